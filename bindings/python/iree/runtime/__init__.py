@@ -19,4 +19,5 @@ from .binding import BufferUsage, HalBuffer, HalDevice, HalDriver, HalElementTyp
 from .binding import create_hal_module, Linkage, VmVariantList, VmFunction, VmInstance, VmContext, VmModule
 from .system_api import *
 from .function import *
+from .profiling import *
 from .tracing import *
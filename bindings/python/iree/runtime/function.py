@@ -7,12 +7,17 @@
 
 from typing import Dict, Optional
 
+import concurrent.futures
 import json
 import logging
+import threading
+import time
 
 import numpy as np
 
-from .binding import HalDevice, HalElementType, VmContext, VmFunction, VmVariantList
+from .binding import (HalDevice, HalElementType, VmArgumentPlan, VmContext,
+                      VmFunction, VmVariantList)
+from . import profiling
 from . import tracing
 
 __all__ = [
@@ -69,6 +74,7 @@ class FunctionInvoker:
       "_named_arg_indices",
       "_max_named_arg_index",
       "_has_inlined_results",
+      "_arg_plan",
       "_tracer",
   ]
 
@@ -95,6 +101,47 @@ class FunctionInvoker:
     return self._vm_function
 
   def __call__(self, *args, **kwargs):
+    profiling_start_ns = (time.perf_counter_ns()
+                          if profiling.is_active() else None)
+    inv, arg_list, call_trace = self._begin_call(args, kwargs)
+    ret_descs = self._ret_descs
+    ret_list = VmVariantList(len(ret_descs) if ret_descs is not None else 1)
+    self._vm_context.invoke(self._vm_function, arg_list, ret_list)
+    result = self._end_call(inv, ret_list, call_trace)
+    if profiling_start_ns is not None:
+      profiling.record_call(self._device, self._vm_function,
+                            profiling_start_ns)
+    return result
+
+  def invoke_async(self, *args, **kwargs) -> concurrent.futures.Future:
+    """Begins an invocation and returns a future resolving to its results.
+
+    Arguments are converted on the calling thread and the function runs until
+    it completes or first blocks on a HAL semaphore. Any remaining execution
+    is resumed on a shared pool of threads that release the GIL while the
+    invocation runs, allowing many invocations to be in flight at once.
+    """
+    inv, arg_list, call_trace = self._begin_call(args, kwargs)
+    invocation = self._vm_context.invoke_async(self._vm_function, arg_list)
+    future = concurrent.futures.Future()
+    future.set_running_or_notify_cancel()
+
+    def complete():
+      try:
+        invocation.await_()
+        result = self._end_call(inv, invocation.get_outputs(), call_trace)
+      except BaseException as e:
+        future.set_exception(e)
+      else:
+        future.set_result(result)
+
+    if invocation.done:
+      complete()
+    else:
+      _get_async_executor().submit(complete)
+    return future
+
+  def _begin_call(self, args, kwargs):
     call_trace = None  # type: Optional[tracing.CallTrace]
     if self._tracer:
       call_trace = self._tracer.start_call(self._vm_function)
@@ -103,7 +150,6 @@ class FunctionInvoker:
     # be below that when doing a flat invocation. May want to be more
     # conservative here when considering nesting.
     inv = Invocation(self._device)
-    ret_descs = self._ret_descs
 
     # Merge keyword args in by name->position mapping.
     if kwargs:
@@ -122,11 +168,20 @@ class FunctionInvoker:
         args[kwarg_index] = kwarg_value
 
     arg_list = VmVariantList(len(args))
-    ret_list = VmVariantList(len(ret_descs) if ret_descs is not None else 1)
-    _merge_python_sequence_to_vm(inv, arg_list, args, self._arg_descs)
+    try:
+      self._arg_plan.marshal(self._device, args, arg_list)
+    except Exception:
+      # Redo the conversion generically to report a precise error (or to
+      # handle any argument the plan does not).
+      arg_list = VmVariantList(len(args))
+      _merge_python_sequence_to_vm(inv, arg_list, args, self._arg_descs)
     if call_trace:
       call_trace.add_vm_list(arg_list, "args")
-    self._vm_context.invoke(self._vm_function, arg_list, ret_list)
+    return inv, arg_list, call_trace
+
+  def _end_call(self, inv: Invocation, ret_list: VmVariantList,
+                call_trace: Optional[tracing.CallTrace]):
+    ret_descs = self._ret_descs
     if call_trace:
       call_trace.add_vm_list(ret_list, "results")
 
@@ -156,6 +211,7 @@ class FunctionInvoker:
       logging.debug(
           "Function lacks reflection data. Interop will be limited: %r",
           vm_function)
+      self._arg_plan = VmArgumentPlan(None, ABI_TYPE_TO_DTYPE)
       return
     try:
       self._abi_dict = json.loads(abi_json)
@@ -184,6 +240,10 @@ class FunctionInvoker:
         if i > self._max_named_arg_index:
           self._max_named_arg_index = i
 
+    # Compile the argument conversion once instead of walking the descriptors
+    # on every call.
+    self._arg_plan = VmArgumentPlan(self._arg_descs, ABI_TYPE_TO_DTYPE)
+
     # Detect whether the results are a slist/stuple/sdict, which indicates
     # that they are inlined with the function's results.
     if len(self._ret_descs) == 1:
@@ -195,6 +255,20 @@ class FunctionInvoker:
     return repr(self._vm_function)
 
 
+_async_executor = None  # type: Optional[concurrent.futures.ThreadPoolExecutor]
+_async_executor_lock = threading.Lock()
+
+
+def _get_async_executor() -> concurrent.futures.ThreadPoolExecutor:
+  """Returns the thread pool used to complete asynchronous invocations."""
+  global _async_executor
+  with _async_executor_lock:
+    if _async_executor is None:
+      _async_executor = concurrent.futures.ThreadPoolExecutor(
+          thread_name_prefix="iree-invoke")
+    return _async_executor
+
+
 # Python type to VM Type converters. All of these take:
 #   inv: Invocation
 #   target_list: VmVariantList to append to
@@ -300,6 +374,10 @@ def _ndarray_to_vm(inv: Invocation, t: VmVariantList, x, desc):
       break
   else:
     _raise_argument_error(inv, f"unsupported numpy dtype {x.dtype}")
+  # C-contiguous arrays are imported by the device without a copy where
+  # possible; any other layout is compacted here first.
+  if not x.flags.c_contiguous:
+    x = np.ascontiguousarray(x)
   t.push_buffer_view(inv.device, x, element_type)
 
 
@@ -8,6 +8,7 @@
 import json
 
 from absl.testing import absltest
+import numpy as np
 
 from iree import runtime as rt
 from iree.runtime.function import FunctionInvoker
@@ -25,11 +26,33 @@ class MockVmContext:
     self.invocations.append((vm_function, arg_list, ret_list))
     print(f"INVOKE: {arg_list} -> {ret_list}")
 
+  def invoke_async(self, vm_function, arg_list):
+    ret_list = VmVariantList(1)
+    self.invoke(vm_function, arg_list, ret_list)
+    return MockVmInvocation(ret_list)
+
   @property
   def mock_arg_reprs(self):
     return repr([arg_list for _, arg_list, _ in self.invocations])
 
 
+class MockVmInvocation:
+
+  def __init__(self, ret_list, error=None):
+    self._ret_list = ret_list
+    self._error = error
+    self.done = False
+
+  def await_(self, timeout=None):
+    self.done = True
+    if self._error:
+      raise self._error
+    return True
+
+  def get_outputs(self):
+    return self._ret_list
+
+
 class MockVmFunction:
 
   def __init__(self, reflection):
@@ -56,6 +79,75 @@ class FunctionTest(absltest.TestCase):
     self.assertEqual("[<VmVariantList(2): [1, 2]>]", vm_context.mock_arg_reprs)
     self.assertEqual((3, 4), result)
 
+  def testInvokeAsync(self):
+
+    def invoke(arg_list, ret_list):
+      ret_list.push_int(3)
+      ret_list.push_int(4)
+
+    vm_context = MockVmContext(invoke)
+    vm_function = MockVmFunction(reflection={})
+    invoker = FunctionInvoker(vm_context, self.device, vm_function, tracer=None)
+    future = invoker.invoke_async(1, 2)
+    self.assertEqual((3, 4), future.result(timeout=10))
+    self.assertEqual("[<VmVariantList(2): [1, 2]>]", vm_context.mock_arg_reprs)
+
+  def testInvokeAsyncError(self):
+    vm_context = MockVmContext(lambda arg_list, ret_list: None)
+    vm_context.invoke_async = lambda vm_function, arg_list: MockVmInvocation(
+        VmVariantList(1), error=RuntimeError("failed"))
+    vm_function = MockVmFunction(reflection={})
+    invoker = FunctionInvoker(vm_context, self.device, vm_function, tracer=None)
+    future = invoker.invoke_async()
+    with self.assertRaisesRegex(RuntimeError, "failed"):
+      future.result(timeout=10)
+
+  def testStructuredArgs(self):
+    captured = []
+
+    def invoke(arg_list, ret_list):
+      captured.append(arg_list.get_as_ndarray(0))
+      ret_list.push_int(3)
+
+    vm_context = MockVmContext(invoke)
+    vm_function = MockVmFunction(
+        reflection={
+            "iree.abi":
+                json.dumps({
+                    "a": [
+                        ["ndarray", "f32", 2, 2, None],
+                        ["slist", "i32", "i32"],
+                        ["sdict", ["x", "i32"], ["y", "i32"]],
+                    ],
+                    "r": ["i32",],
+                })
+        })
+    invoker = FunctionInvoker(vm_context, self.device, vm_function, tracer=None)
+    # The integer list is converted to f32 and transposed arrays are compacted.
+    result = invoker([[1, 3], [2, 4]], [5, 6], {"y": 8, "x": 7})
+    self.assertEqual(3, result)
+    self.assertIn("List[5, 6], List[7, 8]", vm_context.mock_arg_reprs)
+    self.assertEqual(np.float32, captured[0].dtype)
+    np.testing.assert_array_equal([[1, 3], [2, 4]], captured[0])
+
+    invoker(np.asarray([[1, 2, 3], [4, 5, 6]], dtype=np.float32).T[:2].T,
+            (5, 6), {"x": 7, "y": 8})
+    np.testing.assert_array_equal([[1, 2], [4, 5]], captured[1])
+
+  def testStructuredArgsShapeMismatch(self):
+    vm_context = MockVmContext(lambda arg_list, ret_list: None)
+    vm_function = MockVmFunction(
+        reflection={
+            "iree.abi":
+                json.dumps({
+                    "a": [["ndarray", "f32", 2, 2, None]],
+                    "r": [],
+                })
+        })
+    invoker = FunctionInvoker(vm_context, self.device, vm_function, tracer=None)
+    with self.assertRaisesRegex(ValueError, "shape mismatch"):
+      invoker(np.zeros((3, 2), dtype=np.float32))
+
   def testKeywordArgs(self):
 
     def invoke(arg_list, ret_list):
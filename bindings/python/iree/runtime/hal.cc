@@ -6,11 +6,307 @@
 
 #include "bindings/python/iree/runtime/hal.h"
 
+#include <memory>
+
 #include "iree/hal/api.h"
+#include "iree/hal/local/task_device.h"
+#include "iree/task/executor.h"
 
 namespace iree {
 namespace python {
 
+namespace {
+
+//------------------------------------------------------------------------------
+// DLPack ABI
+//------------------------------------------------------------------------------
+// Mirrors the subset of dlpack.h (v0.8) needed to export tensors; the layout
+// is a stable ABI shared by all producers and consumers.
+// See: https://dmlc.github.io/dlpack/latest/c_api.html
+
+enum DLDeviceType : int32_t {
+  kDLCPU = 1,
+};
+
+enum DLDataTypeCode : uint8_t {
+  kDLInt = 0,
+  kDLUInt = 1,
+  kDLFloat = 2,
+  kDLBool = 6,
+};
+
+struct DLDevice {
+  DLDeviceType device_type;
+  int32_t device_id;
+};
+
+struct DLDataType {
+  uint8_t code;
+  uint8_t bits;
+  uint16_t lanes;
+};
+
+struct DLTensor {
+  void* data;
+  DLDevice device;
+  int32_t ndim;
+  DLDataType dtype;
+  int64_t* shape;
+  int64_t* strides;
+  uint64_t byte_offset;
+};
+
+struct DLManagedTensor {
+  DLTensor dl_tensor;
+  void* manager_ctx;
+  void (*deleter)(DLManagedTensor* self);
+};
+
+constexpr char kDLTensorCapsuleName[] = "dltensor";
+
+// Owns the mapping and the buffer view reference backing an exported tensor.
+struct DLPackExport {
+  DLManagedTensor managed;
+  iree_hal_buffer_view_t* buffer_view;
+  iree_hal_buffer_mapping_t mapping;
+  std::vector<int64_t> shape;
+};
+
+// Called by the consumer (from any thread and possibly without the GIL) once
+// it is done with the tensor.
+void DLPackExportDeleter(DLManagedTensor* self) {
+  auto* export_state = static_cast<DLPackExport*>(self->manager_ctx);
+  iree_hal_buffer_unmap_range(&export_state->mapping);
+  iree_hal_buffer_view_release(export_state->buffer_view);
+  delete export_state;
+}
+
+// Consumers rename the capsule when they take ownership of the tensor so we
+// only delete it here if it was never consumed.
+void DLPackCapsuleDestructor(PyObject* capsule) {
+  if (!PyCapsule_IsValid(capsule, kDLTensorCapsuleName)) return;
+  auto* managed = static_cast<DLManagedTensor*>(
+      PyCapsule_GetPointer(capsule, kDLTensorCapsuleName));
+  if (managed && managed->deleter) managed->deleter(managed);
+}
+
+DLDataType ConvertElementTypeToDLDataType(
+    iree_hal_element_type_t element_type) {
+  DLDataType dtype;
+  dtype.bits = iree_hal_element_bit_count(element_type);
+  dtype.lanes = 1;
+  switch (iree_hal_element_numerical_type(element_type)) {
+    case IREE_HAL_NUMERICAL_TYPE_INTEGER_SIGNED:
+      if (dtype.bits == 1) {
+        // i1 is stored as a byte, which is how DLPack represents booleans.
+        dtype.code = kDLBool;
+        dtype.bits = 8;
+      } else {
+        dtype.code = kDLInt;
+      }
+      break;
+    case IREE_HAL_NUMERICAL_TYPE_INTEGER_UNSIGNED:
+      dtype.code = kDLUInt;
+      break;
+    case IREE_HAL_NUMERICAL_TYPE_FLOAT_IEEE:
+      dtype.code = kDLFloat;
+      break;
+    default:
+      throw RaiseValueError("Unsupported buffer view element type for DLPack");
+  }
+  if (dtype.bits % 8 != 0) {
+    throw RaiseValueError("Unsupported sub-byte element type for DLPack");
+  }
+  return dtype;
+}
+
+py::dict AllocatorMemoryStatisticsToDict(
+    const iree_hal_allocator_memory_statistics_t& statistics) {
+  py::dict dict;
+  dict["bytes_live"] = statistics.bytes_live;
+  dict["bytes_peak"] = statistics.bytes_peak;
+  dict["bytes_allocated"] = statistics.bytes_allocated;
+  dict["bytes_freed"] = statistics.bytes_freed;
+  dict["allocation_count"] = statistics.allocation_count;
+  dict["free_count"] = statistics.free_count;
+  return dict;
+}
+
+}  // namespace
+
+const char* HalElementTypeBufferFormat(iree_hal_element_type_t element_type) {
+  switch (element_type) {
+    case IREE_HAL_ELEMENT_TYPE_SINT_8:
+      return "b";
+    case IREE_HAL_ELEMENT_TYPE_UINT_8:
+      return "B";
+    case IREE_HAL_ELEMENT_TYPE_SINT_16:
+      return "h";
+    case IREE_HAL_ELEMENT_TYPE_UINT_16:
+      return "H";
+    case IREE_HAL_ELEMENT_TYPE_SINT_32:
+      return "i";
+    case IREE_HAL_ELEMENT_TYPE_UINT_32:
+      return "I";
+    case IREE_HAL_ELEMENT_TYPE_SINT_64:
+      return "q";
+    case IREE_HAL_ELEMENT_TYPE_UINT_64:
+      return "Q";
+    case IREE_HAL_ELEMENT_TYPE_FLOAT_16:
+      return "e";
+    case IREE_HAL_ELEMENT_TYPE_FLOAT_32:
+      return "f";
+    case IREE_HAL_ELEMENT_TYPE_FLOAT_64:
+      return "d";
+    case IREE_HAL_ELEMENT_TYPE_VALUE(IREE_HAL_NUMERICAL_TYPE_INTEGER_SIGNED, 1):
+      return "?";
+    default:
+      // Expose opaque types as raw bytes.
+      return "B";
+  }
+}
+
+//------------------------------------------------------------------------------
+// HalBufferView
+//------------------------------------------------------------------------------
+
+py::tuple HalBufferView::DLPackDevice() {
+  // Only host-mappable memory is exported today.
+  return py::make_tuple(static_cast<int>(kDLCPU), 0);
+}
+
+py::capsule HalBufferView::DLPack(py::object stream) {
+  // Streams only apply to device memory; host memory is always in sync.
+  (void)stream;
+  iree_hal_buffer_view_t* buffer_view = raw_ptr();
+  iree_hal_buffer_t* buffer = iree_hal_buffer_view_buffer(buffer_view);
+  if (!iree_all_bits_set(iree_hal_buffer_memory_type(buffer),
+                         IREE_HAL_MEMORY_TYPE_HOST_VISIBLE) ||
+      !iree_all_bits_set(iree_hal_buffer_allowed_usage(buffer),
+                         IREE_HAL_BUFFER_USAGE_MAPPING)) {
+    throw RaisePyError(PyExc_BufferError,
+                       "Buffer view is not host-visible and mappable");
+  }
+  DLDataType dtype = ConvertElementTypeToDLDataType(
+      iree_hal_buffer_view_element_type(buffer_view));
+
+  // Map writable when allowed so consumers may update results in place.
+  iree_hal_memory_access_t access = IREE_HAL_MEMORY_ACCESS_READ;
+  if (iree_all_bits_set(iree_hal_buffer_allowed_access(buffer),
+                        IREE_HAL_MEMORY_ACCESS_WRITE)) {
+    access |= IREE_HAL_MEMORY_ACCESS_WRITE;
+  }
+  auto export_state = std::make_unique<DLPackExport>();
+  CheckApiStatus(iree_hal_buffer_map_range(
+                     buffer, access, 0 /* element_offset */,
+                     iree_hal_buffer_view_byte_length(buffer_view),
+                     &export_state->mapping),
+                 "Could not map memory");
+  iree_hal_buffer_view_retain(buffer_view);
+  export_state->buffer_view = buffer_view;
+
+  iree_host_size_t rank = iree_hal_buffer_view_shape_rank(buffer_view);
+  const iree_hal_dim_t* dims = iree_hal_buffer_view_shape_dims(buffer_view);
+  export_state->shape.assign(dims, dims + rank);
+
+  DLManagedTensor* managed = &export_state->managed;
+  managed->dl_tensor.data = export_state->mapping.contents.data;
+  managed->dl_tensor.device = {kDLCPU, 0};
+  managed->dl_tensor.ndim = static_cast<int32_t>(rank);
+  managed->dl_tensor.dtype = dtype;
+  managed->dl_tensor.shape = export_state->shape.data();
+  managed->dl_tensor.strides = nullptr;  // compact row-major
+  managed->dl_tensor.byte_offset = 0;
+  managed->manager_ctx = export_state.get();
+  managed->deleter = DLPackExportDeleter;
+
+  export_state.release();
+  PyObject* capsule =
+      PyCapsule_New(managed, kDLTensorCapsuleName, DLPackCapsuleDestructor);
+  if (!capsule) {
+    DLPackExportDeleter(managed);
+    throw py::error_already_set();
+  }
+  return py::reinterpret_steal<py::capsule>(capsule);
+}
+
+//------------------------------------------------------------------------------
+// HalDevice
+//------------------------------------------------------------------------------
+
+bool HalDevice::BeginDispatchProfiling() {
+  iree_status_t status = iree_hal_device_begin_dispatch_profiling(raw_ptr());
+  if (iree_status_is_unimplemented(status) ||
+      iree_status_is_unavailable(status)) {
+    iree_status_ignore(status);
+    return false;
+  }
+  CheckApiStatus(status, "Error beginning dispatch profiling");
+  return true;
+}
+
+void HalDevice::EndDispatchProfiling() {
+  CheckApiStatus(iree_hal_device_end_dispatch_profiling(raw_ptr()),
+                 "Error ending dispatch profiling");
+}
+
+py::list HalDevice::FlushDispatchProfiles() {
+  py::list profiles;
+  iree_hal_dispatch_profile_callback_t callback;
+  callback.fn = +[](void* user_data,
+                    const iree_hal_dispatch_profile_t* profile) {
+    auto* profiles = static_cast<py::list*>(user_data);
+    profiles->append(py::make_tuple(
+        py::str(profile->entry_point_name.data,
+                profile->entry_point_name.size),
+        profile->entry_point,
+        py::make_tuple(profile->workgroup_count[0],
+                       profile->workgroup_count[1],
+                       profile->workgroup_count[2]),
+        profile->duration_ns, profile->tile_count, profile->shard_count,
+        profile->stolen_shard_count));
+    return iree_ok_status();
+  };
+  callback.user_data = &profiles;
+  CheckApiStatus(iree_hal_device_flush_dispatch_profiles(raw_ptr(), callback),
+                 "Error flushing dispatch profiles");
+  return profiles;
+}
+
+py::dict HalDevice::QueryAllocatorStatistics() {
+  iree_hal_allocator_statistics_t statistics;
+  iree_hal_allocator_query_statistics(allocator(), &statistics);
+  py::dict dict;
+  dict["total"] = AllocatorMemoryStatisticsToDict(statistics.total);
+  dict["device_local"] =
+      AllocatorMemoryStatisticsToDict(statistics.device_local);
+  dict["host_local"] = AllocatorMemoryStatisticsToDict(statistics.host_local);
+  return dict;
+}
+
+py::object HalDevice::QueryExecutorStatistics() {
+  iree_task_executor_t* executor = iree_hal_task_device_executor(raw_ptr());
+  if (!executor) return py::none();
+  iree_task_executor_statistics_t statistics;
+  iree_task_executor_query_statistics(executor, &statistics);
+  const iree_task_worker_statistics_t& totals = statistics.worker_totals;
+  py::dict dict;
+  dict["worker_count"] = statistics.worker_count;
+  dict["idle_worker_count"] = statistics.idle_worker_count;
+  dict["pending_task_count"] = statistics.pending_task_count;
+  dict["waiting_task_count"] = statistics.waiting_task_count;
+  dict["donated_task_count"] = statistics.donated_task_count;
+  dict["donated_tile_count"] = statistics.donated_tile_count;
+  dict["task_count"] = totals.task_count;
+  dict["tile_count"] = totals.tile_count;
+  dict["failed_steal_count"] = totals.failed_steal_count;
+  dict["park_count"] = totals.park_count;
+  dict["busy_ns"] = totals.busy_ns;
+  dict["idle_ns"] = totals.idle_ns;
+  dict["steal_ns"] = totals.steal_ns;
+  return dict;
+}
+
 //------------------------------------------------------------------------------
 // HalDriver
 //------------------------------------------------------------------------------
@@ -100,7 +396,15 @@ void SetupHalBindings(pybind11::module m) {
                  IREE_HAL_NUMERICAL_TYPE_INTEGER_SIGNED, 1)))
       .export_values();
 
-  py::class_<HalDevice>(m, "HalDevice");
+  py::class_<HalDevice>(m, "HalDevice")
+      .def("begin_dispatch_profiling", &HalDevice::BeginDispatchProfiling)
+      .def("end_dispatch_profiling", &HalDevice::EndDispatchProfiling)
+      .def("flush_dispatch_profiles", &HalDevice::FlushDispatchProfiles)
+      .def("query_allocator_statistics",
+           &HalDevice::QueryAllocatorStatistics)
+      .def("reset_allocator_peak_statistics",
+           &HalDevice::ResetAllocatorPeakStatistics)
+      .def("query_executor_statistics", &HalDevice::QueryExecutorStatistics);
   py::class_<HalDriver>(m, "HalDriver")
       .def_static("query", &HalDriver::Query)
       .def_static("create", &HalDriver::Create, py::arg("driver_name"))
@@ -108,7 +412,9 @@ void SetupHalBindings(pybind11::module m) {
 
   py::class_<HalShape>(m, "Shape").def(py::init(&HalShape::FromIntVector));
   py::class_<HalBufferView>(m, "BufferView")
-      .def("map", HalMappedMemory::Create);
+      .def("map", HalMappedMemory::Create)
+      .def("__dlpack__", &HalBufferView::DLPack, py::arg("stream") = py::none())
+      .def("__dlpack_device__", &HalBufferView::DLPackDevice);
   py::class_<HalMappedMemory>(m, "MappedMemory", py::buffer_protocol())
       .def_buffer(&HalMappedMemory::ToBufferInfo);
   py::class_<HalBuffer>(m, "HalBuffer")
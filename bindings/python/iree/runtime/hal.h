@@ -57,6 +57,24 @@ class HalDevice : public ApiRefCounted<HalDevice, iree_hal_device_t> {
   iree_hal_allocator_t* allocator() {
     return iree_hal_device_allocator(raw_ptr());
   }
+
+  // Begins capturing the device time of each dispatch. Returns false if the
+  // device does not support dispatch profiling.
+  bool BeginDispatchProfiling();
+  void EndDispatchProfiling();
+  // Returns a list of (entry_point_name, entry_point, workgroup_count,
+  // duration_ns) tuples for all captured dispatches that have completed.
+  py::list FlushDispatchProfiles();
+
+  // Returns the allocator statistics as a dict of per-memory kind dicts.
+  py::dict QueryAllocatorStatistics();
+  void ResetAllocatorPeakStatistics() {
+    iree_hal_allocator_reset_peak_statistics(allocator());
+  }
+
+  // Returns the task executor statistics as a dict or None if the device does
+  // not execute on an iree/task/ executor.
+  py::object QueryExecutorStatistics();
 };
 
 class HalDriver : public ApiRefCounted<HalDriver, iree_hal_driver_t> {
@@ -81,6 +99,12 @@ struct HalShape {
 class HalBufferView
     : public ApiRefCounted<HalBufferView, iree_hal_buffer_view_t> {
  public:
+  // Returns the DLPack (device_type, device_id) tuple of the contents.
+  py::tuple DLPackDevice();
+  // Exports the contents as a DLPack "dltensor" capsule without copying.
+  // The buffer view remains mapped and retained until the consumer releases
+  // the tensor. Only host-visible, mappable buffers can be exported.
+  py::capsule DLPack(py::object stream);
 };
 
 class HalBuffer : public ApiRefCounted<HalBuffer, iree_hal_buffer_t> {
@@ -110,6 +134,10 @@ class HalBuffer : public ApiRefCounted<HalBuffer, iree_hal_buffer_t> {
   }
 };
 
+// Returns the Python buffer protocol format string of |element_type|.
+// See: https://docs.python.org/3/library/struct.html#format-characters
+const char* HalElementTypeBufferFormat(iree_hal_element_type_t element_type);
+
 // Wrapper around an iree_hal_buffer_mapping_t and iree_hal_buffer_view_t
 // which retains the latter and unmaps/releases on deallocation.
 class HalMappedMemory {
@@ -163,8 +191,9 @@ class HalMappedMemory {
     }
 
     return py::buffer_info(mapped_memory_.contents.data, element_size,
-                           py::format_descriptor<float>::format(), shape.size(),
-                           dims, strides);
+                           HalElementTypeBufferFormat(element_type),
+                           shape.size(), dims, strides,
+                           /*readonly=*/true);
   }
 
  private:
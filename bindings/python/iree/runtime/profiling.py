@@ -0,0 +1,253 @@
+"""Profiling support."""
+
+# Copyright 2021 The IREE Authors
+#
+# Licensed under the Apache License v2.0 with LLVM Exceptions.
+# See https://llvm.org/LICENSE.txt for license information.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+from typing import Dict, List, NamedTuple, Optional, Tuple
+
+import threading
+import time
+
+from . import binding as _binding
+
+__all__ = [
+    "CallProfile",
+    "DispatchProfile",
+    "ProfileReport",
+    "Profiler",
+    "profile",
+]
+
+# Executor statistics that are gauges of the instant they were queried rather
+# than counters accumulated over the lifetime of the executor.
+_EXECUTOR_GAUGES = (
+    "worker_count",
+    "idle_worker_count",
+    "pending_task_count",
+    "waiting_task_count",
+)
+
+# Profilers currently capturing; checked by FunctionInvoker on each call.
+_active_profilers = []  # type: List[Profiler]
+_active_profilers_lock = threading.Lock()
+
+
+class DispatchProfile(NamedTuple):
+  """Device timing of a single dispatch."""
+  entry_point_name: str
+  entry_point: int
+  workgroup_count: Tuple[int, int, int]
+  duration_ns: int
+  # Workgroups executed and how the device scheduled them; 0 if the device
+  # does not track them.
+  tile_count: int = 0
+  shard_count: int = 0
+  stolen_shard_count: int = 0
+
+
+class CallProfile(NamedTuple):
+  """Timing of a single call into the runtime."""
+  function: str
+  wall_time_ns: int
+  # Device time of the dispatches that completed during the call.
+  device_time_ns: int
+  dispatch_count: int
+
+
+class ProfileReport:
+  """Results of a profiling session.
+
+  Attributes:
+    wall_time_ns: duration of the session.
+    calls: profile of each synchronous call made during the session.
+    dispatches: profile of each dispatch executed during the session.
+    dispatch_profiling: whether the device supports dispatch profiling; if not
+      then dispatches is empty and device times are 0.
+    memory: allocator statistics at the end of the session with peaks
+      measured from the start of the session.
+    executor: executor statistics with counters accumulated over the session,
+      or None if the device does not run on a task executor.
+  """
+
+  def __init__(self):
+    self.wall_time_ns = 0
+    self.calls = []  # type: List[CallProfile]
+    self.dispatches = []  # type: List[DispatchProfile]
+    self.dispatch_profiling = False
+    self.memory = None  # type: Optional[dict]
+    self.executor = None  # type: Optional[dict]
+
+  @property
+  def device_time_ns(self) -> int:
+    return sum(d.duration_ns for d in self.dispatches)
+
+  @property
+  def executor_utilization(self) -> Optional[float]:
+    """Fraction of worker time spent executing tasks during the session."""
+    if not self.executor:
+      return None
+    total_ns = (self.executor["busy_ns"] + self.executor["idle_ns"] +
+                self.executor["steal_ns"])
+    return self.executor["busy_ns"] / total_ns if total_ns else 0.0
+
+  def dispatches_by_entry_point(self) -> Dict[str, Tuple[int, int]]:
+    """Returns (count, total duration_ns) of dispatches by entry point."""
+    totals = dict()  # type: Dict[str, Tuple[int, int]]
+    for dispatch in self.dispatches:
+      name = dispatch.entry_point_name or f"#{dispatch.entry_point}"
+      count, duration_ns = totals.get(name, (0, 0))
+      totals[name] = (count + 1, duration_ns + dispatch.duration_ns)
+    return totals
+
+  def to_dict(self) -> dict:
+    return {
+        "wall_time_ns": self.wall_time_ns,
+        "device_time_ns": self.device_time_ns,
+        "calls": [c._asdict() for c in self.calls],
+        "dispatches": [d._asdict() for d in self.dispatches],
+        "dispatch_profiling": self.dispatch_profiling,
+        "memory": self.memory,
+        "executor": self.executor,
+    }
+
+  def summary(self) -> str:
+    """Returns a human-readable summary of the report."""
+    lines = [f"wall time: {self.wall_time_ns / 1e6:.3f}ms"]
+    if self.dispatch_profiling:
+      lines.append(f"device time: {self.device_time_ns / 1e6:.3f}ms "
+                   f"({len(self.dispatches)} dispatches)")
+    else:
+      lines.append("device time: unavailable (device lacks dispatch "
+                   "profiling)")
+    for function in sorted(set(c.function for c in self.calls)):
+      calls = [c for c in self.calls if c.function == function]
+      wall_ns = sum(c.wall_time_ns for c in calls)
+      device_ns = sum(c.device_time_ns for c in calls)
+      lines.append(f"  call {function}: {len(calls)}x "
+                   f"wall {wall_ns / len(calls) / 1e6:.3f}ms/call "
+                   f"device {device_ns / len(calls) / 1e6:.3f}ms/call")
+    by_entry_point = sorted(self.dispatches_by_entry_point().items(),
+                            key=lambda item: item[1][1],
+                            reverse=True)
+    for name, (count, duration_ns) in by_entry_point:
+      lines.append(f"  dispatch {name}: {count}x "
+                   f"{duration_ns / 1e6:.3f}ms total")
+    if self.memory:
+      total = self.memory["total"]
+      lines.append(f"memory: peak {total['bytes_peak']}B "
+                   f"live {total['bytes_live']}B "
+                   f"({total['allocation_count']} allocations)")
+    if self.executor:
+      lines.append(f"executor: {self.executor['worker_count']} workers "
+                   f"{self.executor_utilization * 100:.1f}% busy "
+                   f"{self.executor['task_count']} tasks "
+                   f"{self.executor['tile_count']} tiles")
+    return "\n".join(lines)
+
+  def __repr__(self):
+    return self.summary()
+
+
+class Profiler:
+  """Captures runtime profiling data of calls made while it is active.
+
+  Use as a context manager around the calls to profile; the report is
+  populated when the context exits:
+
+    with iree.runtime.profile(config) as report:
+      module.main(arg)
+    print(report.summary())
+
+  Dispatch profiling adds timing commands around each dispatch and may
+  serialize work that would otherwise overlap. Calls made with invoke_async
+  are not attributed individually but their dispatches are still captured.
+  Device counters are shared by everything using the device so concurrent
+  work outside of the profiled calls is included.
+  """
+
+  def __init__(self, config=None):
+    if config is None:
+      from . import system_api
+      config = system_api._get_global_config()
+    self._device = config.device  # type: _binding.HalDevice
+    self._report = ProfileReport()
+    self._executor_start = None  # type: Optional[dict]
+    self._start_ns = 0
+
+  @property
+  def device(self) -> _binding.HalDevice:
+    return self._device
+
+  @property
+  def report(self) -> ProfileReport:
+    return self._report
+
+  def __enter__(self) -> ProfileReport:
+    self._device.reset_allocator_peak_statistics()
+    self._executor_start = self._device.query_executor_statistics()
+    self._report.dispatch_profiling = (
+        self._device.begin_dispatch_profiling())
+    with _active_profilers_lock:
+      _active_profilers.append(self)
+    self._start_ns = time.perf_counter_ns()
+    return self._report
+
+  def __exit__(self, exc_type, exc_value, traceback):
+    report = self._report
+    report.wall_time_ns = time.perf_counter_ns() - self._start_ns
+    with _active_profilers_lock:
+      _active_profilers.remove(self)
+    if report.dispatch_profiling:
+      self._device.end_dispatch_profiling()
+      self._flush_dispatches()
+    report.memory = self._device.query_allocator_statistics()
+    executor_end = self._device.query_executor_statistics()
+    if executor_end is not None and self._executor_start is not None:
+      report.executor = {
+          key: (value if key in _EXECUTOR_GAUGES else value -
+                self._executor_start[key])
+          for key, value in executor_end.items()
+      }
+    return False
+
+  def _flush_dispatches(self) -> Tuple[int, int]:
+    """Flushes completed dispatches and returns their (count, duration_ns)."""
+    flushed = [
+        DispatchProfile(*p) for p in self._device.flush_dispatch_profiles()
+    ]
+    self._report.dispatches.extend(flushed)
+    return len(flushed), sum(d.duration_ns for d in flushed)
+
+  def _record_call(self, function: str, wall_time_ns: int):
+    dispatch_count, device_time_ns = 0, 0
+    if self._report.dispatch_profiling:
+      dispatch_count, device_time_ns = self._flush_dispatches()
+    self._report.calls.append(
+        CallProfile(function, wall_time_ns, device_time_ns, dispatch_count))
+
+
+def profile(config=None) -> Profiler:
+  """Returns a context manager profiling calls on the device of |config|.
+
+  Uses the global config if none is provided. See Profiler.
+  """
+  return Profiler(config)
+
+
+def record_call(device: _binding.HalDevice, vm_function: _binding.VmFunction,
+                start_ns: int):
+  """Records a completed call on |device| with all active profilers."""
+  wall_time_ns = time.perf_counter_ns() - start_ns
+  function = f"{vm_function.module_name}.{vm_function.name}"
+  with _active_profilers_lock:
+    profilers = [p for p in _active_profilers if p.device is device]
+  for profiler in profilers:
+    profiler._record_call(function, wall_time_ns)
+
+
+def is_active() -> bool:
+  """Returns true if any profiler is capturing."""
+  return bool(_active_profilers)
@@ -0,0 +1,101 @@
+# Lint as: python3
+# Copyright 2021 The IREE Authors
+#
+# Licensed under the Apache License v2.0 with LLVM Exceptions.
+# See https://llvm.org/LICENSE.txt for license information.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+# pylint: disable=unused-variable
+
+from absl.testing import absltest
+import iree.compiler
+import iree.runtime
+import numpy as np
+
+
+def create_simple_mul_module():
+  binary = iree.compiler.compile_str(
+      """
+      module @arithmetic {
+        func @simple_mul(%arg0: tensor<4xf32>, %arg1: tensor<4xf32>) -> tensor<4xf32> {
+            %0 = "mhlo.multiply"(%arg0, %arg1) {name = "mul.1"} : (tensor<4xf32>, tensor<4xf32>) -> tensor<4xf32>
+            return %0 : tensor<4xf32>
+        }
+      }
+      """,
+      input_type="mhlo",
+      target_backends=iree.compiler.core.DEFAULT_TESTING_BACKENDS,
+  )
+  m = iree.runtime.VmModule.from_flatbuffer(binary)
+  return m
+
+
+class ProfilingTest(absltest.TestCase):
+
+  def setUp(self):
+    super().setUp()
+    self.config = iree.runtime.Config("dylib")
+    self.ctx = iree.runtime.SystemContext(config=self.config)
+    self.ctx.add_vm_module(create_simple_mul_module())
+
+  def test_calls(self):
+    arg0 = np.array([1., 2., 3., 4.], dtype=np.float32)
+    arg1 = np.array([4., 5., 6., 7.], dtype=np.float32)
+    with iree.runtime.profile(self.config) as report:
+      self.ctx.modules.arithmetic.simple_mul(arg0, arg1)
+      self.ctx.modules.arithmetic.simple_mul(arg0, arg1)
+    self.assertEqual(len(report.calls), 2)
+    self.assertEqual(report.calls[0].function, "arithmetic.simple_mul")
+    self.assertGreater(report.wall_time_ns, 0)
+    self.assertGreaterEqual(report.wall_time_ns,
+                            sum(c.wall_time_ns for c in report.calls))
+    self.assertIn("arithmetic.simple_mul", report.summary())
+
+  def test_not_recorded_outside(self):
+    arg0 = np.array([1., 2., 3., 4.], dtype=np.float32)
+    with iree.runtime.profile(self.config) as report:
+      pass
+    self.ctx.modules.arithmetic.simple_mul(arg0, arg0)
+    self.assertEmpty(report.calls)
+
+  def test_memory(self):
+    arg0 = np.array([1., 2., 3., 4.], dtype=np.float32)
+    with iree.runtime.profile(self.config) as report:
+      self.ctx.modules.arithmetic.simple_mul(arg0, arg0)
+    total = report.memory["total"]
+    self.assertGreaterEqual(total["bytes_peak"], total["bytes_live"])
+    self.assertGreaterEqual(total["allocation_count"], total["free_count"])
+
+  def test_executor(self):
+    arg0 = np.array([1., 2., 3., 4.], dtype=np.float32)
+    with iree.runtime.profile(self.config) as report:
+      self.ctx.modules.arithmetic.simple_mul(arg0, arg0)
+    self.assertIsNotNone(report.executor)
+    self.assertGreater(report.executor["worker_count"], 0)
+    self.assertGreater(report.executor["task_count"], 0)
+    self.assertGreaterEqual(report.executor_utilization, 0.0)
+    self.assertLessEqual(report.executor_utilization, 1.0)
+
+  def test_dispatches(self):
+    arg0 = np.array([1., 2., 3., 4.], dtype=np.float32)
+    with iree.runtime.profile(self.config) as report:
+      self.ctx.modules.arithmetic.simple_mul(arg0, arg0)
+    self.assertTrue(report.dispatch_profiling)
+    self.assertNotEmpty(report.dispatches)
+    self.assertEqual(report.calls[0].dispatch_count, len(report.dispatches))
+    for dispatch in report.dispatches:
+      self.assertGreater(dispatch.tile_count, 0)
+      self.assertGreater(dispatch.shard_count, 0)
+      self.assertLessEqual(dispatch.stolen_shard_count, dispatch.shard_count)
+
+  def test_to_dict(self):
+    with iree.runtime.profile(self.config) as report:
+      pass
+    d = report.to_dict()
+    self.assertEqual(d["calls"], [])
+    self.assertIn("memory", d)
+    self.assertIn("executor", d)
+
+
+if __name__ == "__main__":
+  absltest.main()
@@ -38,6 +38,55 @@ class PyBufferReleaser {
   Py_buffer& b_;
 };
 
+// Releases a Py_buffer retained by a wrapped HAL buffer and frees it.
+// Used as a Python pending call and must be called with the GIL held.
+int ReleaseRetainedPyBuffer(void* py_view_ptr) {
+  Py_buffer* py_view = static_cast<Py_buffer*>(py_view_ptr);
+  PyBuffer_Release(py_view);
+  delete py_view;
+  return 0;
+}
+
+// Bridges the data allocator of a wrapped HAL buffer to the Py_buffer (passed
+// as |self|) retaining the Python object that owns the memory. HAL buffers may
+// be destroyed on any thread (such as a worker retiring a submission) and so if
+// the GIL is not held the release is deferred to the interpreter instead of
+// blocking the thread on the GIL.
+iree_status_t RetainedPyBufferAllocatorCtl(void* self,
+                                           iree_allocator_command_t command,
+                                           const void* params,
+                                           void** inout_ptr) {
+  if (command != IREE_ALLOCATOR_COMMAND_FREE) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "wrapped Python buffers can only be freed");
+  }
+  if (PyGILState_Check() ||
+      Py_AddPendingCall(ReleaseRetainedPyBuffer, self) != 0) {
+    // Either we already hold the GIL or the pending call queue is full.
+    PyGILState_STATE gil_state = PyGILState_Ensure();
+    ReleaseRetainedPyBuffer(self);
+    PyGILState_Release(gil_state);
+  }
+  return iree_ok_status();
+}
+
+// Returns true if the memory of |py_view| can be used directly by |device|:
+// the view must be C-contiguous, at least as aligned as buffers allocated by
+// the device, and importable by the device allocator.
+bool CanWrapPyBuffer(HalDevice& device, const Py_buffer& py_view,
+                     iree_hal_memory_type_t memory_type,
+                     iree_hal_buffer_usage_t usage) {
+  if (!PyBuffer_IsContiguous(&py_view, 'C')) return false;
+  if (reinterpret_cast<uintptr_t>(py_view.buf) % iree_max_align_t != 0) {
+    return false;
+  }
+  iree_hal_buffer_compatibility_t compatibility =
+      iree_hal_allocator_query_buffer_compatibility(
+          device.allocator(), memory_type, usage, usage, py_view.len);
+  return iree_all_bits_set(compatibility,
+                           IREE_HAL_BUFFER_COMPATIBILITY_IMPORTABLE);
+}
+
 py::dict GetFunctionReflectionDict(iree_vm_function_t& f) {
   py::dict attrs;
   for (int i = 0;; ++i) {
@@ -58,6 +107,228 @@ py::dict GetFunctionReflectionDict(iree_vm_function_t& f) {
 
 }  // namespace
 
+//------------------------------------------------------------------------------
+// VmArgumentPlan
+//------------------------------------------------------------------------------
+
+namespace {
+
+// Maps a native byte order numpy dtype to the HAL element type used for it.
+// Mirrors DTYPE_TO_HAL_ELEMENT_TYPE in function.py.
+bool TryMapDtypeToElementType(const py::dtype& dtype,
+                              iree_hal_element_type_t* out_element_type) {
+  if (!py::cast<bool>(dtype.attr("isnative"))) return false;
+  iree_hal_numerical_type_t numerical_type;
+  switch (dtype.kind()) {
+    case 'b':
+      *out_element_type = static_cast<iree_hal_element_type_t>(
+          IREE_HAL_ELEMENT_TYPE_VALUE(IREE_HAL_NUMERICAL_TYPE_INTEGER_SIGNED,
+                                      1));
+      return dtype.itemsize() == 1;
+    case 'i':
+      numerical_type = IREE_HAL_NUMERICAL_TYPE_INTEGER_SIGNED;
+      break;
+    case 'u':
+      numerical_type = IREE_HAL_NUMERICAL_TYPE_INTEGER_UNSIGNED;
+      break;
+    case 'f':
+      numerical_type = IREE_HAL_NUMERICAL_TYPE_FLOAT_IEEE;
+      break;
+    default:
+      return false;
+  }
+  if (dtype.itemsize() > 8) return false;
+  *out_element_type = static_cast<iree_hal_element_type_t>(
+      IREE_HAL_ELEMENT_TYPE_VALUE(numerical_type, dtype.itemsize() * 8));
+  return true;
+}
+
+}  // namespace
+
+VmArgumentPlan VmArgumentPlan::Create(py::object descs, py::dict abi_dtypes) {
+  VmArgumentPlan plan;
+  py::module numpy = py::module::import("numpy");
+  plan.ndarray_type_ = numpy.attr("ndarray");
+  plan.ascontiguousarray_ = numpy.attr("ascontiguousarray");
+  if (!descs.is_none()) {
+    plan.dynamic_ = false;
+    for (py::handle desc : descs) {
+      plan.nodes_.push_back(CompileNode(desc, abi_dtypes));
+    }
+  }
+  return plan;
+}
+
+VmArgumentPlan::Node VmArgumentPlan::CompileNode(py::handle desc,
+                                                 py::dict& abi_dtypes) {
+  Node node;
+  if (desc.is_none()) {
+    node.kind = Node::Kind::kDynamic;
+    return node;
+  } else if (py::isinstance<py::str>(desc)) {
+    node.kind = Node::Kind::kScalar;
+    return node;
+  } else if (!py::isinstance<py::list>(desc) || py::len(desc) == 0 ||
+             !py::isinstance<py::str>(desc[py::int_(0)])) {
+    return node;
+  }
+  py::list list = py::reinterpret_borrow<py::list>(desc);
+  std::string type = py::cast<std::string>(list[0]);
+  if (type == "ndarray") {
+    // ['ndarray', dtype, rank, dim0, ...] with None for dynamic dims.
+    if (list.size() < 3) return node;
+    py::object dtype_name = list[1];
+    py::object rank = list[2];
+    if (!abi_dtypes.contains(dtype_name) || !py::isinstance<py::int_>(rank) ||
+        py::cast<size_t>(rank) != list.size() - 3) {
+      return node;
+    }
+    for (size_t i = 3; i < list.size(); ++i) {
+      py::object dim = list[i];
+      if (dim.is_none()) {
+        node.dims.push_back(-1);
+      } else if (py::isinstance<py::int_>(dim)) {
+        node.dims.push_back(py::cast<py::ssize_t>(dim));
+      } else {
+        return node;
+      }
+    }
+    node.dtype = py::dtype::from_args(abi_dtypes[dtype_name]);
+    node.kind = Node::Kind::kNdarray;
+  } else if (type == "slist" || type == "stuple") {
+    // ['slist', item0, ...]
+    for (size_t i = 1; i < list.size(); ++i) {
+      node.children.push_back(CompileNode(list[i], abi_dtypes));
+    }
+    node.kind = Node::Kind::kSequence;
+  } else if (type == "sdict") {
+    // ['sdict', [key0, item0], ...]
+    for (size_t i = 1; i < list.size(); ++i) {
+      py::object item = list[i];
+      if (!py::isinstance<py::list>(item) || py::len(item) != 2) {
+        node.children.clear();
+        node.keys.clear();
+        return node;
+      }
+      node.keys.push_back(item[py::int_(0)]);
+      node.children.push_back(CompileNode(item[py::int_(1)], abi_dtypes));
+    }
+    node.kind = Node::Kind::kDict;
+  }
+  return node;
+}
+
+void VmArgumentPlan::Marshal(HalDevice& device, py::sequence args,
+                             VmVariantList& out_list) {
+  if (dynamic_) {
+    Node dynamic_node;
+    dynamic_node.kind = Node::Kind::kDynamic;
+    for (py::handle arg : args) {
+      MarshalValue(dynamic_node, device, arg, out_list);
+    }
+    return;
+  }
+  if (args.size() != nodes_.size()) {
+    throw RaiseValueError("Mismatched function call arity");
+  }
+  for (size_t i = 0; i < nodes_.size(); ++i) {
+    MarshalValue(nodes_[i], device, args[i], out_list);
+  }
+}
+
+void VmArgumentPlan::MarshalValue(const Node& node, HalDevice& device,
+                                  py::handle value, VmVariantList& out_list) {
+  PyObject* obj = value.ptr();
+  switch (node.kind) {
+    case Node::Kind::kDynamic:
+    case Node::Kind::kScalar:
+      if (PyBool_Check(obj)) {
+        out_list.PushInt(obj == Py_True ? 1 : 0);
+      } else if (PyLong_CheckExact(obj)) {
+        out_list.PushInt(py::cast<int64_t>(value));
+      } else if (PyFloat_CheckExact(obj)) {
+        out_list.PushFloat(PyFloat_AS_DOUBLE(obj));
+      } else if (node.kind == Node::Kind::kDynamic &&
+                 value.get_type().is(ndarray_type_)) {
+        MarshalNdarray(nullptr, device, value, out_list);
+      } else {
+        throw RaiseValueError("Unsupported argument type");
+      }
+      return;
+    case Node::Kind::kNdarray:
+      MarshalNdarray(&node, device, value, out_list);
+      return;
+    case Node::Kind::kSequence: {
+      if (!PyList_CheckExact(obj) && !PyTuple_CheckExact(obj)) {
+        throw RaiseValueError("Expected a list or tuple argument");
+      }
+      py::sequence items = py::reinterpret_borrow<py::sequence>(value);
+      if (items.size() != node.children.size()) {
+        throw RaiseValueError("Mismatched list/tuple arity");
+      }
+      VmVariantList sub_list = VmVariantList::Create(node.children.size());
+      for (size_t i = 0; i < node.children.size(); ++i) {
+        MarshalValue(node.children[i], device, items[i], sub_list);
+      }
+      out_list.PushList(sub_list);
+      return;
+    }
+    case Node::Kind::kDict: {
+      if (!PyDict_CheckExact(obj)) {
+        throw RaiseValueError("Expected a dict argument");
+      }
+      py::dict items = py::reinterpret_borrow<py::dict>(value);
+      VmVariantList sub_list = VmVariantList::Create(node.children.size());
+      for (size_t i = 0; i < node.children.size(); ++i) {
+        if (!items.contains(node.keys[i])) {
+          throw RaiseValueError("Missing dict argument item");
+        }
+        MarshalValue(node.children[i], device, items[node.keys[i]], sub_list);
+      }
+      out_list.PushList(sub_list);
+      return;
+    }
+    case Node::Kind::kInvalid:
+    default:
+      throw RaiseValueError("Unsupported argument descriptor");
+  }
+}
+
+void VmArgumentPlan::MarshalNdarray(const Node* node, HalDevice& device,
+                                    py::handle value, VmVariantList& out_list) {
+  if (value.is(py::handle(Py_NotImplemented))) {
+    throw RaiseValueError("Missing argument");
+  }
+  // Equivalent to np.asarray: ndarrays pass through and array-likes convert.
+  py::array array = py::array::ensure(value);
+  if (!array) throw RaiseValueError("Could not convert argument to ndarray");
+  if (node) {
+    if (!array.dtype().equal(node->dtype)) {
+      array = py::array::ensure(array.attr("astype")(node->dtype));
+      if (!array) throw RaiseValueError("Could not convert argument dtype");
+    }
+    if (array.ndim() != static_cast<py::ssize_t>(node->dims.size())) {
+      throw RaiseValueError("Argument rank mismatch");
+    }
+    for (size_t i = 0; i < node->dims.size(); ++i) {
+      if (node->dims[i] >= 0 && node->dims[i] != array.shape(i)) {
+        throw RaiseValueError("Argument shape mismatch");
+      }
+    }
+  }
+  iree_hal_element_type_t element_type;
+  if (!TryMapDtypeToElementType(array.dtype(), &element_type)) {
+    throw RaiseValueError("Unsupported argument dtype");
+  }
+  // C-contiguous arrays are imported by the device without a copy where
+  // possible; any other layout is compacted first.
+  if (!(array.flags() & py::array::c_style)) {
+    array = py::array::ensure(ascontiguousarray_(array));
+    if (!array) throw RaiseValueError("Could not compact argument");
+  }
+  out_list.PushBufferView(device, array, element_type, /*allow_wrap=*/true);
+}
+
 //------------------------------------------------------------------------------
 // VmInstance
 //------------------------------------------------------------------------------
@@ -111,9 +382,75 @@ void VmContext::RegisterModules(std::vector<VmModule*> modules) {
 
 void VmContext::Invoke(iree_vm_function_t f, VmVariantList& inputs,
                        VmVariantList& outputs) {
-  CheckApiStatus(iree_vm_invoke(raw_ptr(), f, nullptr, inputs.raw_ptr(),
-                                outputs.raw_ptr(), iree_allocator_system()),
-                 "Error invoking function");
+  iree_status_t status;
+  {
+    py::gil_scoped_release release;
+    status = iree_vm_invoke(raw_ptr(), f, nullptr, inputs.raw_ptr(),
+                            outputs.raw_ptr(), iree_allocator_system());
+  }
+  CheckApiStatus(status, "Error invoking function");
+}
+
+VmInvocation VmContext::InvokeAsync(iree_vm_function_t f,
+                                    VmVariantList& inputs) {
+  iree_vm_invocation_t* invocation = nullptr;
+  iree_status_t status;
+  {
+    py::gil_scoped_release release;
+    status = iree_vm_invocation_create(raw_ptr(), f, nullptr, inputs.raw_ptr(),
+                                       iree_allocator_system(), &invocation);
+  }
+  CheckApiStatus(status, "Error invoking function");
+  return VmInvocation::CreateRetained(invocation);
+}
+
+//------------------------------------------------------------------------------
+// VmInvocation
+//------------------------------------------------------------------------------
+
+bool VmInvocation::done() {
+  iree_status_t status = iree_vm_invocation_query_status(raw_ptr());
+  bool is_done = !iree_status_is_unavailable(status);
+  iree_status_ignore(status);
+  return is_done;
+}
+
+bool VmInvocation::Await(std::optional<double> timeout) {
+  iree_time_t deadline = IREE_TIME_INFINITE_FUTURE;
+  if (timeout) {
+    deadline = iree_relative_timeout_to_deadline_ns(
+        static_cast<iree_duration_t>(*timeout * 1e9));
+  }
+  iree_status_t status;
+  {
+    py::gil_scoped_release release;
+    status = iree_vm_invocation_await(raw_ptr(), deadline);
+  }
+  if (iree_status_is_deadline_exceeded(status)) {
+    iree_status_ignore(status);
+    return false;
+  }
+  CheckApiStatus(status, "Error invoking function");
+  return true;
+}
+
+VmVariantList VmInvocation::GetOutputs() {
+  const iree_vm_list_t* outputs = iree_vm_invocation_output(raw_ptr());
+  if (!outputs) {
+    throw RaiseValueError("Invocation has not completed successfully");
+  }
+  iree_host_size_t size = iree_vm_list_size(outputs);
+  VmVariantList list = VmVariantList::Create(size);
+  CheckApiStatus(iree_vm_list_resize(list.raw_ptr(), size),
+                 "Error resizing list");
+  CheckApiStatus(iree_vm_list_copy(outputs, 0, list.raw_ptr(), 0, size),
+                 "Error copying invocation outputs");
+  return list;
+}
+
+void VmInvocation::Abort() {
+  CheckApiStatus(iree_vm_invocation_abort(raw_ptr()),
+                 "Error aborting invocation");
 }
 
 //------------------------------------------------------------------------------
@@ -168,6 +505,106 @@ std::optional<iree_vm_function_t> VmModule::LookupFunction(
 // VmVariantList
 //------------------------------------------------------------------------------
 
+namespace {
+
+// Returns the primitive value type matching the Python buffer |format| code.
+// See: https://docs.python.org/3/library/struct.html#format-characters
+iree_vm_value_type_t ValueTypeFromBufferFormat(const std::string& format,
+                                               ssize_t itemsize) {
+  // Skip any byte order/size/alignment prefix such as '<' or '='.
+  char code = format.empty() ? 0 : format.back();
+  switch (code) {
+    case 'f':
+      if (itemsize == 4) return IREE_VM_VALUE_TYPE_F32;
+      break;
+    case 'd':
+      if (itemsize == 8) return IREE_VM_VALUE_TYPE_F64;
+      break;
+    case 'b':
+    case 'B':
+    case 'h':
+    case 'H':
+    case 'i':
+    case 'I':
+    case 'l':
+    case 'L':
+    case 'q':
+    case 'Q':
+      switch (itemsize) {
+        case 1:
+          return IREE_VM_VALUE_TYPE_I8;
+        case 2:
+          return IREE_VM_VALUE_TYPE_I16;
+        case 4:
+          return IREE_VM_VALUE_TYPE_I32;
+        case 8:
+          return IREE_VM_VALUE_TYPE_I64;
+      }
+      break;
+  }
+  throw RaiseValueError("Unsupported buffer format for a typed list");
+}
+
+}  // namespace
+
+VmVariantList VmVariantList::CreateFromBuffer(py::buffer py_buffer) {
+  py::buffer_info info = py_buffer.request();
+  if (info.ndim != 1 || (info.size > 1 && info.strides[0] != info.itemsize)) {
+    throw RaiseValueError("Only contiguous 1D buffers can be made into lists");
+  }
+  iree_vm_type_def_t element_type = iree_vm_type_def_make_value_type(
+      ValueTypeFromBufferFormat(info.format, info.itemsize));
+  iree_vm_list_t* list;
+  CheckApiStatus(iree_vm_list_create(&element_type, info.size,
+                                     iree_allocator_system(), &list),
+                 "Error allocating vm list");
+  VmVariantList result(list);
+  CheckApiStatus(iree_vm_list_resize(list, info.size), "Error resizing list");
+  CheckApiStatus(iree_vm_list_set_values(list, 0, info.size,
+                                         element_type.value_type, info.ptr),
+                 "Error populating list");
+  return result;
+}
+
+py::buffer_info VmVariantList::GetBufferInfo() {
+  iree_vm_value_type_t value_type = IREE_VM_VALUE_TYPE_NONE;
+  iree_byte_span_t storage = iree_make_byte_span(nullptr, 0);
+  CheckApiStatus(iree_vm_list_map_values(raw_ptr(), &value_type, &storage),
+                 "List does not store primitive values");
+  std::string format;
+  ssize_t itemsize = 0;
+  switch (value_type) {
+    case IREE_VM_VALUE_TYPE_I8:
+      format = py::format_descriptor<int8_t>::format();
+      itemsize = sizeof(int8_t);
+      break;
+    case IREE_VM_VALUE_TYPE_I16:
+      format = py::format_descriptor<int16_t>::format();
+      itemsize = sizeof(int16_t);
+      break;
+    case IREE_VM_VALUE_TYPE_I32:
+      format = py::format_descriptor<int32_t>::format();
+      itemsize = sizeof(int32_t);
+      break;
+    case IREE_VM_VALUE_TYPE_I64:
+      format = py::format_descriptor<int64_t>::format();
+      itemsize = sizeof(int64_t);
+      break;
+    case IREE_VM_VALUE_TYPE_F32:
+      format = py::format_descriptor<float>::format();
+      itemsize = sizeof(float);
+      break;
+    case IREE_VM_VALUE_TYPE_F64:
+      format = py::format_descriptor<double>::format();
+      itemsize = sizeof(double);
+      break;
+    default:
+      throw RaiseValueError("Unsupported list element type");
+  }
+  return py::buffer_info(storage.data, itemsize, format, /*ndim=*/1,
+                         {static_cast<ssize_t>(size())}, {itemsize});
+}
+
 void VmVariantList::PushFloat(double fvalue) {
   // Note that Python floats are f64.
   iree_vm_value_t value = iree_vm_value_make_f64(fvalue);
@@ -190,7 +627,8 @@ void VmVariantList::PushList(VmVariantList& other) {
 
 void VmVariantList::PushBufferView(HalDevice& device,
                                    py::object py_buffer_object,
-                                   iree_hal_element_type_t element_type) {
+                                   iree_hal_element_type_t element_type,
+                                   bool allow_wrap) {
   // Request a view of the buffer (use the raw python C API to avoid some
   // allocation and copying at the pybind level).
   Py_buffer py_view;
@@ -207,35 +645,54 @@ void VmVariantList::PushBufferView(HalDevice& device,
   }
   PyBufferReleaser py_view_releaser(py_view);
 
-  // Whether the py object needs to be retained with the argument.
-  // Should be set to true if directly mapping, false if copied.
-  bool depends_on_pyobject = false;
-
-  // Allocate a HalBuffer.
-  // This is hard-coded to C-contiguous right now.
+  // Wrap the memory of the Python object directly when the device can use it
+  // as-is and otherwise copy it into a new device visible buffer.
   // TODO(laurenzo): Expand to other layouts as needed.
-  // TODO(laurenzo): Wrap and retain original buffer (depends_on_pyobject=true).
-  iree_hal_buffer_t* raw_buffer;
-  CheckApiStatus(iree_hal_allocator_allocate_buffer(
-                     device.allocator(),
-                     static_cast<iree_hal_memory_type_t>(
-                         IREE_HAL_MEMORY_TYPE_HOST_LOCAL |
-                         IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE),
-                     IREE_HAL_BUFFER_USAGE_ALL, py_view.len, &raw_buffer),
-                 "Failed to allocate device visible buffer");
-  CheckApiStatus(
-      iree_hal_buffer_write_data(raw_buffer, 0, py_view.buf, py_view.len),
-      "Error writing to input buffer");
-
-  // Only capture the reference to the exporting object (incrementing it)
-  // once guaranteed successful.
-  if (depends_on_pyobject) {
-    // Note for future implementation: there needs to be a place to stash
-    // references to be kept alive which back a buffer. This is likely an
-    // additional bag of refs returned from this function, which can then
-    // be attached to an invocation.
-    throw RaisePyError(PyExc_NotImplementedError,
-                       "Dependent buffer arguments not implemented");
+  iree_hal_memory_type_t memory_type = static_cast<iree_hal_memory_type_t>(
+      IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE);
+  iree_hal_buffer_t* raw_buffer = nullptr;
+  iree_hal_buffer_usage_t usage = IREE_HAL_BUFFER_USAGE_ALL;
+  if (allow_wrap && CanWrapPyBuffer(device, py_view, memory_type, usage)) {
+    // The wrapped buffer retains its own view of the object such that the
+    // memory stays alive (and the exporter can't resize it) until the buffer
+    // is destroyed.
+    Py_buffer* retained_view = new Py_buffer();
+    if (PyObject_GetBuffer(py_buffer_object.ptr(), retained_view, flags) != 0) {
+      delete retained_view;
+      throw py::error_already_set();
+    }
+    iree_allocator_t view_releaser = {/*self=*/retained_view,
+                                      /*ctl=*/RetainedPyBufferAllocatorCtl};
+    iree_status_t status = iree_hal_allocator_wrap_buffer(
+        device.allocator(), memory_type,
+        py_view.readonly ? IREE_HAL_MEMORY_ACCESS_READ
+                         : IREE_HAL_MEMORY_ACCESS_ALL,
+        usage, iree_make_byte_span(py_view.buf, py_view.len), view_releaser,
+        &raw_buffer);
+    if (!iree_status_is_ok(status)) {
+      // Fall back to copying below.
+      iree_status_ignore(status);
+      ReleaseRetainedPyBuffer(retained_view);
+      raw_buffer = nullptr;
+    }
+  }
+  if (!raw_buffer) {
+    // The view keeps the source memory alive and in place so the copy can
+    // proceed without the GIL.
+    iree_status_t status;
+    {
+      py::gil_scoped_release release;
+      status = iree_hal_allocator_allocate_buffer(
+          device.allocator(), memory_type, usage, py_view.len, &raw_buffer);
+      if (iree_status_is_ok(status)) {
+        status = iree_hal_buffer_write_data(raw_buffer, 0, py_view.buf,
+                                            py_view.len);
+        if (!iree_status_is_ok(status)) {
+          iree_hal_buffer_release(raw_buffer);
+        }
+      }
+    }
+    CheckApiStatus(status, "Failed to copy to device visible buffer");
   }
 
   iree_hal_encoding_type_t encoding_type =
@@ -405,6 +862,17 @@ py::object VmVariantList::GetAsSerializedTraceValue(int index) {
   throw RaiseValueError("Unsupported VM to Python Type Conversion");
 }
 
+HalBufferView VmVariantList::GetAsBufferView(int index) {
+  iree_vm_variant_t v = iree_vm_variant_empty();
+  CheckApiStatus(iree_vm_list_get_variant(raw_ptr(), index, &v),
+                 "Could not access list element");
+  iree_hal_buffer_view_t* buffer_view = iree_hal_buffer_view_deref(v.ref);
+  if (!buffer_view) {
+    throw RaiseValueError("Could not deref result buffer view (wrong type?)");
+  }
+  return HalBufferView::RetainAndCreate(buffer_view);
+}
+
 py::object VmVariantList::GetAsNdarray(int index) {
   iree_vm_variant_t v = iree_vm_variant_empty();
   CheckApiStatus(iree_vm_list_get_variant(raw_ptr(), index, &v),
@@ -596,11 +1064,14 @@ void SetupVmBindings(pybind11::module m) {
       .export_values();
 
   // Mutation and inspection of the variant list is mostly opaque to python.
-  py::class_<VmVariantList>(m, "VmVariantList")
+  py::class_<VmVariantList>(m, "VmVariantList", py::buffer_protocol())
       .def(py::init(&VmVariantList::Create))
+      .def_static("from_buffer", &VmVariantList::CreateFromBuffer)
+      .def_buffer(&VmVariantList::GetBufferInfo)
       .def_property_readonly("size", &VmVariantList::size)
       .def("__len__", &VmVariantList::size)
       .def("get_as_ndarray", &VmVariantList::GetAsNdarray)
+      .def("get_as_buffer_view", &VmVariantList::GetAsBufferView)
       .def("get_as_list", &VmVariantList::GetAsList)
       .def("get_variant", &VmVariantList::GetVariant)
       .def("get_serialized_trace_value",
@@ -608,7 +1079,9 @@ void SetupVmBindings(pybind11::module m) {
       .def("push_float", &VmVariantList::PushFloat)
       .def("push_int", &VmVariantList::PushInt)
       .def("push_list", &VmVariantList::PushList)
-      .def("push_buffer_view", &VmVariantList::PushBufferView)
+      .def("push_buffer_view", &VmVariantList::PushBufferView,
+           py::arg("device"), py::arg("buffer"), py::arg("element_type"),
+           py::arg("allow_wrap") = true)
       .def("__repr__", &VmVariantList::DebugString);
 
   py::class_<iree_vm_function_t>(m, "VmFunction")
@@ -645,6 +1118,12 @@ void SetupVmBindings(pybind11::module m) {
         return repr;
       });
 
+  py::class_<VmArgumentPlan>(m, "VmArgumentPlan")
+      .def(py::init(&VmArgumentPlan::Create), py::arg("descs"),
+           py::arg("abi_dtypes"))
+      .def("marshal", &VmArgumentPlan::Marshal, py::arg("device"),
+           py::arg("args"), py::arg("out_list"));
+
   py::class_<VmInstance>(m, "VmInstance").def(py::init(&VmInstance::Create));
 
   py::class_<VmContext>(m, "VmContext")
@@ -652,7 +1131,15 @@ void SetupVmBindings(pybind11::module m) {
            py::arg("modules") = std::optional<std::vector<VmModule*>>())
       .def("register_modules", &VmContext::RegisterModules)
       .def_property_readonly("context_id", &VmContext::context_id)
-      .def("invoke", &VmContext::Invoke);
+      .def("invoke", &VmContext::Invoke)
+      .def("invoke_async", &VmContext::InvokeAsync);
+
+  py::class_<VmInvocation>(m, "VmInvocation")
+      .def_property_readonly("done", &VmInvocation::done)
+      .def("await_", &VmInvocation::Await,
+           py::arg("timeout") = std::optional<double>())
+      .def("get_outputs", &VmInvocation::GetOutputs)
+      .def("abort", &VmInvocation::Abort);
 
   py::class_<VmModule>(m, "VmModule")
       .def_static("from_flatbuffer", &VmModule::FromFlatbufferBlob)
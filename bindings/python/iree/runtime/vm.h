@@ -8,12 +8,14 @@
 #define IREE_BINDINGS_PYTHON_IREE_RT_VM_H_
 
 #include <optional>
+#include <vector>
 
 #include "bindings/python/iree/runtime/binding.h"
 #include "bindings/python/iree/runtime/hal.h"
 #include "iree/base/api.h"
 #include "iree/vm/api.h"
 #include "iree/vm/bytecode_module.h"
+#include "pybind11/numpy.h"
 
 namespace iree {
 namespace python {
@@ -79,6 +81,10 @@ class VmVariantList {
     return VmVariantList(list);
   }
 
+  // Creates a list storing primitive values of a single type populated with
+  // the contents of a 1D contiguous |py_buffer| (such as a numpy array).
+  static VmVariantList CreateFromBuffer(py::buffer py_buffer);
+
   iree_host_size_t size() const { return iree_vm_list_size(list_); }
 
   iree_vm_list_t* raw_ptr() { return list_; }
@@ -94,18 +100,87 @@ class VmVariantList {
   void PushFloat(double fvalue);
   void PushInt(int64_t ivalue);
   void PushList(VmVariantList& other);
+  // Pushes a buffer view of the memory of |py_buffer_object|.
+  // If |allow_wrap| is true and the device can directly use the memory then
+  // the buffer view references it without a copy and keeps the object alive
+  // until the buffer view is destroyed. Writes to the object while the buffer
+  // view is in use will be visible to the program.
   void PushBufferView(HalDevice& device, py::object py_buffer_object,
-                      iree_hal_element_type_t element_type);
+                      iree_hal_element_type_t element_type, bool allow_wrap);
   py::object GetAsList(int index);
   py::object GetAsNdarray(int index);
+  // Returns the buffer view at |index| without mapping or copying it.
+  HalBufferView GetAsBufferView(int index);
   py::object GetVariant(int index);
   py::object GetAsSerializedTraceValue(int index);
 
+  // Returns a buffer protocol view directly referencing the storage of a list
+  // of primitive values. The view is invalidated if the list is resized.
+  py::buffer_info GetBufferInfo();
+
  private:
   VmVariantList(iree_vm_list_t* list) : list_(list) {}
   iree_vm_list_t* list_;
 };
 
+//------------------------------------------------------------------------------
+// VmArgumentPlan
+//------------------------------------------------------------------------------
+
+// Converts Python call arguments to a VM argument list according to the
+// reflection ABI descriptors of a function. The descriptors are compiled once
+// so that each call is a single native walk over the arguments instead of a
+// per-argument dispatch through Python converters.
+//
+// The plan only handles arguments that convert cleanly and raises on anything
+// else; callers fall back to the generic Python conversion to report precise
+// errors.
+class VmArgumentPlan {
+ public:
+  // Compiles the argument descriptors |descs| (or None for functions without
+  // reflection, which are converted dynamically). |abi_dtypes| maps ABI
+  // element type names (such as "f32") to numpy dtypes.
+  static VmArgumentPlan Create(py::object descs, py::dict abi_dtypes);
+
+  // Converts |args| and appends them to |out_list|.
+  void Marshal(HalDevice& device, py::sequence args, VmVariantList& out_list);
+
+ private:
+  struct Node {
+    enum class Kind {
+      // No descriptor: scalars and ndarrays are converted by their type.
+      kDynamic,
+      // Scalar descriptor: ints and floats are pushed as values.
+      kScalar,
+      // ndarray descriptor: array-likes are converted to |dtype| and their
+      // shape checked against |dims| (-1 for dynamic dimensions).
+      kNdarray,
+      // slist/stuple descriptor: lists and tuples of |children|.
+      kSequence,
+      // sdict descriptor: dicts with |keys| mapping to |children|.
+      kDict,
+      // Descriptor that cannot be satisfied; always raises.
+      kInvalid,
+    };
+    Kind kind = Kind::kInvalid;
+    py::dtype dtype;
+    std::vector<py::ssize_t> dims;
+    std::vector<py::object> keys;
+    std::vector<Node> children;
+  };
+
+  static Node CompileNode(py::handle desc, py::dict& abi_dtypes);
+  void MarshalValue(const Node& node, HalDevice& device, py::handle value,
+                    VmVariantList& out_list);
+  void MarshalNdarray(const Node* node, HalDevice& device, py::handle value,
+                      VmVariantList& out_list);
+
+  bool dynamic_ = true;
+  std::vector<Node> nodes_;
+  py::object ndarray_type_;
+  py::object ascontiguousarray_;
+};
+
 //------------------------------------------------------------------------------
 // ApiRefCounted types
 //------------------------------------------------------------------------------
@@ -134,6 +209,26 @@ class VmModule : public ApiRefCounted<VmModule, iree_vm_module_t> {
   py::object stashed_flatbuffer_blob = py::none();
 };
 
+// An asynchronous invocation started with VmContext.invoke_async.
+// The invocation yields whenever it would block on a HAL semaphore wait and
+// is resumed by await_, which releases the GIL for its duration.
+class VmInvocation : public ApiRefCounted<VmInvocation, iree_vm_invocation_t> {
+ public:
+  // Returns true if the invocation has completed (successfully or otherwise).
+  bool done();
+
+  // Resumes the invocation on the calling thread until it completes or the
+  // |timeout| (in seconds) elapses. Returns false on timeout and raises if the
+  // invocation failed.
+  bool Await(std::optional<double> timeout);
+
+  // Returns a new list retaining the outputs of the completed invocation.
+  VmVariantList GetOutputs();
+
+  // Aborts the invocation if it is still in-flight.
+  void Abort();
+};
+
 class VmContext : public ApiRefCounted<VmContext, iree_vm_context_t> {
  public:
   // Creates a context, optionally with modules, which will make the context
@@ -150,11 +245,15 @@ class VmContext : public ApiRefCounted<VmContext, iree_vm_context_t> {
   int context_id() const { return iree_vm_context_id(raw_ptr()); }
 
   // Synchronously invokes the given function.
+  // The GIL is released while the function executes so that other Python
+  // threads may run or issue their own invocations. Concurrent invocations
+  // within one context require the modules in it to be thread-safe.
   void Invoke(iree_vm_function_t f, VmVariantList& inputs,
               VmVariantList& outputs);
-};
 
-class VmInvocation : public ApiRefCounted<VmInvocation, iree_vm_invocation_t> {
+  // Begins invoking the given function and returns once it either completes
+  // or yields on a wait. The inputs are consumed before this returns.
+  VmInvocation InvokeAsync(iree_vm_function_t f, VmVariantList& inputs);
 };
 
 void SetupVmBindings(pybind11::module m);
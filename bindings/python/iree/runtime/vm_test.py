@@ -94,6 +94,68 @@ class VmTest(absltest.TestCase):
       with self.assertRaises(IndexError):
         lst.get_as_ndarray(1)
 
+  def test_variant_list_buffers_wrap(self):
+    ET = iree.runtime.HalElementType
+    # Slice out of a larger allocation to ensure the array is aligned.
+    storage = np.zeros(64 + 16, dtype=np.int8)
+    offset = -storage.ctypes.data % 64
+    ary1 = storage[offset:offset + 16].view(np.int32)
+    ary1[:] = [1, 2, 3, 4]
+
+    # Aligned C-contiguous arrays are used directly.
+    lst = iree.runtime.VmVariantList(1)
+    lst.push_buffer_view(self.device, ary1, ET.SINT_32)
+    ary2 = lst.get_as_ndarray(0)
+    np.testing.assert_array_equal(ary1, ary2)
+    self.assertTrue(np.shares_memory(ary1, ary2))
+
+    # The array must be kept alive by the list.
+    del storage, ary1, ary2
+    np.testing.assert_array_equal(lst.get_as_ndarray(0), [1, 2, 3, 4])
+
+    # Copies can be forced.
+    ary3 = np.asarray([1, 2, 3, 4], dtype=np.int32)
+    lst = iree.runtime.VmVariantList(1)
+    lst.push_buffer_view(self.device, ary3, ET.SINT_32, allow_wrap=False)
+    ary4 = lst.get_as_ndarray(0)
+    np.testing.assert_array_equal(ary3, ary4)
+    self.assertFalse(np.shares_memory(ary3, ary4))
+
+  def test_variant_list_buffer_view_export(self):
+    ET = iree.runtime.HalElementType
+    lst = iree.runtime.VmVariantList(1)
+    lst.push_buffer_view(self.device,
+                         np.asarray([[1, 2], [3, 4]], dtype=np.int16),
+                         ET.SINT_16)
+    bv = lst.get_as_buffer_view(0)
+    self.assertEqual(bv.__dlpack_device__(), (1, 0))
+
+    # The mapped memory reports its real element type.
+    view = memoryview(bv.map())
+    self.assertEqual(view.format, "h")
+    self.assertEqual(view.shape, (2, 2))
+    self.assertTrue(view.readonly)
+
+    if hasattr(np, "from_dlpack"):
+      ary = np.from_dlpack(bv)
+      self.assertEqual(ary.dtype, np.int16)
+      np.testing.assert_array_equal(ary, [[1, 2], [3, 4]])
+      # The tensor keeps the buffer view alive.
+      del bv, lst
+      np.testing.assert_array_equal(ary, [[1, 2], [3, 4]])
+
+  def test_variant_list_from_buffer(self):
+    for dt in (np.int8, np.int16, np.int32, np.int64, np.float32, np.float64):
+      ary = np.asarray([1, 2, 3, 4], dtype=dt)
+      lst = iree.runtime.VmVariantList.from_buffer(ary)
+      self.assertEqual(lst.size, 4)
+      view = np.asarray(lst)
+      self.assertEqual(view.dtype, ary.dtype)
+      np.testing.assert_array_equal(ary, view)
+      # The view aliases the list storage.
+      view[1] = 42
+      np.testing.assert_array_equal([1, 42, 3, 4], np.asarray(lst))
+
   def test_variant_list_list(self):
     lst1 = iree.runtime.VmVariantList(5)
     lst2 = iree.runtime.VmVariantList(5)
@@ -126,6 +126,64 @@ TfLiteInterpreterCreateWithSelectedOps(const TfLiteModel* model,
 TFL_CAPI_EXPORT extern void TfLiteInterpreterOptionsSetUseNNAPI(
     TfLiteInterpreterOptions* options, bool enable);
 
+/// Assigns (or reassigns) a custom memory allocation for the given tensor.
+/// `flags` is a bitmask, see TfLiteCustomAllocationFlags.
+/// The runtime does NOT take ownership of the underlying memory.
+///
+/// NOTE: User needs to call TfLiteInterpreterAllocateTensors() after this.
+/// Invalid/insufficient buffers will cause an error during
+/// TfLiteInterpreterAllocateTensors or TfLiteInterpreterInvoke (in case of
+/// dynamic shapes in the graph).
+///
+/// Parameters should satisfy the following conditions:
+/// 1. tensor->allocation_type == kTfLiteArenaRw or kTfLiteArenaRwPersistent
+///    In general, this is true for I/O tensors & variable tensors.
+/// 2. allocation->data has the appropriate permissions for runtime access
+///    (Read-only for inputs, Read-Write for others), and outlives
+///    TfLiteInterpreter.
+/// 3. allocation->bytes >= tensor->bytes.
+///    This condition is checked again if any tensors are resized.
+/// 4. allocation->data should be aligned to kDefaultTensorAlignment
+///    defined in lite/util.h. (Currently 64 bytes)
+///    This check is skipped if kTfLiteCustomAllocationFlagsSkipAlignCheck is
+///    set through `flags`.
+///
+/// WARNING: This is an experimental API and subject to change.
+TFL_CAPI_EXPORT extern TfLiteStatus
+TfLiteInterpreterSetCustomAllocationForTensor(
+    TfLiteInterpreter* interpreter, int tensor_index,
+    const TfLiteCustomAllocation* allocation, int64_t flags);
+
+//===----------------------------------------------------------------------===//
+// IREE extensions
+//===----------------------------------------------------------------------===//
+// These are not part of the tflite API and are only available in the shim.
+
+/// Policies used to select the cores the interpreter worker threads run on.
+typedef enum TfLiteIreeCoreSelection {
+  /// Workers are configured by the IREE task system flags unless a thread
+  /// count is set, in which case they are spread across all cores.
+  kTfLiteIreeCoreSelectionDefault = 0,
+  /// Workers are spread across all physical cores.
+  kTfLiteIreeCoreSelectionAllCores = 1,
+  /// Workers are only placed on performance cores (the big cores of
+  /// heterogeneous systems such as ARM big.LITTLE).
+  kTfLiteIreeCoreSelectionPerformanceCores = 2,
+  /// Workers are only placed on the cores of the processors in a mask.
+  kTfLiteIreeCoreSelectionProcessorMask = 3,
+} TfLiteIreeCoreSelection;
+
+/// Sets the cores the interpreter worker threads are pinned to. Each worker is
+/// pinned to one physical core and the number of workers is limited by the
+/// value passed to TfLiteInterpreterOptionsSetNumThreads (if positive).
+/// |processor_mask| is only used with kTfLiteIreeCoreSelectionProcessorMask;
+/// bit N selects the processor the OS identifies as N.
+///
+/// WARNING: This is an experimental API and subject to change.
+TFL_CAPI_EXPORT extern void TfLiteInterpreterOptionsSetIreeCoreSelection(
+    TfLiteInterpreterOptions* options, TfLiteIreeCoreSelection core_selection,
+    uint64_t processor_mask);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -6,6 +6,8 @@
 
 #include "bindings/tflite/interpreter.h"
 
+#include <inttypes.h>
+
 #include "bindings/tflite/model.h"
 #include "bindings/tflite/shim.h"
 #include "bindings/tflite/tensor.h"
@@ -14,6 +16,12 @@
 #include "iree/hal/drivers/init.h"
 #include "iree/modules/hal/module.h"
 
+#if defined(IREE_HAL_HAVE_VMVX_DRIVER_MODULE)
+#include "iree/hal/vmvx/registration/driver_module.h"
+#include "iree/task/topology.h"
+#include "iree/task/topology_cpuinfo.h"
+#endif  // IREE_HAL_HAVE_VMVX_DRIVER_MODULE
+
 //===----------------------------------------------------------------------===//
 // HAL / driver support
 //===----------------------------------------------------------------------===//
@@ -25,12 +33,82 @@ static void _TfLiteInterpreterRegisterDrivers(void) {
       iree_hal_driver_registry_default()));
 }
 
+// Creates a driver with its workers placed as requested by the thread count
+// and core selection options. Leaves |out_driver| NULL if the options request
+// the default configuration from the IREE task system flags.
+static iree_status_t _TfLiteInterpreterCreateConfiguredDriver(
+    TfLiteInterpreter* interpreter, iree_hal_driver_t** out_driver) {
+  *out_driver = NULL;
+  const TfLiteInterpreterOptions* options = &interpreter->options;
+  if (options->num_threads <= 0 &&
+      options->core_selection == kTfLiteIreeCoreSelectionDefault) {
+    return iree_ok_status();
+  }
+
+#if defined(IREE_HAL_HAVE_VMVX_DRIVER_MODULE)
+  // One worker is pinned to each selected physical core. Unlike tflite the
+  // calling thread is not counted as it only waits while workers execute.
+  iree_host_size_t max_core_count =
+      options->num_threads > 0 ? (iree_host_size_t)options->num_threads
+                               : IREE_TASK_TOPOLOGY_GROUP_BIT_COUNT;
+  iree_task_topology_t topology;
+  iree_task_topology_initialize(&topology);
+  switch (options->core_selection) {
+    default:
+    case kTfLiteIreeCoreSelectionDefault:
+    case kTfLiteIreeCoreSelectionAllCores:
+      iree_task_topology_initialize_from_physical_cores(max_core_count,
+                                                        &topology);
+      break;
+    case kTfLiteIreeCoreSelectionPerformanceCores:
+      iree_task_topology_initialize_from_performance_cores(max_core_count,
+                                                           &topology);
+      break;
+    case kTfLiteIreeCoreSelectionProcessorMask:
+      iree_task_topology_initialize_from_processor_mask(
+          options->processor_mask, max_core_count, &topology);
+      break;
+  }
+
+  iree_status_t status = iree_ok_status();
+  if (iree_task_topology_group_count(&topology) == 0) {
+    status = iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "no cores match processor mask %016" PRIx64,
+                              options->processor_mask);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_vmvx_driver_create_with_topology(
+        &topology, interpreter->allocator, out_driver);
+  }
+  iree_task_topology_deinitialize(&topology);
+  return status;
+#else
+  IREE_TRACE_MESSAGE(WARNING,
+                     "thread configuration requires the VMVX driver and is "
+                     "ignored in this build of the IREE tflite shim");
+  return iree_ok_status();
+#endif  // IREE_HAL_HAVE_VMVX_DRIVER_MODULE
+}
+
 // TODO(#3977): if already provided a HAL device in the options use that.
 static iree_status_t _TfLiteInterpreterPrepareHAL(
     TfLiteInterpreter* interpreter) {
   iree_call_once(&_TfLiteInterpreterRegisterDriverFlag,
                  _TfLiteInterpreterRegisterDrivers);
 
+  IREE_RETURN_IF_ERROR(
+      _TfLiteInterpreterCreateConfiguredDriver(interpreter,
+                                               &interpreter->driver),
+      "failed to create a driver with the requested thread configuration");
+  if (interpreter->driver) {
+    IREE_RETURN_IF_ERROR(
+        iree_hal_driver_create_default_device(
+            interpreter->driver, interpreter->allocator, &interpreter->device),
+        "failed creating the default device for the configured driver");
+    return iree_hal_module_create(interpreter->device, interpreter->allocator,
+                                  &interpreter->hal_module);
+  }
+
   iree_hal_driver_registry_t* driver_registry =
       iree_hal_driver_registry_default();
 
@@ -67,6 +145,66 @@ static iree_status_t _TfLiteInterpreterPrepareHAL(
   return iree_ok_status();
 }
 
+// Returns true if |runtime| was created with the same thread configuration as
+// requested by |options|.
+static bool _TfLiteModelRuntimeIsCompatible(
+    const _TfLiteModelRuntime* runtime,
+    const TfLiteInterpreterOptions* options) {
+  return runtime->num_threads == options->num_threads &&
+         runtime->core_selection == options->core_selection &&
+         runtime->processor_mask == options->processor_mask;
+}
+
+// Prepares the VM instance and HAL device of the interpreter. They are shared
+// with all other interpreters from the same model with a compatible thread
+// configuration, and executables are shared along with the device as they
+// are memoized per executable loader. Only the VM context (with the module
+// globals) and the I/O state are per-interpreter.
+static iree_status_t _TfLiteInterpreterPrepareRuntime(
+    TfLiteInterpreter* interpreter) {
+  TfLiteModel* model = interpreter->model;
+  _TfLiteModelRuntime* runtime = &model->runtime;
+
+  // The lock is held while creating the runtime so that concurrently created
+  // interpreters wait for and share the first one.
+  iree_slim_mutex_lock(&model->runtime_mutex);
+  if (runtime->device &&
+      _TfLiteModelRuntimeIsCompatible(runtime, &interpreter->options)) {
+    interpreter->instance = runtime->instance;
+    iree_vm_instance_retain(interpreter->instance);
+    interpreter->driver = runtime->driver;
+    iree_hal_driver_retain(interpreter->driver);
+    interpreter->device = runtime->device;
+    iree_hal_device_retain(interpreter->device);
+    interpreter->hal_module = runtime->hal_module;
+    iree_vm_module_retain(interpreter->hal_module);
+    iree_slim_mutex_unlock(&model->runtime_mutex);
+    return iree_ok_status();
+  }
+
+  iree_status_t status =
+      iree_vm_instance_create(interpreter->allocator, &interpreter->instance);
+  if (iree_status_is_ok(status)) {
+    status = _TfLiteInterpreterPrepareHAL(interpreter);
+  }
+  if (iree_status_is_ok(status) && !runtime->device) {
+    // First interpreter of the model: cache for the ones that follow.
+    runtime->num_threads = interpreter->options.num_threads;
+    runtime->core_selection = interpreter->options.core_selection;
+    runtime->processor_mask = interpreter->options.processor_mask;
+    runtime->instance = interpreter->instance;
+    iree_vm_instance_retain(runtime->instance);
+    runtime->driver = interpreter->driver;
+    iree_hal_driver_retain(runtime->driver);
+    runtime->device = interpreter->device;
+    iree_hal_device_retain(runtime->device);
+    runtime->hal_module = interpreter->hal_module;
+    iree_vm_module_retain(runtime->hal_module);
+  }
+  iree_slim_mutex_unlock(&model->runtime_mutex);
+  return status;
+}
+
 //===----------------------------------------------------------------------===//
 // Model shape function query/mutation utilities
 //===----------------------------------------------------------------------===//
@@ -358,11 +496,10 @@ static iree_status_t _TfLiteInterpreterCreate(
   interpreter->user_module = model->module;
   iree_vm_module_retain(interpreter->user_module);
 
-  // External contexts could possibly used to emulate sharing this, but really
-  // if a user is running with multiple models the tflite API is insufficient.
-  IREE_RETURN_IF_ERROR(
-      iree_vm_instance_create(interpreter->allocator, &interpreter->instance));
-  IREE_RETURN_IF_ERROR(_TfLiteInterpreterPrepareHAL(interpreter));
+  // External contexts could possibly used to emulate sharing this across
+  // models, but really if a user is running with multiple models the tflite
+  // API is insufficient. Interpreters from the same model do share it.
+  IREE_RETURN_IF_ERROR(_TfLiteInterpreterPrepareRuntime(interpreter));
 
   // Context will contain both the user-provided bytecode and the HAL module.
   // If we were to support custom ops we would also have a
@@ -421,10 +558,13 @@ TFL_CAPI_EXPORT extern void TfLiteInterpreterDelete(
   }
   iree_vm_list_deinitialize(interpreter->input_list);
   iree_vm_list_deinitialize(interpreter->output_list);
+  iree_hal_buffer_release(interpreter->input_slab);
 
   iree_vm_context_release(interpreter->context);
   iree_vm_module_release(interpreter->hal_module);
   iree_vm_module_release(interpreter->user_module);
+  iree_hal_device_release(interpreter->device);
+  iree_hal_driver_release(interpreter->driver);
   iree_vm_instance_release(interpreter->instance);
 
   _TfLiteModelRelease(interpreter->model);
@@ -514,10 +654,10 @@ TFL_CAPI_EXPORT extern TfLiteStatus TfLiteInterpreterResizeInputTensor(
 
 static iree_status_t _TfLiteInterpreterAllocateTensors(
     TfLiteInterpreter* interpreter) {
-  // NOTE: we could slab allocate like tflite does, but then if any single
-  // tensor has any single dimension that is resized the whole thing gets
-  // reallocated upon resize. That's no good. Instead, we realloc each tensor
-  // if their size has changed.
+  // NOTE: like tflite we slab allocate all input tensors from a single buffer
+  // and bind each tensor to a subspan of it. To avoid reallocating the whole
+  // slab whenever any dimension of any tensor is resized the slab is only
+  // reallocated when it needs to grow and is otherwise repartitioned in place.
 
   // Refresh all shapes from the model. It should have all of the
   // non-data-dependent output shapes.
@@ -527,12 +667,70 @@ static iree_status_t _TfLiteInterpreterAllocateTensors(
   // double-allocating during the resize.
   IREE_RETURN_IF_ERROR(iree_vm_list_resize(interpreter->input_list, 0));
 
-  // Reallocate input tensors (if needed).
+  // Plan the slab layout and check whether any tensor changed size. Tensors
+  // with custom allocations use them directly and are not part of the slab.
+  iree_hal_allocator_t* buffer_allocator =
+      iree_hal_device_allocator(interpreter->device);
+  iree_device_size_t slab_size = 0;
+  iree_host_size_t slab_tensor_count = 0;
+  bool needs_rebind = false;
+  for (iree_host_size_t i = 0; i < interpreter->model->input_count; ++i) {
+    TfLiteTensor* tensor = &interpreter->input_tensors[i];
+    iree_device_size_t byte_length = 0;
+    IREE_RETURN_IF_ERROR(_TfLiteTensorComputeByteLength(tensor, &byte_length));
+    if (!tensor->buffer ||
+        iree_hal_buffer_byte_length(tensor->buffer) != byte_length) {
+      needs_rebind = true;
+    }
+    if (tensor->custom_allocation.data) continue;
+    slab_size =
+        iree_device_align(slab_size, IREE_BINDINGS_TFLITE_TENSOR_ALIGNMENT) +
+        byte_length;
+    ++slab_tensor_count;
+  }
+
+  if (needs_rebind) {
+    for (iree_host_size_t i = 0; i < interpreter->model->input_count; ++i) {
+      _TfLiteTensorDiscardBuffer(&interpreter->input_tensors[i]);
+    }
+    if (slab_tensor_count > 0 &&
+        (!interpreter->input_slab ||
+         iree_hal_buffer_byte_length(interpreter->input_slab) < slab_size)) {
+      // Release the old slab first so that both are not live at once.
+      iree_hal_buffer_release(interpreter->input_slab);
+      interpreter->input_slab = NULL;
+      IREE_RETURN_IF_ERROR(iree_hal_allocator_allocate_buffer(
+          buffer_allocator,
+          IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+          IREE_HAL_BUFFER_USAGE_ALL, slab_size, &interpreter->input_slab));
+    }
+
+    // Bind (and map) each tensor to its subspan of the slab.
+    iree_device_size_t byte_offset = 0;
+    for (iree_host_size_t i = 0; i < interpreter->model->input_count; ++i) {
+      TfLiteTensor* tensor = &interpreter->input_tensors[i];
+      iree_device_size_t byte_length = 0;
+      IREE_RETURN_IF_ERROR(
+          _TfLiteTensorComputeByteLength(tensor, &byte_length));
+      if (tensor->custom_allocation.data) {
+        IREE_RETURN_IF_ERROR(_TfLiteTensorBindCustomAllocation(
+            tensor, buffer_allocator, byte_length));
+        continue;
+      }
+      byte_offset =
+          iree_device_align(byte_offset, IREE_BINDINGS_TFLITE_TENSOR_ALIGNMENT);
+      iree_hal_buffer_t* buffer = NULL;
+      IREE_RETURN_IF_ERROR(iree_hal_buffer_subspan(
+          interpreter->input_slab, byte_offset, byte_length, &buffer));
+      iree_status_t status = _TfLiteTensorBind(tensor, buffer);
+      iree_hal_buffer_release(buffer);
+      IREE_RETURN_IF_ERROR(status);
+      byte_offset += byte_length;
+    }
+  }
+
   for (iree_host_size_t i = 0; i < interpreter->model->input_count; ++i) {
     TfLiteTensor* tensor = &interpreter->input_tensors[i];
-    IREE_RETURN_IF_ERROR(_TfLiteTensorReallocateIfNeeded(
-        tensor, iree_hal_device_allocator(interpreter->device),
-        interpreter->allocator));
     iree_vm_ref_t buffer_ref = iree_hal_buffer_retain_ref(tensor->buffer);
     IREE_RETURN_IF_ERROR(
         iree_vm_list_push_ref_move(interpreter->input_list, &buffer_ref));
@@ -567,6 +765,54 @@ TFL_CAPI_EXPORT extern TfLiteStatus TfLiteInterpreterAllocateTensors(
   return _TfLiteStatusFromIREEStatus(status);
 }
 
+static iree_status_t _TfLiteInterpreterSetCustomAllocationForTensor(
+    TfLiteInterpreter* interpreter, int tensor_index,
+    const TfLiteCustomAllocation* allocation, int64_t flags) {
+  // The shim only exposes I/O tensors: tensor indices enumerate the inputs
+  // followed by the outputs.
+  iree_host_size_t input_count = interpreter->model->input_count;
+  iree_host_size_t output_count = interpreter->model->output_count;
+  if (tensor_index < 0 || tensor_index >= input_count + output_count) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "tensor_index out of range (0 <= %d < %zu)",
+                            tensor_index, input_count + output_count);
+  }
+  if (!allocation) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "custom allocation must be provided");
+  }
+  if (allocation->data &&
+      !(flags & kTfLiteCustomAllocationFlagsSkipAlignCheck) &&
+      ((uintptr_t)allocation->data % IREE_BINDINGS_TFLITE_TENSOR_ALIGNMENT) !=
+          0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "custom allocation must be %d byte aligned",
+                            IREE_BINDINGS_TFLITE_TENSOR_ALIGNMENT);
+  }
+  TfLiteTensor* tensor = tensor_index < input_count
+                             ? &interpreter->input_tensors[tensor_index]
+                             : &interpreter->output_tensors[tensor_index -
+                                                            input_count];
+
+  // The allocation takes effect on the next TfLiteInterpreterAllocateTensors
+  // (for inputs) or TfLiteInterpreterInvoke (for outputs). An allocation with
+  // no data reverts the tensor to the default allocation.
+  _TfLiteTensorDiscardBuffer(tensor);
+  tensor->custom_allocation = *allocation;
+  return iree_ok_status();
+}
+
+TFL_CAPI_EXPORT extern TfLiteStatus
+TfLiteInterpreterSetCustomAllocationForTensor(
+    TfLiteInterpreter* interpreter, int tensor_index,
+    const TfLiteCustomAllocation* allocation, int64_t flags) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_status_t status = _TfLiteInterpreterSetCustomAllocationForTensor(
+      interpreter, tensor_index, allocation, flags);
+  IREE_TRACE_ZONE_END(z0);
+  return _TfLiteStatusFromIREEStatus(status);
+}
+
 static iree_status_t _TfLiteInterpreterInvoke(TfLiteInterpreter* interpreter) {
   // tflite models only have a single entry point and the IREE converter
   // emits it as '_main'.
@@ -586,7 +832,18 @@ static iree_status_t _TfLiteInterpreterInvoke(TfLiteInterpreter* interpreter) {
     iree_hal_buffer_t* buffer = (iree_hal_buffer_t*)iree_vm_list_get_ref_deref(
         interpreter->output_list, i, iree_hal_buffer_get_descriptor());
     TfLiteTensor* tensor = &interpreter->output_tensors[i];
-    IREE_RETURN_IF_ERROR(_TfLiteTensorBind(tensor, buffer));
+    if (buffer && tensor->custom_allocation.data) {
+      // Results are produced by the program into its own buffers so we copy
+      // them into the user allocation and expose that as the tensor data.
+      iree_device_size_t byte_length = iree_hal_buffer_byte_length(buffer);
+      IREE_RETURN_IF_ERROR(_TfLiteTensorBindCustomAllocation(
+          tensor, iree_hal_device_allocator(interpreter->device),
+          byte_length));
+      IREE_RETURN_IF_ERROR(iree_hal_buffer_read_data(
+          buffer, 0, tensor->custom_allocation.data, byte_length));
+    } else {
+      IREE_RETURN_IF_ERROR(_TfLiteTensorBind(tensor, buffer));
+    }
   }
 
   return iree_ok_status();
@@ -41,6 +41,9 @@ struct TfLiteInterpreter {
 
   iree_vm_list_t* input_list;
   iree_vm_list_t* output_list;
+  // Single allocation backing all input tensors, which reference subspans of
+  // it. Only reallocated when the inputs grow beyond its size.
+  iree_hal_buffer_t* input_slab;
   TfLiteTensor* input_tensors;
   TfLiteTensor* output_tensors;
 };
@@ -242,8 +242,25 @@ public final class Interpreter implements AutoCloseable {
       allocateTensors();
     }
 
+    // Direct buffers are bound as the tensor storage and used without copies. Rebinding (and the
+    // reallocation it requires) only happens when a different buffer is passed in.
+    boolean inputsRebound = false;
     for (int i = 0; i < inputs.length; ++i) {
-      getInputTensor(i).copyFromBuffer(inputs[i]);
+      Tensor tensor = getInputTensor(i);
+      if (tensor.isDirectBuffer(inputs[i])) {
+        inputsRebound |= tensor.bindDirectBuffer(inputs[i]);
+      } else {
+        inputsRebound |= tensor.unbindBuffer();
+      }
+    }
+    if (inputsRebound) {
+      allocateTensors();
+    }
+    for (int i = 0; i < inputs.length; ++i) {
+      Tensor tensor = getInputTensor(i);
+      if (!tensor.isBoundTo(inputs[i])) {
+        tensor.copyFromBuffer(inputs[i]);
+      }
     }
 
     long inferenceStartNanos = System.nanoTime();
@@ -255,8 +272,20 @@ public final class Interpreter implements AutoCloseable {
           String.format("Failed to run Interpreter. Returned status code: %d", status));
     }
 
+    // Outputs bound to their buffer were written during the invocation. Others are copied and, if
+    // direct, bound so that subsequent invocations write into them directly.
     for (Map.Entry<Integer, Buffer> output : outputs.entrySet()) {
-      getOutputTensor(output.getKey()).copyToBuffer(output.getValue());
+      Tensor tensor = getOutputTensor(output.getKey());
+      Buffer buffer = output.getValue();
+      if (tensor.isBoundTo(buffer)) {
+        continue;
+      }
+      tensor.copyToBuffer(buffer);
+      if (tensor.isDirectBuffer(buffer)) {
+        tensor.bindDirectBuffer(buffer);
+      } else {
+        tensor.unbindBuffer();
+      }
     }
   }
 
@@ -298,6 +327,10 @@ public final class Interpreter implements AutoCloseable {
    *     number of model inputs; or if error occurs when resizing the specified input.
    */
   public void resizeInput(int inputIndex, @NonNull int[] dims) {
+    // A bound buffer no longer matches the tensor size once it has been resized.
+    if (inputIndex >= 0 && inputIndex < inputTensors.length && inputTensors[inputIndex] != null) {
+      inputTensors[inputIndex].unbindBuffer();
+    }
     if (nativeResizeInputTensor(inputIndex, dims) != 0) {
       throw new IllegalArgumentException("Unable to resize to input tensor.");
     }
@@ -373,7 +406,7 @@ public final class Interpreter implements AutoCloseable {
       throw new IllegalArgumentException(String.format("Invalid output Tensor index: %d", index));
     }
     if (outputTensors[index] == null) {
-      outputTensors[index] = Tensor.outputFromIndex(nativeAddress, index);
+      outputTensors[index] = Tensor.outputFromIndex(nativeAddress, index, inputTensorCount);
     }
     return outputTensors[index];
   }
@@ -30,15 +30,17 @@ public final class Tensor {
     if (nativeAddress == 0) {
       throw new RuntimeException(String.format("Failed to create input tensor %d", tensorIndex));
     }
-    return new Tensor(nativeAddress, tensorIndex);
+    return new Tensor(nativeAddress, nativeInterpreterHandle, tensorIndex, tensorIndex);
   }
 
-  static Tensor outputFromIndex(long nativeInterpreterHandle, int tensorIndex) {
+  static Tensor outputFromIndex(long nativeInterpreterHandle, int tensorIndex, int inputCount) {
     long nativeAddress = nativeCreateOutput(nativeInterpreterHandle, tensorIndex);
     if (nativeAddress == 0) {
       throw new RuntimeException(String.format("Failed to create output tensor %d", tensorIndex));
     }
-    return new Tensor(nativeAddress, tensorIndex);
+    // The shim enumerates custom allocations over the inputs followed by the outputs.
+    return new Tensor(
+        nativeAddress, nativeInterpreterHandle, tensorIndex, inputCount + tensorIndex);
   }
 
   /**
@@ -202,7 +204,52 @@ public final class Tensor {
     }
   }
 
-  private boolean isDirectBuffer(Buffer object) {
+  /**
+   * Binds the direct {@code buffer} as the storage of the tensor so that it is used without
+   * copies. Input bindings take effect on the next tensor allocation and output bindings on the
+   * next invocation. The buffer is referenced by the tensor until it is unbound.
+   *
+   * @return true if the binding changed.
+   */
+  boolean bindDirectBuffer(Buffer buffer) {
+    if (buffer == boundBuffer) {
+      return false;
+    }
+    checkBufferCapacity(buffer);
+    setCustomAllocation(buffer, numBytes());
+    return true;
+  }
+
+  /**
+   * Reverts the tensor to its default storage if it was bound to a direct buffer.
+   *
+   * @return true if the binding changed.
+   */
+  boolean unbindBuffer() {
+    if (boundBuffer == null) {
+      return false;
+    }
+    setCustomAllocation(null, 0);
+    return true;
+  }
+
+  /** Returns true if {@code buffer} is the storage of the tensor. */
+  boolean isBoundTo(Buffer buffer) {
+    return boundBuffer != null && boundBuffer == buffer;
+  }
+
+  private void setCustomAllocation(Buffer buffer, int numBytes) {
+    int statusCode =
+        nativeSetCustomAllocation(nativeInterpreterHandle, customAllocationIndex, buffer, numBytes);
+    if (statusCode != 0) {
+      throw new IllegalArgumentException(
+          String.format("Unable to bind buffer to tensor(%d). Return code: %d", tensorIndex,
+              statusCode));
+    }
+    boundBuffer = buffer;
+  }
+
+  boolean isDirectBuffer(Buffer object) {
     if (object instanceof ByteBuffer) {
       ByteBuffer buffer = (ByteBuffer) object;
       return buffer.isDirect();
@@ -266,13 +313,20 @@ public final class Tensor {
   }
 
   private final long nativeAddress;
+  private final long nativeInterpreterHandle;
   private final int tensorIndex;
+  private final int customAllocationIndex;
   private final QuantizationParams quantizationParams;
   private final int shapeSignature[];
+  // Direct buffer used as the tensor storage, kept alive for as long as it is bound.
+  private Buffer boundBuffer;
 
-  private Tensor(long nativeAddress, int tensorIndex) {
+  private Tensor(
+      long nativeAddress, long nativeInterpreterHandle, int tensorIndex, int customAllocationIndex) {
     this.nativeAddress = nativeAddress;
+    this.nativeInterpreterHandle = nativeInterpreterHandle;
     this.tensorIndex = tensorIndex;
+    this.customAllocationIndex = customAllocationIndex;
     this.quantizationParams =
         new QuantizationParams(nativeQuantizationScale(), nativeQuantizationZeroPoint());
     this.shapeSignature = shape();
@@ -282,6 +336,9 @@ public final class Tensor {
 
   private static native long nativeCreateOutput(long interpreterAddress, int outputIndex);
 
+  private static native int nativeSetCustomAllocation(
+      long interpreterAddress, int tensorIndex, Buffer directBuffer, int numBytes);
+
   private native int nativeType();
 
   private native int nativeNumDims();
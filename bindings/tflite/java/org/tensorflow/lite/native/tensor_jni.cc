@@ -11,6 +11,7 @@
 // NOTE: we pull in our own copy here in case the tflite API changes upstream.
 #define TFL_COMPILE_LIBRARY 1
 #include "bindings/tflite/include/tensorflow/lite/c/c_api.h"
+#include "bindings/tflite/include/tensorflow/lite/c/c_api_experimental.h"
 
 #define JNI_FUNC extern "C" JNIEXPORT
 #define JNI_PREFIX(METHOD) Java_org_tensorflow_lite_Tensor_##METHOD
@@ -61,6 +62,30 @@ JNI_FUNC jlong JNI_PREFIX(nativeCreateOutput)(JNIEnv* env, jclass clazz,
   return reinterpret_cast<jlong>(output_tensor);
 }
 
+JNI_FUNC jint JNI_PREFIX(nativeSetCustomAllocation)(
+    JNIEnv* env, jclass clazz, jlong interpreter_handle, jint tensor_index,
+    jobject direct_buffer, jint byte_length) {
+  TfLiteInterpreter* interpreter = (TfLiteInterpreter*)interpreter_handle;
+  if (!interpreter) {
+    return kTfLiteError;  // Null handle input. Returning to error in Java.
+  }
+
+  // A null buffer reverts the tensor to its default allocation. Direct buffers
+  // are only guaranteed to be aligned to their element size so the alignment
+  // check is skipped; the Java side keeps the buffer alive while it is bound.
+  TfLiteCustomAllocation allocation = {nullptr, 0};
+  if (direct_buffer) {
+    allocation.data = env->GetDirectBufferAddress(direct_buffer);
+    allocation.bytes = static_cast<size_t>(byte_length);
+    if (!allocation.data) {
+      return kTfLiteError;  // Not a direct buffer. Returning to error in Java.
+    }
+  }
+  return (jint)TfLiteInterpreterSetCustomAllocationForTensor(
+      interpreter, tensor_index, &allocation,
+      kTfLiteCustomAllocationFlagsSkipAlignCheck);
+}
+
 JNI_FUNC jint JNI_PREFIX(nativeType)(JNIEnv* env, jobject thiz) {
   TfLiteTensor* tensor = GetTensor(env, thiz);
   if (!tensor) {
@@ -118,6 +118,7 @@ TFL_CAPI_EXPORT extern TfLiteModel* TfLiteModelCreate(const void* model_data,
   }
   memset(model, 0, sizeof(*model));
   iree_atomic_ref_count_init(&model->ref_count);
+  iree_slim_mutex_initialize(&model->runtime_mutex);
   model->allocator = allocator;
 
   status =
@@ -157,6 +158,7 @@ TFL_CAPI_EXPORT extern TfLiteModel* TfLiteModelCreateFromFile(
   }
   memset(model, 0, sizeof(*model));
   iree_atomic_ref_count_init(&model->ref_count);
+  iree_slim_mutex_initialize(&model->runtime_mutex);
   model->allocator = allocator;
   model->owned_model_data = (uint8_t*)model + file_size;
   int ret = fread(model->owned_model_data, 1, file_size, file);
@@ -187,6 +189,11 @@ void _TfLiteModelRetain(TfLiteModel* model) {
 void _TfLiteModelRelease(TfLiteModel* model) {
   if (model && iree_atomic_ref_count_dec(&model->ref_count) == 1) {
     IREE_TRACE_ZONE_BEGIN(z0);
+    iree_vm_module_release(model->runtime.hal_module);
+    iree_hal_device_release(model->runtime.device);
+    iree_hal_driver_release(model->runtime.driver);
+    iree_vm_instance_release(model->runtime.instance);
+    iree_slim_mutex_deinitialize(&model->runtime_mutex);
     iree_vm_module_release(model->module);
     iree_allocator_free(model->allocator, model);
     IREE_TRACE_ZONE_END(z0);
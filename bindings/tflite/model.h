@@ -9,6 +9,8 @@
 
 #include "iree/base/api.h"
 #include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/hal/api.h"
 #include "iree/vm/api.h"
 
 // NOTE: we pull in our own copy here in case the tflite API changes upstream.
@@ -24,6 +26,21 @@ typedef struct _TfLiteModelExports {
   iree_vm_function_t _main;
 } _TfLiteModelExports;
 
+// Runtime objects shared by the interpreters created from a model. They are
+// created along with the first interpreter and reused by all later ones with
+// the same thread configuration so that the device worker threads, allocator
+// pools and loaded executables are not duplicated per interpreter.
+typedef struct _TfLiteModelRuntime {
+  int32_t num_threads;
+  TfLiteIreeCoreSelection core_selection;
+  uint64_t processor_mask;
+
+  iree_vm_instance_t* instance;
+  iree_hal_driver_t* driver;
+  iree_hal_device_t* device;
+  iree_vm_module_t* hal_module;
+} _TfLiteModelRuntime;
+
 struct TfLiteModel {
   iree_atomic_ref_count_t ref_count;
   iree_allocator_t allocator;
@@ -33,6 +50,10 @@ struct TfLiteModel {
   _TfLiteModelExports exports;
   int32_t input_count;
   int32_t output_count;
+
+  // Guards |runtime| as interpreters may be created from multiple threads.
+  iree_slim_mutex_t runtime_mutex;
+  _TfLiteModelRuntime runtime;
 };
 
 void _TfLiteModelRetain(TfLiteModel* model);
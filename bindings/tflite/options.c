@@ -11,6 +11,8 @@
 
 void _TfLiteInterpreterOptionsSetDefaults(TfLiteInterpreterOptions* options) {
   options->num_threads = -1;
+  options->core_selection = kTfLiteIreeCoreSelectionDefault;
+  options->processor_mask = 0;
 }
 
 TFL_CAPI_EXPORT extern TfLiteInterpreterOptions*
@@ -49,6 +51,16 @@ TFL_CAPI_EXPORT extern void TfLiteInterpreterOptionsSetNumThreads(
   IREE_TRACE_ZONE_END(z0);
 }
 
+TFL_CAPI_EXPORT extern void TfLiteInterpreterOptionsSetIreeCoreSelection(
+    TfLiteInterpreterOptions* options, TfLiteIreeCoreSelection core_selection,
+    uint64_t processor_mask) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, core_selection);
+  options->core_selection = core_selection;
+  options->processor_mask = processor_mask;
+  IREE_TRACE_ZONE_END(z0);
+}
+
 TFL_CAPI_EXPORT extern void TfLiteInterpreterOptionsAddDelegate(
     TfLiteInterpreterOptions* options, TfLiteDelegate* delegate) {
   IREE_TRACE_ZONE_BEGIN(z0);
@@ -17,6 +17,8 @@
 struct TfLiteInterpreterOptions {
   iree_allocator_t allocator;
   int32_t num_threads;
+  TfLiteIreeCoreSelection core_selection;
+  uint64_t processor_mask;
   void (*reporter)(void* user_data, const char* format, va_list args);
   void* reporter_user_data;
 
@@ -6,6 +6,8 @@
 
 #include "bindings/tflite/tensor.h"
 
+#include <inttypes.h>
+
 #include "bindings/tflite/shim.h"
 #include "iree/base/tracing.h"
 
@@ -103,16 +105,14 @@ static iree_status_t _TfLiteTypeToElementType(
   return iree_ok_status();
 }
 
-iree_status_t _TfLiteTensorReallocateIfNeeded(
-    TfLiteTensor* tensor, iree_hal_allocator_t* buffer_allocator,
-    iree_allocator_t heap_allocator) {
-  IREE_TRACE_ZONE_BEGIN(z0);
+iree_status_t _TfLiteTensorComputeByteLength(
+    const TfLiteTensor* tensor, iree_device_size_t* out_byte_length) {
+  *out_byte_length = 0;
 
   // Format conversion; ensure we can support the type.
   iree_hal_element_type_t element_type = IREE_HAL_ELEMENT_TYPE_NONE;
   iree_host_size_t storage_scalar = 1;
-  IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0,
+  IREE_RETURN_IF_ERROR(
       _TfLiteTypeToElementType(tensor->type, &element_type, &storage_scalar));
 
   // Compute the total allocation size required, possibly with padding.
@@ -120,39 +120,11 @@ iree_status_t _TfLiteTensorReallocateIfNeeded(
   for (int32_t i = 0; i < tensor->shape_rank; ++i) {
     shape_dims[i] = (iree_hal_dim_t)tensor->shape_dims[i];
   }
-  iree_device_size_t allocation_size = 0;
-  IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0, iree_hal_buffer_compute_view_size(
-              shape_dims, tensor->shape_rank, element_type,
-              IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR, &allocation_size));
-  allocation_size *= storage_scalar;
-
-  // If the old buffer is the same size then no need to realloc.
-  if (tensor->buffer &&
-      iree_hal_buffer_byte_length(tensor->buffer) == allocation_size) {
-    IREE_TRACE_ZONE_END(z0);
-    return iree_ok_status();
-  }
-
-  // Allocate the underlying buffer for the tensor.
-  IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0,
-      iree_hal_allocator_allocate_buffer(
-          buffer_allocator,
-          IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
-          IREE_HAL_BUFFER_USAGE_ALL, allocation_size, &tensor->buffer));
-
-  // Map the buffer memory immediately. The tflite API doesn't let us know if
-  // this is a buffer the user will actually touch or some state buffer that is
-  // just going to be passed to future invocations. We could move this to an
-  // on-demand mapping when the user calls TfLiteTensorData but this at least
-  // puts potential errors in the same easy to find place.
-  IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0,
-      iree_hal_buffer_map_range(tensor->buffer, IREE_HAL_MEMORY_ACCESS_ALL, 0,
-                                IREE_WHOLE_BUFFER, &tensor->buffer_mapping));
-
-  IREE_TRACE_ZONE_END(z0);
+  iree_device_size_t byte_length = 0;
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_compute_view_size(
+      shape_dims, tensor->shape_rank, element_type,
+      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR, &byte_length));
+  *out_byte_length = byte_length * storage_scalar;
   return iree_ok_status();
 }
 
@@ -186,6 +158,37 @@ iree_status_t _TfLiteTensorBind(TfLiteTensor* tensor,
   return iree_ok_status();
 }
 
+iree_status_t _TfLiteTensorBindCustomAllocation(
+    TfLiteTensor* tensor, iree_hal_allocator_t* buffer_allocator,
+    iree_device_size_t byte_length) {
+  if (tensor->custom_allocation.bytes < byte_length) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "custom allocation of tensor '%.*s' is too small "
+                            "(%zu < %" PRIu64 " bytes)",
+                            (int)tensor->name.size, tensor->name.data,
+                            tensor->custom_allocation.bytes,
+                            (uint64_t)byte_length);
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // The memory is owned by the user and only referenced by the buffer.
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_allocator_wrap_buffer(
+              buffer_allocator,
+              IREE_HAL_MEMORY_TYPE_HOST_LOCAL |
+                  IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE,
+              IREE_HAL_MEMORY_ACCESS_ALL, IREE_HAL_BUFFER_USAGE_ALL,
+              iree_make_byte_span(tensor->custom_allocation.data,
+                                  (iree_host_size_t)byte_length),
+              iree_allocator_null(), &buffer));
+  iree_status_t status = _TfLiteTensorBind(tensor, buffer);
+  iree_hal_buffer_release(buffer);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 void _TfLiteTensorDiscardBuffer(TfLiteTensor* tensor) {
   IREE_TRACE_ZONE_BEGIN(z0);
   if (tensor->buffer_mapping.contents.data != NULL) {
@@ -22,6 +22,10 @@
 // modules may of course have arbitrary shape ranks.
 #define IREE_BINDINGS_TFLITE_MAX_RANK 8
 
+// Byte alignment of each tensor suballocated from an interpreter slab.
+// This is the same value as tflite's kDefaultTensorAlignment.
+#define IREE_BINDINGS_TFLITE_TENSOR_ALIGNMENT 64
+
 struct TfLiteTensor {
   // Static metadata about the tensor as it was embedded in the module.
   TfLiteType type;
@@ -34,6 +38,11 @@ struct TfLiteTensor {
   int32_t shape_rank;
   int32_t shape_dims[IREE_BINDINGS_TFLITE_MAX_RANK];
 
+  // User-provided memory set with TfLiteInterpreterSetCustomAllocationForTensor
+  // that is used as the tensor storage instead of runtime allocated memory.
+  // The memory is not owned and |data| is NULL if no allocation is set.
+  TfLiteCustomAllocation custom_allocation;
+
   // Allocated buffer view referencing the backing tensor memory.
   iree_hal_buffer_t* buffer;
   // Persistently mapped buffer; invalidated when buffer is resized.
@@ -53,18 +62,21 @@ iree_status_t _TfLiteTensorParseTypeAttr(TfLiteTensor* tensor,
 iree_status_t _TfLiteTensorParseQuantAttr(TfLiteTensor* tensor,
                                           iree_string_view_t attr);
 
-// Reallocates and remaps the tensor buffer view if needed.
-// No-op if the buffer view is already allocated and its shape matches the
-// current tensor shape.
-iree_status_t _TfLiteTensorReallocateIfNeeded(
-    TfLiteTensor* tensor, iree_hal_allocator_t* buffer_allocator,
-    iree_allocator_t heap_allocator);
+// Computes the byte length of the tensor storage for its current shape.
+iree_status_t _TfLiteTensorComputeByteLength(
+    const TfLiteTensor* tensor, iree_device_size_t* out_byte_length);
 
 // Binds the given |buffer| to the tensor and maps it.
 // The tensor shape will be overwritten with the buffer view shape.
 iree_status_t _TfLiteTensorBind(TfLiteTensor* tensor,
                                 iree_hal_buffer_t* buffer);
 
+// Binds the first |byte_length| bytes of the tensor custom allocation as its
+// buffer without copying. Fails if the allocation is too small.
+iree_status_t _TfLiteTensorBindCustomAllocation(
+    TfLiteTensor* tensor, iree_hal_allocator_t* buffer_allocator,
+    iree_device_size_t byte_length);
+
 // Discards the current buffer view, if any, resetting it to NULL.
 void _TfLiteTensorDiscardBuffer(TfLiteTensor* tensor);
 
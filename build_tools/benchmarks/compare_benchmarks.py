@@ -0,0 +1,220 @@
+#!/usr/bin/env python3
+# Copyright 2021 The IREE Authors
+#
+# Licensed under the Apache License v2.0 with LLVM Exceptions.
+# See https://llvm.org/LICENSE.txt for license information.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+"""Compares two sets of benchmark results and flags regressions.
+
+Takes a base and a target results file as produced by run_benchmarks_on_linux.py
+or build_tools/android/run_benchmarks.py and compares the per-repetition real
+times of every benchmark present in both. A benchmark is flagged as a
+regression (or improvement) only if its median time changed by more than
+--threshold and a two-sided Mann-Whitney U test over the repetitions rejects
+the hypothesis that both sets of samples come from the same distribution at
+--alpha. The test is rank-based so that the occasional outlier repetition (a
+context switch or a frequency change) does not trigger or mask a regression.
+
+Use enough repetitions (10 or more) in both runs for the test to have power;
+with very few samples no change can be significant.
+
+Example usages:
+  python3 compare_benchmarks.py base.json target.json
+  python3 compare_benchmarks.py --fail_on_regression -o diff.json \
+    base.json target.json
+
+Returns a nonzero exit code if --fail_on_regression is set and any benchmark
+regressed.
+"""
+
+import argparse
+import json
+import math
+import statistics
+import sys
+
+from typing import Any, Dict, Sequence, Tuple
+
+# Suffixes of the aggregate entries Google Benchmark appends after repetitions.
+AGGREGATE_NAME_SUFFIXES = ("_mean", "_median", "_stddev", "_cv")
+
+# Multipliers converting Google Benchmark time units to milliseconds.
+TIME_UNIT_TO_MS = {"ns": 1e-6, "us": 1e-3, "ms": 1.0, "s": 1e3}
+
+
+def get_benchmark_name(benchmark: Dict[str, Any]) -> str:
+  """Returns a human-readable unique name for a BenchmarkInfo JSON object."""
+  tags = ",".join(benchmark["model_tags"])
+  model_part = benchmark["model_name"]
+  if tags:
+    model_part += f" [{tags}]"
+  model_part += f" ({benchmark['model_source']})"
+  mode = ",".join(benchmark["bench_mode"])
+  device = benchmark["device_info"]["model"]
+  return f"{model_part} {mode} with {benchmark['runner']} @ {device}"
+
+
+def get_repetition_times(results: Sequence[Dict[str, Any]]) -> Sequence[float]:
+  """Returns the real time in ms of each repetition of a benchmark run."""
+  times = []
+  for result in results:
+    if result.get("run_type", "iteration") != "iteration":
+      continue
+    if result["name"].endswith(AGGREGATE_NAME_SUFFIXES):
+      continue
+    times.append(result["real_time"] * TIME_UNIT_TO_MS[result["time_unit"]])
+  return times
+
+
+def load_benchmark_times(path: str) -> Dict[str, Sequence[float]]:
+  """Loads a results file into a map of benchmark names to repetition times."""
+  with open(path) as f:
+    json_object = json.load(f)
+  benchmark_times = {}
+  for benchmark in json_object["benchmarks"]:
+    name = get_benchmark_name(benchmark["benchmark"])
+    if name in benchmark_times:
+      raise ValueError(f"Duplicated benchmark in '{path}': {name}")
+    benchmark_times[name] = get_repetition_times(benchmark["results"])
+  return benchmark_times
+
+
+def mann_whitney_u_test(xs: Sequence[float],
+                        ys: Sequence[float]) -> Tuple[float, float]:
+  """Performs a two-sided Mann-Whitney U test.
+
+  Uses the normal approximation with tie correction, which is accurate enough
+  for the sample sizes benchmarks use without requiring scipy.
+
+  Returns:
+  - A (U, p-value) tuple where U is the statistic for |xs|.
+  """
+  n1, n2 = len(xs), len(ys)
+  if n1 == 0 or n2 == 0:
+    return 0.0, 1.0
+
+  # Rank the pooled samples, averaging the ranks of ties.
+  pooled = sorted([(x, 0) for x in xs] + [(y, 1) for y in ys])
+  ranks = [0.0] * len(pooled)
+  tie_term = 0.0
+  i = 0
+  while i < len(pooled):
+    j = i
+    while j + 1 < len(pooled) and pooled[j + 1][0] == pooled[i][0]:
+      j += 1
+    average_rank = (i + j) / 2.0 + 1.0
+    for k in range(i, j + 1):
+      ranks[k] = average_rank
+    tie_count = j - i + 1
+    tie_term += tie_count**3 - tie_count
+    i = j + 1
+  rank_sum = sum(rank for rank, (_, group) in zip(ranks, pooled) if group == 0)
+
+  u = rank_sum - n1 * (n1 + 1) / 2.0
+  n = n1 + n2
+  mean_u = n1 * n2 / 2.0
+  variance_u = n1 * n2 / 12.0 * ((n + 1) - tie_term / (n * (n - 1)))
+  if variance_u <= 0:
+    return u, 1.0
+  # Continuity correction toward the mean.
+  z = (abs(u - mean_u) - 0.5) / math.sqrt(variance_u)
+  p_value = math.erfc(max(z, 0.0) / math.sqrt(2.0))
+  return u, min(p_value, 1.0)
+
+
+def compare_benchmarks(base_times: Dict[str, Sequence[float]],
+                       target_times: Dict[str, Sequence[float]],
+                       threshold: float,
+                       alpha: float) -> Sequence[Dict[str, Any]]:
+  """Compares all benchmarks present in both result sets.
+
+  Returns:
+  - A list of comparison JSON objects sorted by relative change, largest
+    regression first.
+  """
+  comparisons = []
+  for name in sorted(base_times.keys() & target_times.keys()):
+    base, target = base_times[name], target_times[name]
+    if not base or not target:
+      continue
+    base_median = statistics.median(base)
+    target_median = statistics.median(target)
+    change = (target_median - base_median) / base_median
+    _, p_value = mann_whitney_u_test(base, target)
+    verdict = "similar"
+    if abs(change) > threshold and p_value < alpha:
+      verdict = "regressed" if change > 0 else "improved"
+    comparisons.append({
+        "name": name,
+        "base_median_ms": base_median,
+        "target_median_ms": target_median,
+        "change": change,
+        "p_value": p_value,
+        "base_repetitions": len(base),
+        "target_repetitions": len(target),
+        "verdict": verdict,
+    })
+  comparisons.sort(key=lambda c: c["change"], reverse=True)
+  return comparisons
+
+
+def print_comparisons(comparisons: Sequence[Dict[str, Any]]):
+  print(f"{'base (ms)':>12} {'target (ms)':>12} {'change':>9} "
+        f"{'p-value':>8}  {'verdict':<10} benchmark")
+  for c in comparisons:
+    print(f"{c['base_median_ms']:12.3f} {c['target_median_ms']:12.3f} "
+          f"{c['change']:+9.2%} {c['p_value']:8.4f}  {c['verdict']:<10} "
+          f"{c['name']}")
+
+
+def parse_arguments():
+  """Parses command-line options."""
+  parser = argparse.ArgumentParser()
+  parser.add_argument("base", help="Path to the base results JSON file")
+  parser.add_argument("target", help="Path to the target results JSON file")
+  parser.add_argument("--threshold",
+                      type=float,
+                      default=0.05,
+                      help="Relative change of the median time below which "
+                      "benchmarks are considered similar (default: 0.05)")
+  parser.add_argument("--alpha",
+                      type=float,
+                      default=0.05,
+                      help="Significance level of the Mann-Whitney U test "
+                      "(default: 0.05)")
+  parser.add_argument("--fail_on_regression",
+                      action="store_true",
+                      help="Exit with a nonzero code if any benchmark "
+                      "regressed")
+  parser.add_argument("-o",
+                      dest="output",
+                      default=None,
+                      help="Path to write the comparison as JSON")
+  return parser.parse_args()
+
+
+def main(args):
+  base_times = load_benchmark_times(args.base)
+  target_times = load_benchmark_times(args.target)
+  comparisons = compare_benchmarks(base_times, target_times, args.threshold,
+                                   args.alpha)
+  print_comparisons(comparisons)
+
+  for name in sorted(base_times.keys() ^ target_times.keys()):
+    where = "base" if name in base_times else "target"
+    print(f"note: only in {where}: {name}")
+
+  if args.output is not None:
+    with open(args.output, "w") as f:
+      json.dump({"comparisons": comparisons}, f, indent=2)
+
+  regressed = [c for c in comparisons if c["verdict"] == "regressed"]
+  if regressed:
+    print(f"{len(regressed)} of {len(comparisons)} benchmarks regressed")
+  if args.fail_on_regression and regressed:
+    return 1
+  return 0
+
+
+if __name__ == "__main__":
+  sys.exit(main(parse_arguments()))
@@ -0,0 +1,311 @@
+#!/usr/bin/env python3
+# Copyright 2021 The IREE Authors
+#
+# Licensed under the Apache License v2.0 with LLVM Exceptions.
+# See https://llvm.org/LICENSE.txt for license information.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+"""Runs all matched benchmark suites on the current Linux host.
+
+This is the host counterpart of build_tools/android/run_benchmarks.py. It
+probes the CPU (and optionally the GPU) of the machine it runs on, picks the
+benchmark cases whose target architecture matches, and runs each of them with
+`iree-benchmark-module`. Results are written in the same JSON format as the
+Android runner (see build_tools/android/common/benchmark_description.py) so the
+two can be compared and uploaded with the same tools.
+
+It expects the benchmark artifacts to be generated by building the
+`iree-benchmark-suites` target with `-DIREE_BUILD_BENCHMARKS=ON`:
+
+<root-build-dir>/benchmark_suites
+└── <benchmark-category> (e.g., TensorFlow)
+    ├── <benchmark-suite> (e.g., MobileBertSquad-fp32)
+    │   ├── <benchmark-case> (e.g., iree-dylib__CPU-x86_64__4-thread,full-inference)
+    │   │   └── flagfile
+    │   └── ...
+    └── vmfb
+        └── compiled-<sha1>.vmfb
+
+Benchmark modes containing an `<N>-thread` tag are pinned to the first N CPUs
+of the host with `taskset`.
+
+Example usages:
+  python3 run_benchmarks_on_linux.py -o results.json /path/to/build/dir
+  python3 compare_benchmarks.py base.json results.json
+"""
+
+import argparse
+import json
+import os
+import platform
+import re
+import subprocess
+
+from typing import Any, Dict, Optional, Sequence, Tuple
+
+# All benchmarks' relative path against root build directory.
+BENCHMARK_SUITE_REL_PATH = "benchmark_suites"
+
+# The flagfile's filename for compiled benchmark artifacts.
+MODEL_FLAGFILE_NAME = "flagfile"
+
+# A map from host machine names to IREE's benchmark target architecture.
+MACHINE_TO_TARGET_ARCH_MAP = {
+    "x86_64": "cpu-x86_64",
+    "amd64": "cpu-x86_64",
+    "aarch64": "cpu-arm64-v8a",
+}
+
+# Patterns matching Vulkan device names to IREE's benchmark target
+# architecture. The first match wins.
+GPU_NAME_TO_TARGET_ARCH_PATTERNS = [
+    (r"RTX[- ]30\d\d|\bA100\b|\bA10\b|\bA40\b", "gpu-nvidia-ampere"),
+]
+
+
+def get_output(args: Sequence[str], verbose: bool = False, **kwargs) -> str:
+  """Executes a command and returns its stdout."""
+  if verbose:
+    cmd = " ".join(args)
+    print(f"cmd: {cmd}")
+  return subprocess.run(args,
+                        check=True,
+                        stdout=subprocess.PIPE,
+                        universal_newlines=True,
+                        **kwargs).stdout.strip()
+
+
+def get_git_commit_hash(commit: str) -> str:
+  return get_output(['git', 'rev-parse', commit],
+                    cwd=os.path.dirname(os.path.realpath(__file__)))
+
+
+def get_host_cpu_model_and_features() -> Tuple[str, Sequence[str]]:
+  """Returns the CPU model name and feature flags from /proc/cpuinfo."""
+  model, features = platform.processor() or "unknown", []
+  try:
+    with open("/proc/cpuinfo") as f:
+      for line in f:
+        key, _, value = line.partition(":")
+        key = key.strip()
+        if key == "model name":
+          model = value.strip()
+        elif key in ("flags", "Features") and not features:
+          features = value.strip().split()
+  except OSError:
+    pass
+  return re.sub(r"\W+", "-", model).strip("-"), features
+
+
+def get_host_gpu_name(verbose: bool = False) -> str:
+  """Returns the name of the first Vulkan device or an empty string."""
+  try:
+    summary = get_output(["vulkaninfo", "--summary"], verbose=verbose)
+  except (OSError, subprocess.CalledProcessError):
+    return ""
+  for line in summary.splitlines():
+    key, _, value = line.partition("=")
+    if key.strip() == "deviceName":
+      return re.sub(r"\W+", "-", value.strip()).strip("-")
+  return ""
+
+
+def get_gpu_target_arch(gpu_name: str) -> Optional[str]:
+  for pattern, target_arch in GPU_NAME_TO_TARGET_ARCH_PATTERNS:
+    if re.search(pattern, gpu_name.replace("-", " ")):
+      return target_arch
+  return None
+
+
+def get_host_device_info(verbose: bool = False) -> Dict[str, Any]:
+  """Returns the host description using the AndroidDeviceInfo JSON schema."""
+  cpu_model, cpu_features = get_host_cpu_model_and_features()
+  return {
+      "model": cpu_model,
+      "cpu_abi": platform.machine().lower(),
+      "cpu_features": cpu_features,
+      "gpu_name": get_host_gpu_name(verbose),
+  }
+
+
+def compose_benchmark_info_object(device_info: Dict[str, Any],
+                                  benchmark_category_dir: str,
+                                  benchmark_case_dir: str) -> Dict[str, Any]:
+  """Creates a BenchmarkInfo JSON object to describe the benchmark.
+
+  Args:
+  - device_info: the host device info JSON object.
+  - benchmark_category_dir: the directory to a specific benchmark category.
+  - benchmark_case_dir: a directory containing the benchmark case.
+
+  Returns:
+  - A JSON object matching BenchmarkInfo.to_json_object().
+  """
+  # <model-name>-<tags>/<iree-driver>__<target-arch>__<bench_mode>
+  model_dir = os.path.dirname(
+      os.path.relpath(benchmark_case_dir, benchmark_category_dir))
+  model_name, _, tags = model_dir.partition("-")
+  iree_driver, _, bench_mode = os.path.basename(benchmark_case_dir).split("__")
+  return {
+      "model_name": model_name,
+      "model_tags": tags.split(",") if tags else [],
+      "model_source": os.path.basename(benchmark_category_dir),
+      "bench_mode": bench_mode.split(","),
+      "runner": iree_driver,
+      "device_info": device_info,
+  }
+
+
+def deduce_taskset(bench_mode: Sequence[str]) -> Optional[str]:
+  """Deduces the CPU list to pin to according to benchmark modes."""
+  for mode in bench_mode:
+    match = re.fullmatch(r"(\d+)-thread", mode)
+    if match:
+      thread_count = min(int(match.group(1)), os.cpu_count() or 1)
+      return f"0-{thread_count - 1}"
+  return None
+
+
+def filter_benchmarks(root_benchmark_dir: str,
+                      target_archs: Sequence[str],
+                      drivers: Optional[Sequence[str]],
+                      verbose: bool = False) -> Sequence[str]:
+  """Returns all benchmark case directories matching the host.
+
+  Args:
+  - root_benchmark_dir: the benchmark_suites directory.
+  - target_archs: lower-cased target architectures the host can run.
+  - drivers: if set, the only IREE drivers to run (e.g. 'dylib').
+  """
+  matched_benchmarks = []
+  for root, dirs, _ in os.walk(root_benchmark_dir):
+    dirs.sort()
+    segments = os.path.basename(root).split("__")
+    if len(segments) != 3 or not segments[0].startswith("iree-"):
+      continue
+    iree_driver, target_arch, bench_mode = segments
+    should_choose = target_arch.lower() in target_archs
+    if drivers is not None:
+      should_choose = should_choose and iree_driver[len("iree-"):] in drivers
+    if should_choose:
+      matched_benchmarks.append(root)
+    if verbose:
+      print(f"dir: {root} (chosen: {should_choose})")
+  return matched_benchmarks
+
+
+def run_benchmark_case(benchmark_case_dir: str, benchmark_tool: str,
+                       bench_mode: Sequence[str], repetitions: int,
+                       verbose: bool) -> Dict[str, Any]:
+  """Runs one benchmark case and returns the parsed Google Benchmark JSON."""
+  cmd = []
+  cpu_list = deduce_taskset(bench_mode)
+  if cpu_list is not None:
+    cmd.extend(["taskset", "-c", cpu_list])
+  cmd.extend([
+      os.path.abspath(benchmark_tool),
+      f"--flagfile={MODEL_FLAGFILE_NAME}",
+      f"--benchmark_repetitions={repetitions}",
+      "--benchmark_format=json",
+  ])
+  return json.loads(get_output(cmd, verbose=verbose, cwd=benchmark_case_dir))
+
+
+def parse_arguments():
+  """Parses command-line options."""
+
+  def check_dir_path(path):
+    if os.path.isdir(path):
+      return path
+    else:
+      raise argparse.ArgumentTypeError(path)
+
+  parser = argparse.ArgumentParser()
+  parser.add_argument(
+      "build_dir",
+      metavar="<build-dir>",
+      type=check_dir_path,
+      help="Path to the build directory containing benchmark suites")
+  parser.add_argument("--benchmark_tool",
+                      default=None,
+                      help="Path to the iree-benchmark-module tool (default to "
+                      "iree/tools/iree-benchmark-module under <build-dir>)")
+  parser.add_argument("--drivers",
+                      default=None,
+                      help="Comma-separated list of IREE drivers to run "
+                      "(default to all matching the host)")
+  parser.add_argument("--gpu_target_arch",
+                      default=None,
+                      help="Benchmark target architecture of the host GPU "
+                      "(e.g. GPU-NVIDIA-Ampere); deduced from the Vulkan "
+                      "device name if omitted")
+  parser.add_argument("--repetitions",
+                      type=int,
+                      default=10,
+                      help="Number of repetitions of each benchmark; more "
+                      "repetitions make regression detection more sensitive")
+  parser.add_argument("-o",
+                      dest="output",
+                      default=None,
+                      help="Path to the output file")
+  parser.add_argument("--verbose",
+                      action="store_true",
+                      help="Print internal information during execution")
+
+  args = parser.parse_args()
+
+  if args.benchmark_tool is None:
+    args.benchmark_tool = os.path.join(args.build_dir, "iree", "tools",
+                                       "iree-benchmark-module")
+  if not os.access(args.benchmark_tool, os.X_OK):
+    parser.error(f"'{args.benchmark_tool}' is not an executable")
+
+  return args
+
+
+def main(args):
+  device_info = get_host_device_info(args.verbose)
+  if args.verbose:
+    print(f"Host device: {device_info}")
+
+  target_archs = []
+  cpu_target_arch = MACHINE_TO_TARGET_ARCH_MAP.get(device_info["cpu_abi"])
+  if cpu_target_arch is None:
+    raise ValueError(f"Unrecognized host machine: '{device_info['cpu_abi']}'; "
+                     "need to update the map")
+  target_archs.append(cpu_target_arch)
+  gpu_target_arch = args.gpu_target_arch or get_gpu_target_arch(
+      device_info["gpu_name"])
+  if gpu_target_arch:
+    target_archs.append(gpu_target_arch.lower())
+
+  drivers = args.drivers.split(",") if args.drivers else None
+  root_benchmark_dir = os.path.join(args.build_dir, BENCHMARK_SUITE_REL_PATH)
+
+  results = {"commit": get_git_commit_hash("HEAD"), "benchmarks": []}
+  for directory in sorted(os.listdir(root_benchmark_dir)):
+    benchmark_category_dir = os.path.join(root_benchmark_dir, directory)
+    for benchmark_case_dir in filter_benchmarks(benchmark_category_dir,
+                                                target_archs, drivers,
+                                                args.verbose):
+      benchmark_info = compose_benchmark_info_object(device_info,
+                                                     benchmark_category_dir,
+                                                     benchmark_case_dir)
+      print(f"--> benchmark: {os.path.relpath(benchmark_case_dir)} <--")
+      resultjson = run_benchmark_case(benchmark_case_dir, args.benchmark_tool,
+                                      benchmark_info["bench_mode"],
+                                      args.repetitions, args.verbose)
+      results["benchmarks"].append({
+          "benchmark": benchmark_info,
+          "context": resultjson["context"],
+          "results": resultjson["benchmarks"],
+      })
+
+  if args.output is not None:
+    with open(args.output, "w") as f:
+      json.dump(results, f)
+  else:
+    print(json.dumps(results))
+
+
+if __name__ == "__main__":
+  main(parse_arguments())
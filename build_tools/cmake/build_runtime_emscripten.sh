@@ -12,6 +12,16 @@
 # Host binaries (e.g. compiler tools) should already be built at
 # ./build-host/install. Emscripten binaries (e.g. .wasm and .js files) will be
 # built in ./build-emscripten/.
+#
+# Set IREE_EMSCRIPTEN_THREADING=1 to build with wasm threads and SIMD such that
+# the local-task HAL driver runs executables across web workers. Executables
+# for this configuration are compiled ahead of time with
+#   -iree-llvm-target-triple=wasm32-unknown-emscripten
+#   -iree-llvm-wasm-simd -iree-llvm-wasm-threads
+#   -iree-llvm-static-library-output-path=...
+# and linked into the program with the static library loader. Pages using the
+# threaded build must be cross-origin isolated (COOP/COEP headers) for
+# SharedArrayBuffer to be available.
 
 set -x
 set -e
@@ -38,13 +48,27 @@ else
 fi
 cd build-emscripten
 
+IREE_EMSCRIPTEN_THREADING=${IREE_EMSCRIPTEN_THREADING:-0}
+if [[ "${IREE_EMSCRIPTEN_THREADING?}" == 1 ]]; then
+  ENABLE_THREADING=ON
+else
+  ENABLE_THREADING=OFF
+fi
+
 # Configure using Emscripten's CMake wrapper, then build.
 emcmake "${CMAKE_BIN?}" -G Ninja .. \
   -DIREE_HOST_BINARY_ROOT=$PWD/../build-host/install \
   -DIREE_HAL_DRIVERS_TO_BUILD=VMVX\;DyLib \
+  -DIREE_ENABLE_THREADING=${ENABLE_THREADING?} \
+  -DIREE_ENABLE_WASM_SIMD=${ENABLE_THREADING?} \
   -DIREE_BUILD_COMPILER=OFF \
   -DIREE_BUILD_TESTS=OFF \
   -DIREE_BUILD_SAMPLES=ON
 
 # TODO(scotttodd): expand this list of targets
 "${CMAKE_BIN?}" --build . --target iree_samples_simple_embedding_simple_embedding_vmvx_sync
+if [[ "${ENABLE_THREADING?}" == ON ]]; then
+  "${CMAKE_BIN?}" --build . --target \
+    iree_hal_local_task_driver \
+    iree_hal_local_loaders_static_library_loader
+fi
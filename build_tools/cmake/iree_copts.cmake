@@ -353,6 +353,29 @@ if(${IREE_SIZE_OPTIMIZED})
       "${IREE_SIZE_OPTIMIZED_DEFAULT_LINKOPTS}")
 endif()
 
+#-------------------------------------------------------------------------------
+# Emscripten/WebAssembly
+#-------------------------------------------------------------------------------
+
+# Wasm threads require that every object linked into a binary, including third
+# party libraries, is compiled with shared memory support and so the flags are
+# applied globally instead of through IREE_DEFAULT_COPTS. Web workers backing
+# pthreads are created up front as they can only be spawned asynchronously
+# from the main browser thread; the page must be cross-origin isolated to use
+# them.
+if(EMSCRIPTEN)
+  if(${IREE_ENABLE_THREADING})
+    string(APPEND CMAKE_C_FLAGS " -pthread")
+    string(APPEND CMAKE_CXX_FLAGS " -pthread")
+    string(APPEND CMAKE_EXE_LINKER_FLAGS
+        " -pthread -sPTHREAD_POOL_SIZE=${IREE_EMSCRIPTEN_PTHREAD_POOL_SIZE}")
+  endif()
+  if(${IREE_ENABLE_WASM_SIMD})
+    string(APPEND CMAKE_C_FLAGS " -msimd128")
+    string(APPEND CMAKE_CXX_FLAGS " -msimd128")
+  endif()
+endif()
+
 #-------------------------------------------------------------------------------
 # Compiler: Clang/LLVM
 #-------------------------------------------------------------------------------
@@ -8,6 +8,8 @@
 
 package com.google.iree;
 
+import java.nio.Buffer;
+import java.nio.ByteBuffer;
 import java.nio.FloatBuffer;
 import java.util.List;
 
@@ -56,12 +58,29 @@ final class Context {
     return function;
   }
 
+  /**
+   * Invokes {@code function} with float32 {@code inputs} of {@code inputElementCount} elements.
+   *
+   * <p>All buffers must be direct buffers in native byte order. Inputs are used in place without
+   * copies and the result is written into {@code output}.
+   */
   public void invokeFunction(
       Function function, FloatBuffer[] inputs, int inputElementCount, FloatBuffer output)
       throws Exception {
-    Status status =
-        Status.fromCode(
-            nativeInvokeFunction(function.getNativeAddress(), inputs, inputElementCount, output));
+    invokeFunctionWithBuffers(function, inputs, inputElementCount, output, output.capacity() * 4);
+  }
+
+  /** See {@link #invokeFunction(Function, FloatBuffer[], int, FloatBuffer)}. */
+  public void invokeFunction(
+      Function function, ByteBuffer[] inputs, int inputElementCount, ByteBuffer output)
+      throws Exception {
+    invokeFunctionWithBuffers(function, inputs, inputElementCount, output, output.capacity());
+  }
+
+  private void invokeFunctionWithBuffers(Function function, Buffer[] inputs,
+      int inputElementCount, Buffer output, int outputByteLength) throws Exception {
+    Status status = Status.fromCode(nativeInvokeFunction(
+        function.getNativeAddress(), inputs, inputElementCount, output, outputByteLength));
     if (!status.isOk()) {
       throw status.toException("Could not invoke function");
     }
@@ -98,8 +117,8 @@ final class Context {
   private native int nativeResolveFunction(long functionAddress, String name);
 
   // TODO(jennik): 'output' should be a Floatbuffer[].
-  private native int nativeInvokeFunction(
-      long functionAddress, FloatBuffer[] inputs, int inputElementCount, FloatBuffer output);
+  private native int nativeInvokeFunction(long functionAddress, Buffer[] inputs,
+      int inputElementCount, Buffer output, int outputByteLength);
 
   private native void nativeFree();
 
@@ -116,23 +116,29 @@ JNI_FUNC jint JNI_PREFIX(nativeInvokeFunction)(JNIEnv* env, jobject thiz,
                                                jlong functionAddress,
                                                jobjectArray inputs,
                                                jint inputElementCount,
-                                               jobject output) {
+                                               jobject output,
+                                               jint outputByteLength) {
   ContextWrapper* context = GetContextWrapper(env, thiz);
   IREE_CHECK_NE(context, nullptr);
 
+  // Direct buffers are passed through by address without copies.
   const jsize inputs_size = env->GetArrayLength(inputs);
   std::vector<float*> native_inputs(inputs_size);
-
   for (int i = 0; i < inputs_size; i++) {
     jobject input = env->GetObjectArrayElement(inputs, i);
-    float* native_input = (float*)env->GetDirectBufferAddress(input);
-    native_inputs[i] = native_input;
+    native_inputs[i] = (float*)env->GetDirectBufferAddress(input);
+    // Release the local reference right away so that repeated invocations
+    // don't grow the local reference table.
+    env->DeleteLocalRef(input);
+    if (!native_inputs[i]) return (jint)IREE_STATUS_INVALID_ARGUMENT;
   }
+  float* native_output = (float*)env->GetDirectBufferAddress(output);
+  if (!native_output) return (jint)IREE_STATUS_INVALID_ARGUMENT;
 
   auto function = (FunctionWrapper*)functionAddress;
-  float* native_output = (float*)env->GetDirectBufferAddress(output);
-  auto status = context->InvokeFunction(*function, native_inputs,
-                                        (int)inputElementCount, native_output);
+  auto status = context->InvokeFunction(function, native_inputs,
+                                        (int)inputElementCount, native_output,
+                                        (iree_host_size_t)outputByteLength);
   return (jint)status.code();
 }
 
@@ -68,13 +68,13 @@ Status ContextWrapper::ResolveFunction(iree_string_view_t name,
                                           function_wrapper->function());
 }
 
-Status ContextWrapper::InvokeFunction(const FunctionWrapper& function_wrapper,
+Status ContextWrapper::InvokeFunction(FunctionWrapper* function_wrapper,
                                       const std::vector<float*>& inputs,
-                                      int input_element_count, float* output) {
-  vm::ref<iree_vm_list_t> input_list;
-  IREE_RETURN_IF_ERROR(iree_vm_list_create(
-      /*element_type=*/nullptr, input_element_count, iree_allocator_system(),
-      &input_list));
+                                      int input_element_count, float* output,
+                                      iree_host_size_t output_byte_length) {
+  IREE_RETURN_IF_ERROR(function_wrapper->ResetCallLists(inputs.size()));
+  iree_vm_list_t* input_list = function_wrapper->inputs();
+  iree_vm_list_t* output_list = function_wrapper->outputs();
 
   iree_hal_allocator_t* allocator = iree_hal_device_allocator(device_);
   iree_hal_memory_type_t input_memory_type =
@@ -85,49 +85,66 @@ Status ContextWrapper::InvokeFunction(const FunctionWrapper& function_wrapper,
                                            IREE_HAL_BUFFER_USAGE_CONSTANT);
 
   for (auto input : inputs) {
-    // Write the input into a mappable buffer.
+    // Wrap the caller memory (a direct buffer on the Java side) in place. The
+    // buffer does not own the memory and is released after the call.
     iree_hal_buffer_t* input_buffer = nullptr;
-    IREE_RETURN_IF_ERROR(iree_hal_allocator_allocate_buffer(
-        allocator, input_memory_type, input_buffer_usage,
-        sizeof(float) * input_element_count, &input_buffer));
-    IREE_RETURN_IF_ERROR(iree_hal_buffer_write_data(
-        input_buffer, 0, input, input_element_count * sizeof(float)));
+    IREE_RETURN_IF_ERROR(iree_hal_allocator_wrap_buffer(
+        allocator, input_memory_type, IREE_HAL_MEMORY_ACCESS_READ,
+        input_buffer_usage,
+        iree_make_byte_span(input, sizeof(float) * input_element_count),
+        iree_allocator_null(), &input_buffer));
 
     // Wrap the input buffers in buffer views.
     iree_hal_buffer_view_t* input_buffer_view = nullptr;
-    IREE_RETURN_IF_ERROR(iree_hal_buffer_view_create(
+    iree_status_t status = iree_hal_buffer_view_create(
         input_buffer,
         /*shape=*/&input_element_count,
-        /*shape_rank=*/1, IREE_HAL_ELEMENT_TYPE_FLOAT_32, &input_buffer_view));
+        /*shape_rank=*/1, IREE_HAL_ELEMENT_TYPE_FLOAT_32,
+        IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR, &input_buffer_view);
     iree_hal_buffer_release(input_buffer);
+    IREE_RETURN_IF_ERROR(status);
 
     // Marshal the input buffer views through the input VM variant list.
     auto input_buffer_view_ref =
         iree_hal_buffer_view_move_ref(input_buffer_view);
     IREE_RETURN_IF_ERROR(
-        iree_vm_list_push_ref_move(input_list.get(), &input_buffer_view_ref));
+        iree_vm_list_push_ref_move(input_list, &input_buffer_view_ref));
   }
 
-  // Prepare outputs list to accept results from the invocation.
-  vm::ref<iree_vm_list_t> outputs;
-  IREE_RETURN_IF_ERROR(iree_vm_list_create(/*element_type=*/nullptr,
-                                           4 * sizeof(float),
-                                           iree_allocator_system(), &outputs));
-
   // Synchronously invoke the function.
-  IREE_RETURN_IF_ERROR(iree_vm_invoke(context_, *function_wrapper.function(),
-                                      /*policy=*/nullptr, input_list.get(),
-                                      outputs.get(), iree_allocator_system()));
-
-  // Read back the results into the given output buffer.
-  auto* output_buffer_view =
-      reinterpret_cast<iree_hal_buffer_view_t*>(iree_vm_list_get_ref_deref(
-          outputs.get(), 0, iree_hal_buffer_view_get_descriptor()));
-  auto* output_buffer = iree_hal_buffer_view_buffer(output_buffer_view);
-  // TODO(jennik): this is unsafe - we don't know the size of output ptr here!
-  IREE_RETURN_IF_ERROR(iree_hal_buffer_read_data(
-      output_buffer, 0, output, iree_hal_buffer_byte_length(output_buffer)));
-  return OkStatus();
+  iree_status_t status =
+      iree_vm_invoke(context_, *function_wrapper->function(),
+                     /*policy=*/nullptr, input_list, output_list,
+                     iree_allocator_system());
+
+  // Read back the results into the given output buffer. The results are
+  // allocated by the program and cannot be aliased with the caller memory.
+  if (iree_status_is_ok(status)) {
+    auto* output_buffer_view =
+        reinterpret_cast<iree_hal_buffer_view_t*>(iree_vm_list_get_ref_deref(
+            output_list, 0, iree_hal_buffer_view_get_descriptor()));
+    if (!output_buffer_view) {
+      status = iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "function result 0 is not a buffer view");
+    }
+    if (iree_status_is_ok(status)) {
+      auto* output_buffer = iree_hal_buffer_view_buffer(output_buffer_view);
+      iree_device_size_t byte_length =
+          iree_hal_buffer_byte_length(output_buffer);
+      if (byte_length > output_byte_length) {
+        status = iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                                  "output buffer too small for the result");
+      } else {
+        status = iree_hal_buffer_read_data(output_buffer, 0, output,
+                                           byte_length);
+      }
+    }
+  }
+
+  // Drop the references to the caller memory and results; the lists remain
+  // allocated for the next call.
+  function_wrapper->ResetCallLists(inputs.size()).IgnoreError();
+  return status;
 }
 
 int ContextWrapper::id() const { return iree_vm_context_id(context_); }
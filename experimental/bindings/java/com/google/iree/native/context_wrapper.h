@@ -32,10 +32,14 @@ class ContextWrapper {
   Status ResolveFunction(iree_string_view_t name,
                          FunctionWrapper* function_wrapper);
 
+  // Invokes the function with |inputs| wrapped in place as HAL buffers; the
+  // memory must remain valid for the duration of the call. The first result is
+  // copied into |output|, which must hold at least |output_byte_length| bytes.
   // TODO(jennik): Support other input types aside from floats.
-  Status InvokeFunction(const FunctionWrapper& function_wrapper,
+  Status InvokeFunction(FunctionWrapper* function_wrapper,
                         const std::vector<float*>& inputs,
-                        int input_element_count, float* output);
+                        int input_element_count, float* output,
+                        iree_host_size_t output_byte_length);
 
   int id() const;
 
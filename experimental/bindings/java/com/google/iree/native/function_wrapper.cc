@@ -21,5 +21,28 @@ iree_vm_function_signature_t FunctionWrapper::signature() const {
   return iree_vm_function_signature(function_.get());
 }
 
+Status FunctionWrapper::ResetCallLists(iree_host_size_t input_capacity) {
+  if (!inputs_) {
+    IREE_RETURN_IF_ERROR(iree_vm_list_create(
+        /*element_type=*/nullptr, input_capacity, iree_allocator_system(),
+        &inputs_));
+  } else {
+    IREE_RETURN_IF_ERROR(iree_vm_list_resize(inputs_.get(), 0));
+    IREE_RETURN_IF_ERROR(iree_vm_list_reserve(inputs_.get(), input_capacity));
+  }
+  if (!outputs_) {
+    IREE_RETURN_IF_ERROR(iree_vm_list_create(
+        /*element_type=*/nullptr, /*initial_capacity=*/1,
+        iree_allocator_system(), &outputs_));
+  } else {
+    IREE_RETURN_IF_ERROR(iree_vm_list_resize(outputs_.get(), 0));
+  }
+  return OkStatus();
+}
+
+iree_vm_list_t* FunctionWrapper::inputs() const { return inputs_.get(); }
+
+iree_vm_list_t* FunctionWrapper::outputs() const { return outputs_.get(); }
+
 }  // namespace java
 }  // namespace iree
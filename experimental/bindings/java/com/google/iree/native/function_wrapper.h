@@ -9,7 +9,9 @@
 
 #include <memory>
 
+#include "iree/base/status_cc.h"
 #include "iree/vm/api.h"
+#include "iree/vm/ref_cc.h"
 
 namespace iree {
 namespace java {
@@ -22,9 +24,20 @@ class FunctionWrapper {
 
   iree_vm_function_signature_t signature() const;
 
+  // Clears the argument and result lists used to invoke the function so that
+  // they can be reused for another call. The lists are created on first use
+  // and kept for the lifetime of the function to avoid per-call allocations.
+  Status ResetCallLists(iree_host_size_t input_capacity);
+
+  iree_vm_list_t* inputs() const;
+
+  iree_vm_list_t* outputs() const;
+
  private:
   std::unique_ptr<iree_vm_function_t> function_ =
       std::make_unique<iree_vm_function_t>();
+  vm::ref<iree_vm_list_t> inputs_;
+  vm::ref<iree_vm_list_t> outputs_;
 };
 
 }  // namespace java
@@ -65,7 +65,8 @@ extern "C" int main(int argc, char** argv) {
   int element_count = 4;
 
   auto invoke_status =
-      context->InvokeFunction(function, input, element_count, output);
+      context->InvokeFunction(&function, input, element_count, output,
+                              sizeof(output));
   if (!context_status.ok()) {
     IREE_LOG(ERROR) << "Invoke function error: " << function_status.code();
     return 1;
@@ -16,6 +16,57 @@
 extern "C" {
 #endif  // __cplusplus
 
+// Parameters configuring an iree_hal_rocm_device_t.
+// Must be initialized with iree_hal_rocm_device_params_initialize prior to use.
+typedef struct iree_hal_rocm_device_params_t {
+  // Records command buffers into HIP graphs that are instantiated once when
+  // recording ends and launched with a single hipGraphLaunch per submission.
+  // When false commands are issued to the device as they are recorded.
+  bool use_graph_command_buffers;
+
+  // Maximum total size in bytes of released device-local allocations that the
+  // device allocator retains for reuse. Retained blocks are handed out again
+  // to later allocations of a similar size instead of being returned to the
+  // driver with a synchronizing hipFree. 0 disables caching.
+  iree_device_size_t allocator_max_cached_size;
+} iree_hal_rocm_device_params_t;
+
+// Initializes |out_params| to default values.
+IREE_API_EXPORT void iree_hal_rocm_device_params_initialize(
+    iree_hal_rocm_device_params_t *out_params);
+
+//===----------------------------------------------------------------------===//
+// iree_hal_rocm_allocator_t
+//===----------------------------------------------------------------------===//
+
+// Aggregate statistics of a ROCM device allocator.
+typedef struct iree_hal_rocm_allocator_statistics_t {
+  // Total bytes of device memory backing live buffers.
+  iree_device_size_t live_size;
+  // Total bytes of device memory retained for reuse by the allocator.
+  iree_device_size_t cached_size;
+  // Peak total bytes of device memory held by the allocator (live and cached).
+  iree_device_size_t peak_size;
+  // Total number of device-local buffers allocated.
+  uint64_t allocation_count;
+  // Number of allocations that reused a retained block.
+  uint64_t cache_hit_count;
+  // Number of allocations and frees made with the driver.
+  uint64_t driver_allocation_count;
+  uint64_t driver_free_count;
+} iree_hal_rocm_allocator_statistics_t;
+
+// Queries the aggregate statistics of a ROCM device |allocator|.
+// Fails if the allocator is not a ROCM allocator.
+IREE_API_EXPORT iree_status_t iree_hal_rocm_allocator_query_statistics(
+    iree_hal_allocator_t *allocator,
+    iree_hal_rocm_allocator_statistics_t *out_statistics);
+
+// Returns all device memory retained by a ROCM device |allocator| to the
+// driver. Live buffers are unaffected. No-op if not a ROCM allocator.
+IREE_API_EXPORT void iree_hal_rocm_allocator_trim(
+    iree_hal_allocator_t *allocator);
+
 //===----------------------------------------------------------------------===//
 // iree_hal_rocm_driver_t
 //===----------------------------------------------------------------------===//
@@ -35,6 +86,7 @@ IREE_API_EXPORT void iree_hal_rocm_driver_options_initialize(
 // |out_driver| must be released by the caller (see |iree_hal_driver_release|).
 IREE_API_EXPORT iree_status_t iree_hal_rocm_driver_create(
     iree_string_view_t identifier,
+    const iree_hal_rocm_device_params_t *default_params,
     const iree_hal_rocm_driver_options_t *options,
     iree_allocator_t host_allocator, iree_hal_driver_t **out_driver);
 
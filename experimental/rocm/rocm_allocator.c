@@ -7,16 +7,57 @@
 #include "experimental/rocm/rocm_allocator.h"
 
 #include <stddef.h>
+#include <stdint.h>
+#include <string.h>
 
+#include "experimental/rocm/api.h"
 #include "experimental/rocm/dynamic_symbols.h"
 #include "experimental/rocm/rocm_buffer.h"
 #include "experimental/rocm/status_util.h"
 #include "iree/base/api.h"
+#include "iree/base/internal/math.h"
+#include "iree/base/internal/synchronization.h"
 #include "iree/base/tracing.h"
 
+// log2 of the smallest device block size. Smaller requests are rounded up.
+#define IREE_HAL_ROCM_ALLOCATOR_MIN_BLOCK_SIZE_LOG2 9
+
+// Each power-of-two range of block sizes is split into this many bins so that
+// rounding up to a bin wastes at most 1/4 of the block.
+#define IREE_HAL_ROCM_ALLOCATOR_BINS_PER_POW2_LOG2 2
+#define IREE_HAL_ROCM_ALLOCATOR_BINS_PER_POW2 \
+  (1 << IREE_HAL_ROCM_ALLOCATOR_BINS_PER_POW2_LOG2)
+
+// Total number of bins, covering blocks from 512B up to 64GB. Larger
+// allocations are never cached.
+#define IREE_HAL_ROCM_ALLOCATOR_BIN_COUNT \
+  ((36 - IREE_HAL_ROCM_ALLOCATOR_MIN_BLOCK_SIZE_LOG2) * \
+   IREE_HAL_ROCM_ALLOCATOR_BINS_PER_POW2)
+
+// A device memory block retained for reuse. Device memory is not host
+// accessible so the free list nodes live in host memory.
+typedef struct iree_hal_rocm_cached_block_t {
+  struct iree_hal_rocm_cached_block_t* next;
+  hipDeviceptr_t device_ptr;
+} iree_hal_rocm_cached_block_t;
+
 typedef struct iree_hal_rocm_allocator_t {
   iree_hal_resource_t resource;
   iree_hal_rocm_context_wrapper_t* context;
+
+  // Maximum total bytes of released blocks retained in the bins.
+  // The device synchronizes all work at submission so blocks released by
+  // buffers are no longer in use by the device and can be reused immediately.
+  iree_device_size_t max_cached_size;
+
+  // Guards all state below.
+  iree_slim_mutex_t mutex;
+  // LIFO free lists of retained blocks, one per bin.
+  iree_hal_rocm_cached_block_t* bins[IREE_HAL_ROCM_ALLOCATOR_BIN_COUNT];
+  // Unused free list nodes.
+  iree_hal_rocm_cached_block_t* node_pool;
+  iree_hal_rocm_allocator_statistics_t statistics;
+  iree_hal_allocator_statistics_t memory_statistics;
 } iree_hal_rocm_allocator_t;
 
 extern const iree_hal_allocator_vtable_t iree_hal_rocm_allocator_vtable;
@@ -29,7 +70,7 @@ static iree_hal_rocm_allocator_t* iree_hal_rocm_allocator_cast(
 
 iree_status_t iree_hal_rocm_allocator_create(
     iree_hal_rocm_context_wrapper_t* context,
-    iree_hal_allocator_t** out_allocator) {
+    iree_device_size_t max_cached_size, iree_hal_allocator_t** out_allocator) {
   IREE_ASSERT_ARGUMENT(context);
   IREE_TRACE_ZONE_BEGIN(z0);
   iree_hal_rocm_allocator_t* allocator = NULL;
@@ -39,6 +80,13 @@ iree_status_t iree_hal_rocm_allocator_create(
     iree_hal_resource_initialize(&iree_hal_rocm_allocator_vtable,
                                  &allocator->resource);
     allocator->context = context;
+    allocator->max_cached_size = max_cached_size;
+    iree_slim_mutex_initialize(&allocator->mutex);
+    memset(allocator->bins, 0, sizeof(allocator->bins));
+    allocator->node_pool = NULL;
+    memset(&allocator->statistics, 0, sizeof(allocator->statistics));
+    memset(&allocator->memory_statistics, 0,
+           sizeof(allocator->memory_statistics));
     *out_allocator = (iree_hal_allocator_t*)allocator;
   }
 
@@ -46,6 +94,162 @@ iree_status_t iree_hal_rocm_allocator_create(
   return status;
 }
 
+// Returns the bin that device-local blocks for |allocation_size| bytes are
+// allocated from and the size of the blocks in the bin or -1 if the size is
+// larger than any bin.
+static int iree_hal_rocm_allocator_select_bin(
+    iree_device_size_t allocation_size, iree_device_size_t* out_block_size) {
+  uint64_t size = iree_max(
+      allocation_size, 1ull << IREE_HAL_ROCM_ALLOCATOR_MIN_BLOCK_SIZE_LOG2);
+  int size_log2 = 63 - iree_math_count_leading_zeros_u64(size);
+  uint64_t step = (1ull << size_log2) >>
+                  IREE_HAL_ROCM_ALLOCATOR_BINS_PER_POW2_LOG2;
+  uint64_t block_size = (size + step - 1) & ~(step - 1);
+  // NOTE: block_size may have rounded up to the next power of two in which
+  // case the sub-bin index overflows into the first bin of the next range.
+  int bin = (size_log2 - IREE_HAL_ROCM_ALLOCATOR_MIN_BLOCK_SIZE_LOG2) *
+                IREE_HAL_ROCM_ALLOCATOR_BINS_PER_POW2 +
+            (int)(block_size / step) - IREE_HAL_ROCM_ALLOCATOR_BINS_PER_POW2;
+  *out_block_size = (iree_device_size_t)block_size;
+  return bin < IREE_HAL_ROCM_ALLOCATOR_BIN_COUNT ? bin : -1;
+}
+
+// Tracks |block_size| bytes becoming live. Must be called with the lock held.
+static void iree_hal_rocm_allocator_note_live(
+    iree_hal_rocm_allocator_t* allocator, iree_device_size_t block_size) {
+  iree_hal_rocm_allocator_statistics_t* statistics = &allocator->statistics;
+  statistics->live_size += block_size;
+  statistics->peak_size =
+      iree_max(statistics->peak_size,
+               statistics->live_size + statistics->cached_size);
+}
+
+// Acquires a device-local block for |allocation_size| bytes either from the
+// bins or the driver.
+static iree_status_t iree_hal_rocm_allocator_acquire_device_block(
+    iree_hal_rocm_allocator_t* allocator, iree_device_size_t allocation_size,
+    hipDeviceptr_t* out_device_ptr) {
+  iree_device_size_t block_size = 0;
+  int bin = iree_hal_rocm_allocator_select_bin(allocation_size, &block_size);
+  if (bin < 0) block_size = allocation_size;
+
+  iree_slim_mutex_lock(&allocator->mutex);
+  ++allocator->statistics.allocation_count;
+  if (bin >= 0 && allocator->bins[bin]) {
+    iree_hal_rocm_cached_block_t* block = allocator->bins[bin];
+    allocator->bins[bin] = block->next;
+    block->next = allocator->node_pool;
+    allocator->node_pool = block;
+    *out_device_ptr = block->device_ptr;
+    ++allocator->statistics.cache_hit_count;
+    allocator->statistics.cached_size -= block_size;
+    iree_hal_rocm_allocator_note_live(allocator, block_size);
+    iree_slim_mutex_unlock(&allocator->mutex);
+    return iree_ok_status();
+  }
+  iree_slim_mutex_unlock(&allocator->mutex);
+
+  iree_hal_rocm_dynamic_symbols_t* syms = allocator->context->syms;
+  iree_status_t status =
+      ROCM_RESULT_TO_STATUS(syms, hipMalloc(out_device_ptr, block_size));
+  if (!iree_status_is_ok(status)) {
+    // Out of memory (or otherwise failing): give back everything we are
+    // holding on to and try once more.
+    iree_status_ignore(status);
+    iree_hal_rocm_allocator_trim((iree_hal_allocator_t*)allocator);
+    status = ROCM_RESULT_TO_STATUS(syms, hipMalloc(out_device_ptr, block_size));
+  }
+  if (iree_status_is_ok(status)) {
+    iree_slim_mutex_lock(&allocator->mutex);
+    ++allocator->statistics.driver_allocation_count;
+    iree_hal_rocm_allocator_note_live(allocator, block_size);
+    iree_slim_mutex_unlock(&allocator->mutex);
+  }
+  return status;
+}
+
+// Releases a device-local block for |allocation_size| bytes either to the bins
+// for reuse or to the driver.
+static void iree_hal_rocm_allocator_release_device_block(
+    iree_hal_rocm_allocator_t* allocator, hipDeviceptr_t device_ptr,
+    iree_device_size_t allocation_size) {
+  iree_device_size_t block_size = 0;
+  int bin = iree_hal_rocm_allocator_select_bin(allocation_size, &block_size);
+  if (bin < 0) block_size = allocation_size;
+
+  iree_slim_mutex_lock(&allocator->mutex);
+  allocator->statistics.live_size -= block_size;
+  if (bin >= 0 && allocator->statistics.cached_size + block_size <=
+                      allocator->max_cached_size) {
+    iree_hal_rocm_cached_block_t* block = allocator->node_pool;
+    if (block) {
+      allocator->node_pool = block->next;
+    } else if (!iree_status_is_ok(iree_allocator_malloc(
+                   allocator->context->host_allocator, sizeof(*block),
+                   (void**)&block))) {
+      block = NULL;
+    }
+    if (block) {
+      block->device_ptr = device_ptr;
+      block->next = allocator->bins[bin];
+      allocator->bins[bin] = block;
+      allocator->statistics.cached_size += block_size;
+      iree_slim_mutex_unlock(&allocator->mutex);
+      return;
+    }
+  }
+  ++allocator->statistics.driver_free_count;
+  iree_slim_mutex_unlock(&allocator->mutex);
+  ROCM_IGNORE_ERROR(allocator->context->syms, hipFree(device_ptr));
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_rocm_allocator_query_statistics(
+    iree_hal_allocator_t* base_allocator,
+    iree_hal_rocm_allocator_statistics_t* out_statistics) {
+  IREE_ASSERT_ARGUMENT(base_allocator);
+  IREE_ASSERT_ARGUMENT(out_statistics);
+  memset(out_statistics, 0, sizeof(*out_statistics));
+  if (!iree_hal_resource_is(base_allocator, &iree_hal_rocm_allocator_vtable)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "allocator is not a ROCM allocator");
+  }
+  iree_hal_rocm_allocator_t* allocator =
+      iree_hal_rocm_allocator_cast(base_allocator);
+  iree_slim_mutex_lock(&allocator->mutex);
+  *out_statistics = allocator->statistics;
+  iree_slim_mutex_unlock(&allocator->mutex);
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT void iree_hal_rocm_allocator_trim(
+    iree_hal_allocator_t* base_allocator) {
+  IREE_ASSERT_ARGUMENT(base_allocator);
+  if (!iree_hal_resource_is(base_allocator, &iree_hal_rocm_allocator_vtable)) {
+    return;
+  }
+  iree_hal_rocm_allocator_t* allocator =
+      iree_hal_rocm_allocator_cast(base_allocator);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_slim_mutex_lock(&allocator->mutex);
+  for (int i = 0; i < IREE_HAL_ROCM_ALLOCATOR_BIN_COUNT; ++i) {
+    iree_hal_rocm_cached_block_t* block = allocator->bins[i];
+    while (block) {
+      iree_hal_rocm_cached_block_t* next = block->next;
+      ROCM_IGNORE_ERROR(allocator->context->syms, hipFree(block->device_ptr));
+      ++allocator->statistics.driver_free_count;
+      block->next = allocator->node_pool;
+      allocator->node_pool = block;
+      block = next;
+    }
+    allocator->bins[i] = NULL;
+  }
+  allocator->statistics.cached_size = 0;
+  iree_slim_mutex_unlock(&allocator->mutex);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
 static void iree_hal_rocm_allocator_destroy(
     iree_hal_allocator_t* base_allocator) {
   iree_hal_rocm_allocator_t* allocator =
@@ -53,6 +257,14 @@ static void iree_hal_rocm_allocator_destroy(
   iree_allocator_t host_allocator = allocator->context->host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  iree_hal_rocm_allocator_trim(base_allocator);
+  iree_hal_rocm_cached_block_t* node = allocator->node_pool;
+  while (node) {
+    iree_hal_rocm_cached_block_t* next = node->next;
+    iree_allocator_free(host_allocator, node);
+    node = next;
+  }
+  iree_slim_mutex_deinitialize(&allocator->mutex);
   iree_allocator_free(host_allocator, allocator);
 
   IREE_TRACE_ZONE_END(z0);
@@ -95,6 +307,24 @@ iree_hal_rocm_allocator_query_buffer_compatibility(
   return compatibility;
 }
 
+// Frees memory allocated by the allocator.
+static void iree_hal_rocm_allocator_free_memory(
+    iree_hal_rocm_allocator_t* allocator, hipDeviceptr_t device_ptr,
+    void* host_ptr, iree_hal_memory_type_t memory_type,
+    iree_device_size_t allocation_size) {
+  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL)) {
+    if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_HOST_VISIBLE)) {
+      ROCM_IGNORE_ERROR(allocator->context->syms, hipFree(device_ptr));
+    } else if (device_ptr) {
+      iree_hal_rocm_allocator_release_device_block(allocator, device_ptr,
+                                                   allocation_size);
+    }
+  } else {
+    // Host local.
+    ROCM_IGNORE_ERROR(allocator->context->syms, hipHostFree(host_ptr));
+  }
+}
+
 static iree_status_t iree_hal_rocm_allocator_allocate_buffer(
     iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
     iree_hal_buffer_usage_t allowed_usage, iree_host_size_t allocation_size,
@@ -116,9 +346,9 @@ static iree_status_t iree_hal_rocm_allocator_allocate_buffer(
           hipMallocManaged(&device_ptr, allocation_size, hipMemAttachGlobal));
       host_ptr = (void*)device_ptr;
     } else {
-      // Device only.
-      status = ROCM_RESULT_TO_STATUS(allocator->context->syms,
-                                     hipMalloc(&device_ptr, allocation_size));
+      // Device only; never host accessible so blocks can be recycled.
+      status = iree_hal_rocm_allocator_acquire_device_block(
+          allocator, allocation_size, &device_ptr);
     }
   } else {
     unsigned int flags = hipHostMallocMapped;
@@ -142,24 +372,32 @@ static iree_status_t iree_hal_rocm_allocator_allocate_buffer(
         /*byte_offset=*/0,
         /*byte_length=*/allocation_size, device_ptr, host_ptr, out_buffer);
   }
-  if (!iree_status_is_ok(status)) {
-    iree_hal_rocm_allocator_free(base_allocator, device_ptr, host_ptr,
-                                 memory_type);
+  if (iree_status_is_ok(status)) {
+    iree_slim_mutex_lock(&allocator->mutex);
+    iree_hal_allocator_statistics_record_alloc(&allocator->memory_statistics,
+                                               memory_type, allocation_size,
+                                               (void*)device_ptr);
+    iree_slim_mutex_unlock(&allocator->mutex);
+  } else {
+    iree_hal_rocm_allocator_free_memory(allocator, device_ptr, host_ptr,
+                                        memory_type, allocation_size);
   }
   return status;
 }
 
 void iree_hal_rocm_allocator_free(iree_hal_allocator_t* base_allocator,
                                   hipDeviceptr_t device_ptr, void* host_ptr,
-                                  iree_hal_memory_type_t memory_type) {
+                                  iree_hal_memory_type_t memory_type,
+                                  iree_device_size_t allocation_size) {
   iree_hal_rocm_allocator_t* allocator =
       iree_hal_rocm_allocator_cast(base_allocator);
-  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL)) {
-    ROCM_IGNORE_ERROR(allocator->context->syms, hipFree(device_ptr));
-  } else {
-    // Host local.
-    ROCM_IGNORE_ERROR(allocator->context->syms, hipHostFree(host_ptr));
-  }
+  iree_hal_rocm_allocator_free_memory(allocator, device_ptr, host_ptr,
+                                      memory_type, allocation_size);
+  iree_slim_mutex_lock(&allocator->mutex);
+  iree_hal_allocator_statistics_record_free(&allocator->memory_statistics,
+                                            memory_type, allocation_size,
+                                            (void*)device_ptr);
+  iree_slim_mutex_unlock(&allocator->mutex);
 }
 
 static iree_status_t iree_hal_rocm_allocator_wrap_buffer(
@@ -171,6 +409,25 @@ static iree_status_t iree_hal_rocm_allocator_wrap_buffer(
                           "wrapping of external buffers not supported");
 }
 
+static void iree_hal_rocm_allocator_query_memory_statistics(
+    iree_hal_allocator_t* base_allocator,
+    iree_hal_allocator_statistics_t* out_statistics) {
+  iree_hal_rocm_allocator_t* allocator =
+      iree_hal_rocm_allocator_cast(base_allocator);
+  iree_slim_mutex_lock(&allocator->mutex);
+  *out_statistics = allocator->memory_statistics;
+  iree_slim_mutex_unlock(&allocator->mutex);
+}
+
+static void iree_hal_rocm_allocator_reset_peak_memory_statistics(
+    iree_hal_allocator_t* base_allocator) {
+  iree_hal_rocm_allocator_t* allocator =
+      iree_hal_rocm_allocator_cast(base_allocator);
+  iree_slim_mutex_lock(&allocator->mutex);
+  iree_hal_allocator_statistics_reset_peak(&allocator->memory_statistics);
+  iree_slim_mutex_unlock(&allocator->mutex);
+}
+
 const iree_hal_allocator_vtable_t iree_hal_rocm_allocator_vtable = {
     .destroy = iree_hal_rocm_allocator_destroy,
     .host_allocator = iree_hal_rocm_allocator_host_allocator,
@@ -178,4 +435,7 @@ const iree_hal_allocator_vtable_t iree_hal_rocm_allocator_vtable = {
         iree_hal_rocm_allocator_query_buffer_compatibility,
     .allocate_buffer = iree_hal_rocm_allocator_allocate_buffer,
     .wrap_buffer = iree_hal_rocm_allocator_wrap_buffer,
+    .query_statistics = iree_hal_rocm_allocator_query_memory_statistics,
+    .reset_peak_statistics =
+        iree_hal_rocm_allocator_reset_peak_memory_statistics,
 };
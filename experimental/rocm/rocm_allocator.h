@@ -17,14 +17,18 @@ extern "C" {
 #endif  // __cplusplus
 
 // Create a ROCM allocator.
+// Up to |max_cached_size| bytes of released device-local blocks are retained
+// for reuse by later allocations of a similar size.
 iree_status_t iree_hal_rocm_allocator_create(
     iree_hal_rocm_context_wrapper_t* context,
-    iree_hal_allocator_t** out_allocator);
+    iree_device_size_t max_cached_size, iree_hal_allocator_t** out_allocator);
 
 // Free an allocation represent by the given device or host pointer.
+// |allocation_size| must match the size the allocation was made with.
 void iree_hal_rocm_allocator_free(iree_hal_allocator_t* allocator,
                                   hipDeviceptr_t device_ptr, void* host_ptr,
-                                  iree_hal_memory_type_t memory_type);
+                                  iree_hal_memory_type_t memory_type,
+                                  iree_device_size_t allocation_size);
 
 #ifdef __cplusplus
 }  // extern "C"
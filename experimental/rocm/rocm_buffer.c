@@ -69,7 +69,8 @@ static void iree_hal_rocm_buffer_destroy(iree_hal_buffer_t* base_buffer) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
   iree_hal_rocm_allocator_free(buffer->base.allocator, buffer->device_ptr,
-                               buffer->host_ptr, buffer->base.memory_type);
+                               buffer->host_ptr, buffer->base.memory_type,
+                               buffer->base.allocation_size);
   iree_allocator_free(host_allocator, buffer);
 
   IREE_TRACE_ZONE_END(z0);
@@ -16,6 +16,7 @@
 #include "experimental/rocm/dynamic_symbols.h"
 #include "experimental/rocm/event_semaphore.h"
 #include "experimental/rocm/executable_layout.h"
+#include "experimental/rocm/graph_command_buffer.h"
 #include "experimental/rocm/nop_executable_cache.h"
 #include "experimental/rocm/rocm_allocator.h"
 #include "experimental/rocm/rocm_event.h"
@@ -41,6 +42,9 @@ typedef struct iree_hal_rocm_device_t {
   iree_hal_rocm_context_wrapper_t context_wrapper;
   iree_hal_allocator_t* device_allocator;
 
+  // True if command buffers are recorded into HIP graphs launched on |stream|
+  // at submission instead of being issued directly as they are recorded.
+  bool use_graph_command_buffers;
 } iree_hal_rocm_device_t;
 
 extern const iree_hal_device_vtable_t iree_hal_rocm_device_vtable;
@@ -51,6 +55,12 @@ static iree_hal_rocm_device_t* iree_hal_rocm_device_cast(
   return (iree_hal_rocm_device_t*)base_value;
 }
 
+IREE_API_EXPORT void iree_hal_rocm_device_params_initialize(
+    iree_hal_rocm_device_params_t* out_params) {
+  out_params->use_graph_command_buffers = true;
+  out_params->allocator_max_cached_size = 512 * 1024 * 1024;
+}
+
 static void iree_hal_rocm_device_destroy(iree_hal_device_t* base_device) {
   iree_hal_rocm_device_t* device = iree_hal_rocm_device_cast(base_device);
   iree_allocator_t host_allocator = iree_hal_device_host_allocator(base_device);
@@ -71,9 +81,9 @@ static void iree_hal_rocm_device_destroy(iree_hal_device_t* base_device) {
 
 static iree_status_t iree_hal_rocm_device_create_internal(
     iree_hal_driver_t* driver, iree_string_view_t identifier,
-    hipDevice_t rocm_device, hipStream_t stream, hipCtx_t context,
-    iree_hal_rocm_dynamic_symbols_t* syms, iree_allocator_t host_allocator,
-    iree_hal_device_t** out_device) {
+    const iree_hal_rocm_device_params_t* params, hipDevice_t rocm_device,
+    hipStream_t stream, hipCtx_t context, iree_hal_rocm_dynamic_symbols_t* syms,
+    iree_allocator_t host_allocator, iree_hal_device_t** out_device) {
   iree_hal_rocm_device_t* device = NULL;
   iree_host_size_t total_size = sizeof(*device) + identifier.size;
   IREE_RETURN_IF_ERROR(
@@ -90,8 +100,10 @@ static iree_status_t iree_hal_rocm_device_create_internal(
   device->context_wrapper.rocm_context = context;
   device->context_wrapper.host_allocator = host_allocator;
   device->context_wrapper.syms = syms;
+  device->use_graph_command_buffers = params->use_graph_command_buffers;
   iree_status_t status = iree_hal_rocm_allocator_create(
-      &device->context_wrapper, &device->device_allocator);
+      &device->context_wrapper, params->allocator_max_cached_size,
+      &device->device_allocator);
   if (iree_status_is_ok(status)) {
     *out_device = (iree_hal_device_t*)device;
   } else {
@@ -100,12 +112,12 @@ static iree_status_t iree_hal_rocm_device_create_internal(
   return status;
 }
 
-iree_status_t iree_hal_rocm_device_create(iree_hal_driver_t* driver,
-                                          iree_string_view_t identifier,
-                                          iree_hal_rocm_dynamic_symbols_t* syms,
-                                          hipDevice_t device,
-                                          iree_allocator_t host_allocator,
-                                          iree_hal_device_t** out_device) {
+iree_status_t iree_hal_rocm_device_create(
+    iree_hal_driver_t* driver, iree_string_view_t identifier,
+    const iree_hal_rocm_device_params_t* params,
+    iree_hal_rocm_dynamic_symbols_t* syms, hipDevice_t device,
+    iree_allocator_t host_allocator, iree_hal_device_t** out_device) {
+  IREE_ASSERT_ARGUMENT(params);
   IREE_TRACE_ZONE_BEGIN(z0);
   hipCtx_t context;
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
@@ -115,9 +127,9 @@ iree_status_t iree_hal_rocm_device_create(iree_hal_driver_t* driver,
       syms, hipStreamCreateWithFlags(&stream, hipStreamNonBlocking));
 
   if (iree_status_is_ok(status)) {
-    status = iree_hal_rocm_device_create_internal(driver, identifier, device,
-                                                  stream, context, syms,
-                                                  host_allocator, out_device);
+    status = iree_hal_rocm_device_create_internal(
+        driver, identifier, params, device, stream, context, syms,
+        host_allocator, out_device);
   }
   if (!iree_status_is_ok(status)) {
     if (stream) {
@@ -174,6 +186,11 @@ static iree_status_t iree_hal_rocm_device_create_command_buffer(
     iree_hal_queue_affinity_t queue_affinity,
     iree_hal_command_buffer_t** out_command_buffer) {
   iree_hal_rocm_device_t* device = iree_hal_rocm_device_cast(base_device);
+  if (device->use_graph_command_buffers) {
+    return iree_hal_rocm_graph_command_buffer_create(
+        &device->context_wrapper, mode, command_categories, queue_affinity,
+        out_command_buffer);
+  }
   return iree_hal_rocm_direct_command_buffer_create(
       &device->context_wrapper, mode, command_categories, queue_affinity,
       out_command_buffer);
@@ -241,10 +258,27 @@ static iree_status_t iree_hal_rocm_device_queue_submit(
     const iree_hal_submission_batch_t* batches) {
   iree_hal_rocm_device_t* device = iree_hal_rocm_device_cast(base_device);
   // TODO(raikonenfnu): Once semaphore is implemented wait for semaphores
+  if (device->use_graph_command_buffers) {
+    for (iree_host_size_t i = 0; i < batch_count; i++) {
+      for (iree_host_size_t j = 0; j < batches[i].command_buffer_count; j++) {
+        hipGraphExec_t exec = iree_hal_rocm_graph_command_buffer_exec(
+            batches[i].command_buffers[j]);
+        ROCM_RETURN_IF_ERROR(device->context_wrapper.syms,
+                             hipGraphLaunch(exec, device->stream),
+                             "hipGraphLaunch");
+      }
+    }
+    // TODO(thomasraoux): Conservatively syncronize after every submit until we
+    // support semaphores.
+    ROCM_RETURN_IF_ERROR(device->context_wrapper.syms,
+                         hipStreamSynchronize(device->stream),
+                         "hipStreamSynchronize");
+    return iree_ok_status();
+  }
   // TODO(thomasraoux): Conservatively syncronize after every submit until we
   // support semaphores.
-  // TODO(raikonenfnu): currently run on default/null stream, when cmd buffer
-  // stream work with device->stream, we'll change
+  // TODO(raikonenfnu): direct command buffers run on default/null stream, when
+  // cmd buffer stream work with device->stream, we'll change
   ROCM_RETURN_IF_ERROR(device->context_wrapper.syms, hipStreamSynchronize(0),
                        "hipStreamSynchronize");
   return iree_ok_status();
@@ -0,0 +1,112 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree_tf_compiler/TFL/Passes.h"
+#include "llvm/ADT/APFloat.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Support/LLVM.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+#include "tensorflow/compiler/mlir/lite/ir/tfl_ops.h"
+
+namespace mlir {
+namespace iree_integrations {
+namespace TFL {
+
+namespace {
+
+// Folds tfl.quantize(tfl.dequantize(%x)) back to %x when the quantized types
+// match. The round trip is exact and otherwise lowers to a pair of rescales.
+class FoldQuantizeOfDequantize
+    : public OpRewritePattern<mlir::TFL::QuantizeOp> {
+ public:
+  using OpRewritePattern<mlir::TFL::QuantizeOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(mlir::TFL::QuantizeOp quantizeOp,
+                                PatternRewriter &rewriter) const override {
+    auto dequantizeOp =
+        quantizeOp.input().getDefiningOp<mlir::TFL::DequantizeOp>();
+    if (!dequantizeOp) return failure();
+    if (dequantizeOp.input().getType() != quantizeOp.getType()) {
+      return failure();
+    }
+    rewriter.replaceOp(quantizeOp, dequantizeOp.input());
+    return success();
+  }
+};
+
+// Folds tfl.dequantize of a constant float16 tensor into a float32 constant.
+// Models converted with float16 weight compression would otherwise widen
+// every weight on each invocation.
+class FoldDequantizeOfF16Constant
+    : public OpRewritePattern<mlir::TFL::DequantizeOp> {
+ public:
+  using OpRewritePattern<mlir::TFL::DequantizeOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(mlir::TFL::DequantizeOp dequantizeOp,
+                                PatternRewriter &rewriter) const override {
+    DenseFPElementsAttr inputAttr;
+    if (!matchPattern(dequantizeOp.input(), m_Constant(&inputAttr))) {
+      return failure();
+    }
+    auto resultType = dequantizeOp.getType().dyn_cast<RankedTensorType>();
+    if (!inputAttr.getType().getElementType().isF16() || !resultType ||
+        !resultType.getElementType().isF32()) {
+      return failure();
+    }
+    auto resultAttr = inputAttr.mapValues(
+        resultType.getElementType(), [](const APFloat &value) {
+          APFloat result = value;
+          bool losesInfo = false;
+          result.convert(APFloat::IEEEsingle(), APFloat::rmNearestTiesToEven,
+                         &losesInfo);
+          return result.bitcastToAPInt();
+        });
+    rewriter.replaceOpWithNewOp<mlir::TFL::ConstOp>(dequantizeOp, resultAttr);
+    return success();
+  }
+};
+
+}  // namespace
+
+class FoldQuantizationPass
+    : public PassWrapper<FoldQuantizationPass, FunctionPass> {
+ public:
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<mlir::TFL::TensorFlowLiteDialect>();
+  }
+
+  StringRef getArgument() const override {
+    return "iree-tflite-fold-quantization";
+  }
+
+  StringRef getDescription() const override {
+    return "Folds redundant TFLite quantize/dequantize ops prior to "
+           "legalization";
+  }
+
+  void runOnFunction() override {
+    OwningRewritePatternList patterns(&getContext());
+    patterns.insert<FoldQuantizeOfDequantize, FoldDequantizeOfF16Constant>(
+        &getContext());
+    if (failed(applyPatternsAndFoldGreedily(getFunction(),
+                                            std::move(patterns)))) {
+      return signalPassFailure();
+    }
+  }
+};
+
+static PassRegistration<FoldQuantizationPass> pass;
+
+std::unique_ptr<OperationPass<FuncOp>> createFoldQuantizationPass() {
+  return std::make_unique<FoldQuantizationPass>();
+}
+
+}  // namespace TFL
+}  // namespace iree_integrations
+}  // namespace mlir
@@ -0,0 +1,250 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <algorithm>
+#include <cstring>
+
+#include "iree_tf_compiler/TFL/Passes.h"
+#include "mlir/Dialect/Tosa/IR/TosaOps.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Support/LLVM.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+namespace mlir {
+namespace iree_integrations {
+namespace TFL {
+
+namespace {
+
+// Returns the tosa.const defining |value| if it has no other users such that
+// folding into it does not duplicate the constant data.
+static tosa::ConstOp getSingleUseConstant(Value value) {
+  auto constOp = value.getDefiningOp<tosa::ConstOp>();
+  if (!constOp || !constOp->hasOneUse()) return {};
+  return constOp;
+}
+
+// Returns |attr| with its elements permuted by |perms| or nullptr if the
+// element type is not supported.
+static DenseElementsAttr transposeElements(DenseElementsAttr attr,
+                                           ArrayRef<int64_t> perms) {
+  ShapedType type = attr.getType();
+  ArrayRef<int64_t> shape = type.getShape();
+  SmallVector<int64_t> resultShape;
+  for (int64_t perm : perms) resultShape.push_back(shape[perm]);
+  auto resultType =
+      RankedTensorType::get(resultShape, type.getElementType());
+  if (attr.isSplat()) return attr.reshape(resultType);
+
+  Type elementType = type.getElementType();
+  if (!elementType.isIntOrFloat() ||
+      elementType.getIntOrFloatBitWidth() % 8 != 0) {
+    return {};
+  }
+  int64_t elementSize = elementType.getIntOrFloatBitWidth() / 8;
+  int64_t rank = type.getRank();
+  SmallVector<int64_t> strides(rank, 1);
+  for (int64_t i = rank - 2; i >= 0; --i) {
+    strides[i] = strides[i + 1] * shape[i + 1];
+  }
+
+  // Walk the result in row-major order and gather each element from its
+  // permuted source position.
+  ArrayRef<char> source = attr.getRawData();
+  std::vector<char> result(source.size());
+  SmallVector<int64_t> index(rank, 0);
+  for (int64_t i = 0, e = type.getNumElements(); i < e; ++i) {
+    int64_t offset = 0;
+    for (int64_t d = 0; d < rank; ++d) offset += index[d] * strides[perms[d]];
+    std::memcpy(&result[i * elementSize], &source[offset * elementSize],
+                elementSize);
+    for (int64_t d = rank - 1; d >= 0; --d) {
+      if (++index[d] < resultShape[d]) break;
+      index[d] = 0;
+    }
+  }
+  return DenseElementsAttr::getFromRawBuffer(resultType, result,
+                                             /*isSplatBuffer=*/false);
+}
+
+// Returns the permutation of a tosa.transpose if it is constant.
+static bool getTransposePerms(tosa::TransposeOp op,
+                              SmallVectorImpl<int64_t> &perms) {
+  DenseIntElementsAttr permsAttr;
+  if (!matchPattern(op.perms(), m_Constant(&permsAttr))) return false;
+  for (const APInt &perm : permsAttr.getValues<APInt>()) {
+    perms.push_back(perm.getSExtValue());
+  }
+  return true;
+}
+
+// Folds tosa.reshape of a constant into the constant. Reshapes of weights are
+// common when TFLite layouts are adapted to TOSA operand shapes.
+class FoldReshapeOfConstant : public OpRewritePattern<tosa::ReshapeOp> {
+ public:
+  using OpRewritePattern<tosa::ReshapeOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(tosa::ReshapeOp op,
+                                PatternRewriter &rewriter) const override {
+    auto constOp = getSingleUseConstant(op.input1());
+    auto resultType = op.getType().dyn_cast<RankedTensorType>();
+    if (!constOp || !resultType || !resultType.hasStaticShape()) {
+      return failure();
+    }
+    auto valueAttr = constOp.value().cast<DenseElementsAttr>();
+    auto reshapedAttr = valueAttr.reshape(RankedTensorType::get(
+        resultType.getShape(), valueAttr.getType().getElementType()));
+    rewriter.replaceOpWithNewOp<tosa::ConstOp>(op, resultType, reshapedAttr);
+    return success();
+  }
+};
+
+// Folds tosa.reshape(tosa.reshape(%x)) into a single reshape of %x and drops
+// reshapes that do not change the type.
+class FoldReshapeOfReshape : public OpRewritePattern<tosa::ReshapeOp> {
+ public:
+  using OpRewritePattern<tosa::ReshapeOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(tosa::ReshapeOp op,
+                                PatternRewriter &rewriter) const override {
+    if (op.input1().getType() == op.getType()) {
+      rewriter.replaceOp(op, op.input1());
+      return success();
+    }
+    auto producerOp = op.input1().getDefiningOp<tosa::ReshapeOp>();
+    if (!producerOp) return failure();
+    rewriter.replaceOpWithNewOp<tosa::ReshapeOp>(
+        op, op.getType(), producerOp.input1(), op.new_shape());
+    return success();
+  }
+};
+
+// Folds tosa.transpose of a constant with constant permutations into the
+// constant so that weights are stored in the layout they are consumed in.
+class FoldTransposeOfConstant : public OpRewritePattern<tosa::TransposeOp> {
+ public:
+  using OpRewritePattern<tosa::TransposeOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(tosa::TransposeOp op,
+                                PatternRewriter &rewriter) const override {
+    auto constOp = getSingleUseConstant(op.input1());
+    auto resultType = op.getType().dyn_cast<RankedTensorType>();
+    SmallVector<int64_t> perms;
+    if (!constOp || !resultType || !resultType.hasStaticShape() ||
+        !getTransposePerms(op, perms)) {
+      return failure();
+    }
+    auto valueAttr = constOp.value().cast<DenseElementsAttr>();
+    if (!valueAttr.getType().hasStaticShape()) return failure();
+    auto transposedAttr = transposeElements(valueAttr, perms);
+    if (!transposedAttr) return failure();
+    rewriter.replaceOpWithNewOp<tosa::ConstOp>(op, resultType, transposedAttr);
+    return success();
+  }
+};
+
+// Composes tosa.transpose(tosa.transpose(%x)) into a single transpose and
+// drops identity transposes.
+class FoldTransposeOfTranspose : public OpRewritePattern<tosa::TransposeOp> {
+ public:
+  using OpRewritePattern<tosa::TransposeOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(tosa::TransposeOp op,
+                                PatternRewriter &rewriter) const override {
+    SmallVector<int64_t> perms;
+    if (!getTransposePerms(op, perms)) return failure();
+    bool isIdentity = true;
+    for (int64_t i = 0, e = perms.size(); i < e; ++i) {
+      isIdentity &= perms[i] == i;
+    }
+    if (isIdentity && op.input1().getType() == op.getType()) {
+      rewriter.replaceOp(op, op.input1());
+      return success();
+    }
+
+    auto producerOp = op.input1().getDefiningOp<tosa::TransposeOp>();
+    SmallVector<int64_t> producerPerms;
+    if (!producerOp || !getTransposePerms(producerOp, producerPerms)) {
+      return failure();
+    }
+    SmallVector<int32_t> composedPerms;
+    for (int64_t perm : perms) composedPerms.push_back(producerPerms[perm]);
+    auto permsType = RankedTensorType::get(
+        {static_cast<int64_t>(composedPerms.size())}, rewriter.getI32Type());
+    auto permsOp = rewriter.create<tosa::ConstOp>(
+        op.getLoc(), permsType,
+        DenseIntElementsAttr::get(permsType, composedPerms));
+    rewriter.replaceOpWithNewOp<tosa::TransposeOp>(
+        op, op.getType(), producerOp.input1(), permsOp);
+    return success();
+  }
+};
+
+// Merges back-to-back tosa.clamp ops (such as a fused activation split from
+// its producer followed by an explicit relu6) into one clamp.
+class FoldClampOfClamp : public OpRewritePattern<tosa::ClampOp> {
+ public:
+  using OpRewritePattern<tosa::ClampOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(tosa::ClampOp op,
+                                PatternRewriter &rewriter) const override {
+    auto producerOp = op.input().getDefiningOp<tosa::ClampOp>();
+    if (!producerOp || !producerOp->hasOneUse()) return failure();
+    int64_t minInt = std::max(op.min_intAttr().getInt(),
+                              producerOp.min_intAttr().getInt());
+    int64_t maxInt = std::min(op.max_intAttr().getInt(),
+                              producerOp.max_intAttr().getInt());
+    double minFp = std::max(op.min_fpAttr().getValueAsDouble(),
+                            producerOp.min_fpAttr().getValueAsDouble());
+    double maxFp = std::min(op.max_fpAttr().getValueAsDouble(),
+                            producerOp.max_fpAttr().getValueAsDouble());
+    rewriter.replaceOpWithNewOp<tosa::ClampOp>(
+        op, op.getType(), producerOp.input(),
+        rewriter.getI64IntegerAttr(minInt), rewriter.getI64IntegerAttr(maxInt),
+        rewriter.getF32FloatAttr(minFp), rewriter.getF32FloatAttr(maxFp));
+    return success();
+  }
+};
+
+}  // namespace
+
+class OptimizeTOSAPass : public PassWrapper<OptimizeTOSAPass, FunctionPass> {
+ public:
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<tosa::TosaDialect>();
+  }
+
+  StringRef getArgument() const override { return "iree-tflite-optimize-tosa"; }
+
+  StringRef getDescription() const override {
+    return "Folds constant reshapes/transposes into weights and merges "
+           "redundant TOSA ops produced by TFLite legalization";
+  }
+
+  void runOnFunction() override {
+    OwningRewritePatternList patterns(&getContext());
+    patterns.insert<FoldClampOfClamp, FoldReshapeOfConstant,
+                    FoldReshapeOfReshape, FoldTransposeOfConstant,
+                    FoldTransposeOfTranspose>(&getContext());
+    if (failed(applyPatternsAndFoldGreedily(getFunction(),
+                                            std::move(patterns)))) {
+      return signalPassFailure();
+    }
+  }
+};
+
+static PassRegistration<OptimizeTOSAPass> pass;
+
+std::unique_ptr<OperationPass<FuncOp>> createOptimizeTOSAPass() {
+  return std::make_unique<OptimizeTOSAPass>();
+}
+
+}  // namespace TFL
+}  // namespace iree_integrations
+}  // namespace mlir
@@ -34,6 +34,7 @@ void buildTFLImportPassPipeline(OpPassManager &pm) {
 
   pm.addPass(createConvertModuleMetadataPass());
   pm.nest<ModuleOp>().addPass(createConvertFunctionMetadataPass());
+  pm.nest<ModuleOp>().addPass(createFoldQuantizationPass());
 
   //----------------------------------------------------------------------------
   // Convert all TFL ops to TOSA ops
@@ -41,6 +42,10 @@ void buildTFLImportPassPipeline(OpPassManager &pm) {
 
   mlir::tosa::TOSATFLLegalizationPipelineOptions tosaOptions;
   mlir::tosa::createTFLtoTOSALegalizationPipeline(pm, tosaOptions);
+
+  // Fold layout changes into weights so that the resulting programs form the
+  // same dispatch regions as equivalent natively imported models.
+  pm.nest<ModuleOp>().addPass(createOptimizeTOSAPass());
   pm.addPass(createCanonicalizerPass());
 
   //----------------------------------------------------------------------------
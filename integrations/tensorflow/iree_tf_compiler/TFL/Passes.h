@@ -29,6 +29,14 @@ void buildTFLImportPassPipeline(OpPassManager &pm);
 std::unique_ptr<OperationPass<ModuleOp>> createConvertModuleMetadataPass();
 std::unique_ptr<OperationPass<FuncOp>> createConvertFunctionMetadataPass();
 
+// Folds redundant TFLite quantize/dequantize pairs and float16 weight
+// dequantization prior to TOSA legalization.
+std::unique_ptr<OperationPass<FuncOp>> createFoldQuantizationPass();
+
+// Folds constant reshapes/transposes into weights and merges redundant TOSA
+// ops left behind by TFLite legalization.
+std::unique_ptr<OperationPass<FuncOp>> createOptimizeTOSAPass();
+
 // Strips all leftover TFLite-related attributes; none are needed by IREE.
 std::unique_ptr<OperationPass<ModuleOp>> createStripModuleMetadataPass();
 std::unique_ptr<OperationPass<FuncOp>> createStripFunctionMetadataPass();
@@ -47,6 +55,8 @@ inline void registerAllPasses() {
 
   createConvertModuleMetadataPass();
   createConvertFunctionMetadataPass();
+  createFoldQuantizationPass();
+  createOptimizeTOSAPass();
   createStripModuleMetadataPass();
   createStripFunctionMetadataPass();
   createVerifyFullyConvertedPass();
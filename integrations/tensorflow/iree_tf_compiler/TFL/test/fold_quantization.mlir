@@ -0,0 +1,35 @@
+// RUN: iree-opt-tflite -split-input-file -pass-pipeline='builtin.func(iree-tflite-fold-quantization)' %s | IreeFileCheck %s
+
+// CHECK-LABEL: func @quantize_of_dequantize
+// CHECK-SAME: %[[ARG0:.+]]: tensor<4x!quant.uniform<i8:f32, 1.000000e-01:2>>
+func @quantize_of_dequantize(%arg0: tensor<4x!quant.uniform<i8:f32, 0.1:2>>) -> tensor<4x!quant.uniform<i8:f32, 0.1:2>> {
+  // CHECK-NOT: tfl.dequantize
+  // CHECK-NOT: tfl.quantize
+  %0 = "tfl.dequantize"(%arg0) : (tensor<4x!quant.uniform<i8:f32, 0.1:2>>) -> tensor<4xf32>
+  %1 = "tfl.quantize"(%0) {qtype = tensor<4x!quant.uniform<i8:f32, 0.1:2>>} : (tensor<4xf32>) -> tensor<4x!quant.uniform<i8:f32, 0.1:2>>
+  // CHECK: return %[[ARG0]]
+  return %1 : tensor<4x!quant.uniform<i8:f32, 0.1:2>>
+}
+
+// -----
+
+// CHECK-LABEL: func @requantize_kept
+func @requantize_kept(%arg0: tensor<4x!quant.uniform<i8:f32, 0.1:2>>) -> tensor<4x!quant.uniform<i8:f32, 0.2:0>> {
+  // CHECK: tfl.dequantize
+  // CHECK: tfl.quantize
+  %0 = "tfl.dequantize"(%arg0) : (tensor<4x!quant.uniform<i8:f32, 0.1:2>>) -> tensor<4xf32>
+  %1 = "tfl.quantize"(%0) {qtype = tensor<4x!quant.uniform<i8:f32, 0.2:0>>} : (tensor<4xf32>) -> tensor<4x!quant.uniform<i8:f32, 0.2:0>>
+  return %1 : tensor<4x!quant.uniform<i8:f32, 0.2:0>>
+}
+
+// -----
+
+// CHECK-LABEL: func @dequantize_f16_constant
+func @dequantize_f16_constant() -> tensor<2xf32> {
+  // CHECK: %[[CST:.+]] = "tfl.pseudo_const"() {value = dense<[1.000000e+00, 2.500000e+00]> : tensor<2xf32>}
+  // CHECK-NOT: tfl.dequantize
+  %0 = "tfl.pseudo_const"() {value = dense<[1.0, 2.5]> : tensor<2xf16>} : () -> tensor<2xf16>
+  %1 = "tfl.dequantize"(%0) : (tensor<2xf16>) -> tensor<2xf32>
+  // CHECK: return %[[CST]]
+  return %1 : tensor<2xf32>
+}
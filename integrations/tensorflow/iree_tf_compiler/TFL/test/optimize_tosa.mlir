@@ -0,0 +1,88 @@
+// RUN: iree-opt-tflite -split-input-file -pass-pipeline='builtin.func(iree-tflite-optimize-tosa)' %s | IreeFileCheck %s
+
+// CHECK-LABEL: func @reshape_of_reshape
+// CHECK-SAME: %[[ARG0:.+]]: tensor<2x3xf32>
+func @reshape_of_reshape(%arg0: tensor<2x3xf32>) -> tensor<3x2xf32> {
+  // CHECK: %[[RESHAPE:.+]] = "tosa.reshape"(%[[ARG0]]) {new_shape = [3, 2]} : (tensor<2x3xf32>) -> tensor<3x2xf32>
+  %0 = "tosa.reshape"(%arg0) {new_shape = [6]} : (tensor<2x3xf32>) -> tensor<6xf32>
+  %1 = "tosa.reshape"(%0) {new_shape = [3, 2]} : (tensor<6xf32>) -> tensor<3x2xf32>
+  // CHECK: return %[[RESHAPE]]
+  return %1 : tensor<3x2xf32>
+}
+
+// -----
+
+// CHECK-LABEL: func @reshape_of_constant
+func @reshape_of_constant() -> tensor<2x2xf32> {
+  // CHECK: %[[CST:.+]] = "tosa.const"() {value = dense<{{\[\[}}1.000000e+00, 2.000000e+00], [3.000000e+00, 4.000000e+00]]> : tensor<2x2xf32>}
+  // CHECK-NOT: tosa.reshape
+  %0 = "tosa.const"() {value = dense<[1.0, 2.0, 3.0, 4.0]> : tensor<4xf32>} : () -> tensor<4xf32>
+  %1 = "tosa.reshape"(%0) {new_shape = [2, 2]} : (tensor<4xf32>) -> tensor<2x2xf32>
+  // CHECK: return %[[CST]]
+  return %1 : tensor<2x2xf32>
+}
+
+// -----
+
+// CHECK-LABEL: func @transpose_of_constant
+func @transpose_of_constant() -> tensor<3x2xi8> {
+  // CHECK: %[[CST:.+]] = "tosa.const"() {value = dense<{{\[\[}}1, 4], [2, 5], [3, 6]]> : tensor<3x2xi8>}
+  // CHECK-NOT: tosa.transpose
+  %0 = "tosa.const"() {value = dense<[[1, 2, 3], [4, 5, 6]]> : tensor<2x3xi8>} : () -> tensor<2x3xi8>
+  %perms = "tosa.const"() {value = dense<[1, 0]> : tensor<2xi32>} : () -> tensor<2xi32>
+  %1 = "tosa.transpose"(%0, %perms) : (tensor<2x3xi8>, tensor<2xi32>) -> tensor<3x2xi8>
+  // CHECK: return %[[CST]]
+  return %1 : tensor<3x2xi8>
+}
+
+// -----
+
+// CHECK-LABEL: func @transpose_of_shared_constant
+func @transpose_of_shared_constant() -> (tensor<2x3xi8>, tensor<3x2xi8>) {
+  // CHECK: tosa.transpose
+  %0 = "tosa.const"() {value = dense<[[1, 2, 3], [4, 5, 6]]> : tensor<2x3xi8>} : () -> tensor<2x3xi8>
+  %perms = "tosa.const"() {value = dense<[1, 0]> : tensor<2xi32>} : () -> tensor<2xi32>
+  %1 = "tosa.transpose"(%0, %perms) : (tensor<2x3xi8>, tensor<2xi32>) -> tensor<3x2xi8>
+  return %0, %1 : tensor<2x3xi8>, tensor<3x2xi8>
+}
+
+// -----
+
+// CHECK-LABEL: func @transpose_of_transpose
+// CHECK-SAME: %[[ARG0:.+]]: tensor<1x2x3xf32>
+func @transpose_of_transpose(%arg0: tensor<1x2x3xf32>) -> tensor<2x3x1xf32> {
+  // CHECK: %[[PERMS:.+]] = "tosa.const"() {value = dense<[1, 2, 0]> : tensor<3xi32>}
+  // CHECK: %[[TRANSPOSE:.+]] = "tosa.transpose"(%[[ARG0]], %[[PERMS]])
+  // CHECK-NOT: tosa.transpose
+  %perms0 = "tosa.const"() {value = dense<[2, 0, 1]> : tensor<3xi32>} : () -> tensor<3xi32>
+  %0 = "tosa.transpose"(%arg0, %perms0) : (tensor<1x2x3xf32>, tensor<3xi32>) -> tensor<3x1x2xf32>
+  %perms1 = "tosa.const"() {value = dense<[2, 0, 1]> : tensor<3xi32>} : () -> tensor<3xi32>
+  %1 = "tosa.transpose"(%0, %perms1) : (tensor<3x1x2xf32>, tensor<3xi32>) -> tensor<2x3x1xf32>
+  // CHECK: return %[[TRANSPOSE]]
+  return %1 : tensor<2x3x1xf32>
+}
+
+// -----
+
+// CHECK-LABEL: func @identity_transpose
+// CHECK-SAME: %[[ARG0:.+]]: tensor<2x3xf32>
+func @identity_transpose(%arg0: tensor<2x3xf32>) -> tensor<2x3xf32> {
+  // CHECK-NOT: tosa.transpose
+  %perms = "tosa.const"() {value = dense<[0, 1]> : tensor<2xi32>} : () -> tensor<2xi32>
+  %0 = "tosa.transpose"(%arg0, %perms) : (tensor<2x3xf32>, tensor<2xi32>) -> tensor<2x3xf32>
+  // CHECK: return %[[ARG0]]
+  return %0 : tensor<2x3xf32>
+}
+
+// -----
+
+// CHECK-LABEL: func @clamp_of_clamp
+// CHECK-SAME: %[[ARG0:.+]]: tensor<4xf32>
+func @clamp_of_clamp(%arg0: tensor<4xf32>) -> tensor<4xf32> {
+  // CHECK: %[[CLAMP:.+]] = "tosa.clamp"(%[[ARG0]]) {max_fp = 6.000000e+00 : f32, max_int = 6 : i64, min_fp = 0.000000e+00 : f32, min_int = 0 : i64}
+  // CHECK-NOT: tosa.clamp
+  %0 = "tosa.clamp"(%arg0) {max_fp = 3.40282347E+38 : f32, max_int = 2147483647 : i64, min_fp = 0.0 : f32, min_int = 0 : i64} : (tensor<4xf32>) -> tensor<4xf32>
+  %1 = "tosa.clamp"(%0) {max_fp = 6.0 : f32, max_int = 6 : i64, min_fp = -3.40282347E+38 : f32, min_int = -2147483648 : i64} : (tensor<4xf32>) -> tensor<4xf32>
+  // CHECK: return %[[CLAMP]]
+  return %1 : tensor<4xf32>
+}
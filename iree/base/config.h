@@ -164,6 +164,21 @@ typedef IREE_DEVICE_SIZE_T iree_device_size_t;
 #define IREE_VM_BACKTRACE_ENABLE 1
 #endif  // !IREE_VM_BACKTRACE_ENABLE
 
+#if !defined(IREE_VM_BYTECODE_JIT_ENABLE)
+// Enables the baseline bytecode JIT on supported architectures.
+// Modules must opt in with IREE_VM_BYTECODE_MODULE_FLAG_JIT when created.
+#define IREE_VM_BYTECODE_JIT_ENABLE 1
+#endif  // !IREE_VM_BYTECODE_JIT_ENABLE
+
+#if !defined(IREE_VM_REF_SINGLE_THREADED)
+// Uses non-atomic reference counting for all iree_vm_ref_t-managed objects.
+// This removes the atomic read-modify-write from every ref retain/release in
+// the interpreter but is only safe when all ref counted objects are used from
+// a single thread (such as a single-threaded context running with inline HAL
+// execution). Debug builds assert if refs are counted from multiple threads.
+#define IREE_VM_REF_SINGLE_THREADED 0
+#endif  // !IREE_VM_REF_SINGLE_THREADED
+
 #if !defined(IREE_VM_EXT_I64_ENABLE)
 // Enables the 64-bit integer instruction extension.
 // Targeted from the compiler with `-iree-vm-target-extension=i64`.
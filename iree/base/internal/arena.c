@@ -15,6 +15,43 @@
 // iree_arena_block_pool_t
 //===----------------------------------------------------------------------===//
 
+#if IREE_SYNCHRONIZATION_DISABLE_UNSAFE
+
+// Only a single thread can use the pool so the first cache is all we need.
+static iree_arena_block_cache_t* iree_arena_block_pool_thread_cache(
+    iree_arena_block_pool_t* block_pool) {
+  return &block_pool->caches[0];
+}
+
+#else
+
+#if defined(IREE_COMPILER_MSVC)
+#define IREE_ARENA_THREAD_LOCAL __declspec(thread)
+#else
+#define IREE_ARENA_THREAD_LOCAL _Thread_local
+#endif  // IREE_COMPILER_MSVC
+
+// Next cache index handed out to a thread the first time it uses a pool.
+static iree_atomic_int32_t iree_arena_next_thread_cache_index =
+    IREE_ATOMIC_VAR_INIT(0);
+
+// Returns the cache in |block_pool| assigned to the calling thread.
+// The same index is used for all pools so that a thread that is the sole user
+// of its cache in one pool is likely to be in all of them.
+static iree_arena_block_cache_t* iree_arena_block_pool_thread_cache(
+    iree_arena_block_pool_t* block_pool) {
+  // 0 indicates unassigned; assigned indices are stored biased by 1.
+  static IREE_ARENA_THREAD_LOCAL uint32_t thread_cache_index = 0;
+  if (IREE_UNLIKELY(thread_cache_index == 0)) {
+    uint32_t index = (uint32_t)iree_atomic_fetch_add_int32(
+        &iree_arena_next_thread_cache_index, 1, iree_memory_order_relaxed);
+    thread_cache_index = 1 + index % IREE_ARENA_BLOCK_POOL_CACHE_COUNT;
+  }
+  return &block_pool->caches[thread_cache_index - 1];
+}
+
+#endif  // IREE_SYNCHRONIZATION_DISABLE_UNSAFE
+
 void iree_arena_block_pool_initialize(iree_host_size_t total_block_size,
                                       iree_allocator_t block_allocator,
                                       iree_arena_block_pool_t* out_block_pool) {
@@ -24,20 +61,23 @@ void iree_arena_block_pool_initialize(iree_host_size_t total_block_size,
       total_block_size - sizeof(iree_arena_block_t);
   out_block_pool->block_allocator = block_allocator;
   iree_atomic_arena_block_slist_initialize(&out_block_pool->available_slist);
+  for (iree_host_size_t i = 0; i < IREE_ARENA_BLOCK_POOL_CACHE_COUNT; ++i) {
+    iree_slim_mutex_initialize(&out_block_pool->caches[i].mutex);
+  }
 }
 
 void iree_arena_block_pool_deinitialize(iree_arena_block_pool_t* block_pool) {
   // Since all blocks must have been released we can just reuse trim (today) as
   // it doesn't retain any blocks.
   iree_arena_block_pool_trim(block_pool);
+  for (iree_host_size_t i = 0; i < IREE_ARENA_BLOCK_POOL_CACHE_COUNT; ++i) {
+    iree_slim_mutex_deinitialize(&block_pool->caches[i].mutex);
+  }
   iree_atomic_arena_block_slist_deinitialize(&block_pool->available_slist);
 }
 
-void iree_arena_block_pool_trim(iree_arena_block_pool_t* block_pool) {
-  iree_arena_block_t* head = NULL;
-  iree_atomic_arena_block_slist_flush(
-      &block_pool->available_slist,
-      IREE_ATOMIC_SLIST_FLUSH_ORDER_APPROXIMATE_LIFO, &head, NULL);
+static void iree_arena_block_pool_free_blocks(
+    iree_arena_block_pool_t* block_pool, iree_arena_block_t* head) {
   while (head) {
     void* ptr = (uint8_t*)head - block_pool->usable_block_size;
     head = head->next;
@@ -45,12 +85,45 @@ void iree_arena_block_pool_trim(iree_arena_block_pool_t* block_pool) {
   }
 }
 
+void iree_arena_block_pool_trim(iree_arena_block_pool_t* block_pool) {
+  for (iree_host_size_t i = 0; i < IREE_ARENA_BLOCK_POOL_CACHE_COUNT; ++i) {
+    iree_arena_block_cache_t* cache = &block_pool->caches[i];
+    iree_slim_mutex_lock(&cache->mutex);
+    iree_arena_block_t* head = cache->head;
+    cache->head = NULL;
+    cache->count = 0;
+    iree_slim_mutex_unlock(&cache->mutex);
+    iree_arena_block_pool_free_blocks(block_pool, head);
+  }
+
+  iree_arena_block_t* head = NULL;
+  iree_atomic_arena_block_slist_flush(
+      &block_pool->available_slist,
+      IREE_ATOMIC_SLIST_FLUSH_ORDER_APPROXIMATE_LIFO, &head, NULL);
+  iree_arena_block_pool_free_blocks(block_pool, head);
+}
+
 iree_status_t iree_arena_block_pool_acquire(iree_arena_block_pool_t* block_pool,
                                             iree_arena_block_t** out_block) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  iree_arena_block_t* block =
-      iree_atomic_arena_block_slist_pop(&block_pool->available_slist);
+  // Try the calling thread's cache first. If another thread sharing the cache
+  // holds it we skip it instead of waiting.
+  iree_arena_block_t* block = NULL;
+  iree_arena_block_cache_t* cache =
+      iree_arena_block_pool_thread_cache(block_pool);
+  if (iree_slim_mutex_try_lock(&cache->mutex)) {
+    block = cache->head;
+    if (block) {
+      cache->head = block->next;
+      --cache->count;
+    }
+    iree_slim_mutex_unlock(&cache->mutex);
+  }
+
+  if (!block) {
+    block = iree_atomic_arena_block_slist_pop(&block_pool->available_slist);
+  }
 
   if (!block) {
     // No blocks available; allocate one now.
@@ -79,8 +152,28 @@ void iree_arena_block_pool_release(iree_arena_block_pool_t* block_pool,
                                    iree_arena_block_t* block_head,
                                    iree_arena_block_t* block_tail) {
   IREE_TRACE_ZONE_BEGIN(z0);
-  iree_atomic_arena_block_slist_concat(&block_pool->available_slist, block_head,
-                                       block_tail);
+
+  // Move as many blocks as fit into the calling thread's cache. Only the blocks
+  // moved are walked and the remainder of the span is returned to the shared
+  // list in one concat.
+  iree_arena_block_cache_t* cache =
+      iree_arena_block_pool_thread_cache(block_pool);
+  if (iree_slim_mutex_try_lock(&cache->mutex)) {
+    while (block_head && cache->count < IREE_ARENA_BLOCK_POOL_CACHE_CAPACITY) {
+      iree_arena_block_t* block = block_head;
+      block_head = block->next;
+      block->next = cache->head;
+      cache->head = block;
+      ++cache->count;
+    }
+    iree_slim_mutex_unlock(&cache->mutex);
+  }
+
+  if (block_head) {
+    iree_atomic_arena_block_slist_concat(&block_pool->available_slist,
+                                         block_head, block_tail);
+  }
+
   IREE_TRACE_ZONE_END(z0);
 }
 
@@ -11,6 +11,7 @@
 
 #include "iree/base/api.h"
 #include "iree/base/internal/atomic_slist.h"
+#include "iree/base/internal/synchronization.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -34,6 +35,32 @@ typedef struct iree_arena_block_t {
 IREE_TYPED_ATOMIC_SLIST_WRAPPER(iree_atomic_arena_block, iree_arena_block_t,
                                 offsetof(iree_arena_block_t, next));
 
+// Number of per-thread block caches in each iree_arena_block_pool_t.
+// Threads are assigned caches round-robin the first time they use any pool and
+// only share a cache once there are more threads than caches.
+#if !defined(IREE_ARENA_BLOCK_POOL_CACHE_COUNT)
+#define IREE_ARENA_BLOCK_POOL_CACHE_COUNT 16
+#endif  // !IREE_ARENA_BLOCK_POOL_CACHE_COUNT
+
+// Maximum number of free blocks retained in each per-thread block cache before
+// they spill to the shared pool. 0 disables the caches.
+#if !defined(IREE_ARENA_BLOCK_POOL_CACHE_CAPACITY)
+#define IREE_ARENA_BLOCK_POOL_CACHE_CAPACITY 8
+#endif  // !IREE_ARENA_BLOCK_POOL_CACHE_CAPACITY
+
+// A small cache of free blocks used by the threads assigned to it.
+// Padded to avoid sharing cache lines with the caches of other threads.
+typedef struct iree_arena_block_cache_t {
+  // Guards the cache; only ever try-locked so that a thread never waits on
+  // another thread that happens to share its cache.
+  iree_slim_mutex_t mutex;
+  // Linked list of free blocks (LIFO).
+  iree_arena_block_t* head;
+  // Total number of blocks in the head list.
+  iree_host_size_t count;
+  uint8_t reserved[iree_hardware_destructive_interference_size];
+} iree_arena_block_cache_t;
+
 // A simple atomic fixed-size block pool.
 // Blocks are allocated from the system as required and kept in the pool to
 // satisfy future requests. Blocks are all of a uniform size specified when the
@@ -41,6 +68,12 @@ IREE_TYPED_ATOMIC_SLIST_WRAPPER(iree_atomic_arena_block, iree_arena_block_t,
 // blocks so that the underlying allocator is more likely to bucket them
 // appropriately.
 //
+// Free blocks are first kept in small per-thread caches such that threads
+// repeatedly acquiring and releasing blocks (such as when recording and
+// resetting command buffers or issuing queue submissions) don't bounce the
+// shared list between cores. Blocks released in excess of a cache's capacity
+// are returned to the shared list in a single operation.
+//
 // Thread-safe; multiple threads may acquire and release blocks from the pool.
 // The underlying allocator must also be thread-safe.
 typedef struct iree_arena_block_pool_t {
@@ -53,6 +86,8 @@ typedef struct iree_arena_block_pool_t {
   iree_allocator_t block_allocator;
   // Linked list of free blocks (LIFO).
   iree_atomic_arena_block_slist_t available_slist;
+  // Per-thread caches of free blocks checked before available_slist.
+  iree_arena_block_cache_t caches[IREE_ARENA_BLOCK_POOL_CACHE_COUNT];
 } iree_arena_block_pool_t;
 
 // Initializes a new block pool in |out_block_pool|.
@@ -69,6 +104,7 @@ void iree_arena_block_pool_initialize(iree_host_size_t total_block_size,
 void iree_arena_block_pool_deinitialize(iree_arena_block_pool_t* block_pool);
 
 // Trims the pool by freeing unused blocks back to the allocator.
+// Blocks in the per-thread caches are freed as well.
 // Acquired blocks are not freed and remain valid.
 void iree_arena_block_pool_trim(iree_arena_block_pool_t* block_pool);
 
@@ -81,6 +117,8 @@ iree_status_t iree_arena_block_pool_acquire(iree_arena_block_pool_t* block_pool,
 // Releases one or more blocks back to the block pool.
 // Any blocks chained in |block_head| will also be released allowing for
 // low-overhead resets when the blocks are already tracked in linked lists.
+// Blocks fill the calling thread's cache first and any remaining are returned
+// to the shared pool together.
 void iree_arena_block_pool_release(iree_arena_block_pool_t* block_pool,
                                    iree_arena_block_t* block_head,
                                    iree_arena_block_t* block_tail);
@@ -0,0 +1,189 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/base/internal/arena.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+constexpr iree_host_size_t kBlockSize = 256;
+
+// Host allocator wrapping the system allocator that counts the allocations
+// made and the allocations live.
+struct CountingAllocator {
+  std::atomic<int> allocation_count{0};
+  std::atomic<int> live_count{0};
+
+  iree_allocator_t allocator() { return {this, Ctl}; }
+
+  static iree_status_t IREE_API_PTR Ctl(void* self,
+                                        iree_allocator_command_t command,
+                                        const void* params, void** inout_ptr) {
+    CountingAllocator* counter = reinterpret_cast<CountingAllocator*>(self);
+    bool is_new = command != IREE_ALLOCATOR_COMMAND_FREE && !*inout_ptr;
+    bool is_free = command == IREE_ALLOCATOR_COMMAND_FREE && *inout_ptr;
+    IREE_RETURN_IF_ERROR(
+        iree_allocator_system_ctl(NULL, command, params, inout_ptr));
+    if (is_new) {
+      ++counter->allocation_count;
+      ++counter->live_count;
+    } else if (is_free) {
+      --counter->live_count;
+    }
+    return iree_ok_status();
+  }
+};
+
+class ArenaBlockPoolTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    iree_arena_block_pool_initialize(kBlockSize, allocator_.allocator(),
+                                     &block_pool_);
+  }
+
+  void TearDown() override {
+    iree_arena_block_pool_deinitialize(&block_pool_);
+    EXPECT_EQ(0, allocator_.live_count.load());
+  }
+
+  // Acquires |count| blocks and returns them chained in acquisition order.
+  std::vector<iree_arena_block_t*> AcquireBlocks(iree_host_size_t count) {
+    std::vector<iree_arena_block_t*> blocks(count);
+    for (iree_host_size_t i = 0; i < count; ++i) {
+      IREE_CHECK_OK(iree_arena_block_pool_acquire(&block_pool_, &blocks[i]));
+      if (i > 0) blocks[i - 1]->next = blocks[i];
+    }
+    return blocks;
+  }
+
+  // Returns the usable memory of |block|, which precedes the block header.
+  uint8_t* BlockData(iree_arena_block_t* block) {
+    return (uint8_t*)block - block_pool_.usable_block_size;
+  }
+
+  void ReleaseBlocks(const std::vector<iree_arena_block_t*>& blocks) {
+    iree_arena_block_pool_release(&block_pool_, blocks.front(), blocks.back());
+  }
+
+  // Returns the total number of blocks held in the per-thread caches.
+  iree_host_size_t CachedBlockCount() {
+    iree_host_size_t count = 0;
+    for (iree_host_size_t i = 0; i < IREE_ARENA_BLOCK_POOL_CACHE_COUNT; ++i) {
+      count += block_pool_.caches[i].count;
+    }
+    return count;
+  }
+
+  CountingAllocator allocator_;
+  iree_arena_block_pool_t block_pool_;
+};
+
+// A block released by a thread is handed back to the same thread without
+// touching the shared list.
+TEST_F(ArenaBlockPoolTest, ReusesCachedBlock) {
+  iree_arena_block_t* block = NULL;
+  IREE_ASSERT_OK(iree_arena_block_pool_acquire(&block_pool_, &block));
+  iree_arena_block_pool_release(&block_pool_, block, block);
+  EXPECT_EQ(1u, CachedBlockCount());
+  EXPECT_EQ(NULL, iree_atomic_arena_block_slist_pop(
+                      &block_pool_.available_slist));
+
+  iree_arena_block_t* reused_block = NULL;
+  IREE_ASSERT_OK(iree_arena_block_pool_acquire(&block_pool_, &reused_block));
+  EXPECT_EQ(block, reused_block);
+  EXPECT_EQ(0u, CachedBlockCount());
+  EXPECT_EQ(1, allocator_.allocation_count.load());
+  iree_arena_block_pool_release(&block_pool_, reused_block, reused_block);
+}
+
+// Blocks released beyond the capacity of the cache spill to the shared list
+// and are reused from there.
+TEST_F(ArenaBlockPoolTest, SpillsToSharedList) {
+  constexpr iree_host_size_t kSpillCount = 4;
+  constexpr iree_host_size_t kCount =
+      IREE_ARENA_BLOCK_POOL_CACHE_CAPACITY + kSpillCount;
+  ReleaseBlocks(AcquireBlocks(kCount));
+  EXPECT_EQ(IREE_ARENA_BLOCK_POOL_CACHE_CAPACITY, CachedBlockCount());
+
+  // Reacquiring the same number of blocks uses the cached and spilled blocks
+  // without allocating any more.
+  std::vector<iree_arena_block_t*> blocks = AcquireBlocks(kCount);
+  EXPECT_EQ(0u, CachedBlockCount());
+  EXPECT_EQ(NULL, iree_atomic_arena_block_slist_pop(
+                      &block_pool_.available_slist));
+  EXPECT_EQ(kCount, allocator_.allocation_count.load());
+  ReleaseBlocks(blocks);
+}
+
+// Blocks spilled by one thread are available to others.
+TEST_F(ArenaBlockPoolTest, SharesSpilledBlocksAcrossThreads) {
+  constexpr iree_host_size_t kSpillCount = 4;
+  constexpr iree_host_size_t kCount =
+      IREE_ARENA_BLOCK_POOL_CACHE_CAPACITY + kSpillCount;
+  ReleaseBlocks(AcquireBlocks(kCount));
+
+  std::thread thread([&]() {
+    // Threads not sharing the cache of the main thread are satisfied by the
+    // spilled blocks.
+    std::vector<iree_arena_block_t*> blocks = AcquireBlocks(kSpillCount);
+    EXPECT_EQ(kCount, allocator_.allocation_count.load());
+    ReleaseBlocks(blocks);
+  });
+  thread.join();
+}
+
+// Trimming frees the blocks in the caches as well as the shared list.
+TEST_F(ArenaBlockPoolTest, TrimFreesCachedBlocks) {
+  ReleaseBlocks(AcquireBlocks(IREE_ARENA_BLOCK_POOL_CACHE_CAPACITY + 4));
+  EXPECT_NE(0, allocator_.live_count.load());
+  iree_arena_block_pool_trim(&block_pool_);
+  EXPECT_EQ(0u, CachedBlockCount());
+  EXPECT_EQ(0, allocator_.live_count.load());
+}
+
+// Blocks are never handed out to more than one thread at a time.
+TEST_F(ArenaBlockPoolTest, ConcurrentAcquireRelease) {
+  constexpr int kThreadCount = IREE_ARENA_BLOCK_POOL_CACHE_COUNT * 2;
+  constexpr int kIterationCount = 1000;
+  std::atomic<int> conflict_count{0};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreadCount; ++i) {
+    threads.emplace_back([&, i]() {
+      for (int j = 0; j < kIterationCount; ++j) {
+        // Vary the span length so that both the caches and shared list are
+        // exercised.
+        std::vector<iree_arena_block_t*> blocks = AcquireBlocks(1 + j % 12);
+        for (iree_arena_block_t* block : blocks) {
+          memset(BlockData(block), i, block_pool_.usable_block_size);
+        }
+        std::this_thread::yield();
+        for (iree_arena_block_t* block : blocks) {
+          uint8_t* ptr = BlockData(block);
+          for (iree_host_size_t k = 0; k < block_pool_.usable_block_size;
+               ++k) {
+            if (ptr[k] != (uint8_t)i) {
+              ++conflict_count;
+              break;
+            }
+          }
+        }
+        ReleaseBlocks(blocks);
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  EXPECT_EQ(0, conflict_count.load());
+}
+
+}  // namespace
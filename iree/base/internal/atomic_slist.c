@@ -10,9 +10,97 @@
 
 #include "iree/base/attributes.h"
 
-// TODO(benvanik): add TSAN annotations when switched to atomics:
-// https://github.com/gcc-mirror/gcc/blob/master/libsanitizer/include/sanitizer/tsan_interface_atomic.h
-// https://reviews.llvm.org/D18500
+#if IREE_ATOMIC_SLIST_LOCK_FREE
+
+//===----------------------------------------------------------------------===//
+// Lock-free producers with serialized consumers
+//===----------------------------------------------------------------------===//
+
+void iree_atomic_slist_initialize(iree_atomic_slist_t* out_list) {
+  memset(out_list, 0, sizeof(*out_list));
+  iree_slim_mutex_initialize(&out_list->consumer_mutex);
+  iree_atomic_store_intptr(&out_list->head, 0, iree_memory_order_relaxed);
+}
+
+void iree_atomic_slist_deinitialize(iree_atomic_slist_t* list) {
+  // TODO(benvanik): assert empty.
+  iree_slim_mutex_deinitialize(&list->consumer_mutex);
+  memset(list, 0, sizeof(*list));
+}
+
+void iree_atomic_slist_concat(iree_atomic_slist_t* list,
+                              iree_atomic_slist_entry_t* head,
+                              iree_atomic_slist_entry_t* tail) {
+  if (IREE_UNLIKELY(!head)) return;
+  // The span is unpublished until the swap succeeds and we can freely rewrite
+  // the tail next pointer each time we lose a race with another producer.
+  intptr_t current = iree_atomic_load_intptr(&list->head,
+                                             iree_memory_order_relaxed);
+  do {
+    tail->next = (iree_atomic_slist_entry_t*)current;
+  } while (!iree_atomic_compare_exchange_weak_intptr(
+      &list->head, &current, (intptr_t)head, iree_memory_order_release,
+      iree_memory_order_relaxed));
+}
+
+void iree_atomic_slist_push(iree_atomic_slist_t* list,
+                            iree_atomic_slist_entry_t* entry) {
+  iree_atomic_slist_concat(list, entry, entry);
+}
+
+void iree_atomic_slist_push_unsafe(iree_atomic_slist_t* list,
+                                   iree_atomic_slist_entry_t* entry) {
+  entry->next = (iree_atomic_slist_entry_t*)iree_atomic_load_intptr(
+      &list->head, iree_memory_order_relaxed);
+  iree_atomic_store_intptr(&list->head, (intptr_t)entry,
+                           iree_memory_order_relaxed);
+}
+
+iree_atomic_slist_entry_t* iree_atomic_slist_pop(iree_atomic_slist_t* list) {
+  // Skip the consumer lock when there's nothing to pop.
+  if (!iree_atomic_load_intptr(&list->head, iree_memory_order_relaxed)) {
+    return NULL;
+  }
+
+  // Producers may still push while we hold the lock but as no other consumer
+  // can remove |entry| its next pointer remains valid until we swap it out.
+  iree_slim_mutex_lock(&list->consumer_mutex);
+  intptr_t current = iree_atomic_load_intptr(&list->head,
+                                             iree_memory_order_acquire);
+  iree_atomic_slist_entry_t* entry = NULL;
+  do {
+    entry = (iree_atomic_slist_entry_t*)current;
+    if (!entry) break;
+  } while (!iree_atomic_compare_exchange_weak_intptr(
+      &list->head, &current, (intptr_t)entry->next, iree_memory_order_acquire,
+      iree_memory_order_acquire));
+  iree_slim_mutex_unlock(&list->consumer_mutex);
+
+  if (entry) entry->next = NULL;
+  return entry;
+}
+
+// Steals the entire contents of the list in native LIFO order.
+static iree_atomic_slist_entry_t* iree_atomic_slist_steal(
+    iree_atomic_slist_t* list) {
+  if (!iree_atomic_load_intptr(&list->head, iree_memory_order_relaxed)) {
+    return NULL;
+  }
+  // A concurrent pop must not have its head entry removed out from under it so
+  // flushes are serialized with pops even though the exchange is atomic.
+  iree_slim_mutex_lock(&list->consumer_mutex);
+  iree_atomic_slist_entry_t* head =
+      (iree_atomic_slist_entry_t*)iree_atomic_exchange_intptr(
+          &list->head, 0, iree_memory_order_acquire);
+  iree_slim_mutex_unlock(&list->consumer_mutex);
+  return head;
+}
+
+#else
+
+//===----------------------------------------------------------------------===//
+// Mutex-guarded fallback
+//===----------------------------------------------------------------------===//
 
 void iree_atomic_slist_initialize(iree_atomic_slist_t* out_list) {
   memset(out_list, 0, sizeof(*out_list));
@@ -61,16 +149,29 @@ iree_atomic_slist_entry_t* iree_atomic_slist_pop(iree_atomic_slist_t* list) {
   return entry;
 }
 
+// Steals the entire contents of the list in native LIFO order.
+static iree_atomic_slist_entry_t* iree_atomic_slist_steal(
+    iree_atomic_slist_t* list) {
+  iree_slim_mutex_lock(&list->mutex);
+  iree_atomic_slist_entry_t* head = list->head;
+  list->head = NULL;
+  iree_slim_mutex_unlock(&list->mutex);
+  return head;
+}
+
+#endif  // IREE_ATOMIC_SLIST_LOCK_FREE
+
+//===----------------------------------------------------------------------===//
+// Common
+//===----------------------------------------------------------------------===//
+
 bool iree_atomic_slist_flush(iree_atomic_slist_t* list,
                              iree_atomic_slist_flush_order_t flush_order,
                              iree_atomic_slist_entry_t** out_head,
                              iree_atomic_slist_entry_t** out_tail) {
   // Exchange list head with NULL to steal the entire list. The list will be in
   // the native LIFO order of the slist.
-  iree_slim_mutex_lock(&list->mutex);
-  iree_atomic_slist_entry_t* head = list->head;
-  list->head = NULL;
-  iree_slim_mutex_unlock(&list->mutex);
+  iree_atomic_slist_entry_t* head = iree_atomic_slist_steal(list);
   if (!head) return false;
 
   switch (flush_order) {
@@ -109,3 +210,63 @@ bool iree_atomic_slist_flush(iree_atomic_slist_t* list,
 
   return true;
 }
+
+//===----------------------------------------------------------------------===//
+// iree_atomic_sharded_slist_t
+//===----------------------------------------------------------------------===//
+
+void iree_atomic_sharded_slist_initialize(
+    iree_atomic_sharded_slist_t* out_list) {
+  for (iree_host_size_t i = 0; i < IREE_ATOMIC_SLIST_SHARD_COUNT; ++i) {
+    iree_atomic_slist_initialize(&out_list->shards[i].list);
+  }
+}
+
+void iree_atomic_sharded_slist_deinitialize(iree_atomic_sharded_slist_t* list) {
+  for (iree_host_size_t i = 0; i < IREE_ATOMIC_SLIST_SHARD_COUNT; ++i) {
+    iree_atomic_slist_deinitialize(&list->shards[i].list);
+  }
+}
+
+void iree_atomic_sharded_slist_concat(iree_atomic_sharded_slist_t* list,
+                                      iree_host_size_t shard_hint,
+                                      iree_atomic_slist_entry_t* head,
+                                      iree_atomic_slist_entry_t* tail) {
+  iree_host_size_t shard_index = shard_hint % IREE_ATOMIC_SLIST_SHARD_COUNT;
+  iree_atomic_slist_concat(&list->shards[shard_index].list, head, tail);
+}
+
+void iree_atomic_sharded_slist_push(iree_atomic_sharded_slist_t* list,
+                                    iree_host_size_t shard_hint,
+                                    iree_atomic_slist_entry_t* entry) {
+  iree_host_size_t shard_index = shard_hint % IREE_ATOMIC_SLIST_SHARD_COUNT;
+  iree_atomic_slist_push(&list->shards[shard_index].list, entry);
+}
+
+bool iree_atomic_sharded_slist_flush(
+    iree_atomic_sharded_slist_t* list,
+    iree_atomic_slist_flush_order_t flush_order,
+    iree_atomic_slist_entry_t** out_head,
+    iree_atomic_slist_entry_t** out_tail) {
+  // Each shard span needs its tail in order to link the next one on.
+  iree_atomic_slist_entry_t* head = NULL;
+  iree_atomic_slist_entry_t* tail = NULL;
+  for (iree_host_size_t i = 0; i < IREE_ATOMIC_SLIST_SHARD_COUNT; ++i) {
+    iree_atomic_slist_entry_t* shard_head = NULL;
+    iree_atomic_slist_entry_t* shard_tail = NULL;
+    if (!iree_atomic_slist_flush(&list->shards[i].list, flush_order,
+                                 &shard_head, &shard_tail)) {
+      continue;
+    }
+    if (tail) {
+      tail->next = shard_head;
+    } else {
+      head = shard_head;
+    }
+    tail = shard_tail;
+  }
+  if (!head) return false;
+  *out_head = head;
+  if (out_tail) *out_tail = tail;
+  return true;
+}
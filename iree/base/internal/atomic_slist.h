@@ -23,6 +23,18 @@
 extern "C" {
 #endif
 
+// Selects the lock-free producer implementation of iree_atomic_slist_t.
+// When 0 all list operations are guarded by a mutex.
+#if !defined(IREE_ATOMIC_SLIST_LOCK_FREE)
+#define IREE_ATOMIC_SLIST_LOCK_FREE 1
+#endif  // !IREE_ATOMIC_SLIST_LOCK_FREE
+
+// Number of shards in an iree_atomic_sharded_slist_t.
+// Setting this to 1 makes sharded lists behave as a single list.
+#if !defined(IREE_ATOMIC_SLIST_SHARD_COUNT)
+#define IREE_ATOMIC_SLIST_SHARD_COUNT 8
+#endif  // !IREE_ATOMIC_SLIST_SHARD_COUNT
+
 // The embedded pointer to the next entry in the slist. This points to the
 // internal iree_atomic_slist_entry_t, *not* the user-provided pointer.
 typedef void* iree_atomic_slist_intrusive_ptr_t;
@@ -77,10 +89,28 @@ typedef struct iree_atomic_slist_entry_t {
 // may have better tooling (TSAN), special intrinsic handling in the compiler,
 // etc. That said, the Windows Interlocked* variants don't seem to. Having a
 // single heavily tested implementation seems more worthwhile than several.
+//
+// Implementation:
+// By default (IREE_ATOMIC_SLIST_LOCK_FREE=1) producers (push/concat) are
+// lock-free and only ever compare-and-swap the list head. Consumers (pop/flush)
+// are serialized against each other with a mutex that producers never touch.
+// Because entries can only be removed while holding the consumer lock a pop can
+// never observe an entry that was removed and then reinserted between reading
+// the head and swapping it out (the ABA problem) and so the head does not need
+// a generation tag or a double-width compare-and-swap. Consumers check for an
+// empty list before acquiring the lock such that polling empty lists is free.
+// Defining IREE_ATOMIC_SLIST_LOCK_FREE=0 falls back to guarding all operations
+// with a single mutex.
 typedef iree_alignas(iree_max_align_t) struct {
-  // TODO(benvanik): spend some time golfing this. Unblocking myself for now :)
+#if IREE_ATOMIC_SLIST_LOCK_FREE
+  // Serializes pop/flush; never acquired by producers.
+  iree_slim_mutex_t consumer_mutex;
+  // iree_atomic_slist_entry_t* of the most recently pushed entry.
+  iree_atomic_intptr_t head;
+#else
   iree_slim_mutex_t mutex;
   iree_atomic_slist_entry_t* head;
+#endif  // IREE_ATOMIC_SLIST_LOCK_FREE
 } iree_atomic_slist_t;
 
 // Initializes an slist handle to an empty list.
@@ -166,6 +196,68 @@ bool iree_atomic_slist_flush(iree_atomic_slist_t* list,
                              iree_atomic_slist_entry_t** out_head,
                              iree_atomic_slist_entry_t** out_tail);
 
+//==============================================================================
+// iree_atomic_sharded_slist_t
+//==============================================================================
+
+// An slist sharded across IREE_ATOMIC_SLIST_SHARD_COUNT independent lists.
+// Producers select a shard with a hint (such as their worker index) such that
+// many producers pushing concurrently spread out across several list heads
+// instead of all contending on a single one. Consumers flush all shards at once
+// and receive a single span of entries.
+//
+// Order guarantees are even weaker than iree_atomic_slist_t: entries are
+// approximately ordered within a shard but there is no order between entries
+// pushed to different shards. Only use this for lists that are bulk-flushed
+// and where many producers are expected (like the executor incoming lists).
+//
+// Shards are aligned such that their heads never share a cache line and
+// producers on one shard do not slow down those on another.
+typedef struct {
+  iree_alignas(iree_hardware_destructive_interference_size)
+      iree_atomic_slist_t list;
+} iree_atomic_slist_shard_t;
+
+typedef struct {
+  iree_atomic_slist_shard_t shards[IREE_ATOMIC_SLIST_SHARD_COUNT];
+} iree_atomic_sharded_slist_t;
+
+// Initializes a sharded slist handle to an empty list.
+// Lists must be flushed to empty and deinitialized when no longer needed with
+// iree_atomic_sharded_slist_deinitialize.
+//
+// NOTE: not thread-safe; existing |out_list| contents are discarded.
+void iree_atomic_sharded_slist_initialize(
+    iree_atomic_sharded_slist_t* out_list);
+
+// Deinitializes a sharded slist. All shards must be empty.
+//
+// NOTE: not thread-safe; |list| must not be used by any other thread.
+void iree_atomic_sharded_slist_deinitialize(iree_atomic_sharded_slist_t* list);
+
+// Concatenates a span of entries into the shard selected by |shard_hint|.
+// See iree_atomic_slist_concat.
+void iree_atomic_sharded_slist_concat(iree_atomic_sharded_slist_t* list,
+                                      iree_host_size_t shard_hint,
+                                      iree_atomic_slist_entry_t* head,
+                                      iree_atomic_slist_entry_t* tail);
+
+// Pushes an entry into the shard selected by |shard_hint|.
+// See iree_atomic_slist_push.
+void iree_atomic_sharded_slist_push(iree_atomic_sharded_slist_t* list,
+                                    iree_host_size_t shard_hint,
+                                    iree_atomic_slist_entry_t* entry);
+
+// Removes all items from all shards and returns them as a single span.
+// Each shard is flushed in |flush_order| and the shards are then joined in
+// shard order. See iree_atomic_slist_flush.
+//
+// Returns true if any items were present and false if the output list is empty.
+bool iree_atomic_sharded_slist_flush(
+    iree_atomic_sharded_slist_t* list,
+    iree_atomic_slist_flush_order_t flush_order,
+    iree_atomic_slist_entry_t** out_head, iree_atomic_slist_entry_t** out_tail);
+
 //==============================================================================
 // Typed wrapper generator for iree_atomic_slist_t
 //==============================================================================
@@ -248,6 +340,48 @@ bool iree_atomic_slist_flush(iree_atomic_slist_t* list,
     *out_head = name##_slist_entry_to_ptr(head);                               \
     if (out_tail) *out_tail = name##_slist_entry_to_ptr(tail);                 \
     return true;                                                               \
+  }                                                                            \
+                                                                               \
+  typedef struct {                                                             \
+    iree_atomic_sharded_slist_t impl;                                          \
+  } name##_sharded_slist_t;                                                    \
+                                                                               \
+  static inline void name##_sharded_slist_initialize(                          \
+      name##_sharded_slist_t* out_list) {                                      \
+    iree_atomic_sharded_slist_initialize(&out_list->impl);                     \
+  }                                                                            \
+  static inline void name##_sharded_slist_deinitialize(                        \
+      name##_sharded_slist_t* list) {                                          \
+    iree_atomic_sharded_slist_deinitialize(&list->impl);                       \
+  }                                                                            \
+                                                                               \
+  static inline void name##_sharded_slist_push(                                \
+      name##_sharded_slist_t* list, iree_host_size_t shard_hint,               \
+      type* entry) {                                                           \
+    iree_atomic_sharded_slist_push(&list->impl, shard_hint,                    \
+                                   name##_slist_entry_from_ptr(entry));        \
+  }                                                                            \
+  static inline void name##_sharded_slist_concat(                              \
+      name##_sharded_slist_t* list, iree_host_size_t shard_hint, type* head,   \
+      type* tail) {                                                            \
+    iree_atomic_sharded_slist_concat(&list->impl, shard_hint,                  \
+                                     name##_slist_entry_from_ptr(head),        \
+                                     name##_slist_entry_from_ptr(tail));       \
+  }                                                                            \
+                                                                               \
+  static inline bool name##_sharded_slist_flush(                               \
+      name##_sharded_slist_t* list,                                            \
+      iree_atomic_slist_flush_order_t flush_order, type** out_head,            \
+      type** out_tail) {                                                       \
+    iree_atomic_slist_entry_t* head = NULL;                                    \
+    iree_atomic_slist_entry_t* tail = NULL;                                    \
+    if (!iree_atomic_sharded_slist_flush(&list->impl, flush_order, &head,      \
+                                         out_tail ? &tail : NULL)) {           \
+      return false; /* empty list */                                           \
+    }                                                                          \
+    *out_head = name##_slist_entry_to_ptr(head);                               \
+    if (out_tail) *out_tail = name##_slist_entry_to_ptr(tail);                 \
+    return true;                                                               \
   }
 
 #ifdef __cplusplus
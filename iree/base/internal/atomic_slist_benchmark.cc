@@ -0,0 +1,140 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <cstddef>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "iree/base/internal/atomic_slist.h"
+
+namespace {
+
+struct dummy_entry_t {
+  iree_atomic_slist_intrusive_ptr_t slist_next = NULL;
+  size_t value = 0;
+};
+IREE_TYPED_ATOMIC_SLIST_WRAPPER(dummy, dummy_entry_t,
+                                offsetof(dummy_entry_t, slist_next));
+
+constexpr int kMaxThreads = 64;
+constexpr int kMaxBatchSize = 64;
+
+// Entries are shared by all benchmark threads and flushed entries are taken
+// over by whichever thread flushed them so the storage must outlive every
+// thread. Never freed.
+dummy_entry_t* GetEntryPool() {
+  static dummy_entry_t* pool = new dummy_entry_t[kMaxThreads * kMaxBatchSize];
+  return pool;
+}
+
+dummy_slist_t* GetSharedList() {
+  static dummy_slist_t* list = ([]() -> dummy_slist_t* {
+    auto list = new dummy_slist_t();
+    dummy_slist_initialize(list);
+    return list;
+  })();
+  return list;
+}
+
+// Models the iree/task submission pattern: producers push entries one at a
+// time to a shared list (as with mailboxes and the executor incoming ready
+// list) and a consumer flushes the entire list at once to process in bulk.
+// Every thread alternates between pushing a batch of entries and flushing
+// whatever is in the list and then takes ownership of the flushed entries.
+// The argument is the number of entries each thread pushes per iteration.
+void BM_PushFlush(benchmark::State& state, bool fifo) {
+  const int batch_size = static_cast<int>(state.range(0));
+  dummy_slist_t* list = GetSharedList();
+  if (state.thread_index == 0) {
+    // Drop anything left over from a prior run; all threads are blocked
+    // until the benchmark loop starts.
+    dummy_slist_initialize(list);
+  }
+  std::vector<dummy_entry_t*> owned;
+  owned.reserve(kMaxThreads * kMaxBatchSize);
+  dummy_entry_t* pool =
+      GetEntryPool() + (state.thread_index % kMaxThreads) * kMaxBatchSize;
+  for (int i = 0; i < batch_size; ++i) owned.push_back(&pool[i]);
+
+  const iree_atomic_slist_flush_order_t flush_order =
+      fifo ? IREE_ATOMIC_SLIST_FLUSH_ORDER_APPROXIMATE_FIFO
+           : IREE_ATOMIC_SLIST_FLUSH_ORDER_APPROXIMATE_LIFO;
+  int64_t flushed_count = 0;
+  for (auto _ : state) {
+    for (dummy_entry_t* entry : owned) dummy_slist_push(list, entry);
+    owned.clear();
+    dummy_entry_t* head = NULL;
+    if (dummy_slist_flush(list, flush_order, &head, NULL)) {
+      for (dummy_entry_t* p = head; p != NULL; p = dummy_slist_get_next(p)) {
+        owned.push_back(p);
+      }
+    }
+    flushed_count += static_cast<int64_t>(owned.size());
+  }
+  state.SetItemsProcessed(state.iterations() * batch_size);
+  state.counters["flushed_per_iteration"] =
+      benchmark::Counter(static_cast<double>(flushed_count),
+                         benchmark::Counter::kAvgIterations);
+}
+
+void BM_PushFlushLIFO(benchmark::State& state) {
+  BM_PushFlush(state, /*fifo=*/false);
+}
+BENCHMARK(BM_PushFlushLIFO)
+    ->UseRealTime()
+    ->Arg(1)
+    ->Arg(16)
+    ->Threads(1)
+    ->Threads(2)
+    ->Threads(4)
+    ->Threads(8)
+    ->Threads(16)
+    ->Threads(32)
+    ->Threads(64);
+
+void BM_PushFlushFIFO(benchmark::State& state) {
+  BM_PushFlush(state, /*fifo=*/true);
+}
+BENCHMARK(BM_PushFlushFIFO)
+    ->UseRealTime()
+    ->Arg(1)
+    ->Arg(16)
+    ->Threads(1)
+    ->Threads(2)
+    ->Threads(4)
+    ->Threads(8)
+    ->Threads(16)
+    ->Threads(32)
+    ->Threads(64);
+
+// Pops entries one at a time as workers do when stealing from one another.
+// Each thread pushes a single entry and pops whichever entry is at the head.
+void BM_PushPop(benchmark::State& state) {
+  dummy_slist_t* list = GetSharedList();
+  if (state.thread_index == 0) {
+    dummy_slist_initialize(list);
+  }
+  dummy_entry_t* owned =
+      GetEntryPool() + (state.thread_index % kMaxThreads) * kMaxBatchSize;
+  for (auto _ : state) {
+    dummy_slist_push(list, owned);
+    // Another thread may have taken our entry but there is always at least
+    // one entry in the list as each thread only pops after pushing.
+    owned = dummy_slist_pop(list);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PushPop)
+    ->UseRealTime()
+    ->Threads(1)
+    ->Threads(2)
+    ->Threads(4)
+    ->Threads(8)
+    ->Threads(16)
+    ->Threads(32)
+    ->Threads(64);
+
+}  // namespace
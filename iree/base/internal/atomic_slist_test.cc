@@ -6,6 +6,9 @@
 
 #include "iree/base/internal/atomic_slist.h"
 
+#include <atomic>
+#include <cstdint>
+#include <thread>
 #include <vector>
 
 #include "iree/testing/gtest.h"
@@ -182,4 +185,171 @@ TEST(AtomicSList, FlushFIFO) {
   dummy_slist_deinitialize(&list);
 }
 
+// Producers push or concat entries while consumers concurrently pop and flush
+// them; every entry must come out exactly once.
+TEST(AtomicSList, ConcurrentPushPopFlush) {
+  constexpr size_t kProducerCount = 4;
+  constexpr size_t kConsumerCount = 4;
+  constexpr size_t kEntriesPerProducer = 16 * 1024;
+  constexpr size_t kSpanSize = 4;
+  constexpr size_t kTotalCount = kProducerCount * kEntriesPerProducer;
+  auto item_storage = MakeDummySListItems(0, kTotalCount);
+  std::vector<std::atomic<int>> seen_counts(kTotalCount);
+  for (auto& count : seen_counts) count = 0;
+  std::atomic<int> remaining_count(static_cast<int>(kTotalCount));
+
+  dummy_slist_t list;
+  dummy_slist_initialize(&list);
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kProducerCount; ++i) {
+    threads.emplace_back([&, i]() {
+      dummy_entry_t* base = &item_storage[i * kEntriesPerProducer];
+      for (size_t j = 0; j < kEntriesPerProducer; j += kSpanSize) {
+        if ((j / kSpanSize) % 2) {
+          dummy_slist_push(&list, &base[j]);
+          for (size_t k = 1; k < kSpanSize; ++k) {
+            dummy_slist_push(&list, &base[j + k]);
+          }
+        } else {
+          for (size_t k = 0; k < kSpanSize - 1; ++k) {
+            dummy_slist_set_next(&base[j + k], &base[j + k + 1]);
+          }
+          dummy_slist_concat(&list, &base[j], &base[j + kSpanSize - 1]);
+        }
+      }
+    });
+  }
+  for (size_t i = 0; i < kConsumerCount; ++i) {
+    threads.emplace_back([&, i]() {
+      while (remaining_count.load() > 0) {
+        if (i % 2) {
+          dummy_entry_t* p = dummy_slist_pop(&list);
+          if (!p) continue;
+          ++seen_counts[p->value];
+          --remaining_count;
+        } else {
+          dummy_entry_t* head = NULL;
+          if (!dummy_slist_flush(&list,
+                                 IREE_ATOMIC_SLIST_FLUSH_ORDER_APPROXIMATE_FIFO,
+                                 &head, NULL)) {
+            continue;
+          }
+          for (dummy_entry_t* p = head; p != NULL;) {
+            dummy_entry_t* next = dummy_slist_get_next(p);
+            ++seen_counts[p->value];
+            --remaining_count;
+            p = next;
+          }
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  EXPECT_EQ(NULL, dummy_slist_pop(&list));
+  for (size_t i = 0; i < kTotalCount; ++i) {
+    EXPECT_EQ(1, seen_counts[i].load()) << "entry " << i;
+  }
+
+  dummy_slist_deinitialize(&list);
+}
+
+TEST(AtomicShardedSList, Lifetime) {
+  iree_atomic_sharded_slist_t list;  // NOTE: intentionally uninitialized.
+  iree_atomic_sharded_slist_initialize(&list);
+  iree_atomic_sharded_slist_deinitialize(&list);
+}
+
+TEST(AtomicShardedSList, FlushAcrossShards) {
+  dummy_sharded_slist_t list;
+  dummy_sharded_slist_initialize(&list);
+
+  // Flushing when empty is ok.
+  dummy_entry_t* head = NULL;
+  dummy_entry_t* tail = NULL;
+  EXPECT_FALSE(dummy_sharded_slist_flush(
+      &list, IREE_ATOMIC_SLIST_FLUSH_ORDER_APPROXIMATE_FIFO, &head, &tail));
+
+  // Push items spread across (and wrapping around) all of the shards.
+  constexpr size_t kCount = IREE_ATOMIC_SLIST_SHARD_COUNT * 3 + 1;
+  auto item_storage = MakeDummySListItems(0, kCount);
+  for (size_t i = 0; i < item_storage.size(); ++i) {
+    dummy_sharded_slist_push(&list, /*shard_hint=*/i, &item_storage[i]);
+  }
+
+  // Flush and verify every item is returned once and that each shard kept its
+  // own FIFO order.
+  EXPECT_TRUE(dummy_sharded_slist_flush(
+      &list, IREE_ATOMIC_SLIST_FLUSH_ORDER_APPROXIMATE_FIFO, &head, &tail));
+  std::vector<int> seen_counts(kCount);
+  std::vector<size_t> last_values(IREE_ATOMIC_SLIST_SHARD_COUNT, SIZE_MAX);
+  dummy_entry_t* last = NULL;
+  for (dummy_entry_t* p = head; p != NULL; p = dummy_slist_get_next(p)) {
+    ++seen_counts[p->value];
+    size_t& last_value = last_values[p->value % IREE_ATOMIC_SLIST_SHARD_COUNT];
+    if (last_value != SIZE_MAX) {
+      EXPECT_LT(last_value, p->value);
+    }
+    last_value = p->value;
+    last = p;
+  }
+  EXPECT_EQ(last, tail);
+  for (size_t i = 0; i < kCount; ++i) EXPECT_EQ(1, seen_counts[i]);
+
+  // All shards are now empty.
+  EXPECT_FALSE(dummy_sharded_slist_flush(
+      &list, IREE_ATOMIC_SLIST_FLUSH_ORDER_APPROXIMATE_LIFO, &head, NULL));
+
+  dummy_sharded_slist_deinitialize(&list);
+}
+
+// Many producers push into their own shards while a single consumer flushes
+// (as with the executor incoming lists).
+TEST(AtomicShardedSList, ConcurrentPushFlush) {
+  constexpr size_t kProducerCount = 8;
+  constexpr size_t kEntriesPerProducer = 16 * 1024;
+  constexpr size_t kTotalCount = kProducerCount * kEntriesPerProducer;
+  auto item_storage = MakeDummySListItems(0, kTotalCount);
+  std::vector<int> seen_counts(kTotalCount);
+
+  dummy_sharded_slist_t list;
+  dummy_sharded_slist_initialize(&list);
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kProducerCount; ++i) {
+    threads.emplace_back([&, i]() {
+      dummy_entry_t* base = &item_storage[i * kEntriesPerProducer];
+      for (size_t j = 0; j < kEntriesPerProducer; ++j) {
+        dummy_sharded_slist_push(&list, /*shard_hint=*/i, &base[j]);
+      }
+    });
+  }
+  size_t remaining_count = kTotalCount;
+  while (remaining_count > 0) {
+    dummy_entry_t* head = NULL;
+    dummy_entry_t* tail = NULL;
+    if (!dummy_sharded_slist_flush(
+            &list, IREE_ATOMIC_SLIST_FLUSH_ORDER_APPROXIMATE_LIFO, &head,
+            &tail)) {
+      std::this_thread::yield();
+      continue;
+    }
+    for (dummy_entry_t* p = head; p != NULL; p = dummy_slist_get_next(p)) {
+      ++seen_counts[p->value];
+      --remaining_count;
+      if (!dummy_slist_get_next(p)) {
+        EXPECT_EQ(p, tail);
+      }
+    }
+  }
+  for (auto& thread : threads) thread.join();
+
+  for (size_t i = 0; i < kTotalCount; ++i) {
+    EXPECT_EQ(1, seen_counts[i]) << "entry " << i;
+  }
+
+  dummy_sharded_slist_deinitialize(&list);
+}
+
 }  // namespace
@@ -0,0 +1,312 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/base/internal/cpu.h"
+
+#include "iree/base/internal/call_once.h"
+
+#if defined(IREE_ARCH_X86_64)
+#if defined(IREE_COMPILER_MSVC)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif  // IREE_COMPILER_MSVC
+#endif  // IREE_ARCH_X86_64
+
+#if defined(IREE_ARCH_ARM_64) && \
+    (defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_LINUX))
+#include <sys/auxv.h>
+#endif  // IREE_ARCH_ARM_64 && (IREE_PLATFORM_ANDROID || IREE_PLATFORM_LINUX)
+
+//==============================================================================
+// Feature bits
+//==============================================================================
+
+enum iree_cpu_feature_bits_t {
+  // x86-64:
+  IREE_CPU_FEATURE_X86_SSE3 = 1ull << 0,
+  IREE_CPU_FEATURE_X86_SSSE3 = 1ull << 1,
+  IREE_CPU_FEATURE_X86_SSE4_1 = 1ull << 2,
+  IREE_CPU_FEATURE_X86_SSE4_2 = 1ull << 3,
+  IREE_CPU_FEATURE_X86_POPCNT = 1ull << 4,
+  IREE_CPU_FEATURE_X86_CX16 = 1ull << 5,
+  IREE_CPU_FEATURE_X86_SAHF = 1ull << 6,
+  IREE_CPU_FEATURE_X86_AVX = 1ull << 7,
+  IREE_CPU_FEATURE_X86_AVX2 = 1ull << 8,
+  IREE_CPU_FEATURE_X86_FMA = 1ull << 9,
+  IREE_CPU_FEATURE_X86_F16C = 1ull << 10,
+  IREE_CPU_FEATURE_X86_BMI = 1ull << 11,
+  IREE_CPU_FEATURE_X86_BMI2 = 1ull << 12,
+  IREE_CPU_FEATURE_X86_LZCNT = 1ull << 13,
+  IREE_CPU_FEATURE_X86_MOVBE = 1ull << 14,
+  IREE_CPU_FEATURE_X86_XSAVE = 1ull << 15,
+  IREE_CPU_FEATURE_X86_AVX512F = 1ull << 16,
+  IREE_CPU_FEATURE_X86_AVX512CD = 1ull << 17,
+  IREE_CPU_FEATURE_X86_AVX512BW = 1ull << 18,
+  IREE_CPU_FEATURE_X86_AVX512DQ = 1ull << 19,
+  IREE_CPU_FEATURE_X86_AVX512VL = 1ull << 20,
+  IREE_CPU_FEATURE_X86_AVX512VNNI = 1ull << 21,
+  IREE_CPU_FEATURE_X86_AVX512BF16 = 1ull << 22,
+
+  // AArch64:
+  IREE_CPU_FEATURE_ARM_64_NEON = 1ull << 32,
+  IREE_CPU_FEATURE_ARM_64_FULLFP16 = 1ull << 33,
+  IREE_CPU_FEATURE_ARM_64_DOTPROD = 1ull << 34,
+  IREE_CPU_FEATURE_ARM_64_I8MM = 1ull << 35,
+  IREE_CPU_FEATURE_ARM_64_BF16 = 1ull << 36,
+
+  // Always set on the architecture the runtime is built for.
+  IREE_CPU_FEATURE_BASELINE = 1ull << 63,
+};
+typedef uint64_t iree_cpu_features_t;
+
+// x86-64 microarchitecture levels as defined by the psABI:
+// https://gitlab.com/x86-psABIs/x86-64-ABI
+#define IREE_CPU_FEATURES_X86_64_V2                                  \
+  (IREE_CPU_FEATURE_X86_CX16 | IREE_CPU_FEATURE_X86_SAHF |           \
+   IREE_CPU_FEATURE_X86_POPCNT | IREE_CPU_FEATURE_X86_SSE3 |         \
+   IREE_CPU_FEATURE_X86_SSE4_1 | IREE_CPU_FEATURE_X86_SSE4_2 |       \
+   IREE_CPU_FEATURE_X86_SSSE3)
+#define IREE_CPU_FEATURES_X86_64_V3                                   \
+  (IREE_CPU_FEATURES_X86_64_V2 | IREE_CPU_FEATURE_X86_AVX |           \
+   IREE_CPU_FEATURE_X86_AVX2 | IREE_CPU_FEATURE_X86_BMI |             \
+   IREE_CPU_FEATURE_X86_BMI2 | IREE_CPU_FEATURE_X86_F16C |            \
+   IREE_CPU_FEATURE_X86_FMA | IREE_CPU_FEATURE_X86_LZCNT |            \
+   IREE_CPU_FEATURE_X86_MOVBE | IREE_CPU_FEATURE_X86_XSAVE)
+#define IREE_CPU_FEATURES_X86_64_V4                                    \
+  (IREE_CPU_FEATURES_X86_64_V3 | IREE_CPU_FEATURE_X86_AVX512F |        \
+   IREE_CPU_FEATURE_X86_AVX512BW | IREE_CPU_FEATURE_X86_AVX512CD |     \
+   IREE_CPU_FEATURE_X86_AVX512DQ | IREE_CPU_FEATURE_X86_AVX512VL)
+
+typedef struct iree_cpu_feature_name_t {
+  const char* name;
+  iree_cpu_features_t features;
+} iree_cpu_feature_name_t;
+
+// Names (as used by LLVM) of all features the runtime knows how to query.
+static const iree_cpu_feature_name_t iree_cpu_feature_names[] = {
+#if defined(IREE_ARCH_X86_64)
+    {"x86-64", IREE_CPU_FEATURE_BASELINE},
+    {"x86-64-v2", IREE_CPU_FEATURES_X86_64_V2},
+    {"x86-64-v3", IREE_CPU_FEATURES_X86_64_V3},
+    {"x86-64-v4", IREE_CPU_FEATURES_X86_64_V4},
+    {"sse", IREE_CPU_FEATURE_BASELINE},
+    {"sse2", IREE_CPU_FEATURE_BASELINE},
+    {"sse3", IREE_CPU_FEATURE_X86_SSE3},
+    {"ssse3", IREE_CPU_FEATURE_X86_SSSE3},
+    {"sse4.1", IREE_CPU_FEATURE_X86_SSE4_1},
+    {"sse4.2", IREE_CPU_FEATURE_X86_SSE4_2},
+    {"popcnt", IREE_CPU_FEATURE_X86_POPCNT},
+    {"cx16", IREE_CPU_FEATURE_X86_CX16},
+    {"sahf", IREE_CPU_FEATURE_X86_SAHF},
+    {"avx", IREE_CPU_FEATURE_X86_AVX},
+    {"avx2", IREE_CPU_FEATURE_X86_AVX2},
+    {"fma", IREE_CPU_FEATURE_X86_FMA},
+    {"f16c", IREE_CPU_FEATURE_X86_F16C},
+    {"bmi", IREE_CPU_FEATURE_X86_BMI},
+    {"bmi2", IREE_CPU_FEATURE_X86_BMI2},
+    {"lzcnt", IREE_CPU_FEATURE_X86_LZCNT},
+    {"movbe", IREE_CPU_FEATURE_X86_MOVBE},
+    {"xsave", IREE_CPU_FEATURE_X86_XSAVE},
+    {"avx512f", IREE_CPU_FEATURE_X86_AVX512F},
+    {"avx512cd", IREE_CPU_FEATURE_X86_AVX512CD},
+    {"avx512bw", IREE_CPU_FEATURE_X86_AVX512BW},
+    {"avx512dq", IREE_CPU_FEATURE_X86_AVX512DQ},
+    {"avx512vl", IREE_CPU_FEATURE_X86_AVX512VL},
+    {"avx512vnni", IREE_CPU_FEATURE_X86_AVX512VNNI},
+    {"avx512bf16", IREE_CPU_FEATURE_X86_AVX512BF16},
+#elif defined(IREE_ARCH_ARM_64)
+    {"generic", IREE_CPU_FEATURE_BASELINE},
+    {"neon", IREE_CPU_FEATURE_ARM_64_NEON},
+    {"fullfp16", IREE_CPU_FEATURE_ARM_64_FULLFP16},
+    {"dotprod", IREE_CPU_FEATURE_ARM_64_DOTPROD},
+    {"i8mm", IREE_CPU_FEATURE_ARM_64_I8MM},
+    {"bf16", IREE_CPU_FEATURE_ARM_64_BF16},
+#endif  // IREE_ARCH_*
+};
+
+//==============================================================================
+// Host CPU queries
+//==============================================================================
+
+#if defined(IREE_ARCH_X86_64)
+
+static void iree_cpu_x86_cpuid(uint32_t leaf, uint32_t subleaf,
+                               uint32_t out_regs[4]) {
+#if defined(IREE_COMPILER_MSVC)
+  int regs[4];
+  __cpuidex(regs, (int)leaf, (int)subleaf);
+  for (int i = 0; i < 4; ++i) out_regs[i] = (uint32_t)regs[i];
+#else
+  if (!__get_cpuid_count(leaf, subleaf, &out_regs[0], &out_regs[1],
+                         &out_regs[2], &out_regs[3])) {
+    out_regs[0] = out_regs[1] = out_regs[2] = out_regs[3] = 0;
+  }
+#endif  // IREE_COMPILER_MSVC
+}
+
+// Returns the XCR0 register indicating which register state the OS saves.
+// Must only be called if OSXSAVE is reported by cpuid.
+static uint64_t iree_cpu_x86_xgetbv(void) {
+#if defined(IREE_COMPILER_MSVC)
+  return _xgetbv(0);
+#else
+  uint32_t eax = 0, edx = 0;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return ((uint64_t)edx << 32) | eax;
+#endif  // IREE_COMPILER_MSVC
+}
+
+#define IREE_CPU_TEST_BIT(reg, bit, feature) \
+  if ((reg) & (1u << (bit))) features |= (feature)
+
+static iree_cpu_features_t iree_cpu_query_host_features(void) {
+  iree_cpu_features_t features = IREE_CPU_FEATURE_BASELINE;
+  uint32_t regs[4] = {0};
+  iree_cpu_x86_cpuid(0, 0, regs);
+  const uint32_t max_leaf = regs[0];
+
+  // Leaf 1: ECX = regs[2].
+  iree_cpu_x86_cpuid(1, 0, regs);
+  const uint32_t leaf1_ecx = regs[2];
+  IREE_CPU_TEST_BIT(leaf1_ecx, 0, IREE_CPU_FEATURE_X86_SSE3);
+  IREE_CPU_TEST_BIT(leaf1_ecx, 9, IREE_CPU_FEATURE_X86_SSSE3);
+  IREE_CPU_TEST_BIT(leaf1_ecx, 13, IREE_CPU_FEATURE_X86_CX16);
+  IREE_CPU_TEST_BIT(leaf1_ecx, 19, IREE_CPU_FEATURE_X86_SSE4_1);
+  IREE_CPU_TEST_BIT(leaf1_ecx, 20, IREE_CPU_FEATURE_X86_SSE4_2);
+  IREE_CPU_TEST_BIT(leaf1_ecx, 22, IREE_CPU_FEATURE_X86_MOVBE);
+  IREE_CPU_TEST_BIT(leaf1_ecx, 23, IREE_CPU_FEATURE_X86_POPCNT);
+  IREE_CPU_TEST_BIT(leaf1_ecx, 26, IREE_CPU_FEATURE_X86_XSAVE);
+
+  // AVX and AVX-512 are only usable if the OS saves their register state.
+  bool os_avx = false;
+  bool os_avx512 = false;
+  if (leaf1_ecx & (1u << 27)) {  // OSXSAVE
+    const uint64_t xcr0 = iree_cpu_x86_xgetbv();
+    os_avx = (xcr0 & 0x6) == 0x6;        // XMM | YMM
+    os_avx512 = (xcr0 & 0xE6) == 0xE6;  // XMM | YMM | opmask | ZMM
+  }
+  if (os_avx) {
+    IREE_CPU_TEST_BIT(leaf1_ecx, 12, IREE_CPU_FEATURE_X86_FMA);
+    IREE_CPU_TEST_BIT(leaf1_ecx, 28, IREE_CPU_FEATURE_X86_AVX);
+    IREE_CPU_TEST_BIT(leaf1_ecx, 29, IREE_CPU_FEATURE_X86_F16C);
+  }
+
+  // Leaf 7: extended features in EBX = regs[1] and ECX = regs[2].
+  if (max_leaf >= 7) {
+    iree_cpu_x86_cpuid(7, 0, regs);
+    const uint32_t leaf7_ebx = regs[1];
+    const uint32_t leaf7_ecx = regs[2];
+    const uint32_t max_leaf7_subleaf = regs[0];
+    IREE_CPU_TEST_BIT(leaf7_ebx, 3, IREE_CPU_FEATURE_X86_BMI);
+    IREE_CPU_TEST_BIT(leaf7_ebx, 8, IREE_CPU_FEATURE_X86_BMI2);
+    if (os_avx) {
+      IREE_CPU_TEST_BIT(leaf7_ebx, 5, IREE_CPU_FEATURE_X86_AVX2);
+    }
+    if (os_avx512) {
+      IREE_CPU_TEST_BIT(leaf7_ebx, 16, IREE_CPU_FEATURE_X86_AVX512F);
+      IREE_CPU_TEST_BIT(leaf7_ebx, 17, IREE_CPU_FEATURE_X86_AVX512DQ);
+      IREE_CPU_TEST_BIT(leaf7_ebx, 28, IREE_CPU_FEATURE_X86_AVX512CD);
+      IREE_CPU_TEST_BIT(leaf7_ebx, 30, IREE_CPU_FEATURE_X86_AVX512BW);
+      IREE_CPU_TEST_BIT(leaf7_ebx, 31, IREE_CPU_FEATURE_X86_AVX512VL);
+      IREE_CPU_TEST_BIT(leaf7_ecx, 11, IREE_CPU_FEATURE_X86_AVX512VNNI);
+      if (max_leaf7_subleaf >= 1) {
+        iree_cpu_x86_cpuid(7, 1, regs);
+        IREE_CPU_TEST_BIT(regs[0], 5, IREE_CPU_FEATURE_X86_AVX512BF16);
+      }
+    }
+  }
+
+  // Extended leaf 0x80000001: ECX = regs[2].
+  iree_cpu_x86_cpuid(0x80000000u, 0, regs);
+  if (regs[0] >= 0x80000001u) {
+    iree_cpu_x86_cpuid(0x80000001u, 0, regs);
+    IREE_CPU_TEST_BIT(regs[2], 0, IREE_CPU_FEATURE_X86_SAHF);
+    IREE_CPU_TEST_BIT(regs[2], 5, IREE_CPU_FEATURE_X86_LZCNT);
+  }
+  return features;
+}
+
+#elif defined(IREE_ARCH_ARM_64)
+
+#if defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_LINUX)
+// From the Linux kernel arch/arm64/include/uapi/asm/hwcap.h; older sysroots
+// may not define them all.
+#define IREE_HWCAP_ASIMDHP (1ul << 10)
+#define IREE_HWCAP_ASIMDDP (1ul << 20)
+#define IREE_HWCAP2_I8MM (1ul << 13)
+#define IREE_HWCAP2_BF16 (1ul << 14)
+#endif  // IREE_PLATFORM_ANDROID || IREE_PLATFORM_LINUX
+
+static iree_cpu_features_t iree_cpu_query_host_features(void) {
+  // NEON is mandatory on AArch64.
+  iree_cpu_features_t features =
+      IREE_CPU_FEATURE_BASELINE | IREE_CPU_FEATURE_ARM_64_NEON;
+#if defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_LINUX)
+  const unsigned long hwcap = getauxval(AT_HWCAP);
+  const unsigned long hwcap2 = getauxval(AT_HWCAP2);
+  if (hwcap & IREE_HWCAP_ASIMDHP) {
+    features |= IREE_CPU_FEATURE_ARM_64_FULLFP16;
+  }
+  if (hwcap & IREE_HWCAP_ASIMDDP) features |= IREE_CPU_FEATURE_ARM_64_DOTPROD;
+  if (hwcap2 & IREE_HWCAP2_I8MM) features |= IREE_CPU_FEATURE_ARM_64_I8MM;
+  if (hwcap2 & IREE_HWCAP2_BF16) features |= IREE_CPU_FEATURE_ARM_64_BF16;
+#endif  // IREE_PLATFORM_ANDROID || IREE_PLATFORM_LINUX
+  return features;
+}
+
+#else
+
+static iree_cpu_features_t iree_cpu_query_host_features(void) {
+  return IREE_CPU_FEATURE_BASELINE;
+}
+
+#endif  // IREE_ARCH_*
+
+static iree_once_flag iree_cpu_host_features_flag_ = IREE_ONCE_FLAG_INIT;
+static iree_cpu_features_t iree_cpu_host_features_ = 0;
+
+static void iree_cpu_initialize_host_features(void) {
+  iree_cpu_host_features_ = iree_cpu_query_host_features();
+}
+
+//==============================================================================
+// iree_cpu_supports_features
+//==============================================================================
+
+// Returns the features required by the feature or CPU level |name| or 0 if it
+// is unknown.
+static iree_cpu_features_t iree_cpu_lookup_feature(iree_string_view_t name) {
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(iree_cpu_feature_names);
+       ++i) {
+    if (iree_string_view_equal(
+            name, iree_make_cstring_view(iree_cpu_feature_names[i].name))) {
+      return iree_cpu_feature_names[i].features;
+    }
+  }
+  return 0;
+}
+
+bool iree_cpu_supports_features(iree_string_view_t features) {
+  iree_call_once(&iree_cpu_host_features_flag_,
+                 iree_cpu_initialize_host_features);
+  iree_string_view_t remaining = features;
+  while (!iree_string_view_is_empty(remaining)) {
+    iree_string_view_t feature;
+    iree_string_view_split(remaining, ',', &feature, &remaining);
+    feature = iree_string_view_trim(feature);
+    if (iree_string_view_is_empty(feature)) continue;
+    if (iree_string_view_consume_prefix(&feature, iree_make_cstring_view("-"))) {
+      continue;  // disabled; no requirement
+    }
+    iree_string_view_consume_prefix(&feature, iree_make_cstring_view("+"));
+    const iree_cpu_features_t required = iree_cpu_lookup_feature(feature);
+    if (!required || (iree_cpu_host_features_ & required) != required) {
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,41 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_BASE_INTERNAL_CPU_H_
+#define IREE_BASE_INTERNAL_CPU_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/base/target_platform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//==============================================================================
+// iree_cpu_*
+//==============================================================================
+
+// Returns true if the host CPU supports all of the |features| requested.
+//
+// |features| is a comma-separated list of LLVM-style feature names such as
+// `+avx2,+fma` or `+dotprod` and/or CPU architecture levels such as
+// `x86-64-v3`. Disabled features (`-avx512f`) place no requirements on the CPU
+// and are ignored. Features that are unknown to the runtime are treated as
+// unsupported so that code requiring them is never selected.
+//
+// The host CPU is queried once per process (cpuid on x86-64, hwcaps on
+// AArch64 Linux/Android) and the result is cached; this is safe to call from
+// multiple threads.
+bool iree_cpu_supports_features(iree_string_view_t features);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // IREE_BASE_INTERNAL_CPU_H_
@@ -0,0 +1,66 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/base/internal/cpu.h"
+
+#include "iree/testing/gtest.h"
+
+namespace {
+
+static bool SupportsFeatures(const char* features) {
+  return iree_cpu_supports_features(iree_make_cstring_view(features));
+}
+
+TEST(CPUTest, EmptyFeatures) {
+  EXPECT_TRUE(SupportsFeatures(""));
+  EXPECT_TRUE(SupportsFeatures(" , "));
+}
+
+TEST(CPUTest, UnknownFeaturesAreUnsupported) {
+  EXPECT_FALSE(SupportsFeatures("+not-a-real-feature"));
+  EXPECT_FALSE(SupportsFeatures("not-a-real-cpu"));
+}
+
+TEST(CPUTest, DisabledFeaturesAreIgnored) {
+  EXPECT_TRUE(SupportsFeatures("-not-a-real-feature"));
+}
+
+#if defined(IREE_ARCH_X86_64)
+
+TEST(CPUTest, X86Baseline) {
+  EXPECT_TRUE(SupportsFeatures("x86-64"));
+  EXPECT_TRUE(SupportsFeatures("+sse,+sse2"));
+}
+
+TEST(CPUTest, X86LevelsAreNested) {
+  // Each level implies all of the lower ones.
+  if (SupportsFeatures("x86-64-v4")) {
+    EXPECT_TRUE(SupportsFeatures("x86-64-v3"));
+  }
+  if (SupportsFeatures("x86-64-v3")) {
+    EXPECT_TRUE(SupportsFeatures("x86-64-v2"));
+    EXPECT_TRUE(SupportsFeatures("+avx2,+fma"));
+  }
+  if (SupportsFeatures("x86-64-v2")) {
+    EXPECT_TRUE(SupportsFeatures("x86-64"));
+  }
+}
+
+TEST(CPUTest, X86AllFeaturesRequired) {
+  EXPECT_EQ(SupportsFeatures("+avx2"), SupportsFeatures("+sse2,+avx2"));
+  EXPECT_FALSE(SupportsFeatures("+avx2,+not-a-real-feature"));
+}
+
+#elif defined(IREE_ARCH_ARM_64)
+
+TEST(CPUTest, ARM64Baseline) {
+  EXPECT_TRUE(SupportsFeatures("generic"));
+  EXPECT_TRUE(SupportsFeatures("+neon"));
+}
+
+#endif  // IREE_ARCH_*
+
+}  // namespace
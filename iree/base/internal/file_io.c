@@ -8,6 +8,13 @@
 
 #include "iree/base/config.h"
 
+struct iree_file_mapping_t {
+  iree_allocator_t host_allocator;
+  // Mapped file contents or empty if the file was empty (as zero-length
+  // mappings are not supported by most platforms).
+  iree_const_byte_span_t contents;
+};
+
 #if IREE_FILE_IO_ENABLE
 
 #include <errno.h>
@@ -24,6 +31,9 @@
 #include <io.h>
 #define IREE_SET_BINARY_MODE(handle) _setmode(_fileno(handle), O_BINARY)
 #else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #define IREE_SET_BINARY_MODE(handle) ((void)0)
 #endif  // IREE_PLATFORM_WINDOWS
 
@@ -117,9 +127,10 @@ iree_status_t iree_file_write_contents(const char* path,
                             "failed to open file '%s'", path);
   }
 
-  int ret = fwrite((char*)content.data, content.data_length, 1, file);
+  // Empty contents just truncate the file; fwrite would report zero items.
   iree_status_t status = iree_ok_status();
-  if (ret != 1) {
+  if (content.data_length > 0 &&
+      fwrite((char*)content.data, content.data_length, 1, file) != 1) {
     status =
         iree_make_status(IREE_STATUS_DATA_LOSS,
                          "unable to write file contents of %zu bytes to '%s'",
@@ -171,6 +182,157 @@ iree_status_t iree_stdin_read_contents(iree_allocator_t allocator,
   return status;
 }
 
+//===----------------------------------------------------------------------===//
+// iree_file_mapping_t
+//===----------------------------------------------------------------------===//
+
+#if defined(IREE_PLATFORM_WINDOWS)
+
+static iree_status_t iree_file_map_platform(
+    const char* path, iree_file_map_hints_t hints,
+    iree_const_byte_span_t* out_contents) {
+  DWORD flags = FILE_ATTRIBUTE_NORMAL;
+  if (hints & IREE_FILE_MAP_HINT_SEQUENTIAL) {
+    flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+  } else if (hints & IREE_FILE_MAP_HINT_RANDOM) {
+    flags |= FILE_FLAG_RANDOM_ACCESS;
+  }
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, flags, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    return iree_make_status(iree_status_code_from_win32_error(GetLastError()),
+                            "failed to open file '%s'", path);
+  }
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size)) {
+    CloseHandle(file);
+    return iree_make_status(iree_status_code_from_win32_error(GetLastError()),
+                            "failed to query size of file '%s'", path);
+  }
+  if (file_size.QuadPart == 0) {
+    CloseHandle(file);
+    return iree_ok_status();
+  }
+
+  // The view retains the file and mapping objects so both handles can be
+  // closed as soon as it has been created.
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  void* data = NULL;
+  if (mapping) {
+    data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  }
+  DWORD error = GetLastError();
+  if (mapping) CloseHandle(mapping);
+  CloseHandle(file);
+  if (!data) {
+    return iree_make_status(iree_status_code_from_win32_error(error),
+                            "failed to map file '%s'", path);
+  }
+  *out_contents =
+      iree_make_const_byte_span(data, (iree_host_size_t)file_size.QuadPart);
+
+#if _WIN32_WINNT >= 0x0602  // _WIN32_WINNT_WIN8
+  if (hints & IREE_FILE_MAP_HINT_PREFETCH) {
+    WIN32_MEMORY_RANGE_ENTRY range = {data, out_contents->data_length};
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+  }
+#endif  // _WIN32_WINNT >= _WIN32_WINNT_WIN8
+
+  return iree_ok_status();
+}
+
+static void iree_file_unmap_platform(iree_const_byte_span_t contents) {
+  UnmapViewOfFile(contents.data);
+}
+
+#else
+
+static iree_status_t iree_file_map_platform(
+    const char* path, iree_file_map_hints_t hints,
+    iree_const_byte_span_t* out_contents) {
+  int fd = open(path, O_RDONLY);
+  if (fd == -1) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "failed to open file '%s'", path);
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) == -1) {
+    close(fd);
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "failed to stat file '%s'", path);
+  }
+  if (file_stat.st_size == 0) {
+    close(fd);
+    return iree_ok_status();
+  }
+
+  // The mapping retains the file so the descriptor can be closed immediately.
+  void* data =
+      mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "failed to map file '%s'", path);
+  }
+  *out_contents =
+      iree_make_const_byte_span(data, (iree_host_size_t)file_stat.st_size);
+
+  // Advice is best-effort and failures are ignored.
+  if (hints & IREE_FILE_MAP_HINT_SEQUENTIAL) {
+    madvise(data, out_contents->data_length, MADV_SEQUENTIAL);
+  } else if (hints & IREE_FILE_MAP_HINT_RANDOM) {
+    madvise(data, out_contents->data_length, MADV_RANDOM);
+  }
+  if (hints & IREE_FILE_MAP_HINT_PREFETCH) {
+    madvise(data, out_contents->data_length, MADV_WILLNEED);
+  }
+
+  return iree_ok_status();
+}
+
+static void iree_file_unmap_platform(iree_const_byte_span_t contents) {
+  munmap((void*)contents.data, contents.data_length);
+}
+
+#endif  // IREE_PLATFORM_WINDOWS
+
+iree_status_t iree_file_map(const char* path, iree_file_map_hints_t hints,
+                            iree_allocator_t host_allocator,
+                            iree_file_mapping_t** out_mapping) {
+  IREE_ASSERT_ARGUMENT(path);
+  IREE_ASSERT_ARGUMENT(out_mapping);
+  *out_mapping = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_TEXT(z0, path);
+
+  iree_file_mapping_t* mapping = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, sizeof(*mapping),
+                                (void**)&mapping));
+  mapping->host_allocator = host_allocator;
+
+  iree_status_t status =
+      iree_file_map_platform(path, hints, &mapping->contents);
+  if (iree_status_is_ok(status)) {
+    *out_mapping = mapping;
+  } else {
+    iree_allocator_free(host_allocator, mapping);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+void iree_file_unmap(iree_file_mapping_t* mapping) {
+  if (!mapping) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  if (mapping->contents.data_length > 0) {
+    iree_file_unmap_platform(mapping->contents);
+  }
+  iree_allocator_free(mapping->host_allocator, mapping);
+  IREE_TRACE_ZONE_END(z0);
+}
+
 #else
 
 iree_status_t iree_file_exists(const char* path) {
@@ -193,4 +355,39 @@ iree_status_t iree_stdin_read_contents(iree_allocator_t allocator,
   return iree_make_status(IREE_STATUS_UNAVAILABLE, "File I/O is disabled");
 }
 
+iree_status_t iree_file_map(const char* path, iree_file_map_hints_t hints,
+                            iree_allocator_t host_allocator,
+                            iree_file_mapping_t** out_mapping) {
+  return iree_make_status(IREE_STATUS_UNAVAILABLE, "File I/O is disabled");
+}
+
+void iree_file_unmap(iree_file_mapping_t* mapping) {}
+
 #endif  // IREE_FILE_IO_ENABLE
+
+iree_const_byte_span_t iree_file_mapping_contents(
+    const iree_file_mapping_t* mapping) {
+  IREE_ASSERT_ARGUMENT(mapping);
+  return mapping->contents;
+}
+
+static iree_status_t iree_file_mapping_deallocator_ctl(
+    void* self, iree_allocator_command_t command, const void* params,
+    void** inout_ptr) {
+  if (command != IREE_ALLOCATOR_COMMAND_FREE) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "file mappings can only be freed");
+  }
+  iree_file_unmap((iree_file_mapping_t*)self);
+  *inout_ptr = NULL;
+  return iree_ok_status();
+}
+
+iree_allocator_t iree_file_mapping_deallocator(iree_file_mapping_t* mapping) {
+  IREE_ASSERT_ARGUMENT(mapping);
+  iree_allocator_t allocator = {
+      .self = mapping,
+      .ctl = iree_file_mapping_deallocator_ctl,
+  };
+  return allocator;
+}
@@ -45,6 +45,55 @@ iree_status_t iree_file_write_contents(const char* path,
 iree_status_t iree_stdin_read_contents(iree_allocator_t allocator,
                                        iree_byte_span_t* out_contents);
 
+//===----------------------------------------------------------------------===//
+// iree_file_mapping_t
+//===----------------------------------------------------------------------===//
+
+// Hints describing how the contents of a mapped file will be accessed.
+// Hints are advisory and ignored on platforms that do not support them.
+enum iree_file_map_hint_bits_t {
+  IREE_FILE_MAP_HINT_NONE = 0u,
+  // Contents will be accessed mostly sequentially and pages may be read ahead
+  // aggressively and dropped soon after they are accessed.
+  IREE_FILE_MAP_HINT_SEQUENTIAL = 1u << 0,
+  // Contents will be accessed in a random order and read-ahead should be
+  // disabled.
+  IREE_FILE_MAP_HINT_RANDOM = 1u << 1,
+  // The entire contents will be needed soon and should be paged in
+  // asynchronously in the background.
+  IREE_FILE_MAP_HINT_PREFETCH = 1u << 2,
+};
+typedef uint32_t iree_file_map_hints_t;
+
+// A read-only memory mapping of a file.
+// Pages are loaded lazily on first access and, as the mapping is backed by the
+// file, are shared with all other processes mapping the same file.
+typedef struct iree_file_mapping_t iree_file_mapping_t;
+
+// Maps the file at |path| read-only into memory.
+//
+// |host_allocator| is used for the mapping bookkeeping only; the contents are
+// never copied. Returns IREE_STATUS_UNAVAILABLE on platforms without file
+// mapping support in which case callers may fall back to
+// iree_file_read_contents.
+iree_status_t iree_file_map(const char* path, iree_file_map_hints_t hints,
+                            iree_allocator_t host_allocator,
+                            iree_file_mapping_t** out_mapping);
+
+// Unmaps |mapping|; any pointers into its contents are invalidated.
+void iree_file_unmap(iree_file_mapping_t* mapping);
+
+// Returns the mapped contents of the file. Valid until the mapping is unmapped.
+// Empty files have empty contents with a NULL data pointer.
+iree_const_byte_span_t iree_file_mapping_contents(
+    const iree_file_mapping_t* mapping);
+
+// Returns an allocator that unmaps |mapping| when its contents are freed
+// through it. This allows transferring ownership of the mapping to APIs that
+// take a data deallocator, such as iree_vm_bytecode_module_create.
+// Only frees are supported.
+iree_allocator_t iree_file_mapping_deallocator(iree_file_mapping_t* mapping);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
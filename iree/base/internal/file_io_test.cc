@@ -73,6 +73,63 @@ TEST(FileIO, ReadWriteContents) {
   iree_allocator_free(iree_allocator_system(), read_contents.data);
 }
 
+TEST(FileIO, MapContents) {
+  constexpr const char* kUniqueName = "MapContents";
+  auto path = GetUniquePath(kUniqueName);
+  auto write_contents = GetUniqueContents(kUniqueName);
+  IREE_ASSERT_OK(iree_file_write_contents(
+      path.c_str(),
+      iree_make_const_byte_span(write_contents.data(), write_contents.size())));
+
+  iree_file_mapping_t* mapping = NULL;
+  IREE_ASSERT_OK(iree_file_map(path.c_str(), IREE_FILE_MAP_HINT_PREFETCH,
+                               iree_allocator_system(), &mapping));
+  iree_const_byte_span_t contents = iree_file_mapping_contents(mapping);
+  EXPECT_EQ(write_contents.size(), contents.data_length);
+  EXPECT_EQ(memcmp(write_contents.data(), contents.data, contents.data_length),
+            0);
+  iree_file_unmap(mapping);
+}
+
+TEST(FileIO, MapEmpty) {
+  auto path = GetUniquePath("MapEmpty");
+  IREE_ASSERT_OK(iree_file_write_contents(path.c_str(),
+                                          iree_make_const_byte_span(NULL, 0)));
+  iree_file_mapping_t* mapping = NULL;
+  IREE_ASSERT_OK(iree_file_map(path.c_str(), IREE_FILE_MAP_HINT_NONE,
+                               iree_allocator_system(), &mapping));
+  EXPECT_EQ(0, iree_file_mapping_contents(mapping).data_length);
+  iree_file_unmap(mapping);
+}
+
+TEST(FileIO, MapMissing) {
+  iree_file_mapping_t* mapping = NULL;
+  IREE_EXPECT_STATUS_IS(
+      IREE_STATUS_NOT_FOUND,
+      iree_file_map(GetUniquePath("MapMissing").c_str(),
+                    IREE_FILE_MAP_HINT_NONE, iree_allocator_system(),
+                    &mapping));
+  EXPECT_EQ(NULL, mapping);
+}
+
+// Ownership of the mapping transfers to the deallocator, as when passing the
+// contents to APIs that free them when no longer needed.
+TEST(FileIO, MapDeallocator) {
+  constexpr const char* kUniqueName = "MapDeallocator";
+  auto path = GetUniquePath(kUniqueName);
+  auto write_contents = GetUniqueContents(kUniqueName);
+  IREE_ASSERT_OK(iree_file_write_contents(
+      path.c_str(),
+      iree_make_const_byte_span(write_contents.data(), write_contents.size())));
+
+  iree_file_mapping_t* mapping = NULL;
+  IREE_ASSERT_OK(iree_file_map(path.c_str(), IREE_FILE_MAP_HINT_SEQUENTIAL,
+                               iree_allocator_system(), &mapping));
+  iree_allocator_t deallocator = iree_file_mapping_deallocator(mapping);
+  iree_allocator_free(deallocator,
+                      (void*)iree_file_mapping_contents(mapping).data);
+}
+
 }  // namespace
 }  // namespace file_io
 }  // namespace iree
@@ -0,0 +1,448 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/base/internal/flight_recorder.h"
+
+#include <string.h>
+
+#include "iree/base/config.h"
+#include "iree/base/internal/math.h"
+#include "iree/base/target_platform.h"
+
+#if IREE_FILE_IO_ENABLE
+#include <stdlib.h>
+#if defined(IREE_PLATFORM_WINDOWS)
+#include <stdio.h>
+#else
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#endif  // IREE_PLATFORM_WINDOWS
+#endif  // IREE_FILE_IO_ENABLE
+
+//===----------------------------------------------------------------------===//
+// Recording
+//===----------------------------------------------------------------------===//
+
+// A single slot in the ring.
+//
+// Slots are written as a seqlock: the writer invalidates |sequence|, stores
+// the payload and then publishes the 1-based index of the event. Readers copy
+// the payload and discard it if |sequence| changed while they were copying.
+typedef struct iree_flight_recorder_event_t {
+  iree_atomic_int64_t sequence;
+  int64_t time_ns;
+  const char* name;
+  int64_t arg;
+  uint16_t track;
+  uint8_t phase;
+} iree_flight_recorder_event_t;
+
+typedef struct iree_flight_recorder_t {
+  // Total number of events ever reserved; the next event goes in
+  // events[head & capacity_mask].
+  iree_atomic_int64_t head;
+  iree_flight_recorder_event_t* events;
+  int64_t capacity_mask;
+  // Time the recorder was enabled; event timestamps are relative to this.
+  iree_time_t base_time_ns;
+  // Set by the first caller to iree_flight_recorder_enable.
+  iree_atomic_int32_t enabling;
+  // Set while a dump is in progress to prevent concurrent dumps.
+  iree_atomic_int32_t dumping;
+} iree_flight_recorder_t;
+
+static iree_flight_recorder_t iree_flight_recorder_global;
+
+iree_atomic_int32_t iree_flight_recorder_enabled_flag = IREE_ATOMIC_VAR_INIT(0);
+
+iree_status_t iree_flight_recorder_enable(iree_host_size_t capacity) {
+  iree_flight_recorder_t* recorder = &iree_flight_recorder_global;
+  if (capacity == 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "flight recorder capacity must be non-zero");
+  }
+  if (iree_atomic_exchange_int32(&recorder->enabling, 1,
+                                 iree_memory_order_acq_rel) != 0) {
+    return iree_ok_status();
+  }
+
+  capacity = (iree_host_size_t)iree_math_round_up_to_pow2_u64(capacity);
+  iree_flight_recorder_event_t* events = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      iree_allocator_system(), capacity * sizeof(*events), (void**)&events);
+  if (!iree_status_is_ok(status)) {
+    iree_atomic_store_int32(&recorder->enabling, 0, iree_memory_order_release);
+    return status;
+  }
+  memset(events, 0, capacity * sizeof(*events));
+  recorder->events = events;
+  recorder->capacity_mask = (int64_t)capacity - 1;
+  recorder->base_time_ns = iree_time_now();
+
+  // Publishes the ring to recorders and dumpers.
+  iree_atomic_store_int32(&iree_flight_recorder_enabled_flag, 1,
+                          iree_memory_order_release);
+  return iree_ok_status();
+}
+
+void iree_flight_recorder_record(iree_flight_recorder_phase_t phase,
+                                 uint32_t track, const char* name,
+                                 int64_t arg) {
+  if (!iree_atomic_load_int32(&iree_flight_recorder_enabled_flag,
+                              iree_memory_order_acquire)) {
+    return;
+  }
+  iree_flight_recorder_t* recorder = &iree_flight_recorder_global;
+  int64_t index = iree_atomic_fetch_add_int64(&recorder->head, 1,
+                                              iree_memory_order_relaxed);
+  iree_flight_recorder_event_t* event =
+      &recorder->events[index & recorder->capacity_mask];
+  iree_atomic_store_int64(&event->sequence, 0, iree_memory_order_relaxed);
+  iree_atomic_thread_fence(iree_memory_order_release);
+  event->time_ns = iree_time_now();
+  event->name = name;
+  event->arg = arg;
+  event->track = (uint16_t)track;
+  event->phase = (uint8_t)phase;
+  iree_atomic_store_int64(&event->sequence, index + 1,
+                          iree_memory_order_release);
+}
+
+// Copies the event with the given absolute |index| into |out_event|.
+// Returns false if the slot was overwritten or is being written.
+static bool iree_flight_recorder_read_event(
+    iree_flight_recorder_t* recorder, int64_t index,
+    iree_flight_recorder_event_t* out_event) {
+  iree_flight_recorder_event_t* event =
+      &recorder->events[index & recorder->capacity_mask];
+  int64_t sequence =
+      iree_atomic_load_int64(&event->sequence, iree_memory_order_acquire);
+  if (sequence != index + 1) return false;
+  out_event->time_ns = event->time_ns;
+  out_event->name = event->name;
+  out_event->arg = event->arg;
+  out_event->track = event->track;
+  out_event->phase = event->phase;
+  iree_atomic_thread_fence(iree_memory_order_acquire);
+  return iree_atomic_load_int64(&event->sequence,
+                                iree_memory_order_relaxed) == sequence;
+}
+
+//===----------------------------------------------------------------------===//
+// Chrome trace JSON output
+//===----------------------------------------------------------------------===//
+
+#if IREE_FILE_IO_ENABLE
+
+// Buffered writer that only uses async-signal-safe functions on POSIX.
+typedef struct iree_flight_recorder_writer_t {
+#if defined(IREE_PLATFORM_WINDOWS)
+  FILE* file;
+#else
+  int fd;
+#endif  // IREE_PLATFORM_WINDOWS
+  bool failed;
+  iree_host_size_t length;
+  char buffer[4096];
+} iree_flight_recorder_writer_t;
+
+static void iree_flight_recorder_writer_flush(
+    iree_flight_recorder_writer_t* writer) {
+  if (!writer->failed && writer->length > 0) {
+#if defined(IREE_PLATFORM_WINDOWS)
+    writer->failed =
+        fwrite(writer->buffer, 1, writer->length, writer->file) !=
+        writer->length;
+#else
+    const char* data = writer->buffer;
+    iree_host_size_t remaining = writer->length;
+    while (remaining > 0) {
+      ssize_t written = write(writer->fd, data, remaining);
+      if (written <= 0) {
+        writer->failed = true;
+        break;
+      }
+      data += written;
+      remaining -= (iree_host_size_t)written;
+    }
+#endif  // IREE_PLATFORM_WINDOWS
+  }
+  writer->length = 0;
+}
+
+static void iree_flight_recorder_writer_append_char(
+    iree_flight_recorder_writer_t* writer, char c) {
+  if (writer->length == sizeof(writer->buffer)) {
+    iree_flight_recorder_writer_flush(writer);
+  }
+  writer->buffer[writer->length++] = c;
+}
+
+static void iree_flight_recorder_writer_append_string(
+    iree_flight_recorder_writer_t* writer, const char* value) {
+  for (const char* c = value; *c; ++c) {
+    iree_flight_recorder_writer_append_char(writer, *c);
+  }
+}
+
+// Appends |value| as a JSON string body; characters that would need escaping
+// are replaced as names are expected to be plain identifiers.
+static void iree_flight_recorder_writer_append_name(
+    iree_flight_recorder_writer_t* writer, const char* value) {
+  for (const char* c = value; *c; ++c) {
+    bool needs_escape = *c == '"' || *c == '\\' || (unsigned char)*c < 0x20;
+    iree_flight_recorder_writer_append_char(writer, needs_escape ? '_' : *c);
+  }
+}
+
+static void iree_flight_recorder_writer_append_uint(
+    iree_flight_recorder_writer_t* writer, uint64_t value,
+    int min_digit_count) {
+  char digits[20];
+  int digit_count = 0;
+  do {
+    digits[digit_count++] = (char)('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  for (; digit_count < min_digit_count; ++digit_count) {
+    digits[digit_count] = '0';
+  }
+  while (digit_count > 0) {
+    iree_flight_recorder_writer_append_char(writer, digits[--digit_count]);
+  }
+}
+
+static void iree_flight_recorder_writer_append_int(
+    iree_flight_recorder_writer_t* writer, int64_t value) {
+  if (value < 0) {
+    iree_flight_recorder_writer_append_char(writer, '-');
+    iree_flight_recorder_writer_append_uint(writer, 0 - (uint64_t)value, 1);
+  } else {
+    iree_flight_recorder_writer_append_uint(writer, (uint64_t)value, 1);
+  }
+}
+
+static void iree_flight_recorder_writer_append_track_name(
+    iree_flight_recorder_writer_t* writer, uint32_t track) {
+  if (track == IREE_FLIGHT_RECORDER_TRACK_CALLER) {
+    iree_flight_recorder_writer_append_string(writer, "caller");
+  } else if (track == IREE_FLIGHT_RECORDER_TRACK_HAL) {
+    iree_flight_recorder_writer_append_string(writer, "hal");
+  } else {
+    iree_flight_recorder_writer_append_string(
+        writer, track < IREE_FLIGHT_RECORDER_TRACK_WORKER_COUNT ? "worker["
+                                                                : "track[");
+    iree_flight_recorder_writer_append_uint(writer, track, 1);
+    iree_flight_recorder_writer_append_char(writer, ']');
+  }
+}
+
+static void iree_flight_recorder_write_track_metadata(
+    iree_flight_recorder_writer_t* writer, uint32_t track) {
+  iree_flight_recorder_writer_append_string(
+      writer, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":");
+  iree_flight_recorder_writer_append_uint(writer, track, 1);
+  iree_flight_recorder_writer_append_string(writer,
+                                            ",\"args\":{\"name\":\"");
+  iree_flight_recorder_writer_append_track_name(writer, track);
+  iree_flight_recorder_writer_append_string(writer, "\"}},\n");
+}
+
+static void iree_flight_recorder_write_event(
+    iree_flight_recorder_writer_t* writer, iree_time_t base_time_ns,
+    const iree_flight_recorder_event_t* event) {
+  iree_flight_recorder_writer_append_string(writer, ",\n{\"name\":\"");
+  iree_flight_recorder_writer_append_name(writer, event->name);
+  iree_flight_recorder_writer_append_string(writer, "\",\"ph\":\"");
+  iree_flight_recorder_writer_append_char(writer, (char)event->phase);
+  // Timestamps are in microseconds with nanosecond fractions.
+  int64_t time_ns = iree_max(0, event->time_ns - base_time_ns);
+  iree_flight_recorder_writer_append_string(writer, "\",\"ts\":");
+  iree_flight_recorder_writer_append_uint(writer, (uint64_t)time_ns / 1000,
+                                          1);
+  iree_flight_recorder_writer_append_char(writer, '.');
+  iree_flight_recorder_writer_append_uint(writer, (uint64_t)time_ns % 1000,
+                                          3);
+  iree_flight_recorder_writer_append_string(writer, ",\"pid\":1,\"tid\":");
+  iree_flight_recorder_writer_append_uint(writer, event->track, 1);
+  if (event->phase == IREE_FLIGHT_RECORDER_PHASE_INSTANT) {
+    iree_flight_recorder_writer_append_string(writer, ",\"s\":\"t\"");
+  }
+  if (event->phase != IREE_FLIGHT_RECORDER_PHASE_END) {
+    iree_flight_recorder_writer_append_string(writer, ",\"args\":{\"arg\":");
+    iree_flight_recorder_writer_append_int(writer, event->arg);
+    iree_flight_recorder_writer_append_char(writer, '}');
+  }
+  iree_flight_recorder_writer_append_char(writer, '}');
+}
+
+// Writes the ring as Chrome trace JSON. Performs no allocations.
+static void iree_flight_recorder_write(iree_flight_recorder_t* recorder,
+                                       iree_flight_recorder_writer_t* writer) {
+  int64_t head =
+      iree_atomic_load_int64(&recorder->head, iree_memory_order_acquire);
+  int64_t tail = iree_max(0, head - (recorder->capacity_mask + 1));
+
+  // Gather the tracks used so that they can be named. Events recorded after
+  // this pass are still written but may be on unnamed tracks.
+  uint64_t worker_tracks = 0;
+  bool has_caller_track = false;
+  bool has_hal_track = false;
+  iree_flight_recorder_event_t event;
+  for (int64_t i = tail; i < head; ++i) {
+    if (!iree_flight_recorder_read_event(recorder, i, &event)) continue;
+    if (event.track < IREE_FLIGHT_RECORDER_TRACK_WORKER_COUNT) {
+      worker_tracks |= 1ull << event.track;
+    } else if (event.track == IREE_FLIGHT_RECORDER_TRACK_CALLER) {
+      has_caller_track = true;
+    } else if (event.track == IREE_FLIGHT_RECORDER_TRACK_HAL) {
+      has_hal_track = true;
+    }
+  }
+
+  iree_flight_recorder_writer_append_string(
+      writer, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+  for (uint32_t track = 0; track < IREE_FLIGHT_RECORDER_TRACK_WORKER_COUNT;
+       ++track) {
+    if (worker_tracks & (1ull << track)) {
+      iree_flight_recorder_write_track_metadata(writer, track);
+    }
+  }
+  if (has_caller_track) {
+    iree_flight_recorder_write_track_metadata(
+        writer, IREE_FLIGHT_RECORDER_TRACK_CALLER);
+  }
+  if (has_hal_track) {
+    iree_flight_recorder_write_track_metadata(writer,
+                                              IREE_FLIGHT_RECORDER_TRACK_HAL);
+  }
+  iree_flight_recorder_writer_append_string(
+      writer,
+      "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+      "\"args\":{\"name\":\"iree\"}}");
+
+  for (int64_t i = tail; i < head; ++i) {
+    if (!iree_flight_recorder_read_event(recorder, i, &event)) continue;
+    iree_flight_recorder_write_event(writer, recorder->base_time_ns, &event);
+  }
+  iree_flight_recorder_writer_append_string(writer, "\n]}\n");
+  iree_flight_recorder_writer_flush(writer);
+}
+
+// Dumps the ring to |path|. Async-signal-safe on POSIX.
+// Returns false if the dump failed or another dump was in progress.
+static bool iree_flight_recorder_dump_to_path(const char* path) {
+  iree_flight_recorder_t* recorder = &iree_flight_recorder_global;
+  if (iree_atomic_exchange_int32(&recorder->dumping, 1,
+                                 iree_memory_order_acquire) != 0) {
+    return false;
+  }
+  iree_flight_recorder_writer_t writer;
+  writer.failed = false;
+  writer.length = 0;
+#if defined(IREE_PLATFORM_WINDOWS)
+  writer.file = fopen(path, "wb");
+  if (writer.file) {
+    iree_flight_recorder_write(recorder, &writer);
+    writer.failed |= fclose(writer.file) != 0;
+  } else {
+    writer.failed = true;
+  }
+#else
+  writer.fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (writer.fd >= 0) {
+    iree_flight_recorder_write(recorder, &writer);
+    writer.failed |= close(writer.fd) != 0;
+  } else {
+    writer.failed = true;
+  }
+#endif  // IREE_PLATFORM_WINDOWS
+  iree_atomic_store_int32(&recorder->dumping, 0, iree_memory_order_release);
+  return !writer.failed;
+}
+
+#endif  // IREE_FILE_IO_ENABLE
+
+iree_status_t iree_flight_recorder_dump_to_file(const char* path) {
+  IREE_ASSERT_ARGUMENT(path);
+  if (!iree_atomic_load_int32(&iree_flight_recorder_enabled_flag,
+                              iree_memory_order_acquire)) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "flight recorder is not enabled");
+  }
+#if IREE_FILE_IO_ENABLE
+  if (!iree_flight_recorder_dump_to_path(path)) {
+    return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                            "failed to dump flight recorder to '%s'", path);
+  }
+  return iree_ok_status();
+#else
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "file IO is disabled in this build");
+#endif  // IREE_FILE_IO_ENABLE
+}
+
+//===----------------------------------------------------------------------===//
+// Dump handlers
+//===----------------------------------------------------------------------===//
+
+#if IREE_FILE_IO_ENABLE
+
+static char iree_flight_recorder_dump_path[1024];
+
+static void iree_flight_recorder_dump_at_exit(void) {
+  iree_flight_recorder_dump_to_path(iree_flight_recorder_dump_path);
+}
+
+#if !defined(IREE_PLATFORM_WINDOWS)
+static void iree_flight_recorder_dump_on_signal(int signal_number) {
+  (void)signal_number;
+  iree_flight_recorder_dump_to_path(iree_flight_recorder_dump_path);
+}
+#endif  // !IREE_PLATFORM_WINDOWS
+
+iree_status_t iree_flight_recorder_install_dump_handlers(const char* path) {
+  IREE_ASSERT_ARGUMENT(path);
+  static iree_atomic_int32_t installed = IREE_ATOMIC_VAR_INIT(0);
+  iree_host_size_t path_length = strlen(path);
+  if (path_length >= sizeof(iree_flight_recorder_dump_path)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "flight recorder dump path too long");
+  }
+  if (iree_atomic_exchange_int32(&installed, 1, iree_memory_order_acq_rel)) {
+    return iree_make_status(IREE_STATUS_ALREADY_EXISTS,
+                            "flight recorder dump handlers already installed");
+  }
+  memcpy(iree_flight_recorder_dump_path, path, path_length + 1);
+
+#if !defined(IREE_PLATFORM_WINDOWS)
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = iree_flight_recorder_dump_on_signal;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  if (sigaction(SIGUSR1, &action, NULL) != 0) {
+    return iree_make_status(IREE_STATUS_INTERNAL,
+                            "failed to install SIGUSR1 handler");
+  }
+#endif  // !IREE_PLATFORM_WINDOWS
+  if (atexit(iree_flight_recorder_dump_at_exit) != 0) {
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "failed to register flight recorder exit dump");
+  }
+  return iree_ok_status();
+}
+
+#else
+
+iree_status_t iree_flight_recorder_install_dump_handlers(const char* path) {
+  (void)path;
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "file IO is disabled in this build");
+}
+
+#endif  // IREE_FILE_IO_ENABLE
@@ -0,0 +1,105 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_BASE_INTERNAL_FLIGHT_RECORDER_H_
+#define IREE_BASE_INTERNAL_FLIGHT_RECORDER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A process-wide ring buffer of timestamped events that is always compiled in
+// and can be dumped as Chrome trace JSON (loadable in Perfetto and
+// chrome://tracing) without Tracy or any other profiler attached.
+//
+// The recorder is disabled by default and recording an event costs a single
+// relaxed load. Once enabled each event costs an atomic increment, a clock
+// read and a few stores into a fixed-size ring; when the ring is full the
+// oldest events are overwritten so the dump always contains the most recent
+// activity leading up to the dump. Event names must be string literals (or
+// otherwise live for the lifetime of the process) as only the pointer is
+// recorded.
+//
+// Dumping performs no allocations and only uses async-signal-safe functions
+// on POSIX so that it can be triggered from a signal handler in a process
+// that appears to be hung. Events being written concurrently with a dump are
+// skipped.
+
+// Event phases as defined by the Chrome trace event format.
+typedef enum iree_flight_recorder_phase_e {
+  // Begins a duration on the track; must be paired with an END.
+  IREE_FLIGHT_RECORDER_PHASE_BEGIN = 'B',
+  // Ends the most recently begun duration on the track.
+  IREE_FLIGHT_RECORDER_PHASE_END = 'E',
+  // An instantaneous event on the track.
+  IREE_FLIGHT_RECORDER_PHASE_INSTANT = 'i',
+} iree_flight_recorder_phase_t;
+
+// Tracks [0, IREE_FLIGHT_RECORDER_TRACK_WORKER_COUNT) are reserved for task
+// system workers and are named `worker[N]` in the dump.
+#define IREE_FLIGHT_RECORDER_TRACK_WORKER_COUNT 64
+// Track used for events from threads donated by callers waiting on the
+// executor and other threads not owned by the task system.
+#define IREE_FLIGHT_RECORDER_TRACK_CALLER 0xFFFE
+// Track used for HAL device queue operations.
+#define IREE_FLIGHT_RECORDER_TRACK_HAL 0xFFFF
+
+// Nonzero when the recorder is enabled; use iree_flight_recorder_is_enabled.
+extern iree_atomic_int32_t iree_flight_recorder_enabled_flag;
+
+// Enables the process-wide flight recorder with a ring of at least |capacity|
+// events (rounded up to a power of two). The ring is never freed so that
+// dumps from signal handlers remain valid. Enabling an already enabled
+// recorder is a no-op that retains the existing ring.
+iree_status_t iree_flight_recorder_enable(iree_host_size_t capacity);
+
+// Returns true if events are being recorded.
+static inline bool iree_flight_recorder_is_enabled(void) {
+  return iree_atomic_load_int32(&iree_flight_recorder_enabled_flag,
+                                iree_memory_order_relaxed) != 0;
+}
+
+// Records an event with the given |phase| on |track|. |name| must outlive the
+// process and |arg| is shown as the event argument in the dump.
+// Prefer the IREE_FLIGHT_RECORD_* macros that skip the call when disabled.
+void iree_flight_recorder_record(iree_flight_recorder_phase_t phase,
+                                 uint32_t track, const char* name,
+                                 int64_t arg);
+
+#define IREE_FLIGHT_RECORD(phase, track, name, arg)         \
+  do {                                                      \
+    if (IREE_UNLIKELY(iree_flight_recorder_is_enabled())) { \
+      iree_flight_recorder_record(phase, track, name, arg); \
+    }                                                       \
+  } while (0)
+#define IREE_FLIGHT_RECORD_BEGIN(track, name, arg) \
+  IREE_FLIGHT_RECORD(IREE_FLIGHT_RECORDER_PHASE_BEGIN, track, name, arg)
+#define IREE_FLIGHT_RECORD_END(track, name) \
+  IREE_FLIGHT_RECORD(IREE_FLIGHT_RECORDER_PHASE_END, track, name, 0)
+#define IREE_FLIGHT_RECORD_INSTANT(track, name, arg) \
+  IREE_FLIGHT_RECORD(IREE_FLIGHT_RECORDER_PHASE_INSTANT, track, name, arg)
+
+// Writes the current contents of the ring to |path| as Chrome trace JSON,
+// overwriting any existing file. Recording continues during the dump.
+// Returns FAILED_PRECONDITION if the recorder is not enabled.
+iree_status_t iree_flight_recorder_dump_to_file(const char* path);
+
+// Dumps the ring to |path| when the process exits normally and, on POSIX,
+// whenever the process receives SIGUSR1 (`kill -USR1 <pid>`). |path| is
+// copied. Only one dump path may be installed per process.
+iree_status_t iree_flight_recorder_install_dump_handlers(const char* path);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // IREE_BASE_INTERNAL_FLIGHT_RECORDER_H_
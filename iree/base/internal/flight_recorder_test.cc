@@ -0,0 +1,82 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/base/internal/flight_recorder.h"
+
+#include <cstdlib>
+#include <string>
+
+#include "iree/base/config.h"
+#include "iree/base/internal/file_io.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+#if IREE_FILE_IO_ENABLE
+
+namespace {
+
+std::string GetUniquePath(const char* unique_name) {
+  const char* test_tmpdir = getenv("TEST_TMPDIR");
+  if (!test_tmpdir) test_tmpdir = getenv("TMPDIR");
+  if (!test_tmpdir) test_tmpdir = getenv("TEMP");
+  if (!test_tmpdir) test_tmpdir = "/tmp";
+  return test_tmpdir + std::string("/iree_test_") + unique_name;
+}
+
+std::string DumpToString(const char* unique_name) {
+  std::string path = GetUniquePath(unique_name);
+  IREE_CHECK_OK(iree_flight_recorder_dump_to_file(path.c_str()));
+  iree_byte_span_t contents = iree_make_byte_span(NULL, 0);
+  IREE_CHECK_OK(iree_file_read_contents(path.c_str(), iree_allocator_system(),
+                                        &contents));
+  std::string result(reinterpret_cast<const char*>(contents.data),
+                     contents.data_length);
+  iree_allocator_free(iree_allocator_system(), contents.data);
+  return result;
+}
+
+// The recorder is process-wide so all checks live in a single test.
+TEST(FlightRecorderTest, RecordAndDump) {
+  EXPECT_FALSE(iree_flight_recorder_is_enabled());
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_FAILED_PRECONDITION,
+                        iree_flight_recorder_dump_to_file(
+                            GetUniquePath("flight_recorder_disabled").c_str()));
+  // Ignored while disabled.
+  IREE_FLIGHT_RECORD_INSTANT(0, "dropped", 0);
+
+  // Capacity is rounded up to 8.
+  IREE_ASSERT_OK(iree_flight_recorder_enable(5));
+  EXPECT_TRUE(iree_flight_recorder_is_enabled());
+  IREE_FLIGHT_RECORD_BEGIN(3, "shard", 42);
+  IREE_FLIGHT_RECORD_END(3, "shard");
+  IREE_FLIGHT_RECORD_INSTANT(IREE_FLIGHT_RECORDER_TRACK_HAL, "submit", -7);
+
+  std::string trace = DumpToString("flight_recorder_basic.json");
+  EXPECT_EQ(std::string::npos, trace.find("dropped"));
+  EXPECT_NE(std::string::npos, trace.find("\"name\":\"worker[3]\""));
+  EXPECT_NE(std::string::npos, trace.find("\"name\":\"hal\""));
+  EXPECT_NE(std::string::npos,
+            trace.find("\"name\":\"shard\",\"ph\":\"B\""));
+  EXPECT_NE(std::string::npos, trace.find("\"args\":{\"arg\":42}"));
+  EXPECT_NE(std::string::npos,
+            trace.find("\"name\":\"shard\",\"ph\":\"E\""));
+  EXPECT_NE(std::string::npos, trace.find("\"args\":{\"arg\":-7}"));
+
+  // Overflowing the ring keeps only the most recent events.
+  for (int i = 0; i < 16; ++i) {
+    IREE_FLIGHT_RECORD_INSTANT(1, "overflow", i);
+  }
+  trace = DumpToString("flight_recorder_overflow.json");
+  EXPECT_EQ(std::string::npos, trace.find("\"name\":\"shard\""));
+  EXPECT_EQ(std::string::npos, trace.find("\"name\":\"hal\""));
+  EXPECT_EQ(std::string::npos, trace.find("\"args\":{\"arg\":7}"));
+  EXPECT_NE(std::string::npos, trace.find("\"args\":{\"arg\":8}"));
+  EXPECT_NE(std::string::npos, trace.find("\"args\":{\"arg\":15}"));
+}
+
+}  // namespace
+
+#endif  // IREE_FILE_IO_ENABLE
@@ -101,6 +101,17 @@ iree_fpu_state_t iree_fpu_state_push(iree_fpu_state_flags_t flags) {
   return state;
 }
 
+void iree_fpu_state_update(iree_fpu_state_t* state,
+                           iree_fpu_state_flags_t flags) {
+  uint64_t new_value = iree_fpu_state_set_dtz(
+      state->current_value,
+      (flags & IREE_FPU_STATE_FLAG_FLUSH_DENORMALS_TO_ZERO) ? true : false);
+  if (new_value != state->current_value) {
+    iree_fpu_store_state(new_value);
+    state->current_value = new_value;
+  }
+}
+
 void iree_fpu_state_pop(iree_fpu_state_t state) {
   if (state.previous_value != state.current_value) {
     iree_fpu_store_state(state.previous_value);
@@ -48,6 +48,14 @@ typedef struct iree_fpu_state_t {
 // May lead to a pipeline flush; avoid if possible.
 iree_fpu_state_t iree_fpu_state_push(iree_fpu_state_flags_t flags);
 
+// Changes the FPU state of the current thread pushed as |state| to match
+// |flags|. The FPU state is only written if the flags change it such that
+// callers switching between work with different requirements only pay for the
+// switches and not for each unit of work. The original state is still restored
+// by iree_fpu_state_pop.
+void iree_fpu_state_update(iree_fpu_state_t* state,
+                           iree_fpu_state_flags_t flags);
+
 // Restores the FPU state of the thread to its original value.
 // May lead to a pipeline flush; avoid if possible.
 void iree_fpu_state_pop(iree_fpu_state_t state);
@@ -25,4 +25,29 @@ TEST(FPUStateTest, FlushDenormalsToZero) {
   iree_fpu_state_pop(fpu_state);
 }
 
+// Tests that updating a pushed state switches between flushing and preserving
+// denormals and only changes the state when the flags differ.
+TEST(FPUStateTest, UpdateFlushDenormalsToZero) {
+  iree_fpu_state_t fpu_state = iree_fpu_state_push(IREE_FPU_STATE_DEFAULT);
+  uint64_t default_value = fpu_state.current_value;
+
+  iree_fpu_state_update(&fpu_state,
+                        IREE_FPU_STATE_FLAG_FLUSH_DENORMALS_TO_ZERO);
+  float f = 1.0f;
+  volatile float* fp = &f;
+  *fp = *fp * 1e-39f;
+  EXPECT_EQ(0.0f, f);
+
+  // Updating to the same flags leaves the state untouched.
+  uint64_t flushing_value = fpu_state.current_value;
+  iree_fpu_state_update(&fpu_state,
+                        IREE_FPU_STATE_FLAG_FLUSH_DENORMALS_TO_ZERO);
+  EXPECT_EQ(flushing_value, fpu_state.current_value);
+
+  iree_fpu_state_update(&fpu_state, IREE_FPU_STATE_DEFAULT);
+  EXPECT_EQ(default_value, fpu_state.current_value);
+
+  iree_fpu_state_pop(fpu_state);
+}
+
 }  // namespace
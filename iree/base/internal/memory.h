@@ -4,14 +4,16 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
-#ifndef IREE_HAL_LOCAL_ELF_PLATFORM_H_
-#define IREE_HAL_LOCAL_ELF_PLATFORM_H_
+#ifndef IREE_BASE_INTERNAL_MEMORY_H_
+#define IREE_BASE_INTERNAL_MEMORY_H_
 
 #include "iree/base/api.h"
 
-// TODO(benvanik): move some of this to iree/base/internal/. A lot of this code
-// comes from an old partial implementation of memory objects that should be
-// finished. When done it will replace the need for all of these platform files.
+// Host virtual memory utilities shared by the ELF loader and the VM JIT.
+//
+// TODO(benvanik): a lot of this code comes from an old partial implementation
+// of memory objects that should be finished. When done it will replace the
+// need for all of these platform files.
 
 //==============================================================================
 // Alignment utilities
@@ -125,6 +127,12 @@ enum iree_memory_view_flag_bits_t {
   // TODO(benvanik): pull from memory_object.h.
   IREE_MEMORY_VIEW_FLAG_NONE = 0u,
 
+  // Indicates that the view should be backed by large pages to reduce TLB
+  // pressure. The base address will be aligned to
+  // iree_memory_info_t::large_page_granularity. Advisory: platforms without
+  // (transparent) large page support will use normal pages.
+  IREE_MEMORY_VIEW_FLAG_LARGE_PAGES = 1u << 0,
+
   // Indicates that the memory may be used to execute code.
   // May be used to ask for special privileges (like MAP_JIT on MacOS).
   IREE_MEMORY_VIEW_FLAG_MAY_EXECUTE = 1u << 10,
@@ -153,7 +161,7 @@ void iree_memory_view_release(void* base_address, iree_host_size_t total_length,
 // Commits pages overlapping the byte ranges defined by |byte_ranges|.
 // Ranges will be adjusted to the page granularity of the view.
 //
-// Implemented by VirtualAlloc+MEM_COMMIT/mmap+!PROT_NONE.
+// Implemented by VirtualAlloc+MEM_COMMIT/mprotect+!PROT_NONE.
 iree_status_t iree_memory_view_commit_ranges(
     void* base_address, iree_host_size_t range_count,
     const iree_byte_range_t* ranges, iree_memory_access_t initial_access);
@@ -169,9 +177,26 @@ iree_status_t iree_memory_view_protect_ranges(void* base_address,
                                               const iree_byte_range_t* ranges,
                                               iree_memory_access_t new_access);
 
+// Maps the pages backing |length| bytes at |source_address| into the view at
+// |target_address| without copying, replacing any pages already committed
+// there, and applies |access| protection. Both addresses must have the same
+// offset within a page. The source pages are shared and the new mapping keeps
+// them alive independent of the source mapping lifetime.
+//
+// Returns IREE_STATUS_UNAVAILABLE if the source pages cannot be aliased (such
+// as private anonymous memory) or the platform does not support aliasing; in
+// that case the target range is left untouched and callers must fall back to
+// committing and copying.
+//
+// Implemented by mremap on shareable (memfd/file-backed) mappings.
+iree_status_t iree_memory_view_alias_range(void* target_address,
+                                           const void* source_address,
+                                           iree_host_size_t length,
+                                           iree_memory_access_t access);
+
 // Flushes the CPU instruction cache for a given range of bytes.
 // May be a no-op depending on architecture, but must be called prior to
 // executing code from any pages that have been written during load.
 void iree_memory_view_flush_icache(void* base_address, iree_host_size_t length);
 
-#endif  // IREE_HAL_LOCAL_ELF_PLATFORM_H_
+#endif  // IREE_BASE_INTERNAL_MEMORY_H_
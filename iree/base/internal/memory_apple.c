@@ -4,9 +4,9 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include "iree/base/internal/memory.h"
 #include "iree/base/target_platform.h"
 #include "iree/base/tracing.h"
-#include "iree/hal/local/elf/platform.h"
 
 #if defined(IREE_PLATFORM_APPLE)
 
@@ -169,6 +169,15 @@ iree_status_t iree_memory_view_protect_ranges(void* base_address,
   return status;
 }
 
+iree_status_t iree_memory_view_alias_range(void* target_address,
+                                           const void* source_address,
+                                           iree_host_size_t length,
+                                           iree_memory_access_t access) {
+  // NOTE: mach_vm_remap could share the pages but the result would need to
+  // be reconciled with the MAP_JIT reservation; callers fall back to copying.
+  return iree_status_from_code(IREE_STATUS_UNAVAILABLE);
+}
+
 void sys_icache_invalidate(void* start, size_t len);
 
 void iree_memory_view_flush_icache(void* base_address,
@@ -4,9 +4,9 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include "iree/base/internal/memory.h"
 #include "iree/base/target_platform.h"
 #include "iree/base/tracing.h"
-#include "iree/hal/local/elf/platform.h"
 
 #if defined(IREE_PLATFORM_GENERIC)
 
@@ -73,6 +73,14 @@ iree_status_t iree_memory_view_protect_ranges(void* base_address,
   return iree_ok_status();
 }
 
+iree_status_t iree_memory_view_alias_range(void* target_address,
+                                           const void* source_address,
+                                           iree_host_size_t length,
+                                           iree_memory_access_t access) {
+  // Not supported; callers fall back to copying.
+  return iree_status_from_code(IREE_STATUS_UNAVAILABLE);
+}
+
 // IREE_ELF_CLEAR_CACHE can be defined externally to override this default
 // behavior.
 #if !defined(IREE_ELF_CLEAR_CACHE)
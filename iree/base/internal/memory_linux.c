@@ -4,13 +4,19 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+// mremap is a GNU extension.
+#if !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif  // !_GNU_SOURCE
+
+#include "iree/base/internal/memory.h"
 #include "iree/base/target_platform.h"
 #include "iree/base/tracing.h"
-#include "iree/hal/local/elf/platform.h"
 
 #if defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_LINUX)
 
 #include <errno.h>
+#include <stdio.h>
 #include <sys/mman.h>
 #include <unistd.h>
 
@@ -25,14 +31,22 @@ void iree_memory_query_info(iree_memory_info_t* out_info) {
   out_info->normal_page_size = page_size;
   out_info->normal_page_granularity = page_size;
 
-  // Large pages arent't currently used so we aren't introducing the build goo
-  // to detect and use them yet.
-  // https://linux.die.net/man/3/gethugepagesizes
-  // http://manpages.ubuntu.com/manpages/bionic/man3/gethugepagesize.3.html
-  // Would be:
-  //   #include <hugetlbfs.h>
-  //   out_info->large_page_granularity = gethugepagesize();
+  // Large pages are transparent huge pages (THP) requested with madvise. This
+  // avoids the need for a preallocated hugetlbfs pool (MAP_HUGETLB) and falls
+  // back to normal pages when THP is unavailable or disabled.
   out_info->large_page_granularity = page_size;
+#if defined(MADV_HUGEPAGE)
+  FILE* file = fopen("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", "r");
+  if (file) {
+    unsigned long long pmd_size = 0;
+    if (fscanf(file, "%llu", &pmd_size) == 1 &&
+        pmd_size > (unsigned long long)page_size &&
+        (pmd_size & (pmd_size - 1)) == 0) {
+      out_info->large_page_granularity = (iree_host_size_t)pmd_size;
+    }
+    fclose(file);
+  }
+#endif  // MADV_HUGEPAGE
 
   out_info->can_allocate_executable_pages = true;
 }
@@ -63,13 +77,47 @@ iree_status_t iree_memory_view_reserve(iree_memory_view_flags_t flags,
   int mmap_prot = PROT_NONE;
   int mmap_flags = MAP_PRIVATE | MAP_ANON | MAP_NORESERVE;
 
+  // Large pages must start at an aligned address; over-reserve by the
+  // alignment and trim the excess on either side.
+  iree_host_size_t alignment = 0;
+#if defined(MADV_HUGEPAGE)
+  if (flags & IREE_MEMORY_VIEW_FLAG_LARGE_PAGES) {
+    iree_memory_info_t memory_info;
+    iree_memory_query_info(&memory_info);
+    if (memory_info.large_page_granularity > memory_info.normal_page_size) {
+      alignment = memory_info.large_page_granularity;
+    }
+  }
+#endif  // MADV_HUGEPAGE
+
   iree_status_t status = iree_ok_status();
-  void* base_address = mmap(NULL, total_length, mmap_prot, mmap_flags, -1, 0);
+  void* base_address = mmap(NULL, total_length + alignment, mmap_prot,
+                            mmap_flags, -1, 0);
   if (base_address == MAP_FAILED) {
+    base_address = NULL;
     status = iree_make_status(iree_status_code_from_errno(errno),
                               "mmap reservation failed");
   }
 
+#if defined(MADV_HUGEPAGE)
+  if (iree_status_is_ok(status) && alignment) {
+    uint8_t* reserved_start = (uint8_t*)base_address;
+    uint8_t* aligned_start =
+        (uint8_t*)iree_page_align_end((uintptr_t)reserved_start, alignment);
+    uint8_t* reserved_end = reserved_start + total_length + alignment;
+    uint8_t* aligned_end = aligned_start + total_length;
+    if (aligned_start > reserved_start) {
+      munmap(reserved_start, aligned_start - reserved_start);
+    }
+    if (reserved_end > aligned_end) {
+      munmap(aligned_end, reserved_end - aligned_end);
+    }
+    base_address = aligned_start;
+    // NOTE: advisory; THP may be disabled or unavailable.
+    madvise(base_address, total_length, MADV_HUGEPAGE);
+  }
+#endif  // MADV_HUGEPAGE
+
   *out_base_address = base_address;
   IREE_TRACE_ZONE_END(z0);
   return status;
@@ -90,8 +138,10 @@ iree_status_t iree_memory_view_commit_ranges(
     const iree_byte_range_t* ranges, iree_memory_access_t initial_access) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // Committing only changes the protection of the reserved pages: the pages
+  // are zero-filled on first touch and this keeps any large page advice made
+  // on the reservation (a new MAP_FIXED mapping would discard it).
   int mmap_prot = iree_memory_access_to_prot(initial_access);
-  int mmap_flags = MAP_PRIVATE | MAP_ANON | MAP_FIXED;
 
   iree_status_t status = iree_ok_status();
   for (iree_host_size_t i = 0; i < range_count; ++i) {
@@ -99,11 +149,10 @@ iree_status_t iree_memory_view_commit_ranges(
     iree_host_size_t aligned_length = 0;
     iree_page_align_range(base_address, ranges[i], getpagesize(), &range_start,
                           &aligned_length);
-    void* result =
-        mmap(range_start, aligned_length, mmap_prot, mmap_flags, -1, 0);
-    if (result == MAP_FAILED) {
+    int ret = mprotect(range_start, aligned_length, mmap_prot);
+    if (ret != 0) {
       status = iree_make_status(iree_status_code_from_errno(errno),
-                                "mmap commit failed");
+                                "mprotect commit failed");
       break;
     }
   }
@@ -138,6 +187,57 @@ iree_status_t iree_memory_view_protect_ranges(void* base_address,
   return status;
 }
 
+iree_status_t iree_memory_view_alias_range(void* target_address,
+                                           const void* source_address,
+                                           iree_host_size_t length,
+                                           iree_memory_access_t access) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_host_size_t page_size = getpagesize();
+  if (((uintptr_t)target_address & (page_size - 1)) !=
+      ((uintptr_t)source_address & (page_size - 1))) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_status_from_code(IREE_STATUS_UNAVAILABLE);
+  }
+  iree_byte_range_t range = {
+      .offset = 0,
+      .length = length,
+  };
+  void* source_start = NULL;
+  void* target_start = NULL;
+  iree_host_size_t aligned_length = 0;
+  iree_page_align_range((void*)source_address, range, page_size, &source_start,
+                        &aligned_length);
+  iree_page_align_range(target_address, range, page_size, &target_start,
+                        &aligned_length);
+
+  // An old_size of 0 creates a second mapping of the same pages; this fails
+  // with EINVAL for private mappings and EFAULT if the range spans multiple
+  // mappings. The alias is created at a kernel-chosen address first so that
+  // the target reservation is only replaced once it is known to succeed.
+  void* alias = mremap(source_start, 0, aligned_length, MREMAP_MAYMOVE);
+  if (alias == MAP_FAILED) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_status_from_code(IREE_STATUS_UNAVAILABLE);
+  }
+  if (mprotect(alias, aligned_length, iree_memory_access_to_prot(access)) !=
+      0) {
+    munmap(alias, aligned_length);
+    IREE_TRACE_ZONE_END(z0);
+    return iree_status_from_code(IREE_STATUS_UNAVAILABLE);
+  }
+  void* result = mremap(alias, aligned_length, aligned_length,
+                        MREMAP_MAYMOVE | MREMAP_FIXED, target_start);
+  if (result == MAP_FAILED) {
+    munmap(alias, aligned_length);
+    IREE_TRACE_ZONE_END(z0);
+    return iree_status_from_code(IREE_STATUS_UNAVAILABLE);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
 // IREE_ELF_CLEAR_CACHE can be defined externally to override this default
 // behavior.
 #if !defined(IREE_ELF_CLEAR_CACHE)
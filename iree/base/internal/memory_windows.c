@@ -5,9 +5,9 @@
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
 #include "iree/base/api.h"
+#include "iree/base/internal/memory.h"
 #include "iree/base/target_platform.h"
 #include "iree/base/tracing.h"
-#include "iree/hal/local/elf/platform.h"
 
 #if defined(IREE_PLATFORM_WINDOWS)
 
@@ -144,6 +144,15 @@ iree_status_t iree_memory_view_protect_ranges(void* base_address,
   return status;
 }
 
+iree_status_t iree_memory_view_alias_range(void* target_address,
+                                           const void* source_address,
+                                           iree_host_size_t length,
+                                           iree_memory_access_t access) {
+  // NOTE: aliasing requires the source to be a section view and the target
+  // a placeholder (MapViewOfFile3); callers fall back to copying.
+  return iree_status_from_code(IREE_STATUS_UNAVAILABLE);
+}
+
 void iree_memory_view_flush_icache(void* base_address,
                                    iree_host_size_t length) {
   FlushInstructionCache(GetCurrentProcess(), base_address, length);
@@ -35,6 +35,10 @@
 
 #endif  // IREE_PLATFORM_*
 
+#if !IREE_SYNCHRONIZATION_DISABLE_UNSAFE && !defined(IREE_PLATFORM_HAS_FUTEX)
+#include <time.h>
+#endif  // !IREE_SYNCHRONIZATION_DISABLE_UNSAFE && !IREE_PLATFORM_HAS_FUTEX
+
 #if defined(NDEBUG)
 #define SYNC_ASSERT(x) (void)(x)
 #else
@@ -551,6 +555,12 @@ void iree_slim_mutex_unlock(iree_slim_mutex_t* mutex)
 #define IREE_NOTIFICATION_EPOCH_INC \
   (0x00000001ull << IREE_NOTIFICATION_EPOCH_SHIFT)
 
+// Maximum number of processor pause instructions issued between each check of
+// the epoch while spinning in iree_notification_await_until. Spinners start at
+// 1 and double each check until this limit to stay off the notification cache
+// line.
+#define IREE_NOTIFICATION_MAX_SPIN_PAUSE_COUNT 64
+
 void iree_notification_initialize(iree_notification_t* out_notification) {
   memset(out_notification, 0, sizeof(*out_notification));
 #if IREE_SYNCHRONIZATION_DISABLE_UNSAFE
@@ -635,6 +645,67 @@ void iree_notification_commit_wait(iree_notification_t* notification,
   SYNC_ASSERT((previous_value & IREE_NOTIFICATION_WAITER_MASK) != 0);
 }
 
+bool iree_notification_commit_wait_until(iree_notification_t* notification,
+                                         iree_wait_token_t wait_token,
+                                         iree_time_t deadline_ns) {
+  // Wait until notified or the deadline elapses. The deadline is only checked
+  // after the epoch so that a notification posted right as the deadline
+  // elapses is still reported.
+  bool posted = true;
+  while ((iree_atomic_load_int64(&notification->value,
+                                 iree_memory_order_acquire) >>
+          IREE_NOTIFICATION_EPOCH_SHIFT) == wait_token) {
+    iree_duration_t timeout_ns =
+        iree_absolute_deadline_to_timeout_ns(deadline_ns);
+    if (timeout_ns == IREE_DURATION_ZERO) {
+      posted = false;
+      break;
+    }
+#if IREE_SYNCHRONIZATION_DISABLE_UNSAFE
+    // TODO(benvanik): platform sleep? this spins.
+#elif defined(IREE_PLATFORM_HAS_FUTEX)
+    // Round up so that we never wake prior to the deadline.
+    uint32_t timeout_ms = IREE_INFINITE_TIMEOUT_MS;
+    if (timeout_ns != IREE_DURATION_INFINITE) {
+      iree_duration_t timeout_ms_64 = (timeout_ns + 999999ll) / 1000000ll;
+      timeout_ms = timeout_ms_64 < (iree_duration_t)IREE_INFINITE_TIMEOUT_MS
+                       ? (uint32_t)timeout_ms_64
+                       : IREE_INFINITE_TIMEOUT_MS - 1;
+    }
+    iree_status_ignore(iree_futex_wait(
+        iree_notification_epoch_address(notification), wait_token, timeout_ms));
+#else
+    pthread_mutex_lock(&notification->mutex);
+    if (timeout_ns == IREE_DURATION_INFINITE) {
+      pthread_cond_wait(&notification->cond, &notification->mutex);
+    } else {
+      // pthread_cond_timedwait takes an absolute CLOCK_REALTIME time.
+      struct timespec abstime;
+      clock_gettime(CLOCK_REALTIME, &abstime);
+      timeout_ns += abstime.tv_nsec;
+      abstime.tv_sec += (time_t)(timeout_ns / 1000000000ll);
+      abstime.tv_nsec = (long)(timeout_ns % 1000000000ll);
+      pthread_cond_timedwait(&notification->cond, &notification->mutex,
+                             &abstime);
+    }
+    pthread_mutex_unlock(&notification->mutex);
+#endif  // IREE_PLATFORM_HAS_FUTEX
+  }
+
+  uint64_t previous_value = iree_atomic_fetch_add_int64(
+      &notification->value, IREE_NOTIFICATION_WAITER_DEC,
+      iree_memory_order_seq_cst);
+  SYNC_ASSERT((previous_value & IREE_NOTIFICATION_WAITER_MASK) != 0);
+  return posted;
+}
+
+bool iree_notification_is_posted(iree_notification_t* notification,
+                                 iree_wait_token_t wait_token) {
+  return (iree_atomic_load_int64(&notification->value,
+                                 iree_memory_order_acquire) >>
+          IREE_NOTIFICATION_EPOCH_SHIFT) != wait_token;
+}
+
 void iree_notification_cancel_wait(iree_notification_t* notification) {
   // TODO(benvanik): benchmark under real workloads.
   // iree_memory_order_relaxed would suffice for correctness but the faster
@@ -664,3 +735,62 @@ void iree_notification_await(iree_notification_t* notification,
     }
   }
 }
+
+bool iree_notification_await_until(iree_notification_t* notification,
+                                   iree_condition_fn_t condition_fn,
+                                   void* condition_arg,
+                                   iree_duration_t spin_ns,
+                                   iree_time_t deadline_ns) {
+  if (IREE_LIKELY(condition_fn(condition_arg))) {
+    // Fast-path with condition already met.
+    return true;
+  } else if (deadline_ns == IREE_TIME_INFINITE_PAST) {
+    // Polling; no need to wait.
+    return false;
+  }
+
+  // Spinning ends at whichever comes first of the spin duration or deadline.
+  iree_time_t spin_deadline_ns = IREE_TIME_INFINITE_PAST;
+  if (spin_ns > 0) {
+    spin_deadline_ns = iree_time_now() + spin_ns;
+    if (spin_deadline_ns > deadline_ns) spin_deadline_ns = deadline_ns;
+  }
+
+  // Slow-path: try-wait until the condition is met.
+  uint32_t pause_count = 1;
+  while (true) {
+    iree_wait_token_t wait_token = iree_notification_prepare_wait(notification);
+    if (condition_fn(condition_arg)) {
+      // Condition is now met; no need to wait on the futex.
+      iree_notification_cancel_wait(notification);
+      return true;
+    }
+
+    // Spin on the notification epoch (and not the condition, which may be
+    // expensive or take locks) until something is posted.
+    bool posted = false;
+    while (iree_time_now() < spin_deadline_ns) {
+      if (iree_notification_is_posted(notification, wait_token)) {
+        posted = true;
+        break;
+      }
+      for (uint32_t i = 0; i < pause_count; ++i) {
+        iree_processor_pause();
+      }
+      if (pause_count < IREE_NOTIFICATION_MAX_SPIN_PAUSE_COUNT) {
+        pause_count <<= 1;
+      }
+    }
+    if (posted) {
+      // Recheck the condition with a new token.
+      iree_notification_cancel_wait(notification);
+      continue;
+    }
+
+    // Park in the OS until posted or the deadline elapses.
+    if (!iree_notification_commit_wait_until(notification, wait_token,
+                                             deadline_ns)) {
+      return condition_fn(condition_arg);
+    }
+  }
+}
@@ -70,6 +70,10 @@
 #include <pthread.h>
 #endif  // !IREE_PLATFORM_WINDOWS
 
+#if defined(IREE_COMPILER_MSVC)
+#include <intrin.h>
+#endif  // IREE_COMPILER_MSVC
+
 // We have the CRITICAL_SECTION path for now but Slim Reader/Writer lock (SRW)
 // is much better (and what std::mutex uses). SRW doesn't spin, though, and has
 // some other implications that don't quite line up with pthread_mutex_t on most
@@ -86,6 +90,24 @@ extern "C" {
 #define IREE_ALL_WAITERS INT32_MAX
 #define IREE_INFINITE_TIMEOUT_MS UINT32_MAX
 
+// Pauses the processor for a short period while spinning.
+static inline void iree_processor_pause(void) {
+#if defined(IREE_COMPILER_MSVC) && \
+    (defined(IREE_ARCH_X86_32) || defined(IREE_ARCH_X86_64))
+  _mm_pause();
+#elif defined(IREE_COMPILER_MSVC) && defined(IREE_ARCH_ARM_64)
+  __yield();
+#elif defined(IREE_COMPILER_GCC_COMPAT) && \
+    (defined(IREE_ARCH_X86_32) || defined(IREE_ARCH_X86_64))
+  __builtin_ia32_pause();
+#elif defined(IREE_COMPILER_GCC_COMPAT) && \
+    (defined(IREE_ARCH_ARM_32) || defined(IREE_ARCH_ARM_64))
+  __asm__ __volatile__("yield");
+#else
+  // No pause instruction available; spin on the load alone.
+#endif  // IREE_ARCH_*
+}
+
 //==============================================================================
 // iree_mutex_t
 //==============================================================================
@@ -340,6 +362,15 @@ iree_wait_token_t iree_notification_prepare_wait(
 void iree_notification_commit_wait(iree_notification_t* notification,
                                    iree_wait_token_t wait_token);
 
+// Returns true if a notification has been posted since |wait_token| was
+// returned from iree_notification_prepare_wait. This never blocks and can be
+// used to spin for a short period prior to committing the wait. The pending
+// wait must still be either committed or canceled.
+//
+// Acts as (at least) a memory_order_acquire barrier.
+bool iree_notification_is_posted(iree_notification_t* notification,
+                                 iree_wait_token_t wait_token);
+
 // Cancels a pending wait operation without blocking.
 //
 // Acts as (at least) a memory_order_relaxed barrier:
@@ -348,6 +379,15 @@ void iree_notification_commit_wait(iree_notification_t* notification,
 //   guaranteed.
 void iree_notification_cancel_wait(iree_notification_t* notification);
 
+// Commits a pending wait operation like iree_notification_commit_wait but
+// returns false without waiting any longer if |deadline_ns| elapses before a
+// notification has been posted. Returns true if a notification was posted.
+//
+// Acts as (at least) a memory_order_acquire barrier.
+bool iree_notification_commit_wait_until(iree_notification_t* notification,
+                                         iree_wait_token_t wait_token,
+                                         iree_time_t deadline_ns);
+
 // Returns true if the condition is true.
 // |arg| is the |condition_arg| passed to the await function.
 // Implementations must ensure they are coherent with their state values.
@@ -371,6 +411,23 @@ void iree_notification_await(iree_notification_t* notification,
                              iree_condition_fn_t condition_fn,
                              void* condition_arg);
 
+// Blocks and waits until |condition_fn| returns true or |deadline_ns| elapses.
+// Returns the final result of |condition_fn|.
+//
+// Waiters first spin for up to |spin_ns| checking for posts to the
+// notification (with exponential backoff on the processor pause) and only
+// evaluate |condition_fn| when one is observed. If the condition is still not
+// met once spinning has finished the waiter parks in the OS until the
+// notification is posted. This avoids the cost of a context switch on both
+// the waiting and the posting thread when the condition is expected to be met
+// within microseconds. A |spin_ns| of 0 parks immediately like
+// iree_notification_await.
+bool iree_notification_await_until(iree_notification_t* notification,
+                                   iree_condition_fn_t condition_fn,
+                                   void* condition_arg,
+                                   iree_duration_t spin_ns,
+                                   iree_time_t deadline_ns);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
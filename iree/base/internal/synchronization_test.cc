@@ -175,4 +175,60 @@ TEST(SlimMutexTest, ExclusiveAccessTryLock) {
 
 // Tested implicitly in threading_test.cc.
 
+TEST(NotificationTest, IsPosted) {
+  iree_notification_t notification;
+  iree_notification_initialize(&notification);
+  iree_wait_token_t wait_token = iree_notification_prepare_wait(&notification);
+  EXPECT_FALSE(iree_notification_is_posted(&notification, wait_token));
+  iree_notification_post(&notification, IREE_ALL_WAITERS);
+  EXPECT_TRUE(iree_notification_is_posted(&notification, wait_token));
+  // Already posted so this must not block.
+  iree_notification_commit_wait(&notification, wait_token);
+  iree_notification_deinitialize(&notification);
+}
+
+bool IsFlagSet(void* arg) {
+  return iree_atomic_load_int32((iree_atomic_int32_t*)arg,
+                                iree_memory_order_acquire) != 0;
+}
+
+TEST(NotificationTest, AwaitUntilDeadline) {
+  iree_notification_t notification;
+  iree_notification_initialize(&notification);
+  iree_atomic_int32_t flag = IREE_ATOMIC_VAR_INIT(0);
+  // Polls never wait.
+  EXPECT_FALSE(iree_notification_await_until(&notification, IsFlagSet, &flag,
+                                             /*spin_ns=*/1000000,
+                                             IREE_TIME_INFINITE_PAST));
+  // Spinning and parking both stop at the deadline.
+  EXPECT_FALSE(iree_notification_await_until(
+      &notification, IsFlagSet, &flag, /*spin_ns=*/1000000,
+      iree_relative_timeout_to_deadline_ns(100000)));
+  EXPECT_FALSE(iree_notification_await_until(
+      &notification, IsFlagSet, &flag, /*spin_ns=*/0,
+      iree_relative_timeout_to_deadline_ns(1000000)));
+  iree_atomic_store_int32(&flag, 1, iree_memory_order_release);
+  EXPECT_TRUE(iree_notification_await_until(&notification, IsFlagSet, &flag,
+                                            /*spin_ns=*/0,
+                                            IREE_TIME_INFINITE_PAST));
+  iree_notification_deinitialize(&notification);
+}
+
+TEST(NotificationTest, AwaitUntilPosted) {
+  for (iree_duration_t spin_ns : {0ll, 1000000000ll}) {
+    iree_notification_t notification;
+    iree_notification_initialize(&notification);
+    iree_atomic_int32_t flag = IREE_ATOMIC_VAR_INIT(0);
+    std::thread thread([&]() {
+      iree_atomic_store_int32(&flag, 1, iree_memory_order_release);
+      iree_notification_post(&notification, IREE_ALL_WAITERS);
+    });
+    EXPECT_TRUE(iree_notification_await_until(&notification, IsFlagSet, &flag,
+                                              spin_ns,
+                                              IREE_TIME_INFINITE_FUTURE));
+    thread.join();
+    iree_notification_deinitialize(&notification);
+  }
+}
+
 }  // namespace
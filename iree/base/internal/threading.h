@@ -172,6 +172,10 @@ void iree_thread_request_affinity(iree_thread_t* thread,
 // This has no effect if the thread is not suspended.
 void iree_thread_resume(iree_thread_t* thread);
 
+// Yields the remainder of the calling thread's time slice to other threads
+// that are ready to run on the same processor, if any.
+void iree_thread_yield(void);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
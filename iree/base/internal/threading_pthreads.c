@@ -20,6 +20,10 @@
 #include <time.h>
 #include <unistd.h>
 
+#if defined(IREE_PLATFORM_EMSCRIPTEN)
+#include <emscripten/threading.h>
+#endif  // IREE_PLATFORM_EMSCRIPTEN
+
 #include "iree/base/internal/atomics.h"
 #include "iree/base/internal/call_once.h"
 #include "iree/base/internal/synchronization.h"
@@ -58,6 +62,19 @@ static bool iree_thread_resumed_predicate(void* arg) {
                                 iree_memory_order_seq_cst) == 0;
 }
 
+#if defined(IREE_PLATFORM_EMSCRIPTEN)
+
+// Emscripten pthreads are backed by web workers that have no dynamic symbol
+// table to query; the name is only used by the browser devtools.
+static int iree_thread_set_name(pthread_t handle, const char* name) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  emscripten_set_thread_name(handle, name);
+  IREE_TRACE_ZONE_END(z0);
+  return 0;
+}
+
+#else
+
 typedef int (*pthread_setname_np_fn_t)(pthread_t thread, const char* name);
 
 static pthread_setname_np_fn_t iree_pthread_setname_np_fn = NULL;
@@ -80,6 +97,8 @@ static int iree_thread_set_name(pthread_t handle, const char* name) {
   return rc;
 }
 
+#endif  // IREE_PLATFORM_EMSCRIPTEN
+
 static void* iree_thread_start_routine(void* param) {
   // NOTE: we own a reference to the thread handle so that the creation
   // thread can't delete this out from under us.
@@ -298,6 +317,10 @@ void iree_thread_override_end(iree_thread_override_t* override) {
 void iree_thread_request_affinity(iree_thread_t* thread,
                                   iree_thread_affinity_t affinity) {
   if (!affinity.specified) return;
+#if defined(IREE_PLATFORM_EMSCRIPTEN)
+  // Web workers cannot be pinned to cores; the browser schedules them.
+  return;
+#else
   IREE_TRACE_ZONE_BEGIN(z0);
 
   // NOTE: Android uses Linux lightweight processes (LWP) for threads, so the
@@ -313,6 +336,7 @@ void iree_thread_request_affinity(iree_thread_t* thread,
   sched_setaffinity(tid, sizeof(cpu_set), &cpu_set);
 
   IREE_TRACE_ZONE_END(z0);
+#endif  // IREE_PLATFORM_EMSCRIPTEN
 }
 
 void iree_thread_resume(iree_thread_t* thread) {
@@ -326,4 +350,6 @@ void iree_thread_resume(iree_thread_t* thread) {
   IREE_TRACE_ZONE_END(z0);
 }
 
+void iree_thread_yield(void) { sched_yield(); }
+
 #endif  // IREE_PLATFORM_*
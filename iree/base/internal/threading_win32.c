@@ -325,4 +325,6 @@ void iree_thread_resume(iree_thread_t* thread) {
   IREE_TRACE_ZONE_END(z0);
 }
 
+void iree_thread_yield(void) { SwitchToThread(); }
+
 #endif  // IREE_PLATFORM_WINDOWS
@@ -9,58 +9,415 @@
 
 #if IREE_WAIT_API == IREE_WAIT_API_EPOLL
 
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <time.h>
+#include <unistd.h>
+
 #include "iree/base/internal/wait_handle_posix.h"
 #include "iree/base/tracing.h"
 
+//===----------------------------------------------------------------------===//
+// Platform utilities
+//===----------------------------------------------------------------------===//
+
+// Maximum number of ready events harvested from the kernel per epoll_wait
+// during an iree_wait_all. Each wait only returns ready handles so this only
+// bounds the number of syscalls when many handles signal at once.
+#define IREE_WAIT_SET_EPOLL_BATCH_SIZE 64
+
+// Converts |deadline_ns| into an epoll_wait timeout in milliseconds.
+// The timeout is rounded up so that we never wake prior to the deadline.
+static int iree_wait_deadline_to_timeout_ms(iree_time_t deadline_ns) {
+  if (deadline_ns == IREE_TIME_INFINITE_PAST) {
+    return 0;  // block never
+  } else if (deadline_ns == IREE_TIME_INFINITE_FUTURE) {
+    return -1;  // block forever
+  }
+  iree_duration_t timeout_ns = deadline_ns - iree_time_now();
+  if (timeout_ns <= 0) {
+    // We've reached the deadline; we'll still perform the wait though as the
+    // caller is likely expecting that behavior (intentional context
+    // switch/thread yield/etc).
+    return 0;
+  }
+  iree_duration_t timeout_ms = (timeout_ns + 999999ll) / 1000000ll;
+  return timeout_ms > INT_MAX ? INT_MAX : (int)timeout_ms;
+}
+
+// epoll_wait may spuriously wake with an EINTR. We don't do anything with that
+// opportunity (no fancy signal stuff), but we do need to retry the wait and
+// ensure that we do so with an updated timeout based on the deadline.
+//
+// Documentation: https://man7.org/linux/man-pages/man2/epoll_wait.2.html
+static iree_status_t iree_syscall_epoll_wait(int epoll_fd,
+                                             struct epoll_event* events,
+                                             int max_events,
+                                             iree_time_t deadline_ns,
+                                             int* out_signaled_count) {
+  *out_signaled_count = 0;
+  int rv = -1;
+  do {
+    rv = epoll_wait(epoll_fd, events, max_events,
+                    iree_wait_deadline_to_timeout_ms(deadline_ns));
+  } while (rv < 0 && errno == EINTR);
+  if (rv > 0) {
+    // One or more events set.
+    *out_signaled_count = rv;
+    return iree_ok_status();
+  } else if (IREE_UNLIKELY(rv < 0)) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "epoll_wait failure %d", errno);
+  }
+  // rv == 0
+  // Timeout; no events set.
+  return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+}
+
+// Maps an epoll event bitfield result to a status (on failure) and an
+// indicator of whether the event was signaled.
+static iree_status_t iree_wait_set_resolve_epoll_events(uint32_t events,
+                                                        bool* out_signaled) {
+  if (events & EPOLLERR) {
+    return iree_make_status(IREE_STATUS_INTERNAL, "EPOLLERR on fd");
+  } else if (events & EPOLLHUP) {
+    return iree_make_status(IREE_STATUS_CANCELLED, "EPOLLHUP on fd");
+  }
+  *out_signaled = (events & EPOLLIN) != 0;
+  return iree_ok_status();
+}
+
 //===----------------------------------------------------------------------===//
 // iree_wait_set_t
 //===----------------------------------------------------------------------===//
 
-// TODO(benvanik): iree_wait_set_s using an epoll fd.
-// epoll lets us route the wait set operations right to kernel and not need our
-// own duplicate data structure. epoll is great, just not available on mac/ios
-// so we still need poll for that. linux/android/bsd all have epoll, though.
+// epoll lets us route the wait set operations right to the kernel: handles are
+// registered once on insert and unregistered on erase instead of rebuilding
+// the native list each wait, and a wait only returns the handles that are
+// ready. This keeps the cost of a wake proportional to the number of ready
+// handles regardless of how many are in the set. epoll is not available on
+// mac/ios so we still need poll for that.
 struct iree_wait_set_t {
-  // NOTE: we could in theory use the epoll handle directly (iree_wait_set_s
-  // then is just a pointer). Then allocate/free just go straight to the system.
-  int reserved;
+  iree_allocator_t allocator;
+
+  // epoll instance that all unique handles in the set are registered with.
+  // Each registration carries the index of the handle in user_handles as its
+  // user data so that ready events map directly back to the handle.
+  int epoll_fd;
+
+  // Total capacity of handles in the set (including duplicates).
+  iree_host_size_t handle_capacity;
+
+  // Total number of handles in the set (including duplicates).
+  // We use this to ensure that we provide consistent capacity errors.
+  iree_host_size_t total_handle_count;
+
+  // Number of handles in the set (excluding duplicates), defining the valid
+  // size of user_handles.
+  iree_host_size_t handle_count;
+
+  // De-duped user-provided handles. iree_wait_handle_t::set_internal.dupe_count
+  // is used to indicate how many additional duplicates there are of a
+  // particular handle. For example, dupe_count=0 means that there are no
+  // duplicates.
+  iree_wait_handle_t* user_handles;
+
+  // Scratch list of handle indices that iree_wait_all has disarmed after they
+  // signaled and must rearm before returning.
+  uint16_t* disarmed_indices;
 };
 
+// (Re)registers the handle at |index| with the epoll instance.
+// |op| is one of EPOLL_CTL_ADD or EPOLL_CTL_MOD and |events| may be 0 to keep
+// the handle registered without it ever being reported as ready.
+static int iree_wait_set_epoll_ctl(iree_wait_set_t* set, int op,
+                                   iree_host_size_t index, uint32_t events) {
+  int fd = iree_wait_primitive_get_read_fd(&set->user_handles[index]);
+  if (fd < 0) return 0;  // never signals; not registered (as with poll)
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = events;
+  event.data.u64 = index;
+  return epoll_ctl(set->epoll_fd, op, fd, &event);
+}
+
 iree_status_t iree_wait_set_allocate(iree_host_size_t capacity,
                                      iree_allocator_t allocator,
                                      iree_wait_set_t** out_set) {
-  // TODO(benvanik): epoll_create()
+  // Be reasonable; epoll itself scales well past 64K objects but we store
+  // indices in 16 bits.
+  if (capacity >= UINT16_MAX) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "wait set capacity of %zu is unreasonably large",
+                            capacity);
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_host_size_t user_handle_list_size =
+      capacity * iree_sizeof_struct(iree_wait_handle_t);
+  iree_host_size_t disarmed_index_list_size = capacity * sizeof(uint16_t);
+  iree_host_size_t total_size = iree_sizeof_struct(iree_wait_set_t) +
+                                user_handle_list_size +
+                                disarmed_index_list_size;
+
+  iree_wait_set_t* set = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(allocator, total_size, (void**)&set));
+  set->allocator = allocator;
+  set->handle_capacity = capacity;
+  set->total_handle_count = 0;
+  set->handle_count = 0;
+
+  set->user_handles =
+      (iree_wait_handle_t*)((uint8_t*)set +
+                            iree_sizeof_struct(iree_wait_set_t));
+  set->disarmed_indices =
+      (uint16_t*)((uint8_t*)set->user_handles + user_handle_list_size);
+
+  // https://man7.org/linux/man-pages/man2/epoll_create.2.html
+  set->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (IREE_UNLIKELY(set->epoll_fd < 0)) {
+    int error_number = errno;
+    iree_allocator_free(allocator, set);
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(iree_status_code_from_errno(error_number),
+                            "failed to create epoll instance (%d)",
+                            error_number);
+  }
+
+  *out_set = set;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
 }
 
 void iree_wait_set_free(iree_wait_set_t* set) {
-  // TODO(benvanik): close()
+  close(set->epoll_fd);
+  iree_allocator_free(set->allocator, set);
 }
 
 iree_status_t iree_wait_set_insert(iree_wait_set_t* set,
                                    iree_wait_handle_t handle) {
-  // TODO(benvanik): epoll_ctl(EPOLL_CTL_ADD)
+  if (set->total_handle_count + 1 > set->handle_capacity) {
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "wait set capacity reached");
+  }
+
+  // Optimistically register the handle as new. The kernel already tracks the
+  // registered fds and tells us when one is a duplicate so we only need to scan
+  // our own list in that (rare) case.
+  iree_host_size_t index = set->handle_count;
+  iree_wait_handle_t* user_handle = &set->user_handles[index];
+  IREE_IGNORE_ERROR(
+      iree_wait_handle_wrap_primitive(handle.type, handle.value, user_handle));
+  user_handle->set_internal.dupe_count = 0;  // just us so far
+  if (iree_wait_set_epoll_ctl(set, EPOLL_CTL_ADD, index,
+                              EPOLLIN | EPOLLPRI) < 0) {
+    if (errno != EEXIST) {
+      return iree_make_status(iree_status_code_from_errno(errno),
+                              "failed to register fd with epoll (%d)", errno);
+    }
+    // Handle already exists in the set; just increment the reference count.
+    int fd = iree_wait_primitive_get_read_fd(&handle);
+    for (iree_host_size_t i = 0; i < set->handle_count; ++i) {
+      iree_wait_handle_t* existing_handle = &set->user_handles[i];
+      if (iree_wait_primitive_get_read_fd(existing_handle) == fd) {
+        ++existing_handle->set_internal.dupe_count;
+        ++set->total_handle_count;
+        return iree_ok_status();
+      }
+    }
+    return iree_make_status(IREE_STATUS_INTERNAL,
+                            "fd %d registered with epoll but not in the set",
+                            fd);
+  }
+
+  ++set->total_handle_count;
+  ++set->handle_count;
+  return iree_ok_status();
 }
 
 void iree_wait_set_erase(iree_wait_set_t* set, iree_wait_handle_t handle) {
-  // TODO(benvanik): epoll_ctl(EPOLL_CTL_DEL)
+  // Find the user handle in the set. This either requires a linear scan to
+  // find the matching user handle or - if valid - we can use the native index
+  // set after an iree_wait_any wake to do a quick lookup.
+  iree_host_size_t index = handle.set_internal.index;
+  if (IREE_UNLIKELY(index >= set->handle_count) ||
+      IREE_UNLIKELY(!iree_wait_primitive_compare_identical(
+          &set->user_handles[index], &handle))) {
+    // Fallback to a linear scan of the list.
+    index = set->handle_count;
+    for (iree_host_size_t i = 0; i < set->handle_count; ++i) {
+      if (iree_wait_primitive_compare_identical(&set->user_handles[i],
+                                                &handle)) {
+        index = i;
+        break;
+      }
+    }
+    if (IREE_UNLIKELY(index == set->handle_count)) return;  // not found
+  }
+
+  // Decrement reference count.
+  iree_wait_handle_t* existing_handle = &set->user_handles[index];
+  if (existing_handle->set_internal.dupe_count-- > 0) {
+    // Still one or more remaining in the set; leave it registered.
+    --set->total_handle_count;
+    return;
+  }
+
+  // No more references remaining; unregister from the kernel.
+  int fd = iree_wait_primitive_get_read_fd(existing_handle);
+  if (fd >= 0) epoll_ctl(set->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+
+  // Since we make no guarantees about the order of the list we can just swap
+  // with the last value. The moved handle needs its registration updated so
+  // that its events report the new index.
+  iree_host_size_t tail_index = set->handle_count - 1;
+  if (tail_index > index) {
+    memcpy(&set->user_handles[index], &set->user_handles[tail_index],
+           sizeof(*set->user_handles));
+    iree_wait_set_epoll_ctl(set, EPOLL_CTL_MOD, index, EPOLLIN | EPOLLPRI);
+  }
+  --set->total_handle_count;
+  --set->handle_count;
 }
 
 void iree_wait_set_clear(iree_wait_set_t* set) {
-  // TODO(benvanik): close and reopen?
+  for (iree_host_size_t i = 0; i < set->handle_count; ++i) {
+    int fd = iree_wait_primitive_get_read_fd(&set->user_handles[i]);
+    if (fd >= 0) epoll_ctl(set->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+  }
+  set->total_handle_count = 0;
+  set->handle_count = 0;
 }
 
 iree_status_t iree_wait_all(iree_wait_set_t* set, iree_time_t deadline_ns) {
-  // TODO(benvanik): epoll_wait
+  // Make the syscall only when we have at least one valid fd.
+  // Don't use this as a sleep.
+  if (set->handle_count <= 0) {
+    return iree_ok_status();
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // TODO(benvanik): see if we can use tracy's mutex tracking to make waits
+  // nicer (at least showing signal->wait relations).
+
+  // Wait-all requires that we repeatedly wait until all handles have been
+  // signaled. epoll is level-triggered so to avoid seeing the same handles
+  // again we disarm each handle as it signals (keeping it registered) and
+  // rearm all of them once the wait completes. This costs a syscall per
+  // handle but wait-all is rare compared to wait-any.
+  iree_status_t status = iree_ok_status();
+  iree_host_size_t disarmed_count = 0;
+  struct epoll_event events[IREE_WAIT_SET_EPOLL_BATCH_SIZE];
+  while (disarmed_count < set->handle_count) {
+    int signaled_count = 0;
+    status = iree_syscall_epoll_wait(set->epoll_fd, events,
+                                     IREE_ARRAYSIZE(events), deadline_ns,
+                                     &signaled_count);
+    if (!iree_status_is_ok(status)) break;
+    for (int i = 0; i < signaled_count; ++i) {
+      bool signaled = false;
+      status =
+          iree_wait_set_resolve_epoll_events(events[i].events, &signaled);
+      if (!iree_status_is_ok(status)) break;
+      if (!signaled) continue;
+      iree_host_size_t index = (iree_host_size_t)events[i].data.u64;
+      iree_wait_set_epoll_ctl(set, EPOLL_CTL_MOD, index, 0);
+      set->disarmed_indices[disarmed_count++] = (uint16_t)index;
+    }
+    if (!iree_status_is_ok(status)) break;
+  }
+
+  // Rearm all handles we disarmed so that the next wait can see them.
+  for (iree_host_size_t i = 0; i < disarmed_count; ++i) {
+    iree_wait_set_epoll_ctl(set, EPOLL_CTL_MOD, set->disarmed_indices[i],
+                            EPOLLIN | EPOLLPRI);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
 }
 
 iree_status_t iree_wait_any(iree_wait_set_t* set, iree_time_t deadline_ns,
                             iree_wait_handle_t* out_wake_handle) {
-  // TODO(benvanik): epoll_wait
+  // Make the syscall only when we have at least one valid fd.
+  // Don't use this as a sleep.
+  if (set->handle_count <= 0) {
+    memset(out_wake_handle, 0, sizeof(*out_wake_handle));
+    return iree_ok_status();
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // TODO(benvanik): see if we can use tracy's mutex tracking to make waits
+  // nicer (at least showing signal->wait relations).
+
+  // We only need a single ready handle. The kernel round-robins level-triggered
+  // ready handles between waits so repeated wait-any calls on a set with many
+  // ready handles won't starve any of them.
+  struct epoll_event event;
+  int signaled_count = 0;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_syscall_epoll_wait(set->epoll_fd, &event, 1, deadline_ns,
+                                  &signaled_count));
+
+  memset(out_wake_handle, 0, sizeof(*out_wake_handle));
+  if (signaled_count > 0) {
+    bool signaled = false;
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_wait_set_resolve_epoll_events(event.events, &signaled));
+    if (signaled) {
+      iree_host_size_t index = (iree_host_size_t)event.data.u64;
+      memcpy(out_wake_handle, &set->user_handles[index],
+             sizeof(*out_wake_handle));
+      out_wake_handle->set_internal.index = index;
+    }
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
 }
 
 iree_status_t iree_wait_one(iree_wait_handle_t* handle,
                             iree_time_t deadline_ns) {
-  // TODO(benvanik): just use poll?
+  // A single handle doesn't benefit from an epoll instance so we ppoll it
+  // directly. See wait_handle_poll.c for details.
+  struct pollfd poll_fd;
+  poll_fd.fd = iree_wait_primitive_get_read_fd(handle);
+  if (poll_fd.fd == -1) return iree_ok_status();
+  poll_fd.events = POLLIN;
+  poll_fd.revents = 0;
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  int rv = -1;
+  do {
+    struct timespec timeout_ts;
+    struct timespec* tmo_p = &timeout_ts;
+    memset(&timeout_ts, 0, sizeof(timeout_ts));
+    if (deadline_ns == IREE_TIME_INFINITE_FUTURE) {
+      tmo_p = NULL;
+    } else if (deadline_ns != IREE_TIME_INFINITE_PAST) {
+      iree_duration_t timeout_ns = deadline_ns - iree_time_now();
+      if (timeout_ns > 0) {
+        timeout_ts.tv_sec = (time_t)(timeout_ns / 1000000000ull);
+        timeout_ts.tv_nsec = (long)(timeout_ns % 1000000000ull);
+      }
+    }
+    rv = ppoll(&poll_fd, 1, tmo_p, NULL);
+  } while (rv < 0 && errno == EINTR);
+
+  IREE_TRACE_ZONE_END(z0);
+  if (IREE_UNLIKELY(rv < 0)) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "ppoll failure %d", errno);
+  }
+  return rv > 0 ? iree_ok_status()
+                : iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
 }
 
 #endif  // IREE_WAIT_API == IREE_WAIT_API_EPOLL
@@ -41,17 +41,27 @@
 #define IREE_WAIT_API 0  // WFMO used in wait_handle_win32.c
 #else
 
-// TODO(benvanik): EPOLL on android/linux/bsd/etc.
+// The API may be overridden by defining IREE_WAIT_API to one of the values
+// above (such as -DIREE_WAIT_API=2 to force ppoll).
+#if !defined(IREE_WAIT_API)
+
+// TODO(benvanik): EPOLL on bsd/etc.
 // TODO(benvanik): KQUEUE on mac/ios.
 // KQUEUE is not implemented yet. Use POLL for mac/ios
 // Android ppoll requires API version >= 21
-#if !defined(IREE_PLATFORM_APPLE) && !defined(__EMSCRIPTEN__) && \
+#if (defined(IREE_PLATFORM_LINUX) || defined(IREE_PLATFORM_ANDROID)) && \
+    !defined(__EMSCRIPTEN__) &&                                          \
+    (!defined(__ANDROID_API__) || __ANDROID_API__ >= 21)
+#define IREE_WAIT_API IREE_WAIT_API_EPOLL
+#elif !defined(IREE_PLATFORM_APPLE) && !defined(__EMSCRIPTEN__) && \
     (!defined(__ANDROID_API__) || __ANDROID_API__ >= 21)
 #define IREE_WAIT_API IREE_WAIT_API_PPOLL
 #else
 #define IREE_WAIT_API IREE_WAIT_API_POLL
 #endif  // insanity
 
+#endif  // !IREE_WAIT_API
+
 #endif  // IREE_PLATFORM_WINDOWS
 
 //===----------------------------------------------------------------------===//
@@ -10,6 +10,7 @@
 #include <cstddef>
 #include <cstring>
 #include <thread>
+#include <vector>
 
 #include "iree/testing/gtest.h"
 #include "iree/testing/status_matchers.h"
@@ -753,6 +754,47 @@ TEST(WaitSet, WaitAnyEraseSplit) {
   iree_event_deinitialize(&ev_set);
 }
 
+// Tests that sets with many more handles than a single native multi-wait
+// supports on some platforms wake and erase only the signaled handles.
+TEST(WaitSet, WaitAnyManyHandles) {
+  constexpr int kEventCount = 256;
+  std::vector<iree_event_t> events(kEventCount);
+  iree_wait_set_t* wait_set = NULL;
+  IREE_ASSERT_OK(
+      iree_wait_set_allocate(kEventCount, iree_allocator_system(), &wait_set));
+  for (auto& event : events) {
+    IREE_ASSERT_OK(iree_event_initialize(/*initial_state=*/false, &event));
+    IREE_ASSERT_OK(iree_wait_set_insert(wait_set, event));
+  }
+
+  // Signal a few handles spread across the set and ensure each is woken once.
+  const int kSignaledIndices[] = {0, 77, 128, kEventCount - 1};
+  for (int index : kSignaledIndices) iree_event_set(&events[index]);
+  for (size_t i = 0; i < IREE_ARRAYSIZE(kSignaledIndices); ++i) {
+    iree_wait_handle_t wake_handle;
+    IREE_ASSERT_OK(
+        iree_wait_any(wait_set, IREE_TIME_INFINITE_PAST, &wake_handle));
+    int woken_count = 0;
+    for (int index : kSignaledIndices) {
+      if (memcmp(&events[index].value, &wake_handle.value,
+                 sizeof(wake_handle.value)) == 0) {
+        ++woken_count;
+      }
+    }
+    EXPECT_EQ(1, woken_count);
+    iree_wait_set_erase(wait_set, wake_handle);
+  }
+
+  // Only unsignaled handles remain.
+  iree_wait_handle_t wake_handle;
+  IREE_EXPECT_STATUS_IS(
+      IREE_STATUS_DEADLINE_EXCEEDED,
+      iree_wait_any(wait_set, IREE_TIME_INFINITE_PAST, &wake_handle));
+
+  iree_wait_set_free(wait_set);
+  for (auto& event : events) iree_event_deinitialize(&event);
+}
+
 // Tests iree_wait_one when polling (deadline_ns = IREE_TIME_INFINITE_PAST).
 TEST(WaitSet, WaitOnePolling) {
   iree_event_t ev_unset, ev_set;
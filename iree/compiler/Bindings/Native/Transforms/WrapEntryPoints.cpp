@@ -4,6 +4,8 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include "iree/compiler/Dialect/Flow/IR/FlowDialect.h"
+#include "iree/compiler/Dialect/Flow/IR/FlowOps.h"
 #include "iree/compiler/Dialect/HAL/IR/HALDialect.h"
 #include "iree/compiler/Dialect/HAL/IR/HALOps.h"
 #include "llvm/ADT/STLExtras.h"
@@ -29,7 +31,8 @@ class WrapEntryPointsPass
     : public PassWrapper<WrapEntryPointsPass, OperationPass<ModuleOp>> {
  public:
   void getDependentDialects(DialectRegistry &registry) const override {
-    registry.insert<StandardOpsDialect, IREE::HAL::HALDialect,
+    registry.insert<StandardOpsDialect, IREE::Flow::FlowDialect,
+                    IREE::HAL::HALDialect,
                     // TODO: memref is here because the **tensor** dim op was
                     // moved there for some reason. When that goes away we can
                     // drop this dependency.
@@ -78,6 +81,13 @@ class WrapEntryPointsPass
   }
 
  private:
+  // Returns true if tensor result |resultIndex| of |funcOp| is written into
+  // storage provided by the caller.
+  bool hasOutputStorage(FuncOp funcOp, unsigned resultIndex) {
+    return funcOp.getType().getResult(resultIndex).isa<TensorType>() &&
+           funcOp.getResultAttr(resultIndex, "iree.abi.output_storage");
+  }
+
   Type mapToABIType(Type type) {
     if (type.isa<TensorType>()) {
       return IREE::HAL::BufferViewType::get(type.getContext());
@@ -92,6 +102,13 @@ class WrapEntryPointsPass
   // transforms from other bindings can also perform their own equivalent
   // wrapping.
   //
+  // Tensor results with the `iree.abi.output_storage` result attribute take an
+  // additional !hal.buffer_view argument (following all original arguments,
+  // in result order) holding caller-provided storage of the result shape. The
+  // result is written into that storage and the returned buffer view
+  // references it, letting callers reuse their own output buffers across calls
+  // instead of receiving a new allocation from each one.
+  //
   // NOTE: today we only support a single entry point; with minor tweaks we
   // could fix this up to support multiple if we wanted.
   FuncOp createWrapperFunc(FuncOp entryFuncOp) {
@@ -106,8 +123,11 @@ class WrapEntryPointsPass
       inputTypes.push_back(mapToABIType(oldType));
     }
     SmallVector<Type> resultTypes;
-    for (auto oldType : entryFuncType.getResults()) {
-      resultTypes.push_back(mapToABIType(oldType));
+    for (auto oldType : llvm::enumerate(entryFuncType.getResults())) {
+      resultTypes.push_back(mapToABIType(oldType.value()));
+      if (hasOutputStorage(entryFuncOp, oldType.index())) {
+        inputTypes.push_back(IREE::HAL::BufferViewType::get(&getContext()));
+      }
     }
     auto wrapperFuncType =
         FunctionType::get(entryFuncOp.getContext(), inputTypes, resultTypes);
@@ -117,6 +137,7 @@ class WrapEntryPointsPass
 
     SmallVector<DictionaryAttr, 4> argAttrDict;
     entryFuncOp.getAllArgAttrs(argAttrDict);
+    argAttrDict.resize(inputTypes.size(), DictionaryAttr::get(&getContext()));
     wrapperFuncOp.setAllArgAttrs(argAttrDict);
     SmallVector<DictionaryAttr, 4> resultAttrDict;
     entryFuncOp.getAllResultAttrs(resultAttrDict);
@@ -128,8 +149,10 @@ class WrapEntryPointsPass
     auto entryBuilder = OpBuilder::atBlockBegin(entryBlock);
 
     // Marshal arguments.
+    unsigned argumentCount = entryFuncType.getNumInputs();
     SmallVector<Value> arguments;
-    for (auto arg : llvm::enumerate(entryBlock->getArguments())) {
+    for (auto arg : llvm::enumerate(
+             entryBlock->getArguments().take_front(argumentCount))) {
       auto oldType = entryFuncType.getInput(arg.index());
       if (oldType.isa<TensorType>()) {
         arguments.push_back(entryBuilder.create<IREE::HAL::TensorCastOp>(
@@ -144,13 +167,27 @@ class WrapEntryPointsPass
                                               arguments);
 
     // Marshal results.
+    auto storageArgs = entryBlock->getArguments().drop_front(argumentCount);
     SmallVector<Value> results;
     for (auto result : llvm::enumerate(callOp.getResults())) {
       auto oldType = entryFuncType.getResult(result.index());
       auto newType = wrapperFuncType.getResult(result.index());
       if (oldType.isa<TensorType>()) {
+        Value resultValue = result.value();
+        if (hasOutputStorage(entryFuncOp, result.index())) {
+          // Update the caller storage in-place with the full result.
+          auto storageValue = entryBuilder.create<IREE::HAL::TensorCastOp>(
+              entryFuncOp.getLoc(), oldType, storageArgs.front());
+          storageArgs = storageArgs.drop_front();
+          auto zero = entryBuilder.createOrFold<ConstantIndexOp>(
+              entryFuncOp.getLoc(), 0);
+          SmallVector<Value> startIndices(
+              oldType.cast<ShapedType>().getRank(), zero);
+          resultValue = entryBuilder.create<IREE::Flow::TensorUpdateOp>(
+              entryFuncOp.getLoc(), storageValue, startIndices, resultValue);
+        }
         results.push_back(entryBuilder.createOrFold<IREE::HAL::TensorCastOp>(
-            entryFuncOp.getLoc(), newType, result.value()));
+            entryFuncOp.getLoc(), newType, resultValue));
       } else {
         results.push_back(result.value());
       }
@@ -36,3 +36,21 @@ func @wrappedAlready(%arg0: !hal.buffer_view) -> !hal.buffer_view attributes {ir
   return %arg0 : !hal.buffer_view
 }
 // CHECK-NOT: func @_wrappedAlready
+
+// -----
+
+// CHECK-LABEL: func @outputStorage(
+//  CHECK-SAME:   %[[ARG0:.+]]: !hal.buffer_view, %[[STORAGE:.+]]: !hal.buffer_view
+//  CHECK-SAME: ) -> (!hal.buffer_view {iree.abi.output_storage})
+//       CHECK:   %[[ARG0_TENSOR:.+]] = hal.tensor.cast %[[ARG0]] : !hal.buffer_view -> tensor<4xf32>
+//  CHECK-NEXT:   %[[RET_TENSOR:.+]] = call @_outputStorage(%[[ARG0_TENSOR]])
+//  CHECK-NEXT:   %[[STORAGE_TENSOR:.+]] = hal.tensor.cast %[[STORAGE]] : !hal.buffer_view -> tensor<4xf32>
+//       CHECK:   %[[UPDATE:.+]] = flow.tensor.update %[[RET_TENSOR]], %[[STORAGE_TENSOR]]
+//  CHECK-NEXT:   %[[RET_VIEW:.+]] = hal.tensor.cast %[[UPDATE]] : tensor<4xf32> -> !hal.buffer_view
+//  CHECK-NEXT:   return %[[RET_VIEW]] : !hal.buffer_view
+
+// CHECK-LABEL: func private @_outputStorage(
+func @outputStorage(%arg0: tensor<4xf32>) -> (tensor<4xf32> {iree.abi.output_storage}) {
+  %0 = "mhlo.add"(%arg0, %arg0) : (tensor<4xf32>, tensor<4xf32>) -> tensor<4xf32>
+  return %0 : tensor<4xf32>
+}
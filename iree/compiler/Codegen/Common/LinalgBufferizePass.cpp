@@ -142,7 +142,9 @@ class BufferizationPlan {
 
   /// Queries if the value `v` is in the same equivalence class as the result of
   /// the dispatch region.
-  bool isInStoreSet(Value v) { return storeLeaders.count(getLeaderValue(v)); }
+  bool isInStoreSet(Value v) const {
+    return storeLeaders.count(getLeaderValue(v));
+  }
 
   void dump() {
     llvm::dbgs() << "BufferMappings : \n";
@@ -883,32 +885,137 @@ static Value getTiedResultForOperand(OpOperand &operand,
   return nullptr;
 }
 
+static Value getInplaceResultBuffer(OpBuilder &b, OpResult resultValue,
+                                    const BufferizationPlan &plan,
+                                    BlockAndValueMapping &bvm);
+
+/// Returns true if the slices written by `lhs` and `rhs` are statically known
+/// not to overlap.
+static bool areDisjointSlices(tensor::InsertSliceOp lhs,
+                              tensor::InsertSliceOp rhs) {
+  auto getStaticValue = [](OpFoldResult valueOrAttr) -> Optional<int64_t> {
+    if (auto attr = valueOrAttr.dyn_cast<Attribute>()) {
+      return attr.cast<IntegerAttr>().getInt();
+    }
+    return llvm::None;
+  };
+  // Returns the [begin, end) range of dimension `dim` written by `op`.
+  auto getRange =
+      [&](tensor::InsertSliceOp op,
+          unsigned dim) -> Optional<std::pair<int64_t, int64_t>> {
+    auto offset = getStaticValue(op.getMixedOffsets()[dim]);
+    auto size = getStaticValue(op.getMixedSizes()[dim]);
+    auto stride = getStaticValue(op.getMixedStrides()[dim]);
+    if (!offset || !size || !stride || *size <= 0) return llvm::None;
+    return std::make_pair(*offset, *offset + (*size - 1) * *stride + 1);
+  };
+  if (lhs.getType().getRank() != rhs.getType().getRank()) return false;
+  for (unsigned dim = 0, e = lhs.getType().getRank(); dim < e; ++dim) {
+    auto lhsRange = getRange(lhs, dim);
+    auto rhsRange = getRange(rhs, dim);
+    if (!lhsRange || !rhsRange) continue;
+    if (lhsRange->second <= rhsRange->first ||
+        rhsRange->second <= lhsRange->first) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/// Returns true if the value inserted by `insertOp` can be computed directly
+/// into the buffer of its `dest` by `ops` (the operations computing the
+/// inserted value). This requires the part of the `dest` buffer covered by the
+/// slice to be fully written before any of `ops` runs and that none of `ops`
+/// reads the `dest` buffer.
+static bool canComputeInsertedSliceInPlace(tensor::InsertSliceOp insertOp,
+                                           ArrayRef<Operation *> ops,
+                                           const BufferizationPlan &plan,
+                                           const BlockAndValueMapping &bvm) {
+  Value dest = insertOp.dest();
+  if (!plan.isEquivalent(dest, insertOp.result()) || !bvm.contains(dest) ||
+      insertOp.getSourceType().getRank() != insertOp.getType().getRank()) {
+    return false;
+  }
+  // Inserts of other slices into the same buffer (such as the other operands
+  // of a concatenation) may run after `ops` as they do not clobber the slice.
+  Value writtenDest = dest;
+  while (auto prevInsertOp =
+             writtenDest.getDefiningOp<tensor::InsertSliceOp>()) {
+    if (!areDisjointSlices(prevInsertOp, insertOp)) break;
+    writtenDest = prevInsertOp.dest();
+  }
+  Operation *destOp = writtenDest.getDefiningOp();
+  for (Operation *op : ops) {
+    if (llvm::any_of(op->getOperands(), [&](Value operand) {
+          return plan.isEquivalent(operand, dest);
+        })) {
+      return false;
+    }
+    // Init tensors only define the shape and never write the buffer.
+    if (!destOp || isa<linalg::InitTensorOp>(op)) continue;
+    Operation *ancestor = destOp->getBlock()->findAncestorOpInBlock(*op);
+    if (!ancestor || !destOp->isBeforeInBlock(ancestor)) return false;
+  }
+  return true;
+}
+
 /// To perform updates directly into the result buffer, the uses need to be
 /// walked to get to a value already mapped to a buffer or a
 /// `flow.dispatch.tensor.store` operation. For each use, gets the tied result
 /// and follow its uses. The traversed uses and thir tied results are returned
 /// in `traversedUses`.
+///
+/// Values that end up as the `source` of a `tensor.insert_slice` (such as the
+/// operands of a concatenation) are computed directly into the subview of the
+/// `dest` buffer the slice is inserted into, avoiding the copy.
 static Value walkUseToGetResultBuffer(
     OpBuilder &b, Value value, const BufferizationPlan &plan,
-    const BlockAndValueMapping &bvm,
+    BlockAndValueMapping &bvm,
     SmallVectorImpl<std::pair<OpOperand *, Value>> &traversedUses) {
   Operation *user = nullptr;
+  SmallVector<Operation *> computeOps;
+  if (Operation *definingOp = value.getDefiningOp()) {
+    computeOps.push_back(definingOp);
+  }
   while (value.hasOneUse()) {
     OpOperand &use = *value.use_begin();
     user = use.getOwner();
     if (isa<IREE::Flow::DispatchTensorStoreOp>(user)) {
       return getSubviewOpForTensorStoreOp(b, user, bvm);
     }
+    auto insertOp = dyn_cast<tensor::InsertSliceOp>(user);
+    if (insertOp && insertOp.source() == value &&
+        !plan.isEquivalent(value, insertOp.result())) {
+      // The destination may not have been mapped yet if it is only defined by
+      // a `linalg.init_tensor` (such as the result of a concatenation).
+      auto destResult = insertOp.dest().dyn_cast<OpResult>();
+      if (destResult && !bvm.contains(destResult) &&
+          plan.isInStoreSet(destResult)) {
+        if (Value destBuffer =
+                getInplaceResultBuffer(b, destResult, plan, bvm)) {
+          bvm.map(destResult, destBuffer);
+        }
+      }
+      if (!canComputeInsertedSliceInPlace(insertOp, computeOps, plan, bvm)) {
+        return nullptr;
+      }
+      return getSubviewOpForTensorStoreOp(b, user, bvm);
+    }
+    computeOps.push_back(user);
     value = getTiedResultForOperand(use, plan);
     if (!value) return nullptr;
     traversedUses.push_back(std::make_pair(&use, value));
+    // Only the result buffer of the dispatch is shared along the use chain;
+    // other values are only computed in place into inserted slices.
+    if (!plan.isInStoreSet(value)) continue;
     if (auto resultBuffer = bvm.lookupOrNull(value)) return resultBuffer;
   }
   return nullptr;
 }
 
-/// For an operation whose `resultValue` is the result of the dispatch region,
-/// gets the buffer to use to compute the value in-place.
+/// For an operation whose `resultValue` is the result of the dispatch region
+/// or a slice inserted into another tensor, gets the buffer to use to compute
+/// the value in-place.
 static Value getInplaceResultBuffer(OpBuilder &b, OpResult resultValue,
                                     const BufferizationPlan &plan,
                                     BlockAndValueMapping &bvm) {
@@ -1112,7 +1219,7 @@ static LogicalResult getOrAllocateResultBuffers(
         hasTiedOperandForResult(result.value(), plan)) {
       buffer = aliasingBuffers[result.index()];
     }
-    if (!buffer && plan.isInStoreSet(result.value())) {
+    if (!buffer) {
       buffer = getInplaceResultBuffer(b, result.value(), plan, bvm);
     }
     if (!buffer) {
@@ -1291,12 +1398,22 @@ static LogicalResult convertSubTensorInsertOp(OpBuilder &b,
     return success();
   }
 
-  // Copy from the source to the result subview.
+  // The source may have been computed directly into the result subview.
   ShapedType sourceType = op.getSourceType();
   Value sourceBuffer = bvm.lookup(source);
   SmallVector<OpFoldResult> offsets = op.getMixedOffsets();
   SmallVector<OpFoldResult> sizes = op.getMixedSizes();
   SmallVector<OpFoldResult> strides = op.getMixedStrides();
+  if (auto subViewOp = sourceBuffer.getDefiningOp<memref::SubViewOp>()) {
+    if (subViewOp.source() == resultBuffer &&
+        subViewOp.getMixedOffsets() == offsets &&
+        subViewOp.getMixedSizes() == sizes &&
+        subViewOp.getMixedStrides() == strides) {
+      return success();
+    }
+  }
+
+  // Copy from the source to the result subview.
   MemRefType subViewResultType =
       (sourceType.getRank() < resultType.getRank()
            ? memref::SubViewOp::inferRankReducedResultType(
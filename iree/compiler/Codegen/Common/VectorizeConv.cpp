@@ -10,6 +10,7 @@
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/Debug.h"
 #include "mlir/Dialect/Linalg/IR/LinalgOps.h"
+#include "mlir/Dialect/Linalg/Transforms/Transforms.h"
 #include "mlir/Dialect/MemRef/IR/MemRef.h"
 #include "mlir/Dialect/StandardOps/IR/Ops.h"
 #include "mlir/Dialect/Utils/StructuredOpsUtils.h"
@@ -49,12 +50,19 @@ namespace {
 /// channel size requirement.
 struct VectorizeLinalgConv
     : OpRewritePattern<linalg::ConvInputNHWCFilterHWCFOp> {
-  using OpRewritePattern::OpRewritePattern;
+  VectorizeLinalgConv(
+      MLIRContext *context,
+      Optional<linalg::LinalgTransformationFilter> filter = llvm::None)
+      : OpRewritePattern(context), filter(std::move(filter)) {}
 
   LogicalResult matchAndRewrite(linalg::ConvInputNHWCFilterHWCFOp convOp,
                                 PatternRewriter &rewriter) const override {
     LLVM_DEBUG(llvm::dbgs() << "inspecting " << convOp << "\n");
 
+    if (filter && failed(filter->checkAndNotify(rewriter, convOp))) {
+      return failure();
+    }
+
     // This pattern does not handle convolutions with dilation.
     if (auto dilations = convOp.dilations()) {
       auto values = dilations.getIntValues();
@@ -204,6 +212,9 @@ struct VectorizeLinalgConv
     rewriter.eraseOp(convOp);
     return success();
   }
+
+ private:
+  Optional<linalg::LinalgTransformationFilter> filter;
 };
 
 /// Vectorizes linalg.depthwise_conv_2d_input_nhwc_filter_hwc for a single GPU
@@ -228,13 +239,20 @@ struct VectorizeLinalgConv
 /// load4/store4, which is native to GPUs.
 struct VectorizeLinalgDepthwiseConv
     : OpRewritePattern<linalg::DepthwiseConvInputNHWCFilterHWCOp> {
-  using OpRewritePattern::OpRewritePattern;
+  VectorizeLinalgDepthwiseConv(
+      MLIRContext *context,
+      Optional<linalg::LinalgTransformationFilter> filter = llvm::None)
+      : OpRewritePattern(context), filter(std::move(filter)) {}
 
   LogicalResult matchAndRewrite(
       linalg::DepthwiseConvInputNHWCFilterHWCOp convOp,
       PatternRewriter &rewriter) const override {
     LLVM_DEBUG(llvm::dbgs() << "inspecting " << convOp << "\n");
 
+    if (filter && failed(filter->checkAndNotify(rewriter, convOp))) {
+      return failure();
+    }
+
     auto inputViewOp =
         convOp.getInputOperand(0)->get().getDefiningOp<memref::SubViewOp>();
     auto filterViewOp =
@@ -333,6 +351,9 @@ struct VectorizeLinalgDepthwiseConv
     rewriter.eraseOp(convOp);
     return success();
   }
+
+ private:
+  Optional<linalg::LinalgTransformationFilter> filter;
 };
 
 struct LinalgToVectorVectorizeConvPass
@@ -352,8 +373,10 @@ struct LinalgToVectorVectorizeConvPass
 }  // namespace
 
 void populateLinalgToVectorVectorizeConvPatterns(
-    MLIRContext *context, OwningRewritePatternList &patterns) {
-  patterns.insert<VectorizeLinalgConv, VectorizeLinalgDepthwiseConv>(context);
+    MLIRContext *context, OwningRewritePatternList &patterns,
+    Optional<linalg::LinalgTransformationFilter> filter) {
+  patterns.insert<VectorizeLinalgConv, VectorizeLinalgDepthwiseConv>(context,
+                                                                     filter);
 }
 
 std::unique_ptr<OperationPass<FuncOp>> createLinalgToVectorVectorizeConvPass() {
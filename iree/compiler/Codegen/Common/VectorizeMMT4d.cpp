@@ -6,6 +6,7 @@
 
 #include "iree/compiler/Codegen/PassDetail.h"
 #include "mlir/Dialect/Linalg/IR/LinalgOps.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
 #include "mlir/Dialect/Vector/VectorOps.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 
@@ -16,7 +17,11 @@ namespace {
 
 /// A pattern to convert tiled linalg.mmt4d into vector contract.
 /// This converts linalg.mmt4d with operands <1x1xM0xK0>, <1x1xK0,N0>
-/// to vector.contract where K0 is the contraction dimension.
+/// to vector.contract where K0 is the contraction dimension. Operands with a
+/// narrower element type than the accumulator (such as i8 x i8 -> i32 or
+/// bf16 x bf16 -> f32) are extended to the accumulator type before the
+/// contraction as done by linalg.mmt4d itself; target-specific patterns can
+/// fold the extension into mixed precision dot product instructions.
 struct VectorizeMMT4DOp : public OpRewritePattern<linalg::Mmt4DOp> {
   using OpRewritePattern<linalg::Mmt4DOp>::OpRewritePattern;
 
@@ -27,10 +32,11 @@ struct VectorizeMMT4DOp : public OpRewritePattern<linalg::Mmt4DOp> {
     auto dst = mmt4DOp.outputs()[0];
 
     auto lhsType = lhs.getType().dyn_cast<ShapedType>();
-    auto rhsType = lhs.getType().dyn_cast<ShapedType>();
+    auto rhsType = rhs.getType().dyn_cast<ShapedType>();
+    auto dstType = dst.getType().dyn_cast<ShapedType>();
 
-    if (!lhsType || !rhsType || !lhsType.hasStaticShape() ||
-        !rhsType.hasStaticShape())
+    if (!lhsType || !rhsType || !dstType || !lhsType.hasStaticShape() ||
+        !rhsType.hasStaticShape() || !dstType.hasStaticShape())
       return failure();
 
     int M1 = lhsType.getShape()[0];
@@ -46,28 +52,40 @@ struct VectorizeMMT4DOp : public OpRewritePattern<linalg::Mmt4DOp> {
     auto loc = mmt4DOp.getLoc();
     auto c0 = rewriter.create<ConstantIndexOp>(loc, 0);
 
-    auto vecType = VectorType::get({1, 1, M0, N0}, rewriter.getF32Type());
+    Type lhsElementType = lhsType.getElementType();
+    Type rhsElementType = rhsType.getElementType();
+    Type dstElementType = dstType.getElementType();
+    if (!canExtend(lhsElementType, dstElementType) ||
+        !canExtend(rhsElementType, dstElementType)) {
+      return failure();
+    }
+
+    auto lhsVecType = VectorType::get({1, 1, M0, K0}, lhsElementType);
+    auto rhsVecType = VectorType::get({1, 1, K0, N0}, rhsElementType);
+    auto vecType = VectorType::get({1, 1, M0, N0}, dstElementType);
 
-    auto lhsVecType2D = VectorType::get({M0, K0}, rewriter.getF32Type());
-    auto rhsVecType2D = VectorType::get({K0, N0}, rewriter.getF32Type());
-    auto dstVecType2D = VectorType::get({M0, N0}, rewriter.getF32Type());
+    auto lhsVecType2D = VectorType::get({M0, K0}, lhsElementType);
+    auto rhsVecType2D = VectorType::get({K0, N0}, rhsElementType);
+    auto dstVecType2D = VectorType::get({M0, N0}, dstElementType);
 
     auto identityMap = rewriter.getMultiDimIdentityMap(4);
 
     auto lhsVec = rewriter.create<vector::TransferReadOp>(
-        loc, vecType, lhs, ValueRange{c0, c0, c0, c0}, identityMap);
+        loc, lhsVecType, lhs, ValueRange{c0, c0, c0, c0}, identityMap);
 
     auto rhsVec = rewriter.create<vector::TransferReadOp>(
-        loc, vecType, rhs, ValueRange{c0, c0, c0, c0}, identityMap);
+        loc, rhsVecType, rhs, ValueRange{c0, c0, c0, c0}, identityMap);
 
     auto dstVec = rewriter.create<vector::TransferReadOp>(
         loc, vecType, dst, ValueRange{c0, c0, c0, c0}, identityMap);
 
     Value lhsVec2D =
         rewriter.create<vector::ShapeCastOp>(loc, lhsVecType2D, lhsVec);
+    lhsVec2D = extendTo(loc, lhsVec2D, dstElementType, rewriter);
 
     Value rhsVec2D =
         rewriter.create<vector::ShapeCastOp>(loc, rhsVecType2D, rhsVec);
+    rhsVec2D = extendTo(loc, rhsVec2D, dstElementType, rewriter);
 
     Value dstVec2D =
         rewriter.create<vector::ShapeCastOp>(loc, dstVecType2D, dstVec);
@@ -97,7 +115,32 @@ struct VectorizeMMT4DOp : public OpRewritePattern<linalg::Mmt4DOp> {
         identityMap);
 
     return success();
-    ;
+  }
+
+ private:
+  /// Returns true if values of `fromType` can be extended to `toType`.
+  static bool canExtend(Type fromType, Type toType) {
+    if (fromType == toType) return true;
+    if (fromType.isa<IntegerType>() && toType.isa<IntegerType>()) {
+      return fromType.getIntOrFloatBitWidth() < toType.getIntOrFloatBitWidth();
+    }
+    if (fromType.isa<FloatType>() && toType.isa<FloatType>()) {
+      return fromType.getIntOrFloatBitWidth() < toType.getIntOrFloatBitWidth();
+    }
+    return false;
+  }
+
+  /// Extends the elements of `vector` to `elementType`. Integers are sign
+  /// extended to match the semantics of linalg.mmt4d.
+  static Value extendTo(Location loc, Value vector, Type elementType,
+                        PatternRewriter &rewriter) {
+    auto vectorType = vector.getType().cast<VectorType>();
+    if (vectorType.getElementType() == elementType) return vector;
+    auto extendedType = VectorType::get(vectorType.getShape(), elementType);
+    if (elementType.isa<IntegerType>()) {
+      return rewriter.create<SignExtendIOp>(loc, extendedType, vector);
+    }
+    return rewriter.create<FPExtOp>(loc, extendedType, vector);
   }
 };
 
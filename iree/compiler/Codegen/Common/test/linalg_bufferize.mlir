@@ -2404,3 +2404,52 @@ func @linalg_ext_sort_1d() {
 //       CHECK:   linalg_ext.sort
 //  CHECK-SAME:     dimension(0)
 //  CHECK-SAME:     outs(%[[INOUT]] : memref<128xi32>)
+
+// -----
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+func @concatenate_in_place() {
+  %c0 = constant 0 : index
+  %0 = hal.interface.binding.subspan @io::@arg0[%c0] : !flow.dispatch.tensor<readonly:2x3xf32>
+  %1 = hal.interface.binding.subspan @io::@arg1[%c0] : !flow.dispatch.tensor<readonly:2x3xf32>
+  %2 = hal.interface.binding.subspan @io::@ret0[%c0] : !flow.dispatch.tensor<writeonly:2x6xf32>
+  %3 = flow.dispatch.tensor.load %0, offsets = [], sizes = [], strides = [] : !flow.dispatch.tensor<readonly:2x3xf32> -> tensor<2x3xf32>
+  %4 = flow.dispatch.tensor.load %1, offsets = [], sizes = [], strides = [] : !flow.dispatch.tensor<readonly:2x3xf32> -> tensor<2x3xf32>
+  %5 = linalg.init_tensor [2, 6] : tensor<2x6xf32>
+  %6 = linalg.init_tensor [2, 3] : tensor<2x3xf32>
+  %7 = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]}
+      ins(%3 : tensor<2x3xf32>) outs(%6 : tensor<2x3xf32>) {
+  ^bb0(%arg0: f32, %arg1: f32):  // no predecessors
+    %11 = addf %arg0, %arg0 : f32
+    linalg.yield %11 : f32
+  } -> tensor<2x3xf32>
+  %8 = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]}
+      ins(%4 : tensor<2x3xf32>) outs(%6 : tensor<2x3xf32>) {
+  ^bb0(%arg0: f32, %arg1: f32):  // no predecessors
+    %11 = mulf %arg0, %arg0 : f32
+    linalg.yield %11 : f32
+  } -> tensor<2x3xf32>
+  %9 = tensor.insert_slice %7 into %5[0, 0] [2, 3] [1, 1] : tensor<2x3xf32> into tensor<2x6xf32>
+  %10 = tensor.insert_slice %8 into %9[0, 3] [2, 3] [1, 1] : tensor<2x3xf32> into tensor<2x6xf32>
+  flow.dispatch.tensor.store %10, %2, offsets = [], sizes = [], strides = [] : tensor<2x6xf32> -> !flow.dispatch.tensor<writeonly:2x6xf32>
+  return
+}
+hal.interface @io attributes {sym_visibility = "private"} {
+  hal.interface.binding @arg0, set=0, binding=0, type="StorageBuffer", access="Read"
+  hal.interface.binding @arg1, set=0, binding=1, type="StorageBuffer", access="Read"
+  hal.interface.binding @ret0, set=0, binding=2, type="StorageBuffer", access="Write|Discard"
+}
+// CHECK-LABEL: func @concatenate_in_place()
+//   CHECK-DAG:   %[[ARG0:.+]] = hal.interface.binding.subspan @io::@arg0
+//   CHECK-DAG:   %[[ARG1:.+]] = hal.interface.binding.subspan @io::@arg1
+//   CHECK-DAG:   %[[RET0:.+]] = hal.interface.binding.subspan @io::@ret0
+//       CHECK:   %[[LHS:.+]] = memref.subview %[[RET0]][0, 0] [2, 3] [1, 1]
+//       CHECK:   linalg.generic
+//  CHECK-SAME:     ins(%[[ARG0]] : memref<2x3xf32>)
+//  CHECK-SAME:     outs(%[[LHS]] :
+//       CHECK:   %[[RHS:.+]] = memref.subview %[[RET0]][0, 3] [2, 3] [1, 1]
+//       CHECK:   linalg.generic
+//  CHECK-SAME:     ins(%[[ARG1]] : memref<2x3xf32>)
+//  CHECK-SAME:     outs(%[[RHS]] :
+//   CHECK-NOT:   linalg.copy
+//   CHECK-NOT:   memref.alloc
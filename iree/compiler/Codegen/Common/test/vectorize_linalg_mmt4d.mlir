@@ -21,3 +21,22 @@ func @tiled_mmt4d(%lhs: memref<1x1x4x4xf32>, %rhs: memref<1x1x4x4xf32>, %dst: me
 // CHECK-SAME:        %[[LHS_2DVEC]], %[[RHS_2DVEC]], %[[DST_2DVEC]] : vector<4x4xf32>, vector<4x4xf32> into vector<4x4xf32>
 //      CHECK:   %[[RESULT_4D:.+]] = vector.shape_cast %[[RESULT_2D]] : vector<4x4xf32> to vector<1x1x4x4xf32>
 
+
+// -----
+
+func @tiled_mmt4d_i8i8i32(%lhs: memref<1x1x8x4xi8>, %rhs: memref<1x1x4x4xi8>, %dst: memref<1x1x8x4xi32>) {
+    linalg.mmt4d ins(%lhs, %rhs: memref<1x1x8x4xi8>, memref<1x1x4x4xi8>) outs(%dst: memref<1x1x8x4xi32>)
+    return
+}
+
+// CHECK: func @tiled_mmt4d_i8i8i32(%[[LHS:.+]]: memref<1x1x8x4xi8>, %[[RHS:.+]]: memref<1x1x4x4xi8>, %[[DST:.+]]: memref<1x1x8x4xi32>
+//      CHECK:   %[[LHS_4DVEC:.+]] = vector.transfer_read %[[LHS]]{{.*}} : memref<1x1x8x4xi8>, vector<1x1x8x4xi8>
+//      CHECK:   %[[RHS_4DVEC:.+]] = vector.transfer_read %[[RHS]]{{.*}} : memref<1x1x4x4xi8>, vector<1x1x4x4xi8>
+//      CHECK:   %[[DST_4DVEC:.+]] = vector.transfer_read %[[DST]]{{.*}} : memref<1x1x8x4xi32>, vector<1x1x8x4xi32>
+//      CHECK:   %[[LHS_2DVEC:.+]] = vector.shape_cast %[[LHS_4DVEC]] : vector<1x1x8x4xi8> to vector<8x4xi8>
+//      CHECK:   %[[LHS_EXT:.+]] = sexti %[[LHS_2DVEC]] : vector<8x4xi8> to vector<8x4xi32>
+//      CHECK:   %[[RHS_2DVEC:.+]] = vector.shape_cast %[[RHS_4DVEC]] : vector<1x1x4x4xi8> to vector<4x4xi8>
+//      CHECK:   %[[RHS_EXT:.+]] = sexti %[[RHS_2DVEC]] : vector<4x4xi8> to vector<4x4xi32>
+//      CHECK:   %[[DST_2DVEC:.+]] = vector.shape_cast %[[DST_4DVEC]] : vector<1x1x8x4xi32> to vector<8x4xi32>
+//      CHECK:   %[[RESULT_2D:.+]] = vector.contract
+// CHECK-SAME:        %[[LHS_EXT]], %[[RHS_EXT]], %[[DST_2DVEC]] : vector<8x4xi32>, vector<4x4xi32> into vector<8x4xi32>
@@ -6,6 +6,10 @@
 
 #include "iree/compiler/Codegen/LLVMCPU/KernelDispatch.h"
 
+#include <limits>
+
+#include "iree/compiler/Codegen/LLVMCPU/TuningDatabase.h"
+#include "iree/compiler/Codegen/Passes.h"
 #include "iree/compiler/Codegen/Transforms/Transforms.h"
 #include "iree/compiler/Codegen/Utils/MarkerUtils.h"
 #include "iree/compiler/Codegen/Utils/Utils.h"
@@ -14,6 +18,7 @@
 #include "iree/compiler/Dialect/LinalgExt/IR/LinalgExtOps.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MathExtras.h"
 #include "mlir/Dialect/Linalg/IR/LinalgInterfaces.h"
 #include "mlir/Dialect/Linalg/IR/LinalgOps.h"
 #include "mlir/Dialect/Linalg/Transforms/Transforms.h"
@@ -45,6 +50,23 @@ static llvm::cl::opt<int> matmulL1TileSize(
 static llvm::cl::opt<int> matmulVectorSize(
     "iree-codegen-llvm-matmul-vector-size",
     llvm::cl::desc("linalg.matmul vector tile size"), llvm::cl::init(4));
+static llvm::cl::opt<int> matmulMaxPaddingPercent(
+    "iree-codegen-llvm-matmul-max-padding-percent",
+    llvm::cl::desc("Largest padding, as a percentage of the dimension size, "
+                   "added to the partial tiles of statically shaped "
+                   "linalg.matmul dimensions that are not multiples of the "
+                   "vector size; dimensions needing more are peeled"),
+    llvm::cl::init(10));
+static llvm::cl::opt<int> matmulMatvecMaxM(
+    "iree-codegen-llvm-matmul-matvec-max-m",
+    llvm::cl::desc("Largest static M of the linalg.matmul ops configured as "
+                   "matrix-vector products"),
+    llvm::cl::init(4));
+static llvm::cl::opt<int> matmulMatvecVectorSize(
+    "iree-codegen-llvm-matmul-matvec-vector-size",
+    llvm::cl::desc("N vector size of the linalg.matmul ops configured as "
+                   "matrix-vector products"),
+    llvm::cl::init(16));
 
 static llvm::cl::opt<int> batchMatmulWorkgroupTileSize(
     "iree-codegen-llvm-batch-matmul-workgroup-size",
@@ -75,12 +97,184 @@ static llvm::cl::list<int> mmt4dVectorSizes(
     llvm::cl::desc("linalg.mmt4d vector tile size"), llvm::cl::ZeroOrMore,
     llvm::cl::MiscFlags::CommaSeparated);
 
+static llvm::cl::opt<int> riscvVectorLMUL(
+    "iree-codegen-llvm-riscv-vector-lmul",
+    llvm::cl::desc("Vector register group multiplier (LMUL) used to size the "
+                   "vectors of RISC-V targets with the vector extension; each "
+                   "native vector spans LMUL registers of VLEN bits"),
+    llvm::cl::init(2));
+
+static llvm::cl::opt<int> aarch64SVEVectorBits(
+    "iree-codegen-llvm-aarch64-sve-vector-bits",
+    llvm::cl::desc("Vector length in bits of the SVE implementations targeted "
+                   "by AArch64 targets with SVE, used to size their vectors; "
+                   "must not exceed the -aarch64-sve-vector-bits-min given to "
+                   "LLVM. 0 keeps the 128-bit NEON sizes"),
+    llvm::cl::init(0));
+
 static llvm::cl::opt<int> defaultWorkgroupTileSize(
     "iree-codegen-llvm-generic-ops-workgroup-size",
     llvm::cl::desc(
         "linalg.generic and linalg.indexed_generic workgroup tile size"),
     llvm::cl::init(64));
 
+static llvm::cl::opt<std::string> clTuningDatabase(
+    "iree-codegen-llvm-tuning-database",
+    llvm::cl::desc("Path to a JSON tuning database with tuned tile sizes that "
+                   "take precedence over the default heuristics for "
+                   "linalg.matmul, linalg.batch_matmul and linalg.mmt4d ops"),
+    llvm::cl::init(""));
+
+static llvm::cl::opt<bool> clPrintTuningCandidates(
+    "iree-codegen-llvm-print-tuning-candidates",
+    llvm::cl::desc("Emits a remark with the tuning database entry of the "
+                   "configuration selected for each tunable op; used by "
+                   "tuning tools to discover the ops to tune"),
+    llvm::cl::init(false));
+
+/// Returns the tuning database specified by the flags, loading it upon first
+/// use. Returns nullptr and sets `errorMessage` if it could not be loaded.
+static const TuningDatabase *getTuningDatabase(std::string &errorMessage) {
+  static std::string loadErrorMessage;
+  static std::unique_ptr<TuningDatabase> database =
+      TuningDatabase::load(clTuningDatabase, loadErrorMessage);
+  errorMessage = loadErrorMessage;
+  return database.get();
+}
+
+/// Sets the lowering configuration of a tunable `op`. A configuration for the
+/// op in the tuning database takes precedence over the given heuristically
+/// selected `tileSizes` and `nativeVectorSize`.
+static LogicalResult setTunableOpConfig(
+    FuncOp entryPointFn, Operation *op, TileSizesListTypeRef tileSizes,
+    ArrayRef<int64_t> nativeVectorSize,
+    IREE::HAL::DispatchLoweringPassPipeline passPipeline =
+        IREE::HAL::DispatchLoweringPassPipeline::CPUVectorization) {
+  TuningConfig config;
+  config.tileSizes.assign(tileSizes.begin(), tileSizes.end());
+  config.nativeVectorSize.assign(nativeVectorSize.begin(),
+                                 nativeVectorSize.end());
+  if (!clTuningDatabase.empty() || clPrintTuningCandidates) {
+    TuningKey key = TuningKey::get(op);
+    if (!clTuningDatabase.empty()) {
+      std::string errorMessage;
+      const TuningDatabase *database = getTuningDatabase(errorMessage);
+      if (!database) return op->emitError(errorMessage);
+      if (const TuningConfig *tunedConfig = database->lookup(key)) {
+        config = *tunedConfig;
+      }
+    }
+    if (clPrintTuningCandidates) {
+      std::string entry;
+      llvm::raw_string_ostream os(entry);
+      os << llvm::json::Value(serializeTuningEntry(key, config));
+      op->emitRemark() << "tuning candidate: " << os.str();
+    }
+  }
+  return setOpConfigAndEntryPointFnTranslation(
+      entryPointFn, op, config.tileSizes, config.nativeVectorSize,
+      passPipeline);
+}
+
+/// Returns the number of `elementType` elements in a native vector of the
+/// wide vector extension (RISC-V V or AArch64 SVE) of the target `op` is
+/// compiled for, or 0 if the target has none. LLVM lowers the fixed-length
+/// vectors to RVV register groups of the configured LMUL given the minimum
+/// VLEN from the `+zvl<N>b` CPU features, or to predicated SVE operations
+/// given the SVE vector length, handling remainders without scalar code.
+static int64_t getWideVectorSize(Operation *op, Type elementType) {
+  if (!elementType.isIntOrFloat()) return 0;
+  CustomKernelsTargetInfo targetInfo = getCustomKernelsTargetInfo(op);
+  int64_t vectorBits = 0;
+  if (targetInfo.riscvVectorBits) {
+    int64_t lmul =
+        llvm::PowerOf2Floor(std::max(1, std::min<int>(riscvVectorLMUL, 8)));
+    vectorBits = targetInfo.riscvVectorBits * lmul;
+  } else if (targetInfo.hasSVE && aarch64SVEVectorBits > 128) {
+    // SVE vector lengths are multiples of 128 bits up to 2048 bits.
+    vectorBits =
+        llvm::alignDown(std::min<int>(aarch64SVEVectorBits, 2048), 128);
+  }
+  return vectorBits / std::max(8u, elementType.getIntOrFloatBitWidth());
+}
+
+/// Returns the pipeline to use for a matmul with the static sizes `dims` of
+/// its (M, N, K) loops, tiled by `l1TileSizes` and then by `vectorSizes`.
+/// Dimensions that are not multiples of their vector size leave partial vector
+/// tiles, which otherwise fall back to scalar code. Padding the partial L1
+/// tiles keeps everything on full vectors at the cost of redundant work, so it
+/// is only used when the padding is a small fraction of the dimension. Larger
+/// remainders are peeled off the vector loops instead, leaving the bulk of the
+/// iterations on full vectors and a single masked vector tile per dimension.
+static IREE::HAL::DispatchLoweringPassPipeline getMatmulPassPipeline(
+    ArrayRef<int64_t> dims, ArrayRef<int64_t> l1TileSizes,
+    ArrayRef<int64_t> vectorSizes) {
+  bool needsPadding = false;
+  for (auto it : llvm::zip(dims, l1TileSizes, vectorSizes)) {
+    int64_t dim = std::get<0>(it);
+    if (ShapedType::isDynamic(dim)) {
+      return IREE::HAL::DispatchLoweringPassPipeline::CPUVectorization;
+    }
+    if (dim % std::get<2>(it) == 0) continue;
+    int64_t padding = llvm::alignTo(dim, std::get<1>(it)) - dim;
+    if (padding * 100 > dim * matmulMaxPaddingPercent) {
+      return IREE::HAL::DispatchLoweringPassPipeline::CPUPeelAndVectorize;
+    }
+    needsPadding = true;
+  }
+  return needsPadding
+             ? IREE::HAL::DispatchLoweringPassPipeline::CPUPadAndVectorize
+             : IREE::HAL::DispatchLoweringPassPipeline::CPUVectorization;
+}
+
+/// Returns the largest tile size not larger than `maxSize` that evenly divides
+/// `dim` and is a multiple of `multiple`, or 0 if there is none.
+static int64_t getDivisibleTileSize(int64_t dim, int64_t maxSize,
+                                    int64_t multiple = 1) {
+  for (int64_t i = std::min(dim, maxSize); i > 0; --i) {
+    if (dim % i == 0 && i % multiple == 0) return i;
+  }
+  return 0;
+}
+
+/// Returns true if the row-major matmul with the given operand shapes has at
+/// most `matmulMatvecMaxM` rows, e.g. the matmuls of batch-1 decoding, and a
+/// static shape that can be configured by setMatvecRootConfig.
+static bool isMatvecLikeMatmul(ArrayRef<int64_t> lhsShape,
+                               ArrayRef<int64_t> rhsShape) {
+  if (lhsShape.size() != 2 || rhsShape.size() != 2) return false;
+  if (llvm::any_of(lhsShape, ShapedType::isDynamic) ||
+      llvm::any_of(rhsShape, ShapedType::isDynamic)) {
+    return false;
+  }
+  return lhsShape[0] <= matmulMatvecMaxM &&
+         rhsShape[1] % matmulMatvecVectorSize == 0;
+}
+
+/// Sets the lowering configuration of a matvec-like matmul. These are bound by
+/// streaming the rhs (the weights) from memory rather than by compute, so all
+/// rows are kept in every tile for the rhs to be read only once, N is
+/// vectorized with wide vectors and K is tiled large enough for the L1 tiles to
+/// stream long contiguous rows of the rhs.
+static LogicalResult setMatvecRootConfig(
+    FuncOp entryPointFn, linalg::ContractionOpInterface contractionOp,
+    ArrayRef<int64_t> lhsShape, ArrayRef<int64_t> rhsShape) {
+  int64_t M = lhsShape[0], N = rhsShape[1], K = rhsShape[0];
+  int64_t nVectorSize = matmulMatvecVectorSize;
+  int64_t kVectorSize = getDivisibleTileSize(K, matmulVectorSize);
+  int64_t nL1TileSize = getDivisibleTileSize(N, 4 * nVectorSize, nVectorSize);
+  int64_t nWorkgroupSize =
+      getDivisibleTileSize(N, matmulWorkgroupTileSize, nL1TileSize);
+  if (nWorkgroupSize == 0) nWorkgroupSize = nL1TileSize;
+  int64_t kL1TileSize = getDivisibleTileSize(K, 256, kVectorSize);
+  TileSizesListType tileSizes = {{M, nWorkgroupSize},
+                                 {M, nL1TileSize, kL1TileSize},
+                                 {M, nVectorSize, kVectorSize}};
+  SmallVector<int64_t, 4> nativeVectorSize = {M, nVectorSize, kVectorSize};
+  return setTunableOpConfig(entryPointFn, contractionOp, tileSizes,
+                            nativeVectorSize);
+}
+
 /// Sets the lowering configuration for dispatch region with root op that
 /// implements the contraction operation interface.
 static LogicalResult setRootConfig(
@@ -92,35 +286,71 @@ static LogicalResult setRootConfig(
     int mL1TileSize = matmulL1TileSize;
     int nL1TileSize = matmulL1TileSize;
     int kL1TileSize = matmulL1TileSize;
+    int mVectorSize = matmulVectorSize;
+    int nVectorSize = matmulVectorSize;
+    int kVectorSize = matmulVectorSize;
+    auto passPipeline =
+        IREE::HAL::DispatchLoweringPassPipeline::CPUVectorization;
     auto lhsShape = getUntiledShape(contractionOp.lhs());
     auto rhsShape = getUntiledShape(contractionOp.rhs());
+    if (isMatvecLikeMatmul(lhsShape, rhsShape)) {
+      return setMatvecRootConfig(entryPointFn, contractionOp, lhsShape,
+                                 rhsShape);
+    }
+    // Targets with wide vector extensions vectorize the contiguous N dimension
+    // with native vectors unless the vector size is overridden.
+    int nVectorMultiple = matmulVectorSize;
+    if (!matmulVectorSize.getNumOccurrences()) {
+      Type elementType =
+          contractionOp.lhs().getType().cast<ShapedType>().getElementType();
+      if (int64_t wideVectorSize =
+              getWideVectorSize(contractionOp.getOperation(), elementType)) {
+        nVectorMultiple = wideVectorSize;
+        nVectorSize = nVectorMultiple;
+        nL1TileSize = std::max(nL1TileSize, nVectorMultiple);
+        nWorkgroupSize = std::max(nWorkgroupSize, nL1TileSize);
+      }
+    }
     if (!lhsShape.empty() && !rhsShape.empty()) {
       // Find largest tile size that is a multiple of the vector size.
-      auto getTileSize = [](int dim, int maxSize) {
+      // Dimensions smaller than the vector size (e.g. M = 1 for matrix-vector
+      // products) are processed whole.
+      auto getTileSize = [](int dim, int maxSize,
+                            int multiple = matmulVectorSize) {
         if (dim == ShapedType::kDynamicSize) return maxSize;
-        if (dim < matmulVectorSize) return matmulVectorSize.getValue();
+        if (dim < multiple) return dim;
         for (int i = std::min(maxSize, dim); i > 0; --i) {
-          if (dim % i == 0 && i % matmulVectorSize == 0) {
+          if (dim % i == 0 && i % multiple == 0) {
             return i;
           }
         }
         return maxSize;
       };
+      auto getVectorSize = [](int dim, int vectorSize = matmulVectorSize) {
+        if (dim == ShapedType::kDynamicSize) return vectorSize;
+        return std::min<int>(dim, vectorSize);
+      };
       mWorkgroupSize = getTileSize(lhsShape[0], mWorkgroupSize);
-      nWorkgroupSize = getTileSize(rhsShape[1], nWorkgroupSize);
+      nWorkgroupSize =
+          getTileSize(rhsShape[1], nWorkgroupSize, nVectorMultiple);
       mL1TileSize = getTileSize(mWorkgroupSize, mL1TileSize);
-      nL1TileSize = getTileSize(nWorkgroupSize, nL1TileSize);
+      nL1TileSize = getTileSize(nWorkgroupSize, nL1TileSize, nVectorMultiple);
       kL1TileSize = getTileSize(rhsShape[0], kL1TileSize);
+      mVectorSize = getVectorSize(lhsShape[0]);
+      nVectorSize = getVectorSize(rhsShape[1], nVectorMultiple);
+      kVectorSize = getVectorSize(rhsShape[0]);
+      passPipeline = getMatmulPassPipeline(
+          {lhsShape[0], rhsShape[1], rhsShape[0]},
+          {mL1TileSize, nL1TileSize, kL1TileSize},
+          {mVectorSize, nVectorSize, kVectorSize});
     }
-    TileSizesListType tileSizes = {
-        {mWorkgroupSize, nWorkgroupSize},
-        {mL1TileSize, nL1TileSize, kL1TileSize},
-        {matmulVectorSize, matmulVectorSize, matmulVectorSize}};
-    SmallVector<int64_t, 4> nativeVectorSize = {
-        matmulVectorSize, matmulVectorSize, matmulVectorSize};
-    return setOpConfigAndEntryPointFnTranslation(
-        entryPointFn, contractionOp, tileSizes, nativeVectorSize,
-        IREE::HAL::DispatchLoweringPassPipeline::CPUVectorization);
+    TileSizesListType tileSizes = {{mWorkgroupSize, nWorkgroupSize},
+                                   {mL1TileSize, nL1TileSize, kL1TileSize},
+                                   {mVectorSize, nVectorSize, kVectorSize}};
+    SmallVector<int64_t, 4> nativeVectorSize = {mVectorSize, nVectorSize,
+                                                kVectorSize};
+    return setTunableOpConfig(entryPointFn, contractionOp, tileSizes,
+                              nativeVectorSize, passPipeline);
   }
   if (contractionOp.isRowMajorBatchMatmul()) {
     // TODO(ataei, ravishankarm): This should just use the configuration for
@@ -133,9 +363,8 @@ static LogicalResult setRootConfig(
          batchMatmulL2TileSize}};
     SmallVector<int64_t, 4> nativeVectorSize = {
         1, batchMatmulL2TileSize, batchMatmulL2TileSize, batchMatmulL2TileSize};
-    return setOpConfigAndEntryPointFnTranslation(
-        entryPointFn, contractionOp, tileSizes, nativeVectorSize,
-        IREE::HAL::DispatchLoweringPassPipeline::CPUVectorization);
+    return setTunableOpConfig(entryPointFn, contractionOp, tileSizes,
+                              nativeVectorSize);
   }
   return success();
 }
@@ -154,12 +383,30 @@ static LogicalResult setRootConfig(FuncOp entryPointFn,
     return {64, 32};
   };
 
+  // By default the inner tiles are processed whole such that they can be
+  // lowered to the microkernels matching their shapes. Dynamic inner tiles of
+  // targets with wide vector extensions vectorize N0 with native vectors.
+  auto getInnerTileSizes = [&]() -> SmallVector<int64_t> {
+    ArrayRef<int64_t> lhsShape = getUntiledShape(mmt4dOp.inputs()[0]);
+    ArrayRef<int64_t> dstShape = getUntiledShape(mmt4dOp.outputs()[0]);
+    if (lhsShape.size() != 4 || dstShape.size() != 4 ||
+        ShapedType::isDynamic(lhsShape[2]) ||
+        ShapedType::isDynamic(lhsShape[3]) ||
+        ShapedType::isDynamic(dstShape[3])) {
+      Type elementType =
+          mmt4dOp.outputs()[0].getType().cast<ShapedType>().getElementType();
+      int64_t n0VectorSize = getWideVectorSize(mmt4dOp, elementType);
+      return {1, 1, 4, n0VectorSize ? n0VectorSize : 4, 1, 4};
+    }
+    return {1, 1, lhsShape[2], dstShape[3], 1, lhsShape[3]};
+  };
+
   auto getL1TileSizes = [&]() -> SmallVector<int64_t> {
     if (!mmt4dL1TileSizes.empty()) {
       return SmallVector<int64_t>(mmt4dL1TileSizes.begin(),
                                   mmt4dL1TileSizes.end());
     }
-    return {1, 1, 4, 4, 1, 4};
+    return getInnerTileSizes();
   };
 
   auto getVectorSizes = [&]() -> SmallVector<int64_t> {
@@ -167,7 +414,7 @@ static LogicalResult setRootConfig(FuncOp entryPointFn,
       return SmallVector<int64_t>(mmt4dVectorSizes.begin(),
                                   mmt4dVectorSizes.end());
     }
-    return {1, 1, 4, 4, 1, 4};
+    return getInnerTileSizes();
   };
 
   SmallVector<int64_t, 4> nativeVectorSize = getVectorSizes();
@@ -175,8 +422,110 @@ static LogicalResult setRootConfig(FuncOp entryPointFn,
   TileSizesListType tileSizes = {getWorkgroupTileSizes(), getL1TileSizes(),
                                  nativeVectorSize};
 
+  return setTunableOpConfig(entryPointFn, mmt4dOp, tileSizes,
+                            nativeVectorSize);
+}
+
+/// Returns true if the `convOp` has any dilation other than 1.
+template <typename ConvOpTy>
+static bool hasDilation(ConvOpTy convOp) {
+  auto dilations = convOp.dilations();
+  return dilations && llvm::any_of(dilations.getIntValues(),
+                                   [](const APInt &value) {
+                                     return value.getSExtValue() != 1;
+                                   });
+}
+
+/// Sets the lowering configuration for dispatch region with a direct
+/// convolution as root op. Workgroups are tiled over the output height, width
+/// and channels. The L1 tiles keep a block of the output resident while
+/// iterating over the filter window one tap at a time and a block of input
+/// channels so the filter slice read per block (HWCF keeps the output channels
+/// innermost) fits in cache. The vector tiles match the kernels of
+/// populateLinalgToVectorVectorizeConvPatterns. Tile sizes are chosen to evenly
+/// divide the static shapes so that all tiles are full; convolutions that do
+/// not fit this scheme fall back to the default configuration.
+static LogicalResult setRootConfig(FuncOp entryPointFn,
+                                   linalg::ConvInputNHWCFilterHWCFOp convOp) {
+  if (getLoweringConfig(convOp)) return success();
+  if (hasDilation(convOp)) return success();
+  ArrayRef<int64_t> filterShape =
+      getUntiledShape(convOp.getInputOperand(1)->get());
+  ArrayRef<int64_t> outputShape =
+      getUntiledShape(convOp.getOutputOperand(0)->get());
+  if (filterShape.size() != 4 || outputShape.size() != 4 ||
+      llvm::any_of(filterShape, ShapedType::isDynamic) ||
+      llvm::any_of(outputShape, ShapedType::isDynamic)) {
+    return success();
+  }
+  int64_t outputHeight = outputShape[1];
+  int64_t outputWidth = outputShape[2];
+  int64_t outputChannels = outputShape[3];
+  int64_t inputChannels = filterShape[2];
+
+  // The vector kernel accumulates along 4-wide output channel vectors.
+  int64_t ocVectorSize = getDivisibleTileSize(outputChannels, 8, 4);
+  if (ocVectorSize == 0) return success();
+  int64_t owVectorSize = getDivisibleTileSize(outputWidth, 4);
+  int64_t icVectorSize = getDivisibleTileSize(inputChannels, 4);
+
+  int64_t ocL1TileSize = getDivisibleTileSize(outputChannels, 32, ocVectorSize);
+  int64_t owL1TileSize = getDivisibleTileSize(outputWidth, 16, owVectorSize);
+  int64_t icL1TileSize = getDivisibleTileSize(inputChannels, 64, icVectorSize);
+
+  int64_t ocWorkgroupSize =
+      getDivisibleTileSize(outputChannels, 64, ocL1TileSize);
+  int64_t owWorkgroupSize = getDivisibleTileSize(outputWidth, 32, owL1TileSize);
+  int64_t ohWorkgroupSize = getDivisibleTileSize(outputHeight, 8);
+
+  // Loops are (N, OH, OW, OC, FH, FW, IC).
+  TileSizesListType tileSizes = {
+      {0, ohWorkgroupSize, owWorkgroupSize, ocWorkgroupSize},
+      {1, 1, owL1TileSize, ocL1TileSize, 1, 1, icL1TileSize},
+      {1, 1, owVectorSize, ocVectorSize, 1, 1, icVectorSize}};
+  SmallVector<int64_t, 4> nativeVectorSize = {
+      1, 1, owVectorSize, ocVectorSize, 1, 1, icVectorSize};
   return setOpConfigAndEntryPointFnTranslation(
-      entryPointFn, mmt4dOp, tileSizes, nativeVectorSize,
+      entryPointFn, convOp, tileSizes, nativeVectorSize,
+      IREE::HAL::DispatchLoweringPassPipeline::CPUVectorization);
+}
+
+/// Sets the lowering configuration for dispatch region with a depthwise
+/// convolution as root op. This follows the direct convolution configuration
+/// with the channels being both the input and output channels.
+static LogicalResult setRootConfig(
+    FuncOp entryPointFn, linalg::DepthwiseConvInputNHWCFilterHWCOp convOp) {
+  if (getLoweringConfig(convOp)) return success();
+  ArrayRef<int64_t> outputShape =
+      getUntiledShape(convOp.getOutputOperand(0)->get());
+  if (outputShape.size() != 4 ||
+      llvm::any_of(outputShape, ShapedType::isDynamic)) {
+    return success();
+  }
+  int64_t outputHeight = outputShape[1];
+  int64_t outputWidth = outputShape[2];
+  int64_t channels = outputShape[3];
+
+  int64_t cVectorSize = getDivisibleTileSize(channels, 8, 4);
+  if (cVectorSize == 0) return success();
+  int64_t owVectorSize = getDivisibleTileSize(outputWidth, 4);
+
+  int64_t cL1TileSize = getDivisibleTileSize(channels, 32, cVectorSize);
+  int64_t owL1TileSize = getDivisibleTileSize(outputWidth, 16, owVectorSize);
+
+  int64_t cWorkgroupSize = getDivisibleTileSize(channels, 64, cL1TileSize);
+  int64_t owWorkgroupSize = getDivisibleTileSize(outputWidth, 32, owL1TileSize);
+  int64_t ohWorkgroupSize = getDivisibleTileSize(outputHeight, 8);
+
+  // Loops are (N, OH, OW, C, FH, FW).
+  TileSizesListType tileSizes = {
+      {0, ohWorkgroupSize, owWorkgroupSize, cWorkgroupSize},
+      {1, 1, owL1TileSize, cL1TileSize, 1, 1},
+      {1, 1, owVectorSize, cVectorSize, 1, 1}};
+  SmallVector<int64_t, 4> nativeVectorSize = {1, 1, owVectorSize,
+                                              cVectorSize, 1, 1};
+  return setOpConfigAndEntryPointFnTranslation(
+      entryPointFn, convOp, tileSizes, nativeVectorSize,
       IREE::HAL::DispatchLoweringPassPipeline::CPUVectorization);
 }
 
@@ -215,7 +564,9 @@ static LogicalResult setRootConfig(FuncOp entryPointFn,
 
     auto setRootConfigFn = [&](Operation *op) -> LogicalResult {
       return TypeSwitch<Operation *, LogicalResult>(op)
-          .Case<linalg::Mmt4DOp, linalg::ContractionOpInterface>(
+          .Case<linalg::Mmt4DOp, linalg::ConvInputNHWCFilterHWCFOp,
+                linalg::DepthwiseConvInputNHWCFilterHWCOp,
+                linalg::ContractionOpInterface>(
               [&](auto op) { return setRootConfig(entryPointFn, op); })
           .Default([&](Operation *op) { return success(); });
     };
@@ -256,6 +607,53 @@ static LogicalResult setRootConfig(FuncOp entryPointFn,
   return success();
 }
 
+/// Returns the static extent of `loop` in `linalgOp` if any operand dimension
+/// indexed directly by the loop has a static untiled size.
+static Optional<int64_t> getStaticLoopExtent(linalg::LinalgOp linalgOp,
+                                             unsigned loop) {
+  for (OpOperand *opOperand : linalgOp.getInputAndOutputOperands()) {
+    ArrayRef<int64_t> shape = getUntiledShape(opOperand->get());
+    AffineMap indexingMap = linalgOp.getTiedIndexingMap(opOperand);
+    for (auto result : llvm::enumerate(indexingMap.getResults())) {
+      auto dimExpr = result.value().dyn_cast<AffineDimExpr>();
+      if (!dimExpr || dimExpr.getPosition() != loop) continue;
+      if (result.index() < shape.size() &&
+          !ShapedType::isDynamic(shape[result.index()])) {
+        return shape[result.index()];
+      }
+    }
+  }
+  return llvm::None;
+}
+
+/// Estimates the number of scalar operations performed by a single workgroup
+/// of the `rootOp` based on the workgroup tile sizes selected for it. Loops that
+/// are not distributed across workgroups must have a static extent; if any do
+/// not then the cost is unknown and llvm::None is returned.
+static Optional<int64_t> estimateWorkgroupCost(linalg::LinalgOp rootOp) {
+  SmallVector<int64_t, 4> workgroupTileSizes = getTileSizes(rootOp, 0);
+  int64_t opsPerIteration = 1;
+  if (rootOp->getNumRegions() == 1 && !rootOp->getRegion(0).empty()) {
+    // Count the payload ops (excluding the terminator) as a rough proxy for
+    // the per-iteration cost.
+    opsPerIteration = std::max<int64_t>(
+        1, rootOp->getRegion(0).front().getOperations().size() - 1);
+  }
+  const int64_t kMaxCost = std::numeric_limits<int32_t>::max();
+  int64_t cost = opsPerIteration;
+  for (unsigned loop = 0; loop < rootOp.getNumLoops(); ++loop) {
+    Optional<int64_t> extent = getStaticLoopExtent(rootOp, loop);
+    if (loop < workgroupTileSizes.size() && workgroupTileSizes[loop] > 0) {
+      extent = extent ? std::min(*extent, workgroupTileSizes[loop])
+                      : workgroupTileSizes[loop];
+    }
+    if (!extent) return llvm::None;
+    if (*extent > 0 && cost > kMaxCost / *extent) return kMaxCost;
+    cost *= *extent;
+  }
+  return cost;
+}
+
 LogicalResult initCPULaunchConfig(ModuleOp moduleOp) {
   llvm::StringMap<IREE::HAL::ExecutableEntryPointOp> entryPointOps =
       getAllEntryPoints(moduleOp);
@@ -271,6 +669,17 @@ LogicalResult initCPULaunchConfig(ModuleOp moduleOp) {
       if (failed(setRootConfig(funcOp, computeOps))) {
         return failure();
       }
+
+      // Record how expensive each workgroup is expected to be so that the
+      // runtime can decide how to distribute workgroups across threads.
+      for (auto computeOp : computeOps) {
+        auto linalgOp = dyn_cast<linalg::LinalgOp>(computeOp);
+        if (!linalgOp || !getLoweringConfig(computeOp)) continue;
+        if (Optional<int64_t> cost = estimateWorkgroupCost(linalgOp)) {
+          setWorkgroupCostHint(entryPointOp, *cost);
+        }
+        break;
+      }
     }
 
     // If the function entry point already doesnt have a lowering info attribute
@@ -155,6 +155,15 @@ void LLVMCPULowerExecutableTargetPass::runOnOperation() {
         case IREE::HAL::DispatchLoweringPassPipeline::CPUVectorization:
           addCPUVectorizationPassPipeline(nestedModulePM, lowerToVectors);
           break;
+        case IREE::HAL::DispatchLoweringPassPipeline::CPUPadAndVectorize:
+          addCPUVectorizationPassPipeline(nestedModulePM, lowerToVectors,
+                                          /*padPartialTiles=*/true);
+          break;
+        case IREE::HAL::DispatchLoweringPassPipeline::CPUPeelAndVectorize:
+          addCPUVectorizationPassPipeline(nestedModulePM, lowerToVectors,
+                                          /*padPartialTiles=*/false,
+                                          /*peelPartialTiles=*/true);
+          break;
         default:
           llvm_unreachable("Unsupported pipeline on CPU target.");
       }
@@ -0,0 +1,404 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+//===- LLVMCPUMathApproximation.cpp ---------------------------------------===//
+//
+// Rewrites f32 math dialect elementary functions (and the sigmoid form produced
+// when lowering mhlo.logistic) into polynomial approximations built only from
+// standard arithmetic ops. The expansions work on scalars and vectors alike so
+// the vectorized loops of elementwise dispatches (softmax, GELU, ...) stay on
+// SIMD instead of calling into scalar libm routines.
+//
+// Two accuracy levels are provided:
+//  - accurate (default): within a few ULP of the correctly rounded result; the
+//    polynomials are the Cephes/Eigen single precision ones.
+//  - fast: lower degree polynomials with a relative error around 1e-5 for exp
+//    and log and an absolute error around 1e-4 for tanh and sigmoid.
+//
+// Denormal inputs to log are not renormalized and lose accuracy, similar to
+// running with denormals flushed to zero.
+//
+//===----------------------------------------------------------------------===//
+
+#include <limits>
+
+#include "iree/compiler/Codegen/PassDetail.h"
+#include "iree/compiler/Codegen/Passes.h"
+#include "mlir/Dialect/Math/IR/Math.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/ImplicitLocOpBuilder.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+namespace mlir {
+namespace iree_compiler {
+
+namespace {
+
+//===----------------------------------------------------------------------===//
+// Helpers
+//===----------------------------------------------------------------------===//
+
+/// Returns true if |type| is f32 or a vector of f32.
+static bool isF32OrF32Vector(Type type) {
+  return getElementTypeOrSelf(type).isF32();
+}
+
+/// Returns the i32 type with the same shape as the f32 |type|.
+static Type getI32TypeLike(Type type) {
+  auto i32Type = IntegerType::get(type.getContext(), 32);
+  if (auto vectorType = type.dyn_cast<VectorType>()) {
+    return VectorType::get(vectorType.getShape(), i32Type);
+  }
+  return i32Type;
+}
+
+/// Returns a constant of |type| (f32 or a vector of f32) holding |value|.
+static Value getF32Constant(ImplicitLocOpBuilder &b, Type type, float value) {
+  Attribute attr = b.getF32FloatAttr(value);
+  if (auto vectorType = type.dyn_cast<VectorType>()) {
+    attr = SplatElementsAttr::get(vectorType, attr);
+  }
+  return b.create<ConstantOp>(attr);
+}
+
+/// Returns a constant of |type| (i32 or a vector of i32) holding |value|.
+static Value getI32Constant(ImplicitLocOpBuilder &b, Type type, int32_t value) {
+  Attribute attr = b.getI32IntegerAttr(value);
+  if (auto vectorType = type.dyn_cast<VectorType>()) {
+    attr = SplatElementsAttr::get(vectorType, attr);
+  }
+  return b.create<ConstantOp>(attr);
+}
+
+/// Returns true if |value| is a scalar or splat f32 constant of |expected|.
+static bool isF32Constant(Value value, float expected) {
+  Attribute attr;
+  if (!matchPattern(value, m_Constant(&attr))) return false;
+  if (auto splatAttr = attr.dyn_cast<SplatElementsAttr>()) {
+    attr = splatAttr.getSplatValue();
+  }
+  auto floatAttr = attr.dyn_cast<FloatAttr>();
+  return floatAttr && floatAttr.getValueAsDouble() == expected;
+}
+
+/// Clamps |x| to [|lo|, |hi|]. NaNs are propagated.
+static Value clamp(ImplicitLocOpBuilder &b, Value x, Value lo, Value hi) {
+  x = b.create<SelectOp>(b.create<CmpFOp>(CmpFPredicate::OLT, x, lo), lo, x);
+  return b.create<SelectOp>(b.create<CmpFOp>(CmpFPredicate::OGT, x, hi), hi,
+                            x);
+}
+
+/// Evaluates the polynomial with |coeffs| (highest degree first) at |x| using
+/// Horner's scheme.
+static Value evaluatePolynomial(ImplicitLocOpBuilder &b, Value x,
+                                ArrayRef<float> coeffs) {
+  Type type = x.getType();
+  Value result = getF32Constant(b, type, coeffs.front());
+  for (float coeff : coeffs.drop_front()) {
+    result = b.create<FmaFOp>(result, x, getF32Constant(b, type, coeff));
+  }
+  return result;
+}
+
+// ln(2) split into a part exactly representable with few mantissa bits and the
+// remainder so that n * ln(2) can be subtracted without losing precision.
+constexpr float kLn2Hi = 0.693359375f;
+constexpr float kLn2Lo = -2.12194440e-4f;
+
+//===----------------------------------------------------------------------===//
+// exp
+//===----------------------------------------------------------------------===//
+
+// Inputs outside of this range over/underflow f32.
+constexpr float kExpLowerBound = -87.33654f;
+constexpr float kExpUpperBound = 88.37626f;
+
+// Polynomials approximating (e^r - 1 - r) / r^2 on [-ln(2)/2, ln(2)/2].
+constexpr float kExpAccurateCoeffs[] = {1.9875691500e-4f, 1.3981999507e-3f,
+                                        8.3334519073e-3f, 4.1665795894e-2f,
+                                        1.6666665459e-1f, 5.0000001201e-1f};
+constexpr float kExpFastCoeffs[] = {4.1277698e-2f, 1.6753516e-1f,
+                                    5.0005117e-1f};
+
+/// Computes e^x as 2^n * e^r with x = n * ln(2) + r.
+static Value buildExp(ImplicitLocOpBuilder &b, Value x, bool fast) {
+  Type type = x.getType();
+  Type i32Type = getI32TypeLike(type);
+  auto cst = [&](float value) { return getF32Constant(b, type, value); };
+
+  Value clamped = clamp(b, x, cst(kExpLowerBound), cst(kExpUpperBound));
+  Value n = b.create<FloorFOp>(
+      b.create<FmaFOp>(clamped, cst(1.44269504088896341f), cst(0.5f)));
+  Value r = b.create<FmaFOp>(n, cst(-kLn2Hi), clamped);
+  r = b.create<FmaFOp>(n, cst(-kLn2Lo), r);
+
+  Value p = evaluatePolynomial(
+      b, r, fast ? ArrayRef<float>(kExpFastCoeffs) : kExpAccurateCoeffs);
+  Value expR = b.create<FmaFOp>(p, b.create<MulFOp>(r, r),
+                                b.create<AddFOp>(r, cst(1.0f)));
+
+  // 2^n is built directly from the bits of the f32 exponent.
+  Value biasedN = b.create<AddIOp>(b.create<FPToSIOp>(i32Type, n),
+                                   getI32Constant(b, i32Type, 127));
+  Value exp2N = b.create<BitcastOp>(
+      type, b.create<ShiftLeftOp>(biasedN, getI32Constant(b, i32Type, 23)));
+  Value result = b.create<MulFOp>(expR, exp2N);
+
+  // Saturate the results of out of range inputs like expf does.
+  result = b.create<SelectOp>(
+      b.create<CmpFOp>(CmpFPredicate::OGT, x, cst(kExpUpperBound)),
+      cst(std::numeric_limits<float>::infinity()), result);
+  return b.create<SelectOp>(
+      b.create<CmpFOp>(CmpFPredicate::OLT, x, cst(kExpLowerBound)), cst(0.0f),
+      result);
+}
+
+struct ExpApproximation : public OpRewritePattern<math::ExpOp> {
+  ExpApproximation(MLIRContext *context, bool fast)
+      : OpRewritePattern<math::ExpOp>(context), fast(fast) {}
+
+  LogicalResult matchAndRewrite(math::ExpOp op,
+                                PatternRewriter &rewriter) const override {
+    if (!isF32OrF32Vector(op.getType())) return failure();
+    ImplicitLocOpBuilder b(op.getLoc(), rewriter);
+    rewriter.replaceOp(op, buildExp(b, op.operand(), fast));
+    return success();
+  }
+
+ private:
+  bool fast;
+};
+
+//===----------------------------------------------------------------------===//
+// log
+//===----------------------------------------------------------------------===//
+
+// Polynomials approximating (log(1 + m) - m + m^2 / 2) / m^3 on
+// [sqrt(0.5) - 1, sqrt(2) - 1].
+constexpr float kLogAccurateCoeffs[] = {
+    7.0376836292e-2f,  -1.1514610310e-1f, 1.1676998740e-1f,
+    -1.2420140846e-1f, 1.4249322787e-1f,  -1.6668057665e-1f,
+    2.0000714765e-1f,  -2.4999993993e-1f, 3.3333331174e-1f};
+constexpr float kLogFastCoeffs[] = {1.1781463e-1f, -1.8407153e-1f,
+                                    2.0442265e-1f, -2.4943834e-1f,
+                                    3.3320858e-1f};
+
+/// Computes log(x) as e * ln(2) + log(m) with x = 2^e * m.
+static Value buildLog(ImplicitLocOpBuilder &b, Value x, bool fast) {
+  Type type = x.getType();
+  Type i32Type = getI32TypeLike(type);
+  auto cst = [&](float value) { return getF32Constant(b, type, value); };
+  auto i32Cst = [&](int32_t value) {
+    return getI32Constant(b, i32Type, value);
+  };
+
+  // Split x into its exponent and a mantissa in [0.5, 1).
+  Value bits = b.create<BitcastOp>(i32Type, x);
+  Value e = b.create<SIToFPOp>(
+      type, b.create<SubIOp>(b.create<SignedShiftRightOp>(bits, i32Cst(23)),
+                             i32Cst(126)));
+  Value m = b.create<BitcastOp>(
+      type, b.create<OrOp>(b.create<AndOp>(bits, i32Cst(0x007fffff)),
+                           i32Cst(0x3f000000)));
+
+  // Move the mantissa to [sqrt(0.5), sqrt(2)) where the polynomial is centered
+  // and subtract 1.
+  Value isSmall =
+      b.create<CmpFOp>(CmpFPredicate::OLT, m, cst(0.707106781186547524f));
+  e = b.create<SubFOp>(e, b.create<SelectOp>(isSmall, cst(1.0f), cst(0.0f)));
+  m = b.create<SubFOp>(
+      b.create<AddFOp>(m, b.create<SelectOp>(isSmall, m, cst(0.0f))),
+      cst(1.0f));
+
+  Value m2 = b.create<MulFOp>(m, m);
+  Value p = evaluatePolynomial(
+      b, m, fast ? ArrayRef<float>(kLogFastCoeffs) : kLogAccurateCoeffs);
+  Value y = b.create<MulFOp>(b.create<MulFOp>(m, m2), p);
+  y = b.create<FmaFOp>(e, cst(kLn2Lo), y);
+  y = b.create<FmaFOp>(m2, cst(-0.5f), y);
+  Value result = b.create<FmaFOp>(e, cst(kLn2Hi), b.create<AddFOp>(m, y));
+
+  // Negative and NaN inputs produce NaN, 0 produces -inf and inf produces inf.
+  result = b.create<SelectOp>(
+      b.create<CmpFOp>(CmpFPredicate::ULT, x, cst(0.0f)),
+      cst(std::numeric_limits<float>::quiet_NaN()), result);
+  result = b.create<SelectOp>(
+      b.create<CmpFOp>(CmpFPredicate::OEQ, x, cst(0.0f)),
+      cst(-std::numeric_limits<float>::infinity()), result);
+  Value inf = cst(std::numeric_limits<float>::infinity());
+  return b.create<SelectOp>(b.create<CmpFOp>(CmpFPredicate::OEQ, x, inf), inf,
+                            result);
+}
+
+struct LogApproximation : public OpRewritePattern<math::LogOp> {
+  LogApproximation(MLIRContext *context, bool fast)
+      : OpRewritePattern<math::LogOp>(context), fast(fast) {}
+
+  LogicalResult matchAndRewrite(math::LogOp op,
+                                PatternRewriter &rewriter) const override {
+    if (!isF32OrF32Vector(op.getType())) return failure();
+    ImplicitLocOpBuilder b(op.getLoc(), rewriter);
+    rewriter.replaceOp(op, buildLog(b, op.operand(), fast));
+    return success();
+  }
+
+ private:
+  bool fast;
+};
+
+//===----------------------------------------------------------------------===//
+// tanh and sigmoid
+//===----------------------------------------------------------------------===//
+
+// Rational approximations x * P(x^2) / Q(x^2) of tanh on [-bound, bound];
+// tanh is 1 to f32 precision beyond the accurate bound.
+constexpr float kTanhAccurateBound = 7.90531110763549805f;
+constexpr float kTanhAccurateNumeratorCoeffs[] = {
+    -2.76076847742355e-16f, 2.00018790482477e-13f, -8.60467152213735e-11f,
+    5.12229709037114e-08f,  1.48572235717979e-05f, 6.37261928875436e-04f,
+    4.89352455891786e-03f};
+constexpr float kTanhAccurateDenominatorCoeffs[] = {
+    1.19825839466702e-06f, 1.18534705686654e-04f, 2.26843463243900e-03f,
+    4.89352518554385e-03f};
+constexpr float kTanhFastBound = 5.0f;
+constexpr float kTanhFastNumeratorCoeffs[] = {4.9208097e-06f, 2.4628685e-03f,
+                                              1.2500240e-01f, 9.9999956e-01f};
+constexpr float kTanhFastDenominatorCoeffs[] = {1.6361705e-04f, 2.1910336e-02f,
+                                                4.5833317e-01f, 1.0f};
+
+/// Computes tanh(x) with a rational approximation on a clamped input.
+static Value buildTanh(ImplicitLocOpBuilder &b, Value x, bool fast) {
+  Type type = x.getType();
+  auto cst = [&](float value) { return getF32Constant(b, type, value); };
+
+  float bound = fast ? kTanhFastBound : kTanhAccurateBound;
+  Value clamped = clamp(b, x, cst(-bound), cst(bound));
+  Value x2 = b.create<MulFOp>(clamped, clamped);
+  ArrayRef<float> numeratorCoeffs =
+      fast ? ArrayRef<float>(kTanhFastNumeratorCoeffs)
+           : kTanhAccurateNumeratorCoeffs;
+  ArrayRef<float> denominatorCoeffs =
+      fast ? ArrayRef<float>(kTanhFastDenominatorCoeffs)
+           : kTanhAccurateDenominatorCoeffs;
+  Value p =
+      b.create<MulFOp>(clamped, evaluatePolynomial(b, x2, numeratorCoeffs));
+  Value q = evaluatePolynomial(b, x2, denominatorCoeffs);
+  Value result = b.create<DivFOp>(p, q);
+
+  // tanh(x) rounds to x for tiny inputs where the rational form loses relative
+  // precision.
+  return b.create<SelectOp>(
+      b.create<CmpFOp>(CmpFPredicate::OLT, b.create<AbsFOp>(x), cst(0.0004f)),
+      x, result);
+}
+
+struct TanhApproximation : public OpRewritePattern<math::TanhOp> {
+  TanhApproximation(MLIRContext *context, bool fast)
+      : OpRewritePattern<math::TanhOp>(context), fast(fast) {}
+
+  LogicalResult matchAndRewrite(math::TanhOp op,
+                                PatternRewriter &rewriter) const override {
+    if (!isF32OrF32Vector(op.getType())) return failure();
+    ImplicitLocOpBuilder b(op.getLoc(), rewriter);
+    rewriter.replaceOp(op, buildTanh(b, op.operand(), fast));
+    return success();
+  }
+
+ private:
+  bool fast;
+};
+
+/// Rewrites the `1 / (1 + exp(-x))` form of sigmoid (as produced by lowering
+/// mhlo.logistic) into `0.5 + 0.5 * tanh(0.5 * x)`. This avoids the range
+/// reduction and exponent bit manipulation of exp and saturates cleanly.
+struct SigmoidApproximation : public OpRewritePattern<DivFOp> {
+  SigmoidApproximation(MLIRContext *context, bool fast)
+      : OpRewritePattern<DivFOp>(context), fast(fast) {}
+
+  LogicalResult matchAndRewrite(DivFOp op,
+                                PatternRewriter &rewriter) const override {
+    if (!isF32OrF32Vector(op.getType())) return failure();
+    if (!isF32Constant(op.lhs(), 1.0f)) return failure();
+    auto addOp = op.rhs().getDefiningOp<AddFOp>();
+    if (!addOp) return failure();
+    Value expValue;
+    if (isF32Constant(addOp.lhs(), 1.0f)) {
+      expValue = addOp.rhs();
+    } else if (isF32Constant(addOp.rhs(), 1.0f)) {
+      expValue = addOp.lhs();
+    } else {
+      return failure();
+    }
+    auto expOp = expValue.getDefiningOp<math::ExpOp>();
+    if (!expOp) return failure();
+    auto negOp = expOp.operand().getDefiningOp<NegFOp>();
+    if (!negOp) return failure();
+
+    ImplicitLocOpBuilder b(op.getLoc(), rewriter);
+    Type type = op.getType();
+    Value half = getF32Constant(b, type, 0.5f);
+    Value tanh =
+        buildTanh(b, b.create<MulFOp>(negOp.operand(), half).getResult(), fast);
+    rewriter.replaceOpWithNewOp<FmaFOp>(op, tanh, half, half);
+    return success();
+  }
+
+ private:
+  bool fast;
+};
+
+//===----------------------------------------------------------------------===//
+// Pass
+//===----------------------------------------------------------------------===//
+
+struct LLVMCPUMathApproximationPass
+    : public LLVMCPUMathApproximationBase<LLVMCPUMathApproximationPass> {
+  LLVMCPUMathApproximationPass(bool fast) { this->fast = fast; }
+  LLVMCPUMathApproximationPass(const LLVMCPUMathApproximationPass &pass) {
+    fast = pass.fast;
+  }
+
+  void runOnOperation() override {
+    MLIRContext *context = &getContext();
+    // Sigmoids are matched first so that their exp is not expanded on its own.
+    {
+      OwningRewritePatternList patterns(context);
+      patterns.insert<SigmoidApproximation>(context, fast);
+      (void)applyPatternsAndFoldGreedily(getOperation(), std::move(patterns));
+    }
+    {
+      OwningRewritePatternList patterns(context);
+      populateLLVMCPUMathApproximationPatterns(patterns, fast);
+      (void)applyPatternsAndFoldGreedily(getOperation(), std::move(patterns));
+    }
+  }
+
+ private:
+  Option<bool> fast{
+      *this, "fast",
+      llvm::cl::desc("Use the lower accuracy and cheaper approximations."),
+      llvm::cl::init(false)};
+};
+
+}  // namespace
+
+void populateLLVMCPUMathApproximationPatterns(
+    OwningRewritePatternList &patterns, bool fast) {
+  MLIRContext *context = patterns.getContext();
+  patterns.insert<ExpApproximation, LogApproximation, TanhApproximation>(
+      context, fast);
+}
+
+std::unique_ptr<OperationPass<FuncOp>> createLLVMCPUMathApproximationPass(
+    bool fast) {
+  return std::make_unique<LLVMCPUMathApproximationPass>(fast);
+}
+
+}  // namespace iree_compiler
+}  // namespace mlir
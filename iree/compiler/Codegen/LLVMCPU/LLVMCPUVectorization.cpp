@@ -10,11 +10,13 @@
 #include "iree/compiler/Codegen/Transforms/Transforms.h"
 #include "iree/compiler/Codegen/Utils/MarkerUtils.h"
 #include "mlir/Conversion/VectorToSCF/VectorToSCF.h"
+#include "mlir/Dialect/Affine/IR/AffineOps.h"
 #include "mlir/Dialect/Linalg/IR/LinalgInterfaces.h"
 #include "mlir/Dialect/Linalg/Transforms/CodegenStrategy.h"
 #include "mlir/Dialect/Linalg/Transforms/Hoisting.h"
 #include "mlir/Dialect/MemRef/IR/MemRef.h"
 #include "mlir/Dialect/MemRef/Transforms/Passes.h"
+#include "mlir/Dialect/SCF/SCF.h"
 #include "mlir/Dialect/Utils/StructuredOpsUtils.h"
 #include "mlir/Dialect/Vector/VectorTransforms.h"
 #include "mlir/IR/AffineExpr.h"
@@ -30,7 +32,8 @@ namespace iree_compiler {
 
 namespace {
 // Could just be linalg::TilingPattern with a ContractionOpInterface filter, but
-// that is always templated on an op.
+// that is always templated on an op. Direct convolutions are tiled the same way
+// once their root configuration carries all tiling levels.
 struct TileWorkgroups : public linalg::LinalgBaseTilingPattern {
   using Base = linalg::LinalgBaseTilingPattern;
   TileWorkgroups(MLIRContext *context, linalg::LinalgTilingOptions options,
@@ -38,8 +41,9 @@ struct TileWorkgroups : public linalg::LinalgBaseTilingPattern {
       : LinalgBaseTilingPattern(context, options, marker) {}
   LogicalResult matchAndRewrite(Operation *op,
                                 PatternRewriter &rewriter) const override {
-    auto contractionOp = dyn_cast<linalg::ContractionOpInterface>(op);
-    if (!contractionOp) return failure();
+    if (!isa<linalg::ContractionOpInterface>(op) && !isTileableConvOp(op)) {
+      return failure();
+    }
 
     linalg::TiledLinalgOp tiledLinalgOp;
     if (failed(Base::matchAndRewriteBase(op, rewriter, tiledLinalgOp)) ||
@@ -49,6 +53,19 @@ struct TileWorkgroups : public linalg::LinalgBaseTilingPattern {
     rewriter.eraseOp(op);
     return success();
   }
+
+ private:
+  /// Returns true if `op` is a convolution with a lowering configuration for
+  /// every tiling level, as set by the direct convolution heuristics.
+  static bool isTileableConvOp(Operation *op) {
+    if (!isa<linalg::ConvInputNHWCFilterHWCFOp,
+             linalg::DepthwiseConvInputNHWCFilterHWCOp>(op)) {
+      return false;
+    }
+    auto config = getLoweringConfig(op);
+    return config && getTileSizes(config).size() ==
+                         static_cast<unsigned>(TilingLevel::NumTileLevels);
+  }
 };
 
 }  // namespace
@@ -56,7 +73,10 @@ struct TileWorkgroups : public linalg::LinalgBaseTilingPattern {
 namespace {
 struct LLVMCPUVectorizationPass
     : public LLVMCPUVectorizationBase<LLVMCPUVectorizationPass> {
-  LLVMCPUVectorizationPass(bool vectorize = true) : lowerToVectors(vectorize) {}
+  LLVMCPUVectorizationPass(bool vectorize = true, bool peel = false)
+      : lowerToVectors(vectorize) {
+    peelPartialTiles = peel;
+  }
   LLVMCPUVectorizationPass(const LLVMCPUVectorizationPass &pass) {
     lowerToVectors = pass.lowerToVectors;
   }
@@ -85,6 +105,12 @@ struct LLVMCPUVectorizationPass
       llvm::cl::desc("Enable promoting wokgroup memory to full tiles allocated "
                      "on the stack."),
       llvm::cl::init(false)};
+
+  Option<bool> peelPartialTiles{
+      *this, "peel-partial-tiles",
+      llvm::cl::desc("Peel the partial tiles off the vector tile loops and "
+                     "vectorize them with masked transfers."),
+      llvm::cl::init(false)};
 };
 }  // namespace
 
@@ -143,6 +169,212 @@ LogicalResult deallocateWorkgroupMemory(OpBuilder &b, Value buffer) {
 
 }  // namespace
 
+namespace {
+
+/// Attribute marking the vector tile loops that remain to be peeled.
+const char kPeelLoopMarker[] = "__internal_iree_peel__";
+
+/// Replaces the affine.min ops in the body of `forOp` computing
+/// min(`step`, `upperBound` - iv) by `step`. This holds once the loop has been
+/// peeled so that all its iterations are at least `step` from `upperBound`.
+void foldFullTileMins(scf::ForOp forOp, Value upperBound, int64_t step) {
+  MLIRContext *context = forOp.getContext();
+  Value iv = forOp.getInductionVar();
+  SmallVector<AffineMinOp> fullTileMins;
+  forOp.walk([&](AffineMinOp minOp) {
+    AffineMap map = minOp.getAffineMap();
+    auto getOperandExpr = [&](Value value) -> AffineExpr {
+      for (auto operand : llvm::enumerate(minOp.getMapOperands())) {
+        if (operand.value() != value) continue;
+        if (operand.index() < map.getNumDims()) {
+          return getAffineDimExpr(operand.index(), context);
+        }
+        return getAffineSymbolExpr(operand.index() - map.getNumDims(),
+                                   context);
+      }
+      return AffineExpr();
+    };
+    AffineExpr ivExpr = getOperandExpr(iv);
+    AffineExpr upperBoundExpr = getOperandExpr(upperBound);
+    bool hasStep = false;
+    for (AffineExpr result : map.getResults()) {
+      if (auto constExpr = result.dyn_cast<AffineConstantExpr>()) {
+        if (constExpr.getValue() < step) return;
+        hasStep |= constExpr.getValue() == step;
+        continue;
+      }
+      if (!ivExpr || !upperBoundExpr) return;
+      // The result is at least `step` if it is at least `upperBound` - iv.
+      AffineExpr slack =
+          simplifyAffineExpr(result - (upperBoundExpr - ivExpr),
+                             map.getNumDims(), map.getNumSymbols());
+      auto slackExpr = slack.dyn_cast<AffineConstantExpr>();
+      if (!slackExpr || slackExpr.getValue() < 0) return;
+    }
+    if (hasStep) fullTileMins.push_back(minOp);
+  });
+  for (AffineMinOp minOp : fullTileMins) {
+    OpBuilder builder(minOp);
+    minOp.replaceAllUsesWith(
+        builder.create<ConstantIndexOp>(minOp.getLoc(), step).getResult());
+    minOp.erase();
+  }
+}
+
+/// Splits `forOp` into a main loop over the iterations that are at least a
+/// full step away from the upper bound, followed by a remainder loop with the
+/// last partial step. Loops without a constant step or that are known to
+/// divide evenly are left as is.
+void peelForLoop(OpBuilder &builder, scf::ForOp forOp) {
+  IntegerAttr stepAttr, lbAttr, ubAttr;
+  if (!matchPattern(forOp.step(), m_Constant(&stepAttr))) return;
+  int64_t step = stepAttr.getInt();
+  if (matchPattern(forOp.lowerBound(), m_Constant(&lbAttr)) &&
+      matchPattern(forOp.upperBound(), m_Constant(&ubAttr)) &&
+      (ubAttr.getInt() - lbAttr.getInt()) % step == 0) {
+    return;
+  }
+
+  Location loc = forOp.getLoc();
+  Value upperBound = forOp.upperBound();
+  builder.setInsertionPoint(forOp);
+  AffineExpr lb, ub;
+  bindSymbols(builder.getContext(), lb, ub);
+  Value splitBound = builder.createOrFold<AffineApplyOp>(
+      loc, AffineMap::get(0, 2, ub - (ub - lb) % step),
+      ValueRange{forOp.lowerBound(), upperBound});
+
+  builder.setInsertionPointAfter(forOp);
+  auto remainderLoop = cast<scf::ForOp>(builder.clone(*forOp));
+  remainderLoop.setLowerBound(splitBound);
+  forOp.setUpperBound(splitBound);
+  foldFullTileMins(forOp, upperBound, step);
+}
+
+/// Peels the partial tiles off the vector tile loops, i.e. the innermost loops
+/// around the ops to vectorize, so that the main loops only contain full
+/// vector tiles.
+void peelVectorTileLoops(FuncOp funcOp) {
+  MLIRContext *context = funcOp.getContext();
+  funcOp.walk([&](linalg::LinalgOp op) {
+    if (!hasMarker(op, getVectorizeMarker())) return;
+    SmallVector<int64_t, 4> tileSizes =
+        getTileSizes(op, static_cast<unsigned>(TilingLevel::Level2Tiles));
+    int64_t numLoops = llvm::count_if(
+        tileSizes, [](int64_t tileSize) { return tileSize != 0; });
+    auto forOp = op->getParentOfType<scf::ForOp>();
+    for (; forOp && numLoops > 0; --numLoops) {
+      forOp->setAttr(kPeelLoopMarker, UnitAttr::get(context));
+      forOp = forOp->getParentOfType<scf::ForOp>();
+    }
+  });
+
+  // Peel the outermost loops first; their inner loops are cloned along with
+  // the marker so they get peeled in both the main and remainder loops.
+  OpBuilder builder(context);
+  while (true) {
+    // Post-order walks visit the parents after their children, so the last
+    // marked loop visited has no marked ancestor.
+    scf::ForOp outermostLoop;
+    funcOp.walk([&](scf::ForOp forOp) {
+      if (forOp->hasAttr(kPeelLoopMarker)) outermostLoop = forOp;
+    });
+    if (!outermostLoop) break;
+    outermostLoop->removeAttr(kPeelLoopMarker);
+    peelForLoop(builder, outermostLoop);
+  }
+}
+
+/// Returns a static upper bound of the size of dimension `dim` of `memref`,
+/// looking through the affine.min ops that clamp the sizes of partial tiles.
+Optional<int64_t> getStaticUpperBound(Value memref, unsigned dim) {
+  auto memrefType = memref.getType().cast<MemRefType>();
+  if (!memrefType.isDynamicDim(dim)) return memrefType.getDimSize(dim);
+  auto subViewOp = memref.getDefiningOp<memref::SubViewOp>();
+  if (!subViewOp ||
+      subViewOp.getType().getRank() != subViewOp.getSourceType().getRank()) {
+    return llvm::None;
+  }
+  OpFoldResult size = subViewOp.getMixedSizes()[dim];
+  if (auto attr = size.dyn_cast<Attribute>()) {
+    return attr.cast<IntegerAttr>().getInt();
+  }
+  auto minOp = size.get<Value>().getDefiningOp<AffineMinOp>();
+  if (!minOp) return llvm::None;
+  Optional<int64_t> upperBound;
+  for (AffineExpr result : minOp.getAffineMap().getResults()) {
+    if (auto constExpr = result.dyn_cast<AffineConstantExpr>()) {
+      upperBound = upperBound ? std::min(*upperBound, constExpr.getValue())
+                              : constExpr.getValue();
+    }
+  }
+  return upperBound;
+}
+
+/// Vectorizes the partial vector tiles of linalg.matmul left by peeling, whose
+/// sizes are dynamic but bounded by the native vector size. The operands are
+/// read into full vectors with transfers that pad the out-of-bounds elements
+/// with zeros, which do not contribute to the contraction, and the result is
+/// written back with a transfer that masks out the padded elements.
+struct VectorizePartialMatmulTile : public OpRewritePattern<linalg::MatmulOp> {
+  VectorizePartialMatmulTile(MLIRContext *context,
+                             linalg::LinalgTransformationFilter filter)
+      : OpRewritePattern<linalg::MatmulOp>(context), filter(filter) {}
+
+  LogicalResult matchAndRewrite(linalg::MatmulOp op,
+                                PatternRewriter &rewriter) const override {
+    if (failed(filter.checkAndNotify(rewriter, op)) ||
+        !op.hasBufferSemantics()) {
+      return failure();
+    }
+    Value lhs = op.getInputOperand(0)->get();
+    Value rhs = op.getInputOperand(1)->get();
+    Value acc = op.getOutputOperand(0)->get();
+    Type elementType = acc.getType().cast<MemRefType>().getElementType();
+    auto isVectorizable = [&](Value operand) {
+      return operand.getType().cast<MemRefType>().getElementType() ==
+             elementType;
+    };
+    auto hasStaticShape = [](Value operand) {
+      return operand.getType().cast<MemRefType>().hasStaticShape();
+    };
+    if (!isVectorizable(lhs) || !isVectorizable(rhs) ||
+        (hasStaticShape(lhs) && hasStaticShape(rhs) && hasStaticShape(acc))) {
+      return failure();
+    }
+
+    SmallVector<int64_t, 4> nativeVectorSize = getNativeVectorSize(op);
+    Optional<int64_t> m = getStaticUpperBound(lhs, 0);
+    Optional<int64_t> k = getStaticUpperBound(lhs, 1);
+    Optional<int64_t> n = getStaticUpperBound(rhs, 1);
+    if (nativeVectorSize.size() != 3 || !m || !n || !k ||
+        *m > nativeVectorSize[0] || *n > nativeVectorSize[1] ||
+        *k > nativeVectorSize[2]) {
+      return failure();
+    }
+
+    Location loc = op.getLoc();
+    Value zero = rewriter.create<ConstantIndexOp>(loc, 0);
+    SmallVector<Value, 2> indices(2, zero);
+    auto read = [&](Value operand, ArrayRef<int64_t> shape) -> Value {
+      return rewriter.create<vector::TransferReadOp>(
+          loc, VectorType::get(shape, elementType), operand, indices);
+    };
+    Value contract = rewriter.create<vector::ContractionOp>(
+        loc, read(lhs, {*m, *k}), read(rhs, {*k, *n}), read(acc, {*m, *n}),
+        rewriter.getAffineMapArrayAttr(op.getIndexingMaps()),
+        op.iterator_types());
+    rewriter.create<vector::TransferWriteOp>(loc, contract, acc, indices);
+    rewriter.eraseOp(op);
+    return success();
+  }
+
+ private:
+  linalg::LinalgTransformationFilter filter;
+};
+
+}  // namespace
+
 void LLVMCPUVectorizationPass::runOnOperation() {
   auto funcOp = getOperation();
   MLIRContext *context = &getContext();
@@ -202,6 +434,10 @@ void LLVMCPUVectorizationPass::runOnOperation() {
     (void)applyPatternsAndFoldGreedily(funcOp, std::move(l2patterns));
   }
 
+  if (peelPartialTiles) {
+    peelVectorTileLoops(funcOp);
+  }
+
   // Apply canonicalization.
   {
     RewritePatternSet canonicalizationPatterns =
@@ -221,6 +457,10 @@ void LLVMCPUVectorizationPass::runOnOperation() {
   {
     RewritePatternSet vectorizeOpsPattenrs(context);
     populateLinalgToVectorVectorizeMMT4dPatterns(context, vectorizeOpsPattenrs);
+    populateLinalgToVectorVectorizeConvPatterns(
+        context, vectorizeOpsPattenrs,
+        linalg::LinalgTransformationFilter(
+            Identifier::get(getVectorizeMarker(), context)));
     if (failed(applyPatternsAndFoldGreedily(funcOp,
                                             std::move(vectorizeOpsPattenrs)))) {
       return signalPassFailure();
@@ -235,6 +475,11 @@ void LLVMCPUVectorizationPass::runOnOperation() {
         vectorizationPatterns, linalg::LinalgVectorizationOptions(),
         linalg::LinalgTransformationFilter(
             Identifier::get(getVectorizeMarker(), context)));
+    if (peelPartialTiles) {
+      vectorizationPatterns.add<VectorizePartialMatmulTile>(
+          context, linalg::LinalgTransformationFilter(
+                       Identifier::get(getVectorizeMarker(), context)));
+    }
     (void)applyPatternsAndFoldGreedily(funcOp,
                                        std::move(vectorizationPatterns));
   }
@@ -247,6 +492,16 @@ void LLVMCPUVectorizationPass::runOnOperation() {
       op->replaceAllUsesWith(contract);
   });
 
+  // Lower the contractions the target has mixed precision instructions for to
+  // custom kernels before they are lowered generically.
+  {
+    RewritePatternSet customKernelsPatterns(context);
+    populateVectorContractCustomKernelsPatterns(
+        getCustomKernelsTargetInfo(funcOp), customKernelsPatterns);
+    (void)applyPatternsAndFoldGreedily(funcOp,
+                                       std::move(customKernelsPatterns));
+  }
+
   if (enableVectorContractToAarch64Asm) {
     RewritePatternSet vectorToAArch64AsmPatterns(context);
     populateVectorContractToAArch64InlineAsm(vectorToAArch64AsmPatterns,
@@ -292,8 +547,9 @@ void LLVMCPUVectorizationPass::runOnOperation() {
 }
 
 std::unique_ptr<OperationPass<FuncOp>> createLLVMCPUVectorizationPass(
-    bool lowerToVectors) {
-  return std::make_unique<LLVMCPUVectorizationPass>(lowerToVectors);
+    bool lowerToVectors, bool peelPartialTiles) {
+  return std::make_unique<LLVMCPUVectorizationPass>(lowerToVectors,
+                                                    peelPartialTiles);
 }
 
 }  // namespace iree_compiler
@@ -23,6 +23,18 @@ static llvm::cl::opt<bool> clUseTensorPadTileAndVectorize(
     llvm::cl::desc("If enabled will use tensor -> vector transformation pass"),
     llvm::cl::init(false));
 
+static llvm::cl::opt<bool> clFastMathApproximations(
+    "iree-codegen-llvm-fast-math-approximations",
+    llvm::cl::desc("Use lower accuracy and cheaper polynomial approximations "
+                   "of exp, log, tanh and sigmoid"),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<int> clFftVectorSize(
+    "iree-codegen-llvm-fft-vector-size",
+    llvm::cl::desc("Number of FFT butterflies to compute at a time with "
+                   "vector ops, or 0 to use scalar loops"),
+    llvm::cl::init(4));
+
 static Value cpuAllocationFunction(OpBuilder &builder, Location loc,
                                    ArrayRef<int64_t> staticShape,
                                    Type elementType,
@@ -32,15 +44,19 @@ static Value cpuAllocationFunction(OpBuilder &builder, Location loc,
 }
 
 void addCPUVectorizationPassPipeline(OpPassManager &passManager,
-                                     bool lowerToVectors) {
+                                     bool lowerToVectors, bool padPartialTiles,
+                                     bool peelPartialTiles) {
   passManager.addPass(createCanonicalizerPass());
 
   // TODO(ataei): This causes segmentation fault on Android. Fix it and
   // re-enable.
   // passManager.addNestedPass<FuncOp>(createPadLinalgWorkgroupTilesPass());
 
-  if (clUseTensorPadTileAndVectorize) {
-    // Tile and vectorize linalg ops on tensors.
+  // Padding produces vector ops regardless of `lowerToVectors`.
+  bool tileOnTensors =
+      clUseTensorPadTileAndVectorize || (padPartialTiles && lowerToVectors);
+  if (tileOnTensors) {
+    // Tile, pad and vectorize linalg ops on tensors.
     passManager.addNestedPass<FuncOp>(createLLVMCPUTilePadAndVectorizePass());
     passManager.addNestedPass<FuncOp>(createCSEPass());
     passManager.addNestedPass<FuncOp>(createCanonicalizerPass());
@@ -51,10 +67,10 @@ void addCPUVectorizationPassPipeline(OpPassManager &passManager,
   passManager.addNestedPass<FuncOp>(createCSEPass());
   passManager.addNestedPass<FuncOp>(createCanonicalizerPass());
 
-  if (!clUseTensorPadTileAndVectorize) {
+  if (!tileOnTensors) {
     // Tile and vectorize linalg ops on buffers.
     passManager.addNestedPass<FuncOp>(
-        createLLVMCPUVectorizationPass(lowerToVectors));
+        createLLVMCPUVectorizationPass(lowerToVectors, peelPartialTiles));
     passManager.addNestedPass<FuncOp>(createCSEPass());
     passManager.addNestedPass<FuncOp>(createCanonicalizerPass());
   }
@@ -75,7 +91,8 @@ static void addLowerToLLVMPasses(
     OpPassManager &passManager,
     const LLVMCPUCodegenPassPipelineOptions &options) {
   // LinalgExt -> SCF
-  passManager.addNestedPass<FuncOp>(linalg_ext::createLinalgExtToLoopsPass());
+  passManager.addNestedPass<FuncOp>(
+      linalg_ext::createLinalgExtToLoopsPass(clFftVectorSize));
 
   // Linalg -> SCF
   passManager.addNestedPass<FuncOp>(createConvertLinalgToLoopsPass());
@@ -91,6 +108,11 @@ static void addLowerToLLVMPasses(
   passManager.addPass(createTensorConstantBufferizePass());
   passManager.addPass(createFoldTensorExtractOpPass());
 
+  // Expand elementary functions into polynomials that vectorize instead of
+  // scalar libm calls.
+  passManager.addNestedPass<FuncOp>(
+      createLLVMCPUMathApproximationPass(clFastMathApproximations));
+
   // (HAL, IREE, Linalg, STD) -> LLVM
   passManager.addPass(createConvertToLLVMPass(
       options.targetTriple, options.targetDataLayout, options.unfuseFMAOps));
@@ -0,0 +1,175 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Codegen/LLVMCPU/TuningDatabase.h"
+
+#include "iree/compiler/Codegen/Utils/Utils.h"
+#include "iree/compiler/Dialect/HAL/IR/HALOps.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/IR/BuiltinTypes.h"
+
+namespace mlir {
+namespace iree_compiler {
+
+/// Returns |type| as a shape string such as `128x?xf32`.
+static std::string getShapeString(Type type) {
+  std::string str;
+  llvm::raw_string_ostream os(str);
+  if (auto shapedType = type.dyn_cast<ShapedType>()) {
+    if (shapedType.hasRank()) {
+      for (int64_t dim : shapedType.getShape()) {
+        if (ShapedType::isDynamic(dim)) {
+          os << "?";
+        } else {
+          os << dim;
+        }
+        os << "x";
+      }
+    }
+    os << shapedType.getElementType();
+  } else {
+    os << type;
+  }
+  return os.str();
+}
+
+/// Returns the target |variantOp| is compiled for. Backends that know the
+/// target machine pack it into the executable target configuration.
+static std::string getTargetString(IREE::HAL::ExecutableVariantOp variantOp) {
+  if (!variantOp) return "";
+  auto targetAttr = variantOp.target();
+  if (auto configAttr = targetAttr.getConfiguration()) {
+    if (auto tripleAttr = configAttr.getAs<StringAttr>("target_triple")) {
+      std::string target = tripleAttr.getValue().str();
+      if (auto featuresAttr = configAttr.getAs<StringAttr>("cpu_features")) {
+        target += ":" + featuresAttr.getValue().str();
+      }
+      return target;
+    }
+  }
+  return targetAttr.getFormat().getValue().str();
+}
+
+TuningKey TuningKey::get(Operation *op) {
+  TuningKey key;
+  key.op = op->getName().getStringRef().str();
+  for (auto operand : op->getOperands()) {
+    key.shapes.push_back(getShapeString(getUntiledType(operand)));
+  }
+  key.target =
+      getTargetString(op->getParentOfType<IREE::HAL::ExecutableVariantOp>());
+  return key;
+}
+
+std::string TuningKey::str() const {
+  std::string str;
+  llvm::raw_string_ostream os(str);
+  os << op << "(";
+  llvm::interleaveComma(shapes, os);
+  os << ")@" << target;
+  return os.str();
+}
+
+/// Parses a JSON array of integers into |values|.
+static bool parseIntList(const llvm::json::Value *value,
+                         SmallVectorImpl<int64_t> &values) {
+  auto *array = value ? value->getAsArray() : nullptr;
+  if (!array) return false;
+  for (auto &element : *array) {
+    auto intValue = element.getAsInteger();
+    if (!intValue) return false;
+    values.push_back(*intValue);
+  }
+  return true;
+}
+
+std::unique_ptr<TuningDatabase> TuningDatabase::load(
+    StringRef path, std::string &errorMessage) {
+  auto fileData = llvm::MemoryBuffer::getFile(path);
+  if (!fileData) {
+    errorMessage = "failed to open tuning database '" + path.str() +
+                   "': " + fileData.getError().message();
+    return nullptr;
+  }
+  auto json = llvm::json::parse(fileData.get()->getBuffer());
+  if (!json) {
+    errorMessage = "failed to parse tuning database '" + path.str() +
+                   "': " + llvm::toString(json.takeError());
+    return nullptr;
+  }
+  auto *entries = json->getAsArray();
+  if (!entries) {
+    errorMessage = "tuning database must be an array of entries";
+    return nullptr;
+  }
+
+  auto database = std::make_unique<TuningDatabase>();
+  for (auto &entryValue : *entries) {
+    auto *entry = entryValue.getAsObject();
+    auto *shapes = entry ? entry->getArray("shapes") : nullptr;
+    auto *tileSizes = entry ? entry->getArray("tile_sizes") : nullptr;
+    if (!shapes || !tileSizes || !entry->getString("op") ||
+        !entry->getString("target")) {
+      errorMessage = "tuning database entries must have 'op', 'shapes', "
+                     "'target', and 'tile_sizes' fields";
+      return nullptr;
+    }
+    TuningKey key;
+    key.op = entry->getString("op")->str();
+    key.target = entry->getString("target")->str();
+    for (auto &shape : *shapes) {
+      auto shapeStr = shape.getAsString();
+      if (!shapeStr) {
+        errorMessage = "tuning database shapes must be strings";
+        return nullptr;
+      }
+      key.shapes.push_back(shapeStr->str());
+    }
+
+    TuningConfig config;
+    for (auto &level : *tileSizes) {
+      if (!parseIntList(&level, config.tileSizes.emplace_back())) {
+        errorMessage = "tuning database tile sizes must be lists of integers";
+        return nullptr;
+      }
+    }
+    if (auto *nativeVectorSize = entry->get("native_vector_size")) {
+      if (!parseIntList(nativeVectorSize, config.nativeVectorSize)) {
+        errorMessage =
+            "tuning database native vector size must be a list of integers";
+        return nullptr;
+      }
+    }
+    database->configs[key.str()] = std::move(config);
+  }
+  return database;
+}
+
+const TuningConfig *TuningDatabase::lookup(const TuningKey &key) const {
+  auto it = configs.find(key.str());
+  return it == configs.end() ? nullptr : &it->second;
+}
+
+llvm::json::Object serializeTuningEntry(const TuningKey &key,
+                                        const TuningConfig &config) {
+  llvm::json::Array shapes;
+  for (auto &shape : key.shapes) shapes.push_back(shape);
+  llvm::json::Array tileSizes;
+  for (auto &level : config.tileSizes) {
+    tileSizes.push_back(llvm::json::Array(level));
+  }
+  return llvm::json::Object{
+      {"op", key.op},
+      {"shapes", std::move(shapes)},
+      {"target", key.target},
+      {"tile_sizes", std::move(tileSizes)},
+      {"native_vector_size", llvm::json::Array(config.nativeVectorSize)},
+  };
+}
+
+}  // namespace iree_compiler
+}  // namespace mlir
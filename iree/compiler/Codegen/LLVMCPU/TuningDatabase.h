@@ -0,0 +1,78 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_COMPILER_CODEGEN_LLVMCPU_TUNINGDATABASE_H_
+#define IREE_COMPILER_CODEGEN_LLVMCPU_TUNINGDATABASE_H_
+
+#include <string>
+
+#include "iree/compiler/Dialect/HAL/IR/LoweringConfig.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/JSON.h"
+#include "mlir/IR/Operation.h"
+
+namespace mlir {
+namespace iree_compiler {
+
+/// Lowering configuration of a tuned op.
+struct TuningConfig {
+  TileSizesListType tileSizes;
+  SmallVector<int64_t, 4> nativeVectorSize;
+};
+
+/// Identifies an op being tuned: the op name, the untiled shapes of its
+/// operands (such as `128x384xf32`), and the target it is being compiled for
+/// (the target triple and CPU features when known, otherwise the executable
+/// format).
+struct TuningKey {
+  std::string op;
+  SmallVector<std::string, 4> shapes;
+  std::string target;
+
+  /// Returns the key identifying |op| when compiled for the
+  /// hal.executable.variant it is nested within.
+  static TuningKey get(Operation *op);
+
+  /// Returns the key as a string usable for lookups.
+  std::string str() const;
+};
+
+/// Database of tuned lowering configurations keyed by TuningKey.
+///
+/// Databases are stored as JSON arrays of entries with one entry per tuned op:
+///   [
+///     {
+///       "op": "linalg.matmul",
+///       "shapes": ["128x384xf32", "384x512xf32", "128x512xf32"],
+///       "target": "x86_64-unknown-linux-gnu:+avx,+avx2,+fma",
+///       "tile_sizes": [[64, 64], [32, 32, 32], [4, 4, 4]],
+///       "native_vector_size": [4, 4, 4]
+///     },
+///     ...
+///   ]
+class TuningDatabase {
+ public:
+  /// Loads the database stored at |path|. On failure |errorMessage| is set and
+  /// nullptr is returned.
+  static std::unique_ptr<TuningDatabase> load(StringRef path,
+                                              std::string &errorMessage);
+
+  /// Returns the tuned configuration for |key|, if any.
+  const TuningConfig *lookup(const TuningKey &key) const;
+
+ private:
+  llvm::StringMap<TuningConfig> configs;
+};
+
+/// Returns the JSON representation of |key| and |config| as stored in the
+/// tuning database.
+llvm::json::Object serializeTuningEntry(const TuningKey &key,
+                                        const TuningConfig &config);
+
+}  // namespace iree_compiler
+}  // namespace mlir
+
+#endif  // IREE_COMPILER_CODEGEN_LLVMCPU_TUNINGDATABASE_H_
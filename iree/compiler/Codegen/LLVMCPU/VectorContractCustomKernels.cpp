@@ -0,0 +1,372 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Codegen/PassDetail.h"
+#include "iree/compiler/Codegen/Passes.h"
+#include "iree/compiler/Dialect/HAL/IR/HALOps.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/Triple.h"
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/Dialect/Utils/StructuredOpsUtils.h"
+#include "mlir/Dialect/Vector/VectorOps.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+namespace mlir {
+namespace iree_compiler {
+
+CustomKernelsTargetInfo inferCustomKernelsTargetInfo(StringRef targetTriple,
+                                                     StringRef cpuFeatures) {
+  CustomKernelsTargetInfo targetInfo;
+  llvm::Triple triple(targetTriple);
+  targetInfo.isAArch64 = triple.isAArch64();
+  targetInfo.isX86_64 = triple.getArch() == llvm::Triple::x86_64;
+  targetInfo.isRISCV = triple.isRISCV();
+  bool hasRVV = false;
+  SmallVector<StringRef> features;
+  cpuFeatures.split(features, ',', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+  for (StringRef feature : features) {
+    feature = feature.trim();
+    if (targetInfo.isAArch64) {
+      if (feature == "+i8mm") targetInfo.hasI8MM = true;
+      if (feature == "+bf16") targetInfo.hasBF16 = true;
+      if (feature == "+sve" || feature == "+sve2") targetInfo.hasSVE = true;
+    } else if (targetInfo.isX86_64) {
+      if (feature == "+avx512vnni") targetInfo.hasAVX512VNNI = true;
+      if (feature == "+avx512bf16") targetInfo.hasAVX512BF16 = true;
+    } else if (targetInfo.isRISCV) {
+      if (feature == "+v" || feature == "+experimental-v") hasRVV = true;
+      int64_t vectorBits = 0;
+      if (feature.consume_front("+zvl") && feature.consume_back("b") &&
+          !feature.getAsInteger(10, vectorBits)) {
+        targetInfo.riscvVectorBits =
+            std::max(targetInfo.riscvVectorBits, vectorBits);
+      }
+    }
+  }
+  // The vector extension guarantees a VLEN of at least 128 bits.
+  if (!hasRVV) {
+    targetInfo.riscvVectorBits = 0;
+  } else if (targetInfo.riscvVectorBits < 128) {
+    targetInfo.riscvVectorBits = 128;
+  }
+  return targetInfo;
+}
+
+CustomKernelsTargetInfo getCustomKernelsTargetInfo(Operation *op) {
+  auto variantOp = op->getParentOfType<IREE::HAL::ExecutableVariantOp>();
+  if (!variantOp) return {};
+  auto configAttr = variantOp.target().getConfiguration();
+  if (!configAttr) return {};
+  auto tripleAttr = configAttr.getAs<StringAttr>("target_triple");
+  auto featuresAttr = configAttr.getAs<StringAttr>("cpu_features");
+  return inferCustomKernelsTargetInfo(
+      tripleAttr ? tripleAttr.getValue() : "",
+      featuresAttr ? featuresAttr.getValue() : "");
+}
+
+namespace {
+
+/// Returns true if |contractionOp| is a plain row-major matrix multiplication
+/// C(m, n) += A(m, k) * B(k, n) on 2-D vectors, which is the form the mmt4d
+/// inner tiles are vectorized to.
+static bool isRowMajorMatmul(vector::ContractionOp contractionOp) {
+  if (contractionOp.getLhsType().getRank() != 2 ||
+      contractionOp.getRhsType().getRank() != 2 ||
+      !contractionOp.getAccType().isa<VectorType>()) {
+    return false;
+  }
+  if (!isParallelIterator(contractionOp.iterator_types()[0]) ||
+      !isParallelIterator(contractionOp.iterator_types()[1]) ||
+      !isReductionIterator(contractionOp.iterator_types()[2])) {
+    return false;
+  }
+  MLIRContext *context = contractionOp.getContext();
+  AffineExpr m, n, k;
+  bindDims(context, m, n, k);
+  auto expectedMaps = AffineMap::inferFromExprList({{m, k}, {k, n}, {m, n}});
+  return contractionOp.getIndexingMaps() == expectedMaps;
+}
+
+/// Returns |value| as a vector of |narrowType| elements: either |value| itself
+/// or the source of the extension op that widened it. Returns nullptr if
+/// |value| is neither.
+static Value getNarrowSource(Value value, Type narrowType) {
+  if (value.getType().cast<VectorType>().getElementType() == narrowType) {
+    return value;
+  }
+  Value source;
+  if (auto extOp = value.getDefiningOp<SignExtendIOp>()) {
+    source = extOp.value();
+  } else if (auto extOp = value.getDefiningOp<FPExtOp>()) {
+    source = extOp.in();
+  }
+  if (!source ||
+      source.getType().cast<VectorType>().getElementType() != narrowType) {
+    return nullptr;
+  }
+  return source;
+}
+
+static LLVM::InlineAsmOp createInlineAsm(Location loc, Type resultType,
+                                         ArrayRef<Value> operands,
+                                         StringRef asmString,
+                                         StringRef constraints,
+                                         PatternRewriter &rewriter) {
+  return rewriter.create<LLVM::InlineAsmOp>(
+      loc, resultType, operands, asmString, constraints,
+      /*has_side_effects=*/false, /*is_align_stack=*/false,
+      LLVM::AsmDialectAttr::get(rewriter.getContext(),
+                                LLVM::AsmDialect::AD_ATT));
+}
+
+/// Converts a M0xK0xN0 vector contraction to AArch64 matrix multiply
+/// accumulate instructions (SMMLA with +i8mm and BFMMLA with +bf16). Each
+/// instruction multiplies a 2xK0 tile of A with the transpose of a K0x2 tile of
+/// B and accumulates into a 2x2 tile of C so B is transposed once up front and
+/// the contraction is unrolled over the 2x2 tiles of C.
+struct ContractToAArch64MatrixMultiplyAccumulatePattern
+    : public OpRewritePattern<vector::ContractionOp> {
+  ContractToAArch64MatrixMultiplyAccumulatePattern(
+      MLIRContext *context, Type narrowType, Type accElementType, int64_t K0,
+      StringRef asmString)
+      : OpRewritePattern<vector::ContractionOp>(context),
+        narrowType(narrowType),
+        accElementType(accElementType),
+        K0(K0),
+        asmString(asmString) {}
+
+  LogicalResult matchAndRewrite(vector::ContractionOp contractionOp,
+                                PatternRewriter &rewriter) const override {
+    if (!isRowMajorMatmul(contractionOp)) return failure();
+    auto accType = contractionOp.getAccType().cast<VectorType>();
+    if (accType.getElementType() != accElementType) return failure();
+    int64_t M0 = accType.getShape()[0];
+    int64_t N0 = accType.getShape()[1];
+    if (M0 % 2 != 0 || N0 % 2 != 0 ||
+        contractionOp.getLhsType().getShape()[1] != K0) {
+      return failure();
+    }
+
+    Value lhs = getNarrowSource(contractionOp.lhs(), narrowType);
+    Value rhs = getNarrowSource(contractionOp.rhs(), narrowType);
+    if (!lhs || !rhs) return failure();
+
+    auto loc = contractionOp.getLoc();
+    Value rhsTransposed = rewriter.create<vector::TransposeOp>(
+        loc, rhs, ArrayRef<int64_t>({1, 0}));
+
+    auto operandType = VectorType::get({2 * K0}, narrowType);
+    auto tileType = VectorType::get({4}, accElementType);
+    auto tileType2D = VectorType::get({2, 2}, accElementType);
+    auto getRowPair = [&](Value matrix, int64_t row) -> Value {
+      Value rows = rewriter.create<vector::ExtractStridedSliceOp>(
+          loc, matrix, ArrayRef<int64_t>({row, 0}),
+          ArrayRef<int64_t>({2, K0}), ArrayRef<int64_t>({1, 1}));
+      return rewriter.create<vector::ShapeCastOp>(loc, operandType, rows);
+    };
+
+    Value result = contractionOp.acc();
+    for (int64_t i = 0; i < M0; i += 2) {
+      Value lhsRows = getRowPair(lhs, i);
+      for (int64_t j = 0; j < N0; j += 2) {
+        Value rhsCols = getRowPair(rhsTransposed, j);
+        Value accTile = rewriter.create<vector::ExtractStridedSliceOp>(
+            loc, contractionOp.acc(), ArrayRef<int64_t>({i, j}),
+            ArrayRef<int64_t>({2, 2}), ArrayRef<int64_t>({1, 1}));
+        accTile = rewriter.create<vector::ShapeCastOp>(loc, tileType, accTile);
+        auto asmOp = createInlineAsm(loc, tileType, {accTile, lhsRows, rhsCols},
+                                     asmString, "=w,0,w,w", rewriter);
+        Value resultTile = rewriter.create<vector::ShapeCastOp>(
+            loc, tileType2D, asmOp.res());
+        result = rewriter.create<vector::InsertStridedSliceOp>(
+            loc, resultTile, result, ArrayRef<int64_t>({i, j}),
+            ArrayRef<int64_t>({1, 1}));
+      }
+    }
+    rewriter.replaceOp(contractionOp, result);
+    return success();
+  }
+
+ private:
+  Type narrowType;
+  Type accElementType;
+  int64_t K0;
+  std::string asmString;
+};
+
+/// Converts a M0xK0x16 vector contraction to x86 AVX-512 pairwise dot product
+/// instructions (VPDPWSSD with +avx512vnni and VDPBF16PS with +avx512bf16).
+/// Each instruction accumulates the products of pairs of consecutive
+/// |operandElementType| elements into the 16 lanes of a row of C; for row m
+/// and the rows 2p and 2p+1 of B the lhs operand is the pair
+/// (A[m][2p], A[m][2p+1]) broadcast to all lanes and the rhs operand the
+/// interleaving of the two rows of B.
+struct ContractToX86PairwiseDotProductPattern
+    : public OpRewritePattern<vector::ContractionOp> {
+  ContractToX86PairwiseDotProductPattern(MLIRContext *context, Type narrowType,
+                                         Type operandElementType,
+                                         Type accElementType,
+                                         StringRef mnemonic)
+      : OpRewritePattern<vector::ContractionOp>(context),
+        narrowType(narrowType),
+        operandElementType(operandElementType),
+        accElementType(accElementType),
+        mnemonic(mnemonic) {}
+
+  LogicalResult matchAndRewrite(vector::ContractionOp contractionOp,
+                                PatternRewriter &rewriter) const override {
+    static constexpr int64_t kNumLanes = 16;
+    if (!isRowMajorMatmul(contractionOp)) return failure();
+    auto accType = contractionOp.getAccType().cast<VectorType>();
+    if (accType.getElementType() != accElementType) return failure();
+    int64_t M0 = accType.getShape()[0];
+    int64_t N0 = accType.getShape()[1];
+    int64_t K0 = contractionOp.getLhsType().getShape()[1];
+    if (N0 != kNumLanes || K0 % 2 != 0) return failure();
+
+    Value lhs = getNarrowSource(contractionOp.lhs(), narrowType);
+    Value rhs = getNarrowSource(contractionOp.rhs(), narrowType);
+    if (!lhs || !rhs) return failure();
+
+    auto loc = contractionOp.getLoc();
+    // The instructions multiply 16-bit elements; narrower integers are sign
+    // extended to them.
+    auto extend = [&](Value value) -> Value {
+      if (narrowType == operandElementType) return value;
+      auto vectorType = value.getType().cast<VectorType>();
+      return rewriter.create<SignExtendIOp>(
+          loc, VectorType::get(vectorType.getShape(), operandElementType),
+          value);
+    };
+    lhs = extend(lhs);
+    rhs = extend(rhs);
+
+    SmallVector<int64_t> broadcastMask;
+    SmallVector<int64_t> interleaveMask;
+    for (int64_t n = 0; n < kNumLanes; ++n) {
+      broadcastMask.append({0, 1});
+      interleaveMask.append({n, kNumLanes + n});
+    }
+    SmallVector<Value> rhsPairs;
+    for (int64_t p = 0; p < K0; p += 2) {
+      Value row0 = rewriter.create<vector::ExtractOp>(loc, rhs, p);
+      Value row1 = rewriter.create<vector::ExtractOp>(loc, rhs, p + 1);
+      rhsPairs.push_back(
+          rewriter.create<vector::ShuffleOp>(loc, row0, row1, interleaveMask));
+    }
+
+    // AT&T operand order: source 2, source 1, destination.
+    std::string asmString = (mnemonic + " $3, $2, $0").str();
+    auto rowType = VectorType::get({kNumLanes}, accElementType);
+    Value result = contractionOp.acc();
+    for (int64_t m = 0; m < M0; ++m) {
+      Value lhsRow = rewriter.create<vector::ExtractOp>(loc, lhs, m);
+      Value accRow =
+          rewriter.create<vector::ExtractOp>(loc, contractionOp.acc(), m);
+      for (int64_t p = 0; p < K0; p += 2) {
+        Value lhsPair = rewriter.create<vector::ExtractStridedSliceOp>(
+            loc, lhsRow, ArrayRef<int64_t>({p}), ArrayRef<int64_t>({2}),
+            ArrayRef<int64_t>({1}));
+        Value lhsBroadcast = rewriter.create<vector::ShuffleOp>(
+            loc, lhsPair, lhsPair, broadcastMask);
+        auto asmOp =
+            createInlineAsm(loc, rowType, {accRow, lhsBroadcast, rhsPairs[p / 2]},
+                            asmString, "=v,0,v,v", rewriter);
+        accRow = asmOp.res();
+      }
+      result = rewriter.create<vector::InsertOp>(loc, accRow, result, m);
+    }
+    rewriter.replaceOp(contractionOp, result);
+    return success();
+  }
+
+ private:
+  Type narrowType;
+  Type operandElementType;
+  Type accElementType;
+  std::string mnemonic;
+};
+
+struct VectorContractCustomKernelsPass
+    : public VectorContractCustomKernelsBase<VectorContractCustomKernelsPass> {
+  VectorContractCustomKernelsPass() = default;
+  VectorContractCustomKernelsPass(const VectorContractCustomKernelsPass &pass) {
+  }
+
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<vector::VectorDialect, LLVM::LLVMDialect>();
+  }
+
+  void runOnOperation() override {
+    MLIRContext *context = &getContext();
+    auto targetInfo =
+        targetTriple.empty()
+            ? getCustomKernelsTargetInfo(getOperation())
+            : inferCustomKernelsTargetInfo(targetTriple, targetCPUFeatures);
+    OwningRewritePatternList patterns(context);
+    populateVectorContractCustomKernelsPatterns(targetInfo, patterns);
+    if (failed(applyPatternsAndFoldGreedily(getOperation(),
+                                            std::move(patterns)))) {
+      signalPassFailure();
+    }
+  }
+
+ private:
+  Option<std::string> targetTriple{
+      *this, "target-triple",
+      llvm::cl::desc("Target triple to select the kernels for; defaults to the "
+                     "one of the enclosing hal.executable.variant"),
+      llvm::cl::init("")};
+  Option<std::string> targetCPUFeatures{
+      *this, "target-cpu-features",
+      llvm::cl::desc("Comma-separated target CPU features to select the "
+                     "kernels for"),
+      llvm::cl::init("")};
+};
+
+}  // namespace
+
+void populateVectorContractCustomKernelsPatterns(
+    const CustomKernelsTargetInfo &targetInfo,
+    OwningRewritePatternList &patterns) {
+  MLIRContext *context = patterns.getContext();
+  Builder builder(context);
+  Type i8Type = builder.getIntegerType(8);
+  Type i16Type = builder.getIntegerType(16);
+  Type i32Type = builder.getIntegerType(32);
+  Type bf16Type = builder.getBF16Type();
+  Type f32Type = builder.getF32Type();
+  if (targetInfo.isAArch64) {
+    if (targetInfo.hasI8MM) {
+      patterns.insert<ContractToAArch64MatrixMultiplyAccumulatePattern>(
+          context, i8Type, i32Type, /*K0=*/8, "smmla $0.4s, $2.16b, $3.16b");
+    }
+    if (targetInfo.hasBF16) {
+      patterns.insert<ContractToAArch64MatrixMultiplyAccumulatePattern>(
+          context, bf16Type, f32Type, /*K0=*/4, "bfmmla $0.4s, $2.8h, $3.8h");
+    }
+  } else if (targetInfo.isX86_64) {
+    if (targetInfo.hasAVX512VNNI) {
+      patterns.insert<ContractToX86PairwiseDotProductPattern>(
+          context, i8Type, i16Type, i32Type, "vpdpwssd");
+    }
+    if (targetInfo.hasAVX512BF16) {
+      patterns.insert<ContractToX86PairwiseDotProductPattern>(
+          context, bf16Type, bf16Type, f32Type, "vdpbf16ps");
+    }
+  }
+}
+
+std::unique_ptr<OperationPass<FuncOp>> createVectorContractCustomKernelsPass() {
+  return std::make_unique<VectorContractCustomKernelsPass>();
+}
+
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -0,0 +1,66 @@
+// RUN: iree-opt -pass-pipeline="hal.executable(hal.executable.variant(iree-llvmcpu-lower-executable-target{use-lowering-pipeline='builtin.func(iree-llvmcpu-vectorization)'}))" -split-input-file %s | IreeFileCheck %s
+
+#config = {nativeVectorSize = [1, 1, 4, 8, 1, 1, 4], tileSizes = [[0, 8, 16, 32], [1, 1, 16, 32, 1, 1, 16], [1, 1, 4, 8, 1, 1, 4]]}
+hal.executable @conv_static attributes {sym_visibility = "private"} {
+  hal.interface @io {
+    hal.interface.binding @arg0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @arg1, set=0, binding=1, type="StorageBuffer", access="Read"
+    hal.interface.binding @ret0, set=0, binding=2, type="StorageBuffer", access="Write|Discard"
+  }
+  hal.executable.variant @llvm, target = #hal.executable.target<"llvm", "embedded-elf-x86_64"> {
+    hal.executable.entry_point @conv_static attributes {
+      interface = @io,
+      ordinal = 0 : index
+    }
+    module {
+      func @conv_static() {
+        %c0 = constant 0 : index
+        %c32 = constant 32 : index
+        %c112 = constant 112 : index
+        %0 = hal.interface.binding.subspan @io::@arg0[%c0] : memref<1x225x225x16xf32>
+        %1 = hal.interface.binding.subspan @io::@arg1[%c0] : memref<3x3x16x32xf32>
+        %2 = hal.interface.binding.subspan @io::@ret0[%c0] : memref<1x112x112x32xf32>
+        %workgroup_id_x = hal.interface.workgroup.id[0] : index
+        %workgroup_count_x = hal.interface.workgroup.count[0] : index
+        %workgroup_id_y = hal.interface.workgroup.id[1] : index
+        %workgroup_count_y = hal.interface.workgroup.count[1] : index
+        %workgroup_id_z = hal.interface.workgroup.id[2] : index
+        %workgroup_count_z = hal.interface.workgroup.count[2] : index
+        %3 = affine.apply affine_map<()[s0] -> (s0 * 8)>()[%workgroup_id_z]
+        %4 = affine.apply affine_map<()[s0] -> (s0 * 8)>()[%workgroup_count_z]
+        scf.for %arg0 = %3 to %c112 step %4 {
+          %5 = affine.apply affine_map<()[s0] -> (s0 * 16)>()[%workgroup_id_y]
+          %6 = affine.apply affine_map<()[s0] -> (s0 * 16)>()[%workgroup_count_y]
+          scf.for %arg1 = %5 to %c112 step %6 {
+            %7 = affine.apply affine_map<()[s0] -> (s0 * 32)>()[%workgroup_id_x]
+            %8 = affine.apply affine_map<()[s0] -> (s0 * 32)>()[%workgroup_count_x]
+            scf.for %arg2 = %7 to %c32 step %8 {
+              %9 = affine.apply affine_map<(d0) -> (d0 * 2)>(%arg0)
+              %10 = affine.apply affine_map<(d0) -> (d0 * 2)>(%arg1)
+              %11 = memref.subview %0[0, %9, %10, 0] [1, 17, 33, 16] [1, 1, 1, 1] : memref<1x225x225x16xf32> to memref<1x17x33x16xf32, affine_map<(d0, d1, d2, d3)[s0] -> (d0 * 810000 + s0 + d1 * 3600 + d2 * 16 + d3)>>
+              %12 = memref.subview %1[0, 0, 0, %arg2] [3, 3, 16, 32] [1, 1, 1, 1] : memref<3x3x16x32xf32> to memref<3x3x16x32xf32, affine_map<(d0, d1, d2, d3)[s0] -> (d0 * 1536 + s0 + d1 * 512 + d2 * 32 + d3)>>
+              %13 = memref.subview %2[0, %arg0, %arg1, %arg2] [1, 8, 16, 32] [1, 1, 1, 1] : memref<1x112x112x32xf32> to memref<1x8x16x32xf32, affine_map<(d0, d1, d2, d3)[s0] -> (d0 * 401408 + s0 + d1 * 3584 + d2 * 32 + d3)>>
+              linalg.conv_2d_input_nhwc_filter_hwcf {__internal_linalg_transform__ = "workgroup", lowering.config = #config, dilations = dense<1> : tensor<2xi64>, strides = dense<2> : tensor<2xi64>} ins(%11, %12 : memref<1x17x33x16xf32, affine_map<(d0, d1, d2, d3)[s0] -> (d0 * 810000 + s0 + d1 * 3600 + d2 * 16 + d3)>>, memref<3x3x16x32xf32, affine_map<(d0, d1, d2, d3)[s0] -> (d0 * 1536 + s0 + d1 * 512 + d2 * 32 + d3)>>) outs(%13 : memref<1x8x16x32xf32, affine_map<(d0, d1, d2, d3)[s0] -> (d0 * 401408 + s0 + d1 * 3584 + d2 * 32 + d3)>>)
+            }
+          }
+        }
+        return
+      }
+    }
+  }
+}
+// CHECK-LABEL: func @conv_static
+//   CHECK-NOT:   linalg.conv_2d_input_nhwc_filter_hwcf
+//       CHECK:   scf.for
+//       CHECK:     scf.for
+//       CHECK:       scf.for
+// L1 tiles walk the output rows and the filter window one tap at a time.
+//       CHECK:         scf.for %{{.+}} = %{{.+}} to %c8 step %c1
+//       CHECK:           scf.for %{{.+}} = %{{.+}} to %c3 step %c1
+//       CHECK:             scf.for %{{.+}} = %{{.+}} to %c3 step %c1
+// Vector tiles over the output width, output channels and input channels.
+//       CHECK:               scf.for %{{.+}} = %{{.+}} to %c16 step %c4
+//       CHECK:                 scf.for %{{.+}} = %{{.+}} to %c32 step %c8
+//       CHECK:                   scf.for %{{.+}} = %{{.+}} to %c16 step %c4
+//       CHECK:                     vector.outerproduct
+//   CHECK-NOT:   linalg.conv_2d_input_nhwc_filter_hwcf
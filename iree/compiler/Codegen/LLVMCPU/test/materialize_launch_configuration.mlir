@@ -172,6 +172,7 @@ hal.executable @add attributes {sym_visibility = "private"} {
 //  CHECK-DAG: #[[CONFIG:.+]] = {tileSizes = {{\[}}[64, 64]{{\]}}}
 //  CHECK-DAG: #[[MAP0:.+]] = affine_map<()[s0] -> (s0 ceildiv 64)>
 //      CHECK: hal.executable.entry_point @add
+// CHECK-SAME:   workgroup_cost_hint = 4096
 // CHECK-NEXT:   (%[[ARG0:[a-zA-Z0-9_]+]]: index
 // CHECK-SAME:    %[[ARG1:[a-zA-Z0-9_]+]]: index
 // CHECK-SAME:    %[[ARG2:[a-zA-Z0-9_]+]]: index)
@@ -352,3 +353,196 @@ hal.executable @batch_matmul_tensors attributes {sym_visibility = "private"} {
 //      CHECK:  hal.return %[[D0]], %[[D1]], %[[ARG2]]
 //      CHECK:  linalg.batch_matmul
 // CHECK-SAME:    lowering.config = #[[CONFIG]]
+
+// -----
+
+hal.executable @conv_static attributes {sym_visibility = "private"} {
+  hal.interface @io {
+    hal.interface.binding @arg0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @arg1, set=0, binding=1, type="StorageBuffer", access="Read"
+    hal.interface.binding @ret0, set=0, binding=2, type="StorageBuffer", access="Write|Discard"
+  }
+  hal.executable.variant @llvm, target = #hal.executable.target<"llvm", "embedded-elf-x86_64"> {
+    hal.executable.entry_point @conv_static attributes {
+      interface = @io,
+      ordinal = 0 : index
+    }
+    module {
+      func @conv_static() {
+        %c0 = constant 0 : index
+        %c32 = constant 32 : index
+        %c112 = constant 112 : index
+        %0 = hal.interface.binding.subspan @io::@arg0[%c0] : memref<1x225x225x16xf32>
+        %1 = hal.interface.binding.subspan @io::@arg1[%c0] : memref<3x3x16x32xf32>
+        %2 = hal.interface.binding.subspan @io::@ret0[%c0] : memref<1x112x112x32xf32>
+        %workgroup_size_x = hal.interface.workgroup.size[0] : index
+        %workgroup_size_y = hal.interface.workgroup.size[1] : index
+        %workgroup_size_z = hal.interface.workgroup.size[2] : index
+        %workgroup_id_x = hal.interface.workgroup.id[0] : index
+        %workgroup_count_x = hal.interface.workgroup.count[0] : index
+        %workgroup_id_y = hal.interface.workgroup.id[1] : index
+        %workgroup_count_y = hal.interface.workgroup.count[1] : index
+        %workgroup_id_z = hal.interface.workgroup.id[2] : index
+        %workgroup_count_z = hal.interface.workgroup.count[2] : index
+        %3 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_id_z, %workgroup_size_z]
+        %4 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_count_z, %workgroup_size_z]
+        scf.for %arg0 = %3 to %c112 step %4 {
+          %5 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_id_y, %workgroup_size_y]
+          %6 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_count_y, %workgroup_size_y]
+          scf.for %arg1 = %5 to %c112 step %6 {
+            %7 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_id_x, %workgroup_size_x]
+            %8 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_count_x, %workgroup_size_x]
+            scf.for %arg2 = %7 to %c32 step %8 {
+              %9 = affine.apply affine_map<(d0) -> (d0 * 2)>(%arg0)
+              %10 = affine.min affine_map<(d0)[s0] -> (s0 * 2 + 1, d0 * -2 + 225)>(%arg0)[%workgroup_size_z]
+              %11 = affine.apply affine_map<(d0) -> (d0 * 2)>(%arg1)
+              %12 = affine.min affine_map<(d0)[s0] -> (s0 * 2 + 1, d0 * -2 + 225)>(%arg1)[%workgroup_size_y]
+              %13 = memref.subview %0[0, %9, %11, 0] [1, %10, %12, 16] [1, 1, 1, 1] : memref<1x225x225x16xf32> to memref<1x?x?x16xf32, affine_map<(d0, d1, d2, d3)[s0] -> (d0 * 810000 + s0 + d1 * 3600 + d2 * 16 + d3)>>
+              %14 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 32)>(%arg2)[%workgroup_size_x]
+              %15 = memref.subview %1[0, 0, 0, %arg2] [3, 3, 16, %14] [1, 1, 1, 1] : memref<3x3x16x32xf32> to memref<3x3x16x?xf32, affine_map<(d0, d1, d2, d3)[s0] -> (d0 * 1536 + s0 + d1 * 512 + d2 * 32 + d3)>>
+              %16 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 112)>(%arg0)[%workgroup_size_z]
+              %17 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 112)>(%arg1)[%workgroup_size_y]
+              %18 = memref.subview %2[0, %arg0, %arg1, %arg2] [1, %16, %17, %14] [1, 1, 1, 1] : memref<1x112x112x32xf32> to memref<1x?x?x?xf32, affine_map<(d0, d1, d2, d3)[s0] -> (d0 * 401408 + s0 + d1 * 3584 + d2 * 32 + d3)>>
+              linalg.conv_2d_input_nhwc_filter_hwcf {__internal_linalg_transform__ = "workgroup", dilations = dense<1> : tensor<2xi64>, strides = dense<2> : tensor<2xi64>} ins(%13, %15 : memref<1x?x?x16xf32, affine_map<(d0, d1, d2, d3)[s0] -> (d0 * 810000 + s0 + d1 * 3600 + d2 * 16 + d3)>>, memref<3x3x16x?xf32, affine_map<(d0, d1, d2, d3)[s0] -> (d0 * 1536 + s0 + d1 * 512 + d2 * 32 + d3)>>) outs(%18 : memref<1x?x?x?xf32, affine_map<(d0, d1, d2, d3)[s0] -> (d0 * 401408 + s0 + d1 * 3584 + d2 * 32 + d3)>>)
+            }
+          }
+        }
+        return
+      }
+    }
+  }
+}
+//  CHECK-DAG: #[[CONFIG:.+]] = {nativeVectorSize = [1, 1, 4, 8, 1, 1, 4], tileSizes = {{\[}}[0, 8, 16, 32], [1, 1, 16, 32, 1, 1, 16], [1, 1, 4, 8, 1, 1, 4]{{\]}}}
+//      CHECK: hal.executable.entry_point @conv_static
+// CHECK-SAME:   workgroup_cost_hint = 589824
+//      CHECK: linalg.conv_2d_input_nhwc_filter_hwcf
+// CHECK-SAME:   lowering.config = #[[CONFIG]]
+
+// -----
+
+hal.executable @matmul_unaligned_peel attributes {sym_visibility = "private"} {
+  hal.interface @io {
+    hal.interface.binding @arg0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @arg1, set=0, binding=1, type="StorageBuffer", access="Read"
+    hal.interface.binding @ret0, set=0, binding=2, type="StorageBuffer", access="Read|Write"
+  }
+  hal.executable.variant @llvm, target = #hal.executable.target<"llvm", "embedded-elf-x86_64"> {
+    hal.executable.entry_point @matmul_unaligned_peel attributes {
+      interface = @io,
+      ordinal = 0 : index
+    }
+    module {
+      func @matmul_unaligned_peel() {
+        %c0 = constant 0 : index
+        %0 = hal.interface.binding.subspan @io::@arg0[%c0] : memref<197x768xf32>
+        %1 = hal.interface.binding.subspan @io::@arg1[%c0] : memref<768x768xf32>
+        %2 = hal.interface.binding.subspan @io::@ret0[%c0] : memref<197x768xf32>
+        linalg.matmul {__internal_linalg_transform__ = "workgroup"} ins(%0, %1 : memref<197x768xf32>, memref<768x768xf32>) outs(%2 : memref<197x768xf32>)
+        return
+      }
+    }
+  }
+}
+// M is not a multiple of the vector size and padding the partial L1 tiles
+// would add 27 rows, so the partial vector tiles are peeled.
+//  CHECK-DAG: #[[CONFIG:.+]] = {nativeVectorSize = [4, 4, 4], tileSizes = {{\[}}[64, 64], [32, 32, 32], [4, 4, 4]{{\]}}}
+//      CHECK: hal.executable.entry_point @matmul_unaligned_peel
+// CHECK-SAME:   passPipeline = 12 : i32
+//      CHECK: linalg.matmul
+// CHECK-SAME:   lowering.config = #[[CONFIG]]
+
+// -----
+
+hal.executable @matmul_unaligned_pad attributes {sym_visibility = "private"} {
+  hal.interface @io {
+    hal.interface.binding @arg0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @arg1, set=0, binding=1, type="StorageBuffer", access="Read"
+    hal.interface.binding @ret0, set=0, binding=2, type="StorageBuffer", access="Read|Write"
+  }
+  hal.executable.variant @llvm, target = #hal.executable.target<"llvm", "embedded-elf-x86_64"> {
+    hal.executable.entry_point @matmul_unaligned_pad attributes {
+      interface = @io,
+      ordinal = 0 : index
+    }
+    module {
+      func @matmul_unaligned_pad() {
+        %c0 = constant 0 : index
+        %0 = hal.interface.binding.subspan @io::@arg0[%c0] : memref<250x256xf32>
+        %1 = hal.interface.binding.subspan @io::@arg1[%c0] : memref<256x256xf32>
+        %2 = hal.interface.binding.subspan @io::@ret0[%c0] : memref<250x256xf32>
+        linalg.matmul {__internal_linalg_transform__ = "workgroup"} ins(%0, %1 : memref<250x256xf32>, memref<256x256xf32>) outs(%2 : memref<250x256xf32>)
+        return
+      }
+    }
+  }
+}
+// Padding the partial L1 tiles of M only adds 6 rows, so they are padded.
+//  CHECK-DAG: #[[CONFIG:.+]] = {nativeVectorSize = [4, 4, 4], tileSizes = {{\[}}[64, 64], [32, 32, 32], [4, 4, 4]{{\]}}}
+//      CHECK: hal.executable.entry_point @matmul_unaligned_pad
+// CHECK-SAME:   passPipeline = 11 : i32
+//      CHECK: linalg.matmul
+// CHECK-SAME:   lowering.config = #[[CONFIG]]
+
+// -----
+
+hal.executable @matvec_like_matmul attributes {sym_visibility = "private"} {
+  hal.interface @io {
+    hal.interface.binding @arg0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @arg1, set=0, binding=1, type="StorageBuffer", access="Read"
+    hal.interface.binding @ret0, set=0, binding=2, type="StorageBuffer", access="Read|Write"
+  }
+  hal.executable.variant @llvm, target = #hal.executable.target<"llvm", "embedded-elf-x86_64"> {
+    hal.executable.entry_point @matvec_like_matmul attributes {
+      interface = @io,
+      ordinal = 0 : index
+    }
+    module {
+      func @matvec_like_matmul() {
+        %c0 = constant 0 : index
+        %0 = hal.interface.binding.subspan @io::@arg0[%c0] : memref<1x768xf32>
+        %1 = hal.interface.binding.subspan @io::@arg1[%c0] : memref<768x3072xf32>
+        %2 = hal.interface.binding.subspan @io::@ret0[%c0] : memref<1x3072xf32>
+        linalg.matmul {__internal_linalg_transform__ = "workgroup"} ins(%0, %1 : memref<1x768xf32>, memref<768x3072xf32>) outs(%2 : memref<1x3072xf32>)
+        return
+      }
+    }
+  }
+}
+// Dimensions smaller than the vector size are processed whole.
+//  CHECK-DAG: #[[CONFIG:.+]] = {nativeVectorSize = [1, 16, 4], tileSizes = {{\[}}[1, 64], [1, 64, 256], [1, 16, 4]{{\]}}}
+//      CHECK: hal.executable.entry_point @matvec_like_matmul
+// CHECK-SAME:   passPipeline = 1 : i32
+//      CHECK: linalg.matmul
+// CHECK-SAME:   lowering.config = #[[CONFIG]]
+
+// -----
+
+hal.executable @matmul_riscv_vector attributes {sym_visibility = "private"} {
+  hal.interface @io {
+    hal.interface.binding @arg0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @arg1, set=0, binding=1, type="StorageBuffer", access="Read"
+    hal.interface.binding @ret0, set=0, binding=2, type="StorageBuffer", access="Read|Write"
+  }
+  hal.executable.variant @llvm, target = #hal.executable.target<"llvm", "embedded-elf-riscv_64", {cpu_features = "+m,+a,+f,+d,+v,+zvl256b", target_triple = "riscv64-unknown-unknown-eabi-elf"}> {
+    hal.executable.entry_point @matmul_riscv_vector attributes {
+      interface = @io,
+      ordinal = 0 : index
+    }
+    module {
+      func @matmul_riscv_vector() {
+        %c0 = constant 0 : index
+        %0 = hal.interface.binding.subspan @io::@arg0[%c0] : memref<256x128xf32>
+        %1 = hal.interface.binding.subspan @io::@arg1[%c0] : memref<128x512xf32>
+        %2 = hal.interface.binding.subspan @io::@ret0[%c0] : memref<256x512xf32>
+        linalg.matmul {__internal_linalg_transform__ = "workgroup"} ins(%0, %1 : memref<256x128xf32>, memref<128x512xf32>) outs(%2 : memref<256x512xf32>)
+        return
+      }
+    }
+  }
+}
+// N is vectorized across register groups of 2 x 256 bit registers.
+//  CHECK-DAG: #[[CONFIG:.+]] = {nativeVectorSize = [4, 16, 4], tileSizes = {{\[}}[64, 64], [32, 32, 32], [4, 16, 4]{{\]}}}
+//      CHECK: hal.executable.entry_point @matmul_riscv_vector
+// CHECK-SAME:   passPipeline = 1 : i32
+//      CHECK: linalg.matmul
+// CHECK-SAME:   lowering.config = #[[CONFIG]]
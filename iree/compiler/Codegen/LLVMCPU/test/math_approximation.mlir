@@ -0,0 +1,80 @@
+// RUN: iree-opt -split-input-file -pass-pipeline='builtin.func(iree-llvmcpu-math-approximation)' %s | IreeFileCheck %s
+// RUN: iree-opt -split-input-file -pass-pipeline='builtin.func(iree-llvmcpu-math-approximation{fast=true})' %s | IreeFileCheck %s --check-prefix=FAST
+
+func @exp(%arg0: vector<8xf32>) -> vector<8xf32> {
+  %0 = math.exp %arg0 : vector<8xf32>
+  return %0 : vector<8xf32>
+}
+// CHECK-LABEL: func @exp
+//   CHECK-NOT:   math.exp
+//       CHECK:   %[[N:.+]] = floorf %{{.+}} : vector<8xf32>
+//       CHECK:   %[[I:.+]] = fptosi %[[N]] : vector<8xf32> to vector<8xi32>
+//       CHECK:   %[[BIASED:.+]] = addi %[[I]], %{{.+}} : vector<8xi32>
+//       CHECK:   %[[BITS:.+]] = shift_left %[[BIASED]], %{{.+}} : vector<8xi32>
+//       CHECK:   %[[EXP2N:.+]] = bitcast %[[BITS]] : vector<8xi32> to vector<8xf32>
+//       CHECK:   %[[RESULT:.+]] = mulf %{{.+}}, %[[EXP2N]] : vector<8xf32>
+//       CHECK:   select %{{.+}}, %{{.+}}, %[[RESULT]] : vector<8xi1>, vector<8xf32>
+// FAST-LABEL: func @exp
+//   FAST-NOT:   math.exp
+// FAST-COUNT-6:   fmaf
+//   FAST-NOT:   fmaf
+//       FAST:   return
+
+// -----
+
+func @log(%arg0: f32) -> f32 {
+  %0 = math.log %arg0 : f32
+  return %0 : f32
+}
+// CHECK-LABEL: func @log
+//   CHECK-NOT:   math.log
+//       CHECK:   %[[BITS:.+]] = bitcast %{{.+}} : f32 to i32
+//       CHECK:   shift_right_signed %[[BITS]], %{{.+}} : i32
+//       CHECK:   %[[MANTISSA:.+]] = or %{{.+}}, %{{.+}} : i32
+//       CHECK:   bitcast %[[MANTISSA]] : i32 to f32
+//       CHECK:   return
+// FAST-LABEL: func @log
+//   FAST-NOT:   math.log
+
+// -----
+
+func @tanh(%arg0: vector<4xf32>) -> vector<4xf32> {
+  %0 = math.tanh %arg0 : vector<4xf32>
+  return %0 : vector<4xf32>
+}
+// CHECK-LABEL: func @tanh
+//  CHECK-SAME:   %[[ARG0:.+]]: vector<4xf32>
+//   CHECK-NOT:   math.tanh
+//       CHECK:   %[[RATIONAL:.+]] = divf %{{.+}}, %{{.+}} : vector<4xf32>
+//       CHECK:   %[[ABS:.+]] = absf %[[ARG0]] : vector<4xf32>
+//       CHECK:   %[[TINY:.+]] = cmpf olt, %[[ABS]], %{{.+}} : vector<4xf32>
+//       CHECK:   %[[RESULT:.+]] = select %[[TINY]], %[[ARG0]], %[[RATIONAL]]
+//       CHECK:   return %[[RESULT]]
+
+// -----
+
+func @sigmoid(%arg0: vector<4xf32>) -> vector<4xf32> {
+  %one = constant dense<1.0> : vector<4xf32>
+  %0 = negf %arg0 : vector<4xf32>
+  %1 = math.exp %0 : vector<4xf32>
+  %2 = addf %1, %one : vector<4xf32>
+  %3 = divf %one, %2 : vector<4xf32>
+  return %3 : vector<4xf32>
+}
+// CHECK-LABEL: func @sigmoid
+//  CHECK-SAME:   %[[ARG0:.+]]: vector<4xf32>
+//   CHECK-DAG:   %[[HALF:.+]] = constant dense<5.000000e-01> : vector<4xf32>
+//   CHECK-NOT:   math.exp
+//       CHECK:   %[[X:.+]] = mulf %[[ARG0]], %[[HALF]] : vector<4xf32>
+//       CHECK:   %[[TANH:.+]] = select %{{.+}}, %[[X]], %{{.+}} : vector<4xi1>, vector<4xf32>
+//       CHECK:   %[[RESULT:.+]] = fmaf %[[TANH]], %[[HALF]], %[[HALF]] : vector<4xf32>
+//       CHECK:   return %[[RESULT]]
+
+// -----
+
+func @exp_f16(%arg0: f16) -> f16 {
+  %0 = math.exp %arg0 : f16
+  return %0 : f16
+}
+// CHECK-LABEL: func @exp_f16
+//       CHECK:   math.exp
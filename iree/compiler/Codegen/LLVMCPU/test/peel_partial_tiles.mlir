@@ -0,0 +1,37 @@
+// RUN: iree-opt -pass-pipeline="hal.executable(hal.executable.variant(iree-llvmcpu-lower-executable-target{use-lowering-pipeline='builtin.func(iree-llvmcpu-vectorization{peel-partial-tiles})'}))" -split-input-file %s | IreeFileCheck %s
+
+#config = {nativeVectorSize = [4, 4, 4], tileSizes = [[64, 64], [32, 32, 32], [4, 4, 4]]}
+hal.executable @matmul_14x16x8 attributes {sym_visibility = "private"} {
+  hal.interface @io {
+    hal.interface.binding @arg0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @arg1, set=0, binding=1, type="StorageBuffer", access="Read"
+    hal.interface.binding @ret0, set=0, binding=2, type="StorageBuffer", access="Read|Write"
+  }
+  hal.executable.variant @llvm, target = #hal.executable.target<"llvm", "embedded-elf-x86_64"> {
+    hal.executable.entry_point @matmul_14x16x8 attributes {
+      interface = @io,
+      ordinal = 0 : index
+    }
+    module {
+      func @matmul_14x16x8() {
+        %c0 = constant 0 : index
+        %0 = hal.interface.binding.subspan @io::@arg0[%c0] : memref<14x16xf32>
+        %1 = hal.interface.binding.subspan @io::@arg1[%c0] : memref<16x8xf32>
+        %2 = hal.interface.binding.subspan @io::@ret0[%c0] : memref<14x8xf32>
+        linalg.matmul {__internal_linalg_transform__ = "workgroup", lowering.config = #config} ins(%0, %1 : memref<14x16xf32>, memref<16x8xf32>) outs(%2 : memref<14x8xf32>)
+        return
+      }
+    }
+  }
+}
+// The last two rows are peeled off the vector tile loop over the rows and
+// vectorized with transfers masking out the rows past the end.
+// CHECK-LABEL: func @matmul_14x16x8
+//   CHECK-DAG:   %[[C0:.+]] = constant 0 : index
+//   CHECK-DAG:   %[[C4:.+]] = constant 4 : index
+//   CHECK-DAG:   %[[C12:.+]] = constant 12 : index
+//       CHECK:   scf.for %{{.+}} = %[[C0]] to %[[C12]] step %[[C4]]
+//       CHECK:     vector.outerproduct
+//       CHECK:   vector.transfer_read
+//       CHECK:   vector.outerproduct
+//   CHECK-NOT:   linalg.matmul
@@ -0,0 +1,63 @@
+// RUN: iree-opt -pass-pipeline='hal.executable(hal.executable.variant(iree-llvmcpu-lower-executable-target{test-lowering-configuration=true}))' -iree-codegen-llvm-aarch64-sve-vector-bits=256 -cse -canonicalize -split-input-file %s | IreeFileCheck %s
+
+hal.executable @matmul_sve attributes {sym_visibility = "private"} {
+  hal.interface @io {
+    hal.interface.binding @arg0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @arg1, set=0, binding=1, type="StorageBuffer", access="Read"
+    hal.interface.binding @ret0, set=0, binding=2, type="StorageBuffer", access="Read|Write"
+  }
+  hal.executable.variant @llvm, target = #hal.executable.target<"llvm", "embedded-elf-arm_64", {cpu_features = "+sve", target_triple = "aarch64-unknown-unknown-eabi-elf"}> {
+    hal.executable.entry_point @matmul_sve attributes {
+      interface = @io,
+      ordinal = 0 : index
+    }
+    module {
+      func @matmul_sve() {
+        %c0 = constant 0 : index
+        %0 = hal.interface.binding.subspan @io::@arg0[%c0] : memref<256x128xf32>
+        %1 = hal.interface.binding.subspan @io::@arg1[%c0] : memref<128x512xf32>
+        %2 = hal.interface.binding.subspan @io::@ret0[%c0] : memref<256x512xf32>
+        linalg.matmul {__internal_linalg_transform__ = "workgroup"} ins(%0, %1 : memref<256x128xf32>, memref<128x512xf32>) outs(%2 : memref<256x512xf32>)
+        return
+      }
+    }
+  }
+}
+// N is vectorized with 256-bit SVE vectors.
+//  CHECK-DAG: #[[CONFIG:.+]] = {nativeVectorSize = [4, 8, 4], tileSizes = {{\[}}[64, 64], [32, 32, 32], [4, 8, 4]{{\]}}}
+//      CHECK: hal.executable.entry_point @matmul_sve
+// CHECK-SAME:   passPipeline = 1 : i32
+//      CHECK: linalg.matmul
+// CHECK-SAME:   lowering.config = #[[CONFIG]]
+
+// -----
+
+hal.executable @matmul_neon attributes {sym_visibility = "private"} {
+  hal.interface @io {
+    hal.interface.binding @arg0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @arg1, set=0, binding=1, type="StorageBuffer", access="Read"
+    hal.interface.binding @ret0, set=0, binding=2, type="StorageBuffer", access="Read|Write"
+  }
+  hal.executable.variant @llvm, target = #hal.executable.target<"llvm", "embedded-elf-arm_64", {cpu_features = "+neon", target_triple = "aarch64-unknown-unknown-eabi-elf"}> {
+    hal.executable.entry_point @matmul_neon attributes {
+      interface = @io,
+      ordinal = 0 : index
+    }
+    module {
+      func @matmul_neon() {
+        %c0 = constant 0 : index
+        %0 = hal.interface.binding.subspan @io::@arg0[%c0] : memref<256x128xf32>
+        %1 = hal.interface.binding.subspan @io::@arg1[%c0] : memref<128x512xf32>
+        %2 = hal.interface.binding.subspan @io::@ret0[%c0] : memref<256x512xf32>
+        linalg.matmul {__internal_linalg_transform__ = "workgroup"} ins(%0, %1 : memref<256x128xf32>, memref<128x512xf32>) outs(%2 : memref<256x512xf32>)
+        return
+      }
+    }
+  }
+}
+// Targets without SVE keep the NEON vector sizes.
+//  CHECK-DAG: #[[CONFIG:.+]] = {nativeVectorSize = [4, 4, 4], tileSizes = {{\[}}[64, 64], [32, 32, 32], [4, 4, 4]{{\]}}}
+//      CHECK: hal.executable.entry_point @matmul_neon
+// CHECK-SAME:   passPipeline = 1 : i32
+//      CHECK: linalg.matmul
+// CHECK-SAME:   lowering.config = #[[CONFIG]]
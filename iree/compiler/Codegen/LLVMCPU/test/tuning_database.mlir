@@ -0,0 +1,64 @@
+// RUN: echo '[{"op": "linalg.matmul", "shapes": ["?x?xf32", "?x?xf32", "?x?xf32"], "target": "embedded-elf-x86_64", "tile_sizes": [[32, 128], [16, 32, 64], [4, 4, 4]], "native_vector_size": [4, 4, 4]}]' > %t.json
+// RUN: iree-opt -pass-pipeline='hal.executable(hal.executable.variant(iree-llvmcpu-lower-executable-target{test-lowering-configuration=true}))' -iree-codegen-llvm-tuning-database=%t.json %s | IreeFileCheck %s
+// RUN: iree-opt -pass-pipeline='hal.executable(hal.executable.variant(iree-llvmcpu-lower-executable-target{test-lowering-configuration=true}))' -iree-codegen-llvm-print-tuning-candidates %s 2>&1 | IreeFileCheck %s --check-prefix=CANDIDATE
+
+hal.executable @matmul_tensors attributes {sym_visibility = "private"} {
+  hal.interface @io {
+    hal.interface.binding @arg0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @arg1, set=0, binding=1, type="StorageBuffer", access="Read"
+    hal.interface.binding @ret0, set=0, binding=2, type="StorageBuffer", access="Read|Write"
+  }
+  hal.executable.variant @llvm, target = #hal.executable.target<"llvm", "embedded-elf-x86_64"> {
+    hal.executable.entry_point @matmul_tensors attributes {
+      interface = @io,
+      ordinal = 0 : index
+    }
+    module {
+      func @matmul_tensors() {
+        %c0 = constant 0 : index
+        %c1 = constant 1 : index
+        %0 = hal.interface.binding.subspan @io::@arg0[%c0] : memref<?x?xf32>
+        %2 = hal.interface.binding.subspan @io::@arg1[%c0] : memref<?x?xf32>
+        %6 = hal.interface.binding.subspan @io::@ret0[%c0] : memref<?x?xf32>
+        %M = memref.dim %0, %c0 : memref<?x?xf32>
+        %N = memref.dim %2, %c1 : memref<?x?xf32>
+        %K = memref.dim %0, %c1 : memref<?x?xf32>
+        %workgroup_size_x = hal.interface.workgroup.size[0] : index
+        %workgroup_size_y = hal.interface.workgroup.size[1] : index
+        %workgroup_id_x = hal.interface.workgroup.id[0] : index
+        %workgroup_count_x = hal.interface.workgroup.count[0] : index
+        %workgroup_id_y = hal.interface.workgroup.id[1] : index
+        %workgroup_count_y = hal.interface.workgroup.count[1] : index
+        %8 = muli %workgroup_size_y, %workgroup_id_y : index
+        %9 = muli %workgroup_size_y, %workgroup_count_y : index
+        scf.for %arg0 = %8 to %M step %9 {
+          %10 = muli %workgroup_size_x, %workgroup_id_x : index
+          %11 = muli %workgroup_size_x, %workgroup_count_x : index
+          scf.for %arg1 = %10 to %N step %11 {
+            %12 = affine.min affine_map<(d0)[s0, s1] -> (s0, -d0 + s1)>(%arg0)[%workgroup_size_y, %N]
+            %13 = memref.subview %0[%arg0, 0] [%12, %K] [1, 1] : memref<?x?xf32> to memref<?x?xf32, affine_map<(d0, d1)[s0, s1] -> (d0 * s1 + s0 + d1)>>
+            %14 = affine.min affine_map<(d0)[s0, s1] -> (s0, -d0 + s1)>(%arg1)[%workgroup_size_x, %M]
+            %15 = memref.subview %2[0, %arg1] [%K, %14] [1, 1] : memref<?x?xf32> to memref<?x?xf32, affine_map<(d0, d1)[s0, s1] -> (d0 * s1 + s0 + d1)>>
+            %16 = memref.subview %6[%arg0, %arg1] [%12, %14] [1, 1] : memref<?x?xf32> to memref<?x?xf32, affine_map<(d0, d1)[s0, s1] -> (d0 * s1 + s0 + d1)>>
+            linalg.matmul {__internal_linalg_transform__ = "workgroup"} ins(%13, %15 : memref<?x?xf32, affine_map<(d0, d1)[s0, s1] -> (d0 * s1 + s0 + d1)>>, memref<?x?xf32, affine_map<(d0, d1)[s0, s1] -> (d0 * s1 + s0 + d1)>>) outs(%16 : memref<?x?xf32, affine_map<(d0, d1)[s0, s1] -> (d0 * s1 + s0 + d1)>>)
+          }
+        }
+        return
+      }
+    }
+  }
+}
+
+// The tuned configuration from the database should replace the default one.
+//  CHECK-DAG: #[[CONFIG:.+]] = {nativeVectorSize = [4, 4, 4], tileSizes = {{\[}}[32, 128], [16, 32, 64], [4, 4, 4]{{\]}}}
+//  CHECK-DAG: #[[MAP0:.+]] = affine_map<()[s0] -> (s0 ceildiv 128)>
+//  CHECK-DAG: #[[MAP1:.+]] = affine_map<()[s0] -> (s0 ceildiv 32)>
+//      CHECK: hal.executable.entry_point @matmul_tensors
+//  CHECK-DAG:   affine.apply #[[MAP0]]
+//  CHECK-DAG:   affine.apply #[[MAP1]]
+//      CHECK: linalg.matmul
+// CHECK-SAME:   lowering.config = #[[CONFIG]]
+
+// The default configuration should be reported for tuning tools to sweep.
+//      CANDIDATE: remark: tuning candidate:
+// CANDIDATE-SAME:   {"native_vector_size":[4,4,4],"op":"linalg.matmul","shapes":["?x?xf32","?x?xf32","?x?xf32"],"target":"embedded-elf-x86_64","tile_sizes":{{\[}}[64,64],[32,32,32],[4,4,4]{{\]}}}
@@ -0,0 +1,62 @@
+// RUN: iree-opt -split-input-file -pass-pipeline='builtin.func(iree-llvmcpu-vector-contract-custom-kernels{target-triple=aarch64-none-linux-android target-cpu-features=+i8mm})' %s | IreeFileCheck %s --check-prefix=I8MM
+// RUN: iree-opt -split-input-file -pass-pipeline='builtin.func(iree-llvmcpu-vector-contract-custom-kernels{target-triple=x86_64-unknown-linux-gnu target-cpu-features=+avx512f,+avx512vnni})' %s | IreeFileCheck %s --check-prefix=VNNI
+// RUN: iree-opt -split-input-file -pass-pipeline='builtin.func(iree-llvmcpu-vector-contract-custom-kernels{target-triple=x86_64-unknown-linux-gnu target-cpu-features=+avx2})' %s | IreeFileCheck %s --check-prefix=NONE
+
+#map0 = affine_map<(d0, d1, d2) -> (d0, d2)>
+#map1 = affine_map<(d0, d1, d2) -> (d2, d1)>
+#map2 = affine_map<(d0, d1, d2) -> (d0, d1)>
+func @contract_2x8x2_i8i8i32(%lhs: vector<2x8xi8>, %rhs: vector<8x2xi8>, %acc: vector<2x2xi32>) -> vector<2x2xi32> {
+  %0 = sexti %lhs : vector<2x8xi8> to vector<2x8xi32>
+  %1 = sexti %rhs : vector<8x2xi8> to vector<8x2xi32>
+  %2 = vector.contract {indexing_maps = [#map0, #map1, #map2], iterator_types = ["parallel", "parallel", "reduction"], kind = #vector.kind<add>} %0, %1, %acc : vector<2x8xi32>, vector<8x2xi32> into vector<2x2xi32>
+  return %2 : vector<2x2xi32>
+}
+//  I8MM-LABEL: @contract_2x8x2_i8i8i32
+//   I8MM-SAME:   %[[LHS:[a-zA-Z0-9]+]]: vector<2x8xi8>
+//   I8MM-SAME:   %[[RHS:[a-zA-Z0-9]+]]: vector<8x2xi8>
+//   I8MM-SAME:   %[[ACC:[a-zA-Z0-9]+]]: vector<2x2xi32>
+//       I8MM:   %[[RHS_T:.+]] = vector.transpose %[[RHS]], [1, 0] : vector<8x2xi8> to vector<2x8xi8>
+//       I8MM:   %[[LHS_ROWS:.+]] = vector.shape_cast %{{.+}} : vector<2x8xi8> to vector<16xi8>
+//       I8MM:   %[[RHS_COLS:.+]] = vector.shape_cast %{{.+}} : vector<2x8xi8> to vector<16xi8>
+//       I8MM:   %[[ACC_TILE:.+]] = vector.shape_cast %{{.+}} : vector<2x2xi32> to vector<4xi32>
+//       I8MM:   %[[RES:.+]] = llvm.inline_asm asm_dialect = att "smmla $0.4s, $2.16b, $3.16b", "=w,0,w,w" %[[ACC_TILE]], %[[LHS_ROWS]], %[[RHS_COLS]] : (vector<4xi32>, vector<16xi8>, vector<16xi8>) -> vector<4xi32>
+//       I8MM:   vector.shape_cast %[[RES]] : vector<4xi32> to vector<2x2xi32>
+//   I8MM-NOT:   vector.contract
+
+// Without a 16 lane wide result the x86 kernels do not apply.
+//   VNNI-LABEL: @contract_2x8x2_i8i8i32
+//         VNNI:   vector.contract
+//   NONE-LABEL: @contract_2x8x2_i8i8i32
+//         NONE:   vector.contract
+
+// -----
+
+#map0 = affine_map<(d0, d1, d2) -> (d0, d2)>
+#map1 = affine_map<(d0, d1, d2) -> (d2, d1)>
+#map2 = affine_map<(d0, d1, d2) -> (d0, d1)>
+func @contract_1x2x16_i8i8i32(%lhs: vector<1x2xi8>, %rhs: vector<2x16xi8>, %acc: vector<1x16xi32>) -> vector<1x16xi32> {
+  %0 = sexti %lhs : vector<1x2xi8> to vector<1x2xi32>
+  %1 = sexti %rhs : vector<2x16xi8> to vector<2x16xi32>
+  %2 = vector.contract {indexing_maps = [#map0, #map1, #map2], iterator_types = ["parallel", "parallel", "reduction"], kind = #vector.kind<add>} %0, %1, %acc : vector<1x2xi32>, vector<2x16xi32> into vector<1x16xi32>
+  return %2 : vector<1x16xi32>
+}
+//   VNNI-LABEL: @contract_1x2x16_i8i8i32
+//    VNNI-SAME:   %[[LHS:[a-zA-Z0-9]+]]: vector<1x2xi8>
+//    VNNI-SAME:   %[[RHS:[a-zA-Z0-9]+]]: vector<2x16xi8>
+//    VNNI-SAME:   %[[ACC:[a-zA-Z0-9]+]]: vector<1x16xi32>
+//    VNNI-DAG:   %[[LHS16:.+]] = sexti %[[LHS]] : vector<1x2xi8> to vector<1x2xi16>
+//    VNNI-DAG:   %[[RHS16:.+]] = sexti %[[RHS]] : vector<2x16xi8> to vector<2x16xi16>
+//    VNNI-DAG:   %[[ROW0:.+]] = vector.extract %[[RHS16]][0] : vector<2x16xi16>
+//    VNNI-DAG:   %[[ROW1:.+]] = vector.extract %[[RHS16]][1] : vector<2x16xi16>
+//        VNNI:   %[[PAIRS:.+]] = vector.shuffle %[[ROW0]], %[[ROW1]] [0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23, 8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31] : vector<16xi16>, vector<16xi16>
+//    VNNI-DAG:   %[[ACC_ROW:.+]] = vector.extract %[[ACC]][0] : vector<1x16xi32>
+//    VNNI-DAG:   %[[LHS_ROW:.+]] = vector.extract %[[LHS16]][0] : vector<1x2xi16>
+//        VNNI:   %[[LHS_PAIR:.+]] = vector.shuffle %[[LHS_ROW]], %[[LHS_ROW]] [0, 1, 0, 1
+//        VNNI:   %[[RES:.+]] = llvm.inline_asm asm_dialect = att "vpdpwssd $3, $2, $0", "=v,0,v,v" %[[ACC_ROW]], %[[LHS_PAIR]], %[[PAIRS]] : (vector<16xi32>, vector<32xi16>, vector<32xi16>) -> vector<16xi32>
+//        VNNI:   vector.insert %[[RES]], %[[ACC]] [0] : vector<16xi32> into vector<1x16xi32>
+//    VNNI-NOT:   vector.contract
+
+//   I8MM-LABEL: @contract_1x2x16_i8i8i32
+//         I8MM:   vector.contract
+//   NONE-LABEL: @contract_1x2x16_i8i8i32
+//         NONE:   vector.contract
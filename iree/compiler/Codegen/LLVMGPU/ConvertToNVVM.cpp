@@ -7,6 +7,7 @@
 #include "iree/compiler/Codegen/LLVMGPU/ConvertToLLVM.h"
 #include "iree/compiler/Codegen/PassDetail.h"
 #include "iree/compiler/Codegen/Passes.h"
+#include "iree/compiler/Codegen/Utils/MarkerUtils.h"
 #include "iree/compiler/Codegen/Utils/Utils.h"
 #include "iree/compiler/Dialect/Util/IR/UtilOps.h"
 #include "mlir/Conversion/GPUToNVVM/GPUToNVVMPass.h"
@@ -17,7 +18,9 @@
 #include "mlir/Conversion/MemRefToLLVM/MemRefToLLVM.h"
 #include "mlir/Conversion/StandardToLLVM/ConvertStandardToLLVM.h"
 #include "mlir/Conversion/VectorToLLVM/ConvertVectorToLLVM.h"
+#include "mlir/Dialect/GPU/GPUDialect.h"
 #include "mlir/Dialect/GPU/Passes.h"
+#include "mlir/Dialect/LLVMIR/FunctionCallUtils.h"
 #include "mlir/Dialect/LLVMIR/NVVMDialect.h"
 #include "mlir/Dialect/StandardOps/IR/Ops.h"
 #include "mlir/Dialect/Vector/VectorOps.h"
@@ -29,6 +32,67 @@ namespace iree_compiler {
 
 namespace {
 
+/// Converts a vector.store of a vector.load from global memory marked by the
+/// LLVMGPU pipelining pass into an asynchronous copy to shared memory
+/// (cp.async). The NVVM dialect doesn't expose cp.async so the copy is
+/// emitted as a call to the corresponding NVVM intrinsic. The load is left
+/// dead and gets cleaned up by LLVM.
+class ConvertAsyncCopyOp : public ConvertOpToLLVMPattern<vector::StoreOp> {
+ public:
+  explicit ConvertAsyncCopyOp(LLVMTypeConverter &converter)
+      : ConvertOpToLLVMPattern<vector::StoreOp>(converter, /*benefit=*/2) {}
+
+  LogicalResult matchAndRewrite(
+      vector::StoreOp storeOp, ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const override {
+    if (!hasMarker(storeOp, getAsyncCopyMarker())) return failure();
+    auto loadOp = storeOp.valueToStore().getDefiningOp<vector::LoadOp>();
+    if (!loadOp || !hasMarker(loadOp, getAsyncCopyMarker())) return failure();
+    MemRefType dstType = storeOp.getMemRefType();
+    MemRefType srcType = loadOp.getMemRefType();
+    if (dstType.getMemorySpaceAsInt() != 3 ||
+        srcType.getMemorySpaceAsInt() != 0) {
+      return failure();
+    }
+    VectorType vectorType = storeOp.getVectorType();
+    int64_t numBytes =
+        vectorType.getNumElements() * vectorType.getElementTypeBitWidth() / 8;
+    if (numBytes != 4 && numBytes != 8 && numBytes != 16) return failure();
+
+    Location loc = storeOp.getLoc();
+    vector::StoreOpAdaptor adaptor(operands);
+    Type i8Type = rewriter.getIntegerType(8);
+    Value dstPtr = getStridedElementPtr(loc, dstType, adaptor.base(),
+                                        adaptor.indices(), rewriter);
+    dstPtr = rewriter.create<LLVM::BitcastOp>(
+        loc, LLVM::LLVMPointerType::get(i8Type, /*addressSpace=*/3), dstPtr);
+
+    // The load is converted independently, look up its converted operands.
+    Value srcBase = rewriter.getRemappedValue(loadOp.base());
+    SmallVector<Value, 4> srcIndices;
+    for (Value index : loadOp.indices()) {
+      srcIndices.push_back(rewriter.getRemappedValue(index));
+    }
+    if (!srcBase || llvm::is_contained(srcIndices, nullptr)) return failure();
+    Value srcPtr =
+        getStridedElementPtr(loc, srcType, srcBase, srcIndices, rewriter);
+    srcPtr = rewriter.create<LLVM::BitcastOp>(
+        loc, LLVM::LLVMPointerType::get(i8Type), srcPtr);
+    srcPtr = rewriter.create<LLVM::AddrSpaceCastOp>(
+        loc, LLVM::LLVMPointerType::get(i8Type, /*addressSpace=*/1), srcPtr);
+
+    auto moduleOp = storeOp->getParentOfType<ModuleOp>();
+    LLVM::LLVMFuncOp copyFn = LLVM::lookupOrCreateFn(
+        moduleOp,
+        ("llvm.nvvm.cp.async.ca.shared.global." + Twine(numBytes)).str(),
+        {dstPtr.getType(), srcPtr.getType()},
+        LLVM::LLVMVoidType::get(rewriter.getContext()));
+    rewriter.create<LLVM::CallOp>(loc, copyFn, ValueRange{dstPtr, srcPtr});
+    rewriter.eraseOp(storeOp);
+    return success();
+  }
+};
+
 /// A pass that replaces all occurrences of GPU device operations with their
 /// corresponding NVVM equivalent.
 ///
@@ -45,6 +109,9 @@ struct ConvertToNVVMPass : public ConvertToNVVMBase<ConvertToNVVMPass> {
     LowerToLLVMOptions options(m.getContext(), DataLayout(m));
     options.overrideIndexBitwidth(64);
     LLVMTypeConverter converter(m.getContext(), options);
+    converter.addConversion([&](gpu::MMAMatrixType type) -> Type {
+      return convertMMAToLLVMType(type);
+    });
     // Apply in-dialect lowering first. In-dialect lowering will replace ops
     // which need to be lowered further, which is not supported by a single
     // conversion pass.
@@ -76,6 +143,8 @@ struct ConvertToNVVMPass : public ConvertToNVVMBase<ConvertToNVVMPass> {
       populateStdToLLVMConversionPatterns(converter, llvmPatterns);
       populateVectorToLLVMConversionPatterns(converter, llvmPatterns);
       populateGpuToNVVMConversionPatterns(converter, llvmPatterns);
+      populateGpuWMMAToNVVMConversionPatterns(converter, llvmPatterns);
+      llvmPatterns.insert<ConvertAsyncCopyOp>(converter);
       populateShapeToLLVMConversionPatterns(&getContext(), &converter,
                                             llvmPatterns);
       LLVMConversionTarget target(getContext());
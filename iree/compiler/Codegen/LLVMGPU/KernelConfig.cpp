@@ -6,9 +6,12 @@
 
 #include "iree/compiler/Codegen/LLVMGPU/KernelConfig.h"
 
+#include "iree/compiler/Codegen/Transforms/Transforms.h"
 #include "iree/compiler/Codegen/Utils/Utils.h"
 #include "iree/compiler/Dialect/Flow/IR/FlowOps.h"
+#include "iree/compiler/Dialect/HAL/IR/HALOps.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
 #include "mlir/Dialect/Linalg/Transforms/Transforms.h"
 #include "mlir/IR/Types.h"
 #include "mlir/IR/Value.h"
@@ -18,12 +21,53 @@ using namespace mlir::iree_compiler;
 
 static constexpr unsigned cudaWarpSize = 32;
 
+/// Maximum number of threads of a workgroup cooperating on a reduction.
+static constexpr int64_t kMaxReductionWorkgroupSize = 256;
+
+/// Maximum number of rows of the lhs of a contraction for it to be configured
+/// as a matrix-vector product.
+static constexpr int64_t kMatvecMaxM = 4;
+
+/// Number of contiguous rhs elements read by each thread of a matrix-vector
+/// product, i.e. 128-bit loads for f32.
+static constexpr int64_t kMatvecVectorSize = 4;
+
+/// Entry point attributes carrying the software pipelining configuration.
+static const char kPipelineDepthAttrName[] = "llvmgpu_pipeline_depth";
+static const char kAsyncCopyAttrName[] = "llvmgpu_async_copy";
+
+/// Minimum fraction of the threads of an SM a matmul configuration has to keep
+/// resident to be picked without looking at the following candidates.
+static constexpr double kMinOccupancy = 0.25;
+
+/// Number of 32-bit registers assumed to be used by each thread for addresses,
+/// loop counters and the like on top of the data of a matmul.
+static constexpr int64_t kRegisterOverhead = 32;
+
 namespace {
 struct TileWorkgroupSizePair {
   // How many scalar elements each workgroup should handle along each dimension.
   std::array<int64_t, 3> tileSize;
   std::array<int64_t, 3> workgroupSize;
 };
+
+/// Resources of an SM of the targeted NVIDIA GPU bounding the number of
+/// workgroups resident at once. Defaults to sm_70 when the target is unknown.
+struct GPUOccupancyLimits {
+  int64_t registersPerSM = 65536;
+  int64_t maxRegistersPerThread = 255;
+  int64_t sharedMemoryPerSM = 96 * 1024;
+  /// Shared memory a workgroup can statically allocate.
+  int64_t sharedMemoryPerWorkgroup = 48 * 1024;
+  int64_t maxThreadsPerSM = 2048;
+  int64_t maxWorkgroupsPerSM = 32;
+};
+
+/// Estimated resources used by a workgroup of a matmul configuration.
+struct MatmulResourceUsage {
+  int64_t registersPerThread;
+  int64_t sharedMemoryBytes;
+};
 }  // namespace
 
 /// Return the best combination of tile size and wg size. It will then used to
@@ -38,6 +82,229 @@ static void getMatmulConfig(SmallVectorImpl<TileWorkgroupSizePair> &tileSizes) {
   tileSizes.push_back(TileWorkgroupSizePair({{1, 128, 8}, {32, 1, 1}}));
 }
 
+/// Return the tile sizes and workgroup sizes to try for the tensor core
+/// pipeline. Each workgroup is made of 2x2 warps and each warp computes a
+/// quarter of the workgroup tile with 16x16x16 WMMA operations.
+static void getTensorCoreConfig(
+    SmallVectorImpl<TileWorkgroupSizePair> &tileSizes) {
+  tileSizes.push_back(TileWorkgroupSizePair({{64, 64, 32}, {64, 2, 1}}));
+  tileSizes.push_back(TileWorkgroupSizePair({{32, 32, 16}, {64, 2, 1}}));
+}
+
+/// Returns the compute capability of the NVIDIA GPU targeted by the variant
+/// containing `entryPoint` (e.g. 80 for sm_80), or 0 if it is unknown.
+static unsigned getSMVersion(FuncOp entryPoint) {
+  auto variantOp =
+      entryPoint->getParentOfType<IREE::HAL::ExecutableVariantOp>();
+  if (!variantOp) return 0;
+  auto configAttr = variantOp.target().getConfiguration();
+  if (!configAttr) return 0;
+  auto archAttr = configAttr.getAs<StringAttr>("target_arch");
+  if (!archAttr) return 0;
+  StringRef arch = archAttr.getValue();
+  unsigned smVersion = 0;
+  if (!arch.consume_front("sm_") || arch.getAsInteger(10, smVersion)) {
+    return 0;
+  }
+  return smVersion;
+}
+
+/// Returns true if the variant containing `entryPoint` targets an NVIDIA GPU
+/// with tensor cores, i.e. sm_70 or newer.
+static bool supportsTensorCore(FuncOp entryPoint) {
+  return getSMVersion(entryPoint) >= 70;
+}
+
+/// Returns the per-SM resources of the GPU targeted by `entryPoint`.
+static GPUOccupancyLimits getOccupancyLimits(FuncOp entryPoint) {
+  GPUOccupancyLimits limits;
+  unsigned smVersion = getSMVersion(entryPoint);
+  if (smVersion >= 86) {
+    limits.sharedMemoryPerSM = 100 * 1024;
+    limits.maxThreadsPerSM = 1536;
+    limits.maxWorkgroupsPerSM = 16;
+  } else if (smVersion >= 80) {
+    limits.sharedMemoryPerSM = 164 * 1024;
+  } else if (smVersion == 75) {
+    limits.sharedMemoryPerSM = 64 * 1024;
+    limits.maxThreadsPerSM = 1024;
+    limits.maxWorkgroupsPerSM = 16;
+  } else if (smVersion != 0 && smVersion < 70) {
+    limits.sharedMemoryPerSM = 64 * 1024;
+  }
+  return limits;
+}
+
+/// Returns the size in bytes of the elements of `value`.
+static int64_t getElementByteSize(Value value) {
+  Type elementType = value.getType().cast<ShapedType>().getElementType();
+  return std::max<int64_t>(1, elementType.getIntOrFloatBitWidth() / 8);
+}
+
+/// Estimates the resources used by a workgroup of `config` computing a matmul.
+/// The accumulators of each thread and its share of the operand tiles being
+/// copied live in registers, and the operand tiles of every pipeline stage live
+/// in shared memory.
+static MatmulResourceUsage estimateMatmulResourceUsage(
+    const TileWorkgroupSizePair &config, int64_t operandBytes,
+    int64_t accumulatorBytes, unsigned pipelineDepth) {
+  int64_t numThreads = config.workgroupSize[0] * config.workgroupSize[1] *
+                       config.workgroupSize[2];
+  int64_t tileM = config.tileSize[0];
+  int64_t tileN = config.tileSize[1];
+  int64_t tileK = config.tileSize[2];
+  int64_t accumulatorRegisters =
+      llvm::divideCeil(tileM * tileN * accumulatorBytes, 4 * numThreads);
+  int64_t operandTileBytes = (tileM + tileN) * tileK * operandBytes;
+  int64_t operandRegisters =
+      llvm::divideCeil(operandTileBytes, 4 * numThreads);
+  MatmulResourceUsage usage;
+  usage.registersPerThread =
+      accumulatorRegisters + operandRegisters + kRegisterOverhead;
+  usage.sharedMemoryBytes = operandTileBytes * pipelineDepth;
+  return usage;
+}
+
+/// Returns the fraction of the threads of an SM kept resident by workgroups of
+/// `numThreads` threads using `usage`, or 0 if such a workgroup would spill
+/// registers or cannot be launched at all.
+static double getOccupancy(const GPUOccupancyLimits &limits,
+                           int64_t numThreads,
+                           const MatmulResourceUsage &usage) {
+  if (usage.registersPerThread > limits.maxRegistersPerThread ||
+      usage.sharedMemoryBytes > limits.sharedMemoryPerWorkgroup ||
+      numThreads > limits.maxThreadsPerSM) {
+    return 0.0;
+  }
+  // Registers are allocated per warp by chunks of 256, with a per thread count
+  // rounded to a multiple of 8.
+  int64_t numWarps = llvm::divideCeil(numThreads, cudaWarpSize);
+  int64_t registersPerWarp =
+      llvm::alignTo(llvm::alignTo(usage.registersPerThread, 8) * cudaWarpSize,
+                    256);
+  int64_t numWorkgroups = std::min(
+      {limits.maxWorkgroupsPerSM,
+       limits.maxThreadsPerSM / (numWarps * cudaWarpSize),
+       limits.registersPerSM / (registersPerWarp * numWarps)});
+  if (usage.sharedMemoryBytes > 0) {
+    numWorkgroups = std::min(
+        numWorkgroups, limits.sharedMemoryPerSM / usage.sharedMemoryBytes);
+  }
+  return static_cast<double>(numWorkgroups * numWarps * cudaWarpSize) /
+         limits.maxThreadsPerSM;
+}
+
+/// Records the software pipelining configuration on the entry point of
+/// `entryPoint`.
+static void setSoftwarePipelineConfig(FuncOp entryPoint,
+                                      const SoftwarePipelineConfig &config) {
+  IREE::HAL::ExecutableEntryPointOp entryPointOp = getEntryPoint(entryPoint);
+  if (!entryPointOp) return;
+  Builder builder(entryPoint.getContext());
+  entryPointOp->setAttr(kPipelineDepthAttrName,
+                        builder.getI64IntegerAttr(config.depth));
+  if (config.useAsyncCopy) {
+    entryPointOp->setAttr(kAsyncCopyAttrName, builder.getUnitAttr());
+  }
+}
+
+/// Sets the configuration for the tensor core pipeline if `op` is a f16
+/// matmul whose shape is aligned on one of the supported tile sizes.
+static LogicalResult setTensorCoreConfig(FuncOp entryPoint,
+                                         linalg::LinalgOp op) {
+  if (!isa<linalg::MatmulOp>(op) || !supportsTensorCore(entryPoint)) {
+    return failure();
+  }
+  // WMMA operations only support f16 operands with a f16 or f32 accumulator.
+  auto getElementType = [](Value v) {
+    return v.getType().cast<ShapedType>().getElementType();
+  };
+  if (!getElementType(op.getInputOperand(0)->get()).isF16() ||
+      !getElementType(op.getInputOperand(1)->get()).isF16()) {
+    return failure();
+  }
+  Type outputType = getElementType(op.getOutputOperand(0)->get());
+  if (!outputType.isF16() && !outputType.isF32()) return failure();
+
+  auto lhsShape = getUntiledShape(op.getInputOperand(0)->get());
+  auto rhsShape = getUntiledShape(op.getInputOperand(1)->get());
+  if (lhsShape.size() != 2 || rhsShape.size() != 2) return failure();
+  int64_t sizeM = lhsShape[0];
+  int64_t sizeK = lhsShape[1];
+  int64_t sizeN = rhsShape[1];
+  if (sizeM <= 0 || sizeN <= 0 || sizeK <= 0) return failure();
+
+  // Tensor core kernels are bound by the latency of the loads from global
+  // memory, keep more of them in flight. Starting with sm_80 the copies to
+  // shared memory can be done asynchronously, which frees the registers
+  // otherwise holding the data loaded and allows going deeper.
+  SoftwarePipelineConfig pipelineConfig;
+  if (getSMVersion(entryPoint) >= 80) {
+    pipelineConfig.depth = 4;
+    pipelineConfig.useAsyncCopy = true;
+  } else {
+    pipelineConfig.depth = 3;
+  }
+
+  // Pick the first configuration keeping enough threads resident. The stages
+  // of the pipeline all live in shared memory, so retry with shallower
+  // pipelines before moving on to the next configuration. If none is good
+  // enough, fall back to the one with the best occupancy.
+  GPUOccupancyLimits limits = getOccupancyLimits(entryPoint);
+  int64_t operandBytes = getElementByteSize(op.getInputOperand(0)->get());
+  int64_t accumulatorBytes = getElementByteSize(op.getOutputOperand(0)->get());
+  Optional<TileWorkgroupSizePair> bestConfig;
+  unsigned bestDepth = pipelineConfig.depth;
+  double bestOccupancy = 0.0;
+  SmallVector<TileWorkgroupSizePair> tileSizeConfig;
+  getTensorCoreConfig(tileSizeConfig);
+  for (TileWorkgroupSizePair &config : tileSizeConfig) {
+    if (sizeM % config.tileSize[0] != 0 || sizeN % config.tileSize[1] != 0 ||
+        sizeK % config.tileSize[2] != 0) {
+      continue;
+    }
+    int64_t numThreads = config.workgroupSize[0] * config.workgroupSize[1] *
+                         config.workgroupSize[2];
+    for (unsigned depth = pipelineConfig.depth; depth >= 2; --depth) {
+      MatmulResourceUsage usage = estimateMatmulResourceUsage(
+          config, operandBytes, accumulatorBytes, depth);
+      double occupancy = getOccupancy(limits, numThreads, usage);
+      if (occupancy > bestOccupancy) {
+        bestConfig = config;
+        bestDepth = depth;
+        bestOccupancy = occupancy;
+      }
+      if (occupancy >= kMinOccupancy) break;
+    }
+    if (bestOccupancy >= kMinOccupancy) break;
+  }
+  if (!bestConfig) return failure();
+
+  int64_t tileM = bestConfig->tileSize[0];
+  int64_t tileN = bestConfig->tileSize[1];
+  int64_t tileK = bestConfig->tileSize[2];
+  SmallVector<int64_t, 3> workgroupSize(bestConfig->workgroupSize.begin(),
+                                        bestConfig->workgroupSize.end());
+  int64_t numWarpsX = workgroupSize[0] / cudaWarpSize;
+  int64_t numWarpsY = workgroupSize[1];
+  TileSizesListType tileSizes;
+  tileSizes.push_back({tileM, tileN, tileK});  // Workgroup level.
+  // At the subgroup level each warp gets a slice of the parallel loops.
+  tileSizes.push_back(
+      {tileM / numWarpsY, tileN / numWarpsX});  // Subgroup level.
+  tileSizes.push_back({});                      // Thread level.
+  if (failed(setOpConfigAndEntryPointFnTranslation(
+          entryPoint, op, tileSizes,
+          /*nativeVectorSize=*/ArrayRef<int64_t>{},
+          IREE::HAL::DispatchLoweringPassPipeline::LLVMGPUMatmulTensorCore,
+          workgroupSize))) {
+    return failure();
+  }
+  pipelineConfig.depth = bestDepth;
+  setSoftwarePipelineConfig(entryPoint, pipelineConfig);
+  return success();
+}
+
 static LogicalResult setContractConfig(FuncOp entryPoint, linalg::LinalgOp op) {
   TileSizesListType tileSizes;
   // Infer the MxN size of the matmul based on operands and indexing maps.
@@ -74,17 +341,31 @@ static LogicalResult setContractConfig(FuncOp entryPoint, linalg::LinalgOp op) {
   SmallVector<TileWorkgroupSizePair> tileSizeConfig;
   // Query the best configuration.
   getMatmulConfig(tileSizeConfig);
-  // Pick the best configuration where the original shape is aligned on the tile
-  // size.
+  // Pick the first configuration where the original shape is aligned on the
+  // tile size and that keeps enough threads resident without spilling. If
+  // none is good enough, fall back to the one with the best occupancy.
+  GPUOccupancyLimits limits = getOccupancyLimits(entryPoint);
+  int64_t operandBytes = getElementByteSize(op.getInputOperand(0)->get());
+  int64_t accumulatorBytes = getElementByteSize(op.getOutputOperand(0)->get());
+  unsigned pipelineDepth = SoftwarePipelineConfig().depth;
+  double bestOccupancy = 0.0;
   for (TileWorkgroupSizePair &config : tileSizeConfig) {
-    if (sizeN % config.tileSize[1] == 0 && sizeM % config.tileSize[0] == 0) {
-      tileX = config.tileSize[0];
-      tileY = config.tileSize[1];
-      tileK = config.tileSize[2];
-      workgroupSize.assign(config.workgroupSize.begin(),
-                           config.workgroupSize.end());
-      break;
+    if (sizeN % config.tileSize[1] != 0 || sizeM % config.tileSize[0] != 0) {
+      continue;
     }
+    int64_t numThreads = config.workgroupSize[0] * config.workgroupSize[1] *
+                         config.workgroupSize[2];
+    MatmulResourceUsage usage = estimateMatmulResourceUsage(
+        config, operandBytes, accumulatorBytes, pipelineDepth);
+    double occupancy = getOccupancy(limits, numThreads, usage);
+    if (occupancy <= bestOccupancy) continue;
+    tileX = config.tileSize[0];
+    tileY = config.tileSize[1];
+    tileK = config.tileSize[2];
+    workgroupSize.assign(config.workgroupSize.begin(),
+                         config.workgroupSize.end());
+    bestOccupancy = occupancy;
+    if (occupancy >= kMinOccupancy) break;
   }
   // Currently just a basic tile size to enable tiling and vectorization.
   // TODO: pick a more efficient tile size and tile at subgroup level.
@@ -108,6 +389,133 @@ static LogicalResult setContractConfig(FuncOp entryPoint, linalg::LinalgOp op) {
       workgroupSize);
 }
 
+/// Returns the size of `loop` of `op` as seen from its inputs, or
+/// ShapedType::kDynamicSize if it is not known.
+static int64_t getLoopSize(linalg::LinalgOp op, unsigned loop) {
+  for (OpOperand *input : op.getInputOperands()) {
+    if (op.isScalar(input)) continue;
+    AffineMap map = op.getTiedIndexingMap(input);
+    ArrayRef<int64_t> shape = getUntiledShape(input->get());
+    for (auto result : llvm::enumerate(map.getResults())) {
+      auto dimExpr = result.value().dyn_cast<AffineDimExpr>();
+      if (dimExpr && dimExpr.getPosition() == loop &&
+          result.index() < shape.size()) {
+        return shape[result.index()];
+      }
+    }
+  }
+  return ShapedType::kDynamicSize;
+}
+
+/// Returns the size of the innermost loop of `op` as seen from its inputs, or
+/// ShapedType::kDynamicSize if it is not known.
+static int64_t getInnermostLoopSize(linalg::LinalgOp op) {
+  return getLoopSize(op, op.getNumLoops() - 1);
+}
+
+/// Sets the configuration distributing the innermost reduction dimension of
+/// `op` over the threads of the workgroup. Each workgroup handles a single
+/// element of the output, the warps reduce their partial results with shuffles
+/// and combine them through shared memory.
+static LogicalResult setWarpReductionConfig(FuncOp entryPoint,
+                                            linalg::LinalgOp op) {
+  if (!getWorkgroupReductionCombiner(op)) return failure();
+  // Shuffles only operate on 32-bit values.
+  Type elementType = op.getOutputOperand(0)
+                         ->get()
+                         .getType()
+                         .cast<ShapedType>()
+                         .getElementType();
+  if (!elementType.isF32() && !elementType.isInteger(32)) return failure();
+  // Leave the reductions too small to fill a warp to the default pipeline.
+  int64_t reductionSize = getInnermostLoopSize(op);
+  if (reductionSize != ShapedType::kDynamicSize &&
+      reductionSize < cudaWarpSize) {
+    return failure();
+  }
+  int64_t workgroupSizeX = kMaxReductionWorkgroupSize;
+  if (reductionSize != ShapedType::kDynamicSize) {
+    workgroupSizeX = std::min<int64_t>(workgroupSizeX,
+                                       llvm::PowerOf2Ceil(reductionSize));
+  }
+
+  SmallVector<int64_t, 4> workgroupTileSizes(op.getNumLoops(), 0);
+  for (unsigned loop : getPartitionedLoops(op)) workgroupTileSizes[loop] = 1;
+  TileSizesListType tileSizes;
+  tileSizes.emplace_back(std::move(workgroupTileSizes));  // Workgroup level.
+  tileSizes.push_back({});                                // Subgroup level.
+  tileSizes.push_back({});                                // Thread level.
+  return setOpConfigAndEntryPointFnTranslation(
+      entryPoint, op, tileSizes, /*nativeVectorSize=*/ArrayRef<int64_t>{},
+      IREE::HAL::DispatchLoweringPassPipeline::LLVMGPUWarpReduction,
+      {workgroupSizeX, 1, 1});
+}
+
+/// Sets the configuration of the contractions with at most kMatvecMaxM rows,
+/// e.g. the matmuls of batch-1 decoding. These are bound by reading the rhs
+/// (the weights) once, so instead of staging tiles in shared memory for reuse
+/// the reads of the rhs are made coalesced and as wide as possible:
+/// - if the reduction dimension is contiguous in the rhs, it is split across
+///   all the threads of a workgroup computing a single output element (see
+///   setWarpReductionConfig),
+/// - otherwise each thread of a single warp workgroup reads kMatvecVectorSize
+///   contiguous elements of each row of the rhs, with no shared memory.
+static LogicalResult setMatvecConfig(FuncOp entryPoint, linalg::LinalgOp op) {
+  if (op.getNumParallelLoops() != 2 || op.getNumReductionLoops() != 1) {
+    return failure();
+  }
+  AffineMap outputMap = op.getTiedIndexingMap(op.getOutputOperand(0));
+  AffineMap rhsMap = op.getTiedIndexingMap(op.getInputOperand(1));
+  if (outputMap.getNumResults() != 2 || !outputMap.isProjectedPermutation() ||
+      rhsMap.getNumResults() != 2 || !rhsMap.isProjectedPermutation()) {
+    return failure();
+  }
+  int64_t sizeM = getLoopSize(op, outputMap.getDimPosition(0));
+  if (sizeM == ShapedType::kDynamicSize || sizeM > kMatvecMaxM) {
+    return failure();
+  }
+
+  unsigned rhsInnermostLoop = rhsMap.getDimPosition(1);
+  if (isReductionIterator(op.iterator_types()[rhsInnermostLoop])) {
+    return setWarpReductionConfig(entryPoint, op);
+  }
+
+  // The loops of linalg.matmul are (M, N, K) with a K x N rhs.
+  if (!isa<linalg::MatmulOp>(op)) return failure();
+  int64_t sizeN = getLoopSize(op, 1);
+  int64_t sizeK = getLoopSize(op, 2);
+  // Leave the products too small to be bound by memory to the default
+  // configuration.
+  if (sizeN == ShapedType::kDynamicSize ||
+      sizeN < cudaWarpSize * kMatvecVectorSize ||
+      sizeN % kMatvecVectorSize != 0) {
+    return failure();
+  }
+  int64_t workgroupSizeX = cudaWarpSize;
+  while (sizeN % (workgroupSizeX * kMatvecVectorSize) != 0) {
+    workgroupSizeX /= 2;
+  }
+  // Unroll the reduction to keep more reads of the rhs in flight.
+  int64_t tileK = 1;
+  if (sizeK != ShapedType::kDynamicSize) {
+    for (int64_t candidate : {16, 8, 4, 2}) {
+      if (sizeK % candidate == 0) {
+        tileK = candidate;
+        break;
+      }
+    }
+  }
+  TileSizesListType tileSizes;
+  tileSizes.push_back(
+      {sizeM, workgroupSizeX * kMatvecVectorSize, tileK});  // Workgroup level.
+  tileSizes.push_back({});                                  // Subgroup level.
+  tileSizes.push_back({sizeM, kMatvecVectorSize});          // Thread level.
+  return setOpConfigAndEntryPointFnTranslation(
+      entryPoint, op, tileSizes, /*nativeVectorSize=*/ArrayRef<int64_t>{},
+      IREE::HAL::DispatchLoweringPassPipeline::LLVMGPUMatmulSimt,
+      {workgroupSizeX, 1, 1});
+}
+
 // Basic default properties for linalg ops that haven't been tuned.
 static LogicalResult setRootDefaultConfig(FuncOp entryPoint, Operation *op) {
   IREE::HAL::DispatchLoweringPassPipeline passPipeline =
@@ -192,8 +600,17 @@ static LogicalResult setRootConfig(FuncOp entryPointFn, Operation *computeOp) {
   if (auto linalgOp = dyn_cast<linalg::LinalgOp>(computeOp)) {
     if (linalg::isaContractionOpInterface(linalgOp) &&
         linalgOp.getNumParallelLoops() >= 2) {
+      if (succeeded(setMatvecConfig(entryPointFn, linalgOp))) {
+        return success();
+      }
+      if (succeeded(setTensorCoreConfig(entryPointFn, linalgOp))) {
+        return success();
+      }
       return setContractConfig(entryPointFn, linalgOp);
     }
+    if (succeeded(setWarpReductionConfig(entryPointFn, linalgOp))) {
+      return success();
+    }
   }
   return setRootDefaultConfig(entryPointFn, computeOp);
 }
@@ -201,6 +618,17 @@ static LogicalResult setRootConfig(FuncOp entryPointFn, Operation *computeOp) {
 namespace mlir {
 namespace iree_compiler {
 
+SoftwarePipelineConfig getSoftwarePipelineConfig(
+    IREE::HAL::ExecutableEntryPointOp entryPointOp) {
+  SoftwarePipelineConfig config;
+  if (auto depthAttr =
+          entryPointOp->getAttrOfType<IntegerAttr>(kPipelineDepthAttrName)) {
+    config.depth = depthAttr.getInt();
+  }
+  config.useAsyncCopy = entryPointOp->hasAttr(kAsyncCopyAttrName);
+  return config;
+}
+
 LogicalResult initGPULaunchConfig(ModuleOp moduleOp) {
   llvm::StringMap<IREE::HAL::ExecutableEntryPointOp> entryPointOps =
       getAllEntryPoints(moduleOp);
@@ -7,14 +7,29 @@
 #ifndef IREE_COMPILER_CODEGEN_LLVMGPU_KERNELCONFIG_H_
 #define IREE_COMPILER_CODEGEN_LLVMGPU_KERNELCONFIG_H_
 
+#include "iree/compiler/Dialect/HAL/IR/HALOps.h"
 #include "iree/compiler/Dialect/HAL/IR/LoweringConfig.h"
 #include "mlir/IR/BuiltinOps.h"
 
 namespace mlir {
 namespace iree_compiler {
 
+/// Software pipelining configuration of the loops copying data to shared
+/// memory.
+struct SoftwarePipelineConfig {
+  /// Number of pipeline stages.
+  unsigned depth = 2;
+  /// Whether the copies from global to shared memory are asynchronous.
+  bool useAsyncCopy = false;
+};
+
 LogicalResult initGPULaunchConfig(ModuleOp moduleOp);
 
+/// Returns the software pipelining configuration picked for `entryPointOp` by
+/// `initGPULaunchConfig`.
+SoftwarePipelineConfig getSoftwarePipelineConfig(
+    IREE::HAL::ExecutableEntryPointOp entryPointOp);
+
 }  // namespace iree_compiler
 }  // namespace mlir
 #endif  // IREE_COMPILER_CODEGEN_LLVMGPU_KERNELCONFIG_H_
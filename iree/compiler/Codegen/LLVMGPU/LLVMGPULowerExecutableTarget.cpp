@@ -73,6 +73,7 @@ void LLVMGPULowerExecutableTargetPass::runOnOperation() {
   llvm::StringMap<IREE::HAL::ExecutableEntryPointOp> entryPoints =
       getAllEntryPoints(moduleOp);
   Optional<IREE::HAL::DispatchLoweringPassPipeline> passPipeline;
+  SoftwarePipelineConfig pipelineConfig;
   for (auto &it : entryPoints) {
     auto entryPointOp = it.second;
     if (IREE::HAL::TranslationInfo translationInfo =
@@ -89,6 +90,7 @@ void LLVMGPULowerExecutableTargetPass::runOnOperation() {
         continue;
       }
       passPipeline = currPipeline;
+      pipelineConfig = getSoftwarePipelineConfig(entryPointOp);
     }
   }
 
@@ -106,6 +108,14 @@ void LLVMGPULowerExecutableTargetPass::runOnOperation() {
       case IREE::HAL::DispatchLoweringPassPipeline::LLVMGPUMatmulSimt:
         addGPUMatmulSimtPassPipeline(nestedModulePM);
         break;
+      case IREE::HAL::DispatchLoweringPassPipeline::LLVMGPUMatmulTensorCore:
+        addGPUMatmulTensorCorePassPipeline(nestedModulePM,
+                                           pipelineConfig.depth,
+                                           pipelineConfig.useAsyncCopy);
+        break;
+      case IREE::HAL::DispatchLoweringPassPipeline::LLVMGPUWarpReduction:
+        addGPUWarpReductionPassPipeline(nestedModulePM);
+        break;
       default:
         llvm_unreachable("Unsupported pipeline on GPU target.");
     }
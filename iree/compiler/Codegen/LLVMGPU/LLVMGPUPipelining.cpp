@@ -6,10 +6,18 @@
 
 #include "iree/compiler/Codegen/PassDetail.h"
 #include "iree/compiler/Codegen/Passes.h"
+#include "iree/compiler/Codegen/Utils/MarkerUtils.h"
 #include "iree/compiler/Codegen/Utils/Utils.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "mlir/Dialect/Affine/IR/AffineOps.h"
+#include "mlir/Dialect/GPU/GPUDialect.h"
 #include "mlir/Dialect/GPU/Passes.h"
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
 #include "mlir/Dialect/SCF/Transforms.h"
 #include "mlir/Dialect/Vector/VectorOps.h"
+#include "mlir/IR/Matchers.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 
 //====---------------------------------------------------------------------===//
@@ -21,6 +29,9 @@ namespace iree_compiler {
 
 static const StringLiteral kPipeliningLoopMarker = "__pipelining_K_loop__";
 static const StringLiteral kPipeliningGlobalLoad = "__pipelining_global_load__";
+static const StringLiteral kPipeliningAsyncCommit =
+    "__pipelining_async_commit__";
+static const StringLiteral kPipeliningAsyncWait = "__pipelining_async_wait__";
 
 /// Helper to recursively add operation dependencies within `block` to `dep`
 /// set.
@@ -34,9 +45,13 @@ static void addDepOps(llvm::SmallDenseSet<Operation*>& dep, Operation* op,
 }
 
 /// Assign stages to the loop ops. Simple logic for now, put load from global
-/// memory in stage 0 and the rest in stage 1.
-static void getPipelineStages(
-    scf::ForOp forOp, std::vector<std::pair<Operation*, unsigned>>& ops) {
+/// memory in stage 0 and the rest in the last stage. The values loaded are
+/// carried in registers for `depth - 1` iterations before being consumed.
+/// With asynchronous copies the stores to shared memory are issued along with
+/// the loads and only the wait on the copies is left in the last stage.
+static void getPipelineStages(scf::ForOp forOp,
+                              std::vector<std::pair<Operation*, unsigned>>& ops,
+                              unsigned depth) {
   if (!forOp->hasAttr(kPipeliningLoopMarker)) return;
 
   // Track dependencies of the global memory load.
@@ -47,20 +62,280 @@ static void getPipelineStages(
   }
   // Create a modulo schedule with loads from global memory and the operations
   // it depends on in stage 0. Store to shared memory and computation are in
-  // stage 1. In order to have a correct scheduling even with back edges we
-  // order stages in decreasing order.
+  // the last stage. In order to have a correct scheduling even with back edges
+  // we order stages in decreasing order.
   for (Operation& op : forOp.getBody()->getOperations()) {
     if (!loadDep.count(&op) && !isa<scf::YieldOp>(op))
-      ops.push_back(std::make_pair(&op, 1));
+      ops.push_back(std::make_pair(&op, depth - 1));
   }
   for (Operation& op : forOp.getBody()->getOperations()) {
     if (loadDep.count(&op)) ops.push_back(std::make_pair(&op, 0));
   }
 }
 
+/// Returns true if the copy from `ld` to `st` can be done with a single
+/// cp.async instruction, which copies 4, 8 or 16 contiguous bytes.
+static bool isAsyncCopyCandidate(vector::TransferReadOp ld,
+                                 vector::TransferWriteOp st) {
+  VectorType vectorType = ld.getVectorType();
+  if (vectorType.getRank() != 1 || st.getVectorType() != vectorType) {
+    return false;
+  }
+  if (!ld.permutation_map().isMinorIdentity() ||
+      !st.permutation_map().isMinorIdentity() || !ld.isDimInBounds(0) ||
+      !st.isDimInBounds(0)) {
+    return false;
+  }
+  if (ld.getShapedType().getElementType() != vectorType.getElementType() ||
+      st.getShapedType().getElementType() != vectorType.getElementType()) {
+    return false;
+  }
+  int64_t numBytes =
+      vectorType.getNumElements() * vectorType.getElementTypeBitWidth() / 8;
+  return numBytes == 4 || numBytes == 8 || numBytes == 16;
+}
+
+/// Returns the value at the root of the chain of subviews producing `v`.
+static Value getSubViewChainRoot(Value v) {
+  while (auto subview = v.getDefiningOp<memref::SubViewOp>()) {
+    v = subview.source();
+  }
+  return v;
+}
+
+/// Collects the uses of `v`, looking through subviews, that are not subviews.
+/// Returns failure if the memref escapes in a way that the multi-buffering
+/// cannot handle.
+static LogicalResult getLeafUses(Value v, SmallVectorImpl<OpOperand*>& uses) {
+  for (OpOperand& use : v.getUses()) {
+    Operation* owner = use.getOwner();
+    if (auto subview = dyn_cast<memref::SubViewOp>(owner)) {
+      if (subview.getType().getRank() !=
+          subview.getSourceType().cast<MemRefType>().getRank()) {
+        return failure();
+      }
+      if (failed(getLeafUses(subview.getResult(), uses))) return failure();
+      continue;
+    }
+    if (llvm::any_of(owner->getResultTypes(),
+                     [](Type t) { return t.isa<MemRefType>(); })) {
+      return failure();
+    }
+    uses.push_back(&use);
+  }
+  return success();
+}
+
+/// Clones the chain of subviews between `root` and `v` on top of `newRoot`.
+static Value cloneSubViewChain(OpBuilder& b, Value v, Value root,
+                               Value newRoot) {
+  if (v == root) return newRoot;
+  auto subview = v.getDefiningOp<memref::SubViewOp>();
+  Value source = cloneSubViewChain(b, subview.source(), root, newRoot);
+  return b.create<memref::SubViewOp>(
+      subview.getLoc(), source, subview.getMixedOffsets(),
+      subview.getMixedSizes(), subview.getMixedStrides());
+}
+
+/// Erases the chain of subviews producing `v` if it became dead.
+static void eraseDeadSubViewChain(Value v) {
+  while (auto subview = v.getDefiningOp<memref::SubViewOp>()) {
+    if (!subview->use_empty()) return;
+    v = subview.source();
+    subview.erase();
+  }
+}
+
+/// Returns true if the shared memory buffer `root` is allocated outside of
+/// `forOp`, has a static shape and is only used within `forOp`.
+static bool canMultiBuffer(scf::ForOp forOp, Value root) {
+  Operation* rootOp = root.getDefiningOp();
+  if (!rootOp || !isa<memref::AllocOp, memref::GetGlobalOp>(rootOp) ||
+      forOp->isAncestor(rootOp)) {
+    return false;
+  }
+  auto rootType = root.getType().cast<MemRefType>();
+  if (!rootType.hasStaticShape() || !rootType.getAffineMaps().empty() ||
+      rootType.getMemorySpaceAsInt() != 3) {
+    return false;
+  }
+  SmallVector<OpOperand*> uses;
+  if (failed(getLeafUses(root, uses))) return false;
+  return llvm::all_of(uses, [&](OpOperand* use) {
+    return forOp->isProperAncestor(use->getOwner());
+  });
+}
+
+/// Replaces the shared memory buffer `root` used within `forOp` by a buffer
+/// with `depth` copies of it. Iteration `i` of the loop uses copy
+/// `i % depth` so that asynchronous copies for the next iterations don't
+/// overwrite the data used by the current one.
+static void multiBufferSharedMemory(scf::ForOp forOp, Value root,
+                                    unsigned depth, int64_t step) {
+  Operation* rootOp = root.getDefiningOp();
+  auto rootType = root.getType().cast<MemRefType>();
+  SmallVector<OpOperand*> uses;
+  (void)getLeafUses(root, uses);
+
+  OpBuilder b(rootOp);
+  SmallVector<int64_t, 4> shape = {static_cast<int64_t>(depth)};
+  shape.append(rootType.getShape().begin(), rootType.getShape().end());
+  auto bufferType = MemRefType::get(shape, rootType.getElementType(), {},
+                                    rootType.getMemorySpaceAsInt());
+  Value buffer = b.create<memref::AllocOp>(rootOp->getLoc(), bufferType);
+
+  AffineExpr iv, lb;
+  bindDims(b.getContext(), iv);
+  bindSymbols(b.getContext(), lb);
+  AffineMap slotMap = AffineMap::get(1, 1, (iv - lb).floorDiv(step) % depth);
+  for (OpOperand* use : uses) {
+    Operation* owner = use->getOwner();
+    Location loc = owner->getLoc();
+    b.setInsertionPoint(owner);
+    Value slot = b.create<AffineApplyOp>(
+        loc, slotMap, ValueRange{forOp.getInductionVar(), forOp.lowerBound()});
+    SmallVector<OpFoldResult> offsets(shape.size(), b.getIndexAttr(0));
+    offsets[0] = slot;
+    SmallVector<OpFoldResult> sizes = {b.getIndexAttr(1)};
+    for (int64_t dim : rootType.getShape()) {
+      sizes.push_back(b.getIndexAttr(dim));
+    }
+    SmallVector<OpFoldResult> strides(shape.size(), b.getIndexAttr(1));
+    auto slotType = memref::SubViewOp::inferRankReducedResultType(
+                        rootType.getRank(), bufferType, offsets, sizes,
+                        strides)
+                        .cast<MemRefType>();
+    Value slotView = b.create<memref::SubViewOp>(loc, slotType, buffer,
+                                                 offsets, sizes, strides);
+    Value oldValue = use->get();
+    use->set(cloneSubViewChain(b, oldValue, root, slotView));
+    eraseDeadSubViewChain(oldValue);
+  }
+  if (rootOp->use_empty()) rootOp->erase();
+}
+
+/// Rewrites the global to shared memory copies of `forOp` into asynchronous
+/// copies. The copies are turned into vector.load/vector.store pairs marked
+/// to be lowered to cp.async, followed by a commit of the copies issued. The
+/// barrier making the copies visible to the workgroup is marked so that a
+/// wait on the copies gets inserted in front of it once the loop has been
+/// pipelined.
+static void convertToAsyncCopies(scf::ForOp forOp, unsigned depth) {
+  SmallVector<std::pair<vector::TransferReadOp, vector::TransferWriteOp>>
+      copies;
+  for (Operation& op : forOp.getBody()->getOperations()) {
+    auto ld = dyn_cast<vector::TransferReadOp>(op);
+    if (!ld || !ld->hasAttr(kPipeliningGlobalLoad)) continue;
+    auto st = cast<vector::TransferWriteOp>(ld->use_begin()->getOwner());
+    if (st->getBlock() != forOp.getBody() || !isAsyncCopyCandidate(ld, st)) {
+      return;
+    }
+    copies.emplace_back(ld, st);
+  }
+  if (copies.empty()) return;
+
+  // All the shared memory buffers written need to be multi-buffered.
+  APInt step;
+  if (!matchPattern(forOp.step(), m_ConstantInt(&step))) return;
+  llvm::SetVector<Value> roots;
+  for (auto& copy : copies) {
+    roots.insert(getSubViewChainRoot(copy.second.source()));
+  }
+  if (!llvm::all_of(roots, [&](Value root) {
+        return canMultiBuffer(forOp, root);
+      })) {
+    return;
+  }
+  for (Value root : roots) {
+    multiBufferSharedMemory(forOp, root, depth, step.getSExtValue());
+  }
+
+  OpBuilder builder(forOp.getContext());
+  Operation* lastStore = nullptr;
+  for (auto& copy : copies) {
+    vector::TransferReadOp ld = copy.first;
+    vector::TransferWriteOp st = copy.second;
+    builder.setInsertionPoint(ld);
+    auto load = builder.create<vector::LoadOp>(ld.getLoc(), ld.getVectorType(),
+                                               ld.source(), ld.indices());
+    builder.setInsertionPoint(st);
+    auto store = builder.create<vector::StoreOp>(st.getLoc(), load,
+                                                 st.source(), st.indices());
+    for (Operation* op : {load.getOperation(), store.getOperation()}) {
+      setMarker(op, getAsyncCopyMarker());
+      op->setAttr(kPipeliningGlobalLoad, builder.getUnitAttr());
+    }
+    st.erase();
+    ld.erase();
+    if (!lastStore || lastStore->isBeforeInBlock(store)) lastStore = store;
+  }
+
+  builder.setInsertionPointAfter(lastStore);
+  auto commit = builder.create<LLVM::InlineAsmOp>(
+      lastStore->getLoc(), /*resultTypes=*/TypeRange(),
+      /*operands=*/ValueRange(), "cp.async.commit_group;", /*constraints=*/"",
+      /*has_side_effects=*/true, /*is_align_stack=*/false,
+      LLVM::AsmDialectAttr());
+  commit->setAttr(kPipeliningGlobalLoad, builder.getUnitAttr());
+  commit->setAttr(kPipeliningAsyncCommit, builder.getUnitAttr());
+
+  gpu::BarrierOp barrier;
+  for (Operation* op = commit->getNextNode(); op; op = op->getNextNode()) {
+    if ((barrier = dyn_cast<gpu::BarrierOp>(op))) break;
+  }
+  if (!barrier) {
+    builder.setInsertionPointAfter(commit);
+    barrier = builder.create<gpu::BarrierOp>(commit.getLoc());
+  }
+  barrier->setAttr(kPipeliningAsyncWait, builder.getUnitAttr());
+}
+
+/// Inserts a wait on the asynchronous copies in front of the barriers marked
+/// by `convertToAsyncCopies`. Within the steady state of a pipelined loop the
+/// copies for the `depth - 2` next iterations are committed after the barrier
+/// and may still be in flight. Anywhere else, i.e. in the epilogue or when the
+/// loop could not be pipelined, all the copies need to be complete.
+static void insertAsyncWaits(FuncOp funcOp, unsigned depth) {
+  SmallVector<gpu::BarrierOp> barriers;
+  funcOp.walk([&](gpu::BarrierOp barrier) {
+    if (barrier->hasAttr(kPipeliningAsyncWait)) barriers.push_back(barrier);
+  });
+  for (gpu::BarrierOp barrier : barriers) {
+    bool commitBefore = false, commitAfter = false;
+    for (Operation& op : barrier->getBlock()->getOperations()) {
+      if (!op.hasAttr(kPipeliningAsyncCommit)) continue;
+      if (op.isBeforeInBlock(barrier)) {
+        commitBefore = true;
+      } else {
+        commitAfter = true;
+      }
+    }
+    unsigned numPending = (commitAfter && !commitBefore) ? depth - 2 : 0;
+    OpBuilder builder(barrier);
+    builder.create<LLVM::InlineAsmOp>(
+        barrier.getLoc(), /*resultTypes=*/TypeRange(),
+        /*operands=*/ValueRange(),
+        llvm::formatv("cp.async.wait_group {0};", numPending).str(),
+        /*constraints=*/"", /*has_side_effects=*/true,
+        /*is_align_stack=*/false, LLVM::AsmDialectAttr());
+    barrier->removeAttr(kPipeliningAsyncWait);
+  }
+}
+
 namespace {
 struct LLVMGPUPipeliningPass
     : public LLVMGPUPipeliningBase<LLVMGPUPipeliningPass> {
+  LLVMGPUPipeliningPass(unsigned depth, bool useAsyncCopy) {
+    this->depth = depth;
+    this->useAsyncCopy = useAsyncCopy;
+  }
+  LLVMGPUPipeliningPass(const LLVMGPUPipeliningPass& pass) {
+    this->depth = pass.depth;
+    this->useAsyncCopy = pass.useAsyncCopy;
+  }
+  void getDependentDialects(DialectRegistry& registry) const override {
+    registry.insert<AffineDialect, LLVM::LLVMDialect, memref::MemRefDialect>();
+  }
   void runOnOperation() override {
     auto funcOp = getOperation();
     MLIRContext* context = &getContext();
@@ -88,17 +363,45 @@ struct LLVMGPUPipeliningPass
       if (copyToWorkgroupMemory)
         forOp->setAttr(kPipeliningLoopMarker, builder.getUnitAttr());
     });
+    if (depth < 2) return;
+    if (useAsyncCopy) {
+      SmallVector<scf::ForOp> loops;
+      funcOp.walk([&](scf::ForOp forOp) {
+        if (forOp->hasAttr(kPipeliningLoopMarker)) loops.push_back(forOp);
+      });
+      for (scf::ForOp forOp : loops) convertToAsyncCopies(forOp, depth);
+    }
     scf::PipeliningOption options;
-    options.getScheduleFn = getPipelineStages;
+    unsigned maxDepth = depth;
+    options.getScheduleFn =
+        [maxDepth](scf::ForOp forOp,
+                   std::vector<std::pair<Operation*, unsigned>>& schedule) {
+          getPipelineStages(forOp, schedule, maxDepth);
+        };
     RewritePatternSet pipeliningPatterns(context);
     scf::populateSCFLoopPipeliningPatterns(pipeliningPatterns, options);
     (void)applyPatternsAndFoldGreedily(funcOp, std::move(pipeliningPatterns));
+    if (useAsyncCopy) insertAsyncWaits(funcOp, depth);
   }
+
+ private:
+  Option<unsigned> depth{
+      *this, "num-stages",
+      llvm::cl::desc("Number of pipeline stages. Loads from global memory are "
+                     "issued `num-stages - 1` iterations ahead of their use"),
+      llvm::cl::init(2)};
+  Option<bool> useAsyncCopy{
+      *this, "use-async-copy",
+      llvm::cl::desc("Use asynchronous copies (cp.async, sm_80 and newer) "
+                     "from global to shared memory. Shared memory buffers are "
+                     "replicated for each pipeline stage"),
+      llvm::cl::init(false)};
 };
 }  // namespace
 
-std::unique_ptr<OperationPass<FuncOp>> createLLVMGPUPipeliningPass() {
-  return std::make_unique<LLVMGPUPipeliningPass>();
+std::unique_ptr<OperationPass<FuncOp>> createLLVMGPUPipeliningPass(
+    unsigned depth, bool useAsyncCopy) {
+  return std::make_unique<LLVMGPUPipeliningPass>(depth, useAsyncCopy);
 }
 
 }  // namespace iree_compiler
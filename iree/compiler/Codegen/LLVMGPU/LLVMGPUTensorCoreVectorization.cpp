@@ -0,0 +1,131 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Codegen/PassDetail.h"
+#include "iree/compiler/Codegen/Passes.h"
+#include "iree/compiler/Codegen/Transforms/Transforms.h"
+#include "iree/compiler/Codegen/Utils/MarkerUtils.h"
+#include "iree/compiler/Codegen/Utils/Utils.h"
+#include "mlir/Conversion/VectorToGPU/VectorToGPU.h"
+#include "mlir/Dialect/GPU/GPUDialect.h"
+#include "mlir/Dialect/Linalg/Transforms/Hoisting.h"
+#include "mlir/Dialect/Vector/VectorOps.h"
+#include "mlir/Dialect/Vector/VectorTransforms.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+#include "mlir/Transforms/LoopUtils.h"
+
+//====---------------------------------------------------------------------===//
+// Pass to vectorize matmul ops distributed on warps and convert them to GPU
+// MMA ops mapping to tensor core instructions.
+//====---------------------------------------------------------------------===//
+
+namespace mlir {
+namespace iree_compiler {
+
+/// Size of the matrix fragments handled by a single WMMA operation.
+static constexpr int64_t kWMMASize = 16;
+
+static void populateVectorizationPatterns(RewritePatternSet &patterns) {
+  linalg::insertVectorizationPatterns<linalg::FillOp, linalg::CopyOp,
+                                      linalg::GenericOp,
+                                      linalg::ContractionOpInterface>(
+      patterns, linalg::LinalgVectorizationOptions(),
+      linalg::LinalgTransformationFilter(
+          Identifier::get(getVectorizeMarker(), patterns.getContext())));
+}
+
+/// Unroll all the vector ops to the 16x16x16 fragment size supported by WMMA.
+static Optional<SmallVector<int64_t, 4>> getWMMANativeVectorSize(
+    Operation *op) {
+  if (auto contract = dyn_cast<vector::ContractionOp>(op)) {
+    if (contract.iterator_types().size() != 3) return llvm::None;
+    return SmallVector<int64_t, 4>(3, kWMMASize);
+  }
+  if ((OpTrait::hasElementwiseMappableTraits(op) && op->getNumResults() == 1)) {
+    if (auto vecType = op->getResultTypes()[0].dyn_cast<VectorType>()) {
+      if (vecType.getRank() < 2) return llvm::None;
+      SmallVector<int64_t, 4> nativeSize(vecType.getRank(), 1);
+      nativeSize[vecType.getRank() - 1] = kWMMASize;
+      nativeSize[vecType.getRank() - 2] = kWMMASize;
+      return nativeSize;
+    }
+  }
+  if (auto vt = dyn_cast<VectorTransferOpInterface>(op)) {
+    int64_t rank = vt.getVectorType().getRank();
+    if (rank < 2) return llvm::None;
+    SmallVector<int64_t, 4> nativeSize(rank, 1);
+    nativeSize[rank - 1] = kWMMASize;
+    nativeSize[rank - 2] = kWMMASize;
+    return nativeSize;
+  }
+  return llvm::None;
+}
+
+static void populateVectorUnrollPatterns(RewritePatternSet &patterns) {
+  vector::populateVectorUnrollPatterns(
+      patterns,
+      vector::UnrollVectorOptions().setNativeShapeFn(getWMMANativeVectorSize));
+}
+
+namespace {
+struct LLVMGPUTensorCoreVectorizationPass
+    : public LLVMGPUTensorCoreVectorizationBase<
+          LLVMGPUTensorCoreVectorizationPass> {
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<gpu::GPUDialect, vector::VectorDialect>();
+  }
+  void runOnOperation() override {
+    auto funcOp = getOperation();
+    MLIRContext *context = &getContext();
+    {
+      // Step 1. Vectorize.
+      RewritePatternSet vectorizationPatterns(context);
+      populateVectorizationPatterns(vectorizationPatterns);
+      (void)applyPatternsAndFoldGreedily(funcOp,
+                                         std::move(vectorizationPatterns));
+      funcOp.walk([&](Operation *op) {
+        if (auto contract = canonicalizeContractionAdd(op))
+          op->replaceAllUsesWith(contract);
+      });
+    }
+    {
+      // Step 2. Unroll the vectors to the WMMA fragment size and canonicalize.
+      RewritePatternSet vectorUnrollPatterns(context);
+      populateVectorUnrollPatterns(vectorUnrollPatterns);
+      vector::populateVectorToVectorCanonicalizationPatterns(
+          vectorUnrollPatterns);
+      (void)applyPatternsAndFoldGreedily(funcOp,
+                                         std::move(vectorUnrollPatterns));
+    }
+    // Step 3. Keep the accumulators in registers across the reduction loop so
+    // that they can be converted to MMA matrices carried by the loop. The
+    // subviews of the output are loop invariant but created inside the loop
+    // by tiling, hoist them first.
+    funcOp.walk([&](LoopLikeOpInterface loopLike) {
+      if (failed(moveLoopInvariantCode(loopLike)))
+        llvm_unreachable("unexpected failure to move invariant code");
+    });
+    linalg::hoistRedundantVectorTransfers(funcOp);
+    {
+      // Step 4. Convert the 2-D contractions and the transfers feeding them to
+      // GPU MMA ops.
+      RewritePatternSet prepareMMAPatterns(context);
+      populatePrepareVectorToMMAPatterns(prepareMMAPatterns);
+      (void)applyPatternsAndFoldGreedily(funcOp,
+                                         std::move(prepareMMAPatterns));
+      convertVectorToMMAOps(funcOp);
+    }
+  }
+};
+}  // namespace
+
+std::unique_ptr<OperationPass<FuncOp>>
+createLLVMGPUTensorCoreVectorizationPass() {
+  return std::make_unique<LLVMGPUTensorCoreVectorizationPass>();
+}
+
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -126,6 +126,83 @@ static void populateTilingToInvocationPatterns(
           Identifier::get(getVectorizeMarker(), context)));
 }
 
+/// Return the warp ids and the number of warps along each dimension of the
+/// workgroup. Warps are formed by consecutive threads along the x dimension.
+static SmallVector<linalg::ProcInfo, 2> getWarpIdsAndCounts(
+    OpBuilder &builder, Location loc, unsigned numDims,
+    ArrayRef<int64_t> workgroupSize) {
+  static constexpr int64_t kWarpSize = 32;
+  assert(numDims <= kNumGPUDims);
+  SmallVector<linalg::ProcInfo, 2> procInfo(numDims);
+  std::array<StringRef, kNumGPUDims> dimAttr{"x", "y", "z"};
+  Type indexType = builder.getIndexType();
+  for (unsigned i = 0; i < numDims; ++i) {
+    StringAttr attr = builder.getStringAttr(dimAttr[i]);
+    Value id = builder.create<gpu::ThreadIdOp>(loc, indexType, attr);
+    int64_t count = workgroupSize[i];
+    if (i == 0) {
+      id = builder.create<SignedDivIOp>(
+          loc, id, builder.create<ConstantIndexOp>(loc, kWarpSize));
+      count = count / kWarpSize;
+    }
+    procInfo[numDims - 1 - i] = {id,
+                                 builder.create<ConstantIndexOp>(loc, count)};
+  }
+  return procInfo;
+}
+
+/// Patterns for warp level tiling. Each warp gets a tile of the parallel loops
+/// sized according to the subgroup level of the lowering config.
+static void populateTilingToWarpPatterns(MLIRContext *context,
+                                         OwningRewritePatternList &patterns,
+                                         ArrayRef<int64_t> workgroupSize) {
+  linalg::TileSizeComputationFunction getWarpTileSizeFn =
+      [](OpBuilder &builder, Operation *operation) {
+        SmallVector<Value, 4> tileSizesVal;
+        SmallVector<int64_t, 4> tileSizes = getTileSizes(operation, 1);
+        if (tileSizes.empty()) return SmallVector<Value, 4>();
+        SmallVector<unsigned> partitionedLoops = getPartitionedLoops(operation);
+        llvm::DenseSet<unsigned> partitionedLoopsSet(partitionedLoops.begin(),
+                                                     partitionedLoops.end());
+        tileSizesVal.reserve(tileSizes.size());
+        for (auto val : llvm::enumerate(tileSizes)) {
+          int64_t useTileSize =
+              partitionedLoopsSet.count(val.index()) ? val.value() : 0;
+          tileSizesVal.push_back(builder.create<ConstantIndexOp>(
+              operation->getLoc(), useTileSize));
+        }
+        return tileSizesVal;
+      };
+
+  auto getWarpProcInfoFn = [workgroupSize](
+                               OpBuilder &builder, Location loc,
+                               ArrayRef<Range> parallelLoopRanges) {
+    return getWarpIdsAndCounts(builder, loc, parallelLoopRanges.size(),
+                               workgroupSize);
+  };
+  linalg::LinalgLoopDistributionOptions warpDistributionOptions;
+  warpDistributionOptions.procInfo = getWarpProcInfoFn;
+  warpDistributionOptions.distributionMethod = {
+      {linalg::DistributionMethod::Cyclic, linalg::DistributionMethod::Cyclic,
+       linalg::DistributionMethod::Cyclic}};
+
+  auto tilingOptions = linalg::LinalgTilingOptions()
+                           .setLoopType(linalg::LinalgTilingLoopType::Loops)
+                           .setTileSizeComputationFunction(getWarpTileSizeFn)
+                           .setDistributionOptions(warpDistributionOptions);
+
+  patterns.insert<linalg::LinalgTilingPattern<linalg::MatmulOp>,
+                  linalg::LinalgTilingPattern<linalg::FillOp>,
+                  linalg::LinalgTilingPattern<linalg::BatchMatmulOp>,
+                  linalg::LinalgTilingPattern<linalg::GenericOp>>(
+      context, tilingOptions,
+      linalg::LinalgTransformationFilter(
+          {Identifier::get(getWorkgroupMarker(), context),
+           Identifier::get(getWorkgroupKTiledMarker(), context),
+           Identifier::get(getWorkgroupMemoryMarker(), context)},
+          Identifier::get(getVectorizeMarker(), context)));
+}
+
 static LogicalResult copyToWorkgroupMemory(OpBuilder &b, Value src, Value dst) {
   auto copyOp = b.create<linalg::CopyOp>(src.getLoc(), src, dst);
   setMarker(copyOp, getCopyToWorkgroupMemoryMarker());
@@ -198,6 +275,12 @@ static void populatePromotionPatterns(MLIRContext *context,
 namespace {
 struct LLVMGPUTileAndDistributePass
     : public LLVMGPUTileAndDistributeBase<LLVMGPUTileAndDistributePass> {
+  LLVMGPUTileAndDistributePass(bool distributeToWarp) {
+    this->distributeToWarp = distributeToWarp;
+  }
+  LLVMGPUTileAndDistributePass(const LLVMGPUTileAndDistributePass &pass) {
+    this->distributeToWarp = pass.distributeToWarp;
+  }
   void getDependentDialects(DialectRegistry &registry) const override {
     registry.insert<AffineDialect, gpu::GPUDialect>();
   }
@@ -270,7 +353,14 @@ struct LLVMGPUTileAndDistributePass
       funcOp.dump();
     });
 
-    {
+    if (distributeToWarp) {
+      // Apply last level of tiling and distribute to warps.
+      OwningRewritePatternList warpLevelTilingPatterns(context);
+      populateTilingToWarpPatterns(context, warpLevelTilingPatterns,
+                                   workgroupSize);
+      (void)applyPatternsAndFoldGreedily(funcOp,
+                                         std::move(warpLevelTilingPatterns));
+    } else {
       // Apply last level of tiling and distribute to threads.
       OwningRewritePatternList threadLevelTilingPatterns(context);
       populateTilingToInvocationPatterns(context, threadLevelTilingPatterns,
@@ -293,12 +383,19 @@ struct LLVMGPUTileAndDistributePass
       funcOp.dump();
     });
   }
+
+ private:
+  Option<bool> distributeToWarp{
+      *this, "distribute-to-warp",
+      llvm::cl::desc("Distribute the last level of tiling to warps instead "
+                     "of threads, using the subgroup level tile sizes"),
+      llvm::cl::init(false)};
 };
 }  // namespace
 
 std::unique_ptr<OperationPass<FuncOp>>
-createLLVMGPUTileAndDistributeToThreads() {
-  return std::make_unique<LLVMGPUTileAndDistributePass>();
+createLLVMGPUTileAndDistributeToThreads(bool distributeToWarp) {
+  return std::make_unique<LLVMGPUTileAndDistributePass>(distributeToWarp);
 }
 
 }  // namespace iree_compiler
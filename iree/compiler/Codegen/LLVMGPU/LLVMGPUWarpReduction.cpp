@@ -0,0 +1,82 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Codegen/LLVMGPU/LLVMGPUUtils.h"
+#include "iree/compiler/Codegen/PassDetail.h"
+#include "iree/compiler/Codegen/Passes.h"
+#include "iree/compiler/Codegen/Transforms/Transforms.h"
+#include "mlir/Dialect/Affine/IR/AffineOps.h"
+#include "mlir/Dialect/GPU/GPUDialect.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/SCF/SCF.h"
+
+//====---------------------------------------------------------------------===//
+// Pass to distribute the innermost reduction dimension of linalg ops over the
+// threads of the workgroup, reducing within warps with shuffles.
+//====---------------------------------------------------------------------===//
+
+namespace mlir {
+namespace iree_compiler {
+
+static constexpr int64_t kWarpSize = 32;
+/// Address space of the shared memory.
+static constexpr unsigned kSharedMemorySpace = 3;
+
+/// Reduces `value` across the warp with a butterfly of xor shuffles. At the
+/// end all the lanes hold the result.
+static Value warpReduce(OpBuilder &b, Location loc, Value value,
+                        Operation *combiner) {
+  Value width = b.create<ConstantOp>(loc, b.getI32IntegerAttr(kWarpSize));
+  StringAttr xorMode = b.getStringAttr("xor");
+  for (int64_t offset = kWarpSize / 2; offset > 0; offset /= 2) {
+    Value offsetVal = b.create<ConstantOp>(loc, b.getI32IntegerAttr(offset));
+    auto shuffleOp = b.create<gpu::ShuffleOp>(
+        loc, TypeRange{value.getType(), b.getI1Type()}, value, offsetVal,
+        width, xorMode);
+    value = createCombinerOp(b, loc, combiner, value, shuffleOp.getResult(0));
+  }
+  return value;
+}
+
+namespace {
+class LLVMGPUWarpReductionPass
+    : public LLVMGPUWarpReductionBase<LLVMGPUWarpReductionPass> {
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<AffineDialect, gpu::GPUDialect, memref::MemRefDialect,
+                    scf::SCFDialect>();
+  }
+  void runOnOperation() override {
+    FuncOp funcOp = getOperation();
+    if (!getEntryPoint(funcOp)) return;
+    std::array<int64_t, 3> workgroupSize = getWorkgroupSize(funcOp);
+
+    SmallVector<linalg::GenericOp> reductionOps;
+    funcOp.walk([&](linalg::GenericOp op) {
+      if (getWorkgroupReductionCombiner(op)) reductionOps.push_back(op);
+    });
+
+    WorkgroupReductionOptions options;
+    options.workgroupSize = workgroupSize[0];
+    options.subgroupSize = kWarpSize;
+    options.workgroupMemorySpace = kSharedMemorySpace;
+    options.subgroupReduceFn = warpReduce;
+    OpBuilder builder(funcOp.getContext());
+    for (linalg::GenericOp op : reductionOps) {
+      if (failed(lowerToWorkgroupReduction(builder, op, options))) {
+        op.emitOpError("failed to distribute the reduction over the warps");
+        return signalPassFailure();
+      }
+    }
+  }
+};
+}  // namespace
+
+std::unique_ptr<OperationPass<FuncOp>> createLLVMGPUWarpReductionPass() {
+  return std::make_unique<LLVMGPUWarpReductionPass>();
+}
+
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -79,6 +79,54 @@ void addGPUMatmulSimtPassPipeline(OpPassManager &pm) {
   pm.addNestedPass<FuncOp>(createLLVMGPUPipeliningPass());
 }
 
+void addGPUMatmulTensorCorePassPipeline(OpPassManager &pm,
+                                        unsigned pipelineDepth,
+                                        bool useAsyncCopy) {
+  // Convert tensor to buffers.
+  addLinalgBufferizePasses(pm, gpuAllocationFunction);
+  //===--------------------------------------------------------------------===//
+  // Initial clean up.
+  //===--------------------------------------------------------------------===//
+  pm.addPass(createCanonicalizerPass());
+  pm.addPass(createCSEPass());
+
+  // Distribute linalg onto warps within the workgroup.
+  pm.addNestedPass<FuncOp>(
+      createLLVMGPUTileAndDistributeToThreads(/*distributeToWarp=*/true));
+  pm.addNestedPass<FuncOp>(createLLVMGPUDistributeSharedMemoryCopy());
+  pm.addPass(createCanonicalizerPass());
+  pm.addPass(createCSEPass());
+
+  pm.addNestedPass<FuncOp>(createLLVMGPURemoveSingleIterationLoopPass());
+
+  // Linalg -> vector -> MMA
+  pm.addNestedPass<FuncOp>(createLLVMGPUTensorCoreVectorizationPass());
+  pm.addNestedPass<FuncOp>(createCanonicalizerPass());
+  pm.addNestedPass<FuncOp>(createCSEPass());
+  pm.addNestedPass<FuncOp>(createOptimizeVectorTransferPass());
+
+  // Pipeline memory operations.
+  pm.addNestedPass<FuncOp>(
+      createLLVMGPUPipeliningPass(pipelineDepth, useAsyncCopy));
+}
+
+void addGPUWarpReductionPassPipeline(OpPassManager &pm) {
+  // Convert tensor to buffers.
+  addLinalgBufferizePasses(pm, gpuAllocationFunction);
+  //===--------------------------------------------------------------------===//
+  // Initial clean up.
+  //===--------------------------------------------------------------------===//
+  pm.addPass(createCanonicalizerPass());
+  pm.addPass(createCSEPass());
+
+  // Distribute the reduction dimension onto the threads within the workgroup.
+  // The other ops of the dispatch only touch the few elements of the output
+  // handled by the workgroup and are executed by every thread.
+  pm.addNestedPass<FuncOp>(createLLVMGPUWarpReductionPass());
+  pm.addPass(createCanonicalizerPass());
+  pm.addPass(createCSEPass());
+}
+
 void addGPUSimpleDistributePassPipeline(OpPassManager &pm) {
   // Convert tensor to buffers.
   addLinalgBufferizePasses(pm, gpuAllocationFunction);
@@ -154,3 +154,112 @@ hal.executable @reduction_dispatch {
 // CHECK-SAME:   lowering.config = #[[CONFIG]]
 //      CHECK: linalg.generic
 // CHECK-SAME:   lowering.config = #[[CONFIG]]
+
+// -----
+
+hal.executable @matvec_dispatch attributes {sym_visibility = "private"} {
+  hal.executable.variant @cuda, target = #hal.executable.target<"cuda", "cuda-nvptx-fb"> {
+    hal.executable.entry_point @matvec_dispatch attributes {interface = @legacy_io, ordinal = 0 : index}
+    module  {
+      func @matvec_dispatch() {
+        %c0 = constant 0 : index
+        %c1 = constant 1 : index
+        %c3072 = constant 3072 : index
+        %cst = constant 0.000000e+00 : f32
+        %0 = hal.interface.binding.subspan @io::@ro0[%c0] : memref<1x768xf32>
+        %1 = hal.interface.binding.subspan @io::@ro1[%c0] : memref<768x3072xf32>
+        %2 = hal.interface.binding.subspan @io::@wo2[%c0] : memref<1x3072xf32>
+        %workgroup_size_x = hal.interface.workgroup.size[0] : index
+        %workgroup_size_y = hal.interface.workgroup.size[1] : index
+        %workgroup_id_x = hal.interface.workgroup.id[0] : index
+        %workgroup_count_x = hal.interface.workgroup.count[0] : index
+        %workgroup_id_y = hal.interface.workgroup.id[1] : index
+        %workgroup_count_y = hal.interface.workgroup.count[1] : index
+        %3 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_id_y, %workgroup_size_y]
+        %4 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_count_y, %workgroup_size_y]
+        scf.for %arg0 = %3 to %c1 step %4 {
+          %5 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_id_x, %workgroup_size_x]
+          %6 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_count_x, %workgroup_size_x]
+          scf.for %arg1 = %5 to %c3072 step %6 {
+            %7 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 1)>(%arg0)[%workgroup_size_y]
+            %8 = memref.subview %0[%arg0, 0] [%7, 768] [1, 1] : memref<1x768xf32> to memref<?x768xf32, affine_map<(d0, d1)[s0] -> (d0 * 768 + s0 + d1)>>
+            %9 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 3072)>(%arg1)[%workgroup_size_x]
+            %10 = memref.subview %1[0, %arg1] [768, %9] [1, 1] : memref<768x3072xf32> to memref<768x?xf32, affine_map<(d0, d1)[s0] -> (d0 * 3072 + s0 + d1)>>
+            %11 = memref.subview %2[%arg0, %arg1] [%7, %9] [1, 1] : memref<1x3072xf32> to memref<?x?xf32, affine_map<(d0, d1)[s0] -> (d0 * 3072 + s0 + d1)>>
+            linalg.fill(%cst, %11) : f32, memref<?x?xf32, affine_map<(d0, d1)[s0] -> (d0 * 3072 + s0 + d1)>>
+            linalg.matmul {__internal_linalg_transform__ = "workgroup"} ins(%8, %10 : memref<?x768xf32, affine_map<(d0, d1)[s0] -> (d0 * 768 + s0 + d1)>>, memref<768x?xf32, affine_map<(d0, d1)[s0] -> (d0 * 3072 + s0 + d1)>>) outs(%11 : memref<?x?xf32, affine_map<(d0, d1)[s0] -> (d0 * 3072 + s0 + d1)>>)
+          }
+        }
+        return
+      }
+      hal.interface @legacy_io attributes {sym_visibility = "private"} {
+        hal.interface.binding @ro0, set=0, binding=0, type="StorageBuffer", access="Read"
+        hal.interface.binding @ro1, set=0, binding=1, type="StorageBuffer", access="Read"
+        hal.interface.binding @wo2, set=0, binding=2, type="StorageBuffer", access="Write|Discard"
+      }
+    }
+  }
+}
+//  CHECK-DAG: #[[CONFIG:.+]] = {tileSizes = {{\[}}[1, 128, 16], [], [1, 4]{{\]}}}
+//      CHECK: hal.executable.entry_point @matvec_dispatch
+// CHECK-SAME:     passPipeline = 4 : i32
+// CHECK-SAME:     workloadPerWorkgroup = [128, 1]
+// CHECK-SAME:     workgroup_size = [32 : index, 1 : index, 1 : index]
+//      CHECK: func @matvec_dispatch
+//      CHECK:   linalg.matmul
+// CHECK-SAME:       lowering.config = #[[CONFIG]]
+
+// -----
+
+hal.executable @dot_f64_dispatch attributes {sym_visibility = "private"} {
+  hal.executable.variant @cuda, target = #hal.executable.target<"cuda", "cuda-nvptx-fb"> {
+    hal.executable.entry_point @dot_f64_dispatch attributes {interface = @legacy_io, ordinal = 0 : index}
+    module  {
+      func @dot_f64_dispatch() {
+        %c0 = constant 0 : index
+        %c512 = constant 512 : index
+        %cst = constant 0.000000e+00 : f64
+        %0 = hal.interface.binding.subspan @io::@ro0[%c0] : memref<512x512xf64>
+        %1 = hal.interface.binding.subspan @io::@ro1[%c0] : memref<512x512xf64>
+        %2 = hal.interface.binding.subspan @io::@wo2[%c0] : memref<512x512xf64>
+        %workgroup_size_x = hal.interface.workgroup.size[0] : index
+        %workgroup_size_y = hal.interface.workgroup.size[1] : index
+        %workgroup_id_x = hal.interface.workgroup.id[0] : index
+        %workgroup_count_x = hal.interface.workgroup.count[0] : index
+        %workgroup_id_y = hal.interface.workgroup.id[1] : index
+        %workgroup_count_y = hal.interface.workgroup.count[1] : index
+        %3 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_id_y, %workgroup_size_y]
+        %4 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_count_y, %workgroup_size_y]
+        scf.for %arg0 = %3 to %c512 step %4 {
+          %5 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_id_x, %workgroup_size_x]
+          %6 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_count_x, %workgroup_size_x]
+          scf.for %arg1 = %5 to %c512 step %6 {
+            %7 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 512)>(%arg0)[%workgroup_size_y]
+            %8 = memref.subview %0[%arg0, 0] [%7, 512] [1, 1] : memref<512x512xf64> to memref<?x512xf64, affine_map<(d0, d1)[s0] -> (d0 * 512 + s0 + d1)>>
+            %9 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 512)>(%arg1)[%workgroup_size_x]
+            %10 = memref.subview %1[0, %arg1] [512, %9] [1, 1] : memref<512x512xf64> to memref<512x?xf64, affine_map<(d0, d1)[s0] -> (d0 * 512 + s0 + d1)>>
+            %11 = memref.subview %2[%arg0, %arg1] [%7, %9] [1, 1] : memref<512x512xf64> to memref<?x?xf64, affine_map<(d0, d1)[s0] -> (d0 * 512 + s0 + d1)>>
+            linalg.fill(%cst, %11) : f64, memref<?x?xf64, affine_map<(d0, d1)[s0] -> (d0 * 512 + s0 + d1)>>
+            linalg.matmul {__internal_linalg_transform__ = "workgroup"} ins(%8, %10 : memref<?x512xf64, affine_map<(d0, d1)[s0] -> (d0 * 512 + s0 + d1)>>, memref<512x?xf64, affine_map<(d0, d1)[s0] -> (d0 * 512 + s0 + d1)>>) outs(%11 : memref<?x?xf64, affine_map<(d0, d1)[s0] -> (d0 * 512 + s0 + d1)>>)
+          }
+        }
+        return
+      }
+      hal.interface @legacy_io attributes {sym_visibility = "private"} {
+        hal.interface.binding @ro0, set=0, binding=0, type="StorageBuffer", access="Read"
+        hal.interface.binding @ro1, set=0, binding=1, type="StorageBuffer", access="Read"
+        hal.interface.binding @wo2, set=0, binding=2, type="StorageBuffer", access="Write|Discard"
+      }
+    }
+  }
+}
+// The f64 accumulators of the larger tiles need so many registers that too few
+// workgroups would be resident; a smaller tile is picked instead.
+//  CHECK-DAG: #[[CONFIG:.+]] = {tileSizes = {{\[}}[16, 64, 4], [], [8, 4]{{\]}}}
+//      CHECK: hal.executable.entry_point @dot_f64_dispatch
+// CHECK-SAME:     passPipeline = 4 : i32
+// CHECK-SAME:     workloadPerWorkgroup = [64, 16]
+// CHECK-SAME:     workgroup_size = [16 : index, 2 : index, 1 : index]
+//      CHECK: func @dot_f64_dispatch
+//      CHECK:   linalg.matmul
+// CHECK-SAME:       lowering.config = #[[CONFIG]]
@@ -454,3 +454,74 @@ hal.executable.variant @cuda, target = #hal.executable.target<"cuda", "cuda-nvpt
 //         CHECK:   hal.executable.variant @cuda
 // CHECK-COUNT-4:   llvm.fadd
 //         CHECK:   llvm.store %{{.*}} : !llvm.ptr<vector<4xf32>>
+
+// -----
+
+// Check that a f16 matmul targeting a GPU with tensor cores is lowered to
+// WMMA operations.
+#map0 = affine_map<()[s0, s1] -> (s0 * s1)>
+#map1 = affine_map<(d0)[s0] -> (s0, -d0 + 1024)>
+#map2 = affine_map<(d0)[s0] -> (-d0 + 1024, s0)>
+hal.executable @dot_f16_dispatch_0 attributes {sym_visibility = "private"} {
+  hal.interface @io {
+    hal.interface.binding @ro0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @ro1, set=0, binding=1, type="StorageBuffer", access="Read"
+    hal.interface.binding @wo2, set=0, binding=2, type="StorageBuffer", access="Write|Discard"
+  }
+  hal.executable.variant @cuda, target = #hal.executable.target<"cuda", "cuda-nvptx-fb", {target_arch = "sm_80"}> {
+    hal.executable.entry_point @dot_f16_dispatch_0 attributes {interface = @io, ordinal = 0 : index}
+    module  {
+      func @dot_f16_dispatch_0() {
+        %cst = constant 0.000000e+00 : f16
+        %c0 = constant 0 : index
+        %c1024 = constant 1024 : index
+        %c1 = constant 1 : index
+        %0 = hal.interface.binding.subspan @io::@ro0[%c0] : !flow.dispatch.tensor<readonly:1024x1024xf16>
+        %1 = hal.interface.binding.subspan @io::@ro1[%c0] : !flow.dispatch.tensor<readonly:1024x1024xf16>
+        %2 = hal.interface.binding.subspan @io::@wo2[%c0] : !flow.dispatch.tensor<writeonly:1024x1024xf16>
+        %workgroup_size_x = hal.interface.workgroup.size[0] : index
+        %workgroup_size_y = hal.interface.workgroup.size[1] : index
+        %workgroup_id_x = hal.interface.workgroup.id[0] : index
+        %workgroup_count_x = hal.interface.workgroup.count[0] : index
+        %workgroup_id_y = hal.interface.workgroup.id[1] : index
+        %workgroup_count_y = hal.interface.workgroup.count[1] : index
+        %3 = affine.apply #map0()[%workgroup_id_y, %workgroup_size_y]
+        %4 = affine.apply #map0()[%workgroup_count_y, %workgroup_size_y]
+        scf.for %arg0 = %3 to %c1024 step %4 {
+          %5 = affine.apply #map0()[%workgroup_id_x, %workgroup_size_x]
+          %6 = affine.apply #map0()[%workgroup_count_x, %workgroup_size_x]
+          scf.for %arg1 = %5 to %c1024 step %6 {
+            %7 = affine.min #map1(%arg0)[%workgroup_size_y]
+            %8 = flow.dispatch.tensor.load %0, offsets = [%arg0, %c0], sizes = [%7, %c1024], strides = [%c1, %c1] : !flow.dispatch.tensor<readonly:1024x1024xf16> -> tensor<?x1024xf16>
+            %9 = affine.min #map1(%arg1)[%workgroup_size_x]
+            %10 = flow.dispatch.tensor.load %1, offsets = [%c0, %arg1], sizes = [%c1024, %9], strides = [%c1, %c1] : !flow.dispatch.tensor<readonly:1024x1024xf16> -> tensor<1024x?xf16>
+            %11 = affine.min #map1(%arg0)[%workgroup_size_y]
+            %12 = affine.min #map1(%arg1)[%workgroup_size_x]
+            %13 = affine.min #map2(%arg0)[%workgroup_size_y]
+            %14 = affine.min #map2(%arg1)[%workgroup_size_x]
+            %15 = linalg.init_tensor [%13, %14] : tensor<?x?xf16>
+            %16 = linalg.fill(%cst, %15) : f16, tensor<?x?xf16> -> tensor<?x?xf16>
+            %17 = linalg.matmul {__internal_linalg_transform__ = "workgroup"} ins(%8, %10 : tensor<?x1024xf16>, tensor<1024x?xf16>) outs(%16 : tensor<?x?xf16>) -> tensor<?x?xf16>
+            flow.dispatch.tensor.store %17, %2, offsets = [%arg0, %arg1], sizes = [%11, %12], strides = [%c1, %c1] : tensor<?x?xf16> -> !flow.dispatch.tensor<writeonly:1024x1024xf16>
+          }
+        }
+        return
+      }
+      hal.interface @io attributes {sym_visibility = "private"} {
+        hal.interface.binding @ro0, set=0, binding=0, type="StorageBuffer", access="Read"
+        hal.interface.binding @ro1, set=0, binding=1, type="StorageBuffer", access="Read"
+        hal.interface.binding @wo2, set=0, binding=2, type="StorageBuffer", access="Write|Discard"
+      }
+    }
+  }
+}
+
+//   CHECK-LABEL: hal.executable @dot_f16_dispatch_0
+//         CHECK:   hal.executable.variant @cuda
+//         CHECK:   llvm.br
+//         CHECK:   llvm.store {{.*}} : !llvm.ptr<vector<4xf16>, 3>
+//         CHECK:   nvvm.wmma.m16n16k16.load.a.f16.row.stride
+//         CHECK:   nvvm.wmma.m16n16k16.load.b.f16.row.stride
+//         CHECK:   nvvm.wmma.m16n16k16.mma.row.row.f16.f16
+//         CHECK:   llvm.br
+//         CHECK:   nvvm.wmma.m16n16k16.store.d.f16.row.stride
@@ -0,0 +1,37 @@
+// RUN: iree-opt -split-input-file -pass-pipeline='builtin.func(iree-llvmgpu-pipelining{num-stages=3 use-async-copy=true})' %s | IreeFileCheck %s
+
+func @async_copy(%a: memref<128x1024xf16>, %out: memref<128x32xf16>) {
+  %c0 = constant 0 : index
+  %c32 = constant 32 : index
+  %c1024 = constant 1024 : index
+  %cst = constant 0.0 : f16
+  %tid = "gpu.thread_id"() {dimension = "x"} : () -> index
+  %shared = memref.alloc() : memref<128x32xf16, 3>
+  %init = constant dense<0.0> : vector<8xf16>
+  %r = scf.for %k = %c0 to %c1024 step %c32 iter_args(%acc = %init) -> (vector<8xf16>) {
+    %ld = vector.transfer_read %a[%tid, %k], %cst {in_bounds = [true]} : memref<128x1024xf16>, vector<8xf16>
+    gpu.barrier
+    vector.transfer_write %ld, %shared[%tid, %c0] {in_bounds = [true]} : vector<8xf16>, memref<128x32xf16, 3>
+    gpu.barrier
+    %v = vector.transfer_read %shared[%tid, %c0], %cst {in_bounds = [true]} : memref<128x32xf16, 3>, vector<8xf16>
+    %add = addf %acc, %v : vector<8xf16>
+    scf.yield %add : vector<8xf16>
+  }
+  vector.transfer_write %r, %out[%tid, %c0] {in_bounds = [true]} : vector<8xf16>, memref<128x32xf16>
+  return
+}
+//       CHECK: affine_map<{{.+}} floordiv 32) mod 3)>
+// CHECK-LABEL: func @async_copy
+//       CHECK:   %[[SHARED:.+]] = memref.alloc() : memref<3x128x32xf16, 3>
+//   CHECK-NOT:   memref<128x32xf16, 3>
+// CHECK-COUNT-2:   cp.async.commit_group
+//       CHECK:   scf.for
+//       CHECK:     cp.async.wait_group 1
+//  CHECK-NEXT:     gpu.barrier
+//       CHECK:     addf
+//       CHECK:     vector.load {{.+}} : memref<128x1024xf16>, vector<8xf16>
+//       CHECK:     vector.store {{.+}} : memref<128x32xf16, #{{.+}}, 3>, vector<8xf16>
+//       CHECK:     cp.async.commit_group
+//       CHECK:     scf.yield
+//       CHECK:   cp.async.wait_group 0
+//       CHECK:   cp.async.wait_group 0
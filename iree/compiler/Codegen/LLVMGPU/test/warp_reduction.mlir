@@ -0,0 +1,46 @@
+// RUN: iree-opt -pass-pipeline='hal.executable(hal.executable.variant(builtin.module(builtin.func(iree-llvmgpu-warp-reduction))))' %s | IreeFileCheck %s
+
+hal.executable @warp_reduction attributes {sym_visibility = "private"} {
+  hal.executable.variant @cuda, target = #hal.executable.target<"cuda", "cuda-nvptx-fb"> {
+    hal.executable.entry_point @warp_reduction attributes {
+      interface = @io,
+      ordinal = 0 : index,
+      workgroup_size = [128: index, 1: index, 1:index]}
+    builtin.module  {
+      builtin.func @warp_reduction(%in : memref<1x1024xf32>, %out : memref<1xf32>) {
+        linalg.generic {
+            indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>,
+                             affine_map<(d0, d1) -> (d0)>],
+            iterator_types = ["parallel", "reduction"]}
+            ins(%in : memref<1x1024xf32>) outs(%out : memref<1xf32>) {
+          ^bb0(%a: f32, %b: f32):
+            %m = maxf %a, %b : f32
+            linalg.yield %m : f32
+        }
+        return
+      }
+    }
+  }
+}
+
+// CHECK-LABEL: builtin.func @warp_reduction
+//       CHECK:   %[[SCRATCH:.+]] = memref.alloc() : memref<4xf32, 3>
+//   CHECK-DAG:   %[[TX:.+]] = "gpu.thread_id"() {dimension = "x"}
+//   CHECK-DAG:   %[[NINF:.+]] = constant 0xFF800000 : f32
+//       CHECK:   scf.for
+//       CHECK:     %[[PARTIAL:.+]] = scf.for %{{.+}} = %[[TX]] to %{{.+}} step %{{.+}} iter_args(%{{.+}} = %[[NINF]]) -> (f32)
+//       CHECK:       memref.load
+//       CHECK:       maxf
+//       CHECK:     gpu.shuffle %[[PARTIAL]], %{{.+}}, %{{.+}} xor : f32
+// CHECK-COUNT-4:   gpu.shuffle
+//       CHECK:     scf.if
+//       CHECK:       memref.store %{{.+}}, %[[SCRATCH]]
+//       CHECK:     gpu.barrier
+//       CHECK:     scf.if
+//       CHECK:       memref.load %[[SCRATCH]]
+// CHECK-COUNT-5:     gpu.shuffle
+//       CHECK:     scf.if
+//       CHECK:       memref.load
+//       CHECK:       maxf
+//       CHECK:       memref.store
+//       CHECK:     gpu.barrier
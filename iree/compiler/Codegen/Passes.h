@@ -95,9 +95,11 @@ createSetNumWorkgroupsPass(ArrayRef<int64_t> workgroupSize = {});
 /// Populates `patterns` with a very specific pattern that vectorizes a
 /// linalg.conv op for a single thread. The linalg.conv should compute on
 /// static-sized subviews. To match, output shape must be 1x1xWoxCo, where Co
-/// Co is a multiple of 4, and filter shape must be 1x1x4xCo.
+/// Co is a multiple of 4, and filter shape must be 1x1x4xCo. If `filter` is
+/// provided only the convolutions it matches are vectorized.
 void populateLinalgToVectorVectorizeConvPatterns(
-    MLIRContext *context, OwningRewritePatternList &patterns);
+    MLIRContext *context, OwningRewritePatternList &patterns,
+    Optional<linalg::LinalgTransformationFilter> filter = llvm::None);
 
 /// Populates `patterns` to convert linalg.mmt4d to vector.contract.
 void populateLinalgToVectorVectorizeMMT4dPatterns(
@@ -123,6 +125,12 @@ std::unique_ptr<OperationPass<ModuleOp>> createConvertToLLVMPass(
 std::unique_ptr<OperationPass<IREE::HAL::ExecutableVariantOp>>
 createLLVMCPULowerExecutableTargetPass(bool lowerToVectors = true);
 
+/// Expands f32 math.exp/log/tanh and sigmoid ops into polynomial
+/// approximations that stay vectorized. |fast| selects the cheaper, lower
+/// accuracy approximations.
+std::unique_ptr<OperationPass<FuncOp>> createLLVMCPUMathApproximationPass(
+    bool fast = false);
+
 /// Pad linalg ops workgroup tiles into the next integer multiple of the target
 /// vector size.
 std::unique_ptr<OperationPass<FuncOp>> createLLVMCPUPadWorkgroupTilesPass();
@@ -138,9 +146,11 @@ createLLVMCPUSynchronizeSymbolVisibilityPass();
 /// Multi-level tiling, padding and vectorization of  linalg ops on tensors.
 std::unique_ptr<OperationPass<FuncOp>> createLLVMCPUTilePadAndVectorizePass();
 
-/// Vectorizes linalg ops executed in the same hal.interface.workgroup.
+/// Vectorizes linalg ops executed in the same hal.interface.workgroup. With
+/// `peelPartialTiles` the vector tile loops are split into a main loop over
+/// full vector tiles and a remainder that is vectorized with masked transfers.
 std::unique_ptr<OperationPass<FuncOp>> createLLVMCPUVectorizationPass(
-    bool lowerToVectors = true);
+    bool lowerToVectors = true, bool peelPartialTiles = false);
 
 /// Replaces llvm.intr.fma with its unfused mul and add ops.
 std::unique_ptr<OperationPass<FuncOp>> createLLVMCPUUnfuseFMAOpsPass();
@@ -149,6 +159,10 @@ std::unique_ptr<OperationPass<FuncOp>> createLLVMCPUUnfuseFMAOpsPass();
 std::unique_ptr<OperationPass<FuncOp>>
 createVectorToAArch64InlineAssemblyPass();
 
+/// Converts vector.contract ops computing mmt4d inner tiles to inline assembly
+/// kernels using the mixed precision instructions of the target CPU.
+std::unique_ptr<OperationPass<FuncOp>> createVectorContractCustomKernelsPass();
+
 //------------------------------------------------------------------------------
 // LLVMCPU Codegen specific patterns.
 //------------------------------------------------------------------------------
@@ -158,6 +172,46 @@ createVectorToAArch64InlineAssemblyPass();
 void populateVectorContractToAArch64InlineAsm(
     OwningRewritePatternList &patterns, MLIRContext *context);
 
+/// Target CPU features the custom vector.contract kernels can make use of.
+struct CustomKernelsTargetInfo {
+  bool isAArch64 = false;
+  bool isX86_64 = false;
+  bool isRISCV = false;
+  // AArch64 int8 (SMMLA) and bf16 (BFMMLA) matrix multiply accumulate.
+  bool hasI8MM = false;
+  bool hasBF16 = false;
+  // x86 AVX-512 int16 (VPDPWSSD) and bf16 (VDPBF16PS) dot products.
+  bool hasAVX512VNNI = false;
+  bool hasAVX512BF16 = false;
+  // AArch64 scalable vector extension (SVE or SVE2).
+  bool hasSVE = false;
+  // RISC-V vector extension (RVV) minimum vector register length (VLEN) in
+  // bits from the `+zvl<N>b` features, or 0 without the vector extension.
+  int64_t riscvVectorBits = 0;
+};
+
+/// Returns the custom kernel features of a target triple and comma-separated
+/// CPU feature list such as `+avx512f,+avx512vnni`.
+CustomKernelsTargetInfo inferCustomKernelsTargetInfo(StringRef targetTriple,
+                                                     StringRef cpuFeatures);
+
+/// Returns the custom kernel features of the hal.executable.variant |op| is
+/// nested within, if it specifies a target triple and CPU features.
+CustomKernelsTargetInfo getCustomKernelsTargetInfo(Operation *op);
+
+/// Populates `patterns` to convert vector.contract ops with row-major matmul
+/// semantics whose operands are extended from i8 or bf16 to inline assembly
+/// kernels using the instructions available on the target.
+void populateVectorContractCustomKernelsPatterns(
+    const CustomKernelsTargetInfo &targetInfo,
+    OwningRewritePatternList &patterns);
+
+/// Populates `patterns` to expand f32 math.exp, math.log and math.tanh ops on
+/// scalars and vectors into polynomial approximations. |fast| selects the
+/// cheaper, lower accuracy approximations.
+void populateLLVMCPUMathApproximationPatterns(
+    OwningRewritePatternList &patterns, bool fast = false);
+
 void populateUnfusedFMAOpsPassPatterns(MLIRContext *context,
                                        OwningRewritePatternList &patterns);
 
@@ -171,9 +225,13 @@ void populateUnfusedFMAOpsPassPatterns(MLIRContext *context,
 void addCPUDefaultPassPipeline(OpPassManager &passManager);
 
 /// Populates the passes needed to lower to vector operations using linalg based
-/// progressive lowering with vectorization after bufferization.
+/// progressive lowering with vectorization after bufferization. Partial tiles
+/// are either padded to full tiles before bufferization (`padPartialTiles`) or
+/// peeled into masked remainder loops (`peelPartialTiles`).
 void addCPUVectorizationPassPipeline(OpPassManager &passManager,
-                                     bool lowerToVectors = true);
+                                     bool lowerToVectors = true,
+                                     bool padPartialTiles = false,
+                                     bool peelPartialTiles = false);
 
 //----------------------------------------------------------------------------//
 // LLVMCPU Pass Pipelines for lowering to LLVM dialect.
@@ -213,6 +271,19 @@ void addGPUVectorizationPassPipeline(OpPassManager &pm);
 /// Lowering calling vectorization patterns.
 void addGPUMatmulSimtPassPipeline(OpPassManager &pm);
 
+/// Lowering using tensor core operations for matmul. The copies to shared
+/// memory are software pipelined with `pipelineDepth` stages, using
+/// asynchronous copies when `useAsyncCopy` is set. Expects pass manager to be
+/// a module-level pass manager.
+void addGPUMatmulTensorCorePassPipeline(OpPassManager &pm,
+                                        unsigned pipelineDepth = 3,
+                                        bool useAsyncCopy = false);
+
+/// Lowering distributing the innermost reduction dimension over the threads of
+/// the workgroup and reducing within warps with shuffles. Expects pass manager
+/// to be a module-level pass manager.
+void addGPUWarpReductionPassPipeline(OpPassManager &pm);
+
 /// Simple lowering only distributute linalg ops on blocks and threads. This
 /// will result in scalar operations. Expects pass manager to be a module-level
 /// pass manager.
@@ -229,9 +300,10 @@ std::unique_ptr<OperationPass<ModuleOp>> createConvertToNVVMPass();
 /// Performs the final conversion to ROCDL+LLVM dialect.
 std::unique_ptr<OperationPass<ModuleOp>> createConvertToROCDLPass();
 
-/// Perform tiling and distribution to threads.
-std::unique_ptr<OperationPass<FuncOp>>
-createLLVMGPUTileAndDistributeToThreads();
+/// Perform tiling and distribution to threads. When `distributeToWarp` is
+/// set the last level of tiling is distributed to warps instead.
+std::unique_ptr<OperationPass<FuncOp>> createLLVMGPUTileAndDistributeToThreads(
+    bool distributeToWarp = false);
 
 std::unique_ptr<OperationPass<FuncOp>>
 createLLVMGPURemoveSingleIterationLoopPass();
@@ -250,8 +322,21 @@ std::unique_ptr<OperationPass<FuncOp>> createLLVMGPUVectorLoweringPass();
 std::unique_ptr<OperationPass<FuncOp>>
 createLLVMGPUDistributeSharedMemoryCopy();
 
-/// Apply software pipelining.
-std::unique_ptr<OperationPass<FuncOp>> createLLVMGPUPipeliningPass();
+/// Apply software pipelining with `depth` stages. When `useAsyncCopy` is set
+/// the copies from global to shared memory are converted to asynchronous
+/// copies and the shared memory buffers are multi-buffered.
+std::unique_ptr<OperationPass<FuncOp>> createLLVMGPUPipeliningPass(
+    unsigned depth = 2, bool useAsyncCopy = false);
+
+/// Convert Linalg matmul ops to Vector and then to GPU MMA ops so that they
+/// get lowered to tensor core instructions.
+std::unique_ptr<OperationPass<FuncOp>>
+createLLVMGPUTensorCoreVectorizationPass();
+
+/// Distribute the innermost reduction dimension of linalg.generic ops over the
+/// threads of the workgroup. The partial results are reduced within warps with
+/// shuffles and then across warps through shared memory.
+std::unique_ptr<OperationPass<FuncOp>> createLLVMGPUWarpReductionPass();
 
 //------------------------------------------------------------------------------
 // SPIRV Passes
@@ -269,6 +354,27 @@ void addSPIRVDistributeToGlobalIDPipeline(OpPassManager &pm);
 /// scalar + vector code. Does distribution to threads and vectorization.
 void addSPIRVVectorizationPassPipeline(OpPassManager &pm);
 
+/// Pipeline to lower executables whose root op is a reduction over the
+/// innermost dimension. Distributes the reduction over the invocations of the
+/// workgroup and reduces within subgroups with non-uniform group operations.
+void addSPIRVSubgroupReductionPassPipeline(OpPassManager &pm);
+
+/// Policy deciding the element types used for the arithmetic of the ops of a
+/// dispatch region on SPIR-V targets.
+enum class SPIRVPrecisionPolicy {
+  /// Use the element types of the dispatch region as they are.
+  Native,
+  /// Keep f16 storage but accumulate f16 matmuls and convolutions in f32, and
+  /// perform f16 elementwise arithmetic in f32 on targets without native f16
+  /// arithmetic.
+  Mixed,
+};
+
+/// Pass to pick the types used for the arithmetic of the Linalg ops on tensors
+/// of a dispatch region according to `policy` and the target capabilities.
+std::unique_ptr<OperationPass<FuncOp>> createSPIRVApplyPrecisionPolicyPass(
+    SPIRVPrecisionPolicy policy = SPIRVPrecisionPolicy::Mixed);
+
 /// Pass to perform the final conversion to SPIR-V dialect.
 /// This pass converts remaining interface ops into SPIR-V global variables,
 /// GPU processor ID ops into SPIR-V global variables, loop/standard ops into
@@ -309,6 +415,12 @@ createSPIRVVectorToCooperativeMatrixPass();
 /// Pass to lower linalg.copy for copying data to workgroup memory.
 std::unique_ptr<OperationPass<FuncOp>> createSPIRVCopyToWorkgroupMemoryPass();
 
+/// Pass to distribute the innermost reduction dimension of linalg.generic ops
+/// over the invocations of the workgroup. The partial results are reduced
+/// within subgroups with non-uniform group operations and then across
+/// subgroups through workgroup memory.
+std::unique_ptr<OperationPass<FuncOp>> createSPIRVSubgroupReductionPass();
+
 /// Converts memref of scalar to memref of vector of efficent size. This will
 /// allow to convert memory accesses to vector load/store in SPIR-V without
 /// having pointer bitcast.
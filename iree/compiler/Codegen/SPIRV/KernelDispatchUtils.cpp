@@ -25,6 +25,7 @@
 #include "iree/compiler/Dialect/Shape/IR/ShapeOps.h"
 #include "iree/compiler/Dialect/Util/IR/UtilOps.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
 #include "mlir/Analysis/SliceAnalysis.h"
 #include "mlir/Dialect/Linalg/Analysis/DependenceAnalysis.h"
 #include "mlir/Dialect/Linalg/IR/LinalgOps.h"
@@ -109,11 +110,106 @@ static void getMaliBestMatMulTileSizes(
   }
 }
 
-/// Launch configuration for Mali GPU configuration.
-static LogicalResult setMaliSpecificConfig(FuncOp entryPoint,
-                                           const spirv::TargetEnv &targetEnv,
-                                           linalg::BatchMatmulOp op) {
-  if (targetEnv.getVendorID() != spirv::Vendor::ARM) return failure();
+static void getAMDBestMatMulTileSizes(
+    Type elementType, SmallVectorImpl<TileWorkgroupSizePair> &tileSizes,
+    int64_t dstSize) {
+  // RDNA GPUs have large register files and execute waves of 32 or 64
+  // invocations: let each invocation compute a 4x4 block with vec4 loads along
+  // N and use large workgroups to cover the latency of the memory accesses.
+  // The 256-invocation workgroups cover a 32x128 destination tile, so a
+  // destination of at most 256x256 elements yields no more than 16 of them;
+  // that leaves most compute units idle and smaller tiles are used instead.
+  // Every entry keeps the same 4x4 block per invocation and K tile of 8 so the
+  // register usage per invocation is the same whichever entry gets picked.
+  const int64_t smallMatrixSizeThreshold = 256 * 256;
+  if (dstSize > smallMatrixSizeThreshold) {
+    tileSizes.push_back(TileWorkgroupSizePair({{32, 128, 8}, {32, 8, 1}}));
+    tileSizes.push_back(TileWorkgroupSizePair({{16, 128, 8}, {32, 4, 1}}));
+  }
+  tileSizes.push_back(TileWorkgroupSizePair({{16, 64, 8}, {16, 4, 1}}));
+  tileSizes.push_back(TileWorkgroupSizePair({{8, 64, 8}, {16, 2, 1}}));
+  tileSizes.push_back(TileWorkgroupSizePair({{8, 32, 8}, {8, 2, 1}}));
+  tileSizes.push_back(TileWorkgroupSizePair({{4, 32, 8}, {8, 1, 1}}));
+}
+
+static void getAdrenoBestMatMulTileSizes(
+    Type elementType, SmallVectorImpl<TileWorkgroupSizePair> &tileSizes,
+    int64_t dstSize) {
+  // Adreno GPUs have a subgroup size of 64 and fewer registers per invocation
+  // than desktop GPUs, so keep a smaller K tile than on AMD. f16 elements take
+  // half the registers of f32 ones, which leaves room to double the K tile for
+  // the same register usage; each invocation still computes a 4x4 block.
+  if (elementType.isF16()) {
+    tileSizes.push_back(TileWorkgroupSizePair({{32, 128, 8}, {32, 8, 1}}));
+    tileSizes.push_back(TileWorkgroupSizePair({{16, 64, 8}, {16, 4, 1}}));
+  }
+  tileSizes.push_back(TileWorkgroupSizePair({{32, 128, 4}, {32, 8, 1}}));
+  tileSizes.push_back(TileWorkgroupSizePair({{16, 128, 4}, {32, 4, 1}}));
+  tileSizes.push_back(TileWorkgroupSizePair({{16, 64, 4}, {16, 4, 1}}));
+  tileSizes.push_back(TileWorkgroupSizePair({{8, 32, 4}, {8, 2, 1}}));
+  tileSizes.push_back(TileWorkgroupSizePair({{4, 32, 4}, {8, 1, 1}}));
+}
+
+/// Gets the list of matmul tile sizes and workgroup sizes, ordered from best to
+/// worst, tuned for the GPU `targetEnv` describes. Leaves `tileSizes` empty if
+/// there is no tuned list for the GPU vendor.
+static void getTargetBestMatMulTileSizes(
+    const spirv::TargetEnv &targetEnv, Type elementType,
+    SmallVectorImpl<TileWorkgroupSizePair> &tileSizes, int64_t dstSize) {
+  switch (targetEnv.getVendorID()) {
+    case spirv::Vendor::ARM:
+      return getMaliBestMatMulTileSizes(elementType, tileSizes, dstSize);
+    case spirv::Vendor::AMD:
+      return getAMDBestMatMulTileSizes(elementType, tileSizes, dstSize);
+    case spirv::Vendor::Qualcomm:
+      return getAdrenoBestMatMulTileSizes(elementType, tileSizes, dstSize);
+    default:
+      return;
+  }
+}
+
+/// Returns the number of 32-bit registers an invocation can use on the GPU
+/// `targetEnv` describes before spilling, or 0 if it is not known.
+static int64_t getMaxRegistersPerInvocation(const spirv::TargetEnv &targetEnv) {
+  switch (targetEnv.getVendorID()) {
+    case spirv::Vendor::ARM:
+    case spirv::Vendor::Qualcomm:
+      return 128;
+    case spirv::Vendor::AMD:
+      return 256;
+    default:
+      return 0;
+  }
+}
+
+/// Returns true if workgroups of `pair` can run a matmul with `elementType`
+/// operands on the GPU `targetEnv` describes: the workgroup has to fit in the
+/// invocation limit and the accumulators plus the lhs and rhs slices of each
+/// invocation have to fit in registers. Used to skip to the next tuned
+/// configuration instead of generating code that spills.
+static bool fitsTargetResources(const spirv::TargetEnv &targetEnv,
+                                const TileWorkgroupSizePair &pair,
+                                Type elementType) {
+  int64_t numInvocations =
+      pair.workgroupSize[0] * pair.workgroupSize[1] * pair.workgroupSize[2];
+  int64_t maxInvocations = targetEnv.getResourceLimits()
+                               .max_compute_workgroup_invocations()
+                               .getInt();
+  if (numInvocations > maxInvocations) return false;
+  int64_t maxRegisters = getMaxRegistersPerInvocation(targetEnv);
+  if (maxRegisters == 0) return true;
+  int64_t tileM = pair.tileSize[0] / pair.workgroupSize[1];
+  int64_t tileN = pair.tileSize[1] / pair.workgroupSize[0];
+  int64_t tileK = pair.tileSize[2];
+  int64_t numElements = tileM * tileN + (tileM + tileN) * tileK;
+  int64_t elementBits = elementType.getIntOrFloatBitWidth();
+  return llvm::divideCeil(numElements * elementBits, 32) <= maxRegisters;
+}
+
+/// Launch configuration for different known GPU configuration.
+static LogicalResult setTargetSpecificConfig(FuncOp entryPoint,
+                                             const spirv::TargetEnv &targetEnv,
+                                             linalg::BatchMatmulOp op) {
 
   ArrayRef<int64_t> lhsShape = getUntiledShape(op.inputs()[0]);
   ArrayRef<int64_t> rhsShape = getUntiledShape(op.inputs()[1]);
@@ -126,13 +222,16 @@ static LogicalResult setMaliSpecificConfig(FuncOp entryPoint,
   // Get a vector of best tile size ordered from best to worst.
   SmallVector<TileWorkgroupSizePair, 4> workgroupLevelTs;
   int64_t dstSize = lhsShape[0] * lhsShape[1] * rhsShape[2];
-  getMaliBestMatMulTileSizes(
-      op.inputs()[0].getType().cast<ShapedType>().getElementType(),
+  getTargetBestMatMulTileSizes(
+      targetEnv, op.inputs()[0].getType().cast<ShapedType>().getElementType(),
       workgroupLevelTs, dstSize);
+  Type elementType =
+      op.inputs()[0].getType().cast<ShapedType>().getElementType();
   for (TileWorkgroupSizePair pair : workgroupLevelTs) {
     if (lhsShape[1] % pair.tileSize[0] != 0 ||
         rhsShape[2] % pair.tileSize[1] != 0 ||
-        lhsShape[2] % pair.tileSize[2] != 0) {
+        lhsShape[2] % pair.tileSize[2] != 0 ||
+        !fitsTargetResources(targetEnv, pair, elementType)) {
       continue;
     }
 
@@ -155,40 +254,6 @@ static LogicalResult setMaliSpecificConfig(FuncOp entryPoint,
   return failure();
 }
 
-/// Launch config for `linalg.batchmatmul`.
-static LogicalResult setRootConfig(FuncOp entryPoint,
-                                   const spirv::TargetEnv &targetEnv,
-                                   linalg::BatchMatmulOp op) {
-  if (succeeded(setMaliSpecificConfig(entryPoint, targetEnv, op))) {
-    return success();
-  }
-  unsigned maxWorkgroupSize = targetEnv.getResourceLimits()
-                                  .max_compute_workgroup_invocations()
-                                  .getInt();
-  std::array<int64_t, 3> workgroupSize = {1, 1, 1};
-  std::tie(workgroupSize[0], workgroupSize[1]) =
-      distributeProcs2D(maxWorkgroupSize);
-  // This is just being hard-wired for now to be minimal viable, but this can be
-  // decided better when we have better estimates of device charecteristics.
-  const int64_t nRowsPerWorkitem = 1;
-  const int64_t nColsPerWorkitem = 1;
-  const int64_t nBatchesPerWorkitem = 1;
-  int64_t tileSizeK = 0;
-  SmallVector<int64_t, 4> workgroupLevel = {
-      nBatchesPerWorkitem, nRowsPerWorkitem * workgroupSize[1],
-      nColsPerWorkitem * workgroupSize[0], tileSizeK};
-  SmallVector<int64_t, 4> invocationLevel = {
-      nBatchesPerWorkitem, nRowsPerWorkitem, nColsPerWorkitem, 0};
-
-  TileSizesListType tileSizes;
-  tileSizes.emplace_back(std::move(workgroupLevel));
-  tileSizes.emplace_back();  // subgroup level
-  tileSizes.emplace_back(std::move(invocationLevel));
-  return setOpConfigAndEntryPointFnTranslation(
-      entryPoint, op, tileSizes, /*nativeVectorSize=*/ArrayRef<int64_t>{},
-      IREE::HAL::DispatchLoweringPassPipeline::SPIRVDistribute, workgroupSize);
-}
-
 /// Returns the size of the co-operative matrix multiply operations on the
 /// device.
 static Optional<SmallVector<int64_t, 4>> getCooperativeMatmulSubgroupSize(
@@ -211,66 +276,173 @@ static Optional<SmallVector<int64_t, 4>> getCooperativeMatmulSubgroupSize(
   return llvm::None;
 }
 
+/// Returns the (M, N) size of the co-operative matrices accumulating values of
+/// `elementType` on the device. This is the size elementwise epilogues on the
+/// matmul result are unrolled to.
+static Optional<SmallVector<int64_t, 4>> getCooperativeMatrixAccumulatorSize(
+    spirv::ResourceLimitsAttr resourceLimits, Type elementType) {
+  for (auto coopMatmulProperties :
+       resourceLimits.cooperative_matrix_properties_nv()
+           .getAsRange<spirv::CooperativeMatrixPropertiesNVAttr>()) {
+    if (coopMatmulProperties.c_type().getValue() == elementType &&
+        coopMatmulProperties.result_type().getValue() == elementType &&
+        coopMatmulProperties.scope().getValue() == spirv::Scope::Subgroup) {
+      return SmallVector<int64_t, 4>{
+          coopMatmulProperties.m_size().getValue().getSExtValue(),
+          coopMatmulProperties.n_size().getValue().getSExtValue()};
+    }
+  }
+  return llvm::None;
+}
+
+/// Returns the number of co-operative matrix multiply operations along
+/// (M, N, K) each subgroup should perform, ordered from best to worst for the
+/// GPU vendor. More operations per subgroup give more reuse of the loaded
+/// matrices but increase register pressure.
+static ArrayRef<std::array<int64_t, 3>> getCooperativeMatmulCountsPerSubgroup(
+    spirv::Vendor vendor) {
+  if (vendor == spirv::Vendor::NVIDIA) {
+    static const std::array<int64_t, 3> nvidiaCounts[] = {
+        {4, 4, 2}, {2, 4, 2}, {2, 2, 2}, {1, 2, 2}, {1, 1, 2}, {1, 1, 1}};
+    return nvidiaCounts;
+  }
+  static const std::array<int64_t, 3> defaultCounts[] = {
+      {2, 2, 1}, {1, 2, 1}, {1, 1, 1}};
+  return defaultCounts;
+}
+
+/// Returns true if `op` is an elementwise operation that can be fused as an
+/// epilogue of a matmul lowered to co-operative matrix operations, i.e. all of
+/// its operands are accessed with the same indices as its result and its body
+/// only uses arithmetic that SPIR-V allows on co-operative matrices.
+static bool isCooperativeMatrixEpilogue(linalg::LinalgOp op) {
+  if (op.getNumParallelLoops() != op.getNumLoops() ||
+      op.hasIndexSemantics() || !isa<linalg::GenericOp>(op)) {
+    return false;
+  }
+  if (!llvm::all_of(op.getIndexingMaps(),
+                    [](AffineMap map) { return map.isMinorIdentity(); })) {
+    return false;
+  }
+  return llvm::all_of(op->getRegion(0).front(), [](Operation &bodyOp) {
+    return isa<AddFOp, SubFOp, DivFOp, NegFOp, AddIOp, SubIOp, SignedDivIOp,
+               UnsignedDivIOp, FPExtOp, FPTruncOp, linalg::YieldOp>(bodyOp);
+  });
+}
+
 /// Launch configuration for using spv.CooperativeMatrixMulAddNV
-/// operations. Needs two levels of tiling.
+/// operations for `linalg.matmul` and `linalg.batch_matmul`. Needs two levels
+/// of tiling.
 static LogicalResult setConfigForCooperativeMatmul(
-    FuncOp entryPoint, const spirv::TargetEnv &targetEnv, linalg::MatmulOp op) {
+    FuncOp entryPoint, const spirv::TargetEnv &targetEnv, linalg::LinalgOp op) {
   if (!targetEnv.allows(spirv::Capability::CooperativeMatrixNV) ||
       !targetEnv.allows(spirv::Extension::SPV_NV_cooperative_matrix))
     return failure();
 
-  ArrayRef<int64_t> lhsShape = getUntiledShape(op.inputs()[0]);
-  ArrayRef<int64_t> rhsShape = getUntiledShape(op.inputs()[1]);
+  ArrayRef<int64_t> lhsShape = getUntiledShape(op.getInputOperand(0)->get());
+  ArrayRef<int64_t> rhsShape = getUntiledShape(op.getInputOperand(1)->get());
   // If the shape size is unknonw fall back to none vectorized path.
   if (llvm::any_of(lhsShape, ShapedType::isDynamic) ||
       llvm::any_of(rhsShape, ShapedType::isDynamic)) {
     return failure();
   }
+  bool isBatchMatmul = isa<linalg::BatchMatmulOp>(op.getOperation());
+  unsigned batchRank = isBatchMatmul ? 1 : 0;
+  if (lhsShape.size() != batchRank + 2 || rhsShape.size() != batchRank + 2) {
+    return failure();
+  }
+  int64_t M = lhsShape[batchRank];
+  int64_t N = rhsShape[batchRank + 1];
+  int64_t K = lhsShape[batchRank + 1];
+
+  // The other ops in the dispatch region are tiled and vectorized along with
+  // the matmul. Only use co-operative matrices if they can all operate on
+  // them as well.
+  bool hasUnsupportedOp = false;
+  entryPoint.walk([&](linalg::LinalgOp otherOp) {
+    if (otherOp == op || isa<linalg::FillOp>(otherOp.getOperation())) return;
+    if (!isCooperativeMatrixEpilogue(otherOp)) hasUnsupportedOp = true;
+  });
+  if (hasUnsupportedOp) return failure();
 
   auto resourceLimits = targetEnv.getResourceLimits();
   auto getElementType = [](Value v) {
     return v.getType().cast<ShapedType>().getElementType();
   };
-  auto outputElementType = getElementType(op.outputs()[0]);
+  auto outputElementType = getElementType(op.getOutputOperand(0)->get());
   Optional<SmallVector<int64_t, 4>> coopMatmulSize =
       getCooperativeMatmulSubgroupSize(
-          resourceLimits, getElementType(op.inputs()[0]),
-          getElementType(op.inputs()[1]), outputElementType, outputElementType);
+          resourceLimits, getElementType(op.getInputOperand(0)->get()),
+          getElementType(op.getInputOperand(1)->get()), outputElementType,
+          outputElementType);
   if (!coopMatmulSize) return failure();
 
-  // Check that the matmul sizes are a multiple of the tilesize.
-  auto isMultipleOf = [](int64_t s, int64_t ts) {
-    return !ShapedType::isDynamic(s) && (s % ts) == 0;
-  };
+  // Pick the largest number of co-operative matrix operations per subgroup
+  // that evenly divides the problem.
+  for (const std::array<int64_t, 3> &counts :
+       getCooperativeMatmulCountsPerSubgroup(targetEnv.getVendorID())) {
+    int64_t tileM = counts[0] * (*coopMatmulSize)[0];
+    int64_t tileN = counts[1] * (*coopMatmulSize)[1];
+    int64_t tileK = counts[2] * (*coopMatmulSize)[2];
+    if (M % tileM != 0 || N % tileN != 0 || K % tileK != 0) continue;
+
+    SmallVector<int64_t, 4> ts = {tileM, tileN, tileK};
+    SmallVector<int64_t, 4> subgroupTs = {tileM, tileN};
+    if (isBatchMatmul) {
+      ts.insert(ts.begin(), 1);
+      subgroupTs.insert(subgroupTs.begin(), 1);
+    }
+    TileSizesListType tileSizes;
+    tileSizes.emplace_back(std::move(ts));
+    tileSizes.emplace_back(std::move(subgroupTs));
 
-  if (!isMultipleOf(lhsShape[0], (*coopMatmulSize)[0]) ||
-      !isMultipleOf(rhsShape[1], (*coopMatmulSize)[1]) ||
-      !isMultipleOf(lhsShape[1], (*coopMatmulSize)[2]) ||
-      !isMultipleOf(rhsShape[0], (*coopMatmulSize)[2]))
-    return failure();
+    int64_t subgroupSize =
+        resourceLimits.subgroup_size().getValue().getSExtValue();
+    std::array<int64_t, 3> workgroupSize = {subgroupSize, 1, 1};
+    return setOpConfigAndEntryPointFnTranslation(
+        entryPoint, op, tileSizes, /*nativeVectorSize=*/ArrayRef<int64_t>{},
+        IREE::HAL::DispatchLoweringPassPipeline::SPIRVVectorize,
+        workgroupSize);
+  }
+  return failure();
+}
 
-  // For now this is being hard-wired to be {4, 4, 2}. This can actually be set
-  // to whatever, but ultimately depends on register pressure.
-  const int64_t numVecMatmulPerSubgroupX = 4;
-  const int64_t numVecMatmulPerSubgroupY = 4;
-  const int64_t numVecMatmulPerSubgroupK = 2;
-  SmallVector<int64_t, 4> ts = {
-      numVecMatmulPerSubgroupY * (*coopMatmulSize)[0],
-      numVecMatmulPerSubgroupX * (*coopMatmulSize)[1],
-      numVecMatmulPerSubgroupK * (*coopMatmulSize)[2]};
-  TileSizesListType tileSizes;
-  tileSizes.emplace_back(std::move(ts));
+/// Launch config for `linalg.batchmatmul`.
+static LogicalResult setRootConfig(FuncOp entryPoint,
+                                   const spirv::TargetEnv &targetEnv,
+                                   linalg::BatchMatmulOp op) {
+  if (succeeded(setConfigForCooperativeMatmul(
+          entryPoint, targetEnv, cast<linalg::LinalgOp>(op.getOperation())))) {
+    return success();
+  }
+  if (succeeded(setTargetSpecificConfig(entryPoint, targetEnv, op))) {
+    return success();
+  }
+  unsigned maxWorkgroupSize = targetEnv.getResourceLimits()
+                                  .max_compute_workgroup_invocations()
+                                  .getInt();
+  std::array<int64_t, 3> workgroupSize = {1, 1, 1};
+  std::tie(workgroupSize[0], workgroupSize[1]) =
+      distributeProcs2D(maxWorkgroupSize);
+  // This is just being hard-wired for now to be minimal viable, but this can be
+  // decided better when we have better estimates of device charecteristics.
+  const int64_t nRowsPerWorkitem = 1;
+  const int64_t nColsPerWorkitem = 1;
+  const int64_t nBatchesPerWorkitem = 1;
+  int64_t tileSizeK = 0;
+  SmallVector<int64_t, 4> workgroupLevel = {
+      nBatchesPerWorkitem, nRowsPerWorkitem * workgroupSize[1],
+      nColsPerWorkitem * workgroupSize[0], tileSizeK};
+  SmallVector<int64_t, 4> invocationLevel = {
+      nBatchesPerWorkitem, nRowsPerWorkitem, nColsPerWorkitem, 0};
 
-  int64_t subgroupSize =
-      resourceLimits.subgroup_size().getValue().getSExtValue();
-  std::array<int64_t, 3> workgroupSize = {subgroupSize, 1, 1};
-  SmallVector<int64_t, 4> subgroupTs = {
-      numVecMatmulPerSubgroupY * (*coopMatmulSize)[0],
-      numVecMatmulPerSubgroupX * (*coopMatmulSize)[1]};
-  tileSizes.emplace_back(std::move(subgroupTs));
+  TileSizesListType tileSizes;
+  tileSizes.emplace_back(std::move(workgroupLevel));
+  tileSizes.emplace_back();  // subgroup level
+  tileSizes.emplace_back(std::move(invocationLevel));
   return setOpConfigAndEntryPointFnTranslation(
       entryPoint, op, tileSizes, /*nativeVectorSize=*/ArrayRef<int64_t>{},
-      IREE::HAL::DispatchLoweringPassPipeline::SPIRVVectorize, workgroupSize);
+      IREE::HAL::DispatchLoweringPassPipeline::SPIRVDistribute, workgroupSize);
 }
 
 /// Launch config for element-wise linalg.generic.
@@ -364,8 +536,6 @@ LogicalResult setDefaultRootConfig(FuncOp entryPoint,
 static LogicalResult setTargetSpecificConfig(FuncOp entryPoint,
                                              const spirv::TargetEnv &targetEnv,
                                              linalg::MatmulOp op) {
-  if (targetEnv.getVendorID() != spirv::Vendor::ARM) return failure();
-
   ArrayRef<int64_t> lhsShape = getUntiledShape(op.inputs()[0]);
   ArrayRef<int64_t> rhsShape = getUntiledShape(op.inputs()[1]);
   // If the shape size is unknonw fall back to none vectorized path.
@@ -377,13 +547,15 @@ static LogicalResult setTargetSpecificConfig(FuncOp entryPoint,
   // Pick ideal tile size based on the type.
   SmallVector<TileWorkgroupSizePair, 4> workgroupLevelTs;
   int64_t dstSize = lhsShape[0] * rhsShape[1];
-  getMaliBestMatMulTileSizes(
-      op.inputs()[0].getType().cast<ShapedType>().getElementType(),
-      workgroupLevelTs, dstSize);
+  Type elementType =
+      op.inputs()[0].getType().cast<ShapedType>().getElementType();
+  getTargetBestMatMulTileSizes(targetEnv, elementType, workgroupLevelTs,
+                               dstSize);
   for (TileWorkgroupSizePair pair : workgroupLevelTs) {
     if (lhsShape[0] % pair.tileSize[0] != 0 ||
         rhsShape[1] % pair.tileSize[1] != 0 ||
-        lhsShape[1] % pair.tileSize[2] != 0) {
+        lhsShape[1] % pair.tileSize[2] != 0 ||
+        !fitsTargetResources(targetEnv, pair, elementType)) {
       continue;
     }
 
@@ -410,7 +582,8 @@ static LogicalResult setTargetSpecificConfig(FuncOp entryPoint,
 LogicalResult setRootConfig(FuncOp entryPoint,
                             const spirv::TargetEnv &targetEnv,
                             linalg::MatmulOp op) {
-  if (succeeded(setConfigForCooperativeMatmul(entryPoint, targetEnv, op))) {
+  if (succeeded(setConfigForCooperativeMatmul(
+          entryPoint, targetEnv, cast<linalg::LinalgOp>(op.getOperation())))) {
     return success();
   }
   if (succeeded(setTargetSpecificConfig(entryPoint, targetEnv, op))) {
@@ -628,6 +801,67 @@ static LogicalResult setRootConfig(
   return setDefaultRootConfig(entryPoint, targetEnv, op);
 }
 
+/// Sets the configuration distributing the innermost reduction dimension of
+/// `op` over the invocations of the workgroup when the target supports
+/// subgroup arithmetic. Each workgroup handles a single element of the output.
+static LogicalResult setSubgroupReductionConfig(
+    FuncOp entryPoint, const spirv::TargetEnv &targetEnv, Operation *op) {
+  auto linalgOp = dyn_cast<linalg::LinalgOp>(op);
+  if (!linalgOp || !getWorkgroupReductionCombiner(linalgOp)) return failure();
+  if (!targetEnv.allows(spirv::Capability::GroupNonUniformArithmetic)) {
+    return failure();
+  }
+  Type elementType = linalgOp.getOutputOperand(0)
+                         ->get()
+                         .getType()
+                         .cast<ShapedType>()
+                         .getElementType();
+  if (!elementType.isF32() && !elementType.isInteger(32)) return failure();
+
+  // Use as many subgroups as there are invocations in a subgroup so that the
+  // subgroup results can be reduced by a single subgroup, but not more than
+  // the reduction has elements.
+  int64_t subgroupSize =
+      targetEnv.getResourceLimits().subgroup_size().getValue().getSExtValue();
+  int64_t maxWorkgroupSize = targetEnv.getResourceLimits()
+                                 .max_compute_workgroup_invocations()
+                                 .getValue()
+                                 .getSExtValue();
+  int64_t workgroupSizeX =
+      std::min<int64_t>({subgroupSize * subgroupSize, 256,
+                         maxWorkgroupSize / subgroupSize * subgroupSize});
+  unsigned reductionLoop = linalgOp.getNumLoops() - 1;
+  for (OpOperand *input : linalgOp.getInputOperands()) {
+    AffineMap map = linalgOp.getTiedIndexingMap(input);
+    ArrayRef<int64_t> shape = getUntiledShape(input->get());
+    for (auto result : llvm::enumerate(map.getResults())) {
+      auto dimExpr = result.value().dyn_cast<AffineDimExpr>();
+      if (!dimExpr || dimExpr.getPosition() != reductionLoop ||
+          result.index() >= shape.size() ||
+          ShapedType::isDynamic(shape[result.index()])) {
+        continue;
+      }
+      int64_t reductionSize = shape[result.index()];
+      // Small reductions are better handled by a single invocation.
+      if (reductionSize < subgroupSize) return failure();
+      workgroupSizeX = std::min<int64_t>(
+          workgroupSizeX, llvm::alignTo(reductionSize, subgroupSize));
+    }
+  }
+  if (workgroupSizeX < subgroupSize) return failure();
+
+  SmallVector<int64_t, 4> workgroupTileSizes(linalgOp.getNumLoops(), 0);
+  for (unsigned loop : getPartitionedLoops(op)) workgroupTileSizes[loop] = 1;
+  TileSizesListType tileSizes;
+  tileSizes.emplace_back(std::move(workgroupTileSizes));  // Workgroup level
+  tileSizes.emplace_back();                               // Subgroup level
+  tileSizes.emplace_back();                               // Invocation level
+  return setOpConfigAndEntryPointFnTranslation(
+      entryPoint, op, tileSizes, /*nativeVectorSize=*/ArrayRef<int64_t>{},
+      IREE::HAL::DispatchLoweringPassPipeline::SPIRVSubgroupReduction,
+      {workgroupSizeX, 1, 1});
+}
+
 /// Helper function to generate the number of workgroups when the
 /// `SPIRVDistributeToGlobalID` is used.
 // TODO(ravishankarm): Remove this when that pipeline is deprecated.
@@ -726,7 +960,8 @@ LogicalResult initSPIRVLaunchConfig(ModuleOp module) {
     if (!rootOperation) {
       for (Operation *computeOp : computeOps) {
         if (isa<linalg::FillOp, linalg::CopyOp>(computeOp)) continue;
-        if (failed(setDefaultRootConfig(funcOp, targetEnv, computeOp))) {
+        if (failed(setSubgroupReductionConfig(funcOp, targetEnv, computeOp)) &&
+            failed(setDefaultRootConfig(funcOp, targetEnv, computeOp))) {
           return failure();
         }
         if (getLoweringConfig(computeOp)) {
@@ -849,6 +1084,32 @@ getOpNativeVectorSize<vector::TransferWriteOp>(vector::TransferWriteOp op) {
   return nativeSize;
 }
 
+/// Returns the cooperative matrix size to unroll the elementwise `op` with
+/// 2-D result type `vecType` to if it is part of a function using cooperative
+/// matrix matmuls.
+static Optional<SmallVector<int64_t, 4>> getCooperativeMatrixElementwiseSize(
+    Operation *op, VectorType vecType) {
+  if (vecType.getRank() != 2) return llvm::None;
+  auto targetEnv = spirv::TargetEnv(spirv::lookupTargetEnv(op));
+  if (!targetEnv.allows(spirv::Capability::CooperativeMatrixNV) ||
+      !targetEnv.allows(spirv::Extension::SPV_NV_cooperative_matrix))
+    return llvm::None;
+  Optional<SmallVector<int64_t, 4>> size = getCooperativeMatrixAccumulatorSize(
+      targetEnv.getResourceLimits(), vecType.getElementType());
+  if (!size || vecType.getDimSize(0) % (*size)[0] != 0 ||
+      vecType.getDimSize(1) % (*size)[1] != 0) {
+    return llvm::None;
+  }
+  auto funcOp = op->getParentOfType<FuncOp>();
+  bool hasContract = funcOp && funcOp
+                                   .walk([](vector::ContractionOp) {
+                                     return WalkResult::interrupt();
+                                   })
+                                   .wasInterrupted();
+  if (!hasContract) return llvm::None;
+  return size;
+}
+
 Optional<SmallVector<int64_t, 4>> getSPIRVNativeVectorSize(Operation *op) {
 #define DISPATCH(opname)                            \
   if (isa<opname>(op)) {                            \
@@ -864,6 +1125,13 @@ Optional<SmallVector<int64_t, 4>> getSPIRVNativeVectorSize(Operation *op) {
 
   if (OpTrait::hasElementwiseMappableTraits(op) && op->getNumResults() == 1) {
     if (auto vecType = op->getResultTypes()[0].dyn_cast<VectorType>()) {
+      // Elementwise epilogues of matmuls using cooperative matrices are
+      // unrolled to the size of the accumulator matrices so that they can
+      // operate on the cooperative matrix values directly.
+      if (Optional<SmallVector<int64_t, 4>> coopSize =
+              getCooperativeMatrixElementwiseSize(op, vecType)) {
+        return coopSize;
+      }
       // Map elementwise ops to vec4.
       SmallVector<int64_t, 4> nativeSize(vecType.getRank() - 1, 1);
       nativeSize.push_back(4);
@@ -48,6 +48,19 @@
 namespace mlir {
 namespace iree_compiler {
 
+static llvm::cl::opt<SPIRVPrecisionPolicy> clPrecisionPolicy(
+    "iree-spirv-precision-policy",
+    llvm::cl::desc("Policy picking the types used for the arithmetic of the "
+                   "dispatch regions"),
+    llvm::cl::init(SPIRVPrecisionPolicy::Native),
+    llvm::cl::values(
+        clEnumValN(SPIRVPrecisionPolicy::Native, "native",
+                   "Use the element types of the dispatch regions"),
+        clEnumValN(SPIRVPrecisionPolicy::Mixed, "mixed",
+                   "Keep f16 storage but accumulate f16 matmuls and "
+                   "convolutions in f32, and compute in f32 on targets "
+                   "without f16 arithmetic")));
+
 static Value gpuAllocationFunction(OpBuilder &builder, Location loc,
                                    ArrayRef<int64_t> staticShape,
                                    Type elementType,
@@ -114,6 +127,22 @@ void addSPIRVDistributePassPipeline(OpPassManager &pm) {
   pm.addNestedPass<FuncOp>(createOptimizeVectorTransferPass());
 }
 
+void addSPIRVSubgroupReductionPassPipeline(OpPassManager &pm) {
+  //===--------------------------------------------------------------------===//
+  // Initial clean up.
+  //===--------------------------------------------------------------------===//
+  pm.addPass(createCanonicalizerPass());
+  pm.addPass(createCSEPass());
+  // Distribute the reduction dimension onto the invocations within the
+  // workgroup. The other ops of the dispatch only touch the few elements of
+  // the output handled by the workgroup and are executed by every invocation.
+  pm.addNestedPass<FuncOp>(createSPIRVSubgroupReductionPass());
+  pm.addNestedPass<FuncOp>(createConvertLinalgToLoopsPass());
+  pm.addPass(createLowerAffinePass());
+  pm.addPass(createCanonicalizerPass());
+  pm.addPass(createCSEPass());
+}
+
 void addSPIRVDistributeToGlobalIDPipeline(OpPassManager &pm) {
   // Handle ops that cannot go through the previous tiling, distribution, and
   // vectorization flow. Only perform one level of distribution to map them to
@@ -177,6 +206,10 @@ static void addLowerToSPIRVPasses(OpPassManager &pm) {
 void buildSPIRVCodegenPassPipeline(OpPassManager &pm) {
   {
     OpPassManager &nestedModulePM = pm.nest<ModuleOp>();
+    if (clPrecisionPolicy != SPIRVPrecisionPolicy::Native) {
+      nestedModulePM.addNestedPass<FuncOp>(
+          createSPIRVApplyPrecisionPolicyPass(clPrecisionPolicy));
+    }
     addLinalgBufferizePasses(nestedModulePM, gpuAllocationFunction);
   }
   pm.addPass(createSPIRVLowerExecutableTargetPass());
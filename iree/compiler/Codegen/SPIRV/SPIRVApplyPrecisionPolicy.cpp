@@ -0,0 +1,309 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+//===- SPIRVApplyPrecisionPolicy.cpp --------------------------------------===//
+//
+// Picks the types used for the arithmetic of the Linalg ops of a dispatch
+// region based on the precision policy and the capabilities of the target.
+// The element types of the buffers, i.e. the storage types, are left
+// untouched.
+//
+//===----------------------------------------------------------------------===//
+
+#include "iree/compiler/Codegen/PassDetail.h"
+#include "iree/compiler/Codegen/Passes.h"
+#include "llvm/ADT/APFloat.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/TypeSwitch.h"
+#include "mlir/Dialect/Linalg/IR/LinalgOps.h"
+#include "mlir/Dialect/SPIRV/IR/TargetAndABI.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/Pass/Pass.h"
+
+#define DEBUG_TYPE "iree-spirv-apply-precision-policy"
+
+namespace mlir {
+namespace iree_compiler {
+
+//===----------------------------------------------------------------------===//
+// f32 accumulation of f16 matmuls and convolutions
+//===----------------------------------------------------------------------===//
+
+/// Returns a tensor of the same shape as `tensor` with `elementType` elements.
+/// If `tensor` is produced by a linalg.fill, the fill is recreated with the new
+/// element type, otherwise the values of `tensor` are extended.
+static Value extendTensor(OpBuilder &b, Location loc, Value tensor,
+                          FloatType elementType) {
+  auto tensorType = tensor.getType().cast<RankedTensorType>();
+  SmallVector<Value> dynSizes;
+  for (auto dim : llvm::enumerate(tensorType.getShape())) {
+    if (ShapedType::isDynamic(dim.value())) {
+      dynSizes.push_back(
+          b.createOrFold<tensor::DimOp>(loc, tensor, dim.index()));
+    }
+  }
+  Value init = b.create<linalg::InitTensorOp>(
+      loc, dynSizes, tensorType.getShape(), elementType);
+
+  if (auto fillOp = tensor.getDefiningOp<linalg::FillOp>()) {
+    if (auto cst = fillOp.value().getDefiningOp<ConstantOp>()) {
+      APFloat value = cst.getValue().cast<FloatAttr>().getValue();
+      bool losesInfo;
+      value.convert(elementType.getFloatSemantics(),
+                    APFloat::rmNearestTiesToEven, &losesInfo);
+      Value newValue = b.create<ConstantOp>(
+          loc, elementType, b.getFloatAttr(elementType, value));
+      return b.create<linalg::FillOp>(loc, newValue, init).getResult(0);
+    }
+  }
+
+  unsigned rank = tensorType.getRank();
+  SmallVector<AffineMap> maps(2, b.getMultiDimIdentityMap(rank));
+  SmallVector<StringRef> iteratorTypes(rank, getParallelIteratorTypeName());
+  return b
+      .create<linalg::GenericOp>(
+          loc, TypeRange{init.getType()}, ValueRange{tensor}, ValueRange{init},
+          maps, iteratorTypes,
+          [&](OpBuilder &nestedBuilder, Location nestedLoc, ValueRange args) {
+            Value ext =
+                nestedBuilder.create<FPExtOp>(nestedLoc, args[0], elementType);
+            nestedBuilder.create<linalg::YieldOp>(nestedLoc, ext);
+          })
+      .getResult(0);
+}
+
+/// Truncates the values of `tensor` into the tensor `dest`.
+static Value truncateTensor(OpBuilder &b, Location loc, Value tensor,
+                            Value dest) {
+  auto destType = dest.getType().cast<RankedTensorType>();
+  unsigned rank = destType.getRank();
+  SmallVector<AffineMap> maps(2, b.getMultiDimIdentityMap(rank));
+  SmallVector<StringRef> iteratorTypes(rank, getParallelIteratorTypeName());
+  return b
+      .create<linalg::GenericOp>(
+          loc, TypeRange{destType}, ValueRange{tensor}, ValueRange{dest}, maps,
+          iteratorTypes,
+          [&](OpBuilder &nestedBuilder, Location nestedLoc, ValueRange args) {
+            Value trunc = nestedBuilder.create<FPTruncOp>(
+                nestedLoc, args[0], destType.getElementType());
+            nestedBuilder.create<linalg::YieldOp>(nestedLoc, trunc);
+          })
+      .getResult(0);
+}
+
+/// Rewrites the named contraction or convolution `op` with f16 operands on
+/// tensors to accumulate in f32. The named ops cast their inputs to the
+/// output element type, so only the output needs to be converted.
+template <typename OpTy>
+static void accumulateInF32(OpTy op) {
+  if (!op.hasTensorSemantics() || op.getNumOutputs() != 1) return;
+  auto isF16 = [](Value v) {
+    return v.getType().cast<ShapedType>().getElementType().isF16();
+  };
+  if (!llvm::all_of(op.inputs(), isF16) || !isF16(op.outputs()[0])) return;
+
+  OpBuilder b(op);
+  Location loc = op.getLoc();
+  Value init = op.outputs()[0];
+  Value wideInit = extendTensor(b, loc, init, b.getF32Type());
+  // The builder of the named op recreates the operand segment sizes.
+  SmallVector<NamedAttribute> attrs;
+  for (NamedAttribute attr : op->getAttrs()) {
+    if (attr.first != "operand_segment_sizes") attrs.push_back(attr);
+  }
+  auto wideOp = b.create<OpTy>(loc, TypeRange{wideInit.getType()},
+                               op.inputs(), ValueRange{wideInit}, attrs);
+  // Write the truncated result into the destination of the original fill
+  // rather than filling it for nothing.
+  Value dest = init;
+  if (wideInit.getDefiningOp<linalg::FillOp>()) {
+    if (auto fillOp = init.getDefiningOp<linalg::FillOp>()) {
+      dest = fillOp.output();
+    }
+  }
+  Value result = truncateTensor(b, loc, wideOp->getResult(0), dest);
+  op->getResult(0).replaceAllUsesWith(result);
+  op->erase();
+  if (Operation *initOp = init.getDefiningOp()) {
+    if (isa<linalg::FillOp>(initOp) && initOp->use_empty()) initOp->erase();
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// f32 arithmetic for f16 elementwise ops
+//===----------------------------------------------------------------------===//
+
+/// Returns true if the body of `op` only contains scalar ops whose f16 values
+/// can be replaced by f32 ones.
+static bool canComputeInF32(linalg::GenericOp op) {
+  Block &body = op.region().front();
+  bool hasF16Arithmetic = false;
+  for (Operation &bodyOp : body) {
+    if (isa<linalg::YieldOp, FPExtOp, FPTruncOp>(bodyOp)) continue;
+    // The bit pattern of the values would change.
+    if (isa<BitcastOp>(bodyOp)) return false;
+    if (auto cst = dyn_cast<ConstantOp>(bodyOp)) {
+      if (cst.getType().isa<ShapedType>()) return false;
+      continue;
+    }
+    if (bodyOp.getNumRegions() != 0 ||
+        !OpTrait::hasElementwiseMappableTraits(&bodyOp)) {
+      return false;
+    }
+    for (Value operand : bodyOp.getOperands()) {
+      if (operand.getType().isF16() && operand.getParentBlock() != &body) {
+        return false;
+      }
+    }
+    hasF16Arithmetic |= llvm::any_of(
+        bodyOp.getResultTypes(), [](Type type) { return type.isF16(); });
+  }
+  return hasF16Arithmetic;
+}
+
+/// Rewrites the body of `op` to perform its f16 arithmetic in f32. The f16
+/// operands are extended once loaded and the results are truncated before
+/// being yielded.
+static void computeInF32(linalg::GenericOp op) {
+  Block &body = op.region().front();
+  OpBuilder b = OpBuilder::atBlockBegin(&body);
+  Type f32Type = b.getF32Type();
+  Location loc = op.getLoc();
+
+  for (BlockArgument arg : body.getArguments()) {
+    if (!arg.getType().isF16() || arg.use_empty()) continue;
+    Value ext = b.create<FPExtOp>(loc, arg, f32Type);
+    arg.replaceAllUsesExcept(ext, ext.getDefiningOp());
+  }
+
+  for (Operation &bodyOp : llvm::make_early_inc_range(body)) {
+    if (isa<linalg::YieldOp>(bodyOp)) continue;
+    // Conversions from and to f16 within the body become no-ops.
+    if (auto extOp = dyn_cast<FPExtOp>(bodyOp)) {
+      if (extOp.in().getType() == extOp.getType()) {
+        extOp.replaceAllUsesWith(extOp.in());
+        extOp.erase();
+      }
+      continue;
+    }
+    if (auto truncOp = dyn_cast<FPTruncOp>(bodyOp)) {
+      if (!truncOp.getType().isF16()) continue;
+      if (truncOp.in().getType().isF32()) {
+        truncOp.replaceAllUsesWith(truncOp.in());
+        truncOp.erase();
+      } else {
+        truncOp.getResult().setType(f32Type);
+      }
+      continue;
+    }
+    if (auto cst = dyn_cast<ConstantOp>(bodyOp)) {
+      if (!cst.getType().isF16()) continue;
+      APFloat value = cst.getValue().cast<FloatAttr>().getValue();
+      bool losesInfo;
+      value.convert(APFloat::IEEEsingle(), APFloat::rmNearestTiesToEven,
+                    &losesInfo);
+      b.setInsertionPoint(cst);
+      Value newCst = b.create<ConstantOp>(
+          loc, f32Type, b.getF32FloatAttr(value.convertToFloat()));
+      cst.replaceAllUsesWith(newCst);
+      cst.erase();
+      continue;
+    }
+    for (OpResult result : bodyOp.getResults()) {
+      if (result.getType().isF16()) result.setType(f32Type);
+    }
+  }
+
+  auto yieldOp = cast<linalg::YieldOp>(body.getTerminator());
+  b.setInsertionPoint(yieldOp);
+  for (OpOperand &operand : yieldOp->getOpOperands()) {
+    Type outputType = op.getOutputOperand(operand.getOperandNumber())
+                          ->get()
+                          .getType()
+                          .cast<ShapedType>()
+                          .getElementType();
+    if (outputType.isF16() && operand.get().getType().isF32()) {
+      operand.set(b.create<FPTruncOp>(loc, operand.get(), outputType));
+    }
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Pass
+//===----------------------------------------------------------------------===//
+
+namespace {
+class SPIRVApplyPrecisionPolicyPass
+    : public SPIRVApplyPrecisionPolicyBase<SPIRVApplyPrecisionPolicyPass> {
+ public:
+  SPIRVApplyPrecisionPolicyPass(SPIRVPrecisionPolicy policy) {
+    this->policy = policy;
+  }
+  SPIRVApplyPrecisionPolicyPass(const SPIRVApplyPrecisionPolicyPass &pass) {
+    policy = pass.policy;
+  }
+
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<linalg::LinalgDialect, tensor::TensorDialect>();
+  }
+
+  void runOnOperation() override {
+    if (policy == SPIRVPrecisionPolicy::Native) return;
+    FuncOp funcOp = getOperation();
+    auto targetEnvAttr = spirv::lookupTargetEnv(funcOp);
+    if (!targetEnvAttr) return;
+    spirv::TargetEnv targetEnv(targetEnvAttr);
+
+    // Accumulating many f16 products in f16 loses too much precision. Keep
+    // the operands in f16 to save bandwidth, but accumulate in f32.
+    SmallVector<Operation *> accumulatingOps;
+    funcOp.walk([&](Operation *op) {
+      if (isa<linalg::MatmulOp, linalg::BatchMatmulOp,
+              linalg::ConvInputNHWCFilterHWCFOp,
+              linalg::DepthwiseConvInputNHWCFilterHWCOp>(op)) {
+        accumulatingOps.push_back(op);
+      }
+    });
+    for (Operation *op : accumulatingOps) {
+      TypeSwitch<Operation *>(op)
+          .Case<linalg::MatmulOp, linalg::BatchMatmulOp,
+                linalg::ConvInputNHWCFilterHWCFOp,
+                linalg::DepthwiseConvInputNHWCFilterHWCOp>(
+              [](auto namedOp) { accumulateInF32(namedOp); });
+    }
+
+    // Targets that only support 16-bit storage need the arithmetic to happen
+    // in f32.
+    if (!targetEnv.allows(spirv::Capability::Float16)) {
+      funcOp.walk([&](linalg::GenericOp op) {
+        if (canComputeInF32(op)) computeInF32(op);
+      });
+    }
+  }
+
+ private:
+  Option<SPIRVPrecisionPolicy> policy{
+      *this, "policy", llvm::cl::desc("Precision policy to apply"),
+      llvm::cl::init(SPIRVPrecisionPolicy::Mixed),
+      llvm::cl::values(
+          clEnumValN(SPIRVPrecisionPolicy::Native, "native",
+                     "Keep the element types of the dispatch region"),
+          clEnumValN(SPIRVPrecisionPolicy::Mixed, "mixed",
+                     "Accumulate f16 in f32 and compute in f32 on targets "
+                     "without f16 arithmetic"))};
+};
+}  // namespace
+
+std::unique_ptr<OperationPass<FuncOp>> createSPIRVApplyPrecisionPolicyPass(
+    SPIRVPrecisionPolicy policy) {
+  return std::make_unique<SPIRVApplyPrecisionPolicyPass>(policy);
+}
+
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -107,6 +107,9 @@ void SPIRVLowerExecutableTargetPass::runOnOperation() {
       case IREE::HAL::DispatchLoweringPassPipeline::SPIRVVectorize:
         addSPIRVVectorizationPassPipeline(nestedModulePM);
         break;
+      case IREE::HAL::DispatchLoweringPassPipeline::SPIRVSubgroupReduction:
+        addSPIRVSubgroupReductionPassPipeline(nestedModulePM);
+        break;
       default:
         llvm_unreachable("Unsupported pipeline on GPU target.");
     }
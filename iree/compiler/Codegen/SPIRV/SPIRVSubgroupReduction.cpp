@@ -0,0 +1,106 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+//===- SPIRVSubgroupReduction.cpp -----------------------------------------===//
+//
+// Distributes the innermost reduction dimension of linalg ops over the
+// invocations of the workgroup, reducing within subgroups with SPIR-V
+// non-uniform group operations.
+//
+//===----------------------------------------------------------------------===//
+
+#include "iree/compiler/Codegen/PassDetail.h"
+#include "iree/compiler/Codegen/Passes.h"
+#include "iree/compiler/Codegen/SPIRV/MemorySpace.h"
+#include "iree/compiler/Codegen/Transforms/Transforms.h"
+#include "iree/compiler/Codegen/Utils/Utils.h"
+#include "llvm/ADT/TypeSwitch.h"
+#include "mlir/Dialect/Affine/IR/AffineOps.h"
+#include "mlir/Dialect/GPU/GPUDialect.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/SCF/SCF.h"
+#include "mlir/Dialect/SPIRV/IR/SPIRVOps.h"
+#include "mlir/Dialect/SPIRV/IR/TargetAndABI.h"
+#include "mlir/Pass/Pass.h"
+
+namespace mlir {
+namespace iree_compiler {
+
+/// Reduces `value` across the subgroup with the non-uniform group operation
+/// corresponding to `combiner`.
+static Value subgroupReduce(OpBuilder &b, Location loc, Value value,
+                            Operation *combiner) {
+  auto createGroupOp = [&](auto opTy) -> Value {
+    using OpTy = decltype(opTy);
+    return b.create<OpTy>(loc, value.getType(), spirv::Scope::Subgroup,
+                          spirv::GroupOperation::Reduce, value,
+                          /*cluster_size=*/Value());
+  };
+  return TypeSwitch<Operation *, Value>(combiner)
+      .Case<AddFOp>(
+          [&](auto) { return createGroupOp(spirv::GroupNonUniformFAddOp()); })
+      .Case<AddIOp>(
+          [&](auto) { return createGroupOp(spirv::GroupNonUniformIAddOp()); })
+      .Case<MulFOp>(
+          [&](auto) { return createGroupOp(spirv::GroupNonUniformFMulOp()); })
+      .Case<MulIOp>(
+          [&](auto) { return createGroupOp(spirv::GroupNonUniformIMulOp()); })
+      .Case<MaxFOp>(
+          [&](auto) { return createGroupOp(spirv::GroupNonUniformFMaxOp()); })
+      .Case<MinFOp>(
+          [&](auto) { return createGroupOp(spirv::GroupNonUniformFMinOp()); })
+      .Case<MaxSIOp>(
+          [&](auto) { return createGroupOp(spirv::GroupNonUniformSMaxOp()); })
+      .Case<MinSIOp>(
+          [&](auto) { return createGroupOp(spirv::GroupNonUniformSMinOp()); })
+      .Case<MaxUIOp>(
+          [&](auto) { return createGroupOp(spirv::GroupNonUniformUMaxOp()); })
+      .Case<MinUIOp>(
+          [&](auto) { return createGroupOp(spirv::GroupNonUniformUMinOp()); });
+}
+
+namespace {
+class SPIRVSubgroupReductionPass
+    : public SPIRVSubgroupReductionBase<SPIRVSubgroupReductionPass> {
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<AffineDialect, gpu::GPUDialect, memref::MemRefDialect,
+                    scf::SCFDialect, spirv::SPIRVDialect>();
+  }
+  void runOnOperation() override {
+    FuncOp funcOp = getOperation();
+    auto entryPointOp = getEntryPoint(funcOp);
+    if (!entryPointOp) return;
+    SmallVector<int64_t> workgroupSize = getWorkgroupSize(entryPointOp);
+    spirv::TargetEnv targetEnv(spirv::lookupTargetEnv(funcOp));
+
+    SmallVector<linalg::GenericOp> reductionOps;
+    funcOp.walk([&](linalg::GenericOp op) {
+      if (getWorkgroupReductionCombiner(op)) reductionOps.push_back(op);
+    });
+
+    WorkgroupReductionOptions options;
+    options.workgroupSize = workgroupSize[0];
+    options.subgroupSize =
+        targetEnv.getResourceLimits().subgroup_size().getValue().getSExtValue();
+    options.workgroupMemorySpace = getWorkgroupMemorySpace();
+    options.subgroupReduceFn = subgroupReduce;
+    OpBuilder builder(funcOp.getContext());
+    for (linalg::GenericOp op : reductionOps) {
+      if (failed(lowerToWorkgroupReduction(builder, op, options))) {
+        op.emitOpError("failed to distribute the reduction over subgroups");
+        return signalPassFailure();
+      }
+    }
+  }
+};
+}  // namespace
+
+std::unique_ptr<OperationPass<FuncOp>> createSPIRVSubgroupReductionPass() {
+  return std::make_unique<SPIRVSubgroupReductionPass>();
+}
+
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -179,10 +179,12 @@ static SmallVector<linalg::ProcInfo, 2> getSubgroupIdsAndCounts(
 }
 
 namespace {
-/// Pattern to tile linalg.matmul for subgroups.
+/// Pattern to tile linalg.matmul, linalg.batch_matmul and their fused
+/// elementwise epilogues for subgroups.
+template <typename LinalgOpTy>
 struct TileMatmulSubgroupPattern
-    : public linalg::LinalgTilingPattern<linalg::MatmulOp> {
-  using Base = linalg::LinalgTilingPattern<linalg::MatmulOp>;
+    : public linalg::LinalgTilingPattern<LinalgOpTy> {
+  using Base = linalg::LinalgTilingPattern<LinalgOpTy>;
   TileMatmulSubgroupPattern(MLIRContext *context,
                             linalg::LinalgTilingOptions options,
                             linalg::LinalgTransformationFilter marker,
@@ -206,7 +208,7 @@ static void populateTilingToSubgroupPatterns(MLIRContext *context,
   auto getSubgroupProcInfoFn = [&](OpBuilder &builder, Location loc,
                                    ArrayRef<Range> parallelLoopRanges) {
     // TODO(ravishankarm): For now assume that there is always a single subgroup
-    std::array<int64_t, 3> numSubgroups = {1, 1, 1};
+    SmallVector<int64_t, 3> numSubgroups(parallelLoopRanges.size(), 1);
     return getSubgroupIdsAndCounts(builder, loc, numSubgroups);
   };
 
@@ -214,9 +216,12 @@ static void populateTilingToSubgroupPatterns(MLIRContext *context,
   subgroupDistributionOptions.procInfo = getSubgroupProcInfoFn;
   subgroupDistributionOptions.distributionMethod = {
       {linalg::DistributionMethod::CyclicNumProcsEqNumIters,
+       linalg::DistributionMethod::CyclicNumProcsEqNumIters,
        linalg::DistributionMethod::CyclicNumProcsEqNumIters}};
 
-  patterns.insert<TileMatmulSubgroupPattern>(
+  patterns.insert<TileMatmulSubgroupPattern<linalg::MatmulOp>,
+                  TileMatmulSubgroupPattern<linalg::BatchMatmulOp>,
+                  TileMatmulSubgroupPattern<linalg::GenericOp>>(
       context,
       linalg::LinalgTilingOptions()
           .setLoopType(linalg::LinalgTilingLoopType::ParallelLoops)
@@ -227,6 +232,48 @@ static void populateTilingToSubgroupPatterns(MLIRContext *context,
           getVectorizeMarker(), context));
 }
 
+namespace {
+/// Rewrites a linalg.batch_matmul whose batch dimension is 1 after subgroup
+/// tiling into a linalg.matmul on rank-reduced views, so that it vectorizes
+/// into a 2-D vector.contract that maps to cooperative matrix operations.
+struct UnitBatchMatmulToMatmulPattern
+    : public OpRewritePattern<linalg::BatchMatmulOp> {
+  using OpRewritePattern<linalg::BatchMatmulOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(linalg::BatchMatmulOp op,
+                                PatternRewriter &rewriter) const override {
+    if (!hasMarker(op, getVectorizeMarker()) || !op.hasBufferSemantics()) {
+      return failure();
+    }
+    SmallVector<Value, 3> operands;
+    for (Value operand : op.getOperation()->getOperands()) {
+      auto type = operand.getType().cast<MemRefType>();
+      if (type.getRank() != 3 || type.getDimSize(0) != 1 ||
+          ShapedType::isDynamic(type.getDimSize(1)) ||
+          ShapedType::isDynamic(type.getDimSize(2))) {
+        return failure();
+      }
+      SmallVector<OpFoldResult> offsets(3, rewriter.getIndexAttr(0));
+      SmallVector<OpFoldResult> sizes = {
+          rewriter.getIndexAttr(1), rewriter.getIndexAttr(type.getDimSize(1)),
+          rewriter.getIndexAttr(type.getDimSize(2))};
+      SmallVector<OpFoldResult> strides(3, rewriter.getIndexAttr(1));
+      auto viewType = memref::SubViewOp::inferRankReducedResultType(
+                          2, type, offsets, sizes, strides)
+                          .cast<MemRefType>();
+      operands.push_back(rewriter.create<memref::SubViewOp>(
+          op.getLoc(), viewType, operand, offsets, sizes, strides));
+    }
+    auto matmulOp = rewriter.create<linalg::MatmulOp>(
+        op.getLoc(), ValueRange{operands[0], operands[1]},
+        ValueRange{operands[2]});
+    setMarker(matmulOp, getVectorizeMarker());
+    rewriter.eraseOp(op);
+    return success();
+  }
+};
+}  // namespace
+
 //===----------------------------------------------------------------------===//
 // Patterns and methods for thread tiling.
 //===----------------------------------------------------------------------===//
@@ -574,6 +621,9 @@ void SPIRVTileAndVectorizePass::runOnOperation() {
 
   {
     RewritePatternSet vectorizationPatterns(&getContext());
+    // Rewrite unit batch matmuls before they get vectorized as they are.
+    vectorizationPatterns.add<UnitBatchMatmulToMatmulPattern>(context,
+                                                              /*benefit=*/2);
     populateVectorizationPatterns(context, vectorizationPatterns);
     populateLinalgToVectorVectorizeConvPatterns(context, vectorizationPatterns);
     (void)applyPatternsAndFoldGreedily(funcOp,
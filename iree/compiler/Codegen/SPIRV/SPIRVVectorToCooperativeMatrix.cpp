@@ -29,6 +29,28 @@ namespace iree_compiler {
 
 namespace {
 
+/// Returns true if the target advertises a subgroup scoped cooperative matrix
+/// multiply-add with the given element types and (m, n, k) sizes.
+bool isSupportedByTarget(const spirv::TargetEnv &targetEnv, Type lhsType,
+                         Type rhsType, Type accType,
+                         std::tuple<int, int, int> dim) {
+  for (auto properties :
+       targetEnv.getResourceLimits()
+           .cooperative_matrix_properties_nv()
+           .getAsRange<spirv::CooperativeMatrixPropertiesNVAttr>()) {
+    if (properties.a_type().getValue() == lhsType &&
+        properties.b_type().getValue() == rhsType &&
+        properties.c_type().getValue() == accType &&
+        properties.result_type().getValue() == accType &&
+        properties.scope().getValue() == spirv::Scope::Subgroup &&
+        dim == std::make_tuple(properties.m_size().getValue().getSExtValue(),
+                               properties.n_size().getValue().getSExtValue(),
+                               properties.k_size().getValue().getSExtValue()))
+      return true;
+  }
+  return false;
+}
+
 bool isLegalVectorContract(vector::ContractionOp contract) {
   if (llvm::size(contract.masks()) != 0) return false;
   VectorType lhsType = contract.lhs().getType().cast<VectorType>();
@@ -37,10 +59,17 @@ bool isLegalVectorContract(vector::ContractionOp contract) {
 
   std::tuple<int, int, int> dim(lhsType.getDimSize(0), rhsType.getDimSize(1),
                                 lhsType.getDimSize(1));
-  // Check if the matrix type can be supported as a cooperative matrix.
-  // Currently we have hardcoded checks for what Turing hardware supports.
-  // TODO(thomasraoux): Add device information to be able to query what the
-  // device supports.
+  // Check if the matrix type can be supported as a cooperative matrix, using
+  // the properties reported by the device when they are available.
+  auto targetEnv = spirv::TargetEnv(spirv::lookupTargetEnv(contract));
+  ArrayAttr properties =
+      targetEnv.getResourceLimits().cooperative_matrix_properties_nv();
+  if (properties && !properties.empty())
+    return isSupportedByTarget(targetEnv, lhsType.getElementType(),
+                               rhsType.getElementType(),
+                               accType.getElementType(), dim);
+
+  // Otherwise fall back to what Turing hardware supports.
   if (lhsType.getElementType().isInteger(8) &&
       rhsType.getElementType().isInteger(8) &&
       accType.getElementType().isInteger(32) &&
@@ -57,6 +86,35 @@ bool isLegalVectorContract(vector::ContractionOp contract) {
   return false;
 }
 
+/// Returns true if `op` is an elementwise arithmetic operation that SPIR-V
+/// allows on cooperative matrix operands and its result has the shape of a
+/// cooperative matrix accumulator.
+bool isCooperativeMatrixElementwiseOp(Operation *op) {
+  if (!isa<AddFOp, SubFOp, DivFOp, NegFOp, AddIOp, SubIOp, SignedDivIOp,
+           UnsignedDivIOp, FPExtOp, FPTruncOp>(op))
+    return false;
+  auto vecType = op->getResultTypes()[0].dyn_cast<VectorType>();
+  if (!vecType || vecType.getRank() != 2) return false;
+  std::pair<int64_t, int64_t> dim(vecType.getDimSize(0),
+                                  vecType.getDimSize(1));
+  auto targetEnv = spirv::TargetEnv(spirv::lookupTargetEnv(op));
+  ArrayAttr properties =
+      targetEnv.getResourceLimits().cooperative_matrix_properties_nv();
+  if (!properties || properties.empty()) {
+    return dim == std::make_pair<int64_t, int64_t>(8, 8) ||
+           dim == std::make_pair<int64_t, int64_t>(16, 16) ||
+           dim == std::make_pair<int64_t, int64_t>(16, 8);
+  }
+  return llvm::any_of(
+      properties.getAsRange<spirv::CooperativeMatrixPropertiesNVAttr>(),
+      [&](spirv::CooperativeMatrixPropertiesNVAttr property) {
+        return property.c_type().getValue() == vecType.getElementType() &&
+               dim == std::make_pair(
+                          property.m_size().getValue().getSExtValue(),
+                          property.n_size().getValue().getSExtValue());
+      });
+}
+
 bool supportsCooperativeMatrix(Operation *op) {
   if (isa<vector::TransferReadOp, vector::TransferWriteOp, scf::ForOp,
           scf::YieldOp>(op))
@@ -64,9 +122,10 @@ bool supportsCooperativeMatrix(Operation *op) {
   if (isa<vector::ContractionOp>(op) &&
       isLegalVectorContract(cast<vector::ContractionOp>(op)))
     return true;
-  // We only support minimal set of operations right now. We can trivially
-  // extend to ALU instructions supporting Cooperative Matrix in SPIR-V spec.
-  // We also need to extend to control flow operations, Alloca, etc...
+  // Elementwise epilogues fused after the matmul can operate directly on the
+  // cooperative matrix values.
+  if (isCooperativeMatrixElementwiseOp(op)) return true;
+  // We need to extend to control flow operations, Alloca, etc...
   // TODO(thomasraoux): extend support to more complex chain of instructions.
   return false;
 }
@@ -80,8 +139,11 @@ class CooperativeMatrixAnalysis {
       return;
 
     op->walk([&](Operation *op) {
-      auto contract = dyn_cast<vector::ContractionOp>(op);
-      if (contract == nullptr) return;
+      // Start from the contractions and from the elementwise epilogues, which
+      // are reading the matmul result back from memory.
+      if (!isa<vector::ContractionOp>(op) &&
+          !isCooperativeMatrixElementwiseOp(op))
+        return;
       auto hasVectorDest = [](Operation *op) {
         if (isa<ConstantOp, memref::AllocOp>(op)) return false;
         for (auto resultType : op->getResultTypes()) {
@@ -250,6 +312,32 @@ class VectorContractToCoopMatmul final
   const CooperativeMatrixAnalysis &cooperativeMatrixAnalysis;
 };
 
+/// Converts elementwise arithmetic on vectors used as cooperative matrices to
+/// the corresponding SPIR-V op on the cooperative matrix type.
+template <typename SrcOpTy, typename DstOpTy>
+class ElementwiseToCoopMatOp final : public OpConversionPattern<SrcOpTy> {
+ public:
+  ElementwiseToCoopMatOp(
+      MLIRContext *context, SPIRVTypeConverter &converter,
+      const CooperativeMatrixAnalysis &cooperativeMatrixAnalysis)
+      : OpConversionPattern<SrcOpTy>(converter, context),
+        cooperativeMatrixAnalysis(cooperativeMatrixAnalysis) {}
+
+  LogicalResult matchAndRewrite(
+      SrcOpTy op, ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const override {
+    if (!cooperativeMatrixAnalysis.usesCooperativeMatrixType(op))
+      return failure();
+    Type dstType = this->getTypeConverter()->convertType(op.getType());
+    if (!dstType) return failure();
+    rewriter.replaceOpWithNewOp<DstOpTy>(op, dstType, operands);
+    return success();
+  }
+
+ private:
+  const CooperativeMatrixAnalysis &cooperativeMatrixAnalysis;
+};
+
 struct SPIRVVectorToCooperativeMatrixPass final
     : public SPIRVVectorToCooperativeMatrixBase<
           SPIRVVectorToCooperativeMatrixPass> {
@@ -287,7 +375,18 @@ struct SPIRVVectorToCooperativeMatrixPass final
     auto &analysis = getAnalysis<CooperativeMatrixAnalysis>();
     patterns.add<TransferToCoopMatLoadStore<vector::TransferReadOp>,
                  TransferToCoopMatLoadStore<vector::TransferWriteOp>,
-                 VectorContractToCoopMatmul>(context, typeConverter, analysis);
+                 VectorContractToCoopMatmul,
+                 ElementwiseToCoopMatOp<AddFOp, spirv::FAddOp>,
+                 ElementwiseToCoopMatOp<SubFOp, spirv::FSubOp>,
+                 ElementwiseToCoopMatOp<DivFOp, spirv::FDivOp>,
+                 ElementwiseToCoopMatOp<NegFOp, spirv::FNegateOp>,
+                 ElementwiseToCoopMatOp<AddIOp, spirv::IAddOp>,
+                 ElementwiseToCoopMatOp<SubIOp, spirv::ISubOp>,
+                 ElementwiseToCoopMatOp<SignedDivIOp, spirv::SDivOp>,
+                 ElementwiseToCoopMatOp<UnsignedDivIOp, spirv::UDivOp>,
+                 ElementwiseToCoopMatOp<FPExtOp, spirv::FConvertOp>,
+                 ElementwiseToCoopMatOp<FPTruncOp, spirv::FConvertOp>>(
+        context, typeConverter, analysis);
 
     std::unique_ptr<ConversionTarget> target =
         SPIRVConversionTarget::get(targetAttr);
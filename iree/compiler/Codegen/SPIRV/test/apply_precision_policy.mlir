@@ -0,0 +1,76 @@
+// RUN: iree-opt -split-input-file -iree-spirv-apply-precision-policy %s | IreeFileCheck %s
+
+module attributes {spv.target_env = #spv.target_env<#spv.vce<v1.3, [Shader, Float16, StorageBuffer16BitAccess], [SPV_KHR_storage_buffer_storage_class, SPV_KHR_16bit_storage]>, {}>} {
+  func @matmul_f16(%lhs: tensor<16x32xf16>, %rhs: tensor<32x8xf16>) -> tensor<16x8xf16> {
+    %zero = constant 0.0 : f16
+    %init = linalg.init_tensor [16, 8] : tensor<16x8xf16>
+    %fill = linalg.fill(%zero, %init) : f16, tensor<16x8xf16> -> tensor<16x8xf16>
+    %0 = linalg.matmul ins(%lhs, %rhs : tensor<16x32xf16>, tensor<32x8xf16>) outs(%fill : tensor<16x8xf16>) -> tensor<16x8xf16>
+    return %0 : tensor<16x8xf16>
+  }
+}
+
+//   CHECK-LABEL: func @matmul_f16
+//    CHECK-SAME:   %[[LHS:[a-zA-Z0-9]+]]: tensor<16x32xf16>
+//    CHECK-SAME:   %[[RHS:[a-zA-Z0-9]+]]: tensor<32x8xf16>
+//     CHECK-DAG:   %[[INIT:.+]] = linalg.init_tensor [16, 8] : tensor<16x8xf16>
+//     CHECK-DAG:   %[[WIDE_INIT:.+]] = linalg.init_tensor [16, 8] : tensor<16x8xf32>
+//     CHECK-DAG:   %[[ZERO:.+]] = constant 0.000000e+00 : f32
+//         CHECK:   %[[WIDE_FILL:.+]] = linalg.fill(%[[ZERO]], %[[WIDE_INIT]])
+//         CHECK:   %[[MATMUL:.+]] = linalg.matmul
+//    CHECK-SAME:     ins(%[[LHS]], %[[RHS]] : tensor<16x32xf16>, tensor<32x8xf16>)
+//    CHECK-SAME:     outs(%[[WIDE_FILL]] : tensor<16x8xf32>)
+//         CHECK:   %[[RESULT:.+]] = linalg.generic
+//    CHECK-SAME:     ins(%[[MATMUL]] : tensor<16x8xf32>)
+//    CHECK-SAME:     outs(%[[INIT]] : tensor<16x8xf16>)
+//         CHECK:     fptrunc %{{.+}} : f32 to f16
+//         CHECK:   return %[[RESULT]]
+
+// -----
+
+#map = affine_map<(d0) -> (d0)>
+module attributes {spv.target_env = #spv.target_env<#spv.vce<v1.3, [Shader, StorageBuffer16BitAccess], [SPV_KHR_storage_buffer_storage_class, SPV_KHR_16bit_storage]>, {}>} {
+  func @elementwise_f16_storage_only(%arg0: tensor<64xf16>, %arg1: tensor<64xf16>) -> tensor<64xf16> {
+    %init = linalg.init_tensor [64] : tensor<64xf16>
+    %0 = linalg.generic {indexing_maps = [#map, #map, #map], iterator_types = ["parallel"]}
+        ins(%arg0, %arg1 : tensor<64xf16>, tensor<64xf16>) outs(%init : tensor<64xf16>) {
+    ^bb0(%a: f16, %b: f16, %c: f16):
+      %cst = constant 2.0 : f16
+      %1 = addf %a, %b : f16
+      %2 = mulf %1, %cst : f16
+      linalg.yield %2 : f16
+    } -> tensor<64xf16>
+    return %0 : tensor<64xf16>
+  }
+}
+
+// CHECK-LABEL: func @elementwise_f16_storage_only
+//       CHECK:   linalg.generic
+//       CHECK:   ^{{.+}}(%[[A:.+]]: f16, %[[B:.+]]: f16, %{{.+}}: f16):
+//   CHECK-DAG:     %[[A32:.+]] = fpext %[[A]] : f16 to f32
+//   CHECK-DAG:     %[[B32:.+]] = fpext %[[B]] : f16 to f32
+//   CHECK-DAG:     %[[CST:.+]] = constant 2.000000e+00 : f32
+//       CHECK:     %[[ADD:.+]] = addf %[[A32]], %[[B32]] : f32
+//       CHECK:     %[[MUL:.+]] = mulf %[[ADD]], %[[CST]] : f32
+//       CHECK:     %[[TRUNC:.+]] = fptrunc %[[MUL]] : f32 to f16
+//       CHECK:     linalg.yield %[[TRUNC]] : f16
+
+// -----
+
+#map = affine_map<(d0) -> (d0)>
+module attributes {spv.target_env = #spv.target_env<#spv.vce<v1.3, [Shader, Float16, StorageBuffer16BitAccess], [SPV_KHR_storage_buffer_storage_class, SPV_KHR_16bit_storage]>, {}>} {
+  func @elementwise_f16_native(%arg0: tensor<64xf16>, %arg1: tensor<64xf16>) -> tensor<64xf16> {
+    %init = linalg.init_tensor [64] : tensor<64xf16>
+    %0 = linalg.generic {indexing_maps = [#map, #map, #map], iterator_types = ["parallel"]}
+        ins(%arg0, %arg1 : tensor<64xf16>, tensor<64xf16>) outs(%init : tensor<64xf16>) {
+    ^bb0(%a: f16, %b: f16, %c: f16):
+      %1 = addf %a, %b : f16
+      linalg.yield %1 : f16
+    } -> tensor<64xf16>
+    return %0 : tensor<64xf16>
+  }
+}
+
+// CHECK-LABEL: func @elementwise_f16_native
+//   CHECK-NOT:   fpext
+//       CHECK:   addf %{{.+}}, %{{.+}} : f16
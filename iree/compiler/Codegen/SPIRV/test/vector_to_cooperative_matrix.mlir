@@ -95,3 +95,35 @@ module attributes {gpu.container_module, spv.target_env = #spv.target_env<#spv.v
     return
   }
 }
+
+// -----
+
+#map1 = affine_map<(d0, d1, d2) -> (d0, d2)>
+#map2 = affine_map<(d0, d1, d2) -> (d2, d1)>
+#map3 = affine_map<(d0, d1, d2) -> (d0, d1)>
+
+module attributes {gpu.container_module, spv.target_env = #spv.target_env<#spv.vce<v1.0, [Shader, CooperativeMatrixNV, Float16, StorageUniform16, Float16Buffer], [SPV_KHR_storage_buffer_storage_class, SPV_NV_cooperative_matrix, SPV_KHR_16bit_storage]>, {cooperative_matrix_properties_nv = [{a_type = f16, b_type = f16, c_type = f16, k_size = 16 : i32, m_size = 16 : i32, n_size = 16 : i32, result_type = f16, scope = 3 : i32}], max_compute_workgroup_invocations = 128 : i32, max_compute_workgroup_size = dense<[128, 128, 64]> : vector<3xi32>}>} {
+  // CHECK-LABEL: func @kernel_matmul_epilogue
+  func @kernel_matmul_epilogue(%arg0: memref<16x16xf16>, %arg1: memref<16x16xf16>, %arg2: memref<16x16xf16>, %arg3: memref<16x16xf16>, %arg4: memref<16x16xf16>) attributes {spv.entry_point_abi = {local_size = dense<[32, 1, 1]> : vector<3xi32>}} {
+    %c0 = constant 0 : index
+    %cst = constant 0.0 : f16
+    %0 = vector.transfer_read %arg0[%c0, %c0], %cst {in_bounds = [true, true]} : memref<16x16xf16>, vector<16x16xf16>
+    %1 = vector.transfer_read %arg1[%c0, %c0], %cst {in_bounds = [true, true]} : memref<16x16xf16>, vector<16x16xf16>
+    %2 = vector.transfer_read %arg2[%c0, %c0], %cst {in_bounds = [true, true]} : memref<16x16xf16>, vector<16x16xf16>
+    %3 = vector.contract {indexing_maps = [#map1, #map2, #map3], iterator_types = ["parallel", "parallel", "reduction"]} %0, %1, %2 : vector<16x16xf16>, vector<16x16xf16> into vector<16x16xf16>
+    vector.transfer_write %3, %arg2[%c0, %c0] {in_bounds = [true, true]} : vector<16x16xf16>, memref<16x16xf16>
+    // CHECK: spv.CooperativeMatrixMulAddNV
+    // CHECK: spv.CooperativeMatrixStoreNV
+    %4 = vector.transfer_read %arg2[%c0, %c0], %cst {in_bounds = [true, true]} : memref<16x16xf16>, vector<16x16xf16>
+    %5 = vector.transfer_read %arg3[%c0, %c0], %cst {in_bounds = [true, true]} : memref<16x16xf16>, vector<16x16xf16>
+    %6 = addf %4, %5 : vector<16x16xf16>
+    %7 = negf %6 : vector<16x16xf16>
+    vector.transfer_write %7, %arg4[%c0, %c0] {in_bounds = [true, true]} : vector<16x16xf16>, memref<16x16xf16>
+    // CHECK: %[[C:.+]] = spv.CooperativeMatrixLoadNV
+    // CHECK: %[[BIAS:.+]] = spv.CooperativeMatrixLoadNV
+    // CHECK: %[[ADD:.+]] = spv.FAdd %[[C]], %[[BIAS]] : !spv.coopmatrix<16x16xf16, Subgroup>
+    // CHECK: %[[NEG:.+]] = spv.FNegate %[[ADD]] : !spv.coopmatrix<16x16xf16, Subgroup>
+    // CHECK: spv.CooperativeMatrixStoreNV %{{.*}}, %[[NEG]], %{{.*}}, %{{.*}}
+    return
+  }
+}
@@ -75,6 +75,46 @@ using GetMinMaxExprFn =
 void populateRemoveSingleIterationLoopPattern(RewritePatternSet &patterns,
                                               GetMinMaxExprFn getMinMaxFn);
 
+/// Returns the operation combining the values reduced by `op` if it is a
+/// linalg.generic op that `lowerToWorkgroupReduction` can handle, i.e. it has
+/// a single output, its innermost loop is its only reduction loop and the body
+/// folds a value into the output with a known commutative operation (add, mul,
+/// min or max). Returns nullptr otherwise.
+Operation *getWorkgroupReductionCombiner(linalg::LinalgOp op);
+
+/// Creates a clone of the `combiner` operation combining `lhs` and `rhs`.
+Value createCombinerOp(OpBuilder &b, Location loc, Operation *combiner,
+                       Value lhs, Value rhs);
+
+/// Callback reducing `value` across all the invocations of a subgroup with the
+/// operation `combiner`. The result must be available to all the invocations.
+using SubgroupReduceFn = std::function<Value(
+    OpBuilder &b, Location loc, Value value, Operation *combiner)>;
+
+struct WorkgroupReductionOptions {
+  /// Number of threads of the workgroup along x. The workgroup must be one
+  /// dimensional.
+  int64_t workgroupSize = 0;
+  /// Number of threads of a subgroup.
+  int64_t subgroupSize = 0;
+  /// Memory space of the buffer used to combine the subgroup results.
+  unsigned workgroupMemorySpace = 0;
+  SubgroupReduceFn subgroupReduceFn = nullptr;
+};
+
+/// Lowers the linalg.generic reduction `op` on buffers so that all the threads
+/// of the workgroup cooperate on its innermost (reduction) dimension:
+/// - each thread accumulates the elements at a stride of the workgroup size,
+/// - the partial results are reduced within each subgroup with
+///   `options.subgroupReduceFn`,
+/// - the first subgroup reduces the per subgroup results staged in workgroup
+///   memory, and the first thread combines it with the output.
+/// The parallel loops of `op` are iterated over serially. Fails if `op` is not
+/// supported (see `getWorkgroupReductionCombiner`).
+LogicalResult lowerToWorkgroupReduction(
+    OpBuilder &b, linalg::GenericOp op,
+    const WorkgroupReductionOptions &options);
+
 /// Insert pattern to fold chains of `affine.min` operations.
 // TODO: It is not clear what this pattern is doing and should be deprecated.
 void populateAffineMinCanonicalizationPattern(RewritePatternSet &patterns);
@@ -0,0 +1,264 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+//===- WorkgroupReduction.cpp - Cooperative reduction within a workgroup --===//
+//
+// Lowers a linalg.generic reducing its innermost loop to code where all the
+// threads of the workgroup cooperate on the reduction. Each thread accumulates
+// a strided slice of the reduction dimension, the partial results are then
+// reduced within each subgroup and the per subgroup results are combined
+// through workgroup memory.
+//
+//===----------------------------------------------------------------------===//
+
+#include "iree/compiler/Codegen/Transforms/Transforms.h"
+#include "llvm/ADT/TypeSwitch.h"
+#include "mlir/Dialect/Affine/IR/AffineOps.h"
+#include "mlir/Dialect/GPU/GPUDialect.h"
+#include "mlir/Dialect/Linalg/Utils/Utils.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/SCF/SCF.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+
+namespace mlir {
+namespace iree_compiler {
+
+Operation *getWorkgroupReductionCombiner(linalg::LinalgOp op) {
+  auto genericOp = dyn_cast<linalg::GenericOp>(op.getOperation());
+  if (!genericOp || genericOp.getNumOutputs() != 1 ||
+      genericOp.getNumReductionLoops() != 1) {
+    return nullptr;
+  }
+  // Only the innermost loop can be the reduction, the other loops are
+  // iterated over serially by the workgroup.
+  ArrayAttr iteratorTypes = genericOp.iterator_types();
+  if (!isReductionIterator(iteratorTypes[iteratorTypes.size() - 1])) {
+    return nullptr;
+  }
+  OpOperand *output = genericOp.getOutputOperand(0);
+  if (!genericOp.getTiedIndexingMap(output).isProjectedPermutation()) {
+    return nullptr;
+  }
+  Block *body = genericOp.getBody();
+  Value yielded = body->getTerminator()->getOperand(0);
+  Operation *combiner = yielded.getDefiningOp();
+  if (!combiner || combiner->getBlock() != body ||
+      !isa<AddFOp, AddIOp, MulFOp, MulIOp, MaxFOp, MinFOp, MaxSIOp, MinSIOp,
+           MaxUIOp, MinUIOp>(combiner)) {
+    return nullptr;
+  }
+  // The accumulator must only be used by the combiner, so that the rest of
+  // the body can be evaluated independently for each element.
+  BlockArgument acc = body->getArgument(output->getOperandNumber());
+  if (!acc.hasOneUse() || (combiner->getOperand(0) != acc &&
+                           combiner->getOperand(1) != acc)) {
+    return nullptr;
+  }
+  return combiner;
+}
+
+Value createCombinerOp(OpBuilder &b, Location loc, Operation *combiner,
+                       Value lhs, Value rhs) {
+  BlockAndValueMapping mapping;
+  mapping.map(combiner->getOperand(0), lhs);
+  mapping.map(combiner->getOperand(1), rhs);
+  return b.clone(*combiner, mapping)->getResult(0);
+}
+
+/// Returns the neutral element of `combiner` for values of type `type`.
+static Value getCombinerIdentity(OpBuilder &b, Location loc,
+                                 Operation *combiner, Type type) {
+  auto getInf = [&](bool negative) -> Attribute {
+    auto floatType = type.cast<FloatType>();
+    return b.getFloatAttr(
+        type, APFloat::getInf(floatType.getFloatSemantics(), negative));
+  };
+  unsigned bitWidth = type.getIntOrFloatBitWidth();
+  Attribute identity =
+      TypeSwitch<Operation *, Attribute>(combiner)
+          .Case<AddFOp>([&](auto) { return b.getFloatAttr(type, 0.0); })
+          .Case<MulFOp>([&](auto) { return b.getFloatAttr(type, 1.0); })
+          .Case<MaxFOp>([&](auto) { return getInf(/*negative=*/true); })
+          .Case<MinFOp>([&](auto) { return getInf(/*negative=*/false); })
+          .Case<AddIOp, MaxUIOp>(
+              [&](auto) { return b.getIntegerAttr(type, 0); })
+          .Case<MulIOp>([&](auto) { return b.getIntegerAttr(type, 1); })
+          .Case<MaxSIOp>([&](auto) {
+            return b.getIntegerAttr(type, APInt::getSignedMinValue(bitWidth));
+          })
+          .Case<MinSIOp>([&](auto) {
+            return b.getIntegerAttr(type, APInt::getSignedMaxValue(bitWidth));
+          })
+          .Case<MinUIOp>([&](auto) {
+            return b.getIntegerAttr(type, APInt::getMaxValue(bitWidth));
+          });
+  return b.create<ConstantOp>(loc, identity);
+}
+
+/// Clones the body of `op` for the iteration `ivs`, using `acc` as the value
+/// of the output. Returns the value yielded.
+static Value cloneReductionBody(OpBuilder &b, Location loc,
+                                linalg::GenericOp op, ValueRange ivs,
+                                Value acc) {
+  Block *body = op.getBody();
+  BlockAndValueMapping mapping;
+  for (OpOperand *input : op.getInputOperands()) {
+    BlockArgument arg = body->getArgument(input->getOperandNumber());
+    if (op.isScalar(input)) {
+      mapping.map(arg, input->get());
+      continue;
+    }
+    SmallVector<Value> indices = linalg::applyMapToValues(
+        b, loc, op.getTiedIndexingMap(input), ivs);
+    mapping.map(arg, b.create<memref::LoadOp>(loc, input->get(), indices));
+  }
+  mapping.map(body->getArgument(op.getOutputOperand(0)->getOperandNumber()),
+              acc);
+  for (Operation &bodyOp : body->without_terminator()) {
+    if (auto indexOp = dyn_cast<linalg::IndexOp>(bodyOp)) {
+      mapping.map(indexOp.getResult(), ivs[indexOp.dim()]);
+      continue;
+    }
+    b.clone(bodyOp, mapping);
+  }
+  return mapping.lookup(body->getTerminator()->getOperand(0));
+}
+
+LogicalResult lowerToWorkgroupReduction(
+    OpBuilder &b, linalg::GenericOp op,
+    const WorkgroupReductionOptions &options) {
+  Operation *combiner = getWorkgroupReductionCombiner(op);
+  if (!combiner || !op.hasBufferSemantics()) return failure();
+  if (options.workgroupSize % options.subgroupSize != 0) return failure();
+  int64_t numSubgroups = options.workgroupSize / options.subgroupSize;
+  if (numSubgroups > options.subgroupSize) return failure();
+
+  OpBuilder::InsertionGuard guard(b);
+  Location loc = op.getLoc();
+  OpOperand *output = op.getOutputOperand(0);
+  Type elementType =
+      output->get().getType().cast<MemRefType>().getElementType();
+
+  // The workgroup memory holding the per subgroup results is allocated once
+  // at the start of the function.
+  Value scratch;
+  if (numSubgroups > 1) {
+    b.setInsertionPointToStart(
+        &op->getParentOfType<FuncOp>().getBody().front());
+    auto scratchType = MemRefType::get({numSubgroups}, elementType, {},
+                                       options.workgroupMemorySpace);
+    scratch = b.create<memref::AllocOp>(loc, scratchType);
+  }
+
+  b.setInsertionPoint(op);
+  Value zero = b.create<ConstantIndexOp>(loc, 0);
+  Value one = b.create<ConstantIndexOp>(loc, 1);
+  Value workgroupSize = b.create<ConstantIndexOp>(loc, options.workgroupSize);
+  Value threadId = b.create<gpu::ThreadIdOp>(loc, b.getIndexType(),
+                                             b.getStringAttr("x"));
+  Value identity = getCombinerIdentity(b, loc, combiner, elementType);
+
+  SmallVector<Range> loopRanges = op.createLoopRanges(b, loc);
+  Value reductionSize = loopRanges.back().size;
+  SmallVector<Value> lbs, ubs, steps;
+  for (Range range : ArrayRef<Range>(loopRanges).drop_back()) {
+    lbs.push_back(zero);
+    ubs.push_back(range.size);
+    steps.push_back(one);
+  }
+
+  // The parallel loops are iterated over by the whole workgroup, the
+  // reduction loop is distributed cyclically over the threads.
+  scf::buildLoopNest(
+      b, loc, lbs, ubs, steps,
+      [&](OpBuilder &nb, Location nl, ValueRange parallelIvs) {
+        auto partialLoop = nb.create<scf::ForOp>(
+            nl, threadId, reductionSize, workgroupSize, ValueRange{identity},
+            [&](OpBuilder &lb, Location ll, Value iv, ValueRange iterArgs) {
+              SmallVector<Value> ivs(parallelIvs.begin(), parallelIvs.end());
+              ivs.push_back(iv);
+              Value next = cloneReductionBody(lb, ll, op, ivs, iterArgs[0]);
+              lb.create<scf::YieldOp>(ll, next);
+            });
+        Value result =
+            options.subgroupReduceFn(nb, nl, partialLoop.getResult(0),
+                                     combiner);
+
+        if (numSubgroups > 1) {
+          // The first lane of each subgroup publishes the subgroup result,
+          // the first subgroup then reduces them.
+          AffineExpr d0 = nb.getAffineDimExpr(0);
+          Value laneId = nb.create<AffineApplyOp>(
+              nl, AffineMap::get(1, 0, d0 % options.subgroupSize), threadId);
+          Value subgroupId = nb.create<AffineApplyOp>(
+              nl, AffineMap::get(1, 0, d0.floorDiv(options.subgroupSize)),
+              threadId);
+          Value isFirstLane =
+              nb.create<CmpIOp>(nl, CmpIPredicate::eq, laneId, zero);
+          nb.create<scf::IfOp>(
+              nl, isFirstLane, [&](OpBuilder &tb, Location tl) {
+                tb.create<memref::StoreOp>(tl, result, scratch, subgroupId);
+                tb.create<scf::YieldOp>(tl);
+              });
+          nb.create<gpu::BarrierOp>(nl);
+
+          Value isFirstSubgroup =
+              nb.create<CmpIOp>(nl, CmpIPredicate::eq, subgroupId, zero);
+          auto combineOp = nb.create<scf::IfOp>(
+              nl, TypeRange{elementType}, isFirstSubgroup,
+              [&](OpBuilder &tb, Location tl) {
+                Value numSubgroupsVal =
+                    tb.create<ConstantIndexOp>(tl, numSubgroups);
+                Value hasValue = tb.create<CmpIOp>(tl, CmpIPredicate::ult,
+                                                   laneId, numSubgroupsVal);
+                auto loadOp = tb.create<scf::IfOp>(
+                    tl, TypeRange{elementType}, hasValue,
+                    [&](OpBuilder &ib, Location il) {
+                      Value v = ib.create<memref::LoadOp>(il, scratch, laneId);
+                      ib.create<scf::YieldOp>(il, v);
+                    },
+                    [&](OpBuilder &ib, Location il) {
+                      ib.create<scf::YieldOp>(il, identity);
+                    });
+                Value v = options.subgroupReduceFn(tb, tl, loadOp.getResult(0),
+                                                   combiner);
+                tb.create<scf::YieldOp>(tl, v);
+              },
+              [&](OpBuilder &tb, Location tl) {
+                tb.create<scf::YieldOp>(tl, identity);
+              });
+          result = combineOp.getResult(0);
+        } else {
+          // Make sure the initial value of the output is visible to the
+          // thread doing the final update.
+          nb.create<gpu::BarrierOp>(nl);
+        }
+
+        // The first thread combines the result with the initial value.
+        Value isFirstThread =
+            nb.create<CmpIOp>(nl, CmpIPredicate::eq, threadId, zero);
+        nb.create<scf::IfOp>(nl, isFirstThread, [&](OpBuilder &tb,
+                                                    Location tl) {
+          SmallVector<Value> ivs(parallelIvs.begin(), parallelIvs.end());
+          ivs.push_back(zero);
+          SmallVector<Value> indices = linalg::applyMapToValues(
+              tb, tl, op.getTiedIndexingMap(output), ivs);
+          Value init = tb.create<memref::LoadOp>(tl, output->get(), indices);
+          Value updated = createCombinerOp(tb, tl, combiner, init, result);
+          tb.create<memref::StoreOp>(tl, updated, output->get(), indices);
+          tb.create<scf::YieldOp>(tl);
+        });
+        // Publish the result to the consumers and protect the workgroup
+        // memory from being overwritten by the next iteration.
+        nb.create<gpu::BarrierOp>(nl);
+      });
+  op.erase();
+  return success();
+}
+
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -49,6 +49,8 @@ StringRef getConvFilterTileMarker() { return "tile_conv_filter"; }
 
 StringRef getVectorizeMarker() { return "vectorize"; }
 
+StringRef getAsyncCopyMarker() { return "async_copy"; }
+
 StringRef getDeleteMarker() { return "delete"; }
 
 StringRef getMarkerOrNull(Operation *op) {
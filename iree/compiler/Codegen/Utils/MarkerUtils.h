@@ -47,6 +47,10 @@ StringRef getConvFilterTileMarker();
 /// Marker for operations that are going to be vectorized.
 StringRef getVectorizeMarker();
 
+/// Marker for vector.load/vector.store pairs copying from global to shared
+/// memory that are lowered to asynchronous copies on GPU.
+StringRef getAsyncCopyMarker();
+
 /// Marker for tagging an operation for deletion. Tile and fuse pattern does
 /// not delete the original operation to not invalidate the
 /// `linalg::LinalgDependenceGraph` data structure. Instead it is marked with
@@ -771,6 +771,17 @@ static ElementsAttr tensorUpdate(ElementsAttr update, ElementsAttr target,
   return DenseElementsAttr::get(targetType, targetValues);
 }
 
+// Returns true if |value| is tied to storage imported from outside of the
+// program (such as a buffer view provided by the caller). Writes to such values
+// are observable and must not be elided.
+static bool isImportedStorage(Value value) {
+  auto tiedOp =
+      dyn_cast_or_null<IREE::Util::TiedOpInterface>(value.getDefiningOp());
+  if (!tiedOp) return false;
+  auto tiedOperand = tiedOp.getTiedResultOperand(value);
+  return tiedOperand && !tiedOperand.getType().isa<TensorType>();
+}
+
 OpFoldResult TensorUpdateOp::fold(ArrayRef<Attribute> operands) {
   auto targetIndex = getODSOperandIndexAndLength(0).first;
   auto startIndices = getODSOperandIndexAndLength(2);
@@ -782,11 +793,12 @@ OpFoldResult TensorUpdateOp::fold(ArrayRef<Attribute> operands) {
     return tensorUpdate(operands[updateIndex].cast<ElementsAttr>(),
                         operands[targetIndex].cast<ElementsAttr>(), indices);
   } else {
-    // Replace the entire tensor when the sizes match.
+    // Replace the entire tensor when the sizes match unless the update must
+    // land in imported storage.
     auto updateType = update().getType().cast<ShapedType>();
     auto targetType = target().getType().cast<ShapedType>();
     if (updateType.hasStaticShape() && targetType.hasStaticShape() &&
-        updateType == targetType) {
+        updateType == targetType && !isImportedStorage(target())) {
       return update();
     }
   }
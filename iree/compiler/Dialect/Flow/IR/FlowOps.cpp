@@ -961,6 +961,69 @@ IREE::Util::ValueAccess ExStreamFragmentOp::getResultAccess(
              : IREE::Util::ValueAccess::DiscardWrite();
 }
 
+// Returns true if |op| records work when executed in a stream.
+static bool isStreamCommandOp(Operation *op) {
+  return isa<StreamableOpInterface>(op) && !isa<TensorReshapeOp>(op);
+}
+
+DenseMap<Operation *, int> ExStreamFragmentOp::computeExecutionWaves() {
+  auto &block = body().front();
+  DenseMap<Operation *, int> waves;
+
+  // Returns the first wave in which the results of |op| are available.
+  auto getAvailableWave = [&](Operation *op) {
+    auto it = waves.find(op);
+    if (it == waves.end()) return 0;
+    return isStreamCommandOp(op) ? it->second + 1 : it->second;
+  };
+
+  for (auto &op : block) {
+    int wave = 0;
+    for (auto operand : op.getOperands()) {
+      if (auto *definingOp = operand.getDefiningOp()) {
+        wave = std::max(wave, getAvailableWave(definingOp));
+      }
+    }
+
+    // Ops that write in-place into their operands must also wait until all
+    // prior readers of the operand storage have completed. Reshapes alias their
+    // operand storage and are walked through in both directions.
+    auto tiedOp = dyn_cast<IREE::Util::TiedOpInterface>(op);
+    if (tiedOp && isStreamCommandOp(&op)) {
+      SmallVector<Value> worklist;
+      for (unsigned i = 0; i < op.getNumResults(); ++i) {
+        auto operandIndex = tiedOp.getTiedResultOperandIndex(i);
+        if (operandIndex.hasValue()) {
+          worklist.push_back(op.getOperand(operandIndex.getValue()));
+        }
+      }
+      SmallPtrSet<Value, 8> visitedValues;
+      while (!worklist.empty()) {
+        auto value = worklist.pop_back_val();
+        if (!visitedValues.insert(value).second) continue;
+        if (auto reshapeOp =
+                dyn_cast_or_null<TensorReshapeOp>(value.getDefiningOp())) {
+          worklist.push_back(reshapeOp.source());
+        }
+        for (auto *user : value.getUsers()) {
+          if (user == &op || user->getBlock() != &block ||
+              !user->isBeforeInBlock(&op)) {
+            continue;
+          }
+          if (auto reshapeOp = dyn_cast<TensorReshapeOp>(user)) {
+            worklist.push_back(reshapeOp.result());
+          } else if (isStreamCommandOp(user)) {
+            wave = std::max(wave, waves[user] + 1);
+          }
+        }
+      }
+    }
+
+    waves[&op] = wave;
+  }
+  return waves;
+}
+
 IREE::Util::ClosureOpInterface
 ExStreamFragmentOp::cloneReplacementExcludingOperandsAndResults(
     ArrayRef<unsigned> excludedOperandIndices,
@@ -373,6 +373,19 @@ func @updateReplace(%arg0 : tensor<4xi32>, %arg1 : tensor<4xi32>) -> tensor<4xi3
 
 // -----
 
+// CHECK-LABEL: @updateReplaceImportedStorage
+func @updateReplaceImportedStorage(%arg0 : tensor<4xi32>, %arg1 : !hal.buffer_view) -> tensor<4xi32> {
+  %c0 = constant 0 : index
+  // CHECK: %[[TARGET:.+]] = hal.tensor.cast %arg1
+  %0 = hal.tensor.cast %arg1 : !hal.buffer_view -> tensor<4xi32>
+  // CHECK: %[[UPDATE:.+]] = flow.tensor.update %arg0, %[[TARGET]]
+  %1 = flow.tensor.update %arg0, %0[%c0] : tensor<4xi32> -> tensor<4xi32>
+  // CHECK: return %[[UPDATE]]
+  return %1 : tensor<4xi32>
+}
+
+// -----
+
 // CHECK-LABEL: @propogateStaticShapeOfTarget
 func @propogateStaticShapeOfTarget(%arg0 : tensor<?x?xf32>, %arg1 : f32) -> tensor<?x?xf32> {
   %c21 = constant 21 : index
@@ -0,0 +1,305 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
+#include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
+#include "iree/compiler/Dialect/Util/IR/UtilOps.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "mlir/Dialect/Linalg/IR/LinalgOps.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Pass/Pass.h"
+
+#define DEBUG_TYPE "iree-flow-const-eval-global-initializers"
+
+static llvm::cl::opt<int64_t> clConstEvalMaxIterations(
+    "iree-flow-const-eval-max-iterations",
+    llvm::cl::desc("Maximum number of loop iterations a single linalg op may "
+                   "have to be evaluated at compile time when folding global "
+                   "initializers"),
+    llvm::cl::init(1 << 20));
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Flow {
+
+namespace {
+
+// Evaluates ops on constant values within a function body at compile time.
+// Ops are evaluated with their folders and linalg ops are interpreted one loop
+// iteration at a time by folding the scalar ops in their bodies.
+class ConstantEvaluator {
+ public:
+  // Evaluates |funcOp| and returns the constant values it returns or None if
+  // any op could not be evaluated.
+  Optional<SmallVector<Attribute>> evaluateFunc(mlir::FuncOp funcOp) {
+    if (funcOp.getNumArguments() != 0 || funcOp.getBlocks().size() != 1) {
+      return llvm::None;
+    }
+    for (auto &op : funcOp.front()) {
+      if (op.hasTrait<OpTrait::ReturnLike>()) {
+        SmallVector<Attribute> results;
+        for (auto operand : op.getOperands()) {
+          auto attr = values.lookup(operand);
+          if (!attr) return llvm::None;
+          results.push_back(attr);
+        }
+        return results;
+      }
+      if (failed(evaluateOp(&op))) {
+        LLVM_DEBUG(llvm::dbgs() << "unable to evaluate " << op << "\n");
+        return llvm::None;
+      }
+    }
+    return llvm::None;
+  }
+
+ private:
+  LogicalResult evaluateOp(Operation *op) {
+    if (op->getNumResults() == 0) return failure();
+
+    // Constants produce their values directly.
+    Attribute constantValue;
+    if (op->getNumResults() == 1 &&
+        matchPattern(op->getResult(0), m_Constant(&constantValue))) {
+      values[op->getResult(0)] = constantValue;
+      return success();
+    }
+
+    // The contents of new tensors are undefined and zeros are as good a value
+    // as any for them.
+    if (auto initTensorOp = dyn_cast<linalg::InitTensorOp>(op)) {
+      auto type = initTensorOp.getType().dyn_cast<RankedTensorType>();
+      if (!type || !type.hasStaticShape()) return failure();
+      auto zeroAttr = getZeroAttr(type.getElementType());
+      if (!zeroAttr) return failure();
+      values[initTensorOp.result()] = DenseElementsAttr::get(type, zeroAttr);
+      return success();
+    }
+
+    SmallVector<Attribute> operands;
+    for (auto operand : op->getOperands()) {
+      auto attr = values.lookup(operand);
+      if (!attr) return failure();
+      operands.push_back(attr);
+    }
+
+    if (auto genericOp = dyn_cast<linalg::GenericOp>(op)) {
+      return evaluateGenericOp(genericOp, operands);
+    }
+
+    SmallVector<Attribute> results;
+    if (failed(foldOp(op, operands, results))) return failure();
+    for (auto it : llvm::zip(op->getResults(), results)) {
+      values[std::get<0>(it)] = std::get<1>(it);
+    }
+    return success();
+  }
+
+  // Folds |op| with the given constant |operands|. Fails unless all results
+  // fold to constants.
+  static LogicalResult foldOp(Operation *op, ArrayRef<Attribute> operands,
+                              SmallVectorImpl<Attribute> &results) {
+    SmallVector<OpFoldResult> foldResults;
+    // Folds that succeed without results have updated the op in-place; we
+    // only evaluate on clones so that's harmless but gives us no value.
+    if (failed(op->fold(operands, foldResults)) || foldResults.empty()) {
+      return failure();
+    }
+    for (auto it : llvm::enumerate(foldResults)) {
+      Attribute attr = it.value().dyn_cast<Attribute>();
+      if (!attr) {
+        // Folded to an existing value; only operands have known values here.
+        Value value = it.value().get<Value>();
+        for (auto operand : llvm::enumerate(op->getOperands())) {
+          if (operand.value() == value) attr = operands[operand.index()];
+        }
+      }
+      if (!attr) return failure();
+      results.push_back(attr);
+    }
+    return success();
+  }
+
+  static Attribute getZeroAttr(Type elementType) {
+    if (auto floatType = elementType.dyn_cast<FloatType>()) {
+      return FloatAttr::get(floatType, 0.0);
+    } else if (elementType.isIntOrIndex()) {
+      return IntegerAttr::get(elementType, 0);
+    }
+    return {};
+  }
+
+  // Interprets |genericOp| over the constant |operands|.
+  LogicalResult evaluateGenericOp(linalg::GenericOp genericOp,
+                                  ArrayRef<Attribute> operands) {
+    // Compute the static loop ranges from the operand shapes.
+    unsigned numLoops = genericOp.getNumLoops();
+    SmallVector<int64_t> loopRanges(numLoops, -1);
+    SmallVector<AffineMap> indexingMaps;
+    SmallVector<ArrayRef<int64_t>> shapes;
+    for (auto *opOperand : genericOp.getInputAndOutputOperands()) {
+      auto type = opOperand->get().getType().dyn_cast<RankedTensorType>();
+      if (!type || !type.hasStaticShape()) return failure();
+      auto indexingMap = genericOp.getTiedIndexingMap(opOperand);
+      for (auto expr : llvm::enumerate(indexingMap.getResults())) {
+        if (auto dimExpr = expr.value().dyn_cast<AffineDimExpr>()) {
+          loopRanges[dimExpr.getPosition()] = type.getDimSize(expr.index());
+        }
+      }
+      indexingMaps.push_back(indexingMap);
+      shapes.push_back(type.getShape());
+    }
+    int64_t numIterations = 1;
+    for (int64_t range : loopRanges) {
+      if (range < 0) return failure();
+      numIterations *= range;
+    }
+    if (numIterations > clConstEvalMaxIterations) {
+      LLVM_DEBUG(llvm::dbgs() << "skipping evaluation of " << numIterations
+                              << " iterations\n");
+      return failure();
+    }
+
+    // Flatten all operand values for random access. Outputs are updated in
+    // place as the iterations run.
+    SmallVector<SmallVector<Attribute>> elements;
+    for (auto operand : operands) {
+      auto elementsAttr = operand.dyn_cast<DenseElementsAttr>();
+      if (!elementsAttr) return failure();
+      elements.emplace_back(elementsAttr.getValues<Attribute>().begin(),
+                            elementsAttr.getValues<Attribute>().end());
+    }
+
+    auto getLinearIndex = [&](unsigned operandIndex,
+                              ArrayRef<int64_t> loopIndices) {
+      auto indices = indexingMaps[operandIndex].compose(loopIndices);
+      int64_t linearIndex = 0;
+      for (auto it : llvm::zip(indices, shapes[operandIndex])) {
+        linearIndex = linearIndex * std::get<1>(it) + std::get<0>(it);
+      }
+      return linearIndex;
+    };
+
+    Block &body = genericOp.region().front();
+    unsigned numInputs = genericOp.getNumInputs();
+    SmallVector<int64_t> loopIndices(numLoops, 0);
+    for (int64_t iteration = 0; iteration < numIterations; ++iteration) {
+      DenseMap<Value, Attribute> bodyValues;
+      for (auto arg : body.getArguments()) {
+        unsigned operandIndex = arg.getArgNumber();
+        bodyValues[arg] =
+            elements[operandIndex][getLinearIndex(operandIndex, loopIndices)];
+      }
+      for (auto &bodyOp : body) {
+        SmallVector<Attribute> bodyOperands;
+        for (auto operand : bodyOp.getOperands()) {
+          // Values defined outside of the body must have been evaluated.
+          auto attr = bodyValues.lookup(operand);
+          if (!attr) attr = values.lookup(operand);
+          if (!attr) return failure();
+          bodyOperands.push_back(attr);
+        }
+        if (auto yieldOp = dyn_cast<linalg::YieldOp>(bodyOp)) {
+          for (auto it : llvm::enumerate(bodyOperands)) {
+            unsigned operandIndex = numInputs + it.index();
+            elements[operandIndex][getLinearIndex(operandIndex, loopIndices)] =
+                it.value();
+          }
+          break;
+        }
+        if (auto indexOp = dyn_cast<linalg::IndexOp>(bodyOp)) {
+          bodyValues[indexOp.getResult()] = IntegerAttr::get(
+              indexOp.getType(), loopIndices[indexOp.dim()]);
+          continue;
+        }
+        Attribute constantValue;
+        if (bodyOp.getNumResults() == 1 &&
+            matchPattern(bodyOp.getResult(0), m_Constant(&constantValue))) {
+          bodyValues[bodyOp.getResult(0)] = constantValue;
+          continue;
+        }
+        SmallVector<Attribute> results;
+        if (failed(foldOp(&bodyOp, bodyOperands, results))) return failure();
+        for (auto it : llvm::zip(bodyOp.getResults(), results)) {
+          bodyValues[std::get<0>(it)] = std::get<1>(it);
+        }
+      }
+      // Advance the loop indices in row-major order.
+      for (int64_t i = numLoops - 1; i >= 0; --i) {
+        if (++loopIndices[i] < loopRanges[i]) break;
+        loopIndices[i] = 0;
+      }
+    }
+
+    for (auto result : llvm::enumerate(genericOp->getResults())) {
+      auto type = result.value().getType().cast<RankedTensorType>();
+      values[result.value()] =
+          DenseElementsAttr::get(type, elements[numInputs + result.index()]);
+    }
+    return success();
+  }
+
+  // Constant values of all evaluated SSA values.
+  DenseMap<Value, Attribute> values;
+};
+
+// Evaluates global initializers that only compute on constants (transposes,
+// reshapes, quantization, etc) at compile time and stores the result as the
+// initial value of the global. This avoids the work at module load time in
+// every process using the module and lets the results be stored in rodata.
+class ConstEvalGlobalInitializersPass
+    : public ConstEvalGlobalInitializersBase<ConstEvalGlobalInitializersPass> {
+ public:
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<linalg::LinalgDialect>();
+  }
+
+  void runOnOperation() override {
+    auto moduleOp = getOperation();
+    SymbolTable symbolTable(moduleOp);
+    for (auto globalOp :
+         llvm::to_vector<4>(moduleOp.getOps<IREE::Util::GlobalOp>())) {
+      if (!globalOp.initializer()) continue;
+      auto initializerOp = symbolTable.lookup<mlir::FuncOp>(
+          globalOp.initializer().getValue());
+      if (!initializerOp) continue;
+
+      // Evaluate on a clone so that folders updating ops in-place don't
+      // change the original initializer if evaluation fails. The clone is kept
+      // in the module so that folders can still resolve symbols.
+      auto clonedOp = cast<mlir::FuncOp>(
+          OpBuilder(initializerOp).clone(*initializerOp.getOperation()));
+      ConstantEvaluator evaluator;
+      auto results = evaluator.evaluateFunc(clonedOp);
+      clonedOp.erase();
+      if (!results || results->size() != 1) continue;
+      auto value = results->front().dyn_cast<ElementsAttr>();
+      if (!value || value.getType() != globalOp.type()) continue;
+
+      globalOp.initial_valueAttr(value);
+      globalOp->removeAttr("initializer");
+      if (SymbolTable::symbolKnownUseEmpty(initializerOp, moduleOp)) {
+        symbolTable.erase(initializerOp);
+      }
+    }
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<OperationPass<mlir::ModuleOp>>
+createConstEvalGlobalInitializersPass() {
+  return std::make_unique<ConstEvalGlobalInitializersPass>();
+}
+
+}  // namespace Flow
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -16,6 +16,7 @@
 #include "iree/compiler/Dialect/Shape/IR/ShapeDialect.h"
 #include "iree/compiler/Dialect/Shape/IR/ShapeOps.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/CommandLine.h"
 #include "mlir/Dialect/Linalg/IR/LinalgOps.h"
@@ -47,17 +48,27 @@ static llvm::cl::list<int64_t> clLinalgOnTensorsTileSizes(
     llvm::cl::desc("Comma-separated list of tile sizes for tiling on tensors"),
     llvm::cl::CommaSeparated);
 
-// TODO(#5040): This works for the most part but the downstream bufferization
-// needs to be sorted out before this can be made the default. Remove after
-// making this default.
+// Fuses elementwise epilogues (bias add, activations, residual adds,
+// requantization) into the dispatch of the matmul/convolution they consume so
+// that the result is written out once. Only consumers that bufferization can
+// compute in place in the result buffer are fused (see #5040).
 static llvm::cl::opt<bool> clEnableOperandFusion(
     "iree-flow-dispatch-formation-enable-operand-fusion",
     llvm::cl::desc(
         "Enable fusing operand producers during dispatch region formation"),
+    llvm::cl::init(true));
+
+// When enabled together with `-iree-enable-fusion-with-reduction-ops` patterns
+// like softmax and layer normalization form a single dispatch region.
+static llvm::cl::opt<bool> clEnableReductionFusion(
+    "iree-flow-dispatch-formation-enable-reduction-fusion",
+    llvm::cl::desc("Enable fusing reductions into their elementwise consumers "
+                   "during dispatch region formation"),
     llvm::cl::init(false));
 
 static const char kRootOpAttr[] = "__root_op__";
 static const char kFusionGroupsAttr[] = "__fused_op__";
+static const char kNumPartitionedLoopsAttr[] = "__num_partitioned_loops__";
 
 namespace mlir {
 namespace iree_compiler {
@@ -79,6 +90,7 @@ static void removeRootOpAttribute(Operation *op) {
   assert(op->hasAttr(kRootOpAttr) &&
          "removing root attribute from op that is not a root attribute");
   op->removeAttr(kRootOpAttr);
+  op->removeAttr(kNumPartitionedLoopsAttr);
 }
 /// Sets the root attribute for an operation. The root attribute needs a number
 /// to identify the root. Asserts if root attribute is already set on an
@@ -661,6 +673,11 @@ static SmallVector<unsigned> getPartitionedLoops(Operation *op) {
   }
   if (auto linalgOp = dyn_cast<linalg::LinalgOp>(op)) {
     size_t numOuterParallelLoops = getNumOuterParallelLoops(linalgOp);
+    if (auto numPartitionedLoopsAttr =
+            op->getAttrOfType<IntegerAttr>(kNumPartitionedLoopsAttr)) {
+      numOuterParallelLoops = std::min<size_t>(
+          numOuterParallelLoops, numPartitionedLoopsAttr.getInt());
+    }
     partitionedLoops =
         llvm::to_vector<4>(llvm::seq<unsigned>(0, numOuterParallelLoops));
     if (partitionedLoops.size() > kNumMaxParallelDims) {
@@ -1124,9 +1141,13 @@ static unsigned decideFusableLinalgOps(mlir::FuncOp funcOp) {
       // To fuse root operations with their consumers, for all root ops chosen.
       // If, 1) The root op has a single use 2) The consumer is an elementwise
       // operation 3) The indexing map in the producer and consumer are identity
-      // maps The root operation can be fused with its consumer. To do this,
-      // mark the consumer as the root and add the operation to the fusion
-      // group.
+      // maps 4) The consumer writes a single result of the same type without
+      // reading its initial value, the root operation can be fused with its
+      // consumer. To do this, mark the consumer as the root and add the
+      // operation to the fusion group. The consumer then becomes a candidate
+      // itself so that chains of epilogue ops all land in the same dispatch.
+      // The last condition lets bufferization compute the root op directly in
+      // the result buffer of the consumer, so no intermediate is allocated.
       for (linalg::LinalgOp linalgOp : block.getOps<linalg::LinalgOp>()) {
         Operation *op = linalgOp.getOperation();
         if (!hasRootOpAttribute(op)) continue;
@@ -1138,7 +1159,13 @@ static unsigned decideFusableLinalgOps(mlir::FuncOp funcOp) {
         }
         linalg::LinalgOp consumer = dyn_cast<linalg::LinalgOp>(use.getOwner());
         if (!consumer ||
-            consumer.getNumLoops() != consumer.getNumParallelLoops()) {
+            consumer.getNumLoops() != consumer.getNumParallelLoops() ||
+            consumer.getNumOutputs() != 1) {
+          continue;
+        }
+        OpOperand *consumerOutput = consumer.getOutputOperand(0);
+        if (consumerOutput->get().getType() != op->getResult(0).getType() ||
+            consumer.payloadUsesValueFromOperand(consumerOutput)) {
           continue;
         }
         AffineMap consumerIndexingMap = consumer.getTiedIndexingMap(&use);
@@ -1159,6 +1186,132 @@ static unsigned decideFusableLinalgOps(mlir::FuncOp funcOp) {
   return numRootOps;
 }
 
+/// Returns true if `genericOp` is an elementwise operation that can be the root
+/// of a fusion group with reductions.
+static bool isElementwiseGenericOp(linalg::GenericOp genericOp) {
+  return genericOp.getNumLoops() == genericOp.getNumParallelLoops() &&
+         llvm::all_of(genericOp.getIndexingMaps(), [](AffineMap map) {
+           return map.isProjectedPermutation();
+         });
+}
+
+/// Returns true if `genericOp` is a reduction that can be fused into the
+/// dispatch region of its consumers.
+static bool isFusableReductionGenericOp(linalg::GenericOp genericOp) {
+  return genericOp.getNumReductionLoops() > 0 &&
+         genericOp->getNumResults() == 1 &&
+         llvm::all_of(genericOp.getIndexingMaps(), [](AffineMap map) {
+           return map.isProjectedPermutation();
+         });
+}
+
+/// Returns the number of leading loops of `consumer` that are used to index
+/// `operand`. Only these loops can be partitioned without requiring each
+/// workgroup to recompute the producer of `operand` in its entirety.
+static unsigned getNumLeadingIndexingLoops(linalg::LinalgOp consumer,
+                                           OpOperand *operand) {
+  AffineMap map = consumer.getTiedIndexingMap(operand);
+  unsigned numLoops = 0;
+  while (numLoops < map.getNumDims() &&
+         llvm::any_of(map.getResults(), [&](AffineExpr expr) {
+           auto dimExpr = expr.dyn_cast<AffineDimExpr>();
+           return dimExpr && dimExpr.getPosition() == numLoops;
+         })) {
+    ++numLoops;
+  }
+  return numLoops;
+}
+
+/// Fuses reductions into the elementwise operations consuming their results,
+/// such as the max/sum reductions of a softmax or the mean/variance reductions
+/// of a layer normalization into the elementwise operation normalizing the
+/// input. The elementwise operation is made the root of the fusion group and
+/// is only partitioned along its leading loops that are used to index all of
+/// the fused reduction results; each workgroup then computes the reductions
+/// for the slice of the result it produces instead of each reduction making a
+/// round trip through memory in its own dispatch region.
+///
+/// Reductions are fused transitively when they are consumed by another fused
+/// reduction using the same indexing map as its result (for example the sum of
+/// a softmax that depends on the max). A reduction is only fused if all of its
+/// uses are within the fusion group.
+static unsigned fuseReductionsWithElementwiseConsumers(mlir::FuncOp funcOp,
+                                                       unsigned numRoots) {
+  MLIRContext *context = funcOp.getContext();
+  for (Block &block : funcOp) {
+    auto genericOps = llvm::to_vector<8>(block.getOps<linalg::GenericOp>());
+    for (linalg::GenericOp consumer : llvm::reverse(genericOps)) {
+      Operation *consumerOp = consumer.getOperation();
+      if (hasRootOpAttribute(consumerOp) ||
+          hasFusionGroupsAttribute(consumerOp) ||
+          !isElementwiseGenericOp(consumer)) {
+        continue;
+      }
+
+      // Grow the set of fused reductions until no more can be added.
+      llvm::SetVector<Operation *> fusedOps;
+      fusedOps.insert(consumerOp);
+      unsigned numPartitionedLoops = getNumOuterParallelLoops(consumer);
+      bool changed = true;
+      while (changed) {
+        changed = false;
+        for (unsigned i = 0; i < fusedOps.size(); ++i) {
+          auto user = cast<linalg::GenericOp>(fusedOps[i]);
+          for (OpOperand *operand : user.getInputTensorOperands()) {
+            auto reduction = operand->get().getDefiningOp<linalg::GenericOp>();
+            if (!reduction || reduction->getBlock() != &block ||
+                fusedOps.count(reduction) || hasRootOpAttribute(reduction) ||
+                hasFusionGroupsAttribute(reduction) ||
+                !isFusableReductionGenericOp(reduction)) {
+              continue;
+            }
+            unsigned numLoops = numPartitionedLoops;
+            bool isFusable = true;
+            for (OpOperand &use : reduction->getResult(0).getUses()) {
+              auto useOp = dyn_cast<linalg::GenericOp>(use.getOwner());
+              if (!useOp || !fusedOps.count(useOp)) {
+                isFusable = false;
+              } else if (useOp == consumer) {
+                numLoops = std::min(numLoops,
+                                    getNumLeadingIndexingLoops(consumer, &use));
+              } else if (useOp.getTiedIndexingMap(&use) !=
+                         useOp.getTiedIndexingMap(useOp.getOutputOperand(0))) {
+                isFusable = false;
+              }
+            }
+            if (!isFusable || numLoops == 0) continue;
+            numPartitionedLoops = numLoops;
+            fusedOps.insert(reduction);
+            changed = true;
+          }
+        }
+      }
+      if (fusedOps.size() == 1) continue;
+
+      unsigned newGroup = numRoots++;
+      setRootAttribute(context, consumerOp, newGroup);
+      consumerOp->setAttr(kNumPartitionedLoopsAttr,
+                          Builder(context).getI64IntegerAttr(
+                              numPartitionedLoops));
+      for (Operation *fusedOp : fusedOps) {
+        if (fusedOp != consumerOp) appendToFusionGroup(fusedOp, newGroup);
+        // Pull in the producers of the outputs (such as the linalg.fill
+        // initializing the reduction) as with other root operations.
+        for (OpOperand *operand :
+             cast<linalg::LinalgOp>(fusedOp).getOutputTensorOperands()) {
+          auto producer = operand->get().getDefiningOp<linalg::LinalgOp>();
+          if (!producer) continue;
+          if (producer.getNumLoops() != producer.getNumParallelLoops()) {
+            continue;
+          }
+          appendToFusionGroup(producer, newGroup);
+        }
+      }
+    }
+  }
+  return numRoots;
+}
+
 namespace {
 /// Pass declaration.
 struct DispatchLinalgOnTensorsPass
@@ -1185,6 +1338,9 @@ void DispatchLinalgOnTensorsPass::runOnOperation() {
   context->allowUnregisteredDialects(true);
 
   unsigned numRoots = decideFusableLinalgOps(funcOp);
+  if (clEnableReductionFusion) {
+    numRoots = fuseReductionsWithElementwiseConsumers(funcOp, numRoots);
+  }
   numRoots = makeElementwiseOpsRootOps<linalg::GenericOp>(funcOp, numRoots);
 
   DEBUG_WITH_TYPE(DEBUG_TYPE, {
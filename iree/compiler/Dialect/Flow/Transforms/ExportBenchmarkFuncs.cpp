@@ -13,6 +13,7 @@
 #include "mlir/IR/BlockAndValueMapping.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Matchers.h"
 #include "mlir/Pass/Pass.h"
 
 namespace mlir {
@@ -20,10 +21,31 @@ namespace iree_compiler {
 namespace IREE {
 namespace Flow {
 
+// Returns the number of bytes of |type| if it is a statically shaped tensor.
+static Optional<int64_t> getStaticTensorByteSize(Type type) {
+  auto tensorType = type.dyn_cast<RankedTensorType>();
+  if (!tensorType || !tensorType.hasStaticShape() ||
+      !tensorType.getElementType().isIntOrFloat()) {
+    return llvm::None;
+  }
+  return (tensorType.getNumElements() *
+              tensorType.getElementTypeBitWidth() +
+          7) /
+         8;
+}
+
 // Clones each exported functions (including those just created) with
 // placeholder constant inputs instead of arguments and removes the exported
 // attribute from the old functions.
 // The input are provided using util.globals.
+//
+// Additionally exports one function per unique dispatch entry point with
+// static shapes and workloads that runs just that dispatch with placeholder
+// inputs of the sizes used by the model. These are tagged with a `dispatch`
+// benchmark reflection attribute along with the bytes the dispatch reads and
+// writes and, when known, the estimate of the ops it performs recorded on the
+// entry point during outlining so that tools can derive achieved bandwidth and
+// throughput.
 class ExportBenchmarkFuncsPass
     : public ExportBenchmarkFuncsBase<ExportBenchmarkFuncsPass> {
  public:
@@ -49,6 +71,23 @@ class ExportBenchmarkFuncsPass
         return;
       }
     }
+
+    // Export each unique dispatch reachable from the original entry points.
+    DenseSet<Attribute> exportedEntryPoints;
+    for (auto entryFuncOp : entryFuncOps) {
+      SmallVector<DispatchOp> dispatchOps;
+      entryFuncOp.walk(
+          [&](DispatchOp dispatchOp) { dispatchOps.push_back(dispatchOp); });
+      for (auto dispatchOp : dispatchOps) {
+        if (!exportedEntryPoints.insert(dispatchOp.entry_point()).second) {
+          continue;
+        }
+        if (failed(createDispatchBenchmarkFunc(moduleOp, dispatchOp))) {
+          signalPassFailure();
+          return;
+        }
+      }
+    }
   }
 
  private:
@@ -122,6 +161,119 @@ class ExportBenchmarkFuncsPass
     return success();
   }
 
+  // Returns true if |dispatchOp| can be run standalone: all shapes and the
+  // workload are static and non-tensor operands are constants.
+  static bool isDispatchBenchmarkable(DispatchOp dispatchOp) {
+    if (!dispatchOp.operand_dims().empty() ||
+        !dispatchOp.result_dims().empty()) {
+      return false;
+    }
+    for (auto workgroupCount : dispatchOp.workgroup_count()) {
+      if (!matchPattern(workgroupCount, m_Constant())) return false;
+    }
+    for (auto operand : dispatchOp.operands()) {
+      if (operand.getType().isa<TensorType>()) {
+        if (!getStaticTensorByteSize(operand.getType())) return false;
+      } else if (!matchPattern(operand, m_Constant())) {
+        return false;
+      }
+    }
+    for (auto resultType : dispatchOp.getResultTypes()) {
+      if (!getStaticTensorByteSize(resultType)) return false;
+    }
+    return true;
+  }
+
+  LogicalResult createDispatchBenchmarkFunc(mlir::ModuleOp moduleOp,
+                                            DispatchOp dispatchOp) {
+    // Dispatches with dynamic shapes are skipped: the sizes they are run with
+    // are only known at runtime.
+    if (!isDispatchBenchmarkable(dispatchOp)) return success();
+
+    OpBuilder moduleBuilder(&getContext());
+    moduleBuilder.setInsertionPointToEnd(moduleOp.getBody());
+
+    // Create one dummy input variable per tensor operand and count the bytes
+    // moved by the dispatch.
+    Location loc = dispatchOp.getLoc();
+    int64_t byteCount = 0;
+    SmallVector<IREE::Util::GlobalOp, 4> dummyInputVariableOps;
+    for (auto operand : dispatchOp.operands()) {
+      if (!operand.getType().isa<TensorType>()) continue;
+      auto dummyVar =
+          createDummyInputVariableOp(loc, operand.getType(), moduleBuilder);
+      if (!dummyVar) return failure();
+      dummyInputVariableOps.push_back(dummyVar);
+      byteCount += *getStaticTensorByteSize(operand.getType());
+    }
+    for (auto resultType : dispatchOp.getResultTypes()) {
+      byteCount += *getStaticTensorByteSize(resultType);
+    }
+
+    // Create a `() -> ()` function running just the dispatch.
+    auto executableOp = SymbolTable::lookupNearestSymbolFrom<ExecutableOp>(
+        dispatchOp, dispatchOp.executable());
+    auto entryPointOp = SymbolTable::lookupNearestSymbolFrom<DispatchEntryOp>(
+        dispatchOp, dispatchOp.entry_point());
+    if (!executableOp || !entryPointOp) {
+      return dispatchOp.emitOpError() << "entry point not found";
+    }
+    std::string funcName = executableOp.sym_name().str();
+    if (entryPointOp.sym_name() != executableOp.sym_name()) {
+      funcName += "_" + entryPointOp.sym_name().str();
+    }
+    funcName += "_benchmark";
+    auto funcOp = moduleBuilder.create<mlir::FuncOp>(
+        loc, funcName, moduleBuilder.getFunctionType({}, {}));
+    funcOp.setPublic();
+    funcOp->setAttr("iree.abi.stub", moduleBuilder.getUnitAttr());
+    SmallVector<NamedAttribute> reflectionAttrs = {
+        moduleBuilder.getNamedAttr("benchmark",
+                                   moduleBuilder.getStringAttr("dispatch")),
+        moduleBuilder.getNamedAttr(
+            "bytes", moduleBuilder.getStringAttr(std::to_string(byteCount))),
+    };
+    if (auto opCount = entryPointOp.estimated_ops()) {
+      reflectionAttrs.push_back(moduleBuilder.getNamedAttr(
+          "ops", moduleBuilder.getStringAttr(std::to_string(*opCount))));
+    }
+    funcOp->setAttr("iree.reflection",
+                    moduleBuilder.getDictionaryAttr(reflectionAttrs));
+    Block* block = funcOp.addEntryBlock();
+
+    // Clone the dispatch with the dummy inputs and its constant operands.
+    auto blockBuilder = OpBuilder::atBlockBegin(block);
+    BlockAndValueMapping mapping;
+    for (auto workgroupCount : dispatchOp.workgroup_count()) {
+      if (mapping.contains(workgroupCount)) continue;
+      mapping.map(workgroupCount,
+                  blockBuilder.clone(*workgroupCount.getDefiningOp())
+                      ->getResult(0));
+    }
+    unsigned dummyIndex = 0;
+    for (auto operand : dispatchOp.operands()) {
+      if (mapping.contains(operand)) continue;
+      if (operand.getType().isa<TensorType>()) {
+        mapping.map(operand,
+                    blockBuilder.createOrFold<IREE::Util::GlobalLoadOp>(
+                        loc, dummyInputVariableOps[dummyIndex++]));
+      } else {
+        mapping.map(operand, blockBuilder.clone(*operand.getDefiningOp())
+                                 ->getResult(0));
+      }
+    }
+    auto clonedOp = blockBuilder.clone(*dispatchOp, mapping);
+
+    // Sink all results with do_not_optimize to ensure that DCE does not
+    // remove the dispatch.
+    for (auto result : clonedOp->getResults()) {
+      blockBuilder.create<IREE::Util::DoNotOptimizeOp>(loc, result);
+    }
+    blockBuilder.create<mlir::ReturnOp>(loc);
+
+    return success();
+  }
+
   int uniqueId = 0;
 };
 
@@ -94,6 +94,29 @@ class FormStreamsPass : public FormStreamsBase<FormStreamsPass> {
     return streams;
   }
 
+  // Reorders the ops within |fragmentOp| such that all ops in the same
+  // execution wave are adjacent. Independent ops (such as the branches of an
+  // inception block or the heads of multi-head attention) are then grouped
+  // together and can be recorded without barriers between them so that they
+  // may execute concurrently. Producers are always in an earlier or the same
+  // wave as their consumers so a stable sort preserves dominance.
+  void sortFragmentByExecutionWave(ExStreamFragmentOp fragmentOp) {
+    auto waves = fragmentOp.computeExecutionWaves();
+    auto &block = fragmentOp.body().front();
+    auto *terminator = block.getTerminator();
+    SmallVector<Operation *, 8> sortedOps;
+    for (auto &op : block.without_terminator()) {
+      sortedOps.push_back(&op);
+    }
+    std::stable_sort(sortedOps.begin(), sortedOps.end(),
+                     [&](Operation *lhs, Operation *rhs) {
+                       return waves[lhs] < waves[rhs];
+                     });
+    for (auto *op : sortedOps) {
+      op->moveBefore(terminator);
+    }
+  }
+
   // Forms a stream fragment containing the identified stream ops and removes
   // the originals from the parent block.
   void formStreamFragmentInBlock(Block &block,
@@ -171,6 +194,7 @@ class FormStreamsPass : public FormStreamsBase<FormStreamsPass> {
         llvm::to_vector<8>(llvm::map_range(fragmentResults, [&](Value value) {
           return mapping.lookup(value);
         })));
+    sortFragmentByExecutionWave(fragmentOp);
     for (auto resultOldNew : llvm::zip(fragmentResults, fragmentOp.results())) {
       auto oldValue = std::get<0>(resultOldNew);
       auto newValue = std::get<1>(resultOldNew);
@@ -0,0 +1,233 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/Flow/IR/FlowOps.h"
+#include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
+#include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
+#include "iree/compiler/Dialect/Util/IR/UtilTypes.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Dominance.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/Pass/Pass.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Flow {
+
+namespace {
+
+// Returns the region argument of |dispatchOp| that |resultIndex| is stored
+// into. Tied results have no argument of their own and are skipped.
+static BlockArgument getResultArgument(DispatchWorkgroupsOp dispatchOp,
+                                       unsigned resultIndex) {
+  unsigned argIndex = dispatchOp.operands().size();
+  for (unsigned i = 0; i < resultIndex; ++i) {
+    if (!dispatchOp.getTiedResultOperandIndex(i)) ++argIndex;
+  }
+  return dispatchOp.body().front().getArgument(argIndex);
+}
+
+// Returns true if |dispatchOp| can be moved right before |updateOp| without
+// breaking dominance of any of its results.
+static bool canMoveDispatchBefore(DispatchWorkgroupsOp dispatchOp,
+                                  TensorUpdateOp updateOp) {
+  Block *block = updateOp->getBlock();
+  if (dispatchOp->getBlock() != block) return false;
+  if (updateOp.target().getDefiningOp() == dispatchOp) return false;
+  for (auto *user : dispatchOp->getUsers()) {
+    auto *ancestor = block->findAncestorOpInBlock(*user);
+    if (ancestor && ancestor->isBeforeInBlock(updateOp)) return false;
+  }
+  return true;
+}
+
+// Rewrites |storeOp| to store into |target| at |startIndices| offset from its
+// original location.
+static void offsetStoreOp(DispatchTensorStoreOp storeOp, Value target,
+                          ArrayRef<int64_t> startIndices) {
+  OpBuilder builder(storeOp);
+  auto loc = storeOp.getLoc();
+  auto valueType = storeOp.value().getType().cast<ShapedType>();
+  SmallVector<Value, 4> offsets, sizes, strides;
+  SmallVector<int64_t, 4> staticOffsets, staticSizes, staticStrides;
+  if (storeOp.static_offsets().empty()) {
+    // Stores of the entire tensor have no offsets; the value is the full
+    // result and must have a static shape as the result does.
+    staticOffsets.assign(startIndices.begin(), startIndices.end());
+    staticSizes.assign(valueType.getShape().begin(),
+                       valueType.getShape().end());
+    staticStrides.resize(startIndices.size(), 1);
+  } else {
+    for (auto offset : llvm::enumerate(storeOp.getMixedOffsets())) {
+      int64_t startIndex = startIndices[offset.index()];
+      if (auto attr = offset.value().dyn_cast<Attribute>()) {
+        staticOffsets.push_back(attr.cast<IntegerAttr>().getInt() +
+                                startIndex);
+        continue;
+      }
+      Value value = offset.value().get<Value>();
+      if (startIndex != 0) {
+        value = builder.create<AddIOp>(
+            loc, value, builder.create<ConstantIndexOp>(loc, startIndex));
+      }
+      offsets.push_back(value);
+      staticOffsets.push_back(ShapedType::kDynamicStrideOrOffset);
+    }
+    sizes = llvm::to_vector<4>(storeOp.sizes());
+    strides = llvm::to_vector<4>(storeOp.strides());
+    staticSizes = llvm::to_vector<4>(llvm::map_range(
+        storeOp.static_sizes(),
+        [](Attribute attr) { return attr.cast<IntegerAttr>().getInt(); }));
+    staticStrides = llvm::to_vector<4>(llvm::map_range(
+        storeOp.static_strides(),
+        [](Attribute attr) { return attr.cast<IntegerAttr>().getInt(); }));
+  }
+  builder.create<DispatchTensorStoreOp>(
+      loc, storeOp.value(), target, offsets, sizes, strides,
+      builder.getI64ArrayAttr(staticOffsets),
+      builder.getI64ArrayAttr(staticSizes),
+      builder.getI64ArrayAttr(staticStrides));
+  storeOp.erase();
+}
+
+// Fuses |updateOp| into the dispatch producing its update value such that the
+// dispatch writes directly into the target slice:
+//   %0 = flow.dispatch.workgroups[...](...) -> tensor<4xf32> = (...) {
+//     flow.dispatch.tensor.store %v, %ret, offsets = [%o], ...
+//   }
+//   %1 = flow.tensor.update %0, %target[%c2] : tensor<4xf32> -> %target
+// ->
+//   %1 = flow.dispatch.workgroups[...](..., %target) -> %target = (...) {
+//     flow.dispatch.tensor.store %v, %target_arg, offsets = [%o + 2], ...
+//   }
+// This removes the copy of the update into the target that would otherwise
+// follow the dispatch.
+static LogicalResult fuseTensorUpdateIntoDispatch(TensorUpdateOp updateOp,
+                                                  DominanceInfo &domInfo) {
+  auto updateValue = updateOp.update().dyn_cast<OpResult>();
+  if (!updateValue || !updateValue.hasOneUse()) return failure();
+  auto dispatchOp = dyn_cast<DispatchWorkgroupsOp>(updateValue.getOwner());
+  if (!dispatchOp) return failure();
+  unsigned resultIndex = updateValue.getResultNumber();
+  if (dispatchOp.getTiedResultOperandIndex(resultIndex)) return failure();
+
+  // Dynamic start indices would need to be passed into the dispatch and
+  // dynamic shapes would need their dimensions rewired; neither is produced
+  // by pad or concat lowering today.
+  Value target = updateOp.target();
+  if (!target.hasOneUse() ||
+      !updateValue.getType().cast<ShapedType>().hasStaticShape() ||
+      !target.getType().cast<ShapedType>().hasStaticShape()) {
+    return failure();
+  }
+  SmallVector<int64_t, 4> startIndices;
+  for (auto index : updateOp.start_indices()) {
+    APInt value;
+    if (!matchPattern(index, m_ConstantInt(&value))) return failure();
+    startIndices.push_back(value.getSExtValue());
+  }
+
+  // The dispatch must only ever store into the result so that offsetting the
+  // stores covers all of its writes.
+  BlockArgument resultArg = getResultArgument(dispatchOp, resultIndex);
+  for (auto *user : resultArg.getUsers()) {
+    auto storeOp = dyn_cast<DispatchTensorStoreOp>(user);
+    if (!storeOp || storeOp.target() != resultArg) return failure();
+  }
+
+  // The target must be available when the dispatch runs. Dispatches are
+  // side-effect free and can be sunk to the update if the target is produced
+  // after them (such as a splat created late for a pad).
+  if (!domInfo.properlyDominates(target, dispatchOp)) {
+    if (!canMoveDispatchBefore(dispatchOp, updateOp)) return failure();
+    dispatchOp->moveBefore(updateOp);
+  }
+
+  auto resultTypes = llvm::to_vector<4>(dispatchOp.getResultTypes());
+  resultTypes[resultIndex] = target.getType();
+  auto operands = llvm::to_vector<4>(dispatchOp.operands());
+  unsigned targetOperandIndex = operands.size();
+  operands.push_back(target);
+  auto tiedOperandIndices =
+      llvm::to_vector<4>(dispatchOp.getTiedResultOperandIndices());
+  if (tiedOperandIndices.empty()) {
+    tiedOperandIndices.resize(dispatchOp.getNumResults(),
+                              IREE::Util::TiedOpInterface::kUntiedIndex);
+  } else {
+    unsigned tiedOperandOffset =
+        dispatchOp.getTiedOperandsIndexAndLength().first;
+    for (auto &index : tiedOperandIndices) {
+      if (index != IREE::Util::TiedOpInterface::kUntiedIndex) {
+        index -= tiedOperandOffset;
+      }
+    }
+  }
+  tiedOperandIndices[resultIndex] = targetOperandIndex;
+
+  OpBuilder builder(dispatchOp);
+  auto newDispatchOp = builder.create<DispatchWorkgroupsOp>(
+      dispatchOp.getLoc(), dispatchOp.workgroup_count(), resultTypes,
+      dispatchOp.result_dims(), operands, dispatchOp.operand_dims(),
+      tiedOperandIndices, dispatchOp->getAttrs());
+
+  // Remap the region arguments: the result argument is replaced by the new
+  // readwrite target argument and all others keep their relative order.
+  Block &oldBlock = dispatchOp.body().front();
+  Block &newBlock = newDispatchOp.body().front();
+  Value targetArg = newBlock.getArgument(targetOperandIndex);
+  for (auto *user : llvm::to_vector<4>(resultArg.getUsers())) {
+    offsetStoreOp(cast<DispatchTensorStoreOp>(user), targetArg, startIndices);
+  }
+  unsigned newArgIndex = 0;
+  for (auto oldArg : oldBlock.getArguments()) {
+    if (oldArg == resultArg) continue;
+    if (newArgIndex == targetOperandIndex) ++newArgIndex;
+    oldArg.replaceAllUsesWith(newBlock.getArgument(newArgIndex++));
+  }
+  newBlock.getOperations().splice(newBlock.end(), oldBlock.getOperations());
+
+  updateOp.replaceAllUsesWith(newDispatchOp.getResult(resultIndex));
+  updateOp.erase();
+  for (auto result : llvm::enumerate(dispatchOp.getResults())) {
+    if (result.index() == resultIndex) continue;
+    result.value().replaceAllUsesWith(
+        newDispatchOp.getResult(result.index()));
+  }
+  dispatchOp.erase();
+  return success();
+}
+
+class FuseTensorUpdatesIntoDispatchesPass
+    : public FuseTensorUpdatesIntoDispatchesBase<
+          FuseTensorUpdatesIntoDispatchesPass> {
+ public:
+  void runOnOperation() override {
+    // Gather first as fusion replaces dispatches. Updates are visited in
+    // program order so that chains of updates (such as from concatenations)
+    // fuse one after the other into the target of the previous one.
+    SmallVector<TensorUpdateOp> updateOps;
+    getOperation().walk(
+        [&](TensorUpdateOp updateOp) { updateOps.push_back(updateOp); });
+    auto &domInfo = getAnalysis<DominanceInfo>();
+    for (auto updateOp : updateOps) {
+      (void)fuseTensorUpdateIntoDispatch(updateOp, domInfo);
+    }
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<OperationPass<mlir::FuncOp>>
+createFuseTensorUpdatesIntoDispatchesPass() {
+  return std::make_unique<FuseTensorUpdatesIntoDispatchesPass>();
+}
+
+}  // namespace Flow
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -31,7 +31,10 @@ static SmallVector<Value, 4> filterTensorValues(ValueRange&& range) {
 class InjectDispatchTracingPass
     : public InjectDispatchTracingBase<InjectDispatchTracingPass> {
  public:
-  InjectDispatchTracingPass() = default;
+  InjectDispatchTracingPass(bool summarize) { this->summarize = summarize; }
+  InjectDispatchTracingPass(const InjectDispatchTracingPass &that) {
+    this->summarize = that.summarize;
+  }
 
   void runOnOperation() override {
     for (auto dispatchOp : getOperation().getOps<DispatchOp>()) {
@@ -44,23 +47,34 @@ class InjectDispatchTracingPass
 
       // Input tensors:
       OpBuilder builder(dispatchOp);
-      builder.create<TensorTraceOp>(
-          dispatchOp.getLoc(),
-          builder.getStringAttr(entryPointName + " inputs"),
-          filterTensorValues(dispatchOp.operands()));
+      createTrace(builder, dispatchOp.getLoc(),
+                  builder.getStringAttr(entryPointName + " inputs"),
+                  filterTensorValues(dispatchOp.operands()));
 
       // Output tensors:
       builder.setInsertionPointAfter(dispatchOp);
-      builder.create<TensorTraceOp>(
-          dispatchOp.getLoc(),
-          builder.getStringAttr(entryPointName + " outputs"),
-          filterTensorValues(dispatchOp.results()));
+      createTrace(builder, dispatchOp.getLoc(),
+                  builder.getStringAttr(entryPointName + " outputs"),
+                  filterTensorValues(dispatchOp.results()));
+    }
+  }
+
+ private:
+  // Summaries only record statistics of the tensors and are cheap enough to
+  // leave enabled in production while full traces print every element.
+  void createTrace(OpBuilder &builder, Location loc, StringAttr key,
+                   ValueRange values) {
+    if (summarize) {
+      builder.create<TensorSummarizeOp>(loc, key, values);
+    } else {
+      builder.create<TensorTraceOp>(loc, key, values);
     }
   }
 };
 
-std::unique_ptr<OperationPass<mlir::FuncOp>> createInjectDispatchTracingPass() {
-  return std::make_unique<InjectDispatchTracingPass>();
+std::unique_ptr<OperationPass<mlir::FuncOp>> createInjectDispatchTracingPass(
+    bool summarize) {
+  return std::make_unique<InjectDispatchTracingPass>(summarize);
 }
 
 }  // namespace Flow
@@ -4,9 +4,13 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <cstring>
+
 #include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
 #include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
 #include "mlir/Dialect/Linalg/IR/LinalgOps.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/IR/Matchers.h"
 #include "mlir/IR/PatternMatch.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
@@ -102,16 +106,21 @@ class LinalgMatmulOpToLinalgMMT4dOpPattern
 
     RankedTensorType lhsType = lhs.getType().dyn_cast<RankedTensorType>();
     RankedTensorType rhsType = rhs.getType().dyn_cast<RankedTensorType>();
+    RankedTensorType dstType = dst.getType().dyn_cast<RankedTensorType>();
 
-    if (!lhsType || !rhsType || !lhsType.hasStaticShape() ||
+    if (!lhsType || !rhsType || !dstType || !lhsType.hasStaticShape() ||
         !rhsType.hasStaticShape()) {
       return failure();
     }
 
-    // This is for float only matmul for now. Integer data type might require
-    // r.h.s layout change.
-    if (!lhsType.getElementType().isF32() || !rhsType.getElementType().isF32())
+    // Only the element types that the CPU backends have mmt4d microkernels
+    // for are converted: f32, and the mixed precision i8 x i8 -> i32 and
+    // bf16 x bf16 -> f32 used by quantized models.
+    if (!isSupportedElementTypes(lhsType.getElementType(),
+                                 rhsType.getElementType(),
+                                 dstType.getElementType())) {
       return failure();
+    }
 
     int m = lhsType.getShape()[0];
     int n = rhsType.getShape()[1];
@@ -145,11 +154,113 @@ class LinalgMatmulOpToLinalgMMT4dOpPattern
   }
 
  private:
+  static bool isSupportedElementTypes(Type lhsType, Type rhsType,
+                                      Type dstType) {
+    if (lhsType != rhsType) return false;
+    if (lhsType.isF32()) return dstType.isF32();
+    if (lhsType.isInteger(8)) return dstType.isInteger(32);
+    if (lhsType.isBF16()) return dstType.isF32();
+    return false;
+  }
+
   int M0Size;
   int N0Size;
   int K0Size;
 };
 
+/// Returns true if |genericOp| only copies its single input to its output,
+/// e.g. a transpose.
+static bool isCopyOnlyGenericOp(linalg::GenericOp genericOp) {
+  if (genericOp.getNumInputs() != 1) return false;
+  if (genericOp.getNumOutputs() != 1) return false;
+  if (genericOp.getNumParallelLoops() != genericOp.getNumLoops()) return false;
+  auto results =
+      llvm::to_vector<4>(genericOp.getBody()->getOps<linalg::YieldOp>());
+  if (results.size() != 1) return false;
+  if (results[0].values().size() != 1) return false;
+  auto blockArgument = results[0].values()[0].dyn_cast<BlockArgument>();
+  return blockArgument && blockArgument.getArgNumber() == 0;
+}
+
+/// Folds [constant -> linalg.tensor_expand_shape -> linalg.generic] where
+/// linalg.generic only transposes into a constant holding the transposed
+/// values. This packs constant matmul operands (weights) into their mmt4d
+/// layout at compile time instead of on every invocation.
+struct FoldConstantTransposeGenericOpPattern
+    : public OpRewritePattern<linalg::GenericOp> {
+  using OpRewritePattern<linalg::GenericOp>::OpRewritePattern;
+  LogicalResult matchAndRewrite(linalg::GenericOp genericOp,
+                                PatternRewriter &rewriter) const override {
+    if (!isCopyOnlyGenericOp(genericOp)) return failure();
+
+    auto outputType =
+        genericOp.outputs()[0].getType().dyn_cast<RankedTensorType>();
+    if (!outputType || !outputType.hasStaticShape()) return failure();
+    unsigned elementBitWidth = outputType.getElementTypeBitWidth();
+    if (elementBitWidth % 8 != 0) return failure();
+
+    // Look through a reshape of the constant as produced by expandTo4D.
+    Value input = genericOp.inputs()[0];
+    auto inputType = input.getType().cast<RankedTensorType>();
+    if (auto expandOp = input.getDefiningOp<linalg::TensorExpandShapeOp>()) {
+      input = expandOp.src();
+    }
+    DenseElementsAttr inputAttr;
+    if (!matchPattern(input, m_Constant(&inputAttr))) return failure();
+
+    // The input must be indexed by a permutation of the loops and the output
+    // by the loops themselves.
+    AffineMap inputMap =
+        genericOp.getTiedIndexingMap(genericOp.getInputOperand(0));
+    AffineMap outputMap =
+        genericOp.getTiedIndexingMap(genericOp.getOutputOperand(0));
+    if (!inputMap.isPermutation() || !outputMap.isIdentity()) return failure();
+
+    if (inputAttr.isSplat()) {
+      rewriter.replaceOpWithNewOp<mlir::ConstantOp>(
+          genericOp, DenseElementsAttr::get(
+                         outputType, inputAttr.getSplatValue()));
+      return success();
+    }
+
+    // Strides (in elements) of each input dimension.
+    int64_t rank = inputType.getRank();
+    SmallVector<int64_t, 4> inputStrides(rank, 1);
+    for (int64_t i = rank - 2; i >= 0; --i) {
+      inputStrides[i] = inputStrides[i + 1] * inputType.getDimSize(i + 1);
+    }
+    // Stride of the input walked along each loop (== output) dimension.
+    SmallVector<int64_t, 4> loopStrides(rank, 0);
+    for (int64_t i = 0; i < rank; ++i) {
+      loopStrides[inputMap.getDimPosition(i)] = inputStrides[i];
+    }
+
+    size_t elementSize = elementBitWidth / 8;
+    ArrayRef<char> inputData = inputAttr.getRawData();
+    std::vector<char> outputData(inputData.size());
+    SmallVector<int64_t, 4> loopIndices(rank, 0);
+    int64_t numElements = outputType.getNumElements();
+    for (int64_t outputIndex = 0; outputIndex < numElements; ++outputIndex) {
+      int64_t inputIndex = 0;
+      for (int64_t i = 0; i < rank; ++i) {
+        inputIndex += loopIndices[i] * loopStrides[i];
+      }
+      std::memcpy(outputData.data() + outputIndex * elementSize,
+                  inputData.data() + inputIndex * elementSize, elementSize);
+      // Advance the loop indices in row-major order.
+      for (int64_t i = rank - 1; i >= 0; --i) {
+        if (++loopIndices[i] < outputType.getDimSize(i)) break;
+        loopIndices[i] = 0;
+      }
+    }
+
+    rewriter.replaceOpWithNewOp<mlir::ConstantOp>(
+        genericOp, DenseElementsAttr::getFromRawBuffer(outputType, outputData,
+                                                       /*isSplatBuffer=*/false));
+    return success();
+  }
+};
+
 /// Canonicalizes [linalg.init_tensor -> linalg.fill -> linalg.generic] ->
 /// [linalg.init_tensor -> linalg.fill] where linalg.generic does only copy e.g
 /// a transpose.
@@ -157,18 +268,8 @@ struct FoldFillGenericOpPattern : public OpRewritePattern<linalg::GenericOp> {
   using OpRewritePattern<linalg::GenericOp>::OpRewritePattern;
   LogicalResult matchAndRewrite(linalg::GenericOp genericOp,
                                 PatternRewriter &rewriter) const override {
-    if (genericOp.getNumInputs() != 1) return failure();
-    if (genericOp.getNumOutputs() != 1) return failure();
-
     // Check linalg.generic does have copy only semantics.
-    if (genericOp.getNumParallelLoops() != genericOp.getNumLoops())
-      return failure();
-    auto results =
-        llvm::to_vector<4>(genericOp.getBody()->getOps<linalg::YieldOp>());
-    if (results.size() != 1) return failure();
-    if (results[0].values().size() != 1) return failure();
-    auto blockArgument = results[0].values()[0].dyn_cast<BlockArgument>();
-    if (!blockArgument || blockArgument.getArgNumber() != 0) return failure();
+    if (!isCopyOnlyGenericOp(genericOp)) return failure();
 
     auto input = genericOp.inputs()[0];
 
@@ -215,7 +316,8 @@ class ConvertLinalgMatmulOpToLinalgMMT4dPass
       OwningRewritePatternList patterns(&getContext());
       linalg::TensorExpandShapeOp::getCanonicalizationPatterns(patterns,
                                                                context);
-      patterns.insert<FoldFillGenericOpPattern>(context);
+      patterns.insert<FoldConstantTransposeGenericOpPattern,
+                      FoldFillGenericOpPattern>(context);
       (void)applyPatternsAndFoldGreedily(getOperation(), std::move(patterns));
     }
   }
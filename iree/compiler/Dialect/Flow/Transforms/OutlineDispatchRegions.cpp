@@ -13,6 +13,7 @@
 #include "iree/compiler/Dialect/Shape/IR/ShapeOps.h"
 #include "iree/compiler/Dialect/Shape/IR/ShapeTypes.h"
 #include "llvm/Support/Debug.h"
+#include "mlir/Dialect/Linalg/IR/LinalgOps.h"
 #include "mlir/Dialect/StandardOps/IR/Ops.h"
 #include "mlir/IR/BlockAndValueMapping.h"
 #include "mlir/IR/Builders.h"
@@ -192,6 +193,73 @@ static mlir::FuncOp createWorkgroupFunc(Location loc, StringRef functionName,
   return funcOp;
 }
 
+// Estimates the scalar operations performed by |funcOp| as the iteration space
+// of each linalg op times the number of ops in its body. Loop bounds are taken
+// from the full static shapes of the dispatch tensors each op loads from so
+// that the estimate covers the whole dispatch even after tiling and
+// distribution. Returns None if the function contains no linalg ops or any
+// bound cannot be determined.
+static Optional<int64_t> estimateDispatchOpCount(mlir::FuncOp funcOp) {
+  int64_t totalOpCount = 0;
+  bool anyLinalgOps = false;
+  auto walkResult = funcOp.walk([&](linalg::LinalgOp linalgOp) {
+    anyLinalgOps = true;
+    SmallVector<int64_t, 4> loopBounds(linalgOp.getNumLoops(), -1);
+    for (OpOperand *opOperand : linalgOp.getInputAndOutputOperands()) {
+      auto loadOp = opOperand->get().getDefiningOp<DispatchTensorLoadOp>();
+      if (!loadOp) continue;
+      auto sourceType = loadOp.source().getType().cast<DispatchTensorType>();
+      AffineMap indexingMap = linalgOp.getTiedIndexingMap(opOperand);
+      if (!sourceType.hasStaticShape() ||
+          sourceType.getRank() != indexingMap.getNumResults()) {
+        continue;
+      }
+      for (auto expr : llvm::enumerate(indexingMap.getResults())) {
+        if (auto dimExpr = expr.value().dyn_cast<AffineDimExpr>()) {
+          loopBounds[dimExpr.getPosition()] =
+              sourceType.getDimSize(expr.index());
+        }
+      }
+    }
+    // All ops but the terminator (linalg.yield). Ops that only move data
+    // (such as fills of linalg.init_tensor results) are skipped.
+    int64_t bodyOpCount =
+        static_cast<int64_t>(linalgOp.getBlock()->getOperations().size()) - 1;
+    if (bodyOpCount <= 0) return WalkResult::advance();
+    int64_t iterationCount = 1;
+    for (int64_t loopBound : loopBounds) {
+      if (loopBound < 0) return WalkResult::interrupt();
+      iterationCount *= loopBound;
+    }
+    totalOpCount += iterationCount * bodyOpCount;
+    return WalkResult::advance();
+  });
+  if (!anyLinalgOps || walkResult.wasInterrupted()) return llvm::None;
+  return totalOpCount;
+}
+
+// Estimates the bytes of tensor data read and written by |funcOp| from the
+// types of its !flow.dispatch.tensor arguments. Read-write tensors are counted
+// twice. Returns None if any of the tensors are dynamically shaped.
+static Optional<int64_t> estimateDispatchByteCount(mlir::FuncOp funcOp) {
+  int64_t totalByteCount = 0;
+  for (auto argType : funcOp.getType().getInputs()) {
+    auto tensorType = argType.dyn_cast<DispatchTensorType>();
+    if (!tensorType) continue;
+    if (!tensorType.hasStaticShape() ||
+        !tensorType.getElementType().isIntOrFloat()) {
+      return llvm::None;
+    }
+    int64_t byteCount =
+        (tensorType.getNumElements() * tensorType.getElementTypeBitWidth() +
+         7) /
+        8;
+    if (tensorType.getAccess() == TensorAccess::ReadWrite) byteCount *= 2;
+    totalByteCount += byteCount;
+  }
+  return totalByteCount;
+}
+
 // Outlines a dispatch region into a flow.executable and replaces the region op
 // with a dispatch to that outlined executable.
 static LogicalResult outlineDispatchWorkgroupsOp(
@@ -211,12 +279,22 @@ static LogicalResult outlineDispatchWorkgroupsOp(
   executableOp.getOperation()->moveBefore(parentFuncOp);
   executableOp.setPrivate();
 
-  // Add executable entry point pointing at the function.
+  // Add executable entry point pointing at the function along with the static
+  // cost estimates of the dispatch, when they can be derived.
   OpBuilder builder(executableOp.body());
+  IntegerAttr estimatedOpsAttr;
+  if (auto opCount = estimateDispatchOpCount(workgroupFuncOp)) {
+    estimatedOpsAttr = builder.getI64IntegerAttr(*opCount);
+  }
+  IntegerAttr estimatedBytesAttr;
+  if (auto byteCount = estimateDispatchByteCount(workgroupFuncOp)) {
+    estimatedBytesAttr = builder.getI64IntegerAttr(*byteCount);
+  }
   auto entryPointOp = builder.create<DispatchEntryOp>(
       regionOp.getLoc(), builder.getStringAttr(workgroupFuncOp.getName()),
       builder.getSymbolRefAttr(workgroupFuncOp),
-      builder.getIndexAttr(regionOp.getWorkgroupRank()));
+      builder.getIndexAttr(regionOp.getWorkgroupRank()), estimatedOpsAttr,
+      estimatedBytesAttr);
 
   // Finally convert the dispatch region into a dispatch to the outlined func.
   return convertToDispatchOp(regionOp, executableOp, entryPointOp);
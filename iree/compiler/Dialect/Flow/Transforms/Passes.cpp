@@ -31,6 +31,13 @@ static llvm::cl::opt<bool> clTraceDispatchTensors(
         "Trace runtime input/output tensors for each dispatch function."),
     llvm::cl::init(false));
 
+static llvm::cl::opt<bool> clSummarizeDispatchTensors(
+    "iree-flow-summarize-dispatch-tensors",
+    llvm::cl::desc("Record statistics (min/max/NaN count/checksum) of the "
+                   "runtime input/output tensors of each dispatch function "
+                   "without printing them."),
+    llvm::cl::init(false));
+
 static llvm::cl::opt<bool> clDemoteF32ToF16(
     "iree-flow-demote-f32-to-f16",
     llvm::cl::desc("Convert all f32 ops and values into f16 counterparts "
@@ -60,6 +67,24 @@ static llvm::cl::opt<int> clLinalgOpsPaddingSize(
                    "flow-padding-size"),
     llvm::cl::init(4));
 
+static llvm::cl::opt<bool> clEnableTransposePropagation(
+    "iree-flow-enable-transpose-propagation",
+    llvm::cl::desc("Enable cancelling and moving transposes across "
+                   "elementwise ops and matmuls"),
+    llvm::cl::init(true));
+
+static llvm::cl::opt<bool> clQuantizeMatmulWeights(
+    "iree-flow-quantize-matmul-weights",
+    llvm::cl::desc("Quantize constant f32 matmul weights to int8 with "
+                   "per-block scales that are dequantized inside the matmul"),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<int64_t> clQuantizeMatmulWeightsBlockSize(
+    "iree-flow-quantize-matmul-weights-block-size",
+    llvm::cl::desc("Number of consecutive K elements of a weight column that "
+                   "share a quantization scale"),
+    llvm::cl::init(32));
+
 static llvm::cl::opt<bool> clEnableMatmulToMMT4d(
     "iree-flow-enable-matmul-to-mmt4d",
     llvm::cl::desc("Enable converting linalg.matmul into linalg.mmt4d"),
@@ -72,6 +97,20 @@ static llvm::cl::opt<bool> clEnableLinalgDetensorize(
     llvm::cl::desc("Enable detensorizing linalg ops to operate on primitives"),
     llvm::cl::init(false));
 
+static llvm::cl::opt<bool> clFuseTensorUpdatesIntoDispatches(
+    "iree-flow-fuse-tensor-updates-into-dispatches",
+    llvm::cl::desc("Fuse flow.tensor.update ops (such as from pads and "
+                   "concatenations) into the dispatches producing the update "
+                   "values to avoid copies between dispatches"),
+    llvm::cl::init(true));
+
+static llvm::cl::list<int64_t> clDispatchSpecializationBuckets(
+    "iree-flow-dispatch-specialization-buckets",
+    llvm::cl::desc("Dynamic dimension values (such as common batch sizes or "
+                   "sequence lengths) to emit specialized dispatches for in "
+                   "addition to the generic dispatch"),
+    llvm::cl::ZeroOrMore, llvm::cl::CommaSeparated);
+
 namespace mlir {
 namespace iree_compiler {
 namespace IREE {
@@ -88,6 +127,10 @@ void buildFlowTransformPassPipeline(OpPassManager &passManager) {
   passManager.addNestedPass<mlir::FuncOp>(mlir::createCanonicalizerPass());
   passManager.addNestedPass<mlir::FuncOp>(mlir::createCSEPass());
 
+  // Evaluate initializers that only compute on constants so that their results
+  // are stored in the module instead of being computed at load time.
+  passManager.addPass(IREE::Flow::createConstEvalGlobalInitializersPass());
+
   // Replaces variables with !shapex.ranked_shape types with individual
   // variables for each dimension. This allows for constant dimensions to be
   // DCE'd in following passes.
@@ -113,6 +156,11 @@ void buildFlowTransformPassPipeline(OpPassManager &passManager) {
     if (clEnableConvToImg2Col) {
       passManager.addNestedPass<FuncOp>(createConvertConv2DToImg2ColPass());
     }
+    // Quantize constant matmul weights before any padding hides them.
+    if (clQuantizeMatmulWeights) {
+      passManager.addNestedPass<FuncOp>(
+          createQuantizeMatmulWeightsPass(clQuantizeMatmulWeightsBlockSize));
+    }
     // Pad linalg op
     if (clEnablePaddingLinalgOps) {
       passManager.addNestedPass<FuncOp>(
@@ -133,6 +181,9 @@ void buildFlowTransformPassPipeline(OpPassManager &passManager) {
       mlir::createConvertElementwiseToLinalgPass());
   passManager.addNestedPass<mlir::FuncOp>(
       mlir::createLinalgFoldUnitExtentDimsPass());
+  if (clEnableTransposePropagation) {
+    passManager.addNestedPass<mlir::FuncOp>(createPropagateTransposesPass());
+  }
   passManager.addNestedPass<mlir::FuncOp>(createInterchangeGenericOpsPass());
   passManager.addNestedPass<mlir::FuncOp>(mlir::createCanonicalizerPass());
   passManager.addNestedPass<mlir::FuncOp>(createFusionOfTensorOpsPass());
@@ -158,6 +209,22 @@ void buildFlowTransformPassPipeline(OpPassManager &passManager) {
   // creates a lot of dead IR that needs to be cleaned up.
   passManager.addNestedPass<mlir::FuncOp>(mlir::createCanonicalizerPass());
 
+  // Write the results of dispatches feeding slice updates directly into the
+  // update targets instead of copying them after the dispatch.
+  if (clFuseTensorUpdatesIntoDispatches) {
+    passManager.addNestedPass<mlir::FuncOp>(
+        IREE::Flow::createFuseTensorUpdatesIntoDispatchesPass());
+  }
+
+  // Specialize dispatches over dynamic dimensions for common values so that
+  // they can be compiled with static shapes and selected at runtime.
+  if (!clDispatchSpecializationBuckets.empty()) {
+    passManager.addNestedPass<mlir::FuncOp>(
+        IREE::Flow::createSpecializeDispatchDynamicDimsPass(
+            llvm::to_vector<4>(clDispatchSpecializationBuckets)));
+    passManager.addNestedPass<mlir::FuncOp>(mlir::createCanonicalizerPass());
+  }
+
   // Outline the dispatch regions into their own functions wrapped in
   // executables.
   passManager.addPass(IREE::Flow::createOutlineDispatchRegionsPass());
@@ -189,6 +256,9 @@ void buildFlowTransformPassPipeline(OpPassManager &passManager) {
   if (clTraceDispatchTensors) {
     passManager.addNestedPass<mlir::FuncOp>(
         IREE::Flow::createInjectDispatchTracingPass());
+  } else if (clSummarizeDispatchTensors) {
+    passManager.addNestedPass<mlir::FuncOp>(
+        IREE::Flow::createInjectDispatchTracingPass(/*summarize=*/true));
   }
 
   //----------------------------------------------------------------------------
@@ -61,6 +61,10 @@ std::unique_ptr<OperationPass<FuncOp>>
 createConvertLinalgMatmulOpToLinalgMMT4dPass(int M0 = 4, int N0 = 4,
                                              int K0 = 4);
 
+/// Creates a pass that cancels transposes and moves them across elementwise
+/// ops and matmuls when that reduces the number of bytes transposed.
+std::unique_ptr<OperationPass<mlir::FuncOp>> createPropagateTransposesPass();
+
 /// Creates a pass to fuse Linalg operations on tensors.
 std::unique_ptr<Pass> createFusionOfTensorOpsPass();
 
@@ -74,6 +78,11 @@ std::unique_ptr<OperationPass<mlir::FuncOp>> createInterchangeGenericOpsPass();
 // outside of dispatch regions and could be represented as flow.tensor.* ops.
 std::unique_ptr<OperationPass<mlir::FuncOp>> createConvertTensorOpsPass();
 
+// Quantizes constant f32 matmul RHS operands to int8 with one scale per
+// |blockSize| K elements and dequantizes them inside the matmul.
+std::unique_ptr<OperationPass<mlir::FuncOp>> createQuantizeMatmulWeightsPass(
+    int64_t blockSize = 32);
+
 // Convert linalg.tensor operations to equivalent flow.tensor.* ops.
 // `runBeforeDispatchRegionFormation` controls whether to run before dispatch
 // region creation. If run after, it will catch operations that were left
@@ -91,6 +100,11 @@ std::unique_ptr<OperationPass<mlir::FuncOp>> createPromoteI1ToI8Pass();
 // this is maintained separately.
 std::unique_ptr<OperationPass<mlir::FuncOp>> createPromoteTensorLoadsPass();
 
+// Evaluates global initializers that only compute on constants at compile time
+// and replaces them with the resulting initial values.
+std::unique_ptr<OperationPass<mlir::ModuleOp>>
+createConstEvalGlobalInitializersPass();
+
 // Expands dynamic !shapex.ranked_shape dimensions in variables.
 std::unique_ptr<OperationPass<mlir::ModuleOp>>
 createExpandGlobalDynamicDimsPass();
@@ -108,12 +122,24 @@ std::unique_ptr<OperationPass<mlir::FuncOp>> createVerifyInputLegalityPass();
 std::unique_ptr<OperationPass<mlir::FuncOp>>
 createDispatchLinalgOnTensorsPass();
 
+// Fuses flow.tensor.update ops into the dispatches producing their update
+// values so that the dispatches write directly into the target slices.
+std::unique_ptr<OperationPass<mlir::FuncOp>>
+createFuseTensorUpdatesIntoDispatchesPass();
+
+// Specializes dispatches with a dynamic dimension for each of the |buckets|
+// values of the dimension, keeping the original dispatch as a fallback.
+std::unique_ptr<OperationPass<mlir::FuncOp>>
+createSpecializeDispatchDynamicDimsPass(ArrayRef<int64_t> buckets = {});
+
 // Outlines dispatch regions into executables.
 std::unique_ptr<OperationPass<mlir::ModuleOp>>
 createOutlineDispatchRegionsPass();
 
 // Injects tracing markers for dispatch operation tensor inputs and outputs.
-std::unique_ptr<OperationPass<mlir::FuncOp>> createInjectDispatchTracingPass();
+// When |summarize| is set only statistics of the tensors are recorded.
+std::unique_ptr<OperationPass<mlir::FuncOp>> createInjectDispatchTracingPass(
+    bool summarize = false);
 
 // Exports all functions and dispatch executables as `() -> ()` benchmark funcs.
 std::unique_ptr<OperationPass<mlir::ModuleOp>> createExportBenchmarkFuncsPass();
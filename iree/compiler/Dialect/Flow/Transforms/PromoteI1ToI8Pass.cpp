@@ -19,9 +19,34 @@ namespace Flow {
 
 namespace {
 
+// Packs the boolean |attr| eight elements per byte along the innermost
+// dimension. Element i of the innermost dimension is stored in bit (i % 8) of
+// byte (i / 8).
+static DenseElementsAttr packBoolElements(DenseIntElementsAttr attr,
+                                          Builder &builder) {
+  auto type = attr.getType();
+  SmallVector<int64_t> packedShape(type.getShape().begin(),
+                                   type.getShape().end());
+  packedShape.back() /= 8;
+  SmallVector<APInt> packedValues(type.getNumElements() / 8, APInt(8, 0));
+  int64_t i = 0;
+  for (bool value : attr.getValues<bool>()) {
+    if (value) packedValues[i / 8].setBit(i % 8);
+    ++i;
+  }
+  return DenseElementsAttr::get(
+      RankedTensorType::get(packedShape, builder.getIntegerType(8)),
+      packedValues);
+}
+
 // Legalizes boolean (i1) constants to i8 with a linalg.generic operation
 // downcasting to i1. This occurs as IREE does not currently support tightly
 // packing and unpacking i1 buffers.
+//
+// When the innermost dimension allows it the constant is stored bit-packed and
+// the linalg.generic extracts the bit for each element instead. Consumers such
+// as selects fuse with the unpacking so the 8x larger i8 form is never
+// materialized.
 class ConvertBoolConstantPattern : public OpRewritePattern<mlir::ConstantOp> {
  public:
   using OpRewritePattern<mlir::ConstantOp>::OpRewritePattern;
@@ -42,10 +67,21 @@ class ConvertBoolConstantPattern : public OpRewritePattern<mlir::ConstantOp> {
     DenseIntElementsAttr attr = op.value().dyn_cast<DenseIntElementsAttr>();
     if (!attr) return failure();
 
+    // Splats are already compact so only dense values are packed.
+    int64_t rank = resultTy.getRank();
+    bool packBits = !attr.isSplat() && resultTy.hasStaticShape() &&
+                    rank > 0 && resultTy.getShape().back() % 8 == 0;
+
     // Create a new ConstantOp that contains the same values as an int8.
-    auto newConst = rewriter.createOrFold<ConstantOp>(
-        loc, attr.mapValues(rewriter.getIntegerType(8),
-                            [&](APInt src) { return src.zext(8); }));
+    Value newConst;
+    if (packBits) {
+      newConst = rewriter.createOrFold<ConstantOp>(
+          loc, packBoolElements(attr, rewriter));
+    } else {
+      newConst = rewriter.createOrFold<ConstantOp>(
+          loc, attr.mapValues(rewriter.getIntegerType(8),
+                              [&](APInt src) { return src.zext(8); }));
+    }
 
     // We need to move the insertion to just before its first use case. This is
     // needed as it is possible we are reusing an existing ConstantOp
@@ -64,8 +100,18 @@ class ConvertBoolConstantPattern : public OpRewritePattern<mlir::ConstantOp> {
         resultTy.getElementType());
 
     SmallVector<AffineMap, 2> indexingMaps = {
-        rewriter.getMultiDimIdentityMap(resultTy.getRank()),
-        rewriter.getMultiDimIdentityMap(resultTy.getRank())};
+        rewriter.getMultiDimIdentityMap(rank),
+        rewriter.getMultiDimIdentityMap(rank)};
+    if (packBits) {
+      // Each byte of the packed constant is shared by 8 consecutive elements.
+      SmallVector<AffineExpr> packedExprs;
+      for (int64_t i = 0; i < rank - 1; ++i) {
+        packedExprs.push_back(rewriter.getAffineDimExpr(i));
+      }
+      packedExprs.push_back(rewriter.getAffineDimExpr(rank - 1).floorDiv(8));
+      indexingMaps[0] =
+          AffineMap::get(rank, 0, packedExprs, rewriter.getContext());
+    }
 
     // Insert a generic op that Truncates the new i8 values to i1 for use as
     // the original value.
@@ -74,12 +120,25 @@ class ConvertBoolConstantPattern : public OpRewritePattern<mlir::ConstantOp> {
             .create<linalg::GenericOp>(
                 loc, TypeRange({resultTy}), ValueRange({newConst}),
                 ValueRange({initTensor}), indexingMaps,
-                SmallVector<StringRef>(resultTy.getRank(),
-                                       getParallelIteratorTypeName()),
+                SmallVector<StringRef>(rank, getParallelIteratorTypeName()),
                 [&](OpBuilder &nestedBuilder, Location nestedLoc,
                     ValueRange blockArgs) {
+                  Value value = blockArgs[0];
+                  if (packBits) {
+                    // Shift the bit of this element down to bit 0.
+                    Value index =
+                        rewriter.create<linalg::IndexOp>(nestedLoc, rank - 1);
+                    Value bitsPerByte =
+                        rewriter.create<ConstantIndexOp>(nestedLoc, 8);
+                    Value bit = rewriter.create<UnsignedRemIOp>(
+                        nestedLoc, index, bitsPerByte);
+                    Value shift = rewriter.create<IndexCastOp>(
+                        nestedLoc, rewriter.getIntegerType(8), bit);
+                    value = rewriter.create<UnsignedShiftRightOp>(
+                        nestedLoc, value, shift);
+                  }
                   auto cast = rewriter.create<TruncateIOp>(
-                      nestedLoc, rewriter.getIntegerType(1), blockArgs[0]);
+                      nestedLoc, rewriter.getIntegerType(1), value);
                   rewriter.create<linalg::YieldOp>(nestedLoc,
                                                    cast->getResult(0));
                 })
@@ -0,0 +1,405 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+//===--------------- PropagateTransposes.cpp ------------------------------===//
+//
+// Moves transposes (copy-only linalg.generic ops with a permuted input) across
+// elementwise ops and matmuls so that they cancel each other out or end up on
+// the smaller side of an op. Each transpose that survives to dispatch region
+// formation either becomes its own memory-bound dispatch or a strided read in
+// its consumer, so every rewrite here only fires when it does not increase
+// the number of bytes transposed.
+//
+//===----------------------------------------------------------------------===//
+
+#include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
+#include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
+#include "mlir/Dialect/Linalg/IR/LinalgOps.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/Dialect/Utils/StructuredOpsUtils.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Flow {
+
+namespace {
+
+/// Returns the indexing map of the input of |genericOp| if it is a transpose:
+/// a copy of its single input indexed by a permutation of the loops into an
+/// output indexed by the loops themselves.
+static Optional<AffineMap> getTransposeMap(linalg::GenericOp genericOp) {
+  if (genericOp.getNumInputs() != 1 || genericOp.getNumOutputs() != 1) {
+    return llvm::None;
+  }
+  if (genericOp.getNumParallelLoops() != genericOp.getNumLoops()) {
+    return llvm::None;
+  }
+  auto yieldOp = cast<linalg::YieldOp>(genericOp.getBody()->getTerminator());
+  if (yieldOp.values().size() != 1) return llvm::None;
+  auto blockArg = yieldOp.values()[0].dyn_cast<BlockArgument>();
+  if (!blockArg || blockArg.getArgNumber() != 0) return llvm::None;
+  AffineMap inputMap =
+      genericOp.getTiedIndexingMap(genericOp.getInputOperand(0));
+  AffineMap outputMap =
+      genericOp.getTiedIndexingMap(genericOp.getOutputOperand(0));
+  if (!inputMap.isPermutation() || !outputMap.isIdentity()) return llvm::None;
+  return inputMap;
+}
+
+/// Returns the transpose producing |value| and its input map if any.
+static Optional<AffineMap> getTransposeMap(Value value,
+                                           linalg::GenericOp &transposeOp) {
+  transposeOp = value.getDefiningOp<linalg::GenericOp>();
+  if (!transposeOp) return llvm::None;
+  return getTransposeMap(transposeOp);
+}
+
+/// Returns true if |map| swaps the two dimensions of a 2D tensor.
+static bool is2DSwap(AffineMap map) {
+  return map.getNumResults() == 2 && map.getDimPosition(0) == 1 &&
+         map.getDimPosition(1) == 0;
+}
+
+/// Returns the number of bits in |type| or 0 if its shape is dynamic.
+static int64_t getStaticSizeInBits(Type type) {
+  auto shapedType = type.cast<ShapedType>();
+  if (!shapedType.hasStaticShape()) return 0;
+  return shapedType.getNumElements() * shapedType.getElementTypeBitWidth();
+}
+
+/// Creates a transpose of |source| reading it through |inputMap|.
+static Value createTranspose(OpBuilder &builder, Location loc, Value source,
+                             AffineMap inputMap) {
+  auto sourceType = source.getType().cast<RankedTensorType>();
+  unsigned rank = sourceType.getRank();
+  AffineMap loopToInput = inversePermutation(inputMap);
+  SmallVector<int64_t> shape;
+  SmallVector<Value> dynSizes;
+  for (unsigned i = 0; i < rank; ++i) {
+    unsigned inputDim = loopToInput.getDimPosition(i);
+    shape.push_back(sourceType.getDimSize(inputDim));
+    if (sourceType.isDynamicDim(inputDim)) {
+      dynSizes.push_back(builder.create<tensor::DimOp>(loc, source, inputDim));
+    }
+  }
+  Value initTensor = builder.create<linalg::InitTensorOp>(
+      loc, dynSizes, shape, sourceType.getElementType());
+  SmallVector<AffineMap> indexingMaps = {
+      inputMap, builder.getMultiDimIdentityMap(rank)};
+  SmallVector<StringRef> iteratorTypes(rank, getParallelIteratorTypeName());
+  auto transposeOp = builder.create<linalg::GenericOp>(
+      loc, initTensor.getType(), source, initTensor, indexingMaps,
+      iteratorTypes, [](OpBuilder &b, Location loc, ValueRange args) {
+        b.create<linalg::YieldOp>(loc, args[0]);
+      });
+  return transposeOp.getResult(0);
+}
+
+/// Creates a linalg.fill of the value filled by |fillOp| into a new tensor
+/// with the shape of its output read through |inputMap|.
+static Value createTransposedFill(OpBuilder &builder, Location loc,
+                                  linalg::FillOp fillOp, AffineMap inputMap) {
+  auto fillType = fillOp.output().getType().cast<RankedTensorType>();
+  AffineMap loopToInput = inversePermutation(inputMap);
+  SmallVector<int64_t> shape;
+  SmallVector<Value> dynSizes;
+  for (unsigned i = 0; i < fillType.getRank(); ++i) {
+    unsigned inputDim = loopToInput.getDimPosition(i);
+    shape.push_back(fillType.getDimSize(inputDim));
+    if (fillType.isDynamicDim(inputDim)) {
+      dynSizes.push_back(
+          builder.create<tensor::DimOp>(loc, fillOp.output(), inputDim));
+    }
+  }
+  Value initTensor = builder.create<linalg::InitTensorOp>(
+      loc, dynSizes, shape, fillType.getElementType());
+  return builder.create<linalg::FillOp>(loc, fillOp.value(), initTensor)
+      .getResult(0);
+}
+
+/// Folds transpose(transpose(x)) into a single transpose of x, or into x
+/// itself when the permutations cancel.
+struct ComposeTransposes : public OpRewritePattern<linalg::GenericOp> {
+  using OpRewritePattern<linalg::GenericOp>::OpRewritePattern;
+  LogicalResult matchAndRewrite(linalg::GenericOp genericOp,
+                                PatternRewriter &rewriter) const override {
+    Optional<AffineMap> outerMap = getTransposeMap(genericOp);
+    if (!outerMap) return failure();
+    linalg::GenericOp innerOp;
+    Optional<AffineMap> innerMap =
+        getTransposeMap(genericOp.getInputOperand(0)->get(), innerOp);
+    if (!innerMap) return failure();
+
+    Value source = innerOp.getInputOperand(0)->get();
+    AffineMap composedMap = innerMap->compose(*outerMap);
+    if (composedMap.isIdentity()) {
+      rewriter.replaceOp(genericOp, source);
+      return success();
+    }
+    rewriter.replaceOp(genericOp, createTranspose(rewriter, genericOp.getLoc(),
+                                                  source, composedMap));
+    return success();
+  }
+};
+
+/// Sinks transposes of all the tensor operands of an elementwise op below it:
+///
+///   f(transpose(x), transpose(y)) -> transpose(f(x, y))
+///
+/// This replaces one transpose per operand with a single one on the result
+/// where it may cancel with a transpose of the consumer.
+struct SinkTransposesBelowElementwise
+    : public OpRewritePattern<linalg::GenericOp> {
+  using OpRewritePattern<linalg::GenericOp>::OpRewritePattern;
+  LogicalResult matchAndRewrite(linalg::GenericOp genericOp,
+                                PatternRewriter &rewriter) const override {
+    if (getTransposeMap(genericOp)) return failure();
+    if (genericOp.getNumOutputs() != 1) return failure();
+    if (genericOp.getNumParallelLoops() != genericOp.getNumLoops()) {
+      return failure();
+    }
+    OpOperand *outputOperand = genericOp.getOutputOperand(0);
+    if (!genericOp.getTiedIndexingMap(outputOperand).isIdentity()) {
+      return failure();
+    }
+    if (!genericOp.getBody()->getArguments().back().use_empty()) {
+      return failure();
+    }
+    if (!genericOp.getBody()->getOps<linalg::IndexOp>().empty()) {
+      return failure();
+    }
+
+    // All tensor operands must be transposed the same way and read in the
+    // iteration order; scalars are forwarded as is.
+    Optional<AffineMap> transposeMap;
+    SmallVector<Value> newInputs;
+    SmallVector<AffineMap> newIndexingMaps;
+    SmallPtrSet<Operation *, 4> transposeOps;
+    int64_t inputBitWidth = 0;
+    for (OpOperand *inputOperand : genericOp.getInputOperands()) {
+      AffineMap indexingMap = genericOp.getTiedIndexingMap(inputOperand);
+      if (!inputOperand->get().getType().isa<ShapedType>()) {
+        newInputs.push_back(inputOperand->get());
+        newIndexingMaps.push_back(indexingMap);
+        continue;
+      }
+      linalg::GenericOp transposeOp;
+      Optional<AffineMap> map =
+          getTransposeMap(inputOperand->get(), transposeOp);
+      if (!map || !indexingMap.isIdentity()) return failure();
+      if (transposeMap && *transposeMap != *map) return failure();
+      transposeMap = map;
+      newInputs.push_back(transposeOp.getInputOperand(0)->get());
+      newIndexingMaps.push_back(indexingMap);
+      if (transposeOps.insert(transposeOp).second) {
+        inputBitWidth += inputOperand->get()
+                             .getType()
+                             .cast<ShapedType>()
+                             .getElementTypeBitWidth();
+      }
+    }
+    if (!transposeMap) return failure();
+
+    // Only sink when the transposes go away and the result is not wider than
+    // what they moved.
+    for (Operation *transposeOp : transposeOps) {
+      if (llvm::any_of(transposeOp->getUsers(), [&](Operation *user) {
+            return user != genericOp.getOperation();
+          })) {
+        return failure();
+      }
+    }
+    auto resultType = genericOp.getResult(0).getType().cast<RankedTensorType>();
+    if (resultType.getElementTypeBitWidth() > inputBitWidth) return failure();
+
+    // The result is computed in the layout of the untransposed operands.
+    Location loc = genericOp.getLoc();
+    Value source = *llvm::find_if(
+        newInputs, [](Value v) { return v.getType().isa<ShapedType>(); });
+    auto sourceType = source.getType().cast<RankedTensorType>();
+    SmallVector<Value> dynSizes;
+    for (unsigned i = 0; i < sourceType.getRank(); ++i) {
+      if (sourceType.isDynamicDim(i)) {
+        dynSizes.push_back(rewriter.create<tensor::DimOp>(loc, source, i));
+      }
+    }
+    Value initTensor = rewriter.create<linalg::InitTensorOp>(
+        loc, dynSizes, sourceType.getShape(), resultType.getElementType());
+    newIndexingMaps.push_back(
+        rewriter.getMultiDimIdentityMap(sourceType.getRank()));
+    auto iteratorTypes = llvm::to_vector<4>(
+        genericOp.iterator_types().getAsValueRange<StringAttr>());
+    auto newOp = rewriter.create<linalg::GenericOp>(
+        loc, initTensor.getType(), newInputs, initTensor, newIndexingMaps,
+        iteratorTypes);
+    rewriter.cloneRegionBefore(genericOp.region(), newOp.region(),
+                               newOp.region().begin());
+    rewriter.replaceOp(genericOp, createTranspose(rewriter, loc,
+                                                  newOp.getResult(0),
+                                                  *transposeMap));
+    return success();
+  }
+};
+
+/// Rewrites transpose(matmul(A, B)) into matmul(B^T, A^T) when operands that
+/// are themselves transposes cancel out enough to move fewer bytes:
+///
+///   transpose(matmul(transpose(X), transpose(Y))) -> matmul(Y, X)
+struct TransposeMatmulOperands : public OpRewritePattern<linalg::GenericOp> {
+  using OpRewritePattern<linalg::GenericOp>::OpRewritePattern;
+  LogicalResult matchAndRewrite(linalg::GenericOp genericOp,
+                                PatternRewriter &rewriter) const override {
+    Optional<AffineMap> outerMap = getTransposeMap(genericOp);
+    if (!outerMap || !is2DSwap(*outerMap)) return failure();
+    Value result = genericOp.getInputOperand(0)->get();
+    auto matmulOp = result.getDefiningOp<linalg::MatmulOp>();
+    if (!matmulOp || !matmulOp.hasTensorSemantics() || !result.hasOneUse()) {
+      return failure();
+    }
+    auto fillOp =
+        matmulOp.getOutputOperand(0)->get().getDefiningOp<linalg::FillOp>();
+    if (!fillOp) return failure();
+
+    // Transposing an operand that is already a transpose is free and removes
+    // that transpose if this is its only use.
+    int64_t removedBits = getStaticSizeInBits(result.getType());
+    int64_t addedBits = 0;
+    bool hasDynamicAdditions = false;
+    SmallVector<Value, 2> transposedOperands;
+    for (OpOperand *operand : matmulOp.getInputOperands()) {
+      Value value = operand->get();
+      linalg::GenericOp transposeOp;
+      Optional<AffineMap> map = getTransposeMap(value, transposeOp);
+      if (map && is2DSwap(*map)) {
+        transposedOperands.push_back(transposeOp.getInputOperand(0)->get());
+        if (value.hasOneUse()) {
+          removedBits += getStaticSizeInBits(value.getType());
+        }
+        continue;
+      }
+      transposedOperands.push_back(Value());
+      int64_t bits = getStaticSizeInBits(value.getType());
+      if (!bits) hasDynamicAdditions = true;
+      addedBits += bits;
+    }
+    if (hasDynamicAdditions) return failure();
+    if (addedBits && addedBits >= removedBits) return failure();
+
+    Location loc = genericOp.getLoc();
+    for (auto operand : llvm::enumerate(matmulOp.getInputOperands())) {
+      if (transposedOperands[operand.index()]) continue;
+      transposedOperands[operand.index()] =
+          createTranspose(rewriter, loc, operand.value()->get(), *outerMap);
+    }
+    Value init = createTransposedFill(rewriter, loc, fillOp, *outerMap);
+    rewriter.replaceOpWithNewOp<linalg::MatmulOp>(
+        genericOp, genericOp.getResultTypes(),
+        ValueRange{transposedOperands[1], transposedOperands[0]},
+        ValueRange{init});
+    return success();
+  }
+};
+
+/// Rewrites matmul(transpose(X), transpose(Y)) into transpose(matmul(Y, X))
+/// when the result is smaller than the two transposed operands.
+struct HoistTransposesAboveMatmul : public OpRewritePattern<linalg::MatmulOp> {
+  using OpRewritePattern<linalg::MatmulOp>::OpRewritePattern;
+  LogicalResult matchAndRewrite(linalg::MatmulOp matmulOp,
+                                PatternRewriter &rewriter) const override {
+    if (!matmulOp.hasTensorSemantics()) return failure();
+    auto fillOp =
+        matmulOp.getOutputOperand(0)->get().getDefiningOp<linalg::FillOp>();
+    if (!fillOp) return failure();
+
+    int64_t removedBits = 0;
+    SmallVector<Value, 2> sources;
+    Optional<AffineMap> map;
+    for (OpOperand *operand : matmulOp.getInputOperands()) {
+      Value value = operand->get();
+      linalg::GenericOp transposeOp;
+      map = getTransposeMap(value, transposeOp);
+      if (!map || !is2DSwap(*map) || !value.hasOneUse()) return failure();
+      sources.push_back(transposeOp.getInputOperand(0)->get());
+      removedBits += getStaticSizeInBits(value.getType());
+    }
+    Value result = matmulOp->getResult(0);
+    int64_t addedBits = getStaticSizeInBits(result.getType());
+    if (!addedBits || addedBits >= removedBits) return failure();
+
+    Location loc = matmulOp.getLoc();
+    Value init = createTransposedFill(rewriter, loc, fillOp, *map);
+    auto newMatmulOp = rewriter.create<linalg::MatmulOp>(
+        loc, init.getType(), ValueRange{sources[1], sources[0]},
+        ValueRange{init});
+    rewriter.replaceOp(matmulOp, createTranspose(rewriter, loc,
+                                                 newMatmulOp->getResult(0),
+                                                 *map));
+    return success();
+  }
+};
+
+struct PropagateTransposesPass
+    : public PropagateTransposesBase<PropagateTransposesPass> {
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<linalg::LinalgDialect, tensor::TensorDialect>();
+  }
+  PropagateTransposesPass() = default;
+  PropagateTransposesPass(const PropagateTransposesPass &pass) {}
+
+  void runOnOperation() override {
+    int64_t transposesBefore = 0, bitsBefore = 0;
+    countTransposes(transposesBefore, bitsBefore);
+
+    OwningRewritePatternList patterns(&getContext());
+    patterns.insert<ComposeTransposes, HoistTransposesAboveMatmul,
+                    SinkTransposesBelowElementwise, TransposeMatmulOperands>(
+        &getContext());
+    if (failed(applyPatternsAndFoldGreedily(getOperation(),
+                                            std::move(patterns)))) {
+      return signalPassFailure();
+    }
+
+    int64_t transposesAfter = 0, bitsAfter = 0;
+    countTransposes(transposesAfter, bitsAfter);
+    numTransposesEliminated = std::max<int64_t>(
+        0, transposesBefore - transposesAfter);
+    numBytesEliminated = std::max<int64_t>(0, (bitsBefore - bitsAfter) / 8);
+  }
+
+ private:
+  /// Counts the transposes in the function and the static size in bits of
+  /// the tensors they produce.
+  void countTransposes(int64_t &count, int64_t &bits) {
+    getOperation().walk([&](linalg::GenericOp genericOp) {
+      if (!genericOp.hasTensorSemantics() || !getTransposeMap(genericOp)) {
+        return;
+      }
+      ++count;
+      bits += getStaticSizeInBits(genericOp.getResult(0).getType());
+    });
+  }
+
+  Statistic numTransposesEliminated{this, "num-transposes-eliminated",
+                                    "Number of transposes eliminated"};
+  Statistic numBytesEliminated{
+      this, "transpose-bytes-eliminated",
+      "Number of bytes no longer written by transposes (static shapes only)"};
+};
+
+}  // namespace
+
+std::unique_ptr<OperationPass<mlir::FuncOp>> createPropagateTransposesPass() {
+  return std::make_unique<PropagateTransposesPass>();
+}
+
+}  // namespace Flow
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
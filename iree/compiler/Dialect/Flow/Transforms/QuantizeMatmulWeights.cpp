@@ -0,0 +1,159 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <algorithm>
+#include <cmath>
+
+#include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
+#include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
+#include "mlir/Dialect/Linalg/IR/LinalgOps.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/Dialect/Utils/StructuredOpsUtils.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/IR/TypeUtilities.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Flow {
+
+namespace {
+
+/// Converts a linalg.matmul with a constant f32 RHS into a linalg.generic that
+/// reads the RHS as symmetric int8 values with one f32 scale per block of
+/// `blockSize` consecutive K elements of each column:
+///
+///   C[m, n] += A[m, k] * (sitofp(Q[k, n]) * S[k floordiv blockSize, n])
+///
+/// The weights are dequantized in registers inside the matmul so the dispatch
+/// streams a quarter of the weight bytes. The RHS is quantized per column if K
+/// is not a multiple of `blockSize`.
+class QuantizeMatmulWeightsPattern
+    : public OpRewritePattern<linalg::MatmulOp> {
+ public:
+  QuantizeMatmulWeightsPattern(MLIRContext *context, int64_t blockSize)
+      : OpRewritePattern<linalg::MatmulOp>(context), blockSize(blockSize) {}
+
+  LogicalResult matchAndRewrite(linalg::MatmulOp matmulOp,
+                                PatternRewriter &rewriter) const override {
+    Location loc = matmulOp.getLoc();
+    Value lhs = matmulOp.inputs()[0];
+    Value rhs = matmulOp.inputs()[1];
+    Value output = matmulOp.outputs()[0];
+
+    DenseFPElementsAttr rhsAttr;
+    if (!matchPattern(rhs, m_Constant(&rhsAttr))) return failure();
+    auto rhsType = rhsAttr.getType().cast<ShapedType>();
+    if (!rhsType.hasStaticShape() || !rhsType.getElementType().isF32() ||
+        !getElementTypeOrSelf(lhs.getType()).isF32() ||
+        !getElementTypeOrSelf(output.getType()).isF32()) {
+      return failure();
+    }
+
+    int64_t K = rhsType.getDimSize(0);
+    int64_t N = rhsType.getDimSize(1);
+    int64_t blockK = K % blockSize == 0 ? blockSize : K;
+    int64_t blockCount = K / blockK;
+
+    // Symmetric quantization: the scale maps the largest magnitude of each
+    // block to 127.
+    auto rhsValues = rhsAttr.getValues<float>();
+    SmallVector<float> values(rhsValues.begin(), rhsValues.end());
+    SmallVector<float> scales(blockCount * N);
+    SmallVector<int8_t> quantizedValues(K * N);
+    for (int64_t block = 0; block < blockCount; ++block) {
+      for (int64_t n = 0; n < N; ++n) {
+        float maxAbs = 0.0f;
+        for (int64_t k = block * blockK; k < (block + 1) * blockK; ++k) {
+          maxAbs = std::max(maxAbs, std::fabs(values[k * N + n]));
+        }
+        float scale = maxAbs > 0.0f ? maxAbs / 127.0f : 1.0f;
+        scales[block * N + n] = scale;
+        for (int64_t k = block * blockK; k < (block + 1) * blockK; ++k) {
+          float quantized = std::round(values[k * N + n] / scale);
+          quantized = std::min(127.0f, std::max(-127.0f, quantized));
+          quantizedValues[k * N + n] = static_cast<int8_t>(quantized);
+        }
+      }
+    }
+    Value quantizedRhs = rewriter.create<ConstantOp>(
+        loc, DenseElementsAttr::get(
+                 RankedTensorType::get({K, N}, rewriter.getIntegerType(8)),
+                 llvm::makeArrayRef(quantizedValues)));
+    Value rhsScales = rewriter.create<ConstantOp>(
+        loc, DenseElementsAttr::get(
+                 RankedTensorType::get({blockCount, N}, rewriter.getF32Type()),
+                 llvm::makeArrayRef(scales)));
+
+    MLIRContext *context = rewriter.getContext();
+    AffineExpr m, n, k;
+    bindDims(context, m, n, k);
+    SmallVector<AffineMap> indexingMaps = {
+        AffineMap::get(3, 0, {m, k}, context),
+        AffineMap::get(3, 0, {k, n}, context),
+        AffineMap::get(3, 0, {k.floorDiv(blockK), n}, context),
+        AffineMap::get(3, 0, {m, n}, context)};
+    SmallVector<StringRef> iteratorTypes = {getParallelIteratorTypeName(),
+                                            getParallelIteratorTypeName(),
+                                            getReductionIteratorTypeName()};
+    rewriter.replaceOpWithNewOp<linalg::GenericOp>(
+        matmulOp, output.getType(), ValueRange{lhs, quantizedRhs, rhsScales},
+        output, indexingMaps, iteratorTypes,
+        [&](OpBuilder &b, Location loc, ValueRange args) {
+          Value weight =
+              b.create<SIToFPOp>(loc, b.getF32Type(), args[1]).getResult();
+          weight = b.create<MulFOp>(loc, weight, args[2]);
+          Value product = b.create<MulFOp>(loc, args[0], weight);
+          b.create<linalg::YieldOp>(
+              loc, b.create<AddFOp>(loc, args[3], product).getResult());
+        });
+    return success();
+  }
+
+ private:
+  int64_t blockSize;
+};
+
+class QuantizeMatmulWeightsPass
+    : public QuantizeMatmulWeightsBase<QuantizeMatmulWeightsPass> {
+ public:
+  QuantizeMatmulWeightsPass(int64_t blockSize) {
+    this->blockSize = blockSize;
+  }
+  QuantizeMatmulWeightsPass(const QuantizeMatmulWeightsPass &that) {
+    this->blockSize = that.blockSize;
+  }
+
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<linalg::LinalgDialect, mlir::StandardOpsDialect>();
+  }
+
+  void runOnOperation() override {
+    if (blockSize <= 0) {
+      getOperation().emitError() << "block size must be positive";
+      return signalPassFailure();
+    }
+    MLIRContext *context = &getContext();
+    OwningRewritePatternList patterns(context);
+    patterns.insert<QuantizeMatmulWeightsPattern>(context, blockSize);
+    (void)applyPatternsAndFoldGreedily(getOperation(), std::move(patterns));
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<OperationPass<mlir::FuncOp>> createQuantizeMatmulWeightsPass(
+    int64_t blockSize) {
+  return std::make_unique<QuantizeMatmulWeightsPass>(blockSize);
+}
+
+}  // namespace Flow
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
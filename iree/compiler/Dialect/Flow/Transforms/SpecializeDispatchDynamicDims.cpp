@@ -0,0 +1,177 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/Flow/IR/FlowOps.h"
+#include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
+#include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
+#include "iree/compiler/Dialect/Shape/IR/ShapeOps.h"
+#include "iree/compiler/Dialect/Shape/IR/ShapeTypes.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/Pass/Pass.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Flow {
+
+namespace {
+
+// Returns the dynamic dimension value the dispatch is specialized on, if any.
+// This is the first index operand that is not a constant; dispatches over data
+// with a dynamic batch or sequence length have it as their first dimension.
+static Value getSpecializationDim(DispatchWorkgroupsOp dispatchOp) {
+  for (auto operand : dispatchOp.operands()) {
+    if (!operand.getType().isIndex()) continue;
+    if (matchPattern(operand, m_Constant())) continue;
+    return operand;
+  }
+  return {};
+}
+
+// Clones |dispatchOp| at the current insertion point of |builder| with all
+// uses of |dim| (both as operands and within the dispatch region) replaced by
+// |value|.
+static DispatchWorkgroupsOp cloneSpecializedDispatch(
+    DispatchWorkgroupsOp dispatchOp, Value dim, int64_t value,
+    OpBuilder &builder) {
+  auto loc = dispatchOp.getLoc();
+  Value outerValue = builder.create<ConstantIndexOp>(loc, value);
+  auto clonedOp = cast<DispatchWorkgroupsOp>(builder.clone(*dispatchOp));
+
+  // Replace the region arguments carrying the dimension first as the index of
+  // the operands they correspond to is lost once they are replaced.
+  Block &entryBlock = clonedOp.body().front();
+  auto regionBuilder = OpBuilder::atBlockBegin(&entryBlock);
+  Value innerValue;
+  for (auto operand : llvm::enumerate(clonedOp.operands())) {
+    if (operand.value() != dim) continue;
+    if (!innerValue) {
+      innerValue = regionBuilder.create<ConstantIndexOp>(loc, value);
+    }
+    entryBlock.getArgument(operand.index()).replaceAllUsesWith(innerValue);
+  }
+
+  for (auto &opOperand : clonedOp->getOpOperands()) {
+    if (opOperand.get() == dim) opOperand.set(outerValue);
+  }
+  return clonedOp;
+}
+
+// Specializes |dispatchOp| for each of the |buckets| values of |dim|. Each
+// variant is predicated on |dim| matching its value and the original dispatch
+// is kept as the fallback for all other values:
+//   if dim == bucket_0:
+//     <dispatch specialized for bucket_0>
+//   else if dim == bucket_1:
+//     <dispatch specialized for bucket_1>
+//   else:
+//     <original dispatch>
+static void specializeDispatch(DispatchWorkgroupsOp dispatchOp, Value dim,
+                               ArrayRef<int64_t> buckets) {
+  auto loc = dispatchOp.getLoc();
+
+  // Split the block such that the dispatch is alone in its own block (the
+  // fallback) and all ops after it are in the join block.
+  auto *beforeBlock = dispatchOp->getBlock();
+  auto *fallbackBlock = beforeBlock->splitBlock(dispatchOp);
+  auto *joinBlock =
+      fallbackBlock->splitBlock(std::next(dispatchOp->getIterator()));
+  auto joinValues = llvm::to_vector<4>(
+      joinBlock->addArguments(dispatchOp.getResultTypes()));
+
+  // Tie the dynamic shapes of the joined results so that their dimensions can
+  // still be resolved.
+  OpBuilder builder = OpBuilder::atBlockBegin(joinBlock);
+  auto resultDims = dispatchOp.result_dims();
+  for (auto result : llvm::enumerate(dispatchOp.getResults())) {
+    Value joinValue = joinValues[result.index()];
+    auto tensorType = result.value().getType().dyn_cast<RankedTensorType>();
+    if (tensorType && !tensorType.hasStaticShape()) {
+      unsigned numDynamicDims = tensorType.getNumDynamicDims();
+      auto shapeValue = builder.create<Shape::MakeRankedShapeOp>(
+          loc, Shape::RankedShapeType::get(tensorType.getShape(),
+                                           builder.getContext()),
+          resultDims.take_front(numDynamicDims));
+      resultDims = resultDims.drop_front(numDynamicDims);
+      joinValue = builder.create<Shape::TieShapeOp>(loc, tensorType, joinValue,
+                                                    shapeValue);
+    }
+    result.value().replaceAllUsesWith(joinValue);
+  }
+  builder.setInsertionPointToEnd(fallbackBlock);
+  builder.create<BranchOp>(loc, joinBlock, dispatchOp.getResults());
+
+  // Build the chain of conditions, each falling through to the next and the
+  // last to the fallback.
+  for (auto bucket : llvm::enumerate(buckets)) {
+    auto *matchBlock = builder.createBlock(fallbackBlock);
+    auto *nextBlock = bucket.index() + 1 < buckets.size()
+                          ? builder.createBlock(fallbackBlock)
+                          : fallbackBlock;
+
+    builder.setInsertionPointToEnd(beforeBlock);
+    auto bucketValue = builder.create<ConstantIndexOp>(loc, bucket.value());
+    auto isMatch =
+        builder.create<CmpIOp>(loc, CmpIPredicate::eq, dim, bucketValue);
+    builder.create<CondBranchOp>(loc, isMatch, matchBlock, nextBlock);
+
+    builder.setInsertionPointToEnd(matchBlock);
+    auto specializedOp =
+        cloneSpecializedDispatch(dispatchOp, dim, bucket.value(), builder);
+    builder.create<BranchOp>(loc, joinBlock, specializedOp.getResults());
+
+    beforeBlock = nextBlock;
+  }
+}
+
+class SpecializeDispatchDynamicDimsPass
+    : public SpecializeDispatchDynamicDimsBase<
+          SpecializeDispatchDynamicDimsPass> {
+ public:
+  SpecializeDispatchDynamicDimsPass() = default;
+  SpecializeDispatchDynamicDimsPass(
+      const SpecializeDispatchDynamicDimsPass &pass) {}
+  SpecializeDispatchDynamicDimsPass(ArrayRef<int64_t> buckets) {
+    this->buckets = buckets;
+  }
+
+  void runOnOperation() override {
+    if (buckets.empty()) return;
+    SmallVector<int64_t> uniqueBuckets;
+    for (int64_t bucket : buckets) {
+      if (!llvm::is_contained(uniqueBuckets, bucket)) {
+        uniqueBuckets.push_back(bucket);
+      }
+    }
+
+    // Gather first as specialization clones dispatches. Only dispatches
+    // directly within the function CFG can be branched around.
+    SmallVector<std::pair<DispatchWorkgroupsOp, Value>> dispatchOps;
+    getOperation().walk([&](DispatchWorkgroupsOp dispatchOp) {
+      if (dispatchOp->getParentOp() != getOperation()) return;
+      if (auto dim = getSpecializationDim(dispatchOp)) {
+        dispatchOps.push_back({dispatchOp, dim});
+      }
+    });
+    for (auto it : dispatchOps) {
+      specializeDispatch(it.first, it.second, uniqueBuckets);
+    }
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<OperationPass<mlir::FuncOp>>
+createSpecializeDispatchDynamicDimsPass(ArrayRef<int64_t> buckets) {
+  return std::make_unique<SpecializeDispatchDynamicDimsPass>(buckets);
+}
+
+}  // namespace Flow
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
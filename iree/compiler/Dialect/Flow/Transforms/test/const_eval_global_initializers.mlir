@@ -0,0 +1,50 @@
+// RUN: iree-opt -split-input-file -iree-flow-const-eval-global-initializers %s | IreeFileCheck %s
+
+// CHECK: util.global private @transposed = dense<{{\[\[}}1, 4], [2, 5], [3, 6]]> : tensor<3x2xi32>
+// CHECK-NOT: func private @transposed_initializer
+util.global private @transposed initializer(@transposed_initializer) : tensor<3x2xi32>
+func private @transposed_initializer() -> tensor<3x2xi32> {
+  %cst = constant dense<[[1, 2, 3], [4, 5, 6]]> : tensor<2x3xi32>
+  %0 = linalg.init_tensor [3, 2] : tensor<3x2xi32>
+  %1 = linalg.generic {
+      indexing_maps = [affine_map<(d0, d1) -> (d1, d0)>, affine_map<(d0, d1) -> (d0, d1)>],
+      iterator_types = ["parallel", "parallel"]}
+      ins(%cst : tensor<2x3xi32>) outs(%0 : tensor<3x2xi32>) {
+  ^bb0(%arg0: i32, %arg1: i32):
+    linalg.yield %arg0 : i32
+  } -> tensor<3x2xi32>
+  return %1 : tensor<3x2xi32>
+}
+
+// -----
+
+// Elementwise math and reductions are evaluated by folding the scalar ops.
+
+// CHECK: util.global private @reduced = dense<[3.000000e+00, 7.000000e+00]> : tensor<2xf32>
+util.global private @reduced initializer(@reduced_initializer) : tensor<2xf32>
+func private @reduced_initializer() -> tensor<2xf32> {
+  %cst = constant dense<[[1.0, 2.0], [3.0, 4.0]]> : tensor<2x2xf32>
+  %0 = linalg.init_tensor [2] : tensor<2xf32>
+  %1 = linalg.generic {
+      indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>, affine_map<(d0, d1) -> (d0)>],
+      iterator_types = ["parallel", "reduction"]}
+      ins(%cst : tensor<2x2xf32>) outs(%0 : tensor<2xf32>) {
+  ^bb0(%arg0: f32, %arg1: f32):
+    %2 = addf %arg0, %arg1 : f32
+    linalg.yield %2 : f32
+  } -> tensor<2xf32>
+  return %1 : tensor<2xf32>
+}
+
+// -----
+
+// Initializers depending on runtime values are left as-is.
+
+// CHECK: util.global private @runtime initializer(@runtime_initializer) : tensor<4xf32>
+// CHECK: func private @runtime_initializer
+util.global private mutable @state : tensor<4xf32>
+util.global private @runtime initializer(@runtime_initializer) : tensor<4xf32>
+func private @runtime_initializer() -> tensor<4xf32> {
+  %0 = util.global.load @state : tensor<4xf32>
+  return %0 : tensor<4xf32>
+}
@@ -929,6 +929,33 @@ func @scatter(
 
 // -----
 
+func @scatter_overwrite(
+    %original : tensor<?x?xf32>, %indices : tensor<?x1xi32>,
+    %update : tensor<?x?xf32>) -> tensor<?x?xf32> {
+  %0 = linalg_ext.scatter
+      ins(%update, %indices : tensor<?x?xf32>, tensor<?x1xi32>)
+      outs(%original : tensor<?x?xf32>) {
+      ^bb0(%arg0: f32, %arg1: f32):
+        linalg_ext.yield %arg0 : f32
+  } -> tensor<?x?xf32>
+  return %0 : tensor<?x?xf32>
+}
+//      CHECK: func @scatter_overwrite(
+// CHECK-SAME:     %[[ARG0:[a-zA-Z0-9_]+]]: tensor<?x?xf32>
+// CHECK-SAME:     %[[ARG1:[a-zA-Z0-9_]+]]: tensor<?x1xi32>
+// CHECK-SAME:     %[[ARG2:[a-zA-Z0-9_]+]]: tensor<?x?xf32>
+//  CHECK-DAG:   %[[C1:.+]] = constant 1 : index
+//  CHECK-DAG:   %[[WORKLOADX:.+]] = tensor.dim %[[ARG2]], %[[C1]]
+//      CHECK:   %[[RESULT:.+]] = flow.dispatch.workgroups[%[[WORKLOADX]], %[[C1]], %[[C1]]]
+//  CHECK-NOT:       flow.dispatch.workgroup.id[1]
+//      CHECK:       scf.for
+//  CHECK-NOT:       scf.for
+//      CHECK:         linalg_ext.scatter
+// CHECK-SAME:             {__internal_linalg_transform__ = "workgroup"}
+//      CHECK:   return %[[RESULT]] : tensor<?x?xf32>
+
+// -----
+
 func @sort_3d(%arg0: tensor<?x?x?xi32>, %arg1 : tensor<?x?x?xf32>)
     -> (tensor<?x?x?xi32>, tensor<?x?x?xf32>) {
   %0, %1 = linalg_ext.sort dimension(0)
@@ -115,3 +115,90 @@ func @dont_fuse_conv2d_with_non_identity_map(%input: tensor<1x225x225x16xf32>, %
 
 // CHECK: flow.dispatch.workgroups
 // CHECK:       linalg.generic
+
+// -----
+
+func @fuse_matmul_epilogue_chain(%lhs: tensor<128x64xf32>, %rhs: tensor<64x256xf32>, %bias: tensor<256xf32>) -> tensor<128x256xf32> {
+  %cst = constant 0.000000e+00 : f32
+  %0 = linalg.init_tensor [128, 256] : tensor<128x256xf32>
+  %1 = linalg.fill(%cst, %0) : f32, tensor<128x256xf32> -> tensor<128x256xf32>
+  %2 = linalg.matmul ins(%lhs, %rhs : tensor<128x64xf32>, tensor<64x256xf32>)
+         outs(%1 : tensor<128x256xf32>) -> tensor<128x256xf32>
+  %3 = linalg.generic {
+         indexing_maps = [
+           affine_map<(d0, d1) -> (d0, d1)>,
+           affine_map<(d0, d1) -> (d1)>,
+           affine_map<(d0, d1) -> (d0, d1)>],
+         iterator_types = ["parallel", "parallel"]}
+         ins(%2, %bias : tensor<128x256xf32>, tensor<256xf32>)
+         outs(%0 : tensor<128x256xf32>) {
+         ^bb0(%a: f32, %b: f32, %c: f32):
+            %add = addf %a, %b : f32
+            linalg.yield %add : f32
+         } -> tensor<128x256xf32>
+  %4 = linalg.generic {
+         indexing_maps = [
+           affine_map<(d0, d1) -> (d0, d1)>,
+           affine_map<(d0, d1) -> (d0, d1)>],
+         iterator_types = ["parallel", "parallel"]}
+         ins(%3 : tensor<128x256xf32>)
+         outs(%0 : tensor<128x256xf32>) {
+         ^bb0(%a: f32, %b: f32):
+            %max = maxf %a, %cst : f32
+            linalg.yield %max : f32
+         } -> tensor<128x256xf32>
+  return %4 : tensor<128x256xf32>
+}
+
+// Check that the bias add and the activation are both fused into the dispatch
+// of the matmul.
+
+// CHECK-LABEL: func @fuse_matmul_epilogue_chain
+
+//      CHECK: flow.dispatch.workgroups
+//      CHECK:   scf.for
+//      CHECK:     scf.for
+//      CHECK:       %[[MATMUL:.+]] = linalg.matmul
+//      CHECK:       %[[BIAS:.+]] = linalg.generic
+// CHECK-SAME:         ins(%[[MATMUL]], %{{.+}} :
+//      CHECK:         addf
+//      CHECK:       linalg.generic
+// CHECK-SAME:         ins(%[[BIAS]] :
+//      CHECK:         maxf
+//      CHECK:       flow.dispatch.tensor.store
+//  CHECK-NOT: flow.dispatch.workgroups
+
+// -----
+
+func @dont_fuse_matmul_with_accumulating_consumer(%lhs: tensor<128x64xf32>, %rhs: tensor<64x256xf32>, %acc: tensor<128x256xf32>) -> tensor<128x256xf32> {
+  %cst = constant 0.000000e+00 : f32
+  %0 = linalg.init_tensor [128, 256] : tensor<128x256xf32>
+  %1 = linalg.fill(%cst, %0) : f32, tensor<128x256xf32> -> tensor<128x256xf32>
+  %2 = linalg.matmul ins(%lhs, %rhs : tensor<128x64xf32>, tensor<64x256xf32>)
+         outs(%1 : tensor<128x256xf32>) -> tensor<128x256xf32>
+  %3 = linalg.generic {
+         indexing_maps = [
+           affine_map<(d0, d1) -> (d0, d1)>,
+           affine_map<(d0, d1) -> (d0, d1)>],
+         iterator_types = ["parallel", "parallel"]}
+         ins(%2 : tensor<128x256xf32>)
+         outs(%acc : tensor<128x256xf32>) {
+         ^bb0(%a: f32, %b: f32):
+            %add = addf %a, %b : f32
+            linalg.yield %add : f32
+         } -> tensor<128x256xf32>
+  return %3 : tensor<128x256xf32>
+}
+
+// The consumer reads its `outs` operand, so the matmul result would need its
+// own buffer inside the dispatch. Keep it in a separate dispatch.
+
+// CHECK-LABEL: func @dont_fuse_matmul_with_accumulating_consumer
+
+// CHECK: flow.dispatch.workgroups
+// CHECK:   scf.for
+// CHECK:     scf.for
+// CHECK:       linalg.matmul
+
+// CHECK: flow.dispatch.workgroups
+// CHECK:       linalg.generic
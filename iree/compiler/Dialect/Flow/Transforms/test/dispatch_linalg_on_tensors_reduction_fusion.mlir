@@ -0,0 +1,71 @@
+// RUN: iree-opt -split-input-file -verify-diagnostics -iree-flow-dispatch-linalg-on-tensors-pass -iree-flow-dispatch-formation-enable-reduction-fusion -canonicalize -cse %s | IreeFileCheck %s
+
+func @softmax(%input: tensor<12x128xf32>) -> tensor<12x128xf32> {
+  %cst = constant 0.000000e+00 : f32
+  %cst_min = constant -3.40282347E+38 : f32
+  %0 = linalg.init_tensor [12] : tensor<12xf32>
+  %1 = linalg.fill(%cst_min, %0) : f32, tensor<12xf32> -> tensor<12xf32>
+  %max = linalg.generic {
+         indexing_maps = [
+           affine_map<(d0, d1) -> (d0, d1)>,
+           affine_map<(d0, d1) -> (d0)>],
+         iterator_types = ["parallel", "reduction"]}
+         ins(%input : tensor<12x128xf32>) outs(%1 : tensor<12xf32>) {
+         ^bb0(%a: f32, %b: f32):
+            %m = maxf %a, %b : f32
+            linalg.yield %m : f32
+         } -> tensor<12xf32>
+  %2 = linalg.fill(%cst, %0) : f32, tensor<12xf32> -> tensor<12xf32>
+  %sum = linalg.generic {
+         indexing_maps = [
+           affine_map<(d0, d1) -> (d0, d1)>,
+           affine_map<(d0, d1) -> (d0)>,
+           affine_map<(d0, d1) -> (d0)>],
+         iterator_types = ["parallel", "reduction"]}
+         ins(%input, %max : tensor<12x128xf32>, tensor<12xf32>)
+         outs(%2 : tensor<12xf32>) {
+         ^bb0(%a: f32, %b: f32, %c: f32):
+            %sub = subf %a, %b : f32
+            %exp = math.exp %sub : f32
+            %add = addf %exp, %c : f32
+            linalg.yield %add : f32
+         } -> tensor<12xf32>
+  %3 = linalg.init_tensor [12, 128] : tensor<12x128xf32>
+  %4 = linalg.generic {
+         indexing_maps = [
+           affine_map<(d0, d1) -> (d0, d1)>,
+           affine_map<(d0, d1) -> (d0)>,
+           affine_map<(d0, d1) -> (d0)>,
+           affine_map<(d0, d1) -> (d0, d1)>],
+         iterator_types = ["parallel", "parallel"]}
+         ins(%input, %max, %sum : tensor<12x128xf32>, tensor<12xf32>, tensor<12xf32>)
+         outs(%3 : tensor<12x128xf32>) {
+         ^bb0(%a: f32, %b: f32, %c: f32, %d: f32):
+            %sub = subf %a, %b : f32
+            %exp = math.exp %sub : f32
+            %div = divf %exp, %c : f32
+            linalg.yield %div : f32
+         } -> tensor<12x128xf32>
+  return %4 : tensor<12x128xf32>
+}
+
+// Check that both reductions are fused into the dispatch region of the
+// elementwise consumer and that only the rows are partitioned.
+
+// CHECK-LABEL: func @softmax
+//  CHECK-DAG:   %[[C1:.+]] = constant 1 : index
+//  CHECK-DAG:   %[[C12:.+]] = constant 12 : index
+//      CHECK:   flow.dispatch.workgroups[%[[C12]], %[[C1]], %[[C1]]]
+//      CHECK:     scf.for
+//  CHECK-NOT:     scf.for
+//      CHECK:       linalg.fill
+//      CHECK:       %[[MAX:.+]] = linalg.generic
+// CHECK-SAME:         iterator_types = ["parallel", "reduction"]
+//      CHECK:       linalg.fill
+//      CHECK:       %[[SUM:.+]] = linalg.generic
+// CHECK-SAME:         iterator_types = ["parallel", "reduction"]
+// CHECK-SAME:         ins(%{{.+}}, %[[MAX]] :
+//      CHECK:       linalg.generic
+// CHECK-SAME:         iterator_types = ["parallel", "parallel"]
+// CHECK-SAME:         ins(%{{.+}}, %{{.+}}, %[[SUM]] :
+//  CHECK-NOT:   flow.dispatch.workgroups
@@ -17,6 +17,12 @@ module {
 // CHECK-DAG: util.do_not_optimize(%[[RET]]#0) : tensor<5x5xf32>
 // CHECK-DAG: util.do_not_optimize(%[[RET]]#1) : tensor<3x5xf32>
 
+// Each dispatch is also exported individually with its sizes and op counts.
+//     CHECK: func @[[DISPATCH:two_dispatch_dispatch_[0-9]+]]_benchmark()
+// CHECK-SAME:   iree.reflection = {benchmark = "dispatch", bytes = "{{[0-9]+}}", ops = "{{[0-9]+}}"}
+//     CHECK:   flow.dispatch @[[DISPATCH]]::@[[DISPATCH]]
+//     CHECK:   util.do_not_optimize
+
 // -----
 
 func @while(%start: tensor<i32>, %bound: tensor<i32>) -> tensor<i32> {
@@ -352,3 +352,24 @@ func @metadata_only(%t: tensor<?xf32>) -> (tensor<?xf32>, !shapex.ranked_shape<[
   %6 = shapex.tie_shape %t, %5 : tensor<?xf32>, !shapex.ranked_shape<[?]>
   return %6, %5 : tensor<?xf32>, !shapex.ranked_shape<[?]>
 }
+
+// -----
+
+// CHECK-LABEL: func @independentDispatchesGroupedByWave(
+func @independentDispatchesGroupedByWave(%arg0: tensor<4xf32>) -> (tensor<4xf32>, tensor<4xf32>) {
+  %cst = constant 4 : index
+  // CHECK: flow.ex.stream.fragment
+  // CHECK-NEXT: (%[[ARG:.+]]: tensor<4xf32>) -> (tensor<4xf32>, tensor<4xf32>) {
+  // CHECK-NEXT:   %[[WORKLOAD:.+]] = constant 4 : index
+  // CHECK-NEXT:   %[[D1:.+]] = flow.dispatch @dispatch_1::@dispatch_1[%[[WORKLOAD]]](%[[ARG]])
+  // CHECK-NEXT:   %[[D3:.+]] = flow.dispatch @dispatch_3::@dispatch_3[%[[WORKLOAD]]](%[[ARG]])
+  // CHECK-NEXT:   %[[D2:.+]] = flow.dispatch @dispatch_2::@dispatch_2[%[[WORKLOAD]]](%[[D1]])
+  // CHECK-NEXT:   %[[D4:.+]] = flow.dispatch @dispatch_4::@dispatch_4[%[[WORKLOAD]]](%[[D3]])
+  // CHECK-NEXT:   flow.return %[[D2]], %[[D4]] : tensor<4xf32>, tensor<4xf32>
+  // CHECK-NEXT: }
+  %d1 = flow.dispatch @dispatch_1::@dispatch_1[%cst](%arg0) : (tensor<4xf32>) -> tensor<4xf32>
+  %d2 = flow.dispatch @dispatch_2::@dispatch_2[%cst](%d1) : (tensor<4xf32>) -> tensor<4xf32>
+  %d3 = flow.dispatch @dispatch_3::@dispatch_3[%cst](%arg0) : (tensor<4xf32>) -> tensor<4xf32>
+  %d4 = flow.dispatch @dispatch_4::@dispatch_4[%cst](%d3) : (tensor<4xf32>) -> tensor<4xf32>
+  return %d2, %d4 : tensor<4xf32>, tensor<4xf32>
+}
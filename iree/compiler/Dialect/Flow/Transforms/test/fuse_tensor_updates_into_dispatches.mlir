@@ -0,0 +1,115 @@
+// RUN: iree-opt -split-input-file -iree-flow-fuse-tensor-updates-into-dispatches %s | IreeFileCheck %s
+
+// CHECK-LABEL: func @fusePadUpdate
+// CHECK-SAME: (%[[ARG0:.+]]: tensor<4xf32>)
+func @fusePadUpdate(%arg0: tensor<4xf32>) -> tensor<8xf32> {
+  %x = constant 4 : index
+  %c2 = constant 2 : index
+  %cst = constant 0.000000e+00 : f32
+  // The splat is produced after the dispatch so the dispatch is sunk to it.
+  // CHECK: %[[SPLAT:.+]] = flow.tensor.splat
+  // CHECK-NEXT: %[[RET:.+]] = flow.dispatch.workgroups[%{{.+}}](%[[ARG0]], %[[SPLAT]]) : (tensor<4xf32>, tensor<8xf32>) -> %[[SPLAT]] =
+  // CHECK-NEXT: (%[[ARG:.+]]: !flow.dispatch.tensor<readonly:4xf32>, %[[TARGET:.+]]: !flow.dispatch.tensor<readwrite:8xf32>) {
+  // CHECK-NEXT:   %[[VALUE:.+]] = flow.dispatch.tensor.load %[[ARG]]
+  // CHECK-NEXT:   flow.dispatch.tensor.store %[[VALUE]], %[[TARGET]], offsets = [2], sizes = [4], strides = [1] : tensor<4xf32> -> !flow.dispatch.tensor<readwrite:8xf32>
+  // CHECK-NEXT:   flow.return
+  %0 = flow.dispatch.workgroups[%x](%arg0) : (tensor<4xf32>) -> tensor<4xf32> = (
+    %arg: !flow.dispatch.tensor<readonly:4xf32>, %ret: !flow.dispatch.tensor<writeonly:4xf32>
+  ) {
+    %t = flow.dispatch.tensor.load %arg, offsets = [], sizes = [], strides = [] : !flow.dispatch.tensor<readonly:4xf32> -> tensor<4xf32>
+    flow.dispatch.tensor.store %t, %ret, offsets = [], sizes = [], strides = [] : tensor<4xf32> -> !flow.dispatch.tensor<writeonly:4xf32>
+    flow.return
+  }
+  %1 = flow.tensor.splat %cst : tensor<8xf32>
+  // CHECK-NOT: flow.tensor.update
+  %2 = flow.tensor.update %0, %1[%c2] : tensor<4xf32> -> %1 as tensor<8xf32>
+  // CHECK: return %[[RET]]
+  return %2 : tensor<8xf32>
+}
+
+// -----
+
+// Tiled stores have their offsets adjusted by the update start indices.
+
+// CHECK-LABEL: func @fuseTiledUpdate
+func @fuseTiledUpdate(%arg0: tensor<4xf32>, %arg1: tensor<8xf32>) -> tensor<8xf32> {
+  %x = constant 4 : index
+  %c3 = constant 3 : index
+  // CHECK: flow.dispatch.workgroups[%{{.+}}](%{{.+}}, %[[ARG1:.+]]) : (tensor<4xf32>, tensor<8xf32>) -> %[[ARG1]] =
+  // CHECK-NEXT: (%[[ARG:.+]]: !flow.dispatch.tensor<readonly:4xf32>, %[[TARGET:.+]]: !flow.dispatch.tensor<readwrite:8xf32>) {
+  // CHECK-NEXT:   %[[ID:.+]] = flow.dispatch.workgroup.id[0] : index
+  // CHECK-NEXT:   %[[VALUE:.+]] = flow.dispatch.tensor.load %[[ARG]]
+  // CHECK-NEXT:   %[[START:.+]] = constant 3 : index
+  // CHECK-NEXT:   %[[OFFSET:.+]] = addi %[[ID]], %[[START]] : index
+  // CHECK-NEXT:   flow.dispatch.tensor.store %[[VALUE]], %[[TARGET]], offsets = [%[[OFFSET]]], sizes = [1], strides = [1] : tensor<1xf32> -> !flow.dispatch.tensor<readwrite:8xf32>
+  %0 = flow.dispatch.workgroups[%x](%arg0) : (tensor<4xf32>) -> tensor<4xf32> = (
+    %arg: !flow.dispatch.tensor<readonly:4xf32>, %ret: !flow.dispatch.tensor<writeonly:4xf32>
+  ) {
+    %id = flow.dispatch.workgroup.id[0] : index
+    %t = flow.dispatch.tensor.load %arg, offsets = [%id], sizes = [1], strides = [1] : !flow.dispatch.tensor<readonly:4xf32> -> tensor<1xf32>
+    flow.dispatch.tensor.store %t, %ret, offsets = [%id], sizes = [1], strides = [1] : tensor<1xf32> -> !flow.dispatch.tensor<writeonly:4xf32>
+    flow.return
+  }
+  // CHECK-NOT: flow.tensor.update
+  %1 = flow.tensor.update %0, %arg1[%c3] : tensor<4xf32> -> %arg1 as tensor<8xf32>
+  return %1 : tensor<8xf32>
+}
+
+// -----
+
+// Concatenations chain the updates; each dispatch writes its own slice.
+
+// CHECK-LABEL: func @fuseConcatUpdates
+// CHECK-SAME: (%[[ARG0:.+]]: tensor<4xf32>, %[[ARG1:.+]]: tensor<4xf32>)
+func @fuseConcatUpdates(%arg0: tensor<4xf32>, %arg1: tensor<4xf32>) -> tensor<8xf32> {
+  %x = constant 4 : index
+  %c0 = constant 0 : index
+  %c4 = constant 4 : index
+  %cst = constant 0.000000e+00 : f32
+  // CHECK: %[[SPLAT:.+]] = flow.tensor.splat
+  %init = flow.tensor.splat %cst : tensor<8xf32>
+  // CHECK-NEXT: %[[LHS:.+]] = flow.dispatch.workgroups[%{{.+}}](%[[ARG0]], %[[SPLAT]]) : (tensor<4xf32>, tensor<8xf32>) -> %[[SPLAT]] =
+  // CHECK: flow.dispatch.tensor.store %{{.+}}, %{{.+}}, offsets = [0], sizes = [4], strides = [1]
+  %0 = flow.dispatch.workgroups[%x](%arg0) : (tensor<4xf32>) -> tensor<4xf32> = (
+    %arg: !flow.dispatch.tensor<readonly:4xf32>, %ret: !flow.dispatch.tensor<writeonly:4xf32>
+  ) {
+    %t = flow.dispatch.tensor.load %arg, offsets = [], sizes = [], strides = [] : !flow.dispatch.tensor<readonly:4xf32> -> tensor<4xf32>
+    flow.dispatch.tensor.store %t, %ret, offsets = [], sizes = [], strides = [] : tensor<4xf32> -> !flow.dispatch.tensor<writeonly:4xf32>
+    flow.return
+  }
+  // CHECK: %[[RHS:.+]] = flow.dispatch.workgroups[%{{.+}}](%[[ARG1]], %[[LHS]]) : (tensor<4xf32>, tensor<8xf32>) -> %[[LHS]] =
+  // CHECK: flow.dispatch.tensor.store %{{.+}}, %{{.+}}, offsets = [4], sizes = [4], strides = [1]
+  %1 = flow.dispatch.workgroups[%x](%arg1) : (tensor<4xf32>) -> tensor<4xf32> = (
+    %arg: !flow.dispatch.tensor<readonly:4xf32>, %ret: !flow.dispatch.tensor<writeonly:4xf32>
+  ) {
+    %t = flow.dispatch.tensor.load %arg, offsets = [], sizes = [], strides = [] : !flow.dispatch.tensor<readonly:4xf32> -> tensor<4xf32>
+    flow.dispatch.tensor.store %t, %ret, offsets = [], sizes = [], strides = [] : tensor<4xf32> -> !flow.dispatch.tensor<writeonly:4xf32>
+    flow.return
+  }
+  // CHECK-NOT: flow.tensor.update
+  %2 = flow.tensor.update %0, %init[%c0] : tensor<4xf32> -> %init as tensor<8xf32>
+  %3 = flow.tensor.update %1, %2[%c4] : tensor<4xf32> -> %2 as tensor<8xf32>
+  // CHECK: return %[[RHS]]
+  return %3 : tensor<8xf32>
+}
+
+// -----
+
+// Updates whose values are also used elsewhere still need their own copy.
+
+// CHECK-LABEL: func @dontFuseSharedUpdate
+func @dontFuseSharedUpdate(%arg0: tensor<4xf32>, %arg1: tensor<8xf32>) -> (tensor<4xf32>, tensor<8xf32>) {
+  %x = constant 4 : index
+  %c2 = constant 2 : index
+  // CHECK: %[[RET:.+]] = flow.dispatch.workgroups[%{{.+}}](%{{.+}}) : (tensor<4xf32>) -> tensor<4xf32> =
+  %0 = flow.dispatch.workgroups[%x](%arg0) : (tensor<4xf32>) -> tensor<4xf32> = (
+    %arg: !flow.dispatch.tensor<readonly:4xf32>, %ret: !flow.dispatch.tensor<writeonly:4xf32>
+  ) {
+    %t = flow.dispatch.tensor.load %arg, offsets = [], sizes = [], strides = [] : !flow.dispatch.tensor<readonly:4xf32> -> tensor<4xf32>
+    flow.dispatch.tensor.store %t, %ret, offsets = [], sizes = [], strides = [] : tensor<4xf32> -> !flow.dispatch.tensor<writeonly:4xf32>
+    flow.return
+  }
+  // CHECK: flow.tensor.update %[[RET]]
+  %1 = flow.tensor.update %0, %arg1[%c2] : tensor<4xf32> -> %arg1 as tensor<8xf32>
+  return %0, %1 : tensor<4xf32>, tensor<8xf32>
+}
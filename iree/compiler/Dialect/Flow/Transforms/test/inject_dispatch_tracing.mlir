@@ -1,4 +1,5 @@
 // RUN: iree-opt -split-input-file -pass-pipeline='builtin.func(iree-flow-inject-dispatch-tracing)' %s | IreeFileCheck %s
+// RUN: iree-opt -split-input-file -pass-pipeline='builtin.func(iree-flow-inject-dispatch-tracing{summarize=true})' %s | IreeFileCheck %s --check-prefix=SUMMARY
 
 // CHECK-LABEL: func @singleDispatch
 // CHECK-SAME: (%[[ARG0:.+]]: tensor<4xf32>)
@@ -32,3 +33,18 @@ func @multiDispatch(%arg0: tensor<4xf32>) -> tensor<4xf32> {
   // CHECK: return %[[RET1]]
   return %1 : tensor<4xf32>
 }
+
+// -----
+
+// SUMMARY-LABEL: func @summarizeDispatch
+// SUMMARY-SAME: (%[[ARG0:.+]]: tensor<4xf32>)
+func @summarizeDispatch(%arg0: tensor<4xf32>) -> tensor<4xf32> {
+  %c4 = constant 4 : index
+  //      SUMMARY: flow.tensor.summarize {key = "ex::entry0 inputs"} %[[ARG0]] : tensor<4xf32>
+  // SUMMARY-NEXT: %[[RET0:.+]] = flow.dispatch @ex::@entry0[%c4](%[[ARG0]]) : (tensor<4xf32>) -> tensor<4xf32>
+  %0 = flow.dispatch @ex::@entry0[%c4](%arg0) : (tensor<4xf32>) -> tensor<4xf32>
+  // SUMMARY-NEXT: flow.tensor.summarize {key = "ex::entry0 outputs"} %[[RET0]] : tensor<4xf32>
+  // SUMMARY-NOT: flow.tensor.trace
+  // SUMMARY: return %[[RET0]]
+  return %0 : tensor<4xf32>
+}
@@ -70,3 +70,39 @@ func @check_mmt4d_with_init_tensor_and_fill(%arg0: tensor<24x8xf32>, %arg1: tens
 // CHECK-SAME:   tensor<8x32xf32> into tensor<2x4x8x4xf32>
 //      CHECK: %[[DST_INIT:.+]] = linalg.init_tensor [6, 8, 4, 4] : tensor<6x8x4x4xf32>
 //      CHECK: [[DST:.+]] linalg.fill(%[[ZERO:.+]], %[[DST_INIT]])
+
+// -----
+func @check_mmt4d_with_constant_rhs(%arg0: tensor<8x4xf32>, %arg1: tensor<8x8xf32>) -> tensor<8x8xf32> {
+    %cst = constant dense<[[0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0],
+                           [8.0, 9.0, 10.0, 11.0, 12.0, 13.0, 14.0, 15.0],
+                           [16.0, 17.0, 18.0, 19.0, 20.0, 21.0, 22.0, 23.0],
+                           [24.0, 25.0, 26.0, 27.0, 28.0, 29.0, 30.0, 31.0]]> : tensor<4x8xf32>
+    %0 = linalg.matmul ins(%arg0, %cst : tensor<8x4xf32>, tensor<4x8xf32>) outs(%arg1 : tensor<8x8xf32>) -> tensor<8x8xf32>
+    return %0 : tensor<8x8xf32>
+}
+// The constant RHS is packed into the mmt4d layout at compile time.
+//      CHECK: @check_mmt4d_with_constant_rhs
+//      CHECK: %[[RHS4DT:.+]] = constant dense<{{\[\[\[\[}}0.000000e+00, 1.000000e+00, 2.000000e+00, 3.000000e+00], [8.000000e+00, 9.000000e+00, 1.000000e+01, 1.100000e+01]
+// CHECK-SAME:   [4.000000e+00, 5.000000e+00, 6.000000e+00, 7.000000e+00], [1.200000e+01, 1.300000e+01, 1.400000e+01, 1.500000e+01]
+// CHECK-SAME:   : tensor<2x1x4x4xf32>
+//  CHECK-NOT: linalg.tensor_expand_shape %{{.+}} : tensor<4x8xf32>
+//      CHECK: linalg.mmt4d ins(%{{.+}}, %[[RHS4DT]] : tensor<2x1x4x4xf32>, tensor<2x1x4x4xf32>)
+
+// -----
+func @check_mmt4d_i8i8i32(%arg0: tensor<24x8xi8>, %arg1: tensor<8x32xi8>, %arg2: tensor<24x32xi32>) -> tensor<24x32xi32> {
+    %0 = linalg.matmul ins(%arg0, %arg1 : tensor<24x8xi8>, tensor<8x32xi8>) outs(%arg2 : tensor<24x32xi32>) -> tensor<24x32xi32>
+    return %0 : tensor<24x32xi32>
+}
+// Quantized matmuls accumulating into i32 are converted as well.
+//      CHECK: @check_mmt4d_i8i8i32
+//      CHECK: linalg.mmt4d ins(%{{.+}}, %{{.+}} : tensor<6x2x4x4xi8>, tensor<8x2x4x4xi8>) outs(%{{.+}} : tensor<6x8x4x4xi32>) -> tensor<6x8x4x4xi32>
+
+// -----
+func @check_no_mmt4d_i8i8i8(%arg0: tensor<24x8xi8>, %arg1: tensor<8x32xi8>, %arg2: tensor<24x32xi8>) -> tensor<24x32xi8> {
+    %0 = linalg.matmul ins(%arg0, %arg1 : tensor<24x8xi8>, tensor<8x32xi8>) outs(%arg2 : tensor<24x32xi8>) -> tensor<24x32xi8>
+    return %0 : tensor<24x32xi8>
+}
+// Element types without microkernels are left as matmuls.
+//      CHECK: @check_no_mmt4d_i8i8i8
+//  CHECK-NOT: linalg.mmt4d
+//      CHECK: linalg.matmul
@@ -2,6 +2,7 @@
 
 //      CHECK: flow.executable @staticShapeDispatch_dispatch_0
 // CHECK-NEXT:   flow.dispatch.entry @staticShapeDispatch_dispatch_0 attributes {
+// CHECK-SAME:       estimated_bytes = 256 : i64
 // CHECK-SAME:       workgroup_rank = 2 : index}
 //      CHECK: func @staticShapeDispatch_dispatch_0(
 // CHECK-SAME:     %[[ARG:.+]]: !flow.dispatch.tensor<readonly:8x4xf32>,
@@ -122,8 +123,7 @@ func @dispatchFn2(%arg0 : tensor<8x4xf32>) -> tensor<4x8xf32> {
 // -----
 
 //      CHECK: flow.executable @dynamicShapeDispatch_dispatch_0
-// CHECK-NEXT:   flow.dispatch.entry @dynamicShapeDispatch_dispatch_0 attributes {
-// CHECK-SAME:       workgroup_rank = 2 : index}
+// CHECK-NEXT:   flow.dispatch.entry @dynamicShapeDispatch_dispatch_0 attributes {workgroup_rank = 2 : index}
 //      CHECK: func @dynamicShapeDispatch_dispatch_0(
 // CHECK-SAME:     %[[ARG:.+]]: !flow.dispatch.tensor<readonly:7x?x24x?xf32>,
 // CHECK-SAME:     %[[RET:.+]]: !flow.dispatch.tensor<writeonly:?x?x1024xf32>,
@@ -202,3 +202,35 @@ func @dynamicShapeDispatch(%arg0 : tensor<7x?x24x?xf32>) -> tensor<?x?x1024xf32>
   // CHECK-NEXT: return %[[RET0]]
   return %ret0 : tensor<?x?x1024xf32>
 }
+
+// -----
+
+//      CHECK: flow.dispatch.entry @linalgDispatch_dispatch_0 attributes {
+// CHECK-SAME:     estimated_bytes = 384 : i64, estimated_ops = 32 : i64
+
+// CHECK-LABEL: func @linalgDispatch(
+func @linalgDispatch(%arg0 : tensor<4x8xf32>, %arg1 : tensor<4x8xf32>) -> tensor<4x8xf32> {
+  %x = constant 8 : index
+  %y = constant 4 : index
+  %0 = flow.dispatch.workgroups[%x, %y](%arg0, %arg1) : (tensor<4x8xf32>, tensor<4x8xf32>) -> tensor<4x8xf32> = (
+    %lhs: !flow.dispatch.tensor<readonly:4x8xf32>, %rhs: !flow.dispatch.tensor<readonly:4x8xf32>, %ret: !flow.dispatch.tensor<writeonly:4x8xf32>
+  ) {
+    %lhs_value = flow.dispatch.tensor.load %lhs, offsets=[], sizes=[], strides=[] : !flow.dispatch.tensor<readonly:4x8xf32> -> tensor<4x8xf32>
+    %rhs_value = flow.dispatch.tensor.load %rhs, offsets=[], sizes=[], strides=[] : !flow.dispatch.tensor<readonly:4x8xf32> -> tensor<4x8xf32>
+    %init = linalg.init_tensor [4, 8] : tensor<4x8xf32>
+    %ret_value = linalg.generic {
+      indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>,
+                       affine_map<(d0, d1) -> (d0, d1)>,
+                       affine_map<(d0, d1) -> (d0, d1)>],
+      iterator_types = ["parallel", "parallel"]}
+      ins(%lhs_value, %rhs_value : tensor<4x8xf32>, tensor<4x8xf32>)
+      outs(%init : tensor<4x8xf32>) {
+    ^bb0(%a : f32, %b : f32, %c : f32):
+      %sum = addf %a, %b : f32
+      linalg.yield %sum : f32
+    } -> tensor<4x8xf32>
+    flow.dispatch.tensor.store %ret_value, %ret, offsets=[], sizes=[], strides=[] : tensor<4x8xf32> -> !flow.dispatch.tensor<writeonly:4x8xf32>
+    flow.return
+  }
+  return %0 : tensor<4x8xf32>
+}
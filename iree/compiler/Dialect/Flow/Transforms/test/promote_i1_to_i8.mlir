@@ -33,3 +33,27 @@ func @boolean_const() -> (tensor<4xi1>, tensor<4xi8>) {
     %1 = constant dense<[1, 1, 0, 1]> : tensor<4xi8>
     return %0, %1 : tensor<4xi1>, tensor<4xi8>
 }
+
+// -----
+
+// CHECK: #[[$PACKED_MAP:.+]] = affine_map<(d0, d1) -> (d0, d1 floordiv 8)>
+// CHECK: #[[$MAP:.+]] = affine_map<(d0, d1) -> (d0, d1)>
+
+// CHECK-LABEL: packed_boolean_const
+func @packed_boolean_const() -> (tensor<2x8xi1>) {
+    // CHECK: [[CONST:%.+]] = constant dense<{{\[}}[11], [80]]> : tensor<2x1xi8>
+    // CHECK: [[INIT:%.+]] = linalg.init_tensor [2, 8] : tensor<2x8xi1>
+    // CHECK: [[GENERIC:%.+]] = linalg.generic {indexing_maps = [#[[$PACKED_MAP]], #[[$MAP]]], iterator_types = ["parallel", "parallel"]} ins([[CONST]] : tensor<2x1xi8>) outs([[INIT]] : tensor<2x8xi1>)
+    // CHECK: ^bb0(%arg0: i8, %arg1: i1):
+    // CHECK:   [[INDEX:%.+]] = linalg.index 1 : index
+    // CHECK:   [[C8:%.+]] = constant 8 : index
+    // CHECK:   [[BIT:%.+]] = remi_unsigned [[INDEX]], [[C8]] : index
+    // CHECK:   [[SHIFT:%.+]] = index_cast [[BIT]] : index to i8
+    // CHECK:   [[SHR:%.+]] = shift_right_unsigned %arg0, [[SHIFT]] : i8
+    // CHECK:   [[TRUNC:%.+]] = trunci [[SHR]] : i8 to i1
+    // CHECK:   linalg.yield [[TRUNC]]
+    // CHECK: return [[GENERIC]]
+    %0 = constant dense<[[true, true, false, true, false, false, false, false],
+                         [false, false, false, false, true, false, true, false]]> : tensor<2x8xi1>
+    return %0 : tensor<2x8xi1>
+}
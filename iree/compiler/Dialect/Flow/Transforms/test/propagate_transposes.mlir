@@ -0,0 +1,198 @@
+// RUN: iree-opt -split-input-file -iree-flow-propagate-transposes -canonicalize -cse %s | IreeFileCheck %s
+
+#map0 = affine_map<(d0, d1) -> (d1, d0)>
+#map1 = affine_map<(d0, d1) -> (d0, d1)>
+func @cancel_transposes(%arg0: tensor<4x8xf32>) -> tensor<4x8xf32> {
+  %0 = linalg.init_tensor [8, 4] : tensor<8x4xf32>
+  %1 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel"]}
+      ins(%arg0 : tensor<4x8xf32>) outs(%0 : tensor<8x4xf32>) {
+  ^bb0(%arg1: f32, %arg2: f32):
+    linalg.yield %arg1 : f32
+  } -> tensor<8x4xf32>
+  %2 = linalg.init_tensor [4, 8] : tensor<4x8xf32>
+  %3 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel"]}
+      ins(%1 : tensor<8x4xf32>) outs(%2 : tensor<4x8xf32>) {
+  ^bb0(%arg1: f32, %arg2: f32):
+    linalg.yield %arg1 : f32
+  } -> tensor<4x8xf32>
+  return %3 : tensor<4x8xf32>
+}
+// CHECK-LABEL: func @cancel_transposes
+//  CHECK-SAME:   %[[ARG0:.+]]: tensor<4x8xf32>
+//   CHECK-NOT:   linalg.generic
+//       CHECK:   return %[[ARG0]]
+
+// -----
+
+#map0 = affine_map<(d0, d1, d2) -> (d1, d2, d0)>
+#map1 = affine_map<(d0, d1, d2) -> (d0, d1, d2)>
+func @compose_transposes(%arg0: tensor<2x3x4xf32>) -> tensor<2x3x4xf32> {
+  %0 = linalg.init_tensor [4, 2, 3] : tensor<4x2x3xf32>
+  %1 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel", "parallel"]}
+      ins(%arg0 : tensor<2x3x4xf32>) outs(%0 : tensor<4x2x3xf32>) {
+  ^bb0(%arg1: f32, %arg2: f32):
+    linalg.yield %arg1 : f32
+  } -> tensor<4x2x3xf32>
+  %2 = linalg.init_tensor [3, 4, 2] : tensor<3x4x2xf32>
+  %3 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel", "parallel"]}
+      ins(%1 : tensor<4x2x3xf32>) outs(%2 : tensor<3x4x2xf32>) {
+  ^bb0(%arg1: f32, %arg2: f32):
+    linalg.yield %arg1 : f32
+  } -> tensor<3x4x2xf32>
+  %4 = linalg.init_tensor [2, 3, 4] : tensor<2x3x4xf32>
+  %5 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel", "parallel"]}
+      ins(%3 : tensor<3x4x2xf32>) outs(%4 : tensor<2x3x4xf32>) {
+  ^bb0(%arg1: f32, %arg2: f32):
+    linalg.yield %arg1 : f32
+  } -> tensor<2x3x4xf32>
+  return %5 : tensor<2x3x4xf32>
+}
+// CHECK-LABEL: func @compose_transposes
+//  CHECK-SAME:   %[[ARG0:.+]]: tensor<2x3x4xf32>
+//   CHECK-NOT:   linalg.generic
+//       CHECK:   return %[[ARG0]]
+
+// -----
+
+#map0 = affine_map<(d0, d1) -> (d1, d0)>
+#map1 = affine_map<(d0, d1) -> (d0, d1)>
+func @sink_below_elementwise(%arg0: tensor<?x8xf32>, %arg1: tensor<?x8xf32>) -> tensor<?x8xf32> {
+  %c0 = constant 0 : index
+  %d0 = tensor.dim %arg0, %c0 : tensor<?x8xf32>
+  %0 = linalg.init_tensor [8, %d0] : tensor<8x?xf32>
+  %1 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel"]}
+      ins(%arg0 : tensor<?x8xf32>) outs(%0 : tensor<8x?xf32>) {
+  ^bb0(%arg2: f32, %arg3: f32):
+    linalg.yield %arg2 : f32
+  } -> tensor<8x?xf32>
+  %2 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel"]}
+      ins(%arg1 : tensor<?x8xf32>) outs(%0 : tensor<8x?xf32>) {
+  ^bb0(%arg2: f32, %arg3: f32):
+    linalg.yield %arg2 : f32
+  } -> tensor<8x?xf32>
+  %3 = linalg.generic {indexing_maps = [#map1, #map1, #map1], iterator_types = ["parallel", "parallel"]}
+      ins(%1, %2 : tensor<8x?xf32>, tensor<8x?xf32>) outs(%0 : tensor<8x?xf32>) {
+  ^bb0(%arg2: f32, %arg3: f32, %arg4: f32):
+    %6 = addf %arg2, %arg3 : f32
+    linalg.yield %6 : f32
+  } -> tensor<8x?xf32>
+  %4 = linalg.init_tensor [%d0, 8] : tensor<?x8xf32>
+  %5 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel"]}
+      ins(%3 : tensor<8x?xf32>) outs(%4 : tensor<?x8xf32>) {
+  ^bb0(%arg2: f32, %arg3: f32):
+    linalg.yield %arg2 : f32
+  } -> tensor<?x8xf32>
+  return %5 : tensor<?x8xf32>
+}
+// CHECK-LABEL: func @sink_below_elementwise
+//  CHECK-SAME:   %[[ARG0:[a-zA-Z0-9_]+]]: tensor<?x8xf32>
+//  CHECK-SAME:   %[[ARG1:[a-zA-Z0-9_]+]]: tensor<?x8xf32>
+//       CHECK:   %[[ADD:.+]] = linalg.generic
+//  CHECK-SAME:     ins(%[[ARG0]], %[[ARG1]] : tensor<?x8xf32>, tensor<?x8xf32>)
+//       CHECK:     addf
+//   CHECK-NOT:   linalg.generic
+//       CHECK:   return %[[ADD]]
+
+// -----
+
+#map0 = affine_map<(d0, d1) -> (d1, d0)>
+#map1 = affine_map<(d0, d1) -> (d0, d1)>
+func @no_sink_widening(%arg0: tensor<4x8xi8>) -> tensor<8x4xf32> {
+  %0 = linalg.init_tensor [8, 4] : tensor<8x4xi8>
+  %1 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel"]}
+      ins(%arg0 : tensor<4x8xi8>) outs(%0 : tensor<8x4xi8>) {
+  ^bb0(%arg1: i8, %arg2: i8):
+    linalg.yield %arg1 : i8
+  } -> tensor<8x4xi8>
+  %2 = linalg.init_tensor [8, 4] : tensor<8x4xf32>
+  %3 = linalg.generic {indexing_maps = [#map1, #map1], iterator_types = ["parallel", "parallel"]}
+      ins(%1 : tensor<8x4xi8>) outs(%2 : tensor<8x4xf32>) {
+  ^bb0(%arg1: i8, %arg2: f32):
+    %4 = sitofp %arg1 : i8 to f32
+    linalg.yield %4 : f32
+  } -> tensor<8x4xf32>
+  return %3 : tensor<8x4xf32>
+}
+// CHECK-LABEL: func @no_sink_widening
+//       CHECK:   %[[TRANSPOSE:.+]] = linalg.generic
+//  CHECK-SAME:     ins(%{{.+}} : tensor<4x8xi8>)
+//       CHECK:   %[[CAST:.+]] = linalg.generic
+//  CHECK-SAME:     ins(%[[TRANSPOSE]] : tensor<8x4xi8>)
+//       CHECK:   return %[[CAST]]
+
+// -----
+
+#map0 = affine_map<(d0, d1) -> (d1, d0)>
+#map1 = affine_map<(d0, d1) -> (d0, d1)>
+func @transpose_matmul_result(%lhs: tensor<16x4xf32>, %rhs: tensor<8x16xf32>) -> tensor<8x4xf32> {
+  %cst = constant 0.0 : f32
+  %0 = linalg.init_tensor [4, 16] : tensor<4x16xf32>
+  %1 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel"]}
+      ins(%lhs : tensor<16x4xf32>) outs(%0 : tensor<4x16xf32>) {
+  ^bb0(%arg0: f32, %arg1: f32):
+    linalg.yield %arg0 : f32
+  } -> tensor<4x16xf32>
+  %2 = linalg.init_tensor [16, 8] : tensor<16x8xf32>
+  %3 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel"]}
+      ins(%rhs : tensor<8x16xf32>) outs(%2 : tensor<16x8xf32>) {
+  ^bb0(%arg0: f32, %arg1: f32):
+    linalg.yield %arg0 : f32
+  } -> tensor<16x8xf32>
+  %4 = linalg.init_tensor [4, 8] : tensor<4x8xf32>
+  %5 = linalg.fill(%cst, %4) : f32, tensor<4x8xf32> -> tensor<4x8xf32>
+  %6 = linalg.matmul ins(%1, %3 : tensor<4x16xf32>, tensor<16x8xf32>)
+      outs(%5 : tensor<4x8xf32>) -> tensor<4x8xf32>
+  %7 = linalg.init_tensor [8, 4] : tensor<8x4xf32>
+  %8 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel"]}
+      ins(%6 : tensor<4x8xf32>) outs(%7 : tensor<8x4xf32>) {
+  ^bb0(%arg0: f32, %arg1: f32):
+    linalg.yield %arg0 : f32
+  } -> tensor<8x4xf32>
+  return %8 : tensor<8x4xf32>
+}
+// CHECK-LABEL: func @transpose_matmul_result
+//  CHECK-SAME:   %[[LHS:.+]]: tensor<16x4xf32>, %[[RHS:.+]]: tensor<8x16xf32>
+//   CHECK-NOT:   linalg.generic
+//       CHECK:   %[[INIT:.+]] = linalg.init_tensor [8, 4]
+//       CHECK:   %[[FILL:.+]] = linalg.fill(%{{.+}}, %[[INIT]])
+//       CHECK:   %[[MATMUL:.+]] = linalg.matmul
+//  CHECK-SAME:     ins(%[[RHS]], %[[LHS]] : tensor<8x16xf32>, tensor<16x4xf32>)
+//  CHECK-SAME:     outs(%[[FILL]] : tensor<8x4xf32>)
+//   CHECK-NOT:   linalg.generic
+//       CHECK:   return %[[MATMUL]]
+
+// -----
+
+#map0 = affine_map<(d0, d1) -> (d1, d0)>
+#map1 = affine_map<(d0, d1) -> (d0, d1)>
+func @hoist_above_matmul(%lhs: tensor<64x4xf32>, %rhs: tensor<8x64xf32>) -> tensor<4x8xf32> {
+  %cst = constant 0.0 : f32
+  %0 = linalg.init_tensor [4, 64] : tensor<4x64xf32>
+  %1 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel"]}
+      ins(%lhs : tensor<64x4xf32>) outs(%0 : tensor<4x64xf32>) {
+  ^bb0(%arg0: f32, %arg1: f32):
+    linalg.yield %arg0 : f32
+  } -> tensor<4x64xf32>
+  %2 = linalg.init_tensor [64, 8] : tensor<64x8xf32>
+  %3 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel"]}
+      ins(%rhs : tensor<8x64xf32>) outs(%2 : tensor<64x8xf32>) {
+  ^bb0(%arg0: f32, %arg1: f32):
+    linalg.yield %arg0 : f32
+  } -> tensor<64x8xf32>
+  %4 = linalg.init_tensor [4, 8] : tensor<4x8xf32>
+  %5 = linalg.fill(%cst, %4) : f32, tensor<4x8xf32> -> tensor<4x8xf32>
+  %6 = linalg.matmul ins(%1, %3 : tensor<4x64xf32>, tensor<64x8xf32>)
+      outs(%5 : tensor<4x8xf32>) -> tensor<4x8xf32>
+  return %6 : tensor<4x8xf32>
+}
+// CHECK-DAG: #[[MAP0:.+]] = affine_map<(d0, d1) -> (d1, d0)>
+// CHECK-DAG: #[[MAP1:.+]] = affine_map<(d0, d1) -> (d0, d1)>
+// CHECK-LABEL: func @hoist_above_matmul
+//  CHECK-SAME:   %[[LHS:.+]]: tensor<64x4xf32>, %[[RHS:.+]]: tensor<8x64xf32>
+//       CHECK:   %[[MATMUL:.+]] = linalg.matmul
+//  CHECK-SAME:     ins(%[[RHS]], %[[LHS]] : tensor<8x64xf32>, tensor<64x4xf32>)
+//  CHECK-SAME:     -> tensor<8x4xf32>
+//       CHECK:   %[[TRANSPOSE:.+]] = linalg.generic
+//  CHECK-SAME:     indexing_maps = [#[[MAP0]], #[[MAP1]]]
+//  CHECK-SAME:     ins(%[[MATMUL]] : tensor<8x4xf32>)
+//       CHECK:   return %[[TRANSPOSE]]
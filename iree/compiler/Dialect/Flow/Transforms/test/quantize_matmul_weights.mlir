@@ -0,0 +1,54 @@
+// RUN: iree-opt -split-input-file -pass-pipeline='builtin.func(iree-flow-quantize-matmul-weights{block-size=2})' %s | IreeFileCheck %s
+
+//  CHECK-DAG: #[[$LHS_MAP:.+]] = affine_map<(d0, d1, d2) -> (d0, d2)>
+//  CHECK-DAG: #[[$RHS_MAP:.+]] = affine_map<(d0, d1, d2) -> (d2, d1)>
+//  CHECK-DAG: #[[$SCALE_MAP:.+]] = affine_map<(d0, d1, d2) -> (d2 floordiv 2, d1)>
+//  CHECK-DAG: #[[$OUT_MAP:.+]] = affine_map<(d0, d1, d2) -> (d0, d1)>
+// CHECK-LABEL: func @blockQuantized
+//  CHECK-SAME: (%[[LHS:.+]]: tensor<3x4xf32>, %[[ACC:.+]]: tensor<3x2xf32>)
+func @blockQuantized(%lhs: tensor<3x4xf32>, %acc: tensor<3x2xf32>) -> tensor<3x2xf32> {
+  //  CHECK-DAG: %[[RHS:.+]] = constant dense<{{\[}}[127, -64], [64, 127], [127, 0], [-64, 127]]> : tensor<4x2xi8>
+  //  CHECK-DAG: %[[SCALES:.+]] = constant dense<{{\[}}[{{.+}}, {{.+}}], [1.000000e+00, {{.+}}]]> : tensor<2x2xf32>
+  //      CHECK: %[[RESULT:.+]] = linalg.generic
+  // CHECK-SAME:     indexing_maps = [#[[$LHS_MAP]], #[[$RHS_MAP]], #[[$SCALE_MAP]], #[[$OUT_MAP]]]
+  // CHECK-SAME:     iterator_types = ["parallel", "parallel", "reduction"]
+  // CHECK-SAME:     ins(%[[LHS]], %[[RHS]], %[[SCALES]] : tensor<3x4xf32>, tensor<4x2xi8>, tensor<2x2xf32>)
+  // CHECK-SAME:     outs(%[[ACC]] : tensor<3x2xf32>)
+  // CHECK-NEXT: ^bb0(%[[A:.+]]: f32, %[[Q:.+]]: i8, %[[S:.+]]: f32, %[[C:.+]]: f32):
+  // CHECK-NEXT:   %[[W:.+]] = sitofp %[[Q]] : i8 to f32
+  // CHECK-NEXT:   %[[SCALED:.+]] = mulf %[[W]], %[[S]] : f32
+  // CHECK-NEXT:   %[[PRODUCT:.+]] = mulf %[[A]], %[[SCALED]] : f32
+  // CHECK-NEXT:   %[[SUM:.+]] = addf %[[C]], %[[PRODUCT]] : f32
+  // CHECK-NEXT:   linalg.yield %[[SUM]] : f32
+  //      CHECK: return %[[RESULT]]
+  %rhs = constant dense<[[1.0, -2.0], [0.5, 4.0], [127.0, 0.0], [-63.5, 1.0]]> : tensor<4x2xf32>
+  %0 = linalg.matmul ins(%lhs, %rhs : tensor<3x4xf32>, tensor<4x2xf32>) outs(%acc : tensor<3x2xf32>) -> tensor<3x2xf32>
+  return %0 : tensor<3x2xf32>
+}
+
+// -----
+
+// K is not a multiple of the block size so each column gets a single scale.
+
+//  CHECK-DAG: #[[$SCALE_MAP:.+]] = affine_map<(d0, d1, d2) -> (d2 floordiv 3, d1)>
+// CHECK-LABEL: func @columnQuantized
+func @columnQuantized(%lhs: tensor<1x3xf32>, %acc: tensor<1x2xf32>) -> tensor<1x2xf32> {
+  //  CHECK-DAG: constant dense<{{\[}}[127, -127], [0, 127], [-127, 0]]> : tensor<3x2xi8>
+  //  CHECK-DAG: constant dense<{{\[}}[2.000000e+00, 1.000000e+00]]> : tensor<1x2xf32>
+  //      CHECK: linalg.generic
+  // CHECK-SAME:     indexing_maps = [#{{.+}}, #{{.+}}, #[[$SCALE_MAP]], #{{.+}}]
+  %rhs = constant dense<[[254.0, -127.0], [0.0, 127.0], [-254.0, 0.0]]> : tensor<3x2xf32>
+  %0 = linalg.matmul ins(%lhs, %rhs : tensor<1x3xf32>, tensor<3x2xf32>) outs(%acc : tensor<1x2xf32>) -> tensor<1x2xf32>
+  return %0 : tensor<1x2xf32>
+}
+
+// -----
+
+// Non-constant weights are left as matmuls.
+
+// CHECK-LABEL: func @dynamicWeights
+func @dynamicWeights(%lhs: tensor<3x4xf32>, %rhs: tensor<4x2xf32>, %acc: tensor<3x2xf32>) -> tensor<3x2xf32> {
+  // CHECK: linalg.matmul
+  %0 = linalg.matmul ins(%lhs, %rhs : tensor<3x4xf32>, tensor<4x2xf32>) outs(%acc : tensor<3x2xf32>) -> tensor<3x2xf32>
+  return %0 : tensor<3x2xf32>
+}
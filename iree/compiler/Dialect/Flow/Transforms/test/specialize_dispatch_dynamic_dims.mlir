@@ -0,0 +1,64 @@
+// RUN: iree-opt -split-input-file -iree-flow-specialize-dispatch-dynamic-dims="buckets=1,8" %s | IreeFileCheck %s
+
+// CHECK-LABEL: func @dynamicBatch
+// CHECK-SAME: (%[[ARG0:.+]]: tensor<?x4xf32>, %[[DIM:.+]]: index)
+func @dynamicBatch(%arg0: tensor<?x4xf32>, %dim: index) -> tensor<?x4xf32> {
+  %x = constant 100 : index
+  //      CHECK: %[[C1:.+]] = constant 1 : index
+  // CHECK-NEXT: %[[IS_1:.+]] = cmpi eq, %[[DIM]], %[[C1]] : index
+  // CHECK-NEXT: cond_br %[[IS_1]], ^bb1, ^bb2
+
+  //      CHECK: ^bb1:
+  // CHECK-NEXT: %[[D1:.+]] = constant 1 : index
+  // CHECK-NEXT: %[[RET1:.+]] = flow.dispatch.workgroups[%{{.+}}, %[[D1]]](%[[ARG0]], %[[D1]]) : (tensor<?x4xf32>{%[[D1]]}, index) -> tensor<?x4xf32>{%[[D1]]}
+  // CHECK-NEXT: (%{{.+}}: !flow.dispatch.tensor<readonly:?x4xf32>, %{{.+}}: index, %{{.+}}: !flow.dispatch.tensor<writeonly:?x4xf32>) {
+  // CHECK-NEXT:   %[[INNER_D1:.+]] = constant 1 : index
+  // CHECK-NEXT:   "test.sink"(%[[INNER_D1]])
+  //      CHECK: br ^bb5(%[[RET1]] : tensor<?x4xf32>)
+
+  //      CHECK: ^bb2:
+  //      CHECK: %[[C8:.+]] = constant 8 : index
+  // CHECK-NEXT: %[[IS_8:.+]] = cmpi eq, %[[DIM]], %[[C8]] : index
+  // CHECK-NEXT: cond_br %[[IS_8]], ^bb3, ^bb4
+
+  //      CHECK: ^bb3:
+  //      CHECK: %[[INNER_D8:.+]] = constant 8 : index
+  // CHECK-NEXT: "test.sink"(%[[INNER_D8]])
+  //      CHECK: br ^bb5
+
+  // The original dispatch is kept as the generic fallback.
+  //      CHECK: ^bb4:
+  // CHECK-NEXT: %[[RET:.+]] = flow.dispatch.workgroups[%{{.+}}, %[[DIM]]](%[[ARG0]], %[[DIM]])
+  // CHECK-NEXT: (%{{.+}}: !flow.dispatch.tensor<readonly:?x4xf32>, %[[INNER_DIM:.+]]: index, %{{.+}}: !flow.dispatch.tensor<writeonly:?x4xf32>) {
+  // CHECK-NEXT:   "test.sink"(%[[INNER_DIM]])
+  //      CHECK: br ^bb5(%[[RET]] : tensor<?x4xf32>)
+
+  //      CHECK: ^bb5(%[[JOINED:.+]]: tensor<?x4xf32>):
+  // CHECK-NEXT: %[[SHAPE:.+]] = shapex.make_ranked_shape %[[DIM]] : (index) -> !shapex.ranked_shape<[?,4]>
+  // CHECK-NEXT: %[[TIED:.+]] = shapex.tie_shape %[[JOINED]], %[[SHAPE]]
+  %0 = flow.dispatch.workgroups[%x, %dim](%arg0, %dim) : (tensor<?x4xf32>{%dim}, index) -> tensor<?x4xf32>{%dim} = (
+    %arg: !flow.dispatch.tensor<readonly:?x4xf32>, %arg_dim: index, %ret: !flow.dispatch.tensor<writeonly:?x4xf32>
+  ) {
+    "test.sink"(%arg_dim) : (index) -> ()
+    flow.return
+  }
+  // CHECK-NEXT: return %[[TIED]]
+  return %0 : tensor<?x4xf32>
+}
+
+// -----
+
+// Static dispatches are left as-is.
+
+// CHECK-LABEL: func @staticDispatch
+func @staticDispatch(%arg0: tensor<8x4xf32>) -> tensor<8x4xf32> {
+  %x = constant 100 : index
+  // CHECK-NOT: cond_br
+  // CHECK: flow.dispatch.workgroups
+  %0 = flow.dispatch.workgroups[%x](%arg0) : (tensor<8x4xf32>) -> tensor<8x4xf32> = (
+    %arg: !flow.dispatch.tensor<readonly:8x4xf32>, %ret: !flow.dispatch.tensor<writeonly:8x4xf32>
+  ) {
+    flow.return
+  }
+  return %0 : tensor<8x4xf32>
+}
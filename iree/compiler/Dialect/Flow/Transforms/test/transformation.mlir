@@ -54,12 +54,9 @@ func @interleavedDot(%arg0 : tensor<4x4xf32>) -> tensor<4x4xf32> {
 //  CHECK-NEXT:   module {
 //  CHECK-NEXT:     func @interleavedDot_dispatch_1
 //       CHECK:       %{{.+}} = linalg.matmul
-//       CHECK: flow.executable @interleavedDot_dispatch_2 attributes {sym_visibility = "private"} {
-//  CHECK-NEXT:   flow.dispatch.entry @interleavedDot_dispatch_2
-//  CHECK-NEXT:   module {
-//  CHECK-NEXT:     func @interleavedDot_dispatch_2
 //       CHECK:       %{{.+}} = linalg.generic
 //       CHECK:         %{{.+}} = mulf %{{.+}}, %{{.+}} : f32
+//   CHECK-NOT: flow.executable @interleavedDot_dispatch_2
 //       CHECK: func @interleavedDot(%arg0: tensor<4x4xf32>) -> tensor<4x4xf32> {
 //  CHECK-NEXT:   %0 = flow.ex.stream.fragment(%arg0) : (tensor<4x4xf32>) -> tensor<4x4xf32> =
 //  CHECK-NEXT:        (%arg1: tensor<4x4xf32>) -> tensor<4x4xf32> {
@@ -67,8 +64,7 @@ func @interleavedDot(%arg0 : tensor<4x4xf32>) -> tensor<4x4xf32> {
 //   CHECK-DAG:     %[[C4:.+]] = constant 4 : index
 //  CHECK-NEXT:     %1 = flow.dispatch @interleavedDot_dispatch_0::@interleavedDot_dispatch_0[%[[C4]], %[[C4]], %[[C1]]](%arg1) : (tensor<4x4xf32>) -> tensor<4x4xf32>
 //  CHECK-NEXT:     %2 = flow.dispatch @interleavedDot_dispatch_1::@interleavedDot_dispatch_1[%[[C4]], %[[C4]], %[[C1]]](%1, %arg1) : (tensor<4x4xf32>, tensor<4x4xf32>) -> tensor<4x4xf32>
-//  CHECK-NEXT:     %3 = flow.dispatch @interleavedDot_dispatch_2::@interleavedDot_dispatch_2[%[[C4]], %[[C4]], %[[C1]]](%2, %arg1) : (tensor<4x4xf32>, tensor<4x4xf32>) -> tensor<4x4xf32>
-//  CHECK-NEXT:     flow.return %3 : tensor<4x4xf32>
+//  CHECK-NEXT:     flow.return %2 : tensor<4x4xf32>
 //  CHECK-NEXT:   }
 //  CHECK-NEXT:   return %0 : tensor<4x4xf32>
 //  CHECK-NEXT: }
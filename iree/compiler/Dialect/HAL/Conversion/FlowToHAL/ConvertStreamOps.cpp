@@ -14,6 +14,7 @@
 #include "iree/compiler/Dialect/HAL/Utils/TypeUtils.h"
 #include "iree/compiler/Dialect/Shape/IR/Builders.h"
 #include "iree/compiler/Dialect/Shape/IR/ShapeOps.h"
+#include "iree/compiler/Dialect/Util/IR/UtilOps.h"
 #include "iree/compiler/Dialect/Util/IR/UtilTypes.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/Support/Debug.h"
@@ -123,7 +124,9 @@ using LivenessIntervalMap = DenseMap<Value, LivenessInterval>;
 using LivenessIntervalList = SmallVector<LivenessInterval>;
 
 // Computes the liveness intervals for each value in the stream.
-// Returns a closed range over an arbitrary operation ordering. The LIVE_IN and
+// Returns a closed range over the execution waves of the stream ops such that
+// values produced or used by ops that may execute concurrently are considered
+// live at the same time. The LIVE_IN and
 // LIVE_OUT sentinels will be used to indicate values that are live-in and
 // live-out to the stream (captured input arguments and escaping output
 // results).
@@ -134,7 +137,8 @@ using LivenessIntervalList = SmallVector<LivenessInterval>;
 // lifetime.
 static LivenessIntervalList computeLivenessIntervals(
     IREE::Flow::ExStreamFragmentOp streamOp,
-    const ValueAliasingMap &valueAliases) {
+    const ValueAliasingMap &valueAliases,
+    const DenseMap<Operation *, int> &executionWaves) {
   // Perform a liveness analysis on the stream fragment.
   // Fragments have a single block and as such the live-in/live-out block
   // information derived here applies to the entire stream region.
@@ -143,11 +147,12 @@ static LivenessIntervalList computeLivenessIntervals(
   Liveness streamLiveness(streamOp);
   auto *livenessInfo = streamLiveness.getLiveness(streamBlock);
 
-  // Operations don't allow us to get their already computed order so we make up
-  // our own. We have a single block and thus the ordering is complete.
+  // Ops within the same execution wave share the same point in the ordering as
+  // they may execute concurrently. We have a single block and thus the ordering
+  // is complete.
   DenseMap<Operation *, int> opOrdering;
   for (auto &op : *streamBlock) {
-    opOrdering[&op] = opOrdering.size();
+    opOrdering[&op] = executionWaves.lookup(&op);
   }
 
   // Liveness doesn't track return values as live-outs so we do that here.
@@ -242,6 +247,13 @@ struct BufferRange {
   Value length = nullptr;
 };
 
+// Returns true if the devices of the module containing |op| share memory
+// allocated from the shared device (see AssignTargetDevices).
+static bool hasUnifiedMemory(Operation *op) {
+  auto moduleOp = op->getParentOfType<ModuleOp>();
+  return moduleOp && moduleOp->hasAttr("hal.device.unified_memory");
+}
+
 // State cache used during stream scheduling.
 //
 // This contains caches used to memoize commonly occuring values such as
@@ -395,6 +407,18 @@ class StreamSchedulingState {
     }
   }
 
+  // Maps |dispatchOp| to the load of the x component of the workgroup count it
+  // reads on the device (see matchIndirectWorkgroupCount).
+  void mapIndirectWorkgroupCount(Operation *dispatchOp,
+                                 IREE::Flow::TensorLoadOp loadOp) {
+    indirectWorkgroupCountMap.insert(std::make_pair(dispatchOp, loadOp));
+  }
+
+  // Returns the load mapped to |dispatchOp|, if any.
+  IREE::Flow::TensorLoadOp lookupIndirectWorkgroupCount(Operation *dispatchOp) {
+    return indirectWorkgroupCountMap.lookup(dispatchOp);
+  }
+
  private:
   Value getElementType(Type elementType, OpBuilder &builder) {
     auto it = memoizedElementTypesConstants.find(elementType);
@@ -457,6 +481,10 @@ class StreamSchedulingState {
 
   // Maps tensor values inside the stream to a buffer range that stores them.
   DenseMap<Value, BufferRange> bufferRangeMap;
+
+  // Dispatches reading their workgroup count on the device -> the load of the
+  // x component of the workgroup count.
+  DenseMap<Operation *, IREE::Flow::TensorLoadOp> indirectWorkgroupCountMap;
 };
 
 //===----------------------------------------------------------------------===//
@@ -650,9 +678,16 @@ static LogicalResult allocateTransientBuffers(
       dynamicSliceSizes);
 
   // Allocate the transient storage buffer.
+  // The storage only backs values that do not escape the stream and is marked
+  // transient so that runtimes can scope it to the invocation.
   // TODO(benvanik): compute from SSA use-def chain uses.
   IREE::HAL::MemoryTypeBitfield memoryTypes =
+      IREE::HAL::MemoryTypeBitfield::Transient |
       IREE::HAL::MemoryTypeBitfield::DeviceLocal;
+  if (hasUnifiedMemory(streamOp)) {
+    // Other devices access the storage through the host mapping.
+    memoryTypes = memoryTypes | IREE::HAL::MemoryTypeBitfield::HostVisible;
+  }
   IREE::HAL::BufferUsageBitfield bufferUsage =
       IREE::HAL::BufferUsageBitfield::Dispatch |
       IREE::HAL::BufferUsageBitfield::Transfer;
@@ -885,6 +920,123 @@ static std::array<Value, 3> calculateDispatchWorkgroupCount(
   return calculateWorkloadWorkgroupCount(loc, workload, workgroupSize, builder);
 }
 
+// Returns the ordinal of the device |streamOp| is assigned to with a
+// hal.device.affinity attribute (see AssignDeviceAffinities). Streams without
+// an affinity execute on the shared device (ordinal 0).
+static int64_t getStreamAffinity(IREE::Flow::ExStreamFragmentOp streamOp) {
+  if (auto affinityAttr =
+          streamOp->getAttrOfType<IntegerAttr>("hal.device.affinity")) {
+    return affinityAttr.getInt();
+  }
+  return 0;
+}
+
+// Returns true if |operand| of a stream executing on the device with
+// |affinity| is resident on another device and must be copied. Values not
+// produced by a stream (arguments, constants, etc) are on the shared device.
+// Devices with unified memory use each other's buffers directly.
+static bool isPeerOperand(Value operand, int64_t affinity,
+                          bool unifiedMemory) {
+  if (unifiedMemory) return false;
+  int64_t operandAffinity = 0;
+  if (auto producerOp =
+          operand.getDefiningOp<IREE::Flow::ExStreamFragmentOp>()) {
+    operandAffinity = getStreamAffinity(producerOp);
+  }
+  return operandAffinity != affinity;
+}
+
+// Returns the flow.tensor.load ops of the (x, y, z) workgroup count of
+// |dispatchOp| if they can be read by the device with an indirect dispatch
+// instead of on the host. This is the case when the workgroup count is loaded
+// from three consecutive elements of an i32 tensor used for nothing else on
+// the host and every target dispatches the workload unmodified. Data-dependent
+// workgroup counts computed by a preceding dispatch then stay on the device
+// and the host does not need to wait for the dispatch to read them back.
+static SmallVector<IREE::Flow::TensorLoadOp, 3> matchIndirectWorkgroupCount(
+    IREE::Flow::DispatchOp dispatchOp) {
+  auto streamOp = dispatchOp->getParentOfType<IREE::Flow::ExStreamFragmentOp>();
+  if (!streamOp || dispatchOp.workgroup_count().size() != 3) return {};
+  auto &entryBlock = streamOp.body().front();
+  SmallVector<IREE::Flow::TensorLoadOp, 3> loadOps;
+  for (auto value : dispatchOp.workgroup_count()) {
+    auto blockArg = value.dyn_cast<BlockArgument>();
+    if (!blockArg || blockArg.getOwner() != &entryBlock ||
+        !blockArg.hasOneUse()) {
+      return {};
+    }
+    auto operand = streamOp.operands()[blockArg.getArgNumber()];
+    auto castOp = operand.getDefiningOp<IndexCastOp>();
+    if (!castOp || !operand.hasOneUse()) return {};
+    auto loadOp = castOp.getOperand().getDefiningOp<IREE::Flow::TensorLoadOp>();
+    if (!loadOp || !loadOp.result().hasOneUse()) return {};
+    loadOps.push_back(loadOp);
+  }
+
+  // The elements must be x, y, z in order within a single rank-1 i32 tensor
+  // resident on the device executing the dispatch.
+  auto source = loadOps.front().source();
+  auto sourceType = source.getType().cast<ShapedType>();
+  if (!sourceType.hasStaticShape() || sourceType.getRank() != 1 ||
+      !sourceType.getElementType().isInteger(32)) {
+    return {};
+  }
+  int64_t firstIndex = 0;
+  for (auto it : llvm::enumerate(loadOps)) {
+    APInt index;
+    if (it.value().source() != source ||
+        !matchPattern(it.value().indices().front(), m_ConstantInt(&index))) {
+      return {};
+    }
+    if (it.index() == 0) firstIndex = index.getSExtValue();
+    if (index.getSExtValue() != firstIndex + it.index()) return {};
+  }
+  if (isPeerOperand(source, getStreamAffinity(streamOp),
+                    hasUnifiedMemory(streamOp))) {
+    return {};
+  }
+
+  // All targets must use the workload as the workgroup count.
+  auto executableOp = dyn_cast_or_null<IREE::HAL::ExecutableOp>(
+      SymbolTable::lookupNearestSymbolFrom(dispatchOp,
+                                           dispatchOp.executable()));
+  if (!executableOp) return {};
+  for (auto variantOp :
+       executableOp.getBlock().getOps<IREE::HAL::ExecutableVariantOp>()) {
+    for (auto entryPointOp :
+         variantOp.getBlock().getOps<IREE::HAL::ExecutableEntryPointOp>()) {
+      if (entryPointOp.getName() !=
+          dispatchOp.entry_point().getLeafReference()) {
+        continue;
+      }
+      Region *region = entryPointOp.getBody();
+      if (!region) continue;
+      Block &body = region->front();
+      auto returnOp = cast<IREE::HAL::ReturnOp>(body.getTerminator());
+      for (auto it : llvm::enumerate(returnOp.operands())) {
+        if (it.value() != body.getArgument(it.index())) return {};
+      }
+    }
+  }
+  return loadOps;
+}
+
+// Returns true if |loadOp| only loads part of a workgroup count that is read
+// by the device instead (see matchIndirectWorkgroupCount).
+static bool isIndirectWorkgroupCountLoad(IREE::Flow::TensorLoadOp loadOp) {
+  if (!loadOp.result().hasOneUse()) return false;
+  auto castOp = dyn_cast<IndexCastOp>(*loadOp.result().user_begin());
+  if (!castOp || !castOp.getResult().hasOneUse()) return false;
+  auto &use = *castOp.getResult().use_begin();
+  auto streamOp = dyn_cast<IREE::Flow::ExStreamFragmentOp>(use.getOwner());
+  if (!streamOp) return false;
+  auto blockArg = streamOp.body().front().getArgument(use.getOperandNumber());
+  if (!blockArg.hasOneUse()) return false;
+  auto dispatchOp = dyn_cast<IREE::Flow::DispatchOp>(*blockArg.user_begin());
+  if (!dispatchOp) return false;
+  return llvm::is_contained(matchIndirectWorkgroupCount(dispatchOp), loadOp);
+}
+
 // Records a dispatch operation.
 static LogicalResult recordDispatch(Value device, Value commandBuffer,
                                     IREE::Flow::DispatchOp &dispatchOp,
@@ -902,6 +1054,24 @@ static LogicalResult recordDispatch(Value device, Value commandBuffer,
     workgroupCount.push_back(rewriter.getRemappedValue(dim));
   }
 
+  // Workgroup counts produced on the device are read from their buffer.
+  Value workgroupsBuffer;
+  Value workgroupsOffset;
+  if (auto loadOp = schedulingState.lookupIndirectWorkgroupCount(dispatchOp)) {
+    auto source = IREE::HAL::TensorRewriteAdaptor::getChecked(
+        loc, loadOp.source(), rewriter.getRemappedValue(loadOp.source()),
+        rewriter);
+    if (!source.hasValue()) {
+      return loadOp.emitOpError() << "cannot create adaptor for source";
+    }
+    SmallVector<Value> indices;
+    for (auto index : loadOp.indices()) {
+      indices.push_back(rewriter.getRemappedValue(index));
+    }
+    workgroupsBuffer = source->getBuffer();
+    workgroupsOffset = source->computeOffset(indices);
+  }
+
   // Ask each target backend to record their dispatch logic.
   IREE::HAL::DeviceSwitchRewriter switchRewriter(loc,
                                                  /*resultTypes=*/TypeRange{},
@@ -943,18 +1113,21 @@ static LogicalResult recordDispatch(Value device, Value commandBuffer,
         executableOp.getName(),
         {caseBuilder.getSymbolRefAttr(entryPointOp->getParentOp()),
          caseBuilder.getSymbolRefAttr(entryPointOp)});
-    auto caseWorkgroupCount = calculateDispatchWorkgroupCount(
-        loc, executableOp, entryPointOp, workgroupCount, caseBuilder);
-    caseBuilder.create<IREE::HAL::CommandBufferDispatchSymbolOp>(
-        loc, commandBuffer, entryPointSymRef, caseWorkgroupCount[0],
-        caseWorkgroupCount[1], caseWorkgroupCount[2]);
+    if (workgroupsBuffer) {
+      caseBuilder.create<IREE::HAL::CommandBufferDispatchIndirectSymbolOp>(
+          loc, commandBuffer, entryPointSymRef, workgroupsBuffer,
+          workgroupsOffset);
+    } else {
+      auto caseWorkgroupCount = calculateDispatchWorkgroupCount(
+          loc, executableOp, entryPointOp, workgroupCount, caseBuilder);
+      caseBuilder.create<IREE::HAL::CommandBufferDispatchSymbolOp>(
+          loc, commandBuffer, entryPointSymRef, caseWorkgroupCount[0],
+          caseWorkgroupCount[1], caseWorkgroupCount[2]);
+    }
 
     caseBuilder.create<IREE::HAL::ReturnOp>(loc);
   }
   switchRewriter.build();
-
-  // Full barriers for now as we aren't scheduling things in waves.
-  recordFullExecutionBarrier(commandBuffer, dispatchOp.getLoc(), rewriter);
   return success();
 }
 
@@ -1017,9 +1190,6 @@ static LogicalResult recordTensorSplat(Value device, Value commandBuffer,
   rewriter.create<IREE::HAL::CommandBufferFillBufferOp>(
       splatOp.getLoc(), commandBuffer, resultBuffer.buffer, zeroOffset,
       resultBuffer.length, pattern);
-
-  // Full barriers for now as we aren't scheduling things.
-  recordFullExecutionBarrier(commandBuffer, splatOp.getLoc(), rewriter);
   return success();
 }
 
@@ -1037,9 +1207,6 @@ static LogicalResult recordTensorClone(Value device, Value commandBuffer,
       // Note: we use the result buffer's length here deliberately to handle the
       // case where the source buffer can be the constant pool buffer.
       resultBuffer.buffer, zeroOffset, resultBuffer.length);
-
-  // Full barriers for now as we aren't scheduling things.
-  recordFullExecutionBarrier(commandBuffer, cloneOp.getLoc(), rewriter);
   return success();
 }
 
@@ -1076,11 +1243,6 @@ static LogicalResult recordTensorSlice(Value device, Value commandBuffer,
   rewriter.create<IREE::HAL::CommandBufferCopyBufferOp>(
       sliceOp.getLoc(), commandBuffer, sourceBuffer.buffer, sourceRange->offset,
       resultBuffer.buffer, zeroOffset, sourceRange->length);
-
-  // Full barriers for now as we aren't scheduling things.
-  // TODO(benvanik): don't add at the end of the command buffer (we could
-  // also do a canonicalization step that removed trailing barriers).
-  recordFullExecutionBarrier(commandBuffer, sliceOp.getLoc(), rewriter);
   return success();
 }
 
@@ -1120,11 +1282,6 @@ static LogicalResult recordTensorUpdate(Value device, Value commandBuffer,
   rewriter.create<IREE::HAL::CommandBufferCopyBufferOp>(
       updateOp.getLoc(), commandBuffer, updateBuffer.buffer, zeroOffset,
       targetBuffer.buffer, targetRange->offset, targetRange->length);
-
-  // Full barriers for now as we aren't scheduling things.
-  // TODO(benvanik): don't add at the end of the command buffer (we could
-  // also do a canonicalization step that removed trailing barriers).
-  recordFullExecutionBarrier(commandBuffer, updateOp.getLoc(), rewriter);
   return success();
 }
 
@@ -1138,11 +1295,29 @@ static void hoistConstants(Block &streamBlock,
   }
 }
 
+// Records all commands in |streamBlock| into |commandBuffer|.
+// Commands are grouped by their |executionWaves| and full barriers are only
+// recorded between waves such that the commands within a wave may execute
+// concurrently.
 static LogicalResult recordStreamCommands(
     Value device, Value commandBuffer, Block &streamBlock,
+    const DenseMap<Operation *, int> &executionWaves,
     StreamSchedulingState &schedulingState,
     ConversionPatternRewriter &rewriter) {
+  Operation *lastCommandOp = nullptr;
+  auto beginCommand = [&](Operation &op) {
+    if (lastCommandOp &&
+        executionWaves.lookup(lastCommandOp) != executionWaves.lookup(&op)) {
+      recordFullExecutionBarrier(commandBuffer, op.getLoc(), rewriter);
+    }
+    lastCommandOp = &op;
+  };
   for (auto &op : streamBlock) {
+    if (isa<IREE::Flow::DispatchOp, IREE::Flow::TensorSplatOp,
+            IREE::Flow::TensorCloneOp, IREE::Flow::TensorSliceOp,
+            IREE::Flow::TensorUpdateOp>(op)) {
+      beginCommand(op);
+    }
     if (auto dispatchOp = dyn_cast<IREE::Flow::DispatchOp>(op)) {
       if (failed(recordDispatch(device, commandBuffer, dispatchOp,
                                 schedulingState, rewriter))) {
@@ -1183,9 +1358,89 @@ static LogicalResult recordStreamCommands(
       return op.emitOpError() << "unexpected in stream";
     }
   }
+
+  // Full barrier at the end of the command buffer to complete the last wave.
+  // TODO(benvanik): don't add at the end of the command buffer (we could
+  // also do a canonicalization step that removed trailing barriers).
+  if (lastCommandOp) {
+    recordFullExecutionBarrier(commandBuffer, lastCommandOp->getLoc(),
+                               rewriter);
+  }
   return success();
 }
 
+// Returns the op in the parent block of |streamOp| before which the host must
+// wait for the stream to complete. Ops that have no side effects and do not
+// use any of the stream operands or results can execute on the host while the
+// device is executing the stream. Subsequent streams are submitted without
+// waiting as they wait on the device for the submissions still in flight (see
+// findInFlightSubmission), including those reading workgroup counts produced
+// by the stream (see matchIndirectWorkgroupCount). Any other op that uses a
+// stream value, may have side effects (including host readback), or transfers
+// control must wait.
+static Operation *findStreamAwaitPoint(IREE::Flow::ExStreamFragmentOp streamOp,
+                                       ValueRange newOperands) {
+  SmallPtrSet<Value, 8> streamValues;
+  streamValues.insert(streamOp->operand_begin(), streamOp->operand_end());
+  streamValues.insert(newOperands.begin(), newOperands.end());
+  streamValues.insert(streamOp->result_begin(), streamOp->result_end());
+  for (auto *op = streamOp->getNextNode(); op; op = op->getNextNode()) {
+    if (isa<IREE::Flow::ExStreamFragmentOp>(op)) continue;
+    if (auto loadOp = dyn_cast<IREE::Flow::TensorLoadOp>(op)) {
+      if (isIndirectWorkgroupCountLoad(loadOp)) continue;
+    }
+    if (op->hasTrait<OpTrait::IsTerminator>() || op->getNumRegions() > 0 ||
+        !MemoryEffectOpInterface::hasNoEffect(op)) {
+      return op;
+    }
+    if (llvm::any_of(op->getOperands(), [&](Value operand) {
+          return streamValues.count(operand) > 0;
+        })) {
+      return op;
+    }
+  }
+  return streamOp->getBlock()->getTerminator();
+}
+
+// Returns the last submission preceding |streamOp| in its block if the host
+// has not awaited its completion yet. As each stream submission waits on the
+// one in flight before it, waiting on it orders |streamOp| after all of the
+// prior streams in the block.
+static IREE::HAL::DeviceQueueSubmitOp findInFlightSubmission(
+    IREE::Flow::ExStreamFragmentOp streamOp) {
+  SmallPtrSet<Value, 4> awaitedSemaphores;
+  for (auto *op = streamOp->getPrevNode(); op; op = op->getPrevNode()) {
+    if (auto awaitOp = dyn_cast<IREE::HAL::SemaphoreAwaitOp>(op)) {
+      awaitedSemaphores.insert(awaitOp.semaphore());
+    } else if (auto submitOp = dyn_cast<IREE::HAL::DeviceQueueSubmitOp>(op)) {
+      if (awaitedSemaphores.count(submitOp.signal_semaphore())) return {};
+      return submitOp;
+    }
+  }
+  return {};
+}
+
+// Copies |bufferRange| resident on another device into a new buffer allocated
+// from |schedulingState|'s allocator. The copy happens on the host and all
+// work on the other device must have completed.
+static BufferRange copyPeerBuffer(Location loc, BufferRange bufferRange,
+                                  StreamSchedulingState &schedulingState,
+                                  ConversionPatternRewriter &rewriter) {
+  auto memoryTypes = IREE::HAL::MemoryTypeBitfield::DeviceLocal |
+                     IREE::HAL::MemoryTypeBitfield::HostVisible;
+  auto bufferUsage = IREE::HAL::BufferUsageBitfield::All;
+  auto buffer = rewriter
+                    .create<IREE::HAL::AllocatorAllocateOp>(
+                        loc, IREE::HAL::BufferType::get(rewriter.getContext()),
+                        schedulingState.allocator(), memoryTypes, bufferUsage,
+                        bufferRange.length)
+                    .getResult();
+  auto zero = schedulingState.lookupOrCreateIndex(0, rewriter);
+  rewriter.create<IREE::HAL::ExBufferCopyOp>(
+      loc, bufferRange.buffer, zero, buffer, zero, bufferRange.length);
+  return BufferRange{buffer, bufferRange.length};
+}
+
 class ExStreamFragmentOpConversion
     : public OpConversionPattern<IREE::Flow::ExStreamFragmentOp> {
  public:
@@ -1198,13 +1453,30 @@ class ExStreamFragmentOpConversion
         newOperands, streamOp->getAttrDictionary());
 
     auto valueAliases = computeValueAliases(streamOp);
-    auto livenessIntervals = computeLivenessIntervals(streamOp, valueAliases);
-
-    auto device =
-        rewriter.createOrFold<IREE::HAL::ExSharedDeviceOp>(streamOp.getLoc());
-    auto allocator =
-        rewriter.create<IREE::HAL::DeviceAllocatorOp>(streamOp.getLoc(), device)
-            .getResult();
+    auto executionWaves = streamOp.computeExecutionWaves();
+    auto livenessIntervals =
+        computeLivenessIntervals(streamOp, valueAliases, executionWaves);
+
+    // Streams assigned to devices other than the shared device use the device
+    // with their affinity ordinal.
+    int64_t affinity = getStreamAffinity(streamOp);
+    Value device =
+        affinity == 0
+            ? rewriter.createOrFold<IREE::HAL::ExSharedDeviceOp>(
+                  streamOp.getLoc())
+            : rewriter.createOrFold<IREE::HAL::ExDeviceOp>(streamOp.getLoc(),
+                                                            affinity);
+    // With unified memory all buffers are allocated from the shared device so
+    // that they can be passed between devices without copies.
+    bool unifiedMemory = hasUnifiedMemory(streamOp);
+    Value allocatorDevice =
+        unifiedMemory ? rewriter.createOrFold<IREE::HAL::ExSharedDeviceOp>(
+                            streamOp.getLoc())
+                      : device;
+    auto allocator = rewriter
+                         .create<IREE::HAL::DeviceAllocatorOp>(
+                             streamOp.getLoc(), allocatorDevice)
+                         .getResult();
     StreamSchedulingState schedulingState(streamOp.getLoc(), device, allocator,
                                           valueAliases);
 
@@ -1217,6 +1489,31 @@ class ExStreamFragmentOpConversion
     // if recording, just hoist them out first to make dominance work out.
     hoistConstants(entryBlock, rewriter);
 
+    // Submissions to the same device wait on the one in flight on the device.
+    // When switching devices the host waits for the in-flight submission
+    // instead such that all work on other devices has completed whenever a
+    // stream is submitted. This orders the peer copies below after the work
+    // producing their source buffers.
+    auto priorSubmitOp = findInFlightSubmission(streamOp);
+    if (priorSubmitOp && IREE::HAL::ExDeviceOp::getDeviceOrdinal(
+                             priorSubmitOp.device()) != affinity) {
+      auto awaitOp = rewriter.create<IREE::HAL::SemaphoreAwaitOp>(
+          streamOp.getLoc(), rewriter.getIntegerType(32),
+          priorSubmitOp.signal_semaphore(), priorSubmitOp.signal_value());
+      rewriter.create<IREE::Util::StatusCheckOkOp>(
+          streamOp.getLoc(), awaitOp.status(), "stream execution failed");
+      priorSubmitOp = {};
+    }
+
+    // Dispatches reading their workgroup count on the device are matched before
+    // the stream captures they are matched through are replaced.
+    for (auto dispatchOp : entryBlock.getOps<IREE::Flow::DispatchOp>()) {
+      auto loadOps = matchIndirectWorkgroupCount(dispatchOp);
+      if (loadOps.empty()) continue;
+      schedulingState.mapIndirectWorkgroupCount(dispatchOp, loadOps.front());
+    }
+
+    SmallVector<Value> operandValues = llvm::to_vector<4>(adaptor.operands());
     for (int i = 0; i < adaptor.operands().size(); ++i) {
       auto streamValue = entryBlock.getArgument(i);
       auto bufferValue = adaptor.operands()[i];
@@ -1234,6 +1531,11 @@ class ExStreamFragmentOpConversion
               bufferValue,
               schedulingState.lookupOrComputeSize(streamValue, rewriter)};
         }
+        if (isPeerOperand(streamOp.operands()[i], affinity, unifiedMemory)) {
+          bufferRange = copyPeerBuffer(streamOp.getLoc(), bufferRange,
+                                       schedulingState, rewriter);
+          operandValues[i] = bufferRange.buffer;
+        }
         if (failed(schedulingState.mapTensorToBufferRange(streamValue,
                                                           bufferRange))) {
           return streamOp.emitOpError()
@@ -1266,11 +1568,9 @@ class ExStreamFragmentOpConversion
     }
 
     // Allocate and begin the command buffer.
-    // In a real version we would want to pick the device based on the placement
-    // information attached to the stream.
     // TODO(benvanik): choose buffer mode/category based on stream commands.
-    // NOTE: we are not doing any overlapping work today and can always allow
-    // inline execution.
+    // NOTE: commands within an execution wave may overlap but as barriers
+    // separate all dependent work we can still always allow inline execution.
     auto mode = IREE::HAL::CommandBufferModeBitfield::OneShot |
                 IREE::HAL::CommandBufferModeBitfield::AllowInlineExecution;
     auto category = IREE::HAL::CommandCategoryBitfield::Dispatch |
@@ -1285,25 +1585,52 @@ class ExStreamFragmentOpConversion
 
     // Record all of the commands into the command buffer.
     if (failed(recordStreamCommands(device, commandBuffer, entryBlock,
-                                    schedulingState, rewriter))) {
+                                    executionWaves, schedulingState,
+                                    rewriter))) {
       return failure();
     }
 
-    // End and submit the command buffer.
-    // In a real version we'd want to setup a semaphore chain instead of
-    // submitting and waiting.
+    // End and asynchronously submit the command buffer.
+    // The host only waits for the stream to complete at the first point it
+    // needs the results (or could otherwise observe the execution) such that
+    // independent host work can overlap with the device execution. Streams
+    // submitted while a prior one is still in flight wait on it on the device
+    // so that the host can enqueue several streams ahead.
     rewriter.create<IREE::HAL::CommandBufferEndOp>(streamOp.getLoc(),
                                                    commandBuffer);
-    rewriter.create<IREE::HAL::ExSubmitAndWaitOp>(streamOp.getLoc(), device,
-                                                  commandBuffer);
+    auto semaphoreValue =
+        rewriter.createOrFold<ConstantIndexOp>(streamOp.getLoc(), 1);
+    auto semaphore = rewriter.create<IREE::HAL::SemaphoreCreateOp>(
+        streamOp.getLoc(),
+        IREE::HAL::SemaphoreType::get(rewriter.getContext()), device,
+        rewriter.createOrFold<ConstantIndexOp>(streamOp.getLoc(), 0));
+    SmallVector<Value> waitSemaphores;
+    SmallVector<Value> waitValues;
+    if (priorSubmitOp) {
+      waitSemaphores.push_back(priorSubmitOp.signal_semaphore());
+      waitValues.push_back(priorSubmitOp.signal_value());
+    }
+    rewriter.create<IREE::HAL::DeviceQueueSubmitOp>(
+        streamOp.getLoc(), device, commandBuffer, waitSemaphores, waitValues,
+        semaphore, semaphoreValue);
+    {
+      OpBuilder::InsertionGuard g(rewriter);
+      rewriter.setInsertionPoint(
+          findStreamAwaitPoint(streamOp, adaptor.operands()));
+      auto awaitOp = rewriter.create<IREE::HAL::SemaphoreAwaitOp>(
+          streamOp.getLoc(), rewriter.getIntegerType(32), semaphore,
+          semaphoreValue);
+      rewriter.create<IREE::Util::StatusCheckOkOp>(
+          streamOp.getLoc(), awaitOp.status(), "stream execution failed");
+    }
 
     // It's annoying but we need to do this replacement at the very end as
     // otherwise we lose access to the original values (which we need for
     // shape information).
-    for (int i = 0; i < adaptor.operands().size(); ++i) {
-      if (adaptor.operands()[i].getType().isa<IREE::HAL::BufferType>()) {
+    for (int i = 0; i < operandValues.size(); ++i) {
+      if (operandValues[i].getType().isa<IREE::HAL::BufferType>()) {
         rewriter.replaceUsesOfBlockArgument(entryBlock.getArgument(i),
-                                            adaptor.operands()[i]);
+                                            operandValues[i]);
       }
     }
 
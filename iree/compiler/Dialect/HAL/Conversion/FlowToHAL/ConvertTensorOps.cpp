@@ -78,14 +78,15 @@ class TensorStoreOpConversion
   }
 };
 
-class TensorTraceOpConversion
-    : public OpConversionPattern<IREE::Flow::TensorTraceOp> {
+// Converts flow.tensor.trace/summarize to the equivalent buffer view op.
+template <typename SrcOp, typename DstOp>
+class TensorTraceOpConversion : public OpConversionPattern<SrcOp> {
  public:
   TensorTraceOpConversion(MLIRContext *ctx, TypeConverter &converter)
-      : OpConversionPattern(ctx) {}
+      : OpConversionPattern<SrcOp>(ctx) {}
 
   LogicalResult matchAndRewrite(
-      IREE::Flow::TensorTraceOp traceOp, llvm::ArrayRef<Value> rawOperands,
+      SrcOp traceOp, llvm::ArrayRef<Value> rawOperands,
       ConversionPatternRewriter &rewriter) const override {
     Location loc = traceOp.getLoc();
     SmallVector<Value, 4> bufferViews;
@@ -94,8 +95,8 @@ class TensorTraceOpConversion
           loc, traceOp.getOperand(operand.index()), operand.value(), rewriter);
       bufferViews.emplace_back(adaptor.getBufferView());
     }
-    rewriter.replaceOpWithNewOp<IREE::HAL::BufferViewTraceOp>(
-        traceOp, traceOp.keyAttr(), bufferViews);
+    rewriter.replaceOpWithNewOp<DstOp>(traceOp, traceOp.keyAttr(),
+                                       bufferViews);
     return success();
   }
 };
@@ -105,8 +106,13 @@ class TensorTraceOpConversion
 void populateFlowTensorToHALPatterns(MLIRContext *context,
                                      OwningRewritePatternList &patterns,
                                      TypeConverter &converter) {
-  patterns.insert<TensorLoadOpConversion, TensorStoreOpConversion,
-                  TensorTraceOpConversion>(context, converter);
+  patterns.insert<TensorLoadOpConversion, TensorStoreOpConversion>(context,
+                                                                  converter);
+  patterns.insert<TensorTraceOpConversion<IREE::Flow::TensorTraceOp,
+                                          IREE::HAL::BufferViewTraceOp>,
+                  TensorTraceOpConversion<IREE::Flow::TensorSummarizeOp,
+                                          IREE::HAL::BufferViewSummarizeOp>>(
+      context, converter);
 }
 
 }  // namespace iree_compiler
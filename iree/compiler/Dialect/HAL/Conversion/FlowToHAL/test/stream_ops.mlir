@@ -27,7 +27,7 @@ func @multipleDispatches(%input: tensor<128xf32>) -> tensor<128xf32> {
   // CHECK-SAME:   usage("Transfer|Mapping|Dispatch")
   // CHECK-SAME:   : !hal.buffer{%c512}
   //      CHECK: %[[TMP_BUF:.+]] = hal.allocator.allocate
-  // CHECK-SAME:   type("DeviceVisible|DeviceLocal")
+  // CHECK-SAME:   type("Transient|DeviceVisible|DeviceLocal")
   // CHECK-SAME:   usage("Transfer|Dispatch")
   // CHECK-SAME:   : !hal.buffer{%c512}
   //      CHECK: %[[CMD:.+]] = hal.command_buffer.create
@@ -64,7 +64,10 @@ func @multipleDispatches(%input: tensor<128xf32>) -> tensor<128xf32> {
     flow.return %2 : tensor<128xf32>
   }
   // CHECK: hal.command_buffer.end<%[[CMD]]
-  // CHECK-NEXT: hal.ex.submit_and_wait {{.+}}, %[[CMD]]
+  // CHECK: %[[SEMAPHORE:.+]] = hal.semaphore.create
+  // CHECK-NEXT: hal.device.queue.submit<{{.+}}> signal(%[[SEMAPHORE]], %[[C1:.+]]) commands(%[[CMD]])
+  // CHECK-NEXT: %[[STATUS:.+]] = hal.semaphore.await<%[[SEMAPHORE]] : !hal.semaphore> until(%[[C1]])
+  // CHECK-NEXT: util.status.check_ok %[[STATUS]]
   // CHECK-NEXT: return %[[RET_BUF]]
   return %0 : tensor<128xf32>
 }
@@ -75,6 +78,189 @@ func @multipleDispatches(%input: tensor<128xf32>) -> tensor<128xf32> {
 
 module attributes {hal.device.targets = [#hal.device.target<"vmvx">]} {
 
+// CHECK-LABEL: @overlapHostWork
+// CHECK-SAME: (%[[SRC_BUF:.+]]: !hal.buffer, %[[ARG1:.+]]: index)
+func @overlapHostWork(%arg0 : tensor<5x24x48xf32>, %arg1 : index) -> (tensor<5x24x48xf32>, index) {
+  // CHECK: %[[SEMAPHORE:.+]] = hal.semaphore.create
+  // CHECK-NEXT: hal.device.queue.submit<{{.+}}> signal(%[[SEMAPHORE]], %[[C1:.+]])
+  %0 = flow.ex.stream.fragment(%arg0) : (tensor<5x24x48xf32>) -> tensor<5x24x48xf32> =
+      (%arg2: tensor<5x24x48xf32>) -> tensor<5x24x48xf32> {
+    %1 = flow.tensor.clone %arg2 : tensor<5x24x48xf32>
+    flow.return %1 : tensor<5x24x48xf32>
+  }
+  // Independent host work is performed before waiting on the stream.
+  // CHECK-NEXT: %[[ADD:.+]] = addi %[[ARG1]], %[[ARG1]] : index
+  %2 = addi %arg1, %arg1 : index
+  // CHECK-NEXT: %[[STATUS:.+]] = hal.semaphore.await<%[[SEMAPHORE]] : !hal.semaphore> until(%[[C1]])
+  // CHECK-NEXT: util.status.check_ok %[[STATUS]]
+  // CHECK-NEXT: return {{.+}}, %[[ADD]]
+  return %0, %2 : tensor<5x24x48xf32>, index
+}
+
+}
+
+// -----
+
+module attributes {hal.device.targets = [#hal.device.target<"vmvx">]} {
+
+// CHECK-LABEL: @chainStreams
+func @chainStreams(%arg0 : tensor<5x24x48xf32>) -> tensor<5x24x48xf32> {
+  // CHECK: %[[SEMAPHORE0:.+]] = hal.semaphore.create
+  // CHECK-NEXT: hal.device.queue.submit<{{.+}}> signal(%[[SEMAPHORE0]], %[[C1:.+]])
+  // CHECK-NOT: hal.semaphore.await
+  %0 = flow.ex.stream.fragment(%arg0) : (tensor<5x24x48xf32>) -> tensor<5x24x48xf32> =
+      (%arg1: tensor<5x24x48xf32>) -> tensor<5x24x48xf32> {
+    %1 = flow.tensor.clone %arg1 : tensor<5x24x48xf32>
+    flow.return %1 : tensor<5x24x48xf32>
+  }
+  // The second stream waits on the first on the device instead of the host.
+  // CHECK: %[[SEMAPHORE1:.+]] = hal.semaphore.create
+  // CHECK-NEXT: hal.device.queue.submit<{{.+}}> wait([%[[SEMAPHORE0]]], [%[[C1]]]) signal(%[[SEMAPHORE1]], %[[C1]])
+  %2 = flow.ex.stream.fragment(%0) : (tensor<5x24x48xf32>) -> tensor<5x24x48xf32> =
+      (%arg1: tensor<5x24x48xf32>) -> tensor<5x24x48xf32> {
+    %3 = flow.tensor.clone %arg1 : tensor<5x24x48xf32>
+    flow.return %3 : tensor<5x24x48xf32>
+  }
+  // CHECK-DAG: hal.semaphore.await<%[[SEMAPHORE0]] : !hal.semaphore>
+  // CHECK-DAG: hal.semaphore.await<%[[SEMAPHORE1]] : !hal.semaphore>
+  // CHECK: return
+  return %2 : tensor<5x24x48xf32>
+}
+
+}
+
+// -----
+
+module attributes {hal.device.targets = [#hal.device.target<"vmvx">]} {
+
+hal.executable @ex0 {
+  hal.interface @interface {
+    hal.interface.binding @s0b0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @s0b1, set=0, binding=1, type="StorageBuffer", access="Write|Discard"
+  }
+  hal.executable.variant @vmvx, target = #hal.executable.target<"vmvx", "vmvx-bytecode-fb"> {
+    hal.executable.entry_point @entry0 attributes {
+      interface = @interface,
+      ordinal = 0 : index
+    }
+    module {}
+  }
+}
+
+// CHECK-LABEL: @indirectDispatch
+func @indirectDispatch(%arg0 : tensor<4xi32>, %arg1 : tensor<128xf32>) -> tensor<128xf32> {
+  // CHECK: %[[COUNT_BUF:.+]] = hal.allocator.allocate
+  // CHECK: %[[SEMAPHORE0:.+]] = hal.semaphore.create
+  // CHECK-NEXT: hal.device.queue.submit<{{.+}}> signal(%[[SEMAPHORE0]], %[[C1:.+]])
+  %0 = flow.ex.stream.fragment(%arg0) : (tensor<4xi32>) -> tensor<4xi32> =
+      (%arg2: tensor<4xi32>) -> tensor<4xi32> {
+    %1 = flow.tensor.clone %arg2 : tensor<4xi32>
+    flow.return %1 : tensor<4xi32>
+  }
+  // The workgroup count is read by the device from the buffer it was produced
+  // in without the host waiting for it to be produced or reading it back.
+  // CHECK-NOT: hal.semaphore.await
+  // CHECK-NOT: hal.buffer.load
+  %c1 = constant 1 : index
+  %c2 = constant 2 : index
+  %c3 = constant 3 : index
+  %2 = flow.tensor.load %0[%c1] : tensor<4xi32>
+  %3 = flow.tensor.load %0[%c2] : tensor<4xi32>
+  %4 = flow.tensor.load %0[%c3] : tensor<4xi32>
+  %x = index_cast %2 : i32 to index
+  %y = index_cast %3 : i32 to index
+  %z = index_cast %4 : i32 to index
+  //      CHECK: %[[CMD:.+]] = hal.command_buffer.create
+  //      CHECK: hal.command_buffer.dispatch.indirect.symbol<%[[CMD]] : !hal.command_buffer>
+  // CHECK-SAME:   target(@ex0::@vmvx::@entry0)
+  // CHECK-SAME:   workgroups(%[[COUNT_BUF]] : !hal.buffer)[%c4]
+  //      CHECK: hal.device.queue.submit<{{.+}}> wait([%[[SEMAPHORE0]]], [%[[C1]]])
+  %5 = flow.ex.stream.fragment(%x, %y, %z, %arg1) : (index, index, index, tensor<128xf32>) -> tensor<128xf32> =
+      (%arg2: index, %arg3: index, %arg4: index, %arg5: tensor<128xf32>) -> tensor<128xf32> {
+    %6 = flow.dispatch @ex0::@entry0[%arg2, %arg3, %arg4](%arg5) {
+      hal.bindings = [
+        #hal.ex.operand_buffer<"s0b0", 0 : index>,
+        #hal.ex.result_buffer<"s0b1", 0 : index>
+      ]
+    } : (tensor<128xf32>) -> tensor<128xf32>
+    flow.return %6 : tensor<128xf32>
+  }
+  // CHECK: return
+  return %5 : tensor<128xf32>
+}
+
+}
+
+// -----
+
+module attributes {hal.device.targets = [#hal.device.target<"vmvx">]} {
+
+// CHECK-LABEL: @peerStreams
+func @peerStreams(%arg0 : tensor<5x24x48xf32>) -> tensor<5x24x48xf32> {
+  // CHECK: %[[SEMAPHORE0:.+]] = hal.semaphore.create
+  // CHECK-NEXT: hal.device.queue.submit<{{.+}}> signal(%[[SEMAPHORE0]], %[[C1:.+]])
+  %0 = flow.ex.stream.fragment(%arg0) : (tensor<5x24x48xf32>) -> tensor<5x24x48xf32> =
+      (%arg1: tensor<5x24x48xf32>) -> tensor<5x24x48xf32> {
+    %1 = flow.tensor.clone %arg1 : tensor<5x24x48xf32>
+    flow.return %1 : tensor<5x24x48xf32>
+  }
+  // The stream on the second device waits for the first on the host and then
+  // copies its result into a buffer allocated on the second device.
+  // CHECK: %[[DEVICE1:.+]] = hal.ex.device<1> : !hal.device
+  // CHECK: %[[ALLOCATOR1:.+]] = hal.device.allocator<%[[DEVICE1]] : !hal.device>
+  // CHECK: %[[STATUS:.+]] = hal.semaphore.await<%[[SEMAPHORE0]] : !hal.semaphore> until(%[[C1]])
+  // CHECK-NEXT: util.status.check_ok %[[STATUS]]
+  // CHECK: %[[PEER_BUF:.+]] = hal.allocator.allocate<%[[ALLOCATOR1]] : !hal.allocator>
+  // CHECK-NEXT: hal.ex.buffer.copy source(%{{.+}} : !hal.buffer)[%c0] target(%[[PEER_BUF]] : !hal.buffer)[%c0] length(%c23040)
+  // CHECK: hal.command_buffer.create device(%[[DEVICE1]] : !hal.device)
+  // CHECK: %[[SEMAPHORE1:.+]] = hal.semaphore.create device(%[[DEVICE1]] : !hal.device)
+  // CHECK-NEXT: hal.device.queue.submit<%[[DEVICE1]] : !hal.device> signal(%[[SEMAPHORE1]], %[[C1]])
+  %2 = flow.ex.stream.fragment(%0) : (tensor<5x24x48xf32>) -> tensor<5x24x48xf32> attributes {hal.device.affinity = 1 : index} =
+      (%arg1: tensor<5x24x48xf32>) -> tensor<5x24x48xf32> {
+    %3 = flow.tensor.clone %arg1 : tensor<5x24x48xf32>
+    flow.return %3 : tensor<5x24x48xf32>
+  }
+  // CHECK: hal.semaphore.await<%[[SEMAPHORE1]] : !hal.semaphore>
+  // CHECK: return
+  return %2 : tensor<5x24x48xf32>
+}
+
+}
+
+// -----
+
+module attributes {hal.device.targets = [#hal.device.target<"vulkan">, #hal.device.target<"cpu">], hal.device.unified_memory} {
+
+// CHECK-LABEL: @unifiedMemoryPeerStreams
+func @unifiedMemoryPeerStreams(%arg0 : tensor<5x24x48xf32>) -> tensor<5x24x48xf32> {
+  // CHECK: hal.device.queue.submit
+  %0 = flow.ex.stream.fragment(%arg0) : (tensor<5x24x48xf32>) -> tensor<5x24x48xf32> =
+      (%arg1: tensor<5x24x48xf32>) -> tensor<5x24x48xf32> {
+    %1 = flow.tensor.clone %arg1 : tensor<5x24x48xf32>
+    flow.return %1 : tensor<5x24x48xf32>
+  }
+  // Buffers are allocated from the shared device and used without copies.
+  // CHECK: %[[DEVICE1:.+]] = hal.ex.device<1> : !hal.device
+  // CHECK: %[[SHARED:.+]] = hal.ex.shared_device : !hal.device
+  // CHECK: hal.device.allocator<%[[SHARED]] : !hal.device>
+  // CHECK: hal.semaphore.await
+  // CHECK-NOT: hal.ex.buffer.copy
+  // CHECK: hal.command_buffer.create device(%[[DEVICE1]] : !hal.device)
+  %2 = flow.ex.stream.fragment(%0) : (tensor<5x24x48xf32>) -> tensor<5x24x48xf32> attributes {hal.device.affinity = 1 : index} =
+      (%arg1: tensor<5x24x48xf32>) -> tensor<5x24x48xf32> {
+    %3 = flow.tensor.clone %arg1 : tensor<5x24x48xf32>
+    flow.return %3 : tensor<5x24x48xf32>
+  }
+  // CHECK: return
+  return %2 : tensor<5x24x48xf32>
+}
+
+}
+
+// -----
+
+module attributes {hal.device.targets = [#hal.device.target<"vmvx">]} {
+
 // CHECK-LABEL: @tensorReshapePassThrough
 //  CHECK-SAME: (%[[SRC_BUF:.+]]:{{.+}})
 func @tensorReshapePassThrough(%arg0 : tensor<5x24x48xf32>) -> tensor<30x2x96xf32> {
@@ -140,7 +326,6 @@ func @tensorReshapeWithMultipleUses(%arg0 : tensor<5x24x48xf32>)
     // CHECK-SAME:     source(%[[SRC_BUF]] : !hal.buffer)[%c0]
     // CHECK-SAME:     target(%[[RET_BUF2]] : !hal.buffer)[%c0]
     // CHECK-SAME:     length(%c23040)
-    // CHECK-NEXT: hal.command_buffer.execution_barrier
     %1 = flow.tensor.clone %arg1 : tensor<5x24x48xf32>
     %2 = flow.tensor.reshape %arg1 : tensor<5x24x48xf32> -> tensor<60x2x48xf32>
     // CHECK-NEXT: hal.command_buffer.copy_buffer
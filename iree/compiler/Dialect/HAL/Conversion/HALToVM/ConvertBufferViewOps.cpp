@@ -32,6 +32,8 @@ void populateHALBufferViewToVMPatterns(MLIRContext *context,
       context, importSymbols, typeConverter, "hal.buffer_view.dim");
   patterns.insert<VMImportOpConversion<IREE::HAL::BufferViewTraceOp>>(
       context, importSymbols, typeConverter, "hal.buffer_view.trace");
+  patterns.insert<VMImportOpConversion<IREE::HAL::BufferViewSummarizeOp>>(
+      context, importSymbols, typeConverter, "hal.buffer_view.summarize");
 }
 
 }  // namespace iree_compiler
@@ -61,6 +61,71 @@ class CommandBufferPushDescriptorSetOpConversion
   mutable IREE::VM::ImportOp importOp;
 };
 
+class CommandBufferDispatchPushOpConversion
+    : public OpConversionPattern<IREE::HAL::CommandBufferDispatchPushOp> {
+ public:
+  CommandBufferDispatchPushOpConversion(MLIRContext *context,
+                                        SymbolTable &importSymbols,
+                                        TypeConverter &typeConverter,
+                                        StringRef importName)
+      : OpConversionPattern(context) {
+    importOp = importSymbols.lookup<IREE::VM::ImportOp>(importName);
+    assert(importOp);
+  }
+
+  LogicalResult matchAndRewrite(
+      IREE::HAL::CommandBufferDispatchPushOp op, llvm::ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const override {
+    auto importType = importOp.getType();
+    IREE::HAL::CommandBufferDispatchPushOp::Adaptor newOperands(
+        operands, op->getAttrDictionary());
+
+    SmallVector<Value, 16> callOperands = {
+        newOperands.command_buffer(),
+        newOperands.executable_layout(),
+        newOperands.executable(),
+        rewriter.createOrFold<IREE::VM::ConstI32Op>(
+            op.getLoc(), op.entry_point().getSExtValue()),
+        newOperands.workgroup_x(),
+        newOperands.workgroup_y(),
+        newOperands.workgroup_z(),
+        newOperands.set(),
+        rewriter.createOrFold<IREE::VM::ConstI32Op>(
+            op.getLoc(), op.constant_offset().getSExtValue()),
+    };
+    SmallVector<int16_t, 11> segmentSizes = {
+        /*command_buffer=*/-1,
+        /*executable_layout=*/-1,
+        /*executable=*/-1,
+        /*entry_point=*/-1,
+        /*workgroup_x=*/-1,
+        /*workgroup_y=*/-1,
+        /*workgroup_z=*/-1,
+        /*set=*/-1,
+        /*constant_offset=*/-1,
+        /*constants=*/
+        static_cast<int16_t>(newOperands.constants().size()),
+        /*bindings=*/
+        static_cast<int16_t>(newOperands.binding_ordinals().size()),
+    };
+    llvm::append_range(callOperands, newOperands.constants());
+    for (size_t i = 0; i < newOperands.binding_ordinals().size(); ++i) {
+      callOperands.push_back(newOperands.binding_ordinals()[i]);
+      callOperands.push_back(newOperands.binding_buffers()[i]);
+      callOperands.push_back(newOperands.binding_offsets()[i]);
+      callOperands.push_back(newOperands.binding_lengths()[i]);
+    }
+
+    rewriter.replaceOpWithNewOp<IREE::VM::CallVariadicOp>(
+        op, rewriter.getSymbolRefAttr(importOp), importType.getResults(),
+        segmentSizes, importType.getInputs(), callOperands);
+    return success();
+  }
+
+ private:
+  mutable IREE::VM::ImportOp importOp;
+};
+
 }  // namespace
 
 void populateHALCommandBufferToVMPatterns(MLIRContext *context,
@@ -106,6 +171,9 @@ void populateHALCommandBufferToVMPatterns(MLIRContext *context,
       .insert<VMImportOpConversion<IREE::HAL::CommandBufferDispatchIndirectOp>>(
           context, importSymbols, typeConverter,
           "hal.command_buffer.dispatch.indirect");
+  patterns.insert<CommandBufferDispatchPushOpConversion>(
+      context, importSymbols, typeConverter,
+      "hal.command_buffer.dispatch.push");
 }
 
 }  // namespace iree_compiler
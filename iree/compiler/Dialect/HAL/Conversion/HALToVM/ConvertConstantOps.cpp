@@ -4,6 +4,8 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <algorithm>
+
 #include "iree/compiler/Dialect/HAL/IR/HALOps.h"
 #include "iree/compiler/Dialect/HAL/IR/HALTypes.h"
 #include "iree/compiler/Dialect/Util/IR/UtilTypes.h"
@@ -14,6 +16,9 @@ namespace mlir {
 namespace iree_compiler {
 namespace {
 
+// Storage buffers of at least this many bytes are aligned to it.
+static constexpr int64_t kPageSize = 4096;
+
 class ConstantPoolOpConversion
     : public OpConversionPattern<IREE::HAL::ConstantPoolOp> {
  public:
@@ -22,11 +27,21 @@ class ConstantPoolOpConversion
   LogicalResult matchAndRewrite(
       IREE::HAL::ConstantPoolOp op, llvm::ArrayRef<Value> operands,
       ConversionPatternRewriter &rewriter) const override {
+    // The runtime wraps storage buffers in-place when the device can access
+    // host memory. Large buffers are page aligned so that they can be used
+    // directly from a mapped module file without being copied.
+    int64_t minAlignment =
+        op.buffer_constraints().min_buffer_offset_alignment().getSExtValue();
     for (auto storageOp : op.getOps<IREE::HAL::ConstantStorageOp>()) {
       auto rodataName = (op.sym_name() + storageOp.sym_name()).str();
       auto rodataOp = rewriter.create<IREE::VM::RodataOp>(
           storageOp.getLoc(), rodataName, storageOp.value());
       rodataOp.setPrivate();
+      int64_t alignment = minAlignment;
+      if (storageOp.value().getNumElements() >= kPageSize) {
+        alignment = std::max(alignment, kPageSize);
+      }
+      rodataOp.alignmentAttr(rewriter.getI64IntegerAttr(alignment));
     }
     rewriter.eraseOp(op);
     return success();
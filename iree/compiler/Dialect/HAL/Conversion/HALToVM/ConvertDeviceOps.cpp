@@ -110,6 +110,54 @@ class DeviceQueryI32OpConversion
   mutable IREE::VM::ImportOp importOp;
 };
 
+class DeviceQueueSubmitOpConversion
+    : public OpConversionPattern<IREE::HAL::DeviceQueueSubmitOp> {
+ public:
+  DeviceQueueSubmitOpConversion(MLIRContext *context,
+                                SymbolTable &importSymbols,
+                                TypeConverter &typeConverter,
+                                StringRef importName)
+      : OpConversionPattern(context) {
+    importOp = importSymbols.lookup<IREE::VM::ImportOp>(importName);
+    assert(importOp);
+  }
+
+  LogicalResult matchAndRewrite(
+      IREE::HAL::DeviceQueueSubmitOp op, llvm::ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const override {
+    auto importType = importOp.getType();
+    IREE::HAL::DeviceQueueSubmitOp::Adaptor newOperands(
+        operands, op->getAttrDictionary());
+
+    SmallVector<Value, 8> callOperands = {
+        newOperands.device(),
+        newOperands.command_buffer(),
+        newOperands.signal_semaphore(),
+        newOperands.signal_value(),
+    };
+    SmallVector<int16_t, 5> segmentSizes = {
+        /*device=*/-1,
+        /*command_buffer=*/-1,
+        /*signal_semaphore=*/-1,
+        /*signal_value=*/-1,
+        /*wait_semaphores=*/
+        static_cast<int16_t>(newOperands.wait_semaphores().size()),
+    };
+    for (size_t i = 0; i < newOperands.wait_semaphores().size(); ++i) {
+      callOperands.push_back(newOperands.wait_semaphores()[i]);
+      callOperands.push_back(newOperands.wait_values()[i]);
+    }
+
+    rewriter.replaceOpWithNewOp<IREE::VM::CallVariadicOp>(
+        op, rewriter.getSymbolRefAttr(importOp), importType.getResults(),
+        segmentSizes, importType.getInputs(), callOperands);
+    return success();
+  }
+
+ private:
+  mutable IREE::VM::ImportOp importOp;
+};
+
 void populateHALDeviceToVMPatterns(MLIRContext *context,
                                    SymbolTable &importSymbols,
                                    TypeConverter &typeConverter,
@@ -120,6 +168,8 @@ void populateHALDeviceToVMPatterns(MLIRContext *context,
   patterns.insert<DeviceQueryIntCastOpConversion>(context, typeConverter);
   patterns.insert<DeviceQueryI32OpConversion>(
       context, importSymbols, typeConverter, "hal.device.query.i32");
+  patterns.insert<DeviceQueueSubmitOpConversion>(
+      context, importSymbols, typeConverter, "hal.device.queue.submit");
 }
 
 }  // namespace iree_compiler
@@ -12,3 +12,14 @@ func @buffer_view_dims(%arg0 : !hal.buffer_view) -> (index, index, index) {
   // CHECK-NEXT: vm.return %[[D0]], %[[D1]], %[[D2]]
   return %0, %1, %2 : index, index, index
 }
+
+// -----
+
+// CHECK-LABEL: vm.func private @buffer_view_summarize
+// CHECK-SAME: %[[VIEW0:.+]]: !vm.ref<!hal.buffer_view>, %[[VIEW1:.+]]: !vm.ref<!hal.buffer_view>
+func @buffer_view_summarize(%arg0 : !hal.buffer_view, %arg1 : !hal.buffer_view) {
+  // CHECK: %[[KEY:.+]] = vm.rodata.inline "_utf8_dispatch_outputs_
+  // CHECK: vm.call.variadic @hal.buffer_view.summarize(%[[KEY]], [%[[VIEW0]], %[[VIEW1]]]) : (!vm.buffer, !vm.ref<!hal.buffer_view> ...)
+  hal.buffer_view.summarize %arg0, %arg1 : !hal.buffer_view, !hal.buffer_view attributes {key = "dispatch outputs"}
+  return
+}
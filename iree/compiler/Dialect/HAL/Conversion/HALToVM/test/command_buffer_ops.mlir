@@ -109,6 +109,33 @@ func @command_buffer_dispatch(
 
 // -----
 
+// CHECK-LABEL: @command_buffer_dispatch_push
+func @command_buffer_dispatch_push(
+  %arg0: !hal.command_buffer,
+  %arg1: !hal.executable_layout,
+  %arg2: !hal.executable,
+  %arg3: i32,
+  %arg4: !hal.buffer
+) {
+  %c0 = constant 0 : index
+  %c1 = constant 1 : index
+  %c100 = constant 100 : index
+  %c200 = constant 200 : index
+  // CHECK: vm.call.variadic @hal.command_buffer.dispatch.push(%arg0, %arg1, %arg2, %{{.+}}, %c100, %c200, %c1, %{{.+}}, %c2, [%arg3, %arg3], [(%{{.+}}, %arg4, %{{.+}}, %c100), (%c1, %arg4, %c100, %c200)]) : (!vm.ref<!hal.command_buffer>, !vm.ref<!hal.executable_layout>, !vm.ref<!hal.executable>, i32, i32, i32, i32, i32, i32, i32 ..., tuple<i32, !vm.ref<!hal.buffer>, i32, i32> ...)
+  hal.command_buffer.dispatch.push<%arg0 : !hal.command_buffer>
+      layout(%arg1 : !hal.executable_layout)
+      target(%arg2 : !hal.executable)[0]
+      workgroups([%c100, %c200, %c1])
+      constants(2, [%arg3, %arg3])
+      bindings(%c0, [
+        %c0 = (%arg4 : !hal.buffer)[%c0, %c100],
+        %c1 = (%arg4 : !hal.buffer)[%c100, %c200]
+      ])
+  return
+}
+
+// -----
+
 // CHECK-LABEL: @command_buffer_dispatch_indirect
 func @command_buffer_dispatch_indirect(
   %arg0: !hal.command_buffer,
@@ -1,7 +1,7 @@
 // RUN: iree-opt -split-input-file -iree-convert-hal-to-vm %s | IreeFileCheck %s
 
-// CHECK: vm.rodata private @pool_storage0 dense<[102, 102, 6, 64, -51, -52, 76, 64, -102, -103, -119, 64, -51, -52, -84, 64]> : vector<16xi8>
-// CHECK: vm.rodata private @pool_storage1 dense<[6, 7, 8, 0]> : vector<4xi8>
+// CHECK: vm.rodata private @pool_storage0 {alignment = 32 : i64} dense<[102, 102, 6, 64, -51, -52, 76, 64, -102, -103, -119, 64, -51, -52, -84, 64]> : vector<16xi8>
+// CHECK: vm.rodata private @pool_storage1 {alignment = 32 : i64} dense<[6, 7, 8, 0]> : vector<4xi8>
 hal.constant_pool @pool attributes {buffer_constraints = #hal.buffer_constraints<max_allocation_size = 1073741824, min_buffer_offset_alignment = 32, max_buffer_range = 134217728, min_buffer_range_alignment = 4>} {
   hal.constant_pool.span @cst0 : tensor<4xf32> = @_storage0[#hal.byte_range<0, 16>] -> @pool_storage0_buffer[#hal.byte_range<0, 16>]
   hal.constant_pool.span @cst1 : tensor<3xi8> = @_storage1[#hal.byte_range<0, 3>] -> @pool_storage1_buffer[#hal.byte_range<0, 3>]
@@ -51,3 +51,11 @@ func private @pool_splats_initializer() -> !hal.buffer {
       usage("Constant|Transfer|Mapping|Dispatch") : !hal.buffer{%c64}
   return %buffer : !hal.buffer
 }
+
+// -----
+
+// CHECK: vm.rodata private @large_pool_storage {alignment = 4096 : i64} dense<1> : vector<8192xi8>
+hal.constant_pool @large_pool attributes {buffer_constraints = #hal.buffer_constraints<max_allocation_size = 1073741824, min_buffer_offset_alignment = 32, max_buffer_range = 134217728, min_buffer_range_alignment = 4>} {
+  hal.constant_pool.span @cst0 : tensor<2048xf32> = @_storage[#hal.byte_range<0, 8192>] -> @large_pool_storage_buffer[#hal.byte_range<0, 8192>]
+  hal.constant_storage @_storage = dense<1> : vector<8192xi8>
+}
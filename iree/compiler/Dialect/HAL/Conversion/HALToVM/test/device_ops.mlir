@@ -63,3 +63,15 @@ func @device_query_i1_default(%device: !hal.device) -> i1 {
   // CHECK: return %[[OUT]]
   return %value : i1
 }
+
+// -----
+
+// CHECK-LABEL: @device_queue_submit
+// CHECK-SAME: (%[[DEVICE:.+]]: !vm.ref<!hal.device>, %[[CMD:.+]]: !vm.ref<!hal.command_buffer>, %[[WAIT0:.+]]: !vm.ref<!hal.semaphore>, %[[WAIT1:.+]]: !vm.ref<!hal.semaphore>, %[[SIGNAL:.+]]: !vm.ref<!hal.semaphore>)
+func @device_queue_submit(%device: !hal.device, %cmd: !hal.command_buffer, %wait0: !hal.semaphore, %wait1: !hal.semaphore, %signal: !hal.semaphore) {
+  %c1 = constant 1 : index
+  %c2 = constant 2 : index
+  // CHECK: vm.call.variadic @hal.device.queue.submit(%[[DEVICE]], %[[CMD]], %[[SIGNAL]], %c1, [(%[[WAIT0]], %c1), (%[[WAIT1]], %c2)]) : (!vm.ref<!hal.device>, !vm.ref<!hal.command_buffer>, !vm.ref<!hal.semaphore>, i32, tuple<!vm.ref<!hal.semaphore>, i32> ...)
+  hal.device.queue.submit<%device : !hal.device> wait([%wait0, %wait1], [%c1, %c2]) signal(%signal, %c1) commands(%cmd)
+  return
+}
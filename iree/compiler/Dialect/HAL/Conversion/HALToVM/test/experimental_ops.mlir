@@ -0,0 +1,25 @@
+// RUN: iree-opt -split-input-file -iree-convert-hal-to-vm -canonicalize %s | IreeFileCheck %s
+
+// CHECK-LABEL: @ex_device
+func @ex_device() -> !hal.device {
+  // CHECK: %[[ORDINAL:.+]] = vm.const.i32 2 : i32
+  // CHECK: %ref = vm.call @hal.ex.device(%[[ORDINAL]])
+  // CHECK-SAME: (i32) -> !vm.ref<!hal.device>
+  %device = hal.ex.device<2> : !hal.device
+  return %device : !hal.device
+}
+
+// -----
+
+// CHECK-LABEL: @ex_buffer_copy
+// CHECK-SAME: (%[[SOURCE:.+]]: !vm.ref<!hal.buffer>, %[[TARGET:.+]]: !vm.ref<!hal.buffer>)
+func @ex_buffer_copy(%source: !hal.buffer, %target: !hal.buffer) {
+  %c100 = constant 100 : index
+  %c200 = constant 200 : index
+  %c300 = constant 300 : index
+  // CHECK: vm.call @hal.ex.buffer.copy(%[[SOURCE]], %c100, %[[TARGET]], %c200, %c300) : (!vm.ref<!hal.buffer>, i32, !vm.ref<!hal.buffer>, i32, i32) -> ()
+  hal.ex.buffer.copy source(%source : !hal.buffer)[%c100]
+                     target(%target : !hal.buffer)[%c200]
+                     length(%c300)
+  return
+}
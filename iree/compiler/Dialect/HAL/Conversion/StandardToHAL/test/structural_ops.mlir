@@ -31,7 +31,8 @@ func @tensor_cast_does_not_alias_metadata_update(%arg0: !hal.buffer_view) -> !ha
     }
 
     // Just anchor on the end of the function that creates a new buffer view.
-    // CHECK: hal.ex.submit_and_wait
+    // CHECK: hal.device.queue.submit
+    // CHECK: hal.semaphore.await
     // CHECK: %[[C3:.*]] = constant 3 : index
     // CHECK: %[[C2:.*]] = constant 2 : index
     // CHECK: %[[C1_1:.*]] = constant 1 : index
@@ -176,6 +176,18 @@ void ExSharedDeviceOp::getAsmResultNames(
   setNameFn(result(), "device");
 }
 
+void ExDeviceOp::getAsmResultNames(
+    function_ref<void(Value, StringRef)> setNameFn) {
+  setNameFn(result(), "device");
+}
+
+int64_t ExDeviceOp::getDeviceOrdinal(Value device) {
+  if (auto deviceOp = device.getDefiningOp<ExDeviceOp>()) {
+    return deviceOp.ordinal().getSExtValue();
+  }
+  return 0;
+}
+
 //===----------------------------------------------------------------------===//
 // hal.tensor.cast
 //===----------------------------------------------------------------------===//
@@ -585,6 +597,22 @@ void CommandBufferPushDescriptorSetOp::build(
   state.addOperands(bindingLengths);
 }
 
+//===----------------------------------------------------------------------===//
+// hal.command_buffer.dispatch.push
+//===----------------------------------------------------------------------===//
+
+static LogicalResult verifyCommandBufferDispatchPushOp(
+    CommandBufferDispatchPushOp op) {
+  size_t bindingCount = op.binding_ordinals().size();
+  if (op.binding_buffers().size() != bindingCount ||
+      op.binding_offsets().size() != bindingCount ||
+      op.binding_lengths().size() != bindingCount) {
+    return op.emitOpError() << "binding ordinals, buffers, offsets, and "
+                               "lengths must have the same count";
+  }
+  return success();
+}
+
 //===----------------------------------------------------------------------===//
 // hal.constant_pool
 //===----------------------------------------------------------------------===//
@@ -724,6 +752,17 @@ static LogicalResult verifyDeviceQueryOp(DeviceQueryOp op) {
   return success();
 }
 
+//===----------------------------------------------------------------------===//
+// hal.device.queue.submit
+//===----------------------------------------------------------------------===//
+
+static LogicalResult verifyDeviceQueueSubmitOp(DeviceQueueSubmitOp op) {
+  if (op.wait_semaphores().size() != op.wait_values().size()) {
+    return op.emitOpError() << "requires one wait value per wait semaphore";
+  }
+  return success();
+}
+
 //===----------------------------------------------------------------------===//
 // hal.device.switch
 //===----------------------------------------------------------------------===//
@@ -817,14 +817,36 @@ void ExecutableTargetAttr::print(DialectAsmPrinter &p) const {
   os << ">";
 }
 
+StringAttr ExecutableTargetAttr::getRequiredFeatures() {
+  auto configAttr = getConfiguration();
+  if (!configAttr) return {};
+  return configAttr.getAs<StringAttr>("required_features");
+}
+
 std::string ExecutableTargetAttr::getSymbolNameFragment() {
-  auto format = getFormat().getValue().lower();
-  std::replace(format.begin(), format.end(), '-', '_');
-  return format;
+  auto fragment = getFormat().getValue().lower();
+  // Variants of the same format that differ only in the features they require
+  // are disambiguated by those features.
+  if (auto requiredFeaturesAttr = getRequiredFeatures()) {
+    auto features = requiredFeaturesAttr.getValue().lower();
+    features.erase(std::remove(features.begin(), features.end(), '+'),
+                   features.end());
+    fragment += "_" + features;
+  }
+  std::replace_if(
+      fragment.begin(), fragment.end(),
+      [](char c) { return !llvm::isAlnum(c) && c != '_'; }, '_');
+  return fragment;
 }
 
 Attribute ExecutableTargetAttr::getMatchExpression() {
-  return DeviceMatchExecutableFormatAttr::get(getContext(), getFormat());
+  auto formatMatchAttr =
+      DeviceMatchExecutableFormatAttr::get(getContext(), getFormat());
+  auto requiredFeaturesAttr = getRequiredFeatures();
+  if (!requiredFeaturesAttr) return formatMatchAttr;
+  SmallVector<Attribute> conditionAttrs = {
+      formatMatchAttr, DeviceMatchFeatureAttr::get(requiredFeaturesAttr)};
+  return MatchAllAttr::get(getContext(), conditionAttrs);
 }
 
 //===----------------------------------------------------------------------===//
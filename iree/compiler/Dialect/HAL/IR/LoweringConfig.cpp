@@ -11,6 +11,9 @@
 
 static const char kConfigAttrName[] = "lowering.config";
 static const char kTranslationInfoAttrName[] = "translation.info";
+static const char kWorkgroupCostHintAttrName[] = "workgroup_cost_hint";
+static const char kEstimatedOpsAttrName[] = "estimated_ops";
+static const char kEstimatedBytesAttrName[] = "estimated_bytes";
 
 #include "iree/compiler/Dialect/HAL/IR/LoweringConfig.cpp.inc"
 #include "iree/compiler/Dialect/HAL/IR/LoweringConfigEnums.cpp.inc"
@@ -73,6 +76,54 @@ void setTranslationInfo(IREE::HAL::ExecutableEntryPointOp entryPointOp,
   }
 }
 
+Optional<int64_t> getWorkgroupCostHint(
+    IREE::HAL::ExecutableEntryPointOp entryPointOp) {
+  if (auto attr =
+          entryPointOp->getAttrOfType<IntegerAttr>(kWorkgroupCostHintAttrName)) {
+    return attr.getInt();
+  }
+  return llvm::None;
+}
+
+void setWorkgroupCostHint(IREE::HAL::ExecutableEntryPointOp entryPointOp,
+                          int64_t workgroupCost) {
+  Builder builder(entryPointOp->getContext());
+  entryPointOp->setAttr(kWorkgroupCostHintAttrName,
+                        builder.getI64IntegerAttr(workgroupCost));
+}
+
+Optional<int64_t> getEstimatedOpCount(
+    IREE::HAL::ExecutableEntryPointOp entryPointOp) {
+  if (auto attr =
+          entryPointOp->getAttrOfType<IntegerAttr>(kEstimatedOpsAttrName)) {
+    return attr.getInt();
+  }
+  return llvm::None;
+}
+
+Optional<int64_t> getEstimatedByteCount(
+    IREE::HAL::ExecutableEntryPointOp entryPointOp) {
+  if (auto attr =
+          entryPointOp->getAttrOfType<IntegerAttr>(kEstimatedBytesAttrName)) {
+    return attr.getInt();
+  }
+  return llvm::None;
+}
+
+void setDispatchCostEstimates(IREE::HAL::ExecutableEntryPointOp entryPointOp,
+                              Optional<int64_t> opCount,
+                              Optional<int64_t> byteCount) {
+  Builder builder(entryPointOp->getContext());
+  if (opCount) {
+    entryPointOp->setAttr(kEstimatedOpsAttrName,
+                          builder.getI64IntegerAttr(*opCount));
+  }
+  if (byteCount) {
+    entryPointOp->setAttr(kEstimatedBytesAttrName,
+                          builder.getI64IntegerAttr(*byteCount));
+  }
+}
+
 //===----------------------------------------------------------------------===//
 // Helpers for getting/setting the `hal.lowering.*` attributes that drive the
 // linalg-based lowering.
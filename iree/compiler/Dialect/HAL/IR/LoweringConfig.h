@@ -72,6 +72,33 @@ void setTranslationInfo(IREE::HAL::ExecutableEntryPointOp entryPointOp,
                         IREE::HAL::TranslationInfo translationInfo,
                         ArrayRef<int64_t> workgroupSize = {});
 
+/// Returns the estimated cost of executing a single workgroup of the
+/// `entryPointOp` in approximate scalar operations, if one was set.
+Optional<int64_t> getWorkgroupCostHint(
+    IREE::HAL::ExecutableEntryPointOp entryPointOp);
+
+/// Sets the estimated cost of executing a single workgroup of the
+/// `entryPointOp` in approximate scalar operations. Backends may use this to
+/// tell the runtime how to distribute workgroups across threads.
+void setWorkgroupCostHint(IREE::HAL::ExecutableEntryPointOp entryPointOp,
+                          int64_t workgroupCost);
+
+/// Returns the static estimate of the scalar operations performed by a single
+/// dispatch of the `entryPointOp`, if one was recorded.
+Optional<int64_t> getEstimatedOpCount(
+    IREE::HAL::ExecutableEntryPointOp entryPointOp);
+
+/// Returns the static estimate of the bytes of tensor data read and written by
+/// a single dispatch of the `entryPointOp`, if one was recorded.
+Optional<int64_t> getEstimatedByteCount(
+    IREE::HAL::ExecutableEntryPointOp entryPointOp);
+
+/// Records the static cost estimates of a single dispatch of the
+/// `entryPointOp`. Either estimate may be omitted if it could not be derived.
+void setDispatchCostEstimates(IREE::HAL::ExecutableEntryPointOp entryPointOp,
+                              Optional<int64_t> opCount,
+                              Optional<int64_t> byteCount);
+
 //===----------------------------------------------------------------------===//
 // Helpers for getting/setting the `hal.lowering.*` attributes that drive the
 // linalg-based lowering.
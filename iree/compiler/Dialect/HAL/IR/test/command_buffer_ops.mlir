@@ -187,3 +187,43 @@ func @command_buffer_dispatch_indirect(
       workgroups(%buffer : !hal.buffer)[%offset]
   return
 }
+
+// -----
+
+// CHECK-LABEL: @command_buffer_dispatch_push
+//  CHECK-SAME: (%[[CMD:.+]]: !hal.command_buffer,
+//  CHECK-SAME: %[[LAYOUT:.+]]: !hal.executable_layout,
+//  CHECK-SAME: %[[EXE:.+]]: !hal.executable,
+//  CHECK-SAME: %[[VALUE:.+]]: i32,
+//  CHECK-SAME: %[[BUFFER:.+]]: !hal.buffer)
+func @command_buffer_dispatch_push(
+    %cmd: !hal.command_buffer,
+    %layout: !hal.executable_layout,
+    %exe: !hal.executable,
+    %value: i32,
+    %buffer: !hal.buffer
+  ) {
+  %c0 = constant 0 : index
+  %c1 = constant 1 : index
+  %c4 = constant 4 : index
+  %c128 = constant 128 : index
+  //      CHECK: hal.command_buffer.dispatch.push<%[[CMD]] : !hal.command_buffer>
+  // CHECK-SAME:   layout(%[[LAYOUT]] : !hal.executable_layout)
+  // CHECK-SAME:   target(%[[EXE]] : !hal.executable)[0]
+  // CHECK-SAME:   workgroups([%c4, %c1, %c1])
+  // CHECK-SAME:   constants(1, [%[[VALUE]], %[[VALUE]]])
+  // CHECK-SAME:   bindings(%c0, [
+  // CHECK-NEXT:     %c0 = (%[[BUFFER]] : !hal.buffer)[%c0, %c128],
+  // CHECK-NEXT:     %c1 = (%[[BUFFER]] : !hal.buffer)[%c128, %c128]
+  // CHECK-NEXT:   ])
+  hal.command_buffer.dispatch.push<%cmd : !hal.command_buffer>
+      layout(%layout : !hal.executable_layout)
+      target(%exe : !hal.executable)[0]
+      workgroups([%c4, %c1, %c1])
+      constants(1, [%value, %value])
+      bindings(%c0, [
+        %c0 = (%buffer : !hal.buffer)[%c0, %c128],
+        %c1 = (%buffer : !hal.buffer)[%c128, %c128]
+      ])
+  return
+}
@@ -51,3 +51,17 @@ func @device_query(%device : !hal.device) -> (i1, i32) {
   %ok, %value = hal.device.query<%device : !hal.device> key("sys" :: "foo") : i1, i32
   return %ok, %value : i1, i32
 }
+
+// -----
+
+// CHECK-LABEL: @device_queue_submit
+// CHECK-SAME: (%[[DEVICE:.+]]: !hal.device, %[[CMD:.+]]: !hal.command_buffer, %[[WAIT0:.+]]: !hal.semaphore, %[[WAIT1:.+]]: !hal.semaphore, %[[SIGNAL:.+]]: !hal.semaphore)
+func @device_queue_submit(%device: !hal.device, %cmd: !hal.command_buffer, %wait0: !hal.semaphore, %wait1: !hal.semaphore, %signal: !hal.semaphore) {
+  %c1 = constant 1 : index
+  %c2 = constant 2 : index
+  // CHECK: hal.device.queue.submit<%[[DEVICE]] : !hal.device> wait([%[[WAIT0]], %[[WAIT1]]], [%c1, %c2]) signal(%[[SIGNAL]], %c1) commands(%[[CMD]])
+  hal.device.queue.submit<%device : !hal.device> wait([%wait0, %wait1], [%c1, %c2]) signal(%signal, %c1) commands(%cmd)
+  // CHECK: hal.device.queue.submit<%[[DEVICE]] : !hal.device> signal(%[[SIGNAL]], %c2) commands(%[[CMD]])
+  hal.device.queue.submit<%device : !hal.device> signal(%signal, %c2) commands(%cmd)
+  return
+}
@@ -11,6 +11,19 @@ func @shared_device() -> !hal.device {
 
 // -----
 
+// CHECK-LABEL: @submit
+func @submit() {
+  %0 = "test_hal.device"() : () -> !hal.device
+  %1 = "test_hal.command_buffer"() : () -> !hal.command_buffer
+  %2 = "test_hal.semaphore"() : () -> !hal.semaphore
+  %c1 = constant 1 : index
+  // CHECK: hal.ex.submit %0, %1 signal(%2, %c1)
+  hal.ex.submit %0, %1 signal(%2, %c1)
+  return
+}
+
+// -----
+
 // CHECK-LABEL: @submit_and_wait
 func @submit_and_wait() {
   %0 = "test_hal.device"() : () -> !hal.device
@@ -19,3 +32,26 @@ func @submit_and_wait() {
   hal.ex.submit_and_wait %0, %1
   return
 }
+
+// -----
+
+// CHECK-LABEL: @device
+func @device() -> !hal.device {
+  // CHECK: %device = hal.ex.device<1> : !hal.device
+  %device = hal.ex.device<1> : !hal.device
+  return %device : !hal.device
+}
+
+// -----
+
+// CHECK-LABEL: @buffer_copy
+func @buffer_copy(%arg0: !hal.buffer, %arg1: !hal.buffer) {
+  %c100 = constant 100 : index
+  %c200 = constant 200 : index
+  %c300 = constant 300 : index
+  // CHECK: hal.ex.buffer.copy source(%arg0 : !hal.buffer)[%c100] target(%arg1 : !hal.buffer)[%c200] length(%c300)
+  hal.ex.buffer.copy source(%arg0 : !hal.buffer)[%c100]
+                     target(%arg1 : !hal.buffer)[%c200]
+                     length(%c300)
+  return
+}
@@ -8,6 +8,7 @@
 
 #include "iree/compiler/Codegen/Passes.h"
 #include "iree/compiler/Dialect/HAL/Target/CUDA/LLVMPasses.h"
+#include "iree/compiler/Dialect/HAL/Target/CUDA/PersistentKernels.h"
 #include "iree/compiler/Dialect/HAL/Target/CUDA/libdevice.h"
 #include "iree/compiler/Dialect/HAL/Target/TargetRegistry.h"
 #include "iree/compiler/Utils/FlatbufferUtils.h"
@@ -17,6 +18,7 @@
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Linker/Linker.h"
+#include "llvm/Support/FormatVariadic.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Target/TargetMachine.h"
@@ -33,6 +35,19 @@
 static llvm::cl::opt<bool> dumpPtx("iree-cuda-dump-ptx", llvm::cl::init(false),
                                    llvm::cl::desc("Dump ptx"));
 
+static llvm::cl::opt<std::string> clTargetArch(
+    "iree-cuda-llvm-target-arch",
+    llvm::cl::desc("LLVM target chip (e.g. sm_80) to generate code for. "
+                   "Tensor core instructions are used for sm_70 and newer."),
+    llvm::cl::init("sm_35"));
+
+static llvm::cl::opt<bool> clPersistentKernels(
+    "iree-cuda-persistent-kernels",
+    llvm::cl::desc("Links all CUDA executables together and adds persistent "
+                   "kernels able to run batches of small dispatches in a "
+                   "single launch. See iree_hal_cuda_device_params_t."),
+    llvm::cl::init(false));
+
 namespace mlir {
 namespace iree_compiler {
 namespace IREE {
@@ -126,6 +141,19 @@ static void linkAndOptimize(llvm::Module &module,
   MPM.run(module);
 }
 
+/// Marks |func| as a kernel entry point.
+static void annotateKernel(llvm::Module &module, llvm::Function *func) {
+  llvm::Metadata *llvmMetadata[] = {
+      llvm::ValueAsMetadata::get(func),
+      llvm::MDString::get(module.getContext(), "kernel"),
+      llvm::ValueAsMetadata::get(llvm::ConstantInt::get(
+          llvm::Type::getInt32Ty(module.getContext()), 1))};
+  llvm::MDNode *llvmMetadataNode =
+      llvm::MDNode::get(module.getContext(), llvmMetadata);
+  module.getOrInsertNamedMetadata("nvvm.annotations")
+      ->addOperand(llvmMetadataNode);
+}
+
 /// Sanitize the function name as CUDA driver doesn't allow function names with
 /// '.' character.
 static std::string sanitizeNameForCuda(llvm::StringRef name) {
@@ -162,6 +190,46 @@ class CUDATargetBackend final : public TargetBackend {
     buildLLVMGPUTransformPassPipeline(passManager, false);
   }
 
+  LogicalResult linkExecutables(mlir::ModuleOp moduleOp) override {
+    // Dispatches can only be batched into a persistent kernel launch if their
+    // entry points are in the same module.
+    if (!clPersistentKernels) return success();
+    OpBuilder builder = OpBuilder::atBlockBegin(moduleOp.getBody());
+    auto targetAttrs = gatherExecutableTargets(moduleOp);
+    for (auto targetAttr : llvm::enumerate(targetAttrs)) {
+      auto sourceExecutableOps =
+          gatherExecutablesForTarget(moduleOp, targetAttr.value());
+      if (sourceExecutableOps.size() <= 1) continue;
+
+      std::string linkedExecutableName =
+          llvm::formatv("{0}_linked_{1}",
+                        moduleOp.getName().getValueOr("module"), name());
+      if (targetAttrs.size() > 1) {
+        linkedExecutableName +=
+            llvm::formatv("_{0}", targetAttr.index()).str();
+      }
+      builder.setInsertionPointToStart(moduleOp.getBody());
+      auto linkedExecutableOp = builder.create<IREE::HAL::ExecutableOp>(
+          moduleOp.getLoc(), linkedExecutableName);
+      linkedExecutableOp.setVisibility(
+          sourceExecutableOps.front().getVisibility());
+      builder.setInsertionPointToStart(linkedExecutableOp.getBody());
+      auto linkedTargetOp = builder.create<IREE::HAL::ExecutableVariantOp>(
+          moduleOp.getLoc(), targetAttr.value().getSymbolNameFragment(),
+          targetAttr.value());
+      builder.setInsertionPoint(&linkedTargetOp.getBlock().back());
+      builder.create<ModuleOp>(moduleOp.getLoc());
+
+      if (failed(linkExecutablesInto(
+              moduleOp, sourceExecutableOps, linkedExecutableOp,
+              linkedTargetOp, [](mlir::ModuleOp moduleOp) { return moduleOp; },
+              builder))) {
+        return failure();
+      }
+    }
+    return success();
+  }
+
   LogicalResult serializeExecutable(IREE::HAL::ExecutableVariantOp variantOp,
                                     OpBuilder &executableBuilder) override {
     // Perform the translation in a separate context to avoid any
@@ -203,6 +271,7 @@ class CUDATargetBackend final : public TargetBackend {
     }
     std::vector<std::array<int32_t, 3>> workgroupSizes;
     std::vector<std::string> entryPointNames;
+    std::vector<llvm::Function *> kernelFuncs;
     for (auto func : innerModuleOp.getOps<LLVM::LLVMFuncOp>()) {
       auto *llvmFunc = llvmModule->getFunction(func.getName());
       if (llvmFunc->isDeclaration()) continue;
@@ -220,21 +289,30 @@ class CUDATargetBackend final : public TargetBackend {
         workgroup_size = {1, 1, 1};
       }
       workgroupSizes.push_back(workgroup_size);
-      llvm::Metadata *llvmMetadata[] = {
-          llvm::ValueAsMetadata::get(llvmFunc),
-          llvm::MDString::get(llvmModule->getContext(), "kernel"),
-          llvm::ValueAsMetadata::get(llvm::ConstantInt::get(
-              llvm::Type::getInt32Ty(llvmModule->getContext()), 1))};
-      llvm::MDNode *llvmMetadataNode =
-          llvm::MDNode::get(llvmModule->getContext(), llvmMetadata);
-      llvmModule->getOrInsertNamedMetadata("nvvm.annotations")
-          ->addOperand(llvmMetadataNode);
+      kernelFuncs.push_back(llvmFunc);
+      annotateKernel(*llvmModule, llvmFunc);
+    }
+
+    // Persistent kernels are built before optimization so that the entry
+    // points get inlined into them.
+    SmallVector<PersistentKernel> persistentKernels;
+    if (clPersistentKernels) {
+      persistentKernels =
+          buildPersistentKernels(*llvmModule, kernelFuncs, workgroupSizes);
+      for (auto &persistentKernel : persistentKernels) {
+        annotateKernel(*llvmModule, persistentKernel.function);
+      }
     }
 
     std::unique_ptr<llvm::TargetMachine> targetMachine;
     {
       llvm::Triple triple("nvptx64-nvidia-cuda");
-      std::string targetChip = "sm_35";
+      std::string targetChip = clTargetArch;
+      if (auto configAttr = variantOp.target().getConfiguration()) {
+        if (auto archAttr = configAttr.getAs<StringAttr>("target_arch")) {
+          targetChip = archAttr.getValue().str();
+        }
+      }
       std::string features = "+ptx60";
       std::string error;
       const llvm::Target *target =
@@ -277,9 +355,34 @@ class CUDATargetBackend final : public TargetBackend {
     }
     auto blockSizesRef = iree_CUDABlockSizeDef_vec_end(builder);
 
+    SmallVector<iree_CUDAPersistentKernelDef_ref_t> persistentKernelRefs;
+    for (auto &persistentKernel : persistentKernels) {
+      auto nameRef =
+          builder.createString(persistentKernel.function->getName());
+      auto kernelEntryPointsRef = flatbuffers_uint32_vec_create(
+          builder, persistentKernel.entryPoints.data(),
+          persistentKernel.entryPoints.size());
+      iree_CUDAPersistentKernelDef_start(builder);
+      iree_CUDAPersistentKernelDef_name_add(builder, nameRef);
+      iree_CUDAPersistentKernelDef_block_size_create(
+          builder, persistentKernel.blockSize[0], persistentKernel.blockSize[1],
+          persistentKernel.blockSize[2]);
+      iree_CUDAPersistentKernelDef_entry_points_add(builder,
+                                                    kernelEntryPointsRef);
+      persistentKernelRefs.push_back(iree_CUDAPersistentKernelDef_end(builder));
+    }
+    auto persistentKernelsRef =
+        builder.createOffsetVecDestructive(persistentKernelRefs);
+
     iree_CUDAExecutableDef_entry_points_add(builder, entryPointsRef);
     iree_CUDAExecutableDef_block_sizes_add(builder, blockSizesRef);
     iree_CUDAExecutableDef_ptx_image_add(builder, ptxCudeRef);
+    if (!persistentKernels.empty()) {
+      iree_CUDAExecutableDef_persistent_kernels_add(builder,
+                                                    persistentKernelsRef);
+      iree_CUDAExecutableDef_persistent_abi_version_add(
+          builder, kPersistentKernelABIVersion);
+    }
     iree_CUDAExecutableDef_end_as_root(builder);
 
     // Add the binary data to the target executable.
@@ -307,6 +410,9 @@ class CUDATargetBackend final : public TargetBackend {
     Builder b(context);
     SmallVector<NamedAttribute> configItems;
 
+    configItems.emplace_back(b.getIdentifier("target_arch"),
+                             b.getStringAttr(clTargetArch));
+
     auto configAttr = b.getDictionaryAttr(configItems);
     return IREE::HAL::ExecutableTargetAttr::get(
         context, b.getStringAttr("cuda"), b.getStringAttr("cuda-nvptx-fb"),
@@ -0,0 +1,346 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/HAL/Target/CUDA/PersistentKernels.h"
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/IntrinsicsNVPTX.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace HAL {
+
+// Field indices of the work item struct; see
+// iree_hal_cuda_persistent_work_item_t.
+enum WorkItemField : unsigned {
+  kEntryPoint = 0,
+  kWorkgroupCountX = 1,
+  kWorkgroupBase = 4,
+  kEpoch = 5,
+  kWaitWorkgroupCount = 6,
+  kBindings = 8,
+};
+
+// Address space of shared memory in NVPTX.
+static constexpr unsigned kSharedAddressSpace = 3;
+
+static llvm::StructType *getWorkItemType(llvm::LLVMContext &context) {
+  auto *i32Type = llvm::Type::getInt32Ty(context);
+  auto *i64Type = llvm::Type::getInt64Ty(context);
+  return llvm::StructType::create(
+      context,
+      {
+          i32Type,  // entry_point
+          i32Type,  // workgroup_count[0]
+          i32Type,  // workgroup_count[1]
+          i32Type,  // workgroup_count[2]
+          i32Type,  // workgroup_base
+          i32Type,  // epoch
+          i32Type,  // wait_workgroup_count
+          i32Type,  // reserved
+          llvm::ArrayType::get(i64Type, kPersistentKernelMaxBindings),
+      },
+      "iree_hal_cuda_persistent_work_item_t");
+}
+
+// Returns true if |func| references a shared memory global directly or through
+// a constant expression.
+static bool usesSharedMemory(llvm::Function &func) {
+  SmallVector<const llvm::Value *> worklist;
+  for (auto &inst : llvm::instructions(func)) {
+    worklist.append(inst.value_op_begin(), inst.value_op_end());
+  }
+  while (!worklist.empty()) {
+    const llvm::Value *value = worklist.pop_back_val();
+    if (auto *global = dyn_cast<llvm::GlobalVariable>(value)) {
+      if (global->getAddressSpace() == kSharedAddressSpace) return true;
+    } else if (auto *constExpr = dyn_cast<llvm::ConstantExpr>(value)) {
+      worklist.append(constExpr->value_op_begin(), constExpr->value_op_end());
+    }
+  }
+  return false;
+}
+
+static bool canRunPersistently(llvm::Function &kernel) {
+  if (!kernel.getReturnType()->isVoidTy()) return false;
+  if (kernel.arg_size() > kPersistentKernelMaxBindings) return false;
+  for (auto &arg : kernel.args()) {
+    if (!arg.getType()->isPointerTy()) return false;
+  }
+  return !usesSharedMemory(kernel);
+}
+
+// Clones |kernel| into an internal function taking the workgroup id and count
+// along x, y and z as 6 trailing i32 arguments in place of the special
+// registers.
+static llvm::Function *cloneWithWorkgroupArgs(llvm::Function &kernel) {
+  auto *i32Type = llvm::Type::getInt32Ty(kernel.getContext());
+  SmallVector<llvm::Type *> argTypes(kernel.getFunctionType()->params());
+  argTypes.append(6, i32Type);
+  auto *funcType = llvm::FunctionType::get(kernel.getReturnType(), argTypes,
+                                           /*isVarArg=*/false);
+  auto *func = llvm::Function::Create(
+      funcType, llvm::GlobalValue::InternalLinkage,
+      kernel.getName() + "_workgroup", kernel.getParent());
+
+  llvm::ValueToValueMapTy valueMap;
+  for (auto args : llvm::zip(kernel.args(), func->args())) {
+    valueMap[&std::get<0>(args)] = &std::get<1>(args);
+  }
+  SmallVector<llvm::ReturnInst *, 4> returns;
+  llvm::CloneFunctionInto(func, &kernel, valueMap,
+                          llvm::CloneFunctionChangeType::LocalChangesOnly,
+                          returns);
+
+  static const llvm::Intrinsic::ID workgroupIntrinsics[] = {
+      llvm::Intrinsic::nvvm_read_ptx_sreg_ctaid_x,
+      llvm::Intrinsic::nvvm_read_ptx_sreg_ctaid_y,
+      llvm::Intrinsic::nvvm_read_ptx_sreg_ctaid_z,
+      llvm::Intrinsic::nvvm_read_ptx_sreg_nctaid_x,
+      llvm::Intrinsic::nvvm_read_ptx_sreg_nctaid_y,
+      llvm::Intrinsic::nvvm_read_ptx_sreg_nctaid_z,
+  };
+  for (auto &inst : llvm::make_early_inc_range(llvm::instructions(func))) {
+    auto *call = dyn_cast<llvm::IntrinsicInst>(&inst);
+    if (!call) continue;
+    auto it = llvm::find(workgroupIntrinsics, call->getIntrinsicID());
+    if (it == std::end(workgroupIntrinsics)) continue;
+    unsigned argIndex =
+        kernel.arg_size() + std::distance(std::begin(workgroupIntrinsics), it);
+    call->replaceAllUsesWith(func->getArg(argIndex));
+    call->eraseFromParent();
+  }
+  return func;
+}
+
+// Builds a persistent kernel dispatching to |entryPoints|, pairs of entry
+// point ordinals and workgroup functions built by cloneWithWorkgroupArgs:
+//
+//   void @name(%items* byval %items, i32 %item_count, i32 %workgroup_count,
+//              i32* %counters)
+//
+// counters[0] hands out workgroup tickets in order and counters[1 + e] counts
+// the completed workgroups of epoch e. All counters must be zero at launch.
+static llvm::Function *buildPersistentKernel(
+    llvm::Module &module, llvm::StringRef name, llvm::StructType *itemType,
+    ArrayRef<std::pair<uint32_t, llvm::Function *>> entryPoints) {
+  auto &context = module.getContext();
+  auto *i32Type = llvm::Type::getInt32Ty(context);
+  auto *i64Type = llvm::Type::getInt64Ty(context);
+  auto *itemsType =
+      llvm::ArrayType::get(itemType, kPersistentKernelMaxWorkItems);
+  auto *funcType = llvm::FunctionType::get(
+      llvm::Type::getVoidTy(context),
+      {itemsType->getPointerTo(), i32Type, i32Type, i32Type->getPointerTo()},
+      /*isVarArg=*/false);
+  auto *func = llvm::Function::Create(
+      funcType, llvm::GlobalValue::ExternalLinkage, name, module);
+  // Work items are kernel parameters so that they are captured at launch
+  // without any upload.
+  func->addParamAttr(0, llvm::Attribute::getWithByValType(context, itemsType));
+  func->addParamAttr(0, llvm::Attribute::getWithAlignment(context,
+                                                          llvm::Align(8)));
+  llvm::Value *items = func->getArg(0);
+  llvm::Value *itemCount = func->getArg(1);
+  llvm::Value *workgroupCount = func->getArg(2);
+  llvm::Value *counters = func->getArg(3);
+
+  // The ticket claimed by the first thread, broadcast to the block.
+  auto *ticketVar = new llvm::GlobalVariable(
+      module, i32Type, /*isConstant=*/false, llvm::GlobalValue::InternalLinkage,
+      llvm::UndefValue::get(i32Type), name + "_ticket",
+      /*InsertBefore=*/nullptr, llvm::GlobalValue::NotThreadLocal,
+      kSharedAddressSpace);
+
+  auto *entryBlock = llvm::BasicBlock::Create(context, "entry", func);
+  auto *loopBlock = llvm::BasicBlock::Create(context, "loop", func);
+  auto *claimBlock = llvm::BasicBlock::Create(context, "claim", func);
+  auto *claimedBlock = llvm::BasicBlock::Create(context, "claimed", func);
+  auto *scanBlock = llvm::BasicBlock::Create(context, "scan", func);
+  auto *scanNextBlock = llvm::BasicBlock::Create(context, "scan_next", func);
+  auto *foundBlock = llvm::BasicBlock::Create(context, "found", func);
+  auto *waitBlock = llvm::BasicBlock::Create(context, "wait", func);
+  auto *waitDoneBlock = llvm::BasicBlock::Create(context, "wait_done", func);
+  auto *runBlock = llvm::BasicBlock::Create(context, "run", func);
+  auto *completeBlock = llvm::BasicBlock::Create(context, "complete", func);
+  auto *signalBlock = llvm::BasicBlock::Create(context, "signal", func);
+  auto *exitBlock = llvm::BasicBlock::Create(context, "exit", func);
+
+  llvm::IRBuilder<> builder(entryBlock);
+  auto callIntrinsic = [&](llvm::Intrinsic::ID id) {
+    return builder.CreateCall(llvm::Intrinsic::getDeclaration(&module, id));
+  };
+  auto loadField = [&](llvm::Value *index, unsigned field) {
+    auto *ptr = builder.CreateInBoundsGEP(
+        itemsType, items,
+        {builder.getInt32(0), index, builder.getInt32(field)});
+    return builder.CreateLoad(i32Type, ptr);
+  };
+  auto counterPtr = [&](llvm::Value *index) {
+    return builder.CreateInBoundsGEP(i32Type, counters, index);
+  };
+  auto atomicIncrement = [&](llvm::Value *ptr) {
+    return builder.CreateAtomicRMW(
+        llvm::AtomicRMWInst::Add, ptr, builder.getInt32(1), llvm::MaybeAlign(),
+        llvm::AtomicOrdering::SequentiallyConsistent);
+  };
+
+  // entry: only the first thread of the block touches the counters.
+  auto *threadId = builder.CreateOr(
+      builder.CreateOr(
+          callIntrinsic(llvm::Intrinsic::nvvm_read_ptx_sreg_tid_x),
+          callIntrinsic(llvm::Intrinsic::nvvm_read_ptx_sreg_tid_y)),
+      callIntrinsic(llvm::Intrinsic::nvvm_read_ptx_sreg_tid_z));
+  auto *isLeader = builder.CreateICmpEQ(threadId, builder.getInt32(0));
+  builder.CreateBr(loopBlock);
+
+  // loop: claim the next workgroup ticket.
+  builder.SetInsertPoint(loopBlock);
+  builder.CreateCondBr(isLeader, claimBlock, claimedBlock);
+  builder.SetInsertPoint(claimBlock);
+  builder.CreateStore(atomicIncrement(counters), ticketVar);
+  builder.CreateBr(claimedBlock);
+  builder.SetInsertPoint(claimedBlock);
+  callIntrinsic(llvm::Intrinsic::nvvm_barrier0);
+  auto *ticket = builder.CreateLoad(i32Type, ticketVar, /*isVolatile=*/true);
+  callIntrinsic(llvm::Intrinsic::nvvm_barrier0);
+  builder.CreateCondBr(builder.CreateICmpUGE(ticket, workgroupCount),
+                       exitBlock, scanBlock);
+
+  // scan: find the last work item starting at or before the ticket.
+  builder.SetInsertPoint(scanBlock);
+  auto *itemIndex = builder.CreatePHI(i32Type, 2);
+  itemIndex->addIncoming(builder.getInt32(0), claimedBlock);
+  auto *nextIndex = builder.CreateAdd(itemIndex, builder.getInt32(1));
+  builder.CreateCondBr(builder.CreateICmpULT(nextIndex, itemCount),
+                       scanNextBlock, foundBlock);
+  builder.SetInsertPoint(scanNextBlock);
+  itemIndex->addIncoming(nextIndex, scanNextBlock);
+  builder.CreateCondBr(
+      builder.CreateICmpULE(loadField(nextIndex, kWorkgroupBase), ticket),
+      scanBlock, foundBlock);
+
+  // found: wait for the previous epoch to complete, if any.
+  builder.SetInsertPoint(foundBlock);
+  auto *epoch = loadField(itemIndex, kEpoch);
+  auto *waitCount = loadField(itemIndex, kWaitWorkgroupCount);
+  builder.CreateCondBr(
+      builder.CreateAnd(isLeader,
+                        builder.CreateICmpNE(epoch, builder.getInt32(0))),
+      waitBlock, runBlock);
+  builder.SetInsertPoint(waitBlock);
+  // counters[1 + (epoch - 1)] tracks the previous epoch.
+  auto *completed =
+      builder.CreateLoad(i32Type, counterPtr(epoch), /*isVolatile=*/true);
+  builder.CreateCondBr(builder.CreateICmpUGE(completed, waitCount),
+                       waitDoneBlock, waitBlock);
+  builder.SetInsertPoint(waitDoneBlock);
+  callIntrinsic(llvm::Intrinsic::nvvm_membar_gl);
+  builder.CreateBr(runBlock);
+
+  // run: decompose the ticket into the workgroup id and call the entry point.
+  builder.SetInsertPoint(runBlock);
+  callIntrinsic(llvm::Intrinsic::nvvm_barrier0);
+  auto *countX = loadField(itemIndex, kWorkgroupCountX);
+  auto *countY = loadField(itemIndex, kWorkgroupCountX + 1);
+  auto *countZ = loadField(itemIndex, kWorkgroupCountX + 2);
+  auto *local =
+      builder.CreateSub(ticket, loadField(itemIndex, kWorkgroupBase));
+  auto *idX = builder.CreateURem(local, countX);
+  auto *idYZ = builder.CreateUDiv(local, countX);
+  auto *idY = builder.CreateURem(idYZ, countY);
+  auto *idZ = builder.CreateUDiv(idYZ, countY);
+  auto *entryPointSwitch = builder.CreateSwitch(
+      loadField(itemIndex, kEntryPoint), completeBlock, entryPoints.size());
+  for (auto entryPoint : entryPoints) {
+    llvm::Function *callee = entryPoint.second;
+    auto *caseBlock = llvm::BasicBlock::Create(
+        context, "entry_point_" + llvm::Twine(entryPoint.first), func,
+        completeBlock);
+    entryPointSwitch->addCase(builder.getInt32(entryPoint.first), caseBlock);
+    builder.SetInsertPoint(caseBlock);
+    SmallVector<llvm::Value *> args;
+    unsigned bindingCount = callee->arg_size() - 6;
+    for (unsigned i = 0; i < bindingCount; ++i) {
+      auto *ptr = builder.CreateInBoundsGEP(
+          itemsType, items,
+          {builder.getInt32(0), itemIndex, builder.getInt32(kBindings),
+           builder.getInt32(i)});
+      args.push_back(builder.CreateIntToPtr(builder.CreateLoad(i64Type, ptr),
+                                            callee->getArg(i)->getType()));
+    }
+    args.append({idX, idY, idZ, countX, countY, countZ});
+    builder.CreateCall(callee, args);
+    builder.CreateBr(completeBlock);
+  }
+
+  // complete: count the workgroup once all threads are done with it.
+  builder.SetInsertPoint(completeBlock);
+  callIntrinsic(llvm::Intrinsic::nvvm_barrier0);
+  builder.CreateCondBr(isLeader, signalBlock, loopBlock);
+  builder.SetInsertPoint(signalBlock);
+  callIntrinsic(llvm::Intrinsic::nvvm_membar_gl);
+  atomicIncrement(
+      counterPtr(builder.CreateAdd(epoch, builder.getInt32(1))));
+  builder.CreateBr(loopBlock);
+
+  builder.SetInsertPoint(exitBlock);
+  builder.CreateRetVoid();
+  return func;
+}
+
+SmallVector<PersistentKernel> buildPersistentKernels(
+    llvm::Module &module, ArrayRef<llvm::Function *> kernels,
+    ArrayRef<std::array<int32_t, 3>> blockSizes) {
+  // Group the eligible kernels by block size in entry point order.
+  SmallVector<std::array<int32_t, 3>> groupBlockSizes;
+  SmallVector<SmallVector<std::pair<uint32_t, llvm::Function *>>> groups;
+  for (auto kernel : llvm::enumerate(kernels)) {
+    if (!canRunPersistently(*kernel.value())) continue;
+    const auto &blockSize = blockSizes[kernel.index()];
+    auto it = llvm::find(groupBlockSizes, blockSize);
+    if (it == groupBlockSizes.end()) {
+      groupBlockSizes.push_back(blockSize);
+      groups.emplace_back();
+      it = std::prev(groupBlockSizes.end());
+    }
+    groups[std::distance(groupBlockSizes.begin(), it)].emplace_back(
+        kernel.index(), cloneWithWorkgroupArgs(*kernel.value()));
+  }
+
+  SmallVector<PersistentKernel> persistentKernels;
+  if (groups.empty()) return persistentKernels;
+  auto *itemType = getWorkItemType(module.getContext());
+  for (auto group : llvm::zip(groupBlockSizes, groups)) {
+    const auto &blockSize = std::get<0>(group);
+    std::string name = ("__iree_persistent_" + llvm::Twine(blockSize[0]) +
+                        "_" + llvm::Twine(blockSize[1]) + "_" +
+                        llvm::Twine(blockSize[2]))
+                           .str();
+    PersistentKernel persistentKernel;
+    persistentKernel.function =
+        buildPersistentKernel(module, name, itemType, std::get<1>(group));
+    persistentKernel.blockSize = blockSize;
+    for (auto entryPoint : std::get<1>(group)) {
+      persistentKernel.entryPoints.push_back(entryPoint.first);
+    }
+    persistentKernels.push_back(std::move(persistentKernel));
+  }
+  return persistentKernels;
+}
+
+}  // namespace HAL
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
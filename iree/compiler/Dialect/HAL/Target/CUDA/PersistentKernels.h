@@ -0,0 +1,58 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_COMPILER_DIALECT_HAL_TARGET_CUDA_PERSISTENTKERNELS_H_
+#define IREE_COMPILER_DIALECT_HAL_TARGET_CUDA_PERSISTENTKERNELS_H_
+
+#include <array>
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Module.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace HAL {
+
+// Version of the work item layout consumed by persistent kernels. Must match
+// IREE_HAL_CUDA_PERSISTENT_KERNEL_ABI_VERSION in
+// iree/hal/cuda/native_executable.h, as must the limits below.
+constexpr uint32_t kPersistentKernelABIVersion = 1;
+constexpr unsigned kPersistentKernelMaxWorkItems = 16;
+constexpr unsigned kPersistentKernelMaxBindings = 16;
+
+struct PersistentKernel {
+  llvm::Function *function;
+  std::array<int32_t, 3> blockSize;
+  // Ordinals of the entry points the kernel can execute.
+  llvm::SmallVector<uint32_t> entryPoints;
+};
+
+// Adds to |module| one persistent kernel per distinct block size of the
+// |kernels| with the block sizes |blockSizes| (indexed by entry point ordinal).
+//
+// A persistent kernel is launched with a fixed number of blocks that claim
+// workgroups from a list of work items passed by value and run them by calling
+// a copy of the original kernel taking its workgroup id and count as
+// arguments. Work items are split into epochs by the runtime: workgroups of an
+// epoch wait for all workgroups of the previous epoch to complete, which
+// implements execution barriers between batched dispatches.
+//
+// Kernels that use shared memory or take more than
+// kPersistentKernelMaxBindings arguments are not included as they would limit
+// the occupancy of all other kernels or not fit in a work item.
+llvm::SmallVector<PersistentKernel> buildPersistentKernels(
+    llvm::Module &module, llvm::ArrayRef<llvm::Function *> kernels,
+    llvm::ArrayRef<std::array<int32_t, 3>> blockSizes);
+
+}  // namespace HAL
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
+
+#endif  // IREE_COMPILER_DIALECT_HAL_TARGET_CUDA_PERSISTENTKERNELS_H_
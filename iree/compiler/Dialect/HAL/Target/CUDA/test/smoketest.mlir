@@ -1,5 +1,6 @@
 // RUN: iree-opt -split-input-file -iree-hal-transformation-pipeline %s | IreeFileCheck %s
 // RUN: iree-opt -split-input-file -iree-hal-transformation-pipeline -iree-cuda-dump-ptx %s 2>&1 | IreeFileCheck %s -check-prefix=PTX
+// RUN: iree-opt -split-input-file -iree-hal-transformation-pipeline -iree-cuda-dump-ptx -iree-cuda-persistent-kernels %s 2>&1 | IreeFileCheck %s -check-prefix=PERSISTENT
 
 #map = affine_map<(d0) -> (d0)>
 
@@ -40,6 +41,13 @@ flow.executable @add_dispatch_0 {
 // PTX:   add.rn.f32
 // PTX:   sqrt
 
+// PERSISTENT: .entry add_dispatch_0
+// PERSISTENT: .entry __iree_persistent_
+// PERSISTENT:   {{atom(.global)?.add.u32}}
+// PERSISTENT:   bar.sync
+// PERSISTENT:   add.rn.f32
+// PERSISTENT:   membar.gl
+
 //      CHECK:   hal.executable.binary @cuda_nvptx_fb attributes {
 // CHECK-SAME:     data = dense
 // CHECK-SAME:     format = "cuda-nvptx-fb"
@@ -9,6 +9,7 @@
 #include <cstdlib>
 
 #include "iree/compiler/Codegen/Passes.h"
+#include "iree/compiler/Dialect/HAL/IR/LoweringConfig.h"
 #include "iree/compiler/Dialect/HAL/Target/LLVM/LLVMIRPasses.h"
 #include "iree/compiler/Dialect/HAL/Target/LLVM/LibraryBuilder.h"
 #include "iree/compiler/Dialect/HAL/Target/LLVM/LinkerTool.h"
@@ -17,12 +18,15 @@
 #include "iree/compiler/Dialect/HAL/Target/TargetRegistry.h"
 #include "iree/compiler/Utils/FlatbufferUtils.h"
 #include "iree/schemas/dylib_executable_def_builder.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Support/FormatVariadic.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/raw_ostream.h"
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "mlir/Target/LLVMIR/Dialect/LLVMIR/LLVMToLLVMIRTranslation.h"
 #include "mlir/Target/LLVMIR/Export.h"
@@ -111,36 +115,73 @@ class LLVMAOTTargetBackend final : public TargetBackend {
   LogicalResult linkExecutables(mlir::ModuleOp moduleOp) override {
     OpBuilder builder = OpBuilder::atBlockBegin(moduleOp.getBody());
 
-    auto sourceExecutableOps =
-        llvm::to_vector<8>(moduleOp.getOps<IREE::HAL::ExecutableOp>());
-    if (sourceExecutableOps.size() <= 1) return success();
-
-    // TODO(benvanik): rework linking to support multiple formats.
-    auto sharedTargetAttr = getExecutableTarget(builder.getContext());
-
     // Guess a module name, if needed, to make the output files readable.
     auto moduleName = guessModuleName(moduleOp);
 
-    // Create our new "linked" hal.executable.
-    std::string linkedExecutableName =
-        llvm::formatv("{0}_linked_{1}", moduleName, name());
-    auto linkedExecutableOp = builder.create<IREE::HAL::ExecutableOp>(
-        moduleOp.getLoc(), linkedExecutableName);
-    linkedExecutableOp.setVisibility(
-        sourceExecutableOps.front().getVisibility());
-
-    // Add our hal.executable.variant with an empty module.
-    builder.setInsertionPointToStart(linkedExecutableOp.getBody());
-    auto linkedTargetOp = builder.create<IREE::HAL::ExecutableVariantOp>(
-        moduleOp.getLoc(), sharedTargetAttr.getSymbolNameFragment(),
-        sharedTargetAttr);
-    builder.setInsertionPoint(&linkedTargetOp.getBlock().back());
-    builder.create<ModuleOp>(moduleOp.getLoc());
-
-    // Try linking together all executables in moduleOp.
-    return linkExecutablesInto(
-        moduleOp, sourceExecutableOps, linkedExecutableOp, linkedTargetOp,
-        [](mlir::ModuleOp moduleOp) { return moduleOp; }, builder);
+    // Link each target (architecture/CPU features/format) into a single
+    // library such that only one executable needs to be loaded for it.
+    auto targetAttrs = gatherExecutableTargets(moduleOp);
+    for (auto targetAttr : llvm::enumerate(targetAttrs)) {
+      auto sourceExecutableOps =
+          gatherExecutablesForTarget(moduleOp, targetAttr.value());
+      if (sourceExecutableOps.size() <= 1) continue;
+
+      // Create our new "linked" hal.executable.
+      std::string linkedExecutableName =
+          llvm::formatv("{0}_linked_{1}", moduleName, name());
+      if (targetAttrs.size() > 1) {
+        linkedExecutableName +=
+            llvm::formatv("_{0}", targetAttr.index()).str();
+      }
+      builder.setInsertionPointToStart(moduleOp.getBody());
+      auto linkedExecutableOp = builder.create<IREE::HAL::ExecutableOp>(
+          moduleOp.getLoc(), linkedExecutableName);
+      linkedExecutableOp.setVisibility(
+          sourceExecutableOps.front().getVisibility());
+
+      // Add our hal.executable.variant with an empty module.
+      builder.setInsertionPointToStart(linkedExecutableOp.getBody());
+      auto linkedTargetOp = builder.create<IREE::HAL::ExecutableVariantOp>(
+          moduleOp.getLoc(), targetAttr.value().getSymbolNameFragment(),
+          targetAttr.value());
+      builder.setInsertionPoint(&linkedTargetOp.getBlock().back());
+      builder.create<ModuleOp>(moduleOp.getLoc());
+
+      // Try linking together all executables for the target in moduleOp.
+      if (failed(linkExecutablesInto(
+              moduleOp, sourceExecutableOps, linkedExecutableOp,
+              linkedTargetOp, [](mlir::ModuleOp moduleOp) { return moduleOp; },
+              builder))) {
+        return failure();
+      }
+    }
+    return success();
+  }
+
+  std::string getExecutableCacheKey() const override {
+    // Static libraries and kept linker artifacts are written outside of the
+    // compiled module and would be missing on cache hits.
+    if (!options_.staticLibraryOutput.empty() || options_.keepLinkerArtifacts) {
+      return "";
+    }
+    std::string key;
+    llvm::raw_string_ostream os(key);
+    os << name() << ";" << options_.targetTriple << ";" << options_.targetCPU
+       << ";" << options_.targetCPUFeatures << ";"
+       << llvm::join(options_.targetCPUVariants, ",") << ";O"
+       << options_.optLevel.getSpeedupLevel() << "s"
+       << options_.optLevel.getSizeLevel() << ";"
+       << options_.pipelineTuningOptions.LoopInterleaving
+       << options_.pipelineTuningOptions.LoopVectorization
+       << options_.pipelineTuningOptions.LoopUnrolling
+       << options_.pipelineTuningOptions.SLPVectorization << ";"
+       << options_.options.MCOptions.ABIName << ";"
+       << static_cast<int>(options_.options.FloatABIType) << ";"
+       << options_.debugSymbols << ";"
+       << static_cast<int>(options_.sanitizerKind) << ";"
+       << options_.linkEmbedded << options_.linkStatic << ";"
+       << options_.linkerPath << ";" << options_.embeddedLinkerPath;
+    return os.str();
   }
 
   LogicalResult serializeExecutable(IREE::HAL::ExecutableVariantOp variantOp,
@@ -161,6 +202,15 @@ class LLVMAOTTargetBackend final : public TargetBackend {
       return variantOp.emitError()
              << "cannot embed ELF and produce static library simultaneously";
     }
+    if (!options_.targetCPUVariants.empty() &&
+        !options_.staticLibraryOutput.empty()) {
+      return variantOp.emitError()
+             << "static libraries cannot contain multiple CPU variants";
+    }
+    if (options_.staticLibraryLTO && options_.staticLibraryOutput.empty()) {
+      return variantOp.emitError()
+             << "static library LTO requires a static library output path";
+    }
 
     // Specialize the module to the target triple.
     // The executable will have been cloned into other ExecutableVariantOps for
@@ -216,11 +266,34 @@ class LLVMAOTTargetBackend final : public TargetBackend {
         }
       } break;
     }
+    if (options_.flushDenormalsToZero) {
+      // The runtime flushes denormal inputs and outputs to zero while
+      // executing the library, which LLVM may then assume as well.
+      libraryBuilder.addRequiredFeature(
+          LibraryBuilder::Features::FLUSH_DENORMALS_TO_ZERO);
+      for (auto &function : llvmModule->getFunctionList()) {
+        function.addFnAttr("denormal-fp-math", "preserve-sign,preserve-sign");
+      }
+    }
+    SmallVector<std::string> directExportNames;
     for (auto entryPointOp :
          variantOp.getBlock().getOps<ExecutableEntryPointOp>()) {
       // Find the matching function in the LLVM module.
       auto *llvmFunc = llvmModule->getFunction(entryPointOp.getName());
-      llvmFunc->setLinkage(llvm::GlobalValue::LinkageTypes::InternalLinkage);
+      if (options_.staticLibraryLTO) {
+        // Entry points are called directly by the host program and need
+        // library-unique names that survive linking. Hidden visibility keeps
+        // them out of any shared object the host may be built into.
+        std::string directName =
+            libraryName + "_" + entryPointOp.getName().str();
+        llvmFunc->setName(directName);
+        llvmFunc->setLinkage(llvm::GlobalValue::LinkageTypes::ExternalLinkage);
+        llvmFunc->setVisibility(
+            llvm::GlobalValue::VisibilityTypes::HiddenVisibility);
+        directExportNames.push_back(llvmFunc->getName().str());
+      } else {
+        llvmFunc->setLinkage(llvm::GlobalValue::LinkageTypes::InternalLinkage);
+      }
       llvmFunc->setDSOLocal(true);
 
       // Optionally entry points may specify that they require workgroup local
@@ -230,9 +303,25 @@ class LLVMAOTTargetBackend final : public TargetBackend {
                                     .getValueOr(APInt(64, 0))
                                     .getSExtValue();
 
-      libraryBuilder.addExport(entryPointOp.getName(), "",
-                               LibraryBuilder::DispatchAttrs{localMemorySize},
-                               llvmFunc);
+      // Codegen may have estimated how expensive each workgroup is; the
+      // runtime uses this to decide how widely to distribute the workgroups.
+      int64_t workgroupCost = getWorkgroupCostHint(entryPointOp).getValueOr(0);
+
+      // Static cost estimates are exposed as the export tag so that tools can
+      // derive the arithmetic intensity of each dispatch from the binary.
+      std::string tag;
+      if (auto opCount = getEstimatedOpCount(entryPointOp)) {
+        tag += "ops=" + std::to_string(*opCount);
+      }
+      if (auto byteCount = getEstimatedByteCount(entryPointOp)) {
+        if (!tag.empty()) tag += " ";
+        tag += "bytes=" + std::to_string(*byteCount);
+      }
+
+      libraryBuilder.addExport(
+          entryPointOp.getName(), tag,
+          LibraryBuilder::DispatchAttrs{localMemorySize, workgroupCost},
+          llvmFunc);
     }
 
     auto queryFunctionName = std::string(kQueryFunctionName);
@@ -267,7 +356,8 @@ class LLVMAOTTargetBackend final : public TargetBackend {
 
     // LLVM opt passes that perform code generation optimizations/transformation
     // similar to what a frontend would do before passing to linking.
-    auto targetMachine = createTargetMachine(options_);
+    auto variantOptions = getVariantTargetOptions(variantOp);
+    auto targetMachine = createTargetMachine(variantOptions);
     if (!targetMachine) {
       return mlir::emitError(variantOp.getLoc())
              << "failed to create target machine for target triple '"
@@ -275,30 +365,41 @@ class LLVMAOTTargetBackend final : public TargetBackend {
     }
     llvmModule->setDataLayout(targetMachine->createDataLayout());
     llvmModule->setTargetTriple(targetMachine->getTargetTriple().str());
-    if (failed(
-            runLLVMIRPasses(options_, targetMachine.get(), llvmModule.get()))) {
-      return variantOp.emitError()
-             << "failed to run LLVM-IR opt passes for IREE::HAL::ExecutableOp "
-                "targeting '"
-             << options_.targetTriple << "'";
-    }
 
-    SmallVector<Artifact> objectFiles;
-
-    // Emit the base object file containing the bulk of our code.
-    // This must come first such that we have the proper library linking order.
-    {
-      // NOTE: today we just use a single object file, however if we wanted to
-      // scale code generation and linking we'd want to generate one per
-      // function (or something like that). A single object file is also
-      // instrumental to static library generation (which only supports one
-      // object file per library).
-      std::string objectData;
+    // Emit the base object files containing the bulk of our code.
+    // These must come first such that we have the proper library linking
+    // order. Linked executables contain every dispatch in the program and
+    // compiling them as a single module leaves all but one core idle so the
+    // module is split into partitions that are optimized and compiled
+    // concurrently. Static libraries only support one object file per library.
+    SmallVector<std::string> objectDatas;
+    unsigned partitionCount = getCodegenPartitionCount(*llvmModule);
+    if (partitionCount > 1) {
+      if (failed(runParallelLLVMIRAndEmitObjFilePasses(
+              variantOptions, llvmModule.get(), partitionCount,
+              objectDatas))) {
+        return variantOp.emitError()
+               << "failed to compile LLVM-IR module partitions to object "
+                  "files targeting '"
+               << options_.targetTriple << "'";
+      }
+    } else {
+      if (failed(runLLVMIRPasses(variantOptions, targetMachine.get(),
+                                 llvmModule.get()))) {
+        return variantOp.emitError()
+               << "failed to run LLVM-IR opt passes for "
+                  "IREE::HAL::ExecutableOp targeting '"
+               << options_.targetTriple << "'";
+      }
+      objectDatas.emplace_back();
       if (failed(runEmitObjFilePasses(targetMachine.get(), llvmModule.get(),
-                                      &objectData))) {
+                                      &objectDatas.back()))) {
         return variantOp.emitError()
                << "failed to compile LLVM-IR module to an object file";
       }
+    }
+    SmallVector<Artifact> objectFiles;
+    for (auto &objectData : objectDatas) {
       auto objectFile = Artifact::createTemporary(libraryName, "o");
       auto &os = objectFile.outputFile->os();
       os << objectData;
@@ -318,7 +419,8 @@ class LLVMAOTTargetBackend final : public TargetBackend {
     }
 
     // If we are keeping artifacts then let's also add the bitcode for easier
-    // debugging (vs just the binary object file).
+    // debugging (vs just the binary object file). When partitioned this is the
+    // module prior to LLVM-IR optimization.
     if (options_.keepLinkerArtifacts) {
       auto bitcodeFile =
           Artifact::createVariant(objectFiles.front().path, "bc");
@@ -337,11 +439,25 @@ class LLVMAOTTargetBackend final : public TargetBackend {
                   "multiple object files is not supported";
       }
 
+      // When targeting LTO the library object is the optimized bitcode
+      // instead of machine code so that the host linker can inline
+      // dispatches called through the direct dispatch table in the header.
+      std::string staticObjectPath = objectFiles[0].path;
+      Artifact bitcodeObjectFile;
+      if (options_.staticLibraryLTO) {
+        bitcodeObjectFile = Artifact::createTemporary(libraryName, "bc");
+        auto &os = bitcodeObjectFile.outputFile->os();
+        llvm::WriteBitcodeToFile(*llvmModule, os);
+        os.flush();
+        os.close();
+        staticObjectPath = bitcodeObjectFile.path;
+      }
+
       // Copy the static object file to the specified output along with
       // generated header file.
       const std::string &libraryPath = options_.staticLibraryOutput;
       if (!outputStaticLibrary(libraryName, queryFunctionName, libraryPath,
-                               objectFiles[0].path)) {
+                               staticObjectPath, directExportNames)) {
         return variantOp.emitError() << "static library generation failed";
       }
     }
@@ -441,13 +557,21 @@ class LLVMAOTTargetBackend final : public TargetBackend {
  private:
   ArrayAttr getExecutableTargets(MLIRContext *context) const {
     SmallVector<Attribute> targetAttrs;
-    // This is where we would multiversion.
-    targetAttrs.push_back(getExecutableTarget(context));
+    // Variants are matched in order at runtime so the baseline target that
+    // runs everywhere must come last.
+    for (auto &cpuVariant : options_.targetCPUVariants) {
+      targetAttrs.push_back(getExecutableTarget(context, cpuVariant));
+    }
+    targetAttrs.push_back(getExecutableTarget(context, /*cpuVariant=*/""));
     return ArrayAttr::get(context, targetAttrs);
   }
 
+  // Returns the executable target for the baseline target machine or, if
+  // |cpuVariant| is not empty, for the CPU or CPU features it specifies. The
+  // variants require the host to support them such that they are only selected
+  // on machines that can run them.
   IREE::HAL::ExecutableTargetAttr getExecutableTarget(
-      MLIRContext *context) const {
+      MLIRContext *context, StringRef cpuVariant) const {
     std::string format;
     if (options_.linkStatic) {
       // Static libraries are just string references when serialized so we don't
@@ -511,9 +635,72 @@ class LLVMAOTTargetBackend final : public TargetBackend {
       }
     }
 
-    // TODO(benvanik): pack in the LLVMTargetOptions into the config dict.
+    // Pack the target machine into the config dict such that codegen can
+    // specialize for it (such as when looking up tuned configurations).
+    // TODO(benvanik): pack in the rest of the LLVMTargetOptions.
+    Builder b(context);
+    SmallVector<NamedAttribute> configItems;
+    configItems.emplace_back(b.getIdentifier("target_triple"),
+                             b.getStringAttr(options_.targetTriple));
+    if (cpuVariant.empty()) {
+      if (!options_.targetCPUFeatures.empty()) {
+        configItems.emplace_back(b.getIdentifier("cpu_features"),
+                                 b.getStringAttr(options_.targetCPUFeatures));
+      }
+    } else if (cpuVariant.startswith("+")) {
+      std::string cpuFeatures = options_.targetCPUFeatures;
+      if (!cpuFeatures.empty()) cpuFeatures += ",";
+      cpuFeatures += cpuVariant.str();
+      configItems.emplace_back(b.getIdentifier("cpu"),
+                               b.getStringAttr(options_.targetCPU));
+      configItems.emplace_back(b.getIdentifier("cpu_features"),
+                               b.getStringAttr(cpuFeatures));
+      configItems.emplace_back(b.getIdentifier("required_features"),
+                               b.getStringAttr(cpuVariant));
+    } else {
+      configItems.emplace_back(b.getIdentifier("cpu"),
+                               b.getStringAttr(cpuVariant));
+      configItems.emplace_back(b.getIdentifier("cpu_features"),
+                               b.getStringAttr(""));
+      configItems.emplace_back(b.getIdentifier("required_features"),
+                               b.getStringAttr(cpuVariant));
+    }
+
+    return IREE::HAL::ExecutableTargetAttr::get(
+        context, b.getStringAttr("llvm"), b.getStringAttr(format),
+        b.getDictionaryAttr(configItems));
+  }
 
-    return IREE::HAL::ExecutableTargetAttr::get(context, "llvm", format);
+  // Returns the target options for |variantOp| with the CPU and CPU features
+  // of its executable target applied.
+  LLVMTargetOptions getVariantTargetOptions(
+      IREE::HAL::ExecutableVariantOp variantOp) const {
+    LLVMTargetOptions variantOptions = options_;
+    if (auto configAttr = variantOp.target().getConfiguration()) {
+      if (auto cpuAttr = configAttr.getAs<StringAttr>("cpu")) {
+        variantOptions.targetCPU = cpuAttr.getValue().str();
+      }
+      if (auto featuresAttr = configAttr.getAs<StringAttr>("cpu_features")) {
+        variantOptions.targetCPUFeatures = featuresAttr.getValue().str();
+      }
+    }
+    return variantOptions;
+  }
+
+  // Returns the number of partitions |module| is compiled in. Partitions are
+  // never smaller than a function and static libraries are always emitted as
+  // a single object file.
+  unsigned getCodegenPartitionCount(const llvm::Module &module) const {
+    if (!options_.staticLibraryOutput.empty()) return 1;
+    unsigned partitionCount = options_.codegenPartitions > 0
+                                  ? options_.codegenPartitions
+                                  : llvm::hardware_concurrency()
+                                        .compute_thread_count();
+    unsigned definitionCount =
+        llvm::count_if(module, [](const llvm::Function &func) {
+          return !func.isDeclaration();
+        });
+    return std::min(partitionCount, definitionCount);
   }
 
   static void overridePlatformGlobal(llvm::Module &module, StringRef globalName,
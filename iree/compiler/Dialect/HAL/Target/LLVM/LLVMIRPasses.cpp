@@ -6,7 +6,12 @@
 
 #include "iree/compiler/Dialect/HAL/Target/LLVM/LLVMIRPasses.h"
 
+#include <atomic>
+
+#include "llvm/ADT/SmallString.h"
 #include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
@@ -18,8 +23,11 @@
 #include "llvm/Support/Error.h"
 #include "llvm/Support/Host.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/Instrumentation/AddressSanitizer.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
 
 namespace mlir {
 namespace iree_compiler {
@@ -140,6 +148,52 @@ LogicalResult runEmitObjFilePasses(llvm::TargetMachine *machine,
   return success();
 }
 
+LogicalResult runParallelLLVMIRAndEmitObjFilePasses(
+    const LLVMTargetOptions &options, llvm::Module *module,
+    unsigned partitionCount, SmallVectorImpl<std::string> &objData) {
+  // LLVMContexts are not thread-safe so each partition is round-tripped
+  // through bitcode and compiled in a context of its own, the same way
+  // llvm::splitCodeGen does for LTO.
+  SmallVector<llvm::SmallString<0>> partitions;
+  llvm::SplitModule(
+      *module, partitionCount,
+      [&](std::unique_ptr<llvm::Module> partition) {
+        partitions.emplace_back();
+        llvm::raw_svector_ostream os(partitions.back());
+        llvm::WriteBitcodeToFile(*partition, os);
+      },
+      /*PreserveLocals=*/false);
+
+  size_t baseIndex = objData.size();
+  objData.resize(baseIndex + partitions.size());
+  std::atomic<bool> anyFailed(false);
+  {
+    llvm::ThreadPool threadPool(llvm::hardware_concurrency(partitions.size()));
+    for (size_t i = 0; i < partitions.size(); ++i) {
+      threadPool.async([&, i]() {
+        llvm::LLVMContext context;
+        auto partitionOr = llvm::parseBitcodeFile(
+            llvm::MemoryBufferRef(partitions[i].str(), "partition"), context);
+        if (!partitionOr) {
+          llvm::consumeError(partitionOr.takeError());
+          anyFailed = true;
+          return;
+        }
+        auto machine = createTargetMachine(options);
+        if (!machine ||
+            failed(runLLVMIRPasses(options, machine.get(),
+                                   partitionOr->get())) ||
+            failed(runEmitObjFilePasses(machine.get(), partitionOr->get(),
+                                        &objData[baseIndex + i]))) {
+          anyFailed = true;
+        }
+      });
+    }
+    threadPool.wait();
+  }
+  return failure(anyFailed);
+}
+
 }  // namespace HAL
 }  // namespace IREE
 }  // namespace iree_compiler
@@ -8,8 +8,10 @@
 #define IREE_COMPILER_DIALECT_HAL_TARGET_LLVM_LLVMIRPASSES_H_
 
 #include <memory>
+#include <string>
 
 #include "iree/compiler/Dialect/HAL/Target/LLVM/LLVMTargetOptions.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Target/TargetMachine.h"
 #include "mlir/Support/LogicalResult.h"
@@ -32,6 +34,13 @@ LogicalResult runLLVMIRPasses(const LLVMTargetOptions &options,
 LogicalResult runEmitObjFilePasses(llvm::TargetMachine *machine,
                                    llvm::Module *module, std::string *objData);
 
+// Splits |module| into up to |partitionCount| modules that are optimized and
+// compiled to object files concurrently, appending one object per partition
+// to |objData|. |module| itself is left unmodified.
+LogicalResult runParallelLLVMIRAndEmitObjFilePasses(
+    const LLVMTargetOptions &options, llvm::Module *module,
+    unsigned partitionCount, SmallVectorImpl<std::string> &objData);
+
 }  // namespace HAL
 }  // namespace IREE
 }  // namespace iree_compiler
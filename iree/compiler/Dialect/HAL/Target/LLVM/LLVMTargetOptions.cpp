@@ -69,6 +69,15 @@ LLVMTargetOptions getLLVMTargetOptionsFromFlags() {
                      "host native CPU"),
       llvm::cl::init(""));
 
+  static llvm::cl::list<std::string> clTargetCPUVariants(
+      "iree-llvm-target-cpu-variant",
+      llvm::cl::desc("Additional LLVM target machine CPU (such as "
+                     "'x86-64-v3') or CPU features (such as '+avx2,+fma') to "
+                     "compile executables for; the first one supported by the "
+                     "host is used at runtime. May be specified multiple "
+                     "times, from most to least preferred"),
+      llvm::cl::ZeroOrMore);
+
   static llvm::cl::opt<bool> llvmLoopInterleaving(
       "iree-llvm-loop-interleaving", llvm::cl::init(false),
       llvm::cl::desc("Enable LLVM loop interleaving opt"));
@@ -89,6 +98,8 @@ LLVMTargetOptions getLLVMTargetOptionsFromFlags() {
   if (clTargetCPUFeatures != "host") {
     targetOptions.targetCPUFeatures = clTargetCPUFeatures;
   }
+  targetOptions.targetCPUVariants.assign(clTargetCPUVariants.begin(),
+                                         clTargetCPUVariants.end());
 
   // LLVM opt options.
   targetOptions.pipelineTuningOptions.LoopInterleaving = llvmLoopInterleaving;
@@ -96,6 +107,14 @@ LLVMTargetOptions getLLVMTargetOptionsFromFlags() {
   targetOptions.pipelineTuningOptions.LoopUnrolling = llvmLoopUnrolling;
   targetOptions.pipelineTuningOptions.SLPVectorization = llvmSLPVectorization;
 
+  static llvm::cl::opt<int> clCodegenPartitions(
+      "iree-llvm-codegen-partitions",
+      llvm::cl::desc("Number of partitions each executable library is split "
+                     "into for parallel LLVM optimization and code "
+                     "generation; 0 uses one per hardware thread"),
+      llvm::cl::init(targetOptions.codegenPartitions));
+  targetOptions.codegenPartitions = clCodegenPartitions;
+
   static llvm::cl::opt<SanitizerKind> clSanitizerKind(
       "iree-llvm-sanitize", llvm::cl::desc("Apply LLVM sanitize feature"),
       llvm::cl::init(SanitizerKind::kNone),
@@ -103,6 +122,14 @@ LLVMTargetOptions getLLVMTargetOptionsFromFlags() {
                                   "Address sanitizer support")));
   targetOptions.sanitizerKind = clSanitizerKind;
 
+  static llvm::cl::opt<bool> clFlushDenormalsToZero(
+      "iree-llvm-flush-denormals-to-zero",
+      llvm::cl::desc("Executes the generated executables with denormal "
+                     "floating-point values flushed to zero (FTZ/DAZ); avoids "
+                     "the slow paths some CPUs take on denormals"),
+      llvm::cl::init(false));
+  targetOptions.flushDenormalsToZero = clFlushDenormalsToZero;
+
   static llvm::cl::opt<std::string> clTargetABI(
       "iree-llvm-target-abi",
       llvm::cl::desc("LLVM target machine ABI; specify for -mabi"),
@@ -171,6 +198,30 @@ LLVMTargetOptions getLLVMTargetOptionsFromFlags() {
       llvm::cl::init(targetOptions.staticLibraryOutput));
   targetOptions.staticLibraryOutput = clStaticLibraryOutputPath;
 
+  static llvm::cl::opt<bool> clStaticLibraryLTO(
+      "iree-llvm-static-library-lto",
+      llvm::cl::desc(
+          "Emits the static library object as LLVM bitcode with externally "
+          "visible entry points and a direct-call dispatch table in the "
+          "generated '.h' for link-time optimization into the host program."),
+      llvm::cl::init(targetOptions.staticLibraryLTO));
+  targetOptions.staticLibraryLTO = clStaticLibraryLTO;
+
+  static llvm::cl::opt<bool> clWasmSIMD(
+      "iree-llvm-wasm-simd",
+      llvm::cl::desc("Enables 128-bit SIMD (+simd128) when targeting "
+                     "WebAssembly"),
+      llvm::cl::init(targetOptions.wasmSIMD));
+  targetOptions.wasmSIMD = clWasmSIMD;
+
+  static llvm::cl::opt<bool> clWasmThreads(
+      "iree-llvm-wasm-threads",
+      llvm::cl::desc("Enables atomics and bulk memory when targeting "
+                     "WebAssembly such that executables can be linked into "
+                     "runtimes using wasm threads (shared memory)"),
+      llvm::cl::init(targetOptions.wasmThreads));
+  targetOptions.wasmThreads = clWasmThreads;
+
   static llvm::cl::opt<bool> clListTargets(
       "iree-llvm-list-targets",
       llvm::cl::desc("Lists all registered targets that the LLVM backend can "
@@ -192,6 +243,21 @@ LLVMTargetOptions getLLVMTargetOptionsFromFlags() {
     targetOptions.targetTriple = triple.str();
   }
 
+  // Add the WebAssembly extensions requested. SIMD is exposed to codegen
+  // through the CPU features such that vectorized code is lowered to simd128
+  // instructions instead of being scalarized.
+  llvm::Triple triple(targetOptions.targetTriple);
+  if (triple.isWasm() &&
+      (targetOptions.wasmSIMD || targetOptions.wasmThreads)) {
+    llvm::SubtargetFeatures features(targetOptions.targetCPUFeatures);
+    if (targetOptions.wasmSIMD) features.AddFeature("simd128");
+    if (targetOptions.wasmThreads) {
+      features.AddFeature("atomics");
+      features.AddFeature("bulk-memory");
+    }
+    targetOptions.targetCPUFeatures = features.getString();
+  }
+
   return targetOptions;
 }
 
@@ -28,10 +28,22 @@ struct LLVMTargetOptions {
   std::string targetCPU;
   std::string targetCPUFeatures;
 
+  // Additional CPU variants each executable is compiled for. Each variant is
+  // either a CPU name (such as `x86-64-v3`) or a list of CPU features added to
+  // targetCPUFeatures (such as `+avx512f,+avx512vnni`). At runtime the first
+  // variant supported by the host is selected and the baseline
+  // targetCPU/targetCPUFeatures are used if none are.
+  std::vector<std::string> targetCPUVariants;
+
   llvm::PipelineTuningOptions pipelineTuningOptions;
   llvm::OptimizationLevel optLevel;
   llvm::TargetOptions options;
 
+  // Number of partitions a module is split into so that the partitions are
+  // optimized and compiled to object files concurrently. 0 uses one partition
+  // per hardware thread and 1 compiles the module as a whole.
+  int codegenPartitions = 0;
+
   // Include debug information in output files (PDB, DWARF, etc).
   // Though this can be set independently from the optLevel (so -O3 with debug
   // information is valid) it may significantly change the output program
@@ -41,6 +53,11 @@ struct LLVMTargetOptions {
   // Sanitizer Kind for CPU Kernels
   SanitizerKind sanitizerKind = SanitizerKind::kNone;
 
+  // Declares that the executables require denormal floating-point values to be
+  // flushed to zero (FTZ/DAZ) such that the runtime sets up the FPU state of
+  // the threads executing them.
+  bool flushDenormalsToZero = false;
+
   // Tool to use for linking (like lld). Acts as a prefix to the command line
   // and can contain additional arguments.
   std::string linkerPath;
@@ -65,6 +82,20 @@ struct LLVMTargetOptions {
   //
   // This option is incompatible with the linkEmbedded option.
   std::string staticLibraryOutput;
+
+  // Emits the static library object as LLVM bitcode with externally visible
+  // entry points and a direct-call dispatch table in the generated header so
+  // that hosts building with LTO can inline dispatches across the library
+  // boundary. Only valid with staticLibraryOutput.
+  bool staticLibraryLTO = false;
+
+  // Enables the 128-bit SIMD extension when targeting WebAssembly.
+  bool wasmSIMD = false;
+
+  // Enables the atomics and bulk-memory extensions when targeting WebAssembly
+  // such that the produced objects can be linked into programs using wasm
+  // threads (shared memory), such as the emscripten pthreads runtime.
+  bool wasmThreads = false;
 };
 
 // Returns LLVMTargetOptions struct intialized with the iree-llvm-* flags.
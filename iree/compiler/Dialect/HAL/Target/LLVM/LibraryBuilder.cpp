@@ -6,6 +6,9 @@
 
 #include "iree/compiler/Dialect/HAL/Target/LLVM/LibraryBuilder.h"
 
+#include <algorithm>
+#include <cstdint>
+
 #include "llvm/IR/IRBuilder.h"
 
 // =============================================================================
@@ -189,6 +192,7 @@ static llvm::StructType *makeLibraryHeaderType(llvm::LLVMContext &context) {
 //   %struct.iree_hal_executable_library_header_t*,
 //   %struct.iree_hal_executable_import_table_v0_t,
 //   %struct.iree_hal_executable_export_table_v0_t,
+//   i32 (i8*)**,
 // }
 static llvm::StructType *makeLibraryType(llvm::StructType *libraryHeaderType) {
   auto &context = libraryHeaderType->getContext();
@@ -196,6 +200,11 @@ static llvm::StructType *makeLibraryType(llvm::StructType *libraryHeaderType) {
           context, "iree_hal_executable_library_v0_t")) {
     return existingType;
   }
+  auto *i32Type = llvm::IntegerType::getInt32Ty(context);
+  auto *i8PtrType = llvm::IntegerType::getInt8PtrTy(context);
+  auto *importPtrType =
+      llvm::FunctionType::get(i32Type, {i8PtrType}, /*isVarArg=*/false)
+          ->getPointerTo();
   auto *importTableType = makeImportTableType(context);
   auto *exportTableType = makeExportTableType(context);
   auto *type = llvm::StructType::create(context,
@@ -203,6 +212,7 @@ static llvm::StructType *makeLibraryType(llvm::StructType *libraryHeaderType) {
                                             libraryHeaderType->getPointerTo(),
                                             importTableType,
                                             exportTableType,
+                                            importPtrType->getPointerTo(),
                                         },
                                         "iree_hal_executable_library_v0_t",
                                         /*isPacked=*/false);
@@ -326,7 +336,7 @@ llvm::Constant *LibraryBuilder::buildLibraryV0ExportTable(
       llvm::find_if(exports, [](const Dispatch &dispatch) {
         return !dispatch.attrs.isDefault();
       }) != exports.end();
-  if (!hasNonDefaultAttrs) {
+  if (hasNonDefaultAttrs) {
     SmallVector<llvm::Constant *, 4> exportAttrValues;
     for (auto dispatch : exports) {
       exportAttrValues.push_back(llvm::ConstantStruct::get(
@@ -337,8 +347,13 @@ llvm::Constant *LibraryBuilder::buildLibraryV0ExportTable(
                   i16Type, RoundUpToAlignment(dispatch.attrs.localMemorySize,
                                               kWorkgroupLocalMemoryPageSize) /
                                kWorkgroupLocalMemoryPageSize),
-              // reserved=
-              llvm::ConstantInt::get(i16Type, 0),
+              // workgroup_cost=
+              llvm::ConstantInt::get(
+                  i16Type, std::min<int64_t>(
+                               RoundUpToAlignment(dispatch.attrs.workgroupCost,
+                                                  kWorkgroupCostUnit) /
+                                   kWorkgroupCostUnit,
+                               UINT16_MAX)),
           }));
     }
     auto *exportAttrsType =
@@ -452,6 +467,9 @@ llvm::Constant *LibraryBuilder::buildLibraryV0(std::string libraryName) {
                                     buildLibraryV0ImportTable(libraryName),
                                     // exports=
                                     buildLibraryV0ExportTable(libraryName),
+                                    // import_bindings=
+                                    llvm::Constant::getNullValue(
+                                        libraryType->getElementType(3)),
                                 }),
       /*Name=*/libraryName);
   // TODO(benvanik): force alignment (8? natural pointer width?)
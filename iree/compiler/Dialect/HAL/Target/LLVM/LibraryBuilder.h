@@ -51,6 +51,10 @@ class LibraryBuilder {
   enum class Features : uint32_t {
     // IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_NONE
     NONE = 0u,
+    // IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_DIRECT_IMPORTS
+    DIRECT_IMPORTS = 1u << 0,
+    // IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_FLUSH_DENORMALS_TO_ZERO
+    FLUSH_DENORMALS_TO_ZERO = 1u << 1,
   };
 
   // iree_hal_executable_library_sanitizer_kind_t
@@ -70,13 +74,22 @@ class LibraryBuilder {
   // IREE_HAL_WORKGROUP_LOCAL_MEMORY_PAGE_SIZE
   static const int64_t kWorkgroupLocalMemoryPageSize = 4096;
 
+  // IREE_HAL_WORKGROUP_COST_UNIT
+  static const int64_t kWorkgroupCostUnit = 1024;
+
   // iree_hal_executable_dispatch_attrs_v0_t
   struct DispatchAttrs {
     // Required workgroup local memory size, in bytes.
     int64_t localMemorySize = 0;
 
+    // Estimated cost of a single workgroup in approximate scalar operations or
+    // 0 if unknown.
+    int64_t workgroupCost = 0;
+
     // True if all values are default and the attributes may be omitted.
-    constexpr bool isDefault() const { return localMemorySize == 0; }
+    constexpr bool isDefault() const {
+      return localMemorySize == 0 && workgroupCost == 0;
+    }
   };
 
   LibraryBuilder(llvm::Module *module, Mode mode,
@@ -4,6 +4,8 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include "iree/compiler/Dialect/HAL/Target/LLVM/StaticLibraryGenerator.h"
+
 #include <algorithm>
 #include <cstring>
 #include <fstream>
@@ -57,6 +59,38 @@ static void generateQueryFunction(llvm::raw_ostream &os,
      << "iree_hal_executable_library_version_t max_version, void* reserved);\n";
 }
 
+static void generateDirectDispatch(
+    llvm::raw_ostream &os, const std::string &library_name,
+    llvm::ArrayRef<std::string> direct_export_names) {
+  // Entry point declarations:
+  os << "\n// Entry points linked directly into the host program.\n";
+  for (const auto &name : direct_export_names) {
+    os << "int " << name << "(\n"
+       << "    const iree_hal_executable_dispatch_state_v0_t* dispatch_state,\n"
+       << "    const iree_hal_vec3_t* workgroup_id, void* local_memory);\n";
+  }
+
+  // Direct-call dispatch table:
+  os << "\n// Calls the entry point with the given export |ordinal| directly.\n"
+     << "// With LTO enabled small dispatches may be inlined into the caller.\n"
+     << "// Returns non-zero if the ordinal is out of range or the dispatch "
+        "fails.\n"
+     << "static inline int " << library_name << "_dispatch(\n"
+     << "    uint32_t ordinal,\n"
+     << "    const iree_hal_executable_dispatch_state_v0_t* dispatch_state,\n"
+     << "    const iree_hal_vec3_t* workgroup_id, void* local_memory) {\n"
+     << "  switch (ordinal) {\n";
+  for (size_t i = 0; i < direct_export_names.size(); ++i) {
+    os << "    case " << i << ":\n"
+       << "      return " << direct_export_names[i]
+       << "(dispatch_state, workgroup_id, local_memory);\n";
+  }
+  os << "    default:\n"
+     << "      return 1;\n"
+     << "  }\n"
+     << "}\n";
+}
+
 static void generateSuffix(llvm::raw_ostream &os,
                            const std::string &library_name,
                            const std::string &query_function_name) {
@@ -73,12 +107,16 @@ static void generateSuffix(llvm::raw_ostream &os,
 
 static bool generateExecutableLibraryHeader(
     const std::string &library_name, const std::string &query_function_name,
-    const std::string &header_file_path) {
+    const std::string &header_file_path,
+    llvm::ArrayRef<std::string> direct_export_names) {
   std::error_code ec;
   llvm::raw_fd_ostream os(header_file_path, ec);
 
   generatePrefix(os, library_name, query_function_name);
   generateQueryFunction(os, library_name, query_function_name);
+  if (!direct_export_names.empty()) {
+    generateDirectDispatch(os, library_name, direct_export_names);
+  }
   generateSuffix(os, library_name, query_function_name);
 
   os.close();
@@ -88,7 +126,8 @@ static bool generateExecutableLibraryHeader(
 bool outputStaticLibrary(const std::string &library_name,
                          const std::string &query_function_name,
                          const std::string &library_output_path,
-                         const std::string &temp_object_path) {
+                         const std::string &temp_object_path,
+                         llvm::ArrayRef<std::string> direct_export_names) {
   llvm::SmallString<32> object_file_path(library_output_path);
   llvm::sys::path::replace_extension(object_file_path, ".o");
   llvm::SmallString<32> header_file_path(library_output_path);
@@ -102,7 +141,8 @@ bool outputStaticLibrary(const std::string &library_name,
 
   // Generate the header file.
   return generateExecutableLibraryHeader(library_name, query_function_name,
-                                         header_file_path.c_str());
+                                         header_file_path.c_str(),
+                                         direct_export_names);
 }
 
 }  // namespace HAL
@@ -10,6 +10,8 @@
 
 #include <string>
 
+#include "llvm/ADT/ArrayRef.h"
+
 namespace mlir {
 namespace iree_compiler {
 namespace IREE {
@@ -19,10 +21,16 @@ namespace HAL {
 // The temporary object file is copied to the library_output_path. The '.h' file
 // with the query_function_name is placed beside it (using the same base
 // filename of the library). Returns true if successful.
+//
+// If |direct_export_names| is not empty the '.h' also declares each of the
+// named entry point functions (in export ordinal order) along with an inline
+// direct-call dispatch function. This is used when the object contains LLVM
+// bitcode intended for link-time optimization into the host program.
 bool outputStaticLibrary(const std::string &library_name,
                          const std::string &query_function_name,
                          const std::string &library_output_path,
-                         const std::string &temp_object_path);
+                         const std::string &temp_object_path,
+                         llvm::ArrayRef<std::string> direct_export_names = {});
 
 }  // namespace HAL
 }  // namespace IREE
@@ -31,8 +31,29 @@ TargetOptions getTargetOptionsFromFlags() {
           llvm::cl::desc("Target backends for executable compilation"),
           llvm::cl::ZeroOrMore, llvm::cl::cat(halTargetOptionsCategory)};
 
+  static llvm::cl::opt<int64_t> *targetDeviceCountFlag =
+      new llvm::cl::opt<int64_t>{
+          "iree-hal-target-device-count",
+          llvm::cl::desc("Number of devices to partition the program across"),
+          llvm::cl::init(1), llvm::cl::cat(halTargetOptionsCategory)};
+
+  static llvm::cl::opt<bool> *partitionByTargetFlag = new llvm::cl::opt<bool>{
+      "iree-hal-partition-by-target",
+      llvm::cl::desc("Executes each target backend on its own device and "
+                     "partitions the program between them by cost"),
+      llvm::cl::init(false), llvm::cl::cat(halTargetOptionsCategory)};
+
+  static llvm::cl::opt<bool> *unifiedMemoryFlag = new llvm::cl::opt<bool>{
+      "iree-hal-unified-memory",
+      llvm::cl::desc("Devices share memory allocated from the first device "
+                     "and exchange buffers without copies"),
+      llvm::cl::init(false), llvm::cl::cat(halTargetOptionsCategory)};
+
   TargetOptions targetOptions;
   targetOptions.targets = *targetBackendsFlag;
+  targetOptions.deviceCount = *targetDeviceCountFlag;
+  targetOptions.partitionByTarget = *partitionByTargetFlag;
+  targetOptions.unifiedMemory = *unifiedMemoryFlag;
   return targetOptions;
 }
 
@@ -173,8 +194,9 @@ LogicalResult TargetBackend::linkExecutablesInto(
     auto variantOps = llvm::to_vector<4>(
         sourceExecutableOp.getOps<IREE::HAL::ExecutableVariantOp>());
     for (auto variantOp : variantOps) {
-      // Only process targets matching our pattern.
-      if (variantOp.target().getBackend().getValue() != name()) continue;
+      // Only process variants for the target being linked. Other targets of
+      // the same backend are linked into their own executables.
+      if (variantOp.target() != linkedTargetOp.target()) continue;
 
       // Clone entry point ops and queue remapping ordinals and updating
       // symbol refs.
@@ -247,6 +269,37 @@ LogicalResult TargetBackend::linkExecutablesInto(
   return success();
 }
 
+SmallVector<IREE::HAL::ExecutableTargetAttr, 4>
+TargetBackend::gatherExecutableTargets(mlir::ModuleOp moduleOp) {
+  SmallVector<IREE::HAL::ExecutableTargetAttr, 4> targetAttrs;
+  for (auto executableOp : moduleOp.getOps<IREE::HAL::ExecutableOp>()) {
+    for (auto variantOp :
+         executableOp.getOps<IREE::HAL::ExecutableVariantOp>()) {
+      auto targetAttr = variantOp.target();
+      if (targetAttr.getBackend().getValue() != name()) continue;
+      if (!llvm::is_contained(targetAttrs, targetAttr)) {
+        targetAttrs.push_back(targetAttr);
+      }
+    }
+  }
+  return targetAttrs;
+}
+
+SmallVector<IREE::HAL::ExecutableOp, 8>
+TargetBackend::gatherExecutablesForTarget(
+    mlir::ModuleOp moduleOp, IREE::HAL::ExecutableTargetAttr targetAttr) {
+  SmallVector<IREE::HAL::ExecutableOp, 8> executableOps;
+  for (auto executableOp : moduleOp.getOps<IREE::HAL::ExecutableOp>()) {
+    auto variantOps = executableOp.getOps<IREE::HAL::ExecutableVariantOp>();
+    if (llvm::any_of(variantOps, [&](IREE::HAL::ExecutableVariantOp variantOp) {
+          return variantOp.target() == targetAttr;
+        })) {
+      executableOps.push_back(executableOp);
+    }
+  }
+  return executableOps;
+}
+
 }  // namespace HAL
 }  // namespace IREE
 }  // namespace iree_compiler
@@ -30,6 +30,19 @@ struct TargetOptions {
   // TODO(benvanik): multiple targets of the same type, etc.
   std::vector<std::string> targets;
 
+  // Number of devices of the targets that the program is partitioned across.
+  // Devices beyond the first are provided to the runtime HAL module by ordinal.
+  int64_t deviceCount = 1;
+
+  // Executes each of the targets on its own device (ordered as |targets|) and
+  // partitions the program between them by estimated cost.
+  bool partitionByTarget = false;
+
+  // Devices share host-visible memory (such as unified memory SoCs) such that
+  // buffers allocated from the first device can be used by all of them without
+  // copies.
+  bool unifiedMemory = false;
+
   // TODO(benvanik): flags for debug/optimization/etc.
   // The intent is that we can have a global debug/-ON flag that then each
   // target backend can have tickle it's own flags in the right way. Right now
@@ -197,6 +210,12 @@ class TargetBackend {
     return success();
   }
 
+  // Returns a string identifying all backend configuration that affects the
+  // translation and serialization of executables (target machine options,
+  // etc). Results are only cached across compilations for backends returning
+  // a non-empty string.
+  virtual std::string getExecutableCacheKey() const { return ""; }
+
   // Serializes the given |variantOp| executable produced by this backend to one
   // or more binary byte buffer formats used for storage in the module file.
   // Implementations should insert `hal.executable.binary` ops for each format
@@ -220,6 +239,17 @@ class TargetBackend {
       IREE::HAL::ExecutableVariantOp linkedTargetOp,
       std::function<Operation *(mlir::ModuleOp moduleOp)> getInnerModuleFn,
       OpBuilder &builder);
+
+  // Returns the distinct executable targets of this backend used by variants
+  // within |moduleOp| in the order they are first used. Each target should be
+  // linked into its own executable as variants for different targets (such as
+  // different architectures or CPU features) cannot be combined.
+  SmallVector<IREE::HAL::ExecutableTargetAttr, 4> gatherExecutableTargets(
+      mlir::ModuleOp moduleOp);
+
+  // Returns all executables within |moduleOp| with a variant for |targetAttr|.
+  SmallVector<IREE::HAL::ExecutableOp, 8> gatherExecutablesForTarget(
+      mlir::ModuleOp moduleOp, IREE::HAL::ExecutableTargetAttr targetAttr);
 };
 
 }  // namespace HAL
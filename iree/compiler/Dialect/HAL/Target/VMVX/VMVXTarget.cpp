@@ -66,39 +66,51 @@ class VMVXTargetBackend final : public TargetBackend {
   LogicalResult linkExecutables(mlir::ModuleOp moduleOp) override {
     OpBuilder builder = OpBuilder::atBlockBegin(moduleOp.getBody());
 
-    auto sourceExecutableOps =
-        llvm::to_vector<8>(moduleOp.getOps<IREE::HAL::ExecutableOp>());
-    if (sourceExecutableOps.size() <= 1) return success();
-
-    // TODO(benvanik): rework linking to support multiple formats.
-    auto sharedTargetAttr = getExecutableTarget(builder.getContext());
-
-    // Create our new "linked" hal.executable.
-    std::string linkedExecutableName = llvm::formatv("{0}_linked", name());
-    auto linkedExecutableOp = builder.create<IREE::HAL::ExecutableOp>(
-        moduleOp.getLoc(), linkedExecutableName);
-    linkedExecutableOp.setVisibility(
-        sourceExecutableOps.front().getVisibility());
-
-    // Add our VMVX hal.executable.variant with an empty module.
-    builder.setInsertionPointToStart(linkedExecutableOp.getBody());
-    auto linkedTargetOp = builder.create<IREE::HAL::ExecutableVariantOp>(
-        moduleOp.getLoc(), sharedTargetAttr.getSymbolNameFragment(),
-        sharedTargetAttr);
-    builder.setInsertionPoint(&linkedTargetOp.getBlock().back());
-    auto linkedModuleOp = builder.create<ModuleOp>(moduleOp.getLoc());
-
-    // Add an empty vm.module to that module (as our vm.funcs must live in it).
-    builder.setInsertionPointToStart(linkedModuleOp.getBody());
-    builder.create<IREE::VM::ModuleOp>(moduleOp.getLoc(), "linked_module");
-
-    // Try linking together all executables in moduleOp.
-    return linkExecutablesInto(
-        moduleOp, sourceExecutableOps, linkedExecutableOp, linkedTargetOp,
-        [](mlir::ModuleOp moduleOp) {
-          return *moduleOp.getOps<IREE::VM::ModuleOp>().begin();
-        },
-        builder);
+    // Link each target into a single executable such that only one needs to
+    // be loaded for it.
+    auto targetAttrs = gatherExecutableTargets(moduleOp);
+    for (auto targetAttr : llvm::enumerate(targetAttrs)) {
+      auto sourceExecutableOps =
+          gatherExecutablesForTarget(moduleOp, targetAttr.value());
+      if (sourceExecutableOps.size() <= 1) continue;
+
+      // Create our new "linked" hal.executable.
+      std::string linkedExecutableName = llvm::formatv("{0}_linked", name());
+      if (targetAttrs.size() > 1) {
+        linkedExecutableName +=
+            llvm::formatv("_{0}", targetAttr.index()).str();
+      }
+      builder.setInsertionPointToStart(moduleOp.getBody());
+      auto linkedExecutableOp = builder.create<IREE::HAL::ExecutableOp>(
+          moduleOp.getLoc(), linkedExecutableName);
+      linkedExecutableOp.setVisibility(
+          sourceExecutableOps.front().getVisibility());
+
+      // Add our VMVX hal.executable.variant with an empty module.
+      builder.setInsertionPointToStart(linkedExecutableOp.getBody());
+      auto linkedTargetOp = builder.create<IREE::HAL::ExecutableVariantOp>(
+          moduleOp.getLoc(), targetAttr.value().getSymbolNameFragment(),
+          targetAttr.value());
+      builder.setInsertionPoint(&linkedTargetOp.getBlock().back());
+      auto linkedModuleOp = builder.create<ModuleOp>(moduleOp.getLoc());
+
+      // Add an empty vm.module to that module (as our vm.funcs must live in
+      // it).
+      builder.setInsertionPointToStart(linkedModuleOp.getBody());
+      builder.create<IREE::VM::ModuleOp>(moduleOp.getLoc(), "linked_module");
+
+      // Try linking together all executables for the target in moduleOp.
+      if (failed(linkExecutablesInto(
+              moduleOp, sourceExecutableOps, linkedExecutableOp,
+              linkedTargetOp,
+              [](mlir::ModuleOp moduleOp) {
+                return *moduleOp.getOps<IREE::VM::ModuleOp>().begin();
+              },
+              builder))) {
+        return failure();
+      }
+    }
+    return success();
   }
 
   LogicalResult serializeExecutable(IREE::HAL::ExecutableVariantOp variantOp,
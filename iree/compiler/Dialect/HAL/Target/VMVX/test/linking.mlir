@@ -384,3 +384,108 @@ hal.executable @dispatch_1 attributes {sym_visibility = "private"} {
 // CHECK-NEXT:          %[[BUF_rodata_d_0:.+]] = vm.const.ref.rodata @rodata_d_0 : !vm.buffer
 // CHECK-NEXT:          %[[BUF_rodata_e:.+]] = vm.const.ref.rodata @rodata_e : !vm.buffer
 // CHECK-NEXT:          %[[BUF_rodata_f:.+]] = vm.const.ref.rodata @rodata_f : !vm.buffer
+
+// -----
+
+#vmvx_target = #hal.executable.target<"vmvx", "vmvx-bytecode-fb">
+#vmvx_debug_target = #hal.executable.target<"vmvx", "vmvx-bytecode-fb", {debug}>
+
+hal.executable @dispatch_0 attributes {sym_visibility = "private"} {
+  hal.interface @io {
+    hal.interface.binding @arg0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @ret0, set=0, binding=1, type="StorageBuffer", access="Write|Discard"
+  }
+  hal.executable.variant @vmvx, target = #vmvx_target {
+    hal.executable.entry_point @dispatch_0 attributes {interface = @io, ordinal = 0 : index}
+    module {
+      vm.module @module {
+        vm.func @dispatch_0() {
+          vm.return
+        }
+        vm.export @dispatch_0
+      }
+    }
+  }
+  hal.executable.variant @vmvx_debug, target = #vmvx_debug_target {
+    hal.executable.entry_point @dispatch_0 attributes {interface = @io, ordinal = 0 : index}
+    module {
+      vm.module @module {
+        vm.func @dispatch_0() {
+          vm.return
+        }
+        vm.export @dispatch_0
+      }
+    }
+  }
+}
+hal.executable @dispatch_1 attributes {sym_visibility = "private"} {
+  hal.interface @io {
+    hal.interface.binding @arg0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @ret0, set=0, binding=1, type="StorageBuffer", access="Write|Discard"
+  }
+  hal.executable.variant @vmvx, target = #vmvx_target {
+    hal.executable.entry_point @dispatch_1 attributes {interface = @io, ordinal = 0 : index}
+    module {
+      vm.module @module {
+        vm.func @dispatch_1() {
+          vm.return
+        }
+        vm.export @dispatch_1
+      }
+    }
+  }
+  hal.executable.variant @vmvx_debug, target = #vmvx_debug_target {
+    hal.executable.entry_point @dispatch_1 attributes {interface = @io, ordinal = 0 : index}
+    module {
+      vm.module @module {
+        vm.func @dispatch_1() {
+          vm.return
+        }
+        vm.export @dispatch_1
+      }
+    }
+  }
+}
+func @multiple_targets() -> () {
+  %device = hal.ex.shared_device : !hal.device
+  %cmd = hal.command_buffer.create device(%device : !hal.device) mode("OneShot") categories("Transfer|Dispatch") : !hal.command_buffer
+  %c1 = constant 1 : index
+  hal.command_buffer.dispatch.symbol<%cmd : !hal.command_buffer> target(@dispatch_0::@vmvx::@dispatch_0) workgroups([%c1, %c1, %c1])
+  hal.command_buffer.dispatch.symbol<%cmd : !hal.command_buffer> target(@dispatch_1::@vmvx::@dispatch_1) workgroups([%c1, %c1, %c1])
+  hal.command_buffer.dispatch.symbol<%cmd : !hal.command_buffer> target(@dispatch_0::@vmvx_debug::@dispatch_0) workgroups([%c1, %c1, %c1])
+  hal.command_buffer.dispatch.symbol<%cmd : !hal.command_buffer> target(@dispatch_1::@vmvx_debug::@dispatch_1) workgroups([%c1, %c1, %c1])
+  return
+}
+
+// Each distinct target should be linked into its own executable with the
+// interfaces shared by all of its entry points deduplicated.
+// CHECK-NOT: hal.executable @dispatch_0
+// CHECK-NOT: hal.executable @dispatch_1
+// CHECK:       hal.executable @vmvx_linked_1 attributes {sym_visibility = "private"} {
+// CHECK-NEXT:    hal.interface @io_0 {
+// CHECK-NEXT:      hal.interface.binding @arg0, set=0, binding=0, type="StorageBuffer", access="Read"
+// CHECK-NEXT:      hal.interface.binding @ret0, set=0, binding=1, type="StorageBuffer", access="Write|Discard"
+// CHECK-NEXT:    }
+// CHECK-NEXT:    hal.executable.variant @vmvx_bytecode_fb, target = #[[DEBUG_TARGET:.+]] {
+// CHECK-NEXT:      hal.executable.entry_point @dispatch_0 attributes {interface = @io_0, ordinal = 0 : index}
+// CHECK-NEXT:      hal.executable.entry_point @dispatch_1 attributes {interface = @io_0, ordinal = 1 : index}
+// CHECK:         }
+// CHECK-NEXT:  }
+// CHECK:       hal.executable @vmvx_linked_0 attributes {sym_visibility = "private"} {
+// CHECK-NEXT:    hal.interface @io_0 {
+// CHECK-NEXT:      hal.interface.binding @arg0, set=0, binding=0, type="StorageBuffer", access="Read"
+// CHECK-NEXT:      hal.interface.binding @ret0, set=0, binding=1, type="StorageBuffer", access="Write|Discard"
+// CHECK-NEXT:    }
+// CHECK-NEXT:    hal.executable.variant @vmvx_bytecode_fb, target = #executable_target_vmvx_bytecode_fb {
+// CHECK-NEXT:      hal.executable.entry_point @dispatch_0 attributes {interface = @io_0, ordinal = 0 : index}
+// CHECK-NEXT:      hal.executable.entry_point @dispatch_1 attributes {interface = @io_0, ordinal = 1 : index}
+// CHECK:         }
+// CHECK-NEXT:  }
+//
+// CHECK:       func @multiple_targets() {
+// CHECK:         hal.command_buffer.dispatch.symbol<%cmd : !hal.command_buffer> target(@vmvx_linked_0::@vmvx_bytecode_fb::@dispatch_0) workgroups([%c1, %c1, %c1])
+// CHECK-NEXT:    hal.command_buffer.dispatch.symbol<%cmd : !hal.command_buffer> target(@vmvx_linked_0::@vmvx_bytecode_fb::@dispatch_1) workgroups([%c1, %c1, %c1])
+// CHECK-NEXT:    hal.command_buffer.dispatch.symbol<%cmd : !hal.command_buffer> target(@vmvx_linked_1::@vmvx_bytecode_fb::@dispatch_0) workgroups([%c1, %c1, %c1])
+// CHECK-NEXT:    hal.command_buffer.dispatch.symbol<%cmd : !hal.command_buffer> target(@vmvx_linked_1::@vmvx_bytecode_fb::@dispatch_1) workgroups([%c1, %c1, %c1])
+// CHECK-NEXT:    return
+// CHECK-NEXT:  }
@@ -0,0 +1,282 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "iree/compiler/Dialect/Flow/IR/FlowOps.h"
+#include "iree/compiler/Dialect/HAL/IR/HALDialect.h"
+#include "iree/compiler/Dialect/HAL/IR/HALTypes.h"
+#include "iree/compiler/Dialect/HAL/Transforms/Passes.h"
+#include "llvm/Support/Debug.h"
+#include "mlir/IR/Attributes.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/Pass/Pass.h"
+
+#define DEBUG_TYPE "iree-hal-assign-device-affinities"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace HAL {
+
+// Returns the number of workgroups |dispatchOp| within |streamOp| launches,
+// counting dynamic workgroup counts as a single workgroup along the dynamic
+// dimensions.
+static int64_t estimateWorkgroupCount(IREE::Flow::ExStreamFragmentOp streamOp,
+                                      IREE::Flow::DispatchOp dispatchOp) {
+  auto &entryBlock = streamOp.body().front();
+  int64_t workgroupCount = 1;
+  for (auto value : dispatchOp.workgroup_count()) {
+    // Workgroup counts are usually captured from the parent block.
+    if (auto blockArg = value.dyn_cast<BlockArgument>()) {
+      if (blockArg.getOwner() == &entryBlock) {
+        value = streamOp.operands()[blockArg.getArgNumber()];
+      }
+    }
+    APInt staticValue;
+    if (matchPattern(value, m_ConstantInt(&staticValue))) {
+      workgroupCount *= std::max<int64_t>(staticValue.getSExtValue(), 1);
+    }
+  }
+  return workgroupCount;
+}
+
+// Returns an estimate of the cost of executing |streamOp|: the total number of
+// workgroups dispatched.
+static int64_t estimateStreamCost(IREE::Flow::ExStreamFragmentOp streamOp) {
+  int64_t cost = 0;
+  streamOp.walk([&](IREE::Flow::DispatchOp dispatchOp) {
+    cost += estimateWorkgroupCount(streamOp, dispatchOp);
+  });
+  // Streams without dispatches still perform transfers.
+  return std::max<int64_t>(cost, 1);
+}
+
+// Rough shape of the work performed by a dispatch.
+enum class DispatchKind {
+  // Matmuls and convolutions.
+  Dense = 0,
+  // Data-dependent control flow and memory accesses (sort, scatter, ...).
+  Irregular = 1,
+  // Everything else; usually memory bound.
+  Elementwise = 2,
+};
+
+// Classifies the dispatch region of |executableOp| by the ops it contains.
+static DispatchKind classifyExecutable(
+    IREE::Flow::ExecutableOp executableOp) {
+  auto kind = DispatchKind::Elementwise;
+  executableOp.walk([&](Operation *op) {
+    auto opName = op->getName().getStringRef();
+    if (op->getDialect() &&
+        op->getDialect()->getNamespace() == "linalg_ext") {
+      kind = DispatchKind::Irregular;
+      return WalkResult::interrupt();
+    }
+    if (opName.startswith("linalg.matmul") ||
+        opName.startswith("linalg.batch_matmul") ||
+        opName.startswith("linalg.matvec") ||
+        opName.startswith("linalg.vecmat") ||
+        opName.startswith("linalg.mmt4d") ||
+        opName.startswith("linalg.conv") ||
+        opName.startswith("linalg.depthwise_conv")) {
+      kind = DispatchKind::Dense;
+    }
+    return WalkResult::advance();
+  });
+  return kind;
+}
+
+// Relative cost of executing work on a class of device.
+struct DeviceCostModel {
+  // Cost per workgroup indexed by DispatchKind.
+  int64_t workgroupCost[3];
+  // Fixed cost of each dispatch.
+  int64_t launchCost;
+};
+
+// CPUs are good at irregular work and launch dispatches cheaply while GPUs
+// are much faster at dense work but have a high fixed cost per dispatch.
+static const DeviceCostModel kCPUCostModel = {{8, 1, 2}, 1};
+static const DeviceCostModel kGPUCostModel = {{1, 8, 1}, 16};
+
+// Cost of synchronizing two devices when a stream consumes the results of a
+// stream on another device.
+static const int64_t kCrossDeviceSyncCost = 64;
+// Bytes copied between devices per unit of cost.
+static const int64_t kCrossDeviceBytesPerCost = 4096;
+
+static const DeviceCostModel &lookupDeviceCostModel(
+    IREE::HAL::DeviceTargetAttr targetAttr) {
+  auto deviceID = targetAttr.getDeviceID().getValue();
+  if (deviceID == "cpu" || deviceID == "vmvx") return kCPUCostModel;
+  return kGPUCostModel;
+}
+
+// Returns the number of bytes in |value| treating dynamic dimensions as 1.
+static int64_t estimateValueSize(Value value) {
+  auto shapedType = value.getType().dyn_cast<ShapedType>();
+  if (!shapedType || !shapedType.hasRank()) return 0;
+  int64_t elementCount = 1;
+  for (int64_t dim : shapedType.getShape()) {
+    elementCount *= ShapedType::isDynamic(dim) ? 1 : dim;
+  }
+  int64_t elementBits = shapedType.getElementType().isIntOrFloat()
+                            ? shapedType.getElementTypeBitWidth()
+                            : 8;
+  return elementCount * ((elementBits + 7) / 8);
+}
+
+class AssignDeviceAffinitiesPass
+    : public PassWrapper<AssignDeviceAffinitiesPass, OperationPass<ModuleOp>> {
+ public:
+  StringRef getArgument() const override {
+    return "iree-hal-assign-device-affinities";
+  }
+
+  StringRef getDescription() const override {
+    return "Partitions the streams of each function across the devices of a "
+           "multi-device module.";
+  }
+
+  void runOnOperation() override {
+    auto moduleOp = getOperation();
+    auto deviceCountAttr =
+        moduleOp->getAttrOfType<IntegerAttr>("hal.device.count");
+    if (!deviceCountAttr) return;
+    int64_t deviceCount = deviceCountAttr.getInt();
+    if (deviceCount <= 1) return;
+
+    if (moduleOp->hasAttr("hal.device.partition_by_target")) {
+      auto targetAttrs = IREE::HAL::DeviceTargetAttr::lookup(moduleOp);
+      if (static_cast<int64_t>(targetAttrs.size()) != deviceCount) {
+        moduleOp.emitError() << "expected one target per device when "
+                                "partitioning by target; have "
+                             << targetAttrs.size() << " targets and "
+                             << deviceCount << " devices";
+        return signalPassFailure();
+      }
+      bool unifiedMemory = moduleOp->hasAttr("hal.device.unified_memory");
+      for (auto funcOp : moduleOp.getOps<FuncOp>()) {
+        placeFuncByCost(funcOp, targetAttrs, unifiedMemory);
+      }
+      return;
+    }
+
+    for (auto funcOp : moduleOp.getOps<FuncOp>()) {
+      partitionFunc(funcOp, deviceCount);
+    }
+  }
+
+ private:
+  // Places each stream in |funcOp| (in program order) on the device with the
+  // lowest estimated cost for executing it, including the cost of waiting on
+  // and copying in results produced on other devices. Values not produced by
+  // streams are owned by the first device.
+  void placeFuncByCost(FuncOp funcOp,
+                       ArrayRef<IREE::HAL::DeviceTargetAttr> targetAttrs,
+                       bool unifiedMemory) {
+    auto moduleOp = funcOp->getParentOfType<ModuleOp>();
+    auto indexType = IndexType::get(funcOp.getContext());
+    funcOp.walk([&](IREE::Flow::ExStreamFragmentOp streamOp) {
+      if (streamOp->hasAttr("hal.device.affinity")) return;
+
+      // Gather the work performed by the stream once for all devices.
+      SmallVector<std::pair<DispatchKind, int64_t>> dispatches;
+      streamOp.walk([&](IREE::Flow::DispatchOp dispatchOp) {
+        auto executableOp = moduleOp.lookupSymbol<IREE::Flow::ExecutableOp>(
+            dispatchOp.executable());
+        auto kind = executableOp ? classifyExecutable(executableOp)
+                                 : DispatchKind::Elementwise;
+        dispatches.push_back(
+            std::make_pair(kind, estimateWorkgroupCount(streamOp, dispatchOp)));
+      });
+
+      int64_t bestOrdinal = 0;
+      int64_t bestCost = INT64_MAX;
+      for (int64_t ordinal = 0; ordinal < targetAttrs.size(); ++ordinal) {
+        auto &costModel = lookupDeviceCostModel(targetAttrs[ordinal]);
+        int64_t cost = 0;
+        for (auto &dispatch : dispatches) {
+          cost += costModel.launchCost +
+                  dispatch.second *
+                      costModel.workgroupCost[static_cast<int>(dispatch.first)];
+        }
+        for (auto operand : streamOp.operands()) {
+          if (!operand.getType().isa<ShapedType>()) continue;
+          int64_t producerOrdinal = 0;
+          auto producerOp = dyn_cast_or_null<IREE::Flow::ExStreamFragmentOp>(
+              operand.getDefiningOp());
+          if (producerOp) {
+            if (auto affinityAttr = producerOp->getAttrOfType<IntegerAttr>(
+                    "hal.device.affinity")) {
+              producerOrdinal = affinityAttr.getInt();
+            }
+          }
+          if (producerOrdinal == ordinal) continue;
+          cost += kCrossDeviceSyncCost;
+          if (!unifiedMemory) {
+            cost += estimateValueSize(operand) / kCrossDeviceBytesPerCost;
+          }
+        }
+        LLVM_DEBUG(llvm::dbgs() << "stream cost on device " << ordinal << ": "
+                                << cost << "\n");
+        if (cost < bestCost) {
+          bestCost = cost;
+          bestOrdinal = ordinal;
+        }
+      }
+      streamOp->setAttr("hal.device.affinity",
+                        IntegerAttr::get(indexType, bestOrdinal));
+    });
+  }
+
+  // Assigns the streams in |funcOp| to devices such that each device executes
+  // a contiguous range of the streams (in program order) with roughly equal
+  // cost. Streams that already have an affinity keep it.
+  void partitionFunc(FuncOp funcOp, int64_t deviceCount) {
+    SmallVector<std::pair<IREE::Flow::ExStreamFragmentOp, int64_t>> streams;
+    int64_t totalCost = 0;
+    funcOp.walk([&](IREE::Flow::ExStreamFragmentOp streamOp) {
+      if (streamOp->hasAttr("hal.device.affinity")) return;
+      int64_t cost = estimateStreamCost(streamOp);
+      streams.push_back(std::make_pair(streamOp, cost));
+      totalCost += cost;
+    });
+    if (streams.size() < 2) return;
+
+    // Each stream is placed on the device owning the midpoint of its cost
+    // range so that a single dominant stream does not shift its neighbors.
+    auto indexType = IndexType::get(funcOp.getContext());
+    int64_t precedingCost = 0;
+    for (auto &stream : streams) {
+      int64_t midpoint = precedingCost + stream.second / 2;
+      int64_t ordinal = std::min<int64_t>(
+          midpoint * deviceCount / totalCost, deviceCount - 1);
+      precedingCost += stream.second;
+      LLVM_DEBUG(llvm::dbgs() << "stream cost " << stream.second
+                              << " -> device " << ordinal << "\n");
+      stream.first->setAttr("hal.device.affinity",
+                            IntegerAttr::get(indexType, ordinal));
+    }
+  }
+};
+
+std::unique_ptr<OperationPass<ModuleOp>> createAssignDeviceAffinitiesPass() {
+  return std::make_unique<AssignDeviceAffinitiesPass>();
+}
+
+static PassRegistration<AssignDeviceAffinitiesPass> pass;
+
+}  // namespace HAL
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
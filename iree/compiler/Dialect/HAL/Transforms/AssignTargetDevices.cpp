@@ -29,8 +29,11 @@ class AssignTargetDevicesPass
  public:
   AssignTargetDevicesPass() = default;
   AssignTargetDevicesPass(const AssignTargetDevicesPass &pass) {}
-  AssignTargetDevicesPass(ArrayRef<std::string> targets) {
-    this->targets = targets;
+  AssignTargetDevicesPass(const TargetOptions &targetOptions) {
+    this->targets = targetOptions.targets;
+    this->deviceCount = targetOptions.deviceCount;
+    this->partitionByTarget = targetOptions.partitionByTarget;
+    this->unifiedMemory = targetOptions.unifiedMemory;
   }
 
   void getDependentDialects(DialectRegistry &registry) const override {
@@ -47,12 +50,34 @@ class AssignTargetDevicesPass
 
   StringRef getDescription() const override {
     return "Assigns the HAL devices the module will target to the given list "
-           "of targets.";
+           "of targets and the number of devices to partition across.";
   }
 
   void runOnOperation() override {
     auto moduleOp = getOperation();
 
+    // Record the number of devices the program is partitioned across so that
+    // device affinities can be assigned. Single device programs carry no
+    // attribute. When partitioning by target each target is its own device.
+    int64_t totalDeviceCount = deviceCount;
+    if (partitionByTarget) {
+      totalDeviceCount = targets.size();
+      auto existingTargetsAttr =
+          moduleOp->getAttrOfType<ArrayAttr>("hal.device.targets");
+      if (existingTargetsAttr) totalDeviceCount = existingTargetsAttr.size();
+      moduleOp->setAttr("hal.device.partition_by_target",
+                        UnitAttr::get(moduleOp.getContext()));
+    }
+    if (totalDeviceCount > 1 && !moduleOp->hasAttr("hal.device.count")) {
+      moduleOp->setAttr("hal.device.count",
+                        IntegerAttr::get(IndexType::get(moduleOp.getContext()),
+                                         totalDeviceCount));
+    }
+    if (unifiedMemory && totalDeviceCount > 1) {
+      moduleOp->setAttr("hal.device.unified_memory",
+                        UnitAttr::get(moduleOp.getContext()));
+    }
+
     // Check to see if targets are already specified.
     auto existingTargetsAttr =
         moduleOp->getAttrOfType<ArrayAttr>("hal.device.targets");
@@ -94,11 +119,23 @@ class AssignTargetDevicesPass
   ListOption<std::string> targets{
       *this, "targets", llvm::cl::desc("List of devices to target."),
       llvm::cl::ZeroOrMore, llvm::cl::CommaSeparated};
+  Option<int64_t> deviceCount{
+      *this, "device-count",
+      llvm::cl::desc("Number of devices to partition the program across."),
+      llvm::cl::init(1)};
+  Option<bool> partitionByTarget{
+      *this, "partition-by-target",
+      llvm::cl::desc("Executes each target on its own device."),
+      llvm::cl::init(false)};
+  Option<bool> unifiedMemory{
+      *this, "unified-memory",
+      llvm::cl::desc("Devices share memory allocated from the first device."),
+      llvm::cl::init(false)};
 };
 
 std::unique_ptr<OperationPass<ModuleOp>> createAssignTargetDevicesPass(
-    ArrayRef<std::string> targets) {
-  return std::make_unique<AssignTargetDevicesPass>(targets);
+    const TargetOptions &targetOptions) {
+  return std::make_unique<AssignTargetDevicesPass>(targetOptions);
 }
 
 static PassRegistration<AssignTargetDevicesPass> pass([] {
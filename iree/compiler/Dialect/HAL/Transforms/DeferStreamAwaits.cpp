@@ -0,0 +1,305 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <utility>
+
+#include "iree/compiler/Dialect/HAL/IR/HALDialect.h"
+#include "iree/compiler/Dialect/HAL/IR/HALOps.h"
+#include "iree/compiler/Dialect/HAL/Transforms/Passes.h"
+#include "iree/compiler/Dialect/Util/IR/UtilDialect.h"
+#include "iree/compiler/Dialect/Util/IR/UtilOps.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/Interfaces/ControlFlowInterfaces.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "mlir/Pass/Pass.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace HAL {
+namespace {
+
+// A submission signaling |semaphore| to |value| that the host has not waited
+// on yet.
+struct PendingSubmission {
+  Value semaphore;
+  Value value;
+};
+
+// Returns true if |op| neither observes the contents of buffers nor otherwise
+// depends on the completion of the submissions in flight such that the host
+// may execute it while they are. Recording and submitting work is safe as the
+// work is ordered on the device.
+static bool isAsyncSafe(Operation *op) {
+  if (isa<IREE::HAL::DeviceSwitchOp>(op)) {
+    auto walkResult = op->walk([&](Operation *nestedOp) {
+      if (nestedOp == op || isa<IREE::HAL::ReturnOp>(nestedOp) ||
+          isAsyncSafe(nestedOp)) {
+        return WalkResult::advance();
+      }
+      return WalkResult::interrupt();
+    });
+    return !walkResult.wasInterrupted();
+  }
+  if (op->getNumRegions() != 0) return false;
+  if (MemoryEffectOpInterface::hasNoEffect(op)) return true;
+  if (isa<IREE::HAL::AllocatorAllocateOp, IREE::HAL::SemaphoreCreateOp,
+          IREE::Util::GlobalLoadOp>(op)) {
+    return true;
+  }
+  return op->getName().getStringRef().startswith("hal.command_buffer.");
+}
+
+// Returns the submission signaling |semaphore|, if any.
+static IREE::HAL::DeviceQueueSubmitOp findSubmission(Value semaphore) {
+  for (auto *user : semaphore.getUsers()) {
+    auto submitOp = dyn_cast<IREE::HAL::DeviceQueueSubmitOp>(user);
+    if (submitOp && submitOp.signal_semaphore() == semaphore) return submitOp;
+  }
+  return {};
+}
+
+// Returns true if |submitOp| waits (possibly transitively) on the submission
+// signaling |semaphore| before it executes.
+static bool isOrderedAfter(IREE::HAL::DeviceQueueSubmitOp submitOp,
+                           Value semaphore) {
+  for (auto waitSemaphore : submitOp.wait_semaphores()) {
+    if (waitSemaphore == semaphore) return true;
+    auto waitSubmitOp = findSubmission(waitSemaphore);
+    if (waitSubmitOp && isOrderedAfter(waitSubmitOp, semaphore)) return true;
+  }
+  return false;
+}
+
+// Removes the host waits on the shared device directly preceding the branch
+// terminating |block| and returns the submission they waited on. The waits
+// are only removed if waiting on the last submission implies the others have
+// completed as well.
+static Optional<PendingSubmission> takeTrailingAwaits(Block &block) {
+  auto *terminatorOp = block.getTerminator();
+  if (!isa<BranchOpInterface>(terminatorOp)) return llvm::None;
+  SmallVector<std::pair<IREE::HAL::SemaphoreAwaitOp,
+                        IREE::Util::StatusCheckOkOp>>
+      awaits;
+  for (auto *op = terminatorOp->getPrevNode(); op && op->getPrevNode();
+       op = op->getPrevNode()->getPrevNode()) {
+    auto checkOp = dyn_cast<IREE::Util::StatusCheckOkOp>(op);
+    auto awaitOp = dyn_cast<IREE::HAL::SemaphoreAwaitOp>(op->getPrevNode());
+    if (!checkOp || !awaitOp || checkOp.status() != awaitOp.status()) break;
+    awaits.push_back(std::make_pair(awaitOp, checkOp));
+  }
+  if (awaits.empty()) return llvm::None;
+
+  auto lastAwaitOp = awaits.front().first;
+  auto submitOp = findSubmission(lastAwaitOp.semaphore());
+  if (!submitOp ||
+      IREE::HAL::ExDeviceOp::getDeviceOrdinal(submitOp.device()) != 0) {
+    return llvm::None;
+  }
+  for (auto &await : llvm::drop_begin(awaits, 1)) {
+    if (!isOrderedAfter(submitOp, await.first.semaphore())) return llvm::None;
+  }
+
+  PendingSubmission pending = {lastAwaitOp.semaphore(),
+                               lastAwaitOp.min_value()};
+  for (auto &await : awaits) {
+    await.second.erase();
+    await.first.erase();
+  }
+  return pending;
+}
+
+// Keeps submissions in flight across branches by passing them to the
+// successor blocks instead of waiting for them before the branch. Each block
+// receiving a submission waits on it either on the device as part of its
+// first submission or on the host before the first op that requires it.
+//
+// Loops whose bodies each submit a stream (such as decoder loops) then record
+// and submit iteration N+1 while iteration N is still executing instead of
+// paying a full host round trip per iteration.
+class DeferStreamAwaitsPass
+    : public PassWrapper<DeferStreamAwaitsPass, OperationPass<FuncOp>> {
+ public:
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<HALDialect, IREE::Util::UtilDialect>();
+  }
+
+  StringRef getArgument() const override {
+    return "iree-hal-defer-stream-awaits";
+  }
+
+  StringRef getDescription() const override {
+    return "Keeps stream submissions in flight across branches.";
+  }
+
+  void runOnOperation() override {
+    auto funcOp = getOperation();
+    successorArgs.clear();
+    signaledSubmission = {};
+    SmallVector<std::pair<Block *, PendingSubmission>> worklist;
+    for (auto &block : funcOp.getBlocks()) {
+      if (auto pending = takeTrailingAwaits(block)) {
+        worklist.push_back(std::make_pair(&block, *pending));
+      }
+    }
+    while (!worklist.empty()) {
+      auto item = worklist.pop_back_val();
+      deferToSuccessors(item.first, item.second, worklist);
+    }
+  }
+
+ private:
+  // Passes |pending| from |block| to each of its successors. Waits on the host
+  // instead if a successor cannot receive it.
+  void deferToSuccessors(
+      Block *block, PendingSubmission pending,
+      SmallVectorImpl<std::pair<Block *, PendingSubmission>> &worklist) {
+    auto branchOp = cast<BranchOpInterface>(block->getTerminator());
+    for (auto *successor : block->getSuccessors()) {
+      if (!successorArgs.count(successor) && !canAddSuccessorArgs(successor)) {
+        awaitOnHost(branchOp, pending);
+        return;
+      }
+    }
+    for (unsigned i = 0; i < block->getNumSuccessors(); ++i) {
+      auto *successor = block->getSuccessor(i);
+      if (!successorArgs.count(successor)) {
+        addSuccessorArgs(successor, worklist);
+      }
+      OperandRange operands = *branchOp.getMutableSuccessorOperands(i);
+      unsigned baseIndex = operands.getBeginOperandIndex() + operands.size();
+      branchOp->setOperand(baseIndex - 2, pending.semaphore);
+      branchOp->setOperand(baseIndex - 1, pending.value);
+    }
+  }
+
+  // Returns true if all predecessors of |block| can pass it a submission.
+  bool canAddSuccessorArgs(Block *block) {
+    if (block->isEntryBlock()) return false;
+    for (auto *predecessor : block->getPredecessors()) {
+      auto branchOp =
+          dyn_cast<BranchOpInterface>(predecessor->getTerminator());
+      if (!branchOp) return false;
+      for (unsigned i = 0; i < predecessor->getNumSuccessors(); ++i) {
+        if (predecessor->getSuccessor(i) == block &&
+            !branchOp.getMutableSuccessorOperands(i)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  // Adds arguments to |block| for receiving the submission in flight from its
+  // predecessors and waits on it. Predecessors without a submission in flight
+  // pass an already signaled semaphore.
+  void addSuccessorArgs(
+      Block *block,
+      SmallVectorImpl<std::pair<Block *, PendingSubmission>> &worklist) {
+    PendingSubmission pending = {
+        block->addArgument(
+            IREE::HAL::SemaphoreType::get(block->getParent()->getContext())),
+        block->addArgument(IndexType::get(block->getParent()->getContext())),
+    };
+    successorArgs[block] = pending;
+
+    auto signaled = getSignaledSubmission();
+    SmallPtrSet<Block *, 4> predecessors(block->pred_begin(),
+                                         block->pred_end());
+    for (auto *predecessor : predecessors) {
+      auto branchOp = cast<BranchOpInterface>(predecessor->getTerminator());
+      for (unsigned i = 0; i < predecessor->getNumSuccessors(); ++i) {
+        if (predecessor->getSuccessor(i) != block) continue;
+        branchOp.getMutableSuccessorOperands(i)->append(
+            ValueRange{signaled.semaphore, signaled.value});
+      }
+    }
+
+    for (auto &op : *block) {
+      if (auto submitOp = dyn_cast<IREE::HAL::DeviceQueueSubmitOp>(op)) {
+        if (IREE::HAL::ExDeviceOp::getDeviceOrdinal(submitOp.device()) == 0) {
+          addSubmissionWait(submitOp, pending);
+        } else {
+          awaitOnHost(&op, pending);
+        }
+        return;
+      }
+      if (op.hasTrait<OpTrait::IsTerminator>()) {
+        if (isa<BranchOpInterface>(op)) {
+          worklist.push_back(std::make_pair(block, pending));
+        } else {
+          awaitOnHost(&op, pending);
+        }
+        return;
+      }
+      if (!isAsyncSafe(&op)) {
+        awaitOnHost(&op, pending);
+        return;
+      }
+    }
+  }
+
+  // Returns a semaphore created signaled at the start of the function.
+  PendingSubmission getSignaledSubmission() {
+    if (signaledSubmission.semaphore) return signaledSubmission;
+    auto funcOp = getOperation();
+    auto builder = OpBuilder::atBlockBegin(&funcOp.front());
+    auto device = builder.create<IREE::HAL::ExSharedDeviceOp>(funcOp.getLoc());
+    auto value = builder.create<ConstantIndexOp>(funcOp.getLoc(), 0);
+    auto semaphore = builder.create<IREE::HAL::SemaphoreCreateOp>(
+        funcOp.getLoc(), IREE::HAL::SemaphoreType::get(builder.getContext()),
+        device, value);
+    signaledSubmission = {semaphore.result(), value.getResult()};
+    return signaledSubmission;
+  }
+
+  // Adds a wait on |pending| to |submitOp|.
+  void addSubmissionWait(IREE::HAL::DeviceQueueSubmitOp submitOp,
+                         PendingSubmission pending) {
+    SmallVector<Value> waitSemaphores =
+        llvm::to_vector<4>(submitOp.wait_semaphores());
+    SmallVector<Value> waitValues = llvm::to_vector<4>(submitOp.wait_values());
+    waitSemaphores.push_back(pending.semaphore);
+    waitValues.push_back(pending.value);
+    OpBuilder builder(submitOp);
+    builder.create<IREE::HAL::DeviceQueueSubmitOp>(
+        submitOp.getLoc(), submitOp.device(), submitOp.command_buffer(),
+        waitSemaphores, waitValues, submitOp.signal_semaphore(),
+        submitOp.signal_value());
+    submitOp.erase();
+  }
+
+  // Waits on |pending| on the host before |op|.
+  void awaitOnHost(Operation *op, PendingSubmission pending) {
+    OpBuilder builder(op);
+    auto awaitOp = builder.create<IREE::HAL::SemaphoreAwaitOp>(
+        op->getLoc(), builder.getIntegerType(32), pending.semaphore,
+        pending.value);
+    builder.create<IREE::Util::StatusCheckOkOp>(
+        op->getLoc(), awaitOp.status(), "stream execution failed");
+  }
+
+  // Blocks that have been given arguments receiving the submission in flight.
+  DenseMap<Block *, PendingSubmission> successorArgs;
+  // A semaphore signaled at the start of the function, if created.
+  PendingSubmission signaledSubmission;
+};
+
+}  // namespace
+
+std::unique_ptr<OperationPass<FuncOp>> createDeferStreamAwaitsPass() {
+  return std::make_unique<DeferStreamAwaitsPass>();
+}
+
+static PassRegistration<DeferStreamAwaitsPass> pass;
+
+}  // namespace HAL
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
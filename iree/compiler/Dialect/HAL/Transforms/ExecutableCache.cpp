@@ -0,0 +1,138 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/HAL/Transforms/ExecutableCache.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/OperationSupport.h"
+#include "mlir/Parser.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace HAL {
+
+static llvm::cl::opt<std::string> clExecutableCacheDir(
+    "iree-hal-executable-cache-dir",
+    llvm::cl::desc("Directory used to cache translated and serialized "
+                   "executables across compilations; entries are not "
+                   "invalidated when the compiler itself changes"),
+    llvm::cl::init(""));
+
+// Entries are printed in the generic form as it round-trips for any dialect
+// the target backends may produce.
+static OpPrintingFlags getCachePrintingFlags() {
+  OpPrintingFlags flags;
+  flags.printGenericOpForm();
+  return flags;
+}
+
+static std::string getEntryPath(StringRef key) {
+  llvm::SmallString<128> path(clExecutableCacheDir);
+  llvm::sys::path::append(path, key + ".mlir");
+  return path.str().str();
+}
+
+std::string getExecutableCacheKey(StringRef stage,
+                                  TargetBackend &targetBackend,
+                                  IREE::HAL::ExecutableVariantOp variantOp) {
+  if (clExecutableCacheDir.empty()) return "";
+  std::string backendKey = targetBackend.getExecutableCacheKey();
+  if (backendKey.empty()) return "";
+
+  // Locations are not printed so that the key only depends on the semantics
+  // of the executable and not where it came from.
+  std::string ir;
+  llvm::raw_string_ostream os(ir);
+  auto executableOp = variantOp->getParentOfType<IREE::HAL::ExecutableOp>();
+  for (auto interfaceOp :
+       executableOp.getBlock().getOps<IREE::HAL::InterfaceOp>()) {
+    interfaceOp->print(os, getCachePrintingFlags());
+  }
+  variantOp->print(os, getCachePrintingFlags());
+  os.flush();
+
+  llvm::SHA1 hasher;
+  hasher.update(stage);
+  hasher.update(backendKey);
+  hasher.update(ir);
+  return (stage + "-" + llvm::toHex(hasher.final(), /*LowerCase=*/true)).str();
+}
+
+LogicalResult lookupExecutableCache(StringRef key, MLIRContext *context,
+                                    Block &block) {
+  auto fileOr = llvm::MemoryBuffer::getFile(getEntryPath(key));
+  if (!fileOr) return failure();
+  Block parsedBlock;
+  if (failed(parseSourceString((*fileOr)->getBuffer(), &parsedBlock,
+                               context))) {
+    return failure();
+  }
+  if (!llvm::hasSingleElement(parsedBlock)) return failure();
+  auto executableOp = dyn_cast<IREE::HAL::ExecutableOp>(parsedBlock.front());
+  if (!executableOp) return failure();
+  for (auto &op : llvm::make_early_inc_range(
+           executableOp.getBlock().without_terminator())) {
+    if (isa<IREE::HAL::InterfaceOp>(op)) continue;
+    op.moveBefore(&block, block.end());
+  }
+  return success();
+}
+
+void storeExecutableCache(StringRef key, IREE::HAL::ExecutableOp executableOp,
+                          ArrayRef<Operation *> ops) {
+  // Wrap the ops in an executable holding the interfaces they reference so
+  // that the entry verifies when parsed back.
+  OpBuilder builder(executableOp.getContext());
+  auto cacheOp = builder.create<IREE::HAL::ExecutableOp>(
+      executableOp.getLoc(), executableOp.sym_name());
+  builder.setInsertionPoint(cacheOp.getBlock().getTerminator());
+  for (auto interfaceOp :
+       executableOp.getBlock().getOps<IREE::HAL::InterfaceOp>()) {
+    builder.clone(*interfaceOp.getOperation());
+  }
+  for (auto *op : ops) builder.clone(*op);
+  std::string ir;
+  llvm::raw_string_ostream os(ir);
+  cacheOp->print(os, getCachePrintingFlags());
+  os.flush();
+  cacheOp->erase();
+
+  // Entries are written to a temporary file and renamed into place so that
+  // concurrent compilations never observe partially written entries.
+  if (llvm::sys::fs::create_directories(clExecutableCacheDir)) return;
+  std::string entryPath = getEntryPath(key);
+  int fd;
+  llvm::SmallString<128> tempPath;
+  if (llvm::sys::fs::createUniqueFile(entryPath + ".%%%%%%.tmp", fd,
+                                      tempPath)) {
+    return;
+  }
+  bool hasError = false;
+  {
+    llvm::raw_fd_ostream fileOS(fd, /*shouldClose=*/true);
+    fileOS << ir;
+    fileOS.close();
+    hasError = fileOS.has_error();
+    fileOS.clear_error();
+  }
+  if (hasError || llvm::sys::fs::rename(tempPath, entryPath)) {
+    llvm::sys::fs::remove(tempPath);
+  }
+}
+
+}  // namespace HAL
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -0,0 +1,52 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_COMPILER_DIALECT_HAL_TRANSFORMS_EXECUTABLECACHE_H_
+#define IREE_COMPILER_DIALECT_HAL_TRANSFORMS_EXECUTABLECACHE_H_
+
+#include <string>
+
+#include "iree/compiler/Dialect/HAL/IR/HALOps.h"
+#include "iree/compiler/Dialect/HAL/Target/TargetBackend.h"
+#include "llvm/ADT/StringRef.h"
+#include "mlir/IR/Block.h"
+#include "mlir/Support/LogicalResult.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace HAL {
+
+// On-disk content-addressed cache of executable translation and serialization
+// results enabled with -iree-hal-executable-cache-dir. Entries are keyed on
+// the IR of a hal.executable.variant, the hal.interfaces of its executable and
+// the configuration of its target backend so that rebuilding a model whose
+// dispatches did not change (such as with different weights) skips codegen.
+
+// Returns a key identifying the result of running |stage| on |variantOp| with
+// |targetBackend| or an empty string if caching is disabled or unsupported by
+// the backend.
+std::string getExecutableCacheKey(StringRef stage,
+                                  TargetBackend &targetBackend,
+                                  IREE::HAL::ExecutableVariantOp variantOp);
+
+// Parses the ops stored under |key| into |block|. Fails if there is no valid
+// entry for |key|. The ops are wrapped in a hal.executable along with the
+// hal.interfaces they reference.
+LogicalResult lookupExecutableCache(StringRef key, MLIRContext *context,
+                                    Block &block);
+
+// Stores |ops| from |executableOp| under |key|. Failures to write the entry
+// are ignored as the cache is only an optimization.
+void storeExecutableCache(StringRef key, IREE::HAL::ExecutableOp executableOp,
+                          ArrayRef<Operation *> ops);
+
+}  // namespace HAL
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
+
+#endif  // IREE_COMPILER_DIALECT_HAL_TRANSFORMS_EXECUTABLECACHE_H_
@@ -0,0 +1,200 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <algorithm>
+#include <string>
+
+#include "iree/compiler/Dialect/HAL/IR/HALDialect.h"
+#include "iree/compiler/Dialect/HAL/IR/HALOps.h"
+#include "iree/compiler/Dialect/HAL/Transforms/Passes.h"
+#include "iree/compiler/Dialect/HAL/Utils/TypeUtils.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/IR/Attributes.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Diagnostics.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Pass/Pass.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace HAL {
+
+// Minimum alignment of buffer storage in the runtime static arena allocator;
+// matches the natural alignment of host allocations.
+static constexpr int64_t kMinPlanAlignment = 16;
+
+class ExportStaticMemoryPlanPass
+    : public PassWrapper<ExportStaticMemoryPlanPass, OperationPass<ModuleOp>> {
+ public:
+  // Bytes of device memory allocated by a function in each plan region.
+  struct RegionSizes {
+    int64_t constant = 0;
+    int64_t transient = 0;
+    int64_t io = 0;
+  };
+
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<IREE::HAL::HALDialect>();
+  }
+
+  StringRef getArgument() const override {
+    return "iree-hal-export-static-memory-plan";
+  }
+
+  StringRef getDescription() const override {
+    return "Computes a static memory plan of all allocations in the program "
+           "and exports it as reflection metadata.";
+  }
+
+  void runOnOperation() override {
+    auto moduleOp = getOperation();
+    auto bufferConstraints =
+        IREE::HAL::DeviceTargetAttr::lookupConservativeBufferConstraints(
+            moduleOp);
+    alignment = std::max<int64_t>(
+        kMinPlanAlignment,
+        bufferConstraints.min_buffer_offset_alignment().getSExtValue());
+
+    // Sum the allocations made directly within each function.
+    bool anyFailed = false;
+    for (auto funcOp : moduleOp.getOps<FuncOp>()) {
+      auto sizes = computeLocalSizes(funcOp);
+      if (failed(sizes)) {
+        anyFailed = true;
+        continue;
+      }
+      localSizes[funcOp] = *sizes;
+    }
+    if (anyFailed) return signalPassFailure();
+
+    // Constants are allocated once when the module is initialized and live for
+    // the lifetime of the module. Transients and outputs are only live during
+    // (or after) a single invocation so the plan reserves enough for the
+    // heaviest entry point, including everything it calls.
+    RegionSizes planSizes;
+    SymbolTable symbolTable(moduleOp);
+    SmallVector<FuncOp> entryFuncOps;
+    for (auto funcOp : moduleOp.getOps<FuncOp>()) {
+      planSizes.constant += localSizes[funcOp].constant;
+      if (!funcOp.isPublic()) continue;
+      entryFuncOps.push_back(funcOp);
+      llvm::DenseSet<Operation *> activeFuncs;
+      auto reachableSizes =
+          computeReachableSizes(funcOp, symbolTable, activeFuncs);
+      if (failed(reachableSizes)) return signalPassFailure();
+      planSizes.transient =
+          std::max(planSizes.transient, reachableSizes->transient);
+      planSizes.io = std::max(planSizes.io, reachableSizes->io);
+    }
+
+    std::string planString;
+    llvm::raw_string_ostream os(planString);
+    os << "constant=" << planSizes.constant
+       << ",transient=" << planSizes.transient << ",io=" << planSizes.io
+       << ",alignment=" << alignment;
+    os.flush();
+
+    // Attach the plan to every exported function such that it is available
+    // through function reflection regardless of which entry point is used.
+    auto planAttr = StringAttr::get(&getContext(), planString);
+    for (auto funcOp : entryFuncOps) {
+      SmallVector<NamedAttribute> attrs;
+      if (auto reflectionAttr =
+              funcOp->getAttrOfType<DictionaryAttr>("iree.reflection")) {
+        llvm::append_range(attrs, reflectionAttr.getValue());
+      }
+      attrs.push_back(std::make_pair(
+          Identifier::get("iree.memory_plan", &getContext()), planAttr));
+      funcOp->setAttr("iree.reflection",
+                      DictionaryAttr::get(&getContext(), attrs));
+    }
+  }
+
+ private:
+  // Returns the sizes of all allocations made directly within |funcOp| or
+  // failure if any are not known at compile time.
+  FailureOr<RegionSizes> computeLocalSizes(FuncOp funcOp) {
+    RegionSizes sizes;
+    auto walkResult = funcOp.walk([&](Operation *op) -> WalkResult {
+      if (auto allocateOp = dyn_cast<IREE::HAL::AllocatorAllocateOp>(op)) {
+        APInt resultSize;
+        if (!matchPattern(allocateOp.result_size(),
+                          m_ConstantInt(&resultSize))) {
+          return allocateOp.emitOpError()
+                 << "has a dynamic size; static memory plans require all "
+                    "allocation sizes to be known at compile time";
+        }
+        int64_t alignedSize = align(resultSize.getZExtValue(), alignment);
+        if (allEnumBitsSet(allocateOp.buffer_usage(),
+                           IREE::HAL::BufferUsageBitfield::Constant)) {
+          sizes.constant += alignedSize;
+        } else if (allEnumBitsSet(allocateOp.memory_types(),
+                                  IREE::HAL::MemoryTypeBitfield::Transient)) {
+          sizes.transient += alignedSize;
+        } else {
+          sizes.io += alignedSize;
+        }
+      } else if (auto constantOp =
+                     dyn_cast<IREE::HAL::AllocatorConstantOp>(op)) {
+        auto valueType = constantOp.value().getType();
+        int64_t byteLength =
+            valueType.getNumElements() *
+            IREE::HAL::getRoundedElementByteWidth(valueType.getElementType());
+        sizes.constant += align(byteLength, alignment);
+      }
+      // NOTE: hal.allocator.map wraps immutable module storage in-place and
+      // does not take any space in the plan.
+      return WalkResult::advance();
+    });
+    if (walkResult.wasInterrupted()) return failure();
+    return sizes;
+  }
+
+  // Returns the transient and output sizes of |funcOp| and all functions it
+  // calls. Calls are assumed to be live at the same time as their caller.
+  FailureOr<RegionSizes> computeReachableSizes(
+      FuncOp funcOp, SymbolTable &symbolTable,
+      llvm::DenseSet<Operation *> &activeFuncs) {
+    if (!activeFuncs.insert(funcOp).second) {
+      funcOp.emitOpError() << "is recursive; static memory plans require a "
+                              "bounded call depth";
+      return failure();
+    }
+    RegionSizes sizes = localSizes[funcOp];
+    auto walkResult = funcOp.walk([&](mlir::CallOp callOp) -> WalkResult {
+      auto calleeOp = symbolTable.lookup<FuncOp>(callOp.callee());
+      if (!calleeOp || calleeOp.isExternal()) return WalkResult::advance();
+      auto calleeSizes =
+          computeReachableSizes(calleeOp, symbolTable, activeFuncs);
+      if (failed(calleeSizes)) return WalkResult::interrupt();
+      sizes.transient += calleeSizes->transient;
+      sizes.io += calleeSizes->io;
+      return WalkResult::advance();
+    });
+    activeFuncs.erase(funcOp);
+    if (walkResult.wasInterrupted()) return failure();
+    return sizes;
+  }
+
+  int64_t alignment = kMinPlanAlignment;
+  llvm::DenseMap<Operation *, RegionSizes> localSizes;
+};
+
+std::unique_ptr<OperationPass<ModuleOp>> createExportStaticMemoryPlanPass() {
+  return std::make_unique<ExportStaticMemoryPlanPass>();
+}
+
+static PassRegistration<ExportStaticMemoryPlanPass> pass;
+
+}  // namespace HAL
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
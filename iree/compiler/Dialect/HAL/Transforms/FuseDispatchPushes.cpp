@@ -0,0 +1,134 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/HAL/IR/HALDialect.h"
+#include "iree/compiler/Dialect/HAL/IR/HALOps.h"
+#include "iree/compiler/Dialect/HAL/Transforms/Passes.h"
+#include "llvm/ADT/STLExtras.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "mlir/Pass/Pass.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace HAL {
+namespace {
+
+// Returns true if |op| may observe or modify command buffer state such that
+// pushes may not be deferred across it.
+static bool isPushBarrier(Operation *op) {
+  if (op->getNumRegions() != 0) return true;
+  auto effectInterface = dyn_cast<MemoryEffectOpInterface>(op);
+  if (!effectInterface) return true;
+  // Reads (such as global loads) cannot observe command buffer state.
+  SmallVector<MemoryEffects::EffectInstance> effects;
+  effectInterface.getEffects(effects);
+  return llvm::any_of(effects, [](MemoryEffects::EffectInstance &effect) {
+    return !isa<MemoryEffects::Read>(effect.getEffect());
+  });
+}
+
+// Fuses the push_constants and push_descriptor_set recorded immediately prior
+// to a dispatch into a single hal.command_buffer.dispatch.push.
+class FuseDispatchPushesPass
+    : public PassWrapper<FuseDispatchPushesPass, OperationPass<FuncOp>> {
+ public:
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<HALDialect>();
+  }
+
+  StringRef getArgument() const override {
+    return "iree-hal-fuse-dispatch-pushes";
+  }
+
+  StringRef getDescription() const override {
+    return "Fuses push constants and descriptor set pushes into the dispatches "
+           "that follow them.";
+  }
+
+  void runOnOperation() override {
+    SmallVector<IREE::HAL::CommandBufferDispatchOp> dispatchOps;
+    getOperation().walk([&](IREE::HAL::CommandBufferDispatchOp dispatchOp) {
+      dispatchOps.push_back(dispatchOp);
+    });
+    for (auto dispatchOp : dispatchOps) {
+      fuseDispatch(dispatchOp);
+    }
+  }
+
+ private:
+  void fuseDispatch(IREE::HAL::CommandBufferDispatchOp dispatchOp) {
+    // Scan backward for the pushes on the same command buffer. Only the most
+    // recent push of each kind is fused and anything that may touch the
+    // command buffer in between ends the scan.
+    IREE::HAL::CommandBufferPushConstantsOp pushConstantsOp;
+    IREE::HAL::CommandBufferPushDescriptorSetOp pushDescriptorSetOp;
+    for (Operation *op = dispatchOp->getPrevNode(); op;
+         op = op->getPrevNode()) {
+      if (auto constantsOp =
+              dyn_cast<IREE::HAL::CommandBufferPushConstantsOp>(op)) {
+        if (pushConstantsOp ||
+            constantsOp.command_buffer() != dispatchOp.command_buffer()) {
+          break;
+        }
+        pushConstantsOp = constantsOp;
+      } else if (auto descriptorSetOp =
+                     dyn_cast<IREE::HAL::CommandBufferPushDescriptorSetOp>(
+                         op)) {
+        if (pushDescriptorSetOp ||
+            descriptorSetOp.command_buffer() != dispatchOp.command_buffer()) {
+          break;
+        }
+        pushDescriptorSetOp = descriptorSetOp;
+      } else if (isPushBarrier(op)) {
+        break;
+      }
+    }
+    if (!pushDescriptorSetOp) return;
+    if (pushConstantsOp && pushConstantsOp.executable_layout() !=
+                               pushDescriptorSetOp.executable_layout()) {
+      return;
+    }
+
+    // All operands of the pushes dominate the dispatch as the pushes precede
+    // it in the same block.
+    OpBuilder builder(dispatchOp);
+    auto constantOffset = builder.getIndexAttr(0);
+    ValueRange constants;
+    if (pushConstantsOp) {
+      constantOffset = pushConstantsOp.offsetAttr();
+      constants = pushConstantsOp.values();
+    }
+    builder.create<IREE::HAL::CommandBufferDispatchPushOp>(
+        builder.getFusedLoc({pushDescriptorSetOp.getLoc(),
+                             dispatchOp.getLoc()}),
+        dispatchOp.command_buffer(), pushDescriptorSetOp.executable_layout(),
+        dispatchOp.executable(), dispatchOp.entry_pointAttr(),
+        dispatchOp.workgroup_x(), dispatchOp.workgroup_y(),
+        dispatchOp.workgroup_z(), constantOffset, constants,
+        pushDescriptorSetOp.set(), pushDescriptorSetOp.binding_ordinals(),
+        pushDescriptorSetOp.binding_buffers(),
+        pushDescriptorSetOp.binding_offsets(),
+        pushDescriptorSetOp.binding_lengths());
+    dispatchOp.erase();
+    pushDescriptorSetOp.erase();
+    if (pushConstantsOp) pushConstantsOp.erase();
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<OperationPass<FuncOp>> createFuseDispatchPushesPass() {
+  return std::make_unique<FuseDispatchPushesPass>();
+}
+
+static PassRegistration<FuseDispatchPushesPass> pass;
+
+}  // namespace HAL
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
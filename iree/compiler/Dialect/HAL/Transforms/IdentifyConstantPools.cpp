@@ -150,16 +150,24 @@ class IdentifyConstantPoolsPass
     DenseMap<StringRef, IREE::HAL::ConstantPoolValueOp> constantReplacements;
     SmallVector<Operation *, 4> deadOps;
     auto poolBuilder = OpBuilder::atBlockBegin(poolOp.getBody());
+    // Attributes are uniqued and globals with identical initial values (such as
+    // the same weights referenced from multiple functions) share a single
+    // value in the pool.
+    DenseMap<Attribute, IREE::HAL::ConstantPoolValueOp> uniqueValueOps;
     for (auto globalOp : globalOps) {
       // Grab the constant value from the global that we'll be pooling.
       auto value =
           globalOp.initial_value().getValue().dyn_cast_or_null<ElementsAttr>();
       assert(value && "value precondition not met: must be elements attr");
 
-      // Create the constant in the pool.
-      auto valueOp = poolBuilder.create<ConstantPoolValueOp>(
-          globalOp.getLoc(), globalOp.getName(), value);
-      valueOp.setNested();
+      // Create the constant in the pool if it does not already exist.
+      auto &uniqueValueOp = uniqueValueOps[value];
+      if (!uniqueValueOp) {
+        uniqueValueOp = poolBuilder.create<ConstantPoolValueOp>(
+            globalOp.getLoc(), globalOp.getName(), value);
+        uniqueValueOp.setNested();
+      }
+      auto valueOp = uniqueValueOp;
 
       // If the global is an immutable constant and used in compatible
       // ways we can turn them into constant loads instead. These will avoid
@@ -156,11 +156,82 @@ class MaterializeConstantPoolBuffersPass
     auto bufferValue = funcBuilder.createOrFold<IREE::HAL::AllocatorMapOp>(
         storageOp.getLoc(), IREE::HAL::BufferType::get(context), allocatorValue,
         memoryType, bufferUsage, sourceValue, offsetValue, lengthValue);
+    if (storageOp.fills().hasValue()) {
+      bufferValue = decompressStorageBuffer(
+          storageOp, bufferConstraints, deviceValue, allocatorValue,
+          bufferValue, memoryType, bufferUsage, funcBuilder);
+    }
     funcBuilder.create<mlir::ReturnOp>(storageOp.getLoc(), bufferValue);
 
     return initializerFunc;
   }
 
+  // Allocates a buffer for the uncompressed contents of |storageOp| and
+  // populates it by copying the ranges stored in the mapped |storageBuffer|
+  // and filling the elided ranges with their patterns. Returns the new buffer.
+  Value decompressStorageBuffer(ConstantStorageOp storageOp,
+                                BufferConstraintsAttr bufferConstraints,
+                                Value deviceValue, Value allocatorValue,
+                                Value storageBuffer,
+                                IREE::HAL::MemoryTypeBitfield memoryType,
+                                IREE::HAL::BufferUsageBitfield bufferUsage,
+                                OpBuilder &funcBuilder) {
+    auto *context = storageOp.getContext();
+    auto loc = storageOp.getLoc();
+    auto fills = llvm::to_vector<16>(
+        storageOp.fills().getValue().getValues<int64_t>());
+    uint64_t storageLength = storageOp.value().getNumElements();
+    uint64_t uncompressedLength = storageLength;
+    for (unsigned i = 0; i < fills.size(); i += 3) {
+      uncompressedLength += fills[i + 1];
+    }
+    auto allocationSizeValue = funcBuilder.createOrFold<mlir::ConstantIndexOp>(
+        loc, align(uncompressedLength,
+                   bufferConstraints.min_buffer_range_alignment()));
+    auto bufferValue = funcBuilder.createOrFold<IREE::HAL::AllocatorAllocateOp>(
+        loc, IREE::HAL::BufferType::get(context), allocatorValue, memoryType,
+        bufferUsage, allocationSizeValue);
+
+    auto commandBufferValue =
+        funcBuilder.createOrFold<IREE::HAL::CommandBufferCreateOp>(
+            loc, IREE::HAL::CommandBufferType::get(context), deviceValue,
+            IREE::HAL::CommandBufferModeBitfield::OneShot |
+                IREE::HAL::CommandBufferModeBitfield::AllowInlineExecution,
+            IREE::HAL::CommandCategoryBitfield::Transfer);
+    funcBuilder.create<IREE::HAL::CommandBufferBeginOp>(loc,
+                                                        commandBufferValue);
+    auto indexValue = [&](uint64_t value) {
+      return funcBuilder.createOrFold<mlir::ConstantIndexOp>(loc, value);
+    };
+    uint64_t storageOffset = 0;
+    uint64_t targetOffset = 0;
+    auto copyStoredRange = [&](uint64_t length) {
+      if (length == 0) return;
+      funcBuilder.create<IREE::HAL::CommandBufferCopyBufferOp>(
+          loc, commandBufferValue, storageBuffer, indexValue(storageOffset),
+          bufferValue, indexValue(targetOffset), indexValue(length));
+      storageOffset += length;
+      targetOffset += length;
+    };
+    for (unsigned i = 0; i < fills.size(); i += 3) {
+      uint64_t fillOffset = fills[i + 0];
+      uint64_t fillLength = fills[i + 1];
+      uint32_t fillPattern = static_cast<uint32_t>(fills[i + 2]);
+      copyStoredRange(fillOffset - targetOffset);
+      auto patternValue = funcBuilder.createOrFold<mlir::ConstantIntOp>(
+          loc, static_cast<int64_t>(fillPattern), 32);
+      funcBuilder.create<IREE::HAL::CommandBufferFillBufferOp>(
+          loc, commandBufferValue, bufferValue, indexValue(fillOffset),
+          indexValue(fillLength), patternValue);
+      targetOffset += fillLength;
+    }
+    copyStoredRange(storageLength - storageOffset);
+    funcBuilder.create<IREE::HAL::CommandBufferEndOp>(loc, commandBufferValue);
+    funcBuilder.create<IREE::HAL::ExSubmitAndWaitOp>(loc, deviceValue,
+                                                     commandBufferValue);
+    return bufferValue;
+  }
+
   // Creates a runtime buffer for the given constant pool splats and constructs
   // its initializer to fill the contents.
   void makeSplatRuntimeGlobal(ConstantPoolOp poolOp,
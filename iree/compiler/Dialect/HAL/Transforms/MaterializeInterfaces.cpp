@@ -10,6 +10,7 @@
 #include "iree/compiler/Dialect/Flow/IR/FlowOps.h"
 #include "iree/compiler/Dialect/HAL/IR/HALDialect.h"
 #include "iree/compiler/Dialect/HAL/IR/HALOps.h"
+#include "iree/compiler/Dialect/HAL/IR/LoweringConfig.h"
 #include "iree/compiler/Dialect/HAL/Target/TargetBackend.h"
 #include "iree/compiler/Dialect/HAL/Target/TargetRegistry.h"
 #include "iree/compiler/Dialect/HAL/Transforms/Passes.h"
@@ -62,10 +63,12 @@ static LogicalResult declareVariantOps(IREE::Flow::ExecutableOp sourceOp,
     auto moduleOp = containerBuilder.create<ModuleOp>(sourceOp.getLoc());
 
     // TODO(benvanik): something more structured here; for now we just copy over
-    // any dialect attrs from the configuration to the inner module.
+    // any dialect attrs from the configuration to the inner module. Other
+    // configuration items remain available on the variant target.
     auto configAttr = targetAttr.getConfiguration();
     if (configAttr) {
       for (auto item : configAttr) {
+        if (!item.first.strref().contains('.')) continue;
         moduleOp->setAttr(item.first, item.second);
       }
     }
@@ -1072,12 +1075,22 @@ static LogicalResult declareEntryPointOps(
     for (auto variantOp : variantOps) {
       // Declare the entry point on the target.
       OpBuilder targetBuilder(&variantOp.getBlock().front());
-      targetBuilder.create<IREE::HAL::ExecutableEntryPointOp>(
-          dispatchEntryOp.getLoc(),
-          targetBuilder.getStringAttr(dispatchEntryOp.function_ref()),
-          targetBuilder.getIndexAttr(ordinal),
-          targetBuilder.getSymbolRefAttr(interfaceOp), ArrayAttr{},
-          IntegerAttr{});
+      auto entryPointOp =
+          targetBuilder.create<IREE::HAL::ExecutableEntryPointOp>(
+              dispatchEntryOp.getLoc(),
+              targetBuilder.getStringAttr(dispatchEntryOp.function_ref()),
+              targetBuilder.getIndexAttr(ordinal),
+              targetBuilder.getSymbolRefAttr(interfaceOp), ArrayAttr{},
+              IntegerAttr{});
+      // Carry over the static cost estimates made during outlining.
+      Optional<int64_t> opCount, byteCount;
+      if (auto attr = dispatchEntryOp.estimated_opsAttr()) {
+        opCount = attr.getInt();
+      }
+      if (auto attr = dispatchEntryOp.estimated_bytesAttr()) {
+        byteCount = attr.getInt();
+      }
+      setDispatchCostEstimates(entryPointOp, opCount, byteCount);
 
       // Clone the updated interface-based function into the target.
       auto targetFuncOp = baseFuncOp.clone();
@@ -23,6 +23,19 @@ namespace iree_compiler {
 namespace IREE {
 namespace HAL {
 
+// Returns the symbol name suffix used for resources cached for |ordinal|.
+static std::string getDeviceSuffix(int64_t ordinal) {
+  return ordinal == 0 ? std::string() : "_device" + std::to_string(ordinal);
+}
+
+// Creates the device with the given |ordinal| in an initializer.
+static Value createDevice(OpBuilder &builder, Location loc, int64_t ordinal) {
+  if (ordinal == 0) return builder.createOrFold<ExSharedDeviceOp>(loc);
+  return builder.createOrFold<ExDeviceOp>(loc, ordinal);
+}
+
+// Resources used with devices other than the shared device (ordinal 0) are
+// cached per device.
 class MaterializeResourceCachesPass
     : public PassWrapper<MaterializeResourceCachesPass,
                          OperationPass<ModuleOp>> {
@@ -55,14 +68,16 @@ class MaterializeResourceCachesPass
            executableOp.getBlock().getOps<IREE::HAL::InterfaceOp>()) {
         defineExecutableLayoutOp(interfaceOp.getLoc(),
                                  interfaceOp.getExecutableSetLayoutsAttr(),
-                                 interfaceOp.push_constantsAttr());
+                                 interfaceOp.push_constantsAttr(),
+                                 /*deviceOrdinal=*/0);
       }
     }
 
     // Declare executable variables so that we can reference them during lookup
-    // replacement.
+    // replacement. Caches for devices other than the shared device are only
+    // declared when a lookup on them is found below.
     for (auto executableOp : executableOps) {
-      if (!defineExecutableOp(executableOp)) {
+      if (!defineExecutableOp(executableOp, /*deviceOrdinal=*/0)) {
         signalPassFailure();
         return;
       }
@@ -87,14 +102,17 @@ class MaterializeResourceCachesPass
 
  private:
   IREE::Util::GlobalOp defineDescriptorSetLayoutOp(Location loc,
-                                                   ArrayAttr bindingsAttr) {
-    auto existingIt = descriptorSetLayoutCache_.find(bindingsAttr);
+                                                   ArrayAttr bindingsAttr,
+                                                   int64_t deviceOrdinal) {
+    auto cacheKey = std::make_pair(deviceOrdinal, Attribute(bindingsAttr));
+    auto existingIt = descriptorSetLayoutCache_.find(cacheKey);
     if (existingIt != descriptorSetLayoutCache_.end()) {
       return existingIt->second;
     }
 
     auto symbolName = (StringRef("_descriptor_set_layout_") +
-                       std::to_string(nextUniqueDescriptorSetLayoutId++))
+                       std::to_string(nextUniqueDescriptorSetLayoutId++) +
+                       getDeviceSuffix(deviceOrdinal))
                           .str();
     auto initializerName = symbolName + "_initializer";
 
@@ -104,14 +122,14 @@ class MaterializeResourceCachesPass
         /*isMutable=*/false, layoutType, StringRef(initializerName),
         llvm::None);
     globalOp.setPrivate();
-    descriptorSetLayoutCache_.try_emplace(bindingsAttr, globalOp);
+    descriptorSetLayoutCache_.try_emplace(cacheKey, globalOp);
 
     auto initializerOp = moduleBuilder.create<FuncOp>(
         loc, initializerName, moduleBuilder.getFunctionType({}, {layoutType}));
     initializerOp.setPrivate();
     auto *block = initializerOp.addEntryBlock();
     OpBuilder blockBuilder = OpBuilder::atBlockEnd(block);
-    auto deviceValue = blockBuilder.createOrFold<ExSharedDeviceOp>(loc);
+    auto deviceValue = createDevice(blockBuilder, loc, deviceOrdinal);
     auto layoutUsage = IREE::HAL::DescriptorSetLayoutUsageType::PushOnly;
     auto layoutValue = blockBuilder.createOrFold<DescriptorSetLayoutCreateOp>(
         loc, layoutType, deviceValue, layoutUsage, bindingsAttr);
@@ -122,7 +140,8 @@ class MaterializeResourceCachesPass
 
   IREE::Util::GlobalOp defineExecutableLayoutOp(Location loc,
                                                 ArrayAttr setLayoutsArrayAttr,
-                                                IntegerAttr pushConstantsAttr) {
+                                                IntegerAttr pushConstantsAttr,
+                                                int64_t deviceOrdinal) {
     // Push constants are optional but we always provide the value.
     if (!pushConstantsAttr) {
       pushConstantsAttr = IntegerAttr::get(IndexType::get(loc.getContext()), 0);
@@ -130,8 +149,10 @@ class MaterializeResourceCachesPass
 
     // We key the layout cache on all attributes that compose an executable
     // layout.
-    auto cacheKey = ArrayAttr::get(loc.getContext(),
-                                   {setLayoutsArrayAttr, pushConstantsAttr});
+    auto cacheKey = std::make_pair(
+        deviceOrdinal,
+        Attribute(ArrayAttr::get(loc.getContext(),
+                                 {setLayoutsArrayAttr, pushConstantsAttr})));
 
     auto existingIt = executableLayoutCache_.find(cacheKey);
     if (existingIt != executableLayoutCache_.end()) {
@@ -142,12 +163,13 @@ class MaterializeResourceCachesPass
     // they end up in the proper initialization order.
     SmallVector<IREE::Util::GlobalOp, 4> setLayoutGlobalOps;
     for (auto setLayoutsAttr : setLayoutsArrayAttr) {
-      setLayoutGlobalOps.push_back(
-          defineDescriptorSetLayoutOp(loc, setLayoutsAttr.cast<ArrayAttr>()));
+      setLayoutGlobalOps.push_back(defineDescriptorSetLayoutOp(
+          loc, setLayoutsAttr.cast<ArrayAttr>(), deviceOrdinal));
     }
 
     auto symbolName = (StringRef("_executable_layout_") +
-                       std::to_string(nextUniqueExecutableLayoutId++))
+                       std::to_string(nextUniqueExecutableLayoutId++) +
+                       getDeviceSuffix(deviceOrdinal))
                           .str();
     auto initializerName = symbolName + "_initializer";
 
@@ -170,7 +192,7 @@ class MaterializeResourceCachesPass
           setLayoutGlobalOp.sym_name());
       setLayoutValues.push_back(setLayoutValue);
     }
-    auto deviceValue = blockBuilder.createOrFold<ExSharedDeviceOp>(loc);
+    auto deviceValue = createDevice(blockBuilder, loc, deviceOrdinal);
     auto layoutValue = blockBuilder.createOrFold<ExecutableLayoutCreateOp>(
         loc, layoutType, deviceValue, pushConstantsAttr, setLayoutValues);
     blockBuilder.create<mlir::ReturnOp>(loc, layoutValue);
@@ -178,10 +200,25 @@ class MaterializeResourceCachesPass
     return globalOp;
   }
 
-  IREE::Util::GlobalOp defineExecutableOp(ExecutableOp executableOp) {
+  IREE::Util::GlobalOp defineExecutableOp(ExecutableOp executableOp,
+                                          int64_t deviceOrdinal) {
     auto loc = executableOp.getLoc();
-    auto symbolName =
-        (StringRef("_executable_") + executableOp.sym_name()).str();
+
+    // Layouts of the shared device are all declared up front; others are
+    // declared here so that they are initialized prior to the executable.
+    if (deviceOrdinal != 0) {
+      for (auto interfaceOp :
+           executableOp.getBlock().getOps<IREE::HAL::InterfaceOp>()) {
+        defineExecutableLayoutOp(interfaceOp.getLoc(),
+                                 interfaceOp.getExecutableSetLayoutsAttr(),
+                                 interfaceOp.push_constantsAttr(),
+                                 deviceOrdinal);
+      }
+    }
+
+    auto symbolName = (StringRef("_executable_") + executableOp.sym_name() +
+                       getDeviceSuffix(deviceOrdinal))
+                          .str();
     auto initializerName = symbolName + "_initializer";
 
     auto executableType = ExecutableType::get(executableOp.getContext());
@@ -189,7 +226,8 @@ class MaterializeResourceCachesPass
         loc, symbolName, /*isMutable=*/false, executableType,
         StringRef(initializerName), llvm::None);
     globalOp.setPrivate();
-    executableCache_.try_emplace(executableOp.sym_name(), globalOp);
+    executableCache_.try_emplace(
+        std::make_pair(deviceOrdinal, executableOp.sym_name()), globalOp);
 
     auto initializerOp = moduleBuilder.create<FuncOp>(
         loc, initializerName,
@@ -197,7 +235,7 @@ class MaterializeResourceCachesPass
     initializerOp.setPrivate();
     auto *block = initializerOp.addEntryBlock();
     OpBuilder blockBuilder = OpBuilder::atBlockEnd(block);
-    auto deviceValue = blockBuilder.createOrFold<ExSharedDeviceOp>(loc);
+    auto deviceValue = createDevice(blockBuilder, loc, deviceOrdinal);
 
     // Create a switch statement with a case for each variant.
     // Each case should then cache only executables which contain a matching
@@ -224,7 +262,7 @@ class MaterializeResourceCachesPass
         assert(interfaceOp && "must have an interface available");
         auto executableLayoutGlobalOp = defineExecutableLayoutOp(
             executableOp.getLoc(), interfaceOp.getExecutableSetLayoutsAttr(),
-            interfaceOp.push_constantsAttr());
+            interfaceOp.push_constantsAttr(), deviceOrdinal);
         executableLayoutValues.push_back(
             caseBuilder.createOrFold<IREE::Util::GlobalLoadOp>(
                 loc, ExecutableLayoutType::get(loc.getContext()),
@@ -259,8 +297,9 @@ class MaterializeResourceCachesPass
   void replaceDescriptorSetLayoutLookupOp(
       DescriptorSetLayoutLookupOp &lookupOp) {
     OpBuilder builder(lookupOp);
-    auto globalOp =
-        defineDescriptorSetLayoutOp(lookupOp.getLoc(), lookupOp.bindings());
+    auto globalOp = defineDescriptorSetLayoutOp(
+        lookupOp.getLoc(), lookupOp.bindings(),
+        ExDeviceOp::getDeviceOrdinal(lookupOp.device()));
     auto loadOp = builder.create<IREE::Util::GlobalLoadOp>(
         lookupOp.getLoc(), DescriptorSetLayoutType::get(lookupOp.getContext()),
         globalOp.sym_name());
@@ -270,9 +309,10 @@ class MaterializeResourceCachesPass
 
   void replaceExecutableLayoutLookupOp(ExecutableLayoutLookupOp &lookupOp) {
     OpBuilder builder(lookupOp);
-    auto globalOp =
-        defineExecutableLayoutOp(lookupOp.getLoc(), lookupOp.set_layouts(),
-                                 lookupOp.push_constantsAttr());
+    auto globalOp = defineExecutableLayoutOp(
+        lookupOp.getLoc(), lookupOp.set_layouts(),
+        lookupOp.push_constantsAttr(),
+        ExDeviceOp::getDeviceOrdinal(lookupOp.device()));
     auto loadOp = builder.create<IREE::Util::GlobalLoadOp>(
         lookupOp.getLoc(), ExecutableLayoutType::get(lookupOp.getContext()),
         globalOp.sym_name());
@@ -282,10 +322,18 @@ class MaterializeResourceCachesPass
 
   void replaceExecutableLookupOp(ExecutableLookupOp &lookupOp) {
     OpBuilder builder(lookupOp);
-    auto executableIt = executableCache_.find(lookupOp.executable());
-    assert(executableIt != executableCache_.end() &&
-           "executable must have been cached");
-    auto globalOp = executableIt->second;
+    int64_t deviceOrdinal = ExDeviceOp::getDeviceOrdinal(lookupOp.device());
+    IREE::Util::GlobalOp globalOp;
+    auto executableIt = executableCache_.find(
+        std::make_pair(deviceOrdinal, lookupOp.executable()));
+    if (executableIt != executableCache_.end()) {
+      globalOp = executableIt->second;
+    } else {
+      assert(deviceOrdinal != 0 && "executable must have been cached");
+      auto executableOp = SymbolTable::lookupNearestSymbolFrom<ExecutableOp>(
+          lookupOp, lookupOp.executableAttr());
+      globalOp = defineExecutableOp(executableOp, deviceOrdinal);
+    }
     auto loadOp = builder.create<IREE::Util::GlobalLoadOp>(
         lookupOp.getLoc(), ExecutableType::get(lookupOp.getContext()),
         globalOp.sym_name());
@@ -296,9 +344,13 @@ class MaterializeResourceCachesPass
   TargetOptions targetOptions_;
 
   OpBuilder moduleBuilder{static_cast<MLIRContext *>(nullptr)};
-  DenseMap<Attribute, IREE::Util::GlobalOp> descriptorSetLayoutCache_;
-  DenseMap<Attribute, IREE::Util::GlobalOp> executableLayoutCache_;
-  DenseMap<StringRef, IREE::Util::GlobalOp> executableCache_;
+  // Caches keyed by the device ordinal the resources are created on.
+  DenseMap<std::pair<int64_t, Attribute>, IREE::Util::GlobalOp>
+      descriptorSetLayoutCache_;
+  DenseMap<std::pair<int64_t, Attribute>, IREE::Util::GlobalOp>
+      executableLayoutCache_;
+  DenseMap<std::pair<int64_t, StringRef>, IREE::Util::GlobalOp>
+      executableCache_;
 
   int nextUniqueExecutableLayoutId = 0;
   int nextUniqueDescriptorSetLayoutId = 0;
@@ -22,8 +22,8 @@ namespace iree_compiler {
 namespace IREE {
 namespace HAL {
 
-// NOTE: this implementation is just for a single active device. As we start to
-// support multiple devices we'll need to change this to be per-device.
+// Queries are memoized per device as devices of different types (such as when
+// partitioning across a CPU and a GPU) answer them differently.
 class MemoizeDeviceQueriesPass
     : public PassWrapper<MemoizeDeviceQueriesPass, OperationPass<ModuleOp>> {
  public:
@@ -42,11 +42,15 @@ class MemoizeDeviceQueriesPass
     // This lets us easily replace all usages of a match with a single variable.
     SmallVector<Attribute, 4> deviceQueryKeys;
     DenseMap<Attribute, std::vector<IREE::HAL::DeviceQueryOp>> deviceQueryOps;
+    auto indexType = IndexType::get(moduleOp.getContext());
     for (auto funcOp : moduleOp.getOps<FuncOp>()) {
       funcOp.walk([&](IREE::HAL::DeviceQueryOp queryOp) {
         auto fullKey = ArrayAttr::get(
             moduleOp.getContext(),
             {
+                IntegerAttr::get(indexType,
+                                 IREE::HAL::ExDeviceOp::getDeviceOrdinal(
+                                     queryOp.device())),
                 StringAttr::get(moduleOp.getContext(),
                                 queryOp.category() + queryOp.key()),
                 queryOp.default_value().hasValue() ? queryOp.default_valueAttr()
@@ -90,8 +94,15 @@ class MemoizeDeviceQueriesPass
       moduleBuilder.setInsertionPointAfter(initializerOp);
 
       auto funcBuilder = OpBuilder::atBlockBegin(initializerOp.addEntryBlock());
+      int64_t deviceOrdinal = queryKey.value()
+                                  .cast<ArrayAttr>()[0]
+                                  .cast<IntegerAttr>()
+                                  .getInt();
       auto device =
-          funcBuilder.createOrFold<IREE::HAL::ExSharedDeviceOp>(fusedLoc);
+          deviceOrdinal == 0
+              ? funcBuilder.createOrFold<IREE::HAL::ExSharedDeviceOp>(fusedLoc)
+              : funcBuilder.createOrFold<IREE::HAL::ExDeviceOp>(fusedLoc,
+                                                               deviceOrdinal);
       auto queryOp = funcBuilder.create<IREE::HAL::DeviceQueryOp>(
           fusedLoc, funcBuilder.getI1Type(), queryType, device,
           anyQueryOp.categoryAttr(), anyQueryOp.keyAttr(),
@@ -0,0 +1,283 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <string>
+
+#include "iree/compiler/Dialect/HAL/IR/HALDialect.h"
+#include "iree/compiler/Dialect/HAL/Transforms/Passes.h"
+#include "iree/compiler/Dialect/Util/IR/UtilDialect.h"
+#include "iree/compiler/Dialect/Util/IR/UtilOps.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/STLExtras.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "mlir/Pass/Pass.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace HAL {
+namespace {
+
+static bool isIntegerOrIndex(Type type) {
+  return type.isa<IntegerType, IndexType>();
+}
+
+// Returns true if |op| may be executed on paths where it originally was not
+// without changing program behavior. Divisions may trap on zero divisors that
+// the original control flow guarded against.
+static bool isSpeculatable(Operation *op) {
+  if (!isa<SignedDivIOp, UnsignedDivIOp, SignedCeilDivIOp, SignedFloorDivIOp,
+           SignedRemIOp, UnsignedRemIOp>(op)) {
+    return true;
+  }
+  APInt divisor;
+  return matchPattern(op->getOperand(1), m_ConstantInt(&divisor)) &&
+         !divisor.isNullValue();
+}
+
+// The shape calculations of a function: all pure integer computations that
+// only depend on the function's integer arguments and constants.
+struct ShapeSlice {
+  // Ops in the slice in an order where all operands are defined before use.
+  SmallVector<Operation *> ops;
+  // Entry block arguments used by the slice; these key the memoized results.
+  SmallVector<BlockArgument> keys;
+  // Values computed by non-constant slice ops that are used outside of it.
+  SmallVector<Value> results;
+  // Number of non-constant ops in the slice.
+  int64_t workCount = 0;
+};
+
+static ShapeSlice computeShapeSlice(FuncOp funcOp) {
+  ShapeSlice slice;
+  Block &entryBlock = funcOp.front();
+  llvm::DenseSet<Value> sliceValues;
+  for (auto arg : entryBlock.getArguments()) {
+    if (isIntegerOrIndex(arg.getType())) sliceValues.insert(arg);
+  }
+
+  // Walk in program order such that operands are visited before their users.
+  // Ops within isolated regions cannot reference the function values and are
+  // not hoisted out.
+  llvm::DenseSet<Operation *> sliceOpSet;
+  funcOp.walk([&](Operation *op) {
+    if (op->getParentWithTrait<OpTrait::IsIsolatedFromAbove>() != funcOp) {
+      return;
+    }
+    if (op->getNumRegions() != 0 || op->getNumResults() == 0 ||
+        op->hasTrait<OpTrait::IsTerminator>() ||
+        !MemoryEffectOpInterface::hasNoEffect(op)) {
+      return;
+    }
+    if (!llvm::all_of(op->getResultTypes(), isIntegerOrIndex) ||
+        !llvm::all_of(op->getOperands(),
+                      [&](Value v) { return sliceValues.contains(v); })) {
+      return;
+    }
+    if (op->getBlock() != &entryBlock && !isSpeculatable(op)) return;
+    slice.ops.push_back(op);
+    sliceOpSet.insert(op);
+    sliceValues.insert(op->result_begin(), op->result_end());
+  });
+
+  llvm::DenseSet<Value> keySet;
+  for (auto *op : slice.ops) {
+    for (auto operand : op->getOperands()) {
+      auto arg = operand.dyn_cast<BlockArgument>();
+      if (arg && keySet.insert(arg).second) slice.keys.push_back(arg);
+    }
+    if (matchPattern(op, m_Constant())) continue;
+    ++slice.workCount;
+    for (auto result : op->getResults()) {
+      if (llvm::any_of(result.getUsers(), [&](Operation *user) {
+            return !sliceOpSet.contains(user);
+          })) {
+        slice.results.push_back(result);
+      }
+    }
+  }
+  llvm::sort(slice.keys, [](BlockArgument lhs, BlockArgument rhs) {
+    return lhs.getArgNumber() < rhs.getArgNumber();
+  });
+  return slice;
+}
+
+// Hoists the shape calculations of functions to their entry and caches their
+// results in globals keyed by the integer arguments they depend on (usually
+// the dynamic dimensions of the inputs):
+//   %valid = util.global.load @_fn_shape_memo_valid : i1
+//   %k0 = util.global.load @_fn_shape_memo_key_0 : index
+//   %eq0 = cmpi eq, %arg1, %k0 : index
+//   %hit = and %valid, %eq0 : i1
+//   cond_br %hit, ^cached, ^compute
+// ^compute:
+//   <shape calculations>
+//   util.global.store ...
+//   br ^continue(%r0, %r1)
+// ^cached:
+//   %r0 = util.global.load @_fn_shape_memo_value_0 : index
+//   br ^continue(%r0, %r1)
+// ^continue(%r0: index, %r1: index):
+//   <original body>
+//
+// Models invoked repeatedly with the same shapes (the common case for
+// streaming and batched inference) then skip the workgroup count and buffer
+// size math on each dispatch. Functions whose calculations are cheaper than
+// the cache check are left unchanged.
+class MemoizeShapeCalculationsPass
+    : public PassWrapper<MemoizeShapeCalculationsPass,
+                         OperationPass<ModuleOp>> {
+ public:
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<IREE::Util::UtilDialect>();
+  }
+
+  StringRef getArgument() const override {
+    return "iree-hal-memoize-shape-calculations";
+  }
+
+  StringRef getDescription() const override {
+    return "Hoists shape calculations to function entry and caches their "
+           "results across invocations with the same argument shapes";
+  }
+
+  void runOnOperation() override {
+    auto funcOps = llvm::to_vector<4>(getOperation().getOps<FuncOp>());
+    for (auto funcOp : funcOps) {
+      if (funcOp.isExternal()) continue;
+      auto slice = computeShapeSlice(funcOp);
+      // Each invocation pays for a load and compare per key and a load per
+      // result; only memoize if that is cheaper than the calculation itself.
+      int64_t checkCost = 2 * slice.keys.size() + slice.results.size();
+      if (slice.keys.empty() || slice.results.empty() ||
+          slice.workCount <= checkCost) {
+        continue;
+      }
+      memoizeShapeSlice(funcOp, slice);
+    }
+  }
+
+ private:
+  void memoizeShapeSlice(FuncOp funcOp, ShapeSlice &slice) {
+    auto loc = funcOp.getLoc();
+    std::string namePrefix = ("_" + funcOp.getName() + "_shape_memo").str();
+    OpBuilder moduleBuilder(funcOp);
+    auto i1Type = moduleBuilder.getI1Type();
+    auto validGlobalOp = moduleBuilder.create<IREE::Util::GlobalOp>(
+        loc, namePrefix + "_valid", /*isMutable=*/true, i1Type,
+        moduleBuilder.getIntegerAttr(i1Type, 0));
+    validGlobalOp.setPrivate();
+    SmallVector<IREE::Util::GlobalOp> keyGlobalOps;
+    for (auto key : llvm::enumerate(slice.keys)) {
+      auto globalOp = moduleBuilder.create<IREE::Util::GlobalOp>(
+          loc, namePrefix + "_key_" + std::to_string(key.index()),
+          /*isMutable=*/true, key.value().getType());
+      globalOp.setPrivate();
+      keyGlobalOps.push_back(globalOp);
+    }
+    SmallVector<IREE::Util::GlobalOp> resultGlobalOps;
+    for (auto result : llvm::enumerate(slice.results)) {
+      auto globalOp = moduleBuilder.create<IREE::Util::GlobalOp>(
+          loc, namePrefix + "_value_" + std::to_string(result.index()),
+          /*isMutable=*/true, result.value().getType());
+      globalOp.setPrivate();
+      resultGlobalOps.push_back(globalOp);
+    }
+
+    // Constants are rematerialized for free and stay at the top of the entry
+    // block where they dominate both the calculations and the original body.
+    Block *entryBlock = &funcOp.front();
+    Operation *insertionPoint = nullptr;
+    for (auto *op : slice.ops) {
+      if (!matchPattern(op, m_Constant())) continue;
+      if (insertionPoint) {
+        op->moveAfter(insertionPoint);
+      } else {
+        op->moveBefore(entryBlock, entryBlock->begin());
+      }
+      insertionPoint = op;
+    }
+
+    // Check whether the cached results were computed with the same keys.
+    OpBuilder builder(entryBlock, insertionPoint
+                                      ? std::next(insertionPoint->getIterator())
+                                      : entryBlock->begin());
+    Value isHit = builder.create<IREE::Util::GlobalLoadOp>(
+        loc, i1Type, validGlobalOp.getName());
+    for (auto key : llvm::zip(slice.keys, keyGlobalOps)) {
+      auto keyValue = std::get<0>(key);
+      auto cachedKey = builder.create<IREE::Util::GlobalLoadOp>(
+          loc, keyValue.getType(), std::get<1>(key).getName());
+      auto isEqual = builder.create<CmpIOp>(loc, CmpIPredicate::eq, keyValue,
+                                            cachedKey);
+      isHit = builder.create<AndOp>(loc, isHit, isEqual);
+    }
+
+    // Everything following the check (including the original body) moves to
+    // the continuation block that receives the results.
+    auto *continueBlock = entryBlock->splitBlock(builder.getInsertionPoint());
+    auto *computeBlock = builder.createBlock(continueBlock);
+    auto *cachedBlock = builder.createBlock(continueBlock);
+    SmallVector<Value> continueArgs;
+    for (auto result : slice.results) {
+      continueArgs.push_back(continueBlock->addArgument(result.getType()));
+    }
+    builder.setInsertionPointToEnd(entryBlock);
+    builder.create<CondBranchOp>(loc, isHit, cachedBlock, computeBlock);
+
+    // Recompute and store the results and their keys on a miss.
+    llvm::DenseSet<Operation *> sliceOpSet(slice.ops.begin(), slice.ops.end());
+    for (auto *op : slice.ops) {
+      if (matchPattern(op, m_Constant())) continue;
+      op->moveBefore(computeBlock, computeBlock->end());
+    }
+    for (auto result : llvm::zip(slice.results, continueArgs)) {
+      std::get<0>(result).replaceUsesWithIf(
+          std::get<1>(result), [&](OpOperand &use) {
+            return !sliceOpSet.contains(use.getOwner());
+          });
+    }
+    builder.setInsertionPointToEnd(computeBlock);
+    for (auto key : llvm::zip(slice.keys, keyGlobalOps)) {
+      builder.create<IREE::Util::GlobalStoreOp>(loc, std::get<0>(key),
+                                                std::get<1>(key).getName());
+    }
+    for (auto result : llvm::zip(slice.results, resultGlobalOps)) {
+      builder.create<IREE::Util::GlobalStoreOp>(loc, std::get<0>(result),
+                                                std::get<1>(result).getName());
+    }
+    builder.create<IREE::Util::GlobalStoreOp>(
+        loc, builder.create<ConstantIntOp>(loc, /*value=*/1, /*width=*/1),
+        validGlobalOp.getName());
+    builder.create<BranchOp>(loc, continueBlock, slice.results);
+
+    // Load the cached results on a hit.
+    builder.setInsertionPointToEnd(cachedBlock);
+    SmallVector<Value> cachedResults;
+    for (auto result : llvm::zip(slice.results, resultGlobalOps)) {
+      cachedResults.push_back(builder.create<IREE::Util::GlobalLoadOp>(
+          loc, std::get<0>(result).getType(), std::get<1>(result).getName()));
+    }
+    builder.create<BranchOp>(loc, continueBlock, cachedResults);
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<OperationPass<ModuleOp>> createMemoizeShapeCalculationsPass() {
+  return std::make_unique<MemoizeShapeCalculationsPass>();
+}
+
+static PassRegistration<MemoizeShapeCalculationsPass> pass;
+
+}  // namespace HAL
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
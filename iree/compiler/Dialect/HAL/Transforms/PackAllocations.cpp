@@ -18,6 +18,7 @@
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/Diagnostics.h"
+#include "mlir/IR/Dominance.h"
 #include "mlir/Pass/Pass.h"
 
 namespace mlir {
@@ -52,6 +53,10 @@ class PackAllocationsPass
         IREE::HAL::DeviceTargetAttr::lookupConservativeBufferConstraints(
             funcOp);
 
+    // Merge the transient allocations of independent streams such that they
+    // are all packed into a single slab that is reused across the streams.
+    coalesceTransientAllocations(funcOp);
+
     // NOTE: we could try several algorithms and compute which packs best. For
     // now we just pack greedily as it's fast and what most existing ML
     // frameworks do.
@@ -105,6 +110,196 @@ class PackAllocationsPass
   }
 
  private:
+  // A transient allocation whose size is entirely defined by a pack op, as
+  // produced by stream conversion for the values that do not escape a stream.
+  struct TransientAllocation {
+    IREE::HAL::AllocatorPackOp packOp;
+    IREE::HAL::AllocatorAllocateOp allocateOp;
+  };
+
+  // Returns the transient allocation of the total length of |packOp| or
+  // nullptr if the packed storage is not a transient allocation.
+  static IREE::HAL::AllocatorAllocateOp matchTransientAllocation(
+      IREE::HAL::AllocatorPackOp packOp) {
+    if (packOp.offset()) return {};
+    auto totalLength = packOp.total_length();
+    if (!totalLength.hasOneUse()) return {};
+    auto allocateOp = dyn_cast<IREE::HAL::AllocatorAllocateOp>(
+        *totalLength.getUsers().begin());
+    if (!allocateOp || allocateOp->getBlock() != packOp->getBlock() ||
+        allocateOp.allocator() != packOp.allocator() ||
+        !allEnumBitsSet(allocateOp.memory_types(),
+                        IREE::HAL::MemoryTypeBitfield::Transient)) {
+      return {};
+    }
+    return allocateOp;
+  }
+
+  // Returns true if |allocation| can be merged into the allocation of
+  // |baseAllocation| by hoisting its pack to the base pack.
+  static bool canMergeTransientAllocation(
+      const TransientAllocation &baseAllocation,
+      const TransientAllocation &allocation, DominanceInfo &domInfo) {
+    if (allocation.packOp.allocator() != baseAllocation.packOp.allocator() ||
+        allocation.allocateOp.memory_types() !=
+            baseAllocation.allocateOp.memory_types() ||
+        allocation.allocateOp.buffer_usage() !=
+            baseAllocation.allocateOp.buffer_usage()) {
+      return false;
+    }
+    for (auto size : allocation.packOp.dynamic_slice_sizes()) {
+      // Constants are rematerialized and otherwise the sizes must already be
+      // available at the base pack.
+      if (isa_and_nonnull<ConstantOp>(size.getDefiningOp())) continue;
+      if (!domInfo.properlyDominates(size, baseAllocation.packOp)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Coalesces the transient allocations within each block of |funcOp| into
+  // one allocation per group of streams that are executed in sequence.
+  //
+  // Streams have their transient values never outlive them. Once a stream has
+  // been waited on (either with hal.ex.submit_and_wait or by awaiting the
+  // semaphore signaled by its hal.ex.submit/hal.device.queue.submit, which
+  // also completes everything the submission waited on) and no other
+  // submissions are in flight the storage of all prior transients can be
+  // reused and as such we can treat the streams as a single timeline: each
+  // pack has its lifetime intervals shifted past the end of the prior packs in
+  // the group and all are merged into a single pack feeding a single
+  // allocation. The greedy packing performed on
+  // the merged pack then assigns overlapping offsets to transients from
+  // different streams which bounds the total slab size by the peak usage of
+  // any single stream instead of the sum of all of them.
+  //
+  // Allocations are only merged when all of the slice sizes are available at
+  // the first pack in the group; dynamically-sized transients that depend on
+  // the results of prior streams begin a new group.
+  void coalesceTransientAllocations(FuncOp funcOp) {
+    DominanceInfo domInfo(funcOp);
+    for (auto &block : funcOp.getBlocks()) {
+      SmallVector<SmallVector<TransientAllocation>> groups;
+      bool hasWaitedSinceLastAllocation = false;
+      SmallPtrSet<Value, 4> pendingSemaphores;
+      // Semaphores waited on by the submission signaling each semaphore.
+      DenseMap<Value, SmallVector<Value>> semaphoreWaits;
+      auto completeSemaphore = [&](Value semaphore) {
+        SmallVector<Value> worklist = {semaphore};
+        bool erased = false;
+        while (!worklist.empty()) {
+          Value value = worklist.pop_back_val();
+          erased |= pendingSemaphores.erase(value);
+          auto it = semaphoreWaits.find(value);
+          if (it == semaphoreWaits.end()) continue;
+          worklist.append(it->second);
+          semaphoreWaits.erase(it);
+        }
+        return erased;
+      };
+      for (auto &op : block) {
+        if (isa<IREE::HAL::ExSubmitAndWaitOp>(op)) {
+          hasWaitedSinceLastAllocation = pendingSemaphores.empty();
+          continue;
+        } else if (auto submitOp = dyn_cast<IREE::HAL::ExSubmitOp>(op)) {
+          pendingSemaphores.insert(submitOp.signal_semaphore());
+          hasWaitedSinceLastAllocation = false;
+          continue;
+        } else if (auto submitOp =
+                       dyn_cast<IREE::HAL::DeviceQueueSubmitOp>(op)) {
+          pendingSemaphores.insert(submitOp.signal_semaphore());
+          semaphoreWaits[submitOp.signal_semaphore()].append(
+              submitOp.wait_semaphores().begin(),
+              submitOp.wait_semaphores().end());
+          hasWaitedSinceLastAllocation = false;
+          continue;
+        } else if (auto awaitOp = dyn_cast<IREE::HAL::SemaphoreAwaitOp>(op)) {
+          if (completeSemaphore(awaitOp.semaphore())) {
+            hasWaitedSinceLastAllocation = pendingSemaphores.empty();
+          }
+          continue;
+        }
+        auto packOp = dyn_cast<IREE::HAL::AllocatorPackOp>(op);
+        if (!packOp) continue;
+        auto allocateOp = matchTransientAllocation(packOp);
+        if (!allocateOp) continue;
+        TransientAllocation allocation = {packOp, allocateOp};
+        if (groups.empty() || !hasWaitedSinceLastAllocation ||
+            !canMergeTransientAllocation(groups.back().front(), allocation,
+                                         domInfo)) {
+          groups.emplace_back();
+        }
+        groups.back().push_back(allocation);
+        hasWaitedSinceLastAllocation = false;
+      }
+      for (auto &group : groups) {
+        if (group.size() > 1) mergeTransientAllocations(group);
+      }
+    }
+  }
+
+  // Merges all |allocations| into a single pack and allocation inserted at the
+  // first pack. The original ops are erased.
+  void mergeTransientAllocations(ArrayRef<TransientAllocation> allocations) {
+    auto baseAllocation = allocations.front();
+    OpBuilder builder(baseAllocation.packOp);
+
+    SmallVector<Location> locs;
+    SmallVector<int64_t> lifetimeIntervals;
+    SmallVector<Value> dynamicSliceSizes;
+    int64_t lifetimeBase = 0;
+    for (auto &allocation : allocations) {
+      locs.push_back(allocation.packOp.getLoc());
+      auto slices = allocation.packOp.getSlices();
+      if (slices.empty()) continue;
+      int64_t lifetimeStart = INT64_MAX;
+      int64_t lifetimeEnd = INT64_MIN;
+      for (auto &slice : slices) {
+        lifetimeStart = std::min(lifetimeStart, slice.lifetimeStart);
+        lifetimeEnd = std::max(lifetimeEnd, slice.lifetimeEnd);
+      }
+      for (auto &slice : slices) {
+        lifetimeIntervals.push_back(lifetimeBase + slice.lifetimeStart -
+                                    lifetimeStart);
+        lifetimeIntervals.push_back(lifetimeBase + slice.lifetimeEnd -
+                                    lifetimeStart);
+        auto size = slice.dynamicSize;
+        if (auto constantOp =
+                dyn_cast_or_null<ConstantIndexOp>(size.getDefiningOp())) {
+          size = builder.createOrFold<ConstantIndexOp>(constantOp.getLoc(),
+                                                       constantOp.getValue());
+        }
+        dynamicSliceSizes.push_back(size);
+      }
+      lifetimeBase += lifetimeEnd - lifetimeStart + 1;
+    }
+
+    auto loc = builder.getFusedLoc(locs);
+    auto indexType = builder.getIndexType();
+    SmallVector<Type> packedOffsetTypes(dynamicSliceSizes.size(), indexType);
+    auto packOp = builder.create<IREE::HAL::AllocatorPackOp>(
+        loc, indexType, packedOffsetTypes, baseAllocation.packOp.allocator(),
+        /*offset=*/nullptr, builder.getIndexArrayAttr(lifetimeIntervals),
+        dynamicSliceSizes);
+    auto allocateOp = builder.create<IREE::HAL::AllocatorAllocateOp>(
+        loc, baseAllocation.allocateOp.result().getType(),
+        baseAllocation.packOp.allocator(),
+        baseAllocation.allocateOp.memory_types(),
+        baseAllocation.allocateOp.buffer_usage(), packOp.total_length());
+
+    auto packedOffsets = packOp.packed_offsets();
+    size_t packedOffsetIndex = 0;
+    for (auto &allocation : allocations) {
+      for (auto packedOffset : allocation.packOp.packed_offsets()) {
+        packedOffset.replaceAllUsesWith(packedOffsets[packedOffsetIndex++]);
+      }
+      allocation.allocateOp.result().replaceAllUsesWith(allocateOp.result());
+      allocation.allocateOp.erase();
+      allocation.packOp.erase();
+    }
+  }
+
   // Packs slices back-to-back with no aliasing. Useful when debugging to remove
   // the aliasing that makes data breakpoints useless.
   //
@@ -4,12 +4,15 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <cstring>
 #include <utility>
 
 #include "iree/compiler/Dialect/HAL/IR/HALDialect.h"
 #include "iree/compiler/Dialect/HAL/IR/HALOps.h"
 #include "iree/compiler/Dialect/HAL/Transforms/Passes.h"
 #include "iree/compiler/Dialect/HAL/Utils/TypeUtils.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/Support/CommandLine.h"
 #include "mlir/Dialect/StandardOps/IR/Ops.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/Builders.h"
@@ -17,6 +20,12 @@
 #include "mlir/IR/Diagnostics.h"
 #include "mlir/Pass/Pass.h"
 
+static llvm::cl::opt<bool> clCompressConstantPoolStorage(
+    "iree-hal-compress-constant-pool-storage",
+    llvm::cl::desc("Elides runs of repeating 4-byte patterns from constant "
+                   "pool storage and fills them in at runtime"),
+    llvm::cl::init(false));
+
 namespace mlir {
 namespace iree_compiler {
 namespace IREE {
@@ -49,6 +58,10 @@ class PackConstantPoolStoragePass
   }
 
  private:
+  // Minimum length in bytes of a run of a repeating 4-byte pattern elided from
+  // compressed storage. Shorter runs are cheaper to store than to fill.
+  static constexpr uint64_t kMinFillRunLength = 256;
+
   // Packs all constant values within |poolOp| into storage buffers.
   // Zero or more top-level module byte buffers will be inserted.
   // Safe to call on constant pools that have already been packed; only newly
@@ -98,7 +111,8 @@ class PackConstantPoolStoragePass
       auto storageBufferOp =
           OpBuilder(poolOp.getContext())
               .create<ConstantStorageOp>(storageBufferLoc, "_storage",
-                                         storageBuffer.data);
+                                         storageBuffer.data,
+                                         storageBuffer.fills);
       poolSymbolTable.insert(storageBufferOp);
       storageBufferOp.setNested();
 
@@ -148,6 +162,8 @@ class PackConstantPoolStoragePass
     // Packed byte data that must be embedded in the final module.
     // It must be written with an alignment as required by the constraints.
     ElementsAttr data;
+    // Runs of [offset, length, pattern] elided from |data| when compressed.
+    DenseIntElementsAttr fills;
   };
 
   // Returns zero or more storage buffers and the spans values map into.
@@ -185,7 +201,9 @@ class PackConstantPoolStoragePass
     //
     // Here it's all descriptor sets and mapped pages but same thing pretty
     // much, and passes earlier on may duplicate constants in the pool if it
-    // means they can improve locality at runtime. This pass doesn't dedupe and
+    // means they can improve locality at runtime. This pass only dedupes
+    // values with identical contents that land in the same storage buffer
+    // (where there's no locality to be gained by repeating them) and otherwise
     // just sticks to packing for that reason.
 
     // Build a list of buffers and spans (append to current or spill to new).
@@ -195,6 +213,9 @@ class PackConstantPoolStoragePass
     // Pack each storage buffer bucket into a single data blob.
     for (auto &storageBuffer : storageBuffers) {
       packStorageBufferData(storageBuffer, context);
+      if (clCompressConstantPoolStorage) {
+        compressStorageBufferData(storageBuffer, context);
+      }
     }
 
     return storageBuffers;
@@ -209,11 +230,28 @@ class PackConstantPoolStoragePass
     SmallVector<StorageBuffer, 8> storageBuffers;
     storageBuffers.push_back({});
     StorageBuffer *currentBuffer = &storageBuffers.back();
+    // Spans in the current buffer keyed by the hash of their contents.
+    DenseMap<size_t, SmallVector<unsigned, 1>> currentSpansByHash;
     for (auto valueOp : valueOps) {
+      auto rawData = valueOp.value().cast<DenseElementsAttr>().getRawData();
+
+      // Reuse the storage of an identical value in the current buffer.
+      size_t hash = llvm::hash_value(rawData);
+      auto *existingSpan = llvm::find_if(
+          currentSpansByHash[hash], [&](unsigned spanIndex) {
+            auto &span = currentBuffer->spans[spanIndex];
+            return span.valueOp.value().cast<DenseElementsAttr>().getRawData() ==
+                   rawData;
+          });
+      if (existingSpan != currentSpansByHash[hash].end()) {
+        auto &span = currentBuffer->spans[*existingSpan];
+        currentBuffer->spans.push_back({valueOp, span.offset, span.length});
+        continue;
+      }
+
       uint64_t offset = align(currentBuffer->totalSize,
                               bufferConstraints.min_buffer_offset_alignment());
-      uint64_t unpaddedLength =
-          valueOp.value().cast<DenseElementsAttr>().getRawData().size();
+      uint64_t unpaddedLength = rawData.size();
       uint64_t paddedLength =
           align(unpaddedLength, bufferConstraints.min_buffer_range_alignment());
       if (offset + unpaddedLength >
@@ -221,8 +259,10 @@ class PackConstantPoolStoragePass
         // Spilling buffer; make a new one.
         storageBuffers.push_back({});
         currentBuffer = &storageBuffers.back();
+        currentSpansByHash.clear();
         offset = 0;
       }
+      currentSpansByHash[hash].push_back(currentBuffer->spans.size());
       currentBuffer->spans.push_back({valueOp, offset, unpaddedLength});
       currentBuffer->totalSize =
           std::max(currentBuffer->totalSize, offset + paddedLength);
@@ -273,6 +313,57 @@ class PackConstantPoolStoragePass
         buffer,
         /*isSplatBuffer=*/false);
   }
+
+  // Compresses the data of |storageBuffer| by eliding all 4-byte aligned runs
+  // of at least kMinFillRunLength bytes of a repeating 4-byte pattern (such as
+  // zero padding or constant-initialized regions of weights). The elided runs
+  // are recorded in the storage buffer fills and are filled in when the
+  // storage is materialized at runtime.
+  void compressStorageBufferData(StorageBuffer &storageBuffer,
+                                 MLIRContext *context) {
+    auto data = storageBuffer.data.cast<DenseElementsAttr>().getRawData();
+    auto readWord = [&](uint64_t offset) {
+      uint32_t word = 0;
+      std::memcpy(&word, data.data() + offset, sizeof(word));
+      return word;
+    };
+
+    SmallVector<int64_t> fills;
+    std::vector<char> literals;
+    literals.reserve(data.size());
+    uint64_t literalStart = 0;
+    uint64_t offset = 0;
+    while (offset + sizeof(uint32_t) <= data.size()) {
+      uint32_t pattern = readWord(offset);
+      uint64_t runEnd = offset + sizeof(uint32_t);
+      while (runEnd + sizeof(uint32_t) <= data.size() &&
+             readWord(runEnd) == pattern) {
+        runEnd += sizeof(uint32_t);
+      }
+      if (runEnd - offset < kMinFillRunLength) {
+        offset = runEnd;
+        continue;
+      }
+      literals.insert(literals.end(), data.begin() + literalStart,
+                      data.begin() + offset);
+      fills.append({static_cast<int64_t>(offset),
+                    static_cast<int64_t>(runEnd - offset),
+                    static_cast<int64_t>(pattern)});
+      literalStart = offset = runEnd;
+    }
+    if (fills.empty()) return;
+    literals.insert(literals.end(), data.begin() + literalStart, data.end());
+
+    storageBuffer.data = DenseElementsAttr::getFromRawBuffer(
+        VectorType::get({static_cast<int64_t>(literals.size())},
+                        IntegerType::get(context, 8)),
+        literals,
+        /*isSplatBuffer=*/false);
+    storageBuffer.fills = DenseIntElementsAttr::get(
+        RankedTensorType::get({static_cast<int64_t>(fills.size() / 3), 3},
+                              IntegerType::get(context, 64)),
+        fills);
+  }
 };
 
 std::unique_ptr<OperationPass<ConstantPoolOp>>
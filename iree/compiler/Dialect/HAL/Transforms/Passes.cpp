@@ -48,6 +48,21 @@ static llvm::cl::opt<unsigned> benchmarkDispatchRepeatCount{
         "structures.)"),
     llvm::cl::init(1)};
 
+static llvm::cl::opt<bool> exportStaticMemoryPlan{
+    "iree-hal-static-memory-plan",
+    llvm::cl::desc(
+        "Computes a static memory plan of all allocations in the program and "
+        "exports it with the module for use with a fixed-size arena at "
+        "runtime. Fails compilation if any allocation size is dynamic."),
+    llvm::cl::init(false)};
+
+static llvm::cl::opt<bool> memoizeShapeCalculations{
+    "iree-hal-memoize-shape-calculations",
+    llvm::cl::desc(
+        "Caches the shape calculations of each function across invocations "
+        "with the same dynamic dimensions."),
+    llvm::cl::init(true)};
+
 }  // namespace
 
 void buildHALTransformPassPipeline(OpPassManager &passManager,
@@ -63,7 +78,7 @@ void buildHALTransformPassPipeline(OpPassManager &passManager,
     // Today we just assign devices from parameters but we should instead be
     // performing analysis at the flow level and then doing magic device
     // database lookups here.
-    passManager.addPass(createAssignTargetDevicesPass(targetOptions.targets));
+    passManager.addPass(createAssignTargetDevicesPass(targetOptions));
   }
   passManager.addPass(createVerifyTargetEnvironmentPass());
 
@@ -89,6 +104,10 @@ void buildHALTransformPassPipeline(OpPassManager &passManager,
           createTranslateExecutableVariantsPass());
   passManager.addPass(createVerifyTargetEnvironmentPass());
 
+  // Partition the streams of programs targeting multiple devices into pipeline
+  // stages, one per device. No-op for single device programs.
+  passManager.addPass(createAssignDeviceAffinitiesPass());
+
   // Convert supported input dialects (std, flow, etc) into the HAL dialect.
   passManager.addPass(createConvertToHALPass());
 
@@ -109,6 +128,10 @@ void buildHALTransformPassPipeline(OpPassManager &passManager,
   // sizes are as much as possible available as constants.
   passManager.addNestedPass<FuncOp>(createPackAllocationsPass());
 
+  // Keep submissions in flight across branches such that loops record and
+  // submit each iteration while the prior one is still executing.
+  passManager.addNestedPass<FuncOp>(createDeferStreamAwaitsPass());
+
   // After all executables are translated and before resolving entry point
   // ordinals, we allow the backends to link executables together. For example,
   // the LLVM AOT backend may combine all executable targets for the same
@@ -149,6 +172,18 @@ void buildHALTransformPassPipeline(OpPassManager &passManager,
   passManager.addNestedPass<FuncOp>(
       IREE::Util::createSimplifyGlobalAccessesPass());
 
+  // Compute workgroup counts, push constants, and buffer sizes derived from
+  // dynamic dimensions once per distinct set of dimensions instead of on
+  // every invocation. This runs after the loads above have been hoisted so
+  // that the cache check itself is not duplicated.
+  if (memoizeShapeCalculations) {
+    passManager.addPass(createMemoizeShapeCalculationsPass());
+  }
+
+  // Record each dispatch and the state it pushes with a single command. This
+  // runs after all folding of the individual push ops.
+  passManager.addNestedPass<FuncOp>(createFuseDispatchPushesPass());
+
   if (transformOptions.serializeExecutables) {
     passManager.addNestedPass<IREE::HAL::ExecutableOp>(
         createSerializeExecutablesPass());
@@ -159,6 +194,11 @@ void buildHALTransformPassPipeline(OpPassManager &passManager,
 
   // Final cleanup of IR; cleans up things left behind by CSE/DCE above.
   passManager.addNestedPass<FuncOp>(createCanonicalizerPass());
+
+  // Export the memory plan once all allocation sizes have been folded.
+  if (exportStaticMemoryPlan) {
+    passManager.addPass(createExportStaticMemoryPlanPass());
+  }
 }
 
 void buildHALTransformPassPipeline(OpPassManager &passManager,
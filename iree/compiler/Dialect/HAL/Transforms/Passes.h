@@ -56,9 +56,17 @@ std::unique_ptr<OperationPass<ModuleOp>> createConvertToHALPass();
 // definition will be checked as well along with other structural requirements.
 std::unique_ptr<OperationPass<ModuleOp>> createVerifyTargetEnvironmentPass();
 
-// Assigns the HAL devices the module will target to the given list of targets.
+// Assigns the HAL devices the module will target to the list of targets.
+// Programs partitioned across more than one device are annotated with the
+// device count and how they are partitioned.
 std::unique_ptr<OperationPass<ModuleOp>> createAssignTargetDevicesPass(
-    ArrayRef<std::string> targets);
+    const TargetOptions &targetOptions);
+
+// Assigns each stream to one of the devices of a module partitioned across
+// multiple devices (hal.device.count) with a hal.device.affinity attribute.
+// Streams are split into pipeline stages across identical devices or placed
+// on the device with the lowest estimated cost when partitioning by target.
+std::unique_ptr<OperationPass<ModuleOp>> createAssignDeviceAffinitiesPass();
 
 // Outlines hal.device.switch conditions into functions and inlines conditions.
 std::unique_ptr<OperationPass<FuncOp>> createInlineDeviceSwitchesPass();
@@ -66,6 +74,10 @@ std::unique_ptr<OperationPass<FuncOp>> createInlineDeviceSwitchesPass();
 // Finds hal.device.query ops and creates variables initialized on startup.
 std::unique_ptr<OperationPass<ModuleOp>> createMemoizeDeviceQueriesPass();
 
+// Hoists the shape calculations of each function to its entry and caches their
+// results in globals keyed by the dynamic dimensions they depend on.
+std::unique_ptr<OperationPass<ModuleOp>> createMemoizeShapeCalculationsPass();
+
 //===----------------------------------------------------------------------===//
 // Executable translation and optimization
 //===----------------------------------------------------------------------===//
@@ -124,6 +136,16 @@ createMaterializeConstantPoolBuffersPass();
 // Performs packing and materializes runtime packing code when required.
 std::unique_ptr<OperationPass<FuncOp>> createPackAllocationsPass();
 
+// Computes a static memory plan covering all constant, transient, and output
+// allocations of the program and attaches it to each exported function as the
+// `iree.memory_plan` reflection attribute. Fails if any allocation size is not
+// known at compile time.
+std::unique_ptr<OperationPass<ModuleOp>> createExportStaticMemoryPlanPass();
+
+// Keeps stream submissions in flight across branches (such as loop back edges)
+// instead of waiting on them on the host before each branch.
+std::unique_ptr<OperationPass<FuncOp>> createDeferStreamAwaitsPass();
+
 // Finds all resource lookups (such as hal.executable.lookup), materializes
 // their cache storage and initialization, and rewrites the lookups to
 // references.
@@ -134,6 +156,10 @@ std::unique_ptr<OperationPass<ModuleOp>> createMaterializeResourceCachesPass(
 // TODO(#1124): replace with memory side effects once supported upstream.
 std::unique_ptr<OperationPass<FuncOp>> createCSEVariableLoadsPass();
 
+// Fuses push constants and descriptor set pushes into the dispatches that
+// follow them such that each dispatch is recorded with a single command.
+std::unique_ptr<OperationPass<FuncOp>> createFuseDispatchPushesPass();
+
 // Repeats dispatches `iree-hal-repeat-dispatch-num` times, which is 1 by
 // default.
 std::unique_ptr<OperationPass<FuncOp>> createBenchmarkBatchDispatchesPass(
@@ -146,9 +172,13 @@ std::unique_ptr<OperationPass<FuncOp>> createBenchmarkBatchDispatchesPass(
 inline void registerHALPasses() {
   registerHALTransformPassPipeline();
   auto targetOptions = getTargetOptionsFromFlags();
-  createAssignTargetDevicesPass({});
+  createAssignDeviceAffinitiesPass();
+  createAssignTargetDevicesPass(targetOptions);
   createBenchmarkBatchDispatchesPass(/*repeatCount=*/1);
   createConvertToHALPass();
+  createDeferStreamAwaitsPass();
+  createExportStaticMemoryPlanPass();
+  createFuseDispatchPushesPass();
   createIdentifyConstantPoolsPass();
   createInlineDeviceSwitchesPass();
   createLinkExecutablesPass();
@@ -157,6 +187,7 @@ inline void registerHALPasses() {
   createMaterializeInterfacesPass();
   createMaterializeResourceCachesPass(targetOptions);
   createMemoizeDeviceQueriesPass();
+  createMemoizeShapeCalculationsPass();
   createPackAllocationsPass();
   createPackConstantPoolStoragePass();
   createPropagateConstantWorkgroupInfoPass();
@@ -11,6 +11,7 @@
 #include "iree/compiler/Dialect/HAL/IR/HALOps.h"
 #include "iree/compiler/Dialect/HAL/Target/TargetBackend.h"
 #include "iree/compiler/Dialect/HAL/Target/TargetRegistry.h"
+#include "iree/compiler/Dialect/HAL/Transforms/ExecutableCache.h"
 #include "llvm/ADT/StringSet.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/Builders.h"
@@ -62,7 +63,25 @@ class SerializeTargetExecutablesPass
         executableOp.getBlock().getOps<IREE::HAL::ExecutableVariantOp>());
     for (auto variantOp : variantOps) {
       if (variantOp.target().getBackend().getValue() != target) continue;
+
+      // Reuse the binaries of an identical variant from a previous
+      // compilation if available.
+      std::string cacheKey =
+          getExecutableCacheKey("serialize", *targetBackend, variantOp);
+      if (!cacheKey.empty()) {
+        Block cachedBlock;
+        if (succeeded(lookupExecutableCache(cacheKey, &getContext(),
+                                            cachedBlock))) {
+          for (auto &op : llvm::make_early_inc_range(cachedBlock)) {
+            op.moveBefore(variantOp);
+          }
+          variantOp.erase();
+          continue;
+        }
+      }
+
       OpBuilder executableBuilder(variantOp);
+      Operation *previousOp = variantOp->getPrevNode();
       // Ask the target backend to serialize the executable. Note that it
       // may create one or more hal.executable.binary ops in the case of
       // multi-architecture binaries.
@@ -72,6 +91,15 @@ class SerializeTargetExecutablesPass
             << "failed to serialize executable for target backend " << target;
         return signalPassFailure();
       }
+      if (!cacheKey.empty()) {
+        SmallVector<Operation *> binaryOps;
+        for (Operation *op = previousOp ? previousOp->getNextNode()
+                                        : &executableOp.getBlock().front();
+             op != variantOp.getOperation(); op = op->getNextNode()) {
+          binaryOps.push_back(op);
+        }
+        storeExecutableCache(cacheKey, executableOp, binaryOps);
+      }
       variantOp.erase();
     }
   }
@@ -11,6 +11,7 @@
 #include "iree/compiler/Dialect/HAL/IR/HALOps.h"
 #include "iree/compiler/Dialect/HAL/Target/TargetBackend.h"
 #include "iree/compiler/Dialect/HAL/Target/TargetRegistry.h"
+#include "iree/compiler/Dialect/HAL/Transforms/ExecutableCache.h"
 #include "llvm/ADT/StringSet.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/Builders.h"
@@ -66,6 +67,14 @@ class TranslateExecutableVariantsPass
       return signalPassFailure();
     }
 
+    // Reuse the translation of an identical variant from a previous
+    // compilation if available.
+    std::string cacheKey =
+        getExecutableCacheKey("translate", *targetBackend, variantOp);
+    if (!cacheKey.empty() && succeeded(restoreFromCache(cacheKey, variantOp))) {
+      return;
+    }
+
     // TODO(benvanik): replace all this pipeline caching/lookup goo.
     for (auto &pipeline : pipelines_) {
       if (pipeline.targetBackend->name() == targetBackend->name()) {
@@ -76,12 +85,32 @@ class TranslateExecutableVariantsPass
               << variantOp.target();
           return signalPassFailure();
         }
+        if (!cacheKey.empty()) {
+          storeExecutableCache(
+              cacheKey, variantOp->getParentOfType<IREE::HAL::ExecutableOp>(),
+              {variantOp.getOperation()});
+        }
         break;  // Converted successfully; break out of loop.
       }
     }
   }
 
  private:
+  // Replaces the contents of |variantOp| with its cached translation.
+  LogicalResult restoreFromCache(StringRef cacheKey,
+                                 IREE::HAL::ExecutableVariantOp variantOp) {
+    Block cachedBlock;
+    if (failed(lookupExecutableCache(cacheKey, &getContext(), cachedBlock))) {
+      return failure();
+    }
+    auto cachedOps = cachedBlock.getOps<IREE::HAL::ExecutableVariantOp>();
+    if (!llvm::hasSingleElement(cachedOps)) return failure();
+    auto cachedOp = *cachedOps.begin();
+    variantOp->setAttrs(cachedOp->getAttrDictionary());
+    variantOp.body().takeBody(cachedOp.body());
+    return success();
+  }
+
   struct Pipeline {
     std::unique_ptr<TargetBackend> targetBackend;
     std::unique_ptr<OpPassManager> passManager;
@@ -0,0 +1,173 @@
+// RUN: iree-opt -split-input-file -iree-hal-assign-device-affinities %s | IreeFileCheck %s
+
+// Streams are partitioned into contiguous pipeline stages of similar cost.
+
+module attributes {hal.device.count = 2 : index} {
+
+flow.executable @ex0 {
+  flow.dispatch.entry @entry0
+  module {
+    func @entry0(%arg0: tensor<1024xf32>) -> tensor<1024xf32> {
+      return %arg0 : tensor<1024xf32>
+    }
+  }
+}
+
+// CHECK-LABEL: @pipelineStages
+func @pipelineStages(%arg0: tensor<1024xf32>) -> tensor<1024xf32> {
+  %c1024 = constant 1024 : index
+  //      CHECK: flow.ex.stream.fragment
+  // CHECK-SAME: attributes {hal.device.affinity = 0 : index}
+  %0 = flow.ex.stream.fragment(%c1024, %arg0) : (index, tensor<1024xf32>) -> tensor<1024xf32> =
+      (%arg1: index, %arg2: tensor<1024xf32>) -> tensor<1024xf32> {
+    %1 = flow.dispatch @ex0::@entry0[%arg1](%arg2) : (tensor<1024xf32>) -> tensor<1024xf32>
+    flow.return %1 : tensor<1024xf32>
+  }
+  //      CHECK: flow.ex.stream.fragment
+  // CHECK-SAME: attributes {hal.device.affinity = 0 : index}
+  %2 = flow.ex.stream.fragment(%0) : (tensor<1024xf32>) -> tensor<1024xf32> =
+      (%arg1: tensor<1024xf32>) -> tensor<1024xf32> {
+    %3 = flow.tensor.clone %arg1 : tensor<1024xf32>
+    flow.return %3 : tensor<1024xf32>
+  }
+  //      CHECK: flow.ex.stream.fragment
+  // CHECK-SAME: attributes {hal.device.affinity = 1 : index}
+  %4 = flow.ex.stream.fragment(%c1024, %2) : (index, tensor<1024xf32>) -> tensor<1024xf32> =
+      (%arg1: index, %arg2: tensor<1024xf32>) -> tensor<1024xf32> {
+    %5 = flow.dispatch @ex0::@entry0[%arg1](%arg2) : (tensor<1024xf32>) -> tensor<1024xf32>
+    flow.return %5 : tensor<1024xf32>
+  }
+  return %4 : tensor<1024xf32>
+}
+
+}
+
+// -----
+
+// Existing affinities are preserved.
+
+module attributes {hal.device.count = 2 : index} {
+
+// CHECK-LABEL: @existingAffinity
+func @existingAffinity(%arg0: tensor<4xf32>) -> tensor<4xf32> {
+  //      CHECK: flow.ex.stream.fragment
+  // CHECK-SAME: attributes {hal.device.affinity = 1 : index}
+  %0 = flow.ex.stream.fragment(%arg0) : (tensor<4xf32>) -> tensor<4xf32> attributes {hal.device.affinity = 1 : index} =
+      (%arg1: tensor<4xf32>) -> tensor<4xf32> {
+    %1 = flow.tensor.clone %arg1 : tensor<4xf32>
+    flow.return %1 : tensor<4xf32>
+  }
+  //      CHECK: flow.ex.stream.fragment
+  // CHECK-SAME: attributes {hal.device.affinity = 0 : index}
+  %2 = flow.ex.stream.fragment(%0) : (tensor<4xf32>) -> tensor<4xf32> =
+      (%arg1: tensor<4xf32>) -> tensor<4xf32> {
+    %3 = flow.tensor.clone %arg1 : tensor<4xf32>
+    flow.return %3 : tensor<4xf32>
+  }
+  //      CHECK: flow.ex.stream.fragment
+  // CHECK-SAME: attributes {hal.device.affinity = 1 : index}
+  %4 = flow.ex.stream.fragment(%2) : (tensor<4xf32>) -> tensor<4xf32> =
+      (%arg1: tensor<4xf32>) -> tensor<4xf32> {
+    %5 = flow.tensor.clone %arg1 : tensor<4xf32>
+    flow.return %5 : tensor<4xf32>
+  }
+  return %4 : tensor<4xf32>
+}
+
+}
+
+// -----
+
+// Modules without a device count are unchanged.
+
+// CHECK-LABEL: @singleDevice
+func @singleDevice(%arg0: tensor<4xf32>) -> tensor<4xf32> {
+  //  CHECK: flow.ex.stream.fragment
+  // CHECK-NOT: hal.device.affinity
+  %0 = flow.ex.stream.fragment(%arg0) : (tensor<4xf32>) -> tensor<4xf32> =
+      (%arg1: tensor<4xf32>) -> tensor<4xf32> {
+    %1 = flow.tensor.clone %arg1 : tensor<4xf32>
+    flow.return %1 : tensor<4xf32>
+  }
+  %2 = flow.ex.stream.fragment(%0) : (tensor<4xf32>) -> tensor<4xf32> =
+      (%arg1: tensor<4xf32>) -> tensor<4xf32> {
+    %3 = flow.tensor.clone %arg1 : tensor<4xf32>
+    flow.return %3 : tensor<4xf32>
+  }
+  return %2 : tensor<4xf32>
+}
+
+// -----
+
+// Streams are placed on the target device with the lowest estimated cost when
+// partitioning by target: dense work on the GPU and irregular or small work on
+// the CPU once the program has moved there.
+
+module attributes {
+  hal.device.count = 2 : index,
+  hal.device.partition_by_target,
+  hal.device.targets = [#hal.device.target<"vulkan">, #hal.device.target<"cpu">]
+} {
+
+flow.executable @matmul_ex {
+  flow.dispatch.entry @matmul
+  module {
+    func @matmul(%arg0: tensor<32x32xf32>) -> tensor<32x32xf32> {
+      %0 = linalg.matmul ins(%arg0, %arg0 : tensor<32x32xf32>, tensor<32x32xf32>) outs(%arg0 : tensor<32x32xf32>) -> tensor<32x32xf32>
+      return %0 : tensor<32x32xf32>
+    }
+  }
+}
+
+flow.executable @sort_ex {
+  flow.dispatch.entry @sort
+  module {
+    func @sort(%arg0: tensor<32x32xf32>) -> tensor<32x32xf32> {
+      %0 = linalg_ext.sort dimension(1) outs(%arg0 : tensor<32x32xf32>) {
+      ^bb0(%arg1: f32, %arg2: f32):  // no predecessors
+        %1 = cmpf ogt, %arg1, %arg2 : f32
+        linalg_ext.yield %1 : i1
+      } -> tensor<32x32xf32>
+      return %0 : tensor<32x32xf32>
+    }
+  }
+}
+
+flow.executable @add_ex {
+  flow.dispatch.entry @add
+  module {
+    func @add(%arg0: tensor<32x32xf32>) -> tensor<32x32xf32> {
+      return %arg0 : tensor<32x32xf32>
+    }
+  }
+}
+
+// CHECK-LABEL: @heterogeneous
+func @heterogeneous(%arg0: tensor<32x32xf32>) -> tensor<32x32xf32> {
+  %c4 = constant 4 : index
+  %c64 = constant 64 : index
+  //      CHECK: flow.ex.stream.fragment
+  // CHECK-SAME: attributes {hal.device.affinity = 0 : index}
+  %0 = flow.ex.stream.fragment(%c64, %arg0) : (index, tensor<32x32xf32>) -> tensor<32x32xf32> =
+      (%arg1: index, %arg2: tensor<32x32xf32>) -> tensor<32x32xf32> {
+    %1 = flow.dispatch @matmul_ex::@matmul[%arg1](%arg2) : (tensor<32x32xf32>) -> tensor<32x32xf32>
+    flow.return %1 : tensor<32x32xf32>
+  }
+  //      CHECK: flow.ex.stream.fragment
+  // CHECK-SAME: attributes {hal.device.affinity = 1 : index}
+  %2 = flow.ex.stream.fragment(%c64, %0) : (index, tensor<32x32xf32>) -> tensor<32x32xf32> =
+      (%arg1: index, %arg2: tensor<32x32xf32>) -> tensor<32x32xf32> {
+    %3 = flow.dispatch @sort_ex::@sort[%arg1](%arg2) : (tensor<32x32xf32>) -> tensor<32x32xf32>
+    flow.return %3 : tensor<32x32xf32>
+  }
+  //      CHECK: flow.ex.stream.fragment
+  // CHECK-SAME: attributes {hal.device.affinity = 1 : index}
+  %4 = flow.ex.stream.fragment(%c4, %2) : (index, tensor<32x32xf32>) -> tensor<32x32xf32> =
+      (%arg1: index, %arg2: tensor<32x32xf32>) -> tensor<32x32xf32> {
+    %5 = flow.dispatch @add_ex::@add[%arg1](%arg2) : (tensor<32x32xf32>) -> tensor<32x32xf32>
+    flow.return %5 : tensor<32x32xf32>
+  }
+  return %4 : tensor<32x32xf32>
+}
+
+}
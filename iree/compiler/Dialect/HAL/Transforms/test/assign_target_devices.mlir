@@ -1,6 +1,8 @@
 // RUN: iree-opt -split-input-file -pass-pipeline='iree-hal-assign-target-devices' %s | IreeFileCheck %s --check-prefix=CHECK --check-prefix=TARGET-0
 // RUN: iree-opt -split-input-file -pass-pipeline='iree-hal-assign-target-devices{targets=vulkan-spirv}' %s | IreeFileCheck %s --check-prefix=CHECK --check-prefix=TARGET-1
 // RUN: iree-opt -split-input-file -pass-pipeline='iree-hal-assign-target-devices{targets=vulkan-spirv,vmvx}' %s | IreeFileCheck %s --check-prefix=CHECK --check-prefix=TARGET-2
+// RUN: iree-opt -split-input-file -pass-pipeline='iree-hal-assign-target-devices{targets=vmvx device-count=2}' %s | IreeFileCheck %s --check-prefix=COUNT-2
+// RUN: iree-opt -split-input-file -pass-pipeline='iree-hal-assign-target-devices{targets=vulkan-spirv,vmvx partition-by-target unified-memory}' %s | IreeFileCheck %s --check-prefix=PARTITION
 
 // TARGET-1: #device_target_vulkan = #hal.device.target<"vulkan"
 
@@ -13,14 +15,25 @@
 // TARGET-1-SAME: hal.device.targets = [#device_target_vulkan]
 // TARGET-2: @module attributes {
 // TARGET-2-SAME: hal.device.targets = [#device_target_vulkan, #device_target_vmvx]}
+// COUNT-2: @module attributes {
+// COUNT-2-SAME: hal.device.count = 2 : index
+// COUNT-2-SAME: hal.device.targets = [#device_target_vmvx]}
+// PARTITION: @module attributes {
+// PARTITION-SAME: hal.device.count = 2 : index
+// PARTITION-SAME: hal.device.partition_by_target
+// PARTITION-SAME: hal.device.targets = [#device_target_vulkan, #device_target_vmvx]
+// PARTITION-SAME: hal.device.unified_memory
 module @module {}
 
 // -----
 
-// The pass is a no-op when targets are already specified.
+// The pass does not change targets that are already specified. The device
+// count is still recorded.
 
 // CHECK: #device_target_foo = #hal.device.target<"foo"
 // CHECK: module @module attributes {hal.device.targets = [#device_target_foo]}
+// COUNT-2: module @module attributes {hal.device.count = 2 : index, hal.device.targets = [#device_target_foo]}
+// PARTITION: module @module attributes {hal.device.partition_by_target, hal.device.targets = [#device_target_foo]}
 module @module attributes {
   hal.device.targets = [#hal.device.target<"foo">]
 } {}
@@ -0,0 +1,63 @@
+// RUN: iree-opt -split-input-file -iree-hal-defer-stream-awaits %s | IreeFileCheck %s
+
+// Each iteration of the loop is submitted while the prior one is in flight.
+
+// CHECK-LABEL: @deferAcrossLoop
+//  CHECK-SAME: (%[[CMD:.+]]: !hal.command_buffer, %[[COUNT:.+]]: index)
+func @deferAcrossLoop(%cmd: !hal.command_buffer, %count: index) {
+  // CHECK: %[[SIGNALED:.+]] = hal.semaphore.create device(%{{.+}} : !hal.device) initial(%[[C0:.+]]) : !hal.semaphore
+  %device = hal.ex.shared_device : !hal.device
+  %c0 = constant 0 : index
+  %c1 = constant 1 : index
+  // CHECK: br ^bb1(%{{.+}}, %[[SIGNALED]], %[[C0]] : index, !hal.semaphore, index)
+  br ^bb1(%c0 : index)
+// CHECK: ^bb1(%[[I:.+]]: index, %[[HEADER_SEM:.+]]: !hal.semaphore, %[[HEADER_VALUE:.+]]: index):
+^bb1(%i: index):
+  %cond = cmpi slt, %i, %count : index
+  //      CHECK: cond_br %{{.+}}, ^bb2(%[[HEADER_SEM]], %[[HEADER_VALUE]] : !hal.semaphore, index),
+  // CHECK-SAME:   ^bb3(%[[HEADER_SEM]], %[[HEADER_VALUE]] : !hal.semaphore, index)
+  cond_br %cond, ^bb2, ^bb3
+// CHECK: ^bb2(%[[BODY_SEM:.+]]: !hal.semaphore, %[[BODY_VALUE:.+]]: index):
+^bb2:
+  // The prior iteration is waited on by the device.
+  // CHECK: %[[SEM:.+]] = hal.semaphore.create
+  %sem = hal.semaphore.create device(%device : !hal.device) initial(%c0) : !hal.semaphore
+  // CHECK-NEXT: hal.device.queue.submit<%{{.+}} : !hal.device> wait([%[[BODY_SEM]]], [%[[BODY_VALUE]]]) signal(%[[SEM]], %c1) commands(%[[CMD]])
+  hal.device.queue.submit<%device : !hal.device> signal(%sem, %c1) commands(%cmd)
+  // CHECK-NOT: hal.semaphore.await
+  %status = hal.semaphore.await<%sem : !hal.semaphore> until(%c1) : i32
+  util.status.check_ok %status, "stream execution failed"
+  %next = addi %i, %c1 : index
+  // CHECK: br ^bb1(%{{.+}}, %[[SEM]], %c1 : index, !hal.semaphore, index)
+  br ^bb1(%next : index)
+// CHECK: ^bb3(%[[EXIT_SEM:.+]]: !hal.semaphore, %[[EXIT_VALUE:.+]]: index):
+^bb3:
+  // The host waits for the last iteration before returning.
+  // CHECK-NEXT: %[[STATUS:.+]] = hal.semaphore.await<%[[EXIT_SEM]] : !hal.semaphore> until(%[[EXIT_VALUE]])
+  // CHECK-NEXT: util.status.check_ok %[[STATUS]]
+  // CHECK-NEXT: return
+  return
+}
+
+// -----
+
+// Host readback in the successor waits on the submission before it.
+
+// CHECK-LABEL: @awaitBeforeReadback
+func @awaitBeforeReadback(%cmd: !hal.command_buffer, %buffer: !hal.buffer) -> i32 {
+  %device = hal.ex.shared_device : !hal.device
+  %c0 = constant 0 : index
+  %c1 = constant 1 : index
+  %sem = hal.semaphore.create device(%device : !hal.device) initial(%c0) : !hal.semaphore
+  hal.device.queue.submit<%device : !hal.device> signal(%sem, %c1) commands(%cmd)
+  %status = hal.semaphore.await<%sem : !hal.semaphore> until(%c1) : i32
+  util.status.check_ok %status, "stream execution failed"
+  br ^bb1
+// CHECK: ^bb1(%[[SEM:.+]]: !hal.semaphore, %[[VALUE:.+]]: index):
+^bb1:
+  // CHECK-NEXT: %[[STATUS:.+]] = hal.semaphore.await<%[[SEM]] : !hal.semaphore> until(%[[VALUE]])
+  // CHECK-NEXT: util.status.check_ok %[[STATUS]]
+  // CHECK-NEXT: hal.buffer.load
+  %value = hal.buffer.load<%buffer : !hal.buffer>[%c0] : i32
+  return %value : i32
+}
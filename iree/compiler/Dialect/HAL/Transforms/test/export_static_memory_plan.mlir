@@ -0,0 +1,53 @@
+// RUN: iree-opt -split-input-file -iree-hal-export-static-memory-plan -verify-diagnostics %s | IreeFileCheck %s
+
+module attributes {
+  hal.device.targets = [
+    #hal.device.target<"cpu", {
+      buffer_constraints = #hal.buffer_constraints<max_allocation_size = 1073741824, min_buffer_offset_alignment = 32, max_buffer_range = 1073741824, min_buffer_range_alignment = 16>
+    }>
+  ]
+} {
+
+// CHECK-LABEL: func private @initializer
+func private @initializer(%allocator: !hal.allocator) -> !hal.buffer {
+  %c100 = constant 100 : index
+  // 100 -> 128 bytes of constants.
+  %buffer = hal.allocator.allocate<%allocator : !hal.allocator> type("DeviceLocal") usage("Constant|Transfer") : !hal.buffer{%c100}
+  return %buffer : !hal.buffer
+}
+
+// CHECK-LABEL: func private @helper
+func private @helper(%allocator: !hal.allocator) -> !hal.buffer {
+  %c64 = constant 64 : index
+  // 64 bytes of transients.
+  %buffer = hal.allocator.allocate<%allocator : !hal.allocator> type("Transient|DeviceLocal") usage("Dispatch|Transfer") : !hal.buffer{%c64}
+  return %buffer : !hal.buffer
+}
+
+// CHECK-LABEL: func @small
+// CHECK-SAME: iree.reflection = {iree.abi = "{}", iree.memory_plan = "constant=128,transient=224,io=32,alignment=32"}
+func @small(%allocator: !hal.allocator) -> !hal.buffer attributes {iree.reflection = {iree.abi = "{}"}} {
+  %c16 = constant 16 : index
+  %buffer = hal.allocator.allocate<%allocator : !hal.allocator> type("DeviceLocal") usage("Dispatch|Transfer") : !hal.buffer{%c16}
+  return %buffer : !hal.buffer
+}
+
+// CHECK-LABEL: func @large
+// CHECK-SAME: iree.reflection = {iree.memory_plan = "constant=128,transient=224,io=32,alignment=32"}
+func @large(%allocator: !hal.allocator) -> !hal.buffer {
+  %c160 = constant 160 : index
+  // 160 bytes locally and 64 bytes in @helper.
+  %buffer = hal.allocator.allocate<%allocator : !hal.allocator> type("Transient|DeviceLocal") usage("Dispatch|Transfer") : !hal.buffer{%c160}
+  %0 = call @helper(%allocator) : (!hal.allocator) -> !hal.buffer
+  return %0 : !hal.buffer
+}
+
+}
+
+// -----
+
+func @dynamic(%allocator: !hal.allocator, %size: index) -> !hal.buffer {
+  // expected-error@+1 {{has a dynamic size}}
+  %buffer = hal.allocator.allocate<%allocator : !hal.allocator> type("DeviceLocal") usage("Dispatch|Transfer") : !hal.buffer{%size}
+  return %buffer : !hal.buffer
+}
@@ -0,0 +1,95 @@
+// RUN: iree-opt -split-input-file -iree-hal-fuse-dispatch-pushes %s | IreeFileCheck %s
+
+// CHECK-LABEL: @fusePushes
+//  CHECK-SAME: (%[[CMD:.+]]: !hal.command_buffer,
+//  CHECK-SAME: %[[LAYOUT:.+]]: !hal.executable_layout,
+//  CHECK-SAME: %[[EXE:.+]]: !hal.executable,
+//  CHECK-SAME: %[[VALUE:.+]]: i32,
+//  CHECK-SAME: %[[BUFFER:.+]]: !hal.buffer,
+//  CHECK-SAME: %[[WORKLOAD:.+]]: index)
+func @fusePushes(%cmd: !hal.command_buffer, %layout: !hal.executable_layout, %exe: !hal.executable, %value: i32, %buffer: !hal.buffer, %workload: index) {
+  %c0 = constant 0 : index
+  %c1 = constant 1 : index
+  %c128 = constant 128 : index
+  // CHECK-NOT: hal.command_buffer.push_descriptor_set
+  hal.command_buffer.push_descriptor_set<%cmd : !hal.command_buffer>
+      layout(%layout : !hal.executable_layout)[%c0]
+      bindings([
+        %c0 = (%buffer : !hal.buffer)[%c0, %c128]
+      ])
+  // CHECK-NOT: hal.command_buffer.push_constants
+  hal.command_buffer.push_constants<%cmd : !hal.command_buffer>
+      layout(%layout : !hal.executable_layout)
+      offset(1)
+      values([%value]) : i32
+  // Side-effect free workgroup count calculations do not prevent fusion.
+  // CHECK: %[[X:.+]] = addi
+  %x = addi %workload, %c1 : index
+  //      CHECK: hal.command_buffer.dispatch.push<%[[CMD]] : !hal.command_buffer>
+  // CHECK-SAME:   layout(%[[LAYOUT]] : !hal.executable_layout)
+  // CHECK-SAME:   target(%[[EXE]] : !hal.executable)[0]
+  // CHECK-SAME:   workgroups([%[[X]], %c1, %c1])
+  // CHECK-SAME:   constants(1, [%[[VALUE]]])
+  // CHECK-SAME:   bindings(%c0, [
+  // CHECK-NEXT:     %c0 = (%[[BUFFER]] : !hal.buffer)[%c0, %c128]
+  // CHECK-NEXT:   ])
+  // CHECK-NOT: hal.command_buffer.dispatch<
+  hal.command_buffer.dispatch<%cmd : !hal.command_buffer>
+      target(%exe : !hal.executable)[0]
+      workgroups([%x, %c1, %c1])
+  return
+}
+
+// -----
+
+// Dispatches without push constants are fused with their descriptor set.
+
+// CHECK-LABEL: @fuseDescriptorSetOnly
+func @fuseDescriptorSetOnly(%cmd: !hal.command_buffer, %layout: !hal.executable_layout, %exe: !hal.executable, %buffer: !hal.buffer) {
+  %c0 = constant 0 : index
+  %c1 = constant 1 : index
+  %c128 = constant 128 : index
+  hal.command_buffer.push_descriptor_set<%cmd : !hal.command_buffer>
+      layout(%layout : !hal.executable_layout)[%c0]
+      bindings([
+        %c0 = (%buffer : !hal.buffer)[%c0, %c128]
+      ])
+  //      CHECK: hal.command_buffer.dispatch.push
+  // CHECK-SAME:   constants(0, [])
+  hal.command_buffer.dispatch<%cmd : !hal.command_buffer>
+      target(%exe : !hal.executable)[0]
+      workgroups([%c1, %c1, %c1])
+  return
+}
+
+// -----
+
+// Pushes separated from the dispatch by other commands are not fused and
+// dispatches reusing previously pushed state are left as-is.
+
+// CHECK-LABEL: @noFusionAcrossCommands
+func @noFusionAcrossCommands(%cmd: !hal.command_buffer, %layout: !hal.executable_layout, %exe: !hal.executable, %buffer: !hal.buffer) {
+  %c0 = constant 0 : index
+  %c1 = constant 1 : index
+  %c128 = constant 128 : index
+  // CHECK: hal.command_buffer.push_descriptor_set
+  hal.command_buffer.push_descriptor_set<%cmd : !hal.command_buffer>
+      layout(%layout : !hal.executable_layout)[%c0]
+      bindings([
+        %c0 = (%buffer : !hal.buffer)[%c0, %c128]
+      ])
+  // CHECK-NEXT: hal.command_buffer.execution_barrier
+  hal.command_buffer.execution_barrier<%cmd : !hal.command_buffer>
+      source("Dispatch|CommandRetire")
+      target("CommandIssue|Dispatch")
+      flags("None")
+  // CHECK-NEXT: hal.command_buffer.dispatch<
+  hal.command_buffer.dispatch<%cmd : !hal.command_buffer>
+      target(%exe : !hal.executable)[0]
+      workgroups([%c1, %c1, %c1])
+  // CHECK-NEXT: hal.command_buffer.dispatch<
+  hal.command_buffer.dispatch<%cmd : !hal.command_buffer>
+      target(%exe : !hal.executable)[0]
+      workgroups([%c1, %c1, %c1])
+  return
+}
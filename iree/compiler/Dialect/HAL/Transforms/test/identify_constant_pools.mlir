@@ -63,3 +63,25 @@ func @skip_indirect_variables() -> (tensor<128xf32>) {
   %1 = util.global.load.indirect %0 : !util.ptr<tensor<128xf32>> -> tensor<128xf32>
   return %1 : tensor<128xf32>
 }
+
+// -----
+
+//      CHECK: hal.constant_pool @_const_pool
+// CHECK-NEXT:   hal.constant_pool.value @cst_a = dense<[2.100000e+00, 3.200000e+00, 4.300000e+00, 5.400000e+00]> : tensor<4xf32>
+// CHECK-NEXT:   hal.constant_pool_end
+util.global private @cst_a = dense<[2.1, 3.2, 4.3, 5.4]> : tensor<4xf32>
+util.global private @cst_b = dense<[2.1, 3.2, 4.3, 5.4]> : tensor<4xf32>
+
+// CHECK-LABEL: func @dedupe_a
+func @dedupe_a() -> tensor<4xf32> {
+  // CHECK-NEXT: = hal.constant_pool.load @_const_pool::@cst_a : tensor<4xf32>
+  %0 = util.global.load @cst_a : tensor<4xf32>
+  return %0 : tensor<4xf32>
+}
+
+// CHECK-LABEL: func @dedupe_b
+func @dedupe_b() -> tensor<4xf32> {
+  // CHECK-NEXT: = hal.constant_pool.load @_const_pool::@cst_a : tensor<4xf32>
+  %0 = util.global.load @cst_b : tensor<4xf32>
+  return %0 : tensor<4xf32>
+}
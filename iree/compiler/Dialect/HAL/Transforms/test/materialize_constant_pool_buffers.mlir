@@ -74,3 +74,32 @@ hal.constant_pool @pool attributes {buffer_constraints = #hal.buffer_constraints
 //      CHECK: hal.command_buffer.fill_buffer<%cmd : !hal.command_buffer>
 // CHECK-SAME:   target(%[[BUFFER]] : !hal.buffer)[%c32, %c32_0]
 // CHECK-SAME:   pattern(%c1234567890_i32 : i32)
+
+// -----
+
+// CHECK-LABEL: hal.constant_pool @compressed_variable_init
+hal.constant_pool @compressed_variable_init attributes {buffer_constraints = #hal.buffer_constraints<max_allocation_size = 1073741824, min_buffer_offset_alignment = 32, max_buffer_range = 134217728, min_buffer_range_alignment = 4>} {
+  // CHECK-NEXT: @cst0 {{.+}} -> @compressed_variable_init_storage_buffer[#hal.byte_range<0, 288>]
+  hal.constant_pool.span @cst0 : tensor<72xi32> = @_storage[#hal.byte_range<0, 288>]
+  hal.constant_storage @_storage = dense<[1, 0, 0, 0, 2, 0, 0, 0]> : vector<8xi8> attributes {fills = dense<[[4, 280, 0]]> : tensor<1x3xi64>}
+}
+
+//      CHECK: func private @compressed_variable_init_storage_buffer_initializer() -> !hal.buffer
+//      CHECK: %[[STORAGE:.+]] = hal.constant_storage.lookup @compressed_variable_init::@_storage : !util.byte_buffer
+//      CHECK: %[[MAPPED:.+]] = hal.allocator.map<%allocator : !hal.allocator>
+// CHECK-SAME:   source(%[[STORAGE]] : !util.byte_buffer)[%c0, %c8]
+//      CHECK: %[[BUFFER:.+]] = hal.allocator.allocate<%allocator : !hal.allocator>
+// CHECK-SAME:   : !hal.buffer{%c288}
+//      CHECK: hal.command_buffer.copy_buffer<%cmd : !hal.command_buffer>
+// CHECK-SAME:   source(%[[MAPPED]] : !hal.buffer)[%c0
+// CHECK-SAME:   target(%[[BUFFER]] : !hal.buffer)[%c0
+// CHECK-SAME:   length(%c4)
+//      CHECK: hal.command_buffer.fill_buffer<%cmd : !hal.command_buffer>
+// CHECK-SAME:   target(%[[BUFFER]] : !hal.buffer)[%c4{{.*}}, %c280]
+// CHECK-SAME:   pattern(%c0_i32 : i32)
+//      CHECK: hal.command_buffer.copy_buffer<%cmd : !hal.command_buffer>
+// CHECK-SAME:   source(%[[MAPPED]] : !hal.buffer)[%c4
+// CHECK-SAME:   target(%[[BUFFER]] : !hal.buffer)[%c284]
+// CHECK-SAME:   length(%c4
+//      CHECK: hal.ex.submit_and_wait
+//      CHECK: return %[[BUFFER]] : !hal.buffer
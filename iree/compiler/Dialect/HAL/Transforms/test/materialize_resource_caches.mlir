@@ -175,3 +175,76 @@ func @exeLookup(%device : !hal.device) -> !hal.executable {
 }
 
 }
+
+// -----
+
+// Variants of the same format requiring device features are matched in order.
+
+module attributes {hal.device.targets = [#hal.device.target<"cpu">]} {
+
+hal.executable @exe {
+  hal.interface @interface0 {
+    hal.interface.binding @s0b0, set=0, binding=0, type="StorageBuffer", access="Read|Write"
+  }
+  hal.executable.variant @embedded_elf_x86_64_x86_64_v3, target = #hal.executable.target<"llvm", "embedded-elf-x86_64", {cpu = "x86-64-v3", cpu_features = "", required_features = "x86-64-v3"}> {
+    hal.executable.entry_point @entry0 attributes {
+      interface = @interface0,
+      ordinal = 0 : index
+    }
+  }
+  hal.executable.variant @embedded_elf_x86_64, target = #hal.executable.target<"llvm", "embedded-elf-x86_64"> {
+    hal.executable.entry_point @entry0 attributes {
+      interface = @interface0,
+      ordinal = 0 : index
+    }
+  }
+}
+
+// CHECK: func private @_executable_exe_initializer() -> !hal.executable {
+// CHECK:   %[[DEV:.+]] = hal.ex.shared_device : !hal.device
+// CHECK:   %[[RET:.+]] = hal.device.switch<%[[DEV]] : !hal.device> -> !hal.executable
+// CHECK:   #hal.match.all<[#hal.device.match.executable.format<"embedded-elf-x86_64">, #hal.device.match.feature<"x86-64-v3">]> {
+// CHECK:     %[[EXE_V3:.+]] = hal.executable.create
+// CHECK-SAME:  target(@exe::@embedded_elf_x86_64_x86_64_v3)
+// CHECK:     hal.return %[[EXE_V3]] : !hal.executable
+// CHECK:   },
+// CHECK:   #hal.device.match.executable.format<"embedded-elf-x86_64"> {
+// CHECK:     %[[EXE:.+]] = hal.executable.create
+// CHECK-SAME:  target(@exe::@embedded_elf_x86_64)
+// CHECK:     hal.return %[[EXE]] : !hal.executable
+// CHECK:   },
+
+}
+
+// -----
+
+// Lookups on devices other than the shared device are cached per device.
+
+// CHECK: util.global private @_descriptor_set_layout_0 initializer(@_descriptor_set_layout_0_initializer) : !hal.descriptor_set_layout
+// CHECK: util.global private @_descriptor_set_layout_1_device1 initializer(@_descriptor_set_layout_1_device1_initializer) : !hal.descriptor_set_layout
+// CHECK-NEXT: func private @_descriptor_set_layout_1_device1_initializer() -> !hal.descriptor_set_layout {
+// CHECK-NEXT:   %device = hal.ex.device<1> : !hal.device
+// CHECK-NEXT:   %descriptor_set_layout = hal.descriptor_set_layout.create
+// CHECK-SAME:     device(%device : !hal.device)
+
+// CHECK-LABEL: @perDeviceDescriptorSetLayoutLookup
+func @perDeviceDescriptorSetLayoutLookup() -> (!hal.descriptor_set_layout, !hal.descriptor_set_layout) {
+  %device0 = hal.ex.shared_device : !hal.device
+  %device1 = hal.ex.device<1> : !hal.device
+  // CHECK: %[[LAYOUT0:.+]] = util.global.load @_descriptor_set_layout_0 : !hal.descriptor_set_layout
+  %0 = hal.descriptor_set_layout.lookup device(%device0 : !hal.device)
+                                        usage(PushOnly)
+                                        bindings([
+    #hal.descriptor_set_layout_binding<0, "StorageBuffer", "Read">,
+    #hal.descriptor_set_layout_binding<1, "StorageBuffer", "Write">
+  ]) : !hal.descriptor_set_layout
+  // CHECK: %[[LAYOUT1:.+]] = util.global.load @_descriptor_set_layout_1_device1 : !hal.descriptor_set_layout
+  %1 = hal.descriptor_set_layout.lookup device(%device1 : !hal.device)
+                                        usage(PushOnly)
+                                        bindings([
+    #hal.descriptor_set_layout_binding<0, "StorageBuffer", "Read">,
+    #hal.descriptor_set_layout_binding<1, "StorageBuffer", "Write">
+  ]) : !hal.descriptor_set_layout
+  // CHECK: return %[[LAYOUT0]], %[[LAYOUT1]]
+  return %0, %1 : !hal.descriptor_set_layout, !hal.descriptor_set_layout
+}
@@ -30,3 +30,26 @@ func @device_matchers(%device : !hal.device) -> (i1, i1, i1, i1) {
 
   return %id0_a, %id0_b, %id1_a, %id1_b : i1, i1, i1, i1
 }
+
+// -----
+
+// Queries are memoized per device.
+
+//      CHECK: util.global private @_device_query_0 initializer(@_device_query_0_initializer) : i1
+//      CHECK: func private @_device_query_0_initializer() -> i1
+// CHECK-NEXT:   %[[DEVICE:.+]] = hal.ex.shared_device : !hal.device
+//      CHECK: util.global private @_device_query_1 initializer(@_device_query_1_initializer) : i1
+//      CHECK: func private @_device_query_1_initializer() -> i1
+// CHECK-NEXT:   %[[DEVICE:.+]] = hal.ex.device<1> : !hal.device
+// CHECK-NEXT:   = hal.device.query<%[[DEVICE]] : !hal.device> key("hal.device.id" :: "vulkan*") : i1, i1 = false
+
+// CHECK-LABEL: func @per_device_matchers
+func @per_device_matchers() -> (i1, i1) {
+  %device0 = hal.ex.shared_device : !hal.device
+  %device1 = hal.ex.device<1> : !hal.device
+  // CHECK: = util.global.load @_device_query_0 : i1
+  %ok0, %id0 = hal.device.query<%device0 : !hal.device> key("hal.device.id" :: "vulkan*") : i1, i1 = false
+  // CHECK: = util.global.load @_device_query_1 : i1
+  %ok1, %id1 = hal.device.query<%device1 : !hal.device> key("hal.device.id" :: "vulkan*") : i1, i1 = false
+  return %id0, %id1 : i1, i1
+}
@@ -0,0 +1,80 @@
+// RUN: iree-opt -split-input-file -iree-hal-memoize-shape-calculations %s | IreeFileCheck %s
+
+// CHECK-DAG: util.global private mutable @_dispatch_counts_shape_memo_valid = false
+// CHECK-DAG: util.global private mutable @_dispatch_counts_shape_memo_key_0 : index
+// CHECK-DAG: util.global private mutable @_dispatch_counts_shape_memo_key_1 : index
+// CHECK-DAG: util.global private mutable @_dispatch_counts_shape_memo_value_0 : index
+// CHECK-DAG: util.global private mutable @_dispatch_counts_shape_memo_value_1 : index
+
+func private @sink(index, index)
+
+// CHECK-LABEL: func @dispatch_counts
+// CHECK-SAME: (%[[ARG0:.+]]: index, %[[ARG1:.+]]: index)
+func @dispatch_counts(%arg0: index, %arg1: index) {
+  // CHECK-DAG: %[[C1:.+]] = constant 1 : index
+  // CHECK-DAG: %[[C4:.+]] = constant 4 : index
+  // CHECK-DAG: %[[C8:.+]] = constant 8 : index
+  // CHECK: %[[VALID:.+]] = util.global.load @_dispatch_counts_shape_memo_valid : i1
+  // CHECK-NEXT: %[[KEY0:.+]] = util.global.load @_dispatch_counts_shape_memo_key_0 : index
+  // CHECK-NEXT: %[[EQ0:.+]] = cmpi eq, %[[ARG0]], %[[KEY0]] : index
+  // CHECK-NEXT: %[[HIT0:.+]] = and %[[VALID]], %[[EQ0]] : i1
+  // CHECK-NEXT: %[[KEY1:.+]] = util.global.load @_dispatch_counts_shape_memo_key_1 : index
+  // CHECK-NEXT: %[[EQ1:.+]] = cmpi eq, %[[ARG1]], %[[KEY1]] : index
+  // CHECK-NEXT: %[[HIT1:.+]] = and %[[HIT0]], %[[EQ1]] : i1
+  // CHECK-NEXT: cond_br %[[HIT1]], ^bb2, ^bb1
+  %c1 = constant 1 : index
+  %c4 = constant 4 : index
+  %c8 = constant 8 : index
+
+  // CHECK: ^bb1:
+  // CHECK-NEXT: %[[X0:.+]] = addi %[[ARG0]], %[[C8]] : index
+  // CHECK-NEXT: %[[X1:.+]] = subi %[[X0]], %[[C1]] : index
+  // CHECK-NEXT: %[[X:.+]] = divi_unsigned %[[X1]], %[[C8]] : index
+  // CHECK-NEXT: %[[Y0:.+]] = muli %[[ARG0]], %[[ARG1]] : index
+  // CHECK-NEXT: %[[Y1:.+]] = addi %[[Y0]], %[[C4]] : index
+  // CHECK-NEXT: %[[Y2:.+]] = subi %[[Y1]], %[[C1]] : index
+  // CHECK-NEXT: %[[Y:.+]] = divi_unsigned %[[Y2]], %[[C4]] : index
+  // CHECK-NEXT: util.global.store %[[ARG0]], @_dispatch_counts_shape_memo_key_0 : index
+  // CHECK-NEXT: util.global.store %[[ARG1]], @_dispatch_counts_shape_memo_key_1 : index
+  // CHECK-NEXT: util.global.store %[[X]], @_dispatch_counts_shape_memo_value_0 : index
+  // CHECK-NEXT: util.global.store %[[Y]], @_dispatch_counts_shape_memo_value_1 : index
+  // CHECK-NEXT: %[[TRUE:.+]] = constant true
+  // CHECK-NEXT: util.global.store %[[TRUE]], @_dispatch_counts_shape_memo_valid : i1
+  // CHECK-NEXT: br ^bb3(%[[X]], %[[Y]] : index, index)
+  %0 = addi %arg0, %c8 : index
+  %1 = subi %0, %c1 : index
+  %2 = divi_unsigned %1, %c8 : index
+  %3 = muli %arg0, %arg1 : index
+  %4 = addi %3, %c4 : index
+  %5 = subi %4, %c1 : index
+  %6 = divi_unsigned %5, %c4 : index
+
+  // CHECK: ^bb2:
+  // CHECK-NEXT: %[[CACHED_X:.+]] = util.global.load @_dispatch_counts_shape_memo_value_0 : index
+  // CHECK-NEXT: %[[CACHED_Y:.+]] = util.global.load @_dispatch_counts_shape_memo_value_1 : index
+  // CHECK-NEXT: br ^bb3(%[[CACHED_X]], %[[CACHED_Y]] : index, index)
+
+  // CHECK: ^bb3(%[[COUNT_X:.+]]: index, %[[COUNT_Y:.+]]: index):
+  // CHECK-NEXT: call @sink(%[[COUNT_X]], %[[COUNT_Y]])
+  call @sink(%2, %6) : (index, index) -> ()
+  // CHECK-NEXT: return
+  return
+}
+
+// -----
+
+// Calculations cheaper than checking the cache are left in place.
+
+// CHECK-NOT: util.global
+
+func private @sink(index)
+
+// CHECK-LABEL: func @cheap_calculation
+func @cheap_calculation(%arg0: index) {
+  %c4 = constant 4 : index
+  // CHECK: %[[X:.+]] = muli
+  %0 = muli %arg0, %c4 : index
+  // CHECK-NEXT: call @sink(%[[X]])
+  call @sink(%0) : (index) -> ()
+  return
+}
@@ -127,3 +127,95 @@ func @packMixedStaticDynamic(%allocator: !hal.allocator, %size_a: index, %size_b
 }
 
 }
+
+// -----
+
+module attributes {
+  hal.device.targets = [
+    #hal.device.target<"cpu", {
+      buffer_constraints = #hal.buffer_constraints<max_allocation_size = 1073741824, min_buffer_offset_alignment = 16, max_buffer_range = 1073741824, min_buffer_range_alignment = 16>
+    }>
+  ]
+} {
+
+// Transient allocations of streams that execute in sequence are merged into a
+// single allocation that is reused across the streams.
+
+// CHECK-LABEL: @coalesceTransients
+// CHECK-SAME: %[[DEVICE:.+]]: !hal.device, %[[ALLOCATOR:.+]]: !hal.allocator
+func @coalesceTransients(%device: !hal.device, %allocator: !hal.allocator, %cmd: !hal.command_buffer, %semaphore: !hal.semaphore) ->
+    (!hal.buffer, !hal.buffer, index, index, index) {
+  %c1 = constant 1 : index
+  %c100 = constant 100 : index
+  %t0:3 = hal.allocator.pack<%allocator : !hal.allocator> slices({
+    [0, 1] = %c100,  // +0
+    [1, 2] = %c100,  // +112
+  }) : index
+  // CHECK: %[[BUFFER:.+]] = hal.allocator.allocate<%[[ALLOCATOR]] : !hal.allocator>
+  // CHECK-SAME: : !hal.buffer{%c224}
+  %buffer0 = hal.allocator.allocate<%allocator : !hal.allocator>
+      type("Transient|DeviceLocal") usage("Dispatch|Transfer") : !hal.buffer{%t0#0}
+  hal.ex.submit %device, %cmd signal(%semaphore, %c1)
+  %status = hal.semaphore.await<%semaphore : !hal.semaphore> until(%c1) : i32
+  util.status.check_ok %status
+  %c200 = constant 200 : index
+  %t1:2 = hal.allocator.pack<%allocator : !hal.allocator> slices({
+    [0, 3] = %c200,  // +0 (reuses the storage of the prior stream)
+  }) : index
+  // CHECK-NOT: hal.allocator.allocate
+  %buffer1 = hal.allocator.allocate<%allocator : !hal.allocator>
+      type("Transient|DeviceLocal") usage("Dispatch|Transfer") : !hal.buffer{%t1#0}
+  hal.ex.submit_and_wait %device, %cmd
+  // CHECK: return %[[BUFFER]], %[[BUFFER]], %c0, %c112, %c0
+  return %buffer0, %buffer1, %t0#1, %t0#2, %t1#1 : !hal.buffer, !hal.buffer, index, index, index
+}
+
+}
+
+// -----
+
+module attributes {
+  hal.device.targets = [
+    #hal.device.target<"cpu", {
+      buffer_constraints = #hal.buffer_constraints<max_allocation_size = 1073741824, min_buffer_offset_alignment = 16, max_buffer_range = 1073741824, min_buffer_range_alignment = 16>
+    }>
+  ]
+} {
+
+// Awaiting a queue submission also completes the submissions it waited on
+// such that the transients of a chain of streams can be reused afterwards.
+
+// CHECK-LABEL: @coalesceChainedTransients
+// CHECK-SAME: %[[DEVICE:.+]]: !hal.device, %[[ALLOCATOR:.+]]: !hal.allocator
+func @coalesceChainedTransients(%device: !hal.device, %allocator: !hal.allocator, %cmd: !hal.command_buffer, %semaphore0: !hal.semaphore, %semaphore1: !hal.semaphore) ->
+    (!hal.buffer, !hal.buffer, !hal.buffer) {
+  %c1 = constant 1 : index
+  %c100 = constant 100 : index
+  %t0:2 = hal.allocator.pack<%allocator : !hal.allocator> slices({
+    [0, 1] = %c100,
+  }) : index
+  // CHECK: %[[BUFFER0:.+]] = hal.allocator.allocate<%[[ALLOCATOR]] : !hal.allocator>
+  %buffer0 = hal.allocator.allocate<%allocator : !hal.allocator>
+      type("Transient|DeviceLocal") usage("Dispatch|Transfer") : !hal.buffer{%t0#0}
+  hal.device.queue.submit<%device : !hal.device> signal(%semaphore0, %c1) commands(%cmd)
+  // The first stream is still in flight so the second cannot reuse its storage.
+  %t1:2 = hal.allocator.pack<%allocator : !hal.allocator> slices({
+    [0, 1] = %c100,
+  }) : index
+  // CHECK: %[[BUFFER1:.+]] = hal.allocator.allocate<%[[ALLOCATOR]] : !hal.allocator>
+  %buffer1 = hal.allocator.allocate<%allocator : !hal.allocator>
+      type("Transient|DeviceLocal") usage("Dispatch|Transfer") : !hal.buffer{%t1#0}
+  hal.device.queue.submit<%device : !hal.device> wait([%semaphore0], [%c1]) signal(%semaphore1, %c1) commands(%cmd)
+  %status = hal.semaphore.await<%semaphore1 : !hal.semaphore> until(%c1) : i32
+  util.status.check_ok %status
+  %t2:2 = hal.allocator.pack<%allocator : !hal.allocator> slices({
+    [0, 1] = %c100,
+  }) : index
+  // CHECK-NOT: hal.allocator.allocate
+  %buffer2 = hal.allocator.allocate<%allocator : !hal.allocator>
+      type("Transient|DeviceLocal") usage("Dispatch|Transfer") : !hal.buffer{%t2#0}
+  // CHECK: return %[[BUFFER0]], %[[BUFFER1]], %[[BUFFER1]]
+  return %buffer0, %buffer1, %buffer2 : !hal.buffer, !hal.buffer, !hal.buffer
+}
+
+}
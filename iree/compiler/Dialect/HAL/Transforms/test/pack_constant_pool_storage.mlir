@@ -1,4 +1,5 @@
 // RUN: iree-opt -split-input-file -iree-hal-pack-constant-pool-storage %s | IreeFileCheck %s
+// RUN: iree-opt -split-input-file -iree-hal-pack-constant-pool-storage -iree-hal-compress-constant-pool-storage %s | IreeFileCheck %s --check-prefix=COMPRESS
 
 // CHECK-LABEL: hal.constant_pool @pool
 hal.constant_pool @pool attributes {
@@ -34,3 +35,40 @@ hal.constant_pool @multi_storage attributes {
   // CHECK-NEXT: hal.constant_storage @_storage = dense<[102, 102, 6, 64, -51, -52, 76, 64, -102, -103, -119, 64, -51, -52, -84, 64]> : vector<16xi8>
   // CHECK-NEXT: hal.constant_storage @_storage_0 = dense<[6, 7, 8]> : vector<3xi8>
 }
+
+// -----
+
+// CHECK-LABEL: hal.constant_pool @dedupe
+hal.constant_pool @dedupe attributes {
+    buffer_constraints = #hal.buffer_constraints<max_allocation_size = 1073741824,
+                                                 min_buffer_offset_alignment = 16,
+                                                 max_buffer_range = 134217728,
+                                                 min_buffer_range_alignment = 4>
+  } {
+  // CHECK-DAG: hal.constant_pool.span @cst0 : tensor<4xf32> = @_storage[#hal.byte_range<0, 16>]
+  hal.constant_pool.value @cst0 = dense<[2.1, 3.2, 4.3, 5.4]> : tensor<4xf32>
+  // CHECK-DAG: hal.constant_pool.span @cst1 : tensor<3xi8> = @_storage[#hal.byte_range<16, 3>]
+  hal.constant_pool.value @cst1 = dense<[6, 7, 8]> : tensor<3xi8>
+  // Identical contents (even with a different type) share storage.
+  // CHECK-DAG: hal.constant_pool.span @cst2 : tensor<2x2xf32> = @_storage[#hal.byte_range<0, 16>]
+  hal.constant_pool.value @cst2 = dense<[[2.1, 3.2], [4.3, 5.4]]> : tensor<2x2xf32>
+
+  // CHECK: hal.constant_storage @_storage = dense<[102, 102, 6, 64, -51, -52, 76, 64, -102, -103, -119, 64, -51, -52, -84, 64, 6, 7, 8, 0]> : vector<20xi8>
+}
+
+// -----
+
+// COMPRESS-LABEL: hal.constant_pool @compress
+hal.constant_pool @compress attributes {
+    buffer_constraints = #hal.buffer_constraints<max_allocation_size = 1073741824,
+                                                 min_buffer_offset_alignment = 16,
+                                                 max_buffer_range = 134217728,
+                                                 min_buffer_range_alignment = 4>
+  } {
+  // COMPRESS: hal.constant_pool.span @cst0 : tensor<72xi32> = @_storage[#hal.byte_range<0, 288>]
+  hal.constant_pool.value @cst0 = dense<"0x010000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000002000000"> : tensor<72xi32>
+
+  // The 280 byte run of zeros is elided from the storage.
+  //      COMPRESS: hal.constant_storage @_storage = dense<[1, 0, 0, 0, 2, 0, 0, 0]> : vector<8xi8>
+  // COMPRESS-SAME:   fills = dense<{{\[\[}}4, 280, 0]]> : tensor<1x3xi64>
+}
@@ -11,6 +11,26 @@ vm.module @hal {
 vm.import @ex.shared_device() -> !vm.ref<!hal.device>
 attributes {nosideeffects}
 
+vm.import @ex.device(
+  %ordinal : i32
+) -> !vm.ref<!hal.device>
+attributes {nosideeffects}
+
+vm.import @ex.buffer.copy(
+  %source_buffer : !vm.ref<!hal.buffer>,
+  %source_offset : i32,
+  %target_buffer : !vm.ref<!hal.buffer>,
+  %target_offset : i32,
+  %length : i32
+)
+
+vm.import @ex.submit(
+  %device : !vm.ref<!hal.device>,
+  %command_buffer : !vm.ref<!hal.command_buffer>,
+  %signal_semaphore : !vm.ref<!hal.semaphore>,
+  %signal_value : i32
+)
+
 vm.import @ex.submit_and_wait(
   %device : !vm.ref<!hal.device>,
   %command_buffer : !vm.ref<!hal.command_buffer>
@@ -126,6 +146,12 @@ vm.import @buffer_view.trace(
   %operands : !vm.ref<!hal.buffer_view> ...
 )
 
+// Records statistics of the content of buffer views.
+vm.import @buffer_view.summarize(
+  %key : !vm.buffer,
+  %operands : !vm.ref<!hal.buffer_view> ...
+)
+
 //===----------------------------------------------------------------------===//
 // iree_hal_command_buffer_t
 //===----------------------------------------------------------------------===//
@@ -234,6 +260,22 @@ vm.import @command_buffer.dispatch.indirect(
   %workgroups_offset : i32
 )
 
+// Pushes constants and a descriptor set and dispatches an execution request.
+vm.import @command_buffer.dispatch.push(
+  %command_buffer : !vm.ref<!hal.command_buffer>,
+  %executable_layout : !vm.ref<!hal.executable_layout>,
+  %executable : !vm.ref<!hal.executable>,
+  %entry_point : i32,
+  %workgroup_x : i32,
+  %workgroup_y : i32,
+  %workgroup_z : i32,
+  %set : i32,
+  %constant_offset : i32,
+  %constants : i32 ...,
+  // <binding, buffer, offset, length>
+  %bindings : tuple<i32, !vm.ref<!hal.buffer>, i32, i32>...
+)
+
 //===----------------------------------------------------------------------===//
 // iree_hal_descriptor_set_t
 //===----------------------------------------------------------------------===//
@@ -278,6 +320,18 @@ vm.import @device.query.i32(
 ) -> (i32, i32)
 attributes {nosideeffects}
 
+// Submits the command buffer for execution once all wait semaphores have
+// reached their values and signals |signal_semaphore| to |signal_value| once
+// it has completed. Returns immediately without waiting on the host.
+vm.import @device.queue.submit(
+  %device : !vm.ref<!hal.device>,
+  %command_buffer : !vm.ref<!hal.command_buffer>,
+  %signal_semaphore : !vm.ref<!hal.semaphore>,
+  %signal_value : i32,
+  // <semaphore, value>
+  %wait_semaphores : tuple<!vm.ref<!hal.semaphore>, i32>...
+)
+
 //===----------------------------------------------------------------------===//
 // iree_hal_executable_t
 //===----------------------------------------------------------------------===//
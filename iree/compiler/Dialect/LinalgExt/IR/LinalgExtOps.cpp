@@ -182,12 +182,56 @@ static LogicalResult verifyScatterOp(ScatterOp op) {
   return success();
 }
 
+/// Returns the kind of atomic read-modify-write that is equivalent to the
+/// scatter `region`, if any. Only single operation combiners that are
+/// supported by the atomic lowerings of all backends are recognized.
+static Optional<AtomicRMWKind> getAtomicCombinerKind(Region &region) {
+  Block &block = region.front();
+  if (!llvm::hasSingleElement(block.without_terminator())) return llvm::None;
+  Operation &combiner = block.front();
+  Value yieldedValue = block.getTerminator()->getOperand(0);
+  if (combiner.getNumResults() != 1 || combiner.getNumOperands() != 2 ||
+      combiner.getResult(0) != yieldedValue) {
+    return llvm::None;
+  }
+  Value lhs = combiner.getOperand(0), rhs = combiner.getOperand(1);
+  Value update = block.getArgument(0), current = block.getArgument(1);
+  if (!(lhs == update && rhs == current) &&
+      !(lhs == current && rhs == update)) {
+    return llvm::None;
+  }
+  if (isa<AddFOp>(combiner)) return AtomicRMWKind::addf;
+  if (isa<AddIOp>(combiner)) return AtomicRMWKind::addi;
+  return llvm::None;
+}
+
 SmallVector<StringRef> ScatterOp::getLoopIteratorTypes() {
   SmallVector<StringRef> iteratorTypes(getUpdateType().getRank(),
                                        getParallelIteratorTypeName());
+  // Updates to the same indices must be applied in order unless they are
+  // known to be unique or can be combined atomically.
+  if (!unique_indices() && !getAtomicCombinerKind(region())) {
+    iteratorTypes[0] = getReductionIteratorTypeName();
+  }
   return iteratorTypes;
 }
 
+SmallVector<unsigned> ScatterOp::getPartitionableLoops(
+    unsigned maxNumParallelDims) {
+  SmallVector<unsigned> partitionableLoops;
+  for (auto iteratorType : llvm::enumerate(getLoopIteratorTypes())) {
+    if (iteratorType.value() != getParallelIteratorTypeName()) continue;
+    partitionableLoops.push_back(iteratorType.index());
+  }
+  if (partitionableLoops.size() > maxNumParallelDims) {
+    partitionableLoops.erase(
+        partitionableLoops.begin(),
+        std::next(partitionableLoops.begin(),
+                  partitionableLoops.size() - maxNumParallelDims));
+  }
+  return partitionableLoops;
+}
+
 SmallVector<Range> ScatterOp::getLoopBounds(OpBuilder &builder) {
   Location loc = getLoc();
   Value zero = builder.create<ConstantIndexOp>(loc, 0);
@@ -280,6 +324,17 @@ LogicalResult ScatterOp::generateScalarImplementation(OpBuilder &b,
     starts.push_back(b.create<IndexCastOp>(loc, b.getIndexType(), idx));
   }
   starts.append(std::next(ivs.begin()), ivs.end());
+
+  // Conflicting updates may be applied concurrently when the update loop is
+  // partitioned, so combine them atomically.
+  if (!unique_indices()) {
+    if (Optional<AtomicRMWKind> kind = getAtomicCombinerKind(region())) {
+      b.create<AtomicRMWOp>(loc, update.getType(), *kind, update, original(),
+                            starts);
+      return success();
+    }
+  }
+
   Value init = b.create<memref::LoadOp>(loc, original(), starts);
 
   BlockAndValueMapping bvm;
@@ -508,6 +563,316 @@ LogicalResult SortOp::generateScalarImplementation(OpBuilder &b, Location loc,
   return success();
 }
 
+//===----------------------------------------------------------------------===//
+// TopkOp
+//===----------------------------------------------------------------------===//
+
+static LogicalResult verifyTopkOp(TopkOp op) {
+  if (op.getNumInputs() == 0) {
+    return op.emitOpError("expected at least one `ins` operand");
+  }
+  if (op.getNumOutputs() != op.getNumInputs()) {
+    return op.emitOpError("expected as many `outs` operands as `ins` operands");
+  }
+
+  Block &block = op.region().front();
+  int64_t numInputs = op.getNumInputs();
+  if (block.getNumArguments() != 2 * numInputs) {
+    return op.emitOpError("region block should have ")
+           << 2 * numInputs << " arguments";
+  }
+
+  int64_t rank = op.getInputRank();
+  int64_t dimension = op.getSelectedDimension();
+  if (dimension < 0 || dimension >= rank) {
+    return op.emitOpError("dimension must be within [0, ") << rank << ")";
+  }
+
+  ArrayRef<int64_t> inputShape = op.getInputType(0).getShape();
+  ArrayRef<int64_t> outputShape = op.getOutputType(0).getShape();
+  for (int64_t index = 0; index < numInputs; ++index) {
+    ShapedType inputType = op.getInputType(index);
+    ShapedType outputType = op.getOutputType(index);
+    if (inputType.getRank() != rank || outputType.getRank() != rank) {
+      return op.emitOpError("expected operands ")
+             << index << " to be rank " << rank << ", same as other operands";
+    }
+    if (inputType.getShape() != inputShape) {
+      return op.emitOpError("expected input ")
+             << index << " to have same shape as other inputs";
+    }
+    if (outputType.getShape() != outputShape) {
+      return op.emitOpError("expected output ")
+             << index << " to have same shape as other outputs";
+    }
+    Type elemType = inputType.getElementType();
+    if (outputType.getElementType() != elemType) {
+      return op.emitOpError("expected input and output ")
+             << index << " to have the same element type";
+    }
+    for (int i : {2 * index, 2 * index + 1}) {
+      Type argType = block.getArgument(i).getType();
+      if (argType != elemType) {
+        return op.emitOpError("region block argument #")
+               << i << " should be of type " << elemType << " but got "
+               << argType;
+      }
+    }
+  }
+
+  for (int64_t dim = 0; dim < rank; ++dim) {
+    if (inputShape[dim] == ShapedType::kDynamicSize ||
+        outputShape[dim] == ShapedType::kDynamicSize) {
+      continue;
+    }
+    if (dim == dimension) {
+      if (outputShape[dim] > inputShape[dim]) {
+        return op.emitOpError(
+            "expected outputs to be at most as large as inputs along "
+            "dimension");
+      }
+    } else if (outputShape[dim] != inputShape[dim]) {
+      return op.emitOpError(
+          "expected inputs and outputs to have the same size along all "
+          "dimensions but the selected one");
+    }
+  }
+
+  auto yieldOp = cast<YieldOp>(block.getTerminator());
+  if (yieldOp.getNumOperands() != 1) {
+    return op.emitOpError("should yield exactly one operand");
+  }
+  auto ty = yieldOp.getOperand(0).getType().dyn_cast<IntegerType>();
+  if (!ty || ty.getWidth() != 1) {
+    return op.emitOpError("should yield i1 type");
+  }
+
+  return success();
+}
+
+SmallVector<StringRef> TopkOp::getLoopIteratorTypes() {
+  // All loops except the dimension to select along are parallel.
+  SmallVector<StringRef> iteratorTypes(getInputRank(),
+                                       getParallelIteratorTypeName());
+  iteratorTypes[getSelectedDimension()] = getReductionIteratorTypeName();
+  return iteratorTypes;
+}
+
+SmallVector<Range> TopkOp::getLoopBounds(OpBuilder &builder) {
+  int64_t inputRank = getInputRank();
+  SmallVector<Range> loopBounds(inputRank);
+  Location loc = getLoc();
+  Value zero = builder.create<ConstantIndexOp>(loc, 0);
+  Value one = builder.create<ConstantIndexOp>(loc, 1);
+  Value source = inputs()[0];
+  for (auto dim : llvm::seq<int64_t>(0, inputRank)) {
+    loopBounds[dim].offset = zero;
+    loopBounds[dim].size = getDimValue(builder, loc, source, dim);
+    loopBounds[dim].stride = one;
+  }
+  return loopBounds;
+}
+
+SmallVector<unsigned> TopkOp::getPartitionableLoops(
+    unsigned maxNumParallelDims) {
+  auto range = llvm::seq<unsigned>(0, getInputRank());
+  SmallVector<unsigned> partitionableLoops(range.begin(), range.end());
+  partitionableLoops.erase(
+      std::next(partitionableLoops.begin(), getSelectedDimension()));
+  if (partitionableLoops.size() > maxNumParallelDims) {
+    partitionableLoops.erase(
+        partitionableLoops.begin(),
+        std::next(partitionableLoops.begin(),
+                  partitionableLoops.size() - maxNumParallelDims));
+  }
+  return partitionableLoops;
+}
+
+Operation *TopkOp::getTiledImplementation(OpBuilder &builder,
+                                          ValueRange outputs,
+                                          ArrayRef<OpFoldResult> offsets,
+                                          ArrayRef<OpFoldResult> sizes,
+                                          SmallVectorImpl<Value> &results) {
+  assert(outputs.size() == this->outputs().size());
+  int64_t rank = getInputRank();
+  assert(offsets.size() == static_cast<size_t>(rank) &&
+         sizes.size() == static_cast<size_t>(rank));
+  uint64_t dimension = getSelectedDimension();
+  auto oneAttr = builder.getI64IntegerAttr(1);
+  SmallVector<OpFoldResult> strides(rank, oneAttr);
+  Location loc = getLoc();
+
+  // The selected dimension is never tiled; the outputs are always sliced
+  // along the whole of it as it is smaller than that of the inputs.
+  SmallVector<OpFoldResult> outputOffsets(offsets.begin(), offsets.end());
+  SmallVector<OpFoldResult> outputSizes(sizes.begin(), sizes.end());
+  outputOffsets[dimension] = builder.getI64IntegerAttr(0);
+  outputSizes[dimension] = getDim(builder, loc, outputs[0], dimension);
+
+  SmallVector<Value> tiledOperands;
+  for (Value input : inputs()) {
+    tiledOperands.push_back(
+        getSlice(builder, loc, input, offsets, sizes, strides));
+    assert(tiledOperands.back() && "failed to get slice of input");
+  }
+  SmallVector<Type, 4> resultTypes;
+  for (Value output : outputs) {
+    tiledOperands.push_back(
+        getSlice(builder, loc, output, outputOffsets, outputSizes, strides));
+    assert(tiledOperands.back() && "failed to get slice of output");
+    if (getNumResults()) {
+      resultTypes.push_back(tiledOperands.back().getType());
+    }
+  }
+  Operation *tiledTopkOp = cast<LinalgExtOp>(getOperation())
+                               .clone(builder, loc, resultTypes, tiledOperands);
+  for (auto result : llvm::enumerate(tiledTopkOp->getResults())) {
+    auto insertSliceOp = builder.create<tensor::InsertSliceOp>(
+        loc, result.value(), outputs[result.index()], outputOffsets,
+        outputSizes, strides);
+    results.push_back(insertSliceOp.getResult());
+  }
+  return tiledTopkOp;
+}
+
+/// Clones the comparator `region` comparing the elements `lhs` to the
+/// elements `rhs` and returns the condition it yields.
+static Value cloneComparator(OpBuilder &b, Region &region, ValueRange lhs,
+                             ValueRange rhs) {
+  Block &srcBlock = region.front();
+  BlockAndValueMapping bvm;
+  for (int i = 0, e = lhs.size(); i < e; ++i) {
+    bvm.map(srcBlock.getArgument(2 * i), lhs[i]);
+    bvm.map(srcBlock.getArgument(2 * i + 1), rhs[i]);
+  }
+  for (auto &blockOp : srcBlock.without_terminator()) {
+    b.clone(blockOp, bvm);
+  }
+  return bvm.lookupOrDefault(srcBlock.getTerminator()->getOperand(0));
+}
+
+// Generates the insertion of the input elements at `ivs` into the outputs.
+// The outputs hold the first min(j, k) of the preceding elements in order,
+// where j = ivs[dimension]. The pseudo reference code is:
+//   if (j >= k && !comparator(in[j], out[k - 1])) return;
+//   carry = in[j];
+//   inserted = false;
+//   for (int m = 0; m < min(j + 1, k); ++m) {
+//     if (m == j) {
+//       out[m] = carry;
+//     } else if (inserted || comparator(carry, out[m])) {
+//       swap(carry, out[m]);
+//       inserted = true;
+//     }
+//   }
+// Elements not among the first k are rejected with a single comparison so
+// selecting from n elements takes O(n + k * insertions) comparisons, which
+// is much less than a full sort for small k.
+LogicalResult TopkOp::generateScalarImplementation(OpBuilder &b, Location loc,
+                                                   ValueRange ivs) {
+  uint64_t dimension = getSelectedDimension();
+  Value j = ivs[dimension];
+  Value zero = b.create<ConstantIndexOp>(loc, 0);
+  Value one = b.create<ConstantIndexOp>(loc, 1);
+  Value k;
+  if (getOutputType(0).isDynamicDim(dimension)) {
+    k = b.create<memref::DimOp>(loc, outputs()[0], dimension);
+  } else {
+    k = b.create<ConstantIndexOp>(loc,
+                                  getOutputType(0).getDimSize(dimension));
+  }
+
+  SmallVector<Value> elements;
+  for (Value input : inputs()) {
+    elements.push_back(b.create<memref::LoadOp>(loc, input, ivs));
+  }
+
+  // Once the outputs are full only elements ordered before the last one are
+  // inserted.
+  Value isFull = b.create<CmpIOp>(loc, CmpIPredicate::uge, j, k);
+  auto shouldInsert = b.create<scf::IfOp>(
+      loc, b.getI1Type(), isFull,
+      [&](OpBuilder &b, Location loc) {
+        SmallVector<Value> indices(ivs.begin(), ivs.end());
+        indices[dimension] = b.create<SubIOp>(loc, k, one);
+        SmallVector<Value> last;
+        for (Value output : outputs()) {
+          last.push_back(b.create<memref::LoadOp>(loc, output, indices));
+        }
+        Value cond = cloneComparator(b, region(), elements, last);
+        b.create<scf::YieldOp>(loc, cond);
+      },
+      [&](OpBuilder &b, Location loc) {
+        Value isTrue = b.create<ConstantIntOp>(loc, 1, 1);
+        b.create<scf::YieldOp>(loc, isTrue);
+      });
+
+  b.create<scf::IfOp>(
+      loc, TypeRange{}, shouldInsert.getResult(0),
+      [&](OpBuilder &b, Location loc) {
+        Value jPlusOne = b.create<AddIOp>(loc, j, one);
+        Value isPartial =
+            b.create<CmpIOp>(loc, CmpIPredicate::ult, jPlusOne, k);
+        Value ub = b.create<SelectOp>(loc, isPartial, jPlusOne, k);
+        // Carries the elements to insert followed by whether the input
+        // elements have been inserted, after which all following elements
+        // are shifted by one position.
+        SmallVector<Value> initArgs(elements);
+        initArgs.push_back(b.create<ConstantIntOp>(loc, 0, 1));
+        b.create<scf::ForOp>(
+            loc, zero, ub, one, initArgs,
+            [&](OpBuilder &b, Location loc, Value m, ValueRange iterArgs) {
+              ValueRange carry = iterArgs.drop_back();
+              Value inserted = iterArgs.back();
+              SmallVector<Value> indices(ivs.begin(), ivs.end());
+              indices[dimension] = m;
+              Value isEmpty = b.create<CmpIOp>(loc, CmpIPredicate::eq, m, j);
+              auto ifOp = b.create<scf::IfOp>(
+                  loc, iterArgs.getTypes(), isEmpty,
+                  [&](OpBuilder &b, Location loc) {
+                    // Append to the outputs as they are not full yet.
+                    for (auto it : llvm::zip(carry, outputs())) {
+                      b.create<memref::StoreOp>(loc, std::get<0>(it),
+                                                std::get<1>(it), indices);
+                    }
+                    b.create<scf::YieldOp>(loc, iterArgs);
+                  },
+                  [&](OpBuilder &b, Location loc) {
+                    SmallVector<Value> current;
+                    for (Value output : outputs()) {
+                      current.push_back(
+                          b.create<memref::LoadOp>(loc, output, indices));
+                    }
+                    Value cond = b.create<OrOp>(
+                        loc, inserted,
+                        cloneComparator(b, region(), carry, current));
+                    auto swapOp = b.create<scf::IfOp>(
+                        loc, iterArgs.getTypes(), cond,
+                        [&](OpBuilder &b, Location loc) {
+                          // Store the carried elements here and carry the
+                          // current ones on to the next position.
+                          for (auto it : llvm::zip(carry, outputs())) {
+                            b.create<memref::StoreOp>(loc, std::get<0>(it),
+                                                      std::get<1>(it),
+                                                      indices);
+                          }
+                          SmallVector<Value> results(current);
+                          results.push_back(
+                              b.create<ConstantIntOp>(loc, 1, 1));
+                          b.create<scf::YieldOp>(loc, results);
+                        },
+                        [&](OpBuilder &b, Location loc) {
+                          b.create<scf::YieldOp>(loc, iterArgs);
+                        });
+                    b.create<scf::YieldOp>(loc, swapOp.getResults());
+                  });
+              b.create<scf::YieldOp>(loc, ifOp.getResults());
+            });
+        b.create<scf::YieldOp>(loc);
+      });
+  return success();
+}
+
 //===----------------------------------------------------------------------===//
 // FftOp
 //===----------------------------------------------------------------------===//
@@ -727,6 +1092,7 @@ LogicalResult FftOp::generateScalarImplementation(OpBuilder &b, Location loc,
 
 DEFINE_OP_GET_EFFECTS(ScatterOp)
 DEFINE_OP_GET_EFFECTS(SortOp)
+DEFINE_OP_GET_EFFECTS(TopkOp)
 DEFINE_OP_GET_EFFECTS(FftOp)
 
 }  // namespace linalg_ext
@@ -380,3 +380,48 @@ func @scatter_original_rank_mismatch(
     } -> tensor<?x?xi64>
   return %0 : tensor<?x?xi64>
 }
+
+// -----
+
+func @topk_mismatch_outs(%arg0: tensor<128xi32>, %arg1: tensor<128xi32>,
+    %arg2: tensor<8xi32>) -> tensor<8xi32> {
+  // expected-error @+1 {{expected as many `outs` operands as `ins` operands}}
+  %0 = linalg_ext.topk dimension(0)
+      ins(%arg0, %arg1 : tensor<128xi32>, tensor<128xi32>)
+      outs(%arg2 : tensor<8xi32>) {
+      ^bb0(%arg3: i32, %arg4: i32, %arg5: i32, %arg6: i32):  // no predecessors
+        %1 = cmpi sgt, %arg3, %arg4 : i32
+        linalg_ext.yield %1 : i1
+      } -> tensor<8xi32>
+  return %0 : tensor<8xi32>
+}
+
+// -----
+
+func @topk_output_too_large(%arg0: tensor<8xi32>, %arg1: tensor<16xi32>)
+    -> tensor<16xi32> {
+  // expected-error @+1 {{expected outputs to be at most as large as inputs along dimension}}
+  %0 = linalg_ext.topk dimension(0)
+      ins(%arg0 : tensor<8xi32>)
+      outs(%arg1 : tensor<16xi32>) {
+      ^bb0(%arg2: i32, %arg3: i32):  // no predecessors
+        %1 = cmpi sgt, %arg2, %arg3 : i32
+        linalg_ext.yield %1 : i1
+      } -> tensor<16xi32>
+  return %0 : tensor<16xi32>
+}
+
+// -----
+
+func @topk_mismatch_parallel_dims(%arg0: tensor<4x128xi32>,
+    %arg1: tensor<2x8xi32>) -> tensor<2x8xi32> {
+  // expected-error @+1 {{expected inputs and outputs to have the same size along all dimensions but the selected one}}
+  %0 = linalg_ext.topk dimension(1)
+      ins(%arg0 : tensor<4x128xi32>)
+      outs(%arg1 : tensor<2x8xi32>) {
+      ^bb0(%arg2: i32, %arg3: i32):  // no predecessors
+        %1 = cmpi sgt, %arg2, %arg3 : i32
+        linalg_ext.yield %1 : i1
+      } -> tensor<2x8xi32>
+  return %0 : tensor<2x8xi32>
+}
@@ -94,6 +94,28 @@ func @scatter_tensor_dynamic(
 
 // -----
 
+func @scatter_tensor_unique_indices(
+    %original: tensor<?x?xf32>, %indices: tensor<?x1xi32>,
+    %update: tensor<?x?xf32>) -> tensor<?x?xf32> {
+  %0 = linalg_ext.scatter {unique_indices}
+    ins(%update, %indices : tensor<?x?xf32>, tensor<?x1xi32>)
+    outs(%original: tensor<?x?xf32>) {
+    ^bb0(%arg1: f32, %arg2: f32):
+      linalg_ext.yield %arg1 : f32
+    } -> tensor<?x?xf32>
+  return %0 : tensor<?x?xf32>
+}
+// CHECK-LABEL: func @scatter_tensor_unique_indices(
+//  CHECK-SAME:   %[[ORIGINAL:[a-zA-Z0-9_]+]]: tensor<?x?xf32>
+//  CHECK-SAME:   %[[INDICES:[a-zA-Z0-9_]+]]: tensor<?x1xi32>
+//  CHECK-SAME:   %[[UPDATE:[a-zA-Z0-9_]+]]: tensor<?x?xf32>
+//       CHECK:   %[[RESULT:.+]] = linalg_ext.scatter {unique_indices}
+//  CHECK-SAME:     ins(%[[UPDATE]], %[[INDICES]]
+//  CHECK-SAME:     outs(%[[ORIGINAL]]
+//       CHECK:   return %[[RESULT]]
+
+// -----
+
 func @scatter_tensor_static(
     %original: tensor<128x3xf32>, %indices: tensor<48x1xi32>,
     %update: tensor<48x3xf32>) -> tensor<128x3xf32> {
@@ -387,3 +409,46 @@ func @fft_tensor_coef_stage_5(%arg0: tensor<1024xf32>, %arg1: tensor<1024xf32>,
 //  CHECK-SAME:    outs(%[[REAL]], %[[IMAG]] : tensor<1024xf32>, tensor<1024xf32>)
 //  CHECK-SAME:   : tensor<1024xf32>, tensor<1024xf32>
 //       CHECK:   return %[[RES]]#0, %[[RES]]#1
+
+// -----
+
+func @topk_tensor(%arg0: tensor<16x128xf32>, %arg1: tensor<16x128xi32>,
+    %arg2: tensor<16x8xf32>, %arg3: tensor<16x8xi32>)
+    -> (tensor<16x8xf32>, tensor<16x8xi32>) {
+  %0:2 = linalg_ext.topk dimension(1)
+      ins(%arg0, %arg1 : tensor<16x128xf32>, tensor<16x128xi32>)
+      outs(%arg2, %arg3 : tensor<16x8xf32>, tensor<16x8xi32>) {
+      ^bb0(%arg4: f32, %arg5: f32, %arg6: i32, %arg7: i32):  // no predecessors
+        %1 = cmpf ogt, %arg4, %arg5 : f32
+        linalg_ext.yield %1 : i1
+      } -> tensor<16x8xf32>, tensor<16x8xi32>
+  return %0#0, %0#1 : tensor<16x8xf32>, tensor<16x8xi32>
+}
+// CHECK-LABEL: func @topk_tensor
+//  CHECK-SAME:   %[[ARG0:[a-zA-Z0-9]+]]: tensor<16x128xf32>
+//  CHECK-SAME:   %[[ARG1:[a-zA-Z0-9]+]]: tensor<16x128xi32>
+//  CHECK-SAME:   %[[ARG2:[a-zA-Z0-9]+]]: tensor<16x8xf32>
+//  CHECK-SAME:   %[[ARG3:[a-zA-Z0-9]+]]: tensor<16x8xi32>
+//       CHECK:   %[[RESULT:.+]]:2 = linalg_ext.topk dimension(1)
+//  CHECK-SAME:      ins(%[[ARG0]], %[[ARG1]]
+//  CHECK-SAME:      outs(%[[ARG2]], %[[ARG3]]
+//       CHECK:   return %[[RESULT]]#0, %[[RESULT]]#1
+
+// -----
+
+func @topk_memref(%arg0: memref<?xi32>, %arg1: memref<4xi32>) {
+  linalg_ext.topk dimension(0)
+      ins(%arg0 : memref<?xi32>)
+      outs(%arg1 : memref<4xi32>) {
+      ^bb0(%arg2: i32, %arg3: i32):  // no predecessors
+        %0 = cmpi sgt, %arg2, %arg3 : i32
+        linalg_ext.yield %0 : i1
+      }
+  return
+}
+// CHECK-LABEL: func @topk_memref
+//  CHECK-SAME:   %[[ARG0:[a-zA-Z0-9]+]]: memref<?xi32>
+//  CHECK-SAME:   %[[ARG1:[a-zA-Z0-9]+]]: memref<4xi32>
+//       CHECK:   linalg_ext.topk dimension(0)
+//  CHECK-SAME:      ins(%[[ARG0]] : memref<?xi32>)
+//  CHECK-SAME:      outs(%[[ARG1]] : memref<4xi32>)
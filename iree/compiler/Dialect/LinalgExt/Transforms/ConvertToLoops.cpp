@@ -11,12 +11,16 @@
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/MathExtras.h"
 #include "mlir/Dialect/Linalg/IR/LinalgOps.h"
 #include "mlir/Dialect/Math/IR/Math.h"
 #include "mlir/Dialect/MemRef/IR/MemRef.h"
 #include "mlir/Dialect/SCF/SCF.h"
 #include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/Dialect/Vector/VectorOps.h"
+#include "mlir/IR/BlockAndValueMapping.h"
 #include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Matchers.h"
 #include "mlir/IR/PatternMatch.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
@@ -83,6 +87,315 @@ struct TiledOpInterfaceLowerToLoopsPattern : public RewritePattern {
 };
 }  // namespace
 
+//===----------------------------------------------------------------------===//
+// SortOp
+//===----------------------------------------------------------------------===//
+
+/// Returns the number of merge levels of a bitonic network sorting `size`
+/// elements, i.e. ceil(log2(size)).
+static Value getBitonicMergeLevelCount(OpBuilder &b, Location loc,
+                                       Value size) {
+  // Computed as the number of significant bits of `size - 1`. Sizes beyond
+  // 2^32 are not supported.
+  Value zero = b.create<ConstantIndexOp>(loc, 0);
+  Value one = b.create<ConstantIndexOp>(loc, 1);
+  Value maxBits = b.create<ConstantIndexOp>(loc, 32);
+  Value isEmpty = b.create<CmpIOp>(loc, CmpIPredicate::eq, size, zero);
+  Value sizeMinusOne = b.create<SelectOp>(loc, isEmpty, zero,
+                                          b.create<SubIOp>(loc, size, one));
+  auto bitLoop = b.create<scf::ForOp>(
+      loc, zero, maxBits, one, ValueRange{zero},
+      [&](OpBuilder &b, Location loc, Value bit, ValueRange iters) {
+        Value shifted = b.create<UnsignedShiftRightOp>(loc, sizeMinusOne, bit);
+        Value isSignificant =
+            b.create<CmpIOp>(loc, CmpIPredicate::ne, shifted, zero);
+        Value next = b.create<AddIOp>(loc, iters[0], one);
+        Value count = b.create<SelectOp>(loc, isSignificant, next, iters[0]);
+        b.create<scf::YieldOp>(loc, count);
+      });
+  return bitLoop.getResult(0);
+}
+
+/// Emits the compare-exchange of the elements at `lhsIndex` and `rhsIndex`
+/// along the sorted dimension of all outputs of `sortOp` at `indices`. The
+/// elements are swapped if the comparator does not hold for them.
+static void generateCompareExchange(OpBuilder &b, Location loc, SortOp sortOp,
+                                    ValueRange ivs, Value lhsIndex,
+                                    Value rhsIndex) {
+  uint64_t sortDim = sortOp.getSortedDimension();
+  SmallVector<Value> indices(ivs.begin(), ivs.end());
+  SmallVector<Value> sortBlkArgs;
+  for (OpOperand *output : sortOp.getOutputOperands()) {
+    indices[sortDim] = lhsIndex;
+    sortBlkArgs.push_back(
+        b.create<memref::LoadOp>(loc, output->get(), indices));
+    indices[sortDim] = rhsIndex;
+    sortBlkArgs.push_back(
+        b.create<memref::LoadOp>(loc, output->get(), indices));
+  }
+
+  Block &srcBlock = sortOp.region().front();
+  BlockAndValueMapping bvm;
+  for (auto it : llvm::zip(srcBlock.getArguments(), sortBlkArgs)) {
+    bvm.map(std::get<0>(it), std::get<1>(it));
+  }
+  for (auto &blockOp : srcBlock.without_terminator()) {
+    b.clone(blockOp, bvm);
+  }
+  Value cond = bvm.lookupOrDefault(srcBlock.getTerminator()->getOperand(0));
+
+  b.create<scf::IfOp>(
+      loc, TypeRange{}, cond,
+      [&](OpBuilder &b, Location loc) {
+        // Do not swap the pairs if true.
+        b.create<scf::YieldOp>(loc);
+      },
+      [&](OpBuilder &b, Location loc) {
+        // Swap the pairs if false.
+        for (int i = 0, e = sortOp.getNumOutputs(); i < e; ++i) {
+          Value output = sortOp.getOutputOperand(i)->get();
+          indices[sortDim] = lhsIndex;
+          b.create<memref::StoreOp>(loc, sortBlkArgs[i * 2 + 1], output,
+                                    indices);
+          indices[sortDim] = rhsIndex;
+          b.create<memref::StoreOp>(loc, sortBlkArgs[i * 2], output, indices);
+        }
+        b.create<scf::YieldOp>(loc);
+      });
+}
+
+/// Emits a bitonic sorting network sorting the `size` elements of all outputs
+/// of `sortOp` at `indices` along the sorted dimension (the index of which in
+/// `indices` is ignored).
+///
+/// Merge level `level` merges sorted blocks of 2^(level-1) elements into
+/// blocks of `k` = 2^level elements. Its first step compares each element in
+/// the lower half of a block with its mirror in the upper half (i ^ (k - 1))
+/// and the following steps compare elements `j` = k/4, k/8, ... 1 apart
+/// (i | j). All comparisons are in the same direction so a network for the
+/// next power of two sorts any `size` by skipping the comparisons against
+/// elements past the end, which act as padding ordered after all others.
+///
+/// This performs O(n log^2 n) comparisons instead of the O(n^2) of the
+/// generic lowering, and all comparisons within a step are independent.
+static void generateBitonicSort(OpBuilder &b, Location loc, SortOp sortOp,
+                                ValueRange indices, Value size,
+                                Value levelCount, Value pairCount) {
+  Value zero = b.create<ConstantIndexOp>(loc, 0);
+  Value one = b.create<ConstantIndexOp>(loc, 1);
+  Value levelUb = b.createOrFold<AddIOp>(loc, levelCount, one);
+  b.create<scf::ForOp>(
+      loc, one, levelUb, one, ValueRange{},
+      [&](OpBuilder &b, Location loc, Value level, ValueRange) {
+        Value k = b.create<ShiftLeftOp>(loc, one, level);
+        Value kMinusOne = b.create<SubIOp>(loc, k, one);
+        b.create<scf::ForOp>(
+            loc, zero, level, one, ValueRange{},
+            [&](OpBuilder &b, Location loc, Value step, ValueRange) {
+              Value logJ = b.create<SubIOp>(
+                  loc, b.create<SubIOp>(loc, level, one), step);
+              Value j = b.create<ShiftLeftOp>(loc, one, logJ);
+              Value jMinusOne = b.create<SubIOp>(loc, j, one);
+              Value logJPlusOne = b.create<AddIOp>(loc, logJ, one);
+              Value isFirstStep =
+                  b.create<CmpIOp>(loc, CmpIPredicate::eq, step, zero);
+              b.create<scf::ForOp>(
+                  loc, zero, pairCount, one, ValueRange{},
+                  [&](OpBuilder &b, Location loc, Value pair, ValueRange) {
+                    // Insert a zero bit at position logJ of the pair index
+                    // to get the lower element of the pair.
+                    Value high = b.create<ShiftLeftOp>(
+                        loc, b.create<UnsignedShiftRightOp>(loc, pair, logJ),
+                        logJPlusOne);
+                    Value low = b.create<AndOp>(loc, pair, jMinusOne);
+                    Value lhsIndex = b.create<OrOp>(loc, high, low);
+                    Value flipIndex =
+                        b.create<XOrOp>(loc, lhsIndex, kMinusOne);
+                    Value halfIndex = b.create<OrOp>(loc, lhsIndex, j);
+                    Value rhsIndex = b.create<SelectOp>(loc, isFirstStep,
+                                                        flipIndex, halfIndex);
+                    Value inBounds = b.create<CmpIOp>(loc, CmpIPredicate::ult,
+                                                      rhsIndex, size);
+                    b.create<scf::IfOp>(
+                        loc, TypeRange{}, inBounds,
+                        [&](OpBuilder &b, Location loc) {
+                          generateCompareExchange(b, loc, sortOp, indices,
+                                                  lhsIndex, rhsIndex);
+                          b.create<scf::YieldOp>(loc);
+                        });
+                    b.create<scf::YieldOp>(loc);
+                  });
+              b.create<scf::YieldOp>(loc);
+            });
+        b.create<scf::YieldOp>(loc);
+      });
+}
+
+namespace {
+/// Lowers `linalg_ext.sort` to loops over the non-sorted dimensions that each
+/// sort along the sorted dimension with a bitonic network. Takes precedence
+/// over the generic lowering using the scalar implementation.
+struct SortOpToBitonicLoopsPattern : public OpRewritePattern<SortOp> {
+  using OpRewritePattern<SortOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(SortOp sortOp,
+                                PatternRewriter &rewriter) const override {
+    if (sortOp->getNumResults()) {
+      return rewriter.notifyMatchFailure(
+          sortOp, "lower to loops needs to have buffer semantics");
+    }
+    Location loc = sortOp.getLoc();
+    uint64_t sortDim = sortOp.getSortedDimension();
+    SmallVector<Range> loopBounds = sortOp.getLoopBounds(rewriter);
+    Value size = loopBounds[sortDim].size;
+
+    // The network shape is known at compile time for static sizes.
+    Value levelCount, pairCount;
+    if (!sortOp.getOperandType(0).isDynamicDim(sortDim)) {
+      int64_t staticSize = sortOp.getOperandType(0).getDimSize(sortDim);
+      unsigned levels = staticSize > 1 ? llvm::Log2_64_Ceil(staticSize) : 0;
+      levelCount = rewriter.create<ConstantIndexOp>(loc, levels);
+      pairCount = rewriter.create<ConstantIndexOp>(
+          loc, levels ? (int64_t(1) << (levels - 1)) : 0);
+    } else {
+      levelCount = getBitonicMergeLevelCount(rewriter, loc, size);
+      Value one = rewriter.create<ConstantIndexOp>(loc, 1);
+      pairCount = rewriter.create<UnsignedShiftRightOp>(
+          loc, rewriter.create<ShiftLeftOp>(loc, one, levelCount), one);
+    }
+
+    SmallVector<Value> lbs, ubs, steps;
+    for (auto en : llvm::enumerate(loopBounds)) {
+      if (en.index() == sortDim) continue;
+      lbs.push_back(en.value().offset);
+      ubs.push_back(en.value().size);
+      steps.push_back(en.value().stride);
+    }
+    scf::buildLoopNest(
+        rewriter, loc, lbs, ubs, steps,
+        [&](OpBuilder &b, Location loc, ValueRange ivs) {
+          SmallVector<Value> indices(ivs.begin(), ivs.end());
+          indices.insert(indices.begin() + sortDim, loopBounds[sortDim].offset);
+          generateBitonicSort(b, loc, sortOp, indices, size, levelCount,
+                              pairCount);
+        });
+    rewriter.eraseOp(sortOp);
+    return success();
+  }
+};
+}  // namespace
+
+/// Generates `vectorType.getNumElements()` consecutive butterflies of an FFT
+/// stage starting at butterfly `j` of the group at `ivs`. The vector type
+/// is expected to evenly divide the `halfSize` butterflies of the group.
+static void generateVectorButterflies(OpBuilder &b, Location loc,
+                                      FftOp fftOp, VectorType vectorType,
+                                      ValueRange ivs, Value j,
+                                      Value halfSize) {
+  auto read = [&](Value source, ValueRange indices) -> Value {
+    return b.create<vector::TransferReadOp>(loc, vectorType, source, indices);
+  };
+  Value wReal = read(fftOp.getRealCoeff(), j);
+  Value wImag = read(fftOp.getImagCoeff(), j);
+
+  SmallVector<Value> lhsIndices(ivs.begin(), ivs.end());
+  lhsIndices.back() = b.create<AddIOp>(loc, ivs.back(), j);
+  SmallVector<Value> rhsIndices(lhsIndices);
+  rhsIndices.back() = b.create<AddIOp>(loc, lhsIndices.back(), halfSize);
+  Value lhsReal = read(fftOp.getReal(), lhsIndices);
+  Value lhsImag = read(fftOp.getImag(), lhsIndices);
+  Value rhsReal = read(fftOp.getReal(), rhsIndices);
+  Value rhsImag = read(fftOp.getImag(), rhsIndices);
+
+  // t = w * a[k + j + mh];
+  // ->  (x + yi)(u + vi) = (xu - yv) + (xv + yu)i
+  Value xu = b.create<MulFOp>(loc, wReal, rhsReal);
+  Value yv = b.create<MulFOp>(loc, wImag, rhsImag);
+  Value xv = b.create<MulFOp>(loc, wReal, rhsImag);
+  Value yu = b.create<MulFOp>(loc, wImag, rhsReal);
+  Value tReal = b.create<SubFOp>(loc, xu, yv);
+  Value tImag = b.create<AddFOp>(loc, xv, yu);
+
+  // cplx u = a[k + j];
+  // a[k + j] = u + t;
+  // a[k + j + mh] = u - t;
+  Value r1 = b.create<AddFOp>(loc, lhsReal, tReal);
+  Value r2 = b.create<AddFOp>(loc, lhsImag, tImag);
+  Value r3 = b.create<SubFOp>(loc, lhsReal, tReal);
+  Value r4 = b.create<SubFOp>(loc, lhsImag, tImag);
+  b.create<vector::TransferWriteOp>(loc, r1, fftOp.getReal(), lhsIndices);
+  b.create<vector::TransferWriteOp>(loc, r2, fftOp.getImag(), lhsIndices);
+  b.create<vector::TransferWriteOp>(loc, r3, fftOp.getReal(), rhsIndices);
+  b.create<vector::TransferWriteOp>(loc, r4, fftOp.getImag(), rhsIndices);
+}
+
+namespace {
+/// Lowers `linalg_ext.fft` stages carrying precomputed coefficient buffers to
+/// loops computing `vectorSize` butterflies at a time with vector operations.
+/// Only applies to constant stages where the butterflies of each group are a
+/// multiple of `vectorSize`; the others use the scalar implementation.
+struct FftOpToVectorLoopsPattern : public OpRewritePattern<FftOp> {
+  FftOpToVectorLoopsPattern(MLIRContext *context, int64_t vectorSize,
+                            PatternBenefit benefit = 1)
+      : OpRewritePattern<FftOp>(context, benefit), vectorSize(vectorSize) {}
+
+  LogicalResult matchAndRewrite(FftOp fftOp,
+                                PatternRewriter &rewriter) const override {
+    if (fftOp->getNumResults()) {
+      return rewriter.notifyMatchFailure(
+          fftOp, "lower to loops needs to have buffer semantics");
+    }
+    if (!fftOp.hasCoeff()) {
+      return rewriter.notifyMatchFailure(fftOp,
+                                         "expected coefficient buffers");
+    }
+    APInt stage;
+    if (!matchPattern(fftOp.getStage(), m_ConstantInt(&stage)) ||
+        stage.getSExtValue() < 1) {
+      return rewriter.notifyMatchFailure(fftOp, "expected a constant stage");
+    }
+    int64_t halfSize = int64_t(1) << (stage.getSExtValue() - 1);
+    if (halfSize % vectorSize != 0) {
+      return rewriter.notifyMatchFailure(
+          fftOp, "expected butterfly groups to be a multiple of vector size");
+    }
+    Type elementType = fftOp.getOperandType().getElementType();
+    if (!elementType.isa<FloatType>()) {
+      return rewriter.notifyMatchFailure(fftOp, "expected float operands");
+    }
+
+    Location loc = fftOp.getLoc();
+    SmallVector<Range> loopBounds = fftOp.getLoopBounds(rewriter);
+    SmallVector<Value> lbs, ubs, steps;
+    for (Range range : loopBounds) {
+      lbs.push_back(range.offset);
+      ubs.push_back(range.size);
+      steps.push_back(range.stride);
+    }
+    Value zero = rewriter.create<ConstantIndexOp>(loc, 0);
+    Value half = rewriter.create<ConstantIndexOp>(loc, halfSize);
+    Value step = rewriter.create<ConstantIndexOp>(loc, vectorSize);
+    auto vectorType = VectorType::get({vectorSize}, elementType);
+    scf::buildLoopNest(
+        rewriter, loc, lbs, ubs, steps,
+        [&](OpBuilder &b, Location loc, ValueRange ivs) {
+          b.create<scf::ForOp>(
+              loc, zero, half, step, ValueRange{},
+              [&](OpBuilder &b, Location loc, Value j, ValueRange args) {
+                generateVectorButterflies(b, loc, fftOp, vectorType, ivs, j,
+                                          half);
+                b.create<scf::YieldOp>(loc);
+              });
+        });
+    rewriter.eraseOp(fftOp);
+    return success();
+  }
+
+ private:
+  int64_t vectorSize;
+};
+}  // namespace
+
 //===----------------------------------------------------------------------===//
 // Pass
 //===----------------------------------------------------------------------===//
@@ -90,10 +403,18 @@ struct TiledOpInterfaceLowerToLoopsPattern : public RewritePattern {
 namespace {
 struct LinalgExtToLoopsPass
     : public LinalgExtToLoopsBase<LinalgExtToLoopsPass> {
+  LinalgExtToLoopsPass(int64_t fftVectorSize) {
+    this->fftVectorSize = fftVectorSize;
+  }
+  LinalgExtToLoopsPass(const LinalgExtToLoopsPass &that) {
+    fftVectorSize = that.fftVectorSize;
+  }
+
   void getDependentDialects(DialectRegistry &registry) const override {
     registry
         .insert<linalg::LinalgDialect, StandardOpsDialect, math::MathDialect,
-                memref::MemRefDialect, scf::SCFDialect>();
+                memref::MemRefDialect, scf::SCFDialect,
+                vector::VectorDialect>();
   }
 
   void runOnOperation() override {
@@ -101,6 +422,11 @@ struct LinalgExtToLoopsPass
 
     OwningRewritePatternList patterns(context);
     patterns.insert<TiledOpInterfaceLowerToLoopsPattern>(context);
+    patterns.insert<SortOpToBitonicLoopsPattern>(context, /*benefit=*/2);
+    if (fftVectorSize > 0) {
+      patterns.insert<FftOpToVectorLoopsPattern>(context, fftVectorSize,
+                                                 /*benefit=*/2);
+    }
     if (failed(applyPatternsAndFoldGreedily(getOperation(),
                                             std::move(patterns)))) {
       return signalPassFailure();
@@ -109,8 +435,9 @@ struct LinalgExtToLoopsPass
 };
 }  // namespace
 
-std::unique_ptr<OperationPass<FuncOp>> createLinalgExtToLoopsPass() {
-  return std::make_unique<LinalgExtToLoopsPass>();
+std::unique_ptr<OperationPass<FuncOp>> createLinalgExtToLoopsPass(
+    int64_t fftVectorSize) {
+  return std::make_unique<LinalgExtToLoopsPass>(fftVectorSize);
 }
 
 }  // namespace linalg_ext
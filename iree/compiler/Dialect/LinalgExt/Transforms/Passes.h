@@ -15,7 +15,10 @@ namespace linalg_ext {
 
 std::unique_ptr<OperationPass<FuncOp>> createTiledOpInterfaceTilingPass();
 
-std::unique_ptr<OperationPass<FuncOp>> createLinalgExtToLoopsPass();
+// Lowers LinalgExt ops to loops. FFT stages with coefficient buffers are
+// lowered to vectors of `fftVectorSize` elements if it is non-zero.
+std::unique_ptr<OperationPass<FuncOp>> createLinalgExtToLoopsPass(
+    int64_t fftVectorSize = 0);
 
 void registerLinalgExtPasses();
 
@@ -435,7 +435,8 @@ void TiledOpInterfaceTilingPass::runOnOperation() {
       linalg::LinalgTransformationFilter(
           Identifier::get("outer_reduce_input", context),
           Identifier::get("outer_reduce_output", context)));
-  patterns.add<TiledOpInterfaceTilingPattern<SortOp>>(
+  patterns.add<TiledOpInterfaceTilingPattern<SortOp>,
+               TiledOpInterfaceTilingPattern<TopkOp>>(
       context, linalg::LinalgTilingOptions().setTileSizes({10, 0, 0}),
       linalg::LinalgTransformationFilter(
           Identifier::get("inner_reduce_input", context),
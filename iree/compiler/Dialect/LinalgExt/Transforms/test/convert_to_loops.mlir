@@ -11,22 +11,32 @@ func @sort_1d(%arg0: memref<128xi32>) {
 }
 // CHECK-LABEL: func @sort_1d
 // CHECK-SAME:    %[[BUF:[a-zA-Z0-9]+]]
-// CHECK-DAG:     %[[C128:.+]] = constant 128 : index
 // CHECK-DAG:     %[[C0:.+]] = constant 0 : index
 // CHECK-DAG:     %[[C1:.+]] = constant 1 : index
-// CHECK-DAG:     %[[C127:.+]] = constant 127 : index
-// CHECK:         scf.for %[[ARG1:.+]] = %[[C0]] to %[[C128]] step %[[C1]]
-// CHECK:           scf.for %[[ARG2:.+]] = %[[C0]] to %[[C127]] step %[[C1]]
-// CHECK:             %[[T1:.+]] = addi %[[ARG2]], %[[C1]] : index
-// CHECK:             %[[V1:.+]] = memref.load %[[BUF]][%[[ARG2]]]
-// CHECK:             %[[V2:.+]] = memref.load %[[BUF]][%[[T1]]]
-// CHECK:             %[[COND:.+]] = cmpi sgt, %[[V1]], %[[V2]] : i32
-// CHECK:             scf.if %[[COND]] {
-// CHECK:             } else {
-// CHECK:               %[[T2:.+]] = addi %[[ARG2]], %[[C1]] : index
-// CHECK:               memref.store %[[V2]], %[[BUF]][%[[ARG2]]]
-// CHECK:               memref.store %[[V1]], %[[BUF]][%[[T2]]]
-// CHECK:             }
+// CHECK-DAG:     %[[C8:.+]] = constant 8 : index
+// CHECK-DAG:     %[[C64:.+]] = constant 64 : index
+// CHECK-DAG:     %[[C128:.+]] = constant 128 : index
+// CHECK:         scf.for %[[LEVEL:.+]] = %[[C1]] to %[[C8]] step %[[C1]]
+// CHECK:           %[[K:.+]] = shift_left %[[C1]], %[[LEVEL]]
+// CHECK:           %[[K_MINUS_ONE:.+]] = subi %[[K]], %[[C1]]
+// CHECK:           scf.for %[[STEP:.+]] = %[[C0]] to %[[LEVEL]] step %[[C1]]
+// CHECK:             %[[FIRST:.+]] = cmpi eq, %[[STEP]], %[[C0]]
+// CHECK:             scf.for %[[PAIR:.+]] = %[[C0]] to %[[C64]] step %[[C1]]
+// CHECK:               %[[LHS:.+]] = or
+// CHECK:               %[[FLIP:.+]] = xor %[[LHS]], %[[K_MINUS_ONE]]
+// CHECK:               %[[HALF:.+]] = or %[[LHS]]
+// CHECK:               %[[RHS:.+]] = select %[[FIRST]], %[[FLIP]], %[[HALF]]
+// CHECK:               %[[IN_BOUNDS:.+]] = cmpi ult, %[[RHS]], %[[C128]]
+// CHECK:               scf.if %[[IN_BOUNDS]] {
+// CHECK:                 %[[V1:.+]] = memref.load %[[BUF]][%[[LHS]]]
+// CHECK:                 %[[V2:.+]] = memref.load %[[BUF]][%[[RHS]]]
+// CHECK:                 %[[COND:.+]] = cmpi sgt, %[[V1]], %[[V2]] : i32
+// CHECK:                 scf.if %[[COND]] {
+// CHECK:                 } else {
+// CHECK:                   memref.store %[[V2]], %[[BUF]][%[[LHS]]]
+// CHECK:                   memref.store %[[V1]], %[[BUF]][%[[RHS]]]
+// CHECK:                 }
+// CHECK:               }
 
 // -----
 
@@ -41,24 +51,29 @@ func @sort_2d(%arg0: memref<16x32xi32>) {
 }
 // CHECK-LABEL: func @sort_2d
 // CHECK-SAME:    %[[BUF:[a-zA-Z0-9]+]]
-// CHECK-DAG:     %[[C16:.+]] = constant 16 : index
-// CHECK-DAG:     %[[C32:.+]] = constant 32 : index
 // CHECK-DAG:     %[[C0:.+]] = constant 0 : index
 // CHECK-DAG:     %[[C1:.+]] = constant 1 : index
-// CHECK-DAG:     %[[C15:.+]] = constant 15 : index
-// CHECK:         scf.for %[[ARG1:.+]] = %[[C0]] to %[[C16]] step %[[C1]]
-// CHECK:           scf.for %[[ARG2:.+]] = %[[C0]] to %[[C32]] step %[[C1]]
-// CHECK:             scf.for %[[ARG3:.+]] = %[[C0]] to %[[C15]] step %[[C1]]
-// CHECK:               %[[T1:.+]] = addi %[[ARG3]], %[[C1]] : index
-// CHECK:               %[[V1:.+]] = memref.load %[[BUF]][%[[ARG3]], %[[ARG2]]]
-// CHECK:               %[[V2:.+]] = memref.load %[[BUF]][%[[T1]], %[[ARG2]]]
-// CHECK:               %[[COND:.+]] = cmpi sgt, %[[V1]], %[[V2]] : i32
-// CHECK:               scf.if %[[COND]] {
-// CHECK:               } else {
-// CHECK:                 %[[T2:.+]] = addi %[[ARG3]], %[[C1]] : index
-// CHECK:                 memref.store %[[V2]], %[[BUF]][%[[ARG3]], %[[ARG2]]]
-// CHECK:                 memref.store %[[V1]], %[[BUF]][%[[T2]], %[[ARG2]]]
-// CHECK:               }
+// CHECK-DAG:     %[[C5:.+]] = constant 5 : index
+// CHECK-DAG:     %[[C8:.+]] = constant 8 : index
+// CHECK-DAG:     %[[C16:.+]] = constant 16 : index
+// CHECK-DAG:     %[[C32:.+]] = constant 32 : index
+// CHECK:         scf.for %[[ARG1:.+]] = %[[C0]] to %[[C32]] step %[[C1]]
+// CHECK:           scf.for %[[LEVEL:.+]] = %[[C1]] to %[[C5]] step %[[C1]]
+// CHECK:             scf.for %[[STEP:.+]] = %[[C0]] to %[[LEVEL]] step %[[C1]]
+// CHECK:               scf.for %[[PAIR:.+]] = %[[C0]] to %[[C8]] step %[[C1]]
+// CHECK:                 %[[LHS:.+]] = or
+// CHECK:                 %[[RHS:.+]] = select
+// CHECK:                 %[[IN_BOUNDS:.+]] = cmpi ult, %[[RHS]], %[[C16]]
+// CHECK:                 scf.if %[[IN_BOUNDS]] {
+// CHECK:                   %[[V1:.+]] = memref.load %[[BUF]][%[[LHS]], %[[ARG1]]]
+// CHECK:                   %[[V2:.+]] = memref.load %[[BUF]][%[[RHS]], %[[ARG1]]]
+// CHECK:                   %[[COND:.+]] = cmpi sgt, %[[V1]], %[[V2]] : i32
+// CHECK:                   scf.if %[[COND]] {
+// CHECK:                   } else {
+// CHECK:                     memref.store %[[V2]], %[[BUF]][%[[LHS]], %[[ARG1]]]
+// CHECK:                     memref.store %[[V1]], %[[BUF]][%[[RHS]], %[[ARG1]]]
+// CHECK:                   }
+// CHECK:                 }
 
 // -----
 
@@ -74,26 +89,106 @@ func @sort_multi(%arg0: memref<128xf32>, %arg1: memref<128xi32>) {
 // CHECK-LABEL: func @sort_multi
 // CHECK-SAME:    %[[BUF1:[a-zA-Z0-9]+]]
 // CHECK-SAME:    %[[BUF2:[a-zA-Z0-9]+]]
+// CHECK-DAG:     %[[C0:.+]] = constant 0 : index
+// CHECK-DAG:     %[[C1:.+]] = constant 1 : index
+// CHECK-DAG:     %[[C8:.+]] = constant 8 : index
+// CHECK-DAG:     %[[C64:.+]] = constant 64 : index
 // CHECK-DAG:     %[[C128:.+]] = constant 128 : index
+// CHECK:         scf.for %[[LEVEL:.+]] = %[[C1]] to %[[C8]] step %[[C1]]
+// CHECK:           scf.for %[[STEP:.+]] = %[[C0]] to %[[LEVEL]] step %[[C1]]
+// CHECK:             scf.for %[[PAIR:.+]] = %[[C0]] to %[[C64]] step %[[C1]]
+// CHECK:               %[[LHS:.+]] = or
+// CHECK:               %[[RHS:.+]] = select
+// CHECK:               %[[IN_BOUNDS:.+]] = cmpi ult, %[[RHS]], %[[C128]]
+// CHECK:               scf.if %[[IN_BOUNDS]] {
+// CHECK:                 %[[V1:.+]] = memref.load %[[BUF1]][%[[LHS]]]
+// CHECK:                 %[[V2:.+]] = memref.load %[[BUF1]][%[[RHS]]]
+// CHECK:                 %[[V3:.+]] = memref.load %[[BUF2]][%[[LHS]]]
+// CHECK:                 %[[V4:.+]] = memref.load %[[BUF2]][%[[RHS]]]
+// CHECK:                 %[[COND:.+]] = cmpf ogt, %[[V1]], %[[V2]] : f32
+// CHECK:                 scf.if %[[COND]] {
+// CHECK:                 } else {
+// CHECK:                   memref.store %[[V2]], %[[BUF1]][%[[LHS]]]
+// CHECK:                   memref.store %[[V1]], %[[BUF1]][%[[RHS]]]
+// CHECK:                   memref.store %[[V4]], %[[BUF2]][%[[LHS]]]
+// CHECK:                   memref.store %[[V3]], %[[BUF2]][%[[RHS]]]
+// CHECK:                 }
+// CHECK:               }
+
+// -----
+
+func @sort_dynamic(%arg0: memref<?xi32>) {
+  linalg_ext.sort dimension(0)
+    outs(%arg0 : memref<?xi32>) {
+  ^bb0(%arg2: i32, %arg3: i32):  // no predecessors
+    %0 = cmpi sgt, %arg2, %arg3 : i32
+    linalg_ext.yield %0 : i1
+  }
+  return
+}
+// CHECK-LABEL: func @sort_dynamic
+// CHECK-SAME:    %[[BUF:[a-zA-Z0-9]+]]
+// CHECK-DAG:     %[[C0:.+]] = constant 0 : index
+// CHECK-DAG:     %[[C1:.+]] = constant 1 : index
+// CHECK-DAG:     %[[C32:.+]] = constant 32 : index
+// CHECK:         %[[SIZE:.+]] = memref.dim %[[BUF]], %[[C0]]
+// CHECK:         %[[LEVELS:.+]] = scf.for %{{.+}} = %[[C0]] to %[[C32]] step %[[C1]]
+// CHECK-SAME:        iter_args(%{{.+}} = %[[C0]]) -> (index)
+// CHECK:         %[[PAIRS_X2:.+]] = shift_left %[[C1]], %[[LEVELS]]
+// CHECK:         %[[PAIRS:.+]] = shift_right_unsigned %[[PAIRS_X2]], %[[C1]]
+// CHECK:         %[[LEVEL_UB:.+]] = addi %[[LEVELS]], %[[C1]]
+// CHECK:         scf.for %[[LEVEL:.+]] = %[[C1]] to %[[LEVEL_UB]] step %[[C1]]
+// CHECK:           scf.for %[[STEP:.+]] = %[[C0]] to %[[LEVEL]] step %[[C1]]
+// CHECK:             scf.for %[[PAIR:.+]] = %[[C0]] to %[[PAIRS]] step %[[C1]]
+// CHECK:               %[[RHS:.+]] = select
+// CHECK:               %[[IN_BOUNDS:.+]] = cmpi ult, %[[RHS]], %[[SIZE]]
+// CHECK:               scf.if %[[IN_BOUNDS]] {
+
+// -----
+
+func @topk_1d(%arg0: memref<128xf32>, %arg1: memref<8xf32>) {
+  linalg_ext.topk dimension(0)
+    ins(%arg0 : memref<128xf32>)
+    outs(%arg1 : memref<8xf32>) {
+  ^bb0(%arg2: f32, %arg3: f32):  // no predecessors
+    %0 = cmpf ogt, %arg2, %arg3 : f32
+    linalg_ext.yield %0 : i1
+  }
+  return
+}
+// CHECK-LABEL: func @topk_1d
+// CHECK-SAME:    %[[IN:[a-zA-Z0-9]+]]
+// CHECK-SAME:    %[[OUT:[a-zA-Z0-9]+]]
 // CHECK-DAG:     %[[C0:.+]] = constant 0 : index
 // CHECK-DAG:     %[[C1:.+]] = constant 1 : index
-// CHECK-DAG:     %[[C127:.+]] = constant 127 : index
-// CHECK:         scf.for %[[ARG1:.+]] = %[[C0]] to %[[C128]] step %[[C1]]
-// CHECK:           scf.for %[[ARG2:.+]] = %[[C0]] to %[[C127]] step %[[C1]]
-// CHECK:             %[[T1:.+]] = addi %[[ARG2]], %[[C1]] : index
-// CHECK:             %[[V1:.+]] = memref.load %[[BUF1]][%[[ARG2]]]
-// CHECK:             %[[V2:.+]] = memref.load %[[BUF1]][%[[T1]]]
-// CHECK:             %[[V3:.+]] = memref.load %[[BUF2]][%[[ARG2]]]
-// CHECK:             %[[V4:.+]] = memref.load %[[BUF2]][%[[T1]]]
-// CHECK:             %[[COND:.+]] = cmpf ogt, %[[V1]], %[[V2]] : f32
-// CHECK:             scf.if %[[COND]] {
-// CHECK:             } else {
-// CHECK:               %[[T2:.+]] = addi %[[ARG2]], %[[C1]] : index
-// CHECK:               memref.store %[[V2]], %[[BUF1]][%[[ARG2]]]
-// CHECK:               memref.store %[[V1]], %[[BUF1]][%[[T2]]]
-// CHECK:               memref.store %[[V4]], %[[BUF2]][%[[ARG2]]]
-// CHECK:               memref.store %[[V3]], %[[BUF2]][%[[T2]]]
-// CHECK:             }
+// CHECK-DAG:     %[[C8:.+]] = constant 8 : index
+// CHECK-DAG:     %[[C128:.+]] = constant 128 : index
+// CHECK:         scf.for %[[J:.+]] = %[[C0]] to %[[C128]] step %[[C1]]
+// CHECK:           %[[V:.+]] = memref.load %[[IN]][%[[J]]]
+// CHECK:           %[[FULL:.+]] = cmpi uge, %[[J]], %[[C8]]
+// CHECK:           %[[INSERT:.+]] = scf.if %[[FULL]] -> (i1) {
+// CHECK:             %[[LAST_IDX:.+]] = subi %[[C8]], %[[C1]]
+// CHECK:             %[[LAST:.+]] = memref.load %[[OUT]][%[[LAST_IDX]]]
+// CHECK:             %[[CMP:.+]] = cmpf ogt, %[[V]], %[[LAST]]
+// CHECK:             scf.yield %[[CMP]]
+// CHECK:           } else {
+// CHECK:             scf.yield %{{.+}} : i1
+// CHECK:           scf.if %[[INSERT]] {
+// CHECK:             %[[J_PLUS_1:.+]] = addi %[[J]], %[[C1]]
+// CHECK:             %[[PARTIAL:.+]] = cmpi ult, %[[J_PLUS_1]], %[[C8]]
+// CHECK:             %[[UB:.+]] = select %[[PARTIAL]], %[[J_PLUS_1]], %[[C8]]
+// CHECK:             scf.for %[[M:.+]] = %[[C0]] to %[[UB]] step %[[C1]]
+// CHECK-SAME:            iter_args(%[[CARRY:.+]] = %[[V]], %[[INSERTED:.+]] = %{{.+}}) -> (f32, i1)
+// CHECK:               %[[EMPTY:.+]] = cmpi eq, %[[M]], %[[J]]
+// CHECK:               scf.if %[[EMPTY]] -> (f32, i1) {
+// CHECK:                 memref.store %[[CARRY]], %[[OUT]][%[[M]]]
+// CHECK:               } else {
+// CHECK:                 %[[CUR:.+]] = memref.load %[[OUT]][%[[M]]]
+// CHECK:                 %[[GT:.+]] = cmpf ogt, %[[CARRY]], %[[CUR]]
+// CHECK:                 %[[SWAP:.+]] = or %[[INSERTED]], %[[GT]]
+// CHECK:                 scf.if %[[SWAP]] -> (f32, i1) {
+// CHECK:                   memref.store %[[CARRY]], %[[OUT]][%[[M]]]
+// CHECK:                   scf.yield %[[CUR]], %{{.+}} : f32, i1
 
 // -----
 
@@ -148,6 +243,36 @@ func @scatter_add_scalar_2D(
 // CHECK:           %[[IDX1:.+]] = index_cast %[[T2]] : i32 to index
 // CHECK:           %[[T3:.+]] = memref.load %[[INDICES]][%[[I]], %[[C1]]] : memref<3x2xi32>
 // CHECK:           %[[IDX2:.+]] = index_cast %[[T3]] : i32 to index
+// CHECK:           atomic_rmw "addi" %[[T1]], %[[ORIGINAL]][%[[IDX1]], %[[IDX2]]]
+
+// -----
+
+func @scatter_add_scalar_unique_2D(
+    %original: memref<4x3xi32>, %indices: memref<3x2xi32>,
+    %updates: memref<3xi32>) {
+  linalg_ext.scatter {unique_indices}
+    ins(%updates, %indices : memref<3xi32>, memref<3x2xi32>)
+    outs(%original : memref<4x3xi32>)  {
+  ^bb0(%arg0: i32, %arg1: i32):  // no predecessors
+    %0 = addi %arg1, %arg0 : i32
+    linalg_ext.yield %0 : i32
+  }
+  return
+}
+// CHECK-LABEL: func @scatter_add_scalar_unique_2D
+// CHECK-SAME:    %[[ORIGINAL:[a-zA-Z0-9]+]]
+// CHECK-SAME:    %[[INDICES:[a-zA-Z0-9]+]]
+// CHECK-SAME:    %[[UPDATES:[a-zA-Z0-9]+]]
+// CHECK-DAG:     %[[C0:.+]] = constant 0 : index
+// CHECK-DAG:     %[[C1:.+]] = constant 1 : index
+// CHECK-DAG:     %[[C3:.+]] = constant 3 : index
+// CHECK:         scf.for %[[I:.+]] = %[[C0]] to %[[C3]] step %[[C1]] {
+// CHECK:           %[[T1:.+]] = memref.load %[[UPDATES]][%[[I]]] : memref<3xi32>
+// CHECK:           %[[T2:.+]] = memref.load %[[INDICES]][%[[I]], %[[C0]]] : memref<3x2xi32>
+// CHECK:           %[[IDX1:.+]] = index_cast %[[T2]] : i32 to index
+// CHECK:           %[[T3:.+]] = memref.load %[[INDICES]][%[[I]], %[[C1]]] : memref<3x2xi32>
+// CHECK:           %[[IDX2:.+]] = index_cast %[[T3]] : i32 to index
+// CHECK-NOT:       atomic_rmw
 // CHECK:           %[[ORI:.+]] = memref.load %[[ORIGINAL]][%[[IDX1]], %[[IDX2]]] : memref<4x3xi32>
 // CHECK:           %[[ADD:.+]] = addi %[[ORI]], %[[T1]] : i32
 // CHECK:           memref.store %[[ADD]], %[[ORIGINAL]][%[[IDX1]], %[[IDX2]]]
@@ -207,9 +332,7 @@ func @scatter_add_scalar_1D(
 // CHECK:           %[[T1:.+]] = memref.load %[[UPDATES]][%[[I]]] : memref<3xi32>
 // CHECK:           %[[T2:.+]] =  memref.load %[[INDICES]][%[[I]], %[[C0]]] : memref<3x1xi32>
 // CHECK:           %[[IDX:.+]] = index_cast %[[T2]] : i32 to index
-// CHECK:           %[[ORI:.+]] = memref.load %[[ORIGINAL]][%[[IDX]]] : memref<8xi32>
-// CHECK:           %[[ADD:.+]] = addi %[[ORI]], %[[T1]] : i32
-// CHECK:           memref.store %[[ADD]], %[[ORIGINAL]][%[[IDX]]]
+// CHECK:           atomic_rmw "addi" %[[T1]], %[[ORIGINAL]][%[[IDX]]]
 
 // -----
 
@@ -237,9 +360,7 @@ func @scatter_add_slice_2D(
 // CHECK:             %[[UPDATEVAL:.+]] = memref.load %[[UPDATES]][%[[I]], %[[J]]]
 // CHECK:             %[[INDEXVAL:.+]] = memref.load %[[INDICES]][%[[I]], %[[C0]]]
 // CHECK:             %[[INDEX:.+]] = index_cast %[[INDEXVAL]] : i32 to index
-// CHECK:             %[[ORIGINALVAL:.+]] = memref.load %[[ORIGINAL]][%[[INDEX]], %[[J]]]
-// CHECK:             %[[STOREVAL:.+]] = addi %[[ORIGINALVAL]], %[[UPDATEVAL]]
-// CHECK:             memref.store %[[STOREVAL]], %[[ORIGINAL]][%[[INDEX]], %[[J]]]
+// CHECK:             atomic_rmw "addi" %[[UPDATEVAL]], %[[ORIGINAL]][%[[INDEX]], %[[J]]]
 
 // -----
 
@@ -294,9 +415,7 @@ func @scatter_add_scalar_dynamic_2D(
 // CHECK:           %[[IDX1:.+]] = index_cast %[[T2]] : i32 to index
 // CHECK:           %[[T3:.+]] = memref.load %[[INDICES]][%[[I]], %[[C1]]] : memref<?x2xi32>
 // CHECK:           %[[IDX2:.+]] = index_cast %[[T3]] : i32 to index
-// CHECK:           %[[ORI:.+]] = memref.load %[[ORIGINAL]][%[[IDX1]], %[[IDX2]]] : memref<?x?xi32>
-// CHECK:           %[[ADD:.+]] = addi %[[ORI]], %[[T1]] : i32
-// CHECK:           memref.store %[[ADD]], %[[ORIGINAL]][%[[IDX1]], %[[IDX2]]]
+// CHECK:           atomic_rmw "addi" %[[T1]], %[[ORIGINAL]][%[[IDX1]], %[[IDX2]]]
 
 // -----
 
@@ -0,0 +1,77 @@
+// RUN: iree-opt -split-input-file -iree-linalg-ext-to-loops="fft-vector-size=4" %s | IreeFileCheck %s
+
+func @fft_2D_coef_buf(%real: memref<?x16xf32>, %imag: memref<?x16xf32>,
+                      %coef_real: memref<4xf32>, %coef_imag: memref<4xf32>) {
+  %stage = constant 3 : index
+  linalg_ext.fft
+    ins(%stage, %coef_real, %coef_imag: index, memref<4xf32>, memref<4xf32>)
+    outs(%real, %imag: memref<?x16xf32>, memref<?x16xf32>)
+  return
+}
+// CHECK:       func @fft_2D_coef_buf
+// CHECK-SAME:    %[[REAL:[a-zA-Z0-9]+]]
+// CHECK-SAME:    %[[IMAG:[a-zA-Z0-9]+]]
+// CHECK-SAME:    %[[COEF_REAL:[a-zA-Z0-9]+]]
+// CHECK-SAME:    %[[COEF_IMAG:[a-zA-Z0-9]+]]
+// CHECK-DAG:     %[[C0:.+]] = constant 0 : index
+// CHECK-DAG:     %[[C1:.+]] = constant 1 : index
+// CHECK-DAG:     %[[C4:.+]] = constant 4 : index
+// CHECK-DAG:     %[[C16:.+]] = constant 16 : index
+// CHECK-DAG:     %[[D0:.+]] = memref.dim %[[REAL]], %[[C0]] : memref<?x16xf32>
+// CHECK:         scf.for %[[I:.+]] = %[[C0]] to %[[D0]] step %[[C1]]
+// CHECK:           scf.for %[[K:.+]] = %[[C0]] to %[[C16]] step %{{.+}}
+// CHECK:             scf.for %[[J:.+]] = %[[C0]] to %[[C4]] step %[[C4]]
+// CHECK-NOT:           linalg.generic
+// CHECK-DAG:           %[[W_REAL:.+]] = vector.transfer_read %[[COEF_REAL]][%[[J]]]{{.*}} : memref<4xf32>, vector<4xf32>
+// CHECK-DAG:           %[[W_IMAG:.+]] = vector.transfer_read %[[COEF_IMAG]][%[[J]]]{{.*}} : memref<4xf32>, vector<4xf32>
+// CHECK-DAG:           %[[L_OFFSET:.+]] = addi %[[K]], %[[J]] : index
+// CHECK-DAG:           %[[R_OFFSET:.+]] = addi %[[L_OFFSET]], %[[C4]] : index
+// CHECK-DAG:           %[[L_REAL:.+]] = vector.transfer_read %[[REAL]][%[[I]], %[[L_OFFSET]]]{{.*}} : memref<?x16xf32>, vector<4xf32>
+// CHECK-DAG:           %[[L_IMAG:.+]] = vector.transfer_read %[[IMAG]][%[[I]], %[[L_OFFSET]]]{{.*}} : memref<?x16xf32>, vector<4xf32>
+// CHECK-DAG:           %[[R_REAL:.+]] = vector.transfer_read %[[REAL]][%[[I]], %[[R_OFFSET]]]{{.*}} : memref<?x16xf32>, vector<4xf32>
+// CHECK-DAG:           %[[R_IMAG:.+]] = vector.transfer_read %[[IMAG]][%[[I]], %[[R_OFFSET]]]{{.*}} : memref<?x16xf32>, vector<4xf32>
+// CHECK-DAG:           %[[XU:.+]] = mulf %[[W_REAL]], %[[R_REAL]] : vector<4xf32>
+// CHECK-DAG:           %[[YV:.+]] = mulf %[[W_IMAG]], %[[R_IMAG]] : vector<4xf32>
+// CHECK-DAG:           %[[XV:.+]] = mulf %[[W_REAL]], %[[R_IMAG]] : vector<4xf32>
+// CHECK-DAG:           %[[YU:.+]] = mulf %[[W_IMAG]], %[[R_REAL]] : vector<4xf32>
+// CHECK-DAG:           %[[T_REAL:.+]] = subf %[[XU]], %[[YV]] : vector<4xf32>
+// CHECK-DAG:           %[[T_IMAG:.+]] = addf %[[XV]], %[[YU]] : vector<4xf32>
+// CHECK-DAG:           %[[RES1:.+]] = addf %[[L_REAL]], %[[T_REAL]] : vector<4xf32>
+// CHECK-DAG:           %[[RES2:.+]] = addf %[[L_IMAG]], %[[T_IMAG]] : vector<4xf32>
+// CHECK-DAG:           %[[RES3:.+]] = subf %[[L_REAL]], %[[T_REAL]] : vector<4xf32>
+// CHECK-DAG:           %[[RES4:.+]] = subf %[[L_IMAG]], %[[T_IMAG]] : vector<4xf32>
+// CHECK-DAG:           vector.transfer_write %[[RES1]], %[[REAL]][%[[I]], %[[L_OFFSET]]]
+// CHECK-DAG:           vector.transfer_write %[[RES2]], %[[IMAG]][%[[I]], %[[L_OFFSET]]]
+// CHECK-DAG:           vector.transfer_write %[[RES3]], %[[REAL]][%[[I]], %[[R_OFFSET]]]
+// CHECK-DAG:           vector.transfer_write %[[RES4]], %[[IMAG]][%[[I]], %[[R_OFFSET]]]
+
+// -----
+
+// Stages with fewer butterflies per group than the vector size keep the
+// scalar implementation.
+func @fft_1D_coef_buf_small_stage(%real: memref<16xf32>, %imag: memref<16xf32>,
+                                  %coef_real: memref<2xf32>,
+                                  %coef_imag: memref<2xf32>) {
+  %stage = constant 2 : index
+  linalg_ext.fft
+    ins(%stage, %coef_real, %coef_imag: index, memref<2xf32>, memref<2xf32>)
+    outs(%real, %imag: memref<16xf32>, memref<16xf32>)
+  return
+}
+// CHECK-LABEL: func @fft_1D_coef_buf_small_stage
+// CHECK-NOT:     vector.transfer_read
+// CHECK:         linalg.generic
+
+// -----
+
+// Stages computing the coefficients are not vectorized.
+func @fft_1D(%real: memref<16xf32>, %imag: memref<16xf32>) {
+  %stage = constant 3 : index
+  linalg_ext.fft
+    ins(%stage: index)
+    outs(%real, %imag: memref<16xf32>, memref<16xf32>)
+  return
+}
+// CHECK-LABEL: func @fft_1D
+// CHECK-NOT:     vector.transfer_read
+// CHECK:         linalg.generic
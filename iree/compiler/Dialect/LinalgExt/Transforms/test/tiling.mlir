@@ -218,6 +218,44 @@ func @sort_2d(%arg0: tensor<?x?xi32>) -> tensor<?x?xi32> {
 
 // -----
 
+func @topk_2d(%arg0: tensor<?x?xf32>, %arg1: tensor<?x8xf32>)
+    -> tensor<?x8xf32> {
+  %0 = linalg_ext.topk dimension(1)
+       {__internal_linalg_transform__ = "inner_reduce_input"}
+       ins(%arg0 : tensor<?x?xf32>)
+       outs(%arg1 : tensor<?x8xf32>) {
+       ^bb0(%arg2: f32, %arg3: f32):  // no predecessors
+         %0 = cmpf ogt, %arg2, %arg3 : f32
+         linalg_ext.yield %0 : i1
+       } -> tensor<?x8xf32>
+  return %0 : tensor<?x8xf32>
+}
+//       CHECK: func @topk_2d(
+//  CHECK-SAME:   %[[INPUT:[a-zA-Z0-9]+]]: tensor<?x?xf32>
+//  CHECK-SAME:   %[[OUTPUT:[a-zA-Z0-9]+]]: tensor<?x8xf32>
+//   CHECK-DAG:   %[[TILESIZE:.+]] = constant 10 : index
+//   CHECK-DAG:   %[[C0:.+]] = constant 0 : index
+//   CHECK-DAG:   %[[C1:.+]] = constant 1 : index
+//   CHECK-DAG:   %[[D0:.+]] = tensor.dim %[[INPUT]], %[[C0]]
+//   CHECK-DAG:   %[[D1:.+]] = tensor.dim %[[INPUT]], %[[C1]]
+//       CHECK:   %[[RESULT:.+]] = scf.for %[[IV:.+]] = %[[C0]] to %[[D0]] step %[[TILESIZE]]
+//  CHECK-SAME:       iter_args(%[[INIT:.+]] = %[[OUTPUT]])
+//       CHECK:     %[[USED_TILESIZE:.+]] = affine.min
+//       CHECK:     %[[INPUT_SLICE:.+]] = tensor.extract_slice %[[INPUT]][%[[IV]], 0]
+//  CHECK-SAME:         [%[[USED_TILESIZE]], %[[D1]]]
+//       CHECK:     %[[OUTPUT_SLICE:.+]] = tensor.extract_slice %[[INIT]][%[[IV]], 0]
+//  CHECK-SAME:         [%[[USED_TILESIZE]], 8]
+//       CHECK:     %[[TOPK_TILE:.+]] = linalg_ext.topk dimension(1)
+//  CHECK-SAME:         __internal_linalg_transform__ = "inner_reduce_output"
+//  CHECK-SAME:         ins(%[[INPUT_SLICE]]
+//  CHECK-SAME:         outs(%[[OUTPUT_SLICE]]
+//       CHECK:     %[[YIELD:.+]] = tensor.insert_slice %[[TOPK_TILE]] into %[[INIT]][%[[IV]], 0]
+//  CHECK-SAME:         [%[[USED_TILESIZE]], 8]
+//       CHECK:     scf.yield %[[YIELD]]
+//       CHECK:   return %[[RESULT]]
+
+// -----
+
 func @sort_2d_inner_parallel(%arg0: tensor<?x?xi32>) -> tensor<?x?xi32> {
   %0 = linalg_ext.sort dimension(0)
        {__internal_linalg_transform__ = "outer_reduce_input"}
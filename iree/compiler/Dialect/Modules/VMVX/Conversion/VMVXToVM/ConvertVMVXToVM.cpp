@@ -115,12 +115,100 @@ class VMVXImportOpConversion : public OpConversionPattern<T> {
   patterns.insert<VMVXImportOpConversion<op_type>>( \
       context, importSymbols, typeConverter, op_mnemonic);
 
+class CopyOpConversion : public VMVXImportOpConversion<IREE::VMVX::CopyOp> {
+ public:
+  using VMVXImportOpConversion::VMVXImportOpConversion;
+
+ protected:
+  std::string getImportSuffix(IREE::VMVX::CopyOp op) const override {
+    return "." + getSizedTypeStr(op.in_buffer()
+                                     .getType()
+                                     .cast<MemRefType>()
+                                     .getElementType());
+  }
+};
+
+class FillOpConversion : public VMVXImportOpConversion<IREE::VMVX::FillOp> {
+ public:
+  using VMVXImportOpConversion::VMVXImportOpConversion;
+
+  LogicalResult matchAndRewrite(
+      IREE::VMVX::FillOp op, llvm::ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const override {
+    // The runtime only cares about the bit pattern of the value so floats are
+    // passed as integers of the same width.
+    IREE::VMVX::FillOp::Adaptor adaptor(operands);
+    if (!adaptor.value().getType().isa<FloatType>()) {
+      return VMVXImportOpConversion::matchAndRewrite(op, operands, rewriter);
+    }
+    auto newOperands = llvm::to_vector<8>(operands);
+    newOperands[0] = rewriter.createOrFold<IREE::VM::BitcastF32I32Op>(
+        op.getLoc(), rewriter.getI32Type(), adaptor.value());
+    return VMVXImportOpConversion::matchAndRewrite(op, newOperands, rewriter);
+  }
+
+ protected:
+  std::string getImportSuffix(IREE::VMVX::FillOp op) const override {
+    return "." + getSizedTypeStr(op.value().getType());
+  }
+};
+
+class UnaryOpConversion : public VMVXImportOpConversion<IREE::VMVX::UnaryOp> {
+ public:
+  using VMVXImportOpConversion::VMVXImportOpConversion;
+
+ protected:
+  std::string getImportSuffix(IREE::VMVX::UnaryOp op) const override {
+    return op.opcode().str() + ".2d." +
+           getTypedTypeStr(op.in_buffer().getType());
+  }
+};
+
+class BinaryOpConversion
+    : public VMVXImportOpConversion<IREE::VMVX::BinaryOp> {
+ public:
+  using VMVXImportOpConversion::VMVXImportOpConversion;
+
+ protected:
+  std::string getImportSuffix(IREE::VMVX::BinaryOp op) const override {
+    return op.opcode().str() + ".2d." +
+           getTypedTypeStr(op.lhs_buffer().getType());
+  }
+};
+
+// Matmul imports are suffixed with the lhs, rhs, and out element types.
+template <typename T>
+class MatmulOpConversion : public VMVXImportOpConversion<T> {
+ public:
+  using VMVXImportOpConversion<T>::VMVXImportOpConversion;
+
+ protected:
+  std::string getImportSuffix(T op) const override {
+    return "." + this->getTypedTypeStr(op.lhs_buffer().getType()) +
+           this->getTypedTypeStr(op.rhs_buffer().getType()) +
+           this->getTypedTypeStr(op.out_buffer().getType());
+  }
+};
+
 }  // namespace
 
 void populateVMVXToVMPatterns(MLIRContext *context,
                               TypeConverter &typeConverter,
                               SymbolTable &importSymbols,
-                              OwningRewritePatternList &patterns) {}
+                              OwningRewritePatternList &patterns) {
+  patterns.insert<CopyOpConversion>(context, importSymbols, typeConverter,
+                                    "vmvx.copy.2d");
+  patterns.insert<FillOpConversion>(context, importSymbols, typeConverter,
+                                    "vmvx.fill.2d");
+  patterns.insert<UnaryOpConversion>(context, importSymbols, typeConverter,
+                                     "vmvx.");
+  patterns.insert<BinaryOpConversion>(context, importSymbols, typeConverter,
+                                      "vmvx.");
+  patterns.insert<MatmulOpConversion<IREE::VMVX::MatmulOp>>(
+      context, importSymbols, typeConverter, "vmvx.matmul");
+  patterns.insert<MatmulOpConversion<IREE::VMVX::Mmt4dOp>>(
+      context, importSymbols, typeConverter, "vmvx.mmt4d");
+}
 
 }  // namespace iree_compiler
 }  // namespace mlir
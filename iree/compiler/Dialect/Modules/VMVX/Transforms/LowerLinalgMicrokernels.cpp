@@ -0,0 +1,572 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <algorithm>
+#include <array>
+
+#include "iree/compiler/Dialect/HAL/IR/HALOps.h"
+#include "iree/compiler/Dialect/Modules/VMVX/IR/VMVXDialect.h"
+#include "iree/compiler/Dialect/Modules/VMVX/IR/VMVXOps.h"
+#include "iree/compiler/Dialect/Modules/VMVX/Transforms/Passes.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/STLExtras.h"
+#include "mlir/Dialect/Affine/IR/AffineOps.h"
+#include "mlir/Dialect/Linalg/IR/LinalgOps.h"
+#include "mlir/Dialect/Math/IR/Math.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Pass/PassRegistry.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace VMVX {
+
+namespace {
+
+// Matches IREE_VMVX_MATMUL_FLAG_ACCUMULATE in iree/modules/vmvx/module.c.
+static constexpr int32_t kMatmulFlagAccumulate = 1;
+
+// Returns true if buffers of |elementType| can be passed to VMVX ops.
+static bool isSupportedElementType(Type elementType) {
+  return elementType.isF32() || elementType.isF64() ||
+         elementType.isSignlessInteger(8) ||
+         elementType.isSignlessInteger(16) ||
+         elementType.isSignlessInteger(32) ||
+         elementType.isSignlessInteger(64);
+}
+
+static Value materializeIndex(OpBuilder &builder, Location loc,
+                              OpFoldResult value) {
+  if (auto indexValue = value.dyn_cast<Value>()) return indexValue;
+  return builder.createOrFold<ConstantIndexOp>(
+      loc, value.get<Attribute>().cast<IntegerAttr>().getInt());
+}
+
+static bool getStaticStrides(MemRefType type,
+                             SmallVectorImpl<int64_t> &strides) {
+  int64_t offset = 0;
+  if (failed(getStridesAndOffset(type, strides, offset))) return false;
+  return llvm::none_of(strides, [](int64_t stride) {
+    return ShapedType::isDynamicStrideOrOffset(stride);
+  });
+}
+
+// A memref produced by a chain of subviews of a hal.interface.binding.subspan
+// that can be addressed by VMVX ops as an element offset into the binding with
+// static element strides.
+struct ResolvedBuffer {
+  IREE::HAL::InterfaceBindingSubspanOp subspanOp;
+  // Subviews between the subspan and the memref, outermost first.
+  SmallVector<memref::SubViewOp> subViewOps;
+  MemRefType type;
+  // Static element strides of each dimension of |type|.
+  SmallVector<int64_t> strides;
+
+  int64_t getRank() const { return type.getRank(); }
+  Type getElementType() const { return type.getElementType(); }
+};
+
+// Resolves |value| into a ResolvedBuffer without modifying the IR.
+// Returns None if the memref cannot be addressed by VMVX ops, such as when it
+// has dynamic strides or dynamic dimensions that cannot be recovered.
+static Optional<ResolvedBuffer> resolveBuffer(Value value) {
+  auto type = value.getType().dyn_cast<MemRefType>();
+  if (!type || !isSupportedElementType(type.getElementType())) {
+    return llvm::None;
+  }
+  ResolvedBuffer resolved;
+  resolved.type = type;
+  if (!getStaticStrides(type, resolved.strides)) return llvm::None;
+
+  Value source = value;
+  while (auto subViewOp = source.getDefiningOp<memref::SubViewOp>()) {
+    SmallVector<int64_t> sourceStrides;
+    if (!getStaticStrides(subViewOp.getSourceType(), sourceStrides)) {
+      return llvm::None;
+    }
+    resolved.subViewOps.push_back(subViewOp);
+    source = subViewOp.source();
+  }
+  std::reverse(resolved.subViewOps.begin(), resolved.subViewOps.end());
+
+  auto subspanOp = source.getDefiningOp<IREE::HAL::InterfaceBindingSubspanOp>();
+  if (!subspanOp) return llvm::None;
+  auto subspanType = subspanOp.getType().dyn_cast<MemRefType>();
+  if (!subspanType || !subspanType.getAffineMaps().empty()) return llvm::None;
+  // Byte offsets are folded into the element offset; like
+  // FlattenMemRefSubspan we don't handle byte lengths along with them.
+  if (!matchPattern(subspanOp.byte_offset(), m_Zero()) &&
+      subspanOp.byte_length()) {
+    return llvm::None;
+  }
+  resolved.subspanOp = subspanOp;
+
+  // Dynamic dimensions are taken from the sizes of the last subview when it
+  // does not drop any dimensions.
+  for (int64_t i = 0; i < type.getRank(); ++i) {
+    if (!type.isDynamicDim(i)) continue;
+    if (resolved.subViewOps.empty() ||
+        resolved.subViewOps.back().getSourceType().getRank() !=
+            type.getRank()) {
+      return llvm::None;
+    }
+  }
+  return resolved;
+}
+
+// A ResolvedBuffer materialized as VMVX op operands.
+struct BufferTile {
+  // Rank-0/1 view of the entire binding.
+  Value buffer;
+  // Element offset of the memref within |buffer|.
+  Value offset;
+  // Size of each dimension of the memref.
+  SmallVector<Value> sizes;
+};
+
+static BufferTile buildBufferTile(OpBuilder &builder, Location loc,
+                                  const ResolvedBuffer &resolved) {
+  BufferTile tile;
+  auto subspanOp = resolved.subspanOp;
+  Type elementType = resolved.getElementType();
+  Value base = subspanOp.result();
+  tile.offset = builder.createOrFold<ConstantIndexOp>(loc, 0);
+
+  if (!matchPattern(subspanOp.byte_offset(), m_Zero())) {
+    // Address the binding from its start and fold the byte offset into the
+    // element offset. We assume that the byte offset is aligned to the element
+    // size as FlattenMemRefSubspan does.
+    {
+      OpBuilder::InsertionGuard guard(builder);
+      builder.setInsertionPoint(subspanOp);
+      Value zero = builder.createOrFold<ConstantIndexOp>(subspanOp.getLoc(), 0);
+      base = builder.create<IREE::HAL::InterfaceBindingSubspanOp>(
+          subspanOp.getLoc(), subspanOp.getType(), subspanOp.binding(), zero,
+          subspanOp.byte_length());
+    }
+    int64_t elementBytes = (elementType.getIntOrFloatBitWidth() + 7) / 8;
+    AffineExpr sym0 = getAffineSymbolExpr(0, builder.getContext());
+    tile.offset = builder.createOrFold<AffineApplyOp>(
+        loc, AffineMap::get(0, 1, sym0.floorDiv(elementBytes)),
+        ValueRange{subspanOp.byte_offset()});
+  }
+
+  for (auto subViewOp : resolved.subViewOps) {
+    SmallVector<int64_t> sourceStrides;
+    (void)getStaticStrides(subViewOp.getSourceType(), sourceStrides);
+    for (auto it : llvm::enumerate(subViewOp.getMixedOffsets())) {
+      Value subOffset = materializeIndex(builder, loc, it.value());
+      Value stride =
+          builder.createOrFold<ConstantIndexOp>(loc, sourceStrides[it.index()]);
+      Value scaledOffset = builder.createOrFold<MulIOp>(loc, subOffset, stride);
+      tile.offset =
+          builder.createOrFold<AddIOp>(loc, tile.offset, scaledOffset);
+    }
+  }
+
+  // The VMVX ops take rank-0/1 buffers; multi-dimensional bindings are cast
+  // to a 1D view that is resolved when FlattenMemRefSubspan flattens them.
+  if (base.getType().cast<MemRefType>().getRank() > 1) {
+    auto flatType = MemRefType::get({ShapedType::kDynamicSize}, elementType);
+    base = builder.create<UnrealizedConversionCastOp>(loc, flatType, base)
+               .getResult(0);
+  }
+  tile.buffer = base;
+
+  for (int64_t i = 0; i < resolved.getRank(); ++i) {
+    if (resolved.type.isDynamicDim(i)) {
+      tile.sizes.push_back(materializeIndex(
+          builder, loc, resolved.subViewOps.back().getMixedSizes()[i]));
+    } else {
+      tile.sizes.push_back(builder.createOrFold<ConstantIndexOp>(
+          loc, resolved.type.getDimSize(i)));
+    }
+  }
+  return tile;
+}
+
+// Operands of a 2D strided tile. Iteration spaces of rank < 2 are padded with
+// leading unit dimensions that are broadcast with a 0 stride.
+struct Tile2D {
+  Value buffer;
+  Value offset;
+  Value strides[2];
+};
+
+static Tile2D buildTile2D(OpBuilder &builder, Location loc,
+                          const BufferTile &tile,
+                          ArrayRef<int64_t> loopStrides) {
+  Tile2D tile2D;
+  tile2D.buffer = tile.buffer;
+  tile2D.offset = tile.offset;
+  size_t padding = 2 - loopStrides.size();
+  for (size_t i = 0; i < 2; ++i) {
+    int64_t stride = i < padding ? 0 : loopStrides[i - padding];
+    tile2D.strides[i] = builder.createOrFold<ConstantIndexOp>(loc, stride);
+  }
+  return tile2D;
+}
+
+static std::array<Value, 2> buildSizes2D(OpBuilder &builder, Location loc,
+                                         ArrayRef<Value> sizes) {
+  std::array<Value, 2> sizes2D;
+  size_t padding = 2 - sizes.size();
+  for (size_t i = 0; i < 2; ++i) {
+    sizes2D[i] = i < padding ? builder.createOrFold<ConstantIndexOp>(loc, 1)
+                             : sizes[i - padding];
+  }
+  return sizes2D;
+}
+
+// Returns the stride of each loop of an iteration space when walking a buffer
+// with |strides| indexed by the projected permutation |map|. Loops that do not
+// index the buffer are broadcast with a 0 stride.
+static SmallVector<int64_t> getLoopStrides(AffineMap map,
+                                           ArrayRef<int64_t> strides) {
+  SmallVector<int64_t> loopStrides(map.getNumDims(), 0);
+  for (auto it : llvm::enumerate(map.getResults())) {
+    unsigned dim = it.value().cast<AffineDimExpr>().getPosition();
+    loopStrides[dim] = strides[it.index()];
+  }
+  return loopStrides;
+}
+
+// Returns the name of the VMVX elementwise function implementing |op| or an
+// empty string if there is none.
+static StringRef getElementwiseOpcode(Operation *op) {
+  if (op->getNumResults() != 1) return "";
+  Type type = op->getResult(0).getType();
+  if (type.isF32()) {
+    if (isa<AbsFOp>(op)) return "abs";
+    if (isa<AddFOp>(op)) return "add";
+    if (isa<CeilFOp>(op)) return "ceil";
+    if (isa<DivFOp>(op)) return "div";
+    if (isa<math::ExpOp>(op)) return "exp";
+    if (isa<FloorFOp>(op)) return "floor";
+    if (isa<math::LogOp>(op)) return "log";
+    if (isa<MulFOp>(op)) return "mul";
+    if (isa<NegFOp>(op)) return "neg";
+    if (isa<math::RsqrtOp>(op)) return "rsqrt";
+    if (isa<SubFOp>(op)) return "sub";
+  } else if (type.isSignlessInteger(32)) {
+    if (isa<AddIOp>(op)) return "add";
+    if (isa<AndOp>(op)) return "and";
+    if (isa<MulIOp>(op)) return "mul";
+    if (isa<OrOp>(op)) return "or";
+    if (isa<SubIOp>(op)) return "sub";
+    if (isa<XOrOp>(op)) return "xor";
+  }
+  return "";
+}
+
+// The body of an elementwise linalg.generic implemented by a single VMVX op.
+struct ElementwiseBody {
+  // VMVX unary/binary opcode or empty if the body copies an input.
+  StringRef opcode;
+  // Indices of the inputs used as operands, in operand order.
+  SmallVector<unsigned, 2> inputIndices;
+};
+
+static Optional<ElementwiseBody> matchElementwiseBody(
+    linalg::GenericOp genericOp) {
+  Block *body = genericOp.getBody();
+  unsigned numInputs = genericOp.getNumInputs();
+  if (!body->getArgument(numInputs).use_empty()) return llvm::None;
+  auto getInputIndex = [&](Value value) -> Optional<unsigned> {
+    auto arg = value.dyn_cast<BlockArgument>();
+    if (!arg || arg.getOwner() != body || arg.getArgNumber() >= numInputs) {
+      return llvm::None;
+    }
+    return arg.getArgNumber();
+  };
+
+  auto yieldOp = cast<linalg::YieldOp>(body->getTerminator());
+  if (yieldOp.getNumOperands() != 1) return llvm::None;
+  Value yieldedValue = yieldOp.getOperand(0);
+  ElementwiseBody result;
+  if (auto inputIndex = getInputIndex(yieldedValue)) {
+    result.inputIndices.push_back(*inputIndex);
+    return result;
+  }
+
+  Operation *op = yieldedValue.getDefiningOp();
+  if (!op || &body->front() != op || op->getNextNode() != yieldOp) {
+    return llvm::None;
+  }
+  result.opcode = getElementwiseOpcode(op);
+  if (result.opcode.empty()) return llvm::None;
+  for (Value operand : op->getOperands()) {
+    auto inputIndex = getInputIndex(operand);
+    if (!inputIndex) return llvm::None;
+    result.inputIndices.push_back(*inputIndex);
+  }
+  if (result.inputIndices.size() != 1 && result.inputIndices.size() != 2) {
+    return llvm::None;
+  }
+  return result;
+}
+
+//===----------------------------------------------------------------------===//
+// Patterns
+//===----------------------------------------------------------------------===//
+
+// linalg.fill of a 32-bit value -> vmvx.fill
+struct LowerFillOp : public OpRewritePattern<linalg::FillOp> {
+  using OpRewritePattern::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(linalg::FillOp op,
+                                PatternRewriter &rewriter) const override {
+    if (!op.hasBufferSemantics()) return failure();
+    Type valueType = op.value().getType();
+    if (!valueType.isF32() && !valueType.isSignlessInteger(32)) {
+      return failure();
+    }
+    auto out = resolveBuffer(op.output());
+    if (!out || out->getRank() > 2) return failure();
+
+    Location loc = op.getLoc();
+    BufferTile outTile = buildBufferTile(rewriter, loc, *out);
+    Tile2D out2D = buildTile2D(rewriter, loc, outTile, out->strides);
+    auto sizes = buildSizes2D(rewriter, loc, outTile.sizes);
+    rewriter.create<IREE::VMVX::FillOp>(
+        loc, op.value(), out2D.buffer, out2D.offset, out2D.strides[0],
+        out2D.strides[1], sizes[0], sizes[1]);
+    rewriter.eraseOp(op);
+    return success();
+  }
+};
+
+// linalg.copy without permutations -> vmvx.copy
+struct LowerCopyOp : public OpRewritePattern<linalg::CopyOp> {
+  using OpRewritePattern::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(linalg::CopyOp op,
+                                PatternRewriter &rewriter) const override {
+    if (!op.hasBufferSemantics()) return failure();
+    if (op.inputPermutation() || op.outputPermutation()) return failure();
+    auto in = resolveBuffer(op.input());
+    auto out = resolveBuffer(op.output());
+    if (!in || !out || out->getRank() > 2 || in->getRank() != out->getRank() ||
+        in->getElementType() != out->getElementType()) {
+      return failure();
+    }
+
+    Location loc = op.getLoc();
+    BufferTile inTile = buildBufferTile(rewriter, loc, *in);
+    BufferTile outTile = buildBufferTile(rewriter, loc, *out);
+    Tile2D in2D = buildTile2D(rewriter, loc, inTile, in->strides);
+    Tile2D out2D = buildTile2D(rewriter, loc, outTile, out->strides);
+    auto sizes = buildSizes2D(rewriter, loc, outTile.sizes);
+    rewriter.create<IREE::VMVX::CopyOp>(
+        loc, in2D.buffer, in2D.offset, in2D.strides[0], in2D.strides[1],
+        out2D.buffer, out2D.offset, out2D.strides[0], out2D.strides[1],
+        sizes[0], sizes[1]);
+    rewriter.eraseOp(op);
+    return success();
+  }
+};
+
+// Elementwise linalg.generic of rank <= 2 with a body of a single supported op
+// (or a copy of an input) -> vmvx.unary/vmvx.binary/vmvx.copy
+// Inputs may be transposed or broadcast by their indexing maps.
+struct LowerElementwiseGenericOp : public OpRewritePattern<linalg::GenericOp> {
+  using OpRewritePattern::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(linalg::GenericOp op,
+                                PatternRewriter &rewriter) const override {
+    if (!op.hasBufferSemantics() || op.getNumOutputs() != 1) return failure();
+    unsigned numLoops = op.getNumLoops();
+    if (numLoops > 2 || op.getNumParallelLoops() != numLoops) {
+      return failure();
+    }
+    OpOperand *outOperand = op.getOutputOperand(0);
+    if (!op.getTiedIndexingMap(outOperand).isIdentity()) return failure();
+    auto out = resolveBuffer(outOperand->get());
+    if (!out) return failure();
+    auto body = matchElementwiseBody(op);
+    if (!body) return failure();
+
+    SmallVector<ResolvedBuffer, 2> ins;
+    SmallVector<SmallVector<int64_t>, 2> inLoopStrides;
+    for (unsigned inputIndex : body->inputIndices) {
+      OpOperand *inOperand = op.getInputOperand(inputIndex);
+      AffineMap map = op.getTiedIndexingMap(inOperand);
+      if (!map.isProjectedPermutation()) return failure();
+      auto in = resolveBuffer(inOperand->get());
+      if (!in || in->getElementType() != out->getElementType()) {
+        return failure();
+      }
+      inLoopStrides.push_back(getLoopStrides(map, in->strides));
+      ins.push_back(std::move(*in));
+    }
+
+    Location loc = op.getLoc();
+    BufferTile outTile = buildBufferTile(rewriter, loc, *out);
+    Tile2D out2D = buildTile2D(rewriter, loc, outTile, out->strides);
+    auto sizes = buildSizes2D(rewriter, loc, outTile.sizes);
+    SmallVector<Tile2D, 2> ins2D;
+    for (auto it : llvm::enumerate(ins)) {
+      BufferTile inTile = buildBufferTile(rewriter, loc, it.value());
+      ins2D.push_back(
+          buildTile2D(rewriter, loc, inTile, inLoopStrides[it.index()]));
+    }
+
+    if (body->opcode.empty()) {
+      rewriter.create<IREE::VMVX::CopyOp>(
+          loc, ins2D[0].buffer, ins2D[0].offset, ins2D[0].strides[0],
+          ins2D[0].strides[1], out2D.buffer, out2D.offset, out2D.strides[0],
+          out2D.strides[1], sizes[0], sizes[1]);
+    } else if (ins2D.size() == 1) {
+      rewriter.create<IREE::VMVX::UnaryOp>(
+          loc, rewriter.getStringAttr(body->opcode), ins2D[0].buffer,
+          ins2D[0].offset, ins2D[0].strides[0], ins2D[0].strides[1],
+          out2D.buffer, out2D.offset, out2D.strides[0], out2D.strides[1],
+          sizes[0], sizes[1]);
+    } else {
+      rewriter.create<IREE::VMVX::BinaryOp>(
+          loc, rewriter.getStringAttr(body->opcode), ins2D[0].buffer,
+          ins2D[0].offset, ins2D[0].strides[0], ins2D[0].strides[1],
+          ins2D[1].buffer, ins2D[1].offset, ins2D[1].strides[0],
+          ins2D[1].strides[1], out2D.buffer, out2D.offset, out2D.strides[0],
+          out2D.strides[1], sizes[0], sizes[1]);
+    }
+    rewriter.eraseOp(op);
+    return success();
+  }
+};
+
+// f32 linalg.matmul with contiguous rows -> vmvx.matmul
+struct LowerMatmulOp : public OpRewritePattern<linalg::MatmulOp> {
+  using OpRewritePattern::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(linalg::MatmulOp op,
+                                PatternRewriter &rewriter) const override {
+    if (!op.hasBufferSemantics()) return failure();
+    auto lhs = resolveBuffer(op.getInputOperand(0)->get());
+    auto rhs = resolveBuffer(op.getInputOperand(1)->get());
+    auto out = resolveBuffer(op.getOutputOperand(0)->get());
+    if (!lhs || !rhs || !out) return failure();
+    for (auto *buffer : {&*lhs, &*rhs, &*out}) {
+      if (!buffer->getElementType().isF32() || buffer->strides[1] != 1) {
+        return failure();
+      }
+    }
+
+    Location loc = op.getLoc();
+    BufferTile lhsTile = buildBufferTile(rewriter, loc, *lhs);
+    BufferTile rhsTile = buildBufferTile(rewriter, loc, *rhs);
+    BufferTile outTile = buildBufferTile(rewriter, loc, *out);
+    auto getStride = [&](const ResolvedBuffer &buffer) {
+      return rewriter.createOrFold<ConstantIndexOp>(loc, buffer.strides[0]);
+    };
+    rewriter.create<IREE::VMVX::MatmulOp>(
+        loc, lhsTile.buffer, lhsTile.offset, getStride(*lhs), rhsTile.buffer,
+        rhsTile.offset, getStride(*rhs), outTile.buffer, outTile.offset,
+        getStride(*out), /*m=*/lhsTile.sizes[0], /*n=*/rhsTile.sizes[1],
+        /*k=*/lhsTile.sizes[1],
+        rewriter.getI32IntegerAttr(kMatmulFlagAccumulate));
+    rewriter.eraseOp(op);
+    return success();
+  }
+};
+
+// Returns true if the inner three dimensions of the rank-4 |buffer| are dense
+// with static inner tile sizes.
+static bool hasDenseInnerTiles(const ResolvedBuffer &buffer) {
+  if (buffer.getRank() != 4) return false;
+  auto shape = buffer.type.getShape();
+  if (ShapedType::isDynamic(shape[2]) || ShapedType::isDynamic(shape[3])) {
+    return false;
+  }
+  return buffer.strides[3] == 1 && buffer.strides[2] == shape[3] &&
+         buffer.strides[1] == shape[2] * shape[3];
+}
+
+// f32 linalg.mmt4d with dense inner tiles -> vmvx.mmt4d
+struct LowerMmt4DOp : public OpRewritePattern<linalg::Mmt4DOp> {
+  using OpRewritePattern::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(linalg::Mmt4DOp op,
+                                PatternRewriter &rewriter) const override {
+    if (!op.hasBufferSemantics()) return failure();
+    auto lhs = resolveBuffer(op.getInputOperand(0)->get());
+    auto rhs = resolveBuffer(op.getInputOperand(1)->get());
+    auto out = resolveBuffer(op.getOutputOperand(0)->get());
+    if (!lhs || !rhs || !out) return failure();
+    for (auto *buffer : {&*lhs, &*rhs, &*out}) {
+      if (!buffer->getElementType().isF32() || !hasDenseInnerTiles(*buffer)) {
+        return failure();
+      }
+    }
+
+    Location loc = op.getLoc();
+    BufferTile lhsTile = buildBufferTile(rewriter, loc, *lhs);
+    BufferTile rhsTile = buildBufferTile(rewriter, loc, *rhs);
+    BufferTile outTile = buildBufferTile(rewriter, loc, *out);
+    auto getStride = [&](const ResolvedBuffer &buffer) {
+      return rewriter.createOrFold<ConstantIndexOp>(loc, buffer.strides[0]);
+    };
+    auto lhsShape = lhs->type.getShape();
+    auto rhsShape = rhs->type.getShape();
+    rewriter.create<IREE::VMVX::Mmt4dOp>(
+        loc, lhsTile.buffer, lhsTile.offset, getStride(*lhs), rhsTile.buffer,
+        rhsTile.offset, getStride(*rhs), outTile.buffer, outTile.offset,
+        getStride(*out), /*m=*/lhsTile.sizes[0], /*n=*/rhsTile.sizes[0],
+        /*k=*/lhsTile.sizes[1], rewriter.getI32IntegerAttr(lhsShape[2]),
+        rewriter.getI32IntegerAttr(rhsShape[2]),
+        rewriter.getI32IntegerAttr(lhsShape[3]),
+        rewriter.getI32IntegerAttr(kMatmulFlagAccumulate));
+    rewriter.eraseOp(op);
+    return success();
+  }
+};
+
+}  // namespace
+
+// Lowers linalg ops on buffers to VMVX microkernel ops operating on entire
+// tiles. Ops that cannot be lowered are left for the scalar loop lowering.
+class LowerLinalgMicrokernelsPass
+    : public PassWrapper<LowerLinalgMicrokernelsPass, OperationPass<FuncOp>> {
+ public:
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<IREE::VMVX::VMVXDialect, AffineDialect>();
+  }
+
+  StringRef getArgument() const override {
+    return "iree-vmvx-lower-linalg-microkernels";
+  }
+
+  StringRef getDescription() const override {
+    return "Lowers linalg ops on buffers to VMVX microkernel ops";
+  }
+
+  void runOnOperation() override {
+    OwningRewritePatternList patterns(&getContext());
+    patterns.insert<LowerFillOp, LowerCopyOp, LowerElementwiseGenericOp,
+                    LowerMatmulOp, LowerMmt4DOp>(&getContext());
+    if (failed(applyPatternsAndFoldGreedily(getOperation(),
+                                            std::move(patterns)))) {
+      return signalPassFailure();
+    }
+  }
+};
+
+std::unique_ptr<OperationPass<FuncOp>> createLowerLinalgMicrokernelsPass() {
+  return std::make_unique<LowerLinalgMicrokernelsPass>();
+}
+
+static PassRegistration<LowerLinalgMicrokernelsPass> pass;
+
+}  // namespace VMVX
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
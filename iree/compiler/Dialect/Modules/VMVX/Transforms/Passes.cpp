@@ -48,6 +48,9 @@ static void buildVectorVMVXTransformPassPipeline(OpPassManager &passManager) {
   // nestedModulePM.addNestedPass<FuncOp>(
   //     createLinalgTileAndVectorizeWorkgroupsPass());
 
+  // Linalg -> VMVX microkernels for ops on tiles we can address directly.
+  nestedModulePM.addNestedPass<FuncOp>(createLowerLinalgMicrokernelsPass());
+
   // Linalg -> SCF.
   nestedModulePM.addNestedPass<FuncOp>(createConvertLinalgToLoopsPass());
   nestedModulePM.addNestedPass<FuncOp>(createCanonicalizerPass());
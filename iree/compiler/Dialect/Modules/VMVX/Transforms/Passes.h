@@ -44,6 +44,10 @@ void createVMVXTransformPassPipeline();
 // Converts from various dialects (HAL, standard, etc) to the VMVX dialect.
 std::unique_ptr<OperationPass<mlir::ModuleOp>> createConversionPass();
 
+// Lowers linalg ops on buffers with statically strided tiles to VMVX
+// microkernel ops. Ops that don't match are left for the loop lowering.
+std::unique_ptr<OperationPass<FuncOp>> createLowerLinalgMicrokernelsPass();
+
 //===----------------------------------------------------------------------===//
 // Register all Passes
 //===----------------------------------------------------------------------===//
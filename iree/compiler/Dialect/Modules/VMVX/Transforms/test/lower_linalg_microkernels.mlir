@@ -0,0 +1,181 @@
+// RUN: iree-opt -split-input-file -iree-vmvx-lower-linalg-microkernels -canonicalize -cse %s | IreeFileCheck %s
+
+hal.interface @io attributes {sym_visibility = "private"} {
+  hal.interface.binding @s0b0_ro_external, set=0, binding=0, type="StorageBuffer", access="Read"
+  hal.interface.binding @s0b1_ro_external, set=0, binding=1, type="StorageBuffer", access="Read"
+  hal.interface.binding @s0b2_xw_external, set=0, binding=2, type="StorageBuffer", access="Write|Discard"
+}
+
+// CHECK-LABEL: func @add_broadcast_rows
+func @add_broadcast_rows() {
+  //  CHECK-DAG: %[[C0:.+]] = constant 0 : index
+  //  CHECK-DAG: %[[C1:.+]] = constant 1 : index
+  //  CHECK-DAG: %[[C4:.+]] = constant 4 : index
+  //  CHECK-DAG: %[[C32:.+]] = constant 32 : index
+  %c0 = constant 0 : index
+  //  CHECK-DAG: %[[LHS_BINDING:.+]] = hal.interface.binding.subspan @io::@s0b0_ro_external{{.+}} : memref<16x32xf32>
+  //  CHECK-DAG: %[[RHS:.+]] = hal.interface.binding.subspan @io::@s0b1_ro_external{{.+}} : memref<32xf32>
+  //  CHECK-DAG: %[[OUT_BINDING:.+]] = hal.interface.binding.subspan @io::@s0b2_xw_external{{.+}} : memref<16x32xf32>
+  %0 = hal.interface.binding.subspan @io::@s0b0_ro_external[%c0] : memref<16x32xf32>
+  %1 = hal.interface.binding.subspan @io::@s0b1_ro_external[%c0] : memref<32xf32>
+  %2 = hal.interface.binding.subspan @io::@s0b2_xw_external[%c0] : memref<16x32xf32>
+  %workgroup_id_x = hal.interface.workgroup.id[0] : index
+  %3 = affine.apply affine_map<()[s0] -> (s0 * 4)>()[%workgroup_id_x]
+  %4 = memref.subview %0[%3, 0] [4, 32] [1, 1] : memref<16x32xf32> to memref<4x32xf32, affine_map<(d0, d1)[s0] -> (d0 * 32 + s0 + d1)>>
+  %5 = memref.subview %2[%3, 0] [4, 32] [1, 1] : memref<16x32xf32> to memref<4x32xf32, affine_map<(d0, d1)[s0] -> (d0 * 32 + s0 + d1)>>
+  //  CHECK-DAG: %[[OFFSET:.+]] = muli %{{.+}}, %[[C32]] : index
+  //  CHECK-DAG: %[[LHS:.+]] = builtin.unrealized_conversion_cast %[[LHS_BINDING]] : memref<16x32xf32> to memref<?xf32>
+  //  CHECK-DAG: %[[OUT:.+]] = builtin.unrealized_conversion_cast %[[OUT_BINDING]] : memref<16x32xf32> to memref<?xf32>
+  //      CHECK: vmvx.binary "add"
+  // CHECK-SAME:   lhs(%[[LHS]] offset %[[OFFSET]] strides[%[[C32]], %[[C1]]] : memref<?xf32>)
+  // CHECK-SAME:   rhs(%[[RHS]] offset %[[C0]] strides[%[[C0]], %[[C1]]] : memref<32xf32>)
+  // CHECK-SAME:   out(%[[OUT]] offset %[[OFFSET]] strides[%[[C32]], %[[C1]]] : memref<?xf32>)
+  // CHECK-SAME:   sizes(%[[C4]], %[[C32]])
+  //  CHECK-NOT: linalg.generic
+  linalg.generic {
+    indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>,
+                     affine_map<(d0, d1) -> (d1)>,
+                     affine_map<(d0, d1) -> (d0, d1)>],
+    iterator_types = ["parallel", "parallel"]
+  } ins(%4, %1 : memref<4x32xf32, affine_map<(d0, d1)[s0] -> (d0 * 32 + s0 + d1)>>, memref<32xf32>)
+    outs(%5 : memref<4x32xf32, affine_map<(d0, d1)[s0] -> (d0 * 32 + s0 + d1)>>) {
+  ^bb0(%lhs: f32, %rhs: f32, %out: f32):  // no predecessors
+    %6 = addf %lhs, %rhs : f32
+    linalg.yield %6 : f32
+  }
+  return
+}
+
+// -----
+
+hal.interface @io attributes {sym_visibility = "private"} {
+  hal.interface.binding @s0b0_ro_external, set=0, binding=0, type="StorageBuffer", access="Read"
+  hal.interface.binding @s0b1_xw_external, set=0, binding=1, type="StorageBuffer", access="Write|Discard"
+}
+
+// CHECK-LABEL: func @exp_transposed_with_byte_offset
+func @exp_transposed_with_byte_offset() {
+  //  CHECK-DAG: %[[C0:.+]] = constant 0 : index
+  //  CHECK-DAG: %[[C1:.+]] = constant 1 : index
+  //  CHECK-DAG: %[[C8:.+]] = constant 8 : index
+  //  CHECK-DAG: %[[C16:.+]] = constant 16 : index
+  %c0 = constant 0 : index
+  %c64 = constant 64 : index
+  //  CHECK-DAG: %[[IN:.+]] = hal.interface.binding.subspan @io::@s0b0_ro_external[%[[C0]]] : memref<8x16xf32>
+  //  CHECK-DAG: %[[OUT:.+]] = hal.interface.binding.subspan @io::@s0b1_xw_external[%[[C0]]] : memref<16x8xf32>
+  %0 = hal.interface.binding.subspan @io::@s0b0_ro_external[%c64] : memref<8x16xf32>
+  %1 = hal.interface.binding.subspan @io::@s0b1_xw_external[%c0] : memref<16x8xf32>
+  //      CHECK: vmvx.unary "exp"
+  // CHECK-SAME:   in(%{{.+}} offset %[[C16]] strides[%[[C1]], %[[C16]]] : memref<?xf32>)
+  // CHECK-SAME:   out(%{{.+}} offset %[[C0]] strides[%[[C8]], %[[C1]]] : memref<?xf32>)
+  // CHECK-SAME:   sizes(%[[C16]], %[[C8]])
+  linalg.generic {
+    indexing_maps = [affine_map<(d0, d1) -> (d1, d0)>,
+                     affine_map<(d0, d1) -> (d0, d1)>],
+    iterator_types = ["parallel", "parallel"]
+  } ins(%0 : memref<8x16xf32>) outs(%1 : memref<16x8xf32>) {
+  ^bb0(%in: f32, %out: f32):  // no predecessors
+    %2 = math.exp %in : f32
+    linalg.yield %2 : f32
+  }
+  return
+}
+
+// -----
+
+hal.interface @io attributes {sym_visibility = "private"} {
+  hal.interface.binding @s0b0_ro_external, set=0, binding=0, type="StorageBuffer", access="Read"
+  hal.interface.binding @s0b1_ro_external, set=0, binding=1, type="StorageBuffer", access="Read"
+  hal.interface.binding @s0b2_xw_external, set=0, binding=2, type="StorageBuffer", access="Write|Discard"
+}
+
+// CHECK-LABEL: func @fill_and_matmul
+func @fill_and_matmul() {
+  //  CHECK-DAG: %[[C0:.+]] = constant 0 : index
+  //  CHECK-DAG: %[[C1:.+]] = constant 1 : index
+  //  CHECK-DAG: %[[C8:.+]] = constant 8 : index
+  //  CHECK-DAG: %[[C16:.+]] = constant 16 : index
+  //  CHECK-DAG: %[[C32:.+]] = constant 32 : index
+  //  CHECK-DAG: %[[ZERO:.+]] = constant 0.000000e+00 : f32
+  %c0 = constant 0 : index
+  %cst = constant 0.000000e+00 : f32
+  //  CHECK-DAG: %[[LHS_BINDING:.+]] = hal.interface.binding.subspan @io::@s0b0_ro_external
+  //  CHECK-DAG: %[[RHS_BINDING:.+]] = hal.interface.binding.subspan @io::@s0b1_ro_external
+  //  CHECK-DAG: %[[OUT_BINDING:.+]] = hal.interface.binding.subspan @io::@s0b2_xw_external
+  %0 = hal.interface.binding.subspan @io::@s0b0_ro_external[%c0] : memref<64x32xf32>
+  %1 = hal.interface.binding.subspan @io::@s0b1_ro_external[%c0] : memref<32x16xf32>
+  %2 = hal.interface.binding.subspan @io::@s0b2_xw_external[%c0] : memref<64x16xf32>
+  %workgroup_id_x = hal.interface.workgroup.id[0] : index
+  %3 = affine.apply affine_map<()[s0] -> (s0 * 8)>()[%workgroup_id_x]
+  %4 = memref.subview %0[%3, 0] [8, 32] [1, 1] : memref<64x32xf32> to memref<8x32xf32, affine_map<(d0, d1)[s0] -> (d0 * 32 + s0 + d1)>>
+  %5 = memref.subview %2[%3, 0] [8, 16] [1, 1] : memref<64x16xf32> to memref<8x16xf32, affine_map<(d0, d1)[s0] -> (d0 * 16 + s0 + d1)>>
+  //  CHECK-DAG: %[[LHS_OFFSET:.+]] = muli %{{.+}}, %[[C32]] : index
+  //  CHECK-DAG: %[[OUT_OFFSET:.+]] = muli %{{.+}}, %[[C16]] : index
+  //  CHECK-DAG: %[[LHS:.+]] = builtin.unrealized_conversion_cast %[[LHS_BINDING]] : memref<64x32xf32> to memref<?xf32>
+  //  CHECK-DAG: %[[RHS:.+]] = builtin.unrealized_conversion_cast %[[RHS_BINDING]] : memref<32x16xf32> to memref<?xf32>
+  //  CHECK-DAG: %[[OUT:.+]] = builtin.unrealized_conversion_cast %[[OUT_BINDING]] : memref<64x16xf32> to memref<?xf32>
+  //      CHECK: vmvx.fill %[[ZERO]] : f32
+  // CHECK-SAME:   out(%[[OUT]] offset %[[OUT_OFFSET]] strides[%[[C16]], %[[C1]]] : memref<?xf32>)
+  // CHECK-SAME:   sizes(%[[C8]], %[[C16]])
+  linalg.fill(%cst, %5) : f32, memref<8x16xf32, affine_map<(d0, d1)[s0] -> (d0 * 16 + s0 + d1)>>
+  //      CHECK: vmvx.matmul
+  // CHECK-SAME:   lhs(%[[LHS]] offset %[[LHS_OFFSET]] row_stride %[[C32]] : memref<?xf32>)
+  // CHECK-SAME:   rhs(%[[RHS]] offset %[[C0]] row_stride %[[C16]] : memref<?xf32>)
+  // CHECK-SAME:   out(%[[OUT]] offset %[[OUT_OFFSET]] row_stride %[[C16]] : memref<?xf32>)
+  // CHECK-SAME:   mnk(%[[C8]], %[[C16]], %[[C32]])
+  // CHECK-SAME:   {flags = 1 : i32}
+  linalg.matmul ins(%4, %1 : memref<8x32xf32, affine_map<(d0, d1)[s0] -> (d0 * 32 + s0 + d1)>>, memref<32x16xf32>)
+                outs(%5 : memref<8x16xf32, affine_map<(d0, d1)[s0] -> (d0 * 16 + s0 + d1)>>)
+  return
+}
+
+// -----
+
+hal.interface @io attributes {sym_visibility = "private"} {
+  hal.interface.binding @s0b0_ro_external, set=0, binding=0, type="StorageBuffer", access="Read"
+  hal.interface.binding @s0b1_ro_external, set=0, binding=1, type="StorageBuffer", access="Read"
+  hal.interface.binding @s0b2_xw_external, set=0, binding=2, type="StorageBuffer", access="Write|Discard"
+}
+
+// CHECK-LABEL: func @mmt4d
+func @mmt4d() {
+  //  CHECK-DAG: %[[C0:.+]] = constant 0 : index
+  //  CHECK-DAG: %[[C2:.+]] = constant 2 : index
+  //  CHECK-DAG: %[[C6:.+]] = constant 6 : index
+  //  CHECK-DAG: %[[C8:.+]] = constant 8 : index
+  //  CHECK-DAG: %[[C32:.+]] = constant 32 : index
+  //  CHECK-DAG: %[[C128:.+]] = constant 128 : index
+  %c0 = constant 0 : index
+  %0 = hal.interface.binding.subspan @io::@s0b0_ro_external[%c0] : memref<6x2x4x4xf32>
+  %1 = hal.interface.binding.subspan @io::@s0b1_ro_external[%c0] : memref<8x2x4x4xf32>
+  %2 = hal.interface.binding.subspan @io::@s0b2_xw_external[%c0] : memref<6x8x4x4xf32>
+  //      CHECK: vmvx.mmt4d
+  // CHECK-SAME:   lhs(%{{.+}} offset %[[C0]] stride0 %[[C32]] : memref<?xf32>)
+  // CHECK-SAME:   rhs(%{{.+}} offset %[[C0]] stride0 %[[C32]] : memref<?xf32>)
+  // CHECK-SAME:   out(%{{.+}} offset %[[C0]] stride0 %[[C128]] : memref<?xf32>)
+  // CHECK-SAME:   mnk(%[[C6]], %[[C8]], %[[C2]])
+  // CHECK-SAME:   {flags = 1 : i32, k0 = 4 : i32, m0 = 4 : i32, n0 = 4 : i32}
+  linalg.mmt4d ins(%0, %1 : memref<6x2x4x4xf32>, memref<8x2x4x4xf32>) outs(%2 : memref<6x8x4x4xf32>)
+  return
+}
+
+// -----
+
+hal.interface @io attributes {sym_visibility = "private"} {
+  hal.interface.binding @s0b0_ro_external, set=0, binding=0, type="StorageBuffer", access="Read"
+  hal.interface.binding @s0b1_xw_external, set=0, binding=1, type="StorageBuffer", access="Write|Discard"
+}
+
+// Subviews with dynamic strides can't be addressed and are left as-is.
+
+// CHECK-LABEL: func @dynamic_stride_not_lowered
+func @dynamic_stride_not_lowered(%stride: index) {
+  %c0 = constant 0 : index
+  %0 = hal.interface.binding.subspan @io::@s0b0_ro_external[%c0] : memref<64xf32>
+  %1 = hal.interface.binding.subspan @io::@s0b1_xw_external[%c0] : memref<8xf32>
+  %2 = memref.subview %0[0] [8] [%stride] : memref<64xf32> to memref<8xf32, affine_map<(d0)[s0] -> (d0 * s0)>>
+  //  CHECK-NOT: vmvx.copy
+  //      CHECK: linalg.copy
+  linalg.copy(%2, %1) : memref<8xf32, affine_map<(d0)[s0] -> (d0 * s0)>>, memref<8xf32>
+  return
+}
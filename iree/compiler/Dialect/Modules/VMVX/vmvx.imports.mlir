@@ -26,7 +26,369 @@
 vm.module @vmvx {
 
 //===----------------------------------------------------------------------===//
-// VMVX Ops: TODO
+// VMVX Ops: 2D tiles
 //===----------------------------------------------------------------------===//
 
+vm.import @copy.2d.x8(
+  %in_buffer : !vm.buffer,
+  %in_offset : i32,
+  %in_stride0 : i32,
+  %in_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @copy.2d.x16(
+  %in_buffer : !vm.buffer,
+  %in_offset : i32,
+  %in_stride0 : i32,
+  %in_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @copy.2d.x32(
+  %in_buffer : !vm.buffer,
+  %in_offset : i32,
+  %in_stride0 : i32,
+  %in_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @copy.2d.x64(
+  %in_buffer : !vm.buffer,
+  %in_offset : i32,
+  %in_stride0 : i32,
+  %in_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @fill.2d.x32(
+  %value : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @abs.2d.f32(
+  %in_buffer : !vm.buffer,
+  %in_offset : i32,
+  %in_stride0 : i32,
+  %in_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @ceil.2d.f32(
+  %in_buffer : !vm.buffer,
+  %in_offset : i32,
+  %in_stride0 : i32,
+  %in_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @exp.2d.f32(
+  %in_buffer : !vm.buffer,
+  %in_offset : i32,
+  %in_stride0 : i32,
+  %in_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @floor.2d.f32(
+  %in_buffer : !vm.buffer,
+  %in_offset : i32,
+  %in_stride0 : i32,
+  %in_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @log.2d.f32(
+  %in_buffer : !vm.buffer,
+  %in_offset : i32,
+  %in_stride0 : i32,
+  %in_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @neg.2d.f32(
+  %in_buffer : !vm.buffer,
+  %in_offset : i32,
+  %in_stride0 : i32,
+  %in_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @rsqrt.2d.f32(
+  %in_buffer : !vm.buffer,
+  %in_offset : i32,
+  %in_stride0 : i32,
+  %in_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @add.2d.f32(
+  %lhs_buffer : !vm.buffer,
+  %lhs_offset : i32,
+  %lhs_stride0 : i32,
+  %lhs_stride1 : i32,
+  %rhs_buffer : !vm.buffer,
+  %rhs_offset : i32,
+  %rhs_stride0 : i32,
+  %rhs_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @add.2d.i32(
+  %lhs_buffer : !vm.buffer,
+  %lhs_offset : i32,
+  %lhs_stride0 : i32,
+  %lhs_stride1 : i32,
+  %rhs_buffer : !vm.buffer,
+  %rhs_offset : i32,
+  %rhs_stride0 : i32,
+  %rhs_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @and.2d.i32(
+  %lhs_buffer : !vm.buffer,
+  %lhs_offset : i32,
+  %lhs_stride0 : i32,
+  %lhs_stride1 : i32,
+  %rhs_buffer : !vm.buffer,
+  %rhs_offset : i32,
+  %rhs_stride0 : i32,
+  %rhs_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @div.2d.f32(
+  %lhs_buffer : !vm.buffer,
+  %lhs_offset : i32,
+  %lhs_stride0 : i32,
+  %lhs_stride1 : i32,
+  %rhs_buffer : !vm.buffer,
+  %rhs_offset : i32,
+  %rhs_stride0 : i32,
+  %rhs_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @mul.2d.f32(
+  %lhs_buffer : !vm.buffer,
+  %lhs_offset : i32,
+  %lhs_stride0 : i32,
+  %lhs_stride1 : i32,
+  %rhs_buffer : !vm.buffer,
+  %rhs_offset : i32,
+  %rhs_stride0 : i32,
+  %rhs_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @mul.2d.i32(
+  %lhs_buffer : !vm.buffer,
+  %lhs_offset : i32,
+  %lhs_stride0 : i32,
+  %lhs_stride1 : i32,
+  %rhs_buffer : !vm.buffer,
+  %rhs_offset : i32,
+  %rhs_stride0 : i32,
+  %rhs_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @or.2d.i32(
+  %lhs_buffer : !vm.buffer,
+  %lhs_offset : i32,
+  %lhs_stride0 : i32,
+  %lhs_stride1 : i32,
+  %rhs_buffer : !vm.buffer,
+  %rhs_offset : i32,
+  %rhs_stride0 : i32,
+  %rhs_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @sub.2d.f32(
+  %lhs_buffer : !vm.buffer,
+  %lhs_offset : i32,
+  %lhs_stride0 : i32,
+  %lhs_stride1 : i32,
+  %rhs_buffer : !vm.buffer,
+  %rhs_offset : i32,
+  %rhs_stride0 : i32,
+  %rhs_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @sub.2d.i32(
+  %lhs_buffer : !vm.buffer,
+  %lhs_offset : i32,
+  %lhs_stride0 : i32,
+  %lhs_stride1 : i32,
+  %rhs_buffer : !vm.buffer,
+  %rhs_offset : i32,
+  %rhs_stride0 : i32,
+  %rhs_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @xor.2d.i32(
+  %lhs_buffer : !vm.buffer,
+  %lhs_offset : i32,
+  %lhs_stride0 : i32,
+  %lhs_stride1 : i32,
+  %rhs_buffer : !vm.buffer,
+  %rhs_offset : i32,
+  %rhs_stride0 : i32,
+  %rhs_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+//===----------------------------------------------------------------------===//
+// VMVX Ops: Matrix multiplication
+//===----------------------------------------------------------------------===//
+
+vm.import @matmul.f32f32f32(
+  %lhs_buffer : !vm.buffer,
+  %lhs_offset : i32,
+  %lhs_row_stride : i32,
+  %rhs_buffer : !vm.buffer,
+  %rhs_offset : i32,
+  %rhs_row_stride : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_row_stride : i32,
+  %m : i32,
+  %n : i32,
+  %k : i32,
+  %flags : i32
+)
+
+vm.import @mmt4d.f32f32f32(
+  %lhs_buffer : !vm.buffer,
+  %lhs_offset : i32,
+  %lhs_stride0 : i32,
+  %rhs_buffer : !vm.buffer,
+  %rhs_offset : i32,
+  %rhs_stride0 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %m : i32,
+  %n : i32,
+  %k : i32,
+  %m0 : i32,
+  %n0 : i32,
+  %k0 : i32,
+  %flags : i32
+)
+
 }  // module
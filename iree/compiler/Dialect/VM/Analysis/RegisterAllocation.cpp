@@ -146,6 +146,48 @@ struct RegisterUsage {
     }
   }
 
+  // Allocates exactly |reg| if all of its ordinals are available.
+  // Returns false and leaves the usage unchanged if any are in use.
+  bool tryAllocateRegister(Register reg) {
+    int ordinalStart = reg.ordinal();
+    if (reg.isRef()) {
+      if (ordinalStart >= Register::kRefRegisterCount ||
+          refRegisters.test(ordinalStart)) {
+        return false;
+      }
+    } else {
+      unsigned int ordinalEnd = ordinalStart + (reg.byteWidth() / 4) - 1;
+      if (ordinalEnd >= Register::kInt32RegisterCount) {
+        return false;
+      }
+      for (unsigned int ordinal = ordinalStart; ordinal <= ordinalEnd;
+           ++ordinal) {
+        if (intRegisters.test(ordinal)) return false;
+      }
+    }
+    markRegisterUsed(reg);
+    return true;
+  }
+
+  // Allocates a register for |type| preferring the first of |hints| that is
+  // compatible with the type and currently available. Falls back to the first
+  // available register when no hint can be satisfied.
+  Optional<Register> allocateRegister(Type type, ArrayRef<Register> hints) {
+    for (auto hint : hints) {
+      if (type.isIntOrFloat()) {
+        if (hint.isRef() ||
+            hint.byteWidth() != type.getIntOrFloatBitWidth() / 8) {
+          continue;
+        }
+      } else if (!hint.isRef()) {
+        continue;
+      }
+      auto reg = hint.asBaseRegister();
+      if (tryAllocateRegister(reg)) return reg;
+    }
+    return allocateRegister(type);
+  }
+
   void markRegisterUsed(Register reg) {
     int ordinalStart = reg.ordinal();
     if (reg.isRef()) {
@@ -202,15 +244,69 @@ static SmallVector<Block *, 8> sortBlocksInDominanceOrder(
   return orderedBlocks;
 }
 
+// Returns the registers already assigned to the values passed to |blockArg|
+// along each predecessor edge. Edges from predecessors that have not yet been
+// allocated (such as loop back-edges) are skipped.
+static SmallVector<Register, 4> getIncomingRegisterHints(
+    BlockArgument blockArg, const llvm::DenseMap<Value, Register> &map) {
+  SmallVector<Register, 4> hints;
+  auto *block = blockArg.getOwner();
+  for (auto it = block->pred_begin(); it != block->pred_end(); ++it) {
+    auto branchOp = dyn_cast<BranchOpInterface>((*it)->getTerminator());
+    if (!branchOp) continue;
+    auto operands = branchOp.getSuccessorOperands(it.getSuccessorIndex());
+    if (!operands.hasValue()) continue;
+    auto mapIt = map.find((*operands)[blockArg.getArgNumber()]);
+    if (mapIt != map.end()) hints.push_back(mapIt->second);
+  }
+  return hints;
+}
+
+// Returns the registers already assigned to the successor block arguments that
+// |value| is passed to by branches. Only block arguments that have been
+// allocated (such as loop headers reached by a back-edge) produce hints.
+static SmallVector<Register, 4> getOutgoingRegisterHints(
+    Value value, const llvm::DenseMap<Value, Register> &map) {
+  SmallVector<Register, 4> hints;
+  for (auto &use : value.getUses()) {
+    auto *op = use.getOwner();
+    auto branchOp = dyn_cast<BranchOpInterface>(op);
+    if (!branchOp) continue;
+    for (unsigned i = 0; i < op->getNumSuccessors(); ++i) {
+      auto operands = branchOp.getSuccessorOperands(i);
+      if (!operands.hasValue() || operands->empty()) continue;
+      unsigned beginIndex = operands->getBeginOperandIndex();
+      unsigned operandIndex = use.getOperandNumber();
+      if (operandIndex < beginIndex ||
+          operandIndex >= beginIndex + operands->size()) {
+        continue;
+      }
+      auto targetArg =
+          op->getSuccessor(i)->getArgument(operandIndex - beginIndex);
+      auto mapIt = map.find(targetArg);
+      if (mapIt != map.end()) hints.push_back(mapIt->second);
+    }
+  }
+  return hints;
+}
+
 // NOTE: this is not a good algorithm, nor is it a good allocator. If you're
 // looking at this and have ideas of how to do this for real please feel
 // free to rip it all apart :)
 //
-// Because I'm lazy we really only look at individual blocks at a time. It'd
-// be much better to use dominance info to track values across blocks and
-// ensure we are avoiding as many moves as possible. The special case we need to
-// handle is when values are not defined within the current block (as values in
-// dominators are allowed to cross block boundaries outside of arguments).
+// We only look at individual blocks at a time and rely on the dominance order
+// walk to know the registers of all implicitly captured values. The special
+// case we need to handle is when values are not defined within the current
+// block (as values in dominators are allowed to cross block boundaries outside
+// of arguments).
+//
+// To reduce the number of moves required on branch edges registers are
+// coalesced across edges where possible: block arguments prefer the registers
+// of the values passed to them by already-allocated predecessors and values
+// passed along branches prefer the registers of already-allocated successor
+// block arguments (loop back-edges). Coalescing only ever selects among
+// registers that are free at the point of allocation and so never extends
+// register pressure beyond what the predecessors already required.
 LogicalResult RegisterAllocation::recalculate(IREE::VM::FuncOp funcOp) {
   map_.clear();
 
@@ -237,9 +333,12 @@ LogicalResult RegisterAllocation::recalculate(IREE::VM::FuncOp funcOp) {
       registerUsage.markRegisterUsed(mapToRegister(liveInValue));
     }
 
-    // Allocate arguments first from left-to-right.
+    // Allocate arguments first from left-to-right. The entry block has no
+    // predecessors and will always receive its arguments in order as required
+    // by the calling convention.
     for (auto blockArg : block->getArguments()) {
-      auto reg = registerUsage.allocateRegister(blockArg.getType());
+      auto reg = registerUsage.allocateRegister(
+          blockArg.getType(), getIncomingRegisterHints(blockArg, map_));
       if (!reg.hasValue()) {
         return funcOp.emitError() << "register allocation failed for block arg "
                                   << blockArg.getArgNumber();
@@ -265,7 +364,8 @@ LogicalResult RegisterAllocation::recalculate(IREE::VM::FuncOp funcOp) {
         }
       }
       for (auto result : op.getResults()) {
-        auto reg = registerUsage.allocateRegister(result.getType());
+        auto reg = registerUsage.allocateRegister(
+            result.getType(), getOutgoingRegisterHints(result, map_));
         if (!reg.hasValue()) {
           return op.emitError() << "register allocation failed for result "
                                 << result.cast<OpResult>().getResultNumber();
@@ -510,6 +610,11 @@ RegisterAllocation::remapSuccessorRegisters(Operation *op, int successorIndex) {
   for (auto it : llvm::enumerate(*operands)) {
     auto srcReg = mapToRegister(it.value());
     BlockArgument targetArg = targetBlock->getArgument(it.index());
+    if (targetArg.use_empty()) {
+      // Unused block arguments have their registers released on entry to the
+      // target block and there's no need to populate them.
+      continue;
+    }
     auto dstReg = mapToRegister(targetArg);
     if (srcReg != dstReg) {
       srcDstRegs.push_back({srcReg, dstReg});
@@ -1747,6 +1747,20 @@ class ReturnOpConversion : public OpConversionPattern<IREE::VM::ReturnOp> {
   }
 };
 
+// EmitC modules always run their functions to completion so yields are
+// dropped, matching the behavior of the interpreter on non-resumable stacks.
+class YieldOpConversion : public OpConversionPattern<IREE::VM::YieldOp> {
+  using OpConversionPattern<IREE::VM::YieldOp>::OpConversionPattern;
+
+ private:
+  LogicalResult matchAndRewrite(
+      IREE::VM::YieldOp op, ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const override {
+    rewriter.eraseOp(op);
+    return success();
+  }
+};
+
 class FailOpConversion : public OpConversionPattern<IREE::VM::FailOp> {
   using OpConversionPattern<IREE::VM::FailOp>::OpConversionPattern;
 
@@ -1965,6 +1979,116 @@ class GlobalStoreOpConversion : public OpConversionPattern<StoreOpTy> {
   StringRef funcName;
 };
 
+// Convert vm buffer operations (and other ops taking multiple refs, such as
+// vm.list.copy) to a call of the failable helper with the given name from
+// ops.h. The operands are passed through followed by a pointer to the result,
+// if any. Ops that allocate a new buffer additionally receive the module state
+// allocator as their first argument.
+template <typename SrcOpTy>
+class BufferOpConversion : public OpConversionPattern<SrcOpTy> {
+  using OpConversionPattern<SrcOpTy>::OpConversionPattern;
+
+ public:
+  BufferOpConversion(MLIRContext *context, StringRef funcName,
+                     VMAnalysisCache &vmAnalysisCache,
+                     bool needsAllocator = false)
+      : OpConversionPattern<SrcOpTy>(context),
+        funcName(funcName),
+        vmAnalysisCache(vmAnalysisCache),
+        needsAllocator(needsAllocator) {}
+
+ private:
+  LogicalResult matchAndRewrite(
+      SrcOpTy op, ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const override {
+    auto ctx = op.getContext();
+    auto loc = op.getLoc();
+
+    auto funcOp = op.getOperation()->template getParentOfType<mlir::FuncOp>();
+
+    SmallVector<Value, 6> callOperands;
+
+    if (needsAllocator) {
+      BlockArgument stateArg = funcOp.getArgument(2);
+      auto allocatorOp = rewriter.create<emitc::CallOp>(
+          /*location=*/loc,
+          /*type=*/emitc::OpaqueType::get(ctx, "iree_allocator_t"),
+          /*callee=*/StringAttr::get(ctx, "EMITC_STRUCT_PTR_MEMBER"),
+          /*args=*/
+          ArrayAttr::get(ctx, {rewriter.getIndexAttr(0),
+                               emitc::OpaqueAttr::get(ctx, "allocator")}),
+          /*templateArgs=*/ArrayAttr{},
+          /*operands=*/ArrayRef<Value>{stateArg});
+      callOperands.push_back(allocatorOp.getResult(0));
+    }
+
+    callOperands.append(operands.begin(), operands.end());
+
+    // The value replacing the op result, if any.
+    Optional<Value> replacement;
+
+    if (op.getOperation()->getNumResults() == 1) {
+      Value result = op.getOperation()->getResult(0);
+
+      if (result.getType().template isa<IREE::VM::RefType>()) {
+        auto ref = findRef(funcOp, vmAnalysisCache, result);
+
+        if (!ref.hasValue()) {
+          return op.emitError() << "local ref not found";
+        }
+
+        auto refPtrOp = rewriter.create<emitc::ApplyOp>(
+            /*location=*/loc,
+            /*type=*/emitc::OpaqueType::get(ctx, "iree_vm_ref_t*"),
+            /*applicableOperator=*/StringAttr::get(ctx, "&"),
+            /*operand=*/ref.getValue());
+
+        callOperands.push_back(refPtrOp.getResult());
+        replacement = refPtrOp.getResult();
+      } else {
+        Optional<std::string> cType = getCType(result.getType());
+        if (!cType.hasValue()) {
+          return op.emitError() << "unable to emit C type";
+        }
+
+        auto valueOp = rewriter.create<emitc::ConstantOp>(
+            /*location=*/loc,
+            /*resultType=*/result.getType(),
+            /*value=*/emitc::OpaqueAttr::get(ctx, ""));
+
+        auto valuePtrOp = rewriter.create<emitc::ApplyOp>(
+            /*location=*/loc,
+            /*result=*/emitc::OpaqueType::get(ctx, cType.getValue() + "*"),
+            /*applicableOperator=*/StringAttr::get(ctx, "&"),
+            /*operand=*/valueOp.getResult());
+
+        callOperands.push_back(valuePtrOp.getResult());
+        replacement = valueOp.getResult();
+      }
+    }
+
+    returnIfError(
+        /*rewriter=*/rewriter,
+        /*location=*/loc,
+        /*callee=*/StringAttr::get(ctx, funcName),
+        /*args=*/ArrayAttr{},
+        /*templateArgs=*/ArrayAttr{},
+        /*operands=*/callOperands);
+
+    if (replacement.hasValue()) {
+      rewriter.replaceOp(op, replacement.getValue());
+    } else {
+      rewriter.eraseOp(op);
+    }
+
+    return success();
+  }
+
+  StringRef funcName;
+  VMAnalysisCache &vmAnalysisCache;
+  bool needsAllocator;
+};
+
 // Convert vm list operations to two emitc calls. The wrapping ref pointer
 // is first dereferenced and the result is used as the argument of the
 // specified function name.
@@ -2183,6 +2307,10 @@ class ListGetOpConversion : public OpConversionPattern<GetOpTy> {
               return std::make_pair(StringRef("IREE_VM_VALUE_TYPE_I64"),
                                     StringRef("iree_vm_value_get_i64"));
             })
+            .template Case<IREE::VM::ListGetF32Op>([&](auto op) {
+              return std::make_pair(StringRef("IREE_VM_VALUE_TYPE_F32"),
+                                    StringRef("iree_vm_value_get_f32"));
+            })
             .Default([](Operation *) { return std::make_pair(None, None); });
 
     if (!valueTypeEnum.hasValue() || !valueExtractor.hasValue()) {
@@ -2437,6 +2565,8 @@ class ListSetOpConversion : public OpConversionPattern<SetOpTy> {
                 [&](auto op) { return StringRef("iree_vm_value_make_i32"); })
             .template Case<IREE::VM::ListSetI64Op>(
                 [&](auto op) { return StringRef("iree_vm_value_make_i64"); })
+            .template Case<IREE::VM::ListSetF32Op>(
+                [&](auto op) { return StringRef("iree_vm_value_make_f32"); })
             .Default([](Operation *) { return None; });
 
     if (!valueConstructor.hasValue()) {
@@ -2561,6 +2691,7 @@ void populateVMToEmitCPatterns(MLIRContext *context,
   patterns.insert<FailOpConversion>(context);
   patterns.insert<FuncOpConversion>(typeConverter, context, vmAnalysisCache);
   patterns.insert<ReturnOpConversion>(context);
+  patterns.insert<YieldOpConversion>(context);
 
   // Globals
   patterns.insert<
@@ -2576,6 +2707,40 @@ void populateVMToEmitCPatterns(MLIRContext *context,
   patterns.insert<ConstRefZeroOpConversion>(context, vmAnalysisCache);
   patterns.insert<ConstRefRodataOpConversion>(context, vmAnalysisCache);
 
+  // Buffer ops
+  patterns.insert<BufferOpConversion<IREE::VM::BufferAllocOp>>(
+      context, "vm_buffer_alloc", vmAnalysisCache, /*needsAllocator=*/true);
+  patterns.insert<BufferOpConversion<IREE::VM::BufferCloneOp>>(
+      context, "vm_buffer_clone", vmAnalysisCache, /*needsAllocator=*/true);
+  patterns.insert<BufferOpConversion<IREE::VM::BufferLengthOp>>(
+      context, "vm_buffer_length", vmAnalysisCache);
+  patterns.insert<BufferOpConversion<IREE::VM::BufferCopyOp>>(
+      context, "vm_buffer_copy", vmAnalysisCache);
+  patterns.insert<BufferOpConversion<IREE::VM::BufferCompareOp>>(
+      context, "vm_buffer_compare", vmAnalysisCache);
+  patterns.insert<BufferOpConversion<IREE::VM::BufferFillI8Op>>(
+      context, "vm_buffer_fill_i8", vmAnalysisCache);
+  patterns.insert<BufferOpConversion<IREE::VM::BufferFillI16Op>>(
+      context, "vm_buffer_fill_i16", vmAnalysisCache);
+  patterns.insert<BufferOpConversion<IREE::VM::BufferFillI32Op>>(
+      context, "vm_buffer_fill_i32", vmAnalysisCache);
+  patterns.insert<BufferOpConversion<IREE::VM::BufferLoadI8UOp>>(
+      context, "vm_buffer_load_i8u", vmAnalysisCache);
+  patterns.insert<BufferOpConversion<IREE::VM::BufferLoadI8SOp>>(
+      context, "vm_buffer_load_i8s", vmAnalysisCache);
+  patterns.insert<BufferOpConversion<IREE::VM::BufferLoadI16UOp>>(
+      context, "vm_buffer_load_i16u", vmAnalysisCache);
+  patterns.insert<BufferOpConversion<IREE::VM::BufferLoadI16SOp>>(
+      context, "vm_buffer_load_i16s", vmAnalysisCache);
+  patterns.insert<BufferOpConversion<IREE::VM::BufferLoadI32Op>>(
+      context, "vm_buffer_load_i32", vmAnalysisCache);
+  patterns.insert<BufferOpConversion<IREE::VM::BufferStoreI8Op>>(
+      context, "vm_buffer_store_i8", vmAnalysisCache);
+  patterns.insert<BufferOpConversion<IREE::VM::BufferStoreI16Op>>(
+      context, "vm_buffer_store_i16", vmAnalysisCache);
+  patterns.insert<BufferOpConversion<IREE::VM::BufferStoreI32Op>>(
+      context, "vm_buffer_store_i32", vmAnalysisCache);
+
   // List ops
   patterns.insert<ListAllocOpConversion>(typeConverter, context,
                                          vmAnalysisCache);
@@ -2589,6 +2754,8 @@ void populateVMToEmitCPatterns(MLIRContext *context,
   patterns.insert<ListGetRefOpConversion>(context, vmAnalysisCache);
   patterns.insert<ListSetOpConversion<IREE::VM::ListSetI32Op>>(context);
   patterns.insert<ListSetRefOpConversion>(context, vmAnalysisCache);
+  patterns.insert<BufferOpConversion<IREE::VM::ListCopyOp>>(
+      context, "vm_list_copy", vmAnalysisCache);
 
   // Conditional assignment ops
   patterns.insert<GenericOpConversion<IREE::VM::SelectI32Op>>(context,
@@ -2666,6 +2833,10 @@ void populateVMToEmitCPatterns(MLIRContext *context,
                                           IREE::VM::GlobalF32Op>>(
       context, "vm_global_store_f32");
 
+  // ExtF32: List ops
+  patterns.insert<ListGetOpConversion<IREE::VM::ListGetF32Op>>(context);
+  patterns.insert<ListSetOpConversion<IREE::VM::ListSetF32Op>>(context);
+
   // ExtF32: Native floating-point constants
   patterns.insert<ConstOpConversion<IREE::VM::ConstF32Op>>(context);
   patterns.insert<ConstZeroOpConversion<IREE::VM::ConstF32ZeroOp>>(context);
@@ -0,0 +1,58 @@
+// RUN: iree-opt -split-input-file -pass-pipeline='vm.module(iree-convert-vm-to-emitc)' %s | IreeFileCheck %s
+
+// CHECK-LABEL: @my_module_buffer_alloc
+vm.module @my_module {
+  vm.func @buffer_alloc(%arg0 : i32) -> !vm.buffer {
+    // CHECK: %[[ALLOCATOR:.+]] = emitc.call "EMITC_STRUCT_PTR_MEMBER"(%arg2) {args = [0 : index, #emitc.opaque<"allocator">]}
+    // CHECK: %[[REF:.+]] = emitc.apply "&"(%{{.+}}) : (!emitc.opaque<"iree_vm_ref_t">) -> !emitc.opaque<"iree_vm_ref_t*">
+    // CHECK: emitc.call "vm_buffer_alloc"(%[[ALLOCATOR]], %arg3, %[[REF]])
+    %0 = vm.buffer.alloc %arg0 : !vm.buffer
+    vm.return %0 : !vm.buffer
+  }
+}
+
+// -----
+
+// CHECK-LABEL: @my_module_buffer_length
+vm.module @my_module {
+  vm.func @buffer_length(%arg0 : !vm.buffer) -> i32 {
+    // CHECK: %[[RESULT_PTR:.+]] = emitc.apply "&"(%{{.+}}) : (i32) -> !emitc.opaque<"int32_t*">
+    // CHECK: emitc.call "vm_buffer_length"(%arg3, %[[RESULT_PTR]])
+    %0 = vm.buffer.length %arg0 : !vm.buffer -> i32
+    vm.return %0 : i32
+  }
+}
+
+// -----
+
+// CHECK-LABEL: @my_module_buffer_load_i8s
+vm.module @my_module {
+  vm.func @buffer_load_i8s(%arg0 : !vm.buffer, %arg1 : i32) -> i32 {
+    // CHECK: %[[RESULT_PTR:.+]] = emitc.apply "&"(%{{.+}}) : (i32) -> !emitc.opaque<"int32_t*">
+    // CHECK: emitc.call "vm_buffer_load_i8s"(%arg3, %arg4, %[[RESULT_PTR]])
+    %0 = vm.buffer.load.i8.s %arg0[%arg1] : !vm.buffer -> i32
+    vm.return %0 : i32
+  }
+}
+
+// -----
+
+// CHECK-LABEL: @my_module_buffer_store_i32
+vm.module @my_module {
+  vm.func @buffer_store_i32(%arg0 : !vm.buffer, %arg1 : i32, %arg2 : i32) {
+    // CHECK: emitc.call "vm_buffer_store_i32"(%arg3, %arg4, %arg5)
+    vm.buffer.store.i32 %arg2, %arg0[%arg1] : i32 -> !vm.buffer
+    vm.return
+  }
+}
+
+// -----
+
+// CHECK-LABEL: @my_module_buffer_fill_i16
+vm.module @my_module {
+  vm.func @buffer_fill_i16(%arg0 : !vm.buffer, %arg1 : i32, %arg2 : i32, %arg3 : i32) {
+    // CHECK: emitc.call "vm_buffer_fill_i16"(%arg3, %arg4, %arg5, %arg6)
+    vm.buffer.fill.i16 %arg0, %arg1, %arg2, %arg3 : i32 -> !vm.buffer
+    vm.return
+  }
+}
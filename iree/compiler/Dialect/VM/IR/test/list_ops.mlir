@@ -19,6 +19,9 @@ vm.module @module {
     %c44 = vm.const.i32 44 : i32
     vm.list.resize %list, %c44 : (!vm.list<i32>, i32)
 
+    // CHECK: vm.list.copy %list, %c42, %list, %c43, %c44 : !vm.list<i32> -> !vm.list<i32>
+    vm.list.copy %list, %c42, %list, %c43, %c44 : !vm.list<i32> -> !vm.list<i32>
+
     vm.return
   }
 }
@@ -228,6 +228,36 @@ class V0BytecodeEncoder : public BytecodeEncoder {
     return writeUint16(reg);
   }
 
+  // Encodes |cmpOp| and the |condBranchOp| consuming its result as the single
+  // |opcode| superinstruction. The comparison result is never materialized.
+  LogicalResult encodeFusedCondBranch(Operation *cmpOp,
+                                      IREE::VM::CondBranchOp condBranchOp,
+                                      IREE::VM::Opcode opcode) {
+    currentOp_ = cmpOp;
+    if (opcode == IREE::VM::Opcode::CondBranch) {
+      // vm.cmp.nz.i32 is redundant as vm.cond_br already tests for non-zero.
+      if (failed(writeUint8(static_cast<uint8_t>(opcode))) ||
+          failed(encodeOperand(cmpOp->getOperand(0), 0))) {
+        return failure();
+      }
+    } else {
+      if (failed(writeUint8(static_cast<uint8_t>(opcode))) ||
+          failed(encodeOperand(cmpOp->getOperand(0), 0)) ||
+          failed(encodeOperand(cmpOp->getOperand(1), 1))) {
+        return failure();
+      }
+    }
+    currentOp_ = condBranchOp.getOperation();
+    if (failed(encodeBranch(condBranchOp.getTrueDest(),
+                            condBranchOp.getTrueOperands(), 0)) ||
+        failed(encodeBranch(condBranchOp.getFalseDest(),
+                            condBranchOp.getFalseOperands(), 1))) {
+      return failure();
+    }
+    currentOp_ = nullptr;
+    return success();
+  }
+
   LogicalResult encodeResults(Operation::result_range values) override {
     if (failed(ensureAlignment(2)) ||
         failed(writeUint16(std::distance(values.begin(), values.end())))) {
@@ -324,12 +354,35 @@ class V0BytecodeEncoder : public BytecodeEncoder {
   std::vector<std::pair<Block *, size_t>> blockOffsetFixups_;
 };
 
+// Returns the superinstruction opcode that |op| and the |nextOp| following it
+// can be fused into, if any.
+static Optional<IREE::VM::Opcode> matchFusedCondBranch(Operation *op,
+                                                       Operation *nextOp) {
+  auto condBranchOp = dyn_cast_or_null<IREE::VM::CondBranchOp>(nextOp);
+  if (!condBranchOp || op->getNumResults() != 1 ||
+      condBranchOp.condition() != op->getResult(0) ||
+      !op->getResult(0).hasOneUse()) {
+    return llvm::None;
+  }
+  if (isa<IREE::VM::CmpEQI32Op>(op)) return IREE::VM::Opcode::CondBranchEQI32;
+  if (isa<IREE::VM::CmpNEI32Op>(op)) return IREE::VM::Opcode::CondBranchNEI32;
+  if (isa<IREE::VM::CmpLTI32SOp>(op)) {
+    return IREE::VM::Opcode::CondBranchLTI32S;
+  }
+  if (isa<IREE::VM::CmpLTI32UOp>(op)) {
+    return IREE::VM::Opcode::CondBranchLTI32U;
+  }
+  if (isa<IREE::VM::CmpNZI32Op>(op)) return IREE::VM::Opcode::CondBranch;
+  return llvm::None;
+}
+
 }  // namespace
 
 // static
 Optional<EncodedBytecodeFunction> BytecodeEncoder::encodeFunction(
     IREE::VM::FuncOp funcOp, llvm::DenseMap<Type, int> &typeTable,
-    SymbolTable &symbolTable, DebugDatabaseBuilder &debugDatabase) {
+    SymbolTable &symbolTable, DebugDatabaseBuilder &debugDatabase,
+    bool emitSuperinstructions) {
   EncodedBytecodeFunction result;
 
   // Perform register allocation first so that we can quickly lookup values as
@@ -349,7 +402,23 @@ Optional<EncodedBytecodeFunction> BytecodeEncoder::encodeFunction(
       return llvm::None;
     }
 
-    for (auto &op : block.getOperations()) {
+    for (auto opIt = block.begin(); opIt != block.end(); ++opIt) {
+      auto &op = *opIt;
+      if (emitSuperinstructions && std::next(opIt) != block.end()) {
+        auto *nextOp = &*std::next(opIt);
+        if (auto opcode = matchFusedCondBranch(&op, nextOp)) {
+          sourceMap.locations.push_back(
+              {static_cast<int32_t>(encoder.getOffset()), op.getLoc()});
+          if (failed(encoder.encodeFusedCondBranch(
+                  &op, cast<IREE::VM::CondBranchOp>(nextOp),
+                  opcode.getValue()))) {
+            op.emitOpError() << "failed to encode fused branch";
+            return llvm::None;
+          }
+          ++opIt;
+          continue;
+        }
+      }
       auto serializableOp = dyn_cast<IREE::VM::VMSerializableOp>(op);
       if (!serializableOp) {
         op.emitOpError() << "is not serializable";
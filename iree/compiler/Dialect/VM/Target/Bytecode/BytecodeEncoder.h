@@ -32,10 +32,13 @@ struct EncodedBytecodeFunction {
 class BytecodeEncoder : public VMFuncEncoder {
  public:
   // Encodes a vm.func to bytecode and returns the result.
+  // If |emitSuperinstructions| is set then common op sequences are fused into
+  // single opcodes where possible.
   // Returns None on failure.
   static Optional<EncodedBytecodeFunction> encodeFunction(
       IREE::VM::FuncOp funcOp, llvm::DenseMap<Type, int> &typeTable,
-      SymbolTable &symbolTable, DebugDatabaseBuilder &debugDatabase);
+      SymbolTable &symbolTable, DebugDatabaseBuilder &debugDatabase,
+      bool emitSuperinstructions = true);
 
   BytecodeEncoder() = default;
   ~BytecodeEncoder() = default;
@@ -23,9 +23,12 @@
 #include "iree/compiler/Utils/TracingUtils.h"
 #include "iree/schemas/bytecode_module_def_builder.h"
 #include "iree/schemas/bytecode_module_def_json_printer.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/MathExtras.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/Diagnostics.h"
@@ -47,6 +50,28 @@ namespace {
 
 using namespace llvm::support;
 
+// Serialized size of each section of a module in bytes, including the alignment
+// padding emitted along with the section.
+struct SizeReport {
+  size_t rodata = 0;
+  size_t bytecode = 0;
+  size_t functionDescriptors = 0;
+  // Names, signatures, types, and reflection attributes.
+  size_t metadata = 0;
+  size_t debugDatabase = 0;
+  // Total FlatBuffer size including the root table and header.
+  size_t total = 0;
+  // Polyglot ZIP central directory appended after the FlatBuffer.
+  size_t zipDirectory = 0;
+};
+
+// Returns the number of bytes emitted so far. FlatBuffers are emitted as each
+// object is ended so the difference before and after building a section is its
+// serialized size.
+static size_t getEmittedSize(FlatbufferBuilder &fbb) {
+  return flatcc_builder_get_buffer_size(fbb);
+}
+
 struct TypeDef {
   Type type;
   std::string full_name;
@@ -485,6 +510,7 @@ static iree_vm_FunctionSignatureDef_ref_t makeInternalFunctionSignatureDef(
 static LogicalResult buildFlatBufferModule(BytecodeTargetOptions targetOptions,
                                            IREE::VM::ModuleOp moduleOp,
                                            SmallVector<ZIPFileRef> &zipFileRefs,
+                                           SizeReport &sizeReport,
                                            FlatbufferBuilder &fbb) {
   // Start the buffer so that we can begin recording data prior to the root
   // table (which we do at the very end). This does not change the layout of the
@@ -537,11 +563,13 @@ static LogicalResult buildFlatBufferModule(BytecodeTargetOptions targetOptions,
   SmallVector<flatbuffers_uint8_vec_ref_t, 8> rodataContentRefs;
   rodataContentRefs.reserve(rodataOps.size());
 
-  // All constants are defaulted to 16-byte aligned as that is the maximum
-  // (reasonable) alignment of all data types on all platforms. This can be
-  // overridden by creators of the rodata with the `alignment` attribute.
-  static constexpr int kDefaultRodataAlignment = 16;
-
+  // All constants are aligned to at least the rodataAlignment option, which
+  // defaults to 16 bytes as that is the maximum (reasonable) alignment of all
+  // data types on all platforms. Creators of the rodata can request more with
+  // the `alignment` attribute. The largest alignment used is recorded in the
+  // module so that loaders can verify that all rodata is aligned in memory.
+  size_t maxRodataAlignment = 0;
+  size_t sectionStart = getEmittedSize(fbb);
   for (auto rodataOp : llvm::reverse(rodataOps)) {
     // Only include rodata entries in the ZIP if they are file-like. This
     // prevents all of our string tables from getting included.
@@ -549,11 +577,12 @@ static LogicalResult buildFlatBufferModule(BytecodeTargetOptions targetOptions,
         targetOptions.emitPolyglotZip && rodataOp.mime_type().hasValue();
 
     // Embed the rodata contents.
-    size_t alignment =
-        rodataOp.alignment()
-            ? static_cast<size_t>(rodataOp.alignment().getValue())
-            : 0;
-    if (alignment == 0) alignment = kDefaultRodataAlignment;
+    size_t alignment = static_cast<size_t>(targetOptions.rodataAlignment);
+    if (rodataOp.alignment()) {
+      alignment = std::max(
+          alignment, static_cast<size_t>(rodataOp.alignment().getValue()));
+    }
+    maxRodataAlignment = std::max(maxRodataAlignment, alignment);
     auto constantRef =
         serializeConstant(rodataOp.getLoc(), rodataOp.value(), alignment,
                           /*calculateCRC32=*/includeInZIP, fbb);
@@ -570,6 +599,7 @@ static LogicalResult buildFlatBufferModule(BytecodeTargetOptions targetOptions,
   }
   // List of references needs to be swapped forward (we wrote backward).
   std::reverse(rodataContentRefs.begin(), rodataContentRefs.end());
+  sizeReport.rodata = getEmittedSize(fbb) - sectionStart;
 
   // Find all types in the module to build the type table.
   // Note that we don't emit it yet as we want to keep it near the top of the
@@ -588,7 +618,8 @@ static LogicalResult buildFlatBufferModule(BytecodeTargetOptions targetOptions,
   size_t totalBytecodeLength = 0;
   for (auto funcOp : llvm::enumerate(internalFuncOps)) {
     auto encodedFunction = BytecodeEncoder::encodeFunction(
-        funcOp.value(), typeOrdinalMap, symbolTable, debugDatabase);
+        funcOp.value(), typeOrdinalMap, symbolTable, debugDatabase,
+        targetOptions.emitSuperinstructions);
     if (!encodedFunction) {
       return funcOp.value().emitError() << "failed to encode function bytecode";
     }
@@ -600,6 +631,7 @@ static LogicalResult buildFlatBufferModule(BytecodeTargetOptions targetOptions,
     bytecodeDataParts[funcOp.index()] =
         std::move(encodedFunction->bytecodeData);
   }
+  sectionStart = getEmittedSize(fbb);
   flatbuffers_uint8_vec_start(fbb);
   uint8_t *bytecodeDataPtr =
       flatbuffers_uint8_vec_extend(fbb, totalBytecodeLength);
@@ -616,16 +648,20 @@ static LogicalResult buildFlatBufferModule(BytecodeTargetOptions targetOptions,
     currentBytecodeOffset += data.size();
   }
   auto bytecodeDataRef = flatbuffers_uint8_vec_end(fbb);
+  sizeReport.bytecode = getEmittedSize(fbb) - sectionStart;
 
   // Encode the function descriptors adjacent to the bytcode data; they are
   // always accessed together. Descriptor 0 is likely within a few hundred bytes
   // of the referenced bytecode data offset 0, and from there we are at least
   // able to hope sequential readahead caching helps; if not, at least we
   // hopefully don't fault on the first function call every time.
+  sectionStart = getEmittedSize(fbb);
   auto functionDescriptorsRef = iree_vm_FunctionDescriptor_vec_create(
       fbb, functionDescriptors.data(), functionDescriptors.size());
+  sizeReport.functionDescriptors = getEmittedSize(fbb) - sectionStart;
 
   // Serialize metadata that should be near the front of the file.
+  sectionStart = getEmittedSize(fbb);
   auto rodataSegmentRefs = llvm::to_vector<8>(
       llvm::map_range(rodataContentRefs, [&](auto rodataContentRef) {
         iree_vm_RodataSegmentDef_start(fbb);
@@ -665,18 +701,29 @@ static LogicalResult buildFlatBufferModule(BytecodeTargetOptions targetOptions,
             fbb, funcOp.ordinal().getValue().getLimitedValue());
         return iree_vm_ExportFunctionDef_end(fbb);
       }));
+  // Internal functions must always be present as they are indexed by ordinal.
+  // When stripping symbols only exported functions retain their signature as
+  // it is needed to call them and to query their reflection attributes.
+  llvm::DenseSet<Operation *> exportedFuncOps;
+  for (auto exportOp : exportFuncOps) {
+    exportedFuncOps.insert(symbolTable.lookup(exportOp.function_ref()));
+  }
   SmallVector<iree_vm_InternalFunctionDef_ref_t, 8> internalFuncRefs;
-  if (!targetOptions.stripSymbols) {
-    internalFuncRefs.reserve(internalFuncOps.size());
-    for (auto funcOp : internalFuncOps) {
-      auto localNameRef = fbb.createString(funcOp.getName());
-      auto signatureRef =
+  internalFuncRefs.reserve(internalFuncOps.size());
+  for (auto funcOp : internalFuncOps) {
+    flatbuffers_string_ref_t localNameRef = 0;
+    iree_vm_FunctionSignatureDef_ref_t signatureRef = 0;
+    if (!targetOptions.stripSymbols) {
+      localNameRef = fbb.createString(funcOp.getName());
+    }
+    if (!targetOptions.stripSymbols || exportedFuncOps.count(funcOp)) {
+      signatureRef =
           makeInternalFunctionSignatureDef(funcOp, typeOrdinalMap, fbb);
-      iree_vm_InternalFunctionDef_start(fbb);
-      iree_vm_InternalFunctionDef_local_name_add(fbb, localNameRef);
-      iree_vm_InternalFunctionDef_signature_add(fbb, signatureRef);
-      internalFuncRefs.push_back(iree_vm_InternalFunctionDef_end(fbb));
     }
+    iree_vm_InternalFunctionDef_start(fbb);
+    iree_vm_InternalFunctionDef_local_name_add(fbb, localNameRef);
+    iree_vm_InternalFunctionDef_signature_add(fbb, signatureRef);
+    internalFuncRefs.push_back(iree_vm_InternalFunctionDef_end(fbb));
   }
 
   // NOTE: we keep the vectors clustered here so that we can hopefully keep the
@@ -703,14 +750,17 @@ static LogicalResult buildFlatBufferModule(BytecodeTargetOptions targetOptions,
     moduleStateDef = iree_vm_ModuleStateDef_end(fbb);
   }
 
+  auto moduleNameRef = fbb.createString(
+      moduleOp.sym_name().empty() ? "module" : moduleOp.sym_name());
+  sizeReport.metadata = getEmittedSize(fbb) - sectionStart;
+
   iree_vm_DebugDatabaseDef_ref_t debugDatabaseRef = 0;
   if (!targetOptions.stripSourceMap) {
+    sectionStart = getEmittedSize(fbb);
     debugDatabaseRef = debugDatabase.build(fbb);
+    sizeReport.debugDatabase = getEmittedSize(fbb) - sectionStart;
   }
 
-  auto moduleNameRef = fbb.createString(
-      moduleOp.sym_name().empty() ? "module" : moduleOp.sym_name());
-
   iree_vm_BytecodeModuleDef_name_add(fbb, moduleNameRef);
   iree_vm_BytecodeModuleDef_types_add(fbb, typesRef);
   iree_vm_BytecodeModuleDef_imported_functions_add(fbb, importFuncsRef);
@@ -723,16 +773,52 @@ static LogicalResult buildFlatBufferModule(BytecodeTargetOptions targetOptions,
                                                      functionDescriptorsRef);
   iree_vm_BytecodeModuleDef_bytecode_data_add(fbb, bytecodeDataRef);
   iree_vm_BytecodeModuleDef_debug_database_add(fbb, debugDatabaseRef);
+  iree_vm_BytecodeModuleDef_rodata_alignment_add(
+      fbb, static_cast<uint32_t>(maxRodataAlignment));
   iree_vm_BytecodeModuleDef_end_as_root(fbb);
+  sizeReport.total = getEmittedSize(fbb);
 
   return success();
 }
 
+static void printSizeReport(IREE::VM::ModuleOp moduleOp,
+                            const SizeReport &sizeReport,
+                            llvm::raw_ostream &os) {
+  os << "vm.module @" << moduleOp.sym_name() << " bytecode size report:\n";
+  auto printSection = [&](StringRef name, size_t size) {
+    double fraction =
+        sizeReport.total ? static_cast<double>(size) / sizeReport.total : 0.0;
+    os << llvm::formatv("  {0,-22}{1,10} bytes {2,7:P1}\n", name, size,
+                        fraction);
+  };
+  printSection("rodata", sizeReport.rodata);
+  printSection("bytecode", sizeReport.bytecode);
+  printSection("function descriptors", sizeReport.functionDescriptors);
+  printSection("metadata", sizeReport.metadata);
+  printSection("debug database", sizeReport.debugDatabase);
+  printSection("other",
+               sizeReport.total - sizeReport.rodata - sizeReport.bytecode -
+                   sizeReport.functionDescriptors - sizeReport.metadata -
+                   sizeReport.debugDatabase);
+  printSection("total", sizeReport.total);
+  if (sizeReport.zipDirectory) {
+    os << llvm::formatv("  {0,-22}{1,10} bytes\n", "zip directory",
+                        sizeReport.zipDirectory);
+  }
+}
+
 LogicalResult translateModuleToBytecode(IREE::VM::ModuleOp moduleOp,
                                         BytecodeTargetOptions targetOptions,
                                         llvm::raw_ostream &output) {
   uint64_t startOffset = output.tell();
 
+  if (targetOptions.rodataAlignment <= 0 ||
+      !llvm::isPowerOf2_64(targetOptions.rodataAlignment)) {
+    return moduleOp.emitError()
+           << "rodata alignment must be a power of two; got "
+           << targetOptions.rodataAlignment;
+  }
+
   if (failed(canonicalizeModule(targetOptions, moduleOp))) {
     return moduleOp.emitError()
            << "failed to canonicalize vm.module to a serializable form";
@@ -776,8 +862,9 @@ LogicalResult translateModuleToBytecode(IREE::VM::ModuleOp moduleOp,
   // can be large bulk data.
   FlatbufferBuilder fbb;
   SmallVector<ZIPFileRef> zipFileRefs;
-  if (failed(
-          buildFlatBufferModule(targetOptions, moduleOp, zipFileRefs, fbb))) {
+  SizeReport sizeReport;
+  if (failed(buildFlatBufferModule(targetOptions, moduleOp, zipFileRefs,
+                                   sizeReport, fbb))) {
     return moduleOp.emitError()
            << "failed to build FlatBuffer BytecodeModuleDef";
   }
@@ -813,9 +900,13 @@ LogicalResult translateModuleToBytecode(IREE::VM::ModuleOp moduleOp,
     // contents to the output so that we have their final absolute addresses.
     uint64_t endOffset = output.tell();
     appendZIPCentralDirectory(zipFileRefs, startOffset, endOffset, output);
+    sizeReport.zipDirectory = output.tell() - endOffset;
   }
 
   output.flush();
+  if (targetOptions.emitSizeReport) {
+    printSizeReport(moduleOp, sizeReport, llvm::errs());
+  }
   return success();
 }
 
@@ -39,12 +39,16 @@ struct BytecodeTargetOptions {
   // Run basic CSE/inlining/etc passes prior to serialization.
   bool optimize = true;
 
+  // Fuse common op sequences into superinstructions during serialization.
+  bool emitSuperinstructions = true;
+
   // Dump a VM MLIR file and annotate source locations with it.
   // This allows for the runtime to serve stack traces referencing both the
   // original source locations and the VM IR.
   std::string sourceListing;
 
-  // Strips all internal symbol names. Import and export names will remain.
+  // Strips all internal symbol names. Import and export names will remain, as
+  // will the signatures of exported functions used for reflection.
   bool stripSymbols = false;
   // Strips source map information.
   bool stripSourceMap = false;
@@ -54,6 +58,15 @@ struct BytecodeTargetOptions {
   // Enables the output .vmfb to be inspected as a ZIP file.
   // This is only useful for debugging and should be disabled otherwise.
   bool emitPolyglotZip = false;
+
+  // Prints the serialized size of each section of the module to stderr.
+  bool emitSizeReport = false;
+
+  // Minimum alignment in bytes of all rodata segments. Rodata with a larger
+  // `alignment` attribute keeps it. Raising this (to a cache line or page)
+  // allows constant data to be used in-place by consumers that require it.
+  // Must be a power of two.
+  int64_t rodataAlignment = 16;
 };
 
 // Translates a vm.module to a bytecode module flatbuffer.
@@ -40,6 +40,13 @@ static llvm::cl::opt<bool> optimizeFlag{
     llvm::cl::init(true),
 };
 
+static llvm::cl::opt<bool> emitSuperinstructionsFlag{
+    "iree-vm-bytecode-module-emit-superinstructions",
+    llvm::cl::desc("Fuses common op sequences into superinstructions during "
+                   "serialization"),
+    llvm::cl::init(true),
+};
+
 static llvm::cl::opt<std::string> sourceListingFlag{
     "iree-vm-bytecode-source-listing",
     llvm::cl::desc("Dump a VM MLIR file and annotate source locations with it"),
@@ -64,6 +71,28 @@ static llvm::cl::opt<bool> stripDebugOpsFlag{
     llvm::cl::init(false),
 };
 
+static llvm::cl::opt<bool> releaseFlag{
+    "iree-vm-bytecode-module-release",
+    llvm::cl::desc("Produces the smallest module for deployment by stripping "
+                   "symbols, source maps, and debug ops and disabling the "
+                   "polyglot zip; reflection metadata on exports is kept"),
+    llvm::cl::init(false),
+};
+
+static llvm::cl::opt<bool> sizeReportFlag{
+    "iree-vm-bytecode-module-size-report",
+    llvm::cl::desc("Prints the serialized size of each module section to "
+                   "stderr"),
+    llvm::cl::init(false),
+};
+
+static llvm::cl::opt<int64_t> rodataAlignmentFlag{
+    "iree-vm-bytecode-module-rodata-alignment",
+    llvm::cl::desc("Minimum alignment in bytes of rodata segments in the "
+                   "module (such as 64 for cache lines or 4096 for pages)"),
+    llvm::cl::init(16),
+};
+
 static llvm::cl::opt<bool> emitPolyglotZipFlag{
     "iree-vm-emit-polyglot-zip",
     llvm::cl::desc(
@@ -75,11 +104,20 @@ BytecodeTargetOptions getBytecodeTargetOptionsFromFlags() {
   BytecodeTargetOptions targetOptions;
   targetOptions.outputFormat = outputFormatFlag;
   targetOptions.optimize = optimizeFlag;
+  targetOptions.emitSuperinstructions = emitSuperinstructionsFlag;
   targetOptions.sourceListing = sourceListingFlag;
   targetOptions.stripSymbols = stripSymbolsFlag;
   targetOptions.stripSourceMap = stripSourceMapFlag;
   targetOptions.stripDebugOps = stripDebugOpsFlag;
   targetOptions.emitPolyglotZip = emitPolyglotZipFlag;
+  targetOptions.emitSizeReport = sizeReportFlag;
+  targetOptions.rodataAlignment = rodataAlignmentFlag;
+  if (releaseFlag) {
+    targetOptions.stripSymbols = true;
+    targetOptions.stripSourceMap = true;
+    targetOptions.stripDebugOps = true;
+    targetOptions.emitPolyglotZip = false;
+  }
   if (outputFormatFlag != BytecodeOutputFormat::kFlatBufferBinary) {
     // Only allow binary output formats to also be .zip files.
     targetOptions.emitPolyglotZip = false;
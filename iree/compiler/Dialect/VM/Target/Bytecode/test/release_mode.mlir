@@ -0,0 +1,40 @@
+// RUN: iree-translate -iree-vm-ir-to-bytecode-module -iree-vm-bytecode-module-output-format=flatbuffer-text -iree-vm-bytecode-module-release %s | IreeFileCheck %s
+// RUN: iree-translate -iree-vm-ir-to-bytecode-module -iree-vm-bytecode-module-release -iree-vm-bytecode-module-size-report %s -o /dev/null 2>&1 | IreeFileCheck %s -check-prefix=SIZE
+
+// Only exported functions keep their signature and reflection attributes;
+// internal names and the debug database are stripped.
+
+// CHECK-LABEL: "name": "release_module"
+vm.module @release_module {
+  // CHECK-NOT: "helper"
+  // CHECK: "exported_functions":
+  // CHECK: "local_name": "func"
+  vm.export @func
+
+  // CHECK: "internal_functions":
+  // CHECK: "calling_convention": "0i_i"
+  // CHECK: "reflection_attrs":
+  // CHECK: "key": "f"
+  // CHECK-NOT: "local_name"
+  // CHECK-NOT: "debug_database"
+  vm.func @func(%arg0 : i32) -> i32
+    attributes { iree.reflection = { f = "FOOBAR" } }
+  {
+    %0 = vm.call @helper(%arg0) : (i32) -> i32
+    vm.return %0 : i32
+  }
+
+  vm.func @helper(%arg0 : i32) -> i32 {
+    %0 = vm.add.i32 %arg0, %arg0 : i32
+    vm.return %0 : i32
+  }
+}
+
+// SIZE: vm.module @release_module bytecode size report:
+// SIZE-NEXT: rodata
+// SIZE-NEXT: bytecode
+// SIZE-NEXT: function descriptors
+// SIZE-NEXT: metadata
+// SIZE-NEXT: debug database {{ +}}0 bytes
+// SIZE-NEXT: other
+// SIZE-NEXT: total
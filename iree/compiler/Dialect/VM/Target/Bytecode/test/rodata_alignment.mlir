@@ -0,0 +1,19 @@
+// RUN: iree-translate -iree-vm-ir-to-bytecode-module -iree-vm-bytecode-module-output-format=flatbuffer-text %s | IreeFileCheck %s -check-prefix=DEFAULT
+// RUN: iree-translate -iree-vm-ir-to-bytecode-module -iree-vm-bytecode-module-output-format=flatbuffer-text -iree-vm-bytecode-module-rodata-alignment=64 %s | IreeFileCheck %s -check-prefix=ALIGN64
+
+// The largest rodata alignment is recorded in the module so the loader can
+// check that rodata is aligned in memory. Explicit alignments larger than the
+// minimum are preserved.
+
+// DEFAULT: "rodata_alignment": 32
+// ALIGN64: "rodata_alignment": 64
+vm.module @rodata_alignment {
+  vm.rodata private @default dense<[1, 2, 3]> : tensor<3xi8>
+  vm.rodata private @aligned {alignment = 32 : i64} dense<[4, 5, 6]> : tensor<3xi8>
+  vm.export @func
+  vm.func @func() -> (!vm.buffer, !vm.buffer) {
+    %0 = vm.const.ref.rodata @default : !vm.buffer
+    %1 = vm.const.ref.rodata @aligned : !vm.buffer
+    vm.return %0, %1 : !vm.buffer, !vm.buffer
+  }
+}
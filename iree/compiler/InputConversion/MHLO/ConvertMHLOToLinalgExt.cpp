@@ -89,6 +89,21 @@ struct LinalgExtRegionReturnOpConversion
 // SortOp
 //===----------------------------------------------------------------------===//
 
+/// Moves the comparator of `op` into `region` and converts its arguments from
+/// 0-d tensors to scalars.
+static void inlineSortComparator(mhlo::SortOp op, Region &region,
+                                 ConversionPatternRewriter &rewriter) {
+  rewriter.inlineRegionBefore(op.comparator(), region, region.begin());
+  Block &block = region.front();
+  TypeConverter::SignatureConversion signature_converter(
+      block.getNumArguments());
+  for (auto en : llvm::enumerate(block.getArguments())) {
+    signature_converter.addInputs(en.index(),
+                                  getElementTypeOrSelf(en.value().getType()));
+  }
+  rewriter.applySignatureConversion(&region, signature_converter);
+}
+
 struct SortOpConversion : public OpConversionPattern<mhlo::SortOp> {
   using OpConversionPattern<mhlo::SortOp>::OpConversionPattern;
 
@@ -98,23 +113,85 @@ struct SortOpConversion : public OpConversionPattern<mhlo::SortOp> {
     auto sortOp = rewriter.create<linalg_ext::SortOp>(
         op.getLoc(), op.getResultTypes(),
         /*inputs=*/ValueRange{}, args, op.dimensionAttr());
-    rewriter.inlineRegionBefore(op.comparator(), sortOp.region(),
-                                sortOp.region().begin());
-    Region &region = sortOp.region();
-    Block &block = region.front();
-    TypeConverter::SignatureConversion signature_converter(
-        block.getNumArguments());
-    for (auto en : llvm::enumerate(block.getArguments())) {
-      signature_converter.addInputs(en.index(),
-                                    getElementTypeOrSelf(en.value().getType()));
-    }
-    rewriter.applySignatureConversion(&region, signature_converter);
+    inlineSortComparator(op, sortOp.region(), rewriter);
 
     rewriter.replaceOp(op, sortOp->getResults());
     return success();
   }
 };
 
+/// Converts a mhlo.sort whose results are only used by mhlo.slice ops taking
+/// the first `k` elements along the sort dimension (as top-k is expressed by
+/// frontends) to a linalg_ext.topk. Takes precedence over SortOpConversion.
+struct TopkOpConversion : public OpConversionPattern<mhlo::SortOp> {
+  using OpConversionPattern<mhlo::SortOp>::OpConversionPattern;
+
+  LogicalResult matchAndRewrite(
+      mhlo::SortOp op, ArrayRef<Value> args,
+      ConversionPatternRewriter &rewriter) const final {
+    auto operandType = op.getOperand(0).getType().dyn_cast<RankedTensorType>();
+    if (!operandType || !operandType.hasStaticShape()) {
+      return rewriter.notifyMatchFailure(op, "expected static shapes");
+    }
+    ArrayRef<int64_t> shape = operandType.getShape();
+    int64_t rank = operandType.getRank();
+    int64_t dimension = op.dimension();
+    if (dimension < 0) dimension += rank;
+
+    // All uses must be slices of the same leading elements along the sort
+    // dimension.
+    int64_t k = -1;
+    SmallVector<std::pair<mhlo::SliceOp, unsigned>> slices;
+    for (OpResult result : op->getResults()) {
+      for (Operation *user : result.getUsers()) {
+        auto sliceOp = dyn_cast<mhlo::SliceOp>(user);
+        if (!sliceOp) {
+          return rewriter.notifyMatchFailure(op, "expected only slice uses");
+        }
+        auto starts = extract1DVector(sliceOp.start_indices());
+        auto limits = extract1DVector(sliceOp.limit_indices());
+        auto strides = extract1DVector(sliceOp.strides());
+        for (int64_t dim = 0; dim < rank; ++dim) {
+          if (starts[dim] != 0 || strides[dim] != 1 ||
+              (dim != dimension && limits[dim] != shape[dim])) {
+            return rewriter.notifyMatchFailure(
+                op, "expected slices of the leading elements");
+          }
+        }
+        if (k != -1 && limits[dimension] != k) {
+          return rewriter.notifyMatchFailure(op, "expected slices of same k");
+        }
+        k = limits[dimension];
+        slices.emplace_back(sliceOp, result.getResultNumber());
+      }
+    }
+    if (k == -1 || k >= shape[dimension]) {
+      return rewriter.notifyMatchFailure(op, "expected a partial slice");
+    }
+
+    Location loc = op.getLoc();
+    SmallVector<int64_t> outputShape(shape.begin(), shape.end());
+    outputShape[dimension] = k;
+    SmallVector<Value> outputs;
+    SmallVector<Type> resultTypes;
+    for (Value arg : args) {
+      Type elementType = getElementTypeOrSelf(arg.getType());
+      outputs.push_back(rewriter.create<linalg::InitTensorOp>(
+          loc, ValueRange{}, outputShape, elementType));
+      resultTypes.push_back(RankedTensorType::get(outputShape, elementType));
+    }
+    auto topkOp = rewriter.create<linalg_ext::TopkOp>(
+        loc, resultTypes, args, outputs, rewriter.getI64IntegerAttr(dimension));
+    inlineSortComparator(op, topkOp.region(), rewriter);
+
+    for (auto &slice : slices) {
+      rewriter.replaceOp(slice.first, topkOp->getResult(slice.second));
+    }
+    rewriter.eraseOp(op);
+    return success();
+  }
+};
+
 //===----------------------------------------------------------------------===//
 // ScatterOp
 //===----------------------------------------------------------------------===//
@@ -226,7 +303,7 @@ struct ScatterOpConversion : public OpConversionPattern<mhlo::ScatterOp> {
     }
     auto scatterOp = rewriter.create<linalg_ext::ScatterOp>(
         op.getLoc(), op->getResultTypes(), ValueRange{updates, indices},
-        ValueRange{original});
+        ValueRange{original}, op.unique_indices());
 
     rewriter.inlineRegionBefore(op.update_computation(), scatterOp.region(),
                                 scatterOp.region().begin());
@@ -394,6 +471,7 @@ struct ConvertMHLOToLinalgExtPass
 
     patterns.insert<SortOpConversion, ScatterOpConversion, FftOpConversion>(
         context);
+    patterns.insert<TopkOpConversion>(context, PatternBenefit(2));
     patterns.insert<LinalgExtRegionHLOOpConversion<mhlo::CompareOp>,
                     LinalgExtRegionHLOOpConversion<mhlo::AddOp>,
                     LinalgExtRegionReturnOpConversion>(context,
@@ -61,6 +61,48 @@ func @topk(%arg0: tensor<128xi32>, %arg1: tensor<128xi32>) -> (tensor<128xi32>)
 
 // -----
 
+func @topk_slice(%arg0: tensor<16x128xf32>, %arg1: tensor<16x128xi32>)
+    -> (tensor<16x8xf32>, tensor<16x8xi32>) {
+  %0:2 = "mhlo.sort"(%arg0, %arg1) ( {
+  ^bb0(%arg2: tensor<f32>, %arg3: tensor<f32>, %arg4: tensor<i32>, %arg5: tensor<i32>):  // no predecessors
+    %1 = "mhlo.compare"(%arg2, %arg3) {comparison_direction = "GT"} : (tensor<f32>, tensor<f32>) -> tensor<i1>
+    "mhlo.return"(%1) : (tensor<i1>) -> ()
+  }) {dimension = 1 : i64, is_stable = true} : (tensor<16x128xf32>, tensor<16x128xi32>) -> (tensor<16x128xf32>, tensor<16x128xi32>)
+  %2 = "mhlo.slice"(%0#0) {limit_indices = dense<[16, 8]> : tensor<2xi64>, start_indices = dense<0> : tensor<2xi64>, strides = dense<1> : tensor<2xi64>} : (tensor<16x128xf32>) -> tensor<16x8xf32>
+  %3 = "mhlo.slice"(%0#1) {limit_indices = dense<[16, 8]> : tensor<2xi64>, start_indices = dense<0> : tensor<2xi64>, strides = dense<1> : tensor<2xi64>} : (tensor<16x128xi32>) -> tensor<16x8xi32>
+  return %2, %3 : tensor<16x8xf32>, tensor<16x8xi32>
+}
+// CHECK-LABEL: func @topk_slice
+// CHECK:         %[[ARG0:[a-zA-Z0-9]+]]
+// CHECK:         %[[ARG1:[a-zA-Z0-9]+]]
+// CHECK-DAG:     %[[INIT0:.+]] = linalg.init_tensor [16, 8] : tensor<16x8xf32>
+// CHECK-DAG:     %[[INIT1:.+]] = linalg.init_tensor [16, 8] : tensor<16x8xi32>
+// CHECK:         %[[TOPK:.+]]:2 = linalg_ext.topk
+// CHECK-SAME:      dimension(1)
+// CHECK-SAME:      ins(%[[ARG0]], %[[ARG1]] : tensor<16x128xf32>, tensor<16x128xi32>)
+// CHECK-SAME:      outs(%[[INIT0]], %[[INIT1]] : tensor<16x8xf32>, tensor<16x8xi32>)
+// CHECK:           ^bb0(%[[ARG2:.+]]: f32, %[[ARG3:.+]]: f32, %{{.*}}: i32, %{{.*}}: i32)
+// CHECK:             %[[CMP:.+]] = cmpf ogt, %[[ARG2]], %[[ARG3]]
+// CHECK:             linalg_ext.yield %[[CMP]]
+// CHECK:         return %[[TOPK]]#0, %[[TOPK]]#1
+
+// -----
+
+func @topk_slice_offset(%arg0: tensor<128xi32>) -> tensor<8xi32> {
+  %0 = "mhlo.sort"(%arg0) ( {
+  ^bb0(%arg1: tensor<i32>, %arg2: tensor<i32>):  // no predecessors
+    %1 = "mhlo.compare"(%arg1, %arg2) {comparison_direction = "GT"} : (tensor<i32>, tensor<i32>) -> tensor<i1>
+    "mhlo.return"(%1) : (tensor<i1>) -> ()
+  }) {dimension = 0 : i64, is_stable = false} : (tensor<128xi32>) -> tensor<128xi32>
+  %2 = "mhlo.slice"(%0) {limit_indices = dense<12> : tensor<1xi64>, start_indices = dense<4> : tensor<1xi64>, strides = dense<1> : tensor<1xi64>} : (tensor<128xi32>) -> tensor<8xi32>
+  return %2 : tensor<8xi32>
+}
+// CHECK-LABEL: func @topk_slice_offset
+// CHECK-NOT:     linalg_ext.topk
+// CHECK:         linalg_ext.sort
+
+// -----
+
 func @scatter_update_scalar_1D(%arg0: tensor<8xi32>, %arg1: tensor<4x1xi32>,
     %arg2: tensor<4xi32>) -> tensor<8xi32> {
   %0 = "mhlo.scatter"(%arg0, %arg1, %arg2) ( {
@@ -91,6 +133,34 @@ func @scatter_update_scalar_1D(%arg0: tensor<8xi32>, %arg1: tensor<4x1xi32>,
 
 // -----
 
+func @scatter_update_scalar_unique_1D(%arg0: tensor<8xi32>,
+    %arg1: tensor<4x1xi32>, %arg2: tensor<4xi32>) -> tensor<8xi32> {
+  %0 = "mhlo.scatter"(%arg0, %arg1, %arg2) ( {
+  ^bb0(%arg3: tensor<i32>, %arg4: tensor<i32>):  // no predecessors
+    "mhlo.return"(%arg4) : (tensor<i32>) -> ()
+  }) {
+    indices_are_sorted = false,
+    scatter_dimension_numbers = {
+      index_vector_dim = 1 : i64,
+      inserted_window_dims = dense<0> : tensor<1xi64>,
+      scatter_dims_to_operand_dims = dense<0> : tensor<1xi64>,
+      update_window_dims = dense<> : tensor<0xi64>
+    },
+    unique_indices = true
+  } : (tensor<8xi32>, tensor<4x1xi32>, tensor<4xi32>) -> tensor<8xi32>
+  return %0 : tensor<8xi32>
+}
+// CHECK-LABEL: func @scatter_update_scalar_unique_1D
+// CHECK:         %[[ARG0:[a-zA-Z0-9]+]]
+// CHECK:         %[[ARG1:[a-zA-Z0-9]+]]
+// CHECK:         %[[ARG2:[a-zA-Z0-9]+]]
+// CHECK:         %[[SCATTER:.+]] = linalg_ext.scatter {unique_indices}
+// CHECK-SAME:      ins(%[[ARG2]], %[[ARG1]] : tensor<4xi32>, tensor<4x1xi32>)
+// CHECK-SAME:      outs(%[[ARG0]] : tensor<8xi32>)
+// CHECK:         return %[[SCATTER]]
+
+// -----
+
 func @scatter_update_scalar_2D(%arg0: tensor<4x3xi32>, %arg1: tensor<3x2xi32>,
     %arg2: tensor<3xi32>) -> tensor<4x3xi32> {
   %0 = "mhlo.scatter"(%arg0, %arg1, %arg2) ( {
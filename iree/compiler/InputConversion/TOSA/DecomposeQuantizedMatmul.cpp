@@ -0,0 +1,174 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/InputConversion/TOSA/PassDetail.h"
+#include "iree/compiler/InputConversion/TOSA/Passes.h"
+#include "mlir/Dialect/Linalg/IR/LinalgOps.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/Dialect/Utils/StructuredOpsUtils.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+namespace mlir {
+namespace iree_compiler {
+
+namespace {
+
+/// Returns the sum of the 2D `input` along `reductionDim` with its elements
+/// sign extended to `accElementType`.
+static Value sumAlongDim(OpBuilder &b, Location loc, Value input,
+                         unsigned reductionDim, Type accElementType) {
+  auto inputType = input.getType().cast<RankedTensorType>();
+  unsigned parallelDim = 1 - reductionDim;
+  SmallVector<Value> dynSizes;
+  if (inputType.isDynamicDim(parallelDim)) {
+    dynSizes.push_back(b.create<tensor::DimOp>(loc, input, parallelDim));
+  }
+  Value initTensor = b.create<linalg::InitTensorOp>(
+      loc, dynSizes, inputType.getDimSize(parallelDim), accElementType);
+  Value zero = b.create<ConstantOp>(loc, b.getZeroAttr(accElementType));
+  Value acc = b.create<linalg::FillOp>(loc, zero, initTensor).getResult(0);
+
+  SmallVector<AffineMap> maps = {
+      b.getMultiDimIdentityMap(2),
+      AffineMap::get(2, 0, b.getAffineDimExpr(parallelDim), b.getContext())};
+  SmallVector<StringRef> iteratorTypes(2, getParallelIteratorTypeName());
+  iteratorTypes[reductionDim] = getReductionIteratorTypeName();
+  auto genericOp = b.create<linalg::GenericOp>(
+      loc, acc.getType(), input, acc, maps, iteratorTypes,
+      [&](OpBuilder &b, Location loc, ValueRange args) {
+        Value value = args[0];
+        if (value.getType() != accElementType) {
+          value = b.create<SignExtendIOp>(loc, accElementType, value);
+        }
+        b.create<linalg::YieldOp>(
+            loc, b.create<AddIOp>(loc, value, args[1]).getResult());
+      });
+  return genericOp.getResult(0);
+}
+
+/// Converts linalg.quantized_matmul to a linalg.matmul of the quantized
+/// values followed by an elementwise correction for the zero points:
+///
+///   sum_k (A[m, k] - Azp) * (B[k, n] - Bzp) =
+///       sum_k A[m, k] * B[k, n] - Bzp * sum_k A[m, k]
+///       - Azp * sum_k B[k, n] + K * Azp * Bzp
+///
+/// The matmul keeps its integer operands so that it can use the integer
+/// matmul/mmt4d kernels, and the row/column sums are only computed for the
+/// zero points that are not known to be 0 (weights are commonly symmetric).
+struct QuantizedMatmulToMatmul
+    : public OpRewritePattern<linalg::QuantizedMatmulOp> {
+  using OpRewritePattern<linalg::QuantizedMatmulOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(linalg::QuantizedMatmulOp op,
+                                PatternRewriter &rewriter) const override {
+    if (!op.hasTensorSemantics()) {
+      return rewriter.notifyMatchFailure(op, "expected tensor semantics");
+    }
+    Location loc = op.getLoc();
+    Value lhs = op.getInputOperand(0)->get();
+    Value rhs = op.getInputOperand(1)->get();
+    Value lhsZp = op.getInputOperand(2)->get();
+    Value rhsZp = op.getInputOperand(3)->get();
+    Value acc = op.getOutputOperand(0)->get();
+    auto accType = acc.getType().cast<RankedTensorType>();
+    Type accElementType = accType.getElementType();
+    if (!accElementType.isa<IntegerType>() ||
+        lhsZp.getType() != accElementType ||
+        rhsZp.getType() != accElementType) {
+      return rewriter.notifyMatchFailure(
+          op, "expected integer accumulators and zero points");
+    }
+
+    Value matmul =
+        rewriter
+            .create<linalg::MatmulOp>(loc, accType, ValueRange{lhs, rhs},
+                                      ValueRange{acc})
+            .getResult(0);
+    bool hasLhsZp = !matchPattern(lhsZp, m_Zero());
+    bool hasRhsZp = !matchPattern(rhsZp, m_Zero());
+    if (!hasLhsZp && !hasRhsZp) {
+      rewriter.replaceOp(op, matmul);
+      return success();
+    }
+
+    SmallVector<Value> inputs;
+    SmallVector<AffineMap> maps;
+    if (hasRhsZp) {
+      inputs.push_back(sumAlongDim(rewriter, loc, lhs, /*reductionDim=*/1,
+                                   accElementType));
+      maps.push_back(AffineMap::get(2, 0, rewriter.getAffineDimExpr(0),
+                                    rewriter.getContext()));
+    }
+    if (hasLhsZp) {
+      inputs.push_back(sumAlongDim(rewriter, loc, rhs, /*reductionDim=*/0,
+                                   accElementType));
+      maps.push_back(AffineMap::get(2, 0, rewriter.getAffineDimExpr(1),
+                                    rewriter.getContext()));
+    }
+    maps.push_back(rewriter.getMultiDimIdentityMap(2));
+
+    // K * Azp * Bzp is only needed when both zero points are non-zero.
+    Value zpProduct;
+    if (hasLhsZp && hasRhsZp) {
+      Value k = rewriter.createOrFold<tensor::DimOp>(loc, lhs, 1);
+      k = rewriter.create<IndexCastOp>(loc, accElementType, k);
+      zpProduct = rewriter.create<MulIOp>(
+          loc, rewriter.create<MulIOp>(loc, k, lhsZp), rhsZp);
+    }
+
+    SmallVector<StringRef> iteratorTypes(2, getParallelIteratorTypeName());
+    rewriter.replaceOpWithNewOp<linalg::GenericOp>(
+        op, accType, inputs, matmul, maps, iteratorTypes,
+        [&](OpBuilder &b, Location loc, ValueRange args) {
+          Value result = args.back();
+          unsigned index = 0;
+          if (hasRhsZp) {
+            Value correction = b.create<MulIOp>(loc, args[index++], rhsZp);
+            result = b.create<SubIOp>(loc, result, correction);
+          }
+          if (hasLhsZp) {
+            Value correction = b.create<MulIOp>(loc, args[index++], lhsZp);
+            result = b.create<SubIOp>(loc, result, correction);
+          }
+          if (zpProduct) {
+            result = b.create<AddIOp>(loc, result, zpProduct);
+          }
+          b.create<linalg::YieldOp>(loc, result);
+        });
+    return success();
+  }
+};
+
+struct DecomposeQuantizedMatmulPass
+    : public DecomposeQuantizedMatmulBase<DecomposeQuantizedMatmulPass> {
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<linalg::LinalgDialect, StandardOpsDialect,
+                    tensor::TensorDialect>();
+  }
+
+  void runOnOperation() override {
+    OwningRewritePatternList patterns(&getContext());
+    patterns.insert<QuantizedMatmulToMatmul>(&getContext());
+    if (failed(applyPatternsAndFoldGreedily(getOperation(),
+                                            std::move(patterns)))) {
+      return signalPassFailure();
+    }
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<OperationPass<FuncOp>> createDecomposeQuantizedMatmulPass() {
+  return std::make_unique<DecomposeQuantizedMatmulPass>();
+}
+
+}  // namespace iree_compiler
+}  // namespace mlir
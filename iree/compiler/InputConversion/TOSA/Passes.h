@@ -7,6 +7,7 @@
 #ifndef IREE_COMPILER_INPUTCONVERSION_TOSA_PASSES_H_
 #define IREE_COMPILER_INPUTCONVERSION_TOSA_PASSES_H_
 
+#include "mlir/IR/BuiltinOps.h"
 #include "mlir/Pass/Pass.h"
 
 namespace mlir {
@@ -30,6 +31,11 @@ void registerTOSAConversionPassPipeline();
 std::unique_ptr<OperationPass<ModuleOp>>
 createVerifyCompilerTOSAInputLegality();
 
+// Rewrites linalg.quantized_matmul into a linalg.matmul of the raw integer
+// operands plus row/column sum corrections for the non-zero zero points so
+// that the matmul can use the integer matmul kernels.
+std::unique_ptr<OperationPass<FuncOp>> createDecomposeQuantizedMatmulPass();
+
 //===----------------------------------------------------------------------===//
 // Register all Passes
 //===----------------------------------------------------------------------===//
@@ -0,0 +1,79 @@
+// RUN: iree-opt -split-input-file -iree-tosa-decompose-quantized-matmul %s | IreeFileCheck %s
+
+// CHECK-LABEL: func @quantized_matmul_both_zp
+//  CHECK-SAME:   %[[LHS:.+]]: tensor<4x8xi8>, %[[RHS:.+]]: tensor<8x16xi8>
+//  CHECK-SAME:   %[[LHS_ZP:.+]]: i32, %[[RHS_ZP:.+]]: i32
+//   CHECK-DAG:   %{{.+}} = constant 8 : i32
+func @quantized_matmul_both_zp(%lhs: tensor<4x8xi8>, %rhs: tensor<8x16xi8>,
+                               %lhs_zp: i32, %rhs_zp: i32) -> tensor<4x16xi32> {
+  %c0 = constant 0 : i32
+  %0 = linalg.init_tensor [4, 16] : tensor<4x16xi32>
+  %1 = linalg.fill(%c0, %0) : i32, tensor<4x16xi32> -> tensor<4x16xi32>
+  %2 = linalg.quantized_matmul
+      ins(%lhs, %rhs, %lhs_zp, %rhs_zp : tensor<4x8xi8>, tensor<8x16xi8>, i32, i32)
+      outs(%1 : tensor<4x16xi32>) -> tensor<4x16xi32>
+  return %2 : tensor<4x16xi32>
+}
+//       CHECK:   %[[MATMUL:.+]] = linalg.matmul
+//  CHECK-SAME:     ins(%[[LHS]], %[[RHS]] : tensor<4x8xi8>, tensor<8x16xi8>)
+//       CHECK:   %[[ROW_SUM:.+]] = linalg.generic
+//  CHECK-SAME:     iterator_types = ["parallel", "reduction"]
+//  CHECK-SAME:     ins(%[[LHS]] : tensor<4x8xi8>)
+//       CHECK:     sexti
+//       CHECK:   %[[COL_SUM:.+]] = linalg.generic
+//  CHECK-SAME:     iterator_types = ["reduction", "parallel"]
+//  CHECK-SAME:     ins(%[[RHS]] : tensor<8x16xi8>)
+//       CHECK:   %[[KZP:.+]] = muli %{{.+}}, %[[LHS_ZP]]
+//       CHECK:   %[[ZP_PRODUCT:.+]] = muli %[[KZP]], %[[RHS_ZP]]
+//       CHECK:   %[[RESULT:.+]] = linalg.generic
+//  CHECK-SAME:     ins(%[[ROW_SUM]], %[[COL_SUM]] : tensor<4xi32>, tensor<16xi32>)
+//  CHECK-SAME:     outs(%[[MATMUL]] : tensor<4x16xi32>)
+//  CHECK-NEXT:   ^{{.+}}(%[[A_SUM:.+]]: i32, %[[B_SUM:.+]]: i32, %[[ACC:.+]]: i32):
+//       CHECK:     %[[T0:.+]] = muli %[[A_SUM]], %[[RHS_ZP]]
+//       CHECK:     %[[T1:.+]] = subi %[[ACC]], %[[T0]]
+//       CHECK:     %[[T2:.+]] = muli %[[B_SUM]], %[[LHS_ZP]]
+//       CHECK:     %[[T3:.+]] = subi %[[T1]], %[[T2]]
+//       CHECK:     %[[T4:.+]] = addi %[[T3]], %[[ZP_PRODUCT]]
+//       CHECK:     linalg.yield %[[T4]]
+//       CHECK:   return %[[RESULT]]
+
+// -----
+
+// CHECK-LABEL: func @quantized_matmul_symmetric_rhs
+//  CHECK-SAME:   %[[LHS:.+]]: tensor<?x8xi8>, %[[RHS:.+]]: tensor<8x16xi8>
+//  CHECK-SAME:   %[[LHS_ZP:.+]]: i32
+func @quantized_matmul_symmetric_rhs(%lhs: tensor<?x8xi8>, %rhs: tensor<8x16xi8>,
+                                     %lhs_zp: i32, %acc: tensor<?x16xi32>) -> tensor<?x16xi32> {
+  %c0 = constant 0 : i32
+  %0 = linalg.quantized_matmul
+      ins(%lhs, %rhs, %lhs_zp, %c0 : tensor<?x8xi8>, tensor<8x16xi8>, i32, i32)
+      outs(%acc : tensor<?x16xi32>) -> tensor<?x16xi32>
+  return %0 : tensor<?x16xi32>
+}
+//       CHECK:   %[[MATMUL:.+]] = linalg.matmul
+//   CHECK-NOT:     ins(%[[LHS]] : tensor<?x8xi8>)
+//       CHECK:   %[[COL_SUM:.+]] = linalg.generic
+//  CHECK-SAME:     ins(%[[RHS]] : tensor<8x16xi8>)
+//       CHECK:   %[[RESULT:.+]] = linalg.generic
+//  CHECK-SAME:     ins(%[[COL_SUM]] : tensor<16xi32>)
+//  CHECK-SAME:     outs(%[[MATMUL]] : tensor<?x16xi32>)
+//       CHECK:     muli %{{.+}}, %[[LHS_ZP]]
+//       CHECK:     subi
+//   CHECK-NOT:     addi
+//       CHECK:     linalg.yield
+//       CHECK:   return %[[RESULT]]
+
+// -----
+
+// CHECK-LABEL: func @quantized_matmul_symmetric
+func @quantized_matmul_symmetric(%lhs: tensor<4x8xi8>, %rhs: tensor<8x16xi8>,
+                                 %acc: tensor<4x16xi32>) -> tensor<4x16xi32> {
+  %c0 = constant 0 : i32
+  %0 = linalg.quantized_matmul
+      ins(%lhs, %rhs, %c0, %c0 : tensor<4x8xi8>, tensor<8x16xi8>, i32, i32)
+      outs(%acc : tensor<4x16xi32>) -> tensor<4x16xi32>
+  return %0 : tensor<4x16xi32>
+}
+//       CHECK:   %[[MATMUL:.+]] = linalg.matmul
+//   CHECK-NOT:   linalg.generic
+//       CHECK:   return %[[MATMUL]]
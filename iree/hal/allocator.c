@@ -6,7 +6,9 @@
 
 #include "iree/hal/allocator.h"
 
+#include <inttypes.h>
 #include <stddef.h>
+#include <string.h>
 
 #include "iree/base/tracing.h"
 #include "iree/hal/detail.h"
@@ -63,3 +65,116 @@ IREE_API_EXPORT iree_status_t iree_hal_allocator_wrap_buffer(
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
+
+IREE_API_EXPORT void iree_hal_allocator_query_statistics(
+    iree_hal_allocator_t* allocator,
+    iree_hal_allocator_statistics_t* out_statistics) {
+  IREE_ASSERT_ARGUMENT(allocator);
+  IREE_ASSERT_ARGUMENT(out_statistics);
+  memset(out_statistics, 0, sizeof(*out_statistics));
+  _VTABLE_DISPATCH(allocator, query_statistics)(allocator, out_statistics);
+}
+
+IREE_API_EXPORT void iree_hal_allocator_reset_peak_statistics(
+    iree_hal_allocator_t* allocator) {
+  IREE_ASSERT_ARGUMENT(allocator);
+  _VTABLE_DISPATCH(allocator, reset_peak_statistics)(allocator);
+}
+
+static iree_status_t iree_hal_allocator_memory_statistics_format(
+    const char* name, const iree_hal_allocator_memory_statistics_t* statistics,
+    iree_string_builder_t* builder) {
+  return iree_string_builder_append_format(
+      builder,
+      "  %-12s %14" PRIu64 " %14" PRIu64 " %14" PRIu64 " %10" PRIu64
+      " %10" PRIu64 "\n",
+      name, (uint64_t)statistics->bytes_peak, (uint64_t)statistics->bytes_live,
+      statistics->bytes_allocated, statistics->allocation_count,
+      statistics->free_count);
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_allocator_statistics_format(
+    const iree_hal_allocator_statistics_t* statistics,
+    iree_string_builder_t* builder) {
+  IREE_ASSERT_ARGUMENT(statistics);
+  IREE_ASSERT_ARGUMENT(builder);
+  IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+      builder, "  %-12s %14s %14s %14s %10s %10s\n", "Memory", "Peak Bytes",
+      "Live Bytes", "Total Bytes", "Allocs", "Frees"));
+  IREE_RETURN_IF_ERROR(iree_hal_allocator_memory_statistics_format(
+      "HOST_LOCAL", &statistics->host_local, builder));
+  IREE_RETURN_IF_ERROR(iree_hal_allocator_memory_statistics_format(
+      "DEVICE_LOCAL", &statistics->device_local, builder));
+  return iree_hal_allocator_memory_statistics_format(
+      "TOTAL", &statistics->total, builder);
+}
+
+// Names of the tracing memory pools buffers are reported in. Tracy identifies
+// pools by the string address so these must be the same for all events.
+#if IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_ALLOCATION_TRACKING
+static const char iree_hal_allocator_host_local_pool_name[] =
+    "iree-hal-host-local";
+static const char iree_hal_allocator_device_local_pool_name[] =
+    "iree-hal-device-local";
+#endif  // IREE_TRACING_FEATURE_ALLOCATION_TRACKING
+
+static void iree_hal_allocator_memory_statistics_record_alloc(
+    iree_hal_allocator_memory_statistics_t* statistics,
+    iree_device_size_t allocation_size) {
+  statistics->bytes_live += allocation_size;
+  statistics->bytes_peak =
+      iree_max(statistics->bytes_peak, statistics->bytes_live);
+  statistics->bytes_allocated += allocation_size;
+  ++statistics->allocation_count;
+}
+
+static void iree_hal_allocator_memory_statistics_record_free(
+    iree_hal_allocator_memory_statistics_t* statistics,
+    iree_device_size_t allocation_size) {
+  statistics->bytes_live -= allocation_size;
+  statistics->bytes_freed += allocation_size;
+  ++statistics->free_count;
+}
+
+IREE_API_EXPORT void iree_hal_allocator_statistics_record_alloc(
+    iree_hal_allocator_statistics_t* statistics,
+    iree_hal_memory_type_t memory_type, iree_device_size_t allocation_size,
+    const void* ptr) {
+  iree_hal_allocator_memory_statistics_record_alloc(&statistics->total,
+                                                    allocation_size);
+  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL)) {
+    iree_hal_allocator_memory_statistics_record_alloc(
+        &statistics->device_local, allocation_size);
+    IREE_TRACE_ALLOC_NAMED(iree_hal_allocator_device_local_pool_name, ptr,
+                           allocation_size);
+  } else {
+    iree_hal_allocator_memory_statistics_record_alloc(&statistics->host_local,
+                                                      allocation_size);
+    IREE_TRACE_ALLOC_NAMED(iree_hal_allocator_host_local_pool_name, ptr,
+                           allocation_size);
+  }
+}
+
+IREE_API_EXPORT void iree_hal_allocator_statistics_record_free(
+    iree_hal_allocator_statistics_t* statistics,
+    iree_hal_memory_type_t memory_type, iree_device_size_t allocation_size,
+    const void* ptr) {
+  iree_hal_allocator_memory_statistics_record_free(&statistics->total,
+                                                   allocation_size);
+  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL)) {
+    iree_hal_allocator_memory_statistics_record_free(&statistics->device_local,
+                                                     allocation_size);
+    IREE_TRACE_FREE_NAMED(iree_hal_allocator_device_local_pool_name, ptr);
+  } else {
+    iree_hal_allocator_memory_statistics_record_free(&statistics->host_local,
+                                                     allocation_size);
+    IREE_TRACE_FREE_NAMED(iree_hal_allocator_host_local_pool_name, ptr);
+  }
+}
+
+IREE_API_EXPORT void iree_hal_allocator_statistics_reset_peak(
+    iree_hal_allocator_statistics_t* statistics) {
+  statistics->total.bytes_peak = statistics->total.bytes_live;
+  statistics->device_local.bytes_peak = statistics->device_local.bytes_live;
+  statistics->host_local.bytes_peak = statistics->host_local.bytes_live;
+}
@@ -126,10 +126,103 @@ IREE_API_EXPORT iree_status_t iree_hal_allocator_wrap_buffer(
     iree_hal_buffer_usage_t allowed_usage, iree_byte_span_t data,
     iree_allocator_t data_allocator, iree_hal_buffer_t** out_buffer);
 
+//===----------------------------------------------------------------------===//
+// iree_hal_allocator_statistics_t
+//===----------------------------------------------------------------------===//
+
+// Memory usage of the buffers allocated from one kind of memory.
+// Sizes are the allocation sizes requested by callers and do not include any
+// rounding, pooling, or bookkeeping overhead of the allocator.
+typedef struct iree_hal_allocator_memory_statistics_t {
+  // Total bytes of buffers currently live.
+  iree_device_size_t bytes_live;
+  // High-water mark of |bytes_live| since the allocator was created or the
+  // peak was last reset with iree_hal_allocator_reset_peak_statistics.
+  iree_device_size_t bytes_peak;
+  // Total bytes of all buffers ever allocated.
+  uint64_t bytes_allocated;
+  // Total bytes of all buffers ever freed.
+  uint64_t bytes_freed;
+  // Total number of buffers ever allocated.
+  uint64_t allocation_count;
+  // Total number of buffers ever freed.
+  uint64_t free_count;
+} iree_hal_allocator_memory_statistics_t;
+
+// Memory usage of the buffers allocated by an allocator.
+// Only buffers allocated with iree_hal_allocator_allocate_buffer are included;
+// wrapped and imported buffers reference memory owned by someone else.
+typedef struct iree_hal_allocator_statistics_t {
+  // All buffers regardless of memory type.
+  iree_hal_allocator_memory_statistics_t total;
+  // Buffers with IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL.
+  iree_hal_allocator_memory_statistics_t device_local;
+  // Buffers without IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL.
+  iree_hal_allocator_memory_statistics_t host_local;
+} iree_hal_allocator_statistics_t;
+
+// Queries the memory usage of the buffers allocated by |allocator|.
+// The peak of |total| may be lower than the sum of the other peaks as they
+// may have been reached at different times.
+IREE_API_EXPORT void iree_hal_allocator_query_statistics(
+    iree_hal_allocator_t* allocator,
+    iree_hal_allocator_statistics_t* out_statistics);
+
+// Resets the peaks of |allocator| to the bytes currently live such that the
+// high-water mark of a particular phase (such as one invocation) can be
+// measured.
+IREE_API_EXPORT void iree_hal_allocator_reset_peak_statistics(
+    iree_hal_allocator_t* allocator);
+
+// Formats |statistics| as a human-readable table to |builder|.
+IREE_API_EXPORT iree_status_t iree_hal_allocator_statistics_format(
+    const iree_hal_allocator_statistics_t* statistics,
+    iree_string_builder_t* builder);
+
 //===----------------------------------------------------------------------===//
 // iree_hal_heap_allocator_t
 //===----------------------------------------------------------------------===//
 
+// Parameters configuring an iree_hal_heap_allocator_t.
+// Must be initialized with iree_hal_heap_allocator_params_initialize prior to
+// use.
+typedef struct iree_hal_heap_allocator_params_t {
+  // Alignment in bytes of the contents of all allocated buffers.
+  // Must be a power of two of at least 16.
+  iree_host_size_t alignment;
+
+  // Buffers with an allocation size of at most this many bytes have their
+  // storage pooled in power-of-two size classes and reused after the buffers
+  // are released instead of being returned to the host allocator.
+  // 0 disables pooling and all buffers are allocated from the host allocator.
+  // NOTE: the contents of buffers whose storage is reused from the pool are
+  // undefined instead of zeroed.
+  iree_host_size_t max_pooled_allocation_size;
+
+  // Maximum total bytes of released buffer storage retained in the pool.
+  // Storage released while the pool is at capacity is returned to the host
+  // allocator. iree_hal_heap_allocator_trim can be used to release all of it.
+  iree_host_size_t max_pooled_size;
+} iree_hal_heap_allocator_params_t;
+
+// Initializes |out_params| to default values (64-byte alignment, no pooling).
+IREE_API_EXPORT void iree_hal_heap_allocator_params_initialize(
+    iree_hal_heap_allocator_params_t* out_params);
+
+// Aggregate statistics of a heap allocator.
+typedef struct iree_hal_heap_allocator_statistics_t {
+  // Total number of buffers allocated with storage owned by the allocator.
+  uint64_t allocation_count;
+  // Number of allocations that reused storage retained in the pool.
+  uint64_t pool_hit_count;
+  // Number of host allocator allocations made for buffer storage.
+  uint64_t host_allocation_count;
+  // Number of host allocator frees made for buffer storage.
+  uint64_t host_free_count;
+  // Total bytes of storage currently retained in the pool.
+  uint64_t pooled_size;
+} iree_hal_heap_allocator_statistics_t;
+
 // Creates a host-local heap allocator that can be used when buffers are
 // required that will not interact with a real hardware device (such as those
 // used in file IO or tests). Buffers allocated with this will not be compatible
@@ -139,6 +232,90 @@ IREE_API_EXPORT iree_status_t iree_hal_allocator_create_heap(
     iree_string_view_t identifier, iree_allocator_t host_allocator,
     iree_hal_allocator_t** out_allocator);
 
+// Creates a host-local heap allocator as with iree_hal_allocator_create_heap
+// configured with the given |params|. Pooling allocators avoid a host
+// allocation and free per transient buffer once the pool has warmed up.
+IREE_API_EXPORT iree_status_t iree_hal_allocator_create_heap_with_params(
+    iree_string_view_t identifier,
+    const iree_hal_heap_allocator_params_t* params,
+    iree_allocator_t host_allocator, iree_hal_allocator_t** out_allocator);
+
+// Returns true if |allocator| was created with iree_hal_allocator_create_heap*
+// and allocates buffers that are backed by host memory.
+IREE_API_EXPORT bool iree_hal_allocator_is_heap(
+    const iree_hal_allocator_t* allocator);
+
+// Queries the aggregate statistics of a heap |allocator|.
+// Fails if the allocator was not created with iree_hal_allocator_create_heap*.
+IREE_API_EXPORT iree_status_t iree_hal_heap_allocator_query_statistics(
+    iree_hal_allocator_t* allocator,
+    iree_hal_heap_allocator_statistics_t* out_statistics);
+
+// Releases all storage retained in the pool of a heap |allocator| back to the
+// host allocator. Buffers that are still live are unaffected. No-op if the
+// allocator is not a heap allocator or does not pool.
+IREE_API_EXPORT void iree_hal_heap_allocator_trim(
+    iree_hal_allocator_t* allocator);
+
+//===----------------------------------------------------------------------===//
+// iree_hal_static_arena_allocator_t
+//===----------------------------------------------------------------------===//
+
+// A static memory plan produced by the compiler with
+// `--iree-hal-static-memory-plan`. The plan bounds the device memory a module
+// will ever allocate and is exported as the `iree.memory_plan` reflection
+// attribute of each exported function in the form
+// `constant=N,transient=N,io=N,alignment=N`.
+typedef struct iree_hal_static_memory_plan_t {
+  // Bytes of constants allocated once when the module is initialized.
+  iree_device_size_t constant_size;
+  // Bytes of transient buffers live during the heaviest invocation.
+  iree_device_size_t transient_size;
+  // Bytes of outputs (and other non-transient buffers) produced by the
+  // heaviest invocation.
+  iree_device_size_t io_size;
+  // Alignment in bytes of each allocation within the arena.
+  iree_device_size_t alignment;
+} iree_hal_static_memory_plan_t;
+
+// Parses a plan from its reflection attribute |value|.
+// Unknown keys are ignored such that newer compilers can extend the plan.
+IREE_API_EXPORT iree_status_t iree_hal_static_memory_plan_parse(
+    iree_string_view_t value, iree_hal_static_memory_plan_t* out_plan);
+
+// Returns the total size in bytes of an arena that can service |plan|.
+// The arena must also be aligned to the plan alignment.
+IREE_API_EXPORT iree_device_size_t iree_hal_static_memory_plan_arena_size(
+    const iree_hal_static_memory_plan_t* plan);
+
+// Creates an allocator that serves all buffer allocations from the
+// caller-provided |arena| according to |plan|, for deployments (such as those
+// using static library executables and EmitC modules) where no heap is
+// available for device memory.
+//
+// The arena is split into a constant, transient, and io region each sized by
+// the plan. Allocations with IREE_HAL_BUFFER_USAGE_CONSTANT come from the
+// constant region, those with IREE_HAL_MEMORY_TYPE_TRANSIENT from the
+// transient region, and all others from the io region. Each region is a bump
+// allocator that is reset once all buffers allocated from it have been
+// released; outputs must therefore be released before the next invocation to
+// keep the io region from filling. Allocations that do not fit fail with
+// IREE_STATUS_RESOURCE_EXHAUSTED.
+//
+// Wrapped buffers (such as constants mapped from module rodata) are used in
+// place and take no arena space. Buffer headers are small and still allocated
+// from |host_allocator|.
+//
+// Statistics report the arena bytes reserved in all regions (including
+// alignment padding) in |total| only.
+//
+// |arena| must remain valid for the lifetime of the allocator and all buffers
+// allocated from it.
+IREE_API_EXPORT iree_status_t iree_hal_allocator_create_static_arena(
+    iree_string_view_t identifier, const iree_hal_static_memory_plan_t* plan,
+    iree_byte_span_t arena, iree_allocator_t host_allocator,
+    iree_hal_allocator_t** out_allocator);
+
 //===----------------------------------------------------------------------===//
 // iree_hal_allocator_t implementation details
 //===----------------------------------------------------------------------===//
@@ -168,11 +345,37 @@ typedef struct iree_hal_allocator_vtable_t {
       iree_hal_memory_access_t allowed_access,
       iree_hal_buffer_usage_t allowed_usage, iree_byte_span_t data,
       iree_allocator_t data_allocator, iree_hal_buffer_t** out_buffer);
+
+  void(IREE_API_PTR* query_statistics)(
+      iree_hal_allocator_t* allocator,
+      iree_hal_allocator_statistics_t* out_statistics);
+
+  void(IREE_API_PTR* reset_peak_statistics)(iree_hal_allocator_t* allocator);
 } iree_hal_allocator_vtable_t;
 
 IREE_API_EXPORT void iree_hal_allocator_destroy(
     iree_hal_allocator_t* allocator);
 
+// Records the allocation of a buffer of |memory_type| and |allocation_size| in
+// |statistics| and reports it to the tracing allocation timeline with the
+// given unique |ptr| identifying the buffer until it is freed.
+// Implementations must synchronize access to |statistics| themselves.
+IREE_API_EXPORT void iree_hal_allocator_statistics_record_alloc(
+    iree_hal_allocator_statistics_t* statistics,
+    iree_hal_memory_type_t memory_type, iree_device_size_t allocation_size,
+    const void* ptr);
+
+// Records the free of a buffer previously recorded with
+// iree_hal_allocator_statistics_record_alloc.
+IREE_API_EXPORT void iree_hal_allocator_statistics_record_free(
+    iree_hal_allocator_statistics_t* statistics,
+    iree_hal_memory_type_t memory_type, iree_device_size_t allocation_size,
+    const void* ptr);
+
+// Resets the peaks in |statistics| to the bytes currently live.
+IREE_API_EXPORT void iree_hal_allocator_statistics_reset_peak(
+    iree_hal_allocator_statistics_t* statistics);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -5,26 +5,93 @@
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
 #include <stddef.h>
+#include <string.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/math.h"
+#include "iree/base/internal/synchronization.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/allocator.h"
 #include "iree/hal/buffer.h"
 #include "iree/hal/buffer_heap_impl.h"
 #include "iree/hal/resource.h"
 
+// log2 of the smallest pooled block size. Requests smaller than this are
+// rounded up so that tiny buffers share a single size class.
+#define IREE_HAL_HEAP_ALLOCATOR_MIN_BLOCK_SIZE_LOG2 8
+
+// Total number of power-of-two size classes, covering blocks from 256B up to
+// 512GB. Allocations larger than the largest class are never pooled.
+#define IREE_HAL_HEAP_ALLOCATOR_SIZE_CLASS_COUNT 32
+
+// Header overlaid on the storage of blocks retained in a size class free list.
+typedef struct iree_hal_heap_block_t {
+  struct iree_hal_heap_block_t* next;
+} iree_hal_heap_block_t;
+
 typedef struct iree_hal_heap_allocator_t {
   iree_hal_resource_t resource;
   iree_allocator_t host_allocator;
   iree_string_view_t identifier;
+  iree_hal_heap_allocator_params_t params;
+
+  // Guards the pool free lists and statistics. Blocks are usually released on
+  // a different thread than they were acquired on (buffers are freed when the
+  // last task referencing them retires) so a shared O(1) free list per size
+  // class is used instead of per-thread caches that would need rebalancing.
+  iree_slim_mutex_t pool_mutex;
+  // LIFO free lists of retained blocks, one per size class. Reusing the most
+  // recently released block keeps the storage warm in cache.
+  iree_hal_heap_block_t* free_lists[IREE_HAL_HEAP_ALLOCATOR_SIZE_CLASS_COUNT];
+  iree_hal_heap_allocator_statistics_t statistics;
+  iree_hal_allocator_statistics_t memory_statistics;
 } iree_hal_heap_allocator_t;
 
 static const iree_hal_allocator_vtable_t iree_hal_heap_allocator_vtable;
 
+static iree_hal_heap_allocator_t* iree_hal_heap_allocator_cast(
+    iree_hal_allocator_t* base_value) {
+  return (iree_hal_heap_allocator_t*)base_value;
+}
+
+IREE_API_EXPORT void iree_hal_heap_allocator_params_initialize(
+    iree_hal_heap_allocator_params_t* out_params) {
+  memset(out_params, 0, sizeof(*out_params));
+  out_params->alignment = 64;
+  out_params->max_pooled_allocation_size = 0;
+  out_params->max_pooled_size = 64 * 1024 * 1024;
+}
+
+static iree_status_t iree_hal_heap_allocator_params_verify(
+    const iree_hal_heap_allocator_params_t* params) {
+  if (params->alignment < 16 ||
+      (params->alignment & (params->alignment - 1)) != 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "heap allocator alignment must be a power of two "
+                            "of at least 16 bytes (got %zu)",
+                            params->alignment);
+  }
+  return iree_ok_status();
+}
+
 IREE_API_EXPORT iree_status_t iree_hal_allocator_create_heap(
     iree_string_view_t identifier, iree_allocator_t host_allocator,
     iree_hal_allocator_t** out_allocator) {
+  iree_hal_heap_allocator_params_t params;
+  iree_hal_heap_allocator_params_initialize(&params);
+  return iree_hal_allocator_create_heap_with_params(identifier, &params,
+                                                    host_allocator,
+                                                    out_allocator);
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_allocator_create_heap_with_params(
+    iree_string_view_t identifier,
+    const iree_hal_heap_allocator_params_t* params,
+    iree_allocator_t host_allocator, iree_hal_allocator_t** out_allocator) {
+  IREE_ASSERT_ARGUMENT(params);
   IREE_ASSERT_ARGUMENT(out_allocator);
+  *out_allocator = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_heap_allocator_params_verify(params));
   IREE_TRACE_ZONE_BEGIN(z0);
 
   iree_hal_heap_allocator_t* allocator = NULL;
@@ -39,13 +106,160 @@ IREE_API_EXPORT iree_status_t iree_hal_allocator_create_heap(
     iree_string_view_append_to_buffer(
         identifier, &allocator->identifier,
         (char*)allocator + iree_sizeof_struct(*allocator));
+    allocator->params = *params;
+    iree_slim_mutex_initialize(&allocator->pool_mutex);
+    memset(allocator->free_lists, 0, sizeof(allocator->free_lists));
+    memset(&allocator->statistics, 0, sizeof(allocator->statistics));
+    memset(&allocator->memory_statistics, 0,
+           sizeof(allocator->memory_statistics));
     *out_allocator = (iree_hal_allocator_t*)allocator;
   }
 
   IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Returns the size class that blocks of |block_size| are pooled in or -1 if
+// blocks of the size are not pooled.
+static int iree_hal_heap_allocator_select_size_class(
+    iree_hal_heap_allocator_t* allocator, iree_host_size_t block_size,
+    iree_host_size_t* out_class_block_size) {
+  if (block_size > allocator->params.max_pooled_allocation_size) return -1;
+  uint64_t class_block_size = iree_math_round_up_to_pow2_u64(block_size);
+  int size_class = iree_math_count_trailing_zeros_u64(class_block_size) -
+                   IREE_HAL_HEAP_ALLOCATOR_MIN_BLOCK_SIZE_LOG2;
+  if (size_class < 0) {
+    size_class = 0;
+    class_block_size = 1ull << IREE_HAL_HEAP_ALLOCATOR_MIN_BLOCK_SIZE_LOG2;
+  }
+  if (size_class >= IREE_HAL_HEAP_ALLOCATOR_SIZE_CLASS_COUNT) return -1;
+  *out_class_block_size = (iree_host_size_t)class_block_size;
+  return size_class;
+}
+
+iree_status_t iree_hal_heap_allocator_acquire_block(
+    iree_hal_allocator_t* base_allocator, iree_host_size_t block_size,
+    void** out_block) {
+  iree_hal_heap_allocator_t* allocator =
+      iree_hal_heap_allocator_cast(base_allocator);
+  *out_block = NULL;
+
+  iree_host_size_t class_block_size = block_size;
+  int size_class = iree_hal_heap_allocator_select_size_class(
+      allocator, block_size, &class_block_size);
+
+  iree_slim_mutex_lock(&allocator->pool_mutex);
+  ++allocator->statistics.allocation_count;
+  if (size_class >= 0 && allocator->free_lists[size_class]) {
+    // Pool hit: reuse the most recently released block.
+    iree_hal_heap_block_t* block = allocator->free_lists[size_class];
+    allocator->free_lists[size_class] = block->next;
+    ++allocator->statistics.pool_hit_count;
+    allocator->statistics.pooled_size -= class_block_size;
+    iree_slim_mutex_unlock(&allocator->pool_mutex);
+    *out_block = block;
+    return iree_ok_status();
+  }
+  ++allocator->statistics.host_allocation_count;
+  iree_slim_mutex_unlock(&allocator->pool_mutex);
+
+  return iree_allocator_malloc(allocator->host_allocator, class_block_size,
+                               out_block);
+}
+
+void iree_hal_heap_allocator_release_block(iree_hal_allocator_t* base_allocator,
+                                           void* block,
+                                           iree_host_size_t block_size,
+                                           iree_hal_memory_type_t memory_type,
+                                           iree_device_size_t allocation_size) {
+  iree_hal_heap_allocator_t* allocator =
+      iree_hal_heap_allocator_cast(base_allocator);
+  if (!block) return;
+
+  iree_host_size_t class_block_size = block_size;
+  int size_class = iree_hal_heap_allocator_select_size_class(
+      allocator, block_size, &class_block_size);
+
+  iree_slim_mutex_lock(&allocator->pool_mutex);
+  iree_hal_allocator_statistics_record_free(&allocator->memory_statistics,
+                                            memory_type, allocation_size,
+                                            block);
+  if (size_class >= 0 &&
+      allocator->statistics.pooled_size + class_block_size <=
+          allocator->params.max_pooled_size) {
+    iree_hal_heap_block_t* pooled_block = (iree_hal_heap_block_t*)block;
+    pooled_block->next = allocator->free_lists[size_class];
+    allocator->free_lists[size_class] = pooled_block;
+    allocator->statistics.pooled_size += class_block_size;
+    iree_slim_mutex_unlock(&allocator->pool_mutex);
+    return;
+  }
+  ++allocator->statistics.host_free_count;
+  iree_slim_mutex_unlock(&allocator->pool_mutex);
+
+  iree_allocator_free(allocator->host_allocator, block);
+}
+
+IREE_API_EXPORT bool iree_hal_allocator_is_heap(
+    const iree_hal_allocator_t* allocator) {
+  return iree_hal_resource_is(allocator, &iree_hal_heap_allocator_vtable);
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_heap_allocator_query_statistics(
+    iree_hal_allocator_t* base_allocator,
+    iree_hal_heap_allocator_statistics_t* out_statistics) {
+  IREE_ASSERT_ARGUMENT(base_allocator);
+  IREE_ASSERT_ARGUMENT(out_statistics);
+  memset(out_statistics, 0, sizeof(*out_statistics));
+  if (!iree_hal_resource_is(base_allocator, &iree_hal_heap_allocator_vtable)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "allocator is not a heap allocator");
+  }
+  iree_hal_heap_allocator_t* allocator =
+      iree_hal_heap_allocator_cast(base_allocator);
+  iree_slim_mutex_lock(&allocator->pool_mutex);
+  *out_statistics = allocator->statistics;
+  iree_slim_mutex_unlock(&allocator->pool_mutex);
   return iree_ok_status();
 }
 
+IREE_API_EXPORT void iree_hal_heap_allocator_trim(
+    iree_hal_allocator_t* base_allocator) {
+  IREE_ASSERT_ARGUMENT(base_allocator);
+  if (!iree_hal_resource_is(base_allocator, &iree_hal_heap_allocator_vtable)) {
+    return;
+  }
+  iree_hal_heap_allocator_t* allocator =
+      iree_hal_heap_allocator_cast(base_allocator);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Steal all free lists under the lock and then free outside of it so that
+  // concurrent allocations are not blocked on the host allocator.
+  iree_hal_heap_block_t* free_lists[IREE_HAL_HEAP_ALLOCATOR_SIZE_CLASS_COUNT];
+  iree_host_size_t free_count = 0;
+  iree_slim_mutex_lock(&allocator->pool_mutex);
+  memcpy(free_lists, allocator->free_lists, sizeof(free_lists));
+  memset(allocator->free_lists, 0, sizeof(allocator->free_lists));
+  allocator->statistics.pooled_size = 0;
+  iree_slim_mutex_unlock(&allocator->pool_mutex);
+
+  for (int i = 0; i < IREE_HAL_HEAP_ALLOCATOR_SIZE_CLASS_COUNT; ++i) {
+    iree_hal_heap_block_t* block = free_lists[i];
+    while (block) {
+      iree_hal_heap_block_t* next = block->next;
+      iree_allocator_free(allocator->host_allocator, block);
+      block = next;
+      ++free_count;
+    }
+  }
+
+  iree_slim_mutex_lock(&allocator->pool_mutex);
+  allocator->statistics.host_free_count += free_count;
+  iree_slim_mutex_unlock(&allocator->pool_mutex);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
 static void iree_hal_heap_allocator_destroy(
     iree_hal_allocator_t* base_allocator) {
   iree_hal_heap_allocator_t* allocator =
@@ -53,6 +267,8 @@ static void iree_hal_heap_allocator_destroy(
   iree_allocator_t host_allocator = allocator->host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  iree_hal_heap_allocator_trim(base_allocator);
+  iree_slim_mutex_deinitialize(&allocator->pool_mutex);
   iree_allocator_free(host_allocator, allocator);
 
   IREE_TRACE_ZONE_END(z0);
@@ -129,9 +345,16 @@ static iree_status_t iree_hal_heap_allocator_allocate_buffer(
       &memory_type, &allowed_access, &allowed_usage));
 
   // Allocate and return the buffer.
-  return iree_hal_heap_buffer_create(
+  IREE_RETURN_IF_ERROR(iree_hal_heap_buffer_create(
       base_allocator, memory_type, allowed_access, allowed_usage,
-      allocation_size, allocator->host_allocator, out_buffer);
+      allocation_size, allocator->params.alignment, out_buffer));
+
+  iree_slim_mutex_lock(&allocator->pool_mutex);
+  iree_hal_allocator_statistics_record_alloc(&allocator->memory_statistics,
+                                             memory_type, allocation_size,
+                                             *out_buffer);
+  iree_slim_mutex_unlock(&allocator->pool_mutex);
+  return iree_ok_status();
 }
 
 static iree_status_t iree_hal_heap_allocator_wrap_buffer(
@@ -148,6 +371,25 @@ static iree_status_t iree_hal_heap_allocator_wrap_buffer(
                                    data_allocator, out_buffer);
 }
 
+static void iree_hal_heap_allocator_query_memory_statistics(
+    iree_hal_allocator_t* base_allocator,
+    iree_hal_allocator_statistics_t* out_statistics) {
+  iree_hal_heap_allocator_t* allocator =
+      iree_hal_heap_allocator_cast(base_allocator);
+  iree_slim_mutex_lock(&allocator->pool_mutex);
+  *out_statistics = allocator->memory_statistics;
+  iree_slim_mutex_unlock(&allocator->pool_mutex);
+}
+
+static void iree_hal_heap_allocator_reset_peak_memory_statistics(
+    iree_hal_allocator_t* base_allocator) {
+  iree_hal_heap_allocator_t* allocator =
+      iree_hal_heap_allocator_cast(base_allocator);
+  iree_slim_mutex_lock(&allocator->pool_mutex);
+  iree_hal_allocator_statistics_reset_peak(&allocator->memory_statistics);
+  iree_slim_mutex_unlock(&allocator->pool_mutex);
+}
+
 static const iree_hal_allocator_vtable_t iree_hal_heap_allocator_vtable = {
     .destroy = iree_hal_heap_allocator_destroy,
     .host_allocator = iree_hal_heap_allocator_host_allocator,
@@ -155,4 +397,7 @@ static const iree_hal_allocator_vtable_t iree_hal_heap_allocator_vtable = {
         iree_hal_heap_allocator_query_buffer_compatibility,
     .allocate_buffer = iree_hal_heap_allocator_allocate_buffer,
     .wrap_buffer = iree_hal_heap_allocator_wrap_buffer,
+    .query_statistics = iree_hal_heap_allocator_query_memory_statistics,
+    .reset_peak_statistics =
+        iree_hal_heap_allocator_reset_peak_memory_statistics,
 };
@@ -0,0 +1,75 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Measures the overhead of the transient buffer allocations made on each
+// invocation of a program: a handful of buffers of different sizes allocated
+// up front and released once the invocation completes. Compares the default
+// heap allocator (one host allocation and free per buffer) against the pooling
+// heap allocator that reuses storage across invocations.
+
+#include <cstdint>
+
+#include "benchmark/benchmark.h"
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+namespace {
+
+// Sizes of the transient buffers allocated per invocation.
+constexpr iree_device_size_t kTransientSizes[] = {
+    64, 256, 4 * 1024, 16 * 1024, 64 * 1024, 256 * 1024, 1024 * 1024, 1024,
+};
+constexpr int kTransientCount =
+    sizeof(kTransientSizes) / sizeof(kTransientSizes[0]);
+
+void RunInvocations(benchmark::State& state, iree_hal_allocator_t* allocator) {
+  iree_hal_buffer_t* buffers[kTransientCount];
+  for (auto _ : state) {
+    for (int i = 0; i < kTransientCount; ++i) {
+      IREE_CHECK_OK(iree_hal_allocator_allocate_buffer(
+          allocator,
+          IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE,
+          IREE_HAL_BUFFER_USAGE_ALL, kTransientSizes[i], &buffers[i]));
+    }
+    benchmark::DoNotOptimize(buffers);
+    for (int i = kTransientCount - 1; i >= 0; --i) {
+      iree_hal_buffer_release(buffers[i]);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kTransientCount);
+
+  iree_hal_heap_allocator_statistics_t statistics;
+  IREE_CHECK_OK(
+      iree_hal_heap_allocator_query_statistics(allocator, &statistics));
+  state.counters["host_allocs"] =
+      benchmark::Counter((double)statistics.host_allocation_count,
+                         benchmark::Counter::kAvgIterations);
+}
+
+void BM_TransientUnpooled(benchmark::State& state) {
+  iree_hal_allocator_t* allocator = NULL;
+  IREE_CHECK_OK(iree_hal_allocator_create_heap(iree_make_cstring_view("heap"),
+                                               iree_allocator_system(),
+                                               &allocator));
+  RunInvocations(state, allocator);
+  iree_hal_allocator_release(allocator);
+}
+BENCHMARK(BM_TransientUnpooled);
+
+void BM_TransientPooled(benchmark::State& state) {
+  iree_hal_heap_allocator_params_t params;
+  iree_hal_heap_allocator_params_initialize(&params);
+  params.max_pooled_allocation_size = 4 * 1024 * 1024;
+  iree_hal_allocator_t* allocator = NULL;
+  IREE_CHECK_OK(iree_hal_allocator_create_heap_with_params(
+      iree_make_cstring_view("heap"), &params, iree_allocator_system(),
+      &allocator));
+  RunInvocations(state, allocator);
+  iree_hal_allocator_release(allocator);
+}
+BENCHMARK(BM_TransientPooled);
+
+}  // namespace
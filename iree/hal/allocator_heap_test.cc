@@ -0,0 +1,202 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <cstdint>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+constexpr iree_hal_memory_type_t kMemoryType =
+    IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE;
+
+iree_hal_allocator_t* CreatePoolingAllocator(
+    iree_host_size_t max_pooled_allocation_size,
+    iree_host_size_t max_pooled_size) {
+  iree_hal_heap_allocator_params_t params;
+  iree_hal_heap_allocator_params_initialize(&params);
+  params.max_pooled_allocation_size = max_pooled_allocation_size;
+  params.max_pooled_size = max_pooled_size;
+  iree_hal_allocator_t* allocator = NULL;
+  IREE_CHECK_OK(iree_hal_allocator_create_heap_with_params(
+      iree_make_cstring_view("heap"), &params, iree_allocator_system(),
+      &allocator));
+  return allocator;
+}
+
+iree_hal_heap_allocator_statistics_t QueryStatistics(
+    iree_hal_allocator_t* allocator) {
+  iree_hal_heap_allocator_statistics_t statistics;
+  IREE_CHECK_OK(
+      iree_hal_heap_allocator_query_statistics(allocator, &statistics));
+  return statistics;
+}
+
+void* MapBuffer(iree_hal_buffer_t* buffer) {
+  iree_hal_buffer_mapping_t mapping;
+  IREE_CHECK_OK(iree_hal_buffer_map_range(
+      buffer, IREE_HAL_MEMORY_ACCESS_READ, 0, IREE_WHOLE_BUFFER, &mapping));
+  void* data = mapping.contents.data;
+  iree_hal_buffer_unmap_range(&mapping);
+  return data;
+}
+
+TEST(AllocatorHeapTest, InvalidAlignment) {
+  iree_hal_heap_allocator_params_t params;
+  iree_hal_heap_allocator_params_initialize(&params);
+  params.alignment = 24;
+  iree_hal_allocator_t* allocator = NULL;
+  iree_status_t status = iree_hal_allocator_create_heap_with_params(
+      iree_make_cstring_view("heap"), &params, iree_allocator_system(),
+      &allocator);
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_INVALID_ARGUMENT, status);
+  iree_status_free(status);
+  EXPECT_EQ(nullptr, allocator);
+}
+
+TEST(AllocatorHeapTest, ContentsAligned) {
+  iree_hal_heap_allocator_params_t params;
+  iree_hal_heap_allocator_params_initialize(&params);
+  params.alignment = 4096;
+  iree_hal_allocator_t* allocator = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_create_heap_with_params(
+      iree_make_cstring_view("heap"), &params, iree_allocator_system(),
+      &allocator));
+  for (iree_device_size_t size : {1, 100, 4096, 10000}) {
+    iree_hal_buffer_t* buffer = NULL;
+    IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+        allocator, kMemoryType, IREE_HAL_BUFFER_USAGE_ALL, size, &buffer));
+    EXPECT_EQ(0u, (uintptr_t)MapBuffer(buffer) % params.alignment);
+    iree_hal_buffer_release(buffer);
+  }
+  iree_hal_allocator_release(allocator);
+}
+
+TEST(AllocatorHeapTest, UnpooledByDefault) {
+  iree_hal_allocator_t* allocator = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_create_heap(
+      iree_make_cstring_view("heap"), iree_allocator_system(), &allocator));
+  for (int i = 0; i < 4; ++i) {
+    iree_hal_buffer_t* buffer = NULL;
+    IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+        allocator, kMemoryType, IREE_HAL_BUFFER_USAGE_ALL, 128, &buffer));
+    iree_hal_buffer_release(buffer);
+  }
+  auto statistics = QueryStatistics(allocator);
+  EXPECT_EQ(4u, statistics.allocation_count);
+  EXPECT_EQ(0u, statistics.pool_hit_count);
+  EXPECT_EQ(4u, statistics.host_allocation_count);
+  EXPECT_EQ(4u, statistics.host_free_count);
+  EXPECT_EQ(0u, statistics.pooled_size);
+  iree_hal_allocator_release(allocator);
+}
+
+TEST(AllocatorHeapTest, PooledReuse) {
+  iree_hal_allocator_t* allocator =
+      CreatePoolingAllocator(64 * 1024, 1024 * 1024);
+  for (int i = 0; i < 4; ++i) {
+    iree_hal_buffer_t* buffer = NULL;
+    IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+        allocator, kMemoryType, IREE_HAL_BUFFER_USAGE_ALL, 1000, &buffer));
+    iree_hal_buffer_release(buffer);
+  }
+  auto statistics = QueryStatistics(allocator);
+  EXPECT_EQ(4u, statistics.allocation_count);
+  EXPECT_EQ(3u, statistics.pool_hit_count);
+  EXPECT_EQ(1u, statistics.host_allocation_count);
+  EXPECT_EQ(0u, statistics.host_free_count);
+  EXPECT_NE(0u, statistics.pooled_size);
+
+  iree_hal_heap_allocator_trim(allocator);
+  statistics = QueryStatistics(allocator);
+  EXPECT_EQ(1u, statistics.host_free_count);
+  EXPECT_EQ(0u, statistics.pooled_size);
+  iree_hal_allocator_release(allocator);
+}
+
+TEST(AllocatorHeapTest, LargeAllocationsUnpooled) {
+  iree_hal_allocator_t* allocator = CreatePoolingAllocator(1024, 1024 * 1024);
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      allocator, kMemoryType, IREE_HAL_BUFFER_USAGE_ALL, 8192, &buffer));
+  iree_hal_buffer_release(buffer);
+  auto statistics = QueryStatistics(allocator);
+  EXPECT_EQ(1u, statistics.host_allocation_count);
+  EXPECT_EQ(1u, statistics.host_free_count);
+  EXPECT_EQ(0u, statistics.pooled_size);
+  iree_hal_allocator_release(allocator);
+}
+
+TEST(AllocatorHeapTest, PoolCapacityLimit) {
+  // Only one 64KB block fits within the retention limit; the second released
+  // block must be returned to the host allocator.
+  iree_hal_allocator_t* allocator =
+      CreatePoolingAllocator(64 * 1024, 64 * 1024);
+  iree_hal_buffer_t* buffers[2] = {NULL, NULL};
+  for (auto& buffer : buffers) {
+    IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+        allocator, kMemoryType, IREE_HAL_BUFFER_USAGE_ALL, 32 * 1024,
+        &buffer));
+  }
+  for (auto& buffer : buffers) iree_hal_buffer_release(buffer);
+  auto statistics = QueryStatistics(allocator);
+  EXPECT_EQ(2u, statistics.host_allocation_count);
+  EXPECT_EQ(1u, statistics.host_free_count);
+  EXPECT_EQ(64u * 1024, statistics.pooled_size);
+  iree_hal_allocator_release(allocator);
+}
+
+TEST(AllocatorHeapTest, MemoryStatistics) {
+  iree_hal_allocator_t* allocator = CreatePoolingAllocator(64 * 1024, 0);
+  iree_hal_buffer_t* buffers[2] = {NULL, NULL};
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      allocator, kMemoryType, IREE_HAL_BUFFER_USAGE_ALL, 1000, &buffers[0]));
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      allocator, kMemoryType | IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL,
+      IREE_HAL_BUFFER_USAGE_ALL, 3000, &buffers[1]));
+  iree_hal_allocator_statistics_t statistics;
+  iree_hal_allocator_query_statistics(allocator, &statistics);
+  EXPECT_EQ(1000u, statistics.host_local.bytes_live);
+  EXPECT_EQ(3000u, statistics.device_local.bytes_live);
+  EXPECT_EQ(4000u, statistics.total.bytes_live);
+  EXPECT_EQ(4000u, statistics.total.bytes_peak);
+  EXPECT_EQ(2u, statistics.total.allocation_count);
+
+  // Peaks remain after the buffers are released until reset.
+  iree_hal_buffer_release(buffers[1]);
+  iree_hal_allocator_query_statistics(allocator, &statistics);
+  EXPECT_EQ(1000u, statistics.total.bytes_live);
+  EXPECT_EQ(4000u, statistics.total.bytes_peak);
+  EXPECT_EQ(0u, statistics.device_local.bytes_live);
+  EXPECT_EQ(3000u, statistics.device_local.bytes_peak);
+  EXPECT_EQ(1u, statistics.device_local.free_count);
+  iree_hal_allocator_reset_peak_statistics(allocator);
+  iree_hal_allocator_query_statistics(allocator, &statistics);
+  EXPECT_EQ(1000u, statistics.total.bytes_peak);
+  EXPECT_EQ(0u, statistics.device_local.bytes_peak);
+
+  // Wrapped buffers do not own their memory and are not counted.
+  uint8_t data[16];
+  iree_hal_buffer_t* wrapped_buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_wrap_buffer(
+      allocator, kMemoryType, IREE_HAL_MEMORY_ACCESS_ALL,
+      IREE_HAL_BUFFER_USAGE_ALL, iree_make_byte_span(data, sizeof(data)),
+      iree_allocator_null(), &wrapped_buffer));
+  iree_hal_buffer_release(wrapped_buffer);
+
+  iree_hal_buffer_release(buffers[0]);
+  iree_hal_allocator_query_statistics(allocator, &statistics);
+  EXPECT_EQ(0u, statistics.total.bytes_live);
+  EXPECT_EQ(4000u, statistics.total.bytes_allocated);
+  EXPECT_EQ(4000u, statistics.total.bytes_freed);
+  EXPECT_EQ(2u, statistics.total.free_count);
+  iree_hal_allocator_release(allocator);
+}
+
+}  // namespace
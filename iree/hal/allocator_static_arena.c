@@ -0,0 +1,395 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/allocator.h"
+#include "iree/hal/buffer.h"
+#include "iree/hal/resource.h"
+
+// Alignment used when a plan does not specify one; matches the minimum
+// alignment the compiler plans with.
+#define IREE_HAL_STATIC_MEMORY_PLAN_DEFAULT_ALIGNMENT 16
+
+//===----------------------------------------------------------------------===//
+// iree_hal_static_memory_plan_t
+//===----------------------------------------------------------------------===//
+
+IREE_API_EXPORT iree_status_t iree_hal_static_memory_plan_parse(
+    iree_string_view_t value, iree_hal_static_memory_plan_t* out_plan) {
+  IREE_ASSERT_ARGUMENT(out_plan);
+  memset(out_plan, 0, sizeof(*out_plan));
+  out_plan->alignment = IREE_HAL_STATIC_MEMORY_PLAN_DEFAULT_ALIGNMENT;
+
+  // constant=N,transient=N,io=N,alignment=N
+  while (!iree_string_view_is_empty(value)) {
+    iree_string_view_t entry = iree_string_view_empty();
+    iree_string_view_split(value, ',', &entry, &value);
+    iree_string_view_t key = iree_string_view_empty();
+    iree_string_view_t number = iree_string_view_empty();
+    uint64_t parsed_value = 0;
+    if (iree_string_view_split(entry, '=', &key, &number) == -1 ||
+        !iree_string_view_atoi_uint64(number, &parsed_value)) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "malformed memory plan entry '%.*s'",
+                              (int)entry.size, entry.data);
+    }
+    if (iree_string_view_equal(key, iree_make_cstring_view("constant"))) {
+      out_plan->constant_size = (iree_device_size_t)parsed_value;
+    } else if (iree_string_view_equal(key,
+                                      iree_make_cstring_view("transient"))) {
+      out_plan->transient_size = (iree_device_size_t)parsed_value;
+    } else if (iree_string_view_equal(key, iree_make_cstring_view("io"))) {
+      out_plan->io_size = (iree_device_size_t)parsed_value;
+    } else if (iree_string_view_equal(key,
+                                      iree_make_cstring_view("alignment"))) {
+      out_plan->alignment = (iree_device_size_t)parsed_value;
+    }
+  }
+
+  if (out_plan->alignment == 0 ||
+      (out_plan->alignment & (out_plan->alignment - 1)) != 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "memory plan alignment must be a power of two "
+                            "(got %" PRIu64 ")",
+                            (uint64_t)out_plan->alignment);
+  }
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_device_size_t iree_hal_static_memory_plan_arena_size(
+    const iree_hal_static_memory_plan_t* plan) {
+  IREE_ASSERT_ARGUMENT(plan);
+  return iree_device_align(plan->constant_size, plan->alignment) +
+         iree_device_align(plan->transient_size, plan->alignment) +
+         iree_device_align(plan->io_size, plan->alignment);
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_static_arena_allocator_t
+//===----------------------------------------------------------------------===//
+
+typedef enum iree_hal_static_arena_region_e {
+  IREE_HAL_STATIC_ARENA_REGION_CONSTANT = 0,
+  IREE_HAL_STATIC_ARENA_REGION_TRANSIENT,
+  IREE_HAL_STATIC_ARENA_REGION_IO,
+  IREE_HAL_STATIC_ARENA_REGION_COUNT,
+} iree_hal_static_arena_region_t;
+
+static const char* iree_hal_static_arena_region_names[] = {
+    "constant",
+    "transient",
+    "io",
+};
+
+struct iree_hal_static_arena_allocator_t;
+
+// A bump-allocated region of the arena. Storage is only reclaimed once every
+// buffer allocated from the region has been released, which matches the
+// lifetimes of the buffers the compiler planned the region for (all constants
+// live as long as the module and all transients/outputs of an invocation are
+// released together).
+typedef struct iree_hal_static_arena_region_storage_t {
+  struct iree_hal_static_arena_allocator_t* allocator;
+  iree_hal_static_arena_region_t region;
+  iree_byte_span_t storage;
+  // Bytes of |storage| in use; allocations are made at this offset.
+  iree_host_size_t offset;
+  // High-water mark of |offset| since the peak was last reset.
+  iree_host_size_t peak_offset;
+  // Number of buffers with storage in the region that are still live.
+  iree_host_size_t live_count;
+} iree_hal_static_arena_region_storage_t;
+
+typedef struct iree_hal_static_arena_allocator_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  iree_string_view_t identifier;
+  iree_host_size_t alignment;
+
+  // Guards the regions and statistics. Buffers may be released on any thread.
+  iree_slim_mutex_t mutex;
+  iree_hal_static_arena_region_storage_t
+      regions[IREE_HAL_STATIC_ARENA_REGION_COUNT];
+  uint64_t bytes_allocated;
+  uint64_t allocation_count;
+  uint64_t free_count;
+} iree_hal_static_arena_allocator_t;
+
+static const iree_hal_allocator_vtable_t iree_hal_static_arena_allocator_vtable;
+
+static iree_hal_static_arena_allocator_t* iree_hal_static_arena_allocator_cast(
+    iree_hal_allocator_t* base_value) {
+  return (iree_hal_static_arena_allocator_t*)base_value;
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_allocator_create_static_arena(
+    iree_string_view_t identifier, const iree_hal_static_memory_plan_t* plan,
+    iree_byte_span_t arena, iree_allocator_t host_allocator,
+    iree_hal_allocator_t** out_allocator) {
+  IREE_ASSERT_ARGUMENT(plan);
+  IREE_ASSERT_ARGUMENT(out_allocator);
+  *out_allocator = NULL;
+  if (plan->alignment == 0 || (plan->alignment & (plan->alignment - 1)) != 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "memory plan alignment must be a power of two "
+                            "(got %" PRIu64 ")",
+                            (uint64_t)plan->alignment);
+  }
+  iree_device_size_t required_size =
+      iree_hal_static_memory_plan_arena_size(plan);
+  if (arena.data_length < required_size) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "arena of %zu bytes is too small for the memory "
+                            "plan (requires %" PRIu64 " bytes)",
+                            arena.data_length, (uint64_t)required_size);
+  }
+  if (((uintptr_t)arena.data & (plan->alignment - 1)) != 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "arena must be aligned to the memory plan "
+                            "alignment of %" PRIu64 " bytes",
+                            (uint64_t)plan->alignment);
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_static_arena_allocator_t* allocator = NULL;
+  iree_host_size_t total_size =
+      iree_sizeof_struct(*allocator) + identifier.size;
+  iree_status_t status =
+      iree_allocator_malloc(host_allocator, total_size, (void**)&allocator);
+  if (iree_status_is_ok(status)) {
+    memset(allocator, 0, sizeof(*allocator));
+    iree_hal_resource_initialize(&iree_hal_static_arena_allocator_vtable,
+                                 &allocator->resource);
+    allocator->host_allocator = host_allocator;
+    iree_string_view_append_to_buffer(
+        identifier, &allocator->identifier,
+        (char*)allocator + iree_sizeof_struct(*allocator));
+    allocator->alignment = (iree_host_size_t)plan->alignment;
+    iree_slim_mutex_initialize(&allocator->mutex);
+
+    // Regions are laid out back to back in the order of the plan.
+    const iree_device_size_t region_sizes[IREE_HAL_STATIC_ARENA_REGION_COUNT] =
+        {
+            plan->constant_size,
+            plan->transient_size,
+            plan->io_size,
+        };
+    uint8_t* region_base = arena.data;
+    for (int i = 0; i < IREE_HAL_STATIC_ARENA_REGION_COUNT; ++i) {
+      iree_hal_static_arena_region_storage_t* region = &allocator->regions[i];
+      iree_host_size_t region_size = (iree_host_size_t)iree_device_align(
+          region_sizes[i], plan->alignment);
+      region->allocator = allocator;
+      region->region = (iree_hal_static_arena_region_t)i;
+      region->storage = iree_make_byte_span(region_base, region_size);
+      region_base += region_size;
+    }
+
+    *out_allocator = (iree_hal_allocator_t*)allocator;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_static_arena_allocator_destroy(
+    iree_hal_allocator_t* base_allocator) {
+  iree_hal_static_arena_allocator_t* allocator =
+      iree_hal_static_arena_allocator_cast(base_allocator);
+  iree_allocator_t host_allocator = allocator->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_slim_mutex_deinitialize(&allocator->mutex);
+  iree_allocator_free(host_allocator, allocator);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static iree_allocator_t iree_hal_static_arena_allocator_host_allocator(
+    const iree_hal_allocator_t* base_allocator) {
+  iree_hal_static_arena_allocator_t* allocator =
+      (iree_hal_static_arena_allocator_t*)base_allocator;
+  return allocator->host_allocator;
+}
+
+static iree_hal_buffer_compatibility_t
+iree_hal_static_arena_allocator_query_buffer_compatibility(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_buffer_usage_t allowed_usage,
+    iree_hal_buffer_usage_t intended_usage,
+    iree_device_size_t allocation_size) {
+  // Arena storage is plain host memory and matches the heap allocator.
+  intended_usage &= allowed_usage;
+  iree_hal_buffer_compatibility_t compatibility =
+      IREE_HAL_BUFFER_COMPATIBILITY_ALLOCATABLE |
+      IREE_HAL_BUFFER_COMPATIBILITY_IMPORTABLE;
+  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE)) {
+    if (iree_all_bits_set(intended_usage, IREE_HAL_BUFFER_USAGE_TRANSFER)) {
+      compatibility |= IREE_HAL_BUFFER_COMPATIBILITY_QUEUE_TRANSFER;
+    }
+    if (iree_all_bits_set(intended_usage, IREE_HAL_BUFFER_USAGE_DISPATCH)) {
+      compatibility |= IREE_HAL_BUFFER_COMPATIBILITY_QUEUE_DISPATCH;
+    }
+  }
+  return compatibility;
+}
+
+static void iree_hal_static_arena_allocator_make_compatible(
+    iree_hal_memory_type_t* memory_type,
+    iree_hal_buffer_usage_t* allowed_usage) {
+  // As with the heap allocator all storage is host memory and host copies are
+  // performed by mapping.
+  *memory_type |= IREE_HAL_MEMORY_TYPE_HOST_VISIBLE;
+  *allowed_usage |=
+      IREE_HAL_BUFFER_USAGE_MAPPING | IREE_HAL_BUFFER_USAGE_TRANSFER;
+}
+
+// Returns the region the compiler planned an allocation of the given
+// |memory_type| and |allowed_usage| in.
+static iree_hal_static_arena_region_t iree_hal_static_arena_select_region(
+    iree_hal_memory_type_t memory_type, iree_hal_buffer_usage_t allowed_usage) {
+  if (iree_all_bits_set(allowed_usage, IREE_HAL_BUFFER_USAGE_CONSTANT)) {
+    return IREE_HAL_STATIC_ARENA_REGION_CONSTANT;
+  } else if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_TRANSIENT)) {
+    return IREE_HAL_STATIC_ARENA_REGION_TRANSIENT;
+  }
+  return IREE_HAL_STATIC_ARENA_REGION_IO;
+}
+
+// Releases one buffer worth of storage back to |region|.
+static void iree_hal_static_arena_region_release(
+    iree_hal_static_arena_region_storage_t* region) {
+  iree_hal_static_arena_allocator_t* allocator = region->allocator;
+  iree_slim_mutex_lock(&allocator->mutex);
+  ++allocator->free_count;
+  if (--region->live_count == 0) region->offset = 0;
+  iree_slim_mutex_unlock(&allocator->mutex);
+}
+
+// Allocator control function used as the data allocator of arena buffers.
+// The storage itself is owned by the arena and only the live count is tracked.
+static iree_status_t IREE_API_PTR iree_hal_static_arena_region_ctl(
+    void* self, iree_allocator_command_t command, const void* params,
+    void** inout_ptr) {
+  if (command != IREE_ALLOCATOR_COMMAND_FREE) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "static arena buffer storage is arena-owned");
+  }
+  iree_hal_static_arena_region_release(
+      (iree_hal_static_arena_region_storage_t*)self);
+  *inout_ptr = NULL;
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_static_arena_allocator_allocate_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_buffer_usage_t allowed_usage, iree_host_size_t allocation_size,
+    iree_hal_buffer_t** out_buffer) {
+  iree_hal_static_arena_allocator_t* allocator =
+      iree_hal_static_arena_allocator_cast(base_allocator);
+  iree_hal_static_arena_allocator_make_compatible(&memory_type,
+                                                  &allowed_usage);
+  iree_hal_static_arena_region_storage_t* region =
+      &allocator->regions[iree_hal_static_arena_select_region(memory_type,
+                                                              allowed_usage)];
+  iree_host_size_t aligned_size =
+      iree_host_align(allocation_size, allocator->alignment);
+
+  iree_slim_mutex_lock(&allocator->mutex);
+  iree_host_size_t available = region->storage.data_length - region->offset;
+  if (aligned_size > available) {
+    iree_slim_mutex_unlock(&allocator->mutex);
+    return iree_make_status(
+        IREE_STATUS_RESOURCE_EXHAUSTED,
+        "static arena '%.*s' %s region exhausted: %zu bytes requested with "
+        "%zu of %zu available; the allocation was not covered by the memory "
+        "plan",
+        (int)allocator->identifier.size, allocator->identifier.data,
+        iree_hal_static_arena_region_names[region->region], aligned_size,
+        available, region->storage.data_length);
+  }
+  uint8_t* data = region->storage.data + region->offset;
+  region->offset += aligned_size;
+  region->peak_offset = iree_max(region->peak_offset, region->offset);
+  ++region->live_count;
+  allocator->bytes_allocated += aligned_size;
+  ++allocator->allocation_count;
+  iree_slim_mutex_unlock(&allocator->mutex);
+
+  iree_allocator_t data_allocator = {
+      .self = region,
+      .ctl = iree_hal_static_arena_region_ctl,
+  };
+  iree_status_t status = iree_hal_heap_buffer_wrap(
+      base_allocator, memory_type, IREE_HAL_MEMORY_ACCESS_ALL, allowed_usage,
+      allocation_size, iree_make_byte_span(data, allocation_size),
+      data_allocator, out_buffer);
+  if (!iree_status_is_ok(status)) {
+    iree_hal_static_arena_region_release(region);
+  }
+  return status;
+}
+
+static iree_status_t iree_hal_static_arena_allocator_wrap_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage, iree_byte_span_t data,
+    iree_allocator_t data_allocator, iree_hal_buffer_t** out_buffer) {
+  iree_hal_static_arena_allocator_make_compatible(&memory_type,
+                                                  &allowed_usage);
+  return iree_hal_heap_buffer_wrap(base_allocator, memory_type, allowed_access,
+                                   allowed_usage, data.data_length, data,
+                                   data_allocator, out_buffer);
+}
+
+static void iree_hal_static_arena_allocator_query_statistics(
+    iree_hal_allocator_t* base_allocator,
+    iree_hal_allocator_statistics_t* out_statistics) {
+  iree_hal_static_arena_allocator_t* allocator =
+      iree_hal_static_arena_allocator_cast(base_allocator);
+  memset(out_statistics, 0, sizeof(*out_statistics));
+  iree_hal_allocator_memory_statistics_t* total = &out_statistics->total;
+  iree_slim_mutex_lock(&allocator->mutex);
+  for (int i = 0; i < IREE_HAL_STATIC_ARENA_REGION_COUNT; ++i) {
+    total->bytes_live += allocator->regions[i].offset;
+    total->bytes_peak += allocator->regions[i].peak_offset;
+  }
+  total->bytes_allocated = allocator->bytes_allocated;
+  total->bytes_freed = allocator->bytes_allocated - total->bytes_live;
+  total->allocation_count = allocator->allocation_count;
+  total->free_count = allocator->free_count;
+  iree_slim_mutex_unlock(&allocator->mutex);
+}
+
+static void iree_hal_static_arena_allocator_reset_peak_statistics(
+    iree_hal_allocator_t* base_allocator) {
+  iree_hal_static_arena_allocator_t* allocator =
+      iree_hal_static_arena_allocator_cast(base_allocator);
+  iree_slim_mutex_lock(&allocator->mutex);
+  for (int i = 0; i < IREE_HAL_STATIC_ARENA_REGION_COUNT; ++i) {
+    allocator->regions[i].peak_offset = allocator->regions[i].offset;
+  }
+  iree_slim_mutex_unlock(&allocator->mutex);
+}
+
+static const iree_hal_allocator_vtable_t
+    iree_hal_static_arena_allocator_vtable = {
+        .destroy = iree_hal_static_arena_allocator_destroy,
+        .host_allocator = iree_hal_static_arena_allocator_host_allocator,
+        .query_buffer_compatibility =
+            iree_hal_static_arena_allocator_query_buffer_compatibility,
+        .allocate_buffer = iree_hal_static_arena_allocator_allocate_buffer,
+        .wrap_buffer = iree_hal_static_arena_allocator_wrap_buffer,
+        .query_statistics = iree_hal_static_arena_allocator_query_statistics,
+        .reset_peak_statistics =
+            iree_hal_static_arena_allocator_reset_peak_statistics,
+};
@@ -0,0 +1,203 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <cstdint>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+constexpr iree_hal_memory_type_t kMemoryType =
+    IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE;
+
+class AllocatorStaticArenaTest : public ::testing::Test {
+ protected:
+  // Creates an allocator over a fresh arena sized for |plan|.
+  iree_hal_allocator_t* CreateAllocator(
+      const iree_hal_static_memory_plan_t& plan) {
+    iree_device_size_t arena_size =
+        iree_hal_static_memory_plan_arena_size(&plan);
+    arena_.resize(arena_size + plan.alignment);
+    uint8_t* base = (uint8_t*)iree_host_align((uintptr_t)arena_.data(),
+                                              plan.alignment);
+    iree_hal_allocator_t* allocator = NULL;
+    IREE_CHECK_OK(iree_hal_allocator_create_static_arena(
+        iree_make_cstring_view("arena"), &plan,
+        iree_make_byte_span(base, arena_size), iree_allocator_system(),
+        &allocator));
+    return allocator;
+  }
+
+  std::vector<uint8_t> arena_;
+};
+
+iree_hal_static_memory_plan_t ParsePlan(const char* value) {
+  iree_hal_static_memory_plan_t plan;
+  IREE_CHECK_OK(
+      iree_hal_static_memory_plan_parse(iree_make_cstring_view(value), &plan));
+  return plan;
+}
+
+void* MapBuffer(iree_hal_buffer_t* buffer) {
+  iree_hal_buffer_mapping_t mapping;
+  IREE_CHECK_OK(iree_hal_buffer_map_range(
+      buffer, IREE_HAL_MEMORY_ACCESS_READ, 0, IREE_WHOLE_BUFFER, &mapping));
+  void* data = mapping.contents.data;
+  iree_hal_buffer_unmap_range(&mapping);
+  return data;
+}
+
+TEST(StaticMemoryPlanTest, Parse) {
+  auto plan = ParsePlan("constant=128,transient=224,io=32,alignment=32");
+  EXPECT_EQ(128, plan.constant_size);
+  EXPECT_EQ(224, plan.transient_size);
+  EXPECT_EQ(32, plan.io_size);
+  EXPECT_EQ(32, plan.alignment);
+  EXPECT_EQ(128 + 224 + 32, iree_hal_static_memory_plan_arena_size(&plan));
+}
+
+TEST(StaticMemoryPlanTest, ParseIgnoresUnknownKeys) {
+  auto plan = ParsePlan("io=64,future=1");
+  EXPECT_EQ(0, plan.constant_size);
+  EXPECT_EQ(64, plan.io_size);
+  EXPECT_EQ(16, plan.alignment);
+}
+
+TEST(StaticMemoryPlanTest, ParseMalformed) {
+  iree_hal_static_memory_plan_t plan;
+  iree_status_t status = iree_hal_static_memory_plan_parse(
+      iree_make_cstring_view("constant=abc"), &plan);
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_INVALID_ARGUMENT, status);
+  iree_status_free(status);
+  status = iree_hal_static_memory_plan_parse(
+      iree_make_cstring_view("io=16,alignment=24"), &plan);
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_INVALID_ARGUMENT, status);
+  iree_status_free(status);
+}
+
+TEST_F(AllocatorStaticArenaTest, ArenaTooSmall) {
+  auto plan = ParsePlan("constant=64,transient=64,io=64,alignment=16");
+  alignas(16) uint8_t arena[128];
+  iree_hal_allocator_t* allocator = NULL;
+  iree_status_t status = iree_hal_allocator_create_static_arena(
+      iree_make_cstring_view("arena"), &plan,
+      iree_make_byte_span(arena, sizeof(arena)), iree_allocator_system(),
+      &allocator);
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_INVALID_ARGUMENT, status);
+  iree_status_free(status);
+  EXPECT_EQ(nullptr, allocator);
+}
+
+TEST_F(AllocatorStaticArenaTest, AllocatesFromPlannedRegions) {
+  auto plan = ParsePlan("constant=64,transient=64,io=64,alignment=32");
+  iree_hal_allocator_t* allocator = CreateAllocator(plan);
+  uint8_t* base = (uint8_t*)iree_host_align((uintptr_t)arena_.data(), 32);
+
+  iree_hal_buffer_t* constant = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      allocator, kMemoryType,
+      IREE_HAL_BUFFER_USAGE_CONSTANT | IREE_HAL_BUFFER_USAGE_DISPATCH, 40,
+      &constant));
+  iree_hal_buffer_t* transient = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      allocator, kMemoryType | IREE_HAL_MEMORY_TYPE_TRANSIENT,
+      IREE_HAL_BUFFER_USAGE_DISPATCH, 16, &transient));
+  iree_hal_buffer_t* output = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      allocator, kMemoryType, IREE_HAL_BUFFER_USAGE_ALL, 64, &output));
+
+  EXPECT_EQ(base, MapBuffer(constant));
+  EXPECT_EQ(base + 64, MapBuffer(transient));
+  EXPECT_EQ(base + 128, MapBuffer(output));
+  EXPECT_EQ(40, iree_hal_buffer_byte_length(constant));
+
+  iree_hal_allocator_statistics_t statistics;
+  iree_hal_allocator_query_statistics(allocator, &statistics);
+  EXPECT_EQ(64 + 32 + 64, statistics.total.bytes_live);
+  EXPECT_EQ(3, statistics.total.allocation_count);
+
+  iree_hal_buffer_release(constant);
+  iree_hal_buffer_release(transient);
+  iree_hal_buffer_release(output);
+
+  iree_hal_allocator_query_statistics(allocator, &statistics);
+  EXPECT_EQ(0, statistics.total.bytes_live);
+  EXPECT_EQ(64 + 32 + 64, statistics.total.bytes_peak);
+  EXPECT_EQ(3, statistics.total.free_count);
+  iree_hal_allocator_release(allocator);
+}
+
+TEST_F(AllocatorStaticArenaTest, RegionExhausted) {
+  auto plan = ParsePlan("constant=0,transient=32,io=0,alignment=16");
+  iree_hal_allocator_t* allocator = CreateAllocator(plan);
+
+  iree_hal_buffer_t* buffer0 = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      allocator, kMemoryType | IREE_HAL_MEMORY_TYPE_TRANSIENT,
+      IREE_HAL_BUFFER_USAGE_DISPATCH, 32, &buffer0));
+  iree_hal_buffer_t* buffer1 = NULL;
+  iree_status_t status = iree_hal_allocator_allocate_buffer(
+      allocator, kMemoryType | IREE_HAL_MEMORY_TYPE_TRANSIENT,
+      IREE_HAL_BUFFER_USAGE_DISPATCH, 1, &buffer1);
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_RESOURCE_EXHAUSTED, status);
+  iree_status_free(status);
+
+  // Outputs are planned separately and must not spill into the transients.
+  status = iree_hal_allocator_allocate_buffer(
+      allocator, kMemoryType, IREE_HAL_BUFFER_USAGE_ALL, 16, &buffer1);
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_RESOURCE_EXHAUSTED, status);
+  iree_status_free(status);
+
+  iree_hal_buffer_release(buffer0);
+  iree_hal_allocator_release(allocator);
+}
+
+TEST_F(AllocatorStaticArenaTest, RegionResetsWhenReleased) {
+  auto plan = ParsePlan("constant=0,transient=64,io=0,alignment=16");
+  iree_hal_allocator_t* allocator = CreateAllocator(plan);
+
+  // Simulate repeated invocations that each fill the transient region.
+  void* first_data = NULL;
+  for (int i = 0; i < 4; ++i) {
+    iree_hal_buffer_t* buffer0 = NULL;
+    IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+        allocator, kMemoryType | IREE_HAL_MEMORY_TYPE_TRANSIENT,
+        IREE_HAL_BUFFER_USAGE_DISPATCH, 48, &buffer0));
+    iree_hal_buffer_t* buffer1 = NULL;
+    IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+        allocator, kMemoryType | IREE_HAL_MEMORY_TYPE_TRANSIENT,
+        IREE_HAL_BUFFER_USAGE_DISPATCH, 16, &buffer1));
+    if (i == 0) first_data = MapBuffer(buffer0);
+    EXPECT_EQ(first_data, MapBuffer(buffer0));
+    iree_hal_buffer_release(buffer1);
+    iree_hal_buffer_release(buffer0);
+  }
+
+  iree_hal_allocator_release(allocator);
+}
+
+TEST_F(AllocatorStaticArenaTest, WrapTakesNoArenaSpace) {
+  auto plan = ParsePlan("constant=0,transient=0,io=0,alignment=16");
+  iree_hal_allocator_t* allocator = CreateAllocator(plan);
+
+  alignas(16) static const uint8_t kData[32] = {1, 2, 3, 4};
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_wrap_buffer(
+      allocator, kMemoryType, IREE_HAL_MEMORY_ACCESS_READ,
+      IREE_HAL_BUFFER_USAGE_CONSTANT | IREE_HAL_BUFFER_USAGE_DISPATCH,
+      iree_make_byte_span((void*)kData, sizeof(kData)),
+      iree_allocator_null(), &buffer));
+  EXPECT_EQ(kData, MapBuffer(buffer));
+  iree_hal_buffer_release(buffer);
+
+  iree_hal_allocator_release(allocator);
+}
+
+}  // namespace
@@ -12,6 +12,7 @@
 #include "iree/base/tracing.h"
 #include "iree/hal/allocator.h"
 #include "iree/hal/buffer.h"
+#include "iree/hal/buffer_heap_impl.h"
 #include "iree/hal/resource.h"
 
 typedef struct iree_hal_heap_buffer_t {
@@ -19,6 +20,10 @@ typedef struct iree_hal_heap_buffer_t {
 
   iree_byte_span_t data;
   iree_allocator_t data_allocator;
+
+  // Size of the block acquired from the heap allocator containing both the
+  // buffer and its contents or 0 if the buffer wraps external data.
+  iree_host_size_t block_size;
 } iree_hal_heap_buffer_t;
 
 static const iree_hal_buffer_vtable_t iree_hal_heap_buffer_vtable;
@@ -27,18 +32,20 @@ iree_status_t iree_hal_heap_buffer_create(
     iree_hal_allocator_t* allocator, iree_hal_memory_type_t memory_type,
     iree_hal_memory_access_t allowed_access,
     iree_hal_buffer_usage_t allowed_usage, iree_device_size_t allocation_size,
-    iree_allocator_t host_allocator, iree_hal_buffer_t** out_buffer) {
+    iree_host_size_t alignment, iree_hal_buffer_t** out_buffer) {
   IREE_ASSERT_ARGUMENT(allocator);
   IREE_ASSERT_ARGUMENT(out_buffer);
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  // NOTE: we want the buffer data to always be 16-byte aligned.
+  // The buffer header and its contents share a single block. The block is only
+  // guaranteed to have the natural alignment of the host allocator so we
+  // over-allocate enough to align the contents to |alignment| (which may be as
+  // large as a page for buffers that are mapped or imported elsewhere).
   iree_hal_heap_buffer_t* buffer = NULL;
-  iree_host_size_t header_size =
-      iree_host_align(iree_sizeof_struct(*buffer), 16);
-  iree_host_size_t total_size = header_size + allocation_size;
-  iree_status_t status =
-      iree_allocator_malloc(host_allocator, total_size, (void**)&buffer);
+  iree_host_size_t header_size = iree_sizeof_struct(*buffer);
+  iree_host_size_t block_size = header_size + alignment + allocation_size;
+  iree_status_t status = iree_hal_heap_allocator_acquire_block(
+      allocator, block_size, (void**)&buffer);
   if (iree_status_is_ok(status)) {
     iree_hal_resource_initialize(&iree_hal_heap_buffer_vtable,
                                  &buffer->base.resource);
@@ -50,9 +57,11 @@ iree_status_t iree_hal_heap_buffer_create(
     buffer->base.memory_type = memory_type;
     buffer->base.allowed_access = allowed_access;
     buffer->base.allowed_usage = allowed_usage;
-    buffer->data =
-        iree_make_byte_span((uint8_t*)buffer + header_size, allocation_size);
+    uint8_t* data_ptr = (uint8_t*)iree_host_align(
+        (uintptr_t)buffer + header_size, alignment);
+    buffer->data = iree_make_byte_span(data_ptr, allocation_size);
     buffer->data_allocator = iree_allocator_null();  // freed with the buffer
+    buffer->block_size = block_size;
     *out_buffer = &buffer->base;
   }
 
@@ -87,6 +96,7 @@ IREE_API_EXPORT iree_status_t iree_hal_heap_buffer_wrap(
     buffer->base.allowed_usage = allowed_usage;
     buffer->data = data;
     buffer->data_allocator = data_allocator;
+    buffer->block_size = 0;
     *out_buffer = &buffer->base;
   }
 
@@ -96,12 +106,17 @@ IREE_API_EXPORT iree_status_t iree_hal_heap_buffer_wrap(
 
 static void iree_hal_heap_buffer_destroy(iree_hal_buffer_t* base_buffer) {
   iree_hal_heap_buffer_t* buffer = (iree_hal_heap_buffer_t*)base_buffer;
-  iree_allocator_t host_allocator =
-      iree_hal_allocator_host_allocator(iree_hal_buffer_allocator(base_buffer));
+  iree_hal_allocator_t* allocator = iree_hal_buffer_allocator(base_buffer);
   IREE_TRACE_ZONE_BEGIN(z0);
 
   iree_allocator_free(buffer->data_allocator, buffer->data.data);
-  iree_allocator_free(host_allocator, buffer);
+  if (buffer->block_size) {
+    iree_hal_heap_allocator_release_block(
+        allocator, buffer, buffer->block_size, base_buffer->memory_type,
+        base_buffer->allocation_size);
+  } else {
+    iree_allocator_free(iree_hal_allocator_host_allocator(allocator), buffer);
+  }
 
   IREE_TRACE_ZONE_END(z0);
 }
@@ -18,13 +18,29 @@ extern "C" {
 // Private utilities for working with heap buffers
 //===----------------------------------------------------------------------===//
 
-// Allocates a new heap buffer from the specified |host_allocator|.
+// Allocates a new heap buffer with contents aligned to |alignment| from storage
+// acquired from the heap |allocator|.
 // |out_buffer| must be released by the caller.
 iree_status_t iree_hal_heap_buffer_create(
     iree_hal_allocator_t* allocator, iree_hal_memory_type_t memory_type,
     iree_hal_memory_access_t allowed_access,
     iree_hal_buffer_usage_t allowed_usage, iree_device_size_t allocation_size,
-    iree_allocator_t host_allocator, iree_hal_buffer_t** out_buffer);
+    iree_host_size_t alignment, iree_hal_buffer_t** out_buffer);
+
+// Acquires a block of storage of at least |block_size| bytes from the heap
+// |allocator|, either reusing pooled storage or allocating from the host.
+iree_status_t iree_hal_heap_allocator_acquire_block(
+    iree_hal_allocator_t* allocator, iree_host_size_t block_size,
+    void** out_block);
+
+// Releases a |block| previously acquired with the same |block_size| back to
+// the heap |allocator| and records the free of the buffer of |memory_type| and
+// |allocation_size| stored within it.
+void iree_hal_heap_allocator_release_block(iree_hal_allocator_t* allocator,
+                                           void* block,
+                                           iree_host_size_t block_size,
+                                           iree_hal_memory_type_t memory_type,
+                                           iree_device_size_t allocation_size);
 
 #ifdef __cplusplus
 }  // extern "C"
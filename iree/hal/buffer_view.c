@@ -8,23 +8,82 @@
 
 #include <inttypes.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/arena.h"
+#include "iree/base/internal/math.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/allocator.h"
 #include "iree/hal/resource.h"
 #include "iree/hal/string_util.h"
 
+// Total size of each block in a buffer view pool, including the arena footer.
+// Sized to fit the shapes of nearly all tensors.
+#define IREE_HAL_BUFFER_VIEW_POOL_BLOCK_SIZE 128
+
+// Describes where the storage of a buffer view came from and how it must be
+// returned when the buffer view is destroyed.
+typedef enum iree_hal_buffer_view_storage_kind_e {
+  // Allocated from the host allocator of the buffer.
+  IREE_HAL_BUFFER_VIEW_STORAGE_KIND_HEAP = 0,
+  // Allocated from a block of |pool|.
+  IREE_HAL_BUFFER_VIEW_STORAGE_KIND_POOLED = 1,
+  // Caller-provided iree_hal_buffer_view_storage_t.
+  IREE_HAL_BUFFER_VIEW_STORAGE_KIND_INLINE = 2,
+} iree_hal_buffer_view_storage_kind_t;
+
 struct iree_hal_buffer_view_t {
   iree_atomic_ref_count_t ref_count;
+  uint32_t storage_kind;
   iree_hal_buffer_t* buffer;
   iree_hal_element_type_t element_type;
   iree_hal_encoding_type_t encoding_type;
   iree_device_size_t byte_length;
+  // Pool the storage was allocated from when STORAGE_KIND_POOLED.
+  iree_hal_buffer_view_pool_t* pool;
   iree_host_size_t shape_rank;
   iree_hal_dim_t shape[];
 };
 
+// We overlay buffer views onto the external iree_hal_buffer_view_storage_t
+// struct; ensure the shape dimensions that follow the header fit.
+static_assert(sizeof(iree_hal_buffer_view_t) <=
+                  offsetof(iree_hal_buffer_view_storage_t, shape),
+              "buffer view must fit inside the external storage header");
+
+struct iree_hal_buffer_view_pool_t {
+  iree_atomic_ref_count_t ref_count;
+  iree_allocator_t host_allocator;
+  iree_arena_block_pool_t block_pool;
+  iree_host_size_t max_rank;
+};
+
+// Initializes the fields of |buffer_view| in already-allocated storage.
+static void iree_hal_buffer_view_initialize_fields(
+    iree_hal_buffer_t* buffer, const iree_hal_dim_t* shape,
+    iree_host_size_t shape_rank, iree_hal_element_type_t element_type,
+    iree_hal_encoding_type_t encoding_type,
+    iree_hal_buffer_view_storage_kind_t storage_kind,
+    iree_hal_buffer_view_pool_t* pool, iree_hal_buffer_view_t* buffer_view) {
+  iree_atomic_ref_count_init(&buffer_view->ref_count);
+  buffer_view->storage_kind = storage_kind;
+  buffer_view->buffer = buffer;
+  iree_hal_buffer_retain(buffer_view->buffer);
+  buffer_view->element_type = element_type;
+  buffer_view->encoding_type = encoding_type;
+  buffer_view->byte_length =
+      iree_hal_element_byte_count(buffer_view->element_type);
+  buffer_view->pool = pool;
+  iree_hal_buffer_view_pool_retain(buffer_view->pool);
+  buffer_view->shape_rank = shape_rank;
+  for (iree_host_size_t i = 0; i < shape_rank; ++i) {
+    buffer_view->shape[i] = shape[i];
+    buffer_view->byte_length *= shape[i];
+  }
+}
+
 IREE_API_EXPORT iree_status_t iree_hal_buffer_view_create(
     iree_hal_buffer_t* buffer, const iree_hal_dim_t* shape,
     iree_host_size_t shape_rank, iree_hal_element_type_t element_type,
@@ -52,18 +111,9 @@ IREE_API_EXPORT iree_status_t iree_hal_buffer_view_create(
       sizeof(*buffer_view) + sizeof(iree_hal_dim_t) * shape_rank,
       (void**)&buffer_view);
   if (iree_status_is_ok(status)) {
-    iree_atomic_ref_count_init(&buffer_view->ref_count);
-    buffer_view->buffer = buffer;
-    iree_hal_buffer_retain(buffer_view->buffer);
-    buffer_view->element_type = element_type;
-    buffer_view->encoding_type = encoding_type;
-    buffer_view->byte_length =
-        iree_hal_element_byte_count(buffer_view->element_type);
-    buffer_view->shape_rank = shape_rank;
-    for (iree_host_size_t i = 0; i < shape_rank; ++i) {
-      buffer_view->shape[i] = shape[i];
-      buffer_view->byte_length *= shape[i];
-    }
+    iree_hal_buffer_view_initialize_fields(
+        buffer, shape, shape_rank, element_type, encoding_type,
+        IREE_HAL_BUFFER_VIEW_STORAGE_KIND_HEAP, /*pool=*/NULL, buffer_view);
     *out_buffer_view = buffer_view;
   }
 
@@ -71,6 +121,42 @@ IREE_API_EXPORT iree_status_t iree_hal_buffer_view_create(
   return status;
 }
 
+IREE_API_EXPORT iree_status_t iree_hal_buffer_view_initialize(
+    iree_hal_buffer_t* buffer, const iree_hal_dim_t* shape,
+    iree_host_size_t shape_rank, iree_hal_element_type_t element_type,
+    iree_hal_encoding_type_t encoding_type,
+    iree_hal_buffer_view_storage_t* storage,
+    iree_hal_buffer_view_t** out_buffer_view) {
+  IREE_ASSERT_ARGUMENT(buffer);
+  IREE_ASSERT_ARGUMENT(storage);
+  IREE_ASSERT_ARGUMENT(out_buffer_view);
+  *out_buffer_view = NULL;
+  if (IREE_UNLIKELY(shape_rank > 0 && !shape)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "no shape dimensions specified");
+  } else if (IREE_UNLIKELY(shape_rank >
+                           IREE_HAL_BUFFER_VIEW_STORAGE_MAX_RANK)) {
+    return iree_make_status(
+        IREE_STATUS_OUT_OF_RANGE,
+        "shape rank %zu exceeds the inline storage maximum of %d", shape_rank,
+        IREE_HAL_BUFFER_VIEW_STORAGE_MAX_RANK);
+  }
+  iree_hal_buffer_view_t* buffer_view = (iree_hal_buffer_view_t*)storage;
+  iree_hal_buffer_view_initialize_fields(
+      buffer, shape, shape_rank, element_type, encoding_type,
+      IREE_HAL_BUFFER_VIEW_STORAGE_KIND_INLINE, /*pool=*/NULL, buffer_view);
+  *out_buffer_view = buffer_view;
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT void iree_hal_buffer_view_deinitialize(
+    iree_hal_buffer_view_t* buffer_view) {
+  if (!buffer_view) return;
+  IREE_ASSERT_EQ(buffer_view->storage_kind,
+                 IREE_HAL_BUFFER_VIEW_STORAGE_KIND_INLINE);
+  iree_hal_buffer_view_release(buffer_view);
+}
+
 IREE_API_EXPORT void iree_hal_buffer_view_retain(
     iree_hal_buffer_view_t* buffer_view) {
   if (IREE_LIKELY(buffer_view)) {
@@ -88,10 +174,30 @@ IREE_API_EXPORT void iree_hal_buffer_view_release(
 
 IREE_API_EXPORT void iree_hal_buffer_view_destroy(
     iree_hal_buffer_view_t* buffer_view) {
-  iree_allocator_t host_allocator = iree_hal_allocator_host_allocator(
-      iree_hal_buffer_allocator(buffer_view->buffer));
-  iree_hal_buffer_release(buffer_view->buffer);
-  iree_allocator_free(host_allocator, buffer_view);
+  iree_hal_buffer_t* buffer = buffer_view->buffer;
+  switch (buffer_view->storage_kind) {
+    default:
+    case IREE_HAL_BUFFER_VIEW_STORAGE_KIND_HEAP: {
+      iree_allocator_t host_allocator = iree_hal_allocator_host_allocator(
+          iree_hal_buffer_allocator(buffer));
+      iree_allocator_free(host_allocator, buffer_view);
+      break;
+    }
+    case IREE_HAL_BUFFER_VIEW_STORAGE_KIND_POOLED: {
+      // The block footer follows the usable bytes of the block.
+      iree_hal_buffer_view_pool_t* pool = buffer_view->pool;
+      iree_arena_block_t* block =
+          (iree_arena_block_t*)((uint8_t*)buffer_view +
+                                pool->block_pool.usable_block_size);
+      iree_arena_block_pool_release(&pool->block_pool, block, block);
+      iree_hal_buffer_view_pool_release(pool);
+      break;
+    }
+    case IREE_HAL_BUFFER_VIEW_STORAGE_KIND_INLINE:
+      // Owned by the caller.
+      break;
+  }
+  iree_hal_buffer_release(buffer);
 }
 
 IREE_API_EXPORT iree_status_t iree_hal_buffer_view_allocate_buffer(
@@ -745,3 +851,209 @@ IREE_API_EXPORT iree_status_t iree_hal_buffer_view_fprint(
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
+
+// Accumulates |value| into the min/max of |summary|. |has_value| tracks
+// whether any value has been accumulated yet.
+static inline void iree_hal_buffer_view_summary_accumulate(
+    iree_hal_buffer_view_summary_t* summary, bool* has_value, double value) {
+  if (value != value) {
+    ++summary->nan_count;
+  } else if (!*has_value) {
+    summary->min_value = value;
+    summary->max_value = value;
+    *has_value = true;
+  } else {
+    summary->min_value = iree_min(summary->min_value, value);
+    summary->max_value = iree_max(summary->max_value, value);
+  }
+}
+
+#define IREE_HAL_SUMMARIZE_ELEMENTS(type, convert)                   \
+  for (iree_host_size_t i = 0; i < element_count; ++i) {            \
+    type value;                                                      \
+    memcpy(&value, contents.data + i * sizeof(type), sizeof(type));  \
+    iree_hal_buffer_view_summary_accumulate(out_summary, &has_value, \
+                                            (double)(convert));      \
+  }
+
+IREE_API_EXPORT iree_status_t iree_hal_buffer_view_summarize(
+    const iree_hal_buffer_view_t* buffer_view,
+    iree_hal_buffer_view_summary_t* out_summary) {
+  IREE_ASSERT_ARGUMENT(buffer_view);
+  IREE_ASSERT_ARGUMENT(out_summary);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  memset(out_summary, 0, sizeof(*out_summary));
+
+  iree_hal_buffer_mapping_t buffer_mapping;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_buffer_map_range(iree_hal_buffer_view_buffer(buffer_view),
+                                    IREE_HAL_MEMORY_ACCESS_READ, 0,
+                                    iree_hal_buffer_view_byte_length(
+                                        buffer_view),
+                                    &buffer_mapping));
+  iree_const_byte_span_t contents = iree_make_const_byte_span(
+      buffer_mapping.contents.data, buffer_mapping.contents.data_length);
+
+  iree_hal_element_type_t element_type =
+      iree_hal_buffer_view_element_type(buffer_view);
+  iree_host_size_t element_count =
+      (iree_host_size_t)iree_hal_buffer_view_element_count(buffer_view);
+  iree_host_size_t element_size = iree_hal_element_byte_count(element_type);
+  if (element_size > 0) {
+    element_count =
+        iree_min(element_count, contents.data_length / element_size);
+  }
+  out_summary->element_count = element_count;
+
+  // FNV-1a over the raw bytes.
+  uint64_t checksum = 0xCBF29CE484222325ull;
+  for (iree_host_size_t i = 0; i < contents.data_length; ++i) {
+    checksum = (checksum ^ contents.data[i]) * 0x100000001B3ull;
+  }
+  out_summary->checksum = checksum;
+
+  bool has_value = false;
+  switch (element_type) {
+    case IREE_HAL_ELEMENT_TYPE_SINT_8:
+      IREE_HAL_SUMMARIZE_ELEMENTS(int8_t, value);
+      break;
+    case IREE_HAL_ELEMENT_TYPE_UINT_8:
+      IREE_HAL_SUMMARIZE_ELEMENTS(uint8_t, value);
+      break;
+    case IREE_HAL_ELEMENT_TYPE_SINT_16:
+      IREE_HAL_SUMMARIZE_ELEMENTS(int16_t, value);
+      break;
+    case IREE_HAL_ELEMENT_TYPE_UINT_16:
+      IREE_HAL_SUMMARIZE_ELEMENTS(uint16_t, value);
+      break;
+    case IREE_HAL_ELEMENT_TYPE_SINT_32:
+      IREE_HAL_SUMMARIZE_ELEMENTS(int32_t, value);
+      break;
+    case IREE_HAL_ELEMENT_TYPE_UINT_32:
+      IREE_HAL_SUMMARIZE_ELEMENTS(uint32_t, value);
+      break;
+    case IREE_HAL_ELEMENT_TYPE_SINT_64:
+      IREE_HAL_SUMMARIZE_ELEMENTS(int64_t, value);
+      break;
+    case IREE_HAL_ELEMENT_TYPE_UINT_64:
+      IREE_HAL_SUMMARIZE_ELEMENTS(uint64_t, value);
+      break;
+    case IREE_HAL_ELEMENT_TYPE_FLOAT_16:
+      IREE_HAL_SUMMARIZE_ELEMENTS(uint16_t, iree_math_f16_to_f32(value));
+      break;
+    case IREE_HAL_ELEMENT_TYPE_FLOAT_32:
+      IREE_HAL_SUMMARIZE_ELEMENTS(float, value);
+      break;
+    case IREE_HAL_ELEMENT_TYPE_FLOAT_64:
+      IREE_HAL_SUMMARIZE_ELEMENTS(double, value);
+      break;
+    default:
+      // Opaque and unsupported types only get a checksum.
+      break;
+  }
+
+  iree_hal_buffer_unmap_range(&buffer_mapping);
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+#undef IREE_HAL_SUMMARIZE_ELEMENTS
+
+//===----------------------------------------------------------------------===//
+// iree_hal_buffer_view_pool_t
+//===----------------------------------------------------------------------===//
+
+IREE_API_EXPORT iree_status_t iree_hal_buffer_view_pool_create(
+    iree_allocator_t host_allocator,
+    iree_hal_buffer_view_pool_t** out_buffer_view_pool) {
+  IREE_ASSERT_ARGUMENT(out_buffer_view_pool);
+  *out_buffer_view_pool = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_buffer_view_pool_t* pool = NULL;
+  iree_status_t status =
+      iree_allocator_malloc(host_allocator, sizeof(*pool), (void**)&pool);
+  if (iree_status_is_ok(status)) {
+    iree_atomic_ref_count_init(&pool->ref_count);
+    pool->host_allocator = host_allocator;
+    iree_arena_block_pool_initialize(IREE_HAL_BUFFER_VIEW_POOL_BLOCK_SIZE,
+                                     host_allocator, &pool->block_pool);
+    pool->max_rank =
+        (pool->block_pool.usable_block_size - sizeof(iree_hal_buffer_view_t)) /
+        sizeof(iree_hal_dim_t);
+    *out_buffer_view_pool = pool;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_buffer_view_pool_destroy(
+    iree_hal_buffer_view_pool_t* pool) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_allocator_t host_allocator = pool->host_allocator;
+  iree_arena_block_pool_deinitialize(&pool->block_pool);
+  iree_allocator_free(host_allocator, pool);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+IREE_API_EXPORT void iree_hal_buffer_view_pool_retain(
+    iree_hal_buffer_view_pool_t* buffer_view_pool) {
+  if (IREE_LIKELY(buffer_view_pool)) {
+    iree_atomic_ref_count_inc(&buffer_view_pool->ref_count);
+  }
+}
+
+IREE_API_EXPORT void iree_hal_buffer_view_pool_release(
+    iree_hal_buffer_view_pool_t* buffer_view_pool) {
+  if (IREE_LIKELY(buffer_view_pool) &&
+      iree_atomic_ref_count_dec(&buffer_view_pool->ref_count) == 1) {
+    iree_hal_buffer_view_pool_destroy(buffer_view_pool);
+  }
+}
+
+IREE_API_EXPORT iree_host_size_t iree_hal_buffer_view_pool_max_rank(
+    const iree_hal_buffer_view_pool_t* buffer_view_pool) {
+  IREE_ASSERT_ARGUMENT(buffer_view_pool);
+  return buffer_view_pool->max_rank;
+}
+
+IREE_API_EXPORT void iree_hal_buffer_view_pool_trim(
+    iree_hal_buffer_view_pool_t* buffer_view_pool) {
+  IREE_ASSERT_ARGUMENT(buffer_view_pool);
+  iree_arena_block_pool_trim(&buffer_view_pool->block_pool);
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_buffer_view_create_pooled(
+    iree_hal_buffer_view_pool_t* buffer_view_pool, iree_hal_buffer_t* buffer,
+    const iree_hal_dim_t* shape, iree_host_size_t shape_rank,
+    iree_hal_element_type_t element_type,
+    iree_hal_encoding_type_t encoding_type,
+    iree_hal_buffer_view_t** out_buffer_view) {
+  IREE_ASSERT_ARGUMENT(buffer_view_pool);
+  IREE_ASSERT_ARGUMENT(buffer);
+  IREE_ASSERT_ARGUMENT(out_buffer_view);
+  if (shape_rank > buffer_view_pool->max_rank) {
+    return iree_hal_buffer_view_create(buffer, shape, shape_rank, element_type,
+                                       encoding_type, out_buffer_view);
+  }
+
+  *out_buffer_view = NULL;
+  if (IREE_UNLIKELY(shape_rank > 0 && !shape)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "no shape dimensions specified");
+  }
+
+  // The usable bytes of the block precede its footer.
+  iree_arena_block_t* block = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_arena_block_pool_acquire(&buffer_view_pool->block_pool, &block));
+  iree_hal_buffer_view_t* buffer_view =
+      (iree_hal_buffer_view_t*)((uint8_t*)block -
+                                buffer_view_pool->block_pool.usable_block_size);
+  iree_hal_buffer_view_initialize_fields(
+      buffer, shape, shape_rank, element_type, encoding_type,
+      IREE_HAL_BUFFER_VIEW_STORAGE_KIND_POOLED, buffer_view_pool, buffer_view);
+  *out_buffer_view = buffer_view;
+  return iree_ok_status();
+}
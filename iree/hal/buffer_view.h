@@ -146,6 +146,35 @@ IREE_API_EXPORT iree_status_t iree_hal_buffer_view_create(
     iree_hal_encoding_type_t encoding_type,
     iree_hal_buffer_view_t** out_buffer_view);
 
+// Maximum shape rank of a buffer view initialized in caller-provided
+// iree_hal_buffer_view_storage_t.
+#define IREE_HAL_BUFFER_VIEW_STORAGE_MAX_RANK 8
+
+// Caller-provided storage for a buffer view with a shape rank of up to
+// IREE_HAL_BUFFER_VIEW_STORAGE_MAX_RANK. Usually stack allocated for buffer
+// views used transiently within a single scope.
+typedef struct iree_hal_buffer_view_storage_t {
+  uint64_t reserved[6];  // opaque
+  iree_hal_dim_t shape[IREE_HAL_BUFFER_VIEW_STORAGE_MAX_RANK];
+} iree_hal_buffer_view_storage_t;
+
+// Initializes a buffer view with the given |buffer| in caller-provided
+// |storage| and returns it in |out_buffer_view|. No allocations are performed.
+// The buffer view must be deinitialized with iree_hal_buffer_view_deinitialize
+// before |storage| goes out of scope and must not be retained beyond that.
+IREE_API_EXPORT iree_status_t iree_hal_buffer_view_initialize(
+    iree_hal_buffer_t* buffer, const iree_hal_dim_t* shape,
+    iree_host_size_t shape_rank, iree_hal_element_type_t element_type,
+    iree_hal_encoding_type_t encoding_type,
+    iree_hal_buffer_view_storage_t* storage,
+    iree_hal_buffer_view_t** out_buffer_view);
+
+// Deinitializes a buffer view initialized with iree_hal_buffer_view_initialize
+// and releases its buffer. All retains of the buffer view must have been
+// balanced with releases.
+IREE_API_EXPORT void iree_hal_buffer_view_deinitialize(
+    iree_hal_buffer_view_t* buffer_view);
+
 // Allocates a buffer from |allocator| and wraps it in a buffer view.
 // This is equivalent to:
 //   1. iree_hal_buffer_compute_view_size
@@ -327,6 +356,74 @@ IREE_API_EXPORT iree_status_t iree_hal_buffer_view_fprint(
     FILE* file, const iree_hal_buffer_view_t* buffer_view,
     iree_host_size_t max_element_count);
 
+// Statistics over the contents of a buffer view.
+typedef struct iree_hal_buffer_view_summary_t {
+  // Total number of elements in the buffer view.
+  iree_host_size_t element_count;
+  // Number of floating-point elements that are NaN. Always 0 for integers.
+  iree_host_size_t nan_count;
+  // Minimum and maximum of all non-NaN elements. Both are 0 if there are no
+  // such elements or the element type is not a supported numeric type.
+  double min_value;
+  double max_value;
+  // FNV-1a hash of the raw bytes of the buffer view contents.
+  uint64_t checksum;
+} iree_hal_buffer_view_summary_t;
+
+// Computes statistics over the elements of |buffer_view| in a single pass
+// over its contents. This is much cheaper than iree_hal_buffer_view_format
+// and performs no allocations so it is suitable for always-on diagnostics.
+// The buffer must be mappable for reading by the host.
+IREE_API_EXPORT iree_status_t iree_hal_buffer_view_summarize(
+    const iree_hal_buffer_view_t* buffer_view,
+    iree_hal_buffer_view_summary_t* out_summary);
+
+//===----------------------------------------------------------------------===//
+// iree_hal_buffer_view_pool_t
+//===----------------------------------------------------------------------===//
+
+// A thread-safe pool of buffer view storage used to avoid a heap allocation
+// per buffer view when many are created and released in a steady state (such
+// as for the results of each invocation). Buffer views with shapes of up to
+// iree_hal_buffer_view_pool_max_rank dimensions are allocated from fixed-size
+// blocks that are reused once released; larger ones fall back to the heap.
+//
+// Buffer views allocated from the pool retain it and may outlive all other
+// references to the pool.
+typedef struct iree_hal_buffer_view_pool_t iree_hal_buffer_view_pool_t;
+
+// Creates a buffer view pool that allocates its blocks from |host_allocator|.
+IREE_API_EXPORT iree_status_t iree_hal_buffer_view_pool_create(
+    iree_allocator_t host_allocator,
+    iree_hal_buffer_view_pool_t** out_buffer_view_pool);
+
+// Retains the given |buffer_view_pool| for the caller.
+IREE_API_EXPORT void iree_hal_buffer_view_pool_retain(
+    iree_hal_buffer_view_pool_t* buffer_view_pool);
+
+// Releases the given |buffer_view_pool| from the caller.
+IREE_API_EXPORT void iree_hal_buffer_view_pool_release(
+    iree_hal_buffer_view_pool_t* buffer_view_pool);
+
+// Returns the maximum shape rank of buffer views allocated from the pool.
+IREE_API_EXPORT iree_host_size_t iree_hal_buffer_view_pool_max_rank(
+    const iree_hal_buffer_view_pool_t* buffer_view_pool);
+
+// Frees all unused blocks retained by the pool.
+IREE_API_EXPORT void iree_hal_buffer_view_pool_trim(
+    iree_hal_buffer_view_pool_t* buffer_view_pool);
+
+// Creates a buffer view with the given |buffer| using storage from
+// |buffer_view_pool|. Behaves as iree_hal_buffer_view_create if the shape rank
+// exceeds iree_hal_buffer_view_pool_max_rank.
+// |out_buffer_view| must be released by the caller.
+IREE_API_EXPORT iree_status_t iree_hal_buffer_view_create_pooled(
+    iree_hal_buffer_view_pool_t* buffer_view_pool, iree_hal_buffer_t* buffer,
+    const iree_hal_dim_t* shape, iree_host_size_t shape_rank,
+    iree_hal_element_type_t element_type,
+    iree_hal_encoding_type_t encoding_type,
+    iree_hal_buffer_view_t** out_buffer_view);
+
 //===----------------------------------------------------------------------===//
 // iree_hal_buffer_view_t implementation details
 //===----------------------------------------------------------------------===//
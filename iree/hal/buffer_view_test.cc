@@ -0,0 +1,170 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+class BufferViewTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    IREE_ASSERT_OK(iree_hal_allocator_create_heap(
+        iree_make_cstring_view("heap"), iree_allocator_system(),
+        &allocator_));
+    IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+        allocator_,
+        IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE,
+        IREE_HAL_BUFFER_USAGE_ALL, 256, &buffer_));
+  }
+
+  void TearDown() override {
+    iree_hal_buffer_release(buffer_);
+    iree_hal_allocator_release(allocator_);
+  }
+
+  iree_hal_allocator_t* allocator_ = NULL;
+  iree_hal_buffer_t* buffer_ = NULL;
+};
+
+TEST_F(BufferViewTest, Initialize) {
+  const iree_hal_dim_t shape[] = {2, 4};
+  iree_hal_buffer_view_storage_t storage;
+  iree_hal_buffer_view_t* buffer_view = NULL;
+  IREE_ASSERT_OK(iree_hal_buffer_view_initialize(
+      buffer_, shape, IREE_ARRAYSIZE(shape), IREE_HAL_ELEMENT_TYPE_FLOAT_32,
+      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR, &storage, &buffer_view));
+  EXPECT_EQ((void*)&storage, (void*)buffer_view);
+  EXPECT_EQ(buffer_, iree_hal_buffer_view_buffer(buffer_view));
+  EXPECT_EQ(2, iree_hal_buffer_view_shape_rank(buffer_view));
+  EXPECT_EQ(4, iree_hal_buffer_view_shape_dim(buffer_view, 1));
+  EXPECT_EQ(2 * 4 * sizeof(float),
+            iree_hal_buffer_view_byte_length(buffer_view));
+  iree_hal_buffer_view_retain(buffer_view);
+  iree_hal_buffer_view_release(buffer_view);
+  iree_hal_buffer_view_deinitialize(buffer_view);
+}
+
+TEST_F(BufferViewTest, InitializeRankTooLarge) {
+  std::vector<iree_hal_dim_t> shape(IREE_HAL_BUFFER_VIEW_STORAGE_MAX_RANK + 1,
+                                    1);
+  iree_hal_buffer_view_storage_t storage;
+  iree_hal_buffer_view_t* buffer_view = NULL;
+  iree_status_t status = iree_hal_buffer_view_initialize(
+      buffer_, shape.data(), shape.size(), IREE_HAL_ELEMENT_TYPE_FLOAT_32,
+      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR, &storage, &buffer_view);
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_OUT_OF_RANGE, status);
+  iree_status_free(status);
+  EXPECT_EQ(nullptr, buffer_view);
+}
+
+TEST_F(BufferViewTest, PooledReusesStorage) {
+  iree_hal_buffer_view_pool_t* pool = NULL;
+  IREE_ASSERT_OK(
+      iree_hal_buffer_view_pool_create(iree_allocator_system(), &pool));
+  EXPECT_GE(iree_hal_buffer_view_pool_max_rank(pool),
+            IREE_HAL_BUFFER_VIEW_STORAGE_MAX_RANK);
+
+  const iree_hal_dim_t shape[] = {4, 4, 4};
+  iree_hal_buffer_view_t* buffer_view0 = NULL;
+  IREE_ASSERT_OK(iree_hal_buffer_view_create_pooled(
+      pool, buffer_, shape, IREE_ARRAYSIZE(shape),
+      IREE_HAL_ELEMENT_TYPE_FLOAT_32, IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR,
+      &buffer_view0));
+  EXPECT_EQ(3, iree_hal_buffer_view_shape_rank(buffer_view0));
+  void* storage0 = buffer_view0;
+  iree_hal_buffer_view_release(buffer_view0);
+
+  // The block released above is reused by the next buffer view.
+  iree_hal_buffer_view_t* buffer_view1 = NULL;
+  IREE_ASSERT_OK(iree_hal_buffer_view_create_pooled(
+      pool, buffer_, shape, 1, IREE_HAL_ELEMENT_TYPE_SINT_8,
+      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR, &buffer_view1));
+  EXPECT_EQ(storage0, (void*)buffer_view1);
+  EXPECT_EQ(1, iree_hal_buffer_view_shape_rank(buffer_view1));
+  EXPECT_EQ(4, iree_hal_buffer_view_byte_length(buffer_view1));
+
+  // Buffer views keep the pool alive.
+  iree_hal_buffer_view_pool_release(pool);
+  iree_hal_buffer_view_release(buffer_view1);
+}
+
+TEST_F(BufferViewTest, PooledRankTooLargeFallsBack) {
+  iree_hal_buffer_view_pool_t* pool = NULL;
+  IREE_ASSERT_OK(
+      iree_hal_buffer_view_pool_create(iree_allocator_system(), &pool));
+  std::vector<iree_hal_dim_t> shape(
+      iree_hal_buffer_view_pool_max_rank(pool) + 1, 1);
+  iree_hal_buffer_view_t* buffer_view = NULL;
+  IREE_ASSERT_OK(iree_hal_buffer_view_create_pooled(
+      pool, buffer_, shape.data(), shape.size(),
+      IREE_HAL_ELEMENT_TYPE_FLOAT_32, IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR,
+      &buffer_view));
+  EXPECT_EQ(shape.size(), iree_hal_buffer_view_shape_rank(buffer_view));
+  iree_hal_buffer_view_release(buffer_view);
+  iree_hal_buffer_view_pool_release(pool);
+}
+
+TEST_F(BufferViewTest, Summarize) {
+  const float values[] = {1.5f, -2.0f, NAN, 4.0f};
+  IREE_ASSERT_OK(
+      iree_hal_buffer_write_data(buffer_, 0, values, sizeof(values)));
+  const iree_hal_dim_t shape[] = {2, 2};
+  iree_hal_buffer_view_t* buffer_view = NULL;
+  IREE_ASSERT_OK(iree_hal_buffer_view_create(
+      buffer_, shape, IREE_ARRAYSIZE(shape), IREE_HAL_ELEMENT_TYPE_FLOAT_32,
+      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR, &buffer_view));
+
+  iree_hal_buffer_view_summary_t summary;
+  IREE_ASSERT_OK(iree_hal_buffer_view_summarize(buffer_view, &summary));
+  EXPECT_EQ(4, summary.element_count);
+  EXPECT_EQ(1, summary.nan_count);
+  EXPECT_EQ(-2.0, summary.min_value);
+  EXPECT_EQ(4.0, summary.max_value);
+
+  // The checksum only depends on the contents of the buffer view.
+  iree_hal_buffer_view_summary_t same_summary;
+  IREE_ASSERT_OK(iree_hal_buffer_view_summarize(buffer_view, &same_summary));
+  EXPECT_EQ(summary.checksum, same_summary.checksum);
+  const float changed_value = 3.0f;
+  IREE_ASSERT_OK(iree_hal_buffer_write_data(buffer_, sizeof(float),
+                                            &changed_value, sizeof(float)));
+  iree_hal_buffer_view_summary_t changed_summary;
+  IREE_ASSERT_OK(
+      iree_hal_buffer_view_summarize(buffer_view, &changed_summary));
+  EXPECT_NE(summary.checksum, changed_summary.checksum);
+  EXPECT_EQ(1.5, changed_summary.min_value);
+
+  iree_hal_buffer_view_release(buffer_view);
+}
+
+TEST_F(BufferViewTest, SummarizeIntegers) {
+  const int8_t values[] = {7, -3, 0, 5};
+  IREE_ASSERT_OK(
+      iree_hal_buffer_write_data(buffer_, 0, values, sizeof(values)));
+  const iree_hal_dim_t shape[] = {4};
+  iree_hal_buffer_view_t* buffer_view = NULL;
+  IREE_ASSERT_OK(iree_hal_buffer_view_create(
+      buffer_, shape, IREE_ARRAYSIZE(shape), IREE_HAL_ELEMENT_TYPE_SINT_8,
+      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR, &buffer_view));
+
+  iree_hal_buffer_view_summary_t summary;
+  IREE_ASSERT_OK(iree_hal_buffer_view_summarize(buffer_view, &summary));
+  EXPECT_EQ(4, summary.element_count);
+  EXPECT_EQ(0, summary.nan_count);
+  EXPECT_EQ(-3.0, summary.min_value);
+  EXPECT_EQ(7.0, summary.max_value);
+
+  iree_hal_buffer_view_release(buffer_view);
+}
+
+}  // namespace
@@ -292,3 +292,36 @@ IREE_API_EXPORT iree_status_t iree_hal_command_buffer_dispatch_indirect(
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
+
+IREE_API_EXPORT iree_status_t iree_hal_command_buffer_dispatch_push(
+    iree_hal_command_buffer_t* command_buffer,
+    iree_hal_executable_layout_t* executable_layout,
+    iree_hal_executable_t* executable, int32_t entry_point,
+    uint32_t workgroup_x, uint32_t workgroup_y, uint32_t workgroup_z,
+    iree_host_size_t constant_offset, iree_host_size_t constant_count,
+    const uint32_t* constants, uint32_t set, iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings) {
+  IREE_ASSERT_ARGUMENT(command_buffer);
+  IREE_ASSERT_ARGUMENT(executable_layout);
+  IREE_ASSERT_ARGUMENT(executable);
+  IREE_ASSERT_ARGUMENT(!constant_count || constants);
+  IREE_ASSERT_ARGUMENT(!binding_count || bindings);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_status_t status = iree_ok_status();
+  if (constant_count > 0) {
+    status = _VTABLE_DISPATCH(command_buffer, push_constants)(
+        command_buffer, executable_layout, constant_offset * sizeof(uint32_t),
+        constants, constant_count * sizeof(uint32_t));
+  }
+  if (iree_status_is_ok(status)) {
+    status = _VTABLE_DISPATCH(command_buffer, push_descriptor_set)(
+        command_buffer, executable_layout, set, binding_count, bindings);
+  }
+  if (iree_status_is_ok(status)) {
+    status = _VTABLE_DISPATCH(command_buffer, dispatch)(
+        command_buffer, executable, entry_point, workgroup_x, workgroup_y,
+        workgroup_z);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
@@ -469,6 +469,24 @@ IREE_API_EXPORT iree_status_t iree_hal_command_buffer_dispatch_indirect(
     iree_hal_executable_t* executable, int32_t entry_point,
     iree_hal_buffer_t* workgroups_buffer, iree_device_size_t workgroups_offset);
 
+// Pushes |constants| and a descriptor set of |bindings| and dispatches an
+// execution request. This is equivalent to
+// iree_hal_command_buffer_push_constants (when |constant_count| is non-zero)
+// and iree_hal_command_buffer_push_descriptor_set followed by
+// iree_hal_command_buffer_dispatch and lets callers such as the VM HAL module
+// record a dispatch with a single call. The pushed state remains bound for
+// subsequent dispatches as with the individual push commands.
+//
+// |constant_offset| is in 4-byte constant values.
+IREE_API_EXPORT iree_status_t iree_hal_command_buffer_dispatch_push(
+    iree_hal_command_buffer_t* command_buffer,
+    iree_hal_executable_layout_t* executable_layout,
+    iree_hal_executable_t* executable, int32_t entry_point,
+    uint32_t workgroup_x, uint32_t workgroup_y, uint32_t workgroup_z,
+    iree_host_size_t constant_offset, iree_host_size_t constant_count,
+    const uint32_t* constants, uint32_t set, iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings);
+
 //===----------------------------------------------------------------------===//
 // iree_hal_command_buffer_t validation wrapper
 //===----------------------------------------------------------------------===//
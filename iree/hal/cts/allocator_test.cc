@@ -115,6 +115,35 @@ TEST_P(AllocatorTest, AllocateEmptyBuffer) {
   iree_hal_buffer_release(buffer);
 }
 
+// Buffers allocated from the allocator are reflected in its statistics until
+// they are released.
+TEST_P(AllocatorTest, AllocateBufferUpdatesStatistics) {
+  iree_hal_allocator_statistics_t base_statistics;
+  iree_hal_allocator_query_statistics(device_allocator_, &base_statistics);
+
+  iree_hal_buffer_t* buffer;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      device_allocator_, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL,
+      IREE_HAL_BUFFER_USAGE_TRANSFER, kAllocationSize, &buffer));
+
+  iree_hal_allocator_statistics_t statistics;
+  iree_hal_allocator_query_statistics(device_allocator_, &statistics);
+  EXPECT_EQ(base_statistics.device_local.allocation_count + 1,
+            statistics.device_local.allocation_count);
+  EXPECT_GE(statistics.device_local.bytes_live,
+            base_statistics.device_local.bytes_live + kAllocationSize);
+  EXPECT_GE(statistics.device_local.bytes_peak,
+            statistics.device_local.bytes_live);
+
+  iree_hal_buffer_release(buffer);
+
+  iree_hal_allocator_query_statistics(device_allocator_, &statistics);
+  EXPECT_EQ(base_statistics.device_local.bytes_live,
+            statistics.device_local.bytes_live);
+  EXPECT_EQ(base_statistics.device_local.free_count + 1,
+            statistics.device_local.free_count);
+}
+
 INSTANTIATE_TEST_SUITE_P(
     AllDrivers, AllocatorTest,
     ::testing::ValuesIn(testing::EnumerateAvailableDrivers()),
@@ -33,6 +33,7 @@ class CommandBufferTest : public CtsTestBase {
   CommandBufferTest() {
     // TODO(#4680): command buffer recording so that this can run on sync HAL.
     SkipUnavailableDriver("dylib-sync");
+    SkipUnavailableDriver("dylib-inline-parallel");
   }
 
  protected:
@@ -248,6 +249,125 @@ TEST_P(CommandBufferTest, CopySubBuffer) {
   iree_hal_buffer_release(host_buffer);
 }
 
+TEST_P(CommandBufferTest, ExecutionBarrierOrdersDependentCommands) {
+  iree_hal_command_buffer_t* command_buffer;
+  IREE_ASSERT_OK(iree_hal_command_buffer_create(
+      device_, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT,
+      IREE_HAL_COMMAND_CATEGORY_TRANSFER, IREE_HAL_QUEUE_AFFINITY_ANY,
+      &command_buffer));
+
+  iree_hal_buffer_t* source_buffer;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      device_allocator_,
+      IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+      IREE_HAL_BUFFER_USAGE_ALL, kBufferSize, &source_buffer));
+  iree_hal_buffer_t* target_buffer;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      device_allocator_,
+      IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+      IREE_HAL_BUFFER_USAGE_ALL, kBufferSize, &target_buffer));
+
+  // Fill the two halves of the source buffer with independent commands
+  // separated by a barrier and then copy the whole buffer after another
+  // barrier. Implementations may overlap the fills but the copy must observe
+  // both of them.
+  IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer));
+  uint8_t val1 = 0x07;
+  IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+      command_buffer, source_buffer, /*target_offset=*/0,
+      /*length=*/kBufferSize / 2, /*pattern=*/&val1,
+      /*pattern_length=*/sizeof(val1)));
+  IREE_ASSERT_OK(iree_hal_command_buffer_execution_barrier(
+      command_buffer, IREE_HAL_EXECUTION_STAGE_TRANSFER,
+      IREE_HAL_EXECUTION_STAGE_TRANSFER, IREE_HAL_EXECUTION_BARRIER_FLAG_NONE,
+      /*memory_barrier_count=*/0, /*memory_barriers=*/NULL,
+      /*buffer_barrier_count=*/0, /*buffer_barriers=*/NULL));
+  uint8_t val2 = 0xbe;
+  IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+      command_buffer, source_buffer, /*target_offset=*/kBufferSize / 2,
+      /*length=*/kBufferSize / 2, /*pattern=*/&val2,
+      /*pattern_length=*/sizeof(val2)));
+  IREE_ASSERT_OK(iree_hal_command_buffer_execution_barrier(
+      command_buffer, IREE_HAL_EXECUTION_STAGE_TRANSFER,
+      IREE_HAL_EXECUTION_STAGE_TRANSFER, IREE_HAL_EXECUTION_BARRIER_FLAG_NONE,
+      /*memory_barrier_count=*/0, /*memory_barriers=*/NULL,
+      /*buffer_barrier_count=*/0, /*buffer_barriers=*/NULL));
+  IREE_ASSERT_OK(iree_hal_command_buffer_copy_buffer(
+      command_buffer, /*source_buffer=*/source_buffer, /*source_offset=*/0,
+      /*target_buffer=*/target_buffer, /*target_offset=*/0,
+      /*length=*/kBufferSize));
+  IREE_ASSERT_OK(iree_hal_command_buffer_end(command_buffer));
+
+  IREE_ASSERT_OK(SubmitCommandBufferAndWait(IREE_HAL_COMMAND_CATEGORY_TRANSFER,
+                                            command_buffer));
+
+  std::vector<uint8_t> reference_buffer(kBufferSize);
+  std::memset(reference_buffer.data(), val1, kBufferSize / 2);
+  std::memset(reference_buffer.data() + kBufferSize / 2, val2, kBufferSize / 2);
+  std::vector<uint8_t> actual_data(kBufferSize);
+  IREE_ASSERT_OK(iree_hal_buffer_read_data(target_buffer, /*source_offset=*/0,
+                                           /*target_buffer=*/actual_data.data(),
+                                           /*data_length=*/kBufferSize));
+  EXPECT_THAT(actual_data, ContainerEq(reference_buffer));
+
+  // Must release the command buffer before resources used by it.
+  iree_hal_command_buffer_release(command_buffer);
+  iree_hal_buffer_release(target_buffer);
+  iree_hal_buffer_release(source_buffer);
+}
+
+TEST_P(CommandBufferTest, SubmitReusableMultipleTimes) {
+  // Reusable command buffers are optional; drivers that only support one-shot
+  // recording are skipped.
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  iree_status_t status = iree_hal_command_buffer_create(
+      device_, /*mode=*/0,
+      IREE_HAL_COMMAND_CATEGORY_TRANSFER, IREE_HAL_QUEUE_AFFINITY_ANY,
+      &command_buffer);
+  if (iree_status_is_unimplemented(status)) {
+    iree_status_ignore(status);
+    GTEST_SKIP() << "reusable command buffers not supported";
+  }
+  IREE_ASSERT_OK(status);
+
+  iree_hal_buffer_t* device_buffer;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      device_allocator_,
+      IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+      IREE_HAL_BUFFER_USAGE_ALL, kBufferSize, &device_buffer));
+
+  IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer));
+  uint8_t val = 0x07;
+  IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+      command_buffer, device_buffer, /*target_offset=*/0,
+      /*length=*/kBufferSize, /*pattern=*/&val,
+      /*pattern_length=*/sizeof(val)));
+  IREE_ASSERT_OK(iree_hal_command_buffer_end(command_buffer));
+  std::vector<uint8_t> reference_buffer(kBufferSize);
+  std::memset(reference_buffer.data(), val, kBufferSize);
+
+  // Clear the buffer from the host between each submission so that we can
+  // verify the recorded commands execute again each time.
+  for (int i = 0; i < 3; ++i) {
+    uint8_t zero = 0;
+    IREE_ASSERT_OK(iree_hal_buffer_fill(device_buffer, /*byte_offset=*/0,
+                                        /*byte_length=*/kBufferSize, &zero,
+                                        /*pattern_length=*/sizeof(zero)));
+    IREE_ASSERT_OK(SubmitCommandBufferAndWait(
+        IREE_HAL_COMMAND_CATEGORY_TRANSFER, command_buffer));
+
+    std::vector<uint8_t> actual_data(kBufferSize);
+    IREE_ASSERT_OK(iree_hal_buffer_read_data(
+        device_buffer, /*source_offset=*/0,
+        /*target_buffer=*/actual_data.data(), /*data_length=*/kBufferSize));
+    EXPECT_THAT(actual_data, ContainerEq(reference_buffer));
+  }
+
+  // Must release the command buffer before resources used by it.
+  iree_hal_command_buffer_release(command_buffer);
+  iree_hal_buffer_release(device_buffer);
+}
+
 INSTANTIATE_TEST_SUITE_P(
     AllDrivers, CommandBufferTest,
     ::testing::ValuesIn(testing::EnumerateAvailableDrivers()),
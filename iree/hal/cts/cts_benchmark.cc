@@ -0,0 +1,382 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Performance counterpart to the CTS: measures the fixed overheads of common
+// HAL operations uniformly across all registered drivers so that drivers can be
+// compared on the same hardware. Each benchmark is registered once per driver
+// with a default device available as `BM_<operation>/<driver>`.
+//
+// NOTE: dispatch latency is measured with empty submissions as the CTS has no
+// executables that all drivers can load.
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "iree/base/api.h"
+#include "iree/base/internal/flags.h"
+#include "iree/base/logging.h"
+#include "iree/hal/api.h"
+#include "iree/hal/testing/driver_registry.h"
+
+namespace iree {
+namespace hal {
+namespace cts {
+namespace {
+
+// A driver and its default device shared by all benchmarks of the driver.
+struct DriverDevice {
+  std::string driver_name;
+  iree_hal_driver_t* driver = nullptr;
+  iree_hal_device_t* device = nullptr;
+};
+
+// Marks the benchmark as failed with the message of |status| and frees it.
+void SkipWithStatus(benchmark::State& state, iree_status_t status) {
+  std::string message = "<!>";
+  iree_host_size_t buffer_length = 0;
+  if (iree_status_format(status, /*buffer_capacity=*/0, /*buffer=*/NULL,
+                         &buffer_length)) {
+    message.assign(buffer_length, '\0');
+    if (!iree_status_format(status, message.size() + 1, &message[0],
+                            &buffer_length)) {
+      message = "<!>";
+    }
+  }
+  iree_status_ignore(status);
+  state.SkipWithError(message.c_str());
+}
+
+// Creates a one-shot command buffer recorded by |record_fn|.
+template <typename RecordFn>
+iree_status_t RecordCommandBuffer(
+    iree_hal_device_t* device, iree_hal_command_category_t categories,
+    RecordFn record_fn, iree_hal_command_buffer_t** out_command_buffer) {
+  *out_command_buffer = NULL;
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_command_buffer_create(
+      device, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT, categories,
+      IREE_HAL_QUEUE_AFFINITY_ANY, &command_buffer));
+  iree_status_t status = iree_hal_command_buffer_begin(command_buffer);
+  if (iree_status_is_ok(status)) {
+    status = record_fn(command_buffer);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_command_buffer_end(command_buffer);
+  }
+  if (iree_status_is_ok(status)) {
+    *out_command_buffer = command_buffer;
+  } else {
+    iree_hal_command_buffer_release(command_buffer);
+  }
+  return status;
+}
+
+// Returns true if the device can record command buffers for later submission.
+// Drivers that only support inline execution (such as dylib-sync) cannot and
+// the command buffer benchmarks are not registered for them.
+bool SupportsDeferredCommandBuffers(iree_hal_device_t* device) {
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  iree_status_t status = iree_hal_command_buffer_create(
+      device, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT,
+      IREE_HAL_COMMAND_CATEGORY_ANY, IREE_HAL_QUEUE_AFFINITY_ANY,
+      &command_buffer);
+  iree_hal_command_buffer_release(command_buffer);
+  if (iree_status_is_ok(status)) return true;
+  iree_status_ignore(status);
+  return false;
+}
+
+// Submits |command_buffer| (if any) signaling |semaphore| to |value| and waits
+// for it to be reached.
+iree_status_t SubmitAndWait(iree_hal_device_t* device,
+                            iree_hal_command_category_t categories,
+                            iree_hal_command_buffer_t* command_buffer,
+                            iree_hal_semaphore_t* semaphore, uint64_t value) {
+  iree_hal_submission_batch_t batch;
+  batch.wait_semaphores.count = 0;
+  batch.wait_semaphores.semaphores = NULL;
+  batch.wait_semaphores.payload_values = NULL;
+  batch.command_buffer_count = command_buffer ? 1 : 0;
+  batch.command_buffers = command_buffer ? &command_buffer : NULL;
+  batch.signal_semaphores.count = 1;
+  batch.signal_semaphores.semaphores = &semaphore;
+  batch.signal_semaphores.payload_values = &value;
+  IREE_RETURN_IF_ERROR(iree_hal_device_queue_submit(
+      device, categories, IREE_HAL_QUEUE_AFFINITY_ANY, 1, &batch));
+  return iree_hal_semaphore_wait(semaphore, value, iree_infinite_timeout());
+}
+
+// Latency of allocating and releasing a device-local buffer of state.range(0)
+// bytes.
+void BM_AllocateBuffer(benchmark::State& state, DriverDevice* driver_device) {
+  iree_hal_allocator_t* allocator =
+      iree_hal_device_allocator(driver_device->device);
+  iree_device_size_t allocation_size = (iree_device_size_t)state.range(0);
+  for (auto _ : state) {
+    iree_hal_buffer_t* buffer = NULL;
+    iree_status_t status = iree_hal_allocator_allocate_buffer(
+        allocator, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL,
+        IREE_HAL_BUFFER_USAGE_ALL, allocation_size, &buffer);
+    if (!iree_status_is_ok(status)) {
+      SkipWithStatus(state, status);
+      break;
+    }
+    iree_hal_buffer_release(buffer);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Cost of creating and recording a command buffer with state.range(0) small
+// fills (without submitting it).
+void BM_CommandBufferRecord(benchmark::State& state,
+                            DriverDevice* driver_device) {
+  iree_hal_buffer_t* buffer = NULL;
+  iree_status_t status = iree_hal_allocator_allocate_buffer(
+      iree_hal_device_allocator(driver_device->device),
+      IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL, IREE_HAL_BUFFER_USAGE_ALL, 4096,
+      &buffer);
+  if (!iree_status_is_ok(status)) {
+    SkipWithStatus(state, status);
+    return;
+  }
+  int64_t command_count = state.range(0);
+  for (auto _ : state) {
+    iree_hal_command_buffer_t* command_buffer = NULL;
+    status = RecordCommandBuffer(
+        driver_device->device, IREE_HAL_COMMAND_CATEGORY_TRANSFER,
+        [&](iree_hal_command_buffer_t* command_buffer) {
+          uint32_t pattern = 0;
+          for (int64_t i = 0; i < command_count; ++i) {
+            IREE_RETURN_IF_ERROR(iree_hal_command_buffer_fill_buffer(
+                command_buffer, buffer, /*target_offset=*/0, /*length=*/16,
+                &pattern, sizeof(pattern)));
+          }
+          return iree_ok_status();
+        },
+        &command_buffer);
+    if (!iree_status_is_ok(status)) {
+      SkipWithStatus(state, status);
+      break;
+    }
+    iree_hal_command_buffer_release(command_buffer);
+  }
+  state.SetItemsProcessed(state.iterations() * command_count);
+  iree_hal_buffer_release(buffer);
+}
+
+// Round-trip latency of recording, submitting, and waiting on an empty command
+// buffer. This is the floor on the latency of any dispatch.
+void BM_EmptySubmit(benchmark::State& state, DriverDevice* driver_device) {
+  iree_hal_semaphore_t* semaphore = NULL;
+  iree_status_t status =
+      iree_hal_semaphore_create(driver_device->device, 0ull, &semaphore);
+  if (!iree_status_is_ok(status)) {
+    SkipWithStatus(state, status);
+    return;
+  }
+  uint64_t value = 0ull;
+  for (auto _ : state) {
+    iree_hal_command_buffer_t* command_buffer = NULL;
+    status = RecordCommandBuffer(
+        driver_device->device, IREE_HAL_COMMAND_CATEGORY_DISPATCH,
+        [](iree_hal_command_buffer_t* command_buffer) {
+          return iree_ok_status();
+        },
+        &command_buffer);
+    if (iree_status_is_ok(status)) {
+      status = SubmitAndWait(driver_device->device,
+                             IREE_HAL_COMMAND_CATEGORY_DISPATCH,
+                             command_buffer, semaphore, ++value);
+    }
+    iree_hal_command_buffer_release(command_buffer);
+    if (!iree_status_is_ok(status)) {
+      SkipWithStatus(state, status);
+      break;
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+  iree_hal_semaphore_release(semaphore);
+}
+
+// Latency between a host signal of a semaphore and a waiting thread waking.
+// Each iteration is a round trip of a signal ping-pong between two threads and
+// as such includes two signal-to-wake latencies.
+void BM_SemaphoreSignalToWake(benchmark::State& state,
+                              DriverDevice* driver_device) {
+  iree_hal_semaphore_t* ping = NULL;
+  iree_hal_semaphore_t* pong = NULL;
+  iree_status_t status =
+      iree_hal_semaphore_create(driver_device->device, 0ull, &ping);
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_semaphore_create(driver_device->device, 0ull, &pong);
+  }
+  if (!iree_status_is_ok(status)) {
+    iree_hal_semaphore_release(ping);
+    SkipWithStatus(state, status);
+    return;
+  }
+  // The responder echoes every ping until it receives UINT64_MAX.
+  std::thread responder([&]() {
+    for (uint64_t value = 1;; ++value) {
+      IREE_CHECK_OK(
+          iree_hal_semaphore_wait(ping, value, iree_infinite_timeout()));
+      uint64_t current_value = 0;
+      IREE_CHECK_OK(iree_hal_semaphore_query(ping, &current_value));
+      if (current_value == UINT64_MAX) break;
+      IREE_CHECK_OK(iree_hal_semaphore_signal(pong, value));
+    }
+  });
+  uint64_t value = 0ull;
+  for (auto _ : state) {
+    status = iree_hal_semaphore_signal(ping, ++value);
+    if (iree_status_is_ok(status)) {
+      status = iree_hal_semaphore_wait(pong, value, iree_infinite_timeout());
+    }
+    if (!iree_status_is_ok(status)) {
+      SkipWithStatus(state, status);
+      break;
+    }
+  }
+  IREE_CHECK_OK(iree_hal_semaphore_signal(ping, UINT64_MAX));
+  responder.join();
+  iree_hal_semaphore_release(pong);
+  iree_hal_semaphore_release(ping);
+}
+
+// Bandwidth of device-local to device-local copies of state.range(0) bytes,
+// including submission overhead.
+void BM_CopyBandwidth(benchmark::State& state, DriverDevice* driver_device) {
+  iree_hal_allocator_t* allocator =
+      iree_hal_device_allocator(driver_device->device);
+  iree_device_size_t length = (iree_device_size_t)state.range(0);
+  iree_hal_buffer_t* source_buffer = NULL;
+  iree_hal_buffer_t* target_buffer = NULL;
+  iree_hal_semaphore_t* semaphore = NULL;
+  iree_status_t status = iree_hal_allocator_allocate_buffer(
+      allocator, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL, IREE_HAL_BUFFER_USAGE_ALL,
+      length, &source_buffer);
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_allocator_allocate_buffer(
+        allocator, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL,
+        IREE_HAL_BUFFER_USAGE_ALL, length, &target_buffer);
+  }
+  if (iree_status_is_ok(status)) {
+    status =
+        iree_hal_semaphore_create(driver_device->device, 0ull, &semaphore);
+  }
+  // No iterations run once the benchmark has been skipped.
+  if (!iree_status_is_ok(status)) SkipWithStatus(state, status);
+  uint64_t value = 0ull;
+  for (auto _ : state) {
+    iree_hal_command_buffer_t* command_buffer = NULL;
+    status = RecordCommandBuffer(
+        driver_device->device, IREE_HAL_COMMAND_CATEGORY_TRANSFER,
+        [&](iree_hal_command_buffer_t* command_buffer) {
+          return iree_hal_command_buffer_copy_buffer(
+              command_buffer, source_buffer, 0, target_buffer, 0, length);
+        },
+        &command_buffer);
+    if (iree_status_is_ok(status)) {
+      status = SubmitAndWait(driver_device->device,
+                             IREE_HAL_COMMAND_CATEGORY_TRANSFER,
+                             command_buffer, semaphore, ++value);
+    }
+    iree_hal_command_buffer_release(command_buffer);
+    if (!iree_status_is_ok(status)) {
+      SkipWithStatus(state, status);
+      break;
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+  iree_hal_semaphore_release(semaphore);
+  iree_hal_buffer_release(target_buffer);
+  iree_hal_buffer_release(source_buffer);
+}
+
+void RegisterDriverBenchmarks(DriverDevice* driver_device) {
+  auto name = [&](const char* benchmark_name) {
+    return std::string(benchmark_name) + "/" + driver_device->driver_name;
+  };
+  benchmark::RegisterBenchmark(name("BM_AllocateBuffer").c_str(),
+                               BM_AllocateBuffer, driver_device)
+      ->Arg(4 * 1024)
+      ->Arg(1024 * 1024)
+      ->Arg(64 * 1024 * 1024);
+  benchmark::RegisterBenchmark(name("BM_SemaphoreSignalToWake").c_str(),
+                               BM_SemaphoreSignalToWake, driver_device)
+      ->UseRealTime();
+  if (!SupportsDeferredCommandBuffers(driver_device->device)) {
+    IREE_LOG(WARNING) << "Skipping command buffer benchmarks for driver '"
+                      << driver_device->driver_name
+                      << "' as it only supports inline command buffers";
+    return;
+  }
+  benchmark::RegisterBenchmark(name("BM_CommandBufferRecord").c_str(),
+                               BM_CommandBufferRecord, driver_device)
+      ->Arg(1)
+      ->Arg(64);
+  benchmark::RegisterBenchmark(name("BM_EmptySubmit").c_str(), BM_EmptySubmit,
+                               driver_device)
+      ->UseRealTime();
+  benchmark::RegisterBenchmark(name("BM_CopyBandwidth").c_str(),
+                               BM_CopyBandwidth, driver_device)
+      ->Arg(64 * 1024)
+      ->Arg(16 * 1024 * 1024)
+      ->UseRealTime();
+}
+
+}  // namespace
+}  // namespace cts
+}  // namespace hal
+}  // namespace iree
+
+int main(int argc, char** argv) {
+  // Pass through flags to benchmark (allowing --help to fall through).
+  iree_flags_parse_checked(IREE_FLAGS_PARSE_MODE_UNDEFINED_OK |
+                               IREE_FLAGS_PARSE_MODE_CONTINUE_AFTER_HELP,
+                           &argc, &argv);
+  ::benchmark::Initialize(&argc, argv);
+
+  // Drivers (or their default devices) that are unavailable on this machine
+  // are skipped.
+  std::vector<iree::hal::cts::DriverDevice> driver_devices;
+  for (const auto& driver_name :
+       iree::hal::testing::EnumerateAvailableDrivers()) {
+    iree::hal::cts::DriverDevice driver_device;
+    driver_device.driver_name = driver_name;
+    iree_status_t status = iree_hal_driver_registry_try_create_by_name(
+        iree_hal_driver_registry_default(),
+        iree_make_string_view(driver_name.data(), driver_name.size()),
+        iree_allocator_system(), &driver_device.driver);
+    if (iree_status_is_ok(status)) {
+      status = iree_hal_driver_create_default_device(
+          driver_device.driver, iree_allocator_system(),
+          &driver_device.device);
+    }
+    if (iree_status_is_ok(status)) {
+      driver_devices.push_back(driver_device);
+    } else {
+      IREE_LOG(WARNING) << "Skipping driver '" << driver_name
+                        << "' as it is unavailable";
+      iree_status_ignore(status);
+      iree_hal_driver_release(driver_device.driver);
+    }
+  }
+  for (auto& driver_device : driver_devices) {
+    iree::hal::cts::RegisterDriverBenchmarks(&driver_device);
+  }
+
+  ::benchmark::RunSpecifiedBenchmarks();
+
+  for (auto& driver_device : driver_devices) {
+    iree_hal_device_release(driver_device.device);
+    iree_hal_driver_release(driver_device.driver);
+  }
+  return 0;
+}
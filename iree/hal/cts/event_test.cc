@@ -25,6 +25,7 @@ class EventTest : public CtsTestBase {
   EventTest() {
     // TODO(#4680): command buffer recording so that this can run on sync HAL.
     SkipUnavailableDriver("dylib-sync");
+    SkipUnavailableDriver("dylib-inline-parallel");
   }
 };
 
@@ -6,6 +6,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -27,6 +28,7 @@ class SemaphoreSubmissionTest : public CtsTestBase {
     SkipUnavailableDriver("cuda");
     // TODO(#4680): command buffer recording so that this can run on sync HAL.
     SkipUnavailableDriver("dylib-sync");
+    SkipUnavailableDriver("dylib-inline-parallel");
   }
 };
 
@@ -211,6 +213,65 @@ TEST_P(SemaphoreSubmissionTest, SubmitWithMultipleSemaphores) {
   iree_hal_semaphore_release(signal_semaphore_2);
 }
 
+// Batches in a single submit must not be delayed by the waits of the batches
+// that follow them. Here the second batch waits on a semaphore that the host
+// only signals after observing the signal of the first batch.
+TEST_P(SemaphoreSubmissionTest, SubmitBatchesWithIndependentWaits) {
+  iree_hal_command_buffer_t* command_buffer;
+  IREE_ASSERT_OK(iree_hal_command_buffer_create(
+      device_, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT,
+      IREE_HAL_COMMAND_CATEGORY_DISPATCH, IREE_HAL_QUEUE_AFFINITY_ANY,
+      &command_buffer));
+  IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer));
+  IREE_ASSERT_OK(iree_hal_command_buffer_end(command_buffer));
+
+  iree_hal_semaphore_t* signal_semaphore_1;
+  iree_hal_semaphore_t* wait_semaphore_2;
+  iree_hal_semaphore_t* signal_semaphore_2;
+  IREE_ASSERT_OK(iree_hal_semaphore_create(device_, 0ull, &signal_semaphore_1));
+  IREE_ASSERT_OK(iree_hal_semaphore_create(device_, 0ull, &wait_semaphore_2));
+  IREE_ASSERT_OK(iree_hal_semaphore_create(device_, 0ull, &signal_semaphore_2));
+  uint64_t payload_values[] = {1ull};
+
+  iree_hal_submission_batch_t submission_batches[2];
+  memset(submission_batches, 0, sizeof(submission_batches));
+  submission_batches[0].command_buffer_count = 1;
+  submission_batches[0].command_buffers = &command_buffer;
+  submission_batches[0].signal_semaphores.count = 1;
+  submission_batches[0].signal_semaphores.semaphores = &signal_semaphore_1;
+  submission_batches[0].signal_semaphores.payload_values = payload_values;
+  submission_batches[1].wait_semaphores.count = 1;
+  submission_batches[1].wait_semaphores.semaphores = &wait_semaphore_2;
+  submission_batches[1].wait_semaphores.payload_values = payload_values;
+  submission_batches[1].command_buffer_count = 1;
+  submission_batches[1].command_buffers = &command_buffer;
+  submission_batches[1].signal_semaphores.count = 1;
+  submission_batches[1].signal_semaphores.semaphores = &signal_semaphore_2;
+  submission_batches[1].signal_semaphores.payload_values = payload_values;
+
+  IREE_ASSERT_OK(iree_hal_device_queue_submit(
+      device_, IREE_HAL_COMMAND_CATEGORY_DISPATCH,
+      /*queue_affinity=*/0, IREE_ARRAYSIZE(submission_batches),
+      submission_batches));
+
+  // The first batch has no waits and must complete on its own.
+  IREE_ASSERT_OK(iree_hal_semaphore_wait(signal_semaphore_1, 1ull,
+                                         iree_infinite_timeout()));
+  uint64_t value = 0;
+  IREE_ASSERT_OK(iree_hal_semaphore_query(signal_semaphore_2, &value));
+  EXPECT_EQ(0ull, value);
+
+  // Only now release the second batch.
+  IREE_ASSERT_OK(iree_hal_semaphore_signal(wait_semaphore_2, 1ull));
+  IREE_ASSERT_OK(iree_hal_semaphore_wait(signal_semaphore_2, 1ull,
+                                         iree_infinite_timeout()));
+
+  iree_hal_command_buffer_release(command_buffer);
+  iree_hal_semaphore_release(signal_semaphore_1);
+  iree_hal_semaphore_release(wait_semaphore_2);
+  iree_hal_semaphore_release(signal_semaphore_2);
+}
+
 INSTANTIATE_TEST_SUITE_P(
     AllDrivers, SemaphoreSubmissionTest,
     ::testing::ValuesIn(testing::EnumerateAvailableDrivers()),
@@ -31,12 +31,95 @@ typedef struct iree_hal_cuda_device_params_t {
 
   // Switch for using deferred command buffer or default graph command buffer
   bool use_deferred_submission;
+
+  // Optimizes deferred command buffers when recording ends by dropping unused
+  // pushes, clustering dispatches, coalescing transfers, and merging barriers.
+  // Only used with |use_deferred_submission|. Disabled by default so that the
+  // exact sequence of recorded commands is replayed.
+  bool optimize_deferred_command_buffers;
+
+  // Maximum total size in bytes of released device-local allocations that the
+  // device allocator retains for reuse. Retained blocks are reused in stream
+  // order by later allocations of a similar size instead of being returned to
+  // the driver with a synchronizing cuMemFree. 0 disables caching.
+  iree_device_size_t allocator_max_cached_size;
+
+  // Maximum number of idle CUDA graph executables retained by the device for
+  // reuse. Graph command buffers recording the same topology as a retained
+  // executable update it in place with cuGraphExecUpdate instead of
+  // instantiating a new one. 0 disables reuse across command buffers.
+  iree_host_size_t graph_exec_cache_capacity;
+
+  // Issues transfer-only submissions on a dedicated stream so that uploads and
+  // readbacks can overlap with dispatches on the compute stream. Ordering
+  // between the streams is only established by semaphores.
+  bool use_transfer_stream;
+
+  // Resolves semaphore waits between submissions on the device with stream
+  // memory operations (cuStreamWaitValue64/cuStreamWriteValue64) when the
+  // device supports them. Waits may then be enqueued before the value they
+  // wait on has been signaled by any submission, without blocking the host.
+  bool use_device_timeline_semaphores;
+
+  // Batches consecutive small dispatches into single launches of persistent
+  // kernels that pull workgroups from a list of work items, removing the
+  // per-dispatch launch overhead. Requires executables compiled with
+  // -iree-cuda-persistent-kernels; others are launched per dispatch. Only used
+  // with |use_deferred_submission|.
+  bool use_persistent_kernels;
+
+  // Dispatches with at most this many workgroups are batched when
+  // |use_persistent_kernels| is set. Larger dispatches amortize their launch
+  // and are issued individually so that they get a full grid.
+  uint32_t persistent_kernel_max_workgroup_count;
 } iree_hal_cuda_device_params_t;
 
 // Initializes |out_params| to default values.
 void iree_hal_cuda_device_params_initialize(
     iree_hal_cuda_device_params_t* out_params);
 
+//===----------------------------------------------------------------------===//
+// iree_hal_cuda_allocator_t
+//===----------------------------------------------------------------------===//
+
+// Aggregate statistics of a CUDA device allocator.
+typedef struct iree_hal_cuda_allocator_statistics_t {
+  // Total bytes of device memory backing live buffers.
+  iree_device_size_t live_size;
+  // Total bytes of device memory retained for reuse by the allocator.
+  iree_device_size_t cached_size;
+  // Peak total bytes of device memory held by the allocator (live and cached).
+  iree_device_size_t peak_size;
+  // Total number of buffers allocated.
+  uint64_t allocation_count;
+  // Number of allocations that reused a retained block.
+  uint64_t cache_hit_count;
+  // Number of allocations and frees made with the driver.
+  uint64_t driver_allocation_count;
+  uint64_t driver_free_count;
+  // Number of host memory imports that reused an existing registration.
+  uint64_t host_registration_hit_count;
+  // Number of host memory ranges registered with the driver.
+  uint64_t host_registration_count;
+} iree_hal_cuda_allocator_statistics_t;
+
+// Queries the aggregate statistics of a CUDA device |allocator|.
+// Fails if the allocator is not a CUDA allocator.
+IREE_API_EXPORT iree_status_t iree_hal_cuda_allocator_query_statistics(
+    iree_hal_allocator_t* allocator,
+    iree_hal_cuda_allocator_statistics_t* out_statistics);
+
+// Returns all device memory retained by a CUDA device |allocator| to the
+// driver and unregisters any imported host memory that is no longer wrapped by
+// a live buffer. Live buffers are unaffected. No-op if not a CUDA allocator.
+//
+// Host memory imported with iree_hal_allocator_wrap_buffer remains registered
+// with the driver after the buffers wrapping it are released so that wrapping
+// the same memory again is cheap. Callers retaining ownership of imported
+// memory must trim the allocator (or release the device) prior to freeing it.
+IREE_API_EXPORT void iree_hal_cuda_allocator_trim(
+    iree_hal_allocator_t* allocator);
+
 //===----------------------------------------------------------------------===//
 // iree_hal_cuda_driver_t
 //===----------------------------------------------------------------------===//
@@ -7,16 +7,105 @@
 #include "iree/hal/cuda/cuda_allocator.h"
 
 #include <stddef.h>
+#include <stdint.h>
+#include <string.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/math.h"
+#include "iree/base/internal/synchronization.h"
 #include "iree/base/tracing.h"
+#include "iree/hal/cuda/api.h"
 #include "iree/hal/cuda/cuda_buffer.h"
 #include "iree/hal/cuda/dynamic_symbols.h"
 #include "iree/hal/cuda/status_util.h"
 
+// log2 of the smallest device block size. Smaller requests are rounded up.
+#define IREE_HAL_CUDA_ALLOCATOR_MIN_BLOCK_SIZE_LOG2 9
+
+// Each power-of-two range of block sizes is split into this many bins so that
+// rounding up to a bin wastes at most 1/4 of the block.
+#define IREE_HAL_CUDA_ALLOCATOR_BINS_PER_POW2_LOG2 2
+#define IREE_HAL_CUDA_ALLOCATOR_BINS_PER_POW2 \
+  (1 << IREE_HAL_CUDA_ALLOCATOR_BINS_PER_POW2_LOG2)
+
+// Total number of bins, covering blocks from 512B up to 64GB. Larger
+// allocations are never cached.
+#define IREE_HAL_CUDA_ALLOCATOR_BIN_COUNT \
+  ((36 - IREE_HAL_CUDA_ALLOCATOR_MIN_BLOCK_SIZE_LOG2) * \
+   IREE_HAL_CUDA_ALLOCATOR_BINS_PER_POW2)
+
+// A device memory block retained for reuse. Device memory is not host
+// accessible so the free list nodes live in host memory.
+typedef struct iree_hal_cuda_cached_block_t {
+  struct iree_hal_cuda_cached_block_t* next;
+  CUdeviceptr device_ptr;
+} iree_hal_cuda_cached_block_t;
+
+// Required alignment of host memory imported into the device address space.
+#define IREE_HAL_CUDA_ALLOCATOR_HOST_REGISTRATION_ALIGNMENT 4096
+
+// Maximum number of imported host memory ranges that remain registered with
+// the driver while not wrapped by any live buffer. Once exceeded the least
+// recently used range is unregistered.
+#define IREE_HAL_CUDA_ALLOCATOR_MAX_IDLE_HOST_REGISTRATIONS 16
+
+// A range of caller-owned host memory registered with the driver and mapped
+// into the device address space.
+typedef struct iree_hal_cuda_host_registration_t {
+  struct iree_hal_cuda_host_registration_t* next;
+  uint8_t* host_ptr;
+  iree_host_size_t length;
+  CUdeviceptr device_ptr;
+  // Number of live buffers wrapping memory within the range.
+  uint32_t ref_count;
+  // True if a wrapping buffer owns the memory and will free it when released
+  // in which case the registration must not outlive its last reference.
+  bool owned;
+} iree_hal_cuda_host_registration_t;
+
 typedef struct iree_hal_cuda_allocator_t {
   iree_hal_resource_t resource;
   iree_hal_cuda_context_wrapper_t* context;
+
+  // Stream that all device work using buffers from the allocator is issued on.
+  // Blocks released while still in use by pending work on the stream can be
+  // handed out again immediately as any work using the new buffer will be
+  // ordered after the work using the old one.
+  CUstream stream;
+
+  // Optional secondary stream that work using buffers may be issued on.
+  // Released blocks may still be in use by work on either stream so each
+  // release orders |stream| after the pending work on |transfer_stream| and
+  // records |release_event| on |stream| that |transfer_stream| waits on prior
+  // to issuing new work.
+  CUstream transfer_stream;
+  CUevent release_event;
+
+  // Maximum total bytes of released blocks retained in the bins.
+  iree_device_size_t max_cached_size;
+
+  // True if the driver supports stream-ordered allocation and it is used for
+  // all device-local blocks. Cleared if the first attempt reports that the
+  // device does not support it so all blocks are always allocated the same
+  // way and can be freed the same way.
+  bool use_stream_ordered_allocation;
+
+  // Guards all state below.
+  iree_slim_mutex_t mutex;
+  // LIFO free lists of retained blocks, one per bin.
+  iree_hal_cuda_cached_block_t* bins[IREE_HAL_CUDA_ALLOCATOR_BIN_COUNT];
+  // Unused free list nodes.
+  iree_hal_cuda_cached_block_t* node_pool;
+  // Registered host memory ranges in most recently used order.
+  iree_hal_cuda_host_registration_t* host_registrations;
+  // Number of host_registrations with no references.
+  iree_host_size_t idle_host_registration_count;
+  // Incremented each time |release_event| is recorded.
+  uint64_t release_epoch;
+  // Value of |release_epoch| the last time |transfer_stream| was ordered.
+  uint64_t transfer_ordered_epoch;
+  iree_hal_cuda_allocator_statistics_t statistics;
+  iree_hal_allocator_statistics_t memory_statistics;
 } iree_hal_cuda_allocator_t;
 
 extern const iree_hal_allocator_vtable_t iree_hal_cuda_allocator_vtable;
@@ -28,10 +117,19 @@ static iree_hal_cuda_allocator_t* iree_hal_cuda_allocator_cast(
 }
 
 iree_status_t iree_hal_cuda_allocator_create(
-    iree_hal_cuda_context_wrapper_t* context,
+    iree_hal_cuda_context_wrapper_t* context, CUstream stream,
+    CUstream transfer_stream, iree_device_size_t max_cached_size,
     iree_hal_allocator_t** out_allocator) {
   IREE_ASSERT_ARGUMENT(context);
   IREE_TRACE_ZONE_BEGIN(z0);
+  CUevent release_event = NULL;
+  if (transfer_stream) {
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, CU_RESULT_TO_STATUS(
+                context->syms,
+                cuEventCreate(&release_event, CU_EVENT_DISABLE_TIMING),
+                "cuEventCreate"));
+  }
   iree_hal_cuda_allocator_t* allocator = NULL;
   iree_status_t status = iree_allocator_malloc(
       context->host_allocator, sizeof(*allocator), (void**)&allocator);
@@ -39,13 +137,399 @@ iree_status_t iree_hal_cuda_allocator_create(
     iree_hal_resource_initialize(&iree_hal_cuda_allocator_vtable,
                                  &allocator->resource);
     allocator->context = context;
+    allocator->stream = stream;
+    allocator->transfer_stream = transfer_stream;
+    allocator->release_event = release_event;
+    allocator->release_epoch = 0;
+    allocator->transfer_ordered_epoch = 0;
+    allocator->max_cached_size = max_cached_size;
+    allocator->use_stream_ordered_allocation =
+        context->syms->cuMemAllocAsync && context->syms->cuMemFreeAsync;
+    iree_slim_mutex_initialize(&allocator->mutex);
+    memset(allocator->bins, 0, sizeof(allocator->bins));
+    allocator->node_pool = NULL;
+    allocator->host_registrations = NULL;
+    allocator->idle_host_registration_count = 0;
+    memset(&allocator->statistics, 0, sizeof(allocator->statistics));
+    memset(&allocator->memory_statistics, 0,
+           sizeof(allocator->memory_statistics));
     *out_allocator = (iree_hal_allocator_t*)allocator;
+  } else if (release_event) {
+    CUDA_IGNORE_ERROR(context->syms, cuEventDestroy(release_event));
   }
 
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
 
+// Orders |stream| after work pending on |transfer_stream| and records the
+// release event that |transfer_stream| must wait on before issuing new work.
+// Must be called with the lock held prior to caching or freeing a block.
+static void iree_hal_cuda_allocator_order_release(
+    iree_hal_cuda_allocator_t* allocator) {
+  if (!allocator->transfer_stream) return;
+  iree_hal_cuda_dynamic_symbols_t* syms = allocator->context->syms;
+  CUDA_IGNORE_ERROR(syms, cuEventRecord(allocator->release_event,
+                                        allocator->transfer_stream));
+  CUDA_IGNORE_ERROR(syms, cuStreamWaitEvent(allocator->stream,
+                                            allocator->release_event,
+                                            /*flags=*/0));
+  CUDA_IGNORE_ERROR(
+      syms, cuEventRecord(allocator->release_event, allocator->stream));
+  ++allocator->release_epoch;
+}
+
+iree_status_t iree_hal_cuda_allocator_order_stream(
+    iree_hal_allocator_t* base_allocator, CUstream stream) {
+  iree_hal_cuda_allocator_t* allocator =
+      iree_hal_cuda_allocator_cast(base_allocator);
+  // Work on the primary stream is always ordered after releases.
+  if (stream != allocator->transfer_stream) return iree_ok_status();
+  iree_status_t status = iree_ok_status();
+  iree_slim_mutex_lock(&allocator->mutex);
+  if (allocator->transfer_ordered_epoch != allocator->release_epoch) {
+    status = CU_RESULT_TO_STATUS(
+        allocator->context->syms,
+        cuStreamWaitEvent(stream, allocator->release_event, /*flags=*/0),
+        "cuStreamWaitEvent");
+    if (iree_status_is_ok(status)) {
+      allocator->transfer_ordered_epoch = allocator->release_epoch;
+    }
+  }
+  iree_slim_mutex_unlock(&allocator->mutex);
+  return status;
+}
+
+// Returns the bin that device-local blocks for |allocation_size| bytes are
+// allocated from and the size of the blocks in the bin or -1 if the size is
+// larger than any bin.
+static int iree_hal_cuda_allocator_select_bin(
+    iree_device_size_t allocation_size, iree_device_size_t* out_block_size) {
+  uint64_t size = iree_max(
+      allocation_size, 1ull << IREE_HAL_CUDA_ALLOCATOR_MIN_BLOCK_SIZE_LOG2);
+  int size_log2 = 63 - iree_math_count_leading_zeros_u64(size);
+  uint64_t step = (1ull << size_log2) >>
+                  IREE_HAL_CUDA_ALLOCATOR_BINS_PER_POW2_LOG2;
+  uint64_t block_size = (size + step - 1) & ~(step - 1);
+  // NOTE: block_size may have rounded up to the next power of two in which
+  // case the sub-bin index overflows into the first bin of the next range.
+  int bin = (size_log2 - IREE_HAL_CUDA_ALLOCATOR_MIN_BLOCK_SIZE_LOG2) *
+                IREE_HAL_CUDA_ALLOCATOR_BINS_PER_POW2 +
+            (int)(block_size / step) - IREE_HAL_CUDA_ALLOCATOR_BINS_PER_POW2;
+  *out_block_size = (iree_device_size_t)block_size;
+  return bin < IREE_HAL_CUDA_ALLOCATOR_BIN_COUNT ? bin : -1;
+}
+
+// Tracks |block_size| bytes becoming live. Must be called with the lock held.
+static void iree_hal_cuda_allocator_note_live(
+    iree_hal_cuda_allocator_t* allocator, iree_device_size_t block_size) {
+  iree_hal_cuda_allocator_statistics_t* statistics = &allocator->statistics;
+  statistics->live_size += block_size;
+  statistics->peak_size =
+      iree_max(statistics->peak_size,
+               statistics->live_size + statistics->cached_size);
+}
+
+// Allocates a device-local block from the driver.
+static iree_status_t iree_hal_cuda_allocator_allocate_device_block(
+    iree_hal_cuda_allocator_t* allocator, iree_device_size_t block_size,
+    CUdeviceptr* out_device_ptr) {
+  iree_hal_cuda_dynamic_symbols_t* syms = allocator->context->syms;
+  if (allocator->use_stream_ordered_allocation) {
+    CUresult result =
+        syms->cuMemAllocAsync(out_device_ptr, block_size, allocator->stream);
+    if (result != CUDA_ERROR_NOT_SUPPORTED) {
+      return iree_hal_cuda_result_to_status(syms, result, __FILE__, __LINE__);
+    }
+    // The driver has the entry point but the device doesn't support memory
+    // pools; nothing has been allocated with it yet so switch over for good.
+    allocator->use_stream_ordered_allocation = false;
+  }
+  return CU_RESULT_TO_STATUS(syms, cuMemAlloc(out_device_ptr, block_size));
+}
+
+// Returns a device-local block to the driver.
+static void iree_hal_cuda_allocator_free_device_block(
+    iree_hal_cuda_allocator_t* allocator, CUdeviceptr device_ptr) {
+  iree_hal_cuda_dynamic_symbols_t* syms = allocator->context->syms;
+  if (allocator->use_stream_ordered_allocation) {
+    CUDA_IGNORE_ERROR(syms, cuMemFreeAsync(device_ptr, allocator->stream));
+  } else {
+    CUDA_IGNORE_ERROR(syms, cuMemFree(device_ptr));
+  }
+}
+
+// Acquires a device-local block for |allocation_size| bytes either from the
+// bins or the driver.
+static iree_status_t iree_hal_cuda_allocator_acquire_device_block(
+    iree_hal_cuda_allocator_t* allocator, iree_device_size_t allocation_size,
+    CUdeviceptr* out_device_ptr) {
+  iree_device_size_t block_size = 0;
+  int bin = iree_hal_cuda_allocator_select_bin(allocation_size, &block_size);
+  if (bin < 0) block_size = allocation_size;
+
+  iree_slim_mutex_lock(&allocator->mutex);
+  ++allocator->statistics.allocation_count;
+  if (bin >= 0 && allocator->bins[bin]) {
+    iree_hal_cuda_cached_block_t* block = allocator->bins[bin];
+    allocator->bins[bin] = block->next;
+    block->next = allocator->node_pool;
+    allocator->node_pool = block;
+    *out_device_ptr = block->device_ptr;
+    ++allocator->statistics.cache_hit_count;
+    allocator->statistics.cached_size -= block_size;
+    iree_hal_cuda_allocator_note_live(allocator, block_size);
+    iree_slim_mutex_unlock(&allocator->mutex);
+    return iree_ok_status();
+  }
+
+  // Miss: allocate under the lock so that the stream-ordered allocation mode
+  // can be switched safely. Driver allocations are the slow path anyway.
+  iree_status_t status = iree_hal_cuda_allocator_allocate_device_block(
+      allocator, block_size, out_device_ptr);
+  if (!iree_status_is_ok(status) && allocator->statistics.cached_size) {
+    // Out of memory (or otherwise failing): give back everything we are
+    // holding on to and try once more.
+    iree_slim_mutex_unlock(&allocator->mutex);
+    iree_status_ignore(status);
+    iree_hal_cuda_allocator_trim((iree_hal_allocator_t*)allocator);
+    iree_slim_mutex_lock(&allocator->mutex);
+    status = iree_hal_cuda_allocator_allocate_device_block(
+        allocator, block_size, out_device_ptr);
+  }
+  if (iree_status_is_ok(status)) {
+    ++allocator->statistics.driver_allocation_count;
+    iree_hal_cuda_allocator_note_live(allocator, block_size);
+  }
+  iree_slim_mutex_unlock(&allocator->mutex);
+  return status;
+}
+
+// Releases a device-local block for |allocation_size| bytes either to the bins
+// for reuse or to the driver.
+static void iree_hal_cuda_allocator_release_device_block(
+    iree_hal_cuda_allocator_t* allocator, CUdeviceptr device_ptr,
+    iree_device_size_t allocation_size) {
+  iree_device_size_t block_size = 0;
+  int bin = iree_hal_cuda_allocator_select_bin(allocation_size, &block_size);
+  if (bin < 0) block_size = allocation_size;
+
+  iree_slim_mutex_lock(&allocator->mutex);
+  allocator->statistics.live_size -= block_size;
+  iree_hal_cuda_allocator_order_release(allocator);
+  if (bin >= 0 && allocator->statistics.cached_size + block_size <=
+                      allocator->max_cached_size) {
+    iree_hal_cuda_cached_block_t* block = allocator->node_pool;
+    if (block) {
+      allocator->node_pool = block->next;
+    } else if (!iree_status_is_ok(iree_allocator_malloc(
+                   allocator->context->host_allocator, sizeof(*block),
+                   (void**)&block))) {
+      block = NULL;
+    }
+    if (block) {
+      block->device_ptr = device_ptr;
+      block->next = allocator->bins[bin];
+      allocator->bins[bin] = block;
+      allocator->statistics.cached_size += block_size;
+      iree_slim_mutex_unlock(&allocator->mutex);
+      return;
+    }
+  }
+  ++allocator->statistics.driver_free_count;
+  iree_hal_cuda_allocator_free_device_block(allocator, device_ptr);
+  iree_slim_mutex_unlock(&allocator->mutex);
+}
+
+// Unregisters and frees |registration| after it has been unlinked from the
+// registration list. Must be called with the lock held.
+static void iree_hal_cuda_allocator_unregister_host_memory(
+    iree_hal_cuda_allocator_t* allocator,
+    iree_hal_cuda_host_registration_t* registration) {
+  CUDA_IGNORE_ERROR(allocator->context->syms,
+                    cuMemHostUnregister(registration->host_ptr));
+  iree_allocator_free(allocator->context->host_allocator, registration);
+}
+
+// Unregisters all idle host memory registrations overlapping the range
+// [|range_begin|, |range_end|). Must be called with the lock held.
+static void iree_hal_cuda_allocator_evict_host_registrations(
+    iree_hal_cuda_allocator_t* allocator, const uint8_t* range_begin,
+    const uint8_t* range_end) {
+  iree_hal_cuda_host_registration_t** link = &allocator->host_registrations;
+  while (*link) {
+    iree_hal_cuda_host_registration_t* registration = *link;
+    if (registration->ref_count == 0 && registration->host_ptr < range_end &&
+        registration->host_ptr + registration->length > range_begin) {
+      *link = registration->next;
+      --allocator->idle_host_registration_count;
+      iree_hal_cuda_allocator_unregister_host_memory(allocator, registration);
+    } else {
+      link = &registration->next;
+    }
+  }
+}
+
+// Maps |data| into the device address space, reusing an existing registration
+// if one covers the whole range.
+static iree_status_t iree_hal_cuda_allocator_import_host_memory(
+    iree_hal_cuda_allocator_t* allocator, iree_byte_span_t data, bool owned,
+    CUdeviceptr* out_device_ptr) {
+  iree_slim_mutex_lock(&allocator->mutex);
+
+  // Look for a registration containing the range and move it to the front.
+  iree_hal_cuda_host_registration_t** link = &allocator->host_registrations;
+  for (; *link; link = &(*link)->next) {
+    iree_hal_cuda_host_registration_t* registration = *link;
+    if (data.data >= registration->host_ptr &&
+        data.data + data.data_length <=
+            registration->host_ptr + registration->length) {
+      *link = registration->next;
+      registration->next = allocator->host_registrations;
+      allocator->host_registrations = registration;
+      if (registration->ref_count++ == 0) {
+        --allocator->idle_host_registration_count;
+      }
+      registration->owned |= owned;
+      ++allocator->statistics.host_registration_hit_count;
+      *out_device_ptr =
+          registration->device_ptr + (data.data - registration->host_ptr);
+      iree_slim_mutex_unlock(&allocator->mutex);
+      return iree_ok_status();
+    }
+  }
+
+  // The driver rejects registrations overlapping existing ones; drop any that
+  // are idle (such as when an I/O buffer has been reallocated larger).
+  iree_hal_cuda_allocator_evict_host_registrations(
+      allocator, data.data, data.data + data.data_length);
+
+  iree_hal_cuda_dynamic_symbols_t* syms = allocator->context->syms;
+  iree_hal_cuda_host_registration_t* registration = NULL;
+  iree_status_t status =
+      iree_allocator_malloc(allocator->context->host_allocator,
+                            sizeof(*registration), (void**)&registration);
+  if (iree_status_is_ok(status)) {
+    status = CU_RESULT_TO_STATUS(
+        syms, cuMemHostRegister(data.data, data.data_length,
+                                CU_MEMHOSTREGISTER_DEVICEMAP));
+    if (!iree_status_is_ok(status)) {
+      iree_allocator_free(allocator->context->host_allocator, registration);
+      registration = NULL;
+    }
+  }
+  if (iree_status_is_ok(status)) {
+    registration->host_ptr = data.data;
+    registration->length = data.data_length;
+    registration->ref_count = 1;
+    registration->owned = owned;
+    status = CU_RESULT_TO_STATUS(
+        syms, cuMemHostGetDevicePointer(&registration->device_ptr, data.data,
+                                        /*flags=*/0));
+    if (iree_status_is_ok(status)) {
+      registration->next = allocator->host_registrations;
+      allocator->host_registrations = registration;
+      ++allocator->statistics.host_registration_count;
+      *out_device_ptr = registration->device_ptr;
+    } else {
+      iree_hal_cuda_allocator_unregister_host_memory(allocator, registration);
+    }
+  }
+
+  iree_slim_mutex_unlock(&allocator->mutex);
+  return status;
+}
+
+// Releases a reference to the registration containing |host_ptr|, if any.
+// Returns false if the memory was not imported.
+static bool iree_hal_cuda_allocator_release_host_memory(
+    iree_hal_cuda_allocator_t* allocator, void* host_ptr) {
+  bool found = false;
+  iree_slim_mutex_lock(&allocator->mutex);
+  iree_hal_cuda_host_registration_t** link = &allocator->host_registrations;
+  for (; *link; link = &(*link)->next) {
+    iree_hal_cuda_host_registration_t* registration = *link;
+    if (registration->ref_count == 0 ||
+        (uint8_t*)host_ptr < registration->host_ptr ||
+        (uint8_t*)host_ptr >= registration->host_ptr + registration->length) {
+      continue;
+    }
+    found = true;
+    if (--registration->ref_count > 0) break;
+    if (registration->owned) {
+      // The memory is about to be freed by the buffer.
+      *link = registration->next;
+      iree_hal_cuda_allocator_unregister_host_memory(allocator, registration);
+      break;
+    }
+    if (++allocator->idle_host_registration_count >
+        IREE_HAL_CUDA_ALLOCATOR_MAX_IDLE_HOST_REGISTRATIONS) {
+      // Evict the least recently used idle registration.
+      iree_hal_cuda_host_registration_t** lru_link = NULL;
+      for (link = &allocator->host_registrations; *link;
+           link = &(*link)->next) {
+        if ((*link)->ref_count == 0) lru_link = link;
+      }
+      iree_hal_cuda_host_registration_t* lru = *lru_link;
+      *lru_link = lru->next;
+      --allocator->idle_host_registration_count;
+      iree_hal_cuda_allocator_unregister_host_memory(allocator, lru);
+    }
+    break;
+  }
+  iree_slim_mutex_unlock(&allocator->mutex);
+  return found;
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_cuda_allocator_query_statistics(
+    iree_hal_allocator_t* base_allocator,
+    iree_hal_cuda_allocator_statistics_t* out_statistics) {
+  IREE_ASSERT_ARGUMENT(base_allocator);
+  IREE_ASSERT_ARGUMENT(out_statistics);
+  memset(out_statistics, 0, sizeof(*out_statistics));
+  if (!iree_hal_resource_is(base_allocator, &iree_hal_cuda_allocator_vtable)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "allocator is not a CUDA allocator");
+  }
+  iree_hal_cuda_allocator_t* allocator =
+      iree_hal_cuda_allocator_cast(base_allocator);
+  iree_slim_mutex_lock(&allocator->mutex);
+  *out_statistics = allocator->statistics;
+  iree_slim_mutex_unlock(&allocator->mutex);
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT void iree_hal_cuda_allocator_trim(
+    iree_hal_allocator_t* base_allocator) {
+  IREE_ASSERT_ARGUMENT(base_allocator);
+  if (!iree_hal_resource_is(base_allocator, &iree_hal_cuda_allocator_vtable)) {
+    return;
+  }
+  iree_hal_cuda_allocator_t* allocator =
+      iree_hal_cuda_allocator_cast(base_allocator);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_slim_mutex_lock(&allocator->mutex);
+  for (int i = 0; i < IREE_HAL_CUDA_ALLOCATOR_BIN_COUNT; ++i) {
+    iree_hal_cuda_cached_block_t* block = allocator->bins[i];
+    while (block) {
+      iree_hal_cuda_cached_block_t* next = block->next;
+      iree_hal_cuda_allocator_free_device_block(allocator, block->device_ptr);
+      ++allocator->statistics.driver_free_count;
+      block->next = allocator->node_pool;
+      allocator->node_pool = block;
+      block = next;
+    }
+    allocator->bins[i] = NULL;
+  }
+  allocator->statistics.cached_size = 0;
+  iree_hal_cuda_allocator_evict_host_registrations(
+      allocator, (const uint8_t*)0, (const uint8_t*)UINTPTR_MAX);
+  iree_slim_mutex_unlock(&allocator->mutex);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
 static void iree_hal_cuda_allocator_destroy(
     iree_hal_allocator_t* base_allocator) {
   iree_hal_cuda_allocator_t* allocator =
@@ -53,6 +537,24 @@ static void iree_hal_cuda_allocator_destroy(
   iree_allocator_t host_allocator = allocator->context->host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  iree_hal_cuda_allocator_trim(base_allocator);
+  iree_hal_cuda_cached_block_t* node = allocator->node_pool;
+  while (node) {
+    iree_hal_cuda_cached_block_t* next = node->next;
+    iree_allocator_free(host_allocator, node);
+    node = next;
+  }
+  if (allocator->use_stream_ordered_allocation) {
+    // Ensure all stream-ordered frees have completed before the stream goes
+    // away with the device.
+    CUDA_IGNORE_ERROR(allocator->context->syms,
+                      cuStreamSynchronize(allocator->stream));
+  }
+  if (allocator->release_event) {
+    CUDA_IGNORE_ERROR(allocator->context->syms,
+                      cuEventDestroy(allocator->release_event));
+  }
+  iree_slim_mutex_deinitialize(&allocator->mutex);
   iree_allocator_free(host_allocator, allocator);
 
   IREE_TRACE_ZONE_END(z0);
@@ -95,6 +597,29 @@ iree_hal_cuda_allocator_query_buffer_compatibility(
   return compatibility;
 }
 
+// Frees memory allocated by the allocator or releases imported host memory.
+// Returns true if the memory was allocated by the allocator.
+static bool iree_hal_cuda_allocator_free_memory(
+    iree_hal_cuda_allocator_t* allocator, CUdeviceptr device_ptr,
+    void* host_ptr, iree_hal_memory_type_t memory_type,
+    iree_device_size_t allocation_size) {
+  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL)) {
+    if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_HOST_VISIBLE)) {
+      CUDA_IGNORE_ERROR(allocator->context->syms, cuMemFree(device_ptr));
+    } else if (device_ptr) {
+      iree_hal_cuda_allocator_release_device_block(allocator, device_ptr,
+                                                   allocation_size);
+    }
+  } else if (!iree_hal_cuda_allocator_release_host_memory(allocator,
+                                                          host_ptr)) {
+    // Host local.
+    CUDA_IGNORE_ERROR(allocator->context->syms, cuMemFreeHost(host_ptr));
+  } else {
+    return false;
+  }
+  return true;
+}
+
 static iree_status_t iree_hal_cuda_allocator_allocate_buffer(
     iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
     iree_hal_buffer_usage_t allowed_usage, iree_host_size_t allocation_size,
@@ -117,9 +642,10 @@ static iree_status_t iree_hal_cuda_allocator_allocate_buffer(
                                                 CU_MEM_ATTACH_GLOBAL));
       host_ptr = (void*)device_ptr;
     } else {
-      // Device only.
-      status = CU_RESULT_TO_STATUS(allocator->context->syms,
-                                   cuMemAlloc(&device_ptr, allocation_size));
+      // Device only; never host accessible so blocks can be recycled in
+      // stream order.
+      status = iree_hal_cuda_allocator_acquire_device_block(
+          allocator, allocation_size, &device_ptr);
     }
   } else {
     unsigned int flags = CU_MEMHOSTALLOC_DEVICEMAP;
@@ -140,25 +666,35 @@ static iree_status_t iree_hal_cuda_allocator_allocate_buffer(
         (iree_hal_allocator_t*)allocator, memory_type,
         IREE_HAL_MEMORY_ACCESS_ALL, allowed_usage, allocation_size,
         /*byte_offset=*/0,
-        /*byte_length=*/allocation_size, device_ptr, host_ptr, out_buffer);
+        /*byte_length=*/allocation_size, device_ptr, host_ptr,
+        /*data_allocator=*/iree_allocator_null(), out_buffer);
   }
-  if (!iree_status_is_ok(status)) {
-    iree_hal_cuda_allocator_free(base_allocator, device_ptr, host_ptr,
-                                 memory_type);
+  if (iree_status_is_ok(status)) {
+    iree_slim_mutex_lock(&allocator->mutex);
+    iree_hal_allocator_statistics_record_alloc(&allocator->memory_statistics,
+                                               memory_type, allocation_size,
+                                               (void*)device_ptr);
+    iree_slim_mutex_unlock(&allocator->mutex);
+  } else {
+    iree_hal_cuda_allocator_free_memory(allocator, device_ptr, host_ptr,
+                                        memory_type, allocation_size);
   }
   return status;
 }
 
 void iree_hal_cuda_allocator_free(iree_hal_allocator_t* base_allocator,
                                   CUdeviceptr device_ptr, void* host_ptr,
-                                  iree_hal_memory_type_t memory_type) {
+                                  iree_hal_memory_type_t memory_type,
+                                  iree_device_size_t allocation_size) {
   iree_hal_cuda_allocator_t* allocator =
       iree_hal_cuda_allocator_cast(base_allocator);
-  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL)) {
-    CUDA_IGNORE_ERROR(allocator->context->syms, cuMemFree(device_ptr));
-  } else {
-    // Host local.
-    CUDA_IGNORE_ERROR(allocator->context->syms, cuMemFreeHost(host_ptr));
+  if (iree_hal_cuda_allocator_free_memory(allocator, device_ptr, host_ptr,
+                                          memory_type, allocation_size)) {
+    iree_slim_mutex_lock(&allocator->mutex);
+    iree_hal_allocator_statistics_record_free(&allocator->memory_statistics,
+                                              memory_type, allocation_size,
+                                              (void*)device_ptr);
+    iree_slim_mutex_unlock(&allocator->mutex);
   }
 }
 
@@ -167,8 +703,62 @@ static iree_status_t iree_hal_cuda_allocator_wrap_buffer(
     iree_hal_memory_access_t allowed_access,
     iree_hal_buffer_usage_t allowed_usage, iree_byte_span_t data,
     iree_allocator_t data_allocator, iree_hal_buffer_t** out_buffer) {
-  return iree_make_status(IREE_STATUS_UNAVAILABLE,
-                          "wrapping of external buffers not supported");
+  iree_hal_cuda_allocator_t* allocator =
+      iree_hal_cuda_allocator_cast(base_allocator);
+
+  // Only host memory can be imported; it is mapped into the device address
+  // space in-place and accessed by the device over the bus.
+  if (iree_any_bit_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL)) {
+    return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                            "wrapping of device-local buffers not supported");
+  }
+  if (!data.data_length ||
+      ((uintptr_t)data.data &
+       (IREE_HAL_CUDA_ALLOCATOR_HOST_REGISTRATION_ALIGNMENT - 1)) != 0) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "imported host memory must be non-empty and aligned to %d bytes",
+        IREE_HAL_CUDA_ALLOCATOR_HOST_REGISTRATION_ALIGNMENT);
+  }
+  memory_type |= IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  CUdeviceptr device_ptr = 0;
+  iree_status_t status = iree_hal_cuda_allocator_import_host_memory(
+      allocator, data, /*owned=*/!iree_allocator_is_null(data_allocator),
+      &device_ptr);
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_cuda_buffer_wrap(
+        base_allocator, memory_type, allowed_access, allowed_usage,
+        data.data_length, /*byte_offset=*/0,
+        /*byte_length=*/data.data_length, device_ptr, data.data,
+        data_allocator, out_buffer);
+    if (!iree_status_is_ok(status)) {
+      iree_hal_cuda_allocator_release_host_memory(allocator, data.data);
+    }
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_cuda_allocator_query_memory_statistics(
+    iree_hal_allocator_t* base_allocator,
+    iree_hal_allocator_statistics_t* out_statistics) {
+  iree_hal_cuda_allocator_t* allocator =
+      iree_hal_cuda_allocator_cast(base_allocator);
+  iree_slim_mutex_lock(&allocator->mutex);
+  *out_statistics = allocator->memory_statistics;
+  iree_slim_mutex_unlock(&allocator->mutex);
+}
+
+static void iree_hal_cuda_allocator_reset_peak_memory_statistics(
+    iree_hal_allocator_t* base_allocator) {
+  iree_hal_cuda_allocator_t* allocator =
+      iree_hal_cuda_allocator_cast(base_allocator);
+  iree_slim_mutex_lock(&allocator->mutex);
+  iree_hal_allocator_statistics_reset_peak(&allocator->memory_statistics);
+  iree_slim_mutex_unlock(&allocator->mutex);
 }
 
 const iree_hal_allocator_vtable_t iree_hal_cuda_allocator_vtable = {
@@ -178,4 +768,7 @@ const iree_hal_allocator_vtable_t iree_hal_cuda_allocator_vtable = {
         iree_hal_cuda_allocator_query_buffer_compatibility,
     .allocate_buffer = iree_hal_cuda_allocator_allocate_buffer,
     .wrap_buffer = iree_hal_cuda_allocator_wrap_buffer,
+    .query_statistics = iree_hal_cuda_allocator_query_memory_statistics,
+    .reset_peak_statistics =
+        iree_hal_cuda_allocator_reset_peak_memory_statistics,
 };
@@ -17,14 +17,31 @@ extern "C" {
 #endif  // __cplusplus
 
 // Create a cuda allocator.
+// Device-local allocations are made in stream order on |stream| when the
+// driver supports it and up to |max_cached_size| bytes of released
+// device-local allocations are retained for reuse by work on |stream|.
+//
+// If |transfer_stream| is provided then work using buffers from the allocator
+// may also be issued on it and releases are ordered across both streams; any
+// work issued on |transfer_stream| must be preceded by a call to
+// iree_hal_cuda_allocator_order_stream.
 iree_status_t iree_hal_cuda_allocator_create(
-    iree_hal_cuda_context_wrapper_t* context,
+    iree_hal_cuda_context_wrapper_t* context, CUstream stream,
+    CUstream transfer_stream, iree_device_size_t max_cached_size,
     iree_hal_allocator_t** out_allocator);
 
-// Free an allocation represent by the given device or host pointer.
+// Orders |stream| after all blocks released since the last call so that any
+// reused memory is not written while prior work on another stream may still
+// be reading it. Must be called before issuing work on |stream|.
+iree_status_t iree_hal_cuda_allocator_order_stream(
+    iree_hal_allocator_t* allocator, CUstream stream);
+
+// Free an allocation of |allocation_size| bytes represented by the given device
+// or host pointer.
 void iree_hal_cuda_allocator_free(iree_hal_allocator_t* allocator,
                                   CUdeviceptr device_ptr, void* host_ptr,
-                                  iree_hal_memory_type_t memory_type);
+                                  iree_hal_memory_type_t memory_type,
+                                  iree_device_size_t allocation_size);
 
 #ifdef __cplusplus
 }  // extern "C"
@@ -18,6 +18,7 @@ typedef struct iree_hal_cuda_buffer_t {
   iree_hal_buffer_t base;
   void* host_ptr;
   CUdeviceptr device_ptr;
+  iree_allocator_t data_allocator;
 } iree_hal_cuda_buffer_t;
 
 extern const iree_hal_buffer_vtable_t iree_hal_cuda_buffer_vtable;
@@ -33,7 +34,8 @@ iree_status_t iree_hal_cuda_buffer_wrap(
     iree_hal_memory_access_t allowed_access,
     iree_hal_buffer_usage_t allowed_usage, iree_device_size_t allocation_size,
     iree_device_size_t byte_offset, iree_device_size_t byte_length,
-    CUdeviceptr device_ptr, void* host_ptr, iree_hal_buffer_t** out_buffer) {
+    CUdeviceptr device_ptr, void* host_ptr, iree_allocator_t data_allocator,
+    iree_hal_buffer_t** out_buffer) {
   IREE_ASSERT_ARGUMENT(allocator);
   IREE_ASSERT_ARGUMENT(out_buffer);
   IREE_TRACE_ZONE_BEGIN(z0);
@@ -55,6 +57,7 @@ iree_status_t iree_hal_cuda_buffer_wrap(
     buffer->base.allowed_usage = allowed_usage;
     buffer->host_ptr = host_ptr;
     buffer->device_ptr = device_ptr;
+    buffer->data_allocator = data_allocator;
     *out_buffer = &buffer->base;
   }
 
@@ -69,7 +72,9 @@ static void iree_hal_cuda_buffer_destroy(iree_hal_buffer_t* base_buffer) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
   iree_hal_cuda_allocator_free(buffer->base.allocator, buffer->device_ptr,
-                               buffer->host_ptr, buffer->base.memory_type);
+                               buffer->host_ptr, buffer->base.memory_type,
+                               buffer->base.allocation_size);
+  iree_allocator_free(buffer->data_allocator, buffer->host_ptr);
   iree_allocator_free(host_allocator, buffer);
 
   IREE_TRACE_ZONE_END(z0);
@@ -16,12 +16,15 @@ extern "C" {
 #endif  // __cplusplus
 
 // Wraps a cuda allocation in an iree_hal_buffer_t.
+// If |data_allocator| is not null it will be used to free |host_ptr| after the
+// allocation has been released back to |allocator|.
 iree_status_t iree_hal_cuda_buffer_wrap(
     iree_hal_allocator_t* allocator, iree_hal_memory_type_t memory_type,
     iree_hal_memory_access_t allowed_access,
     iree_hal_buffer_usage_t allowed_usage, iree_device_size_t allocation_size,
     iree_device_size_t byte_offset, iree_device_size_t byte_length,
-    CUdeviceptr device_ptr, void* host_ptr, iree_hal_buffer_t** out_buffer);
+    CUdeviceptr device_ptr, void* host_ptr, iree_allocator_t data_allocator,
+    iree_hal_buffer_t** out_buffer);
 
 // Returns the cuda base pointer for the given |buffer|.
 // This is the entire allocated_buffer and must be offset by the buffer
@@ -11,6 +11,9 @@
 #include <string.h>
 
 #include "iree/base/internal/arena.h"
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/internal/threading.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/cuda/context_wrapper.h"
 #include "iree/hal/cuda/cuda_allocator.h"
@@ -20,15 +23,33 @@
 #include "iree/hal/cuda/event_semaphore.h"
 #include "iree/hal/cuda/executable_layout.h"
 #include "iree/hal/cuda/graph_command_buffer.h"
+#include "iree/hal/cuda/native_executable.h"
 #include "iree/hal/cuda/nop_executable_cache.h"
+#include "iree/hal/cuda/profiling.h"
 #include "iree/hal/cuda/status_util.h"
 #include "iree/hal/cuda/stream_command_buffer.h"
+#include "iree/hal/cuda/timeline_pool.h"
 #include "iree/hal/utils/deferred_command_buffer.h"
 
 //===----------------------------------------------------------------------===//
 // iree_hal_cuda_device_t
 //===----------------------------------------------------------------------===//
 
+// A submission batch with a wait that cannot yet be enqueued on a stream as
+// no device work signals the value it waits on. Retains the semaphores and
+// command buffers of the batch.
+typedef struct iree_hal_cuda_deferred_submission_t {
+  struct iree_hal_cuda_deferred_submission_t* next;
+  iree_hal_command_category_t command_categories;
+  CUstream stream;
+  iree_hal_submission_batch_t batch;
+  // Index of the first wait of |batch| not yet known to be enqueueable.
+  iree_host_size_t wait_index;
+  // Registered with the semaphore of |wait_index| to wake the deferred thread
+  // once the wait can be enqueued.
+  iree_hal_cuda_semaphore_waiter_t waiter;
+} iree_hal_cuda_deferred_submission_t;
+
 typedef struct iree_hal_cuda_device_t {
   iree_hal_resource_t resource;
   iree_string_view_t identifier;
@@ -43,13 +64,51 @@ typedef struct iree_hal_cuda_device_t {
 
   CUdevice device;
 
-  // TODO: support multiple streams.
+  // Stream that dispatches and mixed submissions are issued on.
   CUstream stream;
+  // Optional stream that transfer-only submissions are issued on so that they
+  // may overlap with work on |stream|. NULL if not enabled.
+  CUstream transfer_stream;
   iree_hal_cuda_context_wrapper_t context_wrapper;
   iree_hal_allocator_t* device_allocator;
 
+  // Idle graph executables available for reuse by graph command buffers.
+  iree_hal_cuda_graph_exec_cache_t graph_exec_cache;
+
   // Switch for using deferred command buffer or default graph command buffer
   bool use_deferred_submission;
+  // Flags used when creating deferred command buffers.
+  iree_hal_deferred_command_buffer_flags_t deferred_command_buffer_flags;
+
+  // Dispatch profiling context used when replaying deferred command buffers.
+  // NULL if deferred submission is not used as graph command buffers cannot
+  // be instrumented after recording.
+  iree_hal_cuda_profiling_context_t* profiling_context;
+
+  // Pool device timeline semaphore payloads are suballocated from. NULL if
+  // semaphores do not use device timelines backed by stream memory operations
+  // or the device does not support them.
+  iree_hal_cuda_timeline_pool_t* timeline_pool;
+
+  // Options for batching dispatches into persistent kernel launches when
+  // replaying deferred command buffers. |counters| is 0 if not enabled.
+  iree_hal_cuda_persistent_dispatch_options_t persistent_options;
+
+  // Guards issuing work to the streams and the deferred submission queue.
+  iree_slim_mutex_t submit_mutex;
+  // Submissions waiting on values that no device work signals yet (such as
+  // values signaled from the host) in submission order. Later submissions
+  // queue behind them so that streams receive work in submission order.
+  iree_hal_cuda_deferred_submission_t* deferred_head;
+  iree_hal_cuda_deferred_submission_t* deferred_tail;
+  // Thread issuing deferred submissions as their waits become enqueueable.
+  // Created when the first submission is deferred.
+  iree_thread_t* deferred_thread;
+  // Set when the deferred thread should check the queue or exit.
+  iree_atomic_int32_t deferred_wake;
+  iree_atomic_int32_t deferred_exit;
+  // Posted when the deferred thread is woken and when the queue drains.
+  iree_notification_t deferred_notification;
 } iree_hal_cuda_device_t;
 
 extern const iree_hal_device_vtable_t iree_hal_cuda_device_vtable;
@@ -65,6 +124,13 @@ void iree_hal_cuda_device_params_initialize(
   out_params->arena_block_size = 32 * 1024;
   out_params->queue_count = 8;
   out_params->use_deferred_submission = false;
+  out_params->optimize_deferred_command_buffers = false;
+  out_params->allocator_max_cached_size = 512 * 1024 * 1024;
+  out_params->graph_exec_cache_capacity = 16;
+  out_params->use_transfer_stream = true;
+  out_params->use_device_timeline_semaphores = true;
+  out_params->use_persistent_kernels = false;
+  out_params->persistent_kernel_max_workgroup_count = 256;
 }
 
 static iree_status_t iree_hal_cuda_device_check_params(
@@ -80,15 +146,62 @@ static iree_status_t iree_hal_cuda_device_check_params(
   return iree_ok_status();
 }
 
+static void iree_hal_cuda_device_free_deferred_submission(
+    iree_hal_cuda_device_t* device,
+    iree_hal_cuda_deferred_submission_t* submission);
+static void iree_hal_cuda_device_fail_batch(
+    const iree_hal_submission_batch_t* batch, iree_status_t status);
+
 static void iree_hal_cuda_device_destroy(iree_hal_device_t* base_device) {
   iree_hal_cuda_device_t* device = iree_hal_cuda_device_cast(base_device);
   iree_allocator_t host_allocator = iree_hal_device_host_allocator(base_device);
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  if (device->deferred_thread) {
+    iree_atomic_store_int32(&device->deferred_exit, 1,
+                            iree_memory_order_release);
+    iree_notification_post(&device->deferred_notification, IREE_ALL_WAITERS);
+    // Joins the thread.
+    iree_thread_release(device->deferred_thread);
+  }
+  // Submissions still deferred can no longer be issued.
+  while (device->deferred_head) {
+    iree_hal_cuda_deferred_submission_t* submission = device->deferred_head;
+    device->deferred_head = submission->next;
+    if (submission->wait_index < submission->batch.wait_semaphores.count) {
+      iree_hal_cuda_semaphore_remove_waiter(
+          submission->batch.wait_semaphores.semaphores[submission->wait_index],
+          &submission->waiter);
+    }
+    iree_hal_cuda_device_fail_batch(
+        &submission->batch,
+        iree_make_status(IREE_STATUS_CANCELLED,
+                         "device destroyed with deferred submissions"));
+    iree_hal_cuda_device_free_deferred_submission(device, submission);
+  }
+  iree_notification_deinitialize(&device->deferred_notification);
+  iree_slim_mutex_deinitialize(&device->submit_mutex);
+
+  // There should be no more command buffers live that use the cache.
+  iree_hal_cuda_graph_exec_cache_deinitialize(&device->graph_exec_cache);
+
+  iree_hal_cuda_profiling_context_free(device->profiling_context);
+
+  if (device->persistent_options.counters) {
+    CUDA_IGNORE_ERROR(device->context_wrapper.syms,
+                      cuMemFree(device->persistent_options.counters));
+  }
+
   // There should be no more buffers live that use the allocator.
   iree_hal_allocator_release(device->device_allocator);
   CUDA_IGNORE_ERROR(device->context_wrapper.syms,
                     cuStreamDestroy(device->stream));
+  if (device->transfer_stream) {
+    CUDA_IGNORE_ERROR(device->context_wrapper.syms,
+                      cuStreamDestroy(device->transfer_stream));
+  }
+  // There should be no more semaphores live that use the pool.
+  iree_hal_cuda_timeline_pool_free(device->timeline_pool);
 
   iree_arena_block_pool_deinitialize(&device->block_pool);
   // Finally, destroy the device.
@@ -99,11 +212,40 @@ static void iree_hal_cuda_device_destroy(iree_hal_device_t* base_device) {
   IREE_TRACE_ZONE_END(z0);
 }
 
+// Blocks of a persistent kernel launch per multiprocessor. Enough to hide
+// latency for the small blocks of tiny dispatches while keeping all blocks
+// resident so that workgroups are claimed without delay.
+#define IREE_HAL_CUDA_PERSISTENT_BLOCKS_PER_MULTIPROCESSOR 4
+
+static iree_status_t iree_hal_cuda_device_initialize_persistent_options(
+    iree_hal_cuda_device_t* device, const iree_hal_cuda_device_params_t* params,
+    iree_hal_cuda_persistent_dispatch_options_t* out_options) {
+  int multiprocessor_count = 0;
+  CUDA_RETURN_IF_ERROR(
+      device->context_wrapper.syms,
+      cuDeviceGetAttribute(&multiprocessor_count,
+                           CU_DEVICE_ATTRIBUTE_MULTIPROCESSOR_COUNT,
+                           device->device),
+      "cuDeviceGetAttribute");
+  out_options->max_workgroup_count =
+      params->persistent_kernel_max_workgroup_count;
+  out_options->max_grid_size =
+      iree_max(1, multiprocessor_count) *
+      IREE_HAL_CUDA_PERSISTENT_BLOCKS_PER_MULTIPROCESSOR;
+  CUDA_RETURN_IF_ERROR(
+      device->context_wrapper.syms,
+      cuMemAlloc(&out_options->counters,
+                 IREE_HAL_CUDA_PERSISTENT_COUNTER_COUNT * sizeof(uint32_t)),
+      "cuMemAlloc");
+  return iree_ok_status();
+}
+
 static iree_status_t iree_hal_cuda_device_create_internal(
     iree_hal_driver_t* driver, iree_string_view_t identifier,
     const iree_hal_cuda_device_params_t* params, CUdevice cu_device,
-    CUstream stream, CUcontext context, iree_hal_cuda_dynamic_symbols_t* syms,
-    iree_allocator_t host_allocator, iree_hal_device_t** out_device) {
+    CUstream stream, CUstream transfer_stream, CUcontext context,
+    iree_hal_cuda_dynamic_symbols_t* syms, iree_allocator_t host_allocator,
+    iree_hal_device_t** out_device) {
   iree_hal_cuda_device_t* device = NULL;
   iree_host_size_t total_size = iree_sizeof_struct(*device) + identifier.size;
   IREE_RETURN_IF_ERROR(
@@ -117,14 +259,39 @@ static iree_status_t iree_hal_cuda_device_create_internal(
       (char*)device + iree_sizeof_struct(*device));
   device->device = cu_device;
   device->stream = stream;
+  device->transfer_stream = transfer_stream;
   device->context_wrapper.cu_context = context;
   device->context_wrapper.host_allocator = host_allocator;
+  iree_slim_mutex_initialize(&device->submit_mutex);
+  iree_notification_initialize(&device->deferred_notification);
   iree_arena_block_pool_initialize(params->arena_block_size, host_allocator,
                                    &device->block_pool);
   device->context_wrapper.syms = syms;
+  iree_hal_cuda_graph_exec_cache_initialize(&device->context_wrapper,
+                                            params->graph_exec_cache_capacity,
+                                            &device->graph_exec_cache);
   device->use_deferred_submission = params->use_deferred_submission;
+  device->deferred_command_buffer_flags =
+      params->optimize_deferred_command_buffers
+          ? IREE_HAL_DEFERRED_COMMAND_BUFFER_FLAG_OPTIMIZE
+          : IREE_HAL_DEFERRED_COMMAND_BUFFER_FLAG_NONE;
   iree_status_t status = iree_hal_cuda_allocator_create(
-      &device->context_wrapper, &device->device_allocator);
+      &device->context_wrapper, device->stream, device->transfer_stream,
+      params->allocator_max_cached_size, &device->device_allocator);
+  if (iree_status_is_ok(status) && params->use_device_timeline_semaphores &&
+      iree_hal_cuda_semaphore_is_device_timeline_supported(syms, cu_device)) {
+    status = iree_hal_cuda_timeline_pool_allocate(&device->context_wrapper,
+                                                  &device->timeline_pool);
+  }
+  if (iree_status_is_ok(status) && device->use_deferred_submission) {
+    status = iree_hal_cuda_profiling_context_allocate(
+        &device->context_wrapper, &device->profiling_context);
+  }
+  if (iree_status_is_ok(status) && device->use_deferred_submission &&
+      params->use_persistent_kernels) {
+    status = iree_hal_cuda_device_initialize_persistent_options(
+        device, params, &device->persistent_options);
+  }
   if (iree_status_is_ok(status)) {
     *out_device = (iree_hal_device_t*)device;
   } else {
@@ -145,16 +312,24 @@ iree_status_t iree_hal_cuda_device_create(
   CUcontext context;
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
       z0, CU_RESULT_TO_STATUS(syms, cuCtxCreate(&context, 0, device)));
-  CUstream stream;
+  CUstream stream = NULL;
   iree_status_t status = CU_RESULT_TO_STATUS(
       syms, cuStreamCreate(&stream, CU_STREAM_NON_BLOCKING));
+  CUstream transfer_stream = NULL;
+  if (iree_status_is_ok(status) && params->use_transfer_stream) {
+    status = CU_RESULT_TO_STATUS(
+        syms, cuStreamCreate(&transfer_stream, CU_STREAM_NON_BLOCKING));
+  }
 
   if (iree_status_is_ok(status)) {
-    status = iree_hal_cuda_device_create_internal(driver, identifier, params,
-                                                  device, stream, context, syms,
-                                                  host_allocator, out_device);
+    status = iree_hal_cuda_device_create_internal(
+        driver, identifier, params, device, stream, transfer_stream, context,
+        syms, host_allocator, out_device);
   }
   if (!iree_status_is_ok(status)) {
+    if (transfer_stream) {
+      syms->cuStreamDestroy(transfer_stream);
+    }
     if (stream) {
       syms->cuStreamDestroy(stream);
     }
@@ -211,12 +386,13 @@ static iree_status_t iree_hal_cuda_device_create_command_buffer(
   iree_hal_cuda_device_t* device = iree_hal_cuda_device_cast(base_device);
   if (device->use_deferred_submission) {
     return iree_hal_deferred_command_buffer_create(
-        mode, command_categories, &device->block_pool,
-        iree_hal_device_host_allocator(base_device), out_command_buffer);
+        mode, command_categories, device->deferred_command_buffer_flags,
+        &device->block_pool, iree_hal_device_host_allocator(base_device),
+        out_command_buffer);
   }
   return iree_hal_cuda_graph_command_buffer_create(
-      &device->context_wrapper, mode, command_categories, queue_affinity,
-      out_command_buffer);
+      &device->context_wrapper, &device->graph_exec_cache, mode,
+      command_categories, queue_affinity, out_command_buffer);
 }
 
 static iree_status_t iree_hal_cuda_device_create_descriptor_set(
@@ -270,50 +446,294 @@ static iree_status_t iree_hal_cuda_device_create_semaphore(
     iree_hal_device_t* base_device, uint64_t initial_value,
     iree_hal_semaphore_t** out_semaphore) {
   iree_hal_cuda_device_t* device = iree_hal_cuda_device_cast(base_device);
-  return iree_hal_cuda_semaphore_create(&device->context_wrapper, initial_value,
-                                        out_semaphore);
+  return iree_hal_cuda_semaphore_create(
+      &device->context_wrapper, device->timeline_pool, initial_value,
+      out_semaphore);
 }
 
-static iree_status_t iree_hal_cuda_device_queue_submit(
-    iree_hal_device_t* base_device,
-    iree_hal_command_category_t command_categories,
-    iree_hal_queue_affinity_t queue_affinity, iree_host_size_t batch_count,
-    const iree_hal_submission_batch_t* batches) {
-  iree_hal_cuda_device_t* device = iree_hal_cuda_device_cast(base_device);
+// Returns the stream that work of |command_categories| is issued on.
+static CUstream iree_hal_cuda_device_select_stream(
+    iree_hal_cuda_device_t* device,
+    iree_hal_command_category_t command_categories) {
+  if (device->transfer_stream &&
+      command_categories == IREE_HAL_COMMAND_CATEGORY_TRANSFER) {
+    return device->transfer_stream;
+  }
+  return device->stream;
+}
+
+// Issues the command buffers of |batch| on |stream| in order after its wait
+// semaphores are reached and enqueues the signals of its signal semaphores.
+static iree_status_t iree_hal_cuda_device_submit_batch(
+    iree_hal_cuda_device_t* device,
+    iree_hal_command_category_t command_categories, CUstream stream,
+    const iree_hal_submission_batch_t* batch) {
+  for (iree_host_size_t i = 0; i < batch->wait_semaphores.count; ++i) {
+    IREE_RETURN_IF_ERROR(iree_hal_cuda_semaphore_enqueue_wait(
+        batch->wait_semaphores.semaphores[i],
+        batch->wait_semaphores.payload_values[i], stream));
+  }
+
   if (device->use_deferred_submission) {
-    iree_hal_command_buffer_t* stream_command_buffer;
-    iree_status_t status = iree_hal_cuda_stream_command_buffer_create(
-        &device->context_wrapper,
-        IREE_HAL_COMMAND_BUFFER_MODE_ALLOW_INLINE_EXECUTION, command_categories,
-        device->stream, &stream_command_buffer);
-    if (iree_status_is_ok(status)) {
-      for (int i = 0; i < batch_count; i++) {
-        for (int j = 0; j < batches[i].command_buffer_count; j++) {
-          iree_hal_deferred_command_buffer_apply(batches[i].command_buffers[j],
-                                                 stream_command_buffer);
-        }
-      }
+    iree_hal_command_buffer_t* stream_command_buffer = NULL;
+    // Persistent kernel counters are shared by all launches and must only be
+    // used from the compute stream.
+    const iree_hal_cuda_persistent_dispatch_options_t* persistent_options =
+        device->persistent_options.counters && stream == device->stream
+            ? &device->persistent_options
+            : NULL;
+    IREE_RETURN_IF_ERROR(iree_hal_cuda_stream_command_buffer_create(
+        &device->context_wrapper, device->profiling_context,
+        persistent_options, IREE_HAL_COMMAND_BUFFER_MODE_ALLOW_INLINE_EXECUTION,
+        command_categories, stream, &stream_command_buffer));
+    iree_status_t status = iree_ok_status();
+    for (iree_host_size_t j = 0;
+         j < batch->command_buffer_count && iree_status_is_ok(status); ++j) {
+      status = iree_hal_deferred_command_buffer_apply(
+          batch->command_buffers[j], stream_command_buffer);
     }
     iree_hal_command_buffer_release(stream_command_buffer);
+    IREE_RETURN_IF_ERROR(status);
   } else {
-    for (int i = 0; i < batch_count; i++) {
-      for (int j = 0; j < batches[i].command_buffer_count; j++) {
-        CUgraphExec exec = iree_hal_cuda_graph_command_buffer_exec(
-            batches[i].command_buffers[j]);
-        CUDA_RETURN_IF_ERROR(device->context_wrapper.syms,
-                             cuGraphLaunch(exec, device->stream),
-                             "cuGraphLaunch");
+    for (iree_host_size_t j = 0; j < batch->command_buffer_count; ++j) {
+      CUgraphExec exec =
+          iree_hal_cuda_graph_command_buffer_exec(batch->command_buffers[j]);
+      CUDA_RETURN_IF_ERROR(device->context_wrapper.syms,
+                           cuGraphLaunch(exec, stream), "cuGraphLaunch");
+    }
+  }
+
+  for (iree_host_size_t i = 0; i < batch->signal_semaphores.count; ++i) {
+    IREE_RETURN_IF_ERROR(iree_hal_cuda_semaphore_enqueue_signal(
+        batch->signal_semaphores.semaphores[i],
+        batch->signal_semaphores.payload_values[i], stream));
+  }
+  return iree_ok_status();
+}
+
+// Fails the signal semaphores of |batch| with |status| when it cannot be
+// issued after having been deferred.
+static void iree_hal_cuda_device_fail_batch(
+    const iree_hal_submission_batch_t* batch, iree_status_t status) {
+  for (iree_host_size_t i = 0; i < batch->signal_semaphores.count; ++i) {
+    iree_hal_semaphore_fail(batch->signal_semaphores.semaphores[i],
+                            iree_status_clone(status));
+  }
+  iree_status_ignore(status);
+}
+
+// Wakes the deferred thread to issue the deferred submissions that are ready.
+// Made with the lock of the semaphore the submission waits on held.
+static void iree_hal_cuda_device_wake_deferred(void* user_data) {
+  iree_hal_cuda_device_t* device = (iree_hal_cuda_device_t*)user_data;
+  iree_atomic_store_int32(&device->deferred_wake, 1, iree_memory_order_release);
+  iree_notification_post(&device->deferred_notification, IREE_ALL_WAITERS);
+}
+
+// Issues deferred submissions in order until one has a wait that cannot yet
+// be enqueued and registers a waiter to wake the deferred thread once it can.
+// Must be called with the submit mutex held.
+static void iree_hal_cuda_device_issue_deferred(
+    iree_hal_cuda_device_t* device) {
+  while (device->deferred_head) {
+    iree_hal_cuda_deferred_submission_t* submission = device->deferred_head;
+    const iree_hal_semaphore_list_t* waits =
+        &submission->batch.wait_semaphores;
+    for (; submission->wait_index < waits->count; ++submission->wait_index) {
+      iree_hal_semaphore_t* semaphore =
+          waits->semaphores[submission->wait_index];
+      // The waiter is still registered if woken for another reason.
+      iree_hal_cuda_semaphore_remove_waiter(semaphore, &submission->waiter);
+      submission->waiter.value = waits->payload_values[submission->wait_index];
+      if (iree_hal_cuda_semaphore_add_waiter(semaphore, &submission->waiter)) {
+        return;
       }
     }
+    device->deferred_head = submission->next;
+    if (!device->deferred_head) device->deferred_tail = NULL;
+    iree_status_t status = iree_hal_cuda_device_submit_batch(
+        device, submission->command_categories, submission->stream,
+        &submission->batch);
+    if (!iree_status_is_ok(status)) {
+      // There is no caller to return the failure to.
+      iree_hal_cuda_device_fail_batch(&submission->batch, status);
+    }
+    iree_hal_cuda_device_free_deferred_submission(device, submission);
   }
-  // TODO(thomasraoux): Conservatively syncronize after every submit until we
-  // support semaphores.
-  CUDA_RETURN_IF_ERROR(device->context_wrapper.syms,
-                       cuStreamSynchronize(device->stream),
-                       "cuStreamSynchronize");
+  // Wake iree_hal_cuda_device_wait_idle.
+  iree_notification_post(&device->deferred_notification, IREE_ALL_WAITERS);
+}
+
+static int iree_hal_cuda_device_deferred_thread_main(void* entry_arg) {
+  iree_hal_cuda_device_t* device = (iree_hal_cuda_device_t*)entry_arg;
+  // Deferred submissions are issued to streams of the device context.
+  CUDA_IGNORE_ERROR(device->context_wrapper.syms,
+                    cuCtxSetCurrent(device->context_wrapper.cu_context));
+  while (true) {
+    iree_wait_token_t wait_token =
+        iree_notification_prepare_wait(&device->deferred_notification);
+    if (iree_atomic_exchange_int32(&device->deferred_wake, 0,
+                                   iree_memory_order_acq_rel)) {
+      iree_notification_cancel_wait(&device->deferred_notification);
+      iree_slim_mutex_lock(&device->submit_mutex);
+      iree_hal_cuda_device_issue_deferred(device);
+      iree_slim_mutex_unlock(&device->submit_mutex);
+    } else if (iree_atomic_load_int32(&device->deferred_exit,
+                                      iree_memory_order_acquire)) {
+      iree_notification_cancel_wait(&device->deferred_notification);
+      break;
+    } else {
+      iree_notification_commit_wait(&device->deferred_notification,
+                                    wait_token);
+    }
+  }
+  return 0;
+}
+
+static void iree_hal_cuda_device_free_deferred_submission(
+    iree_hal_cuda_device_t* device,
+    iree_hal_cuda_deferred_submission_t* submission) {
+  const iree_hal_submission_batch_t* batch = &submission->batch;
+  for (iree_host_size_t i = 0; i < batch->wait_semaphores.count; ++i) {
+    iree_hal_semaphore_release(batch->wait_semaphores.semaphores[i]);
+  }
+  for (iree_host_size_t i = 0; i < batch->command_buffer_count; ++i) {
+    iree_hal_command_buffer_release(batch->command_buffers[i]);
+  }
+  for (iree_host_size_t i = 0; i < batch->signal_semaphores.count; ++i) {
+    iree_hal_semaphore_release(batch->signal_semaphores.semaphores[i]);
+  }
+  iree_allocator_free(device->context_wrapper.host_allocator, submission);
+}
+
+// Appends a copy of |batch| to the deferred submission queue.
+// Must be called with the submit mutex held.
+static iree_status_t iree_hal_cuda_device_defer_batch(
+    iree_hal_cuda_device_t* device,
+    iree_hal_command_category_t command_categories, CUstream stream,
+    const iree_hal_submission_batch_t* batch) {
+  if (!device->deferred_thread) {
+    iree_thread_create_params_t params;
+    memset(&params, 0, sizeof(params));
+    params.name = iree_make_cstring_view("iree-cuda-deferred");
+    IREE_RETURN_IF_ERROR(iree_thread_create(
+        iree_hal_cuda_device_deferred_thread_main, device, params,
+        device->context_wrapper.host_allocator, &device->deferred_thread));
+  }
+
+  // Payload values are stored ahead of the pointer arrays to keep them
+  // aligned.
+  iree_host_size_t wait_count = batch->wait_semaphores.count;
+  iree_host_size_t signal_count = batch->signal_semaphores.count;
+  iree_host_size_t command_buffer_count = batch->command_buffer_count;
+  iree_hal_cuda_deferred_submission_t* submission = NULL;
+  iree_host_size_t total_size =
+      iree_sizeof_struct(*submission) +
+      (wait_count + signal_count) * sizeof(uint64_t) +
+      (wait_count + signal_count) * sizeof(iree_hal_semaphore_t*) +
+      command_buffer_count * sizeof(iree_hal_command_buffer_t*);
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      device->context_wrapper.host_allocator, total_size,
+      (void**)&submission));
+  memset(submission, 0, sizeof(*submission));
+  submission->command_categories = command_categories;
+  submission->stream = stream;
+  submission->waiter.kind = IREE_HAL_CUDA_SEMAPHORE_WAITER_KIND_ENQUEUEABLE;
+  submission->waiter.callback = iree_hal_cuda_device_wake_deferred;
+  submission->waiter.user_data = device;
+
+  uint8_t* ptr = (uint8_t*)submission + iree_sizeof_struct(*submission);
+  iree_hal_submission_batch_t* copy = &submission->batch;
+  copy->wait_semaphores.count = wait_count;
+  copy->wait_semaphores.payload_values = (uint64_t*)ptr;
+  ptr += wait_count * sizeof(uint64_t);
+  copy->signal_semaphores.count = signal_count;
+  copy->signal_semaphores.payload_values = (uint64_t*)ptr;
+  ptr += signal_count * sizeof(uint64_t);
+  copy->wait_semaphores.semaphores = (iree_hal_semaphore_t**)ptr;
+  ptr += wait_count * sizeof(iree_hal_semaphore_t*);
+  copy->signal_semaphores.semaphores = (iree_hal_semaphore_t**)ptr;
+  ptr += signal_count * sizeof(iree_hal_semaphore_t*);
+  copy->command_buffer_count = command_buffer_count;
+  copy->command_buffers = (iree_hal_command_buffer_t**)ptr;
+  for (iree_host_size_t i = 0; i < wait_count; ++i) {
+    copy->wait_semaphores.semaphores[i] = batch->wait_semaphores.semaphores[i];
+    copy->wait_semaphores.payload_values[i] =
+        batch->wait_semaphores.payload_values[i];
+    iree_hal_semaphore_retain(copy->wait_semaphores.semaphores[i]);
+  }
+  for (iree_host_size_t i = 0; i < signal_count; ++i) {
+    copy->signal_semaphores.semaphores[i] =
+        batch->signal_semaphores.semaphores[i];
+    copy->signal_semaphores.payload_values[i] =
+        batch->signal_semaphores.payload_values[i];
+    iree_hal_semaphore_retain(copy->signal_semaphores.semaphores[i]);
+  }
+  for (iree_host_size_t i = 0; i < command_buffer_count; ++i) {
+    copy->command_buffers[i] = batch->command_buffers[i];
+    iree_hal_command_buffer_retain(copy->command_buffers[i]);
+  }
+
+  if (device->deferred_tail) {
+    device->deferred_tail->next = submission;
+  } else {
+    device->deferred_head = submission;
+  }
+  device->deferred_tail = submission;
   return iree_ok_status();
 }
 
+// Returns true if all waits of |batch| can be enqueued on a stream.
+static bool iree_hal_cuda_device_are_waits_enqueueable(
+    const iree_hal_submission_batch_t* batch) {
+  for (iree_host_size_t i = 0; i < batch->wait_semaphores.count; ++i) {
+    if (!iree_hal_cuda_semaphore_is_wait_enqueueable(
+            batch->wait_semaphores.semaphores[i],
+            batch->wait_semaphores.payload_values[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static iree_status_t iree_hal_cuda_device_queue_submit(
+    iree_hal_device_t* base_device,
+    iree_hal_command_category_t command_categories,
+    iree_hal_queue_affinity_t queue_affinity, iree_host_size_t batch_count,
+    const iree_hal_submission_batch_t* batches) {
+  iree_hal_cuda_device_t* device = iree_hal_cuda_device_cast(base_device);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  CUstream stream =
+      iree_hal_cuda_device_select_stream(device, command_categories);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_cuda_allocator_order_stream(device->device_allocator,
+                                               stream));
+  iree_slim_mutex_lock(&device->submit_mutex);
+  iree_status_t status = iree_ok_status();
+  bool deferred = false;
+  for (iree_host_size_t i = 0; i < batch_count && iree_status_is_ok(status);
+       ++i) {
+    // Batches waiting on values that only the host or later submissions will
+    // signal are deferred instead of blocking the caller.
+    if (!device->deferred_head &&
+        iree_hal_cuda_device_are_waits_enqueueable(&batches[i])) {
+      status = iree_hal_cuda_device_submit_batch(device, command_categories,
+                                                 stream, &batches[i]);
+    } else {
+      status = iree_hal_cuda_device_defer_batch(device, command_categories,
+                                                stream, &batches[i]);
+      deferred = true;
+    }
+  }
+  if (deferred) {
+    // Registers a waiter for the first deferred wait.
+    iree_hal_cuda_device_issue_deferred(device);
+  }
+  iree_slim_mutex_unlock(&device->submit_mutex);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 static iree_status_t iree_hal_cuda_device_submit_and_wait(
     iree_hal_device_t* base_device,
     iree_hal_command_category_t command_categories,
@@ -332,22 +752,87 @@ static iree_status_t iree_hal_cuda_device_submit_and_wait(
 static iree_status_t iree_hal_cuda_device_wait_semaphores(
     iree_hal_device_t* base_device, iree_hal_wait_mode_t wait_mode,
     const iree_hal_semaphore_list_t* semaphore_list, iree_timeout_t timeout) {
-  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
-                          "semaphore not implemented");
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
+  iree_status_t status = iree_ok_status();
+  if (wait_mode == IREE_HAL_WAIT_MODE_ALL || semaphore_list->count <= 1) {
+    for (iree_host_size_t i = 0;
+         i < semaphore_list->count && iree_status_is_ok(status); ++i) {
+      status = iree_hal_semaphore_wait(semaphore_list->semaphores[i],
+                                       semaphore_list->payload_values[i],
+                                       iree_make_deadline(deadline_ns));
+    }
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+
+  status = iree_hal_cuda_semaphore_wait_any(
+      semaphore_list, iree_make_deadline(deadline_ns),
+      iree_hal_device_host_allocator(base_device));
+  IREE_TRACE_ZONE_END(z0);
+  return status;
 }
 
 static iree_status_t iree_hal_cuda_device_wait_idle(
     iree_hal_device_t* base_device, iree_timeout_t timeout) {
   iree_hal_cuda_device_t* device = iree_hal_cuda_device_cast(base_device);
-  // Wait until the stream is done.
+  // Wait until deferred submissions have been issued.
+  iree_slim_mutex_lock(&device->submit_mutex);
+  while (device->deferred_head) {
+    if (iree_timeout_is_immediate(timeout)) {
+      iree_slim_mutex_unlock(&device->submit_mutex);
+      return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+    }
+    iree_wait_token_t wait_token =
+        iree_notification_prepare_wait(&device->deferred_notification);
+    iree_slim_mutex_unlock(&device->submit_mutex);
+    iree_notification_commit_wait(&device->deferred_notification, wait_token);
+    iree_slim_mutex_lock(&device->submit_mutex);
+  }
+  iree_slim_mutex_unlock(&device->submit_mutex);
+  // Wait until the streams are done.
   // TODO(thomasraoux): CUDA doesn't support a deadline for wait, figure out how
   // to handle it better.
+  if (device->transfer_stream) {
+    CUDA_RETURN_IF_ERROR(device->context_wrapper.syms,
+                         cuStreamSynchronize(device->transfer_stream),
+                         "cuStreamSynchronize");
+  }
   CUDA_RETURN_IF_ERROR(device->context_wrapper.syms,
                        cuStreamSynchronize(device->stream),
                        "cuStreamSynchronize");
   return iree_ok_status();
 }
 
+static iree_status_t iree_hal_cuda_device_begin_dispatch_profiling(
+    iree_hal_device_t* base_device) {
+  iree_hal_cuda_device_t* device = iree_hal_cuda_device_cast(base_device);
+  if (!device->profiling_context) {
+    return iree_make_status(
+        IREE_STATUS_UNAVAILABLE,
+        "dispatch profiling requires deferred command buffer submission");
+  }
+  return iree_hal_cuda_profiling_context_begin(device->profiling_context);
+}
+
+static iree_status_t iree_hal_cuda_device_end_dispatch_profiling(
+    iree_hal_device_t* base_device) {
+  iree_hal_cuda_device_t* device = iree_hal_cuda_device_cast(base_device);
+  if (device->profiling_context) {
+    iree_hal_cuda_profiling_context_end(device->profiling_context);
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_cuda_device_flush_dispatch_profiles(
+    iree_hal_device_t* base_device,
+    iree_hal_dispatch_profile_callback_t callback) {
+  iree_hal_cuda_device_t* device = iree_hal_cuda_device_cast(base_device);
+  if (!device->profiling_context) return iree_ok_status();
+  return iree_hal_cuda_profiling_context_flush(device->profiling_context,
+                                               callback);
+}
+
 const iree_hal_device_vtable_t iree_hal_cuda_device_vtable = {
     .destroy = iree_hal_cuda_device_destroy,
     .id = iree_hal_cuda_device_id,
@@ -366,4 +851,7 @@ const iree_hal_device_vtable_t iree_hal_cuda_device_vtable = {
     .submit_and_wait = iree_hal_cuda_device_submit_and_wait,
     .wait_semaphores = iree_hal_cuda_device_wait_semaphores,
     .wait_idle = iree_hal_cuda_device_wait_idle,
+    .begin_dispatch_profiling = iree_hal_cuda_device_begin_dispatch_profiling,
+    .end_dispatch_profiling = iree_hal_cuda_device_end_dispatch_profiling,
+    .flush_dispatch_profiles = iree_hal_cuda_device_flush_dispatch_profiles,
 };
@@ -0,0 +1,230 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/cuda/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+constexpr iree_duration_t kTimeoutNs = 5000000000ll;
+
+// Tests submissions waiting on semaphore values signaled from the host. These
+// use semaphores without device timelines so that such waits cannot be
+// resolved on the device and the submissions must be deferred.
+class CUDADeviceTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    CreateDevice(/*use_device_timeline_semaphores=*/false);
+  }
+
+  void CreateDevice(bool use_device_timeline_semaphores) {
+    iree_hal_cuda_device_params_t params;
+    iree_hal_cuda_device_params_initialize(&params);
+    params.use_device_timeline_semaphores = use_device_timeline_semaphores;
+    iree_hal_cuda_driver_options_t options;
+    iree_hal_cuda_driver_options_initialize(&options);
+    iree_status_t status = iree_hal_cuda_driver_create(
+        iree_make_cstring_view("cuda"), &params, &options,
+        iree_allocator_system(), &driver_);
+    if (iree_status_is_ok(status)) {
+      status = iree_hal_driver_create_default_device(
+          driver_, iree_allocator_system(), &device_);
+    }
+    if (!iree_status_is_ok(status)) {
+      iree_status_ignore(status);
+      GTEST_SKIP() << "CUDA device not available";
+    }
+    IREE_ASSERT_OK(iree_hal_semaphore_create(device_, 0ull, &wait_semaphore_));
+    IREE_ASSERT_OK(
+        iree_hal_semaphore_create(device_, 0ull, &signal_semaphore_));
+  }
+
+  void TearDown() override {
+    iree_hal_semaphore_release(signal_semaphore_);
+    iree_hal_semaphore_release(wait_semaphore_);
+    iree_hal_device_release(device_);
+    iree_hal_driver_release(driver_);
+  }
+
+  // Submits an empty batch signaling |signal_semaphore_| to |signal_value|
+  // once |wait_semaphore_| reaches |wait_value| (if non-zero).
+  iree_status_t Submit(uint64_t wait_value, uint64_t signal_value,
+                       iree_hal_command_category_t command_categories =
+                           IREE_HAL_COMMAND_CATEGORY_DISPATCH) {
+    iree_hal_submission_batch_t batch = {};
+    if (wait_value) {
+      batch.wait_semaphores.count = 1;
+      batch.wait_semaphores.semaphores = &wait_semaphore_;
+      batch.wait_semaphores.payload_values = &wait_value;
+    }
+    batch.signal_semaphores.count = 1;
+    batch.signal_semaphores.semaphores = &signal_semaphore_;
+    batch.signal_semaphores.payload_values = &signal_value;
+    return iree_hal_device_queue_submit(device_, command_categories,
+                                        IREE_HAL_QUEUE_AFFINITY_ANY,
+                                        /*batch_count=*/1, &batch);
+  }
+
+  uint64_t Query(iree_hal_semaphore_t* semaphore) {
+    uint64_t value = 0;
+    IREE_CHECK_OK(iree_hal_semaphore_query(semaphore, &value));
+    return value;
+  }
+
+  iree_hal_driver_t* driver_ = NULL;
+  iree_hal_device_t* device_ = NULL;
+  iree_hal_semaphore_t* wait_semaphore_ = NULL;
+  iree_hal_semaphore_t* signal_semaphore_ = NULL;
+};
+
+// Submitting a wait on a value only the host will signal returns immediately
+// and the submission is issued once the host signals it.
+TEST_F(CUDADeviceTest, SubmitDefersHostSignaledWait) {
+  IREE_ASSERT_OK(Submit(/*wait_value=*/1, /*signal_value=*/1));
+  EXPECT_EQ(Query(signal_semaphore_), 0u);
+  IREE_ASSERT_OK(iree_hal_semaphore_signal(wait_semaphore_, 1));
+  IREE_EXPECT_OK(iree_hal_semaphore_wait(signal_semaphore_, 1,
+                                         iree_make_timeout(kTimeoutNs)));
+}
+
+// Submissions made after a deferred submission are issued after it.
+TEST_F(CUDADeviceTest, DeferredSubmissionsIssueInOrder) {
+  IREE_ASSERT_OK(Submit(/*wait_value=*/1, /*signal_value=*/1));
+  IREE_ASSERT_OK(Submit(/*wait_value=*/0, /*signal_value=*/2));
+  EXPECT_EQ(Query(signal_semaphore_), 0u);
+  IREE_ASSERT_OK(iree_hal_semaphore_signal(wait_semaphore_, 1));
+  IREE_EXPECT_OK(iree_hal_semaphore_wait(signal_semaphore_, 2,
+                                         iree_make_timeout(kTimeoutNs)));
+}
+
+// Waiting on any of several semaphores wakes on a host signal of one.
+TEST_F(CUDADeviceTest, WaitAnyWakesOnHostSignal) {
+  iree_hal_semaphore_t* semaphores[] = {wait_semaphore_, signal_semaphore_};
+  uint64_t payload_values[] = {1, 1};
+  iree_hal_semaphore_list_t semaphore_list = {
+      IREE_ARRAYSIZE(semaphores), semaphores, payload_values};
+  std::thread signaler([&]() {
+    IREE_CHECK_OK(iree_hal_semaphore_signal(signal_semaphore_, 1));
+  });
+  IREE_EXPECT_OK(iree_hal_device_wait_semaphores(
+      device_, IREE_HAL_WAIT_MODE_ANY, &semaphore_list,
+      iree_make_timeout(kTimeoutNs)));
+  signaler.join();
+  EXPECT_EQ(Query(wait_semaphore_), 0u);
+}
+
+// Waiting on any of several semaphores wakes on a device signal of one.
+TEST_F(CUDADeviceTest, WaitAnyWakesOnDeviceSignal) {
+  iree_hal_semaphore_t* semaphores[] = {wait_semaphore_, signal_semaphore_};
+  uint64_t payload_values[] = {1, 1};
+  iree_hal_semaphore_list_t semaphore_list = {
+      IREE_ARRAYSIZE(semaphores), semaphores, payload_values};
+  IREE_ASSERT_OK(Submit(/*wait_value=*/0, /*signal_value=*/1));
+  IREE_EXPECT_OK(iree_hal_device_wait_semaphores(
+      device_, IREE_HAL_WAIT_MODE_ANY, &semaphore_list,
+      iree_make_timeout(kTimeoutNs)));
+}
+
+// Waiting on any of several semaphores times out if none are signaled.
+TEST_F(CUDADeviceTest, WaitAnyTimesOut) {
+  iree_hal_semaphore_t* semaphores[] = {wait_semaphore_, signal_semaphore_};
+  uint64_t payload_values[] = {1, 1};
+  iree_hal_semaphore_list_t semaphore_list = {
+      IREE_ARRAYSIZE(semaphores), semaphores, payload_values};
+  iree_status_t status = iree_hal_device_wait_semaphores(
+      device_, IREE_HAL_WAIT_MODE_ANY, &semaphore_list,
+      iree_make_timeout(10000000ll));
+  EXPECT_TRUE(iree_status_is_deadline_exceeded(status));
+  iree_status_ignore(status);
+}
+
+// Tests semaphores using device timelines. Devices without stream memory
+// operations fall back to the event-backed semaphores tested above.
+class CUDADeviceTimelineTest : public CUDADeviceTest {
+ protected:
+  void SetUp() override {
+    CreateDevice(/*use_device_timeline_semaphores=*/true);
+  }
+};
+
+// Device timeline payloads are suballocated from pages shared by many
+// semaphores and reused once a semaphore is destroyed.
+TEST_F(CUDADeviceTimelineTest, ManySemaphores) {
+  constexpr int kSemaphoreCount = 1500;
+  std::vector<iree_hal_semaphore_t*> semaphores(kSemaphoreCount);
+  for (int i = 0; i < kSemaphoreCount; ++i) {
+    IREE_ASSERT_OK(iree_hal_semaphore_create(device_, i, &semaphores[i]));
+  }
+  for (int i = 0; i < kSemaphoreCount; ++i) {
+    IREE_ASSERT_OK(iree_hal_semaphore_signal(semaphores[i], i + 1));
+  }
+  for (int i = 0; i < kSemaphoreCount; ++i) {
+    EXPECT_EQ(Query(semaphores[i]), (uint64_t)i + 1);
+    iree_hal_semaphore_release(semaphores[i]);
+  }
+  // Semaphores reusing the payloads start at their own initial value.
+  for (int i = 0; i < kSemaphoreCount; ++i) {
+    IREE_ASSERT_OK(iree_hal_semaphore_create(device_, 0ull, &semaphores[i]));
+    EXPECT_EQ(Query(semaphores[i]), 0u);
+  }
+  for (int i = 0; i < kSemaphoreCount; ++i) {
+    iree_hal_semaphore_release(semaphores[i]);
+  }
+}
+
+// A payload released while device operations on it are pending is not reused
+// until they complete.
+TEST_F(CUDADeviceTimelineTest, PendingPayloadNotReused) {
+  // Exhausts the first page of payloads (512 per page, two of which are used
+  // by the fixture) so that the next semaphore would reuse the released one.
+  std::vector<iree_hal_semaphore_t*> semaphores(510);
+  for (iree_hal_semaphore_t*& semaphore : semaphores) {
+    IREE_ASSERT_OK(iree_hal_semaphore_create(device_, 0ull, &semaphore));
+  }
+  IREE_ASSERT_OK(Submit(/*wait_value=*/1, /*signal_value=*/1));
+  iree_hal_semaphore_release(signal_semaphore_);
+  IREE_ASSERT_OK(
+      iree_hal_semaphore_create(device_, 0ull, &signal_semaphore_));
+  IREE_ASSERT_OK(iree_hal_semaphore_signal(wait_semaphore_, 1));
+  IREE_ASSERT_OK(iree_hal_device_wait_idle(device_, iree_infinite_timeout()));
+  EXPECT_EQ(Query(signal_semaphore_), 0u);
+  for (iree_hal_semaphore_t* semaphore : semaphores) {
+    iree_hal_semaphore_release(semaphore);
+  }
+}
+
+// Signals of one semaphore from different streams never move the payload
+// backwards even when the later signal runs first.
+TEST_F(CUDADeviceTimelineTest, SignalsOrderedAcrossStreams) {
+  IREE_ASSERT_OK(Submit(/*wait_value=*/1, /*signal_value=*/1,
+                        IREE_HAL_COMMAND_CATEGORY_DISPATCH));
+  IREE_ASSERT_OK(Submit(/*wait_value=*/0, /*signal_value=*/2,
+                        IREE_HAL_COMMAND_CATEGORY_TRANSFER));
+  EXPECT_EQ(Query(signal_semaphore_), 0u);
+  IREE_ASSERT_OK(iree_hal_semaphore_signal(wait_semaphore_, 1));
+  IREE_ASSERT_OK(iree_hal_semaphore_wait(signal_semaphore_, 2,
+                                         iree_make_timeout(kTimeoutNs)));
+  IREE_ASSERT_OK(iree_hal_device_wait_idle(device_, iree_infinite_timeout()));
+  EXPECT_EQ(Query(signal_semaphore_), 2u);
+}
+
+// Device signals must increase.
+TEST_F(CUDADeviceTimelineTest, NonIncreasingSignalFails) {
+  IREE_ASSERT_OK(Submit(/*wait_value=*/0, /*signal_value=*/2));
+  iree_status_t status = Submit(/*wait_value=*/0, /*signal_value=*/1);
+  EXPECT_TRUE(iree_status_is_out_of_range(status));
+  iree_status_ignore(status);
+  IREE_ASSERT_OK(iree_hal_device_wait_idle(device_, iree_infinite_timeout()));
+}
+
+}  // namespace
@@ -6,7 +6,15 @@
 
 CU_PFN_DECL(cuCtxCreate, CUcontext*, unsigned int, CUdevice)
 CU_PFN_DECL(cuCtxDestroy, CUcontext)
+CU_PFN_DECL(cuCtxSetCurrent, CUcontext)
 CU_PFN_DECL(cuDeviceGet, CUdevice*, int)
+CU_PFN_DECL(cuDeviceGetAttribute, int*, CUdevice_attribute, CUdevice)
+CU_PFN_DECL(cuEventCreate, CUevent*, unsigned int)
+CU_PFN_DECL(cuEventDestroy, CUevent)
+CU_PFN_DECL(cuEventElapsedTime, float*, CUevent, CUevent)
+CU_PFN_DECL(cuEventQuery, CUevent)
+CU_PFN_DECL(cuEventRecord, CUevent, CUstream)
+CU_PFN_DECL(cuEventSynchronize, CUevent)
 CU_PFN_DECL(cuDeviceGetCount, int*)
 CU_PFN_DECL(cuDeviceGetName, char*, int, CUdevice)
 CU_PFN_DECL(cuGetErrorName, CUresult, const char**)
@@ -31,6 +39,8 @@ CU_PFN_DECL(cuMemFree, CUdeviceptr)
 CU_PFN_DECL(cuMemFreeHost, void*)
 CU_PFN_DECL(cuMemHostAlloc, void**, size_t, unsigned int)
 CU_PFN_DECL(cuMemHostGetDevicePointer, CUdeviceptr*, void*, unsigned int)
+CU_PFN_DECL(cuMemHostRegister, void*, size_t, unsigned int)
+CU_PFN_DECL(cuMemHostUnregister, void*)
 CU_PFN_DECL(cuModuleGetFunction, CUfunction*, CUmodule, const char*)
 CU_PFN_DECL(cuModuleLoadDataEx, CUmodule*, const void*, unsigned int,
             CUjit_option*, void**)
@@ -44,3 +54,19 @@ CU_PFN_DECL(cuMemcpyAsync, CUdeviceptr, CUdeviceptr, size_t, CUstream)
 CU_PFN_DECL(cuLaunchKernel, CUfunction, unsigned int, unsigned int,
             unsigned int, unsigned int, unsigned int, unsigned int,
             unsigned int, CUstream, void **, void **)
+
+// Optional entry points that are not available in all drivers. These are left
+// NULL if not found and must be checked before use.
+// Stream-ordered allocation (CUDA 11.2+):
+CU_PFN_DECL_OPTIONAL(cuMemAllocAsync, CUdeviceptr*, size_t, CUstream)
+CU_PFN_DECL_OPTIONAL(cuMemFreeAsync, CUdeviceptr, CUstream)
+// In-place graph executable updates (CUDA 10.2+):
+CU_PFN_DECL_OPTIONAL(cuGraphExecUpdate, CUgraphExec, CUgraph, CUgraphNode*,
+                     CUgraphExecUpdateResult*)
+// Stream memory operations (CUDA 9.0+, device support varies):
+CU_PFN_DECL_OPTIONAL(cuStreamWaitValue64, CUstream, CUdeviceptr, cuuint64_t,
+                     unsigned int)
+CU_PFN_DECL_OPTIONAL(cuStreamWriteValue64, CUstream, CUdeviceptr, cuuint64_t,
+                     unsigned int)
+// Host function launches (CUDA 10.0+):
+CU_PFN_DECL_OPTIONAL(cuLaunchHostFunc, CUstream, CUhostFn, void*)
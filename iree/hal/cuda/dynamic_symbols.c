@@ -35,7 +35,16 @@ static iree_status_t iree_hal_cuda_dynamic_symbols_resolve_all(
     iree_dynamic_library_lookup_symbol(syms->loader_library, kNameV2, &funV2); \
     if (funV2) syms->cudaSymbolName = funV2;                                   \
   }
+#define CU_PFN_DECL_OPTIONAL(cudaSymbolName, ...)                              \
+  {                                                                            \
+    static const char* kName = #cudaSymbolName;                                \
+    void* fun = NULL;                                                          \
+    iree_status_ignore(iree_dynamic_library_lookup_symbol(                     \
+        syms->loader_library, kName, &fun));                                   \
+    syms->cudaSymbolName = fun;                                                \
+  }
 #include "iree/hal/cuda/dynamic_symbol_tables.h"  // IWYU pragma: keep
+#undef CU_PFN_DECL_OPTIONAL
 #undef CU_PFN_DECL
   return iree_ok_status();
 }
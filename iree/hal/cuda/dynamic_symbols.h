@@ -18,13 +18,15 @@ extern "C" {
 // DynamicSymbols allow loading dynamically a subset of CUDA driver API. It
 // loads all the function declared in `dynamic_symbol_tables.def` and fail if
 // any of the symbol is not available. The functions signatures are matching
-// the declarations in `cuda.h`.
+// the declarations in `cuda.h`. Optional functions are NULL if not available.
 typedef struct iree_hal_cuda_dynamic_symbols_t {
   iree_dynamic_library_t* loader_library;
 
 #define CU_PFN_DECL(cudaSymbolName, ...) \
   CUresult (*cudaSymbolName)(__VA_ARGS__);
+#define CU_PFN_DECL_OPTIONAL CU_PFN_DECL
 #include "iree/hal/cuda/dynamic_symbol_tables.h"  // IWYU pragma: export
+#undef CU_PFN_DECL_OPTIONAL
 #undef CU_PFN_DECL
 } iree_hal_cuda_dynamic_symbols_t;
 
@@ -7,15 +7,122 @@
 #include "iree/hal/cuda/event_semaphore.h"
 
 #include <stddef.h>
+#include <inttypes.h>
+#include <string.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/internal/threading.h"
+#include "iree/base/internal/wait_handle.h"
 #include "iree/base/tracing.h"
+#include "iree/hal/cuda/timeline_pool.h"
 
-typedef struct iree_hal_cuda_semaphore_t {
+// Maximum number of device signals that may be pending on a semaphore at a
+// time. When exceeded the oldest pending signal is waited on by the host.
+#define IREE_HAL_CUDA_SEMAPHORE_MAX_TIMEPOINTS 32
+
+// Maximum number of streams tracked as having enqueued operations on the
+// device timeline of a semaphore. Devices use at most a compute and a
+// transfer stream.
+#define IREE_HAL_CUDA_SEMAPHORE_MAX_TIMELINE_STREAMS 2
+
+// Payload written to the device timeline of a failed semaphore to release any
+// device waits. cuStreamWaitValue64 compares values as signed differences so
+// this must not exceed INT64_MAX.
+#define IREE_HAL_CUDA_SEMAPHORE_FAILURE_VALUE ((uint64_t)INT64_MAX)
+
+// Interval at which host waits observe device signals when the driver cannot
+// launch host functions to report them.
+#define IREE_HAL_CUDA_SEMAPHORE_POLL_INTERVAL_NS (100 * 1000)
+
+// A CUDA event shared between a pending timepoint and the host threads
+// blocked on it. The event is destroyed when the last reference is released
+// such that retiring a timepoint never destroys an event a waiter is still
+// synchronizing on. The reference count is guarded by the semaphore mutex.
+typedef struct iree_hal_cuda_timepoint_event_t {
+  iree_host_size_t ref_count;
+  CUevent event;
+} iree_hal_cuda_timepoint_event_t;
+
+// A pending device signal of a semaphore to |value| that happens when the
+// event completes.
+typedef struct iree_hal_cuda_timepoint_t {
+  uint64_t value;
+  iree_hal_cuda_timepoint_event_t* event;
+} iree_hal_cuda_timepoint_t;
+
+// A stream that has enqueued operations on a device timeline and an event
+// recorded after the last of them.
+typedef struct iree_hal_cuda_timeline_stream_t {
+  CUstream stream;
+  CUevent event;
+} iree_hal_cuda_timeline_stream_t;
+
+typedef struct iree_hal_cuda_semaphore_t iree_hal_cuda_semaphore_t;
+
+// Routes device signals reported by host functions to their semaphore. Shared
+// by the semaphore and the host functions in flight so that the semaphore may
+// be destroyed before they run.
+typedef struct iree_hal_cuda_host_signal_channel_t {
+  iree_atomic_ref_count_t ref_count;
+  iree_allocator_t host_allocator;
+  // Guards |semaphore|, which is NULL once the semaphore has been destroyed.
+  // Acquired before the semaphore mutex.
+  iree_slim_mutex_t mutex;
+  iree_hal_cuda_semaphore_t* semaphore;
+} iree_hal_cuda_host_signal_channel_t;
+
+// A device signal to |value| reported to the host by a host function launched
+// on the signaling stream.
+typedef struct iree_hal_cuda_host_signal_t {
+  iree_hal_cuda_host_signal_channel_t* channel;
+  uint64_t value;
+} iree_hal_cuda_host_signal_t;
+
+struct iree_hal_cuda_semaphore_t {
   iree_hal_resource_t resource;
   iree_hal_cuda_context_wrapper_t* context;
-  uint64_t initial_value;
-} iree_hal_cuda_semaphore_t;
+
+  // Posted whenever the value changes or the semaphore fails.
+  iree_notification_t notification;
+
+  // Channel reporting device signals to host waiters as they happen. NULL if
+  // the driver cannot launch host functions.
+  iree_hal_cuda_host_signal_channel_t* host_signal_channel;
+
+  // Pool the device timeline payload is suballocated from. NULL if not using
+  // a device timeline.
+  iree_hal_cuda_timeline_pool_t* timeline_pool;
+  // Mapped host memory holding the payload when using a device timeline.
+  // Written by cuStreamWriteValue64 and the host and read by
+  // cuStreamWaitValue64 and the host. |host_ptr| is NULL if not using a device
+  // timeline.
+  iree_hal_cuda_timeline_slot_t timeline;
+
+  // Guards all state below.
+  iree_slim_mutex_t mutex;
+  // Last value known to have been reached.
+  uint64_t current_value;
+  // Sticky failure status set by iree_hal_semaphore_fail, if any.
+  iree_status_t failure_status;
+  // Pending device signals in increasing value order stored as a ring.
+  iree_host_size_t timepoint_head;
+  iree_host_size_t timepoint_count;
+  iree_hal_cuda_timepoint_t timepoints[IREE_HAL_CUDA_SEMAPHORE_MAX_TIMEPOINTS];
+  // Unordered list of registered waiters not yet satisfied.
+  iree_hal_cuda_semaphore_waiter_t* waiter_head;
+  // Streams with operations enqueued on the device timeline. The payload is
+  // only reused once they complete.
+  iree_host_size_t timeline_stream_count;
+  iree_hal_cuda_timeline_stream_t
+      timeline_streams[IREE_HAL_CUDA_SEMAPHORE_MAX_TIMELINE_STREAMS];
+  // Stream and value of the last device signal enqueued. Device timeline
+  // writes from another stream wait for it so that the payload never moves
+  // backwards.
+  CUstream last_write_stream;
+  uint64_t last_write_value;
+};
 
 extern const iree_hal_semaphore_vtable_t iree_hal_cuda_semaphore_vtable;
 
@@ -25,8 +132,87 @@ static iree_hal_cuda_semaphore_t* iree_hal_cuda_semaphore_cast(
   return (iree_hal_cuda_semaphore_t*)base_value;
 }
 
+// Releases a reference to |event| and destroys it if it was the last one.
+// Must be called with the lock held.
+static void iree_hal_cuda_timepoint_event_release(
+    iree_hal_cuda_semaphore_t* semaphore,
+    iree_hal_cuda_timepoint_event_t* event) {
+  if (--event->ref_count > 0) return;
+  // CUDA defers destruction of events that are still pending on the device.
+  CUDA_IGNORE_ERROR(semaphore->context->syms, cuEventDestroy(event->event));
+  iree_allocator_free(semaphore->context->host_allocator, event);
+}
+
+bool iree_hal_cuda_semaphore_is_device_timeline_supported(
+    iree_hal_cuda_dynamic_symbols_t* syms, CUdevice device) {
+  if (!syms->cuStreamWaitValue64 || !syms->cuStreamWriteValue64) return false;
+  int mem_ops = 0;
+  int mem_ops_64_bit = 0;
+  if (syms->cuDeviceGetAttribute(&mem_ops,
+                                 CU_DEVICE_ATTRIBUTE_CAN_USE_STREAM_MEM_OPS,
+                                 device) != CUDA_SUCCESS ||
+      syms->cuDeviceGetAttribute(
+          &mem_ops_64_bit, CU_DEVICE_ATTRIBUTE_CAN_USE_64_BIT_STREAM_MEM_OPS,
+          device) != CUDA_SUCCESS) {
+    return false;
+  }
+  return mem_ops && mem_ops_64_bit;
+}
+
+static iree_status_t iree_hal_cuda_host_signal_channel_create(
+    iree_hal_cuda_semaphore_t* semaphore,
+    iree_hal_cuda_host_signal_channel_t** out_channel) {
+  iree_allocator_t host_allocator = semaphore->context->host_allocator;
+  iree_hal_cuda_host_signal_channel_t* channel = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(host_allocator, sizeof(*channel),
+                                             (void**)&channel));
+  iree_atomic_ref_count_init(&channel->ref_count);
+  channel->host_allocator = host_allocator;
+  iree_slim_mutex_initialize(&channel->mutex);
+  channel->semaphore = semaphore;
+  *out_channel = channel;
+  return iree_ok_status();
+}
+
+static void iree_hal_cuda_host_signal_channel_release(
+    iree_hal_cuda_host_signal_channel_t* channel) {
+  if (iree_atomic_ref_count_dec(&channel->ref_count) == 1) {
+    iree_slim_mutex_deinitialize(&channel->mutex);
+    iree_allocator_free(channel->host_allocator, channel);
+  }
+}
+
+static void iree_hal_cuda_semaphore_notify_waiters(
+    iree_hal_cuda_semaphore_t* semaphore);
+
+// Reports a device signal to host waiters. Called by CUDA from an internal
+// thread once all prior work on the signaling stream has completed. CUDA APIs
+// must not be called from here.
+static void CUDA_CB iree_hal_cuda_semaphore_host_signal(void* user_data) {
+  iree_hal_cuda_host_signal_t* host_signal =
+      (iree_hal_cuda_host_signal_t*)user_data;
+  iree_hal_cuda_host_signal_channel_t* channel = host_signal->channel;
+  iree_slim_mutex_lock(&channel->mutex);
+  iree_hal_cuda_semaphore_t* semaphore = channel->semaphore;
+  if (semaphore) {
+    iree_slim_mutex_lock(&semaphore->mutex);
+    if (iree_status_is_ok(semaphore->failure_status) &&
+        host_signal->value > semaphore->current_value) {
+      // The timepoint is retired on the next query; its event is complete.
+      semaphore->current_value = host_signal->value;
+      iree_hal_cuda_semaphore_notify_waiters(semaphore);
+    }
+    iree_slim_mutex_unlock(&semaphore->mutex);
+    iree_notification_post(&semaphore->notification, IREE_ALL_WAITERS);
+  }
+  iree_slim_mutex_unlock(&channel->mutex);
+  iree_allocator_free(channel->host_allocator, host_signal);
+  iree_hal_cuda_host_signal_channel_release(channel);
+}
+
 iree_status_t iree_hal_cuda_semaphore_create(
-    iree_hal_cuda_context_wrapper_t* context, uint64_t initial_value,
+    iree_hal_cuda_context_wrapper_t* context,
+    iree_hal_cuda_timeline_pool_t* timeline_pool, uint64_t initial_value,
     iree_hal_semaphore_t** out_semaphore) {
   IREE_ASSERT_ARGUMENT(context);
   IREE_ASSERT_ARGUMENT(out_semaphore);
@@ -39,10 +225,36 @@ iree_status_t iree_hal_cuda_semaphore_create(
     iree_hal_resource_initialize(&iree_hal_cuda_semaphore_vtable,
                                  &semaphore->resource);
     semaphore->context = context;
-    semaphore->initial_value = initial_value;
-    *out_semaphore = (iree_hal_semaphore_t*)semaphore;
+    iree_notification_initialize(&semaphore->notification);
+    iree_slim_mutex_initialize(&semaphore->mutex);
+    semaphore->current_value = initial_value;
+    semaphore->failure_status = iree_ok_status();
+    semaphore->timepoint_head = 0;
+    semaphore->timepoint_count = 0;
+    semaphore->timeline_pool = NULL;
+    semaphore->timeline.host_ptr = NULL;
+    semaphore->timeline.device_ptr = 0;
+    semaphore->host_signal_channel = NULL;
+    semaphore->waiter_head = NULL;
+    semaphore->timeline_stream_count = 0;
+    semaphore->last_write_stream = NULL;
+    semaphore->last_write_value = initial_value;
+    if (timeline_pool) {
+      status = iree_hal_cuda_timeline_pool_acquire(
+          timeline_pool, initial_value, &semaphore->timeline);
+      if (iree_status_is_ok(status)) semaphore->timeline_pool = timeline_pool;
+    }
+  }
+  if (iree_status_is_ok(status) && context->syms->cuLaunchHostFunc) {
+    status = iree_hal_cuda_host_signal_channel_create(
+        semaphore, &semaphore->host_signal_channel);
   }
 
+  if (iree_status_is_ok(status)) {
+    *out_semaphore = (iree_hal_semaphore_t*)semaphore;
+  } else if (semaphore) {
+    iree_hal_semaphore_release((iree_hal_semaphore_t*)semaphore);
+  }
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
@@ -54,33 +266,584 @@ static void iree_hal_cuda_semaphore_destroy(
   iree_allocator_t host_allocator = semaphore->context->host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // Host functions still in flight drop their signals once detached.
+  if (semaphore->host_signal_channel) {
+    iree_hal_cuda_host_signal_channel_t* channel =
+        semaphore->host_signal_channel;
+    iree_slim_mutex_lock(&channel->mutex);
+    channel->semaphore = NULL;
+    iree_slim_mutex_unlock(&channel->mutex);
+    iree_hal_cuda_host_signal_channel_release(channel);
+  }
+
+  // Events may still be pending; CUDA defers their destruction until complete.
+  // No host waiters can remain as they hold references to the semaphore.
+  for (iree_host_size_t i = 0; i < semaphore->timepoint_count; ++i) {
+    iree_hal_cuda_timepoint_t* timepoint =
+        &semaphore->timepoints[(semaphore->timepoint_head + i) %
+                               IREE_HAL_CUDA_SEMAPHORE_MAX_TIMEPOINTS];
+    iree_hal_cuda_timepoint_event_release(semaphore, timepoint->event);
+  }
+  if (semaphore->timeline_pool) {
+    // The payload is reused once pending stream memory operations on it have
+    // completed. The pool takes ownership of the events.
+    CUevent events[IREE_HAL_CUDA_SEMAPHORE_MAX_TIMELINE_STREAMS];
+    for (iree_host_size_t i = 0; i < semaphore->timeline_stream_count; ++i) {
+      events[i] = semaphore->timeline_streams[i].event;
+    }
+    iree_hal_cuda_timeline_pool_release(semaphore->timeline_pool,
+                                        semaphore->timeline,
+                                        semaphore->timeline_stream_count,
+                                        events);
+  }
+  iree_status_ignore(semaphore->failure_status);
+  iree_slim_mutex_deinitialize(&semaphore->mutex);
+  iree_notification_deinitialize(&semaphore->notification);
   iree_allocator_free(host_allocator, semaphore);
 
   IREE_TRACE_ZONE_END(z0);
 }
 
+// Returns the first pending timepoint that reaches |value| or NULL if none
+// has been enqueued. Must be called with the lock held.
+static iree_hal_cuda_timepoint_t* iree_hal_cuda_semaphore_find_timepoint(
+    iree_hal_cuda_semaphore_t* semaphore, uint64_t value) {
+  for (iree_host_size_t i = 0; i < semaphore->timepoint_count; ++i) {
+    iree_hal_cuda_timepoint_t* timepoint =
+        &semaphore->timepoints[(semaphore->timepoint_head + i) %
+                               IREE_HAL_CUDA_SEMAPHORE_MAX_TIMEPOINTS];
+    if (timepoint->value >= value) return timepoint;
+  }
+  return NULL;
+}
+
+// Returns true if |waiter| is satisfied by the current state of |semaphore|.
+// Must be called with the lock held.
+static bool iree_hal_cuda_semaphore_is_satisfied(
+    iree_hal_cuda_semaphore_t* semaphore,
+    const iree_hal_cuda_semaphore_waiter_t* waiter) {
+  if (!iree_status_is_ok(semaphore->failure_status) ||
+      semaphore->current_value >= waiter->value) {
+    return true;
+  }
+  if (waiter->kind == IREE_HAL_CUDA_SEMAPHORE_WAITER_KIND_ENQUEUEABLE) {
+    return semaphore->timeline.host_ptr ||
+           iree_hal_cuda_semaphore_find_timepoint(semaphore, waiter->value);
+  }
+  return false;
+}
+
+// Notifies and unregisters all waiters satisfied by the current state of
+// |semaphore|. Must be called with the lock held.
+static void iree_hal_cuda_semaphore_notify_waiters(
+    iree_hal_cuda_semaphore_t* semaphore) {
+  iree_hal_cuda_semaphore_waiter_t** link = &semaphore->waiter_head;
+  while (*link) {
+    iree_hal_cuda_semaphore_waiter_t* waiter = *link;
+    if (iree_hal_cuda_semaphore_is_satisfied(semaphore, waiter)) {
+      *link = waiter->next;
+      waiter->next = NULL;
+      waiter->callback(waiter->user_data);
+    } else {
+      link = &waiter->next;
+    }
+  }
+}
+
+// Retires all completed timepoints from the front of the list and updates the
+// current value. Must be called with the lock held.
+static void iree_hal_cuda_semaphore_retire_timepoints(
+    iree_hal_cuda_semaphore_t* semaphore) {
+  iree_hal_cuda_dynamic_symbols_t* syms = semaphore->context->syms;
+  bool changed = false;
+  if (semaphore->timeline.host_ptr) {
+    uint64_t timeline_value = (uint64_t)iree_atomic_load_int64(
+        semaphore->timeline.host_ptr, iree_memory_order_acquire);
+    if (timeline_value > semaphore->current_value &&
+        iree_status_is_ok(semaphore->failure_status)) {
+      semaphore->current_value = timeline_value;
+      changed = true;
+    }
+  }
+  while (semaphore->timepoint_count > 0) {
+    iree_hal_cuda_timepoint_t* timepoint =
+        &semaphore->timepoints[semaphore->timepoint_head];
+    CUresult result = syms->cuEventQuery(timepoint->event->event);
+    if (result == CUDA_ERROR_NOT_READY) break;
+    if (result != CUDA_SUCCESS &&
+        iree_status_is_ok(semaphore->failure_status)) {
+      semaphore->failure_status =
+          iree_hal_cuda_result_to_status(syms, result, __FILE__, __LINE__);
+    }
+    semaphore->current_value =
+        iree_max(semaphore->current_value, timepoint->value);
+    iree_hal_cuda_timepoint_event_release(semaphore, timepoint->event);
+    timepoint->event = NULL;
+    semaphore->timepoint_head = (semaphore->timepoint_head + 1) %
+                                IREE_HAL_CUDA_SEMAPHORE_MAX_TIMEPOINTS;
+    --semaphore->timepoint_count;
+    changed = true;
+  }
+  if (changed) {
+    iree_hal_cuda_semaphore_notify_waiters(semaphore);
+    iree_notification_post(&semaphore->notification, IREE_ALL_WAITERS);
+  }
+}
+
+bool iree_hal_cuda_semaphore_add_waiter(
+    iree_hal_semaphore_t* base_semaphore,
+    iree_hal_cuda_semaphore_waiter_t* waiter) {
+  iree_hal_cuda_semaphore_t* semaphore =
+      iree_hal_cuda_semaphore_cast(base_semaphore);
+  iree_slim_mutex_lock(&semaphore->mutex);
+  iree_hal_cuda_semaphore_retire_timepoints(semaphore);
+  bool added = !iree_hal_cuda_semaphore_is_satisfied(semaphore, waiter);
+  if (added) {
+    waiter->next = semaphore->waiter_head;
+    semaphore->waiter_head = waiter;
+  }
+  iree_slim_mutex_unlock(&semaphore->mutex);
+  return added;
+}
+
+bool iree_hal_cuda_semaphore_is_wait_enqueueable(
+    iree_hal_semaphore_t* base_semaphore, uint64_t value) {
+  iree_hal_cuda_semaphore_t* semaphore =
+      iree_hal_cuda_semaphore_cast(base_semaphore);
+  iree_hal_cuda_semaphore_waiter_t waiter = {
+      .kind = IREE_HAL_CUDA_SEMAPHORE_WAITER_KIND_ENQUEUEABLE,
+      .value = value,
+  };
+  iree_slim_mutex_lock(&semaphore->mutex);
+  bool enqueueable = iree_hal_cuda_semaphore_is_satisfied(semaphore, &waiter);
+  iree_slim_mutex_unlock(&semaphore->mutex);
+  return enqueueable;
+}
+
+void iree_hal_cuda_semaphore_remove_waiter(
+    iree_hal_semaphore_t* base_semaphore,
+    iree_hal_cuda_semaphore_waiter_t* waiter) {
+  iree_hal_cuda_semaphore_t* semaphore =
+      iree_hal_cuda_semaphore_cast(base_semaphore);
+  iree_slim_mutex_lock(&semaphore->mutex);
+  for (iree_hal_cuda_semaphore_waiter_t** link = &semaphore->waiter_head;
+       *link; link = &(*link)->next) {
+    if (*link == waiter) {
+      *link = waiter->next;
+      waiter->next = NULL;
+      break;
+    }
+  }
+  iree_slim_mutex_unlock(&semaphore->mutex);
+}
+
 static iree_status_t iree_hal_cuda_semaphore_query(
     iree_hal_semaphore_t* base_semaphore, uint64_t* out_value) {
-  // TODO: Support semaphores completely.
-  *out_value = 0;
-  return iree_make_status(IREE_STATUS_UNIMPLEMENTED, "Not impemented on CUDA");
+  iree_hal_cuda_semaphore_t* semaphore =
+      iree_hal_cuda_semaphore_cast(base_semaphore);
+  iree_slim_mutex_lock(&semaphore->mutex);
+  iree_hal_cuda_semaphore_retire_timepoints(semaphore);
+  *out_value = semaphore->current_value;
+  iree_status_t status = iree_status_clone(semaphore->failure_status);
+  iree_slim_mutex_unlock(&semaphore->mutex);
+  return status;
 }
 
 static iree_status_t iree_hal_cuda_semaphore_signal(
     iree_hal_semaphore_t* base_semaphore, uint64_t new_value) {
-  // TODO: Support semaphores completely. Return OK currently as everything is
-  // synchronized for each submit to allow things to run.
-  return iree_ok_status();
+  iree_hal_cuda_semaphore_t* semaphore =
+      iree_hal_cuda_semaphore_cast(base_semaphore);
+  iree_slim_mutex_lock(&semaphore->mutex);
+  // Observe device writes that have landed so they are not overwritten.
+  iree_hal_cuda_semaphore_retire_timepoints(semaphore);
+  iree_status_t status = iree_status_clone(semaphore->failure_status);
+  if (iree_status_is_ok(status) && new_value <= semaphore->current_value) {
+    status = iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                              "semaphore values must be monotonically "
+                              "increasing; current_value=%" PRIu64
+                              ", new_value=%" PRIu64,
+                              semaphore->current_value, new_value);
+  }
+  if (iree_status_is_ok(status)) {
+    semaphore->current_value = new_value;
+    if (semaphore->timeline.host_ptr) {
+      // Releases any device waits enqueued on the value. A device write
+      // landing concurrently may already have moved the payload past it.
+      int64_t payload = iree_atomic_load_int64(semaphore->timeline.host_ptr,
+                                               iree_memory_order_relaxed);
+      while (payload < (int64_t)new_value &&
+             !iree_atomic_compare_exchange_strong_int64(
+                 semaphore->timeline.host_ptr, &payload, (int64_t)new_value,
+                 iree_memory_order_release, iree_memory_order_relaxed)) {
+      }
+    }
+    iree_hal_cuda_semaphore_notify_waiters(semaphore);
+  }
+  iree_slim_mutex_unlock(&semaphore->mutex);
+  if (iree_status_is_ok(status)) {
+    iree_notification_post(&semaphore->notification, IREE_ALL_WAITERS);
+  }
+  return status;
 }
 
 static void iree_hal_cuda_semaphore_fail(iree_hal_semaphore_t* base_semaphore,
-                                         iree_status_t status) {}
+                                         iree_status_t status) {
+  iree_hal_cuda_semaphore_t* semaphore =
+      iree_hal_cuda_semaphore_cast(base_semaphore);
+  iree_slim_mutex_lock(&semaphore->mutex);
+  if (iree_status_is_ok(semaphore->failure_status)) {
+    semaphore->failure_status = status;
+    if (semaphore->timeline.host_ptr) {
+      // Release device waits so that the streams do not hang; the work they
+      // guard may observe invalid results but the failure is sticky and
+      // reported to anyone querying the semaphore.
+      iree_atomic_store_int64(semaphore->timeline.host_ptr,
+                              (int64_t)IREE_HAL_CUDA_SEMAPHORE_FAILURE_VALUE,
+                              iree_memory_order_release);
+    }
+    iree_hal_cuda_semaphore_notify_waiters(semaphore);
+  } else {
+    iree_status_ignore(status);
+  }
+  iree_slim_mutex_unlock(&semaphore->mutex);
+  iree_notification_post(&semaphore->notification, IREE_ALL_WAITERS);
+}
+
+static void iree_hal_cuda_semaphore_set_event(void* user_data) {
+  iree_event_set((iree_event_t*)user_data);
+}
+
+iree_status_t iree_hal_cuda_semaphore_wait_any(
+    const iree_hal_semaphore_list_t* semaphore_list, iree_timeout_t timeout,
+    iree_allocator_t host_allocator) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
+
+  iree_hal_cuda_semaphore_waiter_t* waiters = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator,
+                                semaphore_list->count * sizeof(*waiters),
+                                (void**)&waiters));
+  iree_event_t event;
+  iree_status_t status = iree_event_initialize(/*initial_state=*/false, &event);
+  if (!iree_status_is_ok(status)) {
+    iree_allocator_free(host_allocator, waiters);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+
+  bool satisfied = false;
+  while (iree_status_is_ok(status) && !satisfied) {
+    // Register with each semaphore until one is found to be satisfied. Any
+    // signal made after registering sets the event.
+    bool poll = false;
+    iree_host_size_t added_count = 0;
+    for (; added_count < semaphore_list->count; ++added_count) {
+      iree_hal_cuda_semaphore_t* semaphore =
+          iree_hal_cuda_semaphore_cast(semaphore_list->semaphores[added_count]);
+      iree_hal_cuda_semaphore_waiter_t* waiter = &waiters[added_count];
+      waiter->next = NULL;
+      waiter->kind = IREE_HAL_CUDA_SEMAPHORE_WAITER_KIND_REACHED;
+      waiter->value = semaphore_list->payload_values[added_count];
+      waiter->callback = iree_hal_cuda_semaphore_set_event;
+      waiter->user_data = &event;
+      iree_slim_mutex_lock(&semaphore->mutex);
+      iree_hal_cuda_semaphore_retire_timepoints(semaphore);
+      if (iree_hal_cuda_semaphore_is_satisfied(semaphore, waiter)) {
+        status = iree_status_clone(semaphore->failure_status);
+        satisfied = true;
+        iree_slim_mutex_unlock(&semaphore->mutex);
+        break;
+      }
+      waiter->next = semaphore->waiter_head;
+      semaphore->waiter_head = waiter;
+      // Without host functions device signals are only observed by retiring.
+      poll |= !semaphore->host_signal_channel &&
+              iree_hal_cuda_semaphore_find_timepoint(semaphore, waiter->value);
+      iree_slim_mutex_unlock(&semaphore->mutex);
+    }
+
+    if (!satisfied) {
+      iree_time_t now_ns = iree_time_now();
+      if (now_ns >= deadline_ns) {
+        status = iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+      } else {
+        iree_time_t wait_deadline_ns =
+            poll ? iree_min(deadline_ns,
+                            now_ns + IREE_HAL_CUDA_SEMAPHORE_POLL_INTERVAL_NS)
+                 : deadline_ns;
+        // Timeouts are handled on the next iteration.
+        iree_status_ignore(iree_wait_one(&event, wait_deadline_ns));
+      }
+    }
+
+    for (iree_host_size_t i = 0; i < added_count; ++i) {
+      iree_hal_cuda_semaphore_remove_waiter(semaphore_list->semaphores[i],
+                                            &waiters[i]);
+    }
+    iree_event_reset(&event);
+  }
+
+  iree_event_deinitialize(&event);
+  iree_allocator_free(host_allocator, waiters);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
 
 static iree_status_t iree_hal_cuda_semaphore_wait(
     iree_hal_semaphore_t* base_semaphore, uint64_t value,
     iree_timeout_t timeout) {
-  // TODO: Support semaphores completely. Return OK currently as everything is
-  // synchronized for each submit to allow things to run.
+  iree_hal_cuda_semaphore_t* semaphore =
+      iree_hal_cuda_semaphore_cast(base_semaphore);
+  iree_hal_cuda_dynamic_symbols_t* syms = semaphore->context->syms;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Block on the event of the device signal reaching the value, if any. CUDA
+  // has no timed event wait so this is only done for infinite timeouts.
+  while (iree_timeout_as_deadline_ns(timeout) == IREE_TIME_INFINITE_FUTURE) {
+    iree_slim_mutex_lock(&semaphore->mutex);
+    iree_hal_cuda_semaphore_retire_timepoints(semaphore);
+    iree_hal_cuda_timepoint_t* timepoint =
+        iree_status_is_ok(semaphore->failure_status) &&
+                semaphore->current_value < value
+            ? iree_hal_cuda_semaphore_find_timepoint(semaphore, value)
+            : NULL;
+    if (!timepoint) {
+      iree_slim_mutex_unlock(&semaphore->mutex);
+      break;
+    }
+    // Retiring on the next iteration will pick up the new value. The
+    // reference keeps the event alive if another thread retires the timepoint
+    // while we are waiting.
+    iree_hal_cuda_timepoint_event_t* event = timepoint->event;
+    ++event->ref_count;
+    iree_slim_mutex_unlock(&semaphore->mutex);
+    CUDA_IGNORE_ERROR(syms, cuEventSynchronize(event->event));
+    iree_slim_mutex_lock(&semaphore->mutex);
+    iree_hal_cuda_timepoint_event_release(semaphore, event);
+    iree_slim_mutex_unlock(&semaphore->mutex);
+  }
+
+  // Wait for a host signal (or a device signal enqueued after this point).
+  iree_hal_semaphore_list_t semaphore_list = {
+      .count = 1,
+      .semaphores = &base_semaphore,
+      .payload_values = &value,
+  };
+  iree_status_t status = iree_hal_cuda_semaphore_wait_any(
+      &semaphore_list, timeout, semaphore->context->host_allocator);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Records an event on |stream| after the operations it has enqueued on the
+// device timeline so that the payload is not reused before they complete.
+// Must be called with the lock held.
+static iree_status_t iree_hal_cuda_semaphore_record_timeline_use(
+    iree_hal_cuda_semaphore_t* semaphore, CUstream stream) {
+  iree_hal_cuda_dynamic_symbols_t* syms = semaphore->context->syms;
+  iree_hal_cuda_timeline_stream_t* timeline_stream = NULL;
+  for (iree_host_size_t i = 0; i < semaphore->timeline_stream_count; ++i) {
+    if (semaphore->timeline_streams[i].stream == stream) {
+      timeline_stream = &semaphore->timeline_streams[i];
+      break;
+    }
+  }
+  if (!timeline_stream && semaphore->timeline_stream_count <
+                              IREE_HAL_CUDA_SEMAPHORE_MAX_TIMELINE_STREAMS) {
+    timeline_stream =
+        &semaphore->timeline_streams[semaphore->timeline_stream_count];
+    IREE_RETURN_IF_ERROR(CU_RESULT_TO_STATUS(
+        syms, cuEventCreate(&timeline_stream->event, CU_EVENT_DISABLE_TIMING),
+        "cuEventCreate"));
+    timeline_stream->stream = stream;
+    ++semaphore->timeline_stream_count;
+  } else if (!timeline_stream) {
+    // Out of entries; wait for the oldest stream and reuse its event.
+    timeline_stream = &semaphore->timeline_streams[0];
+    IREE_RETURN_IF_ERROR(CU_RESULT_TO_STATUS(
+        syms, cuEventSynchronize(timeline_stream->event),
+        "cuEventSynchronize"));
+    CUevent event = timeline_stream->event;
+    memmove(&semaphore->timeline_streams[0], &semaphore->timeline_streams[1],
+            (semaphore->timeline_stream_count - 1) *
+                sizeof(semaphore->timeline_streams[0]));
+    timeline_stream =
+        &semaphore->timeline_streams[semaphore->timeline_stream_count - 1];
+    timeline_stream->stream = stream;
+    timeline_stream->event = event;
+  }
+  return CU_RESULT_TO_STATUS(
+      syms, cuEventRecord(timeline_stream->event, stream), "cuEventRecord");
+}
+
+iree_status_t iree_hal_cuda_semaphore_enqueue_wait(
+    iree_hal_semaphore_t* base_semaphore, uint64_t value, CUstream stream) {
+  iree_hal_cuda_semaphore_t* semaphore =
+      iree_hal_cuda_semaphore_cast(base_semaphore);
+  iree_slim_mutex_lock(&semaphore->mutex);
+  iree_hal_cuda_semaphore_retire_timepoints(semaphore);
+  iree_status_t status = iree_status_clone(semaphore->failure_status);
+  if (!iree_status_is_ok(status) || semaphore->current_value >= value) {
+    iree_slim_mutex_unlock(&semaphore->mutex);
+    return status;
+  }
+  if (semaphore->timeline.host_ptr) {
+    // The wait is resolved on the device whenever the payload is written so
+    // the value need not have been signaled by any submission yet.
+    status = CU_RESULT_TO_STATUS(
+        semaphore->context->syms,
+        cuStreamWaitValue64(stream, semaphore->timeline.device_ptr, value,
+                            CU_STREAM_WAIT_VALUE_GEQ),
+        "cuStreamWaitValue64");
+    if (iree_status_is_ok(status)) {
+      status = iree_hal_cuda_semaphore_record_timeline_use(semaphore, stream);
+    }
+    iree_slim_mutex_unlock(&semaphore->mutex);
+    return status;
+  }
+  iree_hal_cuda_timepoint_t* timepoint =
+      iree_hal_cuda_semaphore_find_timepoint(semaphore, value);
+  if (timepoint) {
+    status = CU_RESULT_TO_STATUS(
+        semaphore->context->syms,
+        cuStreamWaitEvent(stream, timepoint->event->event, /*flags=*/0),
+        "cuStreamWaitEvent");
+    iree_slim_mutex_unlock(&semaphore->mutex);
+    return status;
+  }
+  iree_slim_mutex_unlock(&semaphore->mutex);
+  return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                          "no device signal of value %" PRIu64
+                          " has been enqueued; the wait must be deferred",
+                          value);
+}
+
+// Launches a host function on |stream| reporting the signal of |semaphore| to
+// |value| to host waiters.
+static iree_status_t iree_hal_cuda_semaphore_launch_host_signal(
+    iree_hal_cuda_semaphore_t* semaphore, uint64_t value, CUstream stream) {
+  iree_hal_cuda_host_signal_channel_t* channel = semaphore->host_signal_channel;
+  iree_hal_cuda_host_signal_t* host_signal = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      channel->host_allocator, sizeof(*host_signal), (void**)&host_signal));
+  host_signal->channel = channel;
+  host_signal->value = value;
+  iree_atomic_ref_count_inc(&channel->ref_count);
+  iree_status_t status = CU_RESULT_TO_STATUS(
+      semaphore->context->syms,
+      cuLaunchHostFunc(stream, iree_hal_cuda_semaphore_host_signal,
+                       host_signal),
+      "cuLaunchHostFunc");
+  if (!iree_status_is_ok(status)) {
+    iree_allocator_free(channel->host_allocator, host_signal);
+    iree_hal_cuda_host_signal_channel_release(channel);
+  }
+  return status;
+}
+
+iree_status_t iree_hal_cuda_semaphore_enqueue_signal(
+    iree_hal_semaphore_t* base_semaphore, uint64_t value, CUstream stream) {
+  iree_hal_cuda_semaphore_t* semaphore =
+      iree_hal_cuda_semaphore_cast(base_semaphore);
+  iree_hal_cuda_dynamic_symbols_t* syms = semaphore->context->syms;
+
+  iree_slim_mutex_lock(&semaphore->mutex);
+  iree_status_t status = iree_ok_status();
+  uint64_t last_value =
+      iree_max(semaphore->last_write_value, semaphore->current_value);
+  if (value <= last_value) {
+    status = iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                              "semaphore values must be monotonically "
+                              "increasing; last_value=%" PRIu64
+                              ", new_value=%" PRIu64,
+                              last_value, value);
+  }
+  if (iree_status_is_ok(status) && semaphore->timeline.host_ptr) {
+    if (semaphore->last_write_stream &&
+        semaphore->last_write_stream != stream) {
+      // Streams are unordered with respect to each other: without this a
+      // write from a stream running ahead could be overwritten by the
+      // earlier value from another stream.
+      status = CU_RESULT_TO_STATUS(
+          syms,
+          cuStreamWaitValue64(stream, semaphore->timeline.device_ptr,
+                              semaphore->last_write_value,
+                              CU_STREAM_WAIT_VALUE_GEQ),
+          "cuStreamWaitValue64");
+    }
+    if (iree_status_is_ok(status)) {
+      status = CU_RESULT_TO_STATUS(
+          syms,
+          cuStreamWriteValue64(stream, semaphore->timeline.device_ptr, value,
+                               CU_STREAM_WRITE_VALUE_DEFAULT),
+          "cuStreamWriteValue64");
+    }
+    if (iree_status_is_ok(status)) {
+      status = iree_hal_cuda_semaphore_record_timeline_use(semaphore, stream);
+    }
+  }
+  if (iree_status_is_ok(status)) {
+    semaphore->last_write_stream = stream;
+    semaphore->last_write_value = value;
+  }
+  iree_slim_mutex_unlock(&semaphore->mutex);
+  IREE_RETURN_IF_ERROR(status);
+
+  // The event lets host waits block instead of polling the payload.
+  iree_hal_cuda_timepoint_event_t* event = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      semaphore->context->host_allocator, sizeof(*event), (void**)&event));
+  event->ref_count = 1;
+  event->event = NULL;
+  status = CU_RESULT_TO_STATUS(
+      syms, cuEventCreate(&event->event, CU_EVENT_DISABLE_TIMING),
+      "cuEventCreate");
+  if (iree_status_is_ok(status)) {
+    status = CU_RESULT_TO_STATUS(syms, cuEventRecord(event->event, stream),
+                                 "cuEventRecord");
+    if (!iree_status_is_ok(status)) {
+      CUDA_IGNORE_ERROR(syms, cuEventDestroy(event->event));
+    }
+  }
+  if (!iree_status_is_ok(status)) {
+    iree_allocator_free(semaphore->context->host_allocator, event);
+    return status;
+  }
+
+  // Report the signal to host waiters as soon as the stream reaches it.
+  if (semaphore->host_signal_channel) {
+    status = iree_hal_cuda_semaphore_launch_host_signal(semaphore, value,
+                                                        stream);
+    if (!iree_status_is_ok(status)) {
+      CUDA_IGNORE_ERROR(syms, cuEventDestroy(event->event));
+      iree_allocator_free(semaphore->context->host_allocator, event);
+      return status;
+    }
+  }
+
+  iree_slim_mutex_lock(&semaphore->mutex);
+  iree_hal_cuda_semaphore_retire_timepoints(semaphore);
+  while (semaphore->timepoint_count == IREE_HAL_CUDA_SEMAPHORE_MAX_TIMEPOINTS) {
+    // Too many signals in flight; wait for the oldest to make room.
+    CUDA_IGNORE_ERROR(
+        syms,
+        cuEventSynchronize(
+            semaphore->timepoints[semaphore->timepoint_head].event->event));
+    iree_hal_cuda_semaphore_retire_timepoints(semaphore);
+  }
+  iree_hal_cuda_timepoint_t* timepoint =
+      &semaphore->timepoints[(semaphore->timepoint_head +
+                              semaphore->timepoint_count) %
+                             IREE_HAL_CUDA_SEMAPHORE_MAX_TIMEPOINTS];
+  timepoint->value = value;
+  timepoint->event = event;
+  ++semaphore->timepoint_count;
+  // Device waits on the value may now be enqueued.
+  iree_hal_cuda_semaphore_notify_waiters(semaphore);
+  iree_slim_mutex_unlock(&semaphore->mutex);
+  // Wake host waiters so they can wait on the event instead.
+  iree_notification_post(&semaphore->notification, IREE_ALL_WAITERS);
   return iree_ok_status();
 }
 
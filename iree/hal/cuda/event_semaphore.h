@@ -13,16 +13,99 @@
 #include "iree/hal/api.h"
 #include "iree/hal/cuda/context_wrapper.h"
 #include "iree/hal/cuda/status_util.h"
+#include "iree/hal/cuda/timeline_pool.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif  // __cplusplus
 
-// Create a cuda allocator.
+// Creates a timeline semaphore backed by CUDA events.
+// Device signals are recorded as events on the signaling stream and device
+// waits are enqueued as cuStreamWaitEvent on the waiting stream so that work
+// on different streams can be ordered without host round-trips. When the
+// driver supports it a host function launched after each device signal wakes
+// host waiters without polling.
+//
+// If |timeline_pool| is not NULL the payload is also stored in a slot of
+// mapped host memory suballocated from the pool that device signals write with
+// cuStreamWriteValue64 and device waits poll with cuStreamWaitValue64. This
+// allows waits to be enqueued for values that have not yet been signaled by
+// any submission, including values that will be signaled from the host.
+// Device signals must be enqueued in increasing value order; a signal from a
+// stream other than the one that enqueued the previous signal first waits for
+// the previous value so that the payload never moves backwards. Requires the
+// device to support 64-bit stream memory operations; see
+// iree_hal_cuda_semaphore_is_device_timeline_supported.
 iree_status_t iree_hal_cuda_semaphore_create(
-    iree_hal_cuda_context_wrapper_t* context, uint64_t initial_value,
+    iree_hal_cuda_context_wrapper_t* context,
+    iree_hal_cuda_timeline_pool_t* timeline_pool, uint64_t initial_value,
     iree_hal_semaphore_t** out_semaphore);
 
+// Returns true if |device| supports the stream memory operations required for
+// semaphores created with a timeline pool.
+bool iree_hal_cuda_semaphore_is_device_timeline_supported(
+    iree_hal_cuda_dynamic_symbols_t* syms, CUdevice device);
+
+// Determines when a semaphore waiter is notified.
+typedef enum iree_hal_cuda_semaphore_waiter_kind_e {
+  // Notified when the semaphore reaches the value or fails.
+  IREE_HAL_CUDA_SEMAPHORE_WAITER_KIND_REACHED = 0,
+  // Notified as soon as a wait for the value can be enqueued on a stream with
+  // iree_hal_cuda_semaphore_enqueue_wait: when device work signaling the value
+  // has been enqueued or the value has been reached or the semaphore fails.
+  IREE_HAL_CUDA_SEMAPHORE_WAITER_KIND_ENQUEUEABLE = 1,
+} iree_hal_cuda_semaphore_waiter_kind_t;
+
+// A waiter notified once when a semaphore satisfies it.
+// Waiters are owned by the caller and must remain valid until notified or
+// removed. |callback| is made with the semaphore lock held, possibly from a
+// CUDA internal thread, and must only wake whoever is waiting: it must not
+// call back into the semaphore or make CUDA API calls.
+typedef struct iree_hal_cuda_semaphore_waiter_t {
+  struct iree_hal_cuda_semaphore_waiter_t* next;
+  iree_hal_cuda_semaphore_waiter_kind_t kind;
+  uint64_t value;
+  void (*callback)(void* user_data);
+  void* user_data;
+} iree_hal_cuda_semaphore_waiter_t;
+
+// Registers |waiter| with |semaphore| until it is satisfied.
+// Returns false without registering the waiter if it is already satisfied.
+bool iree_hal_cuda_semaphore_add_waiter(
+    iree_hal_semaphore_t* semaphore, iree_hal_cuda_semaphore_waiter_t* waiter);
+
+// Unregisters |waiter| from |semaphore| if it has not yet been notified.
+// The waiter callback will not be made once this returns.
+void iree_hal_cuda_semaphore_remove_waiter(
+    iree_hal_semaphore_t* semaphore, iree_hal_cuda_semaphore_waiter_t* waiter);
+
+// Blocks the caller until any of the semaphores in |semaphore_list| reaches
+// its value, one fails, or the |timeout| elapses. Host signals wake the caller
+// immediately; device signals do as well when the driver supports host
+// function launches and are otherwise observed at a polling interval.
+iree_status_t iree_hal_cuda_semaphore_wait_any(
+    const iree_hal_semaphore_list_t* semaphore_list, iree_timeout_t timeout,
+    iree_allocator_t host_allocator);
+
+// Returns true if a wait for |semaphore| to reach |value| can be enqueued on a
+// stream. Once true remains true.
+bool iree_hal_cuda_semaphore_is_wait_enqueueable(
+    iree_hal_semaphore_t* semaphore, uint64_t value);
+
+// Enqueues a wait on |stream| for |semaphore| to reach |value|.
+// The wait must be enqueueable: the semaphore must use a device timeline or
+// the value must have been reached or signaled by enqueued device work. Use an
+// IREE_HAL_CUDA_SEMAPHORE_WAITER_KIND_ENQUEUEABLE waiter to defer the wait
+// until it is. Fails with IREE_STATUS_FAILED_PRECONDITION otherwise.
+iree_status_t iree_hal_cuda_semaphore_enqueue_wait(
+    iree_hal_semaphore_t* semaphore, uint64_t value, CUstream stream);
+
+// Enqueues a signal of |semaphore| to |value| once all work currently
+// enqueued on |stream| has completed. Fails with IREE_STATUS_OUT_OF_RANGE if
+// |value| does not exceed the value of the last signal.
+iree_status_t iree_hal_cuda_semaphore_enqueue_signal(
+    iree_hal_semaphore_t* semaphore, uint64_t value, CUstream stream);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
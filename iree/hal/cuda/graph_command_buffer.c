@@ -9,6 +9,7 @@
 #include <assert.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "iree/base/api.h"
 #include "iree/base/tracing.h"
@@ -18,6 +19,28 @@
 #include "iree/hal/cuda/native_executable.h"
 #include "iree/hal/cuda/status_util.h"
 
+// A fill or copy that has been recorded but not yet added to the graph.
+// Subsequent fills or copies extending it are merged into a single node so
+// that long runs of small transfers don't bloat the graph and with it the cost
+// of instantiation and launch.
+typedef enum iree_hal_cuda_graph_pending_op_type_e {
+  IREE_HAL_CUDA_GRAPH_PENDING_OP_NONE = 0,
+  IREE_HAL_CUDA_GRAPH_PENDING_OP_FILL,
+  IREE_HAL_CUDA_GRAPH_PENDING_OP_COPY,
+} iree_hal_cuda_graph_pending_op_type_t;
+
+typedef struct iree_hal_cuda_graph_pending_op_t {
+  iree_hal_cuda_graph_pending_op_type_t type;
+  // Absolute device address of the first byte written.
+  CUdeviceptr target;
+  // Absolute device address of the first byte read (copies only).
+  CUdeviceptr source;
+  iree_device_size_t length;
+  // Splatted fill pattern and its original element size (fills only).
+  uint32_t pattern;
+  iree_host_size_t pattern_length;
+} iree_hal_cuda_graph_pending_op_t;
+
 // Command buffer implementation that directly maps to cuda graph.
 // This records the commands on the calling thread without additional threading
 // indirection.
@@ -27,11 +50,18 @@ typedef struct iree_hal_cuda_graph_command_buffer_t {
   iree_hal_command_buffer_mode_t mode;
   iree_hal_command_category_t allowed_categories;
   iree_hal_queue_affinity_t queue_affinity;
+  iree_hal_cuda_graph_exec_cache_t* exec_cache;
   CUgraph graph;
   CUgraphExec exec;
+  // Topology hash of the graph |exec| was instantiated or updated from.
+  uint64_t exec_topology_hash;
+  // Running hash of the topology of the graph being recorded.
+  uint64_t topology_hash;
   // Keep track of the last node added to the command buffer as we are currently
   // serializing all the nodes (each node depends on the previous one).
   CUgraphNode last_node;
+  // Fill or copy waiting to be merged with subsequent ones.
+  iree_hal_cuda_graph_pending_op_t pending_op;
   // Keep track of the current set of kernel arguments.
   void* current_descriptor[];
 } iree_hal_cuda_graph_command_buffer_t;
@@ -47,8 +77,98 @@ iree_hal_cuda_graph_command_buffer_cast(iree_hal_command_buffer_t* base_value) {
   return (iree_hal_cuda_graph_command_buffer_t*)base_value;
 }
 
+//===----------------------------------------------------------------------===//
+// iree_hal_cuda_graph_exec_cache_t
+//===----------------------------------------------------------------------===//
+
+void iree_hal_cuda_graph_exec_cache_initialize(
+    iree_hal_cuda_context_wrapper_t* context, iree_host_size_t capacity,
+    iree_hal_cuda_graph_exec_cache_t* out_cache) {
+  memset(out_cache, 0, sizeof(*out_cache));
+  out_cache->context = context;
+  out_cache->capacity =
+      iree_min(capacity, IREE_HAL_CUDA_GRAPH_EXEC_CACHE_MAX_CAPACITY);
+  iree_slim_mutex_initialize(&out_cache->mutex);
+}
+
+void iree_hal_cuda_graph_exec_cache_deinitialize(
+    iree_hal_cuda_graph_exec_cache_t* cache) {
+  for (iree_host_size_t i = 0; i < cache->count; ++i) {
+    CUDA_IGNORE_ERROR(cache->context->syms,
+                      cuGraphExecDestroy(cache->entries[i].exec));
+  }
+  cache->count = 0;
+  iree_slim_mutex_deinitialize(&cache->mutex);
+}
+
+// Removes and returns the most recently released executable with
+// |topology_hash| from the cache, if any.
+static CUgraphExec iree_hal_cuda_graph_exec_cache_acquire(
+    iree_hal_cuda_graph_exec_cache_t* cache, uint64_t topology_hash) {
+  CUgraphExec exec = NULL;
+  iree_slim_mutex_lock(&cache->mutex);
+  for (iree_host_size_t i = cache->count; i > 0; --i) {
+    if (cache->entries[i - 1].topology_hash != topology_hash) continue;
+    exec = cache->entries[i - 1].exec;
+    memmove(&cache->entries[i - 1], &cache->entries[i],
+            (cache->count - i) * sizeof(cache->entries[0]));
+    --cache->count;
+    break;
+  }
+  iree_slim_mutex_unlock(&cache->mutex);
+  return exec;
+}
+
+// Retains the idle |exec| in the cache, evicting the least recently released
+// executable if the cache is full.
+static void iree_hal_cuda_graph_exec_cache_release(
+    iree_hal_cuda_graph_exec_cache_t* cache, uint64_t topology_hash,
+    CUgraphExec exec) {
+  CUgraphExec evicted_exec = exec;
+  iree_slim_mutex_lock(&cache->mutex);
+  if (cache->capacity > 0) {
+    evicted_exec = NULL;
+    if (cache->count == cache->capacity) {
+      evicted_exec = cache->entries[0].exec;
+      memmove(&cache->entries[0], &cache->entries[1],
+              (cache->count - 1) * sizeof(cache->entries[0]));
+      --cache->count;
+    }
+    cache->entries[cache->count].topology_hash = topology_hash;
+    cache->entries[cache->count].exec = exec;
+    ++cache->count;
+  }
+  iree_slim_mutex_unlock(&cache->mutex);
+  if (evicted_exec) {
+    CUDA_IGNORE_ERROR(cache->context->syms, cuGraphExecDestroy(evicted_exec));
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_cuda_graph_command_buffer_t
+//===----------------------------------------------------------------------===//
+
+// FNV-1a basis used to seed topology hashes.
+#define IREE_HAL_CUDA_GRAPH_TOPOLOGY_HASH_SEED 0xCBF29CE484222325ull
+
+// Folds a node of |node_type| into the running topology hash. Kernel nodes
+// include their function as executables can only be updated with functions
+// from the same context and we'd rather not attempt updates likely to fail.
+static void iree_hal_cuda_graph_command_buffer_hash_node(
+    iree_hal_cuda_graph_command_buffer_t* command_buffer,
+    CUgraphNodeType node_type, uint64_t node_key) {
+  uint64_t values[2] = {(uint64_t)node_type, node_key};
+  const uint8_t* bytes = (const uint8_t*)values;
+  uint64_t hash = command_buffer->topology_hash;
+  for (iree_host_size_t i = 0; i < sizeof(values); ++i) {
+    hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+  }
+  command_buffer->topology_hash = hash;
+}
+
 iree_status_t iree_hal_cuda_graph_command_buffer_create(
     iree_hal_cuda_context_wrapper_t* context,
+    iree_hal_cuda_graph_exec_cache_t* exec_cache,
     iree_hal_command_buffer_mode_t mode,
     iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity,
@@ -70,12 +190,16 @@ iree_status_t iree_hal_cuda_graph_command_buffer_create(
     iree_hal_resource_initialize(&iree_hal_cuda_graph_command_buffer_vtable,
                                  &command_buffer->resource);
     command_buffer->context = context;
+    command_buffer->exec_cache = exec_cache;
     command_buffer->mode = mode;
     command_buffer->allowed_categories = command_categories;
     command_buffer->queue_affinity = queue_affinity;
     command_buffer->graph = graph;
     command_buffer->exec = NULL;
+    command_buffer->exec_topology_hash = 0;
+    command_buffer->topology_hash = IREE_HAL_CUDA_GRAPH_TOPOLOGY_HASH_SEED;
     command_buffer->last_node = NULL;
+    memset(&command_buffer->pending_op, 0, sizeof(command_buffer->pending_op));
 
     CUdeviceptr* device_ptrs =
         (CUdeviceptr*)(command_buffer->current_descriptor +
@@ -104,8 +228,17 @@ static void iree_hal_cuda_graph_command_buffer_destroy(
                       cuGraphDestroy(command_buffer->graph));
   }
   if (command_buffer->exec != NULL) {
-    CUDA_IGNORE_ERROR(command_buffer->context->syms,
-                      cuGraphExecDestroy(command_buffer->exec));
+    if (command_buffer->exec_cache) {
+      // NOTE: the executable may still be in flight. Both updating and
+      // destroying an executable only affect future launches so it can be
+      // handed to another command buffer immediately.
+      iree_hal_cuda_graph_exec_cache_release(command_buffer->exec_cache,
+                                             command_buffer->exec_topology_hash,
+                                             command_buffer->exec);
+    } else {
+      CUDA_IGNORE_ERROR(command_buffer->context->syms,
+                        cuGraphExecDestroy(command_buffer->exec));
+    }
   }
   iree_allocator_free(command_buffer->context->host_allocator, command_buffer);
 
@@ -134,22 +267,181 @@ iree_hal_cuda_graph_command_buffer_allowed_categories(
   return command_buffer->allowed_categories;
 }
 
+// Adds the pending fill or copy, if any, to the graph.
+static iree_status_t iree_hal_cuda_graph_command_buffer_flush_pending_op(
+    iree_hal_cuda_graph_command_buffer_t* command_buffer) {
+  iree_hal_cuda_graph_pending_op_t* op = &command_buffer->pending_op;
+  if (op->type == IREE_HAL_CUDA_GRAPH_PENDING_OP_NONE) return iree_ok_status();
+
+  // Serialize all the nodes for now.
+  CUgraphNode dep[] = {command_buffer->last_node};
+  size_t numNode = command_buffer->last_node ? 1 : 0;
+  iree_status_t status = iree_ok_status();
+  if (op->type == IREE_HAL_CUDA_GRAPH_PENDING_OP_FILL) {
+    iree_hal_cuda_graph_command_buffer_hash_node(
+        command_buffer, CU_GRAPH_NODE_TYPE_MEMSET, op->pattern_length);
+    CUDA_MEMSET_NODE_PARAMS params = {
+        .dst = op->target,
+        .elementSize = op->pattern_length,
+        // width in number of elements despite what driver documentation says.
+        .width = op->length / op->pattern_length,
+        .height = 1,
+        .value = op->pattern,
+    };
+    status = CU_RESULT_TO_STATUS(
+        command_buffer->context->syms,
+        cuGraphAddMemsetNode(&command_buffer->last_node, command_buffer->graph,
+                             dep, numNode, &params,
+                             command_buffer->context->cu_context),
+        "cuGraphAddMemsetNode");
+  } else {
+    iree_hal_cuda_graph_command_buffer_hash_node(
+        command_buffer, CU_GRAPH_NODE_TYPE_MEMCPY, 0);
+    CUDA_MEMCPY3D params = {
+        .Depth = 1,
+        .Height = 1,
+        .WidthInBytes = op->length,
+        .dstDevice = op->target,
+        .srcDevice = op->source,
+        .srcMemoryType = CU_MEMORYTYPE_DEVICE,
+        .dstMemoryType = CU_MEMORYTYPE_DEVICE,
+    };
+    status = CU_RESULT_TO_STATUS(
+        command_buffer->context->syms,
+        cuGraphAddMemcpyNode(&command_buffer->last_node, command_buffer->graph,
+                             dep, numNode, &params,
+                             command_buffer->context->cu_context),
+        "cuGraphAddMemcpyNode");
+  }
+  op->type = IREE_HAL_CUDA_GRAPH_PENDING_OP_NONE;
+  return status;
+}
+
+// Records |new_op| merging it with the pending op if possible and otherwise
+// flushing the pending op and making |new_op| pending.
+static iree_status_t iree_hal_cuda_graph_command_buffer_record_op(
+    iree_hal_cuda_graph_command_buffer_t* command_buffer,
+    const iree_hal_cuda_graph_pending_op_t* new_op) {
+  iree_hal_cuda_graph_pending_op_t* op = &command_buffer->pending_op;
+  if (op->type == new_op->type &&
+      op->type == IREE_HAL_CUDA_GRAPH_PENDING_OP_FILL &&
+      op->pattern == new_op->pattern &&
+      op->pattern_length == new_op->pattern_length) {
+    // Fills of the same pattern touching at either end.
+    if (op->target + op->length == new_op->target) {
+      op->length += new_op->length;
+      return iree_ok_status();
+    } else if (new_op->target + new_op->length == op->target) {
+      op->target = new_op->target;
+      op->length += new_op->length;
+      return iree_ok_status();
+    }
+  } else if (op->type == new_op->type &&
+             op->type == IREE_HAL_CUDA_GRAPH_PENDING_OP_COPY &&
+             op->source + op->length == new_op->source &&
+             op->target + op->length == new_op->target) {
+    // Copies continuing both the source and target ranges. Only valid so long
+    // as the combined ranges don't overlap as the second copy may otherwise
+    // read bytes written by the first.
+    iree_device_size_t new_length = op->length + new_op->length;
+    if (op->source + new_length <= op->target ||
+        op->target + new_length <= op->source) {
+      op->length = new_length;
+      return iree_ok_status();
+    }
+  }
+  IREE_RETURN_IF_ERROR(
+      iree_hal_cuda_graph_command_buffer_flush_pending_op(command_buffer));
+  *op = *new_op;
+  return iree_ok_status();
+}
+
 static iree_status_t iree_hal_cuda_graph_command_buffer_begin(
     iree_hal_command_buffer_t* base_command_buffer) {
-  // Nothing to do.
+  iree_hal_cuda_graph_command_buffer_t* command_buffer =
+      iree_hal_cuda_graph_command_buffer_cast(base_command_buffer);
+  if (command_buffer->graph != NULL) return iree_ok_status();
+
+  // Re-recording after a previous end; start a new graph and keep the existing
+  // executable around to update at the end.
+  CUDA_RETURN_IF_ERROR(command_buffer->context->syms,
+                       cuGraphCreate(&command_buffer->graph, /*flags=*/0),
+                       "cuGraphCreate");
+  command_buffer->topology_hash = IREE_HAL_CUDA_GRAPH_TOPOLOGY_HASH_SEED;
+  command_buffer->last_node = NULL;
+  memset(&command_buffer->pending_op, 0, sizeof(command_buffer->pending_op));
   return iree_ok_status();
 }
 
+// Tries to update |exec| in place to match the recorded graph. Returns false if
+// the update is not supported or the graph is incompatible.
+static bool iree_hal_cuda_graph_command_buffer_try_update(
+    iree_hal_cuda_graph_command_buffer_t* command_buffer, CUgraphExec exec) {
+  iree_hal_cuda_dynamic_symbols_t* syms = command_buffer->context->syms;
+  if (!syms->cuGraphExecUpdate) return false;
+  IREE_TRACE_ZONE_BEGIN_NAMED(z0, "cuGraphExecUpdate");
+  CUgraphNode error_node = NULL;
+  CUgraphExecUpdateResult update_result = CU_GRAPH_EXEC_UPDATE_ERROR;
+  CUresult result = syms->cuGraphExecUpdate(exec, command_buffer->graph,
+                                            &error_node, &update_result);
+  IREE_TRACE_ZONE_END(z0);
+  return result == CUDA_SUCCESS &&
+         update_result == CU_GRAPH_EXEC_UPDATE_SUCCESS;
+}
+
 static iree_status_t iree_hal_cuda_graph_command_buffer_end(
     iree_hal_command_buffer_t* base_command_buffer) {
   iree_hal_cuda_graph_command_buffer_t* command_buffer =
       iree_hal_cuda_graph_command_buffer_cast(base_command_buffer);
+  IREE_RETURN_IF_ERROR(
+      iree_hal_cuda_graph_command_buffer_flush_pending_op(command_buffer));
 
   size_t num_nodes;
   CUDA_RETURN_IF_ERROR(command_buffer->context->syms,
                        cuGraphGetNodes(command_buffer->graph, NULL, &num_nodes),
                        "cuGraphGetNodes");
 
+  // Prefer updating an executable with the same topology in place: either the
+  // one from the previous recording of this command buffer or an idle one
+  // from the cache.
+  CUgraphExec exec = command_buffer->exec;
+  command_buffer->exec = NULL;
+  if (exec && command_buffer->exec_topology_hash !=
+                  command_buffer->topology_hash) {
+    if (command_buffer->exec_cache) {
+      iree_hal_cuda_graph_exec_cache_release(command_buffer->exec_cache,
+                                             command_buffer->exec_topology_hash,
+                                             exec);
+    } else {
+      CUDA_IGNORE_ERROR(command_buffer->context->syms,
+                        cuGraphExecDestroy(exec));
+    }
+    exec = NULL;
+  }
+  if (!exec && command_buffer->exec_cache) {
+    exec = iree_hal_cuda_graph_exec_cache_acquire(
+        command_buffer->exec_cache, command_buffer->topology_hash);
+  }
+  if (exec && !iree_hal_cuda_graph_command_buffer_try_update(command_buffer,
+                                                             exec)) {
+    CUDA_IGNORE_ERROR(command_buffer->context->syms, cuGraphExecDestroy(exec));
+    exec = NULL;
+  }
+  if (exec) {
+    command_buffer->exec = exec;
+    command_buffer->exec_topology_hash = command_buffer->topology_hash;
+    CUDA_IGNORE_ERROR(command_buffer->context->syms,
+                      cuGraphDestroy(command_buffer->graph));
+    command_buffer->graph = NULL;
+    return iree_ok_status();
+  }
+
+  // Instantiation cost scales with the node count and is what stream command
+  // buffers avoid; plot both so that the choice between graph and stream mode
+  // (use_deferred_submission) can be made from real workloads.
+  IREE_TRACE_ZONE_BEGIN_NAMED(z0, "cuGraphInstantiate");
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)num_nodes);
+  IREE_TRACE(iree_time_t instantiate_start_ns = iree_time_now());
   CUgraphNode error_node;
   iree_status_t status =
       CU_RESULT_TO_STATUS(command_buffer->context->syms,
@@ -157,12 +449,19 @@ static iree_status_t iree_hal_cuda_graph_command_buffer_end(
                                              command_buffer->graph, &error_node,
                                              /*logBuffer=*/NULL,
                                              /* bufferSize=*/0));
+  IREE_TRACE_PLOT_VALUE_I64("CUDA graph nodes", (int64_t)num_nodes);
+  IREE_TRACE_PLOT_VALUE_I64("CUDA graph instantiate ns",
+                            iree_time_now() - instantiate_start_ns);
+  IREE_TRACE_ZONE_END(z0);
   if (iree_status_is_ok(status)) {
-    CUDA_IGNORE_ERROR(command_buffer->context->syms,
-                      cuGraphDestroy(command_buffer->graph));
+    command_buffer->exec_topology_hash = command_buffer->topology_hash;
+  } else {
+    command_buffer->exec = NULL;
   }
+  CUDA_IGNORE_ERROR(command_buffer->context->syms,
+                    cuGraphDestroy(command_buffer->graph));
   command_buffer->graph = NULL;
-  return iree_ok_status();
+  return status;
 }
 
 static void iree_hal_cuda_graph_command_buffer_begin_debug_group(
@@ -260,25 +559,15 @@ static iree_status_t iree_hal_cuda_graph_command_buffer_fill_buffer(
   CUdeviceptr target_device_buffer = iree_hal_cuda_buffer_device_pointer(
       iree_hal_buffer_allocated_buffer(target_buffer));
   target_offset += iree_hal_buffer_byte_offset(target_buffer);
-  uint32_t dword_pattern = iree_hal_cuda_splat_pattern(pattern, pattern_length);
-  CUDA_MEMSET_NODE_PARAMS params = {
-      .dst = target_device_buffer + target_offset,
-      .elementSize = pattern_length,
-      // width in number of elements despite what driver documentation says.
-      .width = length / pattern_length,
-      .height = 1,
-      .value = dword_pattern,
+  iree_hal_cuda_graph_pending_op_t op = {
+      .type = IREE_HAL_CUDA_GRAPH_PENDING_OP_FILL,
+      .target = target_device_buffer + target_offset,
+      .source = 0,
+      .length = length,
+      .pattern = iree_hal_cuda_splat_pattern(pattern, pattern_length),
+      .pattern_length = pattern_length,
   };
-  // Serialize all the nodes for now.
-  CUgraphNode dep[] = {command_buffer->last_node};
-  size_t numNode = command_buffer->last_node ? 1 : 0;
-  CUDA_RETURN_IF_ERROR(
-      command_buffer->context->syms,
-      cuGraphAddMemsetNode(&command_buffer->last_node, command_buffer->graph,
-                           dep, numNode, &params,
-                           command_buffer->context->cu_context),
-      "cuGraphAddMemsetNode");
-  return iree_ok_status();
+  return iree_hal_cuda_graph_command_buffer_record_op(command_buffer, &op);
 }
 
 static iree_status_t iree_hal_cuda_graph_command_buffer_update_buffer(
@@ -303,27 +592,15 @@ static iree_status_t iree_hal_cuda_graph_command_buffer_copy_buffer(
   CUdeviceptr source_device_buffer = iree_hal_cuda_buffer_device_pointer(
       iree_hal_buffer_allocated_buffer(source_buffer));
   source_offset += iree_hal_buffer_byte_offset(source_buffer);
-  CUDA_MEMCPY3D params = {
-      .Depth = 1,
-      .Height = 1,
-      .WidthInBytes = length,
-      .dstDevice = target_device_buffer,
-      .srcDevice = source_device_buffer,
-      .srcXInBytes = source_offset,
-      .dstXInBytes = target_offset,
-      .srcMemoryType = CU_MEMORYTYPE_DEVICE,
-      .dstMemoryType = CU_MEMORYTYPE_DEVICE,
+  iree_hal_cuda_graph_pending_op_t op = {
+      .type = IREE_HAL_CUDA_GRAPH_PENDING_OP_COPY,
+      .target = target_device_buffer + target_offset,
+      .source = source_device_buffer + source_offset,
+      .length = length,
+      .pattern = 0,
+      .pattern_length = 0,
   };
-  // Serialize all the nodes for now.
-  CUgraphNode dep[] = {command_buffer->last_node};
-  size_t numNode = command_buffer->last_node ? 1 : 0;
-  CUDA_RETURN_IF_ERROR(
-      command_buffer->context->syms,
-      cuGraphAddMemcpyNode(&command_buffer->last_node, command_buffer->graph,
-                           dep, numNode, &params,
-                           command_buffer->context->cu_context),
-      "cuGraphAddMemcpyNode");
-  return iree_ok_status();
+  return iree_hal_cuda_graph_command_buffer_record_op(command_buffer, &op);
 }
 
 static iree_status_t iree_hal_cuda_graph_command_buffer_push_constants(
@@ -402,6 +679,9 @@ static iree_status_t iree_hal_cuda_graph_command_buffer_dispatch(
       iree_hal_cuda_graph_command_buffer_cast(base_command_buffer);
   iree_hal_cuda_graph_command_buffer_cast(base_command_buffer);
 
+  IREE_RETURN_IF_ERROR(
+      iree_hal_cuda_graph_command_buffer_flush_pending_op(command_buffer));
+
   int32_t block_size_x, block_size_y, block_size_z;
   IREE_RETURN_IF_ERROR(iree_hal_cuda_native_executable_block_size(
       executable, entry_point, &block_size_x, &block_size_y, &block_size_z));
@@ -416,6 +696,10 @@ static iree_status_t iree_hal_cuda_graph_command_buffer_dispatch(
       .gridDimZ = workgroup_z,
       .kernelParams = command_buffer->current_descriptor,
   };
+  iree_hal_cuda_graph_command_buffer_hash_node(
+      command_buffer, CU_GRAPH_NODE_TYPE_KERNEL,
+      (uint64_t)(uintptr_t)params.func);
+
   // Serialize all the nodes for now.
   CUgraphNode dep[] = {command_buffer->last_node};
   size_t numNodes = command_buffer->last_node ? 1 : 0;
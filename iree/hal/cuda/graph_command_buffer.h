@@ -8,6 +8,7 @@
 #define IREE_HAL_CUDA_GRAPH_COMMAND_BUFFER_H_
 
 #include "iree/base/api.h"
+#include "iree/base/internal/synchronization.h"
 #include "iree/hal/api.h"
 #include "iree/hal/cuda/context_wrapper.h"
 #include "iree/hal/cuda/cuda_headers.h"
@@ -17,9 +18,57 @@
 extern "C" {
 #endif  // __cplusplus
 
+//===----------------------------------------------------------------------===//
+// iree_hal_cuda_graph_exec_cache_t
+//===----------------------------------------------------------------------===//
+
+// Maximum number of idle graph executables a cache may retain.
+#define IREE_HAL_CUDA_GRAPH_EXEC_CACHE_MAX_CAPACITY 32
+
+typedef struct iree_hal_cuda_graph_exec_cache_entry_t {
+  uint64_t topology_hash;
+  CUgraphExec exec;
+} iree_hal_cuda_graph_exec_cache_entry_t;
+
+// A cache of idle graph executables keyed by the topology of the graph they
+// were instantiated from. Command buffers recording a graph with the same
+// topology as a cached executable update it in place with cuGraphExecUpdate
+// instead of paying for a full cuGraphInstantiate.
+//
+// Thread-safe.
+typedef struct iree_hal_cuda_graph_exec_cache_t {
+  iree_hal_cuda_context_wrapper_t* context;
+  iree_slim_mutex_t mutex;
+  iree_host_size_t capacity;
+  iree_host_size_t count;
+  // Least recently released first.
+  iree_hal_cuda_graph_exec_cache_entry_t
+      entries[IREE_HAL_CUDA_GRAPH_EXEC_CACHE_MAX_CAPACITY];
+} iree_hal_cuda_graph_exec_cache_t;
+
+// Initializes |out_cache| to retain up to |capacity| idle executables.
+// A capacity of 0 disables caching.
+void iree_hal_cuda_graph_exec_cache_initialize(
+    iree_hal_cuda_context_wrapper_t* context, iree_host_size_t capacity,
+    iree_hal_cuda_graph_exec_cache_t* out_cache);
+
+// Destroys all idle executables retained by |cache|.
+void iree_hal_cuda_graph_exec_cache_deinitialize(
+    iree_hal_cuda_graph_exec_cache_t* cache);
+
+//===----------------------------------------------------------------------===//
+// iree_hal_cuda_graph_command_buffer_t
+//===----------------------------------------------------------------------===//
+
 // Creates a cuda graph.
+// |exec_cache| is optional and, if provided, must remain valid for the lifetime
+// of the command buffer.
+//
+// Command buffers may be re-recorded by calling begin again after end; the
+// previous executable is updated in place if the topology is unchanged.
 iree_status_t iree_hal_cuda_graph_command_buffer_create(
     iree_hal_cuda_context_wrapper_t* context,
+    iree_hal_cuda_graph_exec_cache_t* exec_cache,
     iree_hal_command_buffer_mode_t mode,
     iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity,
@@ -20,6 +20,10 @@
 
 typedef struct iree_hal_cuda_native_executable_function_t {
   CUfunction cu_function;
+  // Persistent kernel able to run the entry point, if any.
+  CUfunction persistent_function;
+  // Entry point name stored in the executable allocation.
+  iree_string_view_t name;
   uint32_t block_size_x;
   uint32_t block_size_y;
   uint32_t block_size_z;
@@ -66,9 +70,15 @@ iree_status_t iree_hal_cuda_native_executable_create(
   iree_CUDABlockSizeDef_vec_t block_sizes_vec =
       iree_CUDAExecutableDef_block_sizes_get(executable_def);
   iree_host_size_t entry_count = flatbuffers_string_vec_len(entry_points_vec);
+  iree_host_size_t total_name_size = 0;
+  for (iree_host_size_t i = 0; i < entry_count; i++) {
+    total_name_size +=
+        flatbuffers_string_len(flatbuffers_string_vec_at(entry_points_vec, i));
+  }
   iree_host_size_t total_size =
       sizeof(*executable) +
-      entry_count * sizeof(iree_hal_cuda_native_executable_function_t);
+      entry_count * sizeof(iree_hal_cuda_native_executable_function_t) +
+      total_name_size;
   iree_status_t status = iree_allocator_malloc(context->host_allocator,
                                                total_size, (void**)&executable);
   CUmodule module = NULL;
@@ -76,6 +86,7 @@ iree_status_t iree_hal_cuda_native_executable_create(
                        cuModuleLoadDataEx(&module, ptx_image, 0, NULL, NULL),
                        "cuModuleLoadDataEx");
 
+  char* name_buffer = (char*)(executable->entry_functions + entry_count);
   for (iree_host_size_t i = 0; i < entry_count; i++) {
     CUfunction function = NULL;
     const char* entry_name = flatbuffers_string_vec_at(entry_points_vec, i);
@@ -83,11 +94,47 @@ iree_status_t iree_hal_cuda_native_executable_create(
                          cuModuleGetFunction(&function, module, entry_name),
                          "cuModuleGetFunction");
     executable->entry_functions[i].cu_function = function;
+    executable->entry_functions[i].persistent_function = NULL;
+    iree_host_size_t name_length = iree_string_view_append_to_buffer(
+        iree_make_string_view(entry_name, flatbuffers_string_len(entry_name)),
+        &executable->entry_functions[i].name, name_buffer);
+    name_buffer += name_length;
     executable->entry_functions[i].block_size_x = block_sizes_vec[i].x;
     executable->entry_functions[i].block_size_y = block_sizes_vec[i].y;
     executable->entry_functions[i].block_size_z = block_sizes_vec[i].z;
   }
 
+  // Persistent kernels are an optimization; executables compiled for another
+  // work item layout still run with a launch per dispatch.
+  iree_CUDAPersistentKernelDef_vec_t persistent_kernels_vec =
+      iree_CUDAExecutableDef_persistent_kernels_get(executable_def);
+  if (iree_CUDAExecutableDef_persistent_abi_version_get(executable_def) ==
+      IREE_HAL_CUDA_PERSISTENT_KERNEL_ABI_VERSION) {
+    for (iree_host_size_t i = 0;
+         i < iree_CUDAPersistentKernelDef_vec_len(persistent_kernels_vec);
+         i++) {
+      iree_CUDAPersistentKernelDef_table_t kernel_def =
+          iree_CUDAPersistentKernelDef_vec_at(persistent_kernels_vec, i);
+      const char* kernel_name =
+          iree_CUDAPersistentKernelDef_name_get(kernel_def);
+      CUfunction function = NULL;
+      CUDA_RETURN_IF_ERROR(context->syms,
+                           cuModuleGetFunction(&function, module, kernel_name),
+                           "cuModuleGetFunction");
+      flatbuffers_uint32_vec_t kernel_entry_points_vec =
+          iree_CUDAPersistentKernelDef_entry_points_get(kernel_def);
+      for (iree_host_size_t j = 0;
+           j < flatbuffers_uint32_vec_len(kernel_entry_points_vec); j++) {
+        uint32_t entry_point =
+            flatbuffers_uint32_vec_at(kernel_entry_points_vec, j);
+        if (entry_point < entry_count) {
+          executable->entry_functions[entry_point].persistent_function =
+              function;
+        }
+      }
+    }
+  }
+
   iree_hal_resource_initialize(&iree_hal_cuda_native_executable_vtable,
                                &executable->resource);
   executable->module = module;
@@ -104,6 +151,20 @@ CUfunction iree_hal_cuda_native_executable_for_entry_point(
   return executable->entry_functions[entry_point].cu_function;
 }
 
+CUfunction iree_hal_cuda_native_executable_persistent_kernel_for_entry_point(
+    iree_hal_executable_t* base_executable, int32_t entry_point) {
+  iree_hal_cuda_native_executable_t* executable =
+      iree_hal_cuda_native_executable_cast(base_executable);
+  return executable->entry_functions[entry_point].persistent_function;
+}
+
+iree_string_view_t iree_hal_cuda_native_executable_entry_point_name(
+    iree_hal_executable_t* base_executable, int32_t entry_point) {
+  iree_hal_cuda_native_executable_t* executable =
+      iree_hal_cuda_native_executable_cast(base_executable);
+  return executable->entry_functions[entry_point].name;
+}
+
 iree_status_t iree_hal_cuda_native_executable_block_size(
     iree_hal_executable_t* base_executable, int32_t entry_point, uint32_t* x,
     uint32_t* y, uint32_t* z) {
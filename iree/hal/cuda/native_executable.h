@@ -18,6 +18,37 @@
 extern "C" {
 #endif  // __cplusplus
 
+// Version of the work item layout consumed by persistent kernels. Executables
+// compiled with a different version have their persistent kernels ignored.
+// Must match kPersistentKernelABIVersion in the compiler, as must the limits.
+#define IREE_HAL_CUDA_PERSISTENT_KERNEL_ABI_VERSION 1
+// Maximum number of work items in a single persistent kernel launch.
+#define IREE_HAL_CUDA_PERSISTENT_MAX_WORK_ITEMS 16
+// Maximum number of bindings of an entry point run by a persistent kernel.
+#define IREE_HAL_CUDA_PERSISTENT_MAX_BINDINGS 16
+// Number of uint32_t counters used by a persistent kernel launch: a ticket
+// counter followed by a completion counter per epoch.
+#define IREE_HAL_CUDA_PERSISTENT_COUNTER_COUNT \
+  (1 + IREE_HAL_CUDA_PERSISTENT_MAX_WORK_ITEMS)
+
+// A dispatch executed by a persistent kernel. Persistent kernels take a fixed
+// array of IREE_HAL_CUDA_PERSISTENT_MAX_WORK_ITEMS items by value, the number
+// of valid items, their total workgroup count, and a pointer to zeroed
+// counters. Items must be ordered by |workgroup_base|.
+typedef struct iree_hal_cuda_persistent_work_item_t {
+  uint32_t entry_point;
+  uint32_t workgroup_count[3];
+  // Sum of the workgroup counts of all preceding items.
+  uint32_t workgroup_base;
+  // Number of execution barriers preceding the item within the launch.
+  uint32_t epoch;
+  // Total workgroup count of epoch |epoch| - 1 that must complete before any
+  // workgroup of the item starts. Unused for epoch 0.
+  uint32_t wait_workgroup_count;
+  uint32_t reserved;
+  uint64_t bindings[IREE_HAL_CUDA_PERSISTENT_MAX_BINDINGS];
+} iree_hal_cuda_persistent_work_item_t;
+
 // Creates an executable from a PTX module. The module may contain several
 // kernels that can be extracted along with the associated block size.
 iree_status_t iree_hal_cuda_native_executable_create(
@@ -28,6 +59,16 @@ iree_status_t iree_hal_cuda_native_executable_create(
 CUfunction iree_hal_cuda_native_executable_for_entry_point(
     iree_hal_executable_t* executable, int32_t entry_point);
 
+// Returns the persistent kernel able to run |entry_point| or NULL if there is
+// none. The persistent kernel uses the block size of the entry point.
+CUfunction iree_hal_cuda_native_executable_persistent_kernel_for_entry_point(
+    iree_hal_executable_t* executable, int32_t entry_point);
+
+// Returns the name of the given |entry_point| within the executable.
+// The returned string is valid for the lifetime of the executable.
+iree_string_view_t iree_hal_cuda_native_executable_entry_point_name(
+    iree_hal_executable_t* executable, int32_t entry_point);
+
 // Return the block size of the given |entry_point| within the executable.
 iree_status_t iree_hal_cuda_native_executable_block_size(
     iree_hal_executable_t* executable, int32_t entry_point, uint32_t* x,
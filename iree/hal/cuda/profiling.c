@@ -0,0 +1,246 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/cuda/profiling.h"
+
+#include <string.h>
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/cuda/native_executable.h"
+#include "iree/hal/cuda/status_util.h"
+
+// Maximum number of dispatches that can be profiled in a single session.
+#define IREE_HAL_CUDA_PROFILING_RECORD_CAPACITY (4 * 1024)
+
+typedef struct iree_hal_cuda_profiling_record_t {
+  // Retained until the record is reported or discarded so that the entry point
+  // name remains valid. NULL once reported.
+  iree_hal_executable_t* executable;
+  int32_t entry_point;
+  uint32_t workgroup_count[3];
+  CUevent start_event;
+  CUevent end_event;
+  // True once |end_event| has been recorded.
+  bool ended;
+} iree_hal_cuda_profiling_record_t;
+
+struct iree_hal_cuda_profiling_context_t {
+  iree_hal_cuda_context_wrapper_t* context;
+
+  // Non-zero while a profiling session is active. Checked without the lock so
+  // that issuing dispatches outside of a session stays cheap.
+  iree_atomic_int32_t active;
+
+  iree_slim_mutex_t mutex;
+  uint32_t record_count;
+  iree_hal_cuda_profiling_record_t records[];
+};
+
+static void iree_hal_cuda_profiling_record_release(
+    iree_hal_cuda_context_wrapper_t* context,
+    iree_hal_cuda_profiling_record_t* record) {
+  if (record->start_event) {
+    CUDA_IGNORE_ERROR(context->syms, cuEventDestroy(record->start_event));
+  }
+  if (record->end_event) {
+    CUDA_IGNORE_ERROR(context->syms, cuEventDestroy(record->end_event));
+  }
+  iree_hal_executable_release(record->executable);
+  memset(record, 0, sizeof(*record));
+}
+
+iree_status_t iree_hal_cuda_profiling_context_allocate(
+    iree_hal_cuda_context_wrapper_t* context,
+    iree_hal_cuda_profiling_context_t** out_profiling_context) {
+  IREE_ASSERT_ARGUMENT(context);
+  IREE_ASSERT_ARGUMENT(out_profiling_context);
+  *out_profiling_context = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_cuda_profiling_context_t* profiling_context = NULL;
+  iree_host_size_t total_size =
+      sizeof(*profiling_context) + IREE_HAL_CUDA_PROFILING_RECORD_CAPACITY *
+                                       sizeof(profiling_context->records[0]);
+  iree_status_t status = iree_allocator_malloc(
+      context->host_allocator, total_size, (void**)&profiling_context);
+  if (iree_status_is_ok(status)) {
+    memset(profiling_context, 0, total_size);
+    profiling_context->context = context;
+    iree_atomic_store_int32(&profiling_context->active, 0,
+                            iree_memory_order_relaxed);
+    iree_slim_mutex_initialize(&profiling_context->mutex);
+    *out_profiling_context = profiling_context;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+void iree_hal_cuda_profiling_context_free(
+    iree_hal_cuda_profiling_context_t* profiling_context) {
+  if (!profiling_context) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  for (uint32_t i = 0; i < profiling_context->record_count; ++i) {
+    iree_hal_cuda_profiling_record_release(profiling_context->context,
+                                           &profiling_context->records[i]);
+  }
+  iree_slim_mutex_deinitialize(&profiling_context->mutex);
+  iree_allocator_free(profiling_context->context->host_allocator,
+                      profiling_context);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+iree_status_t iree_hal_cuda_profiling_context_begin(
+    iree_hal_cuda_profiling_context_t* profiling_context) {
+  iree_slim_mutex_lock(&profiling_context->mutex);
+  for (uint32_t i = 0; i < profiling_context->record_count; ++i) {
+    iree_hal_cuda_profiling_record_release(profiling_context->context,
+                                           &profiling_context->records[i]);
+  }
+  profiling_context->record_count = 0;
+  iree_atomic_store_int32(&profiling_context->active, 1,
+                          iree_memory_order_release);
+  iree_slim_mutex_unlock(&profiling_context->mutex);
+  return iree_ok_status();
+}
+
+void iree_hal_cuda_profiling_context_end(
+    iree_hal_cuda_profiling_context_t* profiling_context) {
+  iree_atomic_store_int32(&profiling_context->active, 0,
+                          iree_memory_order_release);
+}
+
+iree_status_t iree_hal_cuda_profiling_context_flush(
+    iree_hal_cuda_profiling_context_t* profiling_context,
+    iree_hal_dispatch_profile_callback_t callback) {
+  iree_hal_cuda_context_wrapper_t* context = profiling_context->context;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_slim_mutex_lock(&profiling_context->mutex);
+
+  iree_status_t status = iree_ok_status();
+  for (uint32_t i = 0;
+       i < profiling_context->record_count && iree_status_is_ok(status); ++i) {
+    iree_hal_cuda_profiling_record_t* record = &profiling_context->records[i];
+    if (!record->executable || !record->ended) continue;
+    CUresult result = context->syms->cuEventQuery(record->end_event);
+    if (result == CUDA_ERROR_NOT_READY) continue;
+    float elapsed_ms = 0.0f;
+    status = iree_hal_cuda_result_to_status(context->syms, result, __FILE__,
+                                            __LINE__);
+    if (iree_status_is_ok(status)) {
+      status = CU_RESULT_TO_STATUS(
+          context->syms,
+          cuEventElapsedTime(&elapsed_ms, record->start_event,
+                             record->end_event),
+          "cuEventElapsedTime");
+    }
+    if (iree_status_is_ok(status)) {
+      iree_hal_dispatch_profile_t profile;
+      memset(&profile, 0, sizeof(profile));
+      profile.entry_point_name =
+          iree_hal_cuda_native_executable_entry_point_name(
+              record->executable, record->entry_point);
+      profile.entry_point = record->entry_point;
+      memcpy(profile.workgroup_count, record->workgroup_count,
+             sizeof(profile.workgroup_count));
+      profile.duration_ns = (uint64_t)((double)elapsed_ms * 1000000.0);
+      status = callback.fn(callback.user_data, &profile);
+    }
+    iree_hal_cuda_profiling_record_release(context, record);
+  }
+
+  iree_slim_mutex_unlock(&profiling_context->mutex);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+iree_status_t iree_hal_cuda_profiling_context_begin_dispatch(
+    iree_hal_cuda_profiling_context_t* profiling_context, CUstream stream,
+    iree_hal_executable_t* executable, int32_t entry_point,
+    uint32_t workgroup_x, uint32_t workgroup_y, uint32_t workgroup_z,
+    uint32_t* out_record_index) {
+  *out_record_index = IREE_HAL_CUDA_PROFILING_RECORD_NONE;
+  if (!profiling_context ||
+      !iree_atomic_load_int32(&profiling_context->active,
+                              iree_memory_order_acquire)) {
+    return iree_ok_status();
+  }
+  iree_hal_cuda_context_wrapper_t* context = profiling_context->context;
+
+  // Timing is enabled on events created without CU_EVENT_DISABLE_TIMING.
+  CUevent start_event = NULL;
+  CUevent end_event = NULL;
+  iree_status_t status = CU_RESULT_TO_STATUS(
+      context->syms, cuEventCreate(&start_event, CU_EVENT_DEFAULT),
+      "cuEventCreate");
+  if (iree_status_is_ok(status)) {
+    status = CU_RESULT_TO_STATUS(
+        context->syms, cuEventCreate(&end_event, CU_EVENT_DEFAULT),
+        "cuEventCreate");
+  }
+  if (iree_status_is_ok(status)) {
+    status = CU_RESULT_TO_STATUS(context->syms,
+                                 cuEventRecord(start_event, stream),
+                                 "cuEventRecord");
+  }
+
+  uint32_t record_index = IREE_HAL_CUDA_PROFILING_RECORD_NONE;
+  if (iree_status_is_ok(status)) {
+    iree_slim_mutex_lock(&profiling_context->mutex);
+    if (profiling_context->record_count <
+        IREE_HAL_CUDA_PROFILING_RECORD_CAPACITY) {
+      record_index = profiling_context->record_count++;
+      iree_hal_cuda_profiling_record_t* record =
+          &profiling_context->records[record_index];
+      record->executable = executable;
+      iree_hal_executable_retain(executable);
+      record->entry_point = entry_point;
+      record->workgroup_count[0] = workgroup_x;
+      record->workgroup_count[1] = workgroup_y;
+      record->workgroup_count[2] = workgroup_z;
+      record->start_event = start_event;
+      record->end_event = end_event;
+      record->ended = false;
+    }
+    iree_slim_mutex_unlock(&profiling_context->mutex);
+  }
+
+  if (record_index == IREE_HAL_CUDA_PROFILING_RECORD_NONE) {
+    // Either failed or out of capacity; the dispatch is issued unprofiled.
+    if (start_event) {
+      CUDA_IGNORE_ERROR(context->syms, cuEventDestroy(start_event));
+    }
+    if (end_event) {
+      CUDA_IGNORE_ERROR(context->syms, cuEventDestroy(end_event));
+    }
+  }
+  *out_record_index = record_index;
+  return status;
+}
+
+iree_status_t iree_hal_cuda_profiling_context_end_dispatch(
+    iree_hal_cuda_profiling_context_t* profiling_context, CUstream stream,
+    uint32_t record_index) {
+  if (record_index == IREE_HAL_CUDA_PROFILING_RECORD_NONE) {
+    return iree_ok_status();
+  }
+  iree_slim_mutex_lock(&profiling_context->mutex);
+  iree_hal_cuda_profiling_record_t* record =
+      &profiling_context->records[record_index];
+  iree_status_t status = iree_ok_status();
+  if (record->end_event) {  // NULL if discarded by a new session
+    status = CU_RESULT_TO_STATUS(profiling_context->context->syms,
+                                 cuEventRecord(record->end_event, stream),
+                                 "cuEventRecord");
+    record->ended = iree_status_is_ok(status);
+  }
+  iree_slim_mutex_unlock(&profiling_context->mutex);
+  return status;
+}
@@ -0,0 +1,80 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_CUDA_PROFILING_H_
+#define IREE_HAL_CUDA_PROFILING_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/cuda/context_wrapper.h"
+#include "iree/hal/cuda/cuda_headers.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Sentinel record index indicating a dispatch is not being profiled.
+#define IREE_HAL_CUDA_PROFILING_RECORD_NONE UINT32_MAX
+
+// Per-device dispatch profiling context.
+//
+// Each profiled kernel launch is bracketed by a pair of timing events recorded
+// on the stream it is issued on. Records are allocated linearly during a
+// profiling session and are only reclaimed when the next session begins; once
+// the capacity is exhausted further dispatches are issued without profiling.
+// Flushing queries the events without blocking and only reports dispatches
+// that have completed execution.
+//
+// Thread-safe.
+typedef struct iree_hal_cuda_profiling_context_t
+    iree_hal_cuda_profiling_context_t;
+
+// Allocates a dispatch profiling context for |context|.
+iree_status_t iree_hal_cuda_profiling_context_allocate(
+    iree_hal_cuda_context_wrapper_t* context,
+    iree_hal_cuda_profiling_context_t** out_profiling_context);
+
+// Frees a profiling context and all associated resources.
+// All streams with profiled dispatches must have completed.
+void iree_hal_cuda_profiling_context_free(
+    iree_hal_cuda_profiling_context_t* profiling_context);
+
+// Begins a new profiling session, discarding any unflushed profiles.
+iree_status_t iree_hal_cuda_profiling_context_begin(
+    iree_hal_cuda_profiling_context_t* profiling_context);
+
+// Ends the current profiling session, if any.
+void iree_hal_cuda_profiling_context_end(
+    iree_hal_cuda_profiling_context_t* profiling_context);
+
+// Reports all completed dispatch profiles to |callback|.
+// |callback| must not call back into the profiling context.
+iree_status_t iree_hal_cuda_profiling_context_flush(
+    iree_hal_cuda_profiling_context_t* profiling_context,
+    iree_hal_dispatch_profile_callback_t callback);
+
+// Records the start event of a dispatch on |stream| if a session is active and
+// returns the record index to pass to
+// iree_hal_cuda_profiling_context_end_dispatch. Sets |out_record_index| to
+// IREE_HAL_CUDA_PROFILING_RECORD_NONE if the dispatch is not being profiled.
+// |profiling_context| may be NULL.
+iree_status_t iree_hal_cuda_profiling_context_begin_dispatch(
+    iree_hal_cuda_profiling_context_t* profiling_context, CUstream stream,
+    iree_hal_executable_t* executable, int32_t entry_point,
+    uint32_t workgroup_x, uint32_t workgroup_y, uint32_t workgroup_z,
+    uint32_t* out_record_index);
+
+// Records the end event of a dispatch started with
+// iree_hal_cuda_profiling_context_begin_dispatch.
+iree_status_t iree_hal_cuda_profiling_context_end_dispatch(
+    iree_hal_cuda_profiling_context_t* profiling_context, CUstream stream,
+    uint32_t record_index);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_CUDA_PROFILING_H_
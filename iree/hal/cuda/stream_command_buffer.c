@@ -21,12 +21,31 @@
 typedef struct {
   iree_hal_resource_t resource;
   iree_hal_cuda_context_wrapper_t* context;
+  iree_hal_cuda_profiling_context_t* profiling_context;
   iree_hal_command_buffer_mode_t mode;
   iree_hal_command_category_t allowed_categories;
   CUstream stream;
   // Keep track of the current set of kernel arguments.
   void* current_descriptor[IREE_HAL_CUDA_MAX_BINDING_COUNT];
   CUdeviceptr* device_ptrs[IREE_HAL_CUDA_MAX_BINDING_COUNT];
+
+  // Batching of small dispatches into persistent kernel launches.
+  bool use_persistent_kernels;
+  iree_hal_cuda_persistent_dispatch_options_t persistent_options;
+  struct {
+    // Persistent kernel and block size the pending items are launched with.
+    CUfunction function;
+    uint32_t block_size[3];
+    uint32_t item_count;
+    uint32_t workgroup_count;
+    // Set when a barrier was recorded after the last item such that the next
+    // item starts a new epoch.
+    bool barrier_pending;
+    // Total workgroup count of each epoch.
+    uint32_t epoch_workgroup_counts[IREE_HAL_CUDA_PERSISTENT_MAX_WORK_ITEMS];
+    iree_hal_cuda_persistent_work_item_t
+        items[IREE_HAL_CUDA_PERSISTENT_MAX_WORK_ITEMS];
+  } batch;
 } iree_hal_cuda_stream_command_buffer_t;
 
 extern const iree_hal_command_buffer_vtable_t
@@ -41,6 +60,8 @@ iree_hal_cuda_stream_command_buffer_cast(
 
 iree_status_t iree_hal_cuda_stream_command_buffer_create(
     iree_hal_cuda_context_wrapper_t* context,
+    iree_hal_cuda_profiling_context_t* profiling_context,
+    const iree_hal_cuda_persistent_dispatch_options_t* persistent_options,
     iree_hal_command_buffer_mode_t mode,
     iree_hal_command_category_t command_categories, CUstream stream,
     iree_hal_command_buffer_t** out_command_buffer) {
@@ -59,12 +80,18 @@ iree_status_t iree_hal_cuda_stream_command_buffer_create(
     iree_hal_resource_initialize(&iree_hal_cuda_stream_command_buffer_vtable,
                                  &command_buffer->resource);
     command_buffer->context = context;
+    command_buffer->profiling_context = profiling_context;
     command_buffer->mode = mode;
     command_buffer->allowed_categories = command_categories;
     command_buffer->stream = stream;
     for (size_t i = 0; i < IREE_HAL_CUDA_MAX_BINDING_COUNT; i++) {
       command_buffer->current_descriptor[i] = &command_buffer->device_ptrs[i];
     }
+    command_buffer->use_persistent_kernels = persistent_options != NULL;
+    if (persistent_options) {
+      command_buffer->persistent_options = *persistent_options;
+    }
+    command_buffer->batch.item_count = 0;
   }
 
   *out_command_buffer = (iree_hal_command_buffer_t*)command_buffer;
@@ -98,6 +125,115 @@ iree_hal_cuda_stream_command_buffer_allowed_categories(
   return command_buffer->allowed_categories;
 }
 
+// Launches the persistent kernel for all batched dispatches, if any.
+// Must be called before issuing any other work on the stream.
+static iree_status_t iree_hal_cuda_stream_command_buffer_flush_batch(
+    iree_hal_cuda_stream_command_buffer_t* command_buffer) {
+  if (command_buffer->batch.item_count == 0) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, command_buffer->batch.item_count);
+
+  // The work items are passed by value as a kernel parameter and captured at
+  // launch so the batch can be reused immediately after.
+  CUdeviceptr counters = command_buffer->persistent_options.counters;
+  uint32_t grid_size =
+      iree_min(command_buffer->batch.workgroup_count,
+               command_buffer->persistent_options.max_grid_size);
+  void* params[] = {
+      command_buffer->batch.items,
+      &command_buffer->batch.item_count,
+      &command_buffer->batch.workgroup_count,
+      &counters,
+  };
+  iree_status_t status = CU_RESULT_TO_STATUS(
+      command_buffer->context->syms,
+      cuMemsetD32Async(counters, 0, IREE_HAL_CUDA_PERSISTENT_COUNTER_COUNT,
+                       command_buffer->stream),
+      "cuMemsetD32Async");
+  if (iree_status_is_ok(status)) {
+    status = CU_RESULT_TO_STATUS(
+        command_buffer->context->syms,
+        cuLaunchKernel(command_buffer->batch.function, grid_size, 1, 1,
+                       command_buffer->batch.block_size[0],
+                       command_buffer->batch.block_size[1],
+                       command_buffer->batch.block_size[2], 0,
+                       command_buffer->stream, params, NULL),
+        "cuLaunchKernel");
+  }
+  command_buffer->batch.item_count = 0;
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Appends the dispatch to the pending batch if it can be run by a persistent
+// kernel, flushing the batch first if needed. Sets |out_batched| to false if
+// the dispatch must be launched on its own.
+static iree_status_t iree_hal_cuda_stream_command_buffer_batch_dispatch(
+    iree_hal_cuda_stream_command_buffer_t* command_buffer,
+    iree_hal_executable_t* executable, int32_t entry_point,
+    const uint32_t block_size[3], const uint32_t workgroup_count[3],
+    bool* out_batched) {
+  *out_batched = false;
+  if (!command_buffer->use_persistent_kernels) return iree_ok_status();
+  uint64_t total_count = (uint64_t)workgroup_count[0] * workgroup_count[1] *
+                         workgroup_count[2];
+  CUfunction function =
+      iree_hal_cuda_native_executable_persistent_kernel_for_entry_point(
+          executable, entry_point);
+  if (!function || total_count == 0 ||
+      total_count > command_buffer->persistent_options.max_workgroup_count) {
+    return iree_ok_status();
+  }
+
+  if (command_buffer->batch.item_count > 0 &&
+      (command_buffer->batch.function != function ||
+       command_buffer->batch.item_count ==
+           IREE_HAL_CUDA_PERSISTENT_MAX_WORK_ITEMS)) {
+    IREE_RETURN_IF_ERROR(
+        iree_hal_cuda_stream_command_buffer_flush_batch(command_buffer));
+  }
+  if (command_buffer->batch.item_count == 0) {
+    command_buffer->batch.function = function;
+    memcpy(command_buffer->batch.block_size, block_size,
+           sizeof(command_buffer->batch.block_size));
+    command_buffer->batch.workgroup_count = 0;
+    command_buffer->batch.barrier_pending = false;
+    command_buffer->batch.epoch_workgroup_counts[0] = 0;
+  }
+
+  iree_hal_cuda_persistent_work_item_t* item =
+      &command_buffer->batch.items[command_buffer->batch.item_count];
+  uint32_t epoch =
+      command_buffer->batch.item_count > 0
+          ? command_buffer->batch.items[command_buffer->batch.item_count - 1]
+                .epoch
+          : 0;
+  item->wait_workgroup_count = 0;
+  if (command_buffer->batch.barrier_pending) {
+    item->wait_workgroup_count =
+        command_buffer->batch.epoch_workgroup_counts[epoch];
+    ++epoch;
+    command_buffer->batch.epoch_workgroup_counts[epoch] = 0;
+    command_buffer->batch.barrier_pending = false;
+  }
+  item->entry_point = (uint32_t)entry_point;
+  memcpy(item->workgroup_count, workgroup_count, sizeof(item->workgroup_count));
+  item->workgroup_base = command_buffer->batch.workgroup_count;
+  item->epoch = epoch;
+  item->reserved = 0;
+  // Entry points with persistent kernels take at most
+  // IREE_HAL_CUDA_PERSISTENT_MAX_BINDINGS arguments.
+  for (iree_host_size_t i = 0; i < IREE_HAL_CUDA_PERSISTENT_MAX_BINDINGS;
+       ++i) {
+    item->bindings[i] = *(CUdeviceptr*)command_buffer->current_descriptor[i];
+  }
+  command_buffer->batch.epoch_workgroup_counts[epoch] += (uint32_t)total_count;
+  command_buffer->batch.workgroup_count += (uint32_t)total_count;
+  ++command_buffer->batch.item_count;
+  *out_batched = true;
+  return iree_ok_status();
+}
+
 static iree_status_t iree_hal_cuda_stream_command_buffer_begin(
     iree_hal_command_buffer_t* base_command_buffer) {
   return iree_ok_status();
@@ -105,7 +241,9 @@ static iree_status_t iree_hal_cuda_stream_command_buffer_begin(
 
 static iree_status_t iree_hal_cuda_stream_command_buffer_end(
     iree_hal_command_buffer_t* base_command_buffer) {
-  return iree_ok_status();
+  iree_hal_cuda_stream_command_buffer_t* command_buffer =
+      iree_hal_cuda_stream_command_buffer_cast(base_command_buffer);
+  return iree_hal_cuda_stream_command_buffer_flush_batch(command_buffer);
 }
 
 static iree_status_t iree_hal_cuda_stream_command_buffer_execution_barrier(
@@ -117,7 +255,13 @@ static iree_status_t iree_hal_cuda_stream_command_buffer_execution_barrier(
     const iree_hal_memory_barrier_t* memory_barriers,
     iree_host_size_t buffer_barrier_count,
     const iree_hal_buffer_barrier_t* buffer_barriers) {
-  // TODO(jinchen62): implement CUDA barrier
+  iree_hal_cuda_stream_command_buffer_t* command_buffer =
+      iree_hal_cuda_stream_command_buffer_cast(base_command_buffer);
+  // Work issued on the stream is serialized; only batched dispatches need to
+  // wait on each other.
+  if (command_buffer->batch.item_count > 0) {
+    command_buffer->batch.barrier_pending = true;
+  }
   return iree_ok_status();
 }
 
@@ -183,6 +327,8 @@ static iree_status_t iree_hal_cuda_stream_command_buffer_fill_buffer(
     iree_host_size_t pattern_length) {
   iree_hal_cuda_stream_command_buffer_t* command_buffer =
       iree_hal_cuda_stream_command_buffer_cast(base_command_buffer);
+  IREE_RETURN_IF_ERROR(
+      iree_hal_cuda_stream_command_buffer_flush_batch(command_buffer));
 
   CUdeviceptr target_device_buffer = iree_hal_cuda_buffer_device_pointer(
       iree_hal_buffer_allocated_buffer(target_buffer));
@@ -213,6 +359,8 @@ static iree_status_t iree_hal_cuda_stream_command_buffer_copy_buffer(
     iree_device_size_t length) {
   iree_hal_cuda_stream_command_buffer_t* command_buffer =
       iree_hal_cuda_stream_command_buffer_cast(base_command_buffer);
+  IREE_RETURN_IF_ERROR(
+      iree_hal_cuda_stream_command_buffer_flush_batch(command_buffer));
 
   CUdeviceptr target_device_buffer = iree_hal_cuda_buffer_device_pointer(
       iree_hal_buffer_allocated_buffer(target_buffer));
@@ -302,18 +450,34 @@ static iree_status_t iree_hal_cuda_stream_command_buffer_dispatch(
   iree_hal_cuda_stream_command_buffer_t* command_buffer =
       iree_hal_cuda_stream_command_buffer_cast(base_command_buffer);
 
-  int32_t block_size_x, block_size_y, block_size_z;
+  uint32_t block_size_x, block_size_y, block_size_z;
   IREE_RETURN_IF_ERROR(iree_hal_cuda_native_executable_block_size(
       executable, entry_point, &block_size_x, &block_size_y, &block_size_z));
+  const uint32_t block_size[3] = {block_size_x, block_size_y, block_size_z};
+  const uint32_t workgroup_count[3] = {workgroup_x, workgroup_y, workgroup_z};
+  bool batched = false;
+  IREE_RETURN_IF_ERROR(iree_hal_cuda_stream_command_buffer_batch_dispatch(
+      command_buffer, executable, entry_point, block_size, workgroup_count,
+      &batched));
+  if (batched) return iree_ok_status();
+  IREE_RETURN_IF_ERROR(
+      iree_hal_cuda_stream_command_buffer_flush_batch(command_buffer));
+
   CUfunction func =
       iree_hal_cuda_native_executable_for_entry_point(executable, entry_point);
+  uint32_t profiling_record = IREE_HAL_CUDA_PROFILING_RECORD_NONE;
+  IREE_RETURN_IF_ERROR(iree_hal_cuda_profiling_context_begin_dispatch(
+      command_buffer->profiling_context, command_buffer->stream, executable,
+      entry_point, workgroup_x, workgroup_y, workgroup_z, &profiling_record));
   CUDA_RETURN_IF_ERROR(
       command_buffer->context->syms,
       cuLaunchKernel(func, workgroup_x, workgroup_y, workgroup_z, block_size_x,
                      block_size_y, block_size_z, 0, command_buffer->stream,
                      command_buffer->current_descriptor, NULL),
       "cuLaunchKernel");
-  return iree_ok_status();
+  return iree_hal_cuda_profiling_context_end_dispatch(
+      command_buffer->profiling_context, command_buffer->stream,
+      profiling_record);
 }
 
 static iree_status_t iree_hal_cuda_stream_command_buffer_dispatch_indirect(
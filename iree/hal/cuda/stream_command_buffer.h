@@ -12,18 +12,37 @@
 #include "iree/hal/cuda/context_wrapper.h"
 #include "iree/hal/cuda/cuda_headers.h"
 #include "iree/hal/cuda/dynamic_symbols.h"
+#include "iree/hal/cuda/profiling.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif  // __cplusplus
 
+// Configures batching of small dispatches into persistent kernel launches.
+typedef struct iree_hal_cuda_persistent_dispatch_options_t {
+  // Dispatches with at most this many workgroups are batched.
+  uint32_t max_workgroup_count;
+  // Maximum number of blocks of a persistent kernel launch. Should cover the
+  // blocks that can be resident on the device at once.
+  uint32_t max_grid_size;
+  // Device memory holding IREE_HAL_CUDA_PERSISTENT_COUNTER_COUNT uint32_t
+  // counters. Reset before each launch so all launches must be issued in
+  // order on a single stream.
+  CUdeviceptr counters;
+} iree_hal_cuda_persistent_dispatch_options_t;
+
 // Creates a cuda stream command buffer that immediately
 // issues commands against the given |stream|.
 // Access to |stream| must be synchronized by the user.
 // Used for replaying commands in special situations and
 // never returned to a user from the device_create_command_buffer
+// Dispatches are timed with |profiling_context| if it is non-NULL and active.
+// Small dispatches are batched into persistent kernel launches if
+// |persistent_options| is non-NULL; batched dispatches are not timed.
 iree_status_t iree_hal_cuda_stream_command_buffer_create(
     iree_hal_cuda_context_wrapper_t *context,
+    iree_hal_cuda_profiling_context_t *profiling_context,
+    const iree_hal_cuda_persistent_dispatch_options_t *persistent_options,
     iree_hal_command_buffer_mode_t mode,
     iree_hal_command_category_t command_categories, CUstream stream,
     iree_hal_command_buffer_t **out_command_buffer);
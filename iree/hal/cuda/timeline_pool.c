@@ -0,0 +1,236 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/cuda/timeline_pool.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/cuda/status_util.h"
+
+// Size of each page of mapped host memory slots are suballocated from.
+#define IREE_HAL_CUDA_TIMELINE_POOL_PAGE_SIZE 4096
+
+#define IREE_HAL_CUDA_TIMELINE_POOL_SLOTS_PER_PAGE \
+  (IREE_HAL_CUDA_TIMELINE_POOL_PAGE_SIZE / sizeof(int64_t))
+
+// A page of mapped host memory.
+typedef struct iree_hal_cuda_timeline_page_t {
+  struct iree_hal_cuda_timeline_page_t* next;
+  void* host_ptr;
+} iree_hal_cuda_timeline_page_t;
+
+// A released slot that stream operations may still be pending on.
+typedef struct iree_hal_cuda_timeline_retired_slot_t {
+  struct iree_hal_cuda_timeline_retired_slot_t* next;
+  iree_hal_cuda_timeline_slot_t slot;
+  iree_host_size_t event_count;
+  CUevent events[];
+} iree_hal_cuda_timeline_retired_slot_t;
+
+struct iree_hal_cuda_timeline_pool_t {
+  iree_hal_cuda_context_wrapper_t* context;
+
+  // Guards all state below.
+  iree_slim_mutex_t mutex;
+  // All pages allocated by the pool.
+  iree_hal_cuda_timeline_page_t* page_head;
+  // Slots available for reuse.
+  iree_hal_cuda_timeline_slot_t* free_slots;
+  iree_host_size_t free_slot_count;
+  iree_host_size_t free_slot_capacity;
+  // Released slots waiting for their events to complete.
+  iree_hal_cuda_timeline_retired_slot_t* retired_head;
+};
+
+iree_status_t iree_hal_cuda_timeline_pool_allocate(
+    iree_hal_cuda_context_wrapper_t* context,
+    iree_hal_cuda_timeline_pool_t** out_pool) {
+  IREE_ASSERT_ARGUMENT(context);
+  IREE_ASSERT_ARGUMENT(out_pool);
+  iree_hal_cuda_timeline_pool_t* pool = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(context->host_allocator,
+                                             sizeof(*pool), (void**)&pool));
+  memset(pool, 0, sizeof(*pool));
+  pool->context = context;
+  iree_slim_mutex_initialize(&pool->mutex);
+  *out_pool = pool;
+  return iree_ok_status();
+}
+
+// Destroys the events of |retired_slot| and frees it.
+static void iree_hal_cuda_timeline_retired_slot_free(
+    iree_hal_cuda_timeline_pool_t* pool,
+    iree_hal_cuda_timeline_retired_slot_t* retired_slot) {
+  for (iree_host_size_t i = 0; i < retired_slot->event_count; ++i) {
+    CUDA_IGNORE_ERROR(pool->context->syms,
+                      cuEventDestroy(retired_slot->events[i]));
+  }
+  iree_allocator_free(pool->context->host_allocator, retired_slot);
+}
+
+void iree_hal_cuda_timeline_pool_free(iree_hal_cuda_timeline_pool_t* pool) {
+  if (!pool) return;
+  iree_hal_cuda_dynamic_symbols_t* syms = pool->context->syms;
+  iree_allocator_t host_allocator = pool->context->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  while (pool->retired_head) {
+    iree_hal_cuda_timeline_retired_slot_t* retired_slot = pool->retired_head;
+    pool->retired_head = retired_slot->next;
+    for (iree_host_size_t i = 0; i < retired_slot->event_count; ++i) {
+      CUDA_IGNORE_ERROR(syms, cuEventSynchronize(retired_slot->events[i]));
+    }
+    iree_hal_cuda_timeline_retired_slot_free(pool, retired_slot);
+  }
+  while (pool->page_head) {
+    iree_hal_cuda_timeline_page_t* page = pool->page_head;
+    pool->page_head = page->next;
+    CUDA_IGNORE_ERROR(syms, cuMemFreeHost(page->host_ptr));
+    iree_allocator_free(host_allocator, page);
+  }
+  iree_allocator_free(host_allocator, pool->free_slots);
+  iree_slim_mutex_deinitialize(&pool->mutex);
+  iree_allocator_free(host_allocator, pool);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+// Returns retired slots whose events have all completed to the free list.
+// Must be called with the lock held.
+static void iree_hal_cuda_timeline_pool_reclaim(
+    iree_hal_cuda_timeline_pool_t* pool) {
+  iree_hal_cuda_timeline_retired_slot_t** link = &pool->retired_head;
+  while (*link) {
+    iree_hal_cuda_timeline_retired_slot_t* retired_slot = *link;
+    bool completed = true;
+    for (iree_host_size_t i = 0; i < retired_slot->event_count && completed;
+         ++i) {
+      completed = pool->context->syms->cuEventQuery(retired_slot->events[i]) !=
+                  CUDA_ERROR_NOT_READY;
+    }
+    // There is always room as the slot came from the free list.
+    if (completed) {
+      *link = retired_slot->next;
+      pool->free_slots[pool->free_slot_count++] = retired_slot->slot;
+      iree_hal_cuda_timeline_retired_slot_free(pool, retired_slot);
+    } else {
+      link = &retired_slot->next;
+    }
+  }
+}
+
+// Allocates a new page and adds its slots to the free list.
+// Must be called with the lock held.
+static iree_status_t iree_hal_cuda_timeline_pool_grow(
+    iree_hal_cuda_timeline_pool_t* pool) {
+  iree_hal_cuda_dynamic_symbols_t* syms = pool->context->syms;
+  iree_allocator_t host_allocator = pool->context->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_host_size_t new_capacity =
+      pool->free_slot_capacity + IREE_HAL_CUDA_TIMELINE_POOL_SLOTS_PER_PAGE;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_realloc(host_allocator,
+                                 new_capacity * sizeof(*pool->free_slots),
+                                 (void**)&pool->free_slots));
+  pool->free_slot_capacity = new_capacity;
+
+  iree_hal_cuda_timeline_page_t* page = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, sizeof(*page), (void**)&page));
+  page->host_ptr = NULL;
+  iree_status_t status = CU_RESULT_TO_STATUS(
+      syms,
+      cuMemHostAlloc(&page->host_ptr, IREE_HAL_CUDA_TIMELINE_POOL_PAGE_SIZE,
+                     CU_MEMHOSTALLOC_DEVICEMAP | CU_MEMHOSTALLOC_PORTABLE),
+      "cuMemHostAlloc");
+  CUdeviceptr device_ptr = 0;
+  if (iree_status_is_ok(status)) {
+    status = CU_RESULT_TO_STATUS(
+        syms, cuMemHostGetDevicePointer(&device_ptr, page->host_ptr, 0),
+        "cuMemHostGetDevicePointer");
+  }
+  if (!iree_status_is_ok(status)) {
+    if (page->host_ptr) {
+      CUDA_IGNORE_ERROR(syms, cuMemFreeHost(page->host_ptr));
+    }
+    iree_allocator_free(host_allocator, page);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+  page->next = pool->page_head;
+  pool->page_head = page;
+
+  for (iree_host_size_t i = 0; i < IREE_HAL_CUDA_TIMELINE_POOL_SLOTS_PER_PAGE;
+       ++i) {
+    iree_hal_cuda_timeline_slot_t* slot =
+        &pool->free_slots[pool->free_slot_count++];
+    slot->host_ptr = (iree_atomic_int64_t*)page->host_ptr + i;
+    slot->device_ptr = device_ptr + i * sizeof(int64_t);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+iree_status_t iree_hal_cuda_timeline_pool_acquire(
+    iree_hal_cuda_timeline_pool_t* pool, uint64_t initial_value,
+    iree_hal_cuda_timeline_slot_t* out_slot) {
+  IREE_ASSERT_ARGUMENT(pool);
+  IREE_ASSERT_ARGUMENT(out_slot);
+  iree_slim_mutex_lock(&pool->mutex);
+  if (pool->free_slot_count == 0) {
+    iree_hal_cuda_timeline_pool_reclaim(pool);
+  }
+  iree_status_t status = iree_ok_status();
+  if (pool->free_slot_count == 0) {
+    status = iree_hal_cuda_timeline_pool_grow(pool);
+  }
+  if (iree_status_is_ok(status)) {
+    *out_slot = pool->free_slots[--pool->free_slot_count];
+  }
+  iree_slim_mutex_unlock(&pool->mutex);
+  IREE_RETURN_IF_ERROR(status);
+  iree_atomic_store_int64(out_slot->host_ptr, (int64_t)initial_value,
+                          iree_memory_order_release);
+  return iree_ok_status();
+}
+
+void iree_hal_cuda_timeline_pool_release(iree_hal_cuda_timeline_pool_t* pool,
+                                         iree_hal_cuda_timeline_slot_t slot,
+                                         iree_host_size_t event_count,
+                                         const CUevent* events) {
+  IREE_ASSERT_ARGUMENT(pool);
+  iree_hal_cuda_timeline_retired_slot_t* retired_slot = NULL;
+  if (event_count > 0) {
+    iree_status_t status = iree_allocator_malloc(
+        pool->context->host_allocator,
+        sizeof(*retired_slot) + event_count * sizeof(CUevent),
+        (void**)&retired_slot);
+    if (!iree_status_is_ok(status)) {
+      // Wait for the operations now instead of deferring reuse.
+      iree_status_ignore(status);
+      for (iree_host_size_t i = 0; i < event_count; ++i) {
+        CUDA_IGNORE_ERROR(pool->context->syms, cuEventSynchronize(events[i]));
+        CUDA_IGNORE_ERROR(pool->context->syms, cuEventDestroy(events[i]));
+      }
+    }
+  }
+
+  iree_slim_mutex_lock(&pool->mutex);
+  if (retired_slot) {
+    retired_slot->slot = slot;
+    retired_slot->event_count = event_count;
+    memcpy(retired_slot->events, events, event_count * sizeof(CUevent));
+    retired_slot->next = pool->retired_head;
+    pool->retired_head = retired_slot;
+  } else {
+    pool->free_slots[pool->free_slot_count++] = slot;
+  }
+  iree_slim_mutex_unlock(&pool->mutex);
+}
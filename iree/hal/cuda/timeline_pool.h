@@ -0,0 +1,63 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_CUDA_TIMELINE_POOL_H_
+#define IREE_HAL_CUDA_TIMELINE_POOL_H_
+
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
+#include "iree/hal/cuda/context_wrapper.h"
+#include "iree/hal/cuda/cuda_headers.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// A slot of mapped host memory holding the payload of a semaphore device
+// timeline. Written and read by the host through |host_ptr| and by stream
+// memory operations through |device_ptr|.
+typedef struct iree_hal_cuda_timeline_slot_t {
+  iree_atomic_int64_t* host_ptr;
+  CUdeviceptr device_ptr;
+} iree_hal_cuda_timeline_slot_t;
+
+// Suballocates device timeline payloads from pages of mapped host memory.
+// Each cuMemHostAlloc pins at least one page of memory so payloads are not
+// allocated individually. Slots are reused only once all stream operations
+// enqueued on them have completed.
+//
+// Thread-safe.
+typedef struct iree_hal_cuda_timeline_pool_t iree_hal_cuda_timeline_pool_t;
+
+// Allocates a pool of device timeline payloads in |context|.
+iree_status_t iree_hal_cuda_timeline_pool_allocate(
+    iree_hal_cuda_context_wrapper_t* context,
+    iree_hal_cuda_timeline_pool_t** out_pool);
+
+// Frees |pool| and the memory backing its slots. All slots must have been
+// released. Blocks until stream operations on released slots complete.
+void iree_hal_cuda_timeline_pool_free(iree_hal_cuda_timeline_pool_t* pool);
+
+// Acquires a slot from |pool| initialized to |initial_value|.
+iree_status_t iree_hal_cuda_timeline_pool_acquire(
+    iree_hal_cuda_timeline_pool_t* pool, uint64_t initial_value,
+    iree_hal_cuda_timeline_slot_t* out_slot);
+
+// Releases |slot| back to |pool| for reuse once the |event_count| |events|,
+// recorded after the last stream operations on the slot, have completed.
+// Takes ownership of the events.
+void iree_hal_cuda_timeline_pool_release(iree_hal_cuda_timeline_pool_t* pool,
+                                         iree_hal_cuda_timeline_slot_t slot,
+                                         iree_host_size_t event_count,
+                                         const CUevent* events);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_CUDA_TIMELINE_POOL_H_
@@ -6,6 +6,7 @@
 
 #include "iree/hal/device.h"
 
+#include "iree/base/internal/flight_recorder.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/detail.h"
 #include "iree/hal/resource.h"
@@ -81,8 +82,11 @@ IREE_API_EXPORT iree_status_t iree_hal_device_queue_submit(
   IREE_TRACE_ZONE_BEGIN(z0);
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
       z0, iree_hal_device_validate_submission(batch_count, batches));
+  IREE_FLIGHT_RECORD_BEGIN(IREE_FLIGHT_RECORDER_TRACK_HAL, "queue_submit",
+                           (int64_t)batch_count);
   iree_status_t status = _VTABLE_DISPATCH(device, queue_submit)(
       device, command_categories, queue_affinity, batch_count, batches);
+  IREE_FLIGHT_RECORD_END(IREE_FLIGHT_RECORDER_TRACK_HAL, "queue_submit");
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
@@ -98,9 +102,12 @@ IREE_API_EXPORT iree_status_t iree_hal_device_submit_and_wait(
   IREE_TRACE_ZONE_BEGIN(z0);
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
       z0, iree_hal_device_validate_submission(batch_count, batches));
+  IREE_FLIGHT_RECORD_BEGIN(IREE_FLIGHT_RECORDER_TRACK_HAL, "submit_and_wait",
+                           (int64_t)batch_count);
   iree_status_t status = _VTABLE_DISPATCH(device, submit_and_wait)(
       device, command_categories, queue_affinity, batch_count, batches,
       wait_semaphore, wait_value, timeout);
+  IREE_FLIGHT_RECORD_END(IREE_FLIGHT_RECORDER_TRACK_HAL, "submit_and_wait");
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
@@ -125,3 +132,46 @@ iree_hal_device_wait_idle(iree_hal_device_t* device, iree_timeout_t timeout) {
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
+
+IREE_API_EXPORT iree_status_t
+iree_hal_device_begin_dispatch_profiling(iree_hal_device_t* device) {
+  IREE_ASSERT_ARGUMENT(device);
+  if (!_VTABLE_DISPATCH(device, begin_dispatch_profiling)) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "dispatch profiling not supported by device");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_status_t status =
+      _VTABLE_DISPATCH(device, begin_dispatch_profiling)(device);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t
+iree_hal_device_end_dispatch_profiling(iree_hal_device_t* device) {
+  IREE_ASSERT_ARGUMENT(device);
+  if (!_VTABLE_DISPATCH(device, end_dispatch_profiling)) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "dispatch profiling not supported by device");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_status_t status =
+      _VTABLE_DISPATCH(device, end_dispatch_profiling)(device);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_device_flush_dispatch_profiles(
+    iree_hal_device_t* device, iree_hal_dispatch_profile_callback_t callback) {
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(callback.fn);
+  if (!_VTABLE_DISPATCH(device, flush_dispatch_profiles)) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "dispatch profiling not supported by device");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_status_t status =
+      _VTABLE_DISPATCH(device, flush_dispatch_profiles)(device, callback);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
@@ -109,6 +109,39 @@ typedef struct iree_hal_submission_batch_t {
   iree_hal_semaphore_list_t signal_semaphores;
 } iree_hal_submission_batch_t;
 
+// Device timing of a single dispatch captured while dispatch profiling is
+// active. See iree_hal_device_begin_dispatch_profiling.
+typedef struct iree_hal_dispatch_profile_t {
+  // Name of the executable entry point dispatched, if available.
+  // Only valid for the duration of the callback it is passed to.
+  iree_string_view_t entry_point_name;
+  // Ordinal of the entry point within its executable.
+  int32_t entry_point;
+  // Workgroup count of the dispatch or 0 for indirect dispatches.
+  uint32_t workgroup_count[3];
+  // Device time spent executing the dispatch, in nanoseconds.
+  uint64_t duration_ns;
+  // Total number of workgroups executed or 0 if not tracked by the device.
+  uint64_t tile_count;
+  // Number of units of work the dispatch was split into for scheduling across
+  // device execution units (such as CPU worker threads) or 0 if not tracked.
+  uint32_t shard_count;
+  // Number of units of work (out of |shard_count|) that were rebalanced onto
+  // an execution unit other than the one they were originally scheduled on.
+  uint32_t stolen_shard_count;
+} iree_hal_dispatch_profile_t;
+
+// Receives one completed dispatch |profile|. Returning an error stops the
+// flush and propagates the error to the caller.
+typedef iree_status_t(IREE_API_PTR* iree_hal_dispatch_profile_fn_t)(
+    void* user_data, const iree_hal_dispatch_profile_t* profile);
+
+// A callback receiving completed dispatch profiles.
+typedef struct iree_hal_dispatch_profile_callback_t {
+  iree_hal_dispatch_profile_fn_t fn;
+  void* user_data;
+} iree_hal_dispatch_profile_callback_t;
+
 // Defines how a multi-wait operation treats the results of multiple semaphores.
 typedef enum iree_hal_wait_mode_e {
   // Waits for all semaphores to reach or exceed their specified values.
@@ -161,6 +194,11 @@ IREE_API_EXPORT iree_hal_allocator_t* iree_hal_device_allocator(
 //   hal.device.architecture :: some-pattern-*
 //   hal.executable.format :: some-pattern-*
 //
+// Devices executing on the host CPU (local-sync/local-task) interpret
+// hal.device.feature keys as a comma-separated list of CPU features or
+// architecture levels (such as `+avx2,+fma` or `x86-64-v3`) that must all be
+// supported by the host; see iree_cpu_supports_features.
+//
 // Returned values must remain the same for the lifetime of the device as
 // callers may cache them to avoid redundant calls.
 IREE_API_EXPORT iree_status_t iree_hal_device_query_i32(
@@ -239,6 +277,33 @@ IREE_API_EXPORT iree_status_t iree_hal_device_wait_semaphores(
 IREE_API_EXPORT iree_status_t
 iree_hal_device_wait_idle(iree_hal_device_t* device, iree_timeout_t timeout);
 
+// Begins capturing the device execution time of each dispatch recorded into
+// command buffers created from |device| after this call. Any profiles captured
+// by a prior session that have not been flushed are discarded; all command
+// buffers recorded during the prior session must have completed execution.
+//
+// Profiling adds timing commands around each dispatch and may serialize work
+// that would otherwise overlap; it is intended for tracking kernel performance
+// in production telemetry without an attached profiler.
+//
+// Returns UNIMPLEMENTED if the device does not support dispatch profiling and
+// UNAVAILABLE if the physical device is unable to produce timestamps.
+IREE_API_EXPORT iree_status_t
+iree_hal_device_begin_dispatch_profiling(iree_hal_device_t* device);
+
+// Ends the dispatch profiling session started by
+// iree_hal_device_begin_dispatch_profiling. Dispatches recorded prior to this
+// call are still timed when executed and can be flushed after they complete.
+IREE_API_EXPORT iree_status_t
+iree_hal_device_end_dispatch_profiling(iree_hal_device_t* device);
+
+// Passes the profile of each captured dispatch that has completed execution
+// to |callback| and drops it. Profiles of dispatches still pending execution
+// are retained for a subsequent flush. Each recorded dispatch is reported once
+// (for the first time it is executed).
+IREE_API_EXPORT iree_status_t iree_hal_device_flush_dispatch_profiles(
+    iree_hal_device_t* device, iree_hal_dispatch_profile_callback_t callback);
+
 //===----------------------------------------------------------------------===//
 // iree_hal_device_t implementation details
 //===----------------------------------------------------------------------===//
@@ -314,6 +379,15 @@ typedef struct iree_hal_device_vtable_t {
 
   iree_status_t(IREE_API_PTR* wait_idle)(iree_hal_device_t* device,
                                          iree_timeout_t timeout);
+
+  // Optional; NULL if dispatch profiling is not supported by the device.
+  iree_status_t(IREE_API_PTR* begin_dispatch_profiling)(
+      iree_hal_device_t* device);
+  iree_status_t(IREE_API_PTR* end_dispatch_profiling)(
+      iree_hal_device_t* device);
+  iree_status_t(IREE_API_PTR* flush_dispatch_profiles)(
+      iree_hal_device_t* device,
+      iree_hal_dispatch_profile_callback_t callback);
 } iree_hal_device_vtable_t;
 
 IREE_API_EXPORT void iree_hal_device_destroy(iree_hal_device_t* device);
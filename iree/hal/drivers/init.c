@@ -20,6 +20,10 @@
 #include "iree/hal/dylib/registration/driver_module_sync.h"
 #endif  // IREE_HAL_HAVE_DYLIB_SYNC_DRIVER_MODULE
 
+#if defined(IREE_HAL_HAVE_METAL_DRIVER_MODULE)
+#include "iree/hal/metal/registration/driver_module.h"
+#endif  // IREE_HAL_HAVE_METAL_DRIVER_MODULE
+
 #if defined(IREE_HAL_HAVE_VMVX_DRIVER_MODULE)
 #include "iree/hal/vmvx/registration/driver_module.h"
 #endif  // IREE_HAL_HAVE_VMVX_DRIVER_MODULE
@@ -51,6 +55,11 @@ iree_hal_register_all_available_drivers(iree_hal_driver_registry_t* registry) {
       z0, iree_hal_dylib_sync_driver_module_register(registry));
 #endif  // IREE_HAL_HAVE_DYLIB_SYNC_DRIVER_MODULE
 
+#if defined(IREE_HAL_HAVE_METAL_DRIVER_MODULE)
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_metal_driver_module_register(registry));
+#endif  // IREE_HAL_HAVE_METAL_DRIVER_MODULE
+
 #if defined(IREE_HAL_HAVE_VMVX_DRIVER_MODULE)
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
       z0, iree_hal_vmvx_driver_module_register(registry));
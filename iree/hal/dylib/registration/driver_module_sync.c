@@ -10,7 +10,9 @@
 #include <stddef.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/flags.h"
 #include "iree/hal/local/executable_loader.h"
+#include "iree/hal/local/inline_thread_pool.h"
 #include "iree/hal/local/loaders/system_library_loader.h"
 #include "iree/hal/local/sync_device.h"
 #include "iree/hal/local/sync_driver.h"
@@ -20,25 +22,42 @@
 // added to it based on compilation settings we can have a single set of flags
 // for everything.
 
-#define IREE_HAL_DYLIB_SYNC_DRIVER_ID 0x53444C4Cu  // SDLL
+#define IREE_HAL_DYLIB_SYNC_DRIVER_ID 0x53444C4Cu             // SDLL
+#define IREE_HAL_DYLIB_INLINE_PARALLEL_DRIVER_ID 0x50444C4Cu  // PDLL
+
+IREE_FLAG(
+    int32_t, dylib_inline_parallel_worker_count, 3,
+    "Number of threads in addition to the calling thread that the\n"
+    "dylib-inline-parallel driver distributes dispatch workgroups across.\n"
+    "Command buffers still execute inline on the calling thread.");
 
 static iree_status_t iree_hal_dylib_sync_driver_factory_enumerate(
     void* self, const iree_hal_driver_info_t** out_driver_infos,
     iree_host_size_t* out_driver_info_count) {
-  static const iree_hal_driver_info_t default_driver_info = {
-      .driver_id = IREE_HAL_DYLIB_SYNC_DRIVER_ID,
-      .driver_name = iree_string_view_literal("dylib-sync"),
-      .full_name = iree_string_view_literal("AOT compiled dynamic libraries"),
+  static const iree_hal_driver_info_t driver_infos[2] = {
+      {
+          .driver_id = IREE_HAL_DYLIB_SYNC_DRIVER_ID,
+          .driver_name = iree_string_view_literal("dylib-sync"),
+          .full_name =
+              iree_string_view_literal("AOT compiled dynamic libraries"),
+      },
+      {
+          .driver_id = IREE_HAL_DYLIB_INLINE_PARALLEL_DRIVER_ID,
+          .driver_name = iree_string_view_literal("dylib-inline-parallel"),
+          .full_name = iree_string_view_literal(
+              "AOT compiled dynamic libraries (inline, parallel workgroups)"),
+      },
   };
-  *out_driver_info_count = 1;
-  *out_driver_infos = &default_driver_info;
+  *out_driver_info_count = IREE_ARRAYSIZE(driver_infos);
+  *out_driver_infos = driver_infos;
   return iree_ok_status();
 }
 
 static iree_status_t iree_hal_dylib_sync_driver_factory_try_create(
     void* self, iree_hal_driver_id_t driver_id, iree_allocator_t allocator,
     iree_hal_driver_t** out_driver) {
-  if (driver_id != IREE_HAL_DYLIB_SYNC_DRIVER_ID) {
+  if (driver_id != IREE_HAL_DYLIB_SYNC_DRIVER_ID &&
+      driver_id != IREE_HAL_DYLIB_INLINE_PARALLEL_DRIVER_ID) {
     return iree_make_status(IREE_STATUS_UNAVAILABLE,
                             "no driver with ID %016" PRIu64
                             " is provided by this factory",
@@ -48,9 +67,32 @@ static iree_status_t iree_hal_dylib_sync_driver_factory_try_create(
   iree_hal_sync_device_params_t default_params;
   iree_hal_sync_device_params_initialize(&default_params);
 
+  iree_status_t status = iree_ok_status();
+
+  // The driver and its devices retain the pool; our reference is dropped below.
+  iree_hal_inline_thread_pool_t* thread_pool = NULL;
+  if (driver_id == IREE_HAL_DYLIB_INLINE_PARALLEL_DRIVER_ID) {
+    if (FLAG_dylib_inline_parallel_worker_count < 0) {
+      status = iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "worker count must be >= 0 (got %d)",
+                                FLAG_dylib_inline_parallel_worker_count);
+    }
+    if (iree_status_is_ok(status)) {
+      status = iree_hal_inline_thread_pool_create(
+          (iree_host_size_t)FLAG_dylib_inline_parallel_worker_count, allocator,
+          &thread_pool);
+    }
+    if (iree_status_is_ok(status)) {
+      default_params.parallel_for =
+          iree_hal_inline_thread_pool_parallel_for(thread_pool);
+    }
+  }
+
   iree_hal_executable_loader_t* dylib_loader = NULL;
-  iree_status_t status = iree_hal_system_library_loader_create(
-      iree_hal_executable_import_provider_null(), allocator, &dylib_loader);
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_system_library_loader_create(
+        iree_hal_executable_import_provider_null(), allocator, &dylib_loader);
+  }
   iree_hal_executable_loader_t* loaders[1] = {dylib_loader};
 
   if (iree_status_is_ok(status)) {
@@ -60,6 +102,7 @@ static iree_status_t iree_hal_dylib_sync_driver_factory_try_create(
   }
 
   iree_hal_executable_loader_release(dylib_loader);
+  iree_hal_inline_thread_pool_release(thread_pool);
   return status;
 }
 
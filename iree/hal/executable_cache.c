@@ -66,3 +66,20 @@ IREE_API_EXPORT iree_status_t iree_hal_executable_cache_prepare_executable(
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
+
+IREE_API_EXPORT void iree_hal_executable_cache_preload_executables(
+    iree_hal_executable_cache_t* executable_cache,
+    iree_host_size_t executable_count,
+    const iree_const_byte_span_t* executable_datas) {
+  IREE_ASSERT_ARGUMENT(executable_cache);
+  IREE_ASSERT_ARGUMENT(!executable_count || executable_datas);
+  if (!executable_count ||
+      !_VTABLE_DISPATCH(executable_cache, preload_executables)) {
+    return;
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, executable_count);
+  _VTABLE_DISPATCH(executable_cache, preload_executables)(
+      executable_cache, executable_count, executable_datas);
+  IREE_TRACE_ZONE_END(z0);
+}
@@ -166,6 +166,23 @@ IREE_API_EXPORT iree_status_t iree_hal_executable_cache_prepare_executable(
     const iree_hal_executable_spec_t* executable_spec,
     iree_hal_executable_t** out_executable);
 
+// Preloads the executables contained in |executable_datas| such that later
+// calls to iree_hal_executable_cache_prepare_executable with the same data
+// complete quickly. Only the preparation work that does not depend on the
+// executable layouts (such as loading and relocating native code) is performed
+// ahead of time. Implementations may spread the work across multiple threads
+// and return once it has completed.
+//
+// The executable formats need not be known: data that the cache does not
+// recognize is ignored, allowing callers to pass every candidate blob (such as
+// all read-only data in a module) as soon as it is available. Failures to
+// preload are also ignored as preparation will fail with the same error.
+// Caches that do not support preloading ignore all data.
+IREE_API_EXPORT void iree_hal_executable_cache_preload_executables(
+    iree_hal_executable_cache_t* executable_cache,
+    iree_host_size_t executable_count,
+    const iree_const_byte_span_t* executable_datas);
+
 //===----------------------------------------------------------------------===//
 // iree_hal_executable_cache_t implementation details
 //===----------------------------------------------------------------------===//
@@ -185,6 +202,12 @@ typedef struct iree_hal_executable_cache_vtable_t {
       iree_hal_executable_cache_t* executable_cache,
       const iree_hal_executable_spec_t* executable_spec,
       iree_hal_executable_t** out_executable);
+
+  // Optional; NULL if the cache does not support preloading.
+  void(IREE_API_PTR* preload_executables)(
+      iree_hal_executable_cache_t* executable_cache,
+      iree_host_size_t executable_count,
+      const iree_const_byte_span_t* executable_datas);
 } iree_hal_executable_cache_vtable_t;
 
 IREE_API_EXPORT void iree_hal_executable_cache_destroy(
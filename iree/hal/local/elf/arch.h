@@ -44,6 +44,15 @@ iree_status_t iree_elf_arch_apply_relocations(
 // TODO(benvanik): add thunk functions (iree_elf_thunk_*) to be used by imports
 // for marshaling from linux ABI in the ELF to host ABI.
 
+// Defined to 1 when the host ABI matches the ELF ABI such that functions can
+// be called in either direction without marshaling and the iree_elf_call_*
+// functions are pass-throughs.
+#if defined(IREE_PLATFORM_WINDOWS)
+#define IREE_ELF_HOST_ABI_IS_NATIVE 0
+#else
+#define IREE_ELF_HOST_ABI_IS_NATIVE 1
+#endif  // IREE_PLATFORM_WINDOWS
+
 // void(*)(void)
 void iree_elf_call_v_v(const void* symbol_ptr);
 
@@ -9,10 +9,10 @@
 #include <inttypes.h>
 #include <string.h>
 
+#include "iree/base/internal/memory.h"
 #include "iree/base/target_platform.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/local/elf/arch.h"
-#include "iree/hal/local/elf/platform.h"
 
 //==============================================================================
 // Verification and section/info caching
@@ -31,6 +31,10 @@ typedef struct iree_elf_module_load_state_t {
   iree_elf_addr_t init;               // DT_INIT
   const iree_elf_addr_t* init_array;  // DT_INIT_ARRAY
   iree_host_size_t init_array_count;  // DT_INIT_ARRAYSZ
+
+  // Bit i is set if PT_LOAD phdr i was aliased from the source data instead
+  // of copied. Only the first 64 phdrs are eligible.
+  uint64_t aliased_phdr_mask;
 } iree_elf_module_load_state_t;
 
 // Verifies the ELF file header and machine class.
@@ -230,6 +234,80 @@ static iree_byte_range_t iree_elf_module_calculate_vaddr_range(
   return byte_range;
 }
 
+// Interprets the access bits of |phdr| and widens to the implicit allowable
+// permissions. See Table 7-37:
+// https://docs.oracle.com/cd/E19683-01/816-1386/6m7qcoblk/index.html#chapter6-34713
+static iree_memory_access_t iree_elf_module_segment_access(
+    const iree_elf_phdr_t* phdr) {
+  iree_memory_access_t access = 0;
+  if (phdr->p_flags & IREE_ELF_PF_R) access |= IREE_MEMORY_ACCESS_READ;
+  if (phdr->p_flags & IREE_ELF_PF_W) access |= IREE_MEMORY_ACCESS_WRITE;
+  if (phdr->p_flags & IREE_ELF_PF_X) access |= IREE_MEMORY_ACCESS_EXECUTE;
+  if (access & IREE_MEMORY_ACCESS_WRITE) access |= IREE_MEMORY_ACCESS_READ;
+  if (access & IREE_MEMORY_ACCESS_EXECUTE) access |= IREE_MEMORY_ACCESS_READ;
+  return access;
+}
+
+// Returns true if the ELF may apply relocations to non-writable segments.
+// The dynamic table has not been loaded yet so this reads it from the file.
+static bool iree_elf_module_has_text_relocations(
+    iree_const_byte_span_t raw_data, iree_elf_module_load_state_t* load_state) {
+  for (iree_elf_half_t i = 0; i < load_state->ehdr->e_phnum; ++i) {
+    const iree_elf_phdr_t* phdr = &load_state->phdr_table[i];
+    if (phdr->p_type != IREE_ELF_PT_DYNAMIC) continue;
+    if (phdr->p_offset + phdr->p_filesz > raw_data.data_length) return true;
+    const iree_elf_dyn_t* dyn_table =
+        (const iree_elf_dyn_t*)(raw_data.data + phdr->p_offset);
+    iree_host_size_t dyn_table_count = phdr->p_filesz / sizeof(*dyn_table);
+    for (iree_host_size_t j = 0; j < dyn_table_count; ++j) {
+      if (dyn_table[j].d_tag == IREE_ELF_DT_TEXTREL) return true;
+      if (dyn_table[j].d_tag == IREE_ELF_DT_FLAGS &&
+          (dyn_table[j].d_un.d_val & IREE_ELF_DF_TEXTREL)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// Returns true if the PT_LOAD segment at |phdr_index| may be aliased from the
+// source data: it must be read-only, never be written by relocation, be
+// entirely backed by the file, and not share any pages with other segments.
+static bool iree_elf_module_can_alias_segment(
+    iree_const_byte_span_t raw_data, iree_elf_module_load_state_t* load_state,
+    iree_elf_module_t* module, iree_elf_half_t phdr_index) {
+  if (phdr_index >= 64) return false;
+  const iree_elf_phdr_t* phdr = &load_state->phdr_table[phdr_index];
+  if (phdr->p_flags & IREE_ELF_PF_W) return false;
+  if (phdr->p_filesz == 0 || phdr->p_filesz != phdr->p_memsz) return false;
+
+  // Source and target must be congruent within a page.
+  iree_host_size_t page_size = load_state->memory_info.normal_page_size;
+  if ((((uintptr_t)raw_data.data + phdr->p_offset) & (page_size - 1)) !=
+      (((uintptr_t)module->vaddr_bias + phdr->p_vaddr) & (page_size - 1))) {
+    return false;
+  }
+
+  iree_elf_addr_t page_min = iree_page_align_start(phdr->p_vaddr, page_size);
+  iree_elf_addr_t page_max =
+      iree_page_align_end(phdr->p_vaddr + phdr->p_memsz, page_size);
+  for (iree_elf_half_t i = 0; i < load_state->ehdr->e_phnum; ++i) {
+    if (i == phdr_index) continue;
+    const iree_elf_phdr_t* other = &load_state->phdr_table[i];
+    if (other->p_type != IREE_ELF_PT_LOAD &&
+        other->p_type != IREE_ELF_PT_GNU_RELRO) {
+      continue;
+    }
+    iree_elf_addr_t other_min =
+        iree_page_align_start(other->p_vaddr, page_size);
+    iree_elf_addr_t other_max =
+        iree_page_align_end(other->p_vaddr + other->p_memsz, page_size);
+    if (other_min < page_max && page_min < other_max) return false;
+  }
+
+  return !iree_elf_module_has_text_relocations(raw_data, load_state);
+}
+
 // Allocates space for and loads all DT_LOAD segments into the host virtual
 // address space.
 static iree_status_t iree_elf_module_load_segments(
@@ -241,11 +319,19 @@ static iree_status_t iree_elf_module_load_segments(
 
   // Reserve virtual address space in the host memory space. This memory is
   // uncommitted by default as the ELF may only sparsely use the address space.
+  // Images spanning at least one large page request large pages to reduce the
+  // iTLB misses of executing large amounts of code.
   module->vaddr_size = iree_page_align_end(
       vaddr_range.length, load_state->memory_info.normal_page_size);
-  IREE_RETURN_IF_ERROR(iree_memory_view_reserve(
-      IREE_MEMORY_VIEW_FLAG_MAY_EXECUTE, module->vaddr_size,
-      module->host_allocator, (void**)&module->vaddr_base));
+  iree_memory_view_flags_t view_flags = IREE_MEMORY_VIEW_FLAG_MAY_EXECUTE;
+  if (load_state->memory_info.large_page_granularity >
+          load_state->memory_info.normal_page_size &&
+      module->vaddr_size >= load_state->memory_info.large_page_granularity) {
+    view_flags |= IREE_MEMORY_VIEW_FLAG_LARGE_PAGES;
+  }
+  IREE_RETURN_IF_ERROR(iree_memory_view_reserve(view_flags, module->vaddr_size,
+                                                module->host_allocator,
+                                                (void**)&module->vaddr_base));
   module->vaddr_bias = module->vaddr_base - vaddr_range.offset;
 
   // Commit and load all of the segments.
@@ -253,6 +339,21 @@ static iree_status_t iree_elf_module_load_segments(
     const iree_elf_phdr_t* phdr = &load_state->phdr_table[i];
     if (phdr->p_type != IREE_ELF_PT_LOAD) continue;
 
+    // Read-only segments needing no relocation may be able to directly
+    // reference the pages of the source data when it comes from a shareable
+    // mapping (memfd/file-backed). This avoids both the copy and the resident
+    // memory of a private duplicate.
+    if (iree_elf_module_can_alias_segment(raw_data, load_state, module, i)) {
+      iree_status_t alias_status = iree_memory_view_alias_range(
+          module->vaddr_bias + phdr->p_vaddr, raw_data.data + phdr->p_offset,
+          phdr->p_filesz, iree_elf_module_segment_access(phdr));
+      if (iree_status_is_ok(alias_status)) {
+        load_state->aliased_phdr_mask |= 1ull << i;
+        continue;
+      }
+      iree_status_ignore(alias_status);  // fall back to copying
+    }
+
     // Commit the range of pages used by this segment, initially with write
     // access so that we can modify the pages.
     iree_byte_range_t byte_range = {
@@ -264,13 +365,6 @@ static iree_status_t iree_elf_module_load_segments(
         IREE_MEMORY_ACCESS_READ | IREE_MEMORY_ACCESS_WRITE));
 
     // Copy data present in the file.
-    // TODO(benvanik): infra for being able to detect if the source model is in
-    // a mapped file - if it is, we can remap the page and directly reference it
-    // here for read-only segments and setup copy-on-write for writeable ones.
-    // We'd need a way to pass in the underlying mapping and some guarantees on
-    // the lifetime of it. Today we are just always committing above and copying
-    // here because it keeps this all super simple (you know, as simple as an
-    // entire custom ELF loader can be :).
     if (phdr->p_filesz > 0) {
       memcpy(module->vaddr_bias + phdr->p_vaddr, raw_data.data + phdr->p_offset,
              phdr->p_filesz);
@@ -298,16 +392,7 @@ static iree_status_t iree_elf_module_protect_segments(
   for (iree_elf_half_t i = 0; i < load_state->ehdr->e_phnum; ++i) {
     const iree_elf_phdr_t* phdr = &load_state->phdr_table[i];
     if (phdr->p_type != IREE_ELF_PT_LOAD) continue;
-
-    // Interpret the access bits and widen to the implicit allowable
-    // permissions. See Table 7-37:
-    // https://docs.oracle.com/cd/E19683-01/816-1386/6m7qcoblk/index.html#chapter6-34713
-    iree_memory_access_t access = 0;
-    if (phdr->p_flags & IREE_ELF_PF_R) access |= IREE_MEMORY_ACCESS_READ;
-    if (phdr->p_flags & IREE_ELF_PF_W) access |= IREE_MEMORY_ACCESS_WRITE;
-    if (phdr->p_flags & IREE_ELF_PF_X) access |= IREE_MEMORY_ACCESS_EXECUTE;
-    if (access & IREE_MEMORY_ACCESS_WRITE) access |= IREE_MEMORY_ACCESS_READ;
-    if (access & IREE_MEMORY_ACCESS_EXECUTE) access |= IREE_MEMORY_ACCESS_READ;
+    iree_memory_access_t access = iree_elf_module_segment_access(phdr);
 
     // We only support R+X (no W).
     if ((phdr->p_flags & IREE_ELF_PF_X) && (phdr->p_flags & IREE_ELF_PF_W)) {
@@ -315,13 +400,17 @@ static iree_status_t iree_elf_module_protect_segments(
                               "unable to create a writable executable segment");
     }
 
-    // Apply new access protection.
-    iree_byte_range_t byte_range = {
-        .offset = phdr->p_vaddr,
-        .length = phdr->p_memsz,
-    };
-    IREE_RETURN_IF_ERROR(iree_memory_view_protect_ranges(module->vaddr_bias, 1,
-                                                         &byte_range, access));
+    // Apply new access protection. Aliased segments had their final access
+    // applied when they were mapped.
+    bool is_aliased = i < 64 && (load_state->aliased_phdr_mask & (1ull << i));
+    if (!is_aliased) {
+      iree_byte_range_t byte_range = {
+          .offset = phdr->p_vaddr,
+          .length = phdr->p_memsz,
+      };
+      IREE_RETURN_IF_ERROR(iree_memory_view_protect_ranges(
+          module->vaddr_bias, 1, &byte_range, access));
+    }
 
     // Flush the instruction cache if we are going to execute these pages.
     if (access & IREE_MEMORY_ACCESS_EXECUTE) {
@@ -327,6 +327,10 @@ enum {
   IREE_ELF_DT_USED = 0x7ffffffe,          // d_val
 };
 
+enum {
+  IREE_ELF_DF_TEXTREL = 0x4,  // Relocations may modify non-writable segments
+};
+
 typedef struct {
   iree_elf32_sword_t d_tag;  // IREE_ELF_DT_*
   union {
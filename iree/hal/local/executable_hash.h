@@ -0,0 +1,66 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_LOCAL_EXECUTABLE_HASH_H_
+#define IREE_HAL_LOCAL_EXECUTABLE_HASH_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include "iree/base/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// 128-bit content hashing used to identify executables (and their loaded
+// images) by contents when sharing them process-wide. This is not a
+// cryptographic hash: it only rejects mismatches quickly and users must
+// compare the full contents before treating two executables as identical.
+
+// Initializes |hash| to the seed value used by all executable hashes.
+static inline void iree_hal_local_executable_hash_initialize(
+    uint64_t hash[2]) {
+  hash[0] = 0xCBF29CE484222325ull;
+  hash[1] = 0x84222325CBF29CE4ull;
+}
+
+static inline uint64_t iree_hal_local_executable_hash_mix(uint64_t value) {
+  value ^= value >> 33;
+  value *= 0xFF51AFD7ED558CCDull;
+  value ^= value >> 33;
+  value *= 0xC4CEB9FE1A85EC53ull;
+  value ^= value >> 33;
+  return value;
+}
+
+// Folds |data| into the two independent lanes of |hash|. Processes 8 bytes at
+// a time as hashing must stay much cheaper than loading.
+static inline void iree_hal_local_executable_hash_bytes(
+    const void* data, iree_host_size_t length, uint64_t hash[2]) {
+  const uint8_t* bytes = (const uint8_t*)data;
+  uint64_t h0 = hash[0] ^ (length * 0x9E3779B97F4A7C15ull);
+  uint64_t h1 = hash[1] + length;
+  iree_host_size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    uint64_t word = 0;
+    memcpy(&word, bytes + i, sizeof(word));
+    h0 = (h0 ^ iree_hal_local_executable_hash_mix(word)) * 0x100000001B3ull;
+    h1 = ((h1 + word) << 29 | (h1 + word) >> 35) * 0x9E3779B97F4A7C15ull;
+  }
+  uint64_t tail = 0;
+  memcpy(&tail, bytes + i, length - i);
+  h0 = iree_hal_local_executable_hash_mix(h0 ^ tail);
+  h1 = iree_hal_local_executable_hash_mix(h1 + tail);
+  hash[0] = h0;
+  hash[1] = h1;
+}
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_LOCAL_EXECUTABLE_HASH_H_
@@ -40,6 +40,15 @@
 // Defines a bitfield of features that the library requires or supports.
 enum iree_hal_executable_library_feature_bits_t {
   IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_NONE = 0u,
+  // Library provides a writable import binding table in
+  // iree_hal_executable_library_v0_t::import_bindings that the loader must
+  // populate with the resolved imports. See the field for details.
+  IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_DIRECT_IMPORTS = 1u << 0,
+  // Library entry points expect denormal floating-point values to be flushed
+  // to zero (FTZ/DAZ). The runtime sets up the FPU state of the threads
+  // executing the workgroups and only switches it when going between
+  // dispatches with different requirements.
+  IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_FLUSH_DENORMALS_TO_ZERO = 1u << 1,
   // TODO(benvanik): declare features for debugging/coverage/printf/etc.
   // These will control which symbols are injected into the library at runtime.
 };
@@ -227,7 +236,8 @@ typedef struct iree_hal_executable_dispatch_state_v0_t {
   // The length of each binding in bytes, 1:1 with |binding_ptrs|.
   const size_t* binding_lengths;
 
-  // Thunk function for calling imports. All calls must be made through this.
+  // Thunk function for calling imports. All calls must be made through this
+  // unless the library requested direct binding of its imports.
   iree_hal_executable_import_thunk_v0_t import_thunk;
   // Optional imported functions available for use within the executable.
   // Contains one entry per imported function. If an import was marked as weak
@@ -259,6 +269,9 @@ typedef int (*iree_hal_executable_dispatch_v0_t)(
 // This is chosen to match the common page size of devices.
 #define IREE_HAL_WORKGROUP_LOCAL_MEMORY_PAGE_SIZE 4096
 
+// Approximate number of scalar operations per unit of workgroup cost.
+#define IREE_HAL_WORKGROUP_COST_UNIT 1024
+
 // Attributes for exported dispatch functions defining how they are to be
 // executed. 0 defaults are well-specified and the entire attributes table may
 // be omitted if no dispatch functions require these fields.
@@ -267,9 +280,12 @@ typedef struct iree_hal_executable_dispatch_attrs_v0_t {
   // indicating how much workgroup local memory is required for the dispatch.
   // This is the size of the buffer referenced by the `local_memory` argument.
   uint16_t local_memory_pages;
-  // Must be 0. May be used in the future for flags controlling the dispatch
-  // behavior/synchronization requirements.
-  uint16_t reserved;
+  // Estimated cost of executing a single workgroup in units of
+  // IREE_HAL_WORKGROUP_COST_UNIT approximate scalar operations (saturating) or
+  // 0 if unknown. Runtimes may use this to decide how widely to distribute
+  // workgroups: cheap dispatches may be run on fewer threads than expensive
+  // ones to avoid the overhead of waking threads with little to do.
+  uint16_t workgroup_cost;
 } iree_hal_executable_dispatch_attrs_v0_t;
 static_assert(sizeof(iree_hal_executable_dispatch_attrs_v0_t) == 4, "uint32_t");
 
@@ -320,6 +336,19 @@ typedef struct iree_hal_executable_library_v0_t {
 
   // Table of exported functions from the executable.
   iree_hal_executable_export_table_v0_t exports;
+
+  // Writable table of |imports.count| entries 1:1 with |imports.symbols| used
+  // for direct import binding. Only present when the library header declares
+  // IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_DIRECT_IMPORTS and otherwise must not
+  // be accessed (libraries predating the feature do not have the field).
+  //
+  // The loader writes the resolved function pointer of each import into the
+  // table prior to running any entry point (NULL for unavailable weak imports)
+  // and the executable may call the entries directly instead of routing
+  // through the dispatch state |import_thunk| and |imports|. Loaders that must
+  // marshal calls between the executable and host ABIs fail to load libraries
+  // requiring the feature.
+  iree_hal_executable_import_v0_t* import_bindings;
 } iree_hal_executable_library_v0_t;
 
 #endif  // IREE_HAL_LOCAL_EXECUTABLE_LIBRARY_H_
@@ -10,7 +10,10 @@
 #include <string.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
 #include "iree/base/internal/flags.h"
+#include "iree/base/internal/fpu_state.h"
+#include "iree/base/internal/threading.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/api.h"
 #include "iree/hal/local/executable_library.h"
@@ -20,6 +23,11 @@
 #include "iree/hal/local/local_executable_layout.h"
 #include "iree/testing/benchmark.h"
 
+// flatcc schemas:
+#include "iree/base/internal/flatcc.h"
+#include "iree/schemas/bytecode_module_def_reader.h"
+#include "iree/schemas/bytecode_module_def_verifier.h"
+
 IREE_FLAG(string, executable_format, "",
           "Format of the executable file being loaded.");
 IREE_FLAG(string, executable_file, "",
@@ -45,6 +53,33 @@ IREE_FLAG(int32_t, workgroup_size_y, 1,
 IREE_FLAG(int32_t, workgroup_size_z, 1,
           "Z dimension of the workgroup size passed to the executable.");
 
+IREE_FLAG(bool, suite, false,
+          "Benchmarks every entry point of the executable instead of only\n"
+          "--entry_point, once per thread count in --suite_thread_counts.\n"
+          "Bindings are zero-initialized buffers sized by\n"
+          "--suite_params_file or --suite_binding_count/size.");
+IREE_FLAG(string, module_file, "",
+          "Path to a compiled module (.vmfb) whose embedded executables are\n"
+          "all benchmarked in --suite mode instead of --executable_file.\n"
+          "Executables that --executable_format cannot load are skipped.");
+IREE_FLAG(string, suite_params_file, "",
+          "Path to a file with per-entry point dispatch parameters used in\n"
+          "--suite mode. Each line names an entry point followed by any of:\n"
+          "  workgroup_count=X,Y,Z workgroup_size=X,Y,Z\n"
+          "  push_constants=A,B,... bindings=BYTES,BYTES,...\n"
+          "Omitted parameters use the values of the non-suite flags.\n"
+          "Lines starting with # are ignored.");
+IREE_FLAG(string, suite_thread_counts, "1",
+          "Comma-separated list of thread counts each entry point is\n"
+          "benchmarked with in --suite mode. Workgroups are distributed\n"
+          "dynamically across the threads.");
+IREE_FLAG(int32_t, suite_binding_count, 8,
+          "Number of bindings passed to entry points without parameters in\n"
+          "--suite_params_file.");
+IREE_FLAG(int64_t, suite_binding_size, 16 * 1024 * 1024,
+          "Size in bytes of each binding passed to entry points without\n"
+          "parameters in --suite_params_file.");
+
 // Total number of bindings we (currently) allow any executable to have.
 #define IREE_HAL_LOCAL_MAX_TOTAL_BINDING_COUNT \
   (IREE_HAL_LOCAL_MAX_DESCRIPTOR_SET_COUNT *   \
@@ -336,6 +371,611 @@ static iree_status_t iree_hal_executable_library_run(
   return iree_ok_status();
 }
 
+//===----------------------------------------------------------------------===//
+// Kernel suite
+//===----------------------------------------------------------------------===//
+// Benchmarks every entry point of one or more executables in isolation. Each
+// entry point is registered once per thread count so that the time per
+// workgroup and the scaling of a kernel across cores can be compared without
+// the task system or the rest of the HAL involved.
+
+// Dispatch parameters of an entry point in the suite.
+typedef struct iree_hal_suite_params_t {
+  // Name of the entry point the parameters apply to or empty for defaults.
+  iree_string_view_t entry_point_name;
+  uint32_t workgroup_count[3];
+  uint32_t workgroup_size[3];
+  iree_host_size_t push_constant_count;
+  uint32_t push_constants[IREE_HAL_LOCAL_MAX_PUSH_CONSTANT_COUNT];
+  iree_host_size_t binding_count;
+  uint64_t binding_lengths[IREE_HAL_LOCAL_MAX_TOTAL_BINDING_COUNT];
+} iree_hal_suite_params_t;
+
+// Parameters from the flags used for entry points not in the params file.
+static iree_hal_suite_params_t suite_default_params;
+
+// Parameters parsed from --suite_params_file.
+static iree_host_size_t suite_params_count = 0;
+static iree_hal_suite_params_t* suite_params = NULL;
+
+// A registered suite benchmark of a single entry point and thread count.
+typedef struct iree_hal_suite_case_t {
+  // Must be first so that the case can be found from the definition.
+  iree_benchmark_def_t benchmark_def;
+  iree_hal_local_executable_t* executable;
+  iree_host_size_t entry_point;
+  int32_t thread_count;
+  const iree_hal_suite_params_t* params;
+} iree_hal_suite_case_t;
+
+static void iree_hal_suite_initialize_default_params(
+    iree_hal_suite_params_t* params) {
+  memset(params, 0, sizeof(*params));
+  params->workgroup_count[0] = FLAG_workgroup_count_x;
+  params->workgroup_count[1] = FLAG_workgroup_count_y;
+  params->workgroup_count[2] = FLAG_workgroup_count_z;
+  params->workgroup_size[0] = FLAG_workgroup_size_x;
+  params->workgroup_size[1] = FLAG_workgroup_size_y;
+  params->workgroup_size[2] = FLAG_workgroup_size_z;
+  params->push_constant_count = dispatch_params.push_constant_count;
+  for (iree_host_size_t i = 0; i < params->push_constant_count; ++i) {
+    params->push_constants[i] = dispatch_params.push_constants[i].ui32;
+  }
+  params->binding_count =
+      iree_min((iree_host_size_t)iree_max(FLAG_suite_binding_count, 0),
+               IREE_ARRAYSIZE(params->binding_lengths));
+  for (iree_host_size_t i = 0; i < params->binding_count; ++i) {
+    params->binding_lengths[i] = (uint64_t)FLAG_suite_binding_size;
+  }
+}
+
+// Parses a comma-separated list of at most |capacity| integers into |values|.
+static iree_status_t iree_hal_suite_parse_integers(
+    iree_string_view_t value, iree_host_size_t capacity, uint64_t* values,
+    iree_host_size_t* out_count) {
+  *out_count = 0;
+  iree_string_view_t remaining = value;
+  while (!iree_string_view_is_empty(remaining)) {
+    iree_string_view_t item;
+    iree_string_view_split(remaining, ',', &item, &remaining);
+    if (*out_count >= capacity ||
+        !iree_string_view_atoi_uint64(iree_string_view_trim(item),
+                                      &values[*out_count])) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "expected at most %zu comma-separated integers "
+                              "but got '%.*s'",
+                              capacity, (int)value.size, value.data);
+    }
+    ++*out_count;
+  }
+  return iree_ok_status();
+}
+
+// Parses a single `key=value` pair from a params file line into |params|.
+static iree_status_t iree_hal_suite_parse_param(
+    iree_string_view_t key_value, iree_hal_suite_params_t* params) {
+  iree_string_view_t key = iree_string_view_empty();
+  iree_string_view_t value = iree_string_view_empty();
+  if (iree_string_view_split(key_value, '=', &key, &value) == -1) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "expected key=value but got '%.*s'",
+                            (int)key_value.size, key_value.data);
+  }
+  uint64_t values[IREE_HAL_LOCAL_MAX_PUSH_CONSTANT_COUNT];
+  iree_host_size_t count = 0;
+  uint32_t* xyz = NULL;
+  if (iree_string_view_equal(key, iree_make_cstring_view("workgroup_count"))) {
+    xyz = params->workgroup_count;
+  } else if (iree_string_view_equal(key,
+                                    iree_make_cstring_view("workgroup_size"))) {
+    xyz = params->workgroup_size;
+  }
+  if (xyz) {
+    IREE_RETURN_IF_ERROR(
+        iree_hal_suite_parse_integers(value, 3, values, &count));
+    if (count != 3) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "expected X,Y,Z but got '%.*s'", (int)value.size,
+                              value.data);
+    }
+    for (iree_host_size_t i = 0; i < 3; ++i) xyz[i] = (uint32_t)values[i];
+  } else if (iree_string_view_equal(key,
+                                    iree_make_cstring_view("push_constants"))) {
+    IREE_RETURN_IF_ERROR(iree_hal_suite_parse_integers(
+        value, IREE_ARRAYSIZE(params->push_constants), values, &count));
+    params->push_constant_count = count;
+    for (iree_host_size_t i = 0; i < count; ++i) {
+      params->push_constants[i] = (uint32_t)values[i];
+    }
+  } else if (iree_string_view_equal(key, iree_make_cstring_view("bindings"))) {
+    IREE_RETURN_IF_ERROR(iree_hal_suite_parse_integers(
+        value, IREE_ARRAYSIZE(params->binding_lengths),
+        params->binding_lengths, &params->binding_count));
+  } else {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "unknown suite parameter '%.*s'", (int)key.size,
+                            key.data);
+  }
+  return iree_ok_status();
+}
+
+// Loads the per-entry point parameters from |path|. The file contents are
+// retained for the lifetime of the process as the parameters reference them.
+static iree_status_t iree_hal_suite_load_params(
+    const char* path, iree_allocator_t host_allocator) {
+  iree_byte_span_t contents;
+  IREE_RETURN_IF_ERROR(
+      iree_file_read_contents(path, host_allocator, &contents));
+  iree_string_view_t remaining =
+      iree_make_string_view((const char*)contents.data, contents.data_length);
+
+  // Each line has at most one entry.
+  iree_host_size_t line_capacity = 1;
+  for (iree_host_size_t i = 0; i < remaining.size; ++i) {
+    if (remaining.data[i] == '\n') ++line_capacity;
+  }
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      host_allocator, line_capacity * sizeof(*suite_params),
+      (void**)&suite_params));
+
+  while (!iree_string_view_is_empty(remaining)) {
+    iree_string_view_t line;
+    iree_string_view_split(remaining, '\n', &line, &remaining);
+    line = iree_string_view_trim(line);
+    if (iree_string_view_is_empty(line) || line.data[0] == '#') continue;
+    iree_hal_suite_params_t* params = &suite_params[suite_params_count++];
+    *params = suite_default_params;
+    iree_string_view_t key_values;
+    iree_string_view_split(line, ' ', &params->entry_point_name, &key_values);
+    while (!iree_string_view_is_empty(key_values)) {
+      iree_string_view_t key_value;
+      iree_string_view_split(key_values, ' ', &key_value, &key_values);
+      key_value = iree_string_view_trim(key_value);
+      if (iree_string_view_is_empty(key_value)) continue;
+      IREE_RETURN_IF_ERROR(
+          iree_hal_suite_parse_param(key_value, params),
+          "parsing parameters of '%.*s' in '%s'",
+          (int)params->entry_point_name.size, params->entry_point_name.data,
+          path);
+    }
+  }
+  return iree_ok_status();
+}
+
+// Returns the parameters for |entry_point_name|; the last matching line in the
+// params file takes precedence.
+static const iree_hal_suite_params_t* iree_hal_suite_lookup_params(
+    iree_string_view_t entry_point_name) {
+  for (iree_host_size_t i = suite_params_count; i > 0; --i) {
+    if (iree_string_view_equal(suite_params[i - 1].entry_point_name,
+                               entry_point_name)) {
+      return &suite_params[i - 1];
+    }
+  }
+  return &suite_default_params;
+}
+
+// Shared state of a dispatch distributed across the suite threads.
+typedef struct iree_hal_suite_dispatch_t {
+  iree_hal_local_executable_t* executable;
+  iree_host_size_t entry_point;
+  const iree_hal_executable_dispatch_state_v0_t* dispatch_state;
+  int32_t workgroup_total;
+  // Incremented by the benchmark thread to start each dispatch.
+  iree_atomic_int32_t epoch;
+  // Set to nonzero when the worker threads should exit.
+  iree_atomic_int32_t exit_requested;
+  // Linearized index of the next workgroup to claim.
+  iree_atomic_int32_t next_workgroup;
+  // Number of workgroups of the current dispatch that have completed.
+  iree_atomic_int32_t completed_workgroups;
+  // Status code of the last workgroup that failed or IREE_STATUS_OK.
+  iree_atomic_int32_t status_code;
+} iree_hal_suite_dispatch_t;
+
+typedef struct iree_hal_suite_worker_t {
+  iree_hal_suite_dispatch_t* dispatch;
+  iree_byte_span_t local_memory;
+  iree_thread_t* thread;
+} iree_hal_suite_worker_t;
+
+// Claims and runs workgroups of the current dispatch until none remain.
+static void iree_hal_suite_run_workgroups(iree_hal_suite_dispatch_t* dispatch,
+                                          iree_byte_span_t local_memory) {
+  const iree_hal_vec3_t workgroup_count =
+      dispatch->dispatch_state->workgroup_count;
+  int32_t index = 0;
+  while ((index = iree_atomic_fetch_add_int32(&dispatch->next_workgroup, 1,
+                                              iree_memory_order_acq_rel)) <
+         dispatch->workgroup_total) {
+    iree_hal_vec3_t workgroup_id = {{
+        .x = index % workgroup_count.x,
+        .y = (index / workgroup_count.x) % workgroup_count.y,
+        .z = index / (workgroup_count.x * workgroup_count.y),
+    }};
+    iree_status_t status = iree_hal_local_executable_issue_call(
+        dispatch->executable, dispatch->entry_point, dispatch->dispatch_state,
+        &workgroup_id, local_memory);
+    if (!iree_status_is_ok(status)) {
+      iree_atomic_store_int32(&dispatch->status_code, iree_status_code(status),
+                              iree_memory_order_release);
+      iree_status_ignore(status);
+    }
+    iree_atomic_fetch_add_int32(&dispatch->completed_workgroups, 1,
+                                iree_memory_order_acq_rel);
+  }
+}
+
+static int iree_hal_suite_worker_main(void* entry_arg) {
+  iree_hal_suite_worker_t* worker = (iree_hal_suite_worker_t*)entry_arg;
+  iree_hal_suite_dispatch_t* dispatch = worker->dispatch;
+  iree_fpu_state_t fpu_state =
+      iree_fpu_state_push(dispatch->executable->fpu_state_flags);
+  int32_t last_epoch = 0;
+  while (!iree_atomic_load_int32(&dispatch->exit_requested,
+                                 iree_memory_order_acquire)) {
+    int32_t epoch =
+        iree_atomic_load_int32(&dispatch->epoch, iree_memory_order_acquire);
+    if (epoch == last_epoch) {
+      iree_thread_yield();
+      continue;
+    }
+    last_epoch = epoch;
+    iree_hal_suite_run_workgroups(dispatch, worker->local_memory);
+  }
+  iree_fpu_state_pop(fpu_state);
+  return 0;
+}
+
+// NOTE: like iree_hal_executable_library_run this does not clean up on
+// failure.
+static iree_status_t iree_hal_suite_run(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  const iree_hal_suite_case_t* suite_case =
+      (const iree_hal_suite_case_t*)benchmark_def;
+  const iree_hal_suite_params_t* params = suite_case->params;
+  iree_hal_local_executable_t* executable = suite_case->executable;
+  iree_allocator_t host_allocator = benchmark_state->host_allocator;
+
+  // Zero-initialized storage for each binding. The contents are meaningless but
+  // with the binding lengths of the dispatch all accesses are in-bounds.
+  void* binding_ptrs[IREE_HAL_LOCAL_MAX_TOTAL_BINDING_COUNT];
+  size_t binding_lengths[IREE_HAL_LOCAL_MAX_TOTAL_BINDING_COUNT];
+  for (iree_host_size_t i = 0; i < params->binding_count; ++i) {
+    binding_lengths[i] = (size_t)params->binding_lengths[i];
+    IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+        host_allocator, iree_max(binding_lengths[i], 1), &binding_ptrs[i]));
+    memset(binding_ptrs[i], 0, binding_lengths[i]);
+  }
+
+  iree_hal_executable_dispatch_state_v0_t dispatch_state = {
+      .workgroup_count = {{
+          .x = params->workgroup_count[0],
+          .y = params->workgroup_count[1],
+          .z = params->workgroup_count[2],
+      }},
+      .workgroup_size = {{
+          .x = params->workgroup_size[0],
+          .y = params->workgroup_size[1],
+          .z = params->workgroup_size[2],
+      }},
+      .push_constant_count = params->push_constant_count,
+      .push_constants = params->push_constants,
+      .binding_count = params->binding_count,
+      .binding_ptrs = binding_ptrs,
+      .binding_lengths = binding_lengths,
+      .import_thunk = executable->import_thunk,
+      .imports = executable->imports,
+  };
+
+  iree_hal_suite_dispatch_t dispatch;
+  memset(&dispatch, 0, sizeof(dispatch));
+  dispatch.executable = executable;
+  dispatch.entry_point = suite_case->entry_point;
+  dispatch.dispatch_state = &dispatch_state;
+  dispatch.workgroup_total = (int32_t)(params->workgroup_count[0] *
+                                       params->workgroup_count[1] *
+                                       params->workgroup_count[2]);
+
+  // Each thread gets its own workgroup-local memory. The benchmark thread is
+  // worker 0 and runs workgroups alongside the others.
+  iree_host_size_t local_memory_size =
+      executable->dispatch_attrs
+          ? executable->dispatch_attrs[suite_case->entry_point]
+                    .local_memory_pages *
+                IREE_HAL_WORKGROUP_LOCAL_MEMORY_PAGE_SIZE
+          : 0;
+  iree_host_size_t worker_count = (iree_host_size_t)suite_case->thread_count;
+  iree_hal_suite_worker_t* workers = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      host_allocator, worker_count * sizeof(*workers), (void**)&workers));
+  memset(workers, 0, worker_count * sizeof(*workers));
+  for (iree_host_size_t i = 0; i < worker_count; ++i) {
+    workers[i].dispatch = &dispatch;
+    if (local_memory_size > 0) {
+      IREE_RETURN_IF_ERROR(
+          iree_allocator_malloc(host_allocator, local_memory_size,
+                                (void**)&workers[i].local_memory.data));
+      workers[i].local_memory.data_length = local_memory_size;
+    }
+  }
+  iree_thread_create_params_t thread_params;
+  memset(&thread_params, 0, sizeof(thread_params));
+  thread_params.name = iree_make_cstring_view("suite_worker");
+  for (iree_host_size_t i = 1; i < worker_count; ++i) {
+    IREE_RETURN_IF_ERROR(iree_thread_create(iree_hal_suite_worker_main,
+                                            &workers[i], thread_params,
+                                            host_allocator,
+                                            &workers[i].thread));
+  }
+
+  // Each iteration runs through the whole grid (see
+  // iree_hal_executable_library_run for why).
+  iree_status_t status = iree_ok_status();
+  iree_fpu_state_t fpu_state =
+      iree_fpu_state_push(executable->fpu_state_flags);
+  int64_t dispatch_count = 0;
+  while (iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    iree_atomic_store_int32(&dispatch.completed_workgroups, 0,
+                            iree_memory_order_release);
+    iree_atomic_store_int32(&dispatch.next_workgroup, 0,
+                            iree_memory_order_release);
+    iree_atomic_fetch_add_int32(&dispatch.epoch, 1, iree_memory_order_acq_rel);
+    iree_hal_suite_run_workgroups(&dispatch, workers[0].local_memory);
+    while (iree_atomic_load_int32(&dispatch.completed_workgroups,
+                                  iree_memory_order_acquire) <
+           dispatch.workgroup_total) {
+      // Spin; the remaining workgroups are already running.
+    }
+    iree_status_code_t status_code = (iree_status_code_t)iree_atomic_load_int32(
+        &dispatch.status_code, iree_memory_order_acquire);
+    if (status_code != IREE_STATUS_OK) {
+      status = iree_make_status(status_code, "entry point %zu failed",
+                                suite_case->entry_point);
+      break;
+    }
+    ++dispatch_count;
+  }
+  iree_fpu_state_pop(fpu_state);
+
+  // Items are workgroups so that the reporter output includes the time per
+  // workgroup in addition to the time per dispatch.
+  iree_benchmark_set_items_processed(benchmark_state,
+                                     dispatch_count * dispatch.workgroup_total);
+  char label[64];
+  snprintf(label, sizeof(label), "%d workgroups, %d threads",
+           dispatch.workgroup_total, suite_case->thread_count);
+  iree_benchmark_set_label(benchmark_state, label);
+
+  // Stop (and join) the worker threads.
+  iree_atomic_store_int32(&dispatch.exit_requested, 1,
+                          iree_memory_order_release);
+  for (iree_host_size_t i = 0; i < worker_count; ++i) {
+    iree_thread_release(workers[i].thread);
+    iree_allocator_free(host_allocator, workers[i].local_memory.data);
+  }
+  iree_allocator_free(host_allocator, workers);
+  for (iree_host_size_t i = 0; i < params->binding_count; ++i) {
+    iree_allocator_free(host_allocator, binding_ptrs[i]);
+  }
+  return status;
+}
+
+// Loads |executable_data| and registers a benchmark for each of its entry
+// points and each of the |thread_counts|. The executable and the benchmark
+// cases are retained for the lifetime of the process.
+static iree_status_t iree_hal_suite_register_executable(
+    iree_hal_executable_loader_t* executable_loader,
+    iree_const_byte_span_t executable_data, const char* executable_name,
+    const int32_t* thread_counts, iree_host_size_t thread_count_count,
+    iree_allocator_t host_allocator) {
+  iree_hal_executable_spec_t executable_spec;
+  iree_hal_executable_spec_initialize(&executable_spec);
+  executable_spec.caching_mode =
+      IREE_HAL_EXECUTABLE_CACHING_MODE_ALLOW_OPTIMIZATION |
+      IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA |
+      IREE_HAL_EXECUTABLE_CACHING_MODE_DISABLE_VERIFICATION;
+  executable_spec.executable_format =
+      iree_make_cstring_view(FLAG_executable_format);
+  executable_spec.executable_data = executable_data;
+  iree_hal_executable_t* executable = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_executable_loader_try_load(
+      executable_loader, &executable_spec, &executable));
+  iree_hal_local_executable_t* local_executable =
+      iree_hal_local_executable_cast(executable);
+
+  iree_host_size_t entry_point_count = local_executable->entry_point_count;
+  iree_hal_suite_case_t* suite_cases = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      host_allocator,
+      entry_point_count * thread_count_count * sizeof(*suite_cases),
+      (void**)&suite_cases));
+  for (iree_host_size_t i = 0; i < entry_point_count; ++i) {
+    iree_string_view_t entry_point_name =
+        iree_hal_local_executable_entry_point_name(local_executable, i);
+    for (iree_host_size_t j = 0; j < thread_count_count; ++j) {
+      iree_hal_suite_case_t* suite_case =
+          &suite_cases[i * thread_count_count + j];
+      memset(suite_case, 0, sizeof(*suite_case));
+      suite_case->benchmark_def.flags =
+          IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+          IREE_BENCHMARK_FLAG_USE_REAL_TIME;
+      suite_case->benchmark_def.time_unit = IREE_BENCHMARK_UNIT_NANOSECOND;
+      suite_case->benchmark_def.run = iree_hal_suite_run;
+      suite_case->executable = local_executable;
+      suite_case->entry_point = i;
+      suite_case->thread_count = thread_counts[j];
+      suite_case->params = iree_hal_suite_lookup_params(entry_point_name);
+      char name[256];
+      int name_length = 0;
+      if (iree_string_view_is_empty(entry_point_name)) {
+        name_length = snprintf(name, sizeof(name), "%s/%zu/threads:%d",
+                               executable_name, i, thread_counts[j]);
+      } else {
+        name_length = snprintf(name, sizeof(name), "%s/%.*s/threads:%d",
+                               executable_name, (int)entry_point_name.size,
+                               entry_point_name.data, thread_counts[j]);
+      }
+      iree_benchmark_register(
+          iree_make_string_view(
+              name, iree_min((iree_host_size_t)name_length, sizeof(name) - 1)),
+          &suite_case->benchmark_def);
+    }
+  }
+  return iree_ok_status();
+}
+
+// Registers the suite benchmarks for --executable_file or for every executable
+// embedded in --module_file.
+static iree_status_t iree_hal_suite_register(iree_allocator_t host_allocator) {
+  iree_hal_suite_initialize_default_params(&suite_default_params);
+  if (strlen(FLAG_suite_params_file) > 0) {
+    IREE_RETURN_IF_ERROR(
+        iree_hal_suite_load_params(FLAG_suite_params_file, host_allocator));
+  }
+
+  uint64_t thread_count_values[64];
+  iree_host_size_t thread_count_count = 0;
+  IREE_RETURN_IF_ERROR(iree_hal_suite_parse_integers(
+      iree_make_cstring_view(FLAG_suite_thread_counts),
+      IREE_ARRAYSIZE(thread_count_values), thread_count_values,
+      &thread_count_count));
+  int32_t thread_counts[IREE_ARRAYSIZE(thread_count_values)];
+  for (iree_host_size_t i = 0; i < thread_count_count; ++i) {
+    if (thread_count_values[i] == 0) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "thread counts must be at least 1");
+    }
+    thread_counts[i] = (int32_t)thread_count_values[i];
+  }
+
+  iree_hal_executable_loader_t* executable_loader = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_executable_library_create_loader(
+      host_allocator, &executable_loader));
+
+  if (strlen(FLAG_module_file) == 0) {
+    iree_byte_span_t executable_data;
+    IREE_RETURN_IF_ERROR(iree_file_read_contents(
+        FLAG_executable_file, host_allocator, &executable_data));
+    return iree_hal_suite_register_executable(
+        executable_loader,
+        iree_make_const_byte_span(executable_data.data,
+                                  executable_data.data_length),
+        "executable", thread_counts, thread_count_count, host_allocator);
+  }
+
+  // Executables are stored as rodata segments of the module. Other rodata
+  // (strings, constants, executables of other formats) fails to load with the
+  // loader and is skipped.
+  iree_byte_span_t module_data;
+  IREE_RETURN_IF_ERROR(
+      iree_file_read_contents(FLAG_module_file, host_allocator, &module_data));
+  int verify_ret = iree_vm_BytecodeModuleDef_verify_as_root(
+      module_data.data, module_data.data_length);
+  if (verify_ret != flatcc_verify_ok) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "module flatbuffer verification failed: %s",
+                            flatcc_verify_error_string(verify_ret));
+  }
+  iree_vm_BytecodeModuleDef_table_t module_def =
+      iree_vm_BytecodeModuleDef_as_root(module_data.data);
+  iree_vm_RodataSegmentDef_vec_t rodata_segments =
+      iree_vm_BytecodeModuleDef_rodata_segments(module_def);
+  for (iree_host_size_t i = 0;
+       i < iree_vm_RodataSegmentDef_vec_len(rodata_segments); ++i) {
+    flatbuffers_uint8_vec_t segment_data = iree_vm_RodataSegmentDef_data(
+        iree_vm_RodataSegmentDef_vec_at(rodata_segments, i));
+    char executable_name[32];
+    snprintf(executable_name, sizeof(executable_name), "rodata%zu", i);
+    iree_status_t status = iree_hal_suite_register_executable(
+        executable_loader,
+        iree_make_const_byte_span(segment_data,
+                                  flatbuffers_uint8_vec_len(segment_data)),
+        executable_name, thread_counts, thread_count_count, host_allocator);
+    iree_status_ignore(status);
+  }
+  return iree_ok_status();
+}
+
+//===----------------------------------------------------------------------===//
+// Import call overhead
+//===----------------------------------------------------------------------===//
+// Measures the cost of calling an import from an executable through the
+// dispatch state thunk versus a direct call through a bound import table as
+// provided by IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_DIRECT_IMPORTS. The import
+// does almost nothing so that the reported time is dominated by the call.
+
+typedef struct iree_hal_executable_library_import_params_t {
+  int64_t counter;
+} iree_hal_executable_library_import_params_t;
+
+IREE_ATTRIBUTE_NOINLINE static int iree_hal_executable_library_import_nop(
+    void* import_params) {
+  ++((iree_hal_executable_library_import_params_t*)import_params)->counter;
+  return 0;
+}
+
+// Matches the pass-through thunk used by loaders that share the host ABI.
+IREE_ATTRIBUTE_NOINLINE static int iree_hal_executable_library_import_thunk(
+    iree_hal_executable_import_v0_t fn_ptr, void* import_params) {
+  return fn_ptr(import_params);
+}
+
+// Number of import calls made per benchmark iteration.
+#define IREE_HAL_IMPORT_CALLS_PER_ITERATION 1024
+
+static iree_status_t iree_hal_executable_library_run_import_thunk(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  iree_hal_executable_import_v0_t imports[1] = {
+      iree_hal_executable_library_import_nop,
+  };
+  iree_hal_executable_dispatch_state_v0_t dispatch_state;
+  memset(&dispatch_state, 0, sizeof(dispatch_state));
+  dispatch_state.import_thunk = iree_hal_executable_library_import_thunk;
+  dispatch_state.imports = imports;
+  // Volatile so that the compiler cannot see through the calls, just as it
+  // cannot when they are made from within a real executable.
+  const iree_hal_executable_dispatch_state_v0_t* volatile state_ptr =
+      &dispatch_state;
+  iree_hal_executable_library_import_params_t params = {0};
+  int64_t call_count = 0;
+  while (iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    const iree_hal_executable_dispatch_state_v0_t* state = state_ptr;
+    for (int i = 0; i < IREE_HAL_IMPORT_CALLS_PER_ITERATION; ++i) {
+      if (state->import_thunk(state->imports[0], &params) != 0) {
+        return iree_make_status(IREE_STATUS_INTERNAL, "import failed");
+      }
+    }
+    call_count += IREE_HAL_IMPORT_CALLS_PER_ITERATION;
+  }
+  iree_benchmark_set_items_processed(benchmark_state, call_count);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_executable_library_run_import_direct(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  iree_hal_executable_import_v0_t import_bindings[1] = {
+      iree_hal_executable_library_import_nop,
+  };
+  iree_hal_executable_import_v0_t* volatile bindings_ptr = import_bindings;
+  iree_hal_executable_library_import_params_t params = {0};
+  int64_t call_count = 0;
+  while (iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    iree_hal_executable_import_v0_t* bindings = bindings_ptr;
+    for (int i = 0; i < IREE_HAL_IMPORT_CALLS_PER_ITERATION; ++i) {
+      if (bindings[0](&params) != 0) {
+        return iree_make_status(IREE_STATUS_INTERNAL, "import failed");
+      }
+    }
+    call_count += IREE_HAL_IMPORT_CALLS_PER_ITERATION;
+  }
+  iree_benchmark_set_items_processed(benchmark_state, call_count);
+  return iree_ok_status();
+}
+
 int main(int argc, char** argv) {
   iree_flags_set_usage(
       "executable_library_benchmark",
@@ -365,6 +1005,16 @@ int main(int argc, char** argv) {
       "  --binding=4xf32=1,2,3,4\n"
       "  --binding=4xf32=100,200,300,400\n"
       "  --binding=4xf32=0,0,0,0);\n"
+      "\n"
+      "With --suite every entry point is benchmarked instead, optionally\n"
+      "across several thread counts, with zero-initialized bindings:\n"
+      "  --executable_format=EX_ELF\n"
+      "  --module_file=module.vmfb\n"
+      "  --suite\n"
+      "  --suite_thread_counts=1,2,4,8\n"
+      "  --suite_params_file=params.txt\n"
+      "where params.txt contains lines such as:\n"
+      "  main_dispatch_0 workgroup_count=16,16,1 bindings=65536,65536\n"
       "\n");
 
   iree_flags_parse_checked(IREE_FLAGS_PARSE_MODE_UNDEFINED_OK, &argc, &argv);
@@ -379,7 +1029,27 @@ int main(int argc, char** argv) {
       .iteration_count = 0,
       .run = iree_hal_executable_library_run,
   };
-  iree_benchmark_register(iree_make_cstring_view("dispatch"), &benchmark_def);
+  if (FLAG_suite) {
+    iree_status_t status = iree_hal_suite_register(iree_allocator_system());
+    if (!iree_status_is_ok(status)) {
+      iree_status_fprint(stderr, status);
+      iree_status_ignore(status);
+      return 1;
+    }
+  } else {
+    iree_benchmark_register(iree_make_cstring_view("dispatch"),
+                            &benchmark_def);
+  }
+
+  // Import call overhead; independent of the executable being benchmarked.
+  iree_benchmark_def_t import_thunk_def = benchmark_def;
+  import_thunk_def.run = iree_hal_executable_library_run_import_thunk;
+  iree_benchmark_register(iree_make_cstring_view("import_call_thunk"),
+                          &import_thunk_def);
+  iree_benchmark_def_t import_direct_def = benchmark_def;
+  import_direct_def.run = iree_hal_executable_library_run_import_direct;
+  iree_benchmark_register(iree_make_cstring_view("import_call_direct"),
+                          &import_direct_def);
 
   iree_benchmark_run_specified();
   return 0;
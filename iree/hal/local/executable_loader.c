@@ -100,3 +100,12 @@ iree_status_t iree_hal_executable_loader_try_load(
   return executable_loader->vtable->try_load(executable_loader, executable_spec,
                                              out_executable);
 }
+
+iree_status_t iree_hal_executable_loader_preload(
+    iree_hal_executable_loader_t* executable_loader,
+    iree_const_byte_span_t executable_data) {
+  IREE_ASSERT_ARGUMENT(executable_loader);
+  if (!executable_loader->vtable->preload) return iree_ok_status();
+  return executable_loader->vtable->preload(executable_loader,
+                                            executable_data);
+}
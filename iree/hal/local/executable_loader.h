@@ -124,6 +124,18 @@ iree_status_t iree_hal_executable_loader_try_load(
     const iree_hal_executable_spec_t* executable_spec,
     iree_hal_executable_t** out_executable);
 
+// Performs the work of loading |executable_data| that does not depend on the
+// executable layouts (such as loading and relocating native code) ahead of a
+// later iree_hal_executable_loader_try_load of the same data. The results are
+// retained by the loader for its lifetime.
+//
+// The format of |executable_data| is not known to the caller: data that is
+// not recognized by the loader is ignored and returns OK. Loaders that do not
+// support preloading ignore all data.
+iree_status_t iree_hal_executable_loader_preload(
+    iree_hal_executable_loader_t* executable_loader,
+    iree_const_byte_span_t executable_data);
+
 //===----------------------------------------------------------------------===//
 // iree_hal_executable_loader_t implementation details
 //===----------------------------------------------------------------------===//
@@ -140,6 +152,11 @@ typedef struct iree_hal_executable_loader_vtable_t {
       iree_hal_executable_loader_t* executable_loader,
       const iree_hal_executable_spec_t* executable_spec,
       iree_hal_executable_t** out_executable);
+
+  // Optional; NULL if the loader does not support preloading.
+  iree_status_t(IREE_API_PTR* preload)(
+      iree_hal_executable_loader_t* executable_loader,
+      iree_const_byte_span_t executable_data);
 } iree_hal_executable_loader_vtable_t;
 
 #ifdef __cplusplus
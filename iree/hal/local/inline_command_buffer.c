@@ -11,6 +11,7 @@
 #include <string.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
 #include "iree/base/internal/math.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/local/executable_library.h"
@@ -31,6 +32,9 @@ typedef struct iree_hal_inline_command_buffer_t {
   iree_hal_command_category_t allowed_categories;
   iree_hal_queue_affinity_t queue_affinity;
 
+  // Used to distribute dispatch workgroups across threads, if available.
+  iree_hal_inline_parallel_for_t parallel_for;
+
   struct {
     // A flattened list of all available descriptor set bindings.
     // As descriptor sets are pushed/bound the bindings will be updated to
@@ -87,7 +91,9 @@ static void iree_hal_inline_command_buffer_reset(
 iree_status_t iree_hal_inline_command_buffer_create(
     iree_hal_command_buffer_mode_t mode,
     iree_hal_command_category_t command_categories,
-    iree_hal_queue_affinity_t queue_affinity, iree_allocator_t host_allocator,
+    iree_hal_queue_affinity_t queue_affinity,
+    iree_hal_inline_parallel_for_t parallel_for,
+    iree_allocator_t host_allocator,
     iree_hal_command_buffer_t** out_command_buffer) {
   IREE_ASSERT_ARGUMENT(out_command_buffer);
   *out_command_buffer = NULL;
@@ -114,6 +120,7 @@ iree_status_t iree_hal_inline_command_buffer_create(
     command_buffer->mode = mode;
     command_buffer->allowed_categories = command_categories;
     command_buffer->queue_affinity = queue_affinity;
+    command_buffer->parallel_for = parallel_for;
     iree_hal_inline_command_buffer_reset(command_buffer);
 
     *out_command_buffer = (iree_hal_command_buffer_t*)command_buffer;
@@ -385,6 +392,39 @@ static iree_status_t iree_hal_inline_command_buffer_bind_descriptor_set(
 // iree_hal_command_buffer_dispatch
 //===----------------------------------------------------------------------===//
 
+// Shared state of a dispatch whose workgroups are distributed across the
+// participants of an iree_hal_inline_parallel_for_t.
+typedef struct iree_hal_inline_workgroup_batch_t {
+  iree_hal_local_executable_t* executable;
+  iree_host_size_t ordinal;
+  const iree_hal_executable_dispatch_state_v0_t* dispatch_state;
+  uint8_t* local_memory_base;
+  iree_host_size_t local_memory_size;
+  iree_host_size_t local_memory_stride;
+} iree_hal_inline_workgroup_batch_t;
+
+// Issues the workgroup with the flattened x-major |item_index|.
+static iree_status_t iree_hal_inline_workgroup_batch_issue(
+    void* user_data, iree_host_size_t participant_index, uint32_t item_index) {
+  const iree_hal_inline_workgroup_batch_t* batch =
+      (const iree_hal_inline_workgroup_batch_t*)user_data;
+  const iree_hal_vec3_t workgroup_count =
+      batch->dispatch_state->workgroup_count;
+  iree_hal_vec3_t workgroup_id;
+  workgroup_id.x = item_index % workgroup_count.x;
+  workgroup_id.y = (item_index / workgroup_count.x) % workgroup_count.y;
+  workgroup_id.z = item_index / (workgroup_count.x * workgroup_count.y);
+  iree_byte_span_t local_memory = iree_make_byte_span(
+      batch->local_memory_base
+          ? batch->local_memory_base +
+                participant_index * batch->local_memory_stride
+          : NULL,
+      batch->local_memory_size);
+  return iree_hal_local_executable_issue_call(batch->executable, batch->ordinal,
+                                              batch->dispatch_state,
+                                              &workgroup_id, local_memory);
+}
+
 static iree_status_t iree_hal_inline_command_buffer_dispatch(
     iree_hal_command_buffer_t* base_command_buffer,
     iree_hal_executable_t* executable, int32_t entry_point,
@@ -449,6 +489,18 @@ static iree_status_t iree_hal_inline_command_buffer_dispatch(
         command_buffer->state.full_binding_lengths[binding_ordinal];
   }
 
+  // Only distribute when there are multiple workgroups to distribute.
+  const iree_hal_inline_parallel_for_t* parallel_for =
+      &command_buffer->parallel_for;
+  uint64_t workgroup_total =
+      (uint64_t)workgroup_x * (uint64_t)workgroup_y * (uint64_t)workgroup_z;
+  iree_host_size_t participant_count = 1;
+  if (parallel_for->run && parallel_for->participant_count > 1 &&
+      workgroup_total > 1 && workgroup_total <= UINT32_MAX) {
+    participant_count = iree_min(parallel_for->participant_count,
+                                 (iree_host_size_t)workgroup_total);
+  }
+
   // TODO(benvanik): plumb through an arena or fixed-size reservation to use.
   // For now when deploying to devices where you want something like the
   // inline command buffer you probably don't want 256KB of transient memory
@@ -456,18 +508,36 @@ static iree_status_t iree_hal_inline_command_buffer_dispatch(
   // option. For now we just malloc here to make things work and strongly
   // encourage the kind of user who wants synchronous inline execution to not
   // also want tons of scratch memory.
-  iree_byte_span_t local_memory = iree_make_byte_span(NULL, local_memory_size);
+  // Each participant gets its own cache line aligned slice.
+  iree_host_size_t local_memory_stride = iree_host_align(
+      local_memory_size, iree_hardware_destructive_interference_size);
+  uint8_t* local_memory_base = NULL;
   if (local_memory_size > 0) {
-    IREE_RETURN_IF_ERROR(iree_allocator_malloc(command_buffer->host_allocator,
-                                               local_memory_size,
-                                               (void**)&local_memory.data));
+    IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+        command_buffer->host_allocator,
+        participant_count * local_memory_stride, (void**)&local_memory_base));
   }
 
-  iree_status_t status = iree_hal_local_executable_issue_dispatch_inline(
-      local_executable, entry_point, dispatch_state, local_memory);
+  iree_status_t status = iree_ok_status();
+  if (participant_count > 1) {
+    iree_hal_inline_workgroup_batch_t batch = {
+        .executable = local_executable,
+        .ordinal = entry_point,
+        .dispatch_state = dispatch_state,
+        .local_memory_base = local_memory_base,
+        .local_memory_size = local_memory_size,
+        .local_memory_stride = local_memory_stride,
+    };
+    status = parallel_for->run(parallel_for->self, (uint32_t)workgroup_total,
+                               iree_hal_inline_workgroup_batch_issue, &batch);
+  } else {
+    status = iree_hal_local_executable_issue_dispatch_inline(
+        local_executable, entry_point, dispatch_state,
+        iree_make_byte_span(local_memory_base, local_memory_size));
+  }
 
-  if (local_memory.data) {
-    iree_allocator_free(command_buffer->host_allocator, local_memory.data);
+  if (local_memory_base) {
+    iree_allocator_free(command_buffer->host_allocator, local_memory_base);
   }
   return status;
 }
@@ -14,19 +14,55 @@
 extern "C" {
 #endif  // __cplusplus
 
+// Executes item |item_index| of a parallel loop. |participant_index| is in
+// [0, participant_count) and no two items with the same participant index
+// execute concurrently; it can be used to select per-thread scratch storage.
+typedef iree_status_t(IREE_API_PTR* iree_hal_inline_parallel_item_fn_t)(
+    void* user_data, iree_host_size_t participant_index, uint32_t item_index);
+
+// Optional provider of fork-join parallelism used by inline command buffers to
+// spread dispatch workgroups across a small set of threads. The thread calling
+// |run| participates in the loop and |run| only returns once all items have
+// completed. After the first item failure no new items are started and the
+// failure is returned.
+typedef struct iree_hal_inline_parallel_for_t {
+  void* self;
+  // Maximum number of items that may execute concurrently including the
+  // calling thread.
+  iree_host_size_t participant_count;
+  void(IREE_API_PTR* retain)(void* self);
+  void(IREE_API_PTR* release)(void* self);
+  iree_status_t(IREE_API_PTR* run)(void* self, uint32_t item_count,
+                                   iree_hal_inline_parallel_item_fn_t item_fn,
+                                   void* user_data);
+} iree_hal_inline_parallel_for_t;
+
+// Returns a parallel-for provider that executes all items on the caller.
+static inline iree_hal_inline_parallel_for_t iree_hal_inline_parallel_for_null(
+    void) {
+  iree_hal_inline_parallel_for_t v = {NULL, 1, NULL, NULL, NULL};
+  return v;
+}
+
 // Creates an inline synchronous one-shot single-threaded command "buffer".
 // This is designed for ultra-low latency situations where we know the command
 // buffer is going to be submitted with no wait semaphores indicating that it
 // can begin execution immediately. No inter-command-buffer scheduling will be
 // performed and all barriers and events are ignored.
 //
-// Executes all work on the calling thread synchronously (today).
+// Executes all work synchronously on the calling thread. When |parallel_for|
+// has a |run| function the workgroups of each dispatch are distributed across
+// its participants with the calling thread blocking until they complete.
+// |parallel_for| is not retained and must remain valid for the lifetime of the
+// command buffer.
 //
 // Must have IREE_HAL_COMMAND_BUFFER_MODE_ALLOW_INLINE_EXECUTION set.
 iree_status_t iree_hal_inline_command_buffer_create(
     iree_hal_command_buffer_mode_t mode,
     iree_hal_command_category_t command_categories,
-    iree_hal_queue_affinity_t queue_affinity, iree_allocator_t host_allocator,
+    iree_hal_queue_affinity_t queue_affinity,
+    iree_hal_inline_parallel_for_t parallel_for,
+    iree_allocator_t host_allocator,
     iree_hal_command_buffer_t** out_command_buffer);
 
 #ifdef __cplusplus
@@ -0,0 +1,270 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/inline_thread_pool.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/internal/threading.h"
+#include "iree/base/tracing.h"
+
+typedef struct iree_hal_inline_thread_pool_worker_t {
+  iree_hal_inline_thread_pool_t* pool;
+  // Participant index of the worker; the caller of a loop is always 0.
+  iree_host_size_t participant_index;
+  // Generation of the last loop the worker participated in.
+  int32_t generation;
+  iree_thread_t* thread;
+} iree_hal_inline_thread_pool_worker_t;
+
+struct iree_hal_inline_thread_pool_t {
+  iree_atomic_ref_count_t ref_count;
+  iree_allocator_t host_allocator;
+
+  // Serializes loops; only one may be executing at a time.
+  iree_slim_mutex_t run_mutex;
+
+  // Posted when a new loop begins or the workers are asked to exit.
+  iree_notification_t begin_notification;
+  // Posted when the last worker finishes its part of a loop.
+  iree_notification_t end_notification;
+
+  // Incremented each time a loop begins; workers compare against the last
+  // generation they participated in to detect new work.
+  iree_atomic_int32_t generation;
+  // Set to 1 when the workers should exit.
+  iree_atomic_int32_t exit_requested;
+
+  // The current loop. Written by the caller of run only while no workers are
+  // participating and published by the |generation| increment.
+  iree_hal_inline_parallel_item_fn_t item_fn;
+  void* user_data;
+  uint32_t item_count;
+  // Next item index to be executed by any participant.
+  iree_atomic_int32_t next_item;
+  // Number of workers that have not yet finished the current loop. The loop
+  // only completes once every worker has checked in, which guarantees that no
+  // worker can miss a generation.
+  iree_atomic_int32_t pending_worker_count;
+  // The first failure of the current loop as an iree_status_t, if any.
+  iree_atomic_intptr_t failure_status;
+
+  iree_host_size_t worker_count;
+  iree_hal_inline_thread_pool_worker_t workers[];
+};
+
+// Executes items of the current loop until none remain or a failure occurs.
+static void iree_hal_inline_thread_pool_drain(
+    iree_hal_inline_thread_pool_t* pool, iree_host_size_t participant_index) {
+  while (!iree_atomic_load_intptr(&pool->failure_status,
+                                  iree_memory_order_relaxed)) {
+    uint32_t item_index = (uint32_t)iree_atomic_fetch_add_int32(
+        &pool->next_item, 1, iree_memory_order_relaxed);
+    if (item_index >= pool->item_count) break;
+    iree_status_t status =
+        pool->item_fn(pool->user_data, participant_index, item_index);
+    if (IREE_UNLIKELY(!iree_status_is_ok(status))) {
+      intptr_t expected = 0;
+      if (!iree_atomic_compare_exchange_strong_intptr(
+              &pool->failure_status, &expected, (intptr_t)status,
+              iree_memory_order_acq_rel, iree_memory_order_relaxed)) {
+        iree_status_ignore(status);  // another failure was recorded first
+      }
+      break;
+    }
+  }
+}
+
+static bool iree_hal_inline_thread_pool_worker_should_wake(
+    iree_hal_inline_thread_pool_worker_t* worker) {
+  iree_hal_inline_thread_pool_t* pool = worker->pool;
+  return iree_atomic_load_int32(&pool->exit_requested,
+                                iree_memory_order_acquire) ||
+         iree_atomic_load_int32(&pool->generation,
+                                iree_memory_order_acquire) !=
+             worker->generation;
+}
+
+static int iree_hal_inline_thread_pool_worker_main(
+    iree_hal_inline_thread_pool_worker_t* worker) {
+  iree_hal_inline_thread_pool_t* pool = worker->pool;
+  while (true) {
+    iree_notification_await(
+        &pool->begin_notification,
+        (iree_condition_fn_t)iree_hal_inline_thread_pool_worker_should_wake,
+        worker);
+    if (iree_atomic_load_int32(&pool->exit_requested,
+                               iree_memory_order_acquire)) {
+      break;
+    }
+    worker->generation =
+        iree_atomic_load_int32(&pool->generation, iree_memory_order_acquire);
+    iree_hal_inline_thread_pool_drain(pool, worker->participant_index);
+    if (iree_atomic_fetch_sub_int32(&pool->pending_worker_count, 1,
+                                    iree_memory_order_acq_rel) == 1) {
+      iree_notification_post(&pool->end_notification, IREE_ALL_WAITERS);
+    }
+  }
+  return 0;
+}
+
+static void iree_hal_inline_thread_pool_destroy(
+    iree_hal_inline_thread_pool_t* pool) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Wake all workers and join them; release blocks until each thread exits.
+  iree_atomic_store_int32(&pool->exit_requested, 1, iree_memory_order_release);
+  iree_notification_post(&pool->begin_notification, IREE_ALL_WAITERS);
+  for (iree_host_size_t i = 0; i < pool->worker_count; ++i) {
+    iree_thread_release(pool->workers[i].thread);
+  }
+
+  iree_notification_deinitialize(&pool->end_notification);
+  iree_notification_deinitialize(&pool->begin_notification);
+  iree_slim_mutex_deinitialize(&pool->run_mutex);
+  iree_allocator_free(pool->host_allocator, pool);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+iree_status_t iree_hal_inline_thread_pool_create(
+    iree_host_size_t worker_count, iree_allocator_t host_allocator,
+    iree_hal_inline_thread_pool_t** out_pool) {
+  IREE_ASSERT_ARGUMENT(out_pool);
+  *out_pool = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_inline_thread_pool_t* pool = NULL;
+  iree_host_size_t total_size =
+      sizeof(*pool) + worker_count * sizeof(pool->workers[0]);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, total_size, (void**)&pool));
+  memset(pool, 0, total_size);
+  iree_atomic_ref_count_init(&pool->ref_count);
+  pool->host_allocator = host_allocator;
+  iree_slim_mutex_initialize(&pool->run_mutex);
+  iree_notification_initialize(&pool->begin_notification);
+  iree_notification_initialize(&pool->end_notification);
+
+  iree_thread_create_params_t thread_params;
+  memset(&thread_params, 0, sizeof(thread_params));
+  thread_params.name = iree_make_cstring_view("iree-inline-worker");
+  thread_params.priority_class = IREE_THREAD_PRIORITY_CLASS_NORMAL;
+
+  // NOTE: on failure destroy joins the workers created so far.
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < worker_count; ++i) {
+    iree_hal_inline_thread_pool_worker_t* worker = &pool->workers[i];
+    worker->pool = pool;
+    worker->participant_index = 1 + i;
+    status = iree_thread_create(
+        (iree_thread_entry_t)iree_hal_inline_thread_pool_worker_main, worker,
+        thread_params, host_allocator, &worker->thread);
+    if (!iree_status_is_ok(status)) break;
+    pool->worker_count = i + 1;
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_pool = pool;
+  } else {
+    iree_hal_inline_thread_pool_destroy(pool);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+void iree_hal_inline_thread_pool_retain(iree_hal_inline_thread_pool_t* pool) {
+  if (pool) {
+    iree_atomic_ref_count_inc(&pool->ref_count);
+  }
+}
+
+void iree_hal_inline_thread_pool_release(iree_hal_inline_thread_pool_t* pool) {
+  if (pool && iree_atomic_ref_count_dec(&pool->ref_count) == 1) {
+    iree_hal_inline_thread_pool_destroy(pool);
+  }
+}
+
+static bool iree_hal_inline_thread_pool_is_loop_done(
+    iree_hal_inline_thread_pool_t* pool) {
+  return iree_atomic_load_int32(&pool->pending_worker_count,
+                                iree_memory_order_acquire) == 0;
+}
+
+iree_status_t iree_hal_inline_thread_pool_run(
+    iree_hal_inline_thread_pool_t* pool, uint32_t item_count,
+    iree_hal_inline_parallel_item_fn_t item_fn, void* user_data) {
+  IREE_ASSERT_ARGUMENT(pool);
+  IREE_ASSERT_ARGUMENT(item_fn);
+
+  // Waking the workers for a single item would only add latency.
+  if (item_count <= 1 || pool->worker_count == 0) {
+    for (uint32_t i = 0; i < item_count; ++i) {
+      IREE_RETURN_IF_ERROR(item_fn(user_data, 0, i));
+    }
+    return iree_ok_status();
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)item_count);
+  iree_slim_mutex_lock(&pool->run_mutex);
+
+  // Fork: publish the loop and wake the workers.
+  pool->item_fn = item_fn;
+  pool->user_data = user_data;
+  pool->item_count = item_count;
+  iree_atomic_store_int32(&pool->next_item, 0, iree_memory_order_relaxed);
+  iree_atomic_store_intptr(&pool->failure_status, 0,
+                           iree_memory_order_relaxed);
+  iree_atomic_store_int32(&pool->pending_worker_count,
+                          (int32_t)pool->worker_count,
+                          iree_memory_order_relaxed);
+  iree_atomic_fetch_add_int32(&pool->generation, 1, iree_memory_order_release);
+  iree_notification_post(&pool->begin_notification, IREE_ALL_WAITERS);
+
+  // The caller works on the loop too instead of idling.
+  iree_hal_inline_thread_pool_drain(pool, /*participant_index=*/0);
+
+  // Join: wait for every worker to check in.
+  iree_notification_await(
+      &pool->end_notification,
+      (iree_condition_fn_t)iree_hal_inline_thread_pool_is_loop_done, pool);
+  iree_status_t status = (iree_status_t)iree_atomic_exchange_intptr(
+      &pool->failure_status, 0, iree_memory_order_acquire);
+
+  iree_slim_mutex_unlock(&pool->run_mutex);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_inline_thread_pool_retain_thunk(void* self) {
+  iree_hal_inline_thread_pool_retain((iree_hal_inline_thread_pool_t*)self);
+}
+
+static void iree_hal_inline_thread_pool_release_thunk(void* self) {
+  iree_hal_inline_thread_pool_release((iree_hal_inline_thread_pool_t*)self);
+}
+
+static iree_status_t iree_hal_inline_thread_pool_run_thunk(
+    void* self, uint32_t item_count, iree_hal_inline_parallel_item_fn_t item_fn,
+    void* user_data) {
+  return iree_hal_inline_thread_pool_run((iree_hal_inline_thread_pool_t*)self,
+                                         item_count, item_fn, user_data);
+}
+
+iree_hal_inline_parallel_for_t iree_hal_inline_thread_pool_parallel_for(
+    iree_hal_inline_thread_pool_t* pool) {
+  iree_hal_inline_parallel_for_t parallel_for;
+  parallel_for.self = pool;
+  parallel_for.participant_count = 1 + pool->worker_count;
+  parallel_for.retain = iree_hal_inline_thread_pool_retain_thunk;
+  parallel_for.release = iree_hal_inline_thread_pool_release_thunk;
+  parallel_for.run = iree_hal_inline_thread_pool_run_thunk;
+  return parallel_for;
+}
@@ -0,0 +1,57 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_LOCAL_INLINE_THREAD_POOL_H_
+#define IREE_HAL_LOCAL_INLINE_THREAD_POOL_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/local/inline_command_buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// A tiny fixed-size thread pool executing fork-join parallel loops.
+//
+// Intended for use with inline (synchronous) devices where the latency of
+// waking a full task executor would dominate small dispatches but where
+// spreading the workgroups across a few cores still pays off. The thread
+// issuing a loop participates in it and all pool threads join a barrier at the
+// end of each loop; there is no queueing, stealing, or scheduling beyond a
+// shared atomic item counter.
+//
+// Only one loop executes at a time; concurrent callers are serialized.
+typedef struct iree_hal_inline_thread_pool_t iree_hal_inline_thread_pool_t;
+
+// Creates a pool with |worker_count| threads in addition to the caller.
+// A |worker_count| of 0 is valid and results in all loops running inline.
+iree_status_t iree_hal_inline_thread_pool_create(
+    iree_host_size_t worker_count, iree_allocator_t host_allocator,
+    iree_hal_inline_thread_pool_t** out_pool);
+
+// Retains the given |pool| for the caller.
+void iree_hal_inline_thread_pool_retain(iree_hal_inline_thread_pool_t* pool);
+
+// Releases the given |pool| from the caller. The pool threads are joined when
+// the last reference is released.
+void iree_hal_inline_thread_pool_release(iree_hal_inline_thread_pool_t* pool);
+
+// Executes |item_fn| for each item in [0, |item_count|) across the pool and
+// the calling thread and returns once all items have completed.
+iree_status_t iree_hal_inline_thread_pool_run(
+    iree_hal_inline_thread_pool_t* pool, uint32_t item_count,
+    iree_hal_inline_parallel_item_fn_t item_fn, void* user_data);
+
+// Returns a parallel-for provider backed by |pool| that can be passed to inline
+// command buffers and devices. The returned provider is not retained.
+iree_hal_inline_parallel_for_t iree_hal_inline_thread_pool_parallel_for(
+    iree_hal_inline_thread_pool_t* pool);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_LOCAL_INLINE_THREAD_POOL_H_
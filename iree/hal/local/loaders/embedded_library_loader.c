@@ -9,14 +9,179 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
+#include "iree/base/internal/call_once.h"
+#include "iree/base/internal/synchronization.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/api.h"
 #include "iree/hal/local/elf/elf_module.h"
+#include "iree/hal/local/executable_hash.h"
 #include "iree/hal/local/executable_library.h"
 #include "iree/hal/local/local_executable.h"
 #include "iree/hal/local/local_executable_layout.h"
 
+//===----------------------------------------------------------------------===//
+// iree_hal_elf_image_t
+//===----------------------------------------------------------------------===//
+
+// A loaded and relocated ELF module shared by all executables in the process
+// that were loaded from identical contents (such as the same executable
+// prepared for multiple devices). Images are loaded without imports - those
+// are resolved per executable - and thus depend only on their contents.
+//
+// Live images are tracked in a process-wide registry and unloaded when the
+// last executable referencing them is destroyed. Images are allocated from
+// the system allocator as they may outlive the executable that loaded them.
+// Shareable images keep a copy of the ELF contents that is compared on lookup
+// as the hash alone is not strong enough to identify the code to run.
+typedef struct iree_hal_elf_image_t {
+  // Next live image in the registry.
+  struct iree_hal_elf_image_t* next;
+  // Number of executables referencing the image. Guarded by the registry.
+  iree_host_size_t use_count;
+  // True once the direct import binding table of the library, if any, has
+  // been written. Guarded by the registry.
+  bool imports_bound;
+  // Hash of the ELF contents.
+  uint64_t hash[2];
+  // Copy of the ELF contents stored immediately after the image for shareable
+  // images; empty for private images.
+  iree_const_byte_span_t data;
+  // Loaded ELF module.
+  iree_elf_module_t module;
+} iree_hal_elf_image_t;
+
+typedef struct iree_hal_elf_image_registry_t {
+  iree_slim_mutex_t mutex;
+  iree_hal_elf_image_t* head;
+} iree_hal_elf_image_registry_t;
+
+static iree_hal_elf_image_registry_t iree_hal_elf_image_registry_;
+static iree_once_flag iree_hal_elf_image_registry_flag_ = IREE_ONCE_FLAG_INIT;
+static void iree_hal_elf_image_registry_initialize(void) {
+  memset(&iree_hal_elf_image_registry_, 0,
+         sizeof(iree_hal_elf_image_registry_));
+  iree_slim_mutex_initialize(&iree_hal_elf_image_registry_.mutex);
+}
+
+static iree_hal_elf_image_registry_t* iree_hal_elf_image_registry(void) {
+  iree_call_once(&iree_hal_elf_image_registry_flag_,
+                 iree_hal_elf_image_registry_initialize);
+  return &iree_hal_elf_image_registry_;
+}
+
+// Returns a new use of the live image matching the key, if any.
+// Must be called with the registry lock held.
+static iree_hal_elf_image_t* iree_hal_elf_image_registry_find(
+    iree_hal_elf_image_registry_t* registry, const uint64_t hash[2],
+    iree_const_byte_span_t elf_data) {
+  for (iree_hal_elf_image_t* image = registry->head; image;
+       image = image->next) {
+    if (image->hash[0] == hash[0] && image->hash[1] == hash[1] &&
+        image->data.data_length == elf_data.data_length &&
+        memcmp(image->data.data, elf_data.data, elf_data.data_length) == 0) {
+      ++image->use_count;
+      return image;
+    }
+  }
+  return NULL;
+}
+
+static void iree_hal_elf_image_free(iree_hal_elf_image_t* image) {
+  iree_elf_module_deinitialize(&image->module);
+  iree_allocator_free(iree_allocator_system(), image);
+}
+
+// Acquires a use of the image loaded from |elf_data|, loading it if no live
+// image with identical contents exists. |is_shareable| = false always loads a
+// private image that is never returned to other callers.
+static iree_status_t iree_hal_elf_image_acquire(
+    iree_const_byte_span_t elf_data, bool is_shareable,
+    iree_hal_elf_image_t** out_image) {
+  *out_image = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_elf_image_registry_t* registry = iree_hal_elf_image_registry();
+  uint64_t hash[2] = {0, 0};
+  if (is_shareable) {
+    iree_hal_local_executable_hash_initialize(hash);
+    iree_hal_local_executable_hash_bytes(elf_data.data, elf_data.data_length,
+                                         hash);
+    iree_slim_mutex_lock(&registry->mutex);
+    *out_image = iree_hal_elf_image_registry_find(registry, hash, elf_data);
+    iree_slim_mutex_unlock(&registry->mutex);
+    if (*out_image) {
+      IREE_TRACE_ZONE_END(z0);
+      return iree_ok_status();
+    }
+  }
+
+  // Load outside of the lock so that loading different executables is not
+  // serialized. Racing loads of the same contents are resolved below.
+  iree_hal_elf_image_t* image = NULL;
+  iree_host_size_t data_length = is_shareable ? elf_data.data_length : 0;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(iree_allocator_system(),
+                                sizeof(*image) + data_length, (void**)&image));
+  memset(image, 0, sizeof(*image));
+  image->use_count = 1;
+  image->hash[0] = hash[0];
+  image->hash[1] = hash[1];
+  uint8_t* data_copy = (uint8_t*)image + sizeof(*image);
+  memcpy(data_copy, elf_data.data, data_length);
+  image->data = iree_make_const_byte_span(data_copy, data_length);
+  iree_status_t status = iree_elf_module_initialize_from_memory(
+      elf_data, /*import_table=*/NULL, iree_allocator_system(),
+      &image->module);
+  if (!iree_status_is_ok(status)) {
+    iree_allocator_free(iree_allocator_system(), image);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+  if (!is_shareable) {
+    *out_image = image;
+    IREE_TRACE_ZONE_END(z0);
+    return iree_ok_status();
+  }
+
+  iree_slim_mutex_lock(&registry->mutex);
+  iree_hal_elf_image_t* existing_image =
+      iree_hal_elf_image_registry_find(registry, hash, elf_data);
+  if (!existing_image) {
+    image->next = registry->head;
+    registry->head = image;
+  }
+  iree_slim_mutex_unlock(&registry->mutex);
+  if (existing_image) {
+    // Lost the race with another load of the same contents.
+    iree_hal_elf_image_free(image);
+    image = existing_image;
+  }
+
+  *out_image = image;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+// Releases a use of |image| and unloads it if it was the last.
+static void iree_hal_elf_image_release(iree_hal_elf_image_t* image) {
+  if (!image) return;
+  iree_hal_elf_image_registry_t* registry = iree_hal_elf_image_registry();
+  iree_slim_mutex_lock(&registry->mutex);
+  bool is_unused = --image->use_count == 0;
+  if (is_unused) {
+    for (iree_hal_elf_image_t** it = &registry->head; *it; it = &(*it)->next) {
+      if (*it == image) {
+        *it = image->next;
+        break;
+      }
+    }
+  }
+  iree_slim_mutex_unlock(&registry->mutex);
+  if (is_unused) iree_hal_elf_image_free(image);
+}
+
 //===----------------------------------------------------------------------===//
 // iree_hal_elf_executable_t
 //===----------------------------------------------------------------------===//
@@ -24,8 +189,8 @@
 typedef struct iree_hal_elf_executable_t {
   iree_hal_local_executable_t base;
 
-  // Loaded ELF module.
-  iree_elf_module_t module;
+  // Loaded ELF module, possibly shared with other executables.
+  iree_hal_elf_image_t* image;
 
   // Name used for the file field in tracy and debuggers.
   iree_string_view_t identifier;
@@ -46,7 +211,7 @@ static iree_status_t iree_hal_elf_executable_query_library(
   // Get the exported symbol used to get the library metadata.
   iree_hal_executable_library_query_fn_t query_fn = NULL;
   IREE_RETURN_IF_ERROR(iree_elf_module_lookup_export(
-      &executable->module, IREE_HAL_EXECUTABLE_LIBRARY_EXPORT_NAME,
+      &executable->image->module, IREE_HAL_EXECUTABLE_LIBRARY_EXPORT_NAME,
       (void**)&query_fn));
 
   // Query for a compatible version of the library.
@@ -82,6 +247,10 @@ static iree_status_t iree_hal_elf_executable_query_library(
   executable->identifier = iree_make_cstring_view(header->name);
 
   executable->base.dispatch_attrs = executable->library.v0->exports.attrs;
+  executable->base.entry_point_names = executable->library.v0->exports.names;
+  executable->base.entry_point_count = executable->library.v0->exports.count;
+  executable->base.fpu_state_flags =
+      iree_hal_local_executable_fpu_state_flags(header->features);
 
   return iree_ok_status();
 }
@@ -94,6 +263,13 @@ static iree_status_t iree_hal_elf_executable_resolve_imports(
   const iree_hal_executable_import_table_v0_t* import_table =
       &executable->library.v0->imports;
   if (!import_table->count) return iree_ok_status();
+  if (!IREE_ELF_HOST_ABI_IS_NATIVE &&
+      iree_all_bits_set((*executable->library.header)->features,
+                        IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_DIRECT_IMPORTS)) {
+    return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                            "executable requests direct import binding but "
+                            "host calls require ABI marshaling");
+  }
   IREE_TRACE_ZONE_BEGIN(z0);
 
   // All calls from the loaded ELF route through our thunk function so that we
@@ -124,6 +300,34 @@ static iree_status_t iree_hal_elf_executable_resolve_imports(
   return iree_ok_status();
 }
 
+// Writes the resolved imports of |executable| into the direct binding table
+// of the library, if it has one. The table lives in the image and is shared
+// by all executables using the image: returns false if another executable
+// already bound different functions.
+static bool iree_hal_elf_executable_try_bind_imports(
+    iree_hal_elf_executable_t* executable) {
+  const iree_hal_executable_library_v0_t* library = executable->library.v0;
+  if (!library->imports.count ||
+      !iree_all_bits_set(library->header->features,
+                         IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_DIRECT_IMPORTS)) {
+    return true;
+  }
+  iree_hal_elf_image_registry_t* registry = iree_hal_elf_image_registry();
+  iree_slim_mutex_lock(&registry->mutex);
+  bool is_compatible = true;
+  for (uint32_t i = 0; i < library->imports.count; ++i) {
+    if (!executable->image->imports_bound) {
+      library->import_bindings[i] = executable->base.imports[i];
+    } else if (library->import_bindings[i] != executable->base.imports[i]) {
+      is_compatible = false;
+      break;
+    }
+  }
+  executable->image->imports_bound = true;
+  iree_slim_mutex_unlock(&registry->mutex);
+  return is_compatible;
+}
+
 static iree_status_t iree_hal_elf_executable_create(
     iree_hal_executable_caching_mode_t caching_mode,
     iree_const_byte_span_t elf_data, iree_host_size_t executable_layout_count,
@@ -152,9 +356,15 @@ static iree_status_t iree_hal_elf_executable_create(
         &executable->base);
   }
   if (iree_status_is_ok(status)) {
-    // Attempt to load the ELF module.
-    status = iree_elf_module_initialize_from_memory(
-        elf_data, /*import_table=*/NULL, host_allocator, &executable->module);
+    // Attempt to load the ELF module or share an already loaded one.
+    // Initializers in the image run only when it is first loaded so sharing is
+    // limited to executables that may be persistently cached.
+    status = iree_hal_elf_image_acquire(
+        elf_data,
+        iree_all_bits_set(
+            caching_mode,
+            IREE_HAL_EXECUTABLE_CACHING_MODE_ALLOW_PERSISTENT_CACHING),
+        &executable->image);
   }
   if (iree_status_is_ok(status)) {
     // Query metadata and get the entry point function pointers.
@@ -165,6 +375,21 @@ static iree_status_t iree_hal_elf_executable_create(
     status =
         iree_hal_elf_executable_resolve_imports(executable, import_provider);
   }
+  if (iree_status_is_ok(status) &&
+      !iree_hal_elf_executable_try_bind_imports(executable)) {
+    // The shared image was bound to imports resolved by another provider;
+    // fall back to a private image that this executable can bind itself.
+    iree_hal_elf_image_release(executable->image);
+    executable->image = NULL;
+    status = iree_hal_elf_image_acquire(elf_data, /*is_shareable=*/false,
+                                        &executable->image);
+    if (iree_status_is_ok(status)) {
+      status = iree_hal_elf_executable_query_library(executable);
+    }
+    if (iree_status_is_ok(status)) {
+      iree_hal_elf_executable_try_bind_imports(executable);
+    }
+  }
   if (iree_status_is_ok(status) &&
       !iree_all_bits_set(
           caching_mode,
@@ -196,7 +421,7 @@ static void iree_hal_elf_executable_destroy(
   iree_allocator_t host_allocator = executable->base.host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  iree_elf_module_deinitialize(&executable->module);
+  iree_hal_elf_image_release(executable->image);
 
   if (executable->base.imports != NULL) {
     iree_allocator_free(host_allocator, (void*)executable->base.imports);
@@ -269,6 +494,14 @@ const iree_hal_local_executable_vtable_t iree_hal_elf_executable_vtable = {
 typedef struct iree_hal_embedded_library_loader_t {
   iree_hal_executable_loader_t base;
   iree_allocator_t host_allocator;
+
+  // Images loaded by iree_hal_executable_loader_preload. Each holds a use so
+  // that the image remains in the registry until the loader is destroyed and
+  // executables created from the same contents share it.
+  iree_slim_mutex_t mutex;
+  iree_host_size_t preloaded_image_count;
+  iree_host_size_t preloaded_image_capacity;
+  iree_hal_elf_image_t** preloaded_images;
 } iree_hal_embedded_library_loader_t;
 
 extern const iree_hal_executable_loader_vtable_t
@@ -290,6 +523,10 @@ iree_status_t iree_hal_embedded_library_loader_create(
         &iree_hal_embedded_library_loader_vtable, import_provider,
         &executable_loader->base);
     executable_loader->host_allocator = host_allocator;
+    iree_slim_mutex_initialize(&executable_loader->mutex);
+    executable_loader->preloaded_image_count = 0;
+    executable_loader->preloaded_image_capacity = 0;
+    executable_loader->preloaded_images = NULL;
     *out_executable_loader = (iree_hal_executable_loader_t*)executable_loader;
   }
 
@@ -304,6 +541,12 @@ static void iree_hal_embedded_library_loader_destroy(
   iree_allocator_t host_allocator = executable_loader->host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  for (iree_host_size_t i = 0; i < executable_loader->preloaded_image_count;
+       ++i) {
+    iree_hal_elf_image_release(executable_loader->preloaded_images[i]);
+  }
+  iree_allocator_free(host_allocator, executable_loader->preloaded_images);
+  iree_slim_mutex_deinitialize(&executable_loader->mutex);
   iree_allocator_free(host_allocator, executable_loader);
 
   IREE_TRACE_ZONE_END(z0);
@@ -337,9 +580,78 @@ static iree_status_t iree_hal_embedded_library_loader_try_load(
   return status;
 }
 
+// Retains |image| in the preloaded set of the loader. Takes ownership of the
+// caller's use of the image.
+static iree_status_t iree_hal_embedded_library_loader_retain_image(
+    iree_hal_embedded_library_loader_t* executable_loader,
+    iree_hal_elf_image_t* image) {
+  iree_status_t status = iree_ok_status();
+  bool is_retained = false;
+  iree_slim_mutex_lock(&executable_loader->mutex);
+  for (iree_host_size_t i = 0; i < executable_loader->preloaded_image_count;
+       ++i) {
+    if (executable_loader->preloaded_images[i] == image) {
+      is_retained = true;
+      break;
+    }
+  }
+  if (!is_retained && executable_loader->preloaded_image_count ==
+                          executable_loader->preloaded_image_capacity) {
+    iree_host_size_t new_capacity =
+        iree_max(8, executable_loader->preloaded_image_capacity * 2);
+    status = iree_allocator_realloc(
+        executable_loader->host_allocator,
+        new_capacity * sizeof(executable_loader->preloaded_images[0]),
+        (void**)&executable_loader->preloaded_images);
+    if (iree_status_is_ok(status)) {
+      executable_loader->preloaded_image_capacity = new_capacity;
+    }
+  }
+  if (!is_retained && iree_status_is_ok(status)) {
+    executable_loader
+        ->preloaded_images[executable_loader->preloaded_image_count++] = image;
+    image = NULL;
+  }
+  iree_slim_mutex_unlock(&executable_loader->mutex);
+  // Already retained (or failed to grow the set); drop the extra use.
+  iree_hal_elf_image_release(image);
+  return status;
+}
+
+static iree_status_t iree_hal_embedded_library_loader_preload(
+    iree_hal_executable_loader_t* base_executable_loader,
+    iree_const_byte_span_t executable_data) {
+  iree_hal_embedded_library_loader_t* executable_loader =
+      (iree_hal_embedded_library_loader_t*)base_executable_loader;
+
+  // Ignore anything that is not an ELF file.
+  static const uint8_t elf_magic[4] = {0x7F, 'E', 'L', 'F'};
+  if (executable_data.data_length < sizeof(elf_magic) ||
+      memcmp(executable_data.data, elf_magic, sizeof(elf_magic)) != 0) {
+    return iree_ok_status();
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, executable_data.data_length);
+
+  // Load (or find) the shared image that executables prepared with the
+  // default caching mode from the same contents will use.
+  iree_hal_elf_image_t* image = NULL;
+  iree_status_t status = iree_hal_elf_image_acquire(
+      executable_data, /*is_shareable=*/true, &image);
+  if (iree_status_is_ok(status)) {
+    status =
+        iree_hal_embedded_library_loader_retain_image(executable_loader, image);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 const iree_hal_executable_loader_vtable_t
     iree_hal_embedded_library_loader_vtable = {
         .destroy = iree_hal_embedded_library_loader_destroy,
         .query_support = iree_hal_embedded_library_loader_query_support,
         .try_load = iree_hal_embedded_library_loader_try_load,
+        .preload = iree_hal_embedded_library_loader_preload,
 };
@@ -63,6 +63,10 @@ static iree_status_t iree_hal_static_executable_create(
     executable->library.header = library_header;
     executable->identifier = iree_make_cstring_view((*library_header)->name);
     executable->base.dispatch_attrs = executable->library.v0->exports.attrs;
+    executable->base.entry_point_names = executable->library.v0->exports.names;
+    executable->base.entry_point_count = executable->library.v0->exports.count;
+    executable->base.fpu_state_flags =
+        iree_hal_local_executable_fpu_state_flags((*library_header)->features);
   }
 
   if (iree_status_is_ok(status)) {
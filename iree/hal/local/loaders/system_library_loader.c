@@ -9,6 +9,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "iree/base/internal/dynamic_library.h"
 #include "iree/base/tracing.h"
@@ -166,6 +167,10 @@ static iree_status_t iree_hal_system_executable_query_library(
   executable->identifier = iree_make_cstring_view(header->name);
 
   executable->base.dispatch_attrs = executable->library.v0->exports.attrs;
+  executable->base.entry_point_names = executable->library.v0->exports.names;
+  executable->base.entry_point_count = executable->library.v0->exports.count;
+  executable->base.fpu_state_flags =
+      iree_hal_local_executable_fpu_state_flags(header->features);
 
   return iree_ok_status();
 }
@@ -207,6 +212,15 @@ static iree_status_t iree_hal_system_executable_resolve_imports(
             (void**)&executable->base.imports[i]));
   }
 
+  // Host and library share the platform ABI so imports can always be bound for
+  // direct calls when the library requests it.
+  const iree_hal_executable_library_v0_t* library = executable->library.v0;
+  if (iree_all_bits_set(library->header->features,
+                        IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_DIRECT_IMPORTS)) {
+    memcpy(library->import_bindings, executable->base.imports,
+           import_table->count * sizeof(*library->import_bindings));
+  }
+
   IREE_TRACE_ZONE_END(z0);
   return iree_ok_status();
 }
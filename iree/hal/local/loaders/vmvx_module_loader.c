@@ -11,6 +11,7 @@
 #include <stdint.h>
 #include <string.h>
 
+#include "iree/base/internal/atomic_slist.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/api.h"
 #include "iree/hal/local/executable_library.h"
@@ -25,12 +26,41 @@
 
 #define IREE_VMVX_ENTRY_SIGNATURE "0rrriiiiiiiii_v"
 
+// Reusable state for calling into entry points of an executable.
+// Constructing the VM stack, the binding list, and the buffers wrapping the
+// dispatch memory is relatively expensive compared to the work done by small
+// workgroups and only the spans they reference change between workgroups.
+// States are pooled on the executable and acquired for the duration of a call
+// such that concurrently executing workers each end up reusing their own.
+//
+// Allocated as [state | stack storage | list storage | binding buffers].
+typedef struct iree_hal_vmvx_invocation_t {
+  // Intrusive pointer used by the executable pool.
+  iree_atomic_slist_intrusive_ptr_t* slist_next;
+  iree_vm_stack_t* stack;
+  iree_vm_buffer_t local_memory_buffer;
+  iree_vm_buffer_t constants_buffer;
+  // List of |binding_buffers| sized to the last dispatch binding count.
+  iree_vm_list_t* binding_list;
+  iree_host_size_t binding_capacity;
+  iree_vm_buffer_t* binding_buffers;
+} iree_hal_vmvx_invocation_t;
+
+// An atomic approximately LIFO singly-linked list.
+IREE_TYPED_ATOMIC_SLIST_WRAPPER(iree_hal_vmvx_invocation,
+                                iree_hal_vmvx_invocation_t,
+                                offsetof(iree_hal_vmvx_invocation_t,
+                                         slist_next));
+
 typedef struct iree_hal_vmvx_executable_t {
   iree_hal_local_executable_t base;
 
   // Context containing both the VMVX module and the loaded executable.
   iree_vm_context_t* context;
 
+  // Idle invocation states available for reuse by issue_call.
+  iree_hal_vmvx_invocation_slist_t invocation_pool;
+
   // Resolved entry functions from the module.
   iree_host_size_t entry_fn_count;
   iree_vm_function_t entry_fns[];
@@ -57,6 +87,146 @@ static iree_status_t iree_hal_vmvx_executable_verify_entry_point(
   return iree_ok_status();
 }
 
+static void iree_hal_vmvx_invocation_free(
+    iree_hal_vmvx_invocation_t* invocation, iree_allocator_t host_allocator) {
+  iree_vm_stack_deinitialize(invocation->stack);
+  iree_vm_list_deinitialize(invocation->binding_list);
+  for (iree_host_size_t i = 0; i < invocation->binding_capacity; ++i) {
+    iree_vm_buffer_deinitialize(&invocation->binding_buffers[i]);
+  }
+  iree_vm_buffer_deinitialize(&invocation->local_memory_buffer);
+  iree_vm_buffer_deinitialize(&invocation->constants_buffer);
+  iree_allocator_free(host_allocator, invocation);
+}
+
+// Allocates a new invocation state with room for up to |binding_capacity|
+// bindings. Spans are assigned by iree_hal_vmvx_invocation_prepare.
+static iree_status_t iree_hal_vmvx_invocation_allocate(
+    iree_hal_vmvx_executable_t* executable, iree_host_size_t binding_capacity,
+    iree_hal_vmvx_invocation_t** out_invocation) {
+  *out_invocation = NULL;
+  iree_allocator_t host_allocator = executable->base.host_allocator;
+
+  iree_vm_type_def_t buffer_type =
+      iree_vm_type_def_make_ref_type(iree_vm_buffer_type_id());
+  iree_host_size_t stack_size = IREE_VM_STACK_DEFAULT_SIZE;
+  iree_host_size_t list_size = iree_host_align(
+      iree_vm_list_storage_size(&buffer_type, binding_capacity),
+      iree_max_align_t);
+  iree_host_size_t header_size =
+      iree_host_align(sizeof(iree_hal_vmvx_invocation_t), iree_max_align_t);
+  iree_host_size_t total_size = header_size + stack_size + list_size +
+                                binding_capacity * sizeof(iree_vm_buffer_t);
+
+  iree_hal_vmvx_invocation_t* invocation = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_allocator_malloc(host_allocator, total_size, (void**)&invocation));
+  memset(invocation, 0, sizeof(*invocation));
+  uint8_t* stack_storage = (uint8_t*)invocation + header_size;
+  uint8_t* list_storage = stack_storage + stack_size;
+  invocation->binding_capacity = binding_capacity;
+  invocation->binding_buffers =
+      (iree_vm_buffer_t*)(list_storage + list_size);
+
+  iree_status_t status = iree_vm_stack_initialize(
+      iree_make_byte_span(stack_storage, stack_size),
+      iree_vm_context_state_resolver(executable->context), host_allocator,
+      &invocation->stack);
+  if (!iree_status_is_ok(status)) {
+    iree_allocator_free(host_allocator, invocation);
+    return status;
+  }
+  status = iree_vm_list_initialize(
+      iree_make_byte_span(list_storage, list_size), &buffer_type,
+      binding_capacity, &invocation->binding_list);
+  if (!iree_status_is_ok(status)) {
+    iree_vm_stack_deinitialize(invocation->stack);
+    iree_allocator_free(host_allocator, invocation);
+    return status;
+  }
+
+  // TODO(benvanik): executable layout contains the required access
+  // information. We will likely want to encode a bitmap of mutable bindings
+  // such that we can quickly set the access bit, though.
+  for (iree_host_size_t i = 0; i < binding_capacity; ++i) {
+    iree_vm_buffer_initialize(
+        IREE_VM_BUFFER_ACCESS_MUTABLE | IREE_VM_BUFFER_ACCESS_ORIGIN_HOST,
+        iree_make_byte_span(NULL, 0), iree_allocator_null(),
+        &invocation->binding_buffers[i]);
+  }
+  iree_vm_buffer_initialize(
+      IREE_VM_BUFFER_ACCESS_MUTABLE | IREE_VM_BUFFER_ACCESS_ORIGIN_HOST,
+      iree_make_byte_span(NULL, 0), iree_allocator_null(),
+      &invocation->local_memory_buffer);
+  iree_vm_buffer_initialize(IREE_VM_BUFFER_ACCESS_ORIGIN_HOST,
+                            iree_make_byte_span(NULL, 0),
+                            iree_allocator_null(),
+                            &invocation->constants_buffer);
+
+  *out_invocation = invocation;
+  return iree_ok_status();
+}
+
+// Points the buffers of |invocation| at the memory of |dispatch_state|.
+// The binding list is only rebuilt when the binding count changes; otherwise
+// the already-listed buffers are retargeted in place.
+static iree_status_t iree_hal_vmvx_invocation_prepare(
+    iree_hal_vmvx_invocation_t* invocation,
+    const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
+    iree_byte_span_t local_memory) {
+  iree_host_size_t binding_count = dispatch_state->binding_count;
+  if (iree_vm_list_size(invocation->binding_list) != binding_count) {
+    IREE_RETURN_IF_ERROR(iree_vm_list_resize(invocation->binding_list, 0));
+    for (iree_host_size_t i = 0; i < binding_count; ++i) {
+      iree_vm_ref_t ref = {0};
+      IREE_RETURN_IF_ERROR(iree_vm_ref_wrap_assign(
+          &invocation->binding_buffers[i], iree_vm_buffer_type_id(), &ref));
+      IREE_RETURN_IF_ERROR(
+          iree_vm_list_push_ref_retain(invocation->binding_list, &ref));
+    }
+  }
+  for (iree_host_size_t i = 0; i < binding_count; ++i) {
+    invocation->binding_buffers[i].data = iree_make_byte_span(
+        dispatch_state->binding_ptrs[i], dispatch_state->binding_lengths[i]);
+  }
+  invocation->local_memory_buffer.data = local_memory;
+  invocation->constants_buffer.data = iree_make_byte_span(
+      (void*)dispatch_state->push_constants,
+      sizeof(uint32_t) * dispatch_state->push_constant_count);
+  return iree_ok_status();
+}
+
+// Acquires an invocation state able to hold |binding_count| bindings, reusing
+// an idle one from the executable pool when possible.
+static iree_status_t iree_hal_vmvx_executable_acquire_invocation(
+    iree_hal_vmvx_executable_t* executable, iree_host_size_t binding_count,
+    iree_hal_vmvx_invocation_t** out_invocation) {
+  iree_hal_vmvx_invocation_t* invocation =
+      iree_hal_vmvx_invocation_slist_pop(&executable->invocation_pool);
+  if (invocation && invocation->binding_capacity >= binding_count) {
+    *out_invocation = invocation;
+    return iree_ok_status();
+  }
+  // Rare: the pool is empty (a new worker) or the pooled state is too small
+  // for this dispatch and must be grown.
+  iree_host_size_t binding_capacity = binding_count;
+  if (invocation) {
+    binding_capacity = iree_max(binding_capacity,
+                                invocation->binding_capacity * 2);
+    iree_hal_vmvx_invocation_free(invocation, executable->base.host_allocator);
+  }
+  return iree_hal_vmvx_invocation_allocate(executable, binding_capacity,
+                                           out_invocation);
+}
+
+// Returns |invocation| to the executable pool for reuse by subsequent calls.
+static void iree_hal_vmvx_executable_release_invocation(
+    iree_hal_vmvx_executable_t* executable,
+    iree_hal_vmvx_invocation_t* invocation) {
+  iree_hal_vmvx_invocation_slist_push(&executable->invocation_pool,
+                                      invocation);
+}
+
 static iree_status_t iree_hal_vmvx_executable_create(
     iree_vm_context_t* context, iree_vm_module_t* bytecode_module,
     iree_host_size_t executable_layout_count,
@@ -99,7 +269,9 @@ static iree_status_t iree_hal_vmvx_executable_create(
         &executable->base);
     executable->context = context;
     executable->base.dispatch_attrs = dispatch_attrs;
+    executable->base.entry_point_count = entry_count;
     iree_vm_context_retain(executable->context);
+    iree_hal_vmvx_invocation_slist_initialize(&executable->invocation_pool);
 
     executable->entry_fn_count = entry_count;
     for (iree_host_size_t i = 0; i < executable->entry_fn_count; ++i) {
@@ -127,6 +299,7 @@ static iree_status_t iree_hal_vmvx_executable_create(
       }
       local_memory_size /= IREE_HAL_WORKGROUP_LOCAL_MEMORY_PAGE_SIZE;
       dispatch_attrs[i].local_memory_pages = (uint16_t)local_memory_size;
+      dispatch_attrs[i].workgroup_cost = 0;
     }
   }
 
@@ -146,6 +319,19 @@ static void iree_hal_vmvx_executable_destroy(
   iree_allocator_t host_allocator = executable->base.host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  iree_hal_vmvx_invocation_t* invocation = NULL;
+  if (iree_hal_vmvx_invocation_slist_flush(
+          &executable->invocation_pool,
+          IREE_ATOMIC_SLIST_FLUSH_ORDER_APPROXIMATE_LIFO, &invocation, NULL)) {
+    while (invocation) {
+      iree_hal_vmvx_invocation_t* next =
+          iree_hal_vmvx_invocation_slist_get_next(invocation);
+      iree_hal_vmvx_invocation_free(invocation, host_allocator);
+      invocation = next;
+    }
+  }
+  iree_hal_vmvx_invocation_slist_deinitialize(&executable->invocation_pool);
+
   iree_vm_context_release(executable->context);
   iree_hal_local_executable_deinitialize(
       (iree_hal_local_executable_t*)base_executable);
@@ -176,63 +362,25 @@ static iree_status_t iree_hal_vmvx_executable_issue_call(
                                       entry_point_name.size);
 #endif  // IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
 
-  // On-stack interface local to this invocation.
-  // Note that we _could_ share this across all invocations in a dispatch, but
-  // it's tricky to find a good place when threading is happening and it's
-  // intentionally fairly cheap to construct by matching the dispatch_state.
-  // The list would only need to be constructed once and we could avoid the
-  // extraneous retain/releases and mappings.
-  iree_vm_type_def_t buffer_type =
-      iree_vm_type_def_make_ref_type(iree_vm_buffer_type_id());
-  iree_host_size_t binding_list_size =
-      iree_vm_list_storage_size(&buffer_type, dispatch_state->binding_count);
-  void* binding_list_storage = iree_alloca(binding_list_size);
-  iree_vm_list_t* binding_list = NULL;
+  // Reuse the invocation state of a previous call such that only the spans
+  // referenced by the buffers change and the binding list and stack are not
+  // reconstructed per workgroup.
+  iree_hal_vmvx_invocation_t* invocation = NULL;
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0, iree_vm_list_initialize(
-              iree_make_byte_span(binding_list_storage, binding_list_size),
-              &buffer_type, dispatch_state->binding_count, &binding_list));
-  iree_vm_list_retain(binding_list);  // for call
-
-  // Map bindings into on-stack VMVX buffers.
-  iree_vm_buffer_t* binding_buffers = (iree_vm_buffer_t*)iree_alloca(
-      dispatch_state->binding_count * sizeof(iree_vm_buffer_t));
-  for (iree_host_size_t i = 0; i < dispatch_state->binding_count; ++i) {
-    iree_vm_buffer_t* binding_buffer = &binding_buffers[i];
-    // TODO(benvanik): executable layout contains the required access
-    // information. We will likely want to encode a bitmap of mutable bindings
-    // such that we can quickly set the access bit, though.
-    iree_vm_buffer_access_t access =
-        IREE_VM_BUFFER_ACCESS_MUTABLE | IREE_VM_BUFFER_ACCESS_ORIGIN_HOST;
-    iree_vm_buffer_initialize(
-        access,
-        iree_make_byte_span(dispatch_state->binding_ptrs[i],
-                            dispatch_state->binding_lengths[i]),
-        iree_allocator_null(), binding_buffer);
-    iree_vm_ref_t ref = {0};
-    IREE_RETURN_AND_END_ZONE_IF_ERROR(
-        z0, iree_vm_ref_wrap_assign(binding_buffer, iree_vm_buffer_type_id(),
-                                    &ref));
-    IREE_RETURN_AND_END_ZONE_IF_ERROR(
-        z0, iree_vm_list_push_ref_retain(binding_list, &ref));
+      z0, iree_hal_vmvx_executable_acquire_invocation(
+              executable, dispatch_state->binding_count, &invocation));
+  iree_status_t status = iree_hal_vmvx_invocation_prepare(
+      invocation, dispatch_state, local_memory);
+  if (!iree_status_is_ok(status)) {
+    iree_hal_vmvx_executable_release_invocation(executable, invocation);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
   }
 
-  // Acquire workgroup local memory for the dispatch.
-  iree_vm_buffer_t local_memory_buffer;
-  iree_vm_buffer_initialize(
-      IREE_VM_BUFFER_ACCESS_MUTABLE | IREE_VM_BUFFER_ACCESS_ORIGIN_HOST,
-      local_memory, iree_allocator_null(), &local_memory_buffer);
-  iree_vm_buffer_retain(&local_memory_buffer);  // for call
-
-  // Map the push constant memory directly from the dispatch state.
-  iree_vm_buffer_t constants_buffer;
-  iree_vm_buffer_initialize(
-      IREE_VM_BUFFER_ACCESS_ORIGIN_HOST,
-      iree_make_byte_span(
-          (void*)dispatch_state->push_constants,
-          sizeof(uint32_t) * dispatch_state->push_constant_count),
-      iree_allocator_null(), &constants_buffer);
-  iree_vm_buffer_retain(&constants_buffer);  // for call
+  // The callee releases the argument refs when it returns.
+  iree_vm_buffer_retain(&invocation->local_memory_buffer);  // for call
+  iree_vm_buffer_retain(&invocation->constants_buffer);     // for call
+  iree_vm_list_retain(invocation->binding_list);            // for call
 
   // Prepare call argument buffer. We've verified the signature on creation and
   // know the exact format we can assume here.
@@ -271,19 +419,19 @@ static iree_status_t iree_hal_vmvx_executable_issue_call(
       .local_memory =
           {
               .type = iree_vm_buffer_type_id(),
-              .ptr = &local_memory_buffer,
+              .ptr = &invocation->local_memory_buffer,
               .offsetof_counter = 0,
           },
       .constants =
           {
               .type = iree_vm_buffer_type_id(),
-              .ptr = &constants_buffer,
+              .ptr = &invocation->constants_buffer,
               .offsetof_counter = 0,
           },
       .bindings =
           {
               .type = iree_vm_list_type_id(),
-              .ptr = binding_list,
+              .ptr = invocation->binding_list,
               .offsetof_counter = 0,
           },
       .workgroup_x = workgroup_id->x,
@@ -297,12 +445,6 @@ static iree_status_t iree_hal_vmvx_executable_issue_call(
       .workgroup_count_z = dispatch_state->workgroup_count.z,
   };
 
-  // On-stack stack. We really do abuse the stack too much here.
-  // TODO(benvanik): pass in an iree_arena_t that can be used for this.
-  IREE_VM_INLINE_STACK_INITIALIZE(
-      stack, iree_vm_context_state_resolver(executable->context),
-      executable->base.host_allocator);
-
   // Direct call interface.
   iree_vm_function_call_t call;
   memset(&call, 0, sizeof(call));
@@ -310,16 +452,14 @@ static iree_status_t iree_hal_vmvx_executable_issue_call(
   call.arguments = iree_make_byte_span(&call_args, sizeof(call_args));
   call.results = iree_make_byte_span(NULL, 0);
   iree_vm_execution_result_t result;
-  iree_status_t status =
-      entry_fn.module->begin_call(entry_fn.module->self, stack, &call, &result);
+  status = entry_fn.module->begin_call(entry_fn.module->self,
+                                       invocation->stack, &call, &result);
 
-  iree_vm_stack_deinitialize(stack);
-
-  iree_vm_buffer_deinitialize(&local_memory_buffer);
-  iree_vm_buffer_deinitialize(&constants_buffer);
-  iree_vm_list_deinitialize(binding_list);
-  for (iree_host_size_t i = 0; i < dispatch_state->binding_count; ++i) {
-    iree_vm_buffer_deinitialize(&binding_buffers[i]);
+  // Failed calls may leave frames on the stack so the state is not reused.
+  if (iree_status_is_ok(status)) {
+    iree_hal_vmvx_executable_release_invocation(executable, invocation);
+  } else {
+    iree_hal_vmvx_invocation_free(invocation, executable->base.host_allocator);
   }
 
   IREE_TRACE_ZONE_END(z0);
@@ -435,7 +575,7 @@ static iree_status_t iree_hal_vmvx_module_loader_try_load(
   // we have it) to the module to manage.
   iree_vm_module_t* bytecode_module = NULL;
   iree_status_t status = iree_vm_bytecode_module_create(
-      executable_spec->executable_data, bytecode_module_allocator,
+      bytecode_module_data, bytecode_module_allocator,
       executable_loader->host_allocator, &bytecode_module);
 
   // Create the context tying together the shared VMVX module and the
@@ -20,6 +20,7 @@ void iree_hal_local_executable_initialize(
 
   out_base_executable->executable_layout_count = executable_layout_count;
   out_base_executable->executable_layouts = target_executable_layouts;
+  out_base_executable->entry_point_count = executable_layout_count;
   for (iree_host_size_t i = 0; i < executable_layout_count; ++i) {
     target_executable_layouts[i] =
         (iree_hal_local_executable_layout_t*)source_executable_layouts[i];
@@ -28,6 +29,8 @@ void iree_hal_local_executable_initialize(
 
   // Function attributes are optional and populated by the parent type.
   out_base_executable->dispatch_attrs = NULL;
+  out_base_executable->entry_point_names = NULL;
+  out_base_executable->fpu_state_flags = IREE_FPU_STATE_DEFAULT;
 
   // Imports will be provided by the parent type, if needed.
   out_base_executable->import_thunk = NULL;
@@ -48,6 +51,16 @@ iree_hal_local_executable_t* iree_hal_local_executable_cast(
   return (iree_hal_local_executable_t*)base_value;
 }
 
+iree_string_view_t iree_hal_local_executable_entry_point_name(
+    iree_hal_local_executable_t* executable, iree_host_size_t ordinal) {
+  if (!executable->entry_point_names ||
+      ordinal >= executable->entry_point_count ||
+      !executable->entry_point_names[ordinal]) {
+    return iree_string_view_empty();
+  }
+  return iree_make_cstring_view(executable->entry_point_names[ordinal]);
+}
+
 iree_status_t iree_hal_local_executable_issue_call(
     iree_hal_local_executable_t* executable, iree_host_size_t ordinal,
     const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
@@ -78,6 +91,11 @@ iree_status_t iree_hal_local_executable_issue_dispatch_inline(
   IREE_TRACE_ZONE_APPEND_TEXT_STRING_VIEW(z0, xyz_string, xyz_string_length);
 #endif  // IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
 
+  // Threads already in the required FPU state (such as task executor workers)
+  // skip the FPU state writes.
+  iree_fpu_state_t fpu_state =
+      iree_fpu_state_push(executable->fpu_state_flags);
+
   iree_status_t status = iree_ok_status();
 
   iree_hal_vec3_t workgroup_id;
@@ -94,6 +112,8 @@ iree_status_t iree_hal_local_executable_issue_dispatch_inline(
     }
   }
 
+  iree_fpu_state_pop(fpu_state);
+
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
@@ -8,6 +8,7 @@
 #define IREE_HAL_LOCAL_LOCAL_EXECUTABLE_H_
 
 #include "iree/base/api.h"
+#include "iree/base/internal/fpu_state.h"
 #include "iree/hal/api.h"
 #include "iree/hal/local/executable_library.h"
 #include "iree/hal/local/local_executable_layout.h"
@@ -22,12 +23,25 @@ typedef struct iree_hal_local_executable_t {
   iree_host_size_t executable_layout_count;
   iree_hal_local_executable_layout_t** executable_layouts;
 
+  // Total number of entry points in the executable. Defaults to
+  // executable_layout_count and is populated by the parent type when the
+  // executable declares its entry points (as layouts may be omitted by tools).
+  iree_host_size_t entry_point_count;
+
   // Defines per-entry point how much workgroup local memory is required.
   // Contains entries with 0 to indicate no local memory is required or >0 in
   // units of IREE_HAL_WORKGROUP_LOCAL_MEMORY_PAGE_SIZE for the minimum amount
   // of memory required by the function.
   const iree_hal_executable_dispatch_attrs_v0_t* dispatch_attrs;
 
+  // Optional entry point names 1:1 with the entry points. Only used for
+  // debugging and profiling and may be NULL. Populated by the parent type.
+  const char* const* entry_point_names;
+
+  // FPU state required by all entry points while executing, such as flushing
+  // denormals to zero. Populated by the parent type.
+  iree_fpu_state_flags_t fpu_state_flags;
+
   // Thunk function for calling imports. All calls must be made through this.
   iree_hal_executable_import_thunk_v0_t import_thunk;
   // Optional imported functions available for use within the executable.
@@ -60,9 +74,25 @@ void iree_hal_local_executable_initialize(
 void iree_hal_local_executable_deinitialize(
     iree_hal_local_executable_t* base_executable);
 
+// Returns the FPU state flags required by the entry points of a library
+// declaring the given |features|.
+static inline iree_fpu_state_flags_t iree_hal_local_executable_fpu_state_flags(
+    iree_hal_executable_library_features_t features) {
+  return iree_all_bits_set(
+             features,
+             IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_FLUSH_DENORMALS_TO_ZERO)
+             ? IREE_FPU_STATE_FLAG_FLUSH_DENORMALS_TO_ZERO
+             : IREE_FPU_STATE_DEFAULT;
+}
+
 iree_hal_local_executable_t* iree_hal_local_executable_cast(
     iree_hal_executable_t* base_value);
 
+// Returns the name of the entry point at |ordinal| or an empty string if the
+// executable does not have names available.
+iree_string_view_t iree_hal_local_executable_entry_point_name(
+    iree_hal_local_executable_t* executable, iree_host_size_t ordinal);
+
 iree_status_t iree_hal_local_executable_issue_call(
     iree_hal_local_executable_t* executable, iree_host_size_t ordinal,
     const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
@@ -8,13 +8,271 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <string.h>
 
+#include "iree/base/internal/call_once.h"
+#include "iree/base/internal/synchronization.h"
 #include "iree/base/tracing.h"
+#include "iree/hal/local/local_executable_layout.h"
+
+//===----------------------------------------------------------------------===//
+// Process-wide prepared executable memo
+//===----------------------------------------------------------------------===//
+
+// Caches created with IREE_HAL_LOCAL_EXECUTABLE_CACHE_FLAG_SHARE_EXECUTABLES
+// memoize the executables they prepare from aliased data
+// (IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA with
+// IREE_HAL_EXECUTABLE_CACHING_MODE_ALLOW_PERSISTENT_CACHING) process-wide so
+// that preparing the same executable again from any sharing cache (and thus
+// any device) returns the already loaded executable instead of loading and
+// relocating it again.
+//
+// Entries are matched by the identity of the executable data: the same data
+// pointer and length along with an identical caching mode, format, and
+// dispatch-relevant layout properties. Loaded executables may alias their data
+// and callers only guarantee that their own data outlives their cache so an
+// executable is only shared with callers that provided the very same memory.
+// The contents are never copied or hashed. Entries are also only reused by
+// caches using the same loader and host allocator; these ensure imports
+// resolve identically and the executable can outlive the cache it was
+// prepared with.
+//
+// Entries are evicted when the cache that created them is destroyed (as the
+// aliased data is only guaranteed to be valid until then), when they are the
+// least recently used and the memo is full, or when trimmed with
+// iree_hal_local_executable_cache_trim.
+
+// Identity of a prepared executable. |meta| holds the caching mode, format,
+// and the dispatch-relevant properties of the layouts and |data| the
+// executable contents aliased from the caller.
+typedef struct iree_hal_local_executable_memo_key_t {
+  iree_const_byte_span_t meta;
+  iree_const_byte_span_t data;
+} iree_hal_local_executable_memo_key_t;
+
+typedef struct iree_hal_local_executable_memo_entry_t {
+  // Key with a copy of |meta| owned by the entry; |data| is aliased.
+  iree_hal_local_executable_memo_key_t key;
+  // Cache that prepared the executable; NULL if the entry is unused.
+  const void* owner;
+  iree_allocator_t host_allocator;
+  iree_hal_executable_loader_t* loader;
+  iree_hal_executable_t* executable;
+  // Value of the memo use counter the last time the entry was used.
+  uint64_t last_use;
+} iree_hal_local_executable_memo_entry_t;
+
+typedef struct iree_hal_local_executable_memo_t {
+  iree_slim_mutex_t mutex;
+  uint64_t use_counter;
+  iree_hal_local_executable_memo_entry_t
+      entries[IREE_HAL_LOCAL_EXECUTABLE_CACHE_SHARED_CAPACITY];
+} iree_hal_local_executable_memo_t;
+
+static iree_hal_local_executable_memo_t iree_hal_local_executable_memo_;
+static iree_once_flag iree_hal_local_executable_memo_flag_ =
+    IREE_ONCE_FLAG_INIT;
+static void iree_hal_local_executable_memo_initialize(void) {
+  memset(&iree_hal_local_executable_memo_, 0,
+         sizeof(iree_hal_local_executable_memo_));
+  iree_slim_mutex_initialize(&iree_hal_local_executable_memo_.mutex);
+}
+
+static iree_hal_local_executable_memo_t* iree_hal_local_executable_memo(void) {
+  iree_call_once(&iree_hal_local_executable_memo_flag_,
+                 iree_hal_local_executable_memo_initialize);
+  return &iree_hal_local_executable_memo_;
+}
+
+// Initializes |out_key| with the memo key of |executable_spec|. Only the
+// properties of the layouts that affect dispatch are included so that layouts
+// created by different devices match. The key references |executable_spec|
+// and must be deinitialized with
+// iree_hal_local_executable_memo_key_deinitialize.
+static iree_status_t iree_hal_local_executable_memo_key_initialize(
+    const iree_hal_executable_spec_t* executable_spec,
+    iree_allocator_t host_allocator,
+    iree_hal_local_executable_memo_key_t* out_key) {
+  memset(out_key, 0, sizeof(*out_key));
+
+  iree_host_size_t meta_length =
+      sizeof(executable_spec->caching_mode) +
+      executable_spec->executable_format.size +
+      executable_spec->executable_layout_count * 4 * sizeof(uint64_t);
+  uint8_t* meta = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_allocator_malloc(host_allocator, meta_length, (void**)&meta));
+  uint8_t* p = meta;
+  memcpy(p, &executable_spec->caching_mode,
+         sizeof(executable_spec->caching_mode));
+  p += sizeof(executable_spec->caching_mode);
+  memcpy(p, executable_spec->executable_format.data,
+         executable_spec->executable_format.size);
+  p += executable_spec->executable_format.size;
+  for (iree_host_size_t i = 0; i < executable_spec->executable_layout_count;
+       ++i) {
+    uint64_t layout_key[4] = {0, 0, 0, 0};
+    if (executable_spec->executable_layouts[i]) {
+      iree_hal_local_executable_layout_t* layout =
+          iree_hal_local_executable_layout_cast(
+              executable_spec->executable_layouts[i]);
+      layout_key[0] = layout->push_constants;
+      layout_key[1] = layout->dynamic_binding_count;
+      layout_key[2] = layout->used_bindings;
+      layout_key[3] = layout->set_layout_count;
+    }
+    memcpy(p, layout_key, sizeof(layout_key));
+    p += sizeof(layout_key);
+  }
+  out_key->meta = iree_make_const_byte_span(meta, meta_length);
+  out_key->data = executable_spec->executable_data;
+  return iree_ok_status();
+}
+
+static void iree_hal_local_executable_memo_key_deinitialize(
+    iree_hal_local_executable_memo_key_t* key,
+    iree_allocator_t host_allocator) {
+  iree_allocator_free(host_allocator, (void*)key->meta.data);
+  memset(key, 0, sizeof(*key));
+}
+
+static bool iree_hal_local_executable_memo_entry_matches(
+    const iree_hal_local_executable_memo_entry_t* entry,
+    const iree_hal_local_executable_memo_key_t* key,
+    iree_hal_executable_loader_t* loader, iree_allocator_t host_allocator) {
+  return entry->owner && entry->key.data.data == key->data.data &&
+         entry->key.data.data_length == key->data.data_length &&
+         entry->loader == loader &&
+         entry->host_allocator.self == host_allocator.self &&
+         entry->host_allocator.ctl == host_allocator.ctl &&
+         entry->key.meta.data_length == key->meta.data_length &&
+         memcmp(entry->key.meta.data, key->meta.data,
+                key->meta.data_length) == 0;
+}
+
+// Returns a new reference to the memoized executable matching the key, if any.
+static iree_hal_executable_t* iree_hal_local_executable_memo_lookup(
+    const iree_hal_local_executable_memo_key_t* key,
+    iree_hal_executable_loader_t* loader, iree_allocator_t host_allocator) {
+  iree_hal_local_executable_memo_t* memo = iree_hal_local_executable_memo();
+  iree_hal_executable_t* executable = NULL;
+  iree_slim_mutex_lock(&memo->mutex);
+  for (iree_host_size_t i = 0;
+       i < IREE_HAL_LOCAL_EXECUTABLE_CACHE_SHARED_CAPACITY; ++i) {
+    iree_hal_local_executable_memo_entry_t* entry = &memo->entries[i];
+    if (!iree_hal_local_executable_memo_entry_matches(entry, key, loader,
+                                                      host_allocator)) {
+      continue;
+    }
+    entry->last_use = ++memo->use_counter;
+    executable = entry->executable;
+    iree_hal_executable_retain(executable);
+    break;
+  }
+  iree_slim_mutex_unlock(&memo->mutex);
+  return executable;
+}
+
+// Releases the resources retained by a memo |entry| that has been removed
+// from the memo.
+static void iree_hal_local_executable_memo_entry_release(
+    iree_hal_local_executable_memo_entry_t* entry) {
+  if (!entry->owner) return;
+  iree_hal_executable_release(entry->executable);
+  iree_hal_executable_loader_release(entry->loader);
+  iree_allocator_free(entry->host_allocator, (void*)entry->key.meta.data);
+}
+
+// Memoizes |executable| prepared by |owner|, evicting the least recently used
+// entry if the memo is full. If another thread memoized a matching executable
+// first then that one is kept. Failing to copy the key only skips memoization.
+static void iree_hal_local_executable_memo_insert(
+    const void* owner, const iree_hal_local_executable_memo_key_t* key,
+    iree_hal_executable_loader_t* loader, iree_allocator_t host_allocator,
+    iree_hal_executable_t* executable) {
+  iree_hal_local_executable_memo_t* memo = iree_hal_local_executable_memo();
+  uint8_t* meta = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, key->meta.data_length, (void**)&meta);
+  if (!iree_status_is_ok(status)) {
+    iree_status_ignore(status);
+    return;
+  }
+  memcpy(meta, key->meta.data, key->meta.data_length);
+  iree_hal_local_executable_memo_entry_t evicted;
+  memset(&evicted, 0, sizeof(evicted));
+  iree_slim_mutex_lock(&memo->mutex);
+  iree_hal_local_executable_memo_entry_t* target = NULL;
+  for (iree_host_size_t i = 0;
+       i < IREE_HAL_LOCAL_EXECUTABLE_CACHE_SHARED_CAPACITY; ++i) {
+    iree_hal_local_executable_memo_entry_t* entry = &memo->entries[i];
+    if (iree_hal_local_executable_memo_entry_matches(entry, key, loader,
+                                                     host_allocator)) {
+      target = NULL;
+      break;
+    }
+    if (!target || (target->owner && (!entry->owner ||
+                                       entry->last_use < target->last_use))) {
+      target = entry;
+    }
+  }
+  if (target) {
+    evicted = *target;
+    target->key.meta = iree_make_const_byte_span(meta, key->meta.data_length);
+    target->key.data = key->data;
+    meta = NULL;
+    target->owner = owner;
+    target->host_allocator = host_allocator;
+    target->loader = loader;
+    iree_hal_executable_loader_retain(loader);
+    target->executable = executable;
+    iree_hal_executable_retain(executable);
+    target->last_use = ++memo->use_counter;
+  }
+  iree_slim_mutex_unlock(&memo->mutex);
+  // Released outside of the lock as it may run arbitrary destruction code.
+  iree_hal_local_executable_memo_entry_release(&evicted);
+  iree_allocator_free(host_allocator, meta);
+}
+
+// Removes all entries memoized by |owner| (or all entries if NULL) from the
+// memo and releases them.
+static void iree_hal_local_executable_memo_evict(const void* owner) {
+  iree_hal_local_executable_memo_t* memo = iree_hal_local_executable_memo();
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_local_executable_memo_entry_t
+      evicted[IREE_HAL_LOCAL_EXECUTABLE_CACHE_SHARED_CAPACITY];
+  memset(evicted, 0, sizeof(evicted));
+  iree_slim_mutex_lock(&memo->mutex);
+  for (iree_host_size_t i = 0;
+       i < IREE_HAL_LOCAL_EXECUTABLE_CACHE_SHARED_CAPACITY; ++i) {
+    iree_hal_local_executable_memo_entry_t* entry = &memo->entries[i];
+    if (!entry->owner || (owner && entry->owner != owner)) continue;
+    evicted[i] = *entry;
+    memset(entry, 0, sizeof(*entry));
+  }
+  iree_slim_mutex_unlock(&memo->mutex);
+  for (iree_host_size_t i = 0;
+       i < IREE_HAL_LOCAL_EXECUTABLE_CACHE_SHARED_CAPACITY; ++i) {
+    iree_hal_local_executable_memo_entry_release(&evicted[i]);
+  }
+  IREE_TRACE_ZONE_END(z0);
+}
+
+void iree_hal_local_executable_cache_trim(void) {
+  iree_hal_local_executable_memo_evict(/*owner=*/NULL);
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_local_executable_cache_t
+//===----------------------------------------------------------------------===//
 
 typedef struct iree_hal_local_executable_cache_t {
   iree_hal_resource_t resource;
   iree_allocator_t host_allocator;
   iree_string_view_t identifier;
+  iree_hal_local_executable_cache_flags_t flags;
+  iree_hal_inline_parallel_for_t parallel_for;
   iree_host_size_t loader_count;
   iree_hal_executable_loader_t* loaders[];
 } iree_hal_local_executable_cache_t;
@@ -30,7 +288,10 @@ static iree_hal_local_executable_cache_t* iree_hal_local_executable_cache_cast(
 
 iree_status_t iree_hal_local_executable_cache_create(
     iree_string_view_t identifier, iree_host_size_t loader_count,
-    iree_hal_executable_loader_t** loaders, iree_allocator_t host_allocator,
+    iree_hal_executable_loader_t** loaders,
+    iree_hal_inline_parallel_for_t parallel_for,
+    iree_hal_local_executable_cache_flags_t flags,
+    iree_allocator_t host_allocator,
     iree_hal_executable_cache_t** out_executable_cache) {
   IREE_ASSERT_ARGUMENT(!loader_count || loaders);
   IREE_ASSERT_ARGUMENT(out_executable_cache);
@@ -52,6 +313,10 @@ iree_status_t iree_hal_local_executable_cache_create(
         identifier, &executable_cache->identifier,
         (char*)executable_cache + total_size - identifier.size);
 
+    executable_cache->flags = flags;
+    executable_cache->parallel_for = parallel_for;
+    if (parallel_for.retain) parallel_for.retain(parallel_for.self);
+
     executable_cache->loader_count = loader_count;
     for (iree_host_size_t i = 0; i < executable_cache->loader_count; ++i) {
       executable_cache->loaders[i] = loaders[i];
@@ -72,9 +337,17 @@ static void iree_hal_local_executable_cache_destroy(
   iree_allocator_t host_allocator = executable_cache->host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  if (executable_cache->flags &
+      IREE_HAL_LOCAL_EXECUTABLE_CACHE_FLAG_SHARE_EXECUTABLES) {
+    iree_hal_local_executable_memo_evict(executable_cache);
+  }
+
   for (iree_host_size_t i = 0; i < executable_cache->loader_count; ++i) {
     iree_hal_executable_loader_release(executable_cache->loaders[i]);
   }
+  if (executable_cache->parallel_for.release) {
+    executable_cache->parallel_for.release(executable_cache->parallel_for.self);
+  }
   iree_allocator_free(host_allocator, executable_cache);
 
   IREE_TRACE_ZONE_END(z0);
@@ -95,26 +368,40 @@ static bool iree_hal_local_executable_cache_can_prepare_format(
   return false;
 }
 
-static iree_status_t iree_hal_local_executable_cache_prepare_executable(
-    iree_hal_executable_cache_t* base_executable_cache,
+// Prepares |executable_spec| with the first loader that supports it. If
+// |memo_key| is provided then the process-wide memo is consulted first and
+// updated with the loaded executable.
+static iree_status_t iree_hal_local_executable_cache_prepare_with_loaders(
+    iree_hal_local_executable_cache_t* executable_cache,
     const iree_hal_executable_spec_t* executable_spec,
+    const iree_hal_local_executable_memo_key_t* memo_key,
     iree_hal_executable_t** out_executable) {
-  iree_hal_local_executable_cache_t* executable_cache =
-      iree_hal_local_executable_cache_cast(base_executable_cache);
   for (iree_host_size_t i = 0; i < executable_cache->loader_count; ++i) {
+    iree_hal_executable_loader_t* loader = executable_cache->loaders[i];
     if (!iree_hal_executable_loader_query_support(
-            executable_cache->loaders[i], executable_spec->caching_mode,
+            loader, executable_spec->caching_mode,
             executable_spec->executable_format)) {
       // Loader definitely can't handle the executable; no use trying so skip.
       continue;
     }
+    if (memo_key) {
+      *out_executable = iree_hal_local_executable_memo_lookup(
+          memo_key, loader, executable_cache->host_allocator);
+      if (*out_executable) return iree_ok_status();
+    }
     // The loader _may_ handle the executable; if the specific executable is not
     // supported then the try will fail with IREE_STATUS_CANCELLED and we should
     // continue trying other loaders.
-    iree_status_t status = iree_hal_executable_loader_try_load(
-        executable_cache->loaders[i], executable_spec, out_executable);
+    iree_status_t status =
+        iree_hal_executable_loader_try_load(loader, executable_spec,
+                                            out_executable);
     if (iree_status_is_ok(status)) {
       // Executable was successfully loaded.
+      if (memo_key) {
+        iree_hal_local_executable_memo_insert(
+            executable_cache, memo_key, loader,
+            executable_cache->host_allocator, *out_executable);
+      }
       return status;
     } else if (!iree_status_is_cancelled(status)) {
       // Error beyond just the try failing due to unsupported formats.
@@ -129,6 +416,81 @@ static iree_status_t iree_hal_local_executable_cache_prepare_executable(
       executable_spec->executable_format.data);
 }
 
+static iree_status_t iree_hal_local_executable_cache_prepare_executable(
+    iree_hal_executable_cache_t* base_executable_cache,
+    const iree_hal_executable_spec_t* executable_spec,
+    iree_hal_executable_t** out_executable) {
+  iree_hal_local_executable_cache_t* executable_cache =
+      iree_hal_local_executable_cache_cast(base_executable_cache);
+
+  // Only executables aliasing the caller data are memoized so that entries can
+  // be matched by the identity of the data without copying it.
+  const bool memoize =
+      iree_all_bits_set(
+          executable_cache->flags,
+          IREE_HAL_LOCAL_EXECUTABLE_CACHE_FLAG_SHARE_EXECUTABLES) &&
+      iree_all_bits_set(
+          executable_spec->caching_mode,
+          IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA |
+              IREE_HAL_EXECUTABLE_CACHING_MODE_ALLOW_PERSISTENT_CACHING);
+  iree_hal_local_executable_memo_key_t key;
+  memset(&key, 0, sizeof(key));
+  if (memoize) {
+    IREE_RETURN_IF_ERROR(iree_hal_local_executable_memo_key_initialize(
+        executable_spec, executable_cache->host_allocator, &key));
+  }
+  iree_status_t status = iree_hal_local_executable_cache_prepare_with_loaders(
+      executable_cache, executable_spec, memoize ? &key : NULL,
+      out_executable);
+  if (memoize) {
+    iree_hal_local_executable_memo_key_deinitialize(
+        &key, executable_cache->host_allocator);
+  }
+  return status;
+}
+
+typedef struct iree_hal_local_executable_cache_preload_t {
+  iree_hal_local_executable_cache_t* executable_cache;
+  const iree_const_byte_span_t* executable_datas;
+} iree_hal_local_executable_cache_preload_t;
+
+static iree_status_t iree_hal_local_executable_cache_preload_item(
+    void* user_data, iree_host_size_t participant_index, uint32_t item_index) {
+  iree_hal_local_executable_cache_preload_t* preload =
+      (iree_hal_local_executable_cache_preload_t*)user_data;
+  iree_hal_local_executable_cache_t* executable_cache =
+      preload->executable_cache;
+  for (iree_host_size_t i = 0; i < executable_cache->loader_count; ++i) {
+    // Failures are ignored: the data may not be an executable at all and if
+    // it is then preparing it will fail again with the same error.
+    iree_status_ignore(iree_hal_executable_loader_preload(
+        executable_cache->loaders[i], preload->executable_datas[item_index]));
+  }
+  return iree_ok_status();
+}
+
+static void iree_hal_local_executable_cache_preload_executables(
+    iree_hal_executable_cache_t* base_executable_cache,
+    iree_host_size_t executable_count,
+    const iree_const_byte_span_t* executable_datas) {
+  iree_hal_local_executable_cache_t* executable_cache =
+      iree_hal_local_executable_cache_cast(base_executable_cache);
+  iree_hal_local_executable_cache_preload_t preload = {
+      .executable_cache = executable_cache,
+      .executable_datas = executable_datas,
+  };
+  if (executable_cache->parallel_for.run) {
+    iree_status_ignore(executable_cache->parallel_for.run(
+        executable_cache->parallel_for.self, (uint32_t)executable_count,
+        iree_hal_local_executable_cache_preload_item, &preload));
+  } else {
+    for (iree_host_size_t i = 0; i < executable_count; ++i) {
+      iree_status_ignore(iree_hal_local_executable_cache_preload_item(
+          &preload, /*participant_index=*/0, (uint32_t)i));
+    }
+  }
+}
+
 static const iree_hal_executable_cache_vtable_t
     iree_hal_local_executable_cache_vtable = {
         .destroy = iree_hal_local_executable_cache_destroy,
@@ -136,4 +498,6 @@ static const iree_hal_executable_cache_vtable_t
             iree_hal_local_executable_cache_can_prepare_format,
         .prepare_executable =
             iree_hal_local_executable_cache_prepare_executable,
+        .preload_executables =
+            iree_hal_local_executable_cache_preload_executables,
 };
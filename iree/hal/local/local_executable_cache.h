@@ -10,6 +10,7 @@
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
 #include "iree/hal/local/executable_loader.h"
+#include "iree/hal/local/inline_command_buffer.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -18,16 +19,42 @@ extern "C" {
 // TODO(benvanik): when we refactor executable caches this can become something
 // more specialized; like nop_executable_cache (does nothing but pass through)
 // or inproc_lru_executable_cache (simple in-memory LRU of recent executables).
-//
-// We can also set this up so they share storage. Ideally a JIT'ed executable in
-// one device is the same JIT'ed executable in another, and in multi-tenant
-// situations we're likely to want that isolation _and_ sharing.
 
+// Maximum number of prepared executables memoized process-wide.
+#define IREE_HAL_LOCAL_EXECUTABLE_CACHE_SHARED_CAPACITY 64
+
+// Bitfield specifying the behavior of a local executable cache.
+enum iree_hal_local_executable_cache_flag_bits_t {
+  IREE_HAL_LOCAL_EXECUTABLE_CACHE_FLAG_NONE = 0u,
+  // Shares prepared executables process-wide with other caches created with
+  // this flag that use the same loaders and host allocator. Only executables
+  // prepared with both IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA and
+  // IREE_HAL_EXECUTABLE_CACHING_MODE_ALLOW_PERSISTENT_CACHING are shared and
+  // only when prepared again from the same executable data memory (such as
+  // the same module loaded on multiple devices). The shared executables remain
+  // memoized until the cache that prepared them is destroyed.
+  IREE_HAL_LOCAL_EXECUTABLE_CACHE_FLAG_SHARE_EXECUTABLES = 1u << 0,
+};
+typedef uint32_t iree_hal_local_executable_cache_flags_t;
+
+// Creates an executable cache that prepares executables with |loaders|.
+//
+// Executables preloaded with iree_hal_executable_cache_preload_executables are
+// distributed across |parallel_for| when it has a |run| function and
+// otherwise preloaded serially on the calling thread. |parallel_for| is
+// retained by the cache.
 iree_status_t iree_hal_local_executable_cache_create(
     iree_string_view_t identifier, iree_host_size_t loader_count,
-    iree_hal_executable_loader_t** loaders, iree_allocator_t host_allocator,
+    iree_hal_executable_loader_t** loaders,
+    iree_hal_inline_parallel_for_t parallel_for,
+    iree_hal_local_executable_cache_flags_t flags,
+    iree_allocator_t host_allocator,
     iree_hal_executable_cache_t** out_executable_cache);
 
+// Releases all executables shared process-wide. Executables still in use
+// remain valid but will be loaded again the next time they are prepared.
+void iree_hal_local_executable_cache_trim(void);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -0,0 +1,221 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/local_executable_cache.h"
+
+#include <cstring>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/local/executable_library_demo.h"
+#include "iree/hal/local/loaders/static_library_loader.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+// Static library executables are identified by the name of the library.
+constexpr char kLibraryName[] = "demo_library";
+
+class LocalExecutableCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    const iree_hal_executable_library_header_t** const libraries[] = {
+        demo_executable_library_query(
+            IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION, /*reserved=*/NULL),
+    };
+    IREE_ASSERT_OK(iree_hal_static_library_loader_create(
+        IREE_ARRAYSIZE(libraries), libraries,
+        iree_hal_executable_import_provider_null(), iree_allocator_system(),
+        &loader_));
+  }
+
+  void TearDown() override {
+    iree_hal_local_executable_cache_trim();
+    iree_hal_executable_loader_release(loader_);
+  }
+
+  iree_hal_executable_cache_t* CreateCache(
+      iree_hal_local_executable_cache_flags_t flags) {
+    iree_hal_executable_cache_t* executable_cache = NULL;
+    IREE_CHECK_OK(iree_hal_local_executable_cache_create(
+        iree_make_cstring_view("test"), /*loader_count=*/1, &loader_,
+        iree_hal_inline_parallel_for_null(), flags, iree_allocator_system(),
+        &executable_cache));
+    return executable_cache;
+  }
+
+  // Prepares the demo library named by the |name_length| bytes at |name|.
+  iree_hal_executable_t* Prepare(
+      iree_hal_executable_cache_t* executable_cache, const char* name,
+      iree_host_size_t name_length,
+      iree_hal_executable_caching_mode_t caching_mode) {
+    iree_hal_executable_spec_t spec;
+    iree_hal_executable_spec_initialize(&spec);
+    spec.caching_mode = caching_mode;
+    spec.executable_format = iree_make_cstring_view("static");
+    spec.executable_data =
+        iree_make_const_byte_span((const uint8_t*)name, name_length);
+    iree_hal_executable_t* executable = NULL;
+    IREE_CHECK_OK(iree_hal_executable_cache_prepare_executable(
+        executable_cache, &spec, &executable));
+    return executable;
+  }
+
+  iree_hal_executable_t* Prepare(
+      iree_hal_executable_cache_t* executable_cache,
+      iree_hal_executable_caching_mode_t caching_mode = kSharedMode) {
+    return Prepare(executable_cache, kLibraryName, strlen(kLibraryName),
+                   caching_mode);
+  }
+
+  static constexpr iree_hal_executable_caching_mode_t kSharedMode =
+      IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA |
+      IREE_HAL_EXECUTABLE_CACHING_MODE_ALLOW_PERSISTENT_CACHING;
+
+  iree_hal_executable_loader_t* loader_ = NULL;
+};
+
+// Caches sharing executables return the same executable for the same data.
+TEST_F(LocalExecutableCacheTest, SharedHit) {
+  iree_hal_executable_cache_t* cache_a =
+      CreateCache(IREE_HAL_LOCAL_EXECUTABLE_CACHE_FLAG_SHARE_EXECUTABLES);
+  iree_hal_executable_cache_t* cache_b =
+      CreateCache(IREE_HAL_LOCAL_EXECUTABLE_CACHE_FLAG_SHARE_EXECUTABLES);
+  iree_hal_executable_t* executable_a = Prepare(cache_a);
+  iree_hal_executable_t* executable_b = Prepare(cache_b);
+  iree_hal_executable_t* executable_a2 = Prepare(cache_a);
+  EXPECT_EQ(executable_a, executable_b);
+  EXPECT_EQ(executable_a, executable_a2);
+  iree_hal_executable_release(executable_a2);
+  iree_hal_executable_release(executable_b);
+  iree_hal_executable_release(executable_a);
+  iree_hal_executable_cache_release(cache_b);
+  iree_hal_executable_cache_release(cache_a);
+}
+
+// Sharing is opt-in per cache.
+TEST_F(LocalExecutableCacheTest, MissWithoutOptIn) {
+  iree_hal_executable_cache_t* cache_a =
+      CreateCache(IREE_HAL_LOCAL_EXECUTABLE_CACHE_FLAG_SHARE_EXECUTABLES);
+  iree_hal_executable_cache_t* cache_b =
+      CreateCache(IREE_HAL_LOCAL_EXECUTABLE_CACHE_FLAG_NONE);
+  iree_hal_executable_t* executable_a = Prepare(cache_a);
+  iree_hal_executable_t* executable_b = Prepare(cache_b);
+  iree_hal_executable_t* executable_b2 = Prepare(cache_b);
+  EXPECT_NE(executable_a, executable_b);
+  EXPECT_NE(executable_b, executable_b2);
+  iree_hal_executable_release(executable_b2);
+  iree_hal_executable_release(executable_b);
+  iree_hal_executable_release(executable_a);
+  iree_hal_executable_cache_release(cache_b);
+  iree_hal_executable_cache_release(cache_a);
+}
+
+// Executables that do not alias their data are not shared as the memo would
+// otherwise need its own copy of the data to compare against.
+TEST_F(LocalExecutableCacheTest, MissWithoutAliasing) {
+  iree_hal_executable_cache_t* cache =
+      CreateCache(IREE_HAL_LOCAL_EXECUTABLE_CACHE_FLAG_SHARE_EXECUTABLES);
+  iree_hal_executable_t* executable_a = Prepare(
+      cache, IREE_HAL_EXECUTABLE_CACHING_MODE_ALLOW_PERSISTENT_CACHING);
+  iree_hal_executable_t* executable_b = Prepare(
+      cache, IREE_HAL_EXECUTABLE_CACHING_MODE_ALLOW_PERSISTENT_CACHING);
+  EXPECT_NE(executable_a, executable_b);
+  iree_hal_executable_release(executable_b);
+  iree_hal_executable_release(executable_a);
+  iree_hal_executable_cache_release(cache);
+}
+
+// Executables prepared from identical contents in different memory are not
+// shared: the executable may alias the memory it was prepared from and each
+// caller only guarantees the lifetime of its own.
+TEST_F(LocalExecutableCacheTest, MissOnIdenticalContentsInOtherMemory) {
+  iree_hal_executable_cache_t* cache =
+      CreateCache(IREE_HAL_LOCAL_EXECUTABLE_CACHE_FLAG_SHARE_EXECUTABLES);
+  char name_copy[sizeof(kLibraryName)];
+  memcpy(name_copy, kLibraryName, sizeof(name_copy));
+  iree_hal_executable_t* executable_a = Prepare(cache);
+  iree_hal_executable_t* executable_b =
+      Prepare(cache, name_copy, strlen(name_copy), kSharedMode);
+  EXPECT_NE(executable_a, executable_b);
+  iree_hal_executable_release(executable_b);
+  iree_hal_executable_release(executable_a);
+  iree_hal_executable_cache_release(cache);
+}
+
+// Executables prepared from the same memory with a different caching mode (or
+// layouts) are distinct entries.
+TEST_F(LocalExecutableCacheTest, MissOnDifferentCachingMode) {
+  iree_hal_executable_cache_t* cache =
+      CreateCache(IREE_HAL_LOCAL_EXECUTABLE_CACHE_FLAG_SHARE_EXECUTABLES);
+  iree_hal_executable_t* executable_a = Prepare(cache);
+  iree_hal_executable_t* executable_b =
+      Prepare(cache, kSharedMode |
+                         IREE_HAL_EXECUTABLE_CACHING_MODE_ALLOW_OPTIMIZATION);
+  EXPECT_NE(executable_a, executable_b);
+  iree_hal_executable_release(executable_b);
+  iree_hal_executable_release(executable_a);
+  iree_hal_executable_cache_release(cache);
+}
+
+// Trimming releases the shared executables; executables still in use remain
+// valid and the next prepare loads the executable again.
+TEST_F(LocalExecutableCacheTest, Trim) {
+  iree_hal_executable_cache_t* cache =
+      CreateCache(IREE_HAL_LOCAL_EXECUTABLE_CACHE_FLAG_SHARE_EXECUTABLES);
+  iree_hal_executable_t* executable_a = Prepare(cache);
+  iree_hal_local_executable_cache_trim();
+  iree_hal_executable_t* executable_b = Prepare(cache);
+  EXPECT_NE(executable_a, executable_b);
+  iree_hal_executable_t* executable_b2 = Prepare(cache);
+  EXPECT_EQ(executable_b, executable_b2);
+  iree_hal_executable_release(executable_b2);
+  iree_hal_executable_release(executable_b);
+  iree_hal_executable_release(executable_a);
+  iree_hal_executable_cache_release(cache);
+}
+
+// The least recently used executable is evicted when the memo is full.
+TEST_F(LocalExecutableCacheTest, EvictsLeastRecentlyUsed) {
+  constexpr int kCount = IREE_HAL_LOCAL_EXECUTABLE_CACHE_SHARED_CAPACITY + 1;
+  iree_hal_executable_cache_t* cache =
+      CreateCache(IREE_HAL_LOCAL_EXECUTABLE_CACHE_FLAG_SHARE_EXECUTABLES);
+  char names[kCount][sizeof(kLibraryName)];
+  iree_hal_executable_t* executables[kCount];
+  for (int i = 0; i < kCount; ++i) {
+    memcpy(names[i], kLibraryName, sizeof(kLibraryName));
+    executables[i] = Prepare(cache, names[i], strlen(names[i]), kSharedMode);
+  }
+  iree_hal_executable_t* first =
+      Prepare(cache, names[0], strlen(names[0]), kSharedMode);
+  iree_hal_executable_t* last =
+      Prepare(cache, names[kCount - 1], strlen(names[kCount - 1]), kSharedMode);
+  EXPECT_NE(first, executables[0]);
+  EXPECT_EQ(last, executables[kCount - 1]);
+  iree_hal_executable_release(last);
+  iree_hal_executable_release(first);
+  for (int i = 0; i < kCount; ++i) iree_hal_executable_release(executables[i]);
+  iree_hal_executable_cache_release(cache);
+}
+
+// Executables are evicted when the cache that prepared them is destroyed as
+// their data is only guaranteed to be valid until then.
+TEST_F(LocalExecutableCacheTest, EvictedWithPreparingCache) {
+  iree_hal_executable_cache_t* cache_a =
+      CreateCache(IREE_HAL_LOCAL_EXECUTABLE_CACHE_FLAG_SHARE_EXECUTABLES);
+  iree_hal_executable_t* executable_a = Prepare(cache_a);
+  iree_hal_executable_cache_release(cache_a);
+  iree_hal_executable_cache_t* cache_b =
+      CreateCache(IREE_HAL_LOCAL_EXECUTABLE_CACHE_FLAG_SHARE_EXECUTABLES);
+  iree_hal_executable_t* executable_b = Prepare(cache_b);
+  EXPECT_NE(executable_a, executable_b);
+  iree_hal_executable_release(executable_b);
+  iree_hal_executable_release(executable_a);
+  iree_hal_executable_cache_release(cache_b);
+}
+
+}  // namespace
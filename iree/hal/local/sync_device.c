@@ -10,6 +10,7 @@
 #include <stdint.h>
 #include <string.h>
 
+#include "iree/base/internal/cpu.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/local/inline_command_buffer.h"
 #include "iree/hal/local/local_descriptor_set.h"
@@ -28,6 +29,11 @@ typedef struct iree_hal_sync_device_t {
 
   iree_hal_sync_semaphore_state_t semaphore_state;
 
+  iree_hal_inline_parallel_for_t parallel_for;
+
+  // Flags of the executable caches created by the device.
+  iree_hal_local_executable_cache_flags_t executable_cache_flags;
+
   iree_host_size_t loader_count;
   iree_hal_executable_loader_t* loaders[];
 } iree_hal_sync_device_t;
@@ -43,10 +49,16 @@ static iree_hal_sync_device_t* iree_hal_sync_device_cast(
 void iree_hal_sync_device_params_initialize(
     iree_hal_sync_device_params_t* out_params) {
   memset(out_params, 0, sizeof(*out_params));
+  iree_hal_heap_allocator_params_initialize(&out_params->heap_allocator);
+  out_params->parallel_for = iree_hal_inline_parallel_for_null();
 }
 
 static iree_status_t iree_hal_sync_device_check_params(
     const iree_hal_sync_device_params_t* params) {
+  if (params->parallel_for.run && params->parallel_for.participant_count == 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "parallel_for must have at least one participant");
+  }
   return iree_ok_status();
 }
 
@@ -84,11 +96,21 @@ iree_status_t iree_hal_sync_device_create(
     }
 
     iree_hal_sync_semaphore_state_initialize(&device->semaphore_state);
+
+    device->executable_cache_flags =
+        params->share_executables
+            ? IREE_HAL_LOCAL_EXECUTABLE_CACHE_FLAG_SHARE_EXECUTABLES
+            : IREE_HAL_LOCAL_EXECUTABLE_CACHE_FLAG_NONE;
+    device->parallel_for = params->parallel_for;
+    if (device->parallel_for.retain) {
+      device->parallel_for.retain(device->parallel_for.self);
+    }
   }
 
   if (iree_status_is_ok(status)) {
-    status = iree_hal_allocator_create_heap(identifier, host_allocator,
-                                            &device->device_allocator);
+    status = iree_hal_allocator_create_heap_with_params(
+        identifier, &params->heap_allocator, host_allocator,
+        &device->device_allocator);
   }
 
   if (iree_status_is_ok(status)) {
@@ -107,6 +129,10 @@ static void iree_hal_sync_device_destroy(iree_hal_device_t* base_device) {
 
   iree_hal_sync_semaphore_state_deinitialize(&device->semaphore_state);
 
+  if (device->parallel_for.release) {
+    device->parallel_for.release(device->parallel_for.self);
+  }
+
   for (iree_host_size_t i = 0; i < device->loader_count; ++i) {
     iree_hal_executable_loader_release(device->loaders[i]);
   }
@@ -148,6 +174,11 @@ static iree_status_t iree_hal_sync_device_query_i32(
             ? 1
             : 0;
     return iree_ok_status();
+  } else if (iree_string_view_equal(
+                 category, iree_make_cstring_view("hal.device.feature"))) {
+    // Executables run on the host CPU and may require CPU features.
+    *out_value = iree_cpu_supports_features(key) ? 1 : 0;
+    return iree_ok_status();
   }
 
   return iree_make_status(
@@ -161,10 +192,11 @@ static iree_status_t iree_hal_sync_device_create_command_buffer(
     iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity,
     iree_hal_command_buffer_t** out_command_buffer) {
+  iree_hal_sync_device_t* device = iree_hal_sync_device_cast(base_device);
   // TODO(#4680): implement a non-inline command buffer that stores its commands
   // and can be submitted later on/multiple-times.
   return iree_hal_inline_command_buffer_create(
-      mode, command_categories, queue_affinity,
+      mode, command_categories, queue_affinity, device->parallel_for,
       iree_hal_device_host_allocator(base_device), out_command_buffer);
 }
 
@@ -200,7 +232,8 @@ static iree_status_t iree_hal_sync_device_create_executable_cache(
     iree_hal_executable_cache_t** out_executable_cache) {
   iree_hal_sync_device_t* device = iree_hal_sync_device_cast(base_device);
   return iree_hal_local_executable_cache_create(
-      identifier, device->loader_count, device->loaders,
+      identifier, device->loader_count, device->loaders, device->parallel_for,
+      device->executable_cache_flags,
       iree_hal_device_host_allocator(base_device), out_executable_cache);
 }
 
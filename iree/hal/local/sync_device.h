@@ -10,6 +10,7 @@
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
 #include "iree/hal/local/executable_loader.h"
+#include "iree/hal/local/inline_command_buffer.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -18,7 +19,19 @@ extern "C" {
 // Parameters configuring an iree_hal_sync_device_t.
 // Must be initialized with iree_hal_sync_device_params_initialize prior to use.
 typedef struct iree_hal_sync_device_params_t {
-  int reserved;
+  // Shares executables prepared by the device with other devices that also
+  // enable sharing when they are prepared from the same executable data (see
+  // IREE_HAL_LOCAL_EXECUTABLE_CACHE_FLAG_SHARE_EXECUTABLES).
+  bool share_executables;
+
+  // Parameters of the heap allocator used for device buffers.
+  iree_hal_heap_allocator_params_t heap_allocator;
+
+  // Optional fork-join parallelism used to distribute the workgroups of each
+  // dispatch across a small set of threads while still executing command
+  // buffers inline. Retained by the device. Defaults to running everything on
+  // the calling thread.
+  iree_hal_inline_parallel_for_t parallel_for;
 } iree_hal_sync_device_params_t;
 
 // Initializes |out_params| to default values.
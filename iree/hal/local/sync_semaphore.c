@@ -16,6 +16,14 @@
 // Sentinel used the semaphore has failed and an error status is set.
 #define IREE_HAL_SYNC_SEMAPHORE_FAILURE_VALUE UINT64_MAX
 
+// Duration in nanoseconds a waiter spins watching for semaphore signals before
+// parking in the OS. Work on local devices frequently completes within
+// microseconds of the wait starting and spinning avoids the context switches
+// on both the signaling and waiting threads. 0 disables spinning.
+#if !defined(IREE_HAL_SYNC_SEMAPHORE_SPIN_NS)
+#define IREE_HAL_SYNC_SEMAPHORE_SPIN_NS (50 * 1000)
+#endif  // !IREE_HAL_SYNC_SEMAPHORE_SPIN_NS
+
 //===----------------------------------------------------------------------===//
 // iree_hal_sync_semaphore_state_t
 //===----------------------------------------------------------------------===//
@@ -255,21 +263,18 @@ static iree_status_t iree_hal_sync_semaphore_wait(
   }
   iree_slim_mutex_unlock(&semaphore->mutex);
 
-  // TODO(#4680): we should be checking for DEADLINE_EXCEEDED here. This is
-  // easy when it's iree_timeout_is_infinite (we can just use the notification
-  // as below) but if it's an actual deadline we'll need to probably switch to
-  // iree_wait_handle_t.
-
-  // Perform wait on the global notification. Will wait forever.
+  // Perform wait on the global notification, spinning briefly first in case
+  // the signal is imminent.
   iree_hal_sync_semaphore_state_t* shared_state = semaphore->shared_state;
   iree_hal_sync_semaphore_notify_state_t notify_state = {
       .semaphore = semaphore,
       .value = value,
   };
-  iree_notification_await(
+  iree_notification_await_until(
       &shared_state->notification,
       (iree_condition_fn_t)iree_hal_sync_semaphore_is_signaled,
-      (void*)&notify_state);
+      (void*)&notify_state, IREE_HAL_SYNC_SEMAPHORE_SPIN_NS,
+      iree_timeout_as_deadline_ns(timeout));
 
   iree_status_t status = iree_ok_status();
   iree_slim_mutex_lock(&semaphore->mutex);
@@ -384,18 +389,15 @@ iree_status_t iree_hal_sync_semaphore_multi_wait(
     return status;
   }
 
-  // TODO(#4680): we should be checking for DEADLINE_EXCEEDED here. This is
-  // easy when it's iree_timeout_is_infinite (we can just use the notification
-  // as below) but if it's an actual deadline we'll need to probably switch to
-  // iree_wait_handle_t.
-
-  // Perform wait on the global notification. Will wait forever.
-  iree_notification_await(
+  // Perform wait on the global notification. Any signal of any semaphore posts
+  // it so the condition checks the whole list at once for both wait modes.
+  iree_notification_await_until(
       &shared_state->notification,
       wait_mode == IREE_HAL_WAIT_MODE_ALL
           ? (iree_condition_fn_t)iree_hal_sync_semaphore_all_signaled
           : (iree_condition_fn_t)iree_hal_sync_semaphore_any_signaled,
-      (void*)semaphore_list);
+      (void*)semaphore_list, IREE_HAL_SYNC_SEMAPHORE_SPIN_NS,
+      iree_timeout_as_deadline_ns(timeout));
 
   // We may have been successful - or may have a partial failure.
   iree_status_t status =
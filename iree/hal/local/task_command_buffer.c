@@ -12,6 +12,7 @@
 #include <string.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/local/executable_library.h"
 #include "iree/hal/local/local_descriptor_set_layout.h"
@@ -26,6 +27,35 @@
 // iree_hal_task_command_buffer_t
 //===----------------------------------------------------------------------===//
 
+// A task recorded into a reusable command buffer along with the completion
+// task it was linked to during recording. Retiring a task clears its
+// completion task so we keep a copy to restore the DAG on resubmission.
+typedef struct iree_hal_task_cmd_record_t {
+  struct iree_hal_task_cmd_record_t* next;
+  iree_task_t* task;
+  iree_task_t* completion_task;
+} iree_hal_task_cmd_record_t;
+
+// Maximum number of distinct buffer ranges tracked within a single
+// synchronization scope. Scopes touching more ranges than this will have all
+// subsequent barriers emitted conservatively.
+#define IREE_HAL_TASK_CMD_MAX_SCOPE_ACCESS_COUNT 64
+
+// Maximum number of buffer ranges a single recorded command may access: one
+// per possible dispatch binding plus the indirect dispatch workgroup count.
+#define IREE_HAL_TASK_CMD_MAX_COMMAND_ACCESS_COUNT (64 + 1)
+
+// A range of an allocated buffer accessed by a recorded command.
+// Ranges are tracked against the allocated buffer so that subspans of the same
+// allocation are compared correctly.
+typedef struct iree_hal_task_cmd_access_t {
+  iree_hal_buffer_t* buffer;
+  iree_device_size_t offset;
+  // Exclusive end offset; IREE_WHOLE_BUFFER if the range extends to the end.
+  iree_device_size_t end;
+  iree_hal_memory_access_t access;
+} iree_hal_task_cmd_access_t;
+
 // iree/task/-based command buffer.
 // We track a minimal amount of state here and incrementally build out the task
 // DAG that we can submit to the task system directly. There's no intermediate
@@ -43,6 +73,13 @@ typedef struct iree_hal_task_command_buffer_t {
   iree_hal_command_category_t allowed_categories;
   iree_hal_queue_affinity_t queue_affinity;
 
+  // Thresholds below which dispatches are executed inline on a single worker.
+  uint32_t inline_dispatch_max_workgroup_count;
+  uint64_t inline_dispatch_max_cost;
+
+  // Optional dispatch profiling context receiving recorded dispatch statistics.
+  iree_hal_task_profiling_context_t* profiling_context;
+
   // Arena used for all allocations; references the shared device block pool.
   iree_arena_allocator_t arena;
 
@@ -58,6 +95,37 @@ typedef struct iree_hal_task_command_buffer_t {
   // An empty list indicates that root_tasks are also the leaves.
   iree_task_list_t leaf_tasks;
 
+  // Maximum workgroup local memory required by any recorded dispatch. The
+  // executor must have at least this much reserved per worker before issue.
+  iree_host_size_t max_local_memory_size;
+
+  // Number of issues of the command buffer that have not yet retired.
+  // Incremented by iree_hal_task_command_buffer_issue and decremented by
+  // iree_hal_task_command_buffer_retire once the queue has retired the
+  // submission and no task of the issue can still be running.
+  iree_atomic_int32_t in_flight_count;
+
+  // State used to replay reusable (non-ONE_SHOT) command buffers.
+  // The task DAG is built once during recording and on each subsequent issue
+  // the tasks are re-armed in-place instead of being recorded again. All
+  // storage is allocated from the arena.
+  struct {
+    // All tasks recorded in the order they were emitted.
+    iree_hal_task_cmd_record_t* head;
+    iree_hal_task_cmd_record_t* tail;
+
+    // Snapshots of the root/leaf task lists taken when recording ends. The
+    // lists themselves are consumed by the task system when submitted.
+    iree_host_size_t root_task_count;
+    iree_task_t** root_tasks;
+    iree_host_size_t leaf_task_count;
+    iree_task_t** leaf_tasks;
+
+    // True if the command buffer has been issued at least once and the tasks
+    // must be re-armed prior to being submitted again.
+    bool issued;
+  } replay;
+
   // TODO(benvanik): move this out of the struct and allocate from the arena -
   // we only need this during recording and it's ~4KB of waste otherwise.
   // State tracked within the command buffer during recording only.
@@ -77,6 +145,21 @@ typedef struct iree_hal_task_command_buffer_t {
     // All execution tasks emitted that must execute after |open_barrier|.
     iree_task_list_t open_tasks;
 
+    // True if an execution barrier has been requested but not yet emitted.
+    // Barriers are deferred until a command is recorded that conflicts with
+    // the accesses of the current scope; commands that don't conflict are
+    // placed into the current scope and allowed to run concurrently with it.
+    bool pending_barrier;
+
+    // True if the current scope accessed more ranges than can be tracked in
+    // |scope_accesses| and any barrier must be emitted conservatively.
+    bool scope_accesses_overflowed;
+
+    // Buffer ranges accessed by all commands in the current scope.
+    iree_host_size_t scope_access_count;
+    iree_hal_task_cmd_access_t
+        scope_accesses[IREE_HAL_TASK_CMD_MAX_SCOPE_ACCESS_COUNT];
+
     // A flattened list of all available descriptor set bindings.
     // As descriptor sets are pushed/bound the bindings will be updated to
     // represent the fully-translated binding data pointer.
@@ -88,6 +171,12 @@ typedef struct iree_hal_task_command_buffer_t {
         binding_lengths[IREE_HAL_LOCAL_MAX_DESCRIPTOR_SET_COUNT *
                         IREE_HAL_LOCAL_MAX_DESCRIPTOR_BINDING_COUNT];
 
+    // The buffer range and access of each binding in |bindings| used to
+    // determine which dispatches may overlap across barriers.
+    iree_hal_task_cmd_access_t
+        binding_accesses[IREE_HAL_LOCAL_MAX_DESCRIPTOR_SET_COUNT *
+                         IREE_HAL_LOCAL_MAX_DESCRIPTOR_BINDING_COUNT];
+
     // All available push constants updated each time push_constants is called.
     // Reset only with the command buffer and otherwise will maintain its values
     // during recording to allow for partial push_constants updates.
@@ -108,23 +197,18 @@ iree_status_t iree_hal_task_command_buffer_create(
     iree_task_scope_t* scope, iree_hal_command_buffer_mode_t mode,
     iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity,
+    uint32_t inline_dispatch_max_workgroup_count,
+    uint64_t inline_dispatch_max_cost,
+    iree_hal_task_profiling_context_t* profiling_context,
     iree_arena_block_pool_t* block_pool, iree_allocator_t host_allocator,
     iree_hal_command_buffer_t** out_command_buffer) {
   IREE_ASSERT_ARGUMENT(out_command_buffer);
   *out_command_buffer = NULL;
-  if (!iree_all_bits_set(mode, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT)) {
-    // If we want reuse we'd need to support duplicating the task DAG after
-    // recording or have some kind of copy-on-submit behavior that does so if
-    // a command buffer is submitted for execution twice. Allowing for the same
-    // command buffer to be enqueued multiple times would be fine so long as
-    // execution doesn't overlap (`cmdbuf|cmdbuf` vs
-    // `cmdbuf -> semaphore -> cmdbuf`) though we'd still need to be careful
-    // that we did the enqueuing and reset of the task structures at the right
-    // times. Definitely something that'll be useful in the future... but not
-    // today :)
-    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
-                            "only one-shot command buffer usage is supported");
-  }
+
+  // NOTE: command buffers without IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT are
+  // reusable: the recorded task DAG is retained and re-armed in-place on each
+  // issue. Executions must not overlap (`cmdbuf -> semaphore -> cmdbuf` is
+  // fine while `cmdbuf|cmdbuf` is not) as there is only one copy of the tasks.
 
   IREE_TRACE_ZONE_BEGIN(z0);
 
@@ -139,10 +223,17 @@ iree_status_t iree_hal_task_command_buffer_create(
     command_buffer->mode = mode;
     command_buffer->allowed_categories = command_categories;
     command_buffer->queue_affinity = queue_affinity;
+    command_buffer->inline_dispatch_max_workgroup_count =
+        inline_dispatch_max_workgroup_count;
+    command_buffer->inline_dispatch_max_cost = inline_dispatch_max_cost;
+    command_buffer->profiling_context = profiling_context;
     iree_arena_initialize(block_pool, &command_buffer->arena);
     iree_task_list_initialize(&command_buffer->root_tasks);
     iree_task_list_initialize(&command_buffer->leaf_tasks);
+    memset(&command_buffer->replay, 0, sizeof(command_buffer->replay));
     memset(&command_buffer->state, 0, sizeof(command_buffer->state));
+    iree_atomic_store_int32(&command_buffer->in_flight_count, 0,
+                            iree_memory_order_relaxed);
     *out_command_buffer = (iree_hal_command_buffer_t*)command_buffer;
   }
 
@@ -155,9 +246,18 @@ static void iree_hal_task_command_buffer_reset(
   memset(&command_buffer->state, 0, sizeof(command_buffer->state));
   iree_task_list_discard(&command_buffer->leaf_tasks);
   iree_task_list_discard(&command_buffer->root_tasks);
+  memset(&command_buffer->replay, 0, sizeof(command_buffer->replay));
+  command_buffer->max_local_memory_size = 0;
   iree_arena_reset(&command_buffer->arena);
 }
 
+// Returns true if the command buffer may be issued multiple times.
+static bool iree_hal_task_command_buffer_is_reusable(
+    const iree_hal_task_command_buffer_t* command_buffer) {
+  return !iree_all_bits_set(command_buffer->mode,
+                            IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT);
+}
+
 static void iree_hal_task_command_buffer_destroy(
     iree_hal_command_buffer_t* base_command_buffer) {
   iree_hal_task_command_buffer_t* command_buffer =
@@ -191,6 +291,102 @@ iree_hal_task_command_buffer_allowed_categories(
 static iree_status_t iree_hal_task_command_buffer_flush_tasks(
     iree_hal_task_command_buffer_t* command_buffer);
 
+// Tracks |task| for replay if the command buffer is reusable.
+static iree_status_t iree_hal_task_command_buffer_track_task(
+    iree_hal_task_command_buffer_t* command_buffer, iree_task_t* task) {
+  if (!iree_hal_task_command_buffer_is_reusable(command_buffer)) {
+    return iree_ok_status();
+  }
+  iree_hal_task_cmd_record_t* record = NULL;
+  IREE_RETURN_IF_ERROR(iree_arena_allocate(&command_buffer->arena,
+                                           sizeof(*record), (void**)&record));
+  record->next = NULL;
+  record->task = task;
+  record->completion_task = NULL;
+  if (command_buffer->replay.tail) {
+    command_buffer->replay.tail->next = record;
+  } else {
+    command_buffer->replay.head = record;
+  }
+  command_buffer->replay.tail = record;
+  return iree_ok_status();
+}
+
+// Copies the tasks in |list| into a new arena-allocated array.
+static iree_status_t iree_hal_task_command_buffer_snapshot_list(
+    iree_hal_task_command_buffer_t* command_buffer, iree_task_list_t* list,
+    iree_host_size_t* out_count, iree_task_t*** out_tasks) {
+  iree_host_size_t count = 0;
+  for (iree_task_t* task = list->head; task != NULL; task = task->next_task) {
+    ++count;
+  }
+  iree_task_t** tasks = NULL;
+  if (count > 0) {
+    IREE_RETURN_IF_ERROR(iree_arena_allocate(
+        &command_buffer->arena, count * sizeof(*tasks), (void**)&tasks));
+    iree_host_size_t i = 0;
+    for (iree_task_t* task = list->head; task != NULL; task = task->next_task) {
+      tasks[i++] = task;
+    }
+  }
+  *out_count = count;
+  *out_tasks = tasks;
+  return iree_ok_status();
+}
+
+// Snapshots the fully-recorded task DAG such that it can be re-armed for
+// resubmission after each execution completes.
+static iree_status_t iree_hal_task_command_buffer_snapshot_tasks(
+    iree_hal_task_command_buffer_t* command_buffer) {
+  for (iree_hal_task_cmd_record_t* record = command_buffer->replay.head;
+       record != NULL; record = record->next) {
+    record->completion_task = record->task->completion_task;
+  }
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_snapshot_list(
+      command_buffer, &command_buffer->root_tasks,
+      &command_buffer->replay.root_task_count,
+      &command_buffer->replay.root_tasks));
+  if (iree_task_list_is_empty(&command_buffer->leaf_tasks)) {
+    // Single layer DAG: the roots are also the leaves.
+    command_buffer->replay.leaf_task_count =
+        command_buffer->replay.root_task_count;
+    command_buffer->replay.leaf_tasks = command_buffer->replay.root_tasks;
+    return iree_ok_status();
+  }
+  return iree_hal_task_command_buffer_snapshot_list(
+      command_buffer, &command_buffer->leaf_tasks,
+      &command_buffer->replay.leaf_task_count,
+      &command_buffer->replay.leaf_tasks);
+}
+
+// Re-arms all tasks in a reusable command buffer such that they can be
+// submitted again. The prior issue must have retired.
+static void iree_hal_task_command_buffer_rearm(
+    iree_hal_task_command_buffer_t* command_buffer) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Reset execution state and restore the dependency edges as recorded.
+  // Edges are only added after all tasks are reset as restoring an edge
+  // increments the pending dependency count of the target.
+  for (iree_hal_task_cmd_record_t* record = command_buffer->replay.head;
+       record != NULL; record = record->next) {
+    iree_task_rearm(record->task);
+  }
+  for (iree_hal_task_cmd_record_t* record = command_buffer->replay.head;
+       record != NULL; record = record->next) {
+    if (record->completion_task) {
+      iree_task_set_completion_task(record->task, record->completion_task);
+    }
+    if (record->task->type == IREE_TASK_TYPE_BARRIER) {
+      iree_task_barrier_t* barrier = (iree_task_barrier_t*)record->task;
+      iree_task_barrier_set_dependent_tasks(
+          barrier, barrier->dependent_task_count, barrier->dependent_tasks);
+    }
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
 static iree_status_t iree_hal_task_command_buffer_begin(
     iree_hal_command_buffer_t* base_command_buffer) {
   iree_hal_task_command_buffer_t* command_buffer =
@@ -204,9 +400,11 @@ static iree_status_t iree_hal_task_command_buffer_end(
   iree_hal_task_command_buffer_t* command_buffer =
       iree_hal_task_command_buffer_cast(base_command_buffer);
 
-  // Flush any open barriers.
+  // Flush any open barriers. A barrier still pending at the end of recording
+  // has nothing to order and is dropped.
   IREE_RETURN_IF_ERROR(
       iree_hal_task_command_buffer_flush_tasks(command_buffer));
+  command_buffer->state.pending_barrier = false;
 
   // Move the tasks from the leaf list (tail) to the root list (head) if this
   // was the first set of tasks recorded.
@@ -216,6 +414,11 @@ static iree_status_t iree_hal_task_command_buffer_end(
                         &command_buffer->root_tasks);
   }
 
+  if (iree_hal_task_command_buffer_is_reusable(command_buffer)) {
+    IREE_RETURN_IF_ERROR(
+        iree_hal_task_command_buffer_snapshot_tasks(command_buffer));
+  }
+
   return iree_ok_status();
 }
 
@@ -290,6 +493,8 @@ static iree_status_t iree_hal_task_command_buffer_emit_global_barrier(
   IREE_RETURN_IF_ERROR(iree_arena_allocate(&command_buffer->arena,
                                            sizeof(*barrier), (void**)&barrier));
   iree_task_barrier_initialize_empty(command_buffer->scope, barrier);
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_track_task(
+      command_buffer, &barrier->header));
 
   // If there were previous tasks then join them to the barrier.
   for (iree_task_t* task = iree_task_list_front(&command_buffer->leaf_tasks);
@@ -315,13 +520,113 @@ static iree_status_t iree_hal_task_command_buffer_emit_global_barrier(
   command_buffer->state.open_barrier = barrier;
   command_buffer->state.open_task_count = 0;
 
+  // Start tracking accesses for the new scope.
+  command_buffer->state.pending_barrier = false;
+  command_buffer->state.scope_accesses_overflowed = false;
+  command_buffer->state.scope_access_count = 0;
+
   return iree_ok_status();
 }
 
+// Returns an access of |length| bytes at |offset| into |buffer| (which may be
+// a subspan of a larger allocation).
+static iree_hal_task_cmd_access_t iree_hal_task_cmd_make_access(
+    iree_hal_buffer_t* buffer, iree_device_size_t offset,
+    iree_device_size_t length, iree_hal_memory_access_t access) {
+  iree_hal_task_cmd_access_t result;
+  result.buffer = iree_hal_buffer_allocated_buffer(buffer);
+  result.offset = iree_hal_buffer_byte_offset(buffer) + offset;
+  result.end = length == IREE_WHOLE_BUFFER ? IREE_WHOLE_BUFFER
+                                           : result.offset + length;
+  result.access = access;
+  return result;
+}
+
+// Returns true if |a| and |b| touch overlapping bytes and at least one of them
+// may write; concurrent reads of the same range need no ordering.
+static bool iree_hal_task_cmd_accesses_conflict(
+    const iree_hal_task_cmd_access_t* a, const iree_hal_task_cmd_access_t* b) {
+  if (a->buffer != b->buffer) return false;
+  if (a->offset >= b->end || b->offset >= a->end) return false;
+  const iree_hal_memory_access_t write_bits =
+      IREE_HAL_MEMORY_ACCESS_WRITE | IREE_HAL_MEMORY_ACCESS_DISCARD;
+  return iree_any_bit_set(a->access, write_bits) ||
+         iree_any_bit_set(b->access, write_bits);
+}
+
+// Returns true if a command performing |accesses| can be placed into the
+// current scope without violating the ordering a pending barrier requires.
+static bool iree_hal_task_command_buffer_can_elide_barrier(
+    iree_hal_task_command_buffer_t* command_buffer,
+    iree_host_size_t access_count,
+    const iree_hal_task_cmd_access_t* accesses) {
+  if (command_buffer->state.scope_accesses_overflowed) return false;
+  for (iree_host_size_t i = 0; i < access_count; ++i) {
+    for (iree_host_size_t j = 0; j < command_buffer->state.scope_access_count;
+         ++j) {
+      if (iree_hal_task_cmd_accesses_conflict(
+              &accesses[i], &command_buffer->state.scope_accesses[j])) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Adds |accesses| to the set tracked for the current scope. Ranges of the same
+// buffer that touch are coalesced to keep the set small; this may make the
+// tracking more conservative but never less.
+static void iree_hal_task_command_buffer_record_accesses(
+    iree_hal_task_command_buffer_t* command_buffer,
+    iree_host_size_t access_count,
+    const iree_hal_task_cmd_access_t* accesses) {
+  for (iree_host_size_t i = 0; i < access_count; ++i) {
+    const iree_hal_task_cmd_access_t* access = &accesses[i];
+    bool coalesced = false;
+    for (iree_host_size_t j = 0; j < command_buffer->state.scope_access_count;
+         ++j) {
+      iree_hal_task_cmd_access_t* scope_access =
+          &command_buffer->state.scope_accesses[j];
+      if (scope_access->buffer != access->buffer ||
+          access->offset > scope_access->end ||
+          scope_access->offset > access->end) {
+        continue;
+      }
+      scope_access->offset = iree_min(scope_access->offset, access->offset);
+      scope_access->end = iree_max(scope_access->end, access->end);
+      scope_access->access |= access->access;
+      coalesced = true;
+      break;
+    }
+    if (coalesced) continue;
+    if (command_buffer->state.scope_access_count >=
+        IREE_ARRAYSIZE(command_buffer->state.scope_accesses)) {
+      command_buffer->state.scope_accesses_overflowed = true;
+      continue;
+    }
+    command_buffer->state
+        .scope_accesses[command_buffer->state.scope_access_count++] = *access;
+  }
+}
+
 // Emits a the given execution |task| into the current open synchronization
-// scope (after state.open_barrier and before the next barrier).
+// scope (after state.open_barrier and before the next barrier). |accesses|
+// lists the buffer ranges the task reads and writes and is used to decide
+// whether a pending barrier must be emitted before the task.
 static iree_status_t iree_hal_task_command_buffer_emit_execution_task(
-    iree_hal_task_command_buffer_t* command_buffer, iree_task_t* task) {
+    iree_hal_task_command_buffer_t* command_buffer, iree_task_t* task,
+    iree_host_size_t access_count,
+    const iree_hal_task_cmd_access_t* accesses) {
+  if (command_buffer->state.pending_barrier &&
+      !iree_hal_task_command_buffer_can_elide_barrier(
+          command_buffer, access_count, accesses)) {
+    IREE_RETURN_IF_ERROR(
+        iree_hal_task_command_buffer_emit_global_barrier(command_buffer));
+  }
+  IREE_RETURN_IF_ERROR(
+      iree_hal_task_command_buffer_track_task(command_buffer, task));
+  iree_hal_task_command_buffer_record_accesses(command_buffer, access_count,
+                                               accesses);
   if (command_buffer->state.open_barrier == NULL) {
     // If there is no open barrier then we are at the head and going right into
     // the task DAG.
@@ -338,6 +643,49 @@ static iree_status_t iree_hal_task_command_buffer_emit_execution_task(
 // iree_hal_task_command_buffer_t execution
 //===----------------------------------------------------------------------===//
 
+// Issues a reusable command buffer by re-arming the task DAG recorded in it
+// (if it has been issued before) and submitting the snapshotted root tasks.
+static iree_status_t iree_hal_task_command_buffer_issue_reusable(
+    iree_hal_task_command_buffer_t* command_buffer, iree_task_t* retire_task,
+    iree_task_submission_t* pending_submission) {
+  // If the command buffer is empty (valid!) then we are a no-op.
+  if (command_buffer->replay.root_task_count == 0) return iree_ok_status();
+
+  if (command_buffer->replay.issued) {
+    iree_hal_task_command_buffer_rearm(command_buffer);
+  }
+  command_buffer->replay.issued = true;
+
+  // Chain the retire task onto the leaf tasks as their completion indicates
+  // that all commands have completed.
+  for (iree_host_size_t i = 0; i < command_buffer->replay.leaf_task_count;
+       ++i) {
+    iree_task_set_completion_task(command_buffer->replay.leaf_tasks[i],
+                                  retire_task);
+  }
+
+  // Enqueue all root tasks that are ready to run immediately. The task lists
+  // are consumed by the submission but we can rebuild them from the snapshot.
+  iree_task_list_t root_tasks;
+  iree_task_list_initialize(&root_tasks);
+  for (iree_host_size_t i = 0; i < command_buffer->replay.root_task_count;
+       ++i) {
+    iree_task_list_push_back(&root_tasks, command_buffer->replay.root_tasks[i]);
+  }
+  iree_task_submission_enqueue_list(pending_submission, &root_tasks);
+  iree_task_list_initialize(&command_buffer->root_tasks);
+  iree_task_list_initialize(&command_buffer->leaf_tasks);
+
+  return iree_ok_status();
+}
+
+iree_host_size_t iree_hal_task_command_buffer_local_memory_size(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  iree_hal_task_command_buffer_t* command_buffer =
+      iree_hal_task_command_buffer_cast(base_command_buffer);
+  return command_buffer->max_local_memory_size;
+}
+
 iree_status_t iree_hal_task_command_buffer_issue(
     iree_hal_command_buffer_t* base_command_buffer,
     iree_hal_task_queue_state_t* queue_state, iree_task_t* retire_task,
@@ -345,6 +693,26 @@ iree_status_t iree_hal_task_command_buffer_issue(
   iree_hal_task_command_buffer_t* command_buffer =
       iree_hal_task_command_buffer_cast(base_command_buffer);
 
+  // There is only one copy of the task DAG so a reusable command buffer may
+  // not be issued again until the prior issue has retired. The acquire pairs
+  // with the release in iree_hal_task_command_buffer_retire so that all writes
+  // made to the tasks by workers are visible before they are re-armed.
+  int32_t in_flight_count = iree_atomic_fetch_add_int32(
+      &command_buffer->in_flight_count, 1, iree_memory_order_acq_rel);
+
+  if (iree_hal_task_command_buffer_is_reusable(command_buffer)) {
+    if (IREE_UNLIKELY(in_flight_count != 0)) {
+      iree_atomic_fetch_sub_int32(&command_buffer->in_flight_count, 1,
+                                  iree_memory_order_relaxed);
+      return iree_make_status(
+          IREE_STATUS_FAILED_PRECONDITION,
+          "reusable command buffer issued while a prior execution of it is "
+          "still in-flight; executions must not overlap");
+    }
+    return iree_hal_task_command_buffer_issue_reusable(
+        command_buffer, retire_task, pending_submission);
+  }
+
   // If the command buffer is empty (valid!) then we are a no-op.
   bool has_root_tasks = !iree_task_list_is_empty(&command_buffer->root_tasks);
   if (!has_root_tasks) {
@@ -378,6 +746,14 @@ iree_status_t iree_hal_task_command_buffer_issue(
   return iree_ok_status();
 }
 
+void iree_hal_task_command_buffer_retire(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  iree_hal_task_command_buffer_t* command_buffer =
+      iree_hal_task_command_buffer_cast(base_command_buffer);
+  iree_atomic_fetch_sub_int32(&command_buffer->in_flight_count, 1,
+                              iree_memory_order_release);
+}
+
 //===----------------------------------------------------------------------===//
 // iree_hal_task_command_buffer_t debug utilities
 //===----------------------------------------------------------------------===//
@@ -410,9 +786,13 @@ static iree_status_t iree_hal_task_command_buffer_execution_barrier(
   iree_hal_task_command_buffer_t* command_buffer =
       iree_hal_task_command_buffer_cast(base_command_buffer);
 
-  // TODO(benvanik): actual DAG construction. Right now we are just doing simple
-  // global barriers each time and forcing a join-fork point.
-  return iree_hal_task_command_buffer_emit_global_barrier(command_buffer);
+  // The barrier is deferred until a command is recorded that accesses a buffer
+  // range in conflict with the commands recorded before the barrier. Commands
+  // that don't conflict join the current scope and may overlap with it.
+  // TODO(benvanik): build per-binding dependencies instead of a global
+  // join-fork point once a conflict is found.
+  command_buffer->state.pending_barrier = true;
+  return iree_ok_status();
 }
 
 //===----------------------------------------------------------------------===//
@@ -516,8 +896,12 @@ static iree_status_t iree_hal_task_command_buffer_fill_buffer(
   memcpy(cmd->pattern, pattern, pattern_length);
   cmd->pattern_length = pattern_length;
 
-  return iree_hal_task_command_buffer_emit_execution_task(command_buffer,
-                                                          &cmd->task.header);
+  const iree_hal_task_cmd_access_t accesses[1] = {
+      iree_hal_task_cmd_make_access(target_buffer, target_offset, length,
+                                    IREE_HAL_MEMORY_ACCESS_WRITE),
+  };
+  return iree_hal_task_command_buffer_emit_execution_task(
+      command_buffer, &cmd->task.header, IREE_ARRAYSIZE(accesses), accesses);
 }
 
 //===----------------------------------------------------------------------===//
@@ -569,8 +953,12 @@ static iree_status_t iree_hal_task_command_buffer_update_buffer(
   memcpy(cmd->source_buffer, (const uint8_t*)source_buffer + source_offset,
          cmd->length);
 
-  return iree_hal_task_command_buffer_emit_execution_task(command_buffer,
-                                                          &cmd->task.header);
+  const iree_hal_task_cmd_access_t accesses[1] = {
+      iree_hal_task_cmd_make_access(target_buffer, target_offset, length,
+                                    IREE_HAL_MEMORY_ACCESS_WRITE),
+  };
+  return iree_hal_task_command_buffer_emit_execution_task(
+      command_buffer, &cmd->task.header, IREE_ARRAYSIZE(accesses), accesses);
 }
 
 //===----------------------------------------------------------------------===//
@@ -624,8 +1012,14 @@ static iree_status_t iree_hal_task_command_buffer_copy_buffer(
   cmd->target_offset = target_offset;
   cmd->length = length;
 
-  return iree_hal_task_command_buffer_emit_execution_task(command_buffer,
-                                                          &cmd->task.header);
+  const iree_hal_task_cmd_access_t accesses[2] = {
+      iree_hal_task_cmd_make_access(source_buffer, source_offset, length,
+                                    IREE_HAL_MEMORY_ACCESS_READ),
+      iree_hal_task_cmd_make_access(target_buffer, target_offset, length,
+                                    IREE_HAL_MEMORY_ACCESS_WRITE),
+  };
+  return iree_hal_task_command_buffer_emit_execution_task(
+      command_buffer, &cmd->task.header, IREE_ARRAYSIZE(accesses), accesses);
 }
 
 //===----------------------------------------------------------------------===//
@@ -696,6 +1090,11 @@ static iree_status_t iree_hal_task_command_buffer_push_descriptor_set(
         buffer_mapping.contents.data;
     command_buffer->state.binding_lengths[binding_ordinal] =
         buffer_mapping.contents.data_length;
+    command_buffer->state.binding_accesses[binding_ordinal] =
+        iree_hal_task_cmd_make_access(
+            bindings[i].buffer, bindings[i].offset,
+            buffer_mapping.contents.data_length,
+            local_set_layout->bindings[binding_ordinal].access);
   }
 
   return iree_ok_status();
@@ -721,10 +1120,24 @@ static iree_status_t iree_hal_task_command_buffer_bind_descriptor_set(
 //===----------------------------------------------------------------------===//
 
 typedef struct iree_hal_cmd_dispatch_t {
-  iree_task_dispatch_t task;
+  // Task used to execute the dispatch. Most dispatches are issued as dispatch
+  // tasks that fan out across the executor workers while small ones are run
+  // as a single call task that executes all workgroups on one worker.
+  union {
+    iree_task_t header;
+    iree_task_dispatch_t dispatch;
+    iree_task_call_t call;
+  } task;
   iree_hal_local_executable_t* executable;
   int32_t ordinal;
 
+  // Total workgroup count used when the dispatch is executed inline.
+  uint32_t workgroup_count[3];
+
+  // Optional profiling storage receiving the statistics of the first inline
+  // execution. Dispatch tasks use iree_task_dispatch_t::retire_statistics.
+  iree_task_dispatch_statistics_t* inline_statistics;
+
   // Total number of available 4 byte push constant values in |push_constants|.
   uint16_t push_constant_count;
 
@@ -739,37 +1152,46 @@ typedef struct iree_hal_cmd_dispatch_t {
   // - const size_t binding_lengths[binding_count];
 } iree_hal_cmd_dispatch_t;
 
-static iree_status_t iree_hal_cmd_dispatch_tile(
-    uintptr_t user_context, const iree_task_tile_context_t* tile_context,
-    iree_task_submission_t* pending_submission) {
-  const iree_hal_cmd_dispatch_t* cmd =
-      (const iree_hal_cmd_dispatch_t*)user_context;
-  IREE_TRACE_ZONE_BEGIN(z0);
-
-  iree_hal_executable_dispatch_state_v0_t state;
-  memset(&state, 0, sizeof(state));
-  memcpy(state.workgroup_count.value, tile_context->workgroup_count,
-         sizeof(state.workgroup_count));
-  memcpy(state.workgroup_size.value, tile_context->workgroup_size,
-         sizeof(state.workgroup_size));
+// Populates |out_state| with the dispatch state stored in |cmd|.
+static void iree_hal_cmd_dispatch_initialize_state(
+    const iree_hal_cmd_dispatch_t* cmd, const uint32_t workgroup_count[3],
+    const uint32_t workgroup_size[3],
+    iree_hal_executable_dispatch_state_v0_t* out_state) {
+  memset(out_state, 0, sizeof(*out_state));
+  memcpy(out_state->workgroup_count.value, workgroup_count,
+         sizeof(out_state->workgroup_count));
+  memcpy(out_state->workgroup_size.value, workgroup_size,
+         sizeof(out_state->workgroup_size));
 
   uint8_t* cmd_ptr = (uint8_t*)cmd + sizeof(*cmd);
 
-  state.push_constant_count = cmd->push_constant_count;
-  state.push_constants = (uint32_t*)cmd_ptr;
-  cmd_ptr += cmd->push_constant_count * sizeof(*state.push_constants);
+  out_state->push_constant_count = cmd->push_constant_count;
+  out_state->push_constants = (uint32_t*)cmd_ptr;
+  cmd_ptr += cmd->push_constant_count * sizeof(*out_state->push_constants);
 
-  state.binding_count = cmd->binding_count;
-  state.binding_ptrs = (void**)cmd_ptr;
-  cmd_ptr += cmd->binding_count * sizeof(*state.binding_ptrs);
-  state.binding_lengths = (size_t*)cmd_ptr;
-  cmd_ptr += cmd->binding_count * sizeof(*state.binding_lengths);
+  out_state->binding_count = cmd->binding_count;
+  out_state->binding_ptrs = (void**)cmd_ptr;
+  cmd_ptr += cmd->binding_count * sizeof(*out_state->binding_ptrs);
+  out_state->binding_lengths = (size_t*)cmd_ptr;
+  cmd_ptr += cmd->binding_count * sizeof(*out_state->binding_lengths);
 
   // When we support imports we can populate those here based on what the
   // executable declared (as each executable may import a unique set of
   // functions).
-  state.import_thunk = cmd->executable->import_thunk;
-  state.imports = cmd->executable->imports;
+  out_state->import_thunk = cmd->executable->import_thunk;
+  out_state->imports = cmd->executable->imports;
+}
+
+static iree_status_t iree_hal_cmd_dispatch_tile(
+    uintptr_t user_context, const iree_task_tile_context_t* tile_context,
+    iree_task_submission_t* pending_submission) {
+  const iree_hal_cmd_dispatch_t* cmd =
+      (const iree_hal_cmd_dispatch_t*)user_context;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_executable_dispatch_state_v0_t state;
+  iree_hal_cmd_dispatch_initialize_state(cmd, tile_context->workgroup_count,
+                                         tile_context->workgroup_size, &state);
 
   iree_status_t status = iree_hal_local_executable_issue_call(
       cmd->executable, cmd->ordinal, &state,
@@ -780,10 +1202,72 @@ static iree_status_t iree_hal_cmd_dispatch_tile(
   return status;
 }
 
+// Executes all workgroups of the dispatch serially on the calling worker.
+// Only used for dispatches that require no workgroup local memory.
+static iree_status_t iree_hal_cmd_dispatch_inline(
+    uintptr_t user_context, iree_task_t* task,
+    iree_task_submission_t* pending_submission) {
+  iree_hal_cmd_dispatch_t* cmd = (iree_hal_cmd_dispatch_t*)user_context;
+  // TODO(benvanik): expose on API or keep fixed on executable.
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  iree_hal_executable_dispatch_state_v0_t state;
+  iree_hal_cmd_dispatch_initialize_state(cmd, cmd->workgroup_count,
+                                         workgroup_size, &state);
+  iree_time_t start_time_ns = iree_time_now();
+  iree_status_t status = iree_hal_local_executable_issue_dispatch_inline(
+      cmd->executable, cmd->ordinal, &state, iree_make_byte_span(NULL, 0));
+  if (!iree_status_is_ok(status)) return status;
+
+  // Report the statistics as a dispatch of a single shard would.
+  iree_task_dispatch_statistics_t statistics;
+  memset(&statistics, 0, sizeof(statistics));
+  iree_atomic_store_int64(&statistics.dispatch_count, 1,
+                          iree_memory_order_relaxed);
+  iree_atomic_store_int64(&statistics.duration_ns,
+                          iree_time_now() - start_time_ns,
+                          iree_memory_order_relaxed);
+  iree_atomic_store_int64(&statistics.tile_count,
+                          (int64_t)cmd->workgroup_count[0] *
+                              cmd->workgroup_count[1] *
+                              cmd->workgroup_count[2],
+                          iree_memory_order_relaxed);
+  iree_atomic_store_int64(&statistics.shard_count, 1,
+                          iree_memory_order_relaxed);
+  iree_task_dispatch_statistics_merge(&statistics,
+                                      &task->scope->dispatch_statistics);
+  if (cmd->inline_statistics) {
+    iree_task_dispatch_statistics_merge(&statistics, cmd->inline_statistics);
+    cmd->inline_statistics = NULL;
+  }
+  return iree_ok_status();
+}
+
+// Returns true if a dispatch of |workgroup_count| workgroups each costing
+// |workgroup_cost| (or 0 if unknown) is small enough that fanning it out
+// across the executor would cost more than running it on a single worker.
+static bool iree_hal_task_command_buffer_should_inline_dispatch(
+    iree_hal_task_command_buffer_t* command_buffer,
+    const uint32_t workgroup_count[3], uint32_t local_memory_size,
+    uint32_t workgroup_cost) {
+  // Call tasks have no access to worker local memory.
+  if (local_memory_size > 0) return false;
+  uint64_t total_workgroup_count = (uint64_t)workgroup_count[0] *
+                                   workgroup_count[1] * workgroup_count[2];
+  if (total_workgroup_count == 0) return false;
+  if (total_workgroup_count <=
+      command_buffer->inline_dispatch_max_workgroup_count) {
+    return true;
+  }
+  return workgroup_cost > 0 &&
+         total_workgroup_count * workgroup_cost <=
+             command_buffer->inline_dispatch_max_cost;
+}
+
 static iree_status_t iree_hal_task_command_buffer_build_dispatch(
     iree_hal_command_buffer_t* base_command_buffer,
     iree_hal_executable_t* executable, int32_t entry_point,
     uint32_t workgroup_x, uint32_t workgroup_y, uint32_t workgroup_z,
+    const iree_hal_task_cmd_access_t* indirect_access,
     iree_hal_cmd_dispatch_t** out_cmd) {
   iree_hal_task_command_buffer_t* command_buffer =
       iree_hal_task_command_buffer_cast(base_command_buffer);
@@ -817,22 +1301,70 @@ static iree_status_t iree_hal_task_command_buffer_build_dispatch(
   cmd->push_constant_count = push_constant_count;
   cmd->binding_count = used_binding_count;
 
-  const uint32_t workgroup_count[3] = {workgroup_x, workgroup_y, workgroup_z};
-  // TODO(benvanik): expose on API or keep fixed on executable.
-  const uint32_t workgroup_size[3] = {1, 1, 1};
-  iree_task_dispatch_initialize(command_buffer->scope,
-                                iree_task_make_dispatch_closure(
-                                    iree_hal_cmd_dispatch_tile, (uintptr_t)cmd),
-                                workgroup_size, workgroup_count, &cmd->task);
-
-  // Tell the task system how much workgroup local memory is required for the
-  // dispatch; each invocation of the entry point will have at least as much
-  // scratch memory available during execution.
-  cmd->task.local_memory_size =
+  // Workgroup local memory required by each invocation of the entry point.
+  uint32_t local_memory_size =
       local_executable->dispatch_attrs
           ? local_executable->dispatch_attrs[entry_point].local_memory_pages *
                 IREE_HAL_WORKGROUP_LOCAL_MEMORY_PAGE_SIZE
           : 0;
+  command_buffer->max_local_memory_size =
+      iree_max(command_buffer->max_local_memory_size, local_memory_size);
+
+  // The compiler's estimate of how expensive each workgroup is, if known.
+  uint32_t workgroup_cost =
+      local_executable->dispatch_attrs
+          ? local_executable->dispatch_attrs[entry_point].workgroup_cost *
+                IREE_HAL_WORKGROUP_COST_UNIT
+          : 0;
+
+  const uint32_t workgroup_count[3] = {workgroup_x, workgroup_y, workgroup_z};
+  memcpy(cmd->workgroup_count, workgroup_count, sizeof(cmd->workgroup_count));
+
+  // Reserve profiling storage if a session is active; the dispatch fills it in
+  // the first time it executes.
+  iree_task_dispatch_statistics_t* profile_statistics =
+      iree_hal_task_profiling_context_record_dispatch(
+          command_buffer->profiling_context, executable, entry_point,
+          workgroup_count);
+  cmd->inline_statistics = NULL;
+  if (iree_hal_task_command_buffer_should_inline_dispatch(
+          command_buffer, workgroup_count, local_memory_size,
+          workgroup_cost)) {
+    // Small enough that waking workers and allocating shards would dominate:
+    // run all workgroups as a single call on whichever worker picks it up.
+    iree_task_call_initialize(
+        command_buffer->scope,
+        iree_task_make_call_closure(iree_hal_cmd_dispatch_inline,
+                                    (uintptr_t)cmd),
+        &cmd->task.call);
+    cmd->inline_statistics = profile_statistics;
+  } else {
+    // TODO(benvanik): expose on API or keep fixed on executable.
+    const uint32_t workgroup_size[3] = {1, 1, 1};
+    iree_task_dispatch_initialize(
+        command_buffer->scope,
+        iree_task_make_dispatch_closure(iree_hal_cmd_dispatch_tile,
+                                        (uintptr_t)cmd),
+        workgroup_size, workgroup_count, &cmd->task.dispatch);
+
+    // Tell the task system how much workgroup local memory is required for
+    // the dispatch; each invocation of the entry point will have at least as
+    // much scratch memory available during execution.
+    cmd->task.dispatch.local_memory_size = local_memory_size;
+
+    // Pass along the cost estimate so that the task system can decide how
+    // widely to distribute the dispatch.
+    cmd->task.dispatch.tile_cost_hint = workgroup_cost;
+
+    cmd->task.dispatch.retire_statistics = profile_statistics;
+  }
+
+  // Have the workers executing the dispatch switch to the FPU state required by
+  // the executable; consecutive dispatches with the same requirements share it.
+  if (local_executable->fpu_state_flags &
+      IREE_FPU_STATE_FLAG_FLUSH_DENORMALS_TO_ZERO) {
+    cmd->task.header.flags |= IREE_TASK_FLAG_FLUSH_DENORMALS_TO_ZERO;
+  }
 
   // Copy only the push constant range used by the executable.
   uint8_t* cmd_ptr = (uint8_t*)cmd + sizeof(*cmd);
@@ -853,6 +1385,11 @@ static iree_status_t iree_hal_task_command_buffer_build_dispatch(
   cmd_ptr += used_binding_count * sizeof(*binding_ptrs);
   size_t* binding_lengths = (size_t*)cmd_ptr;
   cmd_ptr += used_binding_count * sizeof(*binding_lengths);
+  // NOTE: used_binding_mask is 64 bits so there is always room for the
+  // bindings and the optional indirect workgroup count.
+  iree_host_size_t access_count = 0;
+  iree_hal_task_cmd_access_t
+      accesses[IREE_HAL_TASK_CMD_MAX_COMMAND_ACCESS_COUNT];
   iree_host_size_t binding_base = 0;
   for (iree_host_size_t i = 0; i < used_binding_count; ++i) {
     int mask_offset = iree_math_count_trailing_zeros_u64(used_binding_mask);
@@ -865,11 +1402,14 @@ static iree_status_t iree_hal_task_command_buffer_build_dispatch(
       return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
                               "(flat) binding %d is NULL", binding_ordinal);
     }
+    accesses[access_count++] =
+        command_buffer->state.binding_accesses[binding_ordinal];
   }
+  if (indirect_access) accesses[access_count++] = *indirect_access;
 
   *out_cmd = cmd;
-  return iree_hal_task_command_buffer_emit_execution_task(command_buffer,
-                                                          &cmd->task.header);
+  return iree_hal_task_command_buffer_emit_execution_task(
+      command_buffer, &cmd->task.header, access_count, accesses);
 }
 
 static iree_status_t iree_hal_task_command_buffer_dispatch(
@@ -879,7 +1419,7 @@ static iree_status_t iree_hal_task_command_buffer_dispatch(
   iree_hal_cmd_dispatch_t* cmd = NULL;
   return iree_hal_task_command_buffer_build_dispatch(
       base_command_buffer, executable, entry_point, workgroup_x, workgroup_y,
-      workgroup_z, &cmd);
+      workgroup_z, /*indirect_access=*/NULL, &cmd);
 }
 
 static iree_status_t iree_hal_task_command_buffer_dispatch_indirect(
@@ -893,10 +1433,21 @@ static iree_status_t iree_hal_task_command_buffer_dispatch_indirect(
       workgroups_buffer, IREE_HAL_MEMORY_ACCESS_READ, workgroups_offset,
       3 * sizeof(uint32_t), &buffer_mapping));
 
+  // The workgroup count is read when the dispatch begins executing and must be
+  // ordered against any prior commands producing it.
+  const iree_hal_task_cmd_access_t indirect_access =
+      iree_hal_task_cmd_make_access(workgroups_buffer, workgroups_offset,
+                                    3 * sizeof(uint32_t),
+                                    IREE_HAL_MEMORY_ACCESS_READ);
+
   iree_hal_cmd_dispatch_t* cmd = NULL;
   IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_build_dispatch(
-      base_command_buffer, executable, entry_point, 0, 0, 0, &cmd));
-  cmd->task.workgroup_count.ptr = (const uint32_t*)buffer_mapping.contents.data;
+      base_command_buffer, executable, entry_point, 0, 0, 0, &indirect_access,
+      &cmd));
+  // NOTE: indirect dispatches are never inlined as their workgroup count is
+  // only known at execution time.
+  cmd->task.dispatch.workgroup_count.ptr =
+      (const uint32_t*)buffer_mapping.contents.data;
   cmd->task.header.flags |= IREE_TASK_FLAG_DISPATCH_INDIRECT;
   return iree_ok_status();
 }
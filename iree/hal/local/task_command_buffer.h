@@ -10,6 +10,7 @@
 #include "iree/base/api.h"
 #include "iree/base/internal/arena.h"
 #include "iree/hal/api.h"
+#include "iree/hal/local/task_profiling.h"
 #include "iree/hal/local/task_queue_state.h"
 #include "iree/task/scope.h"
 #include "iree/task/task.h"
@@ -18,13 +19,32 @@
 extern "C" {
 #endif  // __cplusplus
 
+// Creates a command buffer that records directly into iree/task/ tasks.
+//
+// Dispatches with at most |inline_dispatch_max_workgroup_count| workgroups or
+// a total estimated cost of at most |inline_dispatch_max_cost| are recorded as
+// a single call task that runs all workgroups on one worker instead of being
+// fanned out across the executor. Either may be 0 to disable that threshold.
+//
+// Dispatches recorded while |profiling_context| has an active session will
+// report their statistics to it the first time they execute. May be NULL.
 iree_status_t iree_hal_task_command_buffer_create(
     iree_task_scope_t* scope, iree_hal_command_buffer_mode_t mode,
     iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity,
+    uint32_t inline_dispatch_max_workgroup_count,
+    uint64_t inline_dispatch_max_cost,
+    iree_hal_task_profiling_context_t* profiling_context,
     iree_arena_block_pool_t* block_pool, iree_allocator_t host_allocator,
     iree_hal_command_buffer_t** out_command_buffer);
 
+// Returns the maximum workgroup local memory in bytes required by any dispatch
+// recorded in |command_buffer|. The executor must reserve at least this much
+// local memory per worker (iree_task_executor_reserve_local_memory) prior to
+// the command buffer being issued.
+iree_host_size_t iree_hal_task_command_buffer_local_memory_size(
+    iree_hal_command_buffer_t* command_buffer);
+
 // Issues a recorded command buffer using the serial |queue_state|.
 // |queue_state| is used to track the synchronization scope of the queue from
 // prior commands such as signaled events and will be mutated as events are
@@ -41,11 +61,21 @@ iree_status_t iree_hal_task_command_buffer_create(
 //
 // |pending_submission| will receive the ready list of commands and must be
 // submitted to the executor (or discarded on failure) by the caller.
+//
+// Each successful issue must be balanced by a call to
+// iree_hal_task_command_buffer_retire. Reusable command buffers fail to issue
+// with FAILED_PRECONDITION while a prior issue of them has not yet retired.
 iree_status_t iree_hal_task_command_buffer_issue(
     iree_hal_command_buffer_t* command_buffer,
     iree_hal_task_queue_state_t* queue_state, iree_task_t* retire_task,
     iree_arena_allocator_t* arena, iree_task_submission_t* pending_submission);
 
+// Retires a prior successful issue of |command_buffer| after |retire_task| has
+// been reached (or the submission was discarded). None of the tasks issued may
+// be running when this is called.
+void iree_hal_task_command_buffer_retire(
+    iree_hal_command_buffer_t* command_buffer);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -0,0 +1,205 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/task_command_buffer.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/local/task_device.h"
+#include "iree/task/executor.h"
+#include "iree/task/topology.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+using ::testing::ContainerEq;
+
+constexpr iree_device_size_t kBufferSize = 4096;
+
+// Tests reusable command buffers on a task device. These cover behavior that
+// the CTS cannot require of all drivers: the task DAG of a reusable command
+// buffer is re-armed in place on every issue and overlapping issues of it are
+// rejected.
+class TaskCommandBufferTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    iree_task_topology_t topology;
+    iree_task_topology_initialize_from_group_count(2, &topology);
+    iree_task_executor_options_t options;
+    iree_task_executor_options_initialize(&options);
+    iree_task_executor_t* executor = NULL;
+    IREE_ASSERT_OK(iree_task_executor_create(
+        options, &topology, iree_allocator_system(), &executor));
+    iree_task_topology_deinitialize(&topology);
+
+    iree_hal_task_device_params_t params;
+    iree_hal_task_device_params_initialize(&params);
+    iree_status_t status = iree_hal_task_device_create(
+        iree_make_cstring_view("task"), &params, executor,
+        /*loader_count=*/0, /*loaders=*/NULL, iree_allocator_system(),
+        &device_);
+    iree_task_executor_release(executor);
+    IREE_ASSERT_OK(status);
+
+    IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+        iree_hal_device_allocator(device_),
+        IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+        IREE_HAL_BUFFER_USAGE_ALL, kBufferSize, &source_buffer_));
+    IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+        iree_hal_device_allocator(device_),
+        IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+        IREE_HAL_BUFFER_USAGE_ALL, kBufferSize, &target_buffer_));
+    IREE_ASSERT_OK(iree_hal_semaphore_create(device_, 0ull, &semaphore_));
+  }
+
+  void TearDown() override {
+    iree_hal_semaphore_release(semaphore_);
+    iree_hal_buffer_release(target_buffer_);
+    iree_hal_buffer_release(source_buffer_);
+    iree_hal_device_release(device_);
+  }
+
+  // Records a reusable command buffer that fills |source_buffer_| and then
+  // copies it to |target_buffer_|. The barrier between the two conflicting
+  // commands gives the task DAG a barrier task with dependents.
+  void RecordFillAndCopy(uint8_t value,
+                         iree_hal_command_buffer_t** out_command_buffer) {
+    iree_hal_command_buffer_t* command_buffer = NULL;
+    IREE_ASSERT_OK(iree_hal_command_buffer_create(
+        device_, /*mode=*/0, IREE_HAL_COMMAND_CATEGORY_TRANSFER,
+        IREE_HAL_QUEUE_AFFINITY_ANY, &command_buffer));
+    IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer));
+    IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+        command_buffer, source_buffer_, /*target_offset=*/0,
+        /*length=*/kBufferSize, /*pattern=*/&value,
+        /*pattern_length=*/sizeof(value)));
+    IREE_ASSERT_OK(iree_hal_command_buffer_execution_barrier(
+        command_buffer, IREE_HAL_EXECUTION_STAGE_TRANSFER,
+        IREE_HAL_EXECUTION_STAGE_TRANSFER, IREE_HAL_EXECUTION_BARRIER_FLAG_NONE,
+        /*memory_barrier_count=*/0, /*memory_barriers=*/NULL,
+        /*buffer_barrier_count=*/0, /*buffer_barriers=*/NULL));
+    IREE_ASSERT_OK(iree_hal_command_buffer_copy_buffer(
+        command_buffer, source_buffer_, /*source_offset=*/0, target_buffer_,
+        /*target_offset=*/0, /*length=*/kBufferSize));
+    IREE_ASSERT_OK(iree_hal_command_buffer_end(command_buffer));
+    *out_command_buffer = command_buffer;
+  }
+
+  // Submits |command_buffers| in one batch signaling |semaphore_| to
+  // |signal_value| once |semaphore_| reaches |wait_value| (if non-zero).
+  iree_status_t Submit(std::vector<iree_hal_command_buffer_t*> command_buffers,
+                       uint64_t wait_value, uint64_t signal_value) {
+    iree_hal_submission_batch_t batch;
+    memset(&batch, 0, sizeof(batch));
+    if (wait_value) {
+      batch.wait_semaphores.count = 1;
+      batch.wait_semaphores.semaphores = &semaphore_;
+      batch.wait_semaphores.payload_values = &wait_value;
+    }
+    batch.command_buffer_count = command_buffers.size();
+    batch.command_buffers = command_buffers.data();
+    batch.signal_semaphores.count = 1;
+    batch.signal_semaphores.semaphores = &semaphore_;
+    batch.signal_semaphores.payload_values = &signal_value;
+    return iree_hal_device_queue_submit(
+        device_, IREE_HAL_COMMAND_CATEGORY_TRANSFER,
+        /*queue_affinity=*/0, /*batch_count=*/1, &batch);
+  }
+
+  // Clears both buffers from the host so that each execution is observable.
+  void ClearBuffers() {
+    uint8_t zero = 0;
+    IREE_ASSERT_OK(iree_hal_buffer_fill(source_buffer_, 0, kBufferSize, &zero,
+                                        sizeof(zero)));
+    IREE_ASSERT_OK(iree_hal_buffer_fill(target_buffer_, 0, kBufferSize, &zero,
+                                        sizeof(zero)));
+  }
+
+  std::vector<uint8_t> ReadTarget() {
+    std::vector<uint8_t> data(kBufferSize);
+    IREE_CHECK_OK(iree_hal_buffer_read_data(target_buffer_, 0, data.data(),
+                                            kBufferSize));
+    return data;
+  }
+
+  iree_hal_device_t* device_ = NULL;
+  iree_hal_buffer_t* source_buffer_ = NULL;
+  iree_hal_buffer_t* target_buffer_ = NULL;
+  iree_hal_semaphore_t* semaphore_ = NULL;
+};
+
+// Each resubmission must wait for the prior one to retire, including the
+// dependents of the barrier, before the DAG is re-armed.
+TEST_F(TaskCommandBufferTest, ReplaysBarrierDAG) {
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  ASSERT_NO_FATAL_FAILURE(RecordFillAndCopy(0x5A, &command_buffer));
+  std::vector<uint8_t> reference(kBufferSize, 0x5A);
+  for (uint64_t i = 1; i <= 16; ++i) {
+    ASSERT_NO_FATAL_FAILURE(ClearBuffers());
+    IREE_ASSERT_OK(Submit({command_buffer}, /*wait_value=*/0, i));
+    IREE_ASSERT_OK(
+        iree_hal_semaphore_wait(semaphore_, i, iree_infinite_timeout()));
+    EXPECT_THAT(ReadTarget(), ContainerEq(reference));
+  }
+  iree_hal_command_buffer_release(command_buffer);
+}
+
+// `cmdbuf -> semaphore -> cmdbuf` chains are legal: the second issue happens
+// only after the first has retired.
+TEST_F(TaskCommandBufferTest, ChainedResubmission) {
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  ASSERT_NO_FATAL_FAILURE(RecordFillAndCopy(0x3C, &command_buffer));
+  ASSERT_NO_FATAL_FAILURE(ClearBuffers());
+  IREE_ASSERT_OK(Submit({command_buffer}, /*wait_value=*/1, 2));
+  IREE_ASSERT_OK(Submit({command_buffer}, /*wait_value=*/2, 3));
+  IREE_ASSERT_OK(Submit({command_buffer}, /*wait_value=*/3, 4));
+  IREE_ASSERT_OK(iree_hal_semaphore_signal(semaphore_, 1));
+  IREE_ASSERT_OK(
+      iree_hal_semaphore_wait(semaphore_, 4, iree_infinite_timeout()));
+  EXPECT_THAT(ReadTarget(), ContainerEq(std::vector<uint8_t>(kBufferSize,
+                                                             0x3C)));
+  iree_hal_command_buffer_release(command_buffer);
+}
+
+// The queue retains command buffers until the submission retires so they may
+// be released immediately after submission.
+TEST_F(TaskCommandBufferTest, ReleaseWhilePending) {
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  ASSERT_NO_FATAL_FAILURE(RecordFillAndCopy(0x11, &command_buffer));
+  ASSERT_NO_FATAL_FAILURE(ClearBuffers());
+  IREE_ASSERT_OK(Submit({command_buffer}, /*wait_value=*/1, 2));
+  iree_hal_command_buffer_release(command_buffer);
+  IREE_ASSERT_OK(iree_hal_semaphore_signal(semaphore_, 1));
+  IREE_ASSERT_OK(
+      iree_hal_semaphore_wait(semaphore_, 2, iree_infinite_timeout()));
+  EXPECT_THAT(ReadTarget(), ContainerEq(std::vector<uint8_t>(kBufferSize,
+                                                             0x11)));
+}
+
+// Issuing a reusable command buffer while a prior issue of it is in-flight
+// must fail instead of re-arming tasks that workers may still be running.
+TEST_F(TaskCommandBufferTest, OverlappingIssueFails) {
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  ASSERT_NO_FATAL_FAILURE(RecordFillAndCopy(0x22, &command_buffer));
+  IREE_ASSERT_OK(Submit({command_buffer, command_buffer}, /*wait_value=*/0, 1));
+  iree_status_t status =
+      iree_hal_semaphore_wait(semaphore_, 1, iree_infinite_timeout());
+  EXPECT_FALSE(iree_status_is_ok(status));
+  iree_status_ignore(status);
+  uint64_t value = 0;
+  status = iree_hal_semaphore_query(semaphore_, &value);
+  EXPECT_TRUE(iree_status_is_failed_precondition(status));
+  iree_status_ignore(status);
+  IREE_ASSERT_OK(iree_hal_device_wait_idle(device_, iree_infinite_timeout()));
+  iree_hal_command_buffer_release(command_buffer);
+}
+
+}  // namespace
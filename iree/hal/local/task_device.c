@@ -11,6 +11,8 @@
 #include <string.h>
 
 #include "iree/base/internal/arena.h"
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/cpu.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/local/event_pool.h"
 #include "iree/hal/local/local_descriptor_set.h"
@@ -19,8 +21,11 @@
 #include "iree/hal/local/local_executable_layout.h"
 #include "iree/hal/local/task_command_buffer.h"
 #include "iree/hal/local/task_event.h"
+#include "iree/hal/local/task_profiling.h"
 #include "iree/hal/local/task_queue.h"
 #include "iree/hal/local/task_semaphore.h"
+#include "iree/task/scope.h"
+#include "iree/task/submission.h"
 
 #define IREE_HAL_LOCAL_TASK_EVENT_POOL_CAPACITY 32
 
@@ -46,6 +51,19 @@ typedef struct iree_hal_task_device_t {
   iree_allocator_t host_allocator;
   iree_hal_allocator_t* device_allocator;
 
+  // Thresholds below which dispatches are executed inline on a single worker.
+  uint32_t inline_dispatch_max_workgroup_count;
+  uint64_t inline_dispatch_max_cost;
+
+  // Whether threads waiting on semaphores are donated to the executor.
+  bool donate_caller_on_wait;
+
+  // Flags of the executable caches created by the device.
+  iree_hal_local_executable_cache_flags_t executable_cache_flags;
+
+  // Dispatch profiling context shared by all command buffers of the device.
+  iree_hal_task_profiling_context_t* profiling_context;
+
   iree_host_size_t queue_count;
   iree_hal_task_queue_t queues[];
 } iree_hal_task_device_t;
@@ -62,6 +80,12 @@ void iree_hal_task_device_params_initialize(
     iree_hal_task_device_params_t* out_params) {
   out_params->arena_block_size = 32 * 1024;
   out_params->queue_count = 8;
+  out_params->inline_dispatch_max_workgroup_count = 1;
+  out_params->inline_dispatch_max_cost = 32 * 1024;
+  out_params->donate_caller_on_wait = false;
+  out_params->share_executables = false;
+  out_params->scheduling_weight = IREE_TASK_SCOPE_DEFAULT_WEIGHT;
+  iree_hal_heap_allocator_params_initialize(&out_params->heap_allocator);
 }
 
 static iree_status_t iree_hal_task_device_check_params(
@@ -74,6 +98,10 @@ static iree_status_t iree_hal_task_device_check_params(
     return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
                             "at least one queue is required");
   }
+  if (params->scheduling_weight == 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "scheduling weight must be > 0");
+  }
   return iree_ok_status();
 }
 
@@ -124,18 +152,30 @@ iree_status_t iree_hal_task_device_create(
       iree_hal_executable_loader_retain(device->loaders[i]);
     }
 
+    device->inline_dispatch_max_workgroup_count =
+        params->inline_dispatch_max_workgroup_count;
+    device->inline_dispatch_max_cost = params->inline_dispatch_max_cost;
+    device->donate_caller_on_wait = params->donate_caller_on_wait;
+    device->executable_cache_flags =
+        params->share_executables
+            ? IREE_HAL_LOCAL_EXECUTABLE_CACHE_FLAG_SHARE_EXECUTABLES
+            : IREE_HAL_LOCAL_EXECUTABLE_CACHE_FLAG_NONE;
+
     device->queue_count = params->queue_count;
     for (iree_host_size_t i = 0; i < device->queue_count; ++i) {
       // TODO(benvanik): add a number to each queue ID.
       iree_hal_task_queue_initialize(device->identifier, device->executor,
                                      &device->small_block_pool,
                                      &device->queues[i]);
+      iree_task_scope_set_weight(&device->queues[i].scope,
+                                 params->scheduling_weight);
     }
   }
 
   if (iree_status_is_ok(status)) {
-    status = iree_hal_allocator_create_heap(identifier, host_allocator,
-                                            &device->device_allocator);
+    status = iree_hal_allocator_create_heap_with_params(
+        identifier, &params->heap_allocator, host_allocator,
+        &device->device_allocator);
   }
 
   if (iree_status_is_ok(status)) {
@@ -144,6 +184,11 @@ iree_status_t iree_hal_task_device_create(
         &device->event_pool);
   }
 
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_task_profiling_context_allocate(
+        host_allocator, &device->profiling_context);
+  }
+
   if (iree_status_is_ok(status)) {
     *out_device = (iree_hal_device_t*)device;
   } else {
@@ -166,6 +211,7 @@ static void iree_hal_task_device_destroy(iree_hal_device_t* base_device) {
   }
   iree_task_executor_release(device->executor);
   iree_hal_local_event_pool_free(device->event_pool);
+  iree_hal_task_profiling_context_free(device->profiling_context);
   iree_arena_block_pool_deinitialize(&device->large_block_pool);
   iree_arena_block_pool_deinitialize(&device->small_block_pool);
   iree_hal_allocator_release(device->device_allocator);
@@ -174,6 +220,42 @@ static void iree_hal_task_device_destroy(iree_hal_device_t* base_device) {
   IREE_TRACE_ZONE_END(z0);
 }
 
+iree_task_executor_t* iree_hal_task_device_executor(
+    iree_hal_device_t* base_device) {
+  if (!iree_hal_resource_is(base_device, &iree_hal_task_device_vtable)) {
+    return NULL;
+  }
+  iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
+  return device->executor;
+}
+
+bool iree_hal_task_device_consume_dispatch_statistics(
+    iree_hal_device_t* base_device,
+    iree_task_dispatch_statistics_t* out_statistics) {
+  if (!iree_hal_resource_is(base_device, &iree_hal_task_device_vtable)) {
+    return false;
+  }
+  iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
+  for (iree_host_size_t i = 0; i < device->queue_count; ++i) {
+    iree_task_dispatch_statistics_t queue_statistics =
+        iree_hal_task_queue_consume_statistics(&device->queues[i]);
+    iree_task_dispatch_statistics_merge(&queue_statistics, out_statistics);
+  }
+  return true;
+}
+
+bool iree_hal_task_device_set_deadline(iree_hal_device_t* base_device,
+                                       iree_time_t deadline_ns) {
+  if (!iree_hal_resource_is(base_device, &iree_hal_task_device_vtable)) {
+    return false;
+  }
+  iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
+  for (iree_host_size_t i = 0; i < device->queue_count; ++i) {
+    iree_hal_task_queue_set_deadline(&device->queues[i], deadline_ns);
+  }
+  return true;
+}
+
 static iree_string_view_t iree_hal_task_device_id(
     iree_hal_device_t* base_device) {
   iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
@@ -206,6 +288,11 @@ static iree_status_t iree_hal_task_device_query_i32(
             ? 1
             : 0;
     return iree_ok_status();
+  } else if (iree_string_view_equal(
+                 category, iree_make_cstring_view("hal.device.feature"))) {
+    // Executables run on the host CPU and may require CPU features.
+    *out_value = iree_cpu_supports_features(key) ? 1 : 0;
+    return iree_ok_status();
   }
 
   return iree_make_status(
@@ -238,8 +325,9 @@ static iree_status_t iree_hal_task_device_create_command_buffer(
       device, command_categories, queue_affinity);
   return iree_hal_task_command_buffer_create(
       &device->queues[queue_index].scope, mode, command_categories,
-      queue_affinity, &device->large_block_pool, device->host_allocator,
-      out_command_buffer);
+      queue_affinity, device->inline_dispatch_max_workgroup_count,
+      device->inline_dispatch_max_cost, device->profiling_context,
+      &device->large_block_pool, device->host_allocator, out_command_buffer);
 }
 
 static iree_status_t iree_hal_task_device_create_descriptor_set(
@@ -269,12 +357,125 @@ static iree_status_t iree_hal_task_device_create_event(
                                     out_event);
 }
 
+//===----------------------------------------------------------------------===//
+// iree_hal_inline_parallel_for_t on the task executor
+//===----------------------------------------------------------------------===//
+
+// Used for parallelizing host-side work such as executable preloading across
+// the executor workers. One tile is dispatched per participant and each tile
+// pulls items from a shared counter such that items of uneven cost balance.
+typedef struct iree_hal_task_parallel_for_t {
+  iree_hal_inline_parallel_item_fn_t item_fn;
+  void* user_data;
+  uint32_t item_count;
+  iree_atomic_int32_t next_item;
+} iree_hal_task_parallel_for_t;
+
+static iree_status_t iree_hal_task_parallel_for_tile(
+    uintptr_t user_context, const iree_task_tile_context_t* tile_context,
+    iree_task_submission_t* pending_submission) {
+  iree_hal_task_parallel_for_t* parallel_for =
+      (iree_hal_task_parallel_for_t*)user_context;
+  while (true) {
+    int32_t item_index = iree_atomic_fetch_add_int32(
+        &parallel_for->next_item, 1, iree_memory_order_relaxed);
+    if (item_index >= (int32_t)parallel_for->item_count) break;
+    iree_status_t status =
+        parallel_for->item_fn(parallel_for->user_data,
+                              tile_context->workgroup_xyz[0], item_index);
+    if (!iree_status_is_ok(status)) {
+      // Stop other participants from starting new items.
+      iree_atomic_store_int32(&parallel_for->next_item,
+                              (int32_t)parallel_for->item_count,
+                              iree_memory_order_relaxed);
+      return status;
+    }
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_task_parallel_for_run(
+    void* self, uint32_t item_count, iree_hal_inline_parallel_item_fn_t item_fn,
+    void* user_data) {
+  iree_task_executor_t* executor = (iree_task_executor_t*)self;
+  if (item_count == 0) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, item_count);
+
+  iree_hal_task_parallel_for_t parallel_for = {
+      .item_fn = item_fn,
+      .user_data = user_data,
+      .item_count = item_count,
+  };
+  iree_atomic_store_int32(&parallel_for.next_item, 0,
+                          iree_memory_order_relaxed);
+
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("parallel_for"), &scope);
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  const uint32_t workgroup_count[3] = {
+      (uint32_t)iree_min(item_count,
+                         iree_task_executor_worker_count(executor)),
+      1,
+      1,
+  };
+  iree_task_dispatch_t dispatch_task;
+  iree_task_dispatch_initialize(
+      &scope,
+      iree_task_make_dispatch_closure(iree_hal_task_parallel_for_tile,
+                                      (uintptr_t)&parallel_for),
+      workgroup_size, workgroup_count, &dispatch_task);
+  iree_task_fence_t* fence = NULL;
+  iree_status_t status =
+      iree_task_executor_acquire_fence(executor, &scope, &fence);
+  if (iree_status_is_ok(status)) {
+    iree_task_set_completion_task(&dispatch_task.header, &fence->header);
+    iree_task_submission_t submission;
+    iree_task_submission_initialize(&submission);
+    iree_task_submission_enqueue(&submission, &dispatch_task.header);
+    iree_task_executor_submit(executor, &submission);
+    iree_task_executor_flush(executor);
+    status = iree_task_scope_wait_idle(&scope, IREE_TIME_INFINITE_FUTURE);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_task_scope_consume_status(&scope);
+  }
+  iree_task_scope_deinitialize(&scope);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_task_parallel_for_retain(void* self) {
+  iree_task_executor_retain((iree_task_executor_t*)self);
+}
+
+static void iree_hal_task_parallel_for_release(void* self) {
+  iree_task_executor_release((iree_task_executor_t*)self);
+}
+
+// Returns a parallel-for provider that runs items on the workers of
+// |executor|. The calling thread blocks until all items complete.
+static iree_hal_inline_parallel_for_t iree_hal_task_parallel_for(
+    iree_task_executor_t* executor) {
+  iree_hal_inline_parallel_for_t parallel_for = {
+      .self = executor,
+      .participant_count = iree_task_executor_worker_count(executor),
+      .retain = iree_hal_task_parallel_for_retain,
+      .release = iree_hal_task_parallel_for_release,
+      .run = iree_hal_task_parallel_for_run,
+  };
+  return parallel_for;
+}
+
 static iree_status_t iree_hal_task_device_create_executable_cache(
     iree_hal_device_t* base_device, iree_string_view_t identifier,
     iree_hal_executable_cache_t** out_executable_cache) {
   iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
   return iree_hal_local_executable_cache_create(
       identifier, device->loader_count, device->loaders,
+      iree_hal_task_parallel_for(device->executor),
+      device->executable_cache_flags,
       iree_hal_device_host_allocator(base_device), out_executable_cache);
 }
 
@@ -292,8 +493,10 @@ static iree_status_t iree_hal_task_device_create_semaphore(
     iree_hal_device_t* base_device, uint64_t initial_value,
     iree_hal_semaphore_t** out_semaphore) {
   iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
-  return iree_hal_task_semaphore_create(device->event_pool, initial_value,
-                                        device->host_allocator, out_semaphore);
+  return iree_hal_task_semaphore_create(
+      device->event_pool,
+      device->donate_caller_on_wait ? device->executor : NULL, initial_value,
+      device->host_allocator, out_semaphore);
 }
 
 static iree_status_t iree_hal_task_device_queue_submit(
@@ -345,6 +548,27 @@ static iree_status_t iree_hal_task_device_wait_idle(
   return status;
 }
 
+static iree_status_t iree_hal_task_device_begin_dispatch_profiling(
+    iree_hal_device_t* base_device) {
+  iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
+  return iree_hal_task_profiling_context_begin(device->profiling_context);
+}
+
+static iree_status_t iree_hal_task_device_end_dispatch_profiling(
+    iree_hal_device_t* base_device) {
+  iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
+  iree_hal_task_profiling_context_end(device->profiling_context);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_task_device_flush_dispatch_profiles(
+    iree_hal_device_t* base_device,
+    iree_hal_dispatch_profile_callback_t callback) {
+  iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
+  return iree_hal_task_profiling_context_flush(device->profiling_context,
+                                               callback);
+}
+
 static const iree_hal_device_vtable_t iree_hal_task_device_vtable = {
     .destroy = iree_hal_task_device_destroy,
     .id = iree_hal_task_device_id,
@@ -363,4 +587,7 @@ static const iree_hal_device_vtable_t iree_hal_task_device_vtable = {
     .submit_and_wait = iree_hal_task_device_submit_and_wait,
     .wait_semaphores = iree_hal_task_device_wait_semaphores,
     .wait_idle = iree_hal_task_device_wait_idle,
+    .begin_dispatch_profiling = iree_hal_task_device_begin_dispatch_profiling,
+    .end_dispatch_profiling = iree_hal_task_device_end_dispatch_profiling,
+    .flush_dispatch_profiles = iree_hal_task_device_flush_dispatch_profiles,
 };
@@ -11,6 +11,7 @@
 #include "iree/hal/api.h"
 #include "iree/hal/local/executable_loader.h"
 #include "iree/task/executor.h"
+#include "iree/task/task.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -28,6 +29,38 @@ typedef struct iree_hal_task_device_params_t {
   // Larger sizes will lower overhead and ensure the heap isn't hit for
   // transient allocations while also increasing memory consumption.
   iree_host_size_t arena_block_size;
+
+  // Dispatches with at most this many workgroups are executed inline as a
+  // single task on one worker instead of being fanned out across the executor.
+  // 0 disables inlining based on workgroup count.
+  uint32_t inline_dispatch_max_workgroup_count;
+
+  // Dispatches with a total estimated cost (workgroup count multiplied by the
+  // per-workgroup cost reported by the executable) of at most this many
+  // approximate scalar operations are executed inline as a single task on one
+  // worker. 0 disables inlining based on cost.
+  uint64_t inline_dispatch_max_cost;
+
+  // Donates threads waiting on device semaphores to the device executor so
+  // that they execute pending work instead of blocking until the wait is
+  // satisfied. Only one waiter at a time is donated.
+  bool donate_caller_on_wait;
+
+  // Relative share of the executor workers given to the work of this device
+  // when the executor is shared with other devices that have work ready at the
+  // same time (see iree_task_scope_set_weight). Devices sharing an executor
+  // with weight 2 receive twice the worker time of those with weight 1.
+  uint32_t scheduling_weight;
+
+  // Shares executables prepared by the device with other devices that also
+  // enable sharing when they are prepared from the same executable data (see
+  // IREE_HAL_LOCAL_EXECUTABLE_CACHE_FLAG_SHARE_EXECUTABLES).
+  bool share_executables;
+
+  // Parameters of the heap allocator used for device buffers.
+  // Enabling pooling avoids host allocations for transient buffers allocated
+  // and released on each invocation.
+  iree_hal_heap_allocator_params_t heap_allocator;
 } iree_hal_task_device_params_t;
 
 // Initializes |out_params| to default values.
@@ -43,6 +76,24 @@ iree_status_t iree_hal_task_device_create(
     iree_hal_executable_loader_t** loaders, iree_allocator_t host_allocator,
     iree_hal_device_t** out_device);
 
+// Returns the executor used by |device| for scheduling tasks or NULL if
+// |device| is not an iree/task/-based device. The executor is owned by the
+// device and may be used to query utilization statistics.
+iree_task_executor_t* iree_hal_task_device_executor(iree_hal_device_t* device);
+
+// Merges the statistics of all dispatches that have retired on any queue of
+// |device| since the last call into |out_statistics| and resets them.
+// Returns false and leaves |out_statistics| unmodified if |device| is not an
+// iree/task/-based device.
+bool iree_hal_task_device_consume_dispatch_statistics(
+    iree_hal_device_t* device, iree_task_dispatch_statistics_t* out_statistics);
+
+// Sets the absolute time after which all work pending or in-flight on every
+// queue of |device| is cancelled; see iree_hal_task_queue_set_deadline.
+// Returns false if |device| is not an iree/task/-based device.
+bool iree_hal_task_device_set_deadline(iree_hal_device_t* device,
+                                       iree_time_t deadline_ns);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -0,0 +1,176 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/task_profiling.h"
+
+#include <string.h>
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/local/local_executable.h"
+
+// Maximum number of dispatches that can be profiled in a single session.
+#define IREE_HAL_TASK_PROFILING_RECORD_CAPACITY (4 * 1024)
+
+typedef struct iree_hal_task_profiling_record_t {
+  // Retained until the record is reported or discarded so that the entry point
+  // name remains valid. NULL once reported.
+  iree_hal_executable_t* executable;
+  int32_t entry_point;
+  uint32_t workgroup_count[3];
+  // Populated by the task system when the dispatch retires. The
+  // dispatch_count is merged last with release semantics and once nonzero
+  // indicates the remaining fields are valid.
+  iree_task_dispatch_statistics_t statistics;
+} iree_hal_task_profiling_record_t;
+
+struct iree_hal_task_profiling_context_t {
+  iree_allocator_t host_allocator;
+
+  // Non-zero while a profiling session is active. Checked without the lock so
+  // that recording dispatches outside of a session stays cheap.
+  iree_atomic_int32_t active;
+
+  iree_slim_mutex_t mutex;
+  uint32_t record_count;
+  iree_hal_task_profiling_record_t records[];
+};
+
+static void iree_hal_task_profiling_record_release(
+    iree_hal_task_profiling_record_t* record) {
+  iree_hal_executable_release(record->executable);
+  memset(record, 0, sizeof(*record));
+}
+
+iree_status_t iree_hal_task_profiling_context_allocate(
+    iree_allocator_t host_allocator,
+    iree_hal_task_profiling_context_t** out_profiling_context) {
+  IREE_ASSERT_ARGUMENT(out_profiling_context);
+  *out_profiling_context = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_task_profiling_context_t* profiling_context = NULL;
+  iree_host_size_t total_size =
+      sizeof(*profiling_context) + IREE_HAL_TASK_PROFILING_RECORD_CAPACITY *
+                                       sizeof(profiling_context->records[0]);
+  iree_status_t status = iree_allocator_malloc(host_allocator, total_size,
+                                               (void**)&profiling_context);
+  if (iree_status_is_ok(status)) {
+    memset(profiling_context, 0, total_size);
+    profiling_context->host_allocator = host_allocator;
+    iree_atomic_store_int32(&profiling_context->active, 0,
+                            iree_memory_order_relaxed);
+    iree_slim_mutex_initialize(&profiling_context->mutex);
+    *out_profiling_context = profiling_context;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+void iree_hal_task_profiling_context_free(
+    iree_hal_task_profiling_context_t* profiling_context) {
+  if (!profiling_context) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  for (uint32_t i = 0; i < profiling_context->record_count; ++i) {
+    iree_hal_task_profiling_record_release(&profiling_context->records[i]);
+  }
+  iree_slim_mutex_deinitialize(&profiling_context->mutex);
+  iree_allocator_free(profiling_context->host_allocator, profiling_context);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+iree_status_t iree_hal_task_profiling_context_begin(
+    iree_hal_task_profiling_context_t* profiling_context) {
+  iree_slim_mutex_lock(&profiling_context->mutex);
+  for (uint32_t i = 0; i < profiling_context->record_count; ++i) {
+    iree_hal_task_profiling_record_release(&profiling_context->records[i]);
+  }
+  profiling_context->record_count = 0;
+  iree_atomic_store_int32(&profiling_context->active, 1,
+                          iree_memory_order_release);
+  iree_slim_mutex_unlock(&profiling_context->mutex);
+  return iree_ok_status();
+}
+
+void iree_hal_task_profiling_context_end(
+    iree_hal_task_profiling_context_t* profiling_context) {
+  iree_atomic_store_int32(&profiling_context->active, 0,
+                          iree_memory_order_release);
+}
+
+iree_status_t iree_hal_task_profiling_context_flush(
+    iree_hal_task_profiling_context_t* profiling_context,
+    iree_hal_dispatch_profile_callback_t callback) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_slim_mutex_lock(&profiling_context->mutex);
+
+  iree_status_t status = iree_ok_status();
+  for (uint32_t i = 0;
+       i < profiling_context->record_count && iree_status_is_ok(status); ++i) {
+    iree_hal_task_profiling_record_t* record = &profiling_context->records[i];
+    if (!record->executable) continue;
+    iree_task_dispatch_statistics_t* statistics = &record->statistics;
+    if (!iree_atomic_load_int64(&statistics->dispatch_count,
+                                iree_memory_order_acquire)) {
+      continue;  // not yet retired
+    }
+    iree_hal_dispatch_profile_t profile;
+    memset(&profile, 0, sizeof(profile));
+    profile.entry_point_name = iree_hal_local_executable_entry_point_name(
+        iree_hal_local_executable_cast(record->executable),
+        record->entry_point);
+    profile.entry_point = record->entry_point;
+    memcpy(profile.workgroup_count, record->workgroup_count,
+           sizeof(profile.workgroup_count));
+    profile.duration_ns = (uint64_t)iree_atomic_load_int64(
+        &statistics->duration_ns, iree_memory_order_relaxed);
+    profile.tile_count = (uint64_t)iree_atomic_load_int64(
+        &statistics->tile_count, iree_memory_order_relaxed);
+    profile.shard_count = (uint32_t)iree_atomic_load_int64(
+        &statistics->shard_count, iree_memory_order_relaxed);
+    profile.stolen_shard_count = (uint32_t)iree_atomic_load_int64(
+        &statistics->stolen_shard_count, iree_memory_order_relaxed);
+    status = callback.fn(callback.user_data, &profile);
+    iree_hal_task_profiling_record_release(record);
+  }
+
+  iree_slim_mutex_unlock(&profiling_context->mutex);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+iree_task_dispatch_statistics_t*
+iree_hal_task_profiling_context_record_dispatch(
+    iree_hal_task_profiling_context_t* profiling_context,
+    iree_hal_executable_t* executable, int32_t entry_point,
+    const uint32_t workgroup_count[3]) {
+  if (!profiling_context ||
+      !iree_atomic_load_int32(&profiling_context->active,
+                              iree_memory_order_acquire)) {
+    return NULL;
+  }
+
+  iree_task_dispatch_statistics_t* statistics = NULL;
+  iree_slim_mutex_lock(&profiling_context->mutex);
+  if (profiling_context->record_count <
+      IREE_HAL_TASK_PROFILING_RECORD_CAPACITY) {
+    iree_hal_task_profiling_record_t* record =
+        &profiling_context->records[profiling_context->record_count++];
+    record->executable = executable;
+    iree_hal_executable_retain(executable);
+    record->entry_point = entry_point;
+    memcpy(record->workgroup_count, workgroup_count,
+           sizeof(record->workgroup_count));
+    memset(&record->statistics, 0, sizeof(record->statistics));
+    statistics = &record->statistics;
+  }
+  iree_slim_mutex_unlock(&profiling_context->mutex);
+  return statistics;
+}
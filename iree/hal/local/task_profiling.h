@@ -0,0 +1,72 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_LOCAL_TASK_PROFILING_H_
+#define IREE_HAL_LOCAL_TASK_PROFILING_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/task/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Per-device dispatch profiling context.
+//
+// Each profiled dispatch is assigned a record when it is recorded into a
+// command buffer and the task system fills in the record statistics
+// (wall time, tiles executed, shards stolen, etc) the first time the dispatch
+// retires. Records are allocated linearly during a profiling session and are
+// only reclaimed when the next session begins; once the capacity is exhausted
+// further dispatches are recorded without profiling. Flushing only reports
+// dispatches that have retired.
+//
+// Thread-safe.
+typedef struct iree_hal_task_profiling_context_t
+    iree_hal_task_profiling_context_t;
+
+// Allocates a dispatch profiling context.
+iree_status_t iree_hal_task_profiling_context_allocate(
+    iree_allocator_t host_allocator,
+    iree_hal_task_profiling_context_t** out_profiling_context);
+
+// Frees a profiling context and all associated resources.
+// All profiled dispatches must have retired.
+void iree_hal_task_profiling_context_free(
+    iree_hal_task_profiling_context_t* profiling_context);
+
+// Begins a new profiling session, discarding any unflushed profiles.
+// All dispatches profiled in a prior session must have retired.
+iree_status_t iree_hal_task_profiling_context_begin(
+    iree_hal_task_profiling_context_t* profiling_context);
+
+// Ends the current profiling session, if any.
+void iree_hal_task_profiling_context_end(
+    iree_hal_task_profiling_context_t* profiling_context);
+
+// Reports all retired dispatch profiles to |callback|.
+// |callback| must not call back into the profiling context.
+iree_status_t iree_hal_task_profiling_context_flush(
+    iree_hal_task_profiling_context_t* profiling_context,
+    iree_hal_dispatch_profile_callback_t callback);
+
+// Allocates a record for a dispatch of |entry_point| in |executable| if a
+// session is active and returns the statistics storage the dispatch should
+// merge into when it first retires (iree_task_dispatch_t::retire_statistics).
+// Returns NULL if the dispatch is not being profiled.
+// |profiling_context| may be NULL.
+iree_task_dispatch_statistics_t*
+iree_hal_task_profiling_context_record_dispatch(
+    iree_hal_task_profiling_context_t* profiling_context,
+    iree_hal_executable_t* executable, int32_t entry_point,
+    const uint32_t workgroup_count[3]);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_LOCAL_TASK_PROFILING_H_
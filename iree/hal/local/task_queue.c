@@ -14,14 +14,15 @@
 #include "iree/hal/local/task_semaphore.h"
 #include "iree/task/submission.h"
 
-// Each submission is turned into a DAG for execution:
+// Each submission is turned into a DAG for execution. Consecutive batches in a
+// submission that do not depend on each other are fused and share a DAG:
 //
-//  +--------------------+    To preserve the sequential issue order an edge is
-//  |  (previous issue)  |    added between the previous outstanding issue (if
-//  +--------------------+    it exists) such that all issues run in the order
-//    |                       they were submitted to the queue. Note that this
-//    v                       is *only* the issue; the commands issued by two
-//  +--------------------+    submissions may still overlap and are only
+//  +--------------------+    To preserve the sequential issue order the DAG is
+//  |  (previous issue)  |    held back until the previous outstanding issue (if
+//  +--------------------+    it exists) completes such that all issues run in
+//    |                       the order they were submitted to the queue. Note
+//    v                       this is *only* the issue; the commands issued by
+//  +--------------------+    two submissions may still overlap and are only
 //  |  sequence barrier  |    guaranteed to begin execution in order.
 //  +--------------------+
 //    |
@@ -58,27 +59,51 @@
 // Utilities
 //===----------------------------------------------------------------------===//
 
-// Clones a list of semaphores into an |arena| and initializes |out_target_list|
-// to reference the newly-cloned data.
-static iree_status_t iree_hal_semaphore_list_clone(
-    const iree_hal_semaphore_list_t* source_list, iree_arena_allocator_t* arena,
+// Clones the concatenated wait (or signal if |signal| is set) semaphore lists
+// of all |batches| into an |arena| and initializes |out_target_list| to
+// reference the newly-cloned data. Semaphores appearing multiple times are
+// merged into a single entry with the maximum payload value.
+static iree_status_t iree_hal_semaphore_list_clone_batches(
+    iree_host_size_t batch_count, const iree_hal_submission_batch_t* batches,
+    bool signal, iree_arena_allocator_t* arena,
     iree_hal_semaphore_list_t* out_target_list) {
+  iree_host_size_t max_count = 0;
+  for (iree_host_size_t i = 0; i < batch_count; ++i) {
+    max_count += signal ? batches[i].signal_semaphores.count
+                        : batches[i].wait_semaphores.count;
+  }
   iree_host_size_t semaphores_size =
-      source_list->count * sizeof(out_target_list->semaphores[0]);
+      max_count * sizeof(out_target_list->semaphores[0]);
   iree_host_size_t payload_values_size =
-      source_list->count * sizeof(out_target_list->payload_values[0]);
+      max_count * sizeof(out_target_list->payload_values[0]);
   iree_host_size_t total_size = semaphores_size + payload_values_size;
   uint8_t* buffer = NULL;
   IREE_RETURN_IF_ERROR(iree_arena_allocate(arena, total_size, (void**)&buffer));
 
-  out_target_list->count = source_list->count;
+  out_target_list->count = 0;
   out_target_list->semaphores = (iree_hal_semaphore_t**)buffer;
   out_target_list->payload_values = (uint64_t*)(buffer + semaphores_size);
 
-  for (iree_host_size_t i = 0; i < source_list->count; ++i) {
-    out_target_list->semaphores[i] = source_list->semaphores[i];
-    iree_hal_semaphore_retain(out_target_list->semaphores[i]);
-    out_target_list->payload_values[i] = source_list->payload_values[i];
+  for (iree_host_size_t i = 0; i < batch_count; ++i) {
+    const iree_hal_semaphore_list_t* source_list =
+        signal ? &batches[i].signal_semaphores : &batches[i].wait_semaphores;
+    for (iree_host_size_t j = 0; j < source_list->count; ++j) {
+      iree_hal_semaphore_t* semaphore = source_list->semaphores[j];
+      uint64_t payload_value = source_list->payload_values[j];
+      iree_host_size_t k = 0;
+      for (; k < out_target_list->count; ++k) {
+        if (out_target_list->semaphores[k] == semaphore) break;
+      }
+      if (k < out_target_list->count) {
+        out_target_list->payload_values[k] =
+            iree_max(out_target_list->payload_values[k], payload_value);
+        continue;
+      }
+      out_target_list->semaphores[k] = semaphore;
+      iree_hal_semaphore_retain(semaphore);
+      out_target_list->payload_values[k] = payload_value;
+      ++out_target_list->count;
+    }
   }
 
   return iree_ok_status();
@@ -143,8 +168,9 @@ static void iree_hal_task_queue_wait_cmd_cleanup(iree_task_t* task,
 
 // Allocates and initializes a iree_hal_task_queue_wait_cmd_t task.
 static iree_status_t iree_hal_task_queue_wait_cmd_allocate(
-    iree_task_scope_t* scope, const iree_hal_semaphore_list_t* wait_semaphores,
-    iree_arena_allocator_t* arena, iree_hal_task_queue_wait_cmd_t** out_cmd) {
+    iree_task_scope_t* scope, iree_host_size_t batch_count,
+    const iree_hal_submission_batch_t* batches, iree_arena_allocator_t* arena,
+    iree_hal_task_queue_wait_cmd_t** out_cmd) {
   iree_hal_task_queue_wait_cmd_t* cmd = NULL;
   IREE_RETURN_IF_ERROR(iree_arena_allocate(arena, sizeof(*cmd), (void**)&cmd));
   iree_task_call_initialize(
@@ -154,10 +180,10 @@ static iree_status_t iree_hal_task_queue_wait_cmd_allocate(
                            iree_hal_task_queue_wait_cmd_cleanup);
   cmd->arena = arena;
 
-  // Clone the wait semaphores from the batch - we retain them and their
+  // Clone the wait semaphores from the batches - we retain them and their
   // payloads.
-  IREE_RETURN_IF_ERROR(iree_hal_semaphore_list_clone(wait_semaphores, arena,
-                                                     &cmd->wait_semaphores));
+  IREE_RETURN_IF_ERROR(iree_hal_semaphore_list_clone_batches(
+      batch_count, batches, /*signal=*/false, arena, &cmd->wait_semaphores));
 
   *out_cmd = cmd;
   return iree_ok_status();
@@ -182,7 +208,17 @@ typedef struct iree_hal_task_queue_issue_cmd_t {
   // if we are the last issue pending.
   iree_hal_task_queue_t* queue;
 
-  // Command buffers to be issued in the order the appeared in the submission.
+  // First task of the next submission to the queue. It is held back until
+  // this issue completes so that submissions issue in FIFO order. Guarded by
+  // the queue mutex.
+  iree_task_t* next_head_task;
+
+  // Number of |command_buffers| successfully issued. Each must be retired
+  // when the submission retires.
+  iree_host_size_t issued_count;
+
+  // Retained command buffers to be issued in the order they appeared in the
+  // fused submission batches.
   iree_host_size_t command_buffer_count;
   iree_hal_command_buffer_t* command_buffers[];
 } iree_hal_task_queue_issue_cmd_t;
@@ -200,37 +236,72 @@ static iree_status_t iree_hal_task_queue_issue_cmd(
   // submission was purely for synchronization.
   if (cmd->command_buffer_count > 0) {
     for (iree_host_size_t i = 0; i < cmd->command_buffer_count; ++i) {
+      // Ensure workers have enough local memory for every dispatch in the
+      // command buffer prior to any of them being scheduled. Workers grow
+      // their memory before picking up the dispatches so nothing allocates
+      // while tiles are executing.
+      iree_task_executor_reserve_local_memory(
+          cmd->queue->executor,
+          iree_hal_task_command_buffer_local_memory_size(
+              cmd->command_buffers[i]));
       status = iree_hal_task_command_buffer_issue(
           cmd->command_buffers[i], &cmd->queue->state,
           cmd->task.header.completion_task, cmd->arena, pending_submission);
       if (IREE_UNLIKELY(!iree_status_is_ok(status))) break;
+      ++cmd->issued_count;
     }
   }
 
+  // The executor drops task failures (#4026) so they are reported by failing
+  // the scope; the retire command then fails the signal semaphores.
+  if (IREE_UNLIKELY(!iree_status_is_ok(status))) {
+    iree_task_scope_fail(task->scope, task, status);
+    status = iree_ok_status();
+  }
+
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
 
 // Cleanup for iree_hal_task_queue_issue_cmd_t that resets the queue state
-// tracking the last in-flight issue.
+// tracking the last in-flight issue and submits the next submission if it was
+// held back waiting for this issue to complete.
 static void iree_hal_task_queue_issue_cmd_cleanup(iree_task_t* task,
                                                   iree_status_t status) {
   iree_hal_task_queue_issue_cmd_t* cmd = (iree_hal_task_queue_issue_cmd_t*)task;
+  iree_hal_task_queue_t* queue = cmd->queue;
 
   // Reset queue tail issue task if it was us.
-  iree_slim_mutex_lock(&cmd->queue->mutex);
-  if (cmd->queue->tail_issue_task == task) {
-    cmd->queue->tail_issue_task = NULL;
+  iree_slim_mutex_lock(&queue->mutex);
+  iree_task_t* next_head_task = cmd->next_head_task;
+  cmd->next_head_task = NULL;
+  if (queue->tail_issue_task == task) {
+    queue->tail_issue_task = NULL;
+  }
+  iree_slim_mutex_unlock(&queue->mutex);
+
+  // If this issue failed the executor will discard the next submission when it
+  // observes the failed scope.
+  if (next_head_task) {
+    iree_task_submission_t submission;
+    iree_task_submission_initialize(&submission);
+    iree_task_submission_enqueue(&submission, next_head_task);
+    iree_task_executor_submit(queue->executor, &submission);
   }
-  iree_slim_mutex_unlock(&cmd->queue->mutex);
 }
 
-// Allocates and initializes a iree_hal_task_queue_issue_cmd_t task.
+// Allocates and initializes a iree_hal_task_queue_issue_cmd_t task issuing the
+// command buffers of all |batches| in order.
 static iree_status_t iree_hal_task_queue_issue_cmd_allocate(
     iree_task_scope_t* scope, iree_hal_task_queue_t* queue,
-    iree_task_t* retire_task, iree_host_size_t command_buffer_count,
-    iree_hal_command_buffer_t** const command_buffers,
-    iree_arena_allocator_t* arena, iree_hal_task_queue_issue_cmd_t** out_cmd) {
+    iree_task_t* retire_task, iree_host_size_t batch_count,
+    const iree_hal_submission_batch_t* batches, iree_arena_allocator_t* arena,
+    iree_hal_task_queue_issue_cmd_t** out_cmd) {
+  iree_host_size_t command_buffer_count = 0;
+  for (iree_host_size_t i = 0; i < batch_count; ++i) {
+    command_buffer_count += batches[i].command_buffer_count;
+  }
+
   iree_hal_task_queue_issue_cmd_t* cmd = NULL;
   iree_host_size_t total_cmd_size =
       sizeof(*cmd) + command_buffer_count * sizeof(*cmd->command_buffers);
@@ -244,10 +315,18 @@ static iree_status_t iree_hal_task_queue_issue_cmd_allocate(
                            iree_hal_task_queue_issue_cmd_cleanup);
   cmd->arena = arena;
   cmd->queue = queue;
+  cmd->next_head_task = NULL;
+  cmd->issued_count = 0;
 
-  cmd->command_buffer_count = command_buffer_count;
-  memcpy(cmd->command_buffers, command_buffers,
-         cmd->command_buffer_count * sizeof(*cmd->command_buffers));
+  cmd->command_buffer_count = 0;
+  for (iree_host_size_t i = 0; i < batch_count; ++i) {
+    for (iree_host_size_t j = 0; j < batches[i].command_buffer_count; ++j) {
+      iree_hal_command_buffer_t* command_buffer =
+          batches[i].command_buffers[j];
+      iree_hal_command_buffer_retain(command_buffer);
+      cmd->command_buffers[cmd->command_buffer_count++] = command_buffer;
+    }
+  }
 
   *out_cmd = cmd;
   return iree_ok_status();
@@ -257,13 +336,18 @@ static iree_status_t iree_hal_task_queue_issue_cmd_allocate(
 // iree_hal_task_queue_retire_cmd_t
 //===----------------------------------------------------------------------===//
 
-// Task to retire the submission and free the transient memory allocated for
-// it. The task is issued only once all commands from all command buffers in
-// the submission complete. Semaphores will be signaled and dependent
-// submissions may be issued.
+// Retires the submission and frees the transient memory allocated for it. The
+// command is not a task of its own: it is the signal function of the
+// submission fence and runs inline on whichever worker retires the last
+// command in the submission. Semaphores will be signaled and dependent
+// submissions may be issued without an additional round-trip through the
+// executor. If the submission is discarded (such as when the executor is torn
+// down with work pending) the fence still calls the command with a failure
+// status so that the semaphores are failed and the arena is freed.
 typedef struct iree_hal_task_queue_retire_cmd_t {
-  // Call to iree_hal_task_queue_retire_cmd.
-  iree_task_call_t task;
+  // Fence reached once all commands in the submission have completed.
+  // Allocated from the executor fence pool and not from |arena|.
+  iree_task_fence_t* fence;
 
   // Original arena used for all transient allocations required for the
   // submission. All queue-related commands are allocated from this, **including
@@ -272,47 +356,64 @@ typedef struct iree_hal_task_queue_retire_cmd_t {
 
   // A list of semaphores to signal upon retiring.
   iree_hal_semaphore_list_t signal_semaphores;
+
+  // Issue command of the submission holding the command buffers to retire.
+  // Allocated from |arena| and NULL if the submission failed to build.
+  iree_hal_task_queue_issue_cmd_t* issue_cmd;
 } iree_hal_task_queue_retire_cmd_t;
 
-// Retires a submission by signaling semaphores to their desired value and
-// disposing of the temporary arena memory used for the submission.
-static iree_status_t iree_hal_task_queue_retire_cmd(
-    uintptr_t user_context, iree_task_t* task,
-    iree_task_submission_t* pending_submission) {
+// Retires the command buffers issued by |issue_cmd| and releases all of them.
+static void iree_hal_task_queue_retire_command_buffers(
+    iree_hal_task_queue_issue_cmd_t* issue_cmd) {
+  if (!issue_cmd) return;
+  for (iree_host_size_t i = 0; i < issue_cmd->issued_count; ++i) {
+    iree_hal_task_command_buffer_retire(issue_cmd->command_buffers[i]);
+  }
+  for (iree_host_size_t i = 0; i < issue_cmd->command_buffer_count; ++i) {
+    iree_hal_command_buffer_release(issue_cmd->command_buffers[i]);
+  }
+}
+
+// Retires a submission by signaling semaphores to their desired value (or
+// failing them with |status| if the submission was discarded) and disposing of
+// the temporary arena memory used for the submission.
+static void iree_hal_task_queue_retire_cmd(uintptr_t user_context,
+                                           iree_task_t* task,
+                                           iree_status_t status) {
   iree_hal_task_queue_retire_cmd_t* cmd =
-      (iree_hal_task_queue_retire_cmd_t*)task;
+      (iree_hal_task_queue_retire_cmd_t*)user_context;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // If the queue was cancelled (aborted or its deadline elapsed) then some of
+  // the work in the submission may have been skipped and waiters must not
+  // observe the results as valid.
+  iree_status_code_t cancellation_code =
+      iree_task_scope_cancellation_code(task->scope);
+  if (iree_status_is_ok(status) &&
+      IREE_UNLIKELY(cancellation_code != IREE_STATUS_OK)) {
+    status = iree_make_status(cancellation_code, "queue submission cancelled");
+  }
+
+  // Retire the command buffers before signaling so that waiters observing the
+  // signals may issue reusable command buffers again.
+  iree_hal_task_queue_retire_command_buffers(cmd->issue_cmd);
+
   // Signal all semaphores to their new values.
   // Note that if any signal fails then the whole command will fail and all
-  // semaphores will be signaled to the failure state.
-  iree_status_t status = iree_ok_status();
-  for (iree_host_size_t i = 0; i < cmd->signal_semaphores.count; ++i) {
+  // semaphores will be signaled to the failure state to ensure future
+  // submissions fail as well (including those on other queues).
+  for (iree_host_size_t i = 0;
+       i < cmd->signal_semaphores.count && iree_status_is_ok(status); ++i) {
     status =
         iree_hal_semaphore_signal(cmd->signal_semaphores.semaphores[i],
                                   cmd->signal_semaphores.payload_values[i]);
-    if (IREE_UNLIKELY(!iree_status_is_ok(status))) break;
   }
-
-  IREE_TRACE_ZONE_END(z0);
-  return status;
-}
-
-// Cleanup for iree_hal_task_queue_retire_cmd_t that ensures that the arena
-// holding the submission is properly disposed and that semaphores are signaled
-// (or signaled to failure if the command failed).
-static void iree_hal_task_queue_retire_cmd_cleanup(iree_task_t* task,
-                                                   iree_status_t status) {
-  iree_hal_task_queue_retire_cmd_t* cmd =
-      (iree_hal_task_queue_retire_cmd_t*)task;
-
-  // If the command failed then fail all semaphores to ensure future
-  // submissions fail as well (including those on other queues).
-  if (!iree_status_is_ok(status)) {
+  if (IREE_UNLIKELY(!iree_status_is_ok(status))) {
     for (iree_host_size_t i = 0; i < cmd->signal_semaphores.count; ++i) {
       iree_hal_semaphore_fail(cmd->signal_semaphores.semaphores[i],
                               iree_status_clone(status));
     }
+    iree_status_ignore(status);
   }
 
   // Release all semaphores.
@@ -322,14 +423,16 @@ static void iree_hal_task_queue_retire_cmd_cleanup(iree_task_t* task,
   iree_arena_allocator_t arena = cmd->arena;
   cmd = NULL;
   iree_arena_deinitialize(&arena);
+
+  IREE_TRACE_ZONE_END(z0);
 }
 
-// Allocates and initializes a iree_hal_task_queue_retire_cmd_t task.
-// The command will own an arena that can be used for other submission-related
-// allocations.
+// Allocates and initializes a iree_hal_task_queue_retire_cmd_t attached to a
+// fence acquired from |executor|. The command will own an arena that can be
+// used for other submission-related allocations.
 static iree_status_t iree_hal_task_queue_retire_cmd_allocate(
-    iree_task_scope_t* scope,
-    const iree_hal_semaphore_list_t* signal_semaphores,
+    iree_task_executor_t* executor, iree_task_scope_t* scope,
+    iree_host_size_t batch_count, const iree_hal_submission_batch_t* batches,
     iree_arena_block_pool_t* block_pool,
     iree_hal_task_queue_retire_cmd_t** out_cmd) {
   // Make an arena we'll use for allocating the command itself.
@@ -341,23 +444,30 @@ static iree_status_t iree_hal_task_queue_retire_cmd_allocate(
   iree_status_t status =
       iree_arena_allocate(&arena, sizeof(*cmd), (void**)&cmd);
   if (iree_status_is_ok(status)) {
-    iree_task_call_initialize(
-        scope, iree_task_make_call_closure(iree_hal_task_queue_retire_cmd, 0),
-        &cmd->task);
-    iree_task_set_cleanup_fn(&cmd->task.header,
-                             iree_hal_task_queue_retire_cmd_cleanup);
+    cmd->issue_cmd = NULL;
   }
 
-  // Clone the signal semaphores from the batch - we retain them and their
+  // Clone the signal semaphores from the batches - we retain them and their
   // payloads.
   if (iree_status_is_ok(status)) {
-    status = iree_hal_semaphore_list_clone(signal_semaphores, &arena,
-                                           &cmd->signal_semaphores);
+    status = iree_hal_semaphore_list_clone_batches(
+        batch_count, batches, /*signal=*/true, &arena, &cmd->signal_semaphores);
+  }
+
+  // Acquire the fence last as once acquired the scope is considered busy until
+  // the fence retires.
+  if (iree_status_is_ok(status)) {
+    status = iree_task_executor_acquire_fence(executor, scope, &cmd->fence);
+    if (!iree_status_is_ok(status)) {
+      iree_hal_semaphore_list_release(&cmd->signal_semaphores);
+    }
   }
 
   if (iree_status_is_ok(status)) {
     // Transfer ownership of the arena to command.
     memcpy(&cmd->arena, &arena, sizeof(cmd->arena));
+    iree_task_fence_set_signal_fn(cmd->fence, iree_hal_task_queue_retire_cmd,
+                                  (uintptr_t)cmd);
     *out_cmd = cmd;
   } else {
     iree_arena_deinitialize(&arena);
@@ -365,6 +475,23 @@ static iree_status_t iree_hal_task_queue_retire_cmd_allocate(
   return status;
 }
 
+// Discards a retire command that was never submitted, releasing its fence,
+// semaphores, and arena without signaling.
+static void iree_hal_task_queue_retire_cmd_discard(
+    iree_hal_task_queue_retire_cmd_t* cmd) {
+  // The submission failed to build and the caller reports the error; the
+  // semaphores must not be failed as nothing was submitted.
+  iree_task_fence_set_signal_fn(cmd->fence, NULL, 0);
+  iree_task_list_t discard_worklist;
+  iree_task_list_initialize(&discard_worklist);
+  iree_task_discard(&cmd->fence->header, &discard_worklist);
+  iree_hal_task_queue_retire_command_buffers(cmd->issue_cmd);
+  iree_hal_semaphore_list_release(&cmd->signal_semaphores);
+  iree_arena_allocator_t arena = cmd->arena;
+  cmd = NULL;
+  iree_arena_deinitialize(&arena);
+}
+
 //===----------------------------------------------------------------------===//
 // iree_hal_task_queue_t
 //===----------------------------------------------------------------------===//
@@ -409,97 +536,163 @@ void iree_hal_task_queue_deinitialize(iree_hal_task_queue_t* queue) {
   IREE_TRACE_ZONE_END(z0);
 }
 
-static iree_status_t iree_hal_task_queue_submit_batch(
-    iree_hal_task_queue_t* queue, const iree_hal_submission_batch_t* batch) {
-  // Task to retire the submission and free the transient memory allocated for
-  // it (including the command itself). We allocate this first so it can get an
-  // arena which we will use to allocate all other commands.
+// Returns true if |batch| can be fused into a submission led by |leader|
+// without changing when it may begin. This holds if every wait of |batch| is
+// either covered by a wait of |leader| on the same semaphore to an equal or
+// larger payload or is already satisfied at the time of submission. Fusing any
+// other batch would make the shared wait gate the earlier batches on waits
+// they do not have, which may deadlock if those waits are satisfied by
+// something that is waiting on the signals of the earlier batches.
+static bool iree_hal_task_queue_batch_is_fusable(
+    const iree_hal_submission_batch_t* leader,
+    const iree_hal_submission_batch_t* batch) {
+  for (iree_host_size_t i = 0; i < batch->wait_semaphores.count; ++i) {
+    iree_hal_semaphore_t* semaphore = batch->wait_semaphores.semaphores[i];
+    uint64_t payload_value = batch->wait_semaphores.payload_values[i];
+    bool is_covered = false;
+    for (iree_host_size_t j = 0; j < leader->wait_semaphores.count; ++j) {
+      if (leader->wait_semaphores.semaphores[j] == semaphore &&
+          leader->wait_semaphores.payload_values[j] >= payload_value) {
+        is_covered = true;
+        break;
+      }
+    }
+    if (is_covered) continue;
+    uint64_t current_value = 0;
+    iree_status_t status = iree_hal_semaphore_query(semaphore, &current_value);
+    if (!iree_status_is_ok(status)) {
+      // Failed semaphores are handled by the wait of the batch's own
+      // submission.
+      iree_status_ignore(status);
+      return false;
+    }
+    if (current_value < payload_value) return false;
+  }
+  return true;
+}
+
+// Builds the task DAG for |batch_count| |batches| fused into one submission
+// with a shared wait, issue, and retire. |out_head_task| receives the first
+// task of the DAG to be scheduled and |out_issue_task| the issue task used to
+// order subsequent submissions.
+static iree_status_t iree_hal_task_queue_build_batches(
+    iree_hal_task_queue_t* queue, iree_host_size_t batch_count,
+    const iree_hal_submission_batch_t* batches, iree_task_t** out_head_task,
+    iree_task_t** out_issue_task) {
+  // Retires the submission and frees the transient memory allocated for it
+  // (including the command itself) when the submission fence is reached. We
+  // allocate this first so it can get an arena which we will use to allocate
+  // all other commands.
   iree_hal_task_queue_retire_cmd_t* retire_cmd = NULL;
   IREE_RETURN_IF_ERROR(iree_hal_task_queue_retire_cmd_allocate(
-      &queue->scope, &batch->signal_semaphores, queue->block_pool,
+      queue->executor, &queue->scope, batch_count, batches, queue->block_pool,
       &retire_cmd));
 
-  // NOTE: if we fail from here on we must drop the retire_cmd arena.
+  // NOTE: if we fail from here on we must discard the retire_cmd.
   iree_status_t status = iree_ok_status();
 
-  // A fence we'll use to detect when the entire submission has completed.
-  // TODO(benvanik): fold into the retire command.
-  iree_task_fence_t* fence = NULL;
-  status =
-      iree_task_executor_acquire_fence(queue->executor, &queue->scope, &fence);
-  iree_task_set_completion_task(&retire_cmd->task.header, &fence->header);
-
   // Task to fork and wait for unsatisfied semaphore dependencies.
   // This is optional and only required if we have previous submissions still
   // in-flight - if the queue is empty then we can directly schedule the waits.
+  iree_host_size_t wait_count = 0;
+  for (iree_host_size_t i = 0; i < batch_count; ++i) {
+    wait_count += batches[i].wait_semaphores.count;
+  }
   iree_hal_task_queue_wait_cmd_t* wait_cmd = NULL;
-  if (iree_status_is_ok(status) && batch->wait_semaphores.count > 0) {
+  if (iree_status_is_ok(status) && wait_count > 0) {
     status = iree_hal_task_queue_wait_cmd_allocate(
-        &queue->scope, &batch->wait_semaphores, &retire_cmd->arena, &wait_cmd);
+        &queue->scope, batch_count, batches, &retire_cmd->arena, &wait_cmd);
   }
 
-  // Task to issue all the command buffers in the batch.
+  // Task to issue all the command buffers in the batches.
   // After this task completes the commands have been issued but have not yet
   // completed and the issued commands may complete in any order.
   iree_hal_task_queue_issue_cmd_t* issue_cmd = NULL;
   if (iree_status_is_ok(status)) {
     status = iree_hal_task_queue_issue_cmd_allocate(
-        &queue->scope, queue, &retire_cmd->task.header,
-        batch->command_buffer_count, batch->command_buffers, &retire_cmd->arena,
-        &issue_cmd);
+        &queue->scope, queue, &retire_cmd->fence->header, batch_count, batches,
+        &retire_cmd->arena, &issue_cmd);
+  }
+  if (iree_status_is_ok(status)) {
+    retire_cmd->issue_cmd = issue_cmd;
   }
 
   // Last chance for failure - from here on we are submitting.
   if (IREE_UNLIKELY(!iree_status_is_ok(status))) {
-    iree_arena_deinitialize(&retire_cmd->arena);
+    iree_hal_task_queue_retire_cmd_discard(retire_cmd);
     return status;
   }
 
-  iree_task_submission_t submission;
-  iree_task_submission_initialize(&submission);
-
   // Sequencing: wait on semaphores or go directly into the executor queue.
   if (wait_cmd != NULL) {
     // Ensure that we only issue command buffers after all waits have completed.
     iree_task_set_completion_task(&wait_cmd->task.header,
                                   &issue_cmd->task.header);
-    iree_task_submission_enqueue(&submission, &wait_cmd->task.header);
+    *out_head_task = &wait_cmd->task.header;
   } else {
     // No waits needed; directly enqueue.
-    iree_task_submission_enqueue(&submission, &issue_cmd->task.header);
+    *out_head_task = &issue_cmd->task.header;
   }
-
-  iree_slim_mutex_lock(&queue->mutex);
-
-  // If there is an in-flight issue pending then we need to chain onto that
-  // so that we ensure FIFO submission order is preserved. Note that we are only
-  // waiting for the issue to complete and *not* all of the commands that are
-  // issued.
-  if (queue->tail_issue_task != NULL) {
-    iree_task_set_completion_task(queue->tail_issue_task,
-                                  &issue_cmd->task.header);
-  }
-  queue->tail_issue_task = &issue_cmd->task.header;
-
-  iree_slim_mutex_unlock(&queue->mutex);
-
-  // Submit the tasks immediately. The executor may queue them up until we
-  // force the flush after all batches have been processed.
-  iree_task_executor_submit(queue->executor, &submission);
+  *out_issue_task = &issue_cmd->task.header;
   return iree_ok_status();
 }
 
 static iree_status_t iree_hal_task_queue_submit_batches(
     iree_hal_task_queue_t* queue, iree_host_size_t batch_count,
     const iree_hal_submission_batch_t* batches) {
-  // For now we process each batch independently. To elide additional semaphore
-  // work and prevent unneeded coordinator scheduling logic we could instead
-  // build the whole DAG prior to submitting.
-  for (iree_host_size_t i = 0; i < batch_count; ++i) {
-    const iree_hal_submission_batch_t* batch = &batches[i];
-    IREE_RETURN_IF_ERROR(iree_hal_task_queue_submit_batch(queue, batch));
+  // Back-to-back batches are fused into a single submission with one shared
+  // wait, issue, and retire task to reduce the number of tasks, executor
+  // submissions, and wakes. As the shared wait gates every batch in the
+  // submission a batch is only fused if its waits are implied by those of the
+  // first batch in the submission (see iree_hal_task_queue_batch_is_fusable)
+  // such that no batch begins later than it would have on its own. Signals of
+  // earlier batches are still delayed until all fused batches complete; as
+  // the fused batches have no additional waits they always complete.
+  //
+  // All submissions built here are handed to the executor at once.
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  iree_status_t status = iree_ok_status();
+  iree_host_size_t group_start = 0;
+  while (group_start < batch_count) {
+    iree_host_size_t group_end = group_start + 1;
+    while (group_end < batch_count &&
+           iree_hal_task_queue_batch_is_fusable(&batches[group_start],
+                                                &batches[group_end])) {
+      ++group_end;
+    }
+
+    iree_task_t* head_task = NULL;
+    iree_task_t* issue_task = NULL;
+    status = iree_hal_task_queue_build_batches(
+        queue, group_end - group_start, &batches[group_start], &head_task,
+        &issue_task);
+    if (!iree_status_is_ok(status)) break;
+
+    iree_slim_mutex_lock(&queue->mutex);
+
+    // If there is an in-flight issue pending then we need to hold back the new
+    // submission until it completes so that FIFO submission order is
+    // preserved. Note that we are only waiting for the issue to complete and
+    // *not* all of the commands that are issued.
+    if (queue->tail_issue_task != NULL) {
+      ((iree_hal_task_queue_issue_cmd_t*)queue->tail_issue_task)
+          ->next_head_task = head_task;
+    } else {
+      iree_task_submission_enqueue(&submission, head_task);
+    }
+    queue->tail_issue_task = issue_task;
+
+    iree_slim_mutex_unlock(&queue->mutex);
+
+    group_start = group_end;
   }
-  return iree_ok_status();
+
+  // Submit the tasks immediately (even if a later group failed to build as the
+  // earlier groups are already linked into the queue). The executor may queue
+  // them up until we force the flush after all batches have been processed.
+  iree_task_executor_submit(queue->executor, &submission);
+  return status;
 }
 
 iree_status_t iree_hal_task_queue_submit(
@@ -549,3 +742,13 @@ iree_status_t iree_hal_task_queue_wait_idle(iree_hal_task_queue_t* queue,
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
+
+void iree_hal_task_queue_set_deadline(iree_hal_task_queue_t* queue,
+                                      iree_time_t deadline_ns) {
+  iree_task_scope_set_deadline(&queue->scope, deadline_ns);
+}
+
+iree_task_dispatch_statistics_t iree_hal_task_queue_consume_statistics(
+    iree_hal_task_queue_t* queue) {
+  return iree_task_scope_consume_statistics(&queue->scope);
+}
@@ -46,9 +46,9 @@ typedef struct iree_hal_task_queue_t {
 
   // The last active iree_hal_task_queue_issue_cmd_t submitted to the queue.
   // If this is NULL then there are no issues pending - though there may still
-  // be active work that was previously issued. This is used to chain together
-  // issues in FIFO order such that all submissions *issue* in order but not
-  // *execute* in order.
+  // be active work that was previously issued. The next submission is held
+  // back on this issue until it completes such that all submissions *issue* in
+  // order but not *execute* in order.
   iree_task_t* tail_issue_task;
 } iree_hal_task_queue_t;
 
@@ -72,6 +72,19 @@ iree_status_t iree_hal_task_queue_submit_and_wait(
 iree_status_t iree_hal_task_queue_wait_idle(iree_hal_task_queue_t* queue,
                                             iree_timeout_t timeout);
 
+// Sets the absolute time after which all work pending or in-flight on |queue|
+// is cancelled. Dispatches stop executing tiles at their next shard boundary
+// and the signal semaphores of the affected submissions are failed with
+// IREE_STATUS_DEADLINE_EXCEEDED. Pass IREE_TIME_INFINITE_FUTURE to clear the
+// deadline prior to submitting new work.
+void iree_hal_task_queue_set_deadline(iree_hal_task_queue_t* queue,
+                                      iree_time_t deadline_ns);
+
+// Returns and resets the statistics of all dispatches that have retired on
+// |queue| since the last time they were consumed.
+iree_task_dispatch_statistics_t iree_hal_task_queue_consume_statistics(
+    iree_hal_task_queue_t* queue);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -11,6 +11,7 @@
 #include <stddef.h>
 #include <string.h>
 
+#include "iree/base/internal/atomics.h"
 #include "iree/base/internal/synchronization.h"
 #include "iree/base/internal/wait_handle.h"
 #include "iree/base/tracing.h"
@@ -18,6 +19,20 @@
 // Sentinel used the semaphore has failed and an error status is set.
 #define IREE_HAL_TASK_SEMAPHORE_FAILURE_VALUE UINT64_MAX
 
+// Duration in nanoseconds a waiter spins on the semaphore values before
+// acquiring timepoints and waiting on their events. Work on local devices
+// frequently completes within microseconds of the wait starting and spinning
+// avoids the event syscalls and context switches on both the signaling and
+// waiting threads. 0 disables spinning.
+#if !defined(IREE_HAL_TASK_SEMAPHORE_SPIN_NS)
+#define IREE_HAL_TASK_SEMAPHORE_SPIN_NS (50 * 1000)
+#endif  // !IREE_HAL_TASK_SEMAPHORE_SPIN_NS
+
+// Maximum number of processor pause instructions issued between each check of
+// the semaphore values while spinning. The count starts at 1 and doubles each
+// check until this limit to stay off the semaphore cache lines.
+#define IREE_HAL_TASK_SEMAPHORE_MAX_SPIN_PAUSE_COUNT 64
+
 //===----------------------------------------------------------------------===//
 // iree_hal_task_timepoint_t
 //===----------------------------------------------------------------------===//
@@ -34,6 +49,9 @@ typedef struct iree_hal_task_timepoint_t {
   struct iree_hal_task_timepoint_t* prev;
   uint64_t payload_value;
   iree_event_t event;
+  // True while the timepoint is in the semaphore timepoint list. Cleared under
+  // the semaphore lock when a signal takes the timepoint for notification.
+  bool is_pending;
 } iree_hal_task_timepoint_t;
 
 // A doubly-linked FIFO list of timepoints.
@@ -104,6 +122,7 @@ static void iree_hal_task_timepoint_list_take_ready(
 
     // Remove from pending list.
     iree_hal_task_timepoint_list_erase(pending_list, timepoint);
+    timepoint->is_pending = false;
 
     // Add to ready list.
     iree_hal_task_timepoint_list_append(out_ready_list, timepoint);
@@ -135,6 +154,10 @@ typedef struct iree_hal_task_semaphore_t {
   iree_allocator_t host_allocator;
   iree_hal_local_event_pool_t* event_pool;
 
+  // Optional executor that waiting threads are donated to; NULL if waiters
+  // should just block.
+  iree_task_executor_t* executor;
+
   // Guards all mutable fields. We expect low contention on semaphores and since
   // iree_slim_mutex_t is (effectively) just a CAS this keeps things simpler
   // than trying to make the entire structure lock-free.
@@ -142,8 +165,9 @@ typedef struct iree_hal_task_semaphore_t {
 
   // Current signaled value. May be IREE_HAL_TASK_SEMAPHORE_FAILURE_VALUE to
   // indicate that the semaphore has been signaled for failure and
-  // |failure_status| contains the error.
-  uint64_t current_value;
+  // |failure_status| contains the error. Only modified with the mutex held but
+  // may be loaded without it by waiters spinning on the value.
+  iree_atomic_int64_t current_value;
 
   // OK or the status passed to iree_hal_semaphore_fail. Owned by the semaphore.
   iree_status_t failure_status;
@@ -166,9 +190,23 @@ static iree_hal_task_semaphore_t* iree_hal_task_semaphore_cast(
   return (iree_hal_task_semaphore_t*)base_value;
 }
 
+static inline uint64_t iree_hal_task_semaphore_load_value(
+    iree_hal_task_semaphore_t* semaphore) {
+  return (uint64_t)iree_atomic_load_int64(&semaphore->current_value,
+                                          iree_memory_order_acquire);
+}
+
+// Stores |new_value| as the current value. The semaphore mutex must be held.
+static inline void iree_hal_task_semaphore_store_value_unsafe(
+    iree_hal_task_semaphore_t* semaphore, uint64_t new_value) {
+  iree_atomic_store_int64(&semaphore->current_value, (int64_t)new_value,
+                          iree_memory_order_release);
+}
+
 iree_status_t iree_hal_task_semaphore_create(
-    iree_hal_local_event_pool_t* event_pool, uint64_t initial_value,
-    iree_allocator_t host_allocator, iree_hal_semaphore_t** out_semaphore) {
+    iree_hal_local_event_pool_t* event_pool, iree_task_executor_t* executor,
+    uint64_t initial_value, iree_allocator_t host_allocator,
+    iree_hal_semaphore_t** out_semaphore) {
   IREE_ASSERT_ARGUMENT(event_pool);
   IREE_ASSERT_ARGUMENT(out_semaphore);
   *out_semaphore = NULL;
@@ -182,9 +220,12 @@ iree_status_t iree_hal_task_semaphore_create(
                                  &semaphore->resource);
     semaphore->host_allocator = host_allocator;
     semaphore->event_pool = event_pool;
+    semaphore->executor = executor;
+    iree_task_executor_retain(semaphore->executor);
 
     iree_slim_mutex_initialize(&semaphore->mutex);
-    semaphore->current_value = initial_value;
+    iree_atomic_store_int64(&semaphore->current_value, (int64_t)initial_value,
+                            iree_memory_order_relaxed);
     semaphore->failure_status = iree_ok_status();
     iree_notification_initialize(&semaphore->notification);
     iree_hal_task_timepoint_list_initialize(&semaphore->timepoint_list);
@@ -206,6 +247,7 @@ static void iree_hal_task_semaphore_destroy(
   iree_status_free(semaphore->failure_status);
   iree_notification_deinitialize(&semaphore->notification);
   iree_slim_mutex_deinitialize(&semaphore->mutex);
+  iree_task_executor_release(semaphore->executor);
   iree_allocator_free(host_allocator, semaphore);
 
   IREE_TRACE_ZONE_END(z0);
@@ -218,7 +260,7 @@ static iree_status_t iree_hal_task_semaphore_query(
 
   iree_slim_mutex_lock(&semaphore->mutex);
 
-  *out_value = semaphore->current_value;
+  *out_value = iree_hal_task_semaphore_load_value(semaphore);
 
   iree_status_t status = iree_ok_status();
   if (*out_value >= IREE_HAL_TASK_SEMAPHORE_FAILURE_VALUE) {
@@ -237,8 +279,8 @@ static iree_status_t iree_hal_task_semaphore_signal(
 
   iree_slim_mutex_lock(&semaphore->mutex);
 
-  if (new_value <= semaphore->current_value) {
-    uint64_t current_value = semaphore->current_value;
+  uint64_t current_value = iree_hal_task_semaphore_load_value(semaphore);
+  if (new_value <= current_value) {
     iree_slim_mutex_unlock(&semaphore->mutex);
     return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
                             "semaphore values must be monotonically "
@@ -247,7 +289,7 @@ static iree_status_t iree_hal_task_semaphore_signal(
                             current_value, new_value);
   }
 
-  semaphore->current_value = new_value;
+  iree_hal_task_semaphore_store_value_unsafe(semaphore, new_value);
 
   // Scan for all timepoints that are now satisfied and move them to our local
   // ready list. This way we can notify them without needing to continue holding
@@ -282,7 +324,8 @@ static void iree_hal_task_semaphore_fail(iree_hal_semaphore_t* base_semaphore,
   }
 
   // Signal to our failure sentinel value.
-  semaphore->current_value = IREE_HAL_TASK_SEMAPHORE_FAILURE_VALUE;
+  iree_hal_task_semaphore_store_value_unsafe(
+      semaphore, IREE_HAL_TASK_SEMAPHORE_FAILURE_VALUE);
   semaphore->failure_status = status;
 
   // Take the whole timepoint list as we'll be signaling all of them. Since
@@ -290,6 +333,10 @@ static void iree_hal_task_semaphore_fail(iree_hal_semaphore_t* base_semaphore,
   // up.
   iree_hal_task_timepoint_list_t ready_list;
   iree_hal_task_timepoint_list_move(&semaphore->timepoint_list, &ready_list);
+  for (iree_hal_task_timepoint_t* timepoint = ready_list.head;
+       timepoint != NULL; timepoint = timepoint->next) {
+    timepoint->is_pending = false;
+  }
 
   iree_notification_post(&semaphore->notification, IREE_ALL_WAITERS);
   iree_slim_mutex_unlock(&semaphore->mutex);
@@ -310,9 +357,79 @@ static iree_status_t iree_hal_task_semaphore_acquire_timepoint(
       semaphore->event_pool, 1, &out_timepoint->event));
   iree_hal_task_timepoint_list_append(&semaphore->timepoint_list,
                                       out_timepoint);
+  out_timepoint->is_pending = true;
   return iree_ok_status();
 }
 
+// Cancels a |timepoint| acquired from |semaphore| so that its storage and event
+// can be released. If a signal has already taken the timepoint for
+// notification this waits for the (imminent) notification so that the
+// signaling thread is done with the timepoint.
+static void iree_hal_task_semaphore_cancel_timepoint(
+    iree_hal_task_semaphore_t* semaphore,
+    iree_hal_task_timepoint_t* timepoint) {
+  iree_slim_mutex_lock(&semaphore->mutex);
+  bool is_pending = timepoint->is_pending;
+  if (is_pending) {
+    iree_hal_task_timepoint_list_erase(&semaphore->timepoint_list, timepoint);
+    timepoint->is_pending = false;
+  }
+  iree_slim_mutex_unlock(&semaphore->mutex);
+  if (!is_pending) {
+    iree_status_ignore(
+        iree_wait_one(&timepoint->event, IREE_TIME_INFINITE_FUTURE));
+  }
+}
+
+// Returns true if the semaphores in |semaphore_list| have reached their
+// payload values (or failed) as required by |wait_mode|.
+static bool iree_hal_task_semaphore_list_is_signaled(
+    iree_hal_wait_mode_t wait_mode,
+    const iree_hal_semaphore_list_t* semaphore_list) {
+  for (iree_host_size_t i = 0; i < semaphore_list->count; ++i) {
+    iree_hal_task_semaphore_t* semaphore =
+        (iree_hal_task_semaphore_t*)semaphore_list->semaphores[i];
+    // NOTE: the failure value is UINT64_MAX and satisfies every payload value.
+    bool is_signaled = iree_hal_task_semaphore_load_value(semaphore) >=
+                       semaphore_list->payload_values[i];
+    if (wait_mode == IREE_HAL_WAIT_MODE_ANY && is_signaled) return true;
+    if (wait_mode == IREE_HAL_WAIT_MODE_ALL && !is_signaled) return false;
+  }
+  return wait_mode == IREE_HAL_WAIT_MODE_ALL;
+}
+
+// Spins with exponential backoff until the semaphores in |semaphore_list| are
+// signaled as required by |wait_mode|, IREE_HAL_TASK_SEMAPHORE_SPIN_NS has
+// elapsed, or |deadline_ns| is reached. Returns true if signaled.
+//
+// Only the semaphore values are loaded while spinning; no locks are taken and
+// no events are acquired so this is cheap for both waiter and signaler.
+static bool iree_hal_task_semaphore_spin_wait(
+    iree_hal_wait_mode_t wait_mode,
+    const iree_hal_semaphore_list_t* semaphore_list, iree_time_t deadline_ns) {
+  if (IREE_HAL_TASK_SEMAPHORE_SPIN_NS <= 0) return false;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_time_t spin_deadline_ns =
+      iree_time_now() + IREE_HAL_TASK_SEMAPHORE_SPIN_NS;
+  if (spin_deadline_ns > deadline_ns) spin_deadline_ns = deadline_ns;
+  uint32_t pause_count = 1;
+  bool is_signaled = false;
+  do {
+    if (iree_hal_task_semaphore_list_is_signaled(wait_mode, semaphore_list)) {
+      is_signaled = true;
+      break;
+    }
+    for (uint32_t i = 0; i < pause_count; ++i) {
+      iree_processor_pause();
+    }
+    if (pause_count < IREE_HAL_TASK_SEMAPHORE_MAX_SPIN_PAUSE_COUNT) {
+      pause_count <<= 1;
+    }
+  } while (iree_time_now() < spin_deadline_ns);
+  IREE_TRACE_ZONE_END(z0);
+  return is_signaled;
+}
+
 typedef struct iree_hal_task_semaphore_wait_cmd_t {
   iree_task_wait_t task;
   iree_hal_task_semaphore_t* semaphore;
@@ -347,7 +464,7 @@ iree_status_t iree_hal_task_semaphore_enqueue_timepoint(
   iree_slim_mutex_lock(&semaphore->mutex);
 
   iree_status_t status = iree_ok_status();
-  if (semaphore->current_value >= minimum_value) {
+  if (iree_hal_task_semaphore_load_value(semaphore) >= minimum_value) {
     // Fast path: already satisfied.
   } else {
     // Slow path: acquire a system wait handle and perform a full wait.
@@ -384,7 +501,7 @@ static iree_status_t iree_hal_task_semaphore_wait(
     // Fastest path: failed; return an error to tell callers to query for it.
     iree_slim_mutex_unlock(&semaphore->mutex);
     return iree_status_from_code(IREE_STATUS_ABORTED);
-  } else if (semaphore->current_value >= value) {
+  } else if (iree_hal_task_semaphore_load_value(semaphore) >= value) {
     // Fast path: already satisfied.
     iree_slim_mutex_unlock(&semaphore->mutex);
     return iree_ok_status();
@@ -393,9 +510,29 @@ static iree_status_t iree_hal_task_semaphore_wait(
     iree_slim_mutex_unlock(&semaphore->mutex);
     return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
   }
+  iree_slim_mutex_unlock(&semaphore->mutex);
 
   iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
 
+  // Spin path: the value may be reached shortly; spin on it before paying for
+  // a timepoint event and its syscalls.
+  iree_hal_semaphore_list_t semaphore_list = {
+      .count = 1,
+      .semaphores = &base_semaphore,
+      .payload_values = &value,
+  };
+  iree_hal_task_semaphore_spin_wait(IREE_HAL_WAIT_MODE_ALL, &semaphore_list,
+                                    deadline_ns);
+
+  iree_slim_mutex_lock(&semaphore->mutex);
+  if (!iree_status_is_ok(semaphore->failure_status)) {
+    iree_slim_mutex_unlock(&semaphore->mutex);
+    return iree_status_from_code(IREE_STATUS_ABORTED);
+  } else if (iree_hal_task_semaphore_load_value(semaphore) >= value) {
+    iree_slim_mutex_unlock(&semaphore->mutex);
+    return iree_ok_status();
+  }
+
   // Slow path: acquire a timepoint while we hold the lock.
   iree_hal_task_timepoint_t timepoint;
   iree_status_t status =
@@ -404,16 +541,29 @@ static iree_status_t iree_hal_task_semaphore_wait(
   iree_slim_mutex_unlock(&semaphore->mutex);
   if (IREE_UNLIKELY(!iree_status_is_ok(status))) return status;
 
-  // Wait until the timepoint resolves.
+  // Wait until the timepoint resolves, executing work on behalf of the
+  // executor in the meantime if donation is enabled.
   // If satisfied the timepoint is automatically cleaned up and we are done. If
   // the deadline is reached before satisfied then we have to clean it up.
-  status = iree_wait_one(&timepoint.event, deadline_ns);
+  if (semaphore->executor) {
+    status = iree_task_executor_donate_caller(semaphore->executor,
+                                              &timepoint.event, deadline_ns);
+  } else {
+    status = iree_wait_one(&timepoint.event, deadline_ns);
+  }
   if (!iree_status_is_ok(status)) {
+    iree_hal_task_semaphore_cancel_timepoint(semaphore, &timepoint);
+  }
+  iree_hal_local_event_pool_release(semaphore->event_pool, 1, &timepoint.event);
+
+  // Timepoints are also resolved when the semaphore fails.
+  if (iree_status_is_ok(status)) {
     iree_slim_mutex_lock(&semaphore->mutex);
-    iree_hal_task_timepoint_list_erase(&semaphore->timepoint_list, &timepoint);
+    if (!iree_status_is_ok(semaphore->failure_status)) {
+      status = iree_status_from_code(IREE_STATUS_ABORTED);
+    }
     iree_slim_mutex_unlock(&semaphore->mutex);
   }
-  iree_hal_local_event_pool_release(semaphore->event_pool, 1, &timepoint.event);
   return status;
 }
 
@@ -435,6 +585,19 @@ iree_status_t iree_hal_task_semaphore_multi_wait(
 
   iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
 
+  // Fast-path for already satisfied (or polling) and spin-path for values that
+  // are reached shortly. Neither touches the semaphore locks.
+  if (iree_hal_task_semaphore_list_is_signaled(wait_mode, semaphore_list) ||
+      (!iree_timeout_is_immediate(timeout) &&
+       iree_hal_task_semaphore_spin_wait(wait_mode, semaphore_list,
+                                         deadline_ns))) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_ok_status();
+  } else if (iree_timeout_is_immediate(timeout)) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+  }
+
   // Avoid heap allocations by using the device block pool for the wait set.
   iree_arena_allocator_t arena;
   iree_arena_initialize(block_pool, &arena);
@@ -448,49 +611,69 @@ iree_status_t iree_hal_task_semaphore_multi_wait(
   // call.
   iree_host_size_t timepoint_count = 0;
   iree_hal_task_timepoint_t* timepoints = NULL;
+  iree_host_size_t* timepoint_semaphore_indices = NULL;
   iree_host_size_t total_timepoint_size =
-      semaphore_list->count * sizeof(timepoints[0]);
-  status =
-      iree_arena_allocate(&arena, total_timepoint_size, (void**)&timepoints);
+      semaphore_list->count *
+      (sizeof(timepoints[0]) + sizeof(timepoint_semaphore_indices[0]));
+  bool any_signaled = false;
+  if (iree_status_is_ok(status)) {
+    status =
+        iree_arena_allocate(&arena, total_timepoint_size, (void**)&timepoints);
+  }
   if (iree_status_is_ok(status)) {
     memset(timepoints, 0, total_timepoint_size);
+    timepoint_semaphore_indices =
+        (iree_host_size_t*)(timepoints + semaphore_list->count);
     for (iree_host_size_t i = 0; i < semaphore_list->count; ++i) {
       iree_hal_task_semaphore_t* semaphore =
           iree_hal_task_semaphore_cast(semaphore_list->semaphores[i]);
       iree_slim_mutex_lock(&semaphore->mutex);
-      if (semaphore->current_value >= semaphore_list->payload_values[i]) {
-        // Fast path: already satisfied.
+      if (iree_hal_task_semaphore_load_value(semaphore) >=
+          semaphore_list->payload_values[i]) {
+        // Fast path: already satisfied. Wait-any is done.
+        any_signaled = true;
       } else {
         // Slow path: get a native wait handle for the timepoint.
-        iree_hal_task_timepoint_t* timepoint = &timepoints[timepoint_count++];
+        iree_hal_task_timepoint_t* timepoint = &timepoints[timepoint_count];
         status = iree_hal_task_semaphore_acquire_timepoint(
             semaphore, semaphore_list->payload_values[i], timepoint);
         if (iree_status_is_ok(status)) {
+          timepoint_semaphore_indices[timepoint_count++] = i;
           status = iree_wait_set_insert(wait_set, timepoint->event);
         }
       }
       iree_slim_mutex_unlock(&semaphore->mutex);
       if (!iree_status_is_ok(status)) break;
+      if (any_signaled && wait_mode == IREE_HAL_WAIT_MODE_ANY) break;
     }
   }
 
   // Perform the wait.
   if (iree_status_is_ok(status)) {
     if (wait_mode == IREE_HAL_WAIT_MODE_ANY) {
-      status = iree_wait_any(wait_set, deadline_ns, /*out_wake_handle=*/NULL);
+      if (!any_signaled) {
+        iree_wait_handle_t wake_handle;
+        status = iree_wait_any(wait_set, deadline_ns, &wake_handle);
+      }
     } else {
       status = iree_wait_all(wait_set, deadline_ns);
     }
   }
 
   if (timepoints != NULL) {
+    // Unresolved timepoints must be removed from their semaphores before the
+    // events are returned to the pool and the arena storage is released.
     // TODO(benvanik): if we flip the API to multi-acquire events from the pool
     // above then we can multi-release here too.
     for (iree_host_size_t i = 0; i < timepoint_count; ++i) {
+      iree_hal_task_semaphore_cancel_timepoint(
+          (iree_hal_task_semaphore_t*)semaphore_list
+              ->semaphores[timepoint_semaphore_indices[i]],
+          &timepoints[i]);
       iree_hal_local_event_pool_release(event_pool, 1, &timepoints[i].event);
     }
   }
-  iree_wait_set_free(wait_set);
+  if (wait_set != NULL) iree_wait_set_free(wait_set);
   iree_arena_deinitialize(&arena);
 
   IREE_TRACE_ZONE_END(z0);
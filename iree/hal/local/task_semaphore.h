@@ -13,6 +13,7 @@
 #include "iree/base/internal/arena.h"
 #include "iree/hal/api.h"
 #include "iree/hal/local/event_pool.h"
+#include "iree/task/executor.h"
 #include "iree/task/submission.h"
 #include "iree/task/task.h"
 
@@ -22,9 +23,14 @@ extern "C" {
 
 // Creates a semaphore that integrates with the task system to allow for
 // pipelined wait and signal operations.
+//
+// If |executor| is provided then threads waiting on the semaphore will be
+// donated to the executor to perform work until the wait is satisfied (see
+// iree_task_executor_donate_caller). The executor is retained by the semaphore.
 iree_status_t iree_hal_task_semaphore_create(
-    iree_hal_local_event_pool_t* event_pool, uint64_t initial_value,
-    iree_allocator_t host_allocator, iree_hal_semaphore_t** out_semaphore);
+    iree_hal_local_event_pool_t* event_pool, iree_task_executor_t* executor,
+    uint64_t initial_value, iree_allocator_t host_allocator,
+    iree_hal_semaphore_t** out_semaphore);
 
 // Reserves a new timepoint in the timeline for the given minimum payload value.
 // |issue_task| will wait until the timeline semaphore is signaled to at least
@@ -0,0 +1,66 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// See iree/base/api.h for documentation on the API conventions used.
+
+#ifndef IREE_HAL_METAL_API_H_
+#define IREE_HAL_METAL_API_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Parameters configuring an iree_hal_metal_device_t.
+// Must be initialized with iree_hal_metal_device_params_initialize prior to
+// use.
+typedef struct iree_hal_metal_device_params_t {
+  // Total size of each block in the device shared block pool used by
+  // reusable command buffers, which are recorded on the host and replayed
+  // into a new MTLCommandBuffer on each submission.
+  iree_host_size_t arena_block_size;
+
+  // Allocates all buffers with MTLStorageModeShared when the device has
+  // unified memory with the host (Apple Silicon and iOS) so that mapping a
+  // device-local buffer is zero-copy. Device-local buffers use
+  // MTLStorageModePrivate otherwise.
+  bool use_shared_storage_when_unified;
+} iree_hal_metal_device_params_t;
+
+// Initializes |out_params| to default values.
+IREE_API_EXPORT void iree_hal_metal_device_params_initialize(
+    iree_hal_metal_device_params_t* out_params);
+
+//===----------------------------------------------------------------------===//
+// iree_hal_metal_driver_t
+//===----------------------------------------------------------------------===//
+
+// Metal driver creation options.
+typedef struct iree_hal_metal_driver_options_t {
+  // Index of the default Metal device to use within the list of available
+  // devices. The system default device is used if the index is out of range.
+  int default_device_index;
+} iree_hal_metal_driver_options_t;
+
+IREE_API_EXPORT void iree_hal_metal_driver_options_initialize(
+    iree_hal_metal_driver_options_t* out_options);
+
+// Creates a Metal HAL driver.
+//
+// |out_driver| must be released by the caller (see |iree_hal_driver_release|).
+IREE_API_EXPORT iree_status_t iree_hal_metal_driver_create(
+    iree_string_view_t identifier,
+    const iree_hal_metal_device_params_t* default_params,
+    const iree_hal_metal_driver_options_t* options,
+    iree_allocator_t host_allocator, iree_hal_driver_t** out_driver);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_METAL_API_H_
@@ -0,0 +1,43 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_METAL_DIRECT_COMMAND_BUFFER_H_
+#define IREE_HAL_METAL_DIRECT_COMMAND_BUFFER_H_
+
+#import <Metal/Metal.h>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Creates a command buffer that directly encodes commands into a new
+// MTLCommandBuffer from |queue| as they are recorded. The MTLCommandBuffer
+// can only be committed once and so the command buffer is one-shot.
+//
+// The MTLCommandBuffer does not retain the resources it references; as with
+// all HAL command buffers they must remain live until execution completes.
+iree_status_t iree_hal_metal_direct_command_buffer_create(
+    id<MTLCommandQueue> queue, iree_hal_command_buffer_mode_t mode,
+    iree_hal_command_category_t command_categories,
+    iree_allocator_t host_allocator,
+    iree_hal_command_buffer_t** out_command_buffer);
+
+// Returns true if |command_buffer| is a Metal direct command buffer.
+bool iree_hal_metal_direct_command_buffer_isa(
+    iree_hal_command_buffer_t* command_buffer);
+
+// Returns the MTLCommandBuffer commands have been encoded into.
+id<MTLCommandBuffer> iree_hal_metal_direct_command_buffer_handle(
+    iree_hal_command_buffer_t* command_buffer);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_METAL_DIRECT_COMMAND_BUFFER_H_
@@ -0,0 +1,626 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#import "iree/hal/metal/direct_command_buffer.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+#import "iree/hal/metal/executable_layout.h"
+#import "iree/hal/metal/kernel_library.h"
+#import "iree/hal/metal/metal_buffer.h"
+
+// Maximum number of descriptor sets and bindings per set that may be pushed.
+#define IREE_HAL_METAL_MAX_DESCRIPTOR_SET_COUNT 4
+#define IREE_HAL_METAL_MAX_DESCRIPTOR_SET_BINDING_COUNT 32
+
+// Size of each buffer argument buffers are sub-allocated from.
+#define IREE_HAL_METAL_ARGUMENT_BUFFER_BLOCK_SIZE (64 * 1024)
+// Required offset alignment of argument buffers bound to an encoder.
+#define IREE_HAL_METAL_ARGUMENT_BUFFER_ALIGNMENT 256
+
+typedef struct iree_hal_metal_descriptor_set_t {
+  iree_host_size_t binding_count;
+  iree_hal_descriptor_set_binding_t
+      bindings[IREE_HAL_METAL_MAX_DESCRIPTOR_SET_BINDING_COUNT];
+} iree_hal_metal_descriptor_set_t;
+
+typedef struct iree_hal_metal_direct_command_buffer_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  iree_hal_command_buffer_mode_t mode;
+  iree_hal_command_category_t allowed_categories;
+
+  id<MTLCommandBuffer> command_buffer;
+
+  // The encoder commands are currently being recorded into, if any. Only one
+  // encoder may be active on a command buffer at a time; compute dispatches
+  // are batched into a single concurrent encoder until a transfer command
+  // requires switching to a blit encoder.
+  id<MTLComputeCommandEncoder> compute_encoder;
+  id<MTLBlitCommandEncoder> blit_encoder;
+
+  // Buffers created while recording (argument buffers and staging uploads)
+  // that must outlive execution. Released once the command buffer completes.
+  NSMutableArray<id<MTLBuffer>>* retained_buffers;
+
+  // Argument buffer block being sub-allocated from.
+  id<MTLBuffer> argument_buffer;
+  iree_host_size_t argument_buffer_offset;
+
+  // Descriptor sets most recently pushed and the number of sets in the
+  // executable layout they were pushed with.
+  iree_host_size_t descriptor_set_count;
+  iree_hal_metal_descriptor_set_t
+      descriptor_sets[IREE_HAL_METAL_MAX_DESCRIPTOR_SET_COUNT];
+} iree_hal_metal_direct_command_buffer_t;
+
+extern const iree_hal_command_buffer_vtable_t
+    iree_hal_metal_direct_command_buffer_vtable;
+
+static iree_hal_metal_direct_command_buffer_t*
+iree_hal_metal_direct_command_buffer_cast(
+    iree_hal_command_buffer_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value,
+                       &iree_hal_metal_direct_command_buffer_vtable);
+  return (iree_hal_metal_direct_command_buffer_t*)base_value;
+}
+
+iree_status_t iree_hal_metal_direct_command_buffer_create(
+    id<MTLCommandQueue> queue, iree_hal_command_buffer_mode_t mode,
+    iree_hal_command_category_t command_categories,
+    iree_allocator_t host_allocator,
+    iree_hal_command_buffer_t** out_command_buffer) {
+  IREE_ASSERT_ARGUMENT(queue);
+  IREE_ASSERT_ARGUMENT(out_command_buffer);
+  *out_command_buffer = NULL;
+  if (!iree_all_bits_set(mode, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "direct command buffers must be one-shot");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_metal_direct_command_buffer_t* command_buffer = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, sizeof(*command_buffer), (void**)&command_buffer);
+  if (iree_status_is_ok(status)) {
+    memset(command_buffer, 0, sizeof(*command_buffer));
+    iree_hal_resource_initialize(&iree_hal_metal_direct_command_buffer_vtable,
+                                 &command_buffer->resource);
+    command_buffer->host_allocator = host_allocator;
+    command_buffer->mode = mode;
+    command_buffer->allowed_categories = command_categories;
+    // Unretained references avoid the per-resource reference counting Metal
+    // would otherwise do on each encoded command.
+    command_buffer->command_buffer =
+        [[queue commandBufferWithUnretainedReferences] retain];
+    command_buffer->retained_buffers = [[NSMutableArray alloc] init];
+    *out_command_buffer = (iree_hal_command_buffer_t*)command_buffer;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_metal_direct_command_buffer_destroy(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  iree_hal_metal_direct_command_buffer_t* command_buffer =
+      iree_hal_metal_direct_command_buffer_cast(base_command_buffer);
+  iree_allocator_t host_allocator = command_buffer->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  [command_buffer->compute_encoder release];
+  [command_buffer->blit_encoder release];
+  [command_buffer->argument_buffer release];
+  [command_buffer->retained_buffers release];
+  [command_buffer->command_buffer release];
+  iree_allocator_free(host_allocator, command_buffer);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+bool iree_hal_metal_direct_command_buffer_isa(
+    iree_hal_command_buffer_t* command_buffer) {
+  return iree_hal_resource_is(command_buffer,
+                              &iree_hal_metal_direct_command_buffer_vtable);
+}
+
+id<MTLCommandBuffer> iree_hal_metal_direct_command_buffer_handle(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  iree_hal_metal_direct_command_buffer_t* command_buffer =
+      iree_hal_metal_direct_command_buffer_cast(base_command_buffer);
+  return command_buffer->command_buffer;
+}
+
+static iree_hal_command_buffer_mode_t
+iree_hal_metal_direct_command_buffer_mode(
+    const iree_hal_command_buffer_t* base_command_buffer) {
+  const iree_hal_metal_direct_command_buffer_t* command_buffer =
+      (const iree_hal_metal_direct_command_buffer_t*)(base_command_buffer);
+  return command_buffer->mode;
+}
+
+static iree_hal_command_category_t
+iree_hal_metal_direct_command_buffer_allowed_categories(
+    const iree_hal_command_buffer_t* base_command_buffer) {
+  const iree_hal_metal_direct_command_buffer_t* command_buffer =
+      (const iree_hal_metal_direct_command_buffer_t*)(base_command_buffer);
+  return command_buffer->allowed_categories;
+}
+
+// Ends the active encoder, if any.
+static void iree_hal_metal_direct_command_buffer_end_encoding(
+    iree_hal_metal_direct_command_buffer_t* command_buffer) {
+  if (command_buffer->compute_encoder) {
+    [command_buffer->compute_encoder endEncoding];
+    [command_buffer->compute_encoder release];
+    command_buffer->compute_encoder = nil;
+  }
+  if (command_buffer->blit_encoder) {
+    [command_buffer->blit_encoder endEncoding];
+    [command_buffer->blit_encoder release];
+    command_buffer->blit_encoder = nil;
+  }
+}
+
+static id<MTLComputeCommandEncoder>
+iree_hal_metal_direct_command_buffer_compute_encoder(
+    iree_hal_metal_direct_command_buffer_t* command_buffer) {
+  if (!command_buffer->compute_encoder) {
+    iree_hal_metal_direct_command_buffer_end_encoding(command_buffer);
+    // Dispatches within the encoder may run concurrently; ordering is
+    // established with memory barriers from execution barriers.
+    command_buffer->compute_encoder = [[command_buffer->command_buffer
+        computeCommandEncoderWithDispatchType:MTLDispatchTypeConcurrent]
+        retain];
+  }
+  return command_buffer->compute_encoder;
+}
+
+static id<MTLBlitCommandEncoder>
+iree_hal_metal_direct_command_buffer_blit_encoder(
+    iree_hal_metal_direct_command_buffer_t* command_buffer) {
+  if (!command_buffer->blit_encoder) {
+    iree_hal_metal_direct_command_buffer_end_encoding(command_buffer);
+    command_buffer->blit_encoder =
+        [[command_buffer->command_buffer blitCommandEncoder] retain];
+  }
+  return command_buffer->blit_encoder;
+}
+
+static iree_status_t iree_hal_metal_direct_command_buffer_begin(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_metal_direct_command_buffer_end(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  iree_hal_metal_direct_command_buffer_t* command_buffer =
+      iree_hal_metal_direct_command_buffer_cast(base_command_buffer);
+  iree_hal_metal_direct_command_buffer_end_encoding(command_buffer);
+
+  // Keep the buffers created while recording alive until the device is done
+  // with them even if the command buffer is released first.
+  NSMutableArray<id<MTLBuffer>>* retained_buffers =
+      command_buffer->retained_buffers;
+  [command_buffer->command_buffer
+      addCompletedHandler:^(id<MTLCommandBuffer> completed_command_buffer) {
+        [retained_buffers removeAllObjects];
+      }];
+  return iree_ok_status();
+}
+
+static void iree_hal_metal_direct_command_buffer_begin_debug_group(
+    iree_hal_command_buffer_t* base_command_buffer, iree_string_view_t label,
+    iree_hal_label_color_t label_color,
+    const iree_hal_label_location_t* location) {
+  iree_hal_metal_direct_command_buffer_t* command_buffer =
+      iree_hal_metal_direct_command_buffer_cast(base_command_buffer);
+  @autoreleasepool {
+    NSString* label_string =
+        [[[NSString alloc] initWithBytes:label.data
+                                  length:label.size
+                                encoding:NSUTF8StringEncoding] autorelease];
+    iree_hal_metal_direct_command_buffer_end_encoding(command_buffer);
+    [command_buffer->command_buffer pushDebugGroup:label_string];
+  }
+}
+
+static void iree_hal_metal_direct_command_buffer_end_debug_group(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  iree_hal_metal_direct_command_buffer_t* command_buffer =
+      iree_hal_metal_direct_command_buffer_cast(base_command_buffer);
+  iree_hal_metal_direct_command_buffer_end_encoding(command_buffer);
+  [command_buffer->command_buffer popDebugGroup];
+}
+
+static iree_status_t iree_hal_metal_direct_command_buffer_execution_barrier(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_execution_stage_t source_stage_mask,
+    iree_hal_execution_stage_t target_stage_mask,
+    iree_hal_execution_barrier_flags_t flags,
+    iree_host_size_t memory_barrier_count,
+    const iree_hal_memory_barrier_t* memory_barriers,
+    iree_host_size_t buffer_barrier_count,
+    const iree_hal_buffer_barrier_t* buffer_barriers) {
+  iree_hal_metal_direct_command_buffer_t* command_buffer =
+      iree_hal_metal_direct_command_buffer_cast(base_command_buffer);
+  // Work in different encoders is ordered by Metal's hazard tracking; only
+  // concurrent dispatches within the active compute encoder need a barrier.
+  if (command_buffer->compute_encoder) {
+    [command_buffer->compute_encoder
+        memoryBarrierWithScope:MTLBarrierScopeBuffers];
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_metal_direct_command_buffer_signal_event(
+    iree_hal_command_buffer_t* base_command_buffer, iree_hal_event_t* event,
+    iree_hal_execution_stage_t source_stage_mask) {
+  // Events are only waited on within the same command buffer where waits are
+  // implemented as full barriers; nothing to signal.
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_metal_direct_command_buffer_reset_event(
+    iree_hal_command_buffer_t* base_command_buffer, iree_hal_event_t* event,
+    iree_hal_execution_stage_t source_stage_mask) {
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_metal_direct_command_buffer_wait_events(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_host_size_t event_count, const iree_hal_event_t** events,
+    iree_hal_execution_stage_t source_stage_mask,
+    iree_hal_execution_stage_t target_stage_mask,
+    iree_host_size_t memory_barrier_count,
+    const iree_hal_memory_barrier_t* memory_barriers,
+    iree_host_size_t buffer_barrier_count,
+    const iree_hal_buffer_barrier_t* buffer_barriers) {
+  return iree_hal_metal_direct_command_buffer_execution_barrier(
+      base_command_buffer, source_stage_mask, target_stage_mask,
+      IREE_HAL_EXECUTION_BARRIER_FLAG_NONE, memory_barrier_count,
+      memory_barriers, buffer_barrier_count, buffer_barriers);
+}
+
+static iree_status_t iree_hal_metal_direct_command_buffer_discard_buffer(
+    iree_hal_command_buffer_t* base_command_buffer, iree_hal_buffer_t* buffer) {
+  // Nothing to do.
+  return iree_ok_status();
+}
+
+// Returns true if all |pattern_length| bytes of |pattern| are the same.
+static bool iree_hal_metal_is_byte_pattern(const void* pattern,
+                                           iree_host_size_t pattern_length) {
+  const uint8_t* bytes = (const uint8_t*)pattern;
+  for (iree_host_size_t i = 1; i < pattern_length; ++i) {
+    if (bytes[i] != bytes[0]) return false;
+  }
+  return true;
+}
+
+// Copies |length| bytes of |data| into a new shared buffer retained until the
+// command buffer completes.
+static id<MTLBuffer> iree_hal_metal_direct_command_buffer_stage(
+    iree_hal_metal_direct_command_buffer_t* command_buffer, const void* data,
+    iree_device_size_t length) {
+  id<MTLBuffer> staging_buffer = [command_buffer->command_buffer.device
+      newBufferWithBytes:data
+                  length:length
+                 options:MTLResourceStorageModeShared |
+                         MTLResourceCPUCacheModeWriteCombined];
+  if (staging_buffer) {
+    [command_buffer->retained_buffers addObject:staging_buffer];
+    [staging_buffer release];
+  }
+  return staging_buffer;
+}
+
+static iree_status_t iree_hal_metal_direct_command_buffer_fill_buffer(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_buffer_t* target_buffer, iree_device_size_t target_offset,
+    iree_device_size_t length, const void* pattern,
+    iree_host_size_t pattern_length) {
+  iree_hal_metal_direct_command_buffer_t* command_buffer =
+      iree_hal_metal_direct_command_buffer_cast(base_command_buffer);
+  id<MTLBuffer> target_device_buffer = iree_hal_metal_buffer_handle(
+      iree_hal_buffer_allocated_buffer(target_buffer));
+  target_offset += iree_hal_buffer_byte_offset(target_buffer);
+
+  if (iree_hal_metal_is_byte_pattern(pattern, pattern_length)) {
+    id<MTLBlitCommandEncoder> encoder =
+        iree_hal_metal_direct_command_buffer_blit_encoder(command_buffer);
+    [encoder fillBuffer:target_device_buffer
+                  range:NSMakeRange(target_offset, length)
+                  value:*(const uint8_t*)pattern];
+    return iree_ok_status();
+  }
+
+  // Blits can only fill with a single byte; expand wider patterns on the host
+  // and copy them over instead.
+  void* pattern_data = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(command_buffer->host_allocator,
+                                             length, &pattern_data));
+  for (iree_device_size_t i = 0; i < length; i += pattern_length) {
+    memcpy((uint8_t*)pattern_data + i, pattern,
+           iree_min(pattern_length, length - i));
+  }
+  id<MTLBuffer> staging_buffer = iree_hal_metal_direct_command_buffer_stage(
+      command_buffer, pattern_data, length);
+  iree_allocator_free(command_buffer->host_allocator, pattern_data);
+  if (!staging_buffer) {
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "unable to allocate fill staging buffer");
+  }
+  id<MTLBlitCommandEncoder> encoder =
+      iree_hal_metal_direct_command_buffer_blit_encoder(command_buffer);
+  [encoder copyFromBuffer:staging_buffer
+             sourceOffset:0
+                 toBuffer:target_device_buffer
+        destinationOffset:target_offset
+                     size:length];
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_metal_direct_command_buffer_update_buffer(
+    iree_hal_command_buffer_t* base_command_buffer, const void* source_buffer,
+    iree_host_size_t source_offset, iree_hal_buffer_t* target_buffer,
+    iree_device_size_t target_offset, iree_device_size_t length) {
+  iree_hal_metal_direct_command_buffer_t* command_buffer =
+      iree_hal_metal_direct_command_buffer_cast(base_command_buffer);
+  id<MTLBuffer> target_device_buffer = iree_hal_metal_buffer_handle(
+      iree_hal_buffer_allocated_buffer(target_buffer));
+  target_offset += iree_hal_buffer_byte_offset(target_buffer);
+
+  // The source data is only valid during this call; snapshot it into a
+  // staging buffer the device copies from when it executes.
+  id<MTLBuffer> staging_buffer = iree_hal_metal_direct_command_buffer_stage(
+      command_buffer, (const uint8_t*)source_buffer + source_offset, length);
+  if (!staging_buffer) {
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "unable to allocate update staging buffer");
+  }
+  id<MTLBlitCommandEncoder> encoder =
+      iree_hal_metal_direct_command_buffer_blit_encoder(command_buffer);
+  [encoder copyFromBuffer:staging_buffer
+             sourceOffset:0
+                 toBuffer:target_device_buffer
+        destinationOffset:target_offset
+                     size:length];
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_metal_direct_command_buffer_copy_buffer(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_buffer_t* source_buffer, iree_device_size_t source_offset,
+    iree_hal_buffer_t* target_buffer, iree_device_size_t target_offset,
+    iree_device_size_t length) {
+  iree_hal_metal_direct_command_buffer_t* command_buffer =
+      iree_hal_metal_direct_command_buffer_cast(base_command_buffer);
+  id<MTLBuffer> source_device_buffer = iree_hal_metal_buffer_handle(
+      iree_hal_buffer_allocated_buffer(source_buffer));
+  source_offset += iree_hal_buffer_byte_offset(source_buffer);
+  id<MTLBuffer> target_device_buffer = iree_hal_metal_buffer_handle(
+      iree_hal_buffer_allocated_buffer(target_buffer));
+  target_offset += iree_hal_buffer_byte_offset(target_buffer);
+
+  id<MTLBlitCommandEncoder> encoder =
+      iree_hal_metal_direct_command_buffer_blit_encoder(command_buffer);
+  [encoder copyFromBuffer:source_device_buffer
+             sourceOffset:source_offset
+                 toBuffer:target_device_buffer
+        destinationOffset:target_offset
+                     size:length];
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_metal_direct_command_buffer_push_constants(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_layout_t* executable_layout, iree_host_size_t offset,
+    const void* values, iree_host_size_t values_length) {
+  // Push constants are rejected: the metal-spirv compiler target does not
+  // lower push constant blocks (SPIRVToMSL fails on them) and so no MSL kernel
+  // declares a buffer index they could be bound to with setBytes.
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "push constants are not supported by the metal "
+                          "driver; executables must not use them");
+}
+
+static iree_status_t iree_hal_metal_direct_command_buffer_push_descriptor_set(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_layout_t* executable_layout, uint32_t set,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings) {
+  iree_hal_metal_direct_command_buffer_t* command_buffer =
+      iree_hal_metal_direct_command_buffer_cast(base_command_buffer);
+  if (set >= IREE_HAL_METAL_MAX_DESCRIPTOR_SET_COUNT ||
+      set >= iree_hal_metal_executable_layout_set_count(executable_layout)) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "descriptor set %u out of range", set);
+  }
+  if (binding_count > IREE_HAL_METAL_MAX_DESCRIPTOR_SET_BINDING_COUNT) {
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "descriptor set binding count %zu exceeds the "
+                            "maximum of %d",
+                            binding_count,
+                            IREE_HAL_METAL_MAX_DESCRIPTOR_SET_BINDING_COUNT);
+  }
+  // The buffers are resolved when dispatching as the argument buffer layout
+  // depends on the function being dispatched.
+  command_buffer->descriptor_set_count =
+      iree_hal_metal_executable_layout_set_count(executable_layout);
+  iree_hal_metal_descriptor_set_t* descriptor_set =
+      &command_buffer->descriptor_sets[set];
+  descriptor_set->binding_count = binding_count;
+  memcpy(descriptor_set->bindings, bindings,
+         binding_count * sizeof(*bindings));
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_metal_direct_command_buffer_bind_descriptor_set(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_layout_t* executable_layout, uint32_t set,
+    iree_hal_descriptor_set_t* descriptor_set,
+    iree_host_size_t dynamic_offset_count,
+    const iree_device_size_t* dynamic_offsets) {
+  // Only push descriptor sets are supported; see
+  // iree_hal_metal_device_create_descriptor_set.
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "descriptor sets must be pushed with the metal "
+                          "driver; bind_descriptor_set is not supported");
+}
+
+// Sub-allocates |length| bytes of argument buffer storage.
+static iree_status_t iree_hal_metal_direct_command_buffer_allocate_arguments(
+    iree_hal_metal_direct_command_buffer_t* command_buffer,
+    iree_host_size_t length, id<MTLBuffer>* out_buffer,
+    iree_host_size_t* out_offset) {
+  iree_host_size_t offset = iree_host_align(
+      command_buffer->argument_buffer_offset,
+      IREE_HAL_METAL_ARGUMENT_BUFFER_ALIGNMENT);
+  if (!command_buffer->argument_buffer ||
+      offset + length > [command_buffer->argument_buffer length]) {
+    id<MTLBuffer> argument_buffer = [command_buffer->command_buffer.device
+        newBufferWithLength:iree_max(length,
+                                     IREE_HAL_METAL_ARGUMENT_BUFFER_BLOCK_SIZE)
+                    options:MTLResourceStorageModeShared |
+                            MTLResourceCPUCacheModeWriteCombined];
+    if (!argument_buffer) {
+      return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                              "unable to allocate argument buffer");
+    }
+    [command_buffer->retained_buffers addObject:argument_buffer];
+    [command_buffer->argument_buffer release];
+    command_buffer->argument_buffer = argument_buffer;
+    offset = 0;
+  }
+  command_buffer->argument_buffer_offset = offset + length;
+  *out_buffer = command_buffer->argument_buffer;
+  *out_offset = offset;
+  return iree_ok_status();
+}
+
+// Sets the pipeline state of |kernel_params| and encodes the pushed
+// descriptor sets into argument buffers bound to the compute encoder.
+static iree_status_t iree_hal_metal_direct_command_buffer_prepare_dispatch(
+    iree_hal_metal_direct_command_buffer_t* command_buffer,
+    const iree_hal_metal_kernel_params_t* kernel_params,
+    id<MTLComputeCommandEncoder> encoder) {
+  [encoder setComputePipelineState:kernel_params->pipeline_state];
+  for (uint32_t set = 0; set < command_buffer->descriptor_set_count; ++set) {
+    iree_hal_metal_descriptor_set_t* descriptor_set =
+        &command_buffer->descriptor_sets[set];
+    if (!descriptor_set->binding_count) continue;
+
+    id<MTLArgumentEncoder> argument_encoder =
+        [kernel_params->function newArgumentEncoderWithBufferIndex:set];
+    if (!argument_encoder) continue;  // Set unused by the function.
+    id<MTLBuffer> argument_buffer = nil;
+    iree_host_size_t argument_offset = 0;
+    iree_status_t status =
+        iree_hal_metal_direct_command_buffer_allocate_arguments(
+            command_buffer, [argument_encoder encodedLength], &argument_buffer,
+            &argument_offset);
+    if (!iree_status_is_ok(status)) {
+      [argument_encoder release];
+      return status;
+    }
+    [argument_encoder setArgumentBuffer:argument_buffer offset:argument_offset];
+    for (iree_host_size_t i = 0; i < descriptor_set->binding_count; ++i) {
+      const iree_hal_descriptor_set_binding_t* binding =
+          &descriptor_set->bindings[i];
+      id<MTLBuffer> buffer = iree_hal_metal_buffer_handle(
+          iree_hal_buffer_allocated_buffer(binding->buffer));
+      [argument_encoder
+            setBuffer:buffer
+               offset:iree_hal_buffer_byte_offset(binding->buffer) +
+                      binding->offset
+              atIndex:binding->binding];
+      // Resources referenced only through argument buffers must be declared
+      // so that they are resident while the dispatch executes.
+      [encoder useResource:buffer
+                     usage:MTLResourceUsageRead | MTLResourceUsageWrite];
+    }
+    [argument_encoder release];
+    [encoder setBuffer:argument_buffer offset:argument_offset atIndex:set];
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_metal_direct_command_buffer_dispatch(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_t* executable, int32_t entry_point,
+    uint32_t workgroup_x, uint32_t workgroup_y, uint32_t workgroup_z) {
+  iree_hal_metal_direct_command_buffer_t* command_buffer =
+      iree_hal_metal_direct_command_buffer_cast(base_command_buffer);
+  const iree_hal_metal_kernel_params_t* kernel_params = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_metal_kernel_library_entry_point_kernel_params(
+      executable, entry_point, &kernel_params));
+  id<MTLComputeCommandEncoder> encoder =
+      iree_hal_metal_direct_command_buffer_compute_encoder(command_buffer);
+  IREE_RETURN_IF_ERROR(iree_hal_metal_direct_command_buffer_prepare_dispatch(
+      command_buffer, kernel_params, encoder));
+  [encoder
+       dispatchThreadgroups:MTLSizeMake(workgroup_x, workgroup_y, workgroup_z)
+      threadsPerThreadgroup:kernel_params->threadgroup_size];
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_metal_direct_command_buffer_dispatch_indirect(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_t* executable, int32_t entry_point,
+    iree_hal_buffer_t* workgroups_buffer,
+    iree_device_size_t workgroups_offset) {
+  iree_hal_metal_direct_command_buffer_t* command_buffer =
+      iree_hal_metal_direct_command_buffer_cast(base_command_buffer);
+  const iree_hal_metal_kernel_params_t* kernel_params = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_metal_kernel_library_entry_point_kernel_params(
+      executable, entry_point, &kernel_params));
+  id<MTLComputeCommandEncoder> encoder =
+      iree_hal_metal_direct_command_buffer_compute_encoder(command_buffer);
+  IREE_RETURN_IF_ERROR(iree_hal_metal_direct_command_buffer_prepare_dispatch(
+      command_buffer, kernel_params, encoder));
+  id<MTLBuffer> workgroups_device_buffer = iree_hal_metal_buffer_handle(
+      iree_hal_buffer_allocated_buffer(workgroups_buffer));
+  workgroups_offset += iree_hal_buffer_byte_offset(workgroups_buffer);
+  [encoder dispatchThreadgroupsWithIndirectBuffer:workgroups_device_buffer
+                             indirectBufferOffset:workgroups_offset
+                            threadsPerThreadgroup:kernel_params
+                                                      ->threadgroup_size];
+  return iree_ok_status();
+}
+
+const iree_hal_command_buffer_vtable_t
+    iree_hal_metal_direct_command_buffer_vtable = {
+        .destroy = iree_hal_metal_direct_command_buffer_destroy,
+        .mode = iree_hal_metal_direct_command_buffer_mode,
+        .allowed_categories =
+            iree_hal_metal_direct_command_buffer_allowed_categories,
+        .begin = iree_hal_metal_direct_command_buffer_begin,
+        .end = iree_hal_metal_direct_command_buffer_end,
+        .begin_debug_group =
+            iree_hal_metal_direct_command_buffer_begin_debug_group,
+        .end_debug_group = iree_hal_metal_direct_command_buffer_end_debug_group,
+        .execution_barrier =
+            iree_hal_metal_direct_command_buffer_execution_barrier,
+        .signal_event = iree_hal_metal_direct_command_buffer_signal_event,
+        .reset_event = iree_hal_metal_direct_command_buffer_reset_event,
+        .wait_events = iree_hal_metal_direct_command_buffer_wait_events,
+        .discard_buffer = iree_hal_metal_direct_command_buffer_discard_buffer,
+        .fill_buffer = iree_hal_metal_direct_command_buffer_fill_buffer,
+        .update_buffer = iree_hal_metal_direct_command_buffer_update_buffer,
+        .copy_buffer = iree_hal_metal_direct_command_buffer_copy_buffer,
+        .push_constants = iree_hal_metal_direct_command_buffer_push_constants,
+        .push_descriptor_set =
+            iree_hal_metal_direct_command_buffer_push_descriptor_set,
+        .bind_descriptor_set =
+            iree_hal_metal_direct_command_buffer_bind_descriptor_set,
+        .dispatch = iree_hal_metal_direct_command_buffer_dispatch,
+        .dispatch_indirect =
+            iree_hal_metal_direct_command_buffer_dispatch_indirect,
+};
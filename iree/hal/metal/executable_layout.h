@@ -0,0 +1,33 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_METAL_EXECUTABLE_LAYOUT_H_
+#define IREE_HAL_METAL_EXECUTABLE_LAYOUT_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Creates an executable layout. Descriptor set N is bound to the argument
+// buffer at [[buffer(N)]] as produced by the SPIRV-Cross translation.
+iree_status_t iree_hal_metal_executable_layout_create(
+    iree_host_size_t set_layout_count,
+    iree_hal_descriptor_set_layout_t** set_layouts,
+    iree_host_size_t push_constant_count, iree_allocator_t host_allocator,
+    iree_hal_executable_layout_t** out_executable_layout);
+
+// Returns the number of descriptor sets in the given executable layout.
+iree_host_size_t iree_hal_metal_executable_layout_set_count(
+    iree_hal_executable_layout_t* executable_layout);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_METAL_EXECUTABLE_LAYOUT_H_
@@ -0,0 +1,43 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_METAL_KERNEL_LIBRARY_H_
+#define IREE_HAL_METAL_KERNEL_LIBRARY_H_
+
+#import <Metal/Metal.h>
+
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// A compiled entry point of a kernel library.
+typedef struct iree_hal_metal_kernel_params_t {
+  id<MTLFunction> function;
+  id<MTLComputePipelineState> pipeline_state;
+  MTLSize threadgroup_size;
+} iree_hal_metal_kernel_params_t;
+
+// Creates an executable from a MetalExecutableDef flatbuffer by compiling its
+// shader sources and building one compute pipeline state per entry point.
+iree_status_t iree_hal_metal_kernel_library_create(
+    id<MTLDevice> device, const iree_hal_executable_spec_t* executable_spec,
+    iree_allocator_t host_allocator, iree_hal_executable_t** out_executable);
+
+// Returns the compiled kernel of |entry_point| in |executable|.
+iree_status_t iree_hal_metal_kernel_library_entry_point_kernel_params(
+    iree_hal_executable_t* executable, int32_t entry_point,
+    const iree_hal_metal_kernel_params_t** out_params);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_METAL_KERNEL_LIBRARY_H_
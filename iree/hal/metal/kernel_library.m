@@ -0,0 +1,234 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#import "iree/hal/metal/kernel_library.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+
+// flatcc schemas:
+#include "iree/base/internal/flatcc.h"
+#include "iree/schemas/metal_executable_def_reader.h"
+#include "iree/schemas/metal_executable_def_verifier.h"
+
+typedef struct iree_hal_metal_kernel_library_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  iree_host_size_t entry_point_count;
+  iree_hal_metal_kernel_params_t entry_points[];
+} iree_hal_metal_kernel_library_t;
+
+extern const iree_hal_executable_vtable_t iree_hal_metal_kernel_library_vtable;
+
+static iree_hal_metal_kernel_library_t* iree_hal_metal_kernel_library_cast(
+    iree_hal_executable_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_metal_kernel_library_vtable);
+  return (iree_hal_metal_kernel_library_t*)base_value;
+}
+
+// Verifies the structure of the flatbuffer so that we can avoid doing so
+// during runtime.
+static iree_status_t iree_hal_metal_kernel_library_flatbuffer_verify(
+    iree_const_byte_span_t flatbuffer_data) {
+  if (!flatbuffer_data.data || flatbuffer_data.data_length < 16) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "flatbuffer data is not present or less than 16 bytes (%zu total)",
+        flatbuffer_data.data_length);
+  }
+
+  // Run flatcc generated verification. This ensures all pointers are in-bounds
+  // and that we can safely walk the file, but not that the actual contents of
+  // the flatbuffer meet our expectations.
+  int verify_ret = iree_MetalExecutableDef_verify_as_root(
+      flatbuffer_data.data, flatbuffer_data.data_length);
+  if (verify_ret != flatcc_verify_ok) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "flatbuffer verification failed: %s",
+                            flatcc_verify_error_string(verify_ret));
+  }
+
+  iree_MetalExecutableDef_table_t executable_def =
+      iree_MetalExecutableDef_as_root(flatbuffer_data.data);
+
+  flatbuffers_string_vec_t entry_points_vec =
+      iree_MetalExecutableDef_entry_points_get(executable_def);
+  size_t entry_point_count = flatbuffers_string_vec_len(entry_points_vec);
+  for (size_t i = 0; i < entry_point_count; ++i) {
+    if (!flatbuffers_string_len(
+            flatbuffers_string_vec_at(entry_points_vec, i))) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "executable entry point %zu has no name", i);
+    }
+  }
+
+  iree_MetalThreadgroupSize_vec_t threadgroup_sizes_vec =
+      iree_MetalExecutableDef_threadgroup_sizes_get(executable_def);
+  if (iree_MetalThreadgroupSize_vec_len(threadgroup_sizes_vec) !=
+      entry_point_count) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "executable has %zu entry points but %zu "
+                            "threadgroup sizes",
+                            entry_point_count,
+                            iree_MetalThreadgroupSize_vec_len(
+                                threadgroup_sizes_vec));
+  }
+
+  // The compiler emits one shader source per entry point.
+  flatbuffers_string_vec_t shader_sources_vec =
+      iree_MetalExecutableDef_shader_sources_get(executable_def);
+  if (flatbuffers_string_vec_len(shader_sources_vec) != entry_point_count) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "executable must provide one shader source per "
+                            "entry point; precompiled libraries are not yet "
+                            "supported");
+  }
+
+  return iree_ok_status();
+}
+
+// Compiles |source| and builds the pipeline state of the |entry_point| in it.
+static iree_status_t iree_hal_metal_kernel_library_compile_entry_point(
+    id<MTLDevice> device, flatbuffers_string_t source,
+    flatbuffers_string_t entry_point,
+    iree_hal_metal_kernel_params_t* out_params) {
+  @autoreleasepool {
+    NSError* error = nil;
+    NSString* source_string =
+        [[[NSString alloc] initWithBytes:source
+                                  length:flatbuffers_string_len(source)
+                                encoding:NSUTF8StringEncoding] autorelease];
+    MTLCompileOptions* options = [[MTLCompileOptions new] autorelease];
+    options.fastMathEnabled = YES;
+    id<MTLLibrary> library = [[device newLibraryWithSource:source_string
+                                                   options:options
+                                                     error:&error] autorelease];
+    if (!library) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "failed to compile Metal shader source: %s",
+                              error.localizedDescription.UTF8String);
+    }
+
+    NSString* function_name =
+        [[[NSString alloc] initWithBytes:entry_point
+                                  length:flatbuffers_string_len(entry_point)
+                                encoding:NSUTF8StringEncoding] autorelease];
+    id<MTLFunction> function = [library newFunctionWithName:function_name];
+    if (!function) {
+      return iree_make_status(IREE_STATUS_NOT_FOUND,
+                              "entry point '%s' not found in Metal library",
+                              entry_point);
+    }
+
+    id<MTLComputePipelineState> pipeline_state =
+        [device newComputePipelineStateWithFunction:function error:&error];
+    if (!pipeline_state) {
+      [function release];
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "failed to create pipeline state for '%s': %s",
+                              entry_point,
+                              error.localizedDescription.UTF8String);
+    }
+
+    out_params->function = function;
+    out_params->pipeline_state = pipeline_state;
+  }
+  return iree_ok_status();
+}
+
+iree_status_t iree_hal_metal_kernel_library_create(
+    id<MTLDevice> device, const iree_hal_executable_spec_t* executable_spec,
+    iree_allocator_t host_allocator, iree_hal_executable_t** out_executable) {
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(executable_spec);
+  IREE_ASSERT_ARGUMENT(out_executable);
+  *out_executable = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_metal_kernel_library_flatbuffer_verify(
+              executable_spec->executable_data));
+  iree_MetalExecutableDef_table_t executable_def =
+      iree_MetalExecutableDef_as_root(executable_spec->executable_data.data);
+  flatbuffers_string_vec_t entry_points_vec =
+      iree_MetalExecutableDef_entry_points_get(executable_def);
+  iree_MetalThreadgroupSize_vec_t threadgroup_sizes_vec =
+      iree_MetalExecutableDef_threadgroup_sizes_get(executable_def);
+  flatbuffers_string_vec_t shader_sources_vec =
+      iree_MetalExecutableDef_shader_sources_get(executable_def);
+  iree_host_size_t entry_point_count =
+      flatbuffers_string_vec_len(entry_points_vec);
+
+  iree_hal_metal_kernel_library_t* executable = NULL;
+  iree_host_size_t total_size =
+      sizeof(*executable) +
+      entry_point_count * sizeof(executable->entry_points[0]);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, total_size,
+                                (void**)&executable));
+  memset(executable, 0, total_size);
+  iree_hal_resource_initialize(&iree_hal_metal_kernel_library_vtable,
+                               &executable->resource);
+  executable->host_allocator = host_allocator;
+  executable->entry_point_count = entry_point_count;
+
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0;
+       i < entry_point_count && iree_status_is_ok(status); ++i) {
+    iree_hal_metal_kernel_params_t* params = &executable->entry_points[i];
+    status = iree_hal_metal_kernel_library_compile_entry_point(
+        device, flatbuffers_string_vec_at(shader_sources_vec, i),
+        flatbuffers_string_vec_at(entry_points_vec, i), params);
+    const iree_MetalThreadgroupSize_t* threadgroup_size =
+        &threadgroup_sizes_vec[i];
+    params->threadgroup_size = MTLSizeMake(
+        threadgroup_size->x, threadgroup_size->y, threadgroup_size->z);
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_executable = (iree_hal_executable_t*)executable;
+  } else {
+    iree_hal_executable_release((iree_hal_executable_t*)executable);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_metal_kernel_library_destroy(
+    iree_hal_executable_t* base_executable) {
+  iree_hal_metal_kernel_library_t* executable =
+      iree_hal_metal_kernel_library_cast(base_executable);
+  iree_allocator_t host_allocator = executable->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  for (iree_host_size_t i = 0; i < executable->entry_point_count; ++i) {
+    [executable->entry_points[i].pipeline_state release];
+    [executable->entry_points[i].function release];
+  }
+  iree_allocator_free(host_allocator, executable);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+iree_status_t iree_hal_metal_kernel_library_entry_point_kernel_params(
+    iree_hal_executable_t* base_executable, int32_t entry_point,
+    const iree_hal_metal_kernel_params_t** out_params) {
+  iree_hal_metal_kernel_library_t* executable =
+      iree_hal_metal_kernel_library_cast(base_executable);
+  if (entry_point < 0 || entry_point >= executable->entry_point_count) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "invalid entry point ordinal %d", entry_point);
+  }
+  *out_params = &executable->entry_points[entry_point];
+  return iree_ok_status();
+}
+
+const iree_hal_executable_vtable_t iree_hal_metal_kernel_library_vtable = {
+    .destroy = iree_hal_metal_kernel_library_destroy,
+};
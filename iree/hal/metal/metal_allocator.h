@@ -0,0 +1,37 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_METAL_METAL_ALLOCATOR_H_
+#define IREE_HAL_METAL_METAL_ALLOCATOR_H_
+
+#import <Metal/Metal.h>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Creates an allocator of MTLBuffers on |device|.
+// If |use_shared_storage| is set all buffers are allocated in shared storage
+// and device-local buffers are made host-visible; this should only be used
+// when the device has unified memory with the host.
+iree_status_t iree_hal_metal_allocator_create(
+    id<MTLDevice> device, bool use_shared_storage,
+    iree_allocator_t host_allocator, iree_hal_allocator_t** out_allocator);
+
+// Records the release of |metal_buffer| allocated from |allocator|.
+void iree_hal_metal_allocator_free(iree_hal_allocator_t* allocator,
+                                   id<MTLBuffer> metal_buffer,
+                                   iree_hal_memory_type_t memory_type,
+                                   iree_device_size_t allocation_size);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_METAL_METAL_ALLOCATOR_H_
@@ -0,0 +1,276 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#import "iree/hal/metal/metal_allocator.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+#import "iree/hal/metal/metal_buffer.h"
+
+typedef struct iree_hal_metal_allocator_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  id<MTLDevice> device;
+
+  // True if all buffers are allocated in shared storage; see
+  // iree_hal_metal_allocator_create.
+  bool use_shared_storage;
+
+  // Guards all state below.
+  iree_slim_mutex_t mutex;
+  iree_hal_allocator_statistics_t memory_statistics;
+} iree_hal_metal_allocator_t;
+
+extern const iree_hal_allocator_vtable_t iree_hal_metal_allocator_vtable;
+
+static iree_hal_metal_allocator_t* iree_hal_metal_allocator_cast(
+    iree_hal_allocator_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_metal_allocator_vtable);
+  return (iree_hal_metal_allocator_t*)base_value;
+}
+
+iree_status_t iree_hal_metal_allocator_create(
+    id<MTLDevice> device, bool use_shared_storage,
+    iree_allocator_t host_allocator, iree_hal_allocator_t** out_allocator) {
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(out_allocator);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_metal_allocator_t* allocator = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, sizeof(*allocator), (void**)&allocator);
+  if (iree_status_is_ok(status)) {
+    iree_hal_resource_initialize(&iree_hal_metal_allocator_vtable,
+                                 &allocator->resource);
+    allocator->host_allocator = host_allocator;
+    allocator->device = [device retain];
+    allocator->use_shared_storage = use_shared_storage;
+    iree_slim_mutex_initialize(&allocator->mutex);
+    memset(&allocator->memory_statistics, 0,
+           sizeof(allocator->memory_statistics));
+    *out_allocator = (iree_hal_allocator_t*)allocator;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_metal_allocator_destroy(
+    iree_hal_allocator_t* base_allocator) {
+  iree_hal_metal_allocator_t* allocator =
+      iree_hal_metal_allocator_cast(base_allocator);
+  iree_allocator_t host_allocator = allocator->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_slim_mutex_deinitialize(&allocator->mutex);
+  [allocator->device release];
+  iree_allocator_free(host_allocator, allocator);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static iree_allocator_t iree_hal_metal_allocator_host_allocator(
+    const iree_hal_allocator_t* base_allocator) {
+  iree_hal_metal_allocator_t* allocator =
+      (iree_hal_metal_allocator_t*)base_allocator;
+  return allocator->host_allocator;
+}
+
+static iree_hal_buffer_compatibility_t
+iree_hal_metal_allocator_query_buffer_compatibility(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_buffer_usage_t allowed_usage,
+    iree_hal_buffer_usage_t intended_usage,
+    iree_device_size_t allocation_size) {
+  // Disallow usage not permitted by the buffer itself. Since we then use this
+  // to determine compatibility below we'll naturally set the right compat flags
+  // based on what's both allowed and intended.
+  intended_usage &= allowed_usage;
+
+  // All buffers can be allocated on the heap.
+  iree_hal_buffer_compatibility_t compatibility =
+      IREE_HAL_BUFFER_COMPATIBILITY_ALLOCATABLE;
+
+  // Buffers can only be used on the queue if they are device visible.
+  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE)) {
+    if (iree_all_bits_set(intended_usage, IREE_HAL_BUFFER_USAGE_TRANSFER)) {
+      compatibility |= IREE_HAL_BUFFER_COMPATIBILITY_QUEUE_TRANSFER;
+    }
+    if (iree_all_bits_set(intended_usage, IREE_HAL_BUFFER_USAGE_DISPATCH)) {
+      compatibility |= IREE_HAL_BUFFER_COMPATIBILITY_QUEUE_DISPATCH;
+    }
+  }
+
+  return compatibility;
+}
+
+// Returns the MTLResourceOptions used for buffers of |memory_type| and
+// updates |memory_type| with the properties the buffers will actually have.
+static MTLResourceOptions iree_hal_metal_allocator_select_options(
+    iree_hal_metal_allocator_t* allocator,
+    iree_hal_memory_type_t* memory_type) {
+  if (allocator->use_shared_storage) {
+    // The device and host share the same memory so device-local buffers can
+    // be mapped in-place without any staging.
+    *memory_type |= IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE |
+                    IREE_HAL_MEMORY_TYPE_HOST_VISIBLE |
+                    IREE_HAL_MEMORY_TYPE_HOST_COHERENT;
+  } else if (!iree_any_bit_set(*memory_type,
+                               IREE_HAL_MEMORY_TYPE_HOST_VISIBLE)) {
+    return MTLResourceStorageModePrivate;
+  }
+  *memory_type |= IREE_HAL_MEMORY_TYPE_HOST_COHERENT;
+  MTLResourceOptions options = MTLResourceStorageModeShared;
+  if (!iree_all_bits_set(*memory_type, IREE_HAL_MEMORY_TYPE_HOST_CACHED)) {
+    options |= MTLResourceCPUCacheModeWriteCombined;
+  }
+  return options;
+}
+
+static iree_status_t iree_hal_metal_allocator_allocate_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_buffer_usage_t allowed_usage, iree_host_size_t allocation_size,
+    iree_hal_buffer_t** out_buffer) {
+  iree_hal_metal_allocator_t* allocator =
+      iree_hal_metal_allocator_cast(base_allocator);
+  // Guard against the corner case where the requested buffer size is 0. The
+  // application is unlikely to do anything when requesting a 0-byte buffer;
+  // but it can happen in real world use cases. So we should at least not
+  // crash.
+  if (allocation_size == 0) allocation_size = 4;
+
+  MTLResourceOptions options =
+      iree_hal_metal_allocator_select_options(allocator, &memory_type);
+  id<MTLBuffer> metal_buffer =
+      [allocator->device newBufferWithLength:allocation_size options:options];
+  if (!metal_buffer) {
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "unable to allocate MTLBuffer of %zu bytes",
+                            allocation_size);
+  }
+
+  iree_status_t status = iree_hal_metal_buffer_wrap(
+      base_allocator, memory_type, IREE_HAL_MEMORY_ACCESS_ALL, allowed_usage,
+      allocation_size, /*byte_offset=*/0, /*byte_length=*/allocation_size,
+      metal_buffer, /*host_ptr=*/NULL,
+      /*data_allocator=*/iree_allocator_null(), out_buffer);
+  if (iree_status_is_ok(status)) {
+    iree_slim_mutex_lock(&allocator->mutex);
+    iree_hal_allocator_statistics_record_alloc(&allocator->memory_statistics,
+                                               memory_type, allocation_size,
+                                               metal_buffer);
+    iree_slim_mutex_unlock(&allocator->mutex);
+  }
+  // The HAL buffer retains the MTLBuffer if it was created.
+  [metal_buffer release];
+  return status;
+}
+
+void iree_hal_metal_allocator_free(iree_hal_allocator_t* base_allocator,
+                                   id<MTLBuffer> metal_buffer,
+                                   iree_hal_memory_type_t memory_type,
+                                   iree_device_size_t allocation_size) {
+  iree_hal_metal_allocator_t* allocator =
+      iree_hal_metal_allocator_cast(base_allocator);
+  iree_slim_mutex_lock(&allocator->mutex);
+  iree_hal_allocator_statistics_record_free(&allocator->memory_statistics,
+                                            memory_type, allocation_size,
+                                            metal_buffer);
+  iree_slim_mutex_unlock(&allocator->mutex);
+}
+
+static iree_status_t iree_hal_metal_allocator_wrap_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage, iree_byte_span_t data,
+    iree_allocator_t data_allocator, iree_hal_buffer_t** out_buffer) {
+  iree_hal_metal_allocator_t* allocator =
+      iree_hal_metal_allocator_cast(base_allocator);
+
+  // Host memory can only be imported in-place if it covers whole pages.
+  iree_host_size_t page_size = (iree_host_size_t)getpagesize();
+  if (!data.data_length || ((uintptr_t)data.data & (page_size - 1)) != 0 ||
+      (data.data_length & (page_size - 1)) != 0) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "imported host memory must be non-empty and aligned to %zu bytes",
+        page_size);
+  }
+  if (iree_any_bit_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL) &&
+      !allocator->use_shared_storage) {
+    return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                            "wrapping of device-local buffers not supported");
+  }
+  memory_type |= IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE |
+                 IREE_HAL_MEMORY_TYPE_HOST_VISIBLE |
+                 IREE_HAL_MEMORY_TYPE_HOST_COHERENT;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  id<MTLBuffer> metal_buffer =
+      [allocator->device newBufferWithBytesNoCopy:data.data
+                                           length:data.data_length
+                                          options:MTLResourceStorageModeShared
+                                      deallocator:nil];
+  iree_status_t status = iree_ok_status();
+  if (!metal_buffer) {
+    status = iree_make_status(IREE_STATUS_UNAVAILABLE,
+                              "unable to import host memory as a MTLBuffer");
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_metal_buffer_wrap(
+        base_allocator, memory_type, allowed_access, allowed_usage,
+        data.data_length, /*byte_offset=*/0, /*byte_length=*/data.data_length,
+        metal_buffer, data.data, data_allocator, out_buffer);
+  }
+  if (iree_status_is_ok(status)) {
+    iree_slim_mutex_lock(&allocator->mutex);
+    iree_hal_allocator_statistics_record_alloc(&allocator->memory_statistics,
+                                               memory_type, data.data_length,
+                                               metal_buffer);
+    iree_slim_mutex_unlock(&allocator->mutex);
+  }
+  [metal_buffer release];
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_metal_allocator_query_memory_statistics(
+    iree_hal_allocator_t* base_allocator,
+    iree_hal_allocator_statistics_t* out_statistics) {
+  iree_hal_metal_allocator_t* allocator =
+      iree_hal_metal_allocator_cast(base_allocator);
+  iree_slim_mutex_lock(&allocator->mutex);
+  *out_statistics = allocator->memory_statistics;
+  iree_slim_mutex_unlock(&allocator->mutex);
+}
+
+static void iree_hal_metal_allocator_reset_peak_memory_statistics(
+    iree_hal_allocator_t* base_allocator) {
+  iree_hal_metal_allocator_t* allocator =
+      iree_hal_metal_allocator_cast(base_allocator);
+  iree_slim_mutex_lock(&allocator->mutex);
+  iree_hal_allocator_statistics_reset_peak(&allocator->memory_statistics);
+  iree_slim_mutex_unlock(&allocator->mutex);
+}
+
+const iree_hal_allocator_vtable_t iree_hal_metal_allocator_vtable = {
+    .destroy = iree_hal_metal_allocator_destroy,
+    .host_allocator = iree_hal_metal_allocator_host_allocator,
+    .query_buffer_compatibility =
+        iree_hal_metal_allocator_query_buffer_compatibility,
+    .allocate_buffer = iree_hal_metal_allocator_allocate_buffer,
+    .wrap_buffer = iree_hal_metal_allocator_wrap_buffer,
+    .query_statistics = iree_hal_metal_allocator_query_memory_statistics,
+    .reset_peak_statistics =
+        iree_hal_metal_allocator_reset_peak_memory_statistics,
+};
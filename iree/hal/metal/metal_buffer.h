@@ -0,0 +1,38 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_METAL_METAL_BUFFER_H_
+#define IREE_HAL_METAL_METAL_BUFFER_H_
+
+#import <Metal/Metal.h>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Wraps |metal_buffer| in a HAL buffer. The buffer retains |metal_buffer|.
+// |data_allocator| is used to free the host memory backing |metal_buffer| when
+// it was created around caller-provided memory.
+iree_status_t iree_hal_metal_buffer_wrap(
+    iree_hal_allocator_t* allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage, iree_device_size_t allocation_size,
+    iree_device_size_t byte_offset, iree_device_size_t byte_length,
+    id<MTLBuffer> metal_buffer, void* host_ptr,
+    iree_allocator_t data_allocator, iree_hal_buffer_t** out_buffer);
+
+// Returns the MTLBuffer backing |buffer|.
+// |buffer| must be an allocated buffer and not a subspan.
+id<MTLBuffer> iree_hal_metal_buffer_handle(iree_hal_buffer_t* buffer);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_METAL_METAL_BUFFER_H_
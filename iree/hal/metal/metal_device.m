@@ -0,0 +1,461 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#import "iree/hal/metal/metal_device.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "iree/base/internal/arena.h"
+#include "iree/base/internal/threading.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/metal/descriptor_set_layout.h"
+#import "iree/hal/metal/direct_command_buffer.h"
+#include "iree/hal/metal/executable_layout.h"
+#import "iree/hal/metal/metal_allocator.h"
+#include "iree/hal/metal/metal_event.h"
+#import "iree/hal/metal/nop_executable_cache.h"
+#import "iree/hal/metal/shared_event.h"
+#include "iree/hal/utils/deferred_command_buffer.h"
+
+//===----------------------------------------------------------------------===//
+// iree_hal_metal_device_t
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_metal_device_t {
+  iree_hal_resource_t resource;
+  iree_string_view_t identifier;
+  iree_allocator_t host_allocator;
+
+  // Block pool used for reusable command buffers recorded on the host.
+  iree_arena_block_pool_t block_pool;
+
+  // Optional driver that owns the Metal device. We retain it for our lifetime
+  // to ensure the device remains valid.
+  iree_hal_driver_t* driver;
+
+  id<MTLDevice> device;
+  // Queue that all submissions are issued on in order.
+  id<MTLCommandQueue> queue;
+  // Listener delivering MTLSharedEvent notifications to waiting host threads.
+  MTLSharedEventListener* event_listener;
+
+  iree_hal_allocator_t* device_allocator;
+} iree_hal_metal_device_t;
+
+extern const iree_hal_device_vtable_t iree_hal_metal_device_vtable;
+
+static iree_hal_metal_device_t* iree_hal_metal_device_cast(
+    iree_hal_device_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_metal_device_vtable);
+  return (iree_hal_metal_device_t*)base_value;
+}
+
+IREE_API_EXPORT void iree_hal_metal_device_params_initialize(
+    iree_hal_metal_device_params_t* out_params) {
+  memset(out_params, 0, sizeof(*out_params));
+  out_params->arena_block_size = 32 * 1024;
+  out_params->use_shared_storage_when_unified = true;
+}
+
+static iree_status_t iree_hal_metal_device_check_params(
+    const iree_hal_metal_device_params_t* params) {
+  if (params->arena_block_size < 4096) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "arena block size too small (< 4096 bytes)");
+  }
+  return iree_ok_status();
+}
+
+static void iree_hal_metal_device_destroy(iree_hal_device_t* base_device) {
+  iree_hal_metal_device_t* device = iree_hal_metal_device_cast(base_device);
+  iree_allocator_t host_allocator = iree_hal_device_host_allocator(base_device);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // There should be no more buffers live that use the allocator.
+  iree_hal_allocator_release(device->device_allocator);
+  [device->event_listener release];
+  [device->queue release];
+  [device->device release];
+
+  iree_arena_block_pool_deinitialize(&device->block_pool);
+  // Finally, destroy the device.
+  iree_hal_driver_release(device->driver);
+
+  iree_allocator_free(host_allocator, device);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+iree_status_t iree_hal_metal_device_create(
+    iree_hal_driver_t* driver, iree_string_view_t identifier,
+    const iree_hal_metal_device_params_t* params, id<MTLDevice> metal_device,
+    iree_allocator_t host_allocator, iree_hal_device_t** out_device) {
+  IREE_ASSERT_ARGUMENT(params);
+  IREE_ASSERT_ARGUMENT(metal_device);
+  IREE_ASSERT_ARGUMENT(out_device);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(z0,
+                                    iree_hal_metal_device_check_params(params));
+
+  iree_hal_metal_device_t* device = NULL;
+  iree_host_size_t total_size = iree_sizeof_struct(*device) + identifier.size;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, total_size, (void**)&device));
+  memset(device, 0, total_size);
+  iree_hal_resource_initialize(&iree_hal_metal_device_vtable,
+                               &device->resource);
+  device->driver = driver;
+  iree_hal_driver_retain(device->driver);
+  iree_string_view_append_to_buffer(
+      identifier, &device->identifier,
+      (char*)device + iree_sizeof_struct(*device));
+  device->host_allocator = host_allocator;
+  iree_arena_block_pool_initialize(params->arena_block_size, host_allocator,
+                                   &device->block_pool);
+  device->device = [metal_device retain];
+  device->queue = [metal_device newCommandQueue];
+  device->event_listener = [[MTLSharedEventListener alloc] init];
+
+  iree_status_t status = iree_ok_status();
+  if (!device->queue) {
+    status = iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                              "unable to create MTLCommandQueue");
+  }
+  if (iree_status_is_ok(status)) {
+    // With unified memory device-local buffers can live in shared storage and
+    // be mapped by the host without any staging copies.
+    bool use_shared_storage = params->use_shared_storage_when_unified &&
+                              [metal_device hasUnifiedMemory];
+    status = iree_hal_metal_allocator_create(metal_device, use_shared_storage,
+                                             host_allocator,
+                                             &device->device_allocator);
+  }
+  if (iree_status_is_ok(status)) {
+    *out_device = (iree_hal_device_t*)device;
+  } else {
+    iree_hal_device_release((iree_hal_device_t*)device);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static iree_string_view_t iree_hal_metal_device_id(
+    iree_hal_device_t* base_device) {
+  iree_hal_metal_device_t* device = iree_hal_metal_device_cast(base_device);
+  return device->identifier;
+}
+
+static iree_allocator_t iree_hal_metal_device_host_allocator(
+    iree_hal_device_t* base_device) {
+  iree_hal_metal_device_t* device = iree_hal_metal_device_cast(base_device);
+  return device->host_allocator;
+}
+
+static iree_hal_allocator_t* iree_hal_metal_device_allocator(
+    iree_hal_device_t* base_device) {
+  iree_hal_metal_device_t* device = iree_hal_metal_device_cast(base_device);
+  return device->device_allocator;
+}
+
+static iree_status_t iree_hal_metal_device_query_i32(
+    iree_hal_device_t* base_device, iree_string_view_t category,
+    iree_string_view_t key, int32_t* out_value) {
+  *out_value = 0;
+
+  if (iree_string_view_equal(category,
+                             iree_make_cstring_view("hal.executable.format"))) {
+    *out_value =
+        iree_string_view_equal(key, iree_make_cstring_view("metal-msl-fb"))
+            ? 1
+            : 0;
+    return iree_ok_status();
+  }
+
+  return iree_make_status(
+      IREE_STATUS_NOT_FOUND,
+      "unknown device configuration key value '%.*s :: %.*s'",
+      (int)category.size, category.data, (int)key.size, key.data);
+}
+
+static iree_status_t iree_hal_metal_device_create_command_buffer(
+    iree_hal_device_t* base_device, iree_hal_command_buffer_mode_t mode,
+    iree_hal_command_category_t command_categories,
+    iree_hal_queue_affinity_t queue_affinity,
+    iree_hal_command_buffer_t** out_command_buffer) {
+  iree_hal_metal_device_t* device = iree_hal_metal_device_cast(base_device);
+  // MTLCommandBuffers can only be committed once. One-shot command buffers
+  // encode directly into one while reusable ones are recorded on the host and
+  // replayed into a new MTLCommandBuffer on each submission.
+  if (iree_all_bits_set(mode, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT)) {
+    return iree_hal_metal_direct_command_buffer_create(
+        device->queue, mode, command_categories, device->host_allocator,
+        out_command_buffer);
+  }
+  return iree_hal_deferred_command_buffer_create(
+      mode, command_categories, IREE_HAL_DEFERRED_COMMAND_BUFFER_FLAG_NONE,
+      &device->block_pool, device->host_allocator, out_command_buffer);
+}
+
+static iree_status_t iree_hal_metal_device_create_descriptor_set(
+    iree_hal_device_t* base_device,
+    iree_hal_descriptor_set_layout_t* set_layout,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings,
+    iree_hal_descriptor_set_t** out_descriptor_set) {
+  // Persistent descriptor sets are rejected. Argument buffer layouts are
+  // only known per-function, so bindings are encoded at dispatch time from
+  // the sets pushed with push_descriptor_set instead.
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "descriptor sets must be pushed with the metal "
+                          "driver; create_descriptor_set is not supported");
+}
+
+static iree_status_t iree_hal_metal_device_create_descriptor_set_layout(
+    iree_hal_device_t* base_device,
+    iree_hal_descriptor_set_layout_usage_type_t usage_type,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_layout_binding_t* bindings,
+    iree_hal_descriptor_set_layout_t** out_descriptor_set_layout) {
+  iree_hal_metal_device_t* device = iree_hal_metal_device_cast(base_device);
+  return iree_hal_metal_descriptor_set_layout_create(
+      usage_type, binding_count, bindings, device->host_allocator,
+      out_descriptor_set_layout);
+}
+
+static iree_status_t iree_hal_metal_device_create_event(
+    iree_hal_device_t* base_device, iree_hal_event_t** out_event) {
+  iree_hal_metal_device_t* device = iree_hal_metal_device_cast(base_device);
+  return iree_hal_metal_event_create(device->host_allocator, out_event);
+}
+
+static iree_status_t iree_hal_metal_device_create_executable_cache(
+    iree_hal_device_t* base_device, iree_string_view_t identifier,
+    iree_hal_executable_cache_t** out_executable_cache) {
+  iree_hal_metal_device_t* device = iree_hal_metal_device_cast(base_device);
+  return iree_hal_metal_nop_executable_cache_create(
+      device->device, identifier, device->host_allocator,
+      out_executable_cache);
+}
+
+static iree_status_t iree_hal_metal_device_create_executable_layout(
+    iree_hal_device_t* base_device, iree_host_size_t push_constants,
+    iree_host_size_t set_layout_count,
+    iree_hal_descriptor_set_layout_t** set_layouts,
+    iree_hal_executable_layout_t** out_executable_layout) {
+  iree_hal_metal_device_t* device = iree_hal_metal_device_cast(base_device);
+  return iree_hal_metal_executable_layout_create(
+      set_layout_count, set_layouts, push_constants, device->host_allocator,
+      out_executable_layout);
+}
+
+static iree_status_t iree_hal_metal_device_create_semaphore(
+    iree_hal_device_t* base_device, uint64_t initial_value,
+    iree_hal_semaphore_t** out_semaphore) {
+  iree_hal_metal_device_t* device = iree_hal_metal_device_cast(base_device);
+  return iree_hal_metal_shared_event_create(
+      device->device, device->event_listener, initial_value,
+      device->host_allocator, out_semaphore);
+}
+
+// Returns the MTLCommandBuffer holding the commands of |command_buffer|,
+// replaying it into a new one first if it was recorded on the host.
+static iree_status_t iree_hal_metal_device_resolve_command_buffer(
+    iree_hal_metal_device_t* device, iree_hal_command_buffer_t* command_buffer,
+    id<MTLCommandBuffer>* out_metal_command_buffer) {
+  if (iree_hal_metal_direct_command_buffer_isa(command_buffer)) {
+    id<MTLCommandBuffer> metal_command_buffer =
+        iree_hal_metal_direct_command_buffer_handle(command_buffer);
+    if ([metal_command_buffer status] != MTLCommandBufferStatusNotEnqueued) {
+      return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                              "one-shot command buffer already submitted");
+    }
+    *out_metal_command_buffer = metal_command_buffer;
+    return iree_ok_status();
+  }
+
+  iree_hal_command_buffer_t* direct_command_buffer = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_metal_direct_command_buffer_create(
+      device->queue, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT,
+      iree_hal_command_buffer_allowed_categories(command_buffer),
+      device->host_allocator, &direct_command_buffer));
+  iree_status_t status = iree_hal_deferred_command_buffer_apply(
+      command_buffer, direct_command_buffer);
+  if (iree_status_is_ok(status)) {
+    // The queue retains the MTLCommandBuffer once committed; keep it alive
+    // until then in the current autorelease pool.
+    *out_metal_command_buffer = [[iree_hal_metal_direct_command_buffer_handle(
+        direct_command_buffer) retain] autorelease];
+  }
+  iree_hal_command_buffer_release(direct_command_buffer);
+  return status;
+}
+
+// Commits the command buffers of |batch| in order after its wait semaphores
+// are reached and signals its signal semaphores once they complete.
+static iree_status_t iree_hal_metal_device_submit_batch(
+    iree_hal_metal_device_t* device,
+    const iree_hal_submission_batch_t* batch) {
+  // Direct command buffers have already been encoded so waits are encoded
+  // into a command buffer of their own committed before them.
+  if (batch->wait_semaphores.count > 0) {
+    id<MTLCommandBuffer> wait_command_buffer =
+        [device->queue commandBufferWithUnretainedReferences];
+    for (iree_host_size_t i = 0; i < batch->wait_semaphores.count; ++i) {
+      IREE_RETURN_IF_ERROR(iree_hal_metal_shared_event_encode_wait(
+          batch->wait_semaphores.semaphores[i],
+          batch->wait_semaphores.payload_values[i], wait_command_buffer));
+    }
+    [wait_command_buffer commit];
+  }
+
+  id<MTLCommandBuffer> last_command_buffer = nil;
+  for (iree_host_size_t i = 0; i < batch->command_buffer_count; ++i) {
+    if (last_command_buffer) [last_command_buffer commit];
+    IREE_RETURN_IF_ERROR(iree_hal_metal_device_resolve_command_buffer(
+        device, batch->command_buffers[i], &last_command_buffer));
+  }
+
+  // Signals are appended to the last command buffer of the batch to avoid
+  // committing another one.
+  if (batch->signal_semaphores.count > 0 && !last_command_buffer) {
+    last_command_buffer =
+        [device->queue commandBufferWithUnretainedReferences];
+  }
+  for (iree_host_size_t i = 0; i < batch->signal_semaphores.count; ++i) {
+    IREE_RETURN_IF_ERROR(iree_hal_metal_shared_event_encode_signal(
+        batch->signal_semaphores.semaphores[i],
+        batch->signal_semaphores.payload_values[i], last_command_buffer));
+  }
+  if (last_command_buffer) [last_command_buffer commit];
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_metal_device_queue_submit(
+    iree_hal_device_t* base_device,
+    iree_hal_command_category_t command_categories,
+    iree_hal_queue_affinity_t queue_affinity, iree_host_size_t batch_count,
+    const iree_hal_submission_batch_t* batches) {
+  iree_hal_metal_device_t* device = iree_hal_metal_device_cast(base_device);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_status_t status = iree_ok_status();
+  @autoreleasepool {
+    for (iree_host_size_t i = 0; i < batch_count && iree_status_is_ok(status);
+         ++i) {
+      status = iree_hal_metal_device_submit_batch(device, &batches[i]);
+    }
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static iree_status_t iree_hal_metal_device_submit_and_wait(
+    iree_hal_device_t* base_device,
+    iree_hal_command_category_t command_categories,
+    iree_hal_queue_affinity_t queue_affinity, iree_host_size_t batch_count,
+    const iree_hal_submission_batch_t* batches,
+    iree_hal_semaphore_t* wait_semaphore, uint64_t wait_value,
+    iree_timeout_t timeout) {
+  // Submit...
+  IREE_RETURN_IF_ERROR(iree_hal_metal_device_queue_submit(
+      base_device, command_categories, queue_affinity, batch_count, batches));
+
+  // ...and wait.
+  return iree_hal_semaphore_wait(wait_semaphore, wait_value, timeout);
+}
+
+static iree_status_t iree_hal_metal_device_wait_semaphores(
+    iree_hal_device_t* base_device, iree_hal_wait_mode_t wait_mode,
+    const iree_hal_semaphore_list_t* semaphore_list, iree_timeout_t timeout) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
+  iree_status_t status = iree_ok_status();
+  if (wait_mode == IREE_HAL_WAIT_MODE_ALL || semaphore_list->count <= 1) {
+    for (iree_host_size_t i = 0;
+         i < semaphore_list->count && iree_status_is_ok(status); ++i) {
+      status = iree_hal_semaphore_wait(semaphore_list->semaphores[i],
+                                       semaphore_list->payload_values[i],
+                                       iree_make_deadline(deadline_ns));
+    }
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+
+  // Poll each semaphore until one is reached or the deadline passes.
+  while (iree_status_is_ok(status)) {
+    for (iree_host_size_t i = 0; i < semaphore_list->count; ++i) {
+      uint64_t value = 0;
+      status = iree_hal_semaphore_query(semaphore_list->semaphores[i], &value);
+      if (!iree_status_is_ok(status)) break;
+      if (value >= semaphore_list->payload_values[i]) {
+        IREE_TRACE_ZONE_END(z0);
+        return iree_ok_status();
+      }
+    }
+    if (iree_status_is_ok(status) && iree_time_now() >= deadline_ns) {
+      status = iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+    }
+    if (iree_status_is_ok(status)) iree_thread_yield();
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static iree_status_t iree_hal_metal_device_wait_idle(
+    iree_hal_device_t* base_device, iree_timeout_t timeout) {
+  iree_hal_metal_device_t* device = iree_hal_metal_device_cast(base_device);
+  iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Command buffers on a queue complete in order so waiting on an empty one
+  // waits for all prior work. waitUntilCompleted has no deadline so the
+  // completion handler signals a semaphore that is waited on instead.
+  long timed_out = 0;
+  @autoreleasepool {
+    dispatch_semaphore_t completed = dispatch_semaphore_create(0);
+    id<MTLCommandBuffer> command_buffer =
+        [device->queue commandBufferWithUnretainedReferences];
+    [command_buffer addCompletedHandler:^(id<MTLCommandBuffer> cb) {
+      dispatch_semaphore_signal(completed);
+    }];
+    [command_buffer commit];
+    dispatch_time_t dispatch_deadline = DISPATCH_TIME_FOREVER;
+    if (deadline_ns != IREE_TIME_INFINITE_FUTURE) {
+      iree_time_t now_ns = iree_time_now();
+      dispatch_deadline = dispatch_time(
+          DISPATCH_TIME_NOW, deadline_ns > now_ns ? deadline_ns - now_ns : 0);
+    }
+    timed_out = dispatch_semaphore_wait(completed, dispatch_deadline);
+    dispatch_release(completed);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  if (timed_out) {
+    return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+  }
+  return iree_ok_status();
+}
+
+const iree_hal_device_vtable_t iree_hal_metal_device_vtable = {
+    .destroy = iree_hal_metal_device_destroy,
+    .id = iree_hal_metal_device_id,
+    .host_allocator = iree_hal_metal_device_host_allocator,
+    .device_allocator = iree_hal_metal_device_allocator,
+    .query_i32 = iree_hal_metal_device_query_i32,
+    .create_command_buffer = iree_hal_metal_device_create_command_buffer,
+    .create_descriptor_set = iree_hal_metal_device_create_descriptor_set,
+    .create_descriptor_set_layout =
+        iree_hal_metal_device_create_descriptor_set_layout,
+    .create_event = iree_hal_metal_device_create_event,
+    .create_executable_cache = iree_hal_metal_device_create_executable_cache,
+    .create_executable_layout = iree_hal_metal_device_create_executable_layout,
+    .create_semaphore = iree_hal_metal_device_create_semaphore,
+    .queue_submit = iree_hal_metal_device_queue_submit,
+    .submit_and_wait = iree_hal_metal_device_submit_and_wait,
+    .wait_semaphores = iree_hal_metal_device_wait_semaphores,
+    .wait_idle = iree_hal_metal_device_wait_idle,
+};
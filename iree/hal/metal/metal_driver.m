@@ -0,0 +1,176 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#import <Metal/Metal.h>
+#include <TargetConditionals.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/api.h"
+#include "iree/hal/metal/api.h"
+#import "iree/hal/metal/metal_device.h"
+
+typedef struct iree_hal_metal_driver_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  // Identifier used for the driver in the IREE driver registry.
+  iree_string_view_t identifier;
+  iree_hal_metal_device_params_t default_params;
+  int default_device_index;
+} iree_hal_metal_driver_t;
+
+extern const iree_hal_driver_vtable_t iree_hal_metal_driver_vtable;
+
+static iree_hal_metal_driver_t* iree_hal_metal_driver_cast(
+    iree_hal_driver_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_metal_driver_vtable);
+  return (iree_hal_metal_driver_t*)base_value;
+}
+
+IREE_API_EXPORT void iree_hal_metal_driver_options_initialize(
+    iree_hal_metal_driver_options_t* out_options) {
+  memset(out_options, 0, sizeof(*out_options));
+  out_options->default_device_index = 0;
+}
+
+// Returns a retained array of all Metal devices in the system.
+// iOS only exposes the system default device.
+static NSArray<id<MTLDevice>>* iree_hal_metal_copy_all_devices(void) {
+#if TARGET_OS_OSX
+  return MTLCopyAllDevices();
+#else
+  id<MTLDevice> device = MTLCreateSystemDefaultDevice();
+  if (!device) return [[NSArray alloc] init];
+  NSArray<id<MTLDevice>>* devices =
+      [[NSArray alloc] initWithObjects:device, nil];
+  [device release];
+  return devices;
+#endif  // TARGET_OS_OSX
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_metal_driver_create(
+    iree_string_view_t identifier,
+    const iree_hal_metal_device_params_t* default_params,
+    const iree_hal_metal_driver_options_t* options,
+    iree_allocator_t host_allocator, iree_hal_driver_t** out_driver) {
+  IREE_ASSERT_ARGUMENT(default_params);
+  IREE_ASSERT_ARGUMENT(options);
+  IREE_ASSERT_ARGUMENT(out_driver);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_metal_driver_t* driver = NULL;
+  iree_host_size_t total_size = iree_sizeof_struct(*driver) + identifier.size;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, total_size, (void**)&driver));
+  iree_hal_resource_initialize(&iree_hal_metal_driver_vtable,
+                               &driver->resource);
+  driver->host_allocator = host_allocator;
+  iree_string_view_append_to_buffer(
+      identifier, &driver->identifier,
+      (char*)driver + iree_sizeof_struct(*driver));
+  memcpy(&driver->default_params, default_params,
+         sizeof(driver->default_params));
+  driver->default_device_index = options->default_device_index;
+  *out_driver = (iree_hal_driver_t*)driver;
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+static void iree_hal_metal_driver_destroy(iree_hal_driver_t* base_driver) {
+  iree_hal_metal_driver_t* driver = iree_hal_metal_driver_cast(base_driver);
+  iree_allocator_t host_allocator = driver->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_allocator_free(host_allocator, driver);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static iree_status_t iree_hal_metal_driver_query_available_devices(
+    iree_hal_driver_t* base_driver, iree_allocator_t host_allocator,
+    iree_hal_device_info_t** out_device_infos,
+    iree_host_size_t* out_device_info_count) {
+  iree_status_t status = iree_ok_status();
+  @autoreleasepool {
+    NSArray<id<MTLDevice>>* devices = iree_hal_metal_copy_all_devices();
+    iree_host_size_t device_count = (iree_host_size_t)[devices count];
+
+    // Allocate the return infos with the device names appended.
+    iree_hal_device_info_t* device_infos = NULL;
+    iree_host_size_t total_size = device_count * sizeof(*device_infos);
+    for (iree_host_size_t i = 0; i < device_count; ++i) {
+      total_size += strlen([[devices[i] name] UTF8String]);
+    }
+    status = iree_allocator_malloc(host_allocator, total_size,
+                                   (void**)&device_infos);
+    if (iree_status_is_ok(status)) {
+      char* buffer_ptr =
+          (char*)device_infos + device_count * sizeof(*device_infos);
+      for (iree_host_size_t i = 0; i < device_count; ++i) {
+        memset(&device_infos[i], 0, sizeof(device_infos[i]));
+        // Device IDs are 1-based indices into the device list as 0 selects
+        // the default device.
+        device_infos[i].device_id = (iree_hal_device_id_t)(i + 1);
+        buffer_ptr += iree_string_view_append_to_buffer(
+            iree_make_cstring_view([[devices[i] name] UTF8String]),
+            &device_infos[i].name, buffer_ptr);
+      }
+      *out_device_info_count = device_count;
+      *out_device_infos = device_infos;
+    }
+    [devices release];
+  }
+  return status;
+}
+
+static iree_status_t iree_hal_metal_driver_create_device(
+    iree_hal_driver_t* base_driver, iree_hal_device_id_t device_id,
+    iree_allocator_t host_allocator, iree_hal_device_t** out_device) {
+  iree_hal_metal_driver_t* driver = iree_hal_metal_driver_cast(base_driver);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_status_t status = iree_ok_status();
+  @autoreleasepool {
+    // Use either the specified device (enumerated earlier) or whatever default
+    // one was specified when the driver was created, falling back to the
+    // system default device.
+    NSArray<id<MTLDevice>>* devices = iree_hal_metal_copy_all_devices();
+    NSUInteger device_index = device_id != 0
+                                  ? (NSUInteger)(device_id - 1)
+                                  : (NSUInteger)driver->default_device_index;
+    id<MTLDevice> metal_device = nil;
+    if (device_index < [devices count]) {
+      metal_device = [devices[device_index] retain];
+    } else if (device_id == 0) {
+      metal_device = MTLCreateSystemDefaultDevice();
+    }
+    [devices release];
+
+    if (metal_device) {
+      status = iree_hal_metal_device_create(
+          base_driver, iree_make_cstring_view("metal"),
+          &driver->default_params, metal_device, host_allocator, out_device);
+      [metal_device release];
+    } else {
+      status = iree_make_status(IREE_STATUS_NOT_FOUND,
+                                "Metal device %" PRIu64 " not found",
+                                (uint64_t)device_id);
+    }
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+const iree_hal_driver_vtable_t iree_hal_metal_driver_vtable = {
+    .destroy = iree_hal_metal_driver_destroy,
+    .query_available_devices = iree_hal_metal_driver_query_available_devices,
+    .create_device = iree_hal_metal_driver_create_device,
+};
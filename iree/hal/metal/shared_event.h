@@ -0,0 +1,45 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_METAL_SHARED_EVENT_H_
+#define IREE_HAL_METAL_SHARED_EVENT_H_
+
+#import <Metal/Metal.h>
+
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Creates a timeline semaphore backed by a MTLSharedEvent on |device|.
+// Host waits are resolved with notifications delivered through |listener|.
+iree_status_t iree_hal_metal_shared_event_create(
+    id<MTLDevice> device, MTLSharedEventListener* listener,
+    uint64_t initial_value, iree_allocator_t host_allocator,
+    iree_hal_semaphore_t** out_semaphore);
+
+// Encodes a device wait on |semaphore| reaching |value| into
+// |command_buffer|. Work encoded after the wait does not start until the
+// value is signaled.
+iree_status_t iree_hal_metal_shared_event_encode_wait(
+    iree_hal_semaphore_t* semaphore, uint64_t value,
+    id<MTLCommandBuffer> command_buffer);
+
+// Encodes a device signal of |semaphore| to |value| into |command_buffer|
+// once all prior work in it has completed.
+iree_status_t iree_hal_metal_shared_event_encode_signal(
+    iree_hal_semaphore_t* semaphore, uint64_t value,
+    id<MTLCommandBuffer> command_buffer);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_METAL_SHARED_EVENT_H_
@@ -0,0 +1,213 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#import "iree/hal/metal/shared_event.h"
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+
+// Payload value the event is set to when the semaphore fails so that all
+// device and host waits are released. The failure is sticky and reported to
+// anyone querying the semaphore.
+#define IREE_HAL_METAL_SHARED_EVENT_FAILURE_VALUE ((uint64_t)INT64_MAX)
+
+typedef struct iree_hal_metal_shared_event_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  id<MTLSharedEvent> event;
+  // Listener shared across all semaphores of a device used to deliver
+  // notifications to waiting host threads.
+  MTLSharedEventListener* listener;
+
+  // Guards |failure_status|.
+  iree_slim_mutex_t mutex;
+  // Sticky failure status set by iree_hal_semaphore_fail, if any.
+  iree_status_t failure_status;
+} iree_hal_metal_shared_event_t;
+
+extern const iree_hal_semaphore_vtable_t iree_hal_metal_shared_event_vtable;
+
+static iree_hal_metal_shared_event_t* iree_hal_metal_shared_event_cast(
+    iree_hal_semaphore_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_metal_shared_event_vtable);
+  return (iree_hal_metal_shared_event_t*)base_value;
+}
+
+iree_status_t iree_hal_metal_shared_event_create(
+    id<MTLDevice> device, MTLSharedEventListener* listener,
+    uint64_t initial_value, iree_allocator_t host_allocator,
+    iree_hal_semaphore_t** out_semaphore) {
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(listener);
+  IREE_ASSERT_ARGUMENT(out_semaphore);
+  *out_semaphore = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  id<MTLSharedEvent> event = [device newSharedEvent];
+  if (!event) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "unable to create MTLSharedEvent");
+  }
+  event.signaledValue = initial_value;
+
+  iree_hal_metal_shared_event_t* semaphore = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, sizeof(*semaphore), (void**)&semaphore);
+  if (iree_status_is_ok(status)) {
+    iree_hal_resource_initialize(&iree_hal_metal_shared_event_vtable,
+                                 &semaphore->resource);
+    semaphore->host_allocator = host_allocator;
+    semaphore->event = event;
+    semaphore->listener = [listener retain];
+    iree_slim_mutex_initialize(&semaphore->mutex);
+    semaphore->failure_status = iree_ok_status();
+    *out_semaphore = (iree_hal_semaphore_t*)semaphore;
+  } else {
+    [event release];
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_metal_shared_event_destroy(
+    iree_hal_semaphore_t* base_semaphore) {
+  iree_hal_metal_shared_event_t* semaphore =
+      iree_hal_metal_shared_event_cast(base_semaphore);
+  iree_allocator_t host_allocator = semaphore->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_status_ignore(semaphore->failure_status);
+  iree_slim_mutex_deinitialize(&semaphore->mutex);
+  [semaphore->listener release];
+  [semaphore->event release];
+  iree_allocator_free(host_allocator, semaphore);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static iree_status_t iree_hal_metal_shared_event_query(
+    iree_hal_semaphore_t* base_semaphore, uint64_t* out_value) {
+  iree_hal_metal_shared_event_t* semaphore =
+      iree_hal_metal_shared_event_cast(base_semaphore);
+  iree_slim_mutex_lock(&semaphore->mutex);
+  *out_value = semaphore->event.signaledValue;
+  iree_status_t status = iree_status_clone(semaphore->failure_status);
+  iree_slim_mutex_unlock(&semaphore->mutex);
+  return status;
+}
+
+static iree_status_t iree_hal_metal_shared_event_signal(
+    iree_hal_semaphore_t* base_semaphore, uint64_t new_value) {
+  iree_hal_metal_shared_event_t* semaphore =
+      iree_hal_metal_shared_event_cast(base_semaphore);
+  iree_slim_mutex_lock(&semaphore->mutex);
+  iree_status_t status = iree_status_clone(semaphore->failure_status);
+  uint64_t current_value = semaphore->event.signaledValue;
+  if (iree_status_is_ok(status) && new_value <= current_value) {
+    status = iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                              "semaphore values must be monotonically "
+                              "increasing; current_value=%" PRIu64
+                              ", new_value=%" PRIu64,
+                              current_value, new_value);
+  }
+  if (iree_status_is_ok(status)) {
+    // Setting the value releases device waits and notifies the listener.
+    semaphore->event.signaledValue = new_value;
+  }
+  iree_slim_mutex_unlock(&semaphore->mutex);
+  return status;
+}
+
+static void iree_hal_metal_shared_event_fail(
+    iree_hal_semaphore_t* base_semaphore, iree_status_t status) {
+  iree_hal_metal_shared_event_t* semaphore =
+      iree_hal_metal_shared_event_cast(base_semaphore);
+  iree_slim_mutex_lock(&semaphore->mutex);
+  if (iree_status_is_ok(semaphore->failure_status)) {
+    semaphore->failure_status = status;
+    // Release device and host waits so that nothing hangs on the failure.
+    semaphore->event.signaledValue = IREE_HAL_METAL_SHARED_EVENT_FAILURE_VALUE;
+  } else {
+    iree_status_ignore(status);
+  }
+  iree_slim_mutex_unlock(&semaphore->mutex);
+}
+
+static iree_status_t iree_hal_metal_shared_event_wait(
+    iree_hal_semaphore_t* base_semaphore, uint64_t value,
+    iree_timeout_t timeout) {
+  iree_hal_metal_shared_event_t* semaphore =
+      iree_hal_metal_shared_event_cast(base_semaphore);
+  iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
+
+  if (semaphore->event.signaledValue < value) {
+    if (deadline_ns == IREE_TIME_INFINITE_PAST) {
+      return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+    }
+    IREE_TRACE_ZONE_BEGIN(z0);
+
+    // The listener invokes the block on its dispatch queue once the value is
+    // reached, including when it was reached between the check above and the
+    // registration.
+    dispatch_semaphore_t signaled = dispatch_semaphore_create(0);
+    [semaphore->event notifyListener:semaphore->listener
+                             atValue:value
+                               block:^(id<MTLSharedEvent> event,
+                                       uint64_t signaled_value) {
+                                 dispatch_semaphore_signal(signaled);
+                               }];
+    dispatch_time_t dispatch_deadline = DISPATCH_TIME_FOREVER;
+    if (deadline_ns != IREE_TIME_INFINITE_FUTURE) {
+      iree_time_t now_ns = iree_time_now();
+      dispatch_deadline = dispatch_time(
+          DISPATCH_TIME_NOW, deadline_ns > now_ns ? deadline_ns - now_ns : 0);
+    }
+    long timed_out = dispatch_semaphore_wait(signaled, dispatch_deadline);
+    dispatch_release(signaled);
+
+    IREE_TRACE_ZONE_END(z0);
+    if (timed_out) {
+      return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+    }
+  }
+
+  iree_slim_mutex_lock(&semaphore->mutex);
+  iree_status_t status = iree_status_clone(semaphore->failure_status);
+  iree_slim_mutex_unlock(&semaphore->mutex);
+  return status;
+}
+
+iree_status_t iree_hal_metal_shared_event_encode_wait(
+    iree_hal_semaphore_t* base_semaphore, uint64_t value,
+    id<MTLCommandBuffer> command_buffer) {
+  iree_hal_metal_shared_event_t* semaphore =
+      iree_hal_metal_shared_event_cast(base_semaphore);
+  [command_buffer encodeWaitForEvent:semaphore->event value:value];
+  return iree_ok_status();
+}
+
+iree_status_t iree_hal_metal_shared_event_encode_signal(
+    iree_hal_semaphore_t* base_semaphore, uint64_t value,
+    id<MTLCommandBuffer> command_buffer) {
+  iree_hal_metal_shared_event_t* semaphore =
+      iree_hal_metal_shared_event_cast(base_semaphore);
+  [command_buffer encodeSignalEvent:semaphore->event value:value];
+  return iree_ok_status();
+}
+
+const iree_hal_semaphore_vtable_t iree_hal_metal_shared_event_vtable = {
+    .destroy = iree_hal_metal_shared_event_destroy,
+    .query = iree_hal_metal_shared_event_query,
+    .signal = iree_hal_metal_shared_event_signal,
+    .fail = iree_hal_metal_shared_event_fail,
+    .wait = iree_hal_metal_shared_event_wait,
+};
@@ -136,6 +136,7 @@ typedef struct iree_hal_deferred_command_buffer_t {
   iree_allocator_t host_allocator;
   iree_hal_command_buffer_mode_t mode;
   iree_hal_command_category_t allowed_categories;
+  iree_hal_deferred_command_buffer_flags_t flags;
   iree_hal_cmd_list_t cmd_list;
 } iree_hal_deferred_command_buffer_t;
 
@@ -151,6 +152,7 @@ iree_hal_deferred_command_buffer_cast(iree_hal_command_buffer_t* base_value) {
 IREE_API_EXPORT iree_status_t iree_hal_deferred_command_buffer_create(
     iree_hal_command_buffer_mode_t mode,
     iree_hal_command_category_t command_categories,
+    iree_hal_deferred_command_buffer_flags_t flags,
     iree_arena_block_pool_t* block_pool, iree_allocator_t host_allocator,
     iree_hal_command_buffer_t** out_command_buffer) {
   IREE_ASSERT_ARGUMENT(block_pool);
@@ -167,6 +169,7 @@ IREE_API_EXPORT iree_status_t iree_hal_deferred_command_buffer_create(
     command_buffer->host_allocator = host_allocator;
     command_buffer->mode = mode;
     command_buffer->allowed_categories = command_categories;
+    command_buffer->flags = flags;
     iree_hal_cmd_list_initialize(block_pool, &command_buffer->cmd_list);
   }
 
@@ -205,8 +208,16 @@ static iree_status_t iree_hal_deferred_command_buffer_begin(
   return iree_ok_status();
 }
 
+static iree_status_t iree_hal_cmd_list_optimize(iree_hal_cmd_list_t* cmd_list);
+
 static iree_status_t iree_hal_deferred_command_buffer_end(
     iree_hal_command_buffer_t* base_command_buffer) {
+  iree_hal_deferred_command_buffer_t* command_buffer =
+      iree_hal_deferred_command_buffer_cast(base_command_buffer);
+  if (iree_all_bits_set(command_buffer->flags,
+                        IREE_HAL_DEFERRED_COMMAND_BUFFER_FLAG_OPTIMIZE)) {
+    return iree_hal_cmd_list_optimize(&command_buffer->cmd_list);
+  }
   return iree_ok_status();
 }
 
@@ -451,6 +462,7 @@ static iree_status_t iree_hal_deferred_command_buffer_fill_buffer(
   cmd->target_buffer = target_buffer;
   cmd->target_offset = target_offset;
   cmd->length = length;
+  cmd->pattern = 0;  // compared as a whole when coalescing fills
   memcpy(&cmd->pattern, pattern, pattern_length);
   cmd->pattern_length = pattern_length;
   return iree_ok_status();
@@ -734,6 +746,352 @@ static iree_status_t iree_hal_deferred_command_buffer_apply_dispatch_indirect(
       cmd->workgroups_buffer, cmd->workgroups_offset);
 }
 
+//===----------------------------------------------------------------------===//
+// Command list optimization
+//===----------------------------------------------------------------------===//
+
+// Maximum number of dispatches within a single barrier-free region that will
+// be considered for reordering. Longer regions are reordered in chunks.
+#define IREE_HAL_CMD_MAX_REORDER_DISPATCHES 64
+
+static bool iree_hal_cmd_is_dispatch(const iree_hal_cmd_header_t* cmd) {
+  return cmd->type == IREE_HAL_CMD_DISPATCH ||
+         cmd->type == IREE_HAL_CMD_DISPATCH_INDIRECT;
+}
+
+static bool iree_hal_cmd_is_push(const iree_hal_cmd_header_t* cmd) {
+  return cmd->type == IREE_HAL_CMD_PUSH_CONSTANTS ||
+         cmd->type == IREE_HAL_CMD_PUSH_DESCRIPTOR_SET ||
+         cmd->type == IREE_HAL_CMD_BIND_DESCRIPTOR_SET;
+}
+
+// Returns the descriptor set updated by a push/bind descriptor set |cmd|.
+static void iree_hal_cmd_query_descriptor_set(
+    const iree_hal_cmd_header_t* cmd,
+    iree_hal_executable_layout_t** out_executable_layout, uint32_t* out_set) {
+  if (cmd->type == IREE_HAL_CMD_PUSH_DESCRIPTOR_SET) {
+    const iree_hal_cmd_push_descriptor_set_t* push_cmd =
+        (const iree_hal_cmd_push_descriptor_set_t*)cmd;
+    *out_executable_layout = push_cmd->executable_layout;
+    *out_set = push_cmd->set;
+  } else {
+    const iree_hal_cmd_bind_descriptor_set_t* bind_cmd =
+        (const iree_hal_cmd_bind_descriptor_set_t*)cmd;
+    *out_executable_layout = bind_cmd->executable_layout;
+    *out_set = bind_cmd->set;
+  }
+}
+
+// Returns true if the state updated by the push |cmd| is fully replaced by
+// |later_cmd| without being observed.
+static bool iree_hal_cmd_push_is_overwritten(
+    const iree_hal_cmd_header_t* cmd, const iree_hal_cmd_header_t* later_cmd) {
+  if (cmd->type == IREE_HAL_CMD_PUSH_CONSTANTS) {
+    if (later_cmd->type != IREE_HAL_CMD_PUSH_CONSTANTS) return false;
+    const iree_hal_cmd_push_constants_t* push_cmd =
+        (const iree_hal_cmd_push_constants_t*)cmd;
+    const iree_hal_cmd_push_constants_t* later_push_cmd =
+        (const iree_hal_cmd_push_constants_t*)later_cmd;
+    return push_cmd->executable_layout == later_push_cmd->executable_layout &&
+           push_cmd->offset >= later_push_cmd->offset &&
+           push_cmd->offset + push_cmd->values_length <=
+               later_push_cmd->offset + later_push_cmd->values_length;
+  }
+  if (later_cmd->type == IREE_HAL_CMD_PUSH_CONSTANTS) return false;
+  iree_hal_executable_layout_t* executable_layout = NULL;
+  uint32_t set = 0;
+  iree_hal_cmd_query_descriptor_set(cmd, &executable_layout, &set);
+  iree_hal_executable_layout_t* later_executable_layout = NULL;
+  uint32_t later_set = 0;
+  iree_hal_cmd_query_descriptor_set(later_cmd, &later_executable_layout,
+                                    &later_set);
+  return executable_layout == later_executable_layout && set == later_set;
+}
+
+// Returns true if the state updated by the push |cmd| is observed by a
+// dispatch before being overwritten. Pushed state does not persist beyond the
+// command buffer so updates following the last dispatch are never observed.
+static bool iree_hal_cmd_push_is_observed(const iree_hal_cmd_header_t* cmd) {
+  for (const iree_hal_cmd_header_t* later_cmd = cmd->next; later_cmd;
+       later_cmd = later_cmd->next) {
+    if (iree_hal_cmd_is_dispatch(later_cmd)) return true;
+    if (iree_hal_cmd_is_push(later_cmd) &&
+        iree_hal_cmd_push_is_overwritten(cmd, later_cmd)) {
+      return false;
+    }
+  }
+  return false;
+}
+
+// Drops all push constant and descriptor set updates that are not observed by
+// any dispatch.
+static void iree_hal_cmd_list_drop_dead_pushes(iree_hal_cmd_list_t* cmd_list) {
+  iree_hal_cmd_header_t** link = &cmd_list->head;
+  while (*link) {
+    iree_hal_cmd_header_t* cmd = *link;
+    if (iree_hal_cmd_is_push(cmd) && !iree_hal_cmd_push_is_observed(cmd)) {
+      *link = cmd->next;
+    } else {
+      link = &cmd->next;
+    }
+  }
+}
+
+// A dispatch and the pushes recorded immediately prior to it.
+typedef struct iree_hal_cmd_dispatch_group_t {
+  iree_hal_cmd_header_t* head;
+  iree_hal_cmd_header_t* tail;
+  // Executable entry point dispatched used to cluster groups.
+  iree_hal_executable_t* executable;
+  int32_t entry_point;
+  // Summary of the state updated by the pushes in the group. Groups may only
+  // be reordered if they all update exactly the same state.
+  iree_hal_executable_layout_t* executable_layout;
+  uint32_t set_mask;
+  iree_host_size_t constants_offset;
+  iree_host_size_t constants_length;
+  bool is_valid;
+} iree_hal_cmd_dispatch_group_t;
+
+// Populates |out_group| with the pushes starting at |head| and the dispatch
+// that follows them. Returns false if the commands do not form a group.
+static bool iree_hal_cmd_dispatch_group_initialize(
+    iree_hal_cmd_header_t* head, iree_hal_cmd_dispatch_group_t* out_group) {
+  memset(out_group, 0, sizeof(*out_group));
+  out_group->head = head;
+  iree_host_size_t constants_push_count = 0;
+  for (iree_hal_cmd_header_t* cmd = head; cmd; cmd = cmd->next) {
+    if (iree_hal_cmd_is_dispatch(cmd)) {
+      if (cmd->type == IREE_HAL_CMD_DISPATCH) {
+        const iree_hal_cmd_dispatch_t* dispatch_cmd =
+            (const iree_hal_cmd_dispatch_t*)cmd;
+        out_group->executable = dispatch_cmd->executable;
+        out_group->entry_point = dispatch_cmd->entry_point;
+      } else {
+        const iree_hal_cmd_dispatch_indirect_t* dispatch_cmd =
+            (const iree_hal_cmd_dispatch_indirect_t*)cmd;
+        out_group->executable = dispatch_cmd->executable;
+        out_group->entry_point = dispatch_cmd->entry_point;
+      }
+      out_group->tail = cmd;
+      return constants_push_count <= 1;
+    } else if (!iree_hal_cmd_is_push(cmd)) {
+      return false;
+    }
+    iree_hal_executable_layout_t* executable_layout = NULL;
+    if (cmd->type == IREE_HAL_CMD_PUSH_CONSTANTS) {
+      const iree_hal_cmd_push_constants_t* push_cmd =
+          (const iree_hal_cmd_push_constants_t*)cmd;
+      executable_layout = push_cmd->executable_layout;
+      out_group->constants_offset = push_cmd->offset;
+      out_group->constants_length = push_cmd->values_length;
+      ++constants_push_count;
+    } else {
+      uint32_t set = 0;
+      iree_hal_cmd_query_descriptor_set(cmd, &executable_layout, &set);
+      if (set >= 32) return false;
+      out_group->set_mask |= 1u << set;
+    }
+    if (out_group->executable_layout &&
+        out_group->executable_layout != executable_layout) {
+      return false;
+    }
+    out_group->executable_layout = executable_layout;
+  }
+  return false;
+}
+
+static bool iree_hal_cmd_dispatch_group_state_equal(
+    const iree_hal_cmd_dispatch_group_t* lhs,
+    const iree_hal_cmd_dispatch_group_t* rhs) {
+  return lhs->executable_layout == rhs->executable_layout &&
+         lhs->set_mask == rhs->set_mask &&
+         lhs->constants_offset == rhs->constants_offset &&
+         lhs->constants_length == rhs->constants_length;
+}
+
+// Reorders the dispatches within each region of the command list that is not
+// separated by barriers or events such that dispatches of the same executable
+// entry point are adjacent. Dispatches within a region have no ordering
+// requirements between them and only the state they observe must be
+// preserved: this is guaranteed by only reordering when every dispatch is
+// preceded by pushes that update the same state.
+static void iree_hal_cmd_list_cluster_dispatches(
+    iree_hal_cmd_list_t* cmd_list) {
+  iree_hal_cmd_dispatch_group_t groups[IREE_HAL_CMD_MAX_REORDER_DISPATCHES];
+  bool is_placed[IREE_HAL_CMD_MAX_REORDER_DISPATCHES];
+  iree_host_size_t order[IREE_HAL_CMD_MAX_REORDER_DISPATCHES];
+  iree_hal_cmd_header_t** link = &cmd_list->head;
+  while (*link) {
+    // Gather the dispatch groups of the region starting at |link|.
+    iree_host_size_t group_count = 0;
+    bool is_uniform = true;
+    iree_hal_cmd_header_t* head = *link;
+    while (group_count < IREE_ARRAYSIZE(groups) &&
+           iree_hal_cmd_dispatch_group_initialize(head,
+                                                  &groups[group_count])) {
+      if (group_count > 0 && !iree_hal_cmd_dispatch_group_state_equal(
+                                 &groups[0], &groups[group_count])) {
+        is_uniform = false;
+      }
+      head = groups[group_count].tail->next;
+      ++group_count;
+    }
+    if (group_count == 0) {
+      link = &(*link)->next;
+      continue;
+    }
+    iree_hal_cmd_header_t* region_next = groups[group_count - 1].tail->next;
+    if (!is_uniform) {
+      link = &groups[group_count - 1].tail->next;
+      continue;
+    }
+
+    // Stable cluster by first appearance of each entry point.
+    iree_host_size_t order_count = 0;
+    memset(is_placed, 0, sizeof(is_placed));
+    for (iree_host_size_t i = 0; i < group_count; ++i) {
+      if (is_placed[i]) continue;
+      for (iree_host_size_t j = i; j < group_count; ++j) {
+        if (is_placed[j] || groups[j].executable != groups[i].executable ||
+            groups[j].entry_point != groups[i].entry_point) {
+          continue;
+        }
+        is_placed[j] = true;
+        order[order_count++] = j;
+      }
+    }
+
+    // Relink the groups in their new order.
+    for (iree_host_size_t i = 0; i < order_count; ++i) {
+      *link = groups[order[i]].head;
+      link = &groups[order[i]].tail->next;
+    }
+    *link = region_next;
+  }
+}
+
+// Coalesces fills and copies of contiguous ranges that are recorded
+// back-to-back into a single fill or copy. As there is no barrier between them
+// they were already allowed to execute concurrently.
+static void iree_hal_cmd_list_coalesce_transfers(
+    iree_hal_cmd_list_t* cmd_list) {
+  for (iree_hal_cmd_header_t* cmd = cmd_list->head; cmd; cmd = cmd->next) {
+    while (cmd->next && cmd->next->type == cmd->type) {
+      if (cmd->type == IREE_HAL_CMD_FILL_BUFFER) {
+        iree_hal_cmd_fill_buffer_t* fill_cmd = (iree_hal_cmd_fill_buffer_t*)cmd;
+        const iree_hal_cmd_fill_buffer_t* next_cmd =
+            (const iree_hal_cmd_fill_buffer_t*)cmd->next;
+        if (fill_cmd->target_buffer != next_cmd->target_buffer ||
+            fill_cmd->pattern_length != next_cmd->pattern_length ||
+            fill_cmd->pattern != next_cmd->pattern ||
+            fill_cmd->length % fill_cmd->pattern_length != 0 ||
+            fill_cmd->target_offset + fill_cmd->length !=
+                next_cmd->target_offset) {
+          break;
+        }
+        fill_cmd->length += next_cmd->length;
+      } else if (cmd->type == IREE_HAL_CMD_COPY_BUFFER) {
+        iree_hal_cmd_copy_buffer_t* copy_cmd = (iree_hal_cmd_copy_buffer_t*)cmd;
+        const iree_hal_cmd_copy_buffer_t* next_cmd =
+            (const iree_hal_cmd_copy_buffer_t*)cmd->next;
+        if (copy_cmd->source_buffer != next_cmd->source_buffer ||
+            copy_cmd->target_buffer != next_cmd->target_buffer ||
+            copy_cmd->source_offset + copy_cmd->length !=
+                next_cmd->source_offset ||
+            copy_cmd->target_offset + copy_cmd->length !=
+                next_cmd->target_offset) {
+          break;
+        }
+        copy_cmd->length += next_cmd->length;
+      } else {
+        break;
+      }
+      cmd->next = cmd->next->next;
+    }
+  }
+}
+
+// Concatenates two arrays into a new array allocated from the command list.
+// Reuses either array if the other is empty.
+static iree_status_t iree_hal_cmd_list_concat_data(
+    iree_hal_cmd_list_t* cmd_list, const void* lhs_data,
+    iree_host_size_t lhs_length, const void* rhs_data,
+    iree_host_size_t rhs_length, const void** out_data) {
+  if (!rhs_length) {
+    *out_data = lhs_data;
+    return iree_ok_status();
+  } else if (!lhs_length) {
+    *out_data = rhs_data;
+    return iree_ok_status();
+  }
+  uint8_t* data = NULL;
+  IREE_RETURN_IF_ERROR(iree_arena_allocate(
+      &cmd_list->arena, lhs_length + rhs_length, (void**)&data));
+  memcpy(data, lhs_data, lhs_length);
+  memcpy(data + lhs_length, rhs_data, rhs_length);
+  *out_data = data;
+  return iree_ok_status();
+}
+
+// Merges execution barriers with no commands between them into one barrier
+// covering the stages and memory of all of them.
+static iree_status_t iree_hal_cmd_list_merge_barriers(
+    iree_hal_cmd_list_t* cmd_list) {
+  for (iree_hal_cmd_header_t* cmd = cmd_list->head; cmd; cmd = cmd->next) {
+    if (cmd->type != IREE_HAL_CMD_EXECUTION_BARRIER) continue;
+    iree_hal_cmd_execution_barrier_t* barrier_cmd =
+        (iree_hal_cmd_execution_barrier_t*)cmd;
+    while (cmd->next && cmd->next->type == IREE_HAL_CMD_EXECUTION_BARRIER) {
+      const iree_hal_cmd_execution_barrier_t* next_cmd =
+          (const iree_hal_cmd_execution_barrier_t*)cmd->next;
+      if (barrier_cmd->flags != next_cmd->flags) break;
+      IREE_RETURN_IF_ERROR(iree_hal_cmd_list_concat_data(
+          cmd_list, barrier_cmd->memory_barriers,
+          sizeof(barrier_cmd->memory_barriers[0]) *
+              barrier_cmd->memory_barrier_count,
+          next_cmd->memory_barriers,
+          sizeof(next_cmd->memory_barriers[0]) * next_cmd->memory_barrier_count,
+          (const void**)&barrier_cmd->memory_barriers));
+      barrier_cmd->memory_barrier_count += next_cmd->memory_barrier_count;
+      IREE_RETURN_IF_ERROR(iree_hal_cmd_list_concat_data(
+          cmd_list, barrier_cmd->buffer_barriers,
+          sizeof(barrier_cmd->buffer_barriers[0]) *
+              barrier_cmd->buffer_barrier_count,
+          next_cmd->buffer_barriers,
+          sizeof(next_cmd->buffer_barriers[0]) * next_cmd->buffer_barrier_count,
+          (const void**)&barrier_cmd->buffer_barriers));
+      barrier_cmd->buffer_barrier_count += next_cmd->buffer_barrier_count;
+      barrier_cmd->source_stage_mask |= next_cmd->source_stage_mask;
+      barrier_cmd->target_stage_mask |= next_cmd->target_stage_mask;
+      cmd->next = cmd->next->next;
+    }
+  }
+  return iree_ok_status();
+}
+
+// Optimizes the recorded commands in |cmd_list| in place.
+// See IREE_HAL_DEFERRED_COMMAND_BUFFER_FLAG_OPTIMIZE.
+static iree_status_t iree_hal_cmd_list_optimize(iree_hal_cmd_list_t* cmd_list) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Dropping pushes first allows more dispatches to be clustered and more
+  // barriers to become adjacent.
+  iree_hal_cmd_list_drop_dead_pushes(cmd_list);
+  iree_hal_cmd_list_cluster_dispatches(cmd_list);
+  iree_hal_cmd_list_coalesce_transfers(cmd_list);
+  iree_status_t status = iree_hal_cmd_list_merge_barriers(cmd_list);
+
+  // Commands may have been removed from the end of the list.
+  cmd_list->tail = cmd_list->head;
+  while (cmd_list->tail && cmd_list->tail->next) {
+    cmd_list->tail = cmd_list->tail->next;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 //===----------------------------------------------------------------------===//
 // Dynamic replay dispatch
 //===----------------------------------------------------------------------===//
@@ -16,6 +16,26 @@ extern "C" {
 
 typedef struct iree_arena_block_pool_t iree_arena_block_pool_t;
 
+// Controls how a deferred command buffer processes its recorded commands.
+enum iree_hal_deferred_command_buffer_flag_bits_t {
+  IREE_HAL_DEFERRED_COMMAND_BUFFER_FLAG_NONE = 0u,
+
+  // Optimizes the recorded commands once recording ends such that replay
+  // issues fewer and better-ordered commands to the target command buffer:
+  //  - descriptor set and push constant updates that no dispatch observes are
+  //    dropped;
+  //  - dispatches between barriers that update the same state are clustered
+  //    by executable entry point;
+  //  - fills and copies of contiguous ranges recorded back-to-back are
+  //    coalesced;
+  //  - adjacent execution barriers are merged.
+  // The target command buffer will observe a different (but equivalent)
+  // sequence of commands than was recorded and as such this should not be used
+  // when replaying to debug or benchmark the recorded command buffer.
+  IREE_HAL_DEFERRED_COMMAND_BUFFER_FLAG_OPTIMIZE = 1u << 0,
+};
+typedef uint32_t iree_hal_deferred_command_buffer_flags_t;
+
 //===----------------------------------------------------------------------===//
 // iree_hal_command_buffer_t deferred record/replay wrapper
 //===----------------------------------------------------------------------===//
@@ -42,9 +62,13 @@ typedef struct iree_arena_block_pool_t iree_arena_block_pool_t;
 // After recording iree_hal_deferred_command_buffer_apply can be used to replay
 // the sequence of commands against a target command buffer implementation.
 // The command buffer can be replayed multiple times.
+//
+// |flags| controls whether the recorded commands are optimized prior to
+// replay. See iree_hal_deferred_command_buffer_flag_bits_t.
 IREE_API_EXPORT iree_status_t iree_hal_deferred_command_buffer_create(
     iree_hal_command_buffer_mode_t mode,
     iree_hal_command_category_t command_categories,
+    iree_hal_deferred_command_buffer_flags_t flags,
     iree_arena_block_pool_t* block_pool, iree_allocator_t host_allocator,
     iree_hal_command_buffer_t** out_command_buffer);
 
@@ -0,0 +1,301 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/deferred_command_buffer.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/arena.h"
+#include "iree/hal/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+using ::testing::ElementsAre;
+
+// Command buffer that logs the commands replayed into it. Resources passed to
+// it are opaque handles and never dereferenced.
+struct RecordingCommandBuffer {
+  iree_hal_resource_t resource;
+  std::vector<std::string> log;
+
+  static RecordingCommandBuffer* Cast(
+      iree_hal_command_buffer_t* command_buffer) {
+    return reinterpret_cast<RecordingCommandBuffer*>(command_buffer);
+  }
+
+  static void Destroy(iree_hal_command_buffer_t* command_buffer) {}
+
+  static iree_hal_command_buffer_mode_t Mode(
+      const iree_hal_command_buffer_t* command_buffer) {
+    return IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT;
+  }
+
+  static iree_hal_command_category_t AllowedCategories(
+      const iree_hal_command_buffer_t* command_buffer) {
+    return IREE_HAL_COMMAND_CATEGORY_ANY;
+  }
+
+  static iree_status_t Begin(iree_hal_command_buffer_t* command_buffer) {
+    return iree_ok_status();
+  }
+
+  static iree_status_t End(iree_hal_command_buffer_t* command_buffer) {
+    return iree_ok_status();
+  }
+
+  static iree_status_t ExecutionBarrier(
+      iree_hal_command_buffer_t* command_buffer,
+      iree_hal_execution_stage_t source_stage_mask,
+      iree_hal_execution_stage_t target_stage_mask,
+      iree_hal_execution_barrier_flags_t flags,
+      iree_host_size_t memory_barrier_count,
+      const iree_hal_memory_barrier_t* memory_barriers,
+      iree_host_size_t buffer_barrier_count,
+      const iree_hal_buffer_barrier_t* buffer_barriers) {
+    Cast(command_buffer)
+        ->log.push_back("barrier(" + std::to_string(source_stage_mask) + ", " +
+                        std::to_string(target_stage_mask) + ", " +
+                        std::to_string(memory_barrier_count) + ")");
+    return iree_ok_status();
+  }
+
+  static iree_status_t FillBuffer(iree_hal_command_buffer_t* command_buffer,
+                                  iree_hal_buffer_t* target_buffer,
+                                  iree_device_size_t target_offset,
+                                  iree_device_size_t length,
+                                  const void* pattern,
+                                  iree_host_size_t pattern_length) {
+    Cast(command_buffer)
+        ->log.push_back("fill(" + std::to_string(target_offset) + ", " +
+                        std::to_string(length) + ")");
+    return iree_ok_status();
+  }
+
+  static iree_status_t CopyBuffer(iree_hal_command_buffer_t* command_buffer,
+                                  iree_hal_buffer_t* source_buffer,
+                                  iree_device_size_t source_offset,
+                                  iree_hal_buffer_t* target_buffer,
+                                  iree_device_size_t target_offset,
+                                  iree_device_size_t length) {
+    Cast(command_buffer)
+        ->log.push_back("copy(" + std::to_string(source_offset) + ", " +
+                        std::to_string(target_offset) + ", " +
+                        std::to_string(length) + ")");
+    return iree_ok_status();
+  }
+
+  static iree_status_t PushConstants(
+      iree_hal_command_buffer_t* command_buffer,
+      iree_hal_executable_layout_t* executable_layout, iree_host_size_t offset,
+      const void* values, iree_host_size_t values_length) {
+    uint32_t value = 0;
+    memcpy(&value, values, sizeof(value));
+    Cast(command_buffer)->log.push_back("push(" + std::to_string(value) + ")");
+    return iree_ok_status();
+  }
+
+  static iree_status_t Dispatch(iree_hal_command_buffer_t* command_buffer,
+                                iree_hal_executable_t* executable,
+                                int32_t entry_point, uint32_t workgroup_x,
+                                uint32_t workgroup_y, uint32_t workgroup_z) {
+    Cast(command_buffer)
+        ->log.push_back("dispatch(" + std::to_string(entry_point) + ")");
+    return iree_ok_status();
+  }
+
+  static const iree_hal_command_buffer_vtable_t* vtable() {
+    static const iree_hal_command_buffer_vtable_t vtable = [] {
+      iree_hal_command_buffer_vtable_t vtable;
+      memset(&vtable, 0, sizeof(vtable));
+      vtable.destroy = Destroy;
+      vtable.mode = Mode;
+      vtable.allowed_categories = AllowedCategories;
+      vtable.begin = Begin;
+      vtable.end = End;
+      vtable.execution_barrier = ExecutionBarrier;
+      vtable.fill_buffer = FillBuffer;
+      vtable.copy_buffer = CopyBuffer;
+      vtable.push_constants = PushConstants;
+      vtable.dispatch = Dispatch;
+      return vtable;
+    }();
+    return &vtable;
+  }
+
+  RecordingCommandBuffer() {
+    iree_hal_resource_initialize(vtable(), &resource);
+  }
+
+  iree_hal_command_buffer_t* get() {
+    return reinterpret_cast<iree_hal_command_buffer_t*>(this);
+  }
+};
+
+class DeferredCommandBufferTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    iree_arena_block_pool_initialize(4096, iree_allocator_system(),
+                                     &block_pool_);
+  }
+
+  void TearDown() override {
+    iree_hal_command_buffer_release(command_buffer_);
+    iree_arena_block_pool_deinitialize(&block_pool_);
+  }
+
+  // Creates |command_buffer_| and begins recording.
+  void Begin(iree_hal_deferred_command_buffer_flags_t flags) {
+    IREE_ASSERT_OK(iree_hal_deferred_command_buffer_create(
+        /*mode=*/0, IREE_HAL_COMMAND_CATEGORY_ANY, flags, &block_pool_,
+        iree_allocator_system(), &command_buffer_));
+    IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer_));
+  }
+
+  // Ends recording and returns the commands replayed.
+  std::vector<std::string> EndAndReplay() {
+    IREE_CHECK_OK(iree_hal_command_buffer_end(command_buffer_));
+    RecordingCommandBuffer target;
+    IREE_CHECK_OK(
+        iree_hal_deferred_command_buffer_apply(command_buffer_, target.get()));
+    return target.log;
+  }
+
+  void PushConstant(uint32_t value) {
+    IREE_ASSERT_OK(iree_hal_command_buffer_push_constants(
+        command_buffer_, layout(), /*offset=*/0, &value, sizeof(value)));
+  }
+
+  void Dispatch(int32_t entry_point) {
+    IREE_ASSERT_OK(iree_hal_command_buffer_dispatch(
+        command_buffer_, executable(), entry_point, 1, 1, 1));
+  }
+
+  void Barrier(iree_hal_execution_stage_t source_stage_mask,
+               iree_hal_execution_stage_t target_stage_mask) {
+    iree_hal_memory_barrier_t memory_barrier = {
+        IREE_HAL_ACCESS_SCOPE_DISPATCH_WRITE,
+        IREE_HAL_ACCESS_SCOPE_DISPATCH_READ};
+    IREE_ASSERT_OK(iree_hal_command_buffer_execution_barrier(
+        command_buffer_, source_stage_mask, target_stage_mask,
+        IREE_HAL_EXECUTION_BARRIER_FLAG_NONE, 1, &memory_barrier, 0, NULL));
+  }
+
+  // Opaque handles that the deferred command buffer only compares.
+  iree_hal_executable_layout_t* layout() {
+    return reinterpret_cast<iree_hal_executable_layout_t*>(&handles_[0]);
+  }
+  iree_hal_executable_t* executable() {
+    return reinterpret_cast<iree_hal_executable_t*>(&handles_[1]);
+  }
+  iree_hal_buffer_t* buffer(int i) {
+    return reinterpret_cast<iree_hal_buffer_t*>(&handles_[2 + i]);
+  }
+
+  iree_arena_block_pool_t block_pool_;
+  iree_hal_command_buffer_t* command_buffer_ = NULL;
+  int handles_[4] = {0};
+};
+
+// Without the optimize flag commands are replayed exactly as recorded.
+TEST_F(DeferredCommandBufferTest, ReplaysRecordedCommandsByDefault) {
+  Begin(IREE_HAL_DEFERRED_COMMAND_BUFFER_FLAG_NONE);
+  PushConstant(0);
+  PushConstant(1);
+  Dispatch(0);
+  PushConstant(2);
+  Dispatch(1);
+  PushConstant(3);
+  Dispatch(0);
+  PushConstant(4);
+  EXPECT_THAT(EndAndReplay(),
+              ElementsAre("push(0)", "push(1)", "dispatch(0)", "push(2)",
+                          "dispatch(1)", "push(3)", "dispatch(0)", "push(4)"));
+}
+
+// Push constants overwritten before any dispatch observes them and those
+// following the last dispatch are dropped.
+TEST_F(DeferredCommandBufferTest, DropsDeadPushConstants) {
+  Begin(IREE_HAL_DEFERRED_COMMAND_BUFFER_FLAG_OPTIMIZE);
+  PushConstant(0);
+  PushConstant(1);
+  Dispatch(0);
+  PushConstant(2);
+  EXPECT_THAT(EndAndReplay(), ElementsAre("push(1)", "dispatch(0)"));
+}
+
+// Dispatches between barriers that update the same state are clustered by
+// entry point and keep the pushes they observe.
+TEST_F(DeferredCommandBufferTest, ClustersUniformDispatches) {
+  Begin(IREE_HAL_DEFERRED_COMMAND_BUFFER_FLAG_OPTIMIZE);
+  PushConstant(0);
+  Dispatch(0);
+  PushConstant(1);
+  Dispatch(1);
+  PushConstant(2);
+  Dispatch(0);
+  Barrier(IREE_HAL_EXECUTION_STAGE_DISPATCH, IREE_HAL_EXECUTION_STAGE_DISPATCH);
+  // Not reordered across the barrier.
+  PushConstant(3);
+  Dispatch(1);
+  PushConstant(4);
+  Dispatch(0);
+  PushConstant(5);
+  Dispatch(1);
+  // Not reordered as this dispatch observes the constant pushed for the
+  // preceding one.
+  Dispatch(0);
+  EXPECT_THAT(
+      EndAndReplay(),
+      ElementsAre("push(0)", "dispatch(0)", "push(2)", "dispatch(0)", "push(1)",
+                  "dispatch(1)", "barrier(4, 4, 1)", "push(3)", "dispatch(1)",
+                  "push(4)", "dispatch(0)", "push(5)", "dispatch(1)",
+                  "dispatch(0)"));
+}
+
+// Back-to-back fills and copies of contiguous ranges are coalesced.
+TEST_F(DeferredCommandBufferTest, CoalescesTransfers) {
+  Begin(IREE_HAL_DEFERRED_COMMAND_BUFFER_FLAG_OPTIMIZE);
+  uint8_t pattern = 0xCD;
+  IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+      command_buffer_, buffer(0), 0, 16, &pattern, sizeof(pattern)));
+  IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+      command_buffer_, buffer(0), 16, 16, &pattern, sizeof(pattern)));
+  // Not contiguous.
+  IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+      command_buffer_, buffer(0), 64, 16, &pattern, sizeof(pattern)));
+  IREE_ASSERT_OK(iree_hal_command_buffer_copy_buffer(
+      command_buffer_, buffer(0), 0, buffer(1), 32, 16));
+  IREE_ASSERT_OK(iree_hal_command_buffer_copy_buffer(
+      command_buffer_, buffer(0), 16, buffer(1), 48, 16));
+  // Different target buffer.
+  IREE_ASSERT_OK(iree_hal_command_buffer_copy_buffer(
+      command_buffer_, buffer(0), 32, buffer(0), 64, 16));
+  EXPECT_THAT(EndAndReplay(),
+              ElementsAre("fill(0, 32)", "fill(64, 16)", "copy(0, 32, 32)",
+                          "copy(32, 64, 16)"));
+}
+
+// Adjacent execution barriers are merged into one covering all of them.
+TEST_F(DeferredCommandBufferTest, MergesAdjacentBarriers) {
+  Begin(IREE_HAL_DEFERRED_COMMAND_BUFFER_FLAG_OPTIMIZE);
+  PushConstant(0);
+  Dispatch(0);
+  Barrier(IREE_HAL_EXECUTION_STAGE_DISPATCH, IREE_HAL_EXECUTION_STAGE_DISPATCH);
+  Barrier(IREE_HAL_EXECUTION_STAGE_TRANSFER, IREE_HAL_EXECUTION_STAGE_TRANSFER);
+  PushConstant(1);
+  Dispatch(0);
+  EXPECT_THAT(EndAndReplay(),
+              ElementsAre("push(0)", "dispatch(0)", "barrier(12, 12, 2)",
+                          "push(1)", "dispatch(0)"));
+}
+
+}  // namespace
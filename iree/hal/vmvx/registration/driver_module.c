@@ -10,6 +10,7 @@
 #include <stddef.h>
 
 #include "iree/base/api.h"
+#include "iree/base/tracing.h"
 #include "iree/hal/local/executable_loader.h"
 #include "iree/hal/local/loaders/vmvx_module_loader.h"
 #include "iree/hal/local/task_device.h"
@@ -40,16 +41,10 @@ static iree_status_t iree_hal_vmvx_driver_factory_enumerate(
   return iree_ok_status();
 }
 
-static iree_status_t iree_hal_vmvx_driver_factory_try_create(
-    void* self, iree_hal_driver_id_t driver_id, iree_allocator_t allocator,
+// Creates a VMVX driver scheduling work on |executor|.
+static iree_status_t iree_hal_vmvx_driver_create_with_executor(
+    iree_task_executor_t* executor, iree_allocator_t allocator,
     iree_hal_driver_t** out_driver) {
-  if (driver_id != IREE_HAL_VMVX_DRIVER_ID) {
-    return iree_make_status(IREE_STATUS_UNAVAILABLE,
-                            "no driver with ID %016" PRIu64
-                            " is provided by this factory",
-                            driver_id);
-  }
-
   iree_vm_instance_t* instance = NULL;
   IREE_RETURN_IF_ERROR(iree_vm_instance_create(allocator, &instance));
 
@@ -61,23 +56,58 @@ static iree_status_t iree_hal_vmvx_driver_factory_try_create(
       iree_hal_vmvx_module_loader_create(instance, allocator, &vmvx_loader);
   iree_hal_executable_loader_t* loaders[1] = {vmvx_loader};
 
-  iree_task_executor_t* executor = NULL;
-  if (iree_status_is_ok(status)) {
-    status = iree_task_executor_create_from_flags(allocator, &executor);
-  }
-
   if (iree_status_is_ok(status)) {
     status = iree_hal_task_driver_create(
         iree_make_cstring_view("vmvx"), &default_params, executor,
         IREE_ARRAYSIZE(loaders), loaders, allocator, out_driver);
   }
 
-  iree_task_executor_release(executor);
   iree_hal_executable_loader_release(vmvx_loader);
   iree_vm_instance_release(instance);
   return status;
 }
 
+static iree_status_t iree_hal_vmvx_driver_factory_try_create(
+    void* self, iree_hal_driver_id_t driver_id, iree_allocator_t allocator,
+    iree_hal_driver_t** out_driver) {
+  if (driver_id != IREE_HAL_VMVX_DRIVER_ID) {
+    return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                            "no driver with ID %016" PRIu64
+                            " is provided by this factory",
+                            driver_id);
+  }
+
+  iree_task_executor_t* executor = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_task_executor_create_from_flags(allocator, &executor));
+  iree_status_t status = iree_hal_vmvx_driver_create_with_executor(
+      executor, allocator, out_driver);
+  iree_task_executor_release(executor);
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_vmvx_driver_create_with_topology(
+    const iree_task_topology_t* topology, iree_allocator_t allocator,
+    iree_hal_driver_t** out_driver) {
+  IREE_ASSERT_ARGUMENT(topology);
+  IREE_ASSERT_ARGUMENT(out_driver);
+  *out_driver = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, iree_task_topology_group_count(topology));
+
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  iree_task_executor_t* executor = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_task_executor_create(options, topology, allocator, &executor));
+  iree_status_t status = iree_hal_vmvx_driver_create_with_executor(
+      executor, allocator, out_driver);
+  iree_task_executor_release(executor);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 IREE_API_EXPORT iree_status_t
 iree_hal_vmvx_driver_module_register(iree_hal_driver_registry_t* registry) {
   static const iree_hal_driver_factory_t factory = {
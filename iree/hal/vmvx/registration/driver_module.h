@@ -9,6 +9,7 @@
 
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
+#include "iree/task/topology.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -17,6 +18,13 @@ extern "C" {
 IREE_API_EXPORT iree_status_t
 iree_hal_vmvx_driver_module_register(iree_hal_driver_registry_t* registry);
 
+// Creates a VMVX driver whose devices schedule work on a new task executor
+// with workers defined by |topology| instead of the one configured by flags
+// when the driver is created through the registry.
+IREE_API_EXPORT iree_status_t iree_hal_vmvx_driver_create_with_topology(
+    const iree_task_topology_t* topology, iree_allocator_t allocator,
+    iree_hal_driver_t** out_driver);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
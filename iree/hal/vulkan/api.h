@@ -156,17 +156,132 @@ enum iree_hal_vulkan_device_flag_bits_t {
   // May be removed in future versions when timeline semaphores can be assumed
   // present on all platforms (looking at you, Android ಠ_ಠ).
   IREE_HAL_VULKAN_DEVICE_FORCE_TIMELINE_SEMAPHORE_EMULATION = 1u << 0,
+
+  // Defers the creation of the VkPipeline of each executable entry point until
+  // the first dispatch recorded against it. Executables with many entry points
+  // then load in time proportional to the entry points actually used at the
+  // cost of compiling pipelines while recording command buffers.
+  IREE_HAL_VULKAN_DEVICE_DEFER_PIPELINE_CREATION = 1u << 1,
 };
 typedef uint32_t iree_hal_vulkan_device_flags_t;
 
 typedef struct iree_hal_vulkan_device_options_t {
   // Flags controlling device behavior.
   iree_hal_vulkan_device_flags_t flags;
+
+  // Size of the single VkDeviceMemory block backing each per-memory-type ring
+  // buffer pool used to service IREE_HAL_MEMORY_TYPE_TRANSIENT buffers.
+  // Transient allocations that don't fit in the ring fall back to the general
+  // purpose heaps. 0 disables transient pooling.
+  iree_device_size_t transient_pool_block_size;
+
+  // Size of each VkDeviceMemory block in the per-memory-type pools used to
+  // service IREE_HAL_BUFFER_USAGE_CONSTANT buffers. Keeping long-lived
+  // constants out of the general purpose heaps avoids pinning blocks that would
+  // otherwise be released as transient usage fluctuates. 0 disables constant
+  // pooling.
+  iree_device_size_t constant_pool_block_size;
+
+  // Maximum number of VkQueues created for dispatch (compute) operations and
+  // exposed as HAL queues. Submissions are distributed across them by queue
+  // affinity so independent work can execute concurrently. At least one
+  // dispatch queue is always created.
+  uint32_t max_dispatch_queue_count;
+
+  // Maximum number of dedicated VkQueues created for transfer operations.
+  // Submissions containing only transfer commands are routed to these queues
+  // (by queue affinity) so that uploads can overlap with dispatches on the
+  // dispatch queues. 0 routes all transfers to the dispatch queues.
+  uint32_t max_transfer_queue_count;
+
+  // Size of the persistently mapped host-visible ring buffer used to stage
+  // update_buffer contents (and the unaligned edges of fills) recorded into
+  // one-shot command buffers. Staged space is reclaimed as submissions
+  // complete; updates that don't fit are embedded in the command buffer
+  // instead. Only used with native timeline semaphores. 0 disables staging.
+  iree_device_size_t staging_buffer_capacity;
+
+  // Optional path of a file used to persist the VkPipelineCache of the device
+  // across processes. When set the cache is seeded from the file during device
+  // creation (if the file exists and its header matches the vendor, device,
+  // and pipeline cache UUID of the physical device) and the cache contents are
+  // written back to the file when the device is destroyed. An empty path
+  // disables persistence. The string is copied during device/driver creation.
+  iree_string_view_t pipeline_cache_path;
 } iree_hal_vulkan_device_options_t;
 
 IREE_API_EXPORT void iree_hal_vulkan_device_options_initialize(
     iree_hal_vulkan_device_options_t* out_options);
 
+// Statistics describing the device memory managed by a Vulkan allocator.
+typedef struct iree_hal_vulkan_allocator_statistics_t {
+  // Total number of VkDeviceMemory blocks currently allocated across all heaps
+  // and pools.
+  uint32_t device_memory_count;
+  // Total number of live buffer allocations.
+  uint32_t allocation_count;
+  // Total bytes of device memory occupied by live allocations.
+  iree_device_size_t used_size;
+  // Total bytes of device memory allocated but not occupied by allocations.
+  iree_device_size_t unused_size;
+
+  // Bytes occupied by live allocations in the transient ring buffer pools.
+  iree_device_size_t transient_pool_used_size;
+  // Total bytes of device memory reserved by the transient pools.
+  iree_device_size_t transient_pool_size;
+  // Number of transient allocations that did not fit in their ring buffer pool
+  // and were serviced by the general purpose heaps instead.
+  uint64_t transient_pool_miss_count;
+
+  // Bytes occupied by live allocations in the constant pools.
+  iree_device_size_t constant_pool_used_size;
+  // Total bytes of device memory reserved by the constant pools.
+  iree_device_size_t constant_pool_size;
+} iree_hal_vulkan_allocator_statistics_t;
+
+// Identifies the kind of handle describing external memory.
+typedef enum iree_hal_vulkan_external_memory_type_e {
+  // An opaque POSIX file descriptor exported from a Vulkan device via
+  // VK_KHR_external_memory_fd (VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT).
+  IREE_HAL_VULKAN_EXTERNAL_MEMORY_TYPE_OPAQUE_FD = 0,
+  // A Linux dma-buf file descriptor via VK_EXT_external_memory_dma_buf, such
+  // as those produced by V4L2 camera or video decoder drivers.
+  IREE_HAL_VULKAN_EXTERNAL_MEMORY_TYPE_DMA_BUF_FD = 1,
+} iree_hal_vulkan_external_memory_type_t;
+
+// Describes externally allocated memory to import into a Vulkan device.
+typedef struct iree_hal_vulkan_external_memory_t {
+  iree_hal_vulkan_external_memory_type_t type;
+  // File descriptor referencing the memory. Ownership of the file descriptor
+  // is transferred to the Vulkan implementation when the import succeeds and
+  // remains with the caller when it fails.
+  int fd;
+  // Total size of the external allocation in bytes.
+  iree_device_size_t allocation_size;
+} iree_hal_vulkan_external_memory_t;
+
+// Imports |external_memory| as a buffer usable by the Vulkan device owning
+// |allocator| without copying. The memory is bound to a new buffer that keeps
+// the imported memory alive until it is released.
+//
+// |memory_type| bits are used to select a compatible memory type among those
+// the implementation reports for the external memory; importing fails with
+// IREE_STATUS_UNAVAILABLE if the device does not support the handle type or no
+// matching memory type exists.
+IREE_API_EXPORT iree_status_t iree_hal_vulkan_allocator_import_buffer(
+    iree_hal_allocator_t* allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage,
+    const iree_hal_vulkan_external_memory_t* external_memory,
+    iree_hal_buffer_t** out_buffer);
+
+// Queries the current memory statistics of the Vulkan device |allocator| as
+// returned by iree_hal_device_allocator on a Vulkan device. Fails with
+// IREE_STATUS_INVALID_ARGUMENT if the allocator is not a Vulkan allocator.
+IREE_API_EXPORT iree_status_t iree_hal_vulkan_allocator_query_statistics(
+    iree_hal_allocator_t* allocator,
+    iree_hal_vulkan_allocator_statistics_t* out_statistics);
+
 // Creates a Vulkan HAL device that wraps an existing VkDevice.
 //
 // HAL devices created in this way may share Vulkan resources and synchronize
@@ -24,6 +24,37 @@ namespace vulkan {
 
 namespace {
 
+static VkDescriptorBufferInfo GetDescriptorBufferInfo(
+    const iree_hal_descriptor_set_binding_t& binding) {
+  VkDescriptorBufferInfo buffer_info;
+  buffer_info.buffer = iree_hal_vulkan_vma_buffer_handle(
+      iree_hal_buffer_allocated_buffer(binding.buffer));
+  buffer_info.offset =
+      iree_hal_buffer_byte_offset(binding.buffer) + binding.offset;
+  // Round up to a multiple of 32-bit. 32-bit is the most native bitwidth on
+  // GPUs; it has the best support compared to other bitwidths. We use VMA to
+  // manage GPU memory for us and VMA should already handled proper alignment
+  // when performing allocations; here we just need to provide the proper
+  // "view" to Vulkan drivers over the allocated memory.
+  //
+  // Note this is needed because we can see unusal buffers like tensor<3xi8>.
+  // Depending on GPU capabilities, this might not always be directly
+  // supported by the hardware. Under such circumstances, we need to emulate
+  // i8 support with i32. Shader CodeGen takes care of that: the shader will
+  // read the buffer as tensor<i32> and perform bit shifts to extract each
+  // byte and conduct computations. The extra additional byte is read but
+  // not really used by the shader. Here in application we need to match the
+  // ABI and provide the buffer as 32-bit aligned, otherwise the whole read by
+  // the shader is considered as out of bounds per the Vulkan spec.
+  // See https://github.com/google/iree/issues/2022#issuecomment-640617234
+  // for more details.
+  buffer_info.range = iree_device_align(
+      std::min(binding.length,
+               iree_hal_buffer_byte_length(binding.buffer) - binding.offset),
+      4);
+  return buffer_info;
+}
+
 static void PopulateDescriptorSetWriteInfos(
     iree_host_size_t binding_count,
     const iree_hal_descriptor_set_binding_t* bindings, VkDescriptorSet dst_set,
@@ -38,31 +69,7 @@ static void PopulateDescriptorSetWriteInfos(
     const auto& binding = bindings[i];
 
     auto& buffer_info = buffer_infos[i];
-    buffer_info.buffer = iree_hal_vulkan_vma_buffer_handle(
-        iree_hal_buffer_allocated_buffer(binding.buffer));
-    buffer_info.offset =
-        iree_hal_buffer_byte_offset(binding.buffer) + binding.offset;
-    // Round up to a multiple of 32-bit. 32-bit is the most native bitwidth on
-    // GPUs; it has the best support compared to other bitwidths. We use VMA to
-    // manage GPU memory for us and VMA should already handled proper alignment
-    // when performing allocations; here we just need to provide the proper
-    // "view" to Vulkan drivers over the allocated memory.
-    //
-    // Note this is needed because we can see unusal buffers like tensor<3xi8>.
-    // Depending on GPU capabilities, this might not always be directly
-    // supported by the hardware. Under such circumstances, we need to emulate
-    // i8 support with i32. Shader CodeGen takes care of that: the shader will
-    // read the buffer as tensor<i32> and perform bit shifts to extract each
-    // byte and conduct computations. The extra additional byte is read but
-    // not really used by the shader. Here in application we need to match the
-    // ABI and provide the buffer as 32-bit aligned, otherwise the whole read by
-    // the shader is considered as out of bounds per the Vulkan spec.
-    // See https://github.com/google/iree/issues/2022#issuecomment-640617234
-    // for more details.
-    buffer_info.range = iree_device_align(
-        std::min(binding.length,
-                 iree_hal_buffer_byte_length(binding.buffer) - binding.offset),
-        4);
+    buffer_info = GetDescriptorBufferInfo(binding);
 
     auto& write_info = write_infos[i];
     write_info.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -81,6 +88,32 @@ static void PopulateDescriptorSetWriteInfos(
   *out_infos = write_infos.data();
 }
 
+// Populates the data consumed by the descriptor update templates of
+// |set_layout|: one VkDescriptorBufferInfo per layout binding ordinal.
+// Returns nullptr if |bindings| does not cover exactly the bindings of the
+// layout, in which case the caller must fall back to VkWriteDescriptorSet.
+static const VkDescriptorBufferInfo* PopulateDescriptorTemplateData(
+    iree_hal_descriptor_set_layout_t* set_layout,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings, Arena* arena) {
+  if (binding_count !=
+      iree_hal_vulkan_native_descriptor_set_layout_binding_count(set_layout)) {
+    return nullptr;
+  }
+  arena->Reset();
+  auto buffer_infos =
+      arena->AllocateSpan<VkDescriptorBufferInfo>(binding_count);
+  for (int i = 0; i < binding_count; ++i) {
+    iree_host_size_t ordinal = 0;
+    if (!iree_hal_vulkan_native_descriptor_set_layout_binding_ordinal(
+            set_layout, bindings[i].binding, &ordinal)) {
+      return nullptr;
+    }
+    buffer_infos[ordinal] = GetDescriptorBufferInfo(bindings[i]);
+  }
+  return buffer_infos.data();
+}
+
 static VkDescriptorSetAllocateInfo PopulateDescriptorSetsAllocateInfo(
     const DescriptorPool& descriptor_pool,
     iree_hal_descriptor_set_layout_t* set_layout) {
@@ -97,6 +130,12 @@ static VkDescriptorSetAllocateInfo PopulateDescriptorSetsAllocateInfo(
   return allocate_info;
 }
 
+static bool DescriptorBufferInfosEqual(const VkDescriptorBufferInfo& lhs,
+                                       const VkDescriptorBufferInfo& rhs) {
+  return lhs.buffer == rhs.buffer && lhs.offset == rhs.offset &&
+         lhs.range == rhs.range;
+}
+
 }  // namespace
 
 DescriptorSetArena::DescriptorSetArena(
@@ -129,7 +168,34 @@ iree_status_t DescriptorSetArena::BindDescriptorSet(
 
   auto* set_layout =
       iree_hal_vulkan_native_executable_layout_set(executable_layout, set);
+  VkDescriptorSetLayout set_layout_handle =
+      iree_hal_vulkan_native_descriptor_set_layout_handle(set_layout);
+
+  // Reuse a set we've already written with the same bindings, if any. Sets
+  // can't be rewritten once bound without waiting for the command buffer to
+  // complete so any change in bindings requires a new set.
+  VkDescriptorSet descriptor_set =
+      LookupDescriptorSet(set_layout_handle, binding_count, bindings);
+  if (descriptor_set == VK_NULL_HANDLE) {
+    IREE_RETURN_IF_ERROR(
+        AllocateDescriptorSet(set_layout, binding_count, &descriptor_set));
+    UpdateDescriptorSet(set_layout, descriptor_set, binding_count, bindings);
+    InsertDescriptorSet(set_layout_handle, descriptor_set, binding_count,
+                        bindings);
+  }
+
+  // Bind the descriptor set.
+  syms().vkCmdBindDescriptorSets(
+      command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+      iree_hal_vulkan_native_executable_layout_handle(executable_layout), set,
+      1, &descriptor_set, 0, nullptr);
 
+  return iree_ok_status();
+}
+
+iree_status_t DescriptorSetArena::AllocateDescriptorSet(
+    iree_hal_descriptor_set_layout_t* set_layout,
+    iree_host_size_t binding_count, VkDescriptorSet* out_descriptor_set) {
   // Pick a bucket based on the number of descriptors required.
   // NOTE: right now we are 1:1 with bindings.
   uint32_t required_descriptor_count = static_cast<int>(binding_count * 1);
@@ -161,9 +227,9 @@ iree_status_t DescriptorSetArena::BindDescriptorSet(
   allocate_info.descriptorSetCount = 1;
   allocate_info.pSetLayouts = &set_layout_handle;
 
-  VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
+  *out_descriptor_set = VK_NULL_HANDLE;
   VkResult result = syms().vkAllocateDescriptorSets(
-      *logical_device_, &allocate_info, &descriptor_set);
+      *logical_device_, &allocate_info, out_descriptor_set);
 
   if (result == VK_ERROR_OUT_OF_POOL_MEMORY) {
     // Allocation failed because the pool is either out of descriptors or too
@@ -180,12 +246,35 @@ iree_status_t DescriptorSetArena::BindDescriptorSet(
     allocate_info.descriptorPool = descriptor_pool_buckets_[bucket].handle;
     allocate_info.descriptorSetCount = 1;
     allocate_info.pSetLayouts = &set_layout_handle;
-    descriptor_set = VK_NULL_HANDLE;
+    *out_descriptor_set = VK_NULL_HANDLE;
     VK_RETURN_IF_ERROR(syms().vkAllocateDescriptorSets(
-                           *logical_device_, &allocate_info, &descriptor_set),
+                           *logical_device_, &allocate_info,
+                           out_descriptor_set),
                        "vkAllocateDescriptorSets");
   }
 
+  return iree_ok_status();
+}
+
+void DescriptorSetArena::UpdateDescriptorSet(
+    iree_hal_descriptor_set_layout_t* set_layout,
+    VkDescriptorSet descriptor_set, iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings) {
+  // Templates let the driver consume the packed buffer infos directly instead
+  // of walking a list of VkWriteDescriptorSet structs.
+  VkDescriptorUpdateTemplateKHR update_template =
+      iree_hal_vulkan_native_descriptor_set_layout_update_template(set_layout);
+  if (update_template != VK_NULL_HANDLE) {
+    const VkDescriptorBufferInfo* template_data =
+        PopulateDescriptorTemplateData(set_layout, binding_count, bindings,
+                                       &scratch_arena_);
+    if (template_data) {
+      syms().vkUpdateDescriptorSetWithTemplateKHR(
+          *logical_device_, descriptor_set, update_template, template_data);
+      return;
+    }
+  }
+
   // Get a list of VkWriteDescriptorSet structs with all bound buffers.
   iree_host_size_t write_info_count = 0;
   VkWriteDescriptorSet* write_infos = NULL;
@@ -201,14 +290,49 @@ iree_status_t DescriptorSetArena::BindDescriptorSet(
   syms().vkUpdateDescriptorSets(*logical_device_,
                                 static_cast<uint32_t>(write_info_count),
                                 write_infos, 0, nullptr);
+}
 
-  // Bind the descriptor set.
-  syms().vkCmdBindDescriptorSets(
-      command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
-      iree_hal_vulkan_native_executable_layout_handle(executable_layout), set,
-      1, &descriptor_set, 0, nullptr);
+VkDescriptorSet DescriptorSetArena::LookupDescriptorSet(
+    VkDescriptorSetLayout set_layout, iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings) {
+  for (const auto& cached_set : cached_descriptor_sets_) {
+    if (cached_set.set_layout != set_layout ||
+        cached_set.bindings.size() != binding_count) {
+      continue;
+    }
+    bool matches = true;
+    for (iree_host_size_t i = 0; i < binding_count && matches; ++i) {
+      VkDescriptorBufferInfo buffer_info = GetDescriptorBufferInfo(bindings[i]);
+      matches = cached_set.bindings[i] == bindings[i].binding &&
+                DescriptorBufferInfosEqual(cached_set.buffer_infos[i],
+                                           buffer_info);
+    }
+    if (matches) return cached_set.descriptor_set;
+  }
+  return VK_NULL_HANDLE;
+}
 
-  return iree_ok_status();
+void DescriptorSetArena::InsertDescriptorSet(
+    VkDescriptorSetLayout set_layout, VkDescriptorSet descriptor_set,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings) {
+  CachedDescriptorSet* cached_set = nullptr;
+  if (cached_descriptor_sets_.size() < kMaxCachedDescriptorSets) {
+    cached_descriptor_sets_.emplace_back();
+    cached_set = &cached_descriptor_sets_.back();
+  } else {
+    cached_set = &cached_descriptor_sets_[next_cached_descriptor_set_];
+    next_cached_descriptor_set_ =
+        (next_cached_descriptor_set_ + 1) % kMaxCachedDescriptorSets;
+  }
+  cached_set->set_layout = set_layout;
+  cached_set->descriptor_set = descriptor_set;
+  cached_set->bindings.resize(binding_count);
+  cached_set->buffer_infos.resize(binding_count);
+  for (iree_host_size_t i = 0; i < binding_count; ++i) {
+    cached_set->bindings[i] = bindings[i].binding;
+    cached_set->buffer_infos[i] = GetDescriptorBufferInfo(bindings[i]);
+  }
 }
 
 void DescriptorSetArena::PushDescriptorSet(
@@ -220,6 +344,24 @@ void DescriptorSetArena::PushDescriptorSet(
   VkPipelineLayout device_executable_layout =
       iree_hal_vulkan_native_executable_layout_handle(executable_layout);
 
+  // Push the packed buffer infos with the layout template when available.
+  VkDescriptorUpdateTemplateKHR push_template =
+      iree_hal_vulkan_native_executable_layout_push_template(executable_layout,
+                                                             set);
+  if (push_template != VK_NULL_HANDLE) {
+    const VkDescriptorBufferInfo* template_data =
+        PopulateDescriptorTemplateData(
+            iree_hal_vulkan_native_executable_layout_set(executable_layout,
+                                                         set),
+            binding_count, bindings, &scratch_arena_);
+    if (template_data) {
+      syms().vkCmdPushDescriptorSetWithTemplateKHR(
+          command_buffer, push_template, device_executable_layout, set,
+          template_data);
+      return;
+    }
+  }
+
   // Get a list of VkWriteDescriptorSet structs with all bound buffers.
   iree_host_size_t write_info_count = 0;
   VkWriteDescriptorSet* write_infos = NULL;
@@ -237,6 +379,10 @@ void DescriptorSetArena::PushDescriptorSet(
 DescriptorSetGroup DescriptorSetArena::Flush() {
   IREE_TRACE_SCOPE0("DescriptorSetArena::Flush");
 
+  // Sets are returned to their pools below and can no longer be reused.
+  cached_descriptor_sets_.clear();
+  next_cached_descriptor_set_ = 0;
+
   if (used_descriptor_pools_.empty()) {
     // No resources to free.
     return DescriptorSetGroup{};
@@ -27,6 +27,12 @@ namespace hal {
 namespace vulkan {
 
 // A reusable arena for allocating descriptor sets and batching updates.
+//
+// Descriptor sets allocated from the arena are remembered until the arena is
+// flushed so that binding the same buffers with the same layout again (as is
+// common when a command buffer dispatches several times against the same
+// resources) reuses the already-written set instead of allocating and
+// updating a new one.
 class DescriptorSetArena final {
  public:
   explicit DescriptorSetArena(DescriptorPoolCache* descriptor_pool_cache);
@@ -49,12 +55,50 @@ class DescriptorSetArena final {
  private:
   const DynamicSymbols& syms() const { return *logical_device_->syms(); }
 
+  // A descriptor set previously allocated and written by the arena.
+  struct CachedDescriptorSet {
+    VkDescriptorSetLayout set_layout = VK_NULL_HANDLE;
+    VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
+    // Binding numbers and buffer infos the set was written with, in the order
+    // they were provided.
+    std::vector<uint32_t> bindings;
+    std::vector<VkDescriptorBufferInfo> buffer_infos;
+  };
+
+  // Maximum number of descriptor sets remembered for reuse. Lookups are
+  // linear so this is kept small; most reuse comes from recent dispatches.
+  static constexpr size_t kMaxCachedDescriptorSets = 16;
+
   // Pushes the descriptor set to the command buffer, if supported.
   void PushDescriptorSet(VkCommandBuffer command_buffer,
                          iree_hal_executable_layout_t* executable_layout,
                          uint32_t set, iree_host_size_t binding_count,
                          const iree_hal_descriptor_set_binding_t* bindings);
 
+  // Allocates a new descriptor set with |set_layout| from the pool bucket
+  // matching |binding_count|.
+  iree_status_t AllocateDescriptorSet(
+      iree_hal_descriptor_set_layout_t* set_layout,
+      iree_host_size_t binding_count, VkDescriptorSet* out_descriptor_set);
+
+  // Writes |bindings| into |descriptor_set|.
+  void UpdateDescriptorSet(iree_hal_descriptor_set_layout_t* set_layout,
+                           VkDescriptorSet descriptor_set,
+                           iree_host_size_t binding_count,
+                           const iree_hal_descriptor_set_binding_t* bindings);
+
+  // Returns a descriptor set allocated by the arena with |set_layout| that
+  // was written with exactly |bindings| or VK_NULL_HANDLE if none exists.
+  VkDescriptorSet LookupDescriptorSet(
+      VkDescriptorSetLayout set_layout, iree_host_size_t binding_count,
+      const iree_hal_descriptor_set_binding_t* bindings);
+
+  // Remembers |descriptor_set| as being written with |bindings|.
+  void InsertDescriptorSet(VkDescriptorSetLayout set_layout,
+                           VkDescriptorSet descriptor_set,
+                           iree_host_size_t binding_count,
+                           const iree_hal_descriptor_set_binding_t* bindings);
+
   VkDeviceHandle* logical_device_;
   DescriptorPoolCache* descriptor_pool_cache_;
 
@@ -67,6 +111,11 @@ class DescriptorSetArena final {
 
   // All pools that have been used during allocation.
   std::vector<DescriptorPool> used_descriptor_pools_;
+
+  // Descriptor sets available for reuse until the pools they were allocated
+  // from are released by Flush. Replaced round-robin once full.
+  std::vector<CachedDescriptorSet> cached_descriptor_sets_;
+  size_t next_cached_descriptor_set_ = 0;
 };
 
 }  // namespace vulkan
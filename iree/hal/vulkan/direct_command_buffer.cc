@@ -8,6 +8,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 
 #include "iree/base/api.h"
 #include "iree/base/internal/inline_array.h"
@@ -27,9 +28,22 @@
 
 using namespace iree::hal::vulkan;
 
+// Maximum size of the push constant range shadowed by the command buffer to
+// elide redundant updates. Larger ranges are always recorded.
+#define IREE_HAL_VULKAN_MAX_SHADOWED_PUSH_CONSTANT_SIZE 256
+
 // Command buffer implementation that directly maps to VkCommandBuffer.
 // This records the commands on the calling thread without additional threading
 // indirection.
+//
+// Command buffers not recorded with IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT are
+// recorded once and may be submitted any number of times (including while
+// prior submissions are still in flight) without re-recording. As push
+// constants are captured into the VkCommandBuffer at record time, values that
+// change per submission should be staged in a buffer (written by the host or
+// with iree_hal_command_buffer_update_buffer in a small one-shot command
+// buffer) instead of recorded as push constants. When command buffers are
+// re-recorded redundant pipeline binds and push constant updates are elided.
 typedef struct iree_hal_vulkan_direct_command_buffer_t {
   iree_hal_resource_t resource;
   VkDeviceHandle* logical_device;
@@ -37,6 +51,9 @@ typedef struct iree_hal_vulkan_direct_command_buffer_t {
   iree_hal_command_category_t allowed_categories;
   iree_hal_queue_affinity_t queue_affinity;
   iree_hal_vulkan_tracing_context_t* tracing_context;
+  iree_hal_vulkan_profiling_context_t* profiling_context;
+  // Staging ring used by one-shot command buffers; NULL otherwise.
+  iree_hal_vulkan_staging_buffer_t* staging_buffer;
 
   VkCommandPoolHandle* command_pool;
   VkCommandBuffer handle;
@@ -50,6 +67,16 @@ typedef struct iree_hal_vulkan_direct_command_buffer_t {
   // This must remain valid until all in-flight submissions of the command
   // buffer complete.
   DescriptorSetGroup descriptor_set_group;
+
+  // Pipeline last bound during recording, if any.
+  VkPipeline bound_pipeline;
+
+  // Shadow of the push constants last recorded with |push_constant_layout|.
+  // Each bit of |push_constant_valid_mask| marks one valid dword.
+  VkPipelineLayout push_constant_layout;
+  uint64_t push_constant_valid_mask;
+  uint32_t push_constants[IREE_HAL_VULKAN_MAX_SHADOWED_PUSH_CONSTANT_SIZE /
+                          sizeof(uint32_t)];
 } iree_hal_vulkan_direct_command_buffer_t;
 
 extern const iree_hal_command_buffer_vtable_t
@@ -70,6 +97,8 @@ iree_status_t iree_hal_vulkan_direct_command_buffer_allocate(
     iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity,
     iree_hal_vulkan_tracing_context_t* tracing_context,
+    iree_hal_vulkan_profiling_context_t* profiling_context,
+    iree_hal_vulkan_staging_buffer_t* staging_buffer,
     iree::hal::vulkan::DescriptorPoolCache* descriptor_pool_cache,
     iree_hal_command_buffer_t** out_command_buffer) {
   IREE_ASSERT_ARGUMENT(logical_device);
@@ -101,9 +130,17 @@ iree_status_t iree_hal_vulkan_direct_command_buffer_allocate(
     command_buffer->allowed_categories = command_categories;
     command_buffer->queue_affinity = queue_affinity;
     command_buffer->tracing_context = tracing_context;
+    command_buffer->profiling_context = profiling_context;
+    command_buffer->staging_buffer =
+        iree_all_bits_set(mode, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT)
+            ? staging_buffer
+            : NULL;
     command_buffer->command_pool = command_pool;
     command_buffer->handle = handle;
     command_buffer->syms = logical_device->syms().get();
+    command_buffer->bound_pipeline = VK_NULL_HANDLE;
+    command_buffer->push_constant_layout = VK_NULL_HANDLE;
+    command_buffer->push_constant_valid_mask = 0;
 
     new (&command_buffer->descriptor_set_arena)
         DescriptorSetArena(descriptor_pool_cache);
@@ -123,6 +160,34 @@ static void iree_hal_vulkan_direct_command_buffer_reset(
   // NOTE: we require that command buffers not be recorded while they are
   // in-flight so this is safe.
   IREE_IGNORE_ERROR(command_buffer->descriptor_set_group.Reset());
+  if (command_buffer->staging_buffer) {
+    iree_hal_vulkan_staging_buffer_release(command_buffer->staging_buffer,
+                                           command_buffer);
+  }
+  command_buffer->bound_pipeline = VK_NULL_HANDLE;
+  command_buffer->push_constant_layout = VK_NULL_HANDLE;
+  command_buffer->push_constant_valid_mask = 0;
+}
+
+// Invalidates the push constant shadow if binding descriptor sets with
+// |pipeline_layout| may disturb the push constants previously recorded.
+static void iree_hal_vulkan_direct_command_buffer_disturb_push_constants(
+    iree_hal_vulkan_direct_command_buffer_t* command_buffer,
+    VkPipelineLayout pipeline_layout) {
+  if (pipeline_layout != command_buffer->push_constant_layout) {
+    command_buffer->push_constant_layout = VK_NULL_HANDLE;
+    command_buffer->push_constant_valid_mask = 0;
+  }
+}
+
+// Binds |pipeline| unless it is already bound.
+static void iree_hal_vulkan_direct_command_buffer_bind_pipeline(
+    iree_hal_vulkan_direct_command_buffer_t* command_buffer,
+    VkPipeline pipeline) {
+  if (pipeline == command_buffer->bound_pipeline) return;
+  command_buffer->syms->vkCmdBindPipeline(
+      command_buffer->handle, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+  command_buffer->bound_pipeline = pipeline;
 }
 
 static void iree_hal_vulkan_direct_command_buffer_destroy(
@@ -175,10 +240,12 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_begin(
   VkCommandBufferBeginInfo begin_info;
   begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
   begin_info.pNext = NULL;
+  // Reusable command buffers may be resubmitted while prior submissions of the
+  // same recording are still in flight (such as one per frame).
   begin_info.flags = iree_all_bits_set(command_buffer->mode,
                                        IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT)
                          ? VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
-                         : 0;
+                         : VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
   begin_info.pInheritanceInfo = NULL;
   VK_RETURN_IF_ERROR(command_buffer->syms->vkBeginCommandBuffer(
                          command_buffer->handle, &begin_info),
@@ -502,6 +569,51 @@ static uint32_t iree_hal_vulkan_splat_pattern(const void* pattern,
   }
 }
 
+// Reserves |length| bytes of the staging ring and records a copy from them to
+// |target_device_buffer|. The caller must write the contents to
+// |out_host_ptr| prior to submission. Fails with RESOURCE_EXHAUSTED if the
+// command buffer cannot stage or the ring is full.
+static iree_status_t iree_hal_vulkan_direct_command_buffer_stage_copy(
+    iree_hal_vulkan_direct_command_buffer_t* command_buffer,
+    VkBuffer target_device_buffer, iree_device_size_t target_offset,
+    iree_device_size_t length, void** out_host_ptr) {
+  if (!command_buffer->staging_buffer) {
+    return iree_status_from_code(IREE_STATUS_RESOURCE_EXHAUSTED);
+  }
+  VkBuffer staging_device_buffer = VK_NULL_HANDLE;
+  iree_device_size_t staging_offset = 0;
+  IREE_RETURN_IF_ERROR(iree_hal_vulkan_staging_buffer_reserve(
+      command_buffer->staging_buffer, command_buffer, length,
+      &staging_device_buffer, &staging_offset, out_host_ptr));
+  VkBufferCopy region;
+  region.srcOffset = staging_offset;
+  region.dstOffset = target_offset;
+  region.size = length;
+  command_buffer->syms->vkCmdCopyBuffer(command_buffer->handle,
+                                        staging_device_buffer,
+                                        target_device_buffer, 1, &region);
+  return iree_ok_status();
+}
+
+// Stages the fill of [offset, offset + length) within a fill that started at
+// |fill_offset| such that the pattern stays in phase.
+static iree_status_t iree_hal_vulkan_direct_command_buffer_stage_fill(
+    iree_hal_vulkan_direct_command_buffer_t* command_buffer,
+    VkBuffer target_device_buffer, iree_device_size_t fill_offset,
+    iree_device_size_t offset, iree_device_size_t length, const void* pattern,
+    iree_host_size_t pattern_length) {
+  if (length == 0) return iree_ok_status();
+  uint8_t* host_ptr = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_vulkan_direct_command_buffer_stage_copy(
+      command_buffer, target_device_buffer, offset, length,
+      (void**)&host_ptr));
+  const uint8_t* pattern_bytes = static_cast<const uint8_t*>(pattern);
+  for (iree_device_size_t i = 0; i < length; ++i) {
+    host_ptr[i] = pattern_bytes[(offset - fill_offset + i) % pattern_length];
+  }
+  return iree_ok_status();
+}
+
 static iree_status_t iree_hal_vulkan_direct_command_buffer_fill_buffer(
     iree_hal_command_buffer_t* base_command_buffer,
     iree_hal_buffer_t* target_buffer, iree_device_size_t target_offset,
@@ -517,6 +629,38 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_fill_buffer(
   target_offset += iree_hal_buffer_byte_offset(target_buffer);
   uint32_t dword_pattern =
       iree_hal_vulkan_splat_pattern(pattern, pattern_length);
+
+  // vkCmdFillBuffer also requires a 4-byte aligned offset and length. Any
+  // unaligned bytes at the edges of 1 and 2 byte pattern fills are staged and
+  // copied instead when the command buffer is able to.
+  const iree_device_size_t target_end = target_offset + length;
+  iree_device_size_t fill_offset = iree_device_align(target_offset, 4);
+  iree_device_size_t fill_end = target_end & ~(iree_device_size_t)3;
+  if (fill_offset > fill_end) fill_end = fill_offset;
+  if (command_buffer->staging_buffer &&
+      (fill_offset != target_offset || fill_end != target_end)) {
+    iree_device_size_t head_length =
+        iree_min(fill_offset, target_end) - target_offset;
+    iree_status_t status = iree_hal_vulkan_direct_command_buffer_stage_fill(
+        command_buffer, target_device_buffer, target_offset, target_offset,
+        head_length, pattern, pattern_length);
+    if (iree_status_is_ok(status) && fill_end < target_end) {
+      status = iree_hal_vulkan_direct_command_buffer_stage_fill(
+          command_buffer, target_device_buffer, target_offset, fill_end,
+          target_end - fill_end, pattern, pattern_length);
+    }
+    if (iree_status_is_ok(status)) {
+      if (fill_end > fill_offset) {
+        command_buffer->syms->vkCmdFillBuffer(
+            command_buffer->handle, target_device_buffer, fill_offset,
+            fill_end - fill_offset, dword_pattern);
+      }
+      return iree_ok_status();
+    }
+    // Any edge already staged writes the same bytes as the full fill below.
+    iree_status_ignore(status);
+  }
+
   command_buffer->syms->vkCmdFillBuffer(command_buffer->handle,
                                         target_device_buffer, target_offset,
                                         length, dword_pattern);
@@ -533,13 +677,28 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_update_buffer(
   VkBuffer target_device_buffer = iree_hal_vulkan_vma_buffer_handle(
       iree_hal_buffer_allocated_buffer(target_buffer));
 
+  // One-shot command buffers copy the contents through the staging ring so
+  // that they need not be embedded in the command buffer.
+  target_offset += iree_hal_buffer_byte_offset(target_buffer);
+  void* staging_ptr = NULL;
+  iree_status_t status = iree_hal_vulkan_direct_command_buffer_stage_copy(
+      command_buffer, target_device_buffer, target_offset, length,
+      &staging_ptr);
+  if (iree_status_is_ok(status)) {
+    memcpy(staging_ptr,
+           static_cast<const uint8_t*>(source_buffer) + source_offset,
+           length);
+    return iree_ok_status();
+  }
+  iree_status_ignore(status);
+
   // Vulkan only allows updates of <= 65536 because you really, really, really
   // shouldn't do large updates like this (as it wastes command buffer space and
   // may be slower than just using write-through mapped memory). The
   // recommendation in the spec for larger updates is to split the single update
   // into multiple updates over the entire desired range.
-  const auto* source_buffer_ptr = static_cast<const uint8_t*>(source_buffer);
-  target_offset += iree_hal_buffer_byte_offset(target_buffer);
+  const auto* source_buffer_ptr =
+      static_cast<const uint8_t*>(source_buffer) + source_offset;
   while (length > 0) {
     iree_device_size_t chunk_length =
         iree_min((iree_device_size_t)65536u, length);
@@ -583,12 +742,40 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_push_constants(
     const void* values, iree_host_size_t values_length) {
   iree_hal_vulkan_direct_command_buffer_t* command_buffer =
       iree_hal_vulkan_direct_command_buffer_cast(base_command_buffer);
+  VkPipelineLayout pipeline_layout =
+      iree_hal_vulkan_native_executable_layout_handle(executable_layout);
+
+  // Elide the update if the same values were already recorded for a layout
+  // that is still bound. Offsets and lengths are multiples of 4 in Vulkan.
+  bool is_shadowed =
+      offset + values_length <= IREE_HAL_VULKAN_MAX_SHADOWED_PUSH_CONSTANT_SIZE;
+  uint64_t range_mask = 0;
+  if (is_shadowed && values_length > 0) {
+    iree_host_size_t dword_count = values_length / sizeof(uint32_t);
+    range_mask = (dword_count >= 64 ? UINT64_MAX
+                                    : ((1ull << dword_count) - 1))
+                 << (offset / sizeof(uint32_t));
+    if (pipeline_layout == command_buffer->push_constant_layout &&
+        iree_all_bits_set(command_buffer->push_constant_valid_mask,
+                          range_mask) &&
+        memcmp((const uint8_t*)command_buffer->push_constants + offset, values,
+               values_length) == 0) {
+      return iree_ok_status();
+    }
+  }
 
   command_buffer->syms->vkCmdPushConstants(
-      command_buffer->handle,
-      iree_hal_vulkan_native_executable_layout_handle(executable_layout),
-      VK_SHADER_STAGE_COMPUTE_BIT, (uint32_t)offset, (uint32_t)values_length,
-      values);
+      command_buffer->handle, pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT,
+      (uint32_t)offset, (uint32_t)values_length, values);
+
+  iree_hal_vulkan_direct_command_buffer_disturb_push_constants(
+      command_buffer, pipeline_layout);
+  command_buffer->push_constant_layout = pipeline_layout;
+  if (is_shadowed) {
+    memcpy((uint8_t*)command_buffer->push_constants + offset, values,
+           values_length);
+    command_buffer->push_constant_valid_mask |= range_mask;
+  }
 
   return iree_ok_status();
 }
@@ -601,6 +788,10 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_push_descriptor_set(
   iree_hal_vulkan_direct_command_buffer_t* command_buffer =
       iree_hal_vulkan_direct_command_buffer_cast(base_command_buffer);
 
+  iree_hal_vulkan_direct_command_buffer_disturb_push_constants(
+      command_buffer,
+      iree_hal_vulkan_native_executable_layout_handle(executable_layout));
+
   // Either allocate, update, and bind a descriptor set or use push descriptor
   // sets to use the command buffer pool when supported.
   return command_buffer->descriptor_set_arena.BindDescriptorSet(
@@ -626,6 +817,10 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_bind_descriptor_set(
         (uint32_t)dynamic_offsets[i];
   }
 
+  iree_hal_vulkan_direct_command_buffer_disturb_push_constants(
+      command_buffer,
+      iree_hal_vulkan_native_executable_layout_handle(executable_layout));
+
   VkDescriptorSet descriptor_sets[1] = {
       iree_hal_vulkan_native_descriptor_set_handle(descriptor_set),
   };
@@ -665,11 +860,17 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_dispatch(
   IREE_RETURN_IF_ERROR(
       iree_hal_vulkan_native_executable_pipeline_for_entry_point(
           executable, entry_point, &pipeline_handle));
-  command_buffer->syms->vkCmdBindPipeline(
-      command_buffer->handle, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_handle);
+  iree_hal_vulkan_direct_command_buffer_bind_pipeline(command_buffer,
+                                                      pipeline_handle);
 
+  uint32_t profiling_query = iree_hal_vulkan_profiling_context_begin_dispatch(
+      command_buffer->profiling_context, command_buffer->handle, executable,
+      entry_point, workgroup_x, workgroup_y, workgroup_z);
   command_buffer->syms->vkCmdDispatch(command_buffer->handle, workgroup_x,
                                       workgroup_y, workgroup_z);
+  iree_hal_vulkan_profiling_context_end_dispatch(
+      command_buffer->profiling_context, command_buffer->handle,
+      profiling_query);
 
   IREE_VULKAN_TRACE_ZONE_END(command_buffer->tracing_context,
                              command_buffer->handle);
@@ -700,14 +901,20 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_dispatch_indirect(
   IREE_RETURN_IF_ERROR(
       iree_hal_vulkan_native_executable_pipeline_for_entry_point(
           executable, entry_point, &pipeline_handle));
-  command_buffer->syms->vkCmdBindPipeline(
-      command_buffer->handle, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_handle);
+  iree_hal_vulkan_direct_command_buffer_bind_pipeline(command_buffer,
+                                                      pipeline_handle);
 
   VkBuffer workgroups_device_buffer = iree_hal_vulkan_vma_buffer_handle(
       iree_hal_buffer_allocated_buffer(workgroups_buffer));
   workgroups_offset += iree_hal_buffer_byte_offset(workgroups_buffer);
+  uint32_t profiling_query = iree_hal_vulkan_profiling_context_begin_dispatch(
+      command_buffer->profiling_context, command_buffer->handle, executable,
+      entry_point, 0, 0, 0);
   command_buffer->syms->vkCmdDispatchIndirect(
       command_buffer->handle, workgroups_device_buffer, workgroups_offset);
+  iree_hal_vulkan_profiling_context_end_dispatch(
+      command_buffer->profiling_context, command_buffer->handle,
+      profiling_query);
 
   IREE_VULKAN_TRACE_ZONE_END(command_buffer->tracing_context,
                              command_buffer->handle);
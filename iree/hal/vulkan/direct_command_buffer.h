@@ -11,6 +11,8 @@
 #include "iree/hal/api.h"
 #include "iree/hal/vulkan/descriptor_pool_cache.h"
 #include "iree/hal/vulkan/handle_util.h"
+#include "iree/hal/vulkan/profiling.h"
+#include "iree/hal/vulkan/staging_buffer.h"
 #include "iree/hal/vulkan/tracing.h"
 
 #ifdef __cplusplus
@@ -18,6 +20,8 @@ extern "C" {
 #endif  // __cplusplus
 
 // Creates a command buffer that directly records into a VkCommandBuffer.
+// One-shot command buffers stage update_buffer contents in |staging_buffer|,
+// if provided, and the queue submitting them must retire their reservations.
 iree_status_t iree_hal_vulkan_direct_command_buffer_allocate(
     iree::hal::vulkan::VkDeviceHandle* logical_device,
     iree::hal::vulkan::VkCommandPoolHandle* command_pool,
@@ -25,6 +29,8 @@ iree_status_t iree_hal_vulkan_direct_command_buffer_allocate(
     iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity,
     iree_hal_vulkan_tracing_context_t* tracing_context,
+    iree_hal_vulkan_profiling_context_t* profiling_context,
+    iree_hal_vulkan_staging_buffer_t* staging_buffer,
     iree::hal::vulkan::DescriptorPoolCache* descriptor_pool_cache,
     iree_hal_command_buffer_t** out_command_buffer);
 
@@ -25,7 +25,64 @@ DirectCommandQueue::DirectCommandQueue(
     iree_hal_command_category_t supported_categories, VkQueue queue)
     : CommandQueue(logical_device, supported_categories, queue) {}
 
-DirectCommandQueue::~DirectCommandQueue() = default;
+DirectCommandQueue::~DirectCommandQueue() {
+  if (staging_semaphore_ != VK_NULL_HANDLE) {
+    // The semaphore may still be pending signal by in-flight submissions.
+    iree_slim_mutex_lock(&queue_mutex_);
+    syms()->vkQueueWaitIdle(queue_);
+    iree_slim_mutex_unlock(&queue_mutex_);
+    syms()->vkDestroySemaphore(*logical_device_, staging_semaphore_,
+                               logical_device_->allocator());
+  }
+}
+
+iree_status_t DirectCommandQueue::SetStagingBuffer(
+    iree_hal_vulkan_staging_buffer_t* staging_buffer) {
+  staging_buffer_ = nullptr;
+  if (!staging_buffer || staging_semaphore_ != VK_NULL_HANDLE) {
+    staging_buffer_ = staging_buffer;
+    return iree_ok_status();
+  }
+
+  VkSemaphoreTypeCreateInfo timeline_create_info;
+  timeline_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+  timeline_create_info.pNext = nullptr;
+  timeline_create_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+  timeline_create_info.initialValue = 0;
+  VkSemaphoreCreateInfo create_info;
+  create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+  create_info.pNext = &timeline_create_info;
+  create_info.flags = 0;
+  VK_RETURN_IF_ERROR(
+      syms()->vkCreateSemaphore(*logical_device_, &create_info,
+                                logical_device_->allocator(),
+                                &staging_semaphore_),
+      "vkCreateSemaphore");
+  staging_buffer_ = staging_buffer;
+  return iree_ok_status();
+}
+
+uint64_t* DirectCommandQueue::AppendStagingSignal(
+    VkSubmitInfo* submit_info,
+    VkTimelineSemaphoreSubmitInfo* timeline_submit_info, Arena* arena) {
+  uint32_t signal_count = submit_info->signalSemaphoreCount;
+  auto signal_semaphore_handles =
+      arena->AllocateSpan<VkSemaphore>(signal_count + 1);
+  auto signal_semaphore_values =
+      arena->AllocateSpan<uint64_t>(signal_count + 1);
+  for (uint32_t i = 0; i < signal_count; ++i) {
+    signal_semaphore_handles[i] = submit_info->pSignalSemaphores[i];
+    signal_semaphore_values[i] =
+        timeline_submit_info->pSignalSemaphoreValues[i];
+  }
+  signal_semaphore_handles[signal_count] = staging_semaphore_;
+  signal_semaphore_values[signal_count] = 0;
+  submit_info->signalSemaphoreCount = signal_count + 1;
+  submit_info->pSignalSemaphores = signal_semaphore_handles.data();
+  timeline_submit_info->signalSemaphoreValueCount = signal_count + 1;
+  timeline_submit_info->pSignalSemaphoreValues = signal_semaphore_values.data();
+  return &signal_semaphore_values[signal_count];
+}
 
 iree_status_t DirectCommandQueue::TranslateBatchInfo(
     const iree_hal_submission_batch_t* batch, VkSubmitInfo* submit_info,
@@ -108,11 +165,31 @@ iree_status_t DirectCommandQueue::Submit(
                                             &timeline_submit_infos[i], &arena));
   }
 
+  // The staging semaphore is signaled by the last batch; its signal covers all
+  // prior batches in submission order.
+  uint64_t* staging_signal_value = nullptr;
+  if (staging_buffer_ && batch_count > 0) {
+    staging_signal_value =
+        AppendStagingSignal(&submit_infos[batch_count - 1],
+                            &timeline_submit_infos[batch_count - 1], &arena);
+  }
+
   iree_slim_mutex_lock(&queue_mutex_);
+  if (staging_signal_value) *staging_signal_value = staging_value_ + 1;
   iree_status_t status = VK_RESULT_TO_STATUS(
       syms()->vkQueueSubmit(queue_, static_cast<uint32_t>(submit_infos.size()),
                             submit_infos.data(), VK_NULL_HANDLE),
       "vkQueueSubmit");
+  if (iree_status_is_ok(status) && staging_signal_value) {
+    ++staging_value_;
+    for (iree_host_size_t i = 0; i < batch_count; ++i) {
+      for (iree_host_size_t j = 0; j < batches[i].command_buffer_count; ++j) {
+        iree_hal_vulkan_staging_buffer_retire(
+            staging_buffer_, batches[i].command_buffers[j], staging_semaphore_,
+            staging_value_);
+      }
+    }
+  }
   iree_slim_mutex_unlock(&queue_mutex_);
   IREE_RETURN_IF_ERROR(status);
 
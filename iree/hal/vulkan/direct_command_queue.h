@@ -11,6 +11,7 @@
 #include "iree/hal/api.h"
 #include "iree/hal/vulkan/command_queue.h"
 #include "iree/hal/vulkan/handle_util.h"
+#include "iree/hal/vulkan/staging_buffer.h"
 #include "iree/hal/vulkan/util/arena.h"
 
 namespace iree {
@@ -30,10 +31,28 @@ class DirectCommandQueue final : public CommandQueue {
 
   iree_status_t WaitIdle(iree_timeout_t timeout) override;
 
+  // Retires the |staging_buffer| reservations of submitted command buffers
+  // against a timeline semaphore owned by the queue and signaled by each
+  // submission. NULL stops using any previously set staging buffer.
+  // Must not be called concurrently with Submit.
+  iree_status_t SetStagingBuffer(
+      iree_hal_vulkan_staging_buffer_t* staging_buffer);
+
  private:
   iree_status_t TranslateBatchInfo(
       const iree_hal_submission_batch_t* batch, VkSubmitInfo* submit_info,
       VkTimelineSemaphoreSubmitInfo* timeline_submit_info, Arena* arena);
+
+  // Appends a signal of |staging_semaphore_| to |submit_info| and returns the
+  // value slot to fill in once the value is known.
+  uint64_t* AppendStagingSignal(
+      VkSubmitInfo* submit_info,
+      VkTimelineSemaphoreSubmitInfo* timeline_submit_info, Arena* arena);
+
+  iree_hal_vulkan_staging_buffer_t* staging_buffer_ = nullptr;
+  VkSemaphore staging_semaphore_ = VK_NULL_HANDLE;
+  // Last value signaled to |staging_semaphore_|.
+  uint64_t staging_value_ IREE_GUARDED_BY(queue_mutex_) = 0;
 };
 
 }  // namespace vulkan
@@ -102,7 +102,7 @@ namespace vulkan {
   DEV_PFN(EXCLUDED, vkCmdProcessCommandsNVX)                            \
   DEV_PFN(REQUIRED, vkCmdPushConstants)                                 \
   DEV_PFN(OPTIONAL, vkCmdPushDescriptorSetKHR)                          \
-  DEV_PFN(EXCLUDED, vkCmdPushDescriptorSetWithTemplateKHR)              \
+  DEV_PFN(OPTIONAL, vkCmdPushDescriptorSetWithTemplateKHR)              \
   DEV_PFN(EXCLUDED, vkCmdReserveSpaceForCommandsNVX)                    \
   DEV_PFN(REQUIRED, vkCmdResetEvent)                                    \
   DEV_PFN(REQUIRED, vkCmdResetQueryPool)                                \
@@ -155,7 +155,7 @@ namespace vulkan {
   DEV_PFN(REQUIRED, vkCreateDescriptorPool)                             \
   DEV_PFN(REQUIRED, vkCreateDescriptorSetLayout)                        \
   DEV_PFN(EXCLUDED, vkCreateDescriptorUpdateTemplate)                   \
-  DEV_PFN(EXCLUDED, vkCreateDescriptorUpdateTemplateKHR)                \
+  DEV_PFN(OPTIONAL, vkCreateDescriptorUpdateTemplateKHR)                \
   DEV_PFN(REQUIRED, vkCreateEvent)                                      \
   DEV_PFN(REQUIRED, vkCreateFence)                                      \
   DEV_PFN(EXCLUDED, vkCreateFramebuffer)                                \
@@ -187,7 +187,7 @@ namespace vulkan {
   DEV_PFN(REQUIRED, vkDestroyDescriptorPool)                            \
   DEV_PFN(REQUIRED, vkDestroyDescriptorSetLayout)                       \
   DEV_PFN(EXCLUDED, vkDestroyDescriptorUpdateTemplate)                  \
-  DEV_PFN(EXCLUDED, vkDestroyDescriptorUpdateTemplateKHR)               \
+  DEV_PFN(OPTIONAL, vkDestroyDescriptorUpdateTemplateKHR)               \
   DEV_PFN(REQUIRED, vkDestroyDevice)                                    \
   DEV_PFN(REQUIRED, vkDestroyEvent)                                     \
   DEV_PFN(REQUIRED, vkDestroyFence)                                     \
@@ -242,8 +242,8 @@ namespace vulkan {
   DEV_PFN(EXCLUDED, vkGetImageSparseMemoryRequirements2KHR)             \
   DEV_PFN(EXCLUDED, vkGetImageSubresourceLayout)                        \
   DEV_PFN(EXCLUDED, vkGetImageViewHandleNVX)                            \
-  DEV_PFN(EXCLUDED, vkGetMemoryFdKHR)                                   \
-  DEV_PFN(EXCLUDED, vkGetMemoryFdPropertiesKHR)                         \
+  DEV_PFN(OPTIONAL, vkGetMemoryFdKHR)                                   \
+  DEV_PFN(OPTIONAL, vkGetMemoryFdPropertiesKHR)                         \
   DEV_PFN(EXCLUDED, vkGetMemoryHostPointerPropertiesEXT)                \
   DEV_PFN(EXCLUDED, vkGetPastPresentationTimingGOOGLE)                  \
   DEV_PFN(REQUIRED, vkGetPipelineCacheData)                             \
@@ -282,7 +282,7 @@ namespace vulkan {
   DEV_PFN(REQUIRED, vkUnmapMemory)                                      \
   DEV_PFN(EXCLUDED, vkUnregisterObjectsNVX)                             \
   DEV_PFN(EXCLUDED, vkUpdateDescriptorSetWithTemplate)                  \
-  DEV_PFN(EXCLUDED, vkUpdateDescriptorSetWithTemplateKHR)               \
+  DEV_PFN(OPTIONAL, vkUpdateDescriptorSetWithTemplateKHR)               \
   DEV_PFN(REQUIRED, vkUpdateDescriptorSets)                             \
   DEV_PFN(REQUIRED, vkWaitForFences)                                    \
                                                                         \
@@ -15,6 +15,7 @@
 
 #include "iree/base/api.h"
 #include "iree/base/internal/synchronization.h"
+#include "iree/base/internal/threading.h"
 #include "iree/base/logging.h"
 #include "iree/base/status_cc.h"
 #include "iree/base/tracing.h"
@@ -67,10 +68,11 @@ class EmulatedTimelineSemaphore final {
 
   // Gets a binary semaphore for waiting on the timeline to advance to the given
   // |value|. The semaphore returned won't be waited by anyone else. Returns
-  // VK_NULL_HANDLE if no available semaphores for the given |value|.
+  // VK_NULL_HANDLE if no available semaphores for the given |value| are
+  // signaled by submissions to |wait_queue|.
   // |wait_fence| is the fence associated with the queue submission that waiting
   // on this semaphore.
-  VkSemaphore GetWaitSemaphore(uint64_t value,
+  VkSemaphore GetWaitSemaphore(uint64_t value, VkQueue wait_queue,
                                const ref_ptr<TimePointFence>& wait_fence);
 
   // Cancels the waiting attempt on the given binary |semaphore|. This allows
@@ -80,7 +82,7 @@ class EmulatedTimelineSemaphore final {
   // Gets a binary semaphore for signaling the timeline to the given |value|.
   // |value| must be smaller than the current timeline value. |signal_fence| is
   // the fence associated with the queue submission that signals this semaphore.
-  iree_status_t GetSignalSemaphore(uint64_t value,
+  iree_status_t GetSignalSemaphore(uint64_t value, VkQueue signal_queue,
                                    const ref_ptr<TimePointFence>& signal_fence,
                                    VkSemaphore* out_handle);
 
@@ -233,7 +235,10 @@ iree_status_t EmulatedTimelineSemaphore::Wait(uint64_t value,
       // Found; we can break the loop and proceed to waiting now.
       break;
     }
-    // TODO(antiagainst): figure out a better way instead of the busy loop here.
+    // The time point has not been submitted yet as the signaling submission is
+    // still deferred; the fence wait thread submits it as soon as its
+    // dependencies are met so yield instead of hammering the lock.
+    iree_thread_yield();
   } while (iree_time_now() < deadline_ns);
 
   if (fence == VK_NULL_HANDLE) {
@@ -260,7 +265,8 @@ void EmulatedTimelineSemaphore::Fail(iree_status_t status) {
 }
 
 VkSemaphore EmulatedTimelineSemaphore::GetWaitSemaphore(
-    uint64_t value, const ref_ptr<TimePointFence>& wait_fence) {
+    uint64_t value, VkQueue wait_queue,
+    const ref_ptr<TimePointFence>& wait_fence) {
   IREE_TRACE_SCOPE0("EmulatedTimelineSemaphore::GetWaitSemaphore");
   IREE_DVLOG(2) << "EmulatedTimelineSemaphore::GetWaitSemaphore";
 
@@ -268,7 +274,11 @@ VkSemaphore EmulatedTimelineSemaphore::GetWaitSemaphore(
 
   VkSemaphore semaphore = VK_NULL_HANDLE;
   for (TimePointSemaphore* point : outstanding_semaphores_) {
-    if (point->value > value && point->wait_fence) {
+    // Binary semaphores can only be waited once and, as they don't support
+    // wait-before-signal, only by submissions following the signal in the
+    // same queue (until the signal is observed on the host).
+    if (point->value >= value && !point->wait_fence && point->signal_fence &&
+        point->signal_queue == wait_queue) {
       point->wait_fence = add_ref(wait_fence);
       semaphore = point->semaphore;
       break;
@@ -304,7 +314,8 @@ iree_status_t EmulatedTimelineSemaphore::CancelWaitSemaphore(
 }
 
 iree_status_t EmulatedTimelineSemaphore::GetSignalSemaphore(
-    uint64_t value, const ref_ptr<TimePointFence>& signal_fence,
+    uint64_t value, VkQueue signal_queue,
+    const ref_ptr<TimePointFence>& signal_fence,
     VkSemaphore* out_handle) {
   IREE_TRACE_SCOPE0("EmulatedTimelineSemaphore::GetSignalSemaphore");
   IREE_DVLOG(2) << "EmulatedTimelineSemaphore::GetSignalSemaphore";
@@ -320,12 +331,14 @@ iree_status_t EmulatedTimelineSemaphore::GetSignalSemaphore(
   auto insertion_point = outstanding_semaphores_.begin();
   while (insertion_point != outstanding_semaphores_.end()) {
     if ((*insertion_point)->value > value) break;
+    ++insertion_point;
   }
 
   TimePointSemaphore* semaphore = NULL;
   IREE_RETURN_IF_ERROR(semaphore_pool_->Acquire(&semaphore));
   semaphore->value = value;
   semaphore->signal_fence = add_ref(signal_fence);
+  semaphore->signal_queue = signal_queue;
   if (semaphore->wait_fence) {
     return iree_make_status(
         IREE_STATUS_INTERNAL,
@@ -563,12 +576,12 @@ static void iree_hal_vulkan_emulated_semaphore_destroy(
 }
 
 iree_status_t iree_hal_vulkan_emulated_semaphore_acquire_wait_handle(
-    iree_hal_semaphore_t* base_semaphore, uint64_t value,
+    iree_hal_semaphore_t* base_semaphore, uint64_t value, VkQueue wait_queue,
     const iree::ref_ptr<iree::hal::vulkan::TimePointFence>& wait_fence,
     VkSemaphore* out_handle) {
   EmulatedTimelineSemaphore* semaphore =
       iree_hal_vulkan_emulated_semaphore_cast(base_semaphore);
-  *out_handle = semaphore->GetWaitSemaphore(value, wait_fence);
+  *out_handle = semaphore->GetWaitSemaphore(value, wait_queue, wait_fence);
   return iree_ok_status();
 }
 
@@ -580,12 +593,13 @@ iree_status_t iree_hal_vulkan_emulated_semaphore_cancel_wait_handle(
 }
 
 iree_status_t iree_hal_vulkan_emulated_semaphore_acquire_signal_handle(
-    iree_hal_semaphore_t* base_semaphore, uint64_t value,
+    iree_hal_semaphore_t* base_semaphore, uint64_t value, VkQueue signal_queue,
     const iree::ref_ptr<iree::hal::vulkan::TimePointFence>& signal_fence,
     VkSemaphore* out_handle) {
   EmulatedTimelineSemaphore* semaphore =
       iree_hal_vulkan_emulated_semaphore_cast(base_semaphore);
-  return semaphore->GetSignalSemaphore(value, signal_fence, out_handle);
+  return semaphore->GetSignalSemaphore(value, signal_queue, signal_fence,
+                                       out_handle);
 }
 
 static iree_status_t iree_hal_vulkan_emulated_semaphore_query(
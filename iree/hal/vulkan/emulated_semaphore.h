@@ -120,13 +120,13 @@ iree_status_t iree_hal_vulkan_emulated_semaphore_create(
 
 // Acquires a binary semaphore for waiting on the timeline to advance to the
 // given |value|. The semaphore returned won't be waited by anyone else.
-// |wait_fence| is the fence associated with the queue submission that waiting
-// on this semaphore.
+// |wait_queue| is the queue the waiting submission will be submitted to and
+// |wait_fence| is the fence associated with that submission.
 //
 // Returns VK_NULL_HANDLE if there are no available semaphores for the given
-// |value|.
+// |value| signaled by work already submitted to |wait_queue|.
 iree_status_t iree_hal_vulkan_emulated_semaphore_acquire_wait_handle(
-    iree_hal_semaphore_t* semaphore, uint64_t value,
+    iree_hal_semaphore_t* semaphore, uint64_t value, VkQueue wait_queue,
     const iree::ref_ptr<iree::hal::vulkan::TimePointFence>& wait_fence,
     VkSemaphore* out_handle);
 
@@ -136,10 +136,11 @@ iree_status_t iree_hal_vulkan_emulated_semaphore_cancel_wait_handle(
     iree_hal_semaphore_t* semaphore, VkSemaphore handle);
 
 // Acquires a binary semaphore for signaling the timeline to the given |value|.
-// |value| must be smaller than the current timeline value. |signal_fence| is
-// the fence associated with the queue submission that signals this semaphore.
+// |value| must be smaller than the current timeline value. |signal_queue| is
+// the queue the signaling submission will be submitted to and |signal_fence|
+// is the fence associated with that submission.
 iree_status_t iree_hal_vulkan_emulated_semaphore_acquire_signal_handle(
-    iree_hal_semaphore_t* semaphore, uint64_t value,
+    iree_hal_semaphore_t* semaphore, uint64_t value, VkQueue signal_queue,
     const iree::ref_ptr<iree::hal::vulkan::TimePointFence>& signal_fence,
     VkSemaphore* out_handle);
 
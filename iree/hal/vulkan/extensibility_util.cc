@@ -207,6 +207,15 @@ iree_hal_vulkan_populate_enabled_device_extensions(
     } else if (strcmp(extension_name,
                       VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME) == 0) {
       extensions.calibrated_timestamps = true;
+    } else if (strcmp(extension_name,
+                      VK_KHR_EXTERNAL_MEMORY_FD_EXTENSION_NAME) == 0) {
+      extensions.external_memory_fd = true;
+    } else if (strcmp(extension_name,
+                      VK_EXT_EXTERNAL_MEMORY_DMA_BUF_EXTENSION_NAME) == 0) {
+      extensions.external_memory_dma_buf = true;
+    } else if (strcmp(extension_name,
+                      VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME) == 0) {
+      extensions.descriptor_update_template = true;
     }
   }
   return extensions;
@@ -229,5 +238,13 @@ iree_hal_vulkan_infer_enabled_device_extensions(
   if (device_syms->vkGetCalibratedTimestampsEXT) {
     extensions.calibrated_timestamps = true;
   }
+  if (device_syms->vkGetMemoryFdKHR) {
+    extensions.external_memory_fd = true;
+  }
+  if (device_syms->vkUpdateDescriptorSetWithTemplateKHR) {
+    extensions.descriptor_update_template = true;
+  }
+  // NOTE: VK_EXT_external_memory_dma_buf has no entry points and cannot be
+  // inferred; devices wrapped with it enabled must not rely on dma-buf import.
   return extensions;
 }
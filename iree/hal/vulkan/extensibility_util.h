@@ -80,6 +80,13 @@ typedef struct iree_hal_vulkan_device_extensions_t {
   bool host_query_reset : 1;
   // VK_EXT_calibrated_timestamps is enabled.
   bool calibrated_timestamps : 1;
+  // VK_KHR_external_memory_fd is enabled and vkGetMemoryFdKHR is valid.
+  bool external_memory_fd : 1;
+  // VK_EXT_external_memory_dma_buf is enabled.
+  bool external_memory_dma_buf : 1;
+  // VK_KHR_descriptor_update_template is enabled and
+  // vkUpdateDescriptorSetWithTemplateKHR is valid.
+  bool descriptor_update_template : 1;
 } iree_hal_vulkan_device_extensions_t;
 
 // Returns a bitfield with all of the provided extension names.
@@ -8,6 +8,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 
 #include "iree/base/api.h"
 #include "iree/base/tracing.h"
@@ -22,6 +23,14 @@ typedef struct iree_hal_vulkan_native_descriptor_set_layout_t {
   iree_hal_resource_t resource;
   VkDeviceHandle* logical_device;
   VkDescriptorSetLayout handle;
+  // True if |handle| was created for use with push descriptors.
+  bool is_push;
+  // Template updating all bindings of a (non-push) descriptor set with the
+  // layout from an array of VkDescriptorBufferInfo in binding ordinal order.
+  // VK_NULL_HANDLE if descriptor update templates are unavailable.
+  VkDescriptorUpdateTemplateKHR update_template;
+  iree_host_size_t binding_count;
+  iree_hal_descriptor_set_layout_binding_t bindings[];
 } iree_hal_vulkan_native_descriptor_set_layout_t;
 
 extern const iree_hal_descriptor_set_layout_vtable_t
@@ -35,6 +44,15 @@ iree_hal_vulkan_native_descriptor_set_layout_cast(
   return (iree_hal_vulkan_native_descriptor_set_layout_t*)base_value;
 }
 
+// Returns true if a set layout with |usage_type| is created for use with push
+// descriptors.
+static bool iree_hal_vulkan_descriptor_set_layout_uses_push_descriptors(
+    VkDeviceHandle* logical_device,
+    iree_hal_descriptor_set_layout_usage_type_t usage_type) {
+  return usage_type == IREE_HAL_DESCRIPTOR_SET_LAYOUT_USAGE_TYPE_PUSH_ONLY &&
+         logical_device->enabled_extensions().push_descriptors;
+}
+
 static iree_status_t iree_hal_vulkan_create_descriptor_set_layout(
     VkDeviceHandle* logical_device,
     iree_hal_descriptor_set_layout_usage_type_t usage_type,
@@ -45,8 +63,8 @@ static iree_status_t iree_hal_vulkan_create_descriptor_set_layout(
   create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
   create_info.pNext = NULL;
   create_info.flags = 0;
-  if (usage_type == IREE_HAL_DESCRIPTOR_SET_LAYOUT_USAGE_TYPE_PUSH_ONLY &&
-      logical_device->enabled_extensions().push_descriptors) {
+  if (iree_hal_vulkan_descriptor_set_layout_uses_push_descriptors(
+          logical_device, usage_type)) {
     // Note that we can *only* use push descriptor sets if we set this create
     // flag. If push descriptors aren't supported we emulate them with normal
     // descriptors so it's fine to have kPushOnly without support.
@@ -109,21 +127,46 @@ iree_status_t iree_hal_vulkan_native_descriptor_set_layout_create(
               logical_device, usage_type, binding_count, bindings, &handle));
 
   iree_hal_vulkan_native_descriptor_set_layout_t* descriptor_set_layout = NULL;
-  iree_status_t status = iree_allocator_malloc(logical_device->host_allocator(),
-                                               sizeof(*descriptor_set_layout),
-                                               (void**)&descriptor_set_layout);
+  iree_host_size_t total_size =
+      sizeof(*descriptor_set_layout) +
+      binding_count * sizeof(*descriptor_set_layout->bindings);
+  iree_status_t status =
+      iree_allocator_malloc(logical_device->host_allocator(), total_size,
+                            (void**)&descriptor_set_layout);
   if (iree_status_is_ok(status)) {
     iree_hal_resource_initialize(
         &iree_hal_vulkan_native_descriptor_set_layout_vtable,
         &descriptor_set_layout->resource);
     descriptor_set_layout->logical_device = logical_device;
     descriptor_set_layout->handle = handle;
+    descriptor_set_layout->is_push =
+        iree_hal_vulkan_descriptor_set_layout_uses_push_descriptors(
+            logical_device, usage_type);
+    descriptor_set_layout->update_template = VK_NULL_HANDLE;
+    descriptor_set_layout->binding_count = binding_count;
+    memcpy(descriptor_set_layout->bindings, bindings,
+           binding_count * sizeof(*descriptor_set_layout->bindings));
     *out_descriptor_set_layout =
         (iree_hal_descriptor_set_layout_t*)descriptor_set_layout;
   } else {
     iree_hal_vulkan_destroy_descriptor_set_layout(logical_device, handle);
   }
 
+  // Push descriptor templates are tied to a pipeline layout and are created
+  // by the executable layouts using this set layout instead.
+  if (iree_status_is_ok(status) && !descriptor_set_layout->is_push &&
+      logical_device->enabled_extensions().descriptor_update_template) {
+    status = iree_hal_vulkan_native_descriptor_set_layout_create_template(
+        *out_descriptor_set_layout,
+        VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET_KHR,
+        /*pipeline_layout=*/VK_NULL_HANDLE, /*set=*/0,
+        &descriptor_set_layout->update_template);
+    if (!iree_status_is_ok(status)) {
+      iree_hal_descriptor_set_layout_release(*out_descriptor_set_layout);
+      *out_descriptor_set_layout = NULL;
+    }
+  }
+
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
@@ -137,6 +180,13 @@ static void iree_hal_vulkan_native_descriptor_set_layout_destroy(
       descriptor_set_layout->logical_device->host_allocator();
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  if (descriptor_set_layout->update_template != VK_NULL_HANDLE) {
+    descriptor_set_layout->logical_device->syms()
+        ->vkDestroyDescriptorUpdateTemplateKHR(
+            *descriptor_set_layout->logical_device,
+            descriptor_set_layout->update_template,
+            descriptor_set_layout->logical_device->allocator());
+  }
   iree_hal_vulkan_destroy_descriptor_set_layout(
       descriptor_set_layout->logical_device, descriptor_set_layout->handle);
   iree_allocator_free(host_allocator, descriptor_set_layout);
@@ -152,6 +202,91 @@ VkDescriptorSetLayout iree_hal_vulkan_native_descriptor_set_layout_handle(
   return descriptor_set_layout->handle;
 }
 
+bool iree_hal_vulkan_native_descriptor_set_layout_is_push(
+    iree_hal_descriptor_set_layout_t* base_descriptor_set_layout) {
+  iree_hal_vulkan_native_descriptor_set_layout_t* descriptor_set_layout =
+      iree_hal_vulkan_native_descriptor_set_layout_cast(
+          base_descriptor_set_layout);
+  return descriptor_set_layout->is_push;
+}
+
+VkDescriptorUpdateTemplateKHR
+iree_hal_vulkan_native_descriptor_set_layout_update_template(
+    iree_hal_descriptor_set_layout_t* base_descriptor_set_layout) {
+  iree_hal_vulkan_native_descriptor_set_layout_t* descriptor_set_layout =
+      iree_hal_vulkan_native_descriptor_set_layout_cast(
+          base_descriptor_set_layout);
+  return descriptor_set_layout->update_template;
+}
+
+iree_host_size_t iree_hal_vulkan_native_descriptor_set_layout_binding_count(
+    iree_hal_descriptor_set_layout_t* base_descriptor_set_layout) {
+  iree_hal_vulkan_native_descriptor_set_layout_t* descriptor_set_layout =
+      iree_hal_vulkan_native_descriptor_set_layout_cast(
+          base_descriptor_set_layout);
+  return descriptor_set_layout->binding_count;
+}
+
+bool iree_hal_vulkan_native_descriptor_set_layout_binding_ordinal(
+    iree_hal_descriptor_set_layout_t* base_descriptor_set_layout,
+    uint32_t binding, iree_host_size_t* out_ordinal) {
+  iree_hal_vulkan_native_descriptor_set_layout_t* descriptor_set_layout =
+      iree_hal_vulkan_native_descriptor_set_layout_cast(
+          base_descriptor_set_layout);
+  for (iree_host_size_t i = 0; i < descriptor_set_layout->binding_count; ++i) {
+    if (descriptor_set_layout->bindings[i].binding == binding) {
+      *out_ordinal = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+iree_status_t iree_hal_vulkan_native_descriptor_set_layout_create_template(
+    iree_hal_descriptor_set_layout_t* base_descriptor_set_layout,
+    VkDescriptorUpdateTemplateTypeKHR template_type,
+    VkPipelineLayout pipeline_layout, uint32_t set,
+    VkDescriptorUpdateTemplateKHR* out_update_template) {
+  iree_hal_vulkan_native_descriptor_set_layout_t* descriptor_set_layout =
+      iree_hal_vulkan_native_descriptor_set_layout_cast(
+          base_descriptor_set_layout);
+  VkDeviceHandle* logical_device = descriptor_set_layout->logical_device;
+  *out_update_template = VK_NULL_HANDLE;
+
+  iree_host_size_t binding_count = descriptor_set_layout->binding_count;
+  VkDescriptorUpdateTemplateEntryKHR* entries =
+      (VkDescriptorUpdateTemplateEntryKHR*)iree_alloca(
+          binding_count * sizeof(VkDescriptorUpdateTemplateEntryKHR));
+  for (iree_host_size_t i = 0; i < binding_count; ++i) {
+    VkDescriptorUpdateTemplateEntryKHR* entry = &entries[i];
+    entry->dstBinding = descriptor_set_layout->bindings[i].binding;
+    entry->dstArrayElement = 0;
+    entry->descriptorCount = 1;
+    entry->descriptorType = static_cast<VkDescriptorType>(
+        descriptor_set_layout->bindings[i].type);
+    entry->offset = i * sizeof(VkDescriptorBufferInfo);
+    entry->stride = sizeof(VkDescriptorBufferInfo);
+  }
+
+  VkDescriptorUpdateTemplateCreateInfoKHR create_info;
+  create_info.sType =
+      VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO_KHR;
+  create_info.pNext = NULL;
+  create_info.flags = 0;
+  create_info.descriptorUpdateEntryCount = (uint32_t)binding_count;
+  create_info.pDescriptorUpdateEntries = entries;
+  create_info.templateType = template_type;
+  create_info.descriptorSetLayout = descriptor_set_layout->handle;
+  create_info.pipelineBindPoint = VK_PIPELINE_BIND_POINT_COMPUTE;
+  create_info.pipelineLayout = pipeline_layout;
+  create_info.set = set;
+  return VK_RESULT_TO_STATUS(
+      logical_device->syms()->vkCreateDescriptorUpdateTemplateKHR(
+          *logical_device, &create_info, logical_device->allocator(),
+          out_update_template),
+      "vkCreateDescriptorUpdateTemplateKHR");
+}
+
 const iree_hal_descriptor_set_layout_vtable_t
     iree_hal_vulkan_native_descriptor_set_layout_vtable = {
         /*.destroy=*/iree_hal_vulkan_native_descriptor_set_layout_destroy,
@@ -27,6 +27,43 @@ iree_status_t iree_hal_vulkan_native_descriptor_set_layout_create(
 VkDescriptorSetLayout iree_hal_vulkan_native_descriptor_set_layout_handle(
     iree_hal_descriptor_set_layout_t* base_descriptor_set_layout);
 
+// Returns true if the layout was created with
+// VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR.
+bool iree_hal_vulkan_native_descriptor_set_layout_is_push(
+    iree_hal_descriptor_set_layout_t* base_descriptor_set_layout);
+
+// Returns a descriptor update template that writes all of the bindings of a
+// descriptor set allocated with the layout from an array of
+// VkDescriptorBufferInfo indexed by binding ordinal (see
+// iree_hal_vulkan_native_descriptor_set_layout_binding_ordinal).
+// Returns VK_NULL_HANDLE for push descriptor layouts or if
+// VK_KHR_descriptor_update_template is not available.
+VkDescriptorUpdateTemplateKHR
+iree_hal_vulkan_native_descriptor_set_layout_update_template(
+    iree_hal_descriptor_set_layout_t* base_descriptor_set_layout);
+
+// Returns the total number of bindings in the layout.
+iree_host_size_t iree_hal_vulkan_native_descriptor_set_layout_binding_count(
+    iree_hal_descriptor_set_layout_t* base_descriptor_set_layout);
+
+// Returns the ordinal of |binding| within the layout in |out_ordinal| or
+// false if the layout has no such binding.
+bool iree_hal_vulkan_native_descriptor_set_layout_binding_ordinal(
+    iree_hal_descriptor_set_layout_t* base_descriptor_set_layout,
+    uint32_t binding, iree_host_size_t* out_ordinal);
+
+// Creates a descriptor update template of |template_type| covering all of the
+// bindings of the layout with the same data layout as the one returned by
+// iree_hal_vulkan_native_descriptor_set_layout_update_template.
+// |pipeline_layout| and |set| are only used for push descriptor templates.
+// The caller must destroy the template with
+// vkDestroyDescriptorUpdateTemplateKHR.
+iree_status_t iree_hal_vulkan_native_descriptor_set_layout_create_template(
+    iree_hal_descriptor_set_layout_t* base_descriptor_set_layout,
+    VkDescriptorUpdateTemplateTypeKHR template_type,
+    VkPipelineLayout pipeline_layout, uint32_t set,
+    VkDescriptorUpdateTemplateKHR* out_update_template);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
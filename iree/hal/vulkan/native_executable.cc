@@ -11,6 +11,7 @@
 #include <cstring>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/synchronization.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/vulkan/dynamic_symbol_tables.h"
 #include "iree/hal/vulkan/dynamic_symbols.h"
@@ -28,7 +29,11 @@ using namespace iree::hal::vulkan;
 
 typedef struct iree_hal_vulkan_entry_point_t {
   VkPipeline pipeline;
+  // NUL-terminated entry point name stored in the executable allocation.
   iree_string_view_t name;
+  // Layout the pipeline is created with. Only retained while the pipeline
+  // creation is deferred to first use.
+  iree_hal_executable_layout_t* layout;
 } iree_hal_vulkan_entry_point_t;
 
 static iree_status_t iree_hal_vulkan_create_shader_module(
@@ -55,72 +60,80 @@ static void iree_hal_vulkan_destroy_shader_module(
                                                 logical_device->allocator());
 }
 
-static iree_status_t iree_hal_vulkan_create_pipelines(
+// Returns the VkPipelineCreateFlags used for all pipelines created for an
+// executable prepared with |caching_mode|.
+static VkPipelineCreateFlags iree_hal_vulkan_pipeline_create_flags(
+    iree_hal_executable_caching_mode_t caching_mode) {
+  VkPipelineCreateFlags flags = 0;
+  if (!iree_all_bits_set(caching_mode,
+                         IREE_HAL_EXECUTABLE_CACHING_MODE_ALLOW_OPTIMIZATION)) {
+    flags |= VK_PIPELINE_CREATE_DISABLE_OPTIMIZATION_BIT;
+  }
+  return flags;
+}
+
+// Creates the pipeline for the |entry_point| named function in
+// |shader_module|. Each pipeline gets its own trace zone so that expensive
+// kernels stand out in captures.
+static iree_status_t iree_hal_vulkan_create_pipeline(
     VkDeviceHandle* logical_device, VkPipelineCache pipeline_cache,
-    iree_hal_executable_caching_mode_t caching_mode,
-    iree_SpirVExecutableDef_table_t executable_def,
-    VkShaderModule shader_module, iree_host_size_t executable_layout_count,
-    iree_hal_executable_layout_t* const* executable_layouts,
-    iree_host_size_t pipeline_count,
-    iree_hal_vulkan_entry_point_t* out_entry_points) {
-  IREE_TRACE_SCOPE();
-  VkComputePipelineCreateInfo* create_infos = NULL;
-  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
-      logical_device->host_allocator(),
-      pipeline_count * sizeof(VkComputePipelineCreateInfo),
-      (void**)&create_infos));
+    VkPipelineCreateFlags flags, VkShaderModule shader_module,
+    const iree_hal_vulkan_entry_point_t* entry_point,
+    VkPipeline base_pipeline, VkPipeline* out_pipeline) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_TEXT(z0, entry_point->name.data,
+                              entry_point->name.size);
 
-  flatbuffers_string_vec_t entry_points_vec =
-      iree_SpirVExecutableDef_entry_points_get(executable_def);
-  for (iree_host_size_t entry_ordinal = 0; entry_ordinal < pipeline_count;
-       ++entry_ordinal) {
-    VkComputePipelineCreateInfo* create_info = &create_infos[entry_ordinal];
-    create_info->sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-    create_info->pNext = NULL;
-    create_info->flags = 0;
-    if (!iree_all_bits_set(
-            caching_mode,
-            IREE_HAL_EXECUTABLE_CACHING_MODE_ALLOW_OPTIMIZATION)) {
-      create_info->flags |= VK_PIPELINE_CREATE_DISABLE_OPTIMIZATION_BIT;
-    }
-    if (entry_ordinal == 0) {
-      create_info->flags |= VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT;
-    } else {
-      create_info->flags |= VK_PIPELINE_CREATE_DERIVATIVE_BIT;
-    }
-    create_info->layout = iree_hal_vulkan_native_executable_layout_handle(
-        executable_layouts[entry_ordinal]);
-    create_info->basePipelineHandle = VK_NULL_HANDLE;
-    create_info->basePipelineIndex = 0;
-    VkPipelineShaderStageCreateInfo* stage_create_info = &create_info->stage;
-    stage_create_info->sType =
-        VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    stage_create_info->pNext = NULL;
-    stage_create_info->flags = 0;
-    stage_create_info->stage = VK_SHADER_STAGE_COMPUTE_BIT;
-    stage_create_info->module = shader_module;
-    stage_create_info->pName =
-        flatbuffers_string_vec_at(entry_points_vec, entry_ordinal);
-    stage_create_info->pSpecializationInfo = NULL;
-  }
+  VkComputePipelineCreateInfo create_info;
+  create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+  create_info.pNext = NULL;
+  create_info.flags = flags;
+  create_info.layout =
+      iree_hal_vulkan_native_executable_layout_handle(entry_point->layout);
+  create_info.basePipelineHandle = base_pipeline;
+  create_info.basePipelineIndex = -1;
+  VkPipelineShaderStageCreateInfo* stage_create_info = &create_info.stage;
+  stage_create_info->sType =
+      VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  stage_create_info->pNext = NULL;
+  stage_create_info->flags = 0;
+  stage_create_info->stage = VK_SHADER_STAGE_COMPUTE_BIT;
+  stage_create_info->module = shader_module;
+  stage_create_info->pName = entry_point->name.data;
+  stage_create_info->pSpecializationInfo = NULL;
 
-  VkPipeline* pipelines =
-      (VkPipeline*)iree_alloca(pipeline_count * sizeof(VkPipeline));
   iree_status_t status = VK_RESULT_TO_STATUS(
       logical_device->syms()->vkCreateComputePipelines(
-          *logical_device, pipeline_cache, (uint32_t)pipeline_count,
-          create_infos, logical_device->allocator(), pipelines),
+          *logical_device, pipeline_cache, 1, &create_info,
+          logical_device->allocator(), out_pipeline),
       "vkCreateComputePipelines");
-  if (iree_status_is_ok(status)) {
-    for (iree_host_size_t i = 0; i < pipeline_count; ++i) {
-      out_entry_points[i].pipeline = pipelines[i];
-    }
-  }
 
-  iree_allocator_free(logical_device->host_allocator(), create_infos);
+  IREE_TRACE_ZONE_END(z0);
   return status;
 }
 
+// Creates the pipelines for all |entry_points| up front. The first pipeline
+// is used as the base for the others so that drivers supporting derivatives
+// can share work between them.
+static iree_status_t iree_hal_vulkan_create_pipelines(
+    VkDeviceHandle* logical_device, VkPipelineCache pipeline_cache,
+    VkPipelineCreateFlags flags, VkShaderModule shader_module,
+    iree_host_size_t entry_point_count,
+    iree_hal_vulkan_entry_point_t* entry_points) {
+  IREE_TRACE_SCOPE();
+  VkPipeline base_pipeline = VK_NULL_HANDLE;
+  for (iree_host_size_t i = 0; i < entry_point_count; ++i) {
+    VkPipelineCreateFlags entry_flags =
+        flags | (i == 0 ? VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT
+                        : VK_PIPELINE_CREATE_DERIVATIVE_BIT);
+    IREE_RETURN_IF_ERROR(iree_hal_vulkan_create_pipeline(
+        logical_device, pipeline_cache, entry_flags, shader_module,
+        &entry_points[i], base_pipeline, &entry_points[i].pipeline));
+    if (i == 0) base_pipeline = entry_points[i].pipeline;
+  }
+  return iree_ok_status();
+}
+
 static void iree_hal_vulkan_destroy_pipeline(VkDeviceHandle* logical_device,
                                              VkPipeline handle) {
   IREE_TRACE_SCOPE();
@@ -195,6 +208,16 @@ static iree_status_t iree_hal_spirv_executable_flatbuffer_verify(
 typedef struct iree_hal_vulkan_native_executable_t {
   iree_hal_resource_t resource;
   VkDeviceHandle* logical_device;
+
+  // State required to create pipelines on first use. |shader_module| is
+  // VK_NULL_HANDLE if all pipelines were created with the executable.
+  VkShaderModule shader_module;
+  VkPipelineCache pipeline_cache;
+  VkPipelineCreateFlags pipeline_flags;
+  // Guards lazy pipeline creation as command buffers referencing the
+  // executable may be recorded concurrently.
+  iree_slim_mutex_t mutex;
+
   iree_host_size_t entry_point_count;
   iree_hal_vulkan_entry_point_t entry_points[];
 } iree_hal_vulkan_native_executable_t;
@@ -210,7 +233,7 @@ iree_hal_vulkan_native_executable_cast(iree_hal_executable_t* base_value) {
 
 iree_status_t iree_hal_vulkan_native_executable_create(
     iree::hal::vulkan::VkDeviceHandle* logical_device,
-    VkPipelineCache pipeline_cache,
+    VkPipelineCache pipeline_cache, bool defer_pipeline_creation,
     const iree_hal_executable_spec_t* executable_spec,
     iree_hal_executable_t** out_executable) {
   IREE_ASSERT_ARGUMENT(logical_device);
@@ -239,49 +262,77 @@ iree_status_t iree_hal_vulkan_native_executable_create(
                   flatbuffers_uint32_vec_len(code_vec) * sizeof(uint32_t)),
               &shader_module));
 
-  // Create pipelines for each entry point.
+  // The entry point names are copied into the executable as the flatbuffer
+  // is not guaranteed to outlive it and pipelines may be created lazily.
   flatbuffers_string_vec_t entry_points_vec =
       iree_SpirVExecutableDef_entry_points_get(executable_def);
   iree_host_size_t entry_point_count =
       flatbuffers_string_vec_len(entry_points_vec);
+  iree_host_size_t total_name_size = 0;
+  for (iree_host_size_t i = 0; i < entry_point_count; ++i) {
+    total_name_size += flatbuffers_string_len(
+                           flatbuffers_string_vec_at(entry_points_vec, i)) +
+                       /*NUL=*/1;
+  }
 
   iree_hal_vulkan_native_executable_t* executable = NULL;
   iree_host_size_t total_size =
       sizeof(*executable) +
-      entry_point_count * sizeof(*executable->entry_points);
+      entry_point_count * sizeof(*executable->entry_points) + total_name_size;
   iree_status_t status = iree_allocator_malloc(logical_device->host_allocator(),
                                                total_size, (void**)&executable);
   if (iree_status_is_ok(status)) {
     iree_hal_resource_initialize(&iree_hal_vulkan_native_executable_vtable,
                                  &executable->resource);
     executable->logical_device = logical_device;
+    executable->shader_module = VK_NULL_HANDLE;
+    executable->pipeline_cache = pipeline_cache;
+    executable->pipeline_flags =
+        iree_hal_vulkan_pipeline_create_flags(executable_spec->caching_mode);
+    iree_slim_mutex_initialize(&executable->mutex);
     executable->entry_point_count = entry_point_count;
     memset(executable->entry_points, 0,
            entry_point_count * sizeof(*executable->entry_points));
-  }
-  if (iree_status_is_ok(status)) {
-    status = iree_hal_vulkan_create_pipelines(
-        logical_device, pipeline_cache, executable_spec->caching_mode,
-        executable_def, shader_module, executable_spec->executable_layout_count,
-        executable_spec->executable_layouts, executable->entry_point_count,
-        executable->entry_points);
-  }
-  iree_hal_vulkan_destroy_shader_module(logical_device, shader_module);
-
-  if (iree_status_is_ok(status)) {
-    flatbuffers_string_vec_t entry_points_vec =
-        iree_SpirVExecutableDef_entry_points_get(executable_def);
+    char* name_ptr =
+        (char*)(executable->entry_points + executable->entry_point_count);
     for (iree_host_size_t i = 0; i < entry_point_count; ++i) {
       flatbuffers_string_t name =
           flatbuffers_string_vec_at(entry_points_vec, i);
+      iree_host_size_t name_length = flatbuffers_string_len(name);
+      memcpy(name_ptr, name, name_length);
+      name_ptr[name_length] = '\0';
       executable->entry_points[i].name =
-          iree_make_string_view(name, flatbuffers_string_len(name));
+          iree_make_string_view(name_ptr, name_length);
+      executable->entry_points[i].layout =
+          executable_spec->executable_layouts[i];
+      name_ptr += name_length + 1;
     }
   }
 
+  if (iree_status_is_ok(status)) {
+    if (defer_pipeline_creation) {
+      // Keep the shader module and layouts alive until all pipelines have
+      // been created on first use.
+      executable->shader_module = shader_module;
+      shader_module = VK_NULL_HANDLE;
+      for (iree_host_size_t i = 0; i < entry_point_count; ++i) {
+        iree_hal_executable_layout_retain(executable->entry_points[i].layout);
+      }
+    } else {
+      status = iree_hal_vulkan_create_pipelines(
+          logical_device, pipeline_cache, executable->pipeline_flags,
+          shader_module, executable->entry_point_count,
+          executable->entry_points);
+      for (iree_host_size_t i = 0; i < entry_point_count; ++i) {
+        executable->entry_points[i].layout = NULL;
+      }
+    }
+  }
+  iree_hal_vulkan_destroy_shader_module(logical_device, shader_module);
+
   if (iree_status_is_ok(status)) {
     *out_executable = (iree_hal_executable_t*)executable;
-  } else {
+  } else if (executable) {
     iree_hal_executable_destroy((iree_hal_executable_t*)executable);
   }
 
@@ -300,7 +351,11 @@ static void iree_hal_vulkan_native_executable_destroy(
   for (iree_host_size_t i = 0; i < executable->entry_point_count; ++i) {
     iree_hal_vulkan_destroy_pipeline(executable->logical_device,
                                      executable->entry_points[i].pipeline);
+    iree_hal_executable_layout_release(executable->entry_points[i].layout);
   }
+  iree_hal_vulkan_destroy_shader_module(executable->logical_device,
+                                        executable->shader_module);
+  iree_slim_mutex_deinitialize(&executable->mutex);
   iree_allocator_free(host_allocator, executable);
 
   IREE_TRACE_ZONE_END(z0);
@@ -331,8 +386,27 @@ iree_status_t iree_hal_vulkan_native_executable_pipeline_for_entry_point(
     return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
                             "invalid entry point ordinal %zu", entry_ordinal);
   }
-  *out_pipeline_handle = executable->entry_points[entry_ordinal].pipeline;
-  return iree_ok_status();
+  iree_hal_vulkan_entry_point_t* entry_point =
+      &executable->entry_points[entry_ordinal];
+  if (executable->shader_module == VK_NULL_HANDLE) {
+    // All pipelines were created with the executable.
+    *out_pipeline_handle = entry_point->pipeline;
+    return iree_ok_status();
+  }
+
+  // Create the pipeline on first use. Derivatives are not used here as there
+  // is no guarantee any particular base pipeline has been created.
+  iree_status_t status = iree_ok_status();
+  iree_slim_mutex_lock(&executable->mutex);
+  if (entry_point->pipeline == VK_NULL_HANDLE) {
+    status = iree_hal_vulkan_create_pipeline(
+        executable->logical_device, executable->pipeline_cache,
+        executable->pipeline_flags, executable->shader_module, entry_point,
+        /*base_pipeline=*/VK_NULL_HANDLE, &entry_point->pipeline);
+  }
+  *out_pipeline_handle = entry_point->pipeline;
+  iree_slim_mutex_unlock(&executable->mutex);
+  return status;
 }
 
 const iree_hal_executable_vtable_t iree_hal_vulkan_native_executable_vtable = {
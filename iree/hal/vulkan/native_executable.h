@@ -28,9 +28,15 @@ typedef struct iree_hal_vulkan_source_location_t {
 // Creates a wrapper for one or more VkPipelines that are sourced from the same
 // IREE executable. Each of the pipelines will share the same shader module
 // and just differs by the entry point into the shader module they reference.
+//
+// If |defer_pipeline_creation| is set pipelines are not created until their
+// entry point is first requested with
+// iree_hal_vulkan_native_executable_pipeline_for_entry_point so that the
+// load time of executables with many entry points only includes the ones
+// actually used.
 iree_status_t iree_hal_vulkan_native_executable_create(
     iree::hal::vulkan::VkDeviceHandle* logical_device,
-    VkPipelineCache pipeline_cache,
+    VkPipelineCache pipeline_cache, bool defer_pipeline_creation,
     const iree_hal_executable_spec_t* executable_spec,
     iree_hal_executable_t** out_executable);
 
@@ -40,7 +46,8 @@ void iree_hal_vulkan_native_executable_entry_point_source_location(
     iree_hal_executable_t* executable, iree_host_size_t entry_ordinal,
     iree_hal_vulkan_source_location_t* out_source_location);
 
-// Returns the cached VkPipeline for the given executable |entry_ordinal|.
+// Returns the cached VkPipeline for the given executable |entry_ordinal|,
+// creating it first if pipeline creation was deferred. Thread-safe.
 iree_status_t iree_hal_vulkan_native_executable_pipeline_for_entry_point(
     iree_hal_executable_t* executable, iree_host_size_t entry_ordinal,
     VkPipeline* out_pipeline_handle);
@@ -24,6 +24,9 @@ typedef struct iree_hal_vulkan_native_executable_layout_t {
   VkDeviceHandle* logical_device;
   VkPipelineLayout handle;
   iree_host_size_t set_layout_count;
+  // Push descriptor update template for each set, or VK_NULL_HANDLE if the
+  // set is not a push descriptor set or templates are unavailable.
+  VkDescriptorUpdateTemplateKHR* push_templates;
   iree_hal_descriptor_set_layout_t* set_layouts[];
 } iree_hal_vulkan_native_executable_layout_t;
 
@@ -99,7 +102,8 @@ iree_status_t iree_hal_vulkan_native_executable_layout_create(
   iree_hal_vulkan_native_executable_layout_t* executable_layout = NULL;
   iree_host_size_t total_size =
       sizeof(*executable_layout) +
-      set_layout_count * sizeof(*executable_layout->set_layouts);
+      set_layout_count * sizeof(*executable_layout->set_layouts) +
+      set_layout_count * sizeof(*executable_layout->push_templates);
   iree_status_t status = iree_allocator_malloc(
       logical_device->host_allocator(), total_size, (void**)&executable_layout);
   if (iree_status_is_ok(status)) {
@@ -109,15 +113,41 @@ iree_status_t iree_hal_vulkan_native_executable_layout_create(
     executable_layout->logical_device = logical_device;
     executable_layout->handle = handle;
     executable_layout->set_layout_count = set_layout_count;
+    executable_layout->push_templates =
+        (VkDescriptorUpdateTemplateKHR*)(executable_layout->set_layouts +
+                                         set_layout_count);
     for (iree_host_size_t i = 0; i < set_layout_count; ++i) {
       executable_layout->set_layouts[i] = set_layouts[i];
       iree_hal_descriptor_set_layout_retain(set_layouts[i]);
+      executable_layout->push_templates[i] = VK_NULL_HANDLE;
     }
     *out_executable_layout = (iree_hal_executable_layout_t*)executable_layout;
   } else {
     iree_hal_vulkan_destroy_pipeline_layout(logical_device, handle);
   }
 
+  // Push descriptor templates reference the pipeline layout and set index so
+  // unlike normal descriptor set templates they can't live on the set layout.
+  bool use_push_templates =
+      logical_device->enabled_extensions().descriptor_update_template &&
+      logical_device->syms()->vkCmdPushDescriptorSetWithTemplateKHR;
+  for (iree_host_size_t i = 0;
+       use_push_templates && iree_status_is_ok(status) && i < set_layout_count;
+       ++i) {
+    if (!iree_hal_vulkan_native_descriptor_set_layout_is_push(
+            set_layouts[i])) {
+      continue;
+    }
+    status = iree_hal_vulkan_native_descriptor_set_layout_create_template(
+        set_layouts[i], VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR,
+        handle, (uint32_t)i, &executable_layout->push_templates[i]);
+  }
+  if (!iree_status_is_ok(status) && executable_layout) {
+    iree_hal_executable_layout_release(
+        (iree_hal_executable_layout_t*)executable_layout);
+    *out_executable_layout = NULL;
+  }
+
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
@@ -130,7 +160,15 @@ static void iree_hal_vulkan_native_executable_layout_destroy(
       executable_layout->logical_device->host_allocator();
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  iree_hal_vulkan_destroy_pipeline_layout(executable_layout->logical_device,
+  VkDeviceHandle* logical_device = executable_layout->logical_device;
+  for (iree_host_size_t i = 0; i < executable_layout->set_layout_count; ++i) {
+    if (executable_layout->push_templates[i] != VK_NULL_HANDLE) {
+      logical_device->syms()->vkDestroyDescriptorUpdateTemplateKHR(
+          *logical_device, executable_layout->push_templates[i],
+          logical_device->allocator());
+    }
+  }
+  iree_hal_vulkan_destroy_pipeline_layout(logical_device,
                                           executable_layout->handle);
   for (iree_host_size_t i = 0; i < executable_layout->set_layout_count; ++i) {
     iree_hal_descriptor_set_layout_release(executable_layout->set_layouts[i]);
@@ -165,6 +203,18 @@ iree_hal_descriptor_set_layout_t* iree_hal_vulkan_native_executable_layout_set(
   return executable_layout->set_layouts[set_index];
 }
 
+VkDescriptorUpdateTemplateKHR
+iree_hal_vulkan_native_executable_layout_push_template(
+    iree_hal_executable_layout_t* base_executable_layout,
+    iree_host_size_t set_index) {
+  iree_hal_vulkan_native_executable_layout_t* executable_layout =
+      iree_hal_vulkan_native_executable_layout_cast(base_executable_layout);
+  if (IREE_UNLIKELY(set_index >= executable_layout->set_layout_count)) {
+    return VK_NULL_HANDLE;
+  }
+  return executable_layout->push_templates[set_index];
+}
+
 const iree_hal_executable_layout_vtable_t
     iree_hal_vulkan_native_executable_layout_vtable = {
         /*.destroy=*/iree_hal_vulkan_native_executable_layout_destroy,
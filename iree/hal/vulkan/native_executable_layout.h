@@ -40,6 +40,15 @@ iree_hal_descriptor_set_layout_t* iree_hal_vulkan_native_executable_layout_set(
     iree_hal_executable_layout_t* executable_layout,
     iree_host_size_t set_index);
 
+// Returns the push descriptor update template for the set with the given
+// |set_index|, or VK_NULL_HANDLE if the set does not use push descriptors or
+// templates are not available. The template data is laid out as described by
+// iree_hal_vulkan_native_descriptor_set_layout_update_template.
+VkDescriptorUpdateTemplateKHR
+iree_hal_vulkan_native_executable_layout_push_template(
+    iree_hal_executable_layout_t* executable_layout,
+    iree_host_size_t set_index);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -18,6 +18,8 @@ using namespace iree::hal::vulkan;
 typedef struct iree_hal_vulkan_nop_executable_cache_t {
   iree_hal_resource_t resource;
   VkDeviceHandle* logical_device;
+  VkPipelineCache pipeline_cache;
+  bool defer_pipeline_creation;
 } iree_hal_vulkan_nop_executable_cache_t;
 
 extern const iree_hal_executable_cache_vtable_t
@@ -33,6 +35,7 @@ iree_hal_vulkan_nop_executable_cache_cast(
 
 iree_status_t iree_hal_vulkan_nop_executable_cache_create(
     iree::hal::vulkan::VkDeviceHandle* logical_device,
+    VkPipelineCache pipeline_cache, bool defer_pipeline_creation,
     iree_string_view_t identifier,
     iree_hal_executable_cache_t** out_executable_cache) {
   IREE_ASSERT_ARGUMENT(out_executable_cache);
@@ -47,6 +50,8 @@ iree_status_t iree_hal_vulkan_nop_executable_cache_create(
     iree_hal_resource_initialize(&iree_hal_vulkan_nop_executable_cache_vtable,
                                  &executable_cache->resource);
     executable_cache->logical_device = logical_device;
+    executable_cache->pipeline_cache = pipeline_cache;
+    executable_cache->defer_pipeline_creation = defer_pipeline_creation;
 
     *out_executable_cache = (iree_hal_executable_cache_t*)executable_cache;
   }
@@ -83,8 +88,9 @@ static iree_status_t iree_hal_vulkan_nop_executable_cache_prepare_executable(
   iree_hal_vulkan_nop_executable_cache_t* executable_cache =
       iree_hal_vulkan_nop_executable_cache_cast(base_executable_cache);
   return iree_hal_vulkan_native_executable_create(
-      executable_cache->logical_device,
-      /*pipeline_cache=*/VK_NULL_HANDLE, executable_spec, out_executable);
+      executable_cache->logical_device, executable_cache->pipeline_cache,
+      executable_cache->defer_pipeline_creation, executable_spec,
+      out_executable);
 }
 
 const iree_hal_executable_cache_vtable_t
@@ -15,11 +15,14 @@
 extern "C" {
 #endif  // __cplusplus
 
-// Creates a no-op executable cache that does not cache at all.
-// This is useful to isolate pipeline caching behavior and verify compilation
-// behavior.
+// Creates an executable cache that does not cache executables itself and only
+// creates pipelines through the device-wide |pipeline_cache| (which may be
+// VK_NULL_HANDLE). See iree_hal_vulkan_native_executable_create for
+// |defer_pipeline_creation|. This is useful to isolate pipeline caching
+// behavior and verify compilation behavior.
 iree_status_t iree_hal_vulkan_nop_executable_cache_create(
     iree::hal::vulkan::VkDeviceHandle* logical_device,
+    VkPipelineCache pipeline_cache, bool defer_pipeline_creation,
     iree_string_view_t identifier,
     iree_hal_executable_cache_t** out_executable_cache);
 
@@ -0,0 +1,290 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/vulkan/profiling.h"
+
+#include <cstring>
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/vulkan/native_executable.h"
+#include "iree/hal/vulkan/status_util.h"
+
+// Maximum number of timestamp queries allocated for the device. Each profiled
+// dispatch consumes two.
+#define IREE_HAL_VULKAN_PROFILING_DEFAULT_QUERY_CAPACITY (8 * 1024)
+
+typedef struct iree_hal_vulkan_profiling_query_result_t {
+  uint64_t timestamp;
+  uint64_t availability;  // non-zero if available
+} iree_hal_vulkan_profiling_query_result_t;
+
+typedef struct iree_hal_vulkan_profiling_record_t {
+  // Retained until the record is reported or discarded so that the entry point
+  // name remains valid.
+  iree_hal_executable_t* executable;
+  int32_t entry_point;
+  uint32_t workgroup_count[3];
+} iree_hal_vulkan_profiling_record_t;
+
+struct iree_hal_vulkan_profiling_context_t {
+  iree::hal::vulkan::VkDeviceHandle* logical_device;
+  iree_allocator_t host_allocator;
+
+  // Number of nanoseconds required for a timestamp query to be incremented
+  // by 1.
+  float timestamp_period;
+
+  // Non-zero while a profiling session is active. Checked without the lock so
+  // that recording dispatches outside of a session stays cheap.
+  iree_atomic_int32_t active;
+
+  VkQueryPool query_pool;
+  uint32_t query_capacity;
+
+  iree_slim_mutex_t mutex;
+
+  // Records of the current session; record i uses queries 2*i and 2*i+1.
+  // Reported records have a NULL executable.
+  uint32_t record_count;
+  iree_hal_vulkan_profiling_record_t* records;
+
+  // Scratch storage for reading back |query_capacity| query results.
+  iree_hal_vulkan_profiling_query_result_t* query_results;
+};
+
+static void iree_hal_vulkan_profiling_context_reset_queries(
+    iree_hal_vulkan_profiling_context_t* context, uint32_t query_count) {
+  if (!query_count) return;
+  iree::hal::vulkan::DynamicSymbols* syms =
+      context->logical_device->syms().get();
+  PFN_vkResetQueryPool vkResetQueryPool_fn = syms->vkResetQueryPool
+                                                 ? syms->vkResetQueryPool
+                                                 : syms->vkResetQueryPoolEXT;
+  vkResetQueryPool_fn(*context->logical_device, context->query_pool, 0,
+                      query_count);
+}
+
+// Releases all records of the current session. Must be called with the lock
+// held.
+static void iree_hal_vulkan_profiling_context_discard_records(
+    iree_hal_vulkan_profiling_context_t* context) {
+  for (uint32_t i = 0; i < context->record_count; ++i) {
+    iree_hal_executable_release(context->records[i].executable);
+  }
+  iree_hal_vulkan_profiling_context_reset_queries(context,
+                                                  context->record_count * 2);
+  context->record_count = 0;
+}
+
+iree_status_t iree_hal_vulkan_profiling_context_allocate(
+    VkPhysicalDevice physical_device,
+    iree::hal::vulkan::VkDeviceHandle* logical_device,
+    iree_allocator_t host_allocator,
+    iree_hal_vulkan_profiling_context_t** out_context) {
+  IREE_ASSERT_ARGUMENT(logical_device);
+  IREE_ASSERT_ARGUMENT(out_context);
+  *out_context = NULL;
+
+  const auto& syms = logical_device->syms();
+  if (!logical_device->enabled_extensions().host_query_reset ||
+      (!syms->vkResetQueryPool && !syms->vkResetQueryPoolEXT)) {
+    return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                            "dispatch profiling requires host query reset");
+  }
+  VkPhysicalDeviceProperties device_properties;
+  syms->vkGetPhysicalDeviceProperties(physical_device, &device_properties);
+  if (!device_properties.limits.timestampComputeAndGraphics) {
+    return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                            "device does not support timestamps on all "
+                            "graphics and compute queues");
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  VkQueryPoolCreateInfo pool_info;
+  memset(&pool_info, 0, sizeof(pool_info));
+  pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  pool_info.queryCount = IREE_HAL_VULKAN_PROFILING_DEFAULT_QUERY_CAPACITY;
+  pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+  VkQueryPool query_pool = VK_NULL_HANDLE;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, VK_RESULT_TO_STATUS(
+              syms->vkCreateQueryPool(*logical_device, &pool_info,
+                                      logical_device->allocator(), &query_pool),
+              "vkCreateQueryPool"));
+
+  const uint32_t record_capacity = pool_info.queryCount / 2;
+  iree_hal_vulkan_profiling_context_t* context = NULL;
+  iree_host_size_t total_size =
+      sizeof(*context) + record_capacity * sizeof(*context->records) +
+      pool_info.queryCount * sizeof(*context->query_results);
+  iree_status_t status =
+      iree_allocator_malloc(host_allocator, total_size, (void**)&context);
+  if (iree_status_is_ok(status)) {
+    memset(context, 0, sizeof(*context));
+    context->logical_device = logical_device;
+    context->host_allocator = host_allocator;
+    context->timestamp_period = device_properties.limits.timestampPeriod;
+    iree_atomic_store_int32(&context->active, 0, iree_memory_order_relaxed);
+    context->query_pool = query_pool;
+    context->query_capacity = pool_info.queryCount;
+    iree_slim_mutex_initialize(&context->mutex);
+    context->records =
+        (iree_hal_vulkan_profiling_record_t*)((uint8_t*)context +
+                                              sizeof(*context));
+    context->query_results =
+        (iree_hal_vulkan_profiling_query_result_t*)(context->records +
+                                                    record_capacity);
+
+    // All queries must be reset upon creation before first use.
+    iree_hal_vulkan_profiling_context_reset_queries(context,
+                                                    context->query_capacity);
+    *out_context = context;
+  } else {
+    syms->vkDestroyQueryPool(*logical_device, query_pool,
+                             logical_device->allocator());
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+void iree_hal_vulkan_profiling_context_free(
+    iree_hal_vulkan_profiling_context_t* context) {
+  if (!context) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  for (uint32_t i = 0; i < context->record_count; ++i) {
+    iree_hal_executable_release(context->records[i].executable);
+  }
+  iree_slim_mutex_deinitialize(&context->mutex);
+  context->logical_device->syms()->vkDestroyQueryPool(
+      *context->logical_device, context->query_pool,
+      context->logical_device->allocator());
+  iree_allocator_free(context->host_allocator, context);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+iree_status_t iree_hal_vulkan_profiling_context_begin(
+    iree_hal_vulkan_profiling_context_t* context) {
+  iree_slim_mutex_lock(&context->mutex);
+  iree_hal_vulkan_profiling_context_discard_records(context);
+  iree_atomic_store_int32(&context->active, 1, iree_memory_order_release);
+  iree_slim_mutex_unlock(&context->mutex);
+  return iree_ok_status();
+}
+
+void iree_hal_vulkan_profiling_context_end(
+    iree_hal_vulkan_profiling_context_t* context) {
+  iree_atomic_store_int32(&context->active, 0, iree_memory_order_release);
+}
+
+iree_status_t iree_hal_vulkan_profiling_context_flush(
+    iree_hal_vulkan_profiling_context_t* context,
+    iree_hal_dispatch_profile_callback_t callback) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_slim_mutex_lock(&context->mutex);
+
+  // Read back all results without waiting; queries of dispatches that have not
+  // yet executed are reported as unavailable.
+  iree_status_t status = iree_ok_status();
+  const uint32_t query_count = context->record_count * 2;
+  if (query_count > 0) {
+    VkResult result =
+        context->logical_device->syms()->vkGetQueryPoolResults(
+            *context->logical_device, context->query_pool, 0, query_count,
+            query_count * sizeof(*context->query_results),
+            context->query_results, sizeof(*context->query_results),
+            VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+    if (result != VK_NOT_READY) {
+      status = VK_RESULT_TO_STATUS(result, "vkGetQueryPoolResults");
+    }
+  }
+
+  for (uint32_t i = 0; i < context->record_count && iree_status_is_ok(status);
+       ++i) {
+    iree_hal_vulkan_profiling_record_t* record = &context->records[i];
+    if (!record->executable) continue;  // already reported
+    const iree_hal_vulkan_profiling_query_result_t* begin_result =
+        &context->query_results[i * 2 + 0];
+    const iree_hal_vulkan_profiling_query_result_t* end_result =
+        &context->query_results[i * 2 + 1];
+    if (!begin_result->availability || !end_result->availability) continue;
+
+    iree_hal_vulkan_source_location_t source_location;
+    iree_hal_vulkan_native_executable_entry_point_source_location(
+        record->executable, record->entry_point, &source_location);
+    iree_hal_dispatch_profile_t profile;
+    memset(&profile, 0, sizeof(profile));
+    profile.entry_point_name = source_location.func_name;
+    profile.entry_point = record->entry_point;
+    memcpy(profile.workgroup_count, record->workgroup_count,
+           sizeof(profile.workgroup_count));
+    uint64_t ticks = end_result->timestamp >= begin_result->timestamp
+                         ? end_result->timestamp - begin_result->timestamp
+                         : 0;
+    profile.duration_ns = (uint64_t)(ticks * context->timestamp_period);
+    status = callback.fn(callback.user_data, &profile);
+
+    iree_hal_executable_release(record->executable);
+    record->executable = NULL;
+  }
+
+  iree_slim_mutex_unlock(&context->mutex);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+uint32_t iree_hal_vulkan_profiling_context_begin_dispatch(
+    iree_hal_vulkan_profiling_context_t* context,
+    VkCommandBuffer command_buffer, iree_hal_executable_t* executable,
+    int32_t entry_point, uint32_t workgroup_x, uint32_t workgroup_y,
+    uint32_t workgroup_z) {
+  if (!context ||
+      !iree_atomic_load_int32(&context->active, iree_memory_order_acquire)) {
+    return IREE_HAL_VULKAN_PROFILING_QUERY_NONE;
+  }
+
+  iree_slim_mutex_lock(&context->mutex);
+  uint32_t query_index = IREE_HAL_VULKAN_PROFILING_QUERY_NONE;
+  if ((context->record_count + 1) * 2 <= context->query_capacity) {
+    iree_hal_vulkan_profiling_record_t* record =
+        &context->records[context->record_count];
+    record->executable = executable;
+    iree_hal_executable_retain(executable);
+    record->entry_point = entry_point;
+    record->workgroup_count[0] = workgroup_x;
+    record->workgroup_count[1] = workgroup_y;
+    record->workgroup_count[2] = workgroup_z;
+    query_index = context->record_count * 2;
+    ++context->record_count;
+  }
+  iree_slim_mutex_unlock(&context->mutex);
+  if (query_index == IREE_HAL_VULKAN_PROFILING_QUERY_NONE) {
+    return query_index;
+  }
+
+  // The in-stream reset allows command buffers to be submitted multiple times;
+  // the record is reported at most once with whichever execution completed.
+  const auto& syms = context->logical_device->syms();
+  syms->vkCmdResetQueryPool(command_buffer, context->query_pool, query_index,
+                            2);
+  syms->vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                            context->query_pool, query_index);
+  return query_index;
+}
+
+void iree_hal_vulkan_profiling_context_end_dispatch(
+    iree_hal_vulkan_profiling_context_t* context,
+    VkCommandBuffer command_buffer, uint32_t query_index) {
+  if (query_index == IREE_HAL_VULKAN_PROFILING_QUERY_NONE) return;
+  context->logical_device->syms()->vkCmdWriteTimestamp(
+      command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+      context->query_pool, query_index + 1);
+}
@@ -0,0 +1,91 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_VULKAN_PROFILING_H_
+#define IREE_HAL_VULKAN_PROFILING_H_
+
+// clang-format off: must be included before all other headers.
+#include "iree/hal/vulkan/vulkan_headers.h"
+// clang-format on
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/vulkan/handle_util.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Sentinel query index indicating a dispatch is not being profiled.
+#define IREE_HAL_VULKAN_PROFILING_QUERY_NONE UINT32_MAX
+
+// Per-device dispatch profiling context.
+// Available in all builds (unlike the tracing context) so that dispatch timings
+// can be captured in production via iree_hal_device_begin_dispatch_profiling.
+//
+// Each profiled dispatch is bracketed by a pair of timestamp queries from a
+// single device-wide VkQueryPool. Queries are allocated linearly during a
+// profiling session and are only reclaimed when the next session begins; once
+// the pool is exhausted further dispatches are recorded without profiling.
+// Results are read back without waiting so flushing only reports dispatches
+// that have completed execution.
+//
+// Requires VK_EXT_host_query_reset (or Vulkan 1.2) so that query resets need no
+// queue submission of their own.
+//
+// Thread-safe.
+typedef struct iree_hal_vulkan_profiling_context_t
+    iree_hal_vulkan_profiling_context_t;
+
+// Allocates a dispatch profiling context for |logical_device|.
+// Returns UNAVAILABLE if the device cannot support profiling.
+iree_status_t iree_hal_vulkan_profiling_context_allocate(
+    VkPhysicalDevice physical_device,
+    iree::hal::vulkan::VkDeviceHandle* logical_device,
+    iree_allocator_t host_allocator,
+    iree_hal_vulkan_profiling_context_t** out_context);
+
+// Frees a profiling context and all associated resources.
+// All submissions containing profiled dispatches must have completed.
+void iree_hal_vulkan_profiling_context_free(
+    iree_hal_vulkan_profiling_context_t* context);
+
+// Begins a new profiling session, discarding any unflushed profiles.
+iree_status_t iree_hal_vulkan_profiling_context_begin(
+    iree_hal_vulkan_profiling_context_t* context);
+
+// Ends the current profiling session, if any.
+void iree_hal_vulkan_profiling_context_end(
+    iree_hal_vulkan_profiling_context_t* context);
+
+// Reports all completed dispatch profiles to |callback|.
+// |callback| must not call back into the profiling context.
+iree_status_t iree_hal_vulkan_profiling_context_flush(
+    iree_hal_vulkan_profiling_context_t* context,
+    iree_hal_dispatch_profile_callback_t callback);
+
+// Records the start timestamp of a dispatch into |command_buffer| if a session
+// is active and returns the query index to pass to
+// iree_hal_vulkan_profiling_context_end_dispatch. Returns
+// IREE_HAL_VULKAN_PROFILING_QUERY_NONE if the dispatch is not being profiled.
+// |context| may be NULL.
+uint32_t iree_hal_vulkan_profiling_context_begin_dispatch(
+    iree_hal_vulkan_profiling_context_t* context,
+    VkCommandBuffer command_buffer, iree_hal_executable_t* executable,
+    int32_t entry_point, uint32_t workgroup_x, uint32_t workgroup_y,
+    uint32_t workgroup_z);
+
+// Records the end timestamp of a dispatch started with
+// iree_hal_vulkan_profiling_context_begin_dispatch.
+void iree_hal_vulkan_profiling_context_end_dispatch(
+    iree_hal_vulkan_profiling_context_t* context,
+    VkCommandBuffer command_buffer, uint32_t query_index);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_VULKAN_PROFILING_H_
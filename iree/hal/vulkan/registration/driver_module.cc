@@ -27,9 +27,20 @@ IREE_FLAG(int32_t, vulkan_default_index, 0,
 IREE_FLAG(bool, vulkan_force_timeline_semaphore_emulation, false,
           "Uses timeline semaphore emulation even if native support exists.");
 
+IREE_FLAG(int32_t, vulkan_dispatch_queue_count, 2,
+          "Maximum number of Vulkan queues used for dispatches.");
+IREE_FLAG(int32_t, vulkan_transfer_queue_count, 1,
+          "Maximum number of dedicated Vulkan queues used for transfers.");
+
+IREE_FLAG(bool, vulkan_defer_pipeline_creation, false,
+          "Creates the pipeline of each executable entry point on first use.");
+
 IREE_FLAG(bool, vulkan_tracing, true,
           "Enables Vulkan tracing (if IREE tracing is enabled).");
 
+IREE_FLAG(string, vulkan_pipeline_cache_path, "",
+          "Path of a file used to load and save the Vulkan pipeline cache.");
+
 static iree_status_t iree_hal_vulkan_create_driver_with_flags(
     iree_string_view_t identifier, iree_allocator_t allocator,
     iree_hal_driver_t** out_driver) {
@@ -68,6 +79,16 @@ static iree_status_t iree_hal_vulkan_create_driver_with_flags(
     driver_options.device_options.flags |=
         IREE_HAL_VULKAN_DEVICE_FORCE_TIMELINE_SEMAPHORE_EMULATION;
   }
+  driver_options.device_options.max_dispatch_queue_count =
+      (uint32_t)iree_max(1, FLAG_vulkan_dispatch_queue_count);
+  driver_options.device_options.max_transfer_queue_count =
+      (uint32_t)iree_max(0, FLAG_vulkan_transfer_queue_count);
+  if (FLAG_vulkan_defer_pipeline_creation) {
+    driver_options.device_options.flags |=
+        IREE_HAL_VULKAN_DEVICE_DEFER_PIPELINE_CREATION;
+  }
+  driver_options.device_options.pipeline_cache_path =
+      iree_make_cstring_view(FLAG_vulkan_pipeline_cache_path);
 
   // Load the Vulkan library. This will fail if the library cannot be found or
   // does not have the expected functions.
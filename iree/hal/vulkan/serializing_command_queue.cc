@@ -7,6 +7,7 @@
 #include "iree/hal/vulkan/serializing_command_queue.h"
 
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <type_traits>
 
@@ -28,11 +29,11 @@ namespace {
 // Tries to prepare all necessary binary `VKSemaphore`s for emulating the time
 // points as specified in the given submission |batch_wait_semaphores| and
 // |batch_signal_semaphores|, then returns true if possible so that the
-// batch is ready to be submitted to GPU.
+// batch is ready to be submitted to GPU on |queue|.
 // |wait_semaphores| and |signal_semaphores| will be filled with the binary
 // `VkSemaphores` on success.
 iree_status_t TryToPrepareSemaphores(
-    const std::vector<SemaphoreValue>& batch_wait_semaphores,
+    VkQueue queue, const std::vector<SemaphoreValue>& batch_wait_semaphores,
     const std::vector<SemaphoreValue>& batch_signal_semaphores,
     const ref_ptr<TimePointFence>& batch_fence,
     std::vector<VkSemaphore>* wait_semaphores,
@@ -41,6 +42,8 @@ iree_status_t TryToPrepareSemaphores(
   *out_ready_to_submit = false;
 
   wait_semaphores->clear();
+  // Timelines that |wait_semaphores| were acquired from, for cancellation.
+  std::vector<iree_hal_semaphore_t*> waited_timelines;
   for (const auto& timeline_semaphore : batch_wait_semaphores) {
     // Query first to progress this timeline semaphore to the furthest.
     uint64_t signaled_value = 0;
@@ -58,27 +61,28 @@ iree_status_t TryToPrepareSemaphores(
     // TODO(antiagainst): if this fails we need to cancel.
     VkSemaphore wait_semaphore = VK_NULL_HANDLE;
     IREE_RETURN_IF_ERROR(iree_hal_vulkan_emulated_semaphore_acquire_wait_handle(
-        timeline_semaphore.first, timeline_semaphore.second, batch_fence,
-        &wait_semaphore));
-    wait_semaphores->push_back(wait_semaphore);
+        timeline_semaphore.first, timeline_semaphore.second, queue,
+        batch_fence, &wait_semaphore));
 
     if (wait_semaphore == VK_NULL_HANDLE) {
       // We cannot wait on this time point yet: there are no previous semaphores
-      // submitted to the GPU that can signal a value greater than what's
+      // submitted to this queue that can signal a value greater than what's
       // desired here.
 
       // Cancel the wait so others may make progress.
       // TODO(antiagainst): if any of these fail we need to cancel.
-      for (iree_host_size_t i = 0; i < batch_wait_semaphores.size(); ++i) {
-        if (!wait_semaphores->at(i)) break;
+      for (iree_host_size_t i = 0; i < wait_semaphores->size(); ++i) {
         IREE_RETURN_IF_ERROR(
             iree_hal_vulkan_emulated_semaphore_cancel_wait_handle(
-                batch_wait_semaphores[i].first, wait_semaphores->at(i)));
+                waited_timelines[i], wait_semaphores->at(i)));
       }
+      wait_semaphores->clear();
 
       // This batch cannot be submitted to GPU yet.
       return iree_ok_status();
     }
+    wait_semaphores->push_back(wait_semaphore);
+    waited_timelines.push_back(timeline_semaphore.first);
   }
 
   // We've collected all necessary binary semaphores for each timeline we need
@@ -89,8 +93,8 @@ iree_status_t TryToPrepareSemaphores(
     VkSemaphore signal_semaphore = VK_NULL_HANDLE;
     IREE_RETURN_IF_ERROR(
         iree_hal_vulkan_emulated_semaphore_acquire_signal_handle(
-            timeline_semaphore.first, timeline_semaphore.second, batch_fence,
-            &signal_semaphore));
+            timeline_semaphore.first, timeline_semaphore.second, queue,
+            batch_fence, &signal_semaphore));
     signal_semaphores->push_back(signal_semaphore);
   }
 
@@ -160,9 +164,19 @@ SerializingCommandQueue::SerializingCommandQueue(
     iree_hal_command_category_t supported_categories, VkQueue queue,
     TimePointFencePool* fence_pool)
     : CommandQueue(logical_device, supported_categories, queue),
-      fence_pool_(fence_pool) {}
+      fence_pool_(fence_pool) {
+  iree_slim_mutex_initialize(&pending_fences_mutex_);
+}
 
-SerializingCommandQueue::~SerializingCommandQueue() = default;
+SerializingCommandQueue::~SerializingCommandQueue() {
+  iree_slim_mutex_lock(&queue_mutex_);
+  syms()->vkQueueWaitIdle(queue_);
+  iree_slim_mutex_unlock(&queue_mutex_);
+  iree_slim_mutex_lock(&pending_fences_mutex_);
+  pending_fences_.clear();
+  iree_slim_mutex_unlock(&pending_fences_mutex_);
+  iree_slim_mutex_deinitialize(&pending_fences_mutex_);
+}
 
 iree_status_t SerializingCommandQueue::Submit(
     iree_host_size_t batch_count, const iree_hal_submission_batch_t* batches) {
@@ -233,7 +247,7 @@ iree_status_t SerializingCommandQueue::TryProcessDeferredSubmissions(
 
   Arena arena(4 * 1024);
   std::vector<VkSubmitInfo> submit_infos;
-  std::vector<VkFence> submit_fences;
+  std::vector<ref_ptr<TimePointFence>> submit_fences;
   while (!deferred_submissions_.empty()) {
     FencedSubmission* submission = deferred_submissions_.front();
     ref_ptr<TimePointFence>& fence = submission->fence;
@@ -242,15 +256,14 @@ iree_status_t SerializingCommandQueue::TryProcessDeferredSubmissions(
     std::vector<VkSemaphore> signal_semaphores;
     bool ready_to_submit = false;
     IREE_RETURN_IF_ERROR(TryToPrepareSemaphores(
-        submission->wait_semaphores, submission->signal_semaphores, fence,
-        &wait_semaphores, &signal_semaphores, &ready_to_submit));
+        queue_, submission->wait_semaphores, submission->signal_semaphores,
+        fence, &wait_semaphores, &signal_semaphores, &ready_to_submit));
     if (ready_to_submit) {
       submit_infos.emplace_back();
       PrepareSubmitInfo(wait_semaphores, submission->command_buffers,
                         signal_semaphores, &submit_infos.back(), &arena);
 
-      submit_fences.push_back(fence->value());
-      pending_fences_.emplace_back(std::move(fence));
+      submit_fences.emplace_back(std::move(fence));
       deferred_submissions_.pop_front();
     } else {
       // We need to defer the submission until later.
@@ -267,10 +280,18 @@ iree_status_t SerializingCommandQueue::TryProcessDeferredSubmissions(
   for (size_t i = 0, e = submit_infos.size(); i < e; ++i) {
     VK_RETURN_IF_ERROR(
         syms()->vkQueueSubmit(queue_, /*submitCount=*/1, &submit_infos[i],
-                              submit_fences[i]),
+                              submit_fences[i]->value()),
         "vkQueueSubmit");
+    // Only track the fence once submitted as other threads may start waiting
+    // on it as soon as it is pending.
+    iree_slim_mutex_lock(&pending_fences_mutex_);
+    pending_fences_.emplace_back(std::move(submit_fences[i]));
+    iree_slim_mutex_unlock(&pending_fences_mutex_);
   }
 
+  // Let the fence wait thread pick up the new fences.
+  if (fence_wait_thread_) fence_wait_thread_->Wake();
+
   if (out_work_submitted) *out_work_submitted = true;
   return iree_ok_status();
 }
@@ -294,7 +315,9 @@ iree_status_t SerializingCommandQueue::WaitIdle(iree_timeout_t timeout) {
       iree_slim_mutex_unlock(&queue_mutex_);
       return status;
     }
+    iree_slim_mutex_lock(&pending_fences_mutex_);
     pending_fences_.clear();
+    iree_slim_mutex_unlock(&pending_fences_mutex_);
 
     // Submit and complete all deferred work.
     while (!deferred_submissions_.empty()) {
@@ -305,7 +328,9 @@ iree_status_t SerializingCommandQueue::WaitIdle(iree_timeout_t timeout) {
         status = VK_RESULT_TO_STATUS(syms()->vkQueueWaitIdle(queue_),
                                      "vkQueueWaitIdle");
         if (!iree_status_is_ok(status)) break;
+        iree_slim_mutex_lock(&pending_fences_mutex_);
         pending_fences_.clear();
+        iree_slim_mutex_unlock(&pending_fences_mutex_);
       }
     }
 
@@ -322,9 +347,11 @@ iree_status_t SerializingCommandQueue::WaitIdle(iree_timeout_t timeout) {
   do {
     status = ProcessDeferredSubmissions();
     bool has_deferred_submissions = !deferred_submissions_.empty();
-    std::vector<VkFence> fence_handles(pending_fences_.size());
-    for (size_t i = 0; i < pending_fences_.size(); ++i) {
-      fence_handles[i] = pending_fences_[i]->value();
+    std::vector<ref_ptr<TimePointFence>> fences;
+    ReapPendingFences(&fences);
+    std::vector<VkFence> fence_handles(fences.size());
+    for (size_t i = 0; i < fences.size(); ++i) {
+      fence_handles[i] = fences[i]->value();
     }
     if (!iree_status_is_ok(status)) {
       break;  // unable to process submissions
@@ -342,7 +369,8 @@ iree_status_t SerializingCommandQueue::WaitIdle(iree_timeout_t timeout) {
       // The implementation may not wait with this granularity (like by 10000x).
       iree_time_t now_ns = iree_time_now();
       if (deadline_ns < now_ns) {
-        return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+        status = iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+        break;
       }
       timeout_ns = (uint64_t)(deadline_ns - now_ns);
     }
@@ -353,7 +381,9 @@ iree_status_t SerializingCommandQueue::WaitIdle(iree_timeout_t timeout) {
 
     switch (result) {
       case VK_SUCCESS:
+        iree_slim_mutex_lock(&pending_fences_mutex_);
         pending_fences_.clear();
+        iree_slim_mutex_unlock(&pending_fences_mutex_);
         break;
       case VK_TIMEOUT:
         status = iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
@@ -386,6 +416,7 @@ void SerializingCommandQueue::AbortQueueSubmission() {
   // yet so we don't need to reset.
   deferred_submissions_.clear();
 
+  iree_slim_mutex_lock(&pending_fences_mutex_);
   std::vector<VkFence> fence_handles(pending_fences_.size());
   for (size_t i = 0; i < pending_fences_.size(); ++i) {
     fence_handles[i] = pending_fences_[i]->value();
@@ -399,6 +430,7 @@ void SerializingCommandQueue::AbortQueueSubmission() {
   // Clear the list. Fences will be automatically returned back to the queue
   // after refcount reaches 0.
   pending_fences_.clear();
+  iree_slim_mutex_unlock(&pending_fences_mutex_);
 
   iree_slim_mutex_unlock(&queue_mutex_);
 }
@@ -411,7 +443,7 @@ void SerializingCommandQueue::SignalFences(const std::vector<VkFence>& fences) {
     return false;
   };
 
-  iree_slim_mutex_lock(&queue_mutex_);
+  iree_slim_mutex_lock(&pending_fences_mutex_);
   auto it = pending_fences_.begin();
   while (it != pending_fences_.end()) {
     if (span_contains((*it)->value())) {
@@ -420,7 +452,147 @@ void SerializingCommandQueue::SignalFences(const std::vector<VkFence>& fences) {
       ++it;
     }
   }
-  iree_slim_mutex_unlock(&queue_mutex_);
+  iree_slim_mutex_unlock(&pending_fences_mutex_);
+}
+
+void SerializingCommandQueue::ReapPendingFences(
+    std::vector<ref_ptr<TimePointFence>>* out_fences) {
+  iree_slim_mutex_lock(&pending_fences_mutex_);
+  auto it = pending_fences_.begin();
+  while (it != pending_fences_.end()) {
+    if ((*it)->GetStatus() == VK_SUCCESS) {
+      it = pending_fences_.erase(it);
+    } else {
+      out_fences->push_back(add_ref(*it));
+      ++it;
+    }
+  }
+  iree_slim_mutex_unlock(&pending_fences_mutex_);
+}
+
+// How long the fence wait thread blocks in vkWaitForFences before gathering
+// the fences of work submitted since the wait began.
+static constexpr uint64_t kFenceWaitTimeoutNs = 1000000ull;  // 1ms
+
+// static
+iree_status_t FenceWaitThread::Create(VkDeviceHandle* logical_device,
+                                      iree_host_size_t command_queue_count,
+                                      CommandQueue** command_queues,
+                                      FenceWaitThread** out_thread) {
+  IREE_TRACE_SCOPE0("FenceWaitThread::Create");
+  *out_thread = nullptr;
+  std::unique_ptr<FenceWaitThread> fence_wait_thread(
+      new FenceWaitThread(logical_device, command_queue_count, command_queues));
+
+  iree_thread_create_params_t thread_params;
+  memset(&thread_params, 0, sizeof(thread_params));
+  thread_params.name = iree_make_cstring_view("iree-vulkan-fence-wait");
+  IREE_RETURN_IF_ERROR(iree_thread_create(
+      FenceWaitThread::ThreadMain, fence_wait_thread.get(), thread_params,
+      logical_device->host_allocator(), &fence_wait_thread->thread_));
+
+  for (iree_host_size_t i = 0; i < command_queue_count; ++i) {
+    ((SerializingCommandQueue*)command_queues[i])
+        ->set_fence_wait_thread(fence_wait_thread.get());
+  }
+  *out_thread = fence_wait_thread.release();
+  return iree_ok_status();
+}
+
+FenceWaitThread::FenceWaitThread(VkDeviceHandle* logical_device,
+                                 iree_host_size_t command_queue_count,
+                                 CommandQueue** command_queues)
+    : logical_device_(logical_device),
+      command_queue_count_(command_queue_count),
+      command_queues_(command_queues) {
+  iree_notification_initialize(&wake_notification_);
+  iree_atomic_store_int32(&wake_pending_, 0, iree_memory_order_relaxed);
+  iree_atomic_store_int32(&exit_requested_, 0, iree_memory_order_relaxed);
+}
+
+FenceWaitThread::~FenceWaitThread() {
+  IREE_TRACE_SCOPE0("FenceWaitThread::dtor");
+  if (thread_) {
+    iree_atomic_store_int32(&exit_requested_, 1, iree_memory_order_release);
+    Wake();
+    // Joins with the thread as we hold the last reference.
+    iree_thread_release(thread_);
+  }
+  for (iree_host_size_t i = 0; i < command_queue_count_; ++i) {
+    ((SerializingCommandQueue*)command_queues_[i])
+        ->set_fence_wait_thread(nullptr);
+  }
+  iree_notification_deinitialize(&wake_notification_);
+}
+
+void FenceWaitThread::Wake() {
+  iree_atomic_store_int32(&wake_pending_, 1, iree_memory_order_release);
+  iree_notification_post(&wake_notification_, IREE_ALL_WAITERS);
+}
+
+// static
+int FenceWaitThread::ThreadMain(void* entry_arg) {
+  ((FenceWaitThread*)entry_arg)->Run();
+  return 0;
+}
+
+void FenceWaitThread::AdvanceQueues() {
+  IREE_TRACE_SCOPE0("FenceWaitThread::AdvanceQueues");
+  for (iree_host_size_t i = 0; i < command_queue_count_; ++i) {
+    // Failures are sticky on the semaphores involved and reported to the
+    // next user interacting with them.
+    iree_status_ignore(((SerializingCommandQueue*)command_queues_[i])
+                           ->AdvanceQueueSubmission());
+  }
+}
+
+void FenceWaitThread::Run() {
+  std::vector<ref_ptr<TimePointFence>> fences;
+  std::vector<VkFence> fence_handles;
+  while (!iree_atomic_load_int32(&exit_requested_,
+                                 iree_memory_order_acquire)) {
+    fences.clear();
+    for (iree_host_size_t i = 0; i < command_queue_count_; ++i) {
+      ((SerializingCommandQueue*)command_queues_[i])
+          ->ReapPendingFences(&fences);
+    }
+
+    if (fences.empty()) {
+      // Nothing in flight; park until more work is submitted.
+      iree_wait_token_t wait_token =
+          iree_notification_prepare_wait(&wake_notification_);
+      if (iree_atomic_exchange_int32(&wake_pending_, 0,
+                                     iree_memory_order_acq_rel) ||
+          iree_atomic_load_int32(&exit_requested_,
+                                 iree_memory_order_acquire)) {
+        iree_notification_cancel_wait(&wake_notification_);
+      } else {
+        iree_notification_commit_wait(&wake_notification_, wait_token);
+      }
+      continue;
+    }
+
+    // Wait for any of the in-flight submissions across all queues to complete.
+    fence_handles.resize(fences.size());
+    for (size_t i = 0; i < fences.size(); ++i) {
+      fence_handles[i] = fences[i]->value();
+    }
+    VkResult result;
+    {
+      IREE_TRACE_SCOPE0("FenceWaitThread::Run#vkWaitForFences");
+      result = logical_device_->syms()->vkWaitForFences(
+          *logical_device_, static_cast<uint32_t>(fence_handles.size()),
+          fence_handles.data(), /*waitAll=*/VK_FALSE, kFenceWaitTimeoutNs);
+    }
+    fences.clear();
+    if (result == VK_TIMEOUT) continue;
+
+    // Either some fences signaled or the device failed. In both cases advance
+    // the deferred submissions so that the new timeline values (or failures)
+    // are observed.
+    AdvanceQueues();
+    if (result != VK_SUCCESS) break;
+  }
 }
 
 }  // namespace vulkan
@@ -20,7 +20,9 @@
 #include <vector>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
 #include "iree/base/internal/synchronization.h"
+#include "iree/base/internal/threading.h"
 #include "iree/hal/api.h"
 #include "iree/hal/vulkan/command_queue.h"
 #include "iree/hal/vulkan/dynamic_symbols.h"
@@ -35,6 +37,8 @@ namespace vulkan {
 
 using SemaphoreValue = std::pair<iree_hal_semaphore_t*, uint64_t>;
 
+class FenceWaitThread;
+
 // A command queue that potentially defers and serializes command buffer
 // submission to the GPU.
 //
@@ -46,6 +50,13 @@ using SemaphoreValue = std::pair<iree_hal_semaphore_t*, uint64_t>;
 // to enforce that is to defer the submission until we can be certain that the
 // `VkSemaphore`s emulating time points in the timeline are all *submitted* to
 // the GPU.
+//
+// Submissions waiting on time points that are signaled by work already
+// submitted to this same queue are submitted eagerly by chaining the binary
+// `VkSemaphore`s: queue submission order guarantees the signal is submitted
+// before the wait. Only dependencies on other queues or on host signals are
+// deferred, and those are advanced by the device `FenceWaitThread` as soon as
+// the GPU makes progress instead of waiting for the host to poll.
 class SerializingCommandQueue final : public CommandQueue {
  public:
   SerializingCommandQueue(VkDeviceHandle* logical_device,
@@ -71,6 +82,16 @@ class SerializingCommandQueue final : public CommandQueue {
   // Informs this queue that the given |fences| are known to have signaled.
   void SignalFences(const std::vector<VkFence>& fences);
 
+  // Drops all pending fences that have signaled and appends those still in
+  // flight to |out_fences|. The references keep the fences from being recycled
+  // while the caller waits on them.
+  void ReapPendingFences(std::vector<ref_ptr<TimePointFence>>* out_fences);
+
+  // Sets the thread that is woken each time new work is submitted to the GPU.
+  void set_fence_wait_thread(FenceWaitThread* fence_wait_thread) {
+    fence_wait_thread_ = fence_wait_thread;
+  }
+
  private:
   // A submission batch together with the fence to singal its status.
   struct FencedSubmission : public IntrusiveLinkBase<void> {
@@ -88,12 +109,59 @@ class SerializingCommandQueue final : public CommandQueue {
       bool* out_work_submitted);
 
   TimePointFencePool* fence_pool_;
+  FenceWaitThread* fence_wait_thread_ = nullptr;
 
   // A list of fences that are submitted to GPU.
-  std::vector<ref_ptr<TimePointFence>> pending_fences_ IREE_GUARDED_BY(mutex_);
+  // This has its own lock (always acquired after queue_mutex_, if both are
+  // needed) as emulated semaphores may signal fences while advancing their
+  // timeline from within ProcessDeferredSubmissions.
+  iree_slim_mutex_t pending_fences_mutex_;
+  std::vector<ref_ptr<TimePointFence>> pending_fences_
+      IREE_GUARDED_BY(pending_fences_mutex_);
   // A list of deferred submissions that haven't been submitted to GPU.
   IntrusiveList<std::unique_ptr<FencedSubmission>> deferred_submissions_
-      IREE_GUARDED_BY(mutex_);
+      IREE_GUARDED_BY(queue_mutex_);
+};
+
+// A dedicated thread that waits on the fences of all submissions in flight on
+// a set of `SerializingCommandQueue`s with batched `vkWaitForFences` calls.
+// Each time any fence signals the deferred submissions of all queues are
+// advanced so that work blocked on cross-queue dependencies is submitted
+// without requiring the host to poll (or signal) semaphores.
+class FenceWaitThread final {
+ public:
+  // Creates and starts a thread servicing the given |command_queues|, which
+  // must all be `SerializingCommandQueue`s that outlive the thread.
+  static iree_status_t Create(VkDeviceHandle* logical_device,
+                              iree_host_size_t command_queue_count,
+                              CommandQueue** command_queues,
+                              FenceWaitThread** out_thread);
+
+  // Requests the thread exit and joins with it.
+  ~FenceWaitThread();
+
+  // Wakes the thread if it is idle so that it picks up newly submitted fences.
+  void Wake();
+
+ private:
+  FenceWaitThread(VkDeviceHandle* logical_device,
+                  iree_host_size_t command_queue_count,
+                  CommandQueue** command_queues);
+
+  static int ThreadMain(void* entry_arg);
+  void Run();
+
+  // Advances the deferred submissions of all queues.
+  void AdvanceQueues();
+
+  VkDeviceHandle* logical_device_;
+  iree_host_size_t command_queue_count_;
+  CommandQueue** command_queues_;
+
+  iree_thread_t* thread_ = nullptr;
+  iree_notification_t wake_notification_;
+  iree_atomic_int32_t wake_pending_;
+  iree_atomic_int32_t exit_requested_;
 };
 
 }  // namespace vulkan
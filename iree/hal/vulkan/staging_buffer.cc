@@ -0,0 +1,250 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/vulkan/staging_buffer.h"
+
+#include <cstring>
+
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/vulkan/vma_buffer.h"
+
+using namespace iree::hal::vulkan;
+
+// Maximum number of regions that may be outstanding in the ring. Consecutive
+// reservations made by the same owner are coalesced into a single region.
+#define IREE_HAL_VULKAN_STAGING_BUFFER_MAX_REGIONS 256
+
+// Alignment of each reservation within the ring.
+#define IREE_HAL_VULKAN_STAGING_BUFFER_ALIGNMENT 16
+
+// A contiguous range of the ring ending at |end|. The region is pending while
+// |owner| is set, retired while |semaphore| is set, and free otherwise.
+typedef struct iree_hal_vulkan_staging_region_t {
+  const void* owner;
+  iree_device_size_t end;
+  VkSemaphore semaphore;
+  uint64_t value;
+} iree_hal_vulkan_staging_region_t;
+
+struct iree_hal_vulkan_staging_buffer_t {
+  VkDeviceHandle* logical_device;
+
+  iree_hal_buffer_t* buffer;
+  iree_hal_buffer_mapping_t mapping;
+  VkBuffer handle;
+  // Offset of the ring within |handle|.
+  iree_device_size_t handle_offset;
+  iree_device_size_t capacity;
+
+  iree_slim_mutex_t mutex;
+  // Offset the next reservation is made at.
+  iree_device_size_t head;
+  // Offset of the start of the oldest outstanding region.
+  iree_device_size_t tail;
+  // FIFO of outstanding regions in reservation order.
+  uint32_t region_head;
+  uint32_t region_count;
+  iree_hal_vulkan_staging_region_t
+      regions[IREE_HAL_VULKAN_STAGING_BUFFER_MAX_REGIONS];
+};
+
+iree_status_t iree_hal_vulkan_staging_buffer_allocate(
+    VkDeviceHandle* logical_device, iree_hal_allocator_t* device_allocator,
+    iree_device_size_t capacity,
+    iree_hal_vulkan_staging_buffer_t** out_staging_buffer) {
+  IREE_ASSERT_ARGUMENT(logical_device);
+  IREE_ASSERT_ARGUMENT(device_allocator);
+  IREE_ASSERT_ARGUMENT(out_staging_buffer);
+  *out_staging_buffer = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_allocator_allocate_buffer(
+              device_allocator,
+              IREE_HAL_MEMORY_TYPE_HOST_LOCAL |
+                  IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE,
+              IREE_HAL_BUFFER_USAGE_TRANSFER | IREE_HAL_BUFFER_USAGE_MAPPING,
+              (iree_host_size_t)capacity, &buffer));
+
+  iree_hal_vulkan_staging_buffer_t* staging_buffer = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      logical_device->host_allocator(), sizeof(*staging_buffer),
+      (void**)&staging_buffer);
+  if (iree_status_is_ok(status)) {
+    memset(staging_buffer, 0, sizeof(*staging_buffer));
+    staging_buffer->logical_device = logical_device;
+    staging_buffer->buffer = buffer;
+    staging_buffer->handle = iree_hal_vulkan_vma_buffer_handle(
+        iree_hal_buffer_allocated_buffer(buffer));
+    staging_buffer->handle_offset = iree_hal_buffer_byte_offset(buffer);
+    staging_buffer->capacity = capacity;
+    iree_slim_mutex_initialize(&staging_buffer->mutex);
+
+    // The ring stays mapped for its entire lifetime; as the memory is
+    // host-coherent no flushes are required before submission.
+    status = iree_hal_buffer_map_range(buffer, IREE_HAL_MEMORY_ACCESS_WRITE, 0,
+                                       capacity, &staging_buffer->mapping);
+    if (!iree_status_is_ok(status)) {
+      iree_slim_mutex_deinitialize(&staging_buffer->mutex);
+      iree_allocator_free(logical_device->host_allocator(), staging_buffer);
+      staging_buffer = NULL;
+    }
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_staging_buffer = staging_buffer;
+  } else {
+    iree_hal_buffer_release(buffer);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+void iree_hal_vulkan_staging_buffer_free(
+    iree_hal_vulkan_staging_buffer_t* staging_buffer) {
+  if (!staging_buffer) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_buffer_unmap_range(&staging_buffer->mapping);
+  iree_hal_buffer_release(staging_buffer->buffer);
+  iree_slim_mutex_deinitialize(&staging_buffer->mutex);
+  iree_allocator_free(staging_buffer->logical_device->host_allocator(),
+                      staging_buffer);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+// Pops all regions from the front of the FIFO that are no longer in use.
+// Must be called with the lock held.
+static void iree_hal_vulkan_staging_buffer_reclaim(
+    iree_hal_vulkan_staging_buffer_t* staging_buffer) {
+  const auto& syms = staging_buffer->logical_device->syms();
+  VkSemaphore queried_semaphore = VK_NULL_HANDLE;
+  uint64_t queried_value = 0;
+  while (staging_buffer->region_count > 0) {
+    const iree_hal_vulkan_staging_region_t* region =
+        &staging_buffer->regions[staging_buffer->region_head];
+    if (region->owner) break;  // still pending submission
+    if (region->semaphore) {
+      // Regions retired by the same queue are usually adjacent so only query
+      // each semaphore once.
+      if (region->semaphore != queried_semaphore) {
+        queried_semaphore = region->semaphore;
+        if (syms->vkGetSemaphoreCounterValue(*staging_buffer->logical_device,
+                                             queried_semaphore,
+                                             &queried_value) != VK_SUCCESS) {
+          break;
+        }
+      }
+      if (queried_value < region->value) break;  // still in flight
+    }
+    staging_buffer->tail = region->end;
+    staging_buffer->region_head = (staging_buffer->region_head + 1) %
+                                  IREE_HAL_VULKAN_STAGING_BUFFER_MAX_REGIONS;
+    --staging_buffer->region_count;
+  }
+  if (staging_buffer->region_count == 0) {
+    staging_buffer->head = 0;
+    staging_buffer->tail = 0;
+  }
+}
+
+iree_status_t iree_hal_vulkan_staging_buffer_reserve(
+    iree_hal_vulkan_staging_buffer_t* staging_buffer, const void* owner,
+    iree_device_size_t length, VkBuffer* out_buffer,
+    iree_device_size_t* out_offset, void** out_host_ptr) {
+  IREE_ASSERT_ARGUMENT(owner);
+  length = iree_device_align(length, IREE_HAL_VULKAN_STAGING_BUFFER_ALIGNMENT);
+  if (length == 0 || length > staging_buffer->capacity) {
+    return iree_status_from_code(IREE_STATUS_RESOURCE_EXHAUSTED);
+  }
+
+  iree_slim_mutex_lock(&staging_buffer->mutex);
+  iree_hal_vulkan_staging_buffer_reclaim(staging_buffer);
+
+  // Live data spans [tail, head) or, once wrapped, [tail, capacity) and
+  // [0, head). head == tail with outstanding regions means the ring is full.
+  const iree_device_size_t head = staging_buffer->head;
+  const iree_device_size_t tail = staging_buffer->tail;
+  const iree_device_size_t capacity = staging_buffer->capacity;
+  iree_device_size_t offset = capacity;  // not found
+  if (staging_buffer->region_count == 0 || head > tail) {
+    if (capacity - head >= length) {
+      offset = head;
+    } else if (tail >= length) {
+      offset = 0;  // wrap; the space after head is skipped until tail passes it
+    }
+  } else if (head < tail && tail - head >= length) {
+    offset = head;
+  }
+
+  iree_status_t status = iree_ok_status();
+  uint32_t last_index = (staging_buffer->region_head +
+                         staging_buffer->region_count +
+                         IREE_HAL_VULKAN_STAGING_BUFFER_MAX_REGIONS - 1) %
+                        IREE_HAL_VULKAN_STAGING_BUFFER_MAX_REGIONS;
+  iree_hal_vulkan_staging_region_t* last_region =
+      staging_buffer->region_count > 0 ? &staging_buffer->regions[last_index]
+                                       : NULL;
+  if (offset == capacity) {
+    status = iree_status_from_code(IREE_STATUS_RESOURCE_EXHAUSTED);
+  } else if (last_region && last_region->owner == owner &&
+             last_region->end == offset) {
+    last_region->end = offset + length;
+  } else if (staging_buffer->region_count ==
+             IREE_HAL_VULKAN_STAGING_BUFFER_MAX_REGIONS) {
+    status = iree_status_from_code(IREE_STATUS_RESOURCE_EXHAUSTED);
+  } else {
+    iree_hal_vulkan_staging_region_t* region =
+        &staging_buffer->regions[(last_index + 1) %
+                                 IREE_HAL_VULKAN_STAGING_BUFFER_MAX_REGIONS];
+    region->owner = owner;
+    region->end = offset + length;
+    region->semaphore = VK_NULL_HANDLE;
+    region->value = 0;
+    ++staging_buffer->region_count;
+  }
+  if (iree_status_is_ok(status)) {
+    staging_buffer->head = offset + length;
+  }
+  iree_slim_mutex_unlock(&staging_buffer->mutex);
+  IREE_RETURN_IF_ERROR(status);
+
+  *out_buffer = staging_buffer->handle;
+  *out_offset = staging_buffer->handle_offset + offset;
+  *out_host_ptr = staging_buffer->mapping.contents.data + offset;
+  return iree_ok_status();
+}
+
+void iree_hal_vulkan_staging_buffer_retire(
+    iree_hal_vulkan_staging_buffer_t* staging_buffer, const void* owner,
+    VkSemaphore semaphore, uint64_t value) {
+  iree_slim_mutex_lock(&staging_buffer->mutex);
+  for (uint32_t i = 0; i < staging_buffer->region_count; ++i) {
+    iree_hal_vulkan_staging_region_t* region =
+        &staging_buffer->regions[(staging_buffer->region_head + i) %
+                                 IREE_HAL_VULKAN_STAGING_BUFFER_MAX_REGIONS];
+    if (region->owner != owner) continue;
+    region->owner = NULL;
+    region->semaphore = semaphore;
+    region->value = value;
+  }
+  iree_slim_mutex_unlock(&staging_buffer->mutex);
+}
+
+void iree_hal_vulkan_staging_buffer_release(
+    iree_hal_vulkan_staging_buffer_t* staging_buffer, const void* owner) {
+  iree_slim_mutex_lock(&staging_buffer->mutex);
+  for (uint32_t i = 0; i < staging_buffer->region_count; ++i) {
+    iree_hal_vulkan_staging_region_t* region =
+        &staging_buffer->regions[(staging_buffer->region_head + i) %
+                                 IREE_HAL_VULKAN_STAGING_BUFFER_MAX_REGIONS];
+    if (region->owner == owner) region->owner = NULL;
+  }
+  iree_slim_mutex_unlock(&staging_buffer->mutex);
+}
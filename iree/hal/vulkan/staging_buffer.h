@@ -0,0 +1,73 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_VULKAN_STAGING_BUFFER_H_
+#define IREE_HAL_VULKAN_STAGING_BUFFER_H_
+
+// clang-format off: must be included before all other headers.
+#include "iree/hal/vulkan/vulkan_headers.h"
+// clang-format on
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/vulkan/handle_util.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// A persistently mapped host-visible ring buffer used to stage host data that
+// command buffers copy into device buffers (update_buffer and the unaligned
+// edges of fills) without allocating per upload.
+//
+// Reservations are owned by the command buffer recording them. When a queue
+// submits the command buffer it retires the reservations against a timeline
+// semaphore value that the submission signals; the space is reclaimed once the
+// semaphore reaches that value. Reservations of command buffers that are reset
+// or destroyed without being submitted are reclaimed immediately. Because the
+// staged contents are consumed by the first execution, only one-shot command
+// buffers may reserve from the ring.
+//
+// Reservations that do not fit in the free space of the ring fail with
+// RESOURCE_EXHAUSTED and callers fall back to their unstaged path.
+//
+// Thread-safe.
+typedef struct iree_hal_vulkan_staging_buffer_t
+    iree_hal_vulkan_staging_buffer_t;
+
+// Allocates a staging ring of |capacity| bytes from |device_allocator|.
+iree_status_t iree_hal_vulkan_staging_buffer_allocate(
+    iree::hal::vulkan::VkDeviceHandle* logical_device,
+    iree_hal_allocator_t* device_allocator, iree_device_size_t capacity,
+    iree_hal_vulkan_staging_buffer_t** out_staging_buffer);
+
+// Frees the staging ring. All submissions using it must have completed.
+void iree_hal_vulkan_staging_buffer_free(
+    iree_hal_vulkan_staging_buffer_t* staging_buffer);
+
+// Reserves |length| bytes of the ring for |owner| and returns the VkBuffer and
+// offset that commands should read from along with the host pointer the
+// contents should be written to.
+iree_status_t iree_hal_vulkan_staging_buffer_reserve(
+    iree_hal_vulkan_staging_buffer_t* staging_buffer, const void* owner,
+    iree_device_size_t length, VkBuffer* out_buffer,
+    iree_device_size_t* out_offset, void** out_host_ptr);
+
+// Retires all unsubmitted reservations of |owner| such that they are reclaimed
+// once |semaphore| reaches |value|. Called after a successful submission.
+void iree_hal_vulkan_staging_buffer_retire(
+    iree_hal_vulkan_staging_buffer_t* staging_buffer, const void* owner,
+    VkSemaphore semaphore, uint64_t value);
+
+// Releases all unsubmitted reservations of |owner| for immediate reuse.
+void iree_hal_vulkan_staging_buffer_release(
+    iree_hal_vulkan_staging_buffer_t* staging_buffer, const void* owner);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_VULKAN_STAGING_BUFFER_H_
@@ -208,6 +208,7 @@ void TimePointSemaphorePool::ReleaseResolved(
 
   for (auto* semaphore : *semaphores) {
     IREE_DCHECK(!semaphore->signal_fence && !semaphore->wait_fence);
+    semaphore->signal_queue = VK_NULL_HANDLE;
     semaphore->value = UINT64_MAX;
   }
 
@@ -222,6 +223,7 @@ void TimePointSemaphorePool::ReleaseUnresolved(
   for (auto* semaphore : *semaphores) {
     semaphore->signal_fence = nullptr;
     semaphore->wait_fence = nullptr;
+    semaphore->signal_queue = VK_NULL_HANDLE;
     semaphore->value = UINT64_MAX;
   }
 
@@ -110,6 +110,11 @@ struct TimePointSemaphore final : public IntrusiveLinkBase<void> {
   // nullptr means this binary semaphore has not been submitted to GPU.
   ref_ptr<TimePointFence> signal_fence = nullptr;
 
+  // The queue the submission signaling this semaphore is submitted to.
+  // Submissions to the same queue may wait on the semaphore before it has
+  // signaled as queue submission order ensures the signal is submitted first.
+  VkQueue signal_queue = VK_NULL_HANDLE;
+
   // The fence associated with the queue submission waiting this semaphore.
   // nullptr means this binary semaphore has not been waited by any queue
   // submission.
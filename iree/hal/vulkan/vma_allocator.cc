@@ -6,11 +6,14 @@
 
 #include "iree/hal/vulkan/vma_allocator.h"
 
+#include <cinttypes>
 #include <cstddef>
 #include <cstring>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/synchronization.h"
 #include "iree/base/tracing.h"
+#include "iree/hal/vulkan/api.h"
 #include "iree/hal/vulkan/dynamic_symbols.h"
 #include "iree/hal/vulkan/status_util.h"
 #include "iree/hal/vulkan/util/ref_ptr.h"
@@ -21,7 +24,20 @@ using namespace iree::hal::vulkan;
 typedef struct iree_hal_vulkan_vma_allocator_t {
   iree_hal_resource_t resource;
   iree_allocator_t host_allocator;
+  VkDeviceHandle* logical_device;
   VmaAllocator vma;
+  iree_hal_vulkan_vma_allocator_options_t options;
+
+  // Guards lazy creation of the pools below and the statistics.
+  iree_slim_mutex_t pool_mutex;
+  // Ring buffer pools for transient buffers indexed by memory type index.
+  VmaPool transient_pools[VK_MAX_MEMORY_TYPES];
+  // General purpose pools for constant buffers indexed by memory type index.
+  VmaPool constant_pools[VK_MAX_MEMORY_TYPES];
+  // Number of transient allocations that overflowed their ring buffer pool.
+  uint64_t transient_pool_miss_count;
+  // Memory usage of the buffers allocated from VMA.
+  iree_hal_allocator_statistics_t memory_statistics;
 } iree_hal_vulkan_vma_allocator_t;
 
 extern const iree_hal_allocator_vtable_t iree_hal_vulkan_vma_allocator_vtable;
@@ -35,10 +51,12 @@ static iree_hal_vulkan_vma_allocator_t* iree_hal_vulkan_vma_allocator_cast(
 iree_status_t iree_hal_vulkan_vma_allocator_create(
     VkInstance instance, VkPhysicalDevice physical_device,
     VkDeviceHandle* logical_device, VmaRecordSettings record_settings,
+    const iree_hal_vulkan_vma_allocator_options_t* options,
     iree_hal_allocator_t** out_allocator) {
   IREE_ASSERT_ARGUMENT(instance);
   IREE_ASSERT_ARGUMENT(physical_device);
   IREE_ASSERT_ARGUMENT(logical_device);
+  IREE_ASSERT_ARGUMENT(options);
   IREE_ASSERT_ARGUMENT(out_allocator);
   IREE_TRACE_ZONE_BEGIN(z0);
 
@@ -93,14 +111,22 @@ iree_status_t iree_hal_vulkan_vma_allocator_create(
     iree_hal_resource_initialize(&iree_hal_vulkan_vma_allocator_vtable,
                                  &allocator->resource);
     allocator->host_allocator = host_allocator;
+    allocator->logical_device = logical_device;
     allocator->vma = vma;
+    allocator->options = *options;
+    iree_slim_mutex_initialize(&allocator->pool_mutex);
+    memset(allocator->transient_pools, 0, sizeof(allocator->transient_pools));
+    memset(allocator->constant_pools, 0, sizeof(allocator->constant_pools));
+    allocator->transient_pool_miss_count = 0;
+    memset(&allocator->memory_statistics, 0,
+           sizeof(allocator->memory_statistics));
     *out_allocator = (iree_hal_allocator_t*)allocator;
   } else {
     vmaDestroyAllocator(vma);
   }
 
   IREE_TRACE_ZONE_END(z0);
-  return iree_ok_status();
+  return status;
 }
 
 static void iree_hal_vulkan_vma_allocator_destroy(
@@ -110,6 +136,18 @@ static void iree_hal_vulkan_vma_allocator_destroy(
   iree_allocator_t host_allocator = allocator->host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // All buffers must have been released prior to the allocator so the pools
+  // are empty and can be destroyed prior to the VMA allocator itself.
+  for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; ++i) {
+    if (allocator->transient_pools[i] != VK_NULL_HANDLE) {
+      vmaDestroyPool(allocator->vma, allocator->transient_pools[i]);
+    }
+    if (allocator->constant_pools[i] != VK_NULL_HANDLE) {
+      vmaDestroyPool(allocator->vma, allocator->constant_pools[i]);
+    }
+  }
+  iree_slim_mutex_deinitialize(&allocator->pool_mutex);
+
   vmaDestroyAllocator(allocator->vma);
   iree_allocator_free(host_allocator, allocator);
 
@@ -160,6 +198,86 @@ static iree_status_t iree_hal_vulkan_vma_allocator_make_compatible(
   return iree_ok_status();
 }
 
+// Returns the Vulkan buffer usage flags required for |allowed_usage|.
+static VkBufferUsageFlags iree_hal_vulkan_vma_allocator_buffer_usage_flags(
+    iree_hal_buffer_usage_t allowed_usage) {
+  VkBufferUsageFlags usage = 0;
+  if (iree_all_bits_set(allowed_usage, IREE_HAL_BUFFER_USAGE_TRANSFER)) {
+    usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  }
+  if (iree_all_bits_set(allowed_usage, IREE_HAL_BUFFER_USAGE_DISPATCH)) {
+    usage |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    usage |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+  }
+  return usage;
+}
+
+// Selects (and lazily creates) the custom pool that should service an
+// allocation with the given parameters. Returns VK_NULL_HANDLE if the
+// allocation should be made from the default VMA heaps.
+static VmaPool iree_hal_vulkan_vma_allocator_select_pool(
+    iree_hal_vulkan_vma_allocator_t* allocator,
+    iree_hal_memory_type_t memory_type, iree_hal_buffer_usage_t allowed_usage,
+    const VkBufferCreateInfo* buffer_create_info,
+    const VmaAllocationCreateInfo* allocation_create_info) {
+  VmaPool* pools = NULL;
+  VmaPoolCreateInfo pool_create_info;
+  memset(&pool_create_info, 0, sizeof(pool_create_info));
+  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_TRANSIENT)) {
+    // Transient buffers have (roughly) FIFO lifetimes and are serviced from a
+    // single fixed-size block used as a ring buffer. The linear algorithm only
+    // supports ring buffer usage when the pool has exactly one block.
+    if (buffer_create_info->size >
+        allocator->options.transient_pool_block_size / 2) {
+      return VK_NULL_HANDLE;
+    }
+    pools = allocator->transient_pools;
+    pool_create_info.flags = VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT;
+    pool_create_info.blockSize = allocator->options.transient_pool_block_size;
+    pool_create_info.minBlockCount = 1;
+    pool_create_info.maxBlockCount = 1;
+  } else if (iree_all_bits_set(allowed_usage, IREE_HAL_BUFFER_USAGE_CONSTANT)) {
+    if (buffer_create_info->size >
+        allocator->options.constant_pool_block_size / 2) {
+      return VK_NULL_HANDLE;
+    }
+    pools = allocator->constant_pools;
+    pool_create_info.flags = 0;
+    pool_create_info.blockSize = allocator->options.constant_pool_block_size;
+    pool_create_info.minBlockCount = 0;
+    pool_create_info.maxBlockCount = 0;  // Unbounded.
+  } else {
+    return VK_NULL_HANDLE;
+  }
+
+  // Pools are specific to a memory type so we need to resolve which one VMA
+  // would have picked for the allocation given its requirements.
+  uint32_t memory_type_index = 0;
+  if (vmaFindMemoryTypeIndexForBufferInfo(
+          allocator->vma, buffer_create_info, allocation_create_info,
+          &memory_type_index) != VK_SUCCESS) {
+    return VK_NULL_HANDLE;
+  }
+
+  iree_slim_mutex_lock(&allocator->pool_mutex);
+  VmaPool pool = pools[memory_type_index];
+  if (pool == VK_NULL_HANDLE) {
+    pool_create_info.memoryTypeIndex = memory_type_index;
+    pool_create_info.frameInUseCount = 0;
+    if (vmaCreatePool(allocator->vma, &pool_create_info, &pool) !=
+        VK_SUCCESS) {
+      // Failing to create the pool (such as when the heap cannot fit the
+      // block) is not fatal: we'll retry next time and use the default heaps.
+      pool = VK_NULL_HANDLE;
+    }
+    pools[memory_type_index] = pool;
+  }
+  iree_slim_mutex_unlock(&allocator->pool_mutex);
+  return pool;
+}
+
 static iree_status_t iree_hal_vulkan_vma_allocator_allocate_internal(
     iree_hal_vulkan_vma_allocator_t* allocator,
     iree_hal_memory_type_t memory_type, iree_hal_buffer_usage_t allowed_usage,
@@ -175,16 +293,8 @@ static iree_status_t iree_hal_vulkan_vma_allocator_allocate_internal(
   buffer_create_info.pNext = NULL;
   buffer_create_info.flags = 0;
   buffer_create_info.size = allocation_size;
-  buffer_create_info.usage = 0;
-  if (iree_all_bits_set(allowed_usage, IREE_HAL_BUFFER_USAGE_TRANSFER)) {
-    buffer_create_info.usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    buffer_create_info.usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-  }
-  if (iree_all_bits_set(allowed_usage, IREE_HAL_BUFFER_USAGE_DISPATCH)) {
-    buffer_create_info.usage |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-    buffer_create_info.usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
-    buffer_create_info.usage |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
-  }
+  buffer_create_info.usage =
+      iree_hal_vulkan_vma_allocator_buffer_usage_flags(allowed_usage);
   buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
   buffer_create_info.queueFamilyIndexCount = 0;
   buffer_create_info.pQueueFamilyIndices = NULL;
@@ -232,21 +342,69 @@ static iree_status_t iree_hal_vulkan_vma_allocator_allocate_internal(
   if (iree_all_bits_set(allowed_usage, IREE_HAL_BUFFER_USAGE_MAPPING)) {
     allocation_create_info.requiredFlags |= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
   }
+  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_HOST_VISIBLE)) {
+    // Keep host-visible allocations persistently mapped so that mapping a
+    // range of the buffer (such as for scalar loads and small readbacks) is
+    // just pointer arithmetic instead of a vmaMapMemory/vmaUnmapMemory pair.
+    allocation_create_info.flags |= VMA_ALLOCATION_CREATE_MAPPED_BIT;
+  }
 
   VkBuffer handle = VK_NULL_HANDLE;
   VmaAllocation allocation = VK_NULL_HANDLE;
   VmaAllocationInfo allocation_info;
-  VK_RETURN_IF_ERROR(vmaCreateBuffer(allocator->vma, &buffer_create_info,
-                                     &allocation_create_info, &handle,
-                                     &allocation, &allocation_info),
-                     "vmaCreateBuffer");
 
-  return iree_hal_vulkan_vma_buffer_wrap(
+  // Try the custom pool first, if any, and otherwise fall back to the default
+  // heaps. The transient pools are limited to a single block so overflowing
+  // the ring buffer fails here instead of growing the pool.
+  VmaAllocationCreateInfo pool_allocation_create_info = allocation_create_info;
+  pool_allocation_create_info.pool = iree_hal_vulkan_vma_allocator_select_pool(
+      allocator, memory_type, allowed_usage, &buffer_create_info,
+      &allocation_create_info);
+  if (pool_allocation_create_info.pool != VK_NULL_HANDLE) {
+    VkResult result = vmaCreateBuffer(
+        allocator->vma, &buffer_create_info, &pool_allocation_create_info,
+        &handle, &allocation, &allocation_info);
+    if (result != VK_SUCCESS) {
+      handle = VK_NULL_HANDLE;
+      allocation = VK_NULL_HANDLE;
+      if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_TRANSIENT)) {
+        iree_slim_mutex_lock(&allocator->pool_mutex);
+        ++allocator->transient_pool_miss_count;
+        iree_slim_mutex_unlock(&allocator->pool_mutex);
+      }
+    }
+  }
+  if (allocation == VK_NULL_HANDLE) {
+    VK_RETURN_IF_ERROR(vmaCreateBuffer(allocator->vma, &buffer_create_info,
+                                       &allocation_create_info, &handle,
+                                       &allocation, &allocation_info),
+                       "vmaCreateBuffer");
+  }
+
+  IREE_RETURN_IF_ERROR(iree_hal_vulkan_vma_buffer_wrap(
       (iree_hal_allocator_t*)allocator, memory_type, allowed_access,
       allowed_usage, allocation_size,
       /*byte_offset=*/0,
       /*byte_length=*/allocation_size, allocator->vma, handle, allocation,
-      allocation_info, out_buffer);
+      allocation_info, out_buffer));
+
+  iree_slim_mutex_lock(&allocator->pool_mutex);
+  iree_hal_allocator_statistics_record_alloc(&allocator->memory_statistics,
+                                             memory_type, allocation_size,
+                                             *out_buffer);
+  iree_slim_mutex_unlock(&allocator->pool_mutex);
+  return iree_ok_status();
+}
+
+void iree_hal_vulkan_vma_allocator_record_free(
+    iree_hal_allocator_t* base_allocator, iree_hal_buffer_t* buffer) {
+  iree_hal_vulkan_vma_allocator_t* allocator =
+      iree_hal_vulkan_vma_allocator_cast(base_allocator);
+  iree_slim_mutex_lock(&allocator->pool_mutex);
+  iree_hal_allocator_statistics_record_free(
+      &allocator->memory_statistics, iree_hal_buffer_memory_type(buffer),
+      iree_hal_buffer_allocation_size(buffer), buffer);
+  iree_slim_mutex_unlock(&allocator->pool_mutex);
 }
 
 static iree_status_t iree_hal_vulkan_vma_allocator_allocate_buffer(
@@ -275,6 +433,288 @@ static iree_status_t iree_hal_vulkan_vma_allocator_wrap_buffer(
                           "wrapping of external buffers not supported");
 }
 
+// Selects the memory type among |memory_type_bits| best matching the requested
+// HAL |memory_type|: all required properties must be present and device-local
+// memory is preferred when not explicitly requested.
+static iree_status_t iree_hal_vulkan_vma_allocator_select_memory_type_index(
+    iree_hal_vulkan_vma_allocator_t* allocator,
+    iree_hal_memory_type_t memory_type, uint32_t memory_type_bits,
+    uint32_t* out_memory_type_index) {
+  VkMemoryPropertyFlags required_flags = 0;
+  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL)) {
+    required_flags |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+  }
+  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_HOST_VISIBLE)) {
+    required_flags |= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+  }
+  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_HOST_COHERENT)) {
+    required_flags |= VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  }
+  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_HOST_CACHED)) {
+    required_flags |= VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+  }
+
+  const VkPhysicalDeviceMemoryProperties* memory_properties = NULL;
+  vmaGetMemoryProperties(allocator->vma, &memory_properties);
+  int best_index = -1;
+  for (uint32_t i = 0; i < memory_properties->memoryTypeCount; ++i) {
+    if (!(memory_type_bits & (1u << i))) continue;
+    VkMemoryPropertyFlags flags =
+        memory_properties->memoryTypes[i].propertyFlags;
+    if ((flags & required_flags) != required_flags) continue;
+    if (best_index < 0 || (flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) {
+      best_index = (int)i;
+      if (flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) break;
+    }
+  }
+  if (best_index < 0) {
+    return iree_make_status(
+        IREE_STATUS_UNAVAILABLE,
+        "no memory type compatible with the external memory matches the "
+        "requested memory type");
+  }
+  *out_memory_type_index = (uint32_t)best_index;
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_vulkan_allocator_import_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage,
+    const iree_hal_vulkan_external_memory_t* external_memory,
+    iree_hal_buffer_t** out_buffer) {
+  IREE_ASSERT_ARGUMENT(base_allocator);
+  IREE_ASSERT_ARGUMENT(external_memory);
+  IREE_ASSERT_ARGUMENT(out_buffer);
+  *out_buffer = NULL;
+  if (!iree_hal_resource_is(base_allocator,
+                            &iree_hal_vulkan_vma_allocator_vtable)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "allocator is not a Vulkan allocator");
+  }
+  iree_hal_vulkan_vma_allocator_t* allocator =
+      iree_hal_vulkan_vma_allocator_cast(base_allocator);
+  VkDeviceHandle* logical_device = allocator->logical_device;
+  const auto& syms = logical_device->syms();
+  const auto& extensions = logical_device->enabled_extensions();
+
+  VkExternalMemoryHandleTypeFlagBits handle_type;
+  switch (external_memory->type) {
+    case IREE_HAL_VULKAN_EXTERNAL_MEMORY_TYPE_OPAQUE_FD:
+      handle_type = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT;
+      if (!extensions.external_memory_fd) {
+        return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                                "VK_KHR_external_memory_fd not enabled");
+      }
+      break;
+    case IREE_HAL_VULKAN_EXTERNAL_MEMORY_TYPE_DMA_BUF_FD:
+      handle_type = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT;
+      if (!extensions.external_memory_fd ||
+          !extensions.external_memory_dma_buf) {
+        return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                                "VK_EXT_external_memory_dma_buf not enabled");
+      }
+      break;
+    default:
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "unknown external memory type %d",
+                              (int)external_memory->type);
+  }
+  if (external_memory->allocation_size == 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "external memory must be non-empty");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Create the buffer the memory will be bound to with the same usage we
+  // would have for buffers allocated by VMA.
+  VkExternalMemoryBufferCreateInfo external_create_info;
+  external_create_info.sType =
+      VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO;
+  external_create_info.pNext = NULL;
+  external_create_info.handleTypes = handle_type;
+  VkBufferCreateInfo buffer_create_info;
+  buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  buffer_create_info.pNext = &external_create_info;
+  buffer_create_info.flags = 0;
+  buffer_create_info.size = external_memory->allocation_size;
+  buffer_create_info.usage =
+      iree_hal_vulkan_vma_allocator_buffer_usage_flags(allowed_usage);
+  buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  buffer_create_info.queueFamilyIndexCount = 0;
+  buffer_create_info.pQueueFamilyIndices = NULL;
+  VkBuffer handle = VK_NULL_HANDLE;
+  iree_status_t status = VK_RESULT_TO_STATUS(
+      syms->vkCreateBuffer(*logical_device, &buffer_create_info,
+                           logical_device->allocator(), &handle),
+      "vkCreateBuffer");
+
+  // Determine which memory types the external memory can be imported as.
+  // Opaque fds must be imported as the same type they were exported with and
+  // can't be queried; the buffer requirements are all we have to go on.
+  VkMemoryRequirements memory_requirements;
+  memset(&memory_requirements, 0, sizeof(memory_requirements));
+  uint32_t memory_type_index = 0;
+  if (iree_status_is_ok(status)) {
+    syms->vkGetBufferMemoryRequirements(*logical_device, handle,
+                                        &memory_requirements);
+    if (external_memory->allocation_size < memory_requirements.size) {
+      status = iree_make_status(
+          IREE_STATUS_OUT_OF_RANGE,
+          "external memory of %" PRIu64
+          " bytes is smaller than the %" PRIu64 " bytes required",
+          (uint64_t)external_memory->allocation_size,
+          (uint64_t)memory_requirements.size);
+    }
+  }
+  if (iree_status_is_ok(status) &&
+      handle_type != VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT) {
+    VkMemoryFdPropertiesKHR fd_properties;
+    fd_properties.sType = VK_STRUCTURE_TYPE_MEMORY_FD_PROPERTIES_KHR;
+    fd_properties.pNext = NULL;
+    fd_properties.memoryTypeBits = 0;
+    status = VK_RESULT_TO_STATUS(
+        syms->vkGetMemoryFdPropertiesKHR(*logical_device, handle_type,
+                                         external_memory->fd, &fd_properties),
+        "vkGetMemoryFdPropertiesKHR");
+    memory_requirements.memoryTypeBits &= fd_properties.memoryTypeBits;
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_vulkan_vma_allocator_select_memory_type_index(
+        allocator, memory_type, memory_requirements.memoryTypeBits,
+        &memory_type_index);
+  }
+
+  // Import the memory. On success the implementation owns the fd.
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  if (iree_status_is_ok(status)) {
+    VkImportMemoryFdInfoKHR import_info;
+    import_info.sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_FD_INFO_KHR;
+    import_info.pNext = NULL;
+    import_info.handleType = handle_type;
+    import_info.fd = external_memory->fd;
+    VkMemoryAllocateInfo allocate_info;
+    allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocate_info.pNext = &import_info;
+    allocate_info.allocationSize = external_memory->allocation_size;
+    allocate_info.memoryTypeIndex = memory_type_index;
+    status = VK_RESULT_TO_STATUS(
+        syms->vkAllocateMemory(*logical_device, &allocate_info,
+                               logical_device->allocator(), &memory),
+        "vkAllocateMemory");
+  }
+  if (iree_status_is_ok(status)) {
+    status = VK_RESULT_TO_STATUS(
+        syms->vkBindBufferMemory(*logical_device, handle, memory,
+                                 /*memoryOffset=*/0),
+        "vkBindBufferMemory");
+  }
+
+  if (iree_status_is_ok(status)) {
+    // Report the properties of the memory type actually imported.
+    const VkPhysicalDeviceMemoryProperties* memory_properties = NULL;
+    vmaGetMemoryProperties(allocator->vma, &memory_properties);
+    VkMemoryPropertyFlags flags =
+        memory_properties->memoryTypes[memory_type_index].propertyFlags;
+    if (flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) {
+      memory_type |= IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL;
+    }
+    if (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+      memory_type |= IREE_HAL_MEMORY_TYPE_HOST_VISIBLE;
+    }
+    // Takes ownership of the handle and memory, even on failure.
+    status = iree_hal_vulkan_vma_buffer_wrap_external(
+        base_allocator, memory_type, allowed_access, allowed_usage,
+        external_memory->allocation_size, /*byte_offset=*/0,
+        /*byte_length=*/external_memory->allocation_size, logical_device,
+        handle, memory, out_buffer);
+  } else {
+    if (memory != VK_NULL_HANDLE) {
+      syms->vkFreeMemory(*logical_device, memory, logical_device->allocator());
+    }
+    if (handle != VK_NULL_HANDLE) {
+      syms->vkDestroyBuffer(*logical_device, handle,
+                            logical_device->allocator());
+    }
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_vulkan_vma_allocator_accumulate_pool_statistics(
+    iree_hal_vulkan_vma_allocator_t* allocator, const VmaPool* pools,
+    iree_device_size_t* out_used_size, iree_device_size_t* out_total_size) {
+  for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; ++i) {
+    if (pools[i] == VK_NULL_HANDLE) continue;
+    VmaPoolStats pool_stats;
+    memset(&pool_stats, 0, sizeof(pool_stats));
+    vmaGetPoolStats(allocator->vma, pools[i], &pool_stats);
+    *out_used_size += pool_stats.size - pool_stats.unusedSize;
+    *out_total_size += pool_stats.size;
+  }
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_vulkan_allocator_query_statistics(
+    iree_hal_allocator_t* base_allocator,
+    iree_hal_vulkan_allocator_statistics_t* out_statistics) {
+  IREE_ASSERT_ARGUMENT(base_allocator);
+  IREE_ASSERT_ARGUMENT(out_statistics);
+  memset(out_statistics, 0, sizeof(*out_statistics));
+  if (!iree_hal_resource_is(base_allocator,
+                            &iree_hal_vulkan_vma_allocator_vtable)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "allocator is not a Vulkan allocator");
+  }
+  iree_hal_vulkan_vma_allocator_t* allocator =
+      iree_hal_vulkan_vma_allocator_cast(base_allocator);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // NOTE: this walks all blocks and is not intended for use in hot paths.
+  VmaStats stats;
+  memset(&stats, 0, sizeof(stats));
+  vmaCalculateStats(allocator->vma, &stats);
+  out_statistics->device_memory_count = stats.total.blockCount;
+  out_statistics->allocation_count = stats.total.allocationCount;
+  out_statistics->used_size = stats.total.usedBytes;
+  out_statistics->unused_size = stats.total.unusedBytes;
+
+  iree_slim_mutex_lock(&allocator->pool_mutex);
+  iree_hal_vulkan_vma_allocator_accumulate_pool_statistics(
+      allocator, allocator->transient_pools,
+      &out_statistics->transient_pool_used_size,
+      &out_statistics->transient_pool_size);
+  out_statistics->transient_pool_miss_count =
+      allocator->transient_pool_miss_count;
+  iree_hal_vulkan_vma_allocator_accumulate_pool_statistics(
+      allocator, allocator->constant_pools,
+      &out_statistics->constant_pool_used_size,
+      &out_statistics->constant_pool_size);
+  iree_slim_mutex_unlock(&allocator->pool_mutex);
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+static void iree_hal_vulkan_vma_allocator_query_memory_statistics(
+    iree_hal_allocator_t* base_allocator,
+    iree_hal_allocator_statistics_t* out_statistics) {
+  iree_hal_vulkan_vma_allocator_t* allocator =
+      iree_hal_vulkan_vma_allocator_cast(base_allocator);
+  iree_slim_mutex_lock(&allocator->pool_mutex);
+  *out_statistics = allocator->memory_statistics;
+  iree_slim_mutex_unlock(&allocator->pool_mutex);
+}
+
+static void iree_hal_vulkan_vma_allocator_reset_peak_memory_statistics(
+    iree_hal_allocator_t* base_allocator) {
+  iree_hal_vulkan_vma_allocator_t* allocator =
+      iree_hal_vulkan_vma_allocator_cast(base_allocator);
+  iree_slim_mutex_lock(&allocator->pool_mutex);
+  iree_hal_allocator_statistics_reset_peak(&allocator->memory_statistics);
+  iree_slim_mutex_unlock(&allocator->pool_mutex);
+}
+
 const iree_hal_allocator_vtable_t iree_hal_vulkan_vma_allocator_vtable = {
     /*.destroy=*/iree_hal_vulkan_vma_allocator_destroy,
     /*.host_allocator=*/iree_hal_vulkan_vma_allocator_host_allocator,
@@ -282,4 +722,8 @@ const iree_hal_allocator_vtable_t iree_hal_vulkan_vma_allocator_vtable = {
     iree_hal_vulkan_vma_allocator_query_buffer_compatibility,
     /*.allocate_buffer=*/iree_hal_vulkan_vma_allocator_allocate_buffer,
     /*.wrap_buffer=*/iree_hal_vulkan_vma_allocator_wrap_buffer,
+    /*.query_statistics=*/
+    iree_hal_vulkan_vma_allocator_query_memory_statistics,
+    /*.reset_peak_statistics=*/
+    iree_hal_vulkan_vma_allocator_reset_peak_memory_statistics,
 };
@@ -16,6 +16,15 @@
 extern "C" {
 #endif  // __cplusplus
 
+typedef struct iree_hal_vulkan_vma_allocator_options_t {
+  // Block size of the per-memory-type transient ring buffer pools or 0 to
+  // allocate transient buffers from the general purpose heaps.
+  iree_device_size_t transient_pool_block_size;
+  // Block size of the per-memory-type constant pools or 0 to allocate constant
+  // buffers from the general purpose heaps.
+  iree_device_size_t constant_pool_block_size;
+} iree_hal_vulkan_vma_allocator_options_t;
+
 // Creates a VMA-based allocator that performs internal suballocation and a
 // bunch of other fancy things.
 //
@@ -33,10 +42,23 @@ extern "C" {
 // More information:
 //   https://github.com/GPUOpen-LibrariesAndSDKs/VulkanMemoryAllocator
 //   https://gpuopen-librariesandsdks.github.io/VulkanMemoryAllocator/html/
+//
+// Buffers with IREE_HAL_MEMORY_TYPE_TRANSIENT are allocated from dedicated
+// per-memory-type pools using VMA's linear algorithm in ring buffer mode so
+// that the short-lived allocations made each invocation are bump-pointer cheap
+// and never fragment the general purpose heaps. Buffers with
+// IREE_HAL_BUFFER_USAGE_CONSTANT are likewise isolated in their own pools.
 iree_status_t iree_hal_vulkan_vma_allocator_create(
     VkInstance instance, VkPhysicalDevice physical_device,
     iree::hal::vulkan::VkDeviceHandle* logical_device,
-    VmaRecordSettings record_settings, iree_hal_allocator_t** out_allocator);
+    VmaRecordSettings record_settings,
+    const iree_hal_vulkan_vma_allocator_options_t* options,
+    iree_hal_allocator_t** out_allocator);
+
+// Records the free of a |buffer| allocated from the VMA |allocator| in the
+// allocator statistics. Called by buffers as they are destroyed.
+void iree_hal_vulkan_vma_allocator_record_free(iree_hal_allocator_t* allocator,
+                                               iree_hal_buffer_t* buffer);
 
 #ifdef __cplusplus
 }  // extern "C"
@@ -12,7 +12,11 @@
 
 #include "iree/base/api.h"
 #include "iree/base/tracing.h"
+#include "iree/hal/vulkan/dynamic_symbols.h"
 #include "iree/hal/vulkan/status_util.h"
+#include "iree/hal/vulkan/vma_allocator.h"
+
+using namespace iree::hal::vulkan;
 
 typedef struct iree_hal_vulkan_vma_buffer_t {
   iree_hal_buffer_t base;
@@ -21,6 +25,11 @@ typedef struct iree_hal_vulkan_vma_buffer_t {
   VkBuffer handle;
   VmaAllocation allocation;
   VmaAllocationInfo allocation_info;
+
+  // Set when the buffer wraps memory imported outside of VMA, in which case
+  // |vma| and |allocation| are null.
+  VkDeviceHandle* logical_device;
+  VkDeviceMemory external_memory;
 } iree_hal_vulkan_vma_buffer_t;
 
 extern const iree_hal_buffer_vtable_t iree_hal_vulkan_vma_buffer_vtable;
@@ -64,22 +73,65 @@ iree_status_t iree_hal_vulkan_vma_buffer_wrap(
     buffer->handle = handle;
     buffer->allocation = allocation;
     buffer->allocation_info = allocation_info;
+    buffer->logical_device = NULL;
+    buffer->external_memory = VK_NULL_HANDLE;
 
     // TODO(benvanik): set debug name instead and use the
     //     VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT flag.
     vmaSetAllocationUserData(buffer->vma, buffer->allocation, buffer);
 
-    // TODO(benvanik): figure out why this is not working - has unbalanced
-    // allocs in the tracy UI even though they are definitely balanced here.
-    // IREE_TRACE_ALLOC_NAMED("VMA", (void*)buffer->handle, byte_length);
-
     *out_buffer = &buffer->base;
   } else {
     vmaDestroyBuffer(vma, handle, allocation);
   }
 
   IREE_TRACE_ZONE_END(z0);
-  return iree_ok_status();
+  return status;
+}
+
+iree_status_t iree_hal_vulkan_vma_buffer_wrap_external(
+    iree_hal_allocator_t* allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage, iree_device_size_t allocation_size,
+    iree_device_size_t byte_offset, iree_device_size_t byte_length,
+    VkDeviceHandle* logical_device, VkBuffer handle, VkDeviceMemory memory,
+    iree_hal_buffer_t** out_buffer) {
+  IREE_ASSERT_ARGUMENT(allocator);
+  IREE_ASSERT_ARGUMENT(logical_device);
+  IREE_ASSERT_ARGUMENT(handle);
+  IREE_ASSERT_ARGUMENT(memory);
+  IREE_ASSERT_ARGUMENT(out_buffer);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_vulkan_vma_buffer_t* buffer = NULL;
+  iree_status_t status =
+      iree_allocator_malloc(iree_hal_allocator_host_allocator(allocator),
+                            sizeof(*buffer), (void**)&buffer);
+  if (iree_status_is_ok(status)) {
+    memset(buffer, 0, sizeof(*buffer));
+    iree_hal_resource_initialize(&iree_hal_vulkan_vma_buffer_vtable,
+                                 &buffer->base.resource);
+    buffer->base.allocator = allocator;
+    buffer->base.allocated_buffer = &buffer->base;
+    buffer->base.allocation_size = allocation_size;
+    buffer->base.byte_offset = byte_offset;
+    buffer->base.byte_length = byte_length;
+    buffer->base.memory_type = memory_type;
+    buffer->base.allowed_access = allowed_access;
+    buffer->base.allowed_usage = allowed_usage;
+    buffer->handle = handle;
+    buffer->logical_device = logical_device;
+    buffer->external_memory = memory;
+    *out_buffer = &buffer->base;
+  } else {
+    logical_device->syms()->vkDestroyBuffer(*logical_device, handle,
+                                            logical_device->allocator());
+    logical_device->syms()->vkFreeMemory(*logical_device, memory,
+                                         logical_device->allocator());
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
 }
 
 static void iree_hal_vulkan_vma_buffer_destroy(iree_hal_buffer_t* base_buffer) {
@@ -89,9 +141,17 @@ static void iree_hal_vulkan_vma_buffer_destroy(iree_hal_buffer_t* base_buffer) {
       iree_hal_allocator_host_allocator(iree_hal_buffer_allocator(base_buffer));
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  // IREE_TRACE_FREE_NAMED("VMA", (void*)buffer->handle);
-
-  vmaDestroyBuffer(buffer->vma, buffer->handle, buffer->allocation);
+  if (buffer->external_memory) {
+    VkDeviceHandle* logical_device = buffer->logical_device;
+    logical_device->syms()->vkDestroyBuffer(*logical_device, buffer->handle,
+                                            logical_device->allocator());
+    logical_device->syms()->vkFreeMemory(
+        *logical_device, buffer->external_memory, logical_device->allocator());
+  } else {
+    iree_hal_vulkan_vma_allocator_record_free(buffer->base.allocator,
+                                              base_buffer);
+    vmaDestroyBuffer(buffer->vma, buffer->handle, buffer->allocation);
+  }
   iree_allocator_free(host_allocator, buffer);
 
   IREE_TRACE_ZONE_END(z0);
@@ -112,9 +172,21 @@ static iree_status_t iree_hal_vulkan_vma_buffer_map_range(
       iree_hal_vulkan_vma_buffer_cast(base_buffer);
 
   uint8_t* data_ptr = nullptr;
-  VK_RETURN_IF_ERROR(
-      vmaMapMemory(buffer->vma, buffer->allocation, (void**)&data_ptr),
-      "vmaMapMemory");
+  if (buffer->allocation_info.pMappedData) {
+    // Persistently mapped for the lifetime of the allocation.
+    data_ptr = (uint8_t*)buffer->allocation_info.pMappedData;
+  } else if (buffer->external_memory) {
+    VkDeviceHandle* logical_device = buffer->logical_device;
+    VK_RETURN_IF_ERROR(logical_device->syms()->vkMapMemory(
+                           *logical_device, buffer->external_memory,
+                           /*offset=*/0, VK_WHOLE_SIZE, /*flags=*/0,
+                           (void**)&data_ptr),
+                       "vkMapMemory");
+  } else {
+    VK_RETURN_IF_ERROR(
+        vmaMapMemory(buffer->vma, buffer->allocation, (void**)&data_ptr),
+        "vmaMapMemory");
+  }
   *out_data_ptr = data_ptr + local_byte_offset;
 
   // If we mapped for discard scribble over the bytes. This is not a mandated
@@ -135,7 +207,30 @@ static void iree_hal_vulkan_vma_buffer_unmap_range(
     iree_device_size_t local_byte_length, void* data_ptr) {
   iree_hal_vulkan_vma_buffer_t* buffer =
       iree_hal_vulkan_vma_buffer_cast(base_buffer);
-  vmaUnmapMemory(buffer->vma, buffer->allocation);
+  if (buffer->allocation_info.pMappedData) {
+    // Persistently mapped; VMA unmaps it when the allocation is destroyed.
+    return;
+  }
+  if (buffer->external_memory) {
+    buffer->logical_device->syms()->vkUnmapMemory(*buffer->logical_device,
+                                                  buffer->external_memory);
+  } else {
+    vmaUnmapMemory(buffer->vma, buffer->allocation);
+  }
+}
+
+// Returns a range covering all of the external memory of |buffer|.
+// NOTE: ranges must be aligned to nonCoherentAtomSize and we don't track it so
+// the whole allocation is always flushed/invalidated.
+static VkMappedMemoryRange iree_hal_vulkan_vma_buffer_external_range(
+    iree_hal_vulkan_vma_buffer_t* buffer) {
+  VkMappedMemoryRange range;
+  range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+  range.pNext = NULL;
+  range.memory = buffer->external_memory;
+  range.offset = 0;
+  range.size = VK_WHOLE_SIZE;
+  return range;
 }
 
 static iree_status_t iree_hal_vulkan_vma_buffer_invalidate_range(
@@ -143,6 +238,15 @@ static iree_status_t iree_hal_vulkan_vma_buffer_invalidate_range(
     iree_device_size_t local_byte_length) {
   iree_hal_vulkan_vma_buffer_t* buffer =
       iree_hal_vulkan_vma_buffer_cast(base_buffer);
+  if (buffer->external_memory) {
+    VkMappedMemoryRange range =
+        iree_hal_vulkan_vma_buffer_external_range(buffer);
+    VK_RETURN_IF_ERROR(
+        buffer->logical_device->syms()->vkInvalidateMappedMemoryRanges(
+            *buffer->logical_device, 1, &range),
+        "vkInvalidateMappedMemoryRanges");
+    return iree_ok_status();
+  }
   VK_RETURN_IF_ERROR(
       vmaInvalidateAllocation(buffer->vma, buffer->allocation,
                               local_byte_offset, local_byte_length),
@@ -155,6 +259,15 @@ static iree_status_t iree_hal_vulkan_vma_buffer_flush_range(
     iree_device_size_t local_byte_length) {
   iree_hal_vulkan_vma_buffer_t* buffer =
       iree_hal_vulkan_vma_buffer_cast(base_buffer);
+  if (buffer->external_memory) {
+    VkMappedMemoryRange range =
+        iree_hal_vulkan_vma_buffer_external_range(buffer);
+    VK_RETURN_IF_ERROR(
+        buffer->logical_device->syms()->vkFlushMappedMemoryRanges(
+            *buffer->logical_device, 1, &range),
+        "vkFlushMappedMemoryRanges");
+    return iree_ok_status();
+  }
   VK_RETURN_IF_ERROR(vmaFlushAllocation(buffer->vma, buffer->allocation,
                                         local_byte_offset, local_byte_length),
                      "vmaFlushAllocation");
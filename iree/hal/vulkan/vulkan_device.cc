@@ -11,6 +11,7 @@
 #include <cstring>
 #include <vector>
 
+#include "iree/base/internal/file_io.h"
 #include "iree/base/internal/math.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/vulkan/api.h"
@@ -28,7 +29,9 @@
 #include "iree/hal/vulkan/native_executable_layout.h"
 #include "iree/hal/vulkan/native_semaphore.h"
 #include "iree/hal/vulkan/nop_executable_cache.h"
+#include "iree/hal/vulkan/profiling.h"
 #include "iree/hal/vulkan/serializing_command_queue.h"
+#include "iree/hal/vulkan/staging_buffer.h"
 #include "iree/hal/vulkan/status_util.h"
 #include "iree/hal/vulkan/timepoint_util.h"
 #include "iree/hal/vulkan/tracing.h"
@@ -86,6 +89,24 @@ IREE_API_EXPORT iree_status_t iree_hal_vulkan_query_extensibility_set(
   ADD_EXT(IREE_HAL_VULKAN_EXTENSIBILITY_DEVICE_EXTENSIONS_OPTIONAL,
           VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
 
+  // VK_KHR_descriptor_update_template:
+  // Lets us update (or push) all the bindings of a descriptor set from a
+  // packed array in one call instead of building VkWriteDescriptorSet lists
+  // for every dispatch. Promoted to core in Vulkan 1.1.
+  ADD_EXT(IREE_HAL_VULKAN_EXTENSIBILITY_DEVICE_EXTENSIONS_OPTIONAL,
+          VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME);
+
+  // VK_KHR_external_memory_fd + VK_EXT_external_memory_dma_buf:
+  // allows iree_hal_vulkan_allocator_import_buffer to import memory from file
+  // descriptors such as dma-bufs produced by camera or video decoder drivers
+  // without a copy. VK_KHR_external_memory was promoted to core in Vulkan 1.1.
+  ADD_EXT(IREE_HAL_VULKAN_EXTENSIBILITY_DEVICE_EXTENSIONS_OPTIONAL,
+          VK_KHR_EXTERNAL_MEMORY_EXTENSION_NAME);
+  ADD_EXT(IREE_HAL_VULKAN_EXTENSIBILITY_DEVICE_EXTENSIONS_OPTIONAL,
+          VK_KHR_EXTERNAL_MEMORY_FD_EXTENSION_NAME);
+  ADD_EXT(IREE_HAL_VULKAN_EXTENSIBILITY_DEVICE_EXTENSIONS_OPTIONAL,
+          VK_EXT_EXTERNAL_MEMORY_DMA_BUF_EXTENSION_NAME);
+
   //===--------------------------------------------------------------------===//
   // Vulkan forward-compatibility shims
   //===--------------------------------------------------------------------===//
@@ -129,16 +150,16 @@ IREE_API_EXPORT iree_status_t iree_hal_vulkan_query_extensibility_set(
             VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
   }
 
+  // VK_EXT_host_query_reset:
+  // optionally allows for vkResetQueryPool to be used to reset query pools
+  // from the host without needing to do an expensive vkCmdResetQueryPool
+  // submission. Required for dispatch profiling and used by tracing.
+  ADD_EXT(IREE_HAL_VULKAN_EXTENSIBILITY_DEVICE_EXTENSIONS_OPTIONAL,
+          VK_EXT_HOST_QUERY_RESET_EXTENSION_NAME);
+
 #if IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
   if (iree_all_bits_set(requested_features,
                         IREE_HAL_VULKAN_FEATURE_ENABLE_TRACING)) {
-    // VK_EXT_host_query_reset:
-    // optionally allows for vkResetQueryPool to be used to reset query pools
-    // from the host without needing to do an expensive vkCmdResetQueryPool
-    // submission.
-    ADD_EXT(IREE_HAL_VULKAN_EXTENSIBILITY_DEVICE_EXTENSIONS_OPTIONAL,
-            VK_EXT_HOST_QUERY_RESET_EXTENSION_NAME);
-
     // VK_EXT_calibrated_timestamps:
     // optionally provides more accurate timestamps that correspond to the
     // system time. If this is not present then tracy will attempt calibration
@@ -192,6 +213,7 @@ static uint32_t iree_hal_vulkan_find_first_queue_family_with_flags(
 // available.
 static iree_status_t iree_hal_vulkan_select_queue_families(
     VkPhysicalDevice physical_device, iree::hal::vulkan::DynamicSymbols* syms,
+    const iree_hal_vulkan_device_options_t* options,
     iree_hal_vulkan_queue_family_info_t* out_family_info) {
   // Enumerate queue families available on the device.
   uint32_t queue_family_count = 0;
@@ -262,8 +284,19 @@ static iree_status_t iree_hal_vulkan_select_queue_families(
         queue_family_properties[out_family_info->transfer_index].queueCount;
   }
 
+  // Limit the number of queues we create. Each queue adds overhead so we only
+  // create as many as the hosting application asked for.
+  out_family_info->dispatch_queue_count =
+      iree_min(iree_max(1u, options->max_dispatch_queue_count),
+               out_family_info->dispatch_queue_count);
+  out_family_info->transfer_queue_count =
+      iree_min(options->max_transfer_queue_count,
+               out_family_info->transfer_queue_count);
+
   // Ensure that we don't share the dispatch queues with transfer queues if
-  // that would put us over the queue count.
+  // that would put us over the queue count. This must happen after limiting
+  // the dispatch queues so that the remaining queues of a shared family can be
+  // used for transfers.
   if (out_family_info->dispatch_index == out_family_info->transfer_index) {
     out_family_info->transfer_queue_count = iree_min(
         queue_family_properties[out_family_info->dispatch_index].queueCount -
@@ -271,14 +304,6 @@ static iree_status_t iree_hal_vulkan_select_queue_families(
         out_family_info->transfer_queue_count);
   }
 
-  // Limit the number of queues we create (for now).
-  // We may want to allow this to grow, but each queue adds overhead and we
-  // need to measure to make sure we can effectively use them all.
-  out_family_info->dispatch_queue_count =
-      iree_min(2u, out_family_info->dispatch_queue_count);
-  out_family_info->transfer_queue_count =
-      iree_min(1u, out_family_info->transfer_queue_count);
-
   return iree_ok_status();
 }
 
@@ -286,12 +311,13 @@ static iree_status_t iree_hal_vulkan_select_queue_families(
 // the device and some magic heuristical goo.
 static iree_status_t iree_hal_vulkan_build_queue_sets(
     VkPhysicalDevice physical_device, iree::hal::vulkan::DynamicSymbols* syms,
+    const iree_hal_vulkan_device_options_t* options,
     iree_hal_vulkan_queue_set_t* out_compute_queue_set,
     iree_hal_vulkan_queue_set_t* out_transfer_queue_set) {
   // Select which queues to use (and fail the implementation can't handle them).
   iree_hal_vulkan_queue_family_info_t queue_family_info;
   IREE_RETURN_IF_ERROR(iree_hal_vulkan_select_queue_families(
-      physical_device, syms, &queue_family_info));
+      physical_device, syms, options, &queue_family_info));
 
   // Build queue indices for the selected queue families.
   memset(out_compute_queue_set, 0, sizeof(*out_compute_queue_set));
@@ -306,7 +332,7 @@ static iree_status_t iree_hal_vulkan_build_queue_sets(
   uint32_t base_queue_index = 0;
   if (queue_family_info.dispatch_index == queue_family_info.transfer_index) {
     // Sharing a family, so transfer queues follow compute queues.
-    base_queue_index = queue_family_info.dispatch_index;
+    base_queue_index = queue_family_info.dispatch_queue_count;
   }
   for (iree_host_size_t i = 0; i < queue_family_info.transfer_queue_count;
        ++i) {
@@ -357,12 +383,26 @@ typedef struct iree_hal_vulkan_device_t {
 
   DescriptorPoolCache* descriptor_pool_cache;
 
+  // Dispatch profiling context or NULL if the device cannot produce
+  // timestamps.
+  iree_hal_vulkan_profiling_context_t* profiling_context;
+
+  // Ring used to stage uploads recorded into one-shot command buffers or NULL
+  // if disabled. Requires native timeline semaphores for reclamation.
+  iree_hal_vulkan_staging_buffer_t* staging_buffer;
+
+  // Pipeline cache shared by all executables created on the device.
+  VkPipelineCache pipeline_cache;
+  // NUL-terminated path the pipeline cache is persisted to, or empty.
+  iree_string_view_t pipeline_cache_path;
+
   VkCommandPoolHandle* dispatch_command_pool;
   VkCommandPoolHandle* transfer_command_pool;
 
   // Used only for emulated timeline semaphores.
   TimePointSemaphorePool* semaphore_pool;
   TimePointFencePool* fence_pool;
+  FenceWaitThread* fence_wait_thread;
 } iree_hal_vulkan_device_t;
 
 extern const iree_hal_device_vtable_t iree_hal_vulkan_device_vtable;
@@ -377,6 +417,126 @@ IREE_API_EXPORT void iree_hal_vulkan_device_options_initialize(
     iree_hal_vulkan_device_options_t* out_options) {
   memset(out_options, 0, sizeof(*out_options));
   out_options->flags = 0;
+  out_options->transient_pool_block_size = 64 * 1024 * 1024;
+  out_options->constant_pool_block_size = 32 * 1024 * 1024;
+  out_options->max_dispatch_queue_count = 2;
+  out_options->max_transfer_queue_count = 1;
+  out_options->staging_buffer_capacity = 16 * 1024 * 1024;
+  out_options->pipeline_cache_path = iree_string_view_empty();
+}
+
+// Size of the VK_PIPELINE_CACHE_HEADER_VERSION_ONE header prefixing the data
+// returned by vkGetPipelineCacheData:
+//   uint32_t headerSize;
+//   uint32_t headerVersion;
+//   uint32_t vendorID;
+//   uint32_t deviceID;
+//   uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+#define IREE_HAL_VULKAN_PIPELINE_CACHE_HEADER_SIZE \
+  (4 * sizeof(uint32_t) + VK_UUID_SIZE)
+
+// Returns true if |data| is a pipeline cache blob produced by the same driver
+// and physical device as described by |properties|. Implementations are
+// required to reject incompatible data but not all do so gracefully, so we
+// check the header ourselves before handing the blob to the driver.
+static bool iree_hal_vulkan_pipeline_cache_data_is_compatible(
+    iree_const_byte_span_t data, const VkPhysicalDeviceProperties* properties) {
+  if (data.data_length < IREE_HAL_VULKAN_PIPELINE_CACHE_HEADER_SIZE) {
+    return false;
+  }
+  uint32_t header[4];
+  memcpy(header, data.data, sizeof(header));
+  if (header[0] < IREE_HAL_VULKAN_PIPELINE_CACHE_HEADER_SIZE ||
+      header[0] > data.data_length ||
+      header[1] != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+      header[2] != properties->vendorID || header[3] != properties->deviceID) {
+    return false;
+  }
+  return memcmp(data.data + sizeof(header), properties->pipelineCacheUUID,
+                VK_UUID_SIZE) == 0;
+}
+
+// Creates the pipeline cache used for all executables created on the device.
+// If |path| names a compatible cache file its contents are used as the initial
+// cache data; missing or incompatible files are ignored and an empty cache is
+// created instead.
+static iree_status_t iree_hal_vulkan_device_create_pipeline_cache(
+    VkPhysicalDevice physical_device, VkDeviceHandle* logical_device,
+    const char* path, VkPipelineCache* out_pipeline_cache) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  *out_pipeline_cache = VK_NULL_HANDLE;
+
+  iree_byte_span_t file_contents = iree_make_byte_span(NULL, 0);
+  if (path && path[0] != '\0' && iree_status_is_ok(iree_file_exists(path))) {
+    iree_status_t read_status = iree_file_read_contents(
+        path, logical_device->host_allocator(), &file_contents);
+    if (!iree_status_is_ok(read_status)) {
+      // A stale or unreadable cache only costs us compilation time.
+      iree_status_ignore(read_status);
+      file_contents = iree_make_byte_span(NULL, 0);
+    }
+  }
+
+  VkPipelineCacheCreateInfo create_info;
+  create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  create_info.pNext = NULL;
+  create_info.flags = 0;
+  create_info.initialDataSize = 0;
+  create_info.pInitialData = NULL;
+  if (file_contents.data) {
+    VkPhysicalDeviceProperties properties;
+    logical_device->syms()->vkGetPhysicalDeviceProperties(physical_device,
+                                                          &properties);
+    if (iree_hal_vulkan_pipeline_cache_data_is_compatible(
+            iree_make_const_byte_span(file_contents.data,
+                                      file_contents.data_length),
+            &properties)) {
+      create_info.initialDataSize = file_contents.data_length;
+      create_info.pInitialData = file_contents.data;
+    }
+  }
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)create_info.initialDataSize);
+
+  iree_status_t status = VK_RESULT_TO_STATUS(
+      logical_device->syms()->vkCreatePipelineCache(
+          *logical_device, &create_info, logical_device->allocator(),
+          out_pipeline_cache),
+      "vkCreatePipelineCache");
+
+  iree_allocator_free(logical_device->host_allocator(), file_contents.data);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Writes the contents of |pipeline_cache| to the file at |path|.
+static iree_status_t iree_hal_vulkan_device_save_pipeline_cache(
+    VkDeviceHandle* logical_device, VkPipelineCache pipeline_cache,
+    const char* path) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  size_t data_size = 0;
+  iree_status_t status = VK_RESULT_TO_STATUS(
+      logical_device->syms()->vkGetPipelineCacheData(
+          *logical_device, pipeline_cache, &data_size, NULL),
+      "vkGetPipelineCacheData");
+  void* data = NULL;
+  if (iree_status_is_ok(status) && data_size > 0) {
+    status = iree_allocator_malloc(logical_device->host_allocator(), data_size,
+                                   &data);
+  }
+  if (iree_status_is_ok(status) && data) {
+    status = VK_RESULT_TO_STATUS(
+        logical_device->syms()->vkGetPipelineCacheData(
+            *logical_device, pipeline_cache, &data_size, data),
+        "vkGetPipelineCacheData");
+  }
+  if (iree_status_is_ok(status) && data) {
+    IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)data_size);
+    status = iree_file_write_contents(
+        path, iree_make_const_byte_span(data, data_size));
+  }
+  iree_allocator_free(logical_device->host_allocator(), data);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
 }
 
 // Creates a transient command pool for the given queue family.
@@ -439,12 +599,14 @@ static iree_status_t iree_hal_vulkan_device_initialize_command_queues(
   // the tracing subsystem for query and cleanup tasks.
   VkQueue maintenance_dispatch_queue = VK_NULL_HANDLE;
 
-  uint64_t compute_queue_count =
-      iree_math_count_ones_u64(compute_queue_set->queue_indices);
+  // NOTE: the queue sets are bitfields of queue indices within their family
+  // and need not start at 0 (for example when transfer queues follow the
+  // dispatch queues in a shared family).
   uint64_t transfer_queue_count =
       iree_math_count_ones_u64(transfer_queue_set->queue_indices);
-  for (iree_host_size_t i = 0; i < compute_queue_count; ++i) {
-    if (!(compute_queue_set->queue_indices & (1ull << i))) continue;
+  for (uint64_t queue_bits = compute_queue_set->queue_indices; queue_bits;
+       queue_bits &= queue_bits - 1) {
+    uint32_t i = (uint32_t)iree_math_count_trailing_zeros_u64(queue_bits);
 
     char queue_name_buffer[32];
     int queue_name_length =
@@ -481,8 +643,9 @@ static iree_status_t iree_hal_vulkan_device_initialize_command_queues(
       queue->set_tracing_context(device->queue_tracing_contexts[queue_index]);
     }
   }
-  for (iree_host_size_t i = 0; i < transfer_queue_count; ++i) {
-    if (!(transfer_queue_set->queue_indices & (1ull << i))) continue;
+  for (uint64_t queue_bits = transfer_queue_set->queue_indices; queue_bits;
+       queue_bits &= queue_bits - 1) {
+    uint32_t i = (uint32_t)iree_math_count_trailing_zeros_u64(queue_bits);
 
     char queue_name_buffer[32];
     int queue_name_length =
@@ -537,7 +700,8 @@ static iree_status_t iree_hal_vulkan_device_create_internal(
       total_queue_count * sizeof(device->queues[0]) +
       total_queue_count * sizeof(device->dispatch_queues[0]) +
       total_queue_count * sizeof(device->transfer_queues[0]) +
-      total_queue_count * sizeof(device->queue_tracing_contexts[0]);
+      total_queue_count * sizeof(device->queue_tracing_contexts[0]) +
+      options->pipeline_cache_path.size + /*NUL=*/1;
   IREE_RETURN_IF_ERROR(
       iree_allocator_malloc(host_allocator, total_size, (void**)&device));
   memset(device, 0, total_size);
@@ -569,6 +733,12 @@ static iree_status_t iree_hal_vulkan_device_create_internal(
       (iree_hal_vulkan_tracing_context_t**)buffer_ptr;
   buffer_ptr += total_queue_count * sizeof(device->queue_tracing_contexts[0]);
 
+  // The pipeline cache path is stored NUL-terminated (the allocation is zeroed
+  // above) so that it can be passed directly to the file APIs.
+  buffer_ptr += iree_string_view_append_to_buffer(
+      options->pipeline_cache_path, &device->pipeline_cache_path,
+      (char*)buffer_ptr);
+
   device->descriptor_pool_cache =
       new DescriptorPoolCache(device->logical_device);
 
@@ -576,9 +746,19 @@ static iree_status_t iree_hal_vulkan_device_create_internal(
   // allocation requests.
   VmaRecordSettings vma_record_settings;
   memset(&vma_record_settings, 0, sizeof(vma_record_settings));
+  iree_hal_vulkan_vma_allocator_options_t vma_options;
+  memset(&vma_options, 0, sizeof(vma_options));
+  vma_options.transient_pool_block_size = options->transient_pool_block_size;
+  vma_options.constant_pool_block_size = options->constant_pool_block_size;
   iree_status_t status = iree_hal_vulkan_vma_allocator_create(
       instance, physical_device, logical_device, vma_record_settings,
-      &device->device_allocator);
+      &vma_options, &device->device_allocator);
+
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_vulkan_device_create_pipeline_cache(
+        physical_device, device->logical_device,
+        device->pipeline_cache_path.data, &device->pipeline_cache);
+  }
 
   // Create command pools for each queue family. If we don't have a transfer
   // queue then we'll ignore that one and just use the dispatch pool.
@@ -612,6 +792,14 @@ static iree_status_t iree_hal_vulkan_device_create_internal(
         TimePointFencePool::Create(device->logical_device, &device->fence_pool);
   }
 
+  // Dispatch profiling is optional; devices that cannot support it report
+  // UNAVAILABLE when a profiling session is started.
+  if (iree_status_is_ok(status)) {
+    iree_status_ignore(iree_hal_vulkan_profiling_context_allocate(
+        physical_device, device->logical_device, host_allocator,
+        &device->profiling_context));
+  }
+
   // Initialize queues now that we've completed the rest of the device
   // initialization; this happens last as the queues require the pools allocated
   // above.
@@ -621,6 +809,38 @@ static iree_status_t iree_hal_vulkan_device_create_internal(
         transfer_queue_set);
   }
 
+  // The staging ring is reclaimed by timeline semaphores signaled by each
+  // (direct) queue submission. It is an optimization only and the device is
+  // still usable without it.
+  if (!emulate_timeline_semaphores && options->staging_buffer_capacity > 0 &&
+      iree_status_is_ok(status)) {
+    iree_status_t staging_status = iree_hal_vulkan_staging_buffer_allocate(
+        device->logical_device, device->device_allocator,
+        options->staging_buffer_capacity, &device->staging_buffer);
+    for (iree_host_size_t i = 0;
+         i < device->queue_count && iree_status_is_ok(staging_status); ++i) {
+      staging_status = static_cast<DirectCommandQueue*>(device->queues[i])
+                           ->SetStagingBuffer(device->staging_buffer);
+    }
+    if (!iree_status_is_ok(staging_status)) {
+      iree_status_ignore(staging_status);
+      for (iree_host_size_t i = 0; i < device->queue_count; ++i) {
+        IREE_IGNORE_ERROR(static_cast<DirectCommandQueue*>(device->queues[i])
+                              ->SetStagingBuffer(NULL));
+      }
+      iree_hal_vulkan_staging_buffer_free(device->staging_buffer);
+      device->staging_buffer = NULL;
+    }
+  }
+
+  // Emulated timeline semaphores advance deferred submissions from a thread
+  // waiting on the fences of all queues.
+  if (emulate_timeline_semaphores && iree_status_is_ok(status)) {
+    status = FenceWaitThread::Create(device->logical_device,
+                                     device->queue_count, device->queues,
+                                     &device->fence_wait_thread);
+  }
+
   if (iree_status_is_ok(status)) {
     *out_device = (iree_hal_device_t*)device;
   } else {
@@ -634,6 +854,9 @@ static void iree_hal_vulkan_device_destroy(iree_hal_device_t* base_device) {
   iree_allocator_t host_allocator = iree_hal_device_host_allocator(base_device);
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // Stop advancing deferred submissions before the queues go away.
+  delete device->fence_wait_thread;
+
   // Drop all command queues. These may wait until idle in their destructor.
   for (iree_host_size_t i = 0; i < device->queue_count; ++i) {
     delete device->queues[i];
@@ -647,10 +870,25 @@ static void iree_hal_vulkan_device_destroy(iree_hal_device_t* base_device) {
 
   // Now that no commands are outstanding we can release all resources that may
   // have been in use.
+  iree_hal_vulkan_profiling_context_free(device->profiling_context);
+  iree_hal_vulkan_staging_buffer_free(device->staging_buffer);
   delete device->descriptor_pool_cache;
   delete device->semaphore_pool;
   delete device->fence_pool;
 
+  // Persist the pipelines compiled during the lifetime of the device so that
+  // the next process can skip compilation. Failing to save is not fatal.
+  if (device->pipeline_cache != VK_NULL_HANDLE) {
+    if (!iree_string_view_is_empty(device->pipeline_cache_path)) {
+      iree_status_ignore(iree_hal_vulkan_device_save_pipeline_cache(
+          device->logical_device, device->pipeline_cache,
+          device->pipeline_cache_path.data));
+    }
+    device->logical_device->syms()->vkDestroyPipelineCache(
+        *device->logical_device, device->pipeline_cache,
+        device->logical_device->allocator());
+  }
+
   // There should be no more buffers live that use the allocator.
   iree_hal_allocator_release(device->device_allocator);
 
@@ -710,7 +948,7 @@ iree_status_t iree_hal_vulkan_device_create(
   // Find queue families we will expose as HAL queues.
   iree_hal_vulkan_queue_family_info_t queue_family_info;
   IREE_RETURN_IF_ERROR(iree_hal_vulkan_select_queue_families(
-      physical_device, instance_syms, &queue_family_info));
+      physical_device, instance_syms, options, &queue_family_info));
 
   bool has_dedicated_transfer_queues =
       queue_family_info.transfer_queue_count > 0;
@@ -815,8 +1053,8 @@ iree_status_t iree_hal_vulkan_device_create(
   iree_hal_vulkan_queue_set_t transfer_queue_set;
   if (iree_status_is_ok(status)) {
     status = iree_hal_vulkan_build_queue_sets(
-        physical_device, logical_device->syms().get(), &compute_queue_set,
-        &transfer_queue_set);
+        physical_device, logical_device->syms().get(), options,
+        &compute_queue_set, &transfer_queue_set);
   }
 
   // Allocate and initialize the device.
@@ -969,7 +1207,8 @@ static iree_status_t iree_hal_vulkan_device_create_command_buffer(
 
   return iree_hal_vulkan_direct_command_buffer_allocate(
       device->logical_device, command_pool, mode, command_categories,
-      queue_affinity, queue->tracing_context(), device->descriptor_pool_cache,
+      queue_affinity, queue->tracing_context(), device->profiling_context,
+      device->staging_buffer, device->descriptor_pool_cache,
       out_command_buffer);
 }
 
@@ -1007,7 +1246,10 @@ static iree_status_t iree_hal_vulkan_device_create_executable_cache(
     iree_hal_executable_cache_t** out_executable_cache) {
   iree_hal_vulkan_device_t* device = iree_hal_vulkan_device_cast(base_device);
   return iree_hal_vulkan_nop_executable_cache_create(
-      device->logical_device, identifier, out_executable_cache);
+      device->logical_device, device->pipeline_cache,
+      iree_all_bits_set(device->flags,
+                        IREE_HAL_VULKAN_DEVICE_DEFER_PIPELINE_CREATION),
+      identifier, out_executable_cache);
 }
 
 static iree_status_t iree_hal_vulkan_device_create_executable_layout(
@@ -1085,6 +1327,34 @@ static iree_status_t iree_hal_vulkan_device_wait_idle(
   return iree_ok_status();
 }
 
+static iree_status_t iree_hal_vulkan_device_begin_dispatch_profiling(
+    iree_hal_device_t* base_device) {
+  iree_hal_vulkan_device_t* device = iree_hal_vulkan_device_cast(base_device);
+  if (!device->profiling_context) {
+    return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                            "device does not support dispatch profiling");
+  }
+  return iree_hal_vulkan_profiling_context_begin(device->profiling_context);
+}
+
+static iree_status_t iree_hal_vulkan_device_end_dispatch_profiling(
+    iree_hal_device_t* base_device) {
+  iree_hal_vulkan_device_t* device = iree_hal_vulkan_device_cast(base_device);
+  if (device->profiling_context) {
+    iree_hal_vulkan_profiling_context_end(device->profiling_context);
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_vulkan_device_flush_dispatch_profiles(
+    iree_hal_device_t* base_device,
+    iree_hal_dispatch_profile_callback_t callback) {
+  iree_hal_vulkan_device_t* device = iree_hal_vulkan_device_cast(base_device);
+  if (!device->profiling_context) return iree_ok_status();
+  return iree_hal_vulkan_profiling_context_flush(device->profiling_context,
+                                                 callback);
+}
+
 const iree_hal_device_vtable_t iree_hal_vulkan_device_vtable = {
     /*.destroy=*/iree_hal_vulkan_device_destroy,
     /*.id=*/iree_hal_vulkan_device_id,
@@ -1106,4 +1376,9 @@ const iree_hal_device_vtable_t iree_hal_vulkan_device_vtable = {
     iree_hal_vulkan_device_submit_and_wait,
     /*.wait_semaphores=*/iree_hal_vulkan_device_wait_semaphores,
     /*.wait_idle=*/iree_hal_vulkan_device_wait_idle,
+    /*.begin_dispatch_profiling=*/
+    iree_hal_vulkan_device_begin_dispatch_profiling,
+    /*.end_dispatch_profiling=*/iree_hal_vulkan_device_end_dispatch_profiling,
+    /*.flush_dispatch_profiles=*/
+    iree_hal_vulkan_device_flush_dispatch_profiles,
 };
@@ -39,6 +39,7 @@ EXPORT_FN("buffer_view.dim", iree_hal_module_buffer_view_dim, ri, i)
 EXPORT_FN("buffer_view.element_type", iree_hal_module_buffer_view_element_type, r, i)
 EXPORT_FN("buffer_view.encoding_type", iree_hal_module_buffer_view_encoding_type, r, i)
 EXPORT_FN("buffer_view.rank", iree_hal_module_buffer_view_rank, r, i)
+EXPORT_FN("buffer_view.summarize", iree_hal_module_buffer_view_summarize, rCrD, v)
 EXPORT_FN("buffer_view.trace", iree_hal_module_buffer_view_trace, rCrD, v)
 
 EXPORT_FN("command_buffer.begin", iree_hal_module_command_buffer_begin, r, v)
@@ -48,6 +49,7 @@ EXPORT_FN("command_buffer.copy_buffer", iree_hal_module_command_buffer_copy_buff
 EXPORT_FN("command_buffer.create", iree_hal_module_command_buffer_create, rii, r)
 EXPORT_FN("command_buffer.dispatch", iree_hal_module_command_buffer_dispatch, rriiii, v)
 EXPORT_FN("command_buffer.dispatch.indirect", iree_hal_module_command_buffer_dispatch_indirect, rriri, v)
+EXPORT_FN("command_buffer.dispatch.push", iree_hal_module_command_buffer_dispatch_push, rrriiiiiiCiDCiriiD, v)
 EXPORT_FN("command_buffer.end", iree_hal_module_command_buffer_end, r, v)
 EXPORT_FN("command_buffer.end_debug_group", iree_hal_module_command_buffer_end_debug_group, r, v)
 EXPORT_FN("command_buffer.execution_barrier", iree_hal_module_command_buffer_execution_barrier, riii, v)
@@ -61,8 +63,12 @@ EXPORT_FN("descriptor_set_layout.create", iree_hal_module_descriptor_set_layout_
 
 EXPORT_FN("device.allocator", iree_hal_module_device_allocator, r, r)
 EXPORT_FN("device.query.i32", iree_hal_module_device_query_i32, rrr, ii)
+EXPORT_FN("device.queue.submit", iree_hal_module_device_queue_submit, rrriCriD, v)
 
+EXPORT_FN("ex.buffer.copy", iree_hal_module_ex_buffer_copy, ririi, v)
+EXPORT_FN("ex.device", iree_hal_module_ex_device, i, r)
 EXPORT_FN("ex.shared_device", iree_hal_module_ex_shared_device, v, r)
+EXPORT_FN("ex.submit", iree_hal_module_ex_submit, rrri, v)
 EXPORT_FN("ex.submit_and_wait", iree_hal_module_ex_submit_and_wait, rr, v)
 
 EXPORT_FN("executable.create", iree_hal_module_executable_create, rrrCrD, r)
@@ -14,6 +14,10 @@
 #include <string.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/arena.h"
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/flight_recorder.h"
+#include "iree/base/internal/synchronization.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/api.h"
 #include "iree/vm/api.h"
@@ -22,6 +26,25 @@
 // in the future but right now guards the stack from blowing up during calls.
 #define IREE_HAL_MODULE_MAX_DESCRIPTOR_BINDING_COUNT ((iree_host_size_t)32)
 
+// Limit the number of devices a single module may be created with.
+#define IREE_HAL_MODULE_MAX_DEVICE_COUNT ((iree_host_size_t)8)
+
+// Limit the number of semaphores a single queue submission may wait on.
+#define IREE_HAL_MODULE_MAX_WAIT_SEMAPHORE_COUNT ((iree_host_size_t)16)
+
+// Size of each block in the per-context transient buffer arena. Allocations
+// larger than this are made directly from the host allocator and still freed
+// in bulk when the arena is reset.
+#define IREE_HAL_MODULE_TRANSIENT_BLOCK_SIZE ((iree_host_size_t)(256 * 1024))
+
+// Number of trace summaries retained per context before the oldest are
+// overwritten.
+#define IREE_HAL_MODULE_TRACE_SUMMARY_CAPACITY ((iree_host_size_t)256)
+
+// Alignment of the contents of transient buffers allocated from the arena.
+// Matches the default alignment of heap allocator buffers.
+#define IREE_HAL_MODULE_TRANSIENT_ALIGNMENT ((iree_host_size_t)64)
+
 //===----------------------------------------------------------------------===//
 // Type registration
 //===----------------------------------------------------------------------===//
@@ -116,28 +139,129 @@ IREE_VM_DEFINE_TYPE_ADAPTERS(iree_hal_semaphore, iree_hal_semaphore_t);
 
 typedef struct iree_hal_module_t {
   iree_allocator_t host_allocator;
-  iree_hal_device_t* shared_device;
+  // Devices the module was created with. devices[0] is the shared device.
+  iree_host_size_t device_count;
+  iree_hal_device_t* devices[IREE_HAL_MODULE_MAX_DEVICE_COUNT];
   // TODO(benvanik): types.
 } iree_hal_module_t;
 
 #define IREE_HAL_MODULE_CAST(module) \
   (iree_hal_module_t*)((uint8_t*)(module) + iree_vm_native_module_size());
 
-typedef struct iree_hal_module_state_t {
-  iree_allocator_t host_allocator;
-  iree_hal_device_t* shared_device;
+// Per-context state of each device the module was created with.
+typedef struct iree_hal_module_device_state_t {
+  iree_hal_device_t* device;
   iree_hal_executable_cache_t* executable_cache;
 
+  // Timeline of all submissions made to the device. Submissions to different
+  // devices are only ordered by the semaphores passed in by the program.
   iree_hal_semaphore_t* submit_semaphore;
   uint64_t submit_value;
+} iree_hal_module_device_state_t;
+
+// Block pool used for transient buffer storage. Shared by the module state
+// and all transient arenas as arenas may outlive the state when buffers
+// allocated from them are still live when the context is destroyed.
+typedef struct iree_hal_module_transient_pool_t {
+  iree_atomic_ref_count_t ref_count;
+  iree_allocator_t host_allocator;
+  iree_arena_block_pool_t block_pool;
+} iree_hal_module_transient_pool_t;
+
+// Storage of the transient buffers allocated during a single invocation.
+// Each invocation gets its own arena that is freed once the invocation has
+// ended and all buffers allocated from it have been released. Buffers that
+// outlive their invocation (such as those retained by deferred releases until
+// in-flight work completes) only keep their own arena alive and never prevent
+// the storage of other invocations from being reclaimed.
+//
+// The arena is only allocated from by the thread performing the invocation
+// (contexts are thread-compatible) while buffers may be released from any
+// thread. The arena memory is not touched again after the last reference is
+// dropped so no other synchronization is required.
+typedef struct iree_hal_module_transient_arena_t {
+  // One reference for each live buffer allocated from the arena plus one held
+  // by the module state until the invocation ends.
+  iree_atomic_ref_count_t ref_count;
+  iree_hal_module_transient_pool_t* pool;
+  // Arena the storage is allocated from. This struct is allocated from the
+  // arena itself.
+  iree_arena_allocator_t arena;
+} iree_hal_module_transient_arena_t;
+
+typedef struct iree_hal_module_state_t {
+  iree_allocator_t host_allocator;
+
+  iree_host_size_t device_count;
+  iree_hal_module_device_state_t devices[IREE_HAL_MODULE_MAX_DEVICE_COUNT];
 
   void* deferred_lru[6];
   iree_vm_list_t* deferred_releases;
+
+  // Block pool shared by the transient arenas of all invocations.
+  iree_hal_module_transient_pool_t* transient_pool;
+  // Arena used for the storage of buffers allocated with
+  // IREE_HAL_MEMORY_TYPE_TRANSIENT from heap allocators during the current
+  // invocation, if any have been allocated. The compiler only marks
+  // allocations transient when they are proven not to escape the invocation.
+  iree_hal_module_transient_arena_t* transient_arena;
+
+  // Pool of buffer view storage shared by all buffer views created by the
+  // module. Buffer views are created for most results and are short-lived.
+  iree_hal_buffer_view_pool_t* buffer_view_pool;
+
+  // Ring of summaries recorded by hal.buffer_view.summarize. Allocated on the
+  // first summary so that programs not using summaries pay nothing. Drained
+  // from other threads with iree_hal_module_state_drain_trace_summaries.
+  iree_slim_mutex_t trace_summary_mutex;
+  iree_hal_module_trace_summary_t* trace_summaries;
+  // Total number of summaries ever recorded; the next goes in
+  // trace_summaries[trace_summary_head % capacity].
+  uint64_t trace_summary_head;
+  // Number of summaries in the ring that have not yet been drained.
+  iree_host_size_t trace_summary_count;
 } iree_hal_module_state_t;
 
 static void IREE_API_PTR iree_hal_module_destroy(void* base_module) {
   iree_hal_module_t* module = IREE_HAL_MODULE_CAST(base_module);
-  iree_hal_device_release(module->shared_device);
+  for (iree_host_size_t i = 0; i < module->device_count; ++i) {
+    iree_hal_device_release(module->devices[i]);
+  }
+}
+
+static void iree_hal_module_transient_pool_release(
+    iree_hal_module_transient_pool_t* pool) {
+  if (!pool) return;
+  if (iree_atomic_fetch_sub_int32(&pool->ref_count, 1,
+                                  iree_memory_order_acq_rel) == 1) {
+    iree_arena_block_pool_deinitialize(&pool->block_pool);
+    iree_allocator_free(pool->host_allocator, pool);
+  }
+}
+
+// Drops a reference to |transient_arena| and returns its blocks to the pool
+// when it was the last. May be called from any thread.
+static void iree_hal_module_transient_arena_release(
+    iree_hal_module_transient_arena_t* transient_arena) {
+  if (iree_atomic_fetch_sub_int32(&transient_arena->ref_count, 1,
+                                  iree_memory_order_acq_rel) != 1) {
+    return;
+  }
+  // The arena struct lives in the arena so it must be copied out first.
+  iree_hal_module_transient_pool_t* pool = transient_arena->pool;
+  iree_arena_allocator_t arena = transient_arena->arena;
+  transient_arena = NULL;
+  iree_arena_deinitialize(&arena);
+  iree_hal_module_transient_pool_release(pool);
+}
+
+// Ends the transient arena of the current invocation, if any. Its storage is
+// reclaimed as soon as all buffers allocated from it have been released.
+static void iree_hal_module_state_end_transients(
+    iree_hal_module_state_t* state) {
+  if (!state->transient_arena) return;
+  iree_hal_module_transient_arena_release(state->transient_arena);
+  state->transient_arena = NULL;
 }
 
 static iree_status_t IREE_API_PTR
@@ -149,20 +273,36 @@ iree_hal_module_alloc_state(void* self, iree_allocator_t host_allocator,
       iree_allocator_malloc(host_allocator, sizeof(*state), (void**)&state));
   memset(state, 0, sizeof(*state));
   state->host_allocator = host_allocator;
-  state->shared_device = module->shared_device;
-  iree_hal_device_retain(state->shared_device);
+
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(host_allocator,
+                                             sizeof(*state->transient_pool),
+                                             (void**)&state->transient_pool));
+  iree_atomic_ref_count_init(&state->transient_pool->ref_count);
+  state->transient_pool->host_allocator = host_allocator;
+  iree_arena_block_pool_initialize(IREE_HAL_MODULE_TRANSIENT_BLOCK_SIZE,
+                                   host_allocator,
+                                   &state->transient_pool->block_pool);
 
   IREE_RETURN_IF_ERROR(iree_vm_list_create(
       /*element_type=*/NULL, /*initial_capacity=*/512, state->host_allocator,
       &state->deferred_releases));
-
-  IREE_RETURN_IF_ERROR(iree_hal_executable_cache_create(
-      state->shared_device, iree_string_view_empty(),
-      &state->executable_cache));
-
-  state->submit_value = 0ull;
-  IREE_RETURN_IF_ERROR(iree_hal_semaphore_create(
-      state->shared_device, state->submit_value, &state->submit_semaphore));
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_view_pool_create(
+      state->host_allocator, &state->buffer_view_pool));
+  iree_slim_mutex_initialize(&state->trace_summary_mutex);
+
+  state->device_count = module->device_count;
+  for (iree_host_size_t i = 0; i < state->device_count; ++i) {
+    iree_hal_module_device_state_t* device_state = &state->devices[i];
+    device_state->device = module->devices[i];
+    iree_hal_device_retain(device_state->device);
+    IREE_RETURN_IF_ERROR(iree_hal_executable_cache_create(
+        device_state->device, iree_string_view_empty(),
+        &device_state->executable_cache));
+    device_state->submit_value = 0ull;
+    IREE_RETURN_IF_ERROR(iree_hal_semaphore_create(
+        device_state->device, device_state->submit_value,
+        &device_state->submit_semaphore));
+  }
 
   *out_module_state = (iree_vm_module_state_t*)state;
   return iree_ok_status();
@@ -171,13 +311,38 @@ iree_hal_module_alloc_state(void* self, iree_allocator_t host_allocator,
 static void IREE_API_PTR
 iree_hal_module_free_state(void* self, iree_vm_module_state_t* module_state) {
   iree_hal_module_state_t* state = (iree_hal_module_state_t*)module_state;
-  iree_hal_semaphore_release(state->submit_semaphore);
   iree_vm_list_release(state->deferred_releases);
-  iree_hal_executable_cache_release(state->executable_cache);
-  iree_hal_device_release(state->shared_device);
+  iree_hal_buffer_view_pool_release(state->buffer_view_pool);
+  iree_allocator_free(state->host_allocator, state->trace_summaries);
+  iree_slim_mutex_deinitialize(&state->trace_summary_mutex);
+  for (iree_host_size_t i = 0; i < state->device_count; ++i) {
+    iree_hal_module_device_state_t* device_state = &state->devices[i];
+    iree_hal_semaphore_release(device_state->submit_semaphore);
+    iree_hal_executable_cache_release(device_state->executable_cache);
+    iree_hal_device_release(device_state->device);
+  }
+  iree_hal_module_state_end_transients(state);
+  iree_hal_module_transient_pool_release(state->transient_pool);
   iree_allocator_free(state->host_allocator, state);
 }
 
+// Returns the state of |device| in |out_device_state|. Fails if the device is
+// not one of the devices the module was created with.
+static iree_status_t iree_hal_module_state_lookup_device(
+    iree_hal_module_state_t* state, iree_hal_device_t* device,
+    iree_hal_module_device_state_t** out_device_state) {
+  for (iree_host_size_t i = 0; i < state->device_count; ++i) {
+    if (state->devices[i].device == device) {
+      *out_device_state = &state->devices[i];
+      return iree_ok_status();
+    }
+  }
+  return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                          "device is not one of the %zu devices the HAL "
+                          "module was created with",
+                          state->device_count);
+}
+
 //===----------------------------------------------------------------------===//
 // Experimental APIs
 //===----------------------------------------------------------------------===//
@@ -187,10 +352,38 @@ iree_hal_module_free_state(void* self, iree_vm_module_state_t* module_state) {
 IREE_VM_ABI_EXPORT(iree_hal_module_ex_shared_device,  //
                    iree_hal_module_state_t,           //
                    v, r) {
-  rets->r0 = iree_hal_device_retain_ref(state->shared_device);
+  rets->r0 = iree_hal_device_retain_ref(state->devices[0].device);
+  return iree_ok_status();
+}
+
+IREE_VM_ABI_EXPORT(iree_hal_module_ex_device,  //
+                   iree_hal_module_state_t,    //
+                   i, r) {
+  iree_host_size_t ordinal = (iree_host_size_t)args->i0;
+  if (ordinal >= state->device_count) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "device ordinal %zu out of range; the HAL module "
+                            "was created with %zu devices",
+                            ordinal, state->device_count);
+  }
+  rets->r0 = iree_hal_device_retain_ref(state->devices[ordinal].device);
   return iree_ok_status();
 }
 
+IREE_VM_ABI_EXPORT(iree_hal_module_ex_buffer_copy,  //
+                   iree_hal_module_state_t,         //
+                   ririi, v) {
+  iree_hal_buffer_t* source_buffer = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_check_deref(args->r0, &source_buffer));
+  iree_vm_size_t source_offset = (iree_vm_size_t)args->i1;
+  iree_hal_buffer_t* target_buffer = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_check_deref(args->r2, &target_buffer));
+  iree_vm_size_t target_offset = (iree_vm_size_t)args->i3;
+  iree_vm_size_t length = (iree_vm_size_t)args->i4;
+  return iree_hal_buffer_copy_data(source_buffer, source_offset, target_buffer,
+                                   target_offset, length);
+}
+
 void iree_hal_module_ex_defer_release(iree_hal_module_state_t* state,
                                       const iree_vm_ref_t value) {
   // A bulk of the calls to this are for the same (or very recently same)
@@ -215,50 +408,208 @@ void iree_hal_module_ex_defer_release(iree_hal_module_state_t* state,
       iree_vm_list_push_ref_retain(state->deferred_releases, &value));
 }
 
-IREE_VM_ABI_EXPORT(iree_hal_module_ex_submit_and_wait,  //
-                   iree_hal_module_state_t,             //
-                   rr, v) {
-  iree_hal_device_t* device = NULL;
-  IREE_RETURN_IF_ERROR(iree_hal_device_check_deref(args->r0, &device));
-  iree_hal_command_buffer_t* command_buffer = NULL;
+// Drops all pending deferred releases (references to everything in flight) if
+// all work submitted on the timelines of all devices has completed.
+// This will be replaced with resource sets in the future that are attached to
+// each command buffer.
+static iree_status_t iree_hal_module_ex_flush_deferred_releases(
+    iree_hal_module_state_t* state) {
+  for (iree_host_size_t i = 0; i < state->device_count; ++i) {
+    iree_hal_module_device_state_t* device_state = &state->devices[i];
+    uint64_t current_value = 0ull;
+    IREE_RETURN_IF_ERROR(iree_hal_semaphore_query(
+        device_state->submit_semaphore, &current_value));
+    if (current_value < device_state->submit_value) return iree_ok_status();
+  }
+  IREE_RETURN_IF_ERROR(iree_vm_list_resize(state->deferred_releases, 0));
+  memset(state->deferred_lru, 0, sizeof(state->deferred_lru));
+  return iree_ok_status();
+}
+
+// Submits |command_buffer| on the timeline of |device| once all of the
+// |wait_semaphores| have been reached and additionally signals
+// |signal_semaphore| to |signal_value| (if provided) once it has completed.
+// Each submission waits on the prior one to the same device such that reaching
+// a value on the device timeline implies all prior submissions to the device
+// have completed.
+static iree_status_t iree_hal_module_ex_submit_on_timeline(
+    iree_hal_module_state_t* state, iree_hal_device_t* device,
+    iree_hal_command_buffer_t* command_buffer,
+    const iree_hal_semaphore_list_t* wait_semaphores,
+    iree_hal_semaphore_t* signal_semaphore, uint64_t signal_value,
+    bool wait_for_completion) {
+  iree_hal_module_device_state_t* device_state = NULL;
   IREE_RETURN_IF_ERROR(
-      iree_hal_command_buffer_check_deref(args->r1, &command_buffer));
+      iree_hal_module_state_lookup_device(state, device, &device_state));
 
   // Batch with our single command buffer.
   iree_hal_submission_batch_t batch;
   memset(&batch, 0, sizeof(batch));
 
+  // The device timeline is waited on first followed by the caller waits.
+  uint64_t prior_semaphore_value = device_state->submit_value;
+  iree_host_size_t wait_count =
+      1 + (wait_semaphores ? wait_semaphores->count : 0);
+  iree_hal_semaphore_t** wait_semaphore_ptrs =
+      (iree_hal_semaphore_t**)iree_alloca(wait_count *
+                                          sizeof(iree_hal_semaphore_t*));
+  uint64_t* wait_semaphore_values =
+      (uint64_t*)iree_alloca(wait_count * sizeof(uint64_t));
+  wait_semaphore_ptrs[0] = device_state->submit_semaphore;
+  wait_semaphore_values[0] = prior_semaphore_value;
+  for (iree_host_size_t i = 1; i < wait_count; ++i) {
+    wait_semaphore_ptrs[i] = wait_semaphores->semaphores[i - 1];
+    wait_semaphore_values[i] = wait_semaphores->payload_values[i - 1];
+  }
+  batch.wait_semaphores.count = wait_count;
+  batch.wait_semaphores.semaphores = wait_semaphore_ptrs;
+  batch.wait_semaphores.payload_values = wait_semaphore_values;
+
   iree_hal_command_buffer_t* command_buffer_ptrs[] = {command_buffer};
   batch.command_buffer_count = IREE_ARRAYSIZE(command_buffer_ptrs);
   batch.command_buffers = command_buffer_ptrs;
 
-  uint64_t next_semaphore_value = ++state->submit_value;
-  iree_hal_semaphore_t* signal_semaphore_ptrs[] = {state->submit_semaphore};
-  uint64_t signal_semaphore_values[] = {next_semaphore_value};
-  batch.signal_semaphores.count = IREE_ARRAYSIZE(signal_semaphore_ptrs);
+  uint64_t next_semaphore_value = prior_semaphore_value + 1;
+  iree_hal_semaphore_t* signal_semaphore_ptrs[] = {
+      device_state->submit_semaphore, signal_semaphore};
+  uint64_t signal_semaphore_values[] = {next_semaphore_value, signal_value};
+  batch.signal_semaphores.count = signal_semaphore ? 2 : 1;
   batch.signal_semaphores.semaphores = signal_semaphore_ptrs;
   batch.signal_semaphores.payload_values = signal_semaphore_values;
 
-  iree_status_t status = iree_hal_device_submit_and_wait(
-      device, IREE_HAL_COMMAND_CATEGORY_ANY, 0, 1, &batch,
-      state->submit_semaphore, next_semaphore_value, iree_infinite_timeout());
-  if (!iree_status_is_ok(status)) {
-    return status;
+  iree_status_t status = iree_ok_status();
+  if (wait_for_completion) {
+    status = iree_hal_device_submit_and_wait(
+        device, IREE_HAL_COMMAND_CATEGORY_ANY, 0, 1, &batch,
+        device_state->submit_semaphore, next_semaphore_value,
+        iree_infinite_timeout());
+  } else {
+    status = iree_hal_device_queue_submit(
+        device, IREE_HAL_COMMAND_CATEGORY_ANY, 0, 1, &batch);
   }
+  if (iree_status_is_ok(status)) {
+    device_state->submit_value = next_semaphore_value;
+  }
+  return status;
+}
 
-  // Drop all pending deferred releases (references to everything in flight).
-  // This will be replaced with resource sets in the future that are attached to
-  // each command buffer.
-  IREE_RETURN_IF_ERROR(iree_vm_list_resize(state->deferred_releases, 0));
-  memset(state->deferred_lru, 0, sizeof(state->deferred_lru));
+IREE_VM_ABI_EXPORT(iree_hal_module_ex_submit,  //
+                   iree_hal_module_state_t,    //
+                   rrri, v) {
+  iree_hal_device_t* device = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_device_check_deref(args->r0, &device));
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_hal_command_buffer_check_deref(args->r1, &command_buffer));
+  iree_hal_semaphore_t* signal_semaphore = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_hal_semaphore_check_deref(args->r2, &signal_semaphore));
+  uint64_t signal_value = (uint32_t)args->i3;
+
+  // Deferred releases are retained until a later wait observes that all work
+  // on the module timeline has completed.
+  return iree_hal_module_ex_submit_on_timeline(
+      state, device, command_buffer, /*wait_semaphores=*/NULL,
+      signal_semaphore, signal_value, /*wait_for_completion=*/false);
+}
 
-  return iree_ok_status();
+IREE_VM_ABI_EXPORT(iree_hal_module_ex_submit_and_wait,  //
+                   iree_hal_module_state_t,             //
+                   rr, v) {
+  iree_hal_device_t* device = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_device_check_deref(args->r0, &device));
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_hal_command_buffer_check_deref(args->r1, &command_buffer));
+
+  IREE_RETURN_IF_ERROR(iree_hal_module_ex_submit_on_timeline(
+      state, device, command_buffer, /*wait_semaphores=*/NULL,
+      /*signal_semaphore=*/NULL, /*signal_value=*/0ull,
+      /*wait_for_completion=*/true));
+
+  // As each submission waits on the prior one everything in flight has now
+  // completed.
+  return iree_hal_module_ex_flush_deferred_releases(state);
 }
 
 //===----------------------------------------------------------------------===//
 // iree_hal_allocator_t
 //===----------------------------------------------------------------------===//
 
+// Allocator control function used as the data allocator of transient buffers.
+// The storage itself is owned by the arena and each buffer holds a reference
+// to it.
+static iree_status_t IREE_API_PTR iree_hal_module_transient_allocator_ctl(
+    void* self, iree_allocator_command_t command, const void* params,
+    void** inout_ptr) {
+  iree_hal_module_transient_arena_t* transient_arena =
+      (iree_hal_module_transient_arena_t*)self;
+  switch (command) {
+    case IREE_ALLOCATOR_COMMAND_FREE:
+      iree_hal_module_transient_arena_release(transient_arena);
+      return iree_ok_status();
+    default:
+      return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                              "transient buffer storage is arena-owned");
+  }
+}
+
+// Returns the transient arena of the current invocation, beginning one if
+// this is the first transient allocation made by the invocation.
+static iree_status_t iree_hal_module_state_begin_transients(
+    iree_hal_module_state_t* state,
+    iree_hal_module_transient_arena_t** out_transient_arena) {
+  if (!state->transient_arena) {
+    iree_arena_allocator_t arena;
+    iree_arena_initialize(&state->transient_pool->block_pool, &arena);
+    iree_hal_module_transient_arena_t* transient_arena = NULL;
+    iree_status_t status = iree_arena_allocate(
+        &arena, sizeof(*transient_arena), (void**)&transient_arena);
+    if (!iree_status_is_ok(status)) {
+      iree_arena_deinitialize(&arena);
+      return status;
+    }
+    iree_atomic_ref_count_init(&transient_arena->ref_count);
+    transient_arena->pool = state->transient_pool;
+    iree_atomic_ref_count_inc(&state->transient_pool->ref_count);
+    transient_arena->arena = arena;
+    state->transient_arena = transient_arena;
+  }
+  *out_transient_arena = state->transient_arena;
+  return iree_ok_status();
+}
+
+// Allocates a buffer with storage from the invocation-scoped transient arena.
+static iree_status_t iree_hal_module_allocate_transient_buffer(
+    iree_hal_module_state_t* state, iree_hal_allocator_t* allocator,
+    iree_hal_memory_type_t memory_types, iree_hal_buffer_usage_t buffer_usage,
+    iree_host_size_t allocation_size, iree_hal_buffer_t** out_buffer) {
+  iree_hal_module_transient_arena_t* transient_arena = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_hal_module_state_begin_transients(state, &transient_arena));
+
+  void* storage = NULL;
+  IREE_RETURN_IF_ERROR(iree_arena_allocate(
+      &transient_arena->arena,
+      allocation_size + IREE_HAL_MODULE_TRANSIENT_ALIGNMENT, &storage));
+  iree_byte_span_t data = iree_make_byte_span(
+      (uint8_t*)iree_host_align((uintptr_t)storage,
+                                IREE_HAL_MODULE_TRANSIENT_ALIGNMENT),
+      allocation_size);
+  iree_allocator_t data_allocator = {
+      .self = transient_arena,
+      .ctl = iree_hal_module_transient_allocator_ctl,
+  };
+  iree_atomic_ref_count_inc(&transient_arena->ref_count);
+  iree_status_t status = iree_hal_allocator_wrap_buffer(
+      allocator, memory_types, IREE_HAL_MEMORY_ACCESS_ALL, buffer_usage, data,
+      data_allocator, out_buffer);
+  if (!iree_status_is_ok(status)) {
+    iree_hal_module_transient_arena_release(transient_arena);
+  }
+  return status;
+}
+
 IREE_VM_ABI_EXPORT(iree_hal_module_allocator_allocate,  //
                    iree_hal_module_state_t,             //
                    riii, r) {
@@ -269,12 +620,63 @@ IREE_VM_ABI_EXPORT(iree_hal_module_allocator_allocate,  //
   iree_vm_size_t allocation_size = (iree_vm_size_t)args->i3;
 
   iree_hal_buffer_t* buffer = NULL;
-  IREE_RETURN_IF_ERROR(iree_hal_allocator_allocate_buffer(
-      allocator, memory_types, buffer_usage, allocation_size, &buffer));
+  if (iree_all_bits_set(memory_types, IREE_HAL_MEMORY_TYPE_TRANSIENT) &&
+      iree_hal_allocator_is_heap(allocator)) {
+    // Transient buffers from host memory allocators are bump-allocated from
+    // the arena and reclaimed in bulk when the invocation ends. Other
+    // allocators receive the hint and may handle it however they like.
+    IREE_RETURN_IF_ERROR(iree_hal_module_allocate_transient_buffer(
+        state, allocator, memory_types, buffer_usage, allocation_size,
+        &buffer));
+  } else {
+    IREE_RETURN_IF_ERROR(iree_hal_allocator_allocate_buffer(
+        allocator, memory_types, buffer_usage, allocation_size, &buffer));
+  }
   rets->r0 = iree_hal_buffer_move_ref(buffer);
   return iree_ok_status();
 }
 
+// Allocator control function used as the data allocator of buffers wrapping a
+// byte buffer in-place. The wrapped byte buffer is retained until the HAL
+// buffer is destroyed.
+static iree_status_t IREE_API_PTR iree_hal_module_byte_buffer_allocator_ctl(
+    void* self, iree_allocator_command_t command, const void* params,
+    void** inout_ptr) {
+  iree_vm_buffer_t* source = (iree_vm_buffer_t*)self;
+  switch (command) {
+    case IREE_ALLOCATOR_COMMAND_FREE:
+      iree_vm_buffer_release(source);
+      return iree_ok_status();
+    default:
+      return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                              "wrapped byte buffer storage is not owned");
+  }
+}
+
+// Returns true if |length| bytes at |offset| of |source| can be wrapped by
+// |allocator| without copying.
+static bool iree_hal_module_can_wrap_byte_buffer(
+    iree_hal_allocator_t* allocator, iree_hal_memory_type_t memory_types,
+    iree_hal_buffer_usage_t buffer_usage, const iree_vm_buffer_t* source,
+    iree_vm_size_t offset, iree_vm_size_t length) {
+  // Only immutable contents can be shared; a mutable source may change after
+  // the HAL buffer has been created.
+  if (iree_all_bits_set(source->access, IREE_VM_BUFFER_ACCESS_MUTABLE)) {
+    return false;
+  }
+  // Keep the natural alignment expected of buffer contents.
+  uintptr_t data_ptr = (uintptr_t)(source->data.data + offset);
+  if (iree_host_align(data_ptr, iree_max_align_t) != data_ptr) {
+    return false;
+  }
+  iree_hal_buffer_compatibility_t compatibility =
+      iree_hal_allocator_query_buffer_compatibility(
+          allocator, memory_types, buffer_usage, buffer_usage,
+          (iree_device_size_t)length);
+  return iree_all_bits_set(compatibility,
+                           IREE_HAL_BUFFER_COMPATIBILITY_IMPORTABLE);
+}
+
 IREE_VM_ABI_EXPORT(iree_hal_module_allocator_wrap_byte_buffer,  //
                    iree_hal_module_state_t,                     //
                    riirii, r) {
@@ -287,8 +689,6 @@ IREE_VM_ABI_EXPORT(iree_hal_module_allocator_wrap_byte_buffer,  //
   iree_vm_size_t offset = (iree_vm_size_t)args->i4;
   iree_vm_size_t length = (iree_vm_size_t)args->i5;
 
-  // TODO(benvanik): wrap when supported.
-
   iree_host_size_t buffer_length = source->data.data_length;
   if (length == -1) {
     length = buffer_length;
@@ -301,7 +701,31 @@ IREE_VM_ABI_EXPORT(iree_hal_module_allocator_wrap_byte_buffer,  //
         (offset + length - 1), buffer_length);
   }
 
+  // Immutable buffers (such as module rodata) can be used in-place when the
+  // device is able to access host memory directly. This avoids a copy of the
+  // contents and lets large constants stay in the (possibly mapped) module.
   iree_hal_buffer_t* buffer = NULL;
+  if (iree_hal_module_can_wrap_byte_buffer(allocator, memory_types,
+                                           buffer_usage, source, offset,
+                                           length)) {
+    iree_vm_buffer_retain(source);
+    iree_allocator_t data_allocator = {
+        .self = source,
+        .ctl = iree_hal_module_byte_buffer_allocator_ctl,
+    };
+    iree_status_t status = iree_hal_allocator_wrap_buffer(
+        allocator, memory_types, IREE_HAL_MEMORY_ACCESS_READ, buffer_usage,
+        iree_make_byte_span(source->data.data + offset, length),
+        data_allocator, &buffer);
+    if (iree_status_is_ok(status)) {
+      rets->r0 = iree_hal_buffer_move_ref(buffer);
+      return status;
+    }
+    // Fall back to copying below.
+    iree_vm_buffer_release(source);
+    iree_status_ignore(status);
+  }
+
   IREE_RETURN_IF_ERROR(
       iree_hal_allocator_allocate_buffer(allocator, memory_types, buffer_usage,
                                          length, &buffer),
@@ -411,9 +835,9 @@ IREE_VM_ABI_EXPORT(iree_hal_module_buffer_view_create,  //
                              &shape_rank, &shape_dims);
 
   iree_hal_buffer_view_t* buffer_view = NULL;
-  IREE_RETURN_IF_ERROR(
-      iree_hal_buffer_view_create(source_buffer, shape_dims, shape_rank,
-                                  element_type, encoding_type, &buffer_view));
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_view_create_pooled(
+      state->buffer_view_pool, source_buffer, shape_dims, shape_rank,
+      element_type, encoding_type, &buffer_view));
   rets->r0 = iree_hal_buffer_view_move_ref(buffer_view);
   return iree_ok_status();
 }
@@ -526,6 +950,65 @@ IREE_VM_ABI_EXPORT(iree_hal_module_buffer_view_trace,  //
   return iree_ok_status();
 }
 
+IREE_VM_ABI_EXPORT(iree_hal_module_buffer_view_summarize,  //
+                   iree_hal_module_state_t,                //
+                   rCrD, v) {
+  iree_vm_buffer_t* key = NULL;
+  IREE_RETURN_IF_ERROR(iree_vm_buffer_check_deref(args->r0, &key));
+  iree_string_view_t key_str = iree_vm_buffer_as_string(key);
+
+  // Compute all summaries before taking the lock so that draining is never
+  // blocked on reading buffer contents.
+  iree_hal_module_trace_summary_t summaries[8];
+  for (iree_host_size_t base = 0; base < args->a1_count;
+       base += IREE_ARRAYSIZE(summaries)) {
+    iree_host_size_t count =
+        iree_min(IREE_ARRAYSIZE(summaries), args->a1_count - base);
+    for (iree_host_size_t i = 0; i < count; ++i) {
+      iree_hal_buffer_view_t* buffer_view = NULL;
+      IREE_RETURN_IF_ERROR(iree_hal_buffer_view_check_deref(
+          args->a1[base + i].r0, &buffer_view));
+      iree_hal_module_trace_summary_t* summary = &summaries[i];
+      summary->timestamp_ns = iree_time_now();
+      iree_host_size_t key_length =
+          iree_min(key_str.size, IREE_HAL_MODULE_TRACE_SUMMARY_MAX_KEY_LENGTH);
+      memcpy(summary->key, key_str.data, key_length);
+      summary->key[key_length] = 0;
+      summary->operand_index = base + i;
+      IREE_RETURN_IF_ERROR(
+          iree_hal_buffer_view_summarize(buffer_view, &summary->summary));
+      // Mark the summary in the flight recorder timeline next to the
+      // dispatches that produced it; the argument is the NaN count.
+      IREE_FLIGHT_RECORD_INSTANT(IREE_FLIGHT_RECORDER_TRACK_HAL,
+                                 "buffer_view_summary",
+                                 (int64_t)summary->summary.nan_count);
+    }
+
+    iree_slim_mutex_lock(&state->trace_summary_mutex);
+    iree_status_t status = iree_ok_status();
+    if (!state->trace_summaries) {
+      status = iree_allocator_malloc(
+          state->host_allocator,
+          IREE_HAL_MODULE_TRACE_SUMMARY_CAPACITY *
+              sizeof(*state->trace_summaries),
+          (void**)&state->trace_summaries);
+    }
+    if (iree_status_is_ok(status)) {
+      for (iree_host_size_t i = 0; i < count; ++i) {
+        state->trace_summaries[state->trace_summary_head++ %
+                               IREE_HAL_MODULE_TRACE_SUMMARY_CAPACITY] =
+            summaries[i];
+      }
+      state->trace_summary_count =
+          iree_min(state->trace_summary_count + count,
+                   IREE_HAL_MODULE_TRACE_SUMMARY_CAPACITY);
+    }
+    iree_slim_mutex_unlock(&state->trace_summary_mutex);
+    IREE_RETURN_IF_ERROR(status);
+  }
+  return iree_ok_status();
+}
+
 //===----------------------------------------------------------------------===//
 // iree_hal_command_buffer_t
 //===----------------------------------------------------------------------===//
@@ -780,6 +1263,54 @@ IREE_VM_ABI_EXPORT(iree_hal_module_command_buffer_dispatch_indirect,  //
       workgroups_offset);
 }
 
+IREE_VM_ABI_EXPORT(iree_hal_module_command_buffer_dispatch_push,  //
+                   iree_hal_module_state_t,                       //
+                   rrriiiiiiCiDCiriiD, v) {
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_hal_command_buffer_check_deref(args->r0, &command_buffer));
+  iree_hal_executable_layout_t* executable_layout = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_hal_executable_layout_check_deref(args->r1, &executable_layout));
+  iree_hal_executable_t* executable = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_executable_check_deref(args->r2, &executable));
+  uint32_t entry_point = (uint32_t)args->i3;
+  uint32_t workgroup_x = (uint32_t)args->i4;
+  uint32_t workgroup_y = (uint32_t)args->i5;
+  uint32_t workgroup_z = (uint32_t)args->i6;
+  uint32_t set = (uint32_t)args->i7;
+  iree_vm_size_t constant_offset = (iree_vm_size_t)args->i8;
+  iree_host_size_t constant_count = args->a9_count;
+  const uint32_t* constants = (const uint32_t*)&args->a9[0].i0;
+
+  iree_vm_abi_CiriiD_t* binding_args = iree_vm_abi_rrriiiiiiCiDCiriiD_a10(args);
+  iree_host_size_t binding_count = binding_args->count;
+  if (IREE_UNLIKELY(binding_count >
+                    IREE_HAL_MODULE_MAX_DESCRIPTOR_BINDING_COUNT)) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE, "binding count %zu > %zu",
+                            binding_count,
+                            IREE_HAL_MODULE_MAX_DESCRIPTOR_BINDING_COUNT);
+  }
+  iree_hal_descriptor_set_binding_t* bindings =
+      (iree_hal_descriptor_set_binding_t*)iree_alloca(
+          binding_count * sizeof(iree_hal_descriptor_set_binding_t));
+  for (iree_host_size_t i = 0; i < binding_count; ++i) {
+    IREE_RETURN_IF_ERROR(iree_hal_buffer_check_deref(
+        binding_args->values[i].r1, &bindings[i].buffer));
+    bindings[i].binding = (uint32_t)binding_args->values[i].i0;
+    bindings[i].offset = (iree_device_size_t)binding_args->values[i].i2;
+    bindings[i].length = (iree_device_size_t)binding_args->values[i].i3;
+    iree_hal_module_ex_defer_release(state, binding_args->values[i].r1);
+  }
+
+  iree_hal_module_ex_defer_release(state, args->r2);
+
+  return iree_hal_command_buffer_dispatch_push(
+      command_buffer, executable_layout, executable, entry_point, workgroup_x,
+      workgroup_y, workgroup_z, constant_offset, constant_count, constants, set,
+      binding_count, bindings);
+}
+
 //===----------------------------------------------------------------------===//
 // iree_hal_descriptor_set_t
 //===----------------------------------------------------------------------===//
@@ -886,6 +1417,44 @@ IREE_VM_ABI_EXPORT(iree_hal_module_device_query_i32,  //
   return iree_ok_status();
 }
 
+IREE_VM_ABI_EXPORT(iree_hal_module_device_queue_submit,  //
+                   iree_hal_module_state_t,               //
+                   rrriCriD, v) {
+  iree_hal_device_t* device = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_device_check_deref(args->r0, &device));
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_hal_command_buffer_check_deref(args->r1, &command_buffer));
+  iree_hal_semaphore_t* signal_semaphore = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_hal_semaphore_check_deref(args->r2, &signal_semaphore));
+  uint64_t signal_value = (uint32_t)args->i3;
+
+  iree_host_size_t wait_count = args->a4_count;
+  if (IREE_UNLIKELY(wait_count > IREE_HAL_MODULE_MAX_WAIT_SEMAPHORE_COUNT)) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "wait semaphore count %zu > %zu", wait_count,
+                            IREE_HAL_MODULE_MAX_WAIT_SEMAPHORE_COUNT);
+  }
+  iree_hal_semaphore_list_t wait_semaphores;
+  wait_semaphores.count = wait_count;
+  wait_semaphores.semaphores = (iree_hal_semaphore_t**)iree_alloca(
+      wait_count * sizeof(iree_hal_semaphore_t*));
+  wait_semaphores.payload_values =
+      (uint64_t*)iree_alloca(wait_count * sizeof(uint64_t));
+  for (iree_host_size_t i = 0; i < wait_count; ++i) {
+    IREE_RETURN_IF_ERROR(iree_hal_semaphore_check_deref(
+        args->a4[i].r0, &wait_semaphores.semaphores[i]));
+    wait_semaphores.payload_values[i] = (uint32_t)args->a4[i].i1;
+  }
+
+  // The submission only waits on the device; the host blocks solely where the
+  // compiler awaits |signal_semaphore| before observing the results.
+  return iree_hal_module_ex_submit_on_timeline(
+      state, device, command_buffer, &wait_semaphores, signal_semaphore,
+      signal_value, /*wait_for_completion=*/false);
+}
+
 //===--------------------------------------------------------------------===//
 // iree_hal_executable_t
 //===--------------------------------------------------------------------===//
@@ -895,6 +1464,9 @@ IREE_VM_ABI_EXPORT(iree_hal_module_executable_create,  //
                    rrrCrD, r) {
   iree_hal_device_t* device = NULL;
   IREE_RETURN_IF_ERROR(iree_hal_device_check_deref(args->r0, &device));
+  iree_hal_module_device_state_t* device_state = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_hal_module_state_lookup_device(state, device, &device_state));
   iree_vm_buffer_t* executable_format = NULL;
   IREE_RETURN_IF_ERROR(
       iree_vm_buffer_check_deref(args->r1, &executable_format));
@@ -929,7 +1501,7 @@ IREE_VM_ABI_EXPORT(iree_hal_module_executable_create,  //
     spec.executable_layout_count = executable_layout_count;
     spec.executable_layouts = executable_layouts;
     status = iree_hal_executable_cache_prepare_executable(
-        state->executable_cache, &spec, &executable);
+        device_state->executable_cache, &spec, &executable);
   }
 
   iree_allocator_free(state->host_allocator, executable_layouts);
@@ -1014,6 +1586,15 @@ IREE_VM_ABI_EXPORT(iree_hal_module_semaphore_fail,  //
   return iree_ok_status();
 }
 
+// Waits on the semaphore in |ref| to reach |payload| as an iree_vm_wait_fn_t.
+static iree_status_t IREE_API_PTR iree_hal_module_semaphore_wait_fn(
+    iree_vm_ref_t* ref, uint64_t payload, iree_time_t deadline_ns) {
+  iree_hal_semaphore_t* semaphore = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_semaphore_check_deref(*ref, &semaphore));
+  return iree_hal_semaphore_wait(semaphore, payload,
+                                 iree_make_deadline(deadline_ns));
+}
+
 IREE_VM_ABI_EXPORT(iree_hal_module_semaphore_await,  //
                    iree_hal_module_state_t,          //
                    ri, i) {
@@ -1021,11 +1602,28 @@ IREE_VM_ABI_EXPORT(iree_hal_module_semaphore_await,  //
   IREE_RETURN_IF_ERROR(iree_hal_semaphore_check_deref(args->r0, &semaphore));
   uint64_t new_value = (uint32_t)args->i1;
 
-  // TODO(benvanik): coroutine magic.
-  iree_status_t status =
-      iree_hal_semaphore_wait(semaphore, new_value, iree_infinite_timeout());
+  // On resumable stacks we poll and, if the semaphore has not yet reached the
+  // value, defer the wait to the host instead of blocking the thread. The
+  // await will be re-issued once the wait has been satisfied.
+  iree_timeout_t timeout = iree_infinite_timeout();
+  if (iree_vm_stack_is_resumable(stack)) timeout = iree_immediate_timeout();
+  iree_status_t status = iree_hal_semaphore_wait(semaphore, new_value, timeout);
+  if (iree_vm_stack_is_resumable(stack) &&
+      iree_status_is_deadline_exceeded(status)) {
+    iree_status_ignore(status);
+    iree_vm_wait_t wait = {
+        .wait_fn = iree_hal_module_semaphore_wait_fn,
+        .ref = iree_hal_semaphore_retain_ref(semaphore),
+        .payload = new_value,
+    };
+    iree_vm_stack_defer_wait(stack, &wait);
+    return iree_ok_status();
+  }
   if (iree_status_is_ok(status)) {
     rets->i0 = 0;
+    // The wait may have been on work submitted with hal.ex.submit; release
+    // the resources it retained if the module timeline has caught up.
+    status = iree_hal_module_ex_flush_deferred_releases(state);
   } else if (iree_status_is_deadline_exceeded(status)) {
     // Propagate deadline exceeded back to the VM.
     rets->i0 = (int32_t)iree_status_consume_code(status);
@@ -1033,6 +1631,22 @@ IREE_VM_ABI_EXPORT(iree_hal_module_semaphore_await,  //
   return status;
 }
 
+static iree_status_t IREE_API_PTR
+iree_hal_module_notify(void* self, iree_vm_module_state_t* module_state,
+                       iree_vm_signal_t signal) {
+  iree_hal_module_state_t* state = (iree_hal_module_state_t*)module_state;
+  switch (signal) {
+    case IREE_VM_SIGNAL_INVOCATION_END:
+      // Release the resources retained by completed work as well so that the
+      // transient arenas they keep alive are reclaimed even if the program
+      // never waits.
+      iree_hal_module_state_end_transients(state);
+      return iree_hal_module_ex_flush_deferred_releases(state);
+    default:
+      return iree_ok_status();
+  }
+}
+
 //===----------------------------------------------------------------------===//
 // VM module interface implementation
 //===----------------------------------------------------------------------===//
@@ -1080,12 +1694,17 @@ static const iree_vm_native_module_descriptor_t iree_hal_module_descriptor_ = {
     .reflection_attrs = NULL,
 };
 
-IREE_API_EXPORT iree_status_t
-iree_hal_module_create(iree_hal_device_t* device, iree_allocator_t allocator,
-                       iree_vm_module_t** out_module) {
-  IREE_ASSERT_ARGUMENT(device);
+IREE_API_EXPORT iree_status_t iree_hal_module_create_with_devices(
+    iree_host_size_t device_count, iree_hal_device_t** devices,
+    iree_allocator_t allocator, iree_vm_module_t** out_module) {
+  IREE_ASSERT_ARGUMENT(!device_count || devices);
   IREE_ASSERT_ARGUMENT(out_module);
   *out_module = NULL;
+  if (device_count == 0 || device_count > IREE_HAL_MODULE_MAX_DEVICE_COUNT) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "HAL modules require 1 to %zu devices; %zu given",
+                            IREE_HAL_MODULE_MAX_DEVICE_COUNT, device_count);
+  }
 
   // Setup the interface with the functions we implement ourselves. Any function
   // we omit will be handled by the base native module.
@@ -1093,6 +1712,7 @@ iree_hal_module_create(iree_hal_device_t* device, iree_allocator_t allocator,
       .destroy = iree_hal_module_destroy,
       .alloc_state = iree_hal_module_alloc_state,
       .free_state = iree_hal_module_free_state,
+      .notify = iree_hal_module_notify,
   };
 
   // Allocate shared module state.
@@ -1111,17 +1731,49 @@ iree_hal_module_create(iree_hal_device_t* device, iree_allocator_t allocator,
 
   iree_hal_module_t* module = IREE_HAL_MODULE_CAST(base_module);
   module->host_allocator = allocator;
-  module->shared_device = device;
-  iree_hal_device_retain(module->shared_device);
+  module->device_count = device_count;
+  for (iree_host_size_t i = 0; i < device_count; ++i) {
+    module->devices[i] = devices[i];
+    iree_hal_device_retain(module->devices[i]);
+  }
 
   *out_module = base_module;
   return iree_ok_status();
 }
 
+IREE_API_EXPORT iree_status_t
+iree_hal_module_create(iree_hal_device_t* device, iree_allocator_t allocator,
+                       iree_vm_module_t** out_module) {
+  IREE_ASSERT_ARGUMENT(device);
+  return iree_hal_module_create_with_devices(1, &device, allocator,
+                                             out_module);
+}
+
 IREE_API_EXPORT iree_hal_device_t* iree_hal_module_state_device(
     iree_vm_module_state_t* module_state) {
   iree_hal_module_state_t* state = (iree_hal_module_state_t*)module_state;
-  return state->shared_device;
+  return state->devices[0].device;
+}
+
+IREE_API_EXPORT void iree_hal_module_state_drain_trace_summaries(
+    iree_vm_module_state_t* module_state, iree_host_size_t capacity,
+    iree_hal_module_trace_summary_t* out_summaries,
+    iree_host_size_t* out_count) {
+  IREE_ASSERT_ARGUMENT(module_state);
+  IREE_ASSERT_ARGUMENT(!capacity || out_summaries);
+  IREE_ASSERT_ARGUMENT(out_count);
+  iree_hal_module_state_t* state = (iree_hal_module_state_t*)module_state;
+  iree_slim_mutex_lock(&state->trace_summary_mutex);
+  iree_host_size_t count = iree_min(capacity, state->trace_summary_count);
+  uint64_t tail = state->trace_summary_head - state->trace_summary_count;
+  for (iree_host_size_t i = 0; i < count; ++i) {
+    out_summaries[i] =
+        state->trace_summaries[(tail + i) %
+                               IREE_HAL_MODULE_TRACE_SUMMARY_CAPACITY];
+  }
+  state->trace_summary_count -= count;
+  iree_slim_mutex_unlock(&state->trace_summary_mutex);
+  *out_count = count;
 }
 
 //===--------------------------------------------------------------------===//
@@ -46,11 +46,45 @@ IREE_API_EXPORT iree_status_t
 iree_hal_module_create(iree_hal_device_t* device, iree_allocator_t allocator,
                        iree_vm_module_t** out_module);
 
-// Returns the device currently in use by the HAL module.
+// Creates the HAL module initialized to use the given |devices|.
+// The first device is the shared device returned by hal.ex.shared_device and
+// the others are available to programs partitioned across multiple devices by
+// ordinal (hal.ex.device). Each device has its own submission timeline and
+// executable cache. 1 to 8 devices are supported.
+IREE_API_EXPORT iree_status_t iree_hal_module_create_with_devices(
+    iree_host_size_t device_count, iree_hal_device_t** devices,
+    iree_allocator_t allocator, iree_vm_module_t** out_module);
+
+// Returns the shared device (the first device) in use by the HAL module.
 // Returns NULL if no device has been initialized yet.
 IREE_API_EXPORT iree_hal_device_t* iree_hal_module_state_device(
     iree_vm_module_state_t* module_state);
 
+// Maximum length of the key recorded with each trace summary.
+#define IREE_HAL_MODULE_TRACE_SUMMARY_MAX_KEY_LENGTH 63
+
+// Statistics recorded by `hal.buffer_view.summarize` for one buffer view.
+typedef struct iree_hal_module_trace_summary_t {
+  // Time the summary was recorded.
+  iree_time_t timestamp_ns;
+  // Key passed to the summarize op (such as `dispatch_0 outputs`), truncated
+  // to IREE_HAL_MODULE_TRACE_SUMMARY_MAX_KEY_LENGTH characters.
+  char key[IREE_HAL_MODULE_TRACE_SUMMARY_MAX_KEY_LENGTH + 1];
+  // Index of the buffer view within the operands of the summarize op.
+  iree_host_size_t operand_index;
+  iree_hal_buffer_view_summary_t summary;
+} iree_hal_module_trace_summary_t;
+
+// Moves up to |capacity| of the oldest trace summaries recorded in
+// |module_state| into |out_summaries| and returns the number moved in
+// |out_count|. Summaries are kept in a fixed-size ring that overwrites the
+// oldest entries when full so callers are expected to drain periodically.
+// Thread-safe and may be called from any thread while the context is in use.
+IREE_API_EXPORT void iree_hal_module_state_drain_trace_summaries(
+    iree_vm_module_state_t* module_state, iree_host_size_t capacity,
+    iree_hal_module_trace_summary_t* out_summaries,
+    iree_host_size_t* out_count);
+
 // TODO(benvanik): generate these list helpers:
 
 IREE_API_EXPORT iree_hal_buffer_view_t* iree_vm_list_get_buffer_view_assign(
@@ -0,0 +1,198 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/modules/hal/module.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/local/sync_device.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+#include "iree/vm/api.h"
+
+namespace {
+
+// Size of each transient allocation. Several fit in one arena block.
+constexpr int32_t kTransientSize = 16 * 1024;
+
+// Number of invocations made by each loop.
+constexpr int kInvocationCount = 512;
+
+// Host allocator wrapping the system allocator that tracks the number of bytes
+// live. Allocations are prefixed with their size.
+struct CountingAllocator {
+  static constexpr iree_host_size_t kHeaderSize = 16;
+
+  std::atomic<int64_t> live_bytes{0};
+
+  iree_allocator_t allocator() { return {this, Ctl}; }
+
+  static iree_status_t IREE_API_PTR Ctl(void* self,
+                                        iree_allocator_command_t command,
+                                        const void* params, void** inout_ptr) {
+    CountingAllocator* counter = reinterpret_cast<CountingAllocator*>(self);
+    void* header = NULL;
+    iree_host_size_t old_size = 0;
+    if ((command == IREE_ALLOCATOR_COMMAND_REALLOC ||
+         command == IREE_ALLOCATOR_COMMAND_FREE) &&
+        *inout_ptr) {
+      header = (uint8_t*)*inout_ptr - kHeaderSize;
+      old_size = *(iree_host_size_t*)header;
+    }
+    if (command == IREE_ALLOCATOR_COMMAND_FREE) {
+      counter->live_bytes -= (int64_t)old_size;
+      return iree_allocator_system_ctl(NULL, command, NULL, &header);
+    }
+    iree_host_size_t new_size =
+        reinterpret_cast<const iree_allocator_alloc_params_t*>(params)
+            ->byte_length;
+    iree_allocator_alloc_params_t system_params = {kHeaderSize + new_size};
+    IREE_RETURN_IF_ERROR(
+        iree_allocator_system_ctl(NULL, command, &system_params, &header));
+    *(iree_host_size_t*)header = new_size;
+    *inout_ptr = (uint8_t*)header + kHeaderSize;
+    counter->live_bytes += (int64_t)new_size - (int64_t)old_size;
+    return iree_ok_status();
+  }
+};
+
+class HALModuleTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    IREE_ASSERT_OK(iree_hal_module_register_types());
+  }
+
+  void SetUp() override {
+    iree_hal_sync_device_params_t params;
+    iree_hal_sync_device_params_initialize(&params);
+    IREE_ASSERT_OK(iree_hal_sync_device_create(
+        iree_make_cstring_view("sync"), &params, /*loader_count=*/0,
+        /*loaders=*/NULL, iree_allocator_system(), &device_));
+    IREE_ASSERT_OK(
+        iree_hal_module_create(device_, iree_allocator_system(), &module_));
+    IREE_ASSERT_OK(
+        iree_vm_instance_create(iree_allocator_system(), &instance_));
+    // The module state (and with it the transient arenas) is allocated from
+    // the context allocator.
+    IREE_ASSERT_OK(iree_vm_context_create_with_modules(
+        instance_, &module_, 1, host_allocator_.allocator(), &context_));
+    IREE_ASSERT_OK(iree_vm_context_resolve_function(
+        context_, iree_make_cstring_view("hal.allocator.allocate"),
+        &allocate_fn_));
+  }
+
+  void TearDown() override {
+    iree_vm_context_release(context_);
+    iree_vm_instance_release(instance_);
+    iree_vm_module_release(module_);
+    iree_hal_device_release(device_);
+    EXPECT_EQ(host_allocator_.live_bytes, 0);
+  }
+
+  // Invokes hal.allocator.allocate for a transient buffer and returns it.
+  iree_hal_buffer_t* AllocateTransient(iree_vm_context_t* context) {
+    iree_vm_list_t* inputs = NULL;
+    IREE_CHECK_OK(iree_vm_list_create(/*element_type=*/NULL, 4,
+                                      iree_allocator_system(), &inputs));
+    iree_vm_ref_t allocator_ref =
+        iree_hal_allocator_retain_ref(iree_hal_device_allocator(device_));
+    IREE_CHECK_OK(iree_vm_list_push_ref_move(inputs, &allocator_ref));
+    iree_vm_value_t memory_types = iree_vm_value_make_i32(
+        IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_TRANSIENT);
+    IREE_CHECK_OK(iree_vm_list_push_value(inputs, &memory_types));
+    iree_vm_value_t buffer_usage =
+        iree_vm_value_make_i32(IREE_HAL_BUFFER_USAGE_ALL);
+    IREE_CHECK_OK(iree_vm_list_push_value(inputs, &buffer_usage));
+    iree_vm_value_t allocation_size = iree_vm_value_make_i32(kTransientSize);
+    IREE_CHECK_OK(iree_vm_list_push_value(inputs, &allocation_size));
+
+    iree_vm_list_t* outputs = NULL;
+    IREE_CHECK_OK(iree_vm_list_create(/*element_type=*/NULL, 1,
+                                      iree_allocator_system(), &outputs));
+    IREE_CHECK_OK(iree_vm_invoke(context, allocate_fn_,
+                                 /*policy=*/NULL, inputs, outputs,
+                                 iree_allocator_system()));
+    iree_vm_list_release(inputs);
+
+    iree_vm_ref_t buffer_ref = {0};
+    IREE_CHECK_OK(iree_vm_list_get_ref_retain(outputs, 0, &buffer_ref));
+    iree_vm_list_release(outputs);
+    iree_hal_buffer_t* buffer = NULL;
+    IREE_CHECK_OK(iree_hal_buffer_check_deref(buffer_ref, &buffer));
+    return buffer;
+  }
+
+  CountingAllocator host_allocator_;
+  iree_hal_device_t* device_ = NULL;
+  iree_vm_module_t* module_ = NULL;
+  iree_vm_instance_t* instance_ = NULL;
+  iree_vm_context_t* context_ = NULL;
+  iree_vm_function_t allocate_fn_;
+};
+
+// Transient storage is reclaimed after each invocation.
+TEST_F(HALModuleTest, TransientArenaReusedAcrossInvocations) {
+  iree_hal_buffer_release(AllocateTransient(context_));
+  int64_t baseline_bytes = host_allocator_.live_bytes;
+  for (int i = 0; i < kInvocationCount; ++i) {
+    iree_hal_buffer_release(AllocateTransient(context_));
+  }
+  EXPECT_EQ(host_allocator_.live_bytes, baseline_bytes);
+}
+
+// A buffer that outlives its invocation (as when retained by in-flight work)
+// only keeps the storage of its own invocation alive.
+TEST_F(HALModuleTest, TransientArenaBoundedWithOverlappingBuffers) {
+  iree_hal_buffer_t* prior_buffer = AllocateTransient(context_);
+  iree_hal_buffer_t* buffer = AllocateTransient(context_);
+  iree_hal_buffer_release(prior_buffer);
+  prior_buffer = buffer;
+  int64_t baseline_bytes = host_allocator_.live_bytes;
+  for (int i = 0; i < kInvocationCount; ++i) {
+    buffer = AllocateTransient(context_);
+    iree_hal_buffer_release(prior_buffer);
+    prior_buffer = buffer;
+    ASSERT_LE(host_allocator_.live_bytes, baseline_bytes);
+  }
+  iree_hal_buffer_release(prior_buffer);
+}
+
+// Transient buffers may be released from threads other than the one invoking
+// while new invocations allocate from the shared block pool.
+TEST_F(HALModuleTest, TransientBuffersReleasedFromOtherThreads) {
+  std::vector<std::thread> releasers;
+  for (int i = 0; i < kInvocationCount / 64; ++i) {
+    std::vector<iree_hal_buffer_t*> buffers;
+    for (int j = 0; j < 64; ++j) {
+      buffers.push_back(AllocateTransient(context_));
+    }
+    releasers.emplace_back([buffers]() {
+      for (iree_hal_buffer_t* buffer : buffers) {
+        iree_hal_buffer_release(buffer);
+      }
+    });
+  }
+  for (std::thread& releaser : releasers) releaser.join();
+}
+
+// Transient buffers may outlive the context that allocated them.
+TEST_F(HALModuleTest, TransientBufferOutlivesContext) {
+  iree_hal_buffer_t* buffer = AllocateTransient(context_);
+  iree_vm_context_release(context_);
+  context_ = NULL;
+  uint8_t pattern = 0xCD;
+  IREE_EXPECT_OK(iree_hal_buffer_fill(buffer, 0, kTransientSize, &pattern,
+                                      sizeof(pattern)));
+  iree_hal_buffer_release(buffer);
+}
+
+}  // namespace
@@ -23,6 +23,29 @@
 
 // clang-format off
 
-EXPORT_FN("_placeholder", iree_vmvx_module_placeholder, v, v)
+EXPORT_FN("abs.2d.f32", iree_vmvx_module_abs_f32_2d, riiiriiiii, v)
+EXPORT_FN("add.2d.f32", iree_vmvx_module_add_f32_2d, riiiriiiriiiii, v)
+EXPORT_FN("add.2d.i32", iree_vmvx_module_add_i32_2d, riiiriiiriiiii, v)
+EXPORT_FN("and.2d.i32", iree_vmvx_module_and_i32_2d, riiiriiiriiiii, v)
+EXPORT_FN("ceil.2d.f32", iree_vmvx_module_ceil_f32_2d, riiiriiiii, v)
+EXPORT_FN("copy.2d.x16", iree_vmvx_module_copy_2d_x16, riiiriiiii, v)
+EXPORT_FN("copy.2d.x32", iree_vmvx_module_copy_2d_x32, riiiriiiii, v)
+EXPORT_FN("copy.2d.x64", iree_vmvx_module_copy_2d_x64, riiiriiiii, v)
+EXPORT_FN("copy.2d.x8", iree_vmvx_module_copy_2d_x8, riiiriiiii, v)
+EXPORT_FN("div.2d.f32", iree_vmvx_module_div_f32_2d, riiiriiiriiiii, v)
+EXPORT_FN("exp.2d.f32", iree_vmvx_module_exp_f32_2d, riiiriiiii, v)
+EXPORT_FN("fill.2d.x32", iree_vmvx_module_fill_2d_x32, iriiiii, v)
+EXPORT_FN("floor.2d.f32", iree_vmvx_module_floor_f32_2d, riiiriiiii, v)
+EXPORT_FN("log.2d.f32", iree_vmvx_module_log_f32_2d, riiiriiiii, v)
+EXPORT_FN("matmul.f32f32f32", iree_vmvx_module_matmul_f32f32f32, riiriiriiiiii, v)
+EXPORT_FN("mmt4d.f32f32f32", iree_vmvx_module_mmt4d_f32f32f32, riiriiriiiiiiiii, v)
+EXPORT_FN("mul.2d.f32", iree_vmvx_module_mul_f32_2d, riiiriiiriiiii, v)
+EXPORT_FN("mul.2d.i32", iree_vmvx_module_mul_i32_2d, riiiriiiriiiii, v)
+EXPORT_FN("neg.2d.f32", iree_vmvx_module_neg_f32_2d, riiiriiiii, v)
+EXPORT_FN("or.2d.i32", iree_vmvx_module_or_i32_2d, riiiriiiriiiii, v)
+EXPORT_FN("rsqrt.2d.f32", iree_vmvx_module_rsqrt_f32_2d, riiiriiiii, v)
+EXPORT_FN("sub.2d.f32", iree_vmvx_module_sub_f32_2d, riiiriiiriiiii, v)
+EXPORT_FN("sub.2d.i32", iree_vmvx_module_sub_i32_2d, riiiriiiriiiii, v)
+EXPORT_FN("xor.2d.i32", iree_vmvx_module_xor_i32_2d, riiiriiiriiiii, v)
 
 // clang-format on
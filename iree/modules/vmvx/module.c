@@ -6,6 +6,7 @@
 
 #include "iree/modules/vmvx/module.h"
 
+#include <math.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -91,13 +92,412 @@ iree_vmvx_module_free_state(void* self, iree_vm_module_state_t* module_state) {
 }
 
 //===----------------------------------------------------------------------===//
-// TODO
+// Tile access utilities
 //===----------------------------------------------------------------------===//
 
-// Placeholder to make the function pointer arrays happy (they can't be empty).
-IREE_VM_ABI_EXPORT(iree_vmvx_module_placeholder,  //
+// Bit in the matmul/mmt4d |flags| indicating that the product is accumulated
+// into the existing output contents instead of overwriting them.
+#define IREE_VMVX_MATMUL_FLAG_ACCUMULATE (1u << 0)
+
+// Maps a 2D tile of |size0| x |size1| elements of |element_size| bytes starting
+// at element |offset| of |buffer_ref| with element strides |stride0| and
+// |stride1|. Fails if any element of the tile lies outside of the buffer or if
+// |is_output| is set and the buffer is read-only.
+static iree_status_t iree_vmvx_map_tile(iree_vm_ref_t buffer_ref,
+                                        bool is_output,
+                                        iree_host_size_t element_size,
+                                        int32_t offset, int32_t stride0,
+                                        int32_t stride1, int32_t size0,
+                                        int32_t size1, uint8_t** out_ptr) {
+  *out_ptr = NULL;
+  iree_vm_buffer_t* buffer = NULL;
+  IREE_RETURN_IF_ERROR(iree_vm_buffer_check_deref(buffer_ref, &buffer));
+  if (is_output &&
+      !iree_all_bits_set(buffer->access, IREE_VM_BUFFER_ACCESS_MUTABLE)) {
+    return iree_make_status(
+        IREE_STATUS_PERMISSION_DENIED,
+        "buffer is read-only and cannot be mapped for mutation");
+  }
+  if (IREE_UNLIKELY(offset < 0 || stride0 < 0 || stride1 < 0 || size0 < 0 ||
+                    size1 < 0)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "negative tile offset, stride, or size");
+  }
+  iree_byte_span_t data = iree_vm_buffer_data(buffer);
+  if (size0 == 0 || size1 == 0) {
+    *out_ptr = data.data;  // nothing will be accessed
+    return iree_ok_status();
+  }
+  const uint64_t last_element = (uint64_t)offset +
+                                (uint64_t)(size0 - 1) * (uint64_t)stride0 +
+                                (uint64_t)(size1 - 1) * (uint64_t)stride1;
+  if (IREE_UNLIKELY((last_element + 1) * element_size > data.data_length)) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "out-of-bounds tile access (offset=%d, "
+                            "strides=[%d, %d], sizes=[%d, %d], buffer "
+                            "length=%zu)",
+                            offset, stride0, stride1, size0, size1,
+                            data.data_length);
+  }
+  *out_ptr = data.data + (iree_host_size_t)offset * element_size;
+  return iree_ok_status();
+}
+
+// Returns |a| * |b| * |c| in |out_value| if the product fits in an int32_t.
+static iree_status_t iree_vmvx_mul3_i32(int32_t a, int32_t b, int32_t c,
+                                        int32_t* out_value) {
+  const int64_t value = (int64_t)a * (int64_t)b * (int64_t)c;
+  if (IREE_UNLIKELY(a < 0 || b < 0 || c < 0 || value > INT32_MAX)) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "tile dimensions out of range");
+  }
+  *out_value = (int32_t)value;
+  return iree_ok_status();
+}
+
+//===----------------------------------------------------------------------===//
+// Copy and fill
+//===----------------------------------------------------------------------===//
+
+#define IREE_VMVX_STRIDED_COPY_2D(type)                                      \
+  for (int32_t i = 0; i < size0; ++i) {                                      \
+    const type* in_row = (const type*)in + (iree_host_size_t)i * in_stride0; \
+    type* out_row = (type*)out + (iree_host_size_t)i * out_stride0;          \
+    for (int32_t j = 0; j < size1; ++j) {                                    \
+      out_row[(iree_host_size_t)j * out_stride1] =                           \
+          in_row[(iree_host_size_t)j * in_stride1];                          \
+    }                                                                        \
+  }
+
+static void iree_vmvx_copy_2d(iree_host_size_t element_size, const uint8_t* in,
+                              int32_t in_stride0, int32_t in_stride1,
+                              uint8_t* out, int32_t out_stride0,
+                              int32_t out_stride1, int32_t size0,
+                              int32_t size1) {
+  if (size0 == 0 || size1 == 0) return;
+  if (in_stride1 == 1 && out_stride1 == 1) {
+    // Rows are contiguous; tiles that are entirely dense are a single copy.
+    const iree_host_size_t row_length = (iree_host_size_t)size1 * element_size;
+    if (size0 == 1 || (in_stride0 == size1 && out_stride0 == size1)) {
+      memcpy(out, in, (iree_host_size_t)size0 * row_length);
+      return;
+    }
+    for (int32_t i = 0; i < size0; ++i) {
+      memcpy(out + (iree_host_size_t)i * out_stride0 * element_size,
+             in + (iree_host_size_t)i * in_stride0 * element_size, row_length);
+    }
+    return;
+  }
+  switch (element_size) {
+    case 1:
+      IREE_VMVX_STRIDED_COPY_2D(uint8_t);
+      break;
+    case 2:
+      IREE_VMVX_STRIDED_COPY_2D(uint16_t);
+      break;
+    case 4:
+      IREE_VMVX_STRIDED_COPY_2D(uint32_t);
+      break;
+    case 8:
+      IREE_VMVX_STRIDED_COPY_2D(uint64_t);
+      break;
+  }
+}
+
+#define IREE_VMVX_DEFINE_COPY_2D(name, type)                                  \
+  IREE_VM_ABI_EXPORT(iree_vmvx_module_copy_2d_##name,                         \
+                     iree_vmvx_module_state_t, riiiriiiii, v) {               \
+    uint8_t* in = NULL;                                                       \
+    uint8_t* out = NULL;                                                      \
+    IREE_RETURN_IF_ERROR(iree_vmvx_map_tile(args->r0, false, sizeof(type),    \
+                                            args->i1, args->i2, args->i3,     \
+                                            args->i8, args->i9, &in));        \
+    IREE_RETURN_IF_ERROR(iree_vmvx_map_tile(args->r4, true, sizeof(type),     \
+                                            args->i5, args->i6, args->i7,     \
+                                            args->i8, args->i9, &out));       \
+    iree_vmvx_copy_2d(sizeof(type), in, args->i2, args->i3, out, args->i6,    \
+                      args->i7, args->i8, args->i9);                          \
+    return iree_ok_status();                                                  \
+  }
+
+IREE_VMVX_DEFINE_COPY_2D(x8, uint8_t);
+IREE_VMVX_DEFINE_COPY_2D(x16, uint16_t);
+IREE_VMVX_DEFINE_COPY_2D(x32, uint32_t);
+IREE_VMVX_DEFINE_COPY_2D(x64, uint64_t);
+
+IREE_VM_ABI_EXPORT(iree_vmvx_module_fill_2d_x32,  //
                    iree_vmvx_module_state_t,      //
-                   v, v) {
+                   iriiiii, v) {
+  const uint32_t value = (uint32_t)args->i0;
+  const int32_t out_stride0 = args->i3;
+  const int32_t out_stride1 = args->i4;
+  const int32_t size0 = args->i5;
+  const int32_t size1 = args->i6;
+  uint8_t* out_ptr = NULL;
+  IREE_RETURN_IF_ERROR(iree_vmvx_map_tile(args->r1, true, sizeof(uint32_t),
+                                          args->i2, out_stride0, out_stride1,
+                                          size0, size1, &out_ptr));
+  uint32_t* out = (uint32_t*)out_ptr;
+  for (int32_t i = 0; i < size0; ++i) {
+    uint32_t* out_row = out + (iree_host_size_t)i * out_stride0;
+    if (out_stride1 == 1 && value == 0) {
+      memset(out_row, 0, (iree_host_size_t)size1 * sizeof(uint32_t));
+    } else if (out_stride1 == 1) {
+      for (int32_t j = 0; j < size1; ++j) out_row[j] = value;
+    } else {
+      for (int32_t j = 0; j < size1; ++j) {
+        out_row[(iree_host_size_t)j * out_stride1] = value;
+      }
+    }
+  }
+  return iree_ok_status();
+}
+
+//===----------------------------------------------------------------------===//
+// Elementwise ops
+//===----------------------------------------------------------------------===//
+
+// NOTE: the loops below are written such that the unit-stride paths are
+// auto-vectorized by the host compiler; broadcasts are expressed by the
+// compiler with 0 strides and take the strided path only when the innermost
+// dimension is broadcast. Integer ops are performed on unsigned values to get
+// well-defined wraparound.
+
+#define IREE_VMVX_DEFINE_BINARY_2D(name, type, expr)                          \
+  IREE_VM_ABI_EXPORT(iree_vmvx_module_##name##_2d,                            \
+                     iree_vmvx_module_state_t, riiiriiiriiiii, v) {           \
+    const int32_t lhs_stride0 = args->i2;                                     \
+    const int32_t lhs_stride1 = args->i3;                                     \
+    const int32_t rhs_stride0 = args->i6;                                     \
+    const int32_t rhs_stride1 = args->i7;                                     \
+    const int32_t out_stride0 = args->i10;                                    \
+    const int32_t out_stride1 = args->i11;                                    \
+    const int32_t size0 = args->i12;                                          \
+    const int32_t size1 = args->i13;                                          \
+    uint8_t* lhs_ptr = NULL;                                                  \
+    uint8_t* rhs_ptr = NULL;                                                  \
+    uint8_t* out_ptr = NULL;                                                  \
+    IREE_RETURN_IF_ERROR(iree_vmvx_map_tile(args->r0, false, sizeof(type),    \
+                                            args->i1, lhs_stride0,            \
+                                            lhs_stride1, size0, size1,        \
+                                            &lhs_ptr));                       \
+    IREE_RETURN_IF_ERROR(iree_vmvx_map_tile(args->r4, false, sizeof(type),    \
+                                            args->i5, rhs_stride0,            \
+                                            rhs_stride1, size0, size1,        \
+                                            &rhs_ptr));                       \
+    IREE_RETURN_IF_ERROR(iree_vmvx_map_tile(args->r8, true, sizeof(type),     \
+                                            args->i9, out_stride0,            \
+                                            out_stride1, size0, size1,        \
+                                            &out_ptr));                       \
+    const bool is_contiguous =                                                \
+        lhs_stride1 == 1 && rhs_stride1 == 1 && out_stride1 == 1;             \
+    for (int32_t i = 0; i < size0; ++i) {                                     \
+      const type* lhs =                                                       \
+          (const type*)lhs_ptr + (iree_host_size_t)i * lhs_stride0;           \
+      const type* rhs =                                                       \
+          (const type*)rhs_ptr + (iree_host_size_t)i * rhs_stride0;           \
+      type* out = (type*)out_ptr + (iree_host_size_t)i * out_stride0;         \
+      if (is_contiguous) {                                                    \
+        for (int32_t j = 0; j < size1; ++j) {                                 \
+          const type a = lhs[j];                                              \
+          const type b = rhs[j];                                              \
+          out[j] = (expr);                                                    \
+        }                                                                     \
+      } else {                                                                \
+        for (int32_t j = 0; j < size1; ++j) {                                 \
+          const type a = lhs[(iree_host_size_t)j * lhs_stride1];              \
+          const type b = rhs[(iree_host_size_t)j * rhs_stride1];              \
+          out[(iree_host_size_t)j * out_stride1] = (expr);                    \
+        }                                                                     \
+      }                                                                       \
+    }                                                                         \
+    return iree_ok_status();                                                  \
+  }
+
+IREE_VMVX_DEFINE_BINARY_2D(add_f32, float, a + b);
+IREE_VMVX_DEFINE_BINARY_2D(add_i32, uint32_t, a + b);
+IREE_VMVX_DEFINE_BINARY_2D(and_i32, uint32_t, a & b);
+IREE_VMVX_DEFINE_BINARY_2D(div_f32, float, a / b);
+IREE_VMVX_DEFINE_BINARY_2D(mul_f32, float, a * b);
+IREE_VMVX_DEFINE_BINARY_2D(mul_i32, uint32_t, a * b);
+IREE_VMVX_DEFINE_BINARY_2D(or_i32, uint32_t, a | b);
+IREE_VMVX_DEFINE_BINARY_2D(sub_f32, float, a - b);
+IREE_VMVX_DEFINE_BINARY_2D(sub_i32, uint32_t, a - b);
+IREE_VMVX_DEFINE_BINARY_2D(xor_i32, uint32_t, a ^ b);
+
+#define IREE_VMVX_DEFINE_UNARY_2D(name, type, expr)                           \
+  IREE_VM_ABI_EXPORT(iree_vmvx_module_##name##_2d,                            \
+                     iree_vmvx_module_state_t, riiiriiiii, v) {               \
+    const int32_t in_stride0 = args->i2;                                      \
+    const int32_t in_stride1 = args->i3;                                      \
+    const int32_t out_stride0 = args->i6;                                     \
+    const int32_t out_stride1 = args->i7;                                     \
+    const int32_t size0 = args->i8;                                           \
+    const int32_t size1 = args->i9;                                           \
+    uint8_t* in_ptr = NULL;                                                   \
+    uint8_t* out_ptr = NULL;                                                  \
+    IREE_RETURN_IF_ERROR(iree_vmvx_map_tile(args->r0, false, sizeof(type),    \
+                                            args->i1, in_stride0, in_stride1, \
+                                            size0, size1, &in_ptr));          \
+    IREE_RETURN_IF_ERROR(iree_vmvx_map_tile(args->r4, true, sizeof(type),     \
+                                            args->i5, out_stride0,            \
+                                            out_stride1, size0, size1,        \
+                                            &out_ptr));                       \
+    const bool is_contiguous = in_stride1 == 1 && out_stride1 == 1;           \
+    for (int32_t i = 0; i < size0; ++i) {                                     \
+      const type* in = (const type*)in_ptr + (iree_host_size_t)i * in_stride0; \
+      type* out = (type*)out_ptr + (iree_host_size_t)i * out_stride0;         \
+      if (is_contiguous) {                                                    \
+        for (int32_t j = 0; j < size1; ++j) {                                 \
+          const type a = in[j];                                               \
+          out[j] = (expr);                                                    \
+        }                                                                     \
+      } else {                                                                \
+        for (int32_t j = 0; j < size1; ++j) {                                 \
+          const type a = in[(iree_host_size_t)j * in_stride1];                \
+          out[(iree_host_size_t)j * out_stride1] = (expr);                    \
+        }                                                                     \
+      }                                                                       \
+    }                                                                         \
+    return iree_ok_status();                                                  \
+  }
+
+IREE_VMVX_DEFINE_UNARY_2D(abs_f32, float, fabsf(a));
+IREE_VMVX_DEFINE_UNARY_2D(ceil_f32, float, ceilf(a));
+IREE_VMVX_DEFINE_UNARY_2D(exp_f32, float, expf(a));
+IREE_VMVX_DEFINE_UNARY_2D(floor_f32, float, floorf(a));
+IREE_VMVX_DEFINE_UNARY_2D(log_f32, float, logf(a));
+IREE_VMVX_DEFINE_UNARY_2D(neg_f32, float, -a);
+IREE_VMVX_DEFINE_UNARY_2D(rsqrt_f32, float, 1.0f / sqrtf(a));
+
+//===----------------------------------------------------------------------===//
+// Matrix multiplication
+//===----------------------------------------------------------------------===//
+
+// y += a * x
+static void iree_vmvx_axpy_f32(int32_t n, float a, const float* IREE_RESTRICT x,
+                               float* IREE_RESTRICT y) {
+  for (int32_t i = 0; i < n; ++i) y[i] += a * x[i];
+}
+
+// Row-major matmul of an MxK |lhs| and a KxN |rhs| into an MxN |out|. Rows of
+// all operands are contiguous and strided by their respective row strides.
+IREE_VM_ABI_EXPORT(iree_vmvx_module_matmul_f32f32f32,  //
+                   iree_vmvx_module_state_t,           //
+                   riiriiriiiiii, v) {
+  const int32_t lhs_stride = args->i2;
+  const int32_t rhs_stride = args->i5;
+  const int32_t out_stride = args->i8;
+  const int32_t m = args->i9;
+  const int32_t n = args->i10;
+  const int32_t k = args->i11;
+  const uint32_t flags = (uint32_t)args->i12;
+  uint8_t* lhs_ptr = NULL;
+  uint8_t* rhs_ptr = NULL;
+  uint8_t* out_ptr = NULL;
+  IREE_RETURN_IF_ERROR(iree_vmvx_map_tile(args->r0, false, sizeof(float),
+                                          args->i1, lhs_stride, 1, m, k,
+                                          &lhs_ptr));
+  IREE_RETURN_IF_ERROR(iree_vmvx_map_tile(args->r3, false, sizeof(float),
+                                          args->i4, rhs_stride, 1, k, n,
+                                          &rhs_ptr));
+  IREE_RETURN_IF_ERROR(iree_vmvx_map_tile(args->r6, true, sizeof(float),
+                                          args->i7, out_stride, 1, m, n,
+                                          &out_ptr));
+  const float* lhs = (const float*)lhs_ptr;
+  const float* rhs = (const float*)rhs_ptr;
+  float* out = (float*)out_ptr;
+  // Each output row is accumulated as a sequence of scaled rhs rows so that
+  // the innermost loop runs over contiguous memory in all operands.
+  for (int32_t i = 0; i < m; ++i) {
+    const float* lhs_row = lhs + (iree_host_size_t)i * lhs_stride;
+    float* out_row = out + (iree_host_size_t)i * out_stride;
+    if (!(flags & IREE_VMVX_MATMUL_FLAG_ACCUMULATE)) {
+      memset(out_row, 0, (iree_host_size_t)n * sizeof(float));
+    }
+    for (int32_t kk = 0; kk < k; ++kk) {
+      const float* rhs_row = rhs + (iree_host_size_t)kk * rhs_stride;
+      iree_vmvx_axpy_f32(n, lhs_row[kk], rhs_row, out_row);
+    }
+  }
+  return iree_ok_status();
+}
+
+// out(M0xN0) += lhs(M0xK0) * transpose(rhs(N0xK0))
+static void iree_vmvx_mmt4d_tile_f32(int32_t m0, int32_t n0, int32_t k0,
+                                     const float* IREE_RESTRICT lhs,
+                                     const float* IREE_RESTRICT rhs,
+                                     float* IREE_RESTRICT out) {
+  for (int32_t i0 = 0; i0 < m0; ++i0) {
+    for (int32_t j0 = 0; j0 < n0; ++j0) {
+      const float* lhs_row = lhs + i0 * k0;
+      const float* rhs_row = rhs + j0 * k0;
+      float acc = out[i0 * n0 + j0];
+      for (int32_t kk = 0; kk < k0; ++kk) acc += lhs_row[kk] * rhs_row[kk];
+      out[i0 * n0 + j0] = acc;
+    }
+  }
+}
+
+// Matmul of an MxKxM0xK0 |lhs| and an NxKxN0xK0 |rhs| into an MxNxM0xN0 |out|
+// as defined by linalg.mmt4d. The inner tiles of each operand are dense and
+// only the outermost dimension is strided.
+IREE_VM_ABI_EXPORT(iree_vmvx_module_mmt4d_f32f32f32,  //
+                   iree_vmvx_module_state_t,          //
+                   riiriiriiiiiiiii, v) {
+  const int32_t lhs_stride = args->i2;
+  const int32_t rhs_stride = args->i5;
+  const int32_t out_stride = args->i8;
+  const int32_t m = args->i9;
+  const int32_t n = args->i10;
+  const int32_t k = args->i11;
+  const int32_t m0 = args->i12;
+  const int32_t n0 = args->i13;
+  const int32_t k0 = args->i14;
+  const uint32_t flags = (uint32_t)args->i15;
+  if (IREE_UNLIKELY(m0 <= 0 || n0 <= 0 || k0 <= 0)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "invalid inner tile size %dx%dx%d", m0, n0, k0);
+  }
+  int32_t lhs_row_length = 0;
+  int32_t rhs_row_length = 0;
+  int32_t out_row_length = 0;
+  IREE_RETURN_IF_ERROR(iree_vmvx_mul3_i32(k, m0, k0, &lhs_row_length));
+  IREE_RETURN_IF_ERROR(iree_vmvx_mul3_i32(k, n0, k0, &rhs_row_length));
+  IREE_RETURN_IF_ERROR(iree_vmvx_mul3_i32(n, m0, n0, &out_row_length));
+  uint8_t* lhs_ptr = NULL;
+  uint8_t* rhs_ptr = NULL;
+  uint8_t* out_ptr = NULL;
+  IREE_RETURN_IF_ERROR(iree_vmvx_map_tile(args->r0, false, sizeof(float),
+                                          args->i1, lhs_stride, 1, m,
+                                          lhs_row_length, &lhs_ptr));
+  IREE_RETURN_IF_ERROR(iree_vmvx_map_tile(args->r3, false, sizeof(float),
+                                          args->i4, rhs_stride, 1, n,
+                                          rhs_row_length, &rhs_ptr));
+  IREE_RETURN_IF_ERROR(iree_vmvx_map_tile(args->r6, true, sizeof(float),
+                                          args->i7, out_stride, 1, m,
+                                          out_row_length, &out_ptr));
+  const float* lhs = (const float*)lhs_ptr;
+  const float* rhs = (const float*)rhs_ptr;
+  float* out = (float*)out_ptr;
+  const iree_host_size_t lhs_tile_size = (iree_host_size_t)m0 * k0;
+  const iree_host_size_t rhs_tile_size = (iree_host_size_t)n0 * k0;
+  const iree_host_size_t out_tile_size = (iree_host_size_t)m0 * n0;
+  for (int32_t i = 0; i < m; ++i) {
+    const float* lhs_row = lhs + (iree_host_size_t)i * lhs_stride;
+    float* out_row = out + (iree_host_size_t)i * out_stride;
+    if (!(flags & IREE_VMVX_MATMUL_FLAG_ACCUMULATE)) {
+      memset(out_row, 0, (iree_host_size_t)out_row_length * sizeof(float));
+    }
+    for (int32_t j = 0; j < n; ++j) {
+      const float* rhs_row = rhs + (iree_host_size_t)j * rhs_stride;
+      float* out_tile = out_row + j * out_tile_size;
+      for (int32_t kk = 0; kk < k; ++kk) {
+        iree_vmvx_mmt4d_tile_f32(m0, n0, k0, lhs_row + kk * lhs_tile_size,
+                                 rhs_row + kk * rhs_tile_size, out_tile);
+      }
+    }
+  }
   return iree_ok_status();
 }
 
@@ -0,0 +1,499 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/runtime/batcher.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/internal/wait_handle.h"
+#include "iree/base/tracing.h"
+#include "iree/modules/hal/module.h"
+#include "iree/runtime/session.h"
+
+// Maximum rank of the buffer views passed through the batcher.
+#define IREE_RUNTIME_BATCHER_MAX_RANK 16
+
+//===----------------------------------------------------------------------===//
+// iree_runtime_batcher_options_t
+//===----------------------------------------------------------------------===//
+
+IREE_API_EXPORT void iree_runtime_batcher_options_initialize(
+    iree_runtime_batcher_options_t* out_options) {
+  memset(out_options, 0, sizeof(*out_options));
+  out_options->max_batch_size = 16;
+  out_options->max_latency = 1000000;  // 1ms
+}
+
+//===----------------------------------------------------------------------===//
+// iree_runtime_batcher_t
+//===----------------------------------------------------------------------===//
+
+// A request that has joined a batch.
+// Lives on the stack of the thread issuing the request.
+typedef struct iree_runtime_batcher_entry_t {
+  struct iree_runtime_batcher_entry_t* next;
+  iree_runtime_call_t* call;
+  // Outer dimension shared by all inputs of the call.
+  iree_host_size_t row_count;
+  // Result of the call; valid once |is_complete| is set.
+  iree_status_t status;
+  // Set by the thread issuing the batch once the entry is no longer
+  // referenced by it.
+  iree_atomic_int32_t is_complete;
+} iree_runtime_batcher_entry_t;
+
+// A batch of requests.
+// Lives on the stack of the thread of the first request in the batch, which
+// issues the batched invocation once the batch has closed.
+typedef struct iree_runtime_batch_t {
+  iree_runtime_batcher_entry_t* head;
+  iree_runtime_batcher_entry_t* tail;
+  // Total number of rows across all entries.
+  iree_host_size_t row_count;
+  // Set when the batch is closed before its latency deadline is reached.
+  iree_event_t close_event;
+} iree_runtime_batch_t;
+
+struct iree_runtime_batcher_t {
+  iree_atomic_ref_count_t ref_count;
+  iree_allocator_t host_allocator;
+  iree_runtime_session_t* session;
+  iree_vm_function_t function;
+  iree_runtime_batcher_options_t options;
+
+  // Guards |open_batch|.
+  iree_slim_mutex_t mutex;
+  // Batch accepting new requests or NULL if there is none.
+  iree_runtime_batch_t* open_batch;
+
+  // Posted each time a batch completes to wake the requests waiting on it.
+  iree_notification_t completion_notification;
+
+  iree_atomic_int64_t batch_count;
+  iree_atomic_int64_t call_count;
+};
+
+IREE_API_EXPORT iree_status_t iree_runtime_batcher_create(
+    iree_runtime_session_t* session, iree_vm_function_t function,
+    const iree_runtime_batcher_options_t* options,
+    iree_allocator_t host_allocator, iree_runtime_batcher_t** out_batcher) {
+  IREE_ASSERT_ARGUMENT(session);
+  IREE_ASSERT_ARGUMENT(options);
+  IREE_ASSERT_ARGUMENT(out_batcher);
+  *out_batcher = NULL;
+  if (options->max_batch_size == 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "max_batch_size must be at least 1");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_runtime_batcher_t* batcher = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, sizeof(*batcher),
+                                (void**)&batcher));
+  memset(batcher, 0, sizeof(*batcher));
+  iree_atomic_ref_count_init(&batcher->ref_count);
+  batcher->host_allocator = host_allocator;
+  batcher->session = session;
+  iree_runtime_session_retain(session);
+  batcher->function = function;
+  batcher->options = *options;
+  iree_slim_mutex_initialize(&batcher->mutex);
+  iree_notification_initialize(&batcher->completion_notification);
+
+  *out_batcher = batcher;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+static void iree_runtime_batcher_destroy(iree_runtime_batcher_t* batcher) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_notification_deinitialize(&batcher->completion_notification);
+  iree_slim_mutex_deinitialize(&batcher->mutex);
+  iree_runtime_session_release(batcher->session);
+  iree_allocator_free(batcher->host_allocator, batcher);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+IREE_API_EXPORT void iree_runtime_batcher_retain(
+    iree_runtime_batcher_t* batcher) {
+  if (batcher) {
+    iree_atomic_ref_count_inc(&batcher->ref_count);
+  }
+}
+
+IREE_API_EXPORT void iree_runtime_batcher_release(
+    iree_runtime_batcher_t* batcher) {
+  if (batcher && iree_atomic_ref_count_dec(&batcher->ref_count) == 1) {
+    iree_runtime_batcher_destroy(batcher);
+  }
+}
+
+IREE_API_EXPORT uint64_t
+iree_runtime_batcher_batch_count(iree_runtime_batcher_t* batcher) {
+  IREE_ASSERT_ARGUMENT(batcher);
+  return (uint64_t)iree_atomic_load_int64(&batcher->batch_count,
+                                          iree_memory_order_relaxed);
+}
+
+IREE_API_EXPORT uint64_t
+iree_runtime_batcher_call_count(iree_runtime_batcher_t* batcher) {
+  IREE_ASSERT_ARGUMENT(batcher);
+  return (uint64_t)iree_atomic_load_int64(&batcher->call_count,
+                                          iree_memory_order_relaxed);
+}
+
+//===----------------------------------------------------------------------===//
+// Batch formation
+//===----------------------------------------------------------------------===//
+
+// Returns the outer dimension shared by all buffer views in |inputs|.
+static iree_status_t iree_runtime_batcher_query_row_count(
+    const iree_vm_list_t* inputs, iree_host_size_t* out_row_count) {
+  *out_row_count = 0;
+  iree_host_size_t input_count = iree_vm_list_size(inputs);
+  if (input_count == 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "batched calls must have at least one input");
+  }
+  for (iree_host_size_t i = 0; i < input_count; ++i) {
+    iree_hal_buffer_view_t* buffer_view =
+        iree_vm_list_get_buffer_view_assign(inputs, i);
+    if (!buffer_view) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "batched call input %zu is not a buffer view", i);
+    }
+    if (iree_hal_buffer_view_shape_rank(buffer_view) == 0) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "batched call input %zu has no outer dimension",
+                              i);
+    }
+    iree_host_size_t row_count =
+        (iree_host_size_t)iree_hal_buffer_view_shape_dim(buffer_view, 0);
+    if (i == 0) {
+      *out_row_count = row_count;
+    } else if (row_count != *out_row_count) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "batched call input %zu has an outer dimension "
+                              "of %zu but input 0 has %zu",
+                              i, row_count, *out_row_count);
+    }
+  }
+  return iree_ok_status();
+}
+
+// Returns true if the inputs of |a| and |b| can be concatenated.
+static bool iree_runtime_batcher_is_compatible(const iree_vm_list_t* a,
+                                               const iree_vm_list_t* b) {
+  iree_host_size_t input_count = iree_vm_list_size(a);
+  if (iree_vm_list_size(b) != input_count) return false;
+  for (iree_host_size_t i = 0; i < input_count; ++i) {
+    iree_hal_buffer_view_t* a_view = iree_vm_list_get_buffer_view_assign(a, i);
+    iree_hal_buffer_view_t* b_view = iree_vm_list_get_buffer_view_assign(b, i);
+    iree_host_size_t rank = iree_hal_buffer_view_shape_rank(a_view);
+    if (iree_hal_buffer_view_element_type(a_view) !=
+            iree_hal_buffer_view_element_type(b_view) ||
+        iree_hal_buffer_view_encoding_type(a_view) !=
+            iree_hal_buffer_view_encoding_type(b_view) ||
+        iree_hal_buffer_view_shape_rank(b_view) != rank) {
+      return false;
+    }
+    const iree_hal_dim_t* a_dims = iree_hal_buffer_view_shape_dims(a_view);
+    const iree_hal_dim_t* b_dims = iree_hal_buffer_view_shape_dims(b_view);
+    for (iree_host_size_t j = 1; j < rank; ++j) {
+      if (a_dims[j] != b_dims[j]) return false;
+    }
+  }
+  return true;
+}
+
+// Closes |batch| if it is still open. Must be called with the mutex held.
+static void iree_runtime_batcher_close_batch(iree_runtime_batcher_t* batcher,
+                                             iree_runtime_batch_t* batch) {
+  if (batcher->open_batch != batch) return;
+  batcher->open_batch = NULL;
+  iree_event_set(&batch->close_event);
+}
+
+//===----------------------------------------------------------------------===//
+// Batch execution
+//===----------------------------------------------------------------------===//
+
+// Concatenates input |i| of all entries in |batch| and appends it to
+// |batch_inputs|.
+static iree_status_t iree_runtime_batcher_concatenate_input(
+    iree_runtime_batcher_t* batcher, const iree_runtime_batch_t* batch,
+    iree_host_size_t i, iree_vm_list_t* batch_inputs) {
+  iree_hal_buffer_view_t* head_view =
+      iree_vm_list_get_buffer_view_assign(batch->head->call->inputs, i);
+  iree_hal_dim_t shape[IREE_RUNTIME_BATCHER_MAX_RANK];
+  iree_host_size_t shape_rank = 0;
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_view_shape(
+      head_view, IREE_ARRAYSIZE(shape), shape, &shape_rank));
+  shape[0] = (iree_hal_dim_t)batch->row_count;
+
+  iree_hal_buffer_t* head_buffer = iree_hal_buffer_view_buffer(head_view);
+  iree_hal_buffer_view_t* batch_view = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_view_allocate_buffer(
+      iree_runtime_session_device_allocator(batcher->session), shape,
+      shape_rank, iree_hal_buffer_view_element_type(head_view),
+      iree_hal_buffer_view_encoding_type(head_view),
+      iree_hal_buffer_memory_type(head_buffer),
+      iree_hal_buffer_allowed_usage(head_buffer), &batch_view));
+
+  iree_status_t status = iree_ok_status();
+  iree_device_size_t offset = 0;
+  for (iree_runtime_batcher_entry_t* entry = batch->head;
+       entry && iree_status_is_ok(status); entry = entry->next) {
+    iree_hal_buffer_view_t* entry_view =
+        iree_vm_list_get_buffer_view_assign(entry->call->inputs, i);
+    iree_device_size_t length = iree_hal_buffer_view_byte_length(entry_view);
+    status = iree_hal_buffer_copy_data(
+        iree_hal_buffer_view_buffer(entry_view), 0,
+        iree_hal_buffer_view_buffer(batch_view), offset, length);
+    offset += length;
+  }
+
+  if (iree_status_is_ok(status)) {
+    iree_vm_ref_t batch_view_ref = iree_hal_buffer_view_move_ref(batch_view);
+    status = iree_vm_list_push_ref_move(batch_inputs, &batch_view_ref);
+  } else {
+    iree_hal_buffer_view_release(batch_view);
+  }
+  return status;
+}
+
+// Splits output |i| of the batched invocation across the entries of |batch|.
+// Buffer views are split along their outer dimension by referencing subspans
+// of the batched buffer and all other values are given to every entry.
+static iree_status_t iree_runtime_batcher_scatter_output(
+    const iree_runtime_batch_t* batch, const iree_vm_list_t* batch_outputs,
+    iree_host_size_t i) {
+  iree_hal_buffer_view_t* batch_view =
+      iree_vm_list_get_buffer_view_assign(batch_outputs, i);
+  if (!batch_view) {
+    iree_vm_variant_t value = iree_vm_variant_empty();
+    IREE_RETURN_IF_ERROR(iree_vm_list_get_variant(batch_outputs, i, &value));
+    for (iree_runtime_batcher_entry_t* entry = batch->head; entry;
+         entry = entry->next) {
+      IREE_RETURN_IF_ERROR(
+          iree_vm_list_push_variant(entry->call->outputs, &value));
+    }
+    return iree_ok_status();
+  }
+
+  iree_hal_dim_t shape[IREE_RUNTIME_BATCHER_MAX_RANK];
+  iree_host_size_t shape_rank = 0;
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_view_shape(
+      batch_view, IREE_ARRAYSIZE(shape), shape, &shape_rank));
+  if (shape_rank == 0 || (iree_host_size_t)shape[0] != batch->row_count) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "batched call output %zu does not have the batch "
+                            "of %zu rows as its outer dimension",
+                            i, batch->row_count);
+  }
+  iree_hal_buffer_t* batch_buffer = iree_hal_buffer_view_buffer(batch_view);
+  iree_device_size_t row_length =
+      iree_hal_buffer_view_byte_length(batch_view) / batch->row_count;
+
+  iree_device_size_t offset = 0;
+  for (iree_runtime_batcher_entry_t* entry = batch->head; entry;
+       entry = entry->next) {
+    iree_device_size_t length = entry->row_count * row_length;
+    iree_hal_buffer_t* entry_buffer = NULL;
+    IREE_RETURN_IF_ERROR(
+        iree_hal_buffer_subspan(batch_buffer, offset, length, &entry_buffer));
+    offset += length;
+    shape[0] = (iree_hal_dim_t)entry->row_count;
+    iree_hal_buffer_view_t* entry_view = NULL;
+    iree_status_t status = iree_hal_buffer_view_create(
+        entry_buffer, shape, shape_rank,
+        iree_hal_buffer_view_element_type(batch_view),
+        iree_hal_buffer_view_encoding_type(batch_view), &entry_view);
+    iree_hal_buffer_release(entry_buffer);
+    IREE_RETURN_IF_ERROR(status);
+    iree_vm_ref_t entry_view_ref = iree_hal_buffer_view_move_ref(entry_view);
+    IREE_RETURN_IF_ERROR(
+        iree_vm_list_push_ref_move(entry->call->outputs, &entry_view_ref));
+  }
+  return iree_ok_status();
+}
+
+// Concatenates the inputs of all entries in |batch|, invokes the function
+// once, and scatters the outputs back to the entries.
+static iree_status_t iree_runtime_batcher_invoke_batch(
+    iree_runtime_batcher_t* batcher, const iree_runtime_batch_t* batch) {
+  const iree_vm_list_t* head_inputs = batch->head->call->inputs;
+  iree_host_size_t input_count = iree_vm_list_size(head_inputs);
+  iree_vm_list_t* batch_inputs = NULL;
+  iree_vm_list_t* batch_outputs = NULL;
+  iree_status_t status =
+      iree_vm_list_create(/*element_type=*/NULL, input_count,
+                          batcher->host_allocator, &batch_inputs);
+  for (iree_host_size_t i = 0; i < input_count && iree_status_is_ok(status);
+       ++i) {
+    status = iree_runtime_batcher_concatenate_input(batcher, batch, i,
+                                                    batch_inputs);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_vm_list_create(
+        /*element_type=*/NULL,
+        iree_vm_list_capacity(batch->head->call->outputs),
+        batcher->host_allocator, &batch_outputs);
+  }
+
+  if (iree_status_is_ok(status)) {
+    status = iree_runtime_session_call(batcher->session, &batcher->function,
+                                       batch_inputs, batch_outputs);
+  }
+
+  for (iree_runtime_batcher_entry_t* entry = batch->head;
+       entry && iree_status_is_ok(status); entry = entry->next) {
+    status = iree_vm_list_resize(entry->call->outputs, 0);
+  }
+  iree_host_size_t output_count =
+      batch_outputs ? iree_vm_list_size(batch_outputs) : 0;
+  for (iree_host_size_t i = 0; i < output_count && iree_status_is_ok(status);
+       ++i) {
+    status = iree_runtime_batcher_scatter_output(batch, batch_outputs, i);
+  }
+
+  iree_vm_list_release(batch_outputs);
+  iree_vm_list_release(batch_inputs);
+  return status;
+}
+
+// Issues the closed |batch| and completes all of its entries.
+static void iree_runtime_batcher_issue_batch(iree_runtime_batcher_t* batcher,
+                                             iree_runtime_batch_t* batch) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)batch->row_count);
+
+  iree_status_t status = iree_ok_status();
+  if (batch->head == batch->tail) {
+    // A batch of one needs no concatenation.
+    status = iree_runtime_call_invoke(batch->head->call, /*flags=*/0);
+  } else {
+    status = iree_runtime_batcher_invoke_batch(batcher, batch);
+  }
+  iree_atomic_fetch_add_int64(&batcher->batch_count, 1,
+                              iree_memory_order_relaxed);
+
+  // Each entry receives its own copy of the status. Entries may be released by
+  // their threads as soon as they are marked complete.
+  iree_runtime_batcher_entry_t* entry = batch->head;
+  while (entry) {
+    iree_runtime_batcher_entry_t* next_entry = entry->next;
+    entry->status = next_entry ? iree_status_clone(status) : status;
+    iree_atomic_store_int32(&entry->is_complete, 1, iree_memory_order_release);
+    entry = next_entry;
+  }
+  iree_notification_post(&batcher->completion_notification, IREE_ALL_WAITERS);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static bool iree_runtime_batcher_entry_is_complete(void* arg) {
+  iree_runtime_batcher_entry_t* entry = (iree_runtime_batcher_entry_t*)arg;
+  return iree_atomic_load_int32(&entry->is_complete,
+                                iree_memory_order_acquire) != 0;
+}
+
+// Adds |entry| to the open batch (or a new one) and blocks until the batch it
+// joined has completed.
+static iree_status_t iree_runtime_batcher_enqueue(
+    iree_runtime_batcher_t* batcher, iree_runtime_batcher_entry_t* entry) {
+  iree_host_size_t max_batch_size = batcher->options.max_batch_size;
+
+  // Storage for the batch if this entry opens a new one.
+  iree_runtime_batch_t batch;
+  memset(&batch, 0, sizeof(batch));
+  bool is_leader = false;
+
+  iree_slim_mutex_lock(&batcher->mutex);
+  iree_runtime_batch_t* open_batch = batcher->open_batch;
+  if (open_batch &&
+      open_batch->row_count + entry->row_count <= max_batch_size &&
+      iree_runtime_batcher_is_compatible(open_batch->head->call->inputs,
+                                         entry->call->inputs)) {
+    open_batch->tail->next = entry;
+    open_batch->tail = entry;
+    open_batch->row_count += entry->row_count;
+    if (open_batch->row_count == max_batch_size) {
+      iree_runtime_batcher_close_batch(batcher, open_batch);
+    }
+  } else {
+    // The entry does not fit in the open batch (if any): issue that batch now
+    // instead of making it wait out its latency and start a new one.
+    iree_status_t status = iree_event_initialize(false, &batch.close_event);
+    if (!iree_status_is_ok(status)) {
+      iree_slim_mutex_unlock(&batcher->mutex);
+      return status;
+    }
+    if (open_batch) iree_runtime_batcher_close_batch(batcher, open_batch);
+    is_leader = true;
+    batch.head = batch.tail = entry;
+    batch.row_count = entry->row_count;
+    if (batch.row_count < max_batch_size) batcher->open_batch = &batch;
+  }
+  iree_slim_mutex_unlock(&batcher->mutex);
+
+  if (!is_leader) {
+    iree_notification_await(&batcher->completion_notification,
+                            iree_runtime_batcher_entry_is_complete, entry);
+    return entry->status;
+  }
+
+  // Wait for the batch to fill up or for its latency to elapse and then close
+  // it so that no more entries can join.
+  if (batch.row_count < max_batch_size) {
+    iree_status_ignore(iree_wait_one(
+        &batch.close_event,
+        iree_relative_timeout_to_deadline_ns(batcher->options.max_latency)));
+    iree_slim_mutex_lock(&batcher->mutex);
+    iree_runtime_batcher_close_batch(batcher, &batch);
+    iree_slim_mutex_unlock(&batcher->mutex);
+  }
+  iree_event_deinitialize(&batch.close_event);
+
+  iree_runtime_batcher_issue_batch(batcher, &batch);
+  return entry->status;
+}
+
+IREE_API_EXPORT iree_status_t iree_runtime_batcher_invoke(
+    iree_runtime_batcher_t* batcher, iree_runtime_call_t* call,
+    iree_runtime_call_flags_t flags) {
+  IREE_ASSERT_ARGUMENT(batcher);
+  IREE_ASSERT_ARGUMENT(call);
+  if (call->function.module != batcher->function.module ||
+      call->function.ordinal != batcher->function.ordinal) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "call is not for the batched function");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_runtime_batcher_entry_t entry;
+  memset(&entry, 0, sizeof(entry));
+  entry.call = call;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_runtime_batcher_query_row_count(call->inputs, &entry.row_count));
+
+  iree_status_t status = iree_ok_status();
+  if (entry.row_count > batcher->options.max_batch_size) {
+    // Too large to share a batch with any other request.
+    status = iree_runtime_call_invoke(call, flags);
+  } else {
+    status = iree_runtime_batcher_enqueue(batcher, &entry);
+  }
+  iree_atomic_fetch_add_int64(&batcher->call_count, 1,
+                              iree_memory_order_relaxed);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
@@ -0,0 +1,106 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_RUNTIME_BATCHER_H_
+#define IREE_RUNTIME_BATCHER_H_
+
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/runtime/call.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Dynamically batches concurrent calls to a function with a dynamic outer
+// (batch) dimension on all of its inputs and outputs.
+//
+// Each thread issuing a request populates an iree_runtime_call_t as it would
+// for a direct invocation and passes it to iree_runtime_batcher_invoke. The
+// first request to arrive opens a batch and waits up to |max_latency| for
+// other requests to join it; the batch is closed early once it reaches
+// |max_batch_size| rows. The inputs of all requests in the batch are then
+// concatenated along their outer dimension, the function is invoked once on
+// the calling thread of the first request, and each request receives
+// subspans of the batched outputs without any copies.
+//
+// Requirements on the batched function:
+//   - all inputs are densely packed buffer views with the batch as their outer
+//     dimension;
+//   - buffer view outputs have the batch as their outer dimension and are
+//     split across the requests;
+//   - any other outputs (such as primitive values) are returned to every
+//     request in the batch.
+// Requests only join a batch if their input element types and inner
+// dimensions match those of the requests already in it.
+//
+// Thread-safe; any number of threads may invoke calls through the batcher
+// concurrently.
+typedef struct iree_runtime_batcher_t iree_runtime_batcher_t;
+
+//===----------------------------------------------------------------------===//
+// iree_runtime_batcher_options_t
+//===----------------------------------------------------------------------===//
+
+// Options used to configure batcher creation.
+typedef struct iree_runtime_batcher_options_t {
+  // Maximum number of rows (the sum of the outer dimensions of the requests)
+  // in a batch. Requests with more rows than this are invoked on their own.
+  iree_host_size_t max_batch_size;
+
+  // Maximum time the first request in a batch waits for other requests to
+  // join it before the batch is invoked.
+  iree_duration_t max_latency;
+} iree_runtime_batcher_options_t;
+
+// Initializes |out_options| to its default values.
+IREE_API_EXPORT void iree_runtime_batcher_options_initialize(
+    iree_runtime_batcher_options_t* out_options);
+
+//===----------------------------------------------------------------------===//
+// iree_runtime_batcher_t
+//===----------------------------------------------------------------------===//
+
+// Creates a batcher of calls to |function| within |session|.
+// |out_batcher| must be released by the caller.
+IREE_API_EXPORT iree_status_t iree_runtime_batcher_create(
+    iree_runtime_session_t* session, iree_vm_function_t function,
+    const iree_runtime_batcher_options_t* options,
+    iree_allocator_t host_allocator, iree_runtime_batcher_t** out_batcher);
+
+// Retains the given |batcher| for the caller.
+IREE_API_EXPORT void iree_runtime_batcher_retain(
+    iree_runtime_batcher_t* batcher);
+
+// Releases the given |batcher| from the caller.
+IREE_API_EXPORT void iree_runtime_batcher_release(
+    iree_runtime_batcher_t* batcher);
+
+// Synchronously invokes |call| as part of a batch and returns the status.
+// |call| must have been initialized for the function of the batcher. Blocks
+// until the batch the call joined has completed. As with
+// iree_runtime_call_invoke the inputs list remains unchanged and the outputs
+// list is populated with the results of this call alone.
+//
+// A failure of the batched invocation is returned to every call in the batch.
+IREE_API_EXPORT iree_status_t iree_runtime_batcher_invoke(
+    iree_runtime_batcher_t* batcher, iree_runtime_call_t* call,
+    iree_runtime_call_flags_t flags);
+
+// Returns the number of batched invocations issued by the batcher.
+IREE_API_EXPORT uint64_t
+iree_runtime_batcher_batch_count(iree_runtime_batcher_t* batcher);
+
+// Returns the number of calls that have completed through the batcher.
+IREE_API_EXPORT uint64_t
+iree_runtime_batcher_call_count(iree_runtime_batcher_t* batcher);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_RUNTIME_BATCHER_H_
@@ -0,0 +1,356 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/runtime/batcher.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/local/sync_device.h"
+#include "iree/modules/hal/module.h"
+#include "iree/runtime/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+#include "iree/vm/api.h"
+
+namespace {
+
+// Number of elements in each row of the test inputs.
+constexpr iree_hal_dim_t kRowLength = 4;
+
+// Latency long enough that a batch only closes early in the tests.
+constexpr iree_duration_t kLongLatency = 10000000000ll;  // 10s
+
+//===----------------------------------------------------------------------===//
+// test module
+//===----------------------------------------------------------------------===//
+// Exports test.double(%input : !hal.buffer_view) -> !hal.buffer_view, which
+// doubles the f32 contents of |input| in place and returns it. Negative values
+// are rejected so that tests can fail a batch.
+
+typedef iree_status_t (*call_r_r_t)(iree_vm_stack_t* stack, void* module,
+                                    void* module_state, iree_vm_ref_t* arg0,
+                                    iree_vm_ref_t* out_ret0);
+
+// Wrapper for calling a |target_fn| C function with type (ref)->ref from the
+// VM ABI.
+static iree_status_t call_shim_r_r(iree_vm_stack_t* stack,
+                                   const iree_vm_function_call_t* call,
+                                   call_r_r_t target_fn, void* module,
+                                   void* module_state,
+                                   iree_vm_execution_result_t* out_result) {
+  if (call->arguments.data_length != sizeof(iree_vm_ref_t) ||
+      call->results.data_length != sizeof(iree_vm_ref_t)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "argument/result signature mismatch");
+  }
+  iree_vm_ref_t* arg0 = (iree_vm_ref_t*)call->arguments.data;
+  iree_vm_ref_t* ret0 = (iree_vm_ref_t*)call->results.data;
+  memset(ret0, 0, sizeof(*ret0));
+  return target_fn(stack, module, module_state, arg0, ret0);
+}
+
+// test.double(%input : !hal.buffer_view) -> !hal.buffer_view
+static iree_status_t test_double(iree_vm_stack_t* stack, void* module,
+                                 void* module_state, iree_vm_ref_t* arg0,
+                                 iree_vm_ref_t* out_ret0) {
+  iree_hal_buffer_view_t* buffer_view = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_view_check_deref(*arg0, &buffer_view));
+  iree_hal_buffer_t* buffer = iree_hal_buffer_view_buffer(buffer_view);
+  std::vector<float> values(iree_hal_buffer_view_element_count(buffer_view));
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_read_data(
+      buffer, 0, values.data(), values.size() * sizeof(float)));
+  for (float& value : values) {
+    if (value < 0.0f) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "negative input %f", value);
+    }
+    value *= 2.0f;
+  }
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_write_data(
+      buffer, 0, values.data(), values.size() * sizeof(float)));
+  *out_ret0 = iree_hal_buffer_view_retain_ref(buffer_view);
+  return iree_ok_status();
+}
+
+static const iree_vm_native_export_descriptor_t test_module_exports_[] = {
+    {iree_make_cstring_view("double"), iree_make_cstring_view("0r_r"), 0,
+     NULL},
+};
+static const iree_vm_native_function_ptr_t test_module_funcs_[] = {
+    {(iree_vm_native_function_shim_t)call_shim_r_r,
+     (iree_vm_native_function_target_t)test_double},
+};
+static_assert(IREE_ARRAYSIZE(test_module_funcs_) ==
+                  IREE_ARRAYSIZE(test_module_exports_),
+              "function pointer table must be 1:1 with exports");
+static const iree_vm_native_module_descriptor_t test_module_descriptor_ = {
+    iree_make_cstring_view("test"),
+    0,
+    NULL,
+    IREE_ARRAYSIZE(test_module_exports_),
+    test_module_exports_,
+    IREE_ARRAYSIZE(test_module_funcs_),
+    test_module_funcs_,
+    0,
+    NULL,
+};
+
+static iree_status_t test_module_create(iree_allocator_t allocator,
+                                        iree_vm_module_t** out_module) {
+  iree_vm_module_t interface;
+  IREE_RETURN_IF_ERROR(iree_vm_module_initialize(&interface, NULL));
+  return iree_vm_native_module_create(&interface, &test_module_descriptor_,
+                                      allocator, out_module);
+}
+
+//===----------------------------------------------------------------------===//
+// iree_runtime_batcher_t
+//===----------------------------------------------------------------------===//
+
+class BatcherTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    IREE_ASSERT_OK(iree_hal_module_register_types());
+  }
+
+  void SetUp() override {
+    iree_runtime_instance_options_t instance_options;
+    iree_runtime_instance_options_initialize(IREE_API_VERSION_LATEST,
+                                             &instance_options);
+    IREE_ASSERT_OK(iree_runtime_instance_create(
+        &instance_options, iree_allocator_system(), &instance_));
+
+    iree_hal_sync_device_params_t params;
+    iree_hal_sync_device_params_initialize(&params);
+    IREE_ASSERT_OK(iree_hal_sync_device_create(
+        iree_make_cstring_view("sync"), &params, /*loader_count=*/0,
+        /*loaders=*/NULL, iree_allocator_system(), &device_));
+
+    iree_runtime_session_options_t session_options;
+    iree_runtime_session_options_initialize(&session_options);
+    IREE_ASSERT_OK(iree_runtime_session_create_with_device(
+        instance_, &session_options, device_, iree_allocator_system(),
+        &session_));
+
+    iree_vm_module_t* module = NULL;
+    IREE_ASSERT_OK(test_module_create(iree_allocator_system(), &module));
+    iree_status_t status = iree_runtime_session_append_module(session_, module);
+    iree_vm_module_release(module);
+    IREE_ASSERT_OK(status);
+    IREE_ASSERT_OK(iree_runtime_session_lookup_function(
+        session_, iree_make_cstring_view("test.double"), &function_));
+  }
+
+  void TearDown() override {
+    iree_runtime_batcher_release(batcher_);
+    iree_runtime_session_release(session_);
+    iree_hal_device_release(device_);
+    iree_runtime_instance_release(instance_);
+  }
+
+  void CreateBatcher(iree_host_size_t max_batch_size,
+                     iree_duration_t max_latency) {
+    iree_runtime_batcher_options_t options;
+    iree_runtime_batcher_options_initialize(&options);
+    options.max_batch_size = max_batch_size;
+    options.max_latency = max_latency;
+    IREE_ASSERT_OK(iree_runtime_batcher_create(
+        session_, function_, &options, iree_allocator_system(), &batcher_));
+  }
+
+  // Invokes test.double through the batcher with |values| as the input of
+  // shape [|row_count|, |row_length|] and returns the output in |out_values|.
+  iree_status_t Invoke(const std::vector<float>& values,
+                       iree_hal_dim_t row_count, iree_hal_dim_t row_length,
+                       std::vector<float>* out_values) {
+    iree_runtime_call_t call;
+    IREE_RETURN_IF_ERROR(
+        iree_runtime_call_initialize(session_, function_, &call));
+    iree_hal_buffer_t* buffer = NULL;
+    iree_hal_buffer_view_t* buffer_view = NULL;
+    iree_status_t status = iree_hal_allocator_allocate_buffer(
+        iree_hal_device_allocator(device_),
+        IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE,
+        IREE_HAL_BUFFER_USAGE_ALL, values.size() * sizeof(float), &buffer);
+    if (iree_status_is_ok(status)) {
+      status = iree_hal_buffer_write_data(buffer, 0, values.data(),
+                                          values.size() * sizeof(float));
+    }
+    if (iree_status_is_ok(status)) {
+      const iree_hal_dim_t shape[2] = {row_count, row_length};
+      status = iree_hal_buffer_view_create(
+          buffer, shape, IREE_ARRAYSIZE(shape), IREE_HAL_ELEMENT_TYPE_FLOAT_32,
+          IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR, &buffer_view);
+    }
+    iree_hal_buffer_release(buffer);
+    if (iree_status_is_ok(status)) {
+      status =
+          iree_runtime_call_inputs_push_back_buffer_view(&call, buffer_view);
+    }
+    iree_hal_buffer_view_release(buffer_view);
+
+    if (iree_status_is_ok(status)) {
+      status = iree_runtime_batcher_invoke(batcher_, &call, /*flags=*/0);
+    }
+
+    iree_hal_buffer_view_t* output = NULL;
+    if (iree_status_is_ok(status)) {
+      status = iree_runtime_call_outputs_pop_front_buffer_view(&call, &output);
+    }
+    if (iree_status_is_ok(status)) {
+      EXPECT_EQ(row_count, iree_hal_buffer_view_shape_dim(output, 0));
+      out_values->resize(iree_hal_buffer_view_element_count(output));
+      status = iree_hal_buffer_read_data(iree_hal_buffer_view_buffer(output),
+                                         0, out_values->data(),
+                                         out_values->size() * sizeof(float));
+    }
+    iree_hal_buffer_view_release(output);
+    iree_runtime_call_deinitialize(&call);
+    return status;
+  }
+
+  // Returns |row_count| rows of values unique to |id|.
+  static std::vector<float> MakeRows(int id, iree_hal_dim_t row_count) {
+    std::vector<float> values(row_count * kRowLength);
+    for (size_t i = 0; i < values.size(); ++i) {
+      values[i] = (float)(id * 100 + i);
+    }
+    return values;
+  }
+
+  static std::vector<float> Doubled(std::vector<float> values) {
+    for (float& value : values) value *= 2.0f;
+    return values;
+  }
+
+  iree_runtime_instance_t* instance_ = NULL;
+  iree_hal_device_t* device_ = NULL;
+  iree_runtime_session_t* session_ = NULL;
+  iree_vm_function_t function_;
+  iree_runtime_batcher_t* batcher_ = NULL;
+};
+
+// Concurrent requests are invoked as a single batch and each receives its own
+// rows of the output.
+TEST_F(BatcherTest, BatchesConcurrentRequests) {
+  constexpr int kRequestCount = 4;
+  CreateBatcher(kRequestCount, kLongLatency);
+  std::vector<std::thread> threads;
+  std::vector<std::vector<float>> outputs(kRequestCount);
+  std::atomic<int> ok_count{0};
+  for (int i = 0; i < kRequestCount; ++i) {
+    threads.emplace_back([&, i]() {
+      iree_status_t status = Invoke(MakeRows(i, 1), 1, kRowLength, &outputs[i]);
+      if (iree_status_is_ok(status)) ++ok_count;
+      iree_status_ignore(status);
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  EXPECT_EQ(kRequestCount, ok_count.load());
+  EXPECT_EQ(1u, iree_runtime_batcher_batch_count(batcher_));
+  EXPECT_EQ(kRequestCount, iree_runtime_batcher_call_count(batcher_));
+  for (int i = 0; i < kRequestCount; ++i) {
+    EXPECT_EQ(Doubled(MakeRows(i, 1)), outputs[i]);
+  }
+}
+
+// A request that is not joined by any other is invoked once its latency
+// elapses.
+TEST_F(BatcherTest, FlushesAfterLatency) {
+  CreateBatcher(/*max_batch_size=*/4, /*max_latency=*/1000000);  // 1ms
+  std::vector<float> output;
+  IREE_ASSERT_OK(Invoke(MakeRows(1, 1), 1, kRowLength, &output));
+  EXPECT_EQ(Doubled(MakeRows(1, 1)), output);
+  EXPECT_EQ(1u, iree_runtime_batcher_batch_count(batcher_));
+}
+
+// A request that cannot join the open batch issues it immediately instead of
+// making it wait out its latency.
+TEST_F(BatcherTest, FlushesOpenBatchOnRequestThatDoesNotFit) {
+  CreateBatcher(/*max_batch_size=*/4, kLongLatency);
+  auto start_time = std::chrono::steady_clock::now();
+  std::vector<float> first_output;
+  std::thread first_thread([&]() {
+    IREE_EXPECT_OK(Invoke(MakeRows(1, 1), 1, kRowLength, &first_output));
+  });
+  // Wait for the first request to open a batch.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  // A full batch of its own does not fit in the open batch and does not wait
+  // for other requests to join it.
+  std::vector<float> second_output;
+  IREE_ASSERT_OK(Invoke(MakeRows(2, 4), 4, kRowLength, &second_output));
+  first_thread.join();
+
+  EXPECT_LT(std::chrono::steady_clock::now() - start_time,
+            std::chrono::seconds(5));
+  EXPECT_EQ(Doubled(MakeRows(1, 1)), first_output);
+  EXPECT_EQ(Doubled(MakeRows(2, 4)), second_output);
+  EXPECT_EQ(2u, iree_runtime_batcher_batch_count(batcher_));
+  EXPECT_EQ(2u, iree_runtime_batcher_call_count(batcher_));
+}
+
+// Requests whose inner dimensions differ from the open batch cannot be
+// concatenated with it and start a new batch.
+TEST_F(BatcherTest, FlushesOpenBatchOnIncompatibleRequest) {
+  CreateBatcher(/*max_batch_size=*/2, kLongLatency);
+  std::vector<float> first_output;
+  std::thread first_thread([&]() {
+    IREE_EXPECT_OK(Invoke(MakeRows(1, 1), 1, kRowLength, &first_output));
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  std::vector<float> second_input(2 * (kRowLength + 1), 3.0f);
+  std::vector<float> second_output;
+  IREE_ASSERT_OK(Invoke(second_input, 2, kRowLength + 1, &second_output));
+  first_thread.join();
+
+  EXPECT_EQ(Doubled(MakeRows(1, 1)), first_output);
+  EXPECT_EQ(Doubled(second_input), second_output);
+  EXPECT_EQ(2u, iree_runtime_batcher_batch_count(batcher_));
+}
+
+// Requests larger than the maximum batch size are invoked on their own without
+// waiting.
+TEST_F(BatcherTest, InvokesOversizedRequestDirectly) {
+  CreateBatcher(/*max_batch_size=*/2, kLongLatency);
+  std::vector<float> output;
+  IREE_ASSERT_OK(Invoke(MakeRows(1, 3), 3, kRowLength, &output));
+  EXPECT_EQ(Doubled(MakeRows(1, 3)), output);
+  EXPECT_EQ(0u, iree_runtime_batcher_batch_count(batcher_));
+  EXPECT_EQ(1u, iree_runtime_batcher_call_count(batcher_));
+}
+
+// A failure of the batched invocation is returned to every request in the
+// batch.
+TEST_F(BatcherTest, PropagatesFailureToAllRequests) {
+  constexpr int kRequestCount = 4;
+  CreateBatcher(kRequestCount, kLongLatency);
+  std::vector<std::thread> threads;
+  std::atomic<int> invalid_count{0};
+  for (int i = 0; i < kRequestCount; ++i) {
+    threads.emplace_back([&, i]() {
+      std::vector<float> input = MakeRows(i, 1);
+      if (i == 2) input[1] = -1.0f;
+      std::vector<float> output;
+      iree_status_t status = Invoke(input, 1, kRowLength, &output);
+      if (iree_status_is_invalid_argument(status)) ++invalid_count;
+      iree_status_ignore(status);
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  EXPECT_EQ(kRequestCount, invalid_count.load());
+  EXPECT_EQ(1u, iree_runtime_batcher_batch_count(batcher_));
+}
+
+}  // namespace
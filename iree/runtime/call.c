@@ -10,6 +10,7 @@
 #include <string.h>
 
 #include "iree/base/api.h"
+#include "iree/base/tracing.h"
 #include "iree/modules/hal/module.h"
 #include "iree/runtime/session.h"
 
@@ -68,6 +69,7 @@ IREE_API_EXPORT iree_status_t iree_runtime_call_initialize_by_name(
 
 IREE_API_EXPORT void iree_runtime_call_deinitialize(iree_runtime_call_t* call) {
   IREE_ASSERT_ARGUMENT(call);
+  iree_vm_invocation_release(call->invocation);
   iree_vm_list_release(call->inputs);
   iree_vm_list_release(call->outputs);
   iree_runtime_session_release(call->session);
@@ -79,6 +81,12 @@ IREE_API_EXPORT void iree_runtime_call_reset(iree_runtime_call_t* call) {
   iree_status_ignore(iree_vm_list_resize(call->outputs, 0));
 }
 
+IREE_API_EXPORT void iree_runtime_call_reset_outputs(
+    iree_runtime_call_t* call) {
+  IREE_ASSERT_ARGUMENT(call);
+  iree_status_ignore(iree_vm_list_resize(call->outputs, 0));
+}
+
 IREE_API_EXPORT iree_vm_list_t* iree_runtime_call_inputs(
     const iree_runtime_call_t* call) {
   IREE_ASSERT_ARGUMENT(call);
@@ -97,6 +105,93 @@ IREE_API_EXPORT iree_status_t iree_runtime_call_invoke(
                                    call->outputs);
 }
 
+// Completes the in-flight invocation of |call| by moving its outputs into the
+// call outputs list and issuing the callback. Returns the result of the call.
+static iree_status_t iree_runtime_call_complete(iree_runtime_call_t* call) {
+  iree_vm_invocation_t* invocation = call->invocation;
+  iree_runtime_call_callback_t callback = call->callback;
+  call->invocation = NULL;
+  call->callback = iree_runtime_call_callback_null();
+
+  iree_status_t status = iree_vm_invocation_query_status(invocation);
+  if (iree_status_is_ok(status)) {
+    const iree_vm_list_t* outputs = iree_vm_invocation_output(invocation);
+    iree_host_size_t output_count = iree_vm_list_size(outputs);
+    status = iree_vm_list_resize(call->outputs, output_count);
+    if (iree_status_is_ok(status)) {
+      status = iree_vm_list_copy(outputs, 0, call->outputs, 0, output_count);
+    }
+  }
+  iree_vm_invocation_release(invocation);
+
+  if (callback.fn) callback.fn(callback.user_data, call, status);
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t iree_runtime_call_invoke_async(
+    iree_runtime_call_t* call, iree_runtime_call_flags_t flags,
+    iree_runtime_call_callback_t callback) {
+  IREE_ASSERT_ARGUMENT(call);
+  if (call->invocation) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "an asynchronous invocation of the call is "
+                            "already in flight");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_runtime_session_call_async(call->session, &call->function,
+                                          call->inputs, &call->invocation));
+  call->callback = callback;
+
+  // Calls that run to completion without yielding complete immediately.
+  iree_status_t status = iree_vm_invocation_query_status(call->invocation);
+  bool is_pending = iree_status_is_unavailable(status);
+  iree_status_ignore(status);
+  if (!is_pending) iree_status_ignore(iree_runtime_call_complete(call));
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT bool iree_runtime_call_is_pending(
+    const iree_runtime_call_t* call) {
+  IREE_ASSERT_ARGUMENT(call);
+  return call->invocation != NULL;
+}
+
+IREE_API_EXPORT iree_status_t
+iree_runtime_call_poll(iree_runtime_call_t* call) {
+  IREE_ASSERT_ARGUMENT(call);
+  if (!call->invocation) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "no asynchronous invocation in flight");
+  }
+  iree_status_t status = iree_vm_invocation_resume(call->invocation);
+  if (iree_status_is_unavailable(status)) return status;
+  iree_status_ignore(status);
+  return iree_runtime_call_complete(call);
+}
+
+IREE_API_EXPORT iree_status_t iree_runtime_call_await(iree_runtime_call_t* call,
+                                                      iree_time_t deadline) {
+  IREE_ASSERT_ARGUMENT(call);
+  if (!call->invocation) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "no asynchronous invocation in flight");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_status_t status = iree_vm_invocation_await(call->invocation, deadline);
+  if (iree_status_is_deadline_exceeded(status)) {
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+  iree_status_ignore(status);
+  status = iree_runtime_call_complete(call);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 //===----------------------------------------------------------------------===//
 // Helpers for defining call I/O
 //===----------------------------------------------------------------------===//
@@ -111,6 +206,29 @@ IREE_API_EXPORT iree_status_t iree_runtime_call_inputs_push_back_buffer_view(
   return iree_vm_list_push_ref_retain(call->inputs, &value);
 }
 
+IREE_API_EXPORT iree_status_t iree_runtime_call_inputs_set_buffer_view(
+    iree_runtime_call_t* call, iree_host_size_t i,
+    iree_hal_buffer_view_t* buffer_view) {
+  IREE_ASSERT_ARGUMENT(call);
+  IREE_ASSERT_ARGUMENT(buffer_view);
+  iree_vm_ref_t value = {0};
+  IREE_RETURN_IF_ERROR(iree_vm_ref_wrap_assign(
+      buffer_view, iree_hal_buffer_view_type_id(), &value));
+  return iree_vm_list_set_ref_retain(call->inputs, i, &value);
+}
+
+IREE_API_EXPORT iree_status_t iree_runtime_call_inputs_push_back_output_storage(
+    iree_runtime_call_t* call, iree_hal_buffer_view_t* buffer_view) {
+  IREE_ASSERT_ARGUMENT(call);
+  IREE_ASSERT_ARGUMENT(buffer_view);
+  iree_hal_buffer_t* buffer = iree_hal_buffer_view_buffer(buffer_view);
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_validate_access(
+      iree_hal_buffer_allowed_access(buffer), IREE_HAL_MEMORY_ACCESS_WRITE));
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_validate_usage(
+      iree_hal_buffer_allowed_usage(buffer), IREE_HAL_BUFFER_USAGE_TRANSFER));
+  return iree_runtime_call_inputs_push_back_buffer_view(call, buffer_view);
+}
+
 // Pops a buffer view from the front of the call outputs list.
 // Ownership of the buffer view transfers to the caller.
 IREE_API_EXPORT iree_status_t iree_runtime_call_outputs_pop_front_buffer_view(
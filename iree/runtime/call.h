@@ -32,6 +32,31 @@ enum iree_runtime_call_flag_bits_t {
 };
 typedef uint32_t iree_runtime_call_flags_t;
 
+typedef struct iree_runtime_call_t iree_runtime_call_t;
+
+// Callback issued when an asynchronous call completes.
+// |status| is the result of the call and is borrowed for the duration of the
+// callback; the same status is returned to whoever drove the call to
+// completion with iree_runtime_call_poll or iree_runtime_call_await. The
+// outputs of a successful call are available from iree_runtime_call_outputs.
+typedef void(IREE_API_PTR* iree_runtime_call_callback_fn_t)(
+    void* user_data, iree_runtime_call_t* call, iree_status_t status);
+
+// A completion callback for an asynchronous call.
+typedef struct iree_runtime_call_callback_t {
+  // Function called when the call completes or NULL for no callback.
+  iree_runtime_call_callback_fn_t fn;
+  // User data passed to |fn|.
+  void* user_data;
+} iree_runtime_call_callback_t;
+
+// Returns a callback that does nothing.
+static inline iree_runtime_call_callback_t iree_runtime_call_callback_null(
+    void) {
+  iree_runtime_call_callback_t callback = {NULL, NULL};
+  return callback;
+}
+
 // A stateful VM function call builder.
 //
 // Applications that will be calling the same function repeatedly can reuse the
@@ -41,14 +66,24 @@ typedef uint32_t iree_runtime_call_flags_t;
 // call like this callers are required to either reset the call, copy their
 // data out, or reset the particular output they are consuming.
 //
+// Calls may also be pinned: applications that pass the same buffer views on
+// every request and only update their contents can populate the inputs once
+// and use iree_runtime_call_reset_outputs between invocations. The lists keep
+// their storage across calls, making the runtime side of the steady-state call
+// path free of host allocations.
+//
 // Thread-compatible; these are designed to be stack-local or embedded in a user
 // data structure that can provide synchronization when required.
-typedef struct iree_runtime_call_t {
+struct iree_runtime_call_t {
   iree_runtime_session_t* session;
   iree_vm_function_t function;
   iree_vm_list_t* inputs;
   iree_vm_list_t* outputs;
-} iree_runtime_call_t;
+  // In-flight asynchronous invocation or NULL if none is pending.
+  iree_vm_invocation_t* invocation;
+  // Callback issued when |invocation| completes.
+  iree_runtime_call_callback_t callback;
+};
 
 // Initializes call state for a call to |function| within |session|.
 IREE_API_EXPORT iree_status_t iree_runtime_call_initialize(
@@ -69,12 +104,17 @@ IREE_API_EXPORT iree_status_t iree_runtime_call_initialize_by_name(
     iree_runtime_call_t* out_call);
 
 // Deinitializes a call by releasing its input and output lists.
+// Any in-flight asynchronous call is aborted without issuing its callback.
 IREE_API_EXPORT void iree_runtime_call_deinitialize(iree_runtime_call_t* call);
 
 // Resets the input and output lists back to 0-length in preparation for
 // construction of another call.
 IREE_API_EXPORT void iree_runtime_call_reset(iree_runtime_call_t* call);
 
+// Resets the output list back to 0-length while retaining the inputs so that
+// a pinned call can be invoked again with the same arguments.
+IREE_API_EXPORT void iree_runtime_call_reset_outputs(iree_runtime_call_t* call);
+
 // Returns an initially-empty variant list for passing in function inputs.
 // The list must be fully populated based on the required arguments of the
 // function.
@@ -92,6 +132,53 @@ IREE_API_EXPORT iree_vm_list_t* iree_runtime_call_outputs(
 IREE_API_EXPORT iree_status_t iree_runtime_call_invoke(
     iree_runtime_call_t* call, iree_runtime_call_flags_t flags);
 
+// Asynchronously invokes the call.
+//
+// The call begins executing on the calling thread and runs until it either
+// completes or yields waiting on device work (such as a HAL semaphore) that
+// has not yet completed. Yielded calls hold no thread and are continued with
+// iree_runtime_call_poll or iree_runtime_call_await, allowing a single host
+// thread to keep many calls in flight (one per iree_runtime_call_t) by polling
+// each of them from its event loop. The inputs list is consumed before this
+// returns and may be reset or reused immediately; the outputs list is
+// populated when the call completes.
+//
+// |callback| is issued on the thread that completes the call, which may be
+// this one if the call completes without yielding. Only one asynchronous
+// invocation may be in flight per call at a time.
+//
+// Only failures to begin the call are returned here; failures during execution
+// are reported to |callback| and returned from the poll or await that
+// completes the call.
+IREE_API_EXPORT iree_status_t iree_runtime_call_invoke_async(
+    iree_runtime_call_t* call, iree_runtime_call_flags_t flags,
+    iree_runtime_call_callback_t callback);
+
+// Returns true if an asynchronous invocation of |call| is in flight.
+IREE_API_EXPORT bool iree_runtime_call_is_pending(
+    const iree_runtime_call_t* call);
+
+// Makes progress on the in-flight asynchronous invocation of |call| without
+// blocking the calling thread. If the call has yielded and whatever it is
+// waiting on has completed it is resumed on the calling thread until it yields
+// again or completes.
+//
+// Returns IREE_STATUS_UNAVAILABLE if the call is still in flight and otherwise
+// the result of the call after its callback has been issued.
+// Returns IREE_STATUS_FAILED_PRECONDITION if no call is in flight.
+IREE_API_EXPORT iree_status_t iree_runtime_call_poll(iree_runtime_call_t* call);
+
+// Blocks the caller until the in-flight asynchronous invocation of |call|
+// completes or |deadline| elapses, resuming the call on the calling thread as
+// needed.
+//
+// Returns IREE_STATUS_DEADLINE_EXCEEDED if the call is still in flight when
+// |deadline| elapses and otherwise the result of the call after its callback
+// has been issued.
+// Returns IREE_STATUS_FAILED_PRECONDITION if no call is in flight.
+IREE_API_EXPORT iree_status_t iree_runtime_call_await(iree_runtime_call_t* call,
+                                                      iree_time_t deadline);
+
 //===----------------------------------------------------------------------===//
 // Helpers for defining call I/O
 //===----------------------------------------------------------------------===//
@@ -106,6 +193,22 @@ IREE_API_EXPORT iree_status_t iree_runtime_call_invoke(
 IREE_API_EXPORT iree_status_t iree_runtime_call_inputs_push_back_buffer_view(
     iree_runtime_call_t* call, iree_hal_buffer_view_t* buffer_view);
 
+// Replaces input |i| of the call with |buffer_view| in-place.
+// The value will be retained by the list and the prior value released.
+IREE_API_EXPORT iree_status_t iree_runtime_call_inputs_set_buffer_view(
+    iree_runtime_call_t* call, iree_host_size_t i,
+    iree_hal_buffer_view_t* buffer_view);
+
+// Pushes caller-provided |buffer_view| storage for the next output of the call
+// declared with the `iree.abi.output_storage` result attribute. Storage inputs
+// follow all other inputs of the call in output order and must match the shape
+// of the output they receive. The output is written directly into the storage
+// and the buffer view popped from the outputs list references the same
+// buffer, so reusing storage across calls avoids allocating each output.
+// The value will be retained by the list.
+IREE_API_EXPORT iree_status_t iree_runtime_call_inputs_push_back_output_storage(
+    iree_runtime_call_t* call, iree_hal_buffer_view_t* buffer_view);
+
 // Pops a buffer view from the front of the call outputs list.
 // Ownership of the buffer view transfers to the caller.
 IREE_API_EXPORT iree_status_t iree_runtime_call_outputs_pop_front_buffer_view(
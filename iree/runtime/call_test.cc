@@ -0,0 +1,332 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/runtime/call.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/local/sync_device.h"
+#include "iree/modules/hal/module.h"
+#include "iree/runtime/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+#include "iree/vm/api.h"
+
+namespace {
+
+//===----------------------------------------------------------------------===//
+// test module
+//===----------------------------------------------------------------------===//
+// Exports test.add_1(%arg0 : i32) -> i32, which yields until the gate of the
+// module is opened and then returns |arg0| + 1. Negative arguments fail once
+// the call is resumed.
+
+// Gate the calls of the test module wait on.
+struct Gate {
+  std::atomic<bool> is_open{false};
+};
+
+// Waits for the Gate at |payload| to open or |deadline_ns| to elapse.
+static iree_status_t IREE_API_PTR gate_wait(iree_vm_ref_t* ref,
+                                            uint64_t payload,
+                                            iree_time_t deadline_ns) {
+  Gate* gate = (Gate*)(uintptr_t)payload;
+  while (!gate->is_open.load()) {
+    if (iree_time_now() >= deadline_ns) {
+      return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return iree_ok_status();
+}
+
+// Completes the call by replacing the argument stashed in the results with the
+// result.
+static iree_status_t test_module_complete(const iree_vm_function_call_t* call) {
+  int32_t* ret0 = (int32_t*)call->results.data;
+  if (*ret0 < 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT, "negative argument");
+  }
+  *ret0 += 1;
+  return iree_ok_status();
+}
+
+static iree_status_t IREE_API_PTR test_module_begin_call(
+    void* self, iree_vm_stack_t* stack, const iree_vm_function_call_t* call,
+    iree_vm_execution_result_t* out_result) {
+  Gate* gate = (Gate*)self;
+  if (call->arguments.data_length != sizeof(int32_t) ||
+      call->results.data_length != sizeof(int32_t)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "argument/result signature mismatch");
+  }
+  // The results persist across yields while the arguments do not.
+  memcpy(call->results.data, call->arguments.data, sizeof(int32_t));
+  if (gate->is_open.load()) return test_module_complete(call);
+  out_result->flags = IREE_VM_EXECUTION_RESULT_FLAG_YIELDED |
+                      IREE_VM_EXECUTION_RESULT_FLAG_WAITING;
+  out_result->wait.wait_fn = gate_wait;
+  out_result->wait.payload = (uint64_t)(uintptr_t)gate;
+  return iree_ok_status();
+}
+
+static iree_status_t IREE_API_PTR test_module_resume_call(
+    void* self, iree_vm_stack_t* stack, const iree_vm_function_call_t* call,
+    iree_vm_execution_result_t* out_result) {
+  out_result->flags = IREE_VM_EXECUTION_RESULT_FLAG_NONE;
+  return test_module_complete(call);
+}
+
+static const iree_vm_native_export_descriptor_t test_module_exports_[] = {
+    {iree_make_cstring_view("add_1"), iree_make_cstring_view("0i_i"), 0, NULL},
+};
+static const iree_vm_native_module_descriptor_t test_module_descriptor_ = {
+    iree_make_cstring_view("test"),
+    0,
+    NULL,
+    IREE_ARRAYSIZE(test_module_exports_),
+    test_module_exports_,
+    0,
+    NULL,
+    0,
+    NULL,
+};
+
+static iree_status_t test_module_create(Gate* gate, iree_allocator_t allocator,
+                                        iree_vm_module_t** out_module) {
+  iree_vm_module_t interface;
+  IREE_RETURN_IF_ERROR(iree_vm_module_initialize(&interface, gate));
+  interface.begin_call = test_module_begin_call;
+  interface.resume_call = test_module_resume_call;
+  return iree_vm_native_module_create(&interface, &test_module_descriptor_,
+                                      allocator, out_module);
+}
+
+//===----------------------------------------------------------------------===//
+// iree_runtime_call_t
+//===----------------------------------------------------------------------===//
+
+// Records the callbacks issued for a call.
+struct CallbackState {
+  int count = 0;
+  iree_status_code_t status_code = IREE_STATUS_OK;
+  int32_t result = 0;
+
+  iree_runtime_call_callback_t callback() { return {Callback, this}; }
+
+  static void IREE_API_PTR Callback(void* user_data, iree_runtime_call_t* call,
+                                    iree_status_t status) {
+    CallbackState* state = (CallbackState*)user_data;
+    ++state->count;
+    state->status_code = iree_status_code(status);
+    if (iree_status_is_ok(status)) {
+      iree_vm_value_t value;
+      IREE_EXPECT_OK(
+          iree_vm_list_get_value(iree_runtime_call_outputs(call), 0, &value));
+      state->result = value.i32;
+    }
+  }
+};
+
+class CallAsyncTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    IREE_ASSERT_OK(iree_hal_module_register_types());
+  }
+
+  void SetUp() override {
+    iree_runtime_instance_options_t instance_options;
+    iree_runtime_instance_options_initialize(IREE_API_VERSION_LATEST,
+                                             &instance_options);
+    IREE_ASSERT_OK(iree_runtime_instance_create(
+        &instance_options, iree_allocator_system(), &instance_));
+
+    iree_hal_sync_device_params_t params;
+    iree_hal_sync_device_params_initialize(&params);
+    IREE_ASSERT_OK(iree_hal_sync_device_create(
+        iree_make_cstring_view("sync"), &params, /*loader_count=*/0,
+        /*loaders=*/NULL, iree_allocator_system(), &device_));
+
+    iree_runtime_session_options_t session_options;
+    iree_runtime_session_options_initialize(&session_options);
+    IREE_ASSERT_OK(iree_runtime_session_create_with_device(
+        instance_, &session_options, device_, iree_allocator_system(),
+        &session_));
+
+    iree_vm_module_t* module = NULL;
+    IREE_ASSERT_OK(
+        test_module_create(&gate_, iree_allocator_system(), &module));
+    iree_status_t status = iree_runtime_session_append_module(session_, module);
+    iree_vm_module_release(module);
+    IREE_ASSERT_OK(status);
+  }
+
+  void TearDown() override {
+    iree_runtime_session_release(session_);
+    iree_hal_device_release(device_);
+    iree_runtime_instance_release(instance_);
+  }
+
+  // Initializes |out_call| as a call to test.add_1 with |arg0|.
+  void InitializeCall(int32_t arg0, iree_runtime_call_t* out_call) {
+    IREE_ASSERT_OK(iree_runtime_call_initialize_by_name(
+        session_, iree_make_cstring_view("test.add_1"), out_call));
+    iree_vm_value_t value = iree_vm_value_make_i32(arg0);
+    IREE_ASSERT_OK(
+        iree_vm_list_push_value(iree_runtime_call_inputs(out_call), &value));
+  }
+
+  static int32_t GetResult(iree_runtime_call_t* call) {
+    iree_vm_value_t value;
+    IREE_CHECK_OK(
+        iree_vm_list_get_value(iree_runtime_call_outputs(call), 0, &value));
+    return value.i32;
+  }
+
+  Gate gate_;
+  iree_runtime_instance_t* instance_ = NULL;
+  iree_hal_device_t* device_ = NULL;
+  iree_runtime_session_t* session_ = NULL;
+};
+
+// Calls that do not yield complete before iree_runtime_call_invoke_async
+// returns.
+TEST_F(CallAsyncTest, CompletesWithoutYielding) {
+  gate_.is_open = true;
+  iree_runtime_call_t call;
+  InitializeCall(1, &call);
+  CallbackState state;
+  IREE_ASSERT_OK(iree_runtime_call_invoke_async(&call, 0, state.callback()));
+  EXPECT_FALSE(iree_runtime_call_is_pending(&call));
+  EXPECT_EQ(1, state.count);
+  EXPECT_EQ(IREE_STATUS_OK, state.status_code);
+  EXPECT_EQ(2, state.result);
+  EXPECT_EQ(2, GetResult(&call));
+  iree_runtime_call_deinitialize(&call);
+}
+
+// Polling a yielded call does not block and completes it once its wait is
+// satisfied.
+TEST_F(CallAsyncTest, PollCompletesYieldedCall) {
+  iree_runtime_call_t call;
+  InitializeCall(1, &call);
+  CallbackState state;
+  IREE_ASSERT_OK(iree_runtime_call_invoke_async(&call, 0, state.callback()));
+  EXPECT_TRUE(iree_runtime_call_is_pending(&call));
+  EXPECT_EQ(IREE_STATUS_UNAVAILABLE,
+            iree_status_consume_code(iree_runtime_call_poll(&call)));
+  EXPECT_TRUE(iree_runtime_call_is_pending(&call));
+  EXPECT_EQ(0, state.count);
+
+  gate_.is_open = true;
+  IREE_ASSERT_OK(iree_runtime_call_poll(&call));
+  EXPECT_FALSE(iree_runtime_call_is_pending(&call));
+  EXPECT_EQ(1, state.count);
+  EXPECT_EQ(IREE_STATUS_OK, state.status_code);
+  EXPECT_EQ(2, state.result);
+  EXPECT_EQ(2, GetResult(&call));
+  iree_runtime_call_deinitialize(&call);
+}
+
+// Awaiting a call blocks until its wait is satisfied or the deadline elapses.
+TEST_F(CallAsyncTest, AwaitCompletesYieldedCall) {
+  iree_runtime_call_t call;
+  InitializeCall(1, &call);
+  CallbackState state;
+  IREE_ASSERT_OK(iree_runtime_call_invoke_async(&call, 0, state.callback()));
+  EXPECT_EQ(IREE_STATUS_DEADLINE_EXCEEDED,
+            iree_status_consume_code(iree_runtime_call_await(
+                &call, iree_relative_timeout_to_deadline_ns(10000000))));
+  EXPECT_TRUE(iree_runtime_call_is_pending(&call));
+  EXPECT_EQ(0, state.count);
+
+  std::thread opener([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    gate_.is_open = true;
+  });
+  IREE_ASSERT_OK(iree_runtime_call_await(&call, IREE_TIME_INFINITE_FUTURE));
+  opener.join();
+  EXPECT_FALSE(iree_runtime_call_is_pending(&call));
+  EXPECT_EQ(1, state.count);
+  EXPECT_EQ(2, GetResult(&call));
+  iree_runtime_call_deinitialize(&call);
+}
+
+// A single thread can keep many calls in flight by polling each of them.
+TEST_F(CallAsyncTest, PollsManyCallsFromOneThread) {
+  constexpr int kCallCount = 8;
+  iree_runtime_call_t calls[kCallCount];
+  CallbackState states[kCallCount];
+  for (int i = 0; i < kCallCount; ++i) {
+    InitializeCall(i, &calls[i]);
+    IREE_ASSERT_OK(
+        iree_runtime_call_invoke_async(&calls[i], 0, states[i].callback()));
+  }
+  for (int i = 0; i < kCallCount; ++i) {
+    EXPECT_EQ(IREE_STATUS_UNAVAILABLE,
+              iree_status_consume_code(iree_runtime_call_poll(&calls[i])));
+  }
+  gate_.is_open = true;
+  for (int i = 0; i < kCallCount; ++i) {
+    IREE_ASSERT_OK(iree_runtime_call_poll(&calls[i]));
+    EXPECT_EQ(1, states[i].count);
+    EXPECT_EQ(i + 1, states[i].result);
+    iree_runtime_call_deinitialize(&calls[i]);
+  }
+}
+
+// Failures during execution are reported to the callback and returned from the
+// poll that completes the call.
+TEST_F(CallAsyncTest, ReportsFailure) {
+  iree_runtime_call_t call;
+  InitializeCall(-1, &call);
+  CallbackState state;
+  IREE_ASSERT_OK(iree_runtime_call_invoke_async(&call, 0, state.callback()));
+  gate_.is_open = true;
+  EXPECT_EQ(IREE_STATUS_INVALID_ARGUMENT,
+            iree_status_consume_code(iree_runtime_call_poll(&call)));
+  EXPECT_FALSE(iree_runtime_call_is_pending(&call));
+  EXPECT_EQ(1, state.count);
+  EXPECT_EQ(IREE_STATUS_INVALID_ARGUMENT, state.status_code);
+  iree_runtime_call_deinitialize(&call);
+}
+
+// Only one asynchronous invocation may be in flight per call and there must be
+// one to poll or await.
+TEST_F(CallAsyncTest, RequiresOneInvocationInFlight) {
+  iree_runtime_call_t call;
+  InitializeCall(1, &call);
+  EXPECT_EQ(IREE_STATUS_FAILED_PRECONDITION,
+            iree_status_consume_code(iree_runtime_call_poll(&call)));
+  EXPECT_EQ(IREE_STATUS_FAILED_PRECONDITION,
+            iree_status_consume_code(
+                iree_runtime_call_await(&call, IREE_TIME_INFINITE_PAST)));
+  IREE_ASSERT_OK(iree_runtime_call_invoke_async(
+      &call, 0, iree_runtime_call_callback_null()));
+  EXPECT_EQ(IREE_STATUS_FAILED_PRECONDITION,
+            iree_status_consume_code(iree_runtime_call_invoke_async(
+                &call, 0, iree_runtime_call_callback_null())));
+  iree_runtime_call_deinitialize(&call);
+}
+
+// Deinitializing a call aborts its in-flight invocation without issuing the
+// callback.
+TEST_F(CallAsyncTest, DeinitializeAbortsWithoutCallback) {
+  iree_runtime_call_t call;
+  InitializeCall(1, &call);
+  CallbackState state;
+  IREE_ASSERT_OK(iree_runtime_call_invoke_async(&call, 0, state.callback()));
+  iree_runtime_call_deinitialize(&call);
+  EXPECT_EQ(0, state.count);
+}
+
+}  // namespace
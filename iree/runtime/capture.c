@@ -0,0 +1,449 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/runtime/capture.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/file_path.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+#include "iree/modules/hal/module.h"
+
+//===----------------------------------------------------------------------===//
+// iree_runtime_capture_options_t
+//===----------------------------------------------------------------------===//
+
+IREE_API_EXPORT void iree_runtime_capture_options_initialize(
+    iree_runtime_capture_options_t* out_options) {
+  memset(out_options, 0, sizeof(*out_options));
+  out_options->sample_period = 1;
+}
+
+//===----------------------------------------------------------------------===//
+// iree_runtime_capture_t
+//===----------------------------------------------------------------------===//
+
+struct iree_runtime_capture_t {
+  iree_atomic_ref_count_t ref_count;
+  iree_allocator_t host_allocator;
+  iree_runtime_capture_options_t options;
+
+  // Incremented for every call made through any attached session.
+  iree_atomic_int64_t call_counter;
+  iree_atomic_int64_t recorded_call_count;
+  iree_atomic_int64_t dropped_call_count;
+  // Set once |max_file_size| has been reached to stop sampling.
+  iree_atomic_int32_t is_full;
+
+  // Guards all fields below.
+  iree_slim_mutex_t mutex;
+  FILE* file;
+  uint64_t file_size;
+  // Number of bytecode modules written next to the trace.
+  uint32_t module_count;
+
+  // Path of the trace file (owned by the capture allocation).
+  iree_string_view_t path;
+};
+
+IREE_API_EXPORT iree_status_t iree_runtime_capture_create(
+    const char* path, const iree_runtime_capture_options_t* options,
+    iree_allocator_t host_allocator, iree_runtime_capture_t** out_capture) {
+  IREE_ASSERT_ARGUMENT(path);
+  IREE_ASSERT_ARGUMENT(options);
+  IREE_ASSERT_ARGUMENT(out_capture);
+  *out_capture = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_host_size_t path_length = strlen(path);
+  iree_runtime_capture_t* capture = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator,
+                                sizeof(*capture) + path_length + 1,
+                                (void**)&capture));
+  memset(capture, 0, sizeof(*capture));
+  iree_atomic_ref_count_init(&capture->ref_count);
+  capture->host_allocator = host_allocator;
+  capture->options = *options;
+  iree_slim_mutex_initialize(&capture->mutex);
+  char* path_storage = (char*)capture + sizeof(*capture);
+  memcpy(path_storage, path, path_length + 1);
+  capture->path = iree_make_string_view(path_storage, path_length);
+
+  capture->file = fopen(path, "wb");
+  if (!capture->file) {
+    iree_status_t status =
+        iree_make_status(iree_status_code_from_errno(errno),
+                         "failed to open capture file '%s'", path);
+    iree_runtime_capture_release(capture);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+
+  *out_capture = capture;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+static void iree_runtime_capture_destroy(iree_runtime_capture_t* capture) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  if (capture->file) fclose(capture->file);
+  iree_slim_mutex_deinitialize(&capture->mutex);
+  iree_allocator_free(capture->host_allocator, capture);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+IREE_API_EXPORT void iree_runtime_capture_retain(
+    iree_runtime_capture_t* capture) {
+  if (capture) {
+    iree_atomic_ref_count_inc(&capture->ref_count);
+  }
+}
+
+IREE_API_EXPORT void iree_runtime_capture_release(
+    iree_runtime_capture_t* capture) {
+  if (capture && iree_atomic_ref_count_dec(&capture->ref_count) == 1) {
+    iree_runtime_capture_destroy(capture);
+  }
+}
+
+IREE_API_EXPORT uint64_t
+iree_runtime_capture_recorded_call_count(iree_runtime_capture_t* capture) {
+  IREE_ASSERT_ARGUMENT(capture);
+  return (uint64_t)iree_atomic_load_int64(&capture->recorded_call_count,
+                                          iree_memory_order_relaxed);
+}
+
+IREE_API_EXPORT uint64_t
+iree_runtime_capture_dropped_call_count(iree_runtime_capture_t* capture) {
+  IREE_ASSERT_ARGUMENT(capture);
+  return (uint64_t)iree_atomic_load_int64(&capture->dropped_call_count,
+                                          iree_memory_order_relaxed);
+}
+
+// Appends a complete YAML |document| to the trace file.
+static iree_status_t iree_runtime_capture_write_document(
+    iree_runtime_capture_t* capture, iree_string_view_t document) {
+  iree_slim_mutex_lock(&capture->mutex);
+  iree_status_t status = iree_ok_status();
+  if (fwrite(document.data, 1, document.size, capture->file) !=
+          document.size ||
+      fflush(capture->file) != 0) {
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "failed to write capture file");
+  } else {
+    capture->file_size += document.size;
+    if (capture->options.max_file_size &&
+        capture->file_size >= capture->options.max_file_size) {
+      iree_atomic_store_int32(&capture->is_full, 1, iree_memory_order_relaxed);
+    }
+  }
+  iree_slim_mutex_unlock(&capture->mutex);
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t
+iree_runtime_capture_record_session(iree_runtime_capture_t* capture) {
+  IREE_ASSERT_ARGUMENT(capture);
+  // The HAL device is not recorded; replay uses its --driver= flag.
+  return iree_runtime_capture_write_document(
+      capture, iree_make_cstring_view("---\n"
+                                      "type: context_load\n"
+                                      "---\n"
+                                      "type: module_load\n"
+                                      "module:\n"
+                                      "  type: builtin\n"
+                                      "  name: hal\n"));
+}
+
+IREE_API_EXPORT iree_status_t iree_runtime_capture_record_bytecode_module(
+    iree_runtime_capture_t* capture, iree_const_byte_span_t flatbuffer_data) {
+  IREE_ASSERT_ARGUMENT(capture);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Modules are written as `<trace>.module<N>.vmfb`; the trace references them
+  // relative to its own directory so the two can be moved together.
+  iree_slim_mutex_lock(&capture->mutex);
+  uint32_t module_ordinal = capture->module_count++;
+  iree_slim_mutex_unlock(&capture->mutex);
+  iree_string_builder_t builder;
+  iree_string_builder_initialize(capture->host_allocator, &builder);
+  iree_status_t status = iree_string_builder_append_format(
+      &builder, "%.*s.module%u.vmfb", (int)capture->path.size,
+      capture->path.data, module_ordinal);
+  FILE* module_file = NULL;
+  if (iree_status_is_ok(status)) {
+    module_file = fopen(iree_string_builder_buffer(&builder), "wb");
+    if (!module_file) {
+      status = iree_make_status(iree_status_code_from_errno(errno),
+                                "failed to open capture module file '%s'",
+                                iree_string_builder_buffer(&builder));
+    }
+  }
+  if (iree_status_is_ok(status)) {
+    if (fwrite(flatbuffer_data.data, 1, flatbuffer_data.data_length,
+               module_file) != flatbuffer_data.data_length) {
+      status = iree_make_status(iree_status_code_from_errno(errno),
+                                "failed to write capture module file");
+    }
+    fclose(module_file);
+  }
+
+  iree_string_builder_t document;
+  iree_string_builder_initialize(capture->host_allocator, &document);
+  if (iree_status_is_ok(status)) {
+    iree_string_view_t basename =
+        iree_file_path_basename(iree_string_builder_view(&builder));
+    status = iree_string_builder_append_format(
+        &document,
+        "---\n"
+        "type: module_load\n"
+        "module:\n"
+        "  type: bytecode\n"
+        "  path: %.*s\n",
+        (int)basename.size, basename.data);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_runtime_capture_write_document(
+        capture, iree_string_builder_view(&document));
+  }
+  iree_string_builder_deinitialize(&document);
+  iree_string_builder_deinitialize(&builder);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+IREE_API_EXPORT bool iree_runtime_capture_sample_call(
+    iree_runtime_capture_t* capture) {
+  if (iree_atomic_load_int32(&capture->is_full, iree_memory_order_relaxed)) {
+    return false;
+  }
+  uint32_t period = capture->options.sample_period;
+  int64_t call_index = iree_atomic_fetch_add_int64(&capture->call_counter, 1,
+                                                   iree_memory_order_relaxed);
+  return period <= 1 || call_index % period == 0;
+}
+
+//===----------------------------------------------------------------------===//
+// YAML value formatting
+//===----------------------------------------------------------------------===//
+// Values are formatted as consumed by iree/tools/utils/trace_replay.c.
+
+static iree_status_t iree_runtime_capture_format_list(
+    iree_vm_list_t* list, int indent, iree_string_builder_t* builder);
+
+// Appends |data| base64-encoded in lines indented by |indent| spaces.
+static iree_status_t iree_runtime_capture_format_base64(
+    iree_const_byte_span_t data, int indent, iree_string_builder_t* builder) {
+  static const char kAlphabet[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  // 57 input bytes encode to a 76 character line.
+  const iree_host_size_t kBytesPerLine = 57;
+  iree_host_size_t line_count =
+      (data.data_length + kBytesPerLine - 1) / kBytesPerLine;
+  IREE_RETURN_IF_ERROR(iree_string_builder_reserve(
+      builder, iree_string_builder_size(builder) +
+                   line_count * (indent + 76 + 1) + 1));
+  char line[76 + 1];
+  for (iree_host_size_t offset = 0; offset < data.data_length;
+       offset += kBytesPerLine) {
+    iree_host_size_t length =
+        iree_min(kBytesPerLine, data.data_length - offset);
+    const uint8_t* src = data.data + offset;
+    char* dst = line;
+    for (iree_host_size_t i = 0; i < length; i += 3) {
+      uint32_t remaining = (uint32_t)(length - i);
+      uint32_t triple = (uint32_t)src[i] << 16;
+      if (remaining > 1) triple |= (uint32_t)src[i + 1] << 8;
+      if (remaining > 2) triple |= (uint32_t)src[i + 2];
+      *dst++ = kAlphabet[(triple >> 18) & 0x3F];
+      *dst++ = kAlphabet[(triple >> 12) & 0x3F];
+      *dst++ = remaining > 1 ? kAlphabet[(triple >> 6) & 0x3F] : '=';
+      *dst++ = remaining > 2 ? kAlphabet[triple & 0x3F] : '=';
+    }
+    *dst = 0;
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+        builder, "%*s%s\n", indent, "", line));
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_runtime_capture_format_buffer_view(
+    iree_hal_buffer_view_t* buffer_view, int indent,
+    iree_string_builder_t* builder) {
+  IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+      builder, "%*s- type: hal.buffer_view\n%*s  shape: [", indent, "", indent,
+      ""));
+  iree_host_size_t shape_rank = iree_hal_buffer_view_shape_rank(buffer_view);
+  const iree_hal_dim_t* shape = iree_hal_buffer_view_shape_dims(buffer_view);
+  for (iree_host_size_t i = 0; i < shape_rank; ++i) {
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+        builder, i ? ", %d" : "%d", (int)shape[i]));
+  }
+  IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+      builder, "]\n%*s  element_type: %u\n%*s  encoding_type: %u\n", indent,
+      "", (uint32_t)iree_hal_buffer_view_element_type(buffer_view), indent, "",
+      (uint32_t)iree_hal_buffer_view_encoding_type(buffer_view)));
+
+  // Empty contents are zero-filled on replay.
+  iree_device_size_t byte_length =
+      iree_hal_buffer_view_byte_length(buffer_view);
+  if (byte_length == 0) return iree_ok_status();
+  IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+      builder, "%*s  contents: !!binary |\n", indent, ""));
+  iree_hal_buffer_mapping_t mapping;
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_map_range(
+      iree_hal_buffer_view_buffer(buffer_view), IREE_HAL_MEMORY_ACCESS_READ, 0,
+      byte_length, &mapping));
+  iree_status_t status = iree_runtime_capture_format_base64(
+      iree_make_const_byte_span(mapping.contents.data,
+                                mapping.contents.data_length),
+      indent + 4, builder);
+  iree_hal_buffer_unmap_range(&mapping);
+  return status;
+}
+
+static iree_status_t iree_runtime_capture_format_value(
+    const iree_vm_variant_t* variant, int indent,
+    iree_string_builder_t* builder) {
+  IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+      builder, "%*s- type: value\n%*s  ", indent, "", indent, ""));
+  switch (variant->type.value_type) {
+    case IREE_VM_VALUE_TYPE_I8:
+      return iree_string_builder_append_format(builder, "i8: %d\n",
+                                               variant->i8);
+    case IREE_VM_VALUE_TYPE_I16:
+      return iree_string_builder_append_format(builder, "i16: %d\n",
+                                               variant->i16);
+    case IREE_VM_VALUE_TYPE_I32:
+      return iree_string_builder_append_format(builder, "i32: %" PRId32 "\n",
+                                               variant->i32);
+    case IREE_VM_VALUE_TYPE_I64:
+      return iree_string_builder_append_format(builder, "i64: %" PRId64 "\n",
+                                               variant->i64);
+    case IREE_VM_VALUE_TYPE_F32:
+      return iree_string_builder_append_format(builder, "f32: %.9g\n",
+                                               variant->f32);
+    case IREE_VM_VALUE_TYPE_F64:
+      return iree_string_builder_append_format(builder, "f64: %.17g\n",
+                                               variant->f64);
+    default:
+      return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                              "unsupported value type %d",
+                              (int)variant->type.value_type);
+  }
+}
+
+static iree_status_t iree_runtime_capture_format_item(
+    const iree_vm_variant_t* variant, int indent,
+    iree_string_builder_t* builder) {
+  if (iree_vm_variant_is_value(*variant)) {
+    return iree_runtime_capture_format_value(variant, indent, builder);
+  } else if (!iree_vm_variant_is_ref(*variant) || !variant->ref.ptr) {
+    return iree_string_builder_append_format(builder, "%*s- type: null\n",
+                                             indent, "");
+  } else if (iree_hal_buffer_view_isa(variant->ref)) {
+    return iree_runtime_capture_format_buffer_view(
+        iree_hal_buffer_view_deref(variant->ref), indent, builder);
+  } else if (iree_vm_list_isa(variant->ref)) {
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+        builder, "%*s- type: vm.list\n%*s  items:", indent, "", indent, ""));
+    return iree_runtime_capture_format_list(iree_vm_list_deref(variant->ref),
+                                            indent + 2, builder);
+  }
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "ref type cannot be captured");
+}
+
+// Appends the items of |list| as a YAML sequence following a `key:` that has
+// already been written.
+static iree_status_t iree_runtime_capture_format_list(
+    iree_vm_list_t* list, int indent, iree_string_builder_t* builder) {
+  iree_host_size_t count = list ? iree_vm_list_size(list) : 0;
+  if (count == 0) {
+    return iree_string_builder_append_cstring(builder, " []\n");
+  }
+  IREE_RETURN_IF_ERROR(iree_string_builder_append_cstring(builder, "\n"));
+  for (iree_host_size_t i = 0; i < count; ++i) {
+    iree_vm_variant_t variant = iree_vm_variant_empty();
+    IREE_RETURN_IF_ERROR(iree_vm_list_get_variant(list, i, &variant));
+    IREE_RETURN_IF_ERROR(
+        iree_runtime_capture_format_item(&variant, indent, builder));
+  }
+  return iree_ok_status();
+}
+
+//===----------------------------------------------------------------------===//
+// Call recording
+//===----------------------------------------------------------------------===//
+
+static void iree_runtime_capture_drop_call(iree_runtime_capture_t* capture,
+                                           iree_status_t status) {
+  iree_status_ignore(status);
+  iree_atomic_fetch_add_int64(&capture->dropped_call_count, 1,
+                              iree_memory_order_relaxed);
+}
+
+IREE_API_EXPORT bool iree_runtime_capture_begin_call(
+    iree_runtime_capture_t* capture, const iree_vm_function_t* function,
+    iree_vm_list_t* input_list, iree_string_builder_t* call_record) {
+  IREE_ASSERT_ARGUMENT(capture);
+  IREE_ASSERT_ARGUMENT(function);
+  IREE_ASSERT_ARGUMENT(call_record);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_string_view_t module_name = iree_vm_module_name(function->module);
+  iree_string_view_t function_name = iree_vm_function_name(function);
+  iree_status_t status = iree_string_builder_append_format(
+      call_record,
+      "---\n"
+      "type: call\n"
+      "function: %.*s.%.*s\n"
+      "args:",
+      (int)module_name.size, module_name.data, (int)function_name.size,
+      function_name.data);
+  if (iree_status_is_ok(status)) {
+    status = iree_runtime_capture_format_list(input_list, 0, call_record);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  if (!iree_status_is_ok(status)) {
+    iree_runtime_capture_drop_call(capture, status);
+    return false;
+  }
+  return true;
+}
+
+IREE_API_EXPORT bool iree_runtime_capture_end_call(
+    iree_runtime_capture_t* capture, iree_vm_list_t* output_list,
+    iree_string_builder_t* call_record) {
+  IREE_ASSERT_ARGUMENT(capture);
+  IREE_ASSERT_ARGUMENT(call_record);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_status_t status = iree_ok_status();
+  if (capture->options.record_outputs) {
+    status = iree_string_builder_append_cstring(call_record, "results:");
+    if (iree_status_is_ok(status)) {
+      status = iree_runtime_capture_format_list(output_list, 0, call_record);
+    }
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_runtime_capture_write_document(
+        capture, iree_string_builder_view(call_record));
+  }
+  IREE_TRACE_ZONE_END(z0);
+  if (!iree_status_is_ok(status)) {
+    iree_runtime_capture_drop_call(capture, status);
+    return false;
+  }
+  iree_atomic_fetch_add_int64(&capture->recorded_call_count, 1,
+                              iree_memory_order_relaxed);
+  return true;
+}
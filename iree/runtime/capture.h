@@ -0,0 +1,126 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_RUNTIME_CAPTURE_H_
+#define IREE_RUNTIME_CAPTURE_H_
+
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/vm/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// A capture of the calls made through one or more sessions as a YAML trace
+// that can be replayed with iree-run-trace and benchmarked with
+// iree-benchmark-trace.
+//
+// Each session created with a capture records a `context_load` event, the HAL
+// module and every bytecode module appended to it followed by the sampled
+// calls made through iree_runtime_session_call (and thus iree_runtime_call_t)
+// with their input and optionally output values. Bytecode modules are written
+// next to the trace file so that the trace is self-contained.
+//
+// Capture is designed to be left enabled in production: calls that are not
+// sampled only pay for an atomic increment and any failure to capture a call
+// (such as a buffer that is not host-visible) drops the call from the trace
+// without affecting the call itself.
+//
+// Calls are captured independently of one another so replaying a sampled trace
+// of a stateful program may not reproduce the original results.
+//
+// Thread-safe; any number of sessions may share a capture.
+typedef struct iree_runtime_capture_t iree_runtime_capture_t;
+
+//===----------------------------------------------------------------------===//
+// iree_runtime_capture_options_t
+//===----------------------------------------------------------------------===//
+
+// Options used to configure capture creation.
+typedef struct iree_runtime_capture_options_t {
+  // Records one out of every |sample_period| calls; 0 and 1 record all calls.
+  uint32_t sample_period;
+
+  // Stops capturing calls once the trace file reaches this many bytes; 0 for
+  // no limit. Modules and context events are always recorded.
+  uint64_t max_file_size;
+
+  // Records the outputs of each captured call under a `results` key that
+  // replay ignores but that can be used to verify a replay.
+  bool record_outputs;
+} iree_runtime_capture_options_t;
+
+// Initializes |out_options| to its default values.
+IREE_API_EXPORT void iree_runtime_capture_options_initialize(
+    iree_runtime_capture_options_t* out_options);
+
+//===----------------------------------------------------------------------===//
+// iree_runtime_capture_t
+//===----------------------------------------------------------------------===//
+
+// Creates a capture writing to the YAML trace file at |path|, which is
+// truncated if it exists. |out_capture| must be released by the caller and is
+// then attached to sessions via iree_runtime_session_options_t::capture.
+IREE_API_EXPORT iree_status_t iree_runtime_capture_create(
+    const char* path, const iree_runtime_capture_options_t* options,
+    iree_allocator_t host_allocator, iree_runtime_capture_t** out_capture);
+
+// Retains the given |capture| for the caller.
+IREE_API_EXPORT void iree_runtime_capture_retain(
+    iree_runtime_capture_t* capture);
+
+// Releases the given |capture| from the caller. The trace file is closed once
+// the last session using the capture is released.
+IREE_API_EXPORT void iree_runtime_capture_release(
+    iree_runtime_capture_t* capture);
+
+// Returns the number of calls recorded into the trace.
+IREE_API_EXPORT uint64_t
+iree_runtime_capture_recorded_call_count(iree_runtime_capture_t* capture);
+
+// Returns the number of sampled calls that could not be recorded.
+IREE_API_EXPORT uint64_t
+iree_runtime_capture_dropped_call_count(iree_runtime_capture_t* capture);
+
+//===----------------------------------------------------------------------===//
+// Session hooks
+//===----------------------------------------------------------------------===//
+// Used by iree_runtime_session_t; not intended for direct use.
+
+// Records a `context_load` followed by the HAL module load of a new session.
+IREE_API_EXPORT iree_status_t
+iree_runtime_capture_record_session(iree_runtime_capture_t* capture);
+
+// Writes |flatbuffer_data| next to the trace and records a `module_load` of it.
+IREE_API_EXPORT iree_status_t iree_runtime_capture_record_bytecode_module(
+    iree_runtime_capture_t* capture, iree_const_byte_span_t flatbuffer_data);
+
+// Returns true if the next call should be recorded.
+IREE_API_EXPORT bool iree_runtime_capture_sample_call(
+    iree_runtime_capture_t* capture);
+
+// Begins recording a sampled call to |function| with |input_list| into
+// |call_record|. Inputs are read back before the call executes so that
+// in-place updates are not observed. Returns false if the call cannot be
+// recorded, in which case it is counted as dropped.
+IREE_API_EXPORT bool iree_runtime_capture_begin_call(
+    iree_runtime_capture_t* capture, const iree_vm_function_t* function,
+    iree_vm_list_t* input_list, iree_string_builder_t* call_record);
+
+// Completes |call_record| with the |output_list| of a successful call and
+// appends it to the trace. Returns false if the call was dropped.
+IREE_API_EXPORT bool iree_runtime_capture_end_call(
+    iree_runtime_capture_t* capture, iree_vm_list_t* output_list,
+    iree_string_builder_t* call_record);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_RUNTIME_CAPTURE_H_
@@ -60,6 +60,9 @@ struct iree_runtime_session_t {
   // lookup. An application directly using the API may never need this, or could
   // perform VM calls into HAL module exports to gain more portability.
   iree_vm_module_state_t* hal_module_state;
+
+  // Optional capture that modules and calls are recorded into.
+  iree_runtime_capture_t* capture;
 };
 
 IREE_API_EXPORT iree_status_t iree_runtime_session_create_with_device(
@@ -83,6 +86,8 @@ IREE_API_EXPORT iree_status_t iree_runtime_session_create_with_device(
 
   session->instance = instance;
   iree_runtime_instance_retain(session->instance);
+  session->capture = options->capture;
+  iree_runtime_capture_retain(session->capture);
 
   // Create the context empty so that we can add our modules to it.
   iree_status_t status = iree_vm_context_create(
@@ -102,6 +107,9 @@ IREE_API_EXPORT iree_status_t iree_runtime_session_create_with_device(
                                                   &session->hal_module_state);
   }
   iree_vm_module_release(hal_module);
+  if (iree_status_is_ok(status) && session->capture) {
+    status = iree_runtime_capture_record_session(session->capture);
+  }
 
   if (iree_status_is_ok(status)) {
     *out_session = session;
@@ -117,6 +125,7 @@ static void iree_runtime_session_destroy(iree_runtime_session_t* session) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
   iree_vm_context_release(session->context);
+  iree_runtime_capture_release(session->capture);
   iree_runtime_instance_release(session->instance);
 
   iree_allocator_free(session->host_allocator, session);
@@ -184,6 +193,44 @@ IREE_API_EXPORT iree_status_t iree_runtime_session_append_module(
   return status;
 }
 
+// Preloads the executables embedded in the read-only data of the bytecode
+// |module| on the session device. Without this executables are prepared one at
+// a time as the module initializers create them; preloading all of them up
+// front lets devices that support it load them in parallel. Best-effort: any
+// executable that fails to preload will fail again with a proper error when
+// the module initializers prepare it.
+static void iree_runtime_session_preload_executables(
+    iree_runtime_session_t* session, iree_vm_module_t* module) {
+  iree_host_size_t segment_count =
+      iree_vm_bytecode_module_rodata_segment_count(module);
+  if (segment_count == 0) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_allocator_t host_allocator =
+      iree_runtime_session_host_allocator(session);
+  iree_const_byte_span_t* segments = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, segment_count * sizeof(*segments), (void**)&segments);
+  iree_hal_executable_cache_t* executable_cache = NULL;
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_executable_cache_create(
+        iree_runtime_session_device(session), iree_make_cstring_view("preload"),
+        &executable_cache);
+  }
+  if (iree_status_is_ok(status)) {
+    for (iree_host_size_t i = 0; i < segment_count; ++i) {
+      segments[i] = iree_vm_bytecode_module_rodata_segment(module, i);
+    }
+    iree_hal_executable_cache_preload_executables(executable_cache,
+                                                  segment_count, segments);
+  }
+  iree_hal_executable_cache_release(executable_cache);
+  iree_allocator_free(host_allocator, segments);
+  iree_status_ignore(status);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
 IREE_API_EXPORT iree_status_t
 iree_runtime_session_append_bytecode_module_from_memory(
     iree_runtime_session_t* session, iree_const_byte_span_t flatbuffer_data,
@@ -191,11 +238,20 @@ iree_runtime_session_append_bytecode_module_from_memory(
   IREE_ASSERT_ARGUMENT(session);
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  if (session->capture) {
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_runtime_capture_record_bytecode_module(session->capture,
+                                                        flatbuffer_data));
+  }
+
   iree_vm_module_t* module = NULL;
   iree_status_t status = iree_vm_bytecode_module_create(
       flatbuffer_data, flatbuffer_allocator,
       iree_runtime_session_host_allocator(session), &module);
   if (iree_status_is_ok(status)) {
+    // The module initializers run as the module is appended; get a head start
+    // on preparing the executables they will create.
+    iree_runtime_session_preload_executables(session, module);
     status = iree_runtime_session_append_module(session, module);
   }
   iree_vm_module_release(module);
@@ -211,23 +267,36 @@ iree_runtime_session_append_bytecode_module_from_file(
   IREE_TRACE_ZONE_BEGIN(z0);
   IREE_TRACE_ZONE_APPEND_TEXT(z0, file_path);
 
-  // TODO(#3909): actually map the memory here. For now we just load the
-  // contents.
-  iree_allocator_t flatbuffer_allocator =
-      iree_runtime_session_host_allocator(session);
-  iree_byte_span_t flatbuffer_data;
-  IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0, iree_file_read_contents(file_path, flatbuffer_allocator,
-                                  &flatbuffer_data));
-
+  // Map the file so that only the pages of the module that are actually used
+  // are loaded and are shared with other processes loading the same module.
+  // Ownership of the mapping passes to the module which unmaps it when
+  // destroyed.
+  iree_file_mapping_t* mapping = NULL;
   iree_status_t status =
-      iree_runtime_session_append_bytecode_module_from_memory(
-          session,
-          iree_make_const_byte_span(flatbuffer_data.data,
-                                    flatbuffer_data.data_length),
-          flatbuffer_allocator);
-  if (!iree_status_is_ok(status)) {
-    iree_allocator_free(flatbuffer_allocator, flatbuffer_data.data);
+      iree_file_map(file_path, IREE_FILE_MAP_HINT_NONE,
+                    iree_runtime_session_host_allocator(session), &mapping);
+  if (iree_status_is_ok(status)) {
+    status = iree_runtime_session_append_bytecode_module_from_memory(
+        session, iree_file_mapping_contents(mapping),
+        iree_file_mapping_deallocator(mapping));
+    if (!iree_status_is_ok(status)) iree_file_unmap(mapping);
+  } else if (iree_status_is_unavailable(status)) {
+    // Mapping is not supported on this platform; read the contents instead.
+    iree_status_ignore(status);
+    iree_allocator_t flatbuffer_allocator =
+        iree_runtime_session_host_allocator(session);
+    iree_byte_span_t flatbuffer_data;
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_file_read_contents(file_path, flatbuffer_allocator,
+                                    &flatbuffer_data));
+    status = iree_runtime_session_append_bytecode_module_from_memory(
+        session,
+        iree_make_const_byte_span(flatbuffer_data.data,
+                                  flatbuffer_data.data_length),
+        flatbuffer_allocator);
+    if (!iree_status_is_ok(status)) {
+      iree_allocator_free(flatbuffer_allocator, flatbuffer_data.data);
+    }
   }
 
   IREE_TRACE_ZONE_END(z0);
@@ -255,11 +324,42 @@ IREE_API_EXPORT iree_status_t iree_runtime_session_call(
   IREE_ASSERT_ARGUMENT(function);
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // Sampled calls have their inputs recorded before the invocation may modify
+  // them in-place.
+  iree_string_builder_t call_record;
+  iree_string_builder_initialize(session->host_allocator, &call_record);
+  bool capture_call = session->capture &&
+                      iree_runtime_capture_sample_call(session->capture) &&
+                      iree_runtime_capture_begin_call(
+                          session->capture, function, input_list, &call_record);
+
   iree_status_t status =
       iree_vm_invoke(iree_runtime_session_context(session), *function,
                      /*policy=*/NULL, input_list, output_list,
                      iree_runtime_session_host_allocator(session));
 
+  if (capture_call && iree_status_is_ok(status)) {
+    iree_runtime_capture_end_call(session->capture, output_list, &call_record);
+  }
+  iree_string_builder_deinitialize(&call_record);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t iree_runtime_session_call_async(
+    iree_runtime_session_t* session, const iree_vm_function_t* function,
+    iree_vm_list_t* input_list, iree_vm_invocation_t** out_invocation) {
+  IREE_ASSERT_ARGUMENT(session);
+  IREE_ASSERT_ARGUMENT(function);
+  IREE_ASSERT_ARGUMENT(out_invocation);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_status_t status = iree_vm_invocation_create(
+      iree_runtime_session_context(session), *function,
+      /*policy=*/NULL, input_list, iree_runtime_session_host_allocator(session),
+      out_invocation);
+
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
@@ -11,6 +11,7 @@
 
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
+#include "iree/runtime/capture.h"
 #include "iree/vm/api.h"
 
 #ifdef __cplusplus
@@ -58,6 +59,10 @@ typedef struct iree_runtime_session_options_t {
   // Session creation will fail if a requested module is not built into the
   // runtime binary.
   iree_runtime_session_builtins_t builtin_modules;
+
+  // Optional capture that the modules and calls of the session are recorded
+  // into. Retained by the session. See iree/runtime/capture.h.
+  iree_runtime_capture_t* capture;
 } iree_runtime_session_options_t;
 
 // Initializes |out_options| to its default values.
@@ -151,6 +156,9 @@ iree_runtime_session_append_bytecode_module_from_memory(
     iree_allocator_t flatbuffer_allocator);
 
 // Appends a bytecode module to the context loaded from the given |file_path|.
+// The file is memory mapped where supported such that pages are only loaded
+// as they are used and are shared with other processes loading the same file.
+// The file must not be modified for the lifetime of the session.
 //
 // NOTE: only valid if the context is not yet frozen; see
 // iree_vm_context_freeze for more information.
@@ -189,6 +197,26 @@ IREE_API_EXPORT iree_status_t iree_runtime_session_call(
     iree_runtime_session_t* session, const iree_vm_function_t* function,
     iree_vm_list_t* input_list, iree_vm_list_t* output_list);
 
+// Asynchronously issues a generic function call.
+//
+// The call begins executing on the calling thread and runs until it either
+// completes or yields, such as when waiting on a HAL semaphore that has not yet
+// been signaled. In-flight calls do not block the calling thread and can be
+// resumed from any thread with iree_vm_invocation_resume or awaited with
+// iree_vm_invocation_await. Outputs are available from
+// iree_vm_invocation_output once the call completes.
+//
+// |input_list| is used to pass values and objects into the target function and
+// must match the signature defined by the compiled function. List ownership
+// remains with the caller and the inputs are consumed before this call
+// returns.
+//
+// The returned |out_invocation| must be released by the caller and retains the
+// session context until released.
+IREE_API_EXPORT iree_status_t iree_runtime_session_call_async(
+    iree_runtime_session_t* session, const iree_vm_function_t* function,
+    iree_vm_list_t* input_list, iree_vm_invocation_t** out_invocation);
+
 // Synchronously issues a generic function call by fully-qualified name.
 // This is equivalent to performing a iree_runtime_session_lookup_function
 // followed by a iree_runtime_session_call. When calling the same function
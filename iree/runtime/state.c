@@ -0,0 +1,263 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/runtime/state.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/tracing.h"
+#include "iree/modules/hal/module.h"
+#include "iree/runtime/session.h"
+
+//===----------------------------------------------------------------------===//
+// iree_runtime_state_t
+//===----------------------------------------------------------------------===//
+
+struct iree_runtime_state_t {
+  iree_atomic_ref_count_t ref_count;
+  iree_allocator_t host_allocator;
+  iree_runtime_session_t* session;
+  iree_host_size_t count;
+  // Current state values; NULL until set. Stored following the struct.
+  iree_hal_buffer_view_t** values;
+};
+
+IREE_API_EXPORT iree_status_t iree_runtime_state_create(
+    iree_runtime_session_t* session, iree_host_size_t state_count,
+    iree_allocator_t host_allocator, iree_runtime_state_t** out_state) {
+  IREE_ASSERT_ARGUMENT(session);
+  IREE_ASSERT_ARGUMENT(out_state);
+  *out_state = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_runtime_state_t* state = NULL;
+  iree_host_size_t total_size =
+      iree_sizeof_struct(*state) + state_count * sizeof(*state->values);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, total_size, (void**)&state));
+  memset(state, 0, total_size);
+  iree_atomic_ref_count_init(&state->ref_count);
+  state->host_allocator = host_allocator;
+  state->session = session;
+  iree_runtime_session_retain(session);
+  state->count = state_count;
+  state->values =
+      (iree_hal_buffer_view_t**)((uint8_t*)state + iree_sizeof_struct(*state));
+
+  *out_state = state;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+static void iree_runtime_state_destroy(iree_runtime_state_t* state) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  for (iree_host_size_t i = 0; i < state->count; ++i) {
+    iree_hal_buffer_view_release(state->values[i]);
+  }
+  iree_runtime_session_release(state->session);
+  iree_allocator_free(state->host_allocator, state);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+IREE_API_EXPORT void iree_runtime_state_retain(iree_runtime_state_t* state) {
+  if (state) {
+    iree_atomic_ref_count_inc(&state->ref_count);
+  }
+}
+
+IREE_API_EXPORT void iree_runtime_state_release(iree_runtime_state_t* state) {
+  if (state && iree_atomic_ref_count_dec(&state->ref_count) == 1) {
+    iree_runtime_state_destroy(state);
+  }
+}
+
+IREE_API_EXPORT iree_host_size_t
+iree_runtime_state_count(const iree_runtime_state_t* state) {
+  IREE_ASSERT_ARGUMENT(state);
+  return state->count;
+}
+
+static iree_status_t iree_runtime_state_check_index(
+    const iree_runtime_state_t* state, iree_host_size_t i) {
+  if (i >= state->count) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "state index %zu out of range (%zu values)", i,
+                            state->count);
+  }
+  return iree_ok_status();
+}
+
+// Replaces state value |i| with |buffer_view|, taking ownership of it.
+static void iree_runtime_state_assign(iree_runtime_state_t* state,
+                                      iree_host_size_t i,
+                                      iree_hal_buffer_view_t* buffer_view) {
+  iree_hal_buffer_view_release(state->values[i]);
+  state->values[i] = buffer_view;
+}
+
+IREE_API_EXPORT iree_status_t iree_runtime_state_allocate(
+    iree_runtime_state_t* state, iree_host_size_t i,
+    const iree_hal_dim_t* shape, iree_host_size_t shape_rank,
+    iree_hal_element_type_t element_type) {
+  IREE_ASSERT_ARGUMENT(state);
+  IREE_ASSERT_ARGUMENT(!shape_rank || shape);
+  IREE_RETURN_IF_ERROR(iree_runtime_state_check_index(state, i));
+  iree_hal_allocator_t* device_allocator =
+      iree_runtime_session_device_allocator(state->session);
+  if (!device_allocator) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "session device has not been initialized");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_buffer_view_t* buffer_view = NULL;
+  iree_status_t status = iree_hal_buffer_view_allocate_buffer(
+      device_allocator, shape, shape_rank, element_type,
+      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL,
+      IREE_HAL_BUFFER_USAGE_ALL, &buffer_view);
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_buffer_zero(iree_hal_buffer_view_buffer(buffer_view), 0,
+                                  IREE_WHOLE_BUFFER);
+  }
+  if (iree_status_is_ok(status)) {
+    iree_runtime_state_assign(state, i, buffer_view);
+  } else {
+    iree_hal_buffer_view_release(buffer_view);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t iree_runtime_state_set_buffer_view(
+    iree_runtime_state_t* state, iree_host_size_t i,
+    iree_hal_buffer_view_t* buffer_view) {
+  IREE_ASSERT_ARGUMENT(state);
+  IREE_ASSERT_ARGUMENT(buffer_view);
+  IREE_RETURN_IF_ERROR(iree_runtime_state_check_index(state, i));
+  iree_hal_buffer_view_retain(buffer_view);
+  iree_runtime_state_assign(state, i, buffer_view);
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_hal_buffer_view_t* iree_runtime_state_buffer_view(
+    const iree_runtime_state_t* state, iree_host_size_t i) {
+  IREE_ASSERT_ARGUMENT(state);
+  return i < state->count ? state->values[i] : NULL;
+}
+
+IREE_API_EXPORT iree_status_t
+iree_runtime_state_reset(iree_runtime_state_t* state) {
+  IREE_ASSERT_ARGUMENT(state);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < state->count && iree_status_is_ok(status);
+       ++i) {
+    if (!state->values[i]) continue;
+    status = iree_hal_buffer_zero(iree_hal_buffer_view_buffer(state->values[i]),
+                                  0, IREE_WHOLE_BUFFER);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+//===----------------------------------------------------------------------===//
+// Stateful calls
+//===----------------------------------------------------------------------===//
+
+// Appends the state values to the |call| inputs, followed by the state values
+// again as output storage if |with_storage| is set.
+static iree_status_t iree_runtime_call_inputs_push_back_state(
+    iree_runtime_call_t* call, iree_runtime_state_t* state,
+    bool with_storage) {
+  for (iree_host_size_t i = 0; i < state->count; ++i) {
+    IREE_RETURN_IF_ERROR(iree_runtime_call_inputs_push_back_buffer_view(
+        call, state->values[i]));
+  }
+  if (!with_storage) return iree_ok_status();
+  for (iree_host_size_t i = 0; i < state->count; ++i) {
+    IREE_RETURN_IF_ERROR(iree_runtime_call_inputs_push_back_output_storage(
+        call, state->values[i]));
+  }
+  return iree_ok_status();
+}
+
+// Moves the trailing state results of |call| into |state|.
+static iree_status_t iree_runtime_call_outputs_pop_back_state(
+    iree_runtime_call_t* call, iree_runtime_state_t* state) {
+  iree_host_size_t output_count = iree_vm_list_size(call->outputs);
+  if (output_count < state->count) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "call returned %zu results but the state has %zu "
+                            "values",
+                            output_count, state->count);
+  }
+  iree_host_size_t base = output_count - state->count;
+
+  // Verify all results before swapping any so that a failure leaves the state
+  // unchanged.
+  for (iree_host_size_t i = 0; i < state->count; ++i) {
+    if (!iree_vm_list_get_buffer_view_assign(call->outputs, base + i)) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "state result %zu is not a buffer view", i);
+    }
+  }
+  for (iree_host_size_t i = 0; i < state->count; ++i) {
+    iree_runtime_state_assign(
+        state, i, iree_vm_list_get_buffer_view_retain(call->outputs, base + i));
+  }
+  return iree_vm_list_resize(call->outputs, base);
+}
+
+IREE_API_EXPORT iree_status_t iree_runtime_call_invoke_with_state(
+    iree_runtime_call_t* call, iree_runtime_state_t* state,
+    iree_runtime_call_flags_t flags) {
+  IREE_ASSERT_ARGUMENT(call);
+  IREE_ASSERT_ARGUMENT(state);
+  for (iree_host_size_t i = 0; i < state->count; ++i) {
+    if (!state->values[i]) {
+      return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                              "state value %zu has not been set", i);
+    }
+  }
+
+  // The state results carry output storage if the function takes one more
+  // argument per state value than the state values themselves.
+  iree_vm_function_signature_t signature =
+      iree_vm_function_signature(&call->function);
+  iree_host_size_t argument_count = 0;
+  iree_host_size_t result_count = 0;
+  IREE_RETURN_IF_ERROR(iree_vm_function_call_count_arguments_and_results(
+      &signature, &argument_count, &result_count));
+  iree_host_size_t input_count = iree_vm_list_size(call->inputs);
+  bool with_storage = false;
+  if (argument_count == input_count + 2 * state->count) {
+    with_storage = true;
+  } else if (argument_count != input_count + state->count) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "function takes %zu arguments but the call has "
+                            "%zu inputs and the state has %zu values",
+                            argument_count, input_count, state->count);
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_status_t status =
+      iree_runtime_call_inputs_push_back_state(call, state, with_storage);
+  if (iree_status_is_ok(status)) {
+    status = iree_runtime_call_invoke(call, flags);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_runtime_call_outputs_pop_back_state(call, state);
+  }
+
+  // Drop the state inputs so the call can be reused with another state.
+  iree_status_ignore(iree_vm_list_resize(call->inputs, input_count));
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
@@ -0,0 +1,104 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_RUNTIME_STATE_H_
+#define IREE_RUNTIME_STATE_H_
+
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/runtime/call.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Device-resident state carried across calls of a stateful function, such as
+// the recurrent state of a streaming model that is invoked once per chunk.
+//
+// Stateful functions take their state as their trailing arguments and return
+// the updated state as their trailing results, in the same order:
+//   func @step(%chunk: tensor<1x320xf32>, %h: tensor<1x512xf32>)
+//       -> (tensor<1x40xf32>, tensor<1x512xf32> {iree.abi.output_storage})
+// Each state value is held in a device buffer owned by the state object and
+// iree_runtime_call_invoke_with_state passes the buffers to the function and
+// swaps the updated results back in without the state ever touching the host.
+// When the state results are marked with `iree.abi.output_storage` the state
+// buffers are also passed as the result storage and updated in place, making
+// the steady-state call path free of state allocations.
+//
+// Applications handling multiple concurrent streams (such as one per
+// connected client) create one state object per stream and can share a single
+// session and call across all of them.
+//
+// Thread-compatible; a state may only be used by one call at a time.
+typedef struct iree_runtime_state_t iree_runtime_state_t;
+
+// Creates a state with |state_count| values for functions within |session|.
+// All values are initially unset and must be populated with either
+// iree_runtime_state_allocate or iree_runtime_state_set_buffer_view prior to
+// the first call. |out_state| must be released by the caller.
+IREE_API_EXPORT iree_status_t iree_runtime_state_create(
+    iree_runtime_session_t* session, iree_host_size_t state_count,
+    iree_allocator_t host_allocator, iree_runtime_state_t** out_state);
+
+// Retains the given |state| for the caller.
+IREE_API_EXPORT void iree_runtime_state_retain(iree_runtime_state_t* state);
+
+// Releases the given |state| from the caller.
+IREE_API_EXPORT void iree_runtime_state_release(iree_runtime_state_t* state);
+
+// Returns the total number of values in the state.
+IREE_API_EXPORT iree_host_size_t
+iree_runtime_state_count(const iree_runtime_state_t* state);
+
+// Allocates zero-initialized device storage for state value |i| with the given
+// shape and element type, replacing any prior value.
+IREE_API_EXPORT iree_status_t iree_runtime_state_allocate(
+    iree_runtime_state_t* state, iree_host_size_t i,
+    const iree_hal_dim_t* shape, iree_host_size_t shape_rank,
+    iree_hal_element_type_t element_type);
+
+// Sets state value |i| to |buffer_view|, replacing any prior value.
+// The buffer view is retained by the state and will be updated by subsequent
+// calls when passed as output storage.
+IREE_API_EXPORT iree_status_t iree_runtime_state_set_buffer_view(
+    iree_runtime_state_t* state, iree_host_size_t i,
+    iree_hal_buffer_view_t* buffer_view);
+
+// Returns the current value of state |i| or NULL if it has not been set.
+// The buffer view is borrowed and only valid until the next call made with
+// the state.
+IREE_API_EXPORT iree_hal_buffer_view_t* iree_runtime_state_buffer_view(
+    const iree_runtime_state_t* state, iree_host_size_t i);
+
+// Resets all state values to zero, such as when a stream restarts.
+// Requires that the state buffers are mappable; see iree_hal_buffer_zero.
+IREE_API_EXPORT iree_status_t
+iree_runtime_state_reset(iree_runtime_state_t* state);
+
+// Synchronously invokes |call| with |state| and returns the status.
+//
+// |call| must have been populated with all arguments of the function that
+// precede the state. The state values are appended as the trailing arguments
+// (followed by the output storage for the state results if the function
+// declares it) and removed again once the call completes so that pinned calls
+// can be reused across streams. On success the trailing state results are
+// removed from the call outputs and become the new state values; all other
+// outputs remain in the call outputs list.
+//
+// Functions whose state results use output storage must not declare output
+// storage for any of their other results.
+IREE_API_EXPORT iree_status_t iree_runtime_call_invoke_with_state(
+    iree_runtime_call_t* call, iree_runtime_state_t* state,
+    iree_runtime_call_flags_t flags);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_RUNTIME_STATE_H_
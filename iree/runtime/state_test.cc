@@ -0,0 +1,357 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/runtime/state.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/local/sync_device.h"
+#include "iree/modules/hal/module.h"
+#include "iree/runtime/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+#include "iree/vm/api.h"
+
+namespace {
+
+// Number of f32 elements in the chunks and the state value.
+constexpr iree_hal_dim_t kLength = 4;
+
+// Creates a [1, |values|.size()] f32 buffer view with |values| in |allocator|.
+static iree_status_t CreateBufferView(iree_hal_allocator_t* allocator,
+                                      const std::vector<float>& values,
+                                      iree_hal_buffer_view_t** out_view) {
+  const iree_hal_dim_t shape[2] = {1, (iree_hal_dim_t)values.size()};
+  return iree_hal_buffer_view_clone_heap_buffer(
+      allocator, shape, IREE_ARRAYSIZE(shape), IREE_HAL_ELEMENT_TYPE_FLOAT_32,
+      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR,
+      IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE,
+      IREE_HAL_BUFFER_USAGE_ALL,
+      iree_make_const_byte_span(values.data(), values.size() * sizeof(float)),
+      out_view);
+}
+
+static iree_status_t ReadBufferView(iree_hal_buffer_view_t* buffer_view,
+                                    std::vector<float>* out_values) {
+  out_values->resize(iree_hal_buffer_view_element_count(buffer_view));
+  return iree_hal_buffer_read_data(iree_hal_buffer_view_buffer(buffer_view), 0,
+                                   out_values->data(),
+                                   out_values->size() * sizeof(float));
+}
+
+//===----------------------------------------------------------------------===//
+// test module
+//===----------------------------------------------------------------------===//
+// Exports two stateful functions that accumulate their chunks into their
+// state and return the sum as their first result:
+//   test.step(%chunk, %h) -> (%sum, %new_h)
+//   test.step_in_place(%chunk, %h, %h_storage)
+//       -> (%sum, %new_h {iree.abi.output_storage})
+// test.step returns its new state in a new buffer while test.step_in_place
+// writes it to the provided storage. Negative chunk values are rejected.
+
+enum {
+  kStepOrdinal = 0,
+  kStepInPlaceOrdinal = 1,
+};
+
+static iree_status_t IREE_API_PTR test_module_begin_call(
+    void* self, iree_vm_stack_t* stack, const iree_vm_function_call_t* call,
+    iree_vm_execution_result_t* out_result) {
+  iree_hal_allocator_t* allocator = (iree_hal_allocator_t*)self;
+  out_result->flags = IREE_VM_EXECUTION_RESULT_FLAG_NONE;
+  iree_vm_ref_t* args = (iree_vm_ref_t*)call->arguments.data;
+  iree_vm_ref_t* rets = (iree_vm_ref_t*)call->results.data;
+
+  iree_hal_buffer_view_t* chunk = NULL;
+  iree_hal_buffer_view_t* h = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_view_check_deref(args[0], &chunk));
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_view_check_deref(args[1], &h));
+  std::vector<float> chunk_values;
+  std::vector<float> values;
+  IREE_RETURN_IF_ERROR(ReadBufferView(chunk, &chunk_values));
+  IREE_RETURN_IF_ERROR(ReadBufferView(h, &values));
+  if (chunk_values.size() != values.size()) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT, "shape mismatch");
+  }
+  for (size_t i = 0; i < values.size(); ++i) {
+    if (chunk_values[i] < 0.0f) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT, "negative chunk");
+    }
+    values[i] += chunk_values[i];
+  }
+
+  iree_hal_buffer_view_t* sum = NULL;
+  IREE_RETURN_IF_ERROR(CreateBufferView(allocator, values, &sum));
+  rets[0] = iree_hal_buffer_view_move_ref(sum);
+  if (call->function.ordinal == kStepInPlaceOrdinal) {
+    iree_hal_buffer_view_t* storage = NULL;
+    IREE_RETURN_IF_ERROR(iree_hal_buffer_view_check_deref(args[2], &storage));
+    IREE_RETURN_IF_ERROR(iree_hal_buffer_write_data(
+        iree_hal_buffer_view_buffer(storage), 0, values.data(),
+        values.size() * sizeof(float)));
+    rets[1] = iree_hal_buffer_view_retain_ref(storage);
+  } else {
+    iree_hal_buffer_view_t* new_h = NULL;
+    IREE_RETURN_IF_ERROR(CreateBufferView(allocator, values, &new_h));
+    rets[1] = iree_hal_buffer_view_move_ref(new_h);
+  }
+  return iree_ok_status();
+}
+
+static const iree_vm_native_export_descriptor_t test_module_exports_[] = {
+    {iree_make_cstring_view("step"), iree_make_cstring_view("0rr_rr"), 0,
+     NULL},
+    {iree_make_cstring_view("step_in_place"), iree_make_cstring_view("0rrr_rr"),
+     0, NULL},
+};
+static const iree_vm_native_module_descriptor_t test_module_descriptor_ = {
+    iree_make_cstring_view("test"),
+    0,
+    NULL,
+    IREE_ARRAYSIZE(test_module_exports_),
+    test_module_exports_,
+    0,
+    NULL,
+    0,
+    NULL,
+};
+
+static iree_status_t test_module_create(iree_hal_allocator_t* allocator,
+                                        iree_allocator_t host_allocator,
+                                        iree_vm_module_t** out_module) {
+  iree_vm_module_t interface;
+  IREE_RETURN_IF_ERROR(iree_vm_module_initialize(&interface, allocator));
+  interface.begin_call = test_module_begin_call;
+  return iree_vm_native_module_create(&interface, &test_module_descriptor_,
+                                      host_allocator, out_module);
+}
+
+//===----------------------------------------------------------------------===//
+// iree_runtime_state_t
+//===----------------------------------------------------------------------===//
+
+class StateTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    IREE_ASSERT_OK(iree_hal_module_register_types());
+  }
+
+  void SetUp() override {
+    iree_runtime_instance_options_t instance_options;
+    iree_runtime_instance_options_initialize(IREE_API_VERSION_LATEST,
+                                             &instance_options);
+    IREE_ASSERT_OK(iree_runtime_instance_create(
+        &instance_options, iree_allocator_system(), &instance_));
+
+    iree_hal_sync_device_params_t params;
+    iree_hal_sync_device_params_initialize(&params);
+    IREE_ASSERT_OK(iree_hal_sync_device_create(
+        iree_make_cstring_view("sync"), &params, /*loader_count=*/0,
+        /*loaders=*/NULL, iree_allocator_system(), &device_));
+
+    iree_runtime_session_options_t session_options;
+    iree_runtime_session_options_initialize(&session_options);
+    IREE_ASSERT_OK(iree_runtime_session_create_with_device(
+        instance_, &session_options, device_, iree_allocator_system(),
+        &session_));
+
+    iree_vm_module_t* module = NULL;
+    IREE_ASSERT_OK(test_module_create(iree_hal_device_allocator(device_),
+                                      iree_allocator_system(), &module));
+    iree_status_t status = iree_runtime_session_append_module(session_, module);
+    iree_vm_module_release(module);
+    IREE_ASSERT_OK(status);
+  }
+
+  void TearDown() override {
+    iree_runtime_session_release(session_);
+    iree_hal_device_release(device_);
+    iree_runtime_instance_release(instance_);
+  }
+
+  // Creates a state with one zeroed [1, kLength] f32 value.
+  iree_runtime_state_t* CreateState() {
+    iree_runtime_state_t* state = NULL;
+    IREE_CHECK_OK(iree_runtime_state_create(session_, /*state_count=*/1,
+                                            iree_allocator_system(), &state));
+    const iree_hal_dim_t shape[2] = {1, kLength};
+    IREE_CHECK_OK(iree_runtime_state_allocate(state, 0, shape,
+                                              IREE_ARRAYSIZE(shape),
+                                              IREE_HAL_ELEMENT_TYPE_FLOAT_32));
+    return state;
+  }
+
+  // Initializes |out_call| as a call to |name| with |chunk| as its only
+  // non-state input.
+  void InitializeCall(const char* name, const std::vector<float>& chunk,
+                      iree_runtime_call_t* out_call) {
+    IREE_ASSERT_OK(iree_runtime_call_initialize_by_name(
+        session_, iree_make_cstring_view(name), out_call));
+    iree_hal_buffer_view_t* chunk_view = NULL;
+    IREE_ASSERT_OK(CreateBufferView(iree_hal_device_allocator(device_), chunk,
+                                    &chunk_view));
+    iree_status_t status =
+        iree_runtime_call_inputs_push_back_buffer_view(out_call, chunk_view);
+    iree_hal_buffer_view_release(chunk_view);
+    IREE_ASSERT_OK(status);
+  }
+
+  // Pops the sum output of |call| and returns its values.
+  static std::vector<float> PopSum(iree_runtime_call_t* call) {
+    iree_hal_buffer_view_t* sum = NULL;
+    IREE_CHECK_OK(iree_runtime_call_outputs_pop_front_buffer_view(call, &sum));
+    std::vector<float> values;
+    IREE_CHECK_OK(ReadBufferView(sum, &values));
+    iree_hal_buffer_view_release(sum);
+    return values;
+  }
+
+  static std::vector<float> StateValues(iree_runtime_state_t* state) {
+    std::vector<float> values;
+    IREE_CHECK_OK(
+        ReadBufferView(iree_runtime_state_buffer_view(state, 0), &values));
+    return values;
+  }
+
+  iree_runtime_instance_t* instance_ = NULL;
+  iree_hal_device_t* device_ = NULL;
+  iree_runtime_session_t* session_ = NULL;
+};
+
+// State values start unset and are zeroed when allocated.
+TEST_F(StateTest, Allocate) {
+  iree_runtime_state_t* state = NULL;
+  IREE_ASSERT_OK(iree_runtime_state_create(session_, /*state_count=*/1,
+                                           iree_allocator_system(), &state));
+  EXPECT_EQ(1u, iree_runtime_state_count(state));
+  EXPECT_EQ(NULL, iree_runtime_state_buffer_view(state, 0));
+  EXPECT_EQ(NULL, iree_runtime_state_buffer_view(state, 1));
+
+  const iree_hal_dim_t shape[2] = {1, kLength};
+  IREE_ASSERT_OK(iree_runtime_state_allocate(state, 0, shape,
+                                             IREE_ARRAYSIZE(shape),
+                                             IREE_HAL_ELEMENT_TYPE_FLOAT_32));
+  EXPECT_EQ(std::vector<float>(kLength, 0.0f), StateValues(state));
+  EXPECT_EQ(IREE_STATUS_OUT_OF_RANGE,
+            iree_status_consume_code(iree_runtime_state_allocate(
+                state, 1, shape, IREE_ARRAYSIZE(shape),
+                IREE_HAL_ELEMENT_TYPE_FLOAT_32)));
+  iree_runtime_state_release(state);
+}
+
+// The state returned by each call is passed to the next.
+TEST_F(StateTest, CarriesStateAcrossCalls) {
+  iree_runtime_state_t* state = CreateState();
+  iree_runtime_call_t call;
+  InitializeCall("test.step", {1.0f, 2.0f, 3.0f, 4.0f}, &call);
+  for (int i = 1; i <= 3; ++i) {
+    IREE_ASSERT_OK(iree_runtime_call_invoke_with_state(&call, state, 0));
+    std::vector<float> expected = {1.0f * i, 2.0f * i, 3.0f * i, 4.0f * i};
+    EXPECT_EQ(expected, StateValues(state));
+    // Only the non-state inputs and outputs remain in the call.
+    EXPECT_EQ(1u, iree_vm_list_size(iree_runtime_call_inputs(&call)));
+    EXPECT_EQ(1u, iree_vm_list_size(iree_runtime_call_outputs(&call)));
+    EXPECT_EQ(expected, PopSum(&call));
+  }
+  iree_runtime_call_deinitialize(&call);
+  iree_runtime_state_release(state);
+}
+
+// State results declared as output storage are updated in place.
+TEST_F(StateTest, UpdatesOutputStorageInPlace) {
+  iree_runtime_state_t* state = CreateState();
+  iree_hal_buffer_view_t* state_view = iree_runtime_state_buffer_view(state, 0);
+  iree_runtime_call_t call;
+  InitializeCall("test.step_in_place", {1.0f, 2.0f, 3.0f, 4.0f}, &call);
+  for (int i = 1; i <= 3; ++i) {
+    IREE_ASSERT_OK(iree_runtime_call_invoke_with_state(&call, state, 0));
+    EXPECT_EQ(state_view, iree_runtime_state_buffer_view(state, 0));
+    std::vector<float> expected = {1.0f * i, 2.0f * i, 3.0f * i, 4.0f * i};
+    EXPECT_EQ(expected, StateValues(state));
+    EXPECT_EQ(1u, iree_vm_list_size(iree_runtime_call_inputs(&call)));
+    EXPECT_EQ(expected, PopSum(&call));
+  }
+  iree_runtime_call_deinitialize(&call);
+  iree_runtime_state_release(state);
+}
+
+// A single call can be shared by independent states.
+TEST_F(StateTest, SharesCallAcrossStates) {
+  iree_runtime_state_t* state_a = CreateState();
+  iree_runtime_state_t* state_b = CreateState();
+  iree_runtime_call_t call;
+  InitializeCall("test.step", {1.0f, 1.0f, 1.0f, 1.0f}, &call);
+  IREE_ASSERT_OK(iree_runtime_call_invoke_with_state(&call, state_a, 0));
+  IREE_ASSERT_OK(iree_runtime_call_invoke_with_state(&call, state_b, 0));
+  IREE_ASSERT_OK(iree_runtime_call_invoke_with_state(&call, state_a, 0));
+  EXPECT_EQ(std::vector<float>(kLength, 2.0f), StateValues(state_a));
+  EXPECT_EQ(std::vector<float>(kLength, 1.0f), StateValues(state_b));
+  iree_runtime_call_deinitialize(&call);
+  iree_runtime_state_release(state_b);
+  iree_runtime_state_release(state_a);
+}
+
+// Resetting zeroes the state values in place.
+TEST_F(StateTest, Reset) {
+  iree_runtime_state_t* state = CreateState();
+  iree_runtime_call_t call;
+  InitializeCall("test.step_in_place", {1.0f, 2.0f, 3.0f, 4.0f}, &call);
+  IREE_ASSERT_OK(iree_runtime_call_invoke_with_state(&call, state, 0));
+  IREE_ASSERT_OK(iree_runtime_state_reset(state));
+  EXPECT_EQ(std::vector<float>(kLength, 0.0f), StateValues(state));
+  iree_runtime_call_deinitialize(&call);
+  iree_runtime_state_release(state);
+}
+
+// Calls fail without touching the call or state when the state is unset or
+// does not match the function.
+TEST_F(StateTest, RejectsInvalidState) {
+  iree_runtime_call_t call;
+  InitializeCall("test.step", {1.0f, 2.0f, 3.0f, 4.0f}, &call);
+
+  iree_runtime_state_t* unset_state = NULL;
+  IREE_ASSERT_OK(iree_runtime_state_create(session_, /*state_count=*/1,
+                                           iree_allocator_system(),
+                                           &unset_state));
+  EXPECT_EQ(IREE_STATUS_FAILED_PRECONDITION,
+            iree_status_consume_code(
+                iree_runtime_call_invoke_with_state(&call, unset_state, 0)));
+  iree_runtime_state_release(unset_state);
+
+  iree_runtime_state_t* empty_state = NULL;
+  IREE_ASSERT_OK(iree_runtime_state_create(session_, /*state_count=*/0,
+                                           iree_allocator_system(),
+                                           &empty_state));
+  EXPECT_EQ(IREE_STATUS_INVALID_ARGUMENT,
+            iree_status_consume_code(
+                iree_runtime_call_invoke_with_state(&call, empty_state, 0)));
+  iree_runtime_state_release(empty_state);
+
+  EXPECT_EQ(1u, iree_vm_list_size(iree_runtime_call_inputs(&call)));
+  iree_runtime_call_deinitialize(&call);
+}
+
+// A failed call leaves the state unchanged and the call reusable.
+TEST_F(StateTest, FailureLeavesStateUnchanged) {
+  iree_runtime_state_t* state = CreateState();
+  iree_hal_buffer_view_t* state_view = iree_runtime_state_buffer_view(state, 0);
+  iree_runtime_call_t call;
+  InitializeCall("test.step", {1.0f, -1.0f, 1.0f, 1.0f}, &call);
+  EXPECT_EQ(IREE_STATUS_INVALID_ARGUMENT,
+            iree_status_consume_code(
+                iree_runtime_call_invoke_with_state(&call, state, 0)));
+  EXPECT_EQ(state_view, iree_runtime_state_buffer_view(state, 0));
+  EXPECT_EQ(std::vector<float>(kLength, 0.0f), StateValues(state));
+  EXPECT_EQ(1u, iree_vm_list_size(iree_runtime_call_inputs(&call)));
+  iree_runtime_call_deinitialize(&call);
+  iree_runtime_state_release(state);
+}
+
+}  // namespace
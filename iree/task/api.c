@@ -6,10 +6,15 @@
 
 #include "iree/task/api.h"
 
+#include <errno.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <string.h>
 
+#include "iree/base/config.h"
+#include "iree/base/internal/file_io.h"
 #include "iree/base/internal/flags.h"
+#include "iree/base/internal/flight_recorder.h"
 #include "iree/base/tracing.h"
 #include "iree/task/topology.h"
 #include "iree/task/topology_cpuinfo.h"
@@ -34,6 +39,14 @@ IREE_FLAG(
     "threads that would otherwise need to perform the syscalls during\n"
     "coordination.");
 
+IREE_FLAG(
+    int32_t, task_worker_spin_us, 0,
+    "Maximum duration in microseconds each worker will spin waiting for\n"
+    "additional work before parking its thread. Spinning burns power and\n"
+    "takes cycles from other threads on the same cores; only set non-zero\n"
+    "values when wake latency matters more than thermals and system-wide\n"
+    "scheduling.");
+
 IREE_FLAG(
     int32_t, task_worker_local_memory, 64 * 1024,
     "Specifies the bytes of per-worker local memory allocated for use by\n"
@@ -43,6 +56,18 @@ IREE_FLAG(
     "only use a specific maximum amount of local memory and the runtime must\n"
     "be configured to make at least that amount of local memory available.");
 
+IREE_FLAG(
+    int32_t, task_flight_recorder_capacity, 0,
+    "Number of recent task system and HAL events retained by the process-wide\n"
+    "flight recorder. Events include task execution on each worker, steals,\n"
+    "waits, worker park/wake and HAL queue submissions. 0 disables recording.");
+
+IREE_FLAG(
+    string, task_flight_recorder_file, "",
+    "Chrome trace JSON file (viewable in Perfetto or chrome://tracing) the\n"
+    "flight recorder is dumped to when the process exits and, on POSIX, when\n"
+    "the process receives SIGUSR1. Requires --task_flight_recorder_capacity.");
+
 //===----------------------------------------------------------------------===//
 // Topology configuration
 //===----------------------------------------------------------------------===//
@@ -54,7 +79,13 @@ IREE_FLAG(
     "   Uses whatever the specified group count is and ignores the set mode.\n"
     " 'physical_cores':\n"
     "   Creates one group per physical core in the machine up to\n"
-    "   the value specified by --task_topology_max_group_count.\n"
+    "   the value specified by --task_topology_max_group_count. On\n"
+    "   heterogeneous systems slower cores are given proportionally smaller\n"
+    "   shares of each dispatch.\n"
+    " 'performance_cores':\n"
+    "   Creates one group per physical core excluding the slowest class of\n"
+    "   cores on heterogeneous systems (such as ARM big.LITTLE) up to the\n"
+    "   value specified by --task_topology_max_group_count.\n"
     " 'unique_l2_cache_groups':\n"
     "   Creates one group for each unique L2 cache group across all available\n"
     "   cores up to the value specified by --task_topology_max_group_count.\n"
@@ -78,52 +109,267 @@ IREE_FLAG(
 // TODO(benvanik): add --task_topology_dump to dump out the current machine
 // configuration as seen by the topology utilities.
 
+//===----------------------------------------------------------------------===//
+// Worker configuration tuning
+//===----------------------------------------------------------------------===//
+
+IREE_FLAG(
+    string, task_tuning_file, "",
+    "File of the best worker configurations measured per model and host, as\n"
+    "recorded by `iree-benchmark-module --task_sweep_group_counts=`. If it\n"
+    "has a record for --task_tuning_model on the current host the recorded\n"
+    "configuration replaces --task_topology_mode and\n"
+    "--task_topology_max_group_count.");
+
+IREE_FLAG(
+    string, task_tuning_model, "",
+    "Key of the model whose worker configuration is used from (or recorded\n"
+    "to) --task_tuning_file. Must not contain whitespace.");
+
+// Configuration set by iree_task_executor_override_worker_config, if any.
+static bool iree_task_worker_config_is_overridden = false;
+static iree_task_worker_config_t iree_task_worker_config_override;
+
+void iree_task_executor_override_worker_config(
+    const iree_task_worker_config_t* config) {
+  iree_task_worker_config_is_overridden = config != NULL;
+  if (config) iree_task_worker_config_override = *config;
+}
+
+// Returns the next space-separated field of |line| and advances past it.
+static iree_string_view_t iree_task_tuning_next_field(
+    iree_string_view_t* line) {
+  iree_string_view_t field = iree_string_view_empty();
+  do {
+    iree_string_view_split(*line, ' ', &field, line);
+  } while (iree_string_view_is_empty(field) &&
+           !iree_string_view_is_empty(*line));
+  return field;
+}
+
+static bool iree_task_tuning_is_valid_key(iree_string_view_t key) {
+  if (iree_string_view_is_empty(key)) return false;
+  for (iree_host_size_t i = 0; i < key.size; ++i) {
+    if (key.data[i] == ' ' || key.data[i] == '\t' || key.data[i] == '\n' ||
+        key.data[i] == '\r') {
+      return false;
+    }
+  }
+  return true;
+}
+
+iree_status_t iree_task_tuning_lookup(const char* path,
+                                      iree_string_view_t model_key,
+                                      iree_task_worker_config_t* out_config) {
+  IREE_ASSERT_ARGUMENT(path);
+  IREE_ASSERT_ARGUMENT(out_config);
+  memset(out_config, 0, sizeof(*out_config));
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  char host_key[128];
+  iree_task_topology_format_host_key(sizeof(host_key), host_key);
+
+  iree_byte_span_t contents = iree_make_byte_span(NULL, 0);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_file_read_contents(path, iree_allocator_system(), &contents));
+
+  // Malformed records (such as from a partial write) are skipped.
+  bool found = false;
+  iree_string_view_t remaining =
+      iree_make_string_view((const char*)contents.data, contents.data_length);
+  while (!iree_string_view_is_empty(remaining)) {
+    iree_string_view_t line = iree_string_view_empty();
+    iree_string_view_split(remaining, '\n', &line, &remaining);
+    line = iree_string_view_trim(line);
+    if (iree_string_view_is_empty(line) || line.data[0] == '#') continue;
+    iree_string_view_t record_model_key = iree_task_tuning_next_field(&line);
+    iree_string_view_t record_host_key = iree_task_tuning_next_field(&line);
+    iree_string_view_t record_mode = iree_task_tuning_next_field(&line);
+    iree_string_view_t record_count = iree_task_tuning_next_field(&line);
+    uint32_t max_group_count = 0;
+    if (!iree_string_view_equal(record_model_key, model_key) ||
+        !iree_string_view_equal(record_host_key,
+                                iree_make_cstring_view(host_key)) ||
+        iree_string_view_is_empty(record_mode) ||
+        record_mode.size >= sizeof(out_config->topology_mode) ||
+        !iree_string_view_atoi_uint32(record_count, &max_group_count) ||
+        max_group_count == 0) {
+      continue;
+    }
+    memcpy(out_config->topology_mode, record_mode.data, record_mode.size);
+    out_config->topology_mode[record_mode.size] = 0;
+    out_config->max_group_count = max_group_count;
+    found = true;
+  }
+  iree_allocator_free(iree_allocator_system(), contents.data);
+
+  IREE_TRACE_ZONE_END(z0);
+  if (!found) {
+    return iree_make_status(IREE_STATUS_NOT_FOUND,
+                            "no worker configuration recorded for '%.*s' on "
+                            "host '%s' in '%s'",
+                            (int)model_key.size, model_key.data, host_key,
+                            path);
+  }
+  return iree_ok_status();
+}
+
+iree_status_t iree_task_tuning_record(const char* path,
+                                      iree_string_view_t model_key,
+                                      const iree_task_worker_config_t* config,
+                                      double time_ms) {
+  IREE_ASSERT_ARGUMENT(path);
+  IREE_ASSERT_ARGUMENT(config);
+  if (!iree_task_tuning_is_valid_key(model_key)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "tuning model keys must be non-empty and not "
+                            "contain whitespace; got '%.*s'",
+                            (int)model_key.size, model_key.data);
+  }
+  if (!iree_task_tuning_is_valid_key(
+          iree_make_cstring_view(config->topology_mode))) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "invalid topology mode '%s'",
+                            config->topology_mode);
+  }
+#if IREE_FILE_IO_ENABLE
+  IREE_TRACE_ZONE_BEGIN(z0);
+  char host_key[128];
+  iree_task_topology_format_host_key(sizeof(host_key), host_key);
+  FILE* file = fopen(path, "ab");
+  if (!file) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "failed to open tuning file '%s'", path);
+  }
+  int ret = fprintf(file, "%.*s %s %s %zu %.4f\n", (int)model_key.size,
+                    model_key.data, host_key, config->topology_mode,
+                    config->max_group_count, time_ms);
+  fclose(file);
+  IREE_TRACE_ZONE_END(z0);
+  if (ret < 0) {
+    return iree_make_status(IREE_STATUS_DATA_LOSS,
+                            "failed to write tuning file '%s'", path);
+  }
+  return iree_ok_status();
+#else
+  return iree_make_status(IREE_STATUS_UNAVAILABLE, "File I/O is disabled");
+#endif  // IREE_FILE_IO_ENABLE
+}
+
+iree_status_t iree_task_tuning_record_from_flags(
+    const iree_task_worker_config_t* config, double time_ms) {
+  if (strlen(FLAG_task_tuning_file) == 0 ||
+      strlen(FLAG_task_tuning_model) == 0) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "recording worker configurations requires both "
+                            "--task_tuning_file and --task_tuning_model");
+  }
+  return iree_task_tuning_record(FLAG_task_tuning_file,
+                                 iree_make_cstring_view(FLAG_task_tuning_model),
+                                 config, time_ms);
+}
+
+// Returns the worker configuration recorded in --task_tuning_file for
+// --task_tuning_model, if any.
+static bool iree_task_tuning_lookup_from_flags(
+    iree_task_worker_config_t* out_config) {
+  if (strlen(FLAG_task_tuning_file) == 0 ||
+      strlen(FLAG_task_tuning_model) == 0) {
+    return false;
+  }
+  iree_status_t status = iree_task_tuning_lookup(
+      FLAG_task_tuning_file, iree_make_cstring_view(FLAG_task_tuning_model),
+      out_config);
+  if (!iree_status_is_ok(status)) {
+    // Untuned models and hosts fall back to the topology flags.
+    iree_status_ignore(status);
+    return false;
+  }
+  return true;
+}
+
 //===----------------------------------------------------------------------===//
 // Task system factory functions
 //===----------------------------------------------------------------------===//
 
+// Enables the flight recorder if requested. The recorder is process-wide and
+// enabling it again for subsequent executors is a no-op.
+static iree_status_t iree_task_flight_recorder_enable_from_flags(void) {
+  if (FLAG_task_flight_recorder_capacity <= 0) return iree_ok_status();
+  if (iree_flight_recorder_is_enabled()) return iree_ok_status();
+  IREE_RETURN_IF_ERROR(iree_flight_recorder_enable(
+      (iree_host_size_t)FLAG_task_flight_recorder_capacity));
+  if (strlen(FLAG_task_flight_recorder_file) == 0) return iree_ok_status();
+  return iree_flight_recorder_install_dump_handlers(
+      FLAG_task_flight_recorder_file);
+}
+
 iree_status_t iree_task_executor_create_from_flags(
     iree_allocator_t host_allocator, iree_task_executor_t** out_executor) {
   IREE_ASSERT_ARGUMENT(out_executor);
   *out_executor = NULL;
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  iree_task_scheduling_mode_t scheduling_mode = 0;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_task_flight_recorder_enable_from_flags());
+
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
   if (FLAG_task_scheduling_defer_worker_startup) {
-    scheduling_mode |= IREE_TASK_SCHEDULING_MODE_DEFER_WORKER_STARTUP;
+    options.scheduling_mode |= IREE_TASK_SCHEDULING_MODE_DEFER_WORKER_STARTUP;
   }
   if (FLAG_task_scheduling_dedicated_wait_thread) {
-    scheduling_mode |= IREE_TASK_SCHEDULING_MODE_DEDICATED_WAIT_THREAD;
+    options.scheduling_mode |= IREE_TASK_SCHEDULING_MODE_DEDICATED_WAIT_THREAD;
   }
-
-  iree_host_size_t worker_local_memory =
+  options.worker_spin_ns = (iree_duration_t)FLAG_task_worker_spin_us * 1000;
+  options.worker_local_memory_size =
       (iree_host_size_t)FLAG_task_worker_local_memory;
 
   iree_status_t status = iree_ok_status();
 
+  // An overridden or tuned configuration replaces all of the topology flags.
+  int32_t group_count = FLAG_task_topology_group_count;
+  const char* topology_mode = FLAG_task_topology_mode;
+  iree_host_size_t max_group_count =
+      (iree_host_size_t)FLAG_task_topology_max_group_count;
+  iree_task_worker_config_t tuned_config;
+  const iree_task_worker_config_t* config = NULL;
+  if (iree_task_worker_config_is_overridden) {
+    config = &iree_task_worker_config_override;
+  } else if (iree_task_tuning_lookup_from_flags(&tuned_config)) {
+    config = &tuned_config;
+  }
+  if (config) {
+    group_count = 0;
+    topology_mode = config->topology_mode;
+    max_group_count = config->max_group_count;
+  }
+
   iree_task_topology_t topology;
   iree_task_topology_initialize(&topology);
 
-  if (FLAG_task_topology_group_count != 0) {
-    iree_task_topology_initialize_from_group_count(
-        FLAG_task_topology_group_count, &topology);
-  } else if (strcmp(FLAG_task_topology_mode, "physical_cores") == 0) {
-    iree_task_topology_initialize_from_physical_cores(
-        FLAG_task_topology_max_group_count, &topology);
-  } else if (strcmp(FLAG_task_topology_mode, "unique_l2_cache_groups") == 0) {
-    iree_task_topology_initialize_from_unique_l2_cache_groups(
-        FLAG_task_topology_max_group_count, &topology);
+  if (group_count != 0) {
+    iree_task_topology_initialize_from_group_count(group_count, &topology);
+  } else if (strcmp(topology_mode, "physical_cores") == 0) {
+    iree_task_topology_initialize_from_physical_cores(max_group_count,
+                                                      &topology);
+  } else if (strcmp(topology_mode, "performance_cores") == 0) {
+    iree_task_topology_initialize_from_performance_cores(max_group_count,
+                                                         &topology);
+  } else if (strcmp(topology_mode, "unique_l2_cache_groups") == 0) {
+    iree_task_topology_initialize_from_unique_l2_cache_groups(max_group_count,
+                                                              &topology);
   } else {
     status = iree_make_status(
         IREE_STATUS_INVALID_ARGUMENT,
         "one of --task_topology_group_count or --task_topology_mode must be "
         "specified and be a valid value; have --task_topology_mode=%s.",
-        FLAG_task_topology_mode);
+        topology_mode);
   }
 
   if (iree_status_is_ok(status)) {
-    status = iree_task_executor_create(scheduling_mode, &topology,
-                                       worker_local_memory, host_allocator,
+    status = iree_task_executor_create(options, &topology, host_allocator,
                                        out_executor);
   }
 
@@ -25,6 +25,10 @@ extern "C" {
 // a newly created instance in |out_executor| that must be released by the
 // caller.
 //
+// If --task_tuning_file has a worker configuration recorded for the
+// --task_tuning_model on the current host it is used instead of the topology
+// flags.
+//
 // This utility method is useful when only a single executor exists within a
 // process as the flags are globals. When multiple executors may exist or
 // programmatic configuration is needed use the iree_task_executor_create method
@@ -32,6 +36,51 @@ extern "C" {
 iree_status_t iree_task_executor_create_from_flags(
     iree_allocator_t host_allocator, iree_task_executor_t** out_executor);
 
+//===----------------------------------------------------------------------===//
+// Worker configuration tuning
+//===----------------------------------------------------------------------===//
+
+// A task system worker configuration as selected by the topology flags.
+typedef struct iree_task_worker_config_t {
+  // NUL-terminated topology mode as accepted by --task_topology_mode. The mode
+  // defines which cores the workers are placed on.
+  char topology_mode[32];
+  // Maximum number of workers as with --task_topology_max_group_count.
+  iree_host_size_t max_group_count;
+} iree_task_worker_config_t;
+
+// Overrides the topology flags used by subsequent calls to
+// iree_task_executor_create_from_flags with |config| or restores the flags if
+// |config| is NULL. This allows tools to measure several configurations within
+// one process. Not thread-safe.
+void iree_task_executor_override_worker_config(
+    const iree_task_worker_config_t* config);
+
+// Looks up the worker configuration recorded for |model_key| on the current
+// host in the tuning file at |path|. Returns IREE_STATUS_NOT_FOUND if the file
+// does not exist or has no record for the model on this host.
+//
+// Tuning files contain one record per line:
+//   <model key> <host key> <topology mode> <max group count> <time in ms>
+// Records are appended as they are measured and later records take precedence.
+iree_status_t iree_task_tuning_lookup(const char* path,
+                                      iree_string_view_t model_key,
+                                      iree_task_worker_config_t* out_config);
+
+// Appends |config| as the best worker configuration for |model_key| on the
+// current host to the tuning file at |path|. |time_ms| is the measured time of
+// the model with the configuration and is only informational.
+iree_status_t iree_task_tuning_record(const char* path,
+                                      iree_string_view_t model_key,
+                                      const iree_task_worker_config_t* config,
+                                      double time_ms);
+
+// Records |config| for the model named by --task_tuning_model in the
+// --task_tuning_file. Returns IREE_STATUS_FAILED_PRECONDITION if either flag
+// is not set.
+iree_status_t iree_task_tuning_record_from_flags(
+    const iree_task_worker_config_t* config, double time_ms);
+
 //===----------------------------------------------------------------------===//
 // Task system simple invocation utilities
 //===----------------------------------------------------------------------===//
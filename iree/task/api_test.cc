@@ -0,0 +1,113 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/task/api.h"
+
+#include "iree/base/config.h"
+
+#if IREE_FILE_IO_ENABLE
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "iree/base/logging.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+std::string GetUniquePath(const char* unique_name) {
+  char* test_tmpdir = getenv("TEST_TMPDIR");
+  if (!test_tmpdir) {
+    test_tmpdir = getenv("TMPDIR");
+  }
+  if (!test_tmpdir) {
+    test_tmpdir = getenv("TEMP");
+  }
+  IREE_CHECK(test_tmpdir) << "TEST_TMPDIR/TMPDIR/TEMP not defined";
+  std::string path = test_tmpdir + std::string("/iree_test_") + unique_name;
+  std::remove(path.c_str());
+  return path;
+}
+
+iree_task_worker_config_t MakeConfig(const char* topology_mode,
+                                     iree_host_size_t max_group_count) {
+  iree_task_worker_config_t config;
+  memset(&config, 0, sizeof(config));
+  strncpy(config.topology_mode, topology_mode,
+          sizeof(config.topology_mode) - 1);
+  config.max_group_count = max_group_count;
+  return config;
+}
+
+TEST(TaskTuningTest, MissingFile) {
+  auto path = GetUniquePath("TaskTuningMissingFile");
+  iree_task_worker_config_t config;
+  IREE_EXPECT_STATUS_IS(
+      IREE_STATUS_NOT_FOUND,
+      iree_task_tuning_lookup(path.c_str(), iree_make_cstring_view("model"),
+                              &config));
+}
+
+TEST(TaskTuningTest, RecordLookup) {
+  auto path = GetUniquePath("TaskTuningRecordLookup");
+  auto recorded_config = MakeConfig("performance_cores", 8);
+  IREE_ASSERT_OK(iree_task_tuning_record(path.c_str(),
+                                         iree_make_cstring_view("model_a"),
+                                         &recorded_config, 12.5));
+
+  iree_task_worker_config_t config;
+  IREE_ASSERT_OK(iree_task_tuning_lookup(
+      path.c_str(), iree_make_cstring_view("model_a"), &config));
+  EXPECT_STREQ("performance_cores", config.topology_mode);
+  EXPECT_EQ(8, config.max_group_count);
+
+  // Other models are not affected.
+  IREE_EXPECT_STATUS_IS(
+      IREE_STATUS_NOT_FOUND,
+      iree_task_tuning_lookup(path.c_str(), iree_make_cstring_view("model"),
+                              &config));
+  std::remove(path.c_str());
+}
+
+TEST(TaskTuningTest, LastRecordWins) {
+  auto path = GetUniquePath("TaskTuningLastRecordWins");
+  auto first_config = MakeConfig("physical_cores", 16);
+  auto other_config = MakeConfig("physical_cores", 2);
+  auto last_config = MakeConfig("unique_l2_cache_groups", 4);
+  IREE_ASSERT_OK(iree_task_tuning_record(
+      path.c_str(), iree_make_cstring_view("model"), &first_config, 3.0));
+  IREE_ASSERT_OK(iree_task_tuning_record(
+      path.c_str(), iree_make_cstring_view("other"), &other_config, 1.0));
+  IREE_ASSERT_OK(iree_task_tuning_record(
+      path.c_str(), iree_make_cstring_view("model"), &last_config, 2.0));
+
+  iree_task_worker_config_t config;
+  IREE_ASSERT_OK(iree_task_tuning_lookup(
+      path.c_str(), iree_make_cstring_view("model"), &config));
+  EXPECT_STREQ("unique_l2_cache_groups", config.topology_mode);
+  EXPECT_EQ(4, config.max_group_count);
+  std::remove(path.c_str());
+}
+
+TEST(TaskTuningTest, InvalidModelKey) {
+  auto path = GetUniquePath("TaskTuningInvalidModelKey");
+  auto config = MakeConfig("physical_cores", 4);
+  IREE_EXPECT_STATUS_IS(
+      IREE_STATUS_INVALID_ARGUMENT,
+      iree_task_tuning_record(path.c_str(), iree_make_cstring_view("a model"),
+                              &config, 1.0));
+  IREE_EXPECT_STATUS_IS(
+      IREE_STATUS_INVALID_ARGUMENT,
+      iree_task_tuning_record(path.c_str(), iree_string_view_empty(), &config,
+                              1.0));
+}
+
+}  // namespace
+
+#endif  // IREE_FILE_IO_ENABLE
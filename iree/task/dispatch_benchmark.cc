@@ -0,0 +1,116 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Compares issuing tiny dispatches across the executor against running all of
+// their tiles inline within a single call task. The crossover point indicates
+// where the cost of allocating shards and waking workers is amortized by the
+// parallelism gained and is what the inline dispatch thresholds used by
+// iree/hal/local/task_command_buffer.c should be tuned against.
+
+#include <cstdint>
+
+#include "benchmark/benchmark.h"
+#include "iree/base/api.h"
+#include "iree/task/executor.h"
+#include "iree/task/scope.h"
+#include "iree/task/submission.h"
+#include "iree/task/task.h"
+#include "iree/task/topology.h"
+
+namespace {
+
+// Number of loop iterations of busy work performed by each tile. Tiny
+// elementwise dispatches run on the order of this many operations per
+// workgroup.
+constexpr int kTileWorkIterations = 256;
+
+iree_task_executor_t* GetExecutor() {
+  static iree_task_executor_t* executor = ([]() -> iree_task_executor_t* {
+    iree_task_topology_t topology;
+    iree_task_topology_initialize_from_group_count(8, &topology);
+    iree_task_executor_options_t options;
+    iree_task_executor_options_initialize(&options);
+    iree_task_executor_t* executor = NULL;
+    IREE_CHECK_OK(iree_task_executor_create(
+        options, &topology, iree_allocator_system(), &executor));
+    iree_task_topology_deinitialize(&topology);
+    return executor;
+  })();
+  return executor;
+}
+
+void DoTileWork(uint32_t tile_index) {
+  uint32_t value = tile_index;
+  for (int i = 0; i < kTileWorkIterations; ++i) {
+    value = value * 1664525u + 1013904223u;
+    benchmark::DoNotOptimize(value);
+  }
+}
+
+iree_status_t DispatchTile(uintptr_t user_context,
+                           const iree_task_tile_context_t* tile_context,
+                           iree_task_submission_t* pending_submission) {
+  DoTileWork(tile_context->workgroup_xyz[0]);
+  return iree_ok_status();
+}
+
+iree_status_t InlineCall(uintptr_t user_context, iree_task_t* task,
+                         iree_task_submission_t* pending_submission) {
+  uint32_t tile_count = (uint32_t)user_context;
+  for (uint32_t i = 0; i < tile_count; ++i) {
+    DoTileWork(i);
+  }
+  return iree_ok_status();
+}
+
+// Submits |task| and waits for it to complete.
+void SubmitAndWait(iree_task_executor_t* executor, iree_task_scope_t* scope,
+                   iree_task_t* task) {
+  iree_task_fence_t* fence = NULL;
+  IREE_CHECK_OK(iree_task_executor_acquire_fence(executor, scope, &fence));
+  iree_task_set_completion_task(task, &fence->header);
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  iree_task_submission_enqueue(&submission, task);
+  iree_task_executor_submit(executor, &submission);
+  iree_task_executor_flush(executor);
+  IREE_CHECK_OK(iree_task_scope_wait_idle(scope, IREE_TIME_INFINITE_FUTURE));
+}
+
+void BM_DispatchSharded(benchmark::State& state) {
+  iree_task_executor_t* executor = GetExecutor();
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("scope"), &scope);
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  const uint32_t workgroup_count[3] = {(uint32_t)state.range(0), 1, 1};
+  for (auto _ : state) {
+    iree_task_dispatch_t task;
+    iree_task_dispatch_initialize(
+        &scope, iree_task_make_dispatch_closure(DispatchTile, 0),
+        workgroup_size, workgroup_count, &task);
+    SubmitAndWait(executor, &scope, &task.header);
+  }
+  iree_task_scope_deinitialize(&scope);
+}
+BENCHMARK(BM_DispatchSharded)->RangeMultiplier(2)->Range(1, 512)->UseRealTime();
+
+void BM_DispatchInline(benchmark::State& state) {
+  iree_task_executor_t* executor = GetExecutor();
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("scope"), &scope);
+  for (auto _ : state) {
+    iree_task_call_t task;
+    iree_task_call_initialize(
+        &scope,
+        iree_task_make_call_closure(InlineCall, (uintptr_t)state.range(0)),
+        &task);
+    SubmitAndWait(executor, &scope, &task.header);
+  }
+  iree_task_scope_deinitialize(&scope);
+}
+BENCHMARK(BM_DispatchInline)->RangeMultiplier(2)->Range(1, 512)->UseRealTime();
+
+}  // namespace
@@ -11,6 +11,7 @@
 #include <string.h>
 
 #include "iree/base/internal/math.h"
+#include "iree/base/target_platform.h"
 #include "iree/base/tracing.h"
 #include "iree/task/affinity_set.h"
 #include "iree/task/executor_impl.h"
@@ -18,17 +19,44 @@
 #include "iree/task/pool.h"
 #include "iree/task/post_batch.h"
 #include "iree/task/queue.h"
+#include "iree/task/scope.h"
 #include "iree/task/task_impl.h"
 #include "iree/task/tuning.h"
 #include "iree/task/worker.h"
 
+#if defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_LINUX)
+#include <sys/mman.h>
+#endif  // IREE_PLATFORM_ANDROID || IREE_PLATFORM_LINUX
+
 static void iree_task_executor_destroy(iree_task_executor_t* executor);
 
-iree_status_t iree_task_executor_create(
-    iree_task_scheduling_mode_t scheduling_mode,
-    const iree_task_topology_t* topology,
-    iree_host_size_t worker_local_memory_size, iree_allocator_t allocator,
-    iree_task_executor_t** out_executor) {
+// Advises that the aligned large pages within |local_memory| be backed by
+// transparent large pages. Advisory only: ignored if unsupported.
+static void iree_task_executor_advise_local_memory(
+    iree_byte_span_t local_memory) {
+#if defined(MADV_HUGEPAGE) && IREE_TASK_EXECUTOR_LOCAL_MEMORY_LARGE_PAGE_SIZE
+  const uintptr_t page_size = IREE_TASK_EXECUTOR_LOCAL_MEMORY_LARGE_PAGE_SIZE;
+  uintptr_t start = iree_host_align((uintptr_t)local_memory.data, page_size);
+  uintptr_t end = ((uintptr_t)local_memory.data + local_memory.data_length) &
+                  ~(page_size - 1);
+  if (end > start) {
+    madvise((void*)start, end - start, MADV_HUGEPAGE);
+  }
+#endif  // MADV_HUGEPAGE
+}
+
+void iree_task_executor_options_initialize(
+    iree_task_executor_options_t* out_options) {
+  memset(out_options, 0, sizeof(*out_options));
+  out_options->scheduling_mode = IREE_TASK_SCHEDULING_MODE_RESERVED;
+  out_options->worker_spin_ns = 0;
+  out_options->worker_local_memory_size = 0;
+}
+
+iree_status_t iree_task_executor_create(iree_task_executor_options_t options,
+                                        const iree_task_topology_t* topology,
+                                        iree_allocator_t allocator,
+                                        iree_task_executor_t** out_executor) {
   iree_host_size_t worker_count = iree_task_topology_group_count(topology);
   if (worker_count > IREE_TASK_EXECUTOR_MAX_WORKER_COUNT) {
     return iree_make_status(
@@ -49,19 +77,19 @@ iree_status_t iree_task_executor_create(
   IREE_ASSERT_ARGUMENT(out_executor);
   *out_executor = NULL;
 
-  // The executor is followed in memory by worker[] + worker_local_memory[].
+  // The executor is followed in memory by worker[]. Each worker allocates its
+  // own local memory on its own thread (see
+  // iree_task_executor_grow_local_memory) so that it is placed on the worker's
+  // NUMA node and never shares cache lines with other workers.
   // The whole point is that we don't want destructive sharing between workers
   // so ensure we are aligned to at least the destructive interference size.
-  worker_local_memory_size = iree_host_align(
-      worker_local_memory_size, iree_hardware_destructive_interference_size);
   iree_host_size_t executor_base_size =
       iree_host_align(sizeof(iree_task_executor_t),
                       iree_hardware_destructive_interference_size);
   iree_host_size_t worker_list_size =
       iree_host_align(worker_count * sizeof(iree_task_worker_t),
                       iree_hardware_destructive_interference_size);
-  iree_host_size_t executor_size = executor_base_size + worker_list_size +
-                                   worker_count * worker_local_memory_size;
+  iree_host_size_t executor_size = executor_base_size + worker_list_size;
 
   iree_task_executor_t* executor = NULL;
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
@@ -69,11 +97,21 @@ iree_status_t iree_task_executor_create(
   memset(executor, 0, executor_size);
   iree_atomic_ref_count_init(&executor->ref_count);
   executor->allocator = allocator;
-  executor->scheduling_mode = scheduling_mode;
-  iree_atomic_task_slist_initialize(&executor->incoming_ready_slist);
+  executor->scheduling_mode = options.scheduling_mode;
+  executor->worker_spin_ns = options.worker_spin_ns;
+  for (iree_host_size_t i = 0; i < IREE_TASK_PRIORITY_COUNT; ++i) {
+    iree_atomic_task_sharded_slist_initialize(
+        &executor->incoming_ready_slists[i]);
+  }
   iree_atomic_task_slist_initialize(&executor->incoming_waiting_slist);
   iree_slim_mutex_initialize(&executor->coordinator_mutex);
   iree_slim_mutex_initialize(&executor->wait_mutex);
+  iree_slim_mutex_initialize(&executor->donation_mutex);
+  iree_atomic_store_int64(
+      &executor->local_memory_reservation,
+      (int64_t)iree_host_align(options.worker_local_memory_size,
+                               iree_hardware_destructive_interference_size),
+      iree_memory_order_relaxed);
 
   // Simple PRNG used to generate seeds for the per-worker PRNGs used to
   // distribute work. This isn't strong (and doesn't need to be); it's just
@@ -92,27 +130,50 @@ iree_status_t iree_task_executor_create(
   // Wait set used to batch syscalls for polling/waiting on wait handles.
   // This is currently limited to a relatively small max to make bad behavior
   // clearer with nice RESOURCE_EXHAUSTED errors.
+  // The handle reserved for internal use is the wait_interrupt_event.
+  if (iree_status_is_ok(status)) {
+    status =
+        iree_wait_set_allocate(IREE_TASK_EXECUTOR_MAX_OUTSTANDING_WAITS + 1,
+                               allocator, &executor->wait_set);
+  }
   if (iree_status_is_ok(status)) {
-    status = iree_wait_set_allocate(IREE_TASK_EXECUTOR_MAX_OUTSTANDING_WAITS,
-                                    allocator, &executor->wait_set);
+    status = iree_event_initialize(/*initial_state=*/false,
+                                   &executor->wait_interrupt_event);
   }
 
-  // Pool used for all dispatch->slice fanout tasks. These only live within the
-  // executor and since we know the precise lifetime of them we can keep them
-  // entirely within the system here.
   if (iree_status_is_ok(status)) {
     status = iree_task_pool_initialize(allocator, sizeof(iree_task_fence_t), 8,
                                        &executor->fence_task_pool);
   }
-  if (iree_status_is_ok(status)) {
+
+  // Pool used for all dispatch->slice fanout tasks. These only live within the
+  // executor and since we know the precise lifetime of them we can keep them
+  // entirely within the system here.
+  //
+  // Each NUMA node gets its own pool sized based on the number of workers
+  // attached to it. Machines without NUMA (or where we can't tell) will have
+  // all workers on node 0.
+  executor->numa_node_count =
+      iree_min(iree_task_topology_numa_node_count(topology),
+               IREE_TASK_EXECUTOR_MAX_NUMA_NODE_COUNT);
+  for (iree_host_size_t i = 0; i < worker_count; ++i) {
+    uint32_t numa_node = iree_task_topology_get_group(topology, i)->numa_node %
+                         executor->numa_node_count;
+    executor->numa_node_worker_masks[numa_node] |=
+        iree_task_affinity_for_worker(i);
+  }
+  for (iree_host_size_t i = 0;
+       i < executor->numa_node_count && iree_status_is_ok(status); ++i) {
+    iree_host_size_t node_worker_count =
+        iree_task_affinity_set_count_ones(executor->numa_node_worker_masks[i]);
     status = iree_task_pool_initialize(
         allocator,
         iree_max(sizeof(iree_task_dispatch_shard_t),
                  sizeof(iree_task_dispatch_slice_t)),
-        worker_count *
+        node_worker_count *
             iree_max(IREE_TASK_EXECUTOR_INITIAL_SHARD_RESERVATION_PER_WORKER,
                      IREE_TASK_EXECUTOR_INITIAL_SLICE_RESERVATION_PER_WORKER),
-        &executor->dispatch_task_pool);
+        &executor->dispatch_task_pools[i]);
   }
 
   // Bring up the workers; the threads will be created here but be suspended
@@ -121,8 +182,6 @@ iree_status_t iree_task_executor_create(
     executor->worker_count = worker_count;
     executor->workers =
         (iree_task_worker_t*)((uint8_t*)executor + executor_base_size);
-    uint8_t* worker_local_memory =
-        (uint8_t*)executor->workers + worker_list_size;
 
     iree_task_affinity_set_t worker_idle_mask = 0;
     iree_task_affinity_set_t worker_live_mask = 0;
@@ -139,9 +198,7 @@ iree_status_t iree_task_executor_create(
       iree_task_worker_t* worker = &executor->workers[i];
       status = iree_task_worker_initialize(
           executor, i, iree_task_topology_get_group(topology, i),
-          iree_make_byte_span(worker_local_memory, worker_local_memory_size),
           &seed_prng, worker);
-      worker_local_memory += worker_local_memory_size;
       if (!iree_status_is_ok(status)) break;
     }
     iree_atomic_task_affinity_set_store(&executor->worker_live_mask,
@@ -187,13 +244,23 @@ static void iree_task_executor_destroy(iree_task_executor_t* executor) {
     iree_task_worker_deinitialize(worker);
   }
 
+  iree_task_executor_release_local_memory(executor,
+                                          &executor->donation_local_memory);
+  iree_event_deinitialize(&executor->wait_interrupt_event);
   iree_wait_set_free(executor->wait_set);
+  iree_slim_mutex_deinitialize(&executor->donation_mutex);
   iree_slim_mutex_deinitialize(&executor->wait_mutex);
   iree_slim_mutex_deinitialize(&executor->coordinator_mutex);
-  iree_atomic_task_slist_deinitialize(&executor->incoming_ready_slist);
+  for (iree_host_size_t i = 0; i < IREE_TASK_PRIORITY_COUNT; ++i) {
+    iree_task_list_discard(&executor->deferred_ready_lists[i]);
+    iree_atomic_task_sharded_slist_deinitialize(
+        &executor->incoming_ready_slists[i]);
+  }
   iree_atomic_task_slist_deinitialize(&executor->incoming_waiting_slist);
   iree_task_pool_deinitialize(&executor->fence_task_pool);
-  iree_task_pool_deinitialize(&executor->dispatch_task_pool);
+  for (iree_host_size_t i = 0; i < executor->numa_node_count; ++i) {
+    iree_task_pool_deinitialize(&executor->dispatch_task_pools[i]);
+  }
   iree_allocator_free(executor->allocator, executor);
 
   IREE_TRACE_ZONE_END(z0);
@@ -211,6 +278,130 @@ void iree_task_executor_release(iree_task_executor_t* executor) {
   }
 }
 
+iree_host_size_t iree_task_executor_worker_count(
+    iree_task_executor_t* executor) {
+  return executor->worker_count;
+}
+
+void iree_task_executor_reserve_local_memory(
+    iree_task_executor_t* executor, iree_host_size_t local_memory_size) {
+  int64_t new_size = (int64_t)iree_host_align(
+      local_memory_size, iree_hardware_destructive_interference_size);
+  int64_t old_size = iree_atomic_load_int64(&executor->local_memory_reservation,
+                                            iree_memory_order_relaxed);
+  while (new_size > old_size) {
+    if (iree_atomic_compare_exchange_weak_int64(
+            &executor->local_memory_reservation, &old_size, new_size,
+            iree_memory_order_relaxed, iree_memory_order_relaxed)) {
+      break;
+    }
+  }
+}
+
+void iree_task_executor_grow_local_memory(
+    iree_task_executor_t* executor, iree_host_size_t minimum_size,
+    iree_task_local_memory_t* local_memory) {
+  if (minimum_size <= local_memory->span.data_length) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)minimum_size);
+
+  // Over-allocate so that the usable span can start on its own cache line.
+  // The memory is intentionally left uninitialized: the first touch happens on
+  // the calling thread, which is what places the pages on its NUMA node.
+  const iree_host_size_t alignment =
+      iree_hardware_destructive_interference_size;
+  void* allocation = NULL;
+  iree_status_t status = iree_allocator_malloc_uninitialized(
+      executor->allocator, minimum_size + alignment, &allocation);
+  if (iree_status_is_ok(status)) {
+    iree_task_executor_release_local_memory(executor, local_memory);
+    local_memory->allocation = allocation;
+    local_memory->span = iree_make_byte_span(
+        (uint8_t*)iree_host_align((uintptr_t)allocation, alignment),
+        minimum_size);
+    iree_task_executor_advise_local_memory(local_memory->span);
+  } else {
+    // Keep the existing (smaller) memory; dispatches that need more will fail
+    // their local memory size check and propagate the error to their scope.
+    iree_status_ignore(status);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+void iree_task_executor_release_local_memory(
+    iree_task_executor_t* executor, iree_task_local_memory_t* local_memory) {
+  iree_allocator_free(executor->allocator, local_memory->allocation);
+  memset(local_memory, 0, sizeof(*local_memory));
+}
+
+iree_status_t iree_task_executor_query_worker_statistics(
+    iree_task_executor_t* executor, iree_host_size_t worker_index,
+    iree_task_worker_statistics_t* out_statistics) {
+  IREE_ASSERT_ARGUMENT(executor);
+  IREE_ASSERT_ARGUMENT(out_statistics);
+  memset(out_statistics, 0, sizeof(*out_statistics));
+  if (worker_index >= executor->worker_count) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "worker index %zu out of range (%zu workers)",
+                            worker_index, executor->worker_count);
+  }
+  iree_task_worker_query_statistics(&executor->workers[worker_index],
+                                    out_statistics);
+  return iree_ok_status();
+}
+
+void iree_task_executor_query_statistics(
+    iree_task_executor_t* executor,
+    iree_task_executor_statistics_t* out_statistics) {
+  IREE_ASSERT_ARGUMENT(executor);
+  IREE_ASSERT_ARGUMENT(out_statistics);
+  memset(out_statistics, 0, sizeof(*out_statistics));
+  out_statistics->worker_count = executor->worker_count;
+  out_statistics->idle_worker_count = iree_task_affinity_set_count_ones(
+      iree_atomic_task_affinity_set_load(&executor->worker_idle_mask,
+                                         iree_memory_order_relaxed) &
+      iree_atomic_task_affinity_set_load(&executor->worker_live_mask,
+                                         iree_memory_order_relaxed));
+  // Counters may transiently underflow as they are updated independently of
+  // the lists they track.
+  out_statistics->pending_task_count = (uint64_t)iree_max(
+      0, iree_atomic_load_int64(&executor->pending_task_count,
+                                iree_memory_order_relaxed));
+  out_statistics->waiting_task_count = (uint64_t)iree_max(
+      0, iree_atomic_load_int64(&executor->waiting_task_count,
+                                iree_memory_order_relaxed));
+  out_statistics->donated_task_count = (uint64_t)iree_atomic_load_int64(
+      &executor->donated_task_count, iree_memory_order_relaxed);
+  out_statistics->donated_tile_count = (uint64_t)iree_atomic_load_int64(
+      &executor->donated_tile_count, iree_memory_order_relaxed);
+
+  // Aggregate the worker statistics; latencies take the max across workers.
+  iree_task_worker_statistics_t* totals = &out_statistics->worker_totals;
+  for (iree_host_size_t i = 0; i < executor->worker_count; ++i) {
+    iree_task_worker_statistics_t worker_statistics;
+    memset(&worker_statistics, 0, sizeof(worker_statistics));
+    iree_task_worker_query_statistics(&executor->workers[i],
+                                      &worker_statistics);
+    for (iree_host_size_t j = 0; j < IREE_TASK_STEAL_LOCALITY_COUNT; ++j) {
+      totals->steal_count[j] += worker_statistics.steal_count[j];
+    }
+    totals->spin_wake_count += worker_statistics.spin_wake_count;
+    totals->park_count += worker_statistics.park_count;
+    totals->park_wake_latency_total_ns +=
+        worker_statistics.park_wake_latency_total_ns;
+    totals->park_wake_latency_max_ns =
+        iree_max(totals->park_wake_latency_max_ns,
+                 worker_statistics.park_wake_latency_max_ns);
+    totals->task_count += worker_statistics.task_count;
+    totals->tile_count += worker_statistics.tile_count;
+    totals->failed_steal_count += worker_statistics.failed_steal_count;
+    totals->busy_ns += worker_statistics.busy_ns;
+    totals->idle_ns += worker_statistics.idle_ns;
+    totals->steal_ns += worker_statistics.steal_ns;
+  }
+}
+
 iree_status_t iree_task_executor_acquire_fence(iree_task_executor_t* executor,
                                                iree_task_scope_t* scope,
                                                iree_task_fence_t** out_fence) {
@@ -261,8 +452,11 @@ void iree_task_executor_schedule_ready_tasks(
         iree_task_nop_retire((iree_task_nop_t*)task, pending_submission);
         break;
       case IREE_TASK_TYPE_CALL:
-      case IREE_TASK_TYPE_DISPATCH_SLICE: {
+      case IREE_TASK_TYPE_DISPATCH_SLICE:
+      case IREE_TASK_TYPE_DISPATCH_SHARD: {
         // Generic routing to workers for tasks that should always run there.
+        // Shards only arrive here after being preempted by higher priority
+        // work as they are otherwise posted directly when issued.
         iree_task_executor_relay_to_worker(executor, post_batch, task);
         break;
       }
@@ -298,11 +492,9 @@ void iree_task_executor_schedule_ready_tasks(
         } else {
           if (task->flags & IREE_TASK_FLAG_DISPATCH_SLICED) {
             iree_task_dispatch_issue_sliced((iree_task_dispatch_t*)task,
-                                            &executor->dispatch_task_pool,
                                             pending_submission, post_batch);
           } else {
             iree_task_dispatch_issue_sharded((iree_task_dispatch_t*)task,
-                                             &executor->dispatch_task_pool,
                                              pending_submission, post_batch);
           }
         }
@@ -314,14 +506,37 @@ void iree_task_executor_schedule_ready_tasks(
 }
 
 void iree_task_executor_merge_submission(iree_task_executor_t* executor,
+                                         iree_task_worker_t* current_worker,
                                          iree_task_submission_t* submission) {
+  // Split the ready tasks into their priority lanes. Most submissions contain
+  // tasks of a single priority but those produced by workers may contain any
+  // mix. Relative order within each lane is preserved.
+  iree_task_list_t lane_lists[IREE_TASK_PRIORITY_COUNT];
+  for (iree_host_size_t i = 0; i < IREE_TASK_PRIORITY_COUNT; ++i) {
+    iree_task_list_initialize(&lane_lists[i]);
+  }
+  int64_t ready_task_count = 0;
+  iree_task_t* task = NULL;
+  while ((task = iree_task_list_pop_front(&submission->ready_list))) {
+    iree_task_list_push_back(&lane_lists[task->priority], task);
+    ++ready_task_count;
+  }
+  iree_atomic_fetch_add_int64(&executor->pending_task_count, ready_task_count,
+                              iree_memory_order_relaxed);
+
   // Concatenate all of the incoming tasks into the submission list.
   // Note that the submission stores tasks in LIFO order such that when they are
   // put into the LIFO atomic slist they match the order across all concats
   // (earlier concats are later in the LIFO list).
-  iree_atomic_task_slist_concat(&executor->incoming_ready_slist,
-                                submission->ready_list.head,
-                                submission->ready_list.tail);
+  iree_host_size_t shard_hint =
+      current_worker ? (iree_host_size_t)(current_worker - executor->workers)
+                     : 0;
+  for (iree_host_size_t i = 0; i < IREE_TASK_PRIORITY_COUNT; ++i) {
+    if (iree_task_list_is_empty(&lane_lists[i])) continue;
+    iree_atomic_task_sharded_slist_concat(&executor->incoming_ready_slists[i],
+                                          shard_hint, lane_lists[i].head,
+                                          lane_lists[i].tail);
+  }
   iree_atomic_task_slist_concat(&executor->incoming_waiting_slist,
                                 submission->waiting_list.head,
                                 submission->waiting_list.tail);
@@ -336,8 +551,21 @@ void iree_task_executor_submit(iree_task_executor_t* executor,
                                iree_task_submission_t* submission) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // Assign the submission priority to all root tasks; tasks they ready will
+  // inherit it as they retire.
+  IREE_ASSERT_LT(submission->priority, IREE_TASK_PRIORITY_COUNT);
+  for (iree_task_t* task = submission->ready_list.head; task != NULL;
+       task = task->next_task) {
+    task->priority = submission->priority;
+  }
+  for (iree_task_t* task = submission->waiting_list.head; task != NULL;
+       task = task->next_task) {
+    task->priority = submission->priority;
+  }
+
   // Concatenate the submitted tasks onto our primary LIFO incoming lists.
-  iree_task_executor_merge_submission(executor, submission);
+  iree_task_executor_merge_submission(executor, /*current_worker=*/NULL,
+                                      submission);
 
   IREE_TRACE_ZONE_END(z0);
 }
@@ -366,6 +594,7 @@ static void iree_task_executor_merge_wait_list(
   iree_slim_mutex_lock(&executor->wait_mutex);
 
   // Walk the list of incoming wait tasks and add them to our wait_set.
+  int64_t waiting_task_count = 0;
   iree_task_wait_t* wait_task =
       (iree_task_wait_t*)iree_task_list_front(incoming_waiting_list);
   do {
@@ -375,7 +604,10 @@ static void iree_task_executor_merge_wait_list(
     IREE_ASSERT_TRUE(iree_status_is_ok(status));
     iree_status_ignore(status);
     wait_task = (iree_task_wait_t*)wait_task->header.next_task;
+    ++waiting_task_count;
   } while (wait_task);
+  iree_atomic_fetch_add_int64(&executor->waiting_task_count,
+                              waiting_task_count, iree_memory_order_relaxed);
 
   iree_slim_mutex_unlock(&executor->wait_mutex);
 
@@ -408,6 +640,8 @@ static void iree_task_executor_wake_waiting_task(
       if (iree_task_wait_check_condition(wait_task)) {
         iree_wait_set_erase(executor->wait_set, wake_handle);
         iree_task_list_erase(&executor->waiting_list, prev_task, task);
+        iree_atomic_fetch_sub_int64(&executor->waiting_task_count, 1,
+                                    iree_memory_order_relaxed);
         iree_task_submission_enqueue(pending_submission, task);
         task = prev_task;
       }
@@ -469,6 +703,24 @@ static void iree_task_executor_poll_waiting_tasks(
   IREE_TRACE_ZONE_END(z0);
 }
 
+// Returns true if tasks have been posted to any of the workers in
+// |worker_mask| that they have not yet flushed from their mailboxes.
+static bool iree_task_executor_has_posted_tasks(
+    iree_task_executor_t* executor, iree_task_affinity_set_t worker_mask) {
+  int worker_index = 0;
+  int worker_count = iree_task_affinity_set_count_ones(worker_mask);
+  for (int i = 0; i < worker_count; ++i) {
+    int offset = iree_task_affinity_set_count_trailing_zeros(worker_mask);
+    worker_index += offset;
+    if (iree_task_worker_has_posted_tasks(&executor->workers[worker_index])) {
+      return true;
+    }
+    ++worker_index;
+    worker_mask = iree_shr(worker_mask, offset + 1);
+  }
+  return false;
+}
+
 // Waits for one or more waiting tasks to be ready to execute.
 // If a wait task retires any newly-ready tasks will be added to
 // |pending_submission|.
@@ -480,6 +732,13 @@ static void iree_task_executor_wait_any_task(
   if (iree_task_list_is_empty(&executor->waiting_list)) return;
 
   IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Coordinators posting tasks to the worker check this (while holding the
+  // coordinator lock) to know whether they need to interrupt the wait.
+  iree_task_affinity_set_t worker_bit =
+      current_worker ? current_worker->worker_bit : 0;
+  iree_atomic_task_affinity_set_fetch_or(&executor->worker_wait_mask,
+                                         worker_bit, iree_memory_order_seq_cst);
   iree_slim_mutex_unlock(&executor->coordinator_mutex);
 
   // We can't hold the coordinator lock during the wait but also need to ensure
@@ -503,18 +762,56 @@ static void iree_task_executor_wait_any_task(
 
   iree_slim_mutex_lock(&executor->wait_mutex);
 
-  iree_time_t deadline_ns = IREE_TIME_INFINITE_FUTURE;
+  // Tasks posted to waiting workers (this one or those blocked on the wait
+  // lock behind it) interrupt the wait via the wait_interrupt_event. Tasks
+  // posted before the event was reset are instead picked up by checking the
+  // mailboxes so that no worker blocks with tasks pending in it. Other
+  // coordinators may have polled and woken the remaining waiting tasks since
+  // the coordinator lock was released in which case there is nothing to wait
+  // on.
+  iree_event_reset(&executor->wait_interrupt_event);
+  iree_status_t status = iree_ok_status();
   iree_wait_handle_t wake_handle;
-  iree_status_t status =
-      iree_wait_any(executor->wait_set, deadline_ns, &wake_handle);
+  memset(&wake_handle, 0, sizeof(wake_handle));
+  if (iree_atomic_load_int64(&executor->waiting_task_count,
+                             iree_memory_order_relaxed) == 0 ||
+      iree_task_executor_has_posted_tasks(
+          executor, iree_atomic_task_affinity_set_load(
+                        &executor->worker_wait_mask,
+                        iree_memory_order_seq_cst))) {
+    status = iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+  } else {
+    status = iree_wait_set_insert(executor->wait_set,
+                                  executor->wait_interrupt_event);
+  }
+  if (iree_status_is_ok(status)) {
+    iree_time_t deadline_ns = IREE_TIME_INFINITE_FUTURE;
+    uint32_t flight_recorder_track =
+        iree_task_worker_flight_recorder_track(current_worker);
+    IREE_FLIGHT_RECORD_BEGIN(flight_recorder_track, "wait_any", 0);
+    status = iree_wait_any(executor->wait_set, deadline_ns, &wake_handle);
+    IREE_FLIGHT_RECORD_END(flight_recorder_track, "wait_any");
+    iree_wait_set_erase(executor->wait_set, executor->wait_interrupt_event);
+    if (iree_status_is_ok(status) &&
+        wake_handle.type == executor->wait_interrupt_event.type &&
+        memcmp(&wake_handle.value, &executor->wait_interrupt_event.value,
+               sizeof(wake_handle.value)) == 0) {
+      // Interrupted; return to the worker to process its new tasks.
+      status = iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+    }
+  }
 
   iree_slim_mutex_unlock(&executor->wait_mutex);
 
   // TODO(#4026): propagate failure to all scopes involved.
-  IREE_ASSERT_TRUE(iree_status_is_ok(status));
+  IREE_ASSERT_TRUE(iree_status_is_ok(status) ||
+                   iree_status_is_deadline_exceeded(status));
   iree_status_ignore(status);
 
   iree_slim_mutex_lock(&executor->coordinator_mutex);
+  iree_atomic_task_affinity_set_fetch_and(&executor->worker_wait_mask,
+                                          ~worker_bit,
+                                          iree_memory_order_relaxed);
 
   int woken_tasks = 0;
   if (iree_status_is_ok(status)) {
@@ -541,6 +838,129 @@ static void iree_task_executor_wait_any_task(
   IREE_TRACE_ZONE_END(z0);
 }
 
+// Reorders the tasks in |list| such that those from scopes with lower virtual
+// time are scheduled first. The relative order of tasks within each scope is
+// preserved. Scopes that have fallen more than
+// IREE_TASK_EXECUTOR_MAX_FAIRNESS_LAG_NS behind the executor virtual time (as
+// when they were idle) are advanced before being ordered.
+//
+// Only called during coordination and expects the coordinator lock to be held.
+static void iree_task_executor_order_by_scope_virtual_time(
+    iree_task_executor_t* executor, iree_task_list_t* list) {
+  // Tasks are bucketed per scope; tasks from scopes beyond the maximum fair
+  // scope count share the last bucket and are scheduled last.
+  iree_task_scope_t* scopes[IREE_TASK_EXECUTOR_MAX_FAIR_SCOPE_COUNT];
+  int64_t scope_virtual_times[IREE_TASK_EXECUTOR_MAX_FAIR_SCOPE_COUNT];
+  iree_task_list_t scope_lists[IREE_TASK_EXECUTOR_MAX_FAIR_SCOPE_COUNT + 1];
+  iree_task_list_t* overflow_list =
+      &scope_lists[IREE_TASK_EXECUTOR_MAX_FAIR_SCOPE_COUNT];
+  iree_task_list_initialize(overflow_list);
+  iree_host_size_t scope_count = 0;
+  const int64_t min_virtual_time_ns =
+      executor->virtual_time_ns - IREE_TASK_EXECUTOR_MAX_FAIRNESS_LAG_NS;
+  iree_task_t* task = NULL;
+  while ((task = iree_task_list_pop_front(list))) {
+    iree_host_size_t i = 0;
+    while (i < scope_count && scopes[i] != task->scope) ++i;
+    if (i == scope_count) {
+      if (scope_count == IREE_TASK_EXECUTOR_MAX_FAIR_SCOPE_COUNT) {
+        iree_task_list_push_back(overflow_list, task);
+        continue;
+      }
+      scopes[i] = task->scope;
+      if (task->scope) {
+        iree_task_scope_advance_virtual_time(task->scope, min_virtual_time_ns);
+        scope_virtual_times[i] = iree_task_scope_virtual_time(task->scope);
+      } else {
+        scope_virtual_times[i] = INT64_MIN;
+      }
+      iree_task_list_initialize(&scope_lists[i]);
+      ++scope_count;
+    }
+    iree_task_list_push_back(&scope_lists[i], task);
+  }
+
+  // Append the scope lists in ascending virtual time. Few scopes are expected
+  // to have tasks ready at once so a selection sort is sufficient.
+  for (iree_host_size_t n = 0; n < scope_count; ++n) {
+    iree_host_size_t min_index = n;
+    for (iree_host_size_t i = n + 1; i < scope_count; ++i) {
+      if (scope_virtual_times[i] < scope_virtual_times[min_index]) {
+        min_index = i;
+      }
+    }
+    if (min_index != n) {
+      iree_task_scope_t* scope = scopes[n];
+      scopes[n] = scopes[min_index];
+      scopes[min_index] = scope;
+      int64_t scope_virtual_time = scope_virtual_times[n];
+      scope_virtual_times[n] = scope_virtual_times[min_index];
+      scope_virtual_times[min_index] = scope_virtual_time;
+      iree_task_list_t scope_list = scope_lists[n];
+      scope_lists[n] = scope_lists[min_index];
+      scope_lists[min_index] = scope_list;
+    }
+    iree_task_list_append(list, &scope_lists[n]);
+  }
+  iree_task_list_append(list, overflow_list);
+
+  // The executor virtual time follows the scope that is furthest behind among
+  // those with work so that scopes becoming active again start near it.
+  if (scope_count > 0 && scope_virtual_times[0] != INT64_MIN &&
+      scope_virtual_times[0] > executor->virtual_time_ns) {
+    executor->virtual_time_ns = scope_virtual_times[0];
+  }
+}
+
+// Flushes the incoming ready lanes into the |pending_submission| ready list in
+// priority order with the tasks of each lane ordered by scope virtual time so
+// that concurrent scopes share the workers fairly. A lane is deferred if any
+// higher priority lane had tasks unless it has already been deferred for the
+// maximum number of consecutive passes, after which it is scheduled regardless
+// so that it makes progress.
+// Returns true if any tasks were deferred.
+//
+// Only called during coordination and expects the coordinator lock to be held.
+static bool iree_task_executor_flush_ready_lanes(
+    iree_task_executor_t* executor,
+    iree_task_submission_t* pending_submission) {
+  bool has_higher_priority_tasks = false;
+  bool has_deferred_tasks = false;
+  for (iree_host_size_t i = 0; i < IREE_TASK_PRIORITY_COUNT; ++i) {
+    // Tasks deferred from prior passes are kept ahead of newly arrived ones.
+    iree_task_list_t incoming_list;
+    iree_task_list_initialize(&incoming_list);
+    iree_atomic_task_sharded_slist_flush(
+        &executor->incoming_ready_slists[i],
+        IREE_ATOMIC_SLIST_FLUSH_ORDER_APPROXIMATE_LIFO, &incoming_list.head,
+        &incoming_list.tail);
+    iree_task_list_t* lane_list = &executor->deferred_ready_lists[i];
+    iree_task_list_append(lane_list, &incoming_list);
+    if (iree_task_list_is_empty(lane_list)) {
+      executor->deferral_counts[i] = 0;
+      continue;
+    }
+
+    if (has_higher_priority_tasks &&
+        executor->deferral_counts[i] <
+            IREE_TASK_EXECUTOR_MAX_PRIORITY_DEFERRAL_COUNT) {
+      ++executor->deferral_counts[i];
+      has_deferred_tasks = true;
+      continue;
+    }
+
+    executor->deferral_counts[i] = 0;
+    iree_atomic_fetch_sub_int64(
+        &executor->pending_task_count,
+        (int64_t)iree_task_list_calculate_size(lane_list),
+        iree_memory_order_relaxed);
+    iree_task_executor_order_by_scope_virtual_time(executor, lane_list);
+    iree_task_list_append(&pending_submission->ready_list, lane_list);
+    has_higher_priority_tasks = true;
+  }
+  return has_deferred_tasks;
+}
+
 // Dispatches tasks in the global submission queue to workers.
 // This is called by users upon submission of new tasks or by workers when they
 // run out of tasks to process. |wait_on_idle| indicates whether the
@@ -553,6 +973,11 @@ static void iree_task_executor_wait_any_task(
 // those cases the next step for the worker would have been to wait anyway. In
 // the non-speculative case the coordinator polls the wait handles to see if
 // they have resolved instead, possibly readying more tasks immediately.
+//
+// Ready tasks are flushed from the incoming lanes in priority order such that
+// higher priority tasks are scheduled to workers first. Lower priority lanes
+// are deferred entirely while higher priority tasks are being scheduled up to
+// IREE_TASK_EXECUTOR_MAX_PRIORITY_DEFERRAL_COUNT passes in a row.
 void iree_task_executor_coordinate(iree_task_executor_t* executor,
                                    iree_task_worker_t* current_worker,
                                    bool wait_on_idle) {
@@ -581,8 +1006,9 @@ void iree_task_executor_coordinate(iree_task_executor_t* executor,
     // various places and have no relation - hopefully leading to better average
     // latency.
     iree_task_submission_t pending_submission;
-    iree_task_submission_initialize_from_lifo_slist(
-        &executor->incoming_ready_slist, &pending_submission);
+    iree_task_submission_initialize(&pending_submission);
+    bool has_deferred_tasks =
+        iree_task_executor_flush_ready_lanes(executor, &pending_submission);
     iree_task_list_append_from_fifo_slist(&pending_submission.waiting_list,
                                           &executor->incoming_waiting_slist);
 
@@ -620,7 +1046,7 @@ void iree_task_executor_coordinate(iree_task_executor_t* executor,
     // Post all new work to workers; they may wake and begin executing
     // immediately. Returns whether this worker has new tasks for it to work on.
     bool did_post = iree_task_post_batch_submit(post_batch);
-    if (!did_post && wait_on_idle) {
+    if (!did_post && wait_on_idle && !has_deferred_tasks) {
       // No work was found; wait on one or more of our wait handles.
       // This will block the calling thread but that's fine as they were going
       // to wait anyway and were just speculatively seeing if there was work
@@ -634,10 +1060,13 @@ void iree_task_executor_coordinate(iree_task_executor_t* executor,
     // deal with - we don't want the possibility of starvation by looping on
     // this.
     if (!iree_task_submission_is_empty(&pending_submission)) {
-      iree_task_executor_merge_submission(executor, &pending_submission);
+      iree_task_executor_merge_submission(executor, current_worker,
+                                          &pending_submission);
       schedule_dirty = true;
     } else {
-      schedule_dirty = false;
+      // Deferred tasks are picked up on the next pass if nothing was posted
+      // that would otherwise cause a worker to coordinate again later.
+      schedule_dirty = has_deferred_tasks && !did_post;
     }
   } while (schedule_dirty);
 
@@ -645,18 +1074,21 @@ void iree_task_executor_coordinate(iree_task_executor_t* executor,
   IREE_TRACE_ZONE_END(z0);
 }
 
+// Tries to steal from the workers in |victim_mask|. Each victim tried consumes
+// one of the attempts remaining in |inout_theft_attempts|.
 static iree_task_t* iree_task_executor_try_steal_task_from_affinity_set(
     iree_task_executor_t* executor, iree_task_affinity_set_t victim_mask,
-    uint32_t max_theft_attempts, int rotation_offset,
+    uint32_t* inout_theft_attempts, int rotation_offset,
     iree_task_queue_t* local_task_queue) {
   if (!victim_mask) return NULL;
-  max_theft_attempts = iree_min(max_theft_attempts,
-                                iree_task_affinity_set_count_ones(victim_mask));
-  victim_mask = iree_task_affinity_set_rotr(victim_mask, rotation_offset);
+  uint32_t max_theft_attempts = iree_min(
+      *inout_theft_attempts, iree_task_affinity_set_count_ones(victim_mask));
+  *inout_theft_attempts -= max_theft_attempts;
 
+  // Bit i of the rotated mask is the worker at index rotation_offset + i.
   int worker_index = rotation_offset;
   iree_task_affinity_set_t mask =
-      iree_task_affinity_set_rotr(victim_mask, worker_index);
+      iree_task_affinity_set_rotr(victim_mask, rotation_offset);
   for (uint32_t i = 0; i < max_theft_attempts; ++i) {
     // Find the last set bit and skip to it. This avoids the need for doing
     // a full O(n) scan and instead gets us at O(popcnt) * O(ctz).
@@ -670,7 +1102,8 @@ static iree_task_t* iree_task_executor_try_steal_task_from_affinity_set(
     //            mask >>= 1 = 0b01010101
     //            victim_index = 4 % 64 = 4
     int offset = iree_task_affinity_set_count_trailing_zeros(mask);
-    int victim_index = (worker_index + offset) % executor->worker_count;
+    int victim_index =
+        (worker_index + offset) & (8 * sizeof(iree_task_affinity_set_t) - 1);
     worker_index += offset + 1;
     mask = iree_shr(mask, offset + 1);
     iree_task_worker_t* victim_worker = &executor->workers[victim_index];
@@ -695,10 +1128,12 @@ static iree_task_t* iree_task_executor_try_steal_task_from_affinity_set(
 // Returns a task that is available (has not yet begun processing at all).
 // May steal multiple tasks and add them to the |local_task_queue|.
 //
-// We do a scan through ideal victims indicated by the
-// |constructive_sharing_mask|; these are the workers most likely to have some
-// cache benefits to taking their work as they share some level of the cache
-// hierarchy and should be better to steal from than any random worker.
+// We do a scan through victims in order of cache distance as indicated by
+// |victim_masks|; the nearest are the workers most likely to have some cache
+// benefits to taking their work as they share some level of the cache
+// hierarchy and should be better to steal from than any random worker. If none
+// of them have work we move outward to workers sharing the last-level cache,
+// then workers on the same NUMA node, and only then any worker in the system.
 //
 // To prevent biasing any particular victim we use a fast prng function to
 // select where in the set of potential victims defined by the topology
@@ -707,9 +1142,10 @@ static iree_task_t* iree_task_executor_try_steal_task_from_affinity_set(
 // our search and then go in-order.
 iree_task_t* iree_task_executor_try_steal_task(
     iree_task_executor_t* executor,
-    iree_task_affinity_set_t constructive_sharing_mask,
+    const iree_task_affinity_set_t victim_masks[IREE_TASK_STEAL_LOCALITY_COUNT],
     uint32_t max_theft_attempts, iree_prng_minilcg128_state_t* theft_prng,
-    iree_task_queue_t* local_task_queue) {
+    iree_task_queue_t* local_task_queue,
+    iree_task_steal_locality_t* out_locality) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
   // Limit the workers we will steal from to the ones that are currently live
@@ -728,21 +1164,32 @@ iree_task_t* iree_task_executor_try_steal_task(
   int rotation_offset = iree_prng_minilcg128_next_uint8(theft_prng) &
                         (8 * sizeof(iree_task_affinity_set_t) - 1);
 
-  // Try first with the workers we may have some caches shared with. This
+  // Walk outward from the workers we may have some caches shared with. This
   // helps to prevent cache invalidations/availability updates as it's likely
   // that we won't need to go back to main memory (or higher cache tiers) in the
   // event that the thief and victim are running close to each other in time.
-  iree_task_t* task = iree_task_executor_try_steal_task_from_affinity_set(
-      executor, victim_mask & constructive_sharing_mask, max_theft_attempts,
-      rotation_offset, local_task_queue);
-  if (task) {
-    IREE_TRACE_ZONE_APPEND_TEXT(z0, "local");
-  } else {
+  // The max_theft_attempts bound is shared by all tiers so that a worker with
+  // many peers doesn't spend all its time scanning empty queues: once the
+  // nearer tiers have used it up the farther ones are not tried at all.
+#if IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
+  static const char* locality_names[IREE_TASK_STEAL_LOCALITY_COUNT] = {
+      "local",
+      "llc-local",
+      "node-local",
+      "non-local",
+  };
+#endif  // IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
+  iree_task_t* task = NULL;
+  for (int locality = 0;
+       locality < IREE_TASK_STEAL_LOCALITY_COUNT && max_theft_attempts > 0;
+       ++locality) {
     task = iree_task_executor_try_steal_task_from_affinity_set(
-        executor, victim_mask & ~constructive_sharing_mask, max_theft_attempts,
+        executor, victim_mask & victim_masks[locality], &max_theft_attempts,
         rotation_offset, local_task_queue);
     if (task) {
-      IREE_TRACE_ZONE_APPEND_TEXT(z0, "non-local");
+      IREE_TRACE_ZONE_APPEND_TEXT(z0, locality_names[locality]);
+      *out_locality = (iree_task_steal_locality_t)locality;
+      break;
     }
   }
 
@@ -750,6 +1197,22 @@ iree_task_t* iree_task_executor_try_steal_task(
   return task;
 }
 
+// Tries to steal a task for the donated caller from any live worker.
+// Expects the donation lock to be held.
+static iree_task_t* iree_task_executor_try_steal_donated_task(
+    iree_task_executor_t* executor, iree_task_queue_t* local_task_queue) {
+  iree_task_affinity_set_t victim_masks[IREE_TASK_STEAL_LOCALITY_COUNT] = {0};
+  victim_masks[IREE_TASK_STEAL_LOCALITY_REMOTE] =
+      iree_task_affinity_for_any_worker();
+  uint32_t max_theft_attempts =
+      iree_max(1, (uint32_t)executor->worker_count /
+                      IREE_TASK_EXECUTOR_MAX_THEFT_ATTEMPTS_DIVISOR);
+  iree_task_steal_locality_t locality = IREE_TASK_STEAL_LOCALITY_REMOTE;
+  return iree_task_executor_try_steal_task(
+      executor, victim_masks, max_theft_attempts,
+      &executor->donation_theft_prng, local_task_queue, &locality);
+}
+
 iree_status_t iree_task_executor_donate_caller(iree_task_executor_t* executor,
                                                iree_wait_handle_t* wait_handle,
                                                iree_time_t deadline_ns) {
@@ -758,9 +1221,90 @@ iree_status_t iree_task_executor_donate_caller(iree_task_executor_t* executor,
   // Perform an immediate flush/coordination (in case the caller queued).
   iree_task_executor_flush(executor);
 
-  // Wait until completed.
-  // TODO(benvanik): make this steal tasks until wait_handle resolves.
-  iree_status_t status = iree_wait_one(wait_handle, deadline_ns);
+  // Only one caller may be donated at a time; this bounds the amount of
+  // oversubscription donation can introduce to a single additional thread.
+  // Any other callers arriving while one is donated just wait as normal.
+  if (!iree_slim_mutex_try_lock(&executor->donation_mutex)) {
+    iree_status_t status = iree_wait_one(wait_handle, deadline_ns);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+
+  // Tasks stolen in bulk from workers land in this queue. We always drain it
+  // before checking whether the wait has resolved so that no tasks are
+  // stranded when the caller stops donating. The number of tasks in the queue
+  // is bounded by IREE_TASK_EXECUTOR_MAX_THEFT_TASK_COUNT.
+  iree_task_queue_t local_task_queue;
+  iree_task_queue_initialize(&local_task_queue);
+
+  // Tasks switch the FPU state of the caller as needed while donated and it is
+  // restored when the caller stops donating.
+  iree_fpu_state_t fpu_state = iree_fpu_state_push(IREE_FPU_STATE_DEFAULT);
+
+  iree_status_t status = iree_ok_status();
+  while (true) {
+    iree_task_t* task = iree_task_queue_pop_front(&local_task_queue);
+    if (!task) {
+      // Stop donating as soon as the wait resolves (or fails).
+      status = iree_wait_one(wait_handle, IREE_TIME_INFINITE_PAST);
+      if (!iree_status_is_deadline_exceeded(status)) break;
+      iree_status_ignore(status);
+      status = iree_ok_status();
+      if (iree_time_now() >= deadline_ns) {
+        status = iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+        break;
+      }
+
+      // Steal work from the workers; if there is none then coordinate once in
+      // case there is pending work that has not yet been distributed.
+      task = iree_task_executor_try_steal_donated_task(executor,
+                                                       &local_task_queue);
+      if (!task) {
+        iree_task_executor_coordinate(executor, /*current_worker=*/NULL,
+                                      /*wait_on_idle=*/false);
+        task = iree_task_executor_try_steal_donated_task(executor,
+                                                         &local_task_queue);
+      }
+
+      // Nothing to do; fall back to waiting as if we had never donated.
+      if (!task) {
+        IREE_FLIGHT_RECORD_BEGIN(IREE_FLIGHT_RECORDER_TRACK_CALLER, "wait", 0);
+        status = iree_wait_one(wait_handle, deadline_ns);
+        IREE_FLIGHT_RECORD_END(IREE_FLIGHT_RECORDER_TRACK_CALLER, "wait");
+        break;
+      }
+    }
+
+    // Execute the task as if we were a worker and schedule any tasks that
+    // became ready as a result.
+    iree_task_submission_t pending_submission;
+    iree_task_submission_initialize(&pending_submission);
+    iree_task_executor_ensure_local_memory(executor,
+                                           &executor->donation_local_memory);
+    uint32_t tile_count = 0;
+    iree_status_t execute_status = iree_task_worker_execute(
+        task, executor->donation_local_memory.span, /*preemption=*/NULL,
+        /*relative_performance=*/100, &fpu_state,
+        IREE_FLIGHT_RECORDER_TRACK_CALLER, &tile_count, &pending_submission);
+    // TODO(#4026): propagate failure to task scope.
+    // As with workers the failure has already been propagated to the scope.
+    IREE_ASSERT_TRUE(iree_status_is_ok(execute_status));
+    iree_status_ignore(execute_status);
+    iree_atomic_fetch_add_int64(&executor->donated_task_count, 1,
+                                iree_memory_order_relaxed);
+    iree_atomic_fetch_add_int64(&executor->donated_tile_count, tile_count,
+                                iree_memory_order_relaxed);
+    if (!iree_task_submission_is_empty(&pending_submission)) {
+      iree_task_executor_merge_submission(executor, /*current_worker=*/NULL,
+                                          &pending_submission);
+      iree_task_executor_coordinate(executor, /*current_worker=*/NULL,
+                                    /*wait_on_idle=*/false);
+    }
+  }
+
+  iree_fpu_state_pop(fpu_state);
+  iree_task_queue_deinitialize(&local_task_queue);
+  iree_slim_mutex_unlock(&executor->donation_mutex);
 
   IREE_TRACE_ZONE_END(z0);
   return status;
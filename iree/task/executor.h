@@ -64,6 +64,7 @@ extern "C" {
 //   - heterogenous microarchitectures in big.LITTLE/etc compute complexes
 //   - task isolation between multiple active requests or users
 //   - latency prioritization by partitioning workloads by priority
+//   - weighted fair sharing of workers between concurrent scopes
 // - scheduling overhead tradeoffs by varying:
 //   - coordination/flush frequency to reduce cross-thread communication
 //   - by statically inserting dispatch slices to avoid dynamic fan-out
@@ -114,13 +115,19 @@ extern "C" {
 //
 // 2. iree_task_executor_submit (LIFO, atomic slist)
 //    Submissions have their task thread-local lists concatenated into a LIFO
-//    incoming_ready_slist or incoming_waiting_slist shared by the executor.
+//    incoming_ready_slists lane matching their priority or the
+//    incoming_waiting_slist shared by the executor.
 //
 // 3. iree_task_executor_flush (or a worker puts on its coordinator hat 🎩)
 //
-//   a. Tasks are flushed from the incoming_ready_slist into a coordinator-local
-//      FIFO task queue and incoming_waiting_slist is concatenated into the
-//      primary executor waitlist.
+//   a. Tasks are flushed from the incoming_ready_slists into a
+//      coordinator-local FIFO task queue in priority order and
+//      incoming_waiting_slist is concatenated into the primary executor
+//      waitlist. Lower priority lanes may be deferred while higher priority
+//      lanes have work, but only for a bounded number of coordination passes.
+//      Within each lane tasks are ordered by the virtual time of their scope
+//      (execution time divided by scope weight) so that scopes that have
+//      received less than their share of the workers are scheduled first.
 //
 //   b. iree_task_executor_poll_waiting_tasks: finds waiting tasks that are now
 //      ready and they are moved into the coordinator-local FIFO task queue.
@@ -146,7 +153,7 @@ extern "C" {
 //
 //    c. Any tasks in the local_task_queue are executed until empty.
 //       Tasks are retired and dependent tasks (via completion_task or barriers)
-//       are made ready and placed in the executor incoming_ready_slist or
+//       are made ready and placed in the executor incoming_ready_slists or
 //       incoming_waiting_slist as with iree_task_executor_submit.
 //
 //    d. If no more thread-local work is available and the mailbox_slist is
@@ -299,21 +306,40 @@ typedef uint32_t iree_task_scheduling_mode_t;
 // Base task system executor interface.
 typedef struct iree_task_executor_t iree_task_executor_t;
 
+// Options controlling the construction and behavior of an executor.
+// Use iree_task_executor_options_initialize to populate the defaults.
+typedef struct iree_task_executor_options_t {
+  // Defines how work is selected across queues.
+  iree_task_scheduling_mode_t scheduling_mode;
+
+  // Duration a worker will spin looking for new work after running dry before
+  // parking its thread on the kernel. Spinning trades power (and cycles that
+  // other threads could have used) for avoiding the kernel wake latency when
+  // work arrives shortly after the worker went idle. Workers spin with an
+  // exponential backoff of processor pause instructions followed by thread
+  // yields. 0 parks immediately.
+  iree_duration_t worker_spin_ns;
+
+  // Defines the bytes to be allocated and reserved for each worker to use for
+  // local memory operations. Will be rounded up to the next power of two.
+  // Dispatches performed will be able to request up to this amount of memory
+  // (or that reserved with iree_task_executor_reserve_local_memory) for their
+  // invocations and no more. May be 0 if no worker local memory is required.
+  iree_host_size_t worker_local_memory_size;
+} iree_task_executor_options_t;
+
+// Initializes |out_options| to the default values.
+void iree_task_executor_options_initialize(
+    iree_task_executor_options_t* out_options);
+
 // Creates a task executor using the specified topology.
 //
-// |worker_local_memory_size| defines the bytes to be allocated and reserved for
-// each worker to use for local memory operations. Will be rounded up to the
-// next power of two. Dispatches performed will be able to request up to this
-// amount of memory for their invocations and no more. May be 0 if no worker
-// local memory is required.
-//
 // |topology| is only used during creation and need not live beyond this call.
 // |out_executor| must be released by the caller.
-iree_status_t iree_task_executor_create(
-    iree_task_scheduling_mode_t scheduling_mode,
-    const iree_task_topology_t* topology,
-    iree_host_size_t worker_local_memory_size, iree_allocator_t allocator,
-    iree_task_executor_t** out_executor);
+iree_status_t iree_task_executor_create(iree_task_executor_options_t options,
+                                        const iree_task_topology_t* topology,
+                                        iree_allocator_t allocator,
+                                        iree_task_executor_t** out_executor);
 
 // Retains the given |executor| for the caller.
 void iree_task_executor_retain(iree_task_executor_t* executor);
@@ -326,12 +352,127 @@ iree_status_t iree_task_executor_acquire_fence(iree_task_executor_t* executor,
                                                iree_task_scope_t* scope,
                                                iree_task_fence_t** out_fence);
 
+// Locality of a work-stealing victim relative to the thief ordered from the
+// nearest to the farthest. Workers try victims in this order when stealing.
+typedef enum iree_task_steal_locality_e {
+  // Victim shares the L1/L2 caches with the thief.
+  IREE_TASK_STEAL_LOCALITY_CONSTRUCTIVE = 0,
+  // Victim shares the last-level cache or core cluster with the thief.
+  IREE_TASK_STEAL_LOCALITY_LLC = 1,
+  // Victim is on the same NUMA node as the thief.
+  IREE_TASK_STEAL_LOCALITY_NUMA_NODE = 2,
+  // Victim is anywhere else in the system.
+  IREE_TASK_STEAL_LOCALITY_REMOTE = 3,
+  IREE_TASK_STEAL_LOCALITY_COUNT,
+} iree_task_steal_locality_t;
+
+// Statistics tracked by each worker over the lifetime of the executor.
+// Counters are updated with relaxed atomics by the worker and may be torn
+// when queried while the executor is active.
+typedef struct iree_task_worker_statistics_t {
+  // Total number of successful thefts from other workers indexed by the
+  // iree_task_steal_locality_t of the victim.
+  uint64_t steal_count[IREE_TASK_STEAL_LOCALITY_COUNT];
+
+  // Number of times the worker was woken while spinning and avoided parking.
+  uint64_t spin_wake_count;
+
+  // Number of times the worker parked its thread waiting for work.
+  uint64_t park_count;
+
+  // Total and maximum latency in nanoseconds from work being posted to a
+  // parked worker until the worker thread resumed.
+  uint64_t park_wake_latency_total_ns;
+  uint64_t park_wake_latency_max_ns;
+
+  // Number of tasks executed by the worker.
+  uint64_t task_count;
+
+  // Number of dispatch tiles (workgroups) executed by the worker.
+  uint64_t tile_count;
+
+  // Number of times the worker ran out of work and failed to steal any.
+  uint64_t failed_steal_count;
+
+  // Total time in nanoseconds the worker spent executing tasks, waiting for
+  // work (spinning or parked) and searching other workers for work to steal.
+  // Time spent coordinating is not included in any.
+  uint64_t busy_ns;
+  uint64_t idle_ns;
+  uint64_t steal_ns;
+} iree_task_worker_statistics_t;
+
+// Returns the total number of workers in the executor.
+iree_host_size_t iree_task_executor_worker_count(
+    iree_task_executor_t* executor);
+
+// Queries the statistics of the worker at |worker_index|.
+iree_status_t iree_task_executor_query_worker_statistics(
+    iree_task_executor_t* executor, iree_host_size_t worker_index,
+    iree_task_worker_statistics_t* out_statistics);
+
+// A snapshot of executor utilization and queue depth.
+// Gauges (counts of tasks and workers) reflect the instant of the query and
+// counters accumulate over the lifetime of the executor such that rates can
+// be derived by differencing successive queries. Fields are read
+// independently with relaxed atomics and may be mutually inconsistent while
+// the executor is active.
+typedef struct iree_task_executor_statistics_t {
+  // Total number of workers in the executor.
+  iree_host_size_t worker_count;
+
+  // Number of workers that have run out of work and are idle (spinning,
+  // parked or about to be).
+  iree_host_size_t idle_worker_count;
+
+  // Number of ready tasks submitted to the executor that have not yet been
+  // scheduled to workers. Sustained growth indicates saturation.
+  uint64_t pending_task_count;
+
+  // Number of wait tasks blocked on external wait handles.
+  uint64_t waiting_task_count;
+
+  // Number of tasks and dispatch tiles executed by callers donated to the
+  // executor via iree_task_executor_donate_caller.
+  uint64_t donated_task_count;
+  uint64_t donated_tile_count;
+
+  // Statistics of all workers summed together; the maximum park wake latency
+  // is the maximum across all workers.
+  iree_task_worker_statistics_t worker_totals;
+} iree_task_executor_statistics_t;
+
+// Queries a snapshot of the executor utilization and queue depth.
+// Cheap enough to be polled periodically (such as by autoscalers or admission
+// control) while the executor is running.
+void iree_task_executor_query_statistics(
+    iree_task_executor_t* executor,
+    iree_task_executor_statistics_t* out_statistics);
+
+// Reserves at least |local_memory_size| bytes of local memory for each worker
+// (and donated caller) such that dispatches requiring up to that amount may
+// be executed. Reservations only ever grow.
+//
+// Each worker owns its local memory and grows it on its own thread - keeping
+// it local to the NUMA node the worker runs on - prior to executing the first
+// task it picks up after the reservation. Dispatches never allocate local
+// memory and workers reuse the same (hot) memory across all tiles.
+//
+// Safe to call from any thread.
+void iree_task_executor_reserve_local_memory(
+    iree_task_executor_t* executor, iree_host_size_t local_memory_size);
+
 // TODO(benvanik): scheduling mode mutation, compute quota control, etc.
 
 // Submits a batch of tasks for execution.
 // The submission represents a DAG of tasks all reachable from the initial
 // submission lists.
 //
+// All root tasks in the submission are assigned the submission priority and
+// all tasks they ready inherit it. Higher priority work is scheduled first and
+// preempts lower priority dispatch shards at tile reservation boundaries while
+// lower priority work is still guaranteed to make forward progress.
+//
 // Ownership of the tasks remains with the caller for the lifetime of the
 // submission unless tasks have a custom pool specified that they can be
 // returned to.
@@ -360,7 +501,15 @@ void iree_task_executor_flush(iree_task_executor_t* executor);
 // If there are no tasks available then the calling thread will block as if
 // iree_wait_one had been used on |wait_handle|. If tasks are ready then the
 // caller will not block prior to starting to perform work on behalf of the
-// executor.
+// executor: it acts as a temporary worker and steals tasks (including dispatch
+// shards, and with them tiles of in-flight dispatches) from the workers until
+// it either runs out of work to steal or |wait_handle| resolves. The caller
+// finishes any tasks it has stolen prior to returning and never leaves work
+// stranded.
+//
+// Only one caller at a time is donated to an executor; concurrent callers will
+// block on their |wait_handle| as if they had used iree_wait_one. This bounds
+// the additional oversubscription introduced by donation to a single thread.
 //
 // Donation is intended as an optimization to elide context switches when the
 // caller would have waited anyway; now instead of performing a kernel wait and
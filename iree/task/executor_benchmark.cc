@@ -0,0 +1,161 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Measures the fixed scheduling overhead of the executor by issuing dispatches
+// of K empty tiles across N workers. As the tiles do no work the results are
+// the cost of submission, sharding, waking workers, stealing and retiring the
+// dispatch and can be tracked across releases to catch scheduler regressions.
+// The submit-to-wake latency of fence signaling is measured separately as it
+// bounds how quickly a host thread observes completed work.
+
+#include <cstdint>
+#include <map>
+
+#include "benchmark/benchmark.h"
+#include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/task/executor.h"
+#include "iree/task/scope.h"
+#include "iree/task/submission.h"
+#include "iree/task/task.h"
+#include "iree/task/topology.h"
+
+namespace {
+
+// Returns an executor with |worker_count| workers. Executors are cached for
+// the lifetime of the process so that worker thread creation is not measured.
+iree_task_executor_t* GetExecutor(int worker_count) {
+  static std::map<int, iree_task_executor_t*>* executors =
+      new std::map<int, iree_task_executor_t*>();
+  auto it = executors->find(worker_count);
+  if (it != executors->end()) return it->second;
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(worker_count, &topology);
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  iree_task_executor_t* executor = NULL;
+  IREE_CHECK_OK(iree_task_executor_create(options, &topology,
+                                          iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+  executors->insert({worker_count, executor});
+  return executor;
+}
+
+iree_status_t EmptyTile(uintptr_t user_context,
+                        const iree_task_tile_context_t* tile_context,
+                        iree_task_submission_t* pending_submission) {
+  return iree_ok_status();
+}
+
+// Issues a dispatch of range(1) empty tiles on an executor with range(0)
+// workers and waits for it to complete.
+void BM_EmptyDispatch(benchmark::State& state) {
+  const int worker_count = static_cast<int>(state.range(0));
+  const uint32_t tile_count = static_cast<uint32_t>(state.range(1));
+  iree_task_executor_t* executor = GetExecutor(worker_count);
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("scope"), &scope);
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  const uint32_t workgroup_count[3] = {tile_count, 1, 1};
+  for (auto _ : state) {
+    iree_task_dispatch_t task;
+    iree_task_dispatch_initialize(
+        &scope, iree_task_make_dispatch_closure(EmptyTile, 0), workgroup_size,
+        workgroup_count, &task);
+    iree_task_fence_t* fence = NULL;
+    IREE_CHECK_OK(iree_task_executor_acquire_fence(executor, &scope, &fence));
+    iree_task_set_completion_task(&task.header, &fence->header);
+    iree_task_submission_t submission;
+    iree_task_submission_initialize(&submission);
+    iree_task_submission_enqueue(&submission, &task.header);
+    iree_task_executor_submit(executor, &submission);
+    iree_task_executor_flush(executor);
+    IREE_CHECK_OK(
+        iree_task_scope_wait_idle(&scope, IREE_TIME_INFINITE_FUTURE));
+  }
+  iree_task_scope_deinitialize(&scope);
+  state.SetItemsProcessed(state.iterations() * tile_count);
+}
+BENCHMARK(BM_EmptyDispatch)
+    ->ArgNames({"workers", "tiles"})
+    ->Apply([](benchmark::internal::Benchmark* benchmark) {
+      for (int worker_count : {1, 2, 4, 8}) {
+        for (int tile_count : {1, 8, 64, 512, 1024}) {
+          benchmark->Args({worker_count, tile_count});
+        }
+      }
+    })
+    ->UseRealTime();
+
+// Wakes a host thread waiting on a flag when a fence is signaled.
+struct FenceWaiter {
+  iree_atomic_int32_t signaled = IREE_ATOMIC_VAR_INIT(0);
+  iree_notification_t notification;
+
+  static void Signal(uintptr_t user_context, iree_task_t* task,
+                     iree_status_t status) {
+    IREE_CHECK_OK(status);
+    FenceWaiter* waiter = (FenceWaiter*)user_context;
+    iree_atomic_store_int32(&waiter->signaled, 1, iree_memory_order_release);
+    iree_notification_post(&waiter->notification, IREE_ALL_WAITERS);
+  }
+
+  static bool IsSignaled(void* arg) {
+    FenceWaiter* waiter = (FenceWaiter*)arg;
+    return iree_atomic_load_int32(&waiter->signaled,
+                                  iree_memory_order_acquire) != 0;
+  }
+};
+
+iree_status_t EmptyCall(uintptr_t user_context, iree_task_t* task,
+                        iree_task_submission_t* pending_submission) {
+  return iree_ok_status();
+}
+
+// Submits an empty call followed by a signaling fence on an executor with
+// range(0) workers and measures the time until the submitting thread is woken
+// by the fence signal. The fence retires inline on the worker that ran the
+// call so this is the end-to-end cost of submission, one worker wake, and one
+// host wake.
+void BM_FenceSignalLatency(benchmark::State& state) {
+  const int worker_count = static_cast<int>(state.range(0));
+  iree_task_executor_t* executor = GetExecutor(worker_count);
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("scope"), &scope);
+  FenceWaiter waiter;
+  iree_notification_initialize(&waiter.notification);
+  for (auto _ : state) {
+    iree_atomic_store_int32(&waiter.signaled, 0, iree_memory_order_relaxed);
+    iree_task_call_t task;
+    iree_task_call_initialize(&scope, iree_task_make_call_closure(EmptyCall, 0),
+                              &task);
+    iree_task_fence_t* fence = NULL;
+    IREE_CHECK_OK(iree_task_executor_acquire_fence(executor, &scope, &fence));
+    iree_task_fence_set_signal_fn(fence, FenceWaiter::Signal,
+                                  (uintptr_t)&waiter);
+    iree_task_set_completion_task(&task.header, &fence->header);
+    iree_task_submission_t submission;
+    iree_task_submission_initialize(&submission);
+    iree_task_submission_enqueue(&submission, &task.header);
+    iree_task_executor_submit(executor, &submission);
+    iree_task_executor_flush(executor);
+    iree_notification_await(&waiter.notification, FenceWaiter::IsSignaled,
+                            &waiter);
+  }
+  IREE_CHECK_OK(iree_task_scope_wait_idle(&scope, IREE_TIME_INFINITE_FUTURE));
+  iree_notification_deinitialize(&waiter.notification);
+  iree_task_scope_deinitialize(&scope);
+}
+BENCHMARK(BM_FenceSignalLatency)
+    ->ArgNames({"workers"})
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->UseRealTime();
+
+}  // namespace
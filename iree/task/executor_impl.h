@@ -32,21 +32,48 @@ struct iree_task_executor_t {
   // TODO(benvanik): make mutable; currently always the same reserved value.
   iree_task_scheduling_mode_t scheduling_mode;
 
+  // Duration workers spin looking for new work prior to parking.
+  iree_duration_t worker_spin_ns;
+
+  // Guards the donation state below; only one caller at a time may be donated
+  // to the executor and any others will wait as if they had not donated.
+  iree_slim_mutex_t donation_mutex;
+
   // State used by the work-stealing operations performed by donated threads.
-  // This is **NOT SYNCHRONIZED** and relies on the fact that we actually don't
-  // much care about the precise selection of workers enough to mind any tears
-  // we get in the PRNG state that lives inside. Cache write-back order and
-  // incidental cache line availability/visibility update frequency is like an
-  // extra layer of PRNG anyway ;)
+  // Guarded by donation_mutex.
   iree_prng_minilcg128_state_t donation_theft_prng;
 
+  // Bytes of local memory each worker must provide to dispatches. Only grows.
+  // Workers compare this against their local memory capacity prior to
+  // executing tasks; see iree_task_executor_reserve_local_memory.
+  iree_atomic_int64_t local_memory_reservation;
+
+  // Local memory used by the donated thread when executing dispatch tiles.
+  // Sized the same as the local memory of each worker. Guarded by
+  // donation_mutex.
+  iree_task_local_memory_t donation_local_memory;
+
+  // Number of tasks and dispatch tiles executed by donated callers.
+  iree_atomic_int64_t donated_task_count;
+  iree_atomic_int64_t donated_tile_count;
+
   // Pools of transient dispatch tasks shared across all workers.
   // Depending on configuration the task pool may allocate after creation using
   // the allocator provided upon executor creation.
   iree_task_pool_t fence_task_pool;
-  iree_task_pool_t dispatch_task_pool;
 
-  // A list of incoming tasks that are ready to execute immediately.
+  // Per-NUMA node pools of transient dispatch slice/shard tasks. Tasks posted
+  // to a worker are allocated from the pool of the node the worker is on so
+  // that the storage they touch while executing stays node-local.
+  iree_host_size_t numa_node_count;
+  iree_task_pool_t dispatch_task_pools[IREE_TASK_EXECUTOR_MAX_NUMA_NODE_COUNT];
+
+  // A bitset per NUMA node indicating which workers are attached to the node.
+  iree_task_affinity_set_t
+      numa_node_worker_masks[IREE_TASK_EXECUTOR_MAX_NUMA_NODE_COUNT];
+
+  // Lists of incoming tasks that are ready to execute immediately, one lane per
+  // iree_task_priority_t.
   // The list is LIFO and we require that task lists are reversed by the
   // submitter so we can use iree_atomic_slist_concat to quickly prepend the
   // LIFO list to the atomic slist. By doing this we can construct the task
@@ -60,14 +87,36 @@ struct iree_task_executor_t {
   //   existing tasks: C B A
   //        new tasks: 1 2 3
   //    updated tasks: 3 2 1 C B A
-  iree_atomic_task_slist_t incoming_ready_slist;
+  //
+  // Each lane is sharded by the submitting worker so that many workers merging
+  // their submissions at once don't all contend on the same list head. Order
+  // is only retained within each shard.
+  iree_atomic_task_sharded_slist_t
+      incoming_ready_slists[IREE_TASK_PRIORITY_COUNT];
   // A list of incoming wait tasks that need to be waited on. Order doesn't
   // really matter here as all tasks will be waited on simultaneously.
   iree_atomic_task_slist_t incoming_waiting_slist;
+  // Number of ready tasks merged into incoming_ready_slists (or deferred in
+  // deferred_ready_lists) that have not yet been scheduled by a coordinator.
+  iree_atomic_int64_t pending_task_count;
+  // Number of wait tasks in waiting_list. Only written by the coordinator but
+  // may be read from any thread.
+  iree_atomic_int64_t waiting_task_count;
 
   // Guards coordination logic; only one thread at a time may be acting as the
   // coordinator.
   iree_slim_mutex_t coordinator_mutex;
+  // Ready tasks flushed from incoming_ready_slists that the coordinator has
+  // deferred in favor of higher priority tasks, per priority lane.
+  iree_task_list_t deferred_ready_lists[IREE_TASK_PRIORITY_COUNT];
+  // Number of consecutive coordination passes each lane has been deferred.
+  // Bounded by IREE_TASK_EXECUTOR_MAX_PRIORITY_DEFERRAL_COUNT.
+  uint32_t deferral_counts[IREE_TASK_PRIORITY_COUNT];
+  // Highest of the lowest scope virtual times seen in each coordination pass.
+  // Scopes lagging further than IREE_TASK_EXECUTOR_MAX_FAIRNESS_LAG_NS behind
+  // it are advanced when their tasks are scheduled. Only accessed by the
+  // coordinator.
+  int64_t virtual_time_ns;
   // A list of wait tasks with external handles that need to be waited on.
   // Coordinators can choose to poll/wait on these.
   iree_task_list_t waiting_list;
@@ -77,6 +126,13 @@ struct iree_task_executor_t {
   // Wait set containing all the tasks in waiting_list. Coordinator manages
   // keeping the waiting_list and wait_set in sync.
   iree_wait_set_t* wait_set;
+  // Event inserted into the wait_set while a worker is blocked waiting on it.
+  // Workers blocked in the wait_set do not observe their wake notification so
+  // coordinators posting tasks to them set this to interrupt the wait.
+  iree_event_t wait_interrupt_event;
+  // A bitset indicating which workers are waiting (or about to wait) on the
+  // wait_set. Only modified by the coordinator.
+  iree_atomic_task_affinity_set_t worker_wait_mask;
 
   // A bitset indicating which workers are live and usable; all attempts to
   // push work onto a particular worker should check first with this mask. This
@@ -105,8 +161,12 @@ struct iree_task_executor_t {
 // Coordinators will fetch items from here as workers demand them but otherwise
 // not be notified of the changes (waiting until coordination runs again).
 //
+// |current_worker| is the worker performing the merge, if any, and is used to
+// reduce contention with other workers merging concurrently.
+//
 // May be called from any thread.
 void iree_task_executor_merge_submission(iree_task_executor_t* executor,
+                                         iree_task_worker_t* current_worker,
                                          iree_task_submission_t* submission);
 
 // Schedules all ready tasks in the |pending_submission| list.
@@ -130,11 +190,41 @@ void iree_task_executor_coordinate(iree_task_executor_t* executor,
 // Tries to steal an entire task from a sibling worker (based on topology).
 // Returns a task that is available (has not yet begun processing at all).
 // May steal multiple tasks and add them to the |local_task_queue|.
+//
+// Victims are tried in order of locality as defined by |victim_masks| indexed
+// by iree_task_steal_locality_t. At most |max_theft_attempts| victims are tried
+// in total across all localities. The locality of the victim a task was stolen
+// from is returned in |out_locality|.
 iree_task_t* iree_task_executor_try_steal_task(
     iree_task_executor_t* executor,
-    iree_task_affinity_set_t constructive_sharing_mask,
+    const iree_task_affinity_set_t victim_masks[IREE_TASK_STEAL_LOCALITY_COUNT],
     uint32_t max_theft_attempts, iree_prng_minilcg128_state_t* theft_prng,
-    iree_task_queue_t* local_task_queue);
+    iree_task_queue_t* local_task_queue,
+    iree_task_steal_locality_t* out_locality);
+
+// Grows |local_memory| to at least |minimum_size| bytes. Must be called from
+// the thread that will use the memory so that first-touch placement keeps it
+// local to that thread's NUMA node. On allocation failure the existing memory
+// is retained and the dispatch tile check will report the shortfall.
+void iree_task_executor_grow_local_memory(
+    iree_task_executor_t* executor, iree_host_size_t minimum_size,
+    iree_task_local_memory_t* local_memory);
+
+// Releases |local_memory| previously grown with
+// iree_task_executor_grow_local_memory.
+void iree_task_executor_release_local_memory(
+    iree_task_executor_t* executor, iree_task_local_memory_t* local_memory);
+
+// Ensures |local_memory| satisfies the current executor-wide reservation.
+// This is a single relaxed load on the fast path as reservations only grow.
+static inline void iree_task_executor_ensure_local_memory(
+    iree_task_executor_t* executor, iree_task_local_memory_t* local_memory) {
+  iree_host_size_t reservation = (iree_host_size_t)iree_atomic_load_int64(
+      &executor->local_memory_reservation, iree_memory_order_relaxed);
+  if (IREE_UNLIKELY(reservation > local_memory->span.data_length)) {
+    iree_task_executor_grow_local_memory(executor, reservation, local_memory);
+  }
+}
 
 #ifdef __cplusplus
 }  // extern "C"
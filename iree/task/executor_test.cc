@@ -6,12 +6,19 @@
 
 #include "iree/task/executor.h"
 
+#include <atomic>
+#include <chrono>
 #include <cstddef>
+#include <cstring>
+#include <thread>
 
 #include "iree/base/internal/prng.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/internal/wait_handle.h"
 #include "iree/base/tracing.h"
 #include "iree/task/topology_cpuinfo.h"
 #include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
 
 namespace {
 
@@ -55,11 +62,11 @@ TEST(ExecutorTest, Any) {
 #endif
 
   iree_task_executor_t* executor = NULL;
-  iree_task_scheduling_mode_t scheduling_mode =
-      IREE_TASK_SCHEDULING_MODE_RESERVED;
-  IREE_CHECK_OK(iree_task_executor_create(
-      scheduling_mode, &topology,
-      /*worker_local_memory_size=*/(64 * 1024), allocator, &executor));
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  options.worker_local_memory_size = 64 * 1024;
+  IREE_CHECK_OK(
+      iree_task_executor_create(options, &topology, allocator, &executor));
   iree_task_topology_deinitialize(&topology);
 
   //
@@ -91,8 +98,6 @@ TEST(ExecutorTest, Any) {
             IREE_TRACE_SCOPE0("tile0");
             EXPECT_EQ(0, user_context);
             simulate_work(tile_context);
-            iree_atomic_fetch_add_int32(&tile_context->statistics->reserved, 1,
-                                        iree_memory_order_relaxed);
             return iree_ok_status();
           },
           0),
@@ -111,8 +116,6 @@ TEST(ExecutorTest, Any) {
             IREE_TRACE_SCOPE0("tile1");
             EXPECT_EQ(0, user_context);
             simulate_work(tile_context);
-            iree_atomic_fetch_add_int32(&tile_context->statistics->reserved, 1,
-                                        iree_memory_order_relaxed);
             return iree_ok_status();
           },
           0),
@@ -172,4 +175,602 @@ TEST(ExecutorTest, Any) {
   iree_task_executor_release(executor);
 }
 
+TEST(ExecutorTest, WorkerStatistics) {
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/2, &topology);
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  iree_task_executor_t* executor = NULL;
+  IREE_CHECK_OK(iree_task_executor_create(options, &topology,
+                                          iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+  EXPECT_EQ(2, iree_task_executor_worker_count(executor));
+
+  // No work has been submitted and nothing should have been stolen.
+  for (iree_host_size_t i = 0; i < iree_task_executor_worker_count(executor);
+       ++i) {
+    iree_task_worker_statistics_t statistics;
+    IREE_CHECK_OK(
+        iree_task_executor_query_worker_statistics(executor, i, &statistics));
+    for (iree_host_size_t j = 0; j < IREE_TASK_STEAL_LOCALITY_COUNT; ++j) {
+      EXPECT_EQ(0, statistics.steal_count[j]);
+    }
+    EXPECT_EQ(0, statistics.spin_wake_count);
+    EXPECT_EQ(0, statistics.park_wake_latency_total_ns);
+    EXPECT_EQ(0, statistics.task_count);
+    EXPECT_EQ(0, statistics.tile_count);
+    EXPECT_EQ(0, statistics.busy_ns);
+  }
+
+  iree_task_executor_statistics_t executor_statistics;
+  iree_task_executor_query_statistics(executor, &executor_statistics);
+  EXPECT_EQ(2, executor_statistics.worker_count);
+  EXPECT_EQ(0, executor_statistics.pending_task_count);
+  EXPECT_EQ(0, executor_statistics.waiting_task_count);
+  EXPECT_EQ(0, executor_statistics.worker_totals.task_count);
+
+  // Out of range workers are rejected.
+  iree_task_worker_statistics_t statistics;
+  iree_status_t status =
+      iree_task_executor_query_worker_statistics(executor, 2, &statistics);
+  EXPECT_TRUE(iree_status_is_out_of_range(status));
+  iree_status_ignore(status);
+
+  iree_task_executor_release(executor);
+}
+
+// Initializes |out_topology| with |group_count| groups where every worker is at
+// |locality| from all of its peers.
+static void InitializeTopologyWithLocality(
+    iree_host_size_t group_count, iree_task_steal_locality_t locality,
+    iree_task_topology_t* out_topology) {
+  iree_task_topology_initialize_from_group_count(group_count, out_topology);
+  for (iree_host_size_t i = 0; i < group_count; ++i) {
+    iree_task_topology_group_t* group = &out_topology->groups[i];
+    iree_task_topology_group_mask_t group_mask = 1ull << i;
+    group->constructive_sharing_mask =
+        locality == IREE_TASK_STEAL_LOCALITY_CONSTRUCTIVE
+            ? IREE_TASK_TOPOLOGY_GROUP_MASK_ALL
+            : group_mask;
+    group->llc_sharing_mask = locality <= IREE_TASK_STEAL_LOCALITY_LLC
+                                  ? IREE_TASK_TOPOLOGY_GROUP_MASK_ALL
+                                  : group_mask;
+    group->numa_node =
+        locality == IREE_TASK_STEAL_LOCALITY_REMOTE ? (uint32_t)i : 0;
+  }
+}
+
+TEST(ExecutorTest, StealsFromEachLocality) {
+  for (int locality = 0; locality < IREE_TASK_STEAL_LOCALITY_COUNT;
+       ++locality) {
+    iree_task_topology_t topology;
+    InitializeTopologyWithLocality(/*group_count=*/4,
+                                   (iree_task_steal_locality_t)locality,
+                                   &topology);
+    iree_task_executor_options_t options;
+    iree_task_executor_options_initialize(&options);
+    iree_task_executor_t* executor = NULL;
+    IREE_CHECK_OK(iree_task_executor_create(
+        options, &topology, iree_allocator_system(), &executor));
+    iree_task_topology_deinitialize(&topology);
+
+    iree_task_scope_t scope;
+    iree_task_scope_initialize(iree_make_cstring_view("scope"), &scope);
+
+    // The worker that executes the first tile is made slow so that the others
+    // run out of their own slices and have to steal the ones still queued on
+    // it. Each slice is a single tile.
+    std::atomic<std::thread::id> slow_thread{std::thread::id()};
+    const uint32_t workgroup_size[3] = {1, 1, 1};
+    const uint32_t workgroup_count[3] = {1, 64, 1};
+    iree_task_dispatch_t dispatch;
+    iree_task_dispatch_initialize(
+        &scope,
+        iree_task_make_dispatch_closure(
+            [](uintptr_t user_context,
+               const iree_task_tile_context_t* tile_context,
+               iree_task_submission_t* pending_submission) {
+              auto* slow_thread = (std::atomic<std::thread::id>*)user_context;
+              std::thread::id no_thread;
+              slow_thread->compare_exchange_strong(no_thread,
+                                                   std::this_thread::get_id());
+              if (slow_thread->load() == std::this_thread::get_id()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+              }
+              return iree_ok_status();
+            },
+            (uintptr_t)&slow_thread),
+        workgroup_size, workgroup_count, &dispatch);
+    dispatch.header.flags |= IREE_TASK_FLAG_DISPATCH_SLICED;
+    iree_task_fence_t* fence = NULL;
+    IREE_CHECK_OK(iree_task_executor_acquire_fence(executor, &scope, &fence));
+    iree_task_set_completion_task(&dispatch.header, &fence->header);
+    iree_task_submission_t submission;
+    iree_task_submission_initialize(&submission);
+    iree_task_submission_enqueue(&submission, &dispatch.header);
+    iree_task_executor_submit(executor, &submission);
+    iree_task_executor_flush(executor);
+    IREE_CHECK_OK(iree_task_scope_wait_idle(&scope, IREE_TIME_INFINITE_FUTURE));
+
+    // All peers are at the same locality and every theft must be counted
+    // there.
+    uint64_t steal_counts[IREE_TASK_STEAL_LOCALITY_COUNT] = {0};
+    for (iree_host_size_t i = 0; i < iree_task_executor_worker_count(executor);
+         ++i) {
+      iree_task_worker_statistics_t statistics;
+      IREE_CHECK_OK(
+          iree_task_executor_query_worker_statistics(executor, i, &statistics));
+      for (int j = 0; j < IREE_TASK_STEAL_LOCALITY_COUNT; ++j) {
+        steal_counts[j] += statistics.steal_count[j];
+      }
+    }
+    for (int j = 0; j < IREE_TASK_STEAL_LOCALITY_COUNT; ++j) {
+      if (j == locality) {
+        EXPECT_LT(0, steal_counts[j]) << "locality " << locality;
+      } else {
+        EXPECT_EQ(0, steal_counts[j]) << "locality " << locality;
+      }
+    }
+
+    iree_task_scope_deinitialize(&scope);
+    iree_task_executor_release(executor);
+  }
+}
+
+TEST(ExecutorTest, SpinningWorkers) {
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/2, &topology);
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  options.worker_spin_ns = 1000000;  // 1ms
+  iree_task_executor_t* executor = NULL;
+  IREE_CHECK_OK(iree_task_executor_create(options, &topology,
+                                          iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("scope"), &scope);
+
+  // Submit a handful of back-to-back dispatches; workers spinning between them
+  // must still see and execute all of the work.
+  static iree_atomic_int32_t tile_count;
+  iree_atomic_store_int32(&tile_count, 0, iree_memory_order_relaxed);
+  for (int i = 0; i < 8; ++i) {
+    const uint32_t workgroup_size[3] = {1, 1, 1};
+    const uint32_t workgroup_count[3] = {16, 1, 1};
+    iree_task_dispatch_t dispatch;
+    iree_task_dispatch_initialize(
+        &scope,
+        iree_task_make_dispatch_closure(
+            [](uintptr_t user_context,
+               const iree_task_tile_context_t* tile_context,
+               iree_task_submission_t* pending_submission) {
+              iree_atomic_fetch_add_int32(&tile_count, 1,
+                                          iree_memory_order_relaxed);
+              return iree_ok_status();
+            },
+            0),
+        workgroup_size, workgroup_count, &dispatch);
+    iree_task_fence_t* fence = NULL;
+    IREE_CHECK_OK(iree_task_executor_acquire_fence(executor, &scope, &fence));
+    iree_task_set_completion_task(&dispatch.header, &fence->header);
+    iree_task_submission_t submission;
+    iree_task_submission_initialize(&submission);
+    iree_task_submission_enqueue(&submission, &dispatch.header);
+    iree_task_executor_submit(executor, &submission);
+    iree_task_executor_flush(executor);
+    IREE_CHECK_OK(iree_task_scope_wait_idle(&scope, IREE_TIME_INFINITE_FUTURE));
+  }
+  EXPECT_EQ(8 * 16, iree_atomic_load_int32(&tile_count,
+                                           iree_memory_order_relaxed));
+
+  for (iree_host_size_t i = 0; i < iree_task_executor_worker_count(executor);
+       ++i) {
+    iree_task_worker_statistics_t statistics;
+    IREE_CHECK_OK(
+        iree_task_executor_query_worker_statistics(executor, i, &statistics));
+    EXPECT_LE(statistics.park_wake_latency_max_ns,
+              statistics.park_wake_latency_total_ns);
+  }
+
+  // All tiles were executed by the workers and nothing remains queued.
+  iree_task_executor_statistics_t executor_statistics;
+  iree_task_executor_query_statistics(executor, &executor_statistics);
+  EXPECT_EQ(0, executor_statistics.pending_task_count);
+  EXPECT_EQ(0, executor_statistics.waiting_task_count);
+  EXPECT_EQ(8 * 16, executor_statistics.worker_totals.tile_count);
+  EXPECT_LE(8, executor_statistics.worker_totals.task_count);
+  EXPECT_LT(0, executor_statistics.worker_totals.busy_ns);
+
+  iree_task_scope_deinitialize(&scope);
+  iree_task_executor_release(executor);
+}
+
+TEST(ExecutorTest, HeterogeneousWorkers) {
+  // Half of the workers are modeled as little cores with a quarter of the
+  // performance of the others.
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/4, &topology);
+  for (iree_host_size_t i = 2; i < 4; ++i) {
+    topology.groups[i].relative_performance = 25;
+  }
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  iree_task_executor_t* executor = NULL;
+  IREE_CHECK_OK(iree_task_executor_create(options, &topology,
+                                          iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("scope"), &scope);
+
+  // Every tile must be executed exactly once regardless of how the workers
+  // scale their reservations.
+  static iree_atomic_int32_t tile_count;
+  iree_atomic_store_int32(&tile_count, 0, iree_memory_order_relaxed);
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  const uint32_t workgroup_count[3] = {1024, 1, 1};
+  iree_task_dispatch_t dispatch;
+  iree_task_dispatch_initialize(
+      &scope,
+      iree_task_make_dispatch_closure(
+          [](uintptr_t user_context,
+             const iree_task_tile_context_t* tile_context,
+             iree_task_submission_t* pending_submission) {
+            iree_atomic_fetch_add_int32(&tile_count, 1,
+                                        iree_memory_order_relaxed);
+            return iree_ok_status();
+          },
+          0),
+      workgroup_size, workgroup_count, &dispatch);
+  iree_task_fence_t* fence = NULL;
+  IREE_CHECK_OK(iree_task_executor_acquire_fence(executor, &scope, &fence));
+  iree_task_set_completion_task(&dispatch.header, &fence->header);
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  iree_task_submission_enqueue(&submission, &dispatch.header);
+  iree_task_executor_submit(executor, &submission);
+  iree_task_executor_flush(executor);
+  IREE_CHECK_OK(iree_task_scope_wait_idle(&scope, IREE_TIME_INFINITE_FUTURE));
+  EXPECT_EQ(1024, iree_atomic_load_int32(&tile_count,
+                                         iree_memory_order_relaxed));
+
+  iree_task_executor_statistics_t executor_statistics;
+  iree_task_executor_query_statistics(executor, &executor_statistics);
+  EXPECT_EQ(1024, executor_statistics.worker_totals.tile_count);
+
+  iree_task_scope_deinitialize(&scope);
+  iree_task_executor_release(executor);
+}
+
+TEST(ExecutorTest, FlushDenormalsToZero) {
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/2, &topology);
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  iree_task_executor_t* executor = NULL;
+  IREE_CHECK_OK(iree_task_executor_create(options, &topology,
+                                          iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("scope"), &scope);
+
+  // Produces a denormal value unless denormals are flushed to zero.
+  static auto make_denormal = []() {
+    volatile float f = 1.0f;
+    f = f * 1e-39f;
+    return f;
+  };
+
+  // All tiles of a dispatch requesting FTZ flush denormals while the call
+  // following it on the same workers executes with the default FPU state.
+  static iree_atomic_int32_t flushed_tile_count;
+  iree_atomic_store_int32(&flushed_tile_count, 0, iree_memory_order_relaxed);
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  const uint32_t workgroup_count[3] = {256, 1, 1};
+  iree_task_dispatch_t dispatch;
+  iree_task_dispatch_initialize(
+      &scope,
+      iree_task_make_dispatch_closure(
+          [](uintptr_t user_context,
+             const iree_task_tile_context_t* tile_context,
+             iree_task_submission_t* pending_submission) {
+            if (make_denormal() == 0.0f) {
+              iree_atomic_fetch_add_int32(&flushed_tile_count, 1,
+                                          iree_memory_order_relaxed);
+            }
+            return iree_ok_status();
+          },
+          0),
+      workgroup_size, workgroup_count, &dispatch);
+  dispatch.header.flags |= IREE_TASK_FLAG_FLUSH_DENORMALS_TO_ZERO;
+
+  static float call_value;
+  call_value = 0.0f;
+  iree_task_call_t call;
+  iree_task_call_initialize(&scope,
+                            iree_task_make_call_closure(
+                                [](uintptr_t user_context, iree_task_t* task,
+                                   iree_task_submission_t* pending_submission) {
+                                  call_value = make_denormal();
+                                  return iree_ok_status();
+                                },
+                                0),
+                            &call);
+  iree_task_set_completion_task(&dispatch.header, &call.header);
+
+  iree_task_fence_t* fence = NULL;
+  IREE_CHECK_OK(iree_task_executor_acquire_fence(executor, &scope, &fence));
+  iree_task_set_completion_task(&call.header, &fence->header);
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  iree_task_submission_enqueue(&submission, &dispatch.header);
+  iree_task_executor_submit(executor, &submission);
+  iree_task_executor_flush(executor);
+  IREE_CHECK_OK(iree_task_scope_wait_idle(&scope, IREE_TIME_INFINITE_FUTURE));
+  EXPECT_EQ(256, iree_atomic_load_int32(&flushed_tile_count,
+                                        iree_memory_order_relaxed));
+  EXPECT_NE(0.0f, call_value);
+
+  iree_task_scope_deinitialize(&scope);
+  iree_task_executor_release(executor);
+}
+
+TEST(ExecutorTest, DonateCaller) {
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/2, &topology);
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  options.worker_local_memory_size = 4 * 1024;
+  iree_task_executor_t* executor = NULL;
+  IREE_CHECK_OK(iree_task_executor_create(options, &topology,
+                                          iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+
+  // Donating with a wait handle that has already resolved returns immediately.
+  iree_event_t event;
+  IREE_CHECK_OK(iree_event_initialize(/*initial_state=*/true, &event));
+  IREE_EXPECT_OK(iree_task_executor_donate_caller(executor, &event,
+                                                  IREE_TIME_INFINITE_FUTURE));
+  iree_event_reset(&event);
+
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("scope"), &scope);
+
+  // A dispatch followed by a call that signals the event the caller donates
+  // itself on. The caller may execute any of the tiles but must only return
+  // once the event has been signaled.
+  static iree_atomic_int32_t tile_count;
+  iree_atomic_store_int32(&tile_count, 0, iree_memory_order_relaxed);
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  const uint32_t workgroup_count[3] = {64, 1, 1};
+  iree_task_dispatch_t dispatch;
+  iree_task_dispatch_initialize(
+      &scope,
+      iree_task_make_dispatch_closure(
+          [](uintptr_t user_context,
+             const iree_task_tile_context_t* tile_context,
+             iree_task_submission_t* pending_submission) {
+            simulate_work(tile_context);
+            iree_atomic_fetch_add_int32(&tile_count, 1,
+                                        iree_memory_order_relaxed);
+            return iree_ok_status();
+          },
+          0),
+      workgroup_size, workgroup_count, &dispatch);
+  iree_task_call_t call;
+  iree_task_call_initialize(&scope,
+                            iree_task_make_call_closure(
+                                [](uintptr_t user_context, iree_task_t* task,
+                                   iree_task_submission_t* pending_submission) {
+                                  iree_event_set((iree_event_t*)user_context);
+                                  return iree_ok_status();
+                                },
+                                (uintptr_t)&event),
+                            &call);
+  iree_task_set_completion_task(&dispatch.header, &call.header);
+  iree_task_fence_t* fence = NULL;
+  IREE_CHECK_OK(iree_task_executor_acquire_fence(executor, &scope, &fence));
+  iree_task_set_completion_task(&call.header, &fence->header);
+
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  iree_task_submission_enqueue(&submission, &dispatch.header);
+  iree_task_executor_submit(executor, &submission);
+  IREE_EXPECT_OK(iree_task_executor_donate_caller(executor, &event,
+                                                  IREE_TIME_INFINITE_FUTURE));
+  EXPECT_EQ(64, iree_atomic_load_int32(&tile_count, iree_memory_order_relaxed));
+
+  IREE_CHECK_OK(iree_task_scope_wait_idle(&scope, IREE_TIME_INFINITE_FUTURE));
+  iree_task_scope_deinitialize(&scope);
+  iree_event_deinitialize(&event);
+  iree_task_executor_release(executor);
+}
+
+TEST(ExecutorTest, ReserveLocalMemory) {
+  // Workers start without any local memory and grow it once reserved.
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/2, &topology);
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  iree_task_executor_t* executor = NULL;
+  IREE_CHECK_OK(iree_task_executor_create(options, &topology,
+                                          iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+
+  static const iree_host_size_t kLocalMemorySize = 48 * 1024;
+  iree_task_executor_reserve_local_memory(executor, kLocalMemorySize);
+  // Smaller reservations never shrink the existing one.
+  iree_task_executor_reserve_local_memory(executor, 1024);
+
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("scope"), &scope);
+
+  static iree_atomic_int32_t tile_count;
+  iree_atomic_store_int32(&tile_count, 0, iree_memory_order_relaxed);
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  const uint32_t workgroup_count[3] = {32, 1, 1};
+  iree_task_dispatch_t dispatch;
+  iree_task_dispatch_initialize(
+      &scope,
+      iree_task_make_dispatch_closure(
+          [](uintptr_t user_context,
+             const iree_task_tile_context_t* tile_context,
+             iree_task_submission_t* pending_submission) {
+            EXPECT_GE(tile_context->local_memory.data_length,
+                      kLocalMemorySize);
+            memset(tile_context->local_memory.data, 0xCD, kLocalMemorySize);
+            iree_atomic_fetch_add_int32(&tile_count, 1,
+                                        iree_memory_order_relaxed);
+            return iree_ok_status();
+          },
+          0),
+      workgroup_size, workgroup_count, &dispatch);
+  dispatch.local_memory_size = kLocalMemorySize;
+  iree_task_fence_t* fence = NULL;
+  IREE_CHECK_OK(iree_task_executor_acquire_fence(executor, &scope, &fence));
+  iree_task_set_completion_task(&dispatch.header, &fence->header);
+
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  iree_task_submission_enqueue(&submission, &dispatch.header);
+  iree_task_executor_submit(executor, &submission);
+  iree_task_executor_flush(executor);
+  IREE_CHECK_OK(iree_task_scope_wait_idle(&scope, IREE_TIME_INFINITE_FUTURE));
+  IREE_EXPECT_OK(iree_task_scope_consume_status(&scope));
+  EXPECT_EQ(32, iree_atomic_load_int32(&tile_count, iree_memory_order_relaxed));
+
+  iree_task_scope_deinitialize(&scope);
+  iree_task_executor_release(executor);
+}
+
+TEST(ExecutorTest, HighPriorityPreemptsLowPriority) {
+  // A single worker ensures the high priority work can only run if the low
+  // priority dispatch yields the worker.
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/1, &topology);
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  iree_task_executor_t* executor = NULL;
+  IREE_CHECK_OK(iree_task_executor_create(options, &topology,
+                                          iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("scope"), &scope);
+
+  // Low priority tiles block until the high priority call has been submitted
+  // such that the worker is guaranteed to still be within the low priority
+  // dispatch when the call arrives regardless of how fast the tiles run. The
+  // call is only submitted once a tile has started so that the worker cannot
+  // pick up both tasks from its mailbox at once and run the dispatch first.
+  static iree_atomic_int32_t low_priority_started;
+  static iree_atomic_int32_t low_priority_released;
+  static iree_notification_t low_priority_gate;
+  iree_atomic_store_int32(&low_priority_started, 0,
+                          iree_memory_order_relaxed);
+  iree_atomic_store_int32(&low_priority_released, 0,
+                          iree_memory_order_relaxed);
+  iree_notification_initialize(&low_priority_gate);
+
+  // Low priority dispatch with many more tiles than are reserved at a time.
+  static iree_atomic_int32_t tile_count;
+  iree_atomic_store_int32(&tile_count, 0, iree_memory_order_relaxed);
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  const uint32_t workgroup_count[3] = {512, 1, 1};
+  iree_task_dispatch_t dispatch;
+  iree_task_dispatch_initialize(
+      &scope,
+      iree_task_make_dispatch_closure(
+          [](uintptr_t user_context,
+             const iree_task_tile_context_t* tile_context,
+             iree_task_submission_t* pending_submission) {
+            iree_atomic_store_int32(&low_priority_started, 1,
+                                    iree_memory_order_release);
+            iree_notification_post(&low_priority_gate, IREE_ALL_WAITERS);
+            iree_notification_await(
+                &low_priority_gate,
+                +[](void* arg) {
+                  return iree_atomic_load_int32(
+                             &low_priority_released,
+                             iree_memory_order_acquire) != 0;
+                },
+                NULL);
+            iree_atomic_fetch_add_int32(&tile_count, 1,
+                                        iree_memory_order_relaxed);
+            return iree_ok_status();
+          },
+          0),
+      workgroup_size, workgroup_count, &dispatch);
+  iree_task_fence_t* low_fence = NULL;
+  IREE_CHECK_OK(iree_task_executor_acquire_fence(executor, &scope, &low_fence));
+  iree_task_set_completion_task(&dispatch.header, &low_fence->header);
+  iree_task_submission_t low_submission;
+  iree_task_submission_initialize(&low_submission);
+  low_submission.priority = IREE_TASK_PRIORITY_LOW;
+  iree_task_submission_enqueue(&low_submission, &dispatch.header);
+  iree_task_executor_submit(executor, &low_submission);
+  iree_task_executor_flush(executor);
+  iree_notification_await(
+      &low_priority_gate,
+      +[](void* arg) {
+        return iree_atomic_load_int32(&low_priority_started,
+                                      iree_memory_order_acquire) != 0;
+      },
+      NULL);
+
+  // High priority call that records how many low priority tiles had completed
+  // by the time it ran.
+  static iree_atomic_int32_t tile_count_at_call;
+  iree_atomic_store_int32(&tile_count_at_call, -1, iree_memory_order_relaxed);
+  iree_task_call_t call;
+  iree_task_call_initialize(&scope,
+                            iree_task_make_call_closure(
+                                [](uintptr_t user_context, iree_task_t* task,
+                                   iree_task_submission_t* pending_submission) {
+                                  iree_atomic_store_int32(
+                                      &tile_count_at_call,
+                                      iree_atomic_load_int32(
+                                          &tile_count,
+                                          iree_memory_order_relaxed),
+                                      iree_memory_order_relaxed);
+                                  return iree_ok_status();
+                                },
+                                0),
+                            &call);
+  iree_task_fence_t* high_fence = NULL;
+  IREE_CHECK_OK(
+      iree_task_executor_acquire_fence(executor, &scope, &high_fence));
+  iree_task_set_completion_task(&call.header, &high_fence->header);
+  iree_task_submission_t high_submission;
+  iree_task_submission_initialize(&high_submission);
+  high_submission.priority = IREE_TASK_PRIORITY_HIGH;
+  iree_task_submission_enqueue(&high_submission, &call.header);
+  iree_task_executor_submit(executor, &high_submission);
+  iree_task_executor_flush(executor);
+
+  // The call has been posted to the worker; let the low priority tiles run.
+  iree_atomic_store_int32(&low_priority_released, 1,
+                          iree_memory_order_release);
+  iree_notification_post(&low_priority_gate, IREE_ALL_WAITERS);
+
+  IREE_CHECK_OK(iree_task_scope_wait_idle(&scope, IREE_TIME_INFINITE_FUTURE));
+
+  // The call must have run before the low priority dispatch finished and the
+  // preempted dispatch must still have completed all of its tiles.
+  EXPECT_GE(iree_atomic_load_int32(&tile_count_at_call,
+                                   iree_memory_order_relaxed),
+            0);
+  EXPECT_LT(iree_atomic_load_int32(&tile_count_at_call,
+                                   iree_memory_order_relaxed),
+            512);
+  EXPECT_EQ(512,
+            iree_atomic_load_int32(&tile_count, iree_memory_order_relaxed));
+
+  iree_notification_deinitialize(&low_priority_gate);
+  iree_task_scope_deinitialize(&scope);
+  iree_task_executor_release(executor);
+}
+
 }  // namespace
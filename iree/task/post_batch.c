@@ -15,6 +15,7 @@
 #include "iree/base/tracing.h"
 #include "iree/task/executor_impl.h"
 #include "iree/task/queue.h"
+#include "iree/task/scope.h"
 #include "iree/task/worker.h"
 
 void iree_task_post_batch_initialize(iree_task_executor_t* executor,
@@ -23,6 +24,8 @@ void iree_task_post_batch_initialize(iree_task_executor_t* executor,
   out_post_batch->executor = executor;
   out_post_batch->current_worker = current_worker;
   out_post_batch->worker_pending_mask = 0;
+  memset(&out_post_batch->worker_priority_masks, 0,
+         sizeof(out_post_batch->worker_priority_masks));
   memset(&out_post_batch->worker_pending_lifos, 0,
          executor->worker_count * sizeof(iree_task_list_t));
 }
@@ -83,13 +86,31 @@ iree_host_size_t iree_task_post_batch_select_worker(
   return iree_task_post_batch_select_random_worker(post_batch, affinity_set);
 }
 
+iree_task_pool_t* iree_task_post_batch_worker_task_pool(
+    iree_task_post_batch_t* post_batch, iree_host_size_t worker_index) {
+  return post_batch->executor->workers[worker_index].dispatch_task_pool;
+}
+
 void iree_task_post_batch_enqueue(iree_task_post_batch_t* post_batch,
                                   iree_host_size_t worker_index,
                                   iree_task_t* task) {
   iree_task_list_push_front(&post_batch->worker_pending_lifos[worker_index],
                             task);
-  post_batch->worker_pending_mask |=
+  iree_task_affinity_set_t worker_bit =
       iree_task_affinity_for_worker(worker_index);
+  if (!(post_batch->worker_pending_mask & worker_bit)) {
+    post_batch->worker_virtual_times[worker_index] = INT64_MAX;
+    post_batch->worker_virtual_time_scopes[worker_index] = NULL;
+  }
+  post_batch->worker_pending_mask |= worker_bit;
+  post_batch->worker_priority_masks[worker_index] |= 1u << task->priority;
+  if (task->scope) {
+    int64_t virtual_time_ns = iree_task_scope_virtual_time(task->scope);
+    if (virtual_time_ns < post_batch->worker_virtual_times[worker_index]) {
+      post_batch->worker_virtual_times[worker_index] = virtual_time_ns;
+      post_batch->worker_virtual_time_scopes[worker_index] = task->scope;
+    }
+  }
 }
 
 // Wakes each worker indicated in the |wake_mask|, if needed.
@@ -100,6 +121,14 @@ static void iree_task_post_batch_wake_workers(
 
   iree_task_executor_t* executor = post_batch->executor;
 
+  // Workers blocked on the executor wait set won't see their notification so
+  // their wait is interrupted instead (see iree_task_executor_wait_any_task).
+  if (iree_atomic_task_affinity_set_load(&executor->worker_wait_mask,
+                                         iree_memory_order_relaxed) &
+      wake_mask) {
+    iree_event_set(&executor->wait_interrupt_event);
+  }
+
   // Wake workers that may be suspended. We fetch the set of workers we need to
   // wake (hopefully none in the common case) and mark that we've woken them so
   // that we don't double-resume.
@@ -141,6 +170,7 @@ static void iree_task_post_batch_wake_workers(
     // atomic load) if a particular worker isn't waiting or it's required to
     // actually wake it and we can't avoid it.
     iree_task_worker_t* worker = &executor->workers[wake_index];
+    iree_task_worker_mark_wake_posted(worker);
     iree_notification_post(&worker->wake_notification, 1);
   }
 
@@ -177,8 +207,16 @@ bool iree_task_post_batch_submit(iree_task_post_batch_t* post_batch) {
                                                    target_pending_lifo);
     } else {
       iree_task_worker_post_tasks(worker, target_pending_lifo);
+      iree_task_worker_mark_priorities_posted(
+          worker, post_batch->worker_priority_masks[target_index]);
+      if (post_batch->worker_virtual_time_scopes[target_index]) {
+        iree_task_worker_mark_virtual_time_posted(
+            worker, post_batch->worker_virtual_time_scopes[target_index],
+            post_batch->worker_virtual_times[target_index]);
+      }
       worker_wake_mask |= iree_task_affinity_for_worker(target_index);
     }
+    post_batch->worker_priority_masks[target_index] = 0;
   }
 
   // Wake all workers that now have pending work. If a worker is not already
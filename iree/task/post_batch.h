@@ -39,6 +39,19 @@ typedef struct iree_task_post_batch_t {
   // Used to quickly scan the lists and perform the posts only when required.
   iree_task_affinity_set_t worker_pending_mask;
 
+  // A per-worker bitmask of the priorities (1 << iree_task_priority_t) of the
+  // tasks in each pending list. Published to the worker when posting so that
+  // it can preempt lower priority work.
+  uint8_t worker_priority_masks[IREE_TASK_EXECUTOR_MAX_WORKER_COUNT];
+
+  // A per-worker lowest scope virtual time of the tasks in each pending list
+  // and the scope it was taken from. Published to the worker when posting so
+  // that it can yield to scopes that are behind. Only valid for workers with
+  // their bit set in |worker_pending_mask|.
+  int64_t worker_virtual_times[IREE_TASK_EXECUTOR_MAX_WORKER_COUNT];
+  iree_task_scope_t* worker_virtual_time_scopes
+      [IREE_TASK_EXECUTOR_MAX_WORKER_COUNT];
+
   // A per-worker LIFO task list waiting to be posted.
   iree_task_list_t worker_pending_lifos[0];
 } iree_task_post_batch_t;
@@ -55,6 +68,11 @@ iree_host_size_t iree_task_post_batch_worker_count(
 iree_host_size_t iree_task_post_batch_select_worker(
     iree_task_post_batch_t* post_batch, iree_task_affinity_set_t affinity_set);
 
+// Returns the pool that transient tasks posted to |worker_index| should be
+// allocated from. Pools are shared by all workers on the same NUMA node.
+iree_task_pool_t* iree_task_post_batch_worker_task_pool(
+    iree_task_post_batch_t* post_batch, iree_host_size_t worker_index);
+
 // Enqueues a task to the given worker. Note that the pending work lists for
 // each work is kept in LIFO order so that we can easily concatenate it with the
 // worker mailbox slist that's in LIFO order.
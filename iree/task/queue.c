@@ -77,6 +77,9 @@ iree_task_t* iree_task_queue_try_steal(iree_task_queue_t* source_queue,
   iree_slim_mutex_lock(&source_queue->mutex);
   iree_task_list_split(&source_queue->list, max_tasks, &stolen_tasks);
   iree_slim_mutex_unlock(&source_queue->mutex);
+  for (iree_task_t* task = stolen_tasks.head; task; task = task->next_task) {
+    task->flags |= IREE_TASK_FLAG_STOLEN;
+  }
 
   // Add any stolen tasks to the target queue and pop off the head for return.
   iree_task_t* next_task = NULL;
@@ -25,6 +25,11 @@ void iree_task_scope_initialize(iree_string_view_t name,
   // TODO(benvanik): pick trace colors based on name hash.
   IREE_TRACE(out_scope->task_trace_color = 0xFFFF0000u);
 
+  iree_atomic_store_int64(&out_scope->deadline_ns, IREE_TIME_INFINITE_FUTURE,
+                          iree_memory_order_relaxed);
+  iree_atomic_store_int32(&out_scope->weight, IREE_TASK_SCOPE_DEFAULT_WEIGHT,
+                          iree_memory_order_relaxed);
+
   iree_slim_mutex_initialize(&out_scope->mutex);
   iree_notification_initialize(&out_scope->idle_notification);
 
@@ -111,6 +116,57 @@ void iree_task_scope_fail(iree_task_scope_t* scope, iree_task_t* task,
   iree_task_scope_try_set_status(scope, status);
 }
 
+void iree_task_scope_set_deadline(iree_task_scope_t* scope,
+                                  iree_time_t deadline_ns) {
+  iree_atomic_store_int64(&scope->deadline_ns, deadline_ns,
+                          iree_memory_order_relaxed);
+}
+
+iree_status_code_t iree_task_scope_cancellation_code(iree_task_scope_t* scope) {
+  iree_status_t permanent_status = (iree_status_t)iree_atomic_load_intptr(
+      &scope->permanent_status, iree_memory_order_relaxed);
+  if (IREE_UNLIKELY(!iree_status_is_ok(permanent_status))) {
+    return iree_status_code(permanent_status);
+  }
+  iree_time_t deadline_ns =
+      iree_atomic_load_int64(&scope->deadline_ns, iree_memory_order_relaxed);
+  if (deadline_ns != IREE_TIME_INFINITE_FUTURE &&
+      IREE_UNLIKELY(iree_time_now() >= deadline_ns)) {
+    return IREE_STATUS_DEADLINE_EXCEEDED;
+  }
+  return IREE_STATUS_OK;
+}
+
+void iree_task_scope_set_weight(iree_task_scope_t* scope, uint32_t weight) {
+  IREE_ASSERT_GT(weight, 0);
+  iree_atomic_store_int32(&scope->weight, (int32_t)iree_max(1, weight),
+                          iree_memory_order_relaxed);
+}
+
+uint32_t iree_task_scope_weight(iree_task_scope_t* scope) {
+  return (uint32_t)iree_atomic_load_int32(&scope->weight,
+                                          iree_memory_order_relaxed);
+}
+
+void iree_task_scope_charge(iree_task_scope_t* scope,
+                            iree_duration_t duration_ns) {
+  if (duration_ns <= 0) return;
+  iree_atomic_fetch_add_int64(&scope->virtual_time_ns,
+                              duration_ns / iree_task_scope_weight(scope),
+                              iree_memory_order_relaxed);
+}
+
+void iree_task_scope_advance_virtual_time(iree_task_scope_t* scope,
+                                          int64_t min_virtual_time_ns) {
+  int64_t virtual_time_ns = iree_task_scope_virtual_time(scope);
+  while (virtual_time_ns < min_virtual_time_ns &&
+         !iree_atomic_compare_exchange_weak_int64(
+             &scope->virtual_time_ns, &virtual_time_ns, min_virtual_time_ns,
+             iree_memory_order_relaxed, iree_memory_order_relaxed)) {
+    // Retry with the virtual time charged concurrently.
+  }
+}
+
 void iree_task_scope_begin(iree_task_scope_t* scope) {
   iree_slim_mutex_lock(&scope->mutex);
   ++scope->pending_submissions;
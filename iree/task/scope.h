@@ -40,6 +40,15 @@ extern "C" {
 // overhead is low and the only advantage of reusing them is that lifetime can
 // become easier to manage by tying them 1:1 with producers.
 //
+// Scopes also carry a scheduling weight used to share the executor workers
+// fairly between concurrent producers (such as multiple models hosted on one
+// device). Each scope accumulates the execution time of its dispatches divided
+// by its weight as its virtual time and the executor schedules the ready tasks
+// of the scopes with the lowest virtual time first. Dispatch shards yield at
+// tile reservation boundaries to work posted to their worker from scopes that
+// are more than IREE_TASK_SCOPE_FAIRNESS_QUANTUM_NS behind. Under contention a
+// scope with weight 2 receives twice the worker time of a scope with weight 1.
+//
 // Thread-safe; once created scopes are modified exclusively via atomic
 // operations.
 typedef struct iree_task_scope_t {
@@ -55,6 +64,20 @@ typedef struct iree_task_scope_t {
   // to completion.
   iree_atomic_intptr_t permanent_status;
 
+  // Absolute time after which tasks within the scope are cancelled, or
+  // IREE_TIME_INFINITE_FUTURE if the scope has no deadline. Unlike failures the
+  // deadline is not permanent and may be extended to resume execution.
+  iree_atomic_int64_t deadline_ns;
+
+  // Relative share of the executor workers given to the scope when multiple
+  // scopes have work ready. Defaults to IREE_TASK_SCOPE_DEFAULT_WEIGHT.
+  iree_atomic_int32_t weight;
+
+  // Execution time in nanoseconds charged to the scope divided by its weight.
+  // Only meaningful relative to the virtual time of other scopes scheduled on
+  // the same executor, which may advance it when the scope has been idle.
+  iree_atomic_int64_t virtual_time_ns;
+
   // Dispatch statistics aggregated from all dispatches in this scope. Updated
   // relatively infrequently and must not be used for task control as values
   // are undefined in the case of failure and may tear.
@@ -84,6 +107,9 @@ typedef struct iree_task_scope_t {
   iree_notification_t idle_notification;
 } iree_task_scope_t;
 
+// Scheduling weight of newly initialized scopes.
+#define IREE_TASK_SCOPE_DEFAULT_WEIGHT 1
+
 // Initializes a caller-allocated scope.
 // Callers must ensure the scope remains live for as long as there are any
 // tasks that may reference it.
@@ -124,6 +150,53 @@ void iree_task_scope_abort(iree_task_scope_t* scope);
 void iree_task_scope_fail(iree_task_scope_t* scope, iree_task_t* task,
                           iree_status_t status);
 
+// Sets the absolute time after which tasks within the scope are cancelled.
+// Dispatches check for cancellation when issued and at each shard reservation
+// boundary and stop executing tiles once the deadline has elapsed; tasks that
+// are already executing a tile will complete it. Pass IREE_TIME_INFINITE_FUTURE
+// to clear the deadline.
+void iree_task_scope_set_deadline(iree_task_scope_t* scope,
+                                  iree_time_t deadline_ns);
+
+// Returns the status code tasks within the scope should be cancelled with or
+// IREE_STATUS_OK if they may continue executing. This is the code of the
+// permanent failure status if the scope has failed or been aborted and
+// IREE_STATUS_DEADLINE_EXCEEDED if the scope deadline has elapsed.
+iree_status_code_t iree_task_scope_cancellation_code(iree_task_scope_t* scope);
+
+// Returns true if tasks within the scope should stop executing.
+// Cheap enough to be called between units of work: only a relaxed atomic load
+// unless the scope has a deadline.
+static inline bool iree_task_scope_is_cancelled(iree_task_scope_t* scope) {
+  return iree_task_scope_cancellation_code(scope) != IREE_STATUS_OK;
+}
+
+// Sets the relative share of the executor workers the tasks within the scope
+// receive when tasks from other scopes are ready at the same time. |weight|
+// must be > 0. Takes effect for work executed after the call.
+void iree_task_scope_set_weight(iree_task_scope_t* scope, uint32_t weight);
+
+// Returns the scheduling weight of the scope.
+uint32_t iree_task_scope_weight(iree_task_scope_t* scope);
+
+// Returns the weighted virtual time of the scope in nanoseconds.
+static inline int64_t iree_task_scope_virtual_time(iree_task_scope_t* scope) {
+  return iree_atomic_load_int64(&scope->virtual_time_ns,
+                                iree_memory_order_relaxed);
+}
+
+// Charges |duration_ns| of execution time of a task within the scope to the
+// scope virtual time, scaled by the scope weight. Called by the task system as
+// dispatch tiles execute.
+void iree_task_scope_charge(iree_task_scope_t* scope,
+                            iree_duration_t duration_ns);
+
+// Advances the scope virtual time to at least |min_virtual_time_ns|.
+// Used by executors to bound the credit idle scopes accumulate relative to
+// those that have been executing.
+void iree_task_scope_advance_virtual_time(iree_task_scope_t* scope,
+                                          int64_t min_virtual_time_ns);
+
 // Notifies the scope that a new execution task assigned to the scope has begun.
 // The scope is considered active until it is notified execution has completed
 // with iree_task_scope_end.
@@ -114,6 +114,82 @@ TEST(ScopeTest, FailAgain) {
   iree_task_scope_deinitialize(&scope);
 }
 
+TEST(ScopeTest, DeadlineCancellation) {
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("scope_a"), &scope);
+
+  // Scopes have no deadline by default.
+  EXPECT_FALSE(iree_task_scope_is_cancelled(&scope));
+
+  // Elapsed deadlines cancel the scope.
+  iree_task_scope_set_deadline(&scope, IREE_TIME_INFINITE_PAST);
+  EXPECT_TRUE(iree_task_scope_is_cancelled(&scope));
+  EXPECT_EQ(IREE_STATUS_DEADLINE_EXCEEDED,
+            iree_task_scope_cancellation_code(&scope));
+
+  // Deadlines are not sticky and can be extended.
+  iree_task_scope_set_deadline(&scope, iree_time_now() + 1000000000ll);
+  EXPECT_FALSE(iree_task_scope_is_cancelled(&scope));
+  iree_task_scope_set_deadline(&scope, IREE_TIME_INFINITE_FUTURE);
+  EXPECT_FALSE(iree_task_scope_is_cancelled(&scope));
+
+  // Not consumed by checking for cancellation.
+  EXPECT_TRUE(iree_status_is_ok(iree_task_scope_consume_status(&scope)));
+
+  iree_task_scope_deinitialize(&scope);
+}
+
+TEST(ScopeTest, AbortCancellation) {
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("scope_a"), &scope);
+
+  // Failures take precedence over the deadline and remain sticky.
+  iree_task_scope_abort(&scope);
+  EXPECT_EQ(IREE_STATUS_ABORTED, iree_task_scope_cancellation_code(&scope));
+  iree_task_scope_set_deadline(&scope, IREE_TIME_INFINITE_PAST);
+  EXPECT_EQ(IREE_STATUS_ABORTED, iree_task_scope_cancellation_code(&scope));
+  iree_task_scope_set_deadline(&scope, IREE_TIME_INFINITE_FUTURE);
+  EXPECT_TRUE(iree_task_scope_is_cancelled(&scope));
+
+  iree_task_scope_deinitialize(&scope);
+}
+
+TEST(ScopeTest, WeightedVirtualTime) {
+  iree_task_scope_t scope_a;
+  iree_task_scope_initialize(iree_make_cstring_view("scope_a"), &scope_a);
+  iree_task_scope_t scope_b;
+  iree_task_scope_initialize(iree_make_cstring_view("scope_b"), &scope_b);
+  EXPECT_EQ(IREE_TASK_SCOPE_DEFAULT_WEIGHT, iree_task_scope_weight(&scope_a));
+  EXPECT_EQ(0, iree_task_scope_virtual_time(&scope_a));
+
+  // The same execution time advances a scope with twice the weight half as
+  // far.
+  iree_task_scope_set_weight(&scope_a, 1);
+  iree_task_scope_set_weight(&scope_b, 2);
+  EXPECT_EQ(2, iree_task_scope_weight(&scope_b));
+  iree_task_scope_charge(&scope_a, 1000);
+  iree_task_scope_charge(&scope_b, 1000);
+  EXPECT_EQ(1000, iree_task_scope_virtual_time(&scope_a));
+  EXPECT_EQ(500, iree_task_scope_virtual_time(&scope_b));
+
+  iree_task_scope_deinitialize(&scope_b);
+  iree_task_scope_deinitialize(&scope_a);
+}
+
+TEST(ScopeTest, AdvanceVirtualTime) {
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("scope_a"), &scope);
+  iree_task_scope_charge(&scope, 1000);
+
+  // Virtual time only ever moves forward.
+  iree_task_scope_advance_virtual_time(&scope, 500);
+  EXPECT_EQ(1000, iree_task_scope_virtual_time(&scope));
+  iree_task_scope_advance_virtual_time(&scope, 3000);
+  EXPECT_EQ(3000, iree_task_scope_virtual_time(&scope));
+
+  iree_task_scope_deinitialize(&scope);
+}
+
 TEST(ScopeTest, WaitIdleWhenIdle) {
   iree_task_scope_t scope;
   iree_task_scope_initialize(iree_make_cstring_view("scope_a"), &scope);
@@ -14,6 +14,7 @@
 void iree_task_submission_initialize(iree_task_submission_t* out_submission) {
   iree_task_list_initialize(&out_submission->ready_list);
   iree_task_list_initialize(&out_submission->waiting_list);
+  out_submission->priority = IREE_TASK_PRIORITY_NORMAL;
 }
 
 void iree_task_submission_initialize_from_lifo_slist(
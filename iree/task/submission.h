@@ -59,6 +59,11 @@ typedef struct iree_task_submission_t {
   // more of a set than an ordered list and that they can all be waited on as a
   // multi-wait-any.
   iree_task_list_t waiting_list;
+
+  // Priority assigned to all root tasks in the submission when it is submitted
+  // to an executor. Dependent tasks inherit the priority of the tasks that
+  // ready them. Defaults to IREE_TASK_PRIORITY_NORMAL.
+  iree_task_priority_t priority;
 } iree_task_submission_t;
 
 // Initializes a task submission.
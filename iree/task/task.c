@@ -29,6 +29,7 @@ void iree_task_initialize(iree_task_type_t type, iree_task_scope_t* scope,
   out_task->scope = scope;
   out_task->affinity_set = iree_task_affinity_for_any_worker();
   out_task->type = type;
+  out_task->priority = IREE_TASK_PRIORITY_NORMAL;
 }
 
 void iree_task_set_cleanup_fn(iree_task_t* task,
@@ -53,12 +54,33 @@ bool iree_task_is_ready(iree_task_t* task) {
   return true;
 }
 
+void iree_task_rearm(iree_task_t* task) {
+  IREE_ASSERT(!task->pool);
+  IREE_ASSERT_EQ(0, iree_atomic_load_int32(&task->pending_dependency_count,
+                                           iree_memory_order_acquire));
+  task->next_task = NULL;
+  task->completion_task = NULL;
+  switch (task->type) {
+    default:
+      break;
+    case IREE_TASK_TYPE_WAIT:
+      task->flags &= ~IREE_TASK_FLAG_WAIT_COMPLETED;
+      break;
+    case IREE_TASK_TYPE_DISPATCH: {
+      iree_task_dispatch_t* dispatch_task = (iree_task_dispatch_t*)task;
+      task->flags &= ~IREE_TASK_FLAG_DISPATCH_RETIRE;
+      memset(&dispatch_task->statistics, 0, sizeof(dispatch_task->statistics));
+      break;
+    }
+  }
+}
+
 static void iree_task_cleanup(iree_task_t* task, iree_status_t status) {
   // Call the (optional) cleanup function.
   // NOTE: this may free the memory of the task itself!
   iree_task_pool_t* pool = task->pool;
   if (task->cleanup_fn) {
-    task->cleanup_fn(task, iree_ok_status());
+    task->cleanup_fn(task, status);
   }
 
   // Return the task to the pool it was allocated from.
@@ -69,6 +91,16 @@ static void iree_task_cleanup(iree_task_t* task, iree_status_t status) {
   }
 }
 
+// Adds |task| to |discard_worklist| if the dependency being discarded was the
+// last one it was waiting on.
+static void iree_task_discard_dependent(iree_task_t* task,
+                                        iree_task_list_t* discard_worklist) {
+  if (iree_atomic_fetch_sub_int32(&task->pending_dependency_count, 1,
+                                  iree_memory_order_acq_rel) == 1) {
+    iree_task_list_push_front(discard_worklist, task);
+  }
+}
+
 void iree_task_discard(iree_task_t* task, iree_task_list_t* discard_worklist) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
@@ -77,9 +109,11 @@ void iree_task_discard(iree_task_t* task, iree_task_list_t* discard_worklist) {
   // our non-recursive approach.
 
   // Almost all tasks will have a completion task; some may have additional
-  // dependent tasks (like barriers) that will be handled below.
+  // dependent tasks (like barriers) that will be handled below. Tasks with
+  // multiple dependencies are only discarded by the last one so that they are
+  // discarded exactly once.
   if (task->completion_task) {
-    iree_task_list_push_front(discard_worklist, task->completion_task);
+    iree_task_discard_dependent(task->completion_task, discard_worklist);
   }
 
   switch (task->type) {
@@ -90,14 +124,20 @@ void iree_task_discard(iree_task_t* task, iree_task_list_t* discard_worklist) {
     case IREE_TASK_TYPE_BARRIER: {
       iree_task_barrier_t* barrier_task = (iree_task_barrier_t*)task;
       for (uint32_t i = 0; i < barrier_task->dependent_task_count; ++i) {
-        iree_task_list_push_front(discard_worklist,
-                                  barrier_task->dependent_tasks[i]);
+        iree_task_discard_dependent(barrier_task->dependent_tasks[i],
+                                    discard_worklist);
       }
       break;
     }
     case IREE_TASK_TYPE_FENCE: {
-      // TODO(benvanik): signal as error.
-      // iree_task_fence_t* fence_task = (iree_task_fence_t*)task;
+      // Fail any external waiters (such as semaphores) that would otherwise
+      // never be signaled now that the fence will not be reached.
+      iree_task_fence_t* fence_task = (iree_task_fence_t*)task;
+      if (fence_task->signal_fn) {
+        fence_task->signal_fn(
+            fence_task->signal_user_context, task,
+            iree_make_status(IREE_STATUS_ABORTED, "fence discarded"));
+      }
       iree_task_scope_end(task->scope);
       break;
     }
@@ -121,15 +161,30 @@ static void iree_task_retire(iree_task_t* task,
   // Decrement the pending count on the completion task, if any.
   iree_task_t* completion_task = task->completion_task;
   task->completion_task = NULL;
-  if (completion_task &&
+  bool is_completion_ready =
+      completion_task &&
       iree_atomic_fetch_sub_int32(&completion_task->pending_dependency_count, 1,
-                                  iree_memory_order_acq_rel) == 1) {
-    // The completion task has retired and can now be made ready.
-    iree_task_submission_enqueue(pending_submission, completion_task);
+                                  iree_memory_order_acq_rel) == 1;
+  if (is_completion_ready) {
+    completion_task->priority = task->priority;
   }
 
+  // Cleanup happens before the completion task is readied so that completion
+  // tasks retired inline may release the memory holding |task|.
   iree_task_cleanup(task, iree_ok_status());
   // NOTE: task is invalidated here and cannot be used!
+
+  if (is_completion_ready) {
+    if (completion_task->type == IREE_TASK_TYPE_FENCE) {
+      // Fences do no work so we retire them immediately instead of paying for
+      // a round-trip through the executor before waiters are notified.
+      iree_task_fence_retire((iree_task_fence_t*)completion_task,
+                             pending_submission);
+    } else {
+      // The completion task has retired and can now be made ready.
+      iree_task_submission_enqueue(pending_submission, completion_task);
+    }
+  }
 }
 
 //==============================================================================
@@ -223,6 +278,7 @@ void iree_task_barrier_retire(iree_task_barrier_t* task,
     if (iree_atomic_fetch_sub_int32(&dependent_task->pending_dependency_count,
                                     1, iree_memory_order_acq_rel) == 1) {
       // The dependent task has retired and can now be made ready.
+      dependent_task->priority = task->header.priority;
       iree_task_submission_enqueue(pending_submission, dependent_task);
     }
   }
@@ -238,13 +294,29 @@ void iree_task_barrier_retire(iree_task_barrier_t* task,
 void iree_task_fence_initialize(iree_task_scope_t* scope,
                                 iree_task_fence_t* out_task) {
   iree_task_initialize(IREE_TASK_TYPE_FENCE, scope, &out_task->header);
+  out_task->signal_fn = NULL;
+  out_task->signal_user_context = 0;
   iree_task_scope_begin(scope);
 }
 
+void iree_task_fence_set_signal_fn(iree_task_fence_t* task,
+                                   iree_task_fence_signal_fn_t signal_fn,
+                                   uintptr_t user_context) {
+  task->signal_fn = signal_fn;
+  task->signal_user_context = user_context;
+}
+
 void iree_task_fence_retire(iree_task_fence_t* task,
                             iree_task_submission_t* pending_submission) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // Signal before notifying the scope so that anything owned by the signal
+  // function remains live until waiters on the scope are released.
+  if (task->signal_fn) {
+    task->signal_fn(task->signal_user_context, &task->header,
+                    iree_ok_status());
+  }
+
   iree_task_scope_end(task->header.scope);
 
   iree_task_retire(&task->header, pending_submission);
@@ -263,6 +335,19 @@ void iree_task_wait_initialize(iree_task_scope_t* scope,
 }
 
 bool iree_task_wait_check_condition(iree_task_wait_t* task) {
+  // The executor may act on a wake handle some time after the wait set
+  // reported it as signaled. Handles recycled through pools (such as HAL
+  // semaphore timepoint events) may have been reset and reused by another wait
+  // task by then so the handle is polled again to confirm it is signaled.
+  iree_status_t status =
+      iree_wait_one(&task->wait_handle, IREE_TIME_INFINITE_PAST);
+  if (iree_status_is_deadline_exceeded(status)) {
+    iree_status_ignore(status);
+    return false;
+  }
+  // Other failures complete the wait so that the task does not hang; the
+  // dependent tasks are responsible for observing the failure.
+  iree_status_ignore(status);
   // TODO(benvanik): conditions.
   task->header.flags |= IREE_TASK_FLAG_WAIT_COMPLETED;
   return true;
@@ -358,10 +443,34 @@ static uint32_t iree_task_tile_to_color(
 
 #endif  // IREE_TASK_TRACING_PER_TILE_COLORS
 
+// Adds the value of |source| into |target| with the given memory |order|.
+static inline void iree_task_dispatch_statistics_add(
+    const iree_atomic_int64_t* source, iree_atomic_int64_t* target,
+    iree_memory_order_t order) {
+  // NOTE: the atomic load builtins don't accept const pointers on all
+  // compilers.
+  int64_t value = iree_atomic_load_int64((iree_atomic_int64_t*)source,
+                                         iree_memory_order_relaxed);
+  if (value) iree_atomic_fetch_add_int64(target, value, order);
+}
+
 void iree_task_dispatch_statistics_merge(
     const iree_task_dispatch_statistics_t* source,
     iree_task_dispatch_statistics_t* target) {
-  // TODO(benvanik): statistics.
+  iree_task_dispatch_statistics_add(&source->duration_ns, &target->duration_ns,
+                                    iree_memory_order_relaxed);
+  iree_task_dispatch_statistics_add(&source->tile_count, &target->tile_count,
+                                    iree_memory_order_relaxed);
+  iree_task_dispatch_statistics_add(&source->shard_count, &target->shard_count,
+                                    iree_memory_order_relaxed);
+  iree_task_dispatch_statistics_add(&source->stolen_shard_count,
+                                    &target->stolen_shard_count,
+                                    iree_memory_order_relaxed);
+  // Merged last so that consumers observing the dispatch also observe the
+  // counters that were merged along with it.
+  iree_task_dispatch_statistics_add(&source->dispatch_count,
+                                    &target->dispatch_count,
+                                    iree_memory_order_release);
 }
 
 //==============================================================================
@@ -376,7 +485,10 @@ static void iree_task_dispatch_initialize_base(
   memcpy(out_task->workgroup_size, workgroup_size,
          sizeof(out_task->workgroup_size));
   out_task->local_memory_size = 0;
+  out_task->tile_cost_hint = 0;
   memset(&out_task->statistics, 0, sizeof(out_task->statistics));
+  out_task->retire_statistics = NULL;
+  out_task->issue_time_ns = 0;
 }
 
 void iree_task_dispatch_initialize(iree_task_scope_t* scope,
@@ -398,8 +510,41 @@ void iree_task_dispatch_initialize_indirect(
   out_task->workgroup_count.ptr = workgroup_count_ptr;
 }
 
+// Returns |lhs| / |rhs| rounded up.
+static inline uint32_t iree_task_dispatch_ceil_div(uint32_t lhs, uint32_t rhs) {
+  return (lhs + rhs - 1) / rhs;
+}
+
+// Returns the number of tiles along X that each slice of |dispatch_task| should
+// contain given the |slice_row_count| of Y*Z slices the grid has.
+static uint32_t iree_task_dispatch_select_tiles_per_slice_x(
+    const iree_task_dispatch_t* dispatch_task, uint32_t workgroup_count_x,
+    uint32_t slice_row_count, iree_host_size_t worker_count) {
+  uint32_t tiles_per_slice_x = IREE_TASK_DISPATCH_TILES_PER_SLICE_X;
+
+  // Expensive tiles get smaller slices so that stealing (which is done per
+  // slice) can balance the load; cheap tiles keep the full slice size.
+  if (dispatch_task->tile_cost_hint > 0) {
+    uint32_t target_tiles = IREE_TASK_DISPATCH_TARGET_RESERVATION_COST /
+                            dispatch_task->tile_cost_hint;
+    tiles_per_slice_x = iree_max(1, iree_min(tiles_per_slice_x, target_tiles));
+  }
+
+  // If we'd end up with fewer slices than workers then narrow the slices so
+  // that all workers can participate.
+  uint32_t slice_count =
+      iree_task_dispatch_ceil_div(workgroup_count_x, tiles_per_slice_x) *
+      slice_row_count;
+  if (slice_count < worker_count) {
+    uint32_t slices_per_row = iree_task_dispatch_ceil_div(
+        (uint32_t)worker_count, iree_max(1, slice_row_count));
+    tiles_per_slice_x = iree_max(
+        1, iree_task_dispatch_ceil_div(workgroup_count_x, slices_per_row));
+  }
+  return tiles_per_slice_x;
+}
+
 void iree_task_dispatch_issue_sliced(iree_task_dispatch_t* dispatch_task,
-                                     iree_task_pool_t* slice_task_pool,
                                      iree_task_submission_t* pending_submission,
                                      iree_task_post_batch_t* post_batch) {
   IREE_TRACE_ZONE_BEGIN(z0);
@@ -407,6 +552,17 @@ void iree_task_dispatch_issue_sliced(iree_task_dispatch_t* dispatch_task,
   // Mark the dispatch as having been issued; the next time it retires it'll be
   // because all work has completed.
   dispatch_task->header.flags |= IREE_TASK_FLAG_DISPATCH_RETIRE;
+  dispatch_task->issue_time_ns = iree_time_now();
+
+  // Skip the work entirely if the scope was cancelled while the dispatch was
+  // waiting on its dependencies; dependent tasks will still be readied.
+  iree_task_scope_t* scope = dispatch_task->header.scope;
+  if (IREE_UNLIKELY(iree_task_scope_is_cancelled(scope))) {
+    IREE_TRACE_ZONE_APPEND_TEXT(z0, "cancelled");
+    iree_task_dispatch_retire(dispatch_task, pending_submission);
+    IREE_TRACE_ZONE_END(z0);
+    return;
+  }
 
   // Fetch the workgroup count (directly or indirectly).
   // By the task being ready to execute we know any dependencies on the
@@ -437,16 +593,26 @@ void iree_task_dispatch_issue_sliced(iree_task_dispatch_t* dispatch_task,
 #endif  // IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
 
   // Divide up all tiles into slices, our finest-granularity scheduling task.
-  const uint32_t tiles_per_slice_x = IREE_TASK_DISPATCH_TILES_PER_SLICE_X;
+  // The tuning values are the maximum slice size; small dispatches that would
+  // otherwise end up with fewer slices than there are workers get narrower
+  // slices along X so that they can still be spread across the workers.
+  iree_host_size_t worker_count = iree_task_post_batch_worker_count(post_batch);
   const uint32_t tiles_per_slice_y = IREE_TASK_DISPATCH_TILES_PER_SLICE_Y;
   const uint32_t tiles_per_slice_z = IREE_TASK_DISPATCH_TILES_PER_SLICE_Z;
-  uint32_t slice_count_x = iree_max(1, workgroup_count[0] / tiles_per_slice_x);
-  uint32_t slice_count_y = iree_max(1, workgroup_count[1] / tiles_per_slice_y);
-  uint32_t slice_count_z = iree_max(1, workgroup_count[2] / tiles_per_slice_z);
+  uint32_t slice_count_y =
+      iree_task_dispatch_ceil_div(workgroup_count[1], tiles_per_slice_y);
+  uint32_t slice_count_z =
+      iree_task_dispatch_ceil_div(workgroup_count[2], tiles_per_slice_z);
+  uint32_t tiles_per_slice_x = iree_task_dispatch_select_tiles_per_slice_x(
+      dispatch_task, workgroup_count[0], slice_count_y * slice_count_z,
+      worker_count);
+  uint32_t slice_count_x =
+      iree_task_dispatch_ceil_div(workgroup_count[0], tiles_per_slice_x);
 
   // Compute how many slices each worker will process.
   uint32_t slice_count = slice_count_x * slice_count_y * slice_count_z;
-  iree_host_size_t worker_count = iree_task_post_batch_worker_count(post_batch);
+  iree_atomic_store_int64(&dispatch_task->statistics.shard_count, slice_count,
+                          iree_memory_order_relaxed);
   uint32_t slices_per_worker = iree_max(1, slice_count / worker_count);
 
   // Randomize starting worker.
@@ -478,14 +644,17 @@ void iree_task_dispatch_issue_sliced(iree_task_dispatch_t* dispatch_task,
                                       workgroup_base[2] + tiles_per_slice_z) -
                              1;
 
-        // Allocate and initialize the slice.
+        // Allocate and initialize the slice from the pool local to the worker
+        // it will be executed on.
+        iree_host_size_t target_worker_index = worker_index % worker_count;
         iree_task_dispatch_slice_t* slice_task =
-            iree_task_dispatch_slice_allocate(dispatch_task, workgroup_base,
-                                              workgroup_range, workgroup_count,
-                                              slice_task_pool);
+            iree_task_dispatch_slice_allocate(
+                dispatch_task, workgroup_base, workgroup_range, workgroup_count,
+                iree_task_post_batch_worker_task_pool(post_batch,
+                                                      target_worker_index));
 
         // Enqueue on the worker selected for the task.
-        iree_task_post_batch_enqueue(post_batch, worker_index % worker_count,
+        iree_task_post_batch_enqueue(post_batch, target_worker_index,
                                      &slice_task->header);
         if (++worker_slice_count >= slices_per_worker) {
           ++worker_index;
@@ -510,7 +679,7 @@ void iree_task_dispatch_issue_sliced(iree_task_dispatch_t* dispatch_task,
 }
 
 void iree_task_dispatch_issue_sharded(
-    iree_task_dispatch_t* dispatch_task, iree_task_pool_t* shard_task_pool,
+    iree_task_dispatch_t* dispatch_task,
     iree_task_submission_t* pending_submission,
     iree_task_post_batch_t* post_batch) {
   IREE_TRACE_ZONE_BEGIN(z0);
@@ -518,6 +687,17 @@ void iree_task_dispatch_issue_sharded(
   // Mark the dispatch as having been issued; the next time it retires it'll be
   // because all work has completed.
   dispatch_task->header.flags |= IREE_TASK_FLAG_DISPATCH_RETIRE;
+  dispatch_task->issue_time_ns = iree_time_now();
+
+  // Skip the work entirely if the scope was cancelled while the dispatch was
+  // waiting on its dependencies; dependent tasks will still be readied.
+  iree_task_scope_t* scope = dispatch_task->header.scope;
+  if (IREE_UNLIKELY(iree_task_scope_is_cancelled(scope))) {
+    IREE_TRACE_ZONE_APPEND_TEXT(z0, "cancelled");
+    iree_task_dispatch_retire(dispatch_task, pending_submission);
+    IREE_TRACE_ZONE_END(z0);
+    return;
+  }
 
   iree_task_dispatch_shard_state_t* shared_state =
       &dispatch_task->shared.shard_state;
@@ -552,22 +732,46 @@ void iree_task_dispatch_issue_sharded(
       workgroup_count[0] * workgroup_count[1] * workgroup_count[2];
 
   // Compute shard count - almost always worker_count unless we are a very small
-  // dispatch (1x1x1, etc).
+  // dispatch (1x1x1, etc) or the cost hint indicates that there's not enough
+  // work to be worth waking all workers.
   iree_host_size_t worker_count = iree_task_post_batch_worker_count(post_batch);
   iree_host_size_t shard_count =
       iree_min(shared_state->tile_count, worker_count);
+  uint64_t total_cost =
+      (uint64_t)shared_state->tile_count * dispatch_task->tile_cost_hint;
+  if (total_cost > 0) {
+    uint64_t cost_shard_count =
+        (total_cost + IREE_TASK_DISPATCH_MIN_SHARD_COST - 1) /
+        IREE_TASK_DISPATCH_MIN_SHARD_COST;
+    shard_count = (iree_host_size_t)iree_min(shard_count, cost_shard_count);
+  }
+  iree_atomic_store_int64(&dispatch_task->statistics.shard_count, shard_count,
+                          iree_memory_order_relaxed);
 
   // Compute how many tiles we want each shard to reserve at a time from the
   // larger grid. A higher number reduces overhead and improves locality while
   // a lower number reduces maximum worst-case latency (coarser work stealing).
-  if (shared_state->tile_count <
-      worker_count * IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION) {
+  uint32_t tiles_per_reservation =
+      IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION;
+  if (dispatch_task->tile_cost_hint > 0) {
+    // Size reservations such that each amounts to roughly the same cost.
+    tiles_per_reservation =
+        iree_min(tiles_per_reservation,
+                 IREE_TASK_DISPATCH_TARGET_RESERVATION_COST /
+                     dispatch_task->tile_cost_hint);
+  }
+  if (shared_state->tile_count < shard_count * tiles_per_reservation) {
     // Grid is small - allow it to be eagerly sliced up.
-    shared_state->tiles_per_reservation = 1;
-  } else {
-    shared_state->tiles_per_reservation =
-        IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION;
+    tiles_per_reservation = 1;
   }
+  shared_state->tiles_per_reservation = iree_max(1, tiles_per_reservation);
+
+  // Guided self-scheduling starts with large reservations that shrink as the
+  // grid is consumed; the divisor is based on how many shards are competing.
+  shared_state->guided_reservation_divisor =
+      (dispatch_task->header.flags & IREE_TASK_FLAG_DISPATCH_GUIDED)
+          ? (uint32_t)shard_count * IREE_TASK_DISPATCH_GUIDED_SCHEDULING_DIVISOR
+          : 0;
 
   // Randomize starting worker.
   iree_host_size_t worker_offset = iree_task_post_batch_select_worker(
@@ -575,12 +779,15 @@ void iree_task_dispatch_issue_sharded(
   iree_host_size_t worker_index = worker_offset;
 
   for (iree_host_size_t i = 0; i < shard_count; ++i) {
-    // Allocate and initialize the shard.
+    // Allocate and initialize the shard from the pool local to the worker it
+    // will be executed on.
+    iree_host_size_t target_worker_index = worker_index % worker_count;
     iree_task_dispatch_shard_t* shard_task = iree_task_dispatch_shard_allocate(
-        dispatch_task, shared_state, shard_task_pool);
+        dispatch_task, shared_state,
+        iree_task_post_batch_worker_task_pool(post_batch, target_worker_index));
 
     // Enqueue on the worker selected for the task.
-    iree_task_post_batch_enqueue(post_batch, worker_index % worker_count,
+    iree_task_post_batch_enqueue(post_batch, target_worker_index,
                                  &shard_task->header);
     ++worker_index;
   }
@@ -605,11 +812,24 @@ void iree_task_dispatch_retire(iree_task_dispatch_t* dispatch_task,
 
   // TODO(benvanik): attach statistics to the tracy zone.
 
+  // All slices/shards have merged their statistics by the time we get here so
+  // we can finalize the dispatch-level ones.
+  iree_task_dispatch_statistics_t* statistics = &dispatch_task->statistics;
+  iree_atomic_store_int64(&statistics->duration_ns,
+                          iree_time_now() - dispatch_task->issue_time_ns,
+                          iree_memory_order_relaxed);
+  iree_atomic_store_int64(&statistics->dispatch_count, 1,
+                          iree_memory_order_relaxed);
+
   // Merge the statistics from the dispatch into the scope so we can track all
   // of the work without tracking all the dispatches at a global level.
   iree_task_dispatch_statistics_merge(
-      &dispatch_task->statistics,
-      &dispatch_task->header.scope->dispatch_statistics);
+      statistics, &dispatch_task->header.scope->dispatch_statistics);
+  if (dispatch_task->retire_statistics) {
+    iree_task_dispatch_statistics_merge(statistics,
+                                        dispatch_task->retire_statistics);
+    dispatch_task->retire_statistics = NULL;
+  }
 
   iree_task_retire(&dispatch_task->header, pending_submission);
   IREE_TRACE_ZONE_END(z0);
@@ -626,6 +846,9 @@ void iree_task_dispatch_slice_initialize(iree_task_dispatch_t* dispatch_task,
                                          iree_task_dispatch_slice_t* out_task) {
   iree_task_initialize(IREE_TASK_TYPE_DISPATCH_SLICE,
                        dispatch_task->header.scope, &out_task->header);
+  out_task->header.priority = dispatch_task->header.priority;
+  out_task->header.flags |=
+      dispatch_task->header.flags & IREE_TASK_FLAG_FLUSH_DENORMALS_TO_ZERO;
   iree_task_set_completion_task(&out_task->header, &dispatch_task->header);
   out_task->closure = dispatch_task->closure;
 
@@ -668,7 +891,7 @@ iree_task_dispatch_slice_t* iree_task_dispatch_slice_allocate(
 
 iree_status_t iree_task_dispatch_slice_execute(
     iree_task_dispatch_slice_t* task, iree_byte_span_t local_memory,
-    iree_task_submission_t* pending_submission) {
+    uint32_t* out_tile_count, iree_task_submission_t* pending_submission) {
   IREE_TRACE_ZONE_BEGIN(z0);
   IREE_TRACE_ZONE_SET_COLOR(z0,
                             iree_math_ptr_to_xrgb(task->closure.user_context));
@@ -697,12 +920,23 @@ iree_status_t iree_task_dispatch_slice_execute(
   tile_context.local_memory =
       iree_make_byte_span(local_memory.data, task->local_memory_size);
 
+  // Drop the slice if the scope was cancelled before it started executing.
+  // Slices are small enough that we don't check again between tiles.
+  if (IREE_UNLIKELY(iree_task_scope_is_cancelled(task->header.scope))) {
+    IREE_TRACE_ZONE_APPEND_TEXT(z0, "cancelled");
+    iree_task_retire(&task->header, pending_submission);
+    IREE_TRACE_ZONE_END(z0);
+    return iree_ok_status();
+  }
+
+  iree_time_t start_ns = iree_time_now();
   const uint32_t base_x = task->workgroup_base[0];
   const uint32_t base_y = task->workgroup_base[1];
   const uint32_t base_z = task->workgroup_base[2];
   const uint32_t range_x = task->workgroup_range[0];
   const uint32_t range_y = task->workgroup_range[1];
   const uint32_t range_z = task->workgroup_range[2];
+  uint32_t slice_tile_count = 0;
   for (uint32_t z = base_z; z <= range_z; ++z) {
     tile_context.workgroup_xyz[2] = z;
     for (uint32_t y = base_y; y <= range_y; ++y) {
@@ -723,6 +957,8 @@ iree_status_t iree_task_dispatch_slice_execute(
 
         iree_status_t status = task->closure.fn(
             task->closure.user_context, &tile_context, pending_submission);
+        ++*out_tile_count;
+        ++slice_tile_count;
 
         IREE_TRACE_ZONE_END(z_tile);
         if (IREE_UNLIKELY(!iree_status_is_ok(status))) {
@@ -735,7 +971,11 @@ iree_status_t iree_task_dispatch_slice_execute(
     }
   }
 
+  iree_task_scope_charge(task->header.scope, iree_time_now() - start_ns);
+
   // Push aggregate statistics up to the dispatch.
+  iree_atomic_fetch_add_int64(&task->slice_statistics.tile_count,
+                              slice_tile_count, iree_memory_order_relaxed);
   if (task->dispatch_statistics) {
     iree_task_dispatch_statistics_merge(&task->slice_statistics,
                                         task->dispatch_statistics);
@@ -756,6 +996,9 @@ void iree_task_dispatch_shard_initialize(
     iree_task_dispatch_shard_t* out_task) {
   iree_task_initialize(IREE_TASK_TYPE_DISPATCH_SHARD,
                        dispatch_task->header.scope, &out_task->header);
+  out_task->header.priority = dispatch_task->header.priority;
+  out_task->header.flags |=
+      dispatch_task->header.flags & IREE_TASK_FLAG_FLUSH_DENORMALS_TO_ZERO;
   iree_task_set_completion_task(&out_task->header, &dispatch_task->header);
   out_task->dispatch_task = dispatch_task;
   out_task->shared_state = shared_state;
@@ -777,9 +1020,63 @@ iree_task_dispatch_shard_t* iree_task_dispatch_shard_allocate(
   return shard_task;
 }
 
+// Returns the number of tiles the next reservation from |shared_state| should
+// take. In guided mode this is a fraction of the remaining tiles based on a
+// relaxed read of the shared tile index; races only cause the reservation to be
+// slightly larger or smaller than ideal as the fetch-add that follows is what
+// actually claims the tiles.
+//
+// The size is scaled by the |relative_performance| percentage of the executing
+// core so that slower cores on heterogeneous systems claim less work at a time.
+static uint32_t iree_task_dispatch_shard_reservation_size(
+    iree_task_dispatch_shard_state_t* shared_state,
+    uint32_t relative_performance) {
+  uint32_t size = shared_state->tiles_per_reservation;
+  if (shared_state->guided_reservation_divisor) {
+    uint32_t tile_index = (uint32_t)iree_atomic_load_int32(
+        &shared_state->tile_index, iree_memory_order_relaxed);
+    if (tile_index >= shared_state->tile_count) return 1;
+    uint32_t remaining_tiles = shared_state->tile_count - tile_index;
+    uint32_t guided_size =
+        remaining_tiles / shared_state->guided_reservation_divisor;
+    uint32_t max_size = IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION *
+                        shared_state->tiles_per_reservation;
+    size = iree_min(guided_size, max_size);
+  }
+  if (relative_performance < 100) {
+    size = (uint32_t)(((uint64_t)size * relative_performance) / 100);
+  }
+  return iree_max(1, size);
+}
+
+// Returns true if |task| should yield to higher priority work or work from a
+// scope that is behind in virtual time as indicated by |preemption|.
+static bool iree_task_dispatch_shard_should_yield(
+    iree_task_dispatch_shard_t* task, iree_task_preemption_t* preemption) {
+  if (!preemption) return false;
+  const int32_t higher_priority_mask = (1 << task->header.priority) - 1;
+  if ((iree_atomic_load_int32(&preemption->priority_mask,
+                              iree_memory_order_relaxed) &
+       higher_priority_mask) != 0) {
+    return true;
+  }
+  int64_t posted_virtual_time_ns = iree_atomic_load_int64(
+      &preemption->virtual_time_ns, iree_memory_order_relaxed);
+  if (posted_virtual_time_ns == INT64_MAX ||
+      iree_atomic_load_intptr(&preemption->virtual_time_scope,
+                              iree_memory_order_relaxed) ==
+          (intptr_t)task->header.scope) {
+    return false;
+  }
+  return posted_virtual_time_ns <
+         iree_task_scope_virtual_time(task->header.scope) -
+             IREE_TASK_SCOPE_FAIRNESS_QUANTUM_NS;
+}
+
 iree_status_t iree_task_dispatch_shard_execute(
     iree_task_dispatch_shard_t* task, iree_byte_span_t local_memory,
-    iree_task_submission_t* pending_submission) {
+    iree_task_preemption_t* preemption, uint32_t relative_performance,
+    uint32_t* out_tile_count, iree_task_submission_t* pending_submission) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
   iree_task_dispatch_t* dispatch_task = task->dispatch_task;
@@ -817,13 +1114,20 @@ iree_status_t iree_task_dispatch_shard_execute(
   memset(&shard_statistics, 0, sizeof(shard_statistics));
   tile_context.statistics = &shard_statistics;
 
-  // Loop over all tiles until they are all processed.
+  // Loop over all tiles until they are all processed or the scope is cancelled.
+  // Cancellation is checked at each reservation boundary so that a cancelled
+  // shard stops consuming the core after at most one reservation of tiles; the
+  // shard still retires normally so that the dispatch completes.
   const uint32_t tile_count = shared_state->tile_count;
-  const uint32_t tiles_per_reservation = shared_state->tiles_per_reservation;
+  uint32_t shard_tile_count = 0;
+  uint32_t tiles_per_reservation = iree_task_dispatch_shard_reservation_size(
+      shared_state, relative_performance);
   uint32_t tile_base = iree_atomic_fetch_add_int32(&shared_state->tile_index,
                                                    tiles_per_reservation,
                                                    iree_memory_order_relaxed);
-  while (tile_base < tile_count) {
+  iree_task_scope_t* scope = task->header.scope;
+  iree_time_t reservation_start_ns = iree_time_now();
+  while (tile_base < tile_count && !iree_task_scope_is_cancelled(scope)) {
     const uint32_t tile_range =
         iree_min(tile_base + tiles_per_reservation, tile_count);
     for (uint32_t tile_index = tile_base; tile_index < tile_range;
@@ -851,6 +1155,8 @@ iree_status_t iree_task_dispatch_shard_execute(
       iree_status_t status =
           dispatch_task->closure.fn(dispatch_task->closure.user_context,
                                     &tile_context, pending_submission);
+      ++*out_tile_count;
+      ++shard_tile_count;
 
       IREE_TRACE_ZONE_END(z_tile);
       if (IREE_UNLIKELY(!iree_status_is_ok(status))) {
@@ -861,12 +1167,37 @@ iree_status_t iree_task_dispatch_shard_execute(
       }
     }
 
+    // Charge the reservation to the scope so that the executor can share the
+    // workers fairly with other scopes.
+    iree_time_t reservation_end_ns = iree_time_now();
+    iree_task_scope_charge(scope, reservation_end_ns - reservation_start_ns);
+    reservation_start_ns = reservation_end_ns;
+
+    // Yield to higher priority work or to scopes that are behind in virtual
+    // time at the reservation boundary; the shard will pick up where the grid
+    // left off when it is next executed. Other shards of the dispatch that are
+    // not preempted keep draining the grid in the meantime.
+    if (iree_task_dispatch_shard_should_yield(task, preemption)) {
+      iree_atomic_store_int64(&shard_statistics.tile_count, shard_tile_count,
+                              iree_memory_order_relaxed);
+      iree_task_dispatch_statistics_merge(&shard_statistics,
+                                          &dispatch_task->statistics);
+      iree_task_submission_enqueue(pending_submission, &task->header);
+      IREE_TRACE_ZONE_APPEND_TEXT(z0, "preempted");
+      IREE_TRACE_ZONE_END(z0);
+      return iree_ok_status();
+    }
+
+    tiles_per_reservation = iree_task_dispatch_shard_reservation_size(
+        shared_state, relative_performance);
     tile_base = iree_atomic_fetch_add_int32(&shared_state->tile_index,
                                             tiles_per_reservation,
                                             iree_memory_order_relaxed);
   }
 
   // Push aggregate statistics up to the dispatch.
+  iree_atomic_store_int64(&shard_statistics.tile_count, shard_tile_count,
+                          iree_memory_order_relaxed);
   iree_task_dispatch_statistics_merge(&shard_statistics,
                                       &dispatch_task->statistics);
 
@@ -112,9 +112,72 @@ enum iree_task_flag_bits_t {
   // behavior but without an additional task as dispatches are still required
   // to store information for slices.
   IREE_TASK_FLAG_DISPATCH_RETIRE = 1u << 3,
+
+  // The dispatch should use guided self-scheduling when sharded: each shard
+  // reservation takes a fraction of the remaining tiles such that the
+  // reservation size shrinks as the dispatch nears completion. This trades
+  // slightly more contention on the shared grid state for a shorter tail when
+  // tiles take variable amounts of time or workers progress unevenly.
+  IREE_TASK_FLAG_DISPATCH_GUIDED = 1u << 4,
+
+  // The task executes with denormal floating-point values flushed to zero
+  // (FTZ/DAZ). May be set on calls and dispatches and is inherited by the
+  // slices and shards of a dispatch. Workers only change their FPU state when
+  // the requirements of consecutive tasks differ so that runs of tasks with the
+  // same requirements pay for no FPU state writes. Tasks that change the FPU
+  // state themselves must restore it before returning.
+  IREE_TASK_FLAG_FLUSH_DENORMALS_TO_ZERO = 1u << 5,
+
+  // The task was stolen from the worker it was originally posted to. Set by
+  // the thief and cleared when the task begins executing such that dispatch
+  // slices and shards can attribute the steal to the dispatch statistics.
+  IREE_TASK_FLAG_STOLEN = 1u << 6,
 };
 typedef uint16_t iree_task_flags_t;
 
+// Relative scheduling priority of a task. Lower values are higher priority.
+// Ready tasks of higher priority are scheduled to workers before those of lower
+// priority and may preempt lower priority dispatch shards between tile
+// reservations. Priorities are assigned to the root tasks of a submission and
+// inherited by each dependent task as it is readied.
+enum iree_task_priority_e {
+  // Latency-critical work that should start as soon as possible.
+  IREE_TASK_PRIORITY_HIGH = 0u,
+  // Default priority of all tasks.
+  IREE_TASK_PRIORITY_NORMAL = 1u,
+  // Throughput-oriented work that can tolerate being delayed.
+  IREE_TASK_PRIORITY_LOW = 2u,
+
+  IREE_TASK_PRIORITY_COUNT,
+};
+typedef uint8_t iree_task_priority_t;
+
+// Signals polled by dispatch shards between tile reservations to yield their
+// worker to other work posted to it. Each worker owns one that is updated as
+// tasks are posted to its mailbox and reset when the mailbox is flushed.
+typedef struct iree_task_preemption_t {
+  // Bitmask of the priorities (1 << iree_task_priority_t) of posted tasks.
+  iree_atomic_int32_t priority_mask;
+  // Lowest virtual time of the scopes of posted tasks as of when they were
+  // posted (see iree_task_scope_t) or INT64_MAX if none.
+  iree_atomic_int64_t virtual_time_ns;
+  // Scope |virtual_time_ns| was posted for. Only compared against the scope
+  // of executing shards and never dereferenced as the scope may have since
+  // been deinitialized.
+  iree_atomic_intptr_t virtual_time_scope;
+} iree_task_preemption_t;
+
+// Resets |preemption| to indicate no work has been posted.
+static inline void iree_task_preemption_reset(
+    iree_task_preemption_t* preemption) {
+  iree_atomic_store_int32(&preemption->priority_mask, 0,
+                          iree_memory_order_relaxed);
+  iree_atomic_store_int64(&preemption->virtual_time_ns, INT64_MAX,
+                          iree_memory_order_relaxed);
+  iree_atomic_store_intptr(&preemption->virtual_time_scope, 0,
+                           iree_memory_order_relaxed);
+}
+
 typedef struct iree_task_t iree_task_t;
 
 // A function called to cleanup tasks.
@@ -123,6 +186,14 @@ typedef struct iree_task_t iree_task_t;
 typedef void(IREE_API_PTR* iree_task_cleanup_fn_t)(iree_task_t* task,
                                                    iree_status_t status);
 
+// A function called when a fence task is reached or discarded.
+// |task| is the fence and is only valid for the duration of the call.
+// |status| is OK if all dependencies of the fence retired and a failure if the
+// fence was discarded; the callee takes ownership of it.
+typedef void(IREE_API_PTR* iree_task_fence_signal_fn_t)(uintptr_t user_context,
+                                                        iree_task_t* task,
+                                                        iree_status_t status);
+
 // A task within the task system that runs on an executor.
 // Tasks have an iree_task_type_t that defines which parameters are valid and
 // how the executor is to treat the task. Dependency edges can be defined that
@@ -170,6 +241,9 @@ struct iree_alignas(iree_max_align_t) iree_task_t {
   // Specifies the type of the task and how the executor handles it.
   iree_task_type_t type;
 
+  // Scheduling priority of the task (iree_task_priority_t).
+  iree_task_priority_t priority;
+
   // Task-specific flag bits.
   iree_task_flags_t flags;
 };
@@ -203,6 +277,14 @@ void iree_task_set_completion_task(iree_task_t* task,
 // all tiles to complete).
 bool iree_task_is_ready(iree_task_t* task);
 
+// Resets the execution state of a |task| that has retired such that it can be
+// submitted again. Dependency edges are cleared and must be re-established by
+// the caller with iree_task_set_completion_task and (for barriers)
+// iree_task_barrier_set_dependent_tasks. Only valid for tasks that are not
+// allocated from a pool (as those are released upon retirement) and that have
+// no pending dependencies.
+void iree_task_rearm(iree_task_t* task);
+
 // Discards the task and any dependent tasks.
 // Any dependent tasks that need to be discarded will be added to
 // |discard_worklist| for the caller to continue discarding.
@@ -338,17 +420,33 @@ void iree_task_barrier_set_dependent_tasks(
 // When all of the dependencies of a fence have retired the fence will notify
 // the parent scope of the task by decrementing the pending_submissions count
 // and publishing an idle_notification if it was the last in-flight submission.
+//
+// Fences perform no work of their own and are retired inline by whichever
+// task retires last - usually on the worker that executed it - instead of
+// being routed back through the executor. An optional signal function can be
+// used to notify external waiters (such as semaphores) from that same point
+// without requiring an additional task.
 typedef iree_alignas(iree_max_align_t) struct {
   // Task header: implementation detail, do not use.
   iree_task_t header;
 
-  // TODO(benvanik): user-defined fence data for semaphore signaling. Optional
-  // wait_handle to signal?
+  // Optional function called when the fence is reached or discarded, prior to
+  // the scope being notified. May be called from any worker, the coordinator,
+  // or the thread discarding the fence and must not block.
+  iree_task_fence_signal_fn_t signal_fn;
+
+  // User-defined argument passed to |signal_fn|.
+  uintptr_t signal_user_context;
 } iree_task_fence_t;
 
 void iree_task_fence_initialize(iree_task_scope_t* scope,
                                 iree_task_fence_t* out_task);
 
+// Sets the optional function called with |user_context| when |task| is reached.
+void iree_task_fence_set_signal_fn(iree_task_fence_t* task,
+                                   iree_task_fence_signal_fn_t signal_fn,
+                                   uintptr_t user_context);
+
 //==============================================================================
 // IREE_TASK_TYPE_WAIT
 //==============================================================================
@@ -387,10 +485,22 @@ void iree_task_wait_initialize(iree_task_scope_t* scope,
 // generic ones like 'l2 cache misses' or 'ipc') then we can sprinkle in some
 // #ifdefs.
 typedef struct iree_task_dispatch_statistics_t {
-  // TODO(benvanik): statistics counters.
   // NOTE: each of these increases the command buffer storage requirements; we
-  // should always guard these with a compiler flag.
-  iree_atomic_int32_t reserved;
+  // should avoid adding anything that isn't generally useful.
+
+  // Total number of dispatches that have retired. Merged last (with release
+  // semantics) such that a nonzero value indicates the other fields are valid.
+  iree_atomic_int64_t dispatch_count;
+  // Total wall time in nanoseconds from when the dispatch was issued to when
+  // it retired.
+  iree_atomic_int64_t duration_ns;
+  // Total number of tiles (workgroups) executed.
+  iree_atomic_int64_t tile_count;
+  // Total number of slices/shards the dispatch was split into when issued.
+  iree_atomic_int64_t shard_count;
+  // Total number of slice/shard executions that happened on a worker other
+  // than the one they were originally posted to (that is, were stolen).
+  iree_atomic_int64_t stolen_shard_count;
 } iree_task_dispatch_statistics_t;
 
 // Merges statistics from |source| to |target| atomically per-field.
@@ -453,6 +563,11 @@ typedef iree_alignas(iree_max_align_t) struct {
   // Bounded by IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION and a
   // reasonable number chosen based on the tile and shard counts.
   uint32_t tiles_per_reservation;
+
+  // When non-zero reservations are guided: each reservation takes at most
+  // (tile_count - tile_index) / guided_reservation_divisor tiles (and at least
+  // one) such that reservations shrink as the dispatch nears completion.
+  uint32_t guided_reservation_divisor;
 } iree_task_dispatch_shard_state_t;
 
 //==============================================================================
@@ -533,9 +648,22 @@ typedef iree_alignas(iree_max_align_t) struct iree_task_dispatch_t {
   // dispatch closure.
   uint32_t local_memory_size;
 
+  // Optional estimated cost of executing a single tile in approximate
+  // operations or 0 if unknown. Used when issuing the dispatch to decide how
+  // many shards to fan out to and how many tiles each reserves at a time.
+  uint32_t tile_cost_hint;
+
   // Statistics storage used for aggregating counters across all slices.
   iree_task_dispatch_statistics_t statistics;
 
+  // Optional storage that receives a copy of |statistics| the first time the
+  // dispatch retires. Cleared upon retirement such that re-armed dispatches
+  // only report once. Must remain valid until the dispatch retires.
+  iree_task_dispatch_statistics_t* retire_statistics;
+
+  // Time the dispatch was issued used to compute the statistics duration.
+  iree_time_t issue_time_ns;
+
   // Shared state across all slices/shards/etc.
   // Stored once per dispatch and then referenced by all subtasks.
   union {
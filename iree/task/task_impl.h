@@ -53,9 +53,11 @@ void iree_task_barrier_retire(iree_task_barrier_t* task,
 // IREE_TASK_TYPE_FENCE
 //==============================================================================
 
-// Retires a fence task by updating the scope state.
+// Retires a fence task by calling its signal function (if any) and updating
+// the scope state.
 //
-// Only called during coordination and expects the coordinator lock to be held.
+// Called either during coordination with the coordinator lock held or inline
+// from the worker retiring the last dependency of the fence.
 void iree_task_fence_retire(iree_task_fence_t* task,
                             iree_task_submission_t* pending_submission);
 
@@ -79,26 +81,25 @@ void iree_task_wait_retire(iree_task_wait_t* task,
 //==============================================================================
 
 // Schedules a dispatch by forking out to zero or more slices that will be
-// executed on workers. The slices are allocated from an executor-owned pool
-// and are generally not user-visible - they'll just see their dispatch begin
-// execution prior to the slices and end execution after the last slice
-// finishes.
+// executed on workers. The slices are allocated from the executor-owned pool
+// of the NUMA node of each worker they are posted to and are generally not
+// user-visible - they'll just see their dispatch begin execution prior to the
+// slices and end execution after the last slice finishes.
 //
 // Only called during coordination and expects the coordinator lock to be held.
 void iree_task_dispatch_issue_sliced(iree_task_dispatch_t* dispatch_task,
-                                     iree_task_pool_t* slice_task_pool,
                                      iree_task_submission_t* pending_submission,
                                      iree_task_post_batch_t* post_batch);
 
 // Schedules a dispatch by forking out to zero or more shards that will be
-// executed on workers. The shards are allocated from an executor-owned pool
-// and are generally not user-visible - they'll just see their dispatch begin
-// execution prior to the slices and end execution after the last shard
-// finishes.
+// executed on workers. The shards are allocated from the executor-owned pool
+// of the NUMA node of each worker they are posted to and are generally not
+// user-visible - they'll just see their dispatch begin execution prior to the
+// slices and end execution after the last shard finishes.
 //
 // Only called during coordination and expects the coordinator lock to be held.
 void iree_task_dispatch_issue_sharded(
-    iree_task_dispatch_t* dispatch_task, iree_task_pool_t* shard_task_pool,
+    iree_task_dispatch_t* dispatch_task,
     iree_task_submission_t* pending_submission,
     iree_task_post_batch_t* post_batch);
 
@@ -126,11 +127,13 @@ iree_task_dispatch_slice_t* iree_task_dispatch_slice_allocate(
 // |local_memory| is a block of memory exclusively available to the slice
 // during execution. Contents are undefined both before and after execution.
 //
+// |out_tile_count| is incremented by the number of tiles executed.
+//
 // Returns ok if all tiles were successfully executed and otherwise returns
 // an unspecified status (probably the first non-ok status hit).
 iree_status_t iree_task_dispatch_slice_execute(
     iree_task_dispatch_slice_t* task, iree_byte_span_t local_memory,
-    iree_task_submission_t* pending_submission);
+    uint32_t* out_tile_count, iree_task_submission_t* pending_submission);
 
 //==============================================================================
 // IREE_TASK_TYPE_DISPATCH_SHARD
@@ -150,12 +153,30 @@ iree_task_dispatch_shard_t* iree_task_dispatch_shard_allocate(
 // |local_memory| is a block of memory exclusively available to the shard
 // during execution. Contents are undefined both before and after execution.
 //
+// |preemption| is optionally polled between tile reservations. If work of a
+// priority higher than that of the shard has been posted, or work from another
+// scope whose virtual time is more than IREE_TASK_SCOPE_FAIRNESS_QUANTUM_NS
+// behind that of the shard scope, then the shard will stop reserving tiles and
+// be added back to |pending_submission| without retiring so that it can be
+// rescheduled after the other work. At least one reservation is always
+// processed per execution to guarantee progress. The execution time of each
+// reservation is charged to the shard scope.
+//
+// |relative_performance| is the performance of the executing core relative to
+// the fastest in the machine as a percentage in [1, 100]. Slower cores reserve
+// proportionally fewer tiles at a time such that on heterogeneous systems they
+// take a smaller share of the grid and are less likely to hold up the dispatch
+// by finishing a large final reservation long after the faster cores are done.
+//
+// |out_tile_count| is incremented by the number of tiles executed.
+//
 // Returns ok if all tiles processed in the shard successfully executed and
 // otherwise returns an unspecified status (probably the first non-ok status
 // hit).
 iree_status_t iree_task_dispatch_shard_execute(
     iree_task_dispatch_shard_t* task, iree_byte_span_t local_memory,
-    iree_task_submission_t* pending_submission);
+    iree_task_preemption_t* preemption, uint32_t relative_performance,
+    uint32_t* out_tile_count, iree_task_submission_t* pending_submission);
 
 #ifdef __cplusplus
 }  // extern "C"
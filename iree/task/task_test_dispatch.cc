@@ -6,6 +6,7 @@
 
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <memory>
 
 #include "iree/base/api.h"
@@ -67,7 +68,8 @@ class TaskDispatchTest : public TaskTest {
  public:
   void DispatchAndVerifyGrid(const uint32_t workgroup_size[3],
                              const uint32_t workgroup_count[3],
-                             uint32_t dispatch_flags) {
+                             uint32_t dispatch_flags,
+                             uint32_t tile_cost_hint = 0) {
     GridCoverage coverage(workgroup_count);
     iree_task_dispatch_t task;
     iree_task_dispatch_initialize(&scope_,
@@ -75,6 +77,7 @@ class TaskDispatchTest : public TaskTest {
                                       GridCoverage::Tile, (uintptr_t)&coverage),
                                   workgroup_size, workgroup_count, &task);
     task.header.flags |= dispatch_flags;
+    task.tile_cost_hint = tile_cost_hint;
     IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task.header, &task.header));
     EXPECT_TRUE(coverage.Verify());
   }
@@ -132,6 +135,43 @@ TEST_F(TaskDispatchTest, Issue345Sliced) {
                         IREE_TASK_FLAG_DISPATCH_SLICED);
 }
 
+// X is not a multiple of IREE_TASK_DISPATCH_TILES_PER_SLICE_X.
+TEST_F(TaskDispatchTest, Issue1331Sliced) {
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {13, 3, 1};
+  DispatchAndVerifyGrid(kWorkgroupSize, kWorkgroupCount,
+                        IREE_TASK_FLAG_DISPATCH_SLICED);
+}
+
+TEST_F(TaskDispatchTest, Issue345ShardedGuided) {
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {3, 4, 5};
+  DispatchAndVerifyGrid(kWorkgroupSize, kWorkgroupCount,
+                        IREE_TASK_FLAG_DISPATCH_GUIDED);
+}
+
+TEST_F(TaskDispatchTest, Issue345ShardedCheapTiles) {
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {3, 4, 5};
+  DispatchAndVerifyGrid(kWorkgroupSize, kWorkgroupCount, 0,
+                        /*tile_cost_hint=*/16);
+}
+
+TEST_F(TaskDispatchTest, Issue345ShardedExpensiveTiles) {
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {3, 4, 5};
+  DispatchAndVerifyGrid(kWorkgroupSize, kWorkgroupCount, 0,
+                        /*tile_cost_hint=*/1024 * 1024);
+}
+
+TEST_F(TaskDispatchTest, Issue345SlicedExpensiveTiles) {
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {3, 4, 5};
+  DispatchAndVerifyGrid(kWorkgroupSize, kWorkgroupCount,
+                        IREE_TASK_FLAG_DISPATCH_SLICED,
+                        /*tile_cost_hint=*/1024 * 1024);
+}
+
 TEST_F(TaskDispatchTest, IssueIndirect) {
   static const uint32_t kWorkgroupSize[3] = {1, 1, 1};
   static const uint32_t kWorkgroupCount[3] = {3, 4, 5};
@@ -165,4 +205,127 @@ TEST_F(TaskDispatchTest, IssueIndirect) {
   EXPECT_TRUE(coverage.Verify());
 }
 
+// Verifies the statistics of a single retired dispatch of
+// |expected_tile_count| tiles.
+static void VerifyStatistics(iree_task_dispatch_statistics_t* statistics,
+                             int64_t expected_tile_count) {
+  EXPECT_EQ(1, iree_atomic_load_int64(&statistics->dispatch_count,
+                                      iree_memory_order_acquire));
+  EXPECT_EQ(expected_tile_count,
+            iree_atomic_load_int64(&statistics->tile_count,
+                                   iree_memory_order_relaxed));
+  int64_t shard_count = iree_atomic_load_int64(&statistics->shard_count,
+                                               iree_memory_order_relaxed);
+  EXPECT_GT(shard_count, 0);
+  EXPECT_LE(iree_atomic_load_int64(&statistics->stolen_shard_count,
+                                   iree_memory_order_relaxed),
+            shard_count);
+  EXPECT_GE(iree_atomic_load_int64(&statistics->duration_ns,
+                                   iree_memory_order_relaxed),
+            0);
+}
+
+TEST_F(TaskDispatchTest, Statistics345Sharded) {
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {3, 4, 5};
+  GridCoverage coverage(kWorkgroupCount);
+  iree_task_dispatch_statistics_t retire_statistics;
+  memset(&retire_statistics, 0, sizeof(retire_statistics));
+  iree_task_dispatch_t task;
+  iree_task_dispatch_initialize(&scope_,
+                                iree_task_make_dispatch_closure(
+                                    GridCoverage::Tile, (uintptr_t)&coverage),
+                                kWorkgroupSize, kWorkgroupCount, &task);
+  task.retire_statistics = &retire_statistics;
+  IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task.header, &task.header));
+  EXPECT_TRUE(coverage.Verify());
+  EXPECT_EQ(NULL, task.retire_statistics);
+  VerifyStatistics(&retire_statistics, 3 * 4 * 5);
+  iree_task_dispatch_statistics_t scope_statistics =
+      iree_task_scope_consume_statistics(&scope_);
+  VerifyStatistics(&scope_statistics, 3 * 4 * 5);
+
+  // Consuming resets the scope statistics.
+  scope_statistics = iree_task_scope_consume_statistics(&scope_);
+  EXPECT_EQ(0, iree_atomic_load_int64(&scope_statistics.dispatch_count,
+                                      iree_memory_order_acquire));
+}
+
+TEST_F(TaskDispatchTest, Statistics345Sliced) {
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {3, 4, 5};
+  GridCoverage coverage(kWorkgroupCount);
+  iree_task_dispatch_statistics_t retire_statistics;
+  memset(&retire_statistics, 0, sizeof(retire_statistics));
+  iree_task_dispatch_t task;
+  iree_task_dispatch_initialize(&scope_,
+                                iree_task_make_dispatch_closure(
+                                    GridCoverage::Tile, (uintptr_t)&coverage),
+                                kWorkgroupSize, kWorkgroupCount, &task);
+  task.header.flags |= IREE_TASK_FLAG_DISPATCH_SLICED;
+  task.retire_statistics = &retire_statistics;
+  IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task.header, &task.header));
+  EXPECT_TRUE(coverage.Verify());
+  EXPECT_EQ(NULL, task.retire_statistics);
+  VerifyStatistics(&retire_statistics, 3 * 4 * 5);
+  iree_task_dispatch_statistics_t scope_statistics =
+      iree_task_scope_consume_statistics(&scope_);
+  VerifyStatistics(&scope_statistics, 3 * 4 * 5);
+}
+
+// Verifies that a dispatch in a cancelled scope retires without executing any
+// tiles.
+static void VerifyCancelled(iree_task_dispatch_statistics_t* statistics,
+                            iree_atomic_int32_t* executed_tile_count) {
+  EXPECT_EQ(0, iree_atomic_load_int32(executed_tile_count,
+                                      iree_memory_order_relaxed));
+  EXPECT_EQ(1, iree_atomic_load_int64(&statistics->dispatch_count,
+                                      iree_memory_order_acquire));
+  EXPECT_EQ(0, iree_atomic_load_int64(&statistics->tile_count,
+                                      iree_memory_order_relaxed));
+}
+
+static iree_status_t CountTile(uintptr_t user_context,
+                               const iree_task_tile_context_t* tile_context,
+                               iree_task_submission_t* pending_submission) {
+  iree_atomic_fetch_add_int32((iree_atomic_int32_t*)user_context, 1,
+                              iree_memory_order_relaxed);
+  return iree_ok_status();
+}
+
+TEST_F(TaskDispatchTest, Cancelled345Sharded) {
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {3, 4, 5};
+  iree_atomic_int32_t tile_count = IREE_ATOMIC_VAR_INIT(0);
+  iree_task_dispatch_statistics_t retire_statistics;
+  memset(&retire_statistics, 0, sizeof(retire_statistics));
+  iree_task_dispatch_t task;
+  iree_task_dispatch_initialize(
+      &scope_,
+      iree_task_make_dispatch_closure(CountTile, (uintptr_t)&tile_count),
+      kWorkgroupSize, kWorkgroupCount, &task);
+  task.retire_statistics = &retire_statistics;
+  iree_task_scope_set_deadline(&scope_, IREE_TIME_INFINITE_PAST);
+  IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task.header, &task.header));
+  VerifyCancelled(&retire_statistics, &tile_count);
+}
+
+TEST_F(TaskDispatchTest, Cancelled345Sliced) {
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {3, 4, 5};
+  iree_atomic_int32_t tile_count = IREE_ATOMIC_VAR_INIT(0);
+  iree_task_dispatch_statistics_t retire_statistics;
+  memset(&retire_statistics, 0, sizeof(retire_statistics));
+  iree_task_dispatch_t task;
+  iree_task_dispatch_initialize(
+      &scope_,
+      iree_task_make_dispatch_closure(CountTile, (uintptr_t)&tile_count),
+      kWorkgroupSize, kWorkgroupCount, &task);
+  task.header.flags |= IREE_TASK_FLAG_DISPATCH_SLICED;
+  task.retire_statistics = &retire_statistics;
+  iree_task_scope_abort(&scope_);
+  IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task.header, &task.header));
+  VerifyCancelled(&retire_statistics, &tile_count);
+}
+
 }  // namespace
@@ -4,6 +4,7 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include "iree/task/list.h"
 #include "iree/task/task.h"
 #include "iree/task/testing/task_test.h"
 #include "iree/testing/gtest.h"
@@ -28,4 +29,93 @@ TEST_F(TaskFenceTest, IssueChained) {
   IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task_a.header, &task_c.header));
 }
 
+// Fences retired inline after a call must signal before the scope goes idle.
+TEST_F(TaskFenceTest, SignalAfterCall) {
+  iree_task_call_t call_task;
+  iree_task_call_initialize(&scope_,
+                            iree_task_make_call_closure(
+                                [](uintptr_t user_context, iree_task_t* task,
+                                   iree_task_submission_t* pending_submission) {
+                                  return iree_ok_status();
+                                },
+                                0),
+                            &call_task);
+
+  int signal_count = 0;
+  iree_task_fence_t fence_task;
+  iree_task_fence_initialize(&scope_, &fence_task);
+  iree_task_fence_set_signal_fn(
+      &fence_task,
+      [](uintptr_t user_context, iree_task_t* task, iree_status_t status) {
+        EXPECT_EQ(IREE_TASK_TYPE_FENCE, task->type);
+        IREE_EXPECT_OK(status);
+        ++*(int*)user_context;
+      },
+      (uintptr_t)&signal_count);
+  iree_task_set_completion_task(&call_task.header, &fence_task.header);
+
+  IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&call_task.header, &fence_task.header));
+  EXPECT_EQ(1, signal_count);
+}
+
+// Fences submitted directly are retired by the executor and still signal.
+TEST_F(TaskFenceTest, SignalDirect) {
+  int signal_count = 0;
+  iree_task_fence_t fence_task;
+  iree_task_fence_initialize(&scope_, &fence_task);
+  iree_task_fence_set_signal_fn(
+      &fence_task,
+      [](uintptr_t user_context, iree_task_t* task, iree_status_t status) {
+        IREE_EXPECT_OK(status);
+        ++*(int*)user_context;
+      },
+      (uintptr_t)&signal_count);
+
+  IREE_ASSERT_OK(
+      SubmitTasksAndWaitIdle(&fence_task.header, &fence_task.header));
+  EXPECT_EQ(1, signal_count);
+}
+
+// Fences discarded before being reached (such as when a pending submission is
+// dropped during executor teardown) must still call their signal function
+// with a failure so that external waiters are not left blocked forever.
+TEST_F(TaskFenceTest, SignalOnDiscard) {
+  iree_task_call_t call_task_a;
+  iree_task_call_initialize(&scope_, iree_task_make_call_closure(nullptr, 0),
+                            &call_task_a);
+  iree_task_call_t call_task_b;
+  iree_task_call_initialize(&scope_, iree_task_make_call_closure(nullptr, 0),
+                            &call_task_b);
+
+  // The fence depends on both calls and must only be signaled once.
+  iree_status_code_t signal_code = IREE_STATUS_OK;
+  int signal_count = 0;
+  struct SignalState {
+    iree_status_code_t* code;
+    int* count;
+  } signal_state = {&signal_code, &signal_count};
+  iree_task_fence_t fence_task;
+  iree_task_fence_initialize(&scope_, &fence_task);
+  iree_task_fence_set_signal_fn(
+      &fence_task,
+      [](uintptr_t user_context, iree_task_t* task, iree_status_t status) {
+        SignalState* state = (SignalState*)user_context;
+        *state->code = iree_status_consume_code(status);
+        ++*state->count;
+      },
+      (uintptr_t)&signal_state);
+  iree_task_set_completion_task(&call_task_a.header, &fence_task.header);
+  iree_task_set_completion_task(&call_task_b.header, &fence_task.header);
+
+  iree_task_list_t discard_list;
+  iree_task_list_initialize(&discard_list);
+  iree_task_list_push_back(&discard_list, &call_task_a.header);
+  iree_task_list_push_back(&discard_list, &call_task_b.header);
+  iree_task_list_discard(&discard_list);
+
+  EXPECT_EQ(1, signal_count);
+  EXPECT_EQ(IREE_STATUS_ABORTED, signal_code);
+  EXPECT_TRUE(iree_task_scope_is_idle(&scope_));
+}
+
 }  // namespace
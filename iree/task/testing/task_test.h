@@ -24,10 +24,11 @@ class TaskTest : public ::testing::Test {
   virtual void SetUp() {
     iree_task_topology_t topology;
     iree_task_topology_initialize_from_group_count(8, &topology);
-    IREE_ASSERT_OK(
-        iree_task_executor_create(IREE_TASK_SCHEDULING_MODE_RESERVED, &topology,
-                                  /*worker_local_memory_size=*/(64 * 1024),
-                                  iree_allocator_system(), &executor_));
+    iree_task_executor_options_t options;
+    iree_task_executor_options_initialize(&options);
+    options.worker_local_memory_size = 64 * 1024;
+    IREE_ASSERT_OK(iree_task_executor_create(
+        options, &topology, iree_allocator_system(), &executor_));
     iree_task_topology_deinitialize(&topology);
 
     iree_task_scope_initialize(iree_make_cstring_view("scope"), &scope_);
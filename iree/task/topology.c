@@ -19,8 +19,10 @@ void iree_task_topology_group_initialize(
   out_group->group_index = group_index;
   snprintf(out_group->name, IREE_ARRAYSIZE(out_group->name), "worker[%u]",
            group_index);
+  out_group->relative_performance = 100;
   iree_thread_affinity_set_any(&out_group->ideal_thread_affinity);
   out_group->constructive_sharing_mask = IREE_TASK_TOPOLOGY_GROUP_MASK_ALL;
+  out_group->llc_sharing_mask = IREE_TASK_TOPOLOGY_GROUP_MASK_ALL;
 }
 
 void iree_task_topology_initialize(iree_task_topology_t* out_topology) {
@@ -65,6 +67,16 @@ const iree_task_topology_group_t* iree_task_topology_get_group(
   return &topology->groups[group_index];
 }
 
+iree_host_size_t iree_task_topology_numa_node_count(
+    const iree_task_topology_t* topology) {
+  iree_host_size_t numa_node_count = 1;
+  for (iree_host_size_t i = 0; i < topology->group_count; ++i) {
+    iree_host_size_t numa_node = topology->groups[i].numa_node;
+    numa_node_count = iree_max(numa_node_count, numa_node + 1);
+  }
+  return numa_node_count;
+}
+
 iree_status_t iree_task_topology_push_group(
     iree_task_topology_t* topology, const iree_task_topology_group_t* group) {
   if (topology->group_count + 1 > IREE_ARRAYSIZE(topology->groups)) {
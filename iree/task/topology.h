@@ -41,6 +41,18 @@ typedef struct iree_task_topology_group_t {
   // Processor index in the cpuinfo set.
   uint32_t processor_index;
 
+  // NUMA node the processor is attached to or 0 if unknown/not applicable.
+  // Workers on the same node share a memory controller and will prefer
+  // node-local task storage and node-local victims when stealing work.
+  uint32_t numa_node;
+
+  // Performance of the cores in this group relative to the fastest cores in
+  // the machine as a percentage in [1, 100]. On heterogeneous systems
+  // (big.LITTLE/DynamIQ, hybrid x86) workers of slower groups reserve
+  // proportionally fewer dispatch tiles at a time so that they do not become
+  // stragglers holding up the faster groups. Defaults to 100.
+  uint32_t relative_performance;
+
   // Ideal thread affinity for threads within this group.
   // All threads within the group share the same affinity and this is what
   // allows us to model Simultaneous Multi-Threading (SMT) (aka hyperthreading).
@@ -52,6 +64,12 @@ typedef struct iree_task_topology_group_t {
   // workers in a group all share an L2 cache then the groups indicated here may
   // all share the same L3 cache.
   iree_task_topology_group_mask_t constructive_sharing_mask;
+
+  // A bitmask of other group indices that share the last-level cache (such as
+  // an L3 or a chiplet/CCX) or the same core cluster with this group but are
+  // not already in the constructive_sharing_mask. Workers will prefer stealing
+  // from these groups before stealing from groups across the package.
+  iree_task_topology_group_mask_t llc_sharing_mask;
 } iree_task_topology_group_t;
 
 // Initializes |out_group| with a |group_index| derived name.
@@ -113,6 +131,11 @@ const iree_task_topology_group_t* iree_task_topology_get_group(
 iree_status_t iree_task_topology_push_group(
     iree_task_topology_t* topology, const iree_task_topology_group_t* group);
 
+// Returns the total number of NUMA nodes referenced by the topology groups.
+// This is always at least 1 even if the topology is empty.
+iree_host_size_t iree_task_topology_numa_node_count(
+    const iree_task_topology_t* topology);
+
 // Initializes a topology with the specified number of groups.
 // 0 is a valid value, indicating that only donated threads will be used to
 // perform work. Groups will have no specific affinity and rely on the OS
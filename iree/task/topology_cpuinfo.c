@@ -14,6 +14,10 @@
 #include "iree/base/target_platform.h"
 #include "iree/base/tracing.h"
 
+#if defined(IREE_PLATFORM_LINUX)
+#include <unistd.h>
+#endif  // IREE_PLATFORM_LINUX
+
 // Runs the cpuinfo initializer which caches its result on the first call.
 // Returns a failure if cpuinfo does not support the CPU/platform.
 static iree_status_t iree_task_topology_ensure_cpuinfo_available() {
@@ -95,6 +99,25 @@ static void iree_task_topology_set_affinity_from_processor(
 #endif  // cpuinfo-like platform field
 }
 
+// Returns the NUMA node the given |processor| is attached to or 0 if unknown.
+// cpuinfo does not expose NUMA information so we query the OS directly.
+static uint32_t iree_task_topology_query_numa_node(
+    const struct cpuinfo_processor* processor) {
+#if defined(IREE_PLATFORM_LINUX)
+  // Each CPU in sysfs has a nodeN link to the node it belongs to. Nodes are
+  // densely numbered on all systems we care about so probing is cheap.
+  char path[64];
+  for (uint32_t node = 0; node < IREE_TASK_EXECUTOR_MAX_NUMA_NODE_COUNT;
+       ++node) {
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/node%u",
+             processor->linux_id, node);
+    if (access(path, F_OK) == 0) return node;
+  }
+#endif  // IREE_PLATFORM_LINUX
+  // TODO(benvanik): GetNumaProcessorNodeEx on Windows.
+  return 0;
+}
+
 // Returns a bitset with all *processors* that share the same |cache|.
 static uint64_t iree_task_topology_calculate_cache_bits(
     const struct cpuinfo_cache* cache) {
@@ -118,12 +141,55 @@ static uint64_t iree_task_topology_calculate_constructive_sharing_mask(
   mask |= iree_task_topology_calculate_cache_bits(processor->cache.l1i);
   mask |= iree_task_topology_calculate_cache_bits(processor->cache.l1d);
   mask |= iree_task_topology_calculate_cache_bits(processor->cache.l2);
-  // TODO(benvanik): include L3 here too (for systems that have it)? Or use L3
-  // info purely for distribution and focus the group mask on lower-latency
-  // caches?
+  // NOTE: L3 is handled separately by the LLC sharing mask so that we can
+  // focus this mask on the lower-latency caches.
+  return mask;
+}
+
+// Constructs a sharing mask for all *processors* that share the last-level
+// cache or the core cluster with the specified |processor|. On big.LITTLE
+// systems the cluster maps to the set of cores of the same microarchitecture
+// while on chiplet x86 parts the L3 maps to the CCX/CCD.
+static uint64_t iree_task_topology_calculate_llc_sharing_mask(
+    const struct cpuinfo_processor* processor) {
+  uint64_t mask = 0;
+  mask |= iree_task_topology_calculate_cache_bits(processor->cache.l3);
+  const struct cpuinfo_cluster* cluster = processor->cluster;
+  if (cluster) {
+    for (uint32_t processor_i = 0; processor_i < cluster->processor_count;
+         ++processor_i) {
+      uint32_t i = cluster->processor_start + processor_i;
+      if (i < IREE_TASK_TOPOLOGY_GROUP_BIT_COUNT) {
+        mask |= 1ull << i;
+      }
+    }
+  }
   return mask;
 }
 
+// Returns the highest maximum frequency of any core in the machine or 0 if
+// frequency information is not available.
+static uint64_t iree_task_topology_query_max_core_frequency() {
+  uint64_t max_frequency = 0;
+  for (uint32_t i = 0; i < cpuinfo_get_cores_count(); i++) {
+    max_frequency = iree_max(max_frequency, cpuinfo_get_core(i)->frequency);
+  }
+  return max_frequency;
+}
+
+// Returns the performance of |core| relative to the fastest core in the machine
+// as a percentage in [1, 100]. Maximum frequency is used as a proxy: it doesn't
+// capture IPC differences between microarchitectures but does order clusters
+// correctly on every big.LITTLE/hybrid part we've seen. Returns 100 if
+// frequency information is not available.
+static uint32_t iree_task_topology_query_relative_performance(
+    const struct cpuinfo_core* core) {
+  uint64_t max_frequency = iree_task_topology_query_max_core_frequency();
+  if (!max_frequency || !core->frequency) return 100;
+  uint64_t relative_performance = (core->frequency * 100) / max_frequency;
+  return (uint32_t)iree_max(1, iree_min(relative_performance, 100));
+}
+
 // Populates |our_group| with the information from |core|.
 static void iree_task_topology_group_initialize_from_core(
     uint32_t group_index, const struct cpuinfo_core* core,
@@ -140,6 +206,9 @@ static void iree_task_topology_group_initialize_from_core(
       cpuinfo_get_processor(processor_i);
   iree_task_topology_set_affinity_from_processor(
       processor, &out_group->ideal_thread_affinity);
+  out_group->numa_node = iree_task_topology_query_numa_node(processor);
+  out_group->relative_performance =
+      iree_task_topology_query_relative_performance(core);
 }
 
 // Fixes constructive_sharing_mask values such that they represent other chosen
@@ -153,22 +222,30 @@ static void iree_task_topology_fixup_constructive_sharing_masks(
     iree_task_topology_group_t* group = &topology->groups[i];
 
     // Compute the processors that we can constructively share with.
+    const struct cpuinfo_processor* processor =
+        cpuinfo_get_processor(group->processor_index);
     uint64_t constructive_sharing_mask =
-        iree_task_topology_calculate_constructive_sharing_mask(
-            cpuinfo_get_processor(group->processor_index));
+        iree_task_topology_calculate_constructive_sharing_mask(processor);
+    uint64_t llc_sharing_mask =
+        iree_task_topology_calculate_llc_sharing_mask(processor);
 
     iree_task_topology_group_mask_t group_mask = 0;
+    iree_task_topology_group_mask_t llc_group_mask = 0;
     for (iree_host_size_t j = 0; j < topology->group_count; ++j) {
       if (i == j) continue;
       const iree_task_topology_group_t* other_group = &topology->groups[j];
       uint64_t group_processor_bits =
           iree_math_rotl_u64(1ull, other_group->processor_index);
+      uint64_t group_bits = iree_math_rotl_u64(1ull, other_group->group_index);
       if (constructive_sharing_mask & group_processor_bits) {
-        group_mask |= iree_math_rotl_u64(1ull, other_group->group_index);
+        group_mask |= group_bits;
+      } else if (llc_sharing_mask & group_processor_bits) {
+        llc_group_mask |= group_bits;
       }
     }
 
     group->constructive_sharing_mask = group_mask;
+    group->llc_sharing_mask = llc_group_mask;
   }
 }
 
@@ -213,6 +290,71 @@ void iree_task_topology_initialize_from_physical_cores_with_uarch(
       out_topology);
 }
 
+// Matches only cores with a maximum frequency above the value pointed to by
+// |user_data|.
+static bool iree_task_topology_core_filter_min_frequency(
+    const struct cpuinfo_core* core, uintptr_t user_data) {
+  return core->frequency > *(const uint64_t*)user_data;
+}
+
+void iree_task_topology_initialize_from_performance_cores(
+    iree_host_size_t max_core_count, iree_task_topology_t* out_topology) {
+  if (!iree_task_topology_is_cpuinfo_available()) {
+    iree_task_topology_initialize_from_physical_cores(max_core_count,
+                                                      out_topology);
+    return;
+  }
+
+  // Cores of the slowest class are excluded if there is more than one class.
+  // Frequencies are 0 when unknown in which case all cores are used.
+  uint64_t min_frequency = UINT64_MAX;
+  uint64_t max_frequency = 0;
+  for (uint32_t i = 0; i < cpuinfo_get_cores_count(); i++) {
+    const struct cpuinfo_core* core = cpuinfo_get_core(i);
+    min_frequency = iree_min(min_frequency, core->frequency);
+    max_frequency = iree_max(max_frequency, core->frequency);
+  }
+  if (min_frequency == max_frequency) {
+    iree_task_topology_initialize_from_physical_cores(max_core_count,
+                                                      out_topology);
+    return;
+  }
+  iree_task_topology_initialize_from_physical_cores_with_filter(
+      iree_task_topology_core_filter_min_frequency, (uintptr_t)&min_frequency,
+      max_core_count, out_topology);
+}
+
+// Returns the OS-visible ID of |processor| where available.
+static uint32_t iree_task_topology_processor_os_id(
+    const struct cpuinfo_processor* processor) {
+#if defined(__linux__)
+  return processor->linux_id;
+#else
+  return (uint32_t)(processor - cpuinfo_get_processor(0));
+#endif  // __linux__
+}
+
+// Matches only cores with a processor set in the uint64_t mask pointed to by
+// |user_data|.
+static bool iree_task_topology_core_filter_processor_mask(
+    const struct cpuinfo_core* core, uintptr_t user_data) {
+  uint64_t processor_mask = *(const uint64_t*)user_data;
+  for (uint32_t i = 0; i < core->processor_count; ++i) {
+    uint32_t id = iree_task_topology_processor_os_id(
+        cpuinfo_get_processor(core->processor_start + i));
+    if (id < 64 && (processor_mask & (1ull << id))) return true;
+  }
+  return false;
+}
+
+void iree_task_topology_initialize_from_processor_mask(
+    uint64_t processor_mask, iree_host_size_t max_core_count,
+    iree_task_topology_t* out_topology) {
+  iree_task_topology_initialize_from_physical_cores_with_filter(
+      iree_task_topology_core_filter_processor_mask, (uintptr_t)&processor_mask,
+      max_core_count, out_topology);
+}
+
 void iree_task_topology_initialize_from_physical_cores_with_filter(
     iree_task_topology_core_filter_t filter_fn, uintptr_t filter_fn_data,
     iree_host_size_t max_core_count, iree_task_topology_t* out_topology) {
@@ -298,3 +440,19 @@ void iree_task_topology_initialize_from_unique_l2_cache_groups(
   iree_task_topology_fixup_constructive_sharing_masks(out_topology);
   IREE_TRACE_ZONE_END(z0);
 }
+
+void iree_task_topology_format_host_key(iree_host_size_t buffer_capacity,
+                                        char* buffer) {
+  if (!buffer_capacity) return;
+  const char* processor_name = "unknown";
+  uint32_t processor_count = 0;
+  if (iree_task_topology_is_cpuinfo_available()) {
+    const struct cpuinfo_package* package = cpuinfo_get_package(0);
+    if (package && package->name[0]) processor_name = package->name;
+    processor_count = cpuinfo_get_processors_count();
+  }
+  snprintf(buffer, buffer_capacity, "%s/%u", processor_name, processor_count);
+  for (char* c = buffer; *c; ++c) {
+    if (*c == ' ' || *c == '\t') *c = '_';
+  }
+}
@@ -20,6 +20,8 @@ extern "C" {
 struct cpuinfo_core;
 
 // Initializes a topology with one group for each physical core in the machine.
+// On heterogeneous systems each group is tagged with the relative performance
+// of its core so that the executor can weight the work given to slower cores.
 //
 // If detailed cache information is not available this is a decent
 // approximation that can be used as a fallback.
@@ -48,6 +50,29 @@ void iree_task_topology_initialize_from_physical_cores_with_filter(
     iree_task_topology_core_filter_t filter_fn, uintptr_t filter_fn_data,
     iree_host_size_t max_core_count, iree_task_topology_t* out_topology);
 
+// Initializes a topology with one group for each performance core in the
+// machine. On heterogeneous systems (ARM big.LITTLE/DynamIQ and the like) the
+// cores with the lowest maximum frequency are excluded so that workers are only
+// placed on the faster clusters. On homogeneous systems, or if frequency
+// information is not available, all cores are used.
+//
+// If cpuinfo is not available this falls back to the same behavior as
+// iree_task_topology_initialize_from_physical_cores.
+void iree_task_topology_initialize_from_performance_cores(
+    iree_host_size_t max_core_count, iree_task_topology_t* out_topology);
+
+// Initializes a topology with one group for each physical core that has at
+// least one of its logical processors set in |processor_mask|. Bit N selects
+// the processor the OS identifies as N (as in `taskset`) where available and
+// otherwise the Nth processor as enumerated by cpuinfo.
+//
+// The topology may have no groups if no cores match the mask.
+// If cpuinfo is not available this falls back to the same behavior as
+// iree_task_topology_initialize_from_physical_cores.
+void iree_task_topology_initialize_from_processor_mask(
+    uint64_t processor_mask, iree_host_size_t max_core_count,
+    iree_task_topology_t* out_topology);
+
 // Initializes a topology with one group for each unique L2 cache group across
 // all available cores. This optimizes for temporal and spatial cache locality
 // but may suffer from oversubscription if there are other processes trying to
@@ -58,11 +83,17 @@ void iree_task_topology_initialize_from_physical_cores_with_filter(
 void iree_task_topology_initialize_from_unique_l2_cache_groups(
     iree_host_size_t max_group_count, iree_task_topology_t* out_topology);
 
+// Writes a NUL-terminated key identifying the host processor model and its
+// logical processor count to |buffer|, truncating to |buffer_capacity|. Used to
+// key tuning data that is only valid on the host it was measured on. The key
+// contains no whitespace.
+void iree_task_topology_format_host_key(iree_host_size_t buffer_capacity,
+                                        char* buffer);
+
 // TODO(#4654): more helpers and better defaults for the platforms we support.
 // Users can always make their own but just using these is the common path.
 // Ideas:
 // - _from_unique_l2_cache_groups but with a min/max count (N% utilization)
-// - cluster filtering (big/little cores on ARM)
 
 #ifdef __cplusplus
 }  // extern "C"
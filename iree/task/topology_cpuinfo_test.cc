@@ -41,4 +41,35 @@ TEST(TopologyTest, FromPhysicalCores) {
   iree_task_topology_deinitialize(&topology);
 }
 
+TEST(TopologyTest, FromPerformanceCores) {
+  static constexpr iree_host_size_t kMaxGroupCount = 4;
+  iree_task_topology_t topology;
+  iree_task_topology_initialize(&topology);
+  iree_task_topology_initialize_from_performance_cores(kMaxGroupCount,
+                                                       &topology);
+  EnsureTopologyValid(kMaxGroupCount, &topology);
+  iree_task_topology_deinitialize(&topology);
+}
+
+TEST(TopologyTest, FromProcessorMaskAll) {
+  static constexpr iree_host_size_t kMaxGroupCount = 4;
+  iree_task_topology_t topology;
+  iree_task_topology_initialize(&topology);
+  iree_task_topology_initialize_from_processor_mask(UINT64_MAX, kMaxGroupCount,
+                                                    &topology);
+  EnsureTopologyValid(kMaxGroupCount, &topology);
+  iree_task_topology_deinitialize(&topology);
+}
+
+TEST(TopologyTest, FromProcessorMaskLimitsGroups) {
+  // Only processor 0 is selected so at most one core can match.
+  static constexpr iree_host_size_t kMaxGroupCount = 4;
+  iree_task_topology_t topology;
+  iree_task_topology_initialize(&topology);
+  iree_task_topology_initialize_from_processor_mask(1ull, kMaxGroupCount,
+                                                    &topology);
+  EXPECT_LE(iree_task_topology_group_count(&topology), 1);
+  iree_task_topology_deinitialize(&topology);
+}
+
 }  // namespace
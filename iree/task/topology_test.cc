@@ -112,9 +112,32 @@ TEST(TopologyTest, FromGroupCount) {
     const iree_task_topology_group_t* group =
         iree_task_topology_get_group(&topology, i);
     EXPECT_EQ(i, group->group_index);
+    EXPECT_EQ(100, group->relative_performance);
   }
 
   iree_task_topology_deinitialize(&topology);
 }
 
+TEST(TopologyTest, NumaNodeCount) {
+  iree_task_topology_t topology;
+  iree_task_topology_initialize(&topology);
+
+  // Empty topologies and topologies without NUMA info have a single node.
+  EXPECT_EQ(1, iree_task_topology_numa_node_count(&topology));
+  iree_task_topology_initialize_from_group_count(4, &topology);
+  EXPECT_EQ(1, iree_task_topology_numa_node_count(&topology));
+  for (iree_host_size_t i = 0; i < 4; ++i) {
+    EXPECT_EQ(0, iree_task_topology_get_group(&topology, i)->numa_node);
+  }
+
+  // Node count is derived from the highest node referenced.
+  iree_task_topology_group_t group;
+  iree_task_topology_group_initialize(4, &group);
+  group.numa_node = 1;
+  IREE_EXPECT_OK(iree_task_topology_push_group(&topology, &group));
+  EXPECT_EQ(2, iree_task_topology_numa_node_count(&topology));
+
+  iree_task_topology_deinitialize(&topology);
+}
+
 }  // namespace
@@ -7,6 +7,8 @@
 #ifndef IREE_TASK_TUNING_H_
 #define IREE_TASK_TUNING_H_
 
+#include "iree/base/target_platform.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif  // __cplusplus
@@ -17,6 +19,20 @@ extern "C" {
 // only <64 will ever be used (such as for devices with 2 cores).
 #define IREE_TASK_EXECUTOR_MAX_WORKER_COUNT (64)
 
+// Maximum number of NUMA nodes that an executor will partition its workers and
+// transient task pools across. Topology groups with node IDs beyond this will
+// be folded into the existing nodes (which is correct but may cause cross-node
+// traffic on very large machines).
+#define IREE_TASK_EXECUTOR_MAX_NUMA_NODE_COUNT (8)
+
+// Size of the transparent large pages requested for worker local memory on
+// platforms supporting them (PMD-mapped huge pages on Linux). The portion of
+// each worker's local memory spanning aligned large pages is advised to be
+// backed by them to reduce TLB misses in dispatches making heavy use of local
+// memory. Only takes effect when a worker's local memory exceeds this size.
+// Set to zero to disable.
+#define IREE_TASK_EXECUTOR_LOCAL_MEMORY_LARGE_PAGE_SIZE (2 * 1024 * 1024)
+
 // Initial number of slice tasks that are allocated in the executor pool.
 // Increasing this number will decrease initial allocation storms in cases of
 // extremely wide fan-out (many dispatches with many thousands of slices) at the
@@ -44,13 +60,21 @@ extern "C" {
 // progress and indicates a possible error in task assignment.
 //
 // Also, the underlying iree_wait_set_t may not support more than 64 handles on
-// certain platforms without emulation. Trying to keep us on the fast-path
-// with a reasonable number seems fine for now until we have a need for more.
+// certain platforms without emulation (WFMO on Windows). Where the wait set is
+// backed by epoll (Linux/Android) handles stay registered with the kernel and
+// a wake only costs as much as the number of ready handles so we allow many
+// more to support servers with large numbers of concurrent external waits.
 //
 // NOTE: we reserve 1 wait handle for our own internal use. This allows us to
 // wake the coordination worker when new work is submitted from external
 // sources.
+#if !defined(IREE_TASK_EXECUTOR_MAX_OUTSTANDING_WAITS)
+#if defined(IREE_PLATFORM_LINUX) || defined(IREE_PLATFORM_ANDROID)
+#define IREE_TASK_EXECUTOR_MAX_OUTSTANDING_WAITS (4096 - 1)
+#else
 #define IREE_TASK_EXECUTOR_MAX_OUTSTANDING_WAITS (64 - 1)
+#endif  // IREE_PLATFORM_LINUX || IREE_PLATFORM_ANDROID
+#endif  // !IREE_TASK_EXECUTOR_MAX_OUTSTANDING_WAITS
 
 // Allows for dividing the total number of attempts that a worker will make to
 // steal tasks from other workers. By default all other workers will be
@@ -78,6 +102,40 @@ extern "C" {
 #define IREE_TASK_EXECUTOR_MAX_THEFT_TASK_COUNT \
   IREE_TASK_EXECUTOR_MAX_WORKER_COUNT
 
+// Maximum number of consecutive coordination passes that ready tasks of a
+// given priority may be deferred while higher priority tasks are being
+// scheduled. Once reached the deferred tasks are scheduled along with the
+// higher priority tasks to guarantee forward progress.
+#define IREE_TASK_EXECUTOR_MAX_PRIORITY_DEFERRAL_COUNT (4)
+
+// Maximum number of distinct scopes whose ready tasks are ordered by virtual
+// time in each coordination pass. Tasks from additional scopes are scheduled
+// after those of the ordered scopes in arrival order.
+#define IREE_TASK_EXECUTOR_MAX_FAIR_SCOPE_COUNT (64)
+
+// Maximum weighted virtual time, in nanoseconds, that a scope may lag behind
+// the executor when its tasks are scheduled. Scopes that were idle have their
+// virtual time advanced to within this bound so that they don't accumulate
+// credit to monopolize the workers with when they become active again.
+#define IREE_TASK_EXECUTOR_MAX_FAIRNESS_LAG_NS (20 * 1000000)
+
+// Weighted virtual time, in nanoseconds, that the scope of a dispatch shard
+// may run ahead of the scope of work posted to the same worker before the
+// shard yields at its next tile reservation boundary. Smaller values
+// interleave the dispatches of concurrent scopes more finely at the cost of
+// more frequent rescheduling. Set to INT64_MAX to disable interleaving.
+#define IREE_TASK_SCOPE_FAIRNESS_QUANTUM_NS (2 * 1000000)
+
+// Maximum number of processor pause instructions issued between each check
+// for new work when a worker is spinning prior to parking. The count starts at
+// 1 and doubles each check until this limit after which the worker yields its
+// thread time slice between checks instead.
+//
+// Pausing keeps the worker responsive to new work on the order of nanoseconds
+// while yielding lets other threads on the same core make progress (which may
+// be the very thread producing the work we are waiting for).
+#define IREE_TASK_WORKER_MAX_SPIN_PAUSE_COUNT (64)
+
 // Number of tiles that will be batched into a single slice along each XYZ dim.
 //
 // Larger numbers reduce overhead and ensure that more tiles are executed
@@ -110,6 +168,26 @@ extern "C" {
 // memory).
 #define IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION (8)
 
+// Approximate cost, in the units of iree_task_dispatch_t::tile_cost_hint, that
+// each shard reservation from the grid should amount to when the dispatch has
+// a cost hint specified. Cheap tiles will be reserved in larger batches (up to
+// IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION) while expensive tiles
+// will be reserved one at a time. Also bounds the size of slices in sliced
+// dispatches.
+#define IREE_TASK_DISPATCH_TARGET_RESERVATION_COST (64 * 1024)
+
+// Minimum total cost, in the units of iree_task_dispatch_t::tile_cost_hint,
+// that each shard of a dispatch should be assigned. Dispatches with little
+// total work will be issued to fewer shards than there are workers so that we
+// avoid waking workers that would just find there was nothing left to do.
+#define IREE_TASK_DISPATCH_MIN_SHARD_COST (32 * 1024)
+
+// Divisor used in guided self-scheduling mode (IREE_TASK_FLAG_DISPATCH_GUIDED)
+// when sizing each reservation: a shard will reserve at most
+// remaining_tiles / (divisor * shard_count) tiles at a time. Larger values
+// start with smaller reservations and shrink them faster toward the tail.
+#define IREE_TASK_DISPATCH_GUIDED_SCHEDULING_DIVISOR (2)
+
 // Whether to enable per-tile colors for each tile tracing zone based on the
 // tile grid xyz. Not cheap and can be disabled to reduce tracing overhead.
 // TODO(#4017): make per-tile color tracing fast enough to always have on.
@@ -10,6 +10,7 @@
 #include <string.h>
 
 #include "iree/base/internal/math.h"
+#include "iree/base/target_platform.h"
 #include "iree/base/tracing.h"
 #include "iree/task/executor_impl.h"
 #include "iree/task/post_batch.h"
@@ -22,20 +23,36 @@ static int iree_task_worker_main(iree_task_worker_t* worker);
 iree_status_t iree_task_worker_initialize(
     iree_task_executor_t* executor, iree_host_size_t worker_index,
     const iree_task_topology_group_t* topology_group,
-    iree_byte_span_t local_memory, iree_prng_splitmix64_state_t* seed_prng,
-    iree_task_worker_t* out_worker) {
+    iree_prng_splitmix64_state_t* seed_prng, iree_task_worker_t* out_worker) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
   out_worker->executor = executor;
   out_worker->worker_bit = iree_task_affinity_for_worker(worker_index);
   out_worker->ideal_thread_affinity = topology_group->ideal_thread_affinity;
-  out_worker->constructive_sharing_mask =
-      topology_group->constructive_sharing_mask;
+  out_worker->numa_node = topology_group->numa_node % executor->numa_node_count;
+  out_worker->relative_performance =
+      iree_max(1, iree_min(topology_group->relative_performance, 100));
+
+  // Partition all other workers into disjoint victim sets by locality.
+  iree_task_affinity_set_t remaining_mask = ~out_worker->worker_bit;
+  out_worker->victim_masks[IREE_TASK_STEAL_LOCALITY_CONSTRUCTIVE] =
+      topology_group->constructive_sharing_mask & remaining_mask;
+  remaining_mask &= ~topology_group->constructive_sharing_mask;
+  out_worker->victim_masks[IREE_TASK_STEAL_LOCALITY_LLC] =
+      topology_group->llc_sharing_mask & remaining_mask;
+  remaining_mask &= ~topology_group->llc_sharing_mask;
+  out_worker->victim_masks[IREE_TASK_STEAL_LOCALITY_NUMA_NODE] =
+      executor->numa_node_worker_masks[out_worker->numa_node] & remaining_mask;
+  remaining_mask &= ~executor->numa_node_worker_masks[out_worker->numa_node];
+  out_worker->victim_masks[IREE_TASK_STEAL_LOCALITY_REMOTE] = remaining_mask;
+  out_worker->dispatch_task_pool =
+      &executor->dispatch_task_pools[out_worker->numa_node];
   out_worker->max_theft_attempts =
       executor->worker_count / IREE_TASK_EXECUTOR_MAX_THEFT_ATTEMPTS_DIVISOR;
+  out_worker->spin_ns = executor->worker_spin_ns;
   iree_prng_minilcg128_initialize(iree_prng_splitmix64_next(seed_prng),
                                   &out_worker->theft_prng);
-  out_worker->local_memory = local_memory;
+  memset(&out_worker->local_memory, 0, sizeof(out_worker->local_memory));
 
   iree_task_worker_state_t initial_state = IREE_TASK_WORKER_STATE_RUNNING;
   if (executor->scheduling_mode &
@@ -52,6 +69,7 @@ iree_status_t iree_task_worker_initialize(
   iree_notification_initialize(&out_worker->wake_notification);
   iree_notification_initialize(&out_worker->state_notification);
   iree_atomic_task_slist_initialize(&out_worker->mailbox_slist);
+  iree_task_preemption_reset(&out_worker->mailbox_preemption);
   iree_task_queue_initialize(&out_worker->local_task_queue);
 
   iree_thread_create_params_t thread_params;
@@ -103,10 +121,40 @@ void iree_task_worker_deinitialize(iree_task_worker_t* worker) {
   iree_notification_deinitialize(&worker->state_notification);
   iree_atomic_task_slist_deinitialize(&worker->mailbox_slist);
   iree_task_queue_deinitialize(&worker->local_task_queue);
+  iree_task_executor_release_local_memory(worker->executor,
+                                          &worker->local_memory);
 
   IREE_TRACE_ZONE_END(z0);
 }
 
+void iree_task_worker_query_statistics(
+    iree_task_worker_t* worker, iree_task_worker_statistics_t* out_statistics) {
+  for (iree_host_size_t i = 0; i < IREE_TASK_STEAL_LOCALITY_COUNT; ++i) {
+    out_statistics->steal_count[i] = (uint64_t)iree_atomic_load_int64(
+        &worker->steal_counts[i], iree_memory_order_relaxed);
+  }
+  out_statistics->spin_wake_count = (uint64_t)iree_atomic_load_int64(
+      &worker->spin_wake_count, iree_memory_order_relaxed);
+  out_statistics->park_count = (uint64_t)iree_atomic_load_int64(
+      &worker->park_count, iree_memory_order_relaxed);
+  out_statistics->park_wake_latency_total_ns = (uint64_t)iree_atomic_load_int64(
+      &worker->park_wake_latency_total_ns, iree_memory_order_relaxed);
+  out_statistics->park_wake_latency_max_ns = (uint64_t)iree_atomic_load_int64(
+      &worker->park_wake_latency_max_ns, iree_memory_order_relaxed);
+  out_statistics->task_count = (uint64_t)iree_atomic_load_int64(
+      &worker->task_count, iree_memory_order_relaxed);
+  out_statistics->tile_count = (uint64_t)iree_atomic_load_int64(
+      &worker->tile_count, iree_memory_order_relaxed);
+  out_statistics->failed_steal_count = (uint64_t)iree_atomic_load_int64(
+      &worker->failed_steal_count, iree_memory_order_relaxed);
+  out_statistics->busy_ns = (uint64_t)iree_atomic_load_int64(
+      &worker->busy_ns, iree_memory_order_relaxed);
+  out_statistics->idle_ns = (uint64_t)iree_atomic_load_int64(
+      &worker->idle_ns, iree_memory_order_relaxed);
+  out_statistics->steal_ns = (uint64_t)iree_atomic_load_int64(
+      &worker->steal_ns, iree_memory_order_relaxed);
+}
+
 void iree_task_worker_request_exit(iree_task_worker_t* worker) {
   if (!worker->thread) return;
   IREE_TRACE_ZONE_BEGIN(z0);
@@ -146,6 +194,44 @@ void iree_task_worker_post_tasks(iree_task_worker_t* worker,
   memset(list, 0, sizeof(*list));
 }
 
+void iree_task_worker_mark_priorities_posted(iree_task_worker_t* worker,
+                                             uint32_t priority_mask) {
+  iree_atomic_fetch_or_int32(&worker->mailbox_preemption.priority_mask,
+                             (int32_t)priority_mask, iree_memory_order_release);
+}
+
+void iree_task_worker_mark_virtual_time_posted(iree_task_worker_t* worker,
+                                               iree_task_scope_t* scope,
+                                               int64_t virtual_time_ns) {
+  // The coordinator is the only poster so only the worker flushing the mailbox
+  // may race with this; at worst a shard yields once more or less than ideal.
+  iree_task_preemption_t* preemption = &worker->mailbox_preemption;
+  if (virtual_time_ns >= iree_atomic_load_int64(&preemption->virtual_time_ns,
+                                                iree_memory_order_relaxed)) {
+    return;
+  }
+  iree_atomic_store_intptr(&preemption->virtual_time_scope, (intptr_t)scope,
+                           iree_memory_order_relaxed);
+  iree_atomic_store_int64(&preemption->virtual_time_ns, virtual_time_ns,
+                          iree_memory_order_release);
+}
+
+bool iree_task_worker_has_posted_tasks(iree_task_worker_t* worker) {
+  // Every post marks the priorities of the posted tasks and the marks are only
+  // cleared when the worker flushes its mailbox.
+  return iree_atomic_load_int32(&worker->mailbox_preemption.priority_mask,
+                                iree_memory_order_acquire) != 0;
+}
+
+void iree_task_worker_mark_wake_posted(iree_task_worker_t* worker) {
+  // Only the first post is recorded; the worker will wake for it and observe
+  // any that follow.
+  int64_t expected = 0;
+  iree_atomic_compare_exchange_strong_int64(
+      &worker->wake_post_time_ns, &expected, (int64_t)iree_time_now(),
+      iree_memory_order_relaxed, iree_memory_order_relaxed);
+}
+
 iree_task_t* iree_task_worker_try_steal_task(iree_task_worker_t* worker,
                                              iree_task_queue_t* target_queue,
                                              iree_host_size_t max_tasks) {
@@ -158,17 +244,44 @@ iree_task_t* iree_task_worker_try_steal_task(iree_task_worker_t* worker,
 
   // If we still didn't steal any tasks then let's try the slist instead.
   task = iree_atomic_task_slist_pop(&worker->mailbox_slist);
-  if (task) return task;
+  if (task) {
+    task->flags |= IREE_TASK_FLAG_STOLEN;
+    return task;
+  }
 
   return NULL;
 }
 
-// Executes a task on a worker.
-// Only task types that are scheduled to workers are handled; all others must be
-// handled by the coordinator during scheduling.
-static iree_status_t iree_task_worker_execute(
-    iree_task_worker_t* worker, iree_task_t* task,
-    iree_task_submission_t* pending_submission) {
+iree_status_t iree_task_worker_execute(
+    iree_task_t* task, iree_byte_span_t local_memory,
+    iree_task_preemption_t* preemption, uint32_t relative_performance,
+    iree_fpu_state_t* fpu_state, uint32_t flight_recorder_track,
+    uint32_t* out_tile_count, iree_task_submission_t* pending_submission) {
+  // Switch the FPU state only if the task requires a different one than the
+  // task executed before it.
+  iree_fpu_state_update(
+      fpu_state, (task->flags & IREE_TASK_FLAG_FLUSH_DENORMALS_TO_ZERO)
+                     ? IREE_FPU_STATE_FLAG_FLUSH_DENORMALS_TO_ZERO
+                     : IREE_FPU_STATE_DEFAULT);
+
+  // Attribute the steal to the dispatch the slice/shard belongs to. The flag is
+  // cleared so that tasks resumed after preemption are not counted again.
+  if (task->flags & IREE_TASK_FLAG_STOLEN) {
+    task->flags &= ~IREE_TASK_FLAG_STOLEN;
+    iree_task_dispatch_statistics_t* dispatch_statistics = NULL;
+    if (task->type == IREE_TASK_TYPE_DISPATCH_SLICE) {
+      dispatch_statistics =
+          ((iree_task_dispatch_slice_t*)task)->dispatch_statistics;
+    } else if (task->type == IREE_TASK_TYPE_DISPATCH_SHARD) {
+      dispatch_statistics =
+          &((iree_task_dispatch_shard_t*)task)->dispatch_task->statistics;
+    }
+    if (dispatch_statistics) {
+      iree_atomic_fetch_add_int64(&dispatch_statistics->stolen_shard_count, 1,
+                                  iree_memory_order_relaxed);
+    }
+  }
+
   // Execute the task and resolve the task and gather any tasks that are now
   // ready for submission to the executor. They'll be scheduled the next time
   // the coordinator runs.
@@ -177,22 +290,29 @@ static iree_status_t iree_task_worker_execute(
   // BFS behavior at the cost of the additional merge overhead - it's probably
   // worth it?
   // TODO(benvanik): handle partial tasks and re-queuing.
+  iree_status_t status = iree_ok_status();
   switch (task->type) {
     case IREE_TASK_TYPE_CALL: {
-      IREE_RETURN_IF_ERROR(
-          iree_task_call_execute((iree_task_call_t*)task, pending_submission));
+      IREE_FLIGHT_RECORD_BEGIN(flight_recorder_track, "call", 0);
+      status =
+          iree_task_call_execute((iree_task_call_t*)task, pending_submission);
+      IREE_FLIGHT_RECORD_END(flight_recorder_track, "call");
       break;
     }
     case IREE_TASK_TYPE_DISPATCH_SLICE: {
-      IREE_RETURN_IF_ERROR(iree_task_dispatch_slice_execute(
-          (iree_task_dispatch_slice_t*)task, worker->local_memory,
-          pending_submission));
+      IREE_FLIGHT_RECORD_BEGIN(flight_recorder_track, "dispatch_slice", 0);
+      status = iree_task_dispatch_slice_execute(
+          (iree_task_dispatch_slice_t*)task, local_memory, out_tile_count,
+          pending_submission);
+      IREE_FLIGHT_RECORD_END(flight_recorder_track, "dispatch_slice");
       break;
     }
     case IREE_TASK_TYPE_DISPATCH_SHARD: {
-      IREE_RETURN_IF_ERROR(iree_task_dispatch_shard_execute(
-          (iree_task_dispatch_shard_t*)task, worker->local_memory,
-          pending_submission));
+      IREE_FLIGHT_RECORD_BEGIN(flight_recorder_track, "dispatch_shard", 0);
+      status = iree_task_dispatch_shard_execute(
+          (iree_task_dispatch_shard_t*)task, local_memory, preemption,
+          relative_performance, out_tile_count, pending_submission);
+      IREE_FLIGHT_RECORD_END(flight_recorder_track, "dispatch_shard");
       break;
     }
     default:
@@ -203,7 +323,7 @@ static iree_status_t iree_task_worker_execute(
   // NOTE: task is invalidated here!
   task = NULL;
 
-  return iree_ok_status();
+  return status;
 }
 
 // Pumps the worker thread once, processing a single task.
@@ -228,6 +348,13 @@ static bool iree_task_worker_pump_once(
     // first place (large uneven workloads for various workers, bad distribution
     // in the face of heterogenous multi-core architectures where some workers
     // complete tasks faster than others, etc).
+    //
+    // The priorities and virtual times posted are cleared prior to the flush
+    // so that we never miss them for tasks that arrive after it.
+    iree_atomic_store_int64(&worker->mailbox_preemption.virtual_time_ns,
+                            INT64_MAX, iree_memory_order_relaxed);
+    iree_atomic_exchange_int32(&worker->mailbox_preemption.priority_mask, 0,
+                               iree_memory_order_acquire);
     task = iree_task_queue_flush_from_lifo_slist(&worker->local_task_queue,
                                                  &worker->mailbox_slist);
   }
@@ -237,10 +364,23 @@ static bool iree_task_worker_pump_once(
   // with. Their tasks will be moved from their local queue into ours and the
   // the first task in the queue is popped off and returned.
   if (!task) {
+    iree_time_t steal_start_ns = iree_time_now();
+    iree_task_steal_locality_t locality = IREE_TASK_STEAL_LOCALITY_REMOTE;
     task = iree_task_executor_try_steal_task(
-        worker->executor, worker->constructive_sharing_mask,
-        worker->max_theft_attempts, &worker->theft_prng,
-        &worker->local_task_queue);
+        worker->executor, worker->victim_masks, worker->max_theft_attempts,
+        &worker->theft_prng, &worker->local_task_queue, &locality);
+    iree_atomic_fetch_add_int64(&worker->steal_ns,
+                                iree_time_now() - steal_start_ns,
+                                iree_memory_order_relaxed);
+    if (task) {
+      iree_atomic_fetch_add_int64(&worker->steal_counts[locality], 1,
+                                  iree_memory_order_relaxed);
+      IREE_FLIGHT_RECORD_INSTANT(iree_task_worker_flight_recorder_track(worker),
+                                 "steal", locality);
+    } else {
+      iree_atomic_fetch_add_int64(&worker->failed_steal_count, 1,
+                                  iree_memory_order_relaxed);
+    }
   }
 
   // No tasks to run; let the caller know we want to wait for more.
@@ -249,10 +389,28 @@ static bool iree_task_worker_pump_once(
     return false;
   }
 
+  // Grow our local memory if a larger reservation was made since the last
+  // task. This happens on our own thread prior to the task that needs it.
+  iree_task_executor_ensure_local_memory(worker->executor,
+                                         &worker->local_memory);
+
   // Execute the task (may call out to arbitrary user code and may submit more
   // tasks for execution).
+  iree_time_t execute_start_ns = iree_time_now();
+  uint32_t tile_count = 0;
   iree_status_t status =
-      iree_task_worker_execute(worker, task, pending_submission);
+      iree_task_worker_execute(task, worker->local_memory.span,
+                               &worker->mailbox_preemption,
+                               worker->relative_performance, &worker->fpu_state,
+                               iree_task_worker_flight_recorder_track(worker),
+                               &tile_count, pending_submission);
+  iree_atomic_fetch_add_int64(&worker->busy_ns,
+                              iree_time_now() - execute_start_ns,
+                              iree_memory_order_relaxed);
+  iree_atomic_fetch_add_int64(&worker->task_count, 1,
+                              iree_memory_order_relaxed);
+  iree_atomic_fetch_add_int64(&worker->tile_count, tile_count,
+                              iree_memory_order_relaxed);
 
   // TODO(#4026): propagate failure to task scope.
   // We currently drop the error on the floor here; that's because the error
@@ -265,10 +423,94 @@ static bool iree_task_worker_pump_once(
   IREE_ASSERT_TRUE(iree_status_is_ok(status));
   iree_status_ignore(status);
 
+  // If higher priority work or work from another scope is waiting in the
+  // mailbox then any shard we were running may have been preempted into the
+  // pending submission. Merge it now so that the coordinator can reschedule it
+  // (possibly on another worker) instead of it waiting for us to run out of
+  // work.
+  iree_task_preemption_t* preemption = &worker->mailbox_preemption;
+  if ((iree_atomic_load_int32(&preemption->priority_mask,
+                              iree_memory_order_relaxed) != 0 ||
+       iree_atomic_load_int64(&preemption->virtual_time_ns,
+                              iree_memory_order_relaxed) != INT64_MAX) &&
+      !iree_task_submission_is_empty(pending_submission)) {
+    iree_task_executor_merge_submission(worker->executor, worker,
+                                        pending_submission);
+  }
+
   IREE_TRACE_ZONE_END(z0);
   return true;  // try again
 }
 
+// Spins for up to the worker spin duration waiting for the wake notification
+// to be posted. Returns true if the notification was posted while spinning.
+static bool iree_task_worker_spin_for_wake(iree_task_worker_t* worker,
+                                           iree_wait_token_t wait_token) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_time_t spin_deadline_ns = iree_time_now() + worker->spin_ns;
+  uint32_t pause_count = 1;
+  bool posted = false;
+  do {
+    if (iree_notification_is_posted(&worker->wake_notification, wait_token)) {
+      posted = true;
+      break;
+    }
+    if (pause_count <= IREE_TASK_WORKER_MAX_SPIN_PAUSE_COUNT) {
+      // Exponential backoff keeps us off the notification cache line.
+      for (uint32_t i = 0; i < pause_count; ++i) {
+        iree_processor_pause();
+      }
+      pause_count <<= 1;
+    } else {
+      iree_thread_yield();
+    }
+  } while (iree_time_now() < spin_deadline_ns);
+  IREE_TRACE_ZONE_END(z0);
+  return posted;
+}
+
+// Waits for the worker wake notification to be posted, spinning first if the
+// executor was configured to. |wait_token| is consumed.
+static void iree_task_worker_await_wake(iree_task_worker_t* worker,
+                                        iree_wait_token_t wait_token) {
+  if (worker->spin_ns > 0 &&
+      iree_task_worker_spin_for_wake(worker, wait_token)) {
+    iree_notification_cancel_wait(&worker->wake_notification);
+    iree_atomic_store_int64(&worker->wake_post_time_ns, 0,
+                            iree_memory_order_relaxed);
+    iree_atomic_fetch_add_int64(&worker->spin_wake_count, 1,
+                                iree_memory_order_relaxed);
+    IREE_FLIGHT_RECORD_INSTANT(iree_task_worker_flight_recorder_track(worker),
+                               "spin_wake", 0);
+    return;
+  }
+
+  IREE_TRACE_ZONE_BEGIN_NAMED(z_wait, "iree_task_worker_main_pump_wake_wait");
+  IREE_FLIGHT_RECORD_BEGIN(iree_task_worker_flight_recorder_track(worker),
+                           "park", 0);
+  iree_notification_commit_wait(&worker->wake_notification, wait_token);
+  IREE_FLIGHT_RECORD_END(iree_task_worker_flight_recorder_track(worker),
+                         "park");
+  IREE_TRACE_ZONE_END(z_wait);
+
+  // Measure how long it took from the wake being posted until we got here.
+  // Only the worker writes the statistics so load/store is enough for the max.
+  iree_atomic_fetch_add_int64(&worker->park_count, 1,
+                              iree_memory_order_relaxed);
+  int64_t post_time_ns = iree_atomic_exchange_int64(
+      &worker->wake_post_time_ns, 0, iree_memory_order_relaxed);
+  if (post_time_ns > 0) {
+    int64_t latency_ns = iree_max(0, (int64_t)iree_time_now() - post_time_ns);
+    iree_atomic_fetch_add_int64(&worker->park_wake_latency_total_ns,
+                                latency_ns, iree_memory_order_relaxed);
+    if (latency_ns > iree_atomic_load_int64(&worker->park_wake_latency_max_ns,
+                                            iree_memory_order_relaxed)) {
+      iree_atomic_store_int64(&worker->park_wake_latency_max_ns, latency_ns,
+                              iree_memory_order_relaxed);
+    }
+  }
+}
+
 // Alternates between pumping ready tasks in the worker queue and waiting
 // for more tasks to arrive. Only returns when the worker has been asked by
 // the executor to exit.
@@ -282,6 +524,10 @@ static void iree_task_worker_pump_until_exit(iree_task_worker_t* worker) {
     // structures we use.
     iree_wait_token_t wait_token =
         iree_notification_prepare_wait(&worker->wake_notification);
+    // Any wakes posted prior to here will be serviced by the pump below and
+    // should not count against the latency of the next wait.
+    iree_atomic_store_int64(&worker->wake_post_time_ns, 0,
+                            iree_memory_order_relaxed);
     iree_atomic_task_affinity_set_fetch_and(&worker->executor->worker_idle_mask,
                                             ~worker->worker_bit,
                                             iree_memory_order_seq_cst);
@@ -304,7 +550,7 @@ static void iree_task_worker_pump_until_exit(iree_task_worker_t* worker) {
 
     bool schedule_dirty = false;
     if (!iree_task_submission_is_empty(&pending_submission)) {
-      iree_task_executor_merge_submission(worker->executor,
+      iree_task_executor_merge_submission(worker->executor, worker,
                                           &pending_submission);
       schedule_dirty = true;
     }
@@ -335,10 +581,11 @@ static void iree_task_worker_pump_until_exit(iree_task_worker_t* worker) {
       // Have more work to do; loop around to try another pump.
       iree_notification_cancel_wait(&worker->wake_notification);
     } else {
-      IREE_TRACE_ZONE_BEGIN_NAMED(z_wait,
-                                  "iree_task_worker_main_pump_wake_wait");
-      iree_notification_commit_wait(&worker->wake_notification, wait_token);
-      IREE_TRACE_ZONE_END(z_wait);
+      iree_time_t idle_start_ns = iree_time_now();
+      iree_task_worker_await_wake(worker, wait_token);
+      iree_atomic_fetch_add_int64(&worker->idle_ns,
+                                  iree_time_now() - idle_start_ns,
+                                  iree_memory_order_relaxed);
     }
 
     // Wait completed.
@@ -363,8 +610,13 @@ static int iree_task_worker_main(iree_task_worker_t* worker) {
                                  iree_memory_order_seq_cst) !=
       IREE_TASK_WORKER_STATE_EXITING;
   if (IREE_LIKELY(should_run)) {
+    // Tasks switch the FPU state as needed and it is restored upon exit.
+    worker->fpu_state = iree_fpu_state_push(IREE_FPU_STATE_DEFAULT);
+
     // << work happens here >>
     iree_task_worker_pump_until_exit(worker);
+
+    iree_fpu_state_pop(worker->fpu_state);
   }
 
   IREE_TRACE_ZONE_END(thread_zone);
@@ -11,6 +11,8 @@
 #include <stdint.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/flight_recorder.h"
+#include "iree/base/internal/fpu_state.h"
 #include "iree/base/internal/prng.h"
 #include "iree/base/internal/synchronization.h"
 #include "iree/base/internal/threading.h"
@@ -50,6 +52,15 @@ typedef enum iree_task_worker_state_e {
   IREE_TASK_WORKER_STATE_ZOMBIE = 3,
 } iree_task_worker_state_t;
 
+// Local memory owned by a worker (or a donated caller) and reused across all
+// of the dispatch tiles it executes.
+typedef struct iree_task_local_memory_t {
+  // Allocation backing |span|, which is aligned within it. NULL if empty.
+  void* allocation;
+  // Local memory made available to dispatch tiles.
+  iree_byte_span_t span;
+} iree_task_local_memory_t;
+
 // A worker within the executor pool.
 //
 // NOTE: fields in here are touched from multiple threads with lock-free
@@ -77,6 +88,11 @@ typedef struct iree_task_worker_t {
   //         notification.
   iree_notification_t wake_notification;
 
+  // Priorities and scope virtual times of tasks posted to the mailbox since the
+  // worker last flushed it. Polled by dispatch shards executing on the worker
+  // to yield to higher priority work or to scopes that are behind.
+  iree_task_preemption_t mailbox_preemption;
+
   // Notification signaled when the worker changes any state.
   iree_notification_t state_notification;
 
@@ -90,22 +106,63 @@ typedef struct iree_task_worker_t {
   // Ideal thread affinity for the worker thread.
   iree_thread_affinity_t ideal_thread_affinity;
 
-  // A bitmask of other group indices that share some level of the cache
-  // hierarchy. Workers of this group are more likely to constructively share
-  // some cache levels higher up with these other groups. For example, if the
-  // workers in a group all share an L2 cache then the groups indicated here may
-  // all share the same L3 cache.
-  iree_task_affinity_set_t constructive_sharing_mask;
+  // Disjoint bitmasks of other workers to try stealing from indexed by
+  // iree_task_steal_locality_t. Workers first steal from those that
+  // constructively share some level of the cache hierarchy (L1/L2), then those
+  // that share the last-level cache or core cluster, then those on the same
+  // NUMA node, and only then any other worker.
+  iree_task_affinity_set_t victim_masks[IREE_TASK_STEAL_LOCALITY_COUNT];
+
+  // NUMA node the worker is attached to.
+  uint32_t numa_node;
+
+  // Performance of the worker core relative to the fastest in the machine as a
+  // percentage in [1, 100] (see iree_task_topology_group_t). Dispatch shards
+  // executing on the worker scale their tile reservations by this.
+  uint32_t relative_performance;
 
-  // Maximum number of attempts to make when trying to steal tasks from other
-  // workers. This could be 64 (try stealing from all workers) or just a handful
-  // (try stealing from these 3 other cores that share your L3 cache).
+  // Pool used for transient tasks posted to this worker. Shared with all other
+  // workers on the same NUMA node and owned by the executor.
+  iree_task_pool_t* dispatch_task_pool;
+
+  // Maximum number of attempts to make in total across all victim_masks when
+  // trying to steal tasks from other workers, nearest victims first. This
+  // could be 64 (try stealing from all workers) or just a handful (try
+  // stealing from these 3 other cores that share your L3 cache).
   uint32_t max_theft_attempts;
 
   // Rotation counter for work stealing (ensures we don't favor one victim).
   // Only ever touched by the worker thread as it steals work.
   iree_prng_minilcg128_state_t theft_prng;
 
+  // Duration the worker will spin looking for new work prior to parking.
+  iree_duration_t spin_ns;
+
+  // Time the first wake was posted to the worker since it last prepared to
+  // wait or 0 if no wake has been posted. Set by posters and consumed by the
+  // worker to measure wake latency.
+  iree_atomic_int64_t wake_post_time_ns;
+
+  // Number of successful thefts indexed by iree_task_steal_locality_t.
+  // Only ever written by the worker thread but may be read from any thread.
+  iree_atomic_int64_t steal_counts[IREE_TASK_STEAL_LOCALITY_COUNT];
+
+  // Wake statistics; see iree_task_worker_statistics_t.
+  // Only ever written by the worker thread but may be read from any thread.
+  iree_atomic_int64_t spin_wake_count;
+  iree_atomic_int64_t park_count;
+  iree_atomic_int64_t park_wake_latency_total_ns;
+  iree_atomic_int64_t park_wake_latency_max_ns;
+
+  // Utilization statistics; see iree_task_worker_statistics_t.
+  // Only ever written by the worker thread but may be read from any thread.
+  iree_atomic_int64_t task_count;
+  iree_atomic_int64_t tile_count;
+  iree_atomic_int64_t failed_steal_count;
+  iree_atomic_int64_t busy_ns;
+  iree_atomic_int64_t idle_ns;
+  iree_atomic_int64_t steal_ns;
+
   // Thread handle of the worker. If the thread has exited the handle will
   // remain valid so that the executor can query its state.
   iree_thread_t* thread;
@@ -122,10 +179,15 @@ typedef struct iree_task_worker_t {
   // interference) this is the only place padding should be added.
   // uint8_t _padding[8];
 
-  // Pointer to local memory available for use exclusively by the worker.
-  // The base address should be aligned to avoid false sharing with other
-  // workers.
-  iree_byte_span_t local_memory;
+  // Local memory available for use exclusively by the worker. Allocated and
+  // grown by the worker thread itself to match the executor reservation so
+  // that it is local to the NUMA node of the worker.
+  iree_task_local_memory_t local_memory;
+
+  // FPU state of the worker thread, switched only when the FPU requirements of
+  // the tasks it executes change (see IREE_TASK_FLAG_FLUSH_DENORMALS_TO_ZERO).
+  // Only accessed by the worker thread.
+  iree_fpu_state_t fpu_state;
 
   // Worker-local FIFO queue containing the slices that will be processed by the
   // worker. This queue supports work-stealing by other workers if they run out
@@ -149,13 +211,17 @@ static_assert(offsetof(iree_task_worker_t, local_task_queue) >=
 iree_status_t iree_task_worker_initialize(
     iree_task_executor_t* executor, iree_host_size_t worker_index,
     const iree_task_topology_group_t* topology_group,
-    iree_byte_span_t local_memory, iree_prng_splitmix64_state_t* seed_prng,
-    iree_task_worker_t* out_worker);
+    iree_prng_splitmix64_state_t* seed_prng, iree_task_worker_t* out_worker);
 
 // Deinitializes a worker that has successfully exited. The worker must be in
 // the IREE_TASK_WORKER_STATE_ZOMBIE state.
 void iree_task_worker_deinitialize(iree_task_worker_t* worker);
 
+// Queries the current statistics of the worker.
+// May be called from any thread.
+void iree_task_worker_query_statistics(
+    iree_task_worker_t* worker, iree_task_worker_statistics_t* out_statistics);
+
 // Requests that the worker begin exiting (if it hasn't already).
 // If the worker is actively processing tasks it will wait until it has
 // completed all it can and is about to go idle prior to exiting.
@@ -170,6 +236,37 @@ void iree_task_worker_request_exit(iree_task_worker_t* worker);
 void iree_task_worker_post_tasks(iree_task_worker_t* worker,
                                  iree_task_list_t* list);
 
+// Records that tasks with the priorities in |priority_mask|
+// (1 << iree_task_priority_t) have been posted to the |worker| mailbox. Must be
+// called after the tasks have been posted.
+//
+// May be called from any thread.
+void iree_task_worker_mark_priorities_posted(iree_task_worker_t* worker,
+                                             uint32_t priority_mask);
+
+// Records that tasks from |scope| with the scope virtual time
+// |virtual_time_ns| have been posted to the |worker| mailbox. Must be called
+// after the tasks have been posted.
+//
+// Must only be called by the coordinator.
+void iree_task_worker_mark_virtual_time_posted(iree_task_worker_t* worker,
+                                               iree_task_scope_t* scope,
+                                               int64_t virtual_time_ns);
+
+// Returns true if tasks may have been posted to the |worker| mailbox since the
+// worker last flushed it. Tasks stolen from the mailbox by other workers may
+// cause this to return true when the mailbox is empty.
+//
+// May be called from any thread.
+bool iree_task_worker_has_posted_tasks(iree_task_worker_t* worker);
+
+// Records that a wake is being posted to |worker| so that the latency of the
+// worker responding can be measured. Must be called prior to posting the
+// worker wake_notification.
+//
+// May be called from any thread.
+void iree_task_worker_mark_wake_posted(iree_task_worker_t* worker);
+
 // Tries to steal up to |max_tasks| from the back of the queue.
 // Returns NULL if no tasks are available and otherwise up to |max_tasks| tasks
 // that were at the tail of the worker FIFO will be moved to the |target_queue|
@@ -179,6 +276,43 @@ iree_task_t* iree_task_worker_try_steal_task(iree_task_worker_t* worker,
                                              iree_task_queue_t* target_queue,
                                              iree_host_size_t max_tasks);
 
+// Executes a |task| that was posted to or stolen by a worker using
+// |local_memory| as the per-thread scratch memory for dispatch tiles.
+// Only task types that are scheduled to workers are handled; all others must be
+// handled by the coordinator during scheduling. Any tasks that become ready as
+// a result of execution are added to |pending_submission|.
+//
+// If |preemption| is provided then dispatch shards will yield to higher
+// priority work or scopes that are behind as indicated in it and be added back
+// to |pending_submission| (see iree_task_dispatch_shard_execute).
+// |relative_performance| is the percentage of the fastest core's performance
+// the executing thread has.
+//
+// |fpu_state| is the FPU state pushed by the executing thread and is updated to
+// match the FPU requirements of the task, writing the FPU state only if they
+// differ from those of the previously executed task.
+//
+// Execution is recorded on |flight_recorder_track| when the flight recorder is
+// enabled (see iree_task_worker_flight_recorder_track). |out_tile_count| is
+// incremented by the number of dispatch tiles executed.
+//
+// Called from worker threads and from callers donated to the executor.
+iree_status_t iree_task_worker_execute(
+    iree_task_t* task, iree_byte_span_t local_memory,
+    iree_task_preemption_t* preemption, uint32_t relative_performance,
+    iree_fpu_state_t* fpu_state, uint32_t flight_recorder_track,
+    uint32_t* out_tile_count, iree_task_submission_t* pending_submission);
+
+// Returns the flight recorder track events from |worker| are recorded on.
+// Events from threads that are not workers (such as donated callers) are
+// recorded on IREE_FLIGHT_RECORDER_TRACK_CALLER when |worker| is NULL.
+static inline uint32_t iree_task_worker_flight_recorder_track(
+    const iree_task_worker_t* worker) {
+  if (!worker) return IREE_FLIGHT_RECORDER_TRACK_CALLER;
+  return (uint32_t)iree_task_affinity_set_count_trailing_zeros(
+      worker->worker_bit);
+}
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -11,3 +11,53 @@ func @rfft_abs_6x1024() -> tensor<6x513xf32> {
   %1 = "mhlo.abs"(%0) : (tensor<6x513xcomplex<f32>>) -> tensor<6x513xf32>
   return %1: tensor<6x513xf32>
 }
+
+func @rfft_abs_256() -> tensor<129xf32> {
+  %input = util.unfoldable_constant dense<1.0> : tensor<256xf32>
+  %0 = "mhlo.fft"(%input) {
+    fft_length = dense<256> : tensor<1xi64>,
+    fft_type = "RFFT"
+  } : (tensor<256xf32>) -> tensor<129xcomplex<f32>>
+  %1 = "mhlo.abs"(%0) : (tensor<129xcomplex<f32>>) -> tensor<129xf32>
+  return %1: tensor<129xf32>
+}
+
+func @rfft_abs_512() -> tensor<257xf32> {
+  %input = util.unfoldable_constant dense<1.0> : tensor<512xf32>
+  %0 = "mhlo.fft"(%input) {
+    fft_length = dense<512> : tensor<1xi64>,
+    fft_type = "RFFT"
+  } : (tensor<512xf32>) -> tensor<257xcomplex<f32>>
+  %1 = "mhlo.abs"(%0) : (tensor<257xcomplex<f32>>) -> tensor<257xf32>
+  return %1: tensor<257xf32>
+}
+
+func @rfft_abs_1024() -> tensor<513xf32> {
+  %input = util.unfoldable_constant dense<1.0> : tensor<1024xf32>
+  %0 = "mhlo.fft"(%input) {
+    fft_length = dense<1024> : tensor<1xi64>,
+    fft_type = "RFFT"
+  } : (tensor<1024xf32>) -> tensor<513xcomplex<f32>>
+  %1 = "mhlo.abs"(%0) : (tensor<513xcomplex<f32>>) -> tensor<513xf32>
+  return %1: tensor<513xf32>
+}
+
+func @rfft_abs_2048() -> tensor<1025xf32> {
+  %input = util.unfoldable_constant dense<1.0> : tensor<2048xf32>
+  %0 = "mhlo.fft"(%input) {
+    fft_length = dense<2048> : tensor<1xi64>,
+    fft_type = "RFFT"
+  } : (tensor<2048xf32>) -> tensor<1025xcomplex<f32>>
+  %1 = "mhlo.abs"(%0) : (tensor<1025xcomplex<f32>>) -> tensor<1025xf32>
+  return %1: tensor<1025xf32>
+}
+
+func @rfft_abs_4096() -> tensor<2049xf32> {
+  %input = util.unfoldable_constant dense<1.0> : tensor<4096xf32>
+  %0 = "mhlo.fft"(%input) {
+    fft_length = dense<4096> : tensor<1xi64>,
+    fft_type = "RFFT"
+  } : (tensor<4096xf32>) -> tensor<2049xcomplex<f32>>
+  %1 = "mhlo.abs"(%0) : (tensor<2049xcomplex<f32>>) -> tensor<2049xf32>
+  return %1: tensor<2049xf32>
+}
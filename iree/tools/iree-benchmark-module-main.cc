@@ -4,11 +4,19 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
-#include <iterator>
+#include <memory>
+#include <random>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -22,6 +30,7 @@
 #include "iree/hal/api.h"
 #include "iree/hal/drivers/init.h"
 #include "iree/modules/hal/module.h"
+#include "iree/task/api.h"
 #include "iree/tools/utils/vm_util.h"
 #include "iree/vm/api.h"
 #include "iree/vm/bytecode_module.h"
@@ -45,6 +54,63 @@ IREE_FLAG(string, entry_function, "",
 
 IREE_FLAG(string, driver, "vmvx", "Backend driver to use.");
 
+IREE_FLAG(bool, dispatch_report, false,
+          "Runs each per-dispatch benchmark function exported by\n"
+          "-iree-flow-export-benchmark-funcs instead of the google benchmark\n"
+          "suite and prints a table ranked by time with the share of the\n"
+          "total time, bytes moved, and achieved GB/s and GFLOP/s. Times\n"
+          "include the invocation and submission overhead of each dispatch.");
+IREE_FLAG(int32_t, dispatch_report_iterations, 20,
+          "Number of timed iterations of each dispatch with\n"
+          "--dispatch_report after one untimed warmup iteration.");
+
+IREE_FLAG(int32_t, concurrency, 0,
+          "When > 0 runs --entry_function from this many client threads that\n"
+          "share one device, each with its own VM context, instead of running\n"
+          "the google benchmark suite. Reports throughput (QPS) and request\n"
+          "latency percentiles.");
+IREE_FLAG(int32_t, concurrent_request_count, 1000,
+          "Total number of requests issued across all clients when\n"
+          "--concurrency is set.");
+IREE_FLAG(double, arrival_rate, 0.0,
+          "Open-loop request arrival rate in requests per second when\n"
+          "--concurrency is set. Requests arrive with exponentially\n"
+          "distributed interarrival times and latency is measured from the\n"
+          "scheduled arrival so that it includes time spent waiting for a\n"
+          "free client. 0 runs closed-loop: each client issues its next\n"
+          "request as soon as the previous one completes.");
+
+IREE_FLAG(string, task_sweep_group_counts, "",
+          "Comma-separated list of worker counts (such as `1,2,4,8,16`). When\n"
+          "set runs --entry_function on a new device per worker count and\n"
+          "--task_sweep_topology_modes mode instead of running the google\n"
+          "benchmark suite, prints the mean time of each configuration, and\n"
+          "appends the fastest one to --task_tuning_file under\n"
+          "--task_tuning_model. Only applies to task system drivers (dylib,\n"
+          "vmvx).");
+IREE_FLAG(string, task_sweep_topology_modes, "physical_cores",
+          "Comma-separated list of --task_topology_mode values swept with\n"
+          "--task_sweep_group_counts.");
+IREE_FLAG(int32_t, task_sweep_iterations, 10,
+          "Number of timed iterations of each configuration swept with\n"
+          "--task_sweep_group_counts after one untimed warmup iteration.");
+
+IREE_FLAG(bool, print_memory_statistics, false,
+          "Reports the peak bytes of the buffers allocated from the device\n"
+          "allocator per memory type as counters of each benchmark and prints\n"
+          "the memory statistics of the allocator once all benchmarks ran.");
+IREE_FLAG(string, memory_timeline_file, "",
+          "Writes the device allocator memory usage sampled after each\n"
+          "benchmark iteration as a Chrome trace JSON file at the given path.");
+
+IREE_FLAG(bool, print_dispatch_profiles, false,
+          "Captures the device time of each dispatch executed while\n"
+          "benchmarking and prints a table of the dispatches ranked by total\n"
+          "time once all benchmarks ran. On CPU devices the table includes\n"
+          "the workgroups executed per dispatch and the share of work stolen\n"
+          "across worker threads. Ignored on devices without dispatch\n"
+          "profiling support. Profiling adds a small overhead per dispatch.");
+
 static iree_status_t parse_function_input(iree_string_view_t flag_name,
                                           void* storage,
                                           iree_string_view_t value) {
@@ -73,6 +139,9 @@ IREE_FLAG_CALLBACK(
     "  2x2xi32=1 2 3 4\n"
     "Optionally, brackets may be used to separate the element values:\n"
     "  2x2xi32=[[1 2][3 4]]\n"
+    "Buffers may also be loaded from .npy files or raw binary files:\n"
+    "  @input.npy\n"
+    "  2x2xi32=@input.bin\n"
     "Each occurrence of the flag indicates an input in the order they were\n"
     "specified on the command line.");
 
@@ -82,9 +151,14 @@ namespace {
 static void BenchmarkFunction(const std::string& benchmark_name, int batch_size,
                               iree_vm_context_t* context,
                               iree_vm_function_t function,
-                              iree_vm_list_t* inputs, benchmark::State& state) {
+                              iree_vm_list_t* inputs,
+                              iree_hal_allocator_t* device_allocator,
+                              AllocationTimeline* timeline,
+                              DispatchProfileSummary* dispatch_profiles,
+                              benchmark::State& state) {
   IREE_TRACE_SCOPE_DYNAMIC(benchmark_name.c_str());
   IREE_TRACE_FRAME_MARK();
+  iree_hal_allocator_reset_peak_statistics(device_allocator);
 
   // Benchmarking loop.
   while (state.KeepRunningBatch(batch_size)) {
@@ -95,22 +169,46 @@ static void BenchmarkFunction(const std::string& benchmark_name, int batch_size,
                                       iree_allocator_system(), &outputs));
     IREE_CHECK_OK(iree_vm_invoke(context, function, /*policy=*/nullptr, inputs,
                                  outputs.get(), iree_allocator_system()));
+    if (timeline) {
+      state.PauseTiming();
+      timeline->Record(benchmark_name);
+      state.ResumeTiming();
+    }
+    if (dispatch_profiles) {
+      // Flushing each iteration bounds the profiles pending on the device.
+      state.PauseTiming();
+      IREE_CHECK_OK(dispatch_profiles->Flush());
+      state.ResumeTiming();
+    }
+  }
+
+  if (FLAG_print_memory_statistics) {
+    iree_hal_allocator_statistics_t statistics;
+    iree_hal_allocator_query_statistics(device_allocator, &statistics);
+    state.counters["peak_host_local_bytes"] =
+        static_cast<double>(statistics.host_local.bytes_peak);
+    state.counters["peak_device_local_bytes"] =
+        static_cast<double>(statistics.device_local.bytes_peak);
   }
 }
 
 void RegisterModuleBenchmarks(const std::string& function_name,
                               iree_vm_context_t* context,
                               iree_vm_function_t function,
-                              iree_vm_list_t* inputs) {
+                              iree_vm_list_t* inputs,
+                              iree_hal_allocator_t* device_allocator,
+                              AllocationTimeline* timeline,
+                              DispatchProfileSummary* dispatch_profiles) {
   auto benchmark_name = "BM_" + function_name;
   int batch_size = FLAG_batch_size;
-  benchmark::RegisterBenchmark(benchmark_name.c_str(),
-                               [benchmark_name, batch_size, context, function,
-                                inputs](benchmark::State& state) -> void {
-                                 BenchmarkFunction(benchmark_name, batch_size,
-                                                   context, function, inputs,
-                                                   state);
-                               })
+  benchmark::RegisterBenchmark(
+      benchmark_name.c_str(),
+      [benchmark_name, batch_size, context, function, inputs, device_allocator,
+       timeline, dispatch_profiles](benchmark::State& state) -> void {
+        BenchmarkFunction(benchmark_name, batch_size, context, function,
+                          inputs, device_allocator, timeline,
+                          dispatch_profiles, state);
+      })
       // By default only the main thread is included in CPU time. Include all
       // the threads instead.
       ->MeasureProcessCPUTime()
@@ -126,16 +224,50 @@ void RegisterModuleBenchmarks(const std::string& function_name,
       ->Unit(benchmark::kMillisecond);
 }
 
-iree_status_t GetModuleContentsFromFlags(std::string* out_contents) {
-  IREE_TRACE_SCOPE0("GetModuleContentsFromFlags");
-  auto module_file = std::string(FLAG_module_file);
-  if (module_file == "-") {
-    *out_contents = std::string{std::istreambuf_iterator<char>(std::cin),
-                                std::istreambuf_iterator<char>()};
-  } else {
-    IREE_RETURN_IF_ERROR(GetFileContents(module_file.c_str(), out_contents));
+// A client issuing requests in the concurrent-request mode. Each client has its
+// own VM context (and thus its own HAL module state) against the shared device
+// so that clients only contend where independent request threads would.
+struct ConcurrentClient {
+  iree_vm_context_t* context = nullptr;
+  vm::ref<iree_vm_list_t> inputs;
+  // Latency of each request completed by the client in milliseconds.
+  std::vector<double> latencies_ms;
+  // First failure encountered by the client, if any.
+  iree_status_t status = iree_ok_status();
+};
+
+static iree_status_t InvokeRequest(iree_vm_context_t* context,
+                                   iree_vm_function_t function,
+                                   iree_vm_list_t* inputs) {
+  vm::ref<iree_vm_list_t> outputs;
+  IREE_RETURN_IF_ERROR(iree_vm_list_create(/*element_type=*/nullptr, 16,
+                                           iree_allocator_system(), &outputs));
+  return iree_vm_invoke(context, function, /*policy=*/nullptr, inputs,
+                        outputs.get(), iree_allocator_system());
+}
+
+// Returns the |percentile| of the ascending |sorted_values| by nearest rank.
+static double Percentile(const std::vector<double>& sorted_values,
+                         double percentile) {
+  if (sorted_values.empty()) return 0.0;
+  size_t rank = static_cast<size_t>(
+      std::ceil(percentile / 100.0 * sorted_values.size()));
+  return sorted_values[std::max<size_t>(rank, 1) - 1];
+}
+
+// Returns the non-empty elements of the comma-separated |value|.
+static std::vector<std::string> SplitFlagList(const char* value) {
+  std::vector<std::string> elements;
+  iree_string_view_t remaining = iree_make_cstring_view(value);
+  while (!iree_string_view_is_empty(remaining)) {
+    iree_string_view_t element;
+    iree_string_view_split(remaining, ',', &element, &remaining);
+    element = iree_string_view_trim(element);
+    if (!iree_string_view_is_empty(element)) {
+      elements.emplace_back(element.data, element.size);
+    }
   }
-  return iree_ok_status();
+  return elements;
 }
 
 // TODO(hanchung): Consider to refactor this out and reuse in iree-run-module.
@@ -152,6 +284,8 @@ class IREEBenchmark {
     IREE_TRACE_SCOPE0("IREEBenchmark::dtor");
 
     // Order matters.
+    dispatch_profiles_.reset();
+    timeline_.reset();
     inputs_.reset();
     iree_vm_context_release(context_);
     iree_vm_module_release(hal_module_);
@@ -160,6 +294,31 @@ class IREEBenchmark {
     iree_vm_instance_release(instance_);
   };
 
+  // Prints the device allocator statistics and writes the memory timeline as
+  // requested by flags once all benchmarks have run.
+  iree_status_t ReportMemory() {
+    if (!device_) return iree_ok_status();
+    if (FLAG_print_memory_statistics) {
+      IREE_RETURN_IF_ERROR(
+          PrintAllocatorStatistics(iree_hal_device_allocator(device_)));
+    }
+    if (timeline_) {
+      IREE_RETURN_IF_ERROR(
+          timeline_->WriteChromeTrace(FLAG_memory_timeline_file),
+          "writing memory timeline '%s'", FLAG_memory_timeline_file);
+    }
+    return iree_ok_status();
+  }
+
+  // Prints the dispatch profiles captured while benchmarking as requested by
+  // flags once all benchmarks have run.
+  iree_status_t ReportDispatchProfiles() {
+    if (!dispatch_profiles_) return iree_ok_status();
+    IREE_RETURN_IF_ERROR(dispatch_profiles_->End());
+    dispatch_profiles_->Print();
+    return iree_ok_status();
+  }
+
   iree_status_t Register() {
     IREE_TRACE_SCOPE0("IREEBenchmark::Register");
 
@@ -176,25 +335,337 @@ class IREEBenchmark {
     return iree_ok_status();
   }
 
+  // Times each exported per-dispatch benchmark function and prints a table
+  // ranked by time.
+  iree_status_t RunDispatchReport() {
+    IREE_TRACE_SCOPE0("IREEBenchmark::RunDispatchReport");
+
+    if (!instance_ || !device_ || !hal_module_ || !context_ || !input_module_) {
+      IREE_RETURN_IF_ERROR(Init());
+    }
+
+    struct DispatchResult {
+      std::string name;
+      double time_ms = 0.0;
+      int64_t bytes = 0;
+      // Scalar op estimate from the compiler or -1 if unknown.
+      int64_t ops = -1;
+    };
+    std::vector<DispatchResult> results;
+
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+    int iteration_count = std::max(FLAG_dispatch_report_iterations, 1);
+    iree_vm_module_signature_t signature =
+        input_module_->signature(input_module_->self);
+    for (iree_host_size_t i = 0; i < signature.export_function_count; ++i) {
+      iree_vm_function_t function;
+      iree_string_view_t export_name;
+      IREE_RETURN_IF_ERROR(input_module_->get_function(
+          input_module_->self, IREE_VM_FUNCTION_LINKAGE_EXPORT, i, &function,
+          &export_name, nullptr));
+      if (!iree_string_view_equal(
+              iree_vm_function_reflection_attr(&function, IREE_SV("benchmark")),
+              IREE_SV("dispatch"))) {
+        continue;
+      }
+
+      DispatchResult result;
+      result.name = std::string(export_name.data, export_name.size);
+      iree_string_view_t bytes_str =
+          iree_vm_function_reflection_attr(&function, IREE_SV("bytes"));
+      iree_string_view_t ops_str =
+          iree_vm_function_reflection_attr(&function, IREE_SV("ops"));
+      if (!iree_string_view_is_empty(bytes_str)) {
+        result.bytes = std::stoll(std::string(bytes_str.data, bytes_str.size));
+      }
+      if (!iree_string_view_is_empty(ops_str)) {
+        result.ops = std::stoll(std::string(ops_str.data, ops_str.size));
+      }
+
+      IREE_TRACE_SCOPE_DYNAMIC(result.name.c_str());
+      IREE_RETURN_IF_ERROR(InvokeRequest(context_, function, nullptr));
+      auto start_time = Clock::now();
+      for (int j = 0; j < iteration_count; ++j) {
+        IREE_RETURN_IF_ERROR(InvokeRequest(context_, function, nullptr));
+      }
+      result.time_ms =
+          Milliseconds(Clock::now() - start_time).count() / iteration_count;
+      results.push_back(std::move(result));
+    }
+    if (results.empty()) {
+      return iree_make_status(
+          IREE_STATUS_NOT_FOUND,
+          "module has no per-dispatch benchmark functions; compile with "
+          "-iree-flow-export-benchmark-funcs");
+    }
+
+    std::sort(results.begin(), results.end(),
+              [](const DispatchResult& lhs, const DispatchResult& rhs) {
+                return lhs.time_ms > rhs.time_ms;
+              });
+    double total_time_ms = 0.0;
+    for (auto& result : results) total_time_ms += result.time_ms;
+
+    fprintf(stdout, "%-48s %12s %8s %14s %10s %10s\n", "Dispatch", "Time (ms)",
+            "% total", "Bytes", "GB/s", "GFLOP/s");
+    for (auto& result : results) {
+      double time_s = result.time_ms / 1000.0;
+      fprintf(stdout, "%-48s %12.4f %7.2f%% %14" PRId64 " %10.3f ",
+              result.name.c_str(), result.time_ms,
+              100.0 * result.time_ms / total_time_ms, result.bytes,
+              result.bytes / time_s / 1e9);
+      if (result.ops >= 0) {
+        fprintf(stdout, "%10.3f\n", result.ops / time_s / 1e9);
+      } else {
+        fprintf(stdout, "%10s\n", "-");
+      }
+    }
+    fprintf(stdout, "%-48s %12.4f\n", "Total", total_time_ms);
+    return iree_ok_status();
+  }
+
+  // Runs --entry_function with each worker configuration of the
+  // --task_sweep_* flags and records the fastest one.
+  iree_status_t RunTaskSweep() {
+    IREE_TRACE_SCOPE0("IREEBenchmark::RunTaskSweep");
+
+    auto function_name = std::string(FLAG_entry_function);
+    if (function_name.empty()) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "--task_sweep_group_counts requires "
+                              "--entry_function");
+    }
+    std::vector<iree_task_worker_config_t> configs;
+    for (auto& mode : SplitFlagList(FLAG_task_sweep_topology_modes)) {
+      for (auto& count : SplitFlagList(FLAG_task_sweep_group_counts)) {
+        iree_task_worker_config_t config;
+        memset(&config, 0, sizeof(config));
+        uint32_t max_group_count = 0;
+        if (mode.size() >= sizeof(config.topology_mode) ||
+            !iree_string_view_atoi_uint32(
+                iree_string_view_t{count.data(), count.size()},
+                &max_group_count) ||
+            max_group_count == 0) {
+          return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                  "invalid task sweep configuration %s:%s",
+                                  mode.c_str(), count.c_str());
+        }
+        memcpy(config.topology_mode, mode.data(), mode.size());
+        config.max_group_count = max_group_count;
+        configs.push_back(config);
+      }
+    }
+    if (configs.empty()) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "no task sweep configurations specified");
+    }
+
+    if (!instance_) {
+      IREE_RETURN_IF_ERROR(iree_hal_module_register_types());
+      IREE_RETURN_IF_ERROR(
+          iree_vm_instance_create(iree_allocator_system(), &instance_));
+    }
+    if (!input_module_) {
+      IREE_RETURN_IF_ERROR(LoadBytecodeModule(
+          FLAG_module_file, iree_allocator_system(), &input_module_));
+    }
+    iree_vm_function_t function;
+    IREE_RETURN_IF_ERROR(input_module_->lookup_function(
+        input_module_->self, IREE_VM_FUNCTION_LINKAGE_EXPORT,
+        iree_string_view_t{function_name.data(), function_name.size()},
+        &function));
+
+    // Each configuration gets its own device as the executor worker
+    // configuration is fixed when the driver creates it.
+    std::vector<double> times_ms;
+    iree_status_t status = iree_ok_status();
+    for (auto& config : configs) {
+      iree_task_executor_override_worker_config(&config);
+      double time_ms = 0.0;
+      status = TimeTaskSweepConfig(function, &time_ms);
+      if (!iree_status_is_ok(status)) break;
+      times_ms.push_back(time_ms);
+    }
+    iree_task_executor_override_worker_config(nullptr);
+    IREE_RETURN_IF_ERROR(status);
+
+    size_t best_index = std::min_element(times_ms.begin(), times_ms.end()) -
+                        times_ms.begin();
+    fprintf(stdout, "%-24s %10s %12s\n", "Topology mode", "Workers",
+            "Time (ms)");
+    for (size_t i = 0; i < configs.size(); ++i) {
+      fprintf(stdout, "%-24s %10zu %12.4f%s\n", configs[i].topology_mode,
+              configs[i].max_group_count, times_ms[i],
+              i == best_index ? " (best)" : "");
+    }
+
+    status = iree_task_tuning_record_from_flags(&configs[best_index],
+                                                times_ms[best_index]);
+    if (iree_status_is_failed_precondition(status)) {
+      iree_status_ignore(status);
+      fprintf(stdout,
+              "set --task_tuning_file and --task_tuning_model to record the "
+              "best configuration\n");
+      return iree_ok_status();
+    }
+    return status;
+  }
+
+  // Runs --entry_function from --concurrency client threads and prints the
+  // achieved throughput and latency distribution.
+  iree_status_t RunConcurrent() {
+    IREE_TRACE_SCOPE0("IREEBenchmark::RunConcurrent");
+
+    if (!instance_ || !device_ || !hal_module_ || !context_ || !input_module_) {
+      IREE_RETURN_IF_ERROR(Init());
+    }
+
+    auto function_name = std::string(FLAG_entry_function);
+    if (function_name.empty()) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "--concurrency requires --entry_function");
+    }
+    iree_vm_function_t function;
+    IREE_RETURN_IF_ERROR(input_module_->lookup_function(
+        input_module_->self, IREE_VM_FUNCTION_LINKAGE_EXPORT,
+        iree_string_view_t{function_name.data(), function_name.size()},
+        &function));
+
+    // Create the clients and issue one warmup request from each so that any
+    // lazy initialization (executable loading, pools, etc) is not measured.
+    std::vector<ConcurrentClient> clients(FLAG_concurrency);
+    iree_status_t status = iree_ok_status();
+    std::array<iree_vm_module_t*, 2> modules = {hal_module_, input_module_};
+    for (auto& client : clients) {
+      status = iree_vm_context_create_with_modules(
+          instance_, modules.data(), modules.size(), iree_allocator_system(),
+          &client.context);
+      if (!iree_status_is_ok(status)) break;
+      status = ParseToVariantList(
+          iree_hal_device_allocator(device_),
+          iree::span<const std::string>{FLAG_function_inputs.data(),
+                                        FLAG_function_inputs.size()},
+          &client.inputs);
+      if (!iree_status_is_ok(status)) break;
+      status = InvokeRequest(client.context, function, client.inputs.get());
+      if (!iree_status_is_ok(status)) break;
+    }
+
+    // Precompute the open-loop arrival schedule with a fixed seed so that runs
+    // are comparable.
+    int request_count = FLAG_concurrent_request_count;
+    bool is_open_loop = FLAG_arrival_rate > 0.0;
+    std::vector<double> arrival_offsets_ms;
+    if (is_open_loop) {
+      std::mt19937 generator(/*seed=*/0);
+      std::exponential_distribution<double> interarrival_s(FLAG_arrival_rate);
+      arrival_offsets_ms.resize(request_count);
+      double offset_ms = 0.0;
+      for (auto& arrival_offset_ms : arrival_offsets_ms) {
+        arrival_offset_ms = offset_ms;
+        offset_ms += interarrival_s(generator) * 1000.0;
+      }
+    }
+
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+    auto start_time = Clock::now();
+    Milliseconds wall_time(0.0);
+    if (iree_status_is_ok(status)) {
+      std::atomic<int> next_request(0);
+      std::vector<std::thread> threads;
+      threads.reserve(clients.size());
+      for (auto& client : clients) {
+        threads.emplace_back([&, function]() {
+          IREE_TRACE_SCOPE0("ConcurrentClient");
+          client.latencies_ms.reserve(request_count / clients.size() + 1);
+          while (true) {
+            int request = next_request.fetch_add(1);
+            if (request >= request_count) break;
+            auto arrival_time = Clock::now();
+            if (is_open_loop) {
+              arrival_time =
+                  start_time + std::chrono::duration_cast<Clock::duration>(
+                                   Milliseconds(arrival_offsets_ms[request]));
+              std::this_thread::sleep_until(arrival_time);
+            }
+            IREE_TRACE_FRAME_MARK_NAMED("Request");
+            client.status =
+                InvokeRequest(client.context, function, client.inputs.get());
+            if (!iree_status_is_ok(client.status)) break;
+            client.latencies_ms.push_back(
+                Milliseconds(Clock::now() - arrival_time).count());
+          }
+        });
+      }
+      for (auto& thread : threads) thread.join();
+      wall_time = Clock::now() - start_time;
+    }
+
+    // Gather results and release the clients prior to the shared resources.
+    std::vector<double> latencies_ms;
+    latencies_ms.reserve(request_count);
+    for (auto& client : clients) {
+      if (iree_status_is_ok(status)) {
+        status = client.status;
+      } else {
+        iree_status_ignore(client.status);
+      }
+      latencies_ms.insert(latencies_ms.end(), client.latencies_ms.begin(),
+                          client.latencies_ms.end());
+      client.inputs.reset();
+      iree_vm_context_release(client.context);
+    }
+    IREE_RETURN_IF_ERROR(status);
+
+    std::sort(latencies_ms.begin(), latencies_ms.end());
+    double total_latency_ms = 0.0;
+    for (double latency_ms : latencies_ms) total_latency_ms += latency_ms;
+    double mean_latency_ms =
+        latencies_ms.empty() ? 0.0 : total_latency_ms / latencies_ms.size();
+    double qps = latencies_ms.size() / (wall_time.count() / 1000.0);
+
+    fprintf(stdout, "%s: concurrency=%d requests=%zu ", function_name.c_str(),
+            FLAG_concurrency, latencies_ms.size());
+    if (is_open_loop) {
+      fprintf(stdout, "arrival_rate=%.2f/s (open-loop)\n", FLAG_arrival_rate);
+    } else {
+      fprintf(stdout, "(closed-loop)\n");
+    }
+    fprintf(stdout, "  wall time:  %.3f ms\n", wall_time.count());
+    fprintf(stdout, "  throughput: %.2f QPS\n", qps);
+    fprintf(stdout,
+            "  latency:    mean=%.3f p50=%.3f p95=%.3f p99=%.3f max=%.3f ms\n",
+            mean_latency_ms, Percentile(latencies_ms, 50.0),
+            Percentile(latencies_ms, 95.0), Percentile(latencies_ms, 99.0),
+            latencies_ms.empty() ? 0.0 : latencies_ms.back());
+    return iree_ok_status();
+  }
+
  private:
   iree_status_t Init() {
     IREE_TRACE_SCOPE0("IREEBenchmark::Init");
     IREE_TRACE_FRAME_MARK_BEGIN_NAMED("init");
 
-    IREE_RETURN_IF_ERROR(GetModuleContentsFromFlags(&module_data_));
-
     IREE_RETURN_IF_ERROR(iree_hal_module_register_types());
     IREE_RETURN_IF_ERROR(
         iree_vm_instance_create(iree_allocator_system(), &instance_));
 
     // Create IREE's device and module.
     IREE_RETURN_IF_ERROR(iree::CreateDevice(FLAG_driver, &device_));
+    if (strlen(FLAG_memory_timeline_file) > 0) {
+      timeline_ = std::make_unique<AllocationTimeline>(
+          iree_hal_device_allocator(device_));
+    }
+    if (FLAG_print_dispatch_profiles) {
+      dispatch_profiles_ = std::make_unique<DispatchProfileSummary>(device_);
+      IREE_RETURN_IF_ERROR(dispatch_profiles_->Begin());
+    }
     IREE_RETURN_IF_ERROR(
         iree_hal_module_create(device_, iree_allocator_system(), &hal_module_));
-    IREE_RETURN_IF_ERROR(iree_vm_bytecode_module_create(
-        iree_make_const_byte_span((void*)module_data_.data(),
-                                  module_data_.size()),
-        iree_allocator_null(), iree_allocator_system(), &input_module_));
+    IREE_RETURN_IF_ERROR(LoadBytecodeModule(
+        FLAG_module_file, iree_allocator_system(), &input_module_));
 
     // Order matters. The input module will likely be dependent on the hal
     // module.
@@ -207,6 +678,53 @@ class IREEBenchmark {
     return iree_ok_status();
   }
 
+  // Returns the mean time of --entry_function on a new device that uses the
+  // current worker configuration.
+  iree_status_t TimeTaskSweepConfig(iree_vm_function_t function,
+                                    double* out_time_ms) {
+    iree_hal_device_t* device = nullptr;
+    iree_vm_module_t* hal_module = nullptr;
+    iree_vm_context_t* context = nullptr;
+    iree::vm::ref<iree_vm_list_t> inputs;
+    iree_status_t status = iree::CreateDevice(FLAG_driver, &device);
+    if (iree_status_is_ok(status)) {
+      status =
+          iree_hal_module_create(device, iree_allocator_system(), &hal_module);
+    }
+    if (iree_status_is_ok(status)) {
+      std::array<iree_vm_module_t*, 2> modules = {hal_module, input_module_};
+      status = iree_vm_context_create_with_modules(
+          instance_, modules.data(), modules.size(), iree_allocator_system(),
+          &context);
+    }
+    if (iree_status_is_ok(status)) {
+      status = ParseToVariantList(
+          iree_hal_device_allocator(device),
+          iree::span<const std::string>{FLAG_function_inputs.data(),
+                                        FLAG_function_inputs.size()},
+          &inputs);
+    }
+    if (iree_status_is_ok(status)) {
+      status = InvokeRequest(context, function, inputs.get());
+    }
+    if (iree_status_is_ok(status)) {
+      using Clock = std::chrono::steady_clock;
+      using Milliseconds = std::chrono::duration<double, std::milli>;
+      int iteration_count = std::max(FLAG_task_sweep_iterations, 1);
+      auto start_time = Clock::now();
+      for (int i = 0; i < iteration_count && iree_status_is_ok(status); ++i) {
+        status = InvokeRequest(context, function, inputs.get());
+      }
+      *out_time_ms =
+          Milliseconds(Clock::now() - start_time).count() / iteration_count;
+    }
+    inputs.reset();
+    iree_vm_context_release(context);
+    iree_vm_module_release(hal_module);
+    iree_hal_device_release(device);
+    return status;
+  }
+
   iree_status_t RegisterSpecificFunction(const std::string& function_name) {
     IREE_TRACE_SCOPE0("IREEBenchmark::RegisterSpecificFunction");
 
@@ -221,7 +739,9 @@ class IREEBenchmark {
         iree::span<const std::string>{FLAG_function_inputs.data(),
                                       FLAG_function_inputs.size()},
         &inputs_));
-    RegisterModuleBenchmarks(function_name, context_, function, inputs_.get());
+    RegisterModuleBenchmarks(function_name, context_, function, inputs_.get(),
+                             iree_hal_device_allocator(device_),
+                             timeline_.get(), dispatch_profiles_.get());
     return iree_ok_status();
   }
 
@@ -264,18 +784,20 @@ class IREEBenchmark {
 
       iree::RegisterModuleBenchmarks(
           std::string(export_name.data, export_name.size), context_, function,
-          /*inputs=*/nullptr);
+          /*inputs=*/nullptr, iree_hal_device_allocator(device_),
+          timeline_.get(), dispatch_profiles_.get());
     }
     return iree_ok_status();
   }
 
-  std::string module_data_;
   iree_vm_instance_t* instance_ = nullptr;
   iree_hal_device_t* device_ = nullptr;
   iree_vm_module_t* hal_module_ = nullptr;
   iree_vm_context_t* context_ = nullptr;
   iree_vm_module_t* input_module_ = nullptr;
   iree::vm::ref<iree_vm_list_t> inputs_;
+  std::unique_ptr<AllocationTimeline> timeline_;
+  std::unique_ptr<DispatchProfileSummary> dispatch_profiles_;
 };
 }  // namespace
 }  // namespace iree
@@ -293,12 +815,35 @@ int main(int argc, char** argv) {
       iree_hal_driver_registry_default()));
 
   iree::IREEBenchmark iree_benchmark;
-  iree_status_t status = iree_benchmark.Register();
+  bool run_task_sweep = strlen(FLAG_task_sweep_group_counts) > 0;
+  bool use_benchmark_suite =
+      !FLAG_dispatch_report && FLAG_concurrency == 0 && !run_task_sweep;
+  iree_status_t status = iree_ok_status();
+  if (FLAG_dispatch_report) {
+    status = iree_benchmark.RunDispatchReport();
+  } else if (run_task_sweep) {
+    status = iree_benchmark.RunTaskSweep();
+  } else if (FLAG_concurrency > 0) {
+    status = iree_benchmark.RunConcurrent();
+  } else {
+    status = iree_benchmark.Register();
+  }
+  if (!iree_status_is_ok(status)) {
+    int ret = static_cast<int>(iree_status_code(status));
+    std::cout << iree::Status(std::move(status)) << std::endl;
+    return ret;
+  }
+  if (use_benchmark_suite) {
+    ::benchmark::RunSpecifiedBenchmarks();
+  }
+  status = iree_benchmark.ReportMemory();
+  if (iree_status_is_ok(status)) {
+    status = iree_benchmark.ReportDispatchProfiles();
+  }
   if (!iree_status_is_ok(status)) {
     int ret = static_cast<int>(iree_status_code(status));
     std::cout << iree::Status(std::move(status)) << std::endl;
     return ret;
   }
-  ::benchmark::RunSpecifiedBenchmarks();
   return 0;
 }
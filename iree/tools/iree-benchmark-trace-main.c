@@ -12,8 +12,11 @@
 #include <string.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
 #include "iree/base/internal/file_path.h"
 #include "iree/base/internal/flags.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/internal/threading.h"
 #include "iree/hal/api.h"
 #include "iree/hal/drivers/init.h"
 #include "iree/testing/benchmark.h"
@@ -27,6 +30,12 @@ IREE_FLAG(int32_t, call_iterations, 1,
           "Number of times to invoke each call in the trace. May break usage "
           "with stateful models.");
 
+IREE_FLAG(int32_t, replay_streams, 1,
+          "Number of independent copies of each trace to replay concurrently "
+          "against a single device created from --driver=. Each stream has "
+          "its own context and inputs and runs on its own thread, reproducing "
+          "the contention of multiple concurrent users of the device.");
+
 // A benchmark registration for each file to run.
 typedef struct iree_replay_benchmark_registration_t {
   iree_benchmark_def_t benchmark_def;  // Must be first.
@@ -112,6 +121,22 @@ static iree_status_t iree_replay_benchmark_prepare_call(
   return iree_ok_status();
 }
 
+// Processes a binary call trace event like iree_replay_benchmark_prepare_call.
+static iree_status_t iree_replay_benchmark_prepare_binary_call(
+    iree_trace_replay_t* replay, const iree_trace_binary_file_t* file,
+    const iree_trace_binary_event_t* event,
+    iree_replay_benchmark_call_list_t* call_list) {
+  iree_replay_benchmark_call_t* call =
+      iree_replay_benchmark_call_list_acquire_back(call_list);
+  memset(call, 0, sizeof(*call));
+  IREE_RETURN_IF_ERROR(iree_trace_replay_binary_event_call_prepare(
+      replay, file, event, &call->function, &call->input_list));
+  IREE_RETURN_IF_ERROR(
+      iree_vm_list_create(/*element_type=*/NULL, /*initial_capacity=*/8,
+                          replay->host_allocator, &call->output_list));
+  return iree_ok_status();
+}
+
 // Processes a trace event by either setting up the |replay| or appending a call
 // to the |call_list|.
 static iree_status_t iree_replay_benchmark_process_event(
@@ -187,6 +212,242 @@ static iree_status_t iree_replay_benchmark_load_trace(
   return status;
 }
 
+// Configures |replay| from the mapped binary trace |file| and appends its calls
+// to |call_list|. Inputs are wrapped from the mapping instead of parsed.
+static iree_status_t iree_replay_benchmark_load_binary_trace(
+    const iree_trace_binary_file_t* file, iree_trace_replay_t* replay,
+    iree_replay_benchmark_call_list_t* call_list) {
+  for (uint32_t i = 0; i < file->header->event_count; ++i) {
+    const iree_trace_binary_event_t* event = &file->events[i];
+    if (event->type == IREE_TRACE_BINARY_EVENT_CALL) {
+      IREE_RETURN_IF_ERROR(iree_replay_benchmark_prepare_binary_call(
+          replay, file, event, call_list));
+    } else {
+      IREE_RETURN_IF_ERROR(iree_trace_replay_binary_event(replay, file, event));
+    }
+  }
+  return iree_ok_status();
+}
+
+// An independent replay of a trace with its own context and inputs.
+typedef struct iree_replay_benchmark_stream_t {
+  iree_trace_replay_t replay;
+  iree_replay_benchmark_call_list_t call_list;
+} iree_replay_benchmark_stream_t;
+
+// Loads the trace in |registration| into |out_stream|. If |device| is not NULL
+// it is used by the stream instead of a device created from the trace.
+// |binary_file| must be open if the trace is binary.
+static iree_status_t iree_replay_benchmark_stream_initialize(
+    const iree_replay_benchmark_registration_t* registration,
+    const iree_trace_binary_file_t* binary_file, iree_hal_device_t* device,
+    iree_replay_benchmark_stream_t* out_stream) {
+  IREE_RETURN_IF_ERROR(iree_trace_replay_initialize(
+      registration->root_path, registration->instance, iree_allocator_system(),
+      &out_stream->replay));
+  iree_trace_replay_set_hal_driver_override(
+      &out_stream->replay, iree_make_cstring_view(FLAG_driver));
+  iree_trace_replay_set_shared_device(&out_stream->replay, device);
+  iree_replay_benchmark_call_list_initialize(&out_stream->call_list);
+  if (binary_file) {
+    return iree_replay_benchmark_load_binary_trace(
+        binary_file, &out_stream->replay, &out_stream->call_list);
+  }
+  return iree_replay_benchmark_load_trace(
+      registration->file_path, &out_stream->replay, &out_stream->call_list);
+}
+
+static void iree_replay_benchmark_stream_deinitialize(
+    iree_replay_benchmark_stream_t* stream) {
+  iree_replay_benchmark_call_list_deinitialize(&stream->call_list);
+  iree_trace_replay_deinitialize(&stream->replay);
+}
+
+// Calls the functions within the trace of |stream| in order.
+static iree_status_t iree_replay_benchmark_stream_run(
+    iree_replay_benchmark_stream_t* stream) {
+  for (size_t i = 0; i < stream->call_list.count; ++i) {
+    iree_replay_benchmark_call_t* call = &stream->call_list.items[i];
+    for (int32_t j = 0; j < FLAG_call_iterations; ++j) {
+      IREE_RETURN_IF_ERROR(iree_vm_invoke(
+          stream->replay.context, call->function, /*policy=*/NULL,
+          call->input_list, call->output_list, stream->replay.host_allocator));
+      IREE_RETURN_IF_ERROR(iree_vm_list_resize(call->output_list, 0));
+    }
+  }
+  return iree_ok_status();
+}
+
+//===----------------------------------------------------------------------===//
+// Concurrent stream execution
+//===----------------------------------------------------------------------===//
+// Streams 1..N-1 each run on a persistent worker thread so that thread creation
+// is not measured; every benchmark iteration forks all streams and joins them
+// once the last one finishes. Stream 0 runs on the benchmark thread.
+
+typedef struct iree_replay_benchmark_streams_t iree_replay_benchmark_streams_t;
+
+typedef struct iree_replay_benchmark_worker_t {
+  iree_replay_benchmark_streams_t* streams;
+  iree_replay_benchmark_stream_t* stream;
+  // Generation of the last pass the worker ran.
+  int32_t generation;
+  iree_thread_t* thread;
+} iree_replay_benchmark_worker_t;
+
+struct iree_replay_benchmark_streams_t {
+  // Posted when a new pass begins or the workers are asked to exit.
+  iree_notification_t begin_notification;
+  // Posted when the last worker finishes its pass.
+  iree_notification_t end_notification;
+  // Incremented each time a pass begins.
+  iree_atomic_int32_t generation;
+  // Set to 1 when the workers should exit.
+  iree_atomic_int32_t exit_requested;
+  // Number of workers that have not yet finished the current pass.
+  iree_atomic_int32_t pending_worker_count;
+  // The first failure of the current pass as an iree_status_t, if any.
+  iree_atomic_intptr_t failure_status;
+
+  iree_host_size_t worker_count;
+  iree_replay_benchmark_worker_t* workers;
+};
+
+static void iree_replay_benchmark_streams_record_failure(
+    iree_replay_benchmark_streams_t* streams, iree_status_t status) {
+  intptr_t expected = 0;
+  if (!iree_atomic_compare_exchange_strong_intptr(
+          &streams->failure_status, &expected, (intptr_t)status,
+          iree_memory_order_acq_rel, iree_memory_order_relaxed)) {
+    iree_status_ignore(status);  // another failure was recorded first
+  }
+}
+
+static bool iree_replay_benchmark_worker_should_wake(
+    iree_replay_benchmark_worker_t* worker) {
+  iree_replay_benchmark_streams_t* streams = worker->streams;
+  return iree_atomic_load_int32(&streams->exit_requested,
+                                iree_memory_order_acquire) ||
+         iree_atomic_load_int32(&streams->generation,
+                                iree_memory_order_acquire) !=
+             worker->generation;
+}
+
+static int iree_replay_benchmark_worker_main(
+    iree_replay_benchmark_worker_t* worker) {
+  iree_replay_benchmark_streams_t* streams = worker->streams;
+  while (true) {
+    iree_notification_await(
+        &streams->begin_notification,
+        (iree_condition_fn_t)iree_replay_benchmark_worker_should_wake, worker);
+    if (iree_atomic_load_int32(&streams->exit_requested,
+                               iree_memory_order_acquire)) {
+      break;
+    }
+    worker->generation =
+        iree_atomic_load_int32(&streams->generation, iree_memory_order_acquire);
+    iree_status_t status = iree_replay_benchmark_stream_run(worker->stream);
+    if (!iree_status_is_ok(status)) {
+      iree_replay_benchmark_streams_record_failure(streams, status);
+    }
+    if (iree_atomic_fetch_sub_int32(&streams->pending_worker_count, 1,
+                                    iree_memory_order_acq_rel) == 1) {
+      iree_notification_post(&streams->end_notification, IREE_ALL_WAITERS);
+    }
+  }
+  return 0;
+}
+
+// Starts a worker for each of |stream_list[1..stream_count)|.
+static iree_status_t iree_replay_benchmark_streams_initialize(
+    iree_host_size_t stream_count, iree_replay_benchmark_stream_t* stream_list,
+    iree_replay_benchmark_streams_t* out_streams) {
+  memset(out_streams, 0, sizeof(*out_streams));
+  iree_notification_initialize(&out_streams->begin_notification);
+  iree_notification_initialize(&out_streams->end_notification);
+  if (stream_count <= 1) return iree_ok_status();
+  out_streams->workers = (iree_replay_benchmark_worker_t*)calloc(
+      stream_count - 1, sizeof(*out_streams->workers));
+
+  iree_thread_create_params_t thread_params;
+  memset(&thread_params, 0, sizeof(thread_params));
+  thread_params.name = iree_make_cstring_view("iree-replay-stream");
+  for (iree_host_size_t i = 0; i < stream_count - 1; ++i) {
+    iree_replay_benchmark_worker_t* worker = &out_streams->workers[i];
+    worker->streams = out_streams;
+    worker->stream = &stream_list[1 + i];
+    IREE_RETURN_IF_ERROR(iree_thread_create(
+        (iree_thread_entry_t)iree_replay_benchmark_worker_main, worker,
+        thread_params, iree_allocator_system(), &worker->thread));
+    out_streams->worker_count = i + 1;
+  }
+  return iree_ok_status();
+}
+
+static void iree_replay_benchmark_streams_deinitialize(
+    iree_replay_benchmark_streams_t* streams) {
+  // Wake all workers and join them; release blocks until each thread exits.
+  iree_atomic_store_int32(&streams->exit_requested, 1,
+                          iree_memory_order_release);
+  iree_notification_post(&streams->begin_notification, IREE_ALL_WAITERS);
+  for (iree_host_size_t i = 0; i < streams->worker_count; ++i) {
+    iree_thread_release(streams->workers[i].thread);
+  }
+  free(streams->workers);
+  iree_notification_deinitialize(&streams->end_notification);
+  iree_notification_deinitialize(&streams->begin_notification);
+}
+
+static bool iree_replay_benchmark_streams_is_pass_done(
+    iree_replay_benchmark_streams_t* streams) {
+  return iree_atomic_load_int32(&streams->pending_worker_count,
+                                iree_memory_order_acquire) == 0;
+}
+
+// Runs one pass of all streams concurrently with |main_stream| running on the
+// calling thread and returns the first failure.
+static iree_status_t iree_replay_benchmark_streams_run(
+    iree_replay_benchmark_streams_t* streams,
+    iree_replay_benchmark_stream_t* main_stream) {
+  if (streams->worker_count == 0) {
+    return iree_replay_benchmark_stream_run(main_stream);
+  }
+
+  // Fork.
+  iree_atomic_store_int32(&streams->pending_worker_count,
+                          (int32_t)streams->worker_count,
+                          iree_memory_order_relaxed);
+  iree_atomic_fetch_add_int32(&streams->generation, 1,
+                              iree_memory_order_release);
+  iree_notification_post(&streams->begin_notification, IREE_ALL_WAITERS);
+
+  iree_status_t status = iree_replay_benchmark_stream_run(main_stream);
+  if (!iree_status_is_ok(status)) {
+    iree_replay_benchmark_streams_record_failure(streams, status);
+  }
+
+  // Join.
+  iree_notification_await(
+      &streams->end_notification,
+      (iree_condition_fn_t)iree_replay_benchmark_streams_is_pass_done,
+      streams);
+  return (iree_status_t)iree_atomic_exchange_intptr(
+      &streams->failure_status, 0, iree_memory_order_acquire);
+}
+
+// Creates the device shared by all streams from the --driver= flag.
+static iree_status_t iree_replay_benchmark_create_shared_device(
+    iree_hal_device_t** out_device) {
+  iree_hal_driver_t* driver = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_driver_registry_try_create_by_name(
+      iree_hal_driver_registry_default(), iree_make_cstring_view(FLAG_driver),
+      iree_allocator_system(), &driver));
+  iree_status_t status = iree_hal_driver_create_default_device(
+      driver, iree_allocator_system(), out_device);
+  iree_hal_driver_release(driver);
+  return status;
+}
+
 // Benchmark function that runs a trace file.
 static iree_status_t iree_replay_benchmark_run_file(
     const iree_benchmark_def_t* benchmark_def,
@@ -194,37 +455,51 @@ static iree_status_t iree_replay_benchmark_run_file(
   const iree_replay_benchmark_registration_t* registration =
       (const iree_replay_benchmark_registration_t*)benchmark_def;
 
-  // Setup replay state used for this benchmark.
-  iree_trace_replay_t replay;
-  IREE_RETURN_IF_ERROR(iree_trace_replay_initialize(
-      registration->root_path, registration->instance, iree_allocator_system(),
-      &replay));
-  iree_trace_replay_set_hal_driver_override(
-      &replay, iree_make_cstring_view(FLAG_driver));
+  // Binary traces are mapped once and shared by all streams.
+  bool is_binary =
+      iree_trace_binary_file_is_binary(registration->file_path.data);
+  iree_trace_binary_file_t binary_file;
+  if (is_binary) {
+    IREE_RETURN_IF_ERROR(iree_trace_binary_file_open(
+        registration->file_path.data, iree_allocator_system(), &binary_file));
+  }
 
-  // Load YAML file and setup replay state with all modules loaded and ready.
-  iree_replay_benchmark_call_list_t call_list;
-  iree_replay_benchmark_call_list_initialize(&call_list);
-  IREE_RETURN_IF_ERROR(iree_replay_benchmark_load_trace(registration->file_path,
-                                                        &replay, &call_list));
+  // Concurrent streams share one device so that they contend for it.
+  iree_host_size_t stream_count =
+      (iree_host_size_t)iree_max(1, FLAG_replay_streams);
+  iree_hal_device_t* shared_device = NULL;
+  if (stream_count > 1) {
+    IREE_RETURN_IF_ERROR(
+        iree_replay_benchmark_create_shared_device(&shared_device));
+  }
+
+  // Setup replay state for each stream with all modules loaded and ready.
+  iree_replay_benchmark_stream_t* stream_list =
+      (iree_replay_benchmark_stream_t*)calloc(stream_count,
+                                              sizeof(*stream_list));
+  for (iree_host_size_t i = 0; i < stream_count; ++i) {
+    IREE_RETURN_IF_ERROR(iree_replay_benchmark_stream_initialize(
+        registration, is_binary ? &binary_file : NULL, shared_device,
+        &stream_list[i]));
+  }
+  iree_replay_benchmark_streams_t streams;
+  IREE_RETURN_IF_ERROR(iree_replay_benchmark_streams_initialize(
+      stream_count, stream_list, &streams));
 
-  // Call the functions within the trace in order.
+  // Call the functions within the trace in order on every stream.
   while (iree_benchmark_keep_running(benchmark_state,
                                      /*batch_count=*/FLAG_call_iterations)) {
-    for (size_t i = 0; i < call_list.count; ++i) {
-      iree_replay_benchmark_call_t* call = &call_list.items[i];
-      for (int32_t j = 0; j < FLAG_call_iterations; ++j) {
-        IREE_RETURN_IF_ERROR(iree_vm_invoke(replay.context, call->function,
-                                            /*policy=*/NULL, call->input_list,
-                                            call->output_list,
-                                            replay.host_allocator));
-        IREE_RETURN_IF_ERROR(iree_vm_list_resize(call->output_list, 0));
-      }
-    }
+    IREE_RETURN_IF_ERROR(
+        iree_replay_benchmark_streams_run(&streams, &stream_list[0]));
   }
 
-  iree_replay_benchmark_call_list_deinitialize(&call_list);
-  iree_trace_replay_deinitialize(&replay);
+  iree_replay_benchmark_streams_deinitialize(&streams);
+  for (iree_host_size_t i = 0; i < stream_count; ++i) {
+    iree_replay_benchmark_stream_deinitialize(&stream_list[i]);
+  }
+  free(stream_list);
+  iree_hal_device_release(shared_device);
+  if (is_binary) iree_trace_binary_file_close(&binary_file);
   return iree_ok_status();
 }
 
@@ -262,7 +537,8 @@ int main(int argc, char** argv) {
   iree_benchmark_initialize(&argc, argv);
   if (argc <= 1) {
     fprintf(stderr,
-            "no trace files provided; pass one or more yaml file paths");
+            "no trace files provided; pass one or more yaml or binary trace "
+            "file paths");
     return 1;
   }
 
@@ -4,28 +4,170 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <string>
 #include <utility>
 
 #include "iree/base/api.h"
 #include "iree/base/internal/file_io.h"
+#include "iree/base/internal/flatcc.h"
+#include "iree/base/internal/math.h"
 #include "iree/schemas/bytecode_module_def_json_printer.h"
+#include "iree/schemas/bytecode_module_def_reader.h"
+#include "iree/schemas/bytecode_module_def_verifier.h"
 #include "iree/tools/utils/vm_util.h"
+#include "iree/vm/api.h"
 
-// Today we just print to JSON. We could do something more useful (size
-// analysis, etc), but JSON should be enough.
+// Returns the bytes of register storage the bytecode interpreter reserves in
+// each stack frame of a function with the given register counts. This mirrors
+// the rounding performed in iree_vm_bytecode_function_enter so that the
+// reported sizes match what will be allocated at runtime.
+static iree_host_size_t CalculateFrameRegisterSize(
+    uint32_t i32_register_count, uint32_t ref_register_count) {
+  i32_register_count =
+      iree_math_round_up_to_pow2_u32(iree_max(1u, i32_register_count));
+  ref_register_count =
+      iree_math_round_up_to_pow2_u32(iree_max(1u, ref_register_count));
+  return iree_host_align(i32_register_count * sizeof(int32_t), 16) +
+         iree_host_align(ref_register_count * sizeof(iree_vm_ref_t), 16);
+}
+
+// Prints a per-function table of bytecode and frame sizes. Useful for tracking
+// the impact of compiler changes (such as register allocation) on the amount
+// of stack and code each function requires.
+static int PrintFunctionStats(const std::string& module_contents) {
+  if (iree_vm_BytecodeModuleDef_verify_as_root(module_contents.data(),
+                                               module_contents.size()) != 0) {
+    std::cerr << "Module flatbuffer failed verification\n";
+    return 1;
+  }
+  iree_vm_BytecodeModuleDef_table_t module_def =
+      iree_vm_BytecodeModuleDef_as_root(module_contents.data());
+  iree_vm_InternalFunctionDef_vec_t internal_functions =
+      iree_vm_BytecodeModuleDef_internal_functions(module_def);
+  iree_vm_FunctionDescriptor_vec_t function_descriptors =
+      iree_vm_BytecodeModuleDef_function_descriptors(module_def);
+  size_t function_count =
+      iree_vm_FunctionDescriptor_vec_len(function_descriptors);
+
+  fprintf(stdout, "%8s %10s %8s %8s %11s  %s\n", "ordinal", "bytecode",
+          "i32 regs", "ref regs", "frame bytes", "name");
+  size_t total_bytecode_length = 0;
+  size_t max_frame_size = 0;
+  for (size_t i = 0; i < function_count; ++i) {
+    iree_vm_FunctionDescriptor_struct_t function_descriptor =
+        iree_vm_FunctionDescriptor_vec_at(function_descriptors, i);
+    flatbuffers_string_t local_name = nullptr;
+    if (i < iree_vm_InternalFunctionDef_vec_len(internal_functions)) {
+      local_name = iree_vm_InternalFunctionDef_local_name(
+          iree_vm_InternalFunctionDef_vec_at(internal_functions, i));
+    }
+    int32_t bytecode_length = function_descriptor->bytecode_length;
+    int16_t i32_register_count = function_descriptor->i32_register_count;
+    int16_t ref_register_count = function_descriptor->ref_register_count;
+    size_t frame_size =
+        CalculateFrameRegisterSize(i32_register_count, ref_register_count);
+    fprintf(stdout, "%8zu %10d %8d %8d %11zu  %.*s\n", i, bytecode_length,
+            i32_register_count, ref_register_count, frame_size,
+            (int)flatbuffers_string_len(local_name),
+            local_name ? local_name : "");
+    total_bytecode_length += bytecode_length;
+    max_frame_size = iree_max(max_frame_size, frame_size);
+  }
+  fprintf(stdout, "%zu functions, %zu bytecode bytes, %zu max frame bytes\n",
+          function_count, total_bytecode_length, max_frame_size);
+  return 0;
+}
+
+// Returns the value of the reflection attribute |key| in |signature_def| or
+// nullptr if not present.
+static const char* LookupReflectionAttr(
+    iree_vm_FunctionSignatureDef_table_t signature_def, const char* key) {
+  iree_vm_ReflectionAttrDef_vec_t attrs =
+      iree_vm_FunctionSignatureDef_reflection_attrs(signature_def);
+  for (size_t i = 0; i < iree_vm_ReflectionAttrDef_vec_len(attrs); ++i) {
+    iree_vm_ReflectionAttrDef_table_t attr =
+        iree_vm_ReflectionAttrDef_vec_at(attrs, i);
+    flatbuffers_string_t attr_key = iree_vm_ReflectionAttrDef_key(attr);
+    if (attr_key && strcmp(attr_key, key) == 0) {
+      return iree_vm_ReflectionAttrDef_value(attr);
+    }
+  }
+  return nullptr;
+}
+
+// Prints the static cost estimates the compiler recorded for each exported
+// dispatch benchmark function (see -iree-flow-export-benchmark-funcs). The
+// arithmetic intensity (ops per byte) places each dispatch on a roofline plot
+// without needing to run it.
+static int PrintDispatchStats(const std::string& module_contents) {
+  if (iree_vm_BytecodeModuleDef_verify_as_root(module_contents.data(),
+                                               module_contents.size()) != 0) {
+    std::cerr << "Module flatbuffer failed verification\n";
+    return 1;
+  }
+  iree_vm_BytecodeModuleDef_table_t module_def =
+      iree_vm_BytecodeModuleDef_as_root(module_contents.data());
+  iree_vm_ExportFunctionDef_vec_t exported_functions =
+      iree_vm_BytecodeModuleDef_exported_functions(module_def);
+
+  fprintf(stdout, "%16s %16s %10s  %s\n", "ops", "bytes", "ops/byte",
+          "dispatch");
+  size_t dispatch_count = 0;
+  for (size_t i = 0; i < iree_vm_ExportFunctionDef_vec_len(exported_functions);
+       ++i) {
+    iree_vm_ExportFunctionDef_table_t export_def =
+        iree_vm_ExportFunctionDef_vec_at(exported_functions, i);
+    iree_vm_FunctionSignatureDef_table_t signature_def =
+        iree_vm_ExportFunctionDef_signature(export_def);
+    if (!signature_def) continue;
+    const char* benchmark = LookupReflectionAttr(signature_def, "benchmark");
+    if (!benchmark || strcmp(benchmark, "dispatch") != 0) continue;
+    const char* ops = LookupReflectionAttr(signature_def, "ops");
+    const char* bytes = LookupReflectionAttr(signature_def, "bytes");
+    double op_count = ops ? strtod(ops, nullptr) : 0.0;
+    double byte_count = bytes ? strtod(bytes, nullptr) : 0.0;
+    char intensity[32] = "-";
+    if (ops && byte_count > 0.0) {
+      snprintf(intensity, sizeof(intensity), "%.2f", op_count / byte_count);
+    }
+    fprintf(stdout, "%16s %16s %10s  %s\n", ops ? ops : "-",
+            bytes ? bytes : "-", intensity,
+            iree_vm_ExportFunctionDef_local_name(export_def));
+    ++dispatch_count;
+  }
+  fprintf(stdout, "%zu dispatches\n", dispatch_count);
+  return 0;
+}
+
+// By default we just print to JSON. Passing --function_stats instead prints a
+// size summary of each function (bytecode length and frame register sizes)
+// and --dispatch_stats prints the static cost estimates of each exported
+// dispatch benchmark function.
 //
 // We could also move all of this into iree-translate (mlir -> vmfb -> json),
 // though having a tiny little tool not reliant on LLVM is nice (can run this
 // on a device).
 extern "C" int main(int argc, char** argv) {
-  if (argc < 2) {
-    std::cerr << "Syntax: iree-dump-module module.vmfb > module.json\n";
+  bool function_stats = argc > 1 && strcmp(argv[1], "--function_stats") == 0;
+  bool dispatch_stats = argc > 1 && strcmp(argv[1], "--dispatch_stats") == 0;
+  int path_index = (function_stats || dispatch_stats) ? 2 : 1;
+  if (argc < path_index + 1) {
+    std::cerr << "Syntax: iree-dump-module module.vmfb > module.json\n"
+              << "        iree-dump-module --function_stats module.vmfb\n"
+              << "        iree-dump-module --dispatch_stats module.vmfb\n";
     return 1;
   }
   std::string module_contents;
-  IREE_CHECK_OK(iree::GetFileContents(argv[1], &module_contents));
+  IREE_CHECK_OK(iree::GetFileContents(argv[path_index], &module_contents));
+  if (function_stats) {
+    return PrintFunctionStats(module_contents);
+  } else if (dispatch_stats) {
+    return PrintDispatchStats(module_contents);
+  }
 
   // Print direct to stdout.
   flatcc_json_printer_t printer;
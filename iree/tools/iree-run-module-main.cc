@@ -6,8 +6,8 @@
 
 #include <array>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
-#include <iterator>
 #include <string>
 #include <utility>
 #include <vector>
@@ -35,6 +35,14 @@ IREE_FLAG(string, entry_function, "",
 
 IREE_FLAG(string, driver, "vmvx", "Backend driver to use.");
 
+IREE_FLAG(bool, print_memory_statistics, false,
+          "Prints the peak and live bytes of the buffers allocated from the\n"
+          "device allocator per memory type after the function completes.");
+IREE_FLAG(string, memory_timeline_file, "",
+          "Writes the device allocator memory usage sampled after each phase\n"
+          "of the run (device creation, input parsing, invocation, and\n"
+          "result printing) as a Chrome trace JSON file at the given path.");
+
 static iree_status_t parse_function_input(iree_string_view_t flag_name,
                                           void* storage,
                                           iree_string_view_t value) {
@@ -63,24 +71,24 @@ IREE_FLAG_CALLBACK(
     "  2x2xi32=1 2 3 4\n"
     "Optionally, brackets may be used to separate the element values:\n"
     "  2x2xi32=[[1 2][3 4]]\n"
+    "Buffers may also be loaded from .npy files or raw binary files:\n"
+    "  @input.npy\n"
+    "  2x2xi32=@input.bin\n"
     "Each occurrence of the flag indicates an input in the order they were\n"
     "specified on the command line.");
 
+static std::vector<std::string> FLAG_function_outputs;
+IREE_FLAG_CALLBACK(
+    parse_function_input, print_function_input, &FLAG_function_outputs,
+    function_output,
+    "A file to write the corresponding result buffer to instead of printing\n"
+    "its contents. Paths ending in .npy are written as numpy arrays and all\n"
+    "others as raw binary data. Each occurrence of the flag corresponds to a\n"
+    "result in order; empty values print the result as usual.");
+
 namespace iree {
 namespace {
 
-iree_status_t GetModuleContentsFromFlags(std::string* out_contents) {
-  IREE_TRACE_SCOPE0("GetModuleContentsFromFlags");
-  auto module_file = std::string(FLAG_module_file);
-  if (module_file == "-") {
-    *out_contents = std::string{std::istreambuf_iterator<char>(std::cin),
-                                std::istreambuf_iterator<char>()};
-  } else {
-    IREE_RETURN_IF_ERROR(GetFileContents(module_file.c_str(), out_contents));
-  }
-  return iree_ok_status();
-}
-
 iree_status_t Run() {
   IREE_TRACE_SCOPE0("iree-run-module");
 
@@ -91,15 +99,14 @@ iree_status_t Run() {
       iree_vm_instance_create(iree_allocator_system(), &instance),
       "creating instance");
 
-  std::string module_data;
-  IREE_RETURN_IF_ERROR(GetModuleContentsFromFlags(&module_data));
   iree_vm_module_t* input_module = nullptr;
-  IREE_RETURN_IF_ERROR(iree_vm_bytecode_module_create(
-      iree_make_const_byte_span((void*)module_data.data(), module_data.size()),
-      iree_allocator_null(), iree_allocator_system(), &input_module));
+  IREE_RETURN_IF_ERROR(LoadBytecodeModule(
+      FLAG_module_file, iree_allocator_system(), &input_module));
 
   iree_hal_device_t* device = nullptr;
   IREE_RETURN_IF_ERROR(CreateDevice(FLAG_driver, &device));
+  AllocationTimeline timeline(iree_hal_device_allocator(device));
+  timeline.Record("create_device");
   iree_vm_module_t* hal_module = nullptr;
   IREE_RETURN_IF_ERROR(
       iree_hal_module_create(device, iree_allocator_system(), &hal_module));
@@ -132,6 +139,7 @@ iree_status_t Run() {
       iree::span<const std::string>{FLAG_function_inputs.data(),
                                     FLAG_function_inputs.size()},
       &inputs));
+  timeline.Record("parse_inputs");
 
   vm::ref<iree_vm_list_t> outputs;
   IREE_RETURN_IF_ERROR(iree_vm_list_create(/*element_type=*/nullptr, 16,
@@ -142,11 +150,28 @@ iree_status_t Run() {
       iree_vm_invoke(context, function, /*policy=*/nullptr, inputs.get(),
                      outputs.get(), iree_allocator_system()),
       "invoking function '%s'", function_name.c_str());
+  timeline.Record("invoke @" + function_name);
 
-  IREE_RETURN_IF_ERROR(PrintVariantList(outputs.get()), "printing results");
+  IREE_RETURN_IF_ERROR(
+      PrintVariantList(outputs.get(),
+                       iree::span<const std::string>{
+                           FLAG_function_outputs.data(),
+                           FLAG_function_outputs.size()}),
+      "printing results");
+  timeline.Record("print_results");
 
   inputs.reset();
   outputs.reset();
+  timeline.Record("release_results");
+  if (FLAG_print_memory_statistics) {
+    IREE_RETURN_IF_ERROR(
+        PrintAllocatorStatistics(iree_hal_device_allocator(device)));
+  }
+  if (strlen(FLAG_memory_timeline_file) > 0) {
+    IREE_RETURN_IF_ERROR(timeline.WriteChromeTrace(FLAG_memory_timeline_file),
+                         "writing memory timeline '%s'",
+                         FLAG_memory_timeline_file);
+  }
   iree_vm_module_release(hal_module);
   iree_vm_module_release(input_module);
   iree_hal_device_release(device);
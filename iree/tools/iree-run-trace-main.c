@@ -19,16 +19,24 @@
 
 IREE_FLAG(string, driver, "vmvx", "Backend driver to use.");
 
+IREE_FLAG(string, record_binary_trace, "",
+          "Records the replayed YAML trace with its call inputs into a binary "
+          "trace at the given path for use with iree-benchmark-trace. Module "
+          "paths are recorded as written so the binary trace should be placed "
+          "in the same directory as the YAML trace.");
+
 // Runs the trace in |file| using |root_path| as the base for any path lookups
 // required for external files referenced in |file|.
 static iree_status_t iree_run_trace_file(iree_string_view_t root_path,
                                          FILE* file,
-                                         iree_vm_instance_t* instance) {
+                                         iree_vm_instance_t* instance,
+                                         iree_trace_binary_writer_t* recorder) {
   iree_trace_replay_t replay;
   IREE_RETURN_IF_ERROR(iree_trace_replay_initialize(
       root_path, instance, iree_allocator_system(), &replay));
   iree_trace_replay_set_hal_driver_override(
       &replay, iree_make_cstring_view(FLAG_driver));
+  iree_trace_replay_set_recorder(&replay, recorder);
 
   yaml_parser_t parser;
   if (!yaml_parser_initialize(&parser)) {
@@ -60,20 +68,54 @@ static iree_status_t iree_run_trace_file(iree_string_view_t root_path,
   return status;
 }
 
+// Runs the binary trace at |file_path| using |root_path| as the base for any
+// module paths referenced in the trace.
+static iree_status_t iree_run_binary_trace_file(iree_string_view_t root_path,
+                                                const char* file_path,
+                                                iree_vm_instance_t* instance) {
+  iree_trace_binary_file_t file;
+  IREE_RETURN_IF_ERROR(
+      iree_trace_binary_file_open(file_path, iree_allocator_system(), &file));
+  iree_trace_replay_t replay;
+  iree_status_t status = iree_trace_replay_initialize(
+      root_path, instance, iree_allocator_system(), &replay);
+  if (iree_status_is_ok(status)) {
+    iree_trace_replay_set_hal_driver_override(
+        &replay, iree_make_cstring_view(FLAG_driver));
+    for (uint32_t i = 0; i < file.header->event_count; ++i) {
+      status = iree_trace_replay_binary_event(&replay, &file, &file.events[i]);
+      if (!iree_status_is_ok(status)) break;
+    }
+    iree_trace_replay_deinitialize(&replay);
+  }
+  iree_trace_binary_file_close(&file);
+  return status;
+}
+
 // Runs each of the given traces files sequentially in isolated contexts.
-static iree_status_t iree_run_trace_files(int file_count, char** file_paths,
-                                          iree_vm_instance_t* instance) {
+static iree_status_t iree_run_trace_files(
+    int file_count, char** file_paths, iree_vm_instance_t* instance,
+    iree_trace_binary_writer_t* recorder) {
   for (int i = 0; i < file_count; ++i) {
     iree_string_view_t file_path = iree_make_cstring_view(file_paths[i]);
     iree_string_view_t root_path = iree_file_path_dirname(file_path);
-    FILE* file = fopen(file_paths[i], "rb");
-    if (!file) {
-      return iree_make_status(iree_status_code_from_errno(errno),
-                              "failed to open trace file '%.*s'",
-                              (int)file_path.size, file_path.data);
+    iree_status_t status = iree_ok_status();
+    if (iree_trace_binary_file_is_binary(file_paths[i])) {
+      if (recorder) {
+        return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "binary traces cannot be recorded again");
+      }
+      status = iree_run_binary_trace_file(root_path, file_paths[i], instance);
+    } else {
+      FILE* file = fopen(file_paths[i], "rb");
+      if (!file) {
+        return iree_make_status(iree_status_code_from_errno(errno),
+                                "failed to open trace file '%.*s'",
+                                (int)file_path.size, file_path.data);
+      }
+      status = iree_run_trace_file(root_path, file, instance, recorder);
+      fclose(file);
     }
-    iree_status_t status = iree_run_trace_file(root_path, file, instance);
-    fclose(file);
     IREE_RETURN_IF_ERROR(status, "replaying trace file '%.*s'",
                          (int)file_path.size, file_path.data);
   }
@@ -87,6 +129,11 @@ int main(int argc, char** argv) {
             "no trace files provided; pass one or more yaml file paths");
     return 1;
   }
+  bool record = strlen(FLAG_record_binary_trace) > 0;
+  if (record && argc != 2) {
+    fprintf(stderr, "--record_binary_trace= requires a single trace file");
+    return 1;
+  }
 
   iree_vm_instance_t* instance = NULL;
   iree_status_t status =
@@ -94,7 +141,15 @@ int main(int argc, char** argv) {
   if (iree_status_is_ok(status)) {
     IREE_CHECK_OK(iree_hal_register_all_available_drivers(
         iree_hal_driver_registry_default()));
-    status = iree_run_trace_files(argc - 1, argv + 1, instance);
+    iree_trace_binary_writer_t recorder;
+    iree_trace_binary_writer_initialize(iree_allocator_system(), &recorder);
+    status = iree_run_trace_files(argc - 1, argv + 1, instance,
+                                  record ? &recorder : NULL);
+    if (iree_status_is_ok(status) && record) {
+      status = iree_trace_binary_writer_write_file(&recorder,
+                                                   FLAG_record_binary_trace);
+    }
+    iree_trace_binary_writer_deinitialize(&recorder);
   }
   iree_vm_instance_release(instance);
   if (!iree_status_is_ok(status)) {
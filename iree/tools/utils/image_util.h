@@ -7,6 +7,8 @@
 #ifndef IREE_TOOLS_UTILS_IMAGE_UTIL_H_
 #define IREE_TOOLS_UTILS_IMAGE_UTIL_H_
 
+#include <stdbool.h>
+
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
 #include "iree/hal/buffer_view.h"
@@ -56,6 +58,60 @@ iree_status_t iree_tools_utils_buffer_view_from_image_rescaled(
     iree_hal_allocator_t* allocator, const float* input_range,
     iree_host_size_t range_length, iree_hal_buffer_view_t** out_buffer_view);
 
+// Channel layout of image tensors.
+typedef enum iree_tools_utils_pixel_layout_e {
+  // Interleaved channels as stored in image files: [batch x] height x width x
+  // channel (NHWC).
+  IREE_TOOLS_UTILS_PIXEL_LAYOUT_HWC = 0,
+  // Planar channels: [batch x] channel x height x width (NCHW).
+  IREE_TOOLS_UTILS_PIXEL_LAYOUT_CHW = 1,
+} iree_tools_utils_pixel_layout_t;
+
+// Maximum number of channels supported by pixel normalization.
+#define IREE_TOOLS_UTILS_PIXEL_MAX_CHANNEL_COUNT 4
+
+// Per-channel affine normalization of uint8_t pixels to float:
+//   float32_x = uint8_x * scale[c] + bias[c]
+// For the common (x / 255 - mean[c]) / stddev[c] normalization use
+// scale[c] = 1 / (255 * stddev[c]) and bias[c] = -mean[c] / stddev[c].
+typedef struct iree_tools_utils_pixel_normalization_t {
+  // Number of interleaved channels in the source pixels, at most
+  // IREE_TOOLS_UTILS_PIXEL_MAX_CHANNEL_COUNT.
+  iree_host_size_t channel_count;
+  // Scale applied to each channel of the source pixels.
+  float scale[IREE_TOOLS_UTILS_PIXEL_MAX_CHANNEL_COUNT];
+  // Bias added to each channel after scaling.
+  float bias[IREE_TOOLS_UTILS_PIXEL_MAX_CHANNEL_COUNT];
+  // Layout of the output buffer. Source pixels are always interleaved.
+  iree_tools_utils_pixel_layout_t layout;
+  // Reverses the order of the channels in the output (such as RGB->BGR).
+  bool reverse_channels;
+} iree_tools_utils_pixel_normalization_t;
+
+// Normalizes |pixel_count| interleaved uint8_t pixels of
+// |normalization->channel_count| channels each in |pixel_data| into the float
+// buffer |out_buffer| in the requested layout. The loops are specialized per
+// channel count so that compilers can vectorize the strided channel accesses.
+//
+// |out_buffer| needs to be allocated before the call with room for
+// |pixel_count| * channel_count floats.
+iree_status_t iree_tools_utils_pixel_normalize_to_buffer(
+    const uint8_t* pixel_data, iree_host_size_t pixel_count,
+    const iree_tools_utils_pixel_normalization_t* normalization,
+    float* out_buffer);
+
+// Parse the content in an image file in |filename| into a FLOAT_32 HAL buffer
+// view |out_buffer_view| normalized with |normalization|. |shape| must be in
+// the order given by |normalization->layout| (such as 1x3x224x224 for CHW) and
+// the channel count must match the image.
+//
+// The returned |out_buffer_view| must be released by the caller.
+iree_status_t iree_tools_utils_buffer_view_from_image_normalized(
+    const iree_string_view_t filename, const iree_hal_dim_t* shape,
+    iree_host_size_t shape_rank,
+    const iree_tools_utils_pixel_normalization_t* normalization,
+    iree_hal_allocator_t* allocator, iree_hal_buffer_view_t** out_buffer_view);
+
 // Normalize uint8_t |pixel data| of the size |buffer_length| to float buffer
 // |out_buffer| with the range |input_range|.
 //
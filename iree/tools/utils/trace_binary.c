@@ -0,0 +1,395 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/tools/utils/trace_binary.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "iree/base/internal/file_io.h"
+#include "iree/base/tracing.h"
+#include "iree/modules/hal/module.h"
+
+//===----------------------------------------------------------------------===//
+// iree_trace_binary_file_t
+//===----------------------------------------------------------------------===//
+
+bool iree_trace_binary_file_is_binary(const char* path) {
+  FILE* file = fopen(path, "rb");
+  if (!file) return false;
+  uint32_t magic = 0;
+  bool is_binary = fread(&magic, sizeof(magic), 1, file) == 1 &&
+                   magic == IREE_TRACE_BINARY_MAGIC;
+  fclose(file);
+  return is_binary;
+}
+
+static iree_status_t iree_trace_binary_file_verify(
+    const iree_trace_binary_file_t* file) {
+  iree_host_size_t length = file->contents.data_length;
+  const iree_trace_binary_header_t* header = file->header;
+  if (length < sizeof(*header) || header->magic != IREE_TRACE_BINARY_MAGIC) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "not a binary trace file");
+  }
+  if (header->version != IREE_TRACE_BINARY_VERSION) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "unsupported binary trace version %u",
+                            header->version);
+  }
+  if (header->file_length != length ||
+      header->event_offset % sizeof(uint64_t) != 0 ||
+      header->event_offset > length ||
+      header->event_count > (length - header->event_offset) /
+                                sizeof(iree_trace_binary_event_t) ||
+      header->value_offset % sizeof(uint64_t) != 0 ||
+      header->value_offset > length ||
+      header->value_count > (length - header->value_offset) /
+                                sizeof(iree_trace_binary_value_t)) {
+    return iree_make_status(IREE_STATUS_DATA_LOSS,
+                            "binary trace tables out of bounds");
+  }
+
+  // Verify all references once here so that replay can trust the file.
+  for (uint32_t i = 0; i < header->event_count; ++i) {
+    const iree_trace_binary_event_t* event = &file->events[i];
+    if (event->string_offset > length ||
+        event->string_length > length - event->string_offset ||
+        event->value_index > header->value_count ||
+        event->value_count > header->value_count - event->value_index) {
+      return iree_make_status(IREE_STATUS_DATA_LOSS,
+                              "binary trace event %u out of bounds", i);
+    }
+  }
+  for (uint32_t i = 0; i < header->value_count; ++i) {
+    const iree_trace_binary_value_t* value = &file->values[i];
+    if (value->kind != IREE_TRACE_BINARY_VALUE_BUFFER_VIEW) continue;
+    if (value->shape_rank > IREE_TRACE_BINARY_MAX_RANK ||
+        value->payload_offset > length ||
+        value->payload_length > length - value->payload_offset) {
+      return iree_make_status(IREE_STATUS_DATA_LOSS,
+                              "binary trace value %u out of bounds", i);
+    }
+  }
+  return iree_ok_status();
+}
+
+iree_status_t iree_trace_binary_file_open(const char* path,
+                                          iree_allocator_t host_allocator,
+                                          iree_trace_binary_file_t* out_file) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  memset(out_file, 0, sizeof(*out_file));
+  out_file->host_allocator = host_allocator;
+
+  // Prefer mapping so that payloads are paged in lazily and can be imported
+  // into HAL buffers without a copy; fall back to reading the file.
+  iree_status_t status = iree_file_map(path, IREE_FILE_MAP_HINT_NONE,
+                                       host_allocator, &out_file->mapping);
+  if (iree_status_is_ok(status)) {
+    iree_const_byte_span_t contents =
+        iree_file_mapping_contents(out_file->mapping);
+    if (contents.data_length == 0) {
+      status = iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "trace file '%s' is empty", path);
+    }
+    // The mapping is read-only; payloads are only ever imported as read-only
+    // buffers.
+    out_file->contents =
+        iree_make_byte_span((void*)contents.data, contents.data_length);
+  } else if (iree_status_is_unavailable(status)) {
+    iree_status_ignore(status);
+    status =
+        iree_file_read_contents(path, host_allocator, &out_file->contents);
+  }
+
+  if (iree_status_is_ok(status)) {
+    uint8_t* base = out_file->contents.data;
+    out_file->header = (const iree_trace_binary_header_t*)base;
+    if (out_file->contents.data_length >= sizeof(*out_file->header)) {
+      out_file->events = (const iree_trace_binary_event_t*)(
+          base + out_file->header->event_offset);
+      out_file->values = (const iree_trace_binary_value_t*)(
+          base + out_file->header->value_offset);
+    }
+    status = iree_trace_binary_file_verify(out_file);
+  }
+
+  if (!iree_status_is_ok(status)) {
+    iree_trace_binary_file_close(out_file);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+void iree_trace_binary_file_close(iree_trace_binary_file_t* file) {
+  if (file->mapping) {
+    iree_file_unmap(file->mapping);
+  } else {
+    iree_allocator_free(file->host_allocator, file->contents.data);
+  }
+  memset(file, 0, sizeof(*file));
+}
+
+iree_string_view_t iree_trace_binary_event_string(
+    const iree_trace_binary_file_t* file,
+    const iree_trace_binary_event_t* event) {
+  return iree_make_string_view(
+      (const char*)file->contents.data + event->string_offset,
+      event->string_length);
+}
+
+iree_byte_span_t iree_trace_binary_value_payload(
+    const iree_trace_binary_file_t* file,
+    const iree_trace_binary_value_t* value) {
+  return iree_make_byte_span(file->contents.data + value->payload_offset,
+                             (iree_host_size_t)value->payload_length);
+}
+
+//===----------------------------------------------------------------------===//
+// iree_trace_binary_writer_t
+//===----------------------------------------------------------------------===//
+
+void iree_trace_binary_writer_initialize(
+    iree_allocator_t host_allocator, iree_trace_binary_writer_t* out_writer) {
+  memset(out_writer, 0, sizeof(*out_writer));
+  out_writer->host_allocator = host_allocator;
+}
+
+void iree_trace_binary_writer_deinitialize(iree_trace_binary_writer_t* writer) {
+  iree_allocator_free(writer->host_allocator, writer->events);
+  iree_allocator_free(writer->host_allocator, writer->values);
+  iree_allocator_free(writer->host_allocator, writer->strings);
+  iree_allocator_free(writer->host_allocator, writer->payloads);
+  memset(writer, 0, sizeof(*writer));
+}
+
+// Grows |*inout_ptr| to hold at least |minimum_count| elements.
+static iree_status_t iree_trace_binary_writer_reserve(
+    iree_allocator_t host_allocator, iree_host_size_t element_size,
+    iree_host_size_t minimum_count, iree_host_size_t* inout_capacity,
+    void** inout_ptr) {
+  if (minimum_count <= *inout_capacity) return iree_ok_status();
+  iree_host_size_t new_capacity = iree_max(*inout_capacity * 2, 16);
+  new_capacity = iree_max(new_capacity, minimum_count);
+  IREE_RETURN_IF_ERROR(iree_allocator_realloc(
+      host_allocator, new_capacity * element_size, inout_ptr));
+  *inout_capacity = new_capacity;
+  return iree_ok_status();
+}
+
+static iree_status_t iree_trace_binary_writer_append_event(
+    iree_trace_binary_writer_t* writer, iree_trace_binary_event_type_t type,
+    iree_string_view_t string, iree_trace_binary_event_t** out_event) {
+  IREE_RETURN_IF_ERROR(iree_trace_binary_writer_reserve(
+      writer->host_allocator, sizeof(*writer->events), writer->event_count + 1,
+      &writer->event_capacity, (void**)&writer->events));
+  IREE_RETURN_IF_ERROR(iree_trace_binary_writer_reserve(
+      writer->host_allocator, 1, writer->string_length + string.size,
+      &writer->string_capacity, (void**)&writer->strings));
+  iree_trace_binary_event_t* event = &writer->events[writer->event_count++];
+  memset(event, 0, sizeof(*event));
+  event->type = type;
+  event->string_offset = writer->string_length;
+  event->string_length = (uint32_t)string.size;
+  event->value_index = (uint32_t)writer->value_count;
+  if (string.size) {
+    memcpy(writer->strings + writer->string_length, string.data, string.size);
+  }
+  writer->string_length += string.size;
+  if (out_event) *out_event = event;
+  return iree_ok_status();
+}
+
+iree_status_t iree_trace_binary_writer_append_context_load(
+    iree_trace_binary_writer_t* writer) {
+  return iree_trace_binary_writer_append_event(
+      writer, IREE_TRACE_BINARY_EVENT_CONTEXT_LOAD, iree_string_view_empty(),
+      NULL);
+}
+
+iree_status_t iree_trace_binary_writer_append_hal_module_load(
+    iree_trace_binary_writer_t* writer, iree_string_view_t driver) {
+  return iree_trace_binary_writer_append_event(
+      writer, IREE_TRACE_BINARY_EVENT_MODULE_LOAD_HAL, driver, NULL);
+}
+
+iree_status_t iree_trace_binary_writer_append_bytecode_module_load(
+    iree_trace_binary_writer_t* writer, iree_string_view_t path) {
+  return iree_trace_binary_writer_append_event(
+      writer, IREE_TRACE_BINARY_EVENT_MODULE_LOAD_BYTECODE, path, NULL);
+}
+
+// Appends the contents of |buffer_view| to the payload data and describes it
+// in |value|.
+static iree_status_t iree_trace_binary_writer_append_buffer_view(
+    iree_trace_binary_writer_t* writer, iree_hal_buffer_view_t* buffer_view,
+    iree_trace_binary_value_t* value) {
+  iree_host_size_t shape_rank = iree_hal_buffer_view_shape_rank(buffer_view);
+  if (shape_rank > IREE_TRACE_BINARY_MAX_RANK) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "buffer view rank %zu exceeds the maximum of %d",
+                            shape_rank, IREE_TRACE_BINARY_MAX_RANK);
+  }
+  value->kind = IREE_TRACE_BINARY_VALUE_BUFFER_VIEW;
+  value->element_type = iree_hal_buffer_view_element_type(buffer_view);
+  value->encoding_type = iree_hal_buffer_view_encoding_type(buffer_view);
+  value->shape_rank = (uint32_t)shape_rank;
+  const iree_hal_dim_t* shape = iree_hal_buffer_view_shape_dims(buffer_view);
+  for (iree_host_size_t i = 0; i < shape_rank; ++i) {
+    value->shape[i] = shape[i];
+  }
+
+  iree_host_size_t byte_length =
+      (iree_host_size_t)iree_hal_buffer_view_byte_length(buffer_view);
+  iree_host_size_t payload_offset = iree_host_align(
+      writer->payload_length, IREE_TRACE_BINARY_PAYLOAD_ALIGNMENT);
+  IREE_RETURN_IF_ERROR(iree_trace_binary_writer_reserve(
+      writer->host_allocator, 1, payload_offset + byte_length,
+      &writer->payload_capacity, (void**)&writer->payloads));
+  memset(writer->payloads + writer->payload_length, 0,
+         payload_offset - writer->payload_length);
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_read_data(
+      iree_hal_buffer_view_buffer(buffer_view), 0,
+      writer->payloads + payload_offset, byte_length));
+  value->payload_offset = payload_offset;
+  value->payload_length = byte_length;
+  writer->payload_length = payload_offset + byte_length;
+  return iree_ok_status();
+}
+
+iree_status_t iree_trace_binary_writer_append_call(
+    iree_trace_binary_writer_t* writer, iree_string_view_t function_name,
+    iree_vm_list_t* input_list) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_host_size_t input_count = iree_vm_list_size(input_list);
+  iree_status_t status = iree_trace_binary_writer_reserve(
+      writer->host_allocator, sizeof(*writer->values),
+      writer->value_count + input_count, &writer->value_capacity,
+      (void**)&writer->values);
+  iree_trace_binary_event_t* event = NULL;
+  if (iree_status_is_ok(status)) {
+    status = iree_trace_binary_writer_append_event(
+        writer, IREE_TRACE_BINARY_EVENT_CALL, function_name, &event);
+  }
+  for (iree_host_size_t i = 0; i < input_count && iree_status_is_ok(status);
+       ++i) {
+    iree_trace_binary_value_t* value = &writer->values[writer->value_count];
+    memset(value, 0, sizeof(*value));
+    iree_vm_variant_t variant = iree_vm_variant_empty();
+    status = iree_vm_list_get_variant(input_list, i, &variant);
+    if (!iree_status_is_ok(status)) break;
+    if (iree_vm_variant_is_value(variant)) {
+      value->kind = IREE_TRACE_BINARY_VALUE_SCALAR;
+      value->value_type = variant.type.value_type;
+      memcpy(value->scalar_storage, variant.value_storage,
+             sizeof(value->scalar_storage));
+    } else if (iree_vm_variant_is_ref(variant) &&
+               iree_hal_buffer_view_isa(variant.ref)) {
+      status = iree_trace_binary_writer_append_buffer_view(
+          writer, iree_hal_buffer_view_deref(variant.ref), value);
+    } else if (iree_vm_variant_is_ref(variant) && variant.ref.ptr) {
+      status = iree_make_status(
+          IREE_STATUS_UNIMPLEMENTED,
+          "argument %zu of '%.*s' is a ref type binary traces cannot record",
+          i, (int)function_name.size, function_name.data);
+    }
+    if (iree_status_is_ok(status)) {
+      ++writer->value_count;
+      ++event->value_count;
+    }
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static iree_status_t iree_trace_binary_fwrite(FILE* file, const void* data,
+                                              iree_host_size_t length) {
+  if (length && fwrite(data, 1, length, file) != length) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "failed to write binary trace");
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_trace_binary_fpad(FILE* file,
+                                            iree_host_size_t length) {
+  static const uint8_t zeros[IREE_TRACE_BINARY_PAYLOAD_ALIGNMENT] = {0};
+  return iree_trace_binary_fwrite(file, zeros, length);
+}
+
+iree_status_t iree_trace_binary_writer_write_file(
+    iree_trace_binary_writer_t* writer, const char* path) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Compute the file layout; see trace_binary.h.
+  iree_host_size_t event_offset =
+      iree_host_align(sizeof(iree_trace_binary_header_t), sizeof(uint64_t));
+  iree_host_size_t value_offset =
+      event_offset + writer->event_count * sizeof(iree_trace_binary_event_t);
+  iree_host_size_t string_offset =
+      value_offset + writer->value_count * sizeof(iree_trace_binary_value_t);
+  iree_host_size_t payload_offset =
+      iree_host_align(string_offset + writer->string_length,
+                      IREE_TRACE_BINARY_PAYLOAD_ALIGNMENT);
+  iree_host_size_t file_length = payload_offset + writer->payload_length;
+
+  iree_trace_binary_header_t header;
+  memset(&header, 0, sizeof(header));
+  header.magic = IREE_TRACE_BINARY_MAGIC;
+  header.version = IREE_TRACE_BINARY_VERSION;
+  header.event_count = (uint32_t)writer->event_count;
+  header.value_count = (uint32_t)writer->value_count;
+  header.event_offset = event_offset;
+  header.value_offset = value_offset;
+  header.file_length = file_length;
+
+  FILE* file = fopen(path, "wb");
+  if (!file) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "failed to open '%s' for writing", path);
+  }
+  iree_status_t status =
+      iree_trace_binary_fwrite(file, &header, sizeof(header));
+  if (iree_status_is_ok(status)) {
+    status = iree_trace_binary_fpad(file, event_offset - sizeof(header));
+  }
+  // Rebase offsets from the writer-relative sections to the file.
+  for (iree_host_size_t i = 0;
+       i < writer->event_count && iree_status_is_ok(status); ++i) {
+    iree_trace_binary_event_t event = writer->events[i];
+    event.string_offset += string_offset;
+    status = iree_trace_binary_fwrite(file, &event, sizeof(event));
+  }
+  for (iree_host_size_t i = 0;
+       i < writer->value_count && iree_status_is_ok(status); ++i) {
+    iree_trace_binary_value_t value = writer->values[i];
+    if (value.kind == IREE_TRACE_BINARY_VALUE_BUFFER_VIEW) {
+      value.payload_offset += payload_offset;
+    }
+    status = iree_trace_binary_fwrite(file, &value, sizeof(value));
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_trace_binary_fwrite(file, writer->strings,
+                                      writer->string_length);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_trace_binary_fpad(
+        file, payload_offset - (string_offset + writer->string_length));
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_trace_binary_fwrite(file, writer->payloads,
+                                      writer->payload_length);
+  }
+  if (fclose(file) != 0 && iree_status_is_ok(status)) {
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "failed to close '%s'", path);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
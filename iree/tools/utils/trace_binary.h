@@ -0,0 +1,201 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_TOOLS_UTILS_TRACE_BINARY_H_
+#define IREE_TOOLS_UTILS_TRACE_BINARY_H_
+
+#include "iree/base/api.h"
+#include "iree/base/internal/file_io.h"
+#include "iree/hal/api.h"
+#include "iree/vm/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// Binary trace file format
+//===----------------------------------------------------------------------===//
+// A binary trace holds the same events as a YAML trace (see trace_replay.h) in
+// a form that can be mapped into memory and replayed without any parsing: all
+// tables are fixed-size little-endian structs addressed by file offsets and
+// tensor contents are stored out-of-line so that they can be wrapped in HAL
+// buffers directly from the mapped file.
+//
+// Layout:
+//   iree_trace_binary_header_t
+//   iree_trace_binary_event_t[event_count]   (at header.event_offset)
+//   iree_trace_binary_value_t[value_count]   (at header.value_offset)
+//   string data                              (referenced by events)
+//   payload data                             (each payload aligned to
+//                                             PAYLOAD_ALIGNMENT)
+//
+// Binary traces are produced with iree_trace_binary_writer_t, either by
+// recording a YAML trace as it is replayed (iree-run-trace
+// --record_binary_trace=) or by recording calls with real inputs directly from
+// an application.
+
+// 'IRTB' in little-endian.
+#define IREE_TRACE_BINARY_MAGIC 0x42545249u
+#define IREE_TRACE_BINARY_VERSION 0u
+
+// Alignment of tensor payloads in the file. Matches the alignment the HAL heap
+// allocators require for buffers to be imported without a copy.
+#define IREE_TRACE_BINARY_PAYLOAD_ALIGNMENT 64
+
+// Maximum rank of a recorded buffer view.
+#define IREE_TRACE_BINARY_MAX_RANK 8
+
+typedef struct iree_trace_binary_header_t {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t event_count;
+  uint32_t value_count;
+  uint64_t event_offset;
+  uint64_t value_offset;
+  uint64_t file_length;
+} iree_trace_binary_header_t;
+
+typedef enum iree_trace_binary_event_type_e {
+  // Resets the context; equivalent to the YAML `context_load` event.
+  IREE_TRACE_BINARY_EVENT_CONTEXT_LOAD = 0,
+  // Loads the builtin HAL module; the string is the driver name (or empty to
+  // use the driver override).
+  IREE_TRACE_BINARY_EVENT_MODULE_LOAD_HAL = 1,
+  // Loads a bytecode module; the string is the path of the module file joined
+  // with the directory of the trace file as with YAML traces.
+  IREE_TRACE_BINARY_EVENT_MODULE_LOAD_BYTECODE = 2,
+  // Calls a function; the string is the fully-qualified function name and the
+  // values are the arguments.
+  IREE_TRACE_BINARY_EVENT_CALL = 3,
+} iree_trace_binary_event_type_t;
+
+typedef struct iree_trace_binary_event_t {
+  uint32_t type;  // iree_trace_binary_event_type_t
+  uint32_t string_length;
+  uint64_t string_offset;
+  // Range of values in the value table; only used by calls.
+  uint32_t value_index;
+  uint32_t value_count;
+} iree_trace_binary_event_t;
+
+typedef enum iree_trace_binary_value_kind_e {
+  IREE_TRACE_BINARY_VALUE_NULL = 0,
+  // A primitive; |value_type| is an iree_vm_value_type_t and the value is
+  // stored in |scalar_storage|.
+  IREE_TRACE_BINARY_VALUE_SCALAR = 1,
+  // A !hal.buffer_view whose contents are stored in the payload range.
+  IREE_TRACE_BINARY_VALUE_BUFFER_VIEW = 2,
+} iree_trace_binary_value_kind_t;
+
+typedef struct iree_trace_binary_value_t {
+  uint32_t kind;  // iree_trace_binary_value_kind_t
+  uint32_t value_type;
+  uint32_t element_type;   // iree_hal_element_type_t
+  uint32_t encoding_type;  // iree_hal_encoding_type_t
+  uint32_t shape_rank;
+  uint32_t reserved;
+  uint8_t scalar_storage[8];
+  uint64_t payload_offset;
+  uint64_t payload_length;
+  int64_t shape[IREE_TRACE_BINARY_MAX_RANK];
+} iree_trace_binary_value_t;
+
+//===----------------------------------------------------------------------===//
+// iree_trace_binary_file_t
+//===----------------------------------------------------------------------===//
+
+// A binary trace file mapped (or, where mapping is unavailable, read) into
+// memory. All pointers into the file are valid until it is closed.
+typedef struct iree_trace_binary_file_t {
+  iree_allocator_t host_allocator;
+  // Mapping of the file or NULL if the contents were read into memory.
+  iree_file_mapping_t* mapping;
+  iree_byte_span_t contents;
+  const iree_trace_binary_header_t* header;
+  const iree_trace_binary_event_t* events;
+  const iree_trace_binary_value_t* values;
+} iree_trace_binary_file_t;
+
+// Returns true if the file at |path| starts with the binary trace magic.
+bool iree_trace_binary_file_is_binary(const char* path);
+
+// Maps the binary trace file at |path| and verifies its tables.
+iree_status_t iree_trace_binary_file_open(const char* path,
+                                          iree_allocator_t host_allocator,
+                                          iree_trace_binary_file_t* out_file);
+
+// Unmaps |file| and invalidates all pointers into it.
+void iree_trace_binary_file_close(iree_trace_binary_file_t* file);
+
+// Returns the string of |event|.
+iree_string_view_t iree_trace_binary_event_string(
+    const iree_trace_binary_file_t* file,
+    const iree_trace_binary_event_t* event);
+
+// Returns the payload bytes of a buffer view |value|.
+iree_byte_span_t iree_trace_binary_value_payload(
+    const iree_trace_binary_file_t* file,
+    const iree_trace_binary_value_t* value);
+
+//===----------------------------------------------------------------------===//
+// iree_trace_binary_writer_t
+//===----------------------------------------------------------------------===//
+
+// Accumulates events in memory and writes them out as a binary trace.
+typedef struct iree_trace_binary_writer_t {
+  iree_allocator_t host_allocator;
+  iree_host_size_t event_count;
+  iree_host_size_t event_capacity;
+  iree_trace_binary_event_t* events;
+  iree_host_size_t value_count;
+  iree_host_size_t value_capacity;
+  iree_trace_binary_value_t* values;
+  // Strings and payloads; offsets are relative to the start of each until the
+  // file is written.
+  iree_host_size_t string_length;
+  iree_host_size_t string_capacity;
+  char* strings;
+  iree_host_size_t payload_length;
+  iree_host_size_t payload_capacity;
+  uint8_t* payloads;
+} iree_trace_binary_writer_t;
+
+// Initializes an empty |out_writer|.
+void iree_trace_binary_writer_initialize(
+    iree_allocator_t host_allocator, iree_trace_binary_writer_t* out_writer);
+
+// Releases all resources of |writer|.
+void iree_trace_binary_writer_deinitialize(iree_trace_binary_writer_t* writer);
+
+// Records a context reset.
+iree_status_t iree_trace_binary_writer_append_context_load(
+    iree_trace_binary_writer_t* writer);
+
+// Records loading the builtin HAL module using |driver| (may be empty).
+iree_status_t iree_trace_binary_writer_append_hal_module_load(
+    iree_trace_binary_writer_t* writer, iree_string_view_t driver);
+
+// Records loading the bytecode module at |path|.
+iree_status_t iree_trace_binary_writer_append_bytecode_module_load(
+    iree_trace_binary_writer_t* writer, iree_string_view_t path);
+
+// Records a call to |function_name| with the current contents of
+// |input_list|. Buffer view contents are read back from their buffers so the
+// buffers must be host mappable.
+iree_status_t iree_trace_binary_writer_append_call(
+    iree_trace_binary_writer_t* writer, iree_string_view_t function_name,
+    iree_vm_list_t* input_list);
+
+// Writes all recorded events to |path|.
+iree_status_t iree_trace_binary_writer_write_file(
+    iree_trace_binary_writer_t* writer, const char* path);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_TOOLS_UTILS_TRACE_BINARY_H_
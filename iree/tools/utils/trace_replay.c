@@ -45,9 +45,18 @@ void iree_trace_replay_set_hal_driver_override(iree_trace_replay_t* replay,
   replay->driver = driver;
 }
 
-iree_status_t iree_trace_replay_event_context_load(iree_trace_replay_t* replay,
-                                                   yaml_document_t* document,
-                                                   yaml_node_t* event_node) {
+void iree_trace_replay_set_shared_device(iree_trace_replay_t* replay,
+                                         iree_hal_device_t* device) {
+  replay->shared_device = device;
+}
+
+void iree_trace_replay_set_recorder(iree_trace_replay_t* replay,
+                                    iree_trace_binary_writer_t* recorder) {
+  replay->recorder = recorder;
+}
+
+static iree_status_t iree_trace_replay_reset_context(
+    iree_trace_replay_t* replay) {
   // Cleanup previous state.
   iree_hal_device_release(replay->device);
   replay->device = NULL;
@@ -59,11 +68,26 @@ iree_status_t iree_trace_replay_event_context_load(iree_trace_replay_t* replay,
                                 &replay->context);
 }
 
+iree_status_t iree_trace_replay_event_context_load(iree_trace_replay_t* replay,
+                                                   yaml_document_t* document,
+                                                   yaml_node_t* event_node) {
+  if (replay->recorder) {
+    IREE_RETURN_IF_ERROR(
+        iree_trace_binary_writer_append_context_load(replay->recorder));
+  }
+  return iree_trace_replay_reset_context(replay);
+}
+
 static iree_status_t iree_trace_replay_create_device(
-    iree_trace_replay_t* replay, yaml_node_t* driver_node,
+    iree_trace_replay_t* replay, iree_string_view_t driver_name,
     iree_allocator_t host_allocator, iree_hal_device_t** out_device) {
+  if (replay->shared_device) {
+    iree_hal_device_retain(replay->shared_device);
+    *out_device = replay->shared_device;
+    return iree_ok_status();
+  }
+
   // Use the provided driver name or override with the --driver= flag.
-  iree_string_view_t driver_name = iree_yaml_node_as_string(driver_node);
   if (iree_string_view_is_empty(driver_name)) {
     driver_name = replay->driver;
   }
@@ -80,55 +104,55 @@ static iree_status_t iree_trace_replay_create_device(
   return status;
 }
 
+static iree_status_t iree_trace_replay_load_hal_module(
+    iree_trace_replay_t* replay, iree_string_view_t driver_name) {
+  iree_hal_device_release(replay->device);
+  replay->device = NULL;
+  IREE_RETURN_IF_ERROR(iree_trace_replay_create_device(
+      replay, driver_name, replay->host_allocator, &replay->device));
+  iree_vm_module_t* module = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_hal_module_create(replay->device, replay->host_allocator, &module));
+  iree_status_t status =
+      iree_vm_context_register_modules(replay->context, &module, 1);
+  iree_vm_module_release(module);
+  return status;
+}
+
 static iree_status_t iree_trace_replay_load_builtin_module(
     iree_trace_replay_t* replay, yaml_document_t* document,
     yaml_node_t* module_node) {
-  iree_vm_module_t* module = NULL;
-
   yaml_node_t* name_node = NULL;
   IREE_RETURN_IF_ERROR(iree_yaml_mapping_find(
       document, module_node, iree_make_cstring_view("name"), &name_node));
-  if (iree_yaml_string_equal(name_node, iree_make_cstring_view("hal"))) {
-    yaml_node_t* driver_node = NULL;
-    IREE_RETURN_IF_ERROR(iree_yaml_mapping_try_find(
-        document, module_node, iree_make_cstring_view("driver"), &driver_node));
-    IREE_RETURN_IF_ERROR(iree_trace_replay_create_device(
-        replay, driver_node, replay->host_allocator, &replay->device));
-    IREE_RETURN_IF_ERROR(iree_hal_module_create(
-        replay->device, replay->host_allocator, &module));
-  }
-  if (!module) {
+  if (!iree_yaml_string_equal(name_node, iree_make_cstring_view("hal"))) {
     return iree_make_status(
         IREE_STATUS_NOT_FOUND, "builtin module '%.*s' not registered",
         (int)name_node->data.scalar.length, name_node->data.scalar.value);
   }
 
-  iree_status_t status =
-      iree_vm_context_register_modules(replay->context, &module, 1);
-  iree_vm_module_release(module);
-  return status;
+  yaml_node_t* driver_node = NULL;
+  IREE_RETURN_IF_ERROR(iree_yaml_mapping_try_find(
+      document, module_node, iree_make_cstring_view("driver"), &driver_node));
+  iree_string_view_t driver_name = iree_yaml_node_as_string(driver_node);
+  if (replay->recorder) {
+    IREE_RETURN_IF_ERROR(iree_trace_binary_writer_append_hal_module_load(
+        replay->recorder, driver_name));
+  }
+  return iree_trace_replay_load_hal_module(replay, driver_name);
 }
 
-static iree_status_t iree_trace_replay_load_bytecode_module(
-    iree_trace_replay_t* replay, yaml_document_t* document,
-    yaml_node_t* module_node) {
-  yaml_node_t* path_node = NULL;
-  IREE_RETURN_IF_ERROR(iree_yaml_mapping_find(
-      document, module_node, iree_make_cstring_view("path"), &path_node));
-
+// Loads the bytecode module at |full_path| (or stdin) and registers it.
+static iree_status_t iree_trace_replay_load_bytecode_module_file(
+    iree_trace_replay_t* replay, const char* full_path) {
   // Load bytecode file (or stdin) contents into memory.
   iree_byte_span_t flatbuffer_data;
   iree_status_t status = iree_ok_status();
-  if (iree_yaml_string_equal(path_node, iree_make_cstring_view("<stdin>"))) {
+  if (!full_path) {
     status = iree_stdin_read_contents(replay->host_allocator, &flatbuffer_data);
   } else {
-    char* full_path = NULL;
-    IREE_RETURN_IF_ERROR(iree_file_path_join(
-        replay->root_path, iree_yaml_node_as_string(path_node),
-        replay->host_allocator, &full_path));
     status = iree_file_read_contents(full_path, replay->host_allocator,
                                      &flatbuffer_data);
-    iree_allocator_free(replay->host_allocator, full_path);
   }
 
   // Load and verify the bytecode module.
@@ -152,6 +176,36 @@ static iree_status_t iree_trace_replay_load_bytecode_module(
   return status;
 }
 
+static iree_status_t iree_trace_replay_load_bytecode_module(
+    iree_trace_replay_t* replay, yaml_document_t* document,
+    yaml_node_t* module_node) {
+  yaml_node_t* path_node = NULL;
+  IREE_RETURN_IF_ERROR(iree_yaml_mapping_find(
+      document, module_node, iree_make_cstring_view("path"), &path_node));
+
+  if (iree_yaml_string_equal(path_node, iree_make_cstring_view("<stdin>"))) {
+    if (replay->recorder) {
+      return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                              "modules read from stdin cannot be recorded");
+    }
+    return iree_trace_replay_load_bytecode_module_file(replay, NULL);
+  }
+
+  // The path is recorded as written so that it stays relative to the trace.
+  iree_string_view_t path = iree_yaml_node_as_string(path_node);
+  if (replay->recorder) {
+    IREE_RETURN_IF_ERROR(iree_trace_binary_writer_append_bytecode_module_load(
+        replay->recorder, path));
+  }
+  char* full_path = NULL;
+  IREE_RETURN_IF_ERROR(iree_file_path_join(replay->root_path, path,
+                                           replay->host_allocator, &full_path));
+  iree_status_t status =
+      iree_trace_replay_load_bytecode_module_file(replay, full_path);
+  iree_allocator_free(replay->host_allocator, full_path);
+  return status;
+}
+
 iree_status_t iree_trace_replay_event_module_load(iree_trace_replay_t* replay,
                                                   yaml_document_t* document,
                                                   yaml_node_t* event_node) {
@@ -734,6 +788,10 @@ iree_status_t iree_trace_replay_event_call_prepare(
                           replay->host_allocator, &input_list));
   iree_status_t status = iree_trace_replay_parse_item_sequence(
       replay, document, args_node, input_list);
+  if (iree_status_is_ok(status) && replay->recorder) {
+    status = iree_trace_binary_writer_append_call(
+        replay->recorder, iree_yaml_node_as_string(function_node), input_list);
+  }
 
   if (iree_status_is_ok(status)) {
     *out_function = function;
@@ -837,3 +895,155 @@ iree_status_t iree_trace_replay_event(iree_trace_replay_t* replay,
       event_node->start_mark.line, (int)type_node->data.scalar.length,
       type_node->data.scalar.value);
 }
+
+//===----------------------------------------------------------------------===//
+// Binary trace replay
+//===----------------------------------------------------------------------===//
+
+iree_status_t iree_trace_replay_binary_event_module_load(
+    iree_trace_replay_t* replay, const iree_trace_binary_file_t* file,
+    const iree_trace_binary_event_t* event) {
+  iree_string_view_t string = iree_trace_binary_event_string(file, event);
+  if (event->type == IREE_TRACE_BINARY_EVENT_MODULE_LOAD_HAL) {
+    return iree_trace_replay_load_hal_module(replay, string);
+  } else if (event->type != IREE_TRACE_BINARY_EVENT_MODULE_LOAD_BYTECODE) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "event type %u is not a module load", event->type);
+  }
+  char* full_path = NULL;
+  IREE_RETURN_IF_ERROR(iree_file_path_join(replay->root_path, string,
+                                           replay->host_allocator, &full_path));
+  iree_status_t status =
+      iree_trace_replay_load_bytecode_module_file(replay, full_path);
+  iree_allocator_free(replay->host_allocator, full_path);
+  return status;
+}
+
+// Wraps (or, if the device cannot import host memory, copies) the payload of
+// a recorded buffer view |value| and appends it to |target_list|.
+static iree_status_t iree_trace_replay_binary_append_buffer_view(
+    iree_trace_replay_t* replay, const iree_trace_binary_file_t* file,
+    const iree_trace_binary_value_t* value, iree_vm_list_t* target_list) {
+  iree_hal_dim_t shape[IREE_TRACE_BINARY_MAX_RANK];
+  for (uint32_t i = 0; i < value->shape_rank; ++i) {
+    shape[i] = (iree_hal_dim_t)value->shape[i];
+  }
+  iree_hal_buffer_view_t* buffer_view = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_view_wrap_or_clone_heap_buffer(
+      iree_hal_device_allocator(replay->device), shape, value->shape_rank,
+      (iree_hal_element_type_t)value->element_type,
+      (iree_hal_encoding_type_t)value->encoding_type,
+      IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE,
+      IREE_HAL_MEMORY_ACCESS_READ, IREE_HAL_BUFFER_USAGE_ALL,
+      iree_trace_binary_value_payload(file, value), iree_allocator_null(),
+      &buffer_view));
+  iree_vm_ref_t buffer_view_ref = iree_hal_buffer_view_move_ref(buffer_view);
+  iree_status_t status =
+      iree_vm_list_push_ref_move(target_list, &buffer_view_ref);
+  iree_vm_ref_release(&buffer_view_ref);
+  return status;
+}
+
+iree_status_t iree_trace_replay_binary_event_call_prepare(
+    iree_trace_replay_t* replay, const iree_trace_binary_file_t* file,
+    const iree_trace_binary_event_t* event, iree_vm_function_t* out_function,
+    iree_vm_list_t** out_input_list) {
+  memset(out_function, 0, sizeof(*out_function));
+  *out_input_list = NULL;
+
+  iree_vm_function_t function;
+  IREE_RETURN_IF_ERROR(iree_vm_context_resolve_function(
+      replay->context, iree_trace_binary_event_string(file, event),
+      &function));
+
+  iree_vm_list_t* input_list = NULL;
+  IREE_RETURN_IF_ERROR(iree_vm_list_create(
+      /*element_type=*/NULL, event->value_count, replay->host_allocator,
+      &input_list));
+  iree_status_t status = iree_ok_status();
+  for (uint32_t i = 0; i < event->value_count && iree_status_is_ok(status);
+       ++i) {
+    const iree_trace_binary_value_t* value =
+        &file->values[event->value_index + i];
+    switch (value->kind) {
+      case IREE_TRACE_BINARY_VALUE_NULL: {
+        iree_vm_variant_t null_value = iree_vm_variant_empty();
+        status = iree_vm_list_push_variant(input_list, &null_value);
+        break;
+      }
+      case IREE_TRACE_BINARY_VALUE_SCALAR: {
+        iree_vm_variant_t variant = iree_vm_variant_empty();
+        variant.type.value_type = (iree_vm_value_type_t)value->value_type;
+        memcpy(variant.value_storage, value->scalar_storage,
+               sizeof(value->scalar_storage));
+        status = iree_vm_list_push_variant(input_list, &variant);
+        break;
+      }
+      case IREE_TRACE_BINARY_VALUE_BUFFER_VIEW:
+        status = iree_trace_replay_binary_append_buffer_view(replay, file,
+                                                             value, input_list);
+        break;
+      default:
+        status = iree_make_status(IREE_STATUS_DATA_LOSS,
+                                  "unknown binary trace value kind %u",
+                                  value->kind);
+        break;
+    }
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_function = function;
+    *out_input_list = input_list;
+  } else {
+    iree_vm_list_release(input_list);
+  }
+  return status;
+}
+
+static iree_status_t iree_trace_replay_binary_event_call_stdout(
+    iree_trace_replay_t* replay, const iree_trace_binary_file_t* file,
+    const iree_trace_binary_event_t* event) {
+  iree_string_view_t function_name =
+      iree_trace_binary_event_string(file, event);
+  fprintf(stdout, "--- CALL[%.*s] ---\n", (int)function_name.size,
+          function_name.data);
+
+  iree_vm_function_t function;
+  iree_vm_list_t* input_list = NULL;
+  IREE_RETURN_IF_ERROR(iree_trace_replay_binary_event_call_prepare(
+      replay, file, event, &function, &input_list));
+
+  iree_vm_list_t* output_list = NULL;
+  iree_status_t status =
+      iree_vm_list_create(/*element_type=*/NULL, /*initial_capacity=*/8,
+                          replay->host_allocator, &output_list);
+  if (iree_status_is_ok(status)) {
+    status = iree_vm_invoke(replay->context, function, /*policy=*/NULL,
+                            input_list, output_list, replay->host_allocator);
+  }
+  iree_vm_list_release(input_list);
+
+  if (iree_status_is_ok(status)) {
+    status = iree_trace_replay_print_vm_list(output_list);
+  }
+  iree_vm_list_release(output_list);
+  return status;
+}
+
+iree_status_t iree_trace_replay_binary_event(
+    iree_trace_replay_t* replay, const iree_trace_binary_file_t* file,
+    const iree_trace_binary_event_t* event) {
+  switch (event->type) {
+    case IREE_TRACE_BINARY_EVENT_CONTEXT_LOAD:
+      return iree_trace_replay_reset_context(replay);
+    case IREE_TRACE_BINARY_EVENT_MODULE_LOAD_HAL:
+    case IREE_TRACE_BINARY_EVENT_MODULE_LOAD_BYTECODE:
+      return iree_trace_replay_binary_event_module_load(replay, file, event);
+    case IREE_TRACE_BINARY_EVENT_CALL:
+      return iree_trace_replay_binary_event_call_stdout(replay, file, event);
+    default:
+      return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                              "unhandled binary trace event type %u",
+                              event->type);
+  }
+}
@@ -9,6 +9,7 @@
 
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
+#include "iree/tools/utils/trace_binary.h"
 #include "iree/tools/utils/yaml_util.h"
 #include "iree/vm/api.h"
 
@@ -24,6 +25,11 @@ typedef struct iree_trace_replay_t {
 
   iree_vm_context_t* context;
   iree_hal_device_t* device;
+
+  // Optional device used by all HAL module loads instead of creating one.
+  iree_hal_device_t* shared_device;
+  // Optional writer that all replayed YAML events are recorded into.
+  iree_trace_binary_writer_t* recorder;
 } iree_trace_replay_t;
 
 // Initializes a trace replay context.
@@ -41,6 +47,18 @@ void iree_trace_replay_deinitialize(iree_trace_replay_t* replay);
 void iree_trace_replay_set_hal_driver_override(iree_trace_replay_t* replay,
                                                iree_string_view_t driver);
 
+// Uses |device| for all HAL module loads instead of creating a new device from
+// the driver. Multiple replays sharing a device can be run concurrently to
+// reproduce contention between independent streams of work.
+void iree_trace_replay_set_shared_device(iree_trace_replay_t* replay,
+                                         iree_hal_device_t* device);
+
+// Records all subsequently replayed YAML events into |recorder|, which must
+// remain valid for the lifetime of the replay. Call inputs are recorded with
+// the contents they were parsed with.
+void iree_trace_replay_set_recorder(iree_trace_replay_t* replay,
+                                    iree_trace_binary_writer_t* recorder);
+
 // Replays the given |event_node| against the replay context.
 // Automatically switches between the default iree_trace_replay_event_* methods.
 iree_status_t iree_trace_replay_event(iree_trace_replay_t* replay,
@@ -73,6 +91,30 @@ iree_status_t iree_trace_replay_event_call(iree_trace_replay_t* replay,
                                            yaml_node_t* event_node,
                                            iree_vm_list_t** out_output_list);
 
+//===----------------------------------------------------------------------===//
+// Binary trace replay
+//===----------------------------------------------------------------------===//
+
+// Replays the given binary trace |event| from |file| against the replay
+// context. Calls print their outputs to stdout.
+iree_status_t iree_trace_replay_binary_event(
+    iree_trace_replay_t* replay, const iree_trace_binary_file_t* file,
+    const iree_trace_binary_event_t* event);
+
+// Replays a binary IREE_TRACE_BINARY_EVENT_MODULE_LOAD_* event.
+iree_status_t iree_trace_replay_binary_event_module_load(
+    iree_trace_replay_t* replay, const iree_trace_binary_file_t* file,
+    const iree_trace_binary_event_t* event);
+
+// Prepares to replay a binary IREE_TRACE_BINARY_EVENT_CALL event.
+// Buffer view inputs alias the payloads of |file| where the device allows it
+// and otherwise are copied into device buffers; |file| must remain open until
+// |out_input_list| is released.
+iree_status_t iree_trace_replay_binary_event_call_prepare(
+    iree_trace_replay_t* replay, const iree_trace_binary_file_t* file,
+    const iree_trace_binary_event_t* event, iree_vm_function_t* out_function,
+    iree_vm_list_t** out_input_list);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -6,11 +6,17 @@
 
 #include "iree/tools/utils/vm_util.h"
 
+#include <algorithm>
 #include <cerrno>
+#include <chrono>
+#include <cinttypes>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <ostream>
+#include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "iree/base/api.h"
@@ -20,6 +26,7 @@
 #include "iree/base/tracing.h"
 #include "iree/hal/api.h"
 #include "iree/modules/hal/module.h"
+#include "iree/vm/bytecode_module.h"
 #include "iree/vm/ref_cc.h"
 
 namespace iree {
@@ -68,6 +75,352 @@ Status GetFileContents(const char* path, std::string* out_contents) {
   return status;
 }
 
+// Maps the file at |path| into memory and falls back to reading it if mapping
+// is not available. The returned |out_contents| must be freed with
+// |out_deallocator|.
+static iree_status_t MapFileContents(const char* path,
+                                     iree_allocator_t host_allocator,
+                                     iree_const_byte_span_t* out_contents,
+                                     iree_allocator_t* out_deallocator) {
+  *out_contents = iree_make_const_byte_span(nullptr, 0);
+  *out_deallocator = host_allocator;
+  iree_file_mapping_t* mapping = nullptr;
+  iree_status_t status =
+      iree_file_map(path, IREE_FILE_MAP_HINT_NONE, host_allocator, &mapping);
+  if (iree_status_is_ok(status)) {
+    *out_contents = iree_file_mapping_contents(mapping);
+    *out_deallocator = iree_file_mapping_deallocator(mapping);
+  } else if (iree_status_is_unavailable(status)) {
+    iree_status_ignore(status);
+    iree_byte_span_t file_contents;
+    status = iree_file_read_contents(path, host_allocator, &file_contents);
+    *out_contents = iree_make_const_byte_span(file_contents.data,
+                                              file_contents.data_length);
+  }
+  return status;
+}
+
+Status LoadBytecodeModule(const char* path, iree_allocator_t host_allocator,
+                          iree_vm_module_t** out_module) {
+  IREE_TRACE_SCOPE0("LoadBytecodeModule");
+  *out_module = nullptr;
+
+  // Prefer mapping the file and fall back to reading it into memory if
+  // reading from stdin or mapping is not available.
+  iree_const_byte_span_t contents = iree_make_const_byte_span(nullptr, 0);
+  iree_allocator_t deallocator = host_allocator;
+  iree_status_t status = iree_ok_status();
+  if (strcmp(path, "-") == 0) {
+    iree_byte_span_t stdin_contents;
+    status = iree_stdin_read_contents(host_allocator, &stdin_contents);
+    contents = iree_make_const_byte_span(stdin_contents.data,
+                                         stdin_contents.data_length);
+  } else {
+    status = MapFileContents(path, host_allocator, &contents, &deallocator);
+  }
+  IREE_RETURN_IF_ERROR(status, "loading module '%s'", path);
+
+  status = iree_vm_bytecode_module_create(contents, deallocator,
+                                          host_allocator, out_module);
+  if (!iree_status_is_ok(status)) {
+    iree_allocator_free(deallocator, (void*)contents.data);
+  }
+  return status;
+}
+
+// Magic bytes at the start of every .npy file.
+static const char kNpyMagic[] = "\x93NUMPY";
+static const iree_host_size_t kNpyMagicLength = sizeof(kNpyMagic) - 1;
+
+// Returns the value of |key| in the Python dictionary literal |header| of a
+// .npy file with surrounding whitespace removed. The value ends at the next
+// top-level ',' or '}'.
+static std::string FindNpyHeaderValue(const std::string& header,
+                                      const char* key) {
+  std::string quoted_key = std::string("'") + key + "'";
+  size_t key_pos = header.find(quoted_key);
+  if (key_pos == std::string::npos) return "";
+  size_t colon_pos = header.find(':', key_pos + quoted_key.size());
+  if (colon_pos == std::string::npos) return "";
+  size_t begin = colon_pos + 1;
+  size_t end = begin;
+  int depth = 0;
+  for (; end < header.size(); ++end) {
+    char c = header[end];
+    if (c == '(') {
+      ++depth;
+    } else if (c == ')') {
+      --depth;
+    } else if (depth == 0 && (c == ',' || c == '}')) {
+      break;
+    }
+  }
+  iree_string_view_t value = iree_string_view_trim(
+      iree_make_string_view(header.data() + begin, end - begin));
+  return std::string(value.data, value.size);
+}
+
+// Maps a numpy array-protocol type string (such as '<f4') to an element type.
+static iree_status_t ParseNpyDescr(const std::string& descr,
+                                   iree_hal_element_type_t* out_element_type) {
+  *out_element_type = IREE_HAL_ELEMENT_TYPE_NONE;
+  // Strip the quotes and check the byte order: we only support little-endian
+  // (and byte-order agnostic single byte) types.
+  std::string type = descr;
+  if (type.size() < 2 || (type.front() != '\'' && type.front() != '"') ||
+      type.back() != type.front()) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "invalid .npy descr %s", descr.c_str());
+  }
+  type = type.substr(1, type.size() - 2);
+  if (type.size() < 3 || (type[0] != '<' && type[0] != '|' && type[0] != '=')) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "unsupported .npy descr %s; only little-endian "
+                            "types are supported",
+                            descr.c_str());
+  }
+  uint32_t byte_count = 0;
+  if (!iree_string_view_atoi_uint32(
+          iree_make_string_view(type.data() + 2, type.size() - 2),
+          &byte_count) ||
+      (byte_count != 1 && byte_count != 2 && byte_count != 4 &&
+       byte_count != 8)) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "unsupported .npy element size in descr %s",
+                            descr.c_str());
+  }
+  iree_hal_numerical_type_t numerical_type = IREE_HAL_NUMERICAL_TYPE_UNKNOWN;
+  switch (type[1]) {
+    case 'f':
+      if (byte_count == 1) break;
+      numerical_type = IREE_HAL_NUMERICAL_TYPE_FLOAT_IEEE;
+      break;
+    case 'i':
+      numerical_type = IREE_HAL_NUMERICAL_TYPE_INTEGER_SIGNED;
+      break;
+    case 'u':
+    case 'b':
+      numerical_type = IREE_HAL_NUMERICAL_TYPE_INTEGER_UNSIGNED;
+      break;
+    default:
+      break;
+  }
+  if (numerical_type == IREE_HAL_NUMERICAL_TYPE_UNKNOWN) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "unsupported .npy element type in descr %s",
+                            descr.c_str());
+  }
+  *out_element_type =
+      iree_hal_make_element_type(numerical_type, byte_count * 8);
+  return iree_ok_status();
+}
+
+// Parses the header of the .npy file |contents| and returns the shape and
+// element type of the array along with the byte offset of its data.
+// See https://numpy.org/doc/stable/reference/generated/numpy.lib.format.html
+static iree_status_t ParseNpyHeader(iree_const_byte_span_t contents,
+                                    std::vector<iree_hal_dim_t>* out_shape,
+                                    iree_hal_element_type_t* out_element_type,
+                                    iree_host_size_t* out_data_offset) {
+  const uint8_t* data = contents.data;
+  if (contents.data_length < kNpyMagicLength + 4 ||
+      memcmp(data, kNpyMagic, kNpyMagicLength) != 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "file is not a .npy file");
+  }
+  uint8_t major_version = data[kNpyMagicLength];
+  iree_host_size_t header_offset = 0;
+  iree_host_size_t header_length = 0;
+  if (major_version == 1) {
+    header_offset = kNpyMagicLength + 4;
+    header_length =
+        (iree_host_size_t)data[8] | ((iree_host_size_t)data[9] << 8);
+  } else if (major_version == 2 || major_version == 3) {
+    header_offset = kNpyMagicLength + 6;
+    if (contents.data_length < header_offset) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              ".npy header truncated");
+    }
+    header_length = (iree_host_size_t)data[8] |
+                    ((iree_host_size_t)data[9] << 8) |
+                    ((iree_host_size_t)data[10] << 16) |
+                    ((iree_host_size_t)data[11] << 24);
+  } else {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "unsupported .npy version %u", major_version);
+  }
+  if (header_offset + header_length > contents.data_length) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            ".npy header truncated");
+  }
+  std::string header((const char*)data + header_offset, header_length);
+
+  IREE_RETURN_IF_ERROR(
+      ParseNpyDescr(FindNpyHeaderValue(header, "descr"), out_element_type));
+
+  if (FindNpyHeaderValue(header, "fortran_order") != "False") {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "only C-order .npy arrays are supported");
+  }
+
+  // Shapes are tuples such as `()`, `(4,)`, or `(2, 3)`.
+  std::string shape_str = FindNpyHeaderValue(header, "shape");
+  if (shape_str.size() < 2 || shape_str.front() != '(' ||
+      shape_str.back() != ')') {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "invalid .npy shape %s", shape_str.c_str());
+  }
+  out_shape->clear();
+  iree_string_view_t dims =
+      iree_make_string_view(shape_str.data() + 1, shape_str.size() - 2);
+  while (!iree_string_view_is_empty(dims)) {
+    iree_string_view_t dim;
+    iree_string_view_split(dims, ',', &dim, &dims);
+    dim = iree_string_view_trim(dim);
+    if (iree_string_view_is_empty(dim)) continue;
+    int32_t dim_value = 0;
+    if (!iree_string_view_atoi_int32(dim, &dim_value) || dim_value < 0) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "invalid .npy shape %s", shape_str.c_str());
+    }
+    out_shape->push_back(dim_value);
+  }
+
+  *out_data_offset = header_offset + header_length;
+  return iree_ok_status();
+}
+
+// Creates a buffer view of |shape| and |element_type| referencing the data at
+// |data_offset| through the end of the file |contents|. The file memory is
+// wrapped directly if the allocator can import it and otherwise copied into a
+// new buffer. Ownership of |contents| is transferred and it is freed with
+// |deallocator| when no longer needed.
+static iree_status_t WrapFileBufferView(
+    iree_hal_allocator_t* allocator, const std::vector<iree_hal_dim_t>& shape,
+    iree_hal_element_type_t element_type, iree_const_byte_span_t contents,
+    iree_host_size_t data_offset, iree_allocator_t deallocator,
+    iree_hal_buffer_view_t** out_buffer_view) {
+  iree_hal_encoding_type_t encoding_type =
+      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR;
+  iree_const_byte_span_t data =
+      iree_make_const_byte_span(contents.data + data_offset,
+                                contents.data_length - data_offset);
+  iree_device_size_t view_size = 0;
+  iree_status_t status = iree_hal_buffer_compute_view_size(
+      shape.data(), shape.size(), element_type, encoding_type, &view_size);
+  if (iree_status_is_ok(status) && view_size != data.data_length) {
+    status = iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "file contains %zu bytes of data but the shape and type require %zu",
+        (size_t)data.data_length, (size_t)view_size);
+  }
+  if (!iree_status_is_ok(status)) {
+    iree_allocator_free(deallocator, (void*)contents.data);
+    return status;
+  }
+
+  const iree_hal_memory_type_t memory_type =
+      IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE;
+  const iree_hal_buffer_usage_t allowed_usage =
+      IREE_HAL_BUFFER_USAGE_TRANSFER | IREE_HAL_BUFFER_USAGE_MAPPING |
+      IREE_HAL_BUFFER_USAGE_DISPATCH;
+  iree_hal_buffer_compatibility_t compatibility =
+      iree_hal_allocator_query_buffer_compatibility(
+          allocator, memory_type, allowed_usage, IREE_HAL_BUFFER_USAGE_MAPPING,
+          (iree_device_size_t)contents.data_length);
+  if (!iree_all_bits_set(compatibility,
+                         IREE_HAL_BUFFER_COMPATIBILITY_IMPORTABLE)) {
+    status = iree_hal_buffer_view_clone_heap_buffer(
+        allocator, shape.data(), shape.size(), element_type, encoding_type,
+        memory_type, allowed_usage, data, out_buffer_view);
+    iree_allocator_free(deallocator, (void*)contents.data);
+    return status;
+  }
+
+  // The whole file is wrapped so that the buffer frees it with the pointer
+  // it was allocated with; the view then references just the data. Files are
+  // mapped read-only and so is the buffer.
+  iree_hal_buffer_t* file_buffer = nullptr;
+  status = iree_hal_allocator_wrap_buffer(
+      allocator, memory_type, IREE_HAL_MEMORY_ACCESS_READ, allowed_usage,
+      iree_make_byte_span((void*)contents.data, contents.data_length),
+      deallocator, &file_buffer);
+  if (!iree_status_is_ok(status)) {
+    iree_allocator_free(deallocator, (void*)contents.data);
+    return status;
+  }
+  iree_hal_buffer_t* data_buffer = nullptr;
+  status = iree_hal_buffer_subspan(file_buffer, data_offset, view_size,
+                                   &data_buffer);
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_buffer_view_create(data_buffer, shape.data(),
+                                         shape.size(), element_type,
+                                         encoding_type, out_buffer_view);
+  }
+  iree_hal_buffer_release(data_buffer);
+  iree_hal_buffer_release(file_buffer);
+  return status;
+}
+
+// Loads the .npy file at |path| as a buffer view.
+static iree_status_t LoadNpyBufferView(
+    iree_hal_allocator_t* allocator, const char* path,
+    iree_hal_buffer_view_t** out_buffer_view) {
+  IREE_TRACE_SCOPE0("LoadNpyBufferView");
+  iree_const_byte_span_t contents;
+  iree_allocator_t deallocator;
+  IREE_RETURN_IF_ERROR(MapFileContents(path, iree_allocator_system(),
+                                       &contents, &deallocator));
+  std::vector<iree_hal_dim_t> shape;
+  iree_hal_element_type_t element_type = IREE_HAL_ELEMENT_TYPE_NONE;
+  iree_host_size_t data_offset = 0;
+  iree_status_t status =
+      ParseNpyHeader(contents, &shape, &element_type, &data_offset);
+  if (!iree_status_is_ok(status)) {
+    iree_allocator_free(deallocator, (void*)contents.data);
+    return status;
+  }
+  return WrapFileBufferView(allocator, shape, element_type, contents,
+                            data_offset, deallocator, out_buffer_view);
+}
+
+// Loads the raw binary file at |path| as a buffer view with the shape and type
+// from |shape_and_type_str| in the `[shape]xtype` format.
+static iree_status_t LoadRawBufferView(
+    iree_hal_allocator_t* allocator, iree_string_view_t shape_and_type_str,
+    const char* path, iree_hal_buffer_view_t** out_buffer_view) {
+  IREE_TRACE_SCOPE0("LoadRawBufferView");
+  iree_string_view_t shape_str = iree_string_view_empty();
+  iree_string_view_t type_str = shape_and_type_str;
+  iree_host_size_t last_x_index = iree_string_view_find_last_of(
+      shape_and_type_str, IREE_SV("x"), IREE_STRING_VIEW_NPOS);
+  if (last_x_index != IREE_STRING_VIEW_NPOS) {
+    shape_str = iree_string_view_substr(shape_and_type_str, 0, last_x_index);
+    type_str = iree_string_view_substr(shape_and_type_str, last_x_index + 1,
+                                       IREE_STRING_VIEW_NPOS);
+  }
+  iree_host_size_t shape_rank = 0;
+  iree_status_t shape_status =
+      iree_hal_parse_shape(shape_str, 0, nullptr, &shape_rank);
+  if (!iree_status_is_ok(shape_status) &&
+      !iree_status_is_out_of_range(shape_status)) {
+    return shape_status;
+  }
+  iree_status_ignore(shape_status);
+  std::vector<iree_hal_dim_t> shape(shape_rank);
+  IREE_RETURN_IF_ERROR(
+      iree_hal_parse_shape(shape_str, shape.size(), shape.data(), &shape_rank));
+  iree_hal_element_type_t element_type = IREE_HAL_ELEMENT_TYPE_NONE;
+  IREE_RETURN_IF_ERROR(iree_hal_parse_element_type(type_str, &element_type));
+
+  iree_const_byte_span_t contents;
+  iree_allocator_t deallocator;
+  IREE_RETURN_IF_ERROR(MapFileContents(path, iree_allocator_system(),
+                                       &contents, &deallocator));
+  return WrapFileBufferView(allocator, shape, element_type, contents,
+                            /*data_offset=*/0, deallocator, out_buffer_view);
+}
+
 Status ParseToVariantList(iree_hal_allocator_t* allocator,
                           iree::span<const std::string> input_strings,
                           iree_vm_list_t** out_list) {
@@ -79,6 +432,38 @@ Status ParseToVariantList(iree_hal_allocator_t* allocator,
   for (size_t i = 0; i < input_strings.size(); ++i) {
     iree_string_view_t input_view = iree_string_view_trim(iree_make_string_view(
         input_strings[i].data(), input_strings[i].size()));
+    iree_host_size_t file_index =
+        iree_string_view_find_char(input_view, '@', 0);
+    if (file_index != IREE_STRING_VIEW_NPOS) {
+      // Buffer view loaded from a file: either `@file.npy` or a raw binary
+      // file with an explicit shape and type as `[shape]xtype=@file.bin`.
+      std::string path(input_view.data + file_index + 1,
+                       input_view.size - file_index - 1);
+      iree_hal_buffer_view_t* buffer_view = nullptr;
+      if (file_index == 0) {
+        IREE_RETURN_IF_ERROR(
+            LoadNpyBufferView(allocator, path.c_str(), &buffer_view),
+            "loading .npy file '%s'", path.c_str());
+      } else {
+        iree_string_view_t shape_and_type_str =
+            iree_string_view_substr(input_view, 0, file_index);
+        if (!iree_string_view_consume_suffix(&shape_and_type_str,
+                                             IREE_SV("="))) {
+          return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                  "expected `[shape]xtype=@file` but got "
+                                  "'%.*s'",
+                                  (int)input_view.size, input_view.data);
+        }
+        IREE_RETURN_IF_ERROR(
+            LoadRawBufferView(allocator, shape_and_type_str, path.c_str(),
+                              &buffer_view),
+            "loading raw file '%s'", path.c_str());
+      }
+      auto buffer_view_ref = iree_hal_buffer_view_move_ref(buffer_view);
+      IREE_RETURN_IF_ERROR(
+          iree_vm_list_push_ref_move(variant_list.get(), &buffer_view_ref));
+      continue;
+    }
     bool has_equal =
         iree_string_view_find_char(input_view, '=', 0) != IREE_STRING_VIEW_NPOS;
     bool has_x =
@@ -121,14 +506,122 @@ Status ParseToVariantList(iree_hal_allocator_t* allocator,
   return OkStatus();
 }
 
+// Returns the numpy array-protocol type string (such as '<f4') for
+// |element_type|.
+static iree_status_t FormatNpyDescr(iree_hal_element_type_t element_type,
+                                    std::string* out_descr) {
+  char kind = 0;
+  switch (iree_hal_element_numerical_type(element_type)) {
+    case IREE_HAL_NUMERICAL_TYPE_FLOAT_IEEE:
+      kind = 'f';
+      break;
+    case IREE_HAL_NUMERICAL_TYPE_INTEGER_SIGNED:
+      kind = 'i';
+      break;
+    case IREE_HAL_NUMERICAL_TYPE_INTEGER_UNSIGNED:
+      kind = 'u';
+      break;
+    default:
+      break;
+  }
+  size_t bit_count = iree_hal_element_bit_count(element_type);
+  if (!kind || (bit_count != 8 && bit_count != 16 && bit_count != 32 &&
+                bit_count != 64)) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "element type %08X has no .npy equivalent",
+                            element_type);
+  }
+  *out_descr = std::string(bit_count == 8 ? "|" : "<") + kind +
+               std::to_string(bit_count / 8);
+  return iree_ok_status();
+}
+
+// Writes the contents of |buffer_view| to the file at |path|. Files with a
+// .npy extension are written as numpy arrays and all others as raw binary.
+static iree_status_t WriteBufferViewToFile(iree_hal_buffer_view_t* buffer_view,
+                                           const char* path) {
+  IREE_TRACE_SCOPE0("WriteBufferViewToFile");
+  std::string header;
+  iree_string_view_t path_view = iree_make_cstring_view(path);
+  if (iree_string_view_ends_with(path_view, IREE_SV(".npy"))) {
+    std::string descr;
+    IREE_RETURN_IF_ERROR(FormatNpyDescr(
+        iree_hal_buffer_view_element_type(buffer_view), &descr));
+    std::string shape;
+    iree_host_size_t shape_rank = iree_hal_buffer_view_shape_rank(buffer_view);
+    for (iree_host_size_t i = 0; i < shape_rank; ++i) {
+      shape += std::to_string(iree_hal_buffer_view_shape_dim(buffer_view, i));
+      shape += shape_rank == 1 ? "," : (i + 1 < shape_rank ? ", " : "");
+    }
+    std::string dict = "{'descr': '" + descr +
+                       "', 'fortran_order': False, 'shape': (" + shape +
+                       "), }";
+    // Pad with spaces and a trailing newline such that the data is aligned to
+    // 64 bytes as numpy does. Version 1.0 headers are limited to 64KB.
+    size_t prefix_length = kNpyMagicLength + 4;
+    size_t header_length =
+        iree_host_align(prefix_length + dict.size() + 1, 64) - prefix_length;
+    dict.resize(header_length - 1, ' ');
+    dict.push_back('\n');
+    header.append(kNpyMagic, kNpyMagicLength);
+    header.push_back('\x01');
+    header.push_back('\x00');
+    header.push_back((char)(header_length & 0xFF));
+    header.push_back((char)((header_length >> 8) & 0xFF));
+    header.append(dict);
+  }
+
+  iree_hal_buffer_mapping_t mapping;
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_map_range(
+      iree_hal_buffer_view_buffer(buffer_view), IREE_HAL_MEMORY_ACCESS_READ, 0,
+      iree_hal_buffer_view_byte_length(buffer_view), &mapping));
+  iree_status_t status = iree_ok_status();
+  FILE* file = fopen(path, "wb");
+  if (!file) {
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "failed to open file '%s'", path);
+  }
+  if (iree_status_is_ok(status) && !header.empty() &&
+      fwrite(header.data(), header.size(), 1, file) != 1) {
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "failed to write header to '%s'", path);
+  }
+  if (iree_status_is_ok(status) && mapping.contents.data_length &&
+      fwrite(mapping.contents.data, mapping.contents.data_length, 1, file) !=
+          1) {
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "failed to write contents to '%s'", path);
+  }
+  if (file) fclose(file);
+  iree_hal_buffer_unmap_range(&mapping);
+  return status;
+}
+
 Status PrintVariantList(iree_vm_list_t* variant_list, std::ostream* os) {
+  return PrintVariantList(variant_list, {}, os);
+}
+
+Status PrintVariantList(iree_vm_list_t* variant_list,
+                        iree::span<const std::string> output_paths,
+                        std::ostream* os) {
   for (iree_host_size_t i = 0; i < iree_vm_list_size(variant_list); ++i) {
     iree_vm_variant_t variant = iree_vm_variant_empty();
     IREE_RETURN_IF_ERROR(iree_vm_list_get_variant(variant_list, i, &variant),
                          "variant %zu not present", i);
 
     *os << "result[" << i << "]: ";
-    if (iree_vm_variant_is_value(variant)) {
+    const char* output_path = i < output_paths.size() &&
+                                      !output_paths[i].empty()
+                                  ? output_paths[i].c_str()
+                                  : nullptr;
+    if (output_path && iree_vm_variant_is_ref(variant) &&
+        iree_hal_buffer_view_isa(variant.ref)) {
+      IREE_RETURN_IF_ERROR(
+          WriteBufferViewToFile(iree_hal_buffer_view_deref(variant.ref),
+                                output_path),
+          "writing result %zu", i);
+      *os << "hal.buffer_view\n@" << output_path << "\n";
+    } else if (iree_vm_variant_is_value(variant)) {
       switch (variant.type.value_type) {
         case IREE_VM_VALUE_TYPE_I8:
           *os << "i8=" << variant.i8 << "\n";
@@ -196,4 +689,192 @@ Status CreateDevice(const char* driver_name, iree_hal_device_t** out_device) {
   return OkStatus();
 }
 
+Status PrintAllocatorStatistics(iree_hal_allocator_t* allocator,
+                                std::ostream* os) {
+  iree_hal_allocator_statistics_t statistics;
+  iree_hal_allocator_query_statistics(allocator, &statistics);
+  iree_string_builder_t builder;
+  iree_string_builder_initialize(iree_allocator_system(), &builder);
+  iree_status_t status =
+      iree_hal_allocator_statistics_format(&statistics, &builder);
+  if (iree_status_is_ok(status)) {
+    *os << "[[ iree_hal_allocator_t memory statistics ]]\n"
+        << std::string(iree_string_builder_buffer(&builder),
+                       iree_string_builder_size(&builder));
+  }
+  iree_string_builder_deinitialize(&builder);
+  return status;
+}
+
+AllocationTimeline::AllocationTimeline(iree_hal_allocator_t* allocator)
+    : allocator_(allocator), start_time_(std::chrono::steady_clock::now()) {}
+
+void AllocationTimeline::Record(const std::string& label) {
+  Sample sample;
+  sample.label = label;
+  sample.time_us = std::chrono::duration<double, std::micro>(
+                       std::chrono::steady_clock::now() - start_time_)
+                       .count();
+  iree_hal_allocator_query_statistics(allocator_, &sample.statistics);
+  samples_.push_back(std::move(sample));
+}
+
+// Appends |value| to |json| as a quoted string with special characters
+// escaped.
+static void AppendJsonString(const std::string& value, std::string* json) {
+  json->push_back('"');
+  for (char c : value) {
+    if (c == '"' || c == '\\') {
+      json->push_back('\\');
+      json->push_back(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      json->push_back(' ');
+    } else {
+      json->push_back(c);
+    }
+  }
+  json->push_back('"');
+}
+
+Status AllocationTimeline::WriteChromeTrace(const char* path) const {
+  // Each sample is a pair of counter events (which render as stacked area
+  // charts of the live and peak bytes) and an instant event with the label.
+  std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  char event[512];
+  for (size_t i = 0; i < samples_.size(); ++i) {
+    const Sample& sample = samples_[i];
+    const iree_hal_allocator_statistics_t& statistics = sample.statistics;
+    snprintf(event, sizeof(event),
+             "%s{\"name\":\"live bytes\",\"ph\":\"C\",\"ts\":%.3f,"
+             "\"pid\":1,\"tid\":1,\"args\":{\"host_local\":%" PRIu64
+             ",\"device_local\":%" PRIu64 "}},"
+             "{\"name\":\"peak bytes\",\"ph\":\"C\",\"ts\":%.3f,"
+             "\"pid\":1,\"tid\":1,\"args\":{\"host_local\":%" PRIu64
+             ",\"device_local\":%" PRIu64 "}},"
+             "{\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f,\"pid\":1,"
+             "\"tid\":1,\"name\":",
+             i ? "," : "", sample.time_us,
+             (uint64_t)statistics.host_local.bytes_live,
+             (uint64_t)statistics.device_local.bytes_live, sample.time_us,
+             (uint64_t)statistics.host_local.bytes_peak,
+             (uint64_t)statistics.device_local.bytes_peak, sample.time_us);
+    json.append(event);
+    AppendJsonString(sample.label, &json);
+    json.push_back('}');
+  }
+  json.append("]}\n");
+  return iree_file_write_contents(
+      path, iree_make_const_byte_span(json.data(), json.size()));
+}
+
+DispatchProfileSummary::DispatchProfileSummary(iree_hal_device_t* device)
+    : device_(device) {
+  iree_hal_device_retain(device_);
+}
+
+DispatchProfileSummary::~DispatchProfileSummary() {
+  if (active_) {
+    iree_status_ignore(iree_hal_device_end_dispatch_profiling(device_));
+  }
+  iree_hal_device_release(device_);
+}
+
+Status DispatchProfileSummary::Begin() {
+  iree_status_t status = iree_hal_device_begin_dispatch_profiling(device_);
+  if (iree_status_is_unimplemented(status) ||
+      iree_status_is_unavailable(status)) {
+    // Not all devices can profile dispatches; leave the summary empty.
+    iree_status_ignore(status);
+    return OkStatus();
+  }
+  IREE_RETURN_IF_ERROR(status, "beginning dispatch profiling");
+  active_ = true;
+  return OkStatus();
+}
+
+Status DispatchProfileSummary::Flush() {
+  if (!active_) return OkStatus();
+  iree_hal_dispatch_profile_callback_t callback;
+  callback.fn = +[](void* user_data,
+                    const iree_hal_dispatch_profile_t* profile) {
+    static_cast<DispatchProfileSummary*>(user_data)->Add(*profile);
+    return iree_ok_status();
+  };
+  callback.user_data = this;
+  return iree_hal_device_flush_dispatch_profiles(device_, callback);
+}
+
+Status DispatchProfileSummary::End() {
+  if (!active_) return OkStatus();
+  IREE_RETURN_IF_ERROR(iree_hal_device_end_dispatch_profiling(device_));
+  iree_status_t status = Flush();
+  active_ = false;
+  return status;
+}
+
+void DispatchProfileSummary::Add(const iree_hal_dispatch_profile_t& profile) {
+  std::string name;
+  if (iree_string_view_is_empty(profile.entry_point_name)) {
+    name = "#" + std::to_string(profile.entry_point);
+  } else {
+    name = std::string(profile.entry_point_name.data,
+                       profile.entry_point_name.size);
+  }
+  auto it =
+      std::find_if(entries_.begin(), entries_.end(),
+                   [&](const Entry& entry) { return entry.name == name; });
+  if (it == entries_.end()) {
+    entries_.push_back(Entry());
+    it = entries_.end() - 1;
+    it->name = std::move(name);
+  }
+  ++it->count;
+  it->total_ns += profile.duration_ns;
+  it->max_ns = std::max(it->max_ns, profile.duration_ns);
+  it->tile_count += profile.tile_count;
+  it->shard_count += profile.shard_count;
+  it->stolen_shard_count += profile.stolen_shard_count;
+}
+
+void DispatchProfileSummary::Print(std::ostream* os) const {
+  std::vector<const Entry*> entries;
+  uint64_t total_ns = 0;
+  for (const Entry& entry : entries_) {
+    entries.push_back(&entry);
+    total_ns += entry.total_ns;
+  }
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry* lhs, const Entry* rhs) {
+              return lhs->total_ns > rhs->total_ns;
+            });
+
+  // Tile and shard counts are only tracked by some devices (such as the CPU
+  // task executor) and are printed as '-' when unavailable.
+  char line[256];
+  *os << "[[ dispatch profiles ]]\n";
+  snprintf(line, sizeof(line), "%-48s %8s %12s %8s %12s %12s %12s %8s\n",
+           "Dispatch", "Count", "Total (ms)", "% total", "Mean (us)",
+           "Max (us)", "Tiles/call", "Stolen");
+  *os << line;
+  for (const Entry* entry : entries) {
+    snprintf(line, sizeof(line),
+             "%-48s %8" PRIu64 " %12.4f %7.2f%% %12.3f %12.3f ",
+             entry->name.c_str(), entry->count, entry->total_ns / 1e6,
+             total_ns ? 100.0 * entry->total_ns / total_ns : 0.0,
+             entry->total_ns / 1e3 / entry->count, entry->max_ns / 1e3);
+    *os << line;
+    if (entry->shard_count) {
+      snprintf(line, sizeof(line), "%12.1f %7.2f%%\n",
+               (double)entry->tile_count / entry->count,
+               100.0 * entry->stolen_shard_count / entry->shard_count);
+    } else {
+      snprintf(line, sizeof(line), "%12s %8s\n", "-", "-");
+    }
+    *os << line;
+  }
+  snprintf(line, sizeof(line), "%-48s %8s %12.4f\n", "Total", "",
+           total_ns / 1e6);
+  *os << line;
+}
+
 }  // namespace iree
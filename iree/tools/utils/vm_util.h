@@ -7,6 +7,7 @@
 #ifndef IREE_TOOLS_UTILS_VM_UTIL_H_
 #define IREE_TOOLS_UTILS_VM_UTIL_H_
 
+#include <chrono>
 #include <iostream>
 #include <ostream>
 #include <string>
@@ -25,12 +26,26 @@ namespace iree {
 // Synchronously reads a file's contents into a string.
 Status GetFileContents(const char* path, std::string* out_contents);
 
+// Loads the bytecode module at |path| or from stdin if |path| is "-".
+// Files are memory mapped where supported so that only the pages of the module
+// that are used are loaded and are shared across processes; the mapping is
+// owned by the module and released with it.
+// The returned |out_module| must be released by the caller.
+Status LoadBytecodeModule(const char* path, iree_allocator_t host_allocator,
+                          iree_vm_module_t** out_module);
+
 // Parses |input_strings| into a variant list of VM scalars and buffers.
 // Scalars should be in the format:
 //   type=value
 // Buffers should be in the IREE standard shaped buffer format:
 //   [shape]xtype=[value]
 // described in iree/hal/api.h
+// Buffers may also be loaded from files without any parsing of their contents
+// either as numpy arrays or as raw binary data of the given shape and type:
+//   @path/to/array.npy
+//   [shape]xtype=@path/to/data.bin
+// Files are memory mapped and wrapped directly when the allocator can import
+// host memory and otherwise copied into newly allocated buffers.
 // Uses |allocator| to allocate the buffers.
 // Uses descriptors in |descs| for type information and validation.
 // The returned variant list must be freed by the caller.
@@ -49,10 +64,90 @@ Status ParseToVariantList(iree_hal_allocator_t* allocator,
 Status PrintVariantList(iree_vm_list_t* variant_list,
                         std::ostream* os = &std::cout);
 
+// Prints a variant list as with PrintVariantList but writes buffers with a
+// non-empty corresponding entry in |output_paths| to those files instead of
+// printing their contents. Paths with a .npy extension are written as numpy
+// arrays and all others as raw binary data. Written buffers are printed as
+// `@path` in place of their contents.
+Status PrintVariantList(iree_vm_list_t* variant_list,
+                        iree::span<const std::string> output_paths,
+                        std::ostream* os = &std::cout);
+
 // Creates the default device for |driver| in |out_device|.
 // The returned |out_device| must be released by the caller.
 Status CreateDevice(const char* driver_name, iree_hal_device_t** out_device);
 
+// Prints the peak and live memory usage of the buffers allocated from
+// |allocator| to |os|.
+Status PrintAllocatorStatistics(iree_hal_allocator_t* allocator,
+                                std::ostream* os = &std::cout);
+
+// Samples the memory usage of an allocator at points of interest (such as the
+// end of each invocation) and writes it as a Chrome trace that can be viewed in
+// chrome://tracing or https://ui.perfetto.dev. Per-buffer timelines are
+// available in Tracy captures of builds with allocation tracking enabled.
+class AllocationTimeline {
+ public:
+  explicit AllocationTimeline(iree_hal_allocator_t* allocator);
+
+  // Samples the current memory usage and marks it with |label|.
+  void Record(const std::string& label);
+
+  // Writes all samples recorded so far to the file at |path|.
+  Status WriteChromeTrace(const char* path) const;
+
+ private:
+  struct Sample {
+    std::string label;
+    double time_us;
+    iree_hal_allocator_statistics_t statistics;
+  };
+
+  iree_hal_allocator_t* allocator_;
+  std::chrono::steady_clock::time_point start_time_;
+  std::vector<Sample> samples_;
+};
+
+// Aggregates the dispatch profiles captured by a device with
+// iree_hal_device_begin_dispatch_profiling by entry point and prints them as a
+// table ranked by total time. Devices without dispatch profiling support are
+// ignored and produce an empty summary.
+class DispatchProfileSummary {
+ public:
+  explicit DispatchProfileSummary(iree_hal_device_t* device);
+  ~DispatchProfileSummary();
+
+  // Begins capturing dispatch profiles on the device.
+  Status Begin();
+
+  // Adds the profiles of all dispatches that have completed so far.
+  Status Flush();
+
+  // Ends capturing dispatch profiles and flushes the remaining profiles.
+  Status End();
+
+  // Adds a single dispatch |profile| to the summary.
+  void Add(const iree_hal_dispatch_profile_t& profile);
+
+  // Prints the summary table to |os|.
+  void Print(std::ostream* os = &std::cout) const;
+
+ private:
+  struct Entry {
+    std::string name;
+    uint64_t count = 0;
+    uint64_t total_ns = 0;
+    uint64_t max_ns = 0;
+    uint64_t tile_count = 0;
+    uint64_t shard_count = 0;
+    uint64_t stolen_shard_count = 0;
+  };
+
+  iree_hal_device_t* device_;
+  bool active_ = false;
+  std::vector<Entry> entries_;
+};
+
 }  // namespace iree
 
 #endif  // IREE_TOOLS_UTILS_VM_UTIL_H_
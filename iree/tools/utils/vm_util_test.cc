@@ -6,6 +6,12 @@
 
 #include "iree/tools/utils/vm_util.h"
 
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
 #include "iree/hal/vmvx/registration/driver_module.h"
@@ -18,6 +24,13 @@
 namespace iree {
 namespace {
 
+std::string GetUniquePath(const char* unique_name) {
+  const char* test_tmpdir = getenv("TEST_TMPDIR");
+  if (!test_tmpdir) test_tmpdir = getenv("TMPDIR");
+  if (!test_tmpdir) test_tmpdir = "/tmp";
+  return test_tmpdir + std::string("/iree_vm_util_test_") + unique_name;
+}
+
 class VmUtilTest : public ::testing::Test {
  protected:
   static void SetUpTestSuite() {
@@ -83,5 +96,85 @@ TEST_F(VmUtilTest, ParsePrintMultipleBuffers) {
                           buf_string2 + "\n");
 }
 
+TEST_F(VmUtilTest, WriteLoadNpyBuffer) {
+  std::string buf_string = "2x3xf32=[1 2 3][4 5 6]";
+  std::string path = GetUniquePath("buffer.npy");
+  vm::ref<iree_vm_list_t> variant_list;
+  IREE_ASSERT_OK(ParseToVariantList(
+      allocator_, std::vector<std::string>{buf_string}, &variant_list));
+  std::stringstream write_os;
+  IREE_ASSERT_OK(PrintVariantList(
+      variant_list.get(), std::vector<std::string>{path}, &write_os));
+  EXPECT_EQ(write_os.str(), "result[0]: hal.buffer_view\n@" + path + "\n");
+
+  vm::ref<iree_vm_list_t> loaded_list;
+  IREE_ASSERT_OK(ParseToVariantList(
+      allocator_, std::vector<std::string>{"@" + path}, &loaded_list));
+  std::stringstream os;
+  IREE_ASSERT_OK(PrintVariantList(loaded_list.get(), &os));
+  EXPECT_EQ(os.str(),
+            std::string("result[0]: hal.buffer_view\n") + buf_string + "\n");
+}
+
+TEST_F(VmUtilTest, WriteLoadRawBuffer) {
+  std::string buf_string = "2x2xi32=[42 43][44 45]";
+  std::string path = GetUniquePath("buffer.bin");
+  vm::ref<iree_vm_list_t> variant_list;
+  IREE_ASSERT_OK(ParseToVariantList(
+      allocator_, std::vector<std::string>{buf_string}, &variant_list));
+  std::stringstream write_os;
+  IREE_ASSERT_OK(PrintVariantList(
+      variant_list.get(), std::vector<std::string>{path}, &write_os));
+
+  vm::ref<iree_vm_list_t> loaded_list;
+  IREE_ASSERT_OK(ParseToVariantList(
+      allocator_, std::vector<std::string>{"2x2xi32=@" + path},
+      &loaded_list));
+  std::stringstream os;
+  IREE_ASSERT_OK(PrintVariantList(loaded_list.get(), &os));
+  EXPECT_EQ(os.str(),
+            std::string("result[0]: hal.buffer_view\n") + buf_string + "\n");
+
+  // The file size must match the shape and type exactly.
+  vm::ref<iree_vm_list_t> mismatched_list;
+  EXPECT_FALSE(ParseToVariantList(
+                   allocator_, std::vector<std::string>{"3x2xi32=@" + path},
+                   &mismatched_list)
+                   .ok());
+}
+
+TEST_F(VmUtilTest, DispatchProfileSummary) {
+  DispatchProfileSummary summary(device_);
+  IREE_ASSERT_OK(summary.Begin());
+
+  iree_hal_dispatch_profile_t profile;
+  memset(&profile, 0, sizeof(profile));
+  profile.entry_point_name = iree_make_cstring_view("fast");
+  profile.duration_ns = 1000;
+  profile.tile_count = 4;
+  profile.shard_count = 2;
+  summary.Add(profile);
+  profile.entry_point_name = iree_make_cstring_view("slow");
+  profile.duration_ns = 5000;
+  profile.stolen_shard_count = 1;
+  summary.Add(profile);
+  summary.Add(profile);
+  profile.entry_point_name = iree_string_view_empty();
+  profile.entry_point = 3;
+  summary.Add(profile);
+  IREE_ASSERT_OK(summary.End());
+
+  std::stringstream os;
+  summary.Print(&os);
+  std::string output = os.str();
+  size_t slow_pos = output.find("slow");
+  size_t fast_pos = output.find("fast");
+  ASSERT_NE(slow_pos, std::string::npos);
+  ASSERT_NE(fast_pos, std::string::npos);
+  EXPECT_LT(slow_pos, fast_pos);  // ranked by total time
+  EXPECT_NE(output.find("#3"), std::string::npos);
+  EXPECT_NE(output.find("50.00%"), std::string::npos);  // 1 of 2 stolen
+}
+
 }  // namespace
 }  // namespace iree
@@ -12,6 +12,7 @@
 #include "iree/base/internal/math.h"
 #include "iree/vm/api.h"
 #include "iree/vm/bytecode_dispatch_util.h"
+#include "iree/vm/bytecode_jit.h"
 #include "iree/vm/bytecode_module_impl.h"
 #include "iree/vm/ops.h"
 
@@ -60,6 +61,26 @@ static void iree_vm_bytecode_dispatch_discard_registers(
   }
 }
 
+//===----------------------------------------------------------------------===//
+// JIT interop
+//===----------------------------------------------------------------------===//
+
+// Runs the JIT-compiled prefix of the function in |frame| if it has one and
+// execution is starting at the function entry |pc|. Returns the pc at which
+// the interpreter should continue; the register file is updated in-place.
+static inline iree_vm_source_offset_t iree_vm_bytecode_dispatch_enter_jit(
+    const iree_vm_bytecode_module_t* module, const iree_vm_stack_frame_t* frame,
+    const iree_vm_registers_t regs, iree_vm_source_offset_t pc) {
+#if IREE_VM_BYTECODE_JIT_ENABLE
+  if (IREE_LIKELY(!module->jit) || pc != 0) return pc;
+  iree_vm_bytecode_jit_entry_fn_t entry_fn =
+      iree_vm_bytecode_jit_lookup(module->jit, frame->function.ordinal);
+  return entry_fn ? (iree_vm_source_offset_t)entry_fn(regs.i32) : pc;
+#else
+  return pc;
+#endif  // IREE_VM_BYTECODE_JIT_ENABLE
+}
+
 //===----------------------------------------------------------------------===//
 // Stack management
 //===----------------------------------------------------------------------===//
@@ -462,10 +483,64 @@ static void iree_vm_bytecode_populate_import_cconv_arguments(
   }
 }
 
+// Populates the import call |storage| for an argument fragment containing only
+// |value_count| 32-bit primitive values. All bytes of |storage| are written.
+static void iree_vm_bytecode_populate_import_i32_arguments(
+    uint16_t value_count, const iree_vm_registers_t caller_registers,
+    const iree_vm_register_list_t* IREE_RESTRICT src_reg_list,
+    iree_byte_span_t storage) {
+  int32_t* IREE_RESTRICT values = (int32_t*)storage.data;
+  for (uint16_t i = 0; i < value_count; ++i) {
+    uint16_t src_reg = src_reg_list->registers[i];
+    values[i] = caller_registers.i32[src_reg & caller_registers.i32_mask];
+  }
+}
+
+// Populates the import call |storage| for an argument fragment containing only
+// |value_count| refs. |storage| must be zero-initialized.
+static void iree_vm_bytecode_populate_import_ref_arguments(
+    uint16_t value_count, const iree_vm_registers_t caller_registers,
+    const iree_vm_register_list_t* IREE_RESTRICT src_reg_list,
+    iree_byte_span_t storage) {
+  iree_vm_ref_t* IREE_RESTRICT values = (iree_vm_ref_t*)storage.data;
+  for (uint16_t i = 0; i < value_count; ++i) {
+    uint16_t src_reg = src_reg_list->registers[i];
+    iree_vm_ref_assign(
+        &caller_registers.ref[src_reg & caller_registers.ref_mask], &values[i]);
+  }
+}
+
+// Stores the import call |results| of a fragment containing only
+// |value_count| 32-bit primitive values into |dst_reg_list|.
+static void iree_vm_bytecode_store_import_i32_results(
+    uint16_t value_count, iree_byte_span_t results,
+    const iree_vm_registers_t caller_registers,
+    const iree_vm_register_list_t* IREE_RESTRICT dst_reg_list) {
+  const int32_t* IREE_RESTRICT values = (const int32_t*)results.data;
+  for (uint16_t i = 0; i < value_count && i < dst_reg_list->size; ++i) {
+    uint16_t dst_reg = dst_reg_list->registers[i];
+    caller_registers.i32[dst_reg & caller_registers.i32_mask] = values[i];
+  }
+}
+
+// Stores the import call |results| of a fragment containing only
+// |value_count| refs into |dst_reg_list|.
+static void iree_vm_bytecode_store_import_ref_results(
+    uint16_t value_count, iree_byte_span_t results,
+    const iree_vm_registers_t caller_registers,
+    const iree_vm_register_list_t* IREE_RESTRICT dst_reg_list) {
+  iree_vm_ref_t* IREE_RESTRICT values = (iree_vm_ref_t*)results.data;
+  for (uint16_t i = 0; i < value_count && i < dst_reg_list->size; ++i) {
+    uint16_t dst_reg = dst_reg_list->registers[i];
+    iree_vm_ref_move(
+        &values[i], &caller_registers.ref[dst_reg & caller_registers.ref_mask]);
+  }
+}
+
 // Issues a populated import call and marshals the results into |dst_reg_list|.
 static iree_status_t iree_vm_bytecode_issue_import_call(
     iree_vm_stack_t* stack, const iree_vm_function_call_t call,
-    iree_string_view_t cconv_results,
+    const iree_vm_bytecode_import_t* import,
     const iree_vm_register_list_t* IREE_RESTRICT dst_reg_list,
     iree_vm_stack_frame_t** out_caller_frame,
     iree_vm_registers_t* out_caller_registers,
@@ -479,15 +554,37 @@ static iree_status_t iree_vm_bytecode_issue_import_call(
                                 iree_make_cstring_view("while calling import"));
   }
 
-  // NOTE: we don't support yielding within imported functions right now so it's
-  // safe to assume the stack is still valid here. If the called function can
-  // yield then we'll need to requery all pointers here.
+  // NOTE: imported functions always leave their frames before returning (even
+  // when deferring a wait) so the caller frame is back on the top of the stack.
+  // The stack may have been reallocated so all pointers need to be requeried.
   *out_caller_frame = iree_vm_stack_current_frame(stack);
   *out_caller_registers =
       iree_vm_bytecode_get_register_storage(*out_caller_frame);
 
+  // Native functions on resumable stacks may defer a wait instead of blocking.
+  // The call has produced no results and must be re-issued once the wait has
+  // been satisfied.
+  if (IREE_UNLIKELY(iree_vm_stack_take_pending_wait(stack, &out_result->wait))) {
+    out_result->flags |= IREE_VM_EXECUTION_RESULT_FLAG_YIELDED |
+                         IREE_VM_EXECUTION_RESULT_FLAG_WAITING;
+    return iree_ok_status();
+  }
+
   // Marshal outputs from the ABI results buffer to registers.
   iree_vm_registers_t caller_registers = *out_caller_registers;
+  switch (import->result_marshal) {
+    case IREE_VM_BYTECODE_IMPORT_MARSHAL_I32:
+      iree_vm_bytecode_store_import_i32_results(
+          import->result_count, call.results, caller_registers, dst_reg_list);
+      return iree_ok_status();
+    case IREE_VM_BYTECODE_IMPORT_MARSHAL_REF:
+      iree_vm_bytecode_store_import_ref_results(
+          import->result_count, call.results, caller_registers, dst_reg_list);
+      return iree_ok_status();
+    default:
+      break;
+  }
+  iree_string_view_t cconv_results = import->results;
   uint8_t* IREE_RESTRICT p = call.results.data;
   for (iree_host_size_t i = 0; i < cconv_results.size && i < dst_reg_list->size;
        ++i) {
@@ -544,20 +641,40 @@ static iree_status_t iree_vm_bytecode_call_import(
   call.function = import->function;
   IREE_DISPATCH_LOG_CALL(&call.function);
 
-  // Marshal inputs from registers to the ABI arguments buffer.
+  // Marshal inputs from registers to the ABI arguments buffer using the
+  // routine specialized for the import signature.
   call.arguments.data_length = import->argument_buffer_size;
   call.arguments.data = iree_alloca(call.arguments.data_length);
-  memset(call.arguments.data, 0, call.arguments.data_length);
-  iree_vm_bytecode_populate_import_cconv_arguments(
-      import->arguments, caller_registers,
-      /*segment_size_list=*/NULL, src_reg_list, call.arguments);
+  switch (import->argument_marshal) {
+    case IREE_VM_BYTECODE_IMPORT_MARSHAL_I32:
+      iree_vm_bytecode_populate_import_i32_arguments(
+          import->argument_count, caller_registers, src_reg_list,
+          call.arguments);
+      break;
+    case IREE_VM_BYTECODE_IMPORT_MARSHAL_REF:
+      memset(call.arguments.data, 0, call.arguments.data_length);
+      iree_vm_bytecode_populate_import_ref_arguments(
+          import->argument_count, caller_registers, src_reg_list,
+          call.arguments);
+      break;
+    default:
+      memset(call.arguments.data, 0, call.arguments.data_length);
+      iree_vm_bytecode_populate_import_cconv_arguments(
+          import->arguments, caller_registers,
+          /*segment_size_list=*/NULL, src_reg_list, call.arguments);
+      break;
+  }
 
   // Issue the call and handle results.
+  // Primitive-only results are fully written by the callee and don't need to
+  // be cleared; refs must start out as NULL.
   call.results.data_length = import->result_buffer_size;
   call.results.data = iree_alloca(call.results.data_length);
-  memset(call.results.data, 0, call.results.data_length);
-  return iree_vm_bytecode_issue_import_call(stack, call, import->results,
-                                            dst_reg_list, out_caller_frame,
+  if (import->result_marshal != IREE_VM_BYTECODE_IMPORT_MARSHAL_I32) {
+    memset(call.results.data, 0, call.results.data_length);
+  }
+  return iree_vm_bytecode_issue_import_call(stack, call, import, dst_reg_list,
+                                            out_caller_frame,
                                             out_caller_registers, out_result);
 }
 
@@ -602,33 +719,68 @@ static iree_status_t iree_vm_bytecode_call_import_variadic(
   call.results.data_length = import->result_buffer_size;
   call.results.data = iree_alloca(call.results.data_length);
   memset(call.results.data, 0, call.results.data_length);
-  return iree_vm_bytecode_issue_import_call(stack, call, import->results,
-                                            dst_reg_list, out_caller_frame,
+  return iree_vm_bytecode_issue_import_call(stack, call, import, dst_reg_list,
+                                            out_caller_frame,
                                             out_caller_registers, out_result);
 }
 
+// Handles a call that has deferred the wait in |out_result|.
+// Root calls on resumable stacks yield back to the external caller with the
+// wait while all others block on the wait and continue executing.
+// |out_yield| is set to true if execution should yield.
+static iree_status_t iree_vm_bytecode_dispatch_handle_wait(
+    iree_vm_stack_t* stack, int32_t entry_frame_depth,
+    iree_vm_execution_result_t* out_result, bool* out_yield) {
+  if (entry_frame_depth == 0 && iree_vm_stack_is_resumable(stack)) {
+    *out_yield = true;
+    return iree_ok_status();
+  }
+  *out_yield = false;
+  iree_status_t status =
+      iree_vm_wait_until(&out_result->wait, IREE_TIME_INFINITE_FUTURE);
+  iree_vm_wait_reset(&out_result->wait);
+  out_result->flags = IREE_VM_EXECUTION_RESULT_FLAG_NONE;
+  return status;
+}
+
 //===----------------------------------------------------------------------===//
 // Main interpreter dispatch routine
 //===----------------------------------------------------------------------===//
 
 iree_status_t iree_vm_bytecode_dispatch(
     iree_vm_stack_t* stack, iree_vm_bytecode_module_t* module,
-    const iree_vm_function_call_t* call, iree_string_view_t cconv_arguments,
-    iree_string_view_t cconv_results, iree_vm_execution_result_t* out_result) {
+    const iree_vm_function_call_t* call, bool resume,
+    iree_string_view_t cconv_arguments, iree_string_view_t cconv_results,
+    iree_vm_execution_result_t* out_result) {
   memset(out_result, 0, sizeof(*out_result));
 
   // When required emit the dispatch tables here referencing the labels we are
   // defining below.
   DEFINE_DISPATCH_TABLES();
 
-  // Enter function (as this is the initial call).
+  // Enter function (as this is the initial call) or pick up where a previous
+  // yield left off in the frame on the top of the stack.
   // The callee's return will take care of storing the output registers when it
   // actually does return, either immediately or in the future via a resume.
   iree_vm_stack_frame_t* current_frame = NULL;
   iree_vm_registers_t regs;
-  IREE_RETURN_IF_ERROR(
-      iree_vm_bytecode_external_enter(stack, call->function, cconv_arguments,
-                                      call->arguments, &current_frame, &regs));
+  int32_t entry_frame_depth = 0;
+  if (resume) {
+    // Only root calls on resumable stacks yield so the entry frame is always
+    // the bottom-most frame of the stack.
+    current_frame = iree_vm_stack_current_frame(stack);
+    if (IREE_UNLIKELY(!current_frame ||
+                      current_frame->function.module->self != module)) {
+      return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                              "no yielded call in the module to resume");
+    }
+    regs = iree_vm_bytecode_get_register_storage(current_frame);
+  } else {
+    IREE_RETURN_IF_ERROR(iree_vm_bytecode_external_enter(
+        stack, call->function, cconv_arguments, call->arguments,
+        &current_frame, &regs));
+    entry_frame_depth = current_frame->depth;
+  }
 
   // Primary dispatch state. This is our 'native stack frame' and really
   // just enough to make dereferencing common addresses (like the current
@@ -643,8 +795,8 @@ iree_status_t iree_vm_bytecode_dispatch(
       module->bytecode_data.data +
       module->function_descriptor_table[current_frame->function.ordinal]
           .bytecode_offset;
-  iree_vm_source_offset_t pc = current_frame->pc;
-  const int32_t entry_frame_depth = current_frame->depth;
+  iree_vm_source_offset_t pc = iree_vm_bytecode_dispatch_enter_jit(
+      module, current_frame, regs, current_frame->pc);
 
   BEGIN_DISPATCH_CORE() {
     //===------------------------------------------------------------------===//
@@ -796,16 +948,16 @@ iree_status_t iree_vm_bytecode_dispatch(
 
     DISPATCH_OP(CORE, ConstRefRodata, {
       uint32_t rodata_ordinal = VM_DecRodataAttr("rodata");
-      if (IREE_UNLIKELY(rodata_ordinal >= module_state->rodata_ref_count)) {
+      if (IREE_UNLIKELY(rodata_ordinal >= module->rodata_ref_count)) {
         return iree_make_status(
             IREE_STATUS_OUT_OF_RANGE,
             "rodata ref ordinal out of range: %d (table=%zu)", rodata_ordinal,
-            module_state->rodata_ref_count);
+            module->rodata_ref_count);
       }
       bool result_is_move;
       iree_vm_ref_t* result = VM_DecResultRegRef("value", &result_is_move);
       IREE_RETURN_IF_ERROR(iree_vm_ref_wrap_retain(
-          &module_state->rodata_ref_table[rodata_ordinal],
+          &module->rodata_ref_table[rodata_ordinal],
           iree_vm_buffer_type_id(), result));
     });
 
@@ -1202,6 +1354,31 @@ iree_status_t iree_vm_bytecode_dispatch(
       }
     });
 
+    DISPATCH_OP(CORE, ListCopy, {
+      bool source_list_is_move;
+      iree_vm_ref_t* source_list_ref =
+          VM_DecOperandRegRef("source_list", &source_list_is_move);
+      iree_vm_list_t* source_list = iree_vm_list_deref(*source_list_ref);
+      if (IREE_UNLIKELY(!source_list)) {
+        return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "source list is null");
+      }
+      uint32_t source_offset = VM_DecOperandRegI32("source_offset");
+      bool target_list_is_move;
+      iree_vm_ref_t* target_list_ref =
+          VM_DecOperandRegRef("target_list", &target_list_is_move);
+      iree_vm_list_t* target_list = iree_vm_list_deref(*target_list_ref);
+      if (IREE_UNLIKELY(!target_list)) {
+        return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "target list is null");
+      }
+      uint32_t target_offset = VM_DecOperandRegI32("target_offset");
+      uint32_t length = VM_DecOperandRegI32("length");
+      IREE_RETURN_IF_ERROR(iree_vm_list_copy(source_list, source_offset,
+                                             target_list, target_offset,
+                                             length));
+    });
+
     //===------------------------------------------------------------------===//
     // Conditional assignment
     //===------------------------------------------------------------------===//
@@ -1392,7 +1569,14 @@ iree_status_t iree_vm_bytecode_dispatch(
       }
     });
 
+    DISPATCH_OP_CORE_COND_BRANCH_BINARY_I32(CondBranchEQI32, vm_cmp_eq_i32);
+    DISPATCH_OP_CORE_COND_BRANCH_BINARY_I32(CondBranchNEI32, vm_cmp_ne_i32);
+    DISPATCH_OP_CORE_COND_BRANCH_BINARY_I32(CondBranchLTI32S, vm_cmp_lt_i32s);
+    DISPATCH_OP_CORE_COND_BRANCH_BINARY_I32(CondBranchLTI32U, vm_cmp_lt_i32u);
+
     DISPATCH_OP(CORE, Call, {
+      // The pc of the call op itself; imports that defer a wait are re-issued.
+      iree_vm_source_offset_t call_pc = pc - 1;
       int32_t function_ordinal = VM_DecFuncAttr("callee");
       const iree_vm_register_list_t* src_reg_list =
           VM_DecVariadicOperands("operands");
@@ -1408,6 +1592,15 @@ iree_status_t iree_vm_bytecode_dispatch(
         IREE_RETURN_IF_ERROR(iree_vm_bytecode_call_import(
             stack, module_state, function_ordinal, regs, src_reg_list,
             dst_reg_list, &current_frame, &regs, out_result));
+        if (IREE_UNLIKELY(out_result->flags &
+                          IREE_VM_EXECUTION_RESULT_FLAG_WAITING)) {
+          bool yield = false;
+          current_frame->pc = call_pc;
+          IREE_RETURN_IF_ERROR(iree_vm_bytecode_dispatch_handle_wait(
+              stack, entry_frame_depth, out_result, &yield));
+          if (yield) return iree_ok_status();
+          pc = call_pc;
+        }
       } else {
         // Switch execution to the target function and continue running in the
         // bytecode dispatcher.
@@ -1417,13 +1610,15 @@ iree_status_t iree_vm_bytecode_dispatch(
         bytecode_data =
             module->bytecode_data.data +
             module->function_descriptor_table[function_ordinal].bytecode_offset;
-        pc = current_frame->pc;
+        pc = iree_vm_bytecode_dispatch_enter_jit(module, current_frame, regs,
+                                                 current_frame->pc);
       }
     });
 
     DISPATCH_OP(CORE, CallVariadic, {
       // TODO(benvanik): dedupe with above or merge and always have the seg size
       // list be present (but empty) for non-variadic calls.
+      iree_vm_source_offset_t call_pc = pc - 1;
       int32_t function_ordinal = VM_DecFuncAttr("callee");
       const iree_vm_register_list_t* segment_size_list =
           VM_DecVariadicOperands("segment_sizes");
@@ -1447,6 +1642,15 @@ iree_status_t iree_vm_bytecode_dispatch(
       IREE_RETURN_IF_ERROR(iree_vm_bytecode_call_import_variadic(
           stack, module_state, function_ordinal, regs, segment_size_list,
           src_reg_list, dst_reg_list, &current_frame, &regs, out_result));
+      if (IREE_UNLIKELY(out_result->flags &
+                        IREE_VM_EXECUTION_RESULT_FLAG_WAITING)) {
+        bool yield = false;
+        current_frame->pc = call_pc;
+        IREE_RETURN_IF_ERROR(iree_vm_bytecode_dispatch_handle_wait(
+            stack, entry_frame_depth, out_result, &yield));
+        if (yield) return iree_ok_status();
+        pc = call_pc;
+      }
     });
 
     DISPATCH_OP(CORE, Return, {
@@ -1489,8 +1693,13 @@ iree_status_t iree_vm_bytecode_dispatch(
     //===------------------------------------------------------------------===//
 
     DISPATCH_OP(CORE, Yield, {
-      // TODO(benvanik): yield with execution results.
-      return iree_ok_status();
+      // Only root calls on resumable stacks can be suspended; everywhere else
+      // the yield is a no-op and execution continues.
+      if (entry_frame_depth == 0 && iree_vm_stack_is_resumable(stack)) {
+        current_frame->pc = pc;
+        out_result->flags |= IREE_VM_EXECUTION_RESULT_FLAG_YIELDED;
+        return iree_ok_status();
+      }
     });
 
     //===------------------------------------------------------------------===//
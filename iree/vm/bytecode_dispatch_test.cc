@@ -24,6 +24,10 @@ namespace {
 struct TestParams {
   const struct iree_file_toc_t& module_file;
   std::string function_name;
+  iree_vm_bytecode_module_flags_t module_flags;
+  // Runs the function as a resumable invocation that is resumed each time it
+  // yields instead of synchronously.
+  bool resumable;
 };
 
 std::ostream& operator<<(std::ostream& os, const TestParams& params) {
@@ -31,7 +35,10 @@ std::ostream& operator<<(std::ostream& os, const TestParams& params) {
   auto name_sv = iree_make_string_view(name.data(), name.size());
   iree_string_view_replace_char(name_sv, ':', '_');
   iree_string_view_replace_char(name_sv, '.', '_');
-  return os << name << "_" << params.function_name;
+  os << name << "_" << params.function_name;
+  if (params.module_flags & IREE_VM_BYTECODE_MODULE_FLAG_JIT) os << "_jit";
+  if (params.resumable) os << "_resumable";
+  return os;
 }
 
 std::vector<TestParams> GetModuleTestParams() {
@@ -50,13 +57,26 @@ std::vector<TestParams> GetModuleTestParams() {
             module_file.size},
         iree_allocator_null(), iree_allocator_system(), &module));
     iree_vm_module_signature_t signature = module->signature(module->self);
-    test_params.reserve(test_params.size() + signature.export_function_count);
+    test_params.reserve(test_params.size() +
+                        3 * signature.export_function_count);
     for (int i = 0; i < signature.export_function_count; ++i) {
       iree_string_view_t name;
       IREE_CHECK_OK(module->get_function(module->self,
                                          IREE_VM_FUNCTION_LINKAGE_EXPORT, i,
                                          nullptr, &name, nullptr));
-      test_params.push_back({module_file, std::string(name.data, name.size)});
+      // Run each function both interpreted and with the JIT enabled; the JIT
+      // falls back to the interpreter where unsupported so both must pass.
+      // Functions are also run as resumable invocations where yields suspend
+      // execution.
+      test_params.push_back({module_file, std::string(name.data, name.size),
+                             IREE_VM_BYTECODE_MODULE_FLAG_NONE,
+                             /*resumable=*/false});
+      test_params.push_back({module_file, std::string(name.data, name.size),
+                             IREE_VM_BYTECODE_MODULE_FLAG_JIT,
+                             /*resumable=*/false});
+      test_params.push_back({module_file, std::string(name.data, name.size),
+                             IREE_VM_BYTECODE_MODULE_FLAG_NONE,
+                             /*resumable=*/true});
     }
     iree_vm_module_release(module);
   }
@@ -73,7 +93,8 @@ class VMBytecodeDispatchTest
 
     IREE_CHECK_OK(iree_vm_instance_create(iree_allocator_system(), &instance_));
 
-    IREE_CHECK_OK(iree_vm_bytecode_module_create(
+    IREE_CHECK_OK(iree_vm_bytecode_module_create_with_flags(
+        test_params.module_flags,
         iree_const_byte_span_t{
             reinterpret_cast<const uint8_t*>(test_params.module_file.data),
             test_params.module_file.size},
@@ -97,9 +118,23 @@ class VMBytecodeDispatchTest
         bytecode_module_->self, IREE_VM_FUNCTION_LINKAGE_EXPORT,
         iree_make_cstring_view(function_name), &function));
 
-    return iree_vm_invoke(context_, function,
-                          /*policy=*/nullptr, /*inputs=*/nullptr,
-                          /*outputs=*/nullptr, iree_allocator_system());
+    if (!GetParam().resumable) {
+      return iree_vm_invoke(context_, function,
+                            /*policy=*/nullptr, /*inputs=*/nullptr,
+                            /*outputs=*/nullptr, iree_allocator_system());
+    }
+
+    iree_vm_invocation_t* invocation = nullptr;
+    IREE_CHECK_OK(iree_vm_invocation_create(
+        context_, function, /*policy=*/nullptr, /*inputs=*/nullptr,
+        iree_allocator_system(), &invocation));
+    iree_status_t status = iree_vm_invocation_query_status(invocation);
+    while (iree_status_is_unavailable(status)) {
+      EXPECT_TRUE(iree_vm_invocation_is_ready(invocation));
+      status = iree_vm_invocation_resume(invocation);
+    }
+    IREE_CHECK_OK(iree_vm_invocation_release(invocation));
+    return status;
   }
 
   iree_vm_instance_t* instance_ = nullptr;
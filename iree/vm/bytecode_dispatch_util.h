@@ -412,6 +412,28 @@ static inline const iree_vm_register_list_t* VM_DecVariadicOperandsImpl(
     *result = op_func(a, b, c);                        \
   });
 
+// Superinstruction fusing a binary i32 comparison with a conditional branch
+// on its result. The comparison result is not written to any register.
+#define DISPATCH_OP_CORE_COND_BRANCH_BINARY_I32(op_name, op_func)              \
+  DISPATCH_OP(CORE, op_name, {                                                 \
+    int32_t lhs = VM_DecOperandRegI32("lhs");                                  \
+    int32_t rhs = VM_DecOperandRegI32("rhs");                                  \
+    int32_t true_block_pc = VM_DecBranchTarget("true_dest");                   \
+    const iree_vm_register_remap_list_t* true_remap_list =                     \
+        VM_DecBranchOperands("true_operands");                                 \
+    int32_t false_block_pc = VM_DecBranchTarget("false_dest");                 \
+    const iree_vm_register_remap_list_t* false_remap_list =                    \
+        VM_DecBranchOperands("false_operands");                                \
+    if (op_func(lhs, rhs)) {                                                   \
+      pc = true_block_pc;                                                      \
+      iree_vm_bytecode_dispatch_remap_branch_registers(regs, true_remap_list); \
+    } else {                                                                   \
+      pc = false_block_pc;                                                     \
+      iree_vm_bytecode_dispatch_remap_branch_registers(regs,                   \
+                                                       false_remap_list);      \
+    }                                                                          \
+  });
+
 #define DISPATCH_OP_EXT_I64_UNARY_I64(op_name, op_func) \
   DISPATCH_OP(EXT_I64, op_name, {                       \
     int64_t operand = VM_DecOperandRegI64("operand");   \
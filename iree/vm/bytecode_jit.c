@@ -0,0 +1,1054 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/vm/bytecode_jit.h"
+
+#include <string.h>
+
+#include "iree/base/internal/math.h"
+#include "iree/base/internal/memory.h"
+#include "iree/base/tracing.h"
+#include "iree/vm/generated/bytecode_op_table.h"
+
+#if defined(IREE_ARCH_X86_64) && !defined(IREE_PLATFORM_WINDOWS)
+#define IREE_VM_BYTECODE_JIT_ARCH_X86_64 1
+#define IREE_VM_BYTECODE_JIT_ARCH_SUPPORTED 1
+#elif defined(IREE_ARCH_ARM_64)
+#define IREE_VM_BYTECODE_JIT_ARCH_ARM_64 1
+#define IREE_VM_BYTECODE_JIT_ARCH_SUPPORTED 1
+#endif  // IREE_ARCH_*
+
+#if defined(IREE_VM_BYTECODE_JIT_ARCH_SUPPORTED)
+
+//===----------------------------------------------------------------------===//
+// Code buffer
+//===----------------------------------------------------------------------===//
+
+// Growable buffer that native code is emitted into prior to being copied into
+// executable memory. All emitted code is position-independent (only relative
+// branches are used) so that it can be relocated anywhere.
+//
+// Emission failures are sticky: once |status| is set all further emission is
+// ignored and the error is returned when translation completes.
+typedef struct iree_vm_bytecode_jit_buffer_t {
+  iree_allocator_t host_allocator;
+  uint8_t* data;
+  iree_host_size_t size;
+  iree_host_size_t capacity;
+  iree_status_t status;
+} iree_vm_bytecode_jit_buffer_t;
+
+static bool iree_vm_bytecode_jit_buffer_reserve(
+    iree_vm_bytecode_jit_buffer_t* buffer, iree_host_size_t length) {
+  if (!iree_status_is_ok(buffer->status)) return false;
+  if (buffer->size + length <= buffer->capacity) return true;
+  iree_host_size_t new_capacity = iree_max(buffer->capacity * 2, 4096);
+  while (new_capacity < buffer->size + length) new_capacity *= 2;
+  buffer->status = iree_allocator_realloc(buffer->host_allocator, new_capacity,
+                                          (void**)&buffer->data);
+  if (!iree_status_is_ok(buffer->status)) return false;
+  buffer->capacity = new_capacity;
+  return true;
+}
+
+static void iree_vm_bytecode_jit_emit_bytes(
+    iree_vm_bytecode_jit_buffer_t* buffer, const void* data,
+    iree_host_size_t length) {
+  if (!iree_vm_bytecode_jit_buffer_reserve(buffer, length)) return;
+  memcpy(buffer->data + buffer->size, data, length);
+  buffer->size += length;
+}
+
+static void iree_vm_bytecode_jit_emit_u32(
+    iree_vm_bytecode_jit_buffer_t* buffer, uint32_t value) {
+  uint8_t bytes[4] = {
+      (uint8_t)(value & 0xFF),
+      (uint8_t)((value >> 8) & 0xFF),
+      (uint8_t)((value >> 16) & 0xFF),
+      (uint8_t)((value >> 24) & 0xFF),
+  };
+  iree_vm_bytecode_jit_emit_bytes(buffer, bytes, sizeof(bytes));
+}
+
+static void iree_vm_bytecode_jit_store_u32(
+    iree_vm_bytecode_jit_buffer_t* buffer, iree_host_size_t offset,
+    uint32_t value) {
+  uint8_t* p = buffer->data + offset;
+  p[0] = (uint8_t)(value & 0xFF);
+  p[1] = (uint8_t)((value >> 8) & 0xFF);
+  p[2] = (uint8_t)((value >> 16) & 0xFF);
+  p[3] = (uint8_t)((value >> 24) & 0xFF);
+}
+
+//===----------------------------------------------------------------------===//
+// Architecture-specific code generation
+//===----------------------------------------------------------------------===//
+// Generated code uses a trivial model: every bytecode op loads its operands
+// from the register file into scratch registers, computes into scratch 0, and
+// stores the result back to the register file. This keeps the register file
+// coherent at every bytecode op boundary so that exiting to the interpreter
+// at any pc requires no state reconstruction.
+//
+// Scratch registers are numbered 0-2 and mapped to caller-saved native
+// registers so that no prologue/epilogue is required.
+
+// Conditions usable by compare-and-set and conditional branches.
+// Conditions are laid out in pairs such that flipping the low bit inverts one.
+typedef enum iree_vm_bytecode_jit_cond_e {
+  IREE_VM_BYTECODE_JIT_COND_EQ = 0,
+  IREE_VM_BYTECODE_JIT_COND_NE = 1,
+  IREE_VM_BYTECODE_JIT_COND_LT_S = 2,
+  IREE_VM_BYTECODE_JIT_COND_GE_S = 3,
+  IREE_VM_BYTECODE_JIT_COND_LT_U = 4,
+  IREE_VM_BYTECODE_JIT_COND_GE_U = 5,
+} iree_vm_bytecode_jit_cond_t;
+
+static inline iree_vm_bytecode_jit_cond_t iree_vm_bytecode_jit_cond_invert(
+    iree_vm_bytecode_jit_cond_t cond) {
+  return (iree_vm_bytecode_jit_cond_t)(cond ^ 1);
+}
+
+// Binary operations performing scratch0 = scratch0 <op> scratch1.
+typedef enum iree_vm_bytecode_jit_binary_op_e {
+  IREE_VM_BYTECODE_JIT_BINARY_OP_ADD = 0,
+  IREE_VM_BYTECODE_JIT_BINARY_OP_SUB,
+  IREE_VM_BYTECODE_JIT_BINARY_OP_MUL,
+  IREE_VM_BYTECODE_JIT_BINARY_OP_AND,
+  IREE_VM_BYTECODE_JIT_BINARY_OP_OR,
+  IREE_VM_BYTECODE_JIT_BINARY_OP_XOR,
+  IREE_VM_BYTECODE_JIT_BINARY_OP_SHL,
+  IREE_VM_BYTECODE_JIT_BINARY_OP_SHR_S,
+  IREE_VM_BYTECODE_JIT_BINARY_OP_SHR_U,
+} iree_vm_bytecode_jit_binary_op_t;
+
+#if defined(IREE_VM_BYTECODE_JIT_ARCH_X86_64)
+
+// System V: the register file base arrives in rdi and the resume pc is
+// returned in eax. Scratch registers 0-2 are eax, ecx, and edx; ecx is used
+// for shift amounts as required by the variable shift instructions.
+#define IREE_VM_BYTECODE_JIT_X86_RDI 7
+
+// Any i32 register ordinal can be addressed with a disp32.
+#define IREE_VM_BYTECODE_JIT_MAX_I32_REGISTER_COUNT 0x8000
+
+// x86 condition codes as used by jcc/setcc.
+static const uint8_t iree_vm_bytecode_jit_x86_cond_codes[6] = {
+    0x4,  // EQ: E
+    0x5,  // NE: NE
+    0xC,  // LT_S: L
+    0xD,  // GE_S: GE
+    0x2,  // LT_U: B
+    0x3,  // GE_U: AE
+};
+
+static void iree_vm_bytecode_jit_emit_u8(iree_vm_bytecode_jit_buffer_t* buffer,
+                                         uint8_t value) {
+  iree_vm_bytecode_jit_emit_bytes(buffer, &value, sizeof(value));
+}
+
+// mov <scratch>, dword ptr [rdi + byte_offset]
+static void iree_vm_bytecode_jit_emit_load(
+    iree_vm_bytecode_jit_buffer_t* buffer, uint8_t scratch,
+    uint32_t byte_offset) {
+  iree_vm_bytecode_jit_emit_u8(buffer, 0x8B);
+  iree_vm_bytecode_jit_emit_u8(buffer,
+                               0x80 | (scratch << 3) |
+                                   IREE_VM_BYTECODE_JIT_X86_RDI);
+  iree_vm_bytecode_jit_emit_u32(buffer, byte_offset);
+}
+
+// mov dword ptr [rdi + byte_offset], eax
+static void iree_vm_bytecode_jit_emit_store(
+    iree_vm_bytecode_jit_buffer_t* buffer, uint32_t byte_offset) {
+  iree_vm_bytecode_jit_emit_u8(buffer, 0x89);
+  iree_vm_bytecode_jit_emit_u8(buffer, 0x80 | IREE_VM_BYTECODE_JIT_X86_RDI);
+  iree_vm_bytecode_jit_emit_u32(buffer, byte_offset);
+}
+
+// mov eax, imm32
+static void iree_vm_bytecode_jit_emit_load_imm(
+    iree_vm_bytecode_jit_buffer_t* buffer, uint32_t value) {
+  iree_vm_bytecode_jit_emit_u8(buffer, 0xB8);
+  iree_vm_bytecode_jit_emit_u32(buffer, value);
+}
+
+// eax = eax <op> ecx
+static void iree_vm_bytecode_jit_emit_binary(
+    iree_vm_bytecode_jit_buffer_t* buffer,
+    iree_vm_bytecode_jit_binary_op_t op) {
+  // ModRM for (rm=eax, reg=ecx) and for the /digit shift forms on eax.
+  static const uint8_t kAluOpcodes[] = {
+      0x01,  // ADD
+      0x29,  // SUB
+      0x00,  // MUL (handled below)
+      0x21,  // AND
+      0x09,  // OR
+      0x31,  // XOR
+  };
+  switch (op) {
+    case IREE_VM_BYTECODE_JIT_BINARY_OP_MUL: {
+      // imul eax, ecx
+      const uint8_t code[] = {0x0F, 0xAF, 0xC1};
+      iree_vm_bytecode_jit_emit_bytes(buffer, code, sizeof(code));
+      break;
+    }
+    case IREE_VM_BYTECODE_JIT_BINARY_OP_SHL:
+    case IREE_VM_BYTECODE_JIT_BINARY_OP_SHR_S:
+    case IREE_VM_BYTECODE_JIT_BINARY_OP_SHR_U: {
+      // shl/sar/shr eax, cl
+      // The hardware masks the shift amount to 5 bits, matching the VM.
+      uint8_t digit = op == IREE_VM_BYTECODE_JIT_BINARY_OP_SHL     ? 4
+                      : op == IREE_VM_BYTECODE_JIT_BINARY_OP_SHR_S ? 7
+                                                                   : 5;
+      const uint8_t code[] = {0xD3, (uint8_t)(0xC0 | (digit << 3))};
+      iree_vm_bytecode_jit_emit_bytes(buffer, code, sizeof(code));
+      break;
+    }
+    default: {
+      // <alu> eax, ecx
+      const uint8_t code[] = {kAluOpcodes[op], 0xC8};
+      iree_vm_bytecode_jit_emit_bytes(buffer, code, sizeof(code));
+      break;
+    }
+  }
+}
+
+// not eax
+static void iree_vm_bytecode_jit_emit_not(
+    iree_vm_bytecode_jit_buffer_t* buffer) {
+  const uint8_t code[] = {0xF7, 0xD0};
+  iree_vm_bytecode_jit_emit_bytes(buffer, code, sizeof(code));
+}
+
+// Sets flags from eax - ecx (|with_zero| = false) or eax - 0 (true).
+static void iree_vm_bytecode_jit_emit_compare(
+    iree_vm_bytecode_jit_buffer_t* buffer, bool with_zero) {
+  // cmp eax, ecx / test eax, eax
+  const uint8_t code[] = {with_zero ? 0x85 : 0x39, with_zero ? 0xC0 : 0xC8};
+  iree_vm_bytecode_jit_emit_bytes(buffer, code, sizeof(code));
+}
+
+// eax = |cond| ? 1 : 0
+static void iree_vm_bytecode_jit_emit_set_cond(
+    iree_vm_bytecode_jit_buffer_t* buffer, iree_vm_bytecode_jit_cond_t cond) {
+  // setcc al; movzx eax, al
+  const uint8_t code[] = {
+      0x0F, (uint8_t)(0x90 | iree_vm_bytecode_jit_x86_cond_codes[cond]),
+      0xC0, 0x0F,
+      0xB6, 0xC0,
+  };
+  iree_vm_bytecode_jit_emit_bytes(buffer, code, sizeof(code));
+}
+
+// eax = edx ? eax : ecx
+static void iree_vm_bytecode_jit_emit_select(
+    iree_vm_bytecode_jit_buffer_t* buffer) {
+  // test edx, edx; cmovz eax, ecx
+  const uint8_t code[] = {0x85, 0xD2, 0x0F, 0x44, 0xC1};
+  iree_vm_bytecode_jit_emit_bytes(buffer, code, sizeof(code));
+}
+
+// Emits a conditional branch with an unresolved target and returns the fixup
+// location to pass to iree_vm_bytecode_jit_patch_branch.
+static iree_host_size_t iree_vm_bytecode_jit_emit_branch_cond(
+    iree_vm_bytecode_jit_buffer_t* buffer, iree_vm_bytecode_jit_cond_t cond) {
+  // jcc rel32
+  iree_vm_bytecode_jit_emit_u8(buffer, 0x0F);
+  iree_vm_bytecode_jit_emit_u8(
+      buffer, 0x80 | iree_vm_bytecode_jit_x86_cond_codes[cond]);
+  iree_host_size_t fixup = buffer->size;
+  iree_vm_bytecode_jit_emit_u32(buffer, 0);
+  return fixup;
+}
+
+// Emits an unconditional branch with an unresolved target and returns the
+// fixup location to pass to iree_vm_bytecode_jit_patch_branch.
+static iree_host_size_t iree_vm_bytecode_jit_emit_branch(
+    iree_vm_bytecode_jit_buffer_t* buffer) {
+  // jmp rel32
+  iree_vm_bytecode_jit_emit_u8(buffer, 0xE9);
+  iree_host_size_t fixup = buffer->size;
+  iree_vm_bytecode_jit_emit_u32(buffer, 0);
+  return fixup;
+}
+
+// Resolves the branch at |fixup| to jump to |target|.
+// Returns false if the target is out of range of the branch encoding.
+static bool iree_vm_bytecode_jit_patch_branch(
+    iree_vm_bytecode_jit_buffer_t* buffer, iree_host_size_t fixup,
+    iree_host_size_t target) {
+  int64_t displacement = (int64_t)target - (int64_t)(fixup + 4);
+  if (displacement < INT32_MIN || displacement > INT32_MAX) return false;
+  iree_vm_bytecode_jit_store_u32(buffer, fixup, (uint32_t)displacement);
+  return true;
+}
+
+// Returns |pc| to the interpreter.
+static void iree_vm_bytecode_jit_emit_exit(
+    iree_vm_bytecode_jit_buffer_t* buffer, uint32_t pc) {
+  // mov eax, imm32; ret
+  iree_vm_bytecode_jit_emit_load_imm(buffer, pc);
+  iree_vm_bytecode_jit_emit_u8(buffer, 0xC3);
+}
+
+// Pads the buffer to the preferred function alignment with int3.
+static void iree_vm_bytecode_jit_emit_function_alignment(
+    iree_vm_bytecode_jit_buffer_t* buffer) {
+  while (iree_status_is_ok(buffer->status) && (buffer->size % 16) != 0) {
+    iree_vm_bytecode_jit_emit_u8(buffer, 0xCC);
+  }
+}
+
+#elif defined(IREE_VM_BYTECODE_JIT_ARCH_ARM_64)
+
+// AAPCS64: the register file base arrives in x0 and the resume pc is returned
+// in w0. Scratch registers 0-2 are w1, w2, and w3.
+#define IREE_VM_BYTECODE_JIT_A64_X0 0
+#define IREE_VM_BYTECODE_JIT_A64_ZR 31
+
+// The unsigned 12-bit scaled offset of ldr/str limits us to 4096 registers.
+#define IREE_VM_BYTECODE_JIT_MAX_I32_REGISTER_COUNT 4096
+
+// AArch64 condition codes as used by b.cond/csel/csinc.
+static const uint8_t iree_vm_bytecode_jit_a64_cond_codes[6] = {
+    0x0,  // EQ: EQ
+    0x1,  // NE: NE
+    0xB,  // LT_S: LT
+    0xA,  // GE_S: GE
+    0x3,  // LT_U: LO
+    0x2,  // GE_U: HS
+};
+
+static uint32_t iree_vm_bytecode_jit_load_u32(
+    const iree_vm_bytecode_jit_buffer_t* buffer, iree_host_size_t offset) {
+  const uint8_t* p = buffer->data + offset;
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+static inline uint32_t iree_vm_bytecode_jit_a64_scratch(uint8_t scratch) {
+  return 1u + scratch;
+}
+
+// ldr w<scratch>, [x0, #byte_offset]
+static void iree_vm_bytecode_jit_emit_load(
+    iree_vm_bytecode_jit_buffer_t* buffer, uint8_t scratch,
+    uint32_t byte_offset) {
+  iree_vm_bytecode_jit_emit_u32(
+      buffer, 0xB9400000u | ((byte_offset / 4) << 10) |
+                  (IREE_VM_BYTECODE_JIT_A64_X0 << 5) |
+                  iree_vm_bytecode_jit_a64_scratch(scratch));
+}
+
+// str w1, [x0, #byte_offset]
+static void iree_vm_bytecode_jit_emit_store(
+    iree_vm_bytecode_jit_buffer_t* buffer, uint32_t byte_offset) {
+  iree_vm_bytecode_jit_emit_u32(
+      buffer, 0xB9000000u | ((byte_offset / 4) << 10) |
+                  (IREE_VM_BYTECODE_JIT_A64_X0 << 5) |
+                  iree_vm_bytecode_jit_a64_scratch(0));
+}
+
+// movz/movk w<rd>, #value
+static void iree_vm_bytecode_jit_emit_mov_imm(
+    iree_vm_bytecode_jit_buffer_t* buffer, uint32_t rd, uint32_t value) {
+  iree_vm_bytecode_jit_emit_u32(buffer,
+                                0x52800000u | ((value & 0xFFFF) << 5) | rd);
+  if (value >> 16) {
+    iree_vm_bytecode_jit_emit_u32(buffer,
+                                  0x72A00000u | ((value >> 16) << 5) | rd);
+  }
+}
+
+// mov w1, #value
+static void iree_vm_bytecode_jit_emit_load_imm(
+    iree_vm_bytecode_jit_buffer_t* buffer, uint32_t value) {
+  iree_vm_bytecode_jit_emit_mov_imm(buffer, iree_vm_bytecode_jit_a64_scratch(0),
+                                    value);
+}
+
+// w1 = w1 <op> w2
+static void iree_vm_bytecode_jit_emit_binary(
+    iree_vm_bytecode_jit_buffer_t* buffer,
+    iree_vm_bytecode_jit_binary_op_t op) {
+  static const uint32_t kOpcodes[] = {
+      0x0B000000u,  // ADD: add
+      0x4B000000u,  // SUB: sub
+      0x1B007C00u,  // MUL: madd with wzr addend
+      0x0A000000u,  // AND: and
+      0x2A000000u,  // OR: orr
+      0x4A000000u,  // XOR: eor
+      0x1AC02000u,  // SHL: lslv (masks the amount to 5 bits)
+      0x1AC02800u,  // SHR_S: asrv
+      0x1AC02400u,  // SHR_U: lsrv
+  };
+  const uint32_t rd = iree_vm_bytecode_jit_a64_scratch(0);
+  const uint32_t rm = iree_vm_bytecode_jit_a64_scratch(1);
+  iree_vm_bytecode_jit_emit_u32(buffer,
+                                kOpcodes[op] | (rm << 16) | (rd << 5) | rd);
+}
+
+// w1 = ~w1
+static void iree_vm_bytecode_jit_emit_not(
+    iree_vm_bytecode_jit_buffer_t* buffer) {
+  // orn w1, wzr, w1
+  const uint32_t rd = iree_vm_bytecode_jit_a64_scratch(0);
+  iree_vm_bytecode_jit_emit_u32(buffer, 0x2A200000u | (rd << 16) |
+                                            (IREE_VM_BYTECODE_JIT_A64_ZR << 5) |
+                                            rd);
+}
+
+// Sets flags from w1 - w2 (|with_zero| = false) or w1 - 0 (true).
+static void iree_vm_bytecode_jit_emit_compare(
+    iree_vm_bytecode_jit_buffer_t* buffer, bool with_zero) {
+  const uint32_t rn = iree_vm_bytecode_jit_a64_scratch(0);
+  if (with_zero) {
+    // cmp w1, #0
+    iree_vm_bytecode_jit_emit_u32(
+        buffer, 0x71000000u | (rn << 5) | IREE_VM_BYTECODE_JIT_A64_ZR);
+  } else {
+    // cmp w1, w2
+    const uint32_t rm = iree_vm_bytecode_jit_a64_scratch(1);
+    iree_vm_bytecode_jit_emit_u32(buffer, 0x6B000000u | (rm << 16) |
+                                              (rn << 5) |
+                                              IREE_VM_BYTECODE_JIT_A64_ZR);
+  }
+}
+
+// w1 = |cond| ? 1 : 0
+static void iree_vm_bytecode_jit_emit_set_cond(
+    iree_vm_bytecode_jit_buffer_t* buffer, iree_vm_bytecode_jit_cond_t cond) {
+  // cset w1, cond == csinc w1, wzr, wzr, !cond
+  const uint32_t rd = iree_vm_bytecode_jit_a64_scratch(0);
+  const uint32_t inverse_cond =
+      iree_vm_bytecode_jit_a64_cond_codes[iree_vm_bytecode_jit_cond_invert(
+          cond)];
+  iree_vm_bytecode_jit_emit_u32(
+      buffer, 0x1A800400u | (IREE_VM_BYTECODE_JIT_A64_ZR << 16) |
+                  (inverse_cond << 12) | (IREE_VM_BYTECODE_JIT_A64_ZR << 5) |
+                  rd);
+}
+
+// w1 = w3 ? w1 : w2
+static void iree_vm_bytecode_jit_emit_select(
+    iree_vm_bytecode_jit_buffer_t* buffer) {
+  const uint32_t rd = iree_vm_bytecode_jit_a64_scratch(0);
+  const uint32_t rm = iree_vm_bytecode_jit_a64_scratch(1);
+  const uint32_t rc = iree_vm_bytecode_jit_a64_scratch(2);
+  // cmp w3, #0
+  iree_vm_bytecode_jit_emit_u32(
+      buffer, 0x71000000u | (rc << 5) | IREE_VM_BYTECODE_JIT_A64_ZR);
+  // csel w1, w1, w2, ne
+  iree_vm_bytecode_jit_emit_u32(
+      buffer, 0x1A800000u | (rm << 16) |
+                  ((uint32_t)iree_vm_bytecode_jit_a64_cond_codes
+                       [IREE_VM_BYTECODE_JIT_COND_NE]
+                   << 12) |
+                  (rd << 5) | rd);
+}
+
+// Emits a conditional branch with an unresolved target and returns the fixup
+// location to pass to iree_vm_bytecode_jit_patch_branch.
+static iree_host_size_t iree_vm_bytecode_jit_emit_branch_cond(
+    iree_vm_bytecode_jit_buffer_t* buffer, iree_vm_bytecode_jit_cond_t cond) {
+  // b.cond #0
+  iree_host_size_t fixup = buffer->size;
+  iree_vm_bytecode_jit_emit_u32(
+      buffer, 0x54000000u | iree_vm_bytecode_jit_a64_cond_codes[cond]);
+  return fixup;
+}
+
+// Emits an unconditional branch with an unresolved target and returns the
+// fixup location to pass to iree_vm_bytecode_jit_patch_branch.
+static iree_host_size_t iree_vm_bytecode_jit_emit_branch(
+    iree_vm_bytecode_jit_buffer_t* buffer) {
+  // b #0
+  iree_host_size_t fixup = buffer->size;
+  iree_vm_bytecode_jit_emit_u32(buffer, 0x14000000u);
+  return fixup;
+}
+
+// Resolves the branch at |fixup| to jump to |target|.
+// Returns false if the target is out of range of the branch encoding.
+static bool iree_vm_bytecode_jit_patch_branch(
+    iree_vm_bytecode_jit_buffer_t* buffer, iree_host_size_t fixup,
+    iree_host_size_t target) {
+  int64_t displacement = ((int64_t)target - (int64_t)fixup) / 4;
+  uint32_t insn = iree_vm_bytecode_jit_load_u32(buffer, fixup);
+  if ((insn & 0xFC000000u) == 0x14000000u) {
+    // b: imm26
+    if (displacement < -(1 << 25) || displacement >= (1 << 25)) return false;
+    insn |= (uint32_t)displacement & 0x03FFFFFFu;
+  } else {
+    // b.cond: imm19
+    if (displacement < -(1 << 18) || displacement >= (1 << 18)) return false;
+    insn |= ((uint32_t)displacement & 0x7FFFFu) << 5;
+  }
+  iree_vm_bytecode_jit_store_u32(buffer, fixup, insn);
+  return true;
+}
+
+// Returns |pc| to the interpreter.
+static void iree_vm_bytecode_jit_emit_exit(
+    iree_vm_bytecode_jit_buffer_t* buffer, uint32_t pc) {
+  // mov w0, #pc; ret
+  iree_vm_bytecode_jit_emit_mov_imm(buffer, 0, pc);
+  iree_vm_bytecode_jit_emit_u32(buffer, 0xD65F03C0u);
+}
+
+// Pads the buffer to the preferred function alignment with udf.
+static void iree_vm_bytecode_jit_emit_function_alignment(
+    iree_vm_bytecode_jit_buffer_t* buffer) {
+  while (iree_status_is_ok(buffer->status) && (buffer->size % 16) != 0) {
+    iree_vm_bytecode_jit_emit_u32(buffer, 0x00000000u);
+  }
+}
+
+#endif  // IREE_VM_BYTECODE_JIT_ARCH_*
+
+//===----------------------------------------------------------------------===//
+// Bytecode translation
+//===----------------------------------------------------------------------===//
+
+// A branch to a bytecode pc that is resolved once the function is translated.
+typedef struct iree_vm_bytecode_jit_fixup_t {
+  iree_host_size_t location;
+  uint32_t target_pc;
+} iree_vm_bytecode_jit_fixup_t;
+
+// Per-function translation state. Storage is reused across functions.
+typedef struct iree_vm_bytecode_jit_function_state_t {
+  iree_allocator_t host_allocator;
+
+  // Bytecode of the function being translated.
+  const uint8_t* bytecode_data;
+  uint32_t bytecode_length;
+  uint32_t pc;
+
+  // Mask applied to i32 register ordinals; matches the interpreter.
+  uint32_t i32_mask;
+
+  // Maps bytecode pc to the offset of the native code in the buffer or -1 if
+  // no op starting at the pc has been translated.
+  int64_t* pc_map;
+  iree_host_size_t pc_map_capacity;
+
+  // Branches to bytecode pcs pending resolution.
+  iree_vm_bytecode_jit_fixup_t* fixups;
+  iree_host_size_t fixup_count;
+  iree_host_size_t fixup_capacity;
+} iree_vm_bytecode_jit_function_state_t;
+
+static bool iree_vm_bytecode_jit_can_read(
+    const iree_vm_bytecode_jit_function_state_t* state,
+    iree_host_size_t length) {
+  return state->pc + length <= state->bytecode_length;
+}
+
+static void iree_vm_bytecode_jit_align_pc(
+    iree_vm_bytecode_jit_function_state_t* state) {
+  state->pc = (state->pc + 1) & ~1u;
+}
+
+static bool iree_vm_bytecode_jit_read_u16(
+    iree_vm_bytecode_jit_function_state_t* state, uint16_t* out_value) {
+  if (!iree_vm_bytecode_jit_can_read(state, 2)) return false;
+  const uint8_t* p = state->bytecode_data + state->pc;
+  *out_value = (uint16_t)(p[0] | (p[1] << 8));
+  state->pc += 2;
+  return true;
+}
+
+static bool iree_vm_bytecode_jit_read_u32(
+    iree_vm_bytecode_jit_function_state_t* state, uint32_t* out_value) {
+  if (!iree_vm_bytecode_jit_can_read(state, 4)) return false;
+  const uint8_t* p = state->bytecode_data + state->pc;
+  *out_value = (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+               ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+  state->pc += 4;
+  return true;
+}
+
+// Reads an i32 register ordinal and returns its byte offset in the bank.
+static bool iree_vm_bytecode_jit_read_reg(
+    iree_vm_bytecode_jit_function_state_t* state, uint32_t* out_offset) {
+  uint16_t reg = 0;
+  if (!iree_vm_bytecode_jit_read_u16(state, &reg)) return false;
+  *out_offset = (reg & state->i32_mask) * sizeof(int32_t);
+  return true;
+}
+
+// Records a branch at |location| to |target_pc| for later resolution.
+static bool iree_vm_bytecode_jit_add_fixup(
+    iree_vm_bytecode_jit_function_state_t* state,
+    iree_vm_bytecode_jit_buffer_t* buffer, iree_host_size_t location,
+    uint32_t target_pc) {
+  if (!iree_status_is_ok(buffer->status)) return false;
+  if (state->fixup_count == state->fixup_capacity) {
+    iree_host_size_t new_capacity = iree_max(state->fixup_capacity * 2, 16);
+    buffer->status = iree_allocator_realloc(
+        state->host_allocator, new_capacity * sizeof(*state->fixups),
+        (void**)&state->fixups);
+    if (!iree_status_is_ok(buffer->status)) return false;
+    state->fixup_capacity = new_capacity;
+  }
+  state->fixups[state->fixup_count].location = location;
+  state->fixups[state->fixup_count].target_pc = target_pc;
+  ++state->fixup_count;
+  return true;
+}
+
+// Emits the register moves of a branch remap list followed by a branch to
+// |target_pc|. Ref registers cannot be handled in native code and cause the
+// translation of the op to fail.
+static bool iree_vm_bytecode_jit_translate_branch_to(
+    iree_vm_bytecode_jit_function_state_t* state,
+    iree_vm_bytecode_jit_buffer_t* buffer, uint32_t target_pc) {
+  iree_vm_bytecode_jit_align_pc(state);
+  uint16_t remap_count = 0;
+  if (!iree_vm_bytecode_jit_read_u16(state, &remap_count)) return false;
+  // Remapping is performed as sequential moves just as in the interpreter.
+  for (uint16_t i = 0; i < remap_count; ++i) {
+    uint16_t src_reg = 0;
+    uint16_t dst_reg = 0;
+    if (!iree_vm_bytecode_jit_read_u16(state, &src_reg) ||
+        !iree_vm_bytecode_jit_read_u16(state, &dst_reg)) {
+      return false;
+    }
+    if (src_reg & IREE_REF_REGISTER_TYPE_BIT) return false;
+    iree_vm_bytecode_jit_emit_load(buffer, 0,
+                                   (src_reg & state->i32_mask) * 4);
+    iree_vm_bytecode_jit_emit_store(buffer, (dst_reg & state->i32_mask) * 4);
+  }
+  iree_host_size_t fixup = iree_vm_bytecode_jit_emit_branch(buffer);
+  return iree_vm_bytecode_jit_add_fixup(state, buffer, fixup, target_pc);
+}
+
+// Emits a two-way branch to the true and false destinations (with their remap
+// lists) of a conditional branch op once flags have been set by a compare.
+static bool iree_vm_bytecode_jit_translate_cond_branch_tail(
+    iree_vm_bytecode_jit_function_state_t* state,
+    iree_vm_bytecode_jit_buffer_t* buffer, iree_vm_bytecode_jit_cond_t cond) {
+  iree_host_size_t false_fixup = iree_vm_bytecode_jit_emit_branch_cond(
+      buffer, iree_vm_bytecode_jit_cond_invert(cond));
+  uint32_t true_pc = 0;
+  if (!iree_vm_bytecode_jit_read_u32(state, &true_pc) ||
+      !iree_vm_bytecode_jit_translate_branch_to(state, buffer, true_pc)) {
+    return false;
+  }
+  if (!iree_status_is_ok(buffer->status) ||
+      !iree_vm_bytecode_jit_patch_branch(buffer, false_fixup, buffer->size)) {
+    return false;
+  }
+  uint32_t false_pc = 0;
+  return iree_vm_bytecode_jit_read_u32(state, &false_pc) &&
+         iree_vm_bytecode_jit_translate_branch_to(state, buffer, false_pc);
+}
+
+// Returns true if |opcode| is an i32 binary op and sets |out_op| to it.
+static bool iree_vm_bytecode_jit_lookup_binary_op(
+    uint8_t opcode, iree_vm_bytecode_jit_binary_op_t* out_op) {
+  switch (opcode) {
+    case IREE_VM_OP_CORE_AddI32:
+      *out_op = IREE_VM_BYTECODE_JIT_BINARY_OP_ADD;
+      return true;
+    case IREE_VM_OP_CORE_SubI32:
+      *out_op = IREE_VM_BYTECODE_JIT_BINARY_OP_SUB;
+      return true;
+    case IREE_VM_OP_CORE_MulI32:
+      *out_op = IREE_VM_BYTECODE_JIT_BINARY_OP_MUL;
+      return true;
+    case IREE_VM_OP_CORE_AndI32:
+      *out_op = IREE_VM_BYTECODE_JIT_BINARY_OP_AND;
+      return true;
+    case IREE_VM_OP_CORE_OrI32:
+      *out_op = IREE_VM_BYTECODE_JIT_BINARY_OP_OR;
+      return true;
+    case IREE_VM_OP_CORE_XorI32:
+      *out_op = IREE_VM_BYTECODE_JIT_BINARY_OP_XOR;
+      return true;
+    case IREE_VM_OP_CORE_ShlI32:
+      *out_op = IREE_VM_BYTECODE_JIT_BINARY_OP_SHL;
+      return true;
+    case IREE_VM_OP_CORE_ShrI32S:
+      *out_op = IREE_VM_BYTECODE_JIT_BINARY_OP_SHR_S;
+      return true;
+    case IREE_VM_OP_CORE_ShrI32U:
+      *out_op = IREE_VM_BYTECODE_JIT_BINARY_OP_SHR_U;
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns true if |opcode| is an i32 binary compare (either producing a value
+// or fused with a conditional branch) and sets |out_cond| to its condition.
+static bool iree_vm_bytecode_jit_lookup_cmp_op(
+    uint8_t opcode, iree_vm_bytecode_jit_cond_t* out_cond,
+    bool* out_is_branch) {
+  *out_is_branch = false;
+  switch (opcode) {
+    case IREE_VM_OP_CORE_CmpEQI32:
+      *out_cond = IREE_VM_BYTECODE_JIT_COND_EQ;
+      return true;
+    case IREE_VM_OP_CORE_CondBranchEQI32:
+      *out_cond = IREE_VM_BYTECODE_JIT_COND_EQ;
+      *out_is_branch = true;
+      return true;
+    case IREE_VM_OP_CORE_CmpNEI32:
+      *out_cond = IREE_VM_BYTECODE_JIT_COND_NE;
+      return true;
+    case IREE_VM_OP_CORE_CondBranchNEI32:
+      *out_cond = IREE_VM_BYTECODE_JIT_COND_NE;
+      *out_is_branch = true;
+      return true;
+    case IREE_VM_OP_CORE_CmpLTI32S:
+      *out_cond = IREE_VM_BYTECODE_JIT_COND_LT_S;
+      return true;
+    case IREE_VM_OP_CORE_CondBranchLTI32S:
+      *out_cond = IREE_VM_BYTECODE_JIT_COND_LT_S;
+      *out_is_branch = true;
+      return true;
+    case IREE_VM_OP_CORE_CmpLTI32U:
+      *out_cond = IREE_VM_BYTECODE_JIT_COND_LT_U;
+      return true;
+    case IREE_VM_OP_CORE_CondBranchLTI32U:
+      *out_cond = IREE_VM_BYTECODE_JIT_COND_LT_U;
+      *out_is_branch = true;
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Translates the op at the current pc.
+// Returns false if the op is not supported, in which case the caller discards
+// any code emitted for it.
+static bool iree_vm_bytecode_jit_translate_op(
+    iree_vm_bytecode_jit_function_state_t* state,
+    iree_vm_bytecode_jit_buffer_t* buffer) {
+  if (!iree_vm_bytecode_jit_can_read(state, 1)) return false;
+  uint8_t opcode = state->bytecode_data[state->pc++];
+  uint32_t lhs = 0, rhs = 0, operand = 0, result = 0;
+
+  iree_vm_bytecode_jit_binary_op_t binary_op;
+  if (iree_vm_bytecode_jit_lookup_binary_op(opcode, &binary_op)) {
+    if (!iree_vm_bytecode_jit_read_reg(state, &lhs) ||
+        !iree_vm_bytecode_jit_read_reg(state, &rhs) ||
+        !iree_vm_bytecode_jit_read_reg(state, &result)) {
+      return false;
+    }
+    iree_vm_bytecode_jit_emit_load(buffer, 0, lhs);
+    iree_vm_bytecode_jit_emit_load(buffer, 1, rhs);
+    iree_vm_bytecode_jit_emit_binary(buffer, binary_op);
+    iree_vm_bytecode_jit_emit_store(buffer, result);
+    return true;
+  }
+
+  iree_vm_bytecode_jit_cond_t cond;
+  bool is_branch = false;
+  if (iree_vm_bytecode_jit_lookup_cmp_op(opcode, &cond, &is_branch)) {
+    if (!iree_vm_bytecode_jit_read_reg(state, &lhs) ||
+        !iree_vm_bytecode_jit_read_reg(state, &rhs)) {
+      return false;
+    }
+    iree_vm_bytecode_jit_emit_load(buffer, 0, lhs);
+    iree_vm_bytecode_jit_emit_load(buffer, 1, rhs);
+    iree_vm_bytecode_jit_emit_compare(buffer, /*with_zero=*/false);
+    if (is_branch) {
+      return iree_vm_bytecode_jit_translate_cond_branch_tail(state, buffer,
+                                                             cond);
+    }
+    if (!iree_vm_bytecode_jit_read_reg(state, &result)) return false;
+    iree_vm_bytecode_jit_emit_set_cond(buffer, cond);
+    iree_vm_bytecode_jit_emit_store(buffer, result);
+    return true;
+  }
+
+  switch (opcode) {
+    case IREE_VM_OP_CORE_ConstI32: {
+      uint32_t value = 0;
+      if (!iree_vm_bytecode_jit_read_u32(state, &value) ||
+          !iree_vm_bytecode_jit_read_reg(state, &result)) {
+        return false;
+      }
+      iree_vm_bytecode_jit_emit_load_imm(buffer, value);
+      iree_vm_bytecode_jit_emit_store(buffer, result);
+      return true;
+    }
+    case IREE_VM_OP_CORE_ConstI32Zero: {
+      if (!iree_vm_bytecode_jit_read_reg(state, &result)) return false;
+      iree_vm_bytecode_jit_emit_load_imm(buffer, 0);
+      iree_vm_bytecode_jit_emit_store(buffer, result);
+      return true;
+    }
+    case IREE_VM_OP_CORE_NotI32: {
+      if (!iree_vm_bytecode_jit_read_reg(state, &operand) ||
+          !iree_vm_bytecode_jit_read_reg(state, &result)) {
+        return false;
+      }
+      iree_vm_bytecode_jit_emit_load(buffer, 0, operand);
+      iree_vm_bytecode_jit_emit_not(buffer);
+      iree_vm_bytecode_jit_emit_store(buffer, result);
+      return true;
+    }
+    case IREE_VM_OP_CORE_CmpNZI32: {
+      if (!iree_vm_bytecode_jit_read_reg(state, &operand) ||
+          !iree_vm_bytecode_jit_read_reg(state, &result)) {
+        return false;
+      }
+      iree_vm_bytecode_jit_emit_load(buffer, 0, operand);
+      iree_vm_bytecode_jit_emit_compare(buffer, /*with_zero=*/true);
+      iree_vm_bytecode_jit_emit_set_cond(buffer, IREE_VM_BYTECODE_JIT_COND_NE);
+      iree_vm_bytecode_jit_emit_store(buffer, result);
+      return true;
+    }
+    case IREE_VM_OP_CORE_SelectI32: {
+      uint32_t condition = 0, true_value = 0, false_value = 0;
+      if (!iree_vm_bytecode_jit_read_reg(state, &condition) ||
+          !iree_vm_bytecode_jit_read_reg(state, &true_value) ||
+          !iree_vm_bytecode_jit_read_reg(state, &false_value) ||
+          !iree_vm_bytecode_jit_read_reg(state, &result)) {
+        return false;
+      }
+      iree_vm_bytecode_jit_emit_load(buffer, 0, true_value);
+      iree_vm_bytecode_jit_emit_load(buffer, 1, false_value);
+      iree_vm_bytecode_jit_emit_load(buffer, 2, condition);
+      iree_vm_bytecode_jit_emit_select(buffer);
+      iree_vm_bytecode_jit_emit_store(buffer, result);
+      return true;
+    }
+    case IREE_VM_OP_CORE_Branch: {
+      uint32_t target_pc = 0;
+      return iree_vm_bytecode_jit_read_u32(state, &target_pc) &&
+             iree_vm_bytecode_jit_translate_branch_to(state, buffer,
+                                                      target_pc);
+    }
+    case IREE_VM_OP_CORE_CondBranch: {
+      uint32_t condition = 0;
+      if (!iree_vm_bytecode_jit_read_reg(state, &condition)) return false;
+      iree_vm_bytecode_jit_emit_load(buffer, 0, condition);
+      iree_vm_bytecode_jit_emit_compare(buffer, /*with_zero=*/true);
+      return iree_vm_bytecode_jit_translate_cond_branch_tail(
+          state, buffer, IREE_VM_BYTECODE_JIT_COND_NE);
+    }
+    default:
+      // Everything else is left to the interpreter.
+      return false;
+  }
+}
+
+// Translates the longest supported prefix of |function_ordinal| into |buffer|.
+// Returns the buffer offset of the function entry point in |out_entry| or -1
+// if nothing could be translated.
+static iree_status_t iree_vm_bytecode_jit_translate_function(
+    const iree_vm_bytecode_module_t* module, uint16_t function_ordinal,
+    iree_vm_bytecode_jit_function_state_t* state,
+    iree_vm_bytecode_jit_buffer_t* buffer, int64_t* out_entry) {
+  *out_entry = -1;
+  const iree_vm_FunctionDescriptor_t* descriptor =
+      &module->function_descriptor_table[function_ordinal];
+  uint32_t i32_register_count = iree_math_round_up_to_pow2_u32(
+      VMMAX(1, descriptor->i32_register_count));
+  if (descriptor->bytecode_length <= 0 ||
+      i32_register_count > IREE_VM_BYTECODE_JIT_MAX_I32_REGISTER_COUNT) {
+    return iree_ok_status();
+  }
+
+  state->bytecode_data =
+      module->bytecode_data.data + descriptor->bytecode_offset;
+  state->bytecode_length = (uint32_t)descriptor->bytecode_length;
+  state->pc = 0;
+  state->i32_mask = i32_register_count - 1;
+  state->fixup_count = 0;
+  if (state->pc_map_capacity < state->bytecode_length) {
+    IREE_RETURN_IF_ERROR(iree_allocator_realloc(
+        state->host_allocator, state->bytecode_length * sizeof(int64_t),
+        (void**)&state->pc_map));
+    state->pc_map_capacity = state->bytecode_length;
+  }
+  for (uint32_t i = 0; i < state->bytecode_length; ++i) state->pc_map[i] = -1;
+
+  iree_vm_bytecode_jit_emit_function_alignment(buffer);
+  IREE_RETURN_IF_ERROR(buffer->status);
+  const iree_host_size_t function_start = buffer->size;
+
+  // Translate ops until the first unsupported one, which becomes an exit.
+  iree_host_size_t translated_op_count = 0;
+  for (;;) {
+    const uint32_t op_pc = state->pc;
+    const iree_host_size_t op_start = buffer->size;
+    const iree_host_size_t op_fixup_count = state->fixup_count;
+    if (op_pc < state->bytecode_length) state->pc_map[op_pc] = op_start;
+    if (!iree_vm_bytecode_jit_translate_op(state, buffer)) {
+      IREE_RETURN_IF_ERROR(buffer->status);
+      buffer->size = op_start;
+      state->fixup_count = op_fixup_count;
+      iree_vm_bytecode_jit_emit_exit(buffer, op_pc);
+      break;
+    }
+    ++translated_op_count;
+  }
+  IREE_RETURN_IF_ERROR(buffer->status);
+
+  // Resolve branches. Targets outside of the translated prefix exit to the
+  // interpreter at the target pc.
+  bool branches_in_range = true;
+  for (iree_host_size_t i = 0; i < state->fixup_count; ++i) {
+    const iree_vm_bytecode_jit_fixup_t* fixup = &state->fixups[i];
+    int64_t target = fixup->target_pc < state->bytecode_length
+                         ? state->pc_map[fixup->target_pc]
+                         : -1;
+    if (target < 0) {
+      target = (int64_t)buffer->size;
+      iree_vm_bytecode_jit_emit_exit(buffer, fixup->target_pc);
+      IREE_RETURN_IF_ERROR(buffer->status);
+    }
+    branches_in_range &= iree_vm_bytecode_jit_patch_branch(
+        buffer, fixup->location, (iree_host_size_t)target);
+  }
+
+  if (translated_op_count == 0 || !branches_in_range) {
+    // Nothing worth running natively; interpret the entire function.
+    buffer->size = function_start;
+    return iree_ok_status();
+  }
+  *out_entry = (int64_t)function_start;
+  return iree_ok_status();
+}
+
+// Copies the code in |buffer| into newly allocated executable memory.
+static iree_status_t iree_vm_bytecode_jit_commit_code(
+    iree_vm_bytecode_jit_t* jit, const iree_vm_bytecode_jit_buffer_t* buffer) {
+  iree_memory_info_t memory_info;
+  iree_memory_query_info(&memory_info);
+  iree_host_size_t code_capacity =
+      iree_host_align(buffer->size, memory_info.normal_page_size);
+  IREE_RETURN_IF_ERROR(iree_memory_view_reserve(
+      IREE_MEMORY_VIEW_FLAG_MAY_EXECUTE, code_capacity, jit->host_allocator,
+      &jit->code_base));
+  jit->code_capacity = code_capacity;
+
+  iree_byte_range_t code_range = {0, code_capacity};
+  IREE_RETURN_IF_ERROR(iree_memory_view_commit_ranges(
+      jit->code_base, 1, &code_range,
+      IREE_MEMORY_ACCESS_READ | IREE_MEMORY_ACCESS_WRITE));
+
+  // W^X: code is written while the pages are RW and then flipped to RX.
+  iree_memory_jit_context_begin();
+  memcpy(jit->code_base, buffer->data, buffer->size);
+  iree_status_t status = iree_memory_view_protect_ranges(
+      jit->code_base, 1, &code_range,
+      IREE_MEMORY_ACCESS_READ | IREE_MEMORY_ACCESS_EXECUTE);
+  if (iree_status_is_ok(status)) {
+    iree_memory_view_flush_icache(jit->code_base, buffer->size);
+  }
+  iree_memory_jit_context_end();
+  return status;
+}
+
+#endif  // IREE_VM_BYTECODE_JIT_ARCH_SUPPORTED
+
+//===----------------------------------------------------------------------===//
+// iree_vm_bytecode_jit_t
+//===----------------------------------------------------------------------===//
+
+bool iree_vm_bytecode_jit_is_supported(void) {
+#if defined(IREE_VM_BYTECODE_JIT_ARCH_SUPPORTED)
+  iree_memory_info_t memory_info;
+  iree_memory_query_info(&memory_info);
+  return memory_info.can_allocate_executable_pages;
+#else
+  return false;
+#endif  // IREE_VM_BYTECODE_JIT_ARCH_SUPPORTED
+}
+
+iree_status_t iree_vm_bytecode_jit_create(
+    const iree_vm_bytecode_module_t* module, iree_allocator_t host_allocator,
+    iree_vm_bytecode_jit_t** out_jit) {
+  IREE_ASSERT_ARGUMENT(module);
+  IREE_ASSERT_ARGUMENT(out_jit);
+  *out_jit = NULL;
+  if (!iree_vm_bytecode_jit_is_supported() ||
+      module->function_descriptor_count == 0) {
+    return iree_ok_status();
+  }
+#if defined(IREE_VM_BYTECODE_JIT_ARCH_SUPPORTED)
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_vm_bytecode_jit_t* jit = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(
+              host_allocator,
+              sizeof(*jit) + module->function_descriptor_count *
+                                 sizeof(jit->entry_points[0]),
+              (void**)&jit));
+  memset(jit, 0, sizeof(*jit));
+  jit->host_allocator = host_allocator;
+  jit->function_count = module->function_descriptor_count;
+
+  // Buffer offsets of each function entry point (or -1 if not translated) that
+  // are turned into entry points once the code is in its final location.
+  int64_t* entry_offsets = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, jit->function_count * sizeof(int64_t),
+      (void**)&entry_offsets);
+
+  iree_vm_bytecode_jit_buffer_t buffer;
+  memset(&buffer, 0, sizeof(buffer));
+  buffer.host_allocator = host_allocator;
+  buffer.status = iree_ok_status();
+  iree_vm_bytecode_jit_function_state_t state;
+  memset(&state, 0, sizeof(state));
+  state.host_allocator = host_allocator;
+
+  bool any_translated = false;
+  for (iree_host_size_t i = 0;
+       iree_status_is_ok(status) && i < jit->function_count; ++i) {
+    status = iree_vm_bytecode_jit_translate_function(
+        module, (uint16_t)i, &state, &buffer, &entry_offsets[i]);
+    any_translated |= entry_offsets[i] >= 0;
+  }
+  if (iree_status_is_ok(status) && any_translated) {
+    status = iree_vm_bytecode_jit_commit_code(jit, &buffer);
+  }
+  if (iree_status_is_ok(status) && any_translated) {
+    for (iree_host_size_t i = 0; i < jit->function_count; ++i) {
+      jit->entry_points[i] =
+          entry_offsets[i] >= 0
+              ? (iree_vm_bytecode_jit_entry_fn_t)((uintptr_t)jit->code_base +
+                                                  entry_offsets[i])
+              : NULL;
+    }
+  }
+
+  iree_allocator_free(host_allocator, state.fixups);
+  iree_allocator_free(host_allocator, state.pc_map);
+  iree_allocator_free(host_allocator, buffer.data);
+  iree_allocator_free(host_allocator, entry_offsets);
+
+  if (iree_status_is_ok(status) && any_translated) {
+    *out_jit = jit;
+  } else {
+    iree_vm_bytecode_jit_destroy(jit);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+#else
+  return iree_ok_status();
+#endif  // IREE_VM_BYTECODE_JIT_ARCH_SUPPORTED
+}
+
+void iree_vm_bytecode_jit_destroy(iree_vm_bytecode_jit_t* jit) {
+  if (!jit) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  if (jit->code_base) {
+    iree_memory_view_release(jit->code_base, jit->code_capacity,
+                             jit->host_allocator);
+  }
+  iree_allocator_free(jit->host_allocator, jit);
+  IREE_TRACE_ZONE_END(z0);
+}
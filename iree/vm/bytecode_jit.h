@@ -0,0 +1,80 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_VM_BYTECODE_JIT_H_
+#define IREE_VM_BYTECODE_JIT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/vm/bytecode_module_impl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// A baseline JIT translating bytecode function prefixes to native code.
+//
+// Translation is a single linear pass over each function starting at pc 0 that
+// stops at the first op it cannot translate. Only ops that touch nothing but
+// the i32 register bank are supported (constants, integer arithmetic, compares,
+// selects, and branches with i32-only operand remapping). Everything else -
+// calls, returns, refs, globals, and any op after the translated prefix - is
+// handled by the interpreter: native code exits by returning the bytecode pc
+// at which the interpreter should resume and the register file is left exactly
+// as if the interpreter had executed the translated ops itself.
+//
+// Currently supported on x86-64 (System V ABI) and AArch64. On other targets,
+// or when the platform does not allow executable pages to be allocated, no
+// functions are translated and the module runs entirely in the interpreter.
+
+// Native entry point of a translated function.
+// Executes from the start of the function against the i32 register bank of its
+// frame and returns the bytecode pc at which the interpreter must resume.
+typedef int32_t (*iree_vm_bytecode_jit_entry_fn_t)(int32_t* i32_registers);
+
+// JIT-compiled code for all functions within a bytecode module.
+typedef struct iree_vm_bytecode_jit_t {
+  // Allocator used for the JIT storage and the executable memory view.
+  iree_allocator_t host_allocator;
+
+  // Executable memory containing the code of all translated functions.
+  void* code_base;
+  iree_host_size_t code_capacity;
+
+  // Entry points of each internal function indexed by function ordinal.
+  // NULL if the function was not translated.
+  iree_host_size_t function_count;
+  iree_vm_bytecode_jit_entry_fn_t entry_points[];
+} iree_vm_bytecode_jit_t;
+
+// Returns true if the JIT is able to generate code for the current target.
+bool iree_vm_bytecode_jit_is_supported(void);
+
+// Translates the functions in |module| to native code.
+// |out_jit| will be NULL if the JIT is unsupported or no function could be
+// translated, in which case all functions will be interpreted.
+iree_status_t iree_vm_bytecode_jit_create(
+    const iree_vm_bytecode_module_t* module, iree_allocator_t host_allocator,
+    iree_vm_bytecode_jit_t** out_jit);
+
+// Releases the executable memory and storage of |jit|.
+void iree_vm_bytecode_jit_destroy(iree_vm_bytecode_jit_t* jit);
+
+// Returns the native entry point of |function_ordinal| or NULL if the function
+// must be interpreted from the start.
+static inline iree_vm_bytecode_jit_entry_fn_t iree_vm_bytecode_jit_lookup(
+    const iree_vm_bytecode_jit_t* jit, uint16_t function_ordinal) {
+  if (!jit || function_ordinal >= jit->function_count) return NULL;
+  return jit->entry_points[function_ordinal];
+}
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_VM_BYTECODE_JIT_H_
@@ -13,6 +13,7 @@
 #include "iree/base/api.h"
 #include "iree/base/tracing.h"
 #include "iree/vm/api.h"
+#include "iree/vm/bytecode_jit.h"
 #include "iree/vm/bytecode_module_impl.h"
 
 // Perform an strcmp between a flatbuffers string and an IREE string view.
@@ -248,6 +249,14 @@ static void iree_vm_bytecode_module_destroy(void* self) {
   iree_vm_bytecode_module_t* module = (iree_vm_bytecode_module_t*)self;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  iree_vm_bytecode_jit_destroy(module->jit);
+  module->jit = NULL;
+
+  // Ensure all rodata references are unused and deinitialized.
+  for (iree_host_size_t i = 0; i < module->rodata_ref_count; ++i) {
+    iree_vm_buffer_deinitialize(&module->rodata_ref_table[i]);
+  }
+
   iree_allocator_free(module->flatbuffer_allocator,
                       (void*)module->flatbuffer_data.data);
   module->flatbuffer_data = iree_make_const_byte_span(NULL, 0);
@@ -655,8 +664,6 @@ static iree_host_size_t iree_vm_bytecode_module_layout_state(
     global_ref_count =
         iree_vm_ModuleStateDef_global_ref_count(module_state_def);
   }
-  iree_host_size_t rodata_ref_count = iree_vm_RodataSegmentDef_vec_len(
-      iree_vm_BytecodeModuleDef_rodata_segments(module_def));
   iree_host_size_t import_function_count = iree_vm_ImportFunctionDef_vec_len(
       iree_vm_BytecodeModuleDef_imported_functions(module_def));
 
@@ -676,12 +683,6 @@ static iree_host_size_t iree_vm_bytecode_module_layout_state(
   }
   offset += iree_host_align(global_ref_count * sizeof(iree_vm_ref_t), 16);
 
-  if (state) {
-    state->rodata_ref_count = rodata_ref_count;
-    state->rodata_ref_table = (iree_vm_buffer_t*)(base_ptr + offset);
-  }
-  offset += iree_host_align(rodata_ref_count * sizeof(iree_vm_buffer_t), 16);
-
   if (state) {
     state->import_count = import_function_count;
     state->import_table = (iree_vm_bytecode_import_t*)(base_ptr + offset);
@@ -716,20 +717,43 @@ static iree_status_t iree_vm_bytecode_module_alloc_state(
   // Perform layout to get the pointers into the storage for each nested table.
   iree_vm_bytecode_module_layout_state(module_def, state);
 
-  // Setup rodata segments to point directly at the flatbuffer memory.
-  iree_vm_RodataSegmentDef_vec_t rodata_segments =
-      iree_vm_BytecodeModuleDef_rodata_segments(module_def);
-  for (int i = 0; i < state->rodata_ref_count; ++i) {
-    iree_vm_RodataSegmentDef_table_t segment =
-        iree_vm_RodataSegmentDef_vec_at(rodata_segments, i);
-    iree_vm_buffer_t* ref = &state->rodata_ref_table[i];
-    iree_vm_buffer_initialize(
-        IREE_VM_BUFFER_ACCESS_ORIGIN_MODULE,
-        iree_make_byte_span(
-            (uint8_t*)iree_vm_RodataSegmentDef_data(segment),
-            flatbuffers_uint8_vec_len(iree_vm_RodataSegmentDef_data(segment))),
-        iree_allocator_null(), ref);
+  *out_module_state = (iree_vm_module_state_t*)state;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_bytecode_module_clone_state(
+    void* self, const iree_vm_module_state_t* source_module_state,
+    iree_allocator_t allocator, iree_vm_module_state_t** out_module_state) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_ASSERT_ARGUMENT(source_module_state);
+  IREE_ASSERT_ARGUMENT(out_module_state);
+  *out_module_state = NULL;
+
+  iree_vm_bytecode_module_t* module = (iree_vm_bytecode_module_t*)self;
+  const iree_vm_bytecode_module_state_t* source_state =
+      (const iree_vm_bytecode_module_state_t*)source_module_state;
+
+  iree_host_size_t total_state_struct_size =
+      iree_vm_bytecode_module_layout_state(module->def, NULL);
+  iree_vm_bytecode_module_state_t* state = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(allocator, total_state_struct_size,
+                                (void**)&state));
+  state->allocator = allocator;
+  iree_vm_bytecode_module_layout_state(module->def, state);
+
+  // Only the mutable globals are copied; the resolved imports reference the
+  // same modules and are valid as-is so long as the cloned state is used in a
+  // context with the same modules registered.
+  memcpy(state->rwdata_storage.data, source_state->rwdata_storage.data,
+         state->rwdata_storage.data_length);
+  for (iree_host_size_t i = 0; i < state->global_ref_count; ++i) {
+    iree_vm_ref_retain((iree_vm_ref_t*)&source_state->global_ref_table[i],
+                       &state->global_ref_table[i]);
   }
+  memcpy(state->import_table, source_state->import_table,
+         state->import_count * sizeof(*state->import_table));
 
   *out_module_state = (iree_vm_module_state_t*)state;
   IREE_TRACE_ZONE_END(z0);
@@ -749,17 +773,43 @@ static void iree_vm_bytecode_module_free_state(
     iree_vm_ref_release(&state->global_ref_table[i]);
   }
 
-  // Ensure all rodata references are unused and deinitialized.
-  for (int i = 0; i < state->rodata_ref_count; ++i) {
-    iree_vm_buffer_t* ref = &state->rodata_ref_table[i];
-    iree_vm_buffer_deinitialize(ref);
-  }
-
   iree_allocator_free(state->allocator, module_state);
 
   IREE_TRACE_ZONE_END(z0);
 }
 
+// Selects the specialized marshaling routine for |cconv_fragment| and returns
+// the number of values that it contains in |out_value_count|.
+static iree_vm_bytecode_import_marshal_t iree_vm_bytecode_import_select_marshal(
+    iree_string_view_t cconv_fragment, uint16_t* out_value_count) {
+  *out_value_count = 0;
+  bool all_i32 = true;
+  bool all_ref = true;
+  uint16_t value_count = 0;
+  for (iree_host_size_t i = 0; i < cconv_fragment.size; ++i) {
+    switch (cconv_fragment.data[i]) {
+      case IREE_VM_CCONV_TYPE_VOID:
+        break;
+      case IREE_VM_CCONV_TYPE_I32:
+      case IREE_VM_CCONV_TYPE_F32:
+        all_ref = false;
+        ++value_count;
+        break;
+      case IREE_VM_CCONV_TYPE_REF:
+        all_i32 = false;
+        ++value_count;
+        break;
+      default:
+        // 64-bit values and variadic spans take the generic path.
+        return IREE_VM_BYTECODE_IMPORT_MARSHAL_GENERIC;
+    }
+  }
+  *out_value_count = value_count;
+  if (all_i32) return IREE_VM_BYTECODE_IMPORT_MARSHAL_I32;
+  if (all_ref) return IREE_VM_BYTECODE_IMPORT_MARSHAL_REF;
+  return IREE_VM_BYTECODE_IMPORT_MARSHAL_GENERIC;
+}
+
 static iree_status_t iree_vm_bytecode_module_resolve_import(
     void* self, iree_vm_module_state_t* module_state, iree_host_size_t ordinal,
     const iree_vm_function_t* function,
@@ -801,32 +851,30 @@ static iree_status_t iree_vm_bytecode_module_resolve_import(
   import->argument_buffer_size = (uint16_t)argument_buffer_size;
   import->result_buffer_size = (uint16_t)result_buffer_size;
 
+  // Pick the marshaling routines used by each call to the import.
+  import->argument_marshal = (uint8_t)iree_vm_bytecode_import_select_marshal(
+      import->arguments, &import->argument_count);
+  import->result_marshal = (uint8_t)iree_vm_bytecode_import_select_marshal(
+      import->results, &import->result_count);
+
   return iree_ok_status();
 }
 
-static iree_status_t iree_vm_bytecode_module_begin_call(
-    void* self, iree_vm_stack_t* stack, const iree_vm_function_call_t* call,
-    iree_vm_execution_result_t* out_result) {
-  // NOTE: any work here adds directly to the invocation time. Avoid doing too
-  // much work or touching too many unlikely-to-be-cached structures (such as
-  // walking the FlatBuffer, which may cause page faults).
-  IREE_TRACE_ZONE_BEGIN(z0);
-  IREE_ASSERT_ARGUMENT(out_result);
-  memset(out_result, 0, sizeof(iree_vm_execution_result_t));
-
+// Resolves the internal function targeted by |call| and its calling
+// convention fragments.
+static iree_status_t iree_vm_bytecode_module_resolve_call(
+    iree_vm_bytecode_module_t* module, const iree_vm_function_call_t* call,
+    iree_string_view_t* out_cconv_arguments,
+    iree_string_view_t* out_cconv_results) {
   // Only internal functions store the information needed for execution. We
   // allow exports here as well to make things easier to call externally.
   iree_vm_function_t function = call->function;
   if (function.linkage != IREE_VM_FUNCTION_LINKAGE_INTERNAL) {
-    IREE_RETURN_AND_END_ZONE_IF_ERROR(
-        z0,
-        iree_vm_bytecode_module_get_function(
-            self, function.linkage, function.ordinal, &function, NULL, NULL));
+    IREE_RETURN_IF_ERROR(iree_vm_bytecode_module_get_function(
+        module, function.linkage, function.ordinal, &function, NULL, NULL));
   }
 
-  iree_vm_bytecode_module_t* module = (iree_vm_bytecode_module_t*)self;
   if (function.ordinal >= module->function_descriptor_count) {
-    IREE_TRACE_ZONE_END(z0);
     return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
                             "function ordinal out of range (0 < %u < %zu)",
                             function.ordinal,
@@ -857,16 +905,67 @@ static iree_status_t iree_vm_bytecode_module_begin_call(
   signature.calling_convention.data = calling_convention;
   signature.calling_convention.size =
       flatbuffers_string_len(calling_convention);
+  *out_cconv_arguments = iree_string_view_empty();
+  *out_cconv_results = iree_string_view_empty();
+  return iree_vm_function_call_get_cconv_fragments(
+      &signature, out_cconv_arguments, out_cconv_results);
+}
+
+static iree_status_t iree_vm_bytecode_module_begin_call(
+    void* self, iree_vm_stack_t* stack, const iree_vm_function_call_t* call,
+    iree_vm_execution_result_t* out_result) {
+  // NOTE: any work here adds directly to the invocation time. Avoid doing too
+  // much work or touching too many unlikely-to-be-cached structures (such as
+  // walking the FlatBuffer, which may cause page faults).
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_ASSERT_ARGUMENT(out_result);
+  memset(out_result, 0, sizeof(iree_vm_execution_result_t));
+
+  iree_vm_bytecode_module_t* module = (iree_vm_bytecode_module_t*)self;
   iree_string_view_t cconv_arguments = iree_string_view_empty();
   iree_string_view_t cconv_results = iree_string_view_empty();
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0, iree_vm_function_call_get_cconv_fragments(
-              &signature, &cconv_arguments, &cconv_results));
+      z0, iree_vm_bytecode_module_resolve_call(module, call, &cconv_arguments,
+                                               &cconv_results));
 
   // Jump into the dispatch routine to execute bytecode until the function
   // either returns (synchronous) or yields (asynchronous).
-  iree_status_t status = iree_vm_bytecode_dispatch(
-      stack, module, call, cconv_arguments, cconv_results, out_result);
+  iree_status_t status =
+      iree_vm_bytecode_dispatch(stack, module, call, /*resume=*/false,
+                                cconv_arguments, cconv_results, out_result);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static iree_status_t iree_vm_bytecode_module_resume_call(
+    void* self, iree_vm_stack_t* stack, const iree_vm_function_call_t* call,
+    iree_vm_execution_result_t* out_result) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_ASSERT_ARGUMENT(out_result);
+  memset(out_result, 0, sizeof(iree_vm_execution_result_t));
+
+  // The result calling convention is needed to marshal the results once the
+  // call returns; arguments were consumed when the call began.
+  iree_vm_bytecode_module_t* module = (iree_vm_bytecode_module_t*)self;
+  iree_string_view_t cconv_arguments = iree_string_view_empty();
+  iree_string_view_t cconv_results = iree_string_view_empty();
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_vm_bytecode_module_resolve_call(module, call, &cconv_arguments,
+                                               &cconv_results));
+
+  // Continue executing from where the call last yielded.
+  iree_status_t status =
+      iree_vm_bytecode_dispatch(stack, module, call, /*resume=*/true,
+                                cconv_arguments, cconv_results, out_result);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t
+iree_vm_bytecode_module_verify(iree_const_byte_span_t flatbuffer_data) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_status_t status =
+      iree_vm_bytecode_module_flatbuffer_verify(flatbuffer_data);
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
@@ -875,19 +974,34 @@ IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
     iree_const_byte_span_t flatbuffer_data,
     iree_allocator_t flatbuffer_allocator, iree_allocator_t allocator,
     iree_vm_module_t** out_module) {
+  return iree_vm_bytecode_module_create_with_flags(
+      IREE_VM_BYTECODE_MODULE_FLAG_NONE, flatbuffer_data, flatbuffer_allocator,
+      allocator, out_module);
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create_with_flags(
+    iree_vm_bytecode_module_flags_t flags,
+    iree_const_byte_span_t flatbuffer_data,
+    iree_allocator_t flatbuffer_allocator, iree_allocator_t allocator,
+    iree_vm_module_t** out_module) {
   IREE_TRACE_ZONE_BEGIN(z0);
   IREE_ASSERT_ARGUMENT(out_module);
   *out_module = NULL;
 
-  IREE_TRACE_ZONE_BEGIN_NAMED(z1, "iree_vm_bytecode_module_flatbuffer_verify");
-  iree_status_t status =
-      iree_vm_bytecode_module_flatbuffer_verify(flatbuffer_data);
-  if (!iree_status_is_ok(status)) {
-    IREE_TRACE_ZONE_END(z1);
-    IREE_TRACE_ZONE_END(z0);
-    return status;
+  if (flags & IREE_VM_BYTECODE_MODULE_FLAG_SKIP_VERIFICATION) {
+    // Trusted contents; the identifier is still checked below so that passing
+    // entirely the wrong file fails cleanly.
+    if (!flatbuffer_data.data || flatbuffer_data.data_length < 16) {
+      IREE_TRACE_ZONE_END(z0);
+      return iree_make_status(
+          IREE_STATUS_INVALID_ARGUMENT,
+          "flatbuffer data is not present or less than 16 bytes (%zu total)",
+          flatbuffer_data.data_length);
+    }
+  } else {
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_vm_bytecode_module_verify(flatbuffer_data));
   }
-  IREE_TRACE_ZONE_END(z1);
 
   iree_vm_BytecodeModuleDef_table_t module_def =
       iree_vm_BytecodeModuleDef_as_root(flatbuffer_data.data);
@@ -899,16 +1013,56 @@ IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
         "'" iree_vm_BytecodeModuleDef_file_identifier "' not found");
   }
 
+  // Rodata segments are aligned relative to the start of the FlatBuffer and
+  // only aligned in memory if the FlatBuffer itself is.
+  uint32_t rodata_alignment =
+      iree_vm_BytecodeModuleDef_rodata_alignment(module_def);
+  if ((flags & IREE_VM_BYTECODE_MODULE_FLAG_REQUIRE_ALIGNED_RODATA) &&
+      rodata_alignment > 1 &&
+      ((uintptr_t)flatbuffer_data.data % rodata_alignment) != 0) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "module rodata requires the flatbuffer data to be aligned to %u bytes "
+        "but it is at %p",
+        rodata_alignment, flatbuffer_data.data);
+  }
+
   iree_vm_TypeDef_vec_t type_defs = iree_vm_BytecodeModuleDef_types(module_def);
   size_t type_table_size =
       iree_vm_TypeDef_vec_len(type_defs) * sizeof(iree_vm_type_def_t);
+  iree_vm_RodataSegmentDef_vec_t rodata_segments =
+      iree_vm_BytecodeModuleDef_rodata_segments(module_def);
+  iree_host_size_t rodata_ref_count =
+      iree_vm_RodataSegmentDef_vec_len(rodata_segments);
+  iree_host_size_t rodata_table_offset =
+      iree_host_align(sizeof(iree_vm_bytecode_module_t) + type_table_size,
+                      iree_alignof(iree_vm_buffer_t));
 
   iree_vm_bytecode_module_t* module = NULL;
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0, iree_allocator_malloc(allocator, sizeof(*module) + type_table_size,
-                                (void**)&module));
+      z0, iree_allocator_malloc(
+              allocator,
+              rodata_table_offset + rodata_ref_count * sizeof(iree_vm_buffer_t),
+              (void**)&module));
   module->allocator = allocator;
 
+  // Setup rodata segments to point directly at the flatbuffer memory. These are
+  // shared by all module states as they are immutable.
+  module->rodata_ref_count = rodata_ref_count;
+  module->rodata_ref_table =
+      (iree_vm_buffer_t*)((uint8_t*)module + rodata_table_offset);
+  for (iree_host_size_t i = 0; i < rodata_ref_count; ++i) {
+    iree_vm_RodataSegmentDef_table_t segment =
+        iree_vm_RodataSegmentDef_vec_at(rodata_segments, i);
+    iree_vm_buffer_initialize(
+        IREE_VM_BUFFER_ACCESS_ORIGIN_MODULE,
+        iree_make_byte_span(
+            (uint8_t*)iree_vm_RodataSegmentDef_data(segment),
+            flatbuffers_uint8_vec_len(iree_vm_RodataSegmentDef_data(segment))),
+        iree_allocator_null(), &module->rodata_ref_table[i]);
+  }
+
   iree_vm_FunctionDescriptor_vec_t function_descriptors =
       iree_vm_BytecodeModuleDef_function_descriptors(module_def);
   module->function_descriptor_count =
@@ -923,6 +1077,7 @@ IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
   module->flatbuffer_data = flatbuffer_data;
   module->flatbuffer_allocator = flatbuffer_allocator;
   module->def = module_def;
+  module->jit = NULL;
 
   module->type_count = iree_vm_TypeDef_vec_len(type_defs);
   iree_status_t resolve_status =
@@ -933,6 +1088,18 @@ IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
     return resolve_status;
   }
 
+#if IREE_VM_BYTECODE_JIT_ENABLE
+  if (flags & IREE_VM_BYTECODE_MODULE_FLAG_JIT) {
+    iree_status_t jit_status =
+        iree_vm_bytecode_jit_create(module, allocator, &module->jit);
+    if (!iree_status_is_ok(jit_status)) {
+      iree_allocator_free(allocator, module);
+      IREE_TRACE_ZONE_END(z0);
+      return jit_status;
+    }
+  }
+#endif  // IREE_VM_BYTECODE_JIT_ENABLE
+
   iree_vm_module_initialize(&module->interface, module);
   module->interface.destroy = iree_vm_bytecode_module_destroy;
   module->interface.name = iree_vm_bytecode_module_name;
@@ -944,9 +1111,11 @@ IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
       iree_vm_bytecode_module_resolve_source_location;
 #endif  // IREE_VM_BACKTRACE_ENABLE
   module->interface.alloc_state = iree_vm_bytecode_module_alloc_state;
+  module->interface.clone_state = iree_vm_bytecode_module_clone_state;
   module->interface.free_state = iree_vm_bytecode_module_free_state;
   module->interface.resolve_import = iree_vm_bytecode_module_resolve_import;
   module->interface.begin_call = iree_vm_bytecode_module_begin_call;
+  module->interface.resume_call = iree_vm_bytecode_module_resume_call;
   module->interface.get_function_reflection_attr =
       iree_vm_bytecode_module_get_function_reflection_attr;
 
@@ -954,3 +1123,33 @@ IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
   IREE_TRACE_ZONE_END(z0);
   return iree_ok_status();
 }
+
+IREE_API_EXPORT iree_host_size_t
+iree_vm_bytecode_module_rodata_segment_count(const iree_vm_module_t* module) {
+  IREE_ASSERT_ARGUMENT(module);
+  if (module->destroy != iree_vm_bytecode_module_destroy) return 0;
+  const iree_vm_bytecode_module_t* bytecode_module =
+      (const iree_vm_bytecode_module_t*)module->self;
+  return bytecode_module->rodata_ref_count;
+}
+
+IREE_API_EXPORT iree_host_size_t
+iree_vm_bytecode_module_rodata_alignment(const iree_vm_module_t* module) {
+  IREE_ASSERT_ARGUMENT(module);
+  if (module->destroy != iree_vm_bytecode_module_destroy) return 0;
+  const iree_vm_bytecode_module_t* bytecode_module =
+      (const iree_vm_bytecode_module_t*)module->self;
+  if (!bytecode_module->rodata_ref_count) return 0;
+  return iree_vm_BytecodeModuleDef_rodata_alignment(bytecode_module->def);
+}
+
+IREE_API_EXPORT iree_const_byte_span_t iree_vm_bytecode_module_rodata_segment(
+    const iree_vm_module_t* module, iree_host_size_t ordinal) {
+  IREE_ASSERT_ARGUMENT(module);
+  IREE_ASSERT(module->destroy == iree_vm_bytecode_module_destroy);
+  const iree_vm_bytecode_module_t* bytecode_module =
+      (const iree_vm_bytecode_module_t*)module->self;
+  IREE_ASSERT_LT(ordinal, bytecode_module->rodata_ref_count);
+  const iree_vm_buffer_t* buffer = &bytecode_module->rodata_ref_table[ordinal];
+  return iree_make_const_byte_span(buffer->data.data, buffer->data.data_length);
+}
@@ -16,6 +16,38 @@
 extern "C" {
 #endif  // __cplusplus
 
+// Flags controlling how a bytecode module is loaded and executed.
+enum iree_vm_bytecode_module_flag_bits_t {
+  IREE_VM_BYTECODE_MODULE_FLAG_NONE = 0u,
+
+  // Translates functions to native code with the baseline JIT when supported
+  // by the target and permitted by the platform (executable pages must be
+  // allocatable). Functions - or the portions of them - that cannot be
+  // translated run in the interpreter as usual.
+  // Ignored when IREE_VM_BYTECODE_JIT_ENABLE is 0.
+  IREE_VM_BYTECODE_MODULE_FLAG_JIT = 1u << 0,
+
+  // Skips the full structural verification of the module FlatBuffer performed
+  // on creation. Only the identifier and minimum size are checked.
+  //
+  // Verification walks every table in the module and can be a significant
+  // fraction of load time for large modules. Only set this for module contents
+  // that are trusted: those that have already been verified with
+  // iree_vm_bytecode_module_verify (such as when populating a cache) or whose
+  // content hash or signature has been checked against a trusted set by the
+  // caller. Loading a malformed module with this flag set is undefined
+  // behavior.
+  IREE_VM_BYTECODE_MODULE_FLAG_SKIP_VERIFICATION = 1u << 1,
+
+  // Fails module creation if the FlatBuffer data is not aligned in memory to
+  // the rodata alignment the module was compiled with (see
+  // iree_vm_bytecode_module_rodata_alignment). Without this flag misaligned
+  // modules still load but consumers that require aligned data, such as
+  // zero-copy wrapping of rodata into HAL buffers, may fall back to copies.
+  IREE_VM_BYTECODE_MODULE_FLAG_REQUIRE_ALIGNED_RODATA = 1u << 2,
+};
+typedef uint32_t iree_vm_bytecode_module_flags_t;
+
 // Creates a VM module from an in-memory ModuleDef FlatBuffer.
 // If a |flatbuffer_allocator| is provided then it will be used to free the
 // |flatbuffer_data| when the module is destroyed and otherwise the ownership of
@@ -25,6 +57,43 @@ IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
     iree_allocator_t flatbuffer_allocator, iree_allocator_t allocator,
     iree_vm_module_t** out_module);
 
+// Creates a VM module from an in-memory ModuleDef FlatBuffer with the given
+// |flags|. See iree_vm_bytecode_module_create for details.
+IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create_with_flags(
+    iree_vm_bytecode_module_flags_t flags,
+    iree_const_byte_span_t flatbuffer_data,
+    iree_allocator_t flatbuffer_allocator, iree_allocator_t allocator,
+    iree_vm_module_t** out_module);
+
+// Verifies that |flatbuffer_data| contains a well-formed ModuleDef FlatBuffer.
+// This is the verification performed by iree_vm_bytecode_module_create unless
+// IREE_VM_BYTECODE_MODULE_FLAG_SKIP_VERIFICATION is specified and allows
+// callers to verify once (such as when a module is first downloaded or cached)
+// and skip verification on subsequent loads of the same contents.
+IREE_API_EXPORT iree_status_t
+iree_vm_bytecode_module_verify(iree_const_byte_span_t flatbuffer_data);
+
+// Returns the number of read-only data segments in |module| or 0 if |module|
+// is not a bytecode module.
+IREE_API_EXPORT iree_host_size_t
+iree_vm_bytecode_module_rodata_segment_count(const iree_vm_module_t* module);
+
+// Returns the largest alignment in bytes of the read-only data segments of
+// |module| relative to the start of its FlatBuffer or 0 if |module| is not a
+// bytecode module or has no read-only data. All segments have the alignment
+// they were compiled with in memory when the FlatBuffer data is aligned to this
+// value.
+IREE_API_EXPORT iree_host_size_t
+iree_vm_bytecode_module_rodata_alignment(const iree_vm_module_t* module);
+
+// Returns the contents of the read-only data segment |ordinal| of |module|.
+// The contents reference the module FlatBuffer and remain valid for the
+// lifetime of the module. Segments are available as soon as the module is
+// created and before any context has been initialized with it; this allows
+// large embedded data such as executables to be processed ahead of use.
+IREE_API_EXPORT iree_const_byte_span_t iree_vm_bytecode_module_rodata_segment(
+    const iree_vm_module_t* module, iree_host_size_t ordinal);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -13,6 +13,7 @@
 #include "iree/vm/api.h"
 #include "iree/vm/bytecode_module.h"
 #include "iree/vm/bytecode_module_benchmark_module_c.h"
+#include "iree/vm/bytecode_module_benchmark_unfused_module_c.h"
 
 namespace {
 
@@ -66,10 +67,11 @@ static iree_status_t native_import_module_create(
 }
 
 // Benchmarks the given exported function, optionally passing in arguments.
-static iree_status_t RunFunction(benchmark::State& state,
-                                 iree_string_view_t function_name,
-                                 std::vector<int32_t> i32_args,
-                                 int result_count, int64_t batch_size = 1) {
+// |module_file_toc| defaults to the module compiled with superinstructions.
+static iree_status_t RunFunction(
+    benchmark::State& state, iree_string_view_t function_name,
+    std::vector<int32_t> i32_args, int result_count, int64_t batch_size = 1,
+    const struct iree_file_toc_t* module_file_toc = nullptr) {
   iree_vm_instance_t* instance = NULL;
   IREE_CHECK_OK(iree_vm_instance_create(iree_allocator_system(), &instance));
 
@@ -77,8 +79,9 @@ static iree_status_t RunFunction(benchmark::State& state,
   IREE_CHECK_OK(
       native_import_module_create(iree_allocator_system(), &import_module));
 
-  const auto* module_file_toc =
-      iree_vm_bytecode_module_benchmark_module_create();
+  if (!module_file_toc) {
+    module_file_toc = iree_vm_bytecode_module_benchmark_module_create();
+  }
   iree_vm_module_t* bytecode_module = nullptr;
   IREE_CHECK_OK(iree_vm_bytecode_module_create(
       iree_const_byte_span_t{
@@ -297,6 +300,18 @@ static void BM_LoopSumBytecode(benchmark::State& state) {
 }
 BENCHMARK(BM_LoopSumBytecode)->Arg(100000);
 
+// Same as BM_LoopSumBytecode but with the loop condition compiled as separate
+// vm.cmp.lt.i32.s and vm.cond_br ops instead of a fused superinstruction.
+static void BM_LoopSumBytecodeUnfused(benchmark::State& state) {
+  IREE_CHECK_OK(RunFunction(
+      state, iree_make_cstring_view("bytecode_module_benchmark.loop_sum"),
+      {static_cast<int32_t>(state.range(0))},
+      /*result_count=*/1,
+      /*batch_size=*/state.range(0),
+      iree_vm_bytecode_module_benchmark_unfused_module_create()));
+}
+BENCHMARK(BM_LoopSumBytecodeUnfused)->Arg(100000);
+
 static void BM_BufferReduceReference(benchmark::State& state) {
   static auto work = +[](int32_t* buffer, int i, int sum) {
     int new_sum = buffer[i] + sum;
@@ -332,6 +347,16 @@ static void BM_BufferReduceBytecode(benchmark::State& state) {
 }
 BENCHMARK(BM_BufferReduceBytecode)->Arg(100000);
 
+static void BM_BufferReduceBytecodeUnfused(benchmark::State& state) {
+  IREE_CHECK_OK(RunFunction(
+      state, iree_make_cstring_view("bytecode_module_benchmark.buffer_reduce"),
+      {static_cast<int32_t>(state.range(0))},
+      /*result_count=*/1,
+      /*batch_size=*/state.range(0),
+      iree_vm_bytecode_module_benchmark_unfused_module_create()));
+}
+BENCHMARK(BM_BufferReduceBytecodeUnfused)->Arg(100000);
+
 // NOTE: unrolled 8x, requires %count to be % 8 = 0.
 static void BM_BufferReduceBytecodeUnrolled(benchmark::State& state) {
   IREE_CHECK_OK(
@@ -344,4 +369,29 @@ static void BM_BufferReduceBytecodeUnrolled(benchmark::State& state) {
 }
 BENCHMARK(BM_BufferReduceBytecodeUnrolled)->Arg(100000);
 
+// Measures the ref counting overhead paid by the interpreter each time a ref
+// is copied into and cleared from a register. Build with
+// -DIREE_VM_REF_SINGLE_THREADED=1 to compare non-atomic counting against the
+// default atomic counting.
+static void BM_RefRetainRelease(benchmark::State& state) {
+  iree_vm_instance_t* instance = NULL;
+  IREE_CHECK_OK(iree_vm_instance_create(iree_allocator_system(), &instance));
+  iree_vm_list_t* list = NULL;
+  IREE_CHECK_OK(iree_vm_list_create(/*element_type=*/NULL, /*capacity=*/0,
+                                    iree_allocator_system(), &list));
+  iree_vm_ref_t source_ref = iree_vm_list_move_ref(list);
+  iree_vm_ref_t target_ref = {0};
+  while (state.KeepRunningBatch(state.range(0))) {
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      iree_vm_ref_retain(&source_ref, &target_ref);
+      benchmark::DoNotOptimize(target_ref);
+      iree_vm_ref_release(&target_ref);
+    }
+  }
+  state.SetLabel(IREE_VM_REF_SINGLE_THREADED ? "non-atomic" : "atomic");
+  iree_vm_ref_release(&source_ref);
+  iree_vm_instance_release(instance);
+}
+BENCHMARK(BM_RefRetainRelease)->Arg(100000);
+
 }  // namespace
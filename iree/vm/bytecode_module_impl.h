@@ -7,6 +7,7 @@
 #ifndef IREE_VM_BYTECODE_MODULE_IMPL_H_
 #define IREE_VM_BYTECODE_MODULE_IMPL_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -41,6 +42,8 @@ extern "C" {
 #define IREE_REF_REGISTER_MOVE_BIT 0x4000
 #define IREE_REF_REGISTER_MASK 0x3FFF
 
+typedef struct iree_vm_bytecode_jit_t iree_vm_bytecode_jit_t;
+
 // A loaded bytecode module.
 typedef struct iree_vm_bytecode_module_t {
   // Interface routing to the bytecode module functions.
@@ -65,11 +68,34 @@ typedef struct iree_vm_bytecode_module_t {
   iree_allocator_t flatbuffer_allocator;
   iree_vm_BytecodeModuleDef_table_t def;
 
+  // Native code for functions translated by the baseline JIT, if enabled.
+  // NULL if all functions are interpreted.
+  iree_vm_bytecode_jit_t* jit;
+
+  // Initialized references to rodata segments.
+  // Rodata is immutable and shared by the states of all contexts the module is
+  // registered with; references point directly at the flatbuffer memory.
+  iree_host_size_t rodata_ref_count;
+  iree_vm_buffer_t* rodata_ref_table;
+
   // Type table mapping module type IDs to registered VM types.
   iree_host_size_t type_count;
   iree_vm_type_def_t type_table[];
 } iree_vm_bytecode_module_t;
 
+// Marshaling routine used to move values between registers and the ABI buffers
+// of an import call. Selected when the import is resolved based on its cconv
+// fragments so that calls with common signatures avoid walking the cconv
+// string and clearing the ABI buffers on every invocation.
+typedef enum iree_vm_bytecode_import_marshal_e {
+  // Arbitrary signature marshaled by walking the cconv fragment.
+  IREE_VM_BYTECODE_IMPORT_MARSHAL_GENERIC = 0,
+  // All values are 32-bit primitives (i32/f32) and are copied directly.
+  IREE_VM_BYTECODE_IMPORT_MARSHAL_I32,
+  // All values are refs.
+  IREE_VM_BYTECODE_IMPORT_MARSHAL_REF,
+} iree_vm_bytecode_import_marshal_t;
+
 // A resolved and split import in the module state table.
 //
 // NOTE: a table of these are stored per module per context so ideally we'd
@@ -90,6 +116,15 @@ typedef struct iree_vm_bytecode_import_t {
   // don't support variadic values (yet).
   uint16_t argument_buffer_size;
   uint16_t result_buffer_size;
+
+  // Number of values (excluding voids) in the argument/result fragments.
+  // Only valid when the corresponding marshal routine is not generic.
+  uint16_t argument_count;
+  uint16_t result_count;
+
+  // iree_vm_bytecode_import_marshal_t used for arguments/results.
+  uint8_t argument_marshal;
+  uint8_t result_marshal;
 } iree_vm_bytecode_import_t;
 
 // Per-instance module state.
@@ -105,13 +140,6 @@ typedef struct iree_vm_bytecode_module_state_t {
   iree_host_size_t global_ref_count;
   iree_vm_ref_t* global_ref_table;
 
-  // TODO(benvanik): move to iree_vm_bytecode_module_t if always static.
-  // Initialized references to rodata segments.
-  // Right now these don't do much, however we can perform lazy caching and
-  // on-the-fly decompression using this information.
-  iree_host_size_t rodata_ref_count;
-  iree_vm_buffer_t* rodata_ref_table;
-
   // Resolved function imports.
   iree_host_size_t import_count;
   iree_vm_bytecode_import_t* import_table;
@@ -123,9 +151,13 @@ typedef struct iree_vm_bytecode_module_state_t {
 // Begins (or resumes) execution of the current frame and continues until
 // either a yield or return. |out_result| will contain the result status for
 // continuation, if needed.
+//
+// When |resume| is true execution continues in the frame on the top of |stack|
+// left by a prior yield of |call| and |cconv_arguments| is ignored.
 iree_status_t iree_vm_bytecode_dispatch(iree_vm_stack_t* stack,
                                         iree_vm_bytecode_module_t* module,
                                         const iree_vm_function_call_t* call,
+                                        bool resume,
                                         iree_string_view_t cconv_arguments,
                                         iree_string_view_t cconv_results,
                                         iree_vm_execution_result_t* out_result);
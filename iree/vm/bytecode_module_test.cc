@@ -10,10 +10,111 @@
 
 #include "iree/vm/bytecode_module.h"
 
+#include <cstring>
+#include <vector>
+
 #include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+#include "iree/vm/api.h"
+
+// Compiled module embedded here to avoid file IO:
+#include "iree/vm/test/all_bytecode_modules.h"
 
 namespace {
 
 // TODO(benvanik): bytecode_module_test.cc for flatbuffer/module implementation.
 
+iree_const_byte_span_t GetModuleData(const struct iree_file_toc_t& file) {
+  return iree_make_const_byte_span(file.data, file.size);
+}
+
+TEST(BytecodeModuleTest, Verify) {
+  const struct iree_file_toc_t* module_file_toc =
+      all_bytecode_modules_c_create();
+  for (size_t i = 0; i < all_bytecode_modules_c_size(); ++i) {
+    IREE_EXPECT_OK(
+        iree_vm_bytecode_module_verify(GetModuleData(module_file_toc[i])));
+  }
+
+  // Truncated and garbage data are rejected.
+  std::vector<uint8_t> garbage(64, 0xCD);
+  iree_status_t status = iree_vm_bytecode_module_verify(
+      iree_make_const_byte_span(garbage.data(), 8));
+  EXPECT_TRUE(iree_status_is_invalid_argument(status));
+  iree_status_ignore(status);
+  status = iree_vm_bytecode_module_verify(
+      iree_make_const_byte_span(garbage.data(), garbage.size()));
+  EXPECT_TRUE(iree_status_is_invalid_argument(status));
+  iree_status_ignore(status);
+}
+
+TEST(BytecodeModuleTest, SkipVerification) {
+  IREE_ASSERT_OK(iree_vm_register_builtin_types());
+  const struct iree_file_toc_t* module_file_toc =
+      all_bytecode_modules_c_create();
+  for (size_t i = 0; i < all_bytecode_modules_c_size(); ++i) {
+    iree_vm_module_t* module = nullptr;
+    IREE_ASSERT_OK(iree_vm_bytecode_module_create_with_flags(
+        IREE_VM_BYTECODE_MODULE_FLAG_SKIP_VERIFICATION,
+        GetModuleData(module_file_toc[i]), iree_allocator_null(),
+        iree_allocator_system(), &module));
+    iree_vm_module_release(module);
+  }
+
+  // Data that is not a module at all is still rejected.
+  std::vector<uint8_t> garbage(64, 0xCD);
+  iree_vm_module_t* module = nullptr;
+  iree_status_t status = iree_vm_bytecode_module_create_with_flags(
+      IREE_VM_BYTECODE_MODULE_FLAG_SKIP_VERIFICATION,
+      iree_make_const_byte_span(garbage.data(), garbage.size()),
+      iree_allocator_null(), iree_allocator_system(), &module);
+  EXPECT_TRUE(iree_status_is_invalid_argument(status));
+  iree_status_ignore(status);
+  EXPECT_EQ(nullptr, module);
+}
+
+TEST(BytecodeModuleTest, RequireAlignedRodata) {
+  IREE_ASSERT_OK(iree_vm_register_builtin_types());
+  const struct iree_file_toc_t* module_file_toc =
+      all_bytecode_modules_c_create();
+  for (size_t i = 0; i < all_bytecode_modules_c_size(); ++i) {
+    iree_const_byte_span_t module_data = GetModuleData(module_file_toc[i]);
+    iree_vm_module_t* module = nullptr;
+    IREE_ASSERT_OK(iree_vm_bytecode_module_create(
+        module_data, iree_allocator_null(), iree_allocator_system(), &module));
+    iree_host_size_t alignment =
+        iree_vm_bytecode_module_rodata_alignment(module);
+    iree_vm_module_release(module);
+    if (alignment < 16) continue;  // no rodata
+
+    // Copies of the module placed at an aligned address load and expose rodata
+    // with at least the default alignment of the compiler.
+    std::vector<uint8_t> storage(module_data.data_length + 2 * alignment);
+    uint8_t* aligned_ptr = (uint8_t*)iree_host_align(
+        (iree_host_size_t)storage.data(), alignment);
+    memcpy(aligned_ptr, module_data.data, module_data.data_length);
+    IREE_ASSERT_OK(iree_vm_bytecode_module_create_with_flags(
+        IREE_VM_BYTECODE_MODULE_FLAG_REQUIRE_ALIGNED_RODATA,
+        iree_make_const_byte_span(aligned_ptr, module_data.data_length),
+        iree_allocator_null(), iree_allocator_system(), &module));
+    for (iree_host_size_t j = 0;
+         j < iree_vm_bytecode_module_rodata_segment_count(module); ++j) {
+      iree_const_byte_span_t segment =
+          iree_vm_bytecode_module_rodata_segment(module, j);
+      EXPECT_EQ(0u, (uintptr_t)segment.data % 16);
+    }
+    iree_vm_module_release(module);
+
+    // Misaligned copies are rejected.
+    uint8_t* misaligned_ptr = aligned_ptr + alignment / 2;
+    memmove(misaligned_ptr, aligned_ptr, module_data.data_length);
+    iree_status_t status = iree_vm_bytecode_module_create_with_flags(
+        IREE_VM_BYTECODE_MODULE_FLAG_REQUIRE_ALIGNED_RODATA,
+        iree_make_const_byte_span(misaligned_ptr, module_data.data_length),
+        iree_allocator_null(), iree_allocator_system(), &module);
+    EXPECT_TRUE(iree_status_is_invalid_argument(status));
+    iree_status_ignore(status);
+  }
+}
+
 }  // namespace
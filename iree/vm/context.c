@@ -19,7 +19,9 @@ struct iree_vm_context_t {
   iree_allocator_t allocator;
   intptr_t context_id;
 
-  // Context has been frozen and can no longer be modified.
+  // Context has been frozen and can no longer be modified. Module state
+  // resolution only reads the immutable module lists of frozen contexts and
+  // is safe to perform from multiple threads concurrently.
   uint32_t is_frozen : 1;
   // Context storage is statically allocated and need not be freed.
   uint32_t is_static : 1;
@@ -202,20 +204,18 @@ iree_vm_context_create(iree_vm_instance_t* instance, iree_allocator_t allocator,
                                              out_context);
 }
 
-IREE_API_EXPORT iree_status_t iree_vm_context_create_with_modules(
-    iree_vm_instance_t* instance, iree_vm_module_t** modules,
-    iree_host_size_t module_count, iree_allocator_t allocator,
-    iree_vm_context_t** out_context) {
-  IREE_TRACE_ZONE_BEGIN(z0);
-  IREE_ASSERT_ARGUMENT(out_context);
-  *out_context = NULL;
-
+// Allocates a context with inline storage for |module_count| modules.
+static iree_status_t iree_vm_context_allocate(iree_vm_instance_t* instance,
+                                              iree_host_size_t module_count,
+                                              iree_allocator_t allocator,
+                                              iree_vm_context_t** out_context) {
   iree_host_size_t context_size =
       sizeof(iree_vm_context_t) + sizeof(iree_vm_module_t*) * module_count +
       sizeof(iree_vm_module_state_t*) * module_count;
 
   iree_vm_context_t* context = NULL;
-  iree_allocator_malloc(allocator, context_size, (void**)&context);
+  IREE_RETURN_IF_ERROR(
+      iree_allocator_malloc(allocator, context_size, (void**)&context));
   iree_atomic_ref_count_init(&context->ref_count);
   context->instance = instance;
   iree_vm_instance_retain(context->instance);
@@ -232,10 +232,25 @@ IREE_API_EXPORT iree_status_t iree_vm_context_create_with_modules(
   p += sizeof(iree_vm_module_state_t*) * module_count;
   context->list.count = 0;
   context->list.capacity = module_count;
-  // TODO(benvanik): allow for non-frozen but static contexts.
-  context->is_frozen = module_count > 0;
+  context->is_frozen = 0;
   context->is_static = module_count > 0;
 
+  *out_context = context;
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_context_create_with_modules(
+    iree_vm_instance_t* instance, iree_vm_module_t** modules,
+    iree_host_size_t module_count, iree_allocator_t allocator,
+    iree_vm_context_t** out_context) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_ASSERT_ARGUMENT(out_context);
+  *out_context = NULL;
+
+  iree_vm_context_t* context = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_vm_context_allocate(instance, module_count, allocator, &context));
+
   iree_status_t register_status =
       iree_vm_context_register_modules(context, modules, module_count);
   if (!iree_status_is_ok(register_status)) {
@@ -244,6 +259,80 @@ IREE_API_EXPORT iree_status_t iree_vm_context_create_with_modules(
     return register_status;
   }
 
+  // TODO(benvanik): allow for non-frozen but static contexts.
+  context->is_frozen = module_count > 0;
+
+  *out_context = context;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_context_fork(
+    const iree_vm_context_t* source_context, iree_allocator_t allocator,
+    iree_vm_context_t** out_context) {
+  IREE_ASSERT_ARGUMENT(source_context);
+  IREE_ASSERT_ARGUMENT(out_context);
+  *out_context = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_host_size_t module_count = source_context->list.count;
+  iree_vm_context_t* context = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_vm_context_allocate(source_context->instance, module_count,
+                                   allocator, &context));
+
+  // VM stack used to call into module __init methods for modules that cannot
+  // clone their state.
+  IREE_VM_INLINE_STACK_INITIALIZE(
+      stack, iree_vm_context_state_resolver(context), context->allocator);
+
+  iree_status_t status = iree_ok_status();
+  iree_host_size_t i = 0;
+  for (i = 0; i < module_count; ++i) {
+    iree_vm_module_t* module = source_context->list.modules[i];
+    context->list.modules[i] = module;
+    context->list.module_states[i] = NULL;
+    iree_vm_module_retain(module);
+
+    // Modules able to clone their state share all immutable data with the
+    // source and skip import resolution and initialization entirely.
+    iree_vm_module_state_t* module_state = NULL;
+    if (module->clone_state) {
+      status = module->clone_state(module->self,
+                                   source_context->list.module_states[i],
+                                   context->allocator, &module_state);
+      if (!iree_status_is_ok(status)) break;
+      context->list.module_states[i] = module_state;
+      ++context->list.count;
+      continue;
+    }
+
+    // Otherwise the module is registered as if it was new.
+    status =
+        module->alloc_state(module->self, context->allocator, &module_state);
+    if (!iree_status_is_ok(status)) break;
+    context->list.module_states[i] = module_state;
+    status =
+        iree_vm_context_resolve_module_imports(context, module, module_state);
+    if (!iree_status_is_ok(status)) break;
+    ++context->list.count;
+    status = iree_vm_context_run_function(stack, module,
+                                          iree_make_cstring_view("__init"));
+    if (!iree_status_is_ok(status)) break;
+  }
+
+  iree_vm_stack_deinitialize(stack);
+
+  if (!iree_status_is_ok(status)) {
+    iree_vm_context_release_modules(context, 0, i);
+    context->list.count = 0;
+    iree_vm_context_destroy(context);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+
+  context->is_frozen = 1;
+
   *out_context = context;
   IREE_TRACE_ZONE_END(z0);
   return iree_ok_status();
@@ -309,11 +398,18 @@ IREE_API_EXPORT iree_status_t iree_vm_context_register_modules(
     }
   }
 
+  // Registration mutates the module lists that concurrent invocations read
+  // without synchronization once the context has been frozen.
+  if (context->is_frozen) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "context is frozen and cannot register modules");
+  }
+
   IREE_TRACE_ZONE_BEGIN(z0);
 
   // Try growing both our storage lists first, if needed.
   if (context->list.count + module_count > context->list.capacity) {
-    if (context->is_frozen) {
+    if (context->is_static) {
       IREE_TRACE_ZONE_END(z0);
       return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
                               "context was allocated as static and cannot "
@@ -468,3 +564,25 @@ IREE_API_EXPORT iree_status_t iree_vm_context_resolve_function(
                           (int)module_name.size, module_name.data,
                           (int)full_name.size, full_name.data);
 }
+
+IREE_API_EXPORT iree_status_t iree_vm_context_notify(iree_vm_context_t* context,
+                                                     iree_vm_signal_t signal) {
+  IREE_ASSERT_ARGUMENT(context);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < context->list.count; ++i) {
+    iree_vm_module_t* module = context->list.modules[i];
+    if (!module->notify) continue;
+    iree_status_t module_status = module->notify(
+        module->self, context->list.module_states[i], signal);
+    if (iree_status_is_ok(status)) {
+      status = module_status;
+    } else {
+      iree_status_ignore(module_status);
+    }
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
@@ -28,7 +28,11 @@ extern "C" {
 // back to the first, such that modules can override implementations of
 // functions in previously registered modules.
 //
-// Thread-compatible and must be externally synchronized.
+// Thread-compatible and must be externally synchronized while modules are being
+// registered. Once frozen the module lists are immutable and functions may be
+// invoked from multiple threads concurrently without locking so long as the
+// modules within the context are themselves thread-safe; each invocation
+// uses its own iree_vm_stack_t that caches the module states it resolves.
 typedef struct iree_vm_context_t iree_vm_context_t;
 
 // Creates a new context that uses the given |instance| for device management.
@@ -47,6 +51,23 @@ IREE_API_EXPORT iree_status_t iree_vm_context_create_with_modules(
     iree_host_size_t module_count, iree_allocator_t allocator,
     iree_vm_context_t** out_context);
 
+// Creates a new context with the same modules as |source_context|.
+// Modules that support it have their state cloned from the source: immutable
+// data (rodata, bytecode, resolved imports) is shared and only mutable globals
+// are copied such that module initializers need not be rerun. Any other
+// modules have fresh state allocated and initialized as with
+// iree_vm_context_register_modules. Objects referenced by cloned global refs
+// are shared with the source context.
+//
+// This makes creating many contexts from one warmed-up template context
+// cheap; memory scales with the size of the module globals and not the size
+// of the modules. |source_context| must not be executing while being forked.
+// The new context is frozen and uses the same instance as the source.
+// |out_context| must be released by the caller.
+IREE_API_EXPORT iree_status_t iree_vm_context_fork(
+    const iree_vm_context_t* source_context, iree_allocator_t allocator,
+    iree_vm_context_t** out_context);
+
 // Retains the given |context| for the caller.
 IREE_API_EXPORT void iree_vm_context_retain(iree_vm_context_t* context);
 
@@ -65,13 +86,15 @@ IREE_API_EXPORT iree_status_t iree_vm_context_register_modules(
 
 // Freezes a context such that no more modules can be registered.
 // This can be used to ensure that context contents cannot be modified by other
-// code as the context is made available to other parts of the program.
+// code as the context is made available to other parts of the program and is
+// required before invoking functions in the context from multiple threads.
+// Publishing the frozen context to other threads must happen-after this call.
 // No-op if already frozen.
 IREE_API_EXPORT iree_status_t
 iree_vm_context_freeze(iree_vm_context_t* context);
 
 // Returns a state resolver setup to use the |context| for resolving module
-// state.
+// state. Thread-safe once the context has been frozen.
 IREE_API_EXPORT iree_vm_state_resolver_t
 iree_vm_context_state_resolver(const iree_vm_context_t* context);
 
@@ -89,6 +112,12 @@ IREE_API_EXPORT iree_status_t iree_vm_context_resolve_function(
     const iree_vm_context_t* context, iree_string_view_t full_name,
     iree_vm_function_t* out_function);
 
+// Notifies all modules registered with the |context| of the given |signal|.
+// Modules are notified in registration order and the first failure is
+// returned after all modules have been notified.
+IREE_API_EXPORT iree_status_t iree_vm_context_notify(iree_vm_context_t* context,
+                                                     iree_vm_signal_t signal);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
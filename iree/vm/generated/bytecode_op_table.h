@@ -33,7 +33,7 @@ typedef enum {
   IREE_VM_OP_CORE_ListSetRef = 0x17,
   IREE_VM_OP_CORE_RSV_0x18,
   IREE_VM_OP_CORE_RSV_0x19,
-  IREE_VM_OP_CORE_RSV_0x1A,
+  IREE_VM_OP_CORE_ListCopy = 0x1A,
   IREE_VM_OP_CORE_RSV_0x1B,
   IREE_VM_OP_CORE_RSV_0x1C,
   IREE_VM_OP_CORE_RSV_0x1D,
@@ -93,10 +93,10 @@ typedef enum {
   IREE_VM_OP_CORE_CallVariadic = 0x53,
   IREE_VM_OP_CORE_Return = 0x54,
   IREE_VM_OP_CORE_Fail = 0x55,
-  IREE_VM_OP_CORE_RSV_0x56,
-  IREE_VM_OP_CORE_RSV_0x57,
-  IREE_VM_OP_CORE_RSV_0x58,
-  IREE_VM_OP_CORE_RSV_0x59,
+  IREE_VM_OP_CORE_CondBranchEQI32 = 0x56,
+  IREE_VM_OP_CORE_CondBranchNEI32 = 0x57,
+  IREE_VM_OP_CORE_CondBranchLTI32S = 0x58,
+  IREE_VM_OP_CORE_CondBranchLTI32U = 0x59,
   IREE_VM_OP_CORE_RSV_0x5A,
   IREE_VM_OP_CORE_RSV_0x5B,
   IREE_VM_OP_CORE_RSV_0x5C,
@@ -292,7 +292,7 @@ typedef enum {
     OPC(0x17, ListSetRef) \
     RSV(0x18) \
     RSV(0x19) \
-    RSV(0x1A) \
+    OPC(0x1A, ListCopy) \
     RSV(0x1B) \
     RSV(0x1C) \
     RSV(0x1D) \
@@ -352,10 +352,10 @@ typedef enum {
     OPC(0x53, CallVariadic) \
     OPC(0x54, Return) \
     OPC(0x55, Fail) \
-    RSV(0x56) \
-    RSV(0x57) \
-    RSV(0x58) \
-    RSV(0x59) \
+    OPC(0x56, CondBranchEQI32) \
+    OPC(0x57, CondBranchNEI32) \
+    OPC(0x58, CondBranchLTI32S) \
+    OPC(0x59, CondBranchLTI32U) \
     RSV(0x5A) \
     RSV(0x5B) \
     RSV(0x5C) \
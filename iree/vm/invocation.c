@@ -18,7 +18,7 @@
 
 // Marshals caller arguments from the variant list to the ABI convention.
 static iree_status_t iree_vm_invoke_marshal_inputs(
-    iree_string_view_t cconv_arguments, iree_vm_list_t* inputs,
+    iree_string_view_t cconv_arguments, const iree_vm_list_t* inputs,
     iree_byte_span_t arguments) {
   // We are 1:1 right now with no variadic args, so do a quick verification on
   // the input list.
@@ -192,11 +192,12 @@ static iree_status_t iree_vm_invoke_within(
     return status;
   }
 
-  // Read back the outputs from the result buffer.
-  IREE_RETURN_IF_ERROR(
-      iree_vm_invoke_marshal_outputs(cconv_results, results, outputs));
-
-  return iree_ok_status();
+  // Read back the outputs from the result buffer. Native functions only
+  // borrow their arguments so any references not consumed by the callee are
+  // released here.
+  status = iree_vm_invoke_marshal_outputs(cconv_results, results, outputs);
+  iree_vm_function_call_release(&call, &signature);
+  return status;
 }
 
 IREE_API_EXPORT iree_status_t iree_vm_invoke(
@@ -215,6 +216,294 @@ IREE_API_EXPORT iree_status_t iree_vm_invoke(
   }
   iree_vm_stack_deinitialize(stack);
 
+  // Let modules release anything they scoped to the invocation. This happens
+  // even on failure so that resources are not leaked across invocations.
+  iree_status_t notify_status =
+      iree_vm_context_notify(context, IREE_VM_SIGNAL_INVOCATION_END);
+  if (iree_status_is_ok(status)) {
+    status = notify_status;
+  } else {
+    iree_status_ignore(notify_status);
+  }
+
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
+
+//===----------------------------------------------------------------------===//
+// iree_vm_invocation_t
+//===----------------------------------------------------------------------===//
+
+struct iree_vm_invocation_t {
+  iree_atomic_ref_count_t ref_count;
+  iree_allocator_t allocator;
+
+  // Context the invocation executes within; retained.
+  iree_vm_context_t* context;
+
+  // Results calling convention of the function used to marshal outputs.
+  iree_string_view_t cconv_results;
+
+  // Call being executed. Arguments are consumed when the call begins and the
+  // result storage is allocated inline with the invocation.
+  iree_vm_function_call_t call;
+
+  // Resumable stack holding the frames of the in-flight call or NULL once
+  // the invocation has completed.
+  iree_vm_stack_t* stack;
+
+  // Result of the last execution step, including any wait the call is
+  // blocked on.
+  iree_vm_execution_result_t result;
+
+  // Completion status of the invocation; IREE_STATUS_UNAVAILABLE while the
+  // invocation is in-flight.
+  iree_status_t status;
+
+  // Outputs populated when the invocation completes successfully.
+  iree_vm_list_t* outputs;
+};
+
+// Tears down the in-flight state of |invocation| and sets its final |status|.
+static void iree_vm_invocation_finish(iree_vm_invocation_t* invocation,
+                                      iree_status_t status) {
+  iree_vm_wait_reset(&invocation->result.wait);
+  if (invocation->stack) {
+    if (!iree_status_is_ok(status)) {
+      status = IREE_VM_STACK_ANNOTATE_BACKTRACE_IF_ENABLED(invocation->stack,
+                                                           status);
+    }
+    iree_vm_stack_free(invocation->stack);
+    invocation->stack = NULL;
+
+    // Let modules release anything they scoped to the invocation. This
+    // happens even on failure so that resources are not leaked across
+    // invocations.
+    iree_status_t notify_status = iree_vm_context_notify(
+        invocation->context, IREE_VM_SIGNAL_INVOCATION_END);
+    if (iree_status_is_ok(status)) {
+      status = notify_status;
+    } else {
+      iree_status_ignore(notify_status);
+    }
+  }
+  iree_status_ignore(invocation->status);
+  invocation->status = status;
+}
+
+// Processes the |step_status| of beginning or resuming the call.
+static void iree_vm_invocation_process_step(iree_vm_invocation_t* invocation,
+                                            iree_status_t step_status) {
+  if (!iree_status_is_ok(step_status)) {
+    iree_vm_invocation_finish(invocation, step_status);
+    return;
+  }
+  if (invocation->result.flags & IREE_VM_EXECUTION_RESULT_FLAG_YIELDED) {
+    return;  // still in-flight
+  }
+  iree_status_t status = iree_vm_invoke_marshal_outputs(
+      invocation->cconv_results, invocation->call.results,
+      invocation->outputs);
+  iree_vm_invocation_finish(invocation, status);
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_invocation_create(
+    iree_vm_context_t* context, iree_vm_function_t function,
+    const iree_vm_invocation_policy_t* policy, const iree_vm_list_t* inputs,
+    iree_allocator_t allocator, iree_vm_invocation_t** out_invocation) {
+  IREE_ASSERT_ARGUMENT(context);
+  IREE_ASSERT_ARGUMENT(out_invocation);
+  *out_invocation = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_vm_function_signature_t signature =
+      iree_vm_function_signature(&function);
+  iree_string_view_t cconv_arguments = iree_string_view_empty();
+  iree_string_view_t cconv_results = iree_string_view_empty();
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_vm_function_call_get_cconv_fragments(
+              &signature, &cconv_arguments, &cconv_results));
+
+  // The arguments are only needed until the call begins and can live on the
+  // host stack while the results must persist across yields.
+  iree_byte_span_t arguments = iree_make_byte_span(NULL, 0);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_vm_function_call_compute_cconv_fragment_size(
+              cconv_arguments, /*segment_size_list=*/NULL,
+              &arguments.data_length));
+  iree_host_size_t results_size = 0;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_vm_function_call_compute_cconv_fragment_size(
+              cconv_results, /*segment_size_list=*/NULL, &results_size));
+
+  iree_vm_invocation_t* invocation = NULL;
+  iree_host_size_t header_size = iree_host_align(sizeof(*invocation), 16);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(allocator, header_size + results_size,
+                                (void**)&invocation));
+  memset(invocation, 0, header_size + results_size);
+  iree_atomic_ref_count_init(&invocation->ref_count);
+  invocation->allocator = allocator;
+  invocation->context = context;
+  iree_vm_context_retain(context);
+  invocation->cconv_results = cconv_results;
+  invocation->call.function = function;
+  invocation->call.results =
+      iree_make_byte_span((uint8_t*)invocation + header_size, results_size);
+  invocation->status = iree_status_from_code(IREE_STATUS_UNAVAILABLE);
+
+  iree_host_size_t output_count =
+      cconv_results.size > 0 && cconv_results.data[0] != 'v'
+          ? cconv_results.size
+          : 0;
+  iree_status_t status = iree_vm_list_create(/*element_type=*/NULL,
+                                             output_count, allocator,
+                                             &invocation->outputs);
+  if (iree_status_is_ok(status)) {
+    status =
+        iree_vm_stack_allocate(iree_vm_context_state_resolver(context),
+                               allocator, &invocation->stack);
+  }
+  if (iree_status_is_ok(status)) {
+    iree_vm_stack_set_resumable(invocation->stack, true);
+    arguments.data = iree_alloca(arguments.data_length);
+    memset(arguments.data, 0, arguments.data_length);
+    status = iree_vm_invoke_marshal_inputs(cconv_arguments, inputs, arguments);
+  }
+  invocation->call.arguments = arguments;
+  if (!iree_status_is_ok(status)) {
+    iree_vm_function_call_release(&invocation->call, &signature);
+    iree_vm_invocation_release(invocation);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+
+  // Begin execution; arguments are consumed by the callee and the storage
+  // is not referenced again.
+  status = function.module->begin_call(function.module->self,
+                                       invocation->stack, &invocation->call,
+                                       &invocation->result);
+  if (!iree_status_is_ok(status)) {
+    iree_vm_function_call_release(&invocation->call, &signature);
+  }
+  invocation->call.arguments = iree_make_byte_span(NULL, 0);
+  iree_vm_invocation_process_step(invocation, status);
+
+  *out_invocation = invocation;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t
+iree_vm_invocation_retain(iree_vm_invocation_t* invocation) {
+  IREE_ASSERT_ARGUMENT(invocation);
+  iree_atomic_ref_count_inc(&invocation->ref_count);
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t
+iree_vm_invocation_release(iree_vm_invocation_t* invocation) {
+  if (!invocation || iree_atomic_ref_count_dec(&invocation->ref_count) != 1) {
+    return iree_ok_status();
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  if (invocation->stack) {
+    iree_vm_invocation_finish(invocation,
+                              iree_status_from_code(IREE_STATUS_ABORTED));
+  }
+  iree_status_ignore(invocation->status);
+  iree_vm_list_release(invocation->outputs);
+  iree_vm_context_release(invocation->context);
+  iree_allocator_free(invocation->allocator, invocation);
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t
+iree_vm_invocation_query_status(iree_vm_invocation_t* invocation) {
+  IREE_ASSERT_ARGUMENT(invocation);
+  if (iree_status_is_ok(invocation->status)) return iree_ok_status();
+  return iree_status_clone(invocation->status);
+}
+
+IREE_API_EXPORT bool iree_vm_invocation_is_ready(
+    iree_vm_invocation_t* invocation) {
+  IREE_ASSERT_ARGUMENT(invocation);
+  if (!invocation->stack) return false;
+  if (!(invocation->result.flags & IREE_VM_EXECUTION_RESULT_FLAG_WAITING)) {
+    return true;
+  }
+  // Polls the wait; failures will be reported when the invocation is resumed.
+  iree_status_t status =
+      iree_vm_wait_until(&invocation->result.wait, IREE_TIME_INFINITE_PAST);
+  bool is_ready = !iree_status_is_deadline_exceeded(status);
+  iree_status_ignore(status);
+  return is_ready;
+}
+
+IREE_API_EXPORT iree_status_t
+iree_vm_invocation_resume(iree_vm_invocation_t* invocation) {
+  IREE_ASSERT_ARGUMENT(invocation);
+  if (!invocation->stack) return iree_vm_invocation_query_status(invocation);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Remain yielded if the wait the call is blocked on is not yet satisfied.
+  if (invocation->result.flags & IREE_VM_EXECUTION_RESULT_FLAG_WAITING) {
+    iree_status_t wait_status =
+        iree_vm_wait_until(&invocation->result.wait, IREE_TIME_INFINITE_PAST);
+    if (iree_status_is_deadline_exceeded(wait_status)) {
+      iree_status_ignore(wait_status);
+      IREE_TRACE_ZONE_END(z0);
+      return iree_status_from_code(IREE_STATUS_UNAVAILABLE);
+    } else if (!iree_status_is_ok(wait_status)) {
+      iree_vm_invocation_finish(invocation, wait_status);
+      IREE_TRACE_ZONE_END(z0);
+      return iree_vm_invocation_query_status(invocation);
+    }
+    iree_vm_wait_reset(&invocation->result.wait);
+  }
+
+  iree_vm_module_t* module = invocation->call.function.module;
+  iree_status_t status = module->resume_call(
+      module->self, invocation->stack, &invocation->call, &invocation->result);
+  iree_vm_invocation_process_step(invocation, status);
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_vm_invocation_query_status(invocation);
+}
+
+IREE_API_EXPORT const iree_vm_list_t* iree_vm_invocation_output(
+    iree_vm_invocation_t* invocation) {
+  IREE_ASSERT_ARGUMENT(invocation);
+  return iree_status_is_ok(invocation->status) ? invocation->outputs : NULL;
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_invocation_await(
+    iree_vm_invocation_t* invocation, iree_time_t deadline) {
+  IREE_ASSERT_ARGUMENT(invocation);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  while (invocation->stack) {
+    if (invocation->result.flags & IREE_VM_EXECUTION_RESULT_FLAG_WAITING) {
+      iree_status_t wait_status =
+          iree_vm_wait_until(&invocation->result.wait, deadline);
+      if (iree_status_is_deadline_exceeded(wait_status)) {
+        IREE_TRACE_ZONE_END(z0);
+        return wait_status;
+      }
+      iree_status_ignore(wait_status);  // reported by resume
+    }
+    iree_status_ignore(iree_vm_invocation_resume(invocation));
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return iree_vm_invocation_query_status(invocation);
+}
+
+IREE_API_EXPORT iree_status_t
+iree_vm_invocation_abort(iree_vm_invocation_t* invocation) {
+  IREE_ASSERT_ARGUMENT(invocation);
+  if (invocation->stack) {
+    iree_vm_invocation_finish(invocation,
+                              iree_status_from_code(IREE_STATUS_ABORTED));
+  }
+  return iree_ok_status();
+}
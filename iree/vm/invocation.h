@@ -39,7 +39,27 @@ IREE_API_EXPORT iree_status_t iree_vm_invoke(
     const iree_vm_invocation_policy_t* policy, iree_vm_list_t* inputs,
     iree_vm_list_t* outputs, iree_allocator_t allocator);
 
-// TODO(benvanik): document and implement.
+// Creates a resumable invocation of |function| and begins executing it.
+//
+// Execution starts on the calling thread and continues until the function
+// either completes or yields. Functions yield when they reach a vm.yield or
+// when a native import (such as a HAL semaphore wait) would otherwise block.
+// Yielded invocations keep their VM stack and can be continued from any thread
+// with iree_vm_invocation_resume, allowing a small number of host threads to
+// multiplex many in-flight invocations. An invocation must not be resumed
+// from multiple threads concurrently and invocations sharing a |context| must
+// only be resumed concurrently if the modules within it are thread-safe.
+//
+// |policy| is used to schedule the invocation relative to other pending or
+// in-flight invocations. It may be omitted to leave the behavior up to the
+// implementation.
+//
+// |inputs| is used to pass values and objects into the target function and must
+// match the signature defined by the compiled function. List ownership remains
+// with the caller and the inputs are consumed before this call returns.
+//
+// Failures that occur during execution are reported by
+// iree_vm_invocation_query_status and only invalid arguments are returned here.
 IREE_API_EXPORT iree_status_t iree_vm_invocation_create(
     iree_vm_context_t* context, iree_vm_function_t function,
     const iree_vm_invocation_policy_t* policy, const iree_vm_list_t* inputs,
@@ -50,6 +70,7 @@ IREE_API_EXPORT iree_status_t
 iree_vm_invocation_retain(iree_vm_invocation_t* invocation);
 
 // Releases the given |invocation| from the caller.
+// In-flight invocations are aborted when the last reference is released.
 IREE_API_EXPORT iree_status_t
 iree_vm_invocation_release(iree_vm_invocation_t* invocation);
 
@@ -63,6 +84,23 @@ iree_vm_invocation_release(iree_vm_invocation_t* invocation);
 IREE_API_EXPORT iree_status_t
 iree_vm_invocation_query_status(iree_vm_invocation_t* invocation);
 
+// Returns true if |invocation| has yielded and can make progress if resumed.
+// Invocations blocked on a wait are polled without blocking the caller.
+// Completed invocations return false.
+IREE_API_EXPORT bool iree_vm_invocation_is_ready(
+    iree_vm_invocation_t* invocation);
+
+// Resumes a yielded |invocation| on the calling thread.
+// Execution continues until the function either completes or yields again. If
+// the invocation is blocked on a wait that has not yet been satisfied then it
+// remains yielded and the call returns without executing anything.
+//
+// Returns the iree_vm_invocation_query_status after the invocation has been
+// resumed: IREE_STATUS_UNAVAILABLE indicates that the invocation yielded and
+// must be resumed again.
+IREE_API_EXPORT iree_status_t
+iree_vm_invocation_resume(iree_vm_invocation_t* invocation);
+
 // Returns a reference to the output of the invocation.
 // The returned structure is valid for the lifetime of the invocation and
 // callers must retain any refs they want to outlive the invocation once
@@ -73,6 +111,7 @@ IREE_API_EXPORT const iree_vm_list_t* iree_vm_invocation_output(
     iree_vm_invocation_t* invocation);
 
 // Blocks the caller until the invocation completes (successfully or otherwise).
+// Yielded invocations are resumed on the calling thread.
 //
 // Returns IREE_STATUS_DEADLINE_EXCEEDED if |deadline| elapses before the
 // invocation completes and otherwise returns iree_vm_invocation_query_status.
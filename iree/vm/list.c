@@ -490,6 +490,156 @@ iree_vm_list_push_value(iree_vm_list_t* list, const iree_vm_value_t* value) {
   return iree_vm_list_set_value(list, i, value);
 }
 
+// Returns true if |list| stores primitive values of exactly |value_type|.
+static bool iree_vm_list_stores_value_type(const iree_vm_list_t* list,
+                                           iree_vm_value_type_t value_type) {
+  return list->storage_mode == IREE_VM_LIST_STORAGE_MODE_VALUE &&
+         list->element_type.value_type == value_type;
+}
+
+static iree_status_t iree_vm_list_check_range(const iree_vm_list_t* list,
+                                              iree_host_size_t offset,
+                                              iree_host_size_t count) {
+  if (offset > list->count || count > list->count - offset) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "range [%zu, %zu) out of bounds (%zu)", offset,
+                            offset + count, list->count);
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_list_check_value_type(
+    iree_vm_value_type_t value_type) {
+  if (value_type <= IREE_VM_VALUE_TYPE_NONE ||
+      value_type >= IREE_VM_VALUE_TYPE_COUNT) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "invalid value type %d", (int)value_type);
+  }
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_list_map_values(
+    iree_vm_list_t* list, iree_vm_value_type_t* out_value_type,
+    iree_byte_span_t* out_storage) {
+  if (list->storage_mode != IREE_VM_LIST_STORAGE_MODE_VALUE) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "list does not store primitive values");
+  }
+  *out_value_type = list->element_type.value_type;
+  *out_storage = iree_make_byte_span((uint8_t*)list->storage,
+                                     list->count * list->element_size);
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_list_get_values(
+    const iree_vm_list_t* list, iree_host_size_t offset, iree_host_size_t count,
+    iree_vm_value_type_t value_type, void* out_values) {
+  IREE_RETURN_IF_ERROR(iree_vm_list_check_value_type(value_type));
+  IREE_RETURN_IF_ERROR(iree_vm_list_check_range(list, offset, count));
+  if (iree_vm_list_stores_value_type(list, value_type)) {
+    memcpy(out_values,
+           (const uint8_t*)list->storage + offset * list->element_size,
+           count * list->element_size);
+    return iree_ok_status();
+  }
+  // Slow path performing conversion. Value storage is a union and all members
+  // start at offset 0 so copying the leading bytes is endian-agnostic.
+  iree_host_size_t value_size = kValueTypeSizes[value_type];
+  uint8_t* out_ptr = (uint8_t*)out_values;
+  for (iree_host_size_t i = 0; i < count; ++i) {
+    iree_vm_value_t value;
+    IREE_RETURN_IF_ERROR(
+        iree_vm_list_get_value_as(list, offset + i, value_type, &value));
+    memcpy(out_ptr + i * value_size, value.value_storage, value_size);
+  }
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_list_set_values(
+    iree_vm_list_t* list, iree_host_size_t offset, iree_host_size_t count,
+    iree_vm_value_type_t value_type, const void* values) {
+  IREE_RETURN_IF_ERROR(iree_vm_list_check_value_type(value_type));
+  IREE_RETURN_IF_ERROR(iree_vm_list_check_range(list, offset, count));
+  if (iree_vm_list_stores_value_type(list, value_type)) {
+    memcpy((uint8_t*)list->storage + offset * list->element_size, values,
+           count * list->element_size);
+    return iree_ok_status();
+  }
+  // Slow path performing conversion.
+  iree_host_size_t value_size = kValueTypeSizes[value_type];
+  const uint8_t* values_ptr = (const uint8_t*)values;
+  for (iree_host_size_t i = 0; i < count; ++i) {
+    iree_vm_value_t value;
+    memset(&value, 0, sizeof(value));
+    value.type = value_type;
+    memcpy(value.value_storage, values_ptr + i * value_size, value_size);
+    IREE_RETURN_IF_ERROR(iree_vm_list_set_value(list, offset + i, &value));
+  }
+  return iree_ok_status();
+}
+
+// Copies a single element between lists of potentially differing storage modes.
+static iree_status_t iree_vm_list_copy_element(
+    const iree_vm_list_t* source_list, iree_host_size_t source_i,
+    iree_vm_list_t* target_list, iree_host_size_t target_i) {
+  bool is_value = source_list->storage_mode == IREE_VM_LIST_STORAGE_MODE_VALUE;
+  if (source_list->storage_mode == IREE_VM_LIST_STORAGE_MODE_VARIANT) {
+    const iree_vm_variant_t* variant =
+        (const iree_vm_variant_t*)((uintptr_t)source_list->storage +
+                                   source_i * source_list->element_size);
+    is_value = iree_vm_type_def_is_value(&variant->type);
+  }
+  if (is_value) {
+    iree_vm_value_t value;
+    IREE_RETURN_IF_ERROR(iree_vm_list_get_value(source_list, source_i, &value));
+    return iree_vm_list_set_value(target_list, target_i, &value);
+  }
+  iree_vm_ref_t ref = {0};
+  IREE_RETURN_IF_ERROR(
+      iree_vm_list_get_ref_assign(source_list, source_i, &ref));
+  return iree_vm_list_set_ref_retain(target_list, target_i, &ref);
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_list_copy(
+    const iree_vm_list_t* source_list, iree_host_size_t source_offset,
+    iree_vm_list_t* target_list, iree_host_size_t target_offset,
+    iree_host_size_t count) {
+  IREE_RETURN_IF_ERROR(
+      iree_vm_list_check_range(source_list, source_offset, count));
+  IREE_RETURN_IF_ERROR(
+      iree_vm_list_check_range(target_list, target_offset, count));
+  if (count == 0 ||
+      (source_list == target_list && source_offset == target_offset)) {
+    return iree_ok_status();
+  }
+  if (source_list->storage_mode == IREE_VM_LIST_STORAGE_MODE_VALUE &&
+      iree_vm_list_stores_value_type(target_list,
+                                     source_list->element_type.value_type)) {
+    memmove((uint8_t*)target_list->storage +
+                target_offset * target_list->element_size,
+            (const uint8_t*)source_list->storage +
+                source_offset * source_list->element_size,
+            count * source_list->element_size);
+    return iree_ok_status();
+  }
+  // Slow path copying element by element. When copying within the same list
+  // to a higher offset we walk backwards so that overlapping source elements
+  // are read before they are overwritten.
+  if (source_list == target_list && target_offset > source_offset) {
+    for (iree_host_size_t i = count; i > 0; --i) {
+      IREE_RETURN_IF_ERROR(iree_vm_list_copy_element(
+          source_list, source_offset + i - 1, target_list,
+          target_offset + i - 1));
+    }
+  } else {
+    for (iree_host_size_t i = 0; i < count; ++i) {
+      IREE_RETURN_IF_ERROR(iree_vm_list_copy_element(
+          source_list, source_offset + i, target_list, target_offset + i));
+    }
+  }
+  return iree_ok_status();
+}
+
 IREE_API_EXPORT void* iree_vm_list_get_ref_deref(
     const iree_vm_list_t* list, iree_host_size_t i,
     const iree_vm_ref_type_descriptor_t* type_descriptor) {
@@ -608,6 +758,10 @@ IREE_API_EXPORT iree_status_t iree_vm_list_pop_front_ref_move(
   IREE_RETURN_IF_ERROR(iree_vm_list_get_ref_assign(list, 0, out_value));
   memmove(list->storage, (uint8_t*)list->storage + list->element_size,
           (list_size - 1) * list->element_size);
+  // The vacated last element still aliases the ref moved down into the element
+  // before it and must not be released if the list is extended again.
+  memset((uint8_t*)list->storage + (list_size - 1) * list->element_size, 0,
+         list->element_size);
   --list->count;
   return iree_ok_status();
 }
@@ -121,6 +121,42 @@ IREE_API_EXPORT iree_status_t iree_vm_list_set_value(
 IREE_API_EXPORT iree_status_t
 iree_vm_list_push_value(iree_vm_list_t* list, const iree_vm_value_t* value);
 
+// Returns a view of the contiguous storage of a primitive-typed |list| holding
+// all elements in the range [0, size). The view is only valid until the list is
+// next reserved, resized, or released and can be used to read and write the
+// elements in-place without per-element type checks or conversions. Fails if
+// the list does not store primitive values of a single type (such as variant
+// lists).
+IREE_API_EXPORT iree_status_t iree_vm_list_map_values(
+    iree_vm_list_t* list, iree_vm_value_type_t* out_value_type,
+    iree_byte_span_t* out_storage);
+
+// Copies |count| elements starting at |offset| into |out_values| as a dense
+// array of |value_type| values. Lists storing |value_type| elements are copied
+// in bulk while all others are converted element by element using the value
+// type semantics as with iree_vm_list_get_value_as.
+IREE_API_EXPORT iree_status_t iree_vm_list_get_values(
+    const iree_vm_list_t* list, iree_host_size_t offset, iree_host_size_t count,
+    iree_vm_value_type_t value_type, void* out_values);
+
+// Sets |count| elements starting at |offset| from |values| containing a dense
+// array of |value_type| values. Lists storing |value_type| elements are copied
+// in bulk while all others are converted element by element using the value
+// type semantics as with iree_vm_list_set_value.
+IREE_API_EXPORT iree_status_t iree_vm_list_set_values(
+    iree_vm_list_t* list, iree_host_size_t offset, iree_host_size_t count,
+    iree_vm_value_type_t value_type, const void* values);
+
+// Copies |count| elements from |source_list| starting at |source_offset| to
+// |target_list| starting at |target_offset|. Both ranges must be within the
+// current size of the lists. The lists may be the same and the ranges may
+// overlap. Refs are retained by the target list. Primitive lists of the same
+// element type are copied in bulk.
+IREE_API_EXPORT iree_status_t iree_vm_list_copy(
+    const iree_vm_list_t* source_list, iree_host_size_t source_offset,
+    iree_vm_list_t* target_list, iree_host_size_t target_offset,
+    iree_host_size_t count);
+
 // Returns a dereferenced pointer to the given type if the element at the given
 // index matches the type. Returns NULL on error.
 IREE_API_EXPORT void* iree_vm_list_get_ref_deref(
@@ -326,6 +326,38 @@ TEST_F(VMListTest, ResizeRef) {
   iree_vm_list_release(list);
 }
 
+// Tests that popping from the front leaves no stale refs behind when the list
+// is extended again.
+TEST_F(VMListTest, PopFrontRefThenResize) {
+  iree_vm_type_def_t element_type = iree_vm_type_def_make_variant_type();
+  iree_vm_list_t* list = nullptr;
+  IREE_ASSERT_OK(
+      iree_vm_list_create(&element_type, 4, iree_allocator_system(), &list));
+  for (iree_host_size_t i = 0; i < 2; ++i) {
+    iree_vm_ref_t ref_a = MakeRef<A>((float)i);
+    IREE_ASSERT_OK(iree_vm_list_push_ref_move(list, &ref_a));
+  }
+
+  iree_vm_ref_t ref_a{0};
+  IREE_ASSERT_OK(iree_vm_list_pop_front_ref_move(list, &ref_a));
+  EXPECT_EQ(0.0f, test_a_deref(ref_a)->data());
+  iree_vm_ref_release(&ref_a);
+  EXPECT_EQ(1, iree_vm_list_size(list));
+
+  // The slot vacated by the pop must be empty and not release the ref that
+  // was moved down when it is overwritten.
+  IREE_ASSERT_OK(iree_vm_list_resize(list, 2));
+  iree_vm_variant_t value = iree_vm_variant_empty();
+  IREE_ASSERT_OK(iree_vm_list_get_variant(list, 1, &value));
+  EXPECT_TRUE(iree_vm_variant_is_empty(value));
+  iree_vm_ref_t ref_b = MakeRef<A>(2.0f);
+  IREE_ASSERT_OK(iree_vm_list_set_ref_move(list, 1, &ref_b));
+  IREE_ASSERT_OK(iree_vm_list_get_ref_assign(list, 0, &ref_a));
+  EXPECT_EQ(1.0f, test_a_deref(ref_a)->data());
+
+  iree_vm_list_release(list);
+}
+
 // Tests the behavior of resize for truncation and extension on variants.
 TEST_F(VMListTest, ResizeVariant) {
   iree_vm_type_def_t element_type = iree_vm_type_def_make_variant_type();
@@ -380,6 +412,154 @@ TEST_F(VMListTest, ResizeVariant) {
   iree_vm_list_release(list);
 }
 
+// Tests mapping the contiguous storage of a primitive list.
+TEST_F(VMListTest, MapValues) {
+  iree_vm_type_def_t element_type =
+      iree_vm_type_def_make_value_type(IREE_VM_VALUE_TYPE_I32);
+  iree_vm_list_t* list = nullptr;
+  IREE_ASSERT_OK(
+      iree_vm_list_create(&element_type, 4, iree_allocator_system(), &list));
+  IREE_ASSERT_OK(iree_vm_list_resize(list, 4));
+
+  iree_vm_value_type_t value_type = IREE_VM_VALUE_TYPE_NONE;
+  iree_byte_span_t storage = iree_make_byte_span(nullptr, 0);
+  IREE_ASSERT_OK(iree_vm_list_map_values(list, &value_type, &storage));
+  EXPECT_EQ(IREE_VM_VALUE_TYPE_I32, value_type);
+  ASSERT_EQ(4 * sizeof(int32_t), storage.data_length);
+  int32_t* values = (int32_t*)storage.data;
+  for (int32_t i = 0; i < 4; ++i) values[i] = i * 10;
+
+  for (iree_host_size_t i = 0; i < 4; ++i) {
+    iree_vm_value_t value;
+    IREE_ASSERT_OK(iree_vm_list_get_value(list, i, &value));
+    EXPECT_EQ(i * 10, value.i32);
+  }
+
+  iree_vm_list_release(list);
+
+  // Variant lists have no single element type and cannot be mapped.
+  IREE_ASSERT_OK(
+      iree_vm_list_create(/*element_type=*/nullptr, 4, iree_allocator_system(),
+                          &list));
+  iree_status_t status = iree_vm_list_map_values(list, &value_type, &storage);
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_FAILED_PRECONDITION, status);
+  iree_status_free(status);
+  iree_vm_list_release(list);
+}
+
+// Tests bulk get/set on primitive lists, both with and without conversion.
+TEST_F(VMListTest, GetSetValues) {
+  iree_vm_type_def_t element_type =
+      iree_vm_type_def_make_value_type(IREE_VM_VALUE_TYPE_I32);
+  iree_vm_list_t* list = nullptr;
+  IREE_ASSERT_OK(
+      iree_vm_list_create(&element_type, 8, iree_allocator_system(), &list));
+  IREE_ASSERT_OK(iree_vm_list_resize(list, 8));
+
+  int32_t i32_values[4] = {1, 2, 3, 4};
+  IREE_ASSERT_OK(iree_vm_list_set_values(list, 2, 4, IREE_VM_VALUE_TYPE_I32,
+                                         i32_values));
+  int32_t i32_results[8] = {-1, -1, -1, -1, -1, -1, -1, -1};
+  IREE_ASSERT_OK(iree_vm_list_get_values(list, 0, 8, IREE_VM_VALUE_TYPE_I32,
+                                         i32_results));
+  int32_t i32_expected[8] = {0, 0, 1, 2, 3, 4, 0, 0};
+  EXPECT_EQ(0, memcmp(i32_expected, i32_results, sizeof(i32_expected)));
+
+  // Converting to i64 sign-extends each element.
+  int64_t i64_values[2] = {-5, 6};
+  IREE_ASSERT_OK(iree_vm_list_set_values(list, 0, 2, IREE_VM_VALUE_TYPE_I64,
+                                         i64_values));
+  int64_t i64_results[3] = {0};
+  IREE_ASSERT_OK(iree_vm_list_get_values(list, 0, 3, IREE_VM_VALUE_TYPE_I64,
+                                         i64_results));
+  EXPECT_EQ(-5, i64_results[0]);
+  EXPECT_EQ(6, i64_results[1]);
+  EXPECT_EQ(1, i64_results[2]);
+
+  iree_status_t status = iree_vm_list_get_values(
+      list, 6, 3, IREE_VM_VALUE_TYPE_I32, i32_results);
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_OUT_OF_RANGE, status);
+  iree_status_free(status);
+  status = iree_vm_list_set_values(list, 9, 0, IREE_VM_VALUE_TYPE_I32,
+                                   i32_values);
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_OUT_OF_RANGE, status);
+  iree_status_free(status);
+
+  iree_vm_list_release(list);
+}
+
+// Tests copying between primitive lists including overlapping ranges.
+TEST_F(VMListTest, CopyValues) {
+  iree_vm_type_def_t element_type =
+      iree_vm_type_def_make_value_type(IREE_VM_VALUE_TYPE_I32);
+  iree_vm_list_t* list = nullptr;
+  IREE_ASSERT_OK(
+      iree_vm_list_create(&element_type, 6, iree_allocator_system(), &list));
+  IREE_ASSERT_OK(iree_vm_list_resize(list, 6));
+  int32_t values[6] = {0, 1, 2, 3, 4, 5};
+  IREE_ASSERT_OK(
+      iree_vm_list_set_values(list, 0, 6, IREE_VM_VALUE_TYPE_I32, values));
+
+  // Overlapping copy within the same list.
+  IREE_ASSERT_OK(iree_vm_list_copy(list, 0, list, 2, 4));
+  int32_t results[6] = {0};
+  IREE_ASSERT_OK(
+      iree_vm_list_get_values(list, 0, 6, IREE_VM_VALUE_TYPE_I32, results));
+  int32_t expected[6] = {0, 1, 0, 1, 2, 3};
+  EXPECT_EQ(0, memcmp(expected, results, sizeof(expected)));
+
+  // Copy into a variant list converts each element into a variant.
+  iree_vm_list_t* variant_list = nullptr;
+  IREE_ASSERT_OK(iree_vm_list_create(/*element_type=*/nullptr, 6,
+                                     iree_allocator_system(), &variant_list));
+  IREE_ASSERT_OK(iree_vm_list_resize(variant_list, 3));
+  IREE_ASSERT_OK(iree_vm_list_copy(list, 3, variant_list, 0, 3));
+  for (iree_host_size_t i = 0; i < 3; ++i) {
+    iree_vm_value_t value;
+    IREE_ASSERT_OK(iree_vm_list_get_value(variant_list, i, &value));
+    EXPECT_EQ(IREE_VM_VALUE_TYPE_I32, value.type);
+    EXPECT_EQ(expected[3 + i], value.i32);
+  }
+
+  iree_status_t status = iree_vm_list_copy(list, 4, variant_list, 0, 3);
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_OUT_OF_RANGE, status);
+  iree_status_free(status);
+
+  iree_vm_list_release(variant_list);
+  iree_vm_list_release(list);
+}
+
+// Tests copying between ref lists retains the elements.
+TEST_F(VMListTest, CopyRefs) {
+  iree_vm_type_def_t element_type =
+      iree_vm_type_def_make_ref_type(test_a_type_id());
+  iree_vm_list_t* source_list = nullptr;
+  IREE_ASSERT_OK(iree_vm_list_create(&element_type, 3, iree_allocator_system(),
+                                     &source_list));
+  IREE_ASSERT_OK(iree_vm_list_resize(source_list, 3));
+  for (iree_host_size_t i = 0; i < 3; ++i) {
+    iree_vm_ref_t ref_a = MakeRef<A>((float)i);
+    IREE_ASSERT_OK(iree_vm_list_set_ref_move(source_list, i, &ref_a));
+  }
+
+  iree_vm_list_t* target_list = nullptr;
+  IREE_ASSERT_OK(iree_vm_list_create(&element_type, 3, iree_allocator_system(),
+                                     &target_list));
+  IREE_ASSERT_OK(iree_vm_list_resize(target_list, 3));
+  IREE_ASSERT_OK(iree_vm_list_copy(source_list, 0, target_list, 0, 3));
+
+  // Target elements must outlive the source list.
+  iree_vm_list_release(source_list);
+  for (iree_host_size_t i = 0; i < 3; ++i) {
+    iree_vm_ref_t ref_a{0};
+    IREE_ASSERT_OK(iree_vm_list_get_ref_assign(target_list, i, &ref_a));
+    ASSERT_TRUE(test_a_isa(ref_a));
+    EXPECT_EQ(i, test_a_deref(ref_a)->data());
+  }
+
+  iree_vm_list_release(target_list);
+}
+
 // TODO(benvanik): test value get/set.
 
 // TODO(benvanik): test value conversion.
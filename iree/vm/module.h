@@ -15,6 +15,7 @@
 #include "iree/base/api.h"
 #include "iree/base/internal/atomics.h"
 #include "iree/base/string_builder.h"
+#include "iree/vm/ref.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -251,14 +252,60 @@ IREE_API_EXPORT void iree_vm_function_call_release(
     iree_vm_function_call_t* call,
     const iree_vm_function_signature_t* signature);
 
+// Waits on an object until the wait is satisfied or |deadline_ns| elapses.
+// A deadline of IREE_TIME_INFINITE_PAST polls the object without blocking.
+// Returns IREE_STATUS_DEADLINE_EXCEEDED if the wait has not been satisfied.
+typedef iree_status_t(IREE_API_PTR* iree_vm_wait_fn_t)(iree_vm_ref_t* ref,
+                                                        uint64_t payload,
+                                                        iree_time_t deadline_ns);
+
+// A wait operation that a yielded call is blocked on.
+// Execution of the call can only make progress once the wait is satisfied and
+// resuming before then will immediately yield again on the same wait.
+typedef struct iree_vm_wait_t {
+  // Waits on |ref| with the given |payload|. NULL if there is no wait.
+  iree_vm_wait_fn_t wait_fn;
+  // Object being waited on (such as a semaphore). Retained by the wait.
+  iree_vm_ref_t ref;
+  // Implementation-defined wait payload (such as a semaphore timepoint).
+  uint64_t payload;
+} iree_vm_wait_t;
+
+// Blocks the caller until |wait| is satisfied or |deadline_ns| elapses.
+// Returns OK immediately if |wait| has no wait function.
+static inline iree_status_t iree_vm_wait_until(iree_vm_wait_t* wait,
+                                               iree_time_t deadline_ns) {
+  if (!wait->wait_fn) return iree_ok_status();
+  return wait->wait_fn(&wait->ref, wait->payload, deadline_ns);
+}
+
+// Releases the resources retained by |wait| and resets it.
+static inline void iree_vm_wait_reset(iree_vm_wait_t* wait) {
+  iree_vm_ref_release(&wait->ref);
+  wait->wait_fn = NULL;
+  wait->payload = 0;
+}
+
+enum iree_vm_execution_result_flag_bits_t {
+  IREE_VM_EXECUTION_RESULT_FLAG_NONE = 0u,
+  // The call yielded before completing and its frames remain on the stack.
+  // The call results are not yet available and execution must be continued
+  // with resume_call.
+  IREE_VM_EXECUTION_RESULT_FLAG_YIELDED = 1u << 0,
+  // The call yielded because it is blocked on the iree_vm_wait_t in the
+  // execution result. Resuming the call prior to the wait being satisfied will
+  // yield again.
+  IREE_VM_EXECUTION_RESULT_FLAG_WAITING = 1u << 1,
+};
+typedef uint32_t iree_vm_execution_result_flags_t;
+
 // Results of an iree_vm_module_execute request.
 typedef struct iree_vm_execution_result_t {
-  // TODO(benvanik): yield information.
-  // Yield modes:
-  // - yield (yield instruction)
-  // - await (with 1+ wait handles)
-  // - break
-  int reserved;
+  // Flags indicating the execution state of the call.
+  iree_vm_execution_result_flags_t flags;
+  // Wait the call is blocked on when IREE_VM_EXECUTION_RESULT_FLAG_WAITING is
+  // set. Owned by the result and must be reset with iree_vm_wait_reset.
+  iree_vm_wait_t wait;
 } iree_vm_execution_result_t;
 
 // Source location interface.
@@ -277,6 +324,14 @@ typedef struct iree_vm_source_location_t {
 IREE_API_EXPORT iree_status_t iree_vm_source_location_format(
     iree_vm_source_location_t* source_location, iree_string_builder_t* builder);
 
+// Signals sent to modules to notify them of events in the contexts they are
+// registered with.
+typedef enum iree_vm_signal_e {
+  // A top-level invocation of a function within the context has completed.
+  // Modules may release any resources they scoped to the invocation.
+  IREE_VM_SIGNAL_INVOCATION_END = 0,
+} iree_vm_signal_t;
+
 // Defines an interface that can be used to reflect and execute functions on a
 // module.
 //
@@ -324,6 +379,15 @@ typedef struct iree_vm_module_t {
       void* self, iree_allocator_t allocator,
       iree_vm_module_state_t** out_module_state);
 
+  // Optional; allocates module state data initialized as a copy of the
+  // |source_module_state| of another context, including resolved imports.
+  // Immutable data is shared with the source and only mutable state (such as
+  // globals) is copied. The cloned state must only be used in contexts that
+  // have the same modules registered in the same order as the source.
+  iree_status_t(IREE_API_PTR* clone_state)(
+      void* self, const iree_vm_module_state_t* source_module_state,
+      iree_allocator_t allocator, iree_vm_module_state_t** out_module_state);
+
   // Frees module state data.
   void(IREE_API_PTR* free_state)(void* self,
                                  iree_vm_module_state_t* module_state);
@@ -344,8 +408,10 @@ typedef struct iree_vm_module_t {
       iree_vm_execution_result_t* out_result);
 
   // Resumes execution of a previously-yielded call.
+  // |call| must be the same call provided to begin_call and its result storage
+  // will be populated once the call completes.
   iree_status_t(IREE_API_PTR* resume_call)(
-      void* self, iree_vm_stack_t* stack,
+      void* self, iree_vm_stack_t* stack, const iree_vm_function_call_t* call,
       iree_vm_execution_result_t* out_result);
 
   // TODO(benvanik): move this/refactor.
@@ -360,6 +426,12 @@ typedef struct iree_vm_module_t {
       void* self, iree_vm_function_linkage_t linkage, iree_host_size_t ordinal,
       iree_host_size_t index, iree_string_view_t* key,
       iree_string_view_t* value);
+
+  // Optional; notifies the module of a |signal| in the context that owns
+  // |module_state|.
+  iree_status_t(IREE_API_PTR* notify)(void* self,
+                                      iree_vm_module_state_t* module_state,
+                                      iree_vm_signal_t signal);
 } iree_vm_module_t;
 
 // Initializes the interface of a module handle.
@@ -245,6 +245,15 @@ iree_vm_native_module_alloc_state(void* self, iree_allocator_t allocator,
   return iree_ok_status();
 }
 
+static iree_status_t IREE_API_PTR iree_vm_native_module_clone_state(
+    void* self, const iree_vm_module_state_t* source_module_state,
+    iree_allocator_t allocator, iree_vm_module_state_t** out_module_state) {
+  iree_vm_native_module_t* module = (iree_vm_native_module_t*)self;
+  *out_module_state = NULL;
+  return module->user_interface.clone_state(module->self, source_module_state,
+                                            allocator, out_module_state);
+}
+
 static void IREE_API_PTR iree_vm_native_module_free_state(
     void* self, iree_vm_module_state_t* module_state) {
   iree_vm_native_module_t* module = (iree_vm_native_module_t*)self;
@@ -317,17 +326,28 @@ static iree_status_t IREE_API_PTR iree_vm_native_module_begin_call(
   return iree_vm_stack_function_leave(stack);
 }
 
-static iree_status_t IREE_API_PTR
-iree_vm_native_module_resume_call(void* self, iree_vm_stack_t* stack,
-                                  iree_vm_execution_result_t* out_result) {
+static iree_status_t IREE_API_PTR iree_vm_native_module_resume_call(
+    void* self, iree_vm_stack_t* stack, const iree_vm_function_call_t* call,
+    iree_vm_execution_result_t* out_result) {
   iree_vm_native_module_t* module = (iree_vm_native_module_t*)self;
   if (module->user_interface.resume_call) {
-    return module->user_interface.resume_call(module->self, stack, out_result);
+    return module->user_interface.resume_call(module->self, stack, call,
+                                              out_result);
   }
   return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
                           "native module does not support resume");
 }
 
+static iree_status_t IREE_API_PTR iree_vm_native_module_notify(
+    void* self, iree_vm_module_state_t* module_state, iree_vm_signal_t signal) {
+  iree_vm_native_module_t* module = (iree_vm_native_module_t*)self;
+  if (module->user_interface.notify) {
+    return module->user_interface.notify(module->self, module_state, signal);
+  }
+  // No-op in the default implementation.
+  return iree_ok_status();
+}
+
 IREE_API_EXPORT iree_status_t iree_vm_native_module_create(
     const iree_vm_module_t* interface,
     const iree_vm_native_module_descriptor_t* module_descriptor,
@@ -420,10 +440,16 @@ IREE_API_EXPORT iree_status_t iree_vm_native_module_initialize(
   module->base_interface.lookup_function =
       iree_vm_native_module_lookup_function;
   module->base_interface.alloc_state = iree_vm_native_module_alloc_state;
+  if (module->user_interface.clone_state) {
+    // Only routed when provided so that contexts can fall back to allocating
+    // fresh state for modules that don't support cloning.
+    module->base_interface.clone_state = iree_vm_native_module_clone_state;
+  }
   module->base_interface.free_state = iree_vm_native_module_free_state;
   module->base_interface.resolve_import = iree_vm_native_module_resolve_import;
   module->base_interface.begin_call = iree_vm_native_module_begin_call;
   module->base_interface.resume_call = iree_vm_native_module_resume_call;
+  module->base_interface.notify = iree_vm_native_module_notify;
 
   return iree_ok_status();
 }
@@ -56,12 +56,18 @@ class VMNativeModuleTest : public ::testing::Test {
 
   StatusOr<int32_t> RunFunction(iree_string_view_t function_name,
                                 int32_t arg0) {
+    return RunFunction(context_, function_name, arg0);
+  }
+
+  StatusOr<int32_t> RunFunction(iree_vm_context_t* context,
+                                iree_string_view_t function_name,
+                                int32_t arg0) {
     // Lookup the entry function. This can be cached in an application if
     // multiple calls will be made.
     iree_vm_function_t function;
     IREE_RETURN_IF_ERROR(
         iree_vm_context_resolve_function(
-            context_, iree_make_cstring_view("module_b.entry"), &function),
+            context, iree_make_cstring_view("module_b.entry"), &function),
         "unable to resolve entry point");
 
     // Setup I/O lists and pass in the argument. The result list will be
@@ -77,7 +83,7 @@ class VMNativeModuleTest : public ::testing::Test {
         /*element_type=*/nullptr, 1, iree_allocator_system(), &output_list));
 
     // Invoke the entry function to do our work. Runs synchronously.
-    IREE_RETURN_IF_ERROR(iree_vm_invoke(context_, function,
+    IREE_RETURN_IF_ERROR(iree_vm_invoke(context, function,
                                         /*policy=*/nullptr, input_list.get(),
                                         output_list.get(),
                                         iree_allocator_system()));
@@ -89,7 +95,7 @@ class VMNativeModuleTest : public ::testing::Test {
     return ret0_value.i32;
   }
 
- private:
+ protected:
   iree_vm_instance_t* instance_ = nullptr;
   iree_vm_context_t* context_ = nullptr;
 };
@@ -106,5 +112,82 @@ TEST_F(VMNativeModuleTest, Example) {
   ASSERT_EQ(v2, 8);
 }
 
+// Tests that forked contexts start with a copy of the source module state and
+// then diverge.
+TEST_F(VMNativeModuleTest, Fork) {
+  IREE_ASSERT_OK_AND_ASSIGN(
+      int32_t v0, RunFunction(iree_make_cstring_view("module_b.entry"), 1));
+  ASSERT_EQ(v0, 1);
+
+  iree_vm_context_t* forked_context = nullptr;
+  IREE_ASSERT_OK(
+      iree_vm_context_fork(context_, iree_allocator_system(), &forked_context));
+
+  IREE_ASSERT_OK_AND_ASSIGN(
+      int32_t v1, RunFunction(forked_context,
+                              iree_make_cstring_view("module_b.entry"), 2));
+  ASSERT_EQ(v1, 4);
+  IREE_ASSERT_OK_AND_ASSIGN(
+      int32_t v2, RunFunction(forked_context,
+                              iree_make_cstring_view("module_b.entry"), 3));
+  ASSERT_EQ(v2, 8);
+
+  // The source context state is unaffected by calls on the fork.
+  IREE_ASSERT_OK_AND_ASSIGN(
+      int32_t v3, RunFunction(iree_make_cstring_view("module_b.entry"), 3));
+  ASSERT_EQ(v3, 5);
+
+  iree_vm_context_release(forked_context);
+}
+
+// Allocator forwarding to the system allocator that counts allocations.
+struct CountingAllocator {
+  static iree_status_t Ctl(void* self, iree_allocator_command_t command,
+                           const void* params, void** inout_ptr) {
+    if (command != IREE_ALLOCATOR_COMMAND_FREE) {
+      ++reinterpret_cast<CountingAllocator*>(self)->allocation_count;
+    }
+    iree_allocator_t system_allocator = iree_allocator_system();
+    return system_allocator.ctl(system_allocator.self, command, params,
+                                inout_ptr);
+  }
+  iree_allocator_t allocator() { return {this, Ctl}; }
+  int allocation_count = 0;
+};
+
+// Tests that repeatedly invoking a function with pinned I/O lists whose
+// contents are updated in place does not allocate.
+TEST_F(VMNativeModuleTest, PinnedInvokeIsAllocationFree) {
+  CountingAllocator counter;
+  iree_vm_function_t function;
+  IREE_ASSERT_OK(iree_vm_context_resolve_function(
+      context_, iree_make_cstring_view("module_b.entry"), &function));
+  vm::ref<iree_vm_list_t> input_list;
+  IREE_ASSERT_OK(iree_vm_list_create(/*element_type=*/nullptr, 1,
+                                     counter.allocator(), &input_list));
+  auto arg0_value = iree_vm_value_make_i32(1);
+  IREE_ASSERT_OK(iree_vm_list_push_value(input_list.get(), &arg0_value));
+  vm::ref<iree_vm_list_t> output_list;
+  IREE_ASSERT_OK(iree_vm_list_create(/*element_type=*/nullptr, 1,
+                                     counter.allocator(), &output_list));
+
+  // The first call may populate lazily-initialized state.
+  IREE_ASSERT_OK(iree_vm_invoke(context_, function, /*policy=*/nullptr,
+                                input_list.get(), output_list.get(),
+                                counter.allocator()));
+  int warm_allocation_count = counter.allocation_count;
+
+  for (int32_t i = 2; i < 16; ++i) {
+    arg0_value = iree_vm_value_make_i32(i);
+    IREE_ASSERT_OK(iree_vm_list_set_value(input_list.get(), 0, &arg0_value));
+    IREE_ASSERT_OK(iree_vm_invoke(context_, function, /*policy=*/nullptr,
+                                  input_list.get(), output_list.get(),
+                                  counter.allocator()));
+    iree_vm_value_t ret0_value;
+    IREE_ASSERT_OK(iree_vm_list_get_value(output_list.get(), 0, &ret0_value));
+  }
+  EXPECT_EQ(warm_allocation_count, counter.allocation_count);
+}
+
 }  // namespace
 }  // namespace iree
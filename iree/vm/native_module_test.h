@@ -187,6 +187,21 @@ module_b_alloc_state(void* self, iree_allocator_t allocator,
   return iree_ok_status();
 }
 
+// Allocates per-context state as a copy of the state of another context.
+// The resolved imports can be reused as the contexts have the same modules.
+static iree_status_t IREE_API_PTR
+module_b_clone_state(void* self, const iree_vm_module_state_t* source_state,
+                     iree_allocator_t allocator,
+                     iree_vm_module_state_t** out_module_state) {
+  module_b_state_t* state = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_allocator_malloc(allocator, sizeof(*state), (void**)&state));
+  memcpy(state, source_state, sizeof(*state));
+  state->allocator = allocator;
+  *out_module_state = (iree_vm_module_state_t*)state;
+  return iree_ok_status();
+}
+
 // Frees the per-context state.
 static void IREE_API_PTR
 module_b_free_state(void* self, iree_vm_module_state_t* module_state) {
@@ -300,6 +315,7 @@ static iree_status_t module_b_create(iree_allocator_t allocator,
   }
   interface.destroy = module_b_destroy;
   interface.alloc_state = module_b_alloc_state;
+  interface.clone_state = module_b_clone_state;
   interface.free_state = module_b_free_state;
   interface.resolve_import = module_b_resolve_import;
   return iree_vm_native_module_create(&interface, &module_b_descriptor_,
@@ -11,6 +11,9 @@
 #include <stdint.h>
 
 #include "iree/base/api.h"
+#include "iree/vm/buffer.h"
+#include "iree/vm/list.h"
+#include "iree/vm/ref.h"
 #include "iree/vm/value.h"
 
 //===------------------------------------------------------------------===//
@@ -135,6 +138,228 @@ static inline int32_t vm_cmp_nz_ref(iree_vm_ref_t* operand) {
   return (operand->ptr != NULL) ? 1 : 0;
 }
 
+//===------------------------------------------------------------------===//
+// Lists
+//===------------------------------------------------------------------===//
+
+static inline iree_status_t vm_list_copy(iree_vm_ref_t* source_list_ref,
+                                         int32_t source_offset,
+                                         iree_vm_ref_t* target_list_ref,
+                                         int32_t target_offset,
+                                         int32_t length) {
+  iree_vm_list_t* source_list = iree_vm_list_deref(*source_list_ref);
+  if (IREE_UNLIKELY(!source_list)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "source list is null");
+  }
+  iree_vm_list_t* target_list = iree_vm_list_deref(*target_list_ref);
+  if (IREE_UNLIKELY(!target_list)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "target list is null");
+  }
+  return iree_vm_list_copy(source_list, (uint32_t)source_offset, target_list,
+                           (uint32_t)target_offset, (uint32_t)length);
+}
+
+//===------------------------------------------------------------------===//
+// Buffers
+//===------------------------------------------------------------------===//
+
+// NOTE: these mirror the buffer op handlers in bytecode_dispatch.c; buffer
+// operands are passed as refs and must be non-null.
+
+static inline iree_status_t vm_buffer_deref(iree_vm_ref_t* ref,
+                                            iree_vm_buffer_t** out_buffer) {
+  *out_buffer = iree_vm_buffer_deref(*ref);
+  if (IREE_UNLIKELY(!*out_buffer)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT, "buffer is null");
+  }
+  return iree_ok_status();
+}
+
+static inline iree_status_t vm_buffer_alloc(iree_allocator_t allocator,
+                                            int32_t length,
+                                            iree_vm_ref_t* result_ref) {
+  iree_vm_buffer_t* buffer = NULL;
+  IREE_RETURN_IF_ERROR(iree_vm_buffer_create(
+      IREE_VM_BUFFER_ACCESS_MUTABLE | IREE_VM_BUFFER_ACCESS_ORIGIN_GUEST,
+      (uint32_t)length, allocator, &buffer));
+  return iree_vm_ref_wrap_assign(buffer, iree_vm_buffer_type_id(), result_ref);
+}
+
+static inline iree_status_t vm_buffer_clone(iree_allocator_t allocator,
+                                            iree_vm_ref_t* source_ref,
+                                            int32_t offset, int32_t length,
+                                            iree_vm_ref_t* result_ref) {
+  iree_vm_buffer_t* source = NULL;
+  IREE_RETURN_IF_ERROR(vm_buffer_deref(source_ref, &source));
+  iree_vm_buffer_t* result = NULL;
+  IREE_RETURN_IF_ERROR(iree_vm_buffer_clone(
+      IREE_VM_BUFFER_ACCESS_MUTABLE | IREE_VM_BUFFER_ACCESS_ORIGIN_GUEST,
+      source, (uint32_t)offset, (uint32_t)length, allocator, &result));
+  return iree_vm_ref_wrap_assign(result, iree_vm_buffer_type_id(), result_ref);
+}
+
+static inline iree_status_t vm_buffer_length(iree_vm_ref_t* buffer_ref,
+                                             int32_t* out_result) {
+  iree_vm_buffer_t* buffer = NULL;
+  IREE_RETURN_IF_ERROR(vm_buffer_deref(buffer_ref, &buffer));
+  *out_result = (int32_t)iree_vm_buffer_length(buffer);
+  return iree_ok_status();
+}
+
+static inline iree_status_t vm_buffer_copy(iree_vm_ref_t* source_buffer_ref,
+                                           int32_t source_offset,
+                                           iree_vm_ref_t* target_buffer_ref,
+                                           int32_t target_offset,
+                                           int32_t length) {
+  iree_vm_buffer_t* source_buffer = NULL;
+  IREE_RETURN_IF_ERROR(vm_buffer_deref(source_buffer_ref, &source_buffer));
+  iree_vm_buffer_t* target_buffer = NULL;
+  IREE_RETURN_IF_ERROR(vm_buffer_deref(target_buffer_ref, &target_buffer));
+  return iree_vm_buffer_copy_bytes(source_buffer, (uint32_t)source_offset,
+                                   target_buffer, (uint32_t)target_offset,
+                                   (uint32_t)length);
+}
+
+static inline iree_status_t vm_buffer_compare(iree_vm_ref_t* lhs_buffer_ref,
+                                              int32_t lhs_offset,
+                                              iree_vm_ref_t* rhs_buffer_ref,
+                                              int32_t rhs_offset,
+                                              int32_t length,
+                                              int32_t* out_result) {
+  iree_vm_buffer_t* lhs_buffer = NULL;
+  IREE_RETURN_IF_ERROR(vm_buffer_deref(lhs_buffer_ref, &lhs_buffer));
+  iree_vm_buffer_t* rhs_buffer = NULL;
+  IREE_RETURN_IF_ERROR(vm_buffer_deref(rhs_buffer_ref, &rhs_buffer));
+  bool result = false;
+  IREE_RETURN_IF_ERROR(iree_vm_buffer_compare_bytes(
+      lhs_buffer, (uint32_t)lhs_offset, rhs_buffer, (uint32_t)rhs_offset,
+      (uint32_t)length, &result));
+  *out_result = result ? 1 : 0;
+  return iree_ok_status();
+}
+
+static inline iree_status_t vm_buffer_fill_i8(iree_vm_ref_t* buffer_ref,
+                                              int32_t offset, int32_t length,
+                                              int32_t value) {
+  iree_vm_buffer_t* buffer = NULL;
+  IREE_RETURN_IF_ERROR(vm_buffer_deref(buffer_ref, &buffer));
+  uint8_t typed_value = (uint8_t)value;
+  return iree_vm_buffer_fill_elements(buffer, (uint32_t)offset,
+                                      (uint32_t)length / sizeof(uint8_t),
+                                      sizeof(uint8_t), &typed_value);
+}
+
+static inline iree_status_t vm_buffer_fill_i16(iree_vm_ref_t* buffer_ref,
+                                              int32_t offset, int32_t length,
+                                              int32_t value) {
+  iree_vm_buffer_t* buffer = NULL;
+  IREE_RETURN_IF_ERROR(vm_buffer_deref(buffer_ref, &buffer));
+  uint16_t typed_value = (uint16_t)value;
+  return iree_vm_buffer_fill_elements(buffer, (uint32_t)offset,
+                                      (uint32_t)length / sizeof(uint16_t),
+                                      sizeof(uint16_t), &typed_value);
+}
+
+static inline iree_status_t vm_buffer_fill_i32(iree_vm_ref_t* buffer_ref,
+                                              int32_t offset, int32_t length,
+                                              int32_t value) {
+  iree_vm_buffer_t* buffer = NULL;
+  IREE_RETURN_IF_ERROR(vm_buffer_deref(buffer_ref, &buffer));
+  uint32_t typed_value = (uint32_t)value;
+  return iree_vm_buffer_fill_elements(buffer, (uint32_t)offset,
+                                      (uint32_t)length / sizeof(uint32_t),
+                                      sizeof(uint32_t), &typed_value);
+}
+
+static inline iree_status_t vm_buffer_load_i8u(iree_vm_ref_t* buffer_ref,
+                                              int32_t offset,
+                                              int32_t* out_result) {
+  iree_vm_buffer_t* buffer = NULL;
+  IREE_RETURN_IF_ERROR(vm_buffer_deref(buffer_ref, &buffer));
+  uint8_t result = 0;
+  IREE_RETURN_IF_ERROR(iree_vm_buffer_read_elements(
+      buffer, (uint32_t)offset, &result, 1, sizeof(result)));
+  *out_result = (int32_t)result;
+  return iree_ok_status();
+}
+
+static inline iree_status_t vm_buffer_load_i8s(iree_vm_ref_t* buffer_ref,
+                                              int32_t offset,
+                                              int32_t* out_result) {
+  iree_vm_buffer_t* buffer = NULL;
+  IREE_RETURN_IF_ERROR(vm_buffer_deref(buffer_ref, &buffer));
+  int8_t result = 0;
+  IREE_RETURN_IF_ERROR(iree_vm_buffer_read_elements(
+      buffer, (uint32_t)offset, &result, 1, sizeof(result)));
+  *out_result = (int32_t)result;
+  return iree_ok_status();
+}
+
+static inline iree_status_t vm_buffer_load_i16u(iree_vm_ref_t* buffer_ref,
+                                              int32_t offset,
+                                              int32_t* out_result) {
+  iree_vm_buffer_t* buffer = NULL;
+  IREE_RETURN_IF_ERROR(vm_buffer_deref(buffer_ref, &buffer));
+  uint16_t result = 0;
+  IREE_RETURN_IF_ERROR(iree_vm_buffer_read_elements(
+      buffer, (uint32_t)offset, &result, 1, sizeof(result)));
+  *out_result = (int32_t)result;
+  return iree_ok_status();
+}
+
+static inline iree_status_t vm_buffer_load_i16s(iree_vm_ref_t* buffer_ref,
+                                              int32_t offset,
+                                              int32_t* out_result) {
+  iree_vm_buffer_t* buffer = NULL;
+  IREE_RETURN_IF_ERROR(vm_buffer_deref(buffer_ref, &buffer));
+  int16_t result = 0;
+  IREE_RETURN_IF_ERROR(iree_vm_buffer_read_elements(
+      buffer, (uint32_t)offset, &result, 1, sizeof(result)));
+  *out_result = (int32_t)result;
+  return iree_ok_status();
+}
+
+static inline iree_status_t vm_buffer_load_i32(iree_vm_ref_t* buffer_ref,
+                                              int32_t offset,
+                                              int32_t* out_result) {
+  iree_vm_buffer_t* buffer = NULL;
+  IREE_RETURN_IF_ERROR(vm_buffer_deref(buffer_ref, &buffer));
+  int32_t result = 0;
+  IREE_RETURN_IF_ERROR(iree_vm_buffer_read_elements(
+      buffer, (uint32_t)offset, &result, 1, sizeof(result)));
+  *out_result = (int32_t)result;
+  return iree_ok_status();
+}
+
+static inline iree_status_t vm_buffer_store_i8(iree_vm_ref_t* buffer_ref,
+                                               int32_t offset, int32_t value) {
+  iree_vm_buffer_t* buffer = NULL;
+  IREE_RETURN_IF_ERROR(vm_buffer_deref(buffer_ref, &buffer));
+  uint8_t typed_value = (uint8_t)value;
+  return iree_vm_buffer_write_elements(&typed_value, buffer, (uint32_t)offset,
+                                       1, sizeof(uint8_t));
+}
+
+static inline iree_status_t vm_buffer_store_i16(iree_vm_ref_t* buffer_ref,
+                                               int32_t offset, int32_t value) {
+  iree_vm_buffer_t* buffer = NULL;
+  IREE_RETURN_IF_ERROR(vm_buffer_deref(buffer_ref, &buffer));
+  uint16_t typed_value = (uint16_t)value;
+  return iree_vm_buffer_write_elements(&typed_value, buffer, (uint32_t)offset,
+                                       1, sizeof(uint16_t));
+}
+
+static inline iree_status_t vm_buffer_store_i32(iree_vm_ref_t* buffer_ref,
+                                               int32_t offset, int32_t value) {
+  iree_vm_buffer_t* buffer = NULL;
+  IREE_RETURN_IF_ERROR(vm_buffer_deref(buffer_ref, &buffer));
+  uint32_t typed_value = (uint32_t)value;
+  return iree_vm_buffer_write_elements(&typed_value, buffer, (uint32_t)offset,
+                                       1, sizeof(uint32_t));
+}
+
 //===------------------------------------------------------------------===//
 // ExtI64: Globals
 //===------------------------------------------------------------------===//
@@ -17,6 +17,72 @@
 // or something more complex).
 #define IREE_VM_MAX_TYPE_ID 64
 
+//===----------------------------------------------------------------------===//
+// Reference counting
+//===----------------------------------------------------------------------===//
+
+#if IREE_VM_REF_SINGLE_THREADED
+
+#if !defined(NDEBUG)
+#if defined(IREE_COMPILER_MSVC)
+#define IREE_VM_REF_THREAD_LOCAL __declspec(thread)
+#else
+#define IREE_VM_REF_THREAD_LOCAL _Thread_local
+#endif  // IREE_COMPILER_MSVC
+
+// Identifies the thread that performed the first ref counting operation.
+// All subsequent operations must come from the same thread as otherwise the
+// non-atomic counters would race.
+static iree_atomic_intptr_t iree_vm_ref_owner_thread = IREE_ATOMIC_VAR_INIT(0);
+
+// Asserts that the calling thread is the one that first used ref counting.
+// The address of a thread-local is used as a cheap unique thread identifier.
+static void iree_vm_ref_assert_owner_thread(void) {
+  static IREE_VM_REF_THREAD_LOCAL uint8_t thread_marker = 0;
+  intptr_t current_thread = (intptr_t)&thread_marker;
+  intptr_t owner_thread = 0;
+  if (iree_atomic_compare_exchange_strong_intptr(
+          &iree_vm_ref_owner_thread, &owner_thread, current_thread,
+          iree_memory_order_relaxed, iree_memory_order_relaxed)) {
+    return;  // first use; we are now the owner
+  }
+  IREE_ASSERT(owner_thread == current_thread,
+              "ref counted from multiple threads while "
+              "IREE_VM_REF_SINGLE_THREADED is enabled");
+}
+#else
+#define iree_vm_ref_assert_owner_thread()
+#endif  // !NDEBUG
+
+// Non-atomic counter updates. Relaxed loads and stores compile to plain
+// memory operations and avoid the locked read-modify-write instructions.
+static inline void iree_vm_ref_counter_inc(
+    volatile iree_atomic_ref_count_t* counter) {
+  iree_vm_ref_assert_owner_thread();
+  iree_atomic_ref_count_t* value_ptr = (iree_atomic_ref_count_t*)counter;
+  iree_atomic_store_int32(
+      value_ptr,
+      iree_atomic_load_int32(value_ptr, iree_memory_order_relaxed) + 1,
+      iree_memory_order_relaxed);
+}
+
+// Decrements |counter| and returns the value prior to the decrement.
+static inline int32_t iree_vm_ref_counter_dec(
+    volatile iree_atomic_ref_count_t* counter) {
+  iree_vm_ref_assert_owner_thread();
+  iree_atomic_ref_count_t* value_ptr = (iree_atomic_ref_count_t*)counter;
+  int32_t value = iree_atomic_load_int32(value_ptr, iree_memory_order_relaxed);
+  iree_atomic_store_int32(value_ptr, value - 1, iree_memory_order_relaxed);
+  return value;
+}
+
+#else
+
+#define iree_vm_ref_counter_inc(counter) iree_atomic_ref_count_inc(counter)
+#define iree_vm_ref_counter_dec(counter) iree_atomic_ref_count_dec(counter)
+
+#endif  // IREE_VM_REF_SINGLE_THREADED
+
 static inline volatile iree_atomic_ref_count_t* iree_vm_get_raw_counter_ptr(
     void* ptr, const iree_vm_ref_type_descriptor_t* type_descriptor) {
   return (volatile iree_atomic_ref_count_t*)(((uintptr_t)(ptr)) +
@@ -34,7 +100,7 @@ IREE_API_EXPORT void iree_vm_ref_object_retain(
   if (!ptr) return;
   volatile iree_atomic_ref_count_t* counter =
       iree_vm_get_raw_counter_ptr(ptr, type_descriptor);
-  iree_atomic_ref_count_inc(counter);
+  iree_vm_ref_counter_inc(counter);
 }
 
 IREE_API_EXPORT void iree_vm_ref_object_release(
@@ -42,7 +108,7 @@ IREE_API_EXPORT void iree_vm_ref_object_release(
   if (!ptr) return;
   volatile iree_atomic_ref_count_t* counter =
       iree_vm_get_raw_counter_ptr(ptr, type_descriptor);
-  if (iree_atomic_ref_count_dec(counter) == 1) {
+  if (iree_vm_ref_counter_dec(counter) == 1) {
     if (type_descriptor->destroy) {
       // NOTE: this makes us not re-entrant, but I think that's OK.
       type_descriptor->destroy(ptr);
@@ -137,7 +203,7 @@ IREE_API_EXPORT iree_status_t iree_vm_ref_wrap_retain(void* ptr,
   if (out_ref->ptr) {
     volatile iree_atomic_ref_count_t* counter =
         iree_vm_get_ref_counter_ptr(out_ref);
-    iree_atomic_ref_count_inc(counter);
+    iree_vm_ref_counter_inc(counter);
   }
   return iree_ok_status();
 }
@@ -158,7 +224,7 @@ IREE_API_EXPORT void iree_vm_ref_retain(iree_vm_ref_t* ref,
   if (out_ref->ptr) {
     volatile iree_atomic_ref_count_t* counter =
         iree_vm_get_ref_counter_ptr(out_ref);
-    iree_atomic_ref_count_inc(counter);
+    iree_vm_ref_counter_inc(counter);
   }
 }
 
@@ -187,7 +253,7 @@ IREE_API_EXPORT void iree_vm_ref_retain_or_move(int is_move, iree_vm_ref_t* ref,
     // Retain by incrementing counter and preserving the source ref.
     volatile iree_atomic_ref_count_t* counter =
         iree_vm_get_ref_counter_ptr(out_ref);
-    iree_atomic_ref_count_inc(counter);
+    iree_vm_ref_counter_inc(counter);
   } else if (ref != out_ref) {
     // Move by not changing counter and clearing the source ref.
     memset(ref, 0, sizeof(*ref));
@@ -210,7 +276,7 @@ IREE_API_EXPORT void iree_vm_ref_release(iree_vm_ref_t* ref) {
   if (ref->type == IREE_VM_REF_TYPE_NULL || ref->ptr == NULL) return;
 
   volatile iree_atomic_ref_count_t* counter = iree_vm_get_ref_counter_ptr(ref);
-  if (iree_atomic_ref_count_dec(counter) == 1) {
+  if (iree_vm_ref_counter_dec(counter) == 1) {
     const iree_vm_ref_type_descriptor_t* type_descriptor =
         iree_vm_ref_get_type_descriptor(ref->type);
     if (type_descriptor->destroy) {
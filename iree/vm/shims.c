@@ -6,7 +6,9 @@
 
 #include "iree/vm/shims.h"
 
+IREE_VM_ABI_DEFINE_SHIM(i, r);
 IREE_VM_ABI_DEFINE_SHIM(irii, v);
+IREE_VM_ABI_DEFINE_SHIM(iriiiii, v);
 IREE_VM_ABI_DEFINE_SHIM(r, i);
 IREE_VM_ABI_DEFINE_SHIM(r, ii);
 IREE_VM_ABI_DEFINE_SHIM(r, iii);
@@ -26,6 +28,10 @@ IREE_VM_ABI_DEFINE_SHIM(rii, i);
 IREE_VM_ABI_DEFINE_SHIM(rii, r);
 IREE_VM_ABI_DEFINE_SHIM(riii, r);
 IREE_VM_ABI_DEFINE_SHIM(riii, v);
+IREE_VM_ABI_DEFINE_SHIM(riiiriiiii, v);
+IREE_VM_ABI_DEFINE_SHIM(riiiriiiriiiii, v);
+IREE_VM_ABI_DEFINE_SHIM(riiriiriiiiii, v);
+IREE_VM_ABI_DEFINE_SHIM(riiriiriiiiiiiii, v);
 IREE_VM_ABI_DEFINE_SHIM(riirii, r);
 IREE_VM_ABI_DEFINE_SHIM(rrrCrD, r);
 IREE_VM_ABI_DEFINE_SHIM(ririi, v);
@@ -34,9 +40,12 @@ IREE_VM_ABI_DEFINE_SHIM(rr, r);
 IREE_VM_ABI_DEFINE_SHIM(rr, v);
 IREE_VM_ABI_DEFINE_SHIM(rr, ii);
 IREE_VM_ABI_DEFINE_SHIM(rrr, ii);
+IREE_VM_ABI_DEFINE_SHIM(rrri, v);
+IREE_VM_ABI_DEFINE_SHIM(rrriCriD, v);
 IREE_VM_ABI_DEFINE_SHIM(rrCiriiD, r);
 IREE_VM_ABI_DEFINE_SHIM(rriCiD, v);
 IREE_VM_ABI_DEFINE_SHIM(rriCiriiD, v);
+IREE_VM_ABI_DEFINE_SHIM(rrriiiiiiCiDCiriiD, v);
 IREE_VM_ABI_DEFINE_SHIM(rriii, v);
 IREE_VM_ABI_DEFINE_SHIM(rriiii, v);
 IREE_VM_ABI_DEFINE_SHIM(rrirCiD, v);
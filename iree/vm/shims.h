@@ -189,6 +189,16 @@ IREE_VM_ABI_FIXED_STRUCT(irii, {
   int32_t i3;
 });
 
+IREE_VM_ABI_FIXED_STRUCT(iriiiii, {
+  int32_t i0;
+  iree_vm_ref_t r1;
+  int32_t i2;
+  int32_t i3;
+  int32_t i4;
+  int32_t i5;
+  int32_t i6;
+});
+
 IREE_VM_ABI_FIXED_STRUCT(r, { iree_vm_ref_t r0; });
 
 IREE_VM_ABI_FIXED_STRUCT(rr, {
@@ -202,6 +212,13 @@ IREE_VM_ABI_FIXED_STRUCT(rrr, {
   iree_vm_ref_t r2;
 });
 
+IREE_VM_ABI_FIXED_STRUCT(rrri, {
+  iree_vm_ref_t r0;
+  iree_vm_ref_t r1;
+  iree_vm_ref_t r2;
+  int32_t i3;
+});
+
 IREE_VM_ABI_FIXED_STRUCT(ri, {
   iree_vm_ref_t r0;
   int32_t i1;
@@ -234,6 +251,71 @@ IREE_VM_ABI_FIXED_STRUCT(riii, {
   int32_t i3;
 });
 
+IREE_VM_ABI_FIXED_STRUCT(riiiriiiii, {
+  iree_vm_ref_t r0;
+  int32_t i1;
+  int32_t i2;
+  int32_t i3;
+  iree_vm_ref_t r4;
+  int32_t i5;
+  int32_t i6;
+  int32_t i7;
+  int32_t i8;
+  int32_t i9;
+});
+
+IREE_VM_ABI_FIXED_STRUCT(riiiriiiriiiii, {
+  iree_vm_ref_t r0;
+  int32_t i1;
+  int32_t i2;
+  int32_t i3;
+  iree_vm_ref_t r4;
+  int32_t i5;
+  int32_t i6;
+  int32_t i7;
+  iree_vm_ref_t r8;
+  int32_t i9;
+  int32_t i10;
+  int32_t i11;
+  int32_t i12;
+  int32_t i13;
+});
+
+IREE_VM_ABI_FIXED_STRUCT(riiriiriiiiii, {
+  iree_vm_ref_t r0;
+  int32_t i1;
+  int32_t i2;
+  iree_vm_ref_t r3;
+  int32_t i4;
+  int32_t i5;
+  iree_vm_ref_t r6;
+  int32_t i7;
+  int32_t i8;
+  int32_t i9;
+  int32_t i10;
+  int32_t i11;
+  int32_t i12;
+});
+
+IREE_VM_ABI_FIXED_STRUCT(riiriiriiiiiiiii, {
+  iree_vm_ref_t r0;
+  int32_t i1;
+  int32_t i2;
+  iree_vm_ref_t r3;
+  int32_t i4;
+  int32_t i5;
+  iree_vm_ref_t r6;
+  int32_t i7;
+  int32_t i8;
+  int32_t i9;
+  int32_t i10;
+  int32_t i11;
+  int32_t i12;
+  int32_t i13;
+  int32_t i14;
+  int32_t i15;
+});
+
 IREE_VM_ABI_FIXED_STRUCT(riirii, {
   iree_vm_ref_t r0;
   int32_t i1;
@@ -352,6 +434,15 @@ IREE_VM_ABI_VLA_STRUCT(rrirCiD, a4_count, a4, {
   iree_vm_abi_i_t a4[0];
 });
 
+IREE_VM_ABI_VLA_STRUCT(rrriCriD, a4_count, a4, {
+  iree_vm_ref_t r0;
+  iree_vm_ref_t r1;
+  iree_vm_ref_t r2;
+  int32_t i3;
+  iree_vm_size_t a4_count;
+  iree_vm_abi_ri_t a4[0];
+});
+
 IREE_VM_ABI_VLA_STRUCT(riCiiiD, a2_count, a2, {
   iree_vm_ref_t r0;
   int32_t i1;
@@ -374,6 +465,55 @@ IREE_VM_ABI_VLA_STRUCT(rriCiriiD, a3_count, a3, {
   iree_vm_abi_irii_t a3[0];
 });
 
+// Trailing variadic segment of a struct with multiple variadic segments.
+typedef struct iree_vm_abi_CiriiD_t {
+  iree_vm_size_t count;
+  iree_vm_abi_irii_t values[0];
+} IREE_ATTRIBUTE_PACKED iree_vm_abi_CiriiD_t;
+
+// Two variadic segments: the second (a10) directly follows the last element of
+// the first (a9) and is accessed with iree_vm_abi_rrriiiiiiCiDCiriiD_a10.
+typedef struct iree_vm_abi_rrriiiiiiCiDCiriiD_t {
+  iree_vm_ref_t r0;
+  iree_vm_ref_t r1;
+  iree_vm_ref_t r2;
+  int32_t i3;
+  int32_t i4;
+  int32_t i5;
+  int32_t i6;
+  int32_t i7;
+  int32_t i8;
+  iree_vm_size_t a9_count;
+  iree_vm_abi_i_t a9[0];
+} IREE_ATTRIBUTE_PACKED iree_vm_abi_rrriiiiiiCiDCiriiD_t;
+
+static inline iree_vm_abi_CiriiD_t* iree_vm_abi_rrriiiiiiCiDCiriiD_a10(
+    iree_vm_abi_rrriiiiiiCiDCiriiD_t* args) {
+  return (iree_vm_abi_CiriiD_t*)&args->a9[args->a9_count];
+}
+
+static inline iree_vm_abi_rrriiiiiiCiDCiriiD_t*
+iree_vm_abi_rrriiiiiiCiDCiriiD_checked_deref(iree_byte_span_t buffer) {
+  if (IREE_UNLIKELY(buffer.data_length <
+                    sizeof(iree_vm_abi_rrriiiiiiCiDCiriiD_t))) {
+    return NULL;
+  }
+  iree_vm_abi_rrriiiiiiCiDCiriiD_t* args =
+      (iree_vm_abi_rrriiiiiiCiDCiriiD_t*)buffer.data;
+  iree_host_size_t a10_offset = sizeof(iree_vm_abi_rrriiiiiiCiDCiriiD_t) +
+                                args->a9_count * sizeof(iree_vm_abi_i_t);
+  if (IREE_UNLIKELY(buffer.data_length <
+                    a10_offset + sizeof(iree_vm_abi_CiriiD_t))) {
+    return NULL;
+  }
+  iree_vm_abi_CiriiD_t* a10 = iree_vm_abi_rrriiiiiiCiDCiriiD_a10(args);
+  return IREE_LIKELY(buffer.data_length ==
+                     a10_offset + sizeof(iree_vm_abi_CiriiD_t) +
+                         a10->count * sizeof(iree_vm_abi_irii_t))
+             ? args
+             : NULL;
+}
+
 #if defined(IREE_COMPILER_MSVC)
 #pragma pack(pop)
 #endif  // IREE_COMPILER_MSVC
@@ -382,7 +522,9 @@ IREE_VM_ABI_VLA_STRUCT(rriCiriiD, a3_count, a3, {
 // Shims for marshaling arguments and results
 //===----------------------------------------------------------------------===//
 
+IREE_VM_ABI_DECLARE_SHIM(i, r);
 IREE_VM_ABI_DECLARE_SHIM(irii, v);
+IREE_VM_ABI_DECLARE_SHIM(iriiiii, v);
 IREE_VM_ABI_DECLARE_SHIM(r, i);
 IREE_VM_ABI_DECLARE_SHIM(r, ii);
 IREE_VM_ABI_DECLARE_SHIM(r, iii);
@@ -405,6 +547,10 @@ IREE_VM_ABI_DECLARE_SHIM(rii, v);
 IREE_VM_ABI_DECLARE_SHIM(rif, v);
 IREE_VM_ABI_DECLARE_SHIM(riii, r);
 IREE_VM_ABI_DECLARE_SHIM(riii, v);
+IREE_VM_ABI_DECLARE_SHIM(riiiriiiii, v);
+IREE_VM_ABI_DECLARE_SHIM(riiiriiiriiiii, v);
+IREE_VM_ABI_DECLARE_SHIM(riiriiriiiiii, v);
+IREE_VM_ABI_DECLARE_SHIM(riiriiriiiiiiiii, v);
 IREE_VM_ABI_DECLARE_SHIM(riirii, r);
 IREE_VM_ABI_DECLARE_SHIM(rrrCrD, r);
 IREE_VM_ABI_DECLARE_SHIM(ririi, v);
@@ -413,9 +559,12 @@ IREE_VM_ABI_DECLARE_SHIM(rr, r);
 IREE_VM_ABI_DECLARE_SHIM(rr, v);
 IREE_VM_ABI_DECLARE_SHIM(rr, ii);
 IREE_VM_ABI_DECLARE_SHIM(rrr, ii);
+IREE_VM_ABI_DECLARE_SHIM(rrri, v);
+IREE_VM_ABI_DECLARE_SHIM(rrriCriD, v);
 IREE_VM_ABI_DECLARE_SHIM(rrCiriiD, r);
 IREE_VM_ABI_DECLARE_SHIM(rriCiD, v);
 IREE_VM_ABI_DECLARE_SHIM(rriCiriiD, v);
+IREE_VM_ABI_DECLARE_SHIM(rrriiiiiiCiDCiriiD, v);
 IREE_VM_ABI_DECLARE_SHIM(rriii, v);
 IREE_VM_ABI_DECLARE_SHIM(rriiii, v);
 IREE_VM_ABI_DECLARE_SHIM(rrirCiD, v);
@@ -13,6 +13,7 @@
 
 #include "iree/base/alignment.h"
 #include "iree/base/api.h"
+#include "iree/base/internal/arena.h"
 #include "iree/base/tracing.h"
 #include "iree/vm/module.h"
 
@@ -79,6 +80,24 @@
 // entry and that users of the stack cannot rely on pointer stability during
 // execution.
 //
+// Segmented stack growth
+// ----------------------
+// Reallocation requires the entire stack to be copied and stacks sized for the
+// deepest program that may run. When many invocations are in flight at once
+// this adds up and so stacks may instead be given a block pool from which they
+// acquire additional segments as frames spill out of the current one:
+//
+// [initial storage]   [segment 1 (pool block)]   [segment 2 (pool block)]
+//  [frame 0] [frame 1] <- [header] [frame 2] <----- [header] [frame 3]
+//
+// Frames never span segments and the frame linked list is unchanged so walking
+// the stack works the same as before. Because no frame is ever moved there is
+// no fixup step and frame pointers remain stable. Each segment header records
+// the storage of the segment preceding it so that when the first frame in a
+// segment is left the segment can be returned to the pool. The most recently
+// released segment is retained by the stack to avoid round-tripping through
+// the pool when calls repeatedly cross the same segment boundary.
+//
 // Calling convention
 // ------------------
 // Callers provide an arguments buffer and results buffer sized appropriately
@@ -121,6 +140,12 @@
 // but otherwise leave as small as we can to avoid overallocation.
 #define IREE_VM_STACK_GROWTH_FACTOR 2
 
+// Number of module to module state mappings cached on each stack. Cross-module
+// calls between the (usually few) modules in a context are resolved from the
+// cache without calling the state resolver such that many stacks can run in
+// one shared context without touching any context memory beyond the states.
+#define IREE_VM_STACK_MODULE_STATE_CACHE_CAPACITY 4
+
 // A private stack frame header that allows us to walk the linked list of
 // frames without exposing their exact structure through the API. This makes it
 // easier for us to add/version additional information or hide implementation
@@ -151,6 +176,27 @@ typedef struct iree_vm_stack_frame_header_t {
   iree_vm_stack_frame_t frame;
 } iree_vm_stack_frame_header_t;
 
+// A header at the start of each segment acquired for segmented stack growth.
+typedef struct iree_vm_stack_segment_header_t {
+  // Frame storage of the segment preceding this one to restore when the
+  // segment is released.
+  void* parent_storage;
+  iree_host_size_t parent_storage_capacity;
+  iree_host_size_t parent_storage_size;
+  struct iree_vm_stack_segment_header_t* parent;
+
+  // Total capacity of the segment, in bytes, including this header.
+  iree_host_size_t capacity;
+
+  // Block pool block backing the segment or NULL if the segment was allocated
+  // from the stack allocator as it was too large for a block.
+  iree_arena_block_t* block;
+} iree_vm_stack_segment_header_t;
+
+// Byte offset of the first frame within a segment.
+#define IREE_VM_STACK_SEGMENT_HEADER_SIZE \
+  iree_host_align(sizeof(iree_vm_stack_segment_header_t), 16)
+
 // Core stack storage. This will be mapped either into dynamic memory allocated
 // by the member allocator or static memory allocated externally. Static stacks
 // cannot grow when storage runs out while dynamic ones will resize their stack.
@@ -179,12 +225,45 @@ struct iree_vm_stack_t {
   bool owns_frame_storage;
 
   // Resolves a module to a module state within a context.
-  // This will be called on function entry whenever module transitions occur.
+  // This will be called on function entry whenever module transitions occur
+  // to modules not present in the module state cache.
   iree_vm_state_resolver_t state_resolver;
 
+  // Module states previously returned by the state resolver. A module's state
+  // never changes for the lifetime of the module within a context and since
+  // stacks are never shared between threads this requires no synchronization.
+  // Entries are replaced round-robin once the cache is full.
+  struct {
+    iree_vm_module_t* module;
+    iree_vm_module_state_t* module_state;
+  } module_state_cache[IREE_VM_STACK_MODULE_STATE_CACHE_CAPACITY];
+  iree_host_size_t module_state_cache_next;
+
   // Allocator used for dynamic stack allocations. May be the null allocator
   // if growth is prohibited.
   iree_allocator_t allocator;
+
+  // Block pool used for segmented stack growth or NULL if the stack grows by
+  // reallocating its frame storage.
+  iree_arena_block_pool_t* block_pool;
+
+  // Segment that frame_storage currently points into or NULL if frames are
+  // being placed in the initial storage.
+  iree_vm_stack_segment_header_t* segment;
+
+  // Total capacity of all active segments used to enforce
+  // IREE_VM_STACK_MAX_SIZE across the whole stack.
+  iree_host_size_t segment_capacity;
+
+  // A released pool segment retained for reuse; see above.
+  iree_vm_stack_segment_header_t* spare_segment;
+
+  // True if calls executing on the stack may yield and be resumed later.
+  bool resumable;
+
+  // Wait deferred by a native function that must be satisfied before the
+  // function can make progress. Taken by the caller of the function.
+  iree_vm_wait_t pending_wait;
 };
 
 //===----------------------------------------------------------------------===//
@@ -194,6 +273,14 @@ struct iree_vm_stack_t {
 IREE_API_EXPORT iree_status_t iree_vm_stack_initialize(
     iree_byte_span_t storage, iree_vm_state_resolver_t state_resolver,
     iree_allocator_t allocator, iree_vm_stack_t** out_stack) {
+  return iree_vm_stack_initialize_with_block_pool(
+      storage, /*block_pool=*/NULL, state_resolver, allocator, out_stack);
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_stack_initialize_with_block_pool(
+    iree_byte_span_t storage, iree_arena_block_pool_t* block_pool,
+    iree_vm_state_resolver_t state_resolver, iree_allocator_t allocator,
+    iree_vm_stack_t** out_stack) {
   IREE_ASSERT_ARGUMENT(out_stack);
   *out_stack = NULL;
   if (storage.data_length < IREE_VM_STACK_MIN_SIZE) {
@@ -210,6 +297,7 @@ IREE_API_EXPORT iree_status_t iree_vm_stack_initialize(
   stack->owns_frame_storage = false;
   stack->state_resolver = state_resolver;
   stack->allocator = allocator;
+  stack->block_pool = block_pool;
 
   iree_host_size_t storage_offset =
       iree_host_align(sizeof(iree_vm_stack_t), 16);
@@ -225,12 +313,25 @@ IREE_API_EXPORT iree_status_t iree_vm_stack_initialize(
   return iree_ok_status();
 }
 
+static void iree_vm_stack_pop_segment(iree_vm_stack_t* stack);
+static void iree_vm_stack_segment_free(iree_vm_stack_t* stack,
+                                       iree_vm_stack_segment_header_t* segment);
+
 IREE_API_EXPORT void iree_vm_stack_deinitialize(iree_vm_stack_t* stack) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
   while (stack->top) {
     iree_status_ignore(iree_vm_stack_function_leave(stack));
   }
+  iree_vm_wait_reset(&stack->pending_wait);
+  while (stack->segment) {
+    iree_vm_stack_pop_segment(stack);
+  }
+
+  if (stack->spare_segment) {
+    iree_vm_stack_segment_free(stack, stack->spare_segment);
+    stack->spare_segment = NULL;
+  }
 
   if (stack->owns_frame_storage) {
     iree_allocator_free(stack->allocator, stack->frame_storage);
@@ -273,6 +374,30 @@ IREE_API_EXPORT void iree_vm_stack_free(iree_vm_stack_t* stack) {
   IREE_TRACE_ZONE_END(z0);
 }
 
+IREE_API_EXPORT void iree_vm_stack_set_resumable(iree_vm_stack_t* stack,
+                                                 bool resumable) {
+  stack->resumable = resumable;
+}
+
+IREE_API_EXPORT bool iree_vm_stack_is_resumable(const iree_vm_stack_t* stack) {
+  return stack->resumable;
+}
+
+IREE_API_EXPORT void iree_vm_stack_defer_wait(iree_vm_stack_t* stack,
+                                              iree_vm_wait_t* wait) {
+  iree_vm_wait_reset(&stack->pending_wait);
+  stack->pending_wait = *wait;
+  memset(wait, 0, sizeof(*wait));
+}
+
+IREE_API_EXPORT bool iree_vm_stack_take_pending_wait(iree_vm_stack_t* stack,
+                                                     iree_vm_wait_t* out_wait) {
+  if (IREE_LIKELY(!stack->pending_wait.wait_fn)) return false;
+  *out_wait = stack->pending_wait;
+  memset(&stack->pending_wait, 0, sizeof(stack->pending_wait));
+  return true;
+}
+
 IREE_API_EXPORT iree_vm_stack_frame_t* iree_vm_stack_current_frame(
     iree_vm_stack_t* stack) {
   return stack->top ? &stack->top->frame : NULL;
@@ -288,8 +413,21 @@ IREE_API_EXPORT iree_vm_stack_frame_t* iree_vm_stack_parent_frame(
 IREE_API_EXPORT iree_status_t iree_vm_stack_query_module_state(
     iree_vm_stack_t* stack, iree_vm_module_t* module,
     iree_vm_module_state_t** out_module_state) {
-  return stack->state_resolver.query_module_state(stack->state_resolver.self,
-                                                  module, out_module_state);
+  IREE_ASSERT_ARGUMENT(module);
+  for (iree_host_size_t i = 0; i < IREE_VM_STACK_MODULE_STATE_CACHE_CAPACITY;
+       ++i) {
+    if (stack->module_state_cache[i].module == module) {
+      *out_module_state = stack->module_state_cache[i].module_state;
+      return iree_ok_status();
+    }
+  }
+  IREE_RETURN_IF_ERROR(stack->state_resolver.query_module_state(
+      stack->state_resolver.self, module, out_module_state));
+  iree_host_size_t slot = stack->module_state_cache_next++ %
+                          IREE_VM_STACK_MODULE_STATE_CACHE_CAPACITY;
+  stack->module_state_cache[slot].module = module;
+  stack->module_state_cache[slot].module_state = *out_module_state;
+  return iree_ok_status();
 }
 
 // Attempts to grow the stack store to hold at least |minimum_capacity|.
@@ -365,6 +503,99 @@ static iree_status_t iree_vm_stack_grow(iree_vm_stack_t* stack,
   return iree_ok_status();
 }
 
+// Returns the segment storage to the block pool or allocator it came from.
+static void iree_vm_stack_segment_free(
+    iree_vm_stack_t* stack, iree_vm_stack_segment_header_t* segment) {
+  if (segment->block) {
+    iree_arena_block_pool_release(stack->block_pool, segment->block,
+                                  segment->block);
+  } else {
+    iree_allocator_free(stack->allocator, segment);
+  }
+}
+
+// Switches the stack to a new segment with room for at least |frame_size|
+// bytes of frames. The current frame storage is left intact and restored when
+// the segment is popped.
+static iree_status_t iree_vm_stack_push_segment(iree_vm_stack_t* stack,
+                                                iree_host_size_t frame_size) {
+  iree_host_size_t header_size = IREE_VM_STACK_SEGMENT_HEADER_SIZE;
+  iree_host_size_t required_capacity = header_size + frame_size;
+  iree_host_size_t usable_block_size = stack->block_pool->usable_block_size;
+
+  iree_vm_stack_segment_header_t* segment = NULL;
+  if (required_capacity <= usable_block_size) {
+    if (stack->spare_segment) {
+      segment = stack->spare_segment;
+      stack->spare_segment = NULL;
+    } else {
+      iree_arena_block_t* block = NULL;
+      IREE_RETURN_IF_ERROR(
+          iree_arena_block_pool_acquire(stack->block_pool, &block));
+      segment = (iree_vm_stack_segment_header_t*)((uint8_t*)block -
+                                                  usable_block_size);
+      segment->capacity = usable_block_size;
+      segment->block = block;
+    }
+  } else {
+    // Too large for a block; fall back to the allocator just for this segment.
+    if (IREE_UNLIKELY(stack->allocator.ctl == NULL)) {
+      return iree_make_status(
+          IREE_STATUS_RESOURCE_EXHAUSTED,
+          "stack frame of %zu bytes exceeds the stack block size of %zu",
+          frame_size, usable_block_size);
+    }
+    IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+        stack->allocator, required_capacity, (void**)&segment));
+    segment->capacity = required_capacity;
+    segment->block = NULL;
+  }
+
+  if (IREE_UNLIKELY(stack->frame_storage_capacity + stack->segment_capacity +
+                        segment->capacity >
+                    IREE_VM_STACK_MAX_SIZE)) {
+    iree_host_size_t new_size = stack->frame_storage_capacity +
+                                stack->segment_capacity + segment->capacity;
+    if (segment->block) {
+      stack->spare_segment = segment;
+    } else {
+      iree_vm_stack_segment_free(stack, segment);
+    }
+    return iree_make_status(
+        IREE_STATUS_RESOURCE_EXHAUSTED,
+        "new stack size would exceed maximum size: %zu > %d", new_size,
+        IREE_VM_STACK_MAX_SIZE);
+  }
+
+  segment->parent_storage = stack->frame_storage;
+  segment->parent_storage_capacity = stack->frame_storage_capacity;
+  segment->parent_storage_size = stack->frame_storage_size;
+  segment->parent = stack->segment;
+
+  stack->segment = segment;
+  stack->segment_capacity += segment->capacity;
+  stack->frame_storage = segment;
+  stack->frame_storage_capacity = segment->capacity;
+  stack->frame_storage_size = header_size;
+  return iree_ok_status();
+}
+
+// Releases the current (empty) segment and restores the storage preceding it.
+static void iree_vm_stack_pop_segment(iree_vm_stack_t* stack) {
+  iree_vm_stack_segment_header_t* segment = stack->segment;
+  stack->frame_storage = segment->parent_storage;
+  stack->frame_storage_capacity = segment->parent_storage_capacity;
+  stack->frame_storage_size = segment->parent_storage_size;
+  stack->segment = segment->parent;
+  stack->segment_capacity -= segment->capacity;
+
+  if (segment->block && !stack->spare_segment) {
+    stack->spare_segment = segment;
+  } else {
+    iree_vm_stack_segment_free(stack, segment);
+  }
+}
+
 IREE_API_EXPORT iree_status_t iree_vm_stack_function_enter(
     iree_vm_stack_t* stack, const iree_vm_function_t* function,
     iree_vm_stack_frame_type_t frame_type, iree_host_size_t frame_size,
@@ -372,25 +603,34 @@ IREE_API_EXPORT iree_status_t iree_vm_stack_function_enter(
     iree_vm_stack_frame_t** out_callee_frame) {
   if (out_callee_frame) *out_callee_frame = NULL;
 
-  // Allocate stack space and grow stack, if required.
-  iree_host_size_t header_size = sizeof(iree_vm_stack_frame_header_t);
-  iree_host_size_t new_top =
-      stack->frame_storage_size + header_size + frame_size;
-  if (IREE_UNLIKELY(new_top > stack->frame_storage_capacity)) {
-    IREE_RETURN_IF_ERROR(iree_vm_stack_grow(stack, new_top));
-  }
-
   // Try to reuse the same module state if the caller and callee are from the
   // same module. Otherwise, query the state from the registered handler.
-  iree_vm_stack_frame_header_t* caller_frame_header = stack->top;
+  // This happens prior to allocating the frame so that failures don't leave
+  // behind an empty stack segment.
   iree_vm_stack_frame_t* caller_frame =
-      caller_frame_header ? &caller_frame_header->frame : NULL;
+      stack->top ? &stack->top->frame : NULL;
   iree_vm_module_state_t* module_state = NULL;
   if (caller_frame && caller_frame->function.module == function->module) {
     module_state = caller_frame->module_state;
   } else if (function->module != NULL) {
-    IREE_RETURN_IF_ERROR(stack->state_resolver.query_module_state(
-        stack->state_resolver.self, function->module, &module_state));
+    IREE_RETURN_IF_ERROR(iree_vm_stack_query_module_state(
+        stack, function->module, &module_state));
+  }
+
+  // Allocate stack space and grow stack, if required.
+  iree_host_size_t header_size = sizeof(iree_vm_stack_frame_header_t);
+  iree_host_size_t new_top =
+      stack->frame_storage_size + header_size + frame_size;
+  if (IREE_UNLIKELY(new_top > stack->frame_storage_capacity)) {
+    if (stack->block_pool) {
+      IREE_RETURN_IF_ERROR(
+          iree_vm_stack_push_segment(stack, header_size + frame_size));
+      new_top = stack->frame_storage_size + header_size + frame_size;
+    } else {
+      IREE_RETURN_IF_ERROR(iree_vm_stack_grow(stack, new_top));
+    }
+    // Growth may have relocated the caller frame.
+    caller_frame = stack->top ? &stack->top->frame : NULL;
   }
 
   // Bump pointer and get real stack pointer offsets.
@@ -453,6 +693,12 @@ iree_vm_stack_function_leave(iree_vm_stack_t* stack) {
   stack->frame_storage_size -= stack->top->frame_size;
   stack->top = stack->top->parent;
 
+  // Release the segment if we just left the first frame within it.
+  if (stack->segment &&
+      stack->frame_storage_size == IREE_VM_STACK_SEGMENT_HEADER_SIZE) {
+    iree_vm_stack_pop_segment(stack);
+  }
+
   return iree_ok_status();
 }
 
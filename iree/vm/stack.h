@@ -7,6 +7,7 @@
 #ifndef IREE_VM_STACK_H_
 #define IREE_VM_STACK_H_
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -41,6 +42,8 @@ extern "C" {
 // The maximum size of VM stack storage; anything larger is probably a bug.
 #define IREE_VM_STACK_MAX_SIZE (1 * 1024 * 1024)
 
+struct iree_arena_block_pool_t;
+
 typedef enum iree_vm_stack_frame_type_e {
   // Represents an `[external]` frame that needs to marshal args/results.
   // These frames have no source location and are tracked so that we know when
@@ -149,6 +152,33 @@ IREE_API_EXPORT iree_status_t iree_vm_stack_initialize(
     iree_byte_span_t storage, iree_vm_state_resolver_t state_resolver,
     iree_allocator_t allocator, iree_vm_stack_t** out_stack);
 
+// Initializes a statically-allocated stack in |storage| that grows in segments.
+// Once |storage| is exhausted additional segments are acquired from
+// |block_pool| and chained together instead of reallocating and relocating the
+// entire stack. Segments are returned to the pool as the frames within them are
+// left such that only invocations that actually go deep pay for the additional
+// storage and the pool can be shared by many concurrent stacks. Frames larger
+// than the pool block size are allocated from |allocator|, if provided.
+//
+// As frames are never relocated pointers to stack frames remain valid until
+// the frame is left.
+//
+// Example:
+//  iree_arena_block_pool_t block_pool;  // shared across invocations
+//  iree_arena_block_pool_initialize(IREE_VM_STACK_DEFAULT_SIZE, ...,
+//                                   &block_pool);
+//  ...
+//  uint8_t stack_storage[IREE_VM_STACK_MIN_SIZE];
+//  iree_vm_stack_t* stack = NULL;
+//  iree_vm_stack_initialize_with_block_pool(stack_storage, &block_pool, ...,
+//                                           &stack);
+//  ...
+//  iree_vm_stack_deinitialize(stack);
+IREE_API_EXPORT iree_status_t iree_vm_stack_initialize_with_block_pool(
+    iree_byte_span_t storage, struct iree_arena_block_pool_t* block_pool,
+    iree_vm_state_resolver_t state_resolver, iree_allocator_t allocator,
+    iree_vm_stack_t** out_stack);
+
 // Deinitializes a statically-allocated |stack| previously initialized with
 // iree_vm_stack_initialize.
 IREE_API_EXPORT void iree_vm_stack_deinitialize(iree_vm_stack_t* stack);
@@ -174,6 +204,34 @@ iree_vm_stack_allocate(iree_vm_state_resolver_t state_resolver,
 // Frees a dynamically-allocated |stack| from iree_vm_stack_allocate.
 IREE_API_EXPORT void iree_vm_stack_free(iree_vm_stack_t* stack);
 
+// Sets whether calls executing on |stack| may yield and be resumed later.
+// When enabled native functions may defer waits with iree_vm_stack_defer_wait
+// instead of blocking and calls that yield leave their frames on the stack.
+// Resumable stacks must outlive the calls executing on them and so cannot be
+// initialized on the host stack of a caller that may return before completion.
+IREE_API_EXPORT void iree_vm_stack_set_resumable(iree_vm_stack_t* stack,
+                                                 bool resumable);
+
+// Returns true if calls executing on |stack| may yield and be resumed later.
+IREE_API_EXPORT bool iree_vm_stack_is_resumable(const iree_vm_stack_t* stack);
+
+// Defers a |wait| that must be satisfied before the calling native function can
+// make progress. Ownership of the wait is transferred to the stack and |wait|
+// is reset.
+//
+// The native function must return successfully without producing any results
+// or side-effects. The caller will yield execution and re-issue the call once
+// the wait has been satisfied; the re-issued call is expected to make progress
+// without deferring again.
+IREE_API_EXPORT void iree_vm_stack_defer_wait(iree_vm_stack_t* stack,
+                                              iree_vm_wait_t* wait);
+
+// Takes the wait deferred by the last native function called, if any.
+// Returns true and transfers ownership of the wait to |out_wait| if one was
+// deferred.
+IREE_API_EXPORT bool iree_vm_stack_take_pending_wait(iree_vm_stack_t* stack,
+                                                     iree_vm_wait_t* out_wait);
+
 // Returns the current stack frame or nullptr if the stack is empty.
 IREE_API_EXPORT iree_vm_stack_frame_t* iree_vm_stack_current_frame(
     iree_vm_stack_t* stack);
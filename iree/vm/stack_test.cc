@@ -6,7 +6,11 @@
 
 #include "iree/vm/stack.h"
 
+#include <cstring>
+#include <vector>
+
 #include "iree/base/api.h"
+#include "iree/base/internal/arena.h"
 #include "iree/testing/gtest.h"
 #include "iree/testing/status_matchers.h"
 
@@ -17,6 +21,11 @@ namespace {
 #define MODULE_A_STATE_SENTINEL reinterpret_cast<iree_vm_module_state_t*>(101)
 #define MODULE_B_STATE_SENTINEL reinterpret_cast<iree_vm_module_state_t*>(102)
 
+static iree_status_t NeverSatisfiedWait(iree_vm_ref_t* ref, uint64_t payload,
+                                        iree_time_t deadline_ns) {
+  return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+}
+
 static int module_a_state_resolve_count = 0;
 static int module_b_state_resolve_count = 0;
 static iree_status_t SentinelStateResolver(
@@ -120,6 +129,83 @@ TEST(VMStackTest, StackOverflow) {
   iree_vm_stack_deinitialize(stack);
 }
 
+// Tests that segmented stacks grow past their initial storage without moving
+// existing frames and return all segments to the block pool.
+TEST(VMStackTest, SegmentedGrowth) {
+  iree_arena_block_pool_t block_pool;
+  iree_arena_block_pool_initialize(4096, iree_allocator_system(), &block_pool);
+
+  iree_vm_state_resolver_t state_resolver = {nullptr, SentinelStateResolver};
+  uint8_t storage[IREE_VM_STACK_MIN_SIZE];
+  iree_vm_stack_t* stack = nullptr;
+  IREE_ASSERT_OK(iree_vm_stack_initialize_with_block_pool(
+      iree_make_byte_span(storage, sizeof(storage)), &block_pool,
+      state_resolver, iree_allocator_system(), &stack));
+
+  // Push enough frames to spill across many segments, including one frame
+  // that is larger than a block and must be allocated separately.
+  iree_vm_function_t function_a = {MODULE_A_SENTINEL,
+                                   IREE_VM_FUNCTION_LINKAGE_INTERNAL, 0};
+  std::vector<iree_vm_stack_frame_t*> frames;
+  for (int i = 0; i < 512; ++i) {
+    iree_host_size_t frame_size = i == 100 ? 8 * 1024 : 64;
+    iree_vm_stack_frame_t* frame = nullptr;
+    IREE_ASSERT_OK(iree_vm_stack_function_enter(
+        stack, &function_a, IREE_VM_STACK_FRAME_NATIVE, frame_size, NULL,
+        &frame));
+    memset(iree_vm_stack_frame_storage(frame), i & 0xFF, frame_size);
+    frames.push_back(frame);
+  }
+
+  // Frames must not have moved and must still hold their contents.
+  for (int i = static_cast<int>(frames.size()) - 1; i >= 0; --i) {
+    ASSERT_EQ(frames[i], iree_vm_stack_current_frame(stack));
+    EXPECT_EQ(i, frames[i]->depth);
+    uint8_t* frame_storage = (uint8_t*)iree_vm_stack_frame_storage(frames[i]);
+    EXPECT_EQ(i & 0xFF, frame_storage[63]);
+    IREE_ASSERT_OK(iree_vm_stack_function_leave(stack));
+  }
+  EXPECT_EQ(nullptr, iree_vm_stack_current_frame(stack));
+
+  iree_vm_stack_deinitialize(stack);
+
+  // Deinitializing requires all blocks to have been released to the pool.
+  iree_arena_block_pool_deinitialize(&block_pool);
+}
+
+// Tests stack overflow detection with segmented growth.
+TEST(VMStackTest, SegmentedStackOverflow) {
+  iree_arena_block_pool_t block_pool;
+  iree_arena_block_pool_initialize(4096, iree_allocator_system(), &block_pool);
+
+  iree_vm_state_resolver_t state_resolver = {nullptr, SentinelStateResolver};
+  uint8_t storage[IREE_VM_STACK_MIN_SIZE];
+  iree_vm_stack_t* stack = nullptr;
+  IREE_ASSERT_OK(iree_vm_stack_initialize_with_block_pool(
+      iree_make_byte_span(storage, sizeof(storage)), &block_pool,
+      state_resolver, iree_allocator_system(), &stack));
+
+  iree_vm_function_t function_a = {MODULE_A_SENTINEL,
+                                   IREE_VM_FUNCTION_LINKAGE_INTERNAL, 0};
+  bool did_overflow = false;
+  for (int i = 0; i < 99999; ++i) {
+    iree_vm_stack_frame_t* frame_a = nullptr;
+    iree_status_t status = iree_vm_stack_function_enter(
+        stack, &function_a, IREE_VM_STACK_FRAME_NATIVE, 0, NULL, &frame_a);
+    if (iree_status_is_resource_exhausted(status)) {
+      did_overflow = true;
+      IREE_IGNORE_ERROR(status);
+      break;
+    }
+    IREE_EXPECT_OK(status);
+  }
+  ASSERT_TRUE(did_overflow);
+
+  // Leaves the remaining frames and releases all segments.
+  iree_vm_stack_deinitialize(stack);
+  iree_arena_block_pool_deinitialize(&block_pool);
+}
+
 // Tests unbalanced stack popping.
 TEST(VMStackTest, UnbalancedPop) {
   iree_vm_state_resolver_t state_resolver = {nullptr, SentinelStateResolver};
@@ -133,6 +219,33 @@ TEST(VMStackTest, UnbalancedPop) {
   iree_vm_stack_deinitialize(stack);
 }
 
+// Tests that deferred waits are only handed back once.
+TEST(VMStackTest, DeferredWait) {
+  iree_vm_state_resolver_t state_resolver = {nullptr, SentinelStateResolver};
+  IREE_VM_INLINE_STACK_INITIALIZE(stack, state_resolver,
+                                  iree_allocator_system());
+
+  EXPECT_FALSE(iree_vm_stack_is_resumable(stack));
+  iree_vm_stack_set_resumable(stack, true);
+  EXPECT_TRUE(iree_vm_stack_is_resumable(stack));
+
+  iree_vm_wait_t wait;
+  EXPECT_FALSE(iree_vm_stack_take_pending_wait(stack, &wait));
+
+  iree_vm_wait_t deferred_wait = {0};
+  deferred_wait.wait_fn = NeverSatisfiedWait;
+  deferred_wait.payload = 123;
+  iree_vm_stack_defer_wait(stack, &deferred_wait);
+  EXPECT_EQ(nullptr, deferred_wait.wait_fn);
+
+  EXPECT_TRUE(iree_vm_stack_take_pending_wait(stack, &wait));
+  EXPECT_EQ(NeverSatisfiedWait, wait.wait_fn);
+  EXPECT_EQ(123u, wait.payload);
+  EXPECT_FALSE(iree_vm_stack_take_pending_wait(stack, &wait));
+
+  iree_vm_stack_deinitialize(stack);
+}
+
 // Tests module state reuse and querying.
 TEST(VMStackTest, ModuleStateQueries) {
   iree_vm_state_resolver_t state_resolver = {nullptr, SentinelStateResolver};
@@ -176,6 +289,48 @@ TEST(VMStackTest, ModuleStateQueries) {
   iree_vm_stack_deinitialize(stack);
 }
 
+// Tests that module states are cached on the stack across calls such that
+// returning to a module doesn't query the state resolver again.
+TEST(VMStackTest, ModuleStateCache) {
+  iree_vm_state_resolver_t state_resolver = {nullptr, SentinelStateResolver};
+  IREE_VM_INLINE_STACK_INITIALIZE(stack, state_resolver,
+                                  iree_allocator_system());
+
+  module_a_state_resolve_count = 0;
+  module_b_state_resolve_count = 0;
+
+  iree_vm_function_t function_a = {MODULE_A_SENTINEL,
+                                   IREE_VM_FUNCTION_LINKAGE_INTERNAL, 0};
+  iree_vm_function_t function_b = {MODULE_B_SENTINEL,
+                                   IREE_VM_FUNCTION_LINKAGE_INTERNAL, 1};
+  for (int i = 0; i < 3; ++i) {
+    // [A, B, A]
+    iree_vm_stack_frame_t* frame = nullptr;
+    IREE_EXPECT_OK(iree_vm_stack_function_enter(
+        stack, &function_a, IREE_VM_STACK_FRAME_NATIVE, 0, NULL, &frame));
+    EXPECT_EQ(MODULE_A_STATE_SENTINEL, frame->module_state);
+    IREE_EXPECT_OK(iree_vm_stack_function_enter(
+        stack, &function_b, IREE_VM_STACK_FRAME_NATIVE, 0, NULL, &frame));
+    EXPECT_EQ(MODULE_B_STATE_SENTINEL, frame->module_state);
+    IREE_EXPECT_OK(iree_vm_stack_function_enter(
+        stack, &function_a, IREE_VM_STACK_FRAME_NATIVE, 0, NULL, &frame));
+    EXPECT_EQ(MODULE_A_STATE_SENTINEL, frame->module_state);
+    IREE_EXPECT_OK(iree_vm_stack_function_leave(stack));
+    IREE_EXPECT_OK(iree_vm_stack_function_leave(stack));
+    IREE_EXPECT_OK(iree_vm_stack_function_leave(stack));
+  }
+  EXPECT_EQ(1, module_a_state_resolve_count);
+  EXPECT_EQ(1, module_b_state_resolve_count);
+
+  iree_vm_module_state_t* module_state = nullptr;
+  IREE_EXPECT_OK(iree_vm_stack_query_module_state(stack, MODULE_B_SENTINEL,
+                                                  &module_state));
+  EXPECT_EQ(MODULE_B_STATE_SENTINEL, module_state);
+  EXPECT_EQ(1, module_b_state_resolve_count);
+
+  iree_vm_stack_deinitialize(stack);
+}
+
 // Tests that module state query failures propagate to callers correctly.
 TEST(VMStackTest, ModuleStateQueryFailure) {
   iree_vm_state_resolver_t state_resolver = {
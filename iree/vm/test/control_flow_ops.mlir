@@ -19,6 +19,36 @@ vm.module @control_flow_ops {
     vm.fail %code, "error!"
   }
 
+  //===--------------------------------------------------------------------===//
+  // vm.yield
+  //===--------------------------------------------------------------------===//
+
+  // Yields are no-ops when not running on a resumable stack and execution must
+  // continue after them.
+  vm.export @test_yield_loop
+  vm.func @test_yield_loop() {
+    %c0 = vm.const.i32 0 : i32
+    %c1 = vm.const.i32 1 : i32
+    %c4 = vm.const.i32 4 : i32
+    %c4dno = util.do_not_optimize(%c4) : i32
+    vm.br ^bb1(%c0 : i32)
+  ^bb1(%i : i32):
+    vm.yield
+    %next = vm.add.i32 %i, %c1 : i32
+    %cmp = vm.cmp.lt.i32.s %next, %c4dno : i32
+    vm.cond_br %cmp, ^bb1(%next : i32), ^bb2(%next : i32)
+  ^bb2(%count : i32):
+    vm.check.eq %count, %c4, "expected 4 iterations" : i32
+    vm.return
+  }
+
+  vm.export @fail_after_yield
+  vm.func @fail_after_yield() {
+    vm.yield
+    %code = vm.const.i32 4 : i32
+    vm.fail %code, "error!"
+  }
+
   //===--------------------------------------------------------------------===//
   // vm.check.*
   //===--------------------------------------------------------------------===//
@@ -86,4 +116,82 @@ vm.module @control_flow_ops {
     vm.fail %code, "unreachable!"
   }
 
+  // Comparisons feeding a vm.cond_br are fused into a single superinstruction
+  // by the bytecode encoder.
+
+  vm.export @test_cond_br_cmp_eq
+  vm.func @test_cond_br_cmp_eq() {
+    %c1 = vm.const.i32 1 : i32
+    %c1dno = util.do_not_optimize(%c1) : i32
+    %c2 = vm.const.i32 2 : i32
+    %c2dno = util.do_not_optimize(%c2) : i32
+    %cmp = vm.cmp.eq.i32 %c1dno, %c2dno : i32
+    vm.cond_br %cmp, ^bb1, ^bb2(%c2dno : i32)
+  ^bb1:
+    %code = vm.const.i32 4 : i32
+    vm.fail %code, "unreachable!"
+  ^bb2(%arg2 : i32):
+    vm.check.eq %arg2, %c2dno, "error!" : i32
+    vm.return
+  }
+
+  vm.export @test_cond_br_cmp_ne
+  vm.func @test_cond_br_cmp_ne() {
+    %c1 = vm.const.i32 1 : i32
+    %c1dno = util.do_not_optimize(%c1) : i32
+    %c2 = vm.const.i32 2 : i32
+    %c2dno = util.do_not_optimize(%c2) : i32
+    %cmp = vm.cmp.ne.i32 %c1dno, %c2dno : i32
+    vm.cond_br %cmp, ^bb1(%c1dno : i32), ^bb2
+  ^bb1(%arg1 : i32):
+    vm.check.eq %arg1, %c1dno, "error!" : i32
+    vm.return
+  ^bb2:
+    %code = vm.const.i32 4 : i32
+    vm.fail %code, "unreachable!"
+  }
+
+  vm.export @test_cond_br_cmp_lt_s
+  vm.func @test_cond_br_cmp_lt_s() {
+    %cn1 = vm.const.i32 -1 : i32
+    %cn1dno = util.do_not_optimize(%cn1) : i32
+    %c1 = vm.const.i32 1 : i32
+    %c1dno = util.do_not_optimize(%c1) : i32
+    %cmp = vm.cmp.lt.i32.s %cn1dno, %c1dno : i32
+    vm.cond_br %cmp, ^bb1, ^bb2
+  ^bb1:
+    vm.return
+  ^bb2:
+    %code = vm.const.i32 4 : i32
+    vm.fail %code, "unreachable!"
+  }
+
+  vm.export @test_cond_br_cmp_lt_u
+  vm.func @test_cond_br_cmp_lt_u() {
+    %cn1 = vm.const.i32 -1 : i32
+    %cn1dno = util.do_not_optimize(%cn1) : i32
+    %c1 = vm.const.i32 1 : i32
+    %c1dno = util.do_not_optimize(%c1) : i32
+    %cmp = vm.cmp.lt.i32.u %cn1dno, %c1dno : i32
+    vm.cond_br %cmp, ^bb1, ^bb2
+  ^bb1:
+    %code = vm.const.i32 4 : i32
+    vm.fail %code, "unreachable!"
+  ^bb2:
+    vm.return
+  }
+
+  vm.export @test_cond_br_cmp_nz
+  vm.func @test_cond_br_cmp_nz() {
+    %c0 = vm.const.i32 0 : i32
+    %c0dno = util.do_not_optimize(%c0) : i32
+    %cmp = vm.cmp.nz.i32 %c0dno : i32
+    vm.cond_br %cmp, ^bb1, ^bb2
+  ^bb1:
+    %code = vm.const.i32 4 : i32
+    vm.fail %code, "unreachable!"
+  ^bb2:
+    vm.return
+  }
+
 }
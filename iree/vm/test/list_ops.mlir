@@ -106,6 +106,34 @@ vm.module @list_ops {
     vm.return
   }
 
+  //===--------------------------------------------------------------------===//
+  // vm.list.copy
+  //===--------------------------------------------------------------------===//
+
+  vm.export @test_copy
+  vm.func @test_copy() {
+    %c0 = vm.const.i32 0 : i32
+    %c1 = vm.const.i32 1 : i32
+    %c2 = vm.const.i32 2 : i32
+    %c3 = vm.const.i32 3 : i32
+    %c27 = vm.const.i32 27 : i32
+    %c42 = vm.const.i32 42 : i32
+    %src = vm.list.alloc %c2 : (i32) -> !vm.list<i32>
+    vm.list.resize %src, %c2 : (!vm.list<i32>, i32)
+    vm.list.set.i32 %src, %c0, %c27 : (!vm.list<i32>, i32, i32)
+    vm.list.set.i32 %src, %c1, %c42 : (!vm.list<i32>, i32, i32)
+    %dst = vm.list.alloc %c3 : (i32) -> !vm.list<i64>
+    vm.list.resize %dst, %c3 : (!vm.list<i64>, i32)
+    vm.list.copy %src, %c0, %dst, %c1, %c2 : !vm.list<i32> -> !vm.list<i64>
+    %v0 = vm.list.get.i32 %dst, %c0 : (!vm.list<i64>, i32) -> i32
+    %v1 = vm.list.get.i32 %dst, %c1 : (!vm.list<i64>, i32) -> i32
+    %v2 = vm.list.get.i32 %dst, %c2 : (!vm.list<i64>, i32) -> i32
+    vm.check.eq %v0, %c0, "dst.get(0)=0" : i32
+    vm.check.eq %v1, %c27, "dst.get(1)=27" : i32
+    vm.check.eq %v2, %c42, "dst.get(2)=42" : i32
+    vm.return
+  }
+
   //===--------------------------------------------------------------------===//
   // Failure tests
   //===--------------------------------------------------------------------===//
@@ -137,4 +165,15 @@ vm.module @list_ops {
     vm.list.set.i32 %list, %c1, %c1 : (!vm.list<i32>, i32, i32)
     vm.return
   }
+
+  vm.export @fail_out_of_bounds_copy
+  vm.func @fail_out_of_bounds_copy() {
+    %c0 = vm.const.i32 0 : i32
+    %c1 = vm.const.i32 1 : i32
+    %c2 = vm.const.i32 2 : i32
+    %list = vm.list.alloc %c2 : (i32) -> !vm.list<i32>
+    vm.list.resize %list, %c2 : (!vm.list<i32>, i32)
+    vm.list.copy %list, %c0, %list, %c1, %c2 : !vm.list<i32> -> !vm.list<i32>
+    vm.return
+  }
 }
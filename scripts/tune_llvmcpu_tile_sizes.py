@@ -0,0 +1,235 @@
+#!/usr/bin/env python3
+
+# Copyright 2021 The IREE Authors
+#
+# Licensed under the Apache License v2.0 with LLVM Exceptions.
+# See https://llvm.org/LICENSE.txt for license information.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+"""Tunes LLVMCPU tile sizes of a model and stores them in a tuning database.
+
+The tunable ops (linalg.matmul, linalg.batch_matmul and linalg.mmt4d) of the
+model are discovered by compiling it with
+`-iree-codegen-llvm-print-tuning-candidates`. Tile size configurations around
+the default heuristics are then swept for each op one at a time by compiling
+the model with a tuning database containing the configuration under test and
+benchmarking it with `iree-benchmark-module` on the target. The winning
+configurations are stored in a JSON tuning database that can be passed to the
+compiler with `-iree-codegen-llvm-tuning-database=<path>`.
+
+Database entries are keyed on the op, its operand shapes, and the target
+triple/CPU features so a single database can be shared by multiple models and
+targets. Pass an existing database with `--database` to extend it.
+
+Example usage:
+  python3 tune_llvmcpu_tile_sizes.py \
+    --translate_tool=/path/to/iree-translate \
+    --benchmark_tool=/path/to/iree-benchmark-module \
+    --benchmark_flagfile=/path/to/flagfile \
+    --translate_args="-iree-input-type=mhlo;-iree-hal-target-backends=dylib-llvm-aot" \
+    --database=/path/to/tuning_database.json \
+    /path/to/model.mlir
+"""
+
+import argparse
+import itertools
+import json
+import os
+import re
+import subprocess
+import tempfile
+
+from typing import Any, Dict, List, Optional, Sequence
+
+# Matches the remarks emitted by -iree-codegen-llvm-print-tuning-candidates.
+TUNING_CANDIDATE_PATTERN = re.compile(r"tuning candidate: (\{.*\})")
+
+# Factors applied to the default workgroup and L1 tile sizes when sweeping.
+WORKGROUP_TILE_FACTORS = [0.25, 0.5, 1, 2, 4]
+L1_TILE_FACTORS = [0.5, 1, 2]
+
+
+def parse_arguments():
+  """Parses command line arguments."""
+  parser = argparse.ArgumentParser()
+  parser.add_argument("input",
+                      type=str,
+                      metavar="<input-file>",
+                      help="The model to compile")
+  parser.add_argument("--translate_tool",
+                      type=str,
+                      required=True,
+                      metavar="<translate-tool>",
+                      help="Path to iree-translate")
+  parser.add_argument("--translate_args",
+                      type=str,
+                      default="",
+                      metavar="<translate-args>",
+                      help="A list of semicolon-separated iree-translate flags")
+  parser.add_argument("--benchmark_tool",
+                      type=str,
+                      required=True,
+                      metavar="<benchmark-tool>",
+                      help="Path to iree-benchmark-module for the target")
+  parser.add_argument("--benchmark_flagfile",
+                      type=str,
+                      required=True,
+                      metavar="<benchmark-flagfile>",
+                      help="Flagfile with the driver, entry function, and "
+                      "function inputs to benchmark (without a module file)")
+  parser.add_argument("--benchmark_repetitions",
+                      type=int,
+                      default=5,
+                      metavar="<repetitions>",
+                      help="Number of repetitions per configuration")
+  parser.add_argument("--database",
+                      type=str,
+                      required=True,
+                      metavar="<database-file>",
+                      help="Tuning database to extend (if it exists) and "
+                      "write the tuned configurations to")
+  return parser.parse_args()
+
+
+def get_entry_key(entry: Dict[str, Any]) -> str:
+  """Returns the database key of a tuning |entry|."""
+  return f"{entry['op']}({','.join(entry['shapes'])})@{entry['target']}"
+
+
+def load_database(path: str) -> Dict[str, Dict[str, Any]]:
+  """Loads the tuning database at |path| keyed by entry key."""
+  if not os.path.exists(path):
+    return {}
+  with open(path, "r") as f:
+    return {get_entry_key(entry): entry for entry in json.load(f)}
+
+
+def write_database(path: str, database: Dict[str, Dict[str, Any]]):
+  """Writes |database| to |path| in a stable order."""
+  with open(path, "w") as f:
+    json.dump([database[key] for key in sorted(database)], f, indent=2)
+    f.write("\n")
+
+
+def compile_module(args, output_path: str,
+                   extra_flags: Sequence[str]) -> subprocess.CompletedProcess:
+  """Compiles the input model to a VM bytecode module at |output_path|."""
+  cmd = [
+      args.translate_tool, "-iree-mlir-to-vm-bytecode-module", args.input,
+      "-o", output_path
+  ]
+  cmd.extend([flag for flag in args.translate_args.split(";") if flag])
+  cmd.extend(extra_flags)
+  return subprocess.run(cmd,
+                        check=True,
+                        stdout=subprocess.PIPE,
+                        stderr=subprocess.PIPE,
+                        universal_newlines=True)
+
+
+def discover_candidates(args, work_dir: str) -> List[Dict[str, Any]]:
+  """Returns the default configurations of all tunable ops in the model."""
+  result = compile_module(args, os.path.join(work_dir, "discover.vmfb"),
+                          ["-iree-codegen-llvm-print-tuning-candidates"])
+  candidates = {}
+  for match in TUNING_CANDIDATE_PATTERN.finditer(result.stderr):
+    entry = json.loads(match.group(1))
+    candidates.setdefault(get_entry_key(entry), entry)
+  return list(candidates.values())
+
+
+def scale_tile_sizes(tile_sizes: Sequence[int], factor: float) -> List[int]:
+  """Scales the non-trivial tile sizes by |factor|; 0 and 1 are preserved."""
+  return [size if size <= 1 else max(int(size * factor), 1)
+          for size in tile_sizes]
+
+
+def generate_configs(entry: Dict[str, Any]) -> List[Dict[str, Any]]:
+  """Returns the configurations to sweep for the default |entry|."""
+  tile_sizes = entry["tile_sizes"]
+  workgroup_factors = WORKGROUP_TILE_FACTORS
+  # The L1 tiles of mmt4d are tied to the inner tile layout chosen when
+  # packing the operands so only the workgroup tiles are swept.
+  l1_factors = [1] if entry["op"] == "linalg.mmt4d" else L1_TILE_FACTORS
+  configs = []
+  seen = set()
+  for workgroup_factor, l1_factor in itertools.product(workgroup_factors,
+                                                       l1_factors):
+    workgroup_tiles = scale_tile_sizes(tile_sizes[0], workgroup_factor)
+    levels = [workgroup_tiles]
+    if len(tile_sizes) > 1:
+      # L1 tiles larger than the workgroup tiles they partition are useless.
+      l1_tiles = scale_tile_sizes(tile_sizes[1], l1_factor)
+      for i, size in enumerate(workgroup_tiles[:len(l1_tiles)]):
+        if size > 0:
+          l1_tiles[i] = min(l1_tiles[i], size)
+      levels.append(l1_tiles)
+    levels.extend(tile_sizes[2:])
+    key = json.dumps(levels)
+    if key in seen:
+      continue
+    seen.add(key)
+    config = dict(entry)
+    config["tile_sizes"] = levels
+    configs.append(config)
+  return configs
+
+
+def benchmark_module(args, module_path: str) -> float:
+  """Returns the median real time of the benchmarked module."""
+  cmd = [
+      args.benchmark_tool, f"--flagfile={args.benchmark_flagfile}",
+      f"--module_file={module_path}",
+      f"--benchmark_repetitions={args.benchmark_repetitions}",
+      "--benchmark_report_aggregates_only=true", "--benchmark_format=json"
+  ]
+  result = subprocess.run(cmd,
+                          check=True,
+                          stdout=subprocess.PIPE,
+                          universal_newlines=True)
+  for benchmark in json.loads(result.stdout)["benchmarks"]:
+    if benchmark.get("aggregate_name") == "median":
+      return benchmark["real_time"]
+  raise RuntimeError("no median reported by the benchmark tool")
+
+
+def measure_config(args, work_dir: str, database: Dict[str, Dict[str, Any]],
+                   config: Dict[str, Any]) -> Optional[float]:
+  """Returns the model latency with |config| or None if it fails to run."""
+  trial_database = dict(database)
+  trial_database[get_entry_key(config)] = config
+  database_path = os.path.join(work_dir, "trial_database.json")
+  write_database(database_path, trial_database)
+  module_path = os.path.join(work_dir, "trial.vmfb")
+  try:
+    compile_module(args, module_path,
+                   [f"-iree-codegen-llvm-tuning-database={database_path}"])
+    return benchmark_module(args, module_path)
+  except subprocess.CalledProcessError:
+    return None
+
+
+def main(args):
+  database = load_database(args.database)
+  with tempfile.TemporaryDirectory() as work_dir:
+    candidates = discover_candidates(args, work_dir)
+    print(f"Found {len(candidates)} tunable ops")
+    for candidate in candidates:
+      key = get_entry_key(candidate)
+      if key in database:
+        print(f"Skipping already tuned {key}")
+        continue
+      best_config, best_time = None, None
+      for config in generate_configs(candidate):
+        time = measure_config(args, work_dir, database, config)
+        print(f"{key} {config['tile_sizes']}: {time}")
+        if time is not None and (best_time is None or time < best_time):
+          best_config, best_time = config, time
+      if best_config is not None:
+        print(f"Selected {best_config['tile_sizes']} for {key}")
+        database[key] = best_config
+        # Persist as we go so long tuning sessions can be resumed.
+        write_database(args.database, database)
+
+
+if __name__ == "__main__":
+  main(parse_arguments())